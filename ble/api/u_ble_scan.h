@@ -0,0 +1,176 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_BLE_SCAN_H_
+#define _U_BLE_SCAN_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+
+/** \addtogroup _BLE
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the APIs that scan for BLE
+ * advertisements.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The length of a BLE address string, e.g. "2462ABB6EAC6p",
+ * including room for a null terminator.
+ */
+#define U_BLE_SCAN_ADDRESS_STRING_LENGTH_BYTES 14
+
+/** The maximum length of the advertising data, or scan response
+ * data, of a legacy advertisement.
+ */
+#define U_BLE_SCAN_DATA_MAX_LENGTH_BYTES 31
+
+#ifndef U_BLE_SCAN_NAME_MAX_LENGTH_BYTES
+/** The maximum length of a device name reported by a scan,
+ * including room for a null terminator; longer names are truncated.
+ */
+# define U_BLE_SCAN_NAME_MAX_LENGTH_BYTES 30
+#endif
+
+#ifndef U_BLE_SCAN_DEFAULT_DURATION_MS
+/** The duration of a scan if none is given in uBleScanCfg_t.
+ */
+# define U_BLE_SCAN_DEFAULT_DURATION_MS 5000
+#endif
+
+#ifndef U_BLE_SCAN_DEDUP_MAX_ENTRIES
+/** The number of devices that deduplication can keep track of at
+ * any one time, see uBleScanCfg_t; when more devices than this are
+ * within range the one heard from least recently is forgotten
+ * and may be reported again within the deduplication window.
+ */
+# define U_BLE_SCAN_DEDUP_MAX_ENTRIES 64
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The configuration of a scan; set the whole structure to zero
+ * for an active scan of #U_BLE_SCAN_DEFAULT_DURATION_MS which
+ * reports every advertisement.  Filtering is applied as each
+ * advertisement arrives, before it is passed to the callback,
+ * so advertisements that are filtered out cost very little.
+ */
+typedef struct {
+    bool passive;           /**< true for a passive scan, i.e. no scan
+                                 requests are sent and hence no scan
+                                 responses are received. */
+    int32_t durationMs;     /**< the duration of the scan, 0 for
+                                 #U_BLE_SCAN_DEFAULT_DURATION_MS. */
+    const char *pAddressPrefix; /**< if not NULL, only report devices
+                                     whose address starts with this string,
+                                     hex digits in upper case, e.g. "2462AB". */
+    int32_t rssiMin;        /**< if not 0, only report advertisements
+                                 received with at least this RSSI in dBm,
+                                 e.g. -80. */
+    const char *pServiceUuid; /**< if not NULL, only report advertisements
+                                   which list this service UUID. */
+    size_t serviceUuidLength; /**< the length of the UUID at pServiceUuid:
+                                   2, 4 or 16 bytes, least significant byte
+                                   first as it is sent over the air. */
+    int32_t dedupWindowMs;  /**< if not 0, an advertisement from a device
+                                 that has already been reported within this
+                                 many milliseconds is not reported again;
+                                 advertisements and scan responses are
+                                 deduplicated separately. */
+} uBleScanCfg_t;
+
+/** An advertisement, or scan response, received by a scan.
+ */
+typedef struct {
+    char address[U_BLE_SCAN_ADDRESS_STRING_LENGTH_BYTES]; /**< the address of
+                                                               the remote device,
+                                                               as a null-terminated
+                                                               string. */
+    int32_t rssi;           /**< the received signal strength in dBm. */
+    char name[U_BLE_SCAN_NAME_MAX_LENGTH_BYTES]; /**< the name of the device,
+                                                      a null-terminated string,
+                                                      empty if not known. */
+    bool scanResponse;      /**< true if this is a scan response, else it
+                                 is an advertisement. */
+    char data[U_BLE_SCAN_DATA_MAX_LENGTH_BYTES]; /**< the advertising data, as
+                                                      a sequence of AD structures. */
+    size_t dataLength;      /**< the number of bytes at data. */
+} uBleScanResult_t;
+
+/** Callback for each advertisement reported by uBleScan().
+ *
+ * @param devHandle          the handle of the u-blox device.
+ * @param[in] pResult        the advertisement; only valid for the
+ *                           duration of the callback.
+ * @param pCallbackParameter the parameter given to uBleScan().
+ * @return                   true to continue scanning, false to stop.
+ */
+typedef bool (*uBleScanCallback_t)(uDeviceHandle_t devHandle,
+                                   const uBleScanResult_t *pResult,
+                                   void *pCallbackParameter);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Scan for BLE advertisements, calling a callback for each one
+ * that passes the filters of pCfg as it is received.  This function
+ * returns when the scan duration has elapsed or the callback returns
+ * false.  The callback is called from within the AT client of the
+ * device so it must not call any other API of the device.
+ *
+ * @note only supported where the BLE stack runs on a u-blox module
+ * (i.e. not U_CFG_BLE_MODULE_INTERNAL).  When the callback returns
+ * false the module cannot be told to stop, so the remaining
+ * advertisements are discarded, unparsed, until the scan duration
+ * has elapsed.
+ *
+ * @param devHandle          the handle of the u-blox device.
+ * @param[in] pCfg           the scan configuration, may be NULL for
+ *                           the defaults.
+ * @param pCallback          the callback, must not be NULL.
+ * @param pCallbackParameter a parameter that will be passed to
+ *                           pCallback, may be NULL.
+ * @return                   zero on success, on failure negative
+ *                           error code.
+ */
+int32_t uBleScan(uDeviceHandle_t devHandle, const uBleScanCfg_t *pCfg,
+                 uBleScanCallback_t pCallback, void *pCallbackParameter);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_BLE_SCAN_H_
+
+// End of file
@@ -45,21 +45,40 @@ extern "C" {
  */
 #define U_BLE_SPS_INVALID_HANDLE ((int32_t)(-1))
 
-/** Size of receive buffer for a connected data channel
+/** Default size of receive buffer for a connected data channel
  *  When this buffer is full flow control will be invoked
  *  to stop the data flow from remote device, if enabled.
+ *  May be changed per connection with uBleSpsSetRxBufferOnNext().
  */
 #ifndef U_BLE_SPS_BUFFER_SIZE
 #define U_BLE_SPS_BUFFER_SIZE 1024
 #endif
 
-/** Maximum number of simultaneous connections,
- *  server and client combined
+/** The number of bins in the receive buffer occupancy histogram
+ *  of uBleSpsRxStats_t.
+ */
+#ifndef U_BLE_SPS_RX_STATS_OCCUPANCY_NUM_BINS
+#define U_BLE_SPS_RX_STATS_OCCUPANCY_NUM_BINS 8
+#endif
+
+/** Default maximum number of simultaneous connections,
+ *  server and client combined; where the BLE stack runs on
+ *  this MCU this may be changed at run-time with
+ *  uBleSpsSetMaxConnections().
  */
 #ifndef U_BLE_SPS_MAX_CONNECTIONS
 #define U_BLE_SPS_MAX_CONNECTIONS 8
 #endif
 
+/** The number of remote SPS servers whose attribute handles are
+ *  remembered, see uBleSpsSetHandleCacheCallback(); when full, the
+ *  server connected to least recently is forgotten.  Set to 0 to
+ *  switch the cache off.
+ */
+#ifndef U_BLE_SPS_HANDLE_CACHE_SIZE
+#define U_BLE_SPS_HANDLE_CACHE_SIZE 8
+#endif
+
 /** Default timeout for data sending. Can be modified per
  *  connection with uBleSpsSetSendTimeout().
  */
@@ -109,6 +128,20 @@ extern "C" {
 #define U_BLE_SPS_CONN_PARAM_LINK_LOSS_TMO_DEFAULT 2000
 #endif
 
+/** Minimum connection interval used in throughput mode,
+ *  see uBleSpsSetThroughputMode().
+ */
+#ifndef U_BLE_SPS_THROUGHPUT_CONN_INT_MIN
+#define U_BLE_SPS_THROUGHPUT_CONN_INT_MIN 6
+#endif
+
+/** Maximum connection interval used in throughput mode,
+ *  see uBleSpsSetThroughputMode().
+ */
+#ifndef U_BLE_SPS_THROUGHPUT_CONN_INT_MAX
+#define U_BLE_SPS_THROUGHPUT_CONN_INT_MAX 12
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -122,6 +155,22 @@ typedef enum {
 
 /** GATT service handles for SPS server.
  */
+/** Receive buffer statistics for a connected data channel,
+ *  see uBleSpsGetRxStats().
+ */
+typedef struct {
+    size_t highWaterMarkBytes; /**< the most received data there has been
+                                    waiting for uBleSpsReceive(). */
+    size_t lossBytes;          /**< the number of received bytes dropped
+                                    because the receive buffer was full. */
+    size_t occupancy[U_BLE_SPS_RX_STATS_OCCUPANCY_NUM_BINS]; /**< each time
+                                    data is received the amount then in the
+                                    receive buffer is sampled and the count
+                                    in the corresponding bin incremented,
+                                    bin zero being nearly empty and the last
+                                    bin nearly full. */
+} uBleSpsRxStats_t;
+
 typedef struct {
     uint16_t     service;
     uint16_t     fifoValue;
@@ -130,6 +179,22 @@ typedef struct {
     uint16_t     creditsCcc;
 } uBleSpsHandles_t;
 
+/** Callback for changes to the attribute handle cache, see
+ * uBleSpsSetHandleCacheCallback().
+ *
+ * @param[in] pAddress       the address of the remote SPS server.
+ * @param[in] pHandles       the handles now cached for that server,
+ *                           NULL if they have been dropped from the
+ *                           cache, either because they turned out to be
+ *                           wrong, the cache was full or the cache was
+ *                           cleared with uBleSpsClearHandleCache().
+ * @param pCallbackParameter the parameter given to
+ *                           uBleSpsSetHandleCacheCallback().
+ */
+typedef void (*uBleSpsHandleCacheCallback_t)(const char *pAddress,
+                                             const uBleSpsHandles_t *pHandles,
+                                             void *pCallbackParameter);
+
 /** Connection parameters.
  *
  *  @param scanInterval        scan interval (N*0.625 ms).
@@ -152,6 +217,33 @@ typedef struct {
     uint32_t linkLossTimeout;
 } uBleSpsConnParams_t;
 
+/** Link parameters of a connected data channel,
+ *  see uBleSpsGetLinkParams().
+ *
+ *  @param mtu              the ATT MTU.
+ *  @param connInterval     connection interval (N*1.25 ms).
+ *  @param connLatency      connection latency, nbr of connection intervals.
+ *  @param linkLossTimeout  link loss timeout in ms.
+ *  @param txDataLength     largest link layer payload that may be sent,
+ *                          27 without LE Data Length Extension; 0 if
+ *                          not known.
+ *  @param rxDataLength     largest link layer payload that may be
+ *                          received; 0 if not known.
+ *  @param txPhy            PHY used to send: 1 for 1M, 2 for 2M,
+ *                          4 for coded; 0 if not known.
+ *  @param rxPhy            PHY used to receive, values as for txPhy.
+ */
+typedef struct {
+    int32_t  mtu;
+    uint16_t connInterval;
+    uint16_t connLatency;
+    uint32_t linkLossTimeout;
+    uint16_t txDataLength;
+    uint16_t rxDataLength;
+    uint8_t  txPhy;
+    uint8_t  rxPhy;
+} uBleSpsLinkParams_t;
+
 /** Connection status callback type.
  *
  * @param connHandle             connection handle (use to send disconnect).
@@ -240,6 +332,39 @@ int32_t uBleSpsDisconnect(uDeviceHandle_t devHandle, int32_t connHandle);
  */
 int32_t uBleSpsReceive(uDeviceHandle_t devHandle, int32_t channel, char *pData, int32_t length);
 
+/** Get received data in place, without copying it; the data stays
+ * in the receive buffer until uBleSpsReceiveCommit() is called, so
+ * the remote device is given no more credits for it until then.
+ * Since the receive buffer is a ring, this may not be all of the
+ * data that has been received: call this function again after
+ * uBleSpsReceiveCommit() to get the rest.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle   the handle of the u-blox device.
+ * @param channel     the channel to receive on, given in connection callback.
+ * @param[out] ppData a place to put a pointer to the data, must not
+ *                    be NULL; the data must not be modified.
+ * @return            the number of bytes at *ppData, zero if no data
+ *                    is available, on failure negative error code.
+ */
+int32_t uBleSpsReceivePeek(uDeviceHandle_t devHandle, int32_t channel, const char **ppData);
+
+/** Consume data obtained with uBleSpsReceivePeek(), freeing the space
+ * it occupied in the receive buffer.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle   the handle of the u-blox device.
+ * @param channel     the channel to receive on, given in connection callback.
+ * @param length      the number of bytes to consume.
+ * @return            the number of bytes consumed, on failure negative
+ *                    error code.
+ */
+int32_t uBleSpsReceiveCommit(uDeviceHandle_t devHandle, int32_t channel, int32_t length);
+
 /** Send data
  *
  * @param devHandle the handle of the u-blox device.
@@ -267,6 +392,44 @@ int32_t uBleSpsSend(uDeviceHandle_t devHandle, int32_t channel, const char *pDat
  */
 int32_t uBleSpsSetSendTimeout(uDeviceHandle_t devHandle, int32_t channel, uint32_t timeout);
 
+/** Get the receive buffer statistics for a channel
+ *
+ * The statistics start afresh with each connection; use them to see
+ * whether #U_BLE_SPS_BUFFER_SIZE, or the size given to
+ * uBleSpsSetRxBufferOnNext(), suits the traffic of an application.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle    the handle of the u-blox device.
+ * @param channel      the channel, given in connection callback.
+ * @param[out] pStats  a place to put the statistics, must not be NULL.
+ *
+ * @return             zero on success, on failure negative error code.
+ */
+int32_t uBleSpsGetRxStats(uDeviceHandle_t devHandle, int32_t channel,
+                          uBleSpsRxStats_t *pStats);
+
+/** Get the link parameters of a channel
+ *
+ * Use this to see what has been negotiated with the remote device,
+ * e.g. after uBleSpsSetThroughputMode(); note that the PHY, data
+ * length and connection interval are negotiated after the connected
+ * callback has been called, so they may take a few hundred
+ * milliseconds to settle.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle     the handle of the u-blox device.
+ * @param channel       the channel, given in connection callback.
+ * @param[out] pParams  a place to put the parameters, must not be NULL.
+ *
+ * @return              zero on success, on failure negative error code.
+ */
+int32_t uBleSpsGetLinkParams(uDeviceHandle_t devHandle, int32_t channel,
+                             uBleSpsLinkParams_t *pParams);
+
 /** Get server handles for channel connection
  *
  * By reading the server handles for a connection
@@ -307,6 +470,66 @@ int32_t uBleSpsGetSpsServerHandles(uDeviceHandle_t devHandle, int32_t channel,
  */
 int32_t uBleSpsPresetSpsServerHandles(uDeviceHandle_t devHandle, const uBleSpsHandles_t *pHandles);
 
+/** Set a callback for changes to the attribute handle cache
+ *
+ * When connecting with uBleSpsConnectSps() to an SPS server which has
+ * been connected to before, the attribute handles found last time are
+ * used, skipping service, characteristic and descriptor discovery, and
+ * hence saving several round trips.  Handles set with
+ * uBleSpsPresetSpsServerHandles() take precedence.  If the cached
+ * handles turn out to be wrong the connection fails, the handles are
+ * dropped from the cache and the next connection will do discovery.
+ *
+ * The cache of #U_BLE_SPS_HANDLE_CACHE_SIZE entries is in RAM; to keep
+ * the handles of e.g. bonded devices across a restart, store them
+ * when this callback is called and give them back with
+ * uBleSpsAddCachedServerHandles() at start-up.  The callback is called
+ * from the SPS event task and must not call into this API.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle          the handle of the u-blox device.
+ * @param pCallback          the callback, NULL to remove it.
+ * @param pCallbackParameter a parameter that will be passed to
+ *                           pCallback, may be NULL.
+ *
+ * @return                   zero on success, on failure negative error code.
+ */
+int32_t uBleSpsSetHandleCacheCallback(uDeviceHandle_t devHandle,
+                                      uBleSpsHandleCacheCallback_t pCallback,
+                                      void *pCallbackParameter);
+
+/** Add attribute handles to the handle cache, e.g. those of a bonded
+ * device that were stored by the callback of
+ * uBleSpsSetHandleCacheCallback() before a restart.  This does not
+ * call that callback.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle    the handle of the u-blox device.
+ * @param[in] pAddress the address of the remote SPS server, in the
+ *                     form given to uBleSpsConnectSps().
+ * @param[in] pHandles the handles, must not be NULL.
+ *
+ * @return             zero on success, on failure negative error code.
+ */
+int32_t uBleSpsAddCachedServerHandles(uDeviceHandle_t devHandle, const char *pAddress,
+                                      const uBleSpsHandles_t *pHandles);
+
+/** Empty the attribute handle cache; the callback of
+ * uBleSpsSetHandleCacheCallback() is called for each entry.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle the handle of the u-blox device.
+ *
+ * @return          zero on success, on failure negative error code.
+ */
+int32_t uBleSpsClearHandleCache(uDeviceHandle_t devHandle);
+
 /** Disable flow control for next SPS connection
  *
  * Flow control is enabled by default. Flow control cannot be altered for
@@ -326,6 +549,81 @@ int32_t uBleSpsPresetSpsServerHandles(uDeviceHandle_t devHandle, const uBleSpsHa
  */
 int32_t uBleSpsDisableFlowCtrlOnNext(uDeviceHandle_t devHandle);
 
+/** Set throughput mode for subsequent SPS connections
+ *
+ * Throughput mode is disabled by default.  When it is enabled,
+ * for each new SPS connection, whether initiated with
+ * uBleSpsConnectSps() or by the remote device connecting to our SPS
+ * server, the largest ATT MTU the BLE stack is configured for is
+ * requested, as are LE Data Length Extension, the 2M PHY and a
+ * connection interval of between #U_BLE_SPS_THROUGHPUT_CONN_INT_MIN
+ * and #U_BLE_SPS_THROUGHPUT_CONN_INT_MAX; if uBleSpsConnectSps() is
+ * given connection parameters, its connection interval is used
+ * instead.  The remote device may refuse any of these; what was
+ * agreed may be read with uBleSpsGetLinkParams().  The cost is
+ * power consumption: use it while a lot of data is to be moved.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL); the largest MTU, LE Data Length
+ * Extension and PHY changes must also be enabled in the BLE stack
+ * configuration, e.g. with CONFIG_BT_L2CAP_TX_MTU=247,
+ * CONFIG_BT_BUF_ACL_RX_SIZE=251, CONFIG_BT_USER_DATA_LEN_UPDATE=y
+ * and CONFIG_BT_USER_PHY_UPDATE=y under Zephyr.
+ *
+ * @param devHandle the handle of the u-blox device.
+ * @param enable    true to enable throughput mode, false to disable it.
+ *
+ * @return          zero on success, on failure negative error code.
+ */
+int32_t uBleSpsSetThroughputMode(uDeviceHandle_t devHandle, bool enable);
+
+/** Set the receive buffer for the next SPS connection, whether
+ * initiated with uBleSpsConnectSps() or by the remote device
+ * connecting to our SPS server; subsequent connections go back to
+ * a buffer of #U_BLE_SPS_BUFFER_SIZE.  With flow control the remote
+ * device is only given credits for as many full packets as will fit
+ * in the free part of the buffer, so a buffer of several times the
+ * MTU lets it keep sending while the application is reading.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle the handle of the u-blox device.
+ * @param pBuffer   storage for the receive buffer, which must remain
+ *                  valid until the connection has been disconnected;
+ *                  may be NULL, in which case a buffer of size bytes
+ *                  is allocated when the connection is made and freed
+ *                  when it is disconnected.
+ * @param size      the size of the receive buffer in bytes, must not be 0.
+ *
+ * @return          zero on success, on failure negative error code.
+ */
+int32_t uBleSpsSetRxBufferOnNext(uDeviceHandle_t devHandle, char *pBuffer, size_t size);
+
+/** Set the maximum number of simultaneous SPS connections, server
+ * and client combined, in place of #U_BLE_SPS_MAX_CONNECTIONS, e.g.
+ * for a hub that talks to many sensors; the connection table is
+ * allocated on the heap and a connection is found from a BLE stack
+ * callback directly, rather than by searching the table, so a large
+ * limit costs only memory.  This may only be called when there are
+ * no SPS connections, since connection handles are indexes into
+ * the table; if it is called before the BLE device is opened the
+ * limit is applied when it is.
+ *
+ * @note only supported where the BLE stack runs on this MCU
+ * (U_CFG_BLE_MODULE_INTERNAL).
+ *
+ * @param devHandle       the handle of the u-blox device.
+ * @param maxConnections  the maximum number of connections, must
+ *                        not be 0.
+ *
+ * @return                zero on success, on failure negative error
+ *                        code, in particular
+ *                        #U_ERROR_COMMON_INVALID_PARAMETER if there
+ *                        are SPS connections.
+ */
+int32_t uBleSpsSetMaxConnections(uDeviceHandle_t devHandle, size_t maxConnections);
+
 #ifdef __cplusplus
 }
 #endif
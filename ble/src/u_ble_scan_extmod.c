@@ -0,0 +1,292 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the BLE scan API using the AT commands
+ * of a u-blox module.
+ */
+
+#ifndef U_CFG_BLE_MODULE_INTERNAL
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc() and free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset(), memcmp(), strncmp(), strlen()
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+
+#include "u_at_client.h"
+
+#include "u_hex_bin_convert.h"
+
+#include "u_short_range_module_type.h"
+#include "u_short_range.h"
+#include "u_short_range_private.h"
+
+#include "u_ble_scan.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** Discovery type for AT+UBTD: all advertisements, no filtering
+ * of repeats, since deduplication is done here.
+ */
+#define U_BLE_SCAN_DISCOVERY_TYPE_ALL 1
+
+/** Discovery mode for AT+UBTD: active.
+ */
+#define U_BLE_SCAN_DISCOVERY_MODE_ACTIVE 1
+
+/** Discovery mode for AT+UBTD: passive.
+ */
+#define U_BLE_SCAN_DISCOVERY_MODE_PASSIVE 2
+
+/** Data type in a +UBTD line that indicates a scan response.
+ */
+#define U_BLE_SCAN_DATA_TYPE_SCAN_RESPONSE 1
+
+/** How long to wait for the final response of AT+UBTD beyond
+ * the scan duration.
+ */
+#define U_BLE_SCAN_AT_TIMEOUT_MARGIN_MS 2000
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** An entry in the deduplication table.
+ */
+typedef struct {
+    char address[U_BLE_SCAN_ADDRESS_STRING_LENGTH_BYTES];
+    bool scanResponse;
+    int32_t timeMs;
+} uBleScanDedupEntry_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return true if the given AD structures list the given service
+// UUID, either as a service class UUID or in service data.
+static bool hasServiceUuid(const char *pData, size_t dataLength,
+                           const char *pUuid, size_t uuidLength)
+{
+    bool found = false;
+    size_t length;
+    size_t x = 0;
+    uint8_t type;
+
+    while (!found && (x + 1 < dataLength)) {
+        length = (uint8_t) *(pData + x);
+        if ((length == 0) || (x + 1 + length > dataLength)) {
+            break;
+        }
+        type = (uint8_t) *(pData + x + 1);
+        // The payload of the AD structure is what follows the type
+        if ((((type == 0x02) || (type == 0x03)) && (uuidLength == 2)) ||
+            (((type == 0x04) || (type == 0x05)) && (uuidLength == 4)) ||
+            (((type == 0x06) || (type == 0x07)) && (uuidLength == 16))) {
+            // A list of 16-bit, 32-bit or 128-bit UUIDs
+            for (size_t y = 0; !found && (y + uuidLength < length); y += uuidLength) {
+                found = (memcmp(pData + x + 2 + y, pUuid, uuidLength) == 0);
+            }
+        } else if (((type == 0x16) && (uuidLength == 2)) ||
+                   ((type == 0x20) && (uuidLength == 4)) ||
+                   ((type == 0x21) && (uuidLength == 16))) {
+            // Service data, which begins with the UUID
+            found = (length > uuidLength) &&
+                    (memcmp(pData + x + 2, pUuid, uuidLength) == 0);
+        }
+        x += length + 1;
+    }
+
+    return found;
+}
+
+// Return true if the given advertisement has been reported within
+// the deduplication window, else remember it and return false.
+static bool isDuplicate(uBleScanDedupEntry_t *pTable, int32_t windowMs,
+                        const uBleScanResult_t *pResult)
+{
+    bool duplicate = false;
+    int32_t nowMs = uPortGetTickTimeMs();
+    uBleScanDedupEntry_t *pEntry = NULL;
+    uBleScanDedupEntry_t *pOldest = pTable;
+
+    for (size_t x = 0; (x < U_BLE_SCAN_DEDUP_MAX_ENTRIES) && (pEntry == NULL); x++) {
+        if ((pTable + x)->address[0] == 0) {
+            // Never used, so nothing older
+            pOldest = pTable + x;
+            break;
+        }
+        if (((pTable + x)->scanResponse == pResult->scanResponse) &&
+            (strncmp((pTable + x)->address, pResult->address,
+                     sizeof((pTable + x)->address)) == 0)) {
+            pEntry = pTable + x;
+        } else if ((pTable + x)->timeMs - pOldest->timeMs < 0) {
+            pOldest = pTable + x;
+        }
+    }
+
+    if (pEntry != NULL) {
+        duplicate = (nowMs - pEntry->timeMs < windowMs);
+    } else {
+        // Forget the device heard from least recently
+        pEntry = pOldest;
+        memcpy(pEntry->address, pResult->address, sizeof(pEntry->address));
+        pEntry->scanResponse = pResult->scanResponse;
+    }
+    if (!duplicate) {
+        pEntry->timeMs = nowMs;
+    }
+
+    return duplicate;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+int32_t uBleScan(uDeviceHandle_t devHandle, const uBleScanCfg_t *pCfg,
+                 uBleScanCallback_t pCallback, void *pCallbackParameter)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uShortRangePrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+    uBleScanCfg_t cfg = {0};
+    uBleScanDedupEntry_t *pDedupTable = NULL;
+    uBleScanResult_t result;
+    char hex[(U_BLE_SCAN_DATA_MAX_LENGTH_BYTES * 2) + 1];
+    size_t addressPrefixLength = 0;
+    int32_t length;
+    bool keepGoing = true;
+
+    if (pCfg != NULL) {
+        cfg = *pCfg;
+    }
+    if (cfg.durationMs == 0) {
+        cfg.durationMs = U_BLE_SCAN_DEFAULT_DURATION_MS;
+    }
+    if (cfg.pAddressPrefix != NULL) {
+        addressPrefixLength = strlen(cfg.pAddressPrefix);
+    }
+
+    if ((pCallback != NULL) && (cfg.durationMs > 0) && (cfg.dedupWindowMs >= 0) &&
+        (addressPrefixLength < sizeof(result.address)) &&
+        ((cfg.pServiceUuid == NULL) || (cfg.serviceUuidLength == 2) ||
+         (cfg.serviceUuidLength == 4) || (cfg.serviceUuidLength == 16))) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        if (cfg.dedupWindowMs > 0) {
+            // The only allocation, once for the whole scan
+            pDedupTable = (uBleScanDedupEntry_t *) malloc(sizeof(uBleScanDedupEntry_t) *
+                                                          U_BLE_SCAN_DEDUP_MAX_ENTRIES);
+            if (pDedupTable != NULL) {
+                memset(pDedupTable, 0, sizeof(uBleScanDedupEntry_t) * U_BLE_SCAN_DEDUP_MAX_ENTRIES);
+            }
+        }
+        if ((cfg.dedupWindowMs == 0) || (pDedupTable != NULL)) {
+            errorCode = uShortRangeLock();
+        }
+        if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+            pInstance = pUShortRangePrivateGetInstance(devHandle);
+            if (pInstance != NULL) {
+                atHandle = pInstance->atHandle;
+                uAtClientLock(atHandle);
+                // Since the scan takes some time release the short range
+                // lock here, as uWifiStationScan() does: we have the AT
+                // client lock instead
+                uShortRangeUnlock();
+                uAtClientTimeoutSet(atHandle, cfg.durationMs + U_BLE_SCAN_AT_TIMEOUT_MARGIN_MS);
+                uAtClientCommandStart(atHandle, "AT+UBTD=");
+                uAtClientWriteInt(atHandle, U_BLE_SCAN_DISCOVERY_TYPE_ALL);
+                uAtClientWriteInt(atHandle, cfg.passive ? U_BLE_SCAN_DISCOVERY_MODE_PASSIVE :
+                                  U_BLE_SCAN_DISCOVERY_MODE_ACTIVE);
+                uAtClientWriteInt(atHandle, cfg.durationMs);
+                uAtClientCommandStop(atHandle);
+                // Each line is +UBTD:<address>,<rssi>,<name>,<data_type>,<data>;
+                // filter as early in the line as possible, the next
+                // uAtClientResponseStart() throwing away the rest of a
+                // line that has been filtered out.  Loop until we get
+                // OK, ERROR or timeout
+                while (uAtClientResponseStart(atHandle, "+UBTD:") == 0) {
+                    if (!keepGoing) {
+                        // Stopped: just let the lines go by
+                        continue;
+                    }
+                    if ((uAtClientReadString(atHandle, result.address,
+                                             sizeof(result.address), false) < 0) ||
+                        (strncmp(result.address, cfg.pAddressPrefix == NULL ? "" :
+                                 cfg.pAddressPrefix, addressPrefixLength) != 0)) {
+                        continue;
+                    }
+                    result.rssi = uAtClientReadInt(atHandle);
+                    if ((cfg.rssiMin != 0) && (result.rssi < cfg.rssiMin)) {
+                        continue;
+                    }
+                    if (uAtClientReadString(atHandle, result.name,
+                                            sizeof(result.name), false) < 0) {
+                        result.name[0] = 0;
+                    }
+                    result.scanResponse = (uAtClientReadInt(atHandle) ==
+                                           U_BLE_SCAN_DATA_TYPE_SCAN_RESPONSE);
+                    result.dataLength = 0;
+                    length = uAtClientReadString(atHandle, hex, sizeof(hex), false);
+                    if (length > 0) {
+                        result.dataLength = uHexToBin(hex, (size_t) length, result.data);
+                    }
+                    if (((cfg.pServiceUuid == NULL) ||
+                         hasServiceUuid(result.data, result.dataLength,
+                                        cfg.pServiceUuid, cfg.serviceUuidLength)) &&
+                        ((pDedupTable == NULL) ||
+                         !isDuplicate(pDedupTable, cfg.dedupWindowMs, &result))) {
+                        keepGoing = pCallback(devHandle, &result, pCallbackParameter);
+                    }
+                }
+                uAtClientResponseStop(atHandle);
+                errorCode = uAtClientUnlock(atHandle);
+            } else {
+                uShortRangeUnlock();
+            }
+        }
+        free(pDedupTable);
+    }
+
+    return errorCode;
+}
+
+#endif
+
+// End of file
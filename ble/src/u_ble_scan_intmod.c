@@ -0,0 +1,58 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the BLE scan API where the BLE stack
+ * runs on this MCU: not yet supported.
+ */
+
+#ifdef U_CFG_BLE_MODULE_INTERNAL
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_error_common.h"
+
+#include "u_ble_scan.h"
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+int32_t uBleScan(uDeviceHandle_t devHandle, const uBleScanCfg_t *pCfg,
+                 uBleScanCallback_t pCallback, void *pCallbackParameter)
+{
+    (void)devHandle;
+    (void)pCfg;
+    (void)pCallback;
+    (void)pCallbackParameter;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+#endif
+
+// End of file
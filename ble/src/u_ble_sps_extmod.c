@@ -777,6 +777,87 @@ int32_t uBleSpsDisableFlowCtrlOnNext(uDeviceHandle_t devHandle)
     return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
 }
 
+int32_t uBleSpsGetRxStats(uDeviceHandle_t devHandle, int32_t channel,
+                          uBleSpsRxStats_t *pStats)
+{
+    (void)devHandle;
+    (void)channel;
+    (void)pStats;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsGetLinkParams(uDeviceHandle_t devHandle, int32_t channel,
+                             uBleSpsLinkParams_t *pParams)
+{
+    (void)devHandle;
+    (void)channel;
+    (void)pParams;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsSetThroughputMode(uDeviceHandle_t devHandle, bool enable)
+{
+    (void)devHandle;
+    (void)enable;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsSetHandleCacheCallback(uDeviceHandle_t devHandle,
+                                      uBleSpsHandleCacheCallback_t pCallback,
+                                      void *pCallbackParameter)
+{
+    (void)devHandle;
+    (void)pCallback;
+    (void)pCallbackParameter;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsAddCachedServerHandles(uDeviceHandle_t devHandle, const char *pAddress,
+                                      const uBleSpsHandles_t *pHandles)
+{
+    (void)devHandle;
+    (void)pAddress;
+    (void)pHandles;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsClearHandleCache(uDeviceHandle_t devHandle)
+{
+    (void)devHandle;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsReceivePeek(uDeviceHandle_t devHandle, int32_t channel, const char **ppData)
+{
+    (void)devHandle;
+    (void)channel;
+    (void)ppData;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsReceiveCommit(uDeviceHandle_t devHandle, int32_t channel, int32_t length)
+{
+    (void)devHandle;
+    (void)channel;
+    (void)length;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsSetRxBufferOnNext(uDeviceHandle_t devHandle, char *pBuffer, size_t size)
+{
+    (void)devHandle;
+    (void)pBuffer;
+    (void)size;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
+int32_t uBleSpsSetMaxConnections(uDeviceHandle_t devHandle, size_t maxConnections)
+{
+    (void)devHandle;
+    (void)maxConnections;
+    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
 #endif
 
 // End of file
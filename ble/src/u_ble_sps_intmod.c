@@ -88,7 +88,8 @@ typedef enum {
     EVENT_SPS_CREDITS_SUBSCRIBED,
     EVENT_SPS_FIFO_SUBSCRIBED,
     EVENT_SPS_CONNECTING_FAILED,
-    EVENT_SPS_RX_DATA_AVAILABLE
+    EVENT_SPS_RX_DATA_AVAILABLE,
+    EVENT_SPS_THROUGHPUT_REQUEST
 } spsEventType_t;
 
 /** SPS Role
@@ -119,13 +120,27 @@ typedef struct {
     spsState_t             spsState;
     uint16_t               mtu;
     uPortSemaphoreHandle_t txCreditsSemaphore;
-    char                   rxData[U_BLE_SPS_BUFFER_SIZE];
+    uPortSemaphoreHandle_t txBufferSemaphore; // One count per PDU we may have in flight
+    char                  *pRxData;
+    size_t                 rxDataSize;
+    bool                   rxDataIsOurs; // True if pRxData was allocated here
     uRingBuffer_t          rxRingBuffer;
     uint32_t               dataSendTimeoutMs;
     spsRole_t              localSpsRole;
     bool                   flowCtrlEnabled;
+    bool                   throughputMode;
+    bool                   handlesFromCache;
+    uPortMutexHandle_t     mutex; // Serialises API calls on this connection
 } spsConnection_t;
 
+/** An entry in the attribute handle cache
+ * */
+typedef struct {
+    char             remoteAddr[14]; // Empty if the entry is free
+    uBleSpsHandles_t handles;
+    uint32_t         lastUsed;
+} spsHandleCacheEntry_t;
+
 /** SPS Client event
  * */
 typedef struct {
@@ -138,7 +153,7 @@ typedef struct {
  * -------------------------------------------------------------- */
 static int32_t findSpsConnHandle(int32_t gapConnHandle);
 static spsConnection_t *pGetSpsConn(int32_t spsConnHandle);
-static int32_t findFreeSpsConnHandle(void);
+static int32_t findFreeSpsConnHandle(int32_t gapConnHandle);
 static void freeSpsConnection(int32_t spsConnHandle);
 static bool validSpsConnHandle(int32_t spsConnHandle);
 static spsConnection_t *initSpsConnection(int32_t spsConnHandle, int32_t gapConnHandle,
@@ -148,6 +163,11 @@ static void addReceivedDataToBuffer(int32_t spsConnHandle, const void *pData, ui
 static bool sendDataToRemoteFifo(const spsConnection_t *pSpsConn, const char *pData,
                                  uint16_t bytesToSendNow);
 static void updateRxCreditsOnRemote(spsConnection_t *pSpsConn);
+static void onTxComplete(int32_t gapConnHandle, void *pParameter);
+static spsHandleCacheEntry_t *pFindHandleCacheEntry(const char *pAddress);
+static void addHandleCacheEntry(const char *pAddress, const uBleSpsHandles_t *pHandles,
+                                bool callCallback);
+static void removeHandleCacheEntry(const char *pAddress);
 static void gapConnectionEvent(int32_t gapConnHandle, uPortGattGapConnStatus_t status,
                                void *pParameter);
 
@@ -163,6 +183,7 @@ static void onCreditsSubscribed(int32_t gapConnHandle, uint8_t err);
 static void startCreditSubscription(spsConnection_t *pSpsConn);
 static void startFifoSubscription(spsConnection_t *pSpsConn);
 static void mtuXchangeResp(int32_t gapConnHandle, uint8_t err);
+static void requestThroughput(const spsConnection_t *pSpsConn);
 static uPortGattIter_t onCccDiscovery(int32_t gapConnHandle, uPortGattUuid_t *pUuid,
                                       uint16_t attrHandle);
 static uPortGattIter_t onCreditCharDiscovery(int32_t gapConnHandle, uPortGattUuid_t *pUuid,
@@ -176,6 +197,7 @@ static uPortGattIter_t onSpsServiceDiscovery(int32_t gapConnHandle, uPortGattUui
 static void onBleSpsEvent(void *pParam, size_t eventSize);
 
 /** SPS Server specific functions */
+static void serverMtuXchangeResp(int32_t gapConnHandle, uint8_t err);
 static bool write16BitValue(const void *buf, uint16_t len, uint16_t offset, uint16_t *pVal);
 static int32_t remoteWritesFifoCcc(int32_t gapConnHandle, const void *buf, uint16_t len,
                                    uint16_t offset, uint8_t flags);
@@ -200,9 +222,20 @@ static uBleSpsConnectionStatusCallback_t gpSpsConnStatusCallback;
 static void *gpSpsConnStatusCallbackParam;
 static uBleSpsAvailableCallback_t gpSpsDataAvailableCallback;
 static void *gpSpsDataAvailableCallbackParam;
-static spsConnection_t *gpSpsConnections[U_BLE_SPS_MAX_CONNECTIONS];
+static spsConnection_t **gpSpsConnections = NULL;
+static size_t gSpsConnectionsLength = 0; // Number of entries at gpSpsConnections
+static size_t gMaxConnections = U_BLE_SPS_MAX_CONNECTIONS;
 static uBleSpsHandles_t gNextConnServerHandles;
 static bool gFlowCtrlOnNext = true;
+static bool gThroughputMode = false;
+static char *gpRxBufferNext = NULL;
+static size_t gRxBufferSizeNext = U_BLE_SPS_BUFFER_SIZE;
+#if U_BLE_SPS_HANDLE_CACHE_SIZE > 0
+static spsHandleCacheEntry_t gHandleCache[U_BLE_SPS_HANDLE_CACHE_SIZE];
+#endif
+static uint32_t gHandleCacheUseCount = 0;
+static uBleSpsHandleCacheCallback_t gpHandleCacheCallback = NULL;
+static void *gpHandleCacheCallbackParam = NULL;
 
 static uPortGattUuid128_t gSpsCreditsCharUuid = {
     .type = U_PORT_GATT_UUID_TYPE_128,
@@ -273,6 +306,16 @@ static const uBleSpsConnParams_t gConnParamsDefault = {
     U_BLE_SPS_CONN_PARAM_LINK_LOSS_TMO_DEFAULT
 };
 
+static const uBleSpsConnParams_t gConnParamsThroughput = {
+    U_BLE_SPS_CONN_PARAM_SCAN_INT_DEFAULT,
+    U_BLE_SPS_CONN_PARAM_SCAN_WIN_DEFAULT,
+    U_BLE_SPS_CONN_PARAM_TMO_DEFAULT,
+    U_BLE_SPS_THROUGHPUT_CONN_INT_MIN,
+    U_BLE_SPS_THROUGHPUT_CONN_INT_MAX,
+    U_BLE_SPS_CONN_PARAM_CONN_LATENCY_DEFAULT,
+    U_BLE_SPS_CONN_PARAM_LINK_LOSS_TMO_DEFAULT
+};
+
 /* ----------------------------------------------------------------
  * EXPORTED VARIABLES
  * -------------------------------------------------------------- */
@@ -284,15 +327,36 @@ uPortGattService_t const gSpsService = {
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
-static int32_t findSpsConnHandle(int32_t gapConnHandle)
+// The slot that a connection with the given GAP handle is put in
+// if it is free, so that it can be found there first time.
+static int32_t preferredSpsConnHandle(int32_t gapConnHandle)
 {
-    int32_t i;
     int32_t spsConnHandle = U_BLE_SPS_INVALID_HANDLE;
 
-    for (i = 0; i < U_BLE_SPS_MAX_CONNECTIONS; i++) {
-        if ((gpSpsConnections[i] != NULL) &&
-            (gpSpsConnections[i]->gapConnHandle) == gapConnHandle) {
-            spsConnHandle = i;
+    if ((gapConnHandle >= 0) && (gSpsConnectionsLength > 0)) {
+        spsConnHandle = (int32_t)((size_t)gapConnHandle % gSpsConnectionsLength);
+    }
+
+    return spsConnHandle;
+}
+
+// Find a connection by GAP handle: this is called from every data and
+// credit callback so the preferred slot is checked first, which is
+// where the connection will be unless that slot was taken already.
+static int32_t findSpsConnHandle(int32_t gapConnHandle)
+{
+    int32_t spsConnHandle = preferredSpsConnHandle(gapConnHandle);
+
+    if ((spsConnHandle == U_BLE_SPS_INVALID_HANDLE) ||
+        (gpSpsConnections[spsConnHandle] == NULL) ||
+        (gpSpsConnections[spsConnHandle]->gapConnHandle != gapConnHandle)) {
+        spsConnHandle = U_BLE_SPS_INVALID_HANDLE;
+        for (size_t i = 0; i < gSpsConnectionsLength; i++) {
+            if ((gpSpsConnections[i] != NULL) &&
+                (gpSpsConnections[i]->gapConnHandle == gapConnHandle)) {
+                spsConnHandle = (int32_t)i;
+                break;
+            }
         }
     }
 
@@ -303,24 +367,28 @@ static spsConnection_t *pGetSpsConn(int32_t spsConnHandle)
 {
     spsConnection_t *pSpsConn = NULL;
 
-    if ((spsConnHandle >= 0) && (spsConnHandle < U_BLE_SPS_MAX_CONNECTIONS)) {
+    if ((spsConnHandle >= 0) && (spsConnHandle < (int32_t)gSpsConnectionsLength)) {
         pSpsConn = gpSpsConnections[spsConnHandle];
     }
 
     return pSpsConn;
 }
 
-static int32_t findFreeSpsConnHandle(void)
+static int32_t findFreeSpsConnHandle(int32_t gapConnHandle)
 {
-    int32_t i;
-    int32_t spsConnHandle = U_BLE_SPS_INVALID_HANDLE;
+    int32_t spsConnHandle = preferredSpsConnHandle(gapConnHandle);
 
-    for (i = 0; i < U_BLE_SPS_MAX_CONNECTIONS; i++) {
-        if (gpSpsConnections[i] == NULL) {
-            spsConnHandle = i;
-            break;
+    if ((spsConnHandle == U_BLE_SPS_INVALID_HANDLE) ||
+        (gpSpsConnections[spsConnHandle] != NULL)) {
+        spsConnHandle = U_BLE_SPS_INVALID_HANDLE;
+        for (size_t i = 0; i < gSpsConnectionsLength; i++) {
+            if (gpSpsConnections[i] == NULL) {
+                spsConnHandle = (int32_t)i;
+                break;
+            }
         }
     }
+
     return spsConnHandle;
 }
 
@@ -328,8 +396,16 @@ static void freeSpsConnection(int32_t spsConnHandle)
 {
     if (validSpsConnHandle(spsConnHandle)) {
         spsConnection_t *pSpsConn = gpSpsConnections[spsConnHandle];
+        // Make sure that no API call is still using the connection
+        U_PORT_MUTEX_LOCK(pSpsConn->mutex);
+        U_PORT_MUTEX_UNLOCK(pSpsConn->mutex);
+        uPortMutexDelete(pSpsConn->mutex);
         uRingBufferDelete(&pSpsConn->rxRingBuffer);
         uPortSemaphoreDelete(pSpsConn->txCreditsSemaphore);
+        uPortSemaphoreDelete(pSpsConn->txBufferSemaphore);
+        if (pSpsConn->rxDataIsOurs) {
+            free(pSpsConn->pRxData);
+        }
         free(pSpsConn);
         gpSpsConnections[spsConnHandle] = NULL;
     }
@@ -338,7 +414,7 @@ static void freeSpsConnection(int32_t spsConnHandle)
 static bool validSpsConnHandle(int32_t spsConnHandle)
 {
     if ((spsConnHandle >= 0) &&
-        (spsConnHandle < U_BLE_SPS_MAX_CONNECTIONS) &&
+        (spsConnHandle < (int32_t)gSpsConnectionsLength) &&
         (gpSpsConnections[spsConnHandle] != NULL)) {
         return true;
     }
@@ -348,12 +424,39 @@ static bool validSpsConnHandle(int32_t spsConnHandle)
 static spsConnection_t *initSpsConnection(int32_t spsConnHandle, int32_t gapConnHandle,
                                           spsRole_t localSpsRole)
 {
-    if ((spsConnHandle < 0) || (spsConnHandle >= U_BLE_SPS_MAX_CONNECTIONS)) {
+    if ((spsConnHandle < 0) || (spsConnHandle >= (int32_t)gSpsConnectionsLength)) {
         return NULL;
     }
 
     if (gpSpsConnections[spsConnHandle] == NULL) {
-        gpSpsConnections[spsConnHandle] = (spsConnection_t *)malloc(sizeof(spsConnection_t));
+        spsConnection_t *pSpsConn = (spsConnection_t *)malloc(sizeof(spsConnection_t));
+        if (pSpsConn != NULL) {
+            // The receive buffer is the one set with uBleSpsSetRxBufferOnNext(),
+            // if there is one, else it is allocated here
+            pSpsConn->pRxData = gpRxBufferNext;
+            pSpsConn->rxDataSize = gRxBufferSizeNext;
+            pSpsConn->rxDataIsOurs = (gpRxBufferNext == NULL);
+            if (pSpsConn->rxDataIsOurs) {
+                pSpsConn->pRxData = (char *)malloc(pSpsConn->rxDataSize);
+                if (pSpsConn->pRxData == NULL) {
+                    free(pSpsConn);
+                    pSpsConn = NULL;
+                }
+            }
+            if ((pSpsConn != NULL) && (uPortMutexCreate(&(pSpsConn->mutex)) != 0)) {
+                if (pSpsConn->rxDataIsOurs) {
+                    free(pSpsConn->pRxData);
+                }
+                free(pSpsConn);
+                pSpsConn = NULL;
+            }
+            if (pSpsConn != NULL) {
+                // Used up, next time it is back to the default
+                gpRxBufferNext = NULL;
+                gRxBufferSizeNext = U_BLE_SPS_BUFFER_SIZE;
+            }
+        }
+        gpSpsConnections[spsConnHandle] = pSpsConn;
     }
 
     if (gpSpsConnections[spsConnHandle] != NULL) {
@@ -371,11 +474,15 @@ static spsConnection_t *initSpsConnection(int32_t spsConnHandle, int32_t gapConn
         pSpsConn->server.creditsClientConf = 0;
         pSpsConn->spsState = SPS_STATE_DISCONNECTED;
         uPortSemaphoreCreate(&(pSpsConn->txCreditsSemaphore), 0, 1);
-        uRingBufferCreate(&pSpsConn->rxRingBuffer, pSpsConn->rxData, sizeof(pSpsConn->rxData));
+        uPortSemaphoreCreate(&(pSpsConn->txBufferSemaphore), (uint32_t)uPortGattGetTxBufferCount(),
+                             (uint32_t)uPortGattGetTxBufferCount());
+        uRingBufferCreate(&pSpsConn->rxRingBuffer, pSpsConn->pRxData, pSpsConn->rxDataSize);
         uRingBufferReset(&pSpsConn->rxRingBuffer);
         pSpsConn->dataSendTimeoutMs = U_BLE_SPS_DEFAULT_SEND_TIMEOUT_MS;
         pSpsConn->localSpsRole = localSpsRole;
         pSpsConn->flowCtrlEnabled = true;
+        pSpsConn->throughputMode = false;
+        pSpsConn->handlesFromCache = false;
     }
 
     return gpSpsConnections[spsConnHandle];
@@ -445,36 +552,139 @@ static bool sendDataToRemoteFifo(const spsConnection_t *pSpsConn, const char *pD
     bool success;
 
     if ((pSpsConn->localSpsRole == SPS_SERVER) && (pSpsConn->server.fifoClientConf & 1)) {
-        success = (uPortGattNotify(pSpsConn->gapConnHandle,
-                                   &gSpsFifoChar, pData, bytesToSendNow) == (int32_t)U_ERROR_COMMON_SUCCESS);
+        success = (uPortGattNotifyCb(pSpsConn->gapConnHandle,
+                                     &gSpsFifoChar, pData, bytesToSendNow,
+                                     onTxComplete, NULL) == (int32_t)U_ERROR_COMMON_SUCCESS);
     } else {
-        success = (uPortGattWriteAttribute(pSpsConn->gapConnHandle, pSpsConn->client.attHandle.fifoValue,
-                                           pData, bytesToSendNow) == (int32_t)U_ERROR_COMMON_SUCCESS);
+        success = (uPortGattWriteAttributeCb(pSpsConn->gapConnHandle,
+                                             pSpsConn->client.attHandle.fifoValue,
+                                             pData, bytesToSendNow, onTxComplete,
+                                             NULL) == (int32_t)U_ERROR_COMMON_SUCCESS);
     }
 
     return success;
 }
 
+// Called by the BLE stack when a PDU queued by sendDataToRemoteFifo()
+// has gone to the controller, freeing a place for another.
+static void onTxComplete(int32_t gapConnHandle, void *pParameter)
+{
+    int32_t spsConnHandle = findSpsConnHandle(gapConnHandle);
+    (void)pParameter;
+
+    if (spsConnHandle != U_BLE_SPS_INVALID_HANDLE) {
+        uPortSemaphoreGive(pGetSpsConn(spsConnHandle)->txBufferSemaphore);
+    }
+}
+
+// Find the handle cache entry for the given remote address, NULL if
+// there is none; gBleSpsMutex must be locked.
+static spsHandleCacheEntry_t *pFindHandleCacheEntry(const char *pAddress)
+{
+    spsHandleCacheEntry_t *pEntry = NULL;
+
+#if U_BLE_SPS_HANDLE_CACHE_SIZE > 0
+    for (size_t i = 0; (i < U_BLE_SPS_HANDLE_CACHE_SIZE) && (pEntry == NULL); i++) {
+        if ((gHandleCache[i].remoteAddr[0] != 0) &&
+            (strncmp(gHandleCache[i].remoteAddr, pAddress,
+                     sizeof(gHandleCache[i].remoteAddr) - 1) == 0)) {
+            pEntry = &(gHandleCache[i]);
+        }
+    }
+#else
+    (void)pAddress;
+#endif
+
+    return pEntry;
+}
+
+// Add or update the handle cache entry for the given remote address,
+// replacing the least recently used entry if the cache is full;
+// gBleSpsMutex must be locked.
+static void addHandleCacheEntry(const char *pAddress, const uBleSpsHandles_t *pHandles,
+                                bool callCallback)
+{
+#if U_BLE_SPS_HANDLE_CACHE_SIZE > 0
+    spsHandleCacheEntry_t *pEntry = pFindHandleCacheEntry(pAddress);
+
+    if (pEntry == NULL) {
+        pEntry = &(gHandleCache[0]);
+        for (size_t i = 0; i < U_BLE_SPS_HANDLE_CACHE_SIZE; i++) {
+            if (gHandleCache[i].remoteAddr[0] == 0) {
+                pEntry = &(gHandleCache[i]);
+                break;
+            }
+            if (gHandleCache[i].lastUsed < pEntry->lastUsed) {
+                pEntry = &(gHandleCache[i]);
+            }
+        }
+        if ((pEntry->remoteAddr[0] != 0) && callCallback &&
+            (gpHandleCacheCallback != NULL)) {
+            gpHandleCacheCallback(pEntry->remoteAddr, NULL, gpHandleCacheCallbackParam);
+        }
+        memset(pEntry->remoteAddr, 0, sizeof(pEntry->remoteAddr));
+        strncpy(pEntry->remoteAddr, pAddress, sizeof(pEntry->remoteAddr) - 1);
+    }
+    memcpy(&(pEntry->handles), pHandles, sizeof(pEntry->handles));
+    gHandleCacheUseCount++;
+    pEntry->lastUsed = gHandleCacheUseCount;
+    if (callCallback && (gpHandleCacheCallback != NULL)) {
+        gpHandleCacheCallback(pEntry->remoteAddr, &(pEntry->handles),
+                              gpHandleCacheCallbackParam);
+    }
+#else
+    (void)pAddress;
+    (void)pHandles;
+    (void)callCallback;
+#endif
+}
+
+// Remove the handle cache entry for the given remote address;
+// gBleSpsMutex must be locked.
+static void removeHandleCacheEntry(const char *pAddress)
+{
+    spsHandleCacheEntry_t *pEntry = pFindHandleCacheEntry(pAddress);
+
+    if (pEntry != NULL) {
+        if (gpHandleCacheCallback != NULL) {
+            gpHandleCacheCallback(pEntry->remoteAddr, NULL, gpHandleCacheCallbackParam);
+        }
+        memset(pEntry, 0, sizeof(*pEntry));
+    }
+}
+
 static void updateRxCreditsOnRemote(spsConnection_t *pSpsConn)
 {
     size_t avaibleBufferSize = uRingBufferAvailableSize(&(pSpsConn->rxRingBuffer));
-    uint8_t availableRxCredits = 0;
     size_t maxPacketDataSize = pSpsConn->mtu - U_BLE_PDU_HEADER_SIZE;
+    size_t x;
+    uint8_t availableRxCredits;
+    uint8_t batchRxCredits;
     int16_t rxCreditsWeCanSend;
 
     // First we calculate how many full size packets would fit into the current buffer
-    while ((avaibleBufferSize > maxPacketDataSize) && (availableRxCredits < 255)) {
-        avaibleBufferSize -= maxPacketDataSize;
-        availableRxCredits++;
+    // and into the whole buffer, 255 at most
+    x = avaibleBufferSize / maxPacketDataSize;
+    if ((x > 0) && (avaibleBufferSize % maxPacketDataSize == 0)) {
+        // A packet must fit with room to spare
+        x--;
     }
+    availableRxCredits = (x < 255) ? (uint8_t)x : 255;
+    x = pSpsConn->rxDataSize / maxPacketDataSize;
+    // Grant credits in batches of at least half of what the whole buffer
+    // could take, rather than one at a time as the application reads
+    // the data out, so that credit traffic is kept to a few notifications
+    batchRxCredits = (x < 255) ? (uint8_t)((x + 1) / 2) : 128;
 
     // We maybe give the remote permission to send some more packets, but never more than
     // that the total space occupied by the packets could overflow the current free
     // buffer space i.e. availableRxCredits = rxCreditsWeCanSend + rxCreditsOnRemote
     rxCreditsWeCanSend = (int16_t)availableRxCredits - (int16_t)(pSpsConn->rxCreditsOnRemote);
     // Only send new credits when we at least can double the amount available on the remote,
-    // to minimize credits traffic, i.e. when we can send more credits than exists on remote
+    // to minimize credits traffic, i.e. when we can send more credits than exists on remote,
+    // and when there is a whole batch to send
     if ((rxCreditsWeCanSend > (int16_t)(pSpsConn->rxCreditsOnRemote)) &&
+        (rxCreditsWeCanSend >= (int16_t)batchRxCredits) &&
         (rxCreditsWeCanSend > 0)) {
         bool success = false;
 
@@ -558,7 +768,7 @@ static void gapConnectionEvent(int32_t gapConnHandle, uPortGattGapConnStatus_t s
                 // If we get a GAP connected event and there is no handle present
                 // it means the remoted side initiated the connection and we are
                 // SPS server.  In this case we initiate the SPS connection here.
-                spsConnHandle = findFreeSpsConnHandle();
+                spsConnHandle = findFreeSpsConnHandle(gapConnHandle);
                 if (spsConnHandle != U_BLE_SPS_INVALID_HANDLE) {
                     uint8_t addr[6];
                     uPortBtLeAddressType_t addrType;
@@ -566,6 +776,15 @@ static void gapConnectionEvent(int32_t gapConnHandle, uPortGattGapConnStatus_t s
                     uPortGattGetRemoteAddress(gapConnHandle, addr, &addrType);
                     addrArrayToString(addr, addrType, true, pSpsConn->remoteAddr);
                     uPortLog("U_BLE_SPS: Remote GAP connected, SPS conn handle: %d\n", spsConnHandle);
+                    if (gThroughputMode) {
+                        // Do the requests from the event queue rather than
+                        // from the BLE stack callback we are in
+                        spsEvent_t event;
+                        pSpsConn->throughputMode = true;
+                        event.type = EVENT_SPS_THROUGHPUT_REQUEST;
+                        event.spsConnHandle = spsConnHandle;
+                        uPortEventQueueSend(gSpsEventQueue, &event, sizeof(event));
+                    }
                 } else {
                     uPortLog("U_BLE_SPS: We already have maximum nbr of allowed SPS connections!\n", spsConnHandle);
                     uPortGattDisconnectGap(gapConnHandle);
@@ -691,6 +910,31 @@ static void mtuXchangeResp(int32_t gapConnHandle, uint8_t err)
     }
 }
 
+static void requestThroughput(const spsConnection_t *pSpsConn)
+{
+    int32_t gapConnHandle = pSpsConn->gapConnHandle;
+
+    // These are all only requests: the controllers, and for the
+    // connection interval the central, have the final say; the
+    // outcome can be read with uBleSpsGetLinkParams()
+    if (uPortGattUpdateDataLength(gapConnHandle, U_PORT_GATT_DATA_LENGTH_MAX_OCTETS,
+                                  U_PORT_GATT_DATA_LENGTH_MAX_TIME_US) != 0) {
+        uPortLog("U_BLE_SPS: Data length extension request failed\n");
+    }
+    if (uPortGattUpdatePhy(gapConnHandle, U_PORT_GATT_PHY_2M) != 0) {
+        uPortLog("U_BLE_SPS: 2M PHY request failed\n");
+    }
+    if (pSpsConn->localSpsRole == SPS_SERVER) {
+        // As client the connection interval was given when connecting
+        // and the MTU exchange is part of the connection sequence
+        if (uPortGattUpdateConnParams(gapConnHandle,
+                                      (const uPortGattGapParams_t *)&gConnParamsThroughput) != 0) {
+            uPortLog("U_BLE_SPS: Connection parameter update request failed\n");
+        }
+        uPortGattExchangeMtu(gapConnHandle, serverMtuXchangeResp);
+    }
+}
+
 //lint -esym(818, pUuid)
 static uPortGattIter_t onCccDiscovery(int32_t gapConnHandle, uPortGattUuid_t *pUuid,
                                       uint16_t attrHandle)
@@ -820,6 +1064,9 @@ static void onBleSpsEvent(void *pParam, size_t eventSize)
     switch (pEvent->type) {
 
         case EVENT_GAP_CONNECTED:
+            if (pSpsConn->throughputMode) {
+                requestThroughput(pSpsConn);
+            }
             if (pSpsConn->client.attHandle.service == 0) {
                 // If service handle is 0 we assume the handles was not
                 // preset and we have to discover them
@@ -899,6 +1146,13 @@ static void onBleSpsEvent(void *pParam, size_t eventSize)
             uPortLog("U_BLE_SPS: Connected as SPS client. Handle %d, remote addr: %s\n",
                      pEvent->spsConnHandle, pSpsConn->remoteAddr);
             pSpsConn->spsState = SPS_STATE_CONNECTED;
+            if (pSpsConn->flowCtrlEnabled && !pSpsConn->handlesFromCache) {
+                // Discovery found the full set of handles: remember
+                // them for next time
+                U_PORT_MUTEX_LOCK(gBleSpsMutex);
+                addHandleCacheEntry(pSpsConn->remoteAddr, &(pSpsConn->client.attHandle), true);
+                U_PORT_MUTEX_UNLOCK(gBleSpsMutex);
+            }
             if (gpSpsConnStatusCallback != NULL) {
                 gpSpsConnStatusCallback(pEvent->spsConnHandle,
                                         pSpsConn->remoteAddr,
@@ -908,11 +1162,20 @@ static void onBleSpsEvent(void *pParam, size_t eventSize)
                                         gpSpsConnStatusCallbackParam);
             }
             if (pSpsConn->flowCtrlEnabled) {
+                U_PORT_MUTEX_LOCK(pSpsConn->mutex);
                 updateRxCreditsOnRemote(pSpsConn);
+                U_PORT_MUTEX_UNLOCK(pSpsConn->mutex);
             }
             break;
 
         case EVENT_SPS_CONNECTING_FAILED:
+            if (pSpsConn->handlesFromCache) {
+                // The remote server may have changed, so that the cached
+                // handles are no longer right: discover them next time
+                U_PORT_MUTEX_LOCK(gBleSpsMutex);
+                removeHandleCacheEntry(pSpsConn->remoteAddr);
+                U_PORT_MUTEX_UNLOCK(gBleSpsMutex);
+            }
             // Callback gapConnectionEvent will be
             // called later and then reset the SPS connection
             uPortGattDisconnectGap(pSpsConn->gapConnHandle);
@@ -923,6 +1186,11 @@ static void onBleSpsEvent(void *pParam, size_t eventSize)
                 gpSpsDataAvailableCallback(pEvent->spsConnHandle, gpSpsDataAvailableCallbackParam);
             }
             break;
+
+        case EVENT_SPS_THROUGHPUT_REQUEST:
+            // Remote connected to our SPS server in throughput mode
+            requestThroughput(pSpsConn);
+            break;
     }
 }
 
@@ -940,6 +1208,22 @@ static bool write16BitValue(const void *buf, uint16_t len, uint16_t offset, uint
     return false;
 }
 
+static void serverMtuXchangeResp(int32_t gapConnHandle, uint8_t err)
+{
+    int32_t spsConnHandle = findSpsConnHandle(gapConnHandle);
+    int32_t mtu;
+
+    if ((spsConnHandle != U_BLE_SPS_INVALID_HANDLE) && (err == 0)) {
+        // Unlike the client case, nothing waits on this: the new MTU
+        // is simply used from now on for sending and for credits
+        mtu = uPortGattGetMtu(gapConnHandle);
+        if (mtu > 0) {
+            pGetSpsConn(spsConnHandle)->mtu = (uint16_t)mtu;
+            uPortLog("U_BLE_SPS: MTU = %d\n", mtu);
+        }
+    }
+}
+
 static int32_t remoteWritesFifoCcc(int32_t gapConnHandle, const void *buf, uint16_t len,
                                    uint16_t offset, uint8_t flags)
 {
@@ -1085,12 +1369,16 @@ void uBleSpsPrivateInit(void)
 {
     if (gSpsEventQueue == (int32_t)U_ERROR_COMMON_NOT_INITIALISED) {
         uPortMutexCreate(&gBleSpsMutex);
+        gpSpsConnections = (spsConnection_t **)calloc(gMaxConnections, sizeof(spsConnection_t *));
+        if (gpSpsConnections != NULL) {
+            gSpsConnectionsLength = gMaxConnections;
+        }
         uPortGattSetGapConnStatusCallback(gapConnectionEvent, NULL);
 
         gSpsEventQueue = uPortEventQueueOpen(onBleSpsEvent,
                                              "uBleSpsEventQueue", sizeof(spsEvent_t),
                                              U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
-                                             U_CFG_OS_APP_TASK_PRIORITY + 1, 2 * U_BLE_SPS_MAX_CONNECTIONS);
+                                             U_CFG_OS_APP_TASK_PRIORITY + 1, 2 * (int32_t)gMaxConnections);
     }
 }
 
@@ -1099,13 +1387,16 @@ void uBleSpsPrivateDeinit(void)
     if (gSpsEventQueue != (int32_t)U_ERROR_COMMON_NOT_INITIALISED) {
         uPortGattSetGapConnStatusCallback(NULL, NULL);
 
-        for (int32_t i = 0; i < U_BLE_SPS_MAX_CONNECTIONS; i++) {
+        for (int32_t i = 0; i < (int32_t)gSpsConnectionsLength; i++) {
             if (validSpsConnHandle(i)) {
                 spsConnection_t *pSpsConn = pGetSpsConn(i);
                 uPortGattDisconnectGap(pSpsConn->gapConnHandle);
                 freeSpsConnection(i);
             }
         }
+        free(gpSpsConnections);
+        gpSpsConnections = NULL;
+        gSpsConnectionsLength = 0;
 
         uPortEventQueueClose(gSpsEventQueue);
         gSpsEventQueue = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
@@ -1147,7 +1438,7 @@ int32_t uBleSpsConnectSps(uDeviceHandle_t devHandle,
 
     if (errorCode == (int32_t)U_ERROR_COMMON_SUCCESS) {
         if (pConnParams == NULL) {
-            pConnParams = &gConnParamsDefault;
+            pConnParams = gThroughputMode ? &gConnParamsThroughput : &gConnParamsDefault;
         }
         gapConnHandle = uPortGattConnectGap(address, addrType, (const uPortGattGapParams_t *)pConnParams);
 
@@ -1159,7 +1450,7 @@ int32_t uBleSpsConnectSps(uDeviceHandle_t devHandle,
 
             if (gapConnHandle != U_PORT_GATT_GAP_INVALID_CONNHANDLE) {
                 errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-                spsConnHandle = findFreeSpsConnHandle();
+                spsConnHandle = findFreeSpsConnHandle(gapConnHandle);
 
                 if (spsConnHandle != U_BLE_SPS_INVALID_HANDLE) {
                     spsConnection_t *pSpsConn = initSpsConnection(spsConnHandle, gapConnHandle, SPS_CLIENT);
@@ -1168,9 +1459,21 @@ int32_t uBleSpsConnectSps(uDeviceHandle_t devHandle,
                         // Preset server handles (if they are not preset gNextConnServerHandles
                         // is all zero, which will trigger discovery later)
                         memcpy(&(pSpsConn->client.attHandle), &gNextConnServerHandles, sizeof(uBleSpsHandles_t));
+                        if (gNextConnServerHandles.service == 0) {
+                            // Not preset, maybe they are in the cache
+                            spsHandleCacheEntry_t *pEntry = pFindHandleCacheEntry(pAddress);
+                            if (pEntry != NULL) {
+                                memcpy(&(pSpsConn->client.attHandle), &(pEntry->handles),
+                                       sizeof(uBleSpsHandles_t));
+                                gHandleCacheUseCount++;
+                                pEntry->lastUsed = gHandleCacheUseCount;
+                                pSpsConn->handlesFromCache = true;
+                            }
+                        }
                         // Maybe disable flow control
                         pSpsConn->flowCtrlEnabled = gFlowCtrlOnNext;
                         gFlowCtrlOnNext = true;
+                        pSpsConn->throughputMode = gThroughputMode;
                         errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                     }
                 }
@@ -1234,6 +1537,12 @@ int32_t uBleSpsSend(uDeviceHandle_t devHandle, int32_t channel, const char *pDat
     int64_t startTime = uPortGetTickTimeMs();
     int32_t errorCode = (int32_t)U_ERROR_COMMON_SUCCESS;
     spsConnection_t *pSpsConn = pGetSpsConn(spsConnHandle);
+
+    // Only sends on this connection are serialised, those on other
+    // connections carry on in parallel; the BLE stack callbacks that
+    // give credits and TX buffers do not take this lock
+    U_PORT_MUTEX_LOCK(pSpsConn->mutex);
+
     if (pSpsConn->spsState == SPS_STATE_CONNECTED) {
         uint32_t timeout = pSpsConn->dataSendTimeoutMs;
         int64_t time = startTime;
@@ -1264,10 +1573,25 @@ int32_t uBleSpsSend(uDeviceHandle_t devHandle, int32_t channel, const char *pDat
                 }
             }
             if (!pSpsConn->flowCtrlEnabled || (pSpsConn->txCredits > 0)) {
+                // Queue PDUs back to back while the BLE stack has buffers for them,
+                // so that several can go in one connection event, and otherwise wait
+                // for one to be sent rather than blocking inside the BLE stack
+                int32_t timeoutLeft = (int32_t)timeout -
+                                      (int32_t)(uPortGetTickTimeMs() - startTime);
+                if (timeoutLeft < 0) {
+                    timeoutLeft = 0;
+                }
+                if (uPortSemaphoreTryTake(pSpsConn->txBufferSemaphore, timeoutLeft) != 0) {
+                    uPortLog("U_BLE_SPS: SPS Timed out waiting for a TX buffer!\n");
+                    break;
+                }
                 if (sendDataToRemoteFifo(pSpsConn, pData, (uint16_t)bytesToSendNow)) {
                     pData += bytesToSendNow;
                     bytesLeftToSend -= bytesToSendNow;
                     pSpsConn->txCredits--;
+                } else {
+                    // Not queued, so no callback will come
+                    uPortSemaphoreGive(pSpsConn->txBufferSemaphore);
                 }
             } else {
                 // We have flow control enabled, we didn't time out waiting
@@ -1282,6 +1606,8 @@ int32_t uBleSpsSend(uDeviceHandle_t devHandle, int32_t channel, const char *pDat
         }
     }
 
+    U_PORT_MUTEX_UNLOCK(pSpsConn->mutex);
+
     if (errorCode < 0) {
         return errorCode;
     } else {
@@ -1314,10 +1640,12 @@ int32_t uBleSpsReceive(uDeviceHandle_t devHandle, int32_t channel, char *pData,
 
     if (validSpsConnHandle(spsConnHandle)) {
         spsConnection_t *pSpsConn = pGetSpsConn(spsConnHandle);
+        U_PORT_MUTEX_LOCK(pSpsConn->mutex);
         sizeOrErrorCode = (int32_t)uRingBufferRead(&(pSpsConn->rxRingBuffer), pData, length);
         if ((sizeOrErrorCode > 0) && (pSpsConn->flowCtrlEnabled)) {
             updateRxCreditsOnRemote(pSpsConn);
         }
+        U_PORT_MUTEX_UNLOCK(pSpsConn->mutex);
     } else {
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
     }
@@ -1325,6 +1653,90 @@ int32_t uBleSpsReceive(uDeviceHandle_t devHandle, int32_t channel, char *pData,
     return sizeOrErrorCode;
 }
 
+int32_t uBleSpsReceivePeek(uDeviceHandle_t devHandle, int32_t channel, const char **ppData)
+{
+    int32_t spsConnHandle = channel;
+    int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    uRingBufferSpan_t spans[2];
+
+    if ((uDeviceGetDeviceType(devHandle) == (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) &&
+        validSpsConnHandle(spsConnHandle) && (ppData != NULL)) {
+        spsConnection_t *pSpsConn = pGetSpsConn(spsConnHandle);
+        // Only the first span is handed out: once it has been committed
+        // any wrapped data will be in the first span next time
+        uRingBufferPeekSpans(&(pSpsConn->rxRingBuffer), spans);
+        *ppData = spans[0].pData;
+        sizeOrErrorCode = (int32_t)spans[0].length;
+    }
+
+    return sizeOrErrorCode;
+}
+
+int32_t uBleSpsReceiveCommit(uDeviceHandle_t devHandle, int32_t channel, int32_t length)
+{
+    int32_t spsConnHandle = channel;
+    int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((uDeviceGetDeviceType(devHandle) == (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) &&
+        validSpsConnHandle(spsConnHandle) && (length >= 0)) {
+        spsConnection_t *pSpsConn = pGetSpsConn(spsConnHandle);
+        U_PORT_MUTEX_LOCK(pSpsConn->mutex);
+        sizeOrErrorCode = (int32_t)uRingBufferReadCommit(&(pSpsConn->rxRingBuffer),
+                                                         (size_t)length);
+        if ((sizeOrErrorCode > 0) && (pSpsConn->flowCtrlEnabled)) {
+            updateRxCreditsOnRemote(pSpsConn);
+        }
+        U_PORT_MUTEX_UNLOCK(pSpsConn->mutex);
+    }
+
+    return sizeOrErrorCode;
+}
+
+int32_t uBleSpsGetRxStats(uDeviceHandle_t devHandle, int32_t channel,
+                          uBleSpsRxStats_t *pStats)
+{
+    int32_t spsConnHandle = channel;
+    int32_t errorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((uDeviceGetDeviceType(devHandle) == (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) &&
+        validSpsConnHandle(spsConnHandle) && (pStats != NULL)) {
+        spsConnection_t *pSpsConn = pGetSpsConn(spsConnHandle);
+        pStats->highWaterMarkBytes = uRingBufferStatHighWaterMark(&(pSpsConn->rxRingBuffer));
+        pStats->lossBytes = uRingBufferStatAddLoss(&(pSpsConn->rxRingBuffer));
+        uRingBufferStatOccupancy(&(pSpsConn->rxRingBuffer), pStats->occupancy,
+                                 sizeof(pStats->occupancy) / sizeof(pStats->occupancy[0]));
+        errorCode = (int32_t)U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+int32_t uBleSpsGetLinkParams(uDeviceHandle_t devHandle, int32_t channel,
+                             uBleSpsLinkParams_t *pParams)
+{
+    int32_t spsConnHandle = channel;
+    int32_t errorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortGattLinkParams_t linkParams;
+
+    if ((uDeviceGetDeviceType(devHandle) == (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) &&
+        validSpsConnHandle(spsConnHandle) && (pParams != NULL)) {
+        spsConnection_t *pSpsConn = pGetSpsConn(spsConnHandle);
+        errorCode = uPortGattGetLinkParams(pSpsConn->gapConnHandle, &linkParams);
+        if (errorCode == (int32_t)U_ERROR_COMMON_SUCCESS) {
+            pParams->mtu = pSpsConn->mtu;
+            pParams->connInterval = linkParams.connInterval;
+            pParams->connLatency = linkParams.connLatency;
+            pParams->linkLossTimeout = linkParams.linkLossTimeout;
+            pParams->txDataLength = linkParams.txDataLength;
+            pParams->rxDataLength = linkParams.rxDataLength;
+            pParams->txPhy = linkParams.txPhy;
+            pParams->rxPhy = linkParams.rxPhy;
+        }
+    }
+
+    return errorCode;
+}
+
 int32_t uBleSpsGetSpsServerHandles(uDeviceHandle_t devHandle, int32_t channel,
                                    uBleSpsHandles_t *pHandles)
 {
@@ -1359,6 +1771,57 @@ int32_t uBleSpsPresetSpsServerHandles(uDeviceHandle_t devHandle, const uBleSpsHa
     return (int32_t)U_ERROR_COMMON_SUCCESS;
 }
 
+int32_t uBleSpsSetHandleCacheCallback(uDeviceHandle_t devHandle,
+                                      uBleSpsHandleCacheCallback_t pCallback,
+                                      void *pCallbackParameter)
+{
+    if (uDeviceGetDeviceType(devHandle) != (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) {
+        return (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+
+    U_PORT_MUTEX_LOCK(gBleSpsMutex);
+    gpHandleCacheCallback = pCallback;
+    gpHandleCacheCallbackParam = pCallbackParameter;
+    U_PORT_MUTEX_UNLOCK(gBleSpsMutex);
+
+    return (int32_t)U_ERROR_COMMON_SUCCESS;
+}
+
+int32_t uBleSpsAddCachedServerHandles(uDeviceHandle_t devHandle, const char *pAddress,
+                                      const uBleSpsHandles_t *pHandles)
+{
+    if ((uDeviceGetDeviceType(devHandle) != (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) ||
+        (pAddress == NULL) || (pAddress[0] == 0) || (pHandles == NULL) ||
+        (pHandles->service == 0)) {
+        return (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+
+    U_PORT_MUTEX_LOCK(gBleSpsMutex);
+    addHandleCacheEntry(pAddress, pHandles, false);
+    U_PORT_MUTEX_UNLOCK(gBleSpsMutex);
+
+    return (int32_t)U_ERROR_COMMON_SUCCESS;
+}
+
+int32_t uBleSpsClearHandleCache(uDeviceHandle_t devHandle)
+{
+    if (uDeviceGetDeviceType(devHandle) != (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) {
+        return (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+
+    U_PORT_MUTEX_LOCK(gBleSpsMutex);
+#if U_BLE_SPS_HANDLE_CACHE_SIZE > 0
+    for (size_t i = 0; i < U_BLE_SPS_HANDLE_CACHE_SIZE; i++) {
+        if (gHandleCache[i].remoteAddr[0] != 0) {
+            removeHandleCacheEntry(gHandleCache[i].remoteAddr);
+        }
+    }
+#endif
+    U_PORT_MUTEX_UNLOCK(gBleSpsMutex);
+
+    return (int32_t)U_ERROR_COMMON_SUCCESS;
+}
+
 int32_t uBleSpsDisableFlowCtrlOnNext(uDeviceHandle_t devHandle)
 {
     if (uDeviceGetDeviceType(devHandle) != (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) {
@@ -1370,6 +1833,71 @@ int32_t uBleSpsDisableFlowCtrlOnNext(uDeviceHandle_t devHandle)
     return (int32_t)U_ERROR_COMMON_SUCCESS;
 }
 
+int32_t uBleSpsSetThroughputMode(uDeviceHandle_t devHandle, bool enable)
+{
+    if (uDeviceGetDeviceType(devHandle) != (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) {
+        return (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+
+    gThroughputMode = enable;
+
+    return (int32_t)U_ERROR_COMMON_SUCCESS;
+}
+
+int32_t uBleSpsSetRxBufferOnNext(uDeviceHandle_t devHandle, char *pBuffer, size_t size)
+{
+    if ((uDeviceGetDeviceType(devHandle) != (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) ||
+        (size == 0)) {
+        return (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+
+    gpRxBufferNext = pBuffer;
+    gRxBufferSizeNext = size;
+
+    return (int32_t)U_ERROR_COMMON_SUCCESS;
+}
+
+int32_t uBleSpsSetMaxConnections(uDeviceHandle_t devHandle, size_t maxConnections)
+{
+    int32_t errorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    spsConnection_t **pConnections;
+    bool inUse = false;
+
+    if ((uDeviceGetDeviceType(devHandle) != (int32_t)U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU) ||
+        (maxConnections == 0) || (maxConnections > INT32_MAX)) {
+        return errorCode;
+    }
+
+    if (gBleSpsMutex == NULL) {
+        // Not initialised yet, the table is allocated at initialisation
+        gMaxConnections = maxConnections;
+        return (int32_t)U_ERROR_COMMON_SUCCESS;
+    }
+
+    U_PORT_MUTEX_LOCK(gBleSpsMutex);
+
+    // The handles of existing connections are indexes into
+    // the table so it can only be changed when there are none
+    for (size_t i = 0; (i < gSpsConnectionsLength) && !inUse; i++) {
+        inUse = (gpSpsConnections[i] != NULL);
+    }
+    if (!inUse) {
+        errorCode = (int32_t)U_ERROR_COMMON_NO_MEMORY;
+        pConnections = (spsConnection_t **)calloc(maxConnections, sizeof(spsConnection_t *));
+        if (pConnections != NULL) {
+            free(gpSpsConnections);
+            gpSpsConnections = pConnections;
+            gSpsConnectionsLength = maxConnections;
+            gMaxConnections = maxConnections;
+            errorCode = (int32_t)U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(gBleSpsMutex);
+
+    return errorCode;
+}
+
 #endif
 
 // End of file
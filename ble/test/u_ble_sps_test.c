@@ -68,6 +68,7 @@
 #include "u_short_range.h"
 #include "u_short_range_edm_stream.h"
 #include "u_ble.h"
+#include "u_ble_cfg.h"
 
 #include "u_short_range_test_selector.h"
 
@@ -86,6 +87,21 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
+#if defined(U_CFG_BLE_MODULE_INTERNAL) && (defined(U_BLE_TEST_CFG_REMOTE_SPS_CENTRAL) || \
+                                           defined(U_BLE_TEST_CFG_REMOTE_SPS_PERIPHERAL))
+/** Set if the throughput test can be run: this needs a BLE stack
+ * on this MCU and a remote SPS device which echoes back what it
+ * is sent.
+ */
+# define U_BLE_SPS_TEST_THROUGHPUT
+#endif
+
+#ifndef U_BLE_SPS_TEST_THROUGHPUT_BYTES
+/** The amount of data to send in the throughput test.
+ */
+# define U_BLE_SPS_TEST_THROUGHPUT_BYTES (16 * 1024)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -96,6 +112,33 @@
 
 static uBleTestPrivate_t gHandles = { -1, -1, NULL, NULL };
 
+#ifdef U_BLE_SPS_TEST_THROUGHPUT
+/** One of the macros U_BLE_TEST_CFG_REMOTE_SPS_PERIPHERAL or
+ * U_BLE_TEST_CFG_REMOTE_SPS_CENTRAL should be set to the address
+ * of the BLE test peer WITHOUT quotation marks, e.g.
+ * U_BLE_TEST_CFG_REMOTE_SPS_PERIPHERAL=2462ABB6EAC6p.
+ */
+# ifdef U_BLE_TEST_CFG_REMOTE_SPS_PERIPHERAL
+static const char gRemoteSpsAddress[] =
+    U_PORT_STRINGIFY_QUOTED(U_BLE_TEST_CFG_REMOTE_SPS_PERIPHERAL);
+# else
+static const char gRemoteSpsAddress[] =
+    U_PORT_STRINGIFY_QUOTED(U_BLE_TEST_CFG_REMOTE_SPS_CENTRAL);
+# endif
+
+/** Data to send in the throughput test.
+ */
+static char gThroughputData[512];
+
+/** Receive buffer for the throughput test, large enough for the
+ * remote device to be given plenty of credits.
+ */
+static char gThroughputRxBuffer[U_BLE_SPS_BUFFER_SIZE * 4];
+
+static volatile int32_t gThroughputChannel = -1;
+static volatile int32_t gThroughputBytesReceived = 0;
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -176,6 +219,215 @@ U_PORT_TEST_FUNCTION("[bleSps]", "bleSps")
 
 #endif
 
+#ifdef U_CFG_BLE_MODULE_INTERNAL
+
+static void handleCacheCallback(const char *pAddress, const uBleSpsHandles_t *pHandles,
+                                void *pCallbackParameter)
+{
+    int32_t *pDroppedCount = (int32_t *) pCallbackParameter;
+
+    U_TEST_PRINT_LINE("handle cache: %s %s.", pAddress,
+                      pHandles == NULL ? "dropped" : "added");
+    if (pHandles == NULL) {
+        (*pDroppedCount)++;
+    }
+}
+
+/** Check the attribute handle cache API; filling the cache itself
+ * needs a connection to a real SPS server.
+ */
+U_PORT_TEST_FUNCTION("[bleSps]", "bleSpsHandleCache")
+{
+    uBleSpsHandles_t handles = {0};
+    int32_t droppedCount = 0;
+
+    U_PORT_TEST_ASSERT(uBleTestPrivatePreamble(U_BLE_MODULE_TYPE_INTERNAL,
+                                               NULL,
+                                               &gHandles) == 0);
+    U_PORT_TEST_ASSERT(uBleSpsSetHandleCacheCallback(gHandles.devHandle,
+                                                     handleCacheCallback,
+                                                     &droppedCount) == 0);
+    U_PORT_TEST_ASSERT(uBleSpsClearHandleCache(gHandles.devHandle) == 0);
+    droppedCount = 0;
+
+    // A service handle of zero means "not known", so is not allowed
+    U_PORT_TEST_ASSERT(uBleSpsAddCachedServerHandles(gHandles.devHandle, "2462ABB6EAC6p",
+                                                     &handles) < 0);
+    U_PORT_TEST_ASSERT(uBleSpsAddCachedServerHandles(gHandles.devHandle, "2462ABB6EAC6p",
+                                                     NULL) < 0);
+    handles.service = 10;
+    handles.fifoValue = 12;
+    handles.fifoCcc = 13;
+    handles.creditsValue = 15;
+    handles.creditsCcc = 16;
+    U_PORT_TEST_ASSERT(uBleSpsAddCachedServerHandles(gHandles.devHandle, NULL,
+                                                     &handles) < 0);
+    U_PORT_TEST_ASSERT(uBleSpsAddCachedServerHandles(gHandles.devHandle, "2462ABB6EAC6p",
+                                                     &handles) == 0);
+    // Adding the same address again replaces the entry
+    U_PORT_TEST_ASSERT(uBleSpsAddCachedServerHandles(gHandles.devHandle, "2462ABB6EAC6p",
+                                                     &handles) == 0);
+    U_PORT_TEST_ASSERT(uBleSpsAddCachedServerHandles(gHandles.devHandle, "2462ABB6EAC7r",
+                                                     &handles) == 0);
+    // Adding does not call the callback, clearing does
+    U_PORT_TEST_ASSERT(droppedCount == 0);
+    U_PORT_TEST_ASSERT(uBleSpsClearHandleCache(gHandles.devHandle) == 0);
+    U_PORT_TEST_ASSERT(droppedCount == 2);
+    U_PORT_TEST_ASSERT(uBleSpsClearHandleCache(gHandles.devHandle) == 0);
+    U_PORT_TEST_ASSERT(droppedCount == 2);
+
+    U_PORT_TEST_ASSERT(uBleSpsSetHandleCacheCallback(gHandles.devHandle, NULL, NULL) == 0);
+
+    // With no connections the connection limit can be changed,
+    // but not to zero; put it back to the default afterwards
+    U_PORT_TEST_ASSERT(uBleSpsSetMaxConnections(gHandles.devHandle, 0) < 0);
+    U_PORT_TEST_ASSERT(uBleSpsSetMaxConnections(gHandles.devHandle,
+                                                U_BLE_SPS_MAX_CONNECTIONS * 2) == 0);
+    U_PORT_TEST_ASSERT(uBleSpsSetMaxConnections(gHandles.devHandle,
+                                                U_BLE_SPS_MAX_CONNECTIONS) == 0);
+
+    uBleTestPrivatePostamble(&gHandles);
+}
+
+#endif
+
+#ifdef U_BLE_SPS_TEST_THROUGHPUT
+
+static void throughputDataCallback(int32_t channel, void *pParameters)
+{
+    const char *pData;
+    int32_t length;
+    (void) pParameters;
+
+    // Receive without a copy
+    do {
+        length = uBleSpsReceivePeek(gHandles.devHandle, channel, &pData);
+        if (length > 0) {
+            gThroughputBytesReceived += uBleSpsReceiveCommit(gHandles.devHandle,
+                                                             channel, length);
+        }
+    } while (length > 0);
+}
+
+static void throughputConnectionCallback(int32_t connHandle, char *address, int32_t type,
+                                         int32_t channel, int32_t mtu, void *pParameters)
+{
+    (void) connHandle;
+    (void) address;
+    (void) pParameters;
+    if (type == (int32_t) U_BLE_SPS_CONNECTED) {
+        U_TEST_PRINT_LINE("connected on channel %d, MTU %d.", channel, mtu);
+        gThroughputChannel = channel;
+    } else {
+        gThroughputChannel = -1;
+    }
+}
+
+/** Measure SPS throughput in throughput mode: the remote SPS
+ * device echoes back what it is sent.
+ */
+U_PORT_TEST_FUNCTION("[bleSps]", "bleSpsThroughput")
+{
+    uBleCfg_t cfg;
+    uBleSpsLinkParams_t linkParams;
+    int32_t bytesSent = 0;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t x;
+
+    U_PORT_TEST_ASSERT(uBleTestPrivatePreamble(U_BLE_MODULE_TYPE_INTERNAL,
+                                               NULL,
+                                               &gHandles) == 0);
+# ifdef U_BLE_TEST_CFG_REMOTE_SPS_PERIPHERAL
+    cfg.role = U_BLE_CFG_ROLE_CENTRAL;
+    cfg.spsServer = false;
+# else
+    cfg.role = U_BLE_CFG_ROLE_PERIPHERAL;
+    cfg.spsServer = true;
+# endif
+    U_PORT_TEST_ASSERT(uBleCfgConfigure(gHandles.devHandle, &cfg) == 0);
+
+    for (size_t y = 0; y < sizeof(gThroughputData); y++) {
+        gThroughputData[y] = (char) ('0' + (y % 64));
+    }
+    gThroughputChannel = -1;
+    gThroughputBytesReceived = 0;
+    U_PORT_TEST_ASSERT(uBleSpsSetCallbackConnectionStatus(gHandles.devHandle,
+                                                          throughputConnectionCallback,
+                                                          NULL) == 0);
+    U_PORT_TEST_ASSERT(uBleSpsSetDataAvailableCallback(gHandles.devHandle,
+                                                       throughputDataCallback,
+                                                       NULL) == 0);
+    U_PORT_TEST_ASSERT(uBleSpsSetThroughputMode(gHandles.devHandle, true) == 0);
+    U_PORT_TEST_ASSERT(uBleSpsSetRxBufferOnNext(gHandles.devHandle, gThroughputRxBuffer,
+                                                sizeof(gThroughputRxBuffer)) == 0);
+
+    for (size_t tries = 0; (tries < 3) && (gThroughputChannel < 0); tries++) {
+        U_TEST_PRINT_LINE("connecting SPS: %s.", gRemoteSpsAddress);
+        if (uBleSpsConnectSps(gHandles.devHandle, gRemoteSpsAddress, NULL) == 0) {
+            for (x = 0; (x < 100) && (gThroughputChannel < 0); x++) {
+                uPortTaskBlock(100);
+            }
+        } else {
+            uPortTaskBlock(5000);
+        }
+    }
+    U_PORT_TEST_ASSERT(gThroughputChannel >= 0);
+
+    // Give the PHY, data length and connection interval time to settle
+    uPortTaskBlock(1000);
+    U_PORT_TEST_ASSERT(uBleSpsGetLinkParams(gHandles.devHandle, gThroughputChannel,
+                                            &linkParams) == 0);
+    U_TEST_PRINT_LINE("MTU %d, connection interval %d * 1.25 ms, latency %d,"
+                      " data length tx %d rx %d, PHY tx %d rx %d.", linkParams.mtu,
+                      linkParams.connInterval, linkParams.connLatency,
+                      linkParams.txDataLength, linkParams.rxDataLength,
+                      linkParams.txPhy, linkParams.rxPhy);
+    U_PORT_TEST_ASSERT(linkParams.mtu >= 23);
+
+    // Send the data and wait for it all to come back
+    uBleSpsSetSendTimeout(gHandles.devHandle, gThroughputChannel, 1000);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((bytesSent < U_BLE_SPS_TEST_THROUGHPUT_BYTES) &&
+           (uPortGetTickTimeMs() - startTimeMs < 60000)) {
+        x = uBleSpsSend(gHandles.devHandle, gThroughputChannel, gThroughputData,
+                        sizeof(gThroughputData));
+        if (x > 0) {
+            bytesSent += x;
+        } else {
+            uPortTaskBlock(10);
+        }
+    }
+    while ((gThroughputBytesReceived < bytesSent) &&
+           (uPortGetTickTimeMs() - startTimeMs < 60000)) {
+        uPortTaskBlock(10);
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("%d byte(s) sent and %d byte(s) echoed back in %d ms,"
+                      " %d byte(s)/s each way.", bytesSent,
+                      gThroughputBytesReceived, durationMs,
+                      (durationMs > 0) ? (int32_t) (((int64_t) bytesSent * 1000) / durationMs) : 0);
+    U_PORT_TEST_ASSERT(bytesSent >= U_BLE_SPS_TEST_THROUGHPUT_BYTES);
+    U_PORT_TEST_ASSERT(gThroughputBytesReceived == bytesSent);
+
+    // Disconnect and tidy up
+    U_PORT_TEST_ASSERT(uBleSpsDisconnect(gHandles.devHandle, gThroughputChannel) == 0);
+    for (x = 0; (x < 40) && (gThroughputChannel >= 0); x++) {
+        uPortTaskBlock(100);
+    }
+    U_PORT_TEST_ASSERT(gThroughputChannel < 0);
+    uBleSpsSetThroughputMode(gHandles.devHandle, false);
+    uBleSpsSetDataAvailableCallback(gHandles.devHandle, NULL, NULL);
+    uBleSpsSetCallbackConnectionStatus(gHandles.devHandle, NULL, NULL);
+    cfg.role = U_BLE_CFG_ROLE_DISABLED;
+    cfg.spsServer = false;
+    uBleCfgConfigure(gHandles.devHandle, &cfg);
+
+    uBleTestPrivatePostamble(&gHandles);
+}
+
+#endif // U_BLE_SPS_TEST_THROUGHPUT
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -59,6 +59,8 @@
 #include "u_short_range.h"
 #include "u_short_range_edm_stream.h"
 #include "u_ble.h"
+#include "u_ble_cfg.h"
+#include "u_ble_scan.h"
 //lint -efile(766, u_ble_private.h)
 #include "u_ble_private.h"
 
@@ -90,10 +92,44 @@
  */
 static uBleTestPrivate_t gHandles = {-1, -1, NULL, NULL };
 
+#ifndef U_CFG_BLE_MODULE_INTERNAL
+/** The number of advertisements reported by a scan.
+ */
+static int32_t gScanCount = 0;
+
+/** Set to true if a scan reports something it should not have.
+ */
+static bool gScanBad = false;
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+#ifndef U_CFG_BLE_MODULE_INTERNAL
+// Callback for uBleScan(): check the advertisement against the
+// configuration, which is passed in as the parameter, and stop
+// after the given number of advertisements, if not zero.
+static bool scanCallback(uDeviceHandle_t devHandle,
+                         const uBleScanResult_t *pResult,
+                         void *pCallbackParameter)
+{
+    const uBleScanCfg_t *pCfg = (const uBleScanCfg_t *) pCallbackParameter;
+
+    if ((devHandle != gHandles.devHandle) ||
+        ((pCfg->rssiMin != 0) && (pResult->rssi < pCfg->rssiMin)) ||
+        (pResult->dataLength > sizeof(pResult->data))) {
+        gScanBad = true;
+    }
+    gScanCount++;
+    U_TEST_PRINT_LINE("%s, RSSI %d dBm, \"%s\", %d byte(s) of %s.", pResult->address,
+                      pResult->rssi, pResult->name, pResult->dataLength,
+                      pResult->scanResponse ? "scan response" : "advertisement");
+
+    return gScanCount < 3;
+}
+#endif
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -185,6 +221,56 @@ U_PORT_TEST_FUNCTION("[ble]", "bleOpenUart")
 #endif
 }
 
+/** Scan for advertisements, deduplicating and stopping early.
+ */
+U_PORT_TEST_FUNCTION("[ble]", "bleScan")
+{
+    uShortRangeUartConfig_t uart = { .uartPort = U_CFG_APP_SHORT_RANGE_UART,
+                                     .baudRate = U_SHORT_RANGE_UART_BAUD_RATE,
+                                     .pinTx = U_CFG_APP_PIN_SHORT_RANGE_TXD,
+                                     .pinRx = U_CFG_APP_PIN_SHORT_RANGE_RXD,
+                                     .pinCts = U_CFG_APP_PIN_SHORT_RANGE_CTS,
+                                     .pinRts = U_CFG_APP_PIN_SHORT_RANGE_RTS
+                                   };
+    uBleCfg_t cfg = {.role = U_BLE_CFG_ROLE_CENTRAL, .spsServer = false};
+    uBleScanCfg_t scanCfg = {0};
+    char uuid[2] = {0};
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+    U_PORT_TEST_ASSERT(uBleTestPrivatePreamble((uBleModuleType_t) U_CFG_TEST_SHORT_RANGE_MODULE_TYPE,
+                                               &uart,
+                                               &gHandles) == 0);
+    U_PORT_TEST_ASSERT(uBleCfgConfigure(gHandles.devHandle, &cfg) == 0);
+
+    U_TEST_PRINT_LINE("checking parameters.");
+    U_PORT_TEST_ASSERT(uBleScan(gHandles.devHandle, NULL, NULL, NULL) < 0);
+    scanCfg.pServiceUuid = uuid;
+    scanCfg.serviceUuidLength = 3;
+    U_PORT_TEST_ASSERT(uBleScan(gHandles.devHandle, &scanCfg, scanCallback, &scanCfg) < 0);
+    scanCfg.pServiceUuid = NULL;
+    scanCfg.pAddressPrefix = "0123456789ABCDEF";
+    U_PORT_TEST_ASSERT(uBleScan(gHandles.devHandle, &scanCfg, scanCallback, &scanCfg) < 0);
+
+    // There may be no-one advertising, so can only check that
+    // what is reported obeys the filters
+    U_TEST_PRINT_LINE("scanning, deduplicated, RSSI at least -90 dBm.");
+    scanCfg.pAddressPrefix = NULL;
+    scanCfg.durationMs = 3000;
+    scanCfg.rssiMin = -90;
+    scanCfg.dedupWindowMs = 10000;
+    gScanCount = 0;
+    gScanBad = false;
+    U_PORT_TEST_ASSERT(uBleScan(gHandles.devHandle, &scanCfg, scanCallback, &scanCfg) == 0);
+    U_TEST_PRINT_LINE("%d advertisement(s) reported.", gScanCount);
+    U_PORT_TEST_ASSERT(!gScanBad);
+    U_PORT_TEST_ASSERT(gScanCount <= 3);
+
+    // The AT interface must still work after a scan that was stopped
+    U_PORT_TEST_ASSERT(uShortRangeAttention(gHandles.devHandle) == 0);
+
+    uBleTestPrivatePostamble(&gHandles);
+}
 #else
 U_PORT_TEST_FUNCTION("[ble]", "bleOpenCpuInit")
 {
@@ -143,12 +143,16 @@ int32_t uBleTestPrivatePreamble(uBleModuleType_t moduleType,
     }
 
 #else
+    uDeviceInstance_t *pInstance;
+
     if (uPortInit() == 0) {
         errorCodeOrHandle = uBleInit();
 
         if (errorCodeOrHandle >= (int32_t) U_ERROR_COMMON_SUCCESS) {
-            pParameters->devHandle =
-                (uDeviceHandle_t)pUDeviceCreateInstance(U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU);
+            pInstance = pUDeviceCreateInstance(U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU);
+            if (pInstance != NULL) {
+                pParameters->devHandle = U_DEVICE_HANDLE(pInstance);
+            }
         }
     }
     (void)moduleType;
@@ -169,7 +173,7 @@ void uBleTestPrivatePostamble(uBleTestPrivate_t *pParameters)
     uAtClientDeinit();
 
 #else
-    uDeviceDestroyInstance((uDeviceInstance_t *)pParameters->devHandle);
+    uDeviceDestroyInstance(U_DEVICE_INSTANCE(pParameters->devHandle));
     uBleDeinit();
     (void)pParameters;
 #endif
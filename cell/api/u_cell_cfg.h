@@ -59,10 +59,62 @@ extern "C" {
  */
 #define U_CELL_CFG_BAND_MASK_2_EUROPE_NB1_DEFAULT 0LL
 
+#ifndef U_CELL_CFG_DESIRED_MAX_NUM_RATS
+/** The number of RATs, in rank order, that can be given in a
+ * #uCellCfgDesired_t; must be at least as large as the maximum
+ * number of simultaneous RATs of any supported module.
+ */
+# define U_CELL_CFG_DESIRED_MAX_NUM_RATS 3
+#endif
+
+/** The number of band masks that can be given in a
+ * #uCellCfgDesired_t, limited by the number that AT+UBANDMASK
+ * reports.
+ */
+#define U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS 2
+
+/** Suggested initialiser for a #uCellCfgDesired_t: leaves
+ * everything as it is.
+ */
+#define U_CELL_CFG_DESIRED_DEFAULTS {-1, {U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED}, \
+                                     {{U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED, 0, 0}}}
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The band mask for one RAT, as used in #uCellCfgDesired_t.
+ */
+typedef struct {
+    uCellNetRat_t rat;  /**< the RAT this band mask applies to, or
+                             #U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED if
+                             this entry is not used. */
+    uint64_t bandMask1; /**< band mask bits 1 to 64, as for
+                             uCellCfgSetBandMask(). */
+    uint64_t bandMask2; /**< band mask bits 65 to 128, as for
+                             uCellCfgSetBandMask(). */
+} uCellCfgBandMask_t;
+
+/** A complete desired configuration of the module, for
+ * uCellCfgApply(); anything set to "leave" is neither read nor
+ * written.  Initialise with #U_CELL_CFG_DESIRED_DEFAULTS and then
+ * fill in what you care about.
+ */
+typedef struct {
+    int32_t mnoProfile; /**< the MNO profile, negative to leave it
+                             as it is. */
+    uCellNetRat_t rat[U_CELL_CFG_DESIRED_MAX_NUM_RATS]; /**< the RATs
+                             in rank order, highest first, unused
+                             ranks set to
+                             #U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED; if
+                             rat[0] is #U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED
+                             the RATs are left as they are. */
+    uCellCfgBandMask_t bandMask[U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS]; /**<
+                             the band masks to set; the band masks
+                             of RATs not mentioned here are left as
+                             they are. */
+} uCellCfgDesired_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -220,6 +272,54 @@ int32_t uCellCfgSetMnoProfile(uDeviceHandle_t cellHandle,
  */
 int32_t uCellCfgGetMnoProfile(uDeviceHandle_t cellHandle);
 
+/** Apply a complete desired configuration (MNO profile, RATs and
+ * band masks) to the cellular module.  The current settings are read
+ * from the module in a single batch of AT commands and only those
+ * that differ from pDesired are written, so calling this on every
+ * power-on costs one round trip when nothing has changed.  The
+ * module must be powered on for this to work but must NOT be
+ * connected to the cellular network.
+ *
+ * If pFingerprint is not NULL and the value it points to is the
+ * fingerprint of pDesired (and of the module type) then nothing is
+ * done at all, not even the read; otherwise, once the module
+ * configuration has been brought into line with pDesired, the
+ * fingerprint is written to pFingerprint.  The application may keep
+ * the fingerprint in non-volatile storage and pass it in on later
+ * boots to skip the check entirely; a fingerprint is never zero so
+ * zero may be used as "none".  Since the fingerprint is only as good
+ * as the assumption that nothing else has changed the configuration
+ * of the module, the application should clear its stored fingerprint
+ * if it calls uCellCfgFactoryReset(), uCellCfgSetMnoProfile() etc.
+ *
+ * The MNO profile is dealt with first and, since a change of MNO
+ * profile causes the module to adopt the RATs and band masks of that
+ * profile when it next boots, if the MNO profile has to be changed
+ * then nothing else is written and no fingerprint is returned: re-boot
+ * the module (with a call to uCellPwrReboot()) and call this function
+ * again to apply the rest.  Where the return value is greater than zero
+ * the module must be re-booted for the new settings to take effect,
+ * see uCellPwrRebootIsRequired().
+ *
+ * Note: SARA-U201 does not support MNO profile or band masks and is
+ * not supported by this function.
+ *
+ * @param cellHandle        the handle of the cellular instance.
+ * @param[in] pDesired      the desired configuration; cannot be NULL.
+ * @param[in,out] pFingerprint pointer to a fingerprint from a previous
+ *                          call, or zero; on success, if the whole
+ *                          configuration has been applied, the
+ *                          fingerprint of pDesired is written here.
+ *                          May be NULL.
+ * @return                  the number of settings that were changed
+ *                          (zero if the module was already configured
+ *                          as desired or the fingerprint matched),
+ *                          else negative error code.
+ */
+int32_t uCellCfgApply(uDeviceHandle_t cellHandle,
+                      const uCellCfgDesired_t *pDesired,
+                      uint32_t *pFingerprint);
+
 /** Configures the cellular module's serial interface. The configuration
  * affects how an available (physical or logical) serial interface is
  * used, e.g the meaning of data flowing over it. Possible usages are:
@@ -381,6 +481,28 @@ int32_t uCellCfgSetAutoBaudOn(uDeviceHandle_t cellHandle);
  */
 bool uCellCfgAutoBaudIsOn(uDeviceHandle_t cellHandle);
 
+/** Set the baud rate of the UART of the cellular module, WITHOUT
+ * storing it in non-volatile memory.  The module switches to the new
+ * rate as soon as it has responded "OK", hence, once this function
+ * has returned successfully, the UART of this MCU must be re-opened
+ * at the new baud rate and the AT client moved onto it (see
+ * uAtClientStreamSwitch()) before anything else is sent.  You
+ * probably don't need to call this function yourself: set the
+ * baudRateMax field of the UART configuration passed to
+ * uDeviceOpen() and the device layer will do all of this for you.
+ *
+ * Note that some modules (e.g. the SARA-R4 series) will write the
+ * baud rate to non-volatile memory when powered off with
+ * uCellPwrOff(); set the baud rate back to that the MCU expects at
+ * power-on before powering such a module off.
+ *
+ * @param cellHandle   the handle of the cellular instance.
+ * @param baudRate     the new baud rate, e.g. 921600.
+ * @return             zero on success or negative error code on
+ *                     failure.
+ */
+int32_t uCellCfgSetBaudRate(uDeviceHandle_t cellHandle, int32_t baudRate);
+
 #ifdef __cplusplus
 }
 #endif
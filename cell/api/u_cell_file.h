@@ -48,6 +48,18 @@ extern "C" {
  */
 #define U_CELL_FILE_NAME_MAX_LENGTH 248
 
+#ifndef U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES
+/** The number of bytes that uCellFileReadStream() asks for in each
+ * AT+URDBLOCK command and that uCellFileWriteStream() sends in each
+ * AT+UDWNFILE command; the larger this is the fewer the round trips
+ * and hence the closer a transfer gets to UART speed.  It need not
+ * be related to the size of the buffer passed to those functions,
+ * which only has to be big enough to hold one callback's worth of
+ * data.
+ */
+# define U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES 8192
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -89,6 +101,37 @@ int32_t uCellFileSetTag(uDeviceHandle_t cellHandle, const char *pTag);
  */
 const char *pUCellFileGetTag(uDeviceHandle_t cellHandle);
 
+/** Switch the file cache on or off; off is the default.  When the
+ * file cache is on the names of the files in the area of the file
+ * system currently being addressed (see uCellFileSetTag()) are
+ * remembered the first time they are listed, along with the size of
+ * each file once it has been read with uCellFileSize(), and are kept
+ * up to date by uCellFileWrite(), uCellFileWriteStream() and
+ * uCellFileDelete(); subsequent calls to uCellFileListFirst(),
+ * uCellFileListFirst_r() and uCellFileSize() are then answered from
+ * the cache with no AT traffic.  Changing the tag causes the next
+ * listing to be obtained from the module once more.
+ *
+ * IMPORTANT: files that are written or deleted by other means, e.g.
+ * by the module itself as the result of an HTTP or FOTA operation,
+ * will not be known to the cache: if you do such things you should
+ * call uCellFileCacheInvalidate() afterwards.
+ *
+ * @param cellHandle the handle of the cellular instance.
+ * @param onNotOff   true to switch the file cache on, false to switch
+ *                   it off and free the memory it occupies.
+ * @return           zero on success or negative error code on failure.
+ */
+int32_t uCellFileCacheSet(uDeviceHandle_t cellHandle, bool onNotOff);
+
+/** Empty the file cache, if it is on (see uCellFileCacheSet()), so
+ * that the next listing is obtained from the module.
+ *
+ * @param cellHandle the handle of the cellular instance.
+ * @return           zero on success or negative error code on failure.
+ */
+int32_t uCellFileCacheInvalidate(uDeviceHandle_t cellHandle);
+
 /** Open a file in write mode on the file system and write a stream of
  * bytes to it. If the file already exists, the data will be appended to
  * the file already stored in the file system. In order to avoid
@@ -150,6 +193,103 @@ int32_t uCellFileBlockRead(uDeviceHandle_t cellHandle,
                            size_t offset,
                            size_t dataSize);
 
+/** Read a file from the file system as a stream, from a given offset
+ * to the end of the file, passing the data to a callback as it
+ * arrives.  The file is read in blocks of
+ * #U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES with the AT interface held for
+ * the whole transfer, so there is no gap between the blocks other
+ * than the module's own response time, and each block is passed to
+ * pCallback in pieces of up to bufferSize bytes, hence a small
+ * buffer can be used to move a large file.  As for
+ * uCellFileBlockRead(), tags are NOT supported.  In order to avoid
+ * character loss it is recommended that flow control lines are
+ * connected on the interface to the module.  Note that pCallback is
+ * called with the cellular API locked and so must not call back into
+ * the cellular API.
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param[in] pFileName      a pointer to the name of the file to read.
+ *                           File name cannot contain these characters:
+ *                           / * : % | " < > ?.
+ * @param offset             the offset in bytes from the beginning of
+ *                           the file at which to start reading.
+ * @param[in] pBuffer        a buffer for this function to use while
+ *                           reading; cannot be NULL.
+ * @param bufferSize         the amount of storage at pBuffer, the
+ *                           maximum that will be passed to pCallback in
+ *                           one go; cannot be zero.
+ * @param[in] pCallback      the callback that will be given the data;
+ *                           the parameters are a pointer to the data,
+ *                           the number of bytes of data, the offset of
+ *                           that data from the start of the file, the
+ *                           size of the file and pCallbackParam.  Return
+ *                           true to continue, false to stop reading.
+ *                           Cannot be NULL.
+ * @param[in] pCallbackParam a parameter that will be passed to
+ *                           pCallback as its last parameter.
+ * @return                   on success the number of bytes passed to
+ *                           pCallback, else negative error code.
+ */
+int32_t uCellFileReadStream(uDeviceHandle_t cellHandle,
+                            const char *pFileName,
+                            size_t offset,
+                            char *pBuffer,
+                            size_t bufferSize,
+                            bool (*pCallback) (const char *, size_t,
+                                               size_t, size_t,
+                                               void *),
+                            void *pCallbackParam);
+
+/** Write a file to the file system as a stream, obtaining the data
+ * from a callback.  The data is sent in blocks of
+ * #U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES, each block being an append
+ * to the file (so, as for uCellFileWrite(), if the file already
+ * exists the data will be appended to it), with the AT interface
+ * held for the whole transfer; during each block pCallback is called
+ * to fill pBuffer up to bufferSize bytes at a time and the result is
+ * passed straight to the module.  pCallback must provide all of the
+ * bytes it is asked for: if it does not, the block in progress is
+ * padded out with zeroes, to keep the module happy, and the
+ * transfer is stopped.  In order to avoid character
+ * loss it is recommended that flow control lines are connected on
+ * the interface to the module.  Note that pCallback is called with
+ * the cellular API locked and so must not call back into the
+ * cellular API.
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param[in] pFileName      a pointer to the name of the file to write.
+ *                           File name cannot contain these characters:
+ *                           / * : % | " < > ?.
+ * @param size               the total number of bytes to write.
+ * @param[in] pBuffer        a buffer for this function to use while
+ *                           writing; cannot be NULL.
+ * @param bufferSize         the amount of storage at pBuffer, the
+ *                           maximum that pCallback will be asked for
+ *                           in one go; cannot be zero.
+ * @param[in] pCallback      the callback that provides the data; the
+ *                           parameters are a pointer to where the data
+ *                           should be written, the number of bytes
+ *                           required, the offset of that data from the
+ *                           start of the stream and pCallbackParam.
+ *                           It must return the number of bytes written,
+ *                           anything other than the number requested
+ *                           stopping the transfer.  Cannot be NULL.
+ * @param[in] pCallbackParam a parameter that will be passed to
+ *                           pCallback as its last parameter.
+ * @return                   on success the number of bytes provided
+ *                           by pCallback, which will be less than size
+ *                           if pCallback stopped the transfer, else
+ *                           negative error code.
+ */
+int32_t uCellFileWriteStream(uDeviceHandle_t cellHandle,
+                             const char *pFileName,
+                             size_t size,
+                             char *pBuffer,
+                             size_t bufferSize,
+                             int32_t (*pCallback) (char *, size_t,
+                                                   size_t, void *),
+                             void *pCallbackParam);
+
 /** Read size of file on the file system. If the file does not exists,
  * error will be return.
  *
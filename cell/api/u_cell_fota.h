@@ -33,8 +33,10 @@
  * monitoring FOTA (Firmware Over The Air) of a cellular module.
  * These functions are thread-safe.
  *
- * Note:  this is currently a minimal, monitor-only API; it may be
- * expanded in future.
+ * As well as monitoring module-initiated FOTA, a firmware image
+ * obtained by the host from wherever it likes may be delivered to
+ * the file system of the module with uCellFotaImageDownload() and
+ * installed with uCellFotaImageInstall().
  */
 
 #ifdef __cplusplus
@@ -138,6 +140,36 @@ typedef void (uCellFotaStatusCallback_t) (uDeviceHandle_t cellHandle,
                                           uCellFotaStatus_t *pStatus,
                                           void *pParameter);
 
+/** Function signature of the callback that provides the firmware
+ * image to uCellFotaImageDownload(); it is called between
+ * writes, with the cellular API unlocked, so it may, for instance,
+ * use a cellular socket to fetch the image.
+ *
+ * @param cellHandle          the handle of the cellular instance.
+ * @param[out] pBuffer        the place to put the image data.
+ * @param size                the number of bytes of image data
+ *                            required.
+ * @param offset              the offset of the required data from
+ *                            the start of the image; the callback
+ *                            is called with offset ascending but, on
+ *                            a resumed download, the data before the
+ *                            resume point is asked for once more,
+ *                            in order that it can be hashed.
+ * @param imageSize           the size of the whole image, so that
+ *                            offset / imageSize is the progress.
+ * @param[in] pCallbackParam  the parameter given to
+ *                            uCellFotaImageDownload().
+ * @return                    the number of bytes placed at pBuffer;
+ *                            anything other than size stops the
+ *                            download, leaving it to be resumed.
+ */
+typedef int32_t (uCellFotaImageCallback_t) (uDeviceHandle_t cellHandle,
+                                            char *pBuffer,
+                                            size_t size,
+                                            size_t offset,
+                                            size_t imageSize,
+                                            void *pCallbackParam);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -173,6 +205,68 @@ int32_t uCellFotaSetStatusCallback(uDeviceHandle_t cellHandle,
                                    uCellFotaStatusCallback_t *pCallback,
                                    void *pCallbackParameter);
 
+/** Download a firmware image, provided by a callback, to the file
+ * system of the module, ready for uCellFotaImageInstall().  The
+ * image is written in blocks of bufferSize bytes, each being
+ * obtained from the callback before it is written so that a
+ * callback failure never leaves a partial block behind; since each
+ * block costs a round trip to the module, a bufferSize of
+ * #U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES or more is recommended.
+ * The file is written with whatever file system tag has been set
+ * with uCellFileSetTag(): consult the AT manual of your module for
+ * where it expects a firmware image to be (e.g. the "FOTA" tag).
+ *
+ * If the file already exists, e.g. because a previous download
+ * was interrupted by a callback failure or a power cut, the
+ * download is resumed from the end of the file: the data before
+ * that point is requested from the callback only to be hashed, it
+ * is not written again.  If pSha256 is given the image is checked
+ * against it once complete and, should it not match, the file is
+ * deleted and #U_ERROR_COMMON_AUTHENTICATION_FAILURE is returned,
+ * so that the next attempt starts afresh; this is what catches a
+ * file that was left with a partial block by a power cut.
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param[in] pFileName      the null-terminated name of the file to
+ *                           write the image to; cannot be NULL.
+ * @param imageSize          the size of the image in bytes.
+ * @param[in] pSha256        the #U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES
+ *                           byte SHA256 hash of the image, NULL if the
+ *                           image is not to be checked.
+ * @param[in] pBuffer        a buffer for this function to use; cannot
+ *                           be NULL.
+ * @param bufferSize         the amount of storage at pBuffer; cannot be
+ *                           zero.
+ * @param[in] pCallback      the callback that provides the image;
+ *                           cannot be NULL.
+ * @param[in] pCallbackParam a parameter that will be passed to
+ *                           pCallback as its last parameter.
+ * @return                   zero when the whole image is in the file
+ *                           system of the module (and has been
+ *                           checked, if pSha256 was given) else
+ *                           negative error code.
+ */
+int32_t uCellFotaImageDownload(uDeviceHandle_t cellHandle,
+                               const char *pFileName,
+                               size_t imageSize,
+                               const char *pSha256,
+                               char *pBuffer, size_t bufferSize,
+                               uCellFotaImageCallback_t *pCallback,
+                               void *pCallbackParam);
+
+/** Install a firmware image that has been written to the file
+ * system of the module with uCellFotaImageDownload().  The module
+ * will reboot in order to perform the installation, which can take
+ * several minutes, and will not respond to AT commands while it
+ * does so; if uCellFotaSetStatusCallback() has been called the
+ * progress of the installation will be reported to the callback.
+ *
+ * @param cellHandle the handle of the cellular instance.
+ * @return           zero if the installation has been started,
+ *                   else negative error code.
+ */
+int32_t uCellFotaImageInstall(uDeviceHandle_t cellHandle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,6 +55,19 @@ extern "C" {
                                              (num) == 3 ? U_CELL_GPIO_3 : (num) == 4 ? U_CELL_GPIO_4 : \
                                              (num) == 5 ? U_CELL_GPIO_5 : (num) == 6 ? U_CELL_GPIO_6 : U_CELL_GPIO_UNKNOWN)
 
+/** Macro helper: the bit that represents "GPIOx", where x is the
+ * integer on the end of the pin name (NOT the GPIO ID), in the masks
+ * passed to uCellGpioSetMask() and uCellGpioGetMask(); e.g.
+ * U_CELL_GPIO_NUMBER_TO_MASK(1) | U_CELL_GPIO_NUMBER_TO_MASK(3)
+ * represents "GPIO1" and "GPIO3".
+ */
+#define U_CELL_GPIO_NUMBER_TO_MASK(num) (1UL << ((num) - 1))
+
+/** A mask with all of the GPIOs that can be represented in a mask
+ * set, i.e. "GPIO1" to "GPIO6".
+ */
+#define U_CELL_GPIO_MASK_ALL 0x3fUL
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -153,6 +166,54 @@ int32_t uCellGpioSet(uDeviceHandle_t cellHandle, uCellGpioName_t gpioId,
  */
 int32_t uCellGpioGet(uDeviceHandle_t cellHandle, uCellGpioName_t gpioId);
 
+/** Set the state of several GPIOs of a cellular module at once,
+ * where the GPIOs are given as a mask of "GPIOx" pin names, see
+ * U_CELL_GPIO_NUMBER_TO_MASK(), and have already been configured
+ * as outputs with uCellGpioConfig().  The AT commands are
+ * concatenated onto as few command lines as possible, see
+ * uAtClientBatch(), costing a single AT round trip in most cases.
+ * The output level of each GPIO, as set by this function,
+ * uCellGpioSet() or uCellGpioConfig(), is cached and a GPIO that is
+ * already known to be at the requested level is not written again;
+ * the cache is cleared when the module is powered off or rebooted.
+ * Hence, if the level of a GPIO might be changed by other means
+ * (e.g. by sending AT commands directly), use uCellGpioSet() for
+ * that GPIO afterwards, which always writes to the module.
+ *
+ * @param cellHandle    the handle of the cellular instance.
+ * @param gpioMask      the GPIOs to set, a bit-map of
+ *                      U_CELL_GPIO_NUMBER_TO_MASK() values; bits
+ *                      outside #U_CELL_GPIO_MASK_ALL must be zero.
+ * @param levelMask     the levels to set the GPIOs in gpioMask to,
+ *                      a bit set to 1 for high, 0 for low, in the same
+ *                      positions as in gpioMask; bits not in gpioMask
+ *                      are ignored.
+ * @return              on success the number of GPIOs that had to be
+ *                      written (i.e. zero if every GPIO was already
+ *                      known to be at the requested level), else
+ *                      negative error code.
+ */
+int32_t uCellGpioSetMask(uDeviceHandle_t cellHandle, uint32_t gpioMask,
+                         uint32_t levelMask);
+
+/** Get the state of several GPIOs of a cellular module at once,
+ * where the GPIOs are given as a mask of "GPIOx" pin names, see
+ * U_CELL_GPIO_NUMBER_TO_MASK().  The AT commands are concatenated
+ * onto as few command lines as possible, see uAtClientBatch().  The
+ * level is always read from the module, the cache used by
+ * uCellGpioSetMask() is not consulted.
+ *
+ * @param cellHandle    the handle of the cellular instance.
+ * @param gpioMask      the GPIOs to get the state of, a bit-map of
+ *                      U_CELL_GPIO_NUMBER_TO_MASK() values; bits
+ *                      outside #U_CELL_GPIO_MASK_ALL must be zero.
+ * @return              on success a bit-map of the levels of the
+ *                      GPIOs in gpioMask, a bit being 1 for high,
+ *                      in the same positions as in gpioMask, else
+ *                      negative error code.
+ */
+int32_t uCellGpioGetMask(uDeviceHandle_t cellHandle, uint32_t gpioMask);
+
 /** Set the state of the CTS line: this may be used if the
  * serial handshaking lines are NOT being used (they were both
  * -1 in the #uNetworkCfgCell_t structure or the
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_CELL_HTTP_H_
+#define _U_CELL_HTTP_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+
+/** \addtogroup _cell
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the u-blox API for the HTTP client
+ * that is built into the cellular module.  The module makes the
+ * HTTP request itself and writes the response, headers and all, to
+ * a file in its file system, so that a large download costs nothing
+ * on the AT interface until it is read, which can then be done with
+ * the pipelined uCellFileReadStream(), as uCellHttpGetStream() does.
+ * These functions are thread-safe.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The number of HTTP profiles, i.e. HTTP instances, that a
+ * cellular module supports.
+ */
+#define U_CELL_HTTP_PROFILE_MAX_NUM 4
+
+#ifndef U_CELL_HTTP_TIMEOUT_SECONDS
+/** The time that uCellHttpGetStream() waits for an HTTP request to
+ * complete where the timeout given to uCellHttpOpen() is zero.
+ */
+# define U_CELL_HTTP_TIMEOUT_SECONDS 60
+#endif
+
+#ifndef U_CELL_HTTP_FILE_NAME_RESPONSE_DEFAULT
+/** The name of the file that uCellHttpGetStream() asks the module
+ * to write the response to; the file is deleted afterwards.
+ */
+# define U_CELL_HTTP_FILE_NAME_RESPONSE_DEFAULT "ubxlib_http_response"
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The HTTP request types; the values match those of AT+UHTTPC.
+ */
+typedef enum {
+    U_CELL_HTTP_REQUEST_HEAD = 0,
+    U_CELL_HTTP_REQUEST_GET = 1,
+    U_CELL_HTTP_REQUEST_DELETE = 2,
+    U_CELL_HTTP_REQUEST_PUT = 3,      /**< the content is a file. */
+    U_CELL_HTTP_REQUEST_POST = 4,     /**< the content is a file. */
+    U_CELL_HTTP_REQUEST_MAX_NUM
+} uCellHttpRequest_t;
+
+/** The callback called when an HTTP request has completed.
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param httpHandle         the handle of the HTTP instance, as
+ *                           returned by uCellHttpOpen().
+ * @param requestType        the type of request that completed.
+ * @param success            true if the request was successful,
+ *                           in which case the response is in the
+ *                           file given to uCellHttpRequest(); the
+ *                           HTTP status code is in the response.
+ * @param pCallbackParameter the parameter given to uCellHttpOpen().
+ */
+typedef void (*uCellHttpCallback_t)(uDeviceHandle_t cellHandle,
+                                    int32_t httpHandle,
+                                    uCellHttpRequest_t requestType,
+                                    bool success,
+                                    void *pCallbackParameter);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Open an HTTP instance, configuring an HTTP profile of the module
+ * for a given server.  The module must be connected to the network
+ * before a request can be made.
+ *
+ * @param cellHandle             the handle of the cellular instance.
+ * @param[in] pServerName        the null-terminated name of the
+ *                               server, a domain name or an IP
+ *                               address, optionally followed by
+ *                               ":" and a port number, e.g.
+ *                               "www.u-blox.com:80"; no "http://".
+ * @param[in] pUserName          the null-terminated user name for
+ *                               basic authentication, NULL for none.
+ * @param[in] pPassword          the null-terminated password for
+ *                               basic authentication, NULL for none;
+ *                               ignored if pUserName is NULL.
+ * @param securityProfileId      the security profile of the module
+ *                               to use for HTTPS, as configured with
+ *                               uCellSecTlsAdd(), -1 for HTTP.
+ * @param timeoutSeconds         the time the module should wait for
+ *                               a response from the server, 0 for
+ *                               the module default.
+ * @param[in] pCallback          the callback to be called when a
+ *                               request made with uCellHttpRequest()
+ *                               completes; may be NULL.
+ * @param[in] pCallbackParameter a parameter to pass to pCallback;
+ *                               may be NULL.
+ * @return                       on success the handle of the HTTP
+ *                               instance, else negative error code.
+ */
+int32_t uCellHttpOpen(uDeviceHandle_t cellHandle, const char *pServerName,
+                      const char *pUserName, const char *pPassword,
+                      int32_t securityProfileId, int32_t timeoutSeconds,
+                      uCellHttpCallback_t pCallback,
+                      void *pCallbackParameter);
+
+/** Close an HTTP instance, resetting the HTTP profile of the module.
+ *
+ * @param cellHandle the handle of the cellular instance.
+ * @param httpHandle the handle of the HTTP instance.
+ */
+void uCellHttpClose(uDeviceHandle_t cellHandle, int32_t httpHandle);
+
+/** Make an HTTP request; the module writes the response, including
+ * the HTTP headers, to a file in its file system and the callback
+ * given to uCellHttpOpen() is called when it has done so.  Only one
+ * request may be outstanding on an HTTP instance at a time.  The
+ * file cache, see uCellFileCacheSet(), is invalidated when a
+ * request completes.
+ *
+ * @param cellHandle            the handle of the cellular instance.
+ * @param httpHandle            the handle of the HTTP instance.
+ * @param requestType           the request type.
+ * @param[in] pPath             the null-terminated path on the
+ *                              server, e.g. "/index.html".
+ * @param[in] pFileNameResponse the null-terminated name of the file
+ *                              that the response should be written
+ *                              to, which is overwritten if it exists.
+ * @param[in] pFileNameContent  for #U_CELL_HTTP_REQUEST_PUT and
+ *                              #U_CELL_HTTP_REQUEST_POST the
+ *                              null-terminated name of the file in
+ *                              the file system of the module that
+ *                              contains the content to send, else
+ *                              ignored.
+ * @param[in] pContentType      for #U_CELL_HTTP_REQUEST_PUT and
+ *                              #U_CELL_HTTP_REQUEST_POST the
+ *                              null-terminated MIME type of the
+ *                              content, e.g. "application/json",
+ *                              else ignored.
+ * @return                      zero if the request has been
+ *                              started, else negative error code;
+ *                              in particular
+ *                              #U_ERROR_COMMON_TEMPORARY_FAILURE
+ *                              if a request is already outstanding.
+ */
+int32_t uCellHttpRequest(uDeviceHandle_t cellHandle, int32_t httpHandle,
+                         uCellHttpRequest_t requestType,
+                         const char *pPath, const char *pFileNameResponse,
+                         const char *pFileNameContent,
+                         const char *pContentType);
+
+/** Get the outcome of the last request made on an HTTP instance,
+ * for those who would rather poll than have a callback.
+ *
+ * @param cellHandle the handle of the cellular instance.
+ * @param httpHandle the handle of the HTTP instance.
+ * @return           zero if the last request was successful, a
+ *                   positive value if it has not yet completed, else
+ *                   negative error code, e.g.
+ *                   #U_ERROR_COMMON_DEVICE_ERROR if the request failed
+ *                   or #U_ERROR_COMMON_NOT_FOUND if no request has
+ *                   been made.
+ */
+int32_t uCellHttpRequestStatus(uDeviceHandle_t cellHandle,
+                               int32_t httpHandle);
+
+/** Get the error reported by the module for the last request that
+ * failed on an HTTP instance, as returned by AT+UHTTPER; see the AT
+ * manual of the module for the meanings.
+ *
+ * @param cellHandle      the handle of the cellular instance.
+ * @param httpHandle      the handle of the HTTP instance.
+ * @param[out] pErrorCode a place to put the error code, the error
+ *                        class being the return value; may be NULL.
+ * @return                the error class, zero if there was no
+ *                        error, else negative error code.
+ */
+int32_t uCellHttpGetLastError(uDeviceHandle_t cellHandle,
+                              int32_t httpHandle,
+                              int32_t *pErrorCode);
+
+/** Perform an HTTP GET and stream the body of the response to a
+ * callback: the module downloads the response to
+ * #U_CELL_HTTP_FILE_NAME_RESPONSE_DEFAULT, this function waits
+ * for the download to complete and then reads the file back with
+ * uCellFileReadStream(), skipping the HTTP headers, and deletes it.
+ * The callback given to uCellHttpOpen() is not called for this
+ * request.  Not to be called from the callback given to
+ * uCellHttpOpen().
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param httpHandle         the handle of the HTTP instance.
+ * @param[in] pPath          the null-terminated path on the server.
+ * @param[in] pBuffer        a buffer for this function to use while
+ *                           reading; cannot be NULL.
+ * @param bufferSize         the amount of storage at pBuffer, the
+ *                           maximum that will be passed to pCallback
+ *                           in one go; cannot be zero.
+ * @param[in] pCallback      the callback that will be given the body;
+ *                           the parameters are a pointer to the data,
+ *                           the number of bytes of data, the offset
+ *                           of that data from the start of the body
+ *                           and pCallbackParam.  Return true to
+ *                           continue, false to stop.  Called with the
+ *                           cellular API locked and so must not call
+ *                           back into the cellular API.
+ * @param[in] pCallbackParam a parameter to pass to pCallback.
+ * @return                   on success the HTTP status code, e.g.
+ *                           200, else negative error code.
+ */
+int32_t uCellHttpGetStream(uDeviceHandle_t cellHandle, int32_t httpHandle,
+                           const char *pPath, char *pBuffer,
+                           size_t bufferSize,
+                           bool (*pCallback) (const char *, size_t,
+                                              size_t, void *),
+                           void *pCallbackParam);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_CELL_HTTP_H_
+
+// End of file
@@ -58,10 +58,95 @@ extern "C" {
  */
 #define U_CELL_INFO_ICCID_BUFFER_SIZE 21
 
+#ifndef U_CELL_INFO_TIME_BASE_RESYNC_PERIOD_SECONDS
+/** The default period at which the cached time base started by
+ * uCellInfoTimeBaseStart() is resynchronised with the module.
+ */
+# define U_CELL_INFO_TIME_BASE_RESYNC_PERIOD_SECONDS 3600
+#endif
+
+/** The maximum resync period that may be passed to
+ * uCellInfoTimeBaseStart(), well within the wrap of
+ * uPortGetTickTimeMs().
+ */
+#define U_CELL_INFO_TIME_BASE_RESYNC_PERIOD_MAX_SECONDS (3600 * 24)
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A timestamped sample of the radio parameters, as stored by the
+ * sampler started with uCellInfoSamplerStart().  The values are
+ * as would be returned by the uCellInfoGetXxx() function of the
+ * same name at the time the sample was taken, including the
+ * "not known" values.
+ */
+typedef struct {
+    int32_t timeMs;    /**< the value of uPortGetTickTimeMs() when the
+                            sample was taken. */
+    int32_t rssiDbm;   /**< the RSSI in dBm, zero if not known. */
+    int32_t rsrpDbm;   /**< the RSRP in dBm, zero if not known. */
+    int32_t rsrqDb;    /**< the RSRQ in dB, 0x7FFFFFFF if not known. */
+    int32_t rxQual;    /**< the RxQual, negative if not known. */
+    int32_t cellId;    /**< the cell ID, negative if not known. */
+    int32_t earfcn;    /**< the EARFCN, negative if not known. */
+    int32_t snrDb;     /**< the SNR in dB, INT_MAX if the RSRP was
+                            equal to the RSSI; only valid if
+                            snrDbIsValid is true. */
+    bool snrDbIsValid; /**< true if snrDb is valid. */
+} uCellInfoSample_t;
+
+/** Statistics for one radio parameter over a window of samples.
+ */
+typedef struct {
+    size_t numSamples; /**< the number of samples in the window
+                            for which the parameter was known. */
+    int32_t min;       /**< the minimum value, zero if numSamples is zero. */
+    int32_t max;       /**< the maximum value, zero if numSamples is zero. */
+    int32_t mean;      /**< the mean value, zero if numSamples is zero. */
+} uCellInfoSampleStats_t;
+
+/** A summary of the samples stored by the sampler started with
+ * uCellInfoSamplerStart(), as returned by
+ * uCellInfoSamplerGetSummary().
+ */
+typedef struct {
+    uCellInfoSampleStats_t rssiDbm; /**< RSSI statistics in dBm. */
+    uCellInfoSampleStats_t rsrpDbm; /**< RSRP statistics in dBm. */
+    uCellInfoSampleStats_t rsrqDb;  /**< RSRQ statistics in dB. */
+    uCellInfoSampleStats_t snrDb;   /**< SNR statistics in dB, an
+                                         infinite SNR is not included. */
+} uCellInfoSampleSummary_t;
+
+/** Statistics for the cached time base started with
+ * uCellInfoTimeBaseStart(), as returned by
+ * uCellInfoTimeBaseGetStats().  Since the time from the module
+ * has a resolution of one second, each error measured at a resync
+ * is uncertain by up to half a second; the drift figures are only
+ * meaningful over resync periods of many minutes.
+ */
+typedef struct {
+    int32_t numSyncs;      /**< the number of times the time base has
+                                been synchronised with the module,
+                                including from +CTZE. */
+    int32_t numUrcSyncs;   /**< of numSyncs, the number that were
+                                from the network, via +CTZE. */
+    int32_t lastSyncAgeMs; /**< the number of milliseconds since the
+                                last synchronisation, negative if
+                                there has been none. */
+    int32_t lastErrorMs;   /**< the difference between the time from
+                                the module and that predicted by the
+                                time base at the last resync, positive
+                                if the module was ahead. */
+    int32_t maxAbsErrorMs; /**< the largest magnitude of lastErrorMs
+                                seen. */
+    int32_t lastDriftPpm;  /**< lastErrorMs as parts per million of the
+                                time since the previous
+                                synchronisation, i.e. how fast
+                                uPortGetTickTimeMs() runs relative to
+                                network time, positive if slow. */
+} uCellInfoTimeBaseStats_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -167,7 +252,9 @@ int32_t uCellInfoGetCellId(uDeviceHandle_t cellHandle);
  */
 int32_t uCellInfoGetEarfcn(uDeviceHandle_t cellHandle);
 
-/** Get the IMEI of the cellular module.
+/** Get the IMEI of the cellular module.  The IMEI is read from
+ * the module once and then cached until the module is powered off
+ * or rebooted.
  *
  * @param cellHandle  the handle of the cellular instance.
  * @param[out] pImei  a pointer to #U_CELL_INFO_IMEI_SIZE bytes
@@ -199,7 +286,8 @@ int32_t uCellInfoGetImsi(uDeviceHandle_t cellHandle,
  * that, while the ICCID is all numeric digits, like the IMEI and
  * the IMSI, the length of the ICCID can vary between 19 and 20
  * digits; it is treated as a string here because of that variable
- * length.
+ * length.  The ICCID is read once and then cached until the module
+ * is powered off or rebooted or the SIM is deactivated (AT+CFUN=0).
  *
  * @param cellHandle  the handle of the cellular instance.
  * @param[out] pStr   a pointer to size bytes of storage into which
@@ -238,6 +326,8 @@ int32_t uCellInfoGetManufacturerStr(uDeviceHandle_t cellHandle,
                                     char *pStr, size_t size);
 
 /** Get the model identification string from the cellular module.
+ * The string is read from the module once and then cached until the
+ * module is powered off or rebooted.
  *
  * @param cellHandle  the handle of the cellular instance.
  * @param[out] pStr   a pointer to size bytes of storage into which
@@ -256,6 +346,8 @@ int32_t uCellInfoGetModelStr(uDeviceHandle_t cellHandle,
                              char *pStr, size_t size);
 
 /** Get the firmware version string from the cellular module.
+ * The string is read from the module once and then cached until the
+ * module is powered off or rebooted.
  *
  * @param cellHandle  the handle of the cellular instance.
  * @param[out] pStr   a pointer to size bytes of storage into which
@@ -276,6 +368,9 @@ int32_t uCellInfoGetFirmwareVersionStr(uDeviceHandle_t cellHandle,
 /** Get the UTC time according to cellular.  This feature requires
  * a connection to have been activated and support for this feature
  * is optional in the cellular network.
+ * If the cached time base has been started, see
+ * uCellInfoTimeBaseStart(), the time will usually be computed
+ * locally, without any AT traffic.
  *
  * @param cellHandle  the handle of the cellular instance.
  * @return            on success the Unix UTC time, else negative
@@ -303,6 +398,55 @@ int64_t uCellInfoGetTimeUtc(uDeviceHandle_t cellHandle);
 int32_t uCellInfoGetTimeUtcStr(uDeviceHandle_t cellHandle,
                                char *pStr, size_t size);
 
+/** Start a cached time base, so that uCellInfoGetTimeUtc() can
+ * avoid an AT+CCLK? round trip on every call.  Once the time has
+ * been read from the module, uCellInfoGetTimeUtc() returns a time
+ * computed from uPortGetTickTimeMs() since then.  The cached time is
+ * read again from the module every resyncPeriodSeconds, and
+ * whenever the network indicates new time (with the +CTZE URC,
+ * which this function switches on with AT+CTZR=2); the +CTZE time,
+ * where present, is used directly.  If a resync fails the time
+ * from the cached time base is still returned.  Calling this
+ * function again changes the resync period and resyncs.
+ *
+ * As for uCellInfoGetTimeUtc(), the network must be able to
+ * provide the time, so the first sync may not succeed until the
+ * module is registered; this is not an error, the time base will
+ * sync on the next call to uCellInfoGetTimeUtc().
+ *
+ * @param cellHandle           the handle of the cellular instance.
+ * @param resyncPeriodSeconds  the resync period; use zero or a
+ *                             negative value for
+ *                             #U_CELL_INFO_TIME_BASE_RESYNC_PERIOD_SECONDS.
+ *                             It cannot be more than
+ *                             #U_CELL_INFO_TIME_BASE_RESYNC_PERIOD_MAX_SECONDS.
+ * @return                     zero on success else negative error
+ *                             code.
+ */
+int32_t uCellInfoTimeBaseStart(uDeviceHandle_t cellHandle,
+                               int32_t resyncPeriodSeconds);
+
+/** Stop the cached time base started by uCellInfoTimeBaseStart(),
+ * putting the AT+CTZR setting of the module back the way it was;
+ * uCellInfoGetTimeUtc() will read the time from the module on every
+ * call once more.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ */
+void uCellInfoTimeBaseStop(uDeviceHandle_t cellHandle);
+
+/** Get the statistics of the cached time base started by
+ * uCellInfoTimeBaseStart().
+ *
+ * @param cellHandle   the handle of the cellular instance.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ * @return             zero on success else negative error code;
+ *                     #U_ERROR_COMMON_NOT_FOUND is returned if the
+ *                     cached time base has not been started.
+ */
+int32_t uCellInfoTimeBaseGetStats(uDeviceHandle_t cellHandle,
+                                  uCellInfoTimeBaseStats_t *pStats);
+
 /** Determine if RTS flow control, the signal from the
  * cellular module to this software that the module is
  * ready to receive data, is enabled.
@@ -323,6 +467,83 @@ bool uCellInfoIsRtsFlowControlEnabled(uDeviceHandle_t cellHandle);
  */
 bool uCellInfoIsCtsFlowControlEnabled(uDeviceHandle_t cellHandle);
 
+/** Start a sampler which calls uCellInfoRefreshRadioParameters()
+ * in the background every periodMs and stores the results, with
+ * a timestamp, in a ring of historyLength samples; the samples
+ * may then be read with uCellInfoSamplerGetHistory() and
+ * uCellInfoSamplerGetSummary() without any AT traffic.  A sample
+ * is not taken if the module is not registered, if it is in
+ * deep sleep (3GPP power saving), if the cellular API remains
+ * busy for a second or if another sample has been taken within
+ * the last half a period; any call the application makes to
+ * uCellInfoRefreshRadioParameters() while the sampler is running
+ * also adds a sample to the ring.  The radio parameters returned
+ * by uCellInfoGetRssiDbm() etc. are those of the latest sample.
+ *
+ * If the sampler is already running it is restarted, emptying the
+ * ring.  The sampler requires the timer API of the port layer.
+ * Note that the sampler runs in its own task (see
+ * U_CELL_INFO_SAMPLER_TASK_STACK_SIZE_BYTES in u_cell_info.c),
+ * the memory for which is only released when the sampler is
+ * stopped, which will happen automatically when the cellular
+ * instance is removed.
+ *
+ * @param cellHandle    the handle of the cellular instance.
+ * @param periodMs      the sampling period in milliseconds, must
+ *                      be greater than zero; a refresh may take
+ *                      a second or so and so a period below
+ *                      a few seconds is not recommended.
+ * @param historyLength the number of samples to store, must be
+ *                      greater than zero; memory of around
+ *                      30 bytes per sample is allocated.
+ * @return              zero on success else negative error code.
+ */
+int32_t uCellInfoSamplerStart(uDeviceHandle_t cellHandle,
+                              int32_t periodMs, size_t historyLength);
+
+/** Stop the sampler started with uCellInfoSamplerStart() and free
+ * its memory; the stored samples are lost.
+ *
+ * @param cellHandle the handle of the cellular instance.
+ */
+void uCellInfoSamplerStop(uDeviceHandle_t cellHandle);
+
+/** Get the most recent samples stored by the sampler started with
+ * uCellInfoSamplerStart(); this does not cause any AT traffic.
+ *
+ * @param cellHandle     the handle of the cellular instance.
+ * @param[out] pSamples  a place to put the samples, newest first;
+ *                       may only be NULL if numSamples is zero.
+ * @param numSamples     the number of uCellInfoSample_t at pSamples.
+ * @return               the number of samples written to pSamples,
+ *                       which may be zero, else negative error
+ *                       code; #U_ERROR_COMMON_NOT_INITIALISED is
+ *                       returned if the sampler is not running.
+ */
+int32_t uCellInfoSamplerGetHistory(uDeviceHandle_t cellHandle,
+                                   uCellInfoSample_t *pSamples,
+                                   size_t numSamples);
+
+/** Get the minimum, maximum and mean of the RSSI, RSRP, RSRQ and
+ * SNR over the samples, stored by the sampler started with
+ * uCellInfoSamplerStart(), that were taken within the given
+ * window; this does not cause any AT traffic.  Values that
+ * were not known for a given sample are left out.
+ *
+ * @param cellHandle     the handle of the cellular instance.
+ * @param windowMs       the window, going back from now, in
+ *                       milliseconds; use zero or a negative value
+ *                       for all of the stored samples.
+ * @param[out] pSummary  a place to put the summary; cannot be NULL.
+ * @return               the number of samples in the window, which
+ *                       may be zero, else negative error code;
+ *                       #U_ERROR_COMMON_NOT_INITIALISED is returned
+ *                       if the sampler is not running.
+ */
+int32_t uCellInfoSamplerGetSummary(uDeviceHandle_t cellHandle,
+                                   int32_t windowMs,
+                                   uCellInfoSampleSummary_t *pSummary);
+
 #ifdef __cplusplus
 }
 #endif
@@ -657,6 +657,60 @@ int32_t uCellMqttSubscribe(uDeviceHandle_t cellHandle,
 int32_t uCellMqttUnsubscribe(uDeviceHandle_t cellHandle,
                              const char *pTopicFilterStr);
 
+/** Subscribe to several MQTT topics at once.  The module only
+ * allows one topic filter per AT command, and hence per MQTT
+ * SUBSCRIBE packet, so the commands are sent back to back and the
+ * outcomes, which the module reports in URCs, collected afterwards;
+ * this takes little more than the time of a single subscription
+ * rather than the sum of them.  The pKeepGoingCallback() function
+ * set during initialisation will be called while waiting.
+ *
+ * @param cellHandle            the handle of the cellular instance
+ *                              to be used.
+ * @param[in] ppTopicFilterStr  an array of numTopics pointers to
+ *                              null-terminated topic filter strings,
+ *                              as for uCellMqttSubscribe(); cannot
+ *                              be NULL.
+ * @param[in] pMaxQos           an array of numTopics maximum QoS
+ *                              values, one for each topic filter;
+ *                              cannot be NULL.
+ * @param numTopics             the number of topic filters.
+ * @param[out] pQos             an array of numTopics places to put the
+ *                              outcome for each topic filter, the QoS of
+ *                              the subscription or negative error code;
+ *                              cannot be NULL.
+ * @return                      zero if all of the subscriptions succeeded,
+ *                              else the first negative error code in pQos
+ *                              or some other negative error code.
+ */
+int32_t uCellMqttSubscribeMulti(uDeviceHandle_t cellHandle,
+                                const char *const *ppTopicFilterStr,
+                                const uCellMqttQos_t *pMaxQos,
+                                size_t numTopics, int32_t *pQos);
+
+/** Unsubscribe from several MQTT topics at once, pipelined in the
+ * same way as uCellMqttSubscribeMulti().
+ *
+ * @param cellHandle            the handle of the cellular instance
+ *                              to be used.
+ * @param[in] ppTopicFilterStr  an array of numTopics pointers to
+ *                              null-terminated topic filter strings,
+ *                              as for uCellMqttUnsubscribe(); cannot
+ *                              be NULL.
+ * @param numTopics             the number of topic filters.
+ * @param[out] pResults         an array of numTopics places to put the
+ *                              outcome for each topic filter, zero on
+ *                              success else negative error code; cannot
+ *                              be NULL.
+ * @return                      zero if all of the unsubscriptions
+ *                              succeeded, else the first negative error
+ *                              code in pResults or some other negative
+ *                              error code.
+ */
+int32_t uCellMqttUnsubscribeMulti(uDeviceHandle_t cellHandle,
+                                  const char *const *ppTopicFilterStr,
+                                  size_t numTopics, int32_t *pResults);
+
 /** Read an MQTT message.
  *
  * @param cellHandle                 the handle of the cellular instance to
@@ -683,6 +737,58 @@ int32_t uCellMqttMessageRead(uDeviceHandle_t cellHandle, char *pTopicNameStr,
                              char *pMessage, size_t *pMessageSizeBytes,
                              uCellMqttQos_t *pQos);
 
+/** Read an MQTT message in chunks, for messages too large to fit
+ * in one buffer.  The message is read from the module into
+ * pChunkBuffer, at most chunkSizeBytes at a time, and each chunk
+ * is passed to pCallback as it arrives, so the memory required is
+ * bounded by chunkSizeBytes rather than by the size of the message.
+ * This is not supported by those SARA-R4 modules with the old-style
+ * MQTT AT interface, where the message arrives in a URC.
+ *
+ * IMPORTANT: pCallback is called with the AT interface locked;
+ * it must not call into this or any other cellular API.
+ *
+ * @param cellHandle                 the handle of the cellular instance to
+ *                                   be used.
+ * @param[out] pTopicNameStr         a place to put the null-terminated
+ *                                   topic string of the message; cannot
+ *                                   be NULL.
+ * @param topicNameSizeBytes         the number of bytes of storage
+ *                                   at pTopicNameStr.
+ * @param[in] pChunkBuffer           storage for one chunk of the message;
+ *                                   cannot be NULL.
+ * @param chunkSizeBytes             the number of bytes of storage at
+ *                                   pChunkBuffer; must be greater than
+ *                                   zero.
+ * @param[in] pCallback              the function that will be called
+ *                                   with each chunk; cannot be NULL.
+ *                                   The parameters are a pointer to the
+ *                                   chunk (pChunkBuffer), the length of
+ *                                   the chunk, the offset of the chunk
+ *                                   from the start of the message, the
+ *                                   total length of the message and
+ *                                   pCallbackParam.  If the callback
+ *                                   returns false the rest of the message
+ *                                   is discarded.
+ * @param[in] pCallbackParam         a parameter that will be passed to
+ *                                   pCallback; may be NULL.
+ * @param[out] pQos                  a place to put the QoS of the message;
+ *                                   may be NULL.
+ * @return                           on success the number of bytes of
+ *                                   message passed to pCallback, else
+ *                                   negative error code.
+ */
+int32_t uCellMqttMessageReadChunked(uDeviceHandle_t cellHandle,
+                                    char *pTopicNameStr,
+                                    size_t topicNameSizeBytes,
+                                    char *pChunkBuffer,
+                                    size_t chunkSizeBytes,
+                                    bool (*pCallback) (const char *, size_t,
+                                                       size_t, size_t,
+                                                       void *),
+                                    void *pCallbackParam,
+                                    uCellMqttQos_t *pQos);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MQTT-SN ONLY
  * -------------------------------------------------------------- */
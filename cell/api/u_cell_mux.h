@@ -0,0 +1,144 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_CELL_MUX_H_
+#define _U_CELL_MUX_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+
+/** \addtogroup _cell
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the u-blox API for running a
+ * cellular module in 3GPP 27.010 multiplexer (CMUX) mode, so that
+ * AT commands, socket data and, for instance, a GNSS tunnel can
+ * share the single UART to the module in parallel.  Once
+ * multiplexer mode is enabled the AT client of the cellular
+ * instance carries on exactly as before, URC handlers and all,
+ * but over a CMUX channel rather than directly over the UART.
+ * These functions are thread-safe.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_CELL_MUX_CHANNEL_ID_AT
+/** The CMUX channel on which the AT client of the cellular
+ * instance is run once multiplexer mode is enabled.
+ */
+# define U_CELL_MUX_CHANNEL_ID_AT 1
+#endif
+
+#ifndef U_CELL_MUX_CHANNEL_ID_GNSS
+/** The CMUX channel that SARA-R5 uses for GNSS tunnelling,
+ * i.e. direct access to a GNSS chip attached to the cellular
+ * module; see uCellMuxChannelOpen().
+ */
+# define U_CELL_MUX_CHANNEL_ID_GNSS 4
+#endif
+
+#ifndef U_CELL_MUX_FRAME_INFORMATION_MAX_LENGTH_BYTES
+/** The maximum length of the information field of a CMUX frame
+ * (N1) that is requested of the module with AT+CMUX; 127 is the
+ * 27.010 default.
+ */
+# define U_CELL_MUX_FRAME_INFORMATION_MAX_LENGTH_BYTES 127
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Put the cellular module into multiplexer mode, basic option,
+ * and move the AT client of the cellular instance onto CMUX
+ * channel #U_CELL_MUX_CHANNEL_ID_AT.  The AT client must be
+ * talking to the module over a UART and UART power saving
+ * should not be in use.  If multiplexer mode is already enabled
+ * this function does nothing and returns success.
+ *
+ * Multiplexer mode should be disabled with uCellMuxDisable()
+ * before the module is powered off; if the module is powered off,
+ * or reboots, while in multiplexer mode, uCellMuxDisable() must
+ * still be called to return the AT client to the UART.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @return            zero on success else negative error code;
+ *                    on failure the AT client is returned to
+ *                    the UART.
+ */
+int32_t uCellMuxEnable(uDeviceHandle_t cellHandle);
+
+/** Determine whether multiplexer mode is enabled.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @return            true if multiplexer mode is enabled,
+ *                    else false.
+ */
+bool uCellMuxIsEnabled(uDeviceHandle_t cellHandle);
+
+/** Open an additional CMUX channel to the cellular module,
+ * e.g. #U_CELL_MUX_CHANNEL_ID_GNSS.  The returned handle may be
+ * used with uCmuxChannelRead(), uCmuxChannelWrite(),
+ * uCmuxChannelEventCallbackSet() etc. or given to uAtClientAdd()
+ * with #U_AT_CLIENT_STREAM_TYPE_CMUX to run a second AT client.
+ * The channel may be closed with uCmuxChannelClose(); it is
+ * closed anyway by uCellMuxDisable().
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @param channel     the channel to open; what each channel
+ *                    is for is defined by the module, see the
+ *                    AT commands manual.
+ * @return            the handle of the CMUX channel on success,
+ *                    else negative error code.
+ */
+int32_t uCellMuxChannelOpen(uDeviceHandle_t cellHandle, uint8_t channel);
+
+/** Take the cellular module out of multiplexer mode and return
+ * the AT client of the cellular instance to the UART.  Any
+ * additional channels opened with uCellMuxChannelOpen() are
+ * closed: anything using them must have stopped doing so
+ * before this is called.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @return            zero on success else negative error code.
+ */
+int32_t uCellMuxDisable(uDeviceHandle_t cellHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_CELL_MUX_H_
+
+// End of file
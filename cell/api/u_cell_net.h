@@ -96,6 +96,18 @@ extern "C" {
 # define U_CELL_NET_CONNECT_TIMEOUT_SECONDS (60 * 30)
 #endif
 
+#ifndef U_CELL_NET_WARM_START_TIMEOUT_SECONDS
+/** The time in seconds allowed for a warm start connection attempt,
+ * see uCellNetConnectWarm(), to complete before it gives up and
+ * falls back to a normal connection attempt.
+ */
+# define U_CELL_NET_WARM_START_TIMEOUT_SECONDS 60
+#endif
+
+/** The value of the magic field of a valid #uCellNetWarmStart_t.
+ */
+#define U_CELL_NET_WARM_START_MAGIC 0x57524d31
+
 #ifndef U_CELL_NET_UPSD_CONTEXT_ACTIVATION_TIME_SECONDS
 /** Where a module uses the AT+UPSD command to activate
  * a context for the internal IP stack of the module,
@@ -236,6 +248,40 @@ typedef enum {
     U_CELL_NET_REG_DOMAIN_MAX_NUM
 } uCellNetRegDomain_t;
 
+/** A coherent snapshot of the registration state in one domain,
+ * as returned by uCellNetGetRegistrationSnapshot().
+ */
+typedef struct {
+    uCellNetStatus_t status; /**< The registration status. */
+    uCellNetRat_t rat;       /**< The RAT, #U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED
+                                  if not registered. */
+    int32_t cellId;          /**< The cell ID, -1 if not known. */
+    int32_t areaCode;        /**< The location area code (CS domain or
+                                  2G/3G) or tracking area code (LTE),
+                                  -1 if not known. */
+    int32_t updatedAtMs;     /**< The value of uPortGetTickTimeMs()
+                                  when the registration status was last
+                                  updated, -1 if never. */
+} uCellNetRegistrationSnapshot_t;
+
+/** The last-known network parameters, as stored by
+ * uCellNetGetWarmStart() and used by uCellNetConnectWarm().  This
+ * is a plain structure with no pointers in it: the application may
+ * store it in non-volatile memory and hand it back after a
+ * restart, it is not otherwise interpreted by the application.
+ */
+typedef struct {
+    uint32_t magic;       /**< #U_CELL_NET_WARM_START_MAGIC if valid. */
+    char mccMnc[U_CELL_NET_MCC_MNC_LENGTH_BYTES]; /**< The MCC/MNC of the
+                                                       network that was
+                                                       registered on. */
+    uCellNetRat_t rat;    /**< The RAT that was in use. */
+    uint64_t bandMask1;   /**< Band mask 1 for that RAT, bit 0 is band 1. */
+    uint64_t bandMask2;   /**< Band mask 2 for that RAT, bit 0 is band 65. */
+    char apn[U_CELL_NET_MAX_APN_LENGTH_BYTES]; /**< The APN that was in use,
+                                                    may be empty. */
+} uCellNetWarmStart_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -296,6 +342,61 @@ int32_t uCellNetConnect(uDeviceHandle_t cellHandle,
                         const char *pPassword,
                         bool (*pKeepGoingCallback) (uDeviceHandle_t));
 
+/** Connect to the network using the last-known network parameters,
+ * as previously stored by uCellNetGetWarmStart(), in order to
+ * shorten the time to connect.  The MCC/MNC in pWarmStart is given
+ * to the module as an operator selection hint (AT+COPS=4: manual
+ * selection, falling back to automatic selection if that network
+ * cannot be found), so that a search of all networks is avoided,
+ * and the APN in pWarmStart is used unless pApn is non-NULL, so
+ * that the APN database need not be searched.  The RAT and band
+ * mask in pWarmStart are NOT applied since changing them requires
+ * a re-boot of the module; an application that has reason to
+ * believe they have changed may apply them with
+ * uCellCfgSetRatRank()/uCellCfgSetBandMask() before calling this
+ * function.
+ *
+ * If pWarmStart is not valid this behaves exactly as
+ * uCellNetConnect() with automatic network selection.  If the
+ * warm start attempt fails, or takes longer than
+ * #U_CELL_NET_WARM_START_TIMEOUT_SECONDS, a normal
+ * uCellNetConnect() with automatic network selection is performed,
+ * provided that pKeepGoingCallback, if there is one, still returns
+ * true.
+ *
+ * @param cellHandle             the handle of the cellular instance.
+ * @param[in] pWarmStart         the last-known network parameters;
+ *                               may be NULL.
+ * @param[in] pApn               as for uCellNetConnect(), except that
+ *                               NULL means "use the APN in pWarmStart,
+ *                               if there is one".
+ * @param[in] pUsername          as for uCellNetConnect().
+ * @param[in] pPassword          as for uCellNetConnect().
+ * @param[in] pKeepGoingCallback as for uCellNetConnect(); this governs
+ *                               both the warm start attempt and any
+ *                               fall-back attempt.
+ * @return                       zero on success or negative error code on
+ *                               failure.
+ */
+int32_t uCellNetConnectWarm(uDeviceHandle_t cellHandle,
+                            const uCellNetWarmStart_t *pWarmStart,
+                            const char *pApn, const char *pUsername,
+                            const char *pPassword,
+                            bool (*pKeepGoingCallback) (uDeviceHandle_t));
+
+/** Store the current network parameters so that they may be passed
+ * to uCellNetConnectWarm() later: the module must be registered
+ * and should be connected, otherwise the APN will be empty.
+ *
+ * @param cellHandle       the handle of the cellular instance.
+ * @param[out] pWarmStart  a place to store the network parameters;
+ *                         cannot be NULL.
+ * @return                 zero on success or negative error code on
+ *                         failure.
+ */
+int32_t uCellNetGetWarmStart(uDeviceHandle_t cellHandle,
+                             uCellNetWarmStart_t *pWarmStart);
+
 /** Register with the cellular network.  Note that on EUTRAN (LTE)
  * networks, registration and context activation are done at the same
  * time and hence, if you want to specify an APN rather than rely
@@ -520,6 +621,62 @@ int32_t uCellNetScanGetNext(uDeviceHandle_t cellHandle,
  */
 void uCellNetScanGetLast(uDeviceHandle_t cellHandle);
 
+/** Perform a network scan, calling pCallback with each network
+ * as soon as it has been read from the module, rather than
+ * buffering the whole result as uCellNetScanGetFirst() does.
+ * pCallback may end the scan early, for instance once a
+ * preferred network has been seen, by returning false.  Note
+ * that the module only begins to return results once it has
+ * completed its search, hence the saving is in the time taken
+ * to buffer and parse the rest of the results and in the memory
+ * that would otherwise be used to store them.  This does not
+ * affect the results stored for uCellNetScanGetNext().
+ *
+ * For instance, to find out if "23410" is visible:
+ *
+ * ```
+ * bool isNot23410(uDeviceHandle_t cellHandle, const char *pName,
+ *                 const char *pMccMnc, uCellNetRat_t rat,
+ *                 void *pParameter)
+ * {
+ *     bool keepGoing = (strcmp(pMccMnc, "23410") != 0);
+ *     if (!keepGoing) {
+ *         *((bool *) pParameter) = true;
+ *     }
+ *     return keepGoing;
+ * }
+ *
+ * bool found = false;
+ * uCellNetScan(handle, isNot23410, &found, NULL);
+ * ```
+ *
+ * @param cellHandle             the handle of the cellular instance.
+ * @param[in] pCallback          the function to call with each
+ *                               network found; cannot be NULL.  The
+ *                               parameters are the cell handle, the
+ *                               name of the network (may be an empty
+ *                               string), the MCC/MNC string of the
+ *                               network, the radio access technology
+ *                               of the network and pCallbackParameter;
+ *                               the strings are valid only for the
+ *                               duration of the call.  Return true
+ *                               to continue with the next network,
+ *                               false to end the scan.  pCallback is
+ *                               called with the cellular API locked
+ *                               and so must not call back into it.
+ * @param[in] pCallbackParameter a parameter that will be passed to
+ *                               pCallback; may be NULL.
+ * @param[in] pKeepGoingCallback as for uCellNetScanGetFirst().
+ * @return                       the number of networks passed to
+ *                               pCallback or negative error code.
+ */
+int32_t uCellNetScan(uDeviceHandle_t cellHandle,
+                     bool (*pCallback) (uDeviceHandle_t, const char *,
+                                        const char *, uCellNetRat_t,
+                                        void *),
+                     void *pCallbackParameter,
+                     bool (*pKeepGoingCallback) (uDeviceHandle_t));
+
 /** Enable or disable the registration status call-back. This
  * call-back allows the application to know the various
  * states of the network scanning, registration and rejections
@@ -625,6 +782,24 @@ bool uCellNetIsRegistered(uDeviceHandle_t cellHandle);
  */
 uCellNetRat_t uCellNetGetActiveRat(uDeviceHandle_t cellHandle);
 
+/** Get a snapshot of the registration status, RAT, cell ID and
+ * area code in one domain, plus the time at which it was last
+ * updated.  This is the state delivered by the +CREG/+CGREG/+CEREG
+ * URCs, so reading it involves no AT traffic and the members of
+ * the snapshot are always consistent with one another, even if a
+ * URC arrives while it is being read.  The cell ID and area code
+ * are only delivered by URCs: if the module is registered but no
+ * URC has arrived since registration they may be -1.
+ *
+ * @param cellHandle      the handle of the cellular instance.
+ * @param domain          the domain, see uCellNetGetNetworkStatus().
+ * @param[out] pSnapshot  a place to put the snapshot; cannot be NULL.
+ * @return                zero on success else negative error code.
+ */
+int32_t uCellNetGetRegistrationSnapshot(uDeviceHandle_t cellHandle,
+                                        uCellNetRegDomain_t domain,
+                                        uCellNetRegistrationSnapshot_t *pSnapshot);
+
 /** Get the name of the operator on which the cellular module is
  * registered.  An error will be returned if the module is not
  * registered on the network at the time this is called.
@@ -178,10 +178,88 @@ extern "C" {
 # define U_CELL_PWR_UART_POWER_SAVING_DTR_HYSTERESIS_MS 20
 #endif
 
+#ifndef U_CELL_PWR_TX_SCHEDULE_MAX_NUM
+/** The maximum number of sends that the transmit scheduler (see
+ * uCellPwrTxSchedule()) will hold; if it is full the send being
+ * scheduled and everything held are sent at once.
+ */
+# define U_CELL_PWR_TX_SCHEDULE_MAX_NUM 8
+#endif
+
+#ifndef U_CELL_PWR_TX_SCHEDULE_NORMAL_MAX_HOLD_SECONDS
+/** The longest that the transmit scheduler will hold a send of
+ * priority #U_CELL_PWR_TX_PRIORITY_NORMAL waiting for the module
+ * to wake up.
+ */
+# define U_CELL_PWR_TX_SCHEDULE_NORMAL_MAX_HOLD_SECONDS 60
+#endif
+
+#ifndef U_CELL_PWR_TX_SCHEDULE_LOW_MAX_HOLD_SECONDS
+/** The longest that the transmit scheduler will hold a send of
+ * priority #U_CELL_PWR_TX_PRIORITY_LOW waiting for the module to
+ * wake up.
+ */
+# define U_CELL_PWR_TX_SCHEDULE_LOW_MAX_HOLD_SECONDS 900
+#endif
+
+/* Note: define U_CELL_PWR_READY_DETECT_DISABLE to go back to waiting
+ * the fixed, worst-case, times of the module before looking for it
+ * to respond after power-on or reboot. */
+
+#ifndef U_CELL_PWR_READY_POLL_START_MS
+/** After power-on or reboot the module is probed with "AT" (once
+ * VInt, if connected, shows it to be on), first after this many
+ * milliseconds, the interval then doubling up to
+ * #U_CELL_PWR_READY_POLL_MAX_MS, so that we proceed very shortly
+ * after the module is ready rather than after its worst-case boot
+ * time.
+ */
+# define U_CELL_PWR_READY_POLL_START_MS 100
+#endif
+
+#ifndef U_CELL_PWR_READY_POLL_MAX_MS
+/** The longest interval between "AT" probes while waiting for the
+ * module to be ready, see #U_CELL_PWR_READY_POLL_START_MS.
+ */
+# define U_CELL_PWR_READY_POLL_MAX_MS 1000
+#endif
+
+#ifndef U_CELL_PWR_READY_PROBE_TIMEOUT_MS
+/** How long to wait for a response to each "AT" probe while
+ * waiting for the module to be ready; much shorter than the usual
+ * response time since a module that is booting does not respond at
+ * all.
+ */
+# define U_CELL_PWR_READY_PROBE_TIMEOUT_MS 300
+#endif
+
+#ifndef U_CELL_PWR_READY_TIMEOUT_MIN_MS
+/** Once boot times have been measured, the first attempt at
+ * power-on or reboot gives up after twice the longest measured boot
+ * time, but never less than this, and never more than the worst-case
+ * time for the module; any retry uses the worst-case time.
+ */
+# define U_CELL_PWR_READY_TIMEOUT_MIN_MS 5000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The priority of a send passed to uCellPwrTxSchedule().
+ */
+typedef enum {
+    U_CELL_PWR_TX_PRIORITY_URGENT = 0, /**< send now, along with anything
+                                            that is being held. */
+    U_CELL_PWR_TX_PRIORITY_NORMAL = 1, /**< hold until the module is next
+                                            awake, for at most
+                                            #U_CELL_PWR_TX_SCHEDULE_NORMAL_MAX_HOLD_SECONDS. */
+    U_CELL_PWR_TX_PRIORITY_LOW = 2,    /**< hold until the module is next
+                                            awake, for at most
+                                            #U_CELL_PWR_TX_SCHEDULE_LOW_MAX_HOLD_SECONDS. */
+    U_CELL_PWR_TX_PRIORITY_MAX_NUM
+} uCellPwrTxPriority_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -384,6 +462,18 @@ bool uCellPwrRebootIsRequired(uDeviceHandle_t cellHandle);
 int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
                        bool (*pKeepGoingCallback) (uDeviceHandle_t));
 
+/** Get the time the module last took to boot: from the end of the
+ * power-on pulse or from the reboot command to the module answering
+ * "AT".  This is measured on every power-on and reboot performed by
+ * this code and used to shorten the time allowed for the next.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @return            on success the boot time in milliseconds, else
+ *                    negative error code; #U_ERROR_COMMON_NOT_FOUND
+ *                    if no boot time has been measured yet.
+ */
+int32_t uCellPwrGetBootTimeMs(uDeviceHandle_t cellHandle);
+
 /** Reset the cellular module using the given MCU pin, which should
  * be connected to the reset pin of the cellular module, for example
  * U_CFG_APP_PIN_CELL_RESET could be used.  Note that NO organised
@@ -913,6 +1003,70 @@ int32_t uCellPwrEnableUartSleep(uDeviceHandle_t cellHandle);
  */
 bool uCellPwrUartSleepIsEnabled(uDeviceHandle_t cellHandle);
 
+/** Schedule a send.  When 3GPP power saving (PSM) or E-DRX is in
+ * use, every send that the application makes while the module is
+ * asleep causes it to wake up, which costs a lot of energy for a
+ * few bytes.  Rather than sending non-urgent data straight away
+ * with the socket or MQTT APIs, the application may instead hand
+ * the transmit scheduler a function that does the send: all of the
+ * held sends are then made together, in priority order, as soon as
+ * there is a good opportunity, which is when:
+ *
+ * - the module has woken up from deep sleep,
+ * - the module has woken up its protocol stack (+UUPSMR: 0, e.g. at
+ *   the start of a periodic wake-up or paging window),
+ * - a send of priority #U_CELL_PWR_TX_PRIORITY_URGENT is scheduled,
+ * - the scheduler is full,
+ * - uCellPwrTxFlush() is called, or
+ * - the maximum hold time for the priority of a held send expires.
+ *
+ * In all but the last three cases the held sends are made from
+ * the uAtClientCallback() task (see the AT client API), and so
+ * pSend should not block for longer than it takes to do the send
+ * itself.  A send of priority #U_CELL_PWR_TX_PRIORITY_URGENT, and
+ * anything that accompanies it, is made from the calling task
+ * before this function returns.  The scheduler does not look at, or
+ * copy, the data: whatever pSendParam points to must remain valid
+ * until pSend has been called.  Anything held when the cellular
+ * instance is removed is discarded without being sent.  On a
+ * platform that does not implement port timers the maximum hold
+ * time cannot be honoured and so every send is made at once.
+ *
+ * @param cellHandle      the handle of the cellular instance.
+ * @param priority        the priority of the send.
+ * @param[in] pSend       the function that does the send, e.g. by
+ *                        calling uCellSockWrite(); the first
+ *                        parameter will be cellHandle, the second
+ *                        pSendParam.  Cannot be NULL.
+ * @param[in] pSendParam  a parameter that will be passed to pSend
+ *                        as its second parameter; may be NULL.
+ * @return                zero on success else negative error code.
+ */
+int32_t uCellPwrTxSchedule(uDeviceHandle_t cellHandle,
+                           uCellPwrTxPriority_t priority,
+                           void (*pSend) (uDeviceHandle_t cellHandle,
+                                          void *pSendParam),
+                           void *pSendParam);
+
+/** Make all of the sends held by the transmit scheduler, see
+ * uCellPwrTxSchedule(), now, from the calling task, e.g. because
+ * the application is about to switch the module off.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @return            on success the number of sends made, else
+ *                    negative error code.
+ */
+int32_t uCellPwrTxFlush(uDeviceHandle_t cellHandle);
+
+/** Get the number of sends being held by the transmit scheduler,
+ * see uCellPwrTxSchedule().
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @return            on success the number of sends being held,
+ *                    else negative error code.
+ */
+int32_t uCellPwrTxGetNumPending(uDeviceHandle_t cellHandle);
+
 #ifdef __cplusplus
 }
 #endif
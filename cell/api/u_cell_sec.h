@@ -137,6 +137,12 @@ int32_t uCellSecGetRootOfTrustUid(uDeviceHandle_t cellHandle,
  * in a call to uSecurityC2cOpen() to encrypt communication over the
  * AT interface between this MCU and the module.
  *
+ * If chip to chip security has been excluded from the build by
+ * defining U_CFG_CELL_DISABLE_C2C (as the cell_c2c feature of
+ * port/ubxlib.cmake or port/ubxlib.mk does when excluded) this
+ * function, uCellSecC2cOpen() and uCellSecC2cClose() will return
+ * #U_ERROR_COMMON_NOT_SUPPORTED.
+ *
  * @param cellHandle     the handle of the instance to be used.
  * @param[in] pTESecret  a pointer to the fixed-length 16 byte
  *                       secret generated by this MCU (the
@@ -472,6 +472,31 @@ int32_t uCellSecTlsSniSet(const uCellSecTlsContext_t *pContext,
 int32_t uCellSecTlsSniGet(const uCellSecTlsContext_t *pContext,
                           char *pSni, size_t size);
 
+/** Set whether TLS session resumption is used: if it is, the
+ * module keeps the session negotiated with a server against the
+ * security profile and, the next time a connection is made to
+ * that server with the same profile, resumes it with an abbreviated
+ * handshake rather than going through the whole thing again.
+ * Only supported on SARA-R5, SARA-R422 and LARA-R6 modules.
+ *
+ * @param[in] pContext a pointer to the security context.
+ * @param onNotOff     true to use session resumption, false
+ *                     (the default) for a full handshake on
+ *                     every connection.
+ * @return             zero on success else negative error
+ *                     code.
+ */
+int32_t uCellSecTlsSessionResumptionSet(const uCellSecTlsContext_t *pContext,
+                                        bool onNotOff);
+
+/** Get whether TLS session resumption is used.
+ *
+ * @param[in] pContext a pointer to the security context.
+ * @return             true if session resumption is used,
+ *                     else false.
+ */
+bool uCellSecTlsIsUsingSessionResumption(const uCellSecTlsContext_t *pContext);
+
 #ifdef __cplusplus
 }
 #endif
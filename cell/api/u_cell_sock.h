@@ -151,6 +151,42 @@ int32_t uCellSockConnect(uDeviceHandle_t cellHandle,
                          int32_t sockHandle,
                          const uSockAddress_t *pRemoteAddress);
 
+/** Connect to a server asynchronously: this function returns
+ * once the connection has been started and pCallback is called
+ * when it has completed.  Only supported by modules that can
+ * report the result of a connection with the +UUSOCO URC
+ * (SARA-R5, SARA-R422 and LARA-R6); for other modules use
+ * uCellSockConnect().
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param sockHandle         the handle of the socket.
+ * @param[in] pRemoteAddress the address of the server to
+ *                           connect to, including port number.
+ * @param[in] pCallback      the callback to call when the
+ *                           connection has completed, with
+ *                           the first parameter the cellHandle,
+ *                           the second parameter the sockHandle
+ *                           and the third parameter U_SOCK_ENONE
+ *                           if the connection succeeded, else
+ *                           a (non-negated) value of U_SOCK_Exxx
+ *                           from u_sock_errno.h; cannot be NULL.
+ *                           The callback is called from the AT
+ *                           client callback task and is only
+ *                           called if this function returns
+ *                           success.
+ * @return                   zero on success, -U_SOCK_ENOSYS if
+ *                           the module does not support
+ *                           asynchronous connection, else
+ *                           negated value of U_SOCK_Exxx from
+ *                           u_sock_errno.h.
+ */
+int32_t uCellSockConnectAsync(uDeviceHandle_t cellHandle,
+                              int32_t sockHandle,
+                              const uSockAddress_t *pRemoteAddress,
+                              void (*pCallback) (uDeviceHandle_t,
+                                                 int32_t,
+                                                 int32_t));
+
 /** Close a socket.
  *
  * @param cellHandle     the handle of the cellular instance.
@@ -373,6 +409,28 @@ int32_t uCellSockSendTo(uDeviceHandle_t cellHandle,
                         const uSockAddress_t *pRemoteAddress,
                         const void *pData, size_t dataSizeBytes);
 
+/** As uCellSockSendTo() but with the datagram gathered from
+ * several fragments; the fragments are sent with a single
+ * AT+USOST command.  The limit on the total length is as for
+ * uCellSockSendTo().
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param sockHandle         the handle of the socket.
+ * @param[in] pRemoteAddress the address of the server to
+ *                           send the datagram to plus port number.
+ *                           Cannot be NULL.
+ * @param[in] pIoVec         an array of numIoVec fragments; an entry
+ *                           with a length of zero is ignored.
+ * @param numIoVec           the number of entries at pIoVec.
+ * @return                   the number of bytes sent on
+ *                           success else negated value
+ *                           of U_SOCK_Exxx from u_sock_errno.h.
+ */
+int32_t uCellSockSendTov(uDeviceHandle_t cellHandle,
+                         int32_t sockHandle,
+                         const uSockAddress_t *pRemoteAddress,
+                         const uSockIoVec_t *pIoVec, size_t numIoVec);
+
 /** Receive a datagram.
  *
  * @param cellHandle          the handle of the cellular instance.
@@ -400,6 +458,52 @@ int32_t uCellSockReceiveFrom(uDeviceHandle_t cellHandle,
                              uSockAddress_t *pRemoteAddress,
                              void *pData, size_t dataSizeBytes);
 
+/** Send several datagrams, back-to-back, with the AT interface
+ * locked throughout; sending stops at the first failure.  The limit
+ * on the length of each datagram is as for uCellSockSendTo().
+ *
+ * @param cellHandle          the handle of the cellular instance.
+ * @param sockHandle          the handle of the socket.
+ * @param[in] pRemoteAddress  the address to send a datagram to where
+ *                            its own pRemoteAddress is NULL; may be
+ *                            NULL if no datagram needs it.
+ * @param[in,out] pDatagrams  an array of numDatagrams datagrams; the
+ *                            sizeBytes field of each one sent is
+ *                            filled in.
+ * @param numDatagrams        the number of entries at pDatagrams.
+ * @return                    the number of datagrams sent, from the
+ *                            start of the array, else negated value
+ *                            of U_SOCK_Exxx from u_sock_errno.h if
+ *                            not even the first could be sent.
+ */
+int32_t uCellSockSendToMany(uDeviceHandle_t cellHandle,
+                            int32_t sockHandle,
+                            const uSockAddress_t *pRemoteAddress,
+                            uSockDatagram_t *pDatagrams,
+                            size_t numDatagrams);
+
+/** Receive those datagrams that are waiting, up to numDatagrams of
+ * them, back-to-back with the AT interface locked throughout.  The
+ * limit on the length of each datagram is as for
+ * uCellSockReceiveFrom().
+ *
+ * @param cellHandle          the handle of the cellular instance.
+ * @param sockHandle          the handle of the socket.
+ * @param[in,out] pDatagrams  an array of numDatagrams datagrams; the
+ *                            pRemoteAddress (where not NULL) and
+ *                            sizeBytes fields of each one received
+ *                            are filled in.
+ * @param numDatagrams        the number of entries at pDatagrams.
+ * @return                    the number of datagrams received into the
+ *                            start of the array, else negated value of
+ *                            U_SOCK_Exxx from u_sock_errno.h (e.g.
+ *                            -#U_SOCK_EWOULDBLOCK if there were none).
+ */
+int32_t uCellSockReceiveFromMany(uDeviceHandle_t cellHandle,
+                                 int32_t sockHandle,
+                                 uSockDatagram_t *pDatagrams,
+                                 size_t numDatagrams);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: STREAM (TCP)
  * -------------------------------------------------------------- */
@@ -420,6 +524,25 @@ int32_t uCellSockWrite(uDeviceHandle_t cellHandle,
                        int32_t sockHandle,
                        const void *pData, size_t dataSizeBytes);
 
+/** As uCellSockWrite() but with the data gathered from several
+ * fragments: each AT+USOWR command carries up to
+ * #U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES (or half this if hex mode
+ * is on) taken from as many fragments as fit, rather than there
+ * being at least one AT+USOWR command per fragment.
+ *
+ * @param cellHandle     the handle of the cellular instance.
+ * @param sockHandle     the handle of the socket.
+ * @param[in] pIoVec     an array of numIoVec fragments; an entry
+ *                       with a length of zero is ignored.
+ * @param numIoVec       the number of entries at pIoVec.
+ * @return               the number of bytes sent on
+ *                       success else negated value
+ *                       of U_SOCK_Exxx from u_sock_errno.h.
+ */
+int32_t uCellSockWritev(uDeviceHandle_t cellHandle,
+                        int32_t sockHandle,
+                        const uSockIoVec_t *pIoVec, size_t numIoVec);
+
 /** Receive bytes on a connected socket.
  *
  * @param cellHandle     the handle of the cellular instance.
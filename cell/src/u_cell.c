@@ -43,6 +43,7 @@
 #include "u_port_gpio.h"
 
 #include "u_at_client.h"
+#include "u_cmux.h"
 #include "u_device_shared.h"
 
 #include "u_cell_module_type.h"
@@ -89,6 +90,8 @@ static void addCellInstance(uCellPrivateInstance_t *pInstance)
 {
     pInstance->pNext = gpUCellPrivateInstanceList;
     gpUCellPrivateInstanceList = pInstance;
+    // Point the device instance at us for pUCellPrivateGetInstance()
+    U_DEVICE_INSTANCE(pInstance->cellHandle)->pDriverInstance = pInstance;
 }
 
 // Remove a cell instance from the list.
@@ -114,9 +117,45 @@ static void removeCellInstance(const uCellPrivateInstance_t *pInstance)
         }
     }
 
+    // This also invalidates the handle
     uDeviceDestroyInstance(U_DEVICE_INSTANCE(pInstance->cellHandle));
 }
 
+// Free a cell instance and everything hanging off it; the
+// instance must have been removed from the list and must not be
+// in use, see uCellPrivateInstanceWaitUnused().
+static void freeCellInstance(uCellPrivateInstance_t *pInstance)
+{
+    // Tell the AT client to ignore any asynchronous events from now on
+    uAtClientIgnoreAsync(pInstance->atHandle);
+    // Free the wake-up callback
+    uAtClientSetWakeUpHandler(pInstance->atHandle, NULL, NULL, 0);
+    // Free any scan results
+    uCellPrivateScanFree(pInstance);
+    // Free any chip to chip security context
+    uCellPrivateC2cRemoveContext(pInstance);
+    // Free any location context and associated URC
+    uCellPrivateLocRemoveContext(pInstance);
+    // Leave multiplexer mode, if it was enabled
+    uCellPrivateMuxRemoveContext(pInstance);
+    // Free any sleep context
+    uCellPrivateSleepRemoveContext(pInstance);
+    // Free any file cache
+    uCellPrivateFileCacheRemoveContext(pInstance);
+    // Stop any radio parameter sampler
+    uCellPrivateInfoSamplerRemoveContext(pInstance);
+    // Discard anything held by the transmit scheduler
+    uCellPrivateTxScheduleRemoveContext(pInstance);
+    // Stop any cached time base
+    uCellPrivateTimeBaseRemoveContext(pInstance);
+    // Free any HTTP context and associated URC
+    uCellPrivateHttpRemoveContext(pInstance);
+    // Free any FOTA context
+    free(pInstance->pFotaContext);
+    uPortMutexDelete(pInstance->mutex);
+    free(pInstance);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -141,28 +180,24 @@ void uCellDeinit()
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
-
         // Remove all cell instances
-        while (gpUCellPrivateInstanceList != NULL) {
+        do {
+            U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
             pInstance = gpUCellPrivateInstanceList;
-            removeCellInstance(pInstance);
-            // Tell the AT client to ignore any asynchronous events from now on
-            uAtClientIgnoreAsync(pInstance->atHandle);
-            // Free the wake-up callback
-            uAtClientSetWakeUpHandler(pInstance->atHandle, NULL, NULL, 0);
-            // Free any scan results
-            uCellPrivateScanFree(&(pInstance->pScanResults));
-            // Free any chip to chip security context
-            uCellPrivateC2cRemoveContext(pInstance);
-            // Free any location context and associated URC
-            uCellPrivateLocRemoveContext(pInstance);
-            // Free any sleep context
-            uCellPrivateSleepRemoveContext(pInstance);
-            // Free any FOTA context
-            free(pInstance->pFotaContext);
-            free(pInstance);
-        }
+            if (pInstance != NULL) {
+                removeCellInstance(pInstance);
+            }
+            U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+            if (pInstance != NULL) {
+                uCellPrivateInstanceWaitUnused(pInstance);
+                freeCellInstance(pInstance);
+            }
+        } while (pInstance != NULL);
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        // Multiplexer mode is no longer in use by any instance
+        uCmuxDeinit();
 
         // Unlock the mutex so that we can delete it
         U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
@@ -233,6 +268,8 @@ int32_t uCellAdd(uCellModuleType_t moduleType,
                     handleOrErrorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
                     // Fill the values in
                     memset(pInstance, 0, sizeof(*pInstance));
+                    uPortHeapArenaInit(&(pInstance->scanArena), 0,
+                                       U_PORT_HEAP_TAG_CELL, NULL, 0);
                     // Set the pin states so that we can use them elsewhere
                     if (pinEnablePowerOnState != 0) {
                         pInstance->pinStates |= 1 << U_CELL_PRIVATE_ENABLE_POWER_PIN_BIT_ON_STATE;
@@ -243,7 +280,7 @@ int32_t uCellAdd(uCellModuleType_t moduleType,
                     if (pinVIntOnState != 0) {
                         pInstance->pinStates |= 1 << U_CELL_PRIVATE_VINT_PIN_BIT_ON_STATE;
                     }
-                    pInstance->cellHandle = (uDeviceHandle_t)pDevInstance;
+                    pInstance->cellHandle = U_DEVICE_HANDLE(pDevInstance);
                     pInstance->atHandle = atHandle;
                     pInstance->pinEnablePower = pinEnablePower;
                     pInstance->pinPwrOn = pinPwrOn;
@@ -253,6 +290,9 @@ int32_t uCellAdd(uCellModuleType_t moduleType,
                          x < sizeof(pInstance->networkStatus) / sizeof(pInstance->networkStatus[0]);
                          x++) {
                         pInstance->networkStatus[x] = U_CELL_NET_STATUS_UNKNOWN;
+                        pInstance->cellId[x] = -1;
+                        pInstance->areaCode[x] = -1;
+                        pInstance->networkStatusUpdatedMs[x] = -1;
                     }
                     uCellPrivateClearRadioParameters(&(pInstance->radioParameters));
                     pInstance->pModule = &(gUCellPrivateModuleList[moduleType]);
@@ -360,6 +400,10 @@ int32_t uCellAdd(uCellModuleType_t moduleType,
                                      pinVInt, pinVInt, platformError);
                         }
                     }
+                    // Create the mutex that serialises API calls on this instance
+                    if (platformError == 0) {
+                        platformError = uPortMutexCreate(&(pInstance->mutex));
+                    }
                     // With that done, set up the AT client for this module
                     if (platformError == 0) {
                         uAtClientTimeoutSet(atHandle,
@@ -401,7 +445,7 @@ int32_t uCellAdd(uCellModuleType_t moduleType,
 // Remove a cellular instance.
 void uCellRemove(uDeviceHandle_t cellHandle)
 {
-    uCellPrivateInstance_t *pInstance;
+    uCellPrivateInstance_t *pInstance = NULL;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -410,22 +454,16 @@ void uCellRemove(uDeviceHandle_t cellHandle)
         pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             removeCellInstance(pInstance);
-            // Tell the AT client to ignore any asynchronous events from now on
-            uAtClientIgnoreAsync(pInstance->atHandle);
-            // Free the wake-up callback
-            uAtClientSetWakeUpHandler(pInstance->atHandle, NULL, NULL, 0);
-            // Free any scan results
-            uCellPrivateScanFree(&(pInstance->pScanResults));
-            // Free any chip to chip security context
-            uCellPrivateC2cRemoveContext(pInstance);
-            // Free any location context and associated URC
-            uCellPrivateLocRemoveContext(pInstance);
-            // Free any sleep context
-            uCellPrivateSleepRemoveContext(pInstance);
-            free(pInstance);
         }
 
         U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+
+        if (pInstance != NULL) {
+            // Now that it is out of the list, wait for any API
+            // call on the instance to finish before freeing it
+            uCellPrivateInstanceWaitUnused(pInstance);
+            freeCellInstance(pInstance);
+        }
     }
 }
 
@@ -438,16 +476,15 @@ int32_t uCellAtClientHandleGet(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && (pAtHandle != NULL)) {
             *pAtHandle = pInstance->atHandle;
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
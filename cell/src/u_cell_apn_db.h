@@ -52,15 +52,69 @@ extern "C" {
  */
 #define _APN_GET(pCfg) *pCfg ? pCfg : NULL; pCfg  += strlen(pCfg) + 1
 
+/** Pack an MCC and MNC into the integer key of a #uCellNetApn_t;
+ * whether the MNC has two or three digits is part of the key since,
+ * for instance, "310-26" and "310-026" are different things.  The
+ * table is sorted on this key, i.e. by MCC, then by two-digit
+ * before three-digit MNCs, then by MNC.
+ */
+#define U_CELL_APN_DB_KEY(mcc, mnc, mncDigits) ((((uint32_t) (mcc)) << 12) |             \
+                                                (((mncDigits) == 3) ? (1UL << 10) : 0) | \
+                                                ((uint32_t) (mnc)))
+
+/** The regions of the APN database, by the first digit of the MCC
+ * as allocated by the ITU, for use with #U_CELL_APN_DB_REGIONS.
+ */
+#define U_CELL_APN_DB_REGION_EUROPE        (1UL << 2)
+#define U_CELL_APN_DB_REGION_NORTH_AMERICA (1UL << 3)
+#define U_CELL_APN_DB_REGION_ASIA          (1UL << 4)
+#define U_CELL_APN_DB_REGION_OCEANIA       (1UL << 5)
+#define U_CELL_APN_DB_REGION_AFRICA        (1UL << 6)
+#define U_CELL_APN_DB_REGION_SOUTH_AMERICA (1UL << 7)
+#define U_CELL_APN_DB_REGION_INTERNATIONAL (1UL << 9)
+
+#ifndef U_CELL_APN_DB_REGIONS
+/** The regions of the APN database to compile in, a bit-map of
+ * U_CELL_APN_DB_REGION_xxx values; to save flash, override this
+ * with only the regions your devices will operate in, e.g.
+ * (U_CELL_APN_DB_REGION_EUROPE | U_CELL_APN_DB_REGION_INTERNATIONAL).
+ * Networks in regions that are not compiled in will be given the
+ * default APN.
+ */
+# define U_CELL_APN_DB_REGIONS 0xFFFFFFFFUL
+#endif
+
+/** APN configuration strings that are used by more than one entry.
+ */
+#define U_CELL_APN_DB_CFG_M2M_BUSINESS _APN("m2m.business",,)
+#define U_CELL_APN_DB_CFG_TELEFONICA_UK _APN("mobile.o2.co.uk", "faster", "web") /* contract */ \
+                                        _APN("mobile.o2.co.uk", "bypass", "web") /* pre-pay */  \
+                                        _APN("payandgo.o2.co.uk", "payandgo", "payandgo")
+#define U_CELL_APN_DB_CFG_TELENOR_SE _APN("services.telenor.se",,)
+#define U_CELL_APN_DB_CFG_TMOBILE_US _APN("epc.tmobile.com",,) \
+                                     _APN("fast.tmobile.com",,) /* LTE */
+#define U_CELL_APN_DB_CFG_ATT _APN("phone",,)                                                \
+                              _APN("wap.cingular", "WAP@CINGULARGPRS.COM", "CINGULAR1") \
+                              _APN("isp.cingular", "ISP@CINGULARGPRS.COM", "CINGULAR1")
+#define U_CELL_APN_DB_CFG_SOFTBANK _APN("open.softbank.ne.jp", "opensoftbank", "ebMNuX1FIHg9d3DA") \
+                                   _APN("smile.world", "dna1trop", "so2t3k3m2a")
+#define U_CELL_APN_DB_CFG_DOCOMO _APN("bmobilewap",,) /*BMobile*/                             \
+                                 _APN("mpr2.bizho.net", "Mopera U",) /* DoCoMo */            \
+                                 _APN("bmobile.ne.jp", "bmobile@wifi2", "bmobile") /*BMobile*/
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
-/** APN lookup structure.
+/** APN lookup structure: an entry covers numMnc consecutive MNCs,
+ * starting with the one in key.
  */
 typedef struct {
-    const char *pMccMnc; /**< mobile country code (MCC) and
-                              mobile network code (MNC). */
+    uint32_t key;        /**< mobile country code (MCC) and first mobile
+                              network code (MNC), packed with
+                              U_CELL_APN_DB_KEY(). */
+    uint8_t numMnc;      /**< the number of consecutive MNCs, from that in
+                              key, that this entry applies to. */
     const char *pCfg;    /**< APN configuration string, use
                               _APN macro to generate. */
 } uCellNetApn_t;
@@ -73,113 +127,151 @@ typedef struct {
  */
 static const char *const pApnDefault = _APN("internet",,);
 
-/** List of special APNs for different network operators.
+/** List of special APNs for different network operators, SORTED
+ * on key, since it is binary searched.
  *
  * No need to add default, "internet" will be used as a default if
  * no entry matches.
  * The APN without username/password have to be listed first.
  */
 static const uCellNetApn_t gApnLookUpTable[] = {
-// MCC Country
-//  { /* Operator */ "MCC-MNC[,MNC]" _APN(APN, USERNAME, PASSWORD) },
-// MCC must be 3 digits
+//  { /* Operator */ U_CELL_APN_DB_KEY(MCC, MNC, MNC digits), number of MNCs, _APN(APN, USERNAME, PASSWORD) },
 // MNC must be either 2 or 3 digits
-// MCC must be separated by '-' from MNC, multiple MNC can be separated by ','
-
-// 232 Austria - AUT
-    { /* T-Mobile */ "232-03",  _APN("m2m.business",,) },
-
-// 460 China - CN
-    { /* CN Mobile */"460-00",  _APN("cmnet",,)
-        _APN("cmwap",,)
-    },
-    { /* Unicom */   "460-01",  _APN("3gnet",,)
-        _APN("uninet", "uninet", "uninet")
-    },
-
-// 262 Germany - DE
-    { /* T-Mobile */ "262-01",  _APN("internet.t-mobile", "t-mobile", "tm") },
-    { /* T-Mobile */ "262-02,06",
-        _APN("m2m.business",,)
-    },
-
-// 222 Italy - IT
-    { /* TIM */      "222-01",  _APN("ibox.tim.it",,) },
-    { /* Vodafone */ "222-10",  _APN("web.omnitel.it",,) },
-    { /* Wind */     "222-88",  _APN("internet.wind.biz",,) },
-
-// 440 Japan - JP
-//lint -e{786} Suppress concatenation within initialiser
-    { /* Softbank */ "440-04,06,20,40,41,42,43,44,45,46,47,48,90,91,92,93,94,95"
-        ",96,97,98",
-        _APN("open.softbank.ne.jp", "opensoftbank", "ebMNuX1FIHg9d3DA")
-        _APN("smile.world", "dna1trop", "so2t3k3m2a")
-    },
-//lint -e{786} Suppress concatenation within initialiser
-    { /* NTTDoCoMo */ "440-09,10,11,12,13,14,15,16,17,18,19,21,22,23,24,25,26,27,"
-        "28,29,30,31,32,33,34,35,36,37,38,39,58,59,60,61,62,63,"
-        "64,65,66,67,68,69,87,99",
-        _APN("bmobilewap",,) /*BMobile*/
-        _APN("mpr2.bizho.net", "Mopera U",) /* DoCoMo */
-        _APN("bmobile.ne.jp", "bmobile@wifi2", "bmobile") /*BMobile*/
-    },
+// Entries must be in order of MCC, then two-digit before three-digit
+// MNCs, then MNC, and must not overlap
 
+#if U_CELL_APN_DB_REGIONS & U_CELL_APN_DB_REGION_EUROPE
 // 204 Netherlands - NL
-    { /* Vodafone */ "204-04",  _APN("public4.m2minternet.com",,) },
+    { /* Vodafone */   U_CELL_APN_DB_KEY(204, 4, 2),  1, _APN("public4.m2minternet.com",,) },
 
-// 293 Slovenia - SI
-    { /* Si.mobil */ "293-40",  _APN("internet.simobil.si",,) },
-    { /* Tusmobil */ "293-70",  _APN("internet.tusmobil.si",,) },
+// 214 Spain
+    { /* Telefonica */ U_CELL_APN_DB_KEY(214, 7, 2),  1, _APN("m2mtrial.telefonica.com",,) /* Cat-M1 */ },
 
-// 240 Sweden SE
-    { /* Telia */    "240-01",  _APN("online.telia.se",,) },
-    { /* Telenor */  "240-06,08",
-        _APN("services.telenor.se",,)
-    },
-    { /* Tele2 */    "240-07",  _APN("mobileinternet.tele2.se",,) },
+// 222 Italy - IT
+    { /* TIM */        U_CELL_APN_DB_KEY(222, 1, 2),  1, _APN("ibox.tim.it",,) },
+    { /* Vodafone */   U_CELL_APN_DB_KEY(222, 10, 2), 1, _APN("web.omnitel.it",,) },
+    { /* Wind */       U_CELL_APN_DB_KEY(222, 88, 2), 1, _APN("internet.wind.biz",,) },
 
 // 228 Switzerland - CH
-    { /* Swisscom */ "228-01",  _APN("gprs.swisscom.ch",,) },
-    { /* Orange */   "228-03",  _APN("internet",,) /* contract */
+    { /* Swisscom */   U_CELL_APN_DB_KEY(228, 1, 2),  1, _APN("gprs.swisscom.ch",,) },
+    {
+        /* Orange */   U_CELL_APN_DB_KEY(228, 3, 2),  1, _APN("internet",,) /* contract */
         _APN("click",,)    /* pre-pay */
     },
 
+// 232 Austria - AUT
+    { /* T-Mobile */   U_CELL_APN_DB_KEY(232, 3, 2),  1, U_CELL_APN_DB_CFG_M2M_BUSINESS },
+
 // 234 United Kingdom - GB
-    { /* Telefonica */       "234-02,10,11",
-        _APN("mobile.o2.co.uk", "faster", "web") /* contract */
-        _APN("mobile.o2.co.uk", "bypass", "web") /* pre-pay */
-        _APN("payandgo.o2.co.uk", "payandgo", "payandgo")
-    },
-    { /* Vodafone */ "234-15",  _APN("internet", "web", "web") /* contract */
+    { /* Telefonica */ U_CELL_APN_DB_KEY(234, 2, 2),  1, U_CELL_APN_DB_CFG_TELEFONICA_UK },
+    { /* Telefonica */ U_CELL_APN_DB_KEY(234, 10, 2), 2, U_CELL_APN_DB_CFG_TELEFONICA_UK },
+    {
+        /* Vodafone */ U_CELL_APN_DB_KEY(234, 15, 2), 1, _APN("internet", "web", "web") /* contract */
         _APN("pp.vodafone.co.uk", "wap", "wap")  /* pre-pay */
     },
-    { /* Three */    "234-20",  _APN("three.co.uk",,) },
-    { /* Jersey */   "234-50",  _APN("jtm2m",,) /* as used on u-blox C030 U201 boards */ },
+    { /* Three */      U_CELL_APN_DB_KEY(234, 20, 2), 1, _APN("three.co.uk",,) },
+    { /* Jersey */     U_CELL_APN_DB_KEY(234, 50, 2), 1, _APN("jtm2m",,) /* as used on u-blox C030 U201 boards */ },
 
+// 240 Sweden SE
+    { /* Telia */      U_CELL_APN_DB_KEY(240, 1, 2),  1, _APN("online.telia.se",,) },
+    { /* Telenor */    U_CELL_APN_DB_KEY(240, 6, 2),  1, U_CELL_APN_DB_CFG_TELENOR_SE },
+    { /* Tele2 */      U_CELL_APN_DB_KEY(240, 7, 2),  1, _APN("mobileinternet.tele2.se",,) },
+    { /* Telenor */    U_CELL_APN_DB_KEY(240, 8, 2),  1, U_CELL_APN_DB_CFG_TELENOR_SE },
+
+// 262 Germany - DE
+    { /* T-Mobile */   U_CELL_APN_DB_KEY(262, 1, 2),  1, _APN("internet.t-mobile", "t-mobile", "tm") },
+    { /* T-Mobile */   U_CELL_APN_DB_KEY(262, 2, 2),  1, U_CELL_APN_DB_CFG_M2M_BUSINESS },
+    { /* T-Mobile */   U_CELL_APN_DB_KEY(262, 6, 2),  1, U_CELL_APN_DB_CFG_M2M_BUSINESS },
+
+// 293 Slovenia - SI
+    { /* Si.mobil */   U_CELL_APN_DB_KEY(293, 40, 2), 1, _APN("internet.simobil.si",,) },
+    { /* Tusmobil */   U_CELL_APN_DB_KEY(293, 70, 2), 1, _APN("internet.tusmobil.si",,) },
+#endif
+
+#if U_CELL_APN_DB_REGIONS & U_CELL_APN_DB_REGION_NORTH_AMERICA
 // 310 United States of America - US
-    { /* T-Mobile */ "310-026,260,490",
-        _APN("epc.tmobile.com",,)
-        _APN("fast.tmobile.com",,) /* LTE */
+// Note: 310-260 is T-Mobile, not AT&T
+    { /* T-Mobile */   U_CELL_APN_DB_KEY(310, 26, 3),  1, U_CELL_APN_DB_CFG_TMOBILE_US },
+    { /* AT&T */       U_CELL_APN_DB_KEY(310, 30, 3),  1, U_CELL_APN_DB_CFG_ATT },
+    { /* AT&T */       U_CELL_APN_DB_KEY(310, 150, 3), 1, U_CELL_APN_DB_CFG_ATT },
+    { /* AT&T */       U_CELL_APN_DB_KEY(310, 170, 3), 1, U_CELL_APN_DB_CFG_ATT },
+    { /* T-Mobile */   U_CELL_APN_DB_KEY(310, 260, 3), 1, U_CELL_APN_DB_CFG_TMOBILE_US },
+    { /* AT&T */       U_CELL_APN_DB_KEY(310, 410, 3), 1, U_CELL_APN_DB_CFG_ATT },
+    { /* T-Mobile */   U_CELL_APN_DB_KEY(310, 490, 3), 1, U_CELL_APN_DB_CFG_TMOBILE_US },
+    { /* AT&T */       U_CELL_APN_DB_KEY(310, 560, 3), 1, U_CELL_APN_DB_CFG_ATT },
+    { /* AT&T */       U_CELL_APN_DB_KEY(310, 680, 3), 1, U_CELL_APN_DB_CFG_ATT },
+#endif
+
+#if U_CELL_APN_DB_REGIONS & U_CELL_APN_DB_REGION_ASIA
+// 440 Japan - JP
+    { /* Softbank */   U_CELL_APN_DB_KEY(440, 4, 2),  1,  U_CELL_APN_DB_CFG_SOFTBANK },
+    { /* Softbank */   U_CELL_APN_DB_KEY(440, 6, 2),  1,  U_CELL_APN_DB_CFG_SOFTBANK },
+    { /* NTTDoCoMo */  U_CELL_APN_DB_KEY(440, 9, 2),  11, U_CELL_APN_DB_CFG_DOCOMO },
+    { /* Softbank */   U_CELL_APN_DB_KEY(440, 20, 2), 1,  U_CELL_APN_DB_CFG_SOFTBANK },
+    { /* NTTDoCoMo */  U_CELL_APN_DB_KEY(440, 21, 2), 19, U_CELL_APN_DB_CFG_DOCOMO },
+    { /* Softbank */   U_CELL_APN_DB_KEY(440, 40, 2), 9,  U_CELL_APN_DB_CFG_SOFTBANK },
+    { /* NTTDoCoMo */  U_CELL_APN_DB_KEY(440, 58, 2), 12, U_CELL_APN_DB_CFG_DOCOMO },
+    { /* NTTDoCoMo */  U_CELL_APN_DB_KEY(440, 87, 2), 1,  U_CELL_APN_DB_CFG_DOCOMO },
+    { /* Softbank */   U_CELL_APN_DB_KEY(440, 90, 2), 9,  U_CELL_APN_DB_CFG_SOFTBANK },
+    { /* NTTDoCoMo */  U_CELL_APN_DB_KEY(440, 99, 2), 1,  U_CELL_APN_DB_CFG_DOCOMO },
+
+// 460 China - CN
+    {
+        /* CN Mobile */ U_CELL_APN_DB_KEY(460, 0, 2), 1, _APN("cmnet",,)
+        _APN("cmwap",,)
     },
-    { /* AT&T */     "310-030,150,170,260,410,560,680",
-        _APN("phone",,)
-        _APN("wap.cingular", "WAP@CINGULARGPRS.COM", "CINGULAR1")
-        _APN("isp.cingular", "ISP@CINGULARGPRS.COM", "CINGULAR1")
+    {
+        /* Unicom */    U_CELL_APN_DB_KEY(460, 1, 2), 1, _APN("3gnet",,)
+        _APN("uninet", "uninet", "uninet")
     },
+#endif
 
+#if U_CELL_APN_DB_REGIONS & U_CELL_APN_DB_REGION_INTERNATIONAL
 // 901 International - INT
-    { /* Transatel */ "901-37", _APN("netgprs.com", "tsl", "tsl") },
+    { /* Transatel */  U_CELL_APN_DB_KEY(901, 37, 2), 1, _APN("netgprs.com", "tsl", "tsl") },
+#endif
 
-// 214 Spain
-    { /* Telefonica */       "214-07",
-        _APN("m2mtrial.telefonica.com",,) /* Cat-M1 */
-    },
+    // So that the table is never empty
+    {0xFFFFFFFF, 0, NULL}
 };
 
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
 
+/** Binary search the table for the given key.
+ *
+ * @param key  the key, see U_CELL_APN_DB_KEY().
+ * @return     the APN string or NULL if there is no match.
+ */
+static const char *pApnDbFind(uint32_t key)
+{
+    const char *pConfig = NULL;
+    size_t lower = 0;
+    size_t upper = (sizeof(gApnLookUpTable) / sizeof(*gApnLookUpTable)) - 1;
+    size_t x;
+
+    // Find the last entry whose key is no bigger than the one we're
+    // after by binary searching the entries below the end marker
+    while (lower < upper) {
+        x = lower + ((upper - lower) / 2);
+        if (gApnLookUpTable[x].key <= key) {
+            lower = x + 1;
+        } else {
+            upper = x;
+        }
+    }
+    // lower is now the first entry with a key that is bigger
+    if (lower > 0) {
+        x = lower - 1;
+        if (key < gApnLookUpTable[x].key + gApnLookUpTable[x].numMnc) {
+            pConfig = gApnLookUpTable[x].pCfg;
+        }
+    }
+
+    return pConfig;
+}
+
 /** Configuring APN by extraction from IMSI and matching the table.
  *
  * @param pImsi  string containing IMSI.
@@ -188,30 +280,30 @@ static const uCellNetApn_t gApnLookUpTable[] = {
 static const char *pApnGetConfig(const char *pImsi)
 {
     const char *pConfig = NULL;
-    const char *pStr;
-    size_t length;
+    uint32_t mcc = 0;
+    uint32_t mnc = 0;
+    size_t length = 0;
 
-    if ((pImsi != NULL) && (*pImsi != '\0')) {
+    if (pImsi != NULL) {
         // Many carriers use internet without username and password,
         // so use this as default now try to lookup the setting
-        // for our table
-        for (size_t x = 0; x < sizeof(gApnLookUpTable) / sizeof(*gApnLookUpTable) &&
-             !pConfig; x++) {
-            pStr = gApnLookUpTable[x].pMccMnc;
-            // Check the MCC
-            if (memcmp(pImsi, pStr, 3) == 0) {
-                pStr += 3;
-                // Check all the MNC, MNC length can be 2 or 3 digits
-                while (((*(pStr + 0) == '-') || (*(pStr + 0) == ',')) &&
-                       (*(pStr + 1) >= '0') && (*(pStr + 1) <= '9') &&
-                       (*(pStr + 2) >= '0') && (*(pStr + 2) <= '9') && !pConfig) {
-                    length = ((*(pStr + 3) >= '0') && (*(pStr + 3) <= '9')) ? 3 : 2;
-                    if (memcmp(pImsi + 3, pStr + 1, length) == 0) {
-                        pConfig = gApnLookUpTable[x].pCfg;
-                    }
-                    pStr += length + 1;
-                }
+        // for our table; the MCC is 3 digits and the MNC 2 or 3
+        // digits
+        while ((length < 6) && (*(pImsi + length) >= '0') && (*(pImsi + length) <= '9')) {
+            if (length < 3) {
+                mcc = (mcc * 10) + (*(pImsi + length) - '0');
+            } else {
+                mnc = (mnc * 10) + (*(pImsi + length) - '0');
             }
+            length++;
+        }
+        if (length == 6) {
+            // Try the three-digit MNC first
+            pConfig = pApnDbFind(U_CELL_APN_DB_KEY(mcc, mnc, 3));
+            mnc /= 10;
+        }
+        if ((pConfig == NULL) && (length >= 5)) {
+            pConfig = pApnDbFind(U_CELL_APN_DB_KEY(mcc, mnc, 2));
         }
     }
 
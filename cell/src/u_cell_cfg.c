@@ -58,6 +58,27 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The band masks as read from the module with AT+UBANDMASK?.
+ */
+typedef struct {
+    int32_t rats[U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS]; /**< in our RAT
+                                                              numbering,
+                                                              U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED
+                                                              where not
+                                                              present. */
+    uint64_t masks[U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS][2];
+} uCellCfgBandMasks_t;
+
+/** The current configuration of the module, as read by
+ * uCellCfgApply() in a batch.
+ */
+typedef struct {
+    const uCellPrivateInstance_t *pInstance;
+    int32_t mnoProfile;
+    uCellNetRat_t rats[U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS];
+    uCellCfgBandMasks_t bandMasks;
+} uCellCfgCurrent_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -274,7 +295,7 @@ static int32_t setCops(uAtClientHandle_t atHandle, int32_t cops)
 
 // Get the radio access technology that is being used by
 // the cellular module at the given rank, SARA-U2 style.
-// Note: gUCellPrivateMutex should be locked before this is called.
+// Note: the instance should be locked before this is called.
 static uCellNetRat_t getRatSaraU2(uCellPrivateInstance_t *pInstance,
                                   int32_t rank)
 {
@@ -349,7 +370,7 @@ static uCellNetRat_t getRatSaraU2(uCellPrivateInstance_t *pInstance,
 }
 
 // Get the rank at which the given RAT is being used, SARA-U2 style.
-// Note: gUCellPrivateMutex should be locked before this is called.
+// Note: the instance should be locked before this is called.
 static int32_t getRatRankSaraU2(uCellPrivateInstance_t *pInstance,
                                 uCellNetRat_t rat)
 {
@@ -417,7 +438,7 @@ static int32_t getRatRankSaraU2(uCellPrivateInstance_t *pInstance,
 }
 
 // Set RAT SARA-U2 stylee.
-// Note: gUCellPrivateMutex should be locked before this is called.
+// Note: the instance should be locked before this is called.
 static int32_t setRatSaraU2(uCellPrivateInstance_t *pInstance,
                             uCellNetRat_t rat)
 {
@@ -453,7 +474,7 @@ static int32_t setRatSaraU2(uCellPrivateInstance_t *pInstance,
 }
 
 // Set RAT rank SARA-U2 stylee.
-// Note: gUCellPrivateMutex should be locked before this is called.
+// Note: the instance should be locked before this is called.
 static int32_t setRatRankSaraU2(uCellPrivateInstance_t *pInstance,
                                 uCellNetRat_t rat, int32_t rank)
 {
@@ -630,7 +651,7 @@ static int32_t setRatRankSaraU2(uCellPrivateInstance_t *pInstance,
 
 // Get the radio access technology that is being used by
 // the cellular module at the given rank, SARA-R4/R5/R6 style.
-// Note: gUCellPrivateMutex should be locked before this is called.
+// Note: the instance should be locked before this is called.
 static uCellNetRat_t getRatSaraRx(const uCellPrivateInstance_t *pInstance,
                                   int32_t rank)
 {
@@ -667,7 +688,7 @@ static uCellNetRat_t getRatSaraRx(const uCellPrivateInstance_t *pInstance,
 }
 
 // Get the rank at which the given RAT is being used, SARA-R4/R5/R6 style.
-// Note: gUCellPrivateMutex should be locked before this is called.
+// Note: the instance should be locked before this is called.
 static int32_t getRatRankSaraRx(const uCellPrivateInstance_t *pInstance,
                                 uCellNetRat_t rat)
 {
@@ -695,7 +716,7 @@ static int32_t getRatRankSaraRx(const uCellPrivateInstance_t *pInstance,
 }
 
 // Set RAT SARA-R4/R5/R6 stylee.
-// Note: gUCellPrivateMutex should be locked before this is called.
+// Note: the instance should be locked before this is called.
 static int32_t setRatSaraRx(uCellPrivateInstance_t *pInstance,
                             uCellNetRat_t rat)
 {
@@ -728,40 +749,23 @@ static int32_t setRatSaraRx(uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
-// Set RAT rank SARA-R4/R5/R6 stylee.
-// Note: gUCellPrivateMutex should be locked before this is called.
-static int32_t setRatRankSaraRx(uCellPrivateInstance_t *pInstance,
-                                uCellNetRat_t rat, int32_t rank)
+// Set all of the RATs SARA-R4/R5/R6 stylee, in rank order, removing
+// duplicates; pRats must point to U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS
+// entries, which may be modified.
+// Note: the instance should be locked before this is called.
+static int32_t setRatsSaraRx(uCellPrivateInstance_t *pInstance,
+                             int32_t *pRats)
 {
     int32_t errorCode;
     uAtClientHandle_t atHandle = pInstance->atHandle;
-    int32_t rats[U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS];
     int32_t cFunMode = -1;
 
-    // Assume there are no RATs
-    for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
-        rats[x] = (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
-    }
-
-    // Get the existing RATs
-    for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
-        rats[x] = (int32_t) getRatSaraRx(pInstance, (int32_t) x);
-        if (rats[x] == (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
-            break;
-        }
-    }
-    // Overwrite the one we want to set
-    rats[rank] = (int32_t) rat;
-
-    uPortLog("U_CELL_CFG: setting the RAT at rank %d to"
-             " %d (in module terms %d).\n",
-             rank, rat, cellRatToModuleRat(pInstance->pModule->moduleType, rat));
     // Remove duplicates
-    for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
-        for (size_t y = x + 1; y < sizeof(rats) / sizeof(rats[0]); y++) {
-            if ((rats[x] > (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) &&
-                (rats[x] == rats[y])) {
-                rats[y] = (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+    for (size_t x = 0; x < U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS; x++) {
+        for (size_t y = x + 1; y < U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS; y++) {
+            if ((*(pRats + x) > (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) &&
+                (*(pRats + x) == *(pRats + y))) {
+                *(pRats + y) = (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
             }
         }
     }
@@ -776,18 +780,18 @@ static int32_t setRatRankSaraRx(uCellPrivateInstance_t *pInstance,
 
     // Send the AT command
     uPortLog("U_CELL_CFG: RATs (removing duplicates) become:\n");
-    for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
+    for (size_t x = 0; x < U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS; x++) {
         uPortLog("  rank[%d]: %d (in module terms %d).\n",
-                 x, rats[x], cellRatToModuleRat(pInstance->pModule->moduleType,
-                                                (uCellNetRat_t) rats[x]));
+                 x, *(pRats + x), cellRatToModuleRat(pInstance->pModule->moduleType,
+                                                     (uCellNetRat_t) *(pRats + x)));
     }
     uAtClientLock(atHandle);
     uAtClientCommandStart(atHandle, "AT+URAT=");
-    for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
-        if (rats[x] != (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+    for (size_t x = 0; x < U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS; x++) {
+        if (*(pRats + x) != (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
             uAtClientWriteInt(atHandle,
                               cellRatToModuleRat(pInstance->pModule->moduleType,
-                                                 (uCellNetRat_t) rats[x]));
+                                                 (uCellNetRat_t) *(pRats + x)));
         }
     }
     uAtClientCommandStopReadResponse(atHandle);
@@ -801,6 +805,35 @@ static int32_t setRatRankSaraRx(uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Set RAT rank SARA-R4/R5/R6 stylee.
+// Note: the instance should be locked before this is called.
+static int32_t setRatRankSaraRx(uCellPrivateInstance_t *pInstance,
+                                uCellNetRat_t rat, int32_t rank)
+{
+    int32_t rats[U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS];
+
+    // Assume there are no RATs
+    for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
+        rats[x] = (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+    }
+
+    // Get the existing RATs
+    for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
+        rats[x] = (int32_t) getRatSaraRx(pInstance, (int32_t) x);
+        if (rats[x] == (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+            break;
+        }
+    }
+    // Overwrite the one we want to set
+    rats[rank] = (int32_t) rat;
+
+    uPortLog("U_CELL_CFG: setting the RAT at rank %d to"
+             " %d (in module terms %d).\n",
+             rank, rat, cellRatToModuleRat(pInstance->pModule->moduleType, rat));
+
+    return setRatsSaraRx(pInstance, rats);
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: GENERAL
  * -------------------------------------------------------------- */
@@ -832,6 +865,420 @@ int32_t setAndStoreBaudRate(const uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Read the band masks from the response to AT+UBANDMASK?, which must
+// already have been started with uAtClientResponseStart(); this does
+// NOT call uAtClientResponseStop().
+static void readBandMasks(uAtClientHandle_t atHandle,
+                          uCellModuleType_t moduleType,
+                          uCellCfgBandMasks_t *pBandMasks)
+{
+    uint64_t i[6];
+    bool success = true;
+    size_t count = 0;
+
+    // Initialise locals
+    for (size_t x = 0; x < sizeof(i) / sizeof(i[0]); x++) {
+        i[x] = (uint64_t) -1;
+    }
+    memset(pBandMasks, 0, sizeof(*pBandMasks));
+    for (size_t x = 0; x < sizeof(pBandMasks->rats) / sizeof(pBandMasks->rats[0]); x++) {
+        pBandMasks->rats[x] = -1;
+    }
+
+    // The AT response here can be any one of the following:
+    //    0        1             2             3           4                 5
+    // <rat_a>,<bandmask_a0>
+    // <rat_a>,<bandmask_a0>,<bandmask_a1>
+    // <rat_a>,<bandmask_a0>,<rat_b>,      <bandmask_b0>
+    // <rat_a>,<bandmask_a0>,<bandmask_a1>,<rat_b>,      <bandmask_b0>
+    // <rat_a>,<bandmask_a0>,<rat_b>,      <bandmask_b0>,<bandmask_b1>                  <-- ASSUMED THIS CANNOT HAPPEN!!!
+    // <rat_a>,<bandmask_a0>,<bandmask_a1>,<rat_b>,      <bandmask_b0>,  <bandmask_b1>
+    //
+    // Since each entry is just a decimal number, how to tell which format
+    // is being used?
+    //
+    // Here's my algorithm:
+    // i.   Read i0 and i1, <rat_a> and <bandmask_a0>.
+    // ii.  Attempt to read i2: if is present it could be
+    //      <bandmask_a1> or <rat_b>, if not FINISH.
+    // iii. Attempt to read i3: if it is present then it is
+    //      either <bandmask_b0> or <rat_b>, if it
+    //      is not present then the i2 was <bandmask_a1> FINISH.
+    // iv.  Attempt to read i4 : if it is present then i2
+    //      was <bandmask_a1>, i3 was <rat_b> and i4 is
+    //      <bandmask_b0>, if it is not present then i2 was
+    //      <rat_b> and i3 was <bandmask_b0> FINISH.
+    // v.   Attempt to read i5: if it is present then it is
+    //      <bandmask_b1>.
+
+    // Read all the numbers in
+    for (size_t x = 0; (x < sizeof(i) / sizeof(i[0])) && success; x++) {
+        success = (uAtClientReadUint64(atHandle, &(i[x])) == 0);
+        if (success) {
+            count++;
+        }
+    }
+
+    // Point i, nice and simple, <rat_a> and <bandmask_a0>.
+    if (count >= 2) {
+        pBandMasks->rats[0] = (int32_t) i[0];
+        pBandMasks->masks[0][0] = i[1];
+    }
+    if (count >= 3) {
+        // Point ii, the "present" part.
+        if (count >= 4) {
+            // Point iii, the "present" part.
+            if (count >= 5) {
+                // Point iv, the "present" part, <bandmask_a1>,
+                // <rat_b> and <bandmask_b1>.
+                pBandMasks->masks[0][1] = i[2];
+                pBandMasks->rats[1] = (int32_t) i[3];
+                pBandMasks->masks[1][0] = i[4];
+                if (count >= 6) {
+                    // Point v, <bandmask_b1>.
+                    pBandMasks->masks[1][1] = i[5];
+                }
+            } else {
+                // Point iv, the "not present" part, <rat_b>
+                // and <bandmask_b0>.
+                pBandMasks->rats[1] = (int32_t) i[2];
+                pBandMasks->masks[1][0] = i[3];
+            }
+        } else {
+            // Point iii, the "not present" part, <bandmask_a1>.
+            pBandMasks->masks[0][1] = i[2];
+        }
+    } else {
+        // Point ii, the "not present" part, FINISH.
+    }
+
+    // Convert the RAT numbering to keep things simple on the brain
+    for (size_t x = 0; x < sizeof(pBandMasks->rats) / sizeof(pBandMasks->rats[0]); x++) {
+        pBandMasks->rats[x] = (int32_t) moduleRatBandMaskToCellRat(moduleType,
+                                                                   pBandMasks->rats[x]);
+    }
+}
+
+// Set the band mask for the given RAT.
+// Note: the instance should be locked before this is called.
+static int32_t setBandMask(uCellPrivateInstance_t *pInstance,
+                           uCellNetRat_t rat, uint64_t bandMask1,
+                           uint64_t bandMask2)
+{
+    int32_t errorCode;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+
+    uPortLog("U_CELL_CFG: setting band mask for RAT %d (in module"
+             " terms %d) to 0x%08x%08x %08x%08x.\n",
+             rat, cellRatToModuleRatBandMask(pInstance->pModule->moduleType, rat),
+             (uint32_t) (bandMask2 >> 32), (uint32_t) bandMask2,
+             (uint32_t) (bandMask1 >> 32), (uint32_t) bandMask1);
+    uAtClientLock(atHandle);
+    uAtClientCommandStart(atHandle, "AT+UBANDMASK=");
+    uAtClientWriteInt(atHandle, cellRatToModuleRatBandMask(pInstance->pModule->moduleType, rat));
+    uAtClientWriteUint64(atHandle, bandMask1);
+    uAtClientWriteUint64(atHandle, bandMask2);
+    uAtClientCommandStopReadResponse(atHandle);
+    errorCode = uAtClientUnlock(atHandle);
+    if (errorCode == 0) {
+        pInstance->rebootIsRequired = true;
+    }
+
+    return errorCode;
+}
+
+// Set the MNO profile.
+// Note: the instance should be locked before this is called.
+static int32_t setMnoProfile(uCellPrivateInstance_t *pInstance,
+                             int32_t mnoProfile)
+{
+    int32_t errorCode;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+
+    uAtClientLock(atHandle);
+    uAtClientCommandStart(atHandle, "AT+UMNOPROF=");
+    uAtClientWriteInt(atHandle, mnoProfile);
+    uAtClientCommandStopReadResponse(atHandle);
+    errorCode = uAtClientUnlock(atHandle);
+    if (errorCode == 0) {
+        pInstance->rebootIsRequired = true;
+        uPortLog("U_CELL_CFG: MNO profile set to %d.\n",
+                 mnoProfile);
+    } else {
+        uPortLog("U_CELL_CFG: unable to set MNO profile"
+                 " to %d.\n", mnoProfile);
+    }
+
+    return errorCode;
+}
+
+// Return true if the given RAT is one that can have a band mask
+// and is supported by the module.
+static bool bandMaskRatIsValid(const uCellPrivateInstance_t *pInstance,
+                               uCellNetRat_t rat)
+{
+    return ((rat == U_CELL_NET_RAT_CATM1) || (rat == U_CELL_NET_RAT_NB1) ||
+            (rat == U_CELL_NET_RAT_LTE) || (rat == U_CELL_NET_RAT_GSM_GPRS_EGPRS) ||
+            (rat == U_CELL_NET_RAT_UTRAN)) &&
+           (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) rat));
+}
+
+// Check that a desired configuration makes sense for the given module:
+// RATs must be supported, must not be repeated and must fill the ranks
+// from the top with no gaps.
+static bool desiredIsValid(const uCellPrivateInstance_t *pInstance,
+                           const uCellCfgDesired_t *pDesired)
+{
+    bool isValid = true;
+    uCellNetRat_t rat;
+
+    for (size_t x = 0; isValid && (x < U_CELL_CFG_DESIRED_MAX_NUM_RATS); x++) {
+        rat = pDesired->rat[x];
+        if (rat != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+            isValid = (rat > U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) &&
+                      (rat < U_CELL_NET_RAT_MAX_NUM) &&
+                      (x < pInstance->pModule->maxNumSimultaneousRats) &&
+                      ((x == 0) || (pDesired->rat[x - 1] != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED)) &&
+                      (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) rat));
+            for (size_t y = 0; isValid && (y < x); y++) {
+                isValid = (pDesired->rat[y] != rat);
+            }
+        }
+    }
+    for (size_t x = 0; isValid && (x < U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS); x++) {
+        rat = pDesired->bandMask[x].rat;
+        isValid = (rat == U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) ||
+                  bandMaskRatIsValid(pInstance, rat);
+    }
+
+    return isValid;
+}
+
+// Add a value to an FNV-1a hash, least significant byte first so that
+// the result does not depend on the endianness of the platform.
+static uint32_t fingerprintAdd(uint32_t hash, uint64_t value,
+                               size_t numBytes)
+{
+    for (size_t x = 0; x < numBytes; x++) {
+        hash ^= (uint32_t) (value & 0xFF);
+        hash *= 16777619UL;
+        value >>= 8;
+    }
+
+    return hash;
+}
+
+// Compute the fingerprint of a desired configuration for a given
+// module type; this is never zero.
+static uint32_t fingerprintGet(uCellModuleType_t moduleType,
+                               const uCellCfgDesired_t *pDesired)
+{
+    uint32_t hash = 2166136261UL;
+
+    hash = fingerprintAdd(hash, (uint64_t) moduleType, 4);
+    hash = fingerprintAdd(hash, (uint64_t) (int64_t) pDesired->mnoProfile, 4);
+    for (size_t x = 0; x < U_CELL_CFG_DESIRED_MAX_NUM_RATS; x++) {
+        hash = fingerprintAdd(hash, (uint64_t) pDesired->rat[x], 4);
+    }
+    for (size_t x = 0; x < U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS; x++) {
+        hash = fingerprintAdd(hash, (uint64_t) pDesired->bandMask[x].rat, 4);
+        if (pDesired->bandMask[x].rat != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+            hash = fingerprintAdd(hash, pDesired->bandMask[x].bandMask1, 8);
+            hash = fingerprintAdd(hash, pDesired->bandMask[x].bandMask2, 8);
+        }
+    }
+    if (hash == 0) {
+        // Zero is reserved for "no fingerprint"
+        hash = 1;
+    }
+
+    return hash;
+}
+
+// Parser for the AT+UMNOPROF? part of the batch sent by readCurrent().
+static int32_t parseMnoProfile(uAtClientHandle_t atHandle, size_t index,
+                               void *pParameter)
+{
+    uCellCfgCurrent_t *pCurrent = (uCellCfgCurrent_t *) pParameter;
+
+    (void) index;
+    pCurrent->mnoProfile = uAtClientReadInt(atHandle);
+
+    return (pCurrent->mnoProfile >= 0) ? 0 : (int32_t) U_CELL_ERROR_AT;
+}
+
+// Parser for the AT+URAT? part of the batch sent by readCurrent().
+static int32_t parseRats(uAtClientHandle_t atHandle, size_t index,
+                         void *pParameter)
+{
+    uCellCfgCurrent_t *pCurrent = (uCellCfgCurrent_t *) pParameter;
+    const uCellPrivateModule_t *pModule = pCurrent->pInstance->pModule;
+
+    (void) index;
+    // Read up to N integers representing the RATs; there may
+    // be fewer than N, which is not an error
+    for (size_t x = 0; x < pModule->maxNumSimultaneousRats; x++) {
+        pCurrent->rats[x] = uCellPrivateModuleRatToCellRat(pModule->moduleType,
+                                                           uAtClientReadInt(atHandle));
+    }
+
+    return 0;
+}
+
+// Parser for the AT+UBANDMASK? part of the batch sent by readCurrent().
+static int32_t parseBandMasks(uAtClientHandle_t atHandle, size_t index,
+                              void *pParameter)
+{
+    uCellCfgCurrent_t *pCurrent = (uCellCfgCurrent_t *) pParameter;
+
+    (void) index;
+    readBandMasks(atHandle, pCurrent->pInstance->pModule->moduleType,
+                  &(pCurrent->bandMasks));
+
+    return 0;
+}
+
+// Read, in a single batch, those parts of the current configuration
+// of the module that the desired configuration refers to.
+// Note: the instance should be locked before this is called.
+static int32_t readCurrent(const uCellPrivateInstance_t *pInstance,
+                           const uCellCfgDesired_t *pDesired,
+                           uCellCfgCurrent_t *pCurrent)
+{
+    int32_t errorCode = 0;
+    uAtClientBatchCommand_t commands[3];
+    size_t numCommands = 0;
+    bool readBandMask = false;
+
+    memset(pCurrent, 0, sizeof(*pCurrent));
+    pCurrent->pInstance = pInstance;
+    pCurrent->mnoProfile = -1;
+    for (size_t x = 0; x < U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS; x++) {
+        if (pDesired->bandMask[x].rat != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+            readBandMask = true;
+        }
+    }
+
+    if (pDesired->mnoProfile >= 0) {
+        commands[numCommands].pCommand = "AT+UMNOPROF?";
+        commands[numCommands].pResponsePrefix = "+UMNOPROF:";
+        commands[numCommands].pParser = parseMnoProfile;
+        commands[numCommands].pParserParam = (void *) pCurrent;
+        numCommands++;
+    }
+    if (pDesired->rat[0] != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+        commands[numCommands].pCommand = "AT+URAT?";
+        commands[numCommands].pResponsePrefix = "+URAT:";
+        commands[numCommands].pParser = parseRats;
+        commands[numCommands].pParserParam = (void *) pCurrent;
+        numCommands++;
+    }
+    if (readBandMask) {
+        commands[numCommands].pCommand = "AT+UBANDMASK?";
+        commands[numCommands].pResponsePrefix = "+UBANDMASK:";
+        commands[numCommands].pParser = parseBandMasks;
+        commands[numCommands].pParserParam = (void *) pCurrent;
+        numCommands++;
+    }
+
+    if (numCommands > 0) {
+        errorCode = (int32_t) U_CELL_ERROR_AT;
+        if (uAtClientBatch(pInstance->atHandle, commands,
+                           numCommands, true) == (int32_t) numCommands) {
+            errorCode = 0;
+        }
+    }
+
+    return errorCode;
+}
+
+// Apply the difference between the desired configuration and that
+// of the module, returning the number of settings changed; *pComplete
+// is set to false if the MNO profile was changed, in which case
+// nothing else is done.
+// Note: the instance should be locked before this is called.
+static int32_t applyDesired(uCellPrivateInstance_t *pInstance,
+                            const uCellCfgDesired_t *pDesired,
+                            bool *pComplete)
+{
+    int32_t errorCodeOrCount;
+    uCellCfgCurrent_t current;
+    int32_t rats[U_CELL_PRIVATE_MAX_NUM_SIMULTANEOUS_RATS];
+    bool setRats = false;
+    uCellNetRat_t rat;
+    bool found;
+    int32_t count = 0;
+
+    *pComplete = true;
+    errorCodeOrCount = readCurrent(pInstance, pDesired, &current);
+    if ((errorCodeOrCount == 0) && (pDesired->mnoProfile >= 0) &&
+        (current.mnoProfile != pDesired->mnoProfile)) {
+        // The MNO profile is done first, and on its own, since
+        // moving to a new profile will, on the next boot, overwrite
+        // the RATs and band masks with the defaults of that profile
+        errorCodeOrCount = setMnoProfile(pInstance, pDesired->mnoProfile);
+        if (errorCodeOrCount == 0) {
+            count++;
+            *pComplete = false;
+        }
+    }
+
+    if ((errorCodeOrCount == 0) && *pComplete &&
+        (pDesired->rat[0] != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED)) {
+        // Now the RATs, which are written all at once, if any differ
+        for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
+            rats[x] = (int32_t) U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+            if (x < U_CELL_CFG_DESIRED_MAX_NUM_RATS) {
+                rats[x] = (int32_t) pDesired->rat[x];
+            }
+            if (rats[x] != (int32_t) current.rats[x]) {
+                setRats = true;
+            }
+        }
+        if (setRats) {
+            errorCodeOrCount = setRatsSaraRx(pInstance, rats);
+            if (errorCodeOrCount == 0) {
+                pInstance->rebootIsRequired = true;
+                count++;
+            }
+        }
+    }
+
+    for (size_t x = 0; (errorCodeOrCount == 0) && *pComplete &&
+         (x < U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS); x++) {
+        // Finally the band masks, only those that differ
+        rat = pDesired->bandMask[x].rat;
+        if (rat != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+            if ((pInstance->pModule->moduleType == U_CELL_MODULE_TYPE_LARA_R6) &&
+                (rat == U_CELL_NET_RAT_UTRAN)) {
+                // LARA-R6 uses the same band-mask number for both 2G
+                // and 3G, which readBandMasks() will have converted
+                // to our 2G RAT number
+                rat = U_CELL_NET_RAT_GSM_GPRS_EGPRS;
+            }
+            found = false;
+            for (size_t y = 0; !found && (y < U_CELL_CFG_DESIRED_MAX_NUM_BAND_MASKS); y++) {
+                found = (current.bandMasks.rats[y] == (int32_t) rat) &&
+                        (current.bandMasks.masks[y][0] == pDesired->bandMask[x].bandMask1) &&
+                        (current.bandMasks.masks[y][1] == pDesired->bandMask[x].bandMask2);
+            }
+            if (!found) {
+                errorCodeOrCount = setBandMask(pInstance, pDesired->bandMask[x].rat,
+                                               pDesired->bandMask[x].bandMask1,
+                                               pDesired->bandMask[x].bandMask2);
+                if (errorCodeOrCount == 0) {
+                    count++;
+                }
+            }
+        }
+    }
+
+    if (errorCodeOrCount == 0) {
+        errorCodeOrCount = count;
+    }
+
+    return errorCodeOrCount;
+}
 
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
@@ -845,44 +1292,23 @@ int32_t uCellCfgSetBandMask(uDeviceHandle_t cellHandle,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        if ((pInstance != NULL) &&
-            ((rat == U_CELL_NET_RAT_CATM1) || (rat == U_CELL_NET_RAT_NB1) ||
-             (rat == U_CELL_NET_RAT_LTE) || (rat == U_CELL_NET_RAT_GSM_GPRS_EGPRS) ||
-             (rat == U_CELL_NET_RAT_UTRAN)) &&
-            (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) rat))) {
+        if ((pInstance != NULL) && bandMaskRatIsValid(pInstance, rat)) {
             errorCode = (int32_t) U_CELL_ERROR_CONNECTED;
             if (!uCellPrivateIsRegistered(pInstance)) {
-                atHandle = pInstance->atHandle;
-                uPortLog("U_CELL_CFG: setting band mask for RAT %d (in module"
-                         " terms %d) to 0x%08x%08x %08x%08x.\n",
-                         rat, cellRatToModuleRatBandMask(pInstance->pModule->moduleType, rat),
-                         (uint32_t) (bandMask2 >> 32), (uint32_t) bandMask2,
-                         (uint32_t) (bandMask1 >> 32), (uint32_t) bandMask1);
-                uAtClientLock(atHandle);
-                uAtClientCommandStart(atHandle, "AT+UBANDMASK=");
-                uAtClientWriteInt(atHandle, cellRatToModuleRatBandMask(pInstance->pModule->moduleType, rat));
-                uAtClientWriteUint64(atHandle, bandMask1);
-                uAtClientWriteUint64(atHandle, bandMask2);
-                uAtClientCommandStopReadResponse(atHandle);
-                errorCode = uAtClientUnlock(atHandle);
-                if (errorCode == 0) {
-                    pInstance->rebootIsRequired = true;
-                }
+                errorCode = setBandMask(pInstance, rat, bandMask1, bandMask2);
             } else {
                 uPortLog("U_CELL_CFG: unable to set band mask as we are"
                          " connected to the network.\n");
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -897,34 +1323,17 @@ int32_t uCellCfgGetBandMask(uDeviceHandle_t cellHandle,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
     uAtClientHandle_t atHandle;
-    uint64_t i[6];
-    uint64_t masks[2][2];
-    int32_t rats[2];
-    bool success = true;
-    size_t count = 0;
+    uCellCfgBandMasks_t bandMasks;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) &&
-            ((rat == U_CELL_NET_RAT_CATM1) || (rat == U_CELL_NET_RAT_NB1) ||
-             (rat == U_CELL_NET_RAT_LTE) || (rat == U_CELL_NET_RAT_GSM_GPRS_EGPRS) ||
-             (rat == U_CELL_NET_RAT_UTRAN)) &&
             (pBandMask1 != NULL) && (pBandMask2 != NULL) &&
-            (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) rat))) {
+            bandMaskRatIsValid(pInstance, rat)) {
             errorCode = (int32_t) U_CELL_ERROR_AT;
-            // Initialise locals
-            for (size_t x = 0; x < sizeof(i) / sizeof(i[0]); x++) {
-                i[x] = (uint64_t) -1;
-            }
-            memset(masks, 0, sizeof(masks));
-            for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
-                rats[x] = -1;
-            }
-
             atHandle = pInstance->atHandle;
             uPortLog("U_CELL_CFG: getting band mask for RAT %d (in module terms %d).\n",
                      rat, cellRatToModuleRatBandMask(pInstance->pModule->moduleType, rat));
@@ -932,84 +1341,14 @@ int32_t uCellCfgGetBandMask(uDeviceHandle_t cellHandle,
             uAtClientCommandStart(atHandle, "AT+UBANDMASK?");
             uAtClientCommandStop(atHandle);
             uAtClientResponseStart(atHandle, "+UBANDMASK:");
-            // The AT response here can be any one of the following:
-            //    0        1             2             3           4                 5
-            // <rat_a>,<bandmask_a0>
-            // <rat_a>,<bandmask_a0>,<bandmask_a1>
-            // <rat_a>,<bandmask_a0>,<rat_b>,      <bandmask_b0>
-            // <rat_a>,<bandmask_a0>,<bandmask_a1>,<rat_b>,      <bandmask_b0>
-            // <rat_a>,<bandmask_a0>,<rat_b>,      <bandmask_b0>,<bandmask_b1>                  <-- ASSUMED THIS CANNOT HAPPEN!!!
-            // <rat_a>,<bandmask_a0>,<bandmask_a1>,<rat_b>,      <bandmask_b0>,  <bandmask_b1>
-            //
-            // Since each entry is just a decimal number, how to tell which format
-            // is being used?
-            //
-            // Here's my algorithm:
-            // i.   Read i0 and i1, <rat_a> and <bandmask_a0>.
-            // ii.  Attempt to read i2: if is present it could be
-            //      <bandmask_a1> or <rat_b>, if not FINISH.
-            // iii. Attempt to read i3: if it is present then it is
-            //      either <bandmask_b0> or <rat_b>, if it
-            //      is not present then the i2 was <bandmask_a1> FINISH.
-            // iv.  Attempt to read i4 : if it is present then i2
-            //      was <bandmask_a1>, i3 was <rat_b> and i4 is
-            //      <bandmask_b0>, if it is not present then i2 was
-            //      <rat_b> and i3 was <bandmask_b0> FINISH.
-            // v.   Attempt to read i5: if it is present then it is
-            //      <bandmask_b1>.
-
-            // Read all the numbers in
-            for (size_t x = 0; (x < sizeof(i) / sizeof(i[0])) && success; x++) {
-                success = (uAtClientReadUint64(atHandle, &(i[x])) == 0);
-                if (success) {
-                    count++;
-                }
-            }
+            readBandMasks(atHandle, pInstance->pModule->moduleType, &bandMasks);
             uAtClientResponseStop(atHandle);
             uAtClientUnlock(atHandle);
 
-            // Point i, nice and simple, <rat_a> and <bandmask_a0>.
-            if (count >= 2) {
-                rats[0] = (int32_t) i[0];
-                masks[0][0] = i[1];
-            }
-            if (count >= 3) {
-                // Point ii, the "present" part.
-                if (count >= 4) {
-                    // Point iii, the "present" part.
-                    if (count >= 5) {
-                        // Point iv, the "present" part, <bandmask_a1>,
-                        // <rat_b> and <bandmask_b1>.
-                        masks[0][1] = i[2];
-                        rats[1] = (int32_t) i[3];
-                        masks[1][0] = i[4];
-                        if (count >= 6) {
-                            // Point v, <bandmask_b1>.
-                            masks[1][1] = i[5];
-                        }
-                    } else {
-                        // Point iv, the "not present" part, <rat_b>
-                        // and <bandmask_b0>.
-                        rats[1] = (int32_t) i[2];
-                        masks[1][0] = i[3];
-                    }
-                } else {
-                    // Point iii, the "not present" part, <bandmask_a1>.
-                    masks[0][1] = i[2];
-                }
-            } else {
-                // Point ii, the "not present" part, FINISH.
-            }
-
-            // Convert the RAT numbering to keep things simple on the brain
-            for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
-                rats[x] = (int32_t) moduleRatBandMaskToCellRat(pInstance->pModule->moduleType, rats[x]);
-            }
-
             if (pInstance->pModule->moduleType == U_CELL_MODULE_TYPE_LARA_R6) {
                 // LARA-R6 uses the same band-mask number for both 2G and 3G, which
                 // will have been converted to our 2G RAT number by
-                // moduleRatBandMaskToCellRat() so, if the user has asked for
+                // readBandMasks() so, if the user has asked for
                 // U_CELL_NET_RAT_UTRAN then switch it
                 if (rat == U_CELL_NET_RAT_UTRAN) {
                     rat = U_CELL_NET_RAT_GSM_GPRS_EGPRS;
@@ -1017,10 +1356,10 @@ int32_t uCellCfgGetBandMask(uDeviceHandle_t cellHandle,
             }
 
             // Fill in the answers
-            for (size_t x = 0; x < sizeof(rats) / sizeof(rats[0]); x++) {
-                if (rats[x] == (int32_t) rat) {
-                    *pBandMask1 = masks[x][0];
-                    *pBandMask2 = masks[x][1];
+            for (size_t x = 0; x < sizeof(bandMasks.rats) / sizeof(bandMasks.rats[0]); x++) {
+                if (bandMasks.rats[x] == (int32_t) rat) {
+                    *pBandMask1 = bandMasks.masks[x][0];
+                    *pBandMask2 = bandMasks.masks[x][1];
                     uPortLog("U_CELL_CFG: band mask for RAT %d (in module terms %d)"
                              " is 0x%08x%08x %08x%08x.\n",
                              rat, cellRatToModuleRat(pInstance->pModule->moduleType, rat),
@@ -1031,7 +1370,7 @@ int32_t uCellCfgGetBandMask(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1047,9 +1386,8 @@ int32_t uCellCfgSetRat(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) &&
             (rat > U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) &&
@@ -1075,7 +1413,7 @@ int32_t uCellCfgSetRat(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1091,9 +1429,8 @@ int32_t uCellCfgSetRatRank(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) &&
             /* U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED is allowed here */
@@ -1121,7 +1458,7 @@ int32_t uCellCfgSetRatRank(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1137,9 +1474,8 @@ uCellNetRat_t uCellCfgGetRat(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrRat = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (rank >= 0) &&
             (rank < (int32_t) pInstance->pModule->maxNumSimultaneousRats)) {
@@ -1154,7 +1490,7 @@ uCellNetRat_t uCellCfgGetRat(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return (uCellNetRat_t) errorCodeOrRat;
@@ -1170,9 +1506,8 @@ int32_t uCellCfgGetRatRank(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrRank = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) &&
             (rat > U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) &&
@@ -1197,7 +1532,7 @@ int32_t uCellCfgGetRatRank(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrRank;
@@ -1209,38 +1544,23 @@ int32_t uCellCfgSetMnoProfile(uDeviceHandle_t cellHandle,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (mnoProfile >= 0)) {
             errorCode = (int32_t) U_CELL_ERROR_CONNECTED;
             if (!uCellPrivateIsRegistered(pInstance)) {
-                atHandle = pInstance->atHandle;
-                uAtClientLock(atHandle);
-                uAtClientCommandStart(atHandle, "AT+UMNOPROF=");
-                uAtClientWriteInt(atHandle, mnoProfile);
-                uAtClientCommandStopReadResponse(atHandle);
-                errorCode = uAtClientUnlock(atHandle);
-                if (errorCode == 0) {
-                    pInstance->rebootIsRequired = true;
-                    uPortLog("U_CELL_CFG: MNO profile set to %d.\n",
-                             mnoProfile);
-                } else {
-                    uPortLog("U_CELL_CFG: unable to set MNO profile"
-                             " to %d.\n", mnoProfile);
-                }
+                errorCode = setMnoProfile(pInstance, mnoProfile);
             } else {
                 uPortLog("U_CELL_CFG: unable to set MNO Profile as we are"
                          " connected to the network.\n");
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1256,9 +1576,8 @@ int32_t uCellCfgGetMnoProfile(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrMnoProfile = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
@@ -1277,12 +1596,66 @@ int32_t uCellCfgGetMnoProfile(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrMnoProfile;
 }
 
+// Apply a complete desired configuration to the module.
+int32_t uCellCfgApply(uDeviceHandle_t cellHandle,
+                      const uCellCfgDesired_t *pDesired,
+                      uint32_t *pFingerprint)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uint32_t fingerprint;
+    bool complete = false;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pDesired != NULL) &&
+            desiredIsValid(pInstance, pDesired)) {
+            errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            // SARA-U201 has neither AT+UMNOPROF nor AT+UBANDMASK
+            // and its AT+URAT is a different beast entirely
+            if ((pInstance->pModule->moduleType != U_CELL_MODULE_TYPE_SARA_U201) &&
+                ((pDesired->mnoProfile < 0) ||
+                 U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                    U_CELL_PRIVATE_FEATURE_MNO_PROFILE))) {
+                fingerprint = fingerprintGet(pInstance->pModule->moduleType, pDesired);
+                errorCodeOrCount = 0;
+                if ((pFingerprint == NULL) || (*pFingerprint != fingerprint)) {
+                    errorCodeOrCount = (int32_t) U_CELL_ERROR_CONNECTED;
+                    if (!uCellPrivateIsRegistered(pInstance)) {
+                        errorCodeOrCount = applyDesired(pInstance, pDesired, &complete);
+                        if (errorCodeOrCount >= 0) {
+                            uPortLog("U_CELL_CFG: %d configuration setting(s)"
+                                     " changed.\n", errorCodeOrCount);
+                            if (complete && (pFingerprint != NULL)) {
+                                *pFingerprint = fingerprint;
+                            }
+                        }
+                    } else {
+                        uPortLog("U_CELL_CFG: unable to apply configuration"
+                                 " as we are connected to the network.\n");
+                    }
+                } else {
+                    uPortLog("U_CELL_CFG: configuration fingerprint 0x%08x"
+                             " matches, nothing to do.\n", fingerprint);
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrCount;
+}
+
 // Configure serial interface
 int32_t uCellCfgSetSerialInterface(uDeviceHandle_t cellHandle, int32_t requestedVariant)
 {
@@ -1292,9 +1665,8 @@ int32_t uCellCfgSetSerialInterface(uDeviceHandle_t cellHandle, int32_t requested
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
             // Lock mutex before using AT client.
@@ -1312,7 +1684,7 @@ int32_t uCellCfgSetSerialInterface(uDeviceHandle_t cellHandle, int32_t requested
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1328,9 +1700,8 @@ int32_t uCellCfgGetActiveSerialInterface(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrActiveVariant = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
@@ -1352,7 +1723,7 @@ int32_t uCellCfgGetActiveSerialInterface(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrActiveVariant;
@@ -1368,9 +1739,8 @@ int32_t uCellCfgSetUdconf(uDeviceHandle_t cellHandle, int32_t param1,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (param1 >= 0) && (param2 >= 0)) {
             atHandle = pInstance->atHandle;
@@ -1388,7 +1758,7 @@ int32_t uCellCfgSetUdconf(uDeviceHandle_t cellHandle, int32_t param1,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1406,9 +1776,8 @@ int32_t uCellCfgGetUdconf(uDeviceHandle_t cellHandle, int32_t param1,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrUdconf = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (param1 >= 0)) {
             atHandle = pInstance->atHandle;
@@ -1435,7 +1804,7 @@ int32_t uCellCfgGetUdconf(uDeviceHandle_t cellHandle, int32_t param1,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrUdconf;
@@ -1453,9 +1822,8 @@ int32_t uCellCfgFactoryReset(uDeviceHandle_t cellHandle, int32_t fsRestoreType,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
             // Lock mutex before using AT client.
@@ -1476,7 +1844,7 @@ int32_t uCellCfgFactoryReset(uDeviceHandle_t cellHandle, int32_t fsRestoreType,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1496,9 +1864,8 @@ int32_t uCellCfgSetGreeting(uDeviceHandle_t cellHandle, const char *pStr)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
             uAtClientLock(atHandle);
@@ -1511,7 +1878,7 @@ int32_t uCellCfgSetGreeting(uDeviceHandle_t cellHandle, const char *pStr)
             errorCode = uAtClientUnlock(atHandle);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1528,9 +1895,8 @@ int32_t uCellCfgGetGreeting(uDeviceHandle_t cellHandle, char *pStr, size_t size)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && (pStr != NULL)) {
             atHandle = pInstance->atHandle;
             uAtClientLock(atHandle);
@@ -1556,7 +1922,7 @@ int32_t uCellCfgGetGreeting(uDeviceHandle_t cellHandle, char *pStr, size_t size)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -1572,9 +1938,8 @@ int32_t uCellCfgSetAutoBaudOff(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
@@ -1596,7 +1961,7 @@ int32_t uCellCfgSetAutoBaudOff(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1610,9 +1975,8 @@ int32_t uCellCfgSetAutoBaudOn(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -1623,7 +1987,7 @@ int32_t uCellCfgSetAutoBaudOn(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1641,9 +2005,8 @@ bool uCellCfgAutoBaudIsOn(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) &&
             U_CELL_PRIVATE_HAS(pInstance->pModule,
                                U_CELL_PRIVATE_FEATURE_AUTO_BAUDING)) {
@@ -1683,10 +2046,40 @@ bool uCellCfgAutoBaudIsOn(uDeviceHandle_t cellHandle)
             uAtClientUnlock(atHandle);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return autoBaudOn;
 }
 
+// Set the baud rate of the cellular module, not storing it.
+int32_t uCellCfgSetBaudRate(uDeviceHandle_t cellHandle, int32_t baudRate)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (baudRate > 0)) {
+            atHandle = pInstance->atHandle;
+            uAtClientLock(atHandle);
+            uAtClientCommandStart(atHandle, "AT+IPR=");
+            uAtClientWriteInt(atHandle, baudRate);
+            uAtClientCommandStopReadResponse(atHandle);
+            errorCode = uAtClientUnlock(atHandle);
+            if (errorCode == 0) {
+                uPortLog("U_CELL_CFG: baud rate set to %d.\n", baudRate);
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
 // End of file
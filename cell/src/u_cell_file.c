@@ -58,6 +58,180 @@ static uCellPrivateFileListContainer_t *gpFileList = NULL;
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Read the size of a file with AT+ULSTFILE; the returned value
+// should only be believed if the AT client has no error afterwards.
+// The AT client must be locked before this is called.
+static int32_t fileSizeGet(uAtClientHandle_t atHandle,
+                           const char *pFileName,
+                           const char *pFileSystemTag)
+{
+    int32_t size;
+
+    uAtClientCommandStart(atHandle, "AT+ULSTFILE=");
+    // Write get file size op_code
+    uAtClientWriteInt(atHandle, 2);
+    // Write file name
+    uAtClientWriteString(atHandle, pFileName, true);
+    if (pFileSystemTag != NULL) {
+        // Write tag
+        uAtClientWriteString(atHandle, pFileSystemTag, true);
+    }
+    uAtClientCommandStop(atHandle);
+    // Grab the response
+    uAtClientResponseStart(atHandle, "+ULSTFILE:");
+    // Read file size
+    size = uAtClientReadInt(atHandle);
+    uAtClientResponseStop(atHandle);
+
+    return size;
+}
+
+// Read one block of a file with AT+URDBLOCK, passing it to pCallback
+// in pieces of up to bufferSize bytes; returns the number of bytes
+// passed to pCallback, *pKeepGoing being set to false if pCallback
+// asks to stop or the module returns less than was asked for.
+// The AT client must be locked before this is called.
+static size_t readStreamBlock(const uCellPrivateInstance_t *pInstance,
+                              const char *pFileName,
+                              size_t offset, size_t blockSize,
+                              size_t fileSize,
+                              char *pBuffer, size_t bufferSize,
+                              bool (*pCallback) (const char *, size_t,
+                                                 size_t, size_t,
+                                                 void *),
+                              void *pCallbackParam,
+                              bool *pKeepGoing)
+{
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    int32_t indicatedReadSize;
+    size_t bytesRead = 0;
+    size_t bytesDelivered = 0;
+    size_t thisSize;
+    bool wanted = true;
+
+    uAtClientCommandStart(atHandle, "AT+URDBLOCK=");
+    // Write file name
+    uAtClientWriteString(atHandle, pFileName, true);
+    // Write offset in bytes from the beginning of the file
+    uAtClientWriteInt(atHandle, (int32_t) offset);
+    // Write size of data to be read from file
+    uAtClientWriteInt(atHandle, (int32_t) blockSize);
+    uAtClientCommandStop(atHandle);
+    // Grab the response
+    if (U_CELL_PRIVATE_MODULE_IS_SARA_R4(pInstance->pModule->moduleType)) {
+        // SARA-R4 only puts \n before the
+        // response, not \r\n as it should
+        uAtClientResponseStart(atHandle, "\n+URDBLOCK:");
+    } else {
+        uAtClientResponseStart(atHandle, "+URDBLOCK:");
+    }
+    // Skip the file name
+    uAtClientSkipParameters(atHandle, 1);
+    // Read the size
+    indicatedReadSize = uAtClientReadInt(atHandle);
+    if (indicatedReadSize < (int32_t) blockSize) {
+        *pKeepGoing = false;
+    }
+    // Don't stop for anything!
+    uAtClientIgnoreStopTag(atHandle);
+    // Get the leading quote mark out of the way
+    uAtClientReadBytes(atHandle, NULL, 1, true);
+    // Now read out all the data, a buffer-full at a time,
+    // pouring it away to NULL if pCallback has had enough
+    while ((indicatedReadSize > 0) &&
+           (bytesRead < (size_t) (unsigned) indicatedReadSize)) {
+        thisSize = (size_t) (unsigned) indicatedReadSize - bytesRead;
+        if (thisSize > bufferSize) {
+            thisSize = bufferSize;
+        }
+        if (wanted &&
+            (uAtClientReadBytes(atHandle, pBuffer, thisSize, true) == (int32_t) thisSize)) {
+            bytesDelivered += thisSize;
+            wanted = pCallback(pBuffer, thisSize, offset + bytesRead,
+                               fileSize, pCallbackParam);
+        } else {
+            uAtClientReadBytes(atHandle, NULL, thisSize, true);
+            wanted = false;
+        }
+        if (!wanted) {
+            *pKeepGoing = false;
+        }
+        bytesRead += thisSize;
+    }
+    // Make sure to wait for the stop tag before
+    // we finish
+    uAtClientRestoreStopTag(atHandle);
+    uAtClientResponseStop(atHandle);
+
+    return bytesDelivered;
+}
+
+// Write one block of a file with AT+UDWNFILE, obtaining the data
+// from pCallback in pieces of up to bufferSize bytes; returns the
+// number of bytes provided by pCallback, *pKeepGoing being set to
+// false if pCallback does not provide all that it is asked for,
+// in which case the rest of the block is padded with zeroes.
+// The AT client must be locked before this is called.
+static size_t writeStreamBlock(const uCellPrivateInstance_t *pInstance,
+                               const char *pFileName,
+                               size_t offset, size_t blockSize,
+                               char *pBuffer, size_t bufferSize,
+                               int32_t (*pCallback) (char *, size_t,
+                                                     size_t, void *),
+                               void *pCallbackParam,
+                               bool *pKeepGoing)
+{
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    size_t bytesSent = 0;
+    size_t bytesProvided = 0;
+    size_t thisSize;
+
+    uAtClientCommandStart(atHandle, "AT+UDWNFILE=");
+    // Write file name
+    uAtClientWriteString(atHandle, pFileName, true);
+    // Write size of data to be written into the file
+    uAtClientWriteInt(atHandle, (int32_t) blockSize);
+    if (pInstance->pFileSystemTag != NULL) {
+        // Write tag
+        uAtClientWriteString(atHandle, pInstance->pFileSystemTag, true);
+    }
+    uAtClientCommandStop(atHandle);
+    // Wait for the prompt
+    if (uAtClientWaitCharacter(atHandle, '>') == 0) {
+        // Allow plenty of time for this to complete
+        uAtClientTimeoutSet(atHandle, 10000);
+        uPortTaskBlock(50);
+        while (bytesSent < blockSize) {
+            thisSize = blockSize - bytesSent;
+            if (thisSize > bufferSize) {
+                thisSize = bufferSize;
+            }
+            if (*pKeepGoing &&
+                (pCallback(pBuffer, thisSize, offset + bytesSent,
+                           pCallbackParam) == (int32_t) thisSize)) {
+                bytesProvided += thisSize;
+            } else {
+                // The module has to be given the whole block
+                memset(pBuffer, 0, thisSize);
+                *pKeepGoing = false;
+            }
+            uAtClientWriteBytes(atHandle, pBuffer, thisSize, true);
+            bytesSent += thisSize;
+        }
+        // Restore at client timeout to default
+        uAtClientTimeoutSet(atHandle, U_AT_CLIENT_DEFAULT_TIMEOUT_MS);
+        // Grab the response
+        uAtClientCommandStopReadResponse(atHandle);
+    } else {
+        // Best to tidy whatever might have arrived instead
+        // of the prompt before exiting
+        uAtClientResponseStop(atHandle);
+        *pKeepGoing = false;
+    }
+
+    return bytesProvided;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -70,9 +244,8 @@ int32_t uCellFileSetTag(uDeviceHandle_t cellHandle, const char *pTag)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -83,7 +256,7 @@ int32_t uCellFileSetTag(uDeviceHandle_t cellHandle, const char *pTag)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -97,14 +270,13 @@ const char *pUCellFileGetTag(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance !=  NULL) {
             pFileSystemTag = pInstance->pFileSystemTag;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return pFileSystemTag;
@@ -123,9 +295,8 @@ int32_t uCellFileWrite(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         // Check parameters
         if ((pInstance != NULL) && (pData !=  NULL) && (pFileName != NULL) &&
@@ -157,6 +328,10 @@ int32_t uCellFileWrite(uDeviceHandle_t cellHandle,
                 uAtClientCommandStopReadResponse(atHandle);
                 if (uAtClientUnlock(atHandle) == 0) {
                     errorCode = (int32_t) bytesWritten;
+                    uCellPrivateFileCacheWritten(pInstance, pFileName, bytesWritten);
+                } else {
+                    // Don't know what the file looks like now
+                    uCellPrivateFileCacheClear(pInstance);
                 }
             } else {
                 // Best to tidy whatever might have arrived instead
@@ -166,7 +341,7 @@ int32_t uCellFileWrite(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -186,9 +361,8 @@ int32_t uCellFileRead(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         // Check parameters
         if ((pInstance != NULL) && (pData !=  NULL) && (pFileName != NULL) &&
@@ -247,7 +421,7 @@ int32_t uCellFileRead(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -268,9 +442,8 @@ int32_t uCellFileBlockRead(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         // Check parameters
         if ((pInstance != NULL) && (pData !=  NULL) && (pFileName != NULL) &&
@@ -334,55 +507,227 @@ int32_t uCellFileBlockRead(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
 }
 
-// Read file size.
-int32_t uCellFileSize(uDeviceHandle_t cellHandle,
-                      const char *pFileName)
+// Switch the file cache on or off.
+int32_t uCellFileCacheSet(uDeviceHandle_t cellHandle, bool onNotOff)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (!onNotOff) {
+                uCellPrivateFileCacheRemoveContext(pInstance);
+            } else if (pInstance->pFileCache == NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pInstance->pFileCache = (uCellPrivateFileCache_t *) malloc(sizeof(*(pInstance->pFileCache)));
+                if (pInstance->pFileCache != NULL) {
+                    memset(pInstance->pFileCache, 0, sizeof(*(pInstance->pFileCache)));
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Invalidate the file cache.
+int32_t uCellFileCacheInvalidate(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            uCellPrivateFileCacheClear(pInstance);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Read a file as a stream.
+int32_t uCellFileReadStream(uDeviceHandle_t cellHandle,
+                            const char *pFileName,
+                            size_t offset,
+                            char *pBuffer,
+                            size_t bufferSize,
+                            bool (*pCallback) (const char *, size_t,
+                                               size_t, size_t,
+                                               void *),
+                            void *pCallbackParam)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
     uAtClientHandle_t atHandle;
-    int32_t size = 0;
+    int32_t fileSize;
+    size_t blockSize;
+    size_t bytesDelivered;
+    size_t totalBytesDelivered = 0;
+    bool keepGoing = true;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         // Check parameters
         if ((pInstance != NULL) && (pFileName != NULL) &&
-            (strlen(pFileName) <= U_CELL_FILE_NAME_MAX_LENGTH)) {
+            (strlen(pFileName) <= U_CELL_FILE_NAME_MAX_LENGTH) &&
+            (pBuffer != NULL) && (bufferSize > 0) && (pCallback != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            // Use of tags is not supported by any of the modules
+            // we support for block reads
+            if (pInstance->pFileSystemTag == NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                atHandle = pInstance->atHandle;
+                // Keep the AT interface for the whole transfer so
+                // that the blocks follow one another without a gap
+                uAtClientLock(atHandle);
+                fileSize = fileSizeGet(atHandle, pFileName, NULL);
+                while (keepGoing && (fileSize > 0) &&
+                       (offset < (size_t) (unsigned) fileSize) &&
+                       (uAtClientErrorGet(atHandle) == 0)) {
+                    blockSize = (size_t) (unsigned) fileSize - offset;
+                    if (blockSize > U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES) {
+                        blockSize = U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES;
+                    }
+                    bytesDelivered = readStreamBlock(pInstance, pFileName,
+                                                     offset, blockSize,
+                                                     (size_t) (unsigned) fileSize,
+                                                     pBuffer, bufferSize,
+                                                     pCallback, pCallbackParam,
+                                                     &keepGoing);
+                    offset += bytesDelivered;
+                    totalBytesDelivered += bytesDelivered;
+                }
+                if (uAtClientUnlock(atHandle) == 0) {
+                    errorCode = (int32_t) totalBytesDelivered;
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Write a file as a stream.
+int32_t uCellFileWriteStream(uDeviceHandle_t cellHandle,
+                             const char *pFileName,
+                             size_t size,
+                             char *pBuffer,
+                             size_t bufferSize,
+                             int32_t (*pCallback) (char *, size_t,
+                                                   size_t, void *),
+                             void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+    size_t blockSize;
+    size_t totalBytesProvided = 0;
+    bool keepGoing = true;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        // Check parameters
+        if ((pInstance != NULL) && (pFileName != NULL) &&
+            (strlen(pFileName) <= U_CELL_FILE_NAME_MAX_LENGTH) &&
+            (pBuffer != NULL) && (bufferSize > 0) && (pCallback != NULL)) {
             errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
             atHandle = pInstance->atHandle;
-            // Do the ULSTFILE thang with the AT interface
+            // Keep the AT interface for the whole transfer so
+            // that the blocks follow one another without a gap
             uAtClientLock(atHandle);
-            uAtClientCommandStart(atHandle, "AT+ULSTFILE=");
-            // Write get file size op_code
-            uAtClientWriteInt(atHandle, 2);
-            // Write file name
-            uAtClientWriteString(atHandle, pFileName, true);
-            if (pInstance->pFileSystemTag != NULL) {
-                // Write tag
-                uAtClientWriteString(atHandle, pInstance->pFileSystemTag, true);
+            while (keepGoing && (totalBytesProvided < size) &&
+                   (uAtClientErrorGet(atHandle) == 0)) {
+                blockSize = size - totalBytesProvided;
+                if (blockSize > U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES) {
+                    blockSize = U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES;
+                }
+                // Each UDWNFILE appends to the file
+                totalBytesProvided += writeStreamBlock(pInstance, pFileName,
+                                                       totalBytesProvided,
+                                                       blockSize,
+                                                       pBuffer, bufferSize,
+                                                       pCallback,
+                                                       pCallbackParam,
+                                                       &keepGoing);
             }
-            uAtClientCommandStop(atHandle);
-            // Grab the response
-            uAtClientResponseStart(atHandle, "+ULSTFILE:");
-            // Read file size
-            size = uAtClientReadInt(atHandle);
-            uAtClientResponseStop(atHandle);
             if (uAtClientUnlock(atHandle) == 0) {
-                errorCode = size;
+                errorCode = (int32_t) totalBytesProvided;
+            }
+            if (keepGoing && (errorCode >= 0)) {
+                uCellPrivateFileCacheWritten(pInstance, pFileName, totalBytesProvided);
+            } else {
+                // Padded or failed: don't know what the file looks like now
+                uCellPrivateFileCacheClear(pInstance);
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Read file size.
+int32_t uCellFileSize(uDeviceHandle_t cellHandle,
+                      const char *pFileName)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+    int32_t size = 0;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        // Check parameters
+        if ((pInstance != NULL) && (pFileName != NULL) &&
+            (strlen(pFileName) <= U_CELL_FILE_NAME_MAX_LENGTH)) {
+            errorCode = uCellPrivateFileCacheSizeGet(pInstance, pFileName);
+            if (errorCode < 0) {
+                errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                atHandle = pInstance->atHandle;
+                // Do the ULSTFILE thang with the AT interface
+                uAtClientLock(atHandle);
+                size = fileSizeGet(atHandle, pFileName, pInstance->pFileSystemTag);
+                if (uAtClientUnlock(atHandle) == 0) {
+                    errorCode = size;
+                    uCellPrivateFileCacheSizeSet(pInstance, pFileName, size);
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -397,14 +742,13 @@ int32_t uCellFileDelete(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             errorCode = uCellPrivateFileDelete(pInstance, pFileName);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -441,10 +785,9 @@ int32_t uCellFileListFirst_r(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && (ppRentrant != NULL)) {
             *ppRentrant = NULL;
             errorCode = uCellPrivateFileListFirst(pInstance,
@@ -452,7 +795,7 @@ int32_t uCellFileListFirst_r(uDeviceHandle_t cellHandle,
                                                   pFileName);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -32,6 +32,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // memcmp()
 
 #include "u_cfg_sw.h"
 
@@ -39,6 +40,7 @@
 
 #include "u_port.h"
 #include "u_port_os.h"
+#include "u_port_crypto.h"
 
 #include "u_at_client.h"
 
@@ -300,6 +302,27 @@ static void UUFWINSTALL_urc(uAtClientHandle_t atHandle,
                               U_CELL_FOTA_STATUS_TYPE_PERCENTAGE_INSTALL);
 }
 
+// Get a piece of the firmware image from the user's callback
+// and add it to the hash, if there is one.
+static int32_t imageGet(uDeviceHandle_t cellHandle, char *pBuffer,
+                        size_t size, size_t offset, size_t imageSize,
+                        void *pHashContext,
+                        uCellFotaImageCallback_t *pCallback,
+                        void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+
+    if (pCallback(cellHandle, pBuffer, size, offset,
+                  imageSize, pCallbackParam) == (int32_t) size) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pHashContext != NULL) {
+            errorCode = uPortCryptoSha256Update(pHashContext, pBuffer, size);
+        }
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -318,9 +341,8 @@ int32_t uCellFotaSetStatusCallback(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -396,7 +418,124 @@ int32_t uCellFotaSetStatusCallback(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Download a firmware image to the file system of the module.
+int32_t uCellFotaImageDownload(uDeviceHandle_t cellHandle,
+                               const char *pFileName,
+                               size_t imageSize,
+                               const char *pSha256,
+                               char *pBuffer, size_t bufferSize,
+                               uCellFotaImageCallback_t *pCallback,
+                               void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    void *pHashContext = NULL;
+    char sha256[U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES];
+    int32_t fileSize;
+    size_t offset = 0;
+    size_t thisSize;
+
+    if (gUCellPrivateMutex != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pFileName != NULL) && (imageSize > 0) && (pBuffer != NULL) &&
+            (bufferSize > 0) && (pCallback != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            // Find out how much, if any, is already there
+            fileSize = uCellFileSize(cellHandle, pFileName);
+            if (fileSize > (int32_t) imageSize) {
+                // Can't be ours, start again
+                errorCode = uCellFileDelete(cellHandle, pFileName);
+                fileSize = 0;
+            }
+            if (fileSize < 0) {
+                fileSize = 0;
+            }
+            if ((errorCode == 0) && (pSha256 != NULL)) {
+                errorCode = uPortCryptoSha256Start(&pHashContext);
+            }
+            // Hash what is already there, as the user's callback
+            // gives it to us, without writing it again
+            while ((errorCode == 0) && (offset < (size_t) fileSize)) {
+                thisSize = fileSize - offset;
+                if (thisSize > bufferSize) {
+                    thisSize = bufferSize;
+                }
+                errorCode = imageGet(cellHandle, pBuffer, thisSize, offset,
+                                     imageSize, pHashContext,
+                                     pCallback, pCallbackParam);
+                offset += thisSize;
+            }
+            // Write the rest, getting each block before starting
+            // to write it so that a callback failure can't leave
+            // a partial block behind
+            while ((errorCode == 0) && (offset < imageSize)) {
+                thisSize = imageSize - offset;
+                if (thisSize > bufferSize) {
+                    thisSize = bufferSize;
+                }
+                errorCode = imageGet(cellHandle, pBuffer, thisSize, offset,
+                                     imageSize, pHashContext,
+                                     pCallback, pCallbackParam);
+                if (errorCode == 0) {
+                    errorCode = uCellFileWrite(cellHandle, pFileName,
+                                               pBuffer, thisSize);
+                    if (errorCode == (int32_t) thisSize) {
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        offset += thisSize;
+                    } else if (errorCode >= 0) {
+                        errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                    }
+                }
+            }
+            if (pHashContext != NULL) {
+                if (errorCode == 0) {
+                    errorCode = uPortCryptoSha256Finish(pHashContext, sha256);
+                    if ((errorCode == 0) &&
+                        (memcmp(sha256, pSha256, sizeof(sha256)) != 0)) {
+                        // Start again next time
+                        uCellFileDelete(cellHandle, pFileName);
+                        errorCode = (int32_t) U_ERROR_COMMON_AUTHENTICATION_FAILURE;
+                    }
+                } else {
+                    uPortCryptoSha256Finish(pHashContext, NULL);
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Install a firmware image from the file system of the module.
+int32_t uCellFotaImageInstall(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                   U_CELL_PRIVATE_FEATURE_FOTA)) {
+                atHandle = pInstance->atHandle;
+                uAtClientLock(atHandle);
+                uAtClientCommandStart(atHandle, "AT+UFWINSTALL");
+                uAtClientCommandStopReadResponse(atHandle);
+                errorCode = uAtClientUnlock(atHandle);
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -32,6 +32,8 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // memset()
+#include "stdio.h"     // snprintf()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_os_platform_specific.h"  // For #define U_CFG_OS_CLIB_LEAKS
@@ -45,7 +47,8 @@
 
 #include "u_cell_module_type.h"
 #include "u_cell_file.h"
-#include "u_cell_net.h"     // Order is important here
+#include "u_cell.h"         // Order is
+#include "u_cell_net.h"     // important here
 #include "u_cell_private.h" // don't change it
 #include "u_cell_gpio.h"
 
@@ -53,6 +56,15 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The number of GPIOs that can be represented in a mask.
+ */
+#define U_CELL_GPIO_MASK_NUM (sizeof(gGpioIdMask) / sizeof(gGpioIdMask[0]))
+
+/** Room for the longest GPIO read or write command, e.g.
+ * "AT+UGPIOW=42,1", including terminator.
+ */
+#define U_CELL_GPIO_COMMAND_MAX_LENGTH_BYTES 16
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -61,10 +73,75 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The GPIO ID of each bit of a mask, bit x - 1 being "GPIOx".
+ */
+static const uCellGpioName_t gGpioIdMask[] = {U_CELL_GPIO_1, U_CELL_GPIO_2,
+                                              U_CELL_GPIO_3, U_CELL_GPIO_4,
+                                              U_CELL_GPIO_5, U_CELL_GPIO_6
+                                             };
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Return the mask bit for a GPIO ID, zero if there isn't one.
+static uint32_t gpioIdToMask(int32_t gpioId)
+{
+    uint32_t mask = 0;
+
+    for (size_t x = 0; (x < U_CELL_GPIO_MASK_NUM) && (mask == 0); x++) {
+        if ((int32_t) gGpioIdMask[x] == gpioId) {
+            mask = 1UL << x;
+        }
+    }
+
+    return mask;
+}
+
+// Update the GPIO cache after an attempt to write a GPIO ID.
+static void gpioCacheUpdate(uCellPrivateInstance_t *pInstance,
+                            int32_t gpioId, bool written,
+                            int32_t level)
+{
+    uCellPrivateGpioCache_t *pCache = &(pInstance->gpioCache);
+    uint32_t mask = gpioIdToMask(gpioId);
+
+    pCache->knownMask &= ~mask;
+    pCache->levelMask &= ~mask;
+    if (written) {
+        pCache->knownMask |= mask;
+        if (level != 0) {
+            pCache->levelMask |= mask;
+        }
+    }
+}
+
+// Parse the response to AT+UGPIOR for uAtClientBatch(), setting
+// the bit of the GPIO in the uint32_t pointed to by pParam if it
+// is high.
+static int32_t parseGpioLevel(uAtClientHandle_t atHandle,
+                              size_t index, void *pParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+    uint32_t *pLevelMask = (uint32_t *) pParam;
+    int32_t gpioId;
+    int32_t level;
+
+    (void) index;
+
+    // The response carries the GPIO ID, which tells us the bit
+    gpioId = uAtClientReadInt(atHandle);
+    level = uAtClientReadInt(atHandle);
+    if ((gpioId >= 0) && (level >= 0)) {
+        if (level != 0) {
+            *pLevelMask |= gpioIdToMask(gpioId);
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -79,9 +156,8 @@ int32_t uCellGpioConfig(uDeviceHandle_t cellHandle, uCellGpioName_t gpioId,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && ((int32_t) gpioId >= 0)) {
             atHandle = pInstance->atHandle;
 
@@ -97,9 +173,11 @@ int32_t uCellGpioConfig(uDeviceHandle_t cellHandle, uCellGpioName_t gpioId,
             }
             uAtClientCommandStopReadResponse(atHandle);
             errorCode = uAtClientUnlock(atHandle);
+            gpioCacheUpdate(pInstance, (int32_t) gpioId,
+                            isOutput && (errorCode == 0), level);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -115,9 +193,8 @@ int32_t uCellGpioSet(uDeviceHandle_t cellHandle, uCellGpioName_t gpioId,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && ((int32_t) gpioId >= 0)) {
             atHandle = pInstance->atHandle;
 
@@ -129,9 +206,11 @@ int32_t uCellGpioSet(uDeviceHandle_t cellHandle, uCellGpioName_t gpioId,
             uAtClientWriteInt(atHandle, level);
             uAtClientCommandStopReadResponse(atHandle);
             errorCode = uAtClientUnlock(atHandle);
+            gpioCacheUpdate(pInstance, (int32_t) gpioId,
+                            errorCode == 0, level);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -147,9 +226,8 @@ int32_t uCellGpioGet(uDeviceHandle_t cellHandle, uCellGpioName_t gpioId)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && ((int32_t) gpioId >= 0)) {
             atHandle = pInstance->atHandle;
 
@@ -174,12 +252,122 @@ int32_t uCellGpioGet(uDeviceHandle_t cellHandle, uCellGpioName_t gpioId)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
 }
 
+// Set the state of several GPIOs.
+int32_t uCellGpioSetMask(uDeviceHandle_t cellHandle, uint32_t gpioMask,
+                         uint32_t levelMask)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uCellPrivateInstance_t *pInstance;
+    uCellPrivateGpioCache_t *pCache;
+    char command[U_CELL_GPIO_MASK_NUM][U_CELL_GPIO_COMMAND_MAX_LENGTH_BYTES];
+    uAtClientBatchCommand_t batch[U_CELL_GPIO_MASK_NUM];
+    uint32_t batchMask[U_CELL_GPIO_MASK_NUM];
+    size_t numCommands = 0;
+    int32_t numCompleted;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        if ((pInstance != NULL) && ((gpioMask & ~U_CELL_GPIO_MASK_ALL) == 0)) {
+            pCache = &(pInstance->gpioCache);
+            memset(batch, 0, sizeof(batch));
+            for (size_t x = 0; x < U_CELL_GPIO_MASK_NUM; x++) {
+                // Only write the GPIOs that are not already known
+                // to be at the requested level
+                if (((gpioMask & (1UL << x)) != 0) &&
+                    (((pCache->knownMask & (1UL << x)) == 0) ||
+                     (((pCache->levelMask ^ levelMask) & (1UL << x)) != 0))) {
+                    snprintf(command[numCommands], sizeof(command[numCommands]),
+                             "AT+UGPIOW=%d,%d", (int) gGpioIdMask[x],
+                             (levelMask & (1UL << x)) ? 1 : 0);
+                    batch[numCommands].pCommand = command[numCommands];
+                    batchMask[numCommands] = 1UL << x;
+                    numCommands++;
+                }
+            }
+            errorCodeOrCount = 0;
+            if (numCommands > 0) {
+                numCompleted = uAtClientBatch(pInstance->atHandle, batch,
+                                              numCommands, true);
+                errorCodeOrCount = (int32_t) U_CELL_ERROR_AT;
+                if (numCompleted == (int32_t) numCommands) {
+                    errorCodeOrCount = numCompleted;
+                }
+                if (numCompleted < 0) {
+                    numCompleted = 0;
+                }
+                // Record what is now known, forgetting anything
+                // that might not have been written
+                for (size_t x = 0; x < numCommands; x++) {
+                    pCache->knownMask &= ~batchMask[x];
+                    pCache->levelMask &= ~batchMask[x];
+                    if (x < (size_t) numCompleted) {
+                        pCache->knownMask |= batchMask[x];
+                        pCache->levelMask |= levelMask & batchMask[x];
+                    }
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrCount;
+}
+
+// Get the state of several GPIOs.
+int32_t uCellGpioGetMask(uDeviceHandle_t cellHandle, uint32_t gpioMask)
+{
+    int32_t errorCodeOrLevels = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uCellPrivateInstance_t *pInstance;
+    char command[U_CELL_GPIO_MASK_NUM][U_CELL_GPIO_COMMAND_MAX_LENGTH_BYTES];
+    uAtClientBatchCommand_t batch[U_CELL_GPIO_MASK_NUM];
+    size_t numCommands = 0;
+    uint32_t levelMask = 0;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        if ((pInstance != NULL) && ((gpioMask & ~U_CELL_GPIO_MASK_ALL) == 0)) {
+            memset(batch, 0, sizeof(batch));
+            for (size_t x = 0; x < U_CELL_GPIO_MASK_NUM; x++) {
+                if ((gpioMask & (1UL << x)) != 0) {
+                    snprintf(command[numCommands], sizeof(command[numCommands]),
+                             "AT+UGPIOR=%d", (int) gGpioIdMask[x]);
+                    batch[numCommands].pCommand = command[numCommands];
+                    // Note: need to use just +UGPIO" here since SARA-U201
+                    // returns "+UGPIO:" while all the other modules
+                    // return "+UGPIOR:"
+                    batch[numCommands].pResponsePrefix = "+UGPIO";
+                    batch[numCommands].pParser = parseGpioLevel;
+                    batch[numCommands].pParserParam = (void *) &levelMask;
+                    numCommands++;
+                }
+            }
+            errorCodeOrLevels = 0;
+            if (numCommands > 0) {
+                errorCodeOrLevels = (int32_t) U_CELL_ERROR_AT;
+                if (uAtClientBatch(pInstance->atHandle, batch, numCommands,
+                                   true) == (int32_t) numCommands) {
+                    errorCodeOrLevels = (int32_t) (levelMask & gpioMask);
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrLevels;
+}
+
 // Set the state of the CTS line.
 int32_t uCellGpioSetCts(uDeviceHandle_t cellHandle, int32_t level)
 {
@@ -189,9 +377,8 @@ int32_t uCellGpioSetCts(uDeviceHandle_t cellHandle, int32_t level)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -206,7 +393,7 @@ int32_t uCellGpioSetCts(uDeviceHandle_t cellHandle, int32_t level)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -222,9 +409,8 @@ int32_t uCellGpioGetCts(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -244,7 +430,7 @@ int32_t uCellGpioGetCts(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
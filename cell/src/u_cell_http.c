@@ -0,0 +1,660 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the HTTP client API for cellular.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc(), free(), atoi()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset(), strchr(), strncpy()
+
+#include "u_cfg_sw.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+
+#include "u_at_client.h"
+
+#include "u_cell_module_type.h"
+#include "u_cell_file.h"
+#include "u_cell_net.h"     // Order is important here
+#include "u_cell_private.h" // don't change it
+#include "u_cell_http.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The maximum length of a server name, including any port number.
+ */
+#define U_CELL_HTTP_SERVER_NAME_MAX_LENGTH_BYTES 128
+
+/** How often uCellHttpGetStream() checks whether the module has
+ * finished downloading.
+ */
+#define U_CELL_HTTP_POLL_INTERVAL_MS 100
+
+/** The value of the status of a profile while a request is
+ * outstanding.
+ */
+#define U_CELL_HTTP_STATUS_PENDING 1
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The state of one HTTP profile.
+ */
+typedef struct {
+    bool inUse;
+    int32_t timeoutSeconds;
+    uCellHttpCallback_t pCallback;
+    void *pCallbackParameter;
+    uCellHttpRequest_t requestType;
+    bool noCallback; /**< Set while uCellHttpGetStream() is waiting. */
+    volatile int32_t status; /**< Zero, #U_CELL_HTTP_STATUS_PENDING or
+                                  negative error code. */
+} uCellHttpProfile_t;
+
+/** Structure defining the HTTP context, one for all profiles.
+ */
+typedef struct {
+    uCellHttpProfile_t profile[U_CELL_HTTP_PROFILE_MAX_NUM];
+} uCellPrivateHttpContext_t;
+
+/** All the parameters for the HTTP callback.
+ */
+typedef struct {
+    uDeviceHandle_t cellHandle;
+    int32_t httpHandle;
+    uCellHttpRequest_t requestType;
+    bool success;
+    uCellHttpCallback_t pCallback;
+    void *pCallbackParameter;
+} uCellHttpCallbackParameters_t;
+
+/** Context for streamCallback().
+ */
+typedef struct {
+    int32_t statusCode;
+    int32_t statusState; /**< 0 before the status code, 1 in it,
+                              2 after it. */
+    size_t headerMatched; /**< The number of characters of the
+                               end-of-header marker matched so far. */
+    size_t bodyOffset;
+    bool (*pCallback) (const char *, size_t, size_t, void *);
+    void *pCallbackParam;
+} uCellHttpStream_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The marker for the end of the HTTP headers.
+ */
+static const char gHeaderEnd[] = "\r\n\r\n";
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Callback via which the user's HTTP callback is called.
+// This must be called through the uAtClientCallback() mechanism in
+// order to prevent customer code blocking the AT client.
+static void httpCallback(uAtClientHandle_t atHandle, void *pParameter)
+{
+    uCellHttpCallbackParameters_t *pCallback = (uCellHttpCallbackParameters_t *) pParameter;
+
+    (void) atHandle;
+
+    if (pCallback != NULL) {
+        // The module has written a file behind our back
+        uCellFileCacheInvalidate(pCallback->cellHandle);
+        if (pCallback->pCallback != NULL) {
+            pCallback->pCallback(pCallback->cellHandle,
+                                 pCallback->httpHandle,
+                                 pCallback->requestType,
+                                 pCallback->success,
+                                 pCallback->pCallbackParameter);
+        }
+        free(pCallback);
+    }
+}
+
+// The UUHTTPCR URC callback.
+static void UUHTTPCR_urc(uAtClientHandle_t atHandle, void *pParameter)
+{
+    uCellPrivateInstance_t *pInstance = (uCellPrivateInstance_t *) pParameter;
+    uCellPrivateHttpContext_t *pContext = (uCellPrivateHttpContext_t *) pInstance->pHttpContext;
+    uCellHttpProfile_t *pProfile;
+    uCellHttpCallbackParameters_t *pCallback;
+    int32_t httpHandle;
+    int32_t requestType;
+    int32_t result;
+
+    httpHandle = uAtClientReadInt(atHandle);
+    requestType = uAtClientReadInt(atHandle);
+    result = uAtClientReadInt(atHandle);
+    if ((pContext != NULL) && (httpHandle >= 0) &&
+        (httpHandle < U_CELL_HTTP_PROFILE_MAX_NUM) &&
+        (requestType >= 0) && (result >= 0)) {
+        pProfile = &(pContext->profile[httpHandle]);
+        if (pProfile->inUse && (pProfile->status == U_CELL_HTTP_STATUS_PENDING)) {
+            if (!pProfile->noCallback) {
+                // Note: httpCallback will free() the malloc()ed memory.
+                //lint -esym(429, pCallback) Suppress pCallback not being free()ed here
+                //lint -esym(593, pCallback) Suppress pCallback not being free()ed here
+                pCallback = (uCellHttpCallbackParameters_t *) malloc(sizeof(*pCallback));
+                if (pCallback != NULL) {
+                    pCallback->cellHandle = pInstance->cellHandle;
+                    pCallback->httpHandle = httpHandle;
+                    pCallback->requestType = (uCellHttpRequest_t) requestType;
+                    pCallback->success = (result == 1);
+                    pCallback->pCallback = pProfile->pCallback;
+                    pCallback->pCallbackParameter = pProfile->pCallbackParameter;
+                    uAtClientCallback(atHandle, httpCallback, pCallback);
+                }
+            }
+            // Set this last as uCellHttpGetStream() may be waiting on it
+            pProfile->status = (result == 1) ? (int32_t) U_ERROR_COMMON_SUCCESS :
+                               (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+        }
+    }
+}
+
+// Get the profile for an HTTP handle, NULL if it is not open.
+static uCellHttpProfile_t *pGetProfile(const uCellPrivateInstance_t *pInstance,
+                                       int32_t httpHandle)
+{
+    uCellHttpProfile_t *pProfile = NULL;
+    uCellPrivateHttpContext_t *pContext = (uCellPrivateHttpContext_t *) pInstance->pHttpContext;
+
+    if ((pContext != NULL) && (httpHandle >= 0) &&
+        (httpHandle < U_CELL_HTTP_PROFILE_MAX_NUM) &&
+        pContext->profile[httpHandle].inUse) {
+        pProfile = &(pContext->profile[httpHandle]);
+    }
+
+    return pProfile;
+}
+
+// Send AT+UHTTP=<profile>,<opCode>,<integer>.
+static int32_t setInt(uAtClientHandle_t atHandle, int32_t httpHandle,
+                      int32_t opCode, int32_t value)
+{
+    uAtClientLock(atHandle);
+    uAtClientCommandStart(atHandle, "AT+UHTTP=");
+    uAtClientWriteInt(atHandle, httpHandle);
+    uAtClientWriteInt(atHandle, opCode);
+    uAtClientWriteInt(atHandle, value);
+    uAtClientCommandStopReadResponse(atHandle);
+    return uAtClientUnlock(atHandle);
+}
+
+// Send AT+UHTTP=<profile>,<opCode>,"<string>".
+static int32_t setString(uAtClientHandle_t atHandle, int32_t httpHandle,
+                         int32_t opCode, const char *pValue)
+{
+    uAtClientLock(atHandle);
+    uAtClientCommandStart(atHandle, "AT+UHTTP=");
+    uAtClientWriteInt(atHandle, httpHandle);
+    uAtClientWriteInt(atHandle, opCode);
+    uAtClientWriteString(atHandle, pValue, true);
+    uAtClientCommandStopReadResponse(atHandle);
+    return uAtClientUnlock(atHandle);
+}
+
+// Reset an HTTP profile in the module.
+static void reset(uAtClientHandle_t atHandle, int32_t httpHandle)
+{
+    uAtClientLock(atHandle);
+    uAtClientCommandStart(atHandle, "AT+UHTTP=");
+    uAtClientWriteInt(atHandle, httpHandle);
+    uAtClientCommandStopReadResponse(atHandle);
+    uAtClientUnlock(atHandle);
+}
+
+// Configure an HTTP profile in the module.
+static int32_t configure(uAtClientHandle_t atHandle, int32_t httpHandle,
+                         const char *pServerName, const char *pUserName,
+                         const char *pPassword, int32_t securityProfileId,
+                         int32_t timeoutSeconds)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    char serverName[U_CELL_HTTP_SERVER_NAME_MAX_LENGTH_BYTES];
+    char *pPort;
+    int32_t port = -1;
+
+    if (strlen(pServerName) < sizeof(serverName)) {
+        strncpy(serverName, pServerName, sizeof(serverName));
+        pPort = strchr(serverName, ':');
+        if (pPort != NULL) {
+            *pPort = 0;
+            port = atoi(pPort + 1);
+        }
+        // Server name
+        errorCode = setString(atHandle, httpHandle, 1, serverName);
+        if ((errorCode == 0) && (port > 0)) {
+            errorCode = setInt(atHandle, httpHandle, 5, port);
+        }
+        if ((errorCode == 0) && (pUserName != NULL)) {
+            errorCode = setString(atHandle, httpHandle, 2, pUserName);
+            if ((errorCode == 0) && (pPassword != NULL)) {
+                errorCode = setString(atHandle, httpHandle, 3, pPassword);
+            }
+            if (errorCode == 0) {
+                // Basic authentication
+                errorCode = setInt(atHandle, httpHandle, 4, 1);
+            }
+        }
+        if ((errorCode == 0) && (securityProfileId >= 0)) {
+            uAtClientLock(atHandle);
+            uAtClientCommandStart(atHandle, "AT+UHTTP=");
+            uAtClientWriteInt(atHandle, httpHandle);
+            uAtClientWriteInt(atHandle, 6);
+            uAtClientWriteInt(atHandle, 1);
+            uAtClientWriteInt(atHandle, securityProfileId);
+            uAtClientCommandStopReadResponse(atHandle);
+            errorCode = uAtClientUnlock(atHandle);
+        }
+        if ((errorCode == 0) && (timeoutSeconds > 0)) {
+            errorCode = setInt(atHandle, httpHandle, 7, timeoutSeconds);
+        }
+    }
+
+    return errorCode;
+}
+
+// Send an AT+UHTTPC command; the instance must be locked.
+static int32_t request(const uCellPrivateInstance_t *pInstance,
+                       uCellHttpProfile_t *pProfile, int32_t httpHandle,
+                       uCellHttpRequest_t requestType, const char *pPath,
+                       const char *pFileNameResponse,
+                       const char *pFileNameContent,
+                       const char *pContentType)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    bool hasContent = (requestType == U_CELL_HTTP_REQUEST_PUT) ||
+                      (requestType == U_CELL_HTTP_REQUEST_POST);
+
+    if (pProfile->status != U_CELL_HTTP_STATUS_PENDING) {
+        pProfile->requestType = requestType;
+        // Set this before sending as the URC could arrive
+        // before the OK has been processed
+        pProfile->status = U_CELL_HTTP_STATUS_PENDING;
+        uAtClientLock(atHandle);
+        uAtClientCommandStart(atHandle, "AT+UHTTPC=");
+        uAtClientWriteInt(atHandle, httpHandle);
+        uAtClientWriteInt(atHandle, (int32_t) requestType);
+        uAtClientWriteString(atHandle, pPath, true);
+        uAtClientWriteString(atHandle, pFileNameResponse, true);
+        if (hasContent) {
+            uAtClientWriteString(atHandle, pFileNameContent, true);
+            if (requestType == U_CELL_HTTP_REQUEST_POST) {
+                // Content type 6 is "user defined", given next
+                uAtClientWriteInt(atHandle, 6);
+            }
+            uAtClientWriteString(atHandle, pContentType, true);
+        }
+        uAtClientCommandStopReadResponse(atHandle);
+        errorCode = uAtClientUnlock(atHandle);
+        if (errorCode != 0) {
+            pProfile->status = errorCode;
+        }
+    }
+
+    return errorCode;
+}
+
+// Callback for uCellFileReadStream() which skips the HTTP headers,
+// picking the status code out of the first line, e.g.
+// "HTTP/1.1 200 OK", on the way.
+static bool streamCallback(const char *pData, size_t length,
+                           size_t offset, size_t fileSize,
+                           void *pCallbackParam)
+{
+    uCellHttpStream_t *pStream = (uCellHttpStream_t *) pCallbackParam;
+    bool keepGoing = true;
+
+    (void) offset;
+    (void) fileSize;
+
+    while ((length > 0) && (pStream->headerMatched < sizeof(gHeaderEnd) - 1)) {
+        if (pStream->statusState == 0) {
+            if (*pData == ' ') {
+                pStream->statusCode = 0;
+                pStream->statusState = 1;
+            }
+        } else if (pStream->statusState == 1) {
+            if ((*pData >= '0') && (*pData <= '9')) {
+                pStream->statusCode = (pStream->statusCode * 10) + (*pData - '0');
+            } else {
+                pStream->statusState = 2;
+            }
+        }
+        if (*pData == gHeaderEnd[pStream->headerMatched]) {
+            pStream->headerMatched++;
+        } else {
+            pStream->headerMatched = (*pData == gHeaderEnd[0]) ? 1 : 0;
+        }
+        pData++;
+        length--;
+    }
+
+    if (length > 0) {
+        keepGoing = pStream->pCallback(pData, length, pStream->bodyOffset,
+                                       pStream->pCallbackParam);
+        pStream->bodyOffset += length;
+    }
+
+    return keepGoing;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Open an HTTP instance.
+int32_t uCellHttpOpen(uDeviceHandle_t cellHandle, const char *pServerName,
+                      const char *pUserName, const char *pPassword,
+                      int32_t securityProfileId, int32_t timeoutSeconds,
+                      uCellHttpCallback_t pCallback,
+                      void *pCallbackParameter)
+{
+    int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellPrivateHttpContext_t *pContext;
+    uCellHttpProfile_t *pProfile;
+    int32_t httpHandle = -1;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pServerName != NULL) && (timeoutSeconds >= 0)) {
+            errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pContext = (uCellPrivateHttpContext_t *) pInstance->pHttpContext;
+            if (pContext == NULL) {
+                // Note: we don't deallocate this until
+                // cellular is closed down in order to
+                // ensure thread-safety of the URC
+                pContext = (uCellPrivateHttpContext_t *) malloc(sizeof(uCellPrivateHttpContext_t));
+                if (pContext != NULL) {
+                    memset(pContext, 0, sizeof(*pContext));
+                    if (uAtClientSetUrcHandler(pInstance->atHandle, "+UUHTTPCR:",
+                                               UUHTTPCR_urc, pInstance) == 0) {
+                        pInstance->pHttpContext = pContext;
+                    } else {
+                        free(pContext);
+                        pContext = NULL;
+                    }
+                }
+            }
+            if (pContext != NULL) {
+                for (int32_t x = 0; (x < U_CELL_HTTP_PROFILE_MAX_NUM) &&
+                     (httpHandle < 0); x++) {
+                    if (!pContext->profile[x].inUse) {
+                        httpHandle = x;
+                    }
+                }
+                if (httpHandle >= 0) {
+                    errorCodeOrHandle = configure(pInstance->atHandle, httpHandle,
+                                                  pServerName, pUserName, pPassword,
+                                                  securityProfileId, timeoutSeconds);
+                    if (errorCodeOrHandle == 0) {
+                        pProfile = &(pContext->profile[httpHandle]);
+                        memset(pProfile, 0, sizeof(*pProfile));
+                        pProfile->timeoutSeconds = timeoutSeconds;
+                        pProfile->pCallback = pCallback;
+                        pProfile->pCallbackParameter = pCallbackParameter;
+                        pProfile->status = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                        pProfile->inUse = true;
+                        errorCodeOrHandle = httpHandle;
+                    } else {
+                        reset(pInstance->atHandle, httpHandle);
+                    }
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrHandle;
+}
+
+// Close an HTTP instance.
+void uCellHttpClose(uDeviceHandle_t cellHandle, int32_t httpHandle)
+{
+    uCellPrivateInstance_t *pInstance;
+    uCellHttpProfile_t *pProfile;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        if (pInstance != NULL) {
+            pProfile = pGetProfile(pInstance, httpHandle);
+            if (pProfile != NULL) {
+                reset(pInstance->atHandle, httpHandle);
+                pProfile->inUse = false;
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+}
+
+// Make an HTTP request.
+int32_t uCellHttpRequest(uDeviceHandle_t cellHandle, int32_t httpHandle,
+                         uCellHttpRequest_t requestType,
+                         const char *pPath, const char *pFileNameResponse,
+                         const char *pFileNameContent,
+                         const char *pContentType)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellHttpProfile_t *pProfile;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            pProfile = pGetProfile(pInstance, httpHandle);
+            if ((pProfile != NULL) && (requestType >= 0) &&
+                (requestType < U_CELL_HTTP_REQUEST_MAX_NUM) &&
+                (pPath != NULL) && (pFileNameResponse != NULL) &&
+                (((requestType != U_CELL_HTTP_REQUEST_PUT) &&
+                  (requestType != U_CELL_HTTP_REQUEST_POST)) ||
+                 ((pFileNameContent != NULL) && (pContentType != NULL)))) {
+                pProfile->noCallback = false;
+                errorCode = request(pInstance, pProfile, httpHandle,
+                                    requestType, pPath, pFileNameResponse,
+                                    pFileNameContent, pContentType);
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Get the outcome of the last request.
+int32_t uCellHttpRequestStatus(uDeviceHandle_t cellHandle,
+                               int32_t httpHandle)
+{
+    int32_t errorCodeOrStatus = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellHttpProfile_t *pProfile;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrStatus = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            pProfile = pGetProfile(pInstance, httpHandle);
+            if (pProfile != NULL) {
+                errorCodeOrStatus = pProfile->status;
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrStatus;
+}
+
+// Get the last HTTP error from the module.
+int32_t uCellHttpGetLastError(uDeviceHandle_t cellHandle,
+                              int32_t httpHandle,
+                              int32_t *pErrorCode)
+{
+    int32_t errorCodeOrClass = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+    int32_t errorClass;
+    int32_t errorCode;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrClass = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pGetProfile(pInstance, httpHandle) != NULL)) {
+            atHandle = pInstance->atHandle;
+            uAtClientLock(atHandle);
+            uAtClientCommandStart(atHandle, "AT+UHTTPER=");
+            uAtClientWriteInt(atHandle, httpHandle);
+            uAtClientCommandStop(atHandle);
+            uAtClientResponseStart(atHandle, "+UHTTPER:");
+            // Skip the profile
+            uAtClientSkipParameters(atHandle, 1);
+            errorClass = uAtClientReadInt(atHandle);
+            errorCode = uAtClientReadInt(atHandle);
+            uAtClientResponseStop(atHandle);
+            errorCodeOrClass = uAtClientUnlock(atHandle);
+            if ((errorCodeOrClass == 0) && (errorClass >= 0)) {
+                errorCodeOrClass = errorClass;
+                if (pErrorCode != NULL) {
+                    *pErrorCode = errorCode;
+                }
+            } else {
+                errorCodeOrClass = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrClass;
+}
+
+// Perform an HTTP GET and stream the body to a callback.
+int32_t uCellHttpGetStream(uDeviceHandle_t cellHandle, int32_t httpHandle,
+                           const char *pPath, char *pBuffer,
+                           size_t bufferSize,
+                           bool (*pCallback) (const char *, size_t,
+                                              size_t, void *),
+                           void *pCallbackParam)
+{
+    int32_t errorCodeOrStatus = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellHttpProfile_t *pProfile = NULL;
+    int32_t timeoutMs = U_CELL_HTTP_TIMEOUT_SECONDS * 1000;
+    int32_t startTimeMs;
+    uCellHttpStream_t stream;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrStatus = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pPath != NULL) && (pBuffer != NULL) &&
+            (bufferSize > 0) && (pCallback != NULL)) {
+            pProfile = pGetProfile(pInstance, httpHandle);
+            if (pProfile != NULL) {
+                if (pProfile->timeoutSeconds > 0) {
+                    // Allow the module its timeout and a bit
+                    timeoutMs = (pProfile->timeoutSeconds + 5) * 1000;
+                }
+                pProfile->noCallback = true;
+                errorCodeOrStatus = request(pInstance, pProfile, httpHandle,
+                                            U_CELL_HTTP_REQUEST_GET, pPath,
+                                            U_CELL_HTTP_FILE_NAME_RESPONSE_DEFAULT,
+                                            NULL, NULL);
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+
+        if ((errorCodeOrStatus == 0) && (pProfile != NULL)) {
+            // Wait for the module to finish downloading without
+            // holding the lock, so that the URC can get in;
+            // the context is not freed until cellular is closed
+            startTimeMs = uPortGetTickTimeMs();
+            while ((pProfile->status == U_CELL_HTTP_STATUS_PENDING) &&
+                   (uPortGetTickTimeMs() - startTimeMs < timeoutMs)) {
+                uPortTaskBlock(U_CELL_HTTP_POLL_INTERVAL_MS);
+            }
+            errorCodeOrStatus = pProfile->status;
+            if (errorCodeOrStatus == U_CELL_HTTP_STATUS_PENDING) {
+                // Give up; a late URC will now be ignored
+                errorCodeOrStatus = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                pProfile->status = errorCodeOrStatus;
+            }
+            uCellFileCacheInvalidate(cellHandle);
+            if (errorCodeOrStatus == 0) {
+                memset(&stream, 0, sizeof(stream));
+                stream.statusCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                stream.pCallback = pCallback;
+                stream.pCallbackParam = pCallbackParam;
+                errorCodeOrStatus = uCellFileReadStream(cellHandle,
+                                                        U_CELL_HTTP_FILE_NAME_RESPONSE_DEFAULT,
+                                                        0, pBuffer, bufferSize,
+                                                        streamCallback, &stream);
+                if (errorCodeOrStatus >= 0) {
+                    errorCodeOrStatus = stream.statusCode;
+                }
+                uCellFileDelete(cellHandle, U_CELL_HTTP_FILE_NAME_RESPONSE_DEFAULT);
+            }
+        }
+    }
+
+    return errorCodeOrStatus;
+}
+
+// End of file
@@ -38,14 +38,17 @@
 #include "time.h"      // struct tm
 
 #include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
 
 #include "u_error_common.h"
 
 #include "u_port_clib_platform_specific.h" // strtok_r() and, in some cases, isblank()
 #include "u_port_clib_mktime64.h"
+#include "u_port.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"
 #include "u_port_uart.h"
+#include "u_port_event_queue.h"
 
 #include "u_at_client.h"
 
@@ -60,6 +63,26 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_CELL_INFO_SAMPLER_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that refreshes the radio parameters
+ * for the sampler started by uCellInfoSamplerStart().
+ */
+# define U_CELL_INFO_SAMPLER_TASK_STACK_SIZE_BYTES 2560
+#endif
+
+#ifndef U_CELL_INFO_SAMPLER_TASK_PRIORITY
+/** The priority of the task that refreshes the radio parameters
+ * for the sampler started by uCellInfoSamplerStart().
+ */
+# define U_CELL_INFO_SAMPLER_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+/** How long the sampler task will wait for the cellular instance to
+ * be free before giving up on a sample; this also bounds how long
+ * uCellInfoSamplerStop() may wait for the sampler task to exit.
+ */
+#define U_CELL_INFO_SAMPLER_LOCK_TIMEOUT_MS 1000
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -170,11 +193,42 @@ static int32_t getString(uAtClientHandle_t atHandle,
     return errorCodeOrSize;
 }
 
+// Get an identity string, one that cannot change while the module
+// is powered, from pCache if it is there, else from the module with
+// the given AT command, populating pCache.
+static int32_t getStringCached(uCellPrivateInstance_t *pInstance,
+                               const char *pCmd, char *pCache,
+                               char *pBuffer, size_t bufferSize)
+{
+    int32_t errorCodeOrSize;
+
+    if (*pCache == 0) {
+        errorCodeOrSize = getString(pInstance->atHandle, pCmd,
+                                    pBuffer, bufferSize);
+        // Only cache what we know is complete
+        if ((errorCodeOrSize > 0) &&
+            (errorCodeOrSize < (int32_t) bufferSize - 1) &&
+            (errorCodeOrSize <= U_CELL_PRIVATE_IDENTITY_STR_MAX_LENGTH_BYTES)) {
+            memcpy(pCache, pBuffer, errorCodeOrSize + 1);
+        }
+    } else {
+        errorCodeOrSize = (int32_t) strlen(pCache);
+        if (errorCodeOrSize > (int32_t) bufferSize - 1) {
+            errorCodeOrSize = (int32_t) bufferSize - 1;
+        }
+        memcpy(pBuffer, pCache, errorCodeOrSize);
+        *(pBuffer + errorCodeOrSize) = 0;
+    }
+
+    return errorCodeOrSize;
+}
+
 // Fill in the radio parameters the AT+CSQ way
 static int32_t getRadioParamsCsq(uAtClientHandle_t atHandle,
                                  uCellPrivateRadioParameters_t *pRadioParameters)
 {
     int32_t errorCode;
+    int32_t values[2];
     int32_t x;
     int32_t y;
 
@@ -182,8 +236,9 @@ static int32_t getRadioParamsCsq(uAtClientHandle_t atHandle,
     uAtClientCommandStart(atHandle, "AT+CSQ");
     uAtClientCommandStop(atHandle);
     uAtClientResponseStart(atHandle, "+CSQ:");
-    x = uAtClientReadInt(atHandle);
-    y = uAtClientReadInt(atHandle);
+    uAtClientReadIntList(atHandle, values, sizeof(values) / sizeof(values[0]), 0);
+    x = values[0];
+    y = values[1];
     if (y == 99) {
         y = -1;
     }
@@ -204,7 +259,7 @@ static int32_t getRadioParamsCsq(uAtClientHandle_t atHandle,
 static int32_t getRadioParamsUcged2SaraR5(uAtClientHandle_t atHandle,
                                           uCellPrivateRadioParameters_t *pRadioParameters)
 {
-    int32_t x;
+    int32_t values[12];
 
     // +UCGED: 2
     // <rat>,<svc>,<MCC>,<MNC>
@@ -221,26 +276,24 @@ static int32_t getRadioParamsUcged2SaraR5(uAtClientHandle_t atHandle,
     // Don't want anything from the next line
     uAtClientResponseStart(atHandle, NULL);
     uAtClientSkipParameters(atHandle, 4);
-    // Now the line of interest
+    // Now the line of interest: EARFCN is the first integer,
+    // skip <Lband>, <ul_BW>, <dl_BW>, <tac> and <LcellId>,
+    // read <PCID>, skip <mTmsi>, <mmeGrId> and <mmeCode>,
+    // then RSRP is element 11 and RSRQ element 12, both
+    // coded as specified in TS 36.133
     uAtClientResponseStart(atHandle, NULL);
-    // EARFCN is the first integer
-    pRadioParameters->earfcn = uAtClientReadInt(atHandle);
-    // Skip <Lband>, <ul_BW>, <dl_BW>, <tac> and <LcellId>
-    uAtClientSkipParameters(atHandle, 5);
-    // Read <PCID>
-    pRadioParameters->cellId = uAtClientReadInt(atHandle);
-    // Skip <mTmsi>, <mmeGrId> and <mmeCode>
-    uAtClientSkipParameters(atHandle, 3);
-    // RSRP is element 11, coded as specified in TS 36.133
-    pRadioParameters->rsrpDbm = rsrpToDbm(uAtClientReadInt(atHandle));
-    // RSRQ is element 12, coded as specified in TS 36.133.
-    x = uAtClientReadInt(atHandle);
+    uAtClientReadIntList(atHandle, values, sizeof(values) / sizeof(values[0]),
+                         U_AT_CLIENT_READ_INT_LIST_SKIP(1, 5) |
+                         U_AT_CLIENT_READ_INT_LIST_SKIP(7, 3));
+    pRadioParameters->earfcn = values[0];
+    pRadioParameters->cellId = values[6];
+    pRadioParameters->rsrpDbm = rsrpToDbm(values[10]);
     if (uAtClientErrorGet(atHandle) == 0) {
-        // Note that this can be a negative integer, hence
+        // Note that RSRQ can be a negative integer, hence
         // we check for errors here so as not to mix up
         // what might be a negative error code with a
         // negative return value.
-        pRadioParameters->rsrqDb = rsrqToDb(x);
+        pRadioParameters->rsrqDb = rsrqToDb(values[11]);
     }
     uAtClientResponseStop(atHandle);
 
@@ -251,8 +304,7 @@ static int32_t getRadioParamsUcged2SaraR5(uAtClientHandle_t atHandle,
 static int32_t getRadioParamsUcged2SaraR422(uAtClientHandle_t atHandle,
                                             uCellPrivateRadioParameters_t *pRadioParameters)
 {
-    int32_t x;
-    int32_t y;
+    int32_t values[8];
 
     // +UCGED: 2
     // <rat>,<MCC>,<MNC>
@@ -269,25 +321,22 @@ static int32_t getRadioParamsUcged2SaraR422(uAtClientHandle_t atHandle,
     // Don't want anything from the next line
     uAtClientResponseStart(atHandle, NULL);
     uAtClientSkipParameters(atHandle, 3);
-    // Now the line of interest
+    // Now the line of interest: EARFCN is the first integer,
+    // skip <Lband>, <ul_BW>, <dl_BW> and <TAC>, read <P-CID>,
+    // then RSRP is element 7, as a plain-old dBm value, and
+    // RSRQ element 8, as a plain-old dB value
     uAtClientResponseStart(atHandle, NULL);
-    // EARFCN is the first integer
-    pRadioParameters->earfcn = uAtClientReadInt(atHandle);
-    // Skip <Lband>, <ul_BW>, <dl_BW> and <TAC>
-    uAtClientSkipParameters(atHandle, 4);
-    // Read <P-CID>
-    pRadioParameters->cellId = uAtClientReadInt(atHandle);
-    // RSRP is element 7, as a plain-old dBm value
-    x = uAtClientReadInt(atHandle);
-    // RSRQ is element 8, as a plain-old dB value.
-    y = uAtClientReadInt(atHandle);
+    uAtClientReadIntList(atHandle, values, sizeof(values) / sizeof(values[0]),
+                         U_AT_CLIENT_READ_INT_LIST_SKIP(1, 4));
+    pRadioParameters->earfcn = values[0];
+    pRadioParameters->cellId = values[5];
     if (uAtClientErrorGet(atHandle) == 0) {
         // Note that these last two are usually negative
         // integers, hence we check for errors here so as
         // not to mix up what might be a negative error
         // code with a negative return value.
-        pRadioParameters->rsrpDbm = x;
-        pRadioParameters->rsrqDb = y;
+        pRadioParameters->rsrpDbm = values[6];
+        pRadioParameters->rsrqDb = values[7];
     }
     uAtClientResponseStop(atHandle);
 
@@ -300,8 +349,7 @@ static int32_t getRadioParamsUcged2LaraR6(uAtClientHandle_t atHandle,
 {
     int32_t rat;
     int32_t skipParameters = 2;
-    int32_t x;
-    int32_t y;
+    int32_t values[12];
 
     // The formats are RAT dependent as follows:
     //
@@ -349,47 +397,43 @@ static int32_t getRadioParamsUcged2LaraR6(uAtClientHandle_t atHandle,
     uAtClientResponseStart(atHandle, NULL);
     switch (rat) {
         case 2:
-            // ARFCN is the first integer
-            pRadioParameters->earfcn = uAtClientReadInt(atHandle);
-            // Skip <band1900>
-            uAtClientSkipParameters(atHandle, 1);
-            // Read <GcellId>
-            pRadioParameters->cellId = uAtClientReadInt(atHandle);
-            // Ignore the rest; rssiDbm will have come in via CSQ
+            // ARFCN is the first integer, skip <band1900>,
+            // read <GcellId> and ignore the rest; rssiDbm will
+            // have come in via CSQ
+            uAtClientReadIntList(atHandle, values, 3,
+                                 U_AT_CLIENT_READ_INT_LIST_SKIP(1, 1));
+            pRadioParameters->earfcn = values[0];
+            pRadioParameters->cellId = values[2];
             break;
         case 3:
-            // UARFCN is the first integer
-            pRadioParameters->earfcn = uAtClientReadInt(atHandle);
-            // Skip <Wband>
-            uAtClientSkipParameters(atHandle, 1);
-            // Read <WcellId>
-            pRadioParameters->cellId = uAtClientReadInt(atHandle);
-            // Skip <Wlac>, <Wrac>, <scrambling_code> and <Wrrc>
-            uAtClientSkipParameters(atHandle, 4);
-            // Read <rssi> and convert it to dBm
-            pRadioParameters->rssiDbm = rssiUtranToDbm(uAtClientReadInt(atHandle));
-            // Ignore the rest
+            // UARFCN is the first integer, skip <Wband>, read
+            // <WcellId>, skip <Wlac>, <Wrac>, <scrambling_code>
+            // and <Wrrc>, read <rssi> and ignore the rest
+            uAtClientReadIntList(atHandle, values, 8,
+                                 U_AT_CLIENT_READ_INT_LIST_SKIP(1, 1) |
+                                 U_AT_CLIENT_READ_INT_LIST_SKIP(3, 4));
+            pRadioParameters->earfcn = values[0];
+            pRadioParameters->cellId = values[2];
+            pRadioParameters->rssiDbm = rssiUtranToDbm(values[7]);
             break;
         case 4:
-            // EARFCN is the first integer
-            pRadioParameters->earfcn = uAtClientReadInt(atHandle);
-            // Skip <Lband>, <ul_BW>, <dl_BW>, <TAC> and <LcellId>
-            uAtClientSkipParameters(atHandle, 5);
-            // Read <P-CID>
-            pRadioParameters->cellId = uAtClientReadInt(atHandle);
-            // Skip <mTmsi>, <mmeGrId> and <mmeCode>
-            uAtClientSkipParameters(atHandle, 3);
-            // RSRP is element 11, as a plain-old dBm value
-            x = uAtClientReadInt(atHandle);
-            // RSRQ is element 12, as a plain-old dB value.
-            y = uAtClientReadInt(atHandle);
+            // EARFCN is the first integer, skip <Lband>, <ul_BW>,
+            // <dl_BW>, <TAC> and <LcellId>, read <P-CID>, skip
+            // <mTmsi>, <mmeGrId> and <mmeCode>, then RSRP is
+            // element 11 and RSRQ element 12, as plain-old dBm
+            // and dB values
+            uAtClientReadIntList(atHandle, values, 12,
+                                 U_AT_CLIENT_READ_INT_LIST_SKIP(1, 5) |
+                                 U_AT_CLIENT_READ_INT_LIST_SKIP(7, 3));
+            pRadioParameters->earfcn = values[0];
+            pRadioParameters->cellId = values[6];
             if (uAtClientErrorGet(atHandle) == 0) {
                 // Note that these last two are usually negative
                 // integers, hence we check for errors here so as
                 // not to mix up what might be a negative error
                 // code with a negative return value.
-                pRadioParameters->rsrpDbm = x;
-                pRadioParameters->rsrqDb = y;
+                pRadioParameters->rsrpDbm = values[10];
+                pRadioParameters->rsrqDb = values[11];
             }
             break;
         default:
@@ -427,13 +471,15 @@ static int32_t getRadioParamsUcged5(uAtClientHandle_t atHandle,
                                     uCellPrivateRadioParameters_t *pRadioParameters)
 {
     char buffer[16];
+    int32_t values[2];
 
     uAtClientLock(atHandle);
     uAtClientCommandStart(atHandle, "AT+UCGED?");
     uAtClientCommandStop(atHandle);
     uAtClientResponseStart(atHandle, "+RSRP:");
-    pRadioParameters->cellId = uAtClientReadInt(atHandle);
-    pRadioParameters->earfcn = uAtClientReadInt(atHandle);
+    uAtClientReadIntList(atHandle, values, sizeof(values) / sizeof(values[0]), 0);
+    pRadioParameters->cellId = values[0];
+    pRadioParameters->earfcn = values[1];
     if (uAtClientReadString(atHandle, buffer, sizeof(buffer), false) > 0) {
         pRadioParameters->rsrpDbm = strToInt32(buffer);
     }
@@ -447,6 +493,415 @@ static int32_t getRadioParamsUcged5(uAtClientHandle_t atHandle,
     return uAtClientUnlock(atHandle);
 }
 
+// Work out the SNR from the RSSI and RSRP, see the comment
+// above uCellInfoGetSnrDb() for the derivation.
+static int32_t snrDbGet(const uCellPrivateRadioParameters_t *pRadioParameters,
+                        int32_t *pSnrDb)
+{
+    int32_t errorCode = (int32_t) U_CELL_ERROR_VALUE_OUT_OF_RANGE;
+
+    // SNR = RSRP / (RSSI - RSRP).
+    if ((pRadioParameters->rssiDbm != 0) &&
+        (pRadioParameters->rssiDbm <= pRadioParameters->rsrpDbm)) {
+        *pSnrDb = INT_MAX;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    } else if ((pRadioParameters->rssiDbm != 0) && (pRadioParameters->rsrpDbm != 0)) {
+        int32_t ix = pRadioParameters->rssiDbm - (pRadioParameters->rsrpDbm + 1);
+        if (ix >= 0) {
+            const signed char snrLut[] = {6, 2, 0, -2, -3, -5, -6, -7, -8, -10};
+            *pSnrDb = (ix < (int32_t) sizeof(snrLut)) ? snrLut[ix] : (- ix - 1);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Refresh the radio parameters; if verbose is true, as it will
+// be for a user call, pause between the AT commands, so as not
+// to overtask the module, and print the result.
+// Note: the instance should be locked before this is called.
+static int32_t refreshRadioParameters(uCellPrivateInstance_t *pInstance,
+                                      bool verbose)
+{
+    int32_t errorCode = (int32_t) U_CELL_ERROR_NOT_REGISTERED;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    uCellPrivateRadioParameters_t *pRadioParameters = &(pInstance->radioParameters);
+    uCellNetRat_t rat;
+
+    uCellPrivateClearRadioParameters(pRadioParameters);
+    if (uCellPrivateIsRegistered(pInstance)) {
+        // The mechanisms to get the radio information
+        // are different between EUTRAN and GERAN but
+        // AT+CSQ works in all cases though it sometimes
+        // doesn't return a reading.  Collect what we can
+        // with it
+        errorCode = getRadioParamsCsq(atHandle, pRadioParameters);
+        // Note that AT+UCGED is used next rather than AT+CESQ
+        // as, in my experience, it is more reliable in
+        // reporting answers.
+        if (verbose) {
+            // Allow a little sleepy-byes here, don't want to overtask
+            // the module if this is being called repeatedly
+            uPortTaskBlock(500);
+        }
+        if (U_CELL_PRIVATE_HAS(pInstance->pModule, U_CELL_PRIVATE_FEATURE_UCGED5)) {
+            // SARA-R4 (except 422) only supports UCGED=5, and it only
+            // supports it in EUTRAN mode
+            rat = uCellPrivateGetActiveRat(pInstance);
+            if (U_CELL_PRIVATE_RAT_IS_EUTRAN(rat)) {
+                errorCode = getRadioParamsUcged5(atHandle, pRadioParameters);
+            } else {
+                // Can't use AT+UCGED, that's all we can get
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        } else {
+            // The AT+UCGED=2 formats are module-specific
+            switch (pInstance->pModule->moduleType) {
+                case U_CELL_MODULE_TYPE_SARA_R5:
+                    errorCode = getRadioParamsUcged2SaraR5(atHandle, pRadioParameters);
+                    break;
+                case U_CELL_MODULE_TYPE_SARA_R422:
+                    errorCode = getRadioParamsUcged2SaraR422(atHandle, pRadioParameters);
+                    break;
+                case U_CELL_MODULE_TYPE_LARA_R6:
+                    errorCode = getRadioParamsUcged2LaraR6(atHandle, pRadioParameters);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (verbose) {
+        if (errorCode == 0) {
+            uPortLog("U_CELL_INFO: radio parameters refreshed:\n");
+            uPortLog("             RSSI:    %d dBm\n", pRadioParameters->rssiDbm);
+            uPortLog("             RSRP:    %d dBm\n", pRadioParameters->rsrpDbm);
+            uPortLog("             RSRQ:    %d dB\n", pRadioParameters->rsrqDb);
+            uPortLog("             RxQual:  %d\n", pRadioParameters->rxQual);
+            uPortLog("             cell ID: %d\n", pRadioParameters->cellId);
+            uPortLog("             EARFCN:  %d\n", pRadioParameters->earfcn);
+        } else {
+            uPortLog("U_CELL_INFO: unable to refresh radio parameters.\n");
+        }
+    }
+
+    return errorCode;
+}
+
+// Store the current radio parameters in the sampler's ring,
+// if the sampler is running, overwriting the oldest sample
+// if the ring is full.
+// Note: the instance should be locked before this is called.
+static void samplerStore(const uCellPrivateInstance_t *pInstance)
+{
+    uCellPrivateInfoSampler_t *pContext = pInstance->pInfoSampler;
+    uCellPrivateRadioSample_t *pSample;
+
+    if (pContext != NULL) {
+        pSample = pContext->pRing + pContext->next;
+        pSample->timeMs = uPortGetTickTimeMs();
+        pSample->radioParameters = pInstance->radioParameters;
+        pContext->next++;
+        if (pContext->next >= pContext->numMax) {
+            pContext->next = 0;
+        }
+        if (pContext->numStored < pContext->numMax) {
+            pContext->numStored++;
+        }
+    }
+}
+
+// Return a pointer to the sample in the sampler's ring that is
+// index samples older than the newest; index must be less than
+// pContext->numStored.
+static const uCellPrivateRadioSample_t *pSamplerGet(const uCellPrivateInfoSampler_t *pContext,
+                                                      size_t index)
+{
+    size_t x = pContext->next + pContext->numMax - 1 - index;
+
+    if (x >= pContext->numMax) {
+        x -= pContext->numMax;
+    }
+
+    return pContext->pRing + x;
+}
+
+// Timer callback for the sampler: a refresh blocks on
+// the AT interface so it can't be done here, instead it
+// is passed to the sampler task.
+static void samplerTimerCallback(const uPortTimerHandle_t timerHandle,
+                                 void *pParameter)
+{
+    uCellPrivateInfoSampler_t *pContext = (uCellPrivateInfoSampler_t *) pParameter;
+
+    (void) timerHandle;
+
+    // The IRQ form of send does not block: if the sampler task
+    // is still busy with the last sample this one is dropped
+    uPortEventQueueSendIrq(pContext->eventQueueHandle,
+                           &(pContext->cellHandle),
+                           sizeof(pContext->cellHandle));
+}
+
+// Event handler of the sampler task.
+static void samplerEventHandler(void *pParameter, size_t parameterLength)
+{
+    uDeviceHandle_t cellHandle = *((uDeviceHandle_t *) pParameter);
+    uCellPrivateInstance_t *pInstance;
+    uCellPrivateInfoSampler_t *pContext;
+
+    (void) parameterLength;
+
+    // Only wait for a limited time to lock the instance:
+    // uCellPrivateInfoSamplerRemoveContext() closes this event
+    // queue with the instance locked
+    pInstance = pUCellPrivateInstanceTryLock(cellHandle,
+                                             U_CELL_INFO_SAMPLER_LOCK_TIMEOUT_MS);
+    if (pInstance != NULL) {
+        pContext = pInstance->pInfoSampler;
+        // Don't wake the module up from power saving to take
+        // a sample and don't bother if a sample was taken
+        // recently, e.g. because of a user refresh
+        if ((pContext != NULL) &&
+            (pInstance->deepSleepState != U_CELL_PRIVATE_DEEP_SLEEP_STATE_PROTOCOL_STACK_ASLEEP) &&
+            (pInstance->deepSleepState != U_CELL_PRIVATE_DEEP_SLEEP_STATE_ASLEEP) &&
+            ((pContext->numStored == 0) ||
+             (uPortGetTickTimeMs() - pSamplerGet(pContext, 0)->timeMs >=
+              pContext->periodMs / 2)) &&
+            (refreshRadioParameters(pInstance, false) == 0)) {
+            samplerStore(pInstance);
+        }
+        uCellPrivateInstanceUnlock(pInstance);
+    }
+}
+
+// Convert a stored sample into the public form.
+static void samplerSampleConvert(const uCellPrivateRadioSample_t *pStored,
+                                 uCellInfoSample_t *pSample)
+{
+    pSample->timeMs = pStored->timeMs;
+    pSample->rssiDbm = pStored->radioParameters.rssiDbm;
+    pSample->rsrpDbm = pStored->radioParameters.rsrpDbm;
+    pSample->rsrqDb = pStored->radioParameters.rsrqDb;
+    pSample->rxQual = pStored->radioParameters.rxQual;
+    pSample->cellId = pStored->radioParameters.cellId;
+    pSample->earfcn = pStored->radioParameters.earfcn;
+    pSample->snrDbIsValid = (snrDbGet(&(pStored->radioParameters),
+                                      &(pSample->snrDb)) == 0);
+    if (!pSample->snrDbIsValid) {
+        pSample->snrDb = 0;
+    }
+}
+
+// Add a value to a set of sampler statistics.
+static void samplerStatsAdd(uCellInfoSampleStats_t *pStats,
+                            int64_t *pSum, int32_t value)
+{
+    if ((pStats->numSamples == 0) || (value < pStats->min)) {
+        pStats->min = value;
+    }
+    if ((pStats->numSamples == 0) || (value > pStats->max)) {
+        pStats->max = value;
+    }
+    *pSum += value;
+    pStats->numSamples++;
+}
+
+// Work out the mean of a set of sampler statistics.
+static void samplerStatsMean(uCellInfoSampleStats_t *pStats, int64_t sum)
+{
+    pStats->mean = 0;
+    if (pStats->numSamples > 0) {
+        pStats->mean = (int32_t) (sum / (int64_t) pStats->numSamples);
+    }
+}
+
+// Convert a time string of the form "yy/MM/dd,hh:mm:ss", optionally
+// followed by "+TZ", the time zone in 15 minute intervals, into Unix
+// UTC time; the contents of pBuffer are modified.
+static int64_t timeStrToUtc(char *pBuffer, int32_t length)
+{
+    int64_t timeUtc;
+    struct tm timeInfo;
+    size_t offset = 0;
+
+    // Two-digit year converted to years since 1900
+    offset = 0;
+    *(pBuffer + offset + 2) = 0;
+    timeInfo.tm_year = atoi(pBuffer + offset) + 2000 - 1900;
+    // Months converted to months since January
+    offset = 3;
+    *(pBuffer + offset + 2) = 0;
+    timeInfo.tm_mon = atoi(pBuffer + offset) - 1;
+    // Day of month
+    offset = 6;
+    *(pBuffer + offset + 2) = 0;
+    timeInfo.tm_mday = atoi(pBuffer + offset);
+    // Hours since midnight
+    offset = 9;
+    *(pBuffer + offset + 2) = 0;
+    timeInfo.tm_hour = atoi(pBuffer + offset);
+    // Minutes after the hour
+    offset = 12;
+    *(pBuffer + offset + 2) = 0;
+    timeInfo.tm_min = atoi(pBuffer + offset);
+    // Seconds after the hour
+    offset = 15;
+    *(pBuffer + offset + 2) = 0;
+    timeInfo.tm_sec = atoi(pBuffer + offset);
+    // Get the time in seconds from this
+    timeUtc = mktime64(&timeInfo);
+    if ((timeUtc >= 0) && (length >= 20)) {
+        // There's a timezone, expressed in 15 minute intervals,
+        // subtract it to get UTC
+        offset = 18;
+        *(pBuffer + offset + 2) = 0;
+        timeUtc -= ((int64_t) atoi(pBuffer + offset)) * 15 * 60;
+    }
+
+    return timeUtc;
+}
+
+// Read the UTC time from the module with AT+CCLK?.
+// Note: the instance should be locked before this is called.
+static int64_t timeUtcRead(const uCellPrivateInstance_t *pInstance)
+{
+    int64_t errorCodeOrValue;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    int64_t timeUtc;
+    char buffer[32];
+    int32_t bytesRead;
+
+    uAtClientLock(atHandle);
+    uAtClientCommandStart(atHandle, "AT+CCLK?");
+    uAtClientCommandStop(atHandle);
+    uAtClientResponseStart(atHandle, "+CCLK:");
+    bytesRead = uAtClientReadString(atHandle, buffer,
+                                    sizeof(buffer), false);
+    uAtClientResponseStop(atHandle);
+    errorCodeOrValue = uAtClientUnlock(atHandle);
+    if ((bytesRead >= 17) && (errorCodeOrValue == 0)) {
+        errorCodeOrValue = (int64_t) U_ERROR_COMMON_UNKNOWN;
+        uPortLog("U_CELL_INFO: time is %s.\n", buffer);
+        // The format of the returned string is
+        // "yy/MM/dd,hh:mm:ss+TZ" but the +TZ may be omitted
+        timeUtc = timeStrToUtc(buffer, bytesRead);
+        if (timeUtc >= 0) {
+            errorCodeOrValue = timeUtc;
+            uPortLog("U_CELL_INFO: UTC time is %d.\n", (int32_t) errorCodeOrValue);
+        } else {
+            uPortLog("U_CELL_INFO: unable to calculate UTC time.\n");
+        }
+    } else {
+        errorCodeOrValue = (int64_t) U_CELL_ERROR_AT;
+        uPortLog("U_CELL_INFO: unable to read time with AT+CCLK.\n");
+    }
+
+    return errorCodeOrValue;
+}
+
+// Bring the cached time base into line with the given Unix UTC time,
+// obtained at the given tick time, updating the statistics.
+static void timeBaseSync(uCellPrivateTimeBase_t *pContext,
+                         int64_t timeUtc, int32_t tickMs,
+                         bool fromUrc)
+{
+    // The module time only has a resolution of one second,
+    // the middle of that second is the best guess
+    int64_t utcMs = (timeUtc * 1000) + 500;
+    int32_t elapsedMs;
+    int64_t errorMs;
+
+    if (pContext->synced) {
+        elapsedMs = tickMs - pContext->syncTickMs;
+        if (elapsedMs > 0) {
+            errorMs = utcMs - (pContext->syncUtcMs + elapsedMs);
+            pContext->lastErrorMs = (int32_t) errorMs;
+            if (errorMs < 0) {
+                errorMs = -errorMs;
+            }
+            if (errorMs > pContext->maxAbsErrorMs) {
+                pContext->maxAbsErrorMs = (int32_t) errorMs;
+            }
+            pContext->lastDriftPpm = (int32_t) ((((int64_t) pContext->lastErrorMs) * 1000000) /
+                                                elapsedMs);
+        }
+    }
+    pContext->syncUtcMs = utcMs;
+    pContext->syncTickMs = tickMs;
+    pContext->synced = true;
+    pContext->resyncRequired = false;
+    pContext->numSyncs++;
+    if (fromUrc) {
+        pContext->numUrcSyncs++;
+    }
+}
+
+// Get the Unix UTC time from the cached time base, resyncing
+// first if required.
+// Note: the instance should be locked before this is called.
+static int64_t timeBaseGet(uCellPrivateInstance_t *pInstance)
+{
+    int64_t errorCodeOrValue = 0;
+    uCellPrivateTimeBase_t *pContext = pInstance->pTimeBase;
+    int32_t elapsedMs = uPortGetTickTimeMs() - pContext->syncTickMs;
+
+    // Note: a negative elapsed time means that the tick has wrapped
+    // since we last synced, in which case the cache is no good
+    if (!pContext->synced || pContext->resyncRequired || (elapsedMs < 0) ||
+        (elapsedMs >= pContext->resyncPeriodMs)) {
+        errorCodeOrValue = timeUtcRead(pInstance);
+        if (errorCodeOrValue >= 0) {
+            timeBaseSync(pContext, errorCodeOrValue, uPortGetTickTimeMs(), false);
+        }
+        elapsedMs = uPortGetTickTimeMs() - pContext->syncTickMs;
+    }
+    if (pContext->synced && (elapsedMs >= 0)) {
+        // Even if a resync failed, the cached time base is
+        // better than nothing
+        errorCodeOrValue = (pContext->syncUtcMs + elapsedMs) / 1000;
+    }
+
+    return errorCodeOrValue;
+}
+
+// URC for the network indicating a time zone change, which
+// may also carry the network time.
+static void CTZE_urc(uAtClientHandle_t atHandle, void *pParameter)
+{
+    uCellPrivateInstance_t *pInstance = (uCellPrivateInstance_t *) pParameter;
+    uCellPrivateTimeBase_t *pContext = pInstance->pTimeBase;
+    char buffer[32];
+    int32_t bytesRead;
+    int32_t timeZone = 0;
+    int64_t timeUtc;
+
+    // +CTZE: <tz>,<dst>[,<time>], where <tz> is a string, e.g. "+04"
+    // giving the local time zone, including daylight saving, in 15
+    // minute intervals and <time> is "yy/MM/dd,hh:mm:ss", local
+    bytesRead = uAtClientReadString(atHandle, buffer, sizeof(buffer), false);
+    if (bytesRead > 0) {
+        timeZone = atoi(buffer);
+    }
+    // Skip <dst>, it is already included in <tz>
+    uAtClientSkipParameters(atHandle, 1);
+    bytesRead = uAtClientReadString(atHandle, buffer, sizeof(buffer), false);
+    if (pContext != NULL) {
+        // Whatever happens, the network has told us something
+        // new so we must resync
+        pContext->resyncRequired = true;
+        if (bytesRead >= 17) {
+            timeUtc = timeStrToUtc(buffer, 17);
+            if (timeUtc >= 0) {
+                timeBaseSync(pContext, timeUtc - (((int64_t) timeZone) * 15 * 60),
+                             uPortGetTickTimeMs(), true);
+            }
+        }
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -456,76 +911,21 @@ int32_t uCellInfoRefreshRadioParameters(uDeviceHandle_t cellHandle)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    uCellPrivateRadioParameters_t *pRadioParameters;
-    uAtClientHandle_t atHandle;
-    uCellNetRat_t rat;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
-            errorCode = (int32_t) U_CELL_ERROR_NOT_REGISTERED;
-            atHandle = pInstance->atHandle;
-            pRadioParameters = &(pInstance->radioParameters);
-            uCellPrivateClearRadioParameters(pRadioParameters);
-            if (uCellPrivateIsRegistered(pInstance)) {
-                // The mechanisms to get the radio information
-                // are different between EUTRAN and GERAN but
-                // AT+CSQ works in all cases though it sometimes
-                // doesn't return a reading.  Collect what we can
-                // with it
-                errorCode = getRadioParamsCsq(atHandle, pRadioParameters);
-                // Note that AT+UCGED is used next rather than AT+CESQ
-                // as, in my experience, it is more reliable in
-                // reporting answers.
-                // Allow a little sleepy-byes here, don't want to overtask
-                // the module if this is being called repeatedly
-                uPortTaskBlock(500);
-                if (U_CELL_PRIVATE_HAS(pInstance->pModule, U_CELL_PRIVATE_FEATURE_UCGED5)) {
-                    // SARA-R4 (except 422) only supports UCGED=5, and it only
-                    // supports it in EUTRAN mode
-                    rat = uCellPrivateGetActiveRat(pInstance);
-                    if (U_CELL_PRIVATE_RAT_IS_EUTRAN(rat)) {
-                        errorCode = getRadioParamsUcged5(atHandle, pRadioParameters);
-                    } else {
-                        // Can't use AT+UCGED, that's all we can get
-                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-                    }
-                } else {
-                    // The AT+UCGED=2 formats are module-specific
-                    switch (pInstance->pModule->moduleType) {
-                        case U_CELL_MODULE_TYPE_SARA_R5:
-                            errorCode = getRadioParamsUcged2SaraR5(atHandle, pRadioParameters);
-                            break;
-                        case U_CELL_MODULE_TYPE_SARA_R422:
-                            errorCode = getRadioParamsUcged2SaraR422(atHandle, pRadioParameters);
-                            break;
-                        case U_CELL_MODULE_TYPE_LARA_R6:
-                            errorCode = getRadioParamsUcged2LaraR6(atHandle, pRadioParameters);
-                            break;
-                        default:
-                            break;
-                    }
-                }
-            }
-
+            errorCode = refreshRadioParameters(pInstance, true);
             if (errorCode == 0) {
-                uPortLog("U_CELL_INFO: radio parameters refreshed:\n");
-                uPortLog("             RSSI:    %d dBm\n", pRadioParameters->rssiDbm);
-                uPortLog("             RSRP:    %d dBm\n", pRadioParameters->rsrpDbm);
-                uPortLog("             RSRQ:    %d dB\n", pRadioParameters->rsrqDb);
-                uPortLog("             RxQual:  %d\n", pRadioParameters->rxQual);
-                uPortLog("             cell ID: %d\n", pRadioParameters->cellId);
-                uPortLog("             EARFCN:  %d\n", pRadioParameters->earfcn);
-            } else {
-                uPortLog("U_CELL_INFO: unable to refresh radio parameters.\n");
+                // If the sampler is running, this saves it the trouble
+                samplerStore(pInstance);
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -540,14 +940,13 @@ int32_t uCellInfoGetRssiDbm(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             errorCodeOrValue = pInstance->radioParameters.rssiDbm;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrValue;
@@ -562,14 +961,13 @@ int32_t uCellInfoGetRsrpDbm(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             errorCodeOrValue = pInstance->radioParameters.rsrpDbm;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrValue;
@@ -585,14 +983,13 @@ int32_t uCellInfoGetRsrqDb(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             errorCodeOrValue = pInstance->radioParameters.rsrqDb;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrValue;
@@ -606,15 +1003,14 @@ int32_t uCellInfoGetRxQual(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrValue = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrValue = pInstance->radioParameters.rxQual;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrValue;
@@ -677,33 +1073,17 @@ int32_t uCellInfoGetSnrDb(uDeviceHandle_t cellHandle, int32_t *pSnrDb)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    uCellPrivateRadioParameters_t *pRadioParameters;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pSnrDb != NULL)) {
-            pRadioParameters = &(pInstance->radioParameters);
-            errorCode = (int32_t) U_CELL_ERROR_VALUE_OUT_OF_RANGE;
-            // SNR = RSRP / (RSSI - RSRP).
-            if ((pRadioParameters->rssiDbm != 0) &&
-                (pRadioParameters->rssiDbm <= pRadioParameters->rsrpDbm)) {
-                *pSnrDb = INT_MAX;
-                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-            } else if ((pRadioParameters->rssiDbm != 0) && (pRadioParameters->rsrpDbm != 0)) {
-                int32_t ix = pRadioParameters->rssiDbm - (pRadioParameters->rsrpDbm + 1);
-                if (ix >= 0) {
-                    const signed char snrLut[] = {6, 2, 0, -2, -3, -5, -6, -7, -8, -10};
-                    *pSnrDb = (ix < (int32_t) sizeof(snrLut)) ? snrLut[ix] : (- ix - 1);
-                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-                }
-            }
+            errorCode = snrDbGet(&(pInstance->radioParameters), pSnrDb);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -717,15 +1097,14 @@ int32_t uCellInfoGetCellId(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrValue = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrValue = pInstance->radioParameters.cellId;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrValue;
@@ -739,15 +1118,14 @@ int32_t uCellInfoGetEarfcn(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrValue = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrValue = pInstance->radioParameters.earfcn;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrValue;
@@ -762,9 +1140,8 @@ int32_t uCellInfoGetImei(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pImei != NULL)) {
             errorCode = uCellPrivateGetImei(pInstance, pImei);
@@ -776,7 +1153,7 @@ int32_t uCellInfoGetImei(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -791,9 +1168,8 @@ int32_t uCellInfoGetImsi(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pImsi != NULL)) {
             errorCode = uCellPrivateGetImsi(pInstance, pImsi);
@@ -805,7 +1181,7 @@ int32_t uCellInfoGetImsi(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -819,32 +1195,47 @@ int32_t uCellInfoGetIccidStr(uDeviceHandle_t cellHandle,
     uCellPrivateInstance_t *pInstance;
     uAtClientHandle_t atHandle;
     int32_t bytesRead;
+    char *pCache;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
-            atHandle = pInstance->atHandle;
-            uAtClientLock(atHandle);
-            uAtClientCommandStart(atHandle, "AT+CCID");
-            uAtClientCommandStop(atHandle);
-            uAtClientResponseStart(atHandle, "+CCID:");
-            bytesRead = uAtClientReadString(atHandle, pStr, size, false);
-            uAtClientResponseStop(atHandle);
-            errorCodeOrSize = uAtClientUnlock(atHandle);
-            if ((bytesRead >= 0) && (errorCodeOrSize == 0)) {
-                errorCodeOrSize = bytesRead;
-                uPortLog("U_CELL_INFO: ICCID is %s.\n", pStr);
+            pCache = pInstance->identityCache.iccidStr;
+            if (*pCache != 0) {
+                // Cached, the SIM can't have changed since
+                errorCodeOrSize = (int32_t) strlen(pCache);
+                if (errorCodeOrSize > (int32_t) size - 1) {
+                    errorCodeOrSize = (int32_t) size - 1;
+                }
+                memcpy(pStr, pCache, errorCodeOrSize);
+                *(pStr + errorCodeOrSize) = 0;
             } else {
-                errorCodeOrSize = (int32_t) U_CELL_ERROR_AT;
-                uPortLog("U_CELL_INFO: unable to read ICCID.\n");
+                atHandle = pInstance->atHandle;
+                uAtClientLock(atHandle);
+                uAtClientCommandStart(atHandle, "AT+CCID");
+                uAtClientCommandStop(atHandle);
+                uAtClientResponseStart(atHandle, "+CCID:");
+                bytesRead = uAtClientReadString(atHandle, pStr, size, false);
+                uAtClientResponseStop(atHandle);
+                errorCodeOrSize = uAtClientUnlock(atHandle);
+                if ((bytesRead >= 0) && (errorCodeOrSize == 0)) {
+                    errorCodeOrSize = bytesRead;
+                    uPortLog("U_CELL_INFO: ICCID is %s.\n", pStr);
+                    if ((bytesRead > 0) && (bytesRead < (int32_t) size - 1) &&
+                        (bytesRead <= U_CELL_PRIVATE_IDENTITY_STR_MAX_LENGTH_BYTES)) {
+                        memcpy(pCache, pStr, bytesRead + 1);
+                    }
+                } else {
+                    errorCodeOrSize = (int32_t) U_CELL_ERROR_AT;
+                    uPortLog("U_CELL_INFO: unable to read ICCID.\n");
+                }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -859,16 +1250,15 @@ int32_t uCellInfoGetManufacturerStr(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
             errorCodeOrSize = getString(pInstance->atHandle, "AT+CGMI",
                                         pStr, size);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -883,16 +1273,16 @@ int32_t uCellInfoGetModelStr(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
-            errorCodeOrSize = getString(pInstance->atHandle, "AT+CGMM",
-                                        pStr, size);
+            errorCodeOrSize = getStringCached(pInstance, "AT+CGMM",
+                                              pInstance->identityCache.modelStr,
+                                              pStr, size);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -907,17 +1297,17 @@ int32_t uCellInfoGetFirmwareVersionStr(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
             // Use ATI9 instead of AT+CGMR as it contains more information
-            errorCodeOrSize = getString(pInstance->atHandle, "ATI9",
-                                        pStr, size);
+            errorCodeOrSize = getStringCached(pInstance, "ATI9",
+                                              pInstance->identityCache.firmwareVersionStr,
+                                              pStr, size);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -928,85 +1318,154 @@ int64_t uCellInfoGetTimeUtc(uDeviceHandle_t cellHandle)
 {
     int64_t errorCodeOrValue = (int64_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
-    int64_t timeUtc;
-    char buffer[32];
-    struct tm timeInfo;
-    int32_t bytesRead;
-    size_t offset = 0;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrValue = (int64_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
-            atHandle = pInstance->atHandle;
-            uAtClientLock(atHandle);
-            uAtClientCommandStart(atHandle, "AT+CCLK?");
-            uAtClientCommandStop(atHandle);
-            uAtClientResponseStart(atHandle, "+CCLK:");
-            bytesRead = uAtClientReadString(atHandle, buffer,
-                                            sizeof(buffer), false);
-            uAtClientResponseStop(atHandle);
-            errorCodeOrValue = uAtClientUnlock(atHandle);
-            if ((bytesRead >= 17) && (errorCodeOrValue == 0)) {
-                errorCodeOrValue = (int64_t) U_ERROR_COMMON_UNKNOWN;
-                uPortLog("U_CELL_INFO: time is %s.\n", buffer);
-                // The format of the returned string is
-                // "yy/MM/dd,hh:mm:ss+TZ" but the +TZ may be omitted
-
-                // Two-digit year converted to years since 1900
-                offset = 0;
-                buffer[offset + 2] = 0;
-                timeInfo.tm_year = atoi(&(buffer[offset])) + 2000 - 1900;
-                // Months converted to months since January
-                offset = 3;
-                buffer[offset + 2] = 0;
-                timeInfo.tm_mon = atoi(&(buffer[offset])) - 1;
-                // Day of month
-                offset = 6;
-                buffer[offset + 2] = 0;
-                timeInfo.tm_mday = atoi(&(buffer[offset]));
-                // Hours since midnight
-                offset = 9;
-                buffer[offset + 2] = 0;
-                timeInfo.tm_hour = atoi(&(buffer[offset]));
-                // Minutes after the hour
-                offset = 12;
-                buffer[offset + 2] = 0;
-                timeInfo.tm_min = atoi(&(buffer[offset]));
-                // Seconds after the hour
-                offset = 15;
-                buffer[offset + 2] = 0;
-                timeInfo.tm_sec = atoi(&(buffer[offset]));
-                // Get the time in seconds from this
-                timeUtc = mktime64(&timeInfo);
-                if ((timeUtc >= 0) && (bytesRead >= 20)) {
-                    // There's a timezone, expressed in 15 minute intervals,
-                    // subtract it to get UTC
-                    offset = 18;
-                    buffer[offset + 2] = 0;
-                    timeUtc -= ((int64_t) atoi(&(buffer[offset]))) * 15 * 60;
+            if (pInstance->pTimeBase != NULL) {
+                errorCodeOrValue = timeBaseGet(pInstance);
+            } else {
+                errorCodeOrValue = timeUtcRead(pInstance);
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrValue;
+}
+
+// Start a cached time base.
+int32_t uCellInfoTimeBaseStart(uDeviceHandle_t cellHandle,
+                               int32_t resyncPeriodSeconds)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellPrivateTimeBase_t *pContext;
+    uAtClientHandle_t atHandle;
+    int32_t ctzr;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) &&
+            (resyncPeriodSeconds <= U_CELL_INFO_TIME_BASE_RESYNC_PERIOD_MAX_SECONDS)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            pContext = pInstance->pTimeBase;
+            if (pContext == NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pContext = (uCellPrivateTimeBase_t *) malloc(sizeof(*pContext));
+                if (pContext != NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    memset(pContext, 0, sizeof(*pContext));
+                    pContext->ctzrAtStart = -1;
+                    atHandle = pInstance->atHandle;
+                    // Switch on +CTZE, which carries network time, not
+                    // an error if this fails, we just won't get it
+                    uAtClientLock(atHandle);
+                    uAtClientCommandStart(atHandle, "AT+CTZR?");
+                    uAtClientCommandStop(atHandle);
+                    uAtClientResponseStart(atHandle, "+CTZR:");
+                    ctzr = uAtClientReadInt(atHandle);
+                    uAtClientResponseStop(atHandle);
+                    if ((uAtClientUnlock(atHandle) == 0) && (ctzr >= 0) && (ctzr != 2)) {
+                        uAtClientLock(atHandle);
+                        uAtClientCommandStart(atHandle, "AT+CTZR=");
+                        uAtClientWriteInt(atHandle, 2);
+                        uAtClientCommandStopReadResponse(atHandle);
+                        if (uAtClientUnlock(atHandle) == 0) {
+                            pContext->ctzrAtStart = ctzr;
+                        }
+                    }
+                    uAtClientSetUrcHandler(atHandle, "+CTZE:",
+                                           CTZE_urc, pInstance);
+                    pInstance->pTimeBase = pContext;
                 }
+            }
+            if (pContext != NULL) {
+                if (resyncPeriodSeconds <= 0) {
+                    resyncPeriodSeconds = U_CELL_INFO_TIME_BASE_RESYNC_PERIOD_SECONDS;
+                }
+                pContext->resyncPeriodMs = resyncPeriodSeconds * 1000;
+                // Do the first sync now; it doesn't matter if this
+                // fails, it will be done again when the time is next
+                // asked for
+                pContext->resyncRequired = true;
+                timeBaseGet(pInstance);
+            }
+        }
 
-                if (timeUtc >= 0) {
-                    errorCodeOrValue = timeUtc;
-                    uPortLog("U_CELL_INFO: UTC time is %d.\n", (int32_t) errorCodeOrValue);
-                } else {
-                    uPortLog("U_CELL_INFO: unable to calculate UTC time.\n");
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Stop the cached time base.
+void uCellInfoTimeBaseStop(uDeviceHandle_t cellHandle)
+{
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        if ((pInstance != NULL) && (pInstance->pTimeBase != NULL)) {
+            if (pInstance->pTimeBase->ctzrAtStart >= 0) {
+                atHandle = pInstance->atHandle;
+                uAtClientLock(atHandle);
+                uAtClientCommandStart(atHandle, "AT+CTZR=");
+                uAtClientWriteInt(atHandle, pInstance->pTimeBase->ctzrAtStart);
+                uAtClientCommandStopReadResponse(atHandle);
+                uAtClientUnlock(atHandle);
+            }
+            uCellPrivateTimeBaseRemoveContext(pInstance);
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+}
+
+// Get the statistics of the cached time base.
+int32_t uCellInfoTimeBaseGetStats(uDeviceHandle_t cellHandle,
+                                  uCellInfoTimeBaseStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    const uCellPrivateTimeBase_t *pContext;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pStats != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            pContext = pInstance->pTimeBase;
+            if (pContext != NULL) {
+                pStats->numSyncs = pContext->numSyncs;
+                pStats->numUrcSyncs = pContext->numUrcSyncs;
+                pStats->lastSyncAgeMs = -1;
+                if (pContext->synced) {
+                    pStats->lastSyncAgeMs = uPortGetTickTimeMs() - pContext->syncTickMs;
                 }
-            } else {
-                errorCodeOrValue = (int64_t) U_CELL_ERROR_AT;
-                uPortLog("U_CELL_INFO: unable to read time with AT+CCLK.\n");
+                pStats->lastErrorMs = pContext->lastErrorMs;
+                pStats->maxAbsErrorMs = pContext->maxAbsErrorMs;
+                pStats->lastDriftPpm = pContext->lastDriftPpm;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
-    return errorCodeOrValue;
+    return errorCode;
 }
 
 /* Get the UTC time string according to cellular */
@@ -1025,9 +1484,8 @@ int32_t uCellInfoGetTimeUtcStr(uDeviceHandle_t cellHandle, char *pStr, size_t si
 
     if (gUCellPrivateMutex != NULL && sizeOrErrorCode == 0) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
@@ -1049,7 +1507,7 @@ int32_t uCellInfoGetTimeUtcStr(uDeviceHandle_t cellHandle, char *pStr, size_t si
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return sizeOrErrorCode;
@@ -1065,9 +1523,8 @@ bool uCellInfoIsRtsFlowControlEnabled(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             atStreamHandle = uAtClientStreamGet(pInstance->atHandle, &atStreamType);
             if (atStreamType == U_AT_CLIENT_STREAM_TYPE_UART) {
@@ -1075,7 +1532,7 @@ bool uCellInfoIsRtsFlowControlEnabled(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isEnabled;
@@ -1091,9 +1548,8 @@ bool uCellInfoIsCtsFlowControlEnabled(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             atStreamHandle = uAtClientStreamGet(pInstance->atHandle, &atStreamType);
             if (atStreamType == U_AT_CLIENT_STREAM_TYPE_UART) {
@@ -1101,10 +1557,184 @@ bool uCellInfoIsCtsFlowControlEnabled(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isEnabled;
 }
 
+
+// Start the radio parameter sampler.
+int32_t uCellInfoSamplerStart(uDeviceHandle_t cellHandle,
+                              int32_t periodMs, size_t historyLength)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellPrivateInfoSampler_t *pContext;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (periodMs > 0) && (historyLength > 0)) {
+            // Start again if the sampler was already running
+            uCellPrivateInfoSamplerRemoveContext(pInstance);
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pContext = (uCellPrivateInfoSampler_t *) malloc(sizeof(*pContext));
+            if (pContext != NULL) {
+                memset(pContext, 0, sizeof(*pContext));
+                pContext->cellHandle = cellHandle;
+                pContext->periodMs = periodMs;
+                pContext->numMax = historyLength;
+                pContext->eventQueueHandle = -1;
+                pContext->pRing = (uCellPrivateRadioSample_t *) malloc(sizeof(*(pContext->pRing)) *
+                                                                        historyLength);
+                pInstance->pInfoSampler = pContext;
+                if (pContext->pRing != NULL) {
+                    errorCode = uPortEventQueueOpen(samplerEventHandler,
+                                                    "cellInfoSampler",
+                                                    sizeof(pContext->cellHandle),
+                                                    U_CELL_INFO_SAMPLER_TASK_STACK_SIZE_BYTES,
+                                                    U_CELL_INFO_SAMPLER_TASK_PRIORITY,
+                                                    1);
+                    if (errorCode >= 0) {
+                        pContext->eventQueueHandle = errorCode;
+                        errorCode = uPortTimerCreate(&(pContext->timerHandle),
+                                                     "cellInfoSampler",
+                                                     samplerTimerCallback,
+                                                     pContext, periodMs, true);
+                    }
+                    if (errorCode == 0) {
+                        errorCode = uPortTimerStart(pContext->timerHandle);
+                    }
+                    if (errorCode == 0) {
+                        // Take the first sample straight away
+                        uPortEventQueueSend(pContext->eventQueueHandle,
+                                            &(pContext->cellHandle),
+                                            sizeof(pContext->cellHandle));
+                    }
+                }
+                if (errorCode != 0) {
+                    // Clean up
+                    uCellPrivateInfoSamplerRemoveContext(pInstance);
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Stop the radio parameter sampler.
+void uCellInfoSamplerStop(uDeviceHandle_t cellHandle)
+{
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        if (pInstance != NULL) {
+            uCellPrivateInfoSamplerRemoveContext(pInstance);
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+}
+
+// Get the most recent samples from the radio parameter sampler.
+int32_t uCellInfoSamplerGetHistory(uDeviceHandle_t cellHandle,
+                                   uCellInfoSample_t *pSamples,
+                                   size_t numSamples)
+{
+    int32_t errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    const uCellPrivateInfoSampler_t *pContext;
+    size_t x;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrNumber = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && ((pSamples != NULL) || (numSamples == 0))) {
+            errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+            pContext = pInstance->pInfoSampler;
+            if (pContext != NULL) {
+                for (x = 0; (x < numSamples) && (x < pContext->numStored); x++) {
+                    samplerSampleConvert(pSamplerGet(pContext, x), pSamples + x);
+                }
+                errorCodeOrNumber = (int32_t) x;
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrNumber;
+}
+
+// Get a summary of the samples taken by the radio parameter sampler.
+int32_t uCellInfoSamplerGetSummary(uDeviceHandle_t cellHandle,
+                                   int32_t windowMs,
+                                   uCellInfoSampleSummary_t *pSummary)
+{
+    int32_t errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    const uCellPrivateInfoSampler_t *pContext;
+    uCellInfoSample_t sample;
+    int64_t sum[4] = {0};
+    int32_t nowMs = uPortGetTickTimeMs();
+    size_t x;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrNumber = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pSummary != NULL)) {
+            errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+            pContext = pInstance->pInfoSampler;
+            if (pContext != NULL) {
+                memset(pSummary, 0, sizeof(*pSummary));
+                x = 0;
+                // Samples are stored oldest to newest so, starting
+                // from the newest, stop at the first one outside
+                // the window
+                while ((x < pContext->numStored) &&
+                       ((windowMs <= 0) ||
+                        (nowMs - pSamplerGet(pContext, x)->timeMs <= windowMs))) {
+                    samplerSampleConvert(pSamplerGet(pContext, x), &sample);
+                    // Leave out values that are not known
+                    if (sample.rssiDbm != 0) {
+                        samplerStatsAdd(&(pSummary->rssiDbm), &(sum[0]), sample.rssiDbm);
+                    }
+                    if (sample.rsrpDbm != 0) {
+                        samplerStatsAdd(&(pSummary->rsrpDbm), &(sum[1]), sample.rsrpDbm);
+                    }
+                    if (sample.rsrqDb != 0x7FFFFFFF) {
+                        samplerStatsAdd(&(pSummary->rsrqDb), &(sum[2]), sample.rsrqDb);
+                    }
+                    if (sample.snrDbIsValid && (sample.snrDb != INT_MAX)) {
+                        samplerStatsAdd(&(pSummary->snrDb), &(sum[3]), sample.snrDb);
+                    }
+                    x++;
+                }
+                samplerStatsMean(&(pSummary->rssiDbm), sum[0]);
+                samplerStatsMean(&(pSummary->rsrpDbm), sum[1]);
+                samplerStatsMean(&(pSummary->rsrqDb), sum[2]);
+                samplerStatsMean(&(pSummary->snrDb), sum[3]);
+                errorCodeOrNumber = (int32_t) x;
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrNumber;
+}
+
 // End of file
@@ -88,19 +88,43 @@
 # define U_CELL_MQTT_CONNECT_DELAY_MILLISECONDS 1000
 #endif
 
+#ifndef U_CELL_MQTT_PUBLISH_POLL_INTERVAL_MS
+/** The interval at which to check for the URC that says a publish
+ * has completed; this sets the granularity of publish latency so
+ * it should be short compared with a network round trip.
+ */
+# define U_CELL_MQTT_PUBLISH_POLL_INTERVAL_MS 20
+#endif
+
+#ifndef U_CELL_MQTT_PUBLISH_POKE_INTERVAL_MS
+/** While waiting for the URC that says a publish has completed,
+ * the interval at which to poke the module with "AT" in case it
+ * has gone to sleep while withholding the URC.
+ */
+# define U_CELL_MQTT_PUBLISH_POKE_INTERVAL_MS 1000
+#endif
+
+#ifndef U_CELL_MQTT_MULTI_POLL_MS
+/** The interval at which to check for the URCs that carry the
+ * outcomes of uCellMqttSubscribeMulti() or uCellMqttUnsubscribeMulti().
+ */
+# define U_CELL_MQTT_MULTI_POLL_MS 50
+#endif
+
 /** Helper macro to make sure that the entry and exit functions
  * are always called.
  */
 #define U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, ppInstance, pErrorCode, mustBeInitialised) \
-                                   { entryFunction(cellHandle, \
-                                                   ppInstance, \
-                                                   pErrorCode, \
-                                                   mustBeInitialised)
+                                   { uCellPrivateInstance_t *pCellLockedInstance = \
+                                         entryFunction(cellHandle, \
+                                                       ppInstance, \
+                                                       pErrorCode, \
+                                                       mustBeInitialised)
 
 /** Helper macro to make sure that the entry and exit functions
  * are always called.
  */
-#define U_CELL_MQTT_EXIT_FUNCTION() } exitFunction()
+#define U_CELL_MQTT_EXIT_FUNCTION() exitFunction(pCellLockedInstance); }
 
 /** Flag bits for the flags field in uCellMqttUrcStatus_t.
  */
@@ -239,6 +263,14 @@ typedef struct {
     int32_t localPortNumber;
     int32_t inactivityTimeoutSeconds;
     int32_t securityProfileId;
+    // The remaining parameters are used
+    // only while a multiple subscribe or
+    // unsubscribe is in progress
+    int32_t *pMultiResults; /**< where to put the outcome of each
+                                 subscribe/unsubscribe URC, in order,
+                                 NULL if not in progress. */
+    size_t multiCount;      /**< the number of outcomes put there. */
+    size_t multiMax;        /**< the size of the pMultiResults array. */
 } uCellMqttUrcStatus_t;
 
 /** Struct to hold a message that has been read in a callback,
@@ -343,20 +375,23 @@ static void messageIndicationCallback(uAtClientHandle_t atHandle,
     //lint -e(507) Suppress size incompatibility due to the compiler
     // we use for Linting being a 64 bit one where the pointer
     // is 64 bit.
-    volatile uCellMqttContext_t *pContext = (volatile uCellMqttContext_t *) pParam;
+    const uCellPrivateInstance_t *pInstance = (const uCellPrivateInstance_t *) pParam;
+    uCellPrivateInstance_t *pLockedInstance;
+    volatile uCellMqttContext_t *pContext;
 
     (void) atHandle;
 
-    // This task can lock the mutex to ensure we are thread-safe
+    // This task can lock the instance to ensure we are thread-safe
     // for the call below
-    U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
-
-    if ((pContext != NULL) && (pContext->pMessageIndicationCallback != NULL)) {
-        pContext->pMessageIndicationCallback((int32_t) pContext->numUnreadMessages,
-                                             pContext->pMessageIndicationCallbackParam);
+    pLockedInstance = pUCellPrivateInstanceLock(pInstance->cellHandle);
+    if (pLockedInstance != NULL) {
+        pContext = (volatile uCellMqttContext_t *) pLockedInstance->pMqttContext;
+        if ((pContext != NULL) && (pContext->pMessageIndicationCallback != NULL)) {
+            pContext->pMessageIndicationCallback((int32_t) pContext->numUnreadMessages,
+                                                 pContext->pMessageIndicationCallbackParam);
+        }
+        uCellPrivateInstanceUnlock(pLockedInstance);
     }
-
-    U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
 }
 
 // A local "trampoline" for the disconnect callback,
@@ -371,20 +406,22 @@ static void disconnectCallback(uAtClientHandle_t atHandle,
     // we use for Linting being a 64 bit one where the pointer
     // is 64 bit.
     const uCellPrivateInstance_t *pInstance = (const uCellPrivateInstance_t *) pParam;
-    volatile uCellMqttContext_t *pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+    uCellPrivateInstance_t *pLockedInstance;
+    volatile uCellMqttContext_t *pContext;
 
     (void) atHandle;
 
-    // This task can lock the mutex to ensure we are thread-safe
+    // This task can lock the instance to ensure we are thread-safe
     // for the call below
-    U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
-
-    if ((pContext != NULL) && (pContext->pDisconnectCallback != NULL)) {
-        pContext->pDisconnectCallback(getLastMqttErrorCode(pInstance),
-                                      pContext->pDisconnectCallbackParam);
+    pLockedInstance = pUCellPrivateInstanceLock(pInstance->cellHandle);
+    if (pLockedInstance != NULL) {
+        pContext = (volatile uCellMqttContext_t *) pLockedInstance->pMqttContext;
+        if ((pContext != NULL) && (pContext->pDisconnectCallback != NULL)) {
+            pContext->pDisconnectCallback(getLastMqttErrorCode(pLockedInstance),
+                                          pContext->pDisconnectCallbackParam);
+        }
+        uCellPrivateInstanceUnlock(pLockedInstance);
     }
-
-    U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
 }
 
 // "+UUMQTTC:"/"+UUMQTTSNC" URC handler, called by the UUMQTT_urc()
@@ -482,6 +519,16 @@ static void UUMQTTC_UUMQTTSNC_urc(uAtClientHandle_t atHandle,
                 pUrcStatus->subscribeQoS = (uCellMqttQos_t) urcParam2;
             }
         }
+        if ((pUrcStatus->pMultiResults != NULL) &&
+            (pUrcStatus->multiCount < pUrcStatus->multiMax)) {
+            // Part of a multiple subscribe
+            pUrcStatus->pMultiResults[pUrcStatus->multiCount] = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            if ((pUrcStatus->flagsBitmap & (1 << U_CELL_MQTT_URC_FLAG_SUBSCRIBE_SUCCESS)) != 0) {
+                pUrcStatus->pMultiResults[pUrcStatus->multiCount] = urcParam2;
+            }
+            pUrcStatus->flagsBitmap &= ~(1 << U_CELL_MQTT_URC_FLAG_SUBSCRIBE_SUCCESS);
+            pUrcStatus->multiCount++;
+        }
         pUrcStatus->flagsBitmap |= 1 << U_CELL_MQTT_URC_FLAG_SUBSCRIBE_UPDATED;
     } else if (urcType == MQTT_COMMAND_OPCODE_UNSUBSCRIBE(mqttSn)) {
         // Unsubscribe, 1 means success
@@ -489,6 +536,14 @@ static void UUMQTTC_UUMQTTSNC_urc(uAtClientHandle_t atHandle,
             // Unsubscribed
             pUrcStatus->flagsBitmap |= 1 << U_CELL_MQTT_URC_FLAG_UNSUBSCRIBE_SUCCESS;
         }
+        if ((pUrcStatus->pMultiResults != NULL) &&
+            (pUrcStatus->multiCount < pUrcStatus->multiMax)) {
+            // Part of a multiple unsubscribe
+            pUrcStatus->pMultiResults[pUrcStatus->multiCount] = (urcParam1 == 1) ?
+                                                                (int32_t) U_ERROR_COMMON_SUCCESS :
+                                                                (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            pUrcStatus->multiCount++;
+        }
         pUrcStatus->flagsBitmap |= 1 << U_CELL_MQTT_URC_FLAG_UNSUBSCRIBE_UPDATED;
     } else if (urcType == MQTT_COMMAND_OPCODE_READ(mqttSn)) {
         // Read: urcParam1 contains the number of unread messages
@@ -504,7 +559,7 @@ static void UUMQTTC_UUMQTTSNC_urc(uAtClientHandle_t atHandle,
                 //lint -e(1773) Suppress complaints about
                 // passing the pointer as non-volatile
                 uAtClientCallback(atHandle, messageIndicationCallback,
-                                  (void *) pContext);
+                                  (void *) pInstance);
             }
         }
         pUrcStatus->flagsBitmap |= 1 << U_CELL_MQTT_URC_FLAG_UNREAD_MESSAGES_UPDATED;
@@ -546,7 +601,8 @@ static void UUMQTTC_UUMQTTSNC_urc(uAtClientHandle_t atHandle,
 // resetUrcStatusField() and checkUrcStatusField()
 static void UUMQTTx_urc(uAtClientHandle_t atHandle,
                         volatile uCellMqttContext_t *pContext,
-                        int32_t x)
+                        int32_t x,
+                        const uCellPrivateInstance_t *pInstance)
 {
     volatile uCellMqttUrcStatus_t *pUrcStatus = &(pContext->urcStatus);
     char delimiter = uAtClientDelimiterGet(atHandle);
@@ -626,7 +682,8 @@ static void UUMQTTx_urc(uAtClientHandle_t atHandle,
 // "+UUMQTTCM:" URC handler, for SARA-R4 only,
 // called by the UUMQTT_urc() URC handler.
 static void UUMQTTCM_urc(uAtClientHandle_t atHandle,
-                         volatile uCellMqttContext_t *pContext)
+                         volatile uCellMqttContext_t *pContext,
+                         const uCellPrivateInstance_t *pInstance)
 {
     volatile uCellMqttUrcMessage_t *pUrcMessage = pContext->pUrcMessage;
     int32_t x;
@@ -730,7 +787,7 @@ static void UUMQTTCM_urc(uAtClientHandle_t atHandle,
             //lint -e(1773) Suppress complaints about
             // passing the pointer as non-volatile
             uAtClientCallback(atHandle, messageIndicationCallback,
-                              (void *) pContext);
+                              (void *) pInstance);
         }
     }
     uAtClientRestoreStopTag(atHandle);
@@ -758,7 +815,7 @@ static void UUMQTT_urc(uAtClientHandle_t atHandle,
                     // Either "+UUMQTTC" or "+UUMQTTCM"
                     if (bytes[1] == 'M') {
                         if (pContext->pUrcMessage != NULL) {
-                            UUMQTTCM_urc(atHandle, pContext);
+                            UUMQTTCM_urc(atHandle, pContext, pInstance);
                         }
                     } else {
                         UUMQTTC_UUMQTTSNC_urc(atHandle, pContext, pInstance);
@@ -779,7 +836,7 @@ static void UUMQTT_urc(uAtClientHandle_t atHandle,
                             bytes[1] = 0;
                         }
                         UUMQTTx_urc(atHandle, pContext,
-                                    strtol((char *) bytes, NULL, 10));
+                                    strtol((char *) bytes, NULL, 10), pInstance);
                     }
                 }
             } else {
@@ -800,7 +857,7 @@ static void UUMQTT_urc(uAtClientHandle_t atHandle,
  * STATIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
 
-// Check all the basics and lock the mutex, MUST be called at the
+// Check all the basics and lock the instance, MUST be called at the
 // start of every API function; use the helper macro
 // U_CELL_MQTT_ENTRY_FUNCTION to be sure of this, rather than calling
 // this function directly.
@@ -812,21 +869,22 @@ static void UUMQTT_urc(uAtClientHandle_t atHandle,
 // may be NULL.  This latter case is only useful when this function
 // is called from uCellMqttInit(), normally you want to call this
 // function with mustBeInitialised set to true.  In all cases the
-// cellular mutex will be locked.
-static void entryFunction(uDeviceHandle_t cellHandle,
-                          uCellPrivateInstance_t **ppInstance,
-                          int32_t *pErrorCode,
-                          bool mustBeInitialised)
-{
+// instance, if there is one, will be locked and is returned, to be
+// passed to exitFunction().
+static uCellPrivateInstance_t *entryFunction(uDeviceHandle_t cellHandle,
+                                             uCellPrivateInstance_t **ppInstance,
+                                             int32_t *pErrorCode,
+                                             bool mustBeInitialised)
+{
+    uCellPrivateInstance_t *pLockedInstance = NULL;
     uCellPrivateInstance_t *pInstance = NULL;
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
 
     if (gUCellPrivateMutex != NULL) {
 
-        uPortMutexLock(gUCellPrivateMutex);
-
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUCellPrivateGetInstance(cellHandle);
+        pLockedInstance = pUCellPrivateInstanceLock(cellHandle);
+        pInstance = pLockedInstance;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -855,17 +913,17 @@ static void entryFunction(uDeviceHandle_t cellHandle,
     if (pErrorCode != NULL) {
         *pErrorCode = errorCode;
     }
+
+    return pLockedInstance;
 }
 
 // MUST be called at the end of every API function to unlock
-// the cellular mutex; use the helper macro
+// the instance; use the helper macro
 // U_CELL_MQTT_EXIT_FUNCTION to be sure of this, rather than calling
 // this function directly.
-static void exitFunction()
+static void exitFunction(uCellPrivateInstance_t *pLockedInstance)
 {
-    if (gUCellPrivateMutex != NULL) {
-        uPortMutexUnlock(gUCellPrivateMutex);
-    }
+    uCellPrivateInstanceUnlock(pLockedInstance);
 }
 
 // Print the error state of MQTT.
@@ -1489,6 +1547,7 @@ static int32_t publish(const uCellPrivateInstance_t *pInstance,
     bool isAscii;
     bool messageWritten = false;
     int32_t startTimeMs;
+    int32_t pokeTimeMs;
     size_t tryCount = 0;
 
     pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
@@ -1637,19 +1696,25 @@ static int32_t publish(const uCellPrivateInstance_t *pInstance,
                         // has succeeded
                         errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
                         startTimeMs = uPortGetTickTimeMs();
+                        pokeTimeMs = startTimeMs;
                         while (((pUrcStatus->flagsBitmap & (1 << U_CELL_MQTT_URC_FLAG_PUBLISH_UPDATED)) == 0) &&
                                (uPortGetTickTimeMs() - startTimeMs < (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000)) &&
                                ((pContext->pKeepGoingCallback == NULL) ||
                                 pContext->pKeepGoingCallback())) {
-                            uPortTaskBlock(1000);
-                            // When UART power saving is switched on some
-                            // modules (e.g. SARA-R422) can somteimes
-                            // withhold URCs so poke the module here to be
-                            // sure that it has not gone to sleep on us
-                            uAtClientLock(atHandle);
-                            uAtClientCommandStart(atHandle, "AT");
-                            uAtClientCommandStopReadResponse(atHandle);
-                            uAtClientUnlock(atHandle);
+                            // Check often, since the publish latency
+                            // is otherwise rounded up to this interval
+                            uPortTaskBlock(U_CELL_MQTT_PUBLISH_POLL_INTERVAL_MS);
+                            if (uPortGetTickTimeMs() - pokeTimeMs >= U_CELL_MQTT_PUBLISH_POKE_INTERVAL_MS) {
+                                // When UART power saving is switched on some
+                                // modules (e.g. SARA-R422) can somteimes
+                                // withhold URCs so poke the module here to be
+                                // sure that it has not gone to sleep on us
+                                uAtClientLock(atHandle);
+                                uAtClientCommandStart(atHandle, "AT");
+                                uAtClientCommandStopReadResponse(atHandle);
+                                uAtClientUnlock(atHandle);
+                                pokeTimeMs = uPortGetTickTimeMs();
+                            }
                         }
                         if ((pUrcStatus->flagsBitmap & (1 << U_CELL_MQTT_URC_FLAG_PUBLISH_SUCCESS)) != 0) {
                             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
@@ -1847,13 +1912,113 @@ static int32_t unsubscribe(const uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Subscribe to (pMaxQos non-NULL) or unsubscribe from (pMaxQos
+// NULL) several MQTT topics.  The commands are sent back to back,
+// each only waiting for its "OK", and then the URCs carrying the
+// outcomes, which arrive in the same order, are collected together,
+// so that the round trips to the broker overlap.  If the module
+// refuses a command while others are outstanding we wait for
+// those to complete and then do the rest one at a time.
+static int32_t subscribeMulti(const uCellPrivateInstance_t *pInstance,
+                              const char *const *ppTopicFilterStr,
+                              const uCellMqttQos_t *pMaxQos,
+                              size_t numTopics, int32_t *pResults)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    volatile uCellMqttContext_t *pContext;
+    volatile uCellMqttUrcStatus_t *pUrcStatus;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    size_t numSent = 0;
+    bool accepted = true;
+    int32_t startTimeMs;
+
+    pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+    pUrcStatus = &(pContext->urcStatus);
+    if ((ppTopicFilterStr != NULL) && (pResults != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; x < numTopics; x++) {
+            pResults[x] = (int32_t) U_ERROR_COMMON_TIMEOUT;
+            if ((ppTopicFilterStr[x] == NULL) ||
+                (strlen(ppTopicFilterStr[x]) > U_CELL_MQTT_WRITE_TOPIC_MAX_LENGTH_BYTES) ||
+                ((pMaxQos != NULL) && (((int32_t) pMaxQos[x] < 0) ||
+                                       (pMaxQos[x] >= U_CELL_MQTT_QOS_MAX_NUM)))) {
+                errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            }
+        }
+    }
+
+    if ((errorCode == 0) &&
+        !U_CELL_PRIVATE_HAS(pInstance->pModule,
+                            U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX)) {
+        // The old SARA-R4 syntax returns the outcome of an
+        // unsubscribe in the response rather than in a URC and so
+        // can't be pipelined; it is done one at a time below
+        pUrcStatus->multiCount = 0;
+        pUrcStatus->multiMax = numTopics;
+        pUrcStatus->pMultiResults = pResults;
+        for (numSent = 0; accepted && (numSent < numTopics); numSent++) {
+            uAtClientLock(atHandle);
+            uAtClientCommandStart(atHandle, MQTT_COMMAND_AT_COMMAND_STRING(false));
+            if (pMaxQos != NULL) {
+                uAtClientWriteInt(atHandle, MQTT_COMMAND_OPCODE_SUBSCRIBE(false));
+                uAtClientWriteInt(atHandle, (int32_t) pMaxQos[numSent]);
+            } else {
+                uAtClientWriteInt(atHandle, MQTT_COMMAND_OPCODE_UNSUBSCRIBE(false));
+            }
+            uAtClientWriteString(atHandle, ppTopicFilterStr[numSent], true);
+            uAtClientCommandStopReadResponse(atHandle);
+            accepted = (uAtClientUnlock(atHandle) == 0);
+        }
+        if (!accepted) {
+            numSent--;
+        }
+        // Collect the outcomes of everything that was sent
+        startTimeMs = uPortGetTickTimeMs();
+        while ((pUrcStatus->multiCount < numSent) &&
+               (uPortGetTickTimeMs() - startTimeMs < (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000)) &&
+               ((pContext->pKeepGoingCallback == NULL) ||
+                pContext->pKeepGoingCallback())) {
+            uPortTaskBlock(U_CELL_MQTT_MULTI_POLL_MS);
+        }
+        pUrcStatus->pMultiResults = NULL;
+    }
+
+    if (errorCode == 0) {
+        // Anything not sent above is done the slow way
+        for (size_t x = numSent; x < numTopics; x++) {
+            if (pMaxQos != NULL) {
+                pResults[x] = subscribe(pInstance, ppTopicFilterStr[x], -1,
+                                        pMaxQos[x], NULL);
+            } else {
+                pResults[x] = unsubscribe(pInstance, ppTopicFilterStr[x], -1);
+            }
+        }
+        // Return the first error, if there is one
+        for (size_t x = 0; (x < numTopics) && (errorCode == 0); x++) {
+            if (pResults[x] < 0) {
+                errorCode = pResults[x];
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 // Read a message, MQTT or MQTT-SN style.
+// If pChunkCallback is non-NULL the message is read in pieces
+// of up to *pMessageSizeBytes into pMessage, each piece being
+// passed to pChunkCallback; the old-style SARA-R4 interface, where
+// the message arrives in a URC, doesn't support this.
 static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
                            char *pTopicNameStr,
                            size_t topicNameSizeBytes,
                            int32_t *pTopicNameType,
                            char *pMessage, size_t *pMessageSizeBytes,
-                           uCellMqttQos_t *pQos)
+                           uCellMqttQos_t *pQos,
+                           bool (*pChunkCallback) (const char *, size_t,
+                                                   size_t, size_t,
+                                                   void *),
+                           void *pChunkCallbackParam)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     volatile uCellMqttContext_t *pContext;
@@ -1869,6 +2034,8 @@ static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
     int32_t messageBytesAvailable;
     int32_t messageBytesRead = 0;
     int32_t topicBytesAvailable;
+    int32_t chunkBytes;
+    bool keepGoing = true;
 
     pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
     mqttSn = pContext->mqttSn;
@@ -1879,8 +2046,12 @@ static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
             messageSizeBytes = *pMessageSizeBytes;
         }
         errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
-        if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+        if ((pChunkCallback != NULL) &&
+            U_CELL_PRIVATE_HAS(pInstance->pModule,
                                U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        } else if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                      U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX)) {
             U_ASSERT(pUrcMessage != NULL);
             // For the old-style SARA-R4 interface we need a URC capture
             U_ASSERT(U_CELL_PRIVATE_MODULE_IS_SARA_R4(pInstance->pModule->moduleType));
@@ -1974,10 +2145,35 @@ static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
                 uAtClientIgnoreStopTag(atHandle);
                 // Get the leading quote mark out of the way
                 uAtClientReadBytes(atHandle, NULL, 1, true);
-                // Now read out all the actual data,
-                // first the bit we want
-                messageBytesRead = uAtClientReadBytes(atHandle, pMessage,
-                                                      messageSizeBytes, true);
+                if (pChunkCallback != NULL) {
+                    // Read the data a chunk at a time into pMessage,
+                    // handing each chunk to the callback, until
+                    // either it is all read or the callback has
+                    // had enough
+                    chunkBytes = 1;
+                    while (keepGoing && (chunkBytes > 0) &&
+                           (messageBytesRead < messageBytesAvailable)) {
+                        chunkBytes = messageBytesAvailable - messageBytesRead;
+                        if (chunkBytes > (int32_t) messageSizeBytes) {
+                            chunkBytes = (int32_t) messageSizeBytes;
+                        }
+                        chunkBytes = uAtClientReadBytes(atHandle, pMessage,
+                                                        // Cast in two stages to keep Lint happy
+                                                        (size_t) (unsigned) chunkBytes, true);
+                        if (chunkBytes > 0) {
+                            keepGoing = pChunkCallback(pMessage, chunkBytes,
+                                                       messageBytesRead,
+                                                       messageBytesAvailable,
+                                                       pChunkCallbackParam);
+                            messageBytesRead += chunkBytes;
+                        }
+                    }
+                } else {
+                    // Now read out all the actual data,
+                    // first the bit we want
+                    messageBytesRead = uAtClientReadBytes(atHandle, pMessage,
+                                                          messageSizeBytes, true);
+                }
                 if (messageBytesAvailable > messageBytesRead) {
                     //...and then the rest poured away to NULL
                     uAtClientReadBytes(atHandle, NULL,
@@ -2077,6 +2273,7 @@ int32_t uCellMqttInit(uDeviceHandle_t cellHandle, const char *pBrokerNameStr,
                     pContext->pUrcMessage = NULL;
                     pContext->numTries = U_CELL_MQTT_RETRIES_DEFAULT + 1;
                     pContext->mqttSn = mqttSn;
+                    pContext->urcStatus.pMultiResults = NULL;
                     pInstance->pMqttContext = pContext;
                     if (U_CELL_PRIVATE_MODULE_IS_SARA_R4(pInstance->pModule->moduleType)) {
                         // SARA-R4 requires a pUrcMessage as well
@@ -2628,7 +2825,8 @@ int32_t uCellMqttSetWill(uDeviceHandle_t cellHandle,
     volatile uCellMqttContext_t *pContext;
     bool mqttSn;
     uAtClientHandle_t atHandle;
-    char *pHexMessage = NULL;
+    char *pTextMessage = NULL;
+    bool isAscii = false;
 
     U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCode, true);
 
@@ -2652,16 +2850,29 @@ int32_t uCellMqttSetWill(uDeviceHandle_t cellHandle,
                 atHandle = pInstance->atHandle;
                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                 if ((pMessage != NULL) && !mqttSn) {
-                    // For MQTT we can do it in hex, so allocate space
-                    // to encode the hex version of the message
+                    // For MQTT we can do it in hex but that doubles
+                    // the length, so only do so if the message can't
+                    // be sent as it is; either way allocate space
+                    // for a terminated copy of the message
                     errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-                    pHexMessage = (char *) malloc((messageSizeBytes * 2) + 1);
-                    if (pHexMessage != NULL) {
-                        // Convert to hex
-                        uBinToHex(pMessage, messageSizeBytes, pHexMessage);
-                        // Add a terminator to make it a string
-                        *(pHexMessage + (messageSizeBytes * 2)) = '\0';
-                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    isAscii = isAllowedMqttSn(pMessage, messageSizeBytes);
+                    if (isAscii) {
+                        pTextMessage = (char *) malloc(messageSizeBytes + 1);
+                        if (pTextMessage != NULL) {
+                            // Just copy in the text and add a terminator
+                            memcpy(pTextMessage, pMessage, messageSizeBytes);
+                            *(pTextMessage + messageSizeBytes) = '\0';
+                            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        }
+                    } else {
+                        pTextMessage = (char *) malloc((messageSizeBytes * 2) + 1);
+                        if (pTextMessage != NULL) {
+                            // Convert to hex
+                            uBinToHex(pMessage, messageSizeBytes, pTextMessage);
+                            // Add a terminator to make it a string
+                            *(pTextMessage + (messageSizeBytes * 2)) = '\0';
+                            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        }
                     }
                 }
 
@@ -2705,17 +2916,19 @@ int32_t uCellMqttSetWill(uDeviceHandle_t cellHandle,
                     // Set "will" message
                     uAtClientWriteInt(atHandle, MQTT_PROFILE_OPCODE_WILL_MESSAGE(mqttSn));
                     // Write the "will" message
-                    if (pHexMessage != NULL) {
-                        uAtClientWriteString(atHandle, pHexMessage, true);
-                        // Hex mode
-                        uAtClientWriteInt(atHandle, 1);
+                    if (pTextMessage != NULL) {
+                        uAtClientWriteString(atHandle, pTextMessage, true);
+                        if (!isAscii) {
+                            // Hex mode
+                            uAtClientWriteInt(atHandle, 1);
+                        }
                     } else {
                         uAtClientWriteString(atHandle, pMessage, true);
                     }
                     errorCode = atMqttStopCmdGetRespAndUnlock(pInstance);
                 }
                 // Free memory
-                free(pHexMessage);
+                free(pTextMessage);
             }
         }
     }
@@ -3189,6 +3402,64 @@ int32_t uCellMqttUnsubscribe(uDeviceHandle_t cellHandle,
     return errorCode;
 }
 
+// Subscribe to several MQTT topics.
+int32_t uCellMqttSubscribeMulti(uDeviceHandle_t cellHandle,
+                                const char *const *ppTopicFilterStr,
+                                const uCellMqttQos_t *pMaxQos,
+                                size_t numTopics, int32_t *pQos)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance = NULL;
+    volatile uCellMqttContext_t *pContext;
+
+    U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCode, true);
+
+    if ((errorCode == 0) && (pInstance != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pMaxQos != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+            if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                   U_CELL_PRIVATE_FEATURE_MQTT) &&
+                !pContext->mqttSn) {
+                errorCode = subscribeMulti(pInstance, ppTopicFilterStr, pMaxQos,
+                                           numTopics, pQos);
+            }
+        }
+    }
+
+    U_CELL_MQTT_EXIT_FUNCTION();
+
+    return errorCode;
+}
+
+// Unsubscribe from several MQTT topics.
+int32_t uCellMqttUnsubscribeMulti(uDeviceHandle_t cellHandle,
+                                  const char *const *ppTopicFilterStr,
+                                  size_t numTopics, int32_t *pResults)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance = NULL;
+    volatile uCellMqttContext_t *pContext;
+
+    U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCode, true);
+
+    if ((errorCode == 0) && (pInstance != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+        if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                               U_CELL_PRIVATE_FEATURE_MQTT) &&
+            !pContext->mqttSn) {
+            errorCode = subscribeMulti(pInstance, ppTopicFilterStr, NULL,
+                                       numTopics, pResults);
+        }
+    }
+
+    U_CELL_MQTT_EXIT_FUNCTION();
+
+    return errorCode;
+}
+
 // Read an MQTT message.
 int32_t uCellMqttMessageRead(uDeviceHandle_t cellHandle,
                              char *pTopicNameStr,
@@ -3210,7 +3481,8 @@ int32_t uCellMqttMessageRead(uDeviceHandle_t cellHandle,
             !pContext->mqttSn) {
             errorCode = readMessage(pInstance, pTopicNameStr,
                                     topicNameSizeBytes, NULL,
-                                    pMessage, pMessageSizeBytes, pQos);
+                                    pMessage, pMessageSizeBytes, pQos,
+                                    NULL, NULL);
         }
     }
 
@@ -3219,6 +3491,50 @@ int32_t uCellMqttMessageRead(uDeviceHandle_t cellHandle,
     return errorCode;
 }
 
+// Read an MQTT message in chunks.
+int32_t uCellMqttMessageReadChunked(uDeviceHandle_t cellHandle,
+                                    char *pTopicNameStr,
+                                    size_t topicNameSizeBytes,
+                                    char *pChunkBuffer,
+                                    size_t chunkSizeBytes,
+                                    bool (*pCallback) (const char *, size_t,
+                                                       size_t, size_t,
+                                                       void *),
+                                    void *pCallbackParam,
+                                    uCellMqttQos_t *pQos)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance = NULL;
+    volatile uCellMqttContext_t *pContext;
+
+    U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCodeOrLength, true);
+
+    if ((errorCodeOrLength == 0) && (pInstance != NULL)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pChunkBuffer != NULL) && (chunkSizeBytes > 0) && (pCallback != NULL)) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+            if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                   U_CELL_PRIVATE_FEATURE_MQTT) &&
+                !pContext->mqttSn) {
+                errorCodeOrLength = readMessage(pInstance, pTopicNameStr,
+                                                topicNameSizeBytes, NULL,
+                                                pChunkBuffer, &chunkSizeBytes,
+                                                pQos, pCallback, pCallbackParam);
+                if (errorCodeOrLength == 0) {
+                    // readMessage() returns the number of bytes
+                    // passed to the callback in chunkSizeBytes
+                    errorCodeOrLength = (int32_t) chunkSizeBytes;
+                }
+            }
+        }
+    }
+
+    U_CELL_MQTT_EXIT_FUNCTION();
+
+    return errorCodeOrLength;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MQTT-SN ONLY
  * -------------------------------------------------------------- */
@@ -3487,7 +3803,7 @@ int32_t uCellMqttSnMessageRead(uDeviceHandle_t cellHandle,
             pContext->mqttSn) {
             errorCode = readMessage(pInstance, topicNameStr, sizeof(topicNameStr),
                                     &topicNameType, pMessage, pMessageSizeBytes,
-                                    pQos);
+                                    pQos, NULL, NULL);
             if (errorCode == 0) {
                 pTopicName->name.id = (uint16_t) strtol(topicNameStr, NULL, 10);
                 pTopicName->type = (uCellMqttSnTopicNameType_t) topicNameType;
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the multiplexer (CMUX) API for cellular.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc(), free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"  // For #define U_CFG_OS_CLIB_LEAKS
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+
+#include "u_at_client.h"
+#include "u_cmux.h"
+
+#include "u_cell_module_type.h"
+#include "u_cell_file.h"
+#include "u_cell_net.h"     // Order is important here
+#include "u_cell_private.h" // don't change it
+#include "u_cell_mux.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Bring up the CMUX instance and the AT channel and move the AT
+// client onto it; the AT client must be locked and detached.
+static int32_t cmuxStart(uCellPrivateMuxContext_t *pContext,
+                         uAtClientHandle_t atHandle)
+{
+    int32_t errorCodeOrHandle;
+
+    errorCodeOrHandle = uCmuxOpen(pContext->uartHandle,
+                                  U_CELL_MUX_FRAME_INFORMATION_MAX_LENGTH_BYTES);
+    if (errorCodeOrHandle >= 0) {
+        pContext->cmuxHandle = errorCodeOrHandle;
+        errorCodeOrHandle = uCmuxChannelOpen(pContext->cmuxHandle,
+                                             U_CELL_MUX_CHANNEL_ID_AT);
+        if (errorCodeOrHandle >= 0) {
+            errorCodeOrHandle = uAtClientStreamSwitch(atHandle, errorCodeOrHandle,
+                                                      U_AT_CLIENT_STREAM_TYPE_CMUX);
+        }
+        if (errorCodeOrHandle < 0) {
+            // This also closes the channel and tells the
+            // module to leave multiplexer mode
+            uCmuxClose(pContext->cmuxHandle);
+        }
+    }
+
+    return errorCodeOrHandle;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Enable multiplexer mode.
+int32_t uCellMuxEnable(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellPrivateMuxContext_t *pContext;
+    uAtClientHandle_t atHandle;
+    uAtClientStream_t streamType;
+    int32_t uartHandle;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (pInstance->pMuxContext == NULL) {
+                atHandle = pInstance->atHandle;
+                errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+                uartHandle = uAtClientStreamGet(atHandle, &streamType);
+                if (streamType == U_AT_CLIENT_STREAM_TYPE_UART) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                    pContext = (uCellPrivateMuxContext_t *) malloc(sizeof(*pContext));
+                    if (pContext != NULL) {
+                        pContext->uartHandle = uartHandle;
+                        pContext->cmuxHandle = -1;
+                        errorCode = uCmuxInit();
+                        if (errorCode == 0) {
+                            uAtClientLock(atHandle);
+                            // Basic option, UIH frames, default speed
+                            uAtClientCommandStart(atHandle, "AT+CMUX=0,0,,");
+                            uAtClientWriteInt(atHandle,
+                                              U_CELL_MUX_FRAME_INFORMATION_MAX_LENGTH_BYTES);
+                            uAtClientCommandStopReadResponse(atHandle);
+                            errorCode = uAtClientErrorGet(atHandle);
+                            if (errorCode == 0) {
+                                // The module is now in multiplexer mode:
+                                // detach the AT client from the UART so
+                                // that CMUX can have it
+                                uAtClientStreamSwitch(atHandle, -1,
+                                                      U_AT_CLIENT_STREAM_TYPE_UART);
+                                errorCode = cmuxStart(pContext, atHandle);
+                                if (errorCode < 0) {
+                                    uAtClientStreamSwitch(atHandle, uartHandle,
+                                                          U_AT_CLIENT_STREAM_TYPE_UART);
+                                }
+                            }
+                            uAtClientUnlock(atHandle);
+                        }
+                        if (errorCode == 0) {
+                            pInstance->pMuxContext = pContext;
+                            uPortLog("U_CELL_MUX: multiplexer mode enabled, AT client"
+                                     " on channel %d.\n", U_CELL_MUX_CHANNEL_ID_AT);
+                        } else {
+                            free(pContext);
+                        }
+                    }
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Determine whether multiplexer mode is enabled.
+bool uCellMuxIsEnabled(uDeviceHandle_t cellHandle)
+{
+    bool isEnabled = false;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        if (pInstance != NULL) {
+            isEnabled = (pInstance->pMuxContext != NULL);
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return isEnabled;
+}
+
+// Open an additional CMUX channel.
+int32_t uCellMuxChannelOpen(uDeviceHandle_t cellHandle, uint8_t channel)
+{
+    int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (channel != U_CELL_MUX_CHANNEL_ID_AT)) {
+            errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (pInstance->pMuxContext != NULL) {
+                errorCodeOrHandle = uCmuxChannelOpen(pInstance->pMuxContext->cmuxHandle,
+                                                     channel);
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrHandle;
+}
+
+// Disable multiplexer mode.
+int32_t uCellMuxDisable(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            uCellPrivateMuxRemoveContext(pInstance);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// End of file
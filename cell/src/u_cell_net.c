@@ -50,12 +50,14 @@
 #include "u_port_os.h"
 
 #include "u_at_client.h"
+#include "u_mempool.h"  // uMemPoolMalloc(), uMemPoolFree()
 
 #include "u_cell_module_type.h"
 #include "u_cell_file.h"
 #include "u_cell.h"         // Order is
 #include "u_cell_net.h"     // important here
 #include "u_cell_private.h" // don't change it
+#include "u_cell_cfg.h"     // uCellCfgGetBandMask()
 #include "u_cell_info.h"
 #include "u_cell_apn_db.h"
 #include "u_cell_mno_db.h"
@@ -66,12 +68,12 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-/** The length of temporary buffer to use when reading network scan
- * results, sufficient to store N of:
+/** The length of temporary buffer to use when reading a single
+ * network scan result, sufficient to store:
  *
  * (stat,long_name,short_name,numeric[,AcT])
  */
-#define U_CELL_NET_SCAN_LENGTH_BYTES (128 * 10)
+#define U_CELL_NET_SCAN_ITEM_LENGTH_BYTES ((U_CELL_NET_MAX_NAME_LENGTH_BYTES * 2) + 32)
 
 /** The type of CEREG to request; 4 to get the 3GPP sleep parameters
  * also.
@@ -114,6 +116,14 @@ typedef struct {
     void *pCallbackParameter;
 } uCellNetRegistationStatus_t;
 
+/** The user callback, and its parameter, for uCellNetScan().
+ */
+typedef struct {
+    bool (*pCallback) (uDeviceHandle_t, const char *, const char *,
+                       uCellNetRat_t, void *);
+    void *pCallbackParameter;
+} uCellNetScanCallback_t;
+
 /** All the parameters for the base station connection status callback.
  */
 typedef struct {
@@ -208,7 +218,7 @@ static void registrationStatusCallback(uAtClientHandle_t atHandle,
             pStatus->pCallback(pStatus->domain, pStatus->networkStatus,
                                pStatus->pCallbackParameter);
         }
-        free(pStatus);
+        uMemPoolFree(pStatus);
     }
 }
 
@@ -230,7 +240,7 @@ static void powerSaving3gppCallback(uAtClientHandle_t atHandle,
                                  pCallback->periodicWakeupSeconds,
                                  pCallback->pCallbackParam);
         }
-        free(pCallback);
+        uMemPoolFree(pCallback);
     }
 }
 
@@ -251,10 +261,12 @@ static void activateContextCallback(uAtClientHandle_t atHandle,
 // might be called from a URC.
 static void setNetworkStatus(uCellPrivateInstance_t *pInstance,
                              uCellNetStatus_t status, int32_t rat,
+                             int32_t cellId, int32_t areaCode,
                              uCellNetRegDomain_t domain,
                              bool fromUrc)
 {
     uCellNetRegistationStatus_t *pStatus;
+    uCellNetRat_t cellRat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
     bool printAllowed = true;
 #if U_CFG_OS_CLIB_LEAKS
     // If we're in a URC and the C library leaks memory
@@ -354,22 +366,45 @@ static void setNetworkStatus(uCellPrivateInstance_t *pInstance,
             break;
     }
 
-    pInstance->networkStatus[domain] = status;
-
-    pInstance->rat[domain] = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+    if (U_CELL_NET_STATUS_MEANS_REGISTERED(status)) {
+        // An indication that doesn't carry the cell ID or area
+        // code (e.g. one we've polled for) doesn't mean they've changed
+        if (cellId < 0) {
+            cellId = pInstance->cellId[domain];
+        }
+        if (areaCode < 0) {
+            areaCode = pInstance->areaCode[domain];
+        }
+    } else {
+        cellId = -1;
+        areaCode = -1;
+    }
     if (U_CELL_NET_STATUS_MEANS_REGISTERED(status) &&
         (rat >= 0) &&
         (rat < (int32_t) (sizeof(g3gppRatToCellRat) /
                           sizeof(g3gppRatToCellRat[0])))) {
-        pInstance->rat[domain] = (uCellNetRat_t) g3gppRatToCellRat[rat];
-        if ((pInstance->rat[domain] == U_CELL_NET_RAT_LTE) &&
+        cellRat = (uCellNetRat_t) g3gppRatToCellRat[rat];
+        if ((cellRat == U_CELL_NET_RAT_LTE) &&
             !(pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_LTE)) &&
             (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_CATM1))) {
             // The RAT on the end of the network status indication doesn't
             // differentiate between LTE and Cat-M1 so, if the device doesn't
             // support LTE but does support Cat-M1, switch it
-            pInstance->rat[domain] = U_CELL_NET_RAT_CATM1;
+            cellRat = U_CELL_NET_RAT_CATM1;
         }
+    }
+
+    // Write the new state such that uCellNetGetRegistrationSnapshot()
+    // can read it coherently without a lock
+    pInstance->networkStatusSequence++;
+    pInstance->networkStatus[domain] = status;
+    pInstance->rat[domain] = cellRat;
+    pInstance->cellId[domain] = cellId;
+    pInstance->areaCode[domain] = areaCode;
+    pInstance->networkStatusUpdatedMs[domain] = uPortGetTickTimeMs();
+    pInstance->networkStatusSequence++;
+
+    if (cellRat != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
         if (pInstance->profileState == U_CELL_PRIVATE_PROFILE_STATE_REQUIRES_REACTIVATION) {
             // This flag will be set if we had been knocked out
             // of our PDP context by a network outage and need
@@ -395,11 +430,11 @@ static void setNetworkStatus(uCellPrivateInstance_t *pInstance,
         // data in a struct and pass a pointer to it to our
         // local callback via the AT client's callback mechanism
         // to decouple it from any URC handler.
-        // Note: it is up to registrationStatusCallback() to free()
-        // the malloc()ed memory.
+        // Note: it is up to registrationStatusCallback() to
+        // uMemPoolFree() the memory.
         //lint -esym(429, pStatus) Suppress pStatus not being free()ed here
         //lint -esym(593, pStatus) Suppress pStatus not being free()ed here
-        pStatus = (uCellNetRegistationStatus_t *) malloc(sizeof(*pStatus));
+        pStatus = (uCellNetRegistationStatus_t *) uMemPoolMalloc(sizeof(*pStatus));
         if (pStatus != NULL) {
             pStatus->domain = domain;
             pStatus->networkStatus = status;
@@ -424,8 +459,11 @@ static inline uCellNetStatus_t CXREG_urc(uCellPrivateInstance_t *pInstance,
     uAtClientHandle_t atHandle = pInstance->atHandle;
     int32_t status3gpp;
     uCellNetStatus_t status = U_CELL_NET_STATUS_UNKNOWN;
-    int32_t secondInt;
+    char buffer[16 + 1]; // Enough for a <lac>, <tac> or <ci> in hex
+    int32_t secondInt = -1;
     int32_t rat = -1;
+    int32_t cellId = -1;
+    int32_t areaCode = -1;
     int32_t skippedParameters = 1;
     bool responseToCommandNotUrc = false;
 
@@ -450,10 +488,16 @@ static inline uCellNetStatus_t CXREG_urc(uCellPrivateInstance_t *pInstance,
 
     // Assume case (b) at the outset
     status3gpp = uAtClientReadInt(atHandle);
-    secondInt = uAtClientReadInt(atHandle);
+    // Read the second integer as a string since, in case (b),
+    // it is the <lac>/<tac>, which is in hex
+    if (uAtClientReadString(atHandle, buffer, sizeof(buffer), false) > 0) {
+        secondInt = strtol(buffer, NULL, 10);
+        areaCode = strtol(buffer, NULL, 16);
+    }
     if ((status3gpp == U_CELL_NET_CREG_OR_CGREG_TYPE) ||
         (status3gpp == U_CELL_NET_CEREG_TYPE)) {
         // case (a.i) or (a.ii)
+        areaCode = -1;
         if (secondInt < 0) {
             // case (a.ii)
             uAtClientClearError(atHandle);
@@ -484,10 +528,18 @@ static inline uCellNetStatus_t CXREG_urc(uCellPrivateInstance_t *pInstance,
               responseToCommandNotUrc))) {
             skippedParameters++;
         }
-        // Skip <ci> (<lac> already absorbed by the
-        // read of secondInt above) and potentially
-        // <rac_or_mme>
-        uAtClientSkipParameters(atHandle, skippedParameters);
+        // Read <ci> (<lac> already absorbed by the
+        // read of secondInt above) and skip potentially
+        // <rac_or_mme>; <ci> is only believed in case (b),
+        // the URC, since the parameter order has been seen
+        // to vary in the response case
+        if ((uAtClientReadString(atHandle, buffer, sizeof(buffer), false) > 0) &&
+            !responseToCommandNotUrc) {
+            cellId = strtol(buffer, NULL, 16);
+        }
+        if (skippedParameters > 1) {
+            uAtClientSkipParameters(atHandle, skippedParameters - 1);
+        }
         // Read the RAT that we're on
         rat = uAtClientReadInt(atHandle);
         // Use the assumed 3GPP RAT if no RAT is included
@@ -495,7 +547,7 @@ static inline uCellNetStatus_t CXREG_urc(uCellPrivateInstance_t *pInstance,
             rat = assumed3gppRat;
         }
     }
-    setNetworkStatus(pInstance, status, rat, domain, true);
+    setNetworkStatus(pInstance, status, rat, cellId, areaCode, domain, true);
 
     return status;
 }
@@ -579,10 +631,10 @@ static void CEREG_urc(uAtClientHandle_t atHandle,
             // Put all the data in a struct and pass a pointer to it to our
             // local callback via the AT client's callback mechanism to decouple
             // it from whatever might have called us.
-            // Note: powerSaving3gppCallback will free() the malloc()ed memory.
+            // Note: powerSaving3gppCallback will uMemPoolFree() the memory.
             //lint -esym(429, pCallback) Suppress pCallback not being free()ed here
             //lint -esym(593, pCallback) Suppress pCallback not being free()ed here
-            pCallback = (uCellNet3gppPowerSavingCallback_t *) malloc(sizeof(*pCallback));
+            pCallback = (uCellNet3gppPowerSavingCallback_t *) uMemPoolMalloc(sizeof(*pCallback));
             if (pCallback != NULL) {
                 pCallback->cellHandle = pInstance->cellHandle;
                 pCallback->pCallback = pSleepContext->p3gppPowerSavingCallback;
@@ -616,7 +668,7 @@ static void connectionStatusCallback(uAtClientHandle_t atHandle,
             pStatus->pCallback(pStatus->isConnected,
                                pStatus->pCallbackParameter);
         }
-        free(pStatus);
+        uMemPoolFree(pStatus);
     }
 }
 
@@ -640,10 +692,10 @@ static void CSCON_urc(uAtClientHandle_t atHandle,
         // data in a struct and pass a pointer to it to our
         // local callback via the AT client's callback mechanism
         // to decouple it from any URC handler.
-        // Note: it is up to connectionStatusCallback() to free()
-        // the malloc()ed memory.
+        // Note: it is up to connectionStatusCallback() to
+        // uMemPoolFree() the memory.
         //lint -esym(429, pStatus) Suppress pStatus not being free()ed here
-        pStatus = (uCellNetConnectionStatus_t *) malloc(sizeof(*pStatus));
+        pStatus = (uCellNetConnectionStatus_t *) uMemPoolMalloc(sizeof(*pStatus));
         if (pStatus != NULL) {
             pStatus->isConnected = isConnected;
             pStatus->pCallback = pInstance->pConnectionStatusCallback;
@@ -689,6 +741,12 @@ static bool keepGoingLocalCb(const uCellPrivateInstance_t *pInstance)
             keepGoing = false;
         }
     }
+    if (keepGoing && (pInstance->warmStartTimeMs > 0) &&
+        (uPortGetTickTimeMs() - pInstance->warmStartTimeMs >
+         (U_CELL_NET_WARM_START_TIMEOUT_SECONDS * 1000))) {
+        // A warm start has its own, shorter, time limit
+        keepGoing = false;
+    }
 
     return keepGoing;
 }
@@ -703,6 +761,10 @@ static int32_t radioOff(uCellPrivateInstance_t *pInstance)
     // Try three times to do this, would like to
     // get it right but sometimes modules fight back
     pInstance->profileState = U_CELL_PRIVATE_PROFILE_STATE_SHOULD_BE_DOWN;
+    if (pInstance->pModule->radioOffCfun == 0) {
+        // The SIM is deactivated in AT+CFUN=0 and so could be swapped
+        uCellPrivateIdentityCacheClear(pInstance, true);
+    }
     for (size_t x = 3; (x > 0) && (errorCode < 0); x--) {
         // Wait for flip time to expire
         while (uPortGetTickTimeMs() - pInstance->lastCfunFlipTimeMs <
@@ -869,15 +931,12 @@ static int32_t setAutomaticMode(const uCellPrivateInstance_t *pInstance)
     return errorCode;
 }
 
-// Store a network scan result and return the
-// number stored
-static int32_t storeNextScanItem(uCellPrivateInstance_t *pInstance,
-                                 char *pBuffer)
+// Parse a network scan result into pNet, returning true
+// if it was a network and not some gunk.
+static bool parseScanItem(const uCellPrivateInstance_t *pInstance,
+                          char *pBuffer, uCellPrivateNet_t *pNet)
 {
-    int32_t count = 0;
     bool success = false;
-    uCellPrivateNet_t *pNet;
-    uCellPrivateNet_t **ppTmp;
     int32_t copsRat;
     size_t x;
     char *pSaved;
@@ -891,91 +950,287 @@ static int32_t storeNextScanItem(uCellPrivateInstance_t *pInstance,
     // ...may appear there, so check for errors;
     // the <stat> and <numeric> fields must be present, the
     // rest could be absent or zero length strings
-    // Malloc() memory to store this item
-    pNet = (uCellPrivateNet_t *) malloc(sizeof(*pNet));
-    if (pNet != NULL) {
-        // Check that "(<stat>" is there and throw it away
-        pStr = strtok_r(pBuffer, ",", &pSaved);
-        success = ((pStr != NULL) && (*pStr == '('));
-        if (success) {
-            success = false;
-            // Grab <long_name> and put it in name
-            pStr = strtok_r(NULL, ",", &pSaved);
-            if (pStr != NULL) {
-                x = strlen(pStr);
-                pNet->name[0] = '\0';
-                if (x > 1) {
-                    // > 1 since "" is the minimum we can have
-                    snprintf(pNet->name, sizeof(pNet->name), "%.*s",
-                             x - 2, pStr + 1);
-                    success = true;
-                }
-            }
-        }
-        if (success) {
-            // Check if <short_name> is there but
-            // don't store it
-            pStr = strtok_r(NULL, ",", &pSaved);
-            success = ((pStr != NULL) && (strlen(pStr) > 1));
-        }
-        if (success) {
-            success = false;
-            // Grab <numeric> and pluck the MCC/MNC from it
-            pStr = strtok_r(NULL, ",", &pSaved);
-            pNet->mcc = 0;
-            pNet->mnc = 0;
-            // +2 for the quotes at each end
-            if ((pStr != NULL) && (strlen(pStr) >= 5 + 2)) {
-                // +1 for the initial quotation mark
-                pNet->mnc = atoi(pStr + 3 + 1);
-                *(pStr + 3 + 1) = 0;
-                pNet->mcc = atoi(pStr + 1);
+    // Check that "(<stat>" is there and throw it away
+    pStr = strtok_r(pBuffer, ",", &pSaved);
+    success = ((pStr != NULL) && (*pStr == '('));
+    if (success) {
+        success = false;
+        // Grab <long_name> and put it in name
+        pStr = strtok_r(NULL, ",", &pSaved);
+        if (pStr != NULL) {
+            x = strlen(pStr);
+            pNet->name[0] = '\0';
+            if (x > 1) {
+                // > 1 since "" is the minimum we can have
+                snprintf(pNet->name, sizeof(pNet->name), "%.*s",
+                         (int) (x - 2), pStr + 1);
                 success = true;
             }
         }
-        if (success) {
-            // See if <AcT> is there
-            pNet->rat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
-            pStr = strtok_r(NULL, ",", &pSaved);
-            if (pStr != NULL) {
-                // If it is convert it into a RAT value
-                copsRat = atoi(pStr);
-                if ((copsRat >= 0) &&
-                    (copsRat < (int32_t) (sizeof(g3gppRatToCellRat) /
-                                          sizeof(g3gppRatToCellRat[0])))) {
-                    pNet->rat = g3gppRatToCellRat[copsRat];
-                    if ((pNet->rat == U_CELL_NET_RAT_LTE) &&
-                        !(pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_LTE)) &&
-                        (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_CATM1))) {
-                        // The RAT on the end of the network status indication doesn't
-                        // differentiate between LTE and Cat-M1 so, if the device doesn't
-                        // support LTE but does support Cat-M1, switch it
-                        pNet->rat = U_CELL_NET_RAT_CATM1;
-                    }
+    }
+    if (success) {
+        // Check if <short_name> is there but
+        // don't store it
+        pStr = strtok_r(NULL, ",", &pSaved);
+        success = ((pStr != NULL) && (strlen(pStr) > 1));
+    }
+    if (success) {
+        success = false;
+        // Grab <numeric> and pluck the MCC/MNC from it
+        pStr = strtok_r(NULL, ",", &pSaved);
+        pNet->mcc = 0;
+        pNet->mnc = 0;
+        // +2 for the quotes at each end
+        if ((pStr != NULL) && (strlen(pStr) >= 5 + 2)) {
+            // +1 for the initial quotation mark
+            pNet->mnc = atoi(pStr + 3 + 1);
+            *(pStr + 3 + 1) = 0;
+            pNet->mcc = atoi(pStr + 1);
+            success = true;
+        }
+    }
+    if (success) {
+        // See if <AcT> is there
+        pNet->rat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+        pStr = strtok_r(NULL, ",", &pSaved);
+        if (pStr != NULL) {
+            // If it is convert it into a RAT value
+            copsRat = atoi(pStr);
+            if ((copsRat >= 0) &&
+                (copsRat < (int32_t) (sizeof(g3gppRatToCellRat) /
+                                      sizeof(g3gppRatToCellRat[0])))) {
+                pNet->rat = g3gppRatToCellRat[copsRat];
+                if ((pNet->rat == U_CELL_NET_RAT_LTE) &&
+                    !(pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_LTE)) &&
+                    (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_CATM1))) {
+                    // The RAT on the end of the network status indication doesn't
+                    // differentiate between LTE and Cat-M1 so, if the device doesn't
+                    // support LTE but does support Cat-M1, switch it
+                    pNet->rat = U_CELL_NET_RAT_CATM1;
                 }
             }
         }
-        pNet->pNext = NULL;
     }
+    pNet->pNext = NULL;
+
+    return success;
+}
+
+// Item callback for scan(): add a network scan result to the
+// end of the scan results list.
+static bool storeScanItem(uCellPrivateInstance_t *pInstance,
+                          const uCellPrivateNet_t *pNet,
+                          void *pParameter)
+{
+    uCellPrivateNet_t *pStored;
+    uCellPrivateNet_t **ppTmp = &(pInstance->pScanResults);
 
-    // Count the number of things already
-    // in the list
-    ppTmp = &(pInstance->pScanResults);
-    while (*ppTmp != NULL) {
-        ppTmp = &((*ppTmp)->pNext);
-        count++;
+    (void) pParameter;
+
+    // Get memory to store this item from the scan arena, all
+    // of which is released in one go by uCellPrivateScanFree()
+    pStored = (uCellPrivateNet_t *) pUPortHeapArenaAlloc(&(pInstance->scanArena),
+                                                         sizeof(*pStored));
+    if (pStored != NULL) {
+        memcpy(pStored, pNet, sizeof(*pStored));
+        pStored->pNext = NULL;
+        while (*ppTmp != NULL) {
+            ppTmp = &((*ppTmp)->pNext);
+        }
+        *ppTmp = pStored;
     }
 
-    if (success) {
-        // Add the new entry to the end of the list
-        *ppTmp = pNet;
-        count++;
-    } else {
-        // Found gunk, just free the memory
-        free (pNet);
+    // Always want the lot
+    return true;
+}
+
+// Item callback for scan(): pass a network scan result to
+// the user callback of uCellNetScan().
+static bool userScanItem(uCellPrivateInstance_t *pInstance,
+                         const uCellPrivateNet_t *pNet,
+                         void *pParameter)
+{
+    uCellNetScanCallback_t *pScanCallback = (uCellNetScanCallback_t *) pParameter;
+    char mccMnc[U_CELL_NET_MCC_MNC_LENGTH_BYTES];
+
+    snprintf(mccMnc, sizeof(mccMnc), "%03d%02d",
+             (int) pNet->mcc, (int) pNet->mnc);
+
+    return pScanCallback->pCallback(pInstance->cellHandle, pNet->name,
+                                    mccMnc, pNet->rat,
+                                    pScanCallback->pCallbackParameter);
+}
+
+// Perform a network scan with AT+COPS=?, calling pItemCallback
+// with each network found as soon as it has been parsed from
+// the response; the scan ends early if pItemCallback returns
+// false.  Returns the number of networks found or negative
+// error code.
+// Note: the instance should be locked before this is called.
+static int32_t scanNetworks(uCellPrivateInstance_t *pInstance,
+                            bool (*pItemCallback) (uCellPrivateInstance_t *,
+                                                   const uCellPrivateNet_t *,
+                                                   void *),
+                            void *pItemCallbackParameter,
+                            bool (*pKeepGoingCallback) (uDeviceHandle_t))
+{
+    int32_t errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    uDeviceHandle_t cellHandle = pInstance->cellHandle;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    uCellPrivateNet_t net;
+    char *pItem;
+    size_t itemLength;
+    size_t totalLength;
+    int32_t count;
+    int32_t bytesRead;
+    int32_t mode;
+    int64_t innerStartTimeMs;
+    uAtClientDeviceError_t deviceError;
+    bool gotAnswer = false;
+    bool wanted = true;
+    bool inItem;
+    bool inQuotes;
+    char c;
+
+    // Allocate temporary storage for one item
+    pItem = (char *) pUPortHeapAlloc(U_CELL_NET_SCAN_ITEM_LENGTH_BYTES,
+                                     U_PORT_HEAP_TAG_CELL);
+    if (pItem != NULL) {
+        errorCodeOrNumber = (int32_t) U_CELL_ERROR_TEMPORARY_FAILURE;
+        // Ensure that we're powered up.
+        mode = uCellPrivateCFunOne(pInstance);
+        // Start a scan
+        // Do this three times: if the module
+        // is busy doing its own search when we ask it
+        // to do a network search, as it might be if
+        // we've just come out of airplane mode,
+        // it will ignore us and simply return the
+        // "test" response to the AT+COPS=? command,
+        // i.e.: +COPS: ,,(0-6),(0-2)
+        // If we get the "test" response instead
+        // the total length read will be 12 whereas for the
+        // intended response of:
+        // (<stat>,<long_name>,<short_name>,<numeric>[,<AcT>])
+        // it will be at longer than that hence we set
+        // a threshold for the total length of > 12 characters.
+        pInstance->startTimeMs = uPortGetTickTimeMs();
+        for (size_t x = U_CELL_NET_SCAN_RETRIES + 1;
+             (x > 0) && (errorCodeOrNumber <= 0) && wanted &&
+             ((pKeepGoingCallback == NULL) || (pKeepGoingCallback(cellHandle)));
+             x--) {
+            uAtClientLock(atHandle);
+            // Set the timeout to a second so that we
+            // can spin around the loop
+            gotAnswer = false;
+            uAtClientTimeoutSet(atHandle, 1000);
+            uAtClientCommandStart(atHandle, "AT+COPS=?");
+            uAtClientCommandStop(atHandle);
+            // Will get back "+COPS:" then a single line consisting of
+            // comma delimited list of
+            // (<stat>,<long_name>,<short_name>,<numeric>[,<AcT>])
+            // ...plus some other stuff on the end.
+            // Sit in a loop waiting for the first character
+            // of a response of some form to arrive
+            bytesRead = -1;
+            deviceError.type = U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR;
+            innerStartTimeMs = uPortGetTickTimeMs();
+            while ((bytesRead <= 0) &&
+                   (uPortGetTickTimeMs() - innerStartTimeMs <
+                    (U_CELL_NET_SCAN_TIME_SECONDS * 1000)) &&
+                   ((pKeepGoingCallback == NULL) || (pKeepGoingCallback(cellHandle)))) {
+                uAtClientResponseStart(atHandle, "+COPS:");
+                // We use uAtClientReadBytes() here because the
+                // thing we're reading contains quotation marks
+                // and we want to process it as it arrives
+                bytesRead = uAtClientReadBytes(atHandle, &c, 1, true);
+                // Check if an error has been returned by the module,
+                // e.g. +CME ERROR: Temporary Failure, and if
+                // so exit the while() loop and try AT+COPS=? again.
+                uAtClientDeviceErrorGet(atHandle, &deviceError);
+                if (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR) {
+                    // Purely to exit the while() loop and cause us to
+                    // try gain in the outer for() loop
+                    bytesRead = 1;
+                }
+                uAtClientClearError(atHandle);
+                if (bytesRead <= 0) {
+                    uPortTaskBlock(1000);
+                }
+            }
+            if (bytesRead > 0) {
+                // Got _something_ back, but it may still be the
+                // "test" response or a device error
+                gotAnswer = true;
+            }
+            if ((bytesRead > 0) &&
+                (deviceError.type == U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR)) {
+                // Process the response a character at a time, handing
+                // on each item as soon as its closing bracket arrives
+                // rather than waiting for the whole line
+                count = 0;
+                totalLength = 0;
+                itemLength = 0;
+                inItem = false;
+                inQuotes = false;
+                while (wanted && (bytesRead > 0)) {
+                    totalLength++;
+                    if (c == '"') {
+                        inQuotes = !inQuotes;
+                    }
+                    if (!inQuotes && (c == '(')) {
+                        inItem = true;
+                        itemLength = 0;
+                    }
+                    if (inItem) {
+                        if (!inQuotes && (c == ')')) {
+                            inItem = false;
+                            *(pItem + itemLength) = 0;
+                            if (parseScanItem(pInstance, pItem, &net)) {
+                                count++;
+                                wanted = pItemCallback(pInstance, &net,
+                                                       pItemCallbackParameter);
+                            }
+                        } else if (itemLength < U_CELL_NET_SCAN_ITEM_LENGTH_BYTES - 1) {
+                            *(pItem + itemLength) = c;
+                            itemLength++;
+                        } else {
+                            // Too long to be a network, drop it
+                            inItem = false;
+                        }
+                    }
+                    if (wanted) {
+                        bytesRead = uAtClientReadBytes(atHandle, &c, 1, true);
+                    }
+                }
+                if ((totalLength > 12) || !wanted) {
+                    // Got a real answer
+                    errorCodeOrNumber = count;
+                }
+            }
+            // If the scan was ended early this will throw
+            // away the remainder of the line
+            uAtClientResponseStop(atHandle);
+            uAtClientUnlock(atHandle);
+            if (!gotAnswer) {
+                // If we never got an answer, abort the
+                // command first.
+                abortCommand(pInstance);
+            }
+        }
+
+        // Free memory
+        uPortHeapFree(pItem, U_PORT_HEAP_TAG_CELL);
+
+        // Put the mode back if it was not already 1
+        if ((mode >= 0) && (mode != 1)) {
+            uCellPrivateCFunMode(pInstance, mode);
+        }
+        if (!gotAnswer) {
+            errorCodeOrNumber = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        }
     }
 
-    return count;
+    return errorCodeOrNumber;
 }
 
 // Return the next network scan result, freeing
@@ -999,9 +1254,9 @@ static int32_t readNextScanItem(uCellPrivateInstance_t *pInstance,
         if (pRat != NULL) {
             *pRat = pNet->rat;
         }
-        // Now remove this entry from the list
+        // Now remove this entry from the list; the memory
+        // is released by uCellPrivateScanFree()
         pTmp = pNet->pNext;
-        free(pNet);
         pInstance->pScanResults = pTmp;
 
         // Count what's left
@@ -1017,7 +1272,7 @@ static int32_t readNextScanItem(uCellPrivateInstance_t *pInstance,
 
 // Register with the cellular network
 static int32_t registerNetwork(uCellPrivateInstance_t *pInstance,
-                               const char *pMccMnc)
+                               const char *pMccMnc, bool mccMncIsHint)
 {
     int32_t errorCode;
     uAtClientHandle_t atHandle = pInstance->atHandle;
@@ -1038,10 +1293,12 @@ static int32_t registerNetwork(uCellPrivateInstance_t *pInstance,
         uPortTaskBlock(1000);
     }
     // Reset the current registration status
+    pInstance->networkStatusSequence++;
     for (size_t x = 0; x < sizeof(pInstance->networkStatus) /
          sizeof(pInstance->networkStatus[0]); x++) {
         pInstance->networkStatus[x] = U_CELL_NET_STATUS_UNKNOWN;
     }
+    pInstance->networkStatusSequence++;
     uAtClientLock(atHandle);
     uAtClientCommandStart(atHandle, "AT+CFUN=1");
     uAtClientCommandStopReadResponse(atHandle);
@@ -1058,8 +1315,14 @@ static int32_t registerNetwork(uCellPrivateInstance_t *pInstance,
         uAtClientLock(atHandle);
         uAtClientTimeoutSet(atHandle, 1000);
         uAtClientCommandStart(atHandle, "AT+COPS=");
-        // Manual mode
-        uAtClientWriteInt(atHandle, 1);
+        if (mccMncIsHint) {
+            // Manual mode, falling back to automatic mode
+            // if the network cannot be found
+            uAtClientWriteInt(atHandle, 4);
+        } else {
+            // Manual mode
+            uAtClientWriteInt(atHandle, 1);
+        }
         // Numeric format
         uAtClientWriteInt(atHandle, 2);
         // The network
@@ -1171,7 +1434,7 @@ static int32_t registerNetwork(uCellPrivateInstance_t *pInstance,
                     }
                 }
                 // Set the status
-                setNetworkStatus(pInstance, status, rat,
+                setNetworkStatus(pInstance, status, rat, -1, -1,
                                  gRegTypes[regType].domain,
                                  false);
                 uAtClientResponseStop(atHandle);
@@ -1271,7 +1534,7 @@ static int32_t disconnectNetwork(uCellPrivateInstance_t *pInstance,
                                                  sizeof(g3gppStatusToCellStatus[0])))) {
                         setNetworkStatus(pInstance,
                                          g3gppStatusToCellStatus[status3gpp],
-                                         -1, gRegTypes[x].domain, false);
+                                         -1, -1, -1, gRegTypes[x].domain, false);
                     }
                     uAtClientResponseStop(atHandle);
                     uAtClientUnlock(atHandle);
@@ -1294,7 +1557,7 @@ static int32_t disconnectNetwork(uCellPrivateInstance_t *pInstance,
             if (uAtClientReadInt(atHandle) == 0) {
                 setNetworkStatus(pInstance,
                                  U_CELL_NET_STATUS_NOT_REGISTERED,
-                                 -1, U_CELL_NET_REG_DOMAIN_PS, false);
+                                 -1, -1, -1, U_CELL_NET_REG_DOMAIN_PS, false);
             }
             uAtClientResponseStop(atHandle);
             uAtClientUnlock(atHandle);
@@ -1998,6 +2261,203 @@ static int32_t getDnsStrUpsd(const uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Connect to the network, the guts of uCellNetConnect(); if
+// mccMncIsHint is true then pMccMnc is only a hint, as opposed to
+// a requirement, and so is not remembered for re-registration.
+static int32_t connectNetwork(uCellPrivateInstance_t *pInstance,
+                              const char *pMccMnc, bool mccMncIsHint,
+                              const char *pApn, const char *pUsername,
+                              const char *pPassword,
+                              bool (*pKeepGoingCallback) (uDeviceHandle_t cellHandle))
+{
+    int32_t errorCode;
+    char buffer[15];  // At least 15 characters for the IMSI
+    const char *pApnConfig = NULL;
+
+    errorCode = (int32_t) U_CELL_ERROR_NOT_CONNECTED;
+    if (uCellPrivateIsRegistered(pInstance)) {
+        // First deal with any existing context,
+        // which might turn out to be good enough
+        errorCode = handleExistingContext(pInstance, pApn,
+                                          pKeepGoingCallback);
+    }
+
+    if (errorCode != 0) {
+        // Nope, no free ride, do some work
+        errorCode = prepareConnect(pInstance);
+        if (errorCode == 0) {
+            if ((pApn == NULL) &&
+                !uCellMnoDbProfileHas(pInstance,
+                                      U_CELL_MNO_DB_FEATURE_NO_CGDCONT) &&
+                (uCellPrivateGetImsi(pInstance, buffer) == 0)) {
+                // Set up the APN look-up since none is specified
+                pApnConfig = pApnGetConfig(buffer);
+            }
+            pInstance->pKeepGoingCallback = pKeepGoingCallback;
+            pInstance->startTimeMs = uPortGetTickTimeMs();
+            // Now try to connect, potentially multiple times
+            do {
+                if (pApnConfig != NULL) {
+                    pApn = _APN_GET(pApnConfig);
+                    pUsername = _APN_GET(pApnConfig);
+                    pPassword = _APN_GET(pApnConfig);
+                    uPortLog("U_CELL_NET: APN from database is"
+                             " \"%s\".\n", pApn);
+                } else {
+                    if (pApn != NULL) {
+                        if (uCellMnoDbProfileHas(pInstance,
+                                                 U_CELL_MNO_DB_FEATURE_IGNORE_APN)) {
+                            uPortLog("U_CELL_NET: ** WARNING ** user-specified APN"
+                                     " \"%s\" will be IGNORED as the current MNO"
+                                     " profile (%d) does not permit user APNs.\n",
+                                     pApn, pInstance->mnoProfile);
+                            pApn = NULL;
+                        } else if (uCellMnoDbProfileHas(pInstance,
+                                                        U_CELL_MNO_DB_FEATURE_NO_CGDCONT)) {
+                            // An APN has been specified but the MNO profile doesn't
+                            // permit one to be set through AT+CGDCONT (or the AT+UPSD
+                            // equivalent) so flag an error
+                            uPortLog("U_CELL_NET: APN \"%s\" was specified but the"
+                                     " current MNO profile (%d) does not permit an"
+                                     " APN to be set.\n", pInstance->mnoProfile, pApn);
+                            errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                        } else {
+                            uPortLog("U_CELL_NET: user-specified APN is"
+                                     " \"%s\".\n", pApn);
+                        }
+                    } else {
+                        uPortLog("U_CELL_NET: default APN will be"
+                                 " used by network.\n");
+                    }
+                }
+                if ((errorCode == 0) &&
+                    !U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                        U_CELL_PRIVATE_FEATURE_USE_UPSD_CONTEXT_ACTIVATION) &&
+                    !uCellMnoDbProfileHas(pInstance,
+                                          U_CELL_MNO_DB_FEATURE_NO_CGDCONT)) {
+                    // If we're not using AT+UPSD-based
+                    // context activation, set the context using
+                    // AT+CGDCONT and the authentication mode
+                    errorCode = defineContext(pInstance,
+                                              U_CELL_NET_CONTEXT_ID,
+                                              pApn);
+                    if ((errorCode == 0) && (pUsername != NULL) &&
+                        (pPassword != NULL)) {
+                        // Set the authentication mode
+                        errorCode = setAuthenticationMode(pInstance,
+                                                          U_CELL_NET_CONTEXT_ID,
+                                                          pUsername,
+                                                          pPassword);
+                    }
+                }
+                if (errorCode == 0) {
+                    if (pMccMnc == NULL) {
+                        // If no MCC/MNC is given, make sure we are
+                        // in automatic network selection mode
+                        // Don't check error code here as some
+                        // modules can return an error as we still
+                        // have the radio off (but they still obey)
+                        setAutomaticMode(pInstance);
+                    }
+                    // Register
+                    errorCode = registerNetwork(pInstance, pMccMnc, mccMncIsHint);
+                    if (errorCode == 0) {
+                        // Print the network name for debug purposes
+                        if (uCellPrivateGetOperatorStr(pInstance,
+                                                       buffer,
+                                                       sizeof(buffer)) == 0) {
+                            uPortLog("U_CELL_NET: registered on %s.\n", buffer);
+                            // This to prevent warnings if uPortLog is compiled-out
+                            (void) buffer;
+                        }
+                    } else {
+                        uPortLog("U_CELL_NET: unable to register with"
+                                 " the network");
+                        if (pApn != NULL) {
+                            uPortLog(", is APN \"%s\" correct and is an"
+                                     " antenna connected?\n", pApn);
+                        } else {
+                            uPortLog(", does an APN need to be specified"
+                                     " and is an antenna connected?\n");
+                        }
+                    }
+                }
+                if (errorCode == 0) {
+                    // This step _shouldn't_ be necessary.  However,
+                    // for reasons I don't understand, SARA-R4 can be
+                    // registered but not attached (i.e. AT+CGATT
+                    // returns 0) on both RATs (unh?).  Phil Ware, who
+                    // knows about these things, always goes through
+                    // (a) register, (b) wait for AT+CGATT to return 1
+                    // and then (c) check that a context is active
+                    // with AT+CGACT or using AT+UPSD (even for EUTRAN).
+                    // Since this sequence works for both RANs, it is
+                    // best to be consistent.
+                    errorCode = attachNetwork(pInstance);
+                }
+                if (errorCode == 0) {
+                    // Activate the context
+                    if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                           U_CELL_PRIVATE_FEATURE_USE_UPSD_CONTEXT_ACTIVATION)) {
+                        errorCode = activateContextUpsd(pInstance,
+                                                        U_CELL_NET_PROFILE_ID,
+                                                        pApn, pUsername,
+                                                        pPassword);
+                    } else {
+                        errorCode = activateContext(pInstance,
+                                                    U_CELL_NET_CONTEXT_ID,
+                                                    U_CELL_NET_PROFILE_ID);
+                    }
+                    if (errorCode != 0) {
+                        uPortLog("U_CELL_NET: unable to activate a PDP context");
+                        if (pApn != NULL) {
+                            uPortLog(", is APN \"%s\" correct?\n", pApn);
+                        } else {
+                            uPortLog(" (no APN specified/[or allowed]).\n");
+                        }
+                    }
+                }
+                // Exit if there are no errors or if the APN
+                // was user-specified (pApnConfig == NULL) or
+                // we're out of APN database options or the
+                // user callback has returned false
+            } while ((errorCode != 0) && (pApnConfig != NULL) &&
+                     (*pApnConfig != '\0') && keepGoingLocalCb(pInstance));
+
+            if (errorCode == 0) {
+                // Remember the MCC/MNC in case we need to deactivate
+                // and reactivate context later and that causes
+                // de/re-registration.
+                memset(pInstance->mccMnc, 0, sizeof(pInstance->mccMnc));
+                if ((pMccMnc != NULL) && !mccMncIsHint) {
+                    memcpy(pInstance->mccMnc, pMccMnc, sizeof(pInstance->mccMnc));
+                }
+                pInstance->profileState = U_CELL_PRIVATE_PROFILE_STATE_SHOULD_BE_UP;
+                pInstance->connectedAtMs = uPortGetTickTimeMs();
+                uPortLog("U_CELL_NET: connected after %d second(s).\n",
+                         (int32_t) ((uPortGetTickTimeMs() -
+                                     pInstance->startTimeMs) / 1000));
+            } else {
+                // Switch radio off after failure
+                radioOff(pInstance);
+                uPortLog("U_CELL_NET: connection attempt stopped after"
+                         " %d second(s).\n",
+                         (int32_t) ((uPortGetTickTimeMs() -
+                                     pInstance->startTimeMs) / 1000));
+            }
+
+            // Take away the callback again
+            pInstance->pKeepGoingCallback = NULL;
+            pInstance->startTimeMs = 0;
+
+        }
+    } else {
+        uPortLog("U_CELL_NET: already connected.\n");
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -2011,201 +2471,118 @@ int32_t uCellNetConnect(uDeviceHandle_t cellHandle,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    char buffer[15];  // At least 15 characters for the IMSI
-    const char *pApnConfig = NULL;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) &&
             ((pUsername == NULL) || (pPassword != NULL))) {
+            errorCode = connectNetwork(pInstance, pMccMnc, false, pApn,
+                                       pUsername, pPassword, pKeepGoingCallback);
+        }
 
-            errorCode = (int32_t) U_CELL_ERROR_NOT_CONNECTED;
-            if (uCellPrivateIsRegistered(pInstance)) {
-                // First deal with any existing context,
-                // which might turn out to be good enough
-                errorCode = handleExistingContext(pInstance, pApn,
-                                                  pKeepGoingCallback);
-            }
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
 
-            if (errorCode != 0) {
-                // Nope, no free ride, do some work
-                errorCode = prepareConnect(pInstance);
-                if (errorCode == 0) {
-                    if ((pApn == NULL) &&
-                        !uCellMnoDbProfileHas(pInstance,
-                                              U_CELL_MNO_DB_FEATURE_NO_CGDCONT) &&
-                        (uCellPrivateGetImsi(pInstance, buffer) == 0)) {
-                        // Set up the APN look-up since none is specified
-                        pApnConfig = pApnGetConfig(buffer);
-                    }
-                    pInstance->pKeepGoingCallback = pKeepGoingCallback;
-                    pInstance->startTimeMs = uPortGetTickTimeMs();
-                    // Now try to connect, potentially multiple times
-                    do {
-                        if (pApnConfig != NULL) {
-                            pApn = _APN_GET(pApnConfig);
-                            pUsername = _APN_GET(pApnConfig);
-                            pPassword = _APN_GET(pApnConfig);
-                            uPortLog("U_CELL_NET: APN from database is"
-                                     " \"%s\".\n", pApn);
-                        } else {
-                            if (pApn != NULL) {
-                                if (uCellMnoDbProfileHas(pInstance,
-                                                         U_CELL_MNO_DB_FEATURE_IGNORE_APN)) {
-                                    uPortLog("U_CELL_NET: ** WARNING ** user-specified APN"
-                                             " \"%s\" will be IGNORED as the current MNO"
-                                             " profile (%d) does not permit user APNs.\n",
-                                             pApn, pInstance->mnoProfile);
-                                    pApn = NULL;
-                                } else if (uCellMnoDbProfileHas(pInstance,
-                                                                U_CELL_MNO_DB_FEATURE_NO_CGDCONT)) {
-                                    // An APN has been specified but the MNO profile doesn't
-                                    // permit one to be set through AT+CGDCONT (or the AT+UPSD
-                                    // equivalent) so flag an error
-                                    uPortLog("U_CELL_NET: APN \"%s\" was specified but the"
-                                             " current MNO profile (%d) does not permit an"
-                                             " APN to be set.\n", pInstance->mnoProfile, pApn);
-                                    errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-                                } else {
-                                    uPortLog("U_CELL_NET: user-specified APN is"
-                                             " \"%s\".\n", pApn);
-                                }
-                            } else {
-                                uPortLog("U_CELL_NET: default APN will be"
-                                         " used by network.\n");
-                            }
-                        }
-                        if ((errorCode == 0) &&
-                            !U_CELL_PRIVATE_HAS(pInstance->pModule,
-                                                U_CELL_PRIVATE_FEATURE_USE_UPSD_CONTEXT_ACTIVATION) &&
-                            !uCellMnoDbProfileHas(pInstance,
-                                                  U_CELL_MNO_DB_FEATURE_NO_CGDCONT)) {
-                            // If we're not using AT+UPSD-based
-                            // context activation, set the context using
-                            // AT+CGDCONT and the authentication mode
-                            errorCode = defineContext(pInstance,
-                                                      U_CELL_NET_CONTEXT_ID,
-                                                      pApn);
-                            if ((errorCode == 0) && (pUsername != NULL) &&
-                                (pPassword != NULL)) {
-                                // Set the authentication mode
-                                errorCode = setAuthenticationMode(pInstance,
-                                                                  U_CELL_NET_CONTEXT_ID,
-                                                                  pUsername,
-                                                                  pPassword);
-                            }
-                        }
-                        if (errorCode == 0) {
-                            if (pMccMnc == NULL) {
-                                // If no MCC/MNC is given, make sure we are
-                                // in automatic network selection mode
-                                // Don't check error code here as some
-                                // modules can return an error as we still
-                                // have the radio off (but they still obey)
-                                setAutomaticMode(pInstance);
-                            }
-                            // Register
-                            errorCode = registerNetwork(pInstance, pMccMnc);
-                            if (errorCode == 0) {
-                                // Print the network name for debug purposes
-                                if (uCellPrivateGetOperatorStr(pInstance,
-                                                               buffer,
-                                                               sizeof(buffer)) == 0) {
-                                    uPortLog("U_CELL_NET: registered on %s.\n", buffer);
-                                    // This to prevent warnings if uPortLog is compiled-out
-                                    (void) buffer;
-                                }
-                            } else {
-                                uPortLog("U_CELL_NET: unable to register with"
-                                         " the network");
-                                if (pApn != NULL) {
-                                    uPortLog(", is APN \"%s\" correct and is an"
-                                             " antenna connected?\n", pApn);
-                                } else {
-                                    uPortLog(", does an APN need to be specified"
-                                             " and is an antenna connected?\n");
-                                }
-                            }
-                        }
-                        if (errorCode == 0) {
-                            // This step _shouldn't_ be necessary.  However,
-                            // for reasons I don't understand, SARA-R4 can be
-                            // registered but not attached (i.e. AT+CGATT
-                            // returns 0) on both RATs (unh?).  Phil Ware, who
-                            // knows about these things, always goes through
-                            // (a) register, (b) wait for AT+CGATT to return 1
-                            // and then (c) check that a context is active
-                            // with AT+CGACT or using AT+UPSD (even for EUTRAN).
-                            // Since this sequence works for both RANs, it is
-                            // best to be consistent.
-                            errorCode = attachNetwork(pInstance);
-                        }
-                        if (errorCode == 0) {
-                            // Activate the context
-                            if (U_CELL_PRIVATE_HAS(pInstance->pModule,
-                                                   U_CELL_PRIVATE_FEATURE_USE_UPSD_CONTEXT_ACTIVATION)) {
-                                errorCode = activateContextUpsd(pInstance,
-                                                                U_CELL_NET_PROFILE_ID,
-                                                                pApn, pUsername,
-                                                                pPassword);
-                            } else {
-                                errorCode = activateContext(pInstance,
-                                                            U_CELL_NET_CONTEXT_ID,
-                                                            U_CELL_NET_PROFILE_ID);
-                            }
-                            if (errorCode != 0) {
-                                uPortLog("U_CELL_NET: unable to activate a PDP context");
-                                if (pApn != NULL) {
-                                    uPortLog(", is APN \"%s\" correct?\n", pApn);
-                                } else {
-                                    uPortLog(" (no APN specified/[or allowed]).\n");
-                                }
-                            }
-                        }
-                        // Exit if there are no errors or if the APN
-                        // was user-specified (pApnConfig == NULL) or
-                        // we're out of APN database options or the
-                        // user callback has returned false
-                    } while ((errorCode != 0) && (pApnConfig != NULL) &&
-                             (*pApnConfig != '\0') && keepGoingLocalCb(pInstance));
+    return errorCode;
+}
 
-                    if (errorCode == 0) {
-                        // Remember the MCC/MNC in case we need to deactivate
-                        // and reactivate context later and that causes
-                        // de/re-registration.
-                        memset(pInstance->mccMnc, 0, sizeof(pInstance->mccMnc));
-                        if (pMccMnc != NULL) {
-                            memcpy(pInstance->mccMnc, pMccMnc, sizeof(pInstance->mccMnc));
-                        }
-                        pInstance->profileState = U_CELL_PRIVATE_PROFILE_STATE_SHOULD_BE_UP;
-                        pInstance->connectedAtMs = uPortGetTickTimeMs();
-                        uPortLog("U_CELL_NET: connected after %d second(s).\n",
-                                 (int32_t) ((uPortGetTickTimeMs() -
-                                             pInstance->startTimeMs) / 1000));
-                    } else {
-                        // Switch radio off after failure
-                        radioOff(pInstance);
-                        uPortLog("U_CELL_NET: connection attempt stopped after"
-                                 " %d second(s).\n",
-                                 (int32_t) ((uPortGetTickTimeMs() -
-                                             pInstance->startTimeMs) / 1000));
-                    }
+// Connect to the network using the last-known network parameters.
+int32_t uCellNetConnectWarm(uDeviceHandle_t cellHandle,
+                            const uCellNetWarmStart_t *pWarmStart,
+                            const char *pApn, const char *pUsername,
+                            const char *pPassword,
+                            bool (*pKeepGoingCallback) (uDeviceHandle_t cellHandle))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    const char *pWarmApn = pApn;
+    char mccMnc[U_CELL_NET_MCC_MNC_LENGTH_BYTES];
+    bool fallBack = true;
 
-                    // Take away the callback again
-                    pInstance->pKeepGoingCallback = NULL;
-                    pInstance->startTimeMs = 0;
+    if (gUCellPrivateMutex != NULL) {
 
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) &&
+            ((pUsername == NULL) || (pPassword != NULL))) {
+            if ((pWarmStart != NULL) &&
+                (pWarmStart->magic == U_CELL_NET_WARM_START_MAGIC) &&
+                (pWarmStart->mccMnc[0] != 0)) {
+                // Take a terminated copy, the blob may have come
+                // from anywhere
+                memset(mccMnc, 0, sizeof(mccMnc));
+                strncpy(mccMnc, pWarmStart->mccMnc, sizeof(mccMnc) - 1);
+                if ((pWarmApn == NULL) && (pWarmStart->apn[0] != 0) &&
+                    (memchr(pWarmStart->apn, 0, sizeof(pWarmStart->apn)) != NULL)) {
+                    pWarmApn = pWarmStart->apn;
+                }
+                uPortLog("U_CELL_NET: warm start using operator %s, APN \"%s\".\n",
+                         mccMnc, pWarmApn != NULL ? pWarmApn : "");
+                pInstance->warmStartTimeMs = uPortGetTickTimeMs();
+                errorCode = connectNetwork(pInstance, mccMnc, true, pWarmApn,
+                                           pUsername, pPassword,
+                                           pKeepGoingCallback);
+                pInstance->warmStartTimeMs = 0;
+                if (errorCode == 0) {
+                    fallBack = false;
+                } else {
+                    uPortLog("U_CELL_NET: warm start failed (%d).\n", errorCode);
+                    if ((pKeepGoingCallback != NULL) &&
+                        !pKeepGoingCallback(cellHandle)) {
+                        // The user has had enough
+                        fallBack = false;
+                    }
                 }
-            } else {
-                uPortLog("U_CELL_NET: already connected.\n");
+            }
+            if (fallBack) {
+                errorCode = connectNetwork(pInstance, NULL, false, pApn,
+                                           pUsername, pPassword,
+                                           pKeepGoingCallback);
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Store the current network parameters for a later warm start.
+int32_t uCellNetGetWarmStart(uDeviceHandle_t cellHandle,
+                             uCellNetWarmStart_t *pWarmStart)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t mcc;
+    int32_t mnc;
+    uCellNetWarmStart_t warmStart;
+
+    // Made up entirely of calls to the public API, which
+    // do their own locking
+    if (pWarmStart != NULL) {
+        memset(&warmStart, 0, sizeof(warmStart));
+        errorCode = uCellNetGetMccMnc(cellHandle, &mcc, &mnc);
+        if (errorCode == 0) {
+            snprintf(warmStart.mccMnc, sizeof(warmStart.mccMnc),
+                     "%03d%02d", (int) mcc, (int) mnc);
+            warmStart.rat = uCellNetGetActiveRat(cellHandle);
+            if (warmStart.rat >= 0) {
+                // Not all modules support getting the band mask
+                // so don't worry if this fails
+                uCellCfgGetBandMask(cellHandle, warmStart.rat,
+                                    &(warmStart.bandMask1),
+                                    &(warmStart.bandMask2));
+            }
+            if (uCellNetGetApnStr(cellHandle, warmStart.apn,
+                                  sizeof(warmStart.apn)) < 0) {
+                memset(warmStart.apn, 0, sizeof(warmStart.apn));
+            }
+            warmStart.magic = U_CELL_NET_WARM_START_MAGIC;
+            memcpy(pWarmStart, &warmStart, sizeof(*pWarmStart));
+        }
     }
 
     return errorCode;
@@ -2222,9 +2599,8 @@ int32_t uCellNetRegister(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
 
@@ -2241,7 +2617,7 @@ int32_t uCellNetRegister(uDeviceHandle_t cellHandle,
                     setAutomaticMode(pInstance);
                 }
                 // Register
-                errorCode = registerNetwork(pInstance, pMccMnc);
+                errorCode = registerNetwork(pInstance, pMccMnc, false);
                 if (errorCode == 0) {
                     if (uCellPrivateGetOperatorStr(pInstance,
                                                    buffer,
@@ -2285,7 +2661,7 @@ int32_t uCellNetRegister(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2305,9 +2681,8 @@ int32_t uCellNetActivate(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) &&
             ((pUsername == NULL) || (pPassword != NULL))) {
@@ -2372,7 +2747,7 @@ int32_t uCellNetActivate(uDeviceHandle_t cellHandle,
                                     if (strlen(pInstance->mccMnc) > 0) {
                                         pMccMnc = pInstance->mccMnc;
                                     }
-                                    errorCode = registerNetwork(pInstance, pMccMnc);
+                                    errorCode = registerNetwork(pInstance, pMccMnc, false);
                                     if (errorCode == 0) {
                                         // This step _shouldn't_ be necessary.  However,
                                         // for reasons I don't understand, SARA-R4 can
@@ -2420,7 +2795,7 @@ int32_t uCellNetActivate(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2436,9 +2811,8 @@ int32_t uCellNetDeactivate(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             if (uCellPrivateIsRegistered(pInstance)) {
@@ -2464,7 +2838,7 @@ int32_t uCellNetDeactivate(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2481,9 +2855,8 @@ int32_t uCellNetDisconnect(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
@@ -2511,7 +2884,7 @@ int32_t uCellNetDisconnect(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2525,139 +2898,57 @@ int32_t uCellNetScanGetFirst(uDeviceHandle_t cellHandle,
 {
     int32_t errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
-    char *pBuffer;
-    int32_t bytesRead;
-    int32_t mode;
-    int64_t innerStartTimeMs;
-    uAtClientDeviceError_t deviceError;
-    bool gotAnswer = false;
-    char *pSaved;
-    char *pStr;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrNumber = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) &&
             ((pName == NULL) || (nameSize > 0))) {
-            atHandle = pInstance->atHandle;
             // Free any previous scan results
-            uCellPrivateScanFree(&(pInstance->pScanResults));
-            errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-            // Malloc() some temporary storage
-            pBuffer = (char *) malloc(U_CELL_NET_SCAN_LENGTH_BYTES);
-            //lint -esym(429, pBuffer) Suppress complaint about
-            // pBuffer not being free()ed: it is!
-            if (pBuffer != NULL) {
-                errorCodeOrNumber = (int32_t) U_CELL_ERROR_TEMPORARY_FAILURE;
-                // Ensure that we're powered up.
-                mode = uCellPrivateCFunOne(pInstance);
-                // Start a scan
-                // Do this three times: if the module
-                // is busy doing its own search when we ask it
-                // to do a network search, as it might be if
-                // we've just come out of airplane mode,
-                // it will ignore us and simply return the
-                // "test" response to the AT+COPS=? command,
-                // i.e.: +COPS: ,,(0-6),(0-2)
-                // If we get the "test" response instead
-                // readBytes will be 12 whereas for the
-                // intended response of:
-                // (<stat>,<long_name>,<short_name>,<numeric>[,<AcT>])
-                // it will be at longer than that hence we set
-                // a threshold for readBytes of > 12 characters.
-                pInstance->startTimeMs = uPortGetTickTimeMs();
-                for (size_t x = U_CELL_NET_SCAN_RETRIES + 1;
-                     (x > 0) && (errorCodeOrNumber <= 0) &&
-                     ((pKeepGoingCallback == NULL) || (pKeepGoingCallback(cellHandle)));
-                     x--) {
-                    uAtClientLock(atHandle);
-                    // Set the timeout to a second so that we
-                    // can spin around the loop
-                    gotAnswer = false;
-                    uAtClientTimeoutSet(atHandle, 1000);
-                    uAtClientCommandStart(atHandle, "AT+COPS=?");
-                    uAtClientCommandStop(atHandle);
-                    // Will get back "+COPS:" then a single line consisting of
-                    // comma delimited list of
-                    // (<stat>,<long_name>,<short_name>,<numeric>[,<AcT>])
-                    // ...plus some other stuff on the end.
-                    // Sit in a loop waiting for a response
-                    // of some form to arrive
-                    bytesRead = -1;
-                    innerStartTimeMs = uPortGetTickTimeMs();
-                    while ((bytesRead <= 0) &&
-                           (uPortGetTickTimeMs() - innerStartTimeMs <
-                            (U_CELL_NET_SCAN_TIME_SECONDS * 1000)) &&
-                           ((pKeepGoingCallback == NULL) || (pKeepGoingCallback(cellHandle)))) {
-                        uAtClientResponseStart(atHandle, "+COPS:");
-                        // We use uAtClientReadBytes() here because the
-                        // thing we're reading contains quotation marks
-                        // but we do actually want to end up with a string,
-                        // so leave room to add a terminator
-                        bytesRead = uAtClientReadBytes(atHandle, pBuffer,
-                                                       U_CELL_NET_SCAN_LENGTH_BYTES - 1,
-                                                       false);
-                        if (bytesRead >= 0) {
-                            // Add a terminator
-                            *(pBuffer + bytesRead) = 0;
-                        }
-                        // Check if an error has been returned by the module,
-                        // e.g. +CME ERROR: Temporary Failure, and if
-                        // so exit the while() loop and try AT+COPS=? again.
-                        uAtClientDeviceErrorGet(atHandle, &deviceError);
-                        if (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR) {
-                            // Purely to exit the while() loop and cause us to
-                            // try gain in the outer for() loop
-                            bytesRead = 1;
-                        }
-                        uAtClientClearError(atHandle);
-                        uPortTaskBlock(1000);
-                    }
-                    if (bytesRead > 0) {
-                        // Got _something_ back, but it may still be the
-                        // "test" response or a device error
-                        gotAnswer = true;
-                    }
-                    if (bytesRead > 12) {
-                        // Got a real answer: process it in
-                        // chunks delimited by ")"
-                        for (pStr = strtok_r(pBuffer, ")", &pSaved);
-                             pStr != NULL;
-                             pStr = strtok_r(NULL, ")", &pSaved)) {
-                            errorCodeOrNumber = storeNextScanItem(pInstance, pStr);
-                        }
-                    }
-                    uAtClientResponseStop(atHandle);
-                    uAtClientUnlock(atHandle);
-                    if (!gotAnswer) {
-                        // If we never got an answer, abort the
-                        // command first.
-                        abortCommand(pInstance);
-                    }
-                }
+            uCellPrivateScanFree(pInstance);
+            errorCodeOrNumber = scanNetworks(pInstance, storeScanItem, NULL,
+                                             pKeepGoingCallback);
+            if (errorCodeOrNumber >= 0) {
+                // Return the first thing from what we stored
+                readNextScanItem(pInstance, pMccMnc, pName,
+                                 nameSize, pRat);
+            }
+        }
 
-                // Free memory
-                free(pBuffer);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
 
-                // Put the mode back if it was not already 1
-                if ((mode >= 0) && (mode != 1)) {
-                    uCellPrivateCFunMode(pInstance, mode);
-                }
-                if (gotAnswer) {
-                    // Return the first thing from what we stored
-                    readNextScanItem(pInstance, pMccMnc, pName,
-                                     nameSize, pRat);
-                } else {
-                    errorCodeOrNumber = (int32_t) U_ERROR_COMMON_TIMEOUT;
-                }
-            }
+    return errorCodeOrNumber;
+}
+
+// Perform a network scan, streaming the results to a callback.
+int32_t uCellNetScan(uDeviceHandle_t cellHandle,
+                     bool (*pCallback) (uDeviceHandle_t, const char *,
+                                        const char *, uCellNetRat_t,
+                                        void *),
+                     void *pCallbackParameter,
+                     bool (*pKeepGoingCallback) (uDeviceHandle_t cellHandle))
+{
+    int32_t errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellNetScanCallback_t scanCallback;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrNumber = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pCallback != NULL)) {
+            scanCallback.pCallback = pCallback;
+            scanCallback.pCallbackParameter = pCallbackParameter;
+            errorCodeOrNumber = scanNetworks(pInstance, userScanItem,
+                                             &scanCallback,
+                                             pKeepGoingCallback);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrNumber;
@@ -2673,20 +2964,19 @@ int32_t uCellNetScanGetNext(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = readNextScanItem(pInstance, pMccMnc, pName,
                                          nameSize, pRat);
             if (errorCode == 0) {
                 // Must have read the lot, free the scan results
-                uCellPrivateScanFree(&(pInstance->pScanResults));
+                uCellPrivateScanFree(pInstance);
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2699,15 +2989,14 @@ void uCellNetScanGetLast(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             // Free scan results
-            uCellPrivateScanFree(&(pInstance->pScanResults));
+            uCellPrivateScanFree(pInstance);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 }
 
@@ -2723,9 +3012,8 @@ int32_t uCellNetSetRegistrationStatusCallback(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             pInstance->pRegistrationStatusCallback = pCallback;
@@ -2733,7 +3021,7 @@ int32_t uCellNetSetRegistrationStatusCallback(uDeviceHandle_t cellHandle,
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2752,9 +3040,8 @@ int32_t uCellNetSetBaseStationConnectionStatusCallback(uDeviceHandle_t cellHandl
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
@@ -2780,7 +3067,7 @@ int32_t uCellNetSetBaseStationConnectionStatusCallback(uDeviceHandle_t cellHandl
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2795,20 +3082,64 @@ uCellNetStatus_t uCellNetGetNetworkStatus(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrStatus = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (domain < U_CELL_NET_REG_DOMAIN_MAX_NUM)) {
             errorCodeOrStatus = (int32_t) pInstance->networkStatus[domain];
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return (uCellNetStatus_t) errorCodeOrStatus;
 }
 
+// Get a snapshot of the registration state.
+int32_t uCellNetGetRegistrationSnapshot(uDeviceHandle_t cellHandle,
+                                        uCellNetRegDomain_t domain,
+                                        uCellNetRegistrationSnapshot_t *pSnapshot)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uint32_t sequence;
+    bool retry;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (domain < U_CELL_NET_REG_DOMAIN_MAX_NUM) &&
+            (pSnapshot != NULL)) {
+            // The URC writing this doesn't take the mutex, instead
+            // it increments the sequence number before and after
+            // writing, so copy until we get a sequence number that
+            // is even (not mid-write) and unchanged
+            do {
+                sequence = pInstance->networkStatusSequence;
+                pSnapshot->status = pInstance->networkStatus[domain];
+                pSnapshot->rat = pInstance->rat[domain];
+                pSnapshot->cellId = pInstance->cellId[domain];
+                pSnapshot->areaCode = pInstance->areaCode[domain];
+                pSnapshot->updatedAtMs = pInstance->networkStatusUpdatedMs[domain];
+                retry = ((sequence & 1) != 0) ||
+                        (sequence != pInstance->networkStatusSequence);
+                if (retry) {
+                    // Let the writer, which may be of lower
+                    // priority than us, finish
+                    uPortTaskBlock(1);
+                }
+            } while (retry);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
 // Get a value whether the module is registered on the network.
 bool uCellNetIsRegistered(uDeviceHandle_t cellHandle)
 {
@@ -2817,14 +3148,13 @@ bool uCellNetIsRegistered(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             isRegistered = uCellPrivateIsRegistered(pInstance);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isRegistered;
@@ -2838,15 +3168,14 @@ uCellNetRat_t uCellNetGetActiveRat(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrRat = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrRat = (int32_t) uCellPrivateGetActiveRat(pInstance);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return (uCellNetRat_t) errorCodeOrRat;
@@ -2861,9 +3190,8 @@ int32_t uCellNetGetOperatorStr(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
             errorCodeOrSize = (int32_t) U_CELL_ERROR_NOT_REGISTERED;
@@ -2881,7 +3209,7 @@ int32_t uCellNetGetOperatorStr(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -2899,9 +3227,8 @@ int32_t uCellNetGetMccMnc(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pMcc != NULL) && (pMnc != NULL)) {
             errorCode = (int32_t) U_CELL_ERROR_NOT_REGISTERED;
@@ -2942,7 +3269,7 @@ int32_t uCellNetGetMccMnc(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2961,9 +3288,8 @@ int32_t uCellNetGetIpAddressStr(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrSize = (int32_t) U_CELL_ERROR_NOT_CONNECTED;
@@ -3035,7 +3361,7 @@ int32_t uCellNetGetIpAddressStr(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -3050,9 +3376,8 @@ int32_t uCellNetGetDnsStr(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -3067,7 +3392,7 @@ int32_t uCellNetGetDnsStr(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -3082,9 +3407,8 @@ int32_t uCellNetGetApnStr(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -3101,7 +3425,7 @@ int32_t uCellNetGetApnStr(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -3124,9 +3448,8 @@ int32_t uCellNetGetDataCounterTx(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -3157,7 +3480,7 @@ int32_t uCellNetGetDataCounterTx(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrCount;
@@ -3175,9 +3498,8 @@ int32_t uCellNetGetDataCounterRx(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -3209,7 +3531,7 @@ int32_t uCellNetGetDataCounterRx(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrCount;
@@ -3224,9 +3546,8 @@ int32_t uCellNetResetDataCounters(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -3243,7 +3564,7 @@ int32_t uCellNetResetDataCounters(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -40,10 +40,13 @@
 #include "u_port.h"
 #include "u_port_os.h"
 #include "u_port_uart.h"
+#include "u_port_event_queue.h"
 #include "u_port_gpio.h"
 #include "u_port_crypto.h"
 
 #include "u_at_client.h"
+#include "u_cmux.h"
+#include "u_device_shared.h"
 
 #include "u_security.h"
 
@@ -59,6 +62,11 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** How often to check whether an instance that is being removed
+ * is still in use.
+ */
+#define U_CELL_PRIVATE_INSTANCE_UNUSED_POLL_MS 10
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -203,7 +211,9 @@ const uCellPrivateModule_t gUCellPrivateModuleList[] = {
          (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_MQTTSN)                              |
          (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_CTS_CONTROL)                         |
          (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_SOCK_SET_LOCAL_PORT)                 |
-         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_FOTA) /* features */
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_FOTA)                                |
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_ASYNC_SOCK_CONNECT)                  |
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_SECURITY_TLS_SESSION_RESUMPTION) /* features */
         )
     },
     {
@@ -256,7 +266,9 @@ const uCellPrivateModule_t gUCellPrivateModuleList[] = {
          //(1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_3GPP_POWER_SAVING_PAGING_WINDOW_SET) |
          (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_EDRX)                                  |
          (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_MQTTSN)                                |
-         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_FOTA) /* features */
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_FOTA)                                  |
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_ASYNC_SOCK_CONNECT)                    |
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_SECURITY_TLS_SESSION_RESUMPTION) /* features */
         )
     },
     {
@@ -281,7 +293,9 @@ const uCellPrivateModule_t gUCellPrivateModuleList[] = {
          (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_DTR_POWER_SAVING)                    |
          (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_MQTTSN)                              |
          (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_SOCK_SET_LOCAL_PORT)                 |
-         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_FOTA) /* features */
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_FOTA)                                |
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_ASYNC_SOCK_CONNECT)                  |
+         (1ULL << (int32_t) U_CELL_PRIVATE_FEATURE_SECURITY_TLS_SESSION_RESUMPTION) /* features */
         )
     }
 };
@@ -454,6 +468,116 @@ static void fileListClear(uCellPrivateFileListContainer_t **ppFileContainer)
     }
 }
 
+// Return true if two file system tags are the same, where NULL is
+// a valid tag (the default area).
+static bool fileTagIsSame(const char *pTag1, const char *pTag2)
+{
+    return ((pTag1 == NULL) && (pTag2 == NULL)) ||
+           ((pTag1 != NULL) && (pTag2 != NULL) && (strcmp(pTag1, pTag2) == 0));
+}
+
+// Return the file cache of an instance if it is populated and
+// applies to the tag currently in use, else NULL.
+static uCellPrivateFileCache_t *pFileCacheGet(const uCellPrivateInstance_t *pInstance)
+{
+    uCellPrivateFileCache_t *pFileCache = pInstance->pFileCache;
+
+    if ((pFileCache != NULL) &&
+        (!pFileCache->valid ||
+         !fileTagIsSame(pFileCache->pTag, pInstance->pFileSystemTag))) {
+        pFileCache = NULL;
+    }
+
+    return pFileCache;
+}
+
+// Find a file in a file cache, returning a pointer to the pointer
+// to it, which will point to NULL if the file is not there.
+static uCellPrivateFileCacheEntry_t **ppFileCacheFind(uCellPrivateFileCache_t *pFileCache,
+                                                      const char *pFileName)
+{
+    uCellPrivateFileCacheEntry_t **ppEntry = &(pFileCache->pList);
+
+    while ((*ppEntry != NULL) && (strcmp((*ppEntry)->fileName, pFileName) != 0)) {
+        ppEntry = &((*ppEntry)->pNext);
+    }
+
+    return ppEntry;
+}
+
+// Empty a file cache.
+static void fileCacheEmpty(uCellPrivateFileCache_t *pFileCache)
+{
+    uCellPrivateFileCacheEntry_t *pTmp;
+
+    pFileCache->valid = false;
+    while (pFileCache->pList != NULL) {
+        pTmp = pFileCache->pList->pNext;
+        free(pFileCache->pList);
+        pFileCache->pList = pTmp;
+    }
+}
+
+// Fill a file cache from a file list container, returning false
+// if there is insufficient memory to do so, in which case the
+// file cache is left empty.
+static bool fileCacheFill(uCellPrivateFileCache_t *pFileCache,
+                          const char *pTag,
+                          const uCellPrivateFileListContainer_t *pFileContainer)
+{
+    uCellPrivateFileCacheEntry_t **ppEntry = &(pFileCache->pList);
+    bool success = true;
+
+    pFileCache->valid = false;
+    pFileCache->pTag = pTag;
+    while ((pFileContainer != NULL) && success) {
+        *ppEntry = (uCellPrivateFileCacheEntry_t *) malloc(sizeof(**ppEntry));
+        success = (*ppEntry != NULL);
+        if (success) {
+            strncpy((*ppEntry)->fileName, pFileContainer->fileName,
+                    sizeof((*ppEntry)->fileName));
+            (*ppEntry)->size = -1;
+            (*ppEntry)->pNext = NULL;
+            ppEntry = &((*ppEntry)->pNext);
+            pFileContainer = pFileContainer->pNext;
+        }
+    }
+
+    if (success) {
+        pFileCache->valid = true;
+    } else {
+        fileCacheEmpty(pFileCache);
+    }
+
+    return success;
+}
+
+// Finish off uCellPrivateFileListFirst(): copy out the first item
+// in the list and remove it, returning the number of items there
+// were in the list, or clear the list if errorCode indicates a
+// failure.
+static int32_t fileListFirstFinish(uCellPrivateFileListContainer_t **ppFileListContainer,
+                                   int32_t errorCode, size_t count,
+                                   char *pFileName)
+{
+    if (errorCode == (int32_t) U_ERROR_COMMON_NO_MEMORY) {
+        // If we ran out of memory, clear the whole list,
+        // don't want to report partial information
+        fileListClear(ppFileListContainer);
+    } else {
+        if (count > 0) {
+            // Set the return value, copy out the first item in the list
+            // and remove it.
+            errorCode = (int32_t) count;
+            fileListGetRemove(ppFileListContainer, pFileName);
+        } else {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        }
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS THAT ARE PRIVATE TO CELLULAR
  * -------------------------------------------------------------- */
@@ -471,18 +595,104 @@ bool uCellPrivateIsNumeric(const char *pBuffer, size_t bufferSize)
     return numeric;
 }
 
-// Find a cellular instance in the list by instance handle.
+// Find a cellular instance by instance handle: rather than
+// walking the list, the handle leads straight to the device
+// instance, which points at the cellular instance.
 uCellPrivateInstance_t *pUCellPrivateGetInstance(uDeviceHandle_t cellHandle)
 {
-    uCellPrivateInstance_t *pInstance = gpUCellPrivateInstanceList;
+    uCellPrivateInstance_t *pInstance = NULL;
+    uDeviceInstance_t *pDevInstance = U_DEVICE_INSTANCE(cellHandle);
+
+    if ((pDevInstance != NULL) &&
+        (pDevInstance->deviceType == U_DEVICE_TYPE_CELL)) {
+        pInstance = (uCellPrivateInstance_t *) pDevInstance->pDriverInstance;
+        if ((pInstance != NULL) && (pInstance->cellHandle != cellHandle)) {
+            pInstance = NULL;
+        }
+    }
 
-    while ((pInstance != NULL) && (pInstance->cellHandle != cellHandle)) {
-        pInstance = pInstance->pNext;
+    return pInstance;
+}
+
+// Find a cellular instance and lock it, waiting for up to delayMs,
+// or forever if delayMs is negative.
+static uCellPrivateInstance_t *pInstanceLock(uDeviceHandle_t cellHandle,
+                                             int32_t delayMs)
+{
+    uCellPrivateInstance_t *pInstance = NULL;
+    int32_t errorCode;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        if (pInstance != NULL) {
+            // Registering as a user stops the instance being
+            // free'd while we wait for it
+            pInstance->lockUsers++;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+
+        if (pInstance != NULL) {
+            if (delayMs < 0) {
+                errorCode = uPortMutexLock(pInstance->mutex);
+            } else {
+                errorCode = uPortMutexTryLock(pInstance->mutex, delayMs);
+            }
+            if (errorCode != 0) {
+                U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+                pInstance->lockUsers--;
+                U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+                pInstance = NULL;
+            }
+        }
     }
 
     return pInstance;
 }
 
+// Find a cellular instance and lock it.
+uCellPrivateInstance_t *pUCellPrivateInstanceLock(uDeviceHandle_t cellHandle)
+{
+    return pInstanceLock(cellHandle, -1);
+}
+
+// Find a cellular instance and lock it, waiting for a limited time.
+uCellPrivateInstance_t *pUCellPrivateInstanceTryLock(uDeviceHandle_t cellHandle,
+                                                     int32_t delayMs)
+{
+    return pInstanceLock(cellHandle, delayMs);
+}
+
+// Unlock a cellular instance.
+void uCellPrivateInstanceUnlock(uCellPrivateInstance_t *pInstance)
+{
+    if (pInstance != NULL) {
+        uPortMutexUnlock(pInstance->mutex);
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        pInstance->lockUsers--;
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+}
+
+// Wait until no-one is using the lock of an instance.
+void uCellPrivateInstanceWaitUnused(uCellPrivateInstance_t *pInstance)
+{
+    int32_t lockUsers;
+
+    do {
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        lockUsers = pInstance->lockUsers;
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        if (lockUsers > 0) {
+            uPortTaskBlock(U_CELL_PRIVATE_INSTANCE_UNUSED_POLL_MS);
+        }
+    } while (lockUsers > 0);
+}
+
 // Set the radio parameters back to defaults.
 void uCellPrivateClearRadioParameters(uCellPrivateRadioParameters_t *pParameters)
 {
@@ -498,16 +708,20 @@ void uCellPrivateClearRadioParameters(uCellPrivateRadioParameters_t *pParameters
 // the radio parameters.
 void uCellPrivateClearDynamicParameters(uCellPrivateInstance_t *pInstance)
 {
+    pInstance->networkStatusSequence++;
     for (size_t x = 0;
          x < sizeof(pInstance->networkStatus) / sizeof(pInstance->networkStatus[0]);
          x++) {
         pInstance->networkStatus[x] = U_CELL_NET_STATUS_UNKNOWN;
+        pInstance->cellId[x] = -1;
+        pInstance->areaCode[x] = -1;
     }
     for (size_t x = 0;
          x < sizeof(pInstance->rat) / sizeof(pInstance->rat[0]);
          x++) {
         pInstance->rat[x] = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
     }
+    pInstance->networkStatusSequence++;
     uCellPrivateClearRadioParameters(&(pInstance->radioParameters));
 }
 
@@ -591,6 +805,10 @@ void uCellPrivateCFunMode(uCellPrivateInstance_t *pInstance,
     if (uAtClientUnlock(atHandle) == 0) {
         pInstance->lastCfunFlipTimeMs = uPortGetTickTimeMs();
     }
+    if (mode == 0) {
+        // The SIM is deactivated in AT+CFUN=0 and so could be swapped
+        uCellPrivateIdentityCacheClear(pInstance, true);
+    }
 }
 
 // Get the IMSI of the SIM.
@@ -629,13 +847,19 @@ int32_t uCellPrivateGetImsi(const uCellPrivateInstance_t *pInstance,
 }
 
 // Get the IMEI of the cellular module.
-int32_t uCellPrivateGetImei(const uCellPrivateInstance_t *pInstance,
+int32_t uCellPrivateGetImei(uCellPrivateInstance_t *pInstance,
                             char *pImei)
 {
     int32_t errorCode = (int32_t) U_CELL_ERROR_AT;
     uAtClientHandle_t atHandle = pInstance->atHandle;
+    uCellPrivateIdentityCache_t *pCache = &(pInstance->identityCache);
     int32_t bytesRead;
 
+    if (pCache->imeiValid) {
+        memcpy(pImei, pCache->imei, sizeof(pCache->imei));
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
     // Try this ten times: unfortunately
     // the module can spit out a URC just when
     // we're expecting the IMEI and, since there
@@ -655,12 +879,26 @@ int32_t uCellPrivateGetImei(const uCellPrivateInstance_t *pInstance,
             (bytesRead == 15) &&
             uCellPrivateIsNumeric(pImei, 15)) {
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            memcpy(pCache->imei, pImei, sizeof(pCache->imei));
+            pCache->imeiValid = true;
         }
     }
 
     return errorCode;
 }
 
+// Forget the cached identity of the module.
+void uCellPrivateIdentityCacheClear(uCellPrivateInstance_t *pInstance,
+                                    bool simOnly)
+{
+    if (simOnly) {
+        pInstance->identityCache.iccidStr[0] = 0;
+    } else {
+        memset(&(pInstance->identityCache), 0,
+               sizeof(pInstance->identityCache));
+    }
+}
+
 // Get whether the given instance is registered with the network.
 // Needs to be in the packet switched domain, circuit switched is
 // no use for this API.
@@ -739,17 +977,11 @@ int32_t uCellPrivateGetOperatorStr(const uCellPrivateInstance_t *pInstance,
 }
 
 // Free network scan results.
-void uCellPrivateScanFree(uCellPrivateNet_t **ppScanResults)
+void uCellPrivateScanFree(uCellPrivateInstance_t *pInstance)
 {
-    uCellPrivateNet_t *pTmp;
-
-    while (*ppScanResults != NULL) {
-        pTmp = (*ppScanResults)->pNext;
-        free(*ppScanResults);
-        *ppScanResults = pTmp;
-    }
-
-    *ppScanResults = NULL;
+    // The entries all live in the arena
+    pInstance->pScanResults = NULL;
+    uPortHeapArenaRelease(&(pInstance->scanArena));
 }
 
 // Get the module characteristics for a given instance.
@@ -828,6 +1060,96 @@ void uCellPrivateSleepRemoveContext(uCellPrivateInstance_t *pInstance)
     }
 }
 
+// Leave multiplexer mode and remove the context.
+void uCellPrivateMuxRemoveContext(uCellPrivateInstance_t *pInstance)
+{
+    uCellPrivateMuxContext_t *pContext;
+
+    if (pInstance != NULL) {
+        pContext = pInstance->pMuxContext;
+        if (pContext != NULL) {
+            uAtClientLock(pInstance->atHandle);
+            // Detach the AT client from its CMUX channel before
+            // closing it, then tell the module to leave
+            // multiplexer mode and put the AT client back
+            uAtClientStreamSwitch(pInstance->atHandle, -1,
+                                  U_AT_CLIENT_STREAM_TYPE_UART);
+            uCmuxClose(pContext->cmuxHandle);
+            uAtClientStreamSwitch(pInstance->atHandle, pContext->uartHandle,
+                                  U_AT_CLIENT_STREAM_TYPE_UART);
+            uAtClientUnlock(pInstance->atHandle);
+        }
+        // Free the context
+        free(pContext);
+        pInstance->pMuxContext = NULL;
+    }
+}
+
+// Stop the radio parameter sampler and remove the context.
+void uCellPrivateInfoSamplerRemoveContext(uCellPrivateInstance_t *pInstance)
+{
+    uCellPrivateInfoSampler_t *pContext;
+
+    if (pInstance != NULL) {
+        pContext = pInstance->pInfoSampler;
+        if (pContext != NULL) {
+            // Stop the timer first so that no more events are sent;
+            // the sampler task will not wait for long on the
+            // instance, which we may have locked, so closing
+            // its event queue will not deadlock
+            if (pContext->timerHandle != NULL) {
+                uPortTimerDelete(pContext->timerHandle);
+            }
+            if (pContext->eventQueueHandle >= 0) {
+                uPortEventQueueClose(pContext->eventQueueHandle);
+            }
+            free(pContext->pRing);
+        }
+        // Free the context
+        free(pContext);
+        pInstance->pInfoSampler = NULL;
+    }
+}
+
+// Remove the transmit scheduler context.
+void uCellPrivateTxScheduleRemoveContext(uCellPrivateInstance_t *pInstance)
+{
+    uCellPrivateTxSchedule_t *pContext;
+
+    if (pInstance != NULL) {
+        pContext = pInstance->pTxSchedule;
+        if (pContext != NULL) {
+            if (pContext->timerHandle != NULL) {
+                uPortTimerDelete(pContext->timerHandle);
+            }
+            free(pContext->pEntries);
+        }
+        // Free the context
+        free(pContext);
+        pInstance->pTxSchedule = NULL;
+    }
+}
+
+// Remove the cached time base context.
+void uCellPrivateTimeBaseRemoveContext(uCellPrivateInstance_t *pInstance)
+{
+    if ((pInstance != NULL) && (pInstance->pTimeBase != NULL)) {
+        uAtClientRemoveUrcHandler(pInstance->atHandle, "+CTZE:");
+        free(pInstance->pTimeBase);
+        pInstance->pTimeBase = NULL;
+    }
+}
+
+// Remove the HTTP context.
+void uCellPrivateHttpRemoveContext(uCellPrivateInstance_t *pInstance)
+{
+    if ((pInstance != NULL) && (pInstance->pHttpContext != NULL)) {
+        uAtClientRemoveUrcHandler(pInstance->atHandle, "+UUHTTPCR:");
+        free(pInstance->pHttpContext);
+        pInstance->pHttpContext = NULL;
+    }
+}
+
 // [Re]attach a PDP context to an internal module profile.
 int32_t uCellPrivateActivateProfile(const uCellPrivateInstance_t *pInstance,
                                     int32_t contextId, int32_t profileId, size_t tries,
@@ -1058,12 +1380,98 @@ int32_t uCellPrivateResumeUartPowerSaving(const uCellPrivateInstance_t *pInstanc
     return uAtClientUnlock(atHandle);
 }
 
+// Remove the file cache.
+void uCellPrivateFileCacheRemoveContext(uCellPrivateInstance_t *pInstance)
+{
+    if (pInstance != NULL) {
+        uCellPrivateFileCacheClear(pInstance);
+        free(pInstance->pFileCache);
+        pInstance->pFileCache = NULL;
+    }
+}
+
+// Empty the file cache.
+void uCellPrivateFileCacheClear(const uCellPrivateInstance_t *pInstance)
+{
+    if (pInstance->pFileCache != NULL) {
+        fileCacheEmpty(pInstance->pFileCache);
+    }
+}
+
+// Update the file cache after a write.
+void uCellPrivateFileCacheWritten(const uCellPrivateInstance_t *pInstance,
+                                  const char *pFileName, size_t size)
+{
+    uCellPrivateFileCache_t *pFileCache = pFileCacheGet(pInstance);
+    uCellPrivateFileCacheEntry_t **ppEntry;
+
+    if (pFileCache != NULL) {
+        ppEntry = ppFileCacheFind(pFileCache, pFileName);
+        if (*ppEntry != NULL) {
+            // AT+UDWNFILE appends
+            if ((*ppEntry)->size >= 0) {
+                (*ppEntry)->size += (int32_t) size;
+            }
+        } else {
+            *ppEntry = (uCellPrivateFileCacheEntry_t *) malloc(sizeof(**ppEntry));
+            if (*ppEntry != NULL) {
+                strncpy((*ppEntry)->fileName, pFileName, sizeof((*ppEntry)->fileName));
+                (*ppEntry)->size = (int32_t) size;
+                (*ppEntry)->pNext = NULL;
+            } else {
+                // Can't keep up, start again next time
+                uCellPrivateFileCacheClear(pInstance);
+            }
+        }
+    } else {
+        // Written in a different tagged area, which might overlap
+        // the cached one (e.g. "USER" and the default), so be safe
+        uCellPrivateFileCacheClear(pInstance);
+    }
+}
+
+// Get the cached size of a file.
+int32_t uCellPrivateFileCacheSizeGet(const uCellPrivateInstance_t *pInstance,
+                                     const char *pFileName)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+    uCellPrivateFileCache_t *pFileCache = pFileCacheGet(pInstance);
+    uCellPrivateFileCacheEntry_t *pEntry;
+
+    if (pFileCache != NULL) {
+        pEntry = *ppFileCacheFind(pFileCache, pFileName);
+        if ((pEntry != NULL) && (pEntry->size >= 0)) {
+            errorCodeOrSize = pEntry->size;
+        }
+    }
+
+    return errorCodeOrSize;
+}
+
+// Put the size of a file into the cache.
+void uCellPrivateFileCacheSizeSet(const uCellPrivateInstance_t *pInstance,
+                                  const char *pFileName, int32_t size)
+{
+    uCellPrivateFileCache_t *pFileCache = pFileCacheGet(pInstance);
+    uCellPrivateFileCacheEntry_t *pEntry;
+
+    if (pFileCache != NULL) {
+        pEntry = *ppFileCacheFind(pFileCache, pFileName);
+        if (pEntry != NULL) {
+            pEntry->size = size;
+        }
+    }
+}
+
 // Delete file on file system.
 int32_t uCellPrivateFileDelete(const uCellPrivateInstance_t *pInstance,
                                const char *pFileName)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     uAtClientHandle_t atHandle;
+    uCellPrivateFileCache_t *pFileCache;
+    uCellPrivateFileCacheEntry_t **ppEntry;
+    uCellPrivateFileCacheEntry_t *pTmp;
 
     // Check parameters
     if ((pInstance != NULL) && (pFileName != NULL) &&
@@ -1084,6 +1492,19 @@ int32_t uCellPrivateFileDelete(const uCellPrivateInstance_t *pInstance,
         uAtClientCommandStopReadResponse(atHandle);
         if (uAtClientUnlock(atHandle) == 0) {
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            pFileCache = pFileCacheGet(pInstance);
+            if (pFileCache != NULL) {
+                ppEntry = ppFileCacheFind(pFileCache, pFileName);
+                if (*ppEntry != NULL) {
+                    pTmp = (*ppEntry)->pNext;
+                    free(*ppEntry);
+                    *ppEntry = pTmp;
+                }
+            } else {
+                // Deleted from a different tagged area, which
+                // might overlap the cached one, so be safe
+                uCellPrivateFileCacheClear(pInstance);
+            }
         }
     }
 
@@ -1098,64 +1519,82 @@ int32_t uCellPrivateFileListFirst(const uCellPrivateInstance_t *pInstance,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     uAtClientHandle_t atHandle;
     uCellPrivateFileListContainer_t *pFileContainer;
+    uCellPrivateFileCache_t *pFileCache;
+    const uCellPrivateFileCacheEntry_t *pEntry;
     bool keepGoing = true;
     int32_t bytesRead = 0;
     size_t count = 0;
 
     // Check parameters
     if ((pInstance != NULL) && (ppFileListContainer != NULL) && (pFileName != NULL)) {
-        errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
-        atHandle = pInstance->atHandle;
-        // Do the ULSTFILE thang with the AT interface
-        uAtClientLock(atHandle);
-        uAtClientCommandStart(atHandle, "AT+ULSTFILE=");
-        // List files operation
-        uAtClientWriteInt(atHandle, 0);
-        if (pInstance->pFileSystemTag != NULL) {
-            // Write tag
-            uAtClientWriteString(atHandle, pInstance->pFileSystemTag, true);
-        }
-        uAtClientCommandStop(atHandle);
-        uAtClientResponseStart(atHandle, "+ULSTFILE:");
-        while (keepGoing) {
-            keepGoing = false;
-            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-            pFileContainer = (uCellPrivateFileListContainer_t *) malloc(sizeof(*pFileContainer));
-            if (pFileContainer != NULL) {
-                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-                // Read file name
-                bytesRead = uAtClientReadString(atHandle, pFileContainer->fileName,
-                                                sizeof(pFileContainer->fileName), false);
-            }
-            if (bytesRead > 0) {
-                bytesRead = 0;
-                keepGoing = true;
-                // Add the container to the end of the list
-                count = filelListAddCount(ppFileListContainer, pFileContainer);
-            } else {
-                // Nothing there, free it
-                free(pFileContainer);
+        pFileCache = pFileCacheGet(pInstance);
+        if (pFileCache != NULL) {
+            // Make the list from the cache, no need to bother the module
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            for (pEntry = pFileCache->pList;
+                 (pEntry != NULL) && (errorCode == 0);
+                 pEntry = pEntry->pNext) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pFileContainer = (uCellPrivateFileListContainer_t *) malloc(sizeof(*pFileContainer));
+                if (pFileContainer != NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    strncpy(pFileContainer->fileName, pEntry->fileName,
+                            sizeof(pFileContainer->fileName));
+                    count = filelListAddCount(ppFileListContainer, pFileContainer);
+                }
             }
-        }
-        uAtClientResponseStop(atHandle);
-
-        // Do the following parts inside the AT lock,
-        // providing protection for the linked-list.
-        if (errorCode == (int32_t) U_ERROR_COMMON_NO_MEMORY) {
-            // If we ran out of memory, clear the whole list,
-            // don't want to report partial information
-            fileListClear(&pFileContainer);
+            errorCode = fileListFirstFinish(ppFileListContainer, errorCode,
+                                            count, pFileName);
         } else {
-            if (count > 0) {
-                // Set the return value, copy out the first item in the list
-                // and remove it.
-                errorCode = (int32_t) count;
-                fileListGetRemove(ppFileListContainer, pFileName);
-            } else {
-                errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            atHandle = pInstance->atHandle;
+            // Do the ULSTFILE thang with the AT interface
+            uAtClientLock(atHandle);
+            uAtClientCommandStart(atHandle, "AT+ULSTFILE=");
+            // List files operation
+            uAtClientWriteInt(atHandle, 0);
+            if (pInstance->pFileSystemTag != NULL) {
+                // Write tag
+                uAtClientWriteString(atHandle, pInstance->pFileSystemTag, true);
+            }
+            uAtClientCommandStop(atHandle);
+            uAtClientResponseStart(atHandle, "+ULSTFILE:");
+            while (keepGoing) {
+                keepGoing = false;
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pFileContainer = (uCellPrivateFileListContainer_t *) malloc(sizeof(*pFileContainer));
+                if (pFileContainer != NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    // Read file name
+                    bytesRead = uAtClientReadString(atHandle, pFileContainer->fileName,
+                                                    sizeof(pFileContainer->fileName), false);
+                }
+                if (bytesRead > 0) {
+                    bytesRead = 0;
+                    keepGoing = true;
+                    // Add the container to the end of the list
+                    count = filelListAddCount(ppFileListContainer, pFileContainer);
+                } else {
+                    // Nothing there, free it
+                    free(pFileContainer);
+                }
+            }
+            uAtClientResponseStop(atHandle);
+
+            // Do the following parts inside the AT lock,
+            // providing protection for the linked-list.
+            if ((pInstance->pFileCache != NULL) &&
+                (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) &&
+                (uAtClientErrorGet(atHandle) == 0)) {
+                // Got a complete listing, remember it
+                fileCacheEmpty(pInstance->pFileCache);
+                fileCacheFill(pInstance->pFileCache, pInstance->pFileSystemTag,
+                              *ppFileListContainer);
             }
+            errorCode = fileListFirstFinish(ppFileListContainer, errorCode,
+                                            count, pFileName);
+            uAtClientUnlock(atHandle);
         }
-        uAtClientUnlock(atHandle);
     }
 
     return errorCode;
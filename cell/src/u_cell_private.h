@@ -22,6 +22,8 @@
  * of another module should be included here; otherwise
  * please keep #includes to your .c files. */
 
+#include "u_port_heap.h"
+
 /** @file
  * @brief This header file defines types, functions and inclusions that
  * are common and private to the cellular API.
@@ -139,6 +141,15 @@ extern "C" {
 # define U_CELL_PRIVATE_UART_WAKE_UP_RETRY_INTERVAL_MS 333
 #endif
 
+#ifndef U_CELL_PRIVATE_IDENTITY_STR_MAX_LENGTH_BYTES
+/** The longest identity string (model, firmware version, ICCID),
+ * not including the null terminator, that will be cached, see
+ * uCellPrivateIdentityCache_t; a longer string is simply read
+ * from the module every time.
+ */
+# define U_CELL_PRIVATE_IDENTITY_STR_MAX_LENGTH_BYTES 64
+#endif
+
 /** Bit mask to get to the bit in pinStates which indicates
  * the "on" state of the ENABLE_POWER pin.
  */
@@ -177,6 +188,22 @@ extern "C" {
  */
 #define U_CELL_PRIVATE_DTR_POWER_SAVING_PIN_ON_STATE(pinStates) (int32_t) (((pinStates) >> U_CELL_PRIVATE_DTR_POWER_SAVING_PIN_BIT_ON_STATE) & 1)
 
+/** Helper to lock the cellular instance with the given handle
+ * for the duration of an API call, making sure that lock/unlock
+ * pairs are always balanced: pInstance is set to the locked
+ * instance or to NULL if there is no such instance, in which
+ * case nothing is locked.  Must be paired with
+ * U_CELL_PRIVATE_INSTANCE_UNLOCK() in the same block.
+ */
+#define U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance)                           \
+    { uCellPrivateInstance_t *pCellLockedInstance = pUCellPrivateInstanceLock(cellHandle); \
+      pInstance = pCellLockedInstance
+
+/** Helper to unlock an instance locked with
+ * U_CELL_PRIVATE_INSTANCE_LOCK().
+ */
+#define U_CELL_PRIVATE_INSTANCE_UNLOCK() uCellPrivateInstanceUnlock(pCellLockedInstance); }
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -220,7 +247,9 @@ typedef enum {
     U_CELL_PRIVATE_FEATURE_MQTTSN,
     U_CELL_PRIVATE_FEATURE_CTS_CONTROL,
     U_CELL_PRIVATE_FEATURE_SOCK_SET_LOCAL_PORT,
-    U_CELL_PRIVATE_FEATURE_FOTA
+    U_CELL_PRIVATE_FEATURE_FOTA,
+    U_CELL_PRIVATE_FEATURE_ASYNC_SOCK_CONNECT,
+    U_CELL_PRIVATE_FEATURE_SECURITY_TLS_SESSION_RESUMPTION
 } uCellPrivateFeature_t;
 
 /** The characteristics that may differ between cellular modules.
@@ -347,6 +376,92 @@ typedef struct {
     int32_t sleepTime;
 } uCellPrivateUartSleepCache_t;
 
+/** Structure in which the output levels of the GPIOs that can be
+ * addressed by a mask, see u_cell_gpio.c, are cached; bit x - 1
+ * of each mask represents "GPIOx".
+ */
+typedef struct {
+    uint32_t knownMask; /**< The GPIOs whose output level is known. */
+    uint32_t levelMask; /**< The output levels, valid where knownMask is set. */
+} uCellPrivateGpioCache_t;
+
+/** Structure in which the identity of the module, which cannot
+ * change while it is powered, is cached; a string entry is
+ * valid if it is not empty.
+ */
+typedef struct {
+    char imei[15]; /**< Not null-terminated, valid if imeiValid is true. */
+    bool imeiValid;
+    char modelStr[U_CELL_PRIVATE_IDENTITY_STR_MAX_LENGTH_BYTES + 1];
+    char firmwareVersionStr[U_CELL_PRIVATE_IDENTITY_STR_MAX_LENGTH_BYTES + 1];
+    char iccidStr[U_CELL_PRIVATE_IDENTITY_STR_MAX_LENGTH_BYTES + 1];
+} uCellPrivateIdentityCache_t;
+
+/** Context for multiplexer mode, see u_cell_mux.c.
+ */
+typedef struct {
+    int32_t uartHandle; /**< The UART that the AT client was using
+                             before multiplexer mode was enabled. */
+    int32_t cmuxHandle; /**< The handle of the CMUX instance. */
+} uCellPrivateMuxContext_t;
+
+/** A timestamped set of radio parameters, see u_cell_info.c.
+ */
+typedef struct {
+    int32_t timeMs; /**< The value of uPortGetTickTimeMs() when the
+                         radio parameters were refreshed. */
+    uCellPrivateRadioParameters_t radioParameters;
+} uCellPrivateRadioSample_t;
+
+/** Context for the radio parameter sampler, see u_cell_info.c.
+ */
+typedef struct {
+    uDeviceHandle_t cellHandle;         /**< Passed to the sampler task. */
+    uPortTimerHandle_t timerHandle;     /**< The sampling timer. */
+    int32_t eventQueueHandle;           /**< The sampler task. */
+    int32_t periodMs;                   /**< The sampling period. */
+    uCellPrivateRadioSample_t *pRing;   /**< Storage for numMax samples. */
+    size_t numMax;                      /**< The number of samples at pRing. */
+    size_t numStored;                   /**< The number of samples stored. */
+    size_t next;                        /**< Where the next sample goes in pRing. */
+} uCellPrivateInfoSampler_t;
+
+/** Context for the cached time base, see u_cell_info.c.
+ */
+typedef struct {
+    int32_t resyncPeriodMs;   /**< How often to resync with AT+CCLK. */
+    bool synced;              /**< True once syncUtcMs is good. */
+    bool resyncRequired;      /**< Set when the network has sent new time. */
+    int64_t syncUtcMs;        /**< The UTC time, in milliseconds, at... */
+    int32_t syncTickMs;       /**< ...this value of uPortGetTickTimeMs(). */
+    int32_t ctzrAtStart;      /**< The AT+CTZR setting to restore, -1 for none. */
+    int32_t numSyncs;         /**< Statistics: number of syncs. */
+    int32_t numUrcSyncs;      /**< Statistics: of which from +CTZE. */
+    int32_t lastErrorMs;      /**< Statistics: error found at the last resync. */
+    int32_t maxAbsErrorMs;    /**< Statistics: worst error found at a resync. */
+    int32_t lastDriftPpm;     /**< Statistics: drift found at the last resync. */
+} uCellPrivateTimeBase_t;
+
+/** A send held by the transmit scheduler, see u_cell_pwr.c.
+ */
+typedef struct {
+    int32_t priority;                      /**< The uCellPwrTxPriority_t. */
+    void (*pSend) (uDeviceHandle_t, void *);
+    void *pSendParam;
+} uCellPrivateTxScheduleEntry_t;
+
+/** Context for the transmit scheduler, see u_cell_pwr.c.
+ */
+typedef struct {
+    uDeviceHandle_t cellHandle;              /**< Passed to the flush. */
+    uAtClientHandle_t atHandle;              /**< Used by the timer to queue the flush. */
+    uPortTimerHandle_t timerHandle;          /**< Fires when the first held send is due. */
+    int32_t deadlineMs;                      /**< When the first held send is due. */
+    uCellPrivateTxScheduleEntry_t *pEntries; /**< Storage for numMax held sends. */
+    size_t numMax;                           /**< The number of entries at pEntries. */
+    size_t numEntries;                       /**< The number of sends being held. */
+} uCellPrivateTxSchedule_t;
+
 /** Track the state of the profile that is mapped to the
  * active PDP context; required to make sure we reactivate
  * it when we return from a coverage gap. */
@@ -369,6 +484,26 @@ typedef struct uCellPrivateFileListContainer_t {
     struct uCellPrivateFileListContainer_t *pNext;
 } uCellPrivateFileListContainer_t;
 
+/** Structure describing a file in the file cache, see
+ * uCellFileCacheSet().
+ */
+typedef struct uCellPrivateFileCacheEntry_t {
+    /** The name of the file. */
+    char fileName[U_CELL_FILE_NAME_MAX_LENGTH + 1];
+    int32_t size; /**< The size of the file, negative if not yet known. */
+    struct uCellPrivateFileCacheEntry_t *pNext;
+} uCellPrivateFileCacheEntry_t;
+
+/** The file cache of a cellular instance: the files in one tagged
+ * area of the file system, as captured by a listing and kept up
+ * to date by writes and deletes.
+ */
+typedef struct {
+    bool valid; /**< True once a listing has populated pList. */
+    const char *pTag; /**< The file system tag that pList applies to. */
+    uCellPrivateFileCacheEntry_t *pList;
+} uCellPrivateFileCache_t;
+
 /** Definition of a cellular instance.
  */
 typedef struct uCellPrivateInstance_t {
@@ -398,8 +533,21 @@ typedef struct uCellPrivateInstance_t {
     uCellNetStatus_t
     networkStatus[U_CELL_NET_REG_DOMAIN_MAX_NUM]; /**< Registation status in each domain. */
     uCellNetRat_t rat[U_CELL_NET_REG_DOMAIN_MAX_NUM];  /**< The active RAT for each domain. */
+    int32_t cellId[U_CELL_NET_REG_DOMAIN_MAX_NUM]; /**< The cell ID, as delivered by
+                                                        +CxREG, -1 if not known. */
+    int32_t areaCode[U_CELL_NET_REG_DOMAIN_MAX_NUM]; /**< The LAC or TAC, as delivered by
+                                                          +CxREG, -1 if not known. */
+    int32_t networkStatusUpdatedMs[U_CELL_NET_REG_DOMAIN_MAX_NUM]; /**< When networkStatus
+                                                                        was last set, -1
+                                                                        if never. */
+    volatile uint32_t networkStatusSequence; /**< Incremented before and after
+                                                  networkStatus, rat, cellId,
+                                                  areaCode or networkStatusUpdatedMs
+                                                  are written, so that they may be
+                                                  read coherently without a lock. */
     uCellPrivateRadioParameters_t radioParameters; /**< The radio parameters. */
     int32_t startTimeMs;     /**< Used while connecting and scanning. */
+    int32_t warmStartTimeMs; /**< Non-zero while a warm start connection is in progress. */
     int32_t connectedAtMs;   /**< When a connection was last established,
                                   can be used for offsetting from that time;
                                   does NOT mean that we are currently connected. */
@@ -407,12 +555,18 @@ typedef struct uCellPrivateInstance_t {
                                   required, e.g. as a result of a configuration
                                   change. */
     int32_t mnoProfile;     /**< The active MNO profile, populated at boot. */
+    int32_t bootTimeMs;     /**< The last measured boot time, zero if never. */
+    int32_t bootTimeMaxMs;  /**< The longest measured time to boot after
+                                 power-on, zero if never. */
+    int32_t rebootTimeMaxMs; /**< The longest measured time to boot after
+                                  a reboot command, zero if never. */
     bool (*pKeepGoingCallback) (uDeviceHandle_t cellHandle);  /**< Used while connecting. */
     void (*pRegistrationStatusCallback) (uCellNetRegDomain_t, uCellNetStatus_t, void *);
     void *pRegistrationStatusCallbackParameter;
     void (*pConnectionStatusCallback) (bool, void *);
     void *pConnectionStatusCallbackParameter;
     uCellPrivateNet_t *pScanResults;    /**< Anchor for list of network scan results. */
+    uPortHeapArena_t scanArena;         /**< Where the entries of pScanResults live. */
     int32_t sockNextLocalPort;
     void *pSecurityC2cContext;  /**< Hook for a chip to chip security context. */
     volatile void *pMqttContext; /**< Hook for MQTT context, volatile as it
@@ -424,9 +578,29 @@ typedef struct uCellPrivateInstance_t {
     bool inWakeUpCallback; /**< So that we can avoid recursion. */
     uCellPrivateSleep_t *pSleepContext; /**< Context for sleep stuff. */
     uCellPrivateUartSleepCache_t uartSleepCache; /**< Used only by uCellPwrEnable/DisableUartSleep(). */
+    uCellPrivateGpioCache_t gpioCache; /**< Output levels of the GPIOs, cleared at
+                                            power off or reboot. */
+    uCellPrivateIdentityCache_t identityCache; /**< Identity of the module, cleared at
+                                                    power off or reboot. */
     uCellPrivateProfileState_t profileState; /**< To track whether a profile is meant to be active. */
     void *pFotaContext; /**< FOTA context, lodged here as a void * to
                              avoid spreading its types all over. */
+    uCellPrivateMuxContext_t *pMuxContext; /**< Multiplexer mode context,
+                                                NULL if not enabled. */
+    uCellPrivateFileCache_t *pFileCache; /**< The file cache, NULL if
+                                              not enabled. */
+    uCellPrivateInfoSampler_t *pInfoSampler; /**< The radio parameter sampler,
+                                                  NULL if not running. */
+    uCellPrivateTxSchedule_t *pTxSchedule; /**< The transmit scheduler, NULL
+                                                if never used. */
+    uCellPrivateTimeBase_t *pTimeBase; /**< The cached time base, NULL if
+                                            not started. */
+    void *pHttpContext; /**< HTTP context, lodged here as a void * to
+                             avoid spreading its types all over. */
+    uPortMutexHandle_t mutex; /**< Serialises API calls on this instance. */
+    int32_t lockUsers; /**< The number of callers holding or waiting
+                            for mutex, protected by gUCellPrivateMutex;
+                            the instance is not freed until this is zero. */
     struct uCellPrivateInstance_t *pNext;
 } uCellPrivateInstance_t;
 
@@ -447,7 +621,9 @@ extern const size_t gUCellPrivateModuleListSize;
  */
 extern uCellPrivateInstance_t *gpUCellPrivateInstanceList;
 
-/** Mutex to protect the linked list.
+/** Mutex to protect the linked list; API calls on an instance are
+ * serialised by the mutex of that instance instead, see
+ * pUCellPrivateInstanceLock().
  */
 extern uPortMutexHandle_t gUCellPrivateMutex;
 
@@ -473,6 +649,55 @@ bool uCellPrivateIsNumeric(const char *pBuffer, size_t bufferSize);
  */
 uCellPrivateInstance_t *pUCellPrivateGetInstance(uDeviceHandle_t cellHandle);
 
+/** Find a cellular instance and lock it.  gUCellPrivateMutex is
+ * held only while the instance is looked up, so that an API call
+ * on one instance does not hold up API calls on another; the
+ * instance cannot be removed while it is locked.  Where a "locked"
+ * instance is referred to in the notes of this API, this is the
+ * lock that is meant.  gUCellPrivateMutex must NOT be locked when
+ * this is called; if both are required, lock the instance first.
+ * Use U_CELL_PRIVATE_INSTANCE_LOCK()/U_CELL_PRIVATE_INSTANCE_UNLOCK()
+ * rather than calling this directly where possible.
+ *
+ * @param cellHandle  the instance handle.
+ * @return            a pointer to the locked instance, NULL if
+ *                    there is no such instance or the cellular
+ *                    API is not initialised.
+ */
+uCellPrivateInstance_t *pUCellPrivateInstanceLock(uDeviceHandle_t cellHandle);
+
+/** As pUCellPrivateInstanceLock() but only wait for a limited time
+ * for the instance to become free; for use by tasks that the
+ * instance itself may be waiting for.
+ *
+ * @param cellHandle  the instance handle.
+ * @param delayMs     the maximum time to wait in milliseconds.
+ * @return            a pointer to the locked instance, NULL if
+ *                    there is no such instance, the cellular
+ *                    API is not initialised or the instance
+ *                    could not be locked in time.
+ */
+uCellPrivateInstance_t *pUCellPrivateInstanceTryLock(uDeviceHandle_t cellHandle,
+                                                     int32_t delayMs);
+
+/** Unlock an instance locked with pUCellPrivateInstanceLock() or
+ * pUCellPrivateInstanceTryLock().
+ *
+ * @param pInstance   a pointer to the instance, may be NULL in
+ *                    which case this does nothing.
+ */
+void uCellPrivateInstanceUnlock(uCellPrivateInstance_t *pInstance);
+
+/** Wait until no-one is holding or waiting for the lock of an
+ * instance; called when the instance has been taken out of the
+ * linked list, and hence can acquire no new users, before it is
+ * free'd.  gUCellPrivateMutex must NOT be locked when this is
+ * called.
+ *
+ * @param pInstance   a pointer to the instance.
+ */
+void uCellPrivateInstanceWaitUnused(uCellPrivateInstance_t *pInstance);
+
 /** Set the radio parameters back to defaults.
  *
  * @param pParameters pointer to a radio parameters structure.
@@ -513,7 +738,7 @@ void uCellPrivateCFunMode(uCellPrivateInstance_t *pInstance,
                           int32_t mode);
 
 /** Get the IMSI of the SIM.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance  a pointer to the cellular instance.
  * @param pImsi      a pointer to 15 bytes in which the IMSI
@@ -523,19 +748,33 @@ void uCellPrivateCFunMode(uCellPrivateInstance_t *pInstance,
 int32_t uCellPrivateGetImsi(const uCellPrivateInstance_t *pInstance,
                             char *pImsi);
 
-/** Get the IMEI of the module.
- * Note: gUCellPrivateMutex should be locked before this is called.
+/** Get the IMEI of the module; this is cached, see
+ * uCellPrivateIdentityCacheClear().
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance  a pointer to the cellular instance.
  * @param pImei      a pointer to 15 bytes in which the IMEI
  *                   will be stored.
  * @return           zero on success else negative error code.
  */
-int32_t uCellPrivateGetImei(const uCellPrivateInstance_t *pInstance,
+int32_t uCellPrivateGetImei(uCellPrivateInstance_t *pInstance,
                             char *pImei);
 
+/** Forget the cached identity of the module; to be called whenever
+ * the module is powered off or rebooted, since its firmware or
+ * SIM may be changed in between.
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance  a pointer to the cellular instance.
+ * @param simOnly    if true only the identity of the SIM (the
+ *                   ICCID) is forgotten, e.g. because the SIM
+ *                   has been deactivated with AT+CFUN=0.
+ */
+void uCellPrivateIdentityCacheClear(uCellPrivateInstance_t *pInstance,
+                                    bool simOnly);
+
 /** Get whether the given instance is registered with the network.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance  a pointer to the cellular instance.
  * @return           true if it is registered, else false.
@@ -553,7 +792,7 @@ uCellNetRat_t uCellPrivateModuleRatToCellRat(uCellModuleType_t moduleType,
                                              int32_t moduleRat);
 
 /** Get the active RAT.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance  a pointer to the cellular instance.
  * @return           the active RAT.
@@ -581,9 +820,9 @@ int32_t uCellPrivateGetOperatorStr(const uCellPrivateInstance_t *pInstance,
 
 /** Free network scan results.
  *
- * @param ppScanResults a pointer to the pointer to the scan results
+ * @param[in] pInstance  a pointer to the cellular instance.
  */
-void uCellPrivateScanFree(uCellPrivateNet_t **ppScanResults);
+void uCellPrivateScanFree(uCellPrivateInstance_t *pInstance);
 
 /** Get the module characteristics for a given instance.
  *
@@ -596,26 +835,72 @@ void uCellPrivateScanFree(uCellPrivateNet_t **ppScanResults);
 const uCellPrivateModule_t *pUCellPrivateGetModule(uDeviceHandle_t cellHandle);
 
 /** Remove the chip to chip security context for the given instance.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance   a pointer to the cellular instance.
  */
 void uCellPrivateC2cRemoveContext(uCellPrivateInstance_t *pInstance);
 
 /** Remove the location context for the given instance.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance   a pointer to the cellular instance.
  */
 void uCellPrivateLocRemoveContext(uCellPrivateInstance_t *pInstance);
 
 /** Remove the sleep context for the given instance.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance   a pointer to the cellular instance.
  */
 void uCellPrivateSleepRemoveContext(uCellPrivateInstance_t *pInstance);
 
+/** Leave multiplexer mode, returning the AT client to the UART,
+ * and remove the multiplexer context for the given instance.
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ */
+void uCellPrivateMuxRemoveContext(uCellPrivateInstance_t *pInstance);
+
+/** Remove the file cache for the given instance.
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ */
+void uCellPrivateFileCacheRemoveContext(uCellPrivateInstance_t *pInstance);
+
+/** Stop the radio parameter sampler and remove its context for
+ * the given instance.
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ */
+void uCellPrivateInfoSamplerRemoveContext(uCellPrivateInstance_t *pInstance);
+
+/** Remove the transmit scheduler context, discarding any held sends.
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ */
+void uCellPrivateTxScheduleRemoveContext(uCellPrivateInstance_t *pInstance);
+
+/** Remove the cached time base context, and its URC handler; this
+ * does not restore the AT+CTZR setting of the module.
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ */
+void uCellPrivateTimeBaseRemoveContext(uCellPrivateInstance_t *pInstance);
+
+/** Remove the HTTP context for the given instance, and its URC
+ * handler; this does not reset the HTTP profiles of the module.
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ */
+void uCellPrivateHttpRemoveContext(uCellPrivateInstance_t *pInstance);
+
 /** [Re]attach a PDP context to an internal module profile.  This
  * is required by some module types (e.g. SARA-R4 and SARA-R5 modules)
  * when a PDP context is either first established or has been lost, e.g.
@@ -664,7 +949,7 @@ int32_t uCellPrivateWakeUpCallback(uAtClientHandle_t atHandle,
  * RATs.  Something like that anyway.  This should be called after
  * power-on and after a RAT change; it doesn't talk to the module,
  * simply works on the current state of the module as known to this code.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance a pointer to the cellular instance.
  */
@@ -704,10 +989,57 @@ int32_t uCellPrivateSuspendUartPowerSaving(const uCellPrivateInstance_t *pInstan
 int32_t uCellPrivateResumeUartPowerSaving(const uCellPrivateInstance_t *pInstance,
                                           int32_t mode, int32_t timeout);
 
+/** Empty the file cache of the given instance, if there is one, so
+ * that the next listing is obtained from the module.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance  a pointer to the cellular instance.
+ */
+void uCellPrivateFileCacheClear(const uCellPrivateInstance_t *pInstance);
+
+/** Update the file cache of the given instance, if there is one,
+ * after data has been successfully appended to a file with
+ * AT+UDWNFILE.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance  a pointer to the cellular instance.
+ * @param pFileName  the name of the file that was written.
+ * @param size       the number of bytes that were written.
+ */
+void uCellPrivateFileCacheWritten(const uCellPrivateInstance_t *pInstance,
+                                  const char *pFileName, size_t size);
+
+/** Get the size of a file from the file cache of the given instance.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance  a pointer to the cellular instance.
+ * @param pFileName  the name of the file.
+ * @return           the size of the file or negative error code if
+ *                   the size is not in the cache.
+ */
+int32_t uCellPrivateFileCacheSizeGet(const uCellPrivateInstance_t *pInstance,
+                                     const char *pFileName);
+
+/** Put the size of a file, as read from the module, into the file
+ * cache of the given instance; does nothing if the file is not in
+ * the cache.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param pInstance  a pointer to the cellular instance.
+ * @param pFileName  the name of the file.
+ * @param size       the size of the file.
+ */
+void uCellPrivateFileCacheSizeSet(const uCellPrivateInstance_t *pInstance,
+                                  const char *pFileName, int32_t size);
+
 /** Delete a file from the file system. If the file does not exist an
  * error will be returned.
  *
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance      a pointer to the cellular instance.
  * @param[in] pFileName  a pointer to the file name to delete from the
@@ -720,9 +1052,12 @@ int32_t uCellPrivateFileDelete(const uCellPrivateInstance_t *pInstance,
 
 /** Get the description of file stored on the file system;
  * uCellPrivateFileListNext() should be called repeatedly to iterate
- * through subsequent entries in the list.
+ * through subsequent entries in the list.  If the instance has a file
+ * cache that has been populated for the current tag the list is made
+ * from the cache, without any AT traffic, else the list is read from
+ * the module and, if there is a file cache, the cache is populated.
  *
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance           a pointer to the cellular instance.
  * @param ppFileListContainer a pointer to a place to store the pointer
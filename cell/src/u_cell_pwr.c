@@ -34,7 +34,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // strlen()
+#include "string.h"    // strlen(), memset()
 
 #include "u_cfg_sw.h"
 
@@ -807,6 +807,129 @@ static int32_t setEDrxUrc(const uCellPrivateInstance_t *pInstance)
     return errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: TRANSMIT SCHEDULER
+ * -------------------------------------------------------------- */
+
+// Make all of the held sends, in priority order, returning the number
+// made; this must be called WITHOUT the instance locked since
+// the sends will call back into the cellular API.
+static int32_t txScheduleFlush(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellPrivateTxSchedule_t *pContext;
+    uCellPrivateTxScheduleEntry_t entries[U_CELL_PWR_TX_SCHEDULE_MAX_NUM];
+    size_t numEntries = 0;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCodeOrCount = 0;
+            pContext = pInstance->pTxSchedule;
+            if ((pContext != NULL) && (pContext->numEntries > 0)) {
+                uPortTimerStop(pContext->timerHandle);
+                // Take the held sends out, highest priority first and,
+                // within a priority, in the order they were scheduled
+                for (int32_t p = 0; p < (int32_t) U_CELL_PWR_TX_PRIORITY_MAX_NUM; p++) {
+                    for (size_t x = 0; x < pContext->numEntries; x++) {
+                        if ((pContext->pEntries + x)->priority == p) {
+                            entries[numEntries] = *(pContext->pEntries + x);
+                            numEntries++;
+                        }
+                    }
+                }
+                pContext->numEntries = 0;
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    if (numEntries > 0) {
+        uPortLog("U_CELL_PWR: transmit scheduler making %d held send(s).\n",
+                 numEntries);
+        for (size_t x = 0; x < numEntries; x++) {
+            entries[x].pSend(cellHandle, entries[x].pSendParam);
+        }
+        errorCodeOrCount = (int32_t) numEntries;
+    }
+
+    return errorCodeOrCount;
+}
+
+// Callback, run through the uAtClientCallback() mechanism, that makes
+// the held sends.
+static void txScheduleFlushCallback(uAtClientHandle_t atHandle, void *pParameter)
+{
+    (void) atHandle;
+
+    txScheduleFlush((uDeviceHandle_t) pParameter);
+}
+
+// Timer callback for the maximum hold time of the transmit scheduler.
+static void txScheduleTimerCallback(const uPortTimerHandle_t timerHandle,
+                                    void *pParameter)
+{
+    uCellPrivateTxSchedule_t *pContext = (uCellPrivateTxSchedule_t *) pParameter;
+
+    (void) timerHandle;
+
+    // The sends will do AT things, so don't do them in the
+    // timer task, queue them instead
+    uAtClientCallback(pContext->atHandle, txScheduleFlushCallback,
+                      pContext->cellHandle);
+}
+
+// Note the module is awake and, if anything is being held by the
+// transmit scheduler, queue a flush.
+static void txScheduleWakeUp(const uCellPrivateInstance_t *pInstance)
+{
+    uCellPrivateTxSchedule_t *pContext = pInstance->pTxSchedule;
+
+    if ((pContext != NULL) && (pContext->numEntries > 0)) {
+        uAtClientCallback(pInstance->atHandle, txScheduleFlushCallback,
+                          pInstance->cellHandle);
+    }
+}
+
+// Get the transmit scheduler context, creating it if required.
+// Note: the instance should be locked before this is called.
+static uCellPrivateTxSchedule_t *pTxScheduleGet(uCellPrivateInstance_t *pInstance)
+{
+    uCellPrivateTxSchedule_t *pContext = pInstance->pTxSchedule;
+
+    if (pContext == NULL) {
+        pContext = (uCellPrivateTxSchedule_t *) malloc(sizeof(*pContext));
+        if (pContext != NULL) {
+            memset(pContext, 0, sizeof(*pContext));
+            pContext->cellHandle = pInstance->cellHandle;
+            pContext->atHandle = pInstance->atHandle;
+            pContext->numMax = U_CELL_PWR_TX_SCHEDULE_MAX_NUM;
+            pContext->pEntries = (uCellPrivateTxScheduleEntry_t *) malloc(sizeof(*(pContext->pEntries)) *
+                                                                          pContext->numMax);
+            if ((pContext->pEntries == NULL) ||
+                (uPortTimerCreate(&(pContext->timerHandle),
+                                  "cellTxSchedule",
+                                  txScheduleTimerCallback,
+                                  pContext,
+                                  U_CELL_PWR_TX_SCHEDULE_NORMAL_MAX_HOLD_SECONDS * 1000,
+                                  false) != 0)) {
+                free(pContext->pEntries);
+                free(pContext);
+                pContext = NULL;
+            } else {
+                pInstance->pTxSchedule = pContext;
+            }
+        }
+    }
+
+    return pContext;
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: DEEP SLEEP
  * -------------------------------------------------------------- */
@@ -843,6 +966,10 @@ static void UUPSMR_urc(uAtClientHandle_t atHandle, void *pParameter)
     // 2 means sleep is blocked.
     if (x == 1) {
         pInstance->deepSleepState = U_CELL_PRIVATE_DEEP_SLEEP_STATE_PROTOCOL_STACK_ASLEEP;
+    } else if (x == 0) {
+        // Awake, for whatever reason, so a good time for
+        // the transmit scheduler to send anything it is holding
+        txScheduleWakeUp(pInstance);
     }
 }
 
@@ -895,6 +1022,113 @@ static int32_t moduleIsAlive(uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+#ifndef U_CELL_PWR_READY_DETECT_DISABLE
+// Poke the module once with "AT", not waiting long for an answer,
+// returning true if it is there.
+static bool moduleProbe(uCellPrivateInstance_t *pInstance)
+{
+    uAtClientDeviceError_t deviceError;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    bool isAlive;
+
+    uAtClientLock(atHandle);
+    uAtClientTimeoutSet(atHandle, U_CELL_PWR_READY_PROBE_TIMEOUT_MS);
+    uAtClientCommandStart(atHandle, "AT");
+    uAtClientCommandStopReadResponse(atHandle);
+    uAtClientDeviceErrorGet(atHandle, &deviceError);
+    isAlive = (uAtClientUnlock(atHandle) == 0) ||
+              (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR);
+
+    return isAlive;
+}
+
+// Wait for a module that was told to reboot to stop responding,
+// which it may take a moment to do, giving up at timeoutMs.
+static void waitForGone(uCellPrivateInstance_t *pInstance,
+                        int32_t timeoutMs,
+                        bool (*pKeepGoingCallback) (uDeviceHandle_t))
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    int32_t pollMs = U_CELL_PWR_READY_POLL_START_MS;
+
+    while ((uPortGetTickTimeMs() - startTimeMs < timeoutMs) &&
+           ((pKeepGoingCallback == NULL) || pKeepGoingCallback(pInstance->cellHandle)) &&
+           moduleProbe(pInstance)) {
+        uPortTaskBlock(pollMs);
+        pollMs *= 2;
+        if (pollMs > U_CELL_PWR_READY_POLL_MAX_MS) {
+            pollMs = U_CELL_PWR_READY_POLL_MAX_MS;
+        }
+    }
+}
+#endif
+
+// Wait for the module to be ready after it has been powered-on or
+// rebooted, the boot having started at startTimeMs.  fixedWaitMs and
+// attempts are the worst case for the module: wait fixedWaitMs and
+// then try "AT" attempts times.  Unless U_CELL_PWR_READY_DETECT_DISABLE
+// is defined the module is instead probed from the start, at increasing
+// intervals, and we return the moment it answers, giving up at the
+// worst case or, if useMeasured is true and boot times have been
+// measured, at twice the longest of *pTimeMaxMs; the boot time is
+// measured and recorded in the instance and *pTimeMaxMs.
+static int32_t waitForReady(uCellPrivateInstance_t *pInstance,
+                            int32_t startTimeMs, int32_t fixedWaitMs,
+                            int32_t attempts, int32_t *pTimeMaxMs,
+                            bool useMeasured,
+                            bool (*pKeepGoingCallback) (uDeviceHandle_t))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_RESPONDING;
+#ifdef U_CELL_PWR_READY_DETECT_DISABLE
+    (void) startTimeMs;
+    (void) pTimeMaxMs;
+    (void) useMeasured;
+
+    uPortTaskBlock(fixedWaitMs);
+    for (int32_t x = attempts; (x > 0) && (errorCode != 0) &&
+         ((pKeepGoingCallback == NULL) || pKeepGoingCallback(pInstance->cellHandle)); x--) {
+        errorCode = moduleIsAlive(pInstance, 1);
+    }
+#else
+    int32_t timeoutMs = fixedWaitMs + (attempts * pInstance->pModule->responseMaxWaitMs);
+    int32_t pollMs = U_CELL_PWR_READY_POLL_START_MS;
+    int32_t bootTimeMs;
+
+    if (useMeasured && (*pTimeMaxMs > 0) && (*pTimeMaxMs * 2 < timeoutMs)) {
+        timeoutMs = *pTimeMaxMs * 2;
+        if (timeoutMs < U_CELL_PWR_READY_TIMEOUT_MIN_MS) {
+            timeoutMs = U_CELL_PWR_READY_TIMEOUT_MIN_MS;
+        }
+    }
+    while ((errorCode != 0) &&
+           (uPortGetTickTimeMs() - startTimeMs < timeoutMs) &&
+           ((pKeepGoingCallback == NULL) || pKeepGoingCallback(pInstance->cellHandle))) {
+        // No point in probing before VInt says the module is on
+        if (((pInstance->pinVInt < 0) ||
+             (uPortGpioGet(pInstance->pinVInt) == U_CELL_PRIVATE_VINT_PIN_ON_STATE(pInstance->pinStates))) &&
+            moduleProbe(pInstance)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        } else {
+            uPortTaskBlock(pollMs);
+            pollMs *= 2;
+            if (pollMs > U_CELL_PWR_READY_POLL_MAX_MS) {
+                pollMs = U_CELL_PWR_READY_POLL_MAX_MS;
+            }
+        }
+    }
+    if (errorCode == 0) {
+        bootTimeMs = uPortGetTickTimeMs() - startTimeMs;
+        uPortLog("U_CELL_PWR: module ready after %d ms.\n", bootTimeMs);
+        pInstance->bootTimeMs = bootTimeMs;
+        if (bootTimeMs > *pTimeMaxMs) {
+            *pTimeMaxMs = bootTimeMs;
+        }
+    }
+#endif
+
+    return errorCode;
+}
+
 // Configure one item in the cellular module.
 static bool moduleConfigureOne(uAtClientHandle_t atHandle,
                                const char *pAtString,
@@ -922,9 +1156,24 @@ static int32_t moduleConfigure(uCellPrivateInstance_t *pInstance,
     uCellPwrPsvMode_t uartPowerSavingMode = U_CELL_PWR_PSV_MODE_DISABLED; // Assume no UART power saving
     uAtClientStream_t atStreamType;
     char buffer[20]; // Enough room for AT+UPSV=2,1300
-
-    // First send all the commands that everyone gets
-    for (size_t x = 0;
+    uAtClientBatchCommand_t batch[sizeof(gpConfigCommand) / sizeof(gpConfigCommand[0])];
+    int32_t numCompleted;
+
+    // First send all the commands that everyone gets: do this as
+    // a concatenated batch to save round trips and then, from
+    // wherever the batch stopped (if it did), send the remainder
+    // one at a time with retries; the commands can safely be
+    // repeated if a batch fails part way through a line
+    memset(batch, 0, sizeof(batch));
+    for (size_t x = 0; x < sizeof(batch) / sizeof(batch[0]); x++) {
+        batch[x].pCommand = gpConfigCommand[x];
+    }
+    numCompleted = uAtClientBatch(atHandle, batch,
+                                  sizeof(batch) / sizeof(batch[0]), true);
+    if (numCompleted < 0) {
+        numCompleted = 0;
+    }
+    for (size_t x = (size_t) numCompleted;
          (x < sizeof(gpConfigCommand) / sizeof(gpConfigCommand[0])) &&
          success; x++) {
         success = moduleConfigureOne(atHandle, gpConfigCommand[x],
@@ -1121,6 +1370,7 @@ static void waitForPowerOff(uCellPrivateInstance_t *pInstance,
     uAtClientHandle_t atHandle = pInstance->atHandle;
     bool moduleIsOff = false;
     int32_t startTimeMs = uPortGetTickTimeMs();
+    int32_t pollMs = U_CELL_PWR_READY_POLL_START_MS;
 
     while (!moduleIsOff &&
            (uPortGetTickTimeMs() - startTimeMs < pInstance->pModule->powerDownWaitSeconds * 1000) &&
@@ -1140,8 +1390,14 @@ static void waitForPowerOff(uCellPrivateInstance_t *pInstance,
             uAtClientCommandStopReadResponse(atHandle);
             moduleIsOff = (uAtClientUnlock(atHandle) != 0);
         }
-        // Relax a bit
-        uPortTaskBlock(1000);
+        if (!moduleIsOff) {
+            // Relax a bit, for longer each time, up to a second
+            uPortTaskBlock(pollMs);
+            pollMs *= 2;
+            if (pollMs > 1000) {
+                pollMs = 1000;
+            }
+        }
     }
 
     // We have rebooted
@@ -1151,7 +1407,7 @@ static void waitForPowerOff(uCellPrivateInstance_t *pInstance,
 }
 
 // Power the cellular module off.
-// Note: gUCellPrivateMutex must be locked before this is called
+// Note: the instance must be locked before this is called
 static int32_t powerOff(uCellPrivateInstance_t *pInstance,
                         bool (*pKeepGoingCallback) (uDeviceHandle_t))
 {
@@ -1193,6 +1449,10 @@ static int32_t powerOff(uCellPrivateInstance_t *pInstance,
     // Remove any security context as these disappear
     // at power off
     uCellPrivateC2cRemoveContext(pInstance);
+    // GPIOs return to their default levels
+    pInstance->gpioCache.knownMask = 0;
+    // The module identity, e.g. firmware version or SIM, may change
+    uCellPrivateIdentityCacheClear(pInstance, false);
 
     return errorCode;
 }
@@ -1200,7 +1460,7 @@ static int32_t powerOff(uCellPrivateInstance_t *pInstance,
 // Do a quick power off, used for recovery situations only.
 // IMPORTANT: this won't work if a SIM PIN needs
 // to be entered at a power cycle
-// Note: gUCellPrivateMutex must be locked before this is called
+// Note: the instance must be locked before this is called
 static void quickPowerOff(uCellPrivateInstance_t *pInstance,
                           bool (*pKeepGoingCallback) (uDeviceHandle_t))
 {
@@ -1224,6 +1484,10 @@ static void quickPowerOff(uCellPrivateInstance_t *pInstance,
         // Remove any security context as these disappear
         // at power off
         uCellPrivateC2cRemoveContext(pInstance);
+        // GPIOs return to their default levels
+        pInstance->gpioCache.knownMask = 0;
+        // The module identity, e.g. firmware version or SIM, may change
+        uCellPrivateIdentityCacheClear(pInstance, false);
     }
 }
 
@@ -1325,14 +1589,13 @@ int32_t uCellPwrPrivateOn(uCellPrivateInstance_t *pInstance,
                     }
                 }
             }
-            // Cellular module should be up, see if it's there
-            // and, if so, configure it
-            for (size_t y = U_CELL_PWR_IS_ALIVE_ATTEMPTS_POWER_ON;
-                 (y > 0) && (errorCode != 0) &&
-                 ((pKeepGoingCallback == NULL) || pKeepGoingCallback(cellHandle));
-                 y--) {
-                errorCode = moduleIsAlive(pInstance, 1);
-            }
+            // Cellular module should be on its way up, wait for
+            // it to be there and, if so, configure it; only the first
+            // go is shortened by previously measured boot times
+            errorCode = waitForReady(pInstance, uPortGetTickTimeMs(), 0,
+                                     U_CELL_PWR_IS_ALIVE_ATTEMPTS_POWER_ON,
+                                     &(pInstance->bootTimeMaxMs), x == 2,
+                                     pKeepGoingCallback);
             if (errorCode == 0) {
                 // Configure the module, only putting into radio-off
                 // mode if we weren't already registered at the start
@@ -1381,6 +1644,12 @@ int32_t uCellPwrPrivateOn(uCellPrivateInstance_t *pInstance,
         }
     }
 
+    // Having woken up from deep sleep, send anything that the
+    // transmit scheduler is holding
+    if (asleepAtStart && (errorCode == 0)) {
+        txScheduleWakeUp(pInstance);
+    }
+
     return errorCode;
 }
 
@@ -1683,9 +1952,8 @@ bool uCellPwrIsPowered(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             isPowered = true;
             if (pInstance->pinEnablePower >= 0) {
@@ -1694,7 +1962,7 @@ bool uCellPwrIsPowered(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
 
     }
 
@@ -1709,14 +1977,13 @@ bool uCellPwrIsAlive(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             isAlive = (moduleIsAlive(pInstance, 1) == 0);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isAlive;
@@ -1731,9 +1998,8 @@ int32_t uCellPwrOn(uDeviceHandle_t cellHandle, const char *pSimPinCode,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_CELL_ERROR_PIN_ENTRY_NOT_SUPPORTED;
@@ -1745,7 +2011,7 @@ int32_t uCellPwrOn(uDeviceHandle_t cellHandle, const char *pSimPinCode,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1760,15 +2026,14 @@ int32_t uCellPwrOff(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = powerOff(pInstance, pKeepGoingCallback);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
 
     }
 
@@ -1785,9 +2050,8 @@ int32_t uCellPwrOffHard(uDeviceHandle_t cellHandle, bool trulyHard,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
@@ -1801,6 +2065,10 @@ int32_t uCellPwrOffHard(uDeviceHandle_t cellHandle, bool trulyHard,
                 // Remove any security context as these disappear
                 // at power off
                 uCellPrivateC2cRemoveContext(pInstance);
+                // GPIOs return to their default levels
+                pInstance->gpioCache.knownMask = 0;
+                // The module identity, e.g. firmware version or SIM, may change
+                uCellPrivateIdentityCacheClear(pInstance, false);
                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
             } else {
                 if (pInstance->pinPwrOn >= 0) {
@@ -1834,12 +2102,16 @@ int32_t uCellPwrOffHard(uDeviceHandle_t cellHandle, bool trulyHard,
                     // Remove any security context as these disappear
                     // at power off
                     uCellPrivateC2cRemoveContext(pInstance);
+                    // GPIOs return to their default levels
+                    pInstance->gpioCache.knownMask = 0;
+                    // The module identity, e.g. firmware version or SIM, may change
+                    uCellPrivateIdentityCacheClear(pInstance, false);
                     errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                 }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -1854,14 +2126,13 @@ bool uCellPwrRebootIsRequired(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             rebootIsRequired = pInstance->rebootIsRequired;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return rebootIsRequired;
@@ -1876,12 +2147,14 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
     uCellPrivateInstance_t *pInstance;
     uAtClientHandle_t atHandle;
     bool success = false;
+    int32_t startTimeMs;
+    int32_t fixedWaitMs;
+    int32_t *pTimeMaxMs;
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             atHandle = pInstance->atHandle;
@@ -1910,10 +2183,20 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
             if (errorCode == 0) {
                 // Remove any security context as these disappear at reboot
                 uCellPrivateC2cRemoveContext(pInstance);
+                // GPIOs return to their default levels
+                pInstance->gpioCache.knownMask = 0;
+                // The module identity, e.g. firmware version or SIM, may change
+                uCellPrivateIdentityCacheClear(pInstance, false);
                 // We have rebooted
                 pInstance->rebootIsRequired = false;
-                // Wait for the module to boot
-                uPortTaskBlock(pInstance->pModule->rebootCommandWaitSeconds * 1000);
+                startTimeMs = uPortGetTickTimeMs();
+                fixedWaitMs = pInstance->pModule->rebootCommandWaitSeconds * 1000;
+                pTimeMaxMs = &(pInstance->rebootTimeMaxMs);
+#ifndef U_CELL_PWR_READY_DETECT_DISABLE
+                // The module may carry on answering for a moment
+                // after the reboot command: wait for it to go
+                waitForGone(pInstance, fixedWaitMs, pKeepGoingCallback);
+#endif
                 // Two goes at this with a power-off inbetween,
                 // 'cos I've seen some modules
                 // fail during initial configuration.
@@ -1921,14 +2204,16 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
                 // to be entered at a power cycle
                 for (size_t x = 2; (x > 0) && (!success) &&
                      ((pKeepGoingCallback == NULL) || pKeepGoingCallback(cellHandle)); x--) {
-                    if (pInstance->pModule->moduleType == U_CELL_MODULE_TYPE_SARA_R5) {
+                    // Wait for the module to return to life and configure it
+                    errorCode = waitForReady(pInstance, startTimeMs, fixedWaitMs,
+                                             U_CELL_PWR_IS_ALIVE_ATTEMPTS_POWER_ON,
+                                             pTimeMaxMs, x == 2, pKeepGoingCallback);
+                    if ((errorCode == 0) &&
+                        (pInstance->pModule->moduleType == U_CELL_MODULE_TYPE_SARA_R5)) {
                         // SARA-R5 chucks out a load of stuff after
                         // boot in its development version: flush it away
                         uAtClientFlush(atHandle);
                     }
-                    // Wait for the module to return to life and configure it
-                    errorCode = moduleIsAlive(pInstance,
-                                              U_CELL_PWR_IS_ALIVE_ATTEMPTS_POWER_ON);
                     if (errorCode == 0) {
                         // Sleep is no longer available
                         pInstance->deepSleepState = U_CELL_PRIVATE_DEEP_SLEEP_STATE_UNAVAILABLE;
@@ -1965,6 +2250,8 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
                             }
                         }
                         // Now power back on again
+                        fixedWaitMs = 0;
+                        pTimeMaxMs = &(pInstance->bootTimeMaxMs);
                         if (pInstance->pinEnablePower >= 0) {
                             uPortGpioSet(pInstance->pinEnablePower,
                                          U_CELL_PRIVATE_ENABLE_POWER_PIN_ON_STATE(pInstance->pinStates));
@@ -1977,19 +2264,44 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
                             uPortTaskBlock(pInstance->pModule->powerOnPullMs);
                             uPortGpioSet(pInstance->pinPwrOn,
                                          (int32_t) !U_CELL_PRIVATE_PWR_ON_PIN_TOGGLE_TO_STATE(pInstance->pinStates));
-                            uPortTaskBlock(pInstance->pModule->bootWaitSeconds * 1000);
+                            fixedWaitMs = pInstance->pModule->bootWaitSeconds * 1000;
                         }
+                        startTimeMs = uPortGetTickTimeMs();
                     }
                 }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
 }
 
+// Get the time the module last took to boot.
+int32_t uCellPwrGetBootTimeMs(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCodeOrBootTimeMs = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrBootTimeMs = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCodeOrBootTimeMs = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (pInstance->bootTimeMs > 0) {
+                errorCodeOrBootTimeMs = pInstance->bootTimeMs;
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrBootTimeMs;
+}
+
 // Perform a hard reset of the cellular module.
 int32_t uCellPwrResetHard(uDeviceHandle_t cellHandle, int32_t pinReset)
 {
@@ -2024,9 +2336,8 @@ int32_t uCellPwrResetHard(uDeviceHandle_t cellHandle, int32_t pinReset)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pinReset >= 0)) {
             errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
@@ -2048,6 +2359,10 @@ int32_t uCellPwrResetHard(uDeviceHandle_t cellHandle, int32_t pinReset)
                 if (platformError == 0) {
                     // Remove any security context as these disappear at reboot
                     uCellPrivateC2cRemoveContext(pInstance);
+                    // GPIOs return to their default levels
+                    pInstance->gpioCache.knownMask = 0;
+                    // The module identity, e.g. firmware version or SIM, may change
+                    uCellPrivateIdentityCacheClear(pInstance, false);
                     // We have rebooted
                     pInstance->rebootIsRequired = false;
                     startTime = uPortGetTickTimeMs();
@@ -2087,7 +2402,7 @@ int32_t uCellPwrResetHard(uDeviceHandle_t cellHandle, int32_t pinReset)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2106,9 +2421,8 @@ int32_t uCellPwrSetDtrPowerSavingPin(uDeviceHandle_t cellHandle, int32_t pin)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL) && (pin >= 0)) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -2138,7 +2452,7 @@ int32_t uCellPwrSetDtrPowerSavingPin(uDeviceHandle_t cellHandle, int32_t pin)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
 
     }
 
@@ -2153,9 +2467,8 @@ int32_t uCellPwrGetDtrPowerSavingPin(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrPin = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrPin = (int32_t) U_ERROR_COMMON_NOT_FOUND;
@@ -2164,7 +2477,7 @@ int32_t uCellPwrGetDtrPowerSavingPin(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrPin;
@@ -2188,9 +2501,8 @@ int32_t  uCellPwrSetRequested3gppPowerSaving(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL) &&
             (!onNotOff ||
@@ -2268,7 +2580,7 @@ int32_t  uCellPwrSetRequested3gppPowerSaving(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2288,9 +2600,8 @@ int32_t uCellPwrGetRequested3gppPowerSaving(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -2317,7 +2628,7 @@ int32_t uCellPwrGetRequested3gppPowerSaving(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2337,9 +2648,8 @@ int32_t uCellPwrGet3gppPowerSaving(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -2366,7 +2676,7 @@ int32_t uCellPwrGet3gppPowerSaving(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2387,9 +2697,8 @@ int32_t uCellPwrSet3gppPowerSavingCallback(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -2406,7 +2715,7 @@ int32_t uCellPwrSet3gppPowerSavingCallback(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2427,9 +2736,8 @@ int32_t uCellPwrSetRequestedEDrx(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL) &&
             // Cast in two stages to keep Lint happy
@@ -2522,7 +2830,7 @@ int32_t uCellPwrSetRequestedEDrx(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2540,9 +2848,8 @@ int32_t uCellPwrGetRequestedEDrx(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             errorCode = uCellPwrPrivateGetEDrx(pInstance, false, rat,
@@ -2550,7 +2857,7 @@ int32_t uCellPwrGetRequestedEDrx(uDeviceHandle_t cellHandle,
                                                pPagingWindowSeconds);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2568,9 +2875,8 @@ int32_t uCellPwrGetEDrx(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             errorCode = uCellPwrPrivateGetEDrx(pInstance, true, rat,
@@ -2578,7 +2884,7 @@ int32_t uCellPwrGetEDrx(uDeviceHandle_t cellHandle,
                                                pPagingWindowSeconds);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2600,9 +2906,8 @@ int32_t uCellPwrSetEDrxCallback(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -2626,7 +2931,7 @@ int32_t uCellPwrSetEDrxCallback(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2643,9 +2948,8 @@ int32_t uCellPwrSetDeepSleepWakeUpCallback(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -2668,7 +2972,7 @@ int32_t uCellPwrSetDeepSleepWakeUpCallback(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2682,9 +2986,8 @@ int32_t uCellPwrGetDeepSleepActive(uDeviceHandle_t cellHandle, bool *pSleepActiv
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -2697,7 +3000,7 @@ int32_t uCellPwrGetDeepSleepActive(uDeviceHandle_t cellHandle, bool *pSleepActiv
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2720,9 +3023,8 @@ int32_t uCellPwrDisableUartSleep(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             pUartSleepCache = &(pInstance->uartSleepCache);
             // If a wake-up handler has been set then the module supports
@@ -2759,7 +3061,7 @@ int32_t uCellPwrDisableUartSleep(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2775,9 +3077,8 @@ int32_t uCellPwrEnableUartSleep(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             pUartSleepCache = &(pInstance->uartSleepCache);
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -2820,7 +3121,7 @@ int32_t uCellPwrEnableUartSleep(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -2835,18 +3136,123 @@ bool uCellPwrUartSleepIsEnabled(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && (pInstance->pModule != NULL)) {
             isEnabled = uAtClientWakeUpHandlerIsSet(pInstance->atHandle);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isEnabled;
 }
 
 
+// Schedule a send.
+int32_t uCellPwrTxSchedule(uDeviceHandle_t cellHandle,
+                           uCellPwrTxPriority_t priority,
+                           void (*pSend) (uDeviceHandle_t cellHandle,
+                                          void *pSendParam),
+                           void *pSendParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellPrivateTxSchedule_t *pContext;
+    int32_t holdMs;
+    int32_t deadlineMs;
+    bool sendNow = false;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pSend != NULL) &&
+            ((int32_t) priority >= 0) &&
+            (priority < U_CELL_PWR_TX_PRIORITY_MAX_NUM)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            sendNow = true;
+            if (priority != U_CELL_PWR_TX_PRIORITY_URGENT) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                sendNow = false;
+                pContext = pTxScheduleGet(pInstance);
+                if (pContext != NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    if (pContext->numEntries < pContext->numMax) {
+                        (pContext->pEntries + pContext->numEntries)->priority = (int32_t) priority;
+                        (pContext->pEntries + pContext->numEntries)->pSend = pSend;
+                        (pContext->pEntries + pContext->numEntries)->pSendParam = pSendParam;
+                        holdMs = U_CELL_PWR_TX_SCHEDULE_NORMAL_MAX_HOLD_SECONDS * 1000;
+                        if (priority == U_CELL_PWR_TX_PRIORITY_LOW) {
+                            holdMs = U_CELL_PWR_TX_SCHEDULE_LOW_MAX_HOLD_SECONDS * 1000;
+                        }
+                        deadlineMs = uPortGetTickTimeMs() + holdMs;
+                        if ((pContext->numEntries == 0) ||
+                            (deadlineMs - pContext->deadlineMs < 0)) {
+                            // This is now the first held send that falls
+                            // due, so (re)start the timer for it
+                            pContext->deadlineMs = deadlineMs;
+                            uPortTimerStop(pContext->timerHandle);
+                            if ((uPortTimerChange(pContext->timerHandle, holdMs) != 0) ||
+                                (uPortTimerStart(pContext->timerHandle) != 0)) {
+                                // Without a timer we can't honour the
+                                // maximum hold time: send now instead
+                                sendNow = true;
+                            }
+                        }
+                        if (!sendNow) {
+                            pContext->numEntries++;
+                        }
+                    } else {
+                        // Full: send everything now
+                        sendNow = true;
+                    }
+                }
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    if (sendNow) {
+        // Send this first and then everything else that is held,
+        // from this task, while the module is awake anyway
+        pSend(cellHandle, pSendParam);
+        txScheduleFlush(cellHandle);
+    }
+
+    return errorCode;
+}
+
+// Make all of the held sends now.
+int32_t uCellPwrTxFlush(uDeviceHandle_t cellHandle)
+{
+    return txScheduleFlush(cellHandle);
+}
+
+// Get the number of sends being held.
+int32_t uCellPwrTxGetNumPending(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
+
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCodeOrCount = 0;
+            if (pInstance->pTxSchedule != NULL) {
+                errorCodeOrCount = (int32_t) pInstance->pTxSchedule->numEntries;
+            }
+        }
+
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrCount;
+}
+
 // End of file
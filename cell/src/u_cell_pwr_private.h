@@ -40,7 +40,7 @@ extern "C" {
 /** Power the cellular module on or wakeit from deep sleep.  If this
  * function returns success then the cellular module is ready to
  * receive configuration commands and register with the cellular network.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance          a pointer to the instance.
  * @param pKeepGoingCallback power on usually takes between 5 and
@@ -101,7 +101,7 @@ int32_t uCellPwrPrivatePeriodicWakeupStrToSeconds(const char *pStr,
                                                   int32_t *pSeconds);
 
 /** Get the 3GPP power saving settings.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance              a pointer to the cellular instance.
  * @param assignedNotRequested   if true then get the values assigned
@@ -129,7 +129,7 @@ int32_t uCellPwrPrivateGet3gppPowerSaving(uCellPrivateInstance_t *pInstance,
                                           int32_t *pPeriodicWakeupSeconds);
 
 /** Get the E-DRX settings for the given RAT.
- * Note: gUCellPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param pInstance              a pointer to the cellular instance.
  * @param assignedNotRequested   true to get the assigned parameters,
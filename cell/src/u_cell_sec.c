@@ -179,9 +179,8 @@ static int32_t ztpGet(uDeviceHandle_t cellHandle, int32_t type,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -213,12 +212,14 @@ static int32_t ztpGet(uDeviceHandle_t cellHandle, int32_t type,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
 }
 
+#ifndef U_CFG_CELL_DISABLE_C2C
+
 // Enrypt a C2C confirmation tag, consisting
 // of U_SECURITY_C2C_CONFIRMATION_TAG_LENGTH_BYTES
 // but hex encode (so twice that long).
@@ -315,6 +316,8 @@ static size_t encryptC2cConfirmationTag(const char *pC2cConfirmationTagHex,
     return length;
 }
 
+#endif // #ifndef U_CFG_CELL_DISABLE_C2C
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: INFORMATION
  * -------------------------------------------------------------- */
@@ -327,9 +330,8 @@ bool uCellSecIsSupported(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             // No need to contact the module, this is something
             // we know in advance for a given module type
@@ -337,7 +339,7 @@ bool uCellSecIsSupported(uDeviceHandle_t cellHandle)
                                              U_CELL_PRIVATE_FEATURE_ROOT_OF_TRUST);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isSupported;
@@ -354,9 +356,8 @@ bool uCellSecIsBootstrapped(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
                                    U_CELL_PRIVATE_FEATURE_ROOT_OF_TRUST)) {
@@ -389,7 +390,7 @@ bool uCellSecIsBootstrapped(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isBootstrapped;
@@ -427,10 +428,9 @@ int32_t uCellSecGetRootOfTrustUid(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
         if (pRootOfTrustUid != NULL) {
-            pInstance = pUCellPrivateGetInstance(cellHandle);
             errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
             if (pInstance != NULL) {
                 errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -464,7 +464,7 @@ int32_t uCellSecGetRootOfTrustUid(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -474,6 +474,8 @@ int32_t uCellSecGetRootOfTrustUid(uDeviceHandle_t cellHandle,
  * PUBLIC FUNCTIONS: CHIP TO CHIP SECURITY
  * -------------------------------------------------------------- */
 
+#ifndef U_CFG_CELL_DISABLE_C2C
+
 // Pair a cellular module's AT interface for chip to chip security.
 int32_t uCellSecC2cPair(uDeviceHandle_t cellHandle,
                         const char *pTESecret,
@@ -491,9 +493,8 @@ int32_t uCellSecC2cPair(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pTESecret != NULL) &&
             (pKey != NULL) && (pHMac != NULL)) {
@@ -626,7 +627,7 @@ int32_t uCellSecC2cPair(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -646,9 +647,8 @@ int32_t uCellSecC2cOpen(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pTESecret != NULL) &&
             (pKey != NULL) && (pHMacKey != NULL)) {
@@ -717,7 +717,7 @@ int32_t uCellSecC2cOpen(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -732,9 +732,8 @@ int32_t uCellSecC2cClose(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -762,11 +761,45 @@ int32_t uCellSecC2cClose(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
 }
+#else
+
+// Chip to chip security has been excluded from the build,
+// see U_CFG_CELL_DISABLE_C2C.
+int32_t uCellSecC2cPair(uDeviceHandle_t cellHandle,
+                        const char *pTESecret,
+                        char *pKey, char *pHMac)
+{
+    (void) cellHandle;
+    (void) pTESecret;
+    (void) pKey;
+    (void) pHMac;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+int32_t uCellSecC2cOpen(uDeviceHandle_t cellHandle,
+                        const char *pTESecret,
+                        const char *pKey,
+                        const char *pHMacKey)
+{
+    (void) cellHandle;
+    (void) pTESecret;
+    (void) pKey;
+    (void) pHMacKey;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+int32_t uCellSecC2cClose(uDeviceHandle_t cellHandle)
+{
+    (void) cellHandle;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+#endif // #ifndef U_CFG_CELL_DISABLE_C2C
 
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: SEAL
@@ -784,9 +817,8 @@ int32_t uCellSecSealSet(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pDeviceProfileUid != NULL) &&
             (pDeviceSerialNumberStr != NULL)) {
@@ -817,7 +849,7 @@ int32_t uCellSecSealSet(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -831,9 +863,8 @@ bool uCellSecIsSealed(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
                                    U_CELL_PRIVATE_FEATURE_ROOT_OF_TRUST)) {
@@ -841,7 +872,7 @@ bool uCellSecIsSealed(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isSealed;
@@ -888,10 +919,9 @@ int32_t uCellSecE2eSetVersion(uDeviceHandle_t cellHandle, int32_t version)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if ((pInstance != NULL) && (version > 0)) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -908,7 +938,7 @@ int32_t uCellSecE2eSetVersion(uDeviceHandle_t cellHandle, int32_t version)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -924,10 +954,9 @@ int32_t uCellSecE2eGetVersion(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
         errorCodeOrVersion = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         if (pInstance != NULL) {
             errorCodeOrVersion = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -952,7 +981,7 @@ int32_t uCellSecE2eGetVersion(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrVersion;
@@ -971,11 +1000,10 @@ int32_t uCellSecE2eEncrypt(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pDataIn != NULL) {
-            pInstance = pUCellPrivateGetInstance(cellHandle);
             if (pInstance != NULL) {
                 errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
                 if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -1028,7 +1056,7 @@ int32_t uCellSecE2eEncrypt(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -1052,9 +1080,8 @@ int32_t uCellSecPskGenerate(uDeviceHandle_t cellHandle,
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pPsk != NULL) && (pPskId != NULL) &&
             ((pskSizeBytes == 16) || (pskSizeBytes == 32))) {
@@ -1097,7 +1124,7 @@ int32_t uCellSecPskGenerate(uDeviceHandle_t cellHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrSize;
@@ -1116,9 +1143,8 @@ int32_t uCellSecHeartbeatTrigger(uDeviceHandle_t cellHandle)
 
     if (gUCellPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_LOCK(cellHandle, pInstance);
 
-        pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -1134,7 +1160,7 @@ int32_t uCellSecHeartbeatTrigger(uDeviceHandle_t cellHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+        U_CELL_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -79,7 +79,7 @@
 // Check that U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES is at least as
 // big as U_SECURITY_C2C_TE_SECRET_LENGTH_BYTES
 #if U_SECURITY_C2C_TE_SECRET_LENGTH_BYTES > U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES
-# error U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES must be at least as big as U_SECURITY_C2C_TE_SECRET_LENGTH_BYTES since a TE secret is temporarily written to the space a truncated MAC would occupy during V2 encoding.
+# error U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES must be at least as big as U_SECURITY_C2C_TE_SECRET_LENGTH_BYTES since a TE secret is temporarily written to the space a truncated MAC would occupy during V2 encoding and decoding.
 #endif
 
 /* ----------------------------------------------------------------
@@ -464,6 +464,7 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
     size_t chunkLengthLimit;
     uint16_t y;
     char *pData = pRx->pRxIn;
+    char mac[U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES];
 #ifdef U_CELL_SEC_C2C_DETAILED_DEBUG
     size_t z = 0;
 #endif
@@ -519,10 +520,11 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
         // Have a frame marker and at least a non-zero length frame
         // Grab the length, little endian
         pData++;
-        // Cast in two stages to keep Lint happy
-        chunkLength = ((size_t) (int32_t) * pData);
+        // Cast via uint8_t so that a length byte of 0x80 or more
+        // is not sign-extended where char is signed
+        chunkLength = ((size_t) (uint8_t) * pData);
         pData++;
-        chunkLength += ((size_t) (int32_t) * pData) << 8;
+        chunkLength += ((size_t) (uint8_t) * pData) << 8;
         pData++;
 
 #ifdef U_CELL_SEC_C2C_DETAILED_DEBUG
@@ -576,9 +578,14 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
                     // encrypted text (i.e. minus the
                     // HMAC tag that forms part of
                     // the payload) plus the TE Secret.
-                    // To do this concatenate the two
-                    // into rxOut (there is enough room
-                    // to do so).
+                    // Rather than copying the encrypted text
+                    // somewhere else to append the TE Secret to
+                    // it, keep the received truncated MAC in a
+                    // local variable and write the TE Secret over
+                    // it in the receive buffer (it is no bigger,
+                    // as checked with a #error above), then the
+                    // HMAC can be calculated in place: this frame
+                    // is consumed either way.
 #ifdef U_CELL_SEC_C2C_DETAILED_DEBUG
                     uPortLog("U_CELL_SEC_C2C_DECODE: version 2.\n");
 
@@ -593,22 +600,19 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
 #endif
                     x = chunkLength -
                         U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES;
-                    memcpy(pRx->rxOut, pData, x);
-                    memcpy(pRx->rxOut + x, pContext->teSecret,
+                    memcpy(mac, pData + x, U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES);
+                    memcpy(pData + x, pContext->teSecret,
                            sizeof(pContext->teSecret));
                     // Compute the HMAC SHA256 of this block
-                    // using the HMAC tag as the key and put it
-                    // on the end of rxOut as temporary storage.
+                    // into rxOut as temporary storage.
                     if (uPortCryptoHmacSha256(pContext->hmacKey,
                                               sizeof(pContext->hmacKey),
-                                              pRx->rxOut,
+                                              pData,
                                               x + sizeof(pContext->teSecret),
-                                              pRx->rxOut +
-                                              x + sizeof(pContext->teSecret)) == 0) {
+                                              pRx->rxOut) == 0) {
                         // Compare the first 16 bytes of
                         // it with the truncated MAC we received.
-                        if (memcmp(pData + x, pRx->rxOut + x +
-                                   sizeof(pContext->teSecret),
+                        if (memcmp(mac, pRx->rxOut,
                                    U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES) == 0) {
                             // The MAC's match, decrypt the contents
                             // into rxOut using the key and the IV from the
@@ -633,12 +637,11 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
                                 uPortLog("U_CELL_SEC_C2C_DECODE: padded decrypted data:\n");
                                 printBlock(pRx->rxOut, x, false);
 #endif
-                                // Unpad the now plain text
+                                // Unpad the now plain text and hand
+                                // it back from where it is: the AT
+                                // client moves it into place anyway
                                 length = unpad(pRx->rxOut, x);
-                                // Copy it back into the receive buffer
-                                // and set the output pointer
-                                memcpy(pRx->pRxIn, pRx->rxOut, length);
-                                pRx->pRxOut = pRx->pRxIn;
+                                pRx->pRxOut = pRx->rxOut;
 #ifdef U_CELL_SEC_C2C_DETAILED_DEBUG
                                 uPortLog("U_CELL_SEC_C2C_DECODE: decrypted data:\n");
                                 printBlock(pRx->rxOut, length, false);
@@ -710,13 +713,12 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
                                 uPortLog("U_CELL_SEC_C2C_DECODE: MACs match.\n");
 #endif
                                 // The MAC's match, get the unpadded length
-                                // of the plain-text data
+                                // of the plain-text data and hand it back
+                                // from where it is: the AT client moves
+                                // it into place anyway
                                 length = unpad(pRx->rxOut,
                                                x - U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES);
-                                // Copy it back into the receive buffer
-                                // and set the output pointer
-                                memcpy(pRx->pRxIn, pRx->rxOut, length);
-                                pRx->pRxOut = pRx->pRxIn;
+                                pRx->pRxOut = pRx->rxOut;
 #ifdef U_CELL_SEC_C2C_DETAILED_DEBUG
                                 uPortLog("U_CELL_SEC_C2C_DECODE: %d byte(s) decrypted"
                                          " data:\n", length);
@@ -41,6 +41,7 @@
 #include "u_port.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"
+#include "u_port_uart.h"
 
 #include "u_at_client.h"
 
@@ -98,10 +99,80 @@
 #define U_CELL_SOCK_SARA_R422_DNS_DELAY_MILLISECONDS 500
 #endif
 
+#ifndef U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES
+/** When sockets are in hex mode, received hex-coded data is read
+ * from the AT client in chunks of this many characters, decoding
+ * each chunk straight into the caller's buffer, rather than
+ * allocating a buffer big enough for a whole segment of hex; this
+ * buffer is on the stack.  Must be an even number.
+ */
+# define U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES 64
+#endif
+
+#if (U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES < 2) || (U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES % 2 != 0)
+# error U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES must be an even number, at least 2
+#endif
+
+#ifndef U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES
+/** The size of the buffer that data received on a socket in
+ * direct link mode (see #U_SOCK_OPT_DIRECT_LINK) is stored in
+ * until it is read; this is allocated when direct link mode is
+ * entered and freed when it is left.  When the buffer is full
+ * received data is held back in the AT client and, if flow
+ * control is in use, eventually in the module.
+ */
+# define U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES 2048
+#endif
+
+#ifndef U_CELL_SOCK_DIRECT_LINK_GUARD_TIME_MS
+/** The silence required either side of the "+++" escape sequence
+ * that takes the module out of direct link mode; the module's
+ * default guard time is one second, this has some margin.
+ */
+# define U_CELL_SOCK_DIRECT_LINK_GUARD_TIME_MS 1200
+#endif
+
+/** The line the module emits when it enters direct link mode.
+ */
+#define U_CELL_SOCK_DIRECT_LINK_CONNECT "CONNECT\r\n"
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The state of a socket in direct link mode.
+ */
+typedef struct {
+    int32_t sockHandle; /**< The handle of the socket that is in
+                             direct link mode. */
+    char *pBuffer; /**< The buffer that received data is written to,
+                        U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES
+                        long. */
+    volatile size_t readIndex;  /**< Where to read from in pBuffer. */
+    volatile size_t writeIndex; /**< Where to write to in pBuffer. */
+    size_t connectMatchLength; /**< How much of
+                                    U_CELL_SOCK_DIRECT_LINK_CONNECT
+                                    has been matched so far. */
+    volatile bool connected; /**< True once the module has entered
+                                  direct link mode. */
+    volatile bool stalled; /**< True if received data has been held
+                                back because pBuffer was full. */
+    int32_t lastWriteTimeMs; /**< When data was last written, used
+                                  for the escape guard time. */
+} uCellSockDirectLink_t;
+
+/** The read-ahead cache of a socket, see #U_SOCK_OPT_READ_AHEAD;
+ * this is malloc()ed with the buffer, size bytes long, immediately
+ * following it.
+ */
+typedef struct {
+    size_t size; /**< The size of the buffer. */
+    size_t readIndex; /**< Where to read from in the buffer. */
+    size_t writeIndex; /**< The end of the data in the buffer; the
+                            buffer is only filled when it is empty,
+                            i.e. readIndex equals writeIndex. */
+} uCellSockReadAhead_t;
+
 /** A cellular socket.
  */
 typedef struct {
@@ -124,6 +195,26 @@ typedef struct {
     void (*pClosedCallback) (uDeviceHandle_t, int32_t); /**< Set to NULL
                                                      if socket is
                                                      not in use. */
+    void (*pAsyncConnectCallback) (uDeviceHandle_t, int32_t, int32_t); /**< Set
+                                                                    to NULL if no
+                                                                    asynchronous
+                                                                    connection is
+                                                                    in progress. */
+    volatile int32_t asyncConnectErrno; /**< The result of an asynchronous
+                                             connection, passed from the
+                                             +UUSOCO URC to its callback. */
+    uCellSockDirectLink_t *pDirectLink; /**< Non-NULL if the socket is
+                                             in direct link mode. */
+    int32_t readPriority; /**< The priority of this socket's data
+                               callback, see #U_SOCK_OPT_READ_PRIORITY. */
+    int32_t readWaitCount; /**< The number of times this socket has
+                                been passed over by the data scheduler
+                                since its data callback was last called. */
+    volatile bool dataCallbackPending; /**< True if the data callback
+                                            of this socket is waiting
+                                            to be called. */
+    uCellSockReadAhead_t *pReadAhead; /**< Non-NULL if the socket has a
+                                           read-ahead cache. */
 } uCellSockSocket_t;
 
 /** Definition of a URC handler.
@@ -148,6 +239,19 @@ static int32_t gNextSockHandle = 0;
  */
 static uCellSockSocket_t gSockets[U_CELL_SOCK_MAX_NUM_SOCKETS];
 
+/** The index in gSockets of the socket whose data callback was
+ * called last, for the round-robin part of the data scheduler.
+ */
+static size_t gDataScheduleIndex = 0;
+
+/** The AT commands that move socket data, sent often enough to be
+ * worth preparing, see uAtClientCommandPrepared().
+ */
+static const uAtClientPreparedCommand_t gUsord = U_AT_CLIENT_PREPARED_COMMAND("AT+USORD=", "dd");
+static const uAtClientPreparedCommand_t gUsorf = U_AT_CLIENT_PREPARED_COMMAND("AT+USORF=", "dd");
+static const uAtClientPreparedCommand_t gUsowr = U_AT_CLIENT_PREPARED_COMMAND("AT+USOWR=", "dd");
+static const uAtClientPreparedCommand_t gUsowrHex = U_AT_CLIENT_PREPARED_COMMAND("AT+USOWR=", "dds");
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: LIST MANAGEMENT
  * -------------------------------------------------------------- */
@@ -186,6 +290,25 @@ static uCellSockSocket_t *pFindBySockHandleModule(const uAtClientHandle_t atHand
     return pSock;
 }
 
+// Return the socket on the given cellular instance that is in
+// direct link mode, NULL if there isn't one; while there is one
+// the AT interface cannot be used for anything else.
+static uCellSockSocket_t *pFindDirectLink(uDeviceHandle_t cellHandle)
+{
+    uCellSockSocket_t *pSocket = NULL;
+
+    for (size_t x = 0; (x < sizeof(gSockets) / sizeof(gSockets[0])) &&
+         (pSocket == NULL); x++) {
+        if ((gSockets[x].sockHandle >= 0) &&
+            (gSockets[x].cellHandle == cellHandle) &&
+            (gSockets[x].pDirectLink != NULL)) {
+            pSocket = &(gSockets[x]);
+        }
+    }
+
+    return pSocket;
+}
+
 // Do AT+USOER, for debug purposes.
 static void doUsoer(uAtClientHandle_t atHandle)
 {
@@ -222,6 +345,13 @@ static uCellSockSocket_t *pSockCreate(int32_t sockHandle,
         pSock->pAsyncClosedCallback = NULL;
         pSock->pDataCallback = NULL;
         pSock->pClosedCallback = NULL;
+        pSock->pAsyncConnectCallback = NULL;
+        pSock->asyncConnectErrno = U_SOCK_ENONE;
+        pSock->pDirectLink = NULL;
+        pSock->readPriority = 0;
+        pSock->readWaitCount = 0;
+        pSock->dataCallbackPending = false;
+        pSock->pReadAhead = NULL;
     }
 
     return pSock;
@@ -244,7 +374,201 @@ static void sockFree(int32_t sockHandle)
             pSock->pAsyncClosedCallback = NULL;
             pSock->pDataCallback = NULL;
             pSock->pClosedCallback = NULL;
+            pSock->pAsyncConnectCallback = NULL;
+            pSock->asyncConnectErrno = U_SOCK_ENONE;
+            free(pSock->pDirectLink);
+            pSock->pDirectLink = NULL;
+            pSock->readPriority = 0;
+            pSock->readWaitCount = 0;
+            pSock->dataCallbackPending = false;
+            free(pSock->pReadAhead);
+            pSock->pReadAhead = NULL;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: READ
+ * -------------------------------------------------------------- */
+
+// Read the quoted hex string of received socket data, which must
+// be the next thing in the AT client's receive buffer, decoding it
+// a chunk at a time straight into pData: up to dataSizeBytes of
+// decoded data is written to pData and the remainder, up to
+// receivedSize, is poured away. Where there is room for the hex
+// itself at pData it is read there and decoded in place, otherwise
+// it goes through a buffer on the stack. Must be called with the AT
+// client locked; any error is left in the AT client for the caller.
+static void readHex(uAtClientHandle_t atHandle, char *pData,
+                    size_t dataSizeBytes, size_t receivedSize)
+{
+    char buffer[U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES];
+    size_t thisLength;
+    size_t thisDataLength;
+    bool readOk = true;
+
+    // Don't stop for anything!
+    uAtClientIgnoreStopTag(atHandle);
+    // Get the leading quote mark out of the way
+    uAtClientReadBytes(atHandle, NULL, 1, true);
+    while ((receivedSize > 0) && readOk) {
+        thisLength = receivedSize;
+        if (thisLength * 2 <= dataSizeBytes) {
+            // There is room for the hex itself at pData: read
+            // it there and decode it in place
+            readOk = (uAtClientReadBytes(atHandle, pData, thisLength * 2,
+                                         true) == (int32_t) (thisLength * 2));
+            if (readOk) {
+                uHexToBinInPlace(pData, thisLength * 2);
+                pData += thisLength;
+                dataSizeBytes -= thisLength;
+                receivedSize -= thisLength;
+            }
+        } else {
+            if (thisLength > sizeof(buffer) / 2) {
+                thisLength = sizeof(buffer) / 2;
+            }
+            readOk = (uAtClientReadBytes(atHandle, buffer, thisLength * 2,
+                                         true) == (int32_t) (thisLength * 2));
+            if (readOk) {
+                thisDataLength = thisLength;
+                if (thisDataLength > dataSizeBytes) {
+                    thisDataLength = dataSizeBytes;
+                }
+                if (thisDataLength > 0) {
+                    uHexToBin(buffer, thisDataLength * 2, pData);
+                    pData += thisDataLength;
+                    dataSizeBytes -= thisDataLength;
+                }
+                receivedSize -= thisLength;
+            }
+        }
+    }
+    // Make sure to wait for the stop tag before we finish
+    uAtClientRestoreStopTag(atHandle);
+}
+
+// Read up to dataSizeBytes of received data on a socket with
+// AT+USORD, which must be no more than the module can send in one
+// go, updating pendingBytes.  Must be called with the AT client
+// locked.  Returns the number of bytes read or negated U_SOCK_Exxx.
+static int32_t usord(uCellSockSocket_t *pSocket, bool hexMode,
+                     char *pData, size_t dataSizeBytes)
+{
+    int32_t negErrnoLocalOrSize = -U_SOCK_EIO;
+    uAtClientHandle_t atHandle = pSocket->atHandle;
+    int32_t receivedSize;
+    int32_t values[2];
+
+    // Socket handle then number of bytes to read
+    uAtClientCommandPrepared(atHandle, &gUsord, pSocket->sockHandleModule,
+                             (int32_t) dataSizeBytes);
+    uAtClientResponseStart(atHandle, "+USORD:");
+    // Skip the socket ID, then: read the amount of data
+    uAtClientReadIntList(atHandle, values, 2,
+                         U_AT_CLIENT_READ_INT_LIST_SKIP(0, 1));
+    receivedSize = values[1];
+    if (receivedSize > (int32_t) dataSizeBytes) {
+        receivedSize = (int32_t) dataSizeBytes;
+    }
+    if (receivedSize > 0) {
+        if (hexMode) {
+            // Decode the hex straight into pData
+            readHex(atHandle, pData, receivedSize, receivedSize);
+        } else {
+            // Binary mode, don't stop for anything!
+            uAtClientIgnoreStopTag(atHandle);
+            // Get the leading quote mark out of the way
+            uAtClientReadBytes(atHandle, NULL, 1, true);
+            // Now read out the available data
+            uAtClientReadBytes(atHandle, pData, receivedSize, true);
+            // Make sure we wait for the stop tag before
+            // going around again
+            uAtClientRestoreStopTag(atHandle);
+        }
+    }
+    uAtClientResponseStop(atHandle);
+    // BEFORE the caller unlocks, work out what's happened.
+    // This is to prevent a URC being processed that
+    // may indicate data left and over-write pendingBytes
+    // while we're also writing to it.
+    if ((uAtClientErrorGet(atHandle) == 0) && (receivedSize >= 0)) {
+        // Must use what +USORD returns here as it may be less
+        // or more than we asked for and also may be
+        // more than pendingBytes, depending on how
+        // the URCs landed
+        // This update of pendingBytes will be overwritten
+        // by the URC but we have to do something here
+        // 'cos we don't get a URC to tell us when pendingBytes
+        // has gone to zero.
+        if (receivedSize > pSocket->pendingBytes) {
+            pSocket->pendingBytes = 0;
+        } else {
+            pSocket->pendingBytes -= receivedSize;
         }
+        negErrnoLocalOrSize = receivedSize;
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Copy up to dataSizeBytes out of the read-ahead cache of a
+// socket, returning the number of bytes copied.
+static size_t readAheadGet(uCellSockSocket_t *pSocket,
+                           char *pData, size_t dataSizeBytes)
+{
+    uCellSockReadAhead_t *pReadAhead = pSocket->pReadAhead;
+    size_t length = pReadAhead->writeIndex - pReadAhead->readIndex;
+
+    if (length > dataSizeBytes) {
+        length = dataSizeBytes;
+    }
+    memcpy(pData, ((char *) (pReadAhead + 1)) + pReadAhead->readIndex, length);
+    pReadAhead->readIndex += length;
+
+    return length;
+}
+
+// Fill the read-ahead cache of a socket, which must be empty, with
+// as much received data as the module will send in one AT+USORD.
+// Must be called with the AT client locked.  Returns the number of
+// bytes read or negated U_SOCK_Exxx.
+static int32_t readAheadFill(uCellSockSocket_t *pSocket, bool hexMode)
+{
+    uCellSockReadAhead_t *pReadAhead = pSocket->pReadAhead;
+    size_t size = pReadAhead->size;
+    int32_t negErrnoLocalOrSize;
+
+    if (hexMode && (size > U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES / 2)) {
+        size = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES / 2;
+    }
+    pReadAhead->readIndex = 0;
+    pReadAhead->writeIndex = 0;
+    negErrnoLocalOrSize = usord(pSocket, hexMode, (char *) (pReadAhead + 1), size);
+    if (negErrnoLocalOrSize > 0) {
+        pReadAhead->writeIndex = (size_t) negErrnoLocalOrSize;
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Fill the read-ahead cache of a socket, if it is empty and the
+// module has data waiting, so that the reads that follow a data
+// callback are served from RAM.
+static void readAheadPrefetch(uCellSockSocket_t *pSocket)
+{
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle = pSocket->atHandle;
+
+    pInstance = pUCellPrivateGetInstance(pSocket->cellHandle);
+    if ((pInstance != NULL) && (pFindDirectLink(pSocket->cellHandle) == NULL)) {
+        uAtClientLock(atHandle);
+        if ((pSocket->pReadAhead != NULL) &&
+            (pSocket->pReadAhead->readIndex == pSocket->pReadAhead->writeIndex) &&
+            (pSocket->pendingBytes > 0)) {
+            readAheadFill(pSocket, pInstance->socketsHexMode);
+        }
+        uAtClientUnlock(atHandle);
     }
 }
 
@@ -259,7 +583,7 @@ static void dataCallback(const uAtClientHandle_t atHandle,
     //lint -e(507) Suppress size incompatibility: the compiler
     // we use for Lint checking is 64 bit so has 8 byte pointers
     // and Lint doesn't like them being used to carry 4 byte integers
-    int32_t sockHandle = (int32_t) pParameter;
+    int32_t sockHandle = (int32_t) (intptr_t) pParameter;
     uCellSockSocket_t *pSocket;
 
     (void) atHandle;
@@ -274,6 +598,76 @@ static void dataCallback(const uAtClientHandle_t atHandle,
     }
 }
 
+// Pick the next socket on the given AT client whose data callback
+// is waiting to be called: the one with the highest read priority
+// plus the number of times it has been passed over, ties going to
+// the first one after the socket served last, round-robin.
+static uCellSockSocket_t *pDataScheduleNext(const uAtClientHandle_t atHandle)
+{
+    uCellSockSocket_t *pSocket = NULL;
+    uCellSockSocket_t *pCandidate;
+    size_t numSockets = sizeof(gSockets) / sizeof(gSockets[0]);
+    size_t index = 0;
+    size_t y;
+
+    for (size_t x = 1; x <= numSockets; x++) {
+        y = (gDataScheduleIndex + x) % numSockets;
+        pCandidate = &(gSockets[y]);
+        if ((pCandidate->sockHandle >= 0) &&
+            (pCandidate->atHandle == atHandle) &&
+            pCandidate->dataCallbackPending &&
+            ((pSocket == NULL) ||
+             (pCandidate->readPriority + pCandidate->readWaitCount >
+              pSocket->readPriority + pSocket->readWaitCount))) {
+            pSocket = pCandidate;
+            index = y;
+        }
+    }
+
+    if (pSocket != NULL) {
+        // Everyone left waiting moves up
+        for (size_t x = 0; x < numSockets; x++) {
+            pCandidate = &(gSockets[x]);
+            if ((pCandidate != pSocket) &&
+                (pCandidate->sockHandle >= 0) &&
+                (pCandidate->atHandle == atHandle) &&
+                pCandidate->dataCallbackPending) {
+                pCandidate->readWaitCount++;
+            }
+        }
+        pSocket->readWaitCount = 0;
+        gDataScheduleIndex = index;
+    }
+
+    return pSocket;
+}
+
+// Callback for pending data on any socket of an AT client: calls
+// the data callbacks of the sockets that have data waiting, in
+// the order given by pDataScheduleNext().
+static void dataScheduleCallback(const uAtClientHandle_t atHandle,
+                                 void *pUnused)
+{
+    uCellSockSocket_t *pSocket;
+
+    (void) pUnused;
+
+    pSocket = pDataScheduleNext(atHandle);
+    while (pSocket != NULL) {
+        // Clear the flag first so that any data arriving
+        // while the callback runs is not missed
+        pSocket->dataCallbackPending = false;
+        if (pSocket->pReadAhead != NULL) {
+            readAheadPrefetch(pSocket);
+        }
+        if (pSocket->pDataCallback != NULL) {
+            pSocket->pDataCallback(pSocket->cellHandle,
+                                   pSocket->sockHandle);
+        }
+        pSocket = pDataScheduleNext(atHandle);
+    }
+}
+
 // Callback trampoline for connection closed.
 static void closedCallback(const uAtClientHandle_t atHandle,
                            void *pParameter)
@@ -281,7 +675,7 @@ static void closedCallback(const uAtClientHandle_t atHandle,
     //lint -e(507) Suppress size incompatibility: the compiler
     // we use for Lint checking is 64 bit so has 8 byte pointers
     // and Lint doesn't like them being used to carry 4 byte integers
-    int32_t sockHandle = (int32_t) pParameter;
+    int32_t sockHandle = (int32_t) (intptr_t) pParameter;
     uCellSockSocket_t *pSocket;
 
     (void) atHandle;
@@ -310,10 +704,38 @@ static void closedCallback(const uAtClientHandle_t atHandle,
     }
 }
 
+// Callback trampoline for asynchronous connection completed.
+static void connectCallback(const uAtClientHandle_t atHandle,
+                            void *pParameter)
+{
+    //lint -e(507) Suppress size incompatibility: the compiler
+    // we use for Lint checking is 64 bit so has 8 byte pointers
+    // and Lint doesn't like them being used to carry 4 byte integers
+    int32_t sockHandle = (int32_t) (intptr_t) pParameter;
+    uCellSockSocket_t *pSocket;
+    void (*pCallback) (uDeviceHandle_t, int32_t, int32_t);
+
+    (void) atHandle;
+
+    if (sockHandle >= 0) {
+        // Find the entry
+        pSocket = pFindBySockHandle(sockHandle);
+        if ((pSocket != NULL) && (pSocket->pAsyncConnectCallback != NULL)) {
+            // One shot: lose the callback before calling it
+            // in case it starts another connection
+            pCallback = pSocket->pAsyncConnectCallback;
+            pSocket->pAsyncConnectCallback = NULL;
+            pCallback(pSocket->cellHandle, sockHandle,
+                      pSocket->asyncConnectErrno);
+        }
+    }
+}
+
 // Socket Read/Read-From URC.
 static void UUSORD_UUSORF_urc(const uAtClientHandle_t atHandle,
                               void *pUnused)
 {
+    int32_t values[2];
     int32_t sockHandleModule;
     int32_t dataSizeBytes;
     uCellSockSocket_t *pSocket = NULL;
@@ -321,20 +743,26 @@ static void UUSORD_UUSORF_urc(const uAtClientHandle_t atHandle,
     (void) pUnused;
 
     // +UUSORx: <socket>,<length>
-    sockHandleModule = uAtClientReadInt(atHandle);
-    dataSizeBytes = uAtClientReadInt(atHandle);
+    uAtClientReadIntList(atHandle, values, sizeof(values) / sizeof(values[0]), 0);
+    sockHandleModule = values[0];
+    dataSizeBytes = values[1];
 
     if (sockHandleModule >= 0) {
         // Find the entry
         pSocket = pFindBySockHandleModule(atHandle,
                                           sockHandleModule);
         if (pSocket != NULL) {
-            // Call the user call-back via the trampoline
+            // Mark the socket's data callback as pending and
+            // call the scheduler, which decides the order in
+            // which the data callbacks of all the sockets with
+            // data waiting are called; this goes on the data lane
+            // of the callback queue so that a burst of URCs
+            // results in only one call to the scheduler
             if ((dataSizeBytes > 0) &&
                 (pSocket->pDataCallback != NULL)) {
-                uAtClientCallback(atHandle,
-                                  dataCallback,
-                                  (void *) (pSocket->sockHandle));
+                pSocket->dataCallbackPending = true;
+                uAtClientCallbackData(atHandle,
+                                      dataScheduleCallback, NULL);
             }
             pSocket->pendingBytes = dataSizeBytes;
         }
@@ -358,14 +786,47 @@ static void UUSOCL_urc(const uAtClientHandle_t atHandle,
                                           sockHandleModule);
         if (pSocket != NULL) {
             if (pSocket->pClosedCallback != NULL) {
-                uAtClientCallback(atHandle,
-                                  closedCallback,
-                                  (void *) (pSocket->sockHandle));
+                // On the data lane, like dataCallback, so that
+                // this is not run ahead of a data callback for
+                // the same socket
+                uAtClientCallbackData(atHandle,
+                                      closedCallback,
+                                      (void *) (intptr_t) (pSocket->sockHandle));
             }
         }
     }
 }
 
+// Callback for Socket Connect URC, the result of an
+// asynchronous connection.
+static void UUSOCO_urc(const uAtClientHandle_t atHandle,
+                       void *pUnused)
+{
+    int32_t values[2];
+    uCellSockSocket_t *pSocket = NULL;
+
+    (void) pUnused;
+
+    // +UUSOCO: <socket>,<socket_error>
+    uAtClientReadIntList(atHandle, values, sizeof(values) / sizeof(values[0]), 0);
+    if (values[0] >= 0) {
+        // Find the entry
+        pSocket = pFindBySockHandleModule(atHandle, values[0]);
+        if ((pSocket != NULL) && (pSocket->pAsyncConnectCallback != NULL)) {
+            // The module's socket error codes are not errno
+            // values, just report a failure as a blocking
+            // uCellSockConnect() would
+            pSocket->asyncConnectErrno = U_SOCK_ENONE;
+            if (values[1] != 0) {
+                pSocket->asyncConnectErrno = U_SOCK_EHOSTUNREACH;
+            }
+            // Not on the data lane, this is a one-off
+            uAtClientCallback(atHandle, connectCallback,
+                              (void *) (intptr_t) (pSocket->sockHandle));
+        }
+    }
+}
+
 /* ----------------------------------------------------------------
  * MORE VARIABLES
  * -------------------------------------------------------------- */
@@ -375,7 +836,8 @@ static void UUSOCL_urc(const uAtClientHandle_t atHandle,
 static const uCellSockUrcHandler_t gUrcHandlers[] = {
     {"+UUSORD:", UUSORD_UUSORF_urc},
     {"+UUSORF:", UUSORD_UUSORF_urc},
-    {"+UUSOCL:", UUSOCL_urc}
+    {"+UUSOCL:", UUSOCL_urc},
+    {"+UUSOCO:", UUSOCO_urc}
 };
 
 /* ----------------------------------------------------------------
@@ -571,6 +1033,123 @@ static int32_t getOptionLinger(const uCellSockSocket_t *pSocket,
     return errnoLocal;
 }
 
+// Set the read priority socket option, returning a
+// (non-negated) value of U_SOCK_Exxx.
+static int32_t setOptionReadPriority(uCellSockSocket_t *pSocket,
+                                     const void *pOptionValue,
+                                     size_t optionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+    int32_t priority;
+
+    if ((pOptionValue != NULL) &&
+        (optionValueLength == sizeof(int32_t))) {
+        priority = *((const int32_t *) pOptionValue);
+        if ((priority >= 0) && (priority <= U_SOCK_OPT_READ_PRIORITY_MAX)) {
+            pSocket->readPriority = priority;
+            errnoLocal = U_SOCK_ENONE;
+        }
+    }
+
+    return errnoLocal;
+}
+
+// Get the read priority socket option, returning a
+// (non-negated) value of U_SOCK_Exxx.
+static int32_t getOptionReadPriority(const uCellSockSocket_t *pSocket,
+                                     void *pOptionValue,
+                                     size_t *pOptionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+
+    if (pOptionValueLength != NULL) {
+        if (pOptionValue != NULL) {
+            if (*pOptionValueLength >= sizeof(int32_t)) {
+                errnoLocal = U_SOCK_ENONE;
+                *((int32_t *) pOptionValue) = pSocket->readPriority;
+                *pOptionValueLength = sizeof(int32_t);
+            }
+        } else {
+            errnoLocal = U_SOCK_ENONE;
+            // Caller just wants to know the length required
+            *pOptionValueLength = sizeof(int32_t);
+        }
+    }
+
+    return errnoLocal;
+}
+
+// Set the read-ahead socket option, returning a
+// (non-negated) value of U_SOCK_Exxx.
+static int32_t setOptionReadAhead(uCellSockSocket_t *pSocket,
+                                  const void *pOptionValue,
+                                  size_t optionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+    uCellSockReadAhead_t *pReadAhead = pSocket->pReadAhead;
+    int32_t size;
+
+    if ((pOptionValue != NULL) &&
+        (optionValueLength == sizeof(int32_t))) {
+        size = *((const int32_t *) pOptionValue);
+        if ((size >= 0) && (size <= U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES)) {
+            errnoLocal = U_SOCK_ENONE;
+            if ((pReadAhead != NULL) &&
+                (pReadAhead->readIndex != pReadAhead->writeIndex)) {
+                // Mustn't lose unread data
+                if ((size_t) size != pReadAhead->size) {
+                    errnoLocal = U_SOCK_EBUSY;
+                }
+            } else if ((pReadAhead == NULL) || ((size_t) size != pReadAhead->size)) {
+                free(pReadAhead);
+                pSocket->pReadAhead = NULL;
+                if (size > 0) {
+                    pReadAhead = (uCellSockReadAhead_t *) malloc(sizeof(uCellSockReadAhead_t) +
+                                                                 size);
+                    if (pReadAhead != NULL) {
+                        pReadAhead->size = (size_t) size;
+                        pReadAhead->readIndex = 0;
+                        pReadAhead->writeIndex = 0;
+                        pSocket->pReadAhead = pReadAhead;
+                    } else {
+                        errnoLocal = U_SOCK_ENOMEM;
+                    }
+                }
+            }
+        }
+    }
+
+    return errnoLocal;
+}
+
+// Get the read-ahead socket option, returning a
+// (non-negated) value of U_SOCK_Exxx.
+static int32_t getOptionReadAhead(const uCellSockSocket_t *pSocket,
+                                  void *pOptionValue,
+                                  size_t *pOptionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+
+    if (pOptionValueLength != NULL) {
+        if (pOptionValue != NULL) {
+            if (*pOptionValueLength >= sizeof(int32_t)) {
+                errnoLocal = U_SOCK_ENONE;
+                *((int32_t *) pOptionValue) = 0;
+                if (pSocket->pReadAhead != NULL) {
+                    *((int32_t *) pOptionValue) = (int32_t) pSocket->pReadAhead->size;
+                }
+                *pOptionValueLength = sizeof(int32_t);
+            }
+        } else {
+            errnoLocal = U_SOCK_ENONE;
+            // Caller just wants to know the length required
+            *pOptionValueLength = sizeof(int32_t);
+        }
+    }
+
+    return errnoLocal;
+}
+
 // Set hex mode on the underlying AT interface on or off.
 int32_t setHexMode(uDeviceHandle_t cellHandle, bool hexModeOnNotOff)
 {
@@ -607,6 +1186,289 @@ int32_t setHexMode(uDeviceHandle_t cellHandle, bool hexModeOnNotOff)
  * STATIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
 
+// Write length bytes, from offset bytes into the data described by
+// an I/O vector, either to the AT client as binary or, if pHexBuffer
+// is not NULL, hex coded into pHexBuffer (without a terminator).
+// Returns the number of bytes of data written, which will be less
+// than length only if the I/O vector runs out.
+static size_t ioVecWrite(uAtClientHandle_t atHandle,
+                         const uSockIoVec_t *pIoVec, size_t numIoVec,
+                         size_t offset, size_t length, char *pHexBuffer)
+{
+    size_t written = 0;
+    size_t thisLength;
+    const char *pData;
+
+    for (size_t x = 0; (x < numIoVec) && (written < length); x++) {
+        if (offset >= (pIoVec + x)->length) {
+            // Not there yet
+            offset -= (pIoVec + x)->length;
+        } else {
+            pData = (const char *) (pIoVec + x)->pBase + offset;
+            thisLength = (pIoVec + x)->length - offset;
+            if (thisLength > length - written) {
+                thisLength = length - written;
+            }
+            if (pHexBuffer != NULL) {
+                uBinToHex(pData, thisLength, pHexBuffer + (written * 2));
+            } else {
+                uAtClientWriteBytes(atHandle, pData, thisLength, true);
+            }
+            written += thisLength;
+            offset = 0;
+        }
+    }
+
+    return written;
+}
+
+// Send a datagram, gathered from an I/O vector, with AT+USOST;
+// the AT client must be locked.  Returns the number of bytes sent
+// or negated U_SOCK_Exxx, any AT error being left in the AT client
+// for the caller.
+static int32_t usost(const uCellPrivateInstance_t *pInstance,
+                     const uCellSockSocket_t *pSocket,
+                     const uSockAddress_t *pRemoteAddress,
+                     const uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t negErrnoLocalOrSize = -U_SOCK_EINVAL;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    char buffer[U_SOCK_ADDRESS_STRING_MAX_LENGTH_BYTES];
+    char *pRemoteIpAddress;
+    size_t dataLengthMax = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
+    int32_t sentSize = 0;
+    size_t x;
+    bool written = false;
+    int32_t values[2];
+    char *pHexBuffer = NULL;
+    int32_t dataSizeBytes = uSockIoVecLength(pIoVec, numIoVec);
+
+    if (pInstance->socketsHexMode) {
+        dataLengthMax /= 2;
+    }
+    if (dataSizeBytes >= 0) {
+        negErrnoLocalOrSize = -U_SOCK_EDESTADDRREQ;
+        if (uSockAddressToString(pRemoteAddress, buffer,
+                                 sizeof(buffer)) > 0) {
+            pRemoteIpAddress = pUSockDomainRemovePort(buffer);
+            if (pRemoteIpAddress != NULL) {
+                negErrnoLocalOrSize = -U_SOCK_EMSGSIZE;
+                if ((size_t) dataSizeBytes <= dataLengthMax) {
+                    if (pInstance->socketsHexMode) {
+                        negErrnoLocalOrSize = -U_SOCK_ENOMEM;
+                        pHexBuffer = (char *) malloc(dataSizeBytes * 2 + 1);  // +1 for terminator
+                        if (pHexBuffer != NULL) {
+                            // Make the hex-coded null terminated string
+                            x = ioVecWrite(atHandle, pIoVec, numIoVec,
+                                           0, dataSizeBytes, pHexBuffer);
+                            *(pHexBuffer + (x * 2)) = 0;
+                        }
+                    }
+                    if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
+                        negErrnoLocalOrSize = -U_SOCK_EIO;
+                        uAtClientCommandStart(atHandle, "AT+USOST=");
+                        // Write module socket handle
+                        uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
+                        // Write IP address
+                        uAtClientWriteString(atHandle, pRemoteIpAddress, true);
+                        // Write port number
+                        uAtClientWriteInt(atHandle, pRemoteAddress->port);
+                        // Number of bytes to follow
+                        uAtClientWriteInt(atHandle, dataSizeBytes);
+                        if (pHexBuffer) {
+                            // Send the hex mode data as a string
+                            uAtClientWriteString(atHandle, pHexBuffer, true);
+                            uAtClientCommandStop(atHandle);
+                            // Free the buffer
+                            free(pHexBuffer);
+                            written = true;
+                        } else {
+                            // Not in hex mode, wait for the prompt
+                            uAtClientCommandStop(atHandle);
+                            if (uAtClientWaitCharacter(atHandle, '@') == 0) {
+                                // Wait for it...
+                                uPortTaskBlock(50);
+                                // Send the binary data, all
+                                // fragments in the one go
+                                ioVecWrite(atHandle, pIoVec, numIoVec,
+                                           0, dataSizeBytes, NULL);
+                                written = true;
+                            }
+                        }
+                        if (written) {
+                            // Grab the response
+                            uAtClientResponseStart(atHandle, "+USOST:");
+                            // Skip the socket ID, then: bytes sent
+                            uAtClientReadIntList(atHandle, values, 2,
+                                                 U_AT_CLIENT_READ_INT_LIST_SKIP(0, 1));
+                            sentSize = values[1];
+                            uAtClientResponseStop(atHandle);
+                            if ((uAtClientErrorGet(atHandle) == 0) &&
+                                (sentSize >= 0)) {
+                                // All is good, probably
+                                negErrnoLocalOrSize = sentSize;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Ask the module, with a zero-length AT+USORF, how much received
+// data is waiting on a UDP socket, updating pendingBytes; the AT
+// client must be locked.
+static void usorfPendingGet(uCellSockSocket_t *pSocket)
+{
+    uAtClientHandle_t atHandle = pSocket->atHandle;
+    int32_t values[2];
+    int32_t x;
+
+    // Zero bytes to read, just want to know the number
+    // of bytes waiting
+    uAtClientCommandPrepared(atHandle, &gUsorf, pSocket->sockHandleModule,
+                             (int32_t) 0);
+    uAtClientResponseStart(atHandle, "+USORF:");
+    // Skip the socket ID, then: read the amount of data
+    uAtClientReadIntList(atHandle, values, 2,
+                         U_AT_CLIENT_READ_INT_LIST_SKIP(0, 1));
+    x = values[1];
+    uAtClientResponseStop(atHandle);
+    // Update pending bytes here, before the caller
+    // unlocks, as otherwise a data callback
+    // triggered by a URC could be sitting waiting
+    // to grab the AT lock and jump in before
+    // pending bytes has been updated, leading it
+    // back into here again, etc, etc.
+    if (x > 0) {
+        pSocket->pendingBytes = x;
+        // DON'T call the user data callback here:
+        // we already have the AT interface locked
+        // and a user might try to call back into
+        // here which would result in deadlock.
+        // They will get their received data, there
+        // is no need to worry.
+    }
+}
+
+// Receive a datagram with AT+USORF; the AT client must be locked.
+// Returns the number of bytes received or negated U_SOCK_Exxx, any
+// AT error being left in the AT client for the caller.
+static int32_t usorf(const uCellPrivateInstance_t *pInstance,
+                     uCellSockSocket_t *pSocket,
+                     uSockAddress_t *pRemoteAddress,
+                     char *pData, size_t dataSizeBytes)
+{
+    int32_t negErrnoLocalOrSize = -U_SOCK_EIO;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    int32_t dataLengthMax = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
+    char buffer[U_SOCK_ADDRESS_STRING_MAX_LENGTH_BYTES];
+    int32_t port = -1;
+    int32_t receivedSize = -1;
+    int32_t values[2];
+
+    buffer[0] = 0;  // In case of slip-ups
+
+    // Note: the real maximum length of UDP packet we can receive
+    // comes from fitting all of the following into one buffer:
+    //
+    // +USORF: xx,"max.len.ip.address.ipv4.or.ipv6",yyyyy,wwww,"the_data"\r\n
+    //
+    // where xx is the handle, max.len.ip.address.ipv4.or.ipv6 is NSAPI_IP_SIZE,
+    // yyyyy is the port number (max 65536), wwww is the length of the data and
+    // the_data is binary data. I make that 29 + 48 + len(the_data),
+    // so the overhead is 77 bytes.
+
+    if (pInstance->socketsHexMode) {
+        dataLengthMax /= 2;
+    }
+
+    // In the UDP case we HAVE to read the number
+    // of bytes pending as this will be the size
+    // of the next UDP packet in the module and the
+    // module can only deliver whole UDP packets.
+    // Socket handle then number of bytes to read
+    uAtClientCommandPrepared(atHandle, &gUsorf, pSocket->sockHandleModule,
+                             (int32_t) dataLengthMax);
+    uAtClientResponseStart(atHandle, "+USORF:");
+    // Skip the socket ID
+    uAtClientSkipParameters(atHandle, 1);
+    // Read the IP address
+    uAtClientReadString(atHandle, buffer,
+                        sizeof(buffer), false);
+    // Read the port and the amount of data
+    uAtClientReadIntList(atHandle, values, 2, 0);
+    port = values[0];
+    receivedSize = values[1];
+    if (receivedSize > dataLengthMax) {
+        receivedSize = dataLengthMax;
+    }
+    if ((int32_t) dataSizeBytes > receivedSize) {
+        dataSizeBytes = receivedSize;
+    }
+    if (receivedSize > 0) {
+        if (pInstance->socketsHexMode) {
+            // Decode the hex straight into pData
+            readHex(atHandle, pData, dataSizeBytes, receivedSize);
+        } else {
+            // Binary mode, don't stop for anything!
+            uAtClientIgnoreStopTag(atHandle);
+            // Get the leading quote mark out of the way
+            uAtClientReadBytes(atHandle, NULL, 1, true);
+            // Now read out all the actual data,
+            // first the bit we want
+            uAtClientReadBytes(atHandle, pData, dataSizeBytes, true);
+            if (receivedSize > (int32_t) dataSizeBytes) {
+                //...and then the rest poured away to NULL
+                uAtClientReadBytes(atHandle, NULL,
+                                   receivedSize -
+                                   dataSizeBytes, true);
+            }
+            // Make sure to wait for the stop tag before
+            // we finish
+            uAtClientRestoreStopTag(atHandle);
+        }
+    }
+    uAtClientResponseStop(atHandle);
+    // BEFORE the caller unlocks, work out what's happened.
+    // This is to prevent a URC being processed that
+    // may indicate data left and over-write pendingBytes
+    // while we're also writing to it.
+    if ((uAtClientErrorGet(atHandle) == 0) &&
+        (receivedSize >= 0)) {
+        // Must use what +USORF returns here as it may be less
+        // or more than we asked for and also may be
+        // more than pendingBytes, depending on how
+        // the URCs landed
+        // This update of pendingBytes will be overwritten
+        // by the URC but we have to do something here
+        // 'cos we don't get a URC to tell us when pendingBytes
+        // has gone to zero.
+        if (receivedSize > pSocket->pendingBytes) {
+            pSocket->pendingBytes = 0;
+        } else {
+            pSocket->pendingBytes -= receivedSize;
+        }
+        negErrnoLocalOrSize = receivedSize;
+    }
+
+    if ((negErrnoLocalOrSize >= 0) && (pRemoteAddress != NULL) && (port >= 0)) {
+        if (uSockStringToAddress(buffer, pRemoteAddress) == 0) {
+            pRemoteAddress->port = (uint16_t) port;
+        } else {
+            // If we can't decode the remote address this becomes
+            // an error, can't go receiving things from servers
+            // we know not who they are
+            negErrnoLocalOrSize = -U_SOCK_EIO;
+        }
+    }
+
+    return negErrnoLocalOrSize;
+}
+
 // Do AT+USOCTL for an operation with an integer return value.
 static int32_t doUsoctl(uDeviceHandle_t cellHandle, int32_t sockHandle,
                         int32_t operation)
@@ -624,7 +1486,10 @@ static int32_t doUsoctl(uDeviceHandle_t cellHandle, int32_t sockHandle,
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
+            if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to the direct link
+                negErrnoLocallOrValue = -U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
                 negErrnoLocallOrValue = -U_SOCK_EIO;
                 // Do USOCTL 1 to get the last error code
                 uAtClientLock(atHandle);
@@ -647,7 +1512,385 @@ static int32_t doUsoctl(uDeviceHandle_t cellHandle, int32_t sockHandle,
         }
     }
 
-    return negErrnoLocallOrValue;
+    return negErrnoLocallOrValue;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: DIRECT LINK
+ * -------------------------------------------------------------- */
+
+// The receive intercept for direct link mode.  Until the module
+// has said "CONNECT" everything is passed through to the AT client,
+// so that the AT+USODL response can be handled as normal; from then
+// on everything is written to the buffer of the direct link, where
+// uCellSockRead() will find it, and nothing is passed to the AT
+// client.  If the buffer is full the data is left where it is.
+static char *pInterceptRxDirectLink(uAtClientHandle_t atHandle,
+                                    char **ppData, size_t *pLength,
+                                    void *pContext)
+{
+    uCellSockDirectLink_t *pDirectLink = (uCellSockDirectLink_t *) pContext;
+    const char *pConnect = U_CELL_SOCK_DIRECT_LINK_CONNECT;
+    char *pData = NULL;
+    size_t length = 0;
+    size_t readIndex;
+    size_t writeIndex;
+    size_t thisLength;
+
+    if ((ppData != NULL) && (*pLength > 0)) {
+        pData = *ppData;
+        if (!pDirectLink->connected) {
+            // Pass everything through, up to and including the
+            // end of the "CONNECT" line
+            while ((length < *pLength) && !pDirectLink->connected) {
+                if (*(pData + length) == *(pConnect + pDirectLink->connectMatchLength)) {
+                    pDirectLink->connectMatchLength++;
+                } else {
+                    pDirectLink->connectMatchLength = 0;
+                    if (*(pData + length) == *pConnect) {
+                        pDirectLink->connectMatchLength++;
+                    }
+                }
+                if (pDirectLink->connectMatchLength == strlen(pConnect)) {
+                    pDirectLink->connected = true;
+                }
+                length++;
+            }
+            *pLength = length;
+        } else {
+            // Copy as much as will fit into the buffer, remembering
+            // that one byte must always be left empty
+            readIndex = pDirectLink->readIndex;
+            writeIndex = pDirectLink->writeIndex;
+            while ((length < *pLength) &&
+                   (((writeIndex + 1) % U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES) != readIndex)) {
+                if (writeIndex >= readIndex) {
+                    thisLength = U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES - writeIndex;
+                    if (readIndex == 0) {
+                        thisLength--;
+                    }
+                } else {
+                    thisLength = readIndex - writeIndex - 1;
+                }
+                if (thisLength > *pLength - length) {
+                    thisLength = *pLength - length;
+                }
+                memcpy(pDirectLink->pBuffer + writeIndex, pData + length, thisLength);
+                length += thisLength;
+                writeIndex += thisLength;
+                if (writeIndex >= U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES) {
+                    writeIndex = 0;
+                }
+            }
+            pDirectLink->writeIndex = writeIndex;
+            if (length < *pLength) {
+                pDirectLink->stalled = true;
+            }
+            if (length > 0) {
+                uAtClientCallbackData(atHandle, dataCallback,
+                                      (void *) (intptr_t) pDirectLink->sockHandle);
+            } else {
+                // Couldn't consume anything
+                pData = NULL;
+            }
+            // Nothing for the AT client
+            *pLength = 0;
+        }
+        *ppData += length;
+    } else {
+        // Nothing (more) to give
+        *pLength = 0;
+    }
+
+    return pData;
+}
+
+// Read data received on a socket in direct link mode.
+static int32_t directLinkRead(const uCellSockSocket_t *pSocket,
+                              char *pData, size_t dataSizeBytes)
+{
+    int32_t negErrnoLocalOrSize = -U_SOCK_EWOULDBLOCK;
+    uCellSockDirectLink_t *pDirectLink = pSocket->pDirectLink;
+    size_t readIndex = pDirectLink->readIndex;
+    size_t writeIndex = pDirectLink->writeIndex;
+    size_t length = 0;
+    size_t thisLength;
+    uAtClientStream_t streamType;
+    int32_t streamHandle;
+
+    while ((readIndex != writeIndex) && (length < dataSizeBytes)) {
+        if (writeIndex > readIndex) {
+            thisLength = writeIndex - readIndex;
+        } else {
+            thisLength = U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES - readIndex;
+        }
+        if (thisLength > dataSizeBytes - length) {
+            thisLength = dataSizeBytes - length;
+        }
+        memcpy(pData + length, pDirectLink->pBuffer + readIndex, thisLength);
+        length += thisLength;
+        readIndex += thisLength;
+        if (readIndex >= U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES) {
+            readIndex = 0;
+        }
+    }
+    pDirectLink->readIndex = readIndex;
+
+    if ((length > 0) && pDirectLink->stalled) {
+        // There is now room in the buffer for the data that was
+        // held back: if the stream is a UART, kick the AT client
+        // so that it doesn't have to wait for more data to arrive
+        // before passing it on
+        pDirectLink->stalled = false;
+        streamHandle = uAtClientStreamGet(pSocket->atHandle, &streamType);
+        if (streamType == U_AT_CLIENT_STREAM_TYPE_UART) {
+            uPortUartEventTrySend(streamHandle,
+                                  U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED, 0);
+        }
+    }
+
+    if ((length > 0) || (dataSizeBytes == 0)) {
+        negErrnoLocalOrSize = (int32_t) length;
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Write data gathered from an I/O vector to a socket in direct
+// link mode.
+static int32_t directLinkWritev(const uCellSockSocket_t *pSocket,
+                                const uSockIoVec_t *pIoVec, size_t numIoVec,
+                                size_t dataSizeBytes)
+{
+    int32_t negErrnoLocalOrSize = -U_SOCK_EIO;
+    uAtClientHandle_t atHandle = pSocket->atHandle;
+    size_t written;
+
+    uAtClientLock(atHandle);
+    written = ioVecWrite(atHandle, pIoVec, numIoVec, 0, dataSizeBytes, NULL);
+    pSocket->pDirectLink->lastWriteTimeMs = uPortGetTickTimeMs();
+    if (uAtClientUnlock(atHandle) == 0) {
+        negErrnoLocalOrSize = (int32_t) written;
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Put a socket into direct link mode.
+static int32_t directLinkStart(uCellSockSocket_t *pSocket)
+{
+    int32_t errnoLocal = U_SOCK_ENOMEM;
+    uAtClientHandle_t atHandle = pSocket->atHandle;
+    uCellSockDirectLink_t *pDirectLink;
+
+    // Allocate the state and the buffer in one go
+    pDirectLink = (uCellSockDirectLink_t *) malloc(sizeof(uCellSockDirectLink_t) +
+                                                   U_CELL_SOCK_DIRECT_LINK_BUFFER_LENGTH_BYTES);
+    if (pDirectLink != NULL) {
+        errnoLocal = U_SOCK_EIO;
+        memset(pDirectLink, 0, sizeof(*pDirectLink));
+        pDirectLink->sockHandle = pSocket->sockHandle;
+        pDirectLink->pBuffer = (char *) (pDirectLink + 1);
+        uAtClientLock(atHandle);
+        // Hook in the intercept before sending the command so that
+        // nothing the module sends straight after "CONNECT" is lost
+        uAtClientStreamInterceptRx(atHandle, pInterceptRxDirectLink,
+                                   (void *) pDirectLink);
+        uAtClientCommandStart(atHandle, "AT+USODL=");
+        uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
+        uAtClientCommandStop(atHandle);
+        // There is no "OK" after "CONNECT" so no uAtClientResponseStop()
+        uAtClientResponseStart(atHandle, "CONNECT");
+        if ((uAtClientErrorGet(atHandle) == 0) && pDirectLink->connected) {
+            pDirectLink->lastWriteTimeMs = uPortGetTickTimeMs();
+            pSocket->pDirectLink = pDirectLink;
+            errnoLocal = U_SOCK_ENONE;
+        } else {
+            uAtClientStreamInterceptRx(atHandle, NULL, NULL);
+        }
+        uAtClientUnlock(atHandle);
+        if (errnoLocal != U_SOCK_ENONE) {
+            free(pDirectLink);
+        }
+    }
+
+    return errnoLocal;
+}
+
+// Take a socket out of direct link mode.
+static int32_t directLinkStop(uCellSockSocket_t *pSocket)
+{
+    int32_t errnoLocal = U_SOCK_EIO;
+    uAtClientHandle_t atHandle = pSocket->atHandle;
+    int32_t waitMs;
+
+    // The escape sequence must be preceded by a period of silence
+    waitMs = U_CELL_SOCK_DIRECT_LINK_GUARD_TIME_MS -
+             (uPortGetTickTimeMs() - pSocket->pDirectLink->lastWriteTimeMs);
+    if (waitMs > 0) {
+        uPortTaskBlock(waitMs);
+    }
+    uAtClientLock(atHandle);
+    uAtClientWriteBytes(atHandle, "+++", 3, true);
+    uAtClientUnlock(atHandle);
+    // ...and followed by one
+    uPortTaskBlock(U_CELL_SOCK_DIRECT_LINK_GUARD_TIME_MS);
+    // Unhook the intercept, which also throws away anything
+    // that is left in the receive buffers of the AT client
+    uAtClientLock(atHandle);
+    uAtClientStreamInterceptRx(atHandle, NULL, NULL);
+    uAtClientUnlock(atHandle);
+    free(pSocket->pDirectLink);
+    pSocket->pDirectLink = NULL;
+
+    // Make sure that the module is back in command mode
+    for (size_t x = 3; (x > 0) && (errnoLocal != U_SOCK_ENONE); x--) {
+        uAtClientLock(atHandle);
+        uAtClientCommandStart(atHandle, "AT");
+        uAtClientCommandStopReadResponse(atHandle);
+        if (uAtClientUnlock(atHandle) == 0) {
+            errnoLocal = U_SOCK_ENONE;
+        }
+    }
+
+    return errnoLocal;
+}
+
+// Set the direct link socket option.
+static int32_t setOptionDirectLink(uCellSockSocket_t *pSocket,
+                                   const void *pOptionValue,
+                                   size_t optionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+    uCellSockSocket_t *pSocketDirectLink;
+
+    if ((pOptionValue != NULL) &&
+        (optionValueLength == sizeof(int32_t))) {
+        errnoLocal = U_SOCK_ENONE;
+        pSocketDirectLink = pFindDirectLink(pSocket->cellHandle);
+        if (*((const int32_t *) pOptionValue) != 0) {
+            if (pSocketDirectLink == NULL) {
+                errnoLocal = directLinkStart(pSocket);
+            } else if (pSocketDirectLink != pSocket) {
+                errnoLocal = U_SOCK_EBUSY;
+            }
+        } else {
+            if (pSocketDirectLink == pSocket) {
+                errnoLocal = directLinkStop(pSocket);
+            }
+        }
+    }
+
+    return errnoLocal;
+}
+
+// Get the direct link socket option.
+static int32_t getOptionDirectLink(const uCellSockSocket_t *pSocket,
+                                   void *pOptionValue,
+                                   size_t *pOptionValueLength)
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+
+    if (pOptionValueLength != NULL) {
+        if (pOptionValue != NULL) {
+            if (*pOptionValueLength >= sizeof(int32_t)) {
+                errnoLocal = U_SOCK_ENONE;
+                *((int32_t *) pOptionValue) = (pSocket->pDirectLink != NULL);
+                *pOptionValueLength = sizeof(int32_t);
+            }
+        } else {
+            errnoLocal = U_SOCK_ENONE;
+            // Caller just wants to know the length required
+            *pOptionValueLength = sizeof(int32_t);
+        }
+    }
+
+    return errnoLocal;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: CONNECT
+ * -------------------------------------------------------------- */
+
+// Connect a socket, asynchronously if pCallback is non-NULL, in
+// which case the module must support asynchronous connection.
+static int32_t connectSocket(uDeviceHandle_t cellHandle,
+                             int32_t sockHandle,
+                             const uSockAddress_t *pRemoteAddress,
+                             void (*pCallback) (uDeviceHandle_t,
+                                                int32_t,
+                                                int32_t))
+{
+    int32_t errnoLocal = U_SOCK_EINVAL;
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+    uAtClientDeviceError_t deviceError;
+    uCellSockSocket_t *pSocket;
+    char buffer[U_SOCK_ADDRESS_STRING_MAX_LENGTH_BYTES];
+    char *pRemoteIpAddress;
+
+    // Find the instance
+    pInstance = pUCellPrivateGetInstance(cellHandle);
+    if (pInstance != NULL) {
+        atHandle = pInstance->atHandle;
+        // Find the entry
+        if (sockHandle >= 0) {
+            pSocket = pFindBySockHandle(sockHandle);
+            if ((pSocket != NULL) &&
+                (uSockAddressToString(pRemoteAddress, buffer,
+                                      sizeof(buffer)) > 0)) {
+                pRemoteIpAddress = pUSockDomainRemovePort(buffer);
+                errnoLocal = U_SOCK_EHOSTUNREACH;
+                // Connect the socket through the cellular module
+                // If have seen modules return ERROR to this
+                // immediately so try a few times
+                deviceError.type = U_AT_CLIENT_DEVICE_ERROR_TYPE_ERROR;
+                for (size_t x = 3; (x > 0) &&
+                     (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR);
+                     x--) {
+                    // Set the callback before sending the command
+                    // since the +UUSOCO URC may arrive at any time
+                    // after the OK
+                    pSocket->pAsyncConnectCallback = pCallback;
+                    uAtClientLock(atHandle);
+                    if (pCallback == NULL) {
+                        // Leave a little longer to connect
+                        uAtClientTimeoutSet(atHandle,
+                                            U_CELL_SOCK_CONNECT_TIMEOUT_SECONDS * 1000);
+                    }
+                    uAtClientCommandStart(atHandle, "AT+USOCO=");
+                    // Write module socket handle
+                    uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
+                    // Write IP address
+                    uAtClientWriteString(atHandle, pRemoteIpAddress, true);
+                    // Write port number
+                    uAtClientWriteInt(atHandle, pRemoteAddress->port);
+                    if (pCallback != NULL) {
+                        // Ask for the result to be reported
+                        // later with a +UUSOCO URC
+                        uAtClientWriteInt(atHandle, 1);
+                    }
+                    uAtClientCommandStopReadResponse(atHandle);
+                    uAtClientDeviceErrorGet(atHandle, &deviceError);
+                    if (uAtClientUnlock(atHandle) == 0) {
+                        // All good
+                        errnoLocal = U_SOCK_ENONE;
+                    } else {
+                        pSocket->pAsyncConnectCallback = NULL;
+                    }
+                    if (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR) {
+                        // Got an AT interace error, see
+                        // what the module's socket error
+                        // number has to say for debug purposes
+                        doUsoer(atHandle);
+                        uPortTaskBlock(1000);
+                    }
+                }
+            }
+        }
+    }
+
+    return -errnoLocal;
 }
 
 /* ----------------------------------------------------------------
@@ -670,6 +1913,11 @@ int32_t uCellSockInit()
             pSock->pendingBytes = 0;
             pSock->pDataCallback = NULL;
             pSock->pClosedCallback = NULL;
+            pSock->pDirectLink = NULL;
+            pSock->readPriority = 0;
+            pSock->readWaitCount = 0;
+            pSock->dataCallbackPending = false;
+            pSock->pReadAhead = NULL;
         }
 
         gInitialised = true;
@@ -733,7 +1981,10 @@ int32_t uCellSockCreate(uDeviceHandle_t cellHandle,
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
-    if (pInstance != NULL) {
+    if ((pInstance != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+        // The AT interface belongs to the direct link
+        negErrnoLocal = -U_SOCK_EBUSY;
+    } else if (pInstance != NULL) {
         negErrnoLocal = -U_SOCK_ENOBUFS;
         atHandle = pInstance->atHandle;
         // Create the entry
@@ -778,63 +2029,31 @@ int32_t uCellSockConnect(uDeviceHandle_t cellHandle,
                          int32_t sockHandle,
                          const uSockAddress_t *pRemoteAddress)
 {
-    int32_t errnoLocal = U_SOCK_EINVAL;
+    return connectSocket(cellHandle, sockHandle, pRemoteAddress, NULL);
+}
+
+// Connect to a server asynchronously.
+int32_t uCellSockConnectAsync(uDeviceHandle_t cellHandle,
+                              int32_t sockHandle,
+                              const uSockAddress_t *pRemoteAddress,
+                              void (*pCallback) (uDeviceHandle_t,
+                                                 int32_t,
+                                                 int32_t))
+{
+    int32_t negErrnoLocal = -U_SOCK_EINVAL;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
-    uAtClientDeviceError_t deviceError;
-    uCellSockSocket_t *pSocket;
-    char buffer[U_SOCK_ADDRESS_STRING_MAX_LENGTH_BYTES];
-    char *pRemoteIpAddress;
 
-    // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
-    if (pInstance != NULL) {
-        atHandle = pInstance->atHandle;
-        // Find the entry
-        if (sockHandle >= 0) {
-            pSocket = pFindBySockHandle(sockHandle);
-            if ((pSocket != NULL) &&
-                (uSockAddressToString(pRemoteAddress, buffer,
-                                      sizeof(buffer)) > 0)) {
-                pRemoteIpAddress = pUSockDomainRemovePort(buffer);
-                errnoLocal = U_SOCK_EHOSTUNREACH;
-                // Connect the socket through the cellular module
-                // If have seen modules return ERROR to this
-                // immediately so try a few times
-                deviceError.type = U_AT_CLIENT_DEVICE_ERROR_TYPE_ERROR;
-                for (size_t x = 3; (x > 0) &&
-                     (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR);
-                     x--) {
-                    uAtClientLock(atHandle);
-                    // Leave a little longer to connect
-                    uAtClientTimeoutSet(atHandle,
-                                        U_CELL_SOCK_CONNECT_TIMEOUT_SECONDS * 1000);
-                    uAtClientCommandStart(atHandle, "AT+USOCO=");
-                    // Write module socket handle
-                    uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                    // Write IP address
-                    uAtClientWriteString(atHandle, pRemoteIpAddress, true);
-                    // Write port number
-                    uAtClientWriteInt(atHandle, pRemoteAddress->port);
-                    uAtClientCommandStopReadResponse(atHandle);
-                    uAtClientDeviceErrorGet(atHandle, &deviceError);
-                    if (uAtClientUnlock(atHandle) == 0) {
-                        // All good
-                        errnoLocal = U_SOCK_ENONE;
-                    }
-                    if (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR) {
-                        // Got an AT interace error, see
-                        // what the module's socket error
-                        // number has to say for debug purposes
-                        doUsoer(atHandle);
-                        uPortTaskBlock(1000);
-                    }
-                }
-            }
+    if ((pInstance != NULL) && (pCallback != NULL)) {
+        negErrnoLocal = -U_SOCK_ENOSYS;
+        if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                               U_CELL_PRIVATE_FEATURE_ASYNC_SOCK_CONNECT)) {
+            negErrnoLocal = connectSocket(cellHandle, sockHandle,
+                                          pRemoteAddress, pCallback);
         }
     }
 
-    return -errnoLocal;
+    return negErrnoLocal;
 }
 
 // Close a socket.
@@ -857,7 +2076,15 @@ int32_t uCellSockClose(uDeviceHandle_t cellHandle,
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
+            if ((pSocket != NULL) && (pSocket->pDirectLink != NULL)) {
+                // Leave direct link mode before closing
+                directLinkStop(pSocket);
+            }
+            if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to the direct link
+                // of another socket
+                errnoLocal = U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
                 errnoLocal = U_SOCK_EIO;
                 // Close the socket through the cellular module
                 // If have seen modules return ERROR to this
@@ -900,8 +2127,8 @@ int32_t uCellSockClose(uDeviceHandle_t cellHandle,
                         // was given and the the module
                         // doesn't support asynchronous closure,
                         // call the trampoline from here
-                        uAtClientCallback(atHandle, closedCallback,
-                                          (void *) sockHandle);
+                        uAtClientCallbackData(atHandle, closedCallback,
+                                              (void *) (intptr_t) sockHandle);
                     }
                 } else {
                     // Got an AT interace error, see
@@ -966,7 +2193,14 @@ int32_t uCellSockOptionSet(uDeviceHandle_t cellHandle,
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
+            if ((pSocket != NULL) && (level == U_SOCK_OPT_LEVEL_SOCK) &&
+                (option == U_SOCK_OPT_DIRECT_LINK)) {
+                errnoLocal = setOptionDirectLink(pSocket, pOptionValue,
+                                                 optionValueLength);
+            } else if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to the direct link
+                errnoLocal = U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
                 if ((optionValueLength == 0) ||
                     ((optionValueLength > 0) && (pOptionValue != NULL))) {
                     switch (level) {
@@ -988,6 +2222,16 @@ int32_t uCellSockOptionSet(uDeviceHandle_t cellHandle,
                                     errnoLocal = setOptionLinger(pSocket, pOptionValue,
                                                                  optionValueLength);
                                     break;
+                                // The read priority, which is local
+                                case U_SOCK_OPT_READ_PRIORITY:
+                                    errnoLocal = setOptionReadPriority(pSocket, pOptionValue,
+                                                                       optionValueLength);
+                                    break;
+                                // The read-ahead cache, also local
+                                case U_SOCK_OPT_READ_AHEAD:
+                                    errnoLocal = setOptionReadAhead(pSocket, pOptionValue,
+                                                                    optionValueLength);
+                                    break;
                                 default:
                                     break;
                             }
@@ -1051,7 +2295,14 @@ int32_t uCellSockOptionGet(uDeviceHandle_t cellHandle,
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
+            if ((pSocket != NULL) && (level == U_SOCK_OPT_LEVEL_SOCK) &&
+                (option == U_SOCK_OPT_DIRECT_LINK)) {
+                errnoLocal = getOptionDirectLink(pSocket, pOptionValue,
+                                                 pOptionValueLength);
+            } else if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to the direct link
+                errnoLocal = U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
                 // If there's an optionValue then there must be a length
                 if ((pOptionValue == NULL) ||
                     (pOptionValueLength != NULL)) {
@@ -1074,6 +2325,16 @@ int32_t uCellSockOptionGet(uDeviceHandle_t cellHandle,
                                     errnoLocal = getOptionLinger(pSocket, pOptionValue,
                                                                  pOptionValueLength);
                                     break;
+                                // The read priority, which is local
+                                case U_SOCK_OPT_READ_PRIORITY:
+                                    errnoLocal = getOptionReadPriority(pSocket, pOptionValue,
+                                                                       pOptionValueLength);
+                                    break;
+                                // The read-ahead cache, also local
+                                case U_SOCK_OPT_READ_AHEAD:
+                                    errnoLocal = getOptionReadAhead(pSocket, pOptionValue,
+                                                                    pOptionValueLength);
+                                    break;
                                 default:
                                     break;
                             }
@@ -1136,7 +2397,10 @@ int32_t uCellSockSecure(uDeviceHandle_t cellHandle,
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
+            if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to the direct link
+                negErrnoLocal = -U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
                 // Apply the profile in the cellular module
                 uAtClientLock(atHandle);
                 uAtClientCommandStart(atHandle, "AT+USOSEC=");
@@ -1221,97 +2485,41 @@ int32_t uCellSockSendTo(uDeviceHandle_t cellHandle,
                         int32_t sockHandle,
                         const uSockAddress_t *pRemoteAddress,
                         const void *pData, size_t dataSizeBytes)
+{
+    uSockIoVec_t ioVec;
+
+    ioVec.pBase = (void *) pData;
+    ioVec.length = dataSizeBytes;
+
+    return uCellSockSendTov(cellHandle, sockHandle, pRemoteAddress,
+                            &ioVec, 1);
+}
+
+// Send a datagram gathered from an I/O vector.
+int32_t uCellSockSendTov(uDeviceHandle_t cellHandle,
+                         int32_t sockHandle,
+                         const uSockAddress_t *pRemoteAddress,
+                         const uSockIoVec_t *pIoVec, size_t numIoVec)
 {
     int32_t negErrnoLocalOrSize = -U_SOCK_EINVAL;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
     uCellSockSocket_t *pSocket;
-    char buffer[U_SOCK_ADDRESS_STRING_MAX_LENGTH_BYTES];
-    char *pRemoteIpAddress;
-    size_t dataLengthMax = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
-    int32_t sentSize = 0;
-    size_t x;
-    bool written = false;
-    char *pHexBuffer = NULL;
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
-    if (pInstance != NULL) {
-        atHandle = pInstance->atHandle;
-        if (pInstance->socketsHexMode) {
-            dataLengthMax /= 2;
-        }
+    if ((pInstance != NULL) && (uSockIoVecLength(pIoVec, numIoVec) >= 0)) {
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
-                negErrnoLocalOrSize = -U_SOCK_EDESTADDRREQ;
-                if (uSockAddressToString(pRemoteAddress, buffer,
-                                         sizeof(buffer)) > 0) {
-                    pRemoteIpAddress = pUSockDomainRemovePort(buffer);
-                    if (pRemoteIpAddress != NULL) {
-                        negErrnoLocalOrSize = -U_SOCK_EMSGSIZE;
-                        if (dataSizeBytes <= dataLengthMax) {
-                            if (pInstance->socketsHexMode) {
-                                negErrnoLocalOrSize = -U_SOCK_ENOMEM;
-                                pHexBuffer = (char *) malloc(dataSizeBytes * 2 + 1);  // +1 for terminator
-                                if (pHexBuffer != NULL) {
-                                    // Make the hex-coded null terminated string
-                                    x = uBinToHex((const char *) pData, dataSizeBytes, pHexBuffer);
-                                    *(pHexBuffer + x) = 0;
-                                }
-                            }
-                            if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
-                                negErrnoLocalOrSize = -U_SOCK_EIO;
-                                uAtClientLock(atHandle);
-                                uAtClientCommandStart(atHandle, "AT+USOST=");
-                                // Write module socket handle
-                                uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                                // Write IP address
-                                uAtClientWriteString(atHandle, pRemoteIpAddress, true);
-                                // Write port number
-                                uAtClientWriteInt(atHandle, pRemoteAddress->port);
-                                // Number of bytes to follow
-                                uAtClientWriteInt(atHandle, (int32_t) dataSizeBytes);
-                                if (pHexBuffer) {
-                                    // Send the hex mode data as a string
-                                    uAtClientWriteString(atHandle, pHexBuffer, true);
-                                    uAtClientCommandStop(atHandle);
-                                    // Free the buffer
-                                    free(pHexBuffer);
-                                    written = true;
-                                } else {
-                                    // Not in hex mode, wait for the prompt
-                                    uAtClientCommandStop(atHandle);
-                                    if (uAtClientWaitCharacter(atHandle, '@') == 0) {
-                                        // Wait for it...
-                                        uPortTaskBlock(50);
-                                        // Send the binary data
-                                        uAtClientWriteBytes(atHandle, (const char *) pData,
-                                                            dataSizeBytes, true);
-                                        written = true;
-                                    }
-                                }
-                                if (written) {
-                                    // Grab the response
-                                    uAtClientResponseStart(atHandle, "+USOST:");
-                                    // Skip the socket ID
-                                    uAtClientSkipParameters(atHandle, 1);
-                                    // Bytes sent
-                                    sentSize = uAtClientReadInt(atHandle);
-                                    uAtClientResponseStop(atHandle);
-                                    if ((uAtClientUnlock(atHandle) == 0) &&
-                                        (sentSize >= 0)) {
-                                        // All is good, probably
-                                        negErrnoLocalOrSize = sentSize;
-                                    }
-                                } else {
-                                    uAtClientUnlock(atHandle);
-                                }
-                            }
-                        }
-                    }
-                }
+            if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to a direct link and
+                // a direct link has no addressing
+                negErrnoLocalOrSize = -U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
+                uAtClientLock(pInstance->atHandle);
+                negErrnoLocalOrSize = usost(pInstance, pSocket, pRemoteAddress,
+                                            pIoVec, numIoVec);
+                uAtClientUnlock(pInstance->atHandle);
             }
         }
     }
@@ -1329,183 +2537,153 @@ int32_t uCellSockReceiveFrom(uDeviceHandle_t cellHandle,
     uCellPrivateInstance_t *pInstance;
     uAtClientHandle_t atHandle;
     uCellSockSocket_t *pSocket;
-    int32_t dataLengthMax = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
-    char buffer[U_SOCK_ADDRESS_STRING_MAX_LENGTH_BYTES];
-    int32_t x;
-    int32_t port = -1;
-    int32_t receivedSize = -1;
-    int32_t readLength;
-    char *pHexBuffer = NULL;
-
-    buffer[0] = 0;  // In case of slip-ups
-
-    // Note: the real maximum length of UDP packet we can receive
-    // comes from fitting all of the following into one buffer:
-    //
-    // +USORF: xx,"max.len.ip.address.ipv4.or.ipv6",yyyyy,wwww,"the_data"\r\n
-    //
-    // where xx is the handle, max.len.ip.address.ipv4.or.ipv6 is NSAPI_IP_SIZE,
-    // yyyyy is the port number (max 65536), wwww is the length of the data and
-    // the_data is binary data. I make that 29 + 48 + len(the_data),
-    // so the overhead is 77 bytes.
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
     if (pInstance != NULL) {
         atHandle = pInstance->atHandle;
-        if (pInstance->socketsHexMode) {
-            dataLengthMax /= 2;
-        }
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
+            if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to a direct link and
+                // a direct link has no addressing
+                negErrnoLocalOrSize = -U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
                 negErrnoLocalOrSize = -U_SOCK_EWOULDBLOCK;
                 if (pSocket->pendingBytes == 0) {
                     // If the URC has not filled in pendingBytes,
                     // ask the module directly if there is anything
                     // to read
                     uAtClientLock(atHandle);
-                    uAtClientCommandStart(atHandle, "AT+USORF=");
-                    uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                    // Zero bytes to read, just want to know the number
-                    // of bytes waiting
-                    uAtClientWriteInt(atHandle, 0);
-                    uAtClientCommandStop(atHandle);
-                    uAtClientResponseStart(atHandle, "+USORF:");
-                    // Skip the socket ID
-                    uAtClientSkipParameters(atHandle, 1);
-                    // Read the amount of data
-                    x = uAtClientReadInt(atHandle);
-                    uAtClientResponseStop(atHandle);
-                    // Update pending bytes here, before
-                    // unlocking, as otherwise a data callback
-                    // triggered by a URC could be sitting waiting
-                    // to grab the AT lock and jump in before
-                    // pending bytes has been updated, leading it
-                    // back into here again, etc, etc.
-                    if (x > 0) {
-                        pSocket->pendingBytes = x;
-                        // DON'T call the user data callback here:
-                        // we already have the AT interface locked
-                        // and a user might try to call back into
-                        // here which would result in deadlock.
-                        // They will get their received data, there
-                        // is no need to worry.
-                    }
+                    usorfPendingGet(pSocket);
                     uAtClientUnlock(atHandle);
                 }
                 if (pSocket->pendingBytes > 0) {
-                    // In the UDP case we HAVE to read the number
-                    // of bytes pending as this will be the size
-                    // of the next UDP packet in the module and the
-                    // module can only deliver whole UDP packets.
                     uAtClientLock(atHandle);
-                    uAtClientCommandStart(atHandle, "AT+USORF=");
-                    uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                    // Number of bytes to read
-                    uAtClientWriteInt(atHandle, dataLengthMax);
-                    uAtClientCommandStop(atHandle);
-                    uAtClientResponseStart(atHandle, "+USORF:");
-                    // Skip the socket ID
-                    uAtClientSkipParameters(atHandle, 1);
-                    // Read the IP address
-                    uAtClientReadString(atHandle, buffer,
-                                        sizeof(buffer), false);
-                    // Read the port
-                    port = uAtClientReadInt(atHandle);
-                    // Read the amount of data
-                    receivedSize = uAtClientReadInt(atHandle);
-                    if (receivedSize > dataLengthMax) {
-                        receivedSize = dataLengthMax;
-                    }
-                    if ((int32_t) dataSizeBytes > receivedSize) {
-                        dataSizeBytes = receivedSize;
+                    negErrnoLocalOrSize = usorf(pInstance, pSocket, pRemoteAddress,
+                                                (char *) pData, dataSizeBytes);
+                    uAtClientUnlock(atHandle);
+                }
+            }
+        }
+    }
+
+    return negErrnoLocalOrSize;
+}
+
+// Send several datagrams under one AT lock.
+int32_t uCellSockSendToMany(uDeviceHandle_t cellHandle,
+                            int32_t sockHandle,
+                            const uSockAddress_t *pRemoteAddress,
+                            uSockDatagram_t *pDatagrams,
+                            size_t numDatagrams)
+{
+    int32_t negErrnoLocalOrCount = -U_SOCK_EINVAL;
+    uCellPrivateInstance_t *pInstance;
+    uCellSockSocket_t *pSocket;
+    uSockDatagram_t *pDatagram;
+    const uSockAddress_t *pAddress;
+    uSockIoVec_t ioVec;
+    int32_t count = 0;
+    int32_t x = 0;
+
+    // Find the instance
+    pInstance = pUCellPrivateGetInstance(cellHandle);
+    if ((pInstance != NULL) && ((pDatagrams != NULL) || (numDatagrams == 0))) {
+        // Find the entry
+        if (sockHandle >= 0) {
+            pSocket = pFindBySockHandle(sockHandle);
+            if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to a direct link and
+                // a direct link has no addressing
+                negErrnoLocalOrCount = -U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
+                uAtClientLock(pInstance->atHandle);
+                for (size_t y = 0; (y < numDatagrams) && (x >= 0); y++) {
+                    pDatagram = pDatagrams + y;
+                    pAddress = pDatagram->pRemoteAddress;
+                    if (pAddress == NULL) {
+                        pAddress = pRemoteAddress;
                     }
-                    if (receivedSize > 0) {
-                        if (pInstance->socketsHexMode) {
-                            // In hex mode we need a buffer to dump
-                            // the hex into and then we can decode it
-                            negErrnoLocalOrSize = -U_SOCK_ENOMEM;
-                            //lint -e{647} Suppress suspicious truncation
-                            pHexBuffer = (char *) malloc(receivedSize * 2 + 1);  // +1 for terminator
-                        }
-                        if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
-                            if (pHexBuffer != NULL) {
-                                // In hex mode we can read in the whole string
-                                //lint -e{647} Suppress suspicious truncation
-                                readLength = uAtClientReadString(atHandle, pHexBuffer,
-                                                                 receivedSize * 2 + 1, false);
-                                if (readLength > 0) {
-                                    x = (int32_t) dataSizeBytes * 2;
-                                    if (readLength > x) {
-                                        readLength = x;
-                                    }
-                                    uHexToBin(pHexBuffer, readLength, (char *) pData);
-                                }
-                                // Free memory
-                                free(pHexBuffer);
-                            } else {
-                                // Binary mode, don't stop for anything!
-                                uAtClientIgnoreStopTag(atHandle);
-                                // Get the leading quote mark out of the way
-                                uAtClientReadBytes(atHandle, NULL, 1, true);
-                                // Now read out all the actual data,
-                                // first the bit we want
-                                uAtClientReadBytes(atHandle, (char *) pData,
-                                                   dataSizeBytes, true);
-                                if (receivedSize > (int32_t) dataSizeBytes) {
-                                    //...and then the rest poured away to NULL
-                                    uAtClientReadBytes(atHandle, NULL,
-                                                       receivedSize -
-                                                       dataSizeBytes, true);
-                                }
-                                // Make sure to wait for the stop tag before
-                                // we finish
-                                uAtClientRestoreStopTag(atHandle);
-                            }
-                        }
+                    x = 0;
+                    if (pAddress == NULL) {
+                        x = -U_SOCK_EDESTADDRREQ;
+                    } else if (pDatagram->dataSizeBytes > 0) {
+                        ioVec.pBase = pDatagram->pData;
+                        ioVec.length = pDatagram->dataSizeBytes;
+                        x = usost(pInstance, pSocket, pAddress, &ioVec, 1);
                     }
-                    uAtClientResponseStop(atHandle);
-                    // BEFORE unlocking, work out what's happened.
-                    // This is to prevent a URC being processed that
-                    // may indicate data left and over-write pendingBytes
-                    // while we're also writing to it.
-                    if ((uAtClientErrorGet(atHandle) == 0) &&
-                        (receivedSize >= 0)) {
-                        // Must use what +USORF returns here as it may be less
-                        // or more than we asked for and also may be
-                        // more than pendingBytes, depending on how
-                        // the URCs landed
-                        // This update of pendingBytes will be overwritten
-                        // by the URC but we have to do something here
-                        // 'cos we don't get a URC to tell us when pendingBytes
-                        // has gone to zero.
-                        if (receivedSize > pSocket->pendingBytes) {
-                            pSocket->pendingBytes = 0;
-                        } else {
-                            pSocket->pendingBytes -= receivedSize;
-                        }
-                        negErrnoLocalOrSize = receivedSize;
+                    pDatagram->sizeBytes = x;
+                    if (x >= 0) {
+                        count++;
                     }
-                    uAtClientUnlock(atHandle);
+                }
+                uAtClientUnlock(pInstance->atHandle);
+                negErrnoLocalOrCount = count;
+                if ((count == 0) && (x < 0)) {
+                    negErrnoLocalOrCount = x;
                 }
             }
         }
     }
 
-    if ((negErrnoLocalOrSize >= 0) && (pRemoteAddress != NULL) && (port >= 0)) {
-        if (uSockStringToAddress(buffer, pRemoteAddress) == 0) {
-            pRemoteAddress->port = (uint16_t) port;
-        } else {
-            // If we can't decode the remote address this becomes
-            // an error, can't go receiving things from servers
-            // we know not who they are
-            negErrnoLocalOrSize = -U_SOCK_EIO;
+    return negErrnoLocalOrCount;
+}
+
+// Receive the waiting datagrams under one AT lock.
+int32_t uCellSockReceiveFromMany(uDeviceHandle_t cellHandle,
+                                 int32_t sockHandle,
+                                 uSockDatagram_t *pDatagrams,
+                                 size_t numDatagrams)
+{
+    int32_t negErrnoLocalOrCount = -U_SOCK_EINVAL;
+    uCellPrivateInstance_t *pInstance;
+    uCellSockSocket_t *pSocket;
+    uSockDatagram_t *pDatagram;
+    int32_t count = 0;
+    int32_t x = -U_SOCK_EWOULDBLOCK;
+
+    // Find the instance
+    pInstance = pUCellPrivateGetInstance(cellHandle);
+    if ((pInstance != NULL) && (pDatagrams != NULL)) {
+        // Find the entry
+        if (sockHandle >= 0) {
+            pSocket = pFindBySockHandle(sockHandle);
+            if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to a direct link and
+                // a direct link has no addressing
+                negErrnoLocalOrCount = -U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
+                uAtClientLock(pInstance->atHandle);
+                if (pSocket->pendingBytes == 0) {
+                    usorfPendingGet(pSocket);
+                }
+                // Keep going while the module has more and
+                // each read produces a datagram
+                for (size_t y = 0; (y < numDatagrams) &&
+                     (pSocket->pendingBytes > 0) && (count == (int32_t) y); y++) {
+                    pDatagram = pDatagrams + y;
+                    x = usorf(pInstance, pSocket, pDatagram->pRemoteAddress,
+                              (char *) pDatagram->pData, pDatagram->dataSizeBytes);
+                    if (x > 0) {
+                        pDatagram->sizeBytes = x;
+                        count++;
+                    }
+                }
+                uAtClientUnlock(pInstance->atHandle);
+                negErrnoLocalOrCount = count;
+                if (count == 0) {
+                    negErrnoLocalOrCount = -U_SOCK_EWOULDBLOCK;
+                    if (x < 0) {
+                        negErrnoLocalOrCount = x;
+                    }
+                }
+            }
         }
     }
 
-    return negErrnoLocalOrSize;
+    return negErrnoLocalOrCount;
 }
 
 /* ----------------------------------------------------------------
@@ -1516,22 +2694,37 @@ int32_t uCellSockReceiveFrom(uDeviceHandle_t cellHandle,
 int32_t uCellSockWrite(uDeviceHandle_t cellHandle,
                        int32_t sockHandle,
                        const void *pData, size_t dataSizeBytes)
+{
+    uSockIoVec_t ioVec;
+
+    ioVec.pBase = (void *) pData;
+    ioVec.length = dataSizeBytes;
+
+    return uCellSockWritev(cellHandle, sockHandle, &ioVec, 1);
+}
+
+// Send bytes gathered from an I/O vector over a connected socket.
+int32_t uCellSockWritev(uDeviceHandle_t cellHandle,
+                        int32_t sockHandle,
+                        const uSockIoVec_t *pIoVec, size_t numIoVec)
 {
     int32_t negErrnoLocalOrSize = -U_SOCK_EINVAL;
     uCellPrivateInstance_t *pInstance;
     uAtClientHandle_t atHandle;
     uCellSockSocket_t *pSocket;
-    int32_t leftToSendSize = (int32_t) dataSizeBytes;
+    int32_t dataSizeBytes = uSockIoVecLength(pIoVec, numIoVec);
+    int32_t leftToSendSize = dataSizeBytes;
     int32_t sentSize = 0;
     int32_t dataOffset = 0;
     int32_t thisSendSize = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
     size_t x = 0;
     bool written = true;
+    int32_t values[2];
     char *pHexBuffer = NULL;
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
-    if (pInstance != NULL) {
+    if ((pInstance != NULL) && (dataSizeBytes >= 0)) {
         atHandle = pInstance->atHandle;
         if (pInstance->socketsHexMode) {
             thisSendSize /= 2;
@@ -1541,7 +2734,19 @@ int32_t uCellSockWrite(uDeviceHandle_t cellHandle,
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
+            if ((pSocket != NULL) && (pSocket->pDirectLink != NULL)) {
+                // Direct link mode: just write the data
+                negErrnoLocalOrSize = directLinkWritev(pSocket, pIoVec, numIoVec,
+                                                       (size_t) dataSizeBytes);
+                if (negErrnoLocalOrSize >= 0) {
+                    leftToSendSize -= negErrnoLocalOrSize;
+                    negErrnoLocalOrSize = U_SOCK_ENONE;
+                }
+            } else if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to the direct link
+                // of another socket
+                negErrnoLocalOrSize = -U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
                 if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
                     negErrnoLocalOrSize = U_SOCK_ENONE;
                     x = 0;
@@ -1553,42 +2758,43 @@ int32_t uCellSockWrite(uDeviceHandle_t cellHandle,
                             thisSendSize = leftToSendSize;
                         }
                         uAtClientLock(atHandle);
-                        uAtClientCommandStart(atHandle, "AT+USOWR=");
-                        // Write module socket handle
-                        uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                        // Number of bytes to follow
-                        uAtClientWriteInt(atHandle, (int32_t) thisSendSize);
                         written = false;
                         if (pHexBuffer) {
                             // Make the hex-coded null terminated string
-                            uBinToHex((const char *) pData + dataOffset,
-                                      thisSendSize, pHexBuffer);
+                            ioVecWrite(atHandle, pIoVec, numIoVec, dataOffset,
+                                       thisSendSize, pHexBuffer);
                             pHexBuffer[thisSendSize * 2] = 0;
-                            // Send the hex mode data as a string
+                            // Module socket handle, number of bytes and
+                            // then the hex mode data as a string
                             //lint -e(679) Suppress suspicious truncation
-                            uAtClientWriteString(atHandle, pHexBuffer, true);
-                            uAtClientCommandStop(atHandle);
+                            uAtClientCommandPrepared(atHandle, &gUsowrHex,
+                                                     pSocket->sockHandleModule,
+                                                     (int32_t) thisSendSize,
+                                                     (const char *) pHexBuffer);
                             written = true;
                         } else {
-                            uAtClientCommandStop(atHandle);
+                            // Module socket handle and number of bytes to follow
+                            uAtClientCommandPrepared(atHandle, &gUsowr,
+                                                     pSocket->sockHandleModule,
+                                                     (int32_t) thisSendSize);
                             // Wait for the prompt
                             if (uAtClientWaitCharacter(atHandle, '@') == 0) {
                                 // Wait for it...
                                 uPortTaskBlock(50);
-                                // Go!
-                                uAtClientWriteBytes(atHandle,
-                                                    (const char *) pData + dataOffset,
-                                                    thisSendSize, true);
+                                // Go!  This segment may be
+                                // spread across several fragments
+                                ioVecWrite(atHandle, pIoVec, numIoVec, dataOffset,
+                                           thisSendSize, NULL);
                                 written = true;
                             }
                         }
                         if (written) {
                             // Grab the response
                             uAtClientResponseStart(atHandle, "+USOWR:");
-                            // Skip the socket ID
-                            uAtClientSkipParameters(atHandle, 1);
-                            // Bytes sent
-                            sentSize = uAtClientReadInt(atHandle);
+                            // Skip the socket ID, then: bytes sent
+                            uAtClientReadIntList(atHandle, values, 2,
+                                                 U_AT_CLIENT_READ_INT_LIST_SKIP(0, 1));
+                            sentSize = values[1];
                             uAtClientResponseStop(atHandle);
                             if (uAtClientUnlock(atHandle) == 0) {
                                 dataOffset += sentSize;
@@ -1622,7 +2828,7 @@ int32_t uCellSockWrite(uDeviceHandle_t cellHandle,
 
     if (negErrnoLocalOrSize == U_SOCK_ENONE) {
         // All is good
-        negErrnoLocalOrSize = ((int32_t) dataSizeBytes) - leftToSendSize;
+        negErrnoLocalOrSize = dataSizeBytes - leftToSendSize;
     }
 
     return negErrnoLocalOrSize;
@@ -1640,10 +2846,8 @@ int32_t uCellSockRead(uDeviceHandle_t cellHandle,
     int32_t dataLengthMax = U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES;
     int32_t x = -1;
     int32_t thisWantedReceiveSize;
-    int32_t thisActualReceiveSize;
     int32_t totalReceivedSize = 0;
-    int32_t readLength;
-    char *pHexBuffer = NULL;
+    int32_t values[2];
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
@@ -1655,24 +2859,51 @@ int32_t uCellSockRead(uDeviceHandle_t cellHandle,
         // Find the entry
         if (sockHandle >= 0) {
             pSocket = pFindBySockHandle(sockHandle);
-            if (pSocket != NULL) {
+            if ((pSocket != NULL) && (pSocket->pReadAhead != NULL)) {
+                // Anything in the read-ahead cache comes first; the
+                // AT client lock keeps readAheadPrefetch() out, that
+                // doesn't run (and the lock can't be had) while the
+                // AT interface belongs to a direct link
+                if (pFindDirectLink(cellHandle) == NULL) {
+                    uAtClientLock(atHandle);
+                    totalReceivedSize = (int32_t) readAheadGet(pSocket, (char *) pData,
+                                                               dataSizeBytes);
+                    uAtClientUnlock(atHandle);
+                } else {
+                    totalReceivedSize = (int32_t) readAheadGet(pSocket, (char *) pData,
+                                                               dataSizeBytes);
+                }
+                dataSizeBytes -= totalReceivedSize;
+            }
+            if ((pSocket != NULL) && (pSocket->pDirectLink != NULL)) {
+                // Direct link mode: the data is already here
+                negErrnoLocalOrSize = directLinkRead(pSocket,
+                                                     (char *) pData + totalReceivedSize,
+                                                     dataSizeBytes);
+                if (negErrnoLocalOrSize > 0) {
+                    totalReceivedSize += negErrnoLocalOrSize;
+                }
+            } else if ((pSocket != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+                // The AT interface belongs to the direct link
+                // of another socket
+                negErrnoLocalOrSize = -U_SOCK_EBUSY;
+            } else if (pSocket != NULL) {
                 negErrnoLocalOrSize = -U_SOCK_EWOULDBLOCK;
-                if (pSocket->pendingBytes == 0) {
+                if ((pSocket->pendingBytes == 0) && (totalReceivedSize == 0)) {
                     // If the URC has not filled in pendingBytes,
                     // ask the module directly if there is anything
                     // to read
                     uAtClientLock(atHandle);
-                    uAtClientCommandStart(atHandle, "AT+USORD=");
-                    uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
                     // Zero bytes to read, just want to know the number
                     // of bytes waiting
-                    uAtClientWriteInt(atHandle, 0);
-                    uAtClientCommandStop(atHandle);
+                    uAtClientCommandPrepared(atHandle, &gUsord,
+                                             pSocket->sockHandleModule,
+                                             (int32_t) 0);
                     uAtClientResponseStart(atHandle, "+USORD:");
-                    // Skip the socket ID
-                    uAtClientSkipParameters(atHandle, 1);
-                    // Read the amount of data
-                    x = uAtClientReadInt(atHandle);
+                    // Skip the socket ID, then: read the amount of data
+                    uAtClientReadIntList(atHandle, values, 2,
+                                         U_AT_CLIENT_READ_INT_LIST_SKIP(0, 1));
+                    x = values[1];
                     uAtClientResponseStop(atHandle);
                     // Update pending bytes here, before
                     // unlocking, as otherwise a data callback
@@ -1698,92 +2929,33 @@ int32_t uCellSockRead(uDeviceHandle_t cellHandle,
                     while ((dataSizeBytes > 0) &&
                            (pSocket->pendingBytes > 0) &&
                            (negErrnoLocalOrSize == U_SOCK_ENONE)) {
-                        thisWantedReceiveSize = dataLengthMax;
-                        if (thisWantedReceiveSize > (int32_t) dataSizeBytes) {
-                            thisWantedReceiveSize = (int32_t) dataSizeBytes;
-                        }
                         uAtClientLock(atHandle);
-                        uAtClientCommandStart(atHandle, "AT+USORD=");
-                        uAtClientWriteInt(atHandle, pSocket->sockHandleModule);
-                        // Number of bytes to read
-                        uAtClientWriteInt(atHandle, thisWantedReceiveSize);
-                        uAtClientCommandStop(atHandle);
-                        uAtClientResponseStart(atHandle, "+USORD:");
-                        // Skip the socket ID
-                        uAtClientSkipParameters(atHandle, 1);
-                        // Read the amount of data
-                        thisActualReceiveSize = uAtClientReadInt(atHandle);
-                        if (thisActualReceiveSize > (int32_t) dataSizeBytes) {
-                            thisActualReceiveSize = (int32_t) dataSizeBytes;
-                        }
-                        if (thisActualReceiveSize > 0) {
-                            if (pInstance->socketsHexMode) {
-                                // In hex mode we need a buffer to dump
-                                // the hex into and then we can decode it
-                                negErrnoLocalOrSize = -U_SOCK_ENOMEM;
-                                //lint -e{647} Suppress suspicious truncation
-                                pHexBuffer = (char *) malloc(thisActualReceiveSize * 2 + 1);  // +1 for terminator
+                        if ((pSocket->pReadAhead != NULL) &&
+                            (dataSizeBytes < pSocket->pReadAhead->size)) {
+                            // A small read: fill the read-ahead cache
+                            // in one go and serve this read from it
+                            x = readAheadFill(pSocket, pInstance->socketsHexMode);
+                            if (x >= 0) {
+                                x = (int32_t) readAheadGet(pSocket,
+                                                           (char *) pData + totalReceivedSize,
+                                                           dataSizeBytes);
                             }
-                            if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
-                                negErrnoLocalOrSize = U_SOCK_ENONE;
-                                if (pHexBuffer != NULL) {
-                                    // In hex mode we can read in the whole string
-                                    //lint -e{647} Suppress suspicious truncation
-                                    readLength = uAtClientReadString(atHandle, pHexBuffer,
-                                                                     thisActualReceiveSize * 2 + 1,
-                                                                     false);
-                                    if (readLength > 0) {
-                                        x = ((int32_t) dataSizeBytes) * 2;
-                                        if (readLength > x) {
-                                            readLength = x;
-                                        }
-                                        uHexToBin(pHexBuffer, readLength,
-                                                  (char *) pData + totalReceivedSize);
-                                    }
-                                    // Free memory
-                                    free(pHexBuffer);
-                                } else {
-                                    // Binary mode, don't stop for anything!
-                                    uAtClientIgnoreStopTag(atHandle);
-                                    // Get the leading quote mark out of the way
-                                    uAtClientReadBytes(atHandle, NULL, 1, true);
-                                    // Now read out the available data
-                                    uAtClientReadBytes(atHandle,
-                                                       (char *) pData +
-                                                       totalReceivedSize,
-                                                       thisActualReceiveSize, true);
-                                    // Make sure we wait for the stop tag before
-                                    // going around again
-                                    uAtClientRestoreStopTag(atHandle);
-                                }
+                        } else {
+                            thisWantedReceiveSize = dataLengthMax;
+                            if (thisWantedReceiveSize > (int32_t) dataSizeBytes) {
+                                thisWantedReceiveSize = (int32_t) dataSizeBytes;
                             }
+                            x = usord(pSocket, pInstance->socketsHexMode,
+                                      (char *) pData + totalReceivedSize,
+                                      thisWantedReceiveSize);
                         }
-                        uAtClientResponseStop(atHandle);
-                        // BEFORE unlocking, work out what's happened.
-                        // This is to prevent a URC being processed that
-                        // may indicate data left and over-write pendingBytes
-                        // while we're also writing to it.
-                        if ((uAtClientErrorGet(atHandle) == 0) &&
-                            (thisActualReceiveSize >= 0)) {
-                            // Must use what +USORD returns here as it may be less
-                            // or more than we asked for and also may be
-                            // more than pendingBytes, depending on how
-                            // the URCs landed
-                            // This update of pendingBytes will be overwritten
-                            // by the URC but we have to do something here
-                            // 'cos we don't get a URC to tell us when pendingBytes
-                            // has gone to zero.
-                            if (thisActualReceiveSize > pSocket->pendingBytes) {
-                                pSocket->pendingBytes = 0;
-                            } else {
-                                pSocket->pendingBytes -= thisActualReceiveSize;
-                            }
-                            totalReceivedSize += thisActualReceiveSize;
-                            dataSizeBytes -= thisActualReceiveSize;
+                        uAtClientUnlock(atHandle);
+                        if (x >= 0) {
+                            totalReceivedSize += x;
+                            dataSizeBytes -= x;
                         } else {
-                            negErrnoLocalOrSize = -U_SOCK_EIO;
+                            negErrnoLocalOrSize = x;
                         }
-                        uAtClientUnlock(atHandle);
                     }
                 }
             }
@@ -1920,7 +3092,10 @@ int32_t uCellSockGetHostByName(uDeviceHandle_t cellHandle,
     memset(&address, 0, sizeof(address));
     buffer[0] = 0;
     pInstance = pUCellPrivateGetInstance(cellHandle);
-    if ((pInstance != NULL) && (pHostName != NULL)) {
+    if ((pInstance != NULL) && (pFindDirectLink(cellHandle) != NULL)) {
+        // The AT interface belongs to the direct link
+        errnoLocal = U_SOCK_EBUSY;
+    } else if ((pInstance != NULL) && (pHostName != NULL)) {
         uPortLog("U_CELL_SOCK: looking up IP address of \"%s\".\n",
                  pHostName);
         errnoLocal = U_SOCK_ENXIO;
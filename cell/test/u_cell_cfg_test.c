@@ -84,6 +84,18 @@
 #define U_CELL_CFG_TEST_GREETING_STR "beeble"
 #endif
 
+#ifndef U_CELL_CFG_TEST_BAUD_RATE
+/** The baud rate to move to when testing uCellCfgSetBaudRate().
+ */
+#define U_CELL_CFG_TEST_BAUD_RATE 230400
+#endif
+
+#ifndef U_CELL_CFG_TEST_BAUD_RATE_SETTLE_TIME_MS
+/** How long to wait for the module to move to a new baud rate.
+ */
+#define U_CELL_CFG_TEST_BAUD_RATE_SETTLE_TIME_MS 100
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -104,6 +116,32 @@ static uCellTestPrivate_t gHandles = U_CELL_TEST_PRIVATE_DEFAULTS;
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Re-open the UART at a new baud rate and move the AT client onto it.
+static int32_t uartReopen(uCellTestPrivate_t *pHandles, int32_t baudRate)
+{
+    int32_t errorCode;
+
+    uAtClientLock(pHandles->atClientHandle);
+    uAtClientStreamSwitch(pHandles->atClientHandle, -1, U_AT_CLIENT_STREAM_TYPE_UART);
+    uPortUartClose(pHandles->uartHandle);
+    errorCode = uPortUartOpen(U_CFG_APP_CELL_UART,
+                              baudRate, NULL,
+                              U_CELL_UART_BUFFER_LENGTH_BYTES,
+                              U_CFG_APP_PIN_CELL_TXD,
+                              U_CFG_APP_PIN_CELL_RXD,
+                              U_CFG_APP_PIN_CELL_CTS,
+                              U_CFG_APP_PIN_CELL_RTS);
+    pHandles->uartHandle = errorCode;
+    if (errorCode >= 0) {
+        errorCode = uAtClientStreamSwitch(pHandles->atClientHandle,
+                                          pHandles->uartHandle,
+                                          U_AT_CLIENT_STREAM_TYPE_UART);
+    }
+    uAtClientUnlock(pHandles->atClientHandle);
+
+    return errorCode;
+}
+
 // Callback function for the cellular connection process
 static bool keepGoingCallback(uDeviceHandle_t unused)
 {
@@ -674,6 +712,82 @@ U_PORT_TEST_FUNCTION("[cellCfg]", "cellCfgGetSetMnoProfile")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Test applying a desired configuration; this only applies the
+ * configuration the module already has, to check that nothing is
+ * changed and that the fingerprint works, since changing things
+ * would mean lots of re-boots.
+ */
+U_PORT_TEST_FUNCTION("[cellCfg]", "cellCfgApply")
+{
+    uDeviceHandle_t cellHandle;
+    const uCellPrivateModule_t *pModule;
+    uCellCfgDesired_t desired = U_CELL_CFG_DESIRED_DEFAULTS;
+    uint32_t fingerprint = 0;
+    int32_t heapUsed;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    // Get the private module data as we need it for testing
+    pModule = pUCellPrivateGetModule(cellHandle);
+    U_PORT_TEST_ASSERT(pModule != NULL);
+    //lint -esym(613, pModule) Suppress possible use of NULL pointer
+    // for pModule from now on
+
+    // Fill the desired configuration in with what the module has now
+    if (U_CELL_PRIVATE_HAS(pModule,
+                           U_CELL_PRIVATE_FEATURE_MNO_PROFILE)) {
+        desired.mnoProfile = uCellCfgGetMnoProfile(cellHandle);
+        U_PORT_TEST_ASSERT(desired.mnoProfile >= 0);
+    }
+    for (size_t x = 0; x < pModule->maxNumSimultaneousRats; x++) {
+        desired.rat[x] = uCellCfgGetRat(cellHandle, (int32_t) x);
+        U_PORT_TEST_ASSERT((int32_t) desired.rat[x] >= 0);
+    }
+    if (pModule->moduleType != U_CELL_MODULE_TYPE_SARA_U201) {
+        desired.bandMask[0].rat = desired.rat[0];
+        U_PORT_TEST_ASSERT(uCellCfgGetBandMask(cellHandle, desired.bandMask[0].rat,
+                                               &(desired.bandMask[0].bandMask1),
+                                               &(desired.bandMask[0].bandMask2)) == 0);
+    }
+
+    U_TEST_PRINT_LINE("applying the current configuration...");
+    if (pModule->moduleType != U_CELL_MODULE_TYPE_SARA_U201) {
+        U_PORT_TEST_ASSERT(uCellCfgApply(cellHandle, &desired, &fingerprint) == 0);
+        U_TEST_PRINT_LINE("fingerprint is 0x%08x.", fingerprint);
+        U_PORT_TEST_ASSERT(fingerprint != 0);
+        U_PORT_TEST_ASSERT(!uCellPwrRebootIsRequired(cellHandle));
+        U_TEST_PRINT_LINE("applying it again with the fingerprint...");
+        U_PORT_TEST_ASSERT(uCellCfgApply(cellHandle, &desired, &fingerprint) == 0);
+        U_PORT_TEST_ASSERT(!uCellPwrRebootIsRequired(cellHandle));
+        // Without the fingerprint the outcome should be the same
+        U_PORT_TEST_ASSERT(uCellCfgApply(cellHandle, &desired, NULL) == 0);
+        U_PORT_TEST_ASSERT(!uCellPwrRebootIsRequired(cellHandle));
+    } else {
+        U_PORT_TEST_ASSERT(uCellCfgApply(cellHandle, &desired, &fingerprint) < 0);
+        U_PORT_TEST_ASSERT(fingerprint == 0);
+    }
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Test UDCONF.
  */
 U_PORT_TEST_FUNCTION("[cellCfg]", "cellCfgUdconf")
@@ -798,6 +912,53 @@ U_PORT_TEST_FUNCTION("[cellCfg]", "cellCfgAutoBaud")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Test moving the module to a different baud rate and back.
+ */
+U_PORT_TEST_FUNCTION("[cellCfg]", "cellCfgBaudRate")
+{
+    uDeviceHandle_t cellHandle;
+    int32_t heapUsed;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    U_PORT_TEST_ASSERT(uCellCfgSetBaudRate(cellHandle, 0) < 0);
+    U_PORT_TEST_ASSERT(uCellCfgSetBaudRate(NULL, U_CELL_CFG_TEST_BAUD_RATE) < 0);
+    // Nothing should have changed
+    U_PORT_TEST_ASSERT(uCellPwrIsAlive(cellHandle));
+
+    U_TEST_PRINT_LINE("moving to %d baud...", U_CELL_CFG_TEST_BAUD_RATE);
+    U_PORT_TEST_ASSERT(uCellCfgSetBaudRate(cellHandle, U_CELL_CFG_TEST_BAUD_RATE) == 0);
+    uPortTaskBlock(U_CELL_CFG_TEST_BAUD_RATE_SETTLE_TIME_MS);
+    U_PORT_TEST_ASSERT(uartReopen(&gHandles, U_CELL_CFG_TEST_BAUD_RATE) == 0);
+    U_PORT_TEST_ASSERT(uCellPwrIsAlive(cellHandle));
+
+    U_TEST_PRINT_LINE("moving back to %d baud...", U_CELL_UART_BAUD_RATE);
+    U_PORT_TEST_ASSERT(uCellCfgSetBaudRate(cellHandle, U_CELL_UART_BAUD_RATE) == 0);
+    uPortTaskBlock(U_CELL_CFG_TEST_BAUD_RATE_SETTLE_TIME_MS);
+    U_PORT_TEST_ASSERT(uartReopen(&gHandles, U_CELL_UART_BAUD_RATE) == 0);
+    U_PORT_TEST_ASSERT(uCellPwrIsAlive(cellHandle));
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Test greeting message.
  */
 U_PORT_TEST_FUNCTION("[cellCfg]", "cellCfgGreeting")
@@ -97,6 +97,26 @@
  */
 #define U_CELL_FILE_TEST_REENTRANT_STRING_SIZE 9
 
+/** The name of the file to use when testing streaming.
+ */
+#define U_CELL_FILE_TEST_STREAM_FILE_NAME "tstream"
+
+/** The number of bytes to stream: more than a block so that
+ * more than one AT command is involved.
+ */
+#define U_CELL_FILE_TEST_STREAM_SIZE_BYTES (U_CELL_FILE_STREAM_BLOCK_SIZE_BYTES + 100)
+
+/** The size of buffer to use when streaming; deliberately not
+ * a factor of U_CELL_FILE_TEST_STREAM_SIZE_BYTES.
+ */
+#define U_CELL_FILE_TEST_STREAM_BUFFER_SIZE_BYTES 60
+
+/** The name of the file to use when testing the file cache;
+ * must not be the same length as U_CELL_FILE_TEST_FILE_NAME plus
+ * one, which would confuse cellFileListAllReentrant().
+ */
+#define U_CELL_FILE_TEST_CACHE_FILE_NAME "tcache"
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -113,6 +133,59 @@ static uCellTestPrivate_t gHandles = U_CELL_TEST_PRIVATE_DEFAULTS;
 * STATIC FUNCTIONS
 * -------------------------------------------------------------- */
 
+// The byte expected at a given offset in the stream test file.
+static char streamByte(size_t offset)
+{
+    return (char) ('A' + (offset % 26));
+}
+
+// Source of data for uCellFileWriteStream(), used by cellFileStream().
+static int32_t streamSource(char *pData, size_t size,
+                            size_t offset, void *pParam)
+{
+    int32_t *pCalls = (int32_t *) pParam;
+
+    (*pCalls)++;
+    for (size_t x = 0; x < size; x++) {
+        *(pData + x) = streamByte(offset + x);
+    }
+
+    return (int32_t) size;
+}
+
+// Sink for data from uCellFileReadStream(), used by cellFileStream();
+// counts the bytes that are as expected.
+static bool streamSink(const char *pData, size_t size, size_t offset,
+                       size_t totalSize, void *pParam)
+{
+    size_t *pGood = (size_t *) pParam;
+
+    if ((size <= U_CELL_FILE_TEST_STREAM_BUFFER_SIZE_BYTES) &&
+        (totalSize == U_CELL_FILE_TEST_STREAM_SIZE_BYTES)) {
+        for (size_t x = 0; x < size; x++) {
+            if (*(pData + x) == streamByte(offset + x)) {
+                (*pGood)++;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Sink for data from uCellFileReadStream() that stops after the
+// first call, used by cellFileStream().
+static bool streamSinkStop(const char *pData, size_t size, size_t offset,
+                           size_t totalSize, void *pParam)
+{
+    (void) pData;
+    (void) size;
+    (void) offset;
+    (void) totalSize;
+    (*((int32_t *) pParam))++;
+
+    return false;
+}
+
 // Update a tracking array, used by cellFileListAllReentrant().
 static void updateTracker(const char *pFileName, bool *pTracker,
                           size_t size)
@@ -585,6 +658,166 @@ U_PORT_TEST_FUNCTION("[cellFile]", "cellFileListAllReentrant")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Test streaming a file to and from the file system.
+ */
+U_PORT_TEST_FUNCTION("[cellFile]", "cellFileStream")
+{
+    int32_t heapUsed;
+    uDeviceHandle_t cellHandle;
+    char buffer[U_CELL_FILE_TEST_STREAM_BUFFER_SIZE_BYTES];
+    int32_t calls = 0;
+    size_t good = 0;
+    int32_t startTimeMs;
+    int32_t result;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    // Make sure we start with an empty file
+    uCellFileDelete(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME);
+
+    U_TEST_PRINT_LINE("streaming %d byte(s) to file...", U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+    startTimeMs = uPortGetTickTimeMs();
+    result = uCellFileWriteStream(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME,
+                                  U_CELL_FILE_TEST_STREAM_SIZE_BYTES,
+                                  buffer, sizeof(buffer),
+                                  streamSource, &calls);
+    U_TEST_PRINT_LINE("%d byte(s) written in %d ms, %d call(s) to the source.",
+                      result, uPortGetTickTimeMs() - startTimeMs, calls);
+    U_PORT_TEST_ASSERT(result == U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(calls > 1);
+    U_PORT_TEST_ASSERT(uCellFileSize(cellHandle,
+                                     U_CELL_FILE_TEST_STREAM_FILE_NAME) == U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+
+    U_TEST_PRINT_LINE("streaming file back again...");
+    startTimeMs = uPortGetTickTimeMs();
+    result = uCellFileReadStream(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME, 0,
+                                 buffer, sizeof(buffer), streamSink, &good);
+    U_TEST_PRINT_LINE("%d byte(s) read in %d ms, %d as expected.",
+                      result, uPortGetTickTimeMs() - startTimeMs, good);
+    U_PORT_TEST_ASSERT(result == U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(good == U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+
+    // Check that the sink can stop the stream early and that
+    // the AT interface is fine afterwards
+    calls = 0;
+    result = uCellFileReadStream(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME, 10,
+                                 buffer, sizeof(buffer), streamSinkStop, &calls);
+    U_PORT_TEST_ASSERT(result == sizeof(buffer));
+    U_PORT_TEST_ASSERT(calls == 1);
+    U_PORT_TEST_ASSERT(uCellFileSize(cellHandle,
+                                     U_CELL_FILE_TEST_STREAM_FILE_NAME) == U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+
+    U_PORT_TEST_ASSERT(uCellFileDelete(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME) == 0);
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Test the file cache.
+ */
+U_PORT_TEST_FUNCTION("[cellFile]", "cellFileCache")
+{
+    int32_t heapUsed;
+    uDeviceHandle_t cellHandle;
+    char *pFileName;
+    int32_t count;
+    int32_t x;
+    int32_t startTimeMs;
+    bool found = false;
+
+    pFileName = (char *) malloc(U_CELL_FILE_NAME_MAX_LENGTH + 1);
+    U_PORT_TEST_ASSERT(pFileName != NULL);
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    uCellFileDelete(cellHandle, U_CELL_FILE_TEST_CACHE_FILE_NAME);
+
+    U_PORT_TEST_ASSERT(uCellFileCacheSet(cellHandle, true) == 0);
+
+    // The first listing fills the cache
+    startTimeMs = uPortGetTickTimeMs();
+    count = uCellFileListFirst(cellHandle, pFileName);
+    uCellFileListLast(cellHandle);
+    U_TEST_PRINT_LINE("%d file(s) listed from the module in %d ms.",
+                      count, uPortGetTickTimeMs() - startTimeMs);
+    U_PORT_TEST_ASSERT(count > 0);
+
+    // Write a file: it should appear in the next listing, which
+    // should come from the cache
+    U_PORT_TEST_ASSERT(uCellFileWrite(cellHandle, U_CELL_FILE_TEST_CACHE_FILE_NAME,
+                                      "12345", 5) == 5);
+    startTimeMs = uPortGetTickTimeMs();
+    for (x = uCellFileListFirst(cellHandle, pFileName);
+         x >= 0;
+         x = uCellFileListNext(cellHandle, pFileName)) {
+        if (strcmp(pFileName, U_CELL_FILE_TEST_CACHE_FILE_NAME) == 0) {
+            found = true;
+        }
+    }
+    U_TEST_PRINT_LINE("listed from the cache in %d ms.",
+                      uPortGetTickTimeMs() - startTimeMs);
+    U_PORT_TEST_ASSERT(found);
+    U_PORT_TEST_ASSERT(uCellFileListFirst(cellHandle, pFileName) == count + 1);
+    uCellFileListLast(cellHandle);
+
+    // Appending should be tracked in the cached size, which should
+    // agree with what the module says once the cache is invalidated
+    U_PORT_TEST_ASSERT(uCellFileSize(cellHandle, U_CELL_FILE_TEST_CACHE_FILE_NAME) == 5);
+    U_PORT_TEST_ASSERT(uCellFileWrite(cellHandle, U_CELL_FILE_TEST_CACHE_FILE_NAME,
+                                      "678", 3) == 3);
+    U_PORT_TEST_ASSERT(uCellFileSize(cellHandle, U_CELL_FILE_TEST_CACHE_FILE_NAME) == 8);
+    U_PORT_TEST_ASSERT(uCellFileCacheInvalidate(cellHandle) == 0);
+    U_PORT_TEST_ASSERT(uCellFileSize(cellHandle, U_CELL_FILE_TEST_CACHE_FILE_NAME) == 8);
+    U_PORT_TEST_ASSERT(uCellFileListFirst(cellHandle, pFileName) == count + 1);
+    uCellFileListLast(cellHandle);
+
+    // Deleting should be tracked too
+    U_PORT_TEST_ASSERT(uCellFileDelete(cellHandle, U_CELL_FILE_TEST_CACHE_FILE_NAME) == 0);
+    U_PORT_TEST_ASSERT(uCellFileListFirst(cellHandle, pFileName) == count);
+    uCellFileListLast(cellHandle);
+
+    U_PORT_TEST_ASSERT(uCellFileCacheSet(cellHandle, false) == 0);
+
+    free(pFileName);
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Test deleting file.
  */
 U_PORT_TEST_FUNCTION("[cellFile]", "cellFileDelete")
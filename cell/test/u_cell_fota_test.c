@@ -35,6 +35,7 @@
 #  include "u_cfg_override.h" // For a customer's configuration override
 # endif
 
+#include "stdlib.h"    // malloc(), free()
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
@@ -49,6 +50,7 @@
 #include "u_port.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"   // Required by u_cell_private.h
+#include "u_port_crypto.h"
 
 #include "u_at_client.h"
 
@@ -74,6 +76,20 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
+/** The name of the file that the pretend firmware image is
+ * written to; it is not installed.
+ */
+#define U_CELL_FOTA_TEST_IMAGE_FILE_NAME "ubxlib_test_fota_image"
+
+/** The size of the pretend firmware image: deliberately not a
+ * multiple of the buffer size.
+ */
+#define U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES 3000
+
+/** The size of buffer to use when writing the image.
+ */
+#define U_CELL_FOTA_TEST_BUFFER_SIZE_BYTES 512
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -86,6 +102,14 @@
  */
 static uCellTestPrivate_t gHandles = U_CELL_TEST_PRIVATE_DEFAULTS;
 
+/** The offset at which imageCallback() should fail, -1 for never.
+ */
+static int32_t gImageFailAt = -1;
+
+/** The number of bytes imageCallback() has been asked for.
+ */
+static size_t gImageBytesRequested = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -102,6 +126,30 @@ void fotaStatusCallback(uDeviceHandle_t cellHandle,
     (void) pParameter;
 }
 
+// Provide the pretend firmware image: each byte is its offset.
+static int32_t imageCallback(uDeviceHandle_t cellHandle, char *pBuffer,
+                             size_t size, size_t offset, size_t imageSize,
+                             void *pCallbackParam)
+{
+    int32_t bytesProvided = 0;
+
+    (void) cellHandle;
+    (void) imageSize;
+    (void) pCallbackParam;
+
+    gImageBytesRequested += size;
+    for (size_t x = 0; x < size; x++) {
+        if ((gImageFailAt >= 0) && (offset + x >= (size_t) gImageFailAt)) {
+            // Return short
+            break;
+        }
+        *(pBuffer + x) = (char) (offset + x);
+        bytesProvided++;
+    }
+
+    return bytesProvided;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -180,6 +228,96 @@ U_PORT_TEST_FUNCTION("[cellFota]", "cellFotaVeryBasicIndeed")
     U_PORT_TEST_ASSERT(heapUsed <= heapFotaInitLoss);
 }
 
+/** Test writing a firmware image to the file system of the module,
+ * including resuming and checking the hash; the image is a pretend
+ * one and so is not installed.
+ */
+U_PORT_TEST_FUNCTION("[cellFota]", "cellFotaImageDownload")
+{
+    uDeviceHandle_t cellHandle;
+    int32_t heapUsed;
+    char *pImage;
+    char *pBuffer;
+    char sha256[U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES];
+    int32_t x;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    // Work out the hash of the pretend image
+    pImage = (char *) malloc(U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(pImage != NULL);
+    gImageFailAt = -1;
+    imageCallback(NULL, pImage, U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, 0,
+                  U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, NULL);
+    x = uPortCryptoSha256(pImage, U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, sha256);
+    free(pImage);
+    if (x == 0) {
+        pBuffer = (char *) malloc(U_CELL_FOTA_TEST_BUFFER_SIZE_BYTES);
+        U_PORT_TEST_ASSERT(pBuffer != NULL);
+        uCellFileDelete(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME);
+
+        // Fail part way through the second block
+        U_TEST_PRINT_LINE("writing pretend image, failing part way.");
+        gImageFailAt = U_CELL_FOTA_TEST_BUFFER_SIZE_BYTES + 100;
+        x = uCellFotaImageDownload(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME,
+                                   U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, sha256,
+                                   pBuffer, U_CELL_FOTA_TEST_BUFFER_SIZE_BYTES,
+                                   imageCallback, NULL);
+        U_PORT_TEST_ASSERT(x < 0);
+        // Only the whole first block should have been written
+        U_PORT_TEST_ASSERT(uCellFileSize(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME) ==
+                           U_CELL_FOTA_TEST_BUFFER_SIZE_BYTES);
+
+        // Resume
+        U_TEST_PRINT_LINE("resuming.");
+        gImageFailAt = -1;
+        gImageBytesRequested = 0;
+        x = uCellFotaImageDownload(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME,
+                                   U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, sha256,
+                                   pBuffer, U_CELL_FOTA_TEST_BUFFER_SIZE_BYTES,
+                                   imageCallback, NULL);
+        U_TEST_PRINT_LINE("uCellFotaImageDownload() returned %d.", x);
+        U_PORT_TEST_ASSERT(x == 0);
+        U_PORT_TEST_ASSERT(gImageBytesRequested == U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES);
+        U_PORT_TEST_ASSERT(uCellFileSize(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME) ==
+                           U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES);
+
+        // Already complete: nothing more should be written but the
+        // hash should be checked and, if wrong, the file deleted
+        sha256[0] = (char) ~sha256[0];
+        x = uCellFotaImageDownload(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME,
+                                   U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, sha256,
+                                   pBuffer, U_CELL_FOTA_TEST_BUFFER_SIZE_BYTES,
+                                   imageCallback, NULL);
+        U_PORT_TEST_ASSERT(x == (int32_t) U_ERROR_COMMON_AUTHENTICATION_FAILURE);
+        U_PORT_TEST_ASSERT(uCellFileSize(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME) < 0);
+
+        free(pBuffer);
+    } else {
+        U_TEST_PRINT_LINE("SHA256 not supported, not testing image download.");
+    }
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -82,6 +82,13 @@
 # define U_CFG_TEST_GPIO_NAME U_CELL_GPIO_NUMBER_TO_GPIO_ID(1)
 #endif
 
+#ifndef U_CFG_TEST_GPIO_MASK
+/** The mask, see U_CELL_GPIO_NUMBER_TO_MASK(), for the GPIO
+ * given by U_CFG_TEST_GPIO_NAME.
+ */
+# define U_CFG_TEST_GPIO_MASK U_CELL_GPIO_NUMBER_TO_MASK(1)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -146,6 +153,29 @@ U_PORT_TEST_FUNCTION("[cellGpio]", "cellGpioBasic")
     U_TEST_PRINT_LINE("GPIO ID %d is %d.", U_CFG_TEST_GPIO_NAME, x);
     U_PORT_TEST_ASSERT(x == 0);
 
+    // Now the mask versions: the level is known to be 0 so
+    // setting it to 0 again should need no AT command
+    U_PORT_TEST_ASSERT(uCellGpioSetMask(cellHandle, U_CFG_TEST_GPIO_MASK, 0) == 0);
+    U_TEST_PRINT_LINE("setting GPIO mask 0x%02x to 1.",
+                      (unsigned int) U_CFG_TEST_GPIO_MASK);
+    U_PORT_TEST_ASSERT(uCellGpioSetMask(cellHandle, U_CFG_TEST_GPIO_MASK,
+                                        U_CELL_GPIO_MASK_ALL) == 1);
+    x = uCellGpioGetMask(cellHandle, U_CFG_TEST_GPIO_MASK);
+    U_TEST_PRINT_LINE("GPIO mask 0x%02x is 0x%02x.",
+                      (unsigned int) U_CFG_TEST_GPIO_MASK, (unsigned int) x);
+    U_PORT_TEST_ASSERT(x == (int32_t) U_CFG_TEST_GPIO_MASK);
+    U_PORT_TEST_ASSERT(uCellGpioGet(cellHandle, U_CFG_TEST_GPIO_NAME) == 1);
+    U_PORT_TEST_ASSERT(uCellGpioSetMask(cellHandle, U_CFG_TEST_GPIO_MASK,
+                                        U_CFG_TEST_GPIO_MASK) == 0);
+    U_PORT_TEST_ASSERT(uCellGpioSetMask(cellHandle, U_CFG_TEST_GPIO_MASK, 0) == 1);
+    x = uCellGpioGetMask(cellHandle, U_CFG_TEST_GPIO_MASK);
+    U_TEST_PRINT_LINE("GPIO mask 0x%02x is 0x%02x.",
+                      (unsigned int) U_CFG_TEST_GPIO_MASK, (unsigned int) x);
+    U_PORT_TEST_ASSERT(x == 0);
+    U_PORT_TEST_ASSERT(uCellGpioGetMask(cellHandle, 0) == 0);
+    U_PORT_TEST_ASSERT(uCellGpioSetMask(cellHandle, U_CELL_GPIO_NUMBER_TO_MASK(7), 0) < 0);
+    U_PORT_TEST_ASSERT(uCellGpioGetMask(cellHandle, U_CELL_GPIO_NUMBER_TO_MASK(7)) < 0);
+
     // For toggling the CTS pin we need to know that it is not
     // already in use for flow control and this command is also not
     // supported on SARA-R4
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the cellular HTTP API: these should pass on all
+ * platforms that have a cellular module connected to them.  They
+ * are only compiled if U_CFG_TEST_CELL_MODULE_TYPE is defined.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_TEST_CELL_MODULE_TYPE
+
+# ifdef U_CFG_OVERRIDE
+#  include "u_cfg_override.h" // For a customer's configuration override
+# endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+
+#include "u_at_client.h"
+
+#include "u_cell_module_type.h"
+#include "u_cell.h"
+#include "u_cell_file.h"
+#include "u_cell_net.h"
+#include "u_cell_http.h"
+
+#include "u_cell_test_cfg.h"
+#include "u_cell_test_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_CELL_HTTP_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_CELL_HTTP_TEST_SERVER
+/** The HTTP server to use for testing, including port number.
+ */
+# define U_CELL_HTTP_TEST_SERVER ubxlib.it-sgn.u-blox.com:8080
+#endif
+
+#ifndef U_CELL_HTTP_TEST_TIMEOUT_SECONDS
+/** How long to wait for an HTTP request to complete.
+ */
+# define U_CELL_HTTP_TEST_TIMEOUT_SECONDS 30
+#endif
+
+/** The file that the asynchronous request writes its response to.
+ */
+#define U_CELL_HTTP_TEST_FILE_NAME "ubxlib_test_http"
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Used for keepGoingCallback() timeout.
+ */
+static int64_t gStopTimeMs;
+
+/** Handles.
+ */
+static uCellTestPrivate_t gHandles = U_CELL_TEST_PRIVATE_DEFAULTS;
+
+/** Set by httpCallback(): 0 for not called, 1 for success, -1
+ * for failure.
+ */
+static volatile int32_t gCallbackResult = 0;
+
+/** The number of bytes received by streamCallback().
+ */
+static size_t gStreamBytes = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Callback function for the cellular connection process.
+static bool keepGoingCallback(uDeviceHandle_t unused)
+{
+    bool keepGoing = true;
+
+    (void) unused;
+
+    if (uPortGetTickTimeMs() > gStopTimeMs) {
+        keepGoing = false;
+    }
+
+    return keepGoing;
+}
+
+// The HTTP callback.
+static void httpCallback(uDeviceHandle_t cellHandle, int32_t httpHandle,
+                         uCellHttpRequest_t requestType, bool success,
+                         void *pCallbackParameter)
+{
+    (void) cellHandle;
+    (void) httpHandle;
+    (void) requestType;
+    (void) pCallbackParameter;
+
+    gCallbackResult = success ? 1 : -1;
+}
+
+// Callback for uCellHttpGetStream(), which checks the offset.
+static bool streamCallback(const char *pData, size_t length,
+                           size_t offset, void *pCallbackParam)
+{
+    (void) pData;
+    (void) pCallbackParam;
+
+    if (offset == gStreamBytes) {
+        gStreamBytes += length;
+    }
+
+    return true;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Test the HTTP client, both the asynchronous request and the
+ * streamed GET.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the
+ * U_PORT_TEST_FUNCTION() macro.
+ */
+U_PORT_TEST_FUNCTION("[cellHttp]", "cellHttpBasic")
+{
+    uDeviceHandle_t cellHandle;
+    int32_t heapUsed;
+    int32_t heapHttpInitLoss;
+    char buffer[64];
+    int32_t httpHandle;
+    int32_t startTimeMs;
+    int32_t x;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    gStopTimeMs = uPortGetTickTimeMs() +
+                  (U_CELL_TEST_CFG_CONNECT_TIMEOUT_SECONDS * 1000);
+    x = uCellNetConnect(cellHandle, NULL,
+#ifdef U_CELL_TEST_CFG_APN
+                        U_PORT_STRINGIFY_QUOTED(U_CELL_TEST_CFG_APN),
+#else
+                        NULL,
+#endif
+#ifdef U_CELL_TEST_CFG_USERNAME
+                        U_PORT_STRINGIFY_QUOTED(U_CELL_TEST_CFG_USERNAME),
+#else
+                        NULL,
+#endif
+#ifdef U_CELL_TEST_CFG_PASSWORD
+                        U_PORT_STRINGIFY_QUOTED(U_CELL_TEST_CFG_PASSWORD),
+#else
+                        NULL,
+#endif
+                        keepGoingCallback);
+    U_PORT_TEST_ASSERT(x == 0);
+
+    // The first open allocates a context which is not deallocated
+    // until cellular is taken down, which we don't do here to save
+    // time; take account of that initialisation heap cost here.
+    heapHttpInitLoss = uPortGetHeapFree();
+    httpHandle = uCellHttpOpen(cellHandle,
+                               U_PORT_STRINGIFY_QUOTED(U_CELL_HTTP_TEST_SERVER),
+                               NULL, NULL, -1, U_CELL_HTTP_TEST_TIMEOUT_SECONDS,
+                               httpCallback, NULL);
+    heapHttpInitLoss -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("uCellHttpOpen() returned %d.", httpHandle);
+    U_PORT_TEST_ASSERT(httpHandle >= 0);
+    U_PORT_TEST_ASSERT(uCellHttpRequestStatus(cellHandle, httpHandle) ==
+                       (int32_t) U_ERROR_COMMON_NOT_FOUND);
+
+    // Asynchronous HEAD request
+    gCallbackResult = 0;
+    U_PORT_TEST_ASSERT(uCellHttpRequest(cellHandle, httpHandle,
+                                        U_CELL_HTTP_REQUEST_HEAD, "/",
+                                        U_CELL_HTTP_TEST_FILE_NAME,
+                                        NULL, NULL) == 0);
+    // Can't have two at once
+    U_PORT_TEST_ASSERT(uCellHttpRequest(cellHandle, httpHandle,
+                                        U_CELL_HTTP_REQUEST_HEAD, "/",
+                                        U_CELL_HTTP_TEST_FILE_NAME, NULL,
+                                        NULL) == (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gCallbackResult == 0) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_CELL_HTTP_TEST_TIMEOUT_SECONDS * 1000)) {
+        uPortTaskBlock(100);
+    }
+    U_TEST_PRINT_LINE("HEAD request result %d.", gCallbackResult);
+    U_PORT_TEST_ASSERT(gCallbackResult == 1);
+    U_PORT_TEST_ASSERT(uCellHttpRequestStatus(cellHandle, httpHandle) == 0);
+    U_PORT_TEST_ASSERT(uCellFileDelete(cellHandle, U_CELL_HTTP_TEST_FILE_NAME) == 0);
+
+    // Streamed GET, with a small buffer to exercise the header skipping
+    gCallbackResult = 0;
+    gStreamBytes = 0;
+    x = uCellHttpGetStream(cellHandle, httpHandle, "/", buffer, sizeof(buffer),
+                           streamCallback, NULL);
+    U_TEST_PRINT_LINE("uCellHttpGetStream() returned %d, %d byte(s) of body.",
+                      x, gStreamBytes);
+    U_PORT_TEST_ASSERT(x == 200);
+    U_PORT_TEST_ASSERT(gStreamBytes > 0);
+    // The callback is not called for the streamed GET
+    U_PORT_TEST_ASSERT(gCallbackResult == 0);
+
+    uCellHttpClose(cellHandle, httpHandle);
+    U_PORT_TEST_ASSERT(uCellHttpRequestStatus(cellHandle, httpHandle) < 0);
+
+    U_PORT_TEST_ASSERT(uCellNetDisconnect(cellHandle, NULL) == 0);
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("during this part of the test %d byte(s)"
+                      " were lost to cell HTTP initialisation; we"
+                      " have leaked %d byte(s).",
+                      heapHttpInitLoss, heapUsed - heapHttpInitLoss);
+    U_PORT_TEST_ASSERT(heapUsed <= heapHttpInitLoss);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[cellHttp]", "cellHttpCleanUp")
+{
+    int32_t x;
+
+    uCellTestPrivateCleanup(&gHandles);
+
+    x = uPortTaskStackMinFree(NULL);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("main task stack had a minimum of %d"
+                          " byte(s) free at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_OS_MAIN_TASK_MIN_FREE_STACK_BYTES);
+    }
+
+    uPortDeinit();
+
+    x = uPortGetHeapMinFree();
+    if (x >= 0) {
+        U_TEST_PRINT_LINE("heap had a minimum of %d byte(s) free"
+                          " at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_HEAP_MIN_FREE_BYTES);
+    }
+}
+
+#endif // #ifdef U_CFG_TEST_CELL_MODULE_TYPE
+
+// End of file
@@ -83,6 +83,19 @@
 # define U_CELL_INFO_TEST_MIN_UTC_TIME 1626874836
 #endif
 
+#ifndef U_CELL_INFO_TEST_TIME_BASE_MARGIN_SECONDS
+/** How far the time from the cached time base may be ahead of
+ * the time read without it, allowing for the time taken to read
+ * the time string and start the time base.
+ */
+# define U_CELL_INFO_TEST_TIME_BASE_MARGIN_SECONDS 5
+#endif
+
+/** The number of samples to keep when testing the radio parameter
+ * sampler.
+ */
+#define U_CELL_INFO_TEST_SAMPLER_HISTORY_LENGTH 8
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -198,6 +211,14 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoImeiEtc")
     bytesRead = uCellInfoGetFirmwareVersionStr(cellHandle, buffer, sizeof(buffer));
     U_PORT_TEST_ASSERT((bytesRead > 0) && (bytesRead < sizeof(buffer) - 1) &&
                        (bytesRead == strlen(buffer)));
+    // Read it again, which will now come from the cache, into
+    // a short buffer and check that there is no overrun
+    memset(buffer, 0, sizeof(buffer));
+    bytesRead = uCellInfoGetFirmwareVersionStr(cellHandle, buffer, 3);
+    U_PORT_TEST_ASSERT((bytesRead == 2) && (bytesRead == strlen(buffer)));
+    for (size_t x = bytesRead; x < sizeof(buffer); x++) {
+        U_PORT_TEST_ASSERT(buffer[x] == 0);
+    }
 
     U_TEST_PRINT_LINE("getting and checking IMSI...");
     memset(buffer, 0, sizeof(buffer));
@@ -257,6 +278,8 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoRadioParameters")
     uDeviceHandle_t cellHandle;
     int32_t x;
     int32_t snrDb;
+    uCellInfoSample_t samples[U_CELL_INFO_TEST_SAMPLER_HISTORY_LENGTH];
+    uCellInfoSampleSummary_t summary;
     size_t count;
     int32_t heapUsed;
 
@@ -327,6 +350,35 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoRadioParameters")
         U_PORT_TEST_ASSERT((x == 0) || (x == U_CELL_ERROR_VALUE_OUT_OF_RANGE));
     }
 
+    // Run the radio parameter sampler for a while
+    U_TEST_PRINT_LINE("running the radio parameter sampler...");
+    x = uCellInfoSamplerStart(cellHandle, 2000, U_CELL_INFO_TEST_SAMPLER_HISTORY_LENGTH);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED) {
+        U_PORT_TEST_ASSERT(x == 0);
+        // A user refresh should also add a sample
+        uCellInfoRefreshRadioParameters(cellHandle);
+        U_PORT_TEST_ASSERT(uCellInfoSamplerGetHistory(cellHandle, samples, 1) == 1);
+        uPortTaskBlock(10000);
+        x = uCellInfoSamplerGetHistory(cellHandle, samples,
+                                       sizeof(samples) / sizeof(samples[0]));
+        U_TEST_PRINT_LINE("%d sample(s) in the history.", x);
+        U_PORT_TEST_ASSERT(x > 1);
+        for (int32_t y = 1; y < x; y++) {
+            // Newest first
+            U_PORT_TEST_ASSERT(samples[y].timeMs <= samples[y - 1].timeMs);
+        }
+        x = uCellInfoSamplerGetSummary(cellHandle, 0, &summary);
+        U_TEST_PRINT_LINE("%d sample(s): RSSI min %d, max %d, mean %d dBm.", x,
+                          summary.rssiDbm.min, summary.rssiDbm.max, summary.rssiDbm.mean);
+        U_PORT_TEST_ASSERT(x > 1);
+        if (summary.rssiDbm.numSamples > 0) {
+            U_PORT_TEST_ASSERT(summary.rssiDbm.min <= summary.rssiDbm.mean);
+            U_PORT_TEST_ASSERT(summary.rssiDbm.mean <= summary.rssiDbm.max);
+        }
+        uCellInfoSamplerStop(cellHandle);
+        U_PORT_TEST_ASSERT(uCellInfoSamplerGetHistory(cellHandle, samples, 1) < 0);
+    }
+
     // Disconnect
     U_PORT_TEST_ASSERT(uCellNetDisconnect(cellHandle, NULL) == 0);
 
@@ -348,6 +400,9 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoTime")
 {
     uDeviceHandle_t cellHandle;
     int64_t x;
+    int64_t y;
+    int32_t numSyncs;
+    uCellInfoTimeBaseStats_t timeBaseStats;
     int32_t heapUsed;
     char buffer[32] = {0};
 
@@ -376,6 +431,34 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoTime")
     U_PORT_TEST_ASSERT(uCellInfoGetTimeUtcStr(cellHandle, buffer, sizeof(buffer)) >= 0);
     U_TEST_PRINT_LINE("UTC time: %s.", buffer);
 
+    U_TEST_PRINT_LINE("testing the cached time base...");
+    U_PORT_TEST_ASSERT(uCellInfoTimeBaseGetStats(cellHandle, &timeBaseStats) < 0);
+    U_PORT_TEST_ASSERT(uCellInfoTimeBaseStart(cellHandle,
+                                              U_CELL_INFO_TIME_BASE_RESYNC_PERIOD_MAX_SECONDS + 1) < 0);
+    U_PORT_TEST_ASSERT(uCellInfoTimeBaseStart(cellHandle, 0) == 0);
+    U_PORT_TEST_ASSERT(uCellInfoTimeBaseGetStats(cellHandle, &timeBaseStats) == 0);
+    U_PORT_TEST_ASSERT(timeBaseStats.numSyncs >= 1);
+    y = uCellInfoGetTimeUtc(cellHandle);
+    U_TEST_PRINT_LINE("UTC time from the time base is %d.", (int32_t) y);
+    // Allow a second either way for the resolution of the module time
+    U_PORT_TEST_ASSERT((y >= x - 1) && (y <= x + 1 + U_CELL_INFO_TEST_TIME_BASE_MARGIN_SECONDS));
+    // Subsequent reads should not need a resync, though a
+    // +CTZE, which might arrive at any time, could cause one
+    numSyncs = timeBaseStats.numSyncs - timeBaseStats.numUrcSyncs;
+    for (size_t z = 0; z < 10; z++) {
+        U_PORT_TEST_ASSERT(uCellInfoGetTimeUtc(cellHandle) >= y);
+    }
+    U_PORT_TEST_ASSERT(uCellInfoTimeBaseGetStats(cellHandle, &timeBaseStats) == 0);
+    U_TEST_PRINT_LINE("time base: %d sync(s), %d from +CTZE, last %d ms ago,"
+                      " last error %d ms, max error %d ms, drift %d ppm.",
+                      timeBaseStats.numSyncs, timeBaseStats.numUrcSyncs,
+                      timeBaseStats.lastSyncAgeMs, timeBaseStats.lastErrorMs,
+                      timeBaseStats.maxAbsErrorMs, timeBaseStats.lastDriftPpm);
+    U_PORT_TEST_ASSERT(timeBaseStats.numSyncs - timeBaseStats.numUrcSyncs <= numSyncs + 1);
+    U_PORT_TEST_ASSERT(timeBaseStats.lastSyncAgeMs >= 0);
+    uCellInfoTimeBaseStop(cellHandle);
+    U_PORT_TEST_ASSERT(uCellInfoTimeBaseGetStats(cellHandle, &timeBaseStats) < 0);
+
     // Disconnect
     U_PORT_TEST_ASSERT(uCellNetDisconnect(cellHandle, NULL) == 0);
 
@@ -68,6 +68,8 @@
 #include "u_cell_test_cfg.h"
 #include "u_cell_test_private.h"
 
+#include "u_bench.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -133,6 +135,30 @@ static bool keepGoingCallback(uDeviceHandle_t cellHandle)
     return keepGoing;
 }
 
+// Callback for uCellNetScan(): store the MCC/MNC of the first
+// network and end the scan.
+static bool scanCallback(uDeviceHandle_t cellHandle, const char *pName,
+                         const char *pMccMnc, uCellNetRat_t rat,
+                         void *pParameter)
+{
+    (void) pName;
+
+    // Note: not using asserts here as, when they go
+    // off, the seem to cause stack overruns
+    if (cellHandle != gHandles.cellHandle) {
+        gCallbackErrorCode = 9;
+    }
+    if ((rat <= U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) ||
+        (rat >= U_CELL_NET_RAT_MAX_NUM)) {
+        gCallbackErrorCode = 10;
+    }
+    if (pParameter != NULL) {
+        strncpy((char *) pParameter, pMccMnc, U_CELL_NET_MCC_MNC_LENGTH_BYTES - 1);
+    }
+
+    return false;
+}
+
 // Callback for registration status.
 static void registerCallback(uCellNetRegDomain_t domain,
                              uCellNetStatus_t status,
@@ -198,6 +224,8 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetConnectDisconnectPlus")
     const uCellPrivateModule_t *pModule;
     uCellNetStatus_t status;
     uCellNetRat_t rat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+    uCellNetRegistrationSnapshot_t snapshot;
+    uCellNetWarmStart_t warmStart;
     int32_t x;
     char buffer[U_CELL_NET_IP_ADDRESS_SIZE * 2];
     int32_t mcc = 0;
@@ -268,6 +296,7 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetConnectDisconnectPlus")
     // Now connect with a sensible timeout
     gStopTimeMs = uPortGetTickTimeMs() +
                   (U_CELL_TEST_CFG_CONNECT_TIMEOUT_SECONDS * 1000);
+    uBenchEnergyBegin("cellNetConnect");
     x = uCellNetConnect(cellHandle, NULL,
 #ifdef U_CELL_TEST_CFG_APN
                         U_PORT_STRINGIFY_QUOTED(U_CELL_TEST_CFG_APN),
@@ -285,6 +314,7 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetConnectDisconnectPlus")
                         NULL,
 #endif
                         keepGoingCallback);
+    uBenchEnergyEnd("cellNetConnect");
     U_PORT_TEST_ASSERT (x == 0);
 
     // Check that we're registered
@@ -303,6 +333,18 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetConnectDisconnectPlus")
     U_PORT_TEST_ASSERT((rat > U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) &&
                        (rat < U_CELL_NET_RAT_MAX_NUM));
 
+    // Check that the registration snapshot agrees
+    U_PORT_TEST_ASSERT(uCellNetGetRegistrationSnapshot(cellHandle, U_CELL_NET_REG_DOMAIN_PS,
+                                                       &snapshot) == 0);
+    U_TEST_PRINT_LINE("registration snapshot: status %d, RAT %d, cell ID 0x%x,"
+                      " area code 0x%x, %d ms old.", snapshot.status, snapshot.rat,
+                      snapshot.cellId, snapshot.areaCode,
+                      uPortGetTickTimeMs() - snapshot.updatedAtMs);
+    U_PORT_TEST_ASSERT(snapshot.status == status);
+    U_PORT_TEST_ASSERT(snapshot.rat == rat);
+    U_PORT_TEST_ASSERT(snapshot.updatedAtMs >= 0);
+    U_PORT_TEST_ASSERT(snapshot.updatedAtMs <= uPortGetTickTimeMs());
+
     if (U_CELL_PRIVATE_HAS(pModule, U_CELL_PRIVATE_FEATURE_CSCON)) {
         // Check that the connect status callback has been called.
         U_PORT_TEST_ASSERT(gConnectCallbackCalled);
@@ -399,6 +441,35 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetConnectDisconnectPlus")
     U_PORT_TEST_ASSERT(x > 0);
     U_PORT_TEST_ASSERT(strlen(buffer) == x);
 
+    // Store the warm start parameters and check them
+    memset(&warmStart, 0, sizeof(warmStart));
+    U_PORT_TEST_ASSERT(uCellNetGetWarmStart(cellHandle, &warmStart) == 0);
+    U_TEST_PRINT_LINE("warm start: operator %s, RAT %d, APN \"%s\".",
+                      warmStart.mccMnc, warmStart.rat, warmStart.apn);
+    U_PORT_TEST_ASSERT(warmStart.magic == U_CELL_NET_WARM_START_MAGIC);
+    snprintf(buffer, sizeof(buffer), "%03d%02d", (int) mcc, (int) mnc);
+    U_PORT_TEST_ASSERT(strcmp(warmStart.mccMnc, buffer) == 0);
+    U_PORT_TEST_ASSERT(warmStart.rat == rat);
+    U_PORT_TEST_ASSERT(strlen(warmStart.apn) > 0);
+
+    // Connecting warm with the stored parameters while already
+    // connected should also return pretty much immediately
+    gStopTimeMs = uPortGetTickTimeMs() + 5000;
+    U_TEST_PRINT_LINE("connecting again warm...");
+    x = uCellNetConnectWarm(cellHandle, &warmStart, NULL,
+#ifdef U_CELL_TEST_CFG_USERNAME
+                            U_PORT_STRINGIFY_QUOTED(U_CELL_TEST_CFG_USERNAME),
+#else
+                            NULL,
+#endif
+#ifdef U_CELL_TEST_CFG_PASSWORD
+                            U_PORT_STRINGIFY_QUOTED(U_CELL_TEST_CFG_PASSWORD),
+#else
+                            NULL,
+#endif
+                            keepGoingCallback);
+    U_PORT_TEST_ASSERT(x == 0);
+
 #ifndef U_CELL_TEST_NO_INVALID_APN
     // The compilation switch is for live networks which may just ignore
     // invalid APNs and employ the correct default, resulting in successful
@@ -527,6 +598,25 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetScanRegActDeact")
     // Must be at least one, can't guarantee more than that
     U_PORT_TEST_ASSERT(y > 0);
 
+    // Now scan again with the streaming API, ending the scan at
+    // the first network
+    y = 0;
+    for (size_t x = 5; (x > 0) && (y <= 0); x--) {
+        U_TEST_PRINT_LINE("scanning for the first network...");
+        gStopTimeMs = uPortGetTickTimeMs() +
+                      (U_CELL_TEST_CFG_CONNECT_TIMEOUT_SECONDS * 1000);
+        memset(mccMnc, 0, sizeof(mccMnc));
+        y = uCellNetScan(cellHandle, scanCallback, mccMnc, keepGoingCallback);
+        if (y <= 0) {
+            U_TEST_PRINT_LINE("*** WARNING *** RETRY SCAN.");
+            uPortTaskBlock(5000);
+        }
+    }
+    U_TEST_PRINT_LINE("first network found was MCC/MNC %s.", mccMnc);
+    U_PORT_TEST_ASSERT(y == 1);
+    U_PORT_TEST_ASSERT(strlen(mccMnc) > 0);
+    U_PORT_TEST_ASSERT(gCallbackErrorCode == 0);
+
     // Register with a very short time-out to show that aborts work
     gStopTimeMs = uPortGetTickTimeMs() + 1000;
     U_PORT_TEST_ASSERT(uCellNetRegister(cellHandle, NULL, keepGoingCallback) < 0);
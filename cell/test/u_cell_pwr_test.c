@@ -197,6 +197,10 @@ static int64_t gStopTimeMs;
  */
 static int32_t gCallbackErrorCode = 0;
 
+/** The order in which the transmit scheduler made its sends.
+ */
+static char gTxScheduleOrder[U_CELL_PWR_TX_SCHEDULE_MAX_NUM + 2];
+
 # ifndef U_CFG_CELL_DISABLE_UART_POWER_SAVING
 
 /** TCP socket handle.
@@ -244,6 +248,21 @@ static bool keepGoingCallback(uDeviceHandle_t cellHandle)
     return keepGoing;
 }
 
+// Transmit scheduler send function: adds the character at pParam
+// to gTxScheduleOrder.
+static void txScheduleSend(uDeviceHandle_t cellHandle, void *pParam)
+{
+    size_t length = strlen(gTxScheduleOrder);
+
+    if (cellHandle != gHandles.cellHandle) {
+        gCallbackErrorCode = 2;
+    }
+    if (length < sizeof(gTxScheduleOrder) - 1) {
+        gTxScheduleOrder[length] = *((const char *) pParam);
+        gTxScheduleOrder[length + 1] = 0;
+    }
+}
+
 # if U_CFG_APP_PIN_CELL_PWR_ON >= 0
 
 // Test power on/off and aliveness, parameterised by the VInt pin.
@@ -775,6 +794,7 @@ U_PORT_TEST_FUNCTION("[cellPwr]", "cellPwr")
 U_PORT_TEST_FUNCTION("[cellPwr]", "cellPwrReboot")
 {
     int32_t heapUsed;
+    int32_t x;
     int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
 
     // In case a previous test failed
@@ -795,6 +815,99 @@ U_PORT_TEST_FUNCTION("[cellPwr]", "cellPwrReboot")
     U_PORT_TEST_ASSERT(uCellPwrReboot(gHandles.cellHandle, NULL) == 0);
 
     U_PORT_TEST_ASSERT(uCellPwrIsAlive(gHandles.cellHandle));
+#ifndef U_CELL_PWR_READY_DETECT_DISABLE
+    // The reboot will have been timed
+    x = uCellPwrGetBootTimeMs(gHandles.cellHandle);
+    U_TEST_PRINT_LINE("reboot took %d ms.", x);
+    U_PORT_TEST_ASSERT(x > 0);
+#endif
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+/** Test the transmit scheduler; this only checks the ordering and
+ * holding of sends, it doesn't wait for a wake-up.
+ */
+U_PORT_TEST_FUNCTION("[cellPwr]", "cellPwrTxSchedule")
+{
+    uDeviceHandle_t cellHandle;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+    gCallbackErrorCode = 0;
+    gTxScheduleOrder[0] = 0;
+
+    U_PORT_TEST_ASSERT(uCellPwrTxGetNumPending(cellHandle) == 0);
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_NORMAL,
+                                          NULL, NULL) < 0);
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_MAX_NUM,
+                                          txScheduleSend, (void *) "x") < 0);
+
+    U_TEST_PRINT_LINE("holding some sends...");
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_LOW,
+                                          txScheduleSend, (void *) "c") == 0);
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_NORMAL,
+                                          txScheduleSend, (void *) "a") == 0);
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_NORMAL,
+                                          txScheduleSend, (void *) "b") == 0);
+    U_PORT_TEST_ASSERT(uCellPwrTxGetNumPending(cellHandle) == 3);
+    U_PORT_TEST_ASSERT(gTxScheduleOrder[0] == 0);
+
+    U_TEST_PRINT_LINE("sending something urgent...");
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_URGENT,
+                                          txScheduleSend, (void *) "u") == 0);
+    U_TEST_PRINT_LINE("sends were made in the order \"%s\".", gTxScheduleOrder);
+    U_PORT_TEST_ASSERT(strcmp(gTxScheduleOrder, "uabc") == 0);
+    U_PORT_TEST_ASSERT(uCellPwrTxGetNumPending(cellHandle) == 0);
+
+    U_TEST_PRINT_LINE("flushing...");
+    gTxScheduleOrder[0] = 0;
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_LOW,
+                                          txScheduleSend, (void *) "l") == 0);
+    U_PORT_TEST_ASSERT(uCellPwrTxFlush(cellHandle) == 1);
+    U_PORT_TEST_ASSERT(strcmp(gTxScheduleOrder, "l") == 0);
+    U_PORT_TEST_ASSERT(uCellPwrTxFlush(cellHandle) == 0);
+
+    U_TEST_PRINT_LINE("filling the scheduler...");
+    gTxScheduleOrder[0] = 0;
+    for (size_t x = 0; x < U_CELL_PWR_TX_SCHEDULE_MAX_NUM; x++) {
+        U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_LOW,
+                                              txScheduleSend, (void *) "f") == 0);
+    }
+    U_PORT_TEST_ASSERT(uCellPwrTxGetNumPending(cellHandle) == U_CELL_PWR_TX_SCHEDULE_MAX_NUM);
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_LOW,
+                                          txScheduleSend, (void *) "g") == 0);
+    U_PORT_TEST_ASSERT(strlen(gTxScheduleOrder) == U_CELL_PWR_TX_SCHEDULE_MAX_NUM + 1);
+    U_PORT_TEST_ASSERT(gTxScheduleOrder[0] == 'g');
+    U_PORT_TEST_ASSERT(uCellPwrTxGetNumPending(cellHandle) == 0);
+
+    // Leave one held to check that it is cleaned up
+    U_PORT_TEST_ASSERT(uCellPwrTxSchedule(cellHandle, U_CELL_PWR_TX_PRIORITY_LOW,
+                                          txScheduleSend, (void *) "z") == 0);
+    U_PORT_TEST_ASSERT(gCallbackErrorCode == 0);
 
     // Do the standard postamble, leaving the module on for the next
     // test to speed things up
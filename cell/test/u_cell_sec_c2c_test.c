@@ -36,6 +36,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "stdlib.h"    // rand()
 #include "string.h"    // memcpy(), memcmp(), strncpy(), strncat()
 #include "ctype.h"     // isdigit()
 
@@ -149,6 +150,13 @@
 # define U_CELL_SEC_C2C_TEST_TASK_PRIORITY U_AT_CLIENT_URC_TASK_PRIORITY
 #endif
 
+#ifndef U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS
+/** The number of maximum-length chunks to pass through chip to chip
+ * security when measuring its cost.
+ */
+# define U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS 200
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -712,6 +720,10 @@ static void checkEncrypted(size_t testIndex,
         if (pDecrypted != NULL) {
             U_PORT_TEST_ASSERT(memcmp(pDecrypted, pTestData->pClear + previousLength,
                                       pTestData->clearLength[chunkIndex]) == 0);
+            // The decrypted data may not be in the receive buffer,
+            // so do what the AT client would do and move it there
+            memmove(gBufferB + U_CELL_SEC_C2C_GUARD_LENGTH_BYTES + previousLength,
+                    pDecrypted, length);
         }
     }
 }
@@ -899,10 +911,11 @@ static void atServerCallback(int32_t uartHandle, uint32_t eventBitmask,
                     U_TEST_PRINT_LINE_X("AT server decrypted %d byte(s):",
                                         gAtTestCount + 1, interceptLength);
                     printBlock(pDecrypted, interceptLength, false, gAtTestCount + 1);
-                    // Out intercept function returns a pointer to the
-                    // start of the decrypted data in the buffer, i.e.
-                    // to the value of pData when it was called, so just need
-                    // to shuffle everything down so that the next pData
+                    // Our intercept function returns a pointer to the
+                    // decrypted data, which may not be in the buffer, so
+                    // first do what the AT client does and move it to
+                    // where pData was when it was called, then shuffle
+                    // everything down so that the next pData
                     // we provide to the intercept function will be
                     // contiguous with the already decrypted data.
                     // The buffer is as below where "sizeOrError"
@@ -922,6 +935,7 @@ static void atServerCallback(int32_t uartHandle, uint32_t eventBitmask,
                     //
                     // y is the amount of data to move
                     y = pTmp + sizeOrError + x - pData;
+                    memmove(pTmp + sizeOrError, pDecrypted, interceptLength);
                     // Grow size
                     sizeOrError += (int32_t) interceptLength;
                     // Do the move
@@ -1356,6 +1370,117 @@ U_PORT_TEST_FUNCTION("[cellSecC2c]", "cellSecC2cIntercept")
 #endif
 }
 
+/** Measure the cost of chip to chip security: pass maximum-length
+ * chunks through the transmit and then the receive intercept
+ * functions, as they would be in the AT client, and compare the
+ * time taken with that of the copies that the data goes through
+ * without chip to chip security.  Nothing is asserted about the
+ * time taken, just printed, since it depends on the platform.
+ */
+U_PORT_TEST_FUNCTION("[cellSecC2c]", "cellSecC2cThroughput")
+{
+    char *pClear = gBufferA + U_CELL_SEC_C2C_GUARD_LENGTH_BYTES;
+    char *pWire = gBufferB + U_CELL_SEC_C2C_GUARD_LENGTH_BYTES;
+    // Where the AT client would put the received data: well beyond
+    // the longest encrypted chunk
+    char *pReceived = pWire + (U_CELL_SEC_C2C_CHUNK_MAX_LENGTH_BYTES * 2);
+    const char *pData;
+    const char *pOut;
+    char *pIn;
+    char *pDecrypted;
+    size_t clearLength = U_CELL_SEC_C2C_USER_MAX_TX_LENGTH_BYTES - 1;
+    size_t length;
+    size_t totalBytes = clearLength * U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t baselineDurationMs;
+    int32_t heapUsed;
+
+    initGuards();
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+
+    // See cellSecC2cIntercept for why this is here
+    uPortCryptoSha256(NULL, 0, pReceived);
+
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    for (size_t x = 0; x < clearLength; x++) {
+        *(pClear + x) = (char) rand();
+    }
+
+    // The baseline: without chip to chip security the data is
+    // written to the stream and then the AT client moves what it
+    // receives into place
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS; x++) {
+        memcpy(pWire, pClear, clearLength);
+        memmove(pReceived, pWire, clearLength);
+    }
+    baselineDurationMs = uPortGetTickTimeMs() - startTimeMs;
+
+    gContext.pTx = &gContextTx;
+    gContext.pRx = &gContextRx;
+    memcpy(gContext.teSecret, U_CELL_SEC_C2C_TEST_TE_SECRET, sizeof(gContext.teSecret));
+    memcpy(gContext.key, U_CELL_SEC_C2C_TEST_KEY, sizeof(gContext.key));
+    memcpy(gContext.hmacKey, U_CELL_SEC_C2C_TEST_HMAC_TAG, sizeof(gContext.hmacKey));
+    gContext.pTx->txInLimit = U_CELL_SEC_C2C_USER_MAX_TX_LENGTH_BYTES;
+    U_TEST_PRINT_LINE("%d byte(s) in %d byte chunks, without chip to chip"
+                      " security %d ms.", totalBytes, clearLength, baselineDurationMs);
+
+    for (size_t v = 0; v < 2; v++) {
+        gContext.isV2 = (v > 0);
+        gContext.pTx->txInLength = 0;
+        startTimeMs = uPortGetTickTimeMs();
+        for (size_t x = 0; x < U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS; x++) {
+            // Collect the data and flush it out as a chunk
+            pData = pClear;
+            length = clearLength;
+            pUCellSecC2cInterceptTx(0, &pData, &length, &gContext);
+            length = 0;
+            pOut = pUCellSecC2cInterceptTx(0, NULL, &length, &gContext);
+            U_PORT_TEST_ASSERT(pOut != NULL);
+            memcpy(pWire, pOut, length);
+            // Decode it and move it into place as the AT client would
+            pIn = pWire;
+            pDecrypted = pUCellSecC2cInterceptRx(0, &pIn, &length, &gContext);
+            U_PORT_TEST_ASSERT(pDecrypted != NULL);
+            U_PORT_TEST_ASSERT(length == clearLength);
+            memmove(pReceived, pDecrypted, length);
+        }
+        durationMs = uPortGetTickTimeMs() - startTimeMs;
+        U_PORT_TEST_ASSERT(memcmp(pReceived,
+                                  pClear, clearLength) == 0);
+        U_TEST_PRINT_LINE("with V%d chip to chip security %d ms, i.e. an added"
+                          " %d microsecond(s) per kbyte.", v + 1, durationMs,
+                          (int32_t) ((((int64_t) (durationMs - baselineDurationMs)) *
+                                      1000 * 1024) / (int64_t) totalBytes));
+    }
+
+    U_CELL_SEC_C2C_CHECK_GUARD_UNDERRUN(gBufferA);
+    U_CELL_SEC_C2C_CHECK_GUARD_OVERRUN(gBufferA);
+    U_CELL_SEC_C2C_CHECK_GUARD_UNDERRUN(gBufferB);
+    U_CELL_SEC_C2C_CHECK_GUARD_OVERRUN(gBufferB);
+
+    uPortDeinit();
+
+#ifndef __XTENSA__
+    // Check for memory leaks: see cellSecC2cIntercept for why
+    // this is if'ed out for ESP32
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+#else
+    (void) heapUsed;
+#endif
+}
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
 
 /** Test use of the intercept functions inside the AT client
@@ -23,23 +23,24 @@
 /** @file
  * @brief Tests for the cellular sockets API: these should pass on all
  * platforms that have a cellular module connected to them.  They
- * are only compiled if U_CFG_TEST_CELL_MODULE_TYPE is defined.
+ * are only compiled if U_CFG_TEST_CELL_MODULE_TYPE is defined, except
+ * for cellSockReadAhead, which needs no module but two UARTs that are
+ * cross-connected, a dummy AT server on one pretending to be the module.
  * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
  * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
  * macro.
  */
 
-#ifdef U_CFG_TEST_CELL_MODULE_TYPE
-
-# ifdef U_CFG_OVERRIDE
-#  include "u_cfg_override.h" // For a customer's configuration override
-# endif
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
 
-#include "stdlib.h"    // rand()
+#include "stdlib.h"    // rand(), strtol()
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memset()
+#include "stdio.h"     // snprintf()
+#include "string.h"    // memset(), strncmp()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_os_platform_specific.h"
@@ -48,6 +49,9 @@
 
 #include "u_error_common.h"
 
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
 #include "u_port.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"   // Required by u_cell_private.h
@@ -55,6 +59,7 @@
 
 #include "u_at_client.h"
 
+#include "u_sock_errno.h"
 #include "u_sock.h"
 
 #include "u_cell_module_type.h"
@@ -82,6 +87,8 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
+#ifdef U_CFG_TEST_CELL_MODULE_TYPE
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -305,6 +312,14 @@ static uCellSockTestOption_t gSupportedOptions[] = {
         (1UL << U_CELL_MODULE_TYPE_LARA_R6),
         U_SOCK_OPT_LEVEL_SOCK, U_SOCK_OPT_LINGER, sizeof(uSockLinger_t), compareLinger, changeLinger
     },
+    {
+        0, /* All modules: this one is local */
+        U_SOCK_OPT_LEVEL_SOCK, U_SOCK_OPT_READ_PRIORITY, sizeof(int32_t), compareInt32, changeMod256
+    },
+    {
+        0, /* All modules: this one is local */
+        U_SOCK_OPT_LEVEL_SOCK, U_SOCK_OPT_READ_AHEAD, sizeof(int32_t), compareInt32, changeMod256
+    },
     {
         0, /* All modules */
         U_SOCK_OPT_LEVEL_IP, U_SOCK_OPT_IP_TOS, sizeof(int32_t), compareInt32, changeMod256
@@ -536,6 +551,8 @@ U_PORT_TEST_FUNCTION("[cellSock]", "cellSockBasic")
     size_t count;
     char *pBuffer;
     int32_t heapUsed;
+    int32_t directLink;
+    size_t length;
 
     // In case a previous test failed
     uCellSockDeinit();
@@ -814,6 +831,54 @@ U_PORT_TEST_FUNCTION("[cellSock]", "cellSockBasic")
         U_PORT_TEST_ASSERT(!gClosedCallbackCalledTcp);
     }
 
+    // Do it all again with the TCP socket in direct link mode
+    U_TEST_PRINT_LINE("sending %d byte(s) over TCP in direct link mode...",
+                      sizeof(gAllChars));
+    directLink = 1;
+    U_PORT_TEST_ASSERT(uCellSockOptionSet(cellHandle, gSockHandleTcp,
+                                          U_SOCK_OPT_LEVEL_SOCK,
+                                          U_SOCK_OPT_DIRECT_LINK,
+                                          (void *) &directLink, sizeof(directLink)) == 0);
+    directLink = 0;
+    length = sizeof(directLink);
+    U_PORT_TEST_ASSERT(uCellSockOptionGet(cellHandle, gSockHandleTcp,
+                                          U_SOCK_OPT_LEVEL_SOCK,
+                                          U_SOCK_OPT_DIRECT_LINK,
+                                          (void *) &directLink, &length) == 0);
+    U_PORT_TEST_ASSERT(directLink == 1);
+    // Nothing else can use the AT interface meanwhile
+    U_PORT_TEST_ASSERT(uCellSockSendTo(cellHandle, gSockHandleUdp,
+                                       &echoServerAddressUdp,
+                                       gAllChars, 1) == -U_SOCK_EBUSY);
+    U_PORT_TEST_ASSERT(uCellSockWrite(cellHandle, gSockHandleTcp,
+                                      gAllChars,
+                                      sizeof(gAllChars)) == sizeof(gAllChars));
+    y = 0;
+    memset(pBuffer, 0, U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES);
+    for (count = 0; (y < sizeof(gAllChars)) && (count < 20); count++) {
+        z = uCellSockRead(cellHandle, gSockHandleTcp, pBuffer + y,
+                          sizeof(gAllChars) - y);
+        if (z > 0) {
+            y += z;
+        } else {
+            uPortTaskBlock(500);
+        }
+    }
+    U_TEST_PRINT_LINE("%d byte(s) echoed over TCP in direct link mode.", y);
+    U_PORT_TEST_ASSERT(memcmp(pBuffer, gAllChars, sizeof(gAllChars)) == 0);
+    directLink = 0;
+    U_PORT_TEST_ASSERT(uCellSockOptionSet(cellHandle, gSockHandleTcp,
+                                          U_SOCK_OPT_LEVEL_SOCK,
+                                          U_SOCK_OPT_DIRECT_LINK,
+                                          (void *) &directLink, sizeof(directLink)) == 0);
+    directLink = 1;
+    length = sizeof(directLink);
+    U_PORT_TEST_ASSERT(uCellSockOptionGet(cellHandle, gSockHandleTcp,
+                                          U_SOCK_OPT_LEVEL_SOCK,
+                                          U_SOCK_OPT_DIRECT_LINK,
+                                          (void *) &directLink, &length) == 0);
+    U_PORT_TEST_ASSERT(directLink == 0);
+
     // Sockets should both still be open
     U_PORT_TEST_ASSERT(!gClosedCallbackCalledUdp);
     U_PORT_TEST_ASSERT(!gClosedCallbackCalledTcp);
@@ -1088,4 +1153,435 @@ U_PORT_TEST_FUNCTION("[cellSock]", "cellSockCleanUp")
 
 #endif // #ifdef U_CFG_TEST_CELL_MODULE_TYPE
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: READ-AHEAD
+ * -------------------------------------------------------------- */
+
+#ifndef U_CELL_SOCK_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that runs the dummy AT server.
+ */
+# define U_CELL_SOCK_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES 2304
+#endif
+
+#ifndef U_CELL_SOCK_TEST_AT_SERVER_TASK_PRIORITY
+/** The priority of the task that runs the dummy AT server.
+ */
+# define U_CELL_SOCK_TEST_AT_SERVER_TASK_PRIORITY U_AT_CLIENT_URC_TASK_PRIORITY
+#endif
+
+/** The size of read-ahead cache to use.
+ */
+#define U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES 64
+
+/** How long to wait for something asynchronous to happen.
+ */
+#define U_CELL_SOCK_TEST_READ_AHEAD_WAIT_MS 5000
+
+/* ----------------------------------------------------------------
+ * VARIABLES: READ-AHEAD
+ * -------------------------------------------------------------- */
+
+/** Handle of the UART the AT client is on.
+ */
+static int32_t gUartAHandle = -1;
+
+/** Handle of the UART the dummy AT server is on.
+ */
+static int32_t gUartBHandle = -1;
+
+/** The line the dummy AT server is assembling.
+ */
+static char gAtServerLine[64];
+
+/** The length of gAtServerLine.
+ */
+static size_t gAtServerLineLength = 0;
+
+/** The number of bytes the dummy AT server has waiting to be read.
+ */
+static volatile int32_t gAtServerPendingBytes = 0;
+
+/** The offset of the next byte the dummy AT server will send.
+ */
+static volatile size_t gAtServerDataOffset = 0;
+
+/** The number of times the dummy AT server has been asked to send
+ * data with AT+USORD, not counting queries of the amount waiting.
+ */
+static volatile size_t gAtServerUsordCount = 0;
+
+/** The number of times the data callback has been called.
+ */
+static volatile size_t gReadAheadDataCallbackCount = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: READ-AHEAD
+ * -------------------------------------------------------------- */
+
+// The byte of received data at the given offset.
+static char readAheadData(size_t offset)
+{
+    return (char) ('a' + (offset % 26));
+}
+
+// Check that some received data is what the dummy AT server sent,
+// starting at the given offset.
+static bool readAheadDataCheck(const char *pData, size_t length, size_t offset)
+{
+    bool isGood = true;
+
+    for (size_t x = 0; (x < length) && isGood; x++) {
+        isGood = (*(pData + x) == readAheadData(offset + x));
+    }
+
+    return isGood;
+}
+
+// Write a string to the UART of the dummy AT server.
+static void atServerWrite(int32_t uartHandle, const char *pStr)
+{
+    uPortUartWrite(uartHandle, pStr, strlen(pStr));
+}
+
+// Respond to an AT command as a cellular module would, just
+// enough for the read-ahead cache to be tested.
+static void atServerRespond(int32_t uartHandle, const char *pLine)
+{
+    char buffer[U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES + 32];
+    const char *pStr;
+    int32_t length = 0;
+    size_t x;
+
+    if (strncmp(pLine, "AT+USOCR=", 9) == 0) {
+        atServerWrite(uartHandle, "\r\n+USOCR: 0\r\n\r\nOK\r\n");
+    } else if (strncmp(pLine, "AT+USORD=", 9) == 0) {
+        pStr = strchr(pLine, ',');
+        if (pStr != NULL) {
+            length = strtol(pStr + 1, NULL, 10);
+        }
+        if (length == 0) {
+            // Just a query of how much is waiting
+            snprintf(buffer, sizeof(buffer), "\r\n+USORD: 0,%d\r\n\r\nOK\r\n",
+                     (int) gAtServerPendingBytes);
+            atServerWrite(uartHandle, buffer);
+        } else {
+            if (length > gAtServerPendingBytes) {
+                length = gAtServerPendingBytes;
+            }
+            if (length > U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES) {
+                // Keep it within our buffer, the AT client
+                // will come back for the rest
+                length = U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES;
+            }
+            x = snprintf(buffer, sizeof(buffer), "\r\n+USORD: 0,%d,\"", (int) length);
+            for (int32_t y = 0; y < length; y++) {
+                buffer[x] = readAheadData(gAtServerDataOffset);
+                gAtServerDataOffset++;
+                x++;
+            }
+            buffer[x] = 0;
+            gAtServerPendingBytes -= length;
+            gAtServerUsordCount++;
+            atServerWrite(uartHandle, buffer);
+            atServerWrite(uartHandle, "\"\r\n\r\nOK\r\n");
+        }
+    } else {
+        // Anything else, e.g. AT+USOCL, just works
+        atServerWrite(uartHandle, "\r\nOK\r\n");
+    }
+}
+
+// Callback for data arriving at the dummy AT server: assembles
+// lines and responds to each one.
+static void atServerCallback(int32_t uartHandle, uint32_t eventBitmask,
+                             void *pParameters)
+{
+    char buffer[32];
+    int32_t length;
+
+    (void) pParameters;
+
+    if (eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) {
+        do {
+            length = uPortUartRead(uartHandle, buffer, sizeof(buffer));
+            for (int32_t x = 0; x < length; x++) {
+                if (buffer[x] == '\r') {
+                    gAtServerLine[gAtServerLineLength] = 0;
+                    if (gAtServerLineLength > 0) {
+                        atServerRespond(uartHandle, gAtServerLine);
+                    }
+                    gAtServerLineLength = 0;
+                } else if ((buffer[x] != '\n') &&
+                           (gAtServerLineLength < sizeof(gAtServerLine) - 1)) {
+                    gAtServerLine[gAtServerLineLength] = buffer[x];
+                    gAtServerLineLength++;
+                }
+            }
+        } while (length > 0);
+    }
+}
+
+// Callback for data received on a socket.
+static void readAheadDataCallback(uDeviceHandle_t cellHandle,
+                                  int32_t sockHandle)
+{
+    (void) cellHandle;
+    (void) sockHandle;
+
+    gReadAheadDataCallbackCount++;
+}
+
+// Have the dummy AT server send a +UUSORD URC, saying that the given
+// amount of data is waiting, and wait for the data callback.
+static bool readAheadUrc(int32_t length)
+{
+    char buffer[32];
+    size_t callbackCount = gReadAheadDataCallbackCount;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+
+    gAtServerPendingBytes = length;
+    snprintf(buffer, sizeof(buffer), "\r\n+UUSORD: 0,%d\r\n", (int) length);
+    atServerWrite(gUartBHandle, buffer);
+    while ((gReadAheadDataCallbackCount == callbackCount) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_CELL_SOCK_TEST_READ_AHEAD_WAIT_MS)) {
+        uPortTaskBlock(10);
+    }
+
+    return (gReadAheadDataCallbackCount != callbackCount);
+}
+
+// Set the read-ahead option of a socket.
+static int32_t readAheadSet(uDeviceHandle_t cellHandle, int32_t sockHandle,
+                            int32_t size)
+{
+    return uCellSockOptionSet(cellHandle, sockHandle, U_SOCK_OPT_LEVEL_SOCK,
+                              U_SOCK_OPT_READ_AHEAD, &size, sizeof(size));
+}
+
+// Get the read-ahead option of a socket, -1 on error.
+static int32_t readAheadGet(uDeviceHandle_t cellHandle, int32_t sockHandle)
+{
+    int32_t size = -1;
+    size_t length = sizeof(size);
+
+    if ((uCellSockOptionGet(cellHandle, sockHandle, U_SOCK_OPT_LEVEL_SOCK,
+                            U_SOCK_OPT_READ_AHEAD, &size, &length) != 0) ||
+        (length != sizeof(size))) {
+        size = -1;
+    }
+
+    return size;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: READ-AHEAD
+ * -------------------------------------------------------------- */
+
+/** Test the read-ahead cache of a socket, see #U_SOCK_OPT_READ_AHEAD,
+ * against a dummy AT server that pretends to be a cellular module:
+ * setting and getting the option, the cache being filled by the
+ * data callback and by a small read, reads served from the cache
+ * with no AT traffic, partial reads and the cache going with the
+ * socket when it is closed.
+ */
+U_PORT_TEST_FUNCTION("[cellSock]", "cellSockReadAhead")
+{
+    uAtClientHandle_t atClientHandle;
+    uDeviceHandle_t cellHandle;
+    int32_t sockHandle;
+    size_t length = 0;
+    size_t offset = 0;
+    char buffer[U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES * 4];
+    int32_t startTimeMs;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    gUartAHandle = uPortUartOpen(U_CFG_TEST_UART_A,
+                                 U_CFG_TEST_BAUD_RATE,
+                                 NULL,
+                                 U_CELL_UART_BUFFER_LENGTH_BYTES,
+                                 U_CFG_TEST_PIN_UART_A_TXD,
+                                 U_CFG_TEST_PIN_UART_A_RXD,
+                                 U_CFG_TEST_PIN_UART_A_CTS,
+                                 U_CFG_TEST_PIN_UART_A_RTS);
+    U_PORT_TEST_ASSERT(gUartAHandle >= 0);
+    gUartBHandle = uPortUartOpen(U_CFG_TEST_UART_B,
+                                 U_CFG_TEST_BAUD_RATE,
+                                 NULL,
+                                 U_CELL_UART_BUFFER_LENGTH_BYTES,
+                                 U_CFG_TEST_PIN_UART_B_TXD,
+                                 U_CFG_TEST_PIN_UART_B_RXD,
+                                 U_CFG_TEST_PIN_UART_B_CTS,
+                                 U_CFG_TEST_PIN_UART_B_RTS);
+    U_PORT_TEST_ASSERT(gUartBHandle >= 0);
+
+    U_TEST_PRINT_LINE("AT client on UART %d, dummy AT server on UART %d,"
+                      " make sure they are cross-connected.",
+                      U_CFG_TEST_UART_A, U_CFG_TEST_UART_B);
+    gAtServerLineLength = 0;
+    gAtServerPendingBytes = 0;
+    gAtServerDataOffset = 0;
+    gAtServerUsordCount = 0;
+    gReadAheadDataCallbackCount = 0;
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(gUartBHandle,
+                                                 U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                 atServerCallback, NULL,
+                                                 U_CELL_SOCK_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES,
+                                                 U_CELL_SOCK_TEST_AT_SERVER_TASK_PRIORITY) == 0);
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+    U_PORT_TEST_ASSERT(uCellInit() == 0);
+    U_PORT_TEST_ASSERT(uCellSockInit() == 0);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_CELL_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    U_PORT_TEST_ASSERT(uCellAdd(U_CELL_MODULE_TYPE_SARA_R5, atClientHandle,
+                                -1, -1, -1, false, &cellHandle) == 0);
+    U_PORT_TEST_ASSERT(uCellSockInitInstance(cellHandle) == 0);
+
+    sockHandle = uCellSockCreate(cellHandle, U_SOCK_TYPE_STREAM, U_SOCK_PROTOCOL_TCP);
+    U_PORT_TEST_ASSERT(sockHandle >= 0);
+
+    // The option is off to start with, can be set, read back and
+    // switched off again; out of range values are rejected
+    U_PORT_TEST_ASSERT(uCellSockOptionGet(cellHandle, sockHandle, U_SOCK_OPT_LEVEL_SOCK,
+                                          U_SOCK_OPT_READ_AHEAD, NULL, &length) == 0);
+    U_PORT_TEST_ASSERT(length == sizeof(int32_t));
+    U_PORT_TEST_ASSERT(readAheadGet(cellHandle, sockHandle) == 0);
+    U_PORT_TEST_ASSERT(readAheadSet(cellHandle, sockHandle, -1) < 0);
+    U_PORT_TEST_ASSERT(readAheadSet(cellHandle, sockHandle,
+                                    U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES + 1) < 0);
+    U_PORT_TEST_ASSERT(readAheadSet(cellHandle, sockHandle,
+                                    U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES) == 0);
+    U_PORT_TEST_ASSERT(readAheadGet(cellHandle,
+                                    sockHandle) == U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(readAheadSet(cellHandle, sockHandle, 0) == 0);
+    U_PORT_TEST_ASSERT(readAheadGet(cellHandle, sockHandle) == 0);
+    U_PORT_TEST_ASSERT(readAheadSet(cellHandle, sockHandle,
+                                    U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES) == 0);
+
+    // Data arriving with a data callback registered: the cache is
+    // filled, with a single AT+USORD, before the callback is called
+    uCellSockRegisterCallbackData(cellHandle, sockHandle, readAheadDataCallback);
+    U_PORT_TEST_ASSERT(readAheadUrc(40));
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 1);
+    U_PORT_TEST_ASSERT(gAtServerPendingBytes == 0);
+
+    // Reads are now served from the cache, with no AT+USORD
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer, 10) == 10);
+    U_PORT_TEST_ASSERT(readAheadDataCheck(buffer, 10, offset));
+    offset += 10;
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer, 25) == 25);
+    U_PORT_TEST_ASSERT(readAheadDataCheck(buffer, 25, offset));
+    offset += 25;
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 1);
+
+    // While there is data in the cache its size can't be changed,
+    // though setting the same size again is fine
+    U_PORT_TEST_ASSERT(readAheadSet(cellHandle, sockHandle,
+                                    U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES / 2) == -U_SOCK_EBUSY);
+    U_PORT_TEST_ASSERT(readAheadSet(cellHandle, sockHandle,
+                                    U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES) == 0);
+    U_PORT_TEST_ASSERT(readAheadGet(cellHandle,
+                                    sockHandle) == U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES);
+
+    // A read for more than is left in the cache gets what is left
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer, 20) == 5);
+    U_PORT_TEST_ASSERT(readAheadDataCheck(buffer, 5, offset));
+    offset += 5;
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 1);
+
+    // With nothing left anywhere the module is asked and has nothing
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer,
+                                     10) == -U_SOCK_EWOULDBLOCK);
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 1);
+
+    // Without a data callback, a read smaller than the cache fills
+    // the cache with one AT+USORD and the next small read is
+    // served from it
+    uCellSockRegisterCallbackData(cellHandle, sockHandle, NULL);
+    gAtServerPendingBytes = 100;
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer, 8) == 8);
+    U_PORT_TEST_ASSERT(readAheadDataCheck(buffer, 8, offset));
+    offset += 8;
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 2);
+    U_PORT_TEST_ASSERT(gAtServerPendingBytes == 100 - U_CELL_SOCK_TEST_READ_AHEAD_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer, 8) == 8);
+    U_PORT_TEST_ASSERT(readAheadDataCheck(buffer, 8, offset));
+    offset += 8;
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 2);
+
+    // A read larger than the cache empties the cache first and then
+    // goes straight to the module for the rest
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer, sizeof(buffer)) == 84);
+    U_PORT_TEST_ASSERT(readAheadDataCheck(buffer, 84, offset));
+    offset += 84;
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 3);
+    U_PORT_TEST_ASSERT(gAtServerPendingBytes == 0);
+    U_PORT_TEST_ASSERT(gAtServerDataOffset == offset);
+
+    // Fill the cache again and close the socket: the cached data
+    // goes with it, a new socket has no cache and nothing to read
+    uCellSockRegisterCallbackData(cellHandle, sockHandle, readAheadDataCallback);
+    U_PORT_TEST_ASSERT(readAheadUrc(20));
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 4);
+    U_PORT_TEST_ASSERT(uCellSockClose(cellHandle, sockHandle, NULL) == 0);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((readAheadGet(cellHandle, sockHandle) >= 0) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_CELL_SOCK_TEST_READ_AHEAD_WAIT_MS)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(readAheadGet(cellHandle, sockHandle) < 0);
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer, 10) < 0);
+    sockHandle = uCellSockCreate(cellHandle, U_SOCK_TYPE_STREAM, U_SOCK_PROTOCOL_TCP);
+    U_PORT_TEST_ASSERT(sockHandle >= 0);
+    U_PORT_TEST_ASSERT(readAheadGet(cellHandle, sockHandle) == 0);
+    U_PORT_TEST_ASSERT(uCellSockRead(cellHandle, sockHandle, buffer,
+                                     10) == -U_SOCK_EWOULDBLOCK);
+    U_PORT_TEST_ASSERT(gAtServerUsordCount == 4);
+    U_PORT_TEST_ASSERT(uCellSockClose(cellHandle, sockHandle, NULL) == 0);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((readAheadGet(cellHandle, sockHandle) >= 0) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_CELL_SOCK_TEST_READ_AHEAD_WAIT_MS)) {
+        uPortTaskBlock(10);
+    }
+
+    uCellSockDeinit();
+    uCellDeinit();
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+
+    uPortDeinit();
+
+#ifndef __XTENSA__
+    // Check for memory leaks
+    // TODO: this if'ed out for ESP32 (xtensa compiler) at
+    // the moment as there is an issue with ESP32 hanging
+    // on to memory in the UART drivers that can't easily be
+    // accounted for.
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+#else
+    (void) heapUsed;
+#endif
+}
+
+#endif // #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+
 // End of file
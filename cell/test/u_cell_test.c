@@ -36,6 +36,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // strcmp()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_app_platform_specific.h"
@@ -53,6 +54,8 @@
 #include "u_cell_module_type.h"
 #include "u_cell.h"
 
+#include "u_cell_apn_db.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -242,6 +245,40 @@ U_PORT_TEST_FUNCTION("[cell]", "cellAdd")
 }
 #endif
 
+/** Check that the APN database is sorted and that look-ups,
+ * including those inside a range of MNCs and with three-digit
+ * MNCs, find the right entries; needs no module.
+ */
+U_PORT_TEST_FUNCTION("[cell]", "cellApnDb")
+{
+    size_t numEntries = sizeof(gApnLookUpTable) / sizeof(gApnLookUpTable[0]);
+
+    for (size_t x = 1; x < numEntries; x++) {
+        // Each entry must start after the range of the one before
+        U_PORT_TEST_ASSERT(gApnLookUpTable[x].key >=
+                           gApnLookUpTable[x - 1].key + gApnLookUpTable[x - 1].numMnc);
+    }
+
+    U_PORT_TEST_ASSERT(pApnGetConfig(NULL) == pApnDefault);
+    U_PORT_TEST_ASSERT(pApnGetConfig("") == pApnDefault);
+    U_PORT_TEST_ASSERT(pApnGetConfig("2620") == pApnDefault);
+    U_PORT_TEST_ASSERT(pApnGetConfig("001011234567890") == pApnDefault);
+#if U_CELL_APN_DB_REGIONS & U_CELL_APN_DB_REGION_EUROPE
+    U_PORT_TEST_ASSERT(strcmp(pApnGetConfig("262021234567890"), "m2m.business") == 0);
+    U_PORT_TEST_ASSERT(strcmp(pApnGetConfig("234111234567890"), "mobile.o2.co.uk") == 0);
+    U_PORT_TEST_ASSERT(pApnGetConfig("234121234567890") == pApnDefault);
+#endif
+#if U_CELL_APN_DB_REGIONS & U_CELL_APN_DB_REGION_NORTH_AMERICA
+    U_PORT_TEST_ASSERT(strcmp(pApnGetConfig("310260123456789"), "epc.tmobile.com") == 0);
+    U_PORT_TEST_ASSERT(strcmp(pApnGetConfig("310410123456789"), "phone") == 0);
+#endif
+#if U_CELL_APN_DB_REGIONS & U_CELL_APN_DB_REGION_ASIA
+    U_PORT_TEST_ASSERT(strcmp(pApnGetConfig("440981234567890"), "open.softbank.ne.jp") == 0);
+    U_PORT_TEST_ASSERT(strcmp(pApnGetConfig("440391234567890"), "bmobilewap") == 0);
+    U_PORT_TEST_ASSERT(pApnGetConfig("440401234567890") != pApnGetConfig("440391234567890"));
+#endif
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
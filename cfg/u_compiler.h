@@ -86,6 +86,44 @@
 # define U_PACKED_STRUCT(NAME) struct __attribute__((packed)) NAME
 #endif
 
+/** U_MEMORY_BARRIER: the macro that should make any compiler emit a
+ * full memory barrier for the target, so that no memory access is
+ * moved, by the compiler or by the core, from one side of it to the
+ * other; used where data is shared without a mutex, e.g. with an
+ * interrupt.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition: x86 and x64 do not re-order
+ * stores with other stores or loads with other loads, hence a
+ * compiler barrier is all that is needed.
+ */
+# include <intrin.h>
+# define U_MEMORY_BARRIER() _ReadWriteBarrier()
+#else
+/** Default (GCC) definition.
+ */
+# define U_MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+/** U_ATOMIC_CAS32: the macro that should make any compiler emit an
+ * atomic compare-and-swap of a 32-bit value, i.e. if the value at
+ * pValue is oldValue replace it with newValue, evaluating to true if
+ * the swap was made, else false; a full memory barrier is implied.
+ * Used where data is shared without a mutex, e.g. with an interrupt.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition.
+ */
+# define U_ATOMIC_CAS32(pValue, oldValue, newValue) \
+      (_InterlockedCompareExchange((volatile long *) (pValue), \
+                                   (long) (newValue), (long) (oldValue)) == (long) (oldValue))
+#else
+/** Default (GCC) definition.
+ */
+# define U_ATOMIC_CAS32(pValue, oldValue, newValue) \
+      __sync_bool_compare_and_swap((pValue), (oldValue), (newValue))
+#endif
+
 #endif // _U_COMPILER_H_
 
 
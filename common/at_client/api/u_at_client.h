@@ -373,6 +373,53 @@ extern "C" {
 # define U_AT_CLIENT_CALLBACK_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
 #endif
 
+#ifndef U_AT_CLIENT_CALLBACK_QUEUE_LENGTH
+/** The default length of the callback queue of an AT client, the
+ * number of callbacks queued with uAtClientCallback() or
+ * uAtClientCallbackData() that may be waiting to run at any one
+ * time; this may be changed for a given AT client with
+ * uAtClientCallbackQueueLengthSet().  The queue is malloc()ed
+ * when the first callback is queued, each entry being around
+ * 20 bytes.
+ */
+# define U_AT_CLIENT_CALLBACK_QUEUE_LENGTH 10
+#endif
+
+#ifndef U_AT_CLIENT_BATCH_LINE_LENGTH_MAX_BYTES
+/** The maximum length of a command line, excluding the command
+ * delimiter, that uAtClientBatch() will assemble when
+ * concatenating extended AT commands.  This is kept well within
+ * the command line length limit of all u-blox modules.
+ */
+# define U_AT_CLIENT_BATCH_LINE_LENGTH_MAX_BYTES 128
+#endif
+
+#ifndef U_AT_CLIENT_PREPARED_COMMAND_BUFFER_LENGTH_BYTES
+/** The size of the buffer, on the stack of the calling task, in
+ * which uAtClientCommandPrepared() renders a command line; a
+ * command line longer than this is still sent correctly, just
+ * with more than one write to the stream.
+ */
+# define U_AT_CLIENT_PREPARED_COMMAND_BUFFER_LENGTH_BYTES 64
+#endif
+
+#ifndef U_AT_CLIENT_LATENCY_NUM_BUCKETS
+/** The number of buckets in each of the log2 latency histograms
+ * kept by uAtClientLatencyStart(): bucket 0 counts durations of
+ * zero milliseconds, bucket n durations from 2^(n - 1) to
+ * (2^n) - 1 milliseconds and the last bucket everything longer.
+ */
+# define U_AT_CLIENT_LATENCY_NUM_BUCKETS 16
+#endif
+
+#ifndef U_AT_CLIENT_LATENCY_PREFIX_MAX_LENGTH_BYTES
+/** The room for the prefix, including terminator, in a latency
+ * statistics entry, see uAtClientLatencyStart(); longer prefixes
+ * are truncated.
+ */
+# define U_AT_CLIENT_LATENCY_PREFIX_MAX_LENGTH_BYTES 16
+#endif
+
 #ifndef U_AT_CLIENT_MAX_NUM
 /** The maximum number of AT handlers that can be active at any
  * one time.
@@ -380,6 +427,23 @@ extern "C" {
 # define U_AT_CLIENT_MAX_NUM 5
 #endif
 
+/** Helper to define a #uAtClientPreparedCommand_t, e.g.:
+ *
+ * ```
+ * static const uAtClientPreparedCommand_t gUsord = U_AT_CLIENT_PREPARED_COMMAND("AT+USORD=", "dd");
+ * ```
+ *
+ * command must be a string literal, since its length is taken
+ * at compile time; see #uAtClientPreparedCommand_t for format.
+ */
+#define U_AT_CLIENT_PREPARED_COMMAND(command, format) {command, sizeof(command) - 1, format}
+
+/** Helper to make the skipMask parameter of uAtClientReadIntList():
+ * a mask that skips count parameters starting at index first (where
+ * the first parameter is index 0).
+ */
+#define U_AT_CLIENT_READ_INT_LIST_SKIP(first, count) ((((1UL << (count)) - 1) << (first)))
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -388,13 +452,14 @@ extern "C" {
  */
 typedef void *uAtClientHandle_t;
 
-/** The types of underlying stream APIs supported, currently
- * only UART.
+/** The types of underlying stream APIs supported.
  */
 //lint -estring(788, uAtClientStream_t::U_AT_CLIENT_STREAM_TYPE_MAX) Suppress not used within defaulted switch
 typedef enum {
     U_AT_CLIENT_STREAM_TYPE_UART,
     U_AT_CLIENT_STREAM_TYPE_EDM,
+    U_AT_CLIENT_STREAM_TYPE_CMUX, /**< a channel of a 3GPP 27.010
+                                       multiplexer, see u_cmux.h. */
     U_AT_CLIENT_STREAM_TYPE_MAX
 } uAtClientStream_t;
 
@@ -415,6 +480,136 @@ typedef struct {
     int32_t code;
 } uAtClientDeviceError_t;
 
+/** An entry in the latency statistics of an AT client, see
+ * uAtClientLatencyStart().
+ */
+typedef struct {
+    char prefix[U_AT_CLIENT_LATENCY_PREFIX_MAX_LENGTH_BYTES]; /**< the AT command up to
+                                                                   any "=" or "?", e.g.
+                                                                   "AT+CSQ", or the URC
+                                                                   prefix, e.g. "+CEREG:"
+                                                                   if isUrc is true. */
+    bool isUrc;     /**< true if this entry is for a URC. */
+    uint32_t count; /**< the number of times the AT command has had its
+                         response stopped or the URC has been handled. */
+    uint32_t histogram[U_AT_CLIENT_LATENCY_NUM_BUCKETS]; /**< for an AT command
+                                                              the time from the
+                                                              command being sent to
+                                                              its response being
+                                                              stopped (i.e. time to
+                                                              "OK"), for a URC the
+                                                              time spent handling it. */
+    uint32_t firstByteHistogram[U_AT_CLIENT_LATENCY_NUM_BUCKETS]; /**< for an AT command
+                                                                       the time from the
+                                                                       command being sent
+                                                                       to the first byte
+                                                                       of its response
+                                                                       arriving; unused
+                                                                       for a URC. */
+} uAtClientLatencyEntry_t;
+
+/** The definition of one command in a batch of AT commands, see
+ * uAtClientBatch().
+ */
+typedef struct {
+    const char *pCommand;        /**< the complete AT command string,
+                                      e.g. "AT+CGMI" or "AT+CFUN=1";
+                                      cannot be NULL. */
+    const char *pResponsePrefix; /**< the prefix of the information
+                                      response to the command, e.g.
+                                      "+CSQ:", NULL if the response
+                                      has no prefix; ignored if
+                                      pParser is NULL. */
+    /** the function that parses the information response to
+     * the command, NULL if the command has no information
+     * response.  It is called once uAtClientResponseStart()
+     * has matched pResponsePrefix and may use any of the
+     * uAtClientReadxxx()/uAtClientSkipxxx() functions, or call
+     * uAtClientResponseStart() again to read further lines of a
+     * multi-line response; it must NOT call uAtClientResponseStop().
+     * The first parameter is the AT client handle, the second the
+     * index of the command in the batch and the third pParserParam;
+     * it should return zero on success, else negative error code.
+     */
+    int32_t (*pParser) (uAtClientHandle_t, size_t, void *);
+    void *pParserParam;          /**< passed to pParser as its third
+                                      parameter, may be NULL. */
+} uAtClientBatchCommand_t;
+
+/** A prepared AT command, see uAtClientCommandPrepared(); best
+ * defined once, as a static const, with
+ * #U_AT_CLIENT_PREPARED_COMMAND.
+ */
+typedef struct {
+    const char *pCommand; /**< the start of the AT command, e.g.
+                               "AT+USORD="; cannot be NULL. */
+    size_t commandLength; /**< strlen() of pCommand. */
+    const char *pFormat;  /**< one character per parameter: 'd' for
+                               an int32_t, 'u' for a uint64_t, 's'
+                               for a string that is to be quoted and
+                               'S' for a string that is not; NULL or
+                               "" if the command has no parameters. */
+} uAtClientPreparedCommand_t;
+
+/** Statistics on the matching of URCs by an AT client, see
+ * uAtClientUrcStatsGet().
+ */
+typedef struct {
+    uint32_t numMatches;        /**< the number of URCs matched. */
+    uint32_t numCompares;       /**< the total number of prefix
+                                     compares performed in matching
+                                     those URCs. */
+    uint32_t lastMatchCompares; /**< the number of prefix compares
+                                     the last matched URC took. */
+    uint32_t maxMatchCompares;  /**< the largest number of prefix
+                                     compares any matched URC took. */
+} uAtClientUrcStats_t;
+
+/** Statistics on the callback queue of an AT client, see
+ * uAtClientCallbackStatsGet().
+ */
+typedef struct {
+    uint32_t numQueued;  /**< the number of callbacks queued. */
+    uint32_t numMerged;  /**< the number of calls to
+                              uAtClientCallbackData() that were
+                              merged with a callback that was
+                              already waiting to run. */
+    uint32_t numDropped; /**< the number of callbacks that could not
+                              be queued, e.g. because the queue was
+                              full; each of these will have been
+                              reported to the caller as an error. */
+    uint32_t maxDepth;   /**< the largest number of callbacks that
+                              have been waiting to run at any one
+                              time. */
+    uint32_t depth;      /**< the number of callbacks waiting to run
+                              now. */
+} uAtClientCallbackStats_t;
+
+/** Statistics on the wake-up handler of an AT client, see
+ * uAtClientWakeUpStatsGet().
+ */
+typedef struct {
+    uint32_t numWakeUps;            /**< the number of times the
+                                         wake-up handler has been
+                                         called. */
+    uint32_t numWakeUpsPerHour;     /**< numWakeUps scaled to an hour
+                                         of the time since the wake-up
+                                         handler was set. */
+    int32_t wakeUpDurationLastMs;   /**< how long the last call to
+                                         the wake-up handler took. */
+    int32_t wakeUpDurationMaxMs;    /**< the longest any call to the
+                                         wake-up handler has taken. */
+    int32_t wakeUpDurationTotalMs;  /**< the total time spent in the
+                                         wake-up handler; divide by
+                                         numWakeUps for the average. */
+    uint32_t numDeferred;           /**< the number of batches passed
+                                         to uAtClientBatchDeferrable()
+                                         that were held back. */
+    uint32_t numCoalesced;          /**< the number of deferred batches
+                                         that were sent without needing
+                                         a wake-up of their own. */
+} uAtClientWakeUpStats_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: INITIALISATION AND CONFIGURATION
  * -------------------------------------------------------------- */
@@ -762,6 +957,40 @@ void uAtClientWritePartialString(uAtClientHandle_t atHandle,
                                  bool isFirst,
                                  const char *pParam);
 
+/** Send a whole AT command, prepared earlier, in one go: this
+ * is equivalent to calling uAtClientCommandStart(), one of
+ * uAtClientWriteInt(), uAtClientWriteUint64() or
+ * uAtClientWriteString() per parameter and then
+ * uAtClientCommandStop() but the command line is rendered
+ * into a single buffer and written to the stream with one
+ * call, rather than one or more per parameter, so it is
+ * worth using for commands that are sent often, e.g. those
+ * that read or write socket data.  Follow it with
+ * uAtClientResponseStart() as usual.
+ * The stream must be locked with a call to uAtClientLock()
+ * before this function is called.
+ *
+ * Example:
+ *
+ * ```
+ * static const uAtClientPreparedCommand_t gUsord = U_AT_CLIENT_PREPARED_COMMAND("AT+USORD=", "dd");
+ * ...
+ * uAtClientLock(atHandle);
+ * uAtClientCommandPrepared(atHandle, &gUsord, socketId, length);
+ * uAtClientResponseStart(atHandle, "+USORD:");
+ * ...
+ * ```
+ *
+ * @param atHandle       the handle of the AT client.
+ * @param[in] pPrepared  the prepared command; cannot be NULL.
+ * @param ...            the parameters, one for each character
+ *                       of pPrepared->pFormat and of the type
+ *                       it indicates.
+ */
+void uAtClientCommandPrepared(uAtClientHandle_t atHandle,
+                              const uAtClientPreparedCommand_t *pPrepared,
+                              ...);
+
 /** Stop the outgoing AT command by writing the
  * command terminator.  Should be called after
  * uAtClientCommandStart() and any uAtClientWritexxx()
@@ -832,6 +1061,46 @@ int32_t uAtClientReadInt(uAtClientHandle_t atHandle);
 int32_t uAtClientReadUint64(uAtClientHandle_t atHandle,
                             uint64_t *pUint64);
 
+/** Read several consecutive integer parameters from the received
+ * AT response in one pass, e.g. the many fields of a +UCGED or
+ * +CESQ response.  The result for each parameter is exactly that
+ * which uAtClientReadInt() would return for it, so an empty
+ * parameter gives -1, but the parameters are converted as they
+ * are read, without the per-parameter overhead of separate calls.
+ * Parameters may be skipped, just as uAtClientSkipParameters()
+ * would, by setting the corresponding bit in skipMask: bit 0 for
+ * the first parameter, bit 1 for the second, etc.; the values of
+ * skipped parameters are not written.  If the stop tag is reached
+ * before numValues parameters have been read, the remaining
+ * non-skipped entries of pValues are set to -1.  As with
+ * uAtClientReadInt(), if a negative integer is possible then
+ * uAtClientErrorGet() should be checked before the values are
+ * considered valid.
+ *
+ * For instance, to read the first, second and fourth parameters
+ * of `+THING: 1,2,"x",-4`:
+ *
+ * ```
+ * int32_t values[4];
+ * uAtClientResponseStart(client, "+THING:");
+ * uAtClientReadIntList(client, values, 4, 1UL << 2);
+ * ```
+ *
+ * @param atHandle      the handle of the AT client.
+ * @param[out] pValues  a pointer to an array of numValues integers
+ *                      in which to put the results; cannot be NULL.
+ * @param numValues     the number of parameters to read, including
+ *                      those that are skipped.
+ * @param skipMask      a bit-mask of the parameters to skip; only
+ *                      the first 32 parameters may be skipped.
+ * @return              the number of parameters that were present,
+ *                      including those skipped, or negative error
+ *                      code.
+ */
+int32_t uAtClientReadIntList(uAtClientHandle_t atHandle,
+                             int32_t *pValues, size_t numValues,
+                             uint32_t skipMask);
+
 /** Read characters from the received AT response stream.
  * The received string will be null-terminated. Any quotation
  * marks found are skipped.  The delimiter (e.g. ',') is obeyed,
@@ -888,7 +1157,11 @@ int32_t uAtClientReadString(uAtClientHandle_t atHandle,
  * lengthBytes will be ignored; you need to know how many
  * bytes you are going to read.  If you don't want the
  * stop tag to be obeyed either, call
- * uAtClientIgnoreStopTag() first.
+ * uAtClientIgnoreStopTag() first; in that case, where the
+ * stream is a UART with no receive intercept function, the
+ * bytes are read straight from the UART into pBuffer rather
+ * than passing through the receive buffer of the AT client,
+ * so the receive buffer need not be sized for the payload.
  *
  * @param atHandle      the handle of the AT client.
  * @param[out] pBuffer  a buffer in which to place the
@@ -1001,6 +1274,125 @@ void uAtClientSkipBytes(uAtClientHandle_t atHandle,
 int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
                                char character);
 
+/** Send a batch of AT commands and parse their responses, in order,
+ * under a single lock of the AT client.  Where concatenate is true,
+ * runs of extended AT commands (those beginning "AT+") are written
+ * on a single command line, separated by ";" as permitted by
+ * 3GPP 27.007/V.250, e.g. "AT+CGMI;+CGMM;+CGSN", so that the AT
+ * server processes them back-to-back and only one round trip, and
+ * only one inter-command delay (see uAtClientDelaySet()), is
+ * incurred for the lot; other commands, and lines that would exceed
+ * #U_AT_CLIENT_BATCH_LINE_LENGTH_MAX_BYTES, are sent on a line of
+ * their own.  The information responses are passed to the pParser
+ * function of each command in the order the commands appear in the
+ * batch.
+ *
+ * Processing stops at the first line that fails, whether because
+ * the AT server returned an error, a response prefix was not found,
+ * a parser returned an error or a timeout occurred.  Note that a
+ * failed concatenated line means that the AT server will not have
+ * executed the commands on the line after the one that failed,
+ * which is why success is counted a line at a time.
+ *
+ * This function locks and unlocks the AT client itself: it must
+ * NOT be called between uAtClientLock() and uAtClientUnlock().
+ *
+ * @param atHandle        the handle of the AT client.
+ * @param[in] pCommands   the array of commands; may only be NULL
+ *                        if numCommands is zero.
+ * @param numCommands     the number of entries at pCommands.
+ * @param concatenate     true to concatenate extended AT commands
+ *                        onto a single command line, false to send
+ *                        each command on a line of its own.
+ * @return                on success the number of commands, from
+ *                        the start of the batch, that were completed
+ *                        successfully (which will be numCommands if
+ *                        everything worked), else negative error
+ *                        code.
+ */
+int32_t uAtClientBatch(uAtClientHandle_t atHandle,
+                       const uAtClientBatchCommand_t *pCommands,
+                       size_t numCommands, bool concatenate);
+
+/** As uAtClientBatch() but non-blocking: the batch is queued and
+ * run later in the task at the end of the AT client callback queue
+ * (the same one used by uAtClientCallback()), pCallback being called
+ * in that task with the outcome once the batch is complete.  This
+ * allows a single task to have several AT transactions in progress
+ * without blocking.  Batches are run one at a time, in the order
+ * they were queued, and since the callback task is shared by all AT
+ * clients a long batch will hold up other asynchronous callbacks.
+ *
+ * The array at pCommands is copied and so need not be kept once
+ * this function has returned, however the strings pointed to by its
+ * entries, and anything their parsers use, must remain valid until
+ * pCallback has been called.  If the AT client is removed or told to
+ * ignore asynchronous events (see uAtClientIgnoreAsync()) before a
+ * queued batch is run, the batch is discarded and pCallback is not
+ * called.
+ *
+ * @param atHandle        the handle of the AT client.
+ * @param[in] pCommands   the array of commands, see uAtClientBatch();
+ *                        cannot be NULL.
+ * @param numCommands     the number of entries at pCommands, must be
+ *                        greater than zero.
+ * @param concatenate     see uAtClientBatch().
+ * @param[in] pCallback   the function to call when the batch is
+ *                        complete, may be NULL; the first parameter
+ *                        is the AT client handle, the second the
+ *                        value uAtClientBatch() would have returned
+ *                        and the third pCallbackParam.
+ * @param pCallbackParam  a parameter to pass to pCallback, may be NULL.
+ * @return                zero if the batch was queued, else negative
+ *                        error code.
+ */
+int32_t uAtClientBatchAsync(uAtClientHandle_t atHandle,
+                            const uAtClientBatchCommand_t *pCommands,
+                            size_t numCommands, bool concatenate,
+                            void (*pCallback) (uAtClientHandle_t,
+                                               int32_t, void *),
+                            void *pCallbackParam);
+
+/** As uAtClientBatchAsync() but, where a wake-up handler is set
+ * (see uAtClientSetWakeUpHandler()) and the module would need to be
+ * woken up to send the batch, the batch may be held back for up to
+ * maxDelayMs so that it is sent under the same wake-up as whatever
+ * AT command comes next, rather than waking the module on its own.
+ * This suits commands whose timing does not matter much, e.g. a
+ * periodic status query, on a module that spends most of its time
+ * asleep.  If no wake-up handler is set, or the module is already
+ * awake, this behaves exactly as uAtClientBatchAsync(), as it does
+ * on a platform where timers are not implemented.
+ *
+ * Deferred batches are released, in the order they were submitted,
+ * when any AT command causes the module to be woken up or when the
+ * earliest of their maxDelayMs expires, whichever comes first.  If
+ * the wake-up handler is removed, any deferred batches are released
+ * immediately; if the AT client is removed they are discarded and
+ * pCallback is not called.
+ *
+ * @param atHandle        the handle of the AT client.
+ * @param[in] pCommands   the array of commands, see uAtClientBatch();
+ *                        cannot be NULL.
+ * @param numCommands     the number of entries at pCommands, must be
+ *                        greater than zero.
+ * @param concatenate     see uAtClientBatch().
+ * @param maxDelayMs      the longest the batch may be held back for,
+ *                        in milliseconds; zero means don't hold it
+ *                        back.
+ * @param[in] pCallback   see uAtClientBatchAsync().
+ * @param pCallbackParam  a parameter to pass to pCallback, may be NULL.
+ * @return                zero if the batch was queued or deferred,
+ *                        else negative error code.
+ */
+int32_t uAtClientBatchDeferrable(uAtClientHandle_t atHandle,
+                                 const uAtClientBatchCommand_t *pCommands,
+                                 size_t numCommands, bool concatenate,
+                                 int32_t maxDelayMs,
+                                 void (*pCallback) (uAtClientHandle_t,
+                                                    int32_t, void *),
+                                 void *pCallbackParam);
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: HANDLE UNSOLICITED RESPONSES
  * -------------------------------------------------------------- */
@@ -1069,17 +1461,34 @@ void uAtClientRemoveUrcHandler(uAtClientHandle_t atHandle,
  */
 int32_t uAtClientUrcHandlerStackMinFree(uAtClientHandle_t atHandle);
 
+/** Get the statistics on URC matching for the given AT client.
+ * URC prefixes are held in an index hashed on their first few
+ * characters so that, however many URC handlers are set, only
+ * a small number of prefix compares should be needed to match
+ * a URC; these statistics allow that to be confirmed.  This
+ * function may be called from within a URC handler.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param[out] pStats  a place to put the statistics; cannot
+ *                     be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uAtClientUrcStatsGet(uAtClientHandle_t atHandle,
+                             uAtClientUrcStats_t *pStats);
+
 /** Make an asynchronous callback that is run in its own task
  * context with a stack size of
  * #U_AT_CLIENT_CALLBACK_TASK_STACK_SIZE_BYTES running at
  * priority #U_AT_CLIENT_CALLBACK_TASK_PRIORITY.  Use this
  * function if you need to do any heavy work from a URC
  * handler to avoid blocking the stream interface.  Callbacks
- * are queued and so are guaranteed to be run in the order
- * they are called.  A single callback queue is shared between
- * all AT client instances; you can determine which instance
- * has made the call by checking #uAtClientHandle_t, the first
- * parameter passed to the callback.
+ * are queued, each AT client having its own queue (see
+ * uAtClientCallbackQueueLengthSet()), and are guaranteed to be
+ * run in the order they are called, ahead of any callbacks
+ * queued with uAtClientCallbackData().  A single task runs the
+ * callbacks of all AT client instances; you can determine which
+ * instance has made the call by checking #uAtClientHandle_t,
+ * the first parameter passed to the callback.
  *
  * @param atHandle            the handle of the AT client.
  * @param[in] pCallback       the callback function.
@@ -1091,6 +1500,58 @@ int32_t uAtClientCallback(uAtClientHandle_t atHandle,
                           void (*pCallback) (uAtClientHandle_t, void *),
                           void *pCallbackParam);
 
+/** As uAtClientCallback() but for events that simply say "there
+ * is data", e.g. a "data available on socket" URC, where many may
+ * arrive in a burst and one callback is as good as many.  Such
+ * callbacks are run, in the order they are called, only once
+ * there are no callbacks queued with uAtClientCallback() waiting
+ * to run, so that a burst of data events cannot hold up more
+ * important ones.  If the same pCallback with the same
+ * pCallbackParam is already waiting to run the two are merged,
+ * i.e. the new one is not queued and success is returned: hence
+ * pCallbackParam should identify the thing the event is about
+ * (e.g. a socket) and must NOT be something that has been
+ * malloc()ed for this call, since a merged call would leak it.
+ *
+ * @param atHandle            the handle of the AT client.
+ * @param[in] pCallback       the callback function.
+ * @param[in] pCallbackParam  a parameter to pass to the callback,
+ *                            as the second parameter, may be NULL.
+ * @return                    zero on success else negative error code.
+ */
+int32_t uAtClientCallbackData(uAtClientHandle_t atHandle,
+                              void (*pCallback) (uAtClientHandle_t, void *),
+                              void *pCallbackParam);
+
+/** Set the length of the callback queue of an AT client, the
+ * number of callbacks queued with uAtClientCallback() or
+ * uAtClientCallbackData() that may be waiting to run at any
+ * one time; by default this is
+ * #U_AT_CLIENT_CALLBACK_QUEUE_LENGTH.  This would normally be
+ * called immediately after uAtClientAdd(); it cannot be
+ * called while there are callbacks waiting to run.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @param length    the length of the callback queue; must be
+ *                  greater than zero.
+ * @return          zero on success else negative error code;
+ *                  U_ERROR_COMMON_TEMPORARY_FAILURE if there are
+ *                  callbacks waiting to run.
+ */
+int32_t uAtClientCallbackQueueLengthSet(uAtClientHandle_t atHandle,
+                                        size_t length);
+
+/** Get the statistics on the callback queue of an AT client;
+ * this may be called from within a callback.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param[out] pStats  a place to put the statistics; cannot
+ *                     be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uAtClientCallbackStatsGet(uAtClientHandle_t atHandle,
+                                  uAtClientCallbackStats_t *pStats);
+
 /** Get the stack high watermark for the task at the end of the
  * AT callback event queue, the minimum amount of free stack
  * space.  If this gets close to zero you either need to do less
@@ -1197,6 +1658,29 @@ void uAtClientDeviceErrorGet(uAtClientHandle_t atHandle,
 int32_t uAtClientStreamGet(uAtClientHandle_t atHandle,
                            uAtClientStream_t *pStreamType);
 
+/** Switch the AT client to a different underlying stream,
+ * keeping its URC handlers, settings and so on; this is how
+ * an AT client that was talking over a UART is moved onto a
+ * CMUX channel once the module has entered multiplexer mode,
+ * and back again.  The event callback of the current stream
+ * is removed and one is set on the new stream.  Any data
+ * remaining in the receive buffer is discarded.  This MUST be
+ * called between uAtClientLock() and uAtClientUnlock().
+ *
+ * @param atHandle      the handle of the AT client.
+ * @param streamHandle  the handle of the new stream; use a
+ *                      negative value to simply detach the AT
+ *                      client from its current stream, e.g.
+ *                      while something else takes it over.
+ * @param streamType    the type of the new stream.
+ * @return              zero on success else negative error code,
+ *                      in which case the AT client is left
+ *                      detached.
+ */
+int32_t uAtClientStreamSwitch(uAtClientHandle_t atHandle,
+                              int32_t streamHandle,
+                              uAtClientStream_t streamType);
+
 /** Add a function that will intercept the transmitted
  * data before it is presented to the stream and may return
  * a modified buffer or hold onto the data until a whole
@@ -1300,7 +1784,8 @@ void uAtClientStreamInterceptTx(uAtClientHandle_t atHandle,
  * occurs.
  *
  * Otherwise, on return from the intercept function, the
- * return value should point to valid data, length should
+ * return value should point to valid data (which need not be
+ * in the buffer the intercept function was passed), length should
  * point to the length of that data and the data-pointer
  * that was passed in should be advanced to indicate how
  * much of the buffer was consumed.  The AT client will
@@ -1401,6 +1886,20 @@ int32_t uAtClientSetWakeUpHandler(uAtClientHandle_t atHandle,
  */
 bool uAtClientWakeUpHandlerIsSet(const uAtClientHandle_t atHandle);
 
+/** Get the statistics on the wake-up handler of an AT client,
+ * useful when tuning the inactivity timeout of the module, or the
+ * maxDelayMs passed to uAtClientBatchDeferrable(), against power
+ * consumption; the statistics are reset each time a wake-up handler
+ * is set.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param[out] pStats  a place to put the statistics; cannot
+ *                     be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uAtClientWakeUpStatsGet(uAtClientHandle_t atHandle,
+                                uAtClientWakeUpStats_t *pStats);
+
 /** Set an "activity" pin.  This is useful where the module at the
  * other end of the link requires a pin to be raised or lowered while
  * this MCU is actively communicating over the AT interface (i.e.
@@ -1424,6 +1923,53 @@ int32_t uAtClientSetActivityPin(uAtClientHandle_t atHandle,
                                 int32_t pin, int32_t readyMs,
                                 int32_t hysteresisMs, bool highIsOn);
 
+/** Start collecting latency statistics for the given AT client.
+ * For each AT command (identified by the command string up to any
+ * "=" or "?") log2-bucketed histograms of the time from the command
+ * being sent to the first byte of the response arriving and to the
+ * response being stopped are kept; for each URC a histogram of the
+ * time spent handling it is kept.  The statistics are kept in a
+ * table of up to maxNumEntries entries, which is malloc()ed by this
+ * function; once the table is full, new AT commands/URCs are not
+ * counted.  If statistics were already being collected they are
+ * reset.
+ *
+ * This function must not be called between uAtClientLock() and
+ * uAtClientUnlock() or from a URC handler.
+ *
+ * @param atHandle       the handle of the AT client.
+ * @param maxNumEntries  the maximum number of AT commands plus URCs
+ *                       to keep statistics for; each entry costs
+ *                       sizeof(#uAtClientLatencyEntry_t) bytes.
+ * @return               zero on success else negative error code.
+ */
+int32_t uAtClientLatencyStart(uAtClientHandle_t atHandle,
+                              size_t maxNumEntries);
+
+/** Stop collecting latency statistics for the given AT client and
+ * free the memory they occupied.  This function must not be called
+ * between uAtClientLock() and uAtClientUnlock() or from a URC handler.
+ *
+ * @param atHandle  the handle of the AT client.
+ */
+void uAtClientLatencyStop(uAtClientHandle_t atHandle);
+
+/** Get an entry from the latency statistics of the given AT client;
+ * to read all of the entries call this with index incrementing from
+ * zero until it returns an error.  This function must not be called
+ * between uAtClientLock() and uAtClientUnlock() or from a URC handler.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param index        the index of the entry to get.
+ * @param[out] pEntry  a place to put a copy of the entry, may be NULL.
+ * @return             on success the number of entries, else negative
+ *                     error code; #U_ERROR_COMMON_NOT_FOUND is
+ *                     returned if index is beyond the last entry
+ *                     or statistics are not being collected.
+ */
+int32_t uAtClientLatencyGet(uAtClientHandle_t atHandle, size_t index,
+                            uAtClientLatencyEntry_t *pEntry);
+
 /** Get the activity pin, if one is set.
  *
  * @param atHandle  the handle of the AT client.
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_AT_CLIENT_RECORD_H_
+#define _U_AT_CLIENT_RECORD_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_at_client.h"
+
+/** \addtogroup _AT-client
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a way of recording the traffic
+ * on an AT client stream, with timestamps, into a buffer (a
+ * "session") which can later be played back, e.g. by the replay
+ * UART of the Windows port, so that parser changes, URC dispatch
+ * cost or socket read throughput can be measured reproducibly
+ * without a module attached.
+ *
+ * A session is simply a sequence of records, each consisting of
+ * a #U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES byte header followed
+ * by the data; the header is:
+ *
+ * - byte 0: the direction, #U_AT_CLIENT_RECORD_DIRECTION_TX for
+ *   data sent by the AT client, #U_AT_CLIENT_RECORD_DIRECTION_RX
+ *   for data received by the AT client,
+ * - byte 1: reserved, set to zero,
+ * - bytes 2 and 3: the length of the data that follows, little
+ *   endian,
+ * - bytes 4 to 7: the time of the record in milliseconds since
+ *   the session started, little endian.
+ *
+ * Recording is done with the transmit and receive intercepts of
+ * the AT client, see uAtClientStreamInterceptTx() and
+ * uAtClientStreamInterceptRx(), hence it cannot be used at the
+ * same time as anything else that needs the intercepts (e.g.
+ * chip-to-chip security or EDM).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The length of the header on each record of a session.
+ */
+#define U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES 8
+
+/** The maximum amount of data in a single record of a session.
+ */
+#define U_AT_CLIENT_RECORD_DATA_MAX_LENGTH_BYTES 0xFFFF
+
+/** The direction byte for data sent by the AT client.
+ */
+#define U_AT_CLIENT_RECORD_DIRECTION_TX '>'
+
+/** The direction byte for data received by the AT client.
+ */
+#define U_AT_CLIENT_RECORD_DIRECTION_RX '<'
+
+#ifndef U_AT_CLIENT_RECORD_COALESCE_MS
+/** Data passing in the same direction within this many
+ * milliseconds of the previous data is added to the same
+ * record, rather than starting a new one; this avoids an AT
+ * command, which the AT client writes in pieces, turning into
+ * a large number of small records.
+ */
+# define U_AT_CLIENT_RECORD_COALESCE_MS 10
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The state of a recording; the caller provides the storage
+ * for this, the contents are populated by
+ * uAtClientRecordStart() and should not be modified.
+ */
+typedef struct {
+    char *pBuffer;          /**< the buffer the session is written to. */
+    size_t bufferSize;      /**< the size of pBuffer. */
+    size_t length;          /**< the length of the session in pBuffer so far. */
+    size_t bytesDropped;    /**< the number of bytes of stream data that
+                                 could not be recorded because pBuffer
+                                 was full. */
+    int32_t startTimeMs;    /**< the tick time at which the session started. */
+    int32_t lastTimeMs;     /**< the time, relative to startTimeMs, of the
+                                 last data added. */
+    size_t lastRecordOffset; /**< the offset of the last record in pBuffer;
+                                  only valid if length is non-zero. */
+} uAtClientRecord_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Start recording the traffic on an AT client into a buffer.
+ * Any data sitting in the receive buffer of the AT client is
+ * discarded.  Do not call this between uAtClientLock() and
+ * uAtClientUnlock(): the AT client is locked inside here.
+ *
+ * @param atHandle        the handle of the AT client to record;
+ *                        may be NULL, in which case pRecord is
+ *                        simply initialised so that a session
+ *                        can be built by hand with
+ *                        uAtClientRecordAdd().
+ * @param[out] pRecord    a place to store the state of the
+ *                        recording, which must remain valid until
+ *                        uAtClientRecordStop() is called; cannot
+ *                        be NULL.
+ * @param[in] pBuffer     the buffer to write the session to; cannot
+ *                        be NULL.
+ * @param bufferSize      the amount of storage at pBuffer; when it
+ *                        is full further data is counted in
+ *                        bytesDropped but not recorded.
+ * @return                zero on success else negative error code.
+ */
+int32_t uAtClientRecordStart(uAtClientHandle_t atHandle,
+                             uAtClientRecord_t *pRecord,
+                             char *pBuffer, size_t bufferSize);
+
+/** Stop recording the traffic on an AT client.  Do not call
+ * this between uAtClientLock() and uAtClientUnlock().
+ *
+ * @param atHandle     the handle of the AT client that was
+ *                     given to uAtClientRecordStart(); may be
+ *                     NULL if NULL was given there.
+ * @param[in] pRecord  the state of the recording; cannot be NULL.
+ * @return             on success the length of the session in
+ *                     the buffer that was passed to
+ *                     uAtClientRecordStart(), else negative
+ *                     error code.
+ */
+int32_t uAtClientRecordStop(uAtClientHandle_t atHandle,
+                            uAtClientRecord_t *pRecord);
+
+/** Add data to a session; this is what the intercepts of a
+ * recording call but it may also be used to build a session by
+ * hand, e.g. from test data.  If the data is in the same
+ * direction as the last record and is within
+ * #U_AT_CLIENT_RECORD_COALESCE_MS of it the data is added to that
+ * record, otherwise a new record is started.
+ *
+ * @param[in] pRecord  the state of the recording, as initialised
+ *                     by uAtClientRecordStart(); cannot be NULL.
+ * @param isTx         true if this is data sent by the AT client,
+ *                     false if it was received by the AT client.
+ * @param timeMs       the time of the data in milliseconds since
+ *                     the session started.
+ * @param[in] pData    the data; cannot be NULL.
+ * @param length       the amount of data at pData.
+ * @return             the number of bytes (of header and data)
+ *                     added to the session, else negative error
+ *                     code; if there is not enough room for all
+ *                     of the data U_ERROR_COMMON_NO_MEMORY is
+ *                     returned and nothing is added.
+ */
+int32_t uAtClientRecordAdd(uAtClientRecord_t *pRecord, bool isTx,
+                           int32_t timeMs, const char *pData,
+                           size_t length);
+
+/** Get a record from a session.  To walk through a session, call
+ * this with the start of the session and then move pSession on
+ * (and length down) by the return value until zero is returned.
+ *
+ * @param[in] pSession  a pointer to the record in a session;
+ *                      cannot be NULL.
+ * @param length        the amount of session data at pSession.
+ * @param[out] pIsTx    a place to put the direction of the
+ *                      record; may be NULL.
+ * @param[out] pTimeMs  a place to put the time of the record;
+ *                      may be NULL.
+ * @param[out] ppData   a place to put a pointer to the data of
+ *                      the record; may be NULL.
+ * @param[out] pLength  a place to put the length of the data of
+ *                      the record; may be NULL.
+ * @return              the total length of the record, header
+ *                      plus data, zero if length is zero, else
+ *                      negative error code if the record is not
+ *                      valid or is incomplete.
+ */
+int32_t uAtClientRecordGet(const char *pSession, size_t length,
+                           bool *pIsTx, int32_t *pTimeMs,
+                           const char **ppData, size_t *pLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_AT_CLIENT_RECORD_H_
+
+// End of file
@@ -36,6 +36,7 @@
 #include "stdbool.h"
 #include "string.h"    // memcpy(), strcmp(), strcspn(), strspm()
 #include "stdio.h"     // snprintf()
+#include "stdarg.h"    // va_list
 #include "ctype.h"     // isprint()
 
 #include "u_cfg_sw.h"
@@ -55,11 +56,15 @@
 #include "u_port_uart.h"
 #include "u_port_event_queue.h"
 
+#include "u_trace.h"
+
 #include "u_at_client.h"
+#include "u_at_client_private.h"
 #include "u_short_range_pbuf.h"
 #include "u_short_range_module_type.h"
 #include "u_short_range.h"
 #include "u_short_range_edm_stream.h"
+#include "u_cmux.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -140,11 +145,16 @@
  */
 #define U_AT_CLIENT_MAX_LENGTH_INFORMATION_RESPONSE_PREFIX 64
 
-/** The maximum length of the callback queue.
- * Each item in the queue will be
- * sizeof(uAtClientCallback_t) bytes big.
+/** The length of the event queue that runs callbacks.  Each
+ * AT client has its own callback queue, see
+ * uAtClientCallbackQueueLengthSet(), and only ever has a
+ * single entry on this event queue, telling the callback task
+ * to run whatever is in it, so this need only be as long as
+ * the number of AT clients there are likely to be.  Each item
+ * in the queue will be sizeof(uAtClientCallbackKick_t) bytes
+ * big.
  */
-#define U_AT_CLIENT_CALLBACK_QUEUE_LENGTH 10
+#define U_AT_CLIENT_CALLBACK_EVENT_QUEUE_LENGTH 10
 
 /** Guard for the URC task data receive loop to make
  * sure it can't be drowned by the incoming stream,
@@ -152,6 +162,53 @@
  */
 #define U_AT_CLIENT_URC_DATA_LOOP_GUARD       100
 
+#ifndef U_AT_CLIENT_RECEIVE_BUFFER_LAZY_COMPACT
+/** Set this to 1 to defer moving the unread content of the receive
+ * buffer down to the start of the buffer until it is necessary, i.e.
+ * until less than half of the buffer is free at the end, rather than
+ * every time the parser moves on; this avoids copying the same data
+ * over and over again when a large response (e.g. a socket read) is
+ * being parsed.  Set this to 0 for the behaviour where the unread
+ * content is moved down at every rewind.
+ */
+# define U_AT_CLIENT_RECEIVE_BUFFER_LAZY_COMPACT 1
+#endif
+
+#ifndef U_AT_CLIENT_READ_BYTES_DIRECT
+/** Set this to 1 to have uAtClientReadBytes(), when the stop tag is
+ * being ignored (i.e. a binary payload of known length is being
+ * read), copy the payload straight from the UART into the caller's
+ * buffer rather than passing it through the receive buffer.  This
+ * does not apply if there is a receive intercept function or the
+ * stream is not a UART.
+ */
+# define U_AT_CLIENT_READ_BYTES_DIRECT 1
+#endif
+
+#ifndef U_AT_CLIENT_UART_LINE_EVENTS
+/** Set this to 1 to have the AT client ask a UART stream for
+ * U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED rather than
+ * U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED, so that the URC task
+ * is only woken when a complete line has arrived rather than for
+ * every fragment of one; this reduces the number of wake-ups and
+ * of parsing passes over partial lines considerably when there
+ * is a lot of URC traffic.  Only set this on a platform where
+ * the porting layer supports the line event (currently ESP-IDF),
+ * otherwise URCs will never be seen.  Prompts such as ">" are
+ * not affected since those are waited for by the task sending
+ * the AT command, not by the URC task.
+ */
+# define U_AT_CLIENT_UART_LINE_EVENTS 0
+#endif
+
+#if U_AT_CLIENT_UART_LINE_EVENTS
+/** The event that the AT client waits for on a UART stream.
+ */
+# define U_AT_CLIENT_UART_EVENT_BITMASK U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED
+#else
+# define U_AT_CLIENT_UART_EVENT_BITMASK U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED
+#endif
+
 /** Macro that returns the start of the data buffer.
  */
 #define U_AT_CLIENT_DATA_BUFFER_PTR(pBufStruct) (((char *) (pBufStruct)) +          \
@@ -215,6 +272,24 @@
  */
 #define U_AT_CLIENT_MAGIC_NUMBER_START 1
 
+#ifndef U_AT_CLIENT_URC_INDEX_NUM_BUCKETS
+/** The number of hash buckets in the URC dispatch index of each
+ * AT client; each bucket costs one pointer.
+ */
+# define U_AT_CLIENT_URC_INDEX_NUM_BUCKETS 16
+#endif
+
+#ifndef U_AT_CLIENT_URC_INDEX_KEY_LENGTH
+/** The number of characters at the start of a URC prefix that
+ * are hashed to select its bucket in the URC dispatch index.
+ * URC prefixes shorter than this are kept in a separate chain
+ * which is always searched.  Six is enough to separate the
+ * "+UUSOxx" style prefixes of u-blox modules into more than
+ * one bucket.
+ */
+# define U_AT_CLIENT_URC_INDEX_KEY_LENGTH 6
+#endif
+
 // Do some cross-checking
 #if (U_AT_CLIENT_CALLBACK_TASK_PRIORITY >= U_AT_CLIENT_URC_TASK_PRIORITY)
 # error U_AT_CLIENT_CALLBACK_TASK_PRIORITY must be less than U_AT_CLIENT_URC_TASK_PRIORITY
@@ -283,6 +358,7 @@ typedef struct uAtClientUrc_t {
     void (*pHandler) (uAtClientHandle_t, void *); /** The handler to call if pPrefix is matched. */
     void *pHandlerParam;       /** The parameter to pass to pHandler. */
     struct uAtClientUrc_t *pNext;
+    struct uAtClientUrc_t *pNextInBucket; /** The next URC in the same bucket of the URC index. */
 } uAtClientUrc_t;
 
 /** The definition of a tag.
@@ -332,15 +408,43 @@ typedef enum {
     U_AT_CLIENT_BLOCK_STATE_DO_NOT_BLOCK
 } uAtClientBlockState_t;
 
-/** A struct defining a callback plus its optional parameter.
+/** A struct defining a callback plus its optional parameter, an
+ * entry in the callback queue of an AT client.
  */
 typedef struct {
     void (*pFunction) (uAtClientHandle_t, void *);
     uAtClientHandle_t atHandle;
     void *pParam;
-    int32_t atClientMagicNumber;
+    bool freeParam; /** If true pParam was malloc()ed by us and should
+                        be free()ed once the callback has been handled. */
+    bool isData; /** True if this callback was queued with
+                     uAtClientCallbackData(), and so is run after
+                     any others. */
+    bool inUse; /** True if this entry holds a callback waiting to run. */
+    uint32_t sequence; /** Keeps callbacks in the order they were queued. */
 } uAtClientCallback_t;
 
+/** What is sent to the callback event queue to tell it to run
+ * the callbacks queued by an AT client.
+ */
+typedef struct {
+    struct uAtClientInstance_t *pClient;
+    int32_t atClientMagicNumber;
+} uAtClientCallbackKick_t;
+
+/** An asynchronous batch of AT commands, see uAtClientBatchAsync();
+ * this is malloc()ed with the copy of the batch commands immediately
+ * following it.
+ */
+typedef struct uAtClientBatchAsync_t {
+    size_t numCommands;
+    bool concatenate;
+    void (*pCallback) (uAtClientHandle_t, int32_t, void *);
+    void *pCallbackParam;
+    int32_t deadlineMs; /**< when a deferred batch must be sent by. */
+    struct uAtClientBatchAsync_t *pNext; /**< the next deferred batch. */
+} uAtClientBatchAsync_t;
+
 /** Struct defining a wake-up handler.
  */
 typedef struct {
@@ -371,6 +475,21 @@ typedef struct {
     uPortMutexHandle_t *pNextFree;
 } uAtClientMutexStack_t;
 
+/** Struct holding the latency statistics of an AT client, see
+ * uAtClientLatencyStart(); this is malloc()ed with the array of
+ * maxNumEntries entries immediately following it.
+ */
+typedef struct {
+    size_t maxNumEntries; /** The number of entries there is room for. */
+    size_t numEntries; /** The number of entries in use. */
+    int32_t pendingEntry; /** The entry of the AT command awaiting a
+                              response, -1 if there is none. */
+    int32_t commandStopMs; /** The time at which the pending AT command
+                               was sent. */
+    bool firstByteReceived; /** True once the first byte of the response
+                                to the pending AT command has arrived. */
+} uAtClientLatency_t;
+
 /** Definition of an AT client instance.
  */
 typedef struct uAtClientInstance_t {
@@ -395,6 +514,12 @@ typedef struct uAtClientInstance_t {
     uAtClientScope_t scope; /** The scope, where we're at in the AT command. */
     uAtClientTag_t stopTag; /** The stop tag for the current scope. */
     uAtClientUrc_t *pUrcList; /** Linked-list anchor for URC handlers. */
+    /** The URC dispatch index: the URCs in pUrcList hashed on
+        the first U_AT_CLIENT_URC_INDEX_KEY_LENGTH characters of
+        their prefix, the last entry being the chain of URCs with
+        prefixes shorter than that. */
+    uAtClientUrc_t *pUrcIndex[U_AT_CLIENT_URC_INDEX_NUM_BUCKETS + 1];
+    uAtClientUrcStats_t urcStats; /** Statistics on URC matching. */
     int32_t lastResponseStopMs; /** The time the last response ended in milliseconds. */
     int32_t lockTimeMs; /** The time when the stream was locked. */
     int32_t lastTxTimeMs; /** The time when the last transmit activity was carried out, set to -1 initially. */
@@ -417,6 +542,23 @@ typedef struct uAtClientInstance_t {
                                    as its fourth parameter. */
     uAtClientWakeUp_t *pWakeUp; /** Pointer to a wake-up handler structure. */
     uAtClientActivityPin_t *pActivityPin; /** Pointer to an activity pin structure. */
+    uAtClientLatency_t *pLatency; /** Pointer to latency statistics, NULL if not enabled. */
+    const char *pLatencyCommand; /** The AT command most recently started, for pLatency. */
+    uAtClientCallback_t *pCallbackQueue; /** The callbacks waiting to be run, malloc()ed on first use. */
+    size_t callbackQueueLength; /** The number of entries at pCallbackQueue. */
+    size_t callbackQueueDepth; /** The number of entries at pCallbackQueue that are in use. */
+    uint32_t callbackSequence; /** The sequence number to give to the next callback queued. */
+    bool callbackKickPending; /** True if there is a uAtClientCallbackKick_t for
+                                  this AT client on the callback event queue. */
+    uAtClientCallbackStats_t callbackStats; /** Statistics on the callback queue. */
+    uAtClientWakeUpStats_t wakeUpStats; /** Statistics on the wake-up handler. */
+    int32_t wakeUpStatsStartTimeMs; /** When wakeUpStats were last reset. */
+    uPortMutexHandle_t deferMutex; /** Protects pDeferred, deferTimer, deferDeadlineMs and
+                                       the deferral counts in wakeUpStats, created on first
+                                       use by uAtClientBatchDeferrable(). */
+    uAtClientBatchAsync_t *pDeferred; /** Batches held back by uAtClientBatchDeferrable(). */
+    uPortTimerHandle_t deferTimer; /** One-shot timer for the earliest deadline in pDeferred. */
+    int32_t deferDeadlineMs; /** The deadline deferTimer is running to. */
     struct uAtClientInstance_t *pNext;
 } uAtClientInstance_t;
 
@@ -456,6 +598,11 @@ typedef struct {
  */
 static uAtClientInstance_t *gpAtClientList = NULL;
 
+/** Profiling probe for bufferFill(), only present if U_CFG_PROFILE
+ * is defined.
+ */
+U_PORT_PROFILE_PROBE(atBufferFill);
+
 /** Mutex to protect the linked list and
  * other global operations.
  */
@@ -678,6 +825,50 @@ static void ignoreAsync(const uAtClientInstance_t *pClient)
     }
 }
 
+// Find the callback that should be run next from the callback
+// queue of an AT client: callbacks queued with uAtClientCallback()
+// before those queued with uAtClientCallbackData(), each in the
+// order they were queued.  Returns NULL if there is none.
+// gMutexEventQueue should be locked before this is called.
+static uAtClientCallback_t *pCallbackQueueNext(const uAtClientInstance_t *pClient)
+{
+    uAtClientCallback_t *pNext = NULL;
+    uAtClientCallback_t *pCb;
+
+    for (size_t x = 0; (pClient->pCallbackQueue != NULL) &&
+         (x < pClient->callbackQueueLength); x++) {
+        pCb = pClient->pCallbackQueue + x;
+        if (pCb->inUse &&
+            ((pNext == NULL) ||
+             (!pCb->isData && pNext->isData) ||
+             ((pCb->isData == pNext->isData) &&
+              ((int32_t) (pCb->sequence - pNext->sequence) < 0)))) {
+            pNext = pCb;
+        }
+    }
+
+    return pNext;
+}
+
+// Free the callback queue of an AT client, including the
+// parameters of any callbacks in it that were malloc()ed by us.
+// gMutexEventQueue should be locked before this is called.
+static void callbackQueueFree(uAtClientInstance_t *pClient)
+{
+    uAtClientCallback_t *pCb;
+
+    for (size_t x = 0; (pClient->pCallbackQueue != NULL) &&
+         (x < pClient->callbackQueueLength); x++) {
+        pCb = pClient->pCallbackQueue + x;
+        if (pCb->inUse && pCb->freeParam) {
+            free(pCb->pParam);
+        }
+    }
+    free(pClient->pCallbackQueue);
+    pClient->pCallbackQueue = NULL;
+    pClient->callbackQueueDepth = 0;
+}
+
 // Remove an AT client instance from the list.
 // gMutex should be locked before this is called.
 // Note: doesn't free it, the caller must do that.
@@ -703,6 +894,30 @@ static void removeAtClientInstance(const uAtClientInstance_t *pClient)
     }
 }
 
+// Throw away any batches deferred by uAtClientBatchDeferrable(),
+// without calling their callbacks, and the timer that goes with them.
+static void deferredFree(uAtClientInstance_t *pClient)
+{
+    uAtClientBatchAsync_t *pJob;
+
+    if (pClient->deferMutex != NULL) {
+        if (pClient->deferTimer != NULL) {
+            uPortTimerStop(pClient->deferTimer);
+            uPortTimerDelete(pClient->deferTimer);
+            pClient->deferTimer = NULL;
+        }
+        U_PORT_MUTEX_LOCK(pClient->deferMutex);
+        while (pClient->pDeferred != NULL) {
+            pJob = pClient->pDeferred;
+            pClient->pDeferred = pJob->pNext;
+            free(pJob);
+        }
+        U_PORT_MUTEX_UNLOCK(pClient->deferMutex);
+        uPortMutexDelete(pClient->deferMutex);
+        pClient->deferMutex = NULL;
+    }
+}
+
 // Remove an AT client.
 // gMutex should be locked before this is called.
 static void removeClient(uAtClientInstance_t *pClient)
@@ -739,6 +954,9 @@ static void removeClient(uAtClientInstance_t *pClient)
         case U_AT_CLIENT_STREAM_TYPE_EDM:
             uShortRangeEdmStreamAtCallbackRemove(pClient->streamHandle);
             break;
+        case U_AT_CLIENT_STREAM_TYPE_CMUX:
+            uCmuxChannelEventCallbackRemove(pClient->streamHandle);
+            break;
         default:
             break;
     }
@@ -753,11 +971,23 @@ static void removeClient(uAtClientInstance_t *pClient)
     // Remove any activity pin
     free(pClient->pActivityPin);
 
+    // Free any latency statistics
+    free(pClient->pLatency);
+
+    // Throw away any callbacks that have not yet been run
+    U_PORT_MUTEX_LOCK(gMutexEventQueue);
+    callbackQueueFree(pClient);
+    U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
+
     // Free the receive buffer if it was malloc()ed.
     if (pClient->pReceiveBuffer->isMalloced) {
         free(pClient->pReceiveBuffer);
     }
 
+    // Throw away any deferred batches: their callbacks
+    // are not called, just as for those already queued
+    deferredFree(pClient);
+
     // Unlock its main mutex so that we can delete it
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
     uPortMutexDelete(pClient->mutex);
@@ -925,26 +1155,6 @@ static uPortMutexHandle_t streamTryLock(const uAtClientInstance_t *pClient,
     return streamMutex;
 }
 
-// Find one character buffer inside another.
-static const char *pMemStr(const char *pBuffer,
-                           size_t bufferLength,
-                           const char *pFind,
-                           size_t findLength)
-{
-    const char *pPos = NULL;
-
-    if (bufferLength >= findLength) {
-        for (size_t x = 0; (pPos == NULL) &&
-             (x < (bufferLength - findLength) + 1); x++) {
-            if (memcmp(pBuffer + x, pFind, findLength) == 0) {
-                pPos = pBuffer + x;
-            }
-        }
-    }
-
-    return pPos;
-}
-
 // Print out AT commands and responses.
 static void printAt(const uAtClientInstance_t *pClient,
                     const char *pAt, size_t length)
@@ -981,6 +1191,7 @@ static void setError(uAtClientInstance_t *pClient,
                      uErrorCode_t error)
 {
     if (error != U_ERROR_COMMON_SUCCESS) {
+        U_TRACE(AT_ERROR, error);
         if (pClient->debugOn) {
             uPortLog("U_AT_CLIENT_%d-%d: AT error %d.\n",
                      pClient->streamType, pClient->streamHandle,
@@ -999,28 +1210,154 @@ static void clearError(uAtClientInstance_t *pClient)
     setError(pClient, U_ERROR_COMMON_SUCCESS);
 }
 
-// Increment the number of consecutive timeouts
-// and call the callback if there is one
-static void consecutiveTimeout(uAtClientInstance_t *pClient)
+// Queue a callback on the callback queue of an AT client and, if
+// it doesn't already have one, put an entry on the event queue
+// to get it run.  If isData is true and the same callback with
+// the same parameter is already waiting to run, that is enough:
+// the two are merged.
+static int32_t callbackSend(uAtClientInstance_t *pClient,
+                            void (*pCallback) (uAtClientHandle_t, void *),
+                            void *pCallbackParam, bool freeParam,
+                            bool isData)
 {
-    uAtClientCallback_t cb;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    uAtClientCallback_t *pCb = NULL;
+    uAtClientCallbackKick_t kick;
+    bool merged = false;
 
     U_PORT_MUTEX_LOCK(gMutexEventQueue);
 
+    if (!processAsync(pClient->magicNumber)) {
+        // The callback would not be run, just don't queue
+        // it (but make sure we don't leak its parameter)
+        if (freeParam) {
+            free(pCallbackParam);
+        }
+    } else {
+        if (pClient->pCallbackQueue == NULL) {
+            pClient->pCallbackQueue = (uAtClientCallback_t *) malloc(pClient->callbackQueueLength *
+                                                                     sizeof(uAtClientCallback_t));
+            if (pClient->pCallbackQueue != NULL) {
+                memset(pClient->pCallbackQueue, 0,
+                       pClient->callbackQueueLength * sizeof(uAtClientCallback_t));
+            }
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        for (size_t x = 0; (pClient->pCallbackQueue != NULL) && !merged &&
+             (x < pClient->callbackQueueLength); x++) {
+            if (pClient->pCallbackQueue[x].inUse) {
+                merged = isData && pClient->pCallbackQueue[x].isData &&
+                         (pClient->pCallbackQueue[x].pFunction == pCallback) &&
+                         (pClient->pCallbackQueue[x].pParam == pCallbackParam);
+            } else if (pCb == NULL) {
+                pCb = &(pClient->pCallbackQueue[x]);
+            }
+        }
+        if (merged) {
+            pClient->callbackStats.numMerged++;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        } else if (pCb != NULL) {
+            pCb->pFunction = pCallback;
+            pCb->atHandle = (uAtClientHandle_t) pClient;
+            pCb->pParam = pCallbackParam;
+            pCb->freeParam = freeParam;
+            pCb->isData = isData;
+            pCb->sequence = pClient->callbackSequence;
+            pCb->inUse = true;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (!pClient->callbackKickPending) {
+                kick.pClient = pClient;
+                kick.atClientMagicNumber = pClient->magicNumber;
+                errorCode = uPortEventQueueSend(gEventQueueHandle, &kick, sizeof(kick));
+                if (errorCode == 0) {
+                    pClient->callbackKickPending = true;
+                } else {
+                    // Nothing would run it, so don't keep it
+                    pCb->inUse = false;
+                }
+            }
+            if (errorCode == 0) {
+                pClient->callbackSequence++;
+                pClient->callbackQueueDepth++;
+                pClient->callbackStats.numQueued++;
+                if (pClient->callbackQueueDepth > pClient->callbackStats.maxDepth) {
+                    pClient->callbackStats.maxDepth = (uint32_t) pClient->callbackQueueDepth;
+                }
+            }
+        }
+        if (errorCode < 0) {
+            pClient->callbackStats.numDropped++;
+            if (pClient->debugOn) {
+                uPortLog("U_AT_CLIENT_%d-%d: callback dropped (%d).\n",
+                         pClient->streamType, pClient->streamHandle, errorCode);
+            }
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
+
+    return errorCode;
+}
+
+// Callback for the event queue: run the callbacks queued by
+// an AT client.
+static void eventQueueCallback(void *pParameters, size_t paramLength)
+{
+    uAtClientCallbackKick_t *pKick = (uAtClientCallbackKick_t *) pParameters;
+    uAtClientInstance_t *pClient;
+    uAtClientCallback_t *pCb;
+    uAtClientCallback_t cb;
+    bool runIt = true;
+
+    (void) paramLength;
+
+    while ((pKick != NULL) && runIt) {
+        runIt = false;
+        U_PORT_MUTEX_LOCK(gMutexEventQueue);
+        // If the AT client has gone, or is ignoring asynchronous
+        // events, its callback queue has been (or will be)
+        // thrown away; we can only look at it if it is still
+        // processing asynchronous events
+        if (processAsync(pKick->atClientMagicNumber)) {
+            pClient = pKick->pClient;
+            pCb = pCallbackQueueNext(pClient);
+            if (pCb != NULL) {
+                cb = *pCb;
+                pCb->inUse = false;
+                pClient->callbackQueueDepth--;
+                runIt = true;
+            } else {
+                // All done; the next callback queued
+                // will need a new kick
+                pClient->callbackKickPending = false;
+            }
+        }
+        U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
+        if (runIt) {
+            if (cb.pFunction != NULL) {
+                cb.pFunction(cb.atHandle, cb.pParam);
+            }
+            if (cb.freeParam) {
+                free(cb.pParam);
+            }
+        }
+    }
+}
+
+// Increment the number of consecutive timeouts
+// and call the callback if there is one
+static void consecutiveTimeout(uAtClientInstance_t *pClient)
+{
     pClient->numConsecutiveAtTimeouts++;
     if (pClient->pConsecutiveTimeoutsCallback != NULL) {
         // pConsecutiveTimeoutsCallback second parameter
         // is an int32_t pointer but of course the generic
         // callback function is a void pointer so
         // need to cast here
-        cb.pFunction = (void (*) (uAtClientHandle_t, void *)) pClient->pConsecutiveTimeoutsCallback;
-        cb.atHandle = (uAtClientHandle_t) pClient;
-        cb.pParam = &(pClient->numConsecutiveAtTimeouts);
-        cb.atClientMagicNumber = pClient->magicNumber;
-        uPortEventQueueSend(gEventQueueHandle, &cb, sizeof(cb));
+        callbackSend(pClient,
+                     (void (*) (uAtClientHandle_t, void *)) pClient->pConsecutiveTimeoutsCallback,
+                     &(pClient->numConsecutiveAtTimeouts), false, false);
     }
-
-    U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
 }
 
 // Calculate the remaining time for polling based on the start
@@ -1049,6 +1386,123 @@ static int32_t pollTimeRemaining(int32_t atTimeoutMs,
     return (int32_t) timeRemainingMs;
 }
 
+// Return the log2 histogram bucket for the given duration.
+static size_t latencyBucket(int32_t durationMs)
+{
+    size_t bucket = 0;
+
+    // Bucket 0 is for zero, bucket n for durations from
+    // 2^(n - 1) up to (2^n) - 1, the last bucket catching
+    // everything larger
+    while ((durationMs > 0) && (bucket < U_AT_CLIENT_LATENCY_NUM_BUCKETS - 1)) {
+        durationMs >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+// Find the latency entry for the given prefix, adding it if it
+// is not there and there is room, returning its index or -1.
+// The stream mutex should be locked before this is called.
+static int32_t latencyEntryGet(uAtClientLatency_t *pLatency,
+                               const char *pPrefix, size_t prefixLength,
+                               bool isUrc)
+{
+    uAtClientLatencyEntry_t *pEntry = (uAtClientLatencyEntry_t *) (pLatency + 1);
+    int32_t index = -1;
+
+    if (prefixLength >= sizeof(pEntry->prefix)) {
+        prefixLength = sizeof(pEntry->prefix) - 1;
+    }
+    for (size_t x = 0; (index < 0) && (x < pLatency->numEntries); x++, pEntry++) {
+        if ((pEntry->isUrc == isUrc) &&
+            (strncmp(pEntry->prefix, pPrefix, prefixLength) == 0) &&
+            (pEntry->prefix[prefixLength] == 0)) {
+            index = (int32_t) x;
+        }
+    }
+    if ((index < 0) && (pLatency->numEntries < pLatency->maxNumEntries)) {
+        memset(pEntry, 0, sizeof(*pEntry));
+        memcpy(pEntry->prefix, pPrefix, prefixLength);
+        pEntry->isUrc = isUrc;
+        index = (int32_t) pLatency->numEntries;
+        pLatency->numEntries++;
+    }
+
+    return index;
+}
+
+// Note that an AT command has been sent, for the latency statistics.
+// The stream mutex should be locked before this is called.
+static void latencyCommandSent(uAtClientInstance_t *pClient,
+                               const char *pCommand)
+{
+    uAtClientLatency_t *pLatency = pClient->pLatency;
+
+    if ((pLatency != NULL) && (pCommand != NULL)) {
+        // The prefix is the command up to any parameters or
+        // query, e.g. "AT+CGDCONT" for "AT+CGDCONT=1,\"IP\""
+        pLatency->commandStopMs = uPortGetTickTimeMs();
+        pLatency->firstByteReceived = false;
+        pLatency->pendingEntry = latencyEntryGet(pLatency, pCommand,
+                                                 strcspn(pCommand, "=?"),
+                                                 false);
+    }
+}
+
+// Note that something has been received, for the latency statistics.
+// The stream mutex should be locked before this is called.
+static void latencyFirstByte(uAtClientInstance_t *pClient)
+{
+    uAtClientLatency_t *pLatency = pClient->pLatency;
+    uAtClientLatencyEntry_t *pEntry;
+
+    if ((pLatency != NULL) && (pLatency->pendingEntry >= 0) &&
+        !pLatency->firstByteReceived) {
+        pEntry = ((uAtClientLatencyEntry_t *) (pLatency + 1)) + pLatency->pendingEntry;
+        pEntry->firstByteHistogram[latencyBucket(uPortGetTickTimeMs() -
+                                                 pLatency->commandStopMs)]++;
+        pLatency->firstByteReceived = true;
+    }
+}
+
+// Note that the response to an AT command has ended, for the
+// latency statistics.
+// The stream mutex should be locked before this is called.
+static void latencyResponseStop(uAtClientInstance_t *pClient)
+{
+    uAtClientLatency_t *pLatency = pClient->pLatency;
+    uAtClientLatencyEntry_t *pEntry;
+
+    if ((pLatency != NULL) && (pLatency->pendingEntry >= 0)) {
+        pEntry = ((uAtClientLatencyEntry_t *) (pLatency + 1)) + pLatency->pendingEntry;
+        pEntry->count++;
+        pEntry->histogram[latencyBucket(uPortGetTickTimeMs() -
+                                        pLatency->commandStopMs)]++;
+        pLatency->pendingEntry = -1;
+    }
+}
+
+// Note the time spent handling a URC, for the latency statistics.
+// The stream mutex should be locked before this is called.
+static void latencyUrc(uAtClientInstance_t *pClient, const char *pPrefix,
+                       size_t prefixLength, int32_t durationMs)
+{
+    uAtClientLatency_t *pLatency = pClient->pLatency;
+    uAtClientLatencyEntry_t *pEntry;
+    int32_t index;
+
+    if (pLatency != NULL) {
+        index = latencyEntryGet(pLatency, pPrefix, prefixLength, true);
+        if (index >= 0) {
+            pEntry = ((uAtClientLatencyEntry_t *) (pLatency + 1)) + index;
+            pEntry->count++;
+            pEntry->histogram[latencyBucket(durationMs)]++;
+        }
+    }
+}
+
 // Zero the buffer.
 // totalReset also clears out any buffered data that
 // may be awaiting processing by a receive intercept
@@ -1091,7 +1545,7 @@ static void bufferReset(const uAtClientInstance_t *pClient,
 
 // Set the read position to 0 and move the buffer's
 // unread content to the beginning.
-static void bufferRewind(const uAtClientInstance_t *pClient)
+static void bufferCompact(const uAtClientInstance_t *pClient)
 {
     uAtClientReceiveBuffer_t *pBuffer = pClient->pReceiveBuffer;
 
@@ -1122,6 +1576,36 @@ static void bufferRewind(const uAtClientInstance_t *pClient)
     }
 }
 
+// Throw away what has been read from the buffer.  If nothing
+// is left unread this is free, otherwise, with lazy compaction,
+// the unread content is only moved to the beginning of the
+// buffer when the free space at the end of the buffer has
+// fallen below half, so the read position may not be 0
+// afterwards; code that parses the buffer must always work
+// from readIndex.
+static void bufferRewind(const uAtClientInstance_t *pClient)
+{
+    uAtClientReceiveBuffer_t *pBuffer = pClient->pReceiveBuffer;
+
+    if ((pBuffer->readIndex > 0) &&
+        (pBuffer->readIndex == pBuffer->length) &&
+        (pBuffer->lengthBuffered == pBuffer->length)) {
+        // Everything has been read, nothing to move
+        pBuffer->readIndex = 0;
+        pBuffer->length = 0;
+        pBuffer->lengthBuffered = 0;
+    } else {
+#if U_AT_CLIENT_RECEIVE_BUFFER_LAZY_COMPACT
+        if ((pBuffer->dataBufferSize - pBuffer->lengthBuffered) <
+            (pBuffer->dataBufferSize >> 1)) {
+            bufferCompact(pClient);
+        }
+#else
+        bufferCompact(pClient);
+#endif
+    }
+}
+
 // Read from the UART interface in nice coherent lines.
 static int32_t uartReadNoStutter(uAtClientInstance_t *pClient,
                                  uAtClientBlockState_t blockState,
@@ -1193,6 +1677,9 @@ static bool bufferFill(uAtClientInstance_t *pClient,
         case U_AT_CLIENT_STREAM_TYPE_EDM:
             eventIsCallback = uShortRangeEdmStreamAtEventIsCallback(pClient->streamHandle);
             break;
+        case U_AT_CLIENT_STREAM_TYPE_CMUX:
+            eventIsCallback = uCmuxChannelEventIsCallback(pClient->streamHandle);
+            break;
         default:
             break;
     }
@@ -1246,6 +1733,9 @@ static bool bufferFill(uAtClientInstance_t *pClient,
         }
     }
 
+    // Make room at the end of the buffer if we can
+    bufferRewind(pClient);
+
     // Reset buffer if it has become full
     if (pReceiveBuffer->lengthBuffered == pReceiveBuffer->dataBufferSize) {
 #if U_CFG_OS_CLIB_LEAKS
@@ -1284,10 +1774,20 @@ static bool bufferFill(uAtClientInstance_t *pClient,
                                                         pReceiveBuffer->dataBufferSize -
                                                         pReceiveBuffer->length);
                 break;
+            case U_AT_CLIENT_STREAM_TYPE_CMUX:
+                readLength = uCmuxChannelRead(pClient->streamHandle,
+                                              U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+                                              pReceiveBuffer->length,
+                                              pReceiveBuffer->dataBufferSize -
+                                              pReceiveBuffer->length);
+                break;
             default:
                 break;
         }
         LOG_BUFFER_FILL(4);
+        // Profile the processing of what has just been read, not
+        // the read itself, which may block
+        U_PORT_PROFILE_BEGIN(atBufferFill);
 
         if (readLength > 0) {
             // lengthBuffered is advanced by the amount we have
@@ -1339,7 +1839,10 @@ static bool bufferFill(uAtClientInstance_t *pClient,
                     // client hasn't looked at yet and "buffered" is stuff
                     // that the intercept function has yet to process. pData
                     // is somewhere inside "buffered", pointing to our new
-                    // "length" of processed data.  The intercept function
+                    // "length" of processed data (or it may be in memory
+                    // of the intercept function's own, e.g. chip to chip
+                    // security decrypts into its context, since it is
+                    // only the source of a memmove()).  The intercept function
                     // will have moved pDataIntercept to somewhere beyond the
                     // end of "length".
                     //
@@ -1424,6 +1927,9 @@ static bool bufferFill(uAtClientInstance_t *pClient,
             } while (pData != NULL);
         }
 
+        if (readLength > 0) {
+            U_PORT_PROFILE_END(atBufferFill, readLength);
+        }
         LOG_BUFFER_FILL(14);
         uPortTaskBlock(U_AT_CLIENT_STREAM_READ_RETRY_DELAY_MS);
     } while ((readLength == 0) &&
@@ -1431,13 +1937,14 @@ static bool bufferFill(uAtClientInstance_t *pClient,
 
     LOG_BUFFER_FILL(15);
     if (readLength > 0) {
+        latencyFirstByte(pClient);
 #if U_CFG_OS_CLIB_LEAKS
         // If the C library leaks then don't print
         // in a callback as it will leak
         if (!eventIsCallback) {
 #endif
             printAt(pClient, U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
-                    pReceiveBuffer->length + pReceiveBuffer->readIndex,
+                    pReceiveBuffer->length,
                     readLength);
 #if U_CFG_OS_CLIB_LEAKS
         }
@@ -1496,6 +2003,71 @@ static int32_t bufferReadChar(uAtClientInstance_t *pClient)
     return character;
 }
 
+#if U_AT_CLIENT_READ_BYTES_DIRECT
+// Read lengthBytes of payload into pBuffer: first whatever is
+// already in the receive buffer is copied out and then, if
+// nothing else is buffered and there is no receive intercept
+// function in the way, the rest is read directly from the UART,
+// bypassing the receive buffer.  Returns the number of bytes
+// read, which may be less than lengthBytes: if the stream is
+// not a UART the caller should read the remainder in the normal
+// way, while on a timeout the error flag is set, just as
+// bufferReadChar() would, so that the caller doesn't wait for
+// the whole AT timeout all over again.
+static size_t readBytesDirect(uAtClientInstance_t *pClient,
+                              char *pBuffer, size_t lengthBytes)
+{
+    uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
+    size_t lengthRead = pReceiveBuffer->length - pReceiveBuffer->readIndex;
+    int32_t atTimeoutMs = pClient->atTimeoutMs;
+    int32_t thisLength;
+
+    // Copy out what is already in the receive buffer
+    if (lengthRead > lengthBytes) {
+        lengthRead = lengthBytes;
+    }
+    memcpy(pBuffer, U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+           pReceiveBuffer->readIndex, lengthRead);
+    pReceiveBuffer->readIndex += lengthRead;
+
+    if ((lengthRead < lengthBytes) &&
+        (pClient->streamType == U_AT_CLIENT_STREAM_TYPE_UART) &&
+        (pClient->pInterceptRx == NULL) &&
+        (pReceiveBuffer->lengthBuffered == pReceiveBuffer->length)) {
+        // The receive buffer is now empty, just reset it
+        bufferReset(pClient, true);
+        if (uPortUartEventIsCallback(pClient->streamHandle)) {
+            // Short timeout if we're in a URC callback
+            atTimeoutMs = U_AT_CLIENT_URC_TIMEOUT_MS;
+        }
+        while ((lengthRead < lengthBytes) &&
+               (pollTimeRemaining(atTimeoutMs, pClient->lockTimeMs) > 0)) {
+            thisLength = uPortUartRead(pClient->streamHandle,
+                                       pBuffer + lengthRead,
+                                       lengthBytes - lengthRead);
+            if (thisLength > 0) {
+                printAt(pClient, pBuffer + lengthRead, thisLength);
+                lengthRead += thisLength;
+                pClient->numConsecutiveAtTimeouts = 0;
+            } else {
+                uPortTaskBlock(U_AT_CLIENT_STREAM_READ_RETRY_DELAY_MS);
+            }
+        }
+        if (lengthRead < lengthBytes) {
+            // Timeout
+            if (pClient->debugOn) {
+                uPortLog("U_AT_CLIENT_%d-%d: timeout.\n",
+                         pClient->streamType, pClient->streamHandle);
+            }
+            setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
+            consecutiveTimeout(pClient);
+        }
+    }
+
+    return lengthRead;
+}
+#endif
+
 // Look for pString at the start of the current receive buffer
 // without bringing more data into it, and if the string
 // is there consume it.
@@ -1569,24 +2141,46 @@ static void setScope(uAtClientInstance_t *pClient,
     }
 }
 
-// Consume characters until pString is found.
+// Consume characters until pString, of length characters, is found.
 static bool consumeToString(uAtClientInstance_t *pClient,
-                            const char *pString)
+                            const char *pString, size_t length)
 {
+    uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
     size_t index = 0;
-    size_t length = strlen(pString);
     int32_t character = 0;
+    const char *pData;
+    const char *pFound;
+    size_t available;
 
     while ((character >= 0) &&
            (index < length)) {
-        character = bufferReadChar(pClient);
-        if (character >= 0) {
-            if (character == *(pString + index)) {
-                index++;
-            } else {
-                index = 0;
-                if (character == *pString) {
+        if (index == 0) {
+            // Not part-way through a match: rather than going
+            // character by character, search whatever is already
+            // in the buffer in one go
+            pData = U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+                    pReceiveBuffer->readIndex;
+            available = pReceiveBuffer->length - pReceiveBuffer->readIndex;
+            pFound = pUAtClientPrivateMemStr(pData, available, pString, length);
+            if (pFound != NULL) {
+                pReceiveBuffer->readIndex += (pFound - pData) + length;
+                index = length;
+            } else if (available >= length) {
+                // Not there: only the last length - 1 characters
+                // could be the start of it, skip the rest
+                pReceiveBuffer->readIndex += available - (length - 1);
+            }
+        }
+        if (index < length) {
+            character = bufferReadChar(pClient);
+            if (character >= 0) {
+                if (character == *(pString + index)) {
                     index++;
+                } else {
+                    index = 0;
+                    if (character == *pString) {
+                        index++;
+                    }
                 }
             }
         }
@@ -1608,7 +2202,8 @@ static bool consumeToStopTag(uAtClientInstance_t *pClient)
             bufferReset(pClient, false);
         } else {
             // Otherwise consume up to the stop tag
-            found = consumeToString(pClient, pClient->stopTag.pTagDef->pString);
+            found = consumeToString(pClient, pClient->stopTag.pTagDef->pString,
+                                    pClient->stopTag.pTagDef->length);
             if (!found) {
                 setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
                 if (pClient->debugOn) {
@@ -1635,49 +2230,164 @@ static void informationResponseStop(uAtClientInstance_t *pClient)
     }
 }
 
-// Iterate through URCs and check if one of them matches the current
-// contents of the receive buffer. If a URC is matched, set the
-// scope to information response and, after the URC's handler has
-// returned, finish off the information response scope by consuming
-// up to CR/LF.
-static bool bufferMatchOneUrc(uAtClientInstance_t *pClient)
+// Return the bucket in the URC index for the given key, which must
+// be at least U_AT_CLIENT_URC_INDEX_KEY_LENGTH characters long.
+static size_t urcIndexBucket(const char *pKey)
+{
+    uint32_t hash = 0;
+
+    for (size_t x = 0; x < U_AT_CLIENT_URC_INDEX_KEY_LENGTH; x++) {
+        hash = (hash * 31) + (unsigned char) * (pKey + x);
+    }
+
+    return hash % U_AT_CLIENT_URC_INDEX_NUM_BUCKETS;
+}
+
+// Return a pointer to the anchor of the chain in the URC index
+// that a URC with the given prefix would be in.
+static uAtClientUrc_t **ppUrcIndexChain(uAtClientInstance_t *pClient,
+                                        const char *pPrefix,
+                                        size_t prefixLength)
+{
+    // URCs with short prefixes are in the last chain
+    size_t bucket = U_AT_CLIENT_URC_INDEX_NUM_BUCKETS;
+
+    if (prefixLength >= U_AT_CLIENT_URC_INDEX_KEY_LENGTH) {
+        bucket = urcIndexBucket(pPrefix);
+    }
+
+    return &(pClient->pUrcIndex[bucket]);
+}
+
+// Find a URC in the index by its prefix.
+static uAtClientUrc_t *pUrcIndexFind(uAtClientInstance_t *pClient,
+                                     const char *pPrefix)
+{
+    size_t prefixLength = strlen(pPrefix);
+    uAtClientUrc_t *pUrc = *ppUrcIndexChain(pClient, pPrefix, prefixLength);
+
+    while ((pUrc != NULL) &&
+           ((pUrc->prefixLength != prefixLength) ||
+            (memcmp(pPrefix, pUrc->pPrefix, prefixLength) != 0))) {
+        pUrc = pUrc->pNextInBucket;
+    }
+
+    return pUrc;
+}
+
+// Add a URC to the front of its chain in the index, just as it is
+// added to the front of pUrcList, so that the order in which
+// URCs are matched is not changed by the index.
+// urcPermittedMutex should be locked before this is called.
+static void urcIndexAdd(uAtClientInstance_t *pClient, uAtClientUrc_t *pUrc)
 {
-    size_t prefixLength = 0;
+    uAtClientUrc_t **ppChain = ppUrcIndexChain(pClient, pUrc->pPrefix,
+                                               pUrc->prefixLength);
+
+    pUrc->pNextInBucket = *ppChain;
+    *ppChain = pUrc;
+}
+
+// Remove a URC from the index.
+// urcPermittedMutex should be locked before this is called.
+static void urcIndexRemove(uAtClientInstance_t *pClient,
+                           const uAtClientUrc_t *pUrc)
+{
+    uAtClientUrc_t **ppChain = ppUrcIndexChain(pClient, pUrc->pPrefix,
+                                               pUrc->prefixLength);
+
+    while ((*ppChain != NULL) && (*ppChain != pUrc)) {
+        ppChain = &((*ppChain)->pNextInBucket);
+    }
+    if (*ppChain != NULL) {
+        *ppChain = pUrc->pNextInBucket;
+    }
+}
+
+// Search one chain of the URC index for a URC whose prefix matches
+// the start of the receive buffer, consuming the prefix if it does.
+static uAtClientUrc_t *pUrcIndexMatchChain(uAtClientInstance_t *pClient,
+                                           uAtClientUrc_t *pUrc,
+                                           size_t *pNumCompares)
+{
+    size_t available = pClient->pReceiveBuffer->length -
+                       pClient->pReceiveBuffer->readIndex;
     bool found = false;
+
+    while (!found && (pUrc != NULL)) {
+        if (available >= pUrc->prefixLength) {
+            (*pNumCompares)++;
+            found = bufferMatch(pClient, pUrc->pPrefix, pUrc->prefixLength);
+        }
+        if (!found) {
+            pUrc = pUrc->pNextInBucket;
+        }
+    }
+
+    return pUrc;
+}
+
+// Check if one of the URCs matches the current contents of the
+// receive buffer, using the URC index to avoid comparing against
+// every URC. If a URC is matched, set the scope to information
+// response and, after the URC's handler has returned, finish off
+// the information response scope by consuming up to CR/LF.
+static bool bufferMatchOneUrc(uAtClientInstance_t *pClient)
+{
+    uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
+    uAtClientUrc_t *pUrc = NULL;
+    size_t numCompares = 0;
     int32_t now;
     uErrorCode_t savedError;
 
     bufferRewind(pClient);
 
-    for (uAtClientUrc_t *pUrc = pClient->pUrcList;
-         !found && (pUrc != NULL);
-         pUrc = pUrc->pNext) {
-        prefixLength = pUrc->prefixLength;
-        if (pClient->pReceiveBuffer->length >= prefixLength) {
-            if (bufferMatch(pClient, pUrc->pPrefix, prefixLength)) {
-                setScope(pClient, U_AT_CLIENT_SCOPE_INFORMATION);
-                now = uPortGetTickTimeMs();
-                // Before heading off into URCness, save
-                // the current error state and reset
-                // it so that the URC doesn't suffer the error
-                savedError = pClient->error;
-                pClient->error = U_ERROR_COMMON_SUCCESS;
-                if (processAsync(pClient->magicNumber) && pUrc->pHandler) {
-                    pUrc->pHandler(pClient, pUrc->pHandlerParam);
-                }
-                informationResponseStop(pClient);
-                // Put the error state back again
-                pClient->error = savedError;
-                // Put the error state back again
-                // Add the amount of time spent in the URC
-                // world to the start time
-                pClient->lockTimeMs += uPortGetTickTimeMs() - now;
-                found = true;
-            }
+    // A URC prefix long enough to be hashed can only match
+    // if there are enough characters in the buffer to hash
+    if ((pReceiveBuffer->length - pReceiveBuffer->readIndex) >=
+        U_AT_CLIENT_URC_INDEX_KEY_LENGTH) {
+        pUrc = pUrcIndexMatchChain(pClient,
+                                   pClient->pUrcIndex[urcIndexBucket(U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+                                                                     pReceiveBuffer->readIndex)],
+                                   &numCompares);
+    }
+    if (pUrc == NULL) {
+        pUrc = pUrcIndexMatchChain(pClient,
+                                   pClient->pUrcIndex[U_AT_CLIENT_URC_INDEX_NUM_BUCKETS],
+                                   &numCompares);
+    }
+
+    if (pUrc != NULL) {
+        pClient->urcStats.numMatches++;
+        pClient->urcStats.numCompares += (uint32_t) numCompares;
+        pClient->urcStats.lastMatchCompares = (uint32_t) numCompares;
+        if (numCompares > pClient->urcStats.maxMatchCompares) {
+            pClient->urcStats.maxMatchCompares = (uint32_t) numCompares;
+        }
+        setScope(pClient, U_AT_CLIENT_SCOPE_INFORMATION);
+        now = uPortGetTickTimeMs();
+        // Before heading off into URCness, save
+        // the current error state and reset
+        // it so that the URC doesn't suffer the error
+        savedError = pClient->error;
+        pClient->error = U_ERROR_COMMON_SUCCESS;
+        U_PORT_SPAN_BEGIN(pUrc->pPrefix);
+        if (processAsync(pClient->magicNumber) && pUrc->pHandler) {
+            pUrc->pHandler(pClient, pUrc->pHandlerParam);
         }
+        informationResponseStop(pClient);
+        U_PORT_SPAN_END();
+        // Put the error state back again
+        pClient->error = savedError;
+        // Add the amount of time spent in the URC
+        // world to the start time
+        now = uPortGetTickTimeMs() - now;
+        U_TRACE(AT_URC, now);
+        pClient->lockTimeMs += now;
+        latencyUrc(pClient, pUrc->pPrefix, pUrc->prefixLength, now);
     }
 
-    return found;
+    return pUrc != NULL;
 }
 
 // Read a string parameter.
@@ -1804,7 +2514,103 @@ static int32_t readInt(uAtClientInstance_t *pClient)
     return integerRead;
 }
 
-// Record an error sent from the AT server, i.e. ERROR
+// Read a list of integers in one pass, converting the digits as
+// they are read rather than collecting each parameter into a
+// string first; the result for each parameter is the same as
+// readInt() would give, including -1 for an empty parameter.
+// The mutex should be locked before this is called.
+static int32_t readIntList(uAtClientInstance_t *pClient, int32_t *pValues,
+                           size_t numValues, uint32_t skipMask)
+{
+    uAtClientTag_t *pStopTag = &(pClient->stopTag);
+    size_t numRead = 0;
+    size_t matchPos = 0;
+    bool delimiterFound;
+    bool inQuotes;
+    bool skip;
+    bool numberStarted;
+    bool numberEnded;
+    bool isNegative;
+    size_t length;
+    uint32_t digits;
+    int32_t c;
+
+    for (size_t x = 0; x < numValues; x++) {
+        skip = (x < 32) && ((skipMask & (1UL << x)) != 0);
+        if (!skip) {
+            *(pValues + x) = -1;
+        }
+        if ((pClient->error == U_ERROR_COMMON_SUCCESS) && !pStopTag->found) {
+            delimiterFound = false;
+            inQuotes = false;
+            numberStarted = false;
+            numberEnded = false;
+            isNegative = false;
+            length = 0;
+            digits = 0;
+            while ((pClient->error == U_ERROR_COMMON_SUCCESS) &&
+                   !delimiterFound && !pStopTag->found) {
+                c = bufferReadChar(pClient);
+                if (c == -1) {
+                    setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
+                } else if (!inQuotes && (c == pClient->delimiter)) {
+                    delimiterFound = true;
+                } else if (c == '\"') {
+                    matchPos = 0;
+                    inQuotes = !inQuotes;
+                } else {
+                    if (!inQuotes && (pStopTag->pTagDef->length > 0)) {
+                        // It could be a stop tag
+                        if (c == *(pStopTag->pTagDef->pString + matchPos)) {
+                            matchPos++;
+                        } else {
+                            matchPos = 0;
+                            if (c == *(pStopTag->pTagDef->pString)) {
+                                matchPos++;
+                            }
+                        }
+                        if (matchPos == pStopTag->pTagDef->length) {
+                            pStopTag->found = true;
+                            // The tag is not part of the parameter
+                            length -= pStopTag->pTagDef->length - 1;
+                        }
+                    } else {
+                        matchPos = 0;
+                    }
+                    if (!pStopTag->found) {
+                        if (!skip && !numberEnded) {
+                            // Convert as strtol() would: leading
+                            // white space, an optional sign, then
+                            // digits up to the first non-digit
+                            if ((c >= '0') && (c <= '9')) {
+                                digits = (digits * 10) + (uint32_t) (c - '0');
+                                numberStarted = true;
+                            } else if (!numberStarted && ((c == ' ') || (c == '\t'))) {
+                                // Leading white space
+                            } else if (!numberStarted && ((c == '-') || (c == '+'))) {
+                                isNegative = (c == '-');
+                                numberStarted = true;
+                            } else {
+                                numberEnded = true;
+                            }
+                        }
+                        length++;
+                    }
+                }
+            }
+            if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+                numRead++;
+                if (!skip && (length > 0)) {
+                    *(pValues + x) = isNegative ? -(int32_t) digits : (int32_t) digits;
+                }
+            }
+        }
+    }
+
+    return (pClient->error == U_ERROR_COMMON_SUCCESS) ? (int32_t) numRead : -1;
+}
+
+// Record an error sent from the AT server, i.e. ERROR
 // or CMS ERROR or CME ERROR.
 static void setDeviceError(uAtClientInstance_t *pClient,
                            uAtClientDeviceErrorType_t errorType)
@@ -1905,12 +2711,15 @@ static bool processResponse(uAtClientInstance_t *pClient,
                         // If no matches were found, see if there's
                         // a CR/LF in the buffer with some characters
                         // between it and where we are now to read
-                        pTmp = pMemStr(U_AT_CLIENT_DATA_BUFFER_PTR(pClient->pReceiveBuffer) +
-                                       pClient->pReceiveBuffer->readIndex,
-                                       pClient->pReceiveBuffer->length,
-                                       U_AT_CLIENT_CRLF, U_AT_CLIENT_CRLF_LENGTH_BYTES);
+                        pTmp = pUAtClientPrivateMemStr(U_AT_CLIENT_DATA_BUFFER_PTR(pClient->pReceiveBuffer) +
+                                                       pClient->pReceiveBuffer->readIndex,
+                                                       pClient->pReceiveBuffer->length -
+                                                       pClient->pReceiveBuffer->readIndex,
+                                                       U_AT_CLIENT_CRLF,
+                                                       U_AT_CLIENT_CRLF_LENGTH_BYTES);
                         if ((pTmp != NULL) &&
-                            (pTmp - U_AT_CLIENT_DATA_BUFFER_PTR(pClient->pReceiveBuffer)) > 0) {
+                            (pTmp > U_AT_CLIENT_DATA_BUFFER_PTR(pClient->pReceiveBuffer) +
+                             pClient->pReceiveBuffer->readIndex)) {
                             // There is a CR/LF after some stuff
                             // to read and there was no prefix,
                             // so return now so that the caller
@@ -1920,7 +2729,8 @@ static bool processResponse(uAtClientInstance_t *pClient,
                                 processingDone = true;
                             } else {
                                 // Just consume up to CR/LF
-                                consumeToString(pClient, U_AT_CLIENT_CRLF);
+                                consumeToString(pClient, U_AT_CLIENT_CRLF,
+                                                U_AT_CLIENT_CRLF_LENGTH_BYTES);
                             }
                         } else {
                             // We might still bufferMatch something,
@@ -1944,6 +2754,91 @@ static bool processResponse(uAtClientInstance_t *pClient,
     return prefixMatched;
 }
 
+// Return true if the module needs to be woken up before
+// anything more can be sent to it.
+static bool wakeUpRequired(const uAtClientInstance_t *pClient)
+{
+    return (pClient->pWakeUp != NULL) && (pClient->lastTxTimeMs >= 0) &&
+           (uPortGetTickTimeMs() - pClient->lastTxTimeMs > pClient->pWakeUp->inactivityTimeoutMs);
+}
+
+// Run an asynchronous batch of AT commands: called via the event
+// queue, the job is free()ed by eventQueueCallback().
+static void batchAsyncCallback(uAtClientHandle_t atHandle, void *pParam)
+{
+    uAtClientBatchAsync_t *pJob = (uAtClientBatchAsync_t *) pParam;
+    int32_t errorCodeOrCount;
+
+    errorCodeOrCount = uAtClientBatch(atHandle,
+                                      (const uAtClientBatchCommand_t *) (pJob + 1),
+                                      pJob->numCommands, pJob->concatenate);
+    if (pJob->pCallback != NULL) {
+        pJob->pCallback(atHandle, errorCodeOrCount, pJob->pCallbackParam);
+    }
+}
+
+// Release any batches deferred by uAtClientBatchDeferrable() to the
+// callback queue, in the order they were submitted.  If timedOut is
+// true this is being called from the deferral timer and the first
+// batch released will have to wake the module up itself, else the
+// module has just been woken up and all of them share that wake-up.
+// The AT client mutex need not be locked.
+static void deferredRelease(uAtClientInstance_t *pClient, bool timedOut)
+{
+    uAtClientBatchAsync_t *pJob = NULL;
+    uAtClientBatchAsync_t *pNext;
+    uint32_t numReleased = 0;
+    int32_t errorCode;
+
+    if (pClient->deferMutex != NULL) {
+        U_PORT_MUTEX_LOCK(pClient->deferMutex);
+        pJob = pClient->pDeferred;
+        pClient->pDeferred = NULL;
+        if ((pJob != NULL) && !timedOut) {
+            // The timer is one-shot so it only needs
+            // stopping if it has not yet gone off
+            uPortTimerStop(pClient->deferTimer);
+        }
+        U_PORT_MUTEX_UNLOCK(pClient->deferMutex);
+    }
+
+    while (pJob != NULL) {
+        pNext = pJob->pNext;
+        pJob->pNext = NULL;
+        errorCode = callbackSend(pClient, batchAsyncCallback, pJob, true, false);
+        if (errorCode < 0) {
+            // The caller was told the batch was accepted
+            // so they must be told that it has failed
+            if (pJob->pCallback != NULL) {
+                pJob->pCallback((uAtClientHandle_t) pClient, errorCode,
+                                pJob->pCallbackParam);
+            }
+            free(pJob);
+        } else {
+            numReleased++;
+        }
+        pJob = pNext;
+    }
+
+    if (numReleased > 0) {
+        if (timedOut) {
+            numReleased--;
+        }
+        U_PORT_MUTEX_LOCK(pClient->deferMutex);
+        pClient->wakeUpStats.numCoalesced += numReleased;
+        U_PORT_MUTEX_UNLOCK(pClient->deferMutex);
+    }
+}
+
+// Callback for the deferral timer.
+static void deferTimerCallback(const uPortTimerHandle_t timerHandle,
+                               void *pParameter)
+{
+    (void) timerHandle;
+
+    deferredRelease((uAtClientInstance_t *) pParameter, true);
+}
+
 // Write data to the stream.
 //
 // Design note concerning the wake-up handler
@@ -1986,8 +2881,7 @@ static size_t write(uAtClientInstance_t *pClient,
     while (((pData < pDataStart + length) || andFlush) &&
            (pClient->error == U_ERROR_COMMON_SUCCESS)) {
         lengthToWrite = length - (pData - pDataStart);
-        if ((pClient->pWakeUp != NULL) && (pClient->lastTxTimeMs >= 0) &&
-            (uPortGetTickTimeMs() - pClient->lastTxTimeMs > pClient->pWakeUp->inactivityTimeoutMs) &&
+        if (wakeUpRequired(pClient) &&
             (uPortMutexTryLock(pClient->pWakeUp->inWakeUpHandlerMutex, 0) == 0)) {
             // We have a wake-up handler, the inactivity timeout
             // has expired and we've managed to lock the wake-up
@@ -2043,9 +2937,21 @@ static size_t write(uAtClientInstance_t *pClient,
                 pClient->lockTimeMs = savedLockTimeMs + wakeUpDurationMs;
             } else {
                 pClient->lockTimeMs = uPortGetTickTimeMs();
+                wakeUpDurationMs = 0;
+            }
+            pClient->wakeUpStats.numWakeUps++;
+            pClient->wakeUpStats.wakeUpDurationLastMs = wakeUpDurationMs;
+            if (wakeUpDurationMs > pClient->wakeUpStats.wakeUpDurationMaxMs) {
+                pClient->wakeUpStats.wakeUpDurationMaxMs = wakeUpDurationMs;
             }
+            pClient->wakeUpStats.wakeUpDurationTotalMs += wakeUpDurationMs;
             // We are no longer in the wake-up handler
             uPortMutexUnlock(pClient->pWakeUp->inWakeUpHandlerMutex);
+            if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+                // The module is awake: anything that was
+                // deferred can go now under the same wake-up
+                deferredRelease(pClient, false);
+            }
         }
 
         if (pClient->error == U_ERROR_COMMON_SUCCESS) {
@@ -2084,6 +2990,10 @@ static size_t write(uAtClientInstance_t *pClient,
                     // Write handled in intercept
                     case U_AT_CLIENT_STREAM_TYPE_EDM:
                         break;
+                    case U_AT_CLIENT_STREAM_TYPE_CMUX:
+                        thisLengthWritten = uCmuxChannelWrite(pClient->streamHandle,
+                                                              pDataToWrite, lengthToWrite);
+                        break;
                     default:
                         break;
                 }
@@ -2137,21 +3047,52 @@ static bool writeCheckAndDelimit(uAtClientInstance_t *pClient)
     return isOk;
 }
 
-// Check if a URC handler is already in the list.
-static bool findUrcHandler(const uAtClientInstance_t *pClient,
-                           const char *pPrefix)
+// Wait for the delay period required between the end of one
+// AT command and the start of the next.
+static void commandDelay(uAtClientInstance_t *pClient)
 {
-    uAtClientUrc_t *pUrc = pClient->pUrcList;
-    bool found = false;
+    // Wait for delay period if required, constructed this way
+    // to be safe if uPortGetTickTimeMs() wraps
+    if (pClient->delayMs > 0) {
+        // TP changed, as it was not wrap-safe, at least not with int64_t time (failed after ~24 days)
+        // while (uPortGetTickTimeMs() - pClient->lastResponseStopMs < pClient->delayMs) {
+        //     uPortTaskBlock(10);
+        // }
+        do {
+            int32_t diff = uPortGetTickTimeMs() - pClient->lastResponseStopMs;
+            diff &= 0x7FFFFFF;  // clear sign bit
+            if( diff < pClient->delayMs) {
+                uPortTaskBlock(10);
+            } else {
+                break;
+            }
+        } while(1);
+    }
+}
 
-    while ((pUrc != NULL) && !found) {
-        if (strcmp(pPrefix, pUrc->pPrefix) == 0) {
-            found = true;
+// Append to the buffer of uAtClientCommandPrepared(), writing
+// out what is already there first if it would overflow.
+static void preparedAppend(uAtClientInstance_t *pClient,
+                           char *pBuffer, size_t *pLength,
+                           const char *pData, size_t length)
+{
+    size_t thisLength;
+
+    while ((length > 0) && (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+        if (*pLength == U_AT_CLIENT_PREPARED_COMMAND_BUFFER_LENGTH_BYTES) {
+            // write() will set device error if there's a problem
+            write(pClient, pBuffer, *pLength, false);
+            *pLength = 0;
+        }
+        thisLength = U_AT_CLIENT_PREPARED_COMMAND_BUFFER_LENGTH_BYTES - *pLength;
+        if (thisLength > length) {
+            thisLength = length;
         }
-        pUrc = pUrc->pNext;
+        memcpy(pBuffer + *pLength, pData, thisLength);
+        *pLength += thisLength;
+        pData += thisLength;
+        length -= thisLength;
     }
-
-    return found;
 }
 
 // Try to lock the stream: this does NOT clear errors.
@@ -2286,6 +3227,17 @@ static int32_t uint64ToString(char *pBuffer, size_t length,
     return sizeOrError;
 }
 
+// Return true if the given AT command is an extended one,
+// i.e. it begins "AT+", and hence may be concatenated with
+// other extended AT commands on a single command line.
+static bool isExtendedCommand(const char *pCommand)
+{
+    return (strlen(pCommand) > 3) &&
+           ((*pCommand == 'A') || (*pCommand == 'a')) &&
+           ((*(pCommand + 1) == 'T') || (*(pCommand + 1) == 't')) &&
+           (*(pCommand + 2) == '+');
+}
+
 // Get the amount of stuff in the receive buffer for the URC
 // (and so check processAsync() also).
 static int32_t getReceiveSizeForUrc(const uAtClientInstance_t *pClient)
@@ -2300,6 +3252,9 @@ static int32_t getReceiveSizeForUrc(const uAtClientInstance_t *pClient)
             case U_AT_CLIENT_STREAM_TYPE_EDM:
                 receiveSize = uShortRangeEdmStreamAtGetReceiveSize(pClient->streamHandle);
                 break;
+            case U_AT_CLIENT_STREAM_TYPE_CMUX:
+                receiveSize = uCmuxChannelGetReceiveSize(pClient->streamHandle);
+                break;
             default:
                 break;
         }
@@ -2322,7 +3277,8 @@ static void urcCallback(int32_t streamHandle, uint32_t eventBitmask,
 
     if ((pClient != NULL) &&
         (pClient->streamHandle == streamHandle) &&
-        (eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) &&
+        (eventBitmask & (U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED |
+                         U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED)) &&
         (uPortMutexTryLock(pClient->urcPermittedMutex, 0) == 0)) {
 
         // Potential URC data is available.  However,
@@ -2357,12 +3313,15 @@ static void urcCallback(int32_t streamHandle, uint32_t eventBitmask,
                             break;
                         }
                         // If no bufferMatch was found, look for CR/LF
-                    } else if (pMemStr(U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
-                                       pReceiveBuffer->readIndex,
-                                       pReceiveBuffer->length,
-                                       U_AT_CLIENT_CRLF, U_AT_CLIENT_CRLF_LENGTH_BYTES) != NULL) {
+                    } else if (pUAtClientPrivateMemStr(U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+                                                       pReceiveBuffer->readIndex,
+                                                       pReceiveBuffer->length -
+                                                       pReceiveBuffer->readIndex,
+                                                       U_AT_CLIENT_CRLF,
+                                                       U_AT_CLIENT_CRLF_LENGTH_BYTES) != NULL) {
                         // Consume everything up to the CR/LF
-                        consumeToString(pClient, U_AT_CLIENT_CRLF);
+                        consumeToString(pClient, U_AT_CLIENT_CRLF,
+                                        U_AT_CLIENT_CRLF_LENGTH_BYTES);
                     } else {
                         // If no bufferMatch was found and there's no CR/LF to
                         // consume up to, bring in more data and we'll check
@@ -2400,17 +3359,39 @@ static void urcCallback(int32_t streamHandle, uint32_t eventBitmask,
     }
 }
 
-// Callback for the event queue.
-static void eventQueueCallback(void *pParameters, size_t paramLength)
-{
-    uAtClientCallback_t *pCb = (uAtClientCallback_t *) pParameters;
-
-    (void) paramLength;
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: PRIVATE TO THE AT CLIENT
+ * These functions are exposed in u_at_client_private.h only so
+ * that they can be tested.
+ * -------------------------------------------------------------- */
 
-    if ((pCb != NULL) && (pCb->pFunction != NULL) &&
-        processAsync(pCb->atClientMagicNumber)) {
-        pCb->pFunction(pCb->atHandle, pCb->pParam);
+// Find one character buffer inside another.
+const char *pUAtClientPrivateMemStr(const char *pBuffer,
+                                    size_t bufferLength,
+                                    const char *pFind,
+                                    size_t findLength)
+{
+    const char *pPos = NULL;
+    const char *pEnd;
+
+    if (findLength == 0) {
+        pPos = pBuffer;
+    } else if (bufferLength >= findLength) {
+        // pEnd is one beyond the last place pFind could start
+        pEnd = pBuffer + (bufferLength - findLength) + 1;
+        while ((pPos == NULL) && (pBuffer < pEnd)) {
+            pBuffer = (const char *) memchr(pBuffer, *pFind, pEnd - pBuffer);
+            if (pBuffer == NULL) {
+                pBuffer = pEnd;
+            } else if (memcmp(pBuffer + 1, pFind + 1, findLength - 1) == 0) {
+                pPos = pBuffer;
+            } else {
+                pBuffer++;
+            }
+        }
     }
+
+    return pPos;
 }
 
 /* ----------------------------------------------------------------
@@ -2454,10 +3435,10 @@ int32_t uAtClientInit()
         // Create an event queue for callbacks
         errorCodeOrHandle = uPortEventQueueOpen(eventQueueCallback,
                                                 "atCallbacks",
-                                                sizeof(uAtClientCallback_t),
+                                                sizeof(uAtClientCallbackKick_t),
                                                 U_AT_CLIENT_CALLBACK_TASK_STACK_SIZE_BYTES,
                                                 U_AT_CLIENT_CALLBACK_TASK_PRIORITY,
-                                                U_AT_CLIENT_CALLBACK_QUEUE_LENGTH);
+                                                U_AT_CLIENT_CALLBACK_EVENT_QUEUE_LENGTH);
         if (errorCodeOrHandle >= 0) {
             gEventQueueHandle = errorCodeOrHandle;
             // Create the mutex that protects gEventQueueHandle
@@ -2566,6 +3547,7 @@ uAtClientHandle_t uAtClientAdd(int32_t streamHandle,
                         pClient->lastTxTimeMs = -1;
                         pClient->urcMaxStringLength = U_AT_CLIENT_INITIAL_URC_LENGTH;
                         pClient->maxRespLength = U_AT_CLIENT_MAX_LENGTH_INFORMATION_RESPONSE_PREFIX;
+                        pClient->callbackQueueLength = U_AT_CLIENT_CALLBACK_QUEUE_LENGTH;
                         // Set up the buffer and its protection markers
                         pClient->pReceiveBuffer->dataBufferSize = receiveBufferSize -
                                                                   U_AT_CLIENT_BUFFER_OVERHEAD_BYTES;
@@ -2580,7 +3562,7 @@ uAtClientHandle_t uAtClientAdd(int32_t streamHandle,
                         switch (streamType) {
                             case U_AT_CLIENT_STREAM_TYPE_UART:
                                 errorCode = uPortUartEventCallbackSet(streamHandle,
-                                                                      U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                                      U_AT_CLIENT_UART_EVENT_BITMASK,
                                                                       urcCallback, pClient,
                                                                       U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES,
                                                                       U_AT_CLIENT_URC_TASK_PRIORITY);
@@ -2588,6 +3570,13 @@ uAtClientHandle_t uAtClientAdd(int32_t streamHandle,
                             case U_AT_CLIENT_STREAM_TYPE_EDM:
                                 errorCode = uShortRangeEdmStreamAtCallbackSet(streamHandle, urcCallback, pClient);
                                 break;
+                            case U_AT_CLIENT_STREAM_TYPE_CMUX:
+                                errorCode = uCmuxChannelEventCallbackSet(streamHandle,
+                                                                         U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                                         urcCallback, pClient,
+                                                                         U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES,
+                                                                         U_AT_CLIENT_URC_TASK_PRIORITY);
+                                break;
                             default:
                                 // streamType is checked on entry
                                 break;
@@ -2853,12 +3842,12 @@ int32_t uAtClientUnlock(uAtClientHandle_t atHandle)
                     // events in the UART queue, the URC callback will certainly
                     // be run anyway.
                     sendErrorCode = uPortUartEventTrySend(pClient->streamHandle,
-                                                          U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                          U_AT_CLIENT_UART_EVENT_BITMASK,
                                                           0);
                     if ((sendErrorCode == (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED) ||
                         (sendErrorCode == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED)) {
                         uPortUartEventSend(pClient->streamHandle,
-                                           U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED);
+                                           U_AT_CLIENT_UART_EVENT_BITMASK);
                     }
                 }
                 break;
@@ -2870,6 +3859,15 @@ int32_t uAtClientUnlock(uAtClientHandle_t atHandle)
                                                     U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED);
                 }
                 break;
+            case U_AT_CLIENT_STREAM_TYPE_CMUX:
+                sizeBytes = uCmuxChannelGetReceiveSize(pClient->streamHandle);
+                if ((sizeBytes > 0) ||
+                    (pClient->pReceiveBuffer->readIndex < pClient->pReceiveBuffer->length)) {
+                    // Like uPortUartEventTrySend(), this does not block
+                    uCmuxChannelEventSend(pClient->streamHandle,
+                                          U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED);
+                }
+                break;
             default:
                 break;
         }
@@ -2890,24 +3888,12 @@ void uAtClientCommandStart(uAtClientHandle_t atHandle,
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
+    // Ended in uAtClientResponseStop()
+    U_PORT_SPAN_BEGIN(pCommand);
+
     if (pClient->error == U_ERROR_COMMON_SUCCESS) {
-        // Wait for delay period if required, constructed this way
-        // to be safe if uPortGetTickTimeMs() wraps
-        if (pClient->delayMs > 0) {
-            // TP changed, as it was not wrap-safe, at least not with int64_t time (failed after ~24 days)
-            // while (uPortGetTickTimeMs() - pClient->lastResponseStopMs < pClient->delayMs) {
-            //     uPortTaskBlock(10);
-            // }
-            do {
-                int32_t diff = uPortGetTickTimeMs() - pClient->lastResponseStopMs;
-                diff &= 0x7FFFFFF;  // clear sign bit
-                if( diff < pClient->delayMs) {
-                    uPortTaskBlock(10);
-                } else {
-                    break;
-                }
-            } while(1);
-        }
+        U_TRACE(AT_COMMAND_START, pClient->streamHandle);
+        commandDelay(pClient);
 
         // Send the command, no delimiter at first
         pClient->delimiterRequired = false;
@@ -2916,6 +3902,7 @@ void uAtClientCommandStart(uAtClientHandle_t atHandle,
         if (pCommand != NULL) {
             write(pClient, pCommand, strlen(pCommand), false);
         }
+        pClient->pLatencyCommand = pCommand;
     }
 
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
@@ -3031,6 +4018,84 @@ void uAtClientWritePartialString(uAtClientHandle_t atHandle,
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
 }
 
+// Send a prepared AT command.
+void uAtClientCommandPrepared(uAtClientHandle_t atHandle,
+                              const uAtClientPreparedCommand_t *pPrepared,
+                              ...)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    char buffer[U_AT_CLIENT_PREPARED_COMMAND_BUFFER_LENGTH_BYTES];
+    char numberString[24];
+    size_t length = 0;
+    int32_t x;
+    const char *pFormat = pPrepared->pFormat;
+    const char *pStr;
+    va_list args;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    // Ended in uAtClientResponseStop()
+    U_PORT_SPAN_BEGIN(pPrepared->pCommand);
+
+    if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+        U_TRACE(AT_COMMAND_START, pClient->streamHandle);
+        commandDelay(pClient);
+        preparedAppend(pClient, buffer, &length,
+                       pPrepared->pCommand, pPrepared->commandLength);
+        va_start(args, pPrepared);
+        for (size_t y = 0; (pFormat != NULL) && (pFormat[y] != 0) &&
+             (pClient->error == U_ERROR_COMMON_SUCCESS); y++) {
+            if (y > 0) {
+                preparedAppend(pClient, buffer, &length, &(pClient->delimiter), 1);
+            }
+            switch (pFormat[y]) {
+                case 'd':
+                    x = snprintf(numberString, sizeof(numberString),
+                                 "%d", (int) va_arg(args, int32_t));
+                    if ((x > 0) && (x < (int32_t) sizeof(numberString))) {
+                        preparedAppend(pClient, buffer, &length, numberString, x);
+                    }
+                    break;
+                case 'u':
+                    x = uint64ToString(numberString, sizeof(numberString),
+                                       va_arg(args, uint64_t));
+                    if ((x > 0) && (x < (int32_t) sizeof(numberString))) {
+                        preparedAppend(pClient, buffer, &length, numberString, x);
+                    }
+                    break;
+                case 's':
+                    pStr = va_arg(args, const char *);
+                    preparedAppend(pClient, buffer, &length, "\"", 1);
+                    preparedAppend(pClient, buffer, &length, pStr, strlen(pStr));
+                    preparedAppend(pClient, buffer, &length, "\"", 1);
+                    break;
+                case 'S':
+                    pStr = va_arg(args, const char *);
+                    preparedAppend(pClient, buffer, &length, pStr, strlen(pStr));
+                    break;
+                default:
+                    setError(pClient, U_ERROR_COMMON_INVALID_PARAMETER);
+                    break;
+            }
+        }
+        va_end(args);
+        preparedAppend(pClient, buffer, &length, U_AT_CLIENT_COMMAND_DELIMITER,
+                       U_AT_CLIENT_COMMAND_DELIMITER_LENGTH_BYTES);
+        if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+            // The whole lot, with a flush
+            write(pClient, buffer, length, true);
+        }
+        // As if the parameters had been written individually
+        pClient->delimiterRequired = (pFormat != NULL) && (*pFormat != 0);
+        pClient->pLatencyCommand = pPrepared->pCommand;
+        if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+            latencyCommandSent(pClient, pClient->pLatencyCommand);
+        }
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+}
+
 // Stop the outgoing part of an AT command sequence.
 void uAtClientCommandStop(uAtClientHandle_t atHandle)
 {
@@ -3044,6 +4109,7 @@ void uAtClientCommandStop(uAtClientHandle_t atHandle)
         write(pClient, U_AT_CLIENT_COMMAND_DELIMITER,
               U_AT_CLIENT_COMMAND_DELIMITER_LENGTH_BYTES,
               true);
+        latencyCommandSent(pClient, pClient->pLatencyCommand);
     }
 
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
@@ -3070,6 +4136,7 @@ int32_t uAtClientResponseStart(uAtClientHandle_t atHandle,
     // handler which will also need the lock.
 
     if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+        U_TRACE(AT_RESPONSE_START, pClient->streamHandle);
         // Stop any previous information response
         if (pClient->scope == U_AT_CLIENT_SCOPE_INFORMATION) {
             informationResponseStop(pClient);
@@ -3139,6 +4206,25 @@ int32_t uAtClientReadUint64(uAtClientHandle_t atHandle,
     return returnValue;
 }
 
+// Read a list of integer parameters.
+int32_t uAtClientReadIntList(uAtClientHandle_t atHandle,
+                             int32_t *pValues, size_t numValues,
+                             uint32_t skipMask)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t numOrError = -1;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    if (pValues != NULL) {
+        numOrError = readIntList(pClient, pValues, numValues, skipMask);
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return numOrError;
+}
+
 // Read a string parameter.
 int32_t uAtClientReadString(uAtClientHandle_t atHandle,
                             char *pString,
@@ -3171,6 +4257,16 @@ int32_t uAtClientReadBytes(uAtClientHandle_t atHandle,
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
+#if U_AT_CLIENT_READ_BYTES_DIRECT
+    if ((pBuffer != NULL) && (pStopTag->pTagDef->length == 0) &&
+        (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+        // No stop tag to look for so the payload can be read
+        // in one go; anything not read here, e.g. because the
+        // first byte has not yet arrived, is read below
+        lengthRead = (int32_t) readBytesDirect(pClient, pBuffer, lengthBytes);
+    }
+#endif
+
     while ((lengthRead < ((int32_t) lengthBytes + matchPos)) &&
            (pClient->error == U_ERROR_COMMON_SUCCESS) &&
            !pStopTag->found) {
@@ -3269,6 +4365,9 @@ void uAtClientResponseStop(uAtClientHandle_t atHandle)
     }
 
     pClient->lastResponseStopMs = uPortGetTickTimeMs();
+    latencyResponseStop(pClient);
+    U_TRACE(AT_RESPONSE_STOP, pClient->error);
+    U_PORT_SPAN_END();
 
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
 }
@@ -3437,7 +4536,7 @@ int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
                 } else {
                     // Remove the processed stuff from the buffer
                     bufferRewind(pClient);
-                    if (pReceiveBuffer->length == 0) {
+                    if (pReceiveBuffer->readIndex >= pReceiveBuffer->length) {
                         // If there's nothing left, try to get more stuff
                         if (!bufferFill(pClient, true)) {
                             // If we don't get any data within
@@ -3463,6 +4562,218 @@ int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
     return (int32_t) errorCode;
 }
 
+// Send a batch of AT commands.
+int32_t uAtClientBatch(uAtClientHandle_t atHandle,
+                       const uAtClientBatchCommand_t *pCommands,
+                       size_t numCommands, bool concatenate)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uAtClientBatchCommand_t *pCommand;
+    size_t lineStart = 0;
+    size_t lineEnd;
+    size_t lineLength;
+    size_t length;
+    size_t numCompleted = 0;
+    bool success = true;
+    bool responseStarted;
+
+    if ((atHandle != NULL) && ((pCommands != NULL) || (numCommands == 0))) {
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; (x < numCommands) && (errorCodeOrCount == 0); x++) {
+            if ((pCommands + x)->pCommand == NULL) {
+                errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            }
+        }
+    }
+
+    if ((errorCodeOrCount == 0) && (numCommands > 0)) {
+        uAtClientLock(atHandle);
+        while (success && (lineStart < numCommands)) {
+            // Work out how many commands can go on this line
+            pCommand = pCommands + lineStart;
+            lineEnd = lineStart + 1;
+            lineLength = strlen(pCommand->pCommand);
+            if (concatenate && isExtendedCommand(pCommand->pCommand)) {
+                while ((lineEnd < numCommands) &&
+                       isExtendedCommand((pCommands + lineEnd)->pCommand)) {
+                    // Plus one for the ';', minus two for the "AT"
+                    length = strlen((pCommands + lineEnd)->pCommand) - 1;
+                    if (lineLength + length > U_AT_CLIENT_BATCH_LINE_LENGTH_MAX_BYTES) {
+                        break;
+                    }
+                    lineLength += length;
+                    lineEnd++;
+                }
+            }
+            // Write the line
+            uAtClientCommandStart(atHandle, pCommand->pCommand);
+            for (size_t x = lineStart + 1; x < lineEnd; x++) {
+                uAtClientWritePartialString(atHandle, false, ";");
+                // Skip the "AT"
+                uAtClientWritePartialString(atHandle, false,
+                                            (pCommands + x)->pCommand + 2);
+            }
+            uAtClientCommandStop(atHandle);
+            // Hand the responses to their parsers, in order
+            responseStarted = false;
+            for (size_t x = lineStart; success && (x < lineEnd); x++) {
+                pCommand = pCommands + x;
+                if (pCommand->pParser != NULL) {
+                    responseStarted = true;
+                    success = (uAtClientResponseStart(atHandle,
+                                                      pCommand->pResponsePrefix) == 0) &&
+                              (pCommand->pParser(atHandle, x, pCommand->pParserParam) == 0);
+                }
+            }
+            if (!responseStarted) {
+                // Nothing to parse, just wait for the response to end
+                uAtClientResponseStart(atHandle, NULL);
+            }
+            uAtClientResponseStop(atHandle);
+            if (success && (uAtClientErrorGet(atHandle) == 0)) {
+                numCompleted += lineEnd - lineStart;
+            } else {
+                success = false;
+            }
+            lineStart = lineEnd;
+        }
+        uAtClientUnlock(atHandle);
+        errorCodeOrCount = (int32_t) numCompleted;
+    }
+
+    return errorCodeOrCount;
+}
+
+// Send a batch of AT commands asynchronously.
+int32_t uAtClientBatchAsync(uAtClientHandle_t atHandle,
+                            const uAtClientBatchCommand_t *pCommands,
+                            size_t numCommands, bool concatenate,
+                            void (*pCallback) (uAtClientHandle_t,
+                                               int32_t, void *),
+                            void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientBatchAsync_t *pJob;
+
+    if ((atHandle != NULL) && (pCommands != NULL) && (numCommands > 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        // Take a copy of the commands so that the caller
+        // need not keep them
+        pJob = (uAtClientBatchAsync_t *) malloc(sizeof(*pJob) +
+                                                (sizeof(*pCommands) * numCommands));
+        if (pJob != NULL) {
+            pJob->numCommands = numCommands;
+            pJob->concatenate = concatenate;
+            pJob->pCallback = pCallback;
+            pJob->pCallbackParam = pCallbackParam;
+            memcpy(pJob + 1, pCommands, sizeof(*pCommands) * numCommands);
+            errorCode = callbackSend((uAtClientInstance_t *) atHandle,
+                                     batchAsyncCallback, pJob, true, false);
+            if (errorCode < 0) {
+                free(pJob);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Send a batch of AT commands asynchronously, holding it back
+// until the module is next woken up if that's not too long.
+int32_t uAtClientBatchDeferrable(uAtClientHandle_t atHandle,
+                                 const uAtClientBatchCommand_t *pCommands,
+                                 size_t numCommands, bool concatenate,
+                                 int32_t maxDelayMs,
+                                 void (*pCallback) (uAtClientHandle_t,
+                                                    int32_t, void *),
+                                 void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uAtClientBatchAsync_t *pJob;
+    uAtClientBatchAsync_t **ppEnd;
+    bool deferred = false;
+
+    if ((pClient != NULL) && (pCommands != NULL) && (numCommands > 0) &&
+        (maxDelayMs >= 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pJob = (uAtClientBatchAsync_t *) malloc(sizeof(*pJob) +
+                                                (sizeof(*pCommands) * numCommands));
+        if (pJob != NULL) {
+            pJob->numCommands = numCommands;
+            pJob->concatenate = concatenate;
+            pJob->pCallback = pCallback;
+            pJob->pCallbackParam = pCallbackParam;
+            pJob->deadlineMs = uPortGetTickTimeMs() + maxDelayMs;
+            pJob->pNext = NULL;
+            memcpy(pJob + 1, pCommands, sizeof(*pCommands) * numCommands);
+
+            U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+            if ((maxDelayMs > 0) && wakeUpRequired(pClient)) {
+                // Sending this now would wake the module up:
+                // hold it back if we can
+                if (pClient->deferMutex == NULL) {
+                    if (uPortMutexCreate(&(pClient->deferMutex)) != 0) {
+                        pClient->deferMutex = NULL;
+                    }
+                }
+                if (pClient->deferMutex != NULL) {
+                    U_PORT_MUTEX_LOCK(pClient->deferMutex);
+                    if ((pClient->deferTimer == NULL) &&
+                        (uPortTimerCreate(&(pClient->deferTimer), "atDefer",
+                                          deferTimerCallback, pClient,
+                                          (uint32_t) maxDelayMs, false) != 0)) {
+                        // Timers may not be implemented on this platform
+                        pClient->deferTimer = NULL;
+                    }
+                    if (pClient->deferTimer != NULL) {
+                        if ((pClient->pDeferred == NULL) ||
+                            (pJob->deadlineMs - pClient->deferDeadlineMs < 0)) {
+                            // This is now the earliest deadline
+                            deferred = (uPortTimerStop(pClient->deferTimer) == 0) &&
+                                       (uPortTimerChange(pClient->deferTimer,
+                                                         (uint32_t) maxDelayMs) == 0) &&
+                                       (uPortTimerStart(pClient->deferTimer) == 0);
+                            if (deferred) {
+                                pClient->deferDeadlineMs = pJob->deadlineMs;
+                            }
+                        } else {
+                            deferred = true;
+                        }
+                        if (deferred) {
+                            // Add to the end of the list to keep the order
+                            ppEnd = &(pClient->pDeferred);
+                            while (*ppEnd != NULL) {
+                                ppEnd = &((*ppEnd)->pNext);
+                            }
+                            *ppEnd = pJob;
+                            pClient->wakeUpStats.numDeferred++;
+                            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        }
+                    }
+                    U_PORT_MUTEX_UNLOCK(pClient->deferMutex);
+                }
+            }
+
+            U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+            if (!deferred) {
+                // No need, or no means, to hold it back: anything
+                // already deferred must go first to keep the order
+                deferredRelease(pClient, false);
+                errorCode = callbackSend(pClient, batchAsyncCallback,
+                                         pJob, true, false);
+                if (errorCode < 0) {
+                    free(pJob);
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: HANDLE UNSOLICITED RESPONSES
  * -------------------------------------------------------------- */
@@ -3483,7 +4794,7 @@ int32_t uAtClientSetUrcHandler(uAtClientHandle_t atHandle,
 
     if ((pPrefix != NULL) && (pHandler != NULL)) {
         errorCode = U_ERROR_COMMON_NO_MEMORY;
-        if (!findUrcHandler(pClient, pPrefix)) {
+        if (pUrcIndexFind(pClient, pPrefix) == NULL) {
             pUrc = (uAtClientUrc_t *) malloc(sizeof(uAtClientUrc_t));
             if (pUrc != NULL) {
                 prefixLength = strlen(pPrefix);
@@ -3521,6 +4832,7 @@ int32_t uAtClientSetUrcHandler(uAtClientHandle_t atHandle,
 
         pUrc->pNext = pClient->pUrcList;
         pClient->pUrcList = pUrc;
+        urcIndexAdd(pClient, pUrc);
 
         U_PORT_MUTEX_UNLOCK(pClient->urcPermittedMutex);
     }
@@ -3552,6 +4864,7 @@ void uAtClientRemoveUrcHandler(uAtClientHandle_t atHandle,
             } else {
                 pClient->pUrcList = pCurrent->pNext;
             }
+            urcIndexRemove(pClient, pCurrent);
 
             U_PORT_MUTEX_UNLOCK(pClient->urcPermittedMutex);
 
@@ -3577,6 +4890,9 @@ int32_t uAtClientUrcHandlerStackMinFree(uAtClientHandle_t atHandle)
         case U_AT_CLIENT_STREAM_TYPE_EDM:
             stackMinFree = uShortRangeEdmStreamAtEventStackMinFree(pClient->streamHandle);
             break;
+        case U_AT_CLIENT_STREAM_TYPE_CMUX:
+            stackMinFree = uCmuxChannelEventStackMinFree(pClient->streamHandle);
+            break;
         default:
             break;
     }
@@ -3584,6 +4900,23 @@ int32_t uAtClientUrcHandlerStackMinFree(uAtClientHandle_t atHandle)
     return stackMinFree;
 }
 
+// Get the URC matching statistics.
+int32_t uAtClientUrcStatsGet(uAtClientHandle_t atHandle,
+                             uAtClientUrcStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+
+    // Note: no locking here so that this may be called
+    // from within a URC handler
+    if ((pClient != NULL) && (pStats != NULL)) {
+        *pStats = pClient->urcStats;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
 // Make a callback resulting from a URC.
 //lint -esym(593, pCallbackParam) Suppress pCallbackParam not being
 // free()ed here: if Lint spots that pCallbackParam was malloc()ed
@@ -3593,19 +4926,74 @@ int32_t uAtClientCallback(uAtClientHandle_t atHandle,
                           void *pCallbackParam)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-    uAtClientCallback_t cb;
 
-    U_PORT_MUTEX_LOCK(gMutexEventQueue);
+    if ((atHandle != NULL) && (pCallback != NULL)) {
+        errorCode = callbackSend((uAtClientInstance_t *) atHandle,
+                                 pCallback, pCallbackParam, false, false);
+    }
+
+    return errorCode;
+}
+
+// Make a data callback resulting from a URC.
+int32_t uAtClientCallbackData(uAtClientHandle_t atHandle,
+                              void (*pCallback) (uAtClientHandle_t, void *),
+                              void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
 
-    if (pCallback != NULL) {
-        cb.pFunction = pCallback;
-        cb.atHandle = atHandle;
-        cb.pParam = pCallbackParam;
-        cb.atClientMagicNumber = ((uAtClientInstance_t *) atHandle)->magicNumber;
-        errorCode = uPortEventQueueSend(gEventQueueHandle, &cb, sizeof(cb));
+    if ((atHandle != NULL) && (pCallback != NULL)) {
+        errorCode = callbackSend((uAtClientInstance_t *) atHandle,
+                                 pCallback, pCallbackParam, false, true);
     }
 
-    U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
+    return errorCode;
+}
+
+// Set the length of the callback queue of an AT client.
+int32_t uAtClientCallbackQueueLengthSet(uAtClientHandle_t atHandle,
+                                        size_t length)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+
+    if ((pClient != NULL) && (length > 0)) {
+
+        U_PORT_MUTEX_LOCK(gMutexEventQueue);
+
+        errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+        if (pClient->callbackQueueDepth == 0) {
+            // Nothing waiting, the queue will be
+            // malloc()ed at the new length when next needed
+            callbackQueueFree(pClient);
+            pClient->callbackQueueLength = length;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
+    }
+
+    return errorCode;
+}
+
+// Get the statistics on the callback queue of an AT client.
+int32_t uAtClientCallbackStatsGet(uAtClientHandle_t atHandle,
+                                  uAtClientCallbackStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+
+    if ((pClient != NULL) && (pStats != NULL)) {
+
+        U_PORT_MUTEX_LOCK(gMutexEventQueue);
+
+        *pStats = pClient->callbackStats;
+        pStats->depth = (uint32_t) pClient->callbackQueueDepth;
+
+        U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
+
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
 
     return errorCode;
 }
@@ -3772,6 +5160,75 @@ int32_t uAtClientStreamGet(uAtClientHandle_t atHandle,
     return pClient->streamHandle;
 }
 
+// Switch the AT client to a different stream.
+int32_t uAtClientStreamSwitch(uAtClientHandle_t atHandle,
+                              int32_t streamHandle,
+                              uAtClientStream_t streamType)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    if (streamType < U_AT_CLIENT_STREAM_TYPE_MAX) {
+        // Remove the event handler from the existing stream;
+        // the URC callback only ever try-locks the stream mutex,
+        // which our caller has locked, so it can't get in the way
+        if (pClient->streamHandle >= 0) {
+            switch (pClient->streamType) {
+                case U_AT_CLIENT_STREAM_TYPE_UART:
+                    uPortUartEventCallbackRemove(pClient->streamHandle);
+                    break;
+                case U_AT_CLIENT_STREAM_TYPE_EDM:
+                    uShortRangeEdmStreamAtCallbackRemove(pClient->streamHandle);
+                    break;
+                case U_AT_CLIENT_STREAM_TYPE_CMUX:
+                    uCmuxChannelEventCallbackRemove(pClient->streamHandle);
+                    break;
+                default:
+                    break;
+            }
+        }
+        // Anything left in the buffer belongs to the old stream
+        bufferReset(pClient, true);
+        pClient->streamHandle = streamHandle;
+        pClient->streamType = streamType;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (streamHandle >= 0) {
+            switch (streamType) {
+                case U_AT_CLIENT_STREAM_TYPE_UART:
+                    errorCode = uPortUartEventCallbackSet(streamHandle,
+                                                          U_AT_CLIENT_UART_EVENT_BITMASK,
+                                                          urcCallback, pClient,
+                                                          U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES,
+                                                          U_AT_CLIENT_URC_TASK_PRIORITY);
+                    break;
+                case U_AT_CLIENT_STREAM_TYPE_EDM:
+                    errorCode = uShortRangeEdmStreamAtCallbackSet(streamHandle, urcCallback, pClient);
+                    break;
+                case U_AT_CLIENT_STREAM_TYPE_CMUX:
+                    errorCode = uCmuxChannelEventCallbackSet(streamHandle,
+                                                             U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                             urcCallback, pClient,
+                                                             U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES,
+                                                             U_AT_CLIENT_URC_TASK_PRIORITY);
+                    break;
+                default:
+                    break;
+            }
+            if (errorCode != 0) {
+                // Leave the AT client detached rather than
+                // pointing at a stream it can't hear
+                pClient->streamHandle = -1;
+            }
+        }
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return errorCode;
+}
+
 // Add a transmit intercept function.
 void uAtClientStreamInterceptTx(uAtClientHandle_t atHandle,
                                 const char *(*pCallback) (uAtClientHandle_t,
@@ -3837,6 +5294,9 @@ int32_t uAtClientSetWakeUpHandler(uAtClientHandle_t atHandle,
             if (pClient->pWakeUp != NULL) {
                 // Mustn't be in the wake-up handler
                 U_ASSERT(uPortMutexTryLock(pClient->pWakeUp->inWakeUpHandlerMutex, 0) == 0);
+                // Nothing is going to wake the module up for
+                // anything deferred any more, so let it go now
+                deferredRelease(pClient, false);
                 // Delete all the mutexes
                 uPortMutexUnlock(pClient->pWakeUp->inWakeUpHandlerMutex);
                 uPortMutexDelete(pClient->pWakeUp->inWakeUpHandlerMutex);
@@ -3890,6 +5350,15 @@ int32_t uAtClientSetWakeUpHandler(uAtClientHandle_t atHandle,
                 pClient->pWakeUp->inactivityTimeoutMs = inactivityTimeoutMs;
                 pClient->pWakeUp->atTimeoutSavedMs = -1;
                 pClient->pWakeUp->wakeUpTask = NULL;
+                // Start the statistics afresh
+                if (pClient->deferMutex != NULL) {
+                    U_PORT_MUTEX_LOCK(pClient->deferMutex);
+                }
+                memset(&(pClient->wakeUpStats), 0, sizeof(pClient->wakeUpStats));
+                pClient->wakeUpStatsStartTimeMs = uPortGetTickTimeMs();
+                if (pClient->deferMutex != NULL) {
+                    U_PORT_MUTEX_UNLOCK(pClient->deferMutex);
+                }
             }
         }
     }
@@ -3907,6 +5376,40 @@ bool uAtClientWakeUpHandlerIsSet(const uAtClientHandle_t atHandle)
     return ((const uAtClientInstance_t *) atHandle)->pWakeUp != NULL;
 }
 
+// Get the statistics on the wake-up handler.
+int32_t uAtClientWakeUpStatsGet(uAtClientHandle_t atHandle,
+                                uAtClientWakeUpStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t elapsedMs;
+
+    if ((pClient != NULL) && (pStats != NULL)) {
+
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        if (pClient->deferMutex != NULL) {
+            U_PORT_MUTEX_LOCK(pClient->deferMutex);
+        }
+        *pStats = pClient->wakeUpStats;
+        if (pClient->deferMutex != NULL) {
+            U_PORT_MUTEX_UNLOCK(pClient->deferMutex);
+        }
+        pStats->numWakeUpsPerHour = 0;
+        elapsedMs = uPortGetTickTimeMs() - pClient->wakeUpStatsStartTimeMs;
+        if (elapsedMs > 0) {
+            pStats->numWakeUpsPerHour = (uint32_t) (((int64_t) pStats->numWakeUps * 3600000) /
+                                                    elapsedMs);
+        }
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
 // Set an "activity" pin.
 int32_t uAtClientSetActivityPin(uAtClientHandle_t atHandle,
                                 int32_t pin, int32_t readyMs,
@@ -3940,6 +5443,76 @@ int32_t uAtClientSetActivityPin(uAtClientHandle_t atHandle,
     return errorCode;
 }
 
+// Start collecting latency statistics.
+int32_t uAtClientLatencyStart(uAtClientHandle_t atHandle,
+                              size_t maxNumEntries)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uPortMutexHandle_t streamMutex;
+    uAtClientLatency_t *pLatency;
+
+    if ((pClient != NULL) && (maxNumEntries > 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pLatency = (uAtClientLatency_t *) malloc(sizeof(*pLatency) +
+                                                 (sizeof(uAtClientLatencyEntry_t) *
+                                                  maxNumEntries));
+        if (pLatency != NULL) {
+            memset(pLatency, 0, sizeof(*pLatency));
+            pLatency->maxNumEntries = maxNumEntries;
+            pLatency->pendingEntry = -1;
+            // Lock the stream so as not to change things while
+            // a command or URC is being processed
+            streamMutex = streamLock(pClient);
+            free(pClient->pLatency);
+            pClient->pLatency = pLatency;
+            uPortMutexUnlock(streamMutex);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Stop collecting latency statistics.
+void uAtClientLatencyStop(uAtClientHandle_t atHandle)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uPortMutexHandle_t streamMutex;
+
+    if (pClient != NULL) {
+        streamMutex = streamLock(pClient);
+        free(pClient->pLatency);
+        pClient->pLatency = NULL;
+        uPortMutexUnlock(streamMutex);
+    }
+}
+
+// Get an entry from the latency statistics.
+int32_t uAtClientLatencyGet(uAtClientHandle_t atHandle, size_t index,
+                            uAtClientLatencyEntry_t *pEntry)
+{
+    int32_t errorCodeOrNumEntries = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uPortMutexHandle_t streamMutex;
+    uAtClientLatency_t *pLatency;
+
+    if (pClient != NULL) {
+        streamMutex = streamLock(pClient);
+        pLatency = pClient->pLatency;
+        errorCodeOrNumEntries = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        if ((pLatency != NULL) && (index < pLatency->numEntries)) {
+            if (pEntry != NULL) {
+                *pEntry = *(((uAtClientLatencyEntry_t *) (pLatency + 1)) + index);
+            }
+            errorCodeOrNumEntries = (int32_t) pLatency->numEntries;
+        }
+        uPortMutexUnlock(streamMutex);
+    }
+
+    return errorCodeOrNumEntries;
+}
+
 // Return the activity pin.
 //lint -esym(818, atHandle) Suppress could be declared
 // as pointing to const. it is!
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_AT_CLIENT_PRIVATE_H_
+#define _U_AT_CLIENT_PRIVATE_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** @file
+ * @brief This header file defines functions that are private to
+ * the AT client; they are exposed here only so that they can be
+ * tested and benchmarked in isolation.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Find one character buffer inside another, e.g. a stop tag in
+ * the receive buffer.  This uses memchr() to skip to each
+ * occurrence of the first character of pFind before comparing
+ * the rest, which the C library will usually do a word at a
+ * time, rather than comparing at every position in pBuffer.
+ *
+ * @param[in] pBuffer   the buffer to search; cannot be NULL.
+ * @param bufferLength  the amount of data at pBuffer.
+ * @param[in] pFind     the characters to find; cannot be NULL.
+ * @param findLength    the number of characters at pFind; the
+ *                      caller should keep this pre-computed rather
+ *                      than calling strlen() each time.
+ * @return              a pointer to the first occurrence of pFind
+ *                      in pBuffer, NULL if there is none; if
+ *                      findLength is zero pBuffer is returned.
+ */
+//lint -esym(759, pUAtClientPrivateMemStr) Suppress could be moved
+//lint -esym(765, pUAtClientPrivateMemStr) from header and could be static
+const char *pUAtClientPrivateMemStr(const char *pBuffer,
+                                    size_t bufferLength,
+                                    const char *pFind,
+                                    size_t findLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_AT_CLIENT_PRIVATE_H_
+
+// End of file
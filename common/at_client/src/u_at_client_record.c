@@ -0,0 +1,289 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of recording of AT client traffic into
+ * a session that can be played back later.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy()
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+
+#include "u_at_client.h"
+#include "u_at_client_record.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Write a 16-bit value into a buffer, little endian.
+static void writeUint16(char *pBuffer, uint16_t value)
+{
+    *pBuffer = (char) (value & 0xFF);
+    *(pBuffer + 1) = (char) (value >> 8);
+}
+
+// Read a 16-bit value from a buffer, little endian.
+static uint16_t readUint16(const char *pBuffer)
+{
+    return (uint16_t) (((uint16_t) (uint8_t) *(pBuffer + 1)) << 8) |
+           (uint16_t) (uint8_t) *pBuffer;
+}
+
+// Write a 32-bit value into a buffer, little endian.
+static void writeUint32(char *pBuffer, uint32_t value)
+{
+    for (size_t x = 0; x < 4; x++) {
+        *(pBuffer + x) = (char) (value & 0xFF);
+        value >>= 8;
+    }
+}
+
+// Read a 32-bit value from a buffer, little endian.
+static uint32_t readUint32(const char *pBuffer)
+{
+    uint32_t value = 0;
+
+    for (size_t x = 4; x > 0; x--) {
+        value = (value << 8) | (uint8_t) *(pBuffer + x - 1);
+    }
+
+    return value;
+}
+
+// Add data to the recording, counting anything that doesn't fit.
+// Called with the AT client locked.
+static void record(uAtClientRecord_t *pRecord, bool isTx,
+                   const char *pData, size_t length)
+{
+    if (uAtClientRecordAdd(pRecord, isTx,
+                           uPortGetTickTimeMs() - pRecord->startTimeMs,
+                           pData, length) < 0) {
+        pRecord->bytesDropped += length;
+    }
+}
+
+// The transmit intercept: record the data and pass it on unchanged.
+static const char *pInterceptTx(uAtClientHandle_t atHandle,
+                                const char **ppData, size_t *pLength,
+                                void *pContext)
+{
+    const char *pData = NULL;
+
+    (void) atHandle;
+
+    if (ppData != NULL) {
+        pData = *ppData;
+        if (*pLength > 0) {
+            record((uAtClientRecord_t *) pContext, true, pData, *pLength);
+        }
+        *ppData += *pLength;
+    } else {
+        // Flush: we don't hold onto anything
+        *pLength = 0;
+    }
+
+    return pData;
+}
+
+// The receive intercept: record the data and pass it on unchanged.
+static char *pInterceptRx(uAtClientHandle_t atHandle,
+                          char **ppData, size_t *pLength,
+                          void *pContext)
+{
+    char *pData = NULL;
+
+    (void) atHandle;
+
+    if ((ppData != NULL) && (*pLength > 0)) {
+        pData = *ppData;
+        record((uAtClientRecord_t *) pContext, false, pData, *pLength);
+        *ppData += *pLength;
+    } else {
+        // Nothing (more) to give
+        *pLength = 0;
+    }
+
+    return pData;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start recording.
+int32_t uAtClientRecordStart(uAtClientHandle_t atHandle,
+                             uAtClientRecord_t *pRecord,
+                             char *pBuffer, size_t bufferSize)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pRecord != NULL) && (pBuffer != NULL)) {
+        memset(pRecord, 0, sizeof(*pRecord));
+        pRecord->pBuffer = pBuffer;
+        pRecord->bufferSize = bufferSize;
+        pRecord->startTimeMs = uPortGetTickTimeMs();
+        if (atHandle != NULL) {
+            uAtClientLock(atHandle);
+            uAtClientStreamInterceptTx(atHandle, pInterceptTx,
+                                       (void *) pRecord);
+            uAtClientStreamInterceptRx(atHandle, pInterceptRx,
+                                       (void *) pRecord);
+            uAtClientUnlock(atHandle);
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Stop recording.
+int32_t uAtClientRecordStop(uAtClientHandle_t atHandle,
+                            uAtClientRecord_t *pRecord)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pRecord != NULL) {
+        if (atHandle != NULL) {
+            uAtClientLock(atHandle);
+            uAtClientStreamInterceptTx(atHandle, NULL, NULL);
+            uAtClientStreamInterceptRx(atHandle, NULL, NULL);
+            uAtClientUnlock(atHandle);
+        }
+        errorCodeOrLength = (int32_t) pRecord->length;
+    }
+
+    return errorCodeOrLength;
+}
+
+// Add data to a session.
+int32_t uAtClientRecordAdd(uAtClientRecord_t *pRecord, bool isTx,
+                           int32_t timeMs, const char *pData,
+                           size_t length)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    char direction = isTx ? U_AT_CLIENT_RECORD_DIRECTION_TX :
+                     U_AT_CLIENT_RECORD_DIRECTION_RX;
+    char *pHeader = NULL;
+    size_t headerLength = 0;
+    size_t recordLength;
+
+    if ((pRecord != NULL) && (pRecord->pBuffer != NULL) &&
+        (pData != NULL) && (length <= U_AT_CLIENT_RECORD_DATA_MAX_LENGTH_BYTES)) {
+        if (pRecord->length > 0) {
+            pHeader = pRecord->pBuffer + pRecord->lastRecordOffset;
+            recordLength = readUint16(pHeader + 2);
+            if ((*pHeader != direction) ||
+                (timeMs - pRecord->lastTimeMs > U_AT_CLIENT_RECORD_COALESCE_MS) ||
+                (recordLength + length > U_AT_CLIENT_RECORD_DATA_MAX_LENGTH_BYTES)) {
+                // Can't add to the last record, need a new one
+                pHeader = NULL;
+            }
+        }
+        if (pHeader == NULL) {
+            headerLength = U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES;
+        }
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        if (pRecord->length + headerLength + length <= pRecord->bufferSize) {
+            if (pHeader == NULL) {
+                // Start a new record
+                pRecord->lastRecordOffset = pRecord->length;
+                pHeader = pRecord->pBuffer + pRecord->length;
+                *pHeader = direction;
+                *(pHeader + 1) = 0;
+                writeUint16(pHeader + 2, 0);
+                writeUint32(pHeader + 4, (uint32_t) timeMs);
+                pRecord->length += headerLength;
+            }
+            memcpy(pRecord->pBuffer + pRecord->length, pData, length);
+            pRecord->length += length;
+            writeUint16(pHeader + 2, (uint16_t) (readUint16(pHeader + 2) + length));
+            pRecord->lastTimeMs = timeMs;
+            errorCodeOrLength = (int32_t) (headerLength + length);
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// Get a record from a session.
+int32_t uAtClientRecordGet(const char *pSession, size_t length,
+                           bool *pIsTx, int32_t *pTimeMs,
+                           const char **ppData, size_t *pLength)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t dataLength;
+
+    if (pSession != NULL) {
+        errorCodeOrLength = 0;
+        if (length > 0) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            if ((length >= U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES) &&
+                ((*pSession == U_AT_CLIENT_RECORD_DIRECTION_TX) ||
+                 (*pSession == U_AT_CLIENT_RECORD_DIRECTION_RX))) {
+                dataLength = readUint16(pSession + 2);
+                if (U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES + dataLength <= length) {
+                    if (pIsTx != NULL) {
+                        *pIsTx = (*pSession == U_AT_CLIENT_RECORD_DIRECTION_TX);
+                    }
+                    if (pTimeMs != NULL) {
+                        *pTimeMs = (int32_t) readUint32(pSession + 4);
+                    }
+                    if (ppData != NULL) {
+                        *ppData = pSession + U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES;
+                    }
+                    if (pLength != NULL) {
+                        *pLength = dataLength;
+                    }
+                    errorCodeOrLength = (int32_t) (U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES +
+                                                   dataLength);
+                }
+            }
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// End of file
@@ -34,7 +34,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "stdlib.h"    // rand()
+#include "stdlib.h"    // rand(), malloc(), free()
 #include "string.h"    // strlen(), memcmp()
 #include "stdio.h"     // snprintf()
 #include "ctype.h"     // isprint()
@@ -55,9 +55,17 @@
 #include "u_port_uart.h"
 
 #include "u_at_client.h"
+#include "u_at_client_record.h"
+#include "u_at_client_private.h" // pUAtClientPrivateMemStr()
 #include "u_at_client_test.h"
 #include "u_at_client_test_data.h"
 
+#include "u_bench.h"
+
+#if defined(U_CFG_TEST_UART_REPLAY) && (U_CFG_TEST_UART_REPLAY >= 0)
+# include "u_port_uart_replay.h"
+#endif
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -129,6 +137,36 @@
  * we need room for initial and trailing line endings. */
 #define U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES (256 + 4 + U_AT_CLIENT_BUFFER_OVERHEAD_BYTES)
 
+/** The number of payload bytes in each response sent in the
+ * throughput test.
+ */
+#define U_AT_CLIENT_TEST_THROUGHPUT_PAYLOAD_LENGTH_BYTES 200
+
+/** The number of responses sent in the throughput test.
+ */
+#define U_AT_CLIENT_TEST_THROUGHPUT_NUM_RESPONSES 20
+
+/** The size of buffer to build the replay session in: big enough
+ * for all of gAtClientTestSet2 with its URCs interleaved.
+ */
+#define U_AT_CLIENT_TEST_REPLAY_SESSION_LENGTH_BYTES (1024 * 16)
+
+/** The nominal gap between a command and its response, and
+ * between one command/response and the next, in the replay
+ * session.
+ */
+#define U_AT_CLIENT_TEST_REPLAY_GAP_MS 20
+
+/** The size of the buffer searched in the atClientMemStr test.
+ */
+#define U_AT_CLIENT_TEST_MEM_STR_BUFFER_LENGTH_BYTES 1024
+
+/** The number of times the buffer is searched in the
+ * atClientMemStr test: enough for the duration to be measurable
+ * with a millisecond tick.
+ */
+#define U_AT_CLIENT_TEST_MEM_STR_ITERATIONS 1000
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -145,6 +183,19 @@ typedef struct {
     int32_t responseLastError;
 } uAtClientTestCheckCommandResponse_t;
 
+/** The state of the AT server used by the batch tests, see
+ * atBatchServerCallback().
+ */
+typedef struct {
+    char line[256];           /**< the command line being received. */
+    size_t length;            /**< the number of bytes in line. */
+    size_t numLines;          /**< the number of command lines received. */
+    size_t maxLineLength;     /**< the longest command line received,
+                                   excluding the command delimiter. */
+    int32_t numInformation;   /**< the number of information responses
+                                   sent, also the value sent in each. */
+} uAtClientTestBatchServer_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -167,6 +218,22 @@ static int32_t gConsecutiveTimeout;
  */
 static size_t gSystemHeapLost = 0;
 
+/** The order in which callbacks are run in the
+ * atClientCallbackQueue test, each one recording the character
+ * it was given as a parameter.
+ */
+static char gCallbackOrder[16];
+
+/** Index into gCallbackOrder.
+ */
+static volatile size_t gCallbackOrderIndex = 0;
+
+/** While this is true the callback given 'H' as its parameter
+ * in the atClientCallbackQueue test will not return, so that
+ * others queue up behind it.
+ */
+static volatile bool gCallbackHold = false;
+
 # if (U_CFG_TEST_UART_B >= 0)
 
 /** AT server buffer used by atServerCallback() and atEchoServerCallback().
@@ -177,6 +244,30 @@ static char gAtServerBuffer[1024];
  */
 static const char *gpInterceptTxDataLast = NULL;
 
+/** Buffer for the responses sent, and then received, in the
+ * throughput test, big enough for the payload with a prefix,
+ * quotes, terminator, OK and null terminator.
+ */
+static char gAtThroughputBuffer[U_AT_CLIENT_TEST_THROUGHPUT_PAYLOAD_LENGTH_BYTES + 32];
+
+/** The results passed to batchAsyncCallback(), in the order the
+ * callbacks were called.
+ */
+static volatile int32_t gBatchAsyncResult[2];
+
+/** The parameters passed to batchAsyncCallback(), in the order the
+ * callbacks were called.
+ */
+static volatile intptr_t gBatchAsyncParam[2];
+
+/** The number of times batchAsyncCallback() has been called.
+ */
+static volatile size_t gBatchAsyncCount = 0;
+
+/** The number of times wakeUpHandler() has been called.
+ */
+static volatile size_t gWakeUpCount = 0;
+
 # endif
 #endif
 
@@ -184,6 +275,184 @@ static const char *gpInterceptTxDataLast = NULL;
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// The original byte-by-byte version of pUAtClientPrivateMemStr(),
+// to check against and to compare timings with.
+static const char *pMemStrNaive(const char *pBuffer, size_t bufferLength,
+                                const char *pFind, size_t findLength)
+{
+    const char *pPos = NULL;
+
+    if (bufferLength >= findLength) {
+        for (size_t x = 0; (pPos == NULL) &&
+             (x < (bufferLength - findLength) + 1); x++) {
+            if (memcmp(pBuffer + x, pFind, findLength) == 0) {
+                pPos = pBuffer + x;
+            }
+        }
+    }
+
+    return pPos;
+}
+
+// Time U_AT_CLIENT_TEST_MEM_STR_ITERATIONS searches of pBuffer
+// for pFind with pFunction, returning the duration in milliseconds.
+static int32_t timeMemStr(const char *(*pFunction) (const char *, size_t,
+                                                    const char *, size_t),
+                          const char *pBuffer, size_t bufferLength,
+                          const char *pFind, size_t findLength)
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    // volatile so that the searches are not optimised out
+    const char *volatile pPos;
+
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_MEM_STR_ITERATIONS; x++) {
+        pPos = pFunction(pBuffer, bufferLength, pFind, findLength);
+    }
+    (void) pPos;
+
+    return uPortGetTickTimeMs() - startTimeMs;
+}
+
+#ifdef U_AT_CLIENT_TEST_DATA_REQUIRED
+
+// The URC handler for these tests.
+static void urcHandler(uAtClientHandle_t atClientHandle, void *pParameters)
+{
+    uAtClientTestCheckUrc_t *pCheckUrc;
+    const uAtClientTestResponseLine_t *pUrc;
+    int32_t lastError = 0;
+
+    // pParameters is the checking structure and in that is a pointer
+    // to the definition of what should be in the URC
+    pCheckUrc = (uAtClientTestCheckUrc_t *) pParameters;
+    pUrc = pCheckUrc->pUrc;
+
+    // Read all of the parameters and check them
+    for (size_t p = 0; (p < pUrc->numParameters) && (lastError == 0); p++) {
+        lastError = uAtClientTestCheckParam(atClientHandle,
+                                            &(pUrc->parameters[p]), "_URC");
+    }
+
+    pCheckUrc->count++;
+    if (pCheckUrc->lastError == 0) {
+        pCheckUrc->lastError = lastError;
+    }
+    if (lastError == 0) {
+        // This URC passes
+        pCheckUrc->passIndex++;
+    }
+}
+
+#endif
+
+#if defined(U_CFG_TEST_UART_REPLAY) && (U_CFG_TEST_UART_REPLAY >= 0)
+
+// Add a URC to a replay session, formatted as atEchoServerCallback()
+// would send it; returns zero on success else negative error code.
+static int32_t replaySessionAddUrc(uAtClientRecord_t *pRecord, int32_t timeMs,
+                                   const uAtClientTestResponseLine_t *pUrc)
+{
+    int32_t errorCode;
+
+    errorCode = uAtClientRecordAdd(pRecord, false, timeMs,
+                                   U_AT_CLIENT_TEST_RESPONSE_TERMINATOR,
+                                   strlen(U_AT_CLIENT_TEST_RESPONSE_TERMINATOR));
+    if (errorCode >= 0) {
+        errorCode = uAtClientRecordAdd(pRecord, false, timeMs, pUrc->pPrefix,
+                                       strlen(pUrc->pPrefix));
+    }
+    for (size_t x = 0; (x < pUrc->numParameters) && (errorCode >= 0); x++) {
+        if (x > 0) {
+            errorCode = uAtClientRecordAdd(pRecord, false, timeMs,
+                                           U_AT_CLIENT_TEST_DELIMITER,
+                                           strlen(U_AT_CLIENT_TEST_DELIMITER));
+        }
+        if (errorCode >= 0) {
+            errorCode = uAtClientRecordAdd(pRecord, false, timeMs,
+                                           pUrc->parametersRaw[x].pBytes,
+                                           pUrc->parametersRaw[x].length);
+        }
+    }
+    if (errorCode >= 0) {
+        errorCode = uAtClientRecordAdd(pRecord, false, timeMs,
+                                       U_AT_CLIENT_TEST_RESPONSE_TERMINATOR,
+                                       strlen(U_AT_CLIENT_TEST_RESPONSE_TERMINATOR));
+    }
+
+    return errorCode < 0 ? errorCode : 0;
+}
+
+// Add a command and its echoed response to a replay session, i.e.
+// what the AT client sends and what atEchoServerCallback() would
+// send back, interleaving pUrc (if not NULL) before each line;
+// returns zero on success else negative error code.
+static int32_t replaySessionAddEcho(uAtClientRecord_t *pRecord, int32_t timeMs,
+                                    const char *pBytes, size_t length,
+                                    const uAtClientTestResponseLine_t *pUrc)
+{
+    int32_t errorCode;
+    const char *pNext;
+    size_t lengthToSend;
+
+    // What the AT client sends: the bytes plus the command delimiter
+    errorCode = uAtClientRecordAdd(pRecord, true, timeMs, pBytes, length);
+    if (errorCode >= 0) {
+        errorCode = uAtClientRecordAdd(pRecord, true, timeMs,
+                                       U_AT_CLIENT_COMMAND_DELIMITER,
+                                       U_AT_CLIENT_COMMAND_DELIMITER_LENGTH_BYTES);
+    }
+    // What comes back: the same bytes line by line, with the URC between
+    timeMs += U_AT_CLIENT_TEST_REPLAY_GAP_MS;
+    while ((length > 0) && (errorCode >= 0)) {
+        lengthToSend = length;
+        pNext = strstr(pBytes, U_AT_CLIENT_CRLF);
+        if ((pNext != NULL) && (pNext < pBytes + length)) {
+            lengthToSend = (pNext - pBytes) + U_AT_CLIENT_CRLF_LENGTH_BYTES;
+        }
+        if (pUrc != NULL) {
+            errorCode = replaySessionAddUrc(pRecord, timeMs, pUrc);
+        }
+        if (errorCode >= 0) {
+            errorCode = uAtClientRecordAdd(pRecord, false, timeMs,
+                                           pBytes, lengthToSend);
+        }
+        pBytes += lengthToSend;
+        length -= lengthToSend;
+    }
+
+    return errorCode < 0 ? errorCode : 0;
+}
+
+// Build a replay session from gAtClientTestSet2, preceded by the
+// "boring thing" that atClientCommandSet2 sends first; returns the
+// length of the session or negative error code.
+static int32_t replaySessionCreate(char *pBuffer, size_t bufferSize)
+{
+    int32_t errorCodeOrLength;
+    uAtClientRecord_t record;
+    int32_t timeMs = 0;
+    const uAtClientTestEcho_t *pEcho;
+
+    errorCodeOrLength = uAtClientRecordStart(NULL, &record, pBuffer, bufferSize);
+    if (errorCodeOrLength == 0) {
+        errorCodeOrLength = replaySessionAddEcho(&record, timeMs,
+                                                 "\r\nOK\r\n", 6, NULL);
+    }
+    for (size_t x = 0; (x < gAtClientTestSetSize2) && (errorCodeOrLength == 0); x++) {
+        timeMs += U_AT_CLIENT_TEST_REPLAY_GAP_MS * 2;
+        pEcho = &(gAtClientTestSet2[x]);
+        errorCodeOrLength = replaySessionAddEcho(&record, timeMs, pEcho->pBytes,
+                                                 pEcho->length, pEcho->pUrc);
+    }
+    if (errorCodeOrLength == 0) {
+        errorCodeOrLength = uAtClientRecordStop(NULL, &record);
+    }
+
+    return errorCodeOrLength;
+}
+
+#endif
+
 #if (U_CFG_TEST_UART_A >= 0)
 
 // AT consecutive timeout callback, used by some of the tests below
@@ -208,6 +477,25 @@ static void consecutiveTimeoutCallback(uAtClientHandle_t atHandle,
     gConsecutiveTimeout = *pCount;
 }
 
+// Callback for the atClientCallbackQueue test: records the
+// character it is given as a parameter in gCallbackOrder.
+static void callbackQueueCallback(uAtClientHandle_t atHandle, void *pParam)
+{
+    char c = (char) (intptr_t) pParam;
+
+    (void) atHandle;
+
+    if (gCallbackOrderIndex < sizeof(gCallbackOrder) - 1) {
+        gCallbackOrder[gCallbackOrderIndex] = c;
+        gCallbackOrderIndex++;
+    }
+    if (c == 'H') {
+        for (size_t x = 0; gCallbackHold && (x < 500); x++) {
+            uPortTaskBlock(10);
+        }
+    }
+}
+
 // Check the stack extents for the URC and callbacks tasks.
 static void checkStackExtents(uAtClientHandle_t atHandle)
 {
@@ -311,34 +599,6 @@ static bool atTimeoutIsObeyed(uAtClientHandle_t atClientHandle,
     return success;
 }
 
-// The URC handler for these tests.
-static void urcHandler(uAtClientHandle_t atClientHandle, void *pParameters)
-{
-    uAtClientTestCheckUrc_t *pCheckUrc;
-    const uAtClientTestResponseLine_t *pUrc;
-    int32_t lastError = 0;
-
-    // pParameters is the checking structure and in that is a pointer
-    // to the definition of what should be in the URC
-    pCheckUrc = (uAtClientTestCheckUrc_t *) pParameters;
-    pUrc = pCheckUrc->pUrc;
-
-    // Read all of the parameters and check them
-    for (size_t p = 0; (p < pUrc->numParameters) && (lastError == 0); p++) {
-        lastError = uAtClientTestCheckParam(atClientHandle,
-                                            &(pUrc->parameters[p]), "_URC");
-    }
-
-    pCheckUrc->count++;
-    if (pCheckUrc->lastError == 0) {
-        pCheckUrc->lastError = lastError;
-    }
-    if (lastError == 0) {
-        // This URC passes
-        pCheckUrc->passIndex++;
-    }
-}
-
 // Write to a buffer returning the number of bytes written
 static size_t writeToBuffer(char *pBuffer, size_t bufferLength,
                             const char *pBytes, size_t length)
@@ -857,6 +1117,125 @@ static char *pInterceptRx(uAtClientHandle_t atHandle,
     return pData;
 }
 
+// Respond to a single command of a command line as the AT server
+// of the batch tests would, writing to uartHandle; returns false
+// if the command is one that fails.
+static bool atBatchServerRespond(int32_t uartHandle, const char *pCommand,
+                                 size_t length,
+                                 uAtClientTestBatchServer_t *pServer)
+{
+    char buffer[64];
+    bool success = true;
+    int32_t x;
+
+    if ((length >= 5) && (memcmp(pCommand, "+FAIL", 5) == 0)) {
+        success = false;
+    } else if ((length > 1) && (*pCommand == '+') &&
+               (*(pCommand + length - 1) == '?')) {
+        // A query: send an information response carrying the
+        // number of information responses sent so far, e.g.
+        // "+THING: 3" for "+THING?"
+        x = snprintf(buffer, sizeof(buffer), "\r\n%.*s: %d\r\n",
+                     (int) (length - 1), pCommand, (int) pServer->numInformation);
+        pServer->numInformation++;
+        uPortUartWrite(uartHandle, buffer, x);
+    }
+
+    return success;
+}
+
+// Callback acting as the AT server for the batch tests: commands
+// on a line may be separated by ';', a query (e.g. "AT+THING?")
+// gets an information response, "+FAIL" gets ERROR, which ends
+// the line, and anything else just OK.
+static void atBatchServerCallback(int32_t uartHandle, uint32_t eventBitmask,
+                                  void *pParameters)
+{
+    uAtClientTestBatchServer_t *pServer = (uAtClientTestBatchServer_t *) pParameters;
+    const char *pCommand;
+    const char *pEnd;
+    char c;
+    bool success;
+
+    if (eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) {
+        while (uPortUartRead(uartHandle, &c, 1) == 1) {
+            if (c != *U_AT_CLIENT_COMMAND_DELIMITER) {
+                if (pServer->length < sizeof(pServer->line)) {
+                    pServer->line[pServer->length] = c;
+                    pServer->length++;
+                }
+            } else {
+                // A complete command line
+                pServer->numLines++;
+                if (pServer->length > pServer->maxLineLength) {
+                    pServer->maxLineLength = pServer->length;
+                }
+                success = true;
+                pCommand = pServer->line;
+                pEnd = pServer->line + pServer->length;
+                if ((pServer->length >= 2) && (memcmp(pCommand, "AT", 2) == 0)) {
+                    pCommand += 2;
+                }
+                while (success && (pCommand < pEnd)) {
+                    const char *pNext = (const char *) memchr(pCommand, ';',
+                                                              pEnd - pCommand);
+                    if (pNext == NULL) {
+                        pNext = pEnd;
+                    }
+                    success = atBatchServerRespond(uartHandle, pCommand,
+                                                   pNext - pCommand, pServer);
+                    pCommand = pNext + 1;
+                }
+                if (success) {
+                    uPortUartWrite(uartHandle, "\r\nOK\r\n", 6);
+                } else {
+                    uPortUartWrite(uartHandle, "\r\nERROR\r\n", 9);
+                }
+                pServer->length = 0;
+            }
+        }
+    }
+}
+
+// Parser for the information response to a query in the batch
+// tests: stores the value that came back at the index of the
+// command in the array of int32_t pointed to by pParam.
+static int32_t batchParser(uAtClientHandle_t atHandle, size_t index,
+                           void *pParam)
+{
+    int32_t *pResults = (int32_t *) pParam;
+
+    *(pResults + index) = uAtClientReadInt(atHandle);
+
+    return uAtClientErrorGet(atHandle);
+}
+
+// Completion callback for uAtClientBatchAsync(), recording what it
+// was given in gBatchAsyncResult and gBatchAsyncParam.
+static void batchAsyncCallback(uAtClientHandle_t atHandle,
+                               int32_t errorCodeOrCount, void *pParam)
+{
+    (void) atHandle;
+
+    if (gBatchAsyncCount < sizeof(gBatchAsyncResult) / sizeof(gBatchAsyncResult[0])) {
+        gBatchAsyncResult[gBatchAsyncCount] = errorCodeOrCount;
+        gBatchAsyncParam[gBatchAsyncCount] = (intptr_t) pParam;
+    }
+    gBatchAsyncCount++;
+}
+
+// Wake-up handler for the deferrable batch test: there is no
+// module to wake up so this just counts.
+static int32_t wakeUpHandler(uAtClientHandle_t atHandle, void *pParam)
+{
+    (void) atHandle;
+    (void) pParam;
+
+    gWakeUpCount++;
+
+    return 0;
+}
+
 # endif
 #endif
 
@@ -1161,6 +1540,119 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientConfiguration")
                        (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
 }
 
+/** Check that callbacks with uAtClientCallback() are run ahead of
+ * those made with uAtClientCallbackData(), that repeated data
+ * callbacks are merged and that the statistics on the callback
+ * queue count all that correctly.  Requires one UART with no
+ * particular wiring.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientCallbackQueue")
+{
+    uAtClientHandle_t atClientHandle;
+    uAtClientCallbackStats_t stats;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    gUartAHandle = uPortUartOpen(U_CFG_TEST_UART_A,
+                                 U_CFG_TEST_BAUD_RATE,
+                                 NULL,
+                                 U_CFG_TEST_UART_BUFFER_LENGTH_BYTES,
+                                 U_CFG_TEST_PIN_UART_A_TXD,
+                                 U_CFG_TEST_PIN_UART_A_RXD,
+                                 U_CFG_TEST_PIN_UART_A_CTS,
+                                 U_CFG_TEST_PIN_UART_A_RTS);
+    U_PORT_TEST_ASSERT(gUartAHandle >= 0);
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    U_TEST_PRINT_LINE("adding an AT client on UART %d...", U_CFG_TEST_UART_A);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    U_PORT_TEST_ASSERT(uAtClientCallbackQueueLengthSet(atClientHandle, 0) < 0);
+    U_PORT_TEST_ASSERT(uAtClientCallbackQueueLengthSet(atClientHandle, 5) == 0);
+
+    memset(gCallbackOrder, 0, sizeof(gCallbackOrder));
+    gCallbackOrderIndex = 0;
+    gCallbackHold = true;
+
+    // Queue a callback that will hold up the rest and wait
+    // for it to start running
+    U_PORT_TEST_ASSERT(uAtClientCallback(atClientHandle, callbackQueueCallback,
+                                         (void *) 'H') == 0);
+    for (size_t x = 0; (gCallbackOrderIndex == 0) && (x < 100); x++) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(gCallbackOrderIndex == 1);
+
+    // A burst of data callbacks for "a", which should be merged,
+    // one for "b" and then a control callback, which should
+    // overtake them
+    for (size_t x = 0; x < 10; x++) {
+        U_PORT_TEST_ASSERT(uAtClientCallbackData(atClientHandle, callbackQueueCallback,
+                                                 (void *) 'a') == 0);
+    }
+    U_PORT_TEST_ASSERT(uAtClientCallbackData(atClientHandle, callbackQueueCallback,
+                                             (void *) 'b') == 0);
+    U_PORT_TEST_ASSERT(uAtClientCallback(atClientHandle, callbackQueueCallback,
+                                         (void *) 'C') == 0);
+    // That's three waiting, two more will fill the queue
+    // and the one after that should be dropped
+    U_PORT_TEST_ASSERT(uAtClientCallback(atClientHandle, callbackQueueCallback,
+                                         (void *) 'D') == 0);
+    U_PORT_TEST_ASSERT(uAtClientCallbackData(atClientHandle, callbackQueueCallback,
+                                             (void *) 'c') == 0);
+    U_PORT_TEST_ASSERT(uAtClientCallback(atClientHandle, callbackQueueCallback,
+                                         (void *) 'E') < 0);
+    U_PORT_TEST_ASSERT(uAtClientCallbackQueueLengthSet(atClientHandle, 10) < 0);
+
+    U_PORT_TEST_ASSERT(uAtClientCallbackStatsGet(atClientHandle, &stats) == 0);
+    U_TEST_PRINT_LINE("callback queue: %d queued, %d merged, %d dropped,"
+                      " max depth %d, depth %d.", stats.numQueued,
+                      stats.numMerged, stats.numDropped, stats.maxDepth,
+                      stats.depth);
+    U_PORT_TEST_ASSERT(stats.numQueued == 6);
+    U_PORT_TEST_ASSERT(stats.numMerged == 9);
+    U_PORT_TEST_ASSERT(stats.numDropped == 1);
+    U_PORT_TEST_ASSERT(stats.maxDepth == 5);
+    U_PORT_TEST_ASSERT(stats.depth == 5);
+
+    // Let them all run
+    gCallbackHold = false;
+    for (size_t x = 0; (gCallbackOrderIndex < 6) && (x < 100); x++) {
+        uPortTaskBlock(10);
+    }
+    U_TEST_PRINT_LINE("callbacks were run in the order \"%s\".", gCallbackOrder);
+    U_PORT_TEST_ASSERT(strcmp(gCallbackOrder, "HCDabc") == 0);
+    U_PORT_TEST_ASSERT(uAtClientCallbackStatsGet(atClientHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.depth == 0);
+
+    U_TEST_PRINT_LINE("removing AT client...");
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      "during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
 # if (U_CFG_TEST_UART_B >= 0)
 /** Add an AT client, send the test commands of gAtClientTestSet1[],
  * to atServerCallback() over a UART where they are checked and then,
@@ -1566,6 +2058,8 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientCommandSet2")
     int32_t y;
     int32_t heapUsed;
     int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+    uAtClientUrcStats_t urcStats;
+    uAtClientLatencyEntry_t latencyEntry;
 
     memset(&checkUrc, 0, sizeof(checkUrc));
     checkUrc.pUrc = NULL;
@@ -1605,6 +2099,8 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientCommandSet2")
     uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
     U_TEST_PRINT_LINE("setting and checking AT timeout...");
     if (atTimeoutIsObeyed(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS)) {
+        // Collect latency statistics from here on
+        U_PORT_TEST_ASSERT(uAtClientLatencyStart(atClientHandle, 8) == 0);
         // Send out a boring thing that will be echoed
         // back to us, just to be sure everything is working
         uAtClientLock(atClientHandle);
@@ -1693,6 +2189,29 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientCommandSet2")
                       U_AT_CLIENT_TEST_NUM_URCS_SET_2,
                       checkUrc.passIndex);
 
+    // Check that the URC index has kept the matching cheap
+    U_PORT_TEST_ASSERT(uAtClientUrcStatsGet(atClientHandle, &urcStats) == 0);
+    U_TEST_PRINT_LINE("%d URC(s) matched taking %d compare(s), max %d.",
+                      urcStats.numMatches, urcStats.numCompares,
+                      urcStats.maxMatchCompares);
+    if (checkUrc.count > 0) {
+        U_PORT_TEST_ASSERT(urcStats.numMatches > 0);
+    }
+    U_PORT_TEST_ASSERT(urcStats.numCompares >= urcStats.numMatches);
+
+    // The "boring thing" sent above should have an entry in
+    // the latency statistics
+    if (lastError == 0) {
+        y = uAtClientLatencyGet(atClientHandle, 0, &latencyEntry);
+        U_PORT_TEST_ASSERT((y > 0) && (y <= 8));
+        U_PORT_TEST_ASSERT(!latencyEntry.isUrc);
+        U_PORT_TEST_ASSERT(latencyEntry.count > 0);
+        U_PORT_TEST_ASSERT(uAtClientLatencyGet(atClientHandle, (size_t) y,
+                                               NULL) < 0);
+    }
+    uAtClientLatencyStop(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientLatencyGet(atClientHandle, 0, NULL) < 0);
+
     // Check the stack extents for the URC and callbacks tasks
     checkStackExtents(atClientHandle);
 
@@ -1725,7 +2244,1168 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientCommandSet2")
                        (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
 }
 
-# endif
+/** Measure the throughput of the AT parser by sending a stream of
+ * socket-read-like responses, each carrying a quoted payload, from
+ * the second UART and reading them with the AT client, which sees
+ * them as normal information responses.  The throughput is printed
+ * in bytes/second; this is bounded by the baud rate of the UARTs
+ * but the overhead of the parser shows as the difference.  Requires
+ * two UARTs wired back-to-back.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientThroughput")
+{
+    uAtClientHandle_t atClientHandle;
+    size_t responseLength;
+    size_t numBytes = 0;
+    uBench_t bench;
+    int32_t lastError = 0;
+    int32_t x;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Set up everything with the two UARTs
+    twoUartsPreamble();
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    U_TEST_PRINT_LINE("adding an AT client on UART %d...", U_CFG_TEST_UART_A);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    U_TEST_PRINT_LINE("sending %d response(s) each with %d byte(s) of payload...",
+                      U_AT_CLIENT_TEST_THROUGHPUT_NUM_RESPONSES,
+                      U_AT_CLIENT_TEST_THROUGHPUT_PAYLOAD_LENGTH_BYTES);
+    uBenchStart(&bench, "atClientThroughput");
+    for (size_t y = 0; (y < U_AT_CLIENT_TEST_THROUGHPUT_NUM_RESPONSES) &&
+         (lastError == 0); y++) {
+        // Assemble a response that looks like a socket read
+        responseLength = snprintf(gAtThroughputBuffer, sizeof(gAtThroughputBuffer),
+                                  "\r\n+USORD: 0,%d,\"",
+                                  U_AT_CLIENT_TEST_THROUGHPUT_PAYLOAD_LENGTH_BYTES);
+        for (size_t z = 0; z < U_AT_CLIENT_TEST_THROUGHPUT_PAYLOAD_LENGTH_BYTES; z++) {
+            gAtThroughputBuffer[responseLength] = (char) ('a' + ((y + z) % 26));
+            responseLength++;
+        }
+        responseLength += snprintf(gAtThroughputBuffer + responseLength,
+                                   sizeof(gAtThroughputBuffer) - responseLength,
+                                   "\"\r\nOK\r\n");
+        uAtClientLock(atClientHandle);
+        uPortUartWrite(gUartBHandle, gAtThroughputBuffer, responseLength);
+        uAtClientResponseStart(atClientHandle, "+USORD:");
+        uAtClientSkipParameters(atClientHandle, 1);
+        x = uAtClientReadInt(atClientHandle);
+        memset(gAtThroughputBuffer, 0, sizeof(gAtThroughputBuffer));
+        if (uAtClientReadString(atClientHandle, gAtThroughputBuffer,
+                                sizeof(gAtThroughputBuffer), false) == x) {
+            numBytes += x;
+        }
+        uAtClientResponseStop(atClientHandle);
+        lastError = uAtClientUnlock(atClientHandle);
+        // Check the payload
+        if ((lastError == 0) &&
+            (x != U_AT_CLIENT_TEST_THROUGHPUT_PAYLOAD_LENGTH_BYTES)) {
+            lastError = -1;
+        }
+        for (size_t z = 0; (lastError == 0) &&
+             (z < U_AT_CLIENT_TEST_THROUGHPUT_PAYLOAD_LENGTH_BYTES); z++) {
+            if (gAtThroughputBuffer[z] != (char) ('a' + ((y + z) % 26))) {
+                U_TEST_PRINT_LINE("response %d, payload byte %d was 0x%02x"
+                                  " when 0x%02x was expected.", y + 1, z,
+                                  (unsigned char) gAtThroughputBuffer[z],
+                                  'a' + ((y + z) % 26));
+                lastError = -2;
+            }
+        }
+    }
+    uBenchStop(&bench, U_AT_CLIENT_TEST_THROUGHPUT_NUM_RESPONSES,
+               (uint32_t) numBytes, "bytes");
+    U_TEST_PRINT_LINE("UART baud rate %d.", U_CFG_TEST_BAUD_RATE);
+
+    // Check the stack extents for the URC and callbacks tasks
+    checkStackExtents(atClientHandle);
+
+    U_TEST_PRINT_LINE("removing AT client...");
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    uPortDeinit();
+
+    // Fail the test if an error occurred: doing this here
+    // rather than asserting above so that clean-up happens
+    // and hence we don't end up with mutexes left locked
+    U_PORT_TEST_ASSERT(lastError == 0);
+    U_PORT_TEST_ASSERT(numBytes == U_AT_CLIENT_TEST_THROUGHPUT_NUM_RESPONSES *
+                       U_AT_CLIENT_TEST_THROUGHPUT_PAYLOAD_LENGTH_BYTES);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+/** Check that uAtClientReadIntList() gives exactly the same answers
+ * as the equivalent sequence of uAtClientReadInt() and
+ * uAtClientSkipParameters() calls.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientReadIntList")
+{
+    uAtClientHandle_t atClientHandle;
+    const char *pResponse = "\r\n+THING: 1,-2,\"x y\", 34,,abc,\"56\",+7\r\nOK\r\n";
+    int32_t valuesList[9];
+    int32_t valuesSingle[9];
+    int32_t numRead;
+    int32_t errorCodeList;
+    int32_t errorCodeSingle;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Set up everything with the two UARTs
+    twoUartsPreamble();
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    U_TEST_PRINT_LINE("adding an AT client on UART %d...", U_CFG_TEST_UART_A);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    // Read the response in one go, skipping the quoted string
+    memset(valuesList, 0x55, sizeof(valuesList));
+    uAtClientLock(atClientHandle);
+    uPortUartWrite(gUartBHandle, pResponse, strlen(pResponse));
+    uAtClientResponseStart(atClientHandle, "+THING:");
+    numRead = uAtClientReadIntList(atClientHandle, valuesList,
+                                   sizeof(valuesList) / sizeof(valuesList[0]),
+                                   U_AT_CLIENT_READ_INT_LIST_SKIP(2, 1));
+    uAtClientResponseStop(atClientHandle);
+    errorCodeList = uAtClientUnlock(atClientHandle);
+
+    // Now the same the long way
+    memset(valuesSingle, 0x55, sizeof(valuesSingle));
+    uAtClientLock(atClientHandle);
+    uPortUartWrite(gUartBHandle, pResponse, strlen(pResponse));
+    uAtClientResponseStart(atClientHandle, "+THING:");
+    for (size_t x = 0; x < sizeof(valuesSingle) / sizeof(valuesSingle[0]); x++) {
+        if (x == 2) {
+            uAtClientSkipParameters(atClientHandle, 1);
+        } else {
+            valuesSingle[x] = uAtClientReadInt(atClientHandle);
+        }
+    }
+    uAtClientResponseStop(atClientHandle);
+    errorCodeSingle = uAtClientUnlock(atClientHandle);
+
+    U_TEST_PRINT_LINE("removing AT client...");
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    uPortDeinit();
+
+    U_TEST_PRINT_LINE("%d parameter(s) read.", numRead);
+    for (size_t x = 0; x < sizeof(valuesList) / sizeof(valuesList[0]); x++) {
+        U_TEST_PRINT_LINE("parameter %d: %d (uAtClientReadInt() gave %d).",
+                          x, valuesList[x], valuesSingle[x]);
+    }
+    U_PORT_TEST_ASSERT(errorCodeList == 0);
+    U_PORT_TEST_ASSERT(errorCodeSingle == 0);
+    U_PORT_TEST_ASSERT(numRead == 8);
+    U_PORT_TEST_ASSERT(memcmp(valuesList, valuesSingle, sizeof(valuesList)) == 0);
+    U_PORT_TEST_ASSERT(valuesList[0] == 1);
+    U_PORT_TEST_ASSERT(valuesList[1] == -2);
+    U_PORT_TEST_ASSERT(valuesList[3] == 34);
+    U_PORT_TEST_ASSERT(valuesList[4] == -1);
+    U_PORT_TEST_ASSERT(valuesList[5] == 0);
+    U_PORT_TEST_ASSERT(valuesList[6] == 56);
+    U_PORT_TEST_ASSERT(valuesList[7] == 7);
+    U_PORT_TEST_ASSERT(valuesList[8] == -1);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+/** Check that uAtClientCommandPrepared() sends exactly what the
+ * equivalent sequence of individual calls sends, including for a
+ * command line longer than its buffer.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientPrepared")
+{
+    uAtClientHandle_t atClientHandle;
+    static const uAtClientPreparedCommand_t prepared = U_AT_CLIENT_PREPARED_COMMAND("AT+THING=",
+                                                                                    "dusS");
+    char longString[U_AT_CLIENT_PREPARED_COMMAND_BUFFER_LENGTH_BYTES + 10];
+    char bufferPrepared[U_AT_CLIENT_PREPARED_COMMAND_BUFFER_LENGTH_BYTES * 2];
+    char bufferSingle[U_AT_CLIENT_PREPARED_COMMAND_BUFFER_LENGTH_BYTES * 2];
+    int32_t lengthPrepared = 0;
+    int32_t lengthSingle = 0;
+    int32_t x;
+    int32_t startTimeMs;
+    int32_t errorCodePrepared;
+    int32_t errorCodeSingle;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Set up everything with the two UARTs
+    twoUartsPreamble();
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    U_TEST_PRINT_LINE("adding an AT client on UART %d...", U_CFG_TEST_UART_A);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    memset(longString, 'x', sizeof(longString) - 1);
+    longString[sizeof(longString) - 1] = 0;
+
+    // Send the prepared command and capture it on UART B
+    uAtClientLock(atClientHandle);
+    uAtClientCommandPrepared(atClientHandle, &prepared, (int32_t) -12,
+                             (uint64_t) 12345678901234ULL, (const char *) "a b",
+                             (const char *) longString);
+    errorCodePrepared = uAtClientUnlock(atClientHandle);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((uPortGetTickTimeMs() - startTimeMs < 1000) &&
+           (lengthPrepared < (int32_t) sizeof(bufferPrepared))) {
+        x = uPortUartRead(gUartBHandle, bufferPrepared + lengthPrepared,
+                          sizeof(bufferPrepared) - lengthPrepared);
+        if (x > 0) {
+            lengthPrepared += x;
+        } else {
+            uPortTaskBlock(10);
+        }
+    }
+
+    // Now the same the long way
+    uAtClientLock(atClientHandle);
+    uAtClientCommandStart(atClientHandle, "AT+THING=");
+    uAtClientWriteInt(atClientHandle, -12);
+    uAtClientWriteUint64(atClientHandle, 12345678901234ULL);
+    uAtClientWriteString(atClientHandle, "a b", true);
+    uAtClientWriteString(atClientHandle, longString, false);
+    uAtClientCommandStop(atClientHandle);
+    errorCodeSingle = uAtClientUnlock(atClientHandle);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((uPortGetTickTimeMs() - startTimeMs < 1000) &&
+           (lengthSingle < (int32_t) sizeof(bufferSingle))) {
+        x = uPortUartRead(gUartBHandle, bufferSingle + lengthSingle,
+                          sizeof(bufferSingle) - lengthSingle);
+        if (x > 0) {
+            lengthSingle += x;
+        } else {
+            uPortTaskBlock(10);
+        }
+    }
+
+    U_TEST_PRINT_LINE("removing AT client...");
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    uPortDeinit();
+
+    U_TEST_PRINT_LINE("prepared command sent %d byte(s), the long way %d byte(s).",
+                      lengthPrepared, lengthSingle);
+    U_PORT_TEST_ASSERT(errorCodePrepared == 0);
+    U_PORT_TEST_ASSERT(errorCodeSingle == 0);
+    U_PORT_TEST_ASSERT(lengthPrepared == (int32_t) (strlen("AT+THING=-12,12345678901234,\"a b\",") +
+                                                    strlen(longString) + 1));
+    U_PORT_TEST_ASSERT(lengthPrepared == lengthSingle);
+    U_PORT_TEST_ASSERT(memcmp(bufferPrepared, bufferSingle, lengthPrepared) == 0);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+/** Check that uAtClientBatch() concatenates extended AT commands
+ * onto as few lines as the length limit allows, hands each
+ * information response to the right parser and counts completed
+ * commands a line at a time when something fails.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientBatch")
+{
+    uAtClientHandle_t atClientHandle;
+    uAtClientTestBatchServer_t server;
+    int32_t results[5];
+    const uAtClientBatchCommand_t commands[] = {
+        {"AT+ONE?", "+ONE:", batchParser, results},
+        {"AT+TWO?", "+TWO:", batchParser, results},
+        {"ATE0", NULL, NULL, NULL},
+        {"AT+THREE?", "+THREE:", batchParser, results},
+        {"AT+SET=1", NULL, NULL, NULL}
+    };
+    const uAtClientBatchCommand_t commandsFail[] = {
+        {"ATE0", NULL, NULL, NULL},
+        {"AT+ONE?", "+ONE:", batchParser, results},
+        {"AT+FAIL", NULL, NULL, NULL},
+        {"AT+TWO?", "+TWO:", batchParser, results}
+    };
+    char longCommands[10][32];
+    uAtClientBatchCommand_t commandsLong[sizeof(longCommands) / sizeof(longCommands[0])];
+    size_t numLong = sizeof(commandsLong) / sizeof(commandsLong[0]);
+    size_t longLength;
+    size_t longPerLine;
+    int32_t errorCodeOrCount;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Set up everything with the two UARTs
+    twoUartsPreamble();
+
+    memset(&server, 0, sizeof(server));
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(gUartBHandle,
+                                                 U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                 atBatchServerCallback, &server,
+                                                 U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES,
+                                                 U_AT_CLIENT_URC_TASK_PRIORITY) == 0);
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    U_TEST_PRINT_LINE("adding an AT client on UART %d...", U_CFG_TEST_UART_A);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    U_PORT_TEST_ASSERT(uAtClientBatch(atClientHandle, NULL, 1, true) < 0);
+    U_PORT_TEST_ASSERT(uAtClientBatch(atClientHandle, NULL, 0, true) == 0);
+    U_PORT_TEST_ASSERT(server.numLines == 0);
+
+    // Concatenated: "AT+ONE?;+TWO?", "ATE0" and "AT+THREE?;+SET=1"
+    memset(results, 0xff, sizeof(results));
+    errorCodeOrCount = uAtClientBatch(atClientHandle, commands,
+                                      sizeof(commands) / sizeof(commands[0]), true);
+    U_TEST_PRINT_LINE("concatenated batch returned %d, server got %d line(s).",
+                      errorCodeOrCount, (int) server.numLines);
+    U_PORT_TEST_ASSERT(errorCodeOrCount == (int32_t) (sizeof(commands) / sizeof(commands[0])));
+    U_PORT_TEST_ASSERT(server.numLines == 3);
+    U_PORT_TEST_ASSERT(server.maxLineLength == strlen("AT+THREE?;+SET=1"));
+    U_PORT_TEST_ASSERT(results[0] == 0);
+    U_PORT_TEST_ASSERT(results[1] == 1);
+    U_PORT_TEST_ASSERT(results[2] == -1);
+    U_PORT_TEST_ASSERT(results[3] == 2);
+    U_PORT_TEST_ASSERT(results[4] == -1);
+
+    // Not concatenated: a line each
+    memset(&server, 0, sizeof(server));
+    memset(results, 0xff, sizeof(results));
+    errorCodeOrCount = uAtClientBatch(atClientHandle, commands,
+                                      sizeof(commands) / sizeof(commands[0]), false);
+    U_PORT_TEST_ASSERT(errorCodeOrCount == (int32_t) (sizeof(commands) / sizeof(commands[0])));
+    U_PORT_TEST_ASSERT(server.numLines == sizeof(commands) / sizeof(commands[0]));
+    U_PORT_TEST_ASSERT(server.maxLineLength == strlen("AT+THREE?"));
+    U_PORT_TEST_ASSERT(results[0] == 0);
+    U_PORT_TEST_ASSERT(results[1] == 1);
+    U_PORT_TEST_ASSERT(results[3] == 2);
+
+    // Enough commands that they won't all fit on one line
+    for (size_t x = 0; x < numLong; x++) {
+        snprintf(longCommands[x], sizeof(longCommands[x]),
+                 "AT+PADDING%02d=0123456789", (int) x);
+        commandsLong[x].pCommand = longCommands[x];
+        commandsLong[x].pResponsePrefix = NULL;
+        commandsLong[x].pParser = NULL;
+        commandsLong[x].pParserParam = NULL;
+    }
+    longLength = strlen(longCommands[0]);
+    // The first command is whole, the rest lose their "AT" and gain a ';'
+    longPerLine = 1 + ((U_AT_CLIENT_BATCH_LINE_LENGTH_MAX_BYTES - longLength) / (longLength - 1));
+    U_PORT_TEST_ASSERT((longPerLine > 1) && (longPerLine < numLong));
+    memset(&server, 0, sizeof(server));
+    errorCodeOrCount = uAtClientBatch(atClientHandle, commandsLong, numLong, true);
+    U_TEST_PRINT_LINE("%d long command(s) went on %d line(s), the longest"
+                      " %d byte(s).", (int) numLong, (int) server.numLines,
+                      (int) server.maxLineLength);
+    U_PORT_TEST_ASSERT(errorCodeOrCount == (int32_t) numLong);
+    U_PORT_TEST_ASSERT(server.numLines == (numLong + longPerLine - 1) / longPerLine);
+    U_PORT_TEST_ASSERT(server.maxLineLength == longLength + ((longPerLine - 1) * (longLength - 1)));
+    U_PORT_TEST_ASSERT(server.maxLineLength <= U_AT_CLIENT_BATCH_LINE_LENGTH_MAX_BYTES);
+
+    // A failure: not concatenated, the commands before the one that
+    // failed count and the ones after it are never sent
+    memset(&server, 0, sizeof(server));
+    errorCodeOrCount = uAtClientBatch(atClientHandle, commandsFail,
+                                      sizeof(commandsFail) / sizeof(commandsFail[0]), false);
+    U_TEST_PRINT_LINE("failing batch returned %d.", errorCodeOrCount);
+    U_PORT_TEST_ASSERT(errorCodeOrCount == 2);
+    U_PORT_TEST_ASSERT(server.numLines == 3);
+
+    // Concatenated, the whole line with the failure in it is lost
+    memset(&server, 0, sizeof(server));
+    errorCodeOrCount = uAtClientBatch(atClientHandle, commandsFail,
+                                      sizeof(commandsFail) / sizeof(commandsFail[0]), true);
+    U_TEST_PRINT_LINE("failing concatenated batch returned %d.", errorCodeOrCount);
+    U_PORT_TEST_ASSERT(errorCodeOrCount == 1);
+    U_PORT_TEST_ASSERT(server.numLines == 2);
+
+    // The AT client must still be usable afterwards
+    memset(&server, 0, sizeof(server));
+    U_PORT_TEST_ASSERT(uAtClientBatch(atClientHandle, commands, 1, true) == 1);
+
+    U_TEST_PRINT_LINE("removing AT client...");
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+/** Check that uAtClientBatchAsync() copies the batch, runs it from
+ * the callback queue, in the order batches were queued, and calls
+ * the completion callback with what uAtClientBatch() would have
+ * returned.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientBatchAsync")
+{
+    uAtClientHandle_t atClientHandle;
+    uAtClientTestBatchServer_t server;
+    int32_t results[3];
+    uAtClientBatchCommand_t commands[] = {
+        {"AT+ONE?", "+ONE:", batchParser, results},
+        {"AT+SET=1", NULL, NULL, NULL},
+        {"AT+TWO?", "+TWO:", batchParser, results}
+    };
+    const uAtClientBatchCommand_t commandsFail[] = {
+        {"AT+SET=2", NULL, NULL, NULL},
+        {"AT+FAIL", NULL, NULL, NULL},
+        {"AT+SET=3", NULL, NULL, NULL}
+    };
+    int32_t startTimeMs;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Set up everything with the two UARTs
+    twoUartsPreamble();
+
+    memset(&server, 0, sizeof(server));
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(gUartBHandle,
+                                                 U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                 atBatchServerCallback, &server,
+                                                 U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES,
+                                                 U_AT_CLIENT_URC_TASK_PRIORITY) == 0);
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    U_TEST_PRINT_LINE("adding an AT client on UART %d...", U_CFG_TEST_UART_A);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    U_PORT_TEST_ASSERT(uAtClientBatchAsync(atClientHandle, NULL, 1, true,
+                                           batchAsyncCallback, NULL) < 0);
+    U_PORT_TEST_ASSERT(uAtClientBatchAsync(atClientHandle, commands, 0, true,
+                                           batchAsyncCallback, NULL) < 0);
+
+    // Queue a batch that works and then one that fails part-way
+    // through; the AT client is locked while doing so, so that
+    // neither can run before both are queued
+    gBatchAsyncCount = 0;
+    memset(results, 0xff, sizeof(results));
+    uAtClientLock(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientBatchAsync(atClientHandle, commands,
+                                           sizeof(commands) / sizeof(commands[0]),
+                                           true, batchAsyncCallback,
+                                           (void *) (intptr_t) 'A') == 0);
+    U_PORT_TEST_ASSERT(uAtClientBatchAsync(atClientHandle, commandsFail,
+                                           sizeof(commandsFail) / sizeof(commandsFail[0]),
+                                           false, batchAsyncCallback,
+                                           (void *) (intptr_t) 'B') == 0);
+    // The array was copied, so trashing ours must make no difference
+    memset(commands, 0, sizeof(commands));
+    uPortTaskBlock(100);
+    U_PORT_TEST_ASSERT(gBatchAsyncCount == 0);
+    U_PORT_TEST_ASSERT(server.numLines == 0);
+    uAtClientUnlock(atClientHandle);
+
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gBatchAsyncCount < 2) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_AT_CLIENT_TEST_AT_TIMEOUT_MS * 4)) {
+        uPortTaskBlock(10);
+    }
+    U_TEST_PRINT_LINE("%d completion callback(s), results %d ('%c') and %d ('%c').",
+                      (int) gBatchAsyncCount, gBatchAsyncResult[0],
+                      (char) gBatchAsyncParam[0], gBatchAsyncResult[1],
+                      (char) gBatchAsyncParam[1]);
+    U_PORT_TEST_ASSERT(gBatchAsyncCount == 2);
+    U_PORT_TEST_ASSERT(gBatchAsyncParam[0] == 'A');
+    U_PORT_TEST_ASSERT(gBatchAsyncResult[0] == 3);
+    U_PORT_TEST_ASSERT(results[0] == 0);
+    U_PORT_TEST_ASSERT(results[1] == -1);
+    U_PORT_TEST_ASSERT(results[2] == 1);
+    U_PORT_TEST_ASSERT(gBatchAsyncParam[1] == 'B');
+    U_PORT_TEST_ASSERT(gBatchAsyncResult[1] == 1);
+    // One concatenated line for the first batch, two for the second
+    U_PORT_TEST_ASSERT(server.numLines == 3);
+
+    U_TEST_PRINT_LINE("removing AT client...");
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+/** Check that uAtClientBatchDeferrable() behaves as
+ * uAtClientBatchAsync() when there is no wake-up handler, that with
+ * a wake-up handler it holds batches back until the next AT command
+ * wakes the module up, releasing them in order under that same
+ * wake-up, or until maxDelayMs expires, and that
+ * uAtClientWakeUpStatsGet() counts all of this.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientBatchDeferrable")
+{
+    uAtClientHandle_t atClientHandle;
+    uAtClientTestBatchServer_t server;
+    const uAtClientBatchCommand_t commands[] = {
+        {"AT+SET=4", NULL, NULL, NULL}
+    };
+    uAtClientWakeUpStats_t stats;
+    size_t numLines;
+    int32_t startTimeMs;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Set up everything with the two UARTs
+    twoUartsPreamble();
+
+    memset(&server, 0, sizeof(server));
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(gUartBHandle,
+                                                 U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                 atBatchServerCallback, &server,
+                                                 U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES,
+                                                 U_AT_CLIENT_URC_TASK_PRIORITY) == 0);
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    U_TEST_PRINT_LINE("adding an AT client on UART %d...", U_CFG_TEST_UART_A);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    U_PORT_TEST_ASSERT(uAtClientBatchDeferrable(atClientHandle, NULL, 1, true, 1000,
+                                                batchAsyncCallback, NULL) < 0);
+    U_PORT_TEST_ASSERT(uAtClientBatchDeferrable(atClientHandle, commands, 0, true, 1000,
+                                                batchAsyncCallback, NULL) < 0);
+    U_PORT_TEST_ASSERT(uAtClientBatchDeferrable(atClientHandle, commands, 1, true, -1,
+                                                batchAsyncCallback, NULL) < 0);
+    U_PORT_TEST_ASSERT(uAtClientWakeUpStatsGet(atClientHandle, NULL) < 0);
+
+    // With no wake-up handler the batch must go straight away
+    U_TEST_PRINT_LINE("deferrable batch with no wake-up handler...");
+    gBatchAsyncCount = 0;
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(uAtClientBatchDeferrable(atClientHandle, commands, 1, true, 10000,
+                                                batchAsyncCallback,
+                                                (void *) (intptr_t) 'A') == 0);
+    while ((gBatchAsyncCount < 1) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_AT_CLIENT_TEST_AT_TIMEOUT_MS * 4)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(gBatchAsyncCount == 1);
+    U_PORT_TEST_ASSERT(gBatchAsyncParam[0] == 'A');
+    U_PORT_TEST_ASSERT(gBatchAsyncResult[0] == 1);
+    U_PORT_TEST_ASSERT(server.numLines == 1);
+    U_PORT_TEST_ASSERT(uAtClientWakeUpStatsGet(atClientHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numDeferred == 0);
+
+    // Set a wake-up handler with a short inactivity timeout and
+    // let it expire, so that the module is "asleep"
+    gWakeUpCount = 0;
+    U_PORT_TEST_ASSERT(uAtClientSetWakeUpHandler(atClientHandle, wakeUpHandler,
+                                                 NULL, 100) == 0);
+    U_PORT_TEST_ASSERT(uAtClientWakeUpStatsGet(atClientHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numWakeUps == 0);
+    U_PORT_TEST_ASSERT(stats.numDeferred == 0);
+    U_PORT_TEST_ASSERT(stats.numCoalesced == 0);
+    uPortTaskBlock(200);
+
+    // Two batches should now be held back
+    U_TEST_PRINT_LINE("deferring two batches...");
+    gBatchAsyncCount = 0;
+    numLines = server.numLines;
+    U_PORT_TEST_ASSERT(uAtClientBatchDeferrable(atClientHandle, commands, 1, true, 5000,
+                                                batchAsyncCallback,
+                                                (void *) (intptr_t) 'B') == 0);
+    U_PORT_TEST_ASSERT(uAtClientBatchDeferrable(atClientHandle, commands, 1, true, 5000,
+                                                batchAsyncCallback,
+                                                (void *) (intptr_t) 'C') == 0);
+    uPortTaskBlock(300);
+    U_PORT_TEST_ASSERT(gBatchAsyncCount == 0);
+    U_PORT_TEST_ASSERT(server.numLines == numLines);
+    U_PORT_TEST_ASSERT(gWakeUpCount == 0);
+    U_PORT_TEST_ASSERT(uAtClientWakeUpStatsGet(atClientHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numDeferred == 2);
+
+    // An ordinary AT command wakes the module up and both
+    // deferred batches should then go, in order, under that
+    // same wake-up
+    U_TEST_PRINT_LINE("sending an AT command to release them...");
+    uAtClientLock(atClientHandle);
+    uAtClientCommandStart(atClientHandle, "AT+SET=9");
+    uAtClientCommandStopReadResponse(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gBatchAsyncCount < 2) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_AT_CLIENT_TEST_AT_TIMEOUT_MS * 4)) {
+        uPortTaskBlock(10);
+    }
+    U_TEST_PRINT_LINE("%d completion callback(s), results %d ('%c') and %d ('%c').",
+                      (int) gBatchAsyncCount, gBatchAsyncResult[0],
+                      (char) gBatchAsyncParam[0], gBatchAsyncResult[1],
+                      (char) gBatchAsyncParam[1]);
+    U_PORT_TEST_ASSERT(gBatchAsyncCount == 2);
+    U_PORT_TEST_ASSERT(gBatchAsyncParam[0] == 'B');
+    U_PORT_TEST_ASSERT(gBatchAsyncResult[0] == 1);
+    U_PORT_TEST_ASSERT(gBatchAsyncParam[1] == 'C');
+    U_PORT_TEST_ASSERT(gBatchAsyncResult[1] == 1);
+    U_PORT_TEST_ASSERT(server.numLines == numLines + 3);
+    U_PORT_TEST_ASSERT(gWakeUpCount == 1);
+    U_PORT_TEST_ASSERT(uAtClientWakeUpStatsGet(atClientHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numWakeUps == 1);
+    U_PORT_TEST_ASSERT(stats.numDeferred == 2);
+    U_PORT_TEST_ASSERT(stats.numCoalesced == 2);
+
+    // Let the module go back to "sleep" and defer a batch with
+    // nothing to follow it: it should go when maxDelayMs expires,
+    // waking the module up itself
+    uPortTaskBlock(200);
+    U_TEST_PRINT_LINE("deferring a batch until maxDelayMs expires...");
+    gBatchAsyncCount = 0;
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(uAtClientBatchDeferrable(atClientHandle, commands, 1, true, 300,
+                                                batchAsyncCallback,
+                                                (void *) (intptr_t) 'D') == 0);
+    while ((gBatchAsyncCount < 1) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_AT_CLIENT_TEST_AT_TIMEOUT_MS * 4)) {
+        uPortTaskBlock(10);
+    }
+    U_TEST_PRINT_LINE("completion callback after %d ms.",
+                      (int) (uPortGetTickTimeMs() - startTimeMs));
+    U_PORT_TEST_ASSERT(gBatchAsyncCount == 1);
+    U_PORT_TEST_ASSERT(uPortGetTickTimeMs() - startTimeMs >= 300);
+    U_PORT_TEST_ASSERT(gBatchAsyncParam[0] == 'D');
+    U_PORT_TEST_ASSERT(gBatchAsyncResult[0] == 1);
+    U_PORT_TEST_ASSERT(gWakeUpCount == 2);
+    U_PORT_TEST_ASSERT(uAtClientWakeUpStatsGet(atClientHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numWakeUps == 2);
+    U_PORT_TEST_ASSERT(stats.numDeferred == 3);
+    U_PORT_TEST_ASSERT(stats.numCoalesced == 2);
+    U_PORT_TEST_ASSERT(stats.wakeUpDurationMaxMs >= stats.wakeUpDurationLastMs);
+    U_PORT_TEST_ASSERT(stats.wakeUpDurationTotalMs >= stats.wakeUpDurationMaxMs);
+
+    U_PORT_TEST_ASSERT(uAtClientSetWakeUpHandler(atClientHandle, NULL, NULL, 0) == 0);
+
+    U_TEST_PRINT_LINE("removing AT client...");
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+/** Check that a binary payload longer than the receive buffer of
+ * the AT client, part of which will have been buffered by
+ * uAtClientResponseStart() and the rest of which arrives later, is
+ * read correctly by uAtClientReadBytes() with the stop tag ignored,
+ * which is the case where the payload is read directly from the
+ * UART, and that a payload which never completes fails after one
+ * AT timeout, not two.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientReadBytesDirect")
+{
+    uAtClientHandle_t atClientHandle;
+    const char *pPrefix = "\r\n+DATA:";
+    const char *pOk = "\r\nOK\r\n";
+    char *pPayload;
+    char *pBuffer;
+    size_t length = U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES * 3;
+    int32_t lengthRead;
+    int32_t errorCode;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // A payload containing everything, including things that
+    // look like the end of a response
+    pPayload = (char *) malloc(length);
+    U_PORT_TEST_ASSERT(pPayload != NULL);
+    pBuffer = (char *) malloc(length);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    for (size_t x = 0; x < length; x++) {
+        *(pPayload + x) = (char) (x * 7);
+    }
+    memcpy(pPayload + 10, pOk, strlen(pOk));
+
+    // Set up everything with the two UARTs
+    twoUartsPreamble();
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    U_TEST_PRINT_LINE("adding an AT client on UART %d...", U_CFG_TEST_UART_A);
+    atClientHandle = uAtClientAdd(gUartAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    // The prefix and the start of the payload first, the
+    // rest a little later
+    memset(pBuffer, 0, length);
+    uAtClientLock(atClientHandle);
+    uPortUartWrite(gUartBHandle, pPrefix, strlen(pPrefix));
+    uPortUartWrite(gUartBHandle, pPayload, 10 + strlen(pOk));
+    uAtClientResponseStart(atClientHandle, "+DATA:");
+    uAtClientIgnoreStopTag(atClientHandle);
+    uPortUartWrite(gUartBHandle, pPayload + 10 + strlen(pOk), length - (10 + strlen(pOk)));
+    uPortUartWrite(gUartBHandle, pOk, strlen(pOk));
+    lengthRead = uAtClientReadBytes(atClientHandle, pBuffer, length, true);
+    uAtClientRestoreStopTag(atClientHandle);
+    uAtClientResponseStop(atClientHandle);
+    errorCode = uAtClientUnlock(atClientHandle);
+    U_TEST_PRINT_LINE("read %d byte(s) of %d, error code %d.", lengthRead,
+                      (int) length, errorCode);
+    U_PORT_TEST_ASSERT(errorCode == 0);
+    U_PORT_TEST_ASSERT(lengthRead == (int32_t) length);
+    U_PORT_TEST_ASSERT(memcmp(pBuffer, pPayload, length) == 0);
+
+    // Now only half the payload, and no OK, should give a single timeout
+    uAtClientLock(atClientHandle);
+    startTimeMs = uPortGetTickTimeMs();
+    uPortUartWrite(gUartBHandle, pPrefix, strlen(pPrefix));
+    uPortUartWrite(gUartBHandle, pPayload, length / 2);
+    uAtClientResponseStart(atClientHandle, "+DATA:");
+    uAtClientIgnoreStopTag(atClientHandle);
+    lengthRead = uAtClientReadBytes(atClientHandle, pBuffer, length, true);
+    uAtClientRestoreStopTag(atClientHandle);
+    uAtClientResponseStop(atClientHandle);
+    errorCode = uAtClientUnlock(atClientHandle);
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("short payload: read returned %d, error code %d,"
+                      " took %d ms.", lengthRead, errorCode, durationMs);
+    U_PORT_TEST_ASSERT(lengthRead < 0);
+    U_PORT_TEST_ASSERT(errorCode < 0);
+    U_PORT_TEST_ASSERT(durationMs >= U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+    U_PORT_TEST_ASSERT(durationMs < U_AT_CLIENT_TEST_AT_TIMEOUT_MS +
+                       U_AT_CLIENT_TEST_AT_TIMEOUT_TOLERANCE_MS);
+
+    U_TEST_PRINT_LINE("removing AT client...");
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+    uPortUartClose(gUartAHandle);
+    gUartAHandle = -1;
+    free(pBuffer);
+    free(pPayload);
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+# endif
+#endif
+
+/** Check that pUAtClientPrivateMemStr(), the search used for stop
+ * tags, finds the same things as the byte-by-byte search it
+ * replaced and print how long each takes to get through a receive
+ * buffer of typical AT response data; needs no UART.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientMemStr")
+{
+    const char *pLine = "+CGDCONT: 1,\"IP\",\"internet\",\"10.0.0.1\",0,0,0,0\r\n";
+    size_t lineLength = strlen(pLine);
+    const char *pTags[] = {U_AT_CLIENT_CRLF, "OK\r\n", "ERROR\r\n", "\"\r"};
+    char *pBuffer;
+    size_t length = 0;
+    size_t tagLength;
+    int32_t naiveMs;
+    int32_t fastMs;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    pBuffer = (char *) malloc(U_AT_CLIENT_TEST_MEM_STR_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    // Fill the buffer with information response lines,
+    // with "OK\r\n" at the very end
+    while (length + lineLength + 4 <=
+           U_AT_CLIENT_TEST_MEM_STR_BUFFER_LENGTH_BYTES) {
+        memcpy(pBuffer + length, pLine, lineLength);
+        length += lineLength;
+    }
+    memcpy(pBuffer + length, "OK\r\n", 4);
+    length += 4;
+
+    // Check the edge cases
+    U_PORT_TEST_ASSERT(pUAtClientPrivateMemStr(pBuffer, 0, "O", 1) == NULL);
+    U_PORT_TEST_ASSERT(pUAtClientPrivateMemStr(pBuffer, length, "O", 0) == pBuffer);
+    U_PORT_TEST_ASSERT(pUAtClientPrivateMemStr(pBuffer, 3, pBuffer, 4) == NULL);
+    U_PORT_TEST_ASSERT(pUAtClientPrivateMemStr(pBuffer, length, pBuffer, length) == pBuffer);
+    U_PORT_TEST_ASSERT(pUAtClientPrivateMemStr("\r\r\n", 3, "\r\n", 2) != NULL);
+    U_PORT_TEST_ASSERT(pUAtClientPrivateMemStr("OK\r", 3, "OK\r\n", 4) == NULL);
+
+    // Check every offset for every tag against the original
+    for (size_t x = 0; x < sizeof(pTags) / sizeof(pTags[0]); x++) {
+        tagLength = strlen(pTags[x]);
+        for (size_t y = 0; y < lineLength + tagLength; y++) {
+            U_PORT_TEST_ASSERT(pUAtClientPrivateMemStr(pBuffer + y, length - y,
+                                                       pTags[x], tagLength) ==
+                               pMemStrNaive(pBuffer + y, length - y,
+                                            pTags[x], tagLength));
+        }
+    }
+
+    // Time the worst case for a response, "OK\r\n" right at the end
+    naiveMs = timeMemStr(pMemStrNaive, pBuffer, length, "OK\r\n", 4);
+    fastMs = timeMemStr(pUAtClientPrivateMemStr, pBuffer, length, "OK\r\n", 4);
+    U_TEST_PRINT_LINE("searching %d byte(s) for \"OK\\r\\n\" %d times took %d ms"
+                      " byte-by-byte, %d ms with memchr().", length,
+                      U_AT_CLIENT_TEST_MEM_STR_ITERATIONS, naiveMs, fastMs);
+    if (fastMs > 0) {
+        // Bytes per millisecond is kbytes per second
+        U_TEST_PRINT_LINE("that's %d kbytes/s byte-by-byte, %d kbytes/s"
+                          " with memchr().",
+                          (int32_t) ((length * U_AT_CLIENT_TEST_MEM_STR_ITERATIONS) / naiveMs),
+                          (int32_t) ((length * U_AT_CLIENT_TEST_MEM_STR_ITERATIONS) / fastMs));
+    }
+
+    free(pBuffer);
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Test building a session with uAtClientRecordAdd() and walking
+ * it with uAtClientRecordGet(); needs no UART.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientRecordSession")
+{
+    char buffer[40];
+    uAtClientRecord_t record;
+    bool isTx;
+    int32_t timeMs;
+    const char *pData;
+    size_t length;
+    const char *pSession = buffer;
+    int32_t x;
+
+    U_PORT_TEST_ASSERT(uAtClientRecordStart(NULL, NULL, buffer, sizeof(buffer)) < 0);
+    U_PORT_TEST_ASSERT(uAtClientRecordStart(NULL, &record, buffer, sizeof(buffer)) == 0);
+
+    // A command written in two pieces should end up in one record...
+    U_PORT_TEST_ASSERT(uAtClientRecordAdd(&record, true, 0, "AT", 2) ==
+                       U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES + 2);
+    U_PORT_TEST_ASSERT(uAtClientRecordAdd(&record, true, 1, "\r", 1) == 1);
+    // ...the response in another...
+    U_PORT_TEST_ASSERT(uAtClientRecordAdd(&record, false, 5, "\r\nOK\r\n", 6) ==
+                       U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES + 6);
+    // ...and something that arrives much later in a third
+    U_PORT_TEST_ASSERT(uAtClientRecordAdd(&record, false,
+                                          6 + U_AT_CLIENT_RECORD_COALESCE_MS,
+                                          "x", 1) ==
+                       U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES + 1);
+    U_PORT_TEST_ASSERT(record.length == (U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES * 3) + 10);
+    // No room for more
+    U_PORT_TEST_ASSERT(uAtClientRecordAdd(&record, true, 1000, "AT\r", 3) ==
+                       (int32_t) U_ERROR_COMMON_NO_MEMORY);
+    U_PORT_TEST_ASSERT(uAtClientRecordStop(NULL, &record) == (int32_t) record.length);
+
+    // Walk the session
+    length = record.length;
+    x = uAtClientRecordGet(pSession, length, &isTx, &timeMs, &pData, NULL);
+    U_PORT_TEST_ASSERT(x == U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES + 3);
+    U_PORT_TEST_ASSERT(isTx && (timeMs == 0) && (memcmp(pData, "AT\r", 3) == 0));
+    pSession += x;
+    length -= x;
+    x = uAtClientRecordGet(pSession, length, &isTx, &timeMs, &pData, NULL);
+    U_PORT_TEST_ASSERT(x == U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES + 6);
+    U_PORT_TEST_ASSERT(!isTx && (timeMs == 5) && (memcmp(pData, "\r\nOK\r\n", 6) == 0));
+    pSession += x;
+    length -= x;
+    // An incomplete record is an error
+    U_PORT_TEST_ASSERT(uAtClientRecordGet(pSession, length - 1, NULL,
+                                          NULL, NULL, NULL) < 0);
+    x = uAtClientRecordGet(pSession, length, NULL, &timeMs, NULL, NULL);
+    U_PORT_TEST_ASSERT(x == U_AT_CLIENT_RECORD_HEADER_LENGTH_BYTES + 1);
+    U_PORT_TEST_ASSERT(timeMs == 6 + U_AT_CLIENT_RECORD_COALESCE_MS);
+    pSession += x;
+    length -= x;
+    U_PORT_TEST_ASSERT(length == 0);
+    U_PORT_TEST_ASSERT(uAtClientRecordGet(pSession, length, NULL,
+                                          NULL, NULL, NULL) == 0);
+    // A record with a bad direction is an error
+    U_PORT_TEST_ASSERT(uAtClientRecordGet("X\0\0\0\0\0\0\0", 8, NULL,
+                                          NULL, NULL, NULL) < 0);
+}
+
+#if defined(U_CFG_TEST_UART_REPLAY) && (U_CFG_TEST_UART_REPLAY >= 0)
+
+/** Play gAtClientTestSet2 through a replay UART, as fast as it
+ * will go, with the same handlers as atClientCommandSet2, and
+ * print how long it took; this exercises the AT parser and URC
+ * dispatch without any UART hardware in the way.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientReplay")
+{
+    uAtClientHandle_t atClientHandle;
+    int32_t uartHandle;
+    char *pSession;
+    int32_t sessionLength;
+    const uAtClientTestEcho_t *pEcho;
+    uAtClientTestCheckUrc_t checkUrc;
+    size_t x = 0;
+    int32_t lastError;
+    int32_t y;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t heapUsed;
+
+    memset(&checkUrc, 0, sizeof(checkUrc));
+    checkUrc.pUrc = NULL;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    pSession = (char *) malloc(U_AT_CLIENT_TEST_REPLAY_SESSION_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(pSession != NULL);
+    sessionLength = replaySessionCreate(pSession, U_AT_CLIENT_TEST_REPLAY_SESSION_LENGTH_BYTES);
+    U_TEST_PRINT_LINE("replay session of %d byte(s) created.", sessionLength);
+    U_PORT_TEST_ASSERT(sessionLength > 0);
+
+    U_PORT_TEST_ASSERT(uPortUartInit() == 0);
+    U_PORT_TEST_ASSERT(uPortUartReplaySet(U_CFG_TEST_UART_REPLAY, pSession,
+                                          sessionLength, 0) == 0);
+    uartHandle = uPortUartOpen(U_CFG_TEST_UART_REPLAY, U_CFG_TEST_BAUD_RATE,
+                               NULL, U_CFG_TEST_UART_BUFFER_LENGTH_BYTES,
+                               -1, -1, -1, -1);
+    U_PORT_TEST_ASSERT(uartHandle >= 0);
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+    atClientHandle = uAtClientAdd(uartHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    startTimeMs = uPortGetTickTimeMs();
+    // The "boring thing"
+    uAtClientLock(atClientHandle);
+    uAtClientCommandStart(atClientHandle, "\r\nOK\r\n");
+    uAtClientCommandStop(atClientHandle);
+    uAtClientResponseStart(atClientHandle, NULL);
+    uAtClientResponseStop(atClientHandle);
+    lastError = uAtClientUnlock(atClientHandle);
+
+    // Now the same sequence as atClientCommandSet2
+    for (x = 0; (x < gAtClientTestSetSize2) && (lastError == 0); x++) {
+        pEcho = &(gAtClientTestSet2[x]);
+        checkUrc.pUrc = pEcho->pUrc;
+        if (pEcho->pUrc != NULL) {
+            lastError = uAtClientSetUrcHandler(atClientHandle,
+                                               pEcho->pUrc->pPrefix,
+                                               urcHandler,
+                                               (void *) &checkUrc);
+        }
+        if (lastError == 0) {
+            uAtClientLock(atClientHandle);
+            uAtClientCommandStart(atClientHandle, NULL);
+            uPortUartWrite(uartHandle, pEcho->pBytes, pEcho->length);
+            uAtClientCommandStop(atClientHandle);
+            lastError = pEcho->pFunction(atClientHandle, x, pEcho->pParameters);
+            y = uAtClientUnlock(atClientHandle);
+            if (y != pEcho->unlockErrorCode) {
+                U_TEST_PRINT_LINE_X("unlock returned %d when %d was expected.",
+                                    x + 1, y, pEcho->unlockErrorCode);
+                lastError = -2;
+            }
+            if ((checkUrc.pUrc != NULL) && (checkUrc.lastError != 0)) {
+                lastError = checkUrc.lastError;
+            }
+        }
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+
+    U_TEST_PRINT_LINE("%d out of %d tests passed, %d URC(s) (%d expected),"
+                      " of which %d correct.", x, gAtClientTestSetSize2,
+                      checkUrc.count, U_AT_CLIENT_TEST_NUM_URCS_SET_2,
+                      checkUrc.passIndex);
+    U_TEST_PRINT_LINE("replaying %d byte(s) of session took %d ms"
+                      " (this includes the AT timeouts that some"
+                      " of the tests wait for).", sessionLength, durationMs);
+
+    U_PORT_TEST_ASSERT(uPortUartReplayIsFinished(uartHandle));
+
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+    uPortUartClose(uartHandle);
+    uPortUartReplaySet(U_CFG_TEST_UART_REPLAY, NULL, 0, 0);
+    free(pSession);
+    uPortDeinit();
+
+    U_PORT_TEST_ASSERT(lastError == 0);
+    U_PORT_TEST_ASSERT(checkUrc.count == U_AT_CLIENT_TEST_NUM_URCS_SET_2);
+    U_PORT_TEST_ASSERT(checkUrc.passIndex == U_AT_CLIENT_TEST_NUM_URCS_SET_2);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 #endif
 
 /** Clean-up to be run at the end of this round of tests, just
@@ -125,7 +125,7 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
-#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+#ifdef U_AT_CLIENT_TEST_DATA_REQUIRED
 
 /** A URC consisting of a single int32_t, to be referenced in
  * gAtClientTestSet1 or gAtClientTestSet2.
@@ -578,7 +578,7 @@ static const uAtClientTestEchoMisc_t gAtClientTestEchoMisc = { U_AT_CLIENT_TEST_
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
-#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+#ifdef U_AT_CLIENT_TEST_DATA_REQUIRED
 
 // Function to check that whole parameters can be skipped, referenced
 // by gAtClientTestSet2.
@@ -1100,7 +1100,7 @@ static int32_t handleMiscUseLast(uAtClientHandle_t atClientHandle,
  * EXTERNED VARIABLES: gAtClientTestSet1 AND gAtClientTestSet2
  * -------------------------------------------------------------- */
 
-#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+#ifdef U_AT_CLIENT_TEST_DATA_REQUIRED
 
 /** Loopback test data for the AT client, requires two UARTs.
  * NOTE: if you change the number of references to URCs here then
@@ -1855,7 +1855,8 @@ const uAtClientTestCommandResponse_t gAtClientTestSet1[] = {
 const size_t gAtClientTestSetSize1 = sizeof(gAtClientTestSet1) / sizeof(gAtClientTestSet1[0]);
 
 /** Echo test data for the AT client, bringing together the
- * gAtClientTestEcho* items defined above; requires two UARTs.
+ * gAtClientTestEcho* items defined above; requires two UARTs or
+ * a replay UART.
  * NOTE: if you change the number of references to URCs here then
  * don't forget to change U_AT_CLIENT_TEST_NUM_URCS_SET_2 to match.
  */
@@ -92,6 +92,20 @@ extern "C" {
  */
 #define U_AT_CLIENT_TEST_NUM_URCS_SET_2 34
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+/** The test data is needed by the tests that use two UARTs...
+ */
+# define U_AT_CLIENT_TEST_DATA_REQUIRED
+#endif
+
+#if defined(U_CFG_TEST_UART_REPLAY) && (U_CFG_TEST_UART_REPLAY >= 0)
+/** ...and by the test that plays it through a replay UART.
+ */
+# ifndef U_AT_CLIENT_TEST_DATA_REQUIRED
+#  define U_AT_CLIENT_TEST_DATA_REQUIRED
+# endif
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -205,7 +219,7 @@ typedef struct {
  * VARIABLES
  * -------------------------------------------------------------- */
 
-#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+#ifdef U_AT_CLIENT_TEST_DATA_REQUIRED
 
 /** Loopback test data for the AT client, requires two UARTs.
  */
@@ -216,7 +230,8 @@ extern const uAtClientTestCommandResponse_t gAtClientTestSet1[];
  */
 extern const size_t gAtClientTestSetSize1;
 
-/** Echo test data for the AT client, requires two UARTs.
+/** Echo test data for the AT client, requires two UARTs or a
+ * replay UART.
  */
 extern const uAtClientTestEcho_t gAtClientTestSet2[];
 
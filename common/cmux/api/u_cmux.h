@@ -0,0 +1,386 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_CMUX_H_
+#define _U_CMUX_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __cmux __CMUX
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the 3GPP 27.010 multiplexer
+ * (CMUX) API.  A CMUX instance sits on top of a UART, which
+ * must already have been opened with uPortUartOpen(), and
+ * offers a number of virtual channels, each of which can be
+ * used like a UART: in particular a channel handle can be given
+ * to uAtClientAdd() with the stream type
+ * #U_AT_CLIENT_STREAM_TYPE_CMUX so that several AT clients, or
+ * an AT client and a transparent data channel, can run in
+ * parallel over a single UART.
+ *
+ * Only the basic option of 27.010 with UIH frames is supported,
+ * which is what cellular modules use.  The module at the other
+ * end must have been put into multiplexer mode (e.g. with
+ * AT+CMUX) before uCmuxOpen() is called; see uCellMuxEnable()
+ * for the cellular integration.
+ *
+ * The frame encode/decode functions at the end of this file rely
+ * on nothing other than [common/error/api](/common/error/api)
+ * and may be used independently of the rest of the API.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_CMUX_MAX_NUM
+/** The maximum number of CMUX instances that can be open at
+ * any one time, i.e. the number of UARTs that can carry a
+ * multiplexer.
+ */
+# define U_CMUX_MAX_NUM 1
+#endif
+
+#ifndef U_CMUX_CHANNEL_MAX
+/** The highest channel number (DLCI) that can be opened with
+ * uCmuxChannelOpen(); channel 0 is the control channel and is
+ * opened by uCmuxOpen().
+ */
+# define U_CMUX_CHANNEL_MAX 7
+#endif
+
+#ifndef U_CMUX_CHANNEL_BUFFER_LENGTH_BYTES
+/** The size of the receive buffer for each open channel.
+ */
+# define U_CMUX_CHANNEL_BUFFER_LENGTH_BYTES 1024
+#endif
+
+#ifndef U_CMUX_FRAME_INFORMATION_MAX_LENGTH_BYTES
+/** The default maximum length of the information field of a
+ * frame, the N1 parameter of 27.010, used by uCmuxOpen() if
+ * zero is given.  This must match what the module has been
+ * configured with, e.g. through AT+CMUX.
+ */
+# define U_CMUX_FRAME_INFORMATION_MAX_LENGTH_BYTES 127
+#endif
+
+/** The overhead of a frame over and above its information field
+ * when the information field is longer than 127 bytes: opening
+ * flag, address, control, two length bytes, FCS and closing flag.
+ */
+#define U_CMUX_FRAME_OVERHEAD_MAX_BYTES 7
+
+#ifndef U_CMUX_RESPONSE_TIMEOUT_MS
+/** How long to wait for the far end to respond to a control
+ * frame (T1 in 27.010 terms, though we wait for rather longer
+ * than the 27.010 default since cellular modules can be slow).
+ */
+# define U_CMUX_RESPONSE_TIMEOUT_MS 3000
+#endif
+
+#ifndef U_CMUX_WRITE_TIMEOUT_MS
+/** How long uCmuxChannelWrite() will wait for the far end to
+ * allow transmission again if it has flow-controlled us off.
+ */
+# define U_CMUX_WRITE_TIMEOUT_MS 5000
+#endif
+
+#ifndef U_CMUX_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that demultiplexes received
+ * frames; this is the task that is running when the UART
+ * event callback is called.
+ */
+# define U_CMUX_TASK_STACK_SIZE_BYTES 1536
+#endif
+
+#ifndef U_CMUX_TASK_PRIORITY
+/** The priority of the task that demultiplexes received frames:
+ * this should be higher than that of the tasks which consume the
+ * channels (e.g. the URC task of an AT client) so that one
+ * channel being busy does not hold up the others.
+ */
+# define U_CMUX_TASK_PRIORITY (U_CFG_OS_PRIORITY_MAX - 4)
+#endif
+
+#ifndef U_CMUX_CHANNEL_EVENT_QUEUE_SIZE
+/** The length of the event queue for each channel that has an
+ * event callback set.
+ */
+# define U_CMUX_CHANNEL_EVENT_QUEUE_SIZE 10
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The frame types of 27.010 that this implementation understands,
+ * the values being those of the control field with the P/F bit
+ * cleared.
+ */
+typedef enum {
+    U_CMUX_FRAME_TYPE_SABM = 0x2F, /**< set asynchronous balanced mode,
+                                        i.e. open a channel. */
+    U_CMUX_FRAME_TYPE_UA = 0x63,   /**< unnumbered acknowledgement. */
+    U_CMUX_FRAME_TYPE_DM = 0x0F,   /**< disconnected mode. */
+    U_CMUX_FRAME_TYPE_DISC = 0x43, /**< disconnect, i.e. close a channel. */
+    U_CMUX_FRAME_TYPE_UIH = 0xEF,  /**< unnumbered information with header
+                                        check, i.e. data. */
+    U_CMUX_FRAME_TYPE_UI = 0x03    /**< unnumbered information. */
+} uCmuxFrameType_t;
+
+/** A decoded 27.010 frame, as returned by uCmuxFrameDecode().
+ */
+typedef struct {
+    uint8_t channel;           /**< the channel (DLCI) the frame is for. */
+    bool commandResponse;      /**< the value of the C/R bit. */
+    uCmuxFrameType_t type;     /**< the frame type. */
+    bool pollFinal;            /**< the value of the P/F bit. */
+    const char *pInformation;  /**< pointer to the information field,
+                                    within the buffer passed to
+                                    uCmuxFrameDecode(). */
+    size_t informationLength;  /**< the length of the information field. */
+} uCmuxFrame_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: MULTIPLEXER
+ * -------------------------------------------------------------- */
+
+/** Initialise CMUX: must be called before any of the
+ * multiplexer functions below; if already initialised
+ * this function does nothing.
+ *
+ * @return zero on success else negative error code.
+ */
+int32_t uCmuxInit();
+
+/** Deinitialise CMUX, closing any open instances.
+ */
+void uCmuxDeinit();
+
+/** Open a CMUX instance on a UART and establish the control
+ * channel (channel 0).  The module at the far end must already
+ * be in multiplexer mode.  The CMUX instance will take over the
+ * event callback of the UART: whatever was using the UART
+ * before (e.g. an AT client) must have stopped doing so, see
+ * uAtClientStreamSwitch().
+ *
+ * @param uartHandle                 the handle of the UART, as
+ *                                   returned by uPortUartOpen().
+ * @param informationMaxLengthBytes  the maximum length of the
+ *                                   information field of a frame
+ *                                   (N1), which must match that
+ *                                   configured in the module; use
+ *                                   zero for the default of
+ *                                   #U_CMUX_FRAME_INFORMATION_MAX_LENGTH_BYTES.
+ * @return                           the handle of the CMUX instance
+ *                                   on success, else negative error
+ *                                   code.
+ */
+int32_t uCmuxOpen(int32_t uartHandle, size_t informationMaxLengthBytes);
+
+/** Close a CMUX instance: any channels that are still open are
+ * closed, the far end is told to leave multiplexer mode and the
+ * event callback of the UART is removed; the UART itself is not
+ * closed.  Anything using the channels must have stopped doing
+ * so before this is called.
+ *
+ * @param cmuxHandle  the handle of the CMUX instance.
+ */
+void uCmuxClose(int32_t cmuxHandle);
+
+/** Open a channel of a CMUX instance.  The returned handle can
+ * be used with the uCmuxChannelXxx() functions below or passed
+ * to uAtClientAdd() with #U_AT_CLIENT_STREAM_TYPE_CMUX.
+ *
+ * @param cmuxHandle  the handle of the CMUX instance.
+ * @param channel     the channel (DLCI) to open, 1 to
+ *                    #U_CMUX_CHANNEL_MAX.
+ * @return            the handle of the channel on success,
+ *                    else negative error code.
+ */
+int32_t uCmuxChannelOpen(int32_t cmuxHandle, uint8_t channel);
+
+/** Close a channel of a CMUX instance.  The event callback of
+ * the channel, if there is one, is removed.
+ *
+ * @param channelHandle  the handle of the channel.
+ */
+void uCmuxChannelClose(int32_t channelHandle);
+
+/** Get the number of bytes waiting to be read from a channel.
+ *
+ * @param channelHandle  the handle of the channel.
+ * @return               the number of bytes in the receive
+ *                       buffer of the channel else negative
+ *                       error code.
+ */
+int32_t uCmuxChannelGetReceiveSize(int32_t channelHandle);
+
+/** Read from a channel; this does not block.
+ *
+ * @param channelHandle  the handle of the channel.
+ * @param[out] pBuffer   a place to put the received data.
+ * @param sizeBytes      the amount of room at pBuffer.
+ * @return               the number of bytes read else
+ *                       negative error code.
+ */
+int32_t uCmuxChannelRead(int32_t channelHandle, void *pBuffer,
+                         size_t sizeBytes);
+
+/** Write to a channel; the data is split into frames of
+ * no more than the maximum information length given to
+ * uCmuxOpen().  If the far end has flow-controlled us off
+ * this will wait up to #U_CMUX_WRITE_TIMEOUT_MS for it to
+ * allow transmission again.
+ *
+ * @param channelHandle  the handle of the channel.
+ * @param pBuffer        the data to write.
+ * @param sizeBytes      the number of bytes at pBuffer.
+ * @return               the number of bytes written else
+ *                       negative error code.
+ */
+int32_t uCmuxChannelWrite(int32_t channelHandle, const void *pBuffer,
+                          size_t sizeBytes);
+
+/** Set an event callback for a channel.  This works in the
+ * same way as uPortUartEventCallbackSet(): a task with its own
+ * event queue is created for the channel and pFunction is called
+ * in that task, e.g. with #U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED
+ * when data arrives on the channel.
+ *
+ * @param channelHandle   the handle of the channel.
+ * @param filter          a bit-mask of the U_PORT_UART_EVENT_BITMASK_xxx
+ *                        events that pFunction should be called for.
+ * @param pFunction       the function to call.
+ * @param pParam          a parameter that will be passed to pFunction.
+ * @param stackSizeBytes  the stack size for the task that will call
+ *                        pFunction.
+ * @param priority        the priority of the task that will call
+ *                        pFunction.
+ * @return                zero on success else negative error code.
+ */
+int32_t uCmuxChannelEventCallbackSet(int32_t channelHandle,
+                                     uint32_t filter,
+                                     void (*pFunction)(int32_t,
+                                                       uint32_t,
+                                                       void *),
+                                     void *pParam,
+                                     size_t stackSizeBytes,
+                                     int32_t priority);
+
+/** Remove the event callback of a channel.
+ *
+ * @param channelHandle  the handle of the channel.
+ */
+void uCmuxChannelEventCallbackRemove(int32_t channelHandle);
+
+/** Send an event to the event callback of a channel, e.g. to
+ * re-trigger handling of data that has only been partially read.
+ * This does not block: if the event queue of the channel is full
+ * #U_ERROR_COMMON_NO_MEMORY is returned, which is harmless since
+ * the events already queued will cause the callback to be run.
+ *
+ * @param channelHandle  the handle of the channel.
+ * @param eventBitMap    the U_PORT_UART_EVENT_BITMASK_xxx events.
+ * @return               zero on success else negative error code.
+ */
+int32_t uCmuxChannelEventSend(int32_t channelHandle, uint32_t eventBitMap);
+
+/** Detect whether the task currently executing is the event
+ * callback of the given channel.
+ *
+ * @param channelHandle  the handle of the channel.
+ * @return               true if the current task is the event
+ *                       callback of the channel, else false.
+ */
+bool uCmuxChannelEventIsCallback(int32_t channelHandle);
+
+/** Get the minimum amount of stack that has been free, in bytes,
+ * for the event callback task of a channel.
+ *
+ * @param channelHandle  the handle of the channel.
+ * @return               the minimum free stack in bytes, else
+ *                       negative error code.
+ */
+int32_t uCmuxChannelEventStackMinFree(int32_t channelHandle);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: FRAME ENCODE/DECODE
+ * -------------------------------------------------------------- */
+
+/** Encode a 27.010 basic option frame.
+ *
+ * @param channel            the channel (DLCI), 0 to 63.
+ * @param commandResponse    the value of the C/R bit.
+ * @param type               the frame type.
+ * @param pollFinal          the value of the P/F bit.
+ * @param pInformation       the information field, may be NULL
+ *                           if informationLength is zero.
+ * @param informationLength  the length of the information field,
+ *                           up to 32767.
+ * @param[out] pBuffer       a place to put the frame; must have
+ *                           room for informationLength +
+ *                           #U_CMUX_FRAME_OVERHEAD_MAX_BYTES bytes.
+ * @param bufferLength       the amount of room at pBuffer.
+ * @return                   the length of the encoded frame or
+ *                           negative error code.
+ */
+int32_t uCmuxFrameEncode(uint8_t channel, bool commandResponse,
+                         uCmuxFrameType_t type, bool pollFinal,
+                         const char *pInformation, size_t informationLength,
+                         char *pBuffer, size_t bufferLength);
+
+/** Decode a 27.010 basic option frame.  pBuffer must begin with
+ * the opening flag of the frame; leading rubbish should be
+ * discarded by the caller.
+ *
+ * @param pBuffer      the received data.
+ * @param length       the amount of data at pBuffer.
+ * @param[out] pFrame  a place to put the decoded frame; the
+ *                     information field is not copied,
+ *                     pFrame->pInformation points into pBuffer.
+ * @return             on success the number of bytes of pBuffer
+ *                     the frame occupied, including both
+ *                     flags; #U_ERROR_COMMON_TIMEOUT if pBuffer
+ *                     does not (yet) contain a whole frame or
+ *                     #U_ERROR_COMMON_NOT_FOUND if what follows
+ *                     the flag is not a valid frame (e.g. the FCS
+ *                     does not match), in which case the opening flag
+ *                     should be discarded and decoding resumed
+ *                     at the next flag.
+ */
+int32_t uCmuxFrameDecode(const char *pBuffer, size_t length,
+                         uCmuxFrame_t *pFrame);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_CMUX_H_
+
+// End of file
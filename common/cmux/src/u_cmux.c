@@ -0,0 +1,1200 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the 3GPP 27.010 multiplexer (CMUX),
+ * basic option only.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdlib.h"    // malloc(), free()
+#include "string.h"    // memcpy(), memmove(), memset()
+#include "stdio.h"     // snprintf()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+#include "u_port_uart.h"
+#include "u_port_event_queue.h"
+
+#include "u_cmux.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The flag that opens and closes a basic option frame.
+ */
+#define U_CMUX_FLAG 0xF9
+
+/** The extension bit of the address, length and control channel
+ * message fields.
+ */
+#define U_CMUX_EA 0x01
+
+/** The command/response bit of the address field and of the type
+ * field of a control channel message.
+ */
+#define U_CMUX_CR 0x02
+
+/** The poll/final bit of the control field.
+ */
+#define U_CMUX_PF 0x10
+
+/** The value the FCS calculation will give when run over
+ * the header of a good frame plus its FCS.
+ */
+#define U_CMUX_FCS_GOOD 0xCF
+
+/** The minimum length of a frame: opening flag, address,
+ * control, length, FCS and closing flag.
+ */
+#define U_CMUX_FRAME_LENGTH_MIN_BYTES 6
+
+/** Control channel message type: multiplexer close down (CLD).
+ */
+#define U_CMUX_MESSAGE_TYPE_CLD 0xC1
+
+/** Control channel message type: test.
+ */
+#define U_CMUX_MESSAGE_TYPE_TEST 0x21
+
+/** Control channel message type: flow control on (FCon).
+ */
+#define U_CMUX_MESSAGE_TYPE_FCON 0xA1
+
+/** Control channel message type: flow control off (FCoff).
+ */
+#define U_CMUX_MESSAGE_TYPE_FCOFF 0x61
+
+/** Control channel message type: modem status command (MSC).
+ */
+#define U_CMUX_MESSAGE_TYPE_MSC 0xE1
+
+/** Control channel message type: non-supported command response.
+ */
+#define U_CMUX_MESSAGE_TYPE_NSC 0x11
+
+/** The flow control bit of the V.24 signals in an MSC.
+ */
+#define U_CMUX_V24_FC 0x02
+
+/** The V.24 signals we send in an MSC when opening a channel:
+ * ready to communicate, ready to receive and data valid.
+ */
+#define U_CMUX_V24_SIGNALS_OPEN (U_CMUX_EA | 0x04 | 0x08 | 0x80)
+
+/** Make a channel handle from a CMUX instance index and a channel.
+ */
+#define U_CMUX_CHANNEL_HANDLE(index, channel) ((int32_t) (((index) << 8) | (channel)))
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A channel of a CMUX instance.
+ */
+typedef struct {
+    volatile bool isOpen;
+    volatile bool responseReceived; /** Set by the receive task when
+                                        a UA or DM arrives. */
+    volatile uCmuxFrameType_t responseType;
+    volatile bool flowControlledOff; /** Set by an MSC from the far end. */
+    char *pRxBuffer; /** Ring buffer of U_CMUX_CHANNEL_BUFFER_LENGTH_BYTES. */
+    size_t rxReadIndex;
+    size_t rxWriteIndex;
+    size_t rxBytesLost;
+    int32_t eventQueueHandle;
+    uint32_t eventFilter;
+    void (*pEventCallback)(int32_t, uint32_t, void *);
+    void *pEventCallbackParam;
+} uCmuxChannel_t;
+
+/** A CMUX instance.
+ */
+typedef struct {
+    int32_t uartHandle; /** -1 if this instance is not in use. */
+    size_t informationMaxLength;
+    uPortMutexHandle_t txMutex; /** Protects pTxFrame and the UART write. */
+    uPortMutexHandle_t rxMutex; /** Protects the channel receive buffers. */
+    char *pTxFrame;
+    char *pRxFrame; /** Where received frames are assembled. */
+    size_t rxFrameLength;
+    volatile bool flowControlledOff; /** Set by FCoff from the far end. */
+    volatile bool closeDownConfirmed;
+    uCmuxChannel_t channel[U_CMUX_CHANNEL_MAX + 1];
+} uCmuxInstance_t;
+
+/** The parameter block sent to a channel event queue.
+ */
+typedef struct {
+    int32_t channelHandle;
+    uint32_t eventBitmask;
+} uCmuxChannelEvent_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Mutex to protect the API.
+ */
+static uPortMutexHandle_t gMutex = NULL;
+
+/** The CMUX instances.
+ */
+static uCmuxInstance_t gInstance[U_CMUX_MAX_NUM];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: FRAME HANDLING
+ * -------------------------------------------------------------- */
+
+// Calculate the 27.010 FCS, CRC-8 with the reversed polynomial
+// x^8 + x^2 + x + 1, over a buffer.
+static uint8_t fcsCalculate(const char *pBuffer, size_t length)
+{
+    uint8_t fcs = 0xFF;
+
+    for (size_t x = 0; x < length; x++) {
+        fcs ^= (uint8_t) *(pBuffer + x);
+        for (size_t y = 0; y < 8; y++) {
+            if (fcs & 0x01) {
+                fcs = (uint8_t) ((fcs >> 1) ^ 0xE0);
+            } else {
+                fcs >>= 1;
+            }
+        }
+    }
+
+    return fcs;
+}
+
+// Return true if the given control field, P/F bit cleared, is
+// a frame type we understand.
+static bool frameTypeIsValid(uint8_t type)
+{
+    return (type == (uint8_t) U_CMUX_FRAME_TYPE_SABM) ||
+           (type == (uint8_t) U_CMUX_FRAME_TYPE_UA) ||
+           (type == (uint8_t) U_CMUX_FRAME_TYPE_DM) ||
+           (type == (uint8_t) U_CMUX_FRAME_TYPE_DISC) ||
+           (type == (uint8_t) U_CMUX_FRAME_TYPE_UIH) ||
+           (type == (uint8_t) U_CMUX_FRAME_TYPE_UI);
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: INSTANCES AND CHANNELS
+ * -------------------------------------------------------------- */
+
+// Get an instance from a CMUX handle, which must be in use.
+static uCmuxInstance_t *pInstanceGet(int32_t cmuxHandle)
+{
+    uCmuxInstance_t *pInstance = NULL;
+
+    if ((cmuxHandle >= 0) && (cmuxHandle < U_CMUX_MAX_NUM) &&
+        (gInstance[cmuxHandle].uartHandle >= 0)) {
+        pInstance = &(gInstance[cmuxHandle]);
+    }
+
+    return pInstance;
+}
+
+// Get an open channel from a channel handle.
+static uCmuxChannel_t *pChannelGet(int32_t channelHandle,
+                                   uCmuxInstance_t **ppInstance)
+{
+    uCmuxChannel_t *pChannel = NULL;
+    uCmuxInstance_t *pInstance = NULL;
+    int32_t channel = channelHandle & 0xFF;
+
+    if ((channelHandle >= 0) && (channel > 0) && (channel <= U_CMUX_CHANNEL_MAX)) {
+        pInstance = pInstanceGet(channelHandle >> 8);
+        if ((pInstance != NULL) && (pInstance->channel[channel].pRxBuffer != NULL)) {
+            pChannel = &(pInstance->channel[channel]);
+        }
+    }
+    if (ppInstance != NULL) {
+        *ppInstance = pInstance;
+    }
+
+    return pChannel;
+}
+
+// Send a frame.
+static int32_t sendFrame(uCmuxInstance_t *pInstance, uint8_t channel,
+                         bool commandResponse, uCmuxFrameType_t type,
+                         bool pollFinal, const char *pInformation,
+                         size_t informationLength)
+{
+    int32_t errorCodeOrLength;
+    int32_t written = 0;
+    int32_t x = 0;
+
+    U_PORT_MUTEX_LOCK(pInstance->txMutex);
+
+    errorCodeOrLength = uCmuxFrameEncode(channel, commandResponse, type, pollFinal,
+                                         pInformation, informationLength,
+                                         pInstance->pTxFrame,
+                                         pInstance->informationMaxLength +
+                                         U_CMUX_FRAME_OVERHEAD_MAX_BYTES);
+    while ((errorCodeOrLength > 0) && (written < errorCodeOrLength) && (x >= 0)) {
+        x = uPortUartWrite(pInstance->uartHandle, pInstance->pTxFrame + written,
+                           errorCodeOrLength - written);
+        if (x > 0) {
+            written += x;
+        } else if (x < 0) {
+            errorCodeOrLength = x;
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pInstance->txMutex);
+
+    return errorCodeOrLength;
+}
+
+// Send a control channel message.
+static int32_t sendControlMessage(uCmuxInstance_t *pInstance, uint8_t type,
+                                  bool isCommand, const char *pValue,
+                                  size_t valueLength)
+{
+    char message[8];
+
+    if (valueLength > sizeof(message) - 2) {
+        valueLength = sizeof(message) - 2;
+    }
+    message[0] = (char) (type | U_CMUX_EA | (isCommand ? U_CMUX_CR : 0));
+    message[1] = (char) ((valueLength << 1) | U_CMUX_EA);
+    if (valueLength > 0) {
+        memcpy(message + 2, pValue, valueLength);
+    }
+
+    return sendFrame(pInstance, 0, true, U_CMUX_FRAME_TYPE_UIH, false,
+                     message, valueLength + 2);
+}
+
+// Send SABM or DISC on a channel and wait for the response,
+// returning zero if a UA came back.
+static int32_t sendCommandWaitResponse(uCmuxInstance_t *pInstance,
+                                       uint8_t channel,
+                                       uCmuxFrameType_t type)
+{
+    int32_t errorCode;
+    uCmuxChannel_t *pChannel = &(pInstance->channel[channel]);
+    int32_t startTimeMs;
+
+    pChannel->responseReceived = false;
+    errorCode = sendFrame(pInstance, channel, true, type, true, NULL, 0);
+    if (errorCode >= 0) {
+        errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        startTimeMs = uPortGetTickTimeMs();
+        while (!pChannel->responseReceived &&
+               (uPortGetTickTimeMs() - startTimeMs < U_CMUX_RESPONSE_TIMEOUT_MS)) {
+            uPortTaskBlock(10);
+        }
+        if (pChannel->responseReceived) {
+            errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            if (pChannel->responseType == U_CMUX_FRAME_TYPE_UA) {
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Put received data into the ring buffer of a channel, returning
+// true if the channel has a callback that should be told.
+static bool channelRxPut(uCmuxInstance_t *pInstance, uCmuxChannel_t *pChannel,
+                         const char *pData, size_t length)
+{
+    size_t nextWriteIndex;
+
+    U_PORT_MUTEX_LOCK(pInstance->rxMutex);
+
+    if (pChannel->pRxBuffer != NULL) {
+        for (size_t x = 0; x < length; x++) {
+            nextWriteIndex = pChannel->rxWriteIndex + 1;
+            if (nextWriteIndex >= U_CMUX_CHANNEL_BUFFER_LENGTH_BYTES) {
+                nextWriteIndex = 0;
+            }
+            if (nextWriteIndex == pChannel->rxReadIndex) {
+                // Full, the rest is lost
+                pChannel->rxBytesLost += length - x;
+                break;
+            }
+            *(pChannel->pRxBuffer + pChannel->rxWriteIndex) = *(pData + x);
+            pChannel->rxWriteIndex = nextWriteIndex;
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pInstance->rxMutex);
+
+    return (pChannel->eventQueueHandle >= 0) &&
+           ((pChannel->eventFilter & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) != 0);
+}
+
+// Handle a message arriving on the control channel.
+static void handleControlMessage(uCmuxInstance_t *pInstance,
+                                 const char *pMessage, size_t length)
+{
+    uint8_t type;
+    bool isCommand;
+    size_t valueLength;
+    const char *pValue;
+    uint8_t channel;
+
+    if (length >= 2) {
+        type = (uint8_t) *pMessage;
+        isCommand = ((type & U_CMUX_CR) != 0);
+        type &= (uint8_t) ~(U_CMUX_CR | U_CMUX_EA);
+        type |= U_CMUX_EA;
+        // Only single byte lengths are expected on the control channel
+        valueLength = ((uint8_t) * (pMessage + 1)) >> 1;
+        pValue = pMessage + 2;
+        if (valueLength > length - 2) {
+            valueLength = length - 2;
+        }
+        switch (type) {
+            case U_CMUX_MESSAGE_TYPE_CLD:
+                if (!isCommand) {
+                    pInstance->closeDownConfirmed = true;
+                }
+                break;
+            case U_CMUX_MESSAGE_TYPE_FCON:
+            case U_CMUX_MESSAGE_TYPE_FCOFF:
+                if (isCommand) {
+                    pInstance->flowControlledOff = (type == U_CMUX_MESSAGE_TYPE_FCOFF);
+                    sendControlMessage(pInstance, type, false, NULL, 0);
+                }
+                break;
+            case U_CMUX_MESSAGE_TYPE_MSC:
+                if (isCommand && (valueLength >= 2)) {
+                    channel = ((uint8_t) * pValue) >> 2;
+                    if ((channel > 0) && (channel <= U_CMUX_CHANNEL_MAX)) {
+                        pInstance->channel[channel].flowControlledOff =
+                            ((((uint8_t) * (pValue + 1)) & U_CMUX_V24_FC) != 0);
+                    }
+                    sendControlMessage(pInstance, type, false, pValue, valueLength);
+                }
+                break;
+            case U_CMUX_MESSAGE_TYPE_TEST:
+                if (isCommand) {
+                    sendControlMessage(pInstance, type, false, pValue, valueLength);
+                }
+                break;
+            case U_CMUX_MESSAGE_TYPE_NSC:
+                break;
+            default:
+                if (isCommand) {
+                    // Tell the far end we don't do this
+                    type = (uint8_t) * pMessage;
+                    sendControlMessage(pInstance, U_CMUX_MESSAGE_TYPE_NSC,
+                                       false, (const char *) &type, 1);
+                }
+                break;
+        }
+    }
+}
+
+// Handle a received frame, returning the handle of a channel
+// whose callback should be told about received data, or -1.
+static int32_t handleFrame(uCmuxInstance_t *pInstance, int32_t index,
+                           const uCmuxFrame_t *pFrame)
+{
+    int32_t channelHandleToTell = -1;
+    uCmuxChannel_t *pChannel = NULL;
+
+    if (pFrame->channel <= U_CMUX_CHANNEL_MAX) {
+        pChannel = &(pInstance->channel[pFrame->channel]);
+    }
+
+    switch (pFrame->type) {
+        case U_CMUX_FRAME_TYPE_UIH:
+        case U_CMUX_FRAME_TYPE_UI:
+            if (pFrame->channel == 0) {
+                handleControlMessage(pInstance, pFrame->pInformation,
+                                     pFrame->informationLength);
+            } else if ((pChannel != NULL) && pChannel->isOpen &&
+                       (pFrame->informationLength > 0)) {
+                if (channelRxPut(pInstance, pChannel, pFrame->pInformation,
+                                 pFrame->informationLength)) {
+                    channelHandleToTell = U_CMUX_CHANNEL_HANDLE(index, pFrame->channel);
+                }
+            }
+            break;
+        case U_CMUX_FRAME_TYPE_UA:
+        case U_CMUX_FRAME_TYPE_DM:
+            if (pChannel != NULL) {
+                pChannel->responseType = pFrame->type;
+                pChannel->responseReceived = true;
+            }
+            break;
+        case U_CMUX_FRAME_TYPE_DISC:
+            // The far end is closing a channel: agree
+            sendFrame(pInstance, pFrame->channel, false, U_CMUX_FRAME_TYPE_UA,
+                      true, NULL, 0);
+            if (pChannel != NULL) {
+                pChannel->isOpen = false;
+            }
+            break;
+        case U_CMUX_FRAME_TYPE_SABM:
+            // We are the initiator, we don't accept channels
+            sendFrame(pInstance, pFrame->channel, false, U_CMUX_FRAME_TYPE_DM,
+                      true, NULL, 0);
+            break;
+        default:
+            break;
+    }
+
+    return channelHandleToTell;
+}
+
+// Send an event to a channel, without blocking.
+static void channelEventSend(int32_t channelHandle, uint32_t eventBitmask)
+{
+    uCmuxChannel_t *pChannel = pChannelGet(channelHandle, NULL);
+    uCmuxChannelEvent_t event;
+
+    if ((pChannel != NULL) && (pChannel->eventQueueHandle >= 0) &&
+        (uPortEventQueueGetFree(pChannel->eventQueueHandle) != 0)) {
+        // If the queue is full there are events pending which
+        // will cause the receiver to read this data anyway
+        event.channelHandle = channelHandle;
+        event.eventBitmask = eventBitmask;
+        uPortEventQueueSend(pChannel->eventQueueHandle, &event, sizeof(event));
+    }
+}
+
+// The UART event callback: this is where received frames are
+// assembled, decoded and passed to the channels.
+static void uartCallback(int32_t uartHandle, uint32_t eventBitmask,
+                         void *pParameters)
+{
+    uCmuxInstance_t *pInstance = (uCmuxInstance_t *) pParameters;
+    int32_t index = (int32_t) (pInstance - gInstance);
+    size_t rxFrameSize = pInstance->informationMaxLength +
+                         U_CMUX_FRAME_OVERHEAD_MAX_BYTES;
+    uCmuxFrame_t frame;
+    int32_t x;
+    int32_t readLength;
+    int32_t channelHandle;
+    char *pFlag;
+
+    if ((eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) &&
+        (pInstance->uartHandle == uartHandle)) {
+        do {
+            readLength = uPortUartRead(uartHandle,
+                                       pInstance->pRxFrame + pInstance->rxFrameLength,
+                                       rxFrameSize - pInstance->rxFrameLength);
+            if (readLength > 0) {
+                pInstance->rxFrameLength += readLength;
+            }
+            // Decode as many frames as we have
+            while (pInstance->rxFrameLength > 0) {
+                // Throw away anything before a flag and, since the
+                // closing flag of one frame may be the opening flag
+                // of the next, all but the last of a run of flags
+                pFlag = (char *) memchr(pInstance->pRxFrame, U_CMUX_FLAG,
+                                        pInstance->rxFrameLength);
+                if (pFlag == NULL) {
+                    pInstance->rxFrameLength = 0;
+                } else {
+                    while ((pFlag + 1 < pInstance->pRxFrame + pInstance->rxFrameLength) &&
+                           (*(pFlag + 1) == (char) U_CMUX_FLAG)) {
+                        pFlag++;
+                    }
+                    pInstance->rxFrameLength -= pFlag - pInstance->pRxFrame;
+                    memmove(pInstance->pRxFrame, pFlag, pInstance->rxFrameLength);
+                }
+                if (pInstance->rxFrameLength == 0) {
+                    break;
+                }
+                x = uCmuxFrameDecode(pInstance->pRxFrame, pInstance->rxFrameLength,
+                                     &frame);
+                if (x > 0) {
+                    channelHandle = handleFrame(pInstance, index, &frame);
+                    if (channelHandle >= 0) {
+                        channelEventSend(channelHandle,
+                                         U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED);
+                    }
+                    // Leave the closing flag, it may open the next frame
+                    x--;
+                } else if ((x == (int32_t) U_ERROR_COMMON_TIMEOUT) &&
+                           (pInstance->rxFrameLength < rxFrameSize)) {
+                    // Need more data
+                    break;
+                } else {
+                    // Not a frame or too big for us: discard the flag
+                    x = 1;
+                }
+                pInstance->rxFrameLength -= x;
+                memmove(pInstance->pRxFrame, pInstance->pRxFrame + x,
+                        pInstance->rxFrameLength);
+            }
+        } while (readLength > 0);
+    }
+}
+
+// Handle a channel event, called in the event task of the channel.
+static void channelEventHandler(void *pParam, size_t paramLength)
+{
+    uCmuxChannelEvent_t *pEvent = (uCmuxChannelEvent_t *) pParam;
+    uCmuxChannel_t *pChannel;
+
+    (void) paramLength;
+
+    pChannel = pChannelGet(pEvent->channelHandle, NULL);
+    if ((pChannel != NULL) && (pChannel->pEventCallback != NULL) &&
+        ((pChannel->eventFilter & pEvent->eventBitmask) != 0)) {
+        pChannel->pEventCallback(pEvent->channelHandle,
+                                 pEvent->eventBitmask,
+                                 pChannel->pEventCallbackParam);
+    }
+}
+
+// Remove the event callback of a channel.
+static void channelEventCallbackRemove(uCmuxChannel_t *pChannel)
+{
+    int32_t eventQueueHandle = pChannel->eventQueueHandle;
+
+    if (eventQueueHandle >= 0) {
+        pChannel->eventQueueHandle = -1;
+        uPortEventQueueClose(eventQueueHandle);
+    }
+    pChannel->pEventCallback = NULL;
+    pChannel->pEventCallbackParam = NULL;
+    pChannel->eventFilter = 0;
+}
+
+// Close a channel.
+static void channelClose(uCmuxInstance_t *pInstance, uint8_t channel)
+{
+    uCmuxChannel_t *pChannel = &(pInstance->channel[channel]);
+    char *pRxBuffer;
+
+    channelEventCallbackRemove(pChannel);
+    if (pChannel->isOpen) {
+        // Don't much mind if no response comes back
+        sendCommandWaitResponse(pInstance, channel, U_CMUX_FRAME_TYPE_DISC);
+        pChannel->isOpen = false;
+    }
+    U_PORT_MUTEX_LOCK(pInstance->rxMutex);
+    pRxBuffer = pChannel->pRxBuffer;
+    pChannel->pRxBuffer = NULL;
+    U_PORT_MUTEX_UNLOCK(pInstance->rxMutex);
+    free(pRxBuffer);
+}
+
+// Free the resources of an instance, which must have been
+// closed down.
+static void instanceFree(uCmuxInstance_t *pInstance)
+{
+    if (pInstance->txMutex != NULL) {
+        uPortMutexDelete(pInstance->txMutex);
+    }
+    if (pInstance->rxMutex != NULL) {
+        uPortMutexDelete(pInstance->rxMutex);
+    }
+    free(pInstance->pTxFrame);
+    free(pInstance->pRxFrame);
+    memset(pInstance, 0, sizeof(*pInstance));
+    pInstance->uartHandle = -1;
+    for (size_t x = 0; x < sizeof(pInstance->channel) / sizeof(pInstance->channel[0]); x++) {
+        pInstance->channel[x].eventQueueHandle = -1;
+    }
+}
+
+// Close an instance.
+static void instanceClose(uCmuxInstance_t *pInstance)
+{
+    int32_t startTimeMs;
+
+    for (uint8_t x = 1; x <= U_CMUX_CHANNEL_MAX; x++) {
+        channelClose(pInstance, x);
+    }
+    // Ask the far end to leave multiplexer mode
+    pInstance->closeDownConfirmed = false;
+    if (sendControlMessage(pInstance, U_CMUX_MESSAGE_TYPE_CLD,
+                           true, NULL, 0) >= 0) {
+        startTimeMs = uPortGetTickTimeMs();
+        while (!pInstance->closeDownConfirmed &&
+               (uPortGetTickTimeMs() - startTimeMs < U_CMUX_RESPONSE_TIMEOUT_MS)) {
+            uPortTaskBlock(10);
+        }
+    }
+    if (!pInstance->closeDownConfirmed) {
+        // Try closing the control channel instead
+        sendCommandWaitResponse(pInstance, 0, U_CMUX_FRAME_TYPE_DISC);
+    }
+    uPortUartEventCallbackRemove(pInstance->uartHandle);
+    instanceFree(pInstance);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: MULTIPLEXER
+ * -------------------------------------------------------------- */
+
+// Initialise CMUX.
+int32_t uCmuxInit()
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (gMutex == NULL) {
+        errorCode = uPortMutexCreate(&gMutex);
+        if (errorCode == 0) {
+            for (size_t x = 0; x < sizeof(gInstance) / sizeof(gInstance[0]); x++) {
+                memset(&(gInstance[x]), 0, sizeof(gInstance[x]));
+                instanceFree(&(gInstance[x]));
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Deinitialise CMUX.
+void uCmuxDeinit()
+{
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        for (size_t x = 0; x < sizeof(gInstance) / sizeof(gInstance[0]); x++) {
+            if (gInstance[x].uartHandle >= 0) {
+                instanceClose(&(gInstance[x]));
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+        uPortMutexDelete(gMutex);
+        gMutex = NULL;
+    }
+}
+
+// Open a CMUX instance.
+int32_t uCmuxOpen(int32_t uartHandle, size_t informationMaxLengthBytes)
+{
+    int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCmuxInstance_t *pInstance = NULL;
+    int32_t index = -1;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        if (informationMaxLengthBytes == 0) {
+            informationMaxLengthBytes = U_CMUX_FRAME_INFORMATION_MAX_LENGTH_BYTES;
+        }
+        errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((uartHandle >= 0) && (informationMaxLengthBytes <= 32767)) {
+            errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            for (size_t x = 0; (pInstance == NULL) &&
+                 (x < sizeof(gInstance) / sizeof(gInstance[0])); x++) {
+                if (gInstance[x].uartHandle == uartHandle) {
+                    // Already open on this UART
+                    errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                    break;
+                }
+                if (gInstance[x].uartHandle < 0) {
+                    index = (int32_t) x;
+                    pInstance = &(gInstance[x]);
+                }
+            }
+            if (pInstance != NULL) {
+                pInstance->informationMaxLength = informationMaxLengthBytes;
+                pInstance->pTxFrame = (char *) malloc(informationMaxLengthBytes +
+                                                      U_CMUX_FRAME_OVERHEAD_MAX_BYTES);
+                pInstance->pRxFrame = (char *) malloc(informationMaxLengthBytes +
+                                                      U_CMUX_FRAME_OVERHEAD_MAX_BYTES);
+                if ((pInstance->pTxFrame != NULL) && (pInstance->pRxFrame != NULL) &&
+                    (uPortMutexCreate(&(pInstance->txMutex)) == 0) &&
+                    (uPortMutexCreate(&(pInstance->rxMutex)) == 0)) {
+                    pInstance->uartHandle = uartHandle;
+                    errorCodeOrHandle = uPortUartEventCallbackSet(uartHandle,
+                                                                  U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                                  uartCallback, pInstance,
+                                                                  U_CMUX_TASK_STACK_SIZE_BYTES,
+                                                                  U_CMUX_TASK_PRIORITY);
+                    if (errorCodeOrHandle == 0) {
+                        // Open the control channel
+                        errorCodeOrHandle = sendCommandWaitResponse(pInstance, 0,
+                                                                    U_CMUX_FRAME_TYPE_SABM);
+                        if (errorCodeOrHandle == 0) {
+                            pInstance->channel[0].isOpen = true;
+                            errorCodeOrHandle = index;
+                        } else {
+                            uPortUartEventCallbackRemove(uartHandle);
+                        }
+                    }
+                }
+                if (errorCodeOrHandle < 0) {
+                    instanceFree(pInstance);
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCodeOrHandle;
+}
+
+// Close a CMUX instance.
+void uCmuxClose(int32_t cmuxHandle)
+{
+    uCmuxInstance_t *pInstance;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pInstance = pInstanceGet(cmuxHandle);
+        if (pInstance != NULL) {
+            instanceClose(pInstance);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+// Open a channel.
+int32_t uCmuxChannelOpen(int32_t cmuxHandle, uint8_t channel)
+{
+    int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCmuxInstance_t *pInstance;
+    uCmuxChannel_t *pChannel;
+    char value[2];
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pInstanceGet(cmuxHandle);
+        if ((pInstance != NULL) && (channel > 0) && (channel <= U_CMUX_CHANNEL_MAX) &&
+            (pInstance->channel[channel].pRxBuffer == NULL)) {
+            pChannel = &(pInstance->channel[channel]);
+            errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pChannel->pRxBuffer = (char *) malloc(U_CMUX_CHANNEL_BUFFER_LENGTH_BYTES);
+            if (pChannel->pRxBuffer != NULL) {
+                pChannel->rxReadIndex = 0;
+                pChannel->rxWriteIndex = 0;
+                pChannel->rxBytesLost = 0;
+                pChannel->flowControlledOff = false;
+                errorCodeOrHandle = sendCommandWaitResponse(pInstance, channel,
+                                                            U_CMUX_FRAME_TYPE_SABM);
+                if (errorCodeOrHandle == 0) {
+                    pChannel->isOpen = true;
+                    // Tell the far end that we're ready
+                    value[0] = (char) ((channel << 2) | U_CMUX_CR | U_CMUX_EA);
+                    value[1] = (char) U_CMUX_V24_SIGNALS_OPEN;
+                    sendControlMessage(pInstance, U_CMUX_MESSAGE_TYPE_MSC, true,
+                                       value, sizeof(value));
+                    errorCodeOrHandle = U_CMUX_CHANNEL_HANDLE(cmuxHandle, channel);
+                } else {
+                    free(pChannel->pRxBuffer);
+                    pChannel->pRxBuffer = NULL;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCodeOrHandle;
+}
+
+// Close a channel.
+void uCmuxChannelClose(int32_t channelHandle)
+{
+    uCmuxInstance_t *pInstance;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        if (pChannelGet(channelHandle, &pInstance) != NULL) {
+            channelClose(pInstance, (uint8_t) (channelHandle & 0xFF));
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+// Get the number of bytes waiting to be read from a channel.
+int32_t uCmuxChannelGetReceiveSize(int32_t channelHandle)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCmuxInstance_t *pInstance;
+    uCmuxChannel_t *pChannel;
+
+    if (gMutex != NULL) {
+        errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pChannel = pChannelGet(channelHandle, &pInstance);
+        if (pChannel != NULL) {
+            U_PORT_MUTEX_LOCK(pInstance->rxMutex);
+            errorCodeOrSize = (int32_t) pChannel->rxWriteIndex - (int32_t) pChannel->rxReadIndex;
+            if (errorCodeOrSize < 0) {
+                errorCodeOrSize += U_CMUX_CHANNEL_BUFFER_LENGTH_BYTES;
+            }
+            U_PORT_MUTEX_UNLOCK(pInstance->rxMutex);
+        }
+    }
+
+    return errorCodeOrSize;
+}
+
+// Read from a channel.
+int32_t uCmuxChannelRead(int32_t channelHandle, void *pBuffer,
+                         size_t sizeBytes)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCmuxInstance_t *pInstance;
+    uCmuxChannel_t *pChannel;
+    size_t length = 0;
+    size_t x;
+
+    if (gMutex != NULL) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pChannel = pChannelGet(channelHandle, &pInstance);
+        if ((pChannel != NULL) && (pBuffer != NULL)) {
+            U_PORT_MUTEX_LOCK(pInstance->rxMutex);
+            if (pChannel->pRxBuffer != NULL) {
+                // Copy out in up to two chunks, to the end of the
+                // ring and then from the start
+                while ((length < sizeBytes) &&
+                       (pChannel->rxReadIndex != pChannel->rxWriteIndex)) {
+                    if (pChannel->rxWriteIndex > pChannel->rxReadIndex) {
+                        x = pChannel->rxWriteIndex - pChannel->rxReadIndex;
+                    } else {
+                        x = U_CMUX_CHANNEL_BUFFER_LENGTH_BYTES - pChannel->rxReadIndex;
+                    }
+                    if (x > sizeBytes - length) {
+                        x = sizeBytes - length;
+                    }
+                    memcpy(((char *) pBuffer) + length,
+                           pChannel->pRxBuffer + pChannel->rxReadIndex, x);
+                    length += x;
+                    pChannel->rxReadIndex += x;
+                    if (pChannel->rxReadIndex >= U_CMUX_CHANNEL_BUFFER_LENGTH_BYTES) {
+                        pChannel->rxReadIndex = 0;
+                    }
+                }
+            }
+            U_PORT_MUTEX_UNLOCK(pInstance->rxMutex);
+            errorCodeOrLength = (int32_t) length;
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// Write to a channel.
+int32_t uCmuxChannelWrite(int32_t channelHandle, const void *pBuffer,
+                          size_t sizeBytes)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCmuxInstance_t *pInstance;
+    uCmuxChannel_t *pChannel;
+    size_t written = 0;
+    size_t x;
+    int32_t startTimeMs;
+
+    if (gMutex != NULL) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pChannel = pChannelGet(channelHandle, &pInstance);
+        if ((pChannel != NULL) && pChannel->isOpen &&
+            ((pBuffer != NULL) || (sizeBytes == 0))) {
+            errorCodeOrLength = 0;
+            startTimeMs = uPortGetTickTimeMs();
+            while ((written < sizeBytes) && (errorCodeOrLength >= 0) &&
+                   (uPortGetTickTimeMs() - startTimeMs < U_CMUX_WRITE_TIMEOUT_MS)) {
+                if (pInstance->flowControlledOff || pChannel->flowControlledOff) {
+                    // Wait for the far end to let us send again
+                    uPortTaskBlock(10);
+                } else {
+                    x = sizeBytes - written;
+                    if (x > pInstance->informationMaxLength) {
+                        x = pInstance->informationMaxLength;
+                    }
+                    errorCodeOrLength = sendFrame(pInstance, (uint8_t) (channelHandle & 0xFF),
+                                                  true, U_CMUX_FRAME_TYPE_UIH, false,
+                                                  ((const char *) pBuffer) + written, x);
+                    if (errorCodeOrLength >= 0) {
+                        written += x;
+                        startTimeMs = uPortGetTickTimeMs();
+                    }
+                }
+            }
+            if ((errorCodeOrLength >= 0) || (written > 0)) {
+                errorCodeOrLength = (int32_t) written;
+            }
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// Set an event callback for a channel.
+int32_t uCmuxChannelEventCallbackSet(int32_t channelHandle,
+                                     uint32_t filter,
+                                     void (*pFunction)(int32_t,
+                                                       uint32_t,
+                                                       void *),
+                                     void *pParam,
+                                     size_t stackSizeBytes,
+                                     int32_t priority)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCmuxChannel_t *pChannel;
+    char name[16];
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pChannel = pChannelGet(channelHandle, NULL);
+        if ((pChannel != NULL) && (pChannel->eventQueueHandle < 0) &&
+            (filter != 0) && (pFunction != NULL)) {
+            pChannel->eventFilter = filter;
+            pChannel->pEventCallback = pFunction;
+            pChannel->pEventCallbackParam = pParam;
+            snprintf(name, sizeof(name), "eventCmux%d", (int) channelHandle);
+            errorCode = uPortEventQueueOpen(channelEventHandler, name,
+                                            sizeof(uCmuxChannelEvent_t),
+                                            stackSizeBytes, priority,
+                                            U_CMUX_CHANNEL_EVENT_QUEUE_SIZE);
+            if (errorCode >= 0) {
+                pChannel->eventQueueHandle = errorCode;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            } else {
+                pChannel->eventFilter = 0;
+                pChannel->pEventCallback = NULL;
+                pChannel->pEventCallbackParam = NULL;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Remove the event callback of a channel.
+void uCmuxChannelEventCallbackRemove(int32_t channelHandle)
+{
+    uCmuxChannel_t *pChannel;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pChannel = pChannelGet(channelHandle, NULL);
+        if (pChannel != NULL) {
+            channelEventCallbackRemove(pChannel);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+// Send an event to the event callback of a channel.
+int32_t uCmuxChannelEventSend(int32_t channelHandle, uint32_t eventBitMap)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCmuxChannel_t *pChannel;
+    uCmuxChannelEvent_t event;
+
+    if (gMutex != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pChannel = pChannelGet(channelHandle, NULL);
+        if ((pChannel != NULL) && (pChannel->eventQueueHandle >= 0) &&
+            (eventBitMap != 0)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            if (uPortEventQueueGetFree(pChannel->eventQueueHandle) != 0) {
+                event.channelHandle = channelHandle;
+                event.eventBitmask = eventBitMap;
+                errorCode = uPortEventQueueSend(pChannel->eventQueueHandle,
+                                                &event, sizeof(event));
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Detect whether the current task is the event callback of a channel.
+bool uCmuxChannelEventIsCallback(int32_t channelHandle)
+{
+    bool isEventCallback = false;
+    uCmuxChannel_t *pChannel;
+
+    if (gMutex != NULL) {
+        pChannel = pChannelGet(channelHandle, NULL);
+        if ((pChannel != NULL) && (pChannel->eventQueueHandle >= 0)) {
+            isEventCallback = uPortEventQueueIsTask(pChannel->eventQueueHandle);
+        }
+    }
+
+    return isEventCallback;
+}
+
+// Get the stack high watermark of the event task of a channel.
+int32_t uCmuxChannelEventStackMinFree(int32_t channelHandle)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCmuxChannel_t *pChannel;
+
+    if (gMutex != NULL) {
+        errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pChannel = pChannelGet(channelHandle, NULL);
+        if ((pChannel != NULL) && (pChannel->eventQueueHandle >= 0)) {
+            errorCodeOrSize = uPortEventQueueStackMinFree(pChannel->eventQueueHandle);
+        }
+    }
+
+    return errorCodeOrSize;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: FRAME ENCODE/DECODE
+ * -------------------------------------------------------------- */
+
+// Encode a frame.
+int32_t uCmuxFrameEncode(uint8_t channel, bool commandResponse,
+                         uCmuxFrameType_t type, bool pollFinal,
+                         const char *pInformation, size_t informationLength,
+                         char *pBuffer, size_t bufferLength)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t headerLength = 3;
+    size_t fcsLength;
+    char *pTmp = pBuffer;
+
+    if (informationLength > 127) {
+        headerLength++;
+    }
+    if ((channel < 64) && frameTypeIsValid((uint8_t) type) &&
+        (informationLength <= 32767) &&
+        ((pInformation != NULL) || (informationLength == 0)) &&
+        (pBuffer != NULL) &&
+        (bufferLength >= headerLength + informationLength + 3)) {
+        *pTmp++ = (char) U_CMUX_FLAG;
+        *pTmp++ = (char) ((channel << 2) | (commandResponse ? U_CMUX_CR : 0) | U_CMUX_EA);
+        *pTmp++ = (char) (((uint8_t) type) | (pollFinal ? U_CMUX_PF : 0));
+        if (informationLength > 127) {
+            *pTmp++ = (char) ((informationLength & 0x7F) << 1);
+            *pTmp++ = (char) (informationLength >> 7);
+        } else {
+            *pTmp++ = (char) ((informationLength << 1) | U_CMUX_EA);
+        }
+        if (informationLength > 0) {
+            memcpy(pTmp, pInformation, informationLength);
+            pTmp += informationLength;
+        }
+        // The FCS covers the header except for UI frames,
+        // where it also covers the information field
+        fcsLength = headerLength;
+        if (type == U_CMUX_FRAME_TYPE_UI) {
+            fcsLength += informationLength;
+        }
+        *pTmp++ = (char) (0xFF - fcsCalculate(pBuffer + 1, fcsLength));
+        *pTmp++ = (char) U_CMUX_FLAG;
+        errorCodeOrLength = (int32_t) (pTmp - pBuffer);
+    }
+
+    return errorCodeOrLength;
+}
+
+// Decode a frame.
+int32_t uCmuxFrameDecode(const char *pBuffer, size_t length,
+                         uCmuxFrame_t *pFrame)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t headerLength = 3;
+    size_t informationLength;
+    size_t fcsLength;
+    uint8_t type;
+
+    if ((pBuffer != NULL) && (pFrame != NULL)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        if (length >= U_CMUX_FRAME_LENGTH_MIN_BYTES) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            type = (uint8_t) (((uint8_t) * (pBuffer + 2)) & ~U_CMUX_PF);
+            if ((*pBuffer == (char) U_CMUX_FLAG) &&
+                ((((uint8_t) * (pBuffer + 1)) & U_CMUX_EA) != 0) &&
+                frameTypeIsValid(type)) {
+                informationLength = ((uint8_t) * (pBuffer + 3)) >> 1;
+                if ((((uint8_t) * (pBuffer + 3)) & U_CMUX_EA) == 0) {
+                    // Two byte length
+                    headerLength++;
+                    informationLength |= ((size_t) (uint8_t) * (pBuffer + 4)) << 7;
+                }
+                errorCodeOrLength = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                if (length >= headerLength + informationLength + 3) {
+                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                    fcsLength = headerLength;
+                    if (type == (uint8_t) U_CMUX_FRAME_TYPE_UI) {
+                        fcsLength += informationLength;
+                    }
+                    if ((fcsLength == headerLength) && (informationLength > 0)) {
+                        // Need to check the FCS in two parts
+                        // as it is not contiguous with the header
+                        if ((fcsCalculate(pBuffer + 1, fcsLength) ^ 0xFF) ==
+                            (uint8_t) * (pBuffer + 1 + headerLength + informationLength)) {
+                            fcsLength = 0;
+                        }
+                    } else if (fcsCalculate(pBuffer + 1, fcsLength + 1) == U_CMUX_FCS_GOOD) {
+                        fcsLength = 0;
+                    }
+                    if ((fcsLength == 0) &&
+                        (*(pBuffer + headerLength + informationLength + 2) == (char) U_CMUX_FLAG)) {
+                        pFrame->channel = ((uint8_t) * (pBuffer + 1)) >> 2;
+                        pFrame->commandResponse = ((((uint8_t) * (pBuffer + 1)) & U_CMUX_CR) != 0);
+                        pFrame->type = (uCmuxFrameType_t) type;
+                        pFrame->pollFinal = ((((uint8_t) * (pBuffer + 2)) & U_CMUX_PF) != 0);
+                        pFrame->pInformation = pBuffer + 1 + headerLength;
+                        pFrame->informationLength = informationLength;
+                        errorCodeOrLength = (int32_t) (headerLength + informationLength + 3);
+                    }
+                }
+            }
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// End of file
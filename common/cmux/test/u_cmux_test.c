@@ -0,0 +1,214 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the CMUX API: these should pass on all platforms.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcmp()/memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+
+#include "u_cmux.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_CMUX_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_CMUX_TEST_MAX_INFORMATION_SIZE
+/** The maximum information field size to test with; more than
+ * 127 so that the two-byte length field is exercised.
+ */
+# define U_CMUX_TEST_MAX_INFORMATION_SIZE 300
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** A SABM frame, poll bit set, for the control channel, as
+ * given in 3GPP 27.010.
+ */
+static const char gSabmControlChannel[] = {(char) 0xF9, 0x03, 0x3F, 0x01, 0x1C, (char) 0xF9};
+
+/** A UIH frame for channel 1 carrying "AT\r", as a module
+ * would receive it from us.
+ */
+static const char gUihAt[] = {(char) 0xF9, 0x07, (char) 0xEF, 0x07, 'A', 'T', '\r',
+                              (char) 0xD3, (char) 0xF9
+                             };
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test the CMUX frame encoder/decoder against known frames
+ * and back-to-back.
+ */
+U_PORT_TEST_FUNCTION("[cmux]", "cmuxFrame")
+{
+    char buffer[16];
+    char *pInformationIn;
+    char *pBuffer;
+    uCmuxFrame_t frame;
+    size_t bufferLength = U_CMUX_TEST_MAX_INFORMATION_SIZE + U_CMUX_FRAME_OVERHEAD_MAX_BYTES;
+    size_t overhead;
+    int32_t x;
+
+    // Known frames
+    U_PORT_TEST_ASSERT(uCmuxFrameEncode(0, true, U_CMUX_FRAME_TYPE_SABM, true,
+                                        NULL, 0, buffer,
+                                        sizeof(buffer)) == sizeof(gSabmControlChannel));
+    U_PORT_TEST_ASSERT(memcmp(buffer, gSabmControlChannel, sizeof(gSabmControlChannel)) == 0);
+    U_PORT_TEST_ASSERT(uCmuxFrameEncode(1, true, U_CMUX_FRAME_TYPE_UIH, false,
+                                        "AT\r", 3, buffer,
+                                        sizeof(buffer)) == sizeof(gUihAt));
+    U_PORT_TEST_ASSERT(memcmp(buffer, gUihAt, sizeof(gUihAt)) == 0);
+    memset(&frame, 0, sizeof(frame));
+    U_PORT_TEST_ASSERT(uCmuxFrameDecode(gUihAt, sizeof(gUihAt), &frame) == sizeof(gUihAt));
+    U_PORT_TEST_ASSERT(frame.channel == 1);
+    U_PORT_TEST_ASSERT(frame.commandResponse);
+    U_PORT_TEST_ASSERT(frame.type == U_CMUX_FRAME_TYPE_UIH);
+    U_PORT_TEST_ASSERT(!frame.pollFinal);
+    U_PORT_TEST_ASSERT(frame.informationLength == 3);
+    U_PORT_TEST_ASSERT(frame.pInformation == gUihAt + 4);
+
+    // Incomplete frames should ask for more, corrupt ones be rejected
+    for (size_t y = 0; y < sizeof(gUihAt); y++) {
+        U_PORT_TEST_ASSERT(uCmuxFrameDecode(gUihAt, y, &frame) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+    }
+    memcpy(buffer, gUihAt, sizeof(gUihAt));
+    buffer[7]++;
+    U_PORT_TEST_ASSERT(uCmuxFrameDecode(buffer, sizeof(gUihAt),
+                                        &frame) == (int32_t) U_ERROR_COMMON_NOT_FOUND);
+    // Too small an output buffer
+    U_PORT_TEST_ASSERT(uCmuxFrameEncode(1, true, U_CMUX_FRAME_TYPE_UIH, false,
+                                        "AT\r", 3, buffer,
+                                        sizeof(gUihAt) - 1) < 0);
+
+    pInformationIn = (char *) malloc(U_CMUX_TEST_MAX_INFORMATION_SIZE);
+    U_PORT_TEST_ASSERT(pInformationIn != NULL);
+    pBuffer = (char *) malloc(bufferLength);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+
+    // Back to back, UIH and UI (where the FCS covers the
+    // information field also)
+    for (size_t y = 0; y < U_CMUX_TEST_MAX_INFORMATION_SIZE; y += 7) {
+        for (size_t z = 0; z < y; z++) {
+            //lint -e(613) Suppress possible nullness in pInformationIn, it is checked above
+            *(pInformationIn + z) = (char) (z + y);
+        }
+        overhead = 6;
+        if (y > 127) {
+            overhead++;
+        }
+        for (size_t t = 0; t < 2; t++) {
+            x = uCmuxFrameEncode((uint8_t) (y % (U_CMUX_CHANNEL_MAX + 1)), (t == 0),
+                                 t == 0 ? U_CMUX_FRAME_TYPE_UIH : U_CMUX_FRAME_TYPE_UI,
+                                 (t != 0), pInformationIn, y, pBuffer, bufferLength);
+            U_PORT_TEST_ASSERT(x == (int32_t) (y + overhead));
+            memset(&frame, 0, sizeof(frame));
+            U_PORT_TEST_ASSERT(uCmuxFrameDecode(pBuffer, x, &frame) == x);
+            U_PORT_TEST_ASSERT(frame.channel == y % (U_CMUX_CHANNEL_MAX + 1));
+            U_PORT_TEST_ASSERT(frame.commandResponse == (t == 0));
+            U_PORT_TEST_ASSERT(frame.type == (t == 0 ? U_CMUX_FRAME_TYPE_UIH : U_CMUX_FRAME_TYPE_UI));
+            U_PORT_TEST_ASSERT(frame.pollFinal == (t != 0));
+            U_PORT_TEST_ASSERT(frame.informationLength == y);
+            U_PORT_TEST_ASSERT(memcmp(frame.pInformation, pInformationIn, y) == 0);
+            if ((t != 0) && (y > 0)) {
+                // Corrupting the information of a UI frame must be spotted
+                (*(pBuffer + x - 3))++;
+                U_PORT_TEST_ASSERT(uCmuxFrameDecode(pBuffer, x, &frame) < 0);
+            }
+        }
+    }
+
+    // Free memory
+    free(pInformationIn);
+    free(pBuffer);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[cmux]", "cmuxCleanUp")
+{
+    int32_t x;
+
+    uCmuxDeinit();
+
+    x = uPortTaskStackMinFree(NULL);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("main task stack had a minimum of %d byte(s)"
+                          " free at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_OS_MAIN_TASK_MIN_FREE_STACK_BYTES);
+    }
+
+    uPortDeinit();
+
+    x = uPortGetHeapMinFree();
+    if (x >= 0) {
+        U_TEST_PRINT_LINE("heap had a minimum of %d byte(s) free"
+                          " at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_HEAP_MIN_FREE_BYTES);
+    }
+}
+
+// End of file
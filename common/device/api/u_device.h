@@ -41,15 +41,51 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_DEVICE_OPEN_ASYNC_TASK_STACK_SIZE_BYTES
+/** The stack size of the task in which uDeviceOpenStart() brings
+ * a device up; the AT client of a cellular or short-range module
+ * is run from this task while it is powered on.
+ */
+# define U_DEVICE_OPEN_ASYNC_TASK_STACK_SIZE_BYTES (1024 * 3)
+#endif
+
+#ifndef U_DEVICE_OPEN_ASYNC_TASK_PRIORITY
+/** The priority of the task in which uDeviceOpenStart() brings
+ * a device up.
+ */
+# define U_DEVICE_OPEN_ASYNC_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
 /** The u-blox device handle; this is intended to be anonymous,
- * the contents should never be referenced by the application.
+ * the contents should never be referenced by the application.  It
+ * is not a pointer: it encodes the index of the device in a table
+ * along with a generation count, so that a handle that has been
+ * closed is reliably rejected and never dereferenced.
  */
 typedef void *uDeviceHandle_t;
 
+/** The handle of an open begun with uDeviceOpenStart(), which
+ * remains valid until it is passed to uDeviceOpenWait() and the
+ * open has completed.
+ */
+typedef void *uDeviceOpenAsyncHandle_t;
+
+/** The callback that may be given to uDeviceOpenStart(), called
+ * when the open has completed.
+ *
+ * @param devHandle       the handle of the device, NULL if the
+ *                        open failed.
+ * @param errorCode       zero on success else a negative error code.
+ * @param pCallbackParam  the parameter given to uDeviceOpenStart().
+ */
+typedef void (*uDeviceOpenCallback_t)(uDeviceHandle_t devHandle,
+                                      int32_t errorCode,
+                                      void *pCallbackParam);
+
 /** Device types.
  */
 typedef enum {
@@ -123,6 +159,23 @@ typedef struct {
        against it might and with the clause"; if this
        field is populated then the version field of
        this structure must be set to 1 or higher". */
+    int32_t baudRateMax;      /**< Set this to the highest baud rate that
+                                   the UART of this MCU can manage (e.g.
+                                   921600) to have uDeviceOpen(), once it
+                                   has reached a cellular or short-range
+                                   module at baudRate, move the UART up
+                                   to the highest of 230400, 460800,
+                                   921600 or 3000000 that both ends
+                                   support, checking that the module still
+                                   responds and falling back to the lower
+                                   rate if it does not; the rate reached
+                                   is remembered and tried first the next
+                                   time.  The module is always left at
+                                   baudRate when uDeviceClose() powers it
+                                   off.  Leave at zero for no ramp-up.  If
+                                   this field is populated then the version
+                                   field of this structure must be set to
+                                   1 or higher. */
 } uDeviceCfgUart_t;
 
 /** I2C transport configuration.
@@ -245,6 +298,31 @@ typedef struct {
        against it might end with the clause "; if this
        field is populated then the version field of
        this structure must be set to 1 or higher". */
+    size_t ringBufferLengthBytes;      /**< The length of the ring buffer used
+                                            with a streaming transport, see
+                                            #uGnssBufferCfg_t; 0 for the
+                                            default.  If this field, or any
+                                            of the three below, is populated
+                                            then the version field of this
+                                            structure must be set to 1 or
+                                            higher. */
+    char *pRingBuffer;                 /**< Storage for the ring buffer, NULL
+                                            to have it allocated; if this field
+                                            is populated then the version field
+                                            of this structure must be set to 1
+                                            or higher. */
+    size_t temporaryBufferLengthBytes; /**< The length of the temporary buffer
+                                            used with a streaming transport, 0
+                                            for the default; if this field is
+                                            populated then the version field of
+                                            this structure must be set to 1 or
+                                            higher. */
+    char *pTemporaryBuffer;            /**< Storage for the temporary buffer,
+                                            NULL to have it allocated; if this
+                                            field is populated then the version
+                                            field of this structure must be set
+                                            to 1 or higher. */
+    /* This is the end of version 1 of this structure. */
 } uDeviceCfgGnss_t;
 
 /** Short-range device configuration.
@@ -344,6 +422,60 @@ int32_t uDeviceGetDefaults(uDeviceType_t deviceType,
 int32_t uDeviceOpen(const uDeviceCfg_t *pDeviceCfg,
                     uDeviceHandle_t *pDeviceHandle);
 
+/** Begin opening a device instance, returning at once: the
+ * device is powered-up in a task of its own, so that, for example,
+ * a cellular module, a GNSS chip and a Wi-Fi module may be opened
+ * at the same time and the time to open them all is that of the
+ * slowest rather than the sum of the three.  Devices of the same
+ * type share an API and so are still brought up one after the
+ * other, as are all devices with an I2C transport, since the
+ * I2C buses are shared.
+ *
+ * Every open that is begun successfully must be completed by a
+ * call to uDeviceOpenWait(), which releases the open handle and
+ * returns the device handle.  uDeviceDeinit() must not be called
+ * while an open is pending.
+ *
+ * @param[in] pDeviceCfg      device configuration, cannot be NULL;
+ *                            this is copied but anything it points
+ *                            to, e.g. a SIM PIN code, must remain
+ *                            valid until the open has completed.
+ * @param[in] pCallback       a callback to be called, in the task
+ *                            that brings the device up, when the
+ *                            open has completed; may be NULL.
+ * @param[in] pCallbackParam  a parameter that will be passed to
+ *                            pCallback; may be NULL.
+ * @param[out] pOpenHandle    a place to put the handle of the open;
+ *                            cannot be NULL.
+ * @return                    zero on success else a negative error
+ *                            code.
+ */
+int32_t uDeviceOpenStart(const uDeviceCfg_t *pDeviceCfg,
+                         uDeviceOpenCallback_t pCallback,
+                         void *pCallbackParam,
+                         uDeviceOpenAsyncHandle_t *pOpenHandle);
+
+/** Wait for an open begun with uDeviceOpenStart() to complete.
+ * If the open completes within the time given the open handle is
+ * released and the outcome of the open is returned, else
+ * #U_ERROR_COMMON_TIMEOUT is returned and the open handle remains
+ * valid, so that this function may be called again.
+ *
+ * @param openHandle          the handle returned by uDeviceOpenStart().
+ * @param[out] pDeviceHandle  a place to put the device handle; may
+ *                            be NULL if the callback of
+ *                            uDeviceOpenStart() is used instead.
+ * @param timeoutMs           the time to wait in milliseconds;
+ *                            use a negative value to wait for ever.
+ * @return                    zero on success, #U_ERROR_COMMON_TIMEOUT
+ *                            if the open has not yet completed,
+ *                            else the negative error code with
+ *                            which the open failed.
+ */
+int32_t uDeviceOpenWait(uDeviceOpenAsyncHandle_t openHandle,
+                        uDeviceHandle_t *pDeviceHandle,
+                        int32_t timeoutMs);
+
 /** Close an open device instance, optionally powering it down.
  *
  * @param devHandle handle to a previously opened device.
@@ -25,10 +25,15 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"   //
+#include "stdlib.h"    // malloc(), free()
+#include "string.h"    // memset()
+
+#include "u_cfg_os_platform_specific.h" // For U_CFG_OS_APP_TASK_PRIORITY
 
 #include "u_error_common.h"
 
 #include "u_port_os.h"
+#include "u_port_heap.h"
 
 #include "u_device.h"
 #include "u_device_shared.h"
@@ -59,14 +64,142 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The context of an open begun with uDeviceOpenStart(); this is
+ * what a uDeviceOpenAsyncHandle_t points to.
+ */
+typedef struct {
+    uDeviceCfg_t deviceCfg;
+    uDeviceOpenCallback_t pCallback;
+    void *pCallbackParam;
+    uPortSemaphoreHandle_t doneSemaphore;
+    uDeviceHandle_t devHandle;
+    int32_t errorCode;
+} uDeviceOpenAsync_t;
+
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
+#ifdef U_CFG_HEAP_TRACKER
+/** The heap tags that should have nothing outstanding once
+ * uDeviceDeinit() has been called.
+ */
+static const uPortHeapTag_t gDeinitHeapTags[] = {U_PORT_HEAP_TAG_DEVICE,
+                                                 U_PORT_HEAP_TAG_LOCATION,
+                                                 U_PORT_HEAP_TAG_CELL,
+                                                 U_PORT_HEAP_TAG_GNSS,
+                                                 U_PORT_HEAP_TAG_SHORT_RANGE,
+                                                 U_PORT_HEAP_TAG_WIFI,
+                                                 U_PORT_HEAP_TAG_BLE
+                                                };
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+#ifdef U_CFG_HEAP_TRACKER
+// Report what is still allocated for a device type; since other
+// devices of the same type may still be open this is only a hint.
+static void heapReport(int32_t deviceType)
+{
+    switch (deviceType) {
+        case U_DEVICE_TYPE_CELL:
+            uPortHeapPrintOutstanding(U_PORT_HEAP_TAG_CELL);
+            break;
+        case U_DEVICE_TYPE_GNSS:
+            uPortHeapPrintOutstanding(U_PORT_HEAP_TAG_GNSS);
+            break;
+        case U_DEVICE_TYPE_SHORT_RANGE:
+        case U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU:
+            uPortHeapPrintOutstanding(U_PORT_HEAP_TAG_SHORT_RANGE);
+            uPortHeapPrintOutstanding(U_PORT_HEAP_TAG_WIFI);
+            uPortHeapPrintOutstanding(U_PORT_HEAP_TAG_BLE);
+            break;
+        default:
+            break;
+    }
+}
+#endif
+
+// Add a device of the configured type: this is where the device
+// is powered-up, the device API lock is NOT taken here.
+static int32_t addDevice(const uDeviceCfg_t *pDeviceCfg,
+                         uDeviceHandle_t *pDeviceHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    switch (pDeviceCfg->deviceType) {
+        case U_DEVICE_TYPE_CELL:
+            errorCode = uDevicePrivateCellAdd(pDeviceCfg, pDeviceHandle);
+            if (errorCode == 0) {
+                U_DEVICE_INSTANCE(*pDeviceHandle)->moduleType = pDeviceCfg->deviceCfg.cfgCell.moduleType;
+            }
+            break;
+        case U_DEVICE_TYPE_GNSS:
+            errorCode = uDevicePrivateGnssAdd(pDeviceCfg, pDeviceHandle);
+            if (errorCode == 0) {
+                U_DEVICE_INSTANCE(*pDeviceHandle)->moduleType = pDeviceCfg->deviceCfg.cfgGnss.moduleType;
+            }
+            break;
+        case U_DEVICE_TYPE_SHORT_RANGE:
+            errorCode = uDevicePrivateShortRangeAdd(pDeviceCfg, pDeviceHandle);
+            if (errorCode == 0) {
+                U_DEVICE_INSTANCE(*pDeviceHandle)->moduleType = pDeviceCfg->deviceCfg.cfgSho.moduleType;
+            }
+            break;
+        case U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU:
+            errorCode = uDevicePrivateShortRangeOpenCpuAdd(pDeviceCfg, pDeviceHandle);
+            if (errorCode == 0) {
+                U_DEVICE_INSTANCE(*pDeviceHandle)->moduleType = pDeviceCfg->deviceCfg.cfgSho.moduleType;
+            }
+            break;
+        default:
+            break;
+    }
+
+    return errorCode;
+}
+
+// The task in which an open begun with uDeviceOpenStart() is done.
+static void openAsyncTask(void *pParameter)
+{
+    uDeviceOpenAsync_t *pOpenAsync = (uDeviceOpenAsync_t *) pParameter;
+    // The cellular, GNSS and short-range APIs each have a mutex of
+    // their own, which is sufficient to protect a power-up, and
+    // so the device API lock is only needed for I2C, where the
+    // table of I2C buses in u_device_private.c is shared
+    bool lockNeeded = (pOpenAsync->deviceCfg.transportType == U_DEVICE_TRANSPORT_TYPE_I2C);
+    uDeviceHandle_t devHandle = NULL;
+    int32_t errorCode = 0;
+
+    if (lockNeeded) {
+        errorCode = uDeviceLock();
+    }
+    if (errorCode == 0) {
+        errorCode = addDevice(&(pOpenAsync->deviceCfg), &devHandle);
+        if (lockNeeded) {
+            uDeviceUnlock();
+        }
+    }
+    if (errorCode != 0) {
+        devHandle = NULL;
+    }
+
+    pOpenAsync->devHandle = devHandle;
+    pOpenAsync->errorCode = errorCode;
+    if (pOpenAsync->pCallback != NULL) {
+        pOpenAsync->pCallback(devHandle, errorCode, pOpenAsync->pCallbackParam);
+    }
+
+    // Let uDeviceOpenWait() know that we're done: pOpenAsync
+    // must not be touched after this point as it may be freed
+    uPortSemaphoreGive(pOpenAsync->doneSemaphore);
+
+    // Delete ourselves
+    uPortTaskDelete(NULL);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -147,6 +280,12 @@ int32_t uDeviceDeinit()
     uDevicePrivateCellDeinit();
     uDeviceMutexDestroy();
     uDeviceCallback("deinit", NULL, NULL);
+#ifdef U_CFG_HEAP_TRACKER
+    // Leak report
+    for (size_t x = 0; x < sizeof(gDeinitHeapTags) / sizeof(gDeinitHeapTags[0]); x++) {
+        uPortHeapPrintOutstanding(gDeinitHeapTags[x]);
+    }
+#endif
     return (int32_t) U_ERROR_COMMON_SUCCESS;
 }
 
@@ -246,38 +385,93 @@ int32_t uDeviceOpen(const uDeviceCfg_t *pDeviceCfg, uDeviceHandle_t *pDeviceHand
     if (errorCode == 0) {
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pDeviceCfg != NULL) && (pDeviceCfg->version == 0) && (pDeviceHandle != NULL)) {
-            switch (pDeviceCfg->deviceType) {
-                case U_DEVICE_TYPE_CELL:
-                    errorCode = uDevicePrivateCellAdd(pDeviceCfg, pDeviceHandle);
-                    if (errorCode == 0) {
-                        U_DEVICE_INSTANCE(*pDeviceHandle)->moduleType = pDeviceCfg->deviceCfg.cfgCell.moduleType;
-                    }
-                    break;
-                case U_DEVICE_TYPE_GNSS:
-                    errorCode = uDevicePrivateGnssAdd(pDeviceCfg, pDeviceHandle);
-                    if (errorCode == 0) {
-                        U_DEVICE_INSTANCE(*pDeviceHandle)->moduleType = pDeviceCfg->deviceCfg.cfgGnss.moduleType;
-                    }
-                    break;
-                case U_DEVICE_TYPE_SHORT_RANGE:
-                    errorCode = uDevicePrivateShortRangeAdd(pDeviceCfg, pDeviceHandle);
-                    if (errorCode == 0) {
-                        U_DEVICE_INSTANCE(*pDeviceHandle)->moduleType = pDeviceCfg->deviceCfg.cfgSho.moduleType;
-                    }
-                    break;
-                case U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU:
-                    errorCode = uDevicePrivateShortRangeOpenCpuAdd(pDeviceCfg, pDeviceHandle);
+            errorCode = addDevice(pDeviceCfg, pDeviceHandle);
+        }
+
+        // ...and done
+        uDeviceUnlock();
+    }
+
+    return errorCode;
+}
+
+int32_t uDeviceOpenStart(const uDeviceCfg_t *pDeviceCfg,
+                         uDeviceOpenCallback_t pCallback,
+                         void *pCallbackParam,
+                         uDeviceOpenAsyncHandle_t *pOpenHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uDeviceOpenAsync_t *pOpenAsync;
+    uPortTaskHandle_t taskHandle;
+
+    if ((pDeviceCfg != NULL) && (pDeviceCfg->version == 0) &&
+        (pDeviceCfg->deviceType > U_DEVICE_TYPE_NONE) &&
+        (pDeviceCfg->deviceType < U_DEVICE_TYPE_MAX_NUM) &&
+        (pOpenHandle != NULL)) {
+        // The injection hook is called under the lock,
+        // exactly as it is for uDeviceOpen()
+        errorCode = uDeviceLock();
+        if (errorCode == 0) {
+            errorCode = uDeviceCallback("open", (void *)pDeviceCfg->deviceType, NULL);
+            uDeviceUnlock();
+        }
+        if (errorCode == 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pOpenAsync = (uDeviceOpenAsync_t *) malloc(sizeof(uDeviceOpenAsync_t));
+            if (pOpenAsync != NULL) {
+                memset(pOpenAsync, 0, sizeof(*pOpenAsync));
+                pOpenAsync->deviceCfg = *pDeviceCfg;
+                pOpenAsync->pCallback = pCallback;
+                pOpenAsync->pCallbackParam = pCallbackParam;
+                errorCode = uPortSemaphoreCreate(&(pOpenAsync->doneSemaphore), 0, 1);
+                if (errorCode == 0) {
+                    errorCode = uPortTaskCreate(openAsyncTask, "deviceOpen",
+                                                U_DEVICE_OPEN_ASYNC_TASK_STACK_SIZE_BYTES,
+                                                (void *) pOpenAsync,
+                                                U_DEVICE_OPEN_ASYNC_TASK_PRIORITY,
+                                                &taskHandle);
                     if (errorCode == 0) {
-                        U_DEVICE_INSTANCE(*pDeviceHandle)->moduleType = pDeviceCfg->deviceCfg.cfgSho.moduleType;
+                        *pOpenHandle = (uDeviceOpenAsyncHandle_t) pOpenAsync;
+                    } else {
+                        uPortSemaphoreDelete(pOpenAsync->doneSemaphore);
                     }
-                    break;
-                default:
-                    break;
+                }
+                if (errorCode != 0) {
+                    // Clean up on error
+                    free(pOpenAsync);
+                }
             }
         }
+    }
 
-        // ...and done
-        uDeviceUnlock();
+    return errorCode;
+}
+
+int32_t uDeviceOpenWait(uDeviceOpenAsyncHandle_t openHandle,
+                        uDeviceHandle_t *pDeviceHandle,
+                        int32_t timeoutMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uDeviceOpenAsync_t *pOpenAsync = (uDeviceOpenAsync_t *) openHandle;
+
+    if (pOpenAsync != NULL) {
+        if (timeoutMs < 0) {
+            errorCode = uPortSemaphoreTake(pOpenAsync->doneSemaphore);
+        } else {
+            errorCode = uPortSemaphoreTryTake(pOpenAsync->doneSemaphore, timeoutMs);
+        }
+        if (errorCode == 0) {
+            // The open task has finished with the context: take
+            // the outcome and free it
+            errorCode = pOpenAsync->errorCode;
+            if (pDeviceHandle != NULL) {
+                *pDeviceHandle = pOpenAsync->devHandle;
+            }
+            uPortSemaphoreDelete(pOpenAsync->doneSemaphore);
+            free(pOpenAsync);
+        } else {
+            errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        }
     }
 
     return errorCode;
@@ -287,9 +481,11 @@ int32_t uDeviceClose(uDeviceHandle_t devHandle, bool powerOff)
 {
     // Lock the API
     int32_t errorCode = uDeviceLock();
+    int32_t deviceType;
 
     if (errorCode == 0) {
-        switch (uDeviceGetDeviceType(devHandle)) {
+        deviceType = uDeviceGetDeviceType(devHandle);
+        switch (deviceType) {
             case U_DEVICE_TYPE_CELL:
                 errorCode = uDevicePrivateCellRemove(devHandle, powerOff);
                 break;
@@ -314,6 +510,9 @@ int32_t uDeviceClose(uDeviceHandle_t devHandle, bool powerOff)
         if (errorCode == 0) {
             errorCode = uDeviceCallback("close", (void *)(U_DEVICE_INSTANCE(devHandle)->deviceType),
                                         (void *)powerOff);
+#ifdef U_CFG_HEAP_TRACKER
+            heapReport(deviceType);
+#endif
         }
 
         // ...and done
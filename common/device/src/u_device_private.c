@@ -55,6 +55,13 @@
 # define U_DEVICE_PRIVATE_DEVICE_I2C_MAX_NUM 10
 #endif
 
+#ifndef U_DEVICE_PRIVATE_UART_BAUD_RATE_MAX_NUM
+/** The number of UARTs for which the outcome of a baud-rate
+ * ramp-up is remembered.
+ */
+# define U_DEVICE_PRIVATE_UART_BAUD_RATE_MAX_NUM 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -75,6 +82,16 @@ typedef struct {
     uDevicePrivateI2c_t *pI2c;
 } uDevicePrivateDeviceI2c_t;
 
+/** Type to hold what is known about the baud rate of a UART.
+ */
+typedef struct {
+    int32_t uart;
+    int32_t baudRateBest; /**< the highest baud rate that worked,
+                               zero if this entry is not in use. */
+    int32_t baudRateLeftAt; /**< the baud rate a module was left
+                                 powered-on at, zero if not known. */
+} uDevicePrivateUartBaudRate_t;
+
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
@@ -88,6 +105,17 @@ static uDevicePrivateI2c_t gI2c[U_DEVICE_PRIVATE_I2C_MAX_NUM];
  */
 static uDevicePrivateDeviceI2c_t gDeviceI2c[U_DEVICE_PRIVATE_DEVICE_I2C_MAX_NUM];
 
+/** The baud rates that a ramp-up tries, highest first.
+ */
+static const int32_t gUartBaudRateRamp[] = {3000000, 921600, 460800, 230400};
+
+/** Storage to remember the outcome of a baud-rate ramp-up per
+ * UART; deliberately not reset by uDevicePrivateInit() so that it
+ * survives the device layer being deinitialised and initialised
+ * again.
+ */
+static uDevicePrivateUartBaudRate_t gUartBaudRate[U_DEVICE_PRIVATE_UART_BAUD_RATE_MAX_NUM] = {0};
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -142,6 +170,24 @@ static void clearI2cEntry(uDevicePrivateI2c_t *pI2c)
     }
 }
 
+// Find the baud rate entry for a UART; returns NULL if not found,
+// use -1 to find the first unused entry.
+static uDevicePrivateUartBaudRate_t *pFindUartBaudRate(int32_t uart)
+{
+    uDevicePrivateUartBaudRate_t *pUartBaudRate = NULL;
+
+    for (size_t x = 0; (x < sizeof(gUartBaudRate) / sizeof(gUartBaudRate[0])) &&
+         (pUartBaudRate == NULL); x++) {
+        if (((uart < 0) && (gUartBaudRate[x].baudRateBest == 0)) ||
+            ((uart >= 0) && (gUartBaudRate[x].baudRateBest > 0) &&
+             (gUartBaudRate[x].uart == uart))) {
+            pUartBaudRate = &(gUartBaudRate[x]);
+        }
+    }
+
+    return pUartBaudRate;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -297,6 +343,77 @@ void uDevicePrivateI2cCloseCfgI2c(const uDeviceCfgI2c_t *pCfgI2c)
     }
 }
 
+// Get the baud rates that a ramp-up of a UART should try.
+size_t uDevicePrivateUartBaudRateRampGet(int32_t uart,
+                                         int32_t baudRateNow,
+                                         int32_t baudRateMax,
+                                         int32_t *pBaudRate,
+                                         size_t size)
+{
+    size_t count = 0;
+    uDevicePrivateUartBaudRate_t *pUartBaudRate = pFindUartBaudRate(uart);
+
+    if ((pUartBaudRate != NULL) && (count < size) &&
+        (pUartBaudRate->baudRateBest > baudRateNow) &&
+        (pUartBaudRate->baudRateBest <= baudRateMax)) {
+        // What worked last time goes first
+        *(pBaudRate + count) = pUartBaudRate->baudRateBest;
+        count++;
+    }
+    for (size_t x = 0; (x < sizeof(gUartBaudRateRamp) / sizeof(gUartBaudRateRamp[0])) &&
+         (count < size); x++) {
+        if ((gUartBaudRateRamp[x] > baudRateNow) &&
+            (gUartBaudRateRamp[x] <= baudRateMax) &&
+            ((count == 0) || (gUartBaudRateRamp[x] != *pBaudRate))) {
+            *(pBaudRate + count) = gUartBaudRateRamp[x];
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Remember the baud rate that a ramp-up of a UART achieved.
+void uDevicePrivateUartBaudRateBestSet(int32_t uart, int32_t baudRate)
+{
+    uDevicePrivateUartBaudRate_t *pUartBaudRate = pFindUartBaudRate(uart);
+
+    if ((pUartBaudRate == NULL) && (baudRate > 0)) {
+        pUartBaudRate = pFindUartBaudRate(-1);
+        if (pUartBaudRate != NULL) {
+            pUartBaudRate->uart = uart;
+            pUartBaudRate->baudRateLeftAt = 0;
+        }
+    }
+    if ((pUartBaudRate != NULL) && (baudRate >= 0)) {
+        // Zero frees the entry
+        pUartBaudRate->baudRateBest = baudRate;
+    }
+}
+
+// Remember the baud rate a module was left at.
+void uDevicePrivateUartBaudRateLeftAtSet(int32_t uart, int32_t baudRate)
+{
+    uDevicePrivateUartBaudRate_t *pUartBaudRate = pFindUartBaudRate(uart);
+
+    if (pUartBaudRate != NULL) {
+        pUartBaudRate->baudRateLeftAt = baudRate;
+    }
+}
+
+// Get the baud rate a module was left at.
+int32_t uDevicePrivateUartBaudRateLeftAtGet(int32_t uart)
+{
+    int32_t baudRate = 0;
+    uDevicePrivateUartBaudRate_t *pUartBaudRate = pFindUartBaudRate(uart);
+
+    if (pUartBaudRate != NULL) {
+        baudRate = pUartBaudRate->baudRateLeftAt;
+    }
+
+    return baudRate;
+}
+
 // Reset stuff in the device internals.
 void uDevicePrivateInit()
 {
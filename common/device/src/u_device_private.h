@@ -90,6 +90,62 @@ void uDevicePrivateI2cCloseDevHandle(uDeviceHandle_t devHandle);
  */
 void uDevicePrivateI2cCloseCfgI2c(const uDeviceCfgI2c_t *pCfgI2c);
 
+/** Get the baud rates that an automatic ramp-up of the baud rate of
+ * a UART should try, in order: the highest rate that worked for this
+ * UART before (see uDevicePrivateUartBaudRateBestSet()), if there is
+ * one, followed by the standard rates, highest first.  Only rates
+ * above baudRateNow and no higher than baudRateMax are included.
+ * The device API must be locked with a call to uDeviceLock() before
+ * this is called.
+ *
+ * @param uart          the UART HW block.
+ * @param baudRateNow   the baud rate currently in use.
+ * @param baudRateMax   the highest baud rate that may be used, the
+ *                      lower of that of the host UART and that of
+ *                      the module.
+ * @param[out] pBaudRate  a place to put the baud rates.
+ * @param size          the number of entries at pBaudRate.
+ * @return              the number of entries written to pBaudRate.
+ */
+size_t uDevicePrivateUartBaudRateRampGet(int32_t uart,
+                                         int32_t baudRateNow,
+                                         int32_t baudRateMax,
+                                         int32_t *pBaudRate,
+                                         size_t size);
+
+/** Remember the baud rate that an automatic ramp-up of the baud
+ * rate of a UART achieved, so that the next ramp-up may go straight
+ * to it.  The device API must be locked with a call to uDeviceLock()
+ * before this is called.
+ *
+ * @param uart      the UART HW block.
+ * @param baudRate  the baud rate; use zero to forget everything
+ *                  that is remembered about the UART.
+ */
+void uDevicePrivateUartBaudRateBestSet(int32_t uart, int32_t baudRate);
+
+/** Remember the baud rate that a module on the given UART has been
+ * left powered-on at when its device was closed, so that it can be
+ * found again when the device is next opened.  Has no effect if
+ * uDevicePrivateUartBaudRateBestSet() has not been called for the
+ * UART.  The device API must be locked with a call to uDeviceLock()
+ * before this is called.
+ *
+ * @param uart      the UART HW block.
+ * @param baudRate  the baud rate, zero if the module was powered off.
+ */
+void uDevicePrivateUartBaudRateLeftAtSet(int32_t uart, int32_t baudRate);
+
+/** Get the baud rate that a module on the given UART was left
+ * powered-on at, see uDevicePrivateUartBaudRateLeftAtSet().  The
+ * device API must be locked with a call to uDeviceLock() before
+ * this is called.
+ *
+ * @param uart  the UART HW block.
+ * @return      the baud rate, zero if not known.
+ */
+int32_t uDevicePrivateUartBaudRateLeftAtGet(int32_t uart);
+
 /** Initialise stuff in the device internals, should be called by
  * the device layer initialisation function.
  */
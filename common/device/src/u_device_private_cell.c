@@ -31,6 +31,7 @@
 #include "u_error_common.h"
 
 #include "u_port.h"
+#include "u_port_os.h"
 #include "u_port_uart.h"
 
 #include "u_device.h"
@@ -42,8 +43,12 @@
 #include "u_cell.h"
 #include "u_cell_net.h"
 #include "u_cell_pwr.h"
+#include "u_cell_cfg.h"
+
+#include "u_security_tls.h"
 
 #include "u_device_shared_cell.h"
+#include "u_device_private.h"
 #include "u_device_private_cell.h"
 
 /* ----------------------------------------------------------------
@@ -56,6 +61,33 @@
 # define U_DEVICE_PRIVATE_CELL_POWER_ON_GUARD_TIME_SECONDS 60
 #endif
 
+#ifndef U_DEVICE_PRIVATE_CELL_BAUD_RATE_MAX
+/** The highest baud rate that a baud-rate ramp-up will move a
+ * cellular module to; all of the supported modules manage this.
+ */
+# define U_DEVICE_PRIVATE_CELL_BAUD_RATE_MAX 921600
+#endif
+
+#ifndef U_DEVICE_PRIVATE_CELL_BAUD_RATE_SETTLE_TIME_MS
+/** How long to give a cellular module to switch to a new baud rate
+ * after it has responded "OK" to AT+IPR.
+ */
+# define U_DEVICE_PRIVATE_CELL_BAUD_RATE_SETTLE_TIME_MS 100
+#endif
+
+#ifndef U_DEVICE_PRIVATE_CELL_BAUD_RATE_PROBE_TRIES
+/** How many times to send "AT" when checking that a cellular
+ * module can be heard at a new baud rate.
+ */
+# define U_DEVICE_PRIVATE_CELL_BAUD_RATE_PROBE_TRIES 3
+#endif
+
+#ifndef U_DEVICE_PRIVATE_CELL_BAUD_RATE_PROBE_TIMEOUT_MS
+/** The AT timeout for each of the U_DEVICE_PRIVATE_CELL_BAUD_RATE_PROBE_TRIES.
+ */
+# define U_DEVICE_PRIVATE_CELL_BAUD_RATE_PROBE_TIMEOUT_MS 1000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -86,6 +118,110 @@ static bool keepGoingCallback(uDeviceHandle_t devHandle)
     return keepGoing;
 }
 
+// Re-open the UART of a cellular device at the given baud rate,
+// moving the AT client across to it.
+static int32_t uartReopen(uDeviceCellContext_t *pContext, int32_t baudRate)
+{
+    int32_t errorCode;
+    const uDeviceCfgUart_t *pCfgUart = &(pContext->cfgUart);
+
+    uAtClientLock(pContext->at);
+    // Detach the AT client before its UART goes away
+    uAtClientStreamSwitch(pContext->at, -1, U_AT_CLIENT_STREAM_TYPE_UART);
+    uPortUartClose(pContext->uart);
+    errorCode = uPortUartOpen(pCfgUart->uart,
+                              baudRate, NULL,
+                              U_CELL_UART_BUFFER_LENGTH_BYTES,
+                              pCfgUart->pinTxd,
+                              pCfgUart->pinRxd,
+                              pCfgUart->pinCts,
+                              pCfgUart->pinRts);
+    pContext->uart = errorCode;
+    if (errorCode >= 0) {
+        pContext->baudRate = baudRate;
+        errorCode = uAtClientStreamSwitch(pContext->at, pContext->uart,
+                                          U_AT_CLIENT_STREAM_TYPE_UART);
+    }
+    uAtClientUnlock(pContext->at);
+
+    return errorCode;
+}
+
+// Return true if the cellular module responds at the current
+// baud rate.
+static bool probe(uAtClientHandle_t atHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
+
+    for (size_t x = 0; (x < U_DEVICE_PRIVATE_CELL_BAUD_RATE_PROBE_TRIES) &&
+         (errorCode != 0); x++) {
+        uAtClientLock(atHandle);
+        uAtClientTimeoutSet(atHandle, U_DEVICE_PRIVATE_CELL_BAUD_RATE_PROBE_TIMEOUT_MS);
+        uAtClientCommandStart(atHandle, "AT");
+        uAtClientCommandStopReadResponse(atHandle);
+        errorCode = uAtClientUnlock(atHandle);
+    }
+
+    return (errorCode == 0);
+}
+
+// Move the cellular module and the UART to a new baud rate,
+// returning true if the module responds at the new rate.
+static bool baudRateSet(uDeviceHandle_t devHandle,
+                        uDeviceCellContext_t *pContext,
+                        int32_t baudRate)
+{
+    bool success = false;
+
+    if (uCellCfgSetBaudRate(devHandle, baudRate) == 0) {
+        uPortTaskBlock(U_DEVICE_PRIVATE_CELL_BAUD_RATE_SETTLE_TIME_MS);
+        success = (uartReopen(pContext, baudRate) >= 0) && probe(pContext->at);
+    }
+
+    return success;
+}
+
+// Take the UART of a cellular device up to the highest baud rate
+// that works; not getting there is not an error provided that the
+// module can still be heard at the baud rate it was at.
+static int32_t baudRateRamp(uDeviceHandle_t devHandle,
+                            uDeviceCellContext_t *pContext)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t baudRates[5];
+    int32_t baudRateMax = pContext->cfgUart.baudRateMax;
+    int32_t baudRateBefore;
+    size_t numBaudRates;
+    bool done = false;
+
+    if (baudRateMax > U_DEVICE_PRIVATE_CELL_BAUD_RATE_MAX) {
+        baudRateMax = U_DEVICE_PRIVATE_CELL_BAUD_RATE_MAX;
+    }
+    numBaudRates = uDevicePrivateUartBaudRateRampGet(pContext->cfgUart.uart,
+                                                     pContext->baudRate,
+                                                     baudRateMax, baudRates,
+                                                     sizeof(baudRates) / sizeof(baudRates[0]));
+    for (size_t x = 0; (x < numBaudRates) && !done && (errorCode == 0); x++) {
+        baudRateBefore = pContext->baudRate;
+        if (baudRateSet(devHandle, pContext, baudRates[x])) {
+            uDevicePrivateUartBaudRateBestSet(pContext->cfgUart.uart, baudRates[x]);
+            done = true;
+        } else if (pContext->baudRate != baudRateBefore) {
+            // The module accepted the new rate but can't be heard
+            // at it: ask it to go back, in case it can hear us even
+            // though we can't hear it, and follow it
+            uCellCfgSetBaudRate(devHandle, baudRateBefore);
+            uPortTaskBlock(U_DEVICE_PRIVATE_CELL_BAUD_RATE_SETTLE_TIME_MS);
+            if ((uartReopen(pContext, baudRateBefore) < 0) ||
+                !probe(pContext->at)) {
+                errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 // Do all the leg-work to remove a cellular device.
 static int32_t removeDevice(uDeviceHandle_t devHandle, bool powerOff)
 {
@@ -94,6 +230,13 @@ static int32_t removeDevice(uDeviceHandle_t devHandle, bool powerOff)
 
     if (pContext != NULL) {
         errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        powerOff = powerOff && (pContext->pinPwrOn >= 0);
+        if (powerOff && (pContext->baudRate != pContext->cfgUart.baudRate)) {
+            // Put the baud rate back to what will be expected at
+            // the next power-on, since some modules store it when
+            // powered off
+            baudRateSet(devHandle, pContext, pContext->cfgUart.baudRate);
+        }
         if (powerOff) {
             if (pContext->pinPwrOn >= 0) {
                 // Power off only if we have a pin that will let us power on again
@@ -109,6 +252,11 @@ static int32_t removeDevice(uDeviceHandle_t devHandle, bool powerOff)
             }
         }
         if (errorCode == 0) {
+            // Remember where the module was left, for next time
+            uDevicePrivateUartBaudRateLeftAtSet(pContext->cfgUart.uart,
+                                                powerOff ? 0 : pContext->baudRate);
+            // Any cached security profiles go with the device
+            uSecurityTlsCleanUpDevice(devHandle);
             // This will destroy the instance
             uCellRemove(devHandle);
             uAtClientRemove(pContext->at);
@@ -127,6 +275,7 @@ static int32_t addDevice(const uDeviceCfgUart_t *pCfgUart,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
     uDeviceCellContext_t *pContext;
+    int32_t baudRateLeftAt;
 
     pContext = (uDeviceCellContext_t *) malloc(sizeof(uDeviceCellContext_t));
     if (pContext != NULL) {
@@ -141,6 +290,12 @@ static int32_t addDevice(const uDeviceCfgUart_t *pCfgUart,
                                   pCfgUart->pinRts);
         if (errorCode >= 0) {
             pContext->uart = errorCode;
+            pContext->cfgUart = *pCfgUart;
+            if (pCfgUart->version < 1) {
+                // baudRateMax is not present
+                pContext->cfgUart.baudRateMax = 0;
+            }
+            pContext->baudRate = pCfgUart->baudRate;
             // Add an AT client on the UART with the recommended
             // default buffer size.
             errorCode = (int32_t) U_CELL_ERROR_AT;
@@ -173,11 +328,27 @@ static int32_t addDevice(const uDeviceCfgUart_t *pCfgUart,
                         errorCode = uCellPwrSetDtrPowerSavingPin(*pDeviceHandle,
                                                                  pCfgCell->pinDtrPowerSaving);
                     }
+                    baudRateLeftAt = 0;
+                    if (pContext->cfgUart.baudRateMax > 0) {
+                        baudRateLeftAt = uDevicePrivateUartBaudRateLeftAtGet(pCfgUart->uart);
+                    }
+                    if ((errorCode == 0) && (baudRateLeftAt > 0) &&
+                        (baudRateLeftAt != pContext->baudRate)) {
+                        // The module was left powered-on at a different
+                        // baud rate last time: see if it is still there
+                        if ((uartReopen(pContext, baudRateLeftAt) < 0) ||
+                            !probe(pContext->at)) {
+                            errorCode = uartReopen(pContext, pCfgUart->baudRate);
+                        }
+                    }
                     if (errorCode == 0) {
                         // Power on
                         errorCode = uCellPwrOn(*pDeviceHandle, pCfgCell->pSimPinCode,
                                                keepGoingCallback);
                     }
+                    if ((errorCode == 0) && (pContext->cfgUart.baudRateMax > 0)) {
+                        errorCode = baudRateRamp(*pDeviceHandle, pContext);
+                    }
                     if (errorCode != 0) {
                         // If we failed to power on, clean up
                         removeDevice(*pDeviceHandle, false);
@@ -106,6 +106,7 @@ static int32_t addDevice(int32_t transportHandle,
     uGnssTransportHandle_t gnssTransportHandle;
     uGnssTransportType_t gnssTransportType = U_GNSS_TRANSPORT_UART;
     uDeviceGnssInstance_t *pContext;
+    uGnssBufferCfg_t bufferCfg = {0};
 
     // Populate gnssTransportHandle/gnssTransportType
     if (transportType == U_DEVICE_TRANSPORT_TYPE_I2C) {
@@ -119,11 +120,17 @@ static int32_t addDevice(int32_t transportHandle,
     if (pContext != NULL) {
         pContext->transportHandle = transportHandle;
         pContext->transportType = transportType;
+        if (pCfgGnss->version >= 1) {
+            bufferCfg.ringBufferLengthBytes = pCfgGnss->ringBufferLengthBytes;
+            bufferCfg.pRingBuffer = pCfgGnss->pRingBuffer;
+            bufferCfg.temporaryBufferLengthBytes = pCfgGnss->temporaryBufferLengthBytes;
+            bufferCfg.pTemporaryBuffer = pCfgGnss->pTemporaryBuffer;
+        }
         // Add the GNSS instance, which actually creates pDeviceHandle
-        errorCode = uGnssAdd((uGnssModuleType_t) pCfgGnss->moduleType,
-                             gnssTransportType, gnssTransportHandle,
-                             pCfgGnss->pinEnablePower, false,
-                             pDeviceHandle);
+        errorCode = uGnssAddWithBuffers((uGnssModuleType_t) pCfgGnss->moduleType,
+                                        gnssTransportType, gnssTransportHandle,
+                                        pCfgGnss->pinEnablePower, false,
+                                        &bufferCfg, pDeviceHandle);
         if (errorCode == 0) {
             if (pCfgGnss->i2cAddress > 0) {
                 uGnssSetI2cAddress(*pDeviceHandle, pCfgGnss->i2cAddress);
@@ -179,7 +186,7 @@ int32_t uDevicePrivateGnssAdd(const uDeviceCfg_t *pDevCfg,
 
     if ((pDevCfg != NULL) && (pDeviceHandle != NULL)) {
         pCfgGnss = &(pDevCfg->deviceCfg.cfgGnss);
-        if (pCfgGnss->version == 0) {
+        if ((pCfgGnss->version >= 0) && (pCfgGnss->version <= 1)) {
             switch (pDevCfg->transportType) {
                 case U_DEVICE_TRANSPORT_TYPE_UART:
                     pCfgUart = &(pDevCfg->transportCfg.cfgUart);
@@ -43,12 +43,28 @@
 #include "u_ble.h"
 
 #include "u_device_shared_short_range.h"
+#include "u_device_private.h"
 #include "u_device_private_short_range.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX
+/** The highest baud rate that a baud-rate ramp-up will move a
+ * short-range module to, except for NINA-W1, see
+ * U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX_NINA_W1.
+ */
+# define U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX 921600
+#endif
+
+#ifndef U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX_NINA_W1
+/** The highest baud rate that a baud-rate ramp-up will move a
+ * NINA-W1 module to.
+ */
+# define U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX_NINA_W1 3000000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -61,6 +77,55 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Take the UART of a short-range device up to the highest baud rate
+// that works; not getting there is not an error provided that the
+// module can still be reached at the baud rate it was at.
+static int32_t baudRateRamp(int32_t moduleType, int32_t baudRateMax,
+                            uShortRangeUartConfig_t *pUartCfg,
+                            uDeviceHandle_t *pDeviceHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t baudRates[5];
+    int32_t baudRateBefore = pUartCfg->baudRate;
+    size_t numBaudRates;
+    bool done = false;
+
+    if ((moduleType == U_SHORT_RANGE_MODULE_TYPE_NINA_W13) ||
+        (moduleType == U_SHORT_RANGE_MODULE_TYPE_NINA_W15)) {
+        if (baudRateMax > U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX_NINA_W1) {
+            baudRateMax = U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX_NINA_W1;
+        }
+    } else if (baudRateMax > U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX) {
+        baudRateMax = U_DEVICE_PRIVATE_SHORT_RANGE_BAUD_RATE_MAX;
+    }
+    numBaudRates = uDevicePrivateUartBaudRateRampGet(pUartCfg->uartPort,
+                                                     baudRateBefore,
+                                                     baudRateMax, baudRates,
+                                                     sizeof(baudRates) / sizeof(baudRates[0]));
+    for (size_t x = 0; (x < numBaudRates) && !done && (errorCode == 0); x++) {
+        pUartCfg->baudRate = baudRates[x];
+        // This re-opens the device, checking that the module
+        // responds, and updates the device handle
+        if (uShortRangeSetBaudrate(pDeviceHandle, pUartCfg) == 0) {
+            uDevicePrivateUartBaudRateBestSet(pUartCfg->uartPort, baudRates[x]);
+            done = true;
+        } else {
+            pUartCfg->baudRate = baudRateBefore;
+            if (uShortRangeGetUartHandle(*pDeviceHandle) < 0) {
+                // The device was closed on the way: the module may or
+                // may not have moved, try to find it where it was
+                errorCode = uShortRangeOpenUart(moduleType, pUartCfg,
+                                                false, pDeviceHandle);
+                if (errorCode != 0) {
+                    errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -99,6 +164,8 @@ int32_t uDevicePrivateShortRangeAdd(const uDeviceCfg_t *pDevCfg,
     const uDeviceCfgUart_t *pCfgUart;
     const uDeviceCfgShortRange_t *pCfgSho;
     uShortRangeUartConfig_t uartCfg;
+    int32_t baudRateMax = 0;
+    int32_t baudRateLeftAt = 0;
 
     if ((pDevCfg != NULL) &&
         (pDevCfg->transportType == U_DEVICE_TRANSPORT_TYPE_UART) &&
@@ -112,9 +179,33 @@ int32_t uDevicePrivateShortRangeAdd(const uDeviceCfg_t *pDevCfg,
             uartCfg.pinRx = pCfgUart->pinRxd;
             uartCfg.pinCts = pCfgUart->pinCts;
             uartCfg.pinRts = pCfgUart->pinRts;
-            // Open the short range UART, which creates pDeviceHandle
-            errorCode = uShortRangeOpenUart(pCfgSho->moduleType, &uartCfg,
-                                            false, pDeviceHandle);
+            if (pCfgUart->version >= 1) {
+                baudRateMax = pCfgUart->baudRateMax;
+            }
+            if (baudRateMax > 0) {
+                baudRateLeftAt = uDevicePrivateUartBaudRateLeftAtGet(pCfgUart->uart);
+            }
+            errorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
+            if ((baudRateLeftAt > 0) && (baudRateLeftAt != pCfgUart->baudRate)) {
+                // Closing the device doesn't reset the module, so it
+                // may still be at the baud rate it was ramped up to
+                uartCfg.baudRate = baudRateLeftAt;
+                errorCode = uShortRangeOpenUart(pCfgSho->moduleType, &uartCfg,
+                                                false, pDeviceHandle);
+            }
+            if (errorCode != 0) {
+                // Open the short range UART, which creates pDeviceHandle
+                uartCfg.baudRate = pCfgUart->baudRate;
+                errorCode = uShortRangeOpenUart(pCfgSho->moduleType, &uartCfg,
+                                                false, pDeviceHandle);
+            }
+            if ((errorCode == 0) && (baudRateMax > 0)) {
+                errorCode = baudRateRamp(pCfgSho->moduleType, baudRateMax,
+                                         &uartCfg, pDeviceHandle);
+                // Remember where the module is, for next time
+                uDevicePrivateUartBaudRateLeftAtSet(pCfgUart->uart,
+                                                    uartCfg.baudRate);
+            }
         }
     }
 
@@ -128,14 +219,16 @@ int32_t uDevicePrivateShortRangeOpenCpuAdd(const uDeviceCfg_t *pDevCfg,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     const uDeviceCfgShortRange_t *pCfgSho;
+    uDeviceInstance_t *pInstance;
 
     if ((pDevCfg != NULL) && (pDeviceHandle != NULL)) {
         pCfgSho = &(pDevCfg->deviceCfg.cfgSho);
         if ((pCfgSho->version == 0) &&
             ((uBleModuleType_t) pCfgSho->moduleType == U_BLE_MODULE_TYPE_INTERNAL)) {
             errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-            *pDeviceHandle = (uDeviceHandle_t) pUDeviceCreateInstance(U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU);
-            if (*pDeviceHandle != NULL) {
+            pInstance = pUDeviceCreateInstance(U_DEVICE_TYPE_SHORT_RANGE_OPEN_CPU);
+            if (pInstance != NULL) {
+                *pDeviceHandle = U_DEVICE_HANDLE(pInstance);
                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
             }
         }
@@ -48,10 +48,34 @@
  */
 #define U_DEVICE_MAGIC_NUMBER 0x0EA7BEEF
 
+/** The number of bits of a device handle that carry the index
+ * (plus one, so that a handle is never NULL) of the device instance
+ * in gDeviceSlot[], the remaining bits carrying the generation.
+ */
+#define U_DEVICE_HANDLE_INDEX_BITS 8
+
+/** Mask for the index bits of a device handle.
+ */
+#define U_DEVICE_HANDLE_INDEX_MASK ((1UL << U_DEVICE_HANDLE_INDEX_BITS) - 1)
+
+/** Mask for the generation count, the bits of a handle above the
+ * index on a platform where uintptr_t is 32 bits.
+ */
+#define U_DEVICE_HANDLE_GENERATION_MASK (0xFFFFFFFFUL >> U_DEVICE_HANDLE_INDEX_BITS)
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** An entry in the table of device instances.
+ */
+typedef struct {
+    uDeviceInstance_t *volatile pInstance; /**< NULL if the entry is free. */
+    volatile uint32_t generation; /**< incremented each time an
+                                       instance in this entry is
+                                       destroyed. */
+} uDeviceSlot_t;
+
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
@@ -61,6 +85,12 @@
  */
 uPortMutexHandle_t gMutex = NULL;
 
+/** The table of device instances, which a device handle indexes:
+ * entries are claimed and released in a critical section, read
+ * without any locking.
+ */
+static uDeviceSlot_t gDeviceSlot[U_DEVICE_INSTANCE_MAX_NUM] = {0};
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -95,10 +125,32 @@ void uDeviceMutexDestroy()
 uDeviceInstance_t *pUDeviceCreateInstance(uDeviceType_t type)
 {
     uDeviceInstance_t *pInstance;
+    bool inCritical;
+    size_t index = 0;
+    bool found = false;
+
     pInstance = (uDeviceInstance_t *) malloc(sizeof(uDeviceInstance_t));
 
     if (pInstance) {
         uDeviceInitInstance(pInstance, type);
+        // Claim an entry in the table
+        inCritical = (uPortEnterCritical() == 0);
+        for (; (index < sizeof(gDeviceSlot) / sizeof(gDeviceSlot[0])) && !found; index++) {
+            if (gDeviceSlot[index].pInstance == NULL) {
+                pInstance->handle = (uDeviceHandle_t) (uintptr_t) (((gDeviceSlot[index].generation &
+                                                                     U_DEVICE_HANDLE_GENERATION_MASK) << U_DEVICE_HANDLE_INDEX_BITS) |
+                                                                   (index + 1));
+                gDeviceSlot[index].pInstance = pInstance;
+                found = true;
+            }
+        }
+        if (inCritical) {
+            uPortExitCritical();
+        }
+        if (!found) {
+            free(pInstance);
+            pInstance = NULL;
+        }
     }
 
     return pInstance;
@@ -106,7 +158,22 @@ uDeviceInstance_t *pUDeviceCreateInstance(uDeviceType_t type)
 
 void uDeviceDestroyInstance(uDeviceInstance_t *pInstance)
 {
+    bool inCritical;
+    size_t index;
+
     if (uDeviceIsValidInstance(pInstance)) {
+        // Release the entry in the table, moving the generation on
+        // first so that the old handle is rejected
+        index = (((uintptr_t) pInstance->handle) & U_DEVICE_HANDLE_INDEX_MASK) - 1;
+        inCritical = (uPortEnterCritical() == 0);
+        if ((index < sizeof(gDeviceSlot) / sizeof(gDeviceSlot[0])) &&
+            (gDeviceSlot[index].pInstance == pInstance)) {
+            gDeviceSlot[index].generation++;
+            gDeviceSlot[index].pInstance = NULL;
+        }
+        if (inCritical) {
+            uPortExitCritical();
+        }
         // Invalidate the instance
         pInstance->magic = 0;
         free(pInstance);
@@ -151,13 +218,35 @@ U_INLINE bool uDeviceIsValidInstance(const uDeviceInstance_t *pInstance)
     return (pInstance != NULL) && (pInstance->magic == U_DEVICE_MAGIC_NUMBER);
 }
 
+U_INLINE uDeviceInstance_t *pUDeviceInstanceFromHandle(uDeviceHandle_t devHandle)
+{
+    uDeviceInstance_t *pInstance = NULL;
+    uintptr_t value = (uintptr_t) devHandle;
+    size_t index = (value & U_DEVICE_HANDLE_INDEX_MASK) - 1;
+
+    // Note: a NULL handle gives an index of SIZE_MAX
+    if (index < sizeof(gDeviceSlot) / sizeof(gDeviceSlot[0])) {
+        pInstance = gDeviceSlot[index].pInstance;
+        // Read the generation after the pointer: if the entry has
+        // been released, or released and reclaimed, since the handle
+        // was issued the generation will no longer match
+        if ((pInstance != NULL) &&
+            ((value >> U_DEVICE_HANDLE_INDEX_BITS) !=
+             (gDeviceSlot[index].generation & U_DEVICE_HANDLE_GENERATION_MASK))) {
+            pInstance = NULL;
+        }
+    }
+
+    return pInstance;
+}
+
 U_INLINE int32_t uDeviceGetInstance(uDeviceHandle_t devHandle,
                                     uDeviceInstance_t **ppInstance)
 {
     bool isValid = false;
 
-    if (devHandle != NULL) {
-        *ppInstance = U_DEVICE_INSTANCE(devHandle);
+    *ppInstance = U_DEVICE_INSTANCE(devHandle);
+    if (*ppInstance != NULL) {
         isValid = uDeviceIsValidInstance(*ppInstance);
     }
 
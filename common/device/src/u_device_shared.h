@@ -42,17 +42,31 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-/** Convenience macro to get the uDeviceInstance_t from a uDeviceHandle_t.
- *  Note: if you also want to validate the handle you should instead use
- *  uDeviceGetInstance()
+/** Convenience macro to get the uDeviceInstance_t from a uDeviceHandle_t;
+ * evaluates to NULL if the handle is not that of an existing device.
+ *  Note: if you also want to check the magic number you should instead
+ *  use uDeviceGetInstance()
  */
-#define U_DEVICE_INSTANCE(devHandle) ((uDeviceInstance_t *) devHandle)
+#define U_DEVICE_INSTANCE(devHandle) pUDeviceInstanceFromHandle(devHandle)
+
+/** Convenience macro to get the uDeviceHandle_t of a uDeviceInstance_t.
+ */
+#define U_DEVICE_HANDLE(pInstance) ((pInstance)->handle)
 
 /** Convenience macro to check if a uDeviceHandle_t is of a specific
  * uDeviceType_t.
  */
 #define U_DEVICE_IS_TYPE(devHandle, devType) \
-    (devHandle == NULL ? false : U_DEVICE_INSTANCE(devHandle)->deviceType == devType)
+    (U_DEVICE_INSTANCE(devHandle) == NULL ? false : U_DEVICE_INSTANCE(devHandle)->deviceType == devType)
+
+#ifndef U_DEVICE_INSTANCE_MAX_NUM
+/** The maximum number of device instances that may exist at any one
+ * time, counting each cellular module, GNSS chip (including one
+ * attached via a cellular module) and short range module; no more
+ * than 255.
+ */
+# define U_DEVICE_INSTANCE_MAX_NUM 8
+#endif
 
 #ifndef U_DEVICE_NETWORKS_MAX_NUM
 /** The maximum number of networks supported by a given device.
@@ -72,17 +86,24 @@ typedef struct {
     const void *pCfg; /**< constant network configuration provided by application. */
     void *pContext; /**< optional context data for this network interface. */
     void *pStatusCallbackData; /**< optional status callback for this network interface. */
+    void *pUpAsync; /**< context of uNetworkInterfaceUpStart(), NULL if it has not been called. */
 } uDeviceNetworkData_t;
 
-/** Internal data structure that uDeviceHandle_t points at.
+/** Internal data structure that a uDeviceHandle_t refers to, see
+ * U_DEVICE_INSTANCE().
  * This structure may be "inherited" by each device type to provide
  * custom data needed for each driver implementation.
  */
 typedef struct {
     uint32_t magic;             /**< magic number for detecting a stale uDeviceInstance_t. */
+    uDeviceHandle_t handle;     /**< the handle of this instance, see U_DEVICE_HANDLE(). */
     uDeviceType_t deviceType;   /**< type of device. */
     int32_t moduleType;         /**< module identification (when applicable). */
     void *pContext;             /**< private instance data for the device. */
+    void *pDriverInstance;      /**< the instance of the underlying driver (e.g.
+                                     the cellular or GNSS instance), so that the
+                                     driver can find it from a handle without
+                                     searching; NULL if not set. */
     uDeviceNetworkData_t networkData[U_DEVICE_NETWORKS_MAX_NUM]; /**< network cfg and private data. */
     // Note: In the future structs of function pointers for socket, MQTT etc.
     // implementations may be added here.
@@ -105,18 +126,20 @@ int32_t uDeviceMutexCreate();
 void uDeviceMutexDestroy();
 
 /** Create a device instance. uDeviceInstance_t is the internal
- * structure that uDeviceHandle_t will point at.
+ * structure that a uDeviceHandle_t refers to; the handle is
+ * U_DEVICE_HANDLE() of the instance returned.
  * Note: it is OK to call this even if uDeviceInit()/uDeviceLock()
  * has not been called.
  *
  * @param type  the u-blox device type.
  * @return      an allocated uDeviceInstance_t struct or NULL if
- *              out of memory.
+ *              out of memory or if #U_DEVICE_INSTANCE_MAX_NUM
+ *              instances already exist.
  */
 uDeviceInstance_t *pUDeviceCreateInstance(uDeviceType_t type);
 
 /** Destroy/deallocate a device instance created by
- * pUDeviceCreateInstance.
+ * pUDeviceCreateInstance; its handle becomes invalid.
  * Note: it is OK to call this even if uDeviceInit()/
  * uDeviceLock() has not been called, provided you know that
  * the instance is not being used by any other task.
@@ -164,6 +187,19 @@ void uDeviceInitInstance(uDeviceInstance_t *pInstance,
  */
 bool uDeviceIsValidInstance(const uDeviceInstance_t *pInstance);
 
+/** Get the device instance that a handle refers to; this is
+ * a lock-free, constant-time, table look-up which never dereferences
+ * the handle, hence a stale or garbage handle is safely rejected.
+ * Note: it is OK to call this even if uDeviceInit()/uDeviceLock()
+ * has not been called, however the caller must know that the
+ * device is not being closed by another task at the same time.
+ *
+ * @param devHandle the device handle.
+ * @return          the device instance or NULL if devHandle is
+ *                  not the handle of an existing device instance.
+ */
+uDeviceInstance_t *pUDeviceInstanceFromHandle(uDeviceHandle_t devHandle);
+
 /** Get a device instance from a device handle. This will
  * also validate the handle.
  * Note: it is OK to call this even if uDeviceInit()/uDeviceLock()
@@ -48,6 +48,8 @@ typedef struct {
     uAtClientHandle_t at;
     int64_t stopTimeMs;
     int32_t pinPwrOn;
+    uDeviceCfgUart_t cfgUart; /**< kept in order to re-open the UART. */
+    int32_t baudRate; /**< the baud rate the UART is currently at. */
 } uDeviceCellContext_t;
 
 #ifdef __cplusplus
@@ -72,6 +72,12 @@ extern "C" {
 #  error "The architecture definition is bad (overflow?)"
 #endif
 
+/** Call entry index of a jump table filled in by uLibResolve(),
+ * type being the function pointer type of that entry, e.g.
+ * U_LIB_CALL(table, 0, int (*)(void *, int))(libHdl.ictx, 102).
+ */
+#define U_LIB_CALL(ppTable, index, type) ((type) ((ppTable)[index]))
+
 /** Return 8-bit archituecture identifier from library flags */
 #define U_LIB_HDR_FLAG_GET_ARCH(flags) (((flags) >> U_LIB_HDR_FLAG_ARCH_BITPOS) & U_LIB_HDR_FLAG_ARCH_MASK)
 
@@ -137,6 +143,12 @@ typedef struct {
     void *ictx;
     /** Last error */
     int error;
+    /** Jump table filled in by uLibResolve(), NULL if there is none */
+    void **ppJumpTable;
+    /** Symbol names that ppJumpTable was resolved from */
+    const char *const *ppJumpSymbols;
+    /** Number of entries in ppJumpTable */
+    uint32_t jumpTableCount;
 } uLibHdl_t;
 
 /**
@@ -189,6 +201,7 @@ int uLibGetCode(uLibHdl_t *pHdl, const void **pPtr, uint32_t *pLen);
  * Useful when e.g. decrypting library code before use.
  * @param pHdl Pointer to library handle struct
  * @param dst Where the code resides.
+ * Any jump table filled in by uLibResolve() is updated to match.
  * @return U_ERROR_COMMON_SUCCESS if OK, else error code
  */
 int uLibRelocate(uLibHdl_t *pHdl, void *dst);
@@ -209,6 +222,26 @@ int uLibClose(uLibHdl_t *pHdl);
  */
 void *uLibSym(uLibHdl_t *pHdl, const char *sym);
 
+/**
+ * Resolves the given symbols once, into a table of call addresses,
+ * so that calls into the library can then be made through the table
+ * (see U_LIB_CALL()) without a symbol look-up or address calculation
+ * per call. The handle remembers the table and uLibRelocate() updates
+ * it, so it remains valid if the code is moved, e.g. into faster RAM;
+ * it is no longer valid once the library is closed.
+ * @param pHdl Pointer to library handle struct of an open library.
+ * @param ppSymbols Array of count function symbol names to resolve;
+ *                  must remain valid while the library is open.
+ * @param ppTable Array of count entries to fill in, entry n being the
+ *                call address of ppSymbols[n]; must remain valid while
+ *                the library is open.
+ * @param count Number of entries in ppSymbols and ppTable.
+ * @return U_ERROR_COMMON_SUCCESS if OK, U_ERROR_COMMON_NOT_FOUND if a
+ *         symbol is not in the library, else error code
+ */
+int uLibResolve(uLibHdl_t *pHdl, const char *const *ppSymbols,
+                void **ppTable, uint32_t count);
+
 /**
  * Returns and clears last error for given library.
  * @param pHdl Pointer to library handle struct.
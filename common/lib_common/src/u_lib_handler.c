@@ -43,6 +43,35 @@ static uint8_t *getCallAddress(uLibHdl_t *pHdl, uint32_t funcIx)
     return pFunc;
 }
 
+static int findFunction(uLibDescriptor_t *pDescr, const char *sym)
+{
+    for (uint32_t i = 0; i < pDescr->hdr.count; i++) {
+        if (((pDescr->funcs[i].flags & (U_LIB_I_FDESC_FLAG_INIT | U_LIB_I_FDESC_FLAG_FINI |
+                                        U_LIB_I_FDESC_FLAG_FUNCTION))
+             == U_LIB_I_FDESC_FLAG_FUNCTION) &&
+            strcmp(sym, pDescr->funcs[i].name) == 0) {
+            return (int)i;
+        }
+    }
+    return U_ERROR_COMMON_NOT_FOUND;
+}
+
+// Fill in the jump table from the symbols, done once
+// rather than on every call into the library
+static int fillJumpTable(uLibHdl_t *pHdl)
+{
+    uLibDescriptor_t *pDescr = (uLibDescriptor_t *)pHdl->puLibDescr;
+    int ix;
+    for (uint32_t i = 0; i < pHdl->jumpTableCount; i++) {
+        ix = findFunction(pDescr, pHdl->ppJumpSymbols[i]);
+        if (ix < 0) {
+            return ix;
+        }
+        pHdl->ppJumpTable[i] = (void *)getCallAddress(pHdl, (uint32_t)ix);
+    }
+    return U_ERROR_COMMON_SUCCESS;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -59,6 +88,7 @@ int uLibProbe(uLibHdl_t *pHdl, uLibHdr_t *pHdr, const void *puLib)
     if (pHdl != NULL) {
         pHdl->puLibDescr = puLib;
         pHdl->puLibCode = (void *)(&pDescr->funcs[pDescr->hdr.count]);
+        pHdl->ppJumpTable = NULL;
     }
     return U_ERROR_COMMON_SUCCESS;
 }
@@ -77,6 +107,9 @@ int uLibOpen(uLibHdl_t *pHdl, const void *puLib,
         return U_ERROR_COMMON_INVALID_PARAMETER;
     }
     pHdl->puLibDescr = puLib;
+    pHdl->ppJumpTable = NULL;
+    pHdl->ppJumpSymbols = NULL;
+    pHdl->jumpTableCount = 0;
 
     if (pRelocate != NULL) {
         pHdl->puLibCode = pRelocate;
@@ -124,6 +157,9 @@ int uLibRelocate(uLibHdl_t *pHdl, void *dst)
         return U_ERROR_COMMON_NOT_INITIALISED;
     }
     pHdl->puLibCode = dst;
+    if (pHdl->ppJumpTable != NULL) {
+        return fillJumpTable(pHdl);
+    }
     return U_ERROR_COMMON_SUCCESS;
 }
 
@@ -145,6 +181,7 @@ int uLibClose(uLibHdl_t *pHdl)
     }
 
     pHdl->puLibDescr = 0; // indicate closed by nulling library descriptor pointer
+    pHdl->ppJumpTable = NULL;
 
     return U_ERROR_COMMON_SUCCESS;
 }
@@ -163,19 +200,33 @@ void *uLibSym(uLibHdl_t *pHdl, const char *sym)
         return 0;
     }
 
-    uLibDescriptor_t *pDescr = (uLibDescriptor_t *)pHdl->puLibDescr;
-    for (uint32_t i = 0; i < pDescr->hdr.count; i++) {
-        if (((pDescr->funcs[i].flags & (U_LIB_I_FDESC_FLAG_INIT | U_LIB_I_FDESC_FLAG_FINI |
-                                        U_LIB_I_FDESC_FLAG_FUNCTION))
-             == U_LIB_I_FDESC_FLAG_FUNCTION) &&
-            strcmp(sym, pDescr->funcs[i].name) == 0) {
-            return (void *)getCallAddress(pHdl, i);
-        }
+    int ix = findFunction((uLibDescriptor_t *)pHdl->puLibDescr, sym);
+    if (ix >= 0) {
+        return (void *)getCallAddress(pHdl, (uint32_t)ix);
     }
     pHdl->error = U_ERROR_COMMON_NOT_FOUND;
     return 0;
 }
 
+int uLibResolve(uLibHdl_t *pHdl, const char *const *ppSymbols,
+                void **ppTable, uint32_t count)
+{
+    if (pHdl == 0 || ppSymbols == 0 || ppTable == 0) {
+        return U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+    if (pHdl->puLibDescr == 0) {
+        return U_ERROR_COMMON_NOT_INITIALISED;
+    }
+    pHdl->ppJumpTable = ppTable;
+    pHdl->ppJumpSymbols = ppSymbols;
+    pHdl->jumpTableCount = count;
+    int res = fillJumpTable(pHdl);
+    if (res != U_ERROR_COMMON_SUCCESS) {
+        pHdl->ppJumpTable = NULL;
+    }
+    return res;
+}
+
 int uLibError(uLibHdl_t *pHdl)
 {
     if (pHdl == 0) {
@@ -81,6 +81,12 @@ extern const unsigned char __libfibonacci_blob[];
 // this is where we will relocate the library code to
 uint8_t *reloc_buf;
 
+// the library functions to resolve into a jump table
+static const char *const gLibFibSymbols[] = {"libFibTestCalc", "libFibTestLastRes"};
+
+// the jump table, indexed as gLibFibSymbols
+static void *gLibFibTable[sizeof(gLibFibSymbols) / sizeof(gLibFibSymbols[0])];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -173,6 +179,14 @@ static int32_t runLibTest(void)
     U_PORT_TEST_ASSERT(strcmp(pBuffer, U_PORT_STRINGIFY_QUOTED(U_COMMON_LIB_TEST_STRING)) == 0);
     uPortLogF("libFibTestHelloWorld: %s (%p)\n", pBuffer, libFibTestHelloWorld(libHdl.ictx));
 
+    // resolve a jump table, which saves a look-up per call
+    res = uLibResolve(&libHdl, gLibFibSymbols, gLibFibTable,
+                      sizeof(gLibFibTable) / sizeof(gLibFibTable[0]));
+    U_PORT_TEST_ASSERT(res == U_ERROR_COMMON_SUCCESS);
+    U_PORT_TEST_ASSERT(gLibFibTable[0] == (void *)libFibTestCalc);
+    U_PORT_TEST_ASSERT(U_LIB_CALL(gLibFibTable, 0, int (*)(void *, int))(libHdl.ictx,
+                                                                        102) == FIB_102);
+
     // try relocate the library to ram instead
     uPortLogF("\nRelocate library code to ram\n");
 
@@ -213,6 +227,10 @@ static int32_t runLibTest(void)
     uPortLogF("@libFibTestLastRes:   %p\n", libFibTestLastRes);
     uPortLogF("@libFibTestHelloWorld:%p\n\n", libFibTestHelloWorld);
 
+    // the jump table should have followed the code
+    U_PORT_TEST_ASSERT(gLibFibTable[0] == (void *)libFibTestCalc);
+    U_PORT_TEST_ASSERT(gLibFibTable[1] == (void *)libFibTestLastRes);
+
     // call the library again, now we will execute from ram
     int libFibTestLastResultReloc = libFibTestLastRes(libHdl.ictx);
     U_PORT_TEST_ASSERT(libFibTestLastResultReloc == libFibTestLastResult);
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GEOFENCE_H_
+#define _U_GEOFENCE_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+#include "u_location.h"
+
+/** \addtogroup location Location
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the geofence API: circular and
+ * polygonal fences are added at setup time and then every location
+ * established through the location API, i.e. by uLocationGet() or
+ * uLocationGetStart(), is tested against them inside this library,
+ * the callback of a fence only being called when a device enters or
+ * exits it.  Locations obtained directly from the GNSS API may be
+ * fed in by passing uGeofenceGnssPosCallback() as the callback to
+ * uGnssPosGetStart() or uGnssPosGetStreamedStart(), or by calling
+ * uGeofenceApply().
+ *
+ * The bounding box of each fence is worked out when it is added, so
+ * that a location well outside a fence is rejected with a couple of
+ * integer comparisons, and the remaining tests are done in integer
+ * arithmetic on the ten-millionths of a degree of #uLocation_t,
+ * treating the area of a fence as flat; this is accurate for fences
+ * up to a few tens of kilometres across, away from the poles.
+ * Fences may not cross the 180 degree meridian.
+ *
+ * The fences are lost when the device API is deinitialised, see
+ * uDeviceDeinit().  These functions are thread-safe.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_GEOFENCE_MAX_NUM
+/** The maximum number of fences that may exist at any one time;
+ * cannot be more than 32.
+ */
+# define U_GEOFENCE_MAX_NUM 16
+#endif
+
+/** The maximum radius of a circular fence in millimetres (1000 km).
+ */
+#define U_GEOFENCE_CIRCLE_RADIUS_MAX_MILLIMETRES 1000000000
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The events that a fence can report.
+ */
+typedef enum {
+    U_GEOFENCE_EVENT_ENTER, /**< the device has moved inside the fence;
+                                 this is also reported for the first
+                                 location of a device that is inside
+                                 the fence. */
+    U_GEOFENCE_EVENT_EXIT   /**< the device has moved outside the fence. */
+} uGeofenceEvent_t;
+
+/** A vertex of a polygonal fence.
+ */
+typedef struct {
+    int32_t latitudeX1e7;  /**< latitude in ten millionths of a degree. */
+    int32_t longitudeX1e7; /**< longitude in ten millionths of a degree. */
+} uGeofenceVertex_t;
+
+/** The callback called when a device enters or exits a fence.  It is
+ * called in the context of whatever delivered the location, e.g. the
+ * task that calls the callback of uLocationGetStart(), with the
+ * geofence API locked, and so must not call any of the functions here
+ * or in the location API.
+ *
+ * @param devHandle          the handle of the device that delivered
+ *                           the location.
+ * @param fenceId            the ID of the fence, as returned by
+ *                           uGeofenceAddCircle() or
+ *                           uGeofenceAddPolygon().
+ * @param event              the event.
+ * @param[in] pLocation      the location that caused the event, must
+ *                           be copied if it is to be kept.
+ * @param pCallbackParameter the parameter given when the fence was
+ *                           added.
+ */
+typedef void (*uGeofenceCallback_t)(uDeviceHandle_t devHandle,
+                                    int32_t fenceId,
+                                    uGeofenceEvent_t event,
+                                    const uLocation_t *pLocation,
+                                    void *pCallbackParameter);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Add a circular fence.  uDeviceInit() must have been called.
+ *
+ * @param latitudeX1e7           the latitude of the centre of the
+ *                               circle in ten millionths of a degree.
+ * @param longitudeX1e7          the longitude of the centre of the
+ *                               circle in ten millionths of a degree.
+ * @param radiusMillimetres      the radius of the circle in
+ *                               millimetres, greater than zero and
+ *                               no more than
+ *                               #U_GEOFENCE_CIRCLE_RADIUS_MAX_MILLIMETRES.
+ * @param[in] pCallback          the callback to be called when a
+ *                               device enters or exits the fence;
+ *                               cannot be NULL.
+ * @param[in] pCallbackParameter a parameter to pass to pCallback;
+ *                               may be NULL.
+ * @return                       on success the ID of the fence, else
+ *                               negative error code.
+ */
+int32_t uGeofenceAddCircle(int32_t latitudeX1e7, int32_t longitudeX1e7,
+                           int32_t radiusMillimetres,
+                           uGeofenceCallback_t pCallback,
+                           void *pCallbackParameter);
+
+/** Add a polygonal fence.  uDeviceInit() must have been called.  The
+ * vertices are copied and so need not be kept once this function has
+ * returned.
+ *
+ * @param[in] pVertices          the vertices of the polygon, in order
+ *                               around its edge (either direction);
+ *                               the polygon is closed automatically,
+ *                               i.e. the last vertex should not repeat
+ *                               the first.  The polygon may not span
+ *                               more than 180 degrees of longitude or
+ *                               cross the 180 degree meridian.
+ * @param numVertices            the number of vertices at pVertices,
+ *                               at least 3.
+ * @param[in] pCallback          the callback to be called when a
+ *                               device enters or exits the fence;
+ *                               cannot be NULL.
+ * @param[in] pCallbackParameter a parameter to pass to pCallback;
+ *                               may be NULL.
+ * @return                       on success the ID of the fence, else
+ *                               negative error code.
+ */
+int32_t uGeofenceAddPolygon(const uGeofenceVertex_t *pVertices,
+                            size_t numVertices,
+                            uGeofenceCallback_t pCallback,
+                            void *pCallbackParameter);
+
+/** Remove a fence; no events are reported for the fence once this
+ * function has returned.
+ *
+ * @param fenceId the ID of the fence.
+ * @return        zero on success else negative error code.
+ */
+int32_t uGeofenceRemove(int32_t fenceId);
+
+/** Remove all fences.
+ */
+void uGeofenceRemoveAll();
+
+/** Get whether a device is inside a fence, as of the last location
+ * tested for that device.
+ *
+ * @param devHandle the handle of the device.
+ * @param fenceId   the ID of the fence.
+ * @return          1 if the device is inside the fence, 0 if it is
+ *                  outside or no location has been tested for the
+ *                  device, else negative error code.
+ */
+int32_t uGeofenceIsInside(uDeviceHandle_t devHandle, int32_t fenceId);
+
+/** Test a location against all of the fences, calling the callbacks
+ * of any that the device has entered or exited.  There is no need to
+ * call this for locations established through the location API, which
+ * are tested automatically.
+ *
+ * @param devHandle     the handle of the device that delivered the
+ *                      location.
+ * @param[in] pLocation the location; cannot be NULL.
+ * @return              on success the number of events reported,
+ *                      else negative error code.
+ */
+int32_t uGeofenceApply(uDeviceHandle_t devHandle,
+                       const uLocation_t *pLocation);
+
+/** A function with the signature of the callback of
+ * uGnssPosGetStart() and uGnssPosGetStreamedStart() which may be
+ * passed to either of them so that every GNSS fix is tested against
+ * the fences, see uGeofenceApply(), without the application being
+ * involved at all.  Fixes where errorCode is not zero are ignored.
+ */
+void uGeofenceGnssPosCallback(uDeviceHandle_t gnssHandle,
+                              int32_t errorCode,
+                              int32_t latitudeX1e7,
+                              int32_t longitudeX1e7,
+                              int32_t altitudeMillimetres,
+                              int32_t radiusMillimetres,
+                              int32_t speedMillimetresPerSecond,
+                              int32_t svs,
+                              int64_t timeUtc);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GEOFENCE_H_
+
+// End of file
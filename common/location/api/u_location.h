@@ -90,9 +90,32 @@ extern "C" {
                                      U_LOCATION_CLOUD_LOCATE_C_NO_THRESHOLD,                    \
                                      U_LOCATION_CLOUD_LOCATE_MULTIPATH_INDEX_LIMIT,             \
                                      U_LOCATION_CLOUD_LOCATE_PSEUDORANGE_RMS_ERROR_INDEX_LIMIT, \
-                                     NULL, NULL}
+                                     NULL, NULL, false, 0, 0}
 #endif
 
+#ifndef U_LOCATION_CONTINUOUS_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that runs uLocationContinuousStart().
+ */
+# define U_LOCATION_CONTINUOUS_TASK_STACK_SIZE_BYTES 2560
+#endif
+
+#ifndef U_LOCATION_CONTINUOUS_TASK_PRIORITY
+/** The priority of the task that runs uLocationContinuousStart().
+ */
+# define U_LOCATION_CONTINUOUS_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+/** Default values for #uLocationContinuousCfg_t: a fix every
+ * second at speed, stretching to every 30 seconds at walking pace,
+ * 50 metres apart, stationary after five fixes below 0.5 metres per
+ * second, then GNSS powered off with no fixes until
+ * uLocationContinuousMotion() is called or ten minutes pass.
+ */
+#define U_LOCATION_CONTINUOUS_CFG_DEFAULTS {1000, 30000, 50000,        \
+                                            500, 5, 600000,            \
+                                            NULL, U_LOCATION_TYPE_NONE, \
+                                            U_LOCATION_CONTINUOUS_GNSS_STATIONARY_OFF}
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -113,6 +136,17 @@ typedef enum {
                                       supported on Wi-Fi modules in future. */
     U_LOCATION_TYPE_CLOUD_CLOUD_LOCATE,  /**< supported on cellular and Wi-Fi
                                               network instances. */
+    U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS, /**< supported on cellular network
+                                               instances only: Cell Locate
+                                               and GNSS are started at the
+                                               same time and the first
+                                               result to meet
+                                               desiredAccuracyMillimetres
+                                               wins, see uLocationGetStart();
+                                               the type field of the
+                                               #uLocation_t returned will be
+                                               that of the source that
+                                               produced it. */
     U_LOCATION_TYPE_MAX_NUM
 } uLocationType_t;
 
@@ -186,6 +220,45 @@ typedef struct {
                                    with the u-blox Cloud Locate service; the
                                    MQTT client MUST have been logged-in to the
                                    Cloud Locate service BEFORE calling this API. */
+
+    /* The following fields are ONLY used by U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS. */
+
+    bool refine; /**< only used by #U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS
+                      with uLocationGetStart(): if the first result to
+                      arrive comes from Cell Locate then, rather than
+                      cancelling GNSS, let it run on and call the callback
+                      a second time if GNSS produces a more accurate
+                      result. */
+    int32_t maxAgeSeconds; /**< if greater than zero, a location of the
+                                requested type that was established no
+                                more than this many seconds ago, by a
+                                call from anywhere in this application,
+                                and that meets desiredAccuracyMillimetres
+                                (if that is not -1), will be returned
+                                immediately instead of establishing a
+                                new one; use 0 (the default) to always
+                                establish a new location. */
+
+    /* The following field is ONLY used by U_LOCATION_TYPE_CLOUD_CLOUD_LOCATE. */
+
+    int32_t cloudLocateBatchSize; /**< only used by
+                                       #U_LOCATION_TYPE_CLOUD_CLOUD_LOCATE
+                                       where pClientIdStr is NULL, i.e.
+                                       where only the cloud needs to know
+                                       the location: if greater than 1,
+                                       the RRLP data captured by each call
+                                       to uLocationGet() is held back and
+                                       uploaded, as one MQTT message, once
+                                       this many have been captured or the
+                                       message is full, which saves the
+                                       overhead of a publish per location
+                                       for asset tracking.  A call with
+                                       pClientIdStr non-NULL first uploads
+                                       anything held back.  Anything held
+                                       back when the device API is
+                                       deinitialised is lost.  Use 0 (the
+                                       default) to upload each location as
+                                       it is captured. */
 } uLocationAssist_t;
 
 /** Definition of a location.
@@ -244,6 +317,75 @@ typedef enum {
     U_LOCATION_STATUS_MAX_NUM
 } uLocationStatus_t;
 
+/** What uLocationContinuousStart() does with a GNSS device while
+ * the device is stationary.
+ */
+typedef enum {
+    U_LOCATION_CONTINUOUS_GNSS_STATIONARY_ON,         /**< leave GNSS as it is. */
+    U_LOCATION_CONTINUOUS_GNSS_STATIONARY_POWER_SAVE, /**< put GNSS into cyclic
+                                                           tracking power save,
+                                                           CFG-PM-OPERATEMODE
+                                                           PSMCT; M9 modules and
+                                                           later only. */
+    U_LOCATION_CONTINUOUS_GNSS_STATIONARY_OFF         /**< power GNSS off with
+                                                           uGnssPwrOff(); use
+                                                           uGnssPwrSetHotStart()
+                                                           to have the first fix
+                                                           on resuming arrive
+                                                           quickly. */
+} uLocationContinuousGnssStationary_t;
+
+/** Configuration for uLocationContinuousStart(); note the ordering,
+ * see #U_LOCATION_CONTINUOUS_CFG_DEFAULTS.
+ */
+typedef struct {
+    int32_t periodMinMs;          /**< the shortest time between fixes
+                                       while moving. */
+    int32_t periodMaxMs;          /**< the longest time between fixes
+                                       while moving. */
+    int32_t distanceMillimetres;  /**< while moving, the time between fixes
+                                       is set from the speed of the last
+                                       fix so that fixes are about this
+                                       far apart, limited to periodMinMs
+                                       and periodMaxMs; a fix with no
+                                       speed (e.g. from Cell Locate)
+                                       leaves the period as it is. */
+    int32_t stationarySpeedMillimetresPerSecond; /**< a fix slower than
+                                                      this counts as
+                                                      not moving. */
+    int32_t stationaryNumFixes;   /**< the number of fixes in a row that
+                                       must be not moving for the device
+                                       to be stationary. */
+    int32_t periodStationaryMs;   /**< the time between fixes while
+                                       stationary; any movement found
+                                       by such a fix (speed, or position
+                                       outside the radius of the fix
+                                       that became stationary) resumes
+                                       moving.  Use -1 for no fixes while
+                                       stationary, in which case only
+                                       uLocationContinuousMotion() will
+                                       resume moving. */
+    uDeviceHandle_t devHandleStationary; /**< the device to use for fixes
+                                              while stationary, e.g. a
+                                              cellular device for Cell
+                                              Locate or a Wi-Fi device for
+                                              Cloud Locate while GNSS is
+                                              off; NULL to use the device
+                                              passed to
+                                              uLocationContinuousStart(). */
+    uLocationType_t typeStationary; /**< the type of fix to use while
+                                         stationary; #U_LOCATION_TYPE_NONE
+                                         to use the same type as while
+                                         moving. */
+    uLocationContinuousGnssStationary_t gnssStationary; /**< what to do
+                                                             with GNSS while
+                                                             stationary, only
+                                                             applies if the
+                                                             device passed to
+                                                             uLocationContinuousStart()
+                                                             is a GNSS device. */
+} uLocationContinuousCfg_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -292,6 +434,20 @@ typedef enum {
  *                                            should be populated if you want the
  *                                            location to be returned by this function
  *                                            (as well as being available in the cloud).
+ *                                            #U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS
+ *                                            may also be used, which starts Cell
+ *                                            Locate (with GNSS disabled in Cell
+ *                                            Locate) and GNSS at the same time and
+ *                                            returns the first result from either
+ *                                            whose radius is within the
+ *                                            pLocationAssist field
+ *                                            desiredAccuracyMillimetres, cancelling
+ *                                            the other; if neither meets it, the
+ *                                            more accurate of the two is returned.
+ *                                            The GNSS device used is the one on
+ *                                            the GNSS network attached to devHandle,
+ *                                            else a GNSS chip inside or attached
+ *                                            to the cellular module.
  *                                - Wi-Fi:    only #U_LOCATION_TYPE_CLOUD_CLOUD_LOCATE is
  *                                            currently supported, for which the
  *                                            pLocationAssist field pMqttClientContext
@@ -384,7 +540,23 @@ int32_t uLocationGet(uDeviceHandle_t devHandle, uLocationType_t type,
  *                                to a #uLocation_t structure (which may be NULL
  *                                if the error code is non-zero), the contents
  *                                of which must be COPIED as it will be destroyed
- *                                once the callback returns.
+ *                                once the callback returns.  With
+ *                                #U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS, if
+ *                                the refine field of pLocationAssist is true,
+ *                                the callback may be called a second time
+ *                                with a more accurate result from GNSS.
+ *                                If the maxAgeSeconds field of
+ *                                pLocationAssist allows a cached location
+ *                                to be used, the callback will be called
+ *                                before this function returns.  If a
+ *                                location of the same type is already
+ *                                being established for devHandle (other
+ *                                than with #U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS)
+ *                                this request will join it, i.e. the
+ *                                callback will be called with the
+ *                                same result and pLocationAssist
+ *                                and pAuthenticationTokenStr will be
+ *                                ignored.
  * @return                        zero on success or negative error code on
  *                                failure.
  */
@@ -410,6 +582,83 @@ int32_t uLocationGetStatus(uDeviceHandle_t devHandle);
  */
 void uLocationGetStop(uDeviceHandle_t devHandle);
 
+/** Start continuous location at a rate that adapts to movement.  A
+ * task is started that gets a location with uLocationGet(), calls
+ * pCallback with it, then waits before getting the next.  While the
+ * device is moving the wait is set from the speed of the fix so that
+ * fixes are distanceMillimetres apart.  Once stationaryNumFixes fixes
+ * in a row are slower than stationarySpeedMillimetresPerSecond the
+ * device is stationary: a GNSS device is put into power save or
+ * powered off, as gnssStationary says, and fixes are taken only
+ * every periodStationaryMs, perhaps from a cheaper source, until
+ * one shows movement or uLocationContinuousMotion() is called, e.g.
+ * from the motion interrupt of an accelerometer, at which point GNSS
+ * is restored and the next fix is taken at once.
+ *
+ * Only one continuous location may run at a time; it should be stopped
+ * with uLocationContinuousStop() before the device is closed.  It
+ * should not be used at the same time as uLocationGetStart() on the
+ * same device.
+ *
+ * @param devHandle                the device handle to use.
+ * @param type                     the type of location fix to perform,
+ *                                 see uLocationGet().
+ * @param[in] pLocationAssist      see uLocationGet(); copied, may be NULL,
+ *                                 though any strings it points to are not.
+ *                                 Its desiredAccuracyMillimetres also
+ *                                 governs movement: a fix with a larger
+ *                                 radius is passed to pCallback but does
+ *                                 not change the state.
+ * @param pAuthenticationTokenStr  see uLocationGet(); NOT copied, must
+ *                                 remain valid until uLocationContinuousStop()
+ *                                 is called.
+ * @param[in] pCfg                 the configuration, copied; NULL for
+ *                                 #U_LOCATION_CONTINUOUS_CFG_DEFAULTS.
+ * @param[in] pCallback            called from the continuous location
+ *                                 task with each fix, or attempt at a fix,
+ *                                 parameters as for uLocationGetStart();
+ *                                 it may call uLocationContinuousMotion()
+ *                                 but must not call uLocationContinuousStop().
+ *                                 Cannot be NULL.
+ * @return                         zero on success or negative error code;
+ *                                 #U_ERROR_COMMON_TEMPORARY_FAILURE if
+ *                                 continuous location is already running.
+ */
+int32_t uLocationContinuousStart(uDeviceHandle_t devHandle, uLocationType_t type,
+                                 const uLocationAssist_t *pLocationAssist,
+                                 const char *pAuthenticationTokenStr,
+                                 const uLocationContinuousCfg_t *pCfg,
+                                 void (*pCallback) (uDeviceHandle_t devHandle,
+                                                    int32_t errorCode,
+                                                    const uLocation_t *pLocation));
+
+/** Tell continuous location that the device has moved, e.g. from
+ * an accelerometer: if the device is stationary GNSS is restored and
+ * a fix is taken at once.  May be called from any task, but not from
+ * an interrupt.
+ *
+ * @param devHandle  the device handle passed to uLocationContinuousStart().
+ * @return           zero on success or negative error code.
+ */
+int32_t uLocationContinuousMotion(uDeviceHandle_t devHandle);
+
+/** Get the current period of continuous location.
+ *
+ * @param devHandle  the device handle passed to uLocationContinuousStart().
+ * @return           the time between fixes in milliseconds, zero
+ *                   if the device is stationary with no fixes,
+ *                   else negative error code.
+ */
+int32_t uLocationContinuousGetPeriodMs(uDeviceHandle_t devHandle);
+
+/** Stop continuous location, restoring GNSS if it was in power save
+ * or off; once this returns pCallback will not be called again.
+ * If a fix is in progress this waits for it to be abandoned.
+ *
+ * @param devHandle  the device handle passed to uLocationContinuousStart().
+ */
+void uLocationContinuousStop(uDeviceHandle_t devHandle);
+
 #ifdef __cplusplus
 }
 #endif
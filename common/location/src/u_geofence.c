@@ -0,0 +1,586 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the geofence API.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy()
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+
+#include "u_location.h"
+#include "u_location_shared.h"
+#include "u_location_private_geofence.h"
+#include "u_geofence.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The number of millimetres in a degree of latitude, taking the
+ * mean radius of the Earth.
+ */
+#define U_GEOFENCE_MILLIMETRES_PER_DEGREE 111194927LL
+
+/** The largest latitude in ten millionths of a degree.
+ */
+#define U_GEOFENCE_LATITUDE_MAX_X1E7 900000000
+
+/** The largest longitude in ten millionths of a degree.
+ */
+#define U_GEOFENCE_LONGITUDE_MAX_X1E7 1800000000
+
+/** The number of fractional bits in the fixed-point cosine of the
+ * latitude of the centre of a circular fence.
+ */
+#define U_GEOFENCE_COS_FRACTIONAL_BITS 16
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A fence; for a polygon the vertices follow the structure
+ * in the same allocation.
+ */
+typedef struct {
+    uGeofenceCallback_t pCallback;
+    void *pCallbackParameter;
+    int32_t latitudeMinX1e7;  /**< bounding box. */
+    int32_t latitudeMaxX1e7;  /**< bounding box. */
+    int32_t longitudeMinX1e7; /**< bounding box. */
+    int32_t longitudeMaxX1e7; /**< bounding box. */
+    int32_t latitudeX1e7;     /**< centre, circle only. */
+    int32_t longitudeX1e7;    /**< centre, circle only. */
+    int64_t cosLatitude;      /**< fixed-point cosine of the latitude
+                                   of the centre, circle only. */
+    int64_t radiusSquared;    /**< the radius in ten millionths of a
+                                   degree of latitude, squared, circle
+                                   only. */
+    size_t numVertices;       /**< zero for a circle. */
+    uGeofenceVertex_t *pVertices;
+} uGeofence_t;
+
+/** The state of a device with respect to the fences.
+ */
+typedef struct uGeofenceDevice_t {
+    uDeviceHandle_t devHandle;
+    uint32_t insideMask; /**< bit n set if inside fence ID n. */
+    struct uGeofenceDevice_t *pNext;
+} uGeofenceDevice_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The fences, indexed by ID, protected by gULocationMutex.
+ */
+static uGeofence_t *gpFence[U_GEOFENCE_MAX_NUM] = {0};
+
+/** The list of device states, protected by gULocationMutex.
+ */
+static uGeofenceDevice_t *gpDeviceList = NULL;
+
+/** The cosine of each whole degree from 0 to 90, with
+ * U_GEOFENCE_COS_FRACTIONAL_BITS fractional bits (cos(0) being
+ * one short so that it fits), so that no floating point is needed.
+ */
+static const uint16_t gCos[] = {
+    65535, 65526, 65496, 65446, 65376, 65287, 65177, 65048,
+    64898, 64729, 64540, 64332, 64104, 63856, 63589, 63303,
+    62997, 62672, 62328, 61966, 61584, 61183, 60764, 60326,
+    59870, 59396, 58903, 58393, 57865, 57319, 56756, 56175,
+    55578, 54963, 54332, 53684, 53020, 52339, 51643, 50931,
+    50203, 49461, 48703, 47930, 47143, 46341, 45525, 44695,
+    43852, 42995, 42126, 41243, 40348, 39441, 38521, 37590,
+    36647, 35693, 34729, 33754, 32768, 31772, 30767, 29753,
+    28729, 27697, 26656, 25607, 24550, 23486, 22415, 21336,
+    20252, 19161, 18064, 16962, 15855, 14742, 13626, 12505,
+    11380, 10252, 9121, 7987, 6850, 5712, 4572, 3430,
+    2287, 1144, 0
+};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Limit a value to plus or minus a maximum.
+static int32_t limit(int64_t value, int32_t max)
+{
+    if (value > max) {
+        value = max;
+    } else if (value < -max) {
+        value = -max;
+    }
+
+    return (int32_t) value;
+}
+
+// Return the cosine of a latitude, interpolating between the
+// entries of gCos[].
+static int64_t cosLatitude(int32_t latitudeX1e7)
+{
+    int32_t degrees;
+    int32_t remainderX1e7;
+    int64_t cosine;
+
+    if (latitudeX1e7 < 0) {
+        latitudeX1e7 = -latitudeX1e7;
+    }
+    degrees = latitudeX1e7 / 10000000;
+    remainderX1e7 = latitudeX1e7 % 10000000;
+    cosine = gCos[degrees];
+    if (degrees < 90) {
+        cosine -= (((int64_t) gCos[degrees] - gCos[degrees + 1]) * remainderX1e7) / 10000000;
+    }
+
+    return cosine;
+}
+
+// Store a new fence, returning its ID.
+// Note: gULocationMutex should be locked before this is called.
+static int32_t fenceStore(uGeofence_t *pFence)
+{
+    int32_t errorCodeOrId = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+
+    for (size_t x = 0; (x < sizeof(gpFence) / sizeof(gpFence[0])) &&
+         (errorCodeOrId < 0); x++) {
+        if (gpFence[x] == NULL) {
+            gpFence[x] = pFence;
+            errorCodeOrId = (int32_t) x;
+        }
+    }
+
+    return errorCodeOrId;
+}
+
+// Find the state of a device, creating it if it doesn't exist.
+// Note: gULocationMutex should be locked before this is called.
+static uGeofenceDevice_t *pDeviceGet(uDeviceHandle_t devHandle,
+                                     bool create)
+{
+    uGeofenceDevice_t *pDevice = gpDeviceList;
+
+    while ((pDevice != NULL) && (pDevice->devHandle != devHandle)) {
+        pDevice = pDevice->pNext;
+    }
+    if ((pDevice == NULL) && create) {
+        pDevice = (uGeofenceDevice_t *) malloc(sizeof(*pDevice));
+        if (pDevice != NULL) {
+            pDevice->devHandle = devHandle;
+            pDevice->insideMask = 0;
+            pDevice->pNext = gpDeviceList;
+            gpDeviceList = pDevice;
+        }
+    }
+
+    return pDevice;
+}
+
+// Test whether a location is inside a circular fence, the bounding
+// box having already been checked.
+static bool isInsideCircle(const uGeofence_t *pFence,
+                           int32_t latitudeX1e7, int32_t longitudeX1e7)
+{
+    int64_t dy = (int64_t) latitudeX1e7 - pFence->latitudeX1e7;
+    // Scale longitude to the same units as latitude; use division
+    // rather than a shift as dx may be negative
+    int64_t dx = (((int64_t) longitudeX1e7 - pFence->longitudeX1e7) *
+                  pFence->cosLatitude) / (1LL << U_GEOFENCE_COS_FRACTIONAL_BITS);
+
+    return (dx * dx) + (dy * dy) <= pFence->radiusSquared;
+}
+
+// Test whether a location is inside a polygonal fence by counting
+// the edges that a line running from it in the direction of
+// increasing longitude crosses, the bounding box having already been
+// checked: since the polygon spans no more than 180 degrees each
+// product below fits easily into 64 bits.
+static bool isInsidePolygon(const uGeofence_t *pFence,
+                            int32_t latitudeX1e7, int32_t longitudeX1e7)
+{
+    bool inside = false;
+    const uGeofenceVertex_t *pI;
+    const uGeofenceVertex_t *pJ = pFence->pVertices + pFence->numVertices - 1;
+    int64_t lhs;
+    int64_t rhs;
+
+    for (size_t x = 0; x < pFence->numVertices; x++) {
+        pI = pFence->pVertices + x;
+        if ((pI->latitudeX1e7 > latitudeX1e7) != (pJ->latitudeX1e7 > latitudeX1e7)) {
+            // The edge straddles our latitude: we are to the west of
+            // where it crosses if
+            // lon - lonI < (lonJ - lonI) * (lat - latI) / (latJ - latI),
+            // which is rearranged here to avoid the division
+            lhs = ((int64_t) longitudeX1e7 - pI->longitudeX1e7) *
+                  ((int64_t) pJ->latitudeX1e7 - pI->latitudeX1e7);
+            rhs = ((int64_t) pJ->longitudeX1e7 - pI->longitudeX1e7) *
+                  ((int64_t) latitudeX1e7 - pI->latitudeX1e7);
+            if ((pJ->latitudeX1e7 > pI->latitudeX1e7) ? (lhs < rhs) : (lhs > rhs)) {
+                inside = !inside;
+            }
+        }
+        pJ = pI;
+    }
+
+    return inside;
+}
+
+// Test whether a location is inside a fence.
+static bool isInside(const uGeofence_t *pFence,
+                     int32_t latitudeX1e7, int32_t longitudeX1e7)
+{
+    bool inside = false;
+
+    if ((latitudeX1e7 >= pFence->latitudeMinX1e7) &&
+        (latitudeX1e7 <= pFence->latitudeMaxX1e7) &&
+        (longitudeX1e7 >= pFence->longitudeMinX1e7) &&
+        (longitudeX1e7 <= pFence->longitudeMaxX1e7)) {
+        if (pFence->numVertices == 0) {
+            inside = isInsideCircle(pFence, latitudeX1e7, longitudeX1e7);
+        } else {
+            inside = isInsidePolygon(pFence, latitudeX1e7, longitudeX1e7);
+        }
+    }
+
+    return inside;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS THAT ARE PRIVATE TO LOCATION
+ * -------------------------------------------------------------- */
+
+// Test a location against all of the fences.
+int32_t uLocationPrivateGeofenceApply(uDeviceHandle_t devHandle,
+                                      const uLocation_t *pLocation)
+{
+    int32_t errorCodeOrCount = 0;
+    uGeofenceDevice_t *pDevice = NULL;
+    const uGeofence_t *pFence;
+    bool inside;
+    bool wasInside;
+
+    for (size_t x = 0; (x < sizeof(gpFence) / sizeof(gpFence[0])) &&
+         (errorCodeOrCount >= 0); x++) {
+        pFence = gpFence[x];
+        if (pFence != NULL) {
+            if (pDevice == NULL) {
+                // Only need the device state if there is a fence
+                pDevice = pDeviceGet(devHandle, true);
+                if (pDevice == NULL) {
+                    errorCodeOrCount = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                }
+            }
+            if (pDevice != NULL) {
+                inside = isInside(pFence, pLocation->latitudeX1e7,
+                                  pLocation->longitudeX1e7);
+                wasInside = ((pDevice->insideMask & (1UL << x)) != 0);
+                if (inside != wasInside) {
+                    pDevice->insideMask ^= 1UL << x;
+                    pFence->pCallback(devHandle, (int32_t) x,
+                                      inside ? U_GEOFENCE_EVENT_ENTER : U_GEOFENCE_EVENT_EXIT,
+                                      pLocation, pFence->pCallbackParameter);
+                    errorCodeOrCount++;
+                }
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Free all fences and device states.
+void uLocationPrivateGeofenceDeinit()
+{
+    uGeofenceDevice_t *pDevice;
+
+    for (size_t x = 0; x < sizeof(gpFence) / sizeof(gpFence[0]); x++) {
+        free(gpFence[x]);
+        gpFence[x] = NULL;
+    }
+    while (gpDeviceList != NULL) {
+        pDevice = gpDeviceList->pNext;
+        free(gpDeviceList);
+        gpDeviceList = pDevice;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add a circular fence.
+int32_t uGeofenceAddCircle(int32_t latitudeX1e7, int32_t longitudeX1e7,
+                           int32_t radiusMillimetres,
+                           uGeofenceCallback_t pCallback,
+                           void *pCallbackParameter)
+{
+    int32_t errorCodeOrId = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGeofence_t *pFence;
+    int64_t radiusX1e7;
+    int64_t longitudeRadiusX1e7;
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        errorCodeOrId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pCallback != NULL) &&
+            (latitudeX1e7 >= -U_GEOFENCE_LATITUDE_MAX_X1E7) &&
+            (latitudeX1e7 <= U_GEOFENCE_LATITUDE_MAX_X1E7) &&
+            (longitudeX1e7 >= -U_GEOFENCE_LONGITUDE_MAX_X1E7) &&
+            (longitudeX1e7 <= U_GEOFENCE_LONGITUDE_MAX_X1E7) &&
+            (radiusMillimetres > 0) &&
+            (radiusMillimetres <= U_GEOFENCE_CIRCLE_RADIUS_MAX_MILLIMETRES)) {
+            errorCodeOrId = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pFence = (uGeofence_t *) malloc(sizeof(*pFence));
+            if (pFence != NULL) {
+                memset(pFence, 0, sizeof(*pFence));
+                pFence->pCallback = pCallback;
+                pFence->pCallbackParameter = pCallbackParameter;
+                pFence->latitudeX1e7 = latitudeX1e7;
+                pFence->longitudeX1e7 = longitudeX1e7;
+                pFence->cosLatitude = cosLatitude(latitudeX1e7);
+                if (pFence->cosLatitude < 1) {
+                    pFence->cosLatitude = 1;
+                }
+                radiusX1e7 = ((int64_t) radiusMillimetres * 10000000) /
+                             U_GEOFENCE_MILLIMETRES_PER_DEGREE;
+                pFence->radiusSquared = radiusX1e7 * radiusX1e7;
+                longitudeRadiusX1e7 = (radiusX1e7 << U_GEOFENCE_COS_FRACTIONAL_BITS) /
+                                      pFence->cosLatitude;
+                pFence->latitudeMinX1e7 = limit((int64_t) latitudeX1e7 - radiusX1e7,
+                                                U_GEOFENCE_LATITUDE_MAX_X1E7);
+                pFence->latitudeMaxX1e7 = limit((int64_t) latitudeX1e7 + radiusX1e7,
+                                                U_GEOFENCE_LATITUDE_MAX_X1E7);
+                pFence->longitudeMinX1e7 = limit((int64_t) longitudeX1e7 - longitudeRadiusX1e7,
+                                                 U_GEOFENCE_LONGITUDE_MAX_X1E7);
+                pFence->longitudeMaxX1e7 = limit((int64_t) longitudeX1e7 + longitudeRadiusX1e7,
+                                                 U_GEOFENCE_LONGITUDE_MAX_X1E7);
+                errorCodeOrId = fenceStore(pFence);
+                if (errorCodeOrId < 0) {
+                    free(pFence);
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+
+    return errorCodeOrId;
+}
+
+// Add a polygonal fence.
+int32_t uGeofenceAddPolygon(const uGeofenceVertex_t *pVertices,
+                            size_t numVertices,
+                            uGeofenceCallback_t pCallback,
+                            void *pCallbackParameter)
+{
+    int32_t errorCodeOrId = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGeofence_t *pFence;
+    int32_t latitudeMinX1e7 = U_GEOFENCE_LATITUDE_MAX_X1E7;
+    int32_t latitudeMaxX1e7 = -U_GEOFENCE_LATITUDE_MAX_X1E7;
+    int32_t longitudeMinX1e7 = U_GEOFENCE_LONGITUDE_MAX_X1E7;
+    int32_t longitudeMaxX1e7 = -U_GEOFENCE_LONGITUDE_MAX_X1E7;
+    bool valid;
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        errorCodeOrId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        valid = (pVertices != NULL) && (numVertices >= 3) && (pCallback != NULL);
+        for (size_t x = 0; valid && (x < numVertices); x++) {
+            valid = (pVertices[x].latitudeX1e7 >= -U_GEOFENCE_LATITUDE_MAX_X1E7) &&
+                    (pVertices[x].latitudeX1e7 <= U_GEOFENCE_LATITUDE_MAX_X1E7) &&
+                    (pVertices[x].longitudeX1e7 >= -U_GEOFENCE_LONGITUDE_MAX_X1E7) &&
+                    (pVertices[x].longitudeX1e7 <= U_GEOFENCE_LONGITUDE_MAX_X1E7);
+            if (pVertices[x].latitudeX1e7 < latitudeMinX1e7) {
+                latitudeMinX1e7 = pVertices[x].latitudeX1e7;
+            }
+            if (pVertices[x].latitudeX1e7 > latitudeMaxX1e7) {
+                latitudeMaxX1e7 = pVertices[x].latitudeX1e7;
+            }
+            if (pVertices[x].longitudeX1e7 < longitudeMinX1e7) {
+                longitudeMinX1e7 = pVertices[x].longitudeX1e7;
+            }
+            if (pVertices[x].longitudeX1e7 > longitudeMaxX1e7) {
+                longitudeMaxX1e7 = pVertices[x].longitudeX1e7;
+            }
+        }
+        if (valid &&
+            ((int64_t) longitudeMaxX1e7 - longitudeMinX1e7 <= U_GEOFENCE_LONGITUDE_MAX_X1E7)) {
+            errorCodeOrId = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pFence = (uGeofence_t *) malloc(sizeof(*pFence) +
+                                            (sizeof(uGeofenceVertex_t) * numVertices));
+            if (pFence != NULL) {
+                memset(pFence, 0, sizeof(*pFence));
+                pFence->pCallback = pCallback;
+                pFence->pCallbackParameter = pCallbackParameter;
+                pFence->latitudeMinX1e7 = latitudeMinX1e7;
+                pFence->latitudeMaxX1e7 = latitudeMaxX1e7;
+                pFence->longitudeMinX1e7 = longitudeMinX1e7;
+                pFence->longitudeMaxX1e7 = longitudeMaxX1e7;
+                pFence->numVertices = numVertices;
+                pFence->pVertices = (uGeofenceVertex_t *) (pFence + 1);
+                memcpy(pFence->pVertices, pVertices,
+                       sizeof(uGeofenceVertex_t) * numVertices);
+                errorCodeOrId = fenceStore(pFence);
+                if (errorCodeOrId < 0) {
+                    free(pFence);
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+
+    return errorCodeOrId;
+}
+
+// Remove a fence.
+int32_t uGeofenceRemove(int32_t fenceId)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGeofenceDevice_t *pDevice;
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((fenceId >= 0) && (fenceId < U_GEOFENCE_MAX_NUM) &&
+            (gpFence[fenceId] != NULL)) {
+            free(gpFence[fenceId]);
+            gpFence[fenceId] = NULL;
+            // Forget that anyone was inside it, ready for reuse of the ID
+            for (pDevice = gpDeviceList; pDevice != NULL; pDevice = pDevice->pNext) {
+                pDevice->insideMask &= ~(1UL << fenceId);
+            }
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+
+    return errorCode;
+}
+
+// Remove all fences.
+void uGeofenceRemoveAll()
+{
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        uLocationPrivateGeofenceDeinit();
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+}
+
+// Get whether a device is inside a fence.
+int32_t uGeofenceIsInside(uDeviceHandle_t devHandle, int32_t fenceId)
+{
+    int32_t errorCodeOrInside = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    const uGeofenceDevice_t *pDevice;
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        errorCodeOrInside = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((fenceId >= 0) && (fenceId < U_GEOFENCE_MAX_NUM) &&
+            (gpFence[fenceId] != NULL)) {
+            errorCodeOrInside = 0;
+            pDevice = pDeviceGet(devHandle, false);
+            if ((pDevice != NULL) &&
+                ((pDevice->insideMask & (1UL << fenceId)) != 0)) {
+                errorCodeOrInside = 1;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+
+    return errorCodeOrInside;
+}
+
+// Test a location against all of the fences.
+int32_t uGeofenceApply(uDeviceHandle_t devHandle,
+                       const uLocation_t *pLocation)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pLocation != NULL) {
+            errorCodeOrCount = uLocationPrivateGeofenceApply(devHandle, pLocation);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+
+    return errorCodeOrCount;
+}
+
+// Callback for uGnssPosGetStart()/uGnssPosGetStreamedStart().
+void uGeofenceGnssPosCallback(uDeviceHandle_t gnssHandle,
+                              int32_t errorCode,
+                              int32_t latitudeX1e7,
+                              int32_t longitudeX1e7,
+                              int32_t altitudeMillimetres,
+                              int32_t radiusMillimetres,
+                              int32_t speedMillimetresPerSecond,
+                              int32_t svs,
+                              int64_t timeUtc)
+{
+    uLocation_t location;
+
+    if (errorCode == 0) {
+        location.type = U_LOCATION_TYPE_GNSS;
+        location.latitudeX1e7 = latitudeX1e7;
+        location.longitudeX1e7 = longitudeX1e7;
+        location.altitudeMillimetres = altitudeMillimetres;
+        location.radiusMillimetres = radiusMillimetres;
+        location.speedMillimetresPerSecond = speedMillimetresPerSecond;
+        location.svs = svs;
+        location.timeUtc = timeUtc;
+        uGeofenceApply(gnssHandle, &location);
+    }
+}
+
+// End of file
@@ -38,6 +38,7 @@
 
 #include "u_device_shared.h"
 
+#include "u_port.h"
 #include "u_port_os.h"
 
 #include "u_cell_loc.h"
@@ -59,14 +60,46 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_LOCATION_COMBINED_POLL_PERIOD_MS
+/** How often the blocking form of #U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS
+ * checks for a result and calls pKeepGoingCallback.
+ */
+# define U_LOCATION_COMBINED_POLL_PERIOD_MS 100
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Context for a #U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS request, where
+ * Cell Locate and GNSS are run at the same time; there can only be
+ * one such request at a time.
+ */
+typedef struct {
+    uDeviceHandle_t cellHandle;
+    uDeviceHandle_t gnssHandle;
+    int32_t desiredAccuracyMillimetres;
+    bool refine;
+    volatile bool cellLocPending;
+    volatile bool gnssPending;
+    volatile bool reported;
+    int32_t errorCode;    /**< the error code for location, below. */
+    uLocation_t location; /**< the most accurate result so far. */
+    int32_t reportedRadiusMillimetres;
+    void (*pCallback) (uDeviceHandle_t devHandle,
+                       int32_t errorCode,
+                       const uLocation_t *pLocation);
+} uLocationCombined_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The context for a #U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS request,
+ * protected by gULocationMutex.
+ */
+static uLocationCombined_t gLocationCombined = {0};
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -117,25 +150,26 @@ static void gnssPosCallback(uDeviceHandle_t devHandle,
 
         U_PORT_MUTEX_LOCK(gULocationMutex);
 
-        pEntry = pULocationSharedRequestPop(U_LOCATION_TYPE_GNSS);
-        if ((pEntry != NULL) && (pEntry->pCallback != NULL)) {
-            location.type = U_LOCATION_TYPE_GNSS;
-            if (errorCode == 0) {
-                location.latitudeX1e7 = latitudeX1e7;
-                location.longitudeX1e7 = longitudeX1e7;
-                location.altitudeMillimetres = altitudeMillimetres;
-                location.radiusMillimetres = radiusMillimetres;
-                location.speedMillimetresPerSecond = speedMillimetresPerSecond;
-                location.svs = svs;
-            }
-            if (timeUtc >= 0) {
-                // Time may be valid even if the error code is non-zero
-                location.timeUtc = timeUtc;
+        location.type = U_LOCATION_TYPE_GNSS;
+        location.latitudeX1e7 = latitudeX1e7;
+        location.longitudeX1e7 = longitudeX1e7;
+        location.altitudeMillimetres = altitudeMillimetres;
+        location.radiusMillimetres = radiusMillimetres;
+        location.speedMillimetresPerSecond = speedMillimetresPerSecond;
+        location.svs = svs;
+        // Time may be valid even if the error code is non-zero
+        location.timeUtc = timeUtc;
+        if (errorCode == 0) {
+            uLocationSharedFixSet(devHandle, &location);
+        }
+        // Give the answer to everyone who asked
+        while ((pEntry = pULocationSharedRequestPop(U_LOCATION_TYPE_GNSS,
+                                                    devHandle)) != NULL) {
+            if (pEntry->pCallback != NULL) {
+                pEntry->pCallback(devHandle, errorCode, &location);
             }
-            pEntry->pCallback(devHandle, errorCode, &location);
+            free(pEntry);
         }
-        // It is legal C to free a NULL pointer
-        free(pEntry);
 
         U_PORT_MUTEX_UNLOCK(gULocationMutex);
     }
@@ -159,32 +193,353 @@ static void cellLocCallback(uDeviceHandle_t devHandle,
 
         U_PORT_MUTEX_LOCK(gULocationMutex);
 
-        pEntry = pULocationSharedRequestPop(U_LOCATION_TYPE_CLOUD_CELL_LOCATE);
-        if ((pEntry != NULL) && (pEntry->pCallback != NULL)) {
-            if (errorCode == 0) {
-                location.type = U_LOCATION_TYPE_CLOUD_CELL_LOCATE;
-                location.latitudeX1e7 = latitudeX1e7;
-                location.longitudeX1e7 = longitudeX1e7;
-                location.altitudeMillimetres = altitudeMillimetres;
-                location.radiusMillimetres = radiusMillimetres;
-                location.speedMillimetresPerSecond = speedMillimetresPerSecond;
-                location.svs = svs;
-                location.timeUtc = timeUtc;
-                pEntry->pCallback(devHandle, errorCode, &location);
-            } else {
+        location.type = U_LOCATION_TYPE_CLOUD_CELL_LOCATE;
+        location.latitudeX1e7 = latitudeX1e7;
+        location.longitudeX1e7 = longitudeX1e7;
+        location.altitudeMillimetres = altitudeMillimetres;
+        location.radiusMillimetres = radiusMillimetres;
+        location.speedMillimetresPerSecond = speedMillimetresPerSecond;
+        location.svs = svs;
+        location.timeUtc = timeUtc;
+        if (errorCode == 0) {
+            uLocationSharedFixSet(devHandle, &location);
+        }
+        // Give the answer to everyone who asked
+        while ((pEntry = pULocationSharedRequestPop(U_LOCATION_TYPE_CLOUD_CELL_LOCATE,
+                                                    devHandle)) != NULL) {
+            if (pEntry->pCallback != NULL) {
                 // No point in populating the location for
-                // Cell Locate if the error code is zero as there's
-                // nothing valid to give
-                pEntry->pCallback(devHandle, errorCode, NULL);
+                // Cell Locate if the error code is non-zero as
+                // there's nothing valid to give
+                pEntry->pCallback(devHandle, errorCode,
+                                  (errorCode == 0) ? &location : NULL);
             }
+            free(pEntry);
         }
-        // It is legal C to free a NULL pointer
-        free(pEntry);
 
         U_PORT_MUTEX_UNLOCK(gULocationMutex);
     }
 }
 
+// Get a location from the last-fix cache that satisfies the
+// maxAgeSeconds and desiredAccuracyMillimetres fields of
+// pLocationAssist for a request of the given type on a device
+// of the given type.
+// Note: gULocationMutex should be locked before this is called.
+static bool cacheGet(int32_t devType, uLocationType_t type,
+                     const uLocationAssist_t *pLocationAssist,
+                     uLocation_t *pLocation)
+{
+    bool found = false;
+
+    if ((pLocationAssist != NULL) && (pLocationAssist->maxAgeSeconds > 0)) {
+        if (devType == (int32_t) U_DEVICE_TYPE_GNSS) {
+            // For GNSS devices the type is ignored
+            type = U_LOCATION_TYPE_GNSS;
+        }
+        if (type == U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS) {
+            // Either will do, GNSS being the more accurate
+            found = uLocationSharedFixGet(U_LOCATION_TYPE_GNSS,
+                                          pLocationAssist->maxAgeSeconds,
+                                          pLocationAssist->desiredAccuracyMillimetres,
+                                          pLocation) ||
+                    uLocationSharedFixGet(U_LOCATION_TYPE_CLOUD_CELL_LOCATE,
+                                          pLocationAssist->maxAgeSeconds,
+                                          pLocationAssist->desiredAccuracyMillimetres,
+                                          pLocation);
+        } else if (devType != (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+            found = uLocationSharedFixGet(type, pLocationAssist->maxAgeSeconds,
+                                          pLocationAssist->desiredAccuracyMillimetres,
+                                          pLocation);
+        }
+    }
+
+    return found;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: CELL LOCATE AND GNSS COMBINED
+ * -------------------------------------------------------------- */
+
+// Handle a result from one of the sources of a combined request,
+// reporting it to the user if it wins and cancelling the other
+// source if it is no longer needed.  This must be called with
+// gULocationMutex NOT locked since the cancellation of GNSS waits
+// for the GNSS task, which may itself be waiting on gULocationMutex
+// to deliver a result.
+static void combinedResult(bool fromGnss, int32_t errorCode,
+                           const uLocation_t *pLocation)
+{
+    uLocationCombined_t *pCombined = &gLocationCombined;
+    volatile bool *pPending = fromGnss ? &(pCombined->gnssPending) : &(pCombined->cellLocPending);
+    bool report = false;
+    bool meetsAccuracy;
+    bool cancelCellLoc = false;
+    bool cancelGnss = false;
+    int32_t reportErrorCode = 0;
+    uLocation_t location;
+    uDeviceHandle_t cellHandle;
+    uDeviceHandle_t gnssHandle;
+    void (*pCallback) (uDeviceHandle_t, int32_t, const uLocation_t *);
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        cellHandle = pCombined->cellHandle;
+        gnssHandle = pCombined->gnssHandle;
+        pCallback = pCombined->pCallback;
+        if ((errorCode == 0) && (pLocation != NULL)) {
+            uLocationSharedFixSet(cellHandle, pLocation);
+        }
+        // Ignore anything from a source that has been cancelled
+        if (*pPending) {
+            *pPending = false;
+            if ((errorCode == 0) && (pLocation != NULL)) {
+                // Keep the most accurate result, where an unknown
+                // radius counts as the least accurate
+                if ((pCombined->errorCode != 0) ||
+                    ((pLocation->radiusMillimetres >= 0) &&
+                     ((pCombined->location.radiusMillimetres < 0) ||
+                      (pLocation->radiusMillimetres < pCombined->location.radiusMillimetres)))) {
+                    pCombined->errorCode = 0;
+                    pCombined->location = *pLocation;
+                }
+            } else if (pCombined->errorCode != 0) {
+                pCombined->errorCode = errorCode;
+            }
+            meetsAccuracy = (errorCode == 0) && (pLocation != NULL) &&
+                            ((pCombined->desiredAccuracyMillimetres < 0) ||
+                             ((pLocation->radiusMillimetres >= 0) &&
+                              (pLocation->radiusMillimetres <= pCombined->desiredAccuracyMillimetres)));
+            if (!pCombined->reported) {
+                if (meetsAccuracy) {
+                    // First valid result wins
+                    report = true;
+                    if (fromGnss || !pCombined->refine) {
+                        cancelCellLoc = pCombined->cellLocPending;
+                        cancelGnss = pCombined->gnssPending;
+                    }
+                } else if (!pCombined->cellLocPending && !pCombined->gnssPending) {
+                    // Nothing met the desired accuracy, give the best we have
+                    report = true;
+                }
+            } else if (meetsAccuracy && (pCombined->errorCode == 0) &&
+                       (pCombined->location.radiusMillimetres >= 0) &&
+                       ((pCombined->reportedRadiusMillimetres < 0) ||
+                        (pCombined->location.radiusMillimetres < pCombined->reportedRadiusMillimetres))) {
+                // A refinement of something already reported
+                report = true;
+            }
+            if (cancelCellLoc) {
+                pCombined->cellLocPending = false;
+            }
+            if (cancelGnss) {
+                pCombined->gnssPending = false;
+            }
+            if (report) {
+                pCombined->reported = true;
+                pCombined->reportedRadiusMillimetres = pCombined->location.radiusMillimetres;
+                reportErrorCode = pCombined->errorCode;
+                location = pCombined->location;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+
+        if (cancelCellLoc) {
+            uCellLocGetStop(cellHandle);
+        }
+        if (cancelGnss) {
+            uGnssPosGetStop(gnssHandle);
+        }
+        if (report && (pCallback != NULL)) {
+            pCallback(cellHandle, reportErrorCode,
+                      (reportErrorCode == 0) ? &location : NULL);
+        }
+    }
+}
+
+// Callback for the Cell Locate part of a combined request.
+static void combinedCellLocCallback(uDeviceHandle_t devHandle,
+                                    int32_t errorCode,
+                                    int32_t latitudeX1e7,
+                                    int32_t longitudeX1e7,
+                                    int32_t altitudeMillimetres,
+                                    int32_t radiusMillimetres,
+                                    int32_t speedMillimetresPerSecond,
+                                    int32_t svs,
+                                    int64_t timeUtc)
+{
+    uLocation_t location;
+
+    (void) devHandle;
+    location.type = U_LOCATION_TYPE_CLOUD_CELL_LOCATE;
+    location.latitudeX1e7 = latitudeX1e7;
+    location.longitudeX1e7 = longitudeX1e7;
+    location.altitudeMillimetres = altitudeMillimetres;
+    location.radiusMillimetres = radiusMillimetres;
+    location.speedMillimetresPerSecond = speedMillimetresPerSecond;
+    location.svs = svs;
+    location.timeUtc = timeUtc;
+    combinedResult(false, errorCode, &location);
+}
+
+// Callback for the GNSS part of a combined request.
+static void combinedGnssPosCallback(uDeviceHandle_t devHandle,
+                                    int32_t errorCode,
+                                    int32_t latitudeX1e7,
+                                    int32_t longitudeX1e7,
+                                    int32_t altitudeMillimetres,
+                                    int32_t radiusMillimetres,
+                                    int32_t speedMillimetresPerSecond,
+                                    int32_t svs,
+                                    int64_t timeUtc)
+{
+    uLocation_t location;
+
+    (void) devHandle;
+    location.type = U_LOCATION_TYPE_GNSS;
+    location.latitudeX1e7 = latitudeX1e7;
+    location.longitudeX1e7 = longitudeX1e7;
+    location.altitudeMillimetres = altitudeMillimetres;
+    location.radiusMillimetres = radiusMillimetres;
+    location.speedMillimetresPerSecond = speedMillimetresPerSecond;
+    location.svs = svs;
+    location.timeUtc = timeUtc;
+    combinedResult(true, errorCode, &location);
+}
+
+// Start a combined request; pCallback may be NULL, in which case
+// the result is simply left in gLocationCombined.
+// Note: gULocationMutex should be locked before this is called.
+static int32_t combinedStart(uDeviceHandle_t cellHandle,
+                             const uLocationAssist_t *pLocationAssist,
+                             const char *pAuthenticationTokenStr,
+                             bool refine,
+                             void (*pCallback) (uDeviceHandle_t devHandle,
+                                                int32_t errorCode,
+                                                const uLocation_t *pLocation))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+    uLocationCombined_t *pCombined = &gLocationCombined;
+    uDeviceHandle_t gnssHandle;
+
+    if (!pCombined->cellLocPending && !pCombined->gnssPending) {
+        // Use the GNSS network attached to the cellular one if
+        // there is one, else assume a GNSS chip inside or
+        // connected via the cellular module, as for
+        // U_LOCATION_TYPE_GNSS
+        gnssHandle = uNetworkGetDeviceHandle(cellHandle, U_NETWORK_TYPE_GNSS);
+        if (gnssHandle == NULL) {
+            gnssHandle = cellHandle;
+        }
+        errorCode = cellLocConfigure(cellHandle, pLocationAssist,
+                                     pAuthenticationTokenStr);
+        if (errorCode == 0) {
+            // Cell Locate must not claim the GNSS chip, since
+            // GNSS is being asked for its position directly
+            uCellLocSetGnssEnable(cellHandle, false);
+            pCombined->cellHandle = cellHandle;
+            pCombined->gnssHandle = gnssHandle;
+            pCombined->desiredAccuracyMillimetres = -1;
+            if (pLocationAssist != NULL) {
+                pCombined->desiredAccuracyMillimetres = pLocationAssist->desiredAccuracyMillimetres;
+            }
+            pCombined->refine = refine;
+            pCombined->reported = false;
+            pCombined->errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+            pCombined->location.type = U_LOCATION_TYPE_NONE;
+            pCombined->location.radiusMillimetres = -1;
+            pCombined->reportedRadiusMillimetres = -1;
+            pCombined->pCallback = pCallback;
+            // The callbacks can't do anything until we release
+            // gULocationMutex, so it is safe to set these first
+            pCombined->cellLocPending = true;
+            pCombined->gnssPending = true;
+            errorCode = uCellLocGetStart(cellHandle, combinedCellLocCallback);
+            if (errorCode != 0) {
+                pCombined->cellLocPending = false;
+            }
+            if (uGnssPosGetStart(gnssHandle, combinedGnssPosCallback) != 0) {
+                pCombined->gnssPending = false;
+            } else {
+                // One source is enough
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Mark a combined request on the given cellular device as stopped,
+// cancelling Cell Locate and returning the handle of the GNSS device
+// that must be stopped, or NULL if there is none; the caller must
+// call uGnssPosGetStop() on that handle AFTER unlocking
+// gULocationMutex.
+// Note: gULocationMutex should be locked before this is called.
+static uDeviceHandle_t combinedStop(uDeviceHandle_t cellHandle)
+{
+    uLocationCombined_t *pCombined = &gLocationCombined;
+    uDeviceHandle_t gnssHandle = NULL;
+
+    if (pCombined->cellHandle == cellHandle) {
+        if (pCombined->cellLocPending) {
+            pCombined->cellLocPending = false;
+            uCellLocGetStop(cellHandle);
+        }
+        if (pCombined->gnssPending) {
+            pCombined->gnssPending = false;
+            gnssHandle = pCombined->gnssHandle;
+        }
+    }
+
+    return gnssHandle;
+}
+
+// Perform a combined request, blocking.
+// Note: gULocationMutex should be locked before this is called;
+// it is released while waiting so that the sources can report.
+static int32_t combinedGet(uDeviceHandle_t cellHandle,
+                           const uLocationAssist_t *pLocationAssist,
+                           const char *pAuthenticationTokenStr,
+                           uLocation_t *pLocation,
+                           bool (*pKeepGoingCallback) (uDeviceHandle_t))
+{
+    int32_t errorCode;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    uDeviceHandle_t gnssHandle;
+
+    errorCode = combinedStart(cellHandle, pLocationAssist,
+                              pAuthenticationTokenStr, false, NULL);
+    if (errorCode == 0) {
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+        while (!gLocationCombined.reported &&
+               (((pKeepGoingCallback == NULL) &&
+                 ((uPortGetTickTimeMs() - startTimeMs) / 1000 < U_LOCATION_TIMEOUT_SECONDS)) ||
+                ((pKeepGoingCallback != NULL) && pKeepGoingCallback(cellHandle)))) {
+            uPortTaskBlock(U_LOCATION_COMBINED_POLL_PERIOD_MS);
+        }
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+        errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        if (gLocationCombined.reported) {
+            errorCode = gLocationCombined.errorCode;
+            if ((errorCode == 0) && (pLocation != NULL)) {
+                *pLocation = gLocationCombined.location;
+            }
+        }
+        gnssHandle = combinedStop(cellHandle);
+        if (gnssHandle != NULL) {
+            U_PORT_MUTEX_UNLOCK(gULocationMutex);
+            uGnssPosGetStop(gnssHandle);
+            U_PORT_MUTEX_LOCK(gULocationMutex);
+        }
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -206,7 +561,13 @@ int32_t uLocationGet(uDeviceHandle_t devHandle, uLocationType_t type,
         U_PORT_MUTEX_LOCK(gULocationMutex);
 
         int32_t devType = uDeviceGetDeviceType(devHandle);
-        if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+        if (cacheGet(devType, type, pLocationAssist, &location)) {
+            // A recent enough fix will do
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (pLocation != NULL) {
+                *pLocation = location;
+            }
+        } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
         } else if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -225,6 +586,9 @@ int32_t uLocationGet(uDeviceHandle_t devHandle, uLocationType_t type,
                                             &(location.svs),
                                             &(location.timeUtc),
                                             pKeepGoingCallback);
+                    if (errorCode == 0) {
+                        uLocationSharedFixSet(devHandle, &location);
+                    }
                     if (pLocation != NULL) {
                         *pLocation = location;
                     }
@@ -243,7 +607,11 @@ int32_t uLocationGet(uDeviceHandle_t devHandle, uLocationType_t type,
                                                             pLocationAssist->multipathIndexLimit,
                                                             pLocationAssist->pseudorangeRmsErrorIndexLimit,
                                                             pLocationAssist->pClientIdStr,
+                                                            pLocationAssist->cloudLocateBatchSize,
                                                             &location, pKeepGoingCallback);
+                    if (errorCode == 0) {
+                        uLocationSharedFixSet(devHandle, &location);
+                    }
                     if (pLocation != NULL) {
                         *pLocation = location;
                     }
@@ -259,14 +627,21 @@ int32_t uLocationGet(uDeviceHandle_t devHandle, uLocationType_t type,
                                         &(location.svs),
                                         &(location.timeUtc),
                                         pKeepGoingCallback);
+                if (errorCode == 0) {
+                    uLocationSharedFixSet(devHandle, &location);
+                }
                 if (pLocation != NULL) {
-                    pLocation->type = U_LOCATION_TYPE_GNSS;
                     *pLocation = location;
                 }
+            } else if (location.type == U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS) {
+                errorCode = combinedGet(devHandle, pLocationAssist,
+                                        pAuthenticationTokenStr,
+                                        pLocation, pKeepGoingCallback);
             }
         } else if (devType == (int32_t) U_DEVICE_TYPE_GNSS) {
             // type, pLocationAssist and pAuthenticationTokenStr are
             // irrelevant in this case, we just ask GNSS
+            location.type = U_LOCATION_TYPE_GNSS;
             errorCode = uGnssPosGet(devHandle,
                                     &(location.latitudeX1e7),
                                     &(location.longitudeX1e7),
@@ -276,8 +651,10 @@ int32_t uLocationGet(uDeviceHandle_t devHandle, uLocationType_t type,
                                     &(location.svs),
                                     &(location.timeUtc),
                                     pKeepGoingCallback);
+            if (errorCode == 0) {
+                uLocationSharedFixSet(devHandle, &location);
+            }
             if (pLocation != NULL) {
-                pLocation->type = U_LOCATION_TYPE_GNSS;
                 *pLocation = location;
             }
         }
@@ -297,6 +674,7 @@ int32_t uLocationGetStart(uDeviceHandle_t devHandle, uLocationType_t type,
                                              const uLocation_t *pLocation))
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uLocation_t location;
 
     if (gULocationMutex != NULL) {
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
@@ -304,10 +682,22 @@ int32_t uLocationGetStart(uDeviceHandle_t devHandle, uLocationType_t type,
         U_PORT_MUTEX_LOCK(gULocationMutex);
 
         int32_t devType = uDeviceGetDeviceType(devHandle);
-        if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+        if (cacheGet(devType, type, pLocationAssist, &location)) {
+            // A recent enough fix will do
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (pCallback != NULL) {
+                pCallback(devHandle, errorCode, &location);
+            }
+        } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
         } else if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
-            if (type == U_LOCATION_TYPE_CLOUD_CELL_LOCATE) {
+            if ((type == U_LOCATION_TYPE_CLOUD_CELL_LOCATE) &&
+                uLocationSharedRequestIsPending(type, devHandle)) {
+                // Join the fix already in progress
+                errorCode = uLocationSharedRequestPush(devHandle,
+                                                       type,
+                                                       pCallback);
+            } else if (type == U_LOCATION_TYPE_CLOUD_CELL_LOCATE) {
                 errorCode = cellLocConfigure(devHandle,
                                              pLocationAssist,
                                              pAuthenticationTokenStr);
@@ -318,7 +708,8 @@ int32_t uLocationGetStart(uDeviceHandle_t devHandle, uLocationType_t type,
                     if (errorCode == 0) {
                         errorCode = uCellLocGetStart(devHandle, cellLocCallback);
                         if (errorCode != 0) {
-                            free(pULocationSharedRequestPop(U_LOCATION_TYPE_CLOUD_CELL_LOCATE));
+                            free(pULocationSharedRequestPop(U_LOCATION_TYPE_CLOUD_CELL_LOCATE,
+                                                            devHandle));
                         }
                     }
                 }
@@ -327,17 +718,26 @@ int32_t uLocationGetStart(uDeviceHandle_t devHandle, uLocationType_t type,
 
                 // TODO
 
+            } else if (type == U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS) {
+                errorCode = combinedStart(devHandle, pLocationAssist,
+                                          pAuthenticationTokenStr,
+                                          (pLocationAssist != NULL) && pLocationAssist->refine,
+                                          pCallback);
             }
         } else if (devType == (int32_t) U_DEVICE_TYPE_GNSS) {
             // type, pLocationAssist and pAuthenticationTokenStr are
-            // irrelevant in this case, we just ask GNSS
+            // irrelevant in this case, we just ask GNSS, joining
+            // any fix that is already in progress
+            bool joining = uLocationSharedRequestIsPending(U_LOCATION_TYPE_GNSS,
+                                                           devHandle);
             errorCode = uLocationSharedRequestPush(devHandle,
                                                    U_LOCATION_TYPE_GNSS,
                                                    pCallback);
-            if (errorCode == 0) {
+            if ((errorCode == 0) && !joining) {
                 errorCode = uGnssPosGetStart(devHandle, gnssPosCallback);
                 if (errorCode != 0) {
-                    free(pULocationSharedRequestPop(U_LOCATION_TYPE_GNSS));
+                    free(pULocationSharedRequestPop(U_LOCATION_TYPE_GNSS,
+                                                    devHandle));
                 }
             }
         }
@@ -377,6 +777,9 @@ int32_t uLocationGetStatus(uDeviceHandle_t devHandle)
 // Cancel a uLocationGetStart().
 void uLocationGetStop(uDeviceHandle_t devHandle)
 {
+    uDeviceHandle_t gnssHandle = NULL;
+    uLocationSharedFifoEntry_t *pEntry;
+
     if (gULocationMutex != NULL) {
 
         U_PORT_MUTEX_LOCK(gULocationMutex);
@@ -385,12 +788,29 @@ void uLocationGetStop(uDeviceHandle_t devHandle)
         if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
             // Irrelevant
         } else if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+            gnssHandle = combinedStop(devHandle);
             uCellLocGetStop(devHandle);
+            // Drop the requests, including any that joined, so that
+            // a later request doesn't try to join a fix that will
+            // never arrive
+            while ((pEntry = pULocationSharedRequestPop(U_LOCATION_TYPE_CLOUD_CELL_LOCATE,
+                                                        devHandle)) != NULL) {
+                free(pEntry);
+            }
         } else if (devType == (int32_t) U_DEVICE_TYPE_GNSS) {
-            uGnssPosGetStop(devHandle);
+            gnssHandle = devHandle;
+            while ((pEntry = pULocationSharedRequestPop(U_LOCATION_TYPE_GNSS,
+                                                        devHandle)) != NULL) {
+                free(pEntry);
+            }
         }
 
         U_PORT_MUTEX_UNLOCK(gULocationMutex);
+
+        if (gnssHandle != NULL) {
+            // Must be done outside the lock, see combinedResult()
+            uGnssPosGetStop(gnssHandle);
+        }
     }
 }
 
@@ -0,0 +1,482 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of continuous location, where the rate of
+ * fixes, and what provides them, follows the movement of the device.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "limits.h"    // INT_MIN
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_device_shared.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss_pwr.h"
+#include "u_gnss_cfg_val_key.h"
+#include "u_gnss_cfg.h"
+
+#include "u_location.h"
+#include "u_location_shared.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** Millimetres per ten millionth of a degree of latitude, times 1000.
+ */
+#define U_LOCATION_CONTINUOUS_MM_PER_X1E7_X1000 11132
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Mutex held by the continuous location task while it is running.
+ */
+static uPortMutexHandle_t gTaskRunningMutex = NULL;
+
+/** Semaphore given to wake the continuous location task, either
+ * to stop or because of motion.
+ */
+static uPortSemaphoreHandle_t gWakeSemaphore = NULL;
+
+/** Flag to make the continuous location task stop.
+ */
+static volatile bool gStop = false;
+
+/** Flag set by uLocationContinuousMotion().
+ */
+static volatile bool gMotion = false;
+
+/** The state of continuous location, only one at a time.
+ */
+static uLocationSharedContinuous_t gContinuous;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Keep-going callback for uLocationGet().
+static bool keepGoingCallback(uDeviceHandle_t devHandle)
+{
+    (void) devHandle;
+
+    return !gStop &&
+           ((uPortGetTickTimeMs() - gContinuous.fixStartTimeMs) / 1000 < U_LOCATION_TIMEOUT_SECONDS);
+}
+
+// Approximate the distance between two fixes in millimetres,
+// good to around ten percent, which is plenty given the
+// radius of most fixes and avoids any floating point.
+static int64_t distanceMillimetres(const uLocation_t *pA, const uLocation_t *pB)
+{
+    int64_t north;
+    int64_t east;
+    int64_t latitudeSquared; // Radians squared times one million
+    int64_t cosLatitudeX1000;
+    int64_t t;
+
+    north = ((int64_t) pA->latitudeX1e7 - pB->latitudeX1e7) *
+            U_LOCATION_CONTINUOUS_MM_PER_X1E7_X1000 / 1000;
+    // cos(latitude) = 1 - x^2/2 + x^4/24, x in radians, which is
+    // within 0.02 of the truth all the way to the poles;
+    // latitudeX1e7 * 1000 / 572957795 is radians times 1000
+    t = (int64_t) pA->latitudeX1e7 * 1000 / 572957795;
+    latitudeSquared = t * t;
+    cosLatitudeX1000 = 1000 - (latitudeSquared / 2000) +
+                       ((latitudeSquared / 1000) * (latitudeSquared / 1000) / 24000);
+    if (cosLatitudeX1000 < 0) {
+        cosLatitudeX1000 = 0;
+    }
+    east = ((int64_t) pA->longitudeX1e7 - pB->longitudeX1e7) *
+           U_LOCATION_CONTINUOUS_MM_PER_X1E7_X1000 / 1000 * cosLatitudeX1000 / 1000;
+    if (north < 0) {
+        north = -north;
+    }
+    if (east < 0) {
+        east = -east;
+    }
+    // Octagonal approximation to the square root of the sum of squares
+    if (north > east) {
+        t = north + (east / 2);
+    } else {
+        t = east + (north / 2);
+    }
+
+    return t;
+}
+
+// Return true if the position of pB is clearly not that of pA,
+// i.e. they are further apart than their radii put together.
+static bool displaced(const uLocation_t *pA, const uLocation_t *pB)
+{
+    int64_t radii = 0;
+
+    if (pA->radiusMillimetres > 0) {
+        radii += pA->radiusMillimetres;
+    }
+    if (pB->radiusMillimetres > 0) {
+        radii += pB->radiusMillimetres;
+    }
+
+    return distanceMillimetres(pA, pB) > radii;
+}
+
+// Do what is required with GNSS on entering or leaving the
+// stationary state.
+static void gnssStationary(uLocationSharedContinuous_t *pContinuous, bool stationary)
+{
+    if (pContinuous->isGnss) {
+        switch (pContinuous->cfg.gnssStationary) {
+            case U_LOCATION_CONTINUOUS_GNSS_STATIONARY_POWER_SAVE:
+                U_GNSS_CFG_SET_VAL_RAM(pContinuous->devHandle, PM_OPERATEMODE_E1,
+                                       stationary ?
+                                       U_GNSS_CFG_VAL_KEY_ITEM_VALUE_PM_OPERATEMODE_PSMCT :
+                                       U_GNSS_CFG_VAL_KEY_ITEM_VALUE_PM_OPERATEMODE_FULL);
+                break;
+            case U_LOCATION_CONTINUOUS_GNSS_STATIONARY_OFF:
+                if (stationary) {
+                    uGnssPwrOff(pContinuous->devHandle);
+                } else {
+                    uGnssPwrOn(pContinuous->devHandle);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Move to the stationary state.
+static void enterStationary(uLocationSharedContinuous_t *pContinuous,
+                            const uLocation_t *pLocation)
+{
+    pContinuous->stationary = true;
+    pContinuous->numSlowFixes = 0;
+    pContinuous->anchor = *pLocation;
+    gnssStationary(pContinuous, true);
+}
+
+// Leave the stationary state, taking the next fix quickly.
+static void leaveStationary(uLocationSharedContinuous_t *pContinuous)
+{
+    gnssStationary(pContinuous, false);
+    pContinuous->stationary = false;
+    pContinuous->numSlowFixes = 0;
+    pContinuous->periodMs = pContinuous->cfg.periodMinMs;
+    // Don't estimate speed across the stationary period
+    pContinuous->lastTimeMs = -1;
+}
+
+// The continuous location task.
+static void continuousTask(void *pParam)
+{
+    uLocationSharedContinuous_t *pContinuous = (uLocationSharedContinuous_t *) pParam;
+    const uLocationContinuousCfg_t *pCfg = &(pContinuous->cfg);
+    uDeviceHandle_t devHandle;
+    uLocationType_t type;
+    uLocation_t location;
+    int32_t errorCode;
+    bool gnssOffNow;
+
+    U_PORT_MUTEX_LOCK(gTaskRunningMutex);
+
+    while (!gStop) {
+        if (gMotion) {
+            gMotion = false;
+            if (pContinuous->stationary) {
+                leaveStationary(pContinuous);
+            }
+        }
+        if (!pContinuous->stationary || (pCfg->periodStationaryMs >= 0)) {
+            devHandle = pContinuous->devHandle;
+            type = pContinuous->type;
+            if (pContinuous->stationary) {
+                if (pCfg->devHandleStationary != NULL) {
+                    devHandle = pCfg->devHandleStationary;
+                }
+                if (pCfg->typeStationary != U_LOCATION_TYPE_NONE) {
+                    type = pCfg->typeStationary;
+                }
+            }
+            // If a stationary fix needs a GNSS device that we have
+            // switched off, switch it on just for the fix
+            gnssOffNow = pContinuous->stationary && pContinuous->isGnss &&
+                         (devHandle == pContinuous->devHandle) &&
+                         (pCfg->gnssStationary == U_LOCATION_CONTINUOUS_GNSS_STATIONARY_OFF);
+            if (gnssOffNow) {
+                uGnssPwrOn(devHandle);
+            }
+            pContinuous->fixStartTimeMs = uPortGetTickTimeMs();
+            errorCode = uLocationGet(devHandle, type, &(pContinuous->assist),
+                                     pContinuous->pAuthenticationTokenStr,
+                                     &location, keepGoingCallback);
+            if (!gStop) {
+                if (errorCode == 0) {
+                    uLocationSharedContinuousUpdate(pContinuous, &location,
+                                                    uPortGetTickTimeMs());
+                }
+                pContinuous->pCallback(pContinuous->devHandle, errorCode,
+                                       (errorCode == 0) ? &location : NULL);
+            }
+            if (gnssOffNow && pContinuous->stationary) {
+                uGnssPwrOff(devHandle);
+            }
+        }
+        // Wait for the period, motion or to be told to stop
+        if (!gStop && !gMotion) {
+            if (!pContinuous->stationary) {
+                uPortSemaphoreTryTake(gWakeSemaphore, pContinuous->periodMs);
+            } else if (pCfg->periodStationaryMs >= 0) {
+                uPortSemaphoreTryTake(gWakeSemaphore, pCfg->periodStationaryMs);
+            } else {
+                uPortSemaphoreTake(gWakeSemaphore);
+            }
+        }
+    }
+
+    // Leave GNSS as we found it
+    if (pContinuous->stationary) {
+        gnssStationary(pContinuous, false);
+        pContinuous->stationary = false;
+    }
+
+    U_PORT_MUTEX_UNLOCK(gTaskRunningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS THAT ARE SHARED INTERNALLY
+ * -------------------------------------------------------------- */
+
+// Update the state of continuous location with a new fix.
+void uLocationSharedContinuousUpdate(uLocationSharedContinuous_t *pContinuous,
+                                     const uLocation_t *pLocation,
+                                     int32_t nowMs)
+{
+    const uLocationContinuousCfg_t *pCfg = &(pContinuous->cfg);
+    int32_t desiredAccuracyMillimetres = pContinuous->assist.desiredAccuracyMillimetres;
+    int64_t speed = pLocation->speedMillimetresPerSecond;
+    int64_t periodMs;
+
+    if ((desiredAccuracyMillimetres < 0) || (pLocation->radiusMillimetres < 0) ||
+        (pLocation->radiusMillimetres <= desiredAccuracyMillimetres)) {
+        if (pContinuous->stationary) {
+            if (((speed != INT_MIN) && (speed >= pCfg->stationarySpeedMillimetresPerSecond)) ||
+                displaced(&(pContinuous->anchor), pLocation)) {
+                leaveStationary(pContinuous);
+            }
+        } else {
+            if ((speed == INT_MIN) && (pContinuous->lastTimeMs >= 0) &&
+                (nowMs - pContinuous->lastTimeMs > 0)) {
+                // No speed with the fix (e.g. Cell Locate): estimate
+                // it from how far we've come since the last one
+                speed = 0;
+                if (displaced(&(pContinuous->last), pLocation)) {
+                    speed = distanceMillimetres(&(pContinuous->last), pLocation) * 1000 /
+                            (nowMs - pContinuous->lastTimeMs);
+                }
+            }
+            if (speed != INT_MIN) {
+                if (speed < pCfg->stationarySpeedMillimetresPerSecond) {
+                    pContinuous->numSlowFixes++;
+                    if (pContinuous->numSlowFixes >= pCfg->stationaryNumFixes) {
+                        enterStationary(pContinuous, pLocation);
+                    }
+                } else {
+                    pContinuous->numSlowFixes = 0;
+                    periodMs = (int64_t) pCfg->distanceMillimetres * 1000 / speed;
+                    if (periodMs < pCfg->periodMinMs) {
+                        periodMs = pCfg->periodMinMs;
+                    }
+                    if (periodMs > pCfg->periodMaxMs) {
+                        periodMs = pCfg->periodMaxMs;
+                    }
+                    pContinuous->periodMs = (int32_t) periodMs;
+                }
+            }
+        }
+        pContinuous->last = *pLocation;
+        pContinuous->lastTimeMs = nowMs;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start continuous location.
+int32_t uLocationContinuousStart(uDeviceHandle_t devHandle, uLocationType_t type,
+                                 const uLocationAssist_t *pLocationAssist,
+                                 const char *pAuthenticationTokenStr,
+                                 const uLocationContinuousCfg_t *pCfg,
+                                 void (*pCallback) (uDeviceHandle_t devHandle,
+                                                    int32_t errorCode,
+                                                    const uLocation_t *pLocation))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uLocationAssist_t assist = U_LOCATION_ASSIST_DEFAULTS;
+    uLocationContinuousCfg_t cfg = U_LOCATION_CONTINUOUS_CFG_DEFAULTS;
+    uPortTaskHandle_t taskHandle;
+
+    if (pCfg != NULL) {
+        cfg = *pCfg;
+    }
+    if (pLocationAssist != NULL) {
+        assist = *pLocationAssist;
+    }
+    if ((devHandle != NULL) && (pCallback != NULL) &&
+        (cfg.periodMinMs > 0) && (cfg.periodMaxMs >= cfg.periodMinMs) &&
+        (cfg.distanceMillimetres > 0) && (cfg.stationaryNumFixes > 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+        // Only one at a time
+        if (gTaskRunningMutex == NULL) {
+            errorCode = uPortMutexCreate(&gTaskRunningMutex);
+            if (errorCode == 0) {
+                errorCode = uPortSemaphoreCreate(&gWakeSemaphore, 0, 1);
+                if (errorCode == 0) {
+                    gContinuous.devHandle = devHandle;
+                    gContinuous.type = type;
+                    gContinuous.assist = assist;
+                    gContinuous.pAuthenticationTokenStr = pAuthenticationTokenStr;
+                    gContinuous.cfg = cfg;
+                    gContinuous.pCallback = pCallback;
+                    gContinuous.isGnss = (uDeviceGetDeviceType(devHandle) == (int32_t) U_DEVICE_TYPE_GNSS);
+                    gContinuous.stationary = false;
+                    gContinuous.numSlowFixes = 0;
+                    gContinuous.periodMs = cfg.periodMinMs;
+                    gContinuous.lastTimeMs = -1;
+                    gStop = false;
+                    gMotion = false;
+                    errorCode = uPortTaskCreate(continuousTask, "locContinuous",
+                                                U_LOCATION_CONTINUOUS_TASK_STACK_SIZE_BYTES,
+                                                &gContinuous,
+                                                U_LOCATION_CONTINUOUS_TASK_PRIORITY,
+                                                &taskHandle);
+                    if (errorCode == 0) {
+                        // Wait for the task to have hold of its running
+                        // mutex so that uLocationContinuousStop() can't miss it
+                        while (uPortMutexTryLock(gTaskRunningMutex, 0) == 0) {
+                            uPortMutexUnlock(gTaskRunningMutex);
+                            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                        }
+                    }
+                }
+            }
+            if (errorCode != 0) {
+                // Clean up on error
+                if (gWakeSemaphore != NULL) {
+                    uPortSemaphoreDelete(gWakeSemaphore);
+                    gWakeSemaphore = NULL;
+                }
+                if (gTaskRunningMutex != NULL) {
+                    uPortMutexDelete(gTaskRunningMutex);
+                    gTaskRunningMutex = NULL;
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Tell continuous location that the device has moved.
+int32_t uLocationContinuousMotion(uDeviceHandle_t devHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gTaskRunningMutex != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (devHandle == gContinuous.devHandle) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (gContinuous.stationary) {
+                gMotion = true;
+                uPortSemaphoreGive(gWakeSemaphore);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Get the current period of continuous location.
+int32_t uLocationContinuousGetPeriodMs(uDeviceHandle_t devHandle)
+{
+    int32_t errorCodeOrPeriodMs = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gTaskRunningMutex != NULL) {
+        errorCodeOrPeriodMs = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (devHandle == gContinuous.devHandle) {
+            errorCodeOrPeriodMs = gContinuous.periodMs;
+            if (gContinuous.stationary) {
+                errorCodeOrPeriodMs = 0;
+                if (gContinuous.cfg.periodStationaryMs >= 0) {
+                    errorCodeOrPeriodMs = gContinuous.cfg.periodStationaryMs;
+                }
+            }
+        }
+    }
+
+    return errorCodeOrPeriodMs;
+}
+
+// Stop continuous location.
+void uLocationContinuousStop(uDeviceHandle_t devHandle)
+{
+    if ((gTaskRunningMutex != NULL) && (devHandle == gContinuous.devHandle)) {
+        gStop = true;
+        uPortSemaphoreGive(gWakeSemaphore);
+        // Wait for the task to exit
+        U_PORT_MUTEX_LOCK(gTaskRunningMutex);
+        U_PORT_MUTEX_UNLOCK(gTaskRunningMutex);
+        // Give it a moment to delete itself
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        uPortSemaphoreDelete(gWakeSemaphore);
+        gWakeSemaphore = NULL;
+        uPortMutexDelete(gTaskRunningMutex);
+        gTaskRunningMutex = NULL;
+    }
+}
+
+// End of file
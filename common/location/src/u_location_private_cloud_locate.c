@@ -30,7 +30,7 @@
 # include "u_cfg_override.h" // For a customer's configuration override
 #endif
 
-#include "limits.h"    // INT_MAX
+#include "limits.h"    // INT_MAX, INT_MIN
 #include "stdlib.h"    // malloc()/free()
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
@@ -42,11 +42,11 @@
 #include "u_error_common.h"
 
 #include "u_port.h"
-#include "u_port_clib_platform_specific.h" // strtok_r()
 #include "u_port_os.h"
 #include "u_port_debug.h"
 
 #include "u_time.h"
+#include "u_json.h"
 
 #include "u_gnss_pos.h"
 
@@ -60,21 +60,6 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-#ifndef U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES
-/** The size of buffer for the RRLP data used by Cloud Locate,
- * should not be more than 1024 bytes which is the maximum
- * MQTT message length supported by the u-blox cellular modules.
- */
-# define U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES 1024
-#endif
-
-#ifndef U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC
-/** The name of the MQTT topic to which RRLP data is
- * published for Cloud Locate.
- */
-# define U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC "CloudLocate/GNSS/request"
-#endif
-
 #ifndef U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_SUBSCRIBE_TOPIC_PREFIX
 /** The start of the name of the MQTT topic to subscribe to for
  * a location established through the Cloud Locate service;
@@ -112,217 +97,335 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** An item of the location sent back by the Cloud Locate service.
+ */
+typedef struct {
+    const char *pKey;
+    int32_t powerOfTen; /**< the multiplier to apply to a number, -1
+                             for the time, which is a string. */
+} uLocationPrivateCloudLocateItem_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The items of the location sent back by the Cloud Locate service,
+ * in the order of the bits of the "found" bit-map in
+ * uLocationPrivateCloudLocateParse().
+ */
+static const uLocationPrivateCloudLocateItem_t gItem[] = {{"Lat", 7},
+    {"Lon", 7},
+    {"Alt", 3},
+    {"Acc", 3},
+    {"MeasTime", -1}
+};
+
+/** RRLP data held back to be uploaded as a batch, NULL if there
+ * is none; protected by gULocationMutex, which the caller of
+ * uLocationPrivateCloudLocate() holds.
+ */
+static char *gpBatch = NULL;
+
+/** The number of bytes in gpBatch.
+ */
+static size_t gBatchLength = 0;
+
+/** The number of RRLP data blocks in gpBatch.
+ */
+static int32_t gBatchCount = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
-// Convert a string containing a [fractional] decimal number,
-// something like "-758.7387289" (should be null-terminated) into
-// an int32_t with the given power of ten multiplier.
-// Any leading crap is ignored and conversion stops when a
-// non-numeric character is reached after the number has begun.
-static int32_t stringToInt32(char *pStr, int32_t *pNumber,
-                             int32_t powerOfTenWanted,
-                             int32_t maxFractionalDigits,
-                             char **ppEnd)
+// Parse a time of the form "2021-11-09T18:24:11", which need not
+// be null-terminated, into UTC seconds.
+static int32_t parseTime(const char *pStr, size_t length, int64_t *pTimeUtc)
 {
     int32_t errorCode = -1;
-    int64_t int64 = 0;
-    bool negate = false;
-    bool fraction = false;
-    int32_t powerOfTen = 0;
-    int32_t y = 0;
-
-    *pNumber = 0;
-
-    // Find the start of a decimal number
-    while (!isdigit((int32_t) *pStr) &&
-           (*pStr != '+') && (*pStr != '-') && (*pStr != '.') && (*pStr != 0)) {
-        pStr++;
-    }
+    // Year, month, day, hours, minutes, seconds
+    int32_t field[6] = {0};
+    size_t x = 0;
+    bool tooLong = false;
+    int32_t months;
 
-    if (*pStr != 0) {
-        errorCode = 0;
-        if (*pStr == '-') {
-            negate = true;
-        }
-        if (!isdigit((int32_t) *pStr)) {
-            pStr++;
-        }
-        // Now we've dealt with the sign, we should have a number
-        while ((errorCode == 0) && (*pStr != 0) &&
-               (powerOfTen < maxFractionalDigits) &&
-               (y == 0)) {
-            if (isdigit((int32_t) *pStr)) {
-                // Add the digit to the result
-                int64 *= 10;
-                int64 += *pStr - '0';
-                if (int64 > INT_MAX) {
-                    errorCode = -1;
-                } else {
-                    if (fraction) {
-                        powerOfTen++;
-                    }
-                }
-            } else if (!fraction && (*pStr == '.')) {
-                fraction = true;
+    for (size_t y = 0; (y < length) && (x < sizeof(field) / sizeof(field[0])); y++) {
+        if (isdigit((int32_t) * (pStr + y))) {
+            if (field[x] < 10000) {
+                field[x] = (field[x] * 10) + (*(pStr + y) - '0');
             } else {
-                y = -1;
-            }
-            pStr++;
-        }
-    }
-
-    if (errorCode == 0) {
-        // Having obtained the number, adjust it to be the
-        // wanted power of 10. For instance, if we had 356.21,
-        // which would mean int64 = 35621 and powerOfTen = 2,
-        // then if powerOfTenWanted was 3 the result should be
-        // 356210
-        y = powerOfTenWanted - powerOfTen;
-        if (y > 0) {
-            for (int32_t x = 0; x < y; x++) {
-                int64 *= 10;
+                // No field is this long, stop before it overflows
+                tooLong = true;
             }
         } else {
-            for (int32_t x = y; x < 0; x++) {
-                int64 /= 10;
-            }
+            // Any of "-", "T" or ":" moves us on to the next field
+            x++;
         }
-        if (negate) {
-            int64 = -int64;
-        }
-        *pNumber = (int32_t) int64;
     }
 
-    if (ppEnd != NULL) {
-        *ppEnd = pStr;
+    // Four digit year converted to years since 1970
+    if (!tooLong && (x >= sizeof(field) / sizeof(field[0]) - 1) && (field[0] >= 2021) &&
+        (field[1] >= 1) && (field[1] <= 12)) {
+        // Month (1 to 12), so take away 1 to make it zero-based
+        months = ((field[0] - 1970) * 12) + field[1] - 1;
+        // Work out the number of seconds due to the year/month count
+        *pTimeUtc = uTimeMonthsToSecondsUtc(months);
+        // Day (1 to 31), hours, minutes and seconds
+        *pTimeUtc += ((int64_t) (field[2] - 1) * 3600 * 24) +
+                     ((int64_t) field[3] * 3600) + (field[4] * 60) + field[5];
+        errorCode = 0;
     }
 
     return errorCode;
 }
 
-// Find the start of the value of a single item, e.g.
-// for \"Lat\":52.018749899999996 pKey would
-// be "\"Lat\"", and a pointer to the character 5 would
-// be returned
-static char *pFindItem(char *pStr, const char *pKey)
+// Set the field of pLocation for the item at the given index of gItem[].
+static void setItem(uLocation_t *pLocation, size_t index, int32_t value)
 {
-    if (pStr != NULL) {
-        pStr = strstr(pStr, pKey);
-        if (pStr != NULL) {
-            // Move on to the ':'
-            pStr = strstr(pStr, ":");
-            if (pStr != NULL) {
-                // Move beyond the ":"
-                pStr++;
-            }
+    switch (index) {
+        case 0:
+            pLocation->latitudeX1e7 = value;
+            break;
+        case 1:
+            pLocation->longitudeX1e7 = value;
+            break;
+        case 2:
+            pLocation->altitudeMillimetres = value;
+            break;
+        case 3:
+            pLocation->radiusMillimetres = value;
+            break;
+        default:
+            break;
+    }
+}
+
+// Find a key in gItem[], returning its index or -1.
+static int32_t findItem(const char *pKey, size_t keyLength)
+{
+    int32_t index = -1;
+
+    for (size_t x = 0; (index < 0) && (x < sizeof(gItem) / sizeof(gItem[0])); x++) {
+        if ((strlen(gItem[x].pKey) == keyLength) &&
+            (strncmp(gItem[x].pKey, pKey, keyLength) == 0)) {
+            index = (int32_t) x;
         }
     }
 
-    return pStr;
+    return index;
 }
 
-// Parse location out of a message of the form:
+// Parse location out of a JSON message of the form:
 //
 // "{"Lat":52.018749899999996,"Lon":0.2471071,"Alt":120.21600000000001,"Acc":29.877,"MeasTime":"2021-11-09T18:24:11","Epochs":1}"
 //
-// Note that pStr is MODIFIED in this process.
-static int32_t parseLocation(char *pStr, uLocation_t *pLocation)
+// ...returning a bit-map of the items of gItem[] that were found.
+static uint32_t parseLocationJson(const char *pStr, size_t length,
+                                  uLocation_t *pLocation)
 {
-    char *pSaved;
+    uint32_t found = 0;
+    const char *pKey[sizeof(gItem) / sizeof(gItem[0])];
+    uJsonItem_t item[sizeof(gItem) / sizeof(gItem[0])];
     int32_t x;
-    int32_t year;
-    int32_t months;
 
-    pStr = pFindItem(pStr, "\"Lat\"");
-    if (pStr != NULL) {
-        // pStr should now point at 52.018749899999996
-        if (stringToInt32(pStr, &x, 7, 7, &pStr) == 0) {
-            pLocation->latitudeX1e7 = x;
-        } else {
-            pStr = NULL;
-        }
+    for (size_t y = 0; y < sizeof(gItem) / sizeof(gItem[0]); y++) {
+        pKey[y] = gItem[y].pKey;
     }
-    pStr = pFindItem(pStr, "\"Lon\"");
-    if (pStr != NULL) {
-        // pStr should now point at 0.2471071
-        if (stringToInt32(pStr, &x, 7, 7, &pStr) == 0) {
-            pLocation->longitudeX1e7 = x;
-        } else {
-            pStr = NULL;
+    if (uJsonFind(pStr, length, pKey, sizeof(pKey) / sizeof(pKey[0]), item) > 0) {
+        for (size_t y = 0; y < sizeof(gItem) / sizeof(gItem[0]); y++) {
+            if (gItem[y].powerOfTen < 0) {
+                if ((item[y].type == U_JSON_TYPE_STRING) &&
+                    (parseTime(item[y].pValue, item[y].valueLength,
+                               &(pLocation->timeUtc)) == 0)) {
+                    found |= 1U << y;
+                }
+            } else if (uJsonToInt32(&(item[y]), gItem[y].powerOfTen, &x) == 0) {
+                setItem(pLocation, y, x);
+                found |= 1U << y;
+            }
         }
     }
-    pStr = pFindItem(pStr, "\"Alt\"");
-    if (pStr != NULL) {
-        // pStr should now point at 120.21600000000001
-        if (stringToInt32(pStr, &x, 3, 3, &pStr) == 0) {
-            pLocation->altitudeMillimetres = x;
-        } else {
-            pStr = NULL;
-        }
+
+    return found;
+}
+
+// Read a big-endian unsigned integer of the given number of bytes.
+static uint64_t readBigEndian(const char *pBuffer, size_t length)
+{
+    uint64_t value = 0;
+
+    for (size_t x = 0; x < length; x++) {
+        value = (value << 8) | (uint8_t) * (pBuffer + x);
     }
-    pStr = pFindItem(pStr, "\"Acc\"");
-    if (pStr != NULL) {
-        // pStr should now point at 29.877
-        if (stringToInt32(pStr, &x, 3, 3, &pStr) == 0) {
-            pLocation->radiusMillimetres = x;
+
+    return value;
+}
+
+// Parse location, in a single pass, out of a MessagePack message
+// which is a map containing the same keys as the JSON form, where
+// a number may be an integer or a float and "MeasTime" may be a
+// string, as in the JSON form, or an integer number of UTC seconds;
+// returns a bit-map of the items of gItem[] that were found.
+static uint32_t parseLocationMsgPack(const char *pBuffer, size_t length,
+                                     uLocation_t *pLocation)
+{
+    uint32_t found = 0;
+    const char *pEnd = pBuffer + length;
+    size_t numItems = 0;
+    const char *pKey;
+    size_t keyLength;
+    int32_t index;
+    uint8_t type;
+    size_t valueLength;
+    uint64_t raw;
+    float f;
+    uint32_t u32;
+    double d = 0;
+    int64_t i64 = 0;
+    int64_t scale;
+    bool isInteger;
+    bool isNumber;
+    bool inRange;
+
+    // The map header
+    type = (uint8_t) *pBuffer;
+    if ((type & 0xf0) == 0x80) {
+        numItems = type & 0x0f;
+        pBuffer++;
+    } else if ((type == 0xde) && (length >= 3)) {
+        numItems = (size_t) readBigEndian(pBuffer + 1, 2);
+        pBuffer += 3;
+    }
+
+    for (size_t x = 0; (x < numItems) && (pBuffer < pEnd); x++) {
+        // The key, which must be a string
+        type = (uint8_t) *pBuffer;
+        if ((type & 0xe0) == 0xa0) {
+            keyLength = type & 0x1f;
+            pBuffer++;
+        } else if ((type == 0xd9) && (pEnd - pBuffer > 1)) {
+            keyLength = (uint8_t) * (pBuffer + 1);
+            pBuffer += 2;
         } else {
-            pStr = NULL;
+            break;
         }
-    }
-    pStr = pFindItem(pStr, "\"MeasTime\"");
-    if (pStr != NULL) {
-        // pStr should now point at \"2021-11-09T18:24:11\",
-        // i.e. including the quotes
-        // Tokenise on "-"
-        pStr = strtok_r(pStr, "-", &pSaved);
-        // Skip the opening quote
-        pStr++;
-        // Four digit year converted to years since 1970
-        year = strtol(pStr, NULL, 10) - 1970;
-        if (year >= 2021 - 1970) {
-            // Move pStr to the start of the month
-            pStr = strtok_r(NULL, "-", &pSaved);
-            if (pStr != NULL) {
-                // Month (1 to 12), so take away 1 to make it zero-based
-                months = strtol(pStr, NULL, 10) - 1;
-                months += year * 12;
-                // Work out the number of seconds due to the year/month count
-                pLocation->timeUtc = uTimeMonthsToSecondsUtc(months);
-            }
-            // Move pStr to the start of the day and tokenize-out the "T"
-            pStr = strtok_r(NULL, "T", &pSaved);
-            if (pStr != NULL) {
-                // Day (1 to 31)
-                pLocation->timeUtc += (int64_t) (strtol(pStr, NULL, 10) - 1) * 3600 * 24;
-            }
-            // Move pStr to the start of the hours and tokenize-out the ":"
-            pStr = strtok_r(NULL, ":", &pSaved);
-            if (pStr != NULL) {
-                // Hours since midnight
-                pLocation->timeUtc  += (int64_t) strtol(pStr, NULL, 10) * 3600;
+        // Compare lengths rather than pointers, which must not go
+        // beyond pEnd; there must also be room for a value
+        if (keyLength >= (size_t) (pEnd - pBuffer)) {
+            break;
+        }
+        pKey = pBuffer;
+        pBuffer += keyLength;
+        index = findItem(pKey, keyLength);
+        // The value
+        type = (uint8_t) *pBuffer;
+        pBuffer++;
+        isNumber = true;
+        isInteger = true;
+        valueLength = 0;
+        if (type <= 0x7f) {
+            i64 = type;
+        } else if (type >= 0xe0) {
+            i64 = (int8_t) type;
+        } else if ((type >= 0xcc) && (type <= 0xcf)) {
+            // uint 8, 16, 32 or 64
+            valueLength = (size_t) 1 << (type - 0xcc);
+        } else if ((type >= 0xd0) && (type <= 0xd3)) {
+            // int 8, 16, 32 or 64
+            valueLength = (size_t) 1 << (type - 0xd0);
+        } else if ((type == 0xca) || (type == 0xcb)) {
+            // float 32 or 64
+            valueLength = (type == 0xca) ? 4 : 8;
+            isInteger = false;
+        } else {
+            isNumber = false;
+            if ((type & 0xe0) == 0xa0) {
+                valueLength = type & 0x1f;
+            } else if ((type == 0xd9) && (pBuffer < pEnd)) {
+                valueLength = (uint8_t) *pBuffer;
+                pBuffer++;
+            } else if ((type != 0xc0) && (type != 0xc2) && (type != 0xc3)) {
+                // Not nil or a boolean, which we could step over,
+                // and not something we can skip
+                break;
             }
-            // Move pStr to Minutes after the hour
-            pStr = strtok_r(NULL, ":", &pSaved);
-            if (pStr != NULL) {
-                pLocation->timeUtc  += (int64_t) strtol(pStr, NULL, 10) * 60;
+        }
+        if (valueLength > (size_t) (pEnd - pBuffer)) {
+            break;
+        }
+        if (isNumber && (valueLength > 0)) {
+            raw = readBigEndian(pBuffer, valueLength);
+            if (!isInteger) {
+                if (valueLength == 4) {
+                    u32 = (uint32_t) raw;
+                    memcpy(&f, &u32, sizeof(f));
+                    d = f;
+                } else {
+                    memcpy(&d, &raw, sizeof(d));
+                }
+            } else if ((type >= 0xd0) && (valueLength < 8)) {
+                // Sign-extend
+                i64 = (int64_t) (raw << (64 - (valueLength * 8))) >> (64 - (valueLength * 8));
+            } else if ((type == 0xcf) && (raw > INT64_MAX)) {
+                // Too big for us, and must not become negative
+                i64 = INT64_MAX;
+            } else {
+                i64 = (int64_t) raw;
             }
-            // Move pStr to Seconds after the hour, which ends at the final quotation mark
-            pStr = strtok_r(NULL, ":", &pSaved);
-            if (pStr != NULL) {
-                pLocation->timeUtc += (int64_t) strtol(pStr, NULL, 10);
+        }
+        if (index >= 0) {
+            if (gItem[index].powerOfTen < 0) {
+                if (!isNumber) {
+                    if (parseTime(pBuffer, valueLength, &(pLocation->timeUtc)) == 0) {
+                        found |= 1U << index;
+                    }
+                } else if (isInteger) {
+                    pLocation->timeUtc = i64;
+                    found |= 1U << index;
+                }
+            } else if (isNumber) {
+                scale = 1;
+                for (int32_t y = 0; y < gItem[index].powerOfTen; y++) {
+                    scale *= 10;
+                }
+                inRange = false;
+                if (isInteger) {
+                    // Check the range before scaling, which
+                    // would otherwise overflow
+                    if ((i64 <= INT_MAX / scale) && (i64 >= INT_MIN / scale)) {
+                        i64 *= scale;
+                        inRange = true;
+                    }
+                } else {
+                    d *= scale;
+                    // Converting a double that is out of range to an
+                    // integer is undefined; NaN fails both comparisons
+                    if ((d > (double) INT_MIN - 1) && (d < (double) INT_MAX + 1)) {
+                        // Round to the nearest
+                        i64 = (int64_t) (d + ((d < 0) ? -0.5 : 0.5));
+                        inRange = (i64 <= INT_MAX) && (i64 >= INT_MIN);
+                    }
+                }
+                if (inRange) {
+                    setItem(pLocation, index, (int32_t) i64);
+                    found |= 1U << index;
+                }
             }
-        } else {
-            pStr = NULL;
         }
+        pBuffer += valueLength;
     }
 
-    return pStr != NULL ? (int32_t) U_ERROR_COMMON_SUCCESS : (int32_t) U_ERROR_COMMON_UNKNOWN;
+    return found;
+}
+
+// Upload data to the Cloud Locate service with MQTT.
+static int32_t publish(uMqttClientContext_t *pMqttClientContext,
+                       const char *pTopicNameStr, const char *pMessage,
+                       size_t messageSizeBytes)
+{
+    return uMqttClientPublish(pMqttClientContext, pTopicNameStr,
+                              pMessage, messageSizeBytes,
+                              U_MQTT_QOS_EXACTLY_ONCE, false);
 }
 
 /* ----------------------------------------------------------------
@@ -338,6 +441,7 @@ int32_t uLocationPrivateCloudLocate(uDeviceHandle_t devHandle,
                                     int32_t multipathIndexLimit,
                                     int32_t pseudorangeRmsErrorIndexLimit,
                                     const char *pClientIdStr,
+                                    int32_t batchSize,
                                     uLocation_t *pLocation,
                                     bool (*pKeepGoingCallback) (uDeviceHandle_t))
 {
@@ -357,7 +461,12 @@ int32_t uLocationPrivateCloudLocate(uDeviceHandle_t devHandle,
         pBuffer = (char *) malloc(U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES);
         if (pBuffer != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-            if ((pClientIdStr != NULL) && (pLocation != NULL)) {
+            if ((pClientIdStr != NULL) || (batchSize <= 1)) {
+                // Not batching this time, upload anything
+                // that was held back from before
+                errorCode = uLocationPrivateCloudLocateBatchFlush(pMqttClientContext, publish);
+            }
+            if ((errorCode == 0) && (pClientIdStr != NULL) && (pLocation != NULL)) {
                 // If the device also wanted the location, assemble the name
                 // of the subscribe topic and subscribe to it
                 strncpy(topicBuffer, U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_SUBSCRIBE_TOPIC_PREFIX,
@@ -377,12 +486,16 @@ int32_t uLocationPrivateCloudLocate(uDeviceHandle_t devHandle,
                                             svsThreshold, cNoThreshold, multipathIndexLimit,
                                             pseudorangeRmsErrorIndexLimit,
                                             pKeepGoingCallback);
-                if (errorCode >= 0) {
+                if ((errorCode >= 0) && (pClientIdStr == NULL) && (batchSize > 1)) {
+                    // Hold the RRLP data back to be sent as part of a batch
+                    errorCode = uLocationPrivateCloudLocateBatchAdd(pMqttClientContext,
+                                                                    pBuffer, errorCode,
+                                                                    batchSize, publish);
+                } else if (errorCode >= 0) {
                     // Send the RRLP data to the Cloud Locate service using MQTT
-                    errorCode = uMqttClientPublish(pMqttClientContext,
-                                                   U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC,
-                                                   pBuffer, errorCode,
-                                                   U_MQTT_QOS_EXACTLY_ONCE, false);
+                    errorCode = publish(pMqttClientContext,
+                                        U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC,
+                                        pBuffer, errorCode);
                 }
             }
 
@@ -403,8 +516,7 @@ int32_t uLocationPrivateCloudLocate(uDeviceHandle_t devHandle,
                 errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
                 pTopicBufferRead = (char *) malloc(U_LOCATION_PRIVATE_CLOUD_LOCATE_SUBSCRIBE_TOPIC_LENGTH_BYTES);
                 if (pTopicBufferRead != NULL) {
-                    // +1 to allow us to insert a terminator
-                    pMessageRead = (char *) malloc(U_LOCATION_PRIVATE_CLOUD_LOCATE_READ_MESSAGE_LENGTH_BYTES + 1);
+                    pMessageRead = (char *) malloc(U_LOCATION_PRIVATE_CLOUD_LOCATE_READ_MESSAGE_LENGTH_BYTES);
                     if (pMessageRead != NULL) {
                         errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
                         uPortLog("U_LOCATION_PRIVATE_CLOUD_LOCATE: RRLP sent, waiting for"
@@ -421,9 +533,6 @@ int32_t uLocationPrivateCloudLocate(uDeviceHandle_t devHandle,
                                                                    pMessageRead,
                                                                    &z, NULL);
                                 if (errorCode == 0) {
-                                    // Add a terminator to make the message a string so that
-                                    // parseLocation() can parse it later
-                                    *(pMessageRead + z) = 0;
                                     //lint -esym(645, topicBuffer) Suppress warning about
                                     // topicBuffer not being initialised: it is but it is
                                     // too difficult for Lint to track
@@ -440,7 +549,7 @@ int32_t uLocationPrivateCloudLocate(uDeviceHandle_t devHandle,
 
                         if (errorCode == 0) {
                             // Parse the location out of the MQTT message
-                            errorCode = parseLocation(pMessageRead, pLocation);
+                            errorCode = uLocationPrivateCloudLocateParse(pMessageRead, z, pLocation);
                         }
 
                         // Free message memory
@@ -462,4 +571,117 @@ int32_t uLocationPrivateCloudLocate(uDeviceHandle_t devHandle,
     return errorCode;
 }
 
+// Parse location out of a message sent back by the Cloud Locate
+// service, which may be JSON or MessagePack.
+int32_t uLocationPrivateCloudLocateParse(const char *pBuffer, size_t length,
+                                         uLocation_t *pLocation)
+{
+    uint32_t found = 0;
+
+    if (length > 0) {
+        if (*pBuffer == '{') {
+            found = parseLocationJson(pBuffer, length, pLocation);
+        } else {
+            found = parseLocationMsgPack(pBuffer, length, pLocation);
+        }
+    }
+
+    // Must have found all of the items
+    return found == (1U << (sizeof(gItem) / sizeof(gItem[0]))) - 1 ?
+           (int32_t) U_ERROR_COMMON_SUCCESS : (int32_t) U_ERROR_COMMON_UNKNOWN;
+}
+
+// Upload any RRLP data held back for a batch.
+int32_t uLocationPrivateCloudLocateBatchFlush(uMqttClientContext_t *pMqttClientContext,
+                                              int32_t (*pPublish) (uMqttClientContext_t *,
+                                                                   const char *,
+                                                                   const char *,
+                                                                   size_t))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (gpBatch != NULL) {
+        if (gBatchCount > 0) {
+            errorCode = pPublish(pMqttClientContext,
+                                 U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC_BATCH,
+                                 gpBatch, gBatchLength);
+            uPortLog("U_LOCATION_PRIVATE_CLOUD_LOCATE: %d RRLP block(s), %d byte(s),"
+                     " sent as a batch (%d).\n", gBatchCount, (int) gBatchLength, errorCode);
+        }
+        if (errorCode == 0) {
+            free(gpBatch);
+            gpBatch = NULL;
+            gBatchLength = 0;
+            gBatchCount = 0;
+        }
+    }
+
+    return errorCode;
+}
+
+// Add RRLP data to the batch, uploading the batch if it is full.
+int32_t uLocationPrivateCloudLocateBatchAdd(uMqttClientContext_t *pMqttClientContext,
+                                            const char *pRrlp, size_t length,
+                                            int32_t batchSize,
+                                            int32_t (*pPublish) (uMqttClientContext_t *,
+                                                                 const char *,
+                                                                 const char *,
+                                                                 size_t))
+{
+    int32_t errorCode;
+
+    if (length + U_LOCATION_PRIVATE_CLOUD_LOCATE_BATCH_LENGTH_BYTES >
+        U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES) {
+        // Too big to be batched: send what we have first, so
+        // that the RRLP data still goes in the order it was
+        // captured, then send this on its own
+        errorCode = uLocationPrivateCloudLocateBatchFlush(pMqttClientContext, pPublish);
+        if (errorCode == 0) {
+            errorCode = pPublish(pMqttClientContext,
+                                 U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC,
+                                 pRrlp, length);
+        }
+    } else {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (gBatchLength + length + U_LOCATION_PRIVATE_CLOUD_LOCATE_BATCH_LENGTH_BYTES >
+            U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES) {
+            // No room, send what we have first
+            errorCode = uLocationPrivateCloudLocateBatchFlush(pMqttClientContext, pPublish);
+        }
+        if (errorCode == 0) {
+            if (gpBatch == NULL) {
+                gpBatch = (char *) malloc(U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES);
+            }
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            if (gpBatch != NULL) {
+                *(gpBatch + gBatchLength) = (char) (length >> 8);
+                *(gpBatch + gBatchLength + 1) = (char) length;
+                memcpy(gpBatch + gBatchLength + U_LOCATION_PRIVATE_CLOUD_LOCATE_BATCH_LENGTH_BYTES,
+                       pRrlp, length);
+                gBatchLength += length + U_LOCATION_PRIVATE_CLOUD_LOCATE_BATCH_LENGTH_BYTES;
+                gBatchCount++;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                if (gBatchCount >= batchSize) {
+                    errorCode = uLocationPrivateCloudLocateBatchFlush(pMqttClientContext, pPublish);
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Free any RRLP data held back for a batch.
+void uLocationPrivateCloudLocateDeinit()
+{
+    if (gpBatch != NULL) {
+        uPortLog("U_LOCATION_PRIVATE_CLOUD_LOCATE: %d RRLP block(s) held back"
+                 " for a batch were not sent.\n", gBatchCount);
+    }
+    free(gpBatch);
+    gpBatch = NULL;
+    gBatchLength = 0;
+    gBatchCount = 0;
+}
+
 // End of file
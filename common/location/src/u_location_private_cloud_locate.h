@@ -36,6 +36,34 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES
+/** The size of buffer for the RRLP data used by Cloud Locate,
+ * should not be more than 1024 bytes which is the maximum
+ * MQTT message length supported by the u-blox cellular modules.
+ */
+# define U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES 1024
+#endif
+
+#ifndef U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC
+/** The name of the MQTT topic to which RRLP data is
+ * published for Cloud Locate.
+ */
+# define U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC "CloudLocate/GNSS/request"
+#endif
+
+#ifndef U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC_BATCH
+/** The name of the MQTT topic to which batches of RRLP data are
+ * published for Cloud Locate; each RRLP data block in the message
+ * is preceded by its length as a 16-bit big-endian value.
+ */
+# define U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC_BATCH "CloudLocate/GNSS/request/batch"
+#endif
+
+/** The number of bytes of length that precede each RRLP data block
+ * in a batch.
+ */
+#define U_LOCATION_PRIVATE_CLOUD_LOCATE_BATCH_LENGTH_BYTES 2
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -99,6 +127,15 @@ extern "C" {
  *                                      this device; must be provided if
  *                                      pLocation is not NULL, must be
  *                                      null-terminated.
+ * @param batchSize                     if greater than 1 and pClientIdStr
+ *                                      is NULL, the RRLP data is held back
+ *                                      and uploaded as part of a batch once
+ *                                      this many RRLP data blocks have
+ *                                      been captured or the batch is full;
+ *                                      if pClientIdStr is not NULL, or this
+ *                                      is 1 or less, anything held back is
+ *                                      uploaded before the RRLP data of this
+ *                                      call.
  * @param pLocation                     a place to put the location once
  *                                      established, may be NULL if this
  *                                      device does not require the
@@ -130,9 +167,77 @@ int32_t uLocationPrivateCloudLocate(uDeviceHandle_t devHandle,
                                     int32_t multipathIndexLimit,
                                     int32_t pseudorangeRmsErrorIndexLimit,
                                     const char *pClientIdStr,
+                                    int32_t batchSize,
                                     uLocation_t *pLocation,
                                     bool (*pKeepGoingCallback) (uDeviceHandle_t));
 
+/** Free any RRLP data held back for a batch by
+ * uLocationPrivateCloudLocate(); it is not sent.
+ */
+void uLocationPrivateCloudLocateDeinit();
+
+/** Parse the location out of a message sent back by the Cloud
+ * Locate service, which may be JSON or MessagePack; exposed here
+ * only so that it can be tested in isolation.
+ *
+ * @param[in] pBuffer    the message, need not be null-terminated;
+ *                       cannot be NULL.
+ * @param length         the number of bytes at pBuffer.
+ * @param[out] pLocation a place to put the location; cannot be NULL.
+ *                       Fields may be written even if not all of the
+ *                       location is found.
+ * @return               zero if the latitude, longitude, altitude,
+ *                       accuracy and measurement time were all found,
+ *                       else negative error code.
+ */
+int32_t uLocationPrivateCloudLocateParse(const char *pBuffer, size_t length,
+                                         uLocation_t *pLocation);
+
+/** Upload any RRLP data held back for a batch by
+ * uLocationPrivateCloudLocate(); exposed here only so that it can
+ * be tested in isolation.
+ *
+ * @param[in] pMqttClientContext the context to pass to pPublish.
+ * @param[in] pPublish           the function that does the upload,
+ *                               given pMqttClientContext, the topic,
+ *                               the data and its length and returning
+ *                               zero on success else negative error
+ *                               code; cannot be NULL.
+ * @return                       zero on success else negative error
+ *                               code, in which case the batch is kept.
+ */
+int32_t uLocationPrivateCloudLocateBatchFlush(uMqttClientContext_t *pMqttClientContext,
+                                              int32_t (*pPublish) (uMqttClientContext_t *,
+                                                                   const char *,
+                                                                   const char *,
+                                                                   size_t));
+
+/** Add RRLP data to the batch held back by
+ * uLocationPrivateCloudLocate(), uploading the batch if there is
+ * not room for the RRLP data (before adding it) or if the batch then
+ * holds batchSize RRLP data blocks.  RRLP data that is too large to
+ * go into a batch at all is uploaded on its own, after the batch;
+ * exposed here only so that it can be tested in isolation.
+ *
+ * @param[in] pMqttClientContext the context to pass to pPublish.
+ * @param[in] pRrlp              the RRLP data; cannot be NULL.
+ * @param length                 the number of bytes at pRrlp.
+ * @param batchSize              the number of RRLP data blocks that
+ *                               makes a batch.
+ * @param[in] pPublish           the function that does the upload,
+ *                               see uLocationPrivateCloudLocateBatchFlush();
+ *                               cannot be NULL.
+ * @return                       zero on success else negative error
+ *                               code.
+ */
+int32_t uLocationPrivateCloudLocateBatchAdd(uMqttClientContext_t *pMqttClientContext,
+                                            const char *pRrlp, size_t length,
+                                            int32_t batchSize,
+                                            int32_t (*pPublish) (uMqttClientContext_t *,
+                                                                 const char *,
+                                                                 const char *,
+                                                                 size_t));
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_LOCATION_PRIVATE_GEOFENCE_H_
+#define _U_LOCATION_PRIVATE_GEOFENCE_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** @file
+ * @brief This header file defines functions that do not form part,
+ * of the location API but are used internally to pass locations
+ * to the geofence API.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Test a location against all of the fences, calling the callbacks
+ * of any that the device has entered or exited.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ *
+ * @param devHandle     the handle of the device that delivered
+ *                      the location.
+ * @param[in] pLocation the location; cannot be NULL.
+ * @return              on success the number of events reported,
+ *                      else negative error code.
+ */
+int32_t uLocationPrivateGeofenceApply(uDeviceHandle_t devHandle,
+                                      const uLocation_t *pLocation);
+
+/** Free all fences and the state kept for each device.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ */
+void uLocationPrivateGeofenceDeinit();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_LOCATION_PRIVATE_GEOFENCE_H_
+
+// End of file
@@ -38,10 +38,16 @@
 
 #include "u_error_common.h"
 
+#include "u_port.h"
 #include "u_port_os.h"
 
+#include "u_mqtt_common.h"  // Needed by
+#include "u_mqtt_client.h"  // u_location_private_cloud_locate.h
+
 #include "u_location.h"
 #include "u_location_shared.h"
+#include "u_location_private_cloud_locate.h"
+#include "u_location_private_geofence.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -51,6 +57,14 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** An entry in the last-fix cache.
+ */
+typedef struct {
+    bool valid;
+    int32_t timeMs; /**< the tick time at which the fix was stored. */
+    uLocation_t location;
+} uLocationSharedFix_t;
+
 /* ----------------------------------------------------------------
  * SHARED VARIABLES
  * -------------------------------------------------------------- */
@@ -71,10 +85,41 @@ static uLocationSharedFifoEntry_t *gpLocationGnssFifo = NULL;
  */
 static uLocationSharedFifoEntry_t *gpLocationCellLocateFifo = NULL;
 
+/** The last-fix cache, one entry per location type.
+ */
+static uLocationSharedFix_t gLocationFix[U_LOCATION_TYPE_MAX_NUM] = {0};
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Get the hook for the FIFO of the given type, NULL if there is none.
+static uLocationSharedFifoEntry_t **ppFifoGet(uLocationType_t type)
+{
+    uLocationSharedFifoEntry_t **ppThis = NULL;
+
+    switch (type) {
+        case U_LOCATION_TYPE_GNSS:
+            ppThis = &gpLocationGnssFifo;
+            break;
+        case U_LOCATION_TYPE_CLOUD_CELL_LOCATE:
+            ppThis = &gpLocationCellLocateFifo;
+            break;
+        case U_LOCATION_TYPE_CLOUD_GOOGLE:
+        //lint -fallthrough
+        case U_LOCATION_TYPE_CLOUD_SKYHOOK:
+        //lint -fallthrough
+        case U_LOCATION_TYPE_CLOUD_HERE:
+        //lint -fallthrough
+        case U_LOCATION_TYPE_NONE:
+        //lint -fallthrough
+        default:
+            break;
+    }
+
+    return ppThis;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -102,10 +147,18 @@ void uLocationSharedDeinit()
         for (int32_t x = (int32_t) U_LOCATION_TYPE_GNSS;
              x < (int32_t) U_LOCATION_TYPE_MAX_NUM;
              x++) {
-            while ((pEntry = pULocationSharedRequestPop((uLocationType_t) x)) != NULL) {
+            while ((pEntry = pULocationSharedRequestPop((uLocationType_t) x, NULL)) != NULL) {
                 free(pEntry);
             }
         }
+        // Empty the last-fix cache
+        for (size_t x = 0; x < sizeof(gLocationFix) / sizeof(gLocationFix[0]); x++) {
+            gLocationFix[x].valid = false;
+        }
+        // Drop anything held back for a Cloud Locate batch
+        uLocationPrivateCloudLocateDeinit();
+        // Remove any geofences
+        uLocationPrivateGeofenceDeinit();
         U_PORT_MUTEX_UNLOCK(gULocationMutex);
         uPortMutexDelete(gULocationMutex);
         gULocationMutex = NULL;
@@ -120,39 +173,21 @@ int32_t uLocationSharedRequestPush(uDeviceHandle_t devHandle,
                                                       const uLocation_t *pLocation))
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-    uLocationSharedFifoEntry_t **ppThis = NULL;
-    uLocationSharedFifoEntry_t *pSaved = NULL;
-
-    switch (type) {
-        case U_LOCATION_TYPE_GNSS:
-            ppThis = &gpLocationGnssFifo;
-            pSaved = gpLocationGnssFifo;
-            break;
-        case U_LOCATION_TYPE_CLOUD_CELL_LOCATE:
-            ppThis = &gpLocationCellLocateFifo;
-            pSaved = gpLocationCellLocateFifo;
-            break;
-        case U_LOCATION_TYPE_CLOUD_GOOGLE:
-        //lint -fallthrough
-        case U_LOCATION_TYPE_CLOUD_SKYHOOK:
-        //lint -fallthrough
-        case U_LOCATION_TYPE_CLOUD_HERE:
-        //lint -fallthrough
-        case U_LOCATION_TYPE_NONE:
-        //lint -fallthrough
-        default:
-            break;
-    }
+    uLocationSharedFifoEntry_t **ppThis = ppFifoGet(type);
+    uLocationSharedFifoEntry_t *pSaved;
 
     if (ppThis != NULL) {
         errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
         // Add the new entry at the start of the list
+        pSaved = *ppThis;
         *ppThis = (uLocationSharedFifoEntry_t *) malloc(sizeof(**ppThis));
         if (*ppThis != NULL) {
             (*ppThis)->devHandle = devHandle;
             (*ppThis)->pCallback = pCallback;
             (*ppThis)->pNext = pSaved;
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        } else {
+            *ppThis = pSaved;
         }
     }
 
@@ -160,49 +195,91 @@ int32_t uLocationSharedRequestPush(uDeviceHandle_t devHandle,
 }
 
 // Get the oldest location request from the given FIFO.
-uLocationSharedFifoEntry_t *pULocationSharedRequestPop(uLocationType_t type)
+uLocationSharedFifoEntry_t *pULocationSharedRequestPop(uLocationType_t type,
+                                                       uDeviceHandle_t devHandle)
 {
-    uLocationSharedFifoEntry_t **ppThis = NULL;
-    uLocationSharedFifoEntry_t *pSaved = NULL;
-    uLocationSharedFifoEntry_t *pPrevious = NULL;
+    uLocationSharedFifoEntry_t **ppThis = ppFifoGet(type);
+    uLocationSharedFifoEntry_t **ppFound = NULL;
+    uLocationSharedFifoEntry_t *pFound = NULL;
 
-    switch (type) {
-        case U_LOCATION_TYPE_GNSS:
-            ppThis = &gpLocationGnssFifo;
-            break;
-        case U_LOCATION_TYPE_CLOUD_CELL_LOCATE:
-            ppThis = &gpLocationCellLocateFifo;
-            break;
-        case U_LOCATION_TYPE_CLOUD_GOOGLE:
-        //lint -fallthrough
-        case U_LOCATION_TYPE_CLOUD_SKYHOOK:
-        //lint -fallthrough
-        case U_LOCATION_TYPE_CLOUD_HERE:
-        //lint -fallthrough
-        case U_LOCATION_TYPE_NONE:
-        //lint -fallthrough
-        default:
-            break;
+    if (ppThis != NULL) {
+        // New entries are added at the start of the list, so the
+        // oldest matching entry is the last one that matches
+        while (*ppThis != NULL) {
+            if ((devHandle == NULL) || ((*ppThis)->devHandle == devHandle)) {
+                ppFound = ppThis;
+            }
+            ppThis = &((*ppThis)->pNext);
+        }
+        if (ppFound != NULL) {
+            // Remove the entry from the list
+            pFound = *ppFound;
+            *ppFound = pFound->pNext;
+            pFound->pNext = NULL;
+        }
     }
 
+    return pFound;
+}
+
+// Determine whether a location request is already in the FIFO.
+bool uLocationSharedRequestIsPending(uLocationType_t type,
+                                     uDeviceHandle_t devHandle)
+{
+    bool isPending = false;
+    uLocationSharedFifoEntry_t **ppThis = ppFifoGet(type);
+
     if (ppThis != NULL) {
-        // Find the end of the list
-        while (*ppThis != NULL) {
-            pPrevious = pSaved;
-            pSaved = *ppThis;
-            *ppThis = (*ppThis)->pNext;
+        for (uLocationSharedFifoEntry_t *pThis = *ppThis;
+             (pThis != NULL) && !isPending; pThis = pThis->pNext) {
+            isPending = (pThis->devHandle == devHandle);
         }
+    }
 
-        // Remove the entry from the list
-        if (pPrevious != NULL) {
-            pPrevious->pNext = NULL;
-        } else {
-            // Must be at the head
-            *ppThis = NULL;
+    return isPending;
+}
+
+// Store a location in the last-fix cache and apply geofences.
+void uLocationSharedFixSet(uDeviceHandle_t devHandle,
+                           const uLocation_t *pLocation)
+{
+    uLocationSharedFix_t *pFix;
+
+    if ((pLocation != NULL) && (pLocation->type > U_LOCATION_TYPE_NONE) &&
+        (pLocation->type < U_LOCATION_TYPE_MAX_NUM)) {
+        pFix = &(gLocationFix[pLocation->type]);
+        pFix->location = *pLocation;
+        pFix->timeMs = uPortGetTickTimeMs();
+        pFix->valid = true;
+        uLocationPrivateGeofenceApply(devHandle, pLocation);
+    }
+}
+
+// Get a location from the last-fix cache.
+bool uLocationSharedFixGet(uLocationType_t type,
+                           int32_t maxAgeSeconds,
+                           int32_t maxRadiusMillimetres,
+                           uLocation_t *pLocation)
+{
+    bool found = false;
+    const uLocationSharedFix_t *pFix;
+
+    if ((maxAgeSeconds > 0) && (type > U_LOCATION_TYPE_NONE) &&
+        (type < U_LOCATION_TYPE_MAX_NUM)) {
+        pFix = &(gLocationFix[type]);
+        if (pFix->valid &&
+            ((uPortGetTickTimeMs() - pFix->timeMs) / 1000 < maxAgeSeconds) &&
+            ((maxRadiusMillimetres < 0) ||
+             ((pFix->location.radiusMillimetres >= 0) &&
+              (pFix->location.radiusMillimetres <= maxRadiusMillimetres)))) {
+            found = true;
+            if (pLocation != NULL) {
+                *pLocation = pFix->location;
+            }
         }
     }
 
-    return pSaved;
+    return found;
 }
 
 // End of file
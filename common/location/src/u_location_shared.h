@@ -51,6 +51,28 @@ typedef struct uLocationSharedFifoEntry_t {
     struct uLocationSharedFifoEntry_t *pNext;
 } uLocationSharedFifoEntry_t;
 
+/** The state of continuous location, see uLocationContinuousStart();
+ * shared so that the way the rate of fixes follows the movement of
+ * the device can be tested without a module.
+ */
+typedef struct {
+    uDeviceHandle_t devHandle;
+    uLocationType_t type;
+    uLocationAssist_t assist;
+    const char *pAuthenticationTokenStr;
+    uLocationContinuousCfg_t cfg;
+    void (*pCallback) (uDeviceHandle_t, int32_t, const uLocation_t *);
+    bool isGnss;              /**< true if devHandle is a GNSS device. */
+    bool stationary;
+    int32_t numSlowFixes;
+    int32_t periodMs;         /**< the period between fixes while moving. */
+    uLocation_t anchor;       /**< the fix at which the device became
+                                   stationary. */
+    uLocation_t last;         /**< the last usable fix. */
+    int32_t lastTimeMs;       /**< the tick time of last, -1 if none. */
+    int32_t fixStartTimeMs;
+} uLocationSharedContinuous_t;
+
 /* ----------------------------------------------------------------
  * SHARED VARIABLES
  * -------------------------------------------------------------- */
@@ -98,12 +120,83 @@ int32_t uLocationSharedRequestPush(uDeviceHandle_t devHandle,
  * IMPORTANT: gULocationMutex should be locked before this
  * is called.
  *
- * @param type the request type.
- * @return     the entry pointer: it is removed from the list and
- *             hence it is up to the calling task to free the pointer
- *             when done; NULL is returned if the FIFO is empty.
+ * @param type      the request type.
+ * @param devHandle the device handle the request must have been
+ *                  made by; use NULL for any device.
+ * @return          the entry pointer: it is removed from the list and
+ *                  hence it is up to the calling task to free the pointer
+ *                  when done; NULL is returned if there is no such
+ *                  entry in the FIFO.
+ */
+uLocationSharedFifoEntry_t *pULocationSharedRequestPop(uLocationType_t type,
+                                                       uDeviceHandle_t devHandle);
+
+/** Determine whether there is a location request of the given type
+ * from the given device in the FIFO, i.e. whether a fix is already
+ * in progress that a new request could join.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ *
+ * @param type      the request type.
+ * @param devHandle the handle of the device.
+ * @return          true if there is such a request in the FIFO.
+ */
+bool uLocationSharedRequestIsPending(uLocationType_t type,
+                                     uDeviceHandle_t devHandle);
+
+/** Store a location in the last-fix cache, replacing any held
+ * for the same type, and test it against any geofences, see
+ * u_geofence.h; pLocation->type must be set.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ *
+ * @param devHandle     the handle of the device that delivered
+ *                      the location.
+ * @param[in] pLocation the location to store.
+ */
+void uLocationSharedFixSet(uDeviceHandle_t devHandle,
+                           const uLocation_t *pLocation);
+
+/** Get a location of the given type from the last-fix cache, provided
+ * it is no older than maxAgeSeconds and, where maxRadiusMillimetres
+ * is not negative, its radius is known and no bigger than
+ * maxRadiusMillimetres.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ *
+ * @param type                 the location type.
+ * @param maxAgeSeconds        the maximum age of the fix; if this is
+ *                             zero or negative false will be returned.
+ * @param maxRadiusMillimetres the maximum radius of the fix, -1 for
+ *                             don't care.
+ * @param[out] pLocation       a place to put the location; may be NULL.
+ * @return                     true if the cache holds a location
+ *                             that satisfies the criteria.
+ */
+bool uLocationSharedFixGet(uLocationType_t type,
+                           int32_t maxAgeSeconds,
+                           int32_t maxRadiusMillimetres,
+                           uLocation_t *pLocation);
+
+/** Update the state of continuous location with a new fix: set the
+ * period between fixes from the speed of the fix, or from the
+ * distance moved since the last fix if the fix has no speed, and
+ * move into or out of the stationary state; implemented in
+ * u_location_continuous.c.  A fix with a radius larger than
+ * pContinuous->assist.desiredAccuracyMillimetres is ignored.  If
+ * pContinuous->isGnss is true, entering or leaving the stationary
+ * state will do what pContinuous->cfg.gnssStationary says to the
+ * GNSS device.
+ *
+ * @param[in,out] pContinuous  the state of continuous location,
+ *                             cannot be NULL.
+ * @param[in] pLocation        the new fix, cannot be NULL.
+ * @param nowMs                the tick time of the fix, as returned
+ *                             by uPortGetTickTimeMs().
  */
-uLocationSharedFifoEntry_t *pULocationSharedRequestPop(uLocationType_t type);
+void uLocationSharedContinuousUpdate(uLocationSharedContinuous_t *pContinuous,
+                                     const uLocation_t *pLocation,
+                                     int32_t nowMs);
 
 #ifdef __cplusplus
 }
@@ -32,10 +32,12 @@
 # include "u_cfg_override.h" // For a customer's configuration override
 #endif
 
+#include "stdlib.h"    // free()
 #include "limits.h"    // LONG_MIN, INT_MIN
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // memset()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_os_platform_specific.h"
@@ -52,8 +54,14 @@
 #include "u_network.h"
 #include "u_network_test_shared_cfg.h"
 
+#include "u_mqtt_common.h"
+#include "u_mqtt_client.h"
+
 #include "u_location.h"
+#include "u_location_shared.h"
+#include "u_location_private_cloud_locate.h"
 #include "u_location_test_shared_cfg.h"
+#include "u_geofence.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -67,10 +75,38 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
+/** The MeasTime of the Cloud Locate test messages, in UTC seconds.
+ */
+#define U_LOCATION_TEST_CLOUD_LOCATE_TIME_UTC 1636482251LL
+
+/** The maximum number of uploads that cloudLocatePublish() records.
+ */
+#define U_LOCATION_TEST_CLOUD_LOCATE_PUBLISH_MAX_NUM 4
+
+/** The number of bytes of each upload that cloudLocatePublish()
+ * keeps a copy of.
+ */
+#define U_LOCATION_TEST_CLOUD_LOCATE_PUBLISH_COPY_LENGTH_BYTES 16
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A MessagePack message under construction.
+ */
+typedef struct {
+    char buffer[128];
+    size_t length;
+} uLocationTestMsgPack_t;
+
+/** An upload recorded by cloudLocatePublish().
+ */
+typedef struct {
+    bool isBatch;
+    size_t length;
+    char data[U_LOCATION_TEST_CLOUD_LOCATE_PUBLISH_COPY_LENGTH_BYTES];
+} uLocationTestPublish_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -99,10 +135,228 @@ static uLocation_t gLocation;
  */
 static int32_t gErrorCode;
 
+/** The number of enter events minus the number of exit events
+ * seen by geofenceCallback(), indexed by fence ID.
+ */
+static int32_t gGeofenceInsideCount[2];
+
+/** The total number of calls to geofenceCallback().
+ */
+static int32_t gGeofenceEventCount;
+
+/** The number of calls to continuousCallback().
+ */
+static volatile int32_t gContinuousCount;
+
+/** The number of calls to continuousCallback() that carried a fix.
+ */
+static volatile int32_t gContinuousGoodCount;
+
+/** The uploads recorded by cloudLocatePublish().
+ */
+static uLocationTestPublish_t gPublish[U_LOCATION_TEST_CLOUD_LOCATE_PUBLISH_MAX_NUM];
+
+/** The number of calls to cloudLocatePublish().
+ */
+static size_t gPublishCount;
+
+/** The error code that cloudLocatePublish() should return.
+ */
+static int32_t gPublishErrorCode;
+
+/** RRLP data for the Cloud Locate batch tests.
+ */
+static char gRrlp[U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Callback for geofence events.
+static void geofenceCallback(uDeviceHandle_t devHandle, int32_t fenceId,
+                             uGeofenceEvent_t event,
+                             const uLocation_t *pLocation,
+                             void *pCallbackParameter)
+{
+    (void) devHandle;
+    (void) pLocation;
+
+    gGeofenceEventCount++;
+    if ((fenceId >= 0) &&
+        (fenceId < (int32_t) (sizeof(gGeofenceInsideCount) / sizeof(gGeofenceInsideCount[0]))) &&
+        (pCallbackParameter == (void *) &gGeofenceEventCount)) {
+        gGeofenceInsideCount[fenceId] += (event == U_GEOFENCE_EVENT_ENTER) ? 1 : -1;
+    }
+}
+
+// Apply a location to the geofences through the location cache,
+// as uLocationGet() would, returning the number of events.
+static int32_t geofenceFix(uDeviceHandle_t devHandle,
+                           int32_t latitudeX1e7, int32_t longitudeX1e7)
+{
+    uLocation_t location;
+    int32_t eventCount = gGeofenceEventCount;
+
+    memset(&location, 0, sizeof(location));
+    location.type = U_LOCATION_TYPE_GNSS;
+    location.latitudeX1e7 = latitudeX1e7;
+    location.longitudeX1e7 = longitudeX1e7;
+    U_PORT_MUTEX_LOCK(gULocationMutex);
+    uLocationSharedFixSet(devHandle, &location);
+    U_PORT_MUTEX_UNLOCK(gULocationMutex);
+
+    return gGeofenceEventCount - eventCount;
+}
+
+// Callback for continuous location.
+static void continuousCallback(uDeviceHandle_t devHandle,
+                               int32_t errorCode,
+                               const uLocation_t *pLocation)
+{
+    gDevHandle = devHandle;
+    gContinuousCount++;
+    if ((errorCode == 0) && (pLocation != NULL)) {
+        gContinuousGoodCount++;
+    }
+}
+
+// Feed a fix to the state of continuous location, as the
+// continuous location task would.
+static void continuousFix(uLocationSharedContinuous_t *pContinuous,
+                          int32_t latitudeX1e7, int32_t radiusMillimetres,
+                          int32_t speedMillimetresPerSecond, int32_t nowMs)
+{
+    uLocation_t location;
+
+    memset(&location, 0, sizeof(location));
+    location.type = U_LOCATION_TYPE_GNSS;
+    location.latitudeX1e7 = latitudeX1e7;
+    location.radiusMillimetres = radiusMillimetres;
+    location.speedMillimetresPerSecond = speedMillimetresPerSecond;
+    uLocationSharedContinuousUpdate(pContinuous, &location, nowMs);
+}
+
+// Add bytes to a MessagePack message.
+static void msgPackBytes(uLocationTestMsgPack_t *pMsg, const void *pBytes,
+                         size_t length)
+{
+    U_PORT_TEST_ASSERT(pMsg->length + length <= sizeof(pMsg->buffer));
+    memcpy(pMsg->buffer + pMsg->length, pBytes, length);
+    pMsg->length += length;
+}
+
+// Add a MessagePack type followed by a big-endian value of the
+// given number of bytes.
+static void msgPackValue(uLocationTestMsgPack_t *pMsg, uint8_t type,
+                         uint64_t value, size_t length)
+{
+    char bytes[9];
+
+    bytes[0] = (char) type;
+    for (size_t x = 0; x < length; x++) {
+        bytes[length - x] = (char) (value >> (x * 8));
+    }
+    msgPackBytes(pMsg, bytes, length + 1);
+}
+
+// Add a string to a MessagePack message as a fixstr or, if str8
+// is true, a str8.
+static void msgPackStr(uLocationTestMsgPack_t *pMsg, const char *pStr,
+                       bool str8)
+{
+    size_t length = strlen(pStr);
+
+    if (str8) {
+        msgPackValue(pMsg, 0xd9, length, 1);
+    } else {
+        msgPackValue(pMsg, (uint8_t) (0xa0 | length), 0, 0);
+    }
+    msgPackBytes(pMsg, pStr, length);
+}
+
+// Add a float 64 to a MessagePack message.
+static void msgPackDouble(uLocationTestMsgPack_t *pMsg, double d)
+{
+    uint64_t raw;
+
+    memcpy(&raw, &d, sizeof(raw));
+    msgPackValue(pMsg, 0xcb, raw, 8);
+}
+
+// Add a float 32 to a MessagePack message.
+static void msgPackFloat(uLocationTestMsgPack_t *pMsg, float f)
+{
+    uint32_t raw;
+
+    memcpy(&raw, &f, sizeof(raw));
+    msgPackValue(pMsg, 0xca, raw, 4);
+}
+
+// Build the MessagePack form of the standard Cloud Locate test
+// message, with floats for the numbers and a fixstr for MeasTime,
+// but with the given value, if not NULL, for "Lat"; returns the
+// parse result.
+static int32_t cloudLocateParseLat(const uLocationTestMsgPack_t *pLat,
+                                   uLocation_t *pLocation)
+{
+    uLocationTestMsgPack_t msg = {0};
+
+    msgPackValue(&msg, 0x85, 0, 0);
+    msgPackStr(&msg, "Lat", false);
+    if (pLat != NULL) {
+        msgPackBytes(&msg, pLat->buffer, pLat->length);
+    } else {
+        msgPackDouble(&msg, 52.0187499);
+    }
+    msgPackStr(&msg, "Lon", false);
+    msgPackDouble(&msg, -0.2471071);
+    msgPackStr(&msg, "Alt", false);
+    msgPackDouble(&msg, 120.216);
+    msgPackStr(&msg, "Acc", false);
+    msgPackFloat(&msg, 29.877f);
+    msgPackStr(&msg, "MeasTime", false);
+    msgPackStr(&msg, "2021-11-09T18:24:11", false);
+
+    memset(pLocation, 0, sizeof(*pLocation));
+    return uLocationPrivateCloudLocateParse(msg.buffer, msg.length, pLocation);
+}
+
+// Stand-in for the MQTT upload of Cloud Locate: records what
+// would have been sent.
+static int32_t cloudLocatePublish(uMqttClientContext_t *pMqttClientContext,
+                                  const char *pTopicNameStr,
+                                  const char *pMessage,
+                                  size_t messageSizeBytes)
+{
+    uLocationTestPublish_t *pPublish;
+    size_t length = messageSizeBytes;
+
+    U_PORT_TEST_ASSERT(pMqttClientContext == NULL);
+    if (gPublishCount < sizeof(gPublish) / sizeof(gPublish[0])) {
+        pPublish = &(gPublish[gPublishCount]);
+        pPublish->isBatch = (strcmp(pTopicNameStr,
+                                    U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC_BATCH) == 0);
+        U_PORT_TEST_ASSERT(pPublish->isBatch ||
+                           (strcmp(pTopicNameStr,
+                                   U_LOCATION_PRIVATE_CLOUD_LOCATE_MQTT_PUBLISH_TOPIC) == 0));
+        pPublish->length = messageSizeBytes;
+        if (length > sizeof(pPublish->data)) {
+            length = sizeof(pPublish->data);
+        }
+        memcpy(pPublish->data, pMessage, length);
+    }
+    gPublishCount++;
+
+    return gPublishErrorCode;
+}
+
+// Add RRLP data of the given length to the Cloud Locate batch.
+static int32_t cloudLocateBatchAdd(size_t length, int32_t batchSize)
+{
+    return uLocationPrivateCloudLocateBatchAdd(NULL, gRrlp, length, batchSize,
+                                               cloudLocatePublish);
+}
+
 // Callback function for location establishment process.
 static bool keepGoingCallback(uDeviceHandle_t devHandle)
 {
@@ -487,6 +741,735 @@ U_PORT_TEST_FUNCTION("[location]", "locationBasic")
     uNetworkTestListFree();
 }
 
+/** Test the last-fix cache and the request FIFO behind it; needs
+ * no module.
+ */
+U_PORT_TEST_FUNCTION("[location]", "locationCache")
+{
+    uLocation_t location;
+    uLocationSharedFifoEntry_t *pEntry;
+    // Device handles are only compared here, never dereferenced
+    uDeviceHandle_t devHandleA = (uDeviceHandle_t) &location;
+    uDeviceHandle_t devHandleB = (uDeviceHandle_t) &pEntry;
+    int32_t heapUsed;
+
+    memset(&location, 0, sizeof(location));
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uLocationSharedInit() == 0);
+
+    U_PORT_MUTEX_LOCK(gULocationMutex);
+
+    // Nothing in the cache to begin with
+    U_PORT_TEST_ASSERT(!uLocationSharedFixGet(U_LOCATION_TYPE_GNSS, 10, -1, NULL));
+
+    location.type = U_LOCATION_TYPE_GNSS;
+    location.latitudeX1e7 = 521234567;
+    location.radiusMillimetres = 5000;
+    uLocationSharedFixSet(devHandleA, &location);
+    location.latitudeX1e7 = 0;
+    U_PORT_TEST_ASSERT(uLocationSharedFixGet(U_LOCATION_TYPE_GNSS, 10, -1, &location));
+    U_PORT_TEST_ASSERT(location.type == U_LOCATION_TYPE_GNSS);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == 521234567);
+    U_PORT_TEST_ASSERT(uLocationSharedFixGet(U_LOCATION_TYPE_GNSS, 10, 5000, NULL));
+    // Not accurate enough
+    U_PORT_TEST_ASSERT(!uLocationSharedFixGet(U_LOCATION_TYPE_GNSS, 10, 4999, NULL));
+    // Cache not wanted
+    U_PORT_TEST_ASSERT(!uLocationSharedFixGet(U_LOCATION_TYPE_GNSS, 0, -1, NULL));
+    // Wrong type
+    U_PORT_TEST_ASSERT(!uLocationSharedFixGet(U_LOCATION_TYPE_CLOUD_CELL_LOCATE, 10, -1, NULL));
+
+    // Requests: two from A then one from B
+    U_PORT_TEST_ASSERT(!uLocationSharedRequestIsPending(U_LOCATION_TYPE_GNSS, devHandleA));
+    U_PORT_TEST_ASSERT(uLocationSharedRequestPush(devHandleA, U_LOCATION_TYPE_GNSS, NULL) == 0);
+    U_PORT_TEST_ASSERT(uLocationSharedRequestPush(devHandleA, U_LOCATION_TYPE_GNSS, NULL) == 0);
+    U_PORT_TEST_ASSERT(uLocationSharedRequestPush(devHandleB, U_LOCATION_TYPE_GNSS, NULL) == 0);
+    U_PORT_TEST_ASSERT(uLocationSharedRequestIsPending(U_LOCATION_TYPE_GNSS, devHandleA));
+    U_PORT_TEST_ASSERT(uLocationSharedRequestIsPending(U_LOCATION_TYPE_GNSS, devHandleB));
+    U_PORT_TEST_ASSERT(!uLocationSharedRequestIsPending(U_LOCATION_TYPE_CLOUD_CELL_LOCATE,
+                                                        devHandleA));
+    pEntry = pULocationSharedRequestPop(U_LOCATION_TYPE_GNSS, devHandleB);
+    U_PORT_TEST_ASSERT((pEntry != NULL) && (pEntry->devHandle == devHandleB));
+    free(pEntry);
+    U_PORT_TEST_ASSERT(!uLocationSharedRequestIsPending(U_LOCATION_TYPE_GNSS, devHandleB));
+    for (size_t x = 0; x < 2; x++) {
+        pEntry = pULocationSharedRequestPop(U_LOCATION_TYPE_GNSS, NULL);
+        U_PORT_TEST_ASSERT((pEntry != NULL) && (pEntry->devHandle == devHandleA));
+        free(pEntry);
+    }
+    U_PORT_TEST_ASSERT(pULocationSharedRequestPop(U_LOCATION_TYPE_GNSS, NULL) == NULL);
+
+    U_PORT_MUTEX_UNLOCK(gULocationMutex);
+
+    // Let the fix age
+    uPortTaskBlock(1100);
+    U_PORT_MUTEX_LOCK(gULocationMutex);
+    U_PORT_TEST_ASSERT(!uLocationSharedFixGet(U_LOCATION_TYPE_GNSS, 1, -1, NULL));
+    U_PORT_MUTEX_UNLOCK(gULocationMutex);
+
+    uLocationSharedDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+
+    uPortDeinit();
+}
+
+/** Test the geofence API; needs no module.
+ */
+U_PORT_TEST_FUNCTION("[location]", "locationGeofence")
+{
+    // An L shape, 0.2 degrees on a side with the quadrant
+    // at the top right missing
+    const uGeofenceVertex_t polygon[] = {{0, 0}, {2000000, 0},
+        {2000000, 1000000}, {1000000, 1000000},
+        {1000000, 2000000}, {0, 2000000}
+    };
+    // Device handles are only compared here, never dereferenced
+    uDeviceHandle_t devHandleA = (uDeviceHandle_t) &gGeofenceEventCount;
+    uDeviceHandle_t devHandleB = (uDeviceHandle_t) &gGeofenceInsideCount;
+    uLocation_t location;
+    int32_t circleId;
+    int32_t polygonId;
+    int32_t heapUsed;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uGeofenceAddCircle(0, 0, 1000, geofenceCallback, NULL) < 0);
+    U_PORT_TEST_ASSERT(uLocationSharedInit() == 0);
+    gGeofenceEventCount = 0;
+    memset(gGeofenceInsideCount, 0, sizeof(gGeofenceInsideCount));
+
+    // Bad parameters
+    U_PORT_TEST_ASSERT(uGeofenceAddCircle(0, 0, 1000, NULL, NULL) < 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddCircle(0, 0, 0, geofenceCallback, NULL) < 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddCircle(900000001, 0, 1000, geofenceCallback, NULL) < 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddPolygon(polygon, 2, geofenceCallback, NULL) < 0);
+
+    // A circle of radius 1 km at 52 degrees north, where a degree
+    // of longitude is about 68.5 km
+    circleId = uGeofenceAddCircle(520000000, 0, 1000000, geofenceCallback,
+                                  (void *) &gGeofenceEventCount);
+    U_TEST_PRINT_LINE("circular fence has ID %d.", circleId);
+    U_PORT_TEST_ASSERT(circleId == 0);
+    polygonId = uGeofenceAddPolygon(polygon, sizeof(polygon) / sizeof(polygon[0]),
+                                    geofenceCallback, (void *) &gGeofenceEventCount);
+    U_TEST_PRINT_LINE("polygonal fence has ID %d.", polygonId);
+    U_PORT_TEST_ASSERT(polygonId == 1);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleA, circleId) == 0);
+
+    // The first fix, inside the circle, is an enter event
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 520000000, 0) == 1);
+    U_PORT_TEST_ASSERT(gGeofenceInsideCount[circleId] == 1);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleA, circleId) == 1);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleB, circleId) == 0);
+    // 890 metres north and 960 metres east are still inside
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 520080000, 0) == 0);
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 520000000, 140000) == 0);
+    // 1110 metres north is outside
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 520100000, 0) == 1);
+    U_PORT_TEST_ASSERT(gGeofenceInsideCount[circleId] == 0);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleA, circleId) == 0);
+    // Back in, then 780 metres north and 690 metres east, which
+    // is within the bounding box but outside the circle
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 520000000, -140000) == 1);
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 520070000, 100000) == 1);
+    U_PORT_TEST_ASSERT(gGeofenceInsideCount[circleId] == 0);
+
+    // The polygon, including the missing quadrant of the L
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 500000, 500000) == 1);
+    U_PORT_TEST_ASSERT(gGeofenceInsideCount[polygonId] == 1);
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 1500000, 500000) == 0);
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 500000, 1500000) == 0);
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 1500000, 1500000) == 1);
+    U_PORT_TEST_ASSERT(gGeofenceInsideCount[polygonId] == 0);
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 1500000, 900000) == 1);
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, -1, 900000) == 1);
+    U_PORT_TEST_ASSERT(gGeofenceInsideCount[polygonId] == 0);
+
+    // A second device has its own state
+    memset(&location, 0, sizeof(location));
+    location.latitudeX1e7 = 1000;
+    location.longitudeX1e7 = 1000;
+    U_PORT_TEST_ASSERT(uGeofenceApply(devHandleB, &location) == 1);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleB, polygonId) == 1);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleA, polygonId) == 0);
+    uGeofenceGnssPosCallback(devHandleB, 0, 520000000, 0, 0, 0, 0, 0, 0);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleB, circleId) == 1);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleB, polygonId) == 0);
+    // Failed fixes are ignored
+    uGeofenceGnssPosCallback(devHandleB, -1, 0, 0, 0, 0, 0, 0, 0);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleB, circleId) == 1);
+
+    // Remove the circle: no more events from it and its ID is reused
+    U_PORT_TEST_ASSERT(uGeofenceRemove(circleId) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceRemove(circleId) < 0);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleB, circleId) < 0);
+    // 10 degrees south is outside the polygon as well
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleB, -100000000, 0) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddCircle(0, 0, 1000, geofenceCallback, NULL) == circleId);
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleB, circleId) == 0);
+    uGeofenceRemoveAll();
+    U_PORT_TEST_ASSERT(uGeofenceIsInside(devHandleB, polygonId) < 0);
+
+    // Fences are freed by the deinitialisation too
+    U_PORT_TEST_ASSERT(uGeofenceAddPolygon(polygon, sizeof(polygon) / sizeof(polygon[0]),
+                                           geofenceCallback, NULL) == 0);
+    U_PORT_TEST_ASSERT(geofenceFix(devHandleA, 500000, 500000) == 1);
+    uLocationSharedDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+
+    uPortDeinit();
+}
+
+/** Test how continuous location sets the period between fixes and
+ * moves into and out of the stationary state, by feeding fixes
+ * straight into it; needs no module.
+ */
+U_PORT_TEST_FUNCTION("[location]", "locationContinuousRate")
+{
+    uLocationSharedContinuous_t continuous;
+    const uLocationContinuousCfg_t cfgDefaults = U_LOCATION_CONTINUOUS_CFG_DEFAULTS;
+    uLocationContinuousCfg_t cfg = U_LOCATION_CONTINUOUS_CFG_DEFAULTS;
+    uLocationAssist_t assist = U_LOCATION_ASSIST_DEFAULTS;
+    // Device handles are only compared here, never dereferenced
+    uDeviceHandle_t devHandle = (uDeviceHandle_t) &continuous;
+    // 100 metres north
+    int32_t latitudeX1e7 = 520000000 + 8983;
+    int32_t nowMs = 0;
+
+    // Nothing is running so these should all fail
+    U_PORT_TEST_ASSERT(uLocationContinuousGetPeriodMs(devHandle) < 0);
+    U_PORT_TEST_ASSERT(uLocationContinuousMotion(devHandle) < 0);
+    uLocationContinuousStop(devHandle);
+    // Bad parameters
+    U_PORT_TEST_ASSERT(uLocationContinuousStart(NULL, U_LOCATION_TYPE_GNSS, NULL, NULL,
+                                                NULL, continuousCallback) < 0);
+    U_PORT_TEST_ASSERT(uLocationContinuousStart(devHandle, U_LOCATION_TYPE_GNSS, NULL, NULL,
+                                                NULL, NULL) < 0);
+    cfg.periodMaxMs = cfg.periodMinMs - 1;
+    U_PORT_TEST_ASSERT(uLocationContinuousStart(devHandle, U_LOCATION_TYPE_GNSS, NULL, NULL,
+                                                &cfg, continuousCallback) < 0);
+    cfg.periodMaxMs = cfg.periodMinMs;
+    cfg.stationaryNumFixes = 0;
+    U_PORT_TEST_ASSERT(uLocationContinuousStart(devHandle, U_LOCATION_TYPE_GNSS, NULL, NULL,
+                                                &cfg, continuousCallback) < 0);
+
+    // Defaults: period 1 to 30 seconds, fixes 50 metres apart,
+    // stationary after five fixes below 0.5 metres per second
+    memset(&continuous, 0, sizeof(continuous));
+    continuous.cfg = cfgDefaults;
+    continuous.assist = assist;
+    continuous.assist.desiredAccuracyMillimetres = 10000;
+    continuous.periodMs = continuous.cfg.periodMinMs;
+    continuous.lastTimeMs = -1;
+
+    // 10 metres per second gives a fix every 5 seconds
+    continuousFix(&continuous, 520000000, 5000, 10000, nowMs);
+    U_PORT_TEST_ASSERT(continuous.periodMs == 5000);
+    // Faster and slower are limited
+    continuousFix(&continuous, 520000000, 5000, 100000, nowMs);
+    U_PORT_TEST_ASSERT(continuous.periodMs == continuous.cfg.periodMinMs);
+    continuousFix(&continuous, 520000000, 5000, 1000, nowMs);
+    U_PORT_TEST_ASSERT(continuous.periodMs == continuous.cfg.periodMaxMs);
+    // A fix that isn't accurate enough changes nothing
+    continuousFix(&continuous, 520000000, 20000, 10000, nowMs);
+    U_PORT_TEST_ASSERT(continuous.periodMs == continuous.cfg.periodMaxMs);
+
+    // With no speed, as for Cell Locate, speed comes from the
+    // distance moved: 100 metres in 10 seconds
+    nowMs += 10000;
+    continuousFix(&continuous, latitudeX1e7, 5000, INT_MIN, nowMs);
+    U_TEST_PRINT_LINE("period from distance moved is %d ms.", continuous.periodMs);
+    U_PORT_TEST_ASSERT((continuous.periodMs >= 4500) && (continuous.periodMs <= 5500));
+    // Not having moved outside the radius of the fix counts as slow
+    nowMs += 10000;
+    continuousFix(&continuous, latitudeX1e7 + 10, 5000, INT_MIN, nowMs);
+    U_PORT_TEST_ASSERT(continuous.numSlowFixes == 1);
+    U_PORT_TEST_ASSERT(!continuous.stationary);
+
+    // Enough slow fixes in a row make the device stationary
+    for (int32_t x = 1; x < continuous.cfg.stationaryNumFixes; x++) {
+        U_PORT_TEST_ASSERT(!continuous.stationary);
+        nowMs += 1000;
+        continuousFix(&continuous, latitudeX1e7, 5000, 100, nowMs);
+    }
+    U_PORT_TEST_ASSERT(continuous.stationary);
+    U_PORT_TEST_ASSERT(continuous.anchor.latitudeX1e7 == latitudeX1e7);
+    // A slow fix within the radius of the anchor stays stationary
+    nowMs += 1000;
+    continuousFix(&continuous, latitudeX1e7 + 10, 5000, 0, nowMs);
+    U_PORT_TEST_ASSERT(continuous.stationary);
+    // Speed ends it, with the next fix wanted quickly
+    nowMs += 1000;
+    continuousFix(&continuous, latitudeX1e7, 5000, 1000, nowMs);
+    U_PORT_TEST_ASSERT(!continuous.stationary);
+    U_PORT_TEST_ASSERT(continuous.periodMs == continuous.cfg.periodMinMs);
+
+    // Get stationary again, then move 100 metres with no speed
+    for (int32_t x = 0; x < continuous.cfg.stationaryNumFixes; x++) {
+        nowMs += 1000;
+        continuousFix(&continuous, latitudeX1e7, 5000, 0, nowMs);
+    }
+    U_PORT_TEST_ASSERT(continuous.stationary);
+    nowMs += 1000;
+    continuousFix(&continuous, 520000000, 5000, INT_MIN, nowMs);
+    U_PORT_TEST_ASSERT(!continuous.stationary);
+    U_PORT_TEST_ASSERT(continuous.numSlowFixes == 0);
+}
+
+/** Test parsing of the location sent back by the Cloud Locate
+ * service, in JSON and in MessagePack form; needs no module.
+ */
+U_PORT_TEST_FUNCTION("[location]", "locationCloudLocateParse")
+{
+    const char *pJson = "{\"Lat\":52.018749899999996,\"Lon\":0.2471071,"
+                        "\"Alt\":120.21600000000001,\"Acc\":29.877,"
+                        "\"MeasTime\":\"2021-11-09T18:24:11\",\"Epochs\":1}";
+    uLocation_t location;
+    uLocationTestMsgPack_t msg = {0};
+    uLocationTestMsgPack_t lat = {0};
+    const char *pStr;
+    size_t length;
+
+    // JSON, where numbers are truncated
+    memset(&location, 0, sizeof(location));
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pJson, strlen(pJson), &location) == 0);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == 520187498);
+    U_PORT_TEST_ASSERT(location.longitudeX1e7 == 2471071);
+    U_PORT_TEST_ASSERT(location.altitudeMillimetres == 120216);
+    U_PORT_TEST_ASSERT(location.radiusMillimetres == 29877);
+    U_PORT_TEST_ASSERT(location.timeUtc == U_LOCATION_TEST_CLOUD_LOCATE_TIME_UTC);
+    pStr = "{\"Lat\":5.2e1,\"Lon\":-1,\"Alt\":0,\"Acc\":1E-3,"
+           "\"MeasTime\":\"2021-11-09T18:24:11\"}";
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pStr, strlen(pStr), &location) == 0);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == 520000000);
+    U_PORT_TEST_ASSERT(location.longitudeX1e7 == -10000000);
+    U_PORT_TEST_ASSERT(location.altitudeMillimetres == 0);
+    U_PORT_TEST_ASSERT(location.radiusMillimetres == 1);
+    // A missing item, an item of the wrong type, a bad time, a time
+    // field too long to hold, a number out of range and a message
+    // cut short in a value all fail
+    pStr = "{\"Lat\":52,\"Lon\":0,\"Alt\":1,\"MeasTime\":\"2021-11-09T18:24:11\"}";
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pStr, strlen(pStr), &location) < 0);
+    pStr = "{\"Lat\":\"52\",\"Lon\":0,\"Alt\":1,\"Acc\":1,\"MeasTime\":\"2021-11-09T18:24:11\"}";
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pStr, strlen(pStr), &location) < 0);
+    pStr = "{\"Lat\":52,\"Lon\":0,\"Alt\":1,\"Acc\":1,\"MeasTime\":1636482251}";
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pStr, strlen(pStr), &location) < 0);
+    pStr = "{\"Lat\":52,\"Lon\":0,\"Alt\":1,\"Acc\":1,\"MeasTime\":\"2020-11-09T18:24:11\"}";
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pStr, strlen(pStr), &location) < 0);
+    pStr = "{\"Lat\":52,\"Lon\":0,\"Alt\":1,\"Acc\":1,"
+           "\"MeasTime\":\"2021-11-09T18:24:99999999999999999999\"}";
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pStr, strlen(pStr), &location) < 0);
+    pStr = "{\"Lat\":215,\"Lon\":0,\"Alt\":1,\"Acc\":1,\"MeasTime\":\"2021-11-09T18:24:11\"}";
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pStr, strlen(pStr), &location) < 0);
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(pJson, strstr(pJson, "29.8") + 4 - pJson,
+                                                        &location) < 0);
+
+    // MessagePack: fixmap, fixstr keys, float 64 and float 32 values
+    // and a fixstr MeasTime, where numbers are rounded
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(NULL, &location) == 0);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == 520187499);
+    U_PORT_TEST_ASSERT(location.longitudeX1e7 == -2471071);
+    U_PORT_TEST_ASSERT(location.altitudeMillimetres == 120216);
+    U_PORT_TEST_ASSERT(location.radiusMillimetres == 29877);
+    U_PORT_TEST_ASSERT(location.timeUtc == U_LOCATION_TEST_CLOUD_LOCATE_TIME_UTC);
+
+    // map 16, str8 keys, positive and negative fixints, uint 8,
+    // uint 16 and uint 32 (as MeasTime) values
+    msgPackValue(&msg, 0xde, 5, 2);
+    msgPackStr(&msg, "Lat", true);
+    msgPackValue(&msg, 52, 0, 0);
+    msgPackStr(&msg, "Lon", true);
+    msgPackValue(&msg, 0xff, 0, 0);
+    msgPackStr(&msg, "Alt", true);
+    msgPackValue(&msg, 0xcc, 200, 1);
+    msgPackStr(&msg, "Acc", true);
+    msgPackValue(&msg, 0xcd, 1000, 2);
+    msgPackStr(&msg, "MeasTime", true);
+    msgPackValue(&msg, 0xce, U_LOCATION_TEST_CLOUD_LOCATE_TIME_UTC, 4);
+    memset(&location, 0, sizeof(location));
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) == 0);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == 520000000);
+    U_PORT_TEST_ASSERT(location.longitudeX1e7 == -10000000);
+    U_PORT_TEST_ASSERT(location.altitudeMillimetres == 200000);
+    U_PORT_TEST_ASSERT(location.radiusMillimetres == 1000000);
+    U_PORT_TEST_ASSERT(location.timeUtc == U_LOCATION_TEST_CLOUD_LOCATE_TIME_UTC);
+
+    // int 8, int 16, int 32, uint 64 and int 64 (as MeasTime) values,
+    // a str8 MeasTime and, for keys we don't know, nil, boolean,
+    // string and number values, which are stepped over
+    memset(&msg, 0, sizeof(msg));
+    msgPackValue(&msg, 0x8b, 0, 0);
+    msgPackStr(&msg, "Lat", false);
+    msgPackValue(&msg, 0xd0, (uint8_t) -50, 1);
+    msgPackStr(&msg, "Nil", false);
+    msgPackValue(&msg, 0xc0, 0, 0);
+    msgPackStr(&msg, "Lon", false);
+    msgPackValue(&msg, 0xd1, (uint16_t) -179, 2);
+    msgPackStr(&msg, "True", false);
+    msgPackValue(&msg, 0xc3, 0, 0);
+    msgPackStr(&msg, "Alt", false);
+    msgPackValue(&msg, 0xd2, (uint32_t) -100, 4);
+    msgPackStr(&msg, "False", false);
+    msgPackValue(&msg, 0xc2, 0, 0);
+    msgPackStr(&msg, "Acc", false);
+    msgPackValue(&msg, 0xcf, 5, 8);
+    msgPackStr(&msg, "Epochs", false);
+    msgPackValue(&msg, 0xd3, 1, 8);
+    msgPackStr(&msg, "MeasTime", false);
+    msgPackValue(&msg, 0xd3, U_LOCATION_TEST_CLOUD_LOCATE_TIME_UTC, 8);
+    msgPackStr(&msg, "Name", false);
+    msgPackStr(&msg, "thing", true);
+    msgPackStr(&msg, "Speed", false);
+    msgPackFloat(&msg, 1.5f);
+    memset(&location, 0, sizeof(location));
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) == 0);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == -500000000);
+    U_PORT_TEST_ASSERT(location.longitudeX1e7 == -1790000000);
+    U_PORT_TEST_ASSERT(location.altitudeMillimetres == -100000);
+    U_PORT_TEST_ASSERT(location.radiusMillimetres == 5000);
+    U_PORT_TEST_ASSERT(location.timeUtc == U_LOCATION_TEST_CLOUD_LOCATE_TIME_UTC);
+    // A str8 MeasTime
+    memset(&msg, 0, sizeof(msg));
+    msgPackValue(&msg, 0x85, 0, 0);
+    msgPackStr(&msg, "Lat", false);
+    msgPackValue(&msg, 1, 0, 0);
+    msgPackStr(&msg, "Lon", false);
+    msgPackValue(&msg, 2, 0, 0);
+    msgPackStr(&msg, "Alt", false);
+    msgPackValue(&msg, 3, 0, 0);
+    msgPackStr(&msg, "Acc", false);
+    msgPackValue(&msg, 4, 0, 0);
+    msgPackStr(&msg, "MeasTime", false);
+    msgPackStr(&msg, "2021-11-09T18:24:11", true);
+    memset(&location, 0, sizeof(location));
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) == 0);
+    U_PORT_TEST_ASSERT(location.radiusMillimetres == 4000);
+    U_PORT_TEST_ASSERT(location.timeUtc == U_LOCATION_TEST_CLOUD_LOCATE_TIME_UTC);
+
+    // Every truncation of a good message fails: the map, a key,
+    // the type of a value or a value cut short
+    memset(&msg, 0, sizeof(msg));
+    msgPackValue(&msg, 0x85, 0, 0);
+    msgPackStr(&msg, "Lat", true);
+    msgPackDouble(&msg, 52.0187499);
+    msgPackStr(&msg, "Lon", false);
+    msgPackValue(&msg, 0xd2, (uint32_t) -1, 4);
+    msgPackStr(&msg, "Alt", false);
+    msgPackFloat(&msg, 120.216f);
+    msgPackStr(&msg, "Acc", false);
+    msgPackValue(&msg, 0xcd, 30, 2);
+    msgPackStr(&msg, "MeasTime", false);
+    msgPackStr(&msg, "2021-11-09T18:24:11", true);
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) == 0);
+    for (size_t x = 1; x < msg.length; x++) {
+        U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, x, &location) < 0);
+    }
+    // A map that says it holds fewer items than it does stops
+    // short, and so fails
+    msg.buffer[0] = (char) 0x84;
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) < 0);
+    msg.buffer[0] = (char) 0x85;
+    // A str8 length that runs past the end fails, for a key
+    // and for a value
+    msg.buffer[2] = (char) 200;
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) < 0);
+    msg.buffer[2] = 3;
+    msg.buffer[msg.length - 20] = (char) 200;
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) < 0);
+    msg.buffer[msg.length - 20] = 19;
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) == 0);
+    // A type we can't step over stops the parse, even when a
+    // good location follows it; a str8 key with no length fails
+    memcpy(lat.buffer, msg.buffer, msg.length);
+    length = msg.length;
+    memset(&msg, 0, sizeof(msg));
+    msgPackValue(&msg, 0x86, 0, 0);
+    msgPackStr(&msg, "Bin", false);
+    msgPackValue(&msg, 0xc4, 0, 1);
+    msgPackBytes(&msg, lat.buffer + 1, length - 1);
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, msg.length, &location) < 0);
+    msg.buffer[1] = (char) 0xd9;
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateParse(msg.buffer, 2, &location) < 0);
+    memset(&lat, 0, sizeof(lat));
+
+    // Integers that would be out of range once scaled, including
+    // those that would overflow while scaling, and floats that are
+    // out of range, infinite or not a number all fail
+    msgPackValue(&lat, 0xcc, 214, 1);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) == 0);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == 2140000000);
+    lat.length = 0;
+    msgPackValue(&lat, 0xcc, 215, 1);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackValue(&lat, 0xd1, (uint16_t) -214, 2);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) == 0);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == -2140000000);
+    lat.length = 0;
+    msgPackValue(&lat, 0xd1, (uint16_t) -215, 2);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackValue(&lat, 0xd3, (uint64_t) INT64_MIN, 8);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackValue(&lat, 0xd3, (uint64_t) INT64_MAX, 8);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackValue(&lat, 0xcf, UINT64_MAX, 8);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackDouble(&lat, 214.7483647);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) == 0);
+    U_PORT_TEST_ASSERT(location.latitudeX1e7 == INT32_MAX);
+    lat.length = 0;
+    msgPackDouble(&lat, 214.7483648);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackDouble(&lat, 1e300);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackDouble(&lat, -1e300);
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackValue(&lat, 0xcb, 0x7ff0000000000000ULL, 8); // Infinity
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackValue(&lat, 0xcb, 0x7ff8000000000000ULL, 8); // NaN
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+    lat.length = 0;
+    msgPackValue(&lat, 0xca, 0x7fc00000, 4); // NaN
+    U_PORT_TEST_ASSERT(cloudLocateParseLat(&lat, &location) < 0);
+}
+
+/** Test how RRLP data is batched for Cloud Locate, with a stand-in
+ * for the MQTT upload; needs no module.
+ */
+U_PORT_TEST_FUNCTION("[location]", "locationCloudLocateBatch")
+{
+    const size_t headerLength = U_LOCATION_PRIVATE_CLOUD_LOCATE_BATCH_LENGTH_BYTES;
+    const size_t bufferLength = U_LOCATION_PRIVATE_CLOUD_LOCATE_BUFFER_LENGTH_BYTES;
+    int32_t heapUsed;
+
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    for (size_t x = 0; x < sizeof(gRrlp); x++) {
+        gRrlp[x] = (char) x;
+    }
+    uLocationPrivateCloudLocateDeinit();
+    gPublishCount = 0;
+    gPublishErrorCode = 0;
+
+    // Nothing to flush, nothing sent
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateBatchFlush(NULL, cloudLocatePublish) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 0);
+
+    // A batch of three goes when the third block is added, each
+    // block preceded by its length, big-endian
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(1, 3) == 0);
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(2, 3) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 0);
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(3, 3) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 1);
+    U_PORT_TEST_ASSERT(gPublish[0].isBatch);
+    U_PORT_TEST_ASSERT(gPublish[0].length == 6 + (headerLength * 3));
+    U_PORT_TEST_ASSERT(memcmp(gPublish[0].data, "\x00\x01\x00\x00\x02\x00\x01\x00\x03\x00\x01\x02",
+                              12) == 0);
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateBatchFlush(NULL, cloudLocatePublish) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 1);
+
+    // A block that exactly fills the batch is held back, the
+    // next block causes the batch to be sent before it is added
+    gPublishCount = 0;
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(500, 100) == 0);
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(bufferLength - 500 - (headerLength * 2), 100) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 0);
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(1, 100) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 1);
+    U_PORT_TEST_ASSERT(gPublish[0].isBatch);
+    U_PORT_TEST_ASSERT(gPublish[0].length == bufferLength);
+    U_PORT_TEST_ASSERT((gPublish[0].data[0] == 0x01) && (gPublish[0].data[1] == (char) 0xf4));
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateBatchFlush(NULL, cloudLocatePublish) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 2);
+    U_PORT_TEST_ASSERT(gPublish[1].isBatch);
+    U_PORT_TEST_ASSERT(gPublish[1].length == 1 + headerLength);
+
+    // The largest block that can be batched is held back
+    gPublishCount = 0;
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(bufferLength - headerLength, 100) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 0);
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateBatchFlush(NULL, cloudLocatePublish) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 1);
+    U_PORT_TEST_ASSERT(gPublish[0].length == bufferLength);
+
+    // A block too large to batch is sent on its own, but only
+    // after what was already held back, so that order is kept
+    gPublishCount = 0;
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(1, 100) == 0);
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(bufferLength - headerLength + 1, 100) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 2);
+    U_PORT_TEST_ASSERT(gPublish[0].isBatch);
+    U_PORT_TEST_ASSERT(gPublish[0].length == 1 + headerLength);
+    U_PORT_TEST_ASSERT(!gPublish[1].isBatch);
+    U_PORT_TEST_ASSERT(gPublish[1].length == bufferLength - headerLength + 1);
+    U_PORT_TEST_ASSERT(memcmp(gPublish[1].data, gRrlp, sizeof(gPublish[1].data)) == 0);
+
+    // If the upload fails the batch is kept, and a block too large
+    // to batch is not sent ahead of it
+    gPublishCount = 0;
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(4, 2) == 0);
+    gPublishErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(5, 2) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(gPublishCount == 1);
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(bufferLength, 2) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(gPublishCount == 2);
+    U_PORT_TEST_ASSERT(gPublish[1].isBatch);
+    gPublishErrorCode = 0;
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateBatchFlush(NULL, cloudLocatePublish) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 3);
+    U_PORT_TEST_ASSERT(gPublish[2].isBatch);
+    U_PORT_TEST_ASSERT(gPublish[2].length == 4 + 5 + (headerLength * 2));
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateBatchFlush(NULL, cloudLocatePublish) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 3);
+
+    // Anything held back is freed, not sent, on deinitialisation
+    U_PORT_TEST_ASSERT(cloudLocateBatchAdd(1, 2) == 0);
+    uLocationPrivateCloudLocateDeinit();
+    U_PORT_TEST_ASSERT(uLocationPrivateCloudLocateBatchFlush(NULL, cloudLocatePublish) == 0);
+    U_PORT_TEST_ASSERT(gPublishCount == 3);
+
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Run continuous location on each network that supports GNSS.
+ */
+U_PORT_TEST_FUNCTION("[location]", "locationContinuous")
+{
+    uNetworkTestList_t *pList;
+    uDeviceHandle_t devHandle;
+    // Get stationary quickly and keep taking fixes while stationary
+    uLocationContinuousCfg_t cfg = {1000, 5000, 10000, 2000, 2, 2000,
+                                    NULL, U_LOCATION_TYPE_NONE,
+                                    U_LOCATION_CONTINUOUS_GNSS_STATIONARY_ON
+                                   };
+    int32_t count;
+    int32_t periodMs;
+    int32_t startTimeMs;
+    int32_t heapUsed;
+
+    // In case a previous test failed
+    uNetworkTestCleanUp();
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+
+    // Do the standard preamble to make sure there is
+    // a network underneath us
+    pList = pStdPreamble();
+    if (pList == NULL) {
+        U_TEST_PRINT_LINE("*** WARNING *** nothing to do.");
+    }
+
+    // Get the initialish heap
+    heapUsed = uPortGetHeapFree();
+
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (pTmp->networkType != U_NETWORK_TYPE_GNSS) {
+            continue;
+        }
+        devHandle = *pTmp->pDevHandle;
+        U_TEST_PRINT_LINE("testing continuous location on %s network...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+
+        gDevHandle = NULL;
+        gContinuousCount = 0;
+        gContinuousGoodCount = 0;
+        U_PORT_TEST_ASSERT(uLocationContinuousStart(devHandle, U_LOCATION_TYPE_GNSS,
+                                                    NULL, NULL, &cfg,
+                                                    continuousCallback) == 0);
+        // Only one at a time
+        U_PORT_TEST_ASSERT(uLocationContinuousStart(devHandle, U_LOCATION_TYPE_GNSS,
+                                                    NULL, NULL, &cfg,
+                                                    continuousCallback) < 0);
+        U_PORT_TEST_ASSERT(uLocationContinuousGetPeriodMs(NULL) < 0);
+
+        // Wait for a few fixes
+        startTimeMs = uPortGetTickTimeMs();
+        while ((gContinuousGoodCount < cfg.stationaryNumFixes + 2) &&
+               (uPortGetTickTimeMs() - startTimeMs < U_LOCATION_TEST_CFG_TIMEOUT_SECONDS * 1000)) {
+            uPortTaskBlock(1000);
+        }
+        periodMs = uLocationContinuousGetPeriodMs(devHandle);
+        U_TEST_PRINT_LINE("%d callback(s), %d with a fix, period now %d ms.",
+                          gContinuousCount, gContinuousGoodCount, periodMs);
+        U_PORT_TEST_ASSERT(gContinuousGoodCount >= cfg.stationaryNumFixes + 2);
+        U_PORT_TEST_ASSERT(gDevHandle == devHandle);
+        // Moving or, likely on a bench, stationary
+        U_PORT_TEST_ASSERT(((periodMs >= cfg.periodMinMs) && (periodMs <= cfg.periodMaxMs)) ||
+                           (periodMs == cfg.periodStationaryMs));
+
+        // Motion is accepted whether stationary or not, and
+        // only from the device that is running
+        U_PORT_TEST_ASSERT(uLocationContinuousMotion(devHandle) == 0);
+        U_PORT_TEST_ASSERT(uLocationContinuousMotion(NULL) < 0);
+
+        // Once stopped there should be no more callbacks
+        uLocationContinuousStop(devHandle);
+        count = gContinuousCount;
+        uPortTaskBlock(cfg.periodMaxMs * 2);
+        U_PORT_TEST_ASSERT(gContinuousCount == count);
+        U_PORT_TEST_ASSERT(uLocationContinuousGetPeriodMs(devHandle) < 0);
+    }
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+
+    // Remove each network type
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        U_TEST_PRINT_LINE("taking down %s...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceDown(*pTmp->pDevHandle,
+                                                 pTmp->networkType) == 0);
+    }
+
+    // Close the devices and free the list
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (*pTmp->pDevHandle != NULL) {
+            U_TEST_PRINT_LINE("closing device %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType]);
+            U_PORT_TEST_ASSERT(uDeviceClose(*pTmp->pDevHandle, false) == 0);
+            *pTmp->pDevHandle = NULL;
+        }
+    }
+    uNetworkTestListFree();
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
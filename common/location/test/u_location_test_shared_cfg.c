@@ -183,7 +183,8 @@ const char *gpULocationTestTypeStr[] = {"none",         // U_LOCATION_TYPE_NONE
                                         "Google",      // U_LOCATION_TYPE_CLOUD_GOOGLE
                                         "Skyhook",     // U_LOCATION_TYPE_CLOUD_SKYHOOK
                                         "Here",        // U_LOCATION_TYPE_CLOUD_HERE
-                                        "Cloud Locate" // U_LOCATION_TYPE_CLOUD_CLOUD_LOCATE
+                                        "Cloud Locate", // U_LOCATION_TYPE_CLOUD_CLOUD_LOCATE
+                                        "Cell Locate and GNSS" // U_LOCATION_TYPE_CELL_LOCATE_AND_GNSS
                                        };
 
 /* ----------------------------------------------------------------
@@ -52,13 +52,68 @@ extern "C" {
 # define U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS 30
 #endif
 
+#ifndef U_MQTT_CLIENT_PUBLISH_ASYNC_WINDOW
+/** The maximum number of messages passed to
+ * uMqttClientPublishAsync() that may be outstanding, i.e. queued
+ * or in the process of being published, for one MQTT client at
+ * any one time; when this many are outstanding
+ * uMqttClientPublishAsync() will return
+ * #U_ERROR_COMMON_TEMPORARY_FAILURE until one has completed.
+ */
+# define U_MQTT_CLIENT_PUBLISH_ASYNC_WINDOW 8
+#endif
+
+#ifndef U_MQTT_CLIENT_STORE_DRAIN_INTERVAL_MS
+/** The interval between the publishes of messages held by
+ * uMqttClientStorePublish() when they are being forwarded after
+ * a reconnection, so that the reconnection does not cause a
+ * burst.
+ */
+# define U_MQTT_CLIENT_STORE_DRAIN_INTERVAL_MS 100
+#endif
+
+#ifndef U_MQTT_CLIENT_ROUTE_TOPIC_MAX_LENGTH_BYTES
+/** The maximum length of topic name, including terminator, that
+ * can be received for a handler added with uMqttClientRouteAdd();
+ * a longer topic name will be truncated before matching.
+ */
+# define U_MQTT_CLIENT_ROUTE_TOPIC_MAX_LENGTH_BYTES 256
+#endif
+
+#ifndef U_MQTT_CLIENT_ROUTE_MESSAGE_MAX_LENGTH_BYTES
+/** The maximum length of message that can be received for a handler
+ * added with uMqttClientRouteAdd(); a longer message will be
+ * truncated.
+ */
+# define U_MQTT_CLIENT_ROUTE_MESSAGE_MAX_LENGTH_BYTES 1024
+#endif
+
+#ifndef U_MQTT_CLIENT_ROUTE_MAX_MATCHES
+/** The maximum number of handlers added with uMqttClientRouteAdd()
+ * that can be called for any one message, i.e. the maximum number
+ * of overlapping topic filters that a message may match.
+ */
+# define U_MQTT_CLIENT_ROUTE_MAX_MATCHES 8
+#endif
+
 /** The defaults for an MQTT connection, see #uMqttClientConnection_t.
  * Whenever an instance of uMqttClientConnection_t is created it
  * should be assigned to this to ensure the correct default
  * settings. */
 #define U_MQTT_CLIENT_CONNECTION_DEFAULT {NULL, NULL, NULL, NULL,  \
                                           -1, -1, false, false,    \
-                                          NULL, NULL, false, 0}
+                                          NULL, NULL, false, 0,    \
+                                          false, false}
+
+/** The marker at the start of a payload that has been compressed,
+ * see the compress field of #uMqttClientConnection_t.  The first
+ * byte, 0xFF, never appears in UTF-8 text.
+ */
+#define U_MQTT_CLIENT_COMPRESSION_MARKER "\xFFZL1"
+
+/** The length of #U_MQTT_CLIENT_COMPRESSION_MARKER.
+ */
+#define U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES 4
 
 /** The number of bytes required to store a short MQTT-SN topic name,
  * which will be of the form "xy", two characters plus a null terminator.
@@ -177,8 +232,55 @@ typedef struct {
     int32_t radius;                    /**< applicable to MQTT-SN only; not
                                             currently supported by any u-blox
                                             modules. */
+    bool compress;                     /**< set to true to compress payloads:
+                                            uMqttClientPublish() then sends a
+                                            payload LZSS-compressed (see
+                                            u_lzss.h), prefixed with
+                                            #U_MQTT_CLIENT_COMPRESSION_MARKER,
+                                            wherever that makes it smaller, and
+                                            uMqttClientMessageRead() decompresses
+                                            any payload that begins with the
+                                            marker, so that compression is
+                                            invisible to the application; both
+                                            ends must agree to use it.  Costs a
+                                            temporary buffer the size of the
+                                            payload on each publish and each
+                                            read of a compressed payload.
+                                            Applicable to MQTT only, not
+                                            MQTT-SN, defaults to false. */
+    bool resubscribe;                  /**< set to true to have the client
+                                            remember the topic filters
+                                            subscribed to with
+                                            uMqttClientSubscribe() or
+                                            uMqttClientSubscribeMulti()
+                                            (less those unsubscribed from)
+                                            and subscribe to all of them
+                                            again, in one batch, on each
+                                            subsequent successful
+                                            uMqttClientConnect(); this is
+                                            useful where the session is not
+                                            retained by the broker, so that
+                                            the device is listening again as
+                                            soon as possible after a
+                                            reconnection.  A failure to
+                                            re-subscribe does not fail the
+                                            connection.  Applicable to MQTT
+                                            only, not MQTT-SN, defaults to
+                                            false. */
 } uMqttClientConnection_t;
 
+/** Payload compression statistics, see uMqttClientGetCompressionStats();
+ * all payloads are counted, whether they were compressed or not.
+ */
+typedef struct {
+    size_t txBytesUncompressed; /**< the payload bytes given to
+                                     uMqttClientPublish(). */
+    size_t txBytesCompressed;   /**< the payload bytes actually sent. */
+    size_t rxBytesCompressed;   /**< the payload bytes actually received. */
+    size_t rxBytesUncompressed; /**< the payload bytes returned by
+                                     uMqttClientMessageRead(). */
+} uMqttClientCompressionStats_t;
+
 /** MQTT context data, used internally by this code and
  * exposed here only so that it can be handed around by the
  * caller.  The contents and, umm, structure of this structure
@@ -195,6 +297,29 @@ typedef struct {
     uSecurityTlsContext_t *pSecurityContext;
     int32_t totalMessagesSent;      /* Total messages sent from MQTT client */
     int32_t totalMessagesReceived;  /* Total messages received by MQTT client */
+    int32_t publishAsyncEventQueueHandle; /* Event queue used by uMqttClientPublishAsync(),
+                                             negative if not yet opened */
+    int32_t publishAsyncNumOutstanding;   /* Messages queued by uMqttClientPublishAsync()
+                                             which have not yet completed */
+    int32_t publishAsyncNextMessageId;    /* The message ID for the next call to
+                                             uMqttClientPublishAsync() */
+    volatile bool closing;                /* Set by uMqttClientClose() so that queued
+                                             events are not processed */
+    void (*pMessageCallback) (int32_t, void *); /* As set by uMqttClientSetMessageCallback() */
+    void *pMessageCallbackParam;
+    void *pRouteRoot;               /* Root of the topic filter trie of uMqttClientRouteAdd() */
+    int32_t routeEventQueueHandle;  /* Event queue used to read messages for routing,
+                                       negative if not yet opened */
+    void *pStore;                   /* Messages held by uMqttClientStorePublish() */
+    size_t storeSizeBytes;          /* The memory occupied by the messages at pStore */
+    size_t storeMaxSizeBytes;       /* As set by uMqttClientStoreSetSize() */
+    bool storeDrainPending;         /* True if forwarding of pStore has been queued */
+    void *pSnTopicCache;            /* Topic IDs from uMqttClientSnRegisterNormalTopic() */
+    char *pSnTopicCacheBrokerNameStr; /* The MQTT-SN gateway that pSnTopicCache belongs to */
+    bool compress;                  /* As set in uMqttClientConnection_t */
+    uMqttClientCompressionStats_t compressionStats;
+    bool resubscribe;               /* As set in uMqttClientConnection_t */
+    void *pSubscriptions;           /* Topic filters to re-subscribe to on connect */
 } uMqttClientContext_t;
 
 /* ----------------------------------------------------------------
@@ -284,6 +409,9 @@ bool uMqttClientIsConnected(const uMqttClientContext_t *pContext);
 /** Set a callback to be called when new messages are
  * available to be read.  The callback may then call
  * uMqttClientGetUnread() to get the number of unread messages.
+ * While any handler added with uMqttClientRouteAdd() is present
+ * messages are read and dispatched automatically and this
+ * callback is not called.
  *
  * @param[in] pContext        a pointer to the internal MQTT context
  *                            structure that was originally returned
@@ -298,7 +426,7 @@ bool uMqttClientIsConnected(const uMqttClientContext_t *pContext);
  *                            as the second parameter.
  * @return                    zero on success else negative error code.
  */
-int32_t uMqttClientSetMessageCallback(const uMqttClientContext_t *pContext,
+int32_t uMqttClientSetMessageCallback(uMqttClientContext_t *pContext,
                                       void (*pCallback) (int32_t, void *),
                                       void *pCallbackParam);
 
@@ -338,6 +466,19 @@ int32_t uMqttClientGetTotalMessagesSent(const uMqttClientContext_t *pContext);
  */
 int32_t uMqttClientGetTotalMessagesReceived(const uMqttClientContext_t *pContext);
 
+/** Get the payload compression statistics of an MQTT client, see
+ * the compress field of #uMqttClientConnection_t; the statistics
+ * are counted from when the client was opened and are kept whether
+ * compression is switched on or not, so that the benefit of
+ * switching it on can be judged.
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context.
+ * @param[out] pStats   a place to put the statistics; cannot be NULL.
+ * @return              zero on success else negative error code.
+ */
+int32_t uMqttClientGetCompressionStats(const uMqttClientContext_t *pContext,
+                                       uMqttClientCompressionStats_t *pStats);
+
 /** Set a callback to be called if the broker drops the MQTT
  * connection.
  *
@@ -391,6 +532,76 @@ int32_t uMqttClientPublish(uMqttClientContext_t *pContext,
                            size_t messageSizeBytes,
                            uMqttQos_t qos, bool retain);
 
+/** MQTT only: publish an MQTT message without waiting for the
+ * result.  The topic and message are copied into a queue and this
+ * function returns immediately; the messages queued for an MQTT
+ * client are published, in order, by a background task, exactly
+ * as if uMqttClientPublish() had been called, and then pCallback
+ * is called with the result.  Up to
+ * #U_MQTT_CLIENT_PUBLISH_ASYNC_WINDOW messages may be outstanding
+ * at any one time; beyond that #U_ERROR_COMMON_TEMPORARY_FAILURE
+ * is returned and the caller should try again once a callback has
+ * been received.  If the MQTT client is closed while messages are
+ * still queued they are not published and their callbacks are
+ * called with #U_ERROR_COMMON_NOT_INITIALISED.
+ *
+ * Note that the background task consumes memory (see
+ * U_MQTT_CLIENT_PUBLISH_ASYNC_TASK_STACK_SIZE_BYTES in
+ * u_mqtt_client.c), which is only released when the MQTT client is
+ * closed.
+ *
+ * @param[in] pContext      a pointer to the internal MQTT context
+ *                          structure that was originally returned
+ *                          by pUMqttClientOpen().
+ * @param[in] pTopicNameStr the null-terminated topic string
+ *                          for the message; cannot be NULL.
+ * @param[in] pMessage      a pointer to the message; the message
+ *                          is not restricted to ASCII values.
+ *                          Cannot be NULL.
+ * @param messageSizeBytes  the length of pMessage.
+ * @param qos               the MQTT QoS to use for this message.
+ * @param retain            if true the message will be kept
+ *                          by the broker across MQTT disconnects/
+ *                          connects, else it will be cleared.
+ * @param[in] pCallback     the callback to be called when the
+ *                          publish has completed, may be NULL.
+ *                          The parameters are pContext, the message
+ *                          ID returned by this function, the
+ *                          return value of uMqttClientPublish()
+ *                          for the message and pCallbackParam.
+ *                          The callback is called from the
+ *                          background task; it may call
+ *                          uMqttClientPublishAsync() but it must
+ *                          not call uMqttClientClose().
+ * @param[in] pCallbackParam a parameter that will be passed to
+ *                          pCallback, may be NULL.
+ * @return                  on success the message ID, a
+ *                          non-negative number that increments
+ *                          with each message queued, else negative
+ *                          error code.
+ */
+int32_t uMqttClientPublishAsync(uMqttClientContext_t *pContext,
+                                const char *pTopicNameStr,
+                                const char *pMessage,
+                                size_t messageSizeBytes,
+                                uMqttQos_t qos, bool retain,
+                                void (*pCallback) (uMqttClientContext_t *,
+                                                   int32_t,
+                                                   int32_t,
+                                                   void *),
+                                void *pCallbackParam);
+
+/** MQTT only: get the number of messages passed to
+ * uMqttClientPublishAsync() that have not yet completed.
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ * @return              the number of outstanding messages, else
+ *                      negative error code.
+ */
+int32_t uMqttClientGetPublishAsyncOutstanding(uMqttClientContext_t *pContext);
+
 /** MQTT only: subscribe to an MQTT topic. If pKeepGoingCallback()
  * inside the pConnection structure passed to uMqttClientConnect()
  * was non-NULL it will be called while this function is waiting
@@ -432,6 +643,51 @@ int32_t uMqttClientSubscribe(const uMqttClientContext_t *pContext,
 int32_t uMqttClientUnsubscribe(const uMqttClientContext_t *pContext,
                                const char *pTopicFilterStr);
 
+/** MQTT only: subscribe to several MQTT topics at once.  On cellular
+ * the subscriptions are pipelined so that this takes little more than
+ * the time of a single subscription; elsewhere they are simply
+ * performed one after the other under a single lock.
+ *
+ * @param[in] pContext          a pointer to the internal MQTT context
+ *                              structure that was originally returned
+ *                              by pUMqttClientOpen().
+ * @param[in] ppTopicFilterStr  an array of numTopics pointers to
+ *                              null-terminated topic filter strings,
+ *                              as for uMqttClientSubscribe(); cannot
+ *                              be NULL.
+ * @param[in] pMaxQos           an array of numTopics maximum QoS values,
+ *                              one for each topic filter; cannot be NULL.
+ * @param numTopics             the number of topic filters.
+ * @param[out] pQos             an array of numTopics places to put
+ *                              the outcome for each topic filter, the
+ *                              QoS of the subscription or negative error
+ *                              code; may be NULL.
+ * @return                      zero if all of the subscriptions succeeded
+ *                              else negative error code.
+ */
+int32_t uMqttClientSubscribeMulti(uMqttClientContext_t *pContext,
+                                  const char *const *ppTopicFilterStr,
+                                  const uMqttQos_t *pMaxQos,
+                                  size_t numTopics, int32_t *pQos);
+
+/** MQTT only: unsubscribe from several MQTT topics at once, see
+ * uMqttClientSubscribeMulti().
+ *
+ * @param[in] pContext          a pointer to the internal MQTT context
+ *                              structure that was originally returned
+ *                              by pUMqttClientOpen().
+ * @param[in] ppTopicFilterStr  an array of numTopics pointers to
+ *                              null-terminated topic filter strings,
+ *                              as for uMqttClientUnsubscribe(); cannot
+ *                              be NULL.
+ * @param numTopics             the number of topic filters.
+ * @return                      zero if all of the unsubscriptions
+ *                              succeeded else negative error code.
+ */
+int32_t uMqttClientUnsubscribeMulti(uMqttClientContext_t *pContext,
+                                    const char *const *ppTopicFilterStr,
+                                    size_t numTopics);
+
 /** MQTT only: read an MQTT message.
  *
  * @param[in] pContext              a pointer to the internal MQTT context
@@ -459,6 +715,230 @@ int32_t uMqttClientMessageRead(uMqttClientContext_t *pContext,
                                size_t *pMessageSizeBytes,
                                uMqttQos_t *pQos);
 
+/** MQTT only: set the amount of RAM that may be used to hold
+ * messages passed to uMqttClientStorePublish() while the MQTT
+ * client is not connected; by default this is zero, which means
+ * that uMqttClientStorePublish() cannot be used.  Setting the size
+ * to zero discards any messages being held.  If the size is reduced
+ * below that currently in use, messages already held are kept but
+ * no more are accepted until space is available.
+ *
+ * @param[in] pContext     a pointer to the internal MQTT context
+ *                         structure that was originally returned
+ *                         by pUMqttClientOpen().
+ * @param maxSizeBytes     the maximum number of bytes of RAM
+ *                         to use, including overheads.
+ * @return                 zero on success else negative error code.
+ */
+int32_t uMqttClientStoreSetSize(uMqttClientContext_t *pContext,
+                                size_t maxSizeBytes);
+
+/** MQTT only: publish an MQTT message, holding it in RAM, and so
+ * not losing it, if it cannot be sent now; store-and-forward.
+ * The message is copied and this function returns immediately.
+ * Held messages are published by a background task (the same one
+ * as uMqttClientPublishAsync()) whenever the MQTT client is
+ * connected: as soon as they are stored and again on each successful
+ * uMqttClientConnect().  They are published highest priority first
+ * and, within the same priority, in the order they were stored,
+ * #U_MQTT_CLIENT_STORE_DRAIN_INTERVAL_MS apart.  If a publish fails
+ * the message is kept and the forwarding stops until the next
+ * store or reconnection.  When storing a message would exceed the
+ * size set with uMqttClientStoreSetSize(), expired messages are
+ * discarded first and then, newest first, messages of a lower
+ * priority than this one; if there is still not room this
+ * message is rejected.
+ *
+ * @param[in] pContext      a pointer to the internal MQTT context
+ *                          structure that was originally returned
+ *                          by pUMqttClientOpen().
+ * @param[in] pTopicNameStr the null-terminated topic string
+ *                          for the message; cannot be NULL.
+ * @param[in] pMessage      a pointer to the message; cannot be NULL.
+ * @param messageSizeBytes  the length of pMessage.
+ * @param qos               the MQTT QoS to use for this message.
+ * @param retain            if true the message will be kept
+ *                          by the broker across MQTT disconnects/
+ *                          connects, else it will be cleared.
+ * @param priority          the priority of the message, larger
+ *                          numbers being higher priority.
+ * @param ttlSeconds        the time for which the message may be
+ *                          held before it is discarded unsent;
+ *                          use -1 for no limit.
+ * @return                  zero on success (the message is held),
+ *                          else negative error code;
+ *                          #U_ERROR_COMMON_NOT_INITIALISED if
+ *                          uMqttClientStoreSetSize() has not
+ *                          been called.
+ */
+int32_t uMqttClientStorePublish(uMqttClientContext_t *pContext,
+                                const char *pTopicNameStr,
+                                const char *pMessage,
+                                size_t messageSizeBytes,
+                                uMqttQos_t qos, bool retain,
+                                int32_t priority,
+                                int32_t ttlSeconds);
+
+/** MQTT only: get the number of messages held by
+ * uMqttClientStorePublish() that have not yet been published,
+ * including any that have expired but have not yet been discarded.
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ * @return              the number of messages held, else
+ *                      negative error code.
+ */
+int32_t uMqttClientStoreGetNum(uMqttClientContext_t *pContext);
+
+/** MQTT only: add a handler for the messages that match a topic
+ * filter.  Once a handler has been added, messages are read as soon
+ * as they arrive, by a background task, and passed to the handler of
+ * every topic filter they match; the topic filters are held in a
+ * trie of topic levels so that the cost of matching depends on the
+ * number of levels in a topic rather than on the number of handlers.
+ * A message which matches no topic filter is discarded, so add a
+ * handler for "#" as a default if required.  Messages are subject to
+ * #U_MQTT_CLIENT_ROUTE_TOPIC_MAX_LENGTH_BYTES and
+ * #U_MQTT_CLIENT_ROUTE_MESSAGE_MAX_LENGTH_BYTES.  This does NOT
+ * subscribe: call uMqttClientSubscribe() as well.
+ *
+ * The background task consumes memory, which is only released
+ * when the MQTT client is closed.
+ *
+ * @param[in] pContext         a pointer to the internal MQTT context
+ *                             structure that was originally returned
+ *                             by pUMqttClientOpen().
+ * @param[in] pTopicFilterStr  the null-terminated topic filter,
+ *                             which may include the wildcard '+'
+ *                             to match any one topic level and,
+ *                             as the last level only, the wildcard
+ *                             '#' to match everything from there on;
+ *                             cannot be NULL.  As for an MQTT broker,
+ *                             a filter starting with a wildcard does
+ *                             not match a topic starting with '$'.
+ * @param[in] pHandler         the handler, cannot be NULL; the
+ *                             parameters are pContext, the topic
+ *                             name, the message, the length of
+ *                             the message, its QoS and pHandlerParam.
+ *                             The handler is called from the background
+ *                             task and the message is only valid for
+ *                             the duration of the call; the handler
+ *                             may call this API but must not call
+ *                             uMqttClientClose().  If a handler
+ *                             is already present for this exact filter
+ *                             it is replaced.
+ * @param[in] pHandlerParam    a parameter that will be passed to
+ *                             pHandler, may be NULL.
+ * @return                     zero on success else negative error code.
+ */
+int32_t uMqttClientRouteAdd(uMqttClientContext_t *pContext,
+                            const char *pTopicFilterStr,
+                            void (*pHandler) (uMqttClientContext_t *,
+                                              const char *,
+                                              const char *,
+                                              size_t,
+                                              uMqttQos_t,
+                                              void *),
+                            void *pHandlerParam);
+
+/** MQTT only: remove a handler that was added with
+ * uMqttClientRouteAdd().  This does NOT unsubscribe: call
+ * uMqttClientUnsubscribe() as well.
+ *
+ * @param[in] pContext         a pointer to the internal MQTT context
+ *                             structure that was originally returned
+ *                             by pUMqttClientOpen().
+ * @param[in] pTopicFilterStr  the null-terminated topic filter,
+ *                             exactly as passed to uMqttClientRouteAdd().
+ * @return                     zero on success else negative error code;
+ *                             #U_ERROR_COMMON_NOT_FOUND if there is no
+ *                             handler for pTopicFilterStr.
+ */
+int32_t uMqttClientRouteRemove(uMqttClientContext_t *pContext,
+                               const char *pTopicFilterStr);
+
+/** MQTT only: read an MQTT message in chunks, for messages too
+ * large to fit in one buffer.  The message is read into
+ * pChunkBuffer, at most chunkSizeBytes at a time, and each chunk
+ * is passed to pCallback as it arrives, so the memory required is
+ * bounded by chunkSizeBytes rather than by the size of the message.
+ * Supported for cellular and Wi-Fi; for Wi-Fi the message
+ * payload is binary-safe, i.e. it is passed on exactly as received.
+ *
+ * IMPORTANT: pCallback is called from within the underlying
+ * cellular/Wifi API; it must not call into this or any other
+ * ubxlib API.
+ *
+ * @param[in] pContext          a pointer to the internal MQTT context
+ *                              structure that was originally returned
+ *                              by pUMqttClientOpen().
+ * @param[out] pTopicNameStr    a place to put the null-terminated
+ *                              topic string of the message; cannot
+ *                              be NULL.
+ * @param topicNameSizeBytes    the number of bytes of storage at
+ *                              pTopicNameStr.
+ * @param[in] pChunkBuffer      storage for one chunk of the message;
+ *                              cannot be NULL.
+ * @param chunkSizeBytes        the number of bytes of storage at
+ *                              pChunkBuffer; must be greater than zero.
+ * @param[in] pCallback         the function that will be called with
+ *                              each chunk; cannot be NULL.  The
+ *                              parameters are a pointer to the chunk
+ *                              (pChunkBuffer), the length of the chunk,
+ *                              the offset of the chunk from the start
+ *                              of the message, the total length of the
+ *                              message and pCallbackParam.  If the
+ *                              callback returns false the rest of the
+ *                              message is discarded.
+ * @param[in] pCallbackParam    a parameter that will be passed to
+ *                              pCallback; may be NULL.
+ * @param[out] pQos             a place to put the QoS of the message;
+ *                              may be NULL.
+ * @return                      on success the number of bytes of
+ *                              message passed to pCallback, else
+ *                              negative error code.
+ */
+int32_t uMqttClientMessageReadChunked(uMqttClientContext_t *pContext,
+                                      char *pTopicNameStr,
+                                      size_t topicNameSizeBytes,
+                                      char *pChunkBuffer,
+                                      size_t chunkSizeBytes,
+                                      bool (*pCallback) (const char *, size_t,
+                                                         size_t, size_t,
+                                                         void *),
+                                      void *pCallbackParam,
+                                      uMqttQos_t *pQos);
+
+/** MQTT only: publish the metrics registered with the metrics
+ * registry (see u_metrics.h), as a JSON object, to the given topic
+ * every periodMs, so that one call reports everything the library
+ * counts.  The publish is made from the metrics export task and
+ * is skipped while not connected.  Only one export may be running
+ * at a time, across all MQTT sessions; calling this again replaces
+ * the existing export.  The export is stopped automatically by
+ * uMqttClientClose().
+ *
+ * @param[in] pContext       a pointer to the internal MQTT context
+ *                           structure that was originally returned by
+ *                           pUMqttClientOpen().
+ * @param[in] pTopicNameStr  the null-terminated topic string to publish
+ *                           to; this is not copied and so must remain
+ *                           valid until the export is stopped.
+ * @param qos                the MQTT QoS to publish with.
+ * @param periodMs           the export period in milliseconds.
+ * @return                   zero on success else negative error code.
+ */
+int32_t uMqttClientMetricsExportStart(uMqttClientContext_t *pContext,
+                                      const char *pTopicNameStr,
+                                      uMqttQos_t qos,
+                                      int32_t periodMs);
+
+/** MQTT only: stop publishing metrics, see
+ * uMqttClientMetricsExportStart().
+ */
+void uMqttClientMetricsExportStop();
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MQTT-SN ONLY
  * -------------------------------------------------------------- */
@@ -576,6 +1056,15 @@ int32_t uMqttClientSnGetTopicNameShort(const uMqttSnTopicName_t *pTopicName,
  * subscribing.
  * Must be connected to an MQTT-SN broker for this to work.
  *
+ * The topic IDs obtained are cached, so calling this again for the
+ * same topic name, for instance after waking up from sleep, does not
+ * cost a round trip to the gateway.  The cache is kept across calls to
+ * uMqttClientSnConnect() for the same gateway where the retain field
+ * of the connection is true (i.e. not a clean session), otherwise it is
+ * emptied.  If uMqttClientSnPublish() fails using a topic ID from the
+ * cache that topic ID is removed from the cache, so that the next call
+ * to this function registers the topic again.
+ *
  * @param[in] pContext       a pointer to the internal MQTT context.
  * @param[in] pTopicNameStr  the null-terminated topic name string;
  *                           cannot be NULL.
@@ -583,7 +1072,7 @@ int32_t uMqttClientSnGetTopicNameShort(const uMqttSnTopicName_t *pTopicName,
  *                           cannot be NULL.
  * @return                   zero on success, else negative error code.
  */
-int32_t uMqttClientSnRegisterNormalTopic(const uMqttClientContext_t *pContext,
+int32_t uMqttClientSnRegisterNormalTopic(uMqttClientContext_t *pContext,
                                          const char *pTopicNameStr,
                                          uMqttSnTopicName_t *pTopicName);
 
@@ -50,11 +50,18 @@
 #include "stdbool.h"
 #include "string.h"    // strlen(), strncpy()
 
+#include "u_cfg_os_platform_specific.h"
+
 #include "u_error_common.h"
 
 #include "u_device_shared.h"
 
+#include "u_port.h"
 #include "u_port_os.h"
+#include "u_port_event_queue.h"
+
+#include "u_metrics.h"
+#include "u_lzss.h"
 
 #include "u_mqtt_common.h"
 #include "u_mqtt_client.h"
@@ -67,10 +74,129 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_MQTT_CLIENT_PUBLISH_ASYNC_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that publishes the messages queued
+ * by uMqttClientPublishAsync(); this task calls into the underlying
+ * cell/wifi MQTT layer and then calls the user's callback.
+ */
+# define U_MQTT_CLIENT_PUBLISH_ASYNC_TASK_STACK_SIZE_BYTES 2560
+#endif
+
+#ifndef U_MQTT_CLIENT_PUBLISH_ASYNC_TASK_PRIORITY
+/** The priority of the task that publishes the messages queued
+ * by uMqttClientPublishAsync().
+ */
+# define U_MQTT_CLIENT_PUBLISH_ASYNC_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+#ifndef U_MQTT_CLIENT_ROUTE_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that reads messages and passes them
+ * to the handlers added with uMqttClientRouteAdd().
+ */
+# define U_MQTT_CLIENT_ROUTE_TASK_STACK_SIZE_BYTES 2560
+#endif
+
+#ifndef U_MQTT_CLIENT_ROUTE_TASK_PRIORITY
+/** The priority of the task that reads messages and passes them
+ * to the handlers added with uMqttClientRouteAdd().
+ */
+# define U_MQTT_CLIENT_ROUTE_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+#ifndef U_MQTT_CLIENT_ROUTE_EVENT_QUEUE_LENGTH
+/** The length of the event queue used to wake up the task that
+ * reads messages for routing; since each event causes all unread
+ * messages to be read this need not be large.
+ */
+# define U_MQTT_CLIENT_ROUTE_EVENT_QUEUE_LENGTH 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A message queued by uMqttClientPublishAsync(), passed by value
+ * through the event queue.
+ */
+typedef struct {
+    uMqttClientContext_t *pContext;
+    char *pBuffer; /* The null-terminated topic followed by the message,
+                      in one malloc()ed block. */
+    size_t messageSizeBytes;
+    uMqttQos_t qos;
+    bool retain;
+    int32_t messageId;
+    void (*pCallback) (uMqttClientContext_t *, int32_t, int32_t, void *);
+    void *pCallbackParam;
+} uMqttClientPublishAsync_t;
+
+/** A message held by uMqttClientStorePublish(); the topic and
+ * message are stored in the same malloc() as this structure.
+ */
+typedef struct uMqttClientStoreEntry_t {
+    struct uMqttClientStoreEntry_t *pNext;
+    int32_t priority;
+    int32_t storedTimeMs;
+    int32_t ttlMs; /* Negative for no limit */
+    uMqttQos_t qos;
+    bool retain;
+    size_t sizeBytes; /* Of the whole malloc() */
+    size_t messageSizeBytes;
+    char *pTopicNameStr;
+    char *pMessage;
+} uMqttClientStoreEntry_t;
+
+/** An entry in the cache of MQTT-SN topic IDs obtained by
+ * uMqttClientSnRegisterNormalTopic(); the topic name is stored
+ * in the same malloc() as this structure.
+ */
+typedef struct uMqttClientSnTopicCacheEntry_t {
+    struct uMqttClientSnTopicCacheEntry_t *pNext;
+    uint16_t id;
+    char *pTopicNameStr;
+} uMqttClientSnTopicCacheEntry_t;
+
+/** A topic filter to re-subscribe to on connection, see the
+ * resubscribe field of uMqttClientConnection_t; the topic filter
+ * is stored in the same malloc() as this structure.
+ */
+typedef struct uMqttClientSubscription_t {
+    struct uMqttClientSubscription_t *pNext;
+    uMqttQos_t maxQos;
+    char *pTopicFilterStr;
+} uMqttClientSubscription_t;
+
+/** A node in the trie of topic filters added with
+ * uMqttClientRouteAdd(): there is a node for each distinct
+ * topic level of each filter, a node having a handler if a
+ * filter ends there.
+ */
+typedef struct uMqttClientRouteNode_t {
+    struct uMqttClientRouteNode_t *pChild; /* First node of the next topic level down */
+    struct uMqttClientRouteNode_t *pNext;  /* Next node at this topic level */
+    void (*pHandler) (uMqttClientContext_t *, const char *, const char *,
+                      size_t, uMqttQos_t, void *);
+    void *pHandlerParam;
+    size_t levelLength;
+    char *pLevel; /* Not terminated, stored in the same malloc() as this structure */
+} uMqttClientRouteNode_t;
+
+/** A handler that matched a received message.
+ */
+typedef struct {
+    void (*pHandler) (uMqttClientContext_t *, const char *, const char *,
+                      size_t, uMqttQos_t, void *);
+    void *pHandlerParam;
+} uMqttClientRouteMatch_t;
+
+/** Where uMqttClientMetricsExportStart() publishes to.
+ */
+typedef struct {
+    uMqttClientContext_t *pContext;
+    const char *pTopicNameStr;
+    uMqttQos_t qos;
+} uMqttClientMetricsExport_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -79,10 +205,864 @@
  */
 static uErrorCode_t gLastOpenError = U_ERROR_COMMON_SUCCESS;
 
+/** Where the metrics are being exported to, if anywhere.
+ */
+static uMqttClientMetricsExport_t gMetricsExport = {0};
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Compress a payload for sending, prefixed with the compression
+// marker, returning a pointer to the malloc()ed result, which the
+// caller must free(), and updating *pSizeBytes, or NULL if the
+// payload should be sent as it is because compression would not
+// make it any smaller.
+static char *pCompress(const char *pMessage, size_t *pSizeBytes)
+{
+    char *pCompressed = NULL;
+    size_t outLengthBytes = *pSizeBytes;
+    bool mustCompress = false;
+    int32_t lengthOrError = -1;
+
+    if ((*pSizeBytes >= U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES) &&
+        (memcmp(pMessage, U_MQTT_CLIENT_COMPRESSION_MARKER,
+                U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES) == 0)) {
+        // A payload that happens to begin with the marker must be
+        // compressed, whatever the cost, or the far end would
+        // try to decompress it
+        mustCompress = true;
+        outLengthBytes = U_LZSS_COMPRESS_LENGTH_MAX(*pSizeBytes) +
+                         U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES;
+    }
+    if (outLengthBytes > U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES + 1) {
+        pCompressed = (char *) malloc(outLengthBytes);
+    }
+    if (pCompressed != NULL) {
+        memcpy(pCompressed, U_MQTT_CLIENT_COMPRESSION_MARKER,
+               U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES);
+        // Unless we must, leave out one byte so that compression
+        // is only used if the result, marker included, is smaller
+        lengthOrError = uLzssCompress(pMessage, *pSizeBytes,
+                                      pCompressed + U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES,
+                                      outLengthBytes - U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES -
+                                      (mustCompress ? 0 : 1));
+        if (lengthOrError >= 0) {
+            *pSizeBytes = lengthOrError + U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES;
+        } else {
+            free(pCompressed);
+            pCompressed = NULL;
+        }
+    }
+
+    return pCompressed;
+}
+
+// Decompress a received payload in place, if it begins with the
+// compression marker, updating *pSizeBytes.
+static int32_t decompressInPlace(char *pMessage, size_t *pSizeBytes,
+                                 size_t bufferSizeBytes)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+    size_t compressedSizeBytes;
+    char *pCompressed;
+
+    if ((*pSizeBytes >= U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES) &&
+        (memcmp(pMessage, U_MQTT_CLIENT_COMPRESSION_MARKER,
+                U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES) == 0)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        compressedSizeBytes = *pSizeBytes - U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES;
+        // Need a copy since the decompressed data overwrites it
+        pCompressed = (char *) malloc(compressedSizeBytes + 1);
+        if (pCompressed != NULL) {
+            memcpy(pCompressed, pMessage + U_MQTT_CLIENT_COMPRESSION_MARKER_LENGTH_BYTES,
+                   compressedSizeBytes);
+            errorCodeOrLength = uLzssDecompress(pCompressed, compressedSizeBytes,
+                                                pMessage, bufferSizeBytes);
+            if (errorCodeOrLength >= 0) {
+                *pSizeBytes = errorCodeOrLength;
+                errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+            free(pCompressed);
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// Export function for uMetricsExportStart(), called from the
+// metrics export task: publish the metrics if we're connected.
+static void metricsExport(const char *pJson, size_t length, void *pParam)
+{
+    uMqttClientMetricsExport_t *pExport = (uMqttClientMetricsExport_t *) pParam;
+
+    if (uMqttClientIsConnected(pExport->pContext)) {
+        uMqttClientPublish(pExport->pContext, pExport->pTopicNameStr,
+                           pJson, length, pExport->qos, false);
+    }
+}
+
+/** Insert pEntry in the store after any messages of the same or
+ * higher priority or, if atFront is true, before those of the
+ * same priority.
+ * The mutex for this session must be locked before this is called.
+ */
+static void storeInsert(uMqttClientContext_t *pContext,
+                        uMqttClientStoreEntry_t *pEntry, bool atFront)
+{
+    uMqttClientStoreEntry_t *pHead = (uMqttClientStoreEntry_t *) pContext->pStore;
+    uMqttClientStoreEntry_t **ppEntry = &pHead;
+
+    while ((*ppEntry != NULL) &&
+           (((*ppEntry)->priority > pEntry->priority) ||
+            (!atFront && ((*ppEntry)->priority == pEntry->priority)))) {
+        ppEntry = &((*ppEntry)->pNext);
+    }
+    pEntry->pNext = *ppEntry;
+    *ppEntry = pEntry;
+    pContext->pStore = pHead;
+    pContext->storeSizeBytes += pEntry->sizeBytes;
+}
+
+/** Discard any stored messages whose time-to-live has expired.
+ * The mutex for this session must be locked before this is called.
+ */
+static void storeRemoveExpired(uMqttClientContext_t *pContext)
+{
+    uMqttClientStoreEntry_t *pHead = (uMqttClientStoreEntry_t *) pContext->pStore;
+    uMqttClientStoreEntry_t **ppEntry = &pHead;
+    uMqttClientStoreEntry_t *pEntry;
+    int32_t nowMs = uPortGetTickTimeMs();
+
+    while (*ppEntry != NULL) {
+        pEntry = *ppEntry;
+        if ((pEntry->ttlMs >= 0) && (nowMs - pEntry->storedTimeMs > pEntry->ttlMs)) {
+            *ppEntry = pEntry->pNext;
+            pContext->storeSizeBytes -= pEntry->sizeBytes;
+            free(pEntry);
+        } else {
+            ppEntry = &(pEntry->pNext);
+        }
+    }
+    pContext->pStore = pHead;
+}
+
+/** Make room in the store for sizeBytes by discarding messages
+ * of lower priority than priority, newest first; returns true
+ * if there is then room.
+ * The mutex for this session must be locked before this is called.
+ */
+static bool storeMakeRoom(uMqttClientContext_t *pContext,
+                          size_t sizeBytes, int32_t priority)
+{
+    uMqttClientStoreEntry_t *pHead = (uMqttClientStoreEntry_t *) pContext->pStore;
+    uMqttClientStoreEntry_t **ppEntry;
+    bool keepGoing = true;
+
+    while (keepGoing &&
+           (pContext->storeSizeBytes + sizeBytes > pContext->storeMaxSizeBytes)) {
+        // The last entry is the newest of the lowest priority
+        ppEntry = &pHead;
+        while ((*ppEntry != NULL) && ((*ppEntry)->pNext != NULL)) {
+            ppEntry = &((*ppEntry)->pNext);
+        }
+        if ((*ppEntry != NULL) && ((*ppEntry)->priority < priority)) {
+            pContext->storeSizeBytes -= (*ppEntry)->sizeBytes;
+            free(*ppEntry);
+            *ppEntry = NULL;
+        } else {
+            keepGoing = false;
+        }
+    }
+    pContext->pStore = pHead;
+
+    return (pContext->storeSizeBytes + sizeBytes <= pContext->storeMaxSizeBytes);
+}
+
+/** Discard all stored messages.
+ * The mutex for this session must be locked before this is called.
+ */
+static void storeFree(uMqttClientContext_t *pContext)
+{
+    uMqttClientStoreEntry_t *pEntry = (uMqttClientStoreEntry_t *) pContext->pStore;
+    uMqttClientStoreEntry_t *pNext;
+
+    while (pEntry != NULL) {
+        pNext = pEntry->pNext;
+        free(pEntry);
+        pEntry = pNext;
+    }
+    pContext->pStore = NULL;
+    pContext->storeSizeBytes = 0;
+}
+
+/** Publish the stored messages, in order, for as long as we are
+ * connected and the publishes succeed; called from
+ * publishAsyncEventHandler().
+ */
+static void storeDrain(uMqttClientContext_t *pContext)
+{
+    uMqttClientStoreEntry_t *pEntry;
+    bool connected;
+    bool keepGoing = true;
+
+    // As in publishAsyncEventHandler(), don't lock the
+    // mutex when closing
+    while (keepGoing && !pContext->closing) {
+        pEntry = NULL;
+        connected = uMqttClientIsConnected(pContext);
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+        if (connected) {
+            storeRemoveExpired(pContext);
+            pEntry = (uMqttClientStoreEntry_t *) pContext->pStore;
+            if (pEntry != NULL) {
+                pContext->pStore = pEntry->pNext;
+                pContext->storeSizeBytes -= pEntry->sizeBytes;
+            }
+        }
+        if (pEntry == NULL) {
+            // Clear this with the mutex locked so that a
+            // message stored now will start a new drain
+            pContext->storeDrainPending = false;
+            keepGoing = false;
+        }
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+        if (pEntry != NULL) {
+            if (uMqttClientPublish(pContext, pEntry->pTopicNameStr,
+                                   pEntry->pMessage, pEntry->messageSizeBytes,
+                                   pEntry->qos, pEntry->retain) == 0) {
+                free(pEntry);
+                uPortTaskBlock(U_MQTT_CLIENT_STORE_DRAIN_INTERVAL_MS);
+            } else {
+                // Put it back where it was and give up until
+                // the next store or reconnection
+                U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+                storeInsert(pContext, pEntry, true);
+                pContext->storeDrainPending = false;
+                U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+                keepGoing = false;
+            }
+        }
+    }
+}
+
+/** Event handler for messages queued by uMqttClientPublishAsync():
+ * publish the message, if the client is not being closed, and
+ * tell the user.
+ */
+static void publishAsyncEventHandler(void *pParam, size_t paramLength)
+{
+    uMqttClientPublishAsync_t *pPublish = (uMqttClientPublishAsync_t *) pParam;
+    uMqttClientContext_t *pContext = pPublish->pContext;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    (void) paramLength;
+
+    if (pPublish->pBuffer == NULL) {
+        // Not a message, a request from storeDrainStart()
+        storeDrain(pContext);
+    } else {
+        // Neither publish nor lock the mutex when closing:
+        // uMqttClientClose() is waiting for this task to exit
+        if (!pContext->closing) {
+            errorCode = uMqttClientPublish(pContext, pPublish->pBuffer,
+                                           pPublish->pBuffer + strlen(pPublish->pBuffer) + 1,
+                                           pPublish->messageSizeBytes,
+                                           pPublish->qos, pPublish->retain);
+            U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+            pContext->publishAsyncNumOutstanding--;
+            U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+        }
+        free(pPublish->pBuffer);
+
+        if (pPublish->pCallback != NULL) {
+            pPublish->pCallback(pContext, pPublish->messageId, errorCode,
+                                pPublish->pCallbackParam);
+        }
+    }
+}
+
+/** Open the event queue used by uMqttClientPublishAsync() and
+ * storeDrainStart(), if it is not already open, returning its
+ * handle; the extra entry is for storeDrainStart().
+ * The mutex for this session must be locked before this is called.
+ */
+static int32_t publishAsyncQueueOpen(uMqttClientContext_t *pContext)
+{
+    int32_t errorCodeOrHandle = pContext->publishAsyncEventQueueHandle;
+
+    if (errorCodeOrHandle < 0) {
+        errorCodeOrHandle = uPortEventQueueOpen(publishAsyncEventHandler,
+                                                "mqttPublishAsync",
+                                                sizeof(uMqttClientPublishAsync_t),
+                                                U_MQTT_CLIENT_PUBLISH_ASYNC_TASK_STACK_SIZE_BYTES,
+                                                U_MQTT_CLIENT_PUBLISH_ASYNC_TASK_PRIORITY,
+                                                U_MQTT_CLIENT_PUBLISH_ASYNC_WINDOW + 1);
+        if (errorCodeOrHandle >= 0) {
+            pContext->publishAsyncEventQueueHandle = errorCodeOrHandle;
+        }
+    }
+
+    return errorCodeOrHandle;
+}
+
+/** Ask the publishAsyncEventHandler() to forward any stored
+ * messages, if it has not already been asked.
+ * The mutex for this session must be locked before this is called.
+ */
+static void storeDrainStart(uMqttClientContext_t *pContext)
+{
+    uMqttClientPublishAsync_t publish;
+
+    if ((pContext->pStore != NULL) && !pContext->storeDrainPending &&
+        (publishAsyncQueueOpen(pContext) >= 0)) {
+        memset(&publish, 0, sizeof(publish));
+        publish.pContext = pContext;
+        publish.pBuffer = NULL;
+        if (uPortEventQueueSend(pContext->publishAsyncEventQueueHandle,
+                                &publish, sizeof(publish)) == 0) {
+            pContext->storeDrainPending = true;
+        }
+    }
+}
+
+/** Return the length of the topic level at the start of pStr,
+ * i.e. up to the next '/' or the end of the string.
+ */
+static size_t topicLevelLength(const char *pStr)
+{
+    size_t length = 0;
+
+    while ((*(pStr + length) != '\0') && (*(pStr + length) != '/')) {
+        length++;
+    }
+
+    return length;
+}
+
+/** Return true if pTopicFilterStr is a valid topic filter:
+ * wildcards must occupy a whole topic level and '#' may only
+ * be the last level.
+ */
+static bool routeFilterIsValid(const char *pTopicFilterStr)
+{
+    bool isValid = (*pTopicFilterStr != '\0');
+    bool lastLevel = false;
+    size_t length;
+
+    while (isValid && !lastLevel) {
+        length = topicLevelLength(pTopicFilterStr);
+        lastLevel = (*(pTopicFilterStr + length) == '\0');
+        for (size_t x = 0; x < length; x++) {
+            if (((*(pTopicFilterStr + x) == '+') ||
+                 (*(pTopicFilterStr + x) == '#')) && (length != 1)) {
+                isValid = false;
+            }
+        }
+        if ((length == 1) && (*pTopicFilterStr == '#') && !lastLevel) {
+            isValid = false;
+        }
+        pTopicFilterStr += length + 1;
+    }
+
+    return isValid;
+}
+
+/** Find the node for the given topic level in a list of siblings.
+ */
+static uMqttClientRouteNode_t *pRouteNodeFind(uMqttClientRouteNode_t *pNode,
+                                              const char *pLevel,
+                                              size_t levelLength)
+{
+    while ((pNode != NULL) &&
+           ((pNode->levelLength != levelLength) ||
+            (memcmp(pNode->pLevel, pLevel, levelLength) != 0))) {
+        pNode = pNode->pNext;
+    }
+
+    return pNode;
+}
+
+/** Find the node at which the given topic filter ends, adding
+ * nodes to the trie at ppList as required if add is true.
+ */
+static uMqttClientRouteNode_t *pRouteNodeGet(uMqttClientRouteNode_t **ppList,
+                                             const char *pTopicFilterStr,
+                                             bool add)
+{
+    uMqttClientRouteNode_t *pNode = NULL;
+    bool keepGoing = true;
+    size_t length;
+
+    while (keepGoing) {
+        length = topicLevelLength(pTopicFilterStr);
+        pNode = pRouteNodeFind(*ppList, pTopicFilterStr, length);
+        if ((pNode == NULL) && add) {
+            pNode = (uMqttClientRouteNode_t *) malloc(sizeof(*pNode) + length);
+            if (pNode != NULL) {
+                pNode->pChild = NULL;
+                pNode->pHandler = NULL;
+                pNode->pHandlerParam = NULL;
+                pNode->levelLength = length;
+                pNode->pLevel = ((char *) pNode) + sizeof(*pNode);
+                memcpy(pNode->pLevel, pTopicFilterStr, length);
+                pNode->pNext = *ppList;
+                *ppList = pNode;
+            }
+        }
+        if ((pNode == NULL) || (*(pTopicFilterStr + length) == '\0')) {
+            keepGoing = false;
+        } else {
+            ppList = &(pNode->pChild);
+            pTopicFilterStr += length + 1;
+        }
+    }
+
+    return pNode;
+}
+
+/** Free any nodes in the trie at ppList that have neither a
+ * handler nor children.
+ */
+static void routePrune(uMqttClientRouteNode_t **ppList)
+{
+    uMqttClientRouteNode_t *pNode;
+
+    while (*ppList != NULL) {
+        pNode = *ppList;
+        routePrune(&(pNode->pChild));
+        if ((pNode->pHandler == NULL) && (pNode->pChild == NULL)) {
+            *ppList = pNode->pNext;
+            free(pNode);
+        } else {
+            ppList = &(pNode->pNext);
+        }
+    }
+}
+
+/** Free the entire trie at pList.
+ */
+static void routeFree(uMqttClientRouteNode_t *pList)
+{
+    uMqttClientRouteNode_t *pNext;
+
+    while (pList != NULL) {
+        pNext = pList->pNext;
+        routeFree(pList->pChild);
+        free(pList);
+        pList = pNext;
+    }
+}
+
+/** Add the handler of pNode, if it has one, to pMatches.
+ */
+static void routeMatchAdd(const uMqttClientRouteNode_t *pNode,
+                          uMqttClientRouteMatch_t *pMatches,
+                          size_t *pNumMatches)
+{
+    if ((pNode->pHandler != NULL) &&
+        (*pNumMatches < U_MQTT_CLIENT_ROUTE_MAX_MATCHES)) {
+        (pMatches + *pNumMatches)->pHandler = pNode->pHandler;
+        (pMatches + *pNumMatches)->pHandlerParam = pNode->pHandlerParam;
+        (*pNumMatches)++;
+    }
+}
+
+/** Find the handlers of all of the topic filters in the trie at
+ * pNode which match pTopicNameStr.
+ */
+static void routeMatch(uMqttClientRouteNode_t *pNode,
+                       const char *pTopicNameStr, bool isFirstLevel,
+                       uMqttClientRouteMatch_t *pMatches,
+                       size_t *pNumMatches)
+{
+    size_t length = topicLevelLength(pTopicNameStr);
+    bool lastLevel = (*(pTopicNameStr + length) == '\0');
+    bool isWildcard;
+    uMqttClientRouteNode_t *pMultiLevel;
+
+    for (; pNode != NULL; pNode = pNode->pNext) {
+        isWildcard = (pNode->levelLength == 1) &&
+                     ((*pNode->pLevel == '+') || (*pNode->pLevel == '#'));
+        // Wildcards at the first level don't match topics
+        // beginning with '$'
+        if (!isWildcard || !isFirstLevel || (*pTopicNameStr != '$')) {
+            if (isWildcard && (*pNode->pLevel == '#')) {
+                routeMatchAdd(pNode, pMatches, pNumMatches);
+            } else if (isWildcard ||
+                       ((pNode->levelLength == length) &&
+                        (memcmp(pNode->pLevel, pTopicNameStr, length) == 0))) {
+                if (lastLevel) {
+                    routeMatchAdd(pNode, pMatches, pNumMatches);
+                    // "a/#" also matches "a"
+                    pMultiLevel = pRouteNodeFind(pNode->pChild, "#", 1);
+                    if (pMultiLevel != NULL) {
+                        routeMatchAdd(pMultiLevel, pMatches, pNumMatches);
+                    }
+                } else {
+                    routeMatch(pNode->pChild, pTopicNameStr + length + 1,
+                               false, pMatches, pNumMatches);
+                }
+            }
+        }
+    }
+}
+
+/** Event handler for routing: read all unread messages and
+ * pass each one to the handlers of the topic filters it matches.
+ */
+static void routeEventHandler(void *pParam, size_t paramLength)
+{
+    uMqttClientContext_t *pContext = *((uMqttClientContext_t **) pParam);
+    uMqttClientRouteMatch_t matches[U_MQTT_CLIENT_ROUTE_MAX_MATCHES];
+    size_t numMatches;
+    char *pTopicNameStr;
+    char *pMessage;
+    size_t messageSizeBytes;
+    uMqttQos_t qos;
+    bool keepGoing = true;
+
+    (void) paramLength;
+
+    pTopicNameStr = (char *) malloc(U_MQTT_CLIENT_ROUTE_TOPIC_MAX_LENGTH_BYTES +
+                                    U_MQTT_CLIENT_ROUTE_MESSAGE_MAX_LENGTH_BYTES);
+    if (pTopicNameStr != NULL) {
+        pMessage = pTopicNameStr + U_MQTT_CLIENT_ROUTE_TOPIC_MAX_LENGTH_BYTES;
+        // As for publishAsyncEventHandler(), do nothing when closing
+        while (keepGoing && !pContext->closing &&
+               (uMqttClientGetUnread(pContext) > 0)) {
+            messageSizeBytes = U_MQTT_CLIENT_ROUTE_MESSAGE_MAX_LENGTH_BYTES;
+            qos = U_MQTT_QOS_AT_MOST_ONCE;
+            keepGoing = (uMqttClientMessageRead(pContext, pTopicNameStr,
+                                                U_MQTT_CLIENT_ROUTE_TOPIC_MAX_LENGTH_BYTES,
+                                                pMessage, &messageSizeBytes,
+                                                &qos) == 0);
+            if (keepGoing) {
+                // Collect the handlers with the mutex locked and call
+                // them with it unlocked, so that they may call us
+                numMatches = 0;
+                U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+                routeMatch((uMqttClientRouteNode_t *) pContext->pRouteRoot,
+                           pTopicNameStr, true, matches, &numMatches);
+                U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+                for (size_t x = 0; x < numMatches; x++) {
+                    matches[x].pHandler(pContext, pTopicNameStr, pMessage,
+                                        messageSizeBytes, qos,
+                                        matches[x].pHandlerParam);
+                }
+            }
+        }
+        free(pTopicNameStr);
+    }
+}
+
+/** Message indication callback used while there are routes:
+ * wake up routeEventHandler().
+ */
+static void routeMessageIndicationCallback(int32_t numUnread, void *pParam)
+{
+    uMqttClientContext_t *pContext = (uMqttClientContext_t *) pParam;
+
+    (void) numUnread;
+
+    if (pContext->routeEventQueueHandle >= 0) {
+        uPortEventQueueSend(pContext->routeEventQueueHandle,
+                            &pContext, sizeof(pContext));
+    }
+}
+
+/** Set the message indication callback of the underlying layer:
+ * the user's callback if there are no routes, else ours.
+ * The mutex for this session must be locked before this is called.
+ */
+static int32_t messageCallbackUpdate(uMqttClientContext_t *pContext)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+    void (*pCallback) (int32_t, void *) = pContext->pMessageCallback;
+    void *pCallbackParam = pContext->pMessageCallbackParam;
+
+    if (pContext->pRouteRoot != NULL) {
+        pCallback = routeMessageIndicationCallback;
+        pCallbackParam = pContext;
+    }
+    if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+        errorCode = uCellMqttSetMessageCallback(pContext->devHandle,
+                                                pCallback,
+                                                pCallbackParam);
+    } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
+        errorCode = uWifiMqttSetMessageCallback(pContext,
+                                                pCallback,
+                                                pCallbackParam);
+    }
+
+    return errorCode;
+}
+
+/** Find the entry for a topic name in the MQTT-SN topic ID cache.
+ * The mutex for this session must be locked before this is called.
+ */
+static uMqttClientSnTopicCacheEntry_t *pSnTopicCacheFind(const uMqttClientContext_t *pContext,
+                                                         const char *pTopicNameStr)
+{
+    uMqttClientSnTopicCacheEntry_t *pEntry = (uMqttClientSnTopicCacheEntry_t *) pContext->pSnTopicCache;
+
+    while ((pEntry != NULL) && (strcmp(pEntry->pTopicNameStr, pTopicNameStr) != 0)) {
+        pEntry = pEntry->pNext;
+    }
+
+    return pEntry;
+}
+
+/** Add a topic name and ID to the MQTT-SN topic ID cache; if
+ * there is no memory the topic simply isn't cached.
+ * The mutex for this session must be locked before this is called.
+ */
+static void snTopicCacheAdd(uMqttClientContext_t *pContext,
+                            const char *pTopicNameStr, uint16_t id)
+{
+    uMqttClientSnTopicCacheEntry_t *pEntry;
+    size_t length = strlen(pTopicNameStr) + 1;
+
+    pEntry = (uMqttClientSnTopicCacheEntry_t *) malloc(sizeof(*pEntry) + length);
+    if (pEntry != NULL) {
+        pEntry->id = id;
+        pEntry->pTopicNameStr = ((char *) pEntry) + sizeof(*pEntry);
+        memcpy(pEntry->pTopicNameStr, pTopicNameStr, length);
+        pEntry->pNext = (uMqttClientSnTopicCacheEntry_t *) pContext->pSnTopicCache;
+        pContext->pSnTopicCache = pEntry;
+    }
+}
+
+/** Remove the entries for the given topic ID from the MQTT-SN
+ * topic ID cache.
+ * The mutex for this session must be locked before this is called.
+ */
+static void snTopicCacheRemoveId(uMqttClientContext_t *pContext, uint16_t id)
+{
+    uMqttClientSnTopicCacheEntry_t *pHead = (uMqttClientSnTopicCacheEntry_t *) pContext->pSnTopicCache;
+    uMqttClientSnTopicCacheEntry_t **ppEntry = &pHead;
+    uMqttClientSnTopicCacheEntry_t *pEntry;
+
+    while (*ppEntry != NULL) {
+        pEntry = *ppEntry;
+        if (pEntry->id == id) {
+            *ppEntry = pEntry->pNext;
+            free(pEntry);
+        } else {
+            ppEntry = &(pEntry->pNext);
+        }
+    }
+    pContext->pSnTopicCache = pHead;
+}
+
+/** Empty the MQTT-SN topic ID cache.
+ * The mutex for this session must be locked before this is called.
+ */
+static void snTopicCacheFree(uMqttClientContext_t *pContext)
+{
+    uMqttClientSnTopicCacheEntry_t *pEntry = (uMqttClientSnTopicCacheEntry_t *) pContext->pSnTopicCache;
+    uMqttClientSnTopicCacheEntry_t *pNext;
+
+    while (pEntry != NULL) {
+        pNext = pEntry->pNext;
+        free(pEntry);
+        pEntry = pNext;
+    }
+    pContext->pSnTopicCache = NULL;
+}
+
+/** Remember a topic filter to re-subscribe to, or update the
+ * maximum QoS if it is already remembered; if there is no memory
+ * the topic filter simply isn't remembered.
+ * The mutex for this session must be locked before this is called.
+ */
+static void subscriptionAdd(uMqttClientContext_t *pContext,
+                            const char *pTopicFilterStr, uMqttQos_t maxQos)
+{
+    uMqttClientSubscription_t **ppEntry = (uMqttClientSubscription_t **) &(pContext->pSubscriptions);
+    size_t length;
+
+    // Find the entry or, if there isn't one, the end of the
+    // list, so that re-subscription is in the original order
+    while ((*ppEntry != NULL) && (strcmp((*ppEntry)->pTopicFilterStr, pTopicFilterStr) != 0)) {
+        ppEntry = &((*ppEntry)->pNext);
+    }
+    if (*ppEntry != NULL) {
+        (*ppEntry)->maxQos = maxQos;
+    } else {
+        length = strlen(pTopicFilterStr) + 1;
+        *ppEntry = (uMqttClientSubscription_t *) malloc(sizeof(**ppEntry) + length);
+        if (*ppEntry != NULL) {
+            (*ppEntry)->pNext = NULL;
+            (*ppEntry)->maxQos = maxQos;
+            (*ppEntry)->pTopicFilterStr = ((char *) *ppEntry) + sizeof(**ppEntry);
+            memcpy((*ppEntry)->pTopicFilterStr, pTopicFilterStr, length);
+        }
+    }
+}
+
+/** Forget a topic filter that was to be re-subscribed to.
+ * The mutex for this session must be locked before this is called.
+ */
+static void subscriptionRemove(uMqttClientContext_t *pContext,
+                               const char *pTopicFilterStr)
+{
+    uMqttClientSubscription_t **ppEntry = (uMqttClientSubscription_t **) &(pContext->pSubscriptions);
+    uMqttClientSubscription_t *pEntry;
+
+    while (*ppEntry != NULL) {
+        pEntry = *ppEntry;
+        if (strcmp(pEntry->pTopicFilterStr, pTopicFilterStr) == 0) {
+            *ppEntry = pEntry->pNext;
+            free(pEntry);
+        } else {
+            ppEntry = &(pEntry->pNext);
+        }
+    }
+}
+
+/** Forget all of the topic filters that were to be re-subscribed to.
+ * The mutex for this session must be locked before this is called.
+ */
+static void subscriptionsFree(uMqttClientContext_t *pContext)
+{
+    uMqttClientSubscription_t *pEntry = (uMqttClientSubscription_t *) pContext->pSubscriptions;
+    uMqttClientSubscription_t *pNext;
+
+    while (pEntry != NULL) {
+        pNext = pEntry->pNext;
+        free(pEntry);
+        pEntry = pNext;
+    }
+    pContext->pSubscriptions = NULL;
+}
+
+/** Subscribe to (pMaxQos non-NULL) or unsubscribe from (pMaxQos
+ * NULL) several topics, keeping the list of topic filters to
+ * re-subscribe to up to date; pResults must point to numTopics
+ * entries.
+ * The mutex for this session must be locked before this is called.
+ */
+static int32_t subscribeMulti(uMqttClientContext_t *pContext,
+                              const char *const *ppTopicFilterStr,
+                              const uMqttQos_t *pMaxQos,
+                              size_t numTopics, int32_t *pResults)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+    uCellMqttQos_t *pCellMaxQos;
+
+    for (size_t x = 0; x < numTopics; x++) {
+        pResults[x] = errorCode;
+    }
+    if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+        if (pMaxQos != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pCellMaxQos = (uCellMqttQos_t *) malloc(numTopics * sizeof(*pCellMaxQos));
+            if (pCellMaxQos != NULL) {
+                for (size_t x = 0; x < numTopics; x++) {
+                    pCellMaxQos[x] = (uCellMqttQos_t) pMaxQos[x];
+                }
+                errorCode = uCellMqttSubscribeMulti(pContext->devHandle,
+                                                    ppTopicFilterStr,
+                                                    pCellMaxQos, numTopics,
+                                                    pResults);
+                free(pCellMaxQos);
+            }
+        } else {
+            errorCode = uCellMqttUnsubscribeMulti(pContext->devHandle,
+                                                  ppTopicFilterStr,
+                                                  numTopics, pResults);
+        }
+    } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
+        // No pipelining here, just one after the other
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; x < numTopics; x++) {
+            if (pMaxQos != NULL) {
+                pResults[x] = uWifiMqttSubscribe(pContext, ppTopicFilterStr[x],
+                                                 pMaxQos[x]);
+            } else {
+                pResults[x] = uWifiMqttUnsubscribe(pContext, ppTopicFilterStr[x]);
+            }
+            if ((pResults[x] < 0) && (errorCode == 0)) {
+                errorCode = pResults[x];
+            }
+        }
+    }
+    // Some may have succeeded even if others failed
+    for (size_t x = 0; x < numTopics; x++) {
+        if (pResults[x] >= 0) {
+            if (pMaxQos == NULL) {
+                subscriptionRemove(pContext, ppTopicFilterStr[x]);
+            } else if (pContext->resubscribe) {
+                subscriptionAdd(pContext, ppTopicFilterStr[x], pMaxQos[x]);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+/** Re-subscribe to all of the topic filters that were subscribed
+ * to before.
+ * The mutex for this session must be locked before this is called.
+ */
+static void resubscribe(uMqttClientContext_t *pContext)
+{
+    uMqttClientSubscription_t *pEntry = (uMqttClientSubscription_t *) pContext->pSubscriptions;
+    size_t numTopics = 0;
+    const char **ppTopicFilterStr;
+    uMqttQos_t *pMaxQos;
+    int32_t *pResults;
+
+    while (pEntry != NULL) {
+        numTopics++;
+        pEntry = pEntry->pNext;
+    }
+    if (numTopics > 0) {
+        ppTopicFilterStr = (const char **) malloc(numTopics * sizeof(*ppTopicFilterStr));
+        pMaxQos = (uMqttQos_t *) malloc(numTopics * sizeof(*pMaxQos));
+        pResults = (int32_t *) malloc(numTopics * sizeof(*pResults));
+        if ((ppTopicFilterStr != NULL) && (pMaxQos != NULL) && (pResults != NULL)) {
+            pEntry = (uMqttClientSubscription_t *) pContext->pSubscriptions;
+            for (size_t x = 0; x < numTopics; x++) {
+                ppTopicFilterStr[x] = pEntry->pTopicFilterStr;
+                pMaxQos[x] = pEntry->maxQos;
+                pEntry = pEntry->pNext;
+            }
+            subscribeMulti(pContext, ppTopicFilterStr, pMaxQos, numTopics, pResults);
+        }
+        free(pResults);
+        free(pMaxQos);
+        free(ppTopicFilterStr);
+    }
+}
+
+/** Called on an MQTT-SN connect: keep the topic ID cache only if
+ * the session is not clean and it is the same gateway as before.
+ * The mutex for this session must be locked before this is called.
+ */
+static void snTopicCacheConnect(uMqttClientContext_t *pContext,
+                                const uMqttClientConnection_t *pConnection)
+{
+    size_t length;
+
+    if (!pConnection->retain || (pConnection->pBrokerNameStr == NULL) ||
+        (pContext->pSnTopicCacheBrokerNameStr == NULL) ||
+        (strcmp(pContext->pSnTopicCacheBrokerNameStr, pConnection->pBrokerNameStr) != 0)) {
+        snTopicCacheFree(pContext);
+        free(pContext->pSnTopicCacheBrokerNameStr);
+        pContext->pSnTopicCacheBrokerNameStr = NULL;
+        if (pConnection->pBrokerNameStr != NULL) {
+            length = strlen(pConnection->pBrokerNameStr) + 1;
+            pContext->pSnTopicCacheBrokerNameStr = (char *) malloc(length);
+            if (pContext->pSnTopicCacheBrokerNameStr != NULL) {
+                memcpy(pContext->pSnTopicCacheBrokerNameStr,
+                       pConnection->pBrokerNameStr, length);
+            }
+        }
+    }
+}
+
 /** Start an MQTT connection using cellular.
  * The mutex for this session must be locked before this is called.
  */
@@ -190,6 +1170,24 @@ uMqttClientContext_t *pUMqttClientOpen(uDeviceHandle_t devHandle,
             pContext->pSecurityContext = NULL;
             pContext->totalMessagesSent = 0;
             pContext->totalMessagesReceived = 0;
+            pContext->publishAsyncEventQueueHandle = -1;
+            pContext->publishAsyncNumOutstanding = 0;
+            pContext->publishAsyncNextMessageId = 0;
+            pContext->closing = false;
+            pContext->pMessageCallback = NULL;
+            pContext->pMessageCallbackParam = NULL;
+            pContext->pRouteRoot = NULL;
+            pContext->routeEventQueueHandle = -1;
+            pContext->pStore = NULL;
+            pContext->storeSizeBytes = 0;
+            pContext->storeMaxSizeBytes = 0;
+            pContext->storeDrainPending = false;
+            pContext->pSnTopicCache = NULL;
+            pContext->pSnTopicCacheBrokerNameStr = NULL;
+            pContext->compress = false;
+            memset(&(pContext->compressionStats), 0, sizeof(pContext->compressionStats));
+            pContext->resubscribe = false;
+            pContext->pSubscriptions = NULL;
             pContext->pPriv = pPriv;
             if (uPortMutexCreate((uPortMutexHandle_t *) & (pContext->mutexHandle)) == 0) {
                 gLastOpenError = U_ERROR_COMMON_SUCCESS;
@@ -241,6 +1239,23 @@ void uMqttClientClose(uMqttClientContext_t *pContext)
 {
     if (pContext != NULL) {
 
+        // Anything still queued by uMqttClientPublishAsync()
+        // is not published, only its callback is called, and no
+        // more messages are routed; this must be done without the
+        // mutex locked as the event handlers may be waiting on it
+        pContext->closing = true;
+        if (gMetricsExport.pContext == pContext) {
+            uMqttClientMetricsExportStop();
+        }
+        if (pContext->publishAsyncEventQueueHandle >= 0) {
+            uPortEventQueueClose(pContext->publishAsyncEventQueueHandle);
+            pContext->publishAsyncEventQueueHandle = -1;
+        }
+        if (pContext->routeEventQueueHandle >= 0) {
+            uPortEventQueueClose(pContext->routeEventQueueHandle);
+            pContext->routeEventQueueHandle = -1;
+        }
+
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
 
         if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
@@ -254,6 +1269,12 @@ void uMqttClientClose(uMqttClientContext_t *pContext)
             uSecurityTlsRemove(pContext->pSecurityContext);
         }
 
+        routeFree((uMqttClientRouteNode_t *) pContext->pRouteRoot);
+        storeFree(pContext);
+        snTopicCacheFree(pContext);
+        free(pContext->pSnTopicCacheBrokerNameStr);
+        subscriptionsFree(pContext);
+
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
 
         uPortMutexDelete((uPortMutexHandle_t) (pContext->mutexHandle));
@@ -286,6 +1307,18 @@ int32_t uMqttClientConnect(uMqttClientContext_t *pContext,
 
             errorCode = uWifiMqttConnect(pContext, pConnection);
         }
+        if (errorCode == 0) {
+            pContext->compress = pConnection->compress && !pConnection->mqttSn;
+            pContext->resubscribe = pConnection->resubscribe && !pConnection->mqttSn;
+            if (pContext->resubscribe) {
+                // Get the subscriptions back before anything else
+                resubscribe(pContext);
+            } else {
+                subscriptionsFree(pContext);
+            }
+            // Forward anything stored while we were disconnected
+            storeDrainStart(pContext);
+        }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
     }
@@ -337,26 +1370,21 @@ bool uMqttClientIsConnected(const uMqttClientContext_t *pContext)
 }
 
 // Set a callback to be called on new message arrival.
-int32_t uMqttClientSetMessageCallback(const uMqttClientContext_t *pContext,
+int32_t uMqttClientSetMessageCallback(uMqttClientContext_t *pContext,
                                       void (*pCallback) (int32_t, void *),
                                       void *pCallbackParam)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
 
     if (pContext != NULL) {
-        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
 
-        if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
-            errorCode = uCellMqttSetMessageCallback(pContext->devHandle,
-                                                    pCallback,
-                                                    pCallbackParam);
-        } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
-            errorCode = uWifiMqttSetMessageCallback(pContext,
-                                                    pCallback,
-                                                    pCallbackParam);
-        }
+        // Remember the callback so that it can be restored
+        // when the last route is removed
+        pContext->pMessageCallback = pCallback;
+        pContext->pMessageCallbackParam = pCallbackParam;
+        errorCode = messageCallbackUpdate(pContext);
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
     }
@@ -430,6 +1458,25 @@ int32_t uMqttClientGetTotalMessagesReceived(const uMqttClientContext_t *pContext
     return errorCodeOrReceivedMessages;
 }
 
+// Get the payload compression statistics.
+int32_t uMqttClientGetCompressionStats(const uMqttClientContext_t *pContext,
+                                       uMqttClientCompressionStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && (pStats != NULL)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        *pStats = pContext->compressionStats;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCode;
+}
+
 // Set a callback for when the MQTT connection is dropped.
 int32_t uMqttClientSetDisconnectCallback(const uMqttClientContext_t *pContext,
                                          void (*pCallback) (int32_t, void *),
@@ -470,6 +1517,8 @@ int32_t uMqttClientPublish(uMqttClientContext_t *pContext,
                            uMqttQos_t qos, bool retain)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    char *pCompressed = NULL;
+    size_t uncompressedSizeBytes = messageSizeBytes;
 
     if ((pContext != NULL) && (pTopicNameStr != NULL) &&
         (pMessage != NULL) && (messageSizeBytes > 0)) {
@@ -477,6 +1526,12 @@ int32_t uMqttClientPublish(uMqttClientContext_t *pContext,
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
 
+        if (pContext->compress) {
+            pCompressed = pCompress(pMessage, &messageSizeBytes);
+            if (pCompressed != NULL) {
+                pMessage = pCompressed;
+            }
+        }
         if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
             errorCode = uCellMqttPublish(pContext->devHandle,
                                          pTopicNameStr,
@@ -490,14 +1545,93 @@ int32_t uMqttClientPublish(uMqttClientContext_t *pContext,
         }
         if (errorCode == 0) {
             pContext->totalMessagesSent++;
+            pContext->compressionStats.txBytesUncompressed += uncompressedSizeBytes;
+            pContext->compressionStats.txBytesCompressed += messageSizeBytes;
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        free(pCompressed);
     }
 
     return errorCode;
 }
 
+// Publish an MQTT message without waiting for the result.
+int32_t uMqttClientPublishAsync(uMqttClientContext_t *pContext,
+                                const char *pTopicNameStr,
+                                const char *pMessage,
+                                size_t messageSizeBytes,
+                                uMqttQos_t qos, bool retain,
+                                void (*pCallback) (uMqttClientContext_t *,
+                                                   int32_t,
+                                                   int32_t,
+                                                   void *),
+                                void *pCallbackParam)
+{
+    int32_t errorCodeOrMessageId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientPublishAsync_t publish;
+    size_t topicLength;
+
+    if ((pContext != NULL) && (pTopicNameStr != NULL) &&
+        (pMessage != NULL) && (messageSizeBytes > 0)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        errorCodeOrMessageId = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+        if (pContext->publishAsyncNumOutstanding < U_MQTT_CLIENT_PUBLISH_ASYNC_WINDOW) {
+            // First time this will open the event queue to do the publishing
+            errorCodeOrMessageId = publishAsyncQueueOpen(pContext);
+            if (errorCodeOrMessageId >= 0) {
+                errorCodeOrMessageId = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                topicLength = strlen(pTopicNameStr) + 1;
+                publish.pBuffer = (char *) malloc(topicLength + messageSizeBytes);
+                if (publish.pBuffer != NULL) {
+                    memcpy(publish.pBuffer, pTopicNameStr, topicLength);
+                    memcpy(publish.pBuffer + topicLength, pMessage, messageSizeBytes);
+                    publish.pContext = pContext;
+                    publish.messageSizeBytes = messageSizeBytes;
+                    publish.qos = qos;
+                    publish.retain = retain;
+                    publish.messageId = pContext->publishAsyncNextMessageId;
+                    publish.pCallback = pCallback;
+                    publish.pCallbackParam = pCallbackParam;
+                    errorCodeOrMessageId = uPortEventQueueSend(pContext->publishAsyncEventQueueHandle,
+                                                               &publish, sizeof(publish));
+                    if (errorCodeOrMessageId == 0) {
+                        errorCodeOrMessageId = publish.messageId;
+                        pContext->publishAsyncNumOutstanding++;
+                        pContext->publishAsyncNextMessageId++;
+                        if (pContext->publishAsyncNextMessageId < 0) {
+                            pContext->publishAsyncNextMessageId = 0;
+                        }
+                    } else {
+                        free(publish.pBuffer);
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCodeOrMessageId;
+}
+
+// Get the number of messages queued by uMqttClientPublishAsync().
+int32_t uMqttClientGetPublishAsyncOutstanding(uMqttClientContext_t *pContext)
+{
+    int32_t errorCodeOrOutstanding = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pContext != NULL) {
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+        errorCodeOrOutstanding = pContext->publishAsyncNumOutstanding;
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCodeOrOutstanding;
+}
+
 // Subscribe to an MQTT topic.
 int32_t uMqttClientSubscribe(const uMqttClientContext_t *pContext,
                              const char *pTopicFilterStr,
@@ -519,6 +1653,9 @@ int32_t uMqttClientSubscribe(const uMqttClientContext_t *pContext,
                                            pTopicFilterStr,
                                            (uMqttQos_t)maxQos);
         }
+        if ((errorCode >= 0) && pContext->resubscribe) {
+            subscriptionAdd((uMqttClientContext_t *) pContext, pTopicFilterStr, maxQos);
+        }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
     }
@@ -543,6 +1680,9 @@ int32_t uMqttClientUnsubscribe(const uMqttClientContext_t *pContext,
         } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
             errorCode = uWifiMqttUnsubscribe(pContext, pTopicFilterStr);
         }
+        if (errorCode == 0) {
+            subscriptionRemove((uMqttClientContext_t *) pContext, pTopicFilterStr);
+        }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
     }
@@ -550,6 +1690,71 @@ int32_t uMqttClientUnsubscribe(const uMqttClientContext_t *pContext,
     return errorCode;
 }
 
+// Subscribe to several MQTT topics.
+int32_t uMqttClientSubscribeMulti(uMqttClientContext_t *pContext,
+                                  const char *const *ppTopicFilterStr,
+                                  const uMqttQos_t *pMaxQos,
+                                  size_t numTopics, int32_t *pQos)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t *pResults = pQos;
+
+    if ((pContext != NULL) && (ppTopicFilterStr != NULL) && (pMaxQos != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (numTopics > 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            if (pResults == NULL) {
+                pResults = (int32_t *) malloc(numTopics * sizeof(*pResults));
+            }
+            if (pResults != NULL) {
+
+                U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+                errorCode = subscribeMulti(pContext, ppTopicFilterStr, pMaxQos,
+                                           numTopics, pResults);
+
+                U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+                if (pQos == NULL) {
+                    free(pResults);
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Unsubscribe from several MQTT topics.
+int32_t uMqttClientUnsubscribeMulti(uMqttClientContext_t *pContext,
+                                    const char *const *ppTopicFilterStr,
+                                    size_t numTopics)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t *pResults;
+
+    if ((pContext != NULL) && (ppTopicFilterStr != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (numTopics > 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pResults = (int32_t *) malloc(numTopics * sizeof(*pResults));
+            if (pResults != NULL) {
+
+                U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+                errorCode = subscribeMulti(pContext, ppTopicFilterStr, NULL,
+                                           numTopics, pResults);
+
+                U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+                free(pResults);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 // Read an MQTT message.
 int32_t uMqttClientMessageRead(uMqttClientContext_t *pContext,
                                char *pTopicNameStr,
@@ -559,6 +1764,7 @@ int32_t uMqttClientMessageRead(uMqttClientContext_t *pContext,
                                uMqttQos_t *pQos)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t bufferSizeBytes = 0;
 
     if ((pContext != NULL) && (pTopicNameStr != NULL) &&
         (topicNameSizeBytes > 0) &&
@@ -567,6 +1773,10 @@ int32_t uMqttClientMessageRead(uMqttClientContext_t *pContext,
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
 
+        if (pMessageSizeBytes != NULL) {
+            bufferSizeBytes = *pMessageSizeBytes;
+        }
+
         if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
             errorCode = uCellMqttMessageRead(pContext->devHandle,
                                              pTopicNameStr,
@@ -582,16 +1792,303 @@ int32_t uMqttClientMessageRead(uMqttClientContext_t *pContext,
                                              pMessageSizeBytes,
                                              (uMqttQos_t *) pQos);
         }
+        if ((errorCode == 0) && (pMessage != NULL)) {
+            pContext->compressionStats.rxBytesCompressed += *pMessageSizeBytes;
+            if (pContext->compress) {
+                errorCode = decompressInPlace(pMessage, pMessageSizeBytes,
+                                              bufferSizeBytes);
+            }
+            pContext->compressionStats.rxBytesUncompressed += *pMessageSizeBytes;
+        }
+        if (errorCode == 0) {
+            pContext->totalMessagesReceived++;
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCode;
+}
+
+// Set the amount of RAM used for store-and-forward.
+int32_t uMqttClientStoreSetSize(uMqttClientContext_t *pContext,
+                                size_t maxSizeBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pContext != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        pContext->storeMaxSizeBytes = maxSizeBytes;
+        if (maxSizeBytes == 0) {
+            storeFree(pContext);
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCode;
+}
+
+// Publish an MQTT message, store-and-forward.
+int32_t uMqttClientStorePublish(uMqttClientContext_t *pContext,
+                                const char *pTopicNameStr,
+                                const char *pMessage,
+                                size_t messageSizeBytes,
+                                uMqttQos_t qos, bool retain,
+                                int32_t priority,
+                                int32_t ttlSeconds)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientStoreEntry_t *pEntry;
+    size_t topicLength;
+    size_t sizeBytes;
+
+    if ((pContext != NULL) && (pTopicNameStr != NULL) &&
+        (pMessage != NULL) && (messageSizeBytes > 0) &&
+        (ttlSeconds <= INT32_MAX / 1000)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+        if (pContext->storeMaxSizeBytes > 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            topicLength = strlen(pTopicNameStr) + 1;
+            sizeBytes = sizeof(*pEntry) + topicLength + messageSizeBytes;
+            storeRemoveExpired(pContext);
+            if (storeMakeRoom(pContext, sizeBytes, priority)) {
+                pEntry = (uMqttClientStoreEntry_t *) malloc(sizeBytes);
+                if (pEntry != NULL) {
+                    pEntry->priority = priority;
+                    pEntry->storedTimeMs = uPortGetTickTimeMs();
+                    pEntry->ttlMs = -1;
+                    if (ttlSeconds >= 0) {
+                        pEntry->ttlMs = ttlSeconds * 1000;
+                    }
+                    pEntry->qos = qos;
+                    pEntry->retain = retain;
+                    pEntry->sizeBytes = sizeBytes;
+                    pEntry->messageSizeBytes = messageSizeBytes;
+                    pEntry->pTopicNameStr = ((char *) pEntry) + sizeof(*pEntry);
+                    memcpy(pEntry->pTopicNameStr, pTopicNameStr, topicLength);
+                    pEntry->pMessage = pEntry->pTopicNameStr + topicLength;
+                    memcpy(pEntry->pMessage, pMessage, messageSizeBytes);
+                    storeInsert(pContext, pEntry, false);
+                    // Send it now if we can
+                    storeDrainStart(pContext);
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCode;
+}
+
+// Get the number of messages held for store-and-forward.
+int32_t uMqttClientStoreGetNum(uMqttClientContext_t *pContext)
+{
+    int32_t errorCodeOrNum = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uMqttClientStoreEntry_t *pEntry;
+
+    if (pContext != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        errorCodeOrNum = 0;
+        for (pEntry = (const uMqttClientStoreEntry_t *) pContext->pStore;
+             pEntry != NULL; pEntry = pEntry->pNext) {
+            errorCodeOrNum++;
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCodeOrNum;
+}
+
+// Add a handler for the messages that match a topic filter.
+int32_t uMqttClientRouteAdd(uMqttClientContext_t *pContext,
+                            const char *pTopicFilterStr,
+                            void (*pHandler) (uMqttClientContext_t *,
+                                              const char *,
+                                              const char *,
+                                              size_t,
+                                              uMqttQos_t,
+                                              void *),
+                            void *pHandlerParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientRouteNode_t *pRouteRoot;
+    uMqttClientRouteNode_t *pNode;
+
+    if ((pContext != NULL) && (pTopicFilterStr != NULL) &&
+        (pHandler != NULL) && routeFilterIsValid(pTopicFilterStr)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pContext->routeEventQueueHandle < 0) {
+            // First time: open the event queue to do the reading
+            errorCode = uPortEventQueueOpen(routeEventHandler,
+                                            "mqttRoute",
+                                            sizeof(uMqttClientContext_t *),
+                                            U_MQTT_CLIENT_ROUTE_TASK_STACK_SIZE_BYTES,
+                                            U_MQTT_CLIENT_ROUTE_TASK_PRIORITY,
+                                            U_MQTT_CLIENT_ROUTE_EVENT_QUEUE_LENGTH);
+            if (errorCode >= 0) {
+                pContext->routeEventQueueHandle = errorCode;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
         if (errorCode == 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pRouteRoot = (uMqttClientRouteNode_t *) pContext->pRouteRoot;
+            pNode = pRouteNodeGet(&pRouteRoot, pTopicFilterStr, true);
+            pContext->pRouteRoot = pRouteRoot;
+            if (pNode != NULL) {
+                errorCode = messageCallbackUpdate(pContext);
+                if (errorCode == 0) {
+                    pNode->pHandler = pHandler;
+                    pNode->pHandlerParam = pHandlerParam;
+                    // Kick the event handler in case there are
+                    // messages already waiting
+                    uPortEventQueueSend(pContext->routeEventQueueHandle,
+                                        &pContext, sizeof(pContext));
+                }
+            }
+            if (errorCode != 0) {
+                // Clean up any nodes we added that are now unused
+                routePrune(&pRouteRoot);
+                pContext->pRouteRoot = pRouteRoot;
+                messageCallbackUpdate(pContext);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCode;
+}
+
+// Remove a handler added with uMqttClientRouteAdd().
+int32_t uMqttClientRouteRemove(uMqttClientContext_t *pContext,
+                               const char *pTopicFilterStr)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientRouteNode_t *pRouteRoot;
+    uMqttClientRouteNode_t *pNode;
+
+    if ((pContext != NULL) && (pTopicFilterStr != NULL)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        pRouteRoot = (uMqttClientRouteNode_t *) pContext->pRouteRoot;
+        pNode = pRouteNodeGet(&pRouteRoot, pTopicFilterStr, false);
+        if ((pNode != NULL) && (pNode->pHandler != NULL)) {
+            pNode->pHandler = NULL;
+            pNode->pHandlerParam = NULL;
+            routePrune(&pRouteRoot);
+            pContext->pRouteRoot = pRouteRoot;
+            // If that was the last route this will
+            // restore the user's message callback
+            errorCode = messageCallbackUpdate(pContext);
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCode;
+}
+
+// Read an MQTT message in chunks.
+int32_t uMqttClientMessageReadChunked(uMqttClientContext_t *pContext,
+                                      char *pTopicNameStr,
+                                      size_t topicNameSizeBytes,
+                                      char *pChunkBuffer,
+                                      size_t chunkSizeBytes,
+                                      bool (*pCallback) (const char *, size_t,
+                                                         size_t, size_t,
+                                                         void *),
+                                      void *pCallbackParam,
+                                      uMqttQos_t *pQos)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && (pTopicNameStr != NULL) &&
+        (topicNameSizeBytes > 0) && (pChunkBuffer != NULL) &&
+        (chunkSizeBytes > 0) && (pCallback != NULL)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+            errorCodeOrLength = uCellMqttMessageReadChunked(pContext->devHandle,
+                                                            pTopicNameStr,
+                                                            topicNameSizeBytes,
+                                                            pChunkBuffer,
+                                                            chunkSizeBytes,
+                                                            pCallback,
+                                                            pCallbackParam,
+                                                            (uCellMqttQos_t *) pQos);
+        } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
+            errorCodeOrLength = uWifiMqttMessageReadChunked(pContext,
+                                                            pTopicNameStr,
+                                                            topicNameSizeBytes,
+                                                            pChunkBuffer,
+                                                            chunkSizeBytes,
+                                                            pCallback,
+                                                            pCallbackParam,
+                                                            pQos);
+        }
+        if (errorCodeOrLength >= 0) {
             pContext->totalMessagesReceived++;
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
     }
 
+    return errorCodeOrLength;
+}
+
+// Start publishing the metrics periodically.
+int32_t uMqttClientMetricsExportStart(uMqttClientContext_t *pContext,
+                                      const char *pTopicNameStr,
+                                      uMqttQos_t qos,
+                                      int32_t periodMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && (pTopicNameStr != NULL) &&
+        (qos < U_MQTT_QOS_MAX_NUM) && (periodMs > 0)) {
+        // Stop any previous export before its parameters are changed
+        uMqttClientMetricsExportStop();
+        gMetricsExport.pContext = pContext;
+        gMetricsExport.pTopicNameStr = pTopicNameStr;
+        gMetricsExport.qos = qos;
+        errorCode = uMetricsExportStart(periodMs, metricsExport, &gMetricsExport);
+        if (errorCode != 0) {
+            gMetricsExport.pContext = NULL;
+        }
+    }
+
     return errorCode;
 }
 
+// Stop publishing the metrics.
+void uMqttClientMetricsExportStop()
+{
+    if (gMetricsExport.pContext != NULL) {
+        uMetricsExportStop();
+        gMetricsExport.pContext = NULL;
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MQTT-SN ONLY
  * -------------------------------------------------------------- */
@@ -639,6 +2136,9 @@ int32_t uMqttClientSnConnect(uMqttClientContext_t *pContext,
             // context and can be updated.
             pContext->pPriv = (void *) pConnection->pWill;
         }
+        if (errorCode == 0) {
+            snTopicCacheConnect(pContext, pConnection);
+        }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
     }
@@ -725,22 +2225,32 @@ int32_t uMqttClientSnGetTopicNameShort(const uMqttSnTopicName_t *pTopicName,
 }
 
 // Ask the MQTT broker for an MQTT-SN topic name for the given normal MQTT topic.
-int32_t uMqttClientSnRegisterNormalTopic(const uMqttClientContext_t *pContext,
+int32_t uMqttClientSnRegisterNormalTopic(uMqttClientContext_t *pContext,
                                          const char *pTopicNameStr,
                                          uMqttSnTopicName_t *pTopicName)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uMqttClientSnTopicCacheEntry_t *pEntry;
 
     if ((pContext != NULL) && (pTopicNameStr != NULL) && (pTopicName != NULL)) {
         errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
 
-        if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+        pEntry = pSnTopicCacheFind(pContext, pTopicNameStr);
+        if (pEntry != NULL) {
+            // Registered already, no need to ask the gateway
+            pTopicName->name.id = pEntry->id;
+            pTopicName->type = U_MQTT_SN_TOPIC_NAME_TYPE_ID_NORMAL;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
             errorCode = uCellMqttSnRegisterNormalTopic(pContext->devHandle,
                                                        pTopicNameStr,
                                                        //lint -e(740) Suppress unusual pointer cast
                                                        (uCellMqttSnTopicName_t *) pTopicName);
+            if (errorCode == 0) {
+                snTopicCacheAdd(pContext, pTopicNameStr, pTopicName->name.id);
+            }
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
@@ -773,6 +2283,10 @@ int32_t uMqttClientSnPublish(uMqttClientContext_t *pContext,
         }
         if (errorCode == 0) {
             pContext->totalMessagesSent++;
+        } else if (pTopicName->type == U_MQTT_SN_TOPIC_NAME_TYPE_ID_NORMAL) {
+            // The gateway may have forgotten this topic ID,
+            // make sure it is registered afresh next time
+            snTopicCacheRemoveId(pContext, pTopicName->name.id);
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
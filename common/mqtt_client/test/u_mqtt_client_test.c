@@ -68,6 +68,8 @@
 
 #include "u_mqtt_client.h"
 
+#include "u_bench.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -170,6 +172,33 @@ static bool gDisconnectCallbackCalled;
  */
 static int32_t gNumUnread;
 
+/** The message ID passed to publishAsyncCallback(), -1 if it has
+ * not been called.
+ */
+static volatile int32_t gPublishAsyncMessageId;
+
+/** The error code passed to publishAsyncCallback().
+ */
+static volatile int32_t gPublishAsyncErrorCode;
+
+/** Buffer for one chunk of a message read with
+ * uMqttClientMessageReadChunked(); deliberately not a factor of
+ * the message length.
+ */
+static char gMessageChunk[100];
+
+/** Where messageChunkCallback() should write the chunks.
+ */
+static char *gpMessageChunkBuffer = NULL;
+
+/** Where routeHandler() should write the message.
+ */
+static char *gpRouteMessage = NULL;
+
+/** The length of the last message passed to routeHandler().
+ */
+static volatile size_t gRouteMessageSizeBytes = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -257,6 +286,54 @@ static void disconnectCallback(int32_t errorCode, void *pParam)
 
     gDisconnectCallbackCalled = true;
 }
+
+// Callback for uMqttClientPublishAsync().
+static void publishAsyncCallback(uMqttClientContext_t *pContext,
+                                 int32_t messageId, int32_t errorCode,
+                                 void *pParam)
+{
+    (void) pContext;
+    (void) pParam;
+
+    gPublishAsyncErrorCode = errorCode;
+    gPublishAsyncMessageId = messageId;
+}
+
+// Callback for uMqttClientMessageReadChunked(): reassemble the
+// message in gpMessageChunkBuffer.
+static bool messageChunkCallback(const char *pChunk, size_t size,
+                                 size_t offset, size_t totalSize,
+                                 void *pParam)
+{
+    (void) pParam;
+
+    if (offset + size <= totalSize) {
+        memcpy(gpMessageChunkBuffer + offset, pChunk, size);
+    }
+
+    return true;
+}
+
+// Handler for uMqttClientRouteAdd(): pParam points to a counter
+// of the number of times this filter has been matched.
+static void routeHandler(uMqttClientContext_t *pContext,
+                         const char *pTopicNameStr,
+                         const char *pMessage,
+                         size_t messageSizeBytes,
+                         uMqttQos_t qos, void *pParam)
+{
+    volatile int32_t *pCount = (volatile int32_t *) pParam;
+
+    (void) pContext;
+    (void) pTopicNameStr;
+    (void) qos;
+
+    if (messageSizeBytes <= U_MQTT_CLIENT_TEST_READ_MESSAGE_MAX_LENGTH_BYTES) {
+        memcpy(gpRouteMessage, pMessage, messageSizeBytes);
+        gRouteMessageSizeBytes = messageSizeBytes;
+    }
+    (*pCount)++;
+}
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -268,6 +345,7 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
     uNetworkTestList_t *pList;
     uDeviceHandle_t devHandle;
     int32_t heapUsed;
+    volatile int32_t routeCount[3];
     int32_t heapXxxSecurityInitLoss = 0;
     uMqttClientConnection_t connection = U_MQTT_CLIENT_CONNECTION_DEFAULT;
     uSecurityTlsSettings_t tlsSettings = U_SECURITY_TLS_SETTINGS_DEFAULT;
@@ -447,9 +525,11 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
                         y -= z;
                         s += z;
                     }
+                    uBenchEnergyBegin("mqttClientPublish");
                     y = uMqttClientPublish(gpMqttContextA, pTopicOut, pMessageOut,
                                            U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES,
                                            U_MQTT_QOS_EXACTLY_ONCE, false);
+                    uBenchEnergyEnd("mqttClientPublish");
                     if (y == 0) {
                         U_TEST_PRINT_LINE_MQTT("publish successful after %d ms.",
                                                (int32_t) (uPortGetTickTimeMs() - startTimeMs));
@@ -509,12 +589,163 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
 
                     U_PORT_TEST_ASSERT(uMqttClientGetUnread(gpMqttContextA) == 0);
 
+                    // Do it all again with uMqttClientPublishAsync()
+                    U_TEST_PRINT_LINE_MQTT("publishing %d byte(s) asynchronously...",
+                                           U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES);
+                    gPublishAsyncMessageId = -1;
+                    gPublishAsyncErrorCode = 0;
+                    startTimeMs = uPortGetTickTimeMs();
+                    gStopTimeMs = startTimeMs +
+                                  (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                    y = uMqttClientPublishAsync(gpMqttContextA, pTopicOut, pMessageOut,
+                                                U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES,
+                                                U_MQTT_QOS_EXACTLY_ONCE, false,
+                                                publishAsyncCallback, NULL);
+                    U_PORT_TEST_ASSERT(y >= 0);
+                    while ((gPublishAsyncMessageId < 0) &&
+                           (uPortGetTickTimeMs() < gStopTimeMs)) {
+                        uPortTaskBlock(100);
+                    }
+                    U_TEST_PRINT_LINE_MQTT("publish callback for message ID %d, error code %d,"
+                                           " after %d ms.", gPublishAsyncMessageId,
+                                           gPublishAsyncErrorCode,
+                                           (int32_t) (uPortGetTickTimeMs() - startTimeMs));
+                    U_PORT_TEST_ASSERT(gPublishAsyncMessageId == y);
+                    U_PORT_TEST_ASSERT(gPublishAsyncErrorCode == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientGetPublishAsyncOutstanding(gpMqttContextA) == 0);
+                    startTimeMs = uPortGetTickTimeMs();
+                    while ((uMqttClientGetUnread(gpMqttContextA) == 0) &&
+                           (uPortGetTickTimeMs() < startTimeMs +
+                            (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000))) {
+                        uPortTaskBlock(1000);
+                    }
+                    U_PORT_TEST_ASSERT(uMqttClientGetUnread(gpMqttContextA) == 1);
+                    memset(pMessageIn, 0, U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES);
+                    s = U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES;
+                    if ((pTmp->networkType == U_NETWORK_TYPE_CELL) ||
+                        (pTmp->networkType == U_NETWORK_TYPE_WIFI)) {
+                        // Read this one in chunks
+                        U_TEST_PRINT_LINE_MQTT("reading the message in chunks...");
+                        gpMessageChunkBuffer = pMessageIn;
+                        y = uMqttClientMessageReadChunked(gpMqttContextA,
+                                                          pTopicIn,
+                                                          U_MQTT_CLIENT_TEST_READ_TOPIC_MAX_LENGTH_BYTES,
+                                                          gMessageChunk, sizeof(gMessageChunk),
+                                                          messageChunkCallback, NULL,
+                                                          NULL);
+                        U_PORT_TEST_ASSERT(y >= 0);
+                        s = (size_t) y;
+                    } else {
+                        U_PORT_TEST_ASSERT(uMqttClientMessageRead(gpMqttContextA,
+                                                                  pTopicIn,
+                                                                  U_MQTT_CLIENT_TEST_READ_TOPIC_MAX_LENGTH_BYTES,
+                                                                  pMessageIn, &s,
+                                                                  NULL) == 0);
+                    }
+                    //lint -e(668, 802) Suppress possible use of NULL pointers,
+                    // they are checked above
+                    U_PORT_TEST_ASSERT(strcmp(pTopicIn, pTopicOut) == 0);
+                    U_PORT_TEST_ASSERT(s == U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES);
+                    U_PORT_TEST_ASSERT(memcmp(pMessageIn, pMessageOut, s) == 0);
+
+                    // Now route the message to handlers instead of reading it
+                    U_TEST_PRINT_LINE_MQTT("routing messages on topic \"%s\"...", pTopicOut);
+                    for (size_t x = 0; x < sizeof(routeCount) / sizeof(routeCount[0]); x++) {
+                        routeCount[x] = 0;
+                    }
+                    memset(pMessageIn, 0, U_MQTT_CLIENT_TEST_READ_MESSAGE_MAX_LENGTH_BYTES);
+                    gpRouteMessage = pMessageIn;
+                    gRouteMessageSizeBytes = 0;
+                    U_PORT_TEST_ASSERT(uMqttClientRouteAdd(gpMqttContextA, "a/#/b",
+                                                           routeHandler,
+                                                           NULL) < 0);
+                    U_PORT_TEST_ASSERT(uMqttClientRouteAdd(gpMqttContextA, pTopicOut,
+                                                           routeHandler,
+                                                           (void *) &(routeCount[0])) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientRouteAdd(gpMqttContextA, "#",
+                                                           routeHandler,
+                                                           (void *) &(routeCount[1])) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientRouteAdd(gpMqttContextA, "not/+/this",
+                                                           routeHandler,
+                                                           (void *) &(routeCount[2])) == 0);
+                    gStopTimeMs = uPortGetTickTimeMs() +
+                                  (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                    U_PORT_TEST_ASSERT(uMqttClientPublish(gpMqttContextA, pTopicOut, pMessageOut,
+                                                          U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES,
+                                                          U_MQTT_QOS_EXACTLY_ONCE, false) == 0);
+                    startTimeMs = uPortGetTickTimeMs();
+                    while (((routeCount[0] == 0) || (routeCount[1] == 0)) &&
+                           (uPortGetTickTimeMs() < startTimeMs +
+                            (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000))) {
+                        uPortTaskBlock(100);
+                    }
+                    U_TEST_PRINT_LINE_MQTT("routes matched %d, %d and %d time(s).",
+                                           routeCount[0], routeCount[1], routeCount[2]);
+                    U_PORT_TEST_ASSERT(routeCount[0] == 1);
+                    U_PORT_TEST_ASSERT(routeCount[1] == 1);
+                    U_PORT_TEST_ASSERT(routeCount[2] == 0);
+                    U_PORT_TEST_ASSERT(gRouteMessageSizeBytes == U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES);
+                    U_PORT_TEST_ASSERT(memcmp(pMessageIn, pMessageOut,
+                                              U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientGetUnread(gpMqttContextA) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientRouteRemove(gpMqttContextA, "not/+/this") == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientRouteRemove(gpMqttContextA, "#") == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientRouteRemove(gpMqttContextA, pTopicOut) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientRouteRemove(gpMqttContextA,
+                                                              pTopicOut) == (int32_t) U_ERROR_COMMON_NOT_FOUND);
+
                     // Cancel the subscribe
                     U_TEST_PRINT_LINE_MQTT("unsubscribing from topic \"%s\"...", pTopicOut);
                     gStopTimeMs = uPortGetTickTimeMs() +
                                   (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
                     U_PORT_TEST_ASSERT(uMqttClientUnsubscribe(gpMqttContextA, pTopicOut) == 0);
 
+                    // Subscribe and unsubscribe to several topics in one go
+                    U_TEST_PRINT_LINE_MQTT("subscribing to several topics...");
+                    {
+                        const char *pTopics[] = {pTopicOut, "not/+/this"};
+                        const uMqttQos_t maxQos[] = {U_MQTT_QOS_EXACTLY_ONCE, U_MQTT_QOS_AT_MOST_ONCE};
+                        int32_t qos[2];
+                        gStopTimeMs = uPortGetTickTimeMs() +
+                                      (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                        startTimeMs = uPortGetTickTimeMs();
+                        U_PORT_TEST_ASSERT(uMqttClientSubscribeMulti(gpMqttContextA, pTopics, maxQos,
+                                                                     2, qos) == 0);
+                        U_TEST_PRINT_LINE_MQTT("subscribed after %d ms, QoS %d and %d.",
+                                               (int32_t) (uPortGetTickTimeMs() - startTimeMs),
+                                               qos[0], qos[1]);
+                        U_PORT_TEST_ASSERT((qos[0] >= 0) && (qos[1] >= 0));
+                        gStopTimeMs = uPortGetTickTimeMs() +
+                                      (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                        U_PORT_TEST_ASSERT(uMqttClientUnsubscribeMulti(gpMqttContextA, pTopics, 2) == 0);
+                    }
+
+                    // Store-and-forward: while connected a stored
+                    // message should be forwarded straight away
+                    U_TEST_PRINT_LINE_MQTT("testing store-and-forward...");
+                    U_PORT_TEST_ASSERT(uMqttClientStorePublish(gpMqttContextA, pTopicOut, pMessageOut,
+                                                               U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES,
+                                                               U_MQTT_QOS_AT_LEAST_ONCE, false,
+                                                               0, -1) == (int32_t) U_ERROR_COMMON_NOT_INITIALISED);
+                    U_PORT_TEST_ASSERT(uMqttClientStoreSetSize(gpMqttContextA,
+                                                               U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES * 4) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientStorePublish(gpMqttContextA, pTopicOut, pMessageOut,
+                                                               U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES,
+                                                               U_MQTT_QOS_AT_LEAST_ONCE, false,
+                                                               0, -1) == 0);
+                    startTimeMs = uPortGetTickTimeMs();
+                    gStopTimeMs = startTimeMs +
+                                  (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                    while ((uMqttClientStoreGetNum(gpMqttContextA) > 0) &&
+                           (uPortGetTickTimeMs() < gStopTimeMs)) {
+                        uPortTaskBlock(100);
+                    }
+                    U_TEST_PRINT_LINE_MQTT("%d message(s) still stored after %d ms.",
+                                           uMqttClientStoreGetNum(gpMqttContextA),
+                                           (int32_t) (uPortGetTickTimeMs() - startTimeMs));
+                    U_PORT_TEST_ASSERT(uMqttClientStoreGetNum(gpMqttContextA) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientStoreSetSize(gpMqttContextA, 0) == 0);
+
                     // Remove the callback
                     U_PORT_TEST_ASSERT(uMqttClientSetMessageCallback(gpMqttContextA,
                                                                      NULL, NULL) == 0);
@@ -817,6 +1048,17 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClientSn")
                                            U_MQTT_SN_TOPIC_NAME_TYPE_ID_NORMAL);
                         U_PORT_TEST_ASSERT(uMqttClientSnGetTopicId(&topicNameOut) >= 0);
                         U_PORT_TEST_ASSERT(uMqttClientSnGetTopicNameShort(&topicNameOut, topicNameShortStr) < 0);
+                        // Registering again should give the same ID, this time from the cache
+                        memset(&topicNameIn, 0xFF, sizeof(topicNameIn));
+                        startTimeMs = uPortGetTickTimeMs();
+                        U_PORT_TEST_ASSERT(uMqttClientSnRegisterNormalTopic(gpMqttContextA, pTopicNameOutMqtt,
+                                                                            &topicNameIn) == 0);
+                        U_TEST_PRINT_LINE_MQTTSN("registering again took %d ms.",
+                                                 (int32_t) (uPortGetTickTimeMs() - startTimeMs));
+                        U_PORT_TEST_ASSERT(uMqttClientSnGetTopicNameType(&topicNameIn) ==
+                                           U_MQTT_SN_TOPIC_NAME_TYPE_ID_NORMAL);
+                        U_PORT_TEST_ASSERT(uMqttClientSnGetTopicId(&topicNameIn) ==
+                                           uMqttClientSnGetTopicId(&topicNameOut));
                     }
                 }
 
@@ -71,6 +71,20 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_NETWORK_UP_ASYNC_TASK_STACK_SIZE_BYTES
+/** The stack size of the task in which uNetworkInterfaceUpStart()
+ * brings a network up.
+ */
+# define U_NETWORK_UP_ASYNC_TASK_STACK_SIZE_BYTES (1024 * 3)
+#endif
+
+#ifndef U_NETWORK_UP_ASYNC_TASK_PRIORITY
+/** The priority of the task in which uNetworkInterfaceUpStart()
+ * brings a network up.
+ */
+# define U_NETWORK_UP_ASYNC_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -155,6 +169,9 @@ typedef union {
  *                     member for #U_NETWORK_TYPE_WIFI
  *                     (recalling that reporting of network
  *                     status is not relevant to GNSS).
+ *                     pStatus is NULL when the callback is
+ *                     reporting the outcome of
+ *                     uNetworkInterfaceUpStart().
  *                     IMPORTANT: the status information
  *                     should NOT be used outside the
  *                     callback function unless a copy
@@ -233,13 +250,86 @@ typedef struct {
 int32_t uNetworkInterfaceUp(uDeviceHandle_t devHandle, uNetworkType_t netType,
                             const void *pCfg);
 
+/** Begin bringing up the given network interface on a device,
+ * returning at once: the network is brought up in a task of its
+ * own, so that several networks, on different devices, may be
+ * brought up at the same time without tying up a task of the
+ * application for each.
+ *
+ * If pCallback is not NULL it is set as the network status
+ * callback, exactly as if uNetworkSetStatusCallback() had been
+ * called, before the bring-up begins, so that progress is reported
+ * through it: for cellular the callback is called as the module
+ * registers with the network, for Wi-Fi as the module associates
+ * with the access point.  When the bring-up has completed, i.e.
+ * a cellular context is active or an IP address has been
+ * acquired over Wi-Fi, or has failed, the callback is called
+ * once more with pStatus set to NULL and isUp indicating the
+ * outcome; uNetworkInterfaceUpStatus() will then return the
+ * error code.  The status callback remains in place afterwards
+ * as it would had uNetworkSetStatusCallback() been called.
+ *
+ * A bring-up may be abandoned with uNetworkInterfaceUpCancel().
+ * While a bring-up is in progress uNetworkInterfaceDown() will
+ * cancel it and return #U_ERROR_COMMON_TEMPORARY_FAILURE; it
+ * must be called again once the bring-up has completed.  The
+ * rules about not calling ubxlib from the status callback, see
+ * uNetworkSetStatusCallback(), apply equally here.
+ *
+ * @param devHandle               the handle of the device carrying
+ *                                the network.
+ * @param netType                 which of the network interfaces to
+ *                                bring up.
+ * @param[in] pCfg                the configuration, as for
+ *                                uNetworkInterfaceUp().
+ * @param[in] pCallback           the status callback; may be NULL,
+ *                                in which case the outcome may be
+ *                                obtained by polling
+ *                                uNetworkInterfaceUpStatus().
+ * @param[in] pCallbackParameter  a pointer to be passed to the
+ *                                callback as its last parameter;
+ *                                may be NULL.
+ * @return                        zero if the bring-up has been
+ *                                begun else negative error code.
+ */
+int32_t uNetworkInterfaceUpStart(uDeviceHandle_t devHandle,
+                                 uNetworkType_t netType,
+                                 const void *pCfg,
+                                 uNetworkStatusCallback_t pCallback,
+                                 void *pCallbackParameter);
+
+/** Get the state of a bring-up begun with uNetworkInterfaceUpStart().
+ *
+ * @param devHandle the handle of the device carrying the network.
+ * @param netType   the network interface.
+ * @return          zero if the network was brought up, a positive
+ *                  value if the bring-up is still in progress, else
+ *                  the negative error code with which it failed.
+ */
+int32_t uNetworkInterfaceUpStatus(uDeviceHandle_t devHandle,
+                                  uNetworkType_t netType);
+
+/** Cancel a bring-up begun with uNetworkInterfaceUpStart(); this
+ * does not wait: the bring-up stops at the next opportunity,
+ * which is within a second or so, and completes as a failure in
+ * the usual way.  If no bring-up is in progress this does nothing.
+ *
+ * @param devHandle the handle of the device carrying the network.
+ * @param netType   the network interface.
+ * @return          zero on success else negative error code.
+ */
+int32_t uNetworkInterfaceUpCancel(uDeviceHandle_t devHandle,
+                                  uNetworkType_t netType);
+
 /** Take down the given network interface on a device, disconnecting
  * it from any peer entity.  After this function returns
  * uNetworkInterfaceUp() must be called once more to ensure that the
  * network is brought back to a usable state.  If the network
  * is already down success will be returned.  If a network
  * status callback has been set with uNetworkSetStatusCallback(),
- * this will cancel it.
+ * this will cancel it.  If a bring-up begun with
+ * uNetworkInterfaceUpStart() is in progress it is cancelled and
+ * #U_ERROR_COMMON_TEMPORARY_FAILURE is returned.
  *
  * Note: for a Wi-Fi network, this function uses the
  * uWifiSetConnectionStatusCallback() callback.
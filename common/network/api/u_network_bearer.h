@@ -0,0 +1,194 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_NETWORK_BEARER_H_
+#define _U_NETWORK_BEARER_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+#include "u_network.h"
+
+/** \addtogroup network
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the bearer manager, which sits
+ * above the network API and keeps several networks that can carry
+ * sockets, e.g. Wi-Fi and cellular, up at the same time, one of
+ * them being the "active" bearer, the one the application should
+ * use for uSockCreate(), uMqttClientOpen(), etc., and the others
+ * standing by, so that when the active bearer is lost the
+ * application can be switched to a standby bearer in the time it
+ * takes to re-open its sockets rather than in the time it takes
+ * to bring a network up from cold.
+ *
+ * The bearers are preferred in the order in which they were added
+ * with uNetworkBearerAdd(): when a more preferred bearer comes back
+ * the active bearer is switched back to it.  A Wi-Fi bearer that
+ * is lost is brought up again by the bearer manager; a cellular
+ * module regains service by itself.
+ *
+ * A standby cellular bearer remains registered with its context
+ * active; to save power while it is standing by, configure 3GPP
+ * power saving (see uCellPwrSetRequested3gppPowerSaving()), which
+ * parks the module in PSM without losing the registration, before
+ * calling uNetworkBearerStart().
+ *
+ * The bearer manager owns the network status callback of each
+ * bearer: the application must not call uNetworkSetStatusCallback()
+ * on a bearer, it should use the switch callback given to
+ * uNetworkBearerStart() instead.  This API is thread-safe but is
+ * not re-entrant: there is one bearer manager.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_NETWORK_BEARER_MAX_NUM
+/** The maximum number of bearers that may be added.
+ */
+# define U_NETWORK_BEARER_MAX_NUM 4
+#endif
+
+#ifndef U_NETWORK_BEARER_RETRY_INTERVAL_SECONDS
+/** The time to wait before trying again to bring up a bearer
+ * that failed to come up or that was lost and does not
+ * recover by itself.
+ */
+# define U_NETWORK_BEARER_RETRY_INTERVAL_SECONDS 10
+#endif
+
+#ifndef U_NETWORK_BEARER_TASK_STACK_SIZE_BYTES
+/** The stack size of the task in which the bearer manager handles
+ * status changes and calls the switch callback.
+ */
+# define U_NETWORK_BEARER_TASK_STACK_SIZE_BYTES (1024 * 3)
+#endif
+
+#ifndef U_NETWORK_BEARER_TASK_PRIORITY
+/** The priority of the task in which the bearer manager handles
+ * status changes and calls the switch callback.
+ */
+# define U_NETWORK_BEARER_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The callback called when the active bearer changes; this is
+ * the place to re-home sockets and MQTT connections, i.e. close
+ * those that were on the old bearer and open them again on the
+ * new one.  It is called in the task of the bearer manager, not
+ * in a callback task of ubxlib, and so ubxlib APIs MAY be called
+ * from it; no other change of bearer will be reported until it
+ * returns.
+ *
+ * @param devHandleOld       the device handle of the bearer that
+ *                           was active, NULL if there was none.
+ * @param netTypeOld         the network type of the bearer that
+ *                           was active.
+ * @param devHandleNew       the device handle of the bearer that
+ *                           is now active, NULL if there is none,
+ *                           i.e. all bearers are lost.
+ * @param netTypeNew         the network type of the bearer that
+ *                           is now active.
+ * @param pCallbackParameter the parameter given to
+ *                           uNetworkBearerStart().
+ */
+typedef void (*uNetworkBearerSwitchCallback_t)(uDeviceHandle_t devHandleOld,
+                                               uNetworkType_t netTypeOld,
+                                               uDeviceHandle_t devHandleNew,
+                                               uNetworkType_t netTypeNew,
+                                               void *pCallbackParameter);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Add a bearer; this must be done before uNetworkBearerStart()
+ * is called.  The device must already be open.
+ *
+ * @param devHandle  the handle of the device carrying the network.
+ * @param netType    the network type, e.g. #U_NETWORK_TYPE_WIFI or
+ *                   #U_NETWORK_TYPE_CELL.
+ * @param[in] pCfg   the network configuration, which must remain
+ *                   valid until uNetworkBearerStop() is called, see
+ *                   uNetworkInterfaceUp().
+ * @return           zero on success else negative error code.
+ */
+int32_t uNetworkBearerAdd(uDeviceHandle_t devHandle,
+                          uNetworkType_t netType,
+                          const void *pCfg);
+
+/** Start the bearer manager: all of the bearers are brought up,
+ * at the same time, with uNetworkInterfaceUpStart(), and the first
+ * to come up becomes the active bearer, after which the bearer
+ * manager switches bearers as they come and go.  This returns
+ * without waiting for any bearer to come up: the switch callback
+ * is called when the first does.
+ *
+ * @param[in] pCallback          the callback to be called when the
+ *                               active bearer changes; may be NULL,
+ *                               in which case the application must
+ *                               poll uNetworkBearerGet().
+ * @param[in] pCallbackParameter a parameter to be passed to the
+ *                               callback; may be NULL.
+ * @return                       zero on success else negative
+ *                               error code.
+ */
+int32_t uNetworkBearerStart(uNetworkBearerSwitchCallback_t pCallback,
+                            void *pCallbackParameter);
+
+/** Get the active bearer, the one that the application should
+ * use for uSockCreate(), uMqttClientOpen(), etc.
+ *
+ * @param[out] pDevHandle  a place to put the device handle of the
+ *                         active bearer; cannot be NULL.
+ * @param[out] pNetType    a place to put the network type of the
+ *                         active bearer; may be NULL.
+ * @return                 zero on success, #U_ERROR_COMMON_NOT_FOUND
+ *                         if no bearer is up, else negative error
+ *                         code.
+ */
+int32_t uNetworkBearerGet(uDeviceHandle_t *pDevHandle,
+                          uNetworkType_t *pNetType);
+
+/** Stop the bearer manager, taking all of the bearers down and
+ * removing them.  The switch callback will not be called once this
+ * has returned; this must not be called from the switch callback.
+ */
+void uNetworkBearerStop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_NETWORK_BEARER_H_
+
+// End of file
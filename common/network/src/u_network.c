@@ -34,6 +34,8 @@
 #include "stdlib.h"    // malloc(), free()
 #include "string.h"    // memset()
 
+#include "u_cfg_os_platform_specific.h" // For U_CFG_OS_APP_TASK_PRIORITY
+
 #include "u_error_common.h"
 
 #include "u_device_shared.h"
@@ -45,6 +47,8 @@
 #include "u_location.h"
 #include "u_location_shared.h"
 
+#include "u_sock.h"
+
 #include "u_network.h"
 #include "u_network_config_ble.h"
 #include "u_network_config_cell.h"
@@ -72,7 +76,8 @@
  * -------------------------------------------------------------- */
 
 // Bring a network up or down.
-// This must be called between uDeviceLock() and uDeviceUnlock().
+// This must be called between uDeviceLock() and uDeviceUnlock()
+// except by upAsyncTask(), see there for why.
 static int32_t networkInterfaceChangeState(uDeviceHandle_t devHandle,
                                            uNetworkType_t netType,
                                            const void *pNetworkCfg,
@@ -132,6 +137,139 @@ static int32_t networkInterfaceChangeState(uDeviceHandle_t devHandle,
     return errorCode;
 }
 
+// Get the network data for the given network type, taking a
+// free entry if no network of this type has yet been brought up
+// on the device, and set its configuration.
+// This must be called between uDeviceLock() and uDeviceUnlock().
+static int32_t networkDataSet(uDeviceHandle_t devHandle,
+                              uNetworkType_t netType,
+                              const void *pCfg,
+                              uDeviceNetworkData_t **ppNetworkData)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uDeviceInstance_t *pInstance;
+    uDeviceNetworkData_t *pNetworkData;
+
+    if ((uDeviceGetInstance(devHandle, &pInstance) == 0) &&
+        (netType >= U_NETWORK_TYPE_NONE) &&
+        (netType < U_NETWORK_TYPE_MAX_NUM)) {
+        pNetworkData = pUNetworkGetNetworkData(pInstance, netType);
+        if (pNetworkData == NULL) {
+            // No network of this type has yet been brought up on
+            // this device
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pNetworkData = pUNetworkGetNetworkData(pInstance, U_NETWORK_TYPE_NONE);
+        }
+        if (pNetworkData != NULL) {
+            pNetworkData->networkType = (int32_t) netType;
+            errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            if (pCfg == NULL) {
+                // Use possible last set configuration
+                pCfg = pNetworkData->pCfg;
+            }
+            if (pCfg != NULL) {
+                pNetworkData->pCfg = pCfg;
+                *ppNetworkData = pNetworkData;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Set a network status callback.
+// This must be called between uDeviceLock() and uDeviceUnlock().
+static int32_t statusCallbackSet(uDeviceHandle_t devHandle,
+                                 uNetworkType_t netType,
+                                 uDeviceNetworkData_t *pNetworkData,
+                                 uNetworkStatusCallback_t pCallback,
+                                 void *pCallbackParameter)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    uNetworkStatusCallbackData_t *pStatusCallbackData;
+
+    // Allocate space for the status callback data
+    // and attach it to the network data block;
+    // the various callback functions can then
+    // obtain it from there with a call to
+    // pUNetworkGetNetworkData()
+    if (pNetworkData->pStatusCallbackData == NULL) {
+        pNetworkData->pStatusCallbackData = malloc(sizeof(uNetworkStatusCallbackData_t));
+    }
+    pStatusCallbackData = (uNetworkStatusCallbackData_t *) pNetworkData->pStatusCallbackData;
+    if (pStatusCallbackData != NULL) {
+        pStatusCallbackData->pCallback = pCallback;
+        pStatusCallbackData->pCallbackParameter = pCallbackParameter;
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        switch (netType) {
+            case U_NETWORK_TYPE_BLE:
+                errorCode = uNetworkSetStatusCallbackBle(devHandle);
+                break;
+            case U_NETWORK_TYPE_CELL:
+                errorCode = uNetworkSetStatusCallbackCell(devHandle);
+                break;
+            case U_NETWORK_TYPE_WIFI:
+                errorCode = uNetworkSetStatusCallbackWifi(devHandle);
+                break;
+            case U_NETWORK_TYPE_GNSS:
+                // Not relevant to GNSS
+                break;
+            default:
+                break;
+        }
+        if (errorCode != 0) {
+            free(pNetworkData->pStatusCallbackData);
+            pNetworkData->pStatusCallbackData = NULL;
+        }
+    }
+
+    return errorCode;
+}
+
+// The task in which a network is brought up by
+// uNetworkInterfaceUpStart().
+static void upAsyncTask(void *pParameter)
+{
+    uNetworkUpAsync_t *pUpAsync = (uNetworkUpAsync_t *) pParameter;
+    uDeviceHandle_t devHandle = pUpAsync->devHandle;
+    uNetworkType_t netType = pUpAsync->netType;
+    uNetworkStatusCallback_t pCallback = pUpAsync->pCallback;
+    void *pCallbackParameter = pUpAsync->pCallbackParameter;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uDeviceInstance_t *pInstance;
+    uDeviceNetworkData_t *pNetworkData;
+
+    // The device API is NOT locked while the network is brought
+    // up, that is the point; the cellular, GNSS and short-range
+    // APIs have mutexes of their own, the network data entry
+    // was claimed by uNetworkInterfaceUpStart() and it cannot be
+    // released while pUpAsync->running is true.
+    if (uDeviceGetInstance(devHandle, &pInstance) == 0) {
+        pNetworkData = pUNetworkGetNetworkData(pInstance, netType);
+        if (pNetworkData != NULL) {
+            errorCode = networkInterfaceChangeState(devHandle, netType,
+                                                    pNetworkData->pCfg,
+                                                    true);
+        }
+    }
+
+    if (uDeviceLock() == 0) {
+        pUpAsync->errorCode = errorCode;
+        pUpAsync->running = false;
+        // pUpAsync may be freed as soon as we unlock
+        uDeviceUnlock();
+    }
+
+    if (pCallback != NULL) {
+        pCallback(devHandle, netType, (errorCode == 0), NULL,
+                  pCallbackParameter);
+    }
+
+    // Delete ourselves
+    uPortTaskDelete(NULL);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -139,36 +277,139 @@ static int32_t networkInterfaceChangeState(uDeviceHandle_t devHandle,
 int32_t uNetworkInterfaceUp(uDeviceHandle_t devHandle,
                             uNetworkType_t netType,
                             const void *pCfg)
+{
+    // Lock the API
+    int32_t errorCode = uDeviceLock();
+    uDeviceNetworkData_t *pNetworkData = NULL;
+    uNetworkUpAsync_t *pUpAsync;
+
+    if (errorCode == 0) {
+        errorCode = networkDataSet(devHandle, netType, pCfg, &pNetworkData);
+        if (errorCode == 0) {
+            pUpAsync = (uNetworkUpAsync_t *) pNetworkData->pUpAsync;
+            if ((pUpAsync != NULL) && pUpAsync->running) {
+                // Already being brought up by uNetworkInterfaceUpStart()
+                errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+            } else {
+                errorCode = networkInterfaceChangeState(devHandle, netType,
+                                                        pNetworkData->pCfg,
+                                                        true);
+            }
+        }
+        // ...and done
+        uDeviceUnlock();
+    }
+
+    return errorCode;
+}
+
+int32_t uNetworkInterfaceUpStart(uDeviceHandle_t devHandle,
+                                 uNetworkType_t netType,
+                                 const void *pCfg,
+                                 uNetworkStatusCallback_t pCallback,
+                                 void *pCallbackParameter)
+{
+    // Lock the API
+    int32_t errorCode = uDeviceLock();
+    uDeviceNetworkData_t *pNetworkData = NULL;
+    uNetworkUpAsync_t *pUpAsync;
+    uPortTaskHandle_t taskHandle;
+
+    if (errorCode == 0) {
+        errorCode = networkDataSet(devHandle, netType, pCfg, &pNetworkData);
+        if (errorCode == 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+            pUpAsync = (uNetworkUpAsync_t *) pNetworkData->pUpAsync;
+            if ((pUpAsync == NULL) || !pUpAsync->running) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                if (pUpAsync == NULL) {
+                    pUpAsync = (uNetworkUpAsync_t *) malloc(sizeof(uNetworkUpAsync_t));
+                    pNetworkData->pUpAsync = pUpAsync;
+                }
+                if (pUpAsync != NULL) {
+                    memset(pUpAsync, 0, sizeof(*pUpAsync));
+                    pUpAsync->devHandle = devHandle;
+                    pUpAsync->netType = netType;
+                    pUpAsync->pCallback = pCallback;
+                    pUpAsync->pCallbackParameter = pCallbackParameter;
+                    pUpAsync->errorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    if ((pCallback != NULL) && (netType != U_NETWORK_TYPE_GNSS)) {
+                        // Progress is reported through the status
+                        // callback; this is not relevant to GNSS,
+                        // which will only see the outcome
+                        errorCode = statusCallbackSet(devHandle, netType, pNetworkData,
+                                                      pCallback, pCallbackParameter);
+                    }
+                    if (errorCode == 0) {
+                        pUpAsync->running = true;
+                        errorCode = uPortTaskCreate(upAsyncTask, "networkUp",
+                                                    U_NETWORK_UP_ASYNC_TASK_STACK_SIZE_BYTES,
+                                                    (void *) pUpAsync,
+                                                    U_NETWORK_UP_ASYNC_TASK_PRIORITY,
+                                                    &taskHandle);
+                    }
+                    if (errorCode != 0) {
+                        // Clean up on error
+                        free(pNetworkData->pUpAsync);
+                        pNetworkData->pUpAsync = NULL;
+                    }
+                }
+            }
+        }
+        // ...and done
+        uDeviceUnlock();
+    }
+
+    return errorCode;
+}
+
+int32_t uNetworkInterfaceUpStatus(uDeviceHandle_t devHandle,
+                                  uNetworkType_t netType)
 {
     // Lock the API
     int32_t errorCode = uDeviceLock();
     uDeviceInstance_t *pInstance;
     uDeviceNetworkData_t *pNetworkData;
+    uNetworkUpAsync_t *pUpAsync;
 
     if (errorCode == 0) {
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        if ((uDeviceGetInstance(devHandle, &pInstance) == 0) &&
-            (netType >= U_NETWORK_TYPE_NONE) &&
-            (netType < U_NETWORK_TYPE_MAX_NUM)) {
+        if (uDeviceGetInstance(devHandle, &pInstance) == 0) {
             pNetworkData = pUNetworkGetNetworkData(pInstance, netType);
-            if (pNetworkData == NULL) {
-                // No network of this type has yet been brought up on
-                // this device
-                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-                pNetworkData = pUNetworkGetNetworkData(pInstance, U_NETWORK_TYPE_NONE);
+            if ((pNetworkData != NULL) && (pNetworkData->pUpAsync != NULL)) {
+                pUpAsync = (uNetworkUpAsync_t *) pNetworkData->pUpAsync;
+                errorCode = pUpAsync->errorCode;
+                if (pUpAsync->running) {
+                    errorCode = 1;
+                }
             }
+        }
+        // ...and done
+        uDeviceUnlock();
+    }
+
+    return errorCode;
+}
+
+int32_t uNetworkInterfaceUpCancel(uDeviceHandle_t devHandle,
+                                  uNetworkType_t netType)
+{
+    // Lock the API
+    int32_t errorCode = uDeviceLock();
+    uDeviceInstance_t *pInstance;
+    uDeviceNetworkData_t *pNetworkData;
+    uNetworkUpAsync_t *pUpAsync;
+
+    if (errorCode == 0) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (uDeviceGetInstance(devHandle, &pInstance) == 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            pNetworkData = pUNetworkGetNetworkData(pInstance, netType);
             if (pNetworkData != NULL) {
-                pNetworkData->networkType = (int32_t) netType;
-                errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-                if (pCfg == NULL) {
-                    // Use possible last set configuration
-                    pCfg = pNetworkData->pCfg;
-                }
-                if (pCfg != NULL) {
-                    pNetworkData->pCfg = pCfg;
-                    errorCode = networkInterfaceChangeState(devHandle, netType,
-                                                            pNetworkData->pCfg,
-                                                            true);
+                pUpAsync = (uNetworkUpAsync_t *) pNetworkData->pUpAsync;
+                if ((pUpAsync != NULL) && pUpAsync->running) {
+                    pUpAsync->cancel = true;
                 }
             }
         }
@@ -195,12 +436,24 @@ int32_t uNetworkInterfaceDown(uDeviceHandle_t devHandle, uNetworkType_t netType)
             // been brought up, hence success
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
             pNetworkData = pUNetworkGetNetworkData(pInstance, netType);
-            if (pNetworkData != NULL) {
+            if ((pNetworkData != NULL) && (pNetworkData->pUpAsync != NULL) &&
+                ((uNetworkUpAsync_t *) pNetworkData->pUpAsync)->running) {
+                // Can't wait for uNetworkInterfaceUpStart() here
+                // since it needs the lock to complete: cancel it
+                // and let the caller try again once it has
+                ((uNetworkUpAsync_t *) pNetworkData->pUpAsync)->cancel = true;
+                errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+            } else if (pNetworkData != NULL) {
                 errorCode = networkInterfaceChangeState(devHandle, netType,
                                                         pNetworkData->pCfg,
                                                         false);
+                // Any DNS look-ups cached for this device
+                // can no longer be trusted
+                uSockDnsCacheFlush(devHandle);
                 free(pNetworkData->pStatusCallbackData);
                 pNetworkData->pStatusCallbackData = NULL;
+                free(pNetworkData->pUpAsync);
+                pNetworkData->pUpAsync = NULL;
             }
         }
         // ...and done
@@ -220,7 +473,6 @@ int32_t uNetworkSetStatusCallback(uDeviceHandle_t devHandle,
     int32_t errorCode = uDeviceLock();
     uDeviceInstance_t *pInstance;
     uDeviceNetworkData_t *pNetworkData;
-    uNetworkStatusCallbackData_t *pStatusCallbackData;
 
     if (errorCode == 0) {
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
@@ -231,41 +483,8 @@ int32_t uNetworkSetStatusCallback(uDeviceHandle_t devHandle,
             // been brought up
             pNetworkData = pUNetworkGetNetworkData(pInstance, netType);
             if (pNetworkData != NULL) {
-                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-                // Allocate space for the status callback data
-                // and attach it to the network data block;
-                // the various callback functions can then
-                // obtain it from there with a call to
-                // pUNetworkGetNetworkData()
-                if (pNetworkData->pStatusCallbackData == NULL) {
-                    pNetworkData->pStatusCallbackData = malloc(sizeof(uNetworkStatusCallbackData_t));
-                }
-                pStatusCallbackData = (uNetworkStatusCallbackData_t *) pNetworkData->pStatusCallbackData;
-                if (pStatusCallbackData != NULL) {
-                    pStatusCallbackData->pCallback = pCallback;
-                    pStatusCallbackData->pCallbackParameter = pCallbackParameter;
-                    errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
-                    switch (netType) {
-                        case U_NETWORK_TYPE_BLE:
-                            errorCode = uNetworkSetStatusCallbackBle(devHandle);
-                            break;
-                        case U_NETWORK_TYPE_CELL:
-                            errorCode = uNetworkSetStatusCallbackCell(devHandle);
-                            break;
-                        case U_NETWORK_TYPE_WIFI:
-                            errorCode = uNetworkSetStatusCallbackWifi(devHandle);
-                            break;
-                        case U_NETWORK_TYPE_GNSS:
-                            // Not relevant to GNSS
-                            break;
-                        default:
-                            break;
-                    }
-                    if (errorCode != 0) {
-                        free(pNetworkData->pStatusCallbackData);
-                        pNetworkData->pStatusCallbackData = NULL;
-                    }
-                }
+                errorCode = statusCallbackSet(devHandle, netType, pNetworkData,
+                                              pCallback, pCallbackParameter);
             }
         }
         // ...and done
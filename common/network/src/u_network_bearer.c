@@ -0,0 +1,462 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the bearer manager, which keeps a standby
+ * network warm and switches the active bearer when one is lost.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h" // For U_CFG_OS_APP_TASK_PRIORITY
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_debug.h"
+#include "u_port_event_queue.h"
+
+#include "u_device.h"
+
+#include "u_network.h"
+#include "u_network_bearer.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The length of the event queue of the bearer manager.
+ */
+#define U_NETWORK_BEARER_EVENT_QUEUE_LENGTH 8
+
+/** The event index used for the retry timer.
+ */
+#define U_NETWORK_BEARER_EVENT_INDEX_RETRY -1
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The state of a bearer.
+ */
+typedef enum {
+    U_NETWORK_BEARER_STATE_NONE,     /**< entry is not in use. */
+    U_NETWORK_BEARER_STATE_ADDED,    /**< added but not yet started. */
+    U_NETWORK_BEARER_STATE_STARTING, /**< being brought up. */
+    U_NETWORK_BEARER_STATE_UP,       /**< up, may carry traffic. */
+    U_NETWORK_BEARER_STATE_DOWN,     /**< lost, the module is recovering it. */
+    U_NETWORK_BEARER_STATE_RETRY     /**< lost or failed, waiting to try again. */
+} uNetworkBearerState_t;
+
+/** A bearer.
+ */
+typedef struct {
+    uDeviceHandle_t devHandle;
+    uNetworkType_t netType;
+    const void *pCfg;
+    uNetworkBearerState_t state;
+} uNetworkBearer_t;
+
+/** An event passed from a network status callback, or from the
+ * retry timer, to the task of the bearer manager.
+ */
+typedef struct {
+    int32_t index;    /**< the index of the bearer, or
+                           #U_NETWORK_BEARER_EVENT_INDEX_RETRY. */
+    bool isUp;
+    bool isOutcome;   /**< true if this is the outcome of
+                           uNetworkInterfaceUpStart(). */
+} uNetworkBearerEvent_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Mutex to protect the bearers.
+ */
+static uPortMutexHandle_t gMutex = NULL;
+
+/** The bearers, in order of preference.
+ */
+static uNetworkBearer_t gBearer[U_NETWORK_BEARER_MAX_NUM];
+
+/** The index of the active bearer, -1 if there is none.
+ */
+static int32_t gActiveIndex = -1;
+
+/** The handle of the event queue, negative if not started.
+ */
+static int32_t gEventQueueHandle = -1;
+
+/** The retry timer, NULL if timers are not supported.
+ */
+static uPortTimerHandle_t gRetryTimer = NULL;
+
+/** The switch callback.
+ */
+static uNetworkBearerSwitchCallback_t gpCallback = NULL;
+
+/** The parameter for the switch callback.
+ */
+static void *gpCallbackParameter = NULL;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// The network status callback of all of the bearers: this is called
+// in a callback task of ubxlib so all it does is pass the news on.
+static void statusCallback(uDeviceHandle_t devHandle,
+                           uNetworkType_t netType,
+                           bool isUp,
+                           uNetworkStatus_t *pStatus,
+                           void *pParameter)
+{
+    uNetworkBearerEvent_t event;
+    int32_t eventQueueHandle = gEventQueueHandle;
+
+    (void) devHandle;
+    (void) netType;
+
+    if (eventQueueHandle >= 0) {
+        event.index = (int32_t) (((uNetworkBearer_t *) pParameter) - gBearer);
+        event.isUp = isUp;
+        event.isOutcome = (pStatus == NULL);
+        uPortEventQueueSend(eventQueueHandle, &event, sizeof(event));
+    }
+}
+
+// Callback for the retry timer.
+static void retryTimerCallback(const uPortTimerHandle_t timerHandle,
+                               void *pParameter)
+{
+    uNetworkBearerEvent_t event = {.index = U_NETWORK_BEARER_EVENT_INDEX_RETRY,
+                                   .isUp = false,
+                                   .isOutcome = false
+                                  };
+    int32_t eventQueueHandle = gEventQueueHandle;
+
+    (void) timerHandle;
+    (void) pParameter;
+
+    if (eventQueueHandle >= 0) {
+        uPortEventQueueSend(eventQueueHandle, &event, sizeof(event));
+    }
+}
+
+// Begin bringing up a bearer.
+// This must be called with gMutex locked.
+static void bearerStart(uNetworkBearer_t *pBearer)
+{
+    pBearer->state = U_NETWORK_BEARER_STATE_STARTING;
+    if (uNetworkInterfaceUpStart(pBearer->devHandle, pBearer->netType,
+                                 pBearer->pCfg, statusCallback,
+                                 (void *) pBearer) != 0) {
+        pBearer->state = U_NETWORK_BEARER_STATE_RETRY;
+    }
+}
+
+// Work out which bearer should be active: the most preferred
+// one that is up.
+// This must be called with gMutex locked.
+static int32_t bestIndex()
+{
+    int32_t index = -1;
+
+    for (size_t x = 0; (index < 0) && (x < sizeof(gBearer) / sizeof(gBearer[0])); x++) {
+        if (gBearer[x].state == U_NETWORK_BEARER_STATE_UP) {
+            index = (int32_t) x;
+        }
+    }
+
+    return index;
+}
+
+// The event handler of the bearer manager: bring the bearer state
+// up to date, retry anything that needs retrying and switch the
+// active bearer if that has changed.
+static void eventHandler(void *pParam, size_t paramLength)
+{
+    uNetworkBearerEvent_t *pEvent = (uNetworkBearerEvent_t *) pParam;
+    uNetworkBearer_t *pBearer;
+    bool retryNeeded = false;
+    int32_t oldIndex;
+    int32_t newIndex;
+    uDeviceHandle_t devHandleOld = NULL;
+    uNetworkType_t netTypeOld = U_NETWORK_TYPE_NONE;
+    uDeviceHandle_t devHandleNew = NULL;
+    uNetworkType_t netTypeNew = U_NETWORK_TYPE_NONE;
+
+    (void) paramLength;
+
+    U_PORT_MUTEX_LOCK(gMutex);
+
+    if (pEvent->index == U_NETWORK_BEARER_EVENT_INDEX_RETRY) {
+        for (size_t x = 0; x < sizeof(gBearer) / sizeof(gBearer[0]); x++) {
+            if (gBearer[x].state == U_NETWORK_BEARER_STATE_RETRY) {
+                uPortLog("U_NETWORK_BEARER: trying %d again.\n", x);
+                bearerStart(&gBearer[x]);
+            }
+        }
+    } else if ((pEvent->index >= 0) &&
+               (pEvent->index < (int32_t) (sizeof(gBearer) / sizeof(gBearer[0])))) {
+        pBearer = &gBearer[pEvent->index];
+        if (pEvent->isOutcome) {
+            // The outcome of a bring-up
+            pBearer->state = pEvent->isUp ? U_NETWORK_BEARER_STATE_UP :
+                             U_NETWORK_BEARER_STATE_RETRY;
+        } else if (pBearer->state != U_NETWORK_BEARER_STATE_STARTING) {
+            // A change in status after the bring-up: a cellular
+            // module regains service by itself, anything
+            // else has to be brought up again by us
+            if (pEvent->isUp) {
+                if (pBearer->netType == U_NETWORK_TYPE_CELL) {
+                    pBearer->state = U_NETWORK_BEARER_STATE_UP;
+                }
+            } else {
+                pBearer->state = U_NETWORK_BEARER_STATE_DOWN;
+                if (pBearer->netType != U_NETWORK_TYPE_CELL) {
+                    // Take it down properly so that it
+                    // can be brought up again
+                    uNetworkInterfaceDown(pBearer->devHandle, pBearer->netType);
+                    pBearer->state = U_NETWORK_BEARER_STATE_RETRY;
+                }
+            }
+        }
+        if (pBearer->state == U_NETWORK_BEARER_STATE_RETRY) {
+            retryNeeded = true;
+        }
+    }
+
+    if (retryNeeded && (gRetryTimer != NULL)) {
+        uPortTimerStart(gRetryTimer);
+        retryNeeded = false;
+    }
+
+    oldIndex = gActiveIndex;
+    newIndex = bestIndex();
+    if (newIndex != oldIndex) {
+        if (oldIndex >= 0) {
+            devHandleOld = gBearer[oldIndex].devHandle;
+            netTypeOld = gBearer[oldIndex].netType;
+        }
+        if (newIndex >= 0) {
+            devHandleNew = gBearer[newIndex].devHandle;
+            netTypeNew = gBearer[newIndex].netType;
+        }
+        gActiveIndex = newIndex;
+        uPortLog("U_NETWORK_BEARER: active bearer %d -> %d.\n", oldIndex, newIndex);
+    }
+
+    U_PORT_MUTEX_UNLOCK(gMutex);
+
+    if ((newIndex != oldIndex) && (gpCallback != NULL)) {
+        gpCallback(devHandleOld, netTypeOld, devHandleNew, netTypeNew,
+                   gpCallbackParameter);
+    }
+
+    if (retryNeeded) {
+        // No timers on this platform, have to just wait
+        uPortTaskBlock(U_NETWORK_BEARER_RETRY_INTERVAL_SECONDS * 1000);
+        retryTimerCallback(NULL, NULL);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add a bearer.
+int32_t uNetworkBearerAdd(uDeviceHandle_t devHandle,
+                          uNetworkType_t netType,
+                          const void *pCfg)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (gMutex == NULL) {
+        errorCode = uPortMutexCreate(&gMutex);
+        if (errorCode == 0) {
+            memset(gBearer, 0, sizeof(gBearer));
+            gActiveIndex = -1;
+        }
+    }
+
+    if (errorCode == 0) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((devHandle != NULL) && (pCfg != NULL) &&
+            (netType > U_NETWORK_TYPE_NONE) && (netType < U_NETWORK_TYPE_MAX_NUM) &&
+            (netType != U_NETWORK_TYPE_GNSS) && (gEventQueueHandle < 0)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            for (size_t x = 0; (errorCode != 0) &&
+                 (x < sizeof(gBearer) / sizeof(gBearer[0])); x++) {
+                if (gBearer[x].state == U_NETWORK_BEARER_STATE_NONE) {
+                    gBearer[x].devHandle = devHandle;
+                    gBearer[x].netType = netType;
+                    gBearer[x].pCfg = pCfg;
+                    gBearer[x].state = U_NETWORK_BEARER_STATE_ADDED;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Start the bearer manager.
+int32_t uNetworkBearerStart(uNetworkBearerSwitchCallback_t pCallback,
+                            void *pCallbackParameter)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (gEventQueueHandle < 0) {
+            gpCallback = pCallback;
+            gpCallbackParameter = pCallbackParameter;
+            errorCode = uPortEventQueueOpen(eventHandler, "networkBearer",
+                                            sizeof(uNetworkBearerEvent_t),
+                                            U_NETWORK_BEARER_TASK_STACK_SIZE_BYTES,
+                                            U_NETWORK_BEARER_TASK_PRIORITY,
+                                            U_NETWORK_BEARER_EVENT_QUEUE_LENGTH);
+            if (errorCode >= 0) {
+                gEventQueueHandle = errorCode;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                // Not all platforms support timers, if there
+                // isn't one the event task will wait instead
+                if (uPortTimerCreate(&gRetryTimer, "networkBearer",
+                                     retryTimerCallback, NULL,
+                                     U_NETWORK_BEARER_RETRY_INTERVAL_SECONDS * 1000,
+                                     false) != 0) {
+                    gRetryTimer = NULL;
+                }
+                // Bring all of the bearers up at once
+                for (size_t x = 0; x < sizeof(gBearer) / sizeof(gBearer[0]); x++) {
+                    if (gBearer[x].state == U_NETWORK_BEARER_STATE_ADDED) {
+                        bearerStart(&gBearer[x]);
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Get the active bearer.
+int32_t uNetworkBearerGet(uDeviceHandle_t *pDevHandle,
+                          uNetworkType_t *pNetType)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pDevHandle != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (gActiveIndex >= 0) {
+                *pDevHandle = gBearer[gActiveIndex].devHandle;
+                if (pNetType != NULL) {
+                    *pNetType = gBearer[gActiveIndex].netType;
+                }
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Stop the bearer manager.
+void uNetworkBearerStop(void)
+{
+    int32_t eventQueueHandle;
+    uNetworkBearer_t *pBearer;
+
+    if (gMutex != NULL) {
+        // Stop the event task first, without the lock
+        // since the event handler needs it
+        U_PORT_MUTEX_LOCK(gMutex);
+        eventQueueHandle = gEventQueueHandle;
+        gEventQueueHandle = -1;
+        U_PORT_MUTEX_UNLOCK(gMutex);
+        if (eventQueueHandle >= 0) {
+            uPortEventQueueClose(eventQueueHandle);
+        }
+        if (gRetryTimer != NULL) {
+            uPortTimerDelete(gRetryTimer);
+            gRetryTimer = NULL;
+        }
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        // Take the bearers down, cancelling any that
+        // are still being brought up
+        for (size_t x = 0; x < sizeof(gBearer) / sizeof(gBearer[0]); x++) {
+            pBearer = &gBearer[x];
+            if (pBearer->state != U_NETWORK_BEARER_STATE_NONE) {
+                if (pBearer->state != U_NETWORK_BEARER_STATE_ADDED) {
+                    uNetworkInterfaceUpCancel(pBearer->devHandle, pBearer->netType);
+                    while (uNetworkInterfaceUpStatus(pBearer->devHandle,
+                                                     pBearer->netType) > 0) {
+                        uPortTaskBlock(100);
+                    }
+                    uNetworkInterfaceDown(pBearer->devHandle, pBearer->netType);
+                }
+                memset(pBearer, 0, sizeof(*pBearer));
+            }
+        }
+        gActiveIndex = -1;
+        gpCallback = NULL;
+        gpCallbackParameter = NULL;
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
+        uPortMutexDelete(gMutex);
+        gMutex = NULL;
+    }
+}
+
+// End of file
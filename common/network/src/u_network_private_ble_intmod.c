@@ -77,7 +77,8 @@ static void statusCallback(int32_t connHandle, char *pAddress,
                            int32_t status, int32_t channel, int32_t mtu,
                            void *pParameter)
 {
-    uDeviceInstance_t *pInstance = (uDeviceInstance_t *) pParameter;
+    uDeviceHandle_t devHandle = (uDeviceHandle_t) pParameter;
+    uDeviceInstance_t *pInstance = U_DEVICE_INSTANCE(devHandle);
     uDeviceNetworkData_t *pNetworkData;
     uNetworkStatusCallbackData_t *pStatusCallbackData;
     bool isUp;
@@ -106,7 +107,7 @@ static void statusCallback(int32_t connHandle, char *pAddress,
                 networkStatus.ble.status = status;
                 networkStatus.ble.channel = channel;
                 networkStatus.ble.mtu = mtu;
-                pStatusCallbackData->pCallback((uDeviceHandle_t) pInstance,
+                pStatusCallbackData->pCallback(devHandle,
                                                U_NETWORK_TYPE_BLE, isUp,
                                                &networkStatus,
                                                pStatusCallbackData->pCallbackParameter);
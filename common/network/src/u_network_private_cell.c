@@ -48,6 +48,8 @@
 
 #include "u_network_shared.h"
 
+#include "u_sock.h"
+
 #include "u_cell_module_type.h"
 #include "u_cell.h"
 #include "u_cell_net.h"
@@ -91,6 +93,31 @@ static bool keepGoingCallback(uDeviceHandle_t devHandle)
     return keepGoing;
 }
 
+// Call-back for connect/disconnect when the bring-up was begun
+// with uNetworkInterfaceUpStart(), which may be cancelled.
+static bool keepGoingAsyncCallback(uDeviceHandle_t devHandle)
+{
+    uDeviceInstance_t *pDevInstance = NULL;
+    uDeviceNetworkData_t *pNetworkData;
+    const uNetworkCfgCell_t *pCfg = NULL;
+    bool keepGoing = false;
+
+    if (!uNetworkUpIsCancelled(devHandle, U_NETWORK_TYPE_CELL) &&
+        (uDeviceGetInstance(devHandle, &pDevInstance) == 0)) {
+        pNetworkData = pUNetworkGetNetworkData(pDevInstance, U_NETWORK_TYPE_CELL);
+        if (pNetworkData != NULL) {
+            pCfg = (const uNetworkCfgCell_t *) pNetworkData->pCfg;
+        }
+        if ((pCfg != NULL) && (pCfg->pKeepGoingCallback != NULL)) {
+            keepGoing = pCfg->pKeepGoingCallback(devHandle);
+        } else {
+            keepGoing = keepGoingCallback(devHandle);
+        }
+    }
+
+    return keepGoing;
+}
+
 // Call-back for status changes.
 //lint -esym(818, pParameter) Suppress "could be declared as pointing to const",
 // gotta follow function signature
@@ -98,7 +125,8 @@ static void statusCallback(uCellNetRegDomain_t domain,
                            uCellNetStatus_t status,
                            void *pParameter)
 {
-    uDeviceInstance_t *pInstance = (uDeviceInstance_t *) pParameter;
+    uDeviceHandle_t devHandle = (uDeviceHandle_t) pParameter;
+    uDeviceInstance_t *pInstance = U_DEVICE_INSTANCE(devHandle);
     uDeviceNetworkData_t *pNetworkData;
     uNetworkStatusCallbackData_t *pStatusCallbackData;
     bool isUp;
@@ -119,9 +147,14 @@ static void statusCallback(uCellNetRegDomain_t domain,
             if ((pStatusCallbackData != NULL) &&
                 (pStatusCallbackData->pCallback)) {
                 isUp = U_CELL_NET_STATUS_MEANS_REGISTERED(status);
+                if (!isUp) {
+                    // Any DNS look-ups cached for this device
+                    // can no longer be trusted
+                    uSockDnsCacheFlush(devHandle);
+                }
                 networkStatus.cell.domain = (int32_t) domain;
                 networkStatus.cell.status = (int32_t) status;
-                pStatusCallbackData->pCallback((uDeviceHandle_t) pInstance,
+                pStatusCallbackData->pCallback(devHandle,
                                                U_NETWORK_TYPE_CELL, isUp, &networkStatus,
                                                pStatusCallbackData->pCallbackParameter);
             }
@@ -142,6 +175,7 @@ int32_t uNetworkPrivateChangeStateCell(uDeviceHandle_t devHandle,
     uDeviceInstance_t *pDevInstance;
     int32_t errorCode = uDeviceGetInstance(devHandle, &pDevInstance);
     bool (*pKeepGoingCallback)(uDeviceHandle_t devHandle) = keepGoingCallback;
+    uDeviceNetworkData_t *pNetworkData;
 
     if (errorCode == 0) {
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
@@ -156,6 +190,13 @@ int32_t uNetworkPrivateChangeStateCell(uDeviceHandle_t devHandle,
                 pContext->stopTimeMs = uPortGetTickTimeMs() +
                                        (((int64_t) pCfg->timeoutSeconds) * 1000);
             }
+            pNetworkData = pUNetworkGetNetworkData(pDevInstance, U_NETWORK_TYPE_CELL);
+            if (upNotDown && (pNetworkData != NULL) && (pNetworkData->pUpAsync != NULL)) {
+                // Being brought up by uNetworkInterfaceUpStart(),
+                // which may be cancelled, and the keep-going
+                // callback above will be called from there
+                pKeepGoingCallback = keepGoingAsyncCallback;
+            }
             if (upNotDown) {
                 // Connect using automatic selection,
                 // default no user name or password for the APN
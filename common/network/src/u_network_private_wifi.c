@@ -46,6 +46,8 @@
 
 #include "u_network_shared.h"
 
+#include "u_sock.h"
+
 #include "u_short_range_module_type.h"
 #include "u_short_range.h"
 
@@ -168,6 +170,11 @@ static void wifiConnectionCallback(uDeviceHandle_t devHandle,
                 (pStatusCallbackData->pCallback)) {
                 networkStatus.wifi.pBssid = NULL;
                 isUp = (status == (int32_t) U_WIFI_CON_STATUS_CONNECTED);
+                if (!isUp) {
+                    // Any DNS look-ups cached for this device
+                    // can no longer be trusted
+                    uSockDnsCacheFlush(devHandle);
+                }
                 networkStatus.wifi.connId = connId;
                 networkStatus.wifi.status = status;
                 networkStatus.wifi.channel = channel;
@@ -264,11 +271,13 @@ static inline int32_t statusQueueWaitForWifiDisabled(const uPortQueueHandle_t qu
     return (int32_t) U_ERROR_COMMON_TIMEOUT;
 }
 
-static inline int32_t statusQueueWaitForWifiConnected(const uPortQueueHandle_t queueHandle,
+static inline int32_t statusQueueWaitForWifiConnected(uDeviceHandle_t devHandle,
+                                                      const uPortQueueHandle_t queueHandle,
                                                       int32_t timeoutSec)
 {
     int32_t startTime = (int32_t)uPortGetTickTimeMs();
-    while ((int32_t)uPortGetTickTimeMs() - startTime < timeoutSec * 1000) {
+    while (((int32_t)uPortGetTickTimeMs() - startTime < timeoutSec * 1000) &&
+           !uNetworkUpIsCancelled(devHandle, U_NETWORK_TYPE_WIFI)) {
         uStatusMessage_t msg;
         int32_t errorCode = uPortQueueTryReceive(queueHandle, 1000, &msg);
         if ((errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) &&
@@ -279,14 +288,16 @@ static inline int32_t statusQueueWaitForWifiConnected(const uPortQueueHandle_t q
     return (int32_t) U_ERROR_COMMON_TIMEOUT;
 }
 
-static inline int32_t statusQueueWaitForNetworkUp(const uPortQueueHandle_t queueHandle,
+static inline int32_t statusQueueWaitForNetworkUp(uDeviceHandle_t devHandle,
+                                                  const uPortQueueHandle_t queueHandle,
                                                   int32_t timeoutSec)
 {
     static const uint32_t desiredNetStatusMask =
         U_WIFI_STATUS_MASK_IPV4_UP | U_WIFI_STATUS_MASK_IPV6_UP;
     uint32_t lastNetStatusMask = 0;
     int32_t startTime = (int32_t)uPortGetTickTimeMs();
-    while ((int32_t)uPortGetTickTimeMs() - startTime < timeoutSec * 1000) {
+    while (((int32_t)uPortGetTickTimeMs() - startTime < timeoutSec * 1000) &&
+           !uNetworkUpIsCancelled(devHandle, U_NETWORK_TYPE_WIFI)) {
         uStatusMessage_t msg;
         int32_t errorCode = uPortQueueTryReceive(queueHandle, 1000, &msg);
         if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
@@ -371,9 +382,9 @@ int32_t uNetworkPrivateChangeStateWifi(uDeviceHandle_t devHandle,
                                             pCfg->pPassPhrase);
             if (errorCode == 0) {
                 // Wait until the network layer is up before return
-                errorCode = statusQueueWaitForWifiConnected(queueHandle, 20);
+                errorCode = statusQueueWaitForWifiConnected(devHandle, queueHandle, 20);
                 if (errorCode == 0) {
-                    errorCode = statusQueueWaitForNetworkUp(queueHandle,
+                    errorCode = statusQueueWaitForNetworkUp(devHandle, queueHandle,
                                                             U_NETWORK_PRIVATE_WIFI_NETWORK_TIMEOUT_SEC);
                 }
             }
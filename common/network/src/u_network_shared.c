@@ -137,4 +137,26 @@ uDeviceNetworkData_t *pUNetworkGetNetworkData(uDeviceInstance_t *pInstance,
     return pNetworkData;
 }
 
+bool uNetworkUpIsCancelled(uDeviceHandle_t devHandle,
+                           uNetworkType_t netType)
+{
+    bool cancelled = false;
+    uDeviceInstance_t *pInstance;
+    uDeviceNetworkData_t *pNetworkData;
+    uNetworkUpAsync_t *pUpAsync;
+
+    // This function does NOT lock the device API, see
+    // uNetworkGetDeviceHandle() for why; the context
+    // cannot be freed while the bring-up is running.
+    if (uDeviceGetInstance(devHandle, &pInstance) == 0) {
+        pNetworkData = pUNetworkGetNetworkData(pInstance, netType);
+        if (pNetworkData != NULL) {
+            pUpAsync = (uNetworkUpAsync_t *) pNetworkData->pUpAsync;
+            cancelled = (pUpAsync != NULL) && pUpAsync->running && pUpAsync->cancel;
+        }
+    }
+
+    return cancelled;
+}
+
 // End of file
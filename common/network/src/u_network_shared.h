@@ -29,6 +29,25 @@
 
 #include "u_network.h"
 
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The context of a network bring-up begun with
+ * uNetworkInterfaceUpStart(), hooked off the pUpAsync field of
+ * the network data; it is only freed, under the device API lock,
+ * once running is false.
+ */
+typedef struct {
+    uDeviceHandle_t devHandle;
+    uNetworkType_t netType;
+    uNetworkStatusCallback_t pCallback;
+    void *pCallbackParameter;
+    volatile bool running;
+    volatile bool cancel;
+    int32_t errorCode;
+} uNetworkUpAsync_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -67,6 +86,20 @@ uDeviceHandle_t uNetworkGetDeviceHandle(uDeviceHandle_t devHandle,
 uDeviceNetworkData_t *pUNetworkGetNetworkData(uDeviceInstance_t *pInstance,
                                               uNetworkType_t netType);
 
+/** Determine whether a bring-up begun with uNetworkInterfaceUpStart()
+ * has been cancelled with uNetworkInterfaceUpCancel(); this may be
+ * called by the network-specific code while it is waiting for a
+ * network to come up so that it can give up early.  It does NOT
+ * lock the device API and so may be called from a keep-going
+ * callback.
+ *
+ * @param devHandle the handle of the device.
+ * @param netType   the network type.
+ * @return          true if the bring-up has been cancelled.
+ */
+bool uNetworkUpIsCancelled(uDeviceHandle_t devHandle,
+                           uNetworkType_t netType);
+
 #ifdef __cplusplus
 }
 #endif
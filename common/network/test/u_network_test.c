@@ -38,6 +38,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "limits.h"    // INT_MIN
 #include "string.h"    // memset(), strcmp()
 #include "ctype.h"     // isprint()
 
@@ -70,12 +71,16 @@
 #endif
 
 #include "u_network.h"
+#include "u_network_bearer.h"
 #ifdef U_CFG_TEST_NET_STATUS_SHORT_RANGE
 # include "u_wifi.h"
 # include "u_network_config_wifi.h"
 #endif
 #include "u_network_test_shared_cfg.h"
 
+#include "u_device_shared.h"  // uDeviceLock()
+#include "u_device_private.h" // uDevicePrivateUartBaudRateXxx()
+
 #include "u_sock.h"                  // In order to prove that we can do something
 #include "u_sock_test_shared_cfg.h"  // with an "up" network that can support sockets
 
@@ -110,6 +115,13 @@
  */
 #define U_TEST_PRINT_LINE_X(format, ...) uPortLog(U_TEST_PREFIX_X format "\n", ##__VA_ARGS__)
 
+#ifndef U_NETWORK_TEST_BEARER_TIMEOUT_SECONDS
+/** How long to wait for the bearer manager to make a bearer
+ * active.
+ */
+# define U_NETWORK_TEST_BEARER_TIMEOUT_SECONDS 240
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -374,6 +386,63 @@ static void connectionCallback(int32_t connHandle, char *address, int32_t status
 }
 #endif // #if defined(U_BLE_TEST_CFG_REMOTE_SPS_CENTRAL) || defined(U_BLE_TEST_CFG_REMOTE_SPS_PERIPHERAL)
 
+// Callback for uDeviceOpenStart().
+static void deviceOpenCallback(uDeviceHandle_t devHandle,
+                               int32_t errorCode,
+                               void *pCallbackParam)
+{
+    (void) devHandle;
+
+    if (errorCode == 0) {
+        (*((volatile int32_t *) pCallbackParam))++;
+    }
+}
+
+// Status callback for uNetworkInterfaceUpStart(): count the
+// progress reports and the outcomes.
+static void upAsyncCallback(uDeviceHandle_t devHandle,
+                            uNetworkType_t netType,
+                            bool isUp,
+                            uNetworkStatus_t *pStatus,
+                            void *pParameter)
+{
+    volatile int32_t *pCount = (volatile int32_t *) pParameter;
+
+    (void) devHandle;
+    (void) netType;
+
+    if (pStatus == NULL) {
+        // The outcome: count successes in the first entry,
+        // failures in the second
+        if (isUp) {
+            (*pCount)++;
+        } else {
+            (*(pCount + 1))++;
+        }
+    } else {
+        // Progress
+        (*(pCount + 2))++;
+    }
+}
+
+// Callback for a change of bearer.
+static void bearerSwitchCallback(uDeviceHandle_t devHandleOld,
+                                 uNetworkType_t netTypeOld,
+                                 uDeviceHandle_t devHandleNew,
+                                 uNetworkType_t netTypeNew,
+                                 void *pCallbackParameter)
+{
+    volatile int32_t *pCount = (volatile int32_t *) pCallbackParameter;
+
+    (void) devHandleOld;
+    (void) devHandleNew;
+
+    U_TEST_PRINT_LINE("bearer switched from %s to %s.",
+                      gpUNetworkTestTypeName[netTypeOld],
+                      gpUNetworkTestTypeName[netTypeNew]);
+    (*pCount)++;
+}
+
 // Callback function for location establishment process.
 static bool keepGoingCallback(uDeviceHandle_t devHandle)
 {
@@ -1374,6 +1443,406 @@ U_PORT_TEST_FUNCTION("[network]", "networkOutage")
 
 #endif // #if defined(U_CFG_TEST_NET_STATUS_SHORT_RANGE) || defined (U_CFG_TEST_NET_STATUS_CELL)
 
+/** Test opening all of the devices at the same time with
+ * uDeviceOpenStart().
+ */
+U_PORT_TEST_FUNCTION("[network]", "networkOpenAsync")
+{
+    uNetworkTestList_t *pList;
+    uDeviceOpenAsyncHandle_t openHandle[U_DEVICE_TYPE_MAX_NUM];
+    uDeviceHandle_t *pDevHandle[U_DEVICE_TYPE_MAX_NUM];
+    volatile int32_t callbackCount = 0;
+    size_t numDevices = 0;
+    bool alreadyOpening;
+    int32_t startTimeMs;
+    int32_t heapUsed;
+
+    // Make sure we start fresh for this test case
+    uNetworkTestCleanUp();
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uDeviceInit() == 0);
+
+    // Begin opening every device at once; a device may appear
+    // in the list once for each of its networks, so only
+    // start each one once
+    pList = pUNetworkTestListAlloc(NULL);
+    startTimeMs = uPortGetTickTimeMs();
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        alreadyOpening = false;
+        for (size_t x = 0; x < numDevices; x++) {
+            if (pDevHandle[x] == pTmp->pDevHandle) {
+                alreadyOpening = true;
+            }
+        }
+        if (!alreadyOpening && (*pTmp->pDevHandle == NULL)) {
+            U_PORT_TEST_ASSERT(numDevices < sizeof(openHandle) / sizeof(openHandle[0]));
+            U_TEST_PRINT_LINE("starting to open device %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType]);
+            U_PORT_TEST_ASSERT(uDeviceOpenStart(pTmp->pDeviceCfg, deviceOpenCallback,
+                                                (void *) &callbackCount,
+                                                &(openHandle[numDevices])) == 0);
+            pDevHandle[numDevices] = pTmp->pDevHandle;
+            numDevices++;
+        }
+    }
+
+    // Wait for them all to complete
+    for (size_t x = 0; x < numDevices; x++) {
+        U_PORT_TEST_ASSERT(uDeviceOpenWait(openHandle[x], pDevHandle[x], -1) == 0);
+        U_PORT_TEST_ASSERT(*pDevHandle[x] != NULL);
+    }
+    U_TEST_PRINT_LINE("%d device(s) opened in %d ms.", numDevices,
+                      uPortGetTickTimeMs() - startTimeMs);
+    U_PORT_TEST_ASSERT(callbackCount == (int32_t) numDevices);
+
+    // Close the devices once more and free the list
+    for (size_t x = 0; x < numDevices; x++) {
+        U_PORT_TEST_ASSERT(uDeviceClose(*pDevHandle[x], false) == 0);
+        *pDevHandle[x] = NULL;
+    }
+    uNetworkTestListFree();
+
+    uDeviceDeinit();
+    uPortDeinit();
+
+#ifndef __XTENSA__
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost, heapUsed - gSystemHeapLost);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) || (heapUsed <= (int32_t) gSystemHeapLost));
+#else
+    (void) heapUsed;
+#endif
+}
+
+/** Test bringing up all of the networks that support sockets at
+ * the same time with uNetworkInterfaceUpStart().
+ */
+U_PORT_TEST_FUNCTION("[network]", "networkUpAsync")
+{
+    uNetworkTestList_t *pList;
+    // Successes, failures, progress reports
+    volatile int32_t count[3] = {0};
+    int32_t numNetworks = 0;
+    int32_t startTimeMs;
+    int32_t y;
+    int32_t heapUsed;
+
+    // Make sure we start fresh for this test case
+    uNetworkTestCleanUp();
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uDeviceInit() == 0);
+
+    // Get a list of things that support sockets
+    pList = pUNetworkTestListAlloc(uNetworkTestHasSock);
+    // Open the devices that are not already open
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (*pTmp->pDevHandle == NULL) {
+            U_TEST_PRINT_LINE("adding device %s for network %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType],
+                              gpUNetworkTestTypeName[pTmp->networkType]);
+            U_PORT_TEST_ASSERT(uDeviceOpen(pTmp->pDeviceCfg, pTmp->pDevHandle) == 0);
+        }
+    }
+
+    // Begin bringing up all of the networks at once
+    startTimeMs = uPortGetTickTimeMs();
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        U_TEST_PRINT_LINE("starting to bring up %s...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceUpStart(*pTmp->pDevHandle,
+                                                    pTmp->networkType,
+                                                    pTmp->pNetworkCfg,
+                                                    upAsyncCallback,
+                                                    (void *) count) == 0);
+        // Can't start it twice
+        U_PORT_TEST_ASSERT(uNetworkInterfaceUpStart(*pTmp->pDevHandle,
+                                                    pTmp->networkType,
+                                                    pTmp->pNetworkCfg,
+                                                    upAsyncCallback,
+                                                    (void *) count) < 0);
+        numNetworks++;
+    }
+
+    // Wait for them all to complete
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        while ((y = uNetworkInterfaceUpStatus(*pTmp->pDevHandle,
+                                              pTmp->networkType)) > 0) {
+            uPortTaskBlock(100);
+        }
+        U_TEST_PRINT_LINE("%s outcome %d.", gpUNetworkTestTypeName[pTmp->networkType], y);
+        U_PORT_TEST_ASSERT(y == 0);
+    }
+    // Give the callbacks, which are called after the status is
+    // updated, a moment to be called
+    uPortTaskBlock(100);
+    U_TEST_PRINT_LINE("%d network(s) brought up in %d ms, %d progress report(s).",
+                      numNetworks, uPortGetTickTimeMs() - startTimeMs, count[2]);
+    U_PORT_TEST_ASSERT(count[0] == numNetworks);
+    U_PORT_TEST_ASSERT(count[1] == 0);
+
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        U_TEST_PRINT_LINE("taking down %s...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceDown(*pTmp->pDevHandle,
+                                                 pTmp->networkType) == 0);
+    }
+
+    // Start one more time and cancel at once: the outcome may
+    // be either, since the bring-up may have completed before
+    // the cancel arrives, but it must complete
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        U_TEST_PRINT_LINE("starting to bring up %s and cancelling...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceUpStart(*pTmp->pDevHandle,
+                                                    pTmp->networkType,
+                                                    pTmp->pNetworkCfg,
+                                                    NULL, NULL) == 0);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceUpCancel(*pTmp->pDevHandle,
+                                                     pTmp->networkType) == 0);
+        while ((y = uNetworkInterfaceUpStatus(*pTmp->pDevHandle,
+                                              pTmp->networkType)) > 0) {
+            uPortTaskBlock(100);
+        }
+        U_TEST_PRINT_LINE("%s outcome %d.", gpUNetworkTestTypeName[pTmp->networkType], y);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceDown(*pTmp->pDevHandle,
+                                                 pTmp->networkType) == 0);
+    }
+
+    // Close the devices once more and free the list
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (*pTmp->pDevHandle != NULL) {
+            U_TEST_PRINT_LINE("closing device %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType]);
+            U_PORT_TEST_ASSERT(uDeviceClose(*pTmp->pDevHandle, false) == 0);
+            *pTmp->pDevHandle = NULL;
+        }
+    }
+    uNetworkTestListFree();
+
+    uDeviceDeinit();
+    uPortDeinit();
+
+#ifndef __XTENSA__
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost, heapUsed - gSystemHeapLost);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) || (heapUsed <= (int32_t) gSystemHeapLost));
+#else
+    (void) heapUsed;
+#endif
+}
+
+/** Test the bearer manager: add everything that supports sockets
+ * as a bearer, start the bearer manager and check that a bearer
+ * becomes active.
+ */
+U_PORT_TEST_FUNCTION("[network]", "networkBearer")
+{
+    uNetworkTestList_t *pList;
+    volatile int32_t switchCount = 0;
+    uDeviceHandle_t devHandle = NULL;
+    uNetworkType_t netType = U_NETWORK_TYPE_NONE;
+    int32_t startTimeMs;
+    int32_t y;
+    int32_t heapUsed;
+    int32_t heapSockInitLoss = 0;
+
+    // Make sure we start fresh for this test case
+    uNetworkTestCleanUp();
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uDeviceInit() == 0);
+
+    // No bearers yet
+    U_PORT_TEST_ASSERT(uNetworkBearerStart(NULL, NULL) < 0);
+
+    // Get a list of things that support sockets
+    pList = pUNetworkTestListAlloc(uNetworkTestHasSock);
+    // Open the devices that are not already open and add
+    // each network as a bearer
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (*pTmp->pDevHandle == NULL) {
+            U_TEST_PRINT_LINE("adding device %s for network %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType],
+                              gpUNetworkTestTypeName[pTmp->networkType]);
+            U_PORT_TEST_ASSERT(uDeviceOpen(pTmp->pDeviceCfg, pTmp->pDevHandle) == 0);
+        }
+        U_TEST_PRINT_LINE("adding %s as a bearer...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uNetworkBearerAdd(*pTmp->pDevHandle,
+                                             pTmp->networkType,
+                                             pTmp->pNetworkCfg) == 0);
+    }
+
+    if (pList != NULL) {
+        startTimeMs = uPortGetTickTimeMs();
+        U_PORT_TEST_ASSERT(uNetworkBearerStart(bearerSwitchCallback,
+                                               (void *) &switchCount) == 0);
+        // Wait for a bearer to become active
+        while (((y = uNetworkBearerGet(&devHandle, &netType)) != 0) &&
+               (uPortGetTickTimeMs() - startTimeMs < U_NETWORK_TEST_BEARER_TIMEOUT_SECONDS * 1000)) {
+            uPortTaskBlock(100);
+        }
+        U_TEST_PRINT_LINE("%s became the active bearer after %d ms.",
+                          gpUNetworkTestTypeName[netType], uPortGetTickTimeMs() - startTimeMs);
+        U_PORT_TEST_ASSERT(y == 0);
+        U_PORT_TEST_ASSERT(devHandle != NULL);
+        // Prove that the active bearer can do something
+        U_PORT_TEST_ASSERT(openSocketAndUseIt(devHandle, netType,
+                                              &heapSockInitLoss) == 0);
+        // Give the switch callback, which is called after
+        // the active bearer is updated, a moment to be called
+        uPortTaskBlock(100);
+        U_PORT_TEST_ASSERT(switchCount > 0);
+
+        U_TEST_PRINT_LINE("stopping the bearer manager...");
+        uNetworkBearerStop();
+        U_PORT_TEST_ASSERT(uNetworkBearerGet(&devHandle, &netType) < 0);
+    }
+
+    // Close the devices once more and free the list
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (*pTmp->pDevHandle != NULL) {
+            U_TEST_PRINT_LINE("closing device %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType]);
+            U_PORT_TEST_ASSERT(uDeviceClose(*pTmp->pDevHandle, false) == 0);
+            *pTmp->pDevHandle = NULL;
+        }
+    }
+    uNetworkTestListFree();
+    uNetworkBearerStop();
+
+    uDeviceDeinit();
+    uPortDeinit();
+
+#ifndef __XTENSA__
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test, %d byte(s) were lost to"
+                      " sockets initialisation and we have leaked"
+                      " %d byte(s).", gSystemHeapLost, heapSockInitLoss,
+                      heapUsed - (gSystemHeapLost + heapSockInitLoss));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= (int32_t) (gSystemHeapLost +
+                                               heapSockInitLoss)));
+#else
+    (void) heapSockInitLoss;
+    (void) heapUsed;
+#endif
+}
+
+/** Test the bookkeeping behind the UART baud-rate ramp-up of
+ * uDeviceOpen(); no module is needed.
+ */
+U_PORT_TEST_FUNCTION("[network]", "networkBaudRateRamp")
+{
+    // A UART number that nothing else will be using
+    const int32_t uart = 99;
+    int32_t baudRate[5];
+    size_t count;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uDeviceInit() == 0);
+    U_PORT_TEST_ASSERT(uDeviceLock() == 0);
+
+    // With nothing remembered the standard rates above the current
+    // one and no higher than the maximum come out, highest first
+    count = uDevicePrivateUartBaudRateRampGet(uart, 115200, 921600, baudRate,
+                                              sizeof(baudRate) / sizeof(baudRate[0]));
+    U_PORT_TEST_ASSERT(count == 3);
+    U_PORT_TEST_ASSERT(baudRate[0] == 921600);
+    U_PORT_TEST_ASSERT(baudRate[1] == 460800);
+    U_PORT_TEST_ASSERT(baudRate[2] == 230400);
+    count = uDevicePrivateUartBaudRateRampGet(uart, 115200, 3000000, baudRate,
+                                              sizeof(baudRate) / sizeof(baudRate[0]));
+    U_PORT_TEST_ASSERT(count == 4);
+    U_PORT_TEST_ASSERT(baudRate[0] == 3000000);
+    // Limited by the space given
+    count = uDevicePrivateUartBaudRateRampGet(uart, 115200, 921600, baudRate, 1);
+    U_PORT_TEST_ASSERT(count == 1);
+    U_PORT_TEST_ASSERT(baudRate[0] == 921600);
+    // Nothing to go up to
+    U_PORT_TEST_ASSERT(uDevicePrivateUartBaudRateRampGet(uart, 921600, 921600, baudRate,
+                                                         sizeof(baudRate) /
+                                                         sizeof(baudRate[0])) == 0);
+
+    // The rate a module was left at can't be remembered until
+    // a best rate is known
+    U_PORT_TEST_ASSERT(uDevicePrivateUartBaudRateLeftAtGet(uart) == 0);
+    uDevicePrivateUartBaudRateLeftAtSet(uart, 460800);
+    U_PORT_TEST_ASSERT(uDevicePrivateUartBaudRateLeftAtGet(uart) == 0);
+
+    // What worked last time goes first, and only once
+    uDevicePrivateUartBaudRateBestSet(uart, 460800);
+    count = uDevicePrivateUartBaudRateRampGet(uart, 115200, 921600, baudRate,
+                                              sizeof(baudRate) / sizeof(baudRate[0]));
+    U_PORT_TEST_ASSERT(count == 3);
+    U_PORT_TEST_ASSERT(baudRate[0] == 460800);
+    U_PORT_TEST_ASSERT(baudRate[1] == 921600);
+    U_PORT_TEST_ASSERT(baudRate[2] == 230400);
+    // ...but not if it is now above the maximum
+    count = uDevicePrivateUartBaudRateRampGet(uart, 115200, 230400, baudRate,
+                                              sizeof(baudRate) / sizeof(baudRate[0]));
+    U_PORT_TEST_ASSERT(count == 1);
+    U_PORT_TEST_ASSERT(baudRate[0] == 230400);
+    // Another UART is not affected
+    count = uDevicePrivateUartBaudRateRampGet(uart + 1, 115200, 921600, baudRate,
+                                              sizeof(baudRate) / sizeof(baudRate[0]));
+    U_PORT_TEST_ASSERT(count == 3);
+    U_PORT_TEST_ASSERT(baudRate[0] == 921600);
+
+    // Now the rate a module was left at can be remembered
+    uDevicePrivateUartBaudRateLeftAtSet(uart, 460800);
+    U_PORT_TEST_ASSERT(uDevicePrivateUartBaudRateLeftAtGet(uart) == 460800);
+    uDevicePrivateUartBaudRateLeftAtSet(uart, 0);
+    U_PORT_TEST_ASSERT(uDevicePrivateUartBaudRateLeftAtGet(uart) == 0);
+
+    // Forget it all again, since this outlives uDeviceDeinit()
+    uDevicePrivateUartBaudRateLeftAtSet(uart, 460800);
+    uDevicePrivateUartBaudRateBestSet(uart, 0);
+    U_PORT_TEST_ASSERT(uDevicePrivateUartBaudRateLeftAtGet(uart) == 0);
+    count = uDevicePrivateUartBaudRateRampGet(uart, 115200, 921600, baudRate,
+                                              sizeof(baudRate) / sizeof(baudRate[0]));
+    U_PORT_TEST_ASSERT(count == 3);
+    U_PORT_TEST_ASSERT(baudRate[0] == 921600);
+
+    uDeviceUnlock();
+    uDeviceDeinit();
+    uPortDeinit();
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -609,4 +609,25 @@ bool uNetworkTestHasStatusCallback(uDeviceType_t deviceType,
            (networkType == U_NETWORK_TYPE_CELL);
 }
 
+// Get the AT client of a device.
+void *pUNetworkTestAtClientGet(uDeviceHandle_t devHandle)
+{
+    uAtClientHandle_t atHandle = NULL;
+
+#ifdef U_CFG_TEST_CELL_MODULE_TYPE
+    if (uCellAtClientHandleGet(devHandle, &atHandle) != 0) {
+        atHandle = NULL;
+    }
+#endif
+#ifdef U_CFG_TEST_SHORT_RANGE_MODULE_TYPE
+    if ((atHandle == NULL) &&
+        (uShortRangeAtClientHandleGet(devHandle, &atHandle) != 0)) {
+        atHandle = NULL;
+    }
+#endif
+    (void) devHandle;
+
+    return atHandle;
+}
+
 // End of file
@@ -248,6 +248,16 @@ bool uNetworkTestHasStatusCallback(uDeviceType_t deviceType,
                                    uNetworkType_t networkType,
                                    int32_t moduleType);
 
+/** Get the AT client of a device, e.g. to collect statistics on
+ * the AT commands that an operation takes.
+ *
+ * @param devHandle the handle of the device.
+ * @return          the handle of the AT client of the device, a
+ *                  uAtClientHandle_t, or NULL if the device has
+ *                  no AT interface (e.g. a GNSS device).
+ */
+void *pUNetworkTestAtClientGet(uDeviceHandle_t devHandle);
+
 #endif // _U_NETWORK_TEST_CFG_H_
 
 // End of file
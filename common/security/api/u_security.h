@@ -84,6 +84,13 @@ extern "C" {
  */
 #define U_SECURITY_E2E_HEADER_LENGTH_MIN_BYTES U_SECURITY_E2E_V2_HEADER_LENGTH_BYTES
 
+#ifndef U_SECURITY_E2E_STREAM_CHUNK_MAX_LENGTH_BYTES
+/** The largest amount of data that uSecurityE2eEncryptStream()
+ * asks the module to encrypt in one go.
+ */
+# define U_SECURITY_E2E_STREAM_CHUNK_MAX_LENGTH_BYTES 1024
+#endif
+
 /** The maximum amount of storage required for a generated
  * pre-shared key.
  */
@@ -545,6 +552,68 @@ int32_t uSecurityE2eEncrypt(uDeviceHandle_t devHandle,
                             void *pDataOut,
                             size_t dataSizeBytes);
 
+/** Encrypt a block of data of any size, handing the output to a
+ * callback as it is produced, so that a large payload can be
+ * encrypted and sent (e.g. with uSockWrite() or with
+ * uMqttClientPublish()) in bounded RAM, without an output buffer
+ * the size of the whole.  The data is encrypted in chunks of up to
+ * #U_SECURITY_E2E_STREAM_CHUNK_MAX_LENGTH_BYTES, each with its own
+ * header exactly as if uSecurityE2eEncrypt() had been called on
+ * that chunk, so each chunk must be decrypted separately at the
+ * far end; the callback is called once with each encrypted chunk.
+ * The only storage required is that of a single encrypted chunk.
+ *
+ * @param devHandle           the handle of the instance to be used,
+ *                            for example obtained using uDeviceOpen().
+ * @param[in] pDataIn         a pointer to dataSizeBytes of data to
+ *                            be encrypted; cannot be NULL.
+ * @param dataSizeBytes       the number of bytes of data to encrypt.
+ * @param[in] pBuffer         storage for one encrypted chunk; the
+ *                            amount of data encrypted in each chunk
+ *                            is bufferSizeBytes less
+ *                            #U_SECURITY_E2E_HEADER_LENGTH_MAX_BYTES,
+ *                            limited to
+ *                            #U_SECURITY_E2E_STREAM_CHUNK_MAX_LENGTH_BYTES.
+ *                            May be NULL, in which case
+ *                            #U_SECURITY_E2E_STREAM_CHUNK_MAX_LENGTH_BYTES +
+ *                            #U_SECURITY_E2E_HEADER_LENGTH_MAX_BYTES
+ *                            will be allocated for the duration of
+ *                            this call.
+ * @param bufferSizeBytes     the number of bytes at pBuffer, must
+ *                            be more than
+ *                            #U_SECURITY_E2E_HEADER_LENGTH_MAX_BYTES;
+ *                            ignored if pBuffer is NULL.
+ * @param[in] pCallback       the function to call with each encrypted
+ *                            chunk, taking as parameters devHandle,
+ *                            a pointer to the encrypted chunk, the
+ *                            length of the encrypted chunk and
+ *                            pCallbackParam; the chunk is only valid
+ *                            for the duration of the call.  The
+ *                            callback is called from the task that
+ *                            called this function, with no lock held,
+ *                            so it may call other ubxlib APIs on the
+ *                            same device.  It should return zero or a
+ *                            positive value (e.g. the number of bytes
+ *                            sent) to continue or a negative error
+ *                            code to stop, which this function will
+ *                            then return; cannot be NULL.
+ * @param[in] pCallbackParam  a parameter that will be passed to
+ *                            pCallback; may be NULL.
+ * @return                    on success the total number of bytes
+ *                            passed to pCallback, else negative error
+ *                            code.
+ */
+int32_t uSecurityE2eEncryptStream(uDeviceHandle_t devHandle,
+                                  const void *pDataIn,
+                                  size_t dataSizeBytes,
+                                  void *pBuffer,
+                                  size_t bufferSizeBytes,
+                                  int32_t (*pCallback) (uDeviceHandle_t,
+                                                        const void *,
+                                                        size_t,
+                                                        void *),
+                                  void *pCallbackParam);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: PRE-SHARED KEY GENERATION
  * -------------------------------------------------------------- */
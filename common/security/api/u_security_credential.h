@@ -88,6 +88,13 @@ extern "C" {
  */
 #define U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES 16
 
+/** The size of the buffer that uSecurityCredentialStoreStream()
+ * allocates to read a credential into, a chunk at a time.
+ */
+#ifndef U_SECURITY_CREDENTIAL_STREAM_CHUNK_LENGTH_BYTES
+# define U_SECURITY_CREDENTIAL_STREAM_CHUNK_LENGTH_BYTES 256
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -124,6 +131,52 @@ typedef struct {
     int64_t expirationUtc;
 } uSecurityCredential_t;
 
+/** Structure describing a security credential that should be
+ * in storage, used by uSecurityCredentialSync().
+ */
+typedef struct {
+    /** The type of the credential. */
+    uSecurityCredentialType_t type;
+    /** The null-terminated name of the credential, maximum length
+        #U_SECURITY_CREDENTIAL_NAME_MAX_LENGTH_BYTES. */
+    const char *pName;
+    /** The contents of the credential, as would be passed to
+        uSecurityCredentialStore(). */
+    const char *pContents;
+    /** The number of bytes at pContents. */
+    size_t size;
+    /** The password for the credential, as would be passed to
+        uSecurityCredentialStore(); may be NULL. */
+    const char *pPassword;
+    /** Pointer to the #U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES MD5
+        hash of the credential in DER format, as returned by
+        uSecurityCredentialStore() when the credential was first
+        stored, or as calculated, e.g. for a PEM certificate, with
+        "openssl x509 -in cert.pem -outform DER | openssl md5";
+        if NULL the credential is always stored. */
+    const char *pMd5;
+} uSecurityCredentialSync_t;
+
+/** Callback that supplies the contents of a credential to
+ * uSecurityCredentialStoreStream(), a chunk at a time.
+ *
+ * @param[out] pBuffer          where to put the next chunk.
+ * @param size                  the number of bytes wanted, never
+ *                              more than the number of bytes at
+ *                              pBuffer.
+ * @param offset                the offset of this chunk from the
+ *                              start of the credential.
+ * @param pCallbackParameter    the parameter passed to
+ *                              uSecurityCredentialStoreStream().
+ * @return                      the number of bytes written to
+ *                              pBuffer, at most size, or zero/negative
+ *                              if no more can be supplied.
+ */
+typedef int32_t (*uSecurityCredentialStoreCallback_t)(char *pBuffer,
+                                                      size_t size,
+                                                      size_t offset,
+                                                      void *pCallbackParameter);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -200,6 +253,45 @@ int32_t uSecurityCredentialStore(uDeviceHandle_t devHandle,
                                  const char *pPassword,
                                  char *pMd5);
 
+/** As uSecurityCredentialStore() but, rather than having to be
+ * in RAM all at once, the credential is read from a callback, e.g.
+ * out of flash, and sent to the module a chunk of at most
+ * #U_SECURITY_CREDENTIAL_STREAM_CHUNK_LENGTH_BYTES at a time, so
+ * that the RAM required is the same however large the credential.
+ * The callback is called with the AT interface locked and so must
+ * not call any other API of the device.  The module must be sent
+ * exactly size bytes: if the callback stops supplying them early
+ * there is no way to abort the store, the error will only be
+ * returned once the module has timed out.
+ *
+ * @param devHandle            the handle of the instance to be used,
+ *                             for example obtained using uDeviceOpen().
+ * @param type                 the type of credential to be stored.
+ * @param pName                the null-terminated name for the
+ *                             X.509 certificate or security key, as
+ *                             for uSecurityCredentialStore().
+ * @param size                 the total size of the credential in
+ *                             bytes, maximum
+ *                             #U_SECURITY_CREDENTIAL_MAX_LENGTH_BYTES.
+ * @param pPassword            the password, as for
+ *                             uSecurityCredentialStore(); may be NULL.
+ * @param pCallback            the callback that supplies the contents
+ *                             of the credential; cannot be NULL.
+ * @param pCallbackParameter   a parameter that will be passed to
+ *                             pCallback; may be NULL.
+ * @param pMd5                 as for uSecurityCredentialStore(); may
+ *                             be NULL.
+ * @return                     zero on success else negative error code.
+ */
+int32_t uSecurityCredentialStoreStream(uDeviceHandle_t devHandle,
+                                       uSecurityCredentialType_t type,
+                                       const char *pName,
+                                       size_t size,
+                                       const char *pPassword,
+                                       uSecurityCredentialStoreCallback_t pCallback,
+                                       void *pCallbackParameter,
+                                       char *pMd5);
+
 /** Read the MD5 hash of a stored X.509 certificate or security key
  * to compare with that originally returned by uSecurityCredentialStore().
  * The hash is that of the DER-format key as stored in the module.
@@ -222,6 +314,30 @@ int32_t uSecurityCredentialGetHash(uDeviceHandle_t devHandle,
                                    const char *pName,
                                    char *pMd5);
 
+/** Make sure that the given X.509 certificates and security keys
+ * are in storage, storing only those which are missing or whose
+ * MD5 hash, as read with uSecurityCredentialGetHash(), differs from
+ * the pMd5 field of uSecurityCredentialSync_t.  Reading a hash is
+ * a short AT exchange whereas storing a credential sends all of
+ * its contents, so calling this at every start-up in place of
+ * uSecurityCredentialStore() saves a great deal of traffic with
+ * the module when, as is usual, nothing has changed.
+ *
+ * @param devHandle            the handle of the instance to be used,
+ *                             for example obtained using uDeviceOpen().
+ * @param[in] pCredentials     pointer to an array of numCredentials
+ *                             credentials; cannot be NULL.
+ * @param numCredentials       the number of entries at pCredentials.
+ * @return                     on success the number of credentials
+ *                             that had to be stored, else negative
+ *                             error code; if an error occurs part
+ *                             way through, the credentials before it
+ *                             will have been synchronised.
+ */
+int32_t uSecurityCredentialSync(uDeviceHandle_t devHandle,
+                                const uSecurityCredentialSync_t *pCredentials,
+                                size_t numCredentials);
+
 /** Get the description of the first X.509 certificate or security key
  * from storage; uSecurityCredentialListNext() should be called repeatedly
  * to iterate through subsequent entries in the list.  This function
@@ -78,6 +78,23 @@ extern "C" {
 # define U_SECURITY_TLS_SNI_MAX_LENGTH_BYTES 128
 #endif
 
+#ifndef U_SECURITY_TLS_PROFILE_CACHE_SIZE
+/** The number of configured cellular security profiles that are
+ * kept, rather than freed, by uSecurityTlsRemove() so that a
+ * later pUSecurityTlsAdd() for the same device with identical
+ * settings, e.g. when a socket or MQTT connection is re-made,
+ * can use the profile as it is without configuring it again;
+ * reusing the same profile also allows the module to resume the
+ * TLS session if enableSessionResumption is set.  A cached
+ * profile occupies one of the module's security profiles, which
+ * will be given up if a new profile is needed.  Set to 0 to
+ * disable the cache.  Call uSecurityTlsCleanUp() to empty the
+ * cache, e.g. if the module has been restored to factory
+ * settings.
+ */
+# define U_SECURITY_TLS_PROFILE_CACHE_SIZE 2
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -357,8 +374,12 @@ typedef struct {
                            negotiation, maximum length #U_SECURITY_TLS_SNI_MAX_LENGTH_BYTES;
                            this is optional on cellular modules while for Wifi modules it
                            is set automatically if the connect string is a URL. */
-    bool enableSessionResumption; /**< set to true to enable session resumption; currently
-                                       only false is supported. */
+    bool enableSessionResumption; /**< set to true to enable session resumption, where
+                                       the module resumes a previous TLS session with
+                                       the server rather than performing a full
+                                       handshake; supported on SARA-R5, SARA-R422 and
+                                       LARA-R6 cellular modules only, see also
+                                       #U_SECURITY_TLS_PROFILE_CACHE_SIZE. */
     bool useDeviceCertificate; /**< if this is set to true then pClientCertificateName should
                                     be set to NULL and instead, for a module that supports
                                     u-blox security and has been security sealed, the device
@@ -404,6 +425,9 @@ typedef struct uSecurityTlsContext_t {
                                  which will be passed to the BLE/Cellular/Wifi
                                  layer (appropriately cast) when this security
                                  context is used. */
+    char *pSettingsKey;     /**< for internal use: a flattened copy of the
+                                 settings, used to find a cached profile. */
+    size_t settingsKeySize; /**< for internal use: the size of pSettingsKey. */
 } uSecurityTlsContext_t;
 
 /* ----------------------------------------------------------------
@@ -451,7 +475,9 @@ void uSecurityTlsRemove(uSecurityTlsContext_t *pContext);
 
 /** Clean-up memory from TLS security contexts.
  * pUSecurityTlsAdd() creates a mutex, if not already created,
- * to ensure thread-safety.  This function may be called if
+ * to ensure thread-safety; this function also frees any security
+ * profiles held in the cache, see
+ * #U_SECURITY_TLS_PROFILE_CACHE_SIZE.  This function may be called if
  * you're completely done with TLS security in order to free
  * the memory held by that mutex once more.  This function
  * should not be called at the same time as any of the other
@@ -459,6 +485,16 @@ void uSecurityTlsRemove(uSecurityTlsContext_t *pContext);
  */
 void uSecurityTlsCleanUp();
 
+/** Free any security profiles belonging to the given device that
+ * are held in the cache, see #U_SECURITY_TLS_PROFILE_CACHE_SIZE.
+ * IMPORTANT: this function is NOT INTENDED FOR CUSTOMER USE.  It is
+ * called internally by the device API when a device is closed, since
+ * the cached profiles cannot be used once the device has gone.
+ *
+ * @param devHandle the handle of the device.
+ */
+void uSecurityTlsCleanUpDevice(uDeviceHandle_t devHandle);
+
 #ifdef __cplusplus
 }
 #endif
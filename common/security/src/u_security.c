@@ -130,6 +130,7 @@
 # include "u_cfg_override.h" // For a customer's configuration override
 #endif
 
+#include "stdlib.h"    // malloc(), free()
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
@@ -424,6 +425,74 @@ int32_t uSecurityE2eEncrypt(uDeviceHandle_t devHandle,
     return errorCode;
 }
 
+// Encrypt a block of data of any size in chunks.
+int32_t uSecurityE2eEncryptStream(uDeviceHandle_t devHandle,
+                                  const void *pDataIn,
+                                  size_t dataSizeBytes,
+                                  void *pBuffer,
+                                  size_t bufferSizeBytes,
+                                  int32_t (*pCallback) (uDeviceHandle_t,
+                                                        const void *,
+                                                        size_t,
+                                                        void *),
+                                  void *pCallbackParam)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    void *pBufferMalloced = NULL;
+    const char *pIn = (const char *) pDataIn;
+    size_t chunkSizeBytes;
+    size_t thisSizeBytes;
+    int32_t sizeOut = 0;
+    int32_t x;
+
+    if ((pDataIn != NULL) && (pCallback != NULL) &&
+        ((pBuffer == NULL) || (bufferSizeBytes > U_SECURITY_E2E_HEADER_LENGTH_MAX_BYTES))) {
+        errorCodeOrSize = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        if (pBuffer == NULL) {
+            bufferSizeBytes = U_SECURITY_E2E_STREAM_CHUNK_MAX_LENGTH_BYTES +
+                              U_SECURITY_E2E_HEADER_LENGTH_MAX_BYTES;
+            pBufferMalloced = malloc(bufferSizeBytes);
+            pBuffer = pBufferMalloced;
+        }
+        if (pBuffer != NULL) {
+            errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+            chunkSizeBytes = bufferSizeBytes - U_SECURITY_E2E_HEADER_LENGTH_MAX_BYTES;
+            if (chunkSizeBytes > U_SECURITY_E2E_STREAM_CHUNK_MAX_LENGTH_BYTES) {
+                chunkSizeBytes = U_SECURITY_E2E_STREAM_CHUNK_MAX_LENGTH_BYTES;
+            }
+            while ((errorCodeOrSize == 0) && (dataSizeBytes > 0)) {
+                thisSizeBytes = dataSizeBytes;
+                if (thisSizeBytes > chunkSizeBytes) {
+                    thisSizeBytes = chunkSizeBytes;
+                }
+                // Encrypt a chunk and pass it on; the encryption
+                // has released the device by the time the callback
+                // is called, so the callback is free to send the
+                // chunk through the same device
+                x = uSecurityE2eEncrypt(devHandle, pIn, pBuffer, thisSizeBytes);
+                if (x >= 0) {
+                    sizeOut += x;
+                    x = pCallback(devHandle, pBuffer, (size_t) x, pCallbackParam);
+                    if (x >= 0) {
+                        pIn += thisSizeBytes;
+                        dataSizeBytes -= thisSizeBytes;
+                    } else {
+                        errorCodeOrSize = x;
+                    }
+                } else {
+                    errorCodeOrSize = x;
+                }
+            }
+            if (errorCodeOrSize == 0) {
+                errorCodeOrSize = sizeOut;
+            }
+        }
+        free(pBufferMalloced);
+    }
+
+    return errorCodeOrSize;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: PRE-SHARED KEY GENERATION
  * -------------------------------------------------------------- */
@@ -36,7 +36,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // strlen(), strtol()
+#include "string.h"    // strlen(), strtol(), memcmp()
 #include "time.h"      // struct tm
 #include "ctype.h"     // isprint(), isblank()
 
@@ -47,6 +47,7 @@
 #include "u_port_clib_platform_specific.h" // isblank() in some cases
 #include "u_port_clib_mktime64.h"
 #include "u_port.h"
+#include "u_port_debug.h"
 #include "u_port_os.h"
 
 #include "u_at_client.h"
@@ -316,23 +317,26 @@ static size_t stripWhitespace(char *pString, size_t stringLength)
     return newLength;
 }
 
-/* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS
- * -------------------------------------------------------------- */
-
-// Store the given X.509 certificate or security key.
-int32_t uSecurityCredentialStore(uDeviceHandle_t devHandle,
-                                 uSecurityCredentialType_t type,
-                                 const char *pName,
-                                 const char *pContents,
-                                 size_t size,
-                                 const char *pPassword,
-                                 char *pMd5)
+// Store a credential, either from pContents or, if that is NULL
+// and pCallback is not, read in chunks from pCallback into
+// pChunkBuffer.
+static int32_t store(uDeviceHandle_t devHandle,
+                     uSecurityCredentialType_t type,
+                     const char *pName,
+                     const char *pContents,
+                     size_t size,
+                     const char *pPassword,
+                     uSecurityCredentialStoreCallback_t pCallback,
+                     void *pCallbackParameter,
+                     char *pChunkBuffer, size_t chunkSizeBytes,
+                     char *pMd5)
 {
     uAtClientHandle_t atHandle;
     int32_t errorCode = getAtClient(devHandle, &atHandle);
     char hashHexRead[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES * 2 + 1]; // +1 for terminator
     int32_t hashHexReadSize;
+    int32_t chunkLength = 0;
+    size_t wanted;
 
     if (errorCode == 0) {
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
@@ -344,10 +348,10 @@ int32_t uSecurityCredentialStore(uDeviceHandle_t devHandle,
             ((size > 0) || (pContents == NULL)) &&
             (size <= U_SECURITY_CREDENTIAL_MAX_LENGTH_BYTES) &&
             ((pPassword == NULL) ||
-             ((pContents != NULL) &&
+             (((pContents != NULL) || (pCallback != NULL)) &&
               (type == U_SECURITY_CREDENTIAL_CLIENT_KEY_PRIVATE) &&
               (strlen(pPassword) <= U_SECURITY_CREDENTIAL_PASSWORD_MAX_LENGTH_BYTES)))) {
-            if (pContents != NULL) {
+            if ((pContents != NULL) || (pCallback != NULL)) {
                 errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
                 // Do the USECMNG thang with the AT interface
                 uAtClientLock(atHandle);
@@ -372,7 +376,27 @@ int32_t uSecurityCredentialStore(uDeviceHandle_t devHandle,
                     // Wait for it...
                     uPortTaskBlock(50);
                     // Write the contents
-                    uAtClientWriteBytes(atHandle, pContents, size, true);
+                    if (pContents != NULL) {
+                        uAtClientWriteBytes(atHandle, pContents, size, true);
+                    } else {
+                        // Only a chunk at a time need be in RAM; if the
+                        // source runs dry early there is no way to
+                        // abort, the module will time out and return
+                        // an error
+                        for (size_t offset = 0; (offset < size) && (chunkLength >= 0);
+                             offset += (size_t) chunkLength) {
+                            wanted = size - offset < chunkSizeBytes ?
+                                     size - offset : chunkSizeBytes;
+                            chunkLength = pCallback(pChunkBuffer, wanted, offset,
+                                                    pCallbackParameter);
+                            if ((chunkLength <= 0) || ((size_t) chunkLength > wanted)) {
+                                chunkLength = -1;
+                            } else {
+                                uAtClientWriteBytes(atHandle, pChunkBuffer,
+                                                    (size_t) chunkLength, true);
+                            }
+                        }
+                    }
                     // Grab the response
                     uAtClientResponseStart(atHandle, "+USECMNG:");
                     // Skip the first three parameters
@@ -382,7 +406,7 @@ int32_t uSecurityCredentialStore(uDeviceHandle_t devHandle,
                                                           sizeof(hashHexRead),
                                                           false);
                     uAtClientResponseStop(atHandle);
-                    if ((uAtClientUnlock(atHandle) == 0) &&
+                    if ((uAtClientUnlock(atHandle) == 0) && (chunkLength >= 0) &&
                         (hashHexReadSize == sizeof(hashHexRead) - 1)) {
                         // Convert the hash into a binary sequence and write
                         // it to pMd5
@@ -410,6 +434,53 @@ int32_t uSecurityCredentialStore(uDeviceHandle_t devHandle,
     return errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Store the given X.509 certificate or security key.
+int32_t uSecurityCredentialStore(uDeviceHandle_t devHandle,
+                                 uSecurityCredentialType_t type,
+                                 const char *pName,
+                                 const char *pContents,
+                                 size_t size,
+                                 const char *pPassword,
+                                 char *pMd5)
+{
+    return store(devHandle, type, pName, pContents, size, pPassword,
+                 NULL, NULL, NULL, 0, pMd5);
+}
+
+// Store the given X.509 certificate or security key, read in chunks.
+int32_t uSecurityCredentialStoreStream(uDeviceHandle_t devHandle,
+                                       uSecurityCredentialType_t type,
+                                       const char *pName,
+                                       size_t size,
+                                       const char *pPassword,
+                                       uSecurityCredentialStoreCallback_t pCallback,
+                                       void *pCallbackParameter,
+                                       char *pMd5)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    char *pChunkBuffer;
+
+    if ((pCallback != NULL) && (size > 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        // Allocated here, rather than on the stack, and before the
+        // AT client is locked
+        pChunkBuffer = (char *) malloc(U_SECURITY_CREDENTIAL_STREAM_CHUNK_LENGTH_BYTES);
+        if (pChunkBuffer != NULL) {
+            errorCode = store(devHandle, type, pName, NULL, size, pPassword,
+                              pCallback, pCallbackParameter, pChunkBuffer,
+                              U_SECURITY_CREDENTIAL_STREAM_CHUNK_LENGTH_BYTES,
+                              pMd5);
+            free(pChunkBuffer);
+        }
+    }
+
+    return errorCode;
+}
+
 // Read the MD5 hash of a stored X.509 certificate
 // or security key.
 int32_t uSecurityCredentialGetHash(uDeviceHandle_t devHandle,
@@ -460,6 +531,54 @@ int32_t uSecurityCredentialGetHash(uDeviceHandle_t devHandle,
     return errorCode;
 }
 
+// Store only those credentials which are not already stored.
+int32_t uSecurityCredentialSync(uDeviceHandle_t devHandle,
+                                const uSecurityCredentialSync_t *pCredentials,
+                                size_t numCredentials)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uSecurityCredentialSync_t *pCredential;
+    char md5[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES];
+    size_t count = 0;
+
+    if ((pCredentials != NULL) || (numCredentials == 0)) {
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; (x < numCredentials) &&
+             (errorCodeOrCount == (int32_t) U_ERROR_COMMON_SUCCESS); x++) {
+            pCredential = pCredentials + x;
+            // An error reading the hash, e.g. because the credential
+            // isn't there, just means that it has to be stored
+            if ((pCredential->pMd5 == NULL) ||
+                (uSecurityCredentialGetHash(devHandle, pCredential->type,
+                                            pCredential->pName, md5) != 0) ||
+                (memcmp(md5, pCredential->pMd5, sizeof(md5)) != 0)) {
+                errorCodeOrCount = uSecurityCredentialStore(devHandle,
+                                                            pCredential->type,
+                                                            pCredential->pName,
+                                                            pCredential->pContents,
+                                                            pCredential->size,
+                                                            pCredential->pPassword,
+                                                            md5);
+                if (errorCodeOrCount == (int32_t) U_ERROR_COMMON_SUCCESS) {
+                    count++;
+                    if ((pCredential->pMd5 != NULL) &&
+                        (memcmp(md5, pCredential->pMd5, sizeof(md5)) != 0)) {
+                        // Otherwise it will be stored again every time
+                        uPortLog("U_SECURITY_CREDENTIAL: warning, MD5 hash given"
+                                 " for \"%s\" does not match that of the stored"
+                                 " credential.\n", pCredential->pName);
+                    }
+                }
+            }
+        }
+        if (errorCodeOrCount == (int32_t) U_ERROR_COMMON_SUCCESS) {
+            errorCodeOrCount = (int32_t) count;
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
 // Get the description of the first X.509 certificate or security key.
 int32_t uSecurityCredentialListFirst(uDeviceHandle_t devHandle,
                                      uSecurityCredential_t *pCredential)
@@ -35,7 +35,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // strlen()
+#include "string.h"    // strlen(), memcpy(), memcmp()
 
 #include "u_error_common.h"
 
@@ -57,6 +57,16 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A configured cellular security profile kept for reuse.
+ */
+typedef struct {
+    uDeviceHandle_t devHandle;
+    void *pNetworkSpecific; /**< NULL if this entry is not in use. */
+    char *pSettingsKey;
+    size_t settingsKeySize;
+    uint32_t age;           /**< for finding the oldest entry. */
+} uSecurityTlsProfileCacheEntry_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -65,6 +75,16 @@
  */
 static uPortMutexHandle_t gMutex = NULL;
 
+#if U_SECURITY_TLS_PROFILE_CACHE_SIZE > 0
+/** Cellular security profiles kept for reuse.
+ */
+static uSecurityTlsProfileCacheEntry_t gProfileCache[U_SECURITY_TLS_PROFILE_CACHE_SIZE] = {0};
+
+/** Incremented each time a profile is added to gProfileCache.
+ */
+static uint32_t gProfileCacheAge = 0;
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -110,14 +130,167 @@ static bool checkConfig(const uSecurityTlsSettings_t *pSettings)
          (strlen(pSettings->pExpectedServerUrl) <=
           U_SECURITY_TLS_EXPECTED_SERVER_URL_MAX_LENGTH_BYTES)) &&
         ((pSettings->pSni == NULL) || (strlen(pSettings->pSni) <=
-                                       U_SECURITY_TLS_SNI_MAX_LENGTH_BYTES)) &&
-        !pSettings->enableSessionResumption) {
+                                       U_SECURITY_TLS_SNI_MAX_LENGTH_BYTES))) {
         isGood = true;
     }
 
     return isGood;
 }
 
+// Append something to a settings key at offset, or just count its
+// size if pKey is NULL, returning the new offset.
+static size_t keyAppend(char *pKey, size_t offset, const void *pData, size_t size)
+{
+    if ((pKey != NULL) && (size > 0)) {
+        memcpy(pKey + offset, pData, size);
+    }
+
+    return offset + size;
+}
+
+// Append a string, or binary sequence, to a settings key,
+// length first so that the key can't be ambiguous; a NULL pointer
+// is distinguished from an empty string.
+static size_t keyAppendBinary(char *pKey, size_t offset, const char *pData, size_t size)
+{
+    size_t length = SIZE_MAX;
+
+    if (pData != NULL) {
+        length = size;
+    }
+    offset = keyAppend(pKey, offset, &length, sizeof(length));
+
+    return keyAppend(pKey, offset, pData, pData != NULL ? size : 0);
+}
+
+// As keyAppendBinary() but for a null-terminated string.
+static size_t keyAppendString(char *pKey, size_t offset, const char *pString)
+{
+    return keyAppendBinary(pKey, offset, pString, pString != NULL ? strlen(pString) : 0);
+}
+
+// Flatten the settings into pKey, which may be NULL to obtain
+// the size required; the settings are copied field by field,
+// following what the pointers point to, so that two sets of
+// settings which would configure a profile in the same way give
+// the same key.
+static size_t settingsKey(const uSecurityTlsSettings_t *pSettings, char *pKey)
+{
+    size_t offset = 0;
+    bool isPresent = (pSettings != NULL);
+
+    offset = keyAppend(pKey, offset, &isPresent, sizeof(isPresent));
+    if (pSettings != NULL) {
+        offset = keyAppend(pKey, offset, &pSettings->tlsVersionMin,
+                           sizeof(pSettings->tlsVersionMin));
+        offset = keyAppendString(pKey, offset, pSettings->pRootCaCertificateName);
+        offset = keyAppendString(pKey, offset, pSettings->pClientCertificateName);
+        offset = keyAppendString(pKey, offset, pSettings->pClientPrivateKeyName);
+        offset = keyAppend(pKey, offset, &pSettings->certificateCheck,
+                           sizeof(pSettings->certificateCheck));
+        offset = keyAppendString(pKey, offset, pSettings->pClientPrivateKeyPassword);
+        offset = keyAppend(pKey, offset, &pSettings->cipherSuites.num,
+                           sizeof(pSettings->cipherSuites.num));
+        offset = keyAppend(pKey, offset, pSettings->cipherSuites.suite,
+                           pSettings->cipherSuites.num * sizeof(pSettings->cipherSuites.suite[0]));
+        offset = keyAppendBinary(pKey, offset, pSettings->psk.pBin, pSettings->psk.size);
+        offset = keyAppendBinary(pKey, offset, pSettings->pskId.pBin, pSettings->pskId.size);
+        offset = keyAppend(pKey, offset, &pSettings->pskGeneratedByRoT,
+                           sizeof(pSettings->pskGeneratedByRoT));
+        offset = keyAppendString(pKey, offset, pSettings->pExpectedServerUrl);
+        offset = keyAppendString(pKey, offset, pSettings->pSni);
+        offset = keyAppend(pKey, offset, &pSettings->enableSessionResumption,
+                           sizeof(pSettings->enableSessionResumption));
+        offset = keyAppend(pKey, offset, &pSettings->useDeviceCertificate,
+                           sizeof(pSettings->useDeviceCertificate));
+        offset = keyAppend(pKey, offset, &pSettings->includeCaCertificates,
+                           sizeof(pSettings->includeCaCertificates));
+    }
+
+    return offset;
+}
+
+#if U_SECURITY_TLS_PROFILE_CACHE_SIZE > 0
+
+// Free the profile in a cache entry and empty the entry.
+static void profileCacheEntryFree(uSecurityTlsProfileCacheEntry_t *pEntry)
+{
+    if (pEntry->pNetworkSpecific != NULL) {
+        uCellSecTlsRemove((uCellSecTlsContext_t *) pEntry->pNetworkSpecific);
+    }
+    free(pEntry->pSettingsKey);
+    memset(pEntry, 0, sizeof(*pEntry));
+}
+
+// Take a profile configured with the given settings key out of
+// the cache, returning NULL if there isn't one.
+static void *pProfileCacheTake(uDeviceHandle_t devHandle,
+                               const char *pSettingsKey, size_t settingsKeySize)
+{
+    void *pNetworkSpecific = NULL;
+    uSecurityTlsProfileCacheEntry_t *pEntry;
+
+    for (size_t x = 0; (x < U_SECURITY_TLS_PROFILE_CACHE_SIZE) &&
+         (pNetworkSpecific == NULL); x++) {
+        pEntry = &(gProfileCache[x]);
+        if ((pEntry->pNetworkSpecific != NULL) && (pEntry->devHandle == devHandle) &&
+            (pEntry->settingsKeySize == settingsKeySize) &&
+            (memcmp(pEntry->pSettingsKey, pSettingsKey, settingsKeySize) == 0)) {
+            pNetworkSpecific = pEntry->pNetworkSpecific;
+            // The profile is now owned by the caller
+            pEntry->pNetworkSpecific = NULL;
+            profileCacheEntryFree(pEntry);
+        }
+    }
+
+    return pNetworkSpecific;
+}
+
+// Put a configured profile into the cache, giving it, and its
+// settings key, to the cache; if the cache is full the oldest
+// profile is freed.
+static void profileCachePut(uDeviceHandle_t devHandle, void *pNetworkSpecific,
+                            char *pSettingsKey, size_t settingsKeySize)
+{
+    uSecurityTlsProfileCacheEntry_t *pEntry = &(gProfileCache[0]);
+
+    for (size_t x = 0; (x < U_SECURITY_TLS_PROFILE_CACHE_SIZE) &&
+         (pEntry->pNetworkSpecific != NULL); x++) {
+        if ((gProfileCache[x].pNetworkSpecific == NULL) ||
+            (gProfileCacheAge - gProfileCache[x].age > gProfileCacheAge - pEntry->age)) {
+            pEntry = &(gProfileCache[x]);
+        }
+    }
+    profileCacheEntryFree(pEntry);
+    pEntry->devHandle = devHandle;
+    pEntry->pNetworkSpecific = pNetworkSpecific;
+    pEntry->pSettingsKey = pSettingsKey;
+    pEntry->settingsKeySize = settingsKeySize;
+    pEntry->age = gProfileCacheAge;
+    gProfileCacheAge++;
+}
+
+// Free the profiles in the cache that belong to the given device,
+// or all of them if devHandle is NULL, returning true if any
+// were freed.
+static bool profileCacheClear(uDeviceHandle_t devHandle)
+{
+    bool freed = false;
+
+    for (size_t x = 0; x < U_SECURITY_TLS_PROFILE_CACHE_SIZE; x++) {
+        if ((devHandle == NULL) || (gProfileCache[x].devHandle == devHandle)) {
+            if (gProfileCache[x].pNetworkSpecific != NULL) {
+                freed = true;
+            }
+            profileCacheEntryFree(&(gProfileCache[x]));
+        }
+    }
+
+    return freed;
+}
+
+#endif // #if U_SECURITY_TLS_PROFILE_CACHE_SIZE > 0
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -134,6 +307,8 @@ uSecurityTlsContext_t *pUSecurityTlsAdd(uDeviceHandle_t devHandle,
     const char *pClientPrivateKeyName = NULL;
     bool certificateCheckOn = false;
     uSecurityTlsVersion_t tlsVersionMin = U_SECURITY_TLS_VERSION_ANY;
+    char *pSettingsKey = NULL;
+    size_t settingsKeySize = 0;
 
     if ((errorCode == 0) && (pContext != NULL)) {
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
@@ -175,9 +350,37 @@ uSecurityTlsContext_t *pUSecurityTlsAdd(uDeviceHandle_t devHandle,
                 }
             } else if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                settingsKeySize = settingsKey(pSettings, NULL);
+                pSettingsKey = (char *) malloc(settingsKeySize);
+                if (pSettingsKey != NULL) {
+                    settingsKey(pSettings, pSettingsKey);
+                }
+#if U_SECURITY_TLS_PROFILE_CACHE_SIZE > 0
+                if (pSettingsKey != NULL) {
+                    // A profile configured in just this way may
+                    // be waiting in the cache
+                    pNetworkSpecific = pProfileCacheTake(devHandle, pSettingsKey,
+                                                         settingsKeySize);
+                }
+                if (pNetworkSpecific == NULL) {
+                    // Allocate a cellular security context with
+                    // default settings
+                    pNetworkSpecific = (void *) pUCellSecSecTlsAdd(devHandle);
+                    if ((pNetworkSpecific == NULL) && profileCacheClear(devHandle)) {
+                        // The module may have run out of profiles
+                        // because the cache was holding them
+                        uCellSecTlsResetLastError();
+                        pNetworkSpecific = (void *) pUCellSecSecTlsAdd(devHandle);
+                    }
+                } else {
+                    // Nothing more to do
+                    pSettings = NULL;
+                }
+#else
                 // Allocate a cellular security context with
                 // default settings
                 pNetworkSpecific = (void *) pUCellSecSecTlsAdd(devHandle);
+#endif
                 if (pNetworkSpecific == NULL) {
                     errorCode = uCellSecTlsResetLastError();
                 } else {
@@ -245,6 +448,11 @@ uSecurityTlsContext_t *pUSecurityTlsAdd(uDeviceHandle_t devHandle,
                             errorCode = uCellSecTlsUseDeviceCertificateSet((uCellSecTlsContext_t *) pNetworkSpecific,
                                                                            pSettings->includeCaCertificates);
                         }
+                        if ((errorCode == 0) && (pSettings->enableSessionResumption)) {
+                            // Switch on session resumption
+                            errorCode = uCellSecTlsSessionResumptionSet((uCellSecTlsContext_t *) pNetworkSpecific,
+                                                                        true);
+                        }
                     }
                 }
             } else if (devType < 0) {
@@ -260,7 +468,14 @@ uSecurityTlsContext_t *pUSecurityTlsAdd(uDeviceHandle_t devHandle,
         pContext->errorCode = errorCode;
         pContext->devHandle = devHandle;
         pContext->pNetworkSpecific = pNetworkSpecific;
+        if (errorCode == 0) {
+            // Keep the key so that the profile can be cached
+            pContext->pSettingsKey = pSettingsKey;
+            pContext->settingsKeySize = settingsKeySize;
+            pSettingsKey = NULL;
+        }
     }
+    free(pSettingsKey);
 
     return pContext;
 }
@@ -276,8 +491,21 @@ void uSecurityTlsRemove(uSecurityTlsContext_t *pContext)
         if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
             uShortRangeSecTlsRemove((uShortRangeSecTlsContext_t *) pContext->pNetworkSpecific);
         } else if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+#if U_SECURITY_TLS_PROFILE_CACHE_SIZE > 0
+            if ((pContext->errorCode == 0) && (pContext->pNetworkSpecific != NULL) &&
+                (pContext->pSettingsKey != NULL)) {
+                // Keep the configured profile for next time
+                profileCachePut(pContext->devHandle, pContext->pNetworkSpecific,
+                                pContext->pSettingsKey, pContext->settingsKeySize);
+                pContext->pSettingsKey = NULL;
+            } else {
+                uCellSecTlsRemove((uCellSecTlsContext_t *) pContext->pNetworkSpecific);
+            }
+#else
             uCellSecTlsRemove((uCellSecTlsContext_t *) pContext->pNetworkSpecific);
+#endif
         }
+        free(pContext->pSettingsKey);
         free(pContext);
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -289,10 +517,27 @@ void uSecurityTlsCleanUp()
 {
     if (gMutex != NULL) {
         U_PORT_MUTEX_LOCK(gMutex);
+#if U_SECURITY_TLS_PROFILE_CACHE_SIZE > 0
+        profileCacheClear(NULL);
+#endif
         U_PORT_MUTEX_UNLOCK(gMutex);
         uPortMutexDelete(gMutex);
         gMutex = NULL;
     }
 }
 
+// Free any cached security profiles belonging to a device.
+void uSecurityTlsCleanUpDevice(uDeviceHandle_t devHandle)
+{
+#if U_SECURITY_TLS_PROFILE_CACHE_SIZE > 0
+    if (gMutex != NULL) {
+        U_PORT_MUTEX_LOCK(gMutex);
+        profileCacheClear(devHandle);
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+#else
+    (void) devHandle;
+#endif
+}
+
 // End of file
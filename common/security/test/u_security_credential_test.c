@@ -33,7 +33,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // strcmp()
+#include "string.h"    // strcmp(), memcpy()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_app_platform_specific.h"
@@ -119,6 +119,20 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Callback for uSecurityCredentialStoreStream(): copy the next
+// chunk out of the credential array, deliberately giving less than
+// asked for now and again to check that a short chunk is handled.
+static int32_t storeStreamCallback(char *pBuffer, size_t size,
+                                   size_t offset, void *pCallbackParameter)
+{
+    if ((size > 1) && ((offset % 3) == 0)) {
+        size--;
+    }
+    memcpy(pBuffer, ((const char *) pCallbackParameter) + offset, size);
+
+    return (int32_t) size;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -215,6 +229,7 @@ U_PORT_TEST_FUNCTION("[securityCredential]", "securityCredentialTest")
     int32_t z;
     char hash[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES];
     char buffer[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES];
+    uSecurityCredentialSync_t syncCredential;
 
     // In case a previous test failed
     uNetworkTestCleanUp();
@@ -292,6 +307,32 @@ U_PORT_TEST_FUNCTION("[securityCredential]", "securityCredentialTest")
             U_PORT_TEST_ASSERT((uint8_t) buffer[y] == hash[y]);
         }
 
+        // Synchronise: with the right hash nothing should be stored,
+        // with the wrong hash the certificate should be stored again
+        U_TEST_PRINT_LINE_X("synchronising certificate...", x);
+        syncCredential.type = U_SECURITY_CREDENTIAL_CLIENT_X509;
+        syncCredential.pName = "ubxlib_test_cert";
+        syncCredential.pContents = (const char *) gUSecurityCredentialTestClientX509Pem;
+        syncCredential.size = gUSecurityCredentialTestClientX509PemSize;
+        syncCredential.pPassword = NULL;
+        syncCredential.pMd5 = hash;
+        U_PORT_TEST_ASSERT(uSecurityCredentialSync(devHandle, &syncCredential, 1) == 0);
+        memcpy(buffer, hash, sizeof(buffer));
+        buffer[0] = (char) ~buffer[0];
+        syncCredential.pMd5 = buffer;
+        U_PORT_TEST_ASSERT(uSecurityCredentialSync(devHandle, &syncCredential, 1) == 1);
+
+        // Store it again, streaming it this time: the hash should not change
+        U_TEST_PRINT_LINE_X("streaming certificate...", x);
+        U_PORT_TEST_ASSERT(uSecurityCredentialStoreStream(devHandle,
+                                                          U_SECURITY_CREDENTIAL_CLIENT_X509,
+                                                          "ubxlib_test_cert",
+                                                          gUSecurityCredentialTestClientX509PemSize,
+                                                          NULL, storeStreamCallback,
+                                                          (void *) gUSecurityCredentialTestClientX509Pem,
+                                                          buffer) == 0);
+        U_PORT_TEST_ASSERT(memcmp(buffer, hash, sizeof(buffer)) == 0);
+
         // Check that the certificate is listed
         U_TEST_PRINT_LINE_X("listing credentials...", x);
         z = 0;
@@ -166,6 +166,12 @@ static const char gAllChars[] = "the quick brown fox jumps over the lazy dog "
                                 "\x0f\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c"
                                 "\x1d\x1e!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~\x7f";
 
+// The number of chunks passed to e2eStreamCallback().
+static size_t gE2eStreamChunks = 0;
+
+// The number of bytes passed to e2eStreamCallback().
+static size_t gE2eStreamBytes = 0;
+
 #ifdef U_CFG_TEST_SECURITY_C2C_TE_SECRET
 /** Data to exchange in a sockets test.
  */
@@ -208,6 +214,21 @@ char *gpBuffer = NULL;
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Callback for uSecurityE2eEncryptStream().
+static int32_t e2eStreamCallback(uDeviceHandle_t devHandle,
+                                 const void *pData, size_t size,
+                                 void *pCallbackParam)
+{
+    (void) devHandle;
+    (void) pData;
+    (void) pCallbackParam;
+
+    gE2eStreamChunks++;
+    gE2eStreamBytes += size;
+
+    return 0;
+}
+
 #ifdef U_CFG_SECURITY_DEVICE_PROFILE_UID
 // Callback function for the security sealing processes.
 static bool keepGoingCallback()
@@ -1105,6 +1126,26 @@ U_PORT_TEST_FUNCTION("[security]", "securityE2eEncryption")
                 //lint -e(668) Suppress possible NULL pointer, it is checked above
                 U_PORT_TEST_ASSERT(memcmp(pData, gAllChars, sizeof(gAllChars)) != 0);
                 free(pData);
+
+                // Do it again, streamed, in chunks of a quarter
+                // of the size, or a little more
+                pData = malloc((sizeof(gAllChars) / 4) + U_SECURITY_E2E_HEADER_LENGTH_MAX_BYTES);
+                U_PORT_TEST_ASSERT(pData != NULL);
+                gE2eStreamChunks = 0;
+                gE2eStreamBytes = 0;
+                U_TEST_PRINT_LINE("requesting streamed end to end encryption of %d"
+                                  " byte(s) of data...", sizeof(gAllChars));
+                y = uSecurityE2eEncryptStream(devHandle, gAllChars, sizeof(gAllChars),
+                                              pData, (sizeof(gAllChars) / 4) +
+                                              U_SECURITY_E2E_HEADER_LENGTH_MAX_BYTES,
+                                              e2eStreamCallback, NULL);
+                U_TEST_PRINT_LINE("%d byte(s) of data returned in %d chunk(s).",
+                                  y, gE2eStreamChunks);
+                U_PORT_TEST_ASSERT((gE2eStreamChunks >= 4) && (gE2eStreamChunks <= 5));
+                U_PORT_TEST_ASSERT(y == (int32_t) gE2eStreamBytes);
+                U_PORT_TEST_ASSERT(y == (int32_t) sizeof(gAllChars) +
+                                   (headerLengthBytes * (int32_t) gE2eStreamChunks));
+                free(pData);
             } else {
                 U_TEST_PRINT_LINE("this device supports u-blox security but has not"
                                   " been security sealed, no testing of end to end"
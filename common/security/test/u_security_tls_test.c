@@ -489,6 +489,131 @@ U_PORT_TEST_FUNCTION("[securityTls]", "securityTlsSock")
 #endif
 }
 
+#if U_SECURITY_TLS_PROFILE_CACHE_SIZE > 0
+/** Check that a cellular security profile is kept and reused when
+ * the settings are the same, and not when they differ.
+ */
+U_PORT_TEST_FUNCTION("[securityTls]", "securityTlsProfileCache")
+{
+    uNetworkTestList_t *pList;
+    uSecurityTlsContext_t *pContext;
+    void *pNetworkSpecific;
+    int32_t heapUsed;
+    uSecurityTlsSettings_t settings = U_SECURITY_TLS_SETTINGS_DEFAULT;
+    char serverUrl[] = "ubxlib.com";
+
+    // In case a previous test failed
+    uNetworkTestCleanUp();
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uDeviceInit() == 0);
+
+    // Get a list of things that support secure sockets
+    pList = pUNetworkTestListAlloc(uNetworkTestHasSecureSock);
+    if (pList == NULL) {
+        U_TEST_PRINT_LINE("*** WARNING *** nothing to do.");
+    }
+    // Open the devices that are not already open
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (*pTmp->pDevHandle == NULL) {
+            U_TEST_PRINT_LINE("adding device %s for network %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType],
+                              gpUNetworkTestTypeName[pTmp->networkType]);
+            U_PORT_TEST_ASSERT(uDeviceOpen(pTmp->pDeviceCfg, pTmp->pDevHandle) == 0);
+        }
+    }
+
+    // Only cellular devices have a profile cache
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (pTmp->pDeviceCfg->deviceType != U_DEVICE_TYPE_CELL) {
+            continue;
+        }
+        U_TEST_PRINT_LINE("testing the profile cache on %s...",
+                          gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType]);
+        settings.pExpectedServerUrl = "ubxlib.com";
+        pContext = pUSecurityTlsAdd(*pTmp->pDevHandle, &settings);
+        U_PORT_TEST_ASSERT(pContext != NULL);
+        U_PORT_TEST_ASSERT(pContext->errorCode == 0);
+        pNetworkSpecific = pContext->pNetworkSpecific;
+        U_PORT_TEST_ASSERT(pNetworkSpecific != NULL);
+        uSecurityTlsRemove(pContext);
+
+        // The same settings, though the string is at a different
+        // address, should get the same profile back
+        settings.pExpectedServerUrl = serverUrl;
+        pContext = pUSecurityTlsAdd(*pTmp->pDevHandle, &settings);
+        U_PORT_TEST_ASSERT(pContext != NULL);
+        U_PORT_TEST_ASSERT(pContext->errorCode == 0);
+        U_PORT_TEST_ASSERT(pContext->pNetworkSpecific == pNetworkSpecific);
+
+        // Different settings while that is in use must get
+        // a different profile
+        settings.pExpectedServerUrl = "www.u-blox.com";
+        uSecurityTlsContext_t *pContextOther = pUSecurityTlsAdd(*pTmp->pDevHandle,
+                                                                &settings);
+        U_PORT_TEST_ASSERT(pContextOther != NULL);
+        U_PORT_TEST_ASSERT(pContextOther->errorCode == 0);
+        U_PORT_TEST_ASSERT(pContextOther->pNetworkSpecific != NULL);
+        U_PORT_TEST_ASSERT(pContextOther->pNetworkSpecific != pNetworkSpecific);
+        uSecurityTlsRemove(pContextOther);
+        uSecurityTlsRemove(pContext);
+
+        // Changing any part of the settings means no match
+        settings.pExpectedServerUrl = serverUrl;
+        settings.tlsVersionMin = U_SECURITY_TLS_VERSION_1_2;
+        pContext = pUSecurityTlsAdd(*pTmp->pDevHandle, &settings);
+        U_PORT_TEST_ASSERT(pContext != NULL);
+        U_PORT_TEST_ASSERT(pContext->errorCode == 0);
+        U_PORT_TEST_ASSERT(pContext->pNetworkSpecific != pNetworkSpecific);
+        uSecurityTlsRemove(pContext);
+        settings.tlsVersionMin = U_SECURITY_TLS_VERSION_ANY;
+
+        // Emptying the cache must give the profiles back; adding
+        // again must still work
+        uSecurityTlsCleanUp();
+        pContext = pUSecurityTlsAdd(*pTmp->pDevHandle, &settings);
+        U_PORT_TEST_ASSERT(pContext != NULL);
+        U_PORT_TEST_ASSERT(pContext->errorCode == 0);
+        uSecurityTlsRemove(pContext);
+    }
+
+    // Close the devices once more, which will empty the cache,
+    // and free the list
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (*pTmp->pDevHandle != NULL) {
+            U_TEST_PRINT_LINE("closing device %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType]);
+            U_PORT_TEST_ASSERT(uDeviceClose(*pTmp->pDevHandle, false) == 0);
+            *pTmp->pDevHandle = NULL;
+        }
+    }
+    uNetworkTestListFree();
+
+    uSecurityTlsCleanUp();
+    uDeviceDeinit();
+    uPortDeinit();
+
+#if !defined(__XTENSA__) && !defined(ARDUINO)
+    // Check for memory leaks
+    // TODO: this if'ed out for ESP32 (xtensa compiler or Arduino)
+    // at the moment as there is an issue with ESP32 hanging
+    // on to memory in the UART drivers that can't easily be
+    // accounted for.
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+#else
+    (void) heapUsed;
+#endif
+}
+#endif
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -50,6 +50,39 @@ extern "C" {
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Forward declaration of the I/O vector type of u_sock.h,
+ * used by uShortRangeEdmStreamWritev().
+ */
+struct uSockIoVec_t;
+
+/** A frame of data to be sent by uShortRangeEdmStreamWriteFrames().
+ */
+typedef struct {
+    int32_t channel;      /**< the channel to send the data on. */
+    const void *pBuffer;  /**< the data to send; cannot be NULL. */
+    size_t sizeBytes;     /**< the number of bytes at pBuffer; cannot be zero. */
+} uShortRangeEdmStreamTxFrame_t;
+
+/** Statistics on the receive side of an EDM stream, see
+ * uShortRangeEdmStreamRxStatsGet().  Receive stalls when there
+ * are no pbufs free or when the channel of a data packet is at its
+ * receive quota (see uShortRangeEdmStreamRxQuotaSet()); while it is
+ * stalled the UART receive buffer fills and, eventually, hardware
+ * flow control holds off the module.
+ */
+typedef struct {
+    int32_t stallCount;       /**< the number of times receive has stalled. */
+    int32_t quotaStallCount;  /**< how many of stallCount were because
+                                   a channel was at its receive quota. */
+    int32_t stallTimeMs;      /**< the total time spent stalled, including
+                                   any stall that is ongoing. */
+    int32_t stallTimeMaxMs;   /**< the longest single stall. */
+    bool stalled;             /**< true if receive is currently stalled. */
+    int32_t stalledChannel;   /**< if receive is currently stalled because
+                                   a channel is at its receive quota, that
+                                   channel, else -1. */
+} uShortRangeEdmStreamRxStats_t;
+
 typedef void (*uEdmAtEventCallback_t)(int32_t edmStreamHandle,
                                       uint32_t eventBitmask,
                                       void *pCallbackParameter);
@@ -75,18 +108,24 @@ typedef void (*uEdmDataEventCallback_t)(int32_t edmStreamHandle,
  * FUNCTIONS
  * -------------------------------------------------------------- */
 
-/** Initialise stream handling.
+/** Initialise stream handling; calling this again when stream
+ * handling is already initialised does nothing.
  *
  * @return  zero on success else negative error code.
  */
 int32_t uShortRangeEdmStreamInit();
 
-/** Shutdown stream handling.
+/** Shutdown stream handling; this does nothing while any stream
+ * is still open, so that one of several short range modules
+ * may be closed without affecting the others.
  */
 void uShortRangeEdmStreamDeinit();
 
 /** Open an instance. Needs an open UART instance that is not accessed
- * by any other module.
+ * by any other module.  Up to U_SHORT_RANGE_EDM_STREAM_MAX_NUM
+ * instances, each on a different UART, may be open at once, e.g. to
+ * drive more than one short range module; each has its own lock,
+ * event queue and EDM parser.
  *
  * @param uartHandle       the UART HW block to use.
  * @return                 a stream handle else negative
@@ -162,6 +201,45 @@ int32_t uShortRangeEdmStreamWrite(int32_t handle, int32_t channel,
                                   const void *pBuffer, size_t sizeBytes,
                                   uint32_t timeoutMs);
 
+/** As uShortRangeEdmStreamWrite() but with the data gathered from
+ * several fragments, described by the uSockIoVec_t type of
+ * u_sock.h; each EDM data frame carries data from as many fragments
+ * as fit, rather than there being at least one frame per fragment.
+ *
+ * @param handle      the handle of the stream instance.
+ * @param channel     the number of for the connection channel given in
+ *                    the connected event callback.
+ * @param[in] pIoVec  an array of numIoVec fragments; an entry with a
+ *                    length of zero is ignored.
+ * @param numIoVec    the number of entries at pIoVec.
+ * @param timeoutMs   timeout in ms, as for uShortRangeEdmStreamWrite().
+ * @return            the number of bytes sent or negative
+ *                    error code.
+ */
+int32_t uShortRangeEdmStreamWritev(int32_t handle, int32_t channel,
+                                   const struct uSockIoVec_t *pIoVec,
+                                   size_t numIoVec, uint32_t timeoutMs);
+
+/** Write several frames of data, each of which may be for a
+ * different channel, in order.  The EDM headers and tails and the
+ * data of as many frames as will fit are passed to the UART in a
+ * single uPortUartWritev() call.  Will block until all of the data
+ * has been written or an error has occurred.
+ *
+ * @param handle      the handle of the stream instance.
+ * @param[in] pFrames an array of numFrames frames; every channel
+ *                    must be connected.
+ * @param numFrames   the number of entries at pFrames.
+ * @param timeoutMs   timeout in ms, as for uShortRangeEdmStreamWrite();
+ *                    since the frames are sent in order, the return
+ *                    value tells the caller how far sending got.
+ * @return            the total number of bytes sent, not including
+ *                    EDM overhead, or negative error code.
+ */
+int32_t uShortRangeEdmStreamWriteFrames(int32_t handle,
+                                        const uShortRangeEdmStreamTxFrame_t *pFrames,
+                                        size_t numFrames, uint32_t timeoutMs);
+
 /** Set a callback to be called when an AT event occurs.
  * pFunction will be called asynchronously in its own task.
  *
@@ -297,6 +375,66 @@ void uShortRangeEdmStreamDataEventCallbackRemove(int32_t handle,
  */
 int32_t uShortRangeEdmStreamAtEventSend(int32_t handle, uint32_t eventBitMap);
 
+/** Set the receive quota of a data channel: the most pbuf memory that
+ * data received on the channel, and not yet consumed, may hold, so
+ * that one slow consumer, e.g. a socket that is not being read, cannot
+ * use up all of the pbufs and so hold up AT responses and the other
+ * channels.  When a data packet arrives for a channel that is at its
+ * quota, receive stalls until the consumer of the channel has read
+ * enough of what it holds; note that, the EDM stream being serial,
+ * packets behind the stalled one must wait too.  By default each data
+ * channel has a quota of U_SHORT_RANGE_EDM_RX_QUOTA_DEFAULT_PERCENT of
+ * the pbufs; the quotas return to the default when the stream is
+ * closed.
+ *
+ * @param handle     the handle of the stream instance.
+ * @param channel    the EDM channel, 0 to
+ *                   U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM - 1.
+ * @param quotaBytes the quota in bytes; zero for no quota, negative
+ *                   for the default.
+ * @return           zero on success else negative error code.
+ */
+int32_t uShortRangeEdmStreamRxQuotaSet(int32_t handle, int32_t channel,
+                                       int32_t quotaBytes);
+
+/** Set the size of the largest EDM data frame that writes to an
+ * IP or MQTT connection are split into.  When the connection is
+ * made this is U_SHORT_RANGE_EDM_STREAM_IP_FRAME_SIZE_DEFAULT_BYTES,
+ * normally the largest EDM frame (4092 bytes); the module does any
+ * TCP segmentation itself so larger frames carry less overhead per
+ * byte.  Module firmware that cannot accept frames this large, e.g.
+ * more than the 635 byte IP MTU, should be given a smaller size
+ * once the connection is made.  The frame size of a Bluetooth
+ * connection is set by the module and cannot be changed.
+ *
+ * @param handle    the handle of the stream instance.
+ * @param channel   the EDM channel of the connection.
+ * @param sizeBytes the frame size, at most 4092 bytes; zero or
+ *                  negative for the default.
+ * @return          zero on success else negative error code.
+ */
+int32_t uShortRangeEdmStreamFrameSizeSet(int32_t handle, int32_t channel,
+                                         int32_t sizeBytes);
+
+/** Get the size of the largest EDM data frame that writes to a
+ * connection are split into.
+ *
+ * @param handle  the handle of the stream instance.
+ * @param channel the EDM channel of the connection.
+ * @return        the frame size in bytes, else negative error code.
+ */
+int32_t uShortRangeEdmStreamFrameSizeGet(int32_t handle, int32_t channel);
+
+/** Get the receive statistics of the stream; they are reset when
+ * the stream is opened.
+ *
+ * @param handle      the handle of the stream instance.
+ * @param[out] pStats a place to put the statistics; cannot be NULL.
+ * @return            zero on success else negative error code.
+ */
+int32_t uShortRangeEdmStreamRxStatsGet(int32_t handle,
+                                       uShortRangeEdmStreamRxStats_t *pStats);
+
 /** Get the stack high watermark, the minimum amount of
  * free stack, in bytes, for the task at the end of the event
  * queue.
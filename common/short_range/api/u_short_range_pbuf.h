@@ -41,6 +41,61 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The largest data buffer a pbuf may have.
+ */
+#define U_SHORT_RANGE_PBUF_DATA_SIZE_MAX_BYTES 0xFFFF
+
+#ifndef U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES
+/** The size of the data buffer of the pbufs of the small size
+ * class in the default configuration, used for EDM events and the
+ * tail end of data.
+ */
+# define U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES 64
+#endif
+
+#ifndef U_SHORT_RANGE_PBUF_SMALL_COUNT
+/** The number of pbufs of the small size class in the default
+ * configuration.
+ */
+# define U_SHORT_RANGE_PBUF_SMALL_COUNT 16
+#endif
+
+#ifndef U_SHORT_RANGE_PBUF_LARGE_DATA_SIZE_BYTES
+/** The size of the data buffer of the pbufs of the large size
+ * class in the default configuration, large enough for an EDM data
+ * packet of the IP MTU (U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE), so that
+ * such a packet is held in a single pbuf.
+ */
+# define U_SHORT_RANGE_PBUF_LARGE_DATA_SIZE_BYTES 640
+#endif
+
+#ifndef U_SHORT_RANGE_PBUF_LARGE_COUNT
+/** The number of pbufs of the large size class in the default
+ * configuration.
+ */
+# define U_SHORT_RANGE_PBUF_LARGE_COUNT 5
+#endif
+
+#ifndef U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM
+/** The number of EDM channels, from zero upwards, for which the
+ * memory held in pbufs is accounted, see uShortRangePbufChannelCharge();
+ * pbufs for channels outside this range are not accounted.
+ */
+# define U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM 16
+#endif
+
+#ifndef U_SHORT_RANGE_PBUF_OWNER_MAX_NUM
+/** The number of owners, i.e. EDM streams, from zero upwards, for
+ * which the memory held in pbufs by each EDM channel is accounted
+ * separately, see uShortRangePbufChannelCharge().
+ */
+# define U_SHORT_RANGE_PBUF_OWNER_MAX_NUM 2
+#endif
+
+/** The channel of a pbuf that is not charged to any EDM channel.
+ */
+#define U_SHORT_RANGE_PBUF_CHANNEL_NONE -1
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -56,6 +111,12 @@ extern "C" {
 typedef U_PACKED_STRUCT(uShortRangePbuf_t) {
     struct uShortRangePbuf_t *pNext; /**< Used for linked list of pBuf */
     uint16_t length; /**< Number of used bytes in the data buffer */
+    uint16_t offset; /**< Offset of the used bytes from the start of the
+                          data buffer, non-zero once some have been consumed */
+    uint16_t size;   /**< Size of the data buffer */
+    int8_t channel;  /**< The EDM channel the pbuf is charged to,
+                          #U_SHORT_RANGE_PBUF_CHANNEL_NONE if none */
+    uint8_t owner;   /**< The owner of channel */
     char data[];  /**< Data buffer */
 } uShortRangePbuf_t;
 #ifdef _MSC_VER
@@ -78,6 +139,22 @@ typedef U_PACKED_STRUCT(uShortRangePbufList_t) {
 } uShortRangePbufList_t;
 // *INDENT-ON*
 
+/** The configuration of a size class of pbuf, see
+ * uShortRangePbufCfgSet().
+ */
+typedef struct {
+    size_t dataSizeBytes; /**< the size of the data buffer of each pbuf
+                               of the class. */
+    size_t count;         /**< the number of pbufs in the class. */
+} uShortRangePbufClassCfg_t;
+
+/** A callback which is called when pbufs have been freed, see
+ * uShortRangePbufFreeCallbackSet().
+ *
+ * @param[in] pParam the pParam given to uShortRangePbufFreeCallbackSet().
+ */
+typedef void (*uShortRangePbufFreeCallback_t)(void *pParam);
+
 /** List of pbuf list. Packet list contains multiple
  * EDM payloads. Packet list are mainly used in message based
  * datapath clients like MQTT, UDP
@@ -91,6 +168,26 @@ typedef struct uShortRangePktList_t {
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
+/** Set the size classes of pbuf that uShortRangeMemPoolInit() will
+ * create, replacing the default of a small and a large class (see
+ * U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES etc.).  Use a few large
+ * pbufs for data, so that an EDM data packet is held in one or two
+ * pbufs rather than a long chain, and smaller ones for events.
+ * This may only be called while the memory pool is not initialised,
+ * i.e. before the short range stream is opened; it may be called
+ * by an application before the short range API is initialised.
+ *
+ * @param[in] pCfg   the size classes, in ascending order of data size;
+ *                   the data size and count of each must be non-zero.
+ * @param numClasses the number of entries at pCfg, up to
+ *                   #U_MEMPOOL_SLAB_CLASSES_MAX_NUM.
+ * @return           zero on success else negative error code;
+ *                   #U_ERROR_COMMON_TEMPORARY_FAILURE if the memory pool is
+ *                   currently initialised.
+ */
+int32_t uShortRangePbufCfgSet(const uShortRangePbufClassCfg_t *pCfg,
+                              size_t numClasses);
+
 /** Initialize the memory pool for shortrange.
  *
  * @return zero on success else negative error code.
@@ -102,8 +199,8 @@ int32_t uShortRangeMemPoolInit(void);
  */
 void uShortRangeMemPoolDeInit(void);
 
-/** Allocate fixed size memory from gEdmPayLoadPool memory pool.
- * Refer to gEdmPayLoadPool in u_short_range_pbuf.c
+/** Allocate a pbuf of the smallest size class or, if there is
+ * none free, of the next class up, and so on.
  * Memory pool should have been initialized before using this
  * API. Refer to uShortRangeMemPoolInit()
  *
@@ -113,6 +210,66 @@ void uShortRangeMemPoolDeInit(void);
  */
 int32_t uShortRangePbufAlloc(uShortRangePbuf_t **ppBuf);
 
+/** Allocate a pbuf for sizeBytes of data: the pbuf comes from the
+ * smallest size class that holds sizeBytes, or the largest class
+ * if none do, or, if there is none free, from the next class up;
+ * failing that a pbuf of a smaller class is returned, which is
+ * fine as the data is then chained across more pbufs.
+ * Memory pool should have been initialized before using this
+ * API. Refer to uShortRangeMemPoolInit()
+ *
+ * @param[out] ppBuf a double pointer to destination pbuf.
+ * @param sizeBytes  the amount of data to be put in the pbuf.
+ * @return  data size of the returned pbuf, which may be smaller
+ *          than sizeBytes, on failure negative error code.
+ */
+int32_t uShortRangePbufAllocSized(uShortRangePbuf_t **ppBuf, size_t sizeBytes);
+
+/** Get the total size of the data buffers of all of the pbufs in
+ * the current configuration, see uShortRangePbufCfgSet().
+ *
+ * @return the total data size of all pbufs in bytes.
+ */
+size_t uShortRangePbufPoolSizeBytes(void);
+
+/** Charge a pbuf to an EDM channel of an owner, i.e. of an EDM
+ * stream: the size of its data buffer is added to the amount held by
+ * that channel, see uShortRangePbufChannelHeldBytes(), until the pbuf
+ * is freed.  This is used to stop one channel whose consumer is slow
+ * using up all of the pbufs.  An owner outside of the range 0 to
+ * #U_SHORT_RANGE_PBUF_OWNER_MAX_NUM - 1 or a channel outside of the
+ * range 0 to #U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM - 1 is not
+ * accounted.  This function is thread-safe.
+ *
+ * @param[in] pBuf a pbuf that is not charged to any channel.
+ * @param owner    the owner of the channel.
+ * @param channel  the EDM channel.
+ */
+void uShortRangePbufChannelCharge(uShortRangePbuf_t *pBuf, int32_t owner,
+                                  int32_t channel);
+
+/** Get the amount of pbuf data buffer currently held by an EDM
+ * channel, see uShortRangePbufChannelCharge().  This function is
+ * thread-safe.
+ *
+ * @param owner   the owner of the channel.
+ * @param channel the EDM channel.
+ * @return        the number of bytes held; zero if the channel is
+ *                not accounted.
+ */
+size_t uShortRangePbufChannelHeldBytes(int32_t owner, int32_t channel);
+
+/** Set a callback to be called, in the context of whoever freed
+ * them, when pbufs have been freed, e.g. so that a receiver which
+ * stalled for want of pbufs may be started again.  The callback
+ * must not block and must not allocate or free pbufs.
+ *
+ * @param pCallback the callback, use NULL to remove it.
+ * @param[in] pParam a parameter which will be passed to pCallback.
+ */
+void uShortRangePbufFreeCallbackSet(uShortRangePbufFreeCallback_t pCallback,
+                                    void *pParam);
+
 /** Allocate memory for pbuf list from the pbuf list
  * memory pool. Refer to gPBufListPool in u_short_range_pbuf.c
  * Memory pool should have been initialized before using this
@@ -148,6 +305,22 @@ int32_t uShortRangePbufListAppend(uShortRangePbufList_t *pBufList, uShortRangePb
  */
 size_t uShortRangePbufListConsumeData(uShortRangePbufList_t *pBufList, char *pData, size_t len);
 
+/** Detach pbufs from the head of a pbuf list into a new pbuf list,
+ * without touching their data, e.g. so that the data can be lent
+ * out to an application and read in place; when the application
+ * has finished, freeing the new list with uShortRangePbufListFree()
+ * returns the pbufs to the pool.
+ *
+ * @param[in,out] pBufList pointer to the pbuf list to take the
+ *                         pbufs from.
+ * @param maxNumPbufs      the maximum number of pbufs to take.
+ * @return                 a new pbuf list holding the pbufs or NULL
+ *                         if pBufList has no data, maxNumPbufs is
+ *                         zero or no pbuf list could be allocated.
+ */
+uShortRangePbufList_t *pUShortRangePbufListSplit(uShortRangePbufList_t *pBufList,
+                                                 size_t maxNumPbufs);
+
 /** Link a new pbuf list to the existing pbuf list.
  *  The pointer allocated for the new pbuf list from the pbuf list pool
  *  will be added to its free list.
@@ -166,6 +339,16 @@ void uShortRangePbufListMerge(uShortRangePbufList_t *pOldList, uShortRangePbufLi
 int32_t uShortRangePktListAppend(uShortRangePktList_t *pPktList,
                                  uShortRangePbufList_t *pBufList);
 
+/** Remove the packet at the head of a packet list, without touching
+ * its data, e.g. so that it can be lent out to an application and
+ * read in place; free it with uShortRangePbufListFree().
+ *
+ * @param[in,out] pPktList pointer to the packet list.
+ * @return                 the pbuf list of the packet or NULL if
+ *                         there is no packet.
+ */
+uShortRangePbufList_t *pUShortRangePktListRemoveHead(uShortRangePktList_t *pPktList);
+
 /** Read and consume a packet in a packet list.
  * If the given buffer size cannot accommodate the size of a complete packet, partial
  * data will be copied.
@@ -157,6 +157,7 @@ static void removeShortRangeInstance(uShortRangePrivateInstance_t *pInstance)
         }
     }
 
+    free(pInstance->pWifiStaCache);
     free(pInstance);
 }
 
@@ -244,8 +245,7 @@ static int32_t uShortRangeAdd(uShortRangeModuleType_t moduleType,
     if (pInstance) {
         handleOrErrorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
         pDevInstance->pContext = (void *)pInstance;
-        //lint -e740 Disable Unusual pointer cast
-        *pDevHandle = (uDeviceHandle_t)pDevInstance;
+        *pDevHandle = U_DEVICE_HANDLE(pDevInstance);
     } else {
         handleOrErrorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
     }
@@ -26,6 +26,7 @@
 
 #include "u_error_common.h"
 #include "u_assert.h"
+#include "u_port_debug.h"
 #include "u_short_range_module_type.h"
 #include "u_short_range_pbuf.h"
 #include "u_at_client.h"
@@ -55,44 +56,57 @@
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
-typedef enum {
-    EDM_PARSER_STATE_PARSE_START_BYTE,
-    EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH,
-    EDM_PARSER_STATE_PARSE_HEADER_LENGTH,
-    EDM_PARSER_STATE_ALLOCATE_PBUFLIST,
-    EDM_PARSER_STATE_ALLOCATE_PAYLOAD,
-    EDM_PARSER_STATE_ACCUMULATE_PAYLOAD,
-    EDM_PARSER_STATE_PARSE_TAIL_BYTE,
-    EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING
-} edmParserState_t;
-
 /* ----------------------------------------------------------------
  * STATIC PROTOTYPES
  * -------------------------------------------------------------- */
 static int32_t getBtProfile(char value, uShortRangeBtProfile_t *profile);
 static int32_t getIpProtocol(char value, uShortRangeIpProtocol_t *protocol);
-static uShortRangeEdmEvent_t *allocateEdmEvent(void);
-static uShortRangeEdmEvent_t *parseConnectBtEvent(uint8_t channel, char *buffer,
+static uShortRangeEdmEvent_t *allocateEdmEvent(uShortRangeEdmParser_t *pParser);
+static uShortRangeEdmEvent_t *parseConnectBtEvent(uShortRangeEdmParser_t *pParser,
+                                                  uint8_t channel, char *buffer,
                                                   uint16_t payloadLength);
-static uShortRangeEdmEvent_t *parseConnectIpv4Event(uint8_t channel, char *buffer,
+static uShortRangeEdmEvent_t *parseConnectIpv4Event(uShortRangeEdmParser_t *pParser,
+                                                    uint8_t channel, char *buffer,
                                                     uint16_t payloadLength);
-static uShortRangeEdmEvent_t *parseConnectIpv6Event(uint8_t channel, char *buffer,
+static uShortRangeEdmEvent_t *parseConnectIpv6Event(uShortRangeEdmParser_t *pParser,
+                                                    uint8_t channel, char *buffer,
                                                     uint16_t payloadLength);
-static uShortRangeEdmEvent_t *parseConnectEvent(uint8_t channel, uShortRangePbufList_t *pBufList);
-static uShortRangeEdmEvent_t *parseDisconnectEvent(uint8_t channel);
-static uShortRangeEdmEvent_t *parseDataEvent(uint8_t channel, uShortRangePbufList_t *pBufList);
-static uShortRangeEdmEvent_t *parseAtResponseOrEvent(uShortRangePbufList_t *pBufList);
-static uShortRangeEdmEvent_t *parseEdmPayload(uint16_t idAndType, uint8_t channel,
+static uShortRangeEdmEvent_t *parseConnectEvent(uShortRangeEdmParser_t *pParser,
+                                                uint8_t channel, uShortRangePbufList_t *pBufList);
+static uShortRangeEdmEvent_t *parseDisconnectEvent(uShortRangeEdmParser_t *pParser,
+                                                   uint8_t channel);
+static uShortRangeEdmEvent_t *parseDataEvent(uShortRangeEdmParser_t *pParser,
+                                             uint8_t channel, uShortRangePbufList_t *pBufList);
+static uShortRangeEdmEvent_t *parseAtResponseOrEvent(uShortRangeEdmParser_t *pParser,
+                                                     uShortRangePbufList_t *pBufList);
+static uShortRangeEdmEvent_t *parseEdmPayload(uShortRangeEdmParser_t *pParser,
+                                              uint16_t idAndType, uint8_t channel,
                                               uShortRangePbufList_t *pBufList);
 
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
-static edmParserState_t gEdmParserState = EDM_PARSER_STATE_PARSE_START_BYTE;
-static uShortRangePbufList_t *gCurPBufList = NULL;
+
+/** Profiling probe for uShortRangeEdmParseBuffer(), only present if
+ * U_CFG_PROFILE is defined.
+ */
+U_PORT_PROFILE_PROBE(edmParse);
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
+
+// Check if the receive quota of a channel allows a payload of
+// sizeBytes to be taken on.
+static bool rxQuotaAllows(const uShortRangeEdmParser_t *pParser, int32_t channel,
+                          size_t sizeBytes)
+{
+    size_t quotaBytes = uShortRangeEdmRxQuotaGet(pParser, channel);
+    size_t heldBytes = uShortRangePbufChannelHeldBytes(pParser->owner, channel);
+
+    return (quotaBytes == 0) || (heldBytes == 0) || (heldBytes + sizeBytes <= quotaBytes);
+}
+
 static int32_t getBtProfile(char value, uShortRangeBtProfile_t *pProfile)
 {
     switch (value) {
@@ -131,14 +145,13 @@ static int32_t getIpProtocol(char value, uShortRangeIpProtocol_t *pProtocol)
     return U_SHORT_RANGE_EDM_OK;
 }
 
-static uShortRangeEdmEvent_t *allocateEdmEvent(void)
+static uShortRangeEdmEvent_t *allocateEdmEvent(uShortRangeEdmParser_t *pParser)
 {
-    static uShortRangeEdmEvent_t gEdmEvent;
-
-    return &gEdmEvent;
+    return &(pParser->event);
 }
 
-static uShortRangeEdmEvent_t *parseConnectBtEvent(uint8_t channel, char *pBuffer,
+static uShortRangeEdmEvent_t *parseConnectBtEvent(uShortRangeEdmParser_t *pParser,
+                                                  uint8_t channel, char *pBuffer,
                                                   uint16_t payloadLength)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
@@ -147,7 +160,7 @@ static uShortRangeEdmEvent_t *parseConnectBtEvent(uint8_t channel, char *pBuffer
 
     if ((payloadLength == 10) && (result == U_SHORT_RANGE_EDM_OK)) {
         uShortRangeEdmConnectionEventBt_t *pEvtData;
-        pEvent = allocateEdmEvent();
+        pEvent = allocateEdmEvent(pParser);
         pEvent->type = U_SHORT_RANGE_EDM_EVENT_CONNECT_BT;
         pEvtData = &pEvent->params.btConnectEvent;
         pEvtData->channel = channel;
@@ -160,7 +173,8 @@ static uShortRangeEdmEvent_t *parseConnectBtEvent(uint8_t channel, char *pBuffer
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseConnectIpv4Event(uint8_t channel, char *pBuffer,
+static uShortRangeEdmEvent_t *parseConnectIpv4Event(uShortRangeEdmParser_t *pParser,
+                                                    uint8_t channel, char *pBuffer,
                                                     uint16_t payloadLength)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
@@ -169,7 +183,7 @@ static uShortRangeEdmEvent_t *parseConnectIpv4Event(uint8_t channel, char *pBuff
 
     if ((payloadLength == 14) && (result == U_SHORT_RANGE_EDM_OK)) {
         uShortRangeEdmConnectionEventIpv4_t *pEvtData;
-        pEvent = allocateEdmEvent();
+        pEvent = allocateEdmEvent(pParser);
         pEvent->type = U_SHORT_RANGE_EDM_EVENT_CONNECT_IPv4;
         pEvtData = &pEvent->params.ipv4ConnectEvent;
         pEvtData->channel = channel;
@@ -187,7 +201,8 @@ static uShortRangeEdmEvent_t *parseConnectIpv4Event(uint8_t channel, char *pBuff
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseConnectIpv6Event(uint8_t channel, char *pBuffer,
+static uShortRangeEdmEvent_t *parseConnectIpv6Event(uShortRangeEdmParser_t *pParser,
+                                                    uint8_t channel, char *pBuffer,
                                                     uint16_t payloadLength)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
@@ -196,7 +211,7 @@ static uShortRangeEdmEvent_t *parseConnectIpv6Event(uint8_t channel, char *pBuff
 
     if ((payloadLength == 38) && (result == U_SHORT_RANGE_EDM_OK)) {
         uShortRangeEdmConnectionEventIpv6_t *pEvtData;
-        pEvent = allocateEdmEvent();
+        pEvent = allocateEdmEvent(pParser);
         pEvent->type = U_SHORT_RANGE_EDM_EVENT_CONNECT_IPv6;
         pEvtData = &pEvent->params.ipv6ConnectEvent;
         pEvtData->channel = channel;
@@ -214,7 +229,8 @@ static uShortRangeEdmEvent_t *parseConnectIpv6Event(uint8_t channel, char *pBuff
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseConnectEvent(uint8_t channel, uShortRangePbufList_t *pBufList)
+static uShortRangeEdmEvent_t *parseConnectEvent(uShortRangeEdmParser_t *pParser,
+                                                uint8_t channel, uShortRangePbufList_t *pBufList)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
     uint16_t payloadLength = 0;
@@ -230,15 +246,15 @@ static uShortRangeEdmEvent_t *parseConnectEvent(uint8_t channel, uShortRangePbuf
         switch (type) {
 
             case U_SHORT_RANGE_EDM_CONNECTION_TYPE_BT:
-                pEvent = parseConnectBtEvent(channel, pBuffer, payloadLength);
+                pEvent = parseConnectBtEvent(pParser, channel, pBuffer, payloadLength);
                 break;
 
             case U_SHORT_RANGE_EDM_CONNECTION_TYPE_IPv4:
-                pEvent = parseConnectIpv4Event(channel, pBuffer, payloadLength);
+                pEvent = parseConnectIpv4Event(pParser, channel, pBuffer, payloadLength);
                 break;
 
             case U_SHORT_RANGE_EDM_CONNECTION_TYPE_IPv6:
-                pEvent = parseConnectIpv6Event(channel, pBuffer, payloadLength);
+                pEvent = parseConnectIpv6Event(pParser, channel, pBuffer, payloadLength);
                 break;
 
             default:
@@ -249,23 +265,25 @@ static uShortRangeEdmEvent_t *parseConnectEvent(uint8_t channel, uShortRangePbuf
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseDisconnectEvent(uint8_t channel)
+static uShortRangeEdmEvent_t *parseDisconnectEvent(uShortRangeEdmParser_t *pParser,
+                                                   uint8_t channel)
 {
     uShortRangeEdmEvent_t *pEvent;
 
-    pEvent = allocateEdmEvent();
+    pEvent = allocateEdmEvent(pParser);
     pEvent->type = U_SHORT_RANGE_EDM_EVENT_DISCONNECT;
     pEvent->params.disconnectEvent.channel = channel;
 
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseDataEvent(uint8_t channel, uShortRangePbufList_t *pBufList)
+static uShortRangeEdmEvent_t *parseDataEvent(uShortRangeEdmParser_t *pParser,
+                                             uint8_t channel, uShortRangePbufList_t *pBufList)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
 
     if ((pBufList != NULL) && (pBufList->totalLen > 0)) {
-        pEvent = allocateEdmEvent();
+        pEvent = allocateEdmEvent(pParser);
         pEvent->type = U_SHORT_RANGE_EDM_EVENT_DATA;
         pEvent->params.dataEvent.channel = channel;
         pEvent->params.dataEvent.pBufList = pBufList;
@@ -274,15 +292,17 @@ static uShortRangeEdmEvent_t *parseDataEvent(uint8_t channel, uShortRangePbufLis
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseAtResponseOrEvent(uShortRangePbufList_t *pBufList)
+static uShortRangeEdmEvent_t *parseAtResponseOrEvent(uShortRangeEdmParser_t *pParser,
+                                                     uShortRangePbufList_t *pBufList)
 {
-    uShortRangeEdmEvent_t *pEvent = allocateEdmEvent();
+    uShortRangeEdmEvent_t *pEvent = allocateEdmEvent(pParser);
     pEvent->type = U_SHORT_RANGE_EDM_EVENT_AT;
     pEvent->params.atEvent.pBufList = pBufList;
     return pEvent;
 }
 
-static uShortRangeEdmEvent_t *parseEdmPayload(uint16_t idAndType, uint8_t channel,
+static uShortRangeEdmEvent_t *parseEdmPayload(uShortRangeEdmParser_t *pParser,
+                                              uint16_t idAndType, uint8_t channel,
                                               uShortRangePbufList_t *pBufList)
 {
     uShortRangeEdmEvent_t *pEvent = NULL;
@@ -290,26 +310,26 @@ static uShortRangeEdmEvent_t *parseEdmPayload(uint16_t idAndType, uint8_t channe
     switch (idAndType) {
 
         case U_SHORT_RANGE_EDM_TYPE_CONNECT_EVENT:
-            pEvent = parseConnectEvent(channel, pBufList);
+            pEvent = parseConnectEvent(pParser, channel, pBufList);
             uShortRangePbufListFree(pBufList);
             break;
 
         case U_SHORT_RANGE_EDM_TYPE_DISCONNECT_EVENT:
-            pEvent = parseDisconnectEvent(channel);
+            pEvent = parseDisconnectEvent(pParser, channel);
             uShortRangePbufListFree(pBufList);
             break;
 
         case U_SHORT_RANGE_EDM_TYPE_DATA_EVENT:
-            pEvent = parseDataEvent(channel, pBufList);
+            pEvent = parseDataEvent(pParser, channel, pBufList);
             break;
 
         case U_SHORT_RANGE_EDM_TYPE_AT_RESPONSE:
         case U_SHORT_RANGE_EDM_TYPE_AT_EVENT:
-            pEvent = parseAtResponseOrEvent(pBufList);
+            pEvent = parseAtResponseOrEvent(pParser, pBufList);
             break;
 
         case U_SHORT_RANGE_EDM_TYPE_START_EVENT:
-            pEvent = allocateEdmEvent();
+            pEvent = allocateEdmEvent(pParser);
             pEvent->type = U_SHORT_RANGE_EDM_EVENT_STARTUP;
             break;
         //lint -e825
@@ -326,86 +346,89 @@ static uShortRangeEdmEvent_t *parseEdmPayload(uint16_t idAndType, uint8_t channe
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
-bool uShortRangeEdmParserReady(void)
+void uShortRangeEdmParserInit(uShortRangeEdmParser_t *pParser, int32_t owner)
+{
+    memset(pParser, 0, sizeof(*pParser));
+    pParser->state = EDM_PARSER_STATE_PARSE_START_BYTE;
+    pParser->owner = owner;
+    pParser->rxQuotaStalledChannel = -1;
+}
+
+bool uShortRangeEdmParserReady(const uShortRangeEdmParser_t *pParser)
 {
-    return (gEdmParserState != EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING);
+    return (pParser->state != EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING);
 }
 
-void uShortRangeEdmResetParser(void)
+void uShortRangeEdmResetParser(uShortRangeEdmParser_t *pParser)
 {
-    gEdmParserState = EDM_PARSER_STATE_PARSE_START_BYTE;
+    pParser->state = EDM_PARSER_STATE_PARSE_START_BYTE;
 }
 
-bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pMemAvailable)
+bool uShortRangeEdmParse(uShortRangeEdmParser_t *pParser, char c,
+                         uShortRangeEdmEvent_t **ppResultEvent, bool *pMemAvailable)
 {
-    edmParserState_t newState = gEdmParserState;
-    static uint16_t payloadLength;
-    static uShortRangePbuf_t *pBuf;
-    static int32_t pBufSize;
-    static char header[U_SHORT_RANGE_EDM_HEADER_SIZE];
-    static uint32_t headerIndex;
-    static uint16_t idAndType;
-    static uint8_t channel;
+    uShortRangeEdmParserState_t newState = pParser->state;
     bool charConsumed = false;
     int32_t result;
 
     *pMemAvailable = true;
-    switch (gEdmParserState) {
+    switch (pParser->state) {
 
         case EDM_PARSER_STATE_PARSE_START_BYTE:
             if (c == U_SHORT_RANGE_EDM_HEAD) {
-                headerIndex = 0;
+                pParser->headerIndex = 0;
                 newState = EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH;
             }
             charConsumed = true;
             break;
 
         case EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH:
-            if (headerIndex == 0) {
-                payloadLength = (uint16_t)(uint8_t)c << 8;
-                headerIndex++;
+            if (pParser->headerIndex == 0) {
+                pParser->payloadLength = (uint16_t)(uint8_t)c << 8;
+                pParser->headerIndex++;
             } else {
-                payloadLength |= (uint16_t)(uint8_t)c;
-                if (payloadLength < 2) {
+                pParser->payloadLength |= (uint16_t)(uint8_t)c;
+                if (pParser->payloadLength < 2) {
                     // Something is wrong, start over
                     newState = EDM_PARSER_STATE_PARSE_START_BYTE;
                 } else {
-                    headerIndex = 0;
+                    pParser->headerIndex = 0;
                     newState = EDM_PARSER_STATE_PARSE_HEADER_LENGTH;
                 }
             }
             charConsumed = true;
             break;
         case EDM_PARSER_STATE_PARSE_HEADER_LENGTH:
-            header[headerIndex++] = c;
-            payloadLength--;
+            pParser->header[pParser->headerIndex++] = c;
+            pParser->payloadLength--;
 
-            if (headerIndex == 2) {
+            if (pParser->headerIndex == 2) {
 
-                idAndType = ((uint16_t)(uint8_t)header[0] << 8) | (uint16_t)(uint8_t)header[1];
+                pParser->idAndType = ((uint16_t)(uint8_t)pParser->header[0] << 8) |
+                                     (uint16_t)(uint8_t)pParser->header[1];
 
-                if ((idAndType == U_SHORT_RANGE_EDM_TYPE_AT_RESPONSE) ||
-                    (idAndType == U_SHORT_RANGE_EDM_TYPE_AT_EVENT)    ||
-                    (idAndType == U_SHORT_RANGE_EDM_TYPE_START_EVENT) ||
-                    (idAndType == U_SHORT_RANGE_EDM_TYPE_AT_REQUEST)) {
+                if ((pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_AT_RESPONSE) ||
+                    (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_AT_EVENT)    ||
+                    (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_START_EVENT) ||
+                    (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_AT_REQUEST)) {
 
                     // Channel does not exist for these types so
                     // fill in -1
-                    header[headerIndex++] = -1;
+                    pParser->header[pParser->headerIndex++] = -1;
                 }
             }
 
-            if (headerIndex == U_SHORT_RANGE_EDM_HEADER_SIZE) {
-                channel = header[2];
+            if (pParser->headerIndex == U_SHORT_RANGE_EDM_HEADER_SIZE) {
+                pParser->channel = pParser->header[2];
                 // gCurPBufChain should always be NULL here
                 // If it's not we have a leak
-                U_ASSERT(gCurPBufList == NULL);
-                pBuf = NULL;
+                U_ASSERT(pParser->pCurPBufList == NULL);
+                pParser->pPBuf = NULL;
                 newState = EDM_PARSER_STATE_ALLOCATE_PBUFLIST;
                 // For disconnect event there is no payload
                 // so directly head to parse tail byte
-                if ((idAndType == U_SHORT_RANGE_EDM_TYPE_DISCONNECT_EVENT) ||
-                    (idAndType == U_SHORT_RANGE_EDM_TYPE_START_EVENT)) {
+                if ((pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_DISCONNECT_EVENT) ||
+                    (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_START_EVENT)) {
                     newState = EDM_PARSER_STATE_PARSE_TAIL_BYTE;
                 }
             }
@@ -416,11 +439,12 @@ bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pM
 
             // if allocation fails stay back until
             // we have some free memory in their respective pool
-            gCurPBufList = pUShortRangePbufListAlloc();
-            if (gCurPBufList != NULL) {
-                gCurPBufList->edmChannel = channel;
+            pParser->pCurPBufList = pUShortRangePbufListAlloc();
+            if (pParser->pCurPBufList != NULL) {
+                pParser->pCurPBufList->edmChannel = pParser->channel;
                 newState = EDM_PARSER_STATE_ALLOCATE_PAYLOAD;
             } else {
+                pParser->rxQuotaStalledChannel = -1;
                 *pMemAvailable = false; // remain at same state, try again later
             }
             // we dont consume the input char in this state
@@ -431,12 +455,29 @@ bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pM
 
             // if allocation fails stay back until
             // we have some free memory in their respective pool
-            pBufSize = uShortRangePbufAlloc(&pBuf);
-            if (pBufSize > 0) {
-                headerIndex = 0;
-                newState = EDM_PARSER_STATE_ACCUMULATE_PAYLOAD;
-            } else {
+            // Ask for a pbuf that will hold all of what is left of the
+            // payload, so that a data packet ends up in as few as possible
+            // A data packet is only begun if its channel is within
+            // its receive quota; once begun it is allowed to complete
+            if ((pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_DATA_EVENT) &&
+                (pParser->pCurPBufList->pBufHead == NULL) &&
+                !rxQuotaAllows(pParser, pParser->channel, pParser->payloadLength)) {
+                pParser->rxQuotaStalledChannel = pParser->channel;
                 *pMemAvailable = false; // remain at same state, try again later
+            } else {
+                pParser->pBufSize = uShortRangePbufAllocSized(&(pParser->pPBuf),
+                                                              pParser->payloadLength);
+                if (pParser->pBufSize > 0) {
+                    if (pParser->idAndType == U_SHORT_RANGE_EDM_TYPE_DATA_EVENT) {
+                        uShortRangePbufChannelCharge(pParser->pPBuf, pParser->owner,
+                                                     pParser->channel);
+                    }
+                    pParser->headerIndex = 0;
+                    newState = EDM_PARSER_STATE_ACCUMULATE_PAYLOAD;
+                } else {
+                    pParser->rxQuotaStalledChannel = -1;
+                    *pMemAvailable = false; // remain at same state, try again later
+                }
             }
             // we dont consume the input char in this state
             charConsumed = false;
@@ -444,25 +485,25 @@ bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pM
 
         case EDM_PARSER_STATE_ACCUMULATE_PAYLOAD:
 
-            U_ASSERT(pBufSize > 0);
-            U_ASSERT(pBuf != NULL);
-            U_ASSERT(pBuf->length < pBufSize);
+            U_ASSERT(pParser->pBufSize > 0);
+            U_ASSERT(pParser->pPBuf != NULL);
+            U_ASSERT(pParser->pPBuf->length < pParser->pBufSize);
 
-            pBuf->data[pBuf->length++] = c;
-            payloadLength--;
+            pParser->pPBuf->data[pParser->pPBuf->length++] = c;
+            pParser->payloadLength--;
 
-            if ((pBuf->length == pBufSize) ||
-                (payloadLength == 0)) {
-                result = uShortRangePbufListAppend(gCurPBufList, pBuf);
+            if ((pParser->pPBuf->length == pParser->pBufSize) ||
+                (pParser->payloadLength == 0)) {
+                result = uShortRangePbufListAppend(pParser->pCurPBufList, pParser->pPBuf);
                 U_ASSERT(result == 0);
-                if (payloadLength == 0) {
+                if (pParser->payloadLength == 0) {
                     newState = EDM_PARSER_STATE_PARSE_TAIL_BYTE;
-                } else if (pBuf->length == pBufSize) {
+                } else if (pParser->pPBuf->length == pParser->pBufSize) {
                     // we have some more data coming in
                     // so allocate memory for payload
                     newState = EDM_PARSER_STATE_ALLOCATE_PAYLOAD;
                 }
-                pBuf = NULL;
+                pParser->pPBuf = NULL;
             }
             charConsumed = true;
             break;
@@ -471,7 +512,9 @@ bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pM
             newState = EDM_PARSER_STATE_PARSE_START_BYTE;
             if (c == U_SHORT_RANGE_EDM_TAIL) {
                 if (ppResultEvent != NULL) {
-                    *ppResultEvent = parseEdmPayload(idAndType, channel, gCurPBufList);
+                    *ppResultEvent = parseEdmPayload(pParser, pParser->idAndType,
+                                                     pParser->channel,
+                                                     pParser->pCurPBufList);
                     if (*ppResultEvent == NULL) {
                         // No event was generated
                         // Reset parser
@@ -483,9 +526,9 @@ bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pM
             }
             if (newState == EDM_PARSER_STATE_PARSE_START_BYTE) {
                 // Always de-allocate the buffer when we reset the parser
-                uShortRangePbufListFree(gCurPBufList);
+                uShortRangePbufListFree(pParser->pCurPBufList);
             }
-            gCurPBufList = NULL;
+            pParser->pCurPBufList = NULL;
             charConsumed = true;
             break;
 
@@ -497,11 +540,109 @@ bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pM
             break;
     }
 
-    gEdmParserState = newState;
+    pParser->state = newState;
 
     return charConsumed;
 }
 
+size_t uShortRangeEdmParseBuffer(uShortRangeEdmParser_t *pParser,
+                                 const char *pBuffer, size_t length,
+                                 uShortRangeEdmEvent_t **ppResultEvent,
+                                 bool *pMemAvailable)
+{
+    size_t consumed = 0;
+    size_t copyLength;
+    const char *pStart;
+    uShortRangeEdmEvent_t *pEvent = NULL;
+    U_PORT_PROFILE_BEGIN(edmParse);
+
+    *pMemAvailable = true;
+    while ((consumed < length) && (pEvent == NULL) && *pMemAvailable &&
+           (pParser->state != EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING)) {
+        if (pParser->state == EDM_PARSER_STATE_PARSE_START_BYTE) {
+            // Skip straight to the next start byte
+            pStart = (const char *) memchr(pBuffer + consumed, U_SHORT_RANGE_EDM_HEAD,
+                                           length - consumed);
+            if (pStart == NULL) {
+                consumed = length;
+            } else {
+                consumed = pStart - pBuffer;
+            }
+        } else if ((pParser->state == EDM_PARSER_STATE_ACCUMULATE_PAYLOAD) &&
+                   (pParser->pPBuf != NULL)) {
+            // Copy all but the last of what will fit in this pbuf
+            // in one go, the last byte going through uShortRangeEdmParse()
+            // below so that it deals with the pbuf being full or
+            // the payload being complete
+            copyLength = pParser->pBufSize - pParser->pPBuf->length;
+            if (copyLength > pParser->payloadLength) {
+                copyLength = pParser->payloadLength;
+            }
+            if (copyLength > length - consumed) {
+                copyLength = length - consumed;
+            }
+            if (copyLength > 1) {
+                copyLength--;
+                memcpy(&(pParser->pPBuf->data[pParser->pPBuf->length]),
+                       pBuffer + consumed, copyLength);
+                pParser->pPBuf->length += (uint16_t) copyLength;
+                pParser->payloadLength -= (uint16_t) copyLength;
+                consumed += copyLength;
+            }
+        }
+        if ((consumed < length) &&
+            uShortRangeEdmParse(pParser, pBuffer[consumed], &pEvent, pMemAvailable)) {
+            consumed++;
+        }
+    }
+
+    if (ppResultEvent != NULL) {
+        *ppResultEvent = pEvent;
+    }
+
+    U_PORT_PROFILE_END(edmParse, consumed);
+
+    return consumed;
+}
+
+int32_t uShortRangeEdmRxQuotaSet(uShortRangeEdmParser_t *pParser, int32_t channel,
+                                 int32_t quotaBytes)
+{
+    int32_t errorCode = U_SHORT_RANGE_EDM_ERROR_PARAM;
+
+    if ((channel >= 0) && (channel < U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM)) {
+        pParser->rxQuotaIsSet[channel] = (quotaBytes >= 0);
+        pParser->rxQuotaBytes[channel] = 0;
+        if (quotaBytes > 0) {
+            pParser->rxQuotaBytes[channel] = (size_t) quotaBytes;
+        }
+        errorCode = U_SHORT_RANGE_EDM_OK;
+    }
+
+    return errorCode;
+}
+
+size_t uShortRangeEdmRxQuotaGet(const uShortRangeEdmParser_t *pParser, int32_t channel)
+{
+    size_t quotaBytes = 0;
+
+    if ((channel >= 0) && (channel < U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM)) {
+        if (pParser->rxQuotaIsSet[channel]) {
+            quotaBytes = pParser->rxQuotaBytes[channel];
+        } else {
+            quotaBytes = (uShortRangePbufPoolSizeBytes() *
+                          U_SHORT_RANGE_EDM_RX_QUOTA_DEFAULT_PERCENT) / 100;
+        }
+    }
+
+    return quotaBytes;
+}
+
+int32_t uShortRangeEdmRxQuotaStalledChannel(const uShortRangeEdmParser_t *pParser)
+{
+    return pParser->rxQuotaStalledChannel;
+}
+
 int32_t uShortRangeEdmZeroCopyHeadData(uint8_t channel, uint32_t size, char *pHead)
 {
     if (pHead == NULL || size > U_SHORT_RANGE_EDM_MAX_SIZE) {
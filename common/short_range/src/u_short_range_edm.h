@@ -21,9 +21,14 @@
  * of another module should be included here; otherwise
  * please keep #includes to your .c files. */
 #include "u_short_range.h"
+#include "u_short_range_pbuf.h"
 
 /** @file */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define U_SHORT_RANGE_EDM_OK                  0
 #define U_SHORT_RANGE_EDM_ERROR               -1
 #define U_SHORT_RANGE_EDM_ERROR_PARAM         -2
@@ -45,8 +50,14 @@
 //lint -esym(755, U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE) Suppress lack of a reference
 #define U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE     635
 #define U_SHORT_RANGE_EDM_HEADER_SIZE         3 // (ID + TYPE)(2 bytes)  + CHANNEL ID (1 byte)
-#define U_SHORT_RANGE_EDM_BLK_SIZE            64
-#define U_SHORT_RANGE_EDM_BLK_COUNT           (U_SHORT_RANGE_EDM_MAX_SIZE / U_SHORT_RANGE_EDM_BLK_SIZE)
+
+#ifndef U_SHORT_RANGE_EDM_RX_QUOTA_DEFAULT_PERCENT
+/** The default receive quota of a data channel, as a percentage of
+ * the total data size of the pbufs (uShortRangePbufPoolSizeBytes()),
+ * see uShortRangeEdmRxQuotaSet().
+ */
+# define U_SHORT_RANGE_EDM_RX_QUOTA_DEFAULT_PERCENT 50
+#endif
 
 typedef enum {
     U_SHORT_RANGE_EDM_EVENT_CONNECT_BT,
@@ -99,6 +110,53 @@ typedef struct {
     } params;
 } uShortRangeEdmEvent_t;
 
+typedef enum {
+    EDM_PARSER_STATE_PARSE_START_BYTE,
+    EDM_PARSER_STATE_PARSE_PAYLOAD_LENGTH,
+    EDM_PARSER_STATE_PARSE_HEADER_LENGTH,
+    EDM_PARSER_STATE_ALLOCATE_PBUFLIST,
+    EDM_PARSER_STATE_ALLOCATE_PAYLOAD,
+    EDM_PARSER_STATE_ACCUMULATE_PAYLOAD,
+    EDM_PARSER_STATE_PARSE_TAIL_BYTE,
+    EDM_PARSER_STATE_WAIT_FOR_EVENT_PROCESSING
+} uShortRangeEdmParserState_t;
+
+/** An EDM parser, one for each EDM stream, so that several modules
+ * may be parsed at once: not to be accessed directly, use the
+ * functions below, initialising it with uShortRangeEdmParserInit().
+ */
+typedef struct {
+    uShortRangeEdmParserState_t state;
+    char header[U_SHORT_RANGE_EDM_HEADER_SIZE];
+    uint32_t headerIndex;
+    uint16_t idAndType;
+    uint8_t channel;
+    uShortRangePbufList_t *pCurPBufList;
+    uint16_t payloadLength;        /**< the payload still to come. */
+    uShortRangePbuf_t *pPBuf;      /**< the pbuf being filled. */
+    int32_t pBufSize;              /**< the data size of pPBuf. */
+    uShortRangeEdmEvent_t event;   /**< the event returned by the parser. */
+    int32_t owner;                 /**< what pbufs are charged to, see
+                                        uShortRangePbufChannelCharge(). */
+    bool rxQuotaIsSet[U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM];
+    size_t rxQuotaBytes[U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM];
+    int32_t rxQuotaStalledChannel;
+} uShortRangeEdmParser_t;
+
+/**
+ *
+ * @brief Initialise an EDM parser; this must be done before the
+ *        parser is used.
+ *
+ * @param[out] pParser The parser.
+ *
+ * @param owner The owner that the pbufs holding data received by this
+ *              parser are charged to, see uShortRangePbufChannelCharge(),
+ *              0 to U_SHORT_RANGE_PBUF_OWNER_MAX_NUM - 1, unique to
+ *              the parser.
+ */
+void uShortRangeEdmParserInit(uShortRangeEdmParser_t *pParser, int32_t owner);
+
 /**
  *
  * @brief Check if EDM parser is available
@@ -106,16 +164,20 @@ typedef struct {
  * @note  Do not call the uShortRangeEdmParse function if this function
  *        returns false.
  *
+ * @param[in] pParser The parser.
+ *
  * @return True if EDM parser is available
  */
-bool uShortRangeEdmParserReady(void);
+bool uShortRangeEdmParserReady(const uShortRangeEdmParser_t *pParser);
 
 /**
  *
  * @brief Reset the parser. Do this every time the latest EDM event
  *        has been processed to make the parser available again.
+ *
+ * @param[in] pParser The parser.
  */
-void uShortRangeEdmResetParser(void);
+void uShortRangeEdmResetParser(uShortRangeEdmParser_t *pParser);
 
 /**
  *
@@ -125,6 +187,8 @@ void uShortRangeEdmResetParser(void);
  *        Check if parser is available with uShortRangeEdmParserAvailable
  *        If a packet is invalid it will be silently dropped.
  *
+ * @param[in] pParser The parser.
+ *
  * @param c Input character.
  *
  * @param[out] ppResultEvent Address of pointer to event, NULL if no event was generated
@@ -135,7 +199,96 @@ void uShortRangeEdmResetParser(void);
  *
  * @return True when input character c is consumed else false.
  */
-bool uShortRangeEdmParse(char c, uShortRangeEdmEvent_t **ppResultEvent, bool *pMemAvailable);
+bool uShortRangeEdmParse(uShortRangeEdmParser_t *pParser, char c,
+                         uShortRangeEdmEvent_t **ppResultEvent, bool *pMemAvailable);
+
+/**
+ *
+ * @brief Function for parsing a buffer of binary EDM data, equivalent
+ *        to calling uShortRangeEdmParse() for each character but with
+ *        the search for the start of a packet done using memchr() and
+ *        payload copied into pbufs with a memcpy() per pbuf.
+ *
+ * @note  Parsing stops when an event is generated, when no pbuf memory
+ *        is available or when the parser is not available; what is not
+ *        consumed should be passed in again once the event has been
+ *        processed, and the parser reset, or once memory is available.
+ *
+ * @param[in] pParser The parser.
+ *
+ * @param[in] pBuffer The data to parse.
+ *
+ * @param length The number of bytes at pBuffer.
+ *
+ * @param[out] ppResultEvent Address of pointer to event, NULL if no event was generated.
+ *
+ * @param[out] pMemAvailable Pointer to a boolean that indicates if memory was allocated successfully.
+ *
+ * @return The number of bytes of pBuffer that were consumed.
+ */
+size_t uShortRangeEdmParseBuffer(uShortRangeEdmParser_t *pParser,
+                                 const char *pBuffer, size_t length,
+                                 uShortRangeEdmEvent_t **ppResultEvent,
+                                 bool *pMemAvailable);
+
+/**
+ *
+ * @brief Set the receive quota of a data channel: the parser will not
+ *        begin on the payload of a data packet for the channel if that
+ *        would take the amount of pbuf held by the channel, see
+ *        uShortRangePbufChannelHeldBytes(), beyond the quota; instead
+ *        it reports no memory available, as it would were the pbufs
+ *        exhausted, until the consumer of the data on the channel has
+ *        freed enough of what it holds.  This stops one slow consumer
+ *        using up all of the pbufs, which would leave none for AT
+ *        responses or other channels, though note that, the EDM stream
+ *        being serial, a stalled packet still holds up those behind it.
+ *        A packet is always allowed if the channel holds nothing, so
+ *        a packet larger than the quota does not stall for ever.
+ *
+ * @note  Channels outside of the range 0 to
+ *        U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM - 1 have no quota.
+ *
+ * @param[in] pParser The parser.
+ *
+ * @param channel The EDM channel.
+ *
+ * @param quotaBytes The quota in bytes; zero for no quota, negative
+ *                   to return to the default of
+ *                   U_SHORT_RANGE_EDM_RX_QUOTA_DEFAULT_PERCENT of the
+ *                   pbufs.
+ *
+ * @return U_SHORT_RANGE_EDM_OK on success else
+ *         U_SHORT_RANGE_EDM_ERROR_PARAM.
+ */
+int32_t uShortRangeEdmRxQuotaSet(uShortRangeEdmParser_t *pParser, int32_t channel,
+                                 int32_t quotaBytes);
+
+/**
+ *
+ * @brief Get the receive quota of a data channel, see
+ *        uShortRangeEdmRxQuotaSet().
+ *
+ * @param[in] pParser The parser.
+ *
+ * @param channel The EDM channel.
+ *
+ * @return The quota in bytes, zero if there is none.
+ */
+size_t uShortRangeEdmRxQuotaGet(const uShortRangeEdmParser_t *pParser, int32_t channel);
+
+/**
+ *
+ * @brief Get the channel for which the parser last reported no memory
+ *        available because the channel was at its receive quota.
+ *
+ * @param[in] pParser The parser.
+ *
+ * @return The channel or -1 if the parser last reported no memory
+ *         available because the pbufs were exhausted (or has never
+ *         reported no memory available).
+ */
+int32_t uShortRangeEdmRxQuotaStalledChannel(const uShortRangeEdmParser_t *pParser);
 
 /**
  *
@@ -206,6 +359,10 @@ int32_t uShortRangeEdmZeroCopyHeadData(uint8_t channel, uint32_t size, char *pHe
  */
 int32_t uShortRangeEdmZeroCopyTail(char *pTail);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
 
 // End of file
@@ -39,7 +39,9 @@
 #include "u_port_event_queue.h"
 #include "u_port_uart.h"
 #include "u_port_debug.h"
+#include "u_trace.h"
 #include "u_at_client.h"
+#include "u_sock.h"    // uSockIoVec_t
 #include "u_short_range_pbuf.h"
 #include "u_short_range_module_type.h"
 #include "u_short_range.h"
@@ -63,7 +65,58 @@
 #define U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH  200
 // TODO: is this value correct?
 #define U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH 500
-#define U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS    9
+
+#ifndef U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS
+/** The number of EDM channels, from zero upwards, that connections
+ * may be made on: connections are looked up by indexing directly
+ * with the channel, hence a connect event for a channel beyond this
+ * is ignored.  Each one costs the size of a
+ * uShortRangeEdmStreamConnections_t.
+ */
+# define U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM
+#endif
+
+#ifndef U_SHORT_RANGE_EDM_STREAM_MAX_NUM
+/** The number of EDM streams, i.e. of short-range modules in EDM
+ * mode, that may be open at once; an EDM stream handle is an index
+ * into this many instances and is also the owner that the pbufs
+ * received by the stream are charged to, hence this cannot be more
+ * than U_SHORT_RANGE_PBUF_OWNER_MAX_NUM.
+ */
+# define U_SHORT_RANGE_EDM_STREAM_MAX_NUM U_SHORT_RANGE_PBUF_OWNER_MAX_NUM
+#endif
+
+#ifndef U_SHORT_RANGE_EDM_STREAM_UART_READ_BUFFER_LENGTH_BYTES
+/** The size of the buffer that data is read into from the UART
+ * before being parsed; there is one of these for each open EDM
+ * stream, allocated when the stream is opened.
+ */
+# define U_SHORT_RANGE_EDM_STREAM_UART_READ_BUFFER_LENGTH_BYTES 1024
+#endif
+
+#ifndef U_SHORT_RANGE_EDM_STREAM_TX_IO_VEC_MAX_NUM
+/** The maximum number of pieces (EDM headers, payload fragments and
+ * tails) that EDM data frames are gathered into before being sent
+ * with a single call to uPortUartWritev(); this many
+ * uPortUartIoVec_t structures are put on the stack when writing.
+ */
+# define U_SHORT_RANGE_EDM_STREAM_TX_IO_VEC_MAX_NUM 12
+#endif
+
+#ifndef U_SHORT_RANGE_EDM_STREAM_IP_FRAME_SIZE_DEFAULT_BYTES
+/** The largest EDM data frame that data written to an IP (or MQTT)
+ * connection is split into when the connection is made, see
+ * uShortRangeEdmStreamFrameSizeSet(); the module does any TCP
+ * segmentation itself so, where the module firmware allows it,
+ * larger frames mean less EDM overhead per byte.  Cannot be more
+ * than U_SHORT_RANGE_EDM_MAX_SIZE.
+ */
+# define U_SHORT_RANGE_EDM_STREAM_IP_FRAME_SIZE_DEFAULT_BYTES U_SHORT_RANGE_EDM_MAX_SIZE
+#endif
+
+/** The maximum number of whole EDM data frames in a TX batch.
+ */
+#define U_SHORT_RANGE_EDM_STREAM_TX_FRAMES_MAX_NUM (U_SHORT_RANGE_EDM_STREAM_TX_IO_VEC_MAX_NUM / 3)
 
 #ifndef U_EDM_STREAM_TASK_STACK_SIZE_BYTES
 #define U_EDM_STREAM_TASK_STACK_SIZE_BYTES  U_AT_CLIENT_URC_TASK_STACK_SIZE_BYTES
@@ -151,6 +204,7 @@ typedef struct {
 } uShortRangeEdmStreamDataEvent_t;
 
 typedef struct {
+    struct uEdmStreamInstance_t *pInstance;
     uShortRangeEdmStreamEventType_t type;
     union {
         // no content in at event       at;
@@ -165,17 +219,24 @@ typedef struct {
     int32_t frameSize;
 } uBtConnectionParams_t;
 
+typedef struct {
+    int32_t frameSize;
+} uIpConnectionParams_t;
+
 typedef struct {
     int32_t channel;
     uShortRangeConnectionType_t type;
     union {
         uBtConnectionParams_t bt;
+        uIpConnectionParams_t ip; /**< also used for MQTT. */
     };
 } uShortRangeEdmStreamConnections_t;
 
 typedef struct uEdmStreamInstance_t {
-    bool ignoreUartCallback;
-    int32_t handle;
+    uPortMutexHandle_t mutex; /**< protects everything below. */
+    volatile bool ignoreUartCallback;
+    int32_t handle;           /**< the index of this instance, -1 if
+                                   not open. */
     int32_t uartHandle;
     void *atHandle;
     int32_t eventQueueHandle;
@@ -198,15 +259,43 @@ typedef struct uEdmStreamInstance_t {
     char *pAtResponseBuffer;
     int32_t atResponseLength;
     int32_t atResponseRead;
+    /** Indexed by channel, see pConnectionEntry(). */
     uShortRangeEdmStreamConnections_t connections[U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS];
+    volatile bool rxKickNeeded; /**< set while receive is stalled and
+                                     has not been kicked since. */
+    int32_t rxStallStartMs;
+    uShortRangeEdmStreamRxStats_t rxStats;
+    uShortRangeEdmParser_t parser;
+    char *pRxBuffer;          /**< data read from the UART, of size
+                                   U_SHORT_RANGE_EDM_STREAM_UART_READ_BUFFER_LENGTH_BYTES. */
+    size_t rxStartIndex;      /**< where unparsed data begins in pRxBuffer. */
+    size_t rxCharsInBuffer;   /**< the amount of unparsed data in pRxBuffer. */
 } uShortRangeEdmStreamInstance_t;
 
+/** EDM data frames gathered together so that they can be sent
+ * with a single call to uPortUartWritev().
+ */
+typedef struct {
+    int32_t uartHandle;
+    uPortUartIoVec_t ioVec[U_SHORT_RANGE_EDM_STREAM_TX_IO_VEC_MAX_NUM];
+    char head[U_SHORT_RANGE_EDM_STREAM_TX_FRAMES_MAX_NUM][U_SHORT_RANGE_EDM_DATA_HEAD_SIZE];
+    char tail[U_SHORT_RANGE_EDM_TAIL_SIZE];
+    size_t numIoVec;
+    size_t numFrames;
+    size_t length;   /**< the total number of bytes at ioVec. */
+    bool error;      /**< set if a uPortUartWritev() came up short. */
+} uShortRangeEdmStreamTxBatch_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** Protects opening and closing of the instances; each instance
+ * has its own mutex for everything else, so that EDM streams on
+ * different UARTs do not hold each other up.
+ */
 static uPortMutexHandle_t gMutex = NULL;
-static uShortRangeEdmStreamInstance_t gEdmStream;
+static uShortRangeEdmStreamInstance_t gEdmStream[U_SHORT_RANGE_EDM_STREAM_MAX_NUM];
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -274,116 +363,212 @@ static const char *getProtocolText(uShortRangeIpProtocol_t protocol)
 
 #endif
 
-// Find connection from channel, use -1 to get the first free slot
-static uShortRangeEdmStreamConnections_t *findConnection(int32_t channel)
+// Get the instance for a handle, locked, or NULL, with nothing
+// locked, if the handle is not that of an open EDM stream; gMutex
+// must not be NULL.  Unlock with uPortMutexUnlock(pInstance->mutex).
+static uShortRangeEdmStreamInstance_t *pInstanceLock(int32_t handle)
+{
+    uShortRangeEdmStreamInstance_t *pInstance = NULL;
+
+    if ((handle >= 0) && (handle < U_SHORT_RANGE_EDM_STREAM_MAX_NUM)) {
+        pInstance = &(gEdmStream[handle]);
+        uPortMutexLock(pInstance->mutex);
+        if (pInstance->handle != handle) {
+            uPortMutexUnlock(pInstance->mutex);
+            pInstance = NULL;
+        }
+    }
+
+    return pInstance;
+}
+
+// Get the connection entry for a channel, whether it is in use
+// or not, NULL if the channel is out of range.
+static uShortRangeEdmStreamConnections_t *pConnectionEntry(uShortRangeEdmStreamInstance_t
+                                                            *pInstance,
+                                                            int32_t channel)
 {
     uShortRangeEdmStreamConnections_t *pConnection = NULL;
 
-    for (uint32_t i = 0; i < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS; i++) {
-        if (gEdmStream.connections[i].channel == channel) {
-            pConnection = &gEdmStream.connections[i];
-            break;
-        }
+    if ((channel >= 0) && (channel < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS)) {
+        pConnection = &pInstance->connections[channel];
     }
 
     return pConnection;
 }
 
-static void processedEvent(void)
+// Find the connection on a channel, NULL if there is none.
+static uShortRangeEdmStreamConnections_t *findConnection(uShortRangeEdmStreamInstance_t *pInstance,
+                                                          int32_t channel)
+{
+    uShortRangeEdmStreamConnections_t *pConnection = pConnectionEntry(pInstance, channel);
+
+    if ((pConnection != NULL) && (pConnection->channel != channel)) {
+        pConnection = NULL;
+    }
+
+    return pConnection;
+}
+
+// Trigger an event from the uart to get parsing going again.
+static void kickUart(const uShortRangeEdmStreamInstance_t *pInstance)
 {
     int32_t sendErrorCode;
 
-    uShortRangeEdmResetParser();
-    // Trigger an event from the uart to get parsing going again
     // First use the "try" version so as not to block, which can
     // lead to mutex lock-outs if the queue is full: if the "try"
     // version is not supported on this platform then fall back
     // to the blocking version; there is no danger here since,
     // if there are already events in the UART queue, the URC
     // callback will certainly be run anyway.
-    sendErrorCode = uPortUartEventTrySend(gEdmStream.uartHandle,
+    sendErrorCode = uPortUartEventTrySend(pInstance->uartHandle,
                                           U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
                                           0);
     if ((sendErrorCode == (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED) ||
         (sendErrorCode == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED)) {
-        uPortUartEventSend(gEdmStream.uartHandle,
+        uPortUartEventSend(pInstance->uartHandle,
                            U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED);
     }
 }
 
-static void atEventHandler(void)
+static void processedEvent(uShortRangeEdmStreamInstance_t *pInstance)
+{
+    uShortRangeEdmResetParser(&(pInstance->parser));
+    kickUart(pInstance);
+}
+
+// Note that receive has stalled for want of memory, if it has
+// not already; must be called with the instance locked.
+static void rxStall(uShortRangeEdmStreamInstance_t *pInstance)
 {
-    if (gEdmStream.pAtCallback != NULL) {
-        gEdmStream.pAtCallback(gEdmStream.handle,
+    int32_t channel;
+
+    if (!pInstance->rxStats.stalled) {
+        channel = uShortRangeEdmRxQuotaStalledChannel(&(pInstance->parser));
+        pInstance->rxStallStartMs = uPortGetTickTimeMs();
+        pInstance->rxStats.stalled = true;
+        pInstance->rxStats.stalledChannel = channel;
+        pInstance->rxStats.stallCount++;
+        if (channel >= 0) {
+            pInstance->rxStats.quotaStallCount++;
+        }
+        uEdmChLogLine(LOG_CH_DATA, "RX stalled (channel %d)", channel);
+    }
+    // Ask pbufFreeCallback() to kick us when memory is freed
+    pInstance->rxKickNeeded = true;
+}
+
+// Note that receive is no longer stalled; must be called with
+// the instance locked.
+static void rxStallEnd(uShortRangeEdmStreamInstance_t *pInstance)
+{
+    int32_t durationMs = uPortGetTickTimeMs() - pInstance->rxStallStartMs;
+
+    pInstance->rxKickNeeded = false;
+    pInstance->rxStats.stalled = false;
+    pInstance->rxStats.stalledChannel = -1;
+    pInstance->rxStats.stallTimeMs += durationMs;
+    if (durationMs > pInstance->rxStats.stallTimeMaxMs) {
+        pInstance->rxStats.stallTimeMaxMs = durationMs;
+    }
+    uEdmChLogLine(LOG_CH_DATA, "RX resumed after %d ms", durationMs);
+}
+
+// Called, in the context of whoever freed them, when pbufs have been
+// freed: if receive on any EDM stream is stalled for want of memory,
+// get it going again; there is no lock here, a spare kick does no harm.
+static void pbufFreeCallback(void *pParam)
+{
+    uShortRangeEdmStreamInstance_t *pInstance;
+
+    (void) pParam;
+
+    for (size_t x = 0; x < sizeof(gEdmStream) / sizeof(gEdmStream[0]); x++) {
+        pInstance = &(gEdmStream[x]);
+        if (pInstance->rxKickNeeded && (pInstance->uartHandle >= 0)) {
+            pInstance->rxKickNeeded = false;
+            kickUart(pInstance);
+        }
+    }
+}
+
+static void atEventHandler(uShortRangeEdmStreamInstance_t *pInstance)
+{
+    if (pInstance->pAtCallback != NULL) {
+        pInstance->pAtCallback(pInstance->handle,
                                U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
-                               gEdmStream.pAtCallbackParam);
+                               pInstance->pAtCallbackParam);
     }
     // This event is not fully processed until uShortRangeEdmStreamAtRead has been called
     // and all event data been read out
 }
 
 // Event handler, calls the user's event callback.
-static void btEventHandler(uShortRangeEdmStreamBtEvent_t *pBtEvent)
+static void btEventHandler(uShortRangeEdmStreamInstance_t *pInstance,
+                           uShortRangeEdmStreamBtEvent_t *pBtEvent)
 {
-    if (gEdmStream.pBtEventCallback != NULL) {
-        gEdmStream.pBtEventCallback(gEdmStream.handle, pBtEvent->channel, pBtEvent->type,
-                                    &pBtEvent->conData, gEdmStream.pBtEventCallbackParam);
+    if (pInstance->pBtEventCallback != NULL) {
+        pInstance->pBtEventCallback(pInstance->handle, pBtEvent->channel, pBtEvent->type,
+                                    &pBtEvent->conData, pInstance->pBtEventCallbackParam);
     }
     uEdmChLogLine(LOG_CH_BT, "processed");
-    processedEvent();
+    processedEvent(pInstance);
 }
 
 // Event handler, calls the user's event callback.
-static void ipEventHandler(uShortRangeEdmStreamIpEvent_t *pIpEvent)
+static void ipEventHandler(uShortRangeEdmStreamInstance_t *pInstance,
+                           uShortRangeEdmStreamIpEvent_t *pIpEvent)
 {
-    if (gEdmStream.pIpEventCallback != NULL) {
-        gEdmStream.pIpEventCallback(gEdmStream.handle, pIpEvent->channel, pIpEvent->type,
-                                    &pIpEvent->conData, gEdmStream.pIpEventCallbackParam);
+    if (pInstance->pIpEventCallback != NULL) {
+        pInstance->pIpEventCallback(pInstance->handle, pIpEvent->channel, pIpEvent->type,
+                                    &pIpEvent->conData, pInstance->pIpEventCallbackParam);
     }
 
     uEdmChLogLine(LOG_CH_IP, "processed");
-    processedEvent();
+    processedEvent(pInstance);
 }
 
 // Event handler, calls the user's event callback.
-static void mqttEventHandler(uShortRangeEdmStreamIpEvent_t *pMqttEvent)
+static void mqttEventHandler(uShortRangeEdmStreamInstance_t *pInstance,
+                             uShortRangeEdmStreamIpEvent_t *pMqttEvent)
 {
-    if (gEdmStream.pMqttEventCallback != NULL) {
-        gEdmStream.pMqttEventCallback(gEdmStream.handle, pMqttEvent->channel, pMqttEvent->type,
-                                      &pMqttEvent->conData, gEdmStream.pMqttEventCallbackParam);
+    if (pInstance->pMqttEventCallback != NULL) {
+        pInstance->pMqttEventCallback(pInstance->handle, pMqttEvent->channel, pMqttEvent->type,
+                                      &pMqttEvent->conData, pInstance->pMqttEventCallbackParam);
     }
     uEdmChLogLine(LOG_CH_IP, "processed");
-    processedEvent();
+    processedEvent(pInstance);
 }
 
-static void dataEventHandler(uShortRangeEdmStreamDataEvent_t *pDataEvent)
+static void dataEventHandler(uShortRangeEdmStreamInstance_t *pInstance,
+                             uShortRangeEdmStreamDataEvent_t *pDataEvent)
 {
     uShortRangeEdmStreamConnections_t *pConnection;
     volatile uEdmDataEventCallback_t pDataCallback = NULL;
     volatile void *pCallbackParam = NULL;
     volatile int32_t edmStreamHandle = -1;
 
-    uPortMutexLock(gMutex);
-    pConnection = findConnection(pDataEvent->channel);
+    uPortMutexLock(pInstance->mutex);
+    pConnection = findConnection(pInstance, pDataEvent->channel);
 
     if (pConnection != NULL) {
-        edmStreamHandle = gEdmStream.handle;
+        edmStreamHandle = pInstance->handle;
 
         switch (pConnection->type) {
 
             case U_SHORT_RANGE_CONNECTION_TYPE_BT:
-                pDataCallback = gEdmStream.pBtDataCallback;
-                pCallbackParam = gEdmStream.pBtDataCallbackParam;
+                pDataCallback = pInstance->pBtDataCallback;
+                pCallbackParam = pInstance->pBtDataCallbackParam;
                 break;
 
             case U_SHORT_RANGE_CONNECTION_TYPE_IP:
-                pDataCallback = gEdmStream.pIpDataCallback;
-                pCallbackParam = gEdmStream.pIpDataCallbackParam;
+                pDataCallback = pInstance->pIpDataCallback;
+                pCallbackParam = pInstance->pIpDataCallbackParam;
                 break;
 
             case U_SHORT_RANGE_CONNECTION_TYPE_MQTT:
-                pDataCallback = gEdmStream.pMqttDataCallback;
-                pCallbackParam = gEdmStream.pMqttDataCallbackParam;
+                pDataCallback = pInstance->pMqttDataCallback;
+                pCallbackParam = pInstance->pMqttDataCallbackParam;
                 break;
 
             case U_SHORT_RANGE_CONNECTION_TYPE_INVALID:
@@ -395,16 +580,16 @@ static void dataEventHandler(uShortRangeEdmStreamDataEvent_t *pDataEvent)
     if (pDataCallback != NULL) {
         // Make sure we release the lock before calling the callback
         // otherwise this may result in a deadlock
-        uPortMutexUnlock(gMutex);
+        uPortMutexUnlock(pInstance->mutex);
         //lint -e(1773) Suppress "attempt to cast away const"
         pDataCallback(edmStreamHandle, pDataEvent->channel, pDataEvent->pBufList,
                       (void *)pCallbackParam);
-        uPortMutexLock(gMutex);
+        uPortMutexLock(pInstance->mutex);
     }
 
     uEdmChLogLine(LOG_CH_DATA, "processed");
-    processedEvent();
-    uPortMutexUnlock(gMutex);
+    processedEvent(pInstance);
+    uPortMutexUnlock(pInstance->mutex);
 }
 
 static void eventHandler(void *pParam, size_t paramLength)
@@ -419,23 +604,23 @@ static void eventHandler(void *pParam, size_t paramLength)
     switch (pEvent->type) {
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_AT:
-            atEventHandler();
+            atEventHandler(pEvent->pInstance);
             break;
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_BT:
-            btEventHandler(&(pEvent->bt));
+            btEventHandler(pEvent->pInstance, &(pEvent->bt));
             break;
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_IP:
-            ipEventHandler(&(pEvent->ip));
+            ipEventHandler(pEvent->pInstance, &(pEvent->ip));
             break;
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_MQTT:
-            mqttEventHandler(&(pEvent->mqtt));
+            mqttEventHandler(pEvent->pInstance, &(pEvent->mqtt));
             break;
 
         case U_SHORT_RANGE_EDM_STREAM_EVENT_DATA:
-            dataEventHandler(&(pEvent->data));
+            dataEventHandler(pEvent->pInstance, &(pEvent->data));
             break;
 
         default:
@@ -443,26 +628,28 @@ static void eventHandler(void *pParam, size_t paramLength)
     }
 }
 
-static bool enqueueEdmAtEvent(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmAtEvent(uShortRangeEdmStreamInstance_t *pInstance,
+                              uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
     uShortRangeEdmStreamEvent_t event;
 
     uShortRangePbufList_t *pBufList = pEvent->params.atEvent.pBufList;
-    gEdmStream.atResponseLength = (int32_t)pBufList->totalLen;
-    gEdmStream.atResponseRead = 0;
-    uShortRangePbufListConsumeData(pBufList, gEdmStream.pAtResponseBuffer,
-                                   gEdmStream.atResponseLength);
+    pInstance->atResponseLength = (int32_t)pBufList->totalLen;
+    pInstance->atResponseRead = 0;
+    uShortRangePbufListConsumeData(pBufList, pInstance->pAtResponseBuffer,
+                                   pInstance->atResponseLength);
     uShortRangePbufListFree(pBufList);
 
 #ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
     uEdmChLogStart(LOG_CH_AT_RX, "\"");
-    dumpAtData(gEdmStream.pAtResponseBuffer, gEdmStream.atResponseLength);
+    dumpAtData(pInstance->pAtResponseBuffer, pInstance->atResponseLength);
     uEdmChLogEnd("\"");
 #endif
 
+    event.pInstance = pInstance;
     event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_AT;
-    if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+    if (uPortEventQueueSend(pInstance->eventQueueHandle,
                             &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
         success = true;
     } else {
@@ -472,18 +659,17 @@ static bool enqueueEdmAtEvent(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmConnectBtEvent(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmConnectBtEvent(uShortRangeEdmStreamInstance_t *pInstance,
+                                     uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uShortRangeEdmStreamConnections_t *pConnection =
-        findConnection(pEvent->params.btConnectEvent.channel);
+        pConnectionEntry(pInstance, pEvent->params.btConnectEvent.channel);
 
-    if (pConnection == NULL) {
-        pConnection = findConnection(-1);
-    }
     if (pConnection != NULL) {
         uShortRangeEdmStreamEvent_t event;
+        event.pInstance = pInstance;
         pConnection->channel = pEvent->params.btConnectEvent.channel;
         pConnection->type = U_SHORT_RANGE_CONNECTION_TYPE_BT;
         pConnection->bt.frameSize = pEvent->params.btConnectEvent.connection.framesize;
@@ -499,7 +685,7 @@ static bool enqueueEdmConnectBtEvent(uShortRangeEdmEvent_t *pEvent)
         uEdmChLogEnd("");
 #endif
 
-        if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+        if (uPortEventQueueSend(pInstance->eventQueueHandle,
                                 &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
             success = true;
         } else {
@@ -510,18 +696,17 @@ static bool enqueueEdmConnectBtEvent(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmConnectIpv4Event(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmConnectIpv4Event(uShortRangeEdmStreamInstance_t *pInstance,
+                                       uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uShortRangeEdmStreamConnections_t *pConnection =
-        findConnection(pEvent->params.ipv4ConnectEvent.channel);
+        pConnectionEntry(pInstance, pEvent->params.ipv4ConnectEvent.channel);
 
-    if (pConnection == NULL) {
-        pConnection = findConnection(-1);
-    }
     if (pConnection != NULL) {
         uShortRangeEdmStreamEvent_t event;
+        event.pInstance = pInstance;
         uShortRangeEdmConnectionEventIpv4_t *ipv4Evt = &pEvent->params.ipv4ConnectEvent;
         uShortRangeIpProtocol_t protocol = ipv4Evt->connection.protocol;
         // IPv4 events are generated by TCP, UDP and MQTT connections
@@ -540,6 +725,7 @@ static bool enqueueEdmConnectIpv4Event(uShortRangeEdmEvent_t *pEvent)
 
         if (pConnection->type != U_SHORT_RANGE_CONNECTION_TYPE_INVALID) {
             pConnection->channel = ipv4Evt->channel;
+            pConnection->ip.frameSize = U_SHORT_RANGE_EDM_STREAM_IP_FRAME_SIZE_DEFAULT_BYTES;
 
             event.ip.type = U_SHORT_RANGE_EVENT_CONNECTED;
             event.ip.channel = ipv4Evt->channel;
@@ -559,7 +745,7 @@ static bool enqueueEdmConnectIpv4Event(uShortRangeEdmEvent_t *pEvent)
                           rIp[0], rIp[1], rIp[2], rIp[3], rPort);
 #endif
 
-            if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+            if (uPortEventQueueSend(pInstance->eventQueueHandle,
                                     &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                 success = true;
             } else {
@@ -571,18 +757,17 @@ static bool enqueueEdmConnectIpv4Event(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmConnectIpv6Event(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmConnectIpv6Event(uShortRangeEdmStreamInstance_t *pInstance,
+                                       uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uShortRangeEdmStreamConnections_t *pConnection =
-        findConnection(pEvent->params.ipv6ConnectEvent.channel);
+        pConnectionEntry(pInstance, pEvent->params.ipv6ConnectEvent.channel);
 
-    if (pConnection == NULL) {
-        pConnection = findConnection(-1);
-    }
     if (pConnection != NULL) {
         uShortRangeEdmStreamEvent_t event;
+        event.pInstance = pInstance;
         uShortRangeEdmConnectionEventIpv6_t *ipv6Evt = &pEvent->params.ipv6ConnectEvent;
         uShortRangeIpProtocol_t protocol = ipv6Evt->connection.protocol;
         // IPv4 events are generated by TCP, UDP and MQTT connections
@@ -601,6 +786,7 @@ static bool enqueueEdmConnectIpv6Event(uShortRangeEdmEvent_t *pEvent)
 
         if (pConnection->type != U_SHORT_RANGE_CONNECTION_TYPE_INVALID) {
             pConnection->channel = ipv6Evt->channel;
+            pConnection->ip.frameSize = U_SHORT_RANGE_EDM_STREAM_IP_FRAME_SIZE_DEFAULT_BYTES;
 
             event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_IP;
             event.ip.type = U_SHORT_RANGE_EVENT_CONNECTED;
@@ -615,7 +801,7 @@ static bool enqueueEdmConnectIpv6Event(uShortRangeEdmEvent_t *pEvent)
                           event.ip.channel, protocolTxt, lPort, rPort);
 #endif
 
-            if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+            if (uPortEventQueueSend(pInstance->eventQueueHandle,
                                     &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                 success = true;
             } else {
@@ -627,15 +813,17 @@ static bool enqueueEdmConnectIpv6Event(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmDisconnectEvent(uShortRangeEdmStreamInstance_t *pInstance,
+                                      uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uint8_t channel = pEvent->params.disconnectEvent.channel;
-    uShortRangeEdmStreamConnections_t *pConnection = findConnection(channel);
+    uShortRangeEdmStreamConnections_t *pConnection = findConnection(pInstance, channel);
 
     if (pConnection != NULL) {
         uShortRangeEdmStreamEvent_t event;
+        event.pInstance = pInstance;
         switch (pConnection->type) {
             case U_SHORT_RANGE_CONNECTION_TYPE_BT:
                 event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_BT;
@@ -644,7 +832,7 @@ static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
 #ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
                 uEdmChLogLine(LOG_CH_BT, "ch: %d, disconnect", channel);
 #endif
-                if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+                if (uPortEventQueueSend(pInstance->eventQueueHandle,
                                         &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                     success = true;
                 } else {
@@ -659,7 +847,7 @@ static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
 #ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
                 uEdmChLogLine(LOG_CH_IP, "ch: %d, disconnect", channel);
 #endif
-                if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+                if (uPortEventQueueSend(pInstance->eventQueueHandle,
                                         &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                     success = true;
                 } else {
@@ -674,7 +862,7 @@ static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
 #ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
                 uEdmChLogLine(LOG_CH_IP, "ch: %d, disconnect", channel);
 #endif
-                if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+                if (uPortEventQueueSend(pInstance->eventQueueHandle,
                                         &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
                     success = true;
                 } else {
@@ -692,11 +880,13 @@ static bool enqueueEdmDisconnectEvent(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static bool enqueueEdmDataEvent(uShortRangeEdmEvent_t *pEvent)
+static bool enqueueEdmDataEvent(uShortRangeEdmStreamInstance_t *pInstance,
+                                uShortRangeEdmEvent_t *pEvent)
 {
     bool success = false;
 
     uShortRangeEdmStreamEvent_t event;
+    event.pInstance = pInstance;
     event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_DATA;
     event.data.channel = pEvent->params.dataEvent.channel;
     event.data.pBufList = pEvent->params.dataEvent.pBufList;
@@ -713,7 +903,7 @@ static bool enqueueEdmDataEvent(uShortRangeEdmEvent_t *pEvent)
 # endif
 #endif
     }
-    if (uPortEventQueueSend(gEdmStream.eventQueueHandle,
+    if (uPortEventQueueSend(pInstance->eventQueueHandle,
                             &event, sizeof(uShortRangeEdmStreamEvent_t)) == 0) {
         success = true;
     } else {
@@ -723,34 +913,36 @@ static bool enqueueEdmDataEvent(uShortRangeEdmEvent_t *pEvent)
     return success;
 }
 
-static void processEdmEvent(uShortRangeEdmEvent_t *pEvent)
+static void processEdmEvent(uShortRangeEdmStreamInstance_t *pInstance,
+                            uShortRangeEdmEvent_t *pEvent)
 {
     bool enqueued = false;
 
+    U_TRACE(EDM_RX_EVENT, pEvent->type);
     switch (pEvent->type) {
 
         case U_SHORT_RANGE_EDM_EVENT_AT:
-            enqueued = enqueueEdmAtEvent(pEvent);
+            enqueued = enqueueEdmAtEvent(pInstance, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_CONNECT_BT:
-            enqueued = enqueueEdmConnectBtEvent(pEvent);
+            enqueued = enqueueEdmConnectBtEvent(pInstance, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_DISCONNECT:
-            enqueued = enqueueEdmDisconnectEvent(pEvent);
+            enqueued = enqueueEdmDisconnectEvent(pInstance, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_DATA:
-            enqueued = enqueueEdmDataEvent(pEvent);
+            enqueued = enqueueEdmDataEvent(pInstance, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_CONNECT_IPv4:
-            enqueued = enqueueEdmConnectIpv4Event(pEvent);
+            enqueued = enqueueEdmConnectIpv4Event(pInstance, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_CONNECT_IPv6:
-            enqueued = enqueueEdmConnectIpv6Event(pEvent);
+            enqueued = enqueueEdmConnectIpv6Event(pInstance, pEvent);
             break;
 
         case U_SHORT_RANGE_EDM_EVENT_INVALID: /* Intentional fallthrough */
@@ -762,76 +954,118 @@ static void processEdmEvent(uShortRangeEdmEvent_t *pEvent)
 
     if (!enqueued) {
         /* No event was enqueued to the event queue so we simply consume the event */
-        processedEvent();
+        processedEvent(pInstance);
     }
 }
 
 static void uartCallback(int32_t uartHandle, uint32_t eventBitmask,
                          void *pParameters)
 {
-    (void)pParameters;
+    uShortRangeEdmStreamInstance_t *pInstance = (uShortRangeEdmStreamInstance_t *) pParameters;
     bool memAvailable = true;
+    bool retried = false;
 
-    if ((gEdmStream.uartHandle == uartHandle) &&
-        !gEdmStream.ignoreUartCallback &&
+    if ((pInstance != NULL) && (pInstance->uartHandle == uartHandle) &&
+        !pInstance->ignoreUartCallback &&
         (eventBitmask == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
         bool uartEmpty = false;
         // We don't want to read one character at the time from the uart driver since that will be
         // quite an overhead when pumping a lot of data. Instead we read into a buffer
-        // and then comsume characters from that. But we might not consume all read characters
+        // and then parse that in one go. But we might not consume all read characters
         // before an EDM-event is generated by the parser which makes the parser unavailable
         // and we have to leave this callback. When the parser later is available this
         // uart-event will be placed on the queue again so that we come back here.
-        // We thus need a static buffer, and if there are unparsed characters left in it we move
-        // them to the beginning of the buffer befor leaving (instead of using a ring buffer).
-        U_PORT_MUTEX_LOCK(gMutex);
-        while (!uartEmpty && uShortRangeEdmParserReady() && memAvailable) {
+        // We thus need a buffer per instance, and if there are unparsed characters left in it we
+        // carry on from where we were; they are only moved to the beginning of the buffer
+        // when there is no room left at the end (instead of using a ring buffer).
+        U_PORT_MUTEX_LOCK(pInstance->mutex);
+        while (!uartEmpty && (pInstance->pRxBuffer != NULL) &&
+               uShortRangeEdmParserReady(&(pInstance->parser)) && memAvailable) {
             // Loop until we couldn't read any more characters from uart
             // or EDM parser is unavailable
             // or no pbuf memory is available
-            static char buffer[128];
-            static size_t charsInBuffer = 0;
-            size_t consumed = 0;
-
-            // Check if there are any existing characters in the buffer and parse them
-            while (uShortRangeEdmParserReady() && (consumed < charsInBuffer) && memAvailable) {
-                //lint -esym(727, buffer)
-                uShortRangeEdmEvent_t *pEvent = NULL;
-                // when there is no memory available in the pool to intake
-                // the data, this call would return false.In such
-                // cases hardware flow control will be triggered if
-                // UART H/W Rx FIFO is full.
-                if (uShortRangeEdmParse(buffer[consumed], &pEvent, &memAvailable)) {
-                    consumed++;
+            char *pBuffer = pInstance->pRxBuffer;
+            size_t bufferSize = U_SHORT_RANGE_EDM_STREAM_UART_READ_BUFFER_LENGTH_BYTES;
+            uShortRangeEdmEvent_t *pEvent = NULL;
+            size_t consumed;
+
+            // Parse any existing characters in the buffer, event by event;
+            // when there is no memory available in the pool to intake
+            // the data memAvailable will be false, in which case hardware
+            // flow control will be triggered if UART H/W Rx FIFO is full.
+            while (uShortRangeEdmParserReady(&(pInstance->parser)) &&
+                   (pInstance->rxCharsInBuffer > 0) && memAvailable) {
+                consumed = uShortRangeEdmParseBuffer(&(pInstance->parser),
+                                                     pBuffer + pInstance->rxStartIndex,
+                                                     pInstance->rxCharsInBuffer,
+                                                     &pEvent, &memAvailable);
+                pInstance->rxStartIndex += consumed;
+                pInstance->rxCharsInBuffer -= consumed;
+                if (!memAvailable) {
+                    rxStall(pInstance);
+                    if (!retried) {
+                        // Now that a free will kick us, try once more in
+                        // case memory was freed before rxStall() was called
+                        retried = true;
+                        memAvailable = true;
+                    }
+                } else if (pInstance->rxStats.stalled) {
+                    rxStallEnd(pInstance);
                 }
                 if (pEvent != NULL) {
-                    processEdmEvent(pEvent);
+                    processEdmEvent(pInstance, pEvent);
+                    pEvent = NULL;
                 }
             }
-            // Move unparsed data to beginning of buffer
-            if ((consumed > 0) && (charsInBuffer - consumed) > 0) {
-                memmove(buffer, buffer + consumed, charsInBuffer - consumed);
+            if (pInstance->rxCharsInBuffer == 0) {
+                pInstance->rxStartIndex = 0;
+            } else if (pInstance->rxStartIndex + pInstance->rxCharsInBuffer == bufferSize) {
+                // No room at the end, move unparsed data to beginning of buffer
+                memmove(pBuffer, pBuffer + pInstance->rxStartIndex, pInstance->rxCharsInBuffer);
+                pInstance->rxStartIndex = 0;
             }
-            charsInBuffer -= consumed;
 
             // Read as much as possible from uart into rest of buffer
-            if (charsInBuffer < sizeof buffer) {
-                int32_t sizeOrError = uPortUartRead(gEdmStream.uartHandle, buffer + charsInBuffer,
-                                                    sizeof buffer - charsInBuffer);
+            if (pInstance->rxStartIndex + pInstance->rxCharsInBuffer < bufferSize) {
+                int32_t sizeOrError = uPortUartRead(pInstance->uartHandle,
+                                                    pBuffer + pInstance->rxStartIndex +
+                                                    pInstance->rxCharsInBuffer,
+                                                    bufferSize - (pInstance->rxStartIndex +
+                                                                  pInstance->rxCharsInBuffer));
                 if (sizeOrError > 0) {
-                    charsInBuffer += sizeOrError;
+                    pInstance->rxCharsInBuffer += sizeOrError;
                 } else {
                     uartEmpty = true;
                 }
+            } else {
+                // Buffer full of unparsed data: leave it until the
+                // event is processed
+                uartEmpty = true;
             }
         }
-        U_PORT_MUTEX_UNLOCK(gMutex);
+        U_PORT_MUTEX_UNLOCK(pInstance->mutex);
     }
 }
 
 static void flushUart(int32_t uartHandle)
 {
+    const char *pData;
     int32_t length = uPortUartGetReceiveSize(uartHandle);
+    int32_t spanLength = uPortUartReadSpan(uartHandle, &pData);
+
+    // Where the UART supports it, just let go of what has been
+    // received, rather than reading it into a temporary buffer
+    while ((length > 0) && (spanLength > 0)) {
+        if (spanLength > length) {
+            spanLength = length;
+        }
+        if (uPortUartReleaseSpan(uartHandle, (size_t) spanLength) == 0) {
+            length -= spanLength;
+            spanLength = uPortUartReadSpan(uartHandle, &pData);
+        } else {
+            spanLength = -1;
+        }
+    }
 
     if (length > 0) {
         char *pDummy = (char *)malloc(length);
@@ -840,12 +1074,154 @@ static void flushUart(int32_t uartHandle)
     }
 }
 
-static int32_t uartWrite(const void *pData, size_t length)
+static int32_t uartWrite(const uShortRangeEdmStreamInstance_t *pInstance,
+                         const void *pData, size_t length)
 {
-    return uPortUartWrite(gEdmStream.uartHandle,
+    return uPortUartWrite(pInstance->uartHandle,
                           pData, length);
 }
 
+// Initialise a TX batch.
+static void txBatchInit(uShortRangeEdmStreamTxBatch_t *pBatch, int32_t uartHandle)
+{
+    pBatch->uartHandle = uartHandle;
+    pBatch->numIoVec = 0;
+    pBatch->numFrames = 0;
+    pBatch->length = 0;
+    pBatch->error = false;
+    (void)uShortRangeEdmZeroCopyTail(pBatch->tail);
+}
+
+// Write what is in a TX batch to the UART and empty it.
+static void txBatchFlush(uShortRangeEdmStreamTxBatch_t *pBatch)
+{
+    int32_t written;
+
+    if (pBatch->numIoVec > 0) {
+#if defined(U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG) && defined(U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG_DUMP_DATA)
+        uEdmChLogStart(LOG_CH_DATA, "TX (%d bytes, including EDM overhead): ",
+                       (int32_t) pBatch->length);
+        for (size_t x = 0; x < pBatch->numIoVec; x++) {
+            dumpHexData((const uint8_t *) pBatch->ioVec[x].pBase, pBatch->ioVec[x].length);
+        }
+        uEdmChLogEnd("");
+#endif
+        written = uPortUartWritev(pBatch->uartHandle, pBatch->ioVec, pBatch->numIoVec);
+        U_TRACE(EDM_TX, written);
+        if (written != (int32_t) pBatch->length) {
+            pBatch->error = true;
+        }
+    }
+    pBatch->numIoVec = 0;
+    pBatch->numFrames = 0;
+    pBatch->length = 0;
+}
+
+// Add a piece of data to a TX batch, flushing it first if it is full.
+static void txBatchAdd(uShortRangeEdmStreamTxBatch_t *pBatch,
+                       const void *pData, size_t length)
+{
+    if (pBatch->numIoVec >= sizeof(pBatch->ioVec) / sizeof(pBatch->ioVec[0])) {
+        txBatchFlush(pBatch);
+    }
+    pBatch->ioVec[pBatch->numIoVec].pBase = pData;
+    pBatch->ioVec[pBatch->numIoVec].length = length;
+    pBatch->numIoVec++;
+    pBatch->length += length;
+}
+
+// Add an EDM data frame on the given channel, carrying length bytes
+// from offset bytes into the data described by an I/O vector, to a
+// TX batch; the data must remain valid until the batch is flushed.
+static void txBatchAddFrame(uShortRangeEdmStreamTxBatch_t *pBatch,
+                            uint8_t channel, const uSockIoVec_t *pIoVec,
+                            size_t numIoVec, size_t offset, size_t length)
+{
+    char *pHead;
+    size_t thisLength;
+
+    if ((pBatch->numFrames >= sizeof(pBatch->head) / sizeof(pBatch->head[0])) ||
+        (pBatch->numIoVec + 3 > sizeof(pBatch->ioVec) / sizeof(pBatch->ioVec[0]))) {
+        // Make sure that there is room for at least a small frame
+        txBatchFlush(pBatch);
+    }
+    pHead = pBatch->head[pBatch->numFrames];
+    pBatch->numFrames++;
+    (void)uShortRangeEdmZeroCopyHeadData(channel, (uint32_t) length, pHead);
+    txBatchAdd(pBatch, pHead, U_SHORT_RANGE_EDM_DATA_HEAD_SIZE);
+    for (size_t x = 0; (x < numIoVec) && (length > 0); x++) {
+        if (offset >= (pIoVec + x)->length) {
+            // Not there yet
+            offset -= (pIoVec + x)->length;
+        } else {
+            thisLength = (pIoVec + x)->length - offset;
+            if (thisLength > length) {
+                thisLength = length;
+            }
+            // A frame spread over more fragments than the batch has
+            // room for just gets flushed part-way through, which
+            // does no harm
+            txBatchAdd(pBatch, (const char *) (pIoVec + x)->pBase + offset, thisLength);
+            length -= thisLength;
+            offset = 0;
+        }
+    }
+    txBatchAdd(pBatch, pBatch->tail, U_SHORT_RANGE_EDM_TAIL_SIZE);
+}
+
+// Return the size of the largest EDM data frame that may be sent
+// on a connection.
+static int32_t connectionFrameSize(const uShortRangeEdmStreamConnections_t *pConnection)
+{
+    int32_t frameSize = U_SHORT_RANGE_EDM_MAX_SIZE;
+
+    if (pConnection->type == U_SHORT_RANGE_CONNECTION_TYPE_BT) {
+        frameSize = pConnection->bt.frameSize;
+    } else if ((pConnection->type == U_SHORT_RANGE_CONNECTION_TYPE_IP) ||
+               (pConnection->type == U_SHORT_RANGE_CONNECTION_TYPE_MQTT)) {
+        frameSize = pConnection->ip.frameSize;
+    }
+    if ((frameSize <= 0) || (frameSize > U_SHORT_RANGE_EDM_MAX_SIZE)) {
+        frameSize = U_SHORT_RANGE_EDM_MAX_SIZE;
+    }
+
+    return frameSize;
+}
+
+// Add the EDM data frames needed to send sizeBytes of the data
+// described by an I/O vector on a connection to a TX batch, stopping
+// if the time since startTimeMs exceeds timeoutMs.  Returns the
+// number of bytes of data added.
+static int32_t txBatchAddData(uShortRangeEdmStreamTxBatch_t *pBatch,
+                              const uShortRangeEdmStreamConnections_t *pConnection,
+                              const uSockIoVec_t *pIoVec, size_t numIoVec,
+                              size_t sizeBytes, int64_t startTimeMs,
+                              uint32_t timeoutMs)
+{
+    int32_t added = 0;
+    int32_t send;
+    int32_t frameSize = connectionFrameSize(pConnection);
+
+    // Each EDM data frame may carry data from
+    // more than one fragment
+    do {
+        send = ((int32_t)sizeBytes - added);
+        if (send > frameSize) {
+            send = frameSize;
+        }
+
+        uEdmChLogLine(LOG_CH_DATA, "TX (%d bytes) on channel %d", send,
+                      (int32_t) pConnection->channel);
+
+        txBatchAddFrame(pBatch, (uint8_t) pConnection->channel, pIoVec, numIoVec,
+                        added, send);
+        added += send;
+    } while (((int32_t)sizeBytes > added) && !pBatch->error &&
+             (uPortGetTickTimeMs() - startTimeMs < timeoutMs));
+
+    return added;
+}
+
 // Do an EDM send.  Returns the amount written, including
 // EDM packet overhead.
 static int32_t edmSend(const uShortRangeEdmStreamInstance_t *pEdmStream)
@@ -867,7 +1243,7 @@ static int32_t edmSend(const uShortRangeEdmStreamInstance_t *pEdmStream)
             uEdmChLogEnd("\"");
 #endif
             while (written < (uint32_t) sizeOrError) {
-                written += uartWrite((void *) (pPacket + written),
+                written += uartWrite(pEdmStream, (void *) (pPacket + written),
                                      (uint32_t) sizeOrError - written);
             }
         }
@@ -878,45 +1254,45 @@ static int32_t edmSend(const uShortRangeEdmStreamInstance_t *pEdmStream)
 }
 
 // A transmit intercept function.
-//lint -e{818} Suppress 'pContext' could be declared as const:
-// need to follow function signature
 static const char *pInterceptTx(uAtClientHandle_t atHandle,
                                 const char **ppData,
                                 size_t *pLength,
                                 void *pContext)
 {
+    uShortRangeEdmStreamInstance_t *pInstance = (uShortRangeEdmStreamInstance_t *) pContext;
     int32_t x = 0;
 
-    (void) pContext;
     (void) atHandle;
 
     if ((*pLength != 0) || (ppData == NULL)) {
         if (ppData == NULL) {
             // We're being flushed, create and send EDM packet
-            edmSend(&gEdmStream);
+            edmSend(pInstance);
             // Reset buffer
-            gEdmStream.atCommandCurrent = 0;
+            pInstance->atCommandCurrent = 0;
         } else {
             // Send any whole buffer's worths we have
-            while ((*pLength + gEdmStream.atCommandCurrent > U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH) &&
+            while ((*pLength + pInstance->atCommandCurrent >
+                    U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH) &&
                    (x >= 0)) {
-                x = U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH - gEdmStream.atCommandCurrent;
-                memcpy(gEdmStream.pAtCommandBuffer + gEdmStream.atCommandCurrent, *ppData, x);
+                x = U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH - pInstance->atCommandCurrent;
+                memcpy(pInstance->pAtCommandBuffer + pInstance->atCommandCurrent, *ppData, x);
                 *pLength -= x;
                 *ppData += x;
-                gEdmStream.atCommandCurrent = U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH;
+                pInstance->atCommandCurrent = U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH;
                 // Send a chunk
-                x = edmSend(&gEdmStream);
+                x = edmSend(pInstance);
                 if (x < 0) {
                     // Error recovery: tell the caller we've consumed the lot
                     *ppData += *pLength;
                     *pLength = 0;
                 }
-                gEdmStream.atCommandCurrent = 0;
+                pInstance->atCommandCurrent = 0;
             }
             // Copy in any partial buffer, will be sent when we are flushed
-            memcpy(gEdmStream.pAtCommandBuffer + gEdmStream.atCommandCurrent, *ppData, *pLength);
-            gEdmStream.atCommandCurrent += (int32_t) * pLength;
+            memcpy(pInstance->pAtCommandBuffer + pInstance->atCommandCurrent, *ppData,
+                   *pLength);
+            pInstance->atCommandCurrent += (int32_t) * pLength;
             // Tell the caller what we've consumed.
             *ppData += *pLength;
         }
@@ -936,109 +1312,187 @@ static const char *pInterceptTx(uAtClientHandle_t atHandle,
 int32_t uShortRangeEdmStreamInit()
 {
     uErrorCode_t errorCodeOrHandle = U_ERROR_COMMON_SUCCESS;
+    size_t x;
 
     if (gMutex == NULL) {
         errorCodeOrHandle = (uErrorCode_t)uPortMutexCreate(&gMutex);
+        for (x = 0; (x < sizeof(gEdmStream) / sizeof(gEdmStream[0])) &&
+             (errorCodeOrHandle == U_ERROR_COMMON_SUCCESS); x++) {
+            gEdmStream[x].handle = -1;
+            gEdmStream[x].uartHandle = -1;
+            gEdmStream[x].eventQueueHandle = -1;
+            gEdmStream[x].ignoreUartCallback = false;
+            gEdmStream[x].rxKickNeeded = false;
+            uShortRangeEdmParserInit(&(gEdmStream[x].parser), (int32_t) x);
+            errorCodeOrHandle = (uErrorCode_t)uPortMutexCreate(&(gEdmStream[x].mutex));
+        }
 
         if (errorCodeOrHandle == U_ERROR_COMMON_SUCCESS) {
             errorCodeOrHandle = (uErrorCode_t)uShortRangeMemPoolInit();
         }
-        gEdmStream.handle = -1;
-        gEdmStream.ignoreUartCallback = false;
+        if (errorCodeOrHandle == U_ERROR_COMMON_SUCCESS) {
+            uShortRangePbufFreeCallbackSet(pbufFreeCallback, NULL);
+        } else {
+            // Clean up
+            for (x = 0; x < sizeof(gEdmStream) / sizeof(gEdmStream[0]); x++) {
+                if (gEdmStream[x].mutex != NULL) {
+                    uPortMutexDelete(gEdmStream[x].mutex);
+                    gEdmStream[x].mutex = NULL;
+                }
+            }
+            if (gMutex != NULL) {
+                uPortMutexDelete(gMutex);
+                gMutex = NULL;
+            }
+        }
     }
 
-    uShortRangeEdmResetParser();
-
     return (int32_t) errorCodeOrHandle;
 }
 
 void uShortRangeEdmStreamDeinit()
 {
-    uShortRangeEdmResetParser();
+    bool isOpen = false;
 
     if (gMutex != NULL) {
 
         U_PORT_MUTEX_LOCK(gMutex);
-        uShortRangeMemPoolDeInit();
 
-        if (gEdmStream.eventQueueHandle >= 0) {
-            uPortEventQueueClose(gEdmStream.eventQueueHandle);
+        for (size_t x = 0; x < sizeof(gEdmStream) / sizeof(gEdmStream[0]); x++) {
+            if (gEdmStream[x].handle >= 0) {
+                isOpen = true;
+            }
+        }
+        if (!isOpen) {
+            uShortRangePbufFreeCallbackSet(NULL, NULL);
+            uShortRangeMemPoolDeInit();
+            for (size_t x = 0; x < sizeof(gEdmStream) / sizeof(gEdmStream[0]); x++) {
+                uPortMutexDelete(gEdmStream[x].mutex);
+                gEdmStream[x].mutex = NULL;
+            }
         }
-        gEdmStream.eventQueueHandle = -1;
 
         U_PORT_MUTEX_UNLOCK(gMutex);
-        uPortMutexDelete(gMutex);
-        gMutex = NULL;
+
+        if (!isOpen) {
+            uPortMutexDelete(gMutex);
+            gMutex = NULL;
+        }
     }
 }
 
 int32_t uShortRangeEdmStreamOpen(int32_t uartHandle)
 {
     uErrorCode_t handleOrErrorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance = NULL;
+    int32_t errorCode;
 
     if (gMutex != NULL) {
 
         U_PORT_MUTEX_LOCK(gMutex);
         handleOrErrorCode = U_ERROR_COMMON_INVALID_PARAMETER;
 
-        if (uartHandle >= 0 && gEdmStream.handle == -1) {
-
-            int32_t errorCode = uPortUartEventCallbackSet(uartHandle,
-                                                          U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
-                                                          uartCallback, NULL,
-                                                          U_EDM_STREAM_TASK_STACK_SIZE_BYTES,
-                                                          U_EDM_STREAM_TASK_PRIORITY);
-
-            if (errorCode == 0) {
-                gEdmStream.pAtCommandBuffer = (char *)malloc(U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH);
-                memset(gEdmStream.pAtCommandBuffer, 0, U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH);
-                gEdmStream.pAtResponseBuffer = (char *)malloc(U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH);
-                memset(gEdmStream.pAtResponseBuffer, 0, U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH);
-                if (gEdmStream.pAtCommandBuffer == NULL ||
-                    gEdmStream.pAtResponseBuffer == NULL) {
-                    handleOrErrorCode = U_ERROR_COMMON_NO_MEMORY;
-                    uPortUartEventCallbackRemove(uartHandle);
-                } else {
-                    gEdmStream.eventQueueHandle
+        if (uartHandle >= 0) {
+            // Find a free instance, checking that the UART
+            // is not already in use by another
+            for (size_t x = 0; x < sizeof(gEdmStream) / sizeof(gEdmStream[0]); x++) {
+                if (gEdmStream[x].handle >= 0) {
+                    if (gEdmStream[x].uartHandle == uartHandle) {
+                        pInstance = NULL;
+                        break;
+                    }
+                } else if (pInstance == NULL) {
+                    pInstance = &(gEdmStream[x]);
+                }
+            }
+        }
+
+        if (pInstance != NULL) {
+            handleOrErrorCode = U_ERROR_COMMON_NO_MEMORY;
+            U_PORT_MUTEX_LOCK(pInstance->mutex);
+            pInstance->pAtCommandBuffer =
+                (char *)malloc(U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH);
+            pInstance->pAtResponseBuffer =
+                (char *)malloc(U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH);
+            pInstance->pRxBuffer =
+                (char *)malloc(U_SHORT_RANGE_EDM_STREAM_UART_READ_BUFFER_LENGTH_BYTES);
+            if ((pInstance->pAtCommandBuffer != NULL) &&
+                (pInstance->pAtResponseBuffer != NULL) &&
+                (pInstance->pRxBuffer != NULL)) {
+                memset(pInstance->pAtCommandBuffer, 0,
+                       U_SHORT_RANGE_EDM_STREAM_AT_COMMAND_LENGTH);
+                memset(pInstance->pAtResponseBuffer, 0,
+                       U_SHORT_RANGE_EDM_STREAM_AT_RESPONSE_LENGTH);
+                pInstance->rxStartIndex = 0;
+                pInstance->rxCharsInBuffer = 0;
+                pInstance->uartHandle = uartHandle;
+                pInstance->atHandle = NULL;
+                pInstance->pAtCallback = NULL;
+                pInstance->pAtCallbackParam = NULL;
+                pInstance->pBtEventCallback = NULL;
+                pInstance->pBtEventCallbackParam = NULL;
+                pInstance->pBtDataCallback = NULL;
+                pInstance->pBtDataCallbackParam = NULL;
+                pInstance->pIpEventCallback = NULL;
+                pInstance->pIpEventCallbackParam = NULL;
+                pInstance->pIpDataCallback = NULL;
+                pInstance->pIpDataCallbackParam = NULL;
+                pInstance->pMqttEventCallback = NULL;
+                pInstance->pMqttEventCallbackParam = NULL;
+                pInstance->pMqttDataCallback = NULL;
+                pInstance->pMqttDataCallbackParam = NULL;
+                pInstance->atCommandCurrent = 0;
+                pInstance->atResponseLength = 0;
+                pInstance->atResponseRead = 0;
+                pInstance->rxKickNeeded = false;
+                memset(&pInstance->rxStats, 0, sizeof(pInstance->rxStats));
+                pInstance->rxStats.stalledChannel = -1;
+                // The instance index is also the owner its pbufs are charged to
+                uShortRangeEdmParserInit(&(pInstance->parser), (int32_t) (pInstance - gEdmStream));
+
+                for (uint32_t i = 0; i < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS; i++) {
+                    pInstance->connections[i].channel = -1;
+                    pInstance->connections[i].type = U_SHORT_RANGE_CONNECTION_TYPE_INVALID;
+                }
+
+                // The UART callback is given the instance as its parameter
+                // and so needs no look-up; it can't run until the instance
+                // is unlocked
+                errorCode = uPortUartEventCallbackSet(uartHandle,
+                                                      U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                      uartCallback, pInstance,
+                                                      U_EDM_STREAM_TASK_STACK_SIZE_BYTES,
+                                                      U_EDM_STREAM_TASK_PRIORITY);
+                if (errorCode == 0) {
+                    pInstance->eventQueueHandle
                         = uPortEventQueueOpen(eventHandler, "eventEdmStream",
                                               sizeof(uShortRangeEdmStreamEvent_t),
                                               U_EDM_STREAM_TASK_STACK_SIZE_BYTES,
                                               U_EDM_STREAM_TASK_PRIORITY,
                                               U_EDM_STREAM_EVENT_QUEUE_SIZE);
-                    if (gEdmStream.eventQueueHandle < 0) {
-                        gEdmStream.eventQueueHandle = -1;
+                    if (pInstance->eventQueueHandle < 0) {
+                        pInstance->eventQueueHandle = -1;
                     }
-
-                    gEdmStream.handle = 0;
-                    gEdmStream.uartHandle = uartHandle;
-                    gEdmStream.atHandle = NULL;
-                    gEdmStream.pAtCallback = NULL;
-                    gEdmStream.pAtCallbackParam = NULL;
-                    gEdmStream.pBtEventCallback = NULL;
-                    gEdmStream.pBtEventCallbackParam = NULL;
-                    gEdmStream.pBtDataCallback = NULL;
-                    gEdmStream.pBtDataCallbackParam = NULL;
-                    gEdmStream.pIpEventCallback = NULL;
-                    gEdmStream.pIpEventCallbackParam = NULL;
-                    gEdmStream.pIpDataCallback = NULL;
-                    gEdmStream.pIpDataCallbackParam = NULL;
-                    gEdmStream.pMqttEventCallback = NULL;
-                    gEdmStream.pMqttEventCallbackParam = NULL;
-                    gEdmStream.pMqttDataCallback = NULL;
-                    gEdmStream.pMqttDataCallbackParam = NULL;
-                    gEdmStream.atCommandCurrent = 0;
-
-                    for (uint32_t i = 0; i < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS; i++) {
-                        gEdmStream.connections[i].channel = -1;
-                        gEdmStream.connections[i].type = U_SHORT_RANGE_CONNECTION_TYPE_INVALID;
-                    }
-
-                    handleOrErrorCode = (uErrorCode_t)gEdmStream.handle;
+                    pInstance->handle = (int32_t) (pInstance - gEdmStream);
+                    handleOrErrorCode = (uErrorCode_t)pInstance->handle;
                     flushUart(uartHandle);
+                } else {
+                    handleOrErrorCode = (uErrorCode_t)errorCode;
+                    pInstance->uartHandle = -1;
                 }
             }
+            if (pInstance->handle < 0) {
+                // Clean up on error
+                free(pInstance->pAtCommandBuffer);
+                pInstance->pAtCommandBuffer = NULL;
+                free(pInstance->pAtResponseBuffer);
+                pInstance->pAtResponseBuffer = NULL;
+                free(pInstance->pRxBuffer);
+                pInstance->pRxBuffer = NULL;
+            }
+            U_PORT_MUTEX_UNLOCK(pInstance->mutex);
         }
-        uShortRangeEdmResetParser();
+
         U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
@@ -1047,51 +1501,61 @@ int32_t uShortRangeEdmStreamOpen(int32_t uartHandle)
 
 void uShortRangeEdmStreamClose(int32_t handle)
 {
-    if (gMutex != NULL) {
-        gEdmStream.ignoreUartCallback = true;
-        uPortMutexLock(gMutex);
+    uShortRangeEdmStreamInstance_t *pInstance;
 
-        if ((handle != -1) && (handle == gEdmStream.handle)) {
-            gEdmStream.handle = -1;
-            if (gEdmStream.uartHandle >= 0) {
-                uPortUartEventCallbackRemove(gEdmStream.uartHandle);
+    if ((gMutex != NULL) && (handle >= 0) && (handle < U_SHORT_RANGE_EDM_STREAM_MAX_NUM)) {
+        pInstance = &(gEdmStream[handle]);
+        pInstance->ignoreUartCallback = true;
+
+        U_PORT_MUTEX_LOCK(gMutex);
+        U_PORT_MUTEX_LOCK(pInstance->mutex);
+
+        if (handle == pInstance->handle) {
+            pInstance->handle = -1;
+            pInstance->rxKickNeeded = false;
+            if (pInstance->uartHandle >= 0) {
+                uPortUartEventCallbackRemove(pInstance->uartHandle);
             }
-            gEdmStream.uartHandle = -1;
-            if (gEdmStream.eventQueueHandle >= 0) {
-                uPortEventQueueClose(gEdmStream.eventQueueHandle);
+            pInstance->uartHandle = -1;
+            if (pInstance->eventQueueHandle >= 0) {
+                uPortEventQueueClose(pInstance->eventQueueHandle);
             }
-            gEdmStream.eventQueueHandle = -1;
-            if (gEdmStream.atHandle != NULL) {
-                uAtClientStreamInterceptTx(gEdmStream.atHandle, NULL, NULL);
+            pInstance->eventQueueHandle = -1;
+            if (pInstance->atHandle != NULL) {
+                uAtClientStreamInterceptTx(pInstance->atHandle, NULL, NULL);
             }
-            gEdmStream.atHandle = NULL;
-            gEdmStream.pAtCallback = NULL;
-            gEdmStream.pAtCallbackParam = NULL;
-            gEdmStream.pBtEventCallback = NULL;
-            gEdmStream.pBtEventCallbackParam = NULL;
-            gEdmStream.pBtDataCallback = NULL;
-            gEdmStream.pBtDataCallbackParam = NULL;
-            gEdmStream.pIpEventCallback = NULL;
-            gEdmStream.pIpEventCallbackParam = NULL;
-            gEdmStream.pIpDataCallback = NULL;
-            gEdmStream.pIpDataCallbackParam = NULL;
-            gEdmStream.pMqttEventCallback = NULL;
-            gEdmStream.pMqttEventCallbackParam = NULL;
-            gEdmStream.pMqttDataCallback = NULL;
-            gEdmStream.pMqttDataCallbackParam = NULL;
-            free(gEdmStream.pAtCommandBuffer);
-            gEdmStream.pAtCommandBuffer = NULL;
-            free(gEdmStream.pAtResponseBuffer);
-            gEdmStream.pAtResponseBuffer = NULL;
+            pInstance->atHandle = NULL;
+            pInstance->pAtCallback = NULL;
+            pInstance->pAtCallbackParam = NULL;
+            pInstance->pBtEventCallback = NULL;
+            pInstance->pBtEventCallbackParam = NULL;
+            pInstance->pBtDataCallback = NULL;
+            pInstance->pBtDataCallbackParam = NULL;
+            pInstance->pIpEventCallback = NULL;
+            pInstance->pIpEventCallbackParam = NULL;
+            pInstance->pIpDataCallback = NULL;
+            pInstance->pIpDataCallbackParam = NULL;
+            pInstance->pMqttEventCallback = NULL;
+            pInstance->pMqttEventCallbackParam = NULL;
+            pInstance->pMqttDataCallback = NULL;
+            pInstance->pMqttDataCallbackParam = NULL;
+            free(pInstance->pAtCommandBuffer);
+            pInstance->pAtCommandBuffer = NULL;
+            free(pInstance->pAtResponseBuffer);
+            pInstance->pAtResponseBuffer = NULL;
+            free(pInstance->pRxBuffer);
+            pInstance->pRxBuffer = NULL;
             for (uint32_t i = 0; i < U_SHORT_RANGE_EDM_STREAM_MAX_CONNECTIONS; i++) {
-                gEdmStream.connections[i].channel = -1;
-                gEdmStream.connections[i].type = U_SHORT_RANGE_CONNECTION_TYPE_INVALID;
+                pInstance->connections[i].channel = -1;
+                pInstance->connections[i].type = U_SHORT_RANGE_CONNECTION_TYPE_INVALID;
             }
+            // This also returns the receive quotas to their defaults
+            uShortRangeEdmParserInit(&(pInstance->parser), handle);
         }
 
-        uShortRangeEdmResetParser();
-        uPortMutexUnlock(gMutex);
-        gEdmStream.ignoreUartCallback = false;
+        U_PORT_MUTEX_UNLOCK(pInstance->mutex);
+        U_PORT_MUTEX_UNLOCK(gMutex);
+        pInstance->ignoreUartCallback = false;
     }
 }
 
@@ -1101,19 +1565,20 @@ int32_t uShortRangeEdmStreamAtCallbackSet(int32_t handle,
                                           void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if ((handle == gEdmStream.handle) && (pFunction != NULL)) {
-            gEdmStream.pAtCallback = pFunction;
-            gEdmStream.pAtCallbackParam = pParam;
-            errorCode = U_ERROR_COMMON_SUCCESS;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pFunction != NULL) {
+                pInstance->pAtCallback = pFunction;
+                pInstance->pAtCallbackParam = pParam;
+                errorCode = U_ERROR_COMMON_SUCCESS;
+            }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return (int32_t)errorCode;
@@ -1124,25 +1589,24 @@ int32_t uShortRangeEdmStreamIpEventCallbackSet(int32_t handle,
                                                void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
-            if (pFunction != NULL && gEdmStream.pIpEventCallback == NULL) {
-                gEdmStream.pIpEventCallback = pFunction;
-                gEdmStream.pIpEventCallbackParam = pParam;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pFunction != NULL && pInstance->pIpEventCallback == NULL) {
+                pInstance->pIpEventCallback = pFunction;
+                pInstance->pIpEventCallbackParam = pParam;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             } else if (pFunction == NULL) {
-                gEdmStream.pIpEventCallback = NULL;
-                gEdmStream.pIpEventCallbackParam = NULL;
+                pInstance->pIpEventCallback = NULL;
+                pInstance->pIpEventCallbackParam = NULL;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return (int32_t)errorCode;
@@ -1160,25 +1624,24 @@ int32_t uShortRangeEdmStreamMqttEventCallbackSet(int32_t handle,
                                                  void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
-            if (pFunction != NULL && gEdmStream.pMqttEventCallback == NULL) {
-                gEdmStream.pMqttEventCallback = pFunction;
-                gEdmStream.pMqttEventCallbackParam = pParam;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pFunction != NULL && pInstance->pMqttEventCallback == NULL) {
+                pInstance->pMqttEventCallback = pFunction;
+                pInstance->pMqttEventCallbackParam = pParam;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             } else if (pFunction == NULL) {
-                gEdmStream.pMqttEventCallback = NULL;
-                gEdmStream.pMqttEventCallbackParam = NULL;
+                pInstance->pMqttEventCallback = NULL;
+                pInstance->pMqttEventCallbackParam = NULL;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return (int32_t)errorCode;
@@ -1197,26 +1660,24 @@ int32_t uShortRangeEdmStreamBtEventCallbackSet(int32_t handle,
                                                void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
-            if (pFunction != NULL && gEdmStream.pBtEventCallback == NULL) {
-                gEdmStream.pBtEventCallback = pFunction;
-                gEdmStream.pBtEventCallbackParam = pParam;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pFunction != NULL && pInstance->pBtEventCallback == NULL) {
+                pInstance->pBtEventCallback = pFunction;
+                pInstance->pBtEventCallbackParam = pParam;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             } else if (pFunction == NULL) {
-                gEdmStream.pBtEventCallback = NULL;
-                gEdmStream.pBtEventCallbackParam = NULL;
+                pInstance->pBtEventCallback = NULL;
+                pInstance->pBtEventCallbackParam = NULL;
                 errorCode = U_ERROR_COMMON_SUCCESS;
             }
-
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return (int32_t)errorCode;
@@ -1235,47 +1696,47 @@ int32_t uShortRangeEdmStreamDataEventCallbackSet(int32_t handle,
                                                  void *pParam)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
             switch (type) {
 
                 case U_SHORT_RANGE_CONNECTION_TYPE_BT:
-                    if (pFunction != NULL && gEdmStream.pBtDataCallback == NULL) {
-                        gEdmStream.pBtDataCallback = pFunction;
-                        gEdmStream.pBtDataCallbackParam = pParam;
+                    if (pFunction != NULL && pInstance->pBtDataCallback == NULL) {
+                        pInstance->pBtDataCallback = pFunction;
+                        pInstance->pBtDataCallbackParam = pParam;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     } else if (pFunction == NULL) {
-                        gEdmStream.pBtDataCallback = NULL;
-                        gEdmStream.pBtDataCallbackParam = NULL;
+                        pInstance->pBtDataCallback = NULL;
+                        pInstance->pBtDataCallbackParam = NULL;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     }
                     break;
 
                 case U_SHORT_RANGE_CONNECTION_TYPE_IP:
-                    if (pFunction != NULL && gEdmStream.pIpDataCallback == NULL) {
-                        gEdmStream.pIpDataCallback = pFunction;
-                        gEdmStream.pIpDataCallbackParam = pParam;
+                    if (pFunction != NULL && pInstance->pIpDataCallback == NULL) {
+                        pInstance->pIpDataCallback = pFunction;
+                        pInstance->pIpDataCallbackParam = pParam;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     } else if (pFunction == NULL) {
-                        gEdmStream.pIpDataCallback = NULL;
-                        gEdmStream.pIpDataCallbackParam = NULL;
+                        pInstance->pIpDataCallback = NULL;
+                        pInstance->pIpDataCallbackParam = NULL;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     }
                     break;
 
                 case U_SHORT_RANGE_CONNECTION_TYPE_MQTT:
-                    if (pFunction != NULL && gEdmStream.pMqttDataCallback == NULL) {
-                        gEdmStream.pMqttDataCallback = pFunction;
-                        gEdmStream.pMqttDataCallbackParam = pParam;
+                    if (pFunction != NULL && pInstance->pMqttDataCallback == NULL) {
+                        pInstance->pMqttDataCallback = pFunction;
+                        pInstance->pMqttDataCallbackParam = pParam;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     } else if (pFunction == NULL) {
-                        gEdmStream.pMqttDataCallback = NULL;
-                        gEdmStream.pMqttDataCallbackParam = NULL;
+                        pInstance->pMqttDataCallback = NULL;
+                        pInstance->pMqttDataCallbackParam = NULL;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                     }
                     break;
@@ -1283,9 +1744,8 @@ int32_t uShortRangeEdmStreamDataEventCallbackSet(int32_t handle,
                 default:
                     break;
             }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return (int32_t)errorCode;
@@ -1302,9 +1762,16 @@ void uShortRangeEdmStreamDataEventCallbackRemove(int32_t handle,
 
 void uShortRangeEdmStreamSetAtHandle(int32_t handle, void *atHandle)
 {
-    if (handle == gEdmStream.handle) {
-        uAtClientStreamInterceptTx(atHandle, pInterceptTx, NULL);
-        gEdmStream.atHandle = atHandle;
+    uShortRangeEdmStreamInstance_t *pInstance;
+
+    if (gMutex != NULL) {
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            // The intercept function is given the instance as its context
+            uAtClientStreamInterceptTx(atHandle, pInterceptTx, pInstance);
+            pInstance->atHandle = atHandle;
+            uPortMutexUnlock(pInstance->mutex);
+        }
     }
 }
 
@@ -1312,30 +1779,32 @@ int32_t uShortRangeEdmStreamAtWrite(int32_t handle, const void *pBuffer,
                                     size_t sizeBytes)
 {
     int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-        if (gEdmStream.handle == handle && pBuffer != NULL && sizeBytes != 0) {
-            sizeOrErrorCode = (int32_t)U_ERROR_COMMON_PLATFORM;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pBuffer != NULL && sizeBytes != 0) {
+                sizeOrErrorCode = (int32_t)U_ERROR_COMMON_PLATFORM;
 
-            int32_t result;
-            uint32_t sent = 0;
+                int32_t result;
+                uint32_t sent = 0;
 
-            do {
-                result = uartWrite(pBuffer, sizeBytes);
-                if (result > 0) {
-                    sent += result;
-                }
-            } while (result > 0 && sent < sizeBytes);
+                do {
+                    result = uartWrite(pInstance, pBuffer, sizeBytes);
+                    if (result > 0) {
+                        sent += result;
+                    }
+                } while (result > 0 && sent < sizeBytes);
 
-            if (sent > 0) {
-                sizeOrErrorCode = (int32_t)sent;
+                if (sent > 0) {
+                    sizeOrErrorCode = (int32_t)sent;
+                }
             }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return sizeOrErrorCode;
@@ -1345,30 +1814,34 @@ int32_t uShortRangeEdmStreamAtRead(int32_t handle, void *pBuffer,
                                    size_t sizeBytes)
 {
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-        if (gEdmStream.handle == handle && pBuffer != NULL && sizeBytes != 0) {
-            sizeOrErrorCode = (int32_t)(gEdmStream.atResponseLength - gEdmStream.atResponseRead);
-            if (sizeOrErrorCode > 0) {
-                if (sizeBytes < (uint32_t)sizeOrErrorCode) {
-                    sizeOrErrorCode = (int32_t)sizeBytes;
-                }
-                memcpy(pBuffer, gEdmStream.pAtResponseBuffer + gEdmStream.atResponseRead, sizeOrErrorCode);
-                gEdmStream.atResponseRead += sizeOrErrorCode;
-
-                if (gEdmStream.atResponseRead >= gEdmStream.atResponseLength) {
-                    gEdmStream.atResponseLength = 0;
-                    gEdmStream.atResponseRead = 0;
-                    uEdmChLogLine(LOG_CH_AT_RX, "processed");
-                    processedEvent();
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pBuffer != NULL && sizeBytes != 0) {
+                sizeOrErrorCode = (int32_t)(pInstance->atResponseLength -
+                                            pInstance->atResponseRead);
+                if (sizeOrErrorCode > 0) {
+                    if (sizeBytes < (uint32_t)sizeOrErrorCode) {
+                        sizeOrErrorCode = (int32_t)sizeBytes;
+                    }
+                    memcpy(pBuffer, pInstance->pAtResponseBuffer + pInstance->atResponseRead,
+                           sizeOrErrorCode);
+                    pInstance->atResponseRead += sizeOrErrorCode;
+
+                    if (pInstance->atResponseRead >= pInstance->atResponseLength) {
+                        pInstance->atResponseLength = 0;
+                        pInstance->atResponseRead = 0;
+                        uEdmChLogLine(LOG_CH_AT_RX, "processed");
+                        processedEvent(pInstance);
+                    }
                 }
             }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return sizeOrErrorCode;
@@ -1377,60 +1850,114 @@ int32_t uShortRangeEdmStreamAtRead(int32_t handle, void *pBuffer,
 int32_t uShortRangeEdmStreamWrite(int32_t handle, int32_t channel,
                                   const void *pBuffer, size_t sizeBytes,
                                   uint32_t timeoutMs)
+{
+    uSockIoVec_t ioVec;
+
+    ioVec.pBase = (void *) pBuffer;
+    ioVec.length = sizeBytes;
+
+    return uShortRangeEdmStreamWritev(handle, channel, &ioVec,
+                                      (pBuffer != NULL) ? 1 : 0,
+                                      timeoutMs);
+}
+
+int32_t uShortRangeEdmStreamWritev(int32_t handle, int32_t channel,
+                                   const struct uSockIoVec_t *pIoVec,
+                                   size_t numIoVec, uint32_t timeoutMs)
 {
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
+    size_t sizeBytes = 0;
+    bool ioVecValid = (pIoVec != NULL);
+
+    for (size_t x = 0; ioVecValid && (x < numIoVec); x++) {
+        if (((pIoVec + x)->pBase == NULL) && ((pIoVec + x)->length > 0)) {
+            ioVecValid = false;
+        }
+        sizeBytes += (pIoVec + x)->length;
+    }
 
     if (gMutex != NULL) {
-        U_PORT_MUTEX_LOCK(gMutex);
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-        if (gEdmStream.handle == handle && channel >= 0 &&
-            pBuffer != NULL && sizeBytes != 0) {
-            uShortRangeEdmStreamConnections_t *pConnection = findConnection(channel);
-            if (pConnection != NULL) {
-                int32_t sent;
-                int32_t send;
-                char head[U_SHORT_RANGE_EDM_DATA_HEAD_SIZE];
-                char tail[U_SHORT_RANGE_EDM_TAIL_SIZE];
-                sizeOrErrorCode = 0;
-                int64_t startTime = uPortGetTickTimeMs();
-                int64_t endTime;
-
-                do {
-                    send = ((int32_t)sizeBytes - sizeOrErrorCode);
-                    if (pConnection->type == U_SHORT_RANGE_CONNECTION_TYPE_BT) {
-                        if (((int32_t)sizeBytes - sizeOrErrorCode) > pConnection->bt.frameSize) {
-                            send = pConnection->bt.frameSize;
-                        }
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (channel >= 0 && ioVecValid && sizeBytes != 0 && sizeBytes <= INT32_MAX) {
+                uShortRangeEdmStreamConnections_t *pConnection = findConnection(pInstance,
+                                                                                channel);
+                if (pConnection != NULL) {
+                    uShortRangeEdmStreamTxBatch_t batch;
+
+                    txBatchInit(&batch, pInstance->uartHandle);
+                    sizeOrErrorCode = txBatchAddData(&batch, pConnection, pIoVec, numIoVec,
+                                                     sizeBytes, uPortGetTickTimeMs(), timeoutMs);
+                    txBatchFlush(&batch);
+                    if (batch.error) {
+                        sizeOrErrorCode = (int32_t)U_ERROR_COMMON_DEVICE_ERROR;
                     }
+                }
+            }
+            uPortMutexUnlock(pInstance->mutex);
+        }
+    }
 
-#ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG
-# ifdef U_CFG_SHORT_RANGE_EDM_STREAM_DEBUG_DUMP_DATA
-                    uEdmChLogStart(LOG_CH_DATA, "TX (%d bytes): ", send);
-                    dumpHexData(((const char *)pBuffer + sizeOrErrorCode), send);
-                    uEdmChLogEnd("");
-# else
-                    uEdmChLogLine(LOG_CH_DATA, "TX (%d bytes)", send);
-# endif
-#endif
+    return sizeOrErrorCode;
+}
 
-                    (void)uShortRangeEdmZeroCopyHeadData((uint8_t)channel, send, (char *)&head[0]);
-                    sent = uartWrite((void *)&head[0], U_SHORT_RANGE_EDM_DATA_HEAD_SIZE);
-                    sent += uartWrite((const void *)((const char *)pBuffer + sizeOrErrorCode), send);
-                    (void)uShortRangeEdmZeroCopyTail((char *)&tail[0]);
-                    sent += uartWrite((void *)&tail[0], U_SHORT_RANGE_EDM_TAIL_SIZE);
+int32_t uShortRangeEdmStreamWriteFrames(int32_t handle,
+                                        const uShortRangeEdmStreamTxFrame_t *pFrames,
+                                        size_t numFrames, uint32_t timeoutMs)
+{
+    int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
+    uShortRangeEdmStreamConnections_t *pConnection;
+    uShortRangeEdmStreamTxBatch_t batch;
+    uSockIoVec_t ioVec;
+    int64_t startTimeMs;
+    bool framesValid = (pFrames != NULL) && (numFrames > 0);
+    size_t sizeBytes = 0;
+    int32_t added;
+
+    for (size_t x = 0; framesValid && (x < numFrames); x++) {
+        if (((pFrames + x)->pBuffer == NULL) || ((pFrames + x)->sizeBytes == 0)) {
+            framesValid = false;
+        }
+        sizeBytes += (pFrames + x)->sizeBytes;
+    }
 
-                    if (sent != (send + U_SHORT_RANGE_EDM_DATA_HEAD_SIZE + U_SHORT_RANGE_EDM_TAIL_SIZE)) {
-                        sizeOrErrorCode = (int32_t)U_ERROR_COMMON_DEVICE_ERROR;
+    if (gMutex != NULL) {
+        sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            for (size_t x = 0; framesValid && (x < numFrames); x++) {
+                if (((pFrames + x)->channel < 0) ||
+                    (findConnection(pInstance, (pFrames + x)->channel) == NULL)) {
+                    framesValid = false;
+                }
+            }
+            if (framesValid && (sizeBytes <= INT32_MAX)) {
+                sizeOrErrorCode = 0;
+                startTimeMs = uPortGetTickTimeMs();
+                txBatchInit(&batch, pInstance->uartHandle);
+                for (size_t x = 0; (x < numFrames) && !batch.error &&
+                     ((x == 0) || (uPortGetTickTimeMs() - startTimeMs < timeoutMs)); x++) {
+                    pConnection = findConnection(pInstance, (pFrames + x)->channel);
+                    ioVec.pBase = (void *) (pFrames + x)->pBuffer;
+                    ioVec.length = (pFrames + x)->sizeBytes;
+                    added = txBatchAddData(&batch, pConnection, &ioVec, 1,
+                                           ioVec.length, startTimeMs, timeoutMs);
+                    sizeOrErrorCode += added;
+                    if ((size_t) added < ioVec.length) {
+                        // Timed out part-way through this one
                         break;
-                    } else {
-                        sizeOrErrorCode += send;
                     }
-                    endTime = uPortGetTickTimeMs();
-                } while (((int32_t)sizeBytes > sizeOrErrorCode) &&
-                         (endTime - startTime < timeoutMs));
+                }
+                txBatchFlush(&batch);
+                if (batch.error) {
+                    sizeOrErrorCode = (int32_t)U_ERROR_COMMON_DEVICE_ERROR;
+                }
             }
+            uPortMutexUnlock(pInstance->mutex);
         }
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return sizeOrErrorCode;
@@ -1439,26 +1966,27 @@ int32_t uShortRangeEdmStreamWrite(int32_t handle, int32_t channel,
 int32_t uShortRangeEdmStreamAtEventSend(int32_t handle, uint32_t eventBitMap)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        if ((handle == 0) &&
-            (gEdmStream.eventQueueHandle >= 0) &&
-            // The only event we support right now
-            (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
-            uShortRangeEdmStreamEvent_t event;
-            event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_AT;
-            errorCode = uPortEventQueueSend(gEdmStream.eventQueueHandle,
-                                            &event, sizeof(uShortRangeEdmStreamEvent_t));
-            if (errorCode != 0) {
-                uPortLog("U_SHO_EDM_STREAM: Failed to enqueue message\n");
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if ((pInstance->eventQueueHandle >= 0) &&
+                // The only event we support right now
+                (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
+                uShortRangeEdmStreamEvent_t event;
+                event.pInstance = pInstance;
+                event.type = U_SHORT_RANGE_EDM_STREAM_EVENT_AT;
+                errorCode = uPortEventQueueSend(pInstance->eventQueueHandle,
+                                                &event, sizeof(uShortRangeEdmStreamEvent_t));
+                if (errorCode != 0) {
+                    uPortLog("U_SHO_EDM_STREAM: Failed to enqueue message\n");
+                }
             }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return errorCode;
@@ -1467,17 +1995,17 @@ int32_t uShortRangeEdmStreamAtEventSend(int32_t handle, uint32_t eventBitMap)
 bool uShortRangeEdmStreamAtEventIsCallback(int32_t handle)
 {
     bool isEventCallback = false;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
-        if ((handle == gEdmStream.handle) &&
-            (gEdmStream.eventQueueHandle >= 0)) {
-            isEventCallback = uPortEventQueueIsTask(gEdmStream.eventQueueHandle);
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pInstance->eventQueueHandle >= 0) {
+                isEventCallback = uPortEventQueueIsTask(pInstance->eventQueueHandle);
+            }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return isEventCallback;
@@ -1485,34 +2013,133 @@ bool uShortRangeEdmStreamAtEventIsCallback(int32_t handle)
 
 void uShortRangeEdmStreamAtCallbackRemove(int32_t handle)
 {
+    uShortRangeEdmStreamInstance_t *pInstance;
+
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            pInstance->pAtCallback = NULL;
+            uPortMutexUnlock(pInstance->mutex);
+        }
+    }
+}
+
+
+int32_t uShortRangeEdmStreamRxQuotaSet(int32_t handle, int32_t channel,
+                                       int32_t quotaBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
-        if (handle == gEdmStream.handle) {
-            gEdmStream.pAtCallback = NULL;
+    if (gMutex != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (uShortRangeEdmRxQuotaSet(&(pInstance->parser), channel,
+                                         quotaBytes) == U_SHORT_RANGE_EDM_OK) {
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                // A larger quota may mean that receive can resume
+                if (pInstance->rxStats.stalled) {
+                    kickUart(pInstance);
+                }
+            }
+            uPortMutexUnlock(pInstance->mutex);
         }
+    }
 
-        U_PORT_MUTEX_UNLOCK(gMutex);
+    return errorCode;
+}
+
+int32_t uShortRangeEdmStreamFrameSizeSet(int32_t handle, int32_t channel,
+                                         int32_t sizeBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
+    uShortRangeEdmStreamConnections_t *pConnection;
+
+    if (gMutex != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            pConnection = findConnection(pInstance, channel);
+            if ((pConnection != NULL) &&
+                ((pConnection->type == U_SHORT_RANGE_CONNECTION_TYPE_IP) ||
+                 (pConnection->type == U_SHORT_RANGE_CONNECTION_TYPE_MQTT)) &&
+                (sizeBytes <= U_SHORT_RANGE_EDM_MAX_SIZE)) {
+                if (sizeBytes <= 0) {
+                    sizeBytes = U_SHORT_RANGE_EDM_STREAM_IP_FRAME_SIZE_DEFAULT_BYTES;
+                }
+                pConnection->ip.frameSize = sizeBytes;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+            uPortMutexUnlock(pInstance->mutex);
+        }
     }
+
+    return errorCode;
 }
 
+int32_t uShortRangeEdmStreamFrameSizeGet(int32_t handle, int32_t channel)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
+    uShortRangeEdmStreamConnections_t *pConnection;
+
+    if (gMutex != NULL) {
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            pConnection = findConnection(pInstance, channel);
+            if (pConnection != NULL) {
+                sizeOrErrorCode = connectionFrameSize(pConnection);
+            }
+            uPortMutexUnlock(pInstance->mutex);
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
+int32_t uShortRangeEdmStreamRxStatsGet(int32_t handle,
+                                       uShortRangeEdmStreamRxStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
+
+    if (gMutex != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pStats != NULL) {
+                *pStats = pInstance->rxStats;
+                if (pStats->stalled) {
+                    pStats->stallTimeMs += uPortGetTickTimeMs() - pInstance->rxStallStartMs;
+                }
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+            uPortMutexUnlock(pInstance->mutex);
+        }
+    }
+
+    return errorCode;
+}
 
 int32_t uShortRangeEdmStreamAtEventStackMinFree(int32_t handle)
 {
     int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        if ((handle == gEdmStream.handle) &&
-            (gEdmStream.eventQueueHandle >= 0)) {
-            sizeOrErrorCode = uPortEventQueueStackMinFree(gEdmStream.eventQueueHandle);
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            if (pInstance->eventQueueHandle >= 0) {
+                sizeOrErrorCode = uPortEventQueueStackMinFree(pInstance->eventQueueHandle);
+            }
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return sizeOrErrorCode;
@@ -1521,17 +2148,16 @@ int32_t uShortRangeEdmStreamAtEventStackMinFree(int32_t handle)
 int32_t uShortRangeEdmStreamAtGetReceiveSize(int32_t handle)
 {
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+    uShortRangeEdmStreamInstance_t *pInstance;
 
     if (gMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gMutex);
-
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-        if (handle == gEdmStream.handle) {
-            sizeOrErrorCode = gEdmStream.atResponseLength - gEdmStream.atResponseRead;
+        pInstance = pInstanceLock(handle);
+        if (pInstance != NULL) {
+            sizeOrErrorCode = pInstance->atResponseLength - pInstance->atResponseRead;
+            uPortMutexUnlock(pInstance->mutex);
         }
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
 
     return sizeOrErrorCode;
@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
+#include "u_compiler.h" // For U_ATOMIC_CAS32
 #include "u_assert.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"
@@ -37,9 +38,6 @@
 #define U_SHORT_RANGE_PBUFLIST_COUNT  (32)
 #endif
 
-#ifndef U_SHORT_RANGE_PBUF_COUNT
-#define U_SHORT_RANGE_PBUF_COUNT      (32)
-#endif
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -53,45 +51,149 @@
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 static uMemPoolDesc_t gPBufListPool;
-static uMemPoolDesc_t gPBufPool;
+// The pbufs, one size class of the slab per size class of pbuf.
+static uMemPoolSlab_t gPBufSlab;
+static bool gPBufSlabInitialised = false;
+// The size classes of pbuf, as set by uShortRangePbufCfgSet().
+static uShortRangePbufClassCfg_t gPBufCfg[U_MEMPOOL_SLAB_CLASSES_MAX_NUM] = {
+    {U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES, U_SHORT_RANGE_PBUF_SMALL_COUNT},
+    {U_SHORT_RANGE_PBUF_LARGE_DATA_SIZE_BYTES, U_SHORT_RANGE_PBUF_LARGE_COUNT}
+};
+static size_t gPBufCfgNumClasses = 2;
+// The number of bytes of pbuf held by each EDM channel of each owner.
+static volatile uint32_t gPBufChannelHeldBytes[U_SHORT_RANGE_PBUF_OWNER_MAX_NUM]
+[U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM] = {0};
+// The callback to call when pbufs have been freed and its parameter.
+static volatile uShortRangePbufFreeCallback_t gpPBufFreeCallback = NULL;
+static void *volatile gpPBufFreeCallbackParam = NULL;
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Add to the number of bytes held by a channel without a lock.
+static void channelHeldBytesAdd(int32_t owner, int32_t channel, int32_t amount)
+{
+    volatile uint32_t *pHeldBytes = &(gPBufChannelHeldBytes[owner][channel]);
+    uint32_t oldValue;
+
+    do {
+        oldValue = *pHeldBytes;
+    } while (!U_ATOMIC_CAS32(pHeldBytes, oldValue, oldValue + (uint32_t) amount));
+}
+
 static void freePbuf(uShortRangePbuf_t *pBuf, bool freeWholeChain)
 {
-    if (freeWholeChain) {
-        while (pBuf != NULL) {
-            uShortRangePbuf_t *pNext = pBuf->pNext;
-            // Basic sanity check - pbuf length should never be longer than pool block size
-            U_ASSERT(pBuf->length <= gPBufPool.blockSize);
-            uMemPoolFreeMem(&gPBufPool, pBuf);
+    uShortRangePbuf_t *pNext;
+    uShortRangePbufFreeCallback_t pCallback = gpPBufFreeCallback;
+    bool freed;
+    bool freedAny = (pBuf != NULL);
+
+    while (pBuf != NULL) {
+        pNext = pBuf->pNext;
+        // Basic sanity check - pbuf length should never be longer than its data buffer
+        U_ASSERT(pBuf->offset + pBuf->length <= pBuf->size);
+        if (pBuf->channel != U_SHORT_RANGE_PBUF_CHANNEL_NONE) {
+            // Give the channel its credit back
+            channelHeldBytesAdd(pBuf->owner, pBuf->channel, -((int32_t) pBuf->size));
+        }
+        freed = uMemPoolSlabFree(&gPBufSlab, pBuf);
+        U_ASSERT(freed);
+        (void) freed; // Unused if U_ASSERT is compiled out
+        pBuf = NULL;
+        if (freeWholeChain) {
             pBuf = pNext;
         }
-    } else if (pBuf != NULL) {
-        // Basic sanity check - pbuf length should never be longer than pool block size
-        U_ASSERT(pBuf->length <= gPBufPool.blockSize);
-        uMemPoolFreeMem(&gPBufPool, pBuf);
+    }
+
+    if (freedAny && (pCallback != NULL)) {
+        pCallback(gpPBufFreeCallbackParam);
     }
 }
 
+// Allocate a pbuf from the given size class of the slab or,
+// if that is empty, from the next class up, and so on, returning
+// the size of its data buffer.
+static int32_t pbufAlloc(uShortRangePbuf_t **ppBuf, size_t classIndex)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    uMemPoolSlabStats_t stats;
+    size_t blockSize;
+
+    *ppBuf = NULL;
+    if (gPBufSlabInitialised &&
+        (uMemPoolSlabGetStats(&gPBufSlab, classIndex, &stats) == 0)) {
+        *ppBuf = (uShortRangePbuf_t *) uMemPoolSlabAlloc(&gPBufSlab, stats.blockSize);
+        if (*ppBuf != NULL) {
+            // Ask the slab what we got since it may be from a class
+            // above; the size of the data buffer is as configured
+            // for that class, though alignment may have made the
+            // block a little larger
+            blockSize = uMemPoolSlabBlockSize(&gPBufSlab, *ppBuf);
+            for (size_t x = classIndex; (x < gPBufCfgNumClasses) && (sizeOrErrorCode < 0); x++) {
+                if ((uMemPoolSlabGetStats(&gPBufSlab, x, &stats) == 0) &&
+                    (stats.blockSize == blockSize)) {
+                    sizeOrErrorCode = (int32_t) gPBufCfg[x].dataSizeBytes;
+                }
+            }
+            U_ASSERT(sizeOrErrorCode > 0);
+            (*ppBuf)->pNext = NULL;
+            (*ppBuf)->length = 0;
+            (*ppBuf)->offset = 0;
+            (*ppBuf)->size = (uint16_t) sizeOrErrorCode;
+            (*ppBuf)->channel = U_SHORT_RANGE_PBUF_CHANNEL_NONE;
+            (*ppBuf)->owner = 0;
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+int32_t uShortRangePbufCfgSet(const uShortRangePbufClassCfg_t *pCfg,
+                              size_t numClasses)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    bool cfgValid = (pCfg != NULL) && (numClasses > 0) &&
+                    (numClasses <= sizeof(gPBufCfg) / sizeof(gPBufCfg[0]));
+
+    for (size_t x = 0; cfgValid && (x < numClasses); x++) {
+        if (((pCfg + x)->dataSizeBytes == 0) || ((pCfg + x)->count == 0) ||
+            ((pCfg + x)->dataSizeBytes > U_SHORT_RANGE_PBUF_DATA_SIZE_MAX_BYTES) ||
+            ((x > 0) && ((pCfg + x)->dataSizeBytes <= (pCfg + x - 1)->dataSizeBytes))) {
+            cfgValid = false;
+        }
+    }
+    if (gPBufSlabInitialised) {
+        errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+    } else if (cfgValid) {
+        memcpy(gPBufCfg, pCfg, numClasses * sizeof(gPBufCfg[0]));
+        gPBufCfgNumClasses = numClasses;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
 int32_t uShortRangeMemPoolInit(void)
 {
     int32_t err;
+    uMemPoolSlabClassCfg_t slabCfg[U_MEMPOOL_SLAB_CLASSES_MAX_NUM];
 
     err = uMemPoolInit(&gPBufListPool, sizeof(uShortRangePbufList_t),
                        U_SHORT_RANGE_PBUFLIST_COUNT);
 
     if (err == 0) {
-
-        err = uMemPoolInit(&gPBufPool, sizeof(uShortRangePbuf_t) + U_SHORT_RANGE_EDM_BLK_SIZE,
-                           U_SHORT_RANGE_EDM_BLK_COUNT);
-
-        if (err != (int32_t)U_ERROR_COMMON_SUCCESS) {
+        for (size_t x = 0; x < gPBufCfgNumClasses; x++) {
+            slabCfg[x].blockSize = sizeof(uShortRangePbuf_t) + gPBufCfg[x].dataSizeBytes;
+            slabCfg[x].blockCount = gPBufCfg[x].count;
+        }
+        err = uMemPoolSlabInit(&gPBufSlab, slabCfg, gPBufCfgNumClasses, NULL, 0);
+        if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
+            gPBufSlabInitialised = true;
+        } else {
             uMemPoolDeinit(&gPBufListPool);
         }
     }
@@ -101,20 +203,81 @@ int32_t uShortRangeMemPoolInit(void)
 
 void uShortRangeMemPoolDeInit(void)
 {
-    uMemPoolDeinit(&gPBufPool);
+    if (gPBufSlabInitialised) {
+        uMemPoolSlabDeinit(&gPBufSlab);
+        gPBufSlabInitialised = false;
+    }
     uMemPoolDeinit(&gPBufListPool);
 }
 
 int32_t uShortRangePbufAlloc(uShortRangePbuf_t **ppBuf)
 {
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-    *ppBuf = (uShortRangePbuf_t *)uMemPoolAllocMem(&gPBufPool);
-    if (*ppBuf != NULL) {
-        (*ppBuf)->length = 0;
-        (*ppBuf)->pNext = NULL;
-        errorCode = gPBufPool.blockSize - sizeof(uShortRangePbuf_t);
+    return pbufAlloc(ppBuf, 0);
+}
+
+int32_t uShortRangePbufAllocSized(uShortRangePbuf_t **ppBuf, size_t sizeBytes)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    size_t classIndex = 0;
+
+    // Find the smallest class that will hold it all or, if the
+    // data is larger than every class, the largest class
+    while ((classIndex + 1 < gPBufCfgNumClasses) &&
+           (gPBufCfg[classIndex].dataSizeBytes < sizeBytes)) {
+        classIndex++;
     }
-    return errorCode;
+    // pbufAlloc() will move up from there if it has to; if there is
+    // nothing free above, try the classes below, the data will
+    // just have to be chained across more pbufs
+    for (size_t x = classIndex + 1; (x > 0) && (sizeOrErrorCode < 0); x--) {
+        sizeOrErrorCode = pbufAlloc(ppBuf, x - 1);
+    }
+
+    return sizeOrErrorCode;
+}
+
+size_t uShortRangePbufPoolSizeBytes(void)
+{
+    size_t sizeBytes = 0;
+
+    for (size_t x = 0; x < gPBufCfgNumClasses; x++) {
+        sizeBytes += gPBufCfg[x].dataSizeBytes * gPBufCfg[x].count;
+    }
+
+    return sizeBytes;
+}
+
+void uShortRangePbufChannelCharge(uShortRangePbuf_t *pBuf, int32_t owner,
+                                  int32_t channel)
+{
+    if ((pBuf != NULL) && (pBuf->channel == U_SHORT_RANGE_PBUF_CHANNEL_NONE) &&
+        (owner >= 0) && (owner < U_SHORT_RANGE_PBUF_OWNER_MAX_NUM) &&
+        (channel >= 0) && (channel < U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM)) {
+        pBuf->owner = (uint8_t) owner;
+        pBuf->channel = (int8_t) channel;
+        channelHeldBytesAdd(owner, channel, pBuf->size);
+    }
+}
+
+size_t uShortRangePbufChannelHeldBytes(int32_t owner, int32_t channel)
+{
+    size_t heldBytes = 0;
+
+    if ((owner >= 0) && (owner < U_SHORT_RANGE_PBUF_OWNER_MAX_NUM) &&
+        (channel >= 0) && (channel < U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM)) {
+        heldBytes = gPBufChannelHeldBytes[owner][channel];
+    }
+
+    return heldBytes;
+}
+
+void uShortRangePbufFreeCallbackSet(uShortRangePbufFreeCallback_t pCallback,
+                                    void *pParam)
+{
+    // Remove the callback before changing the parameter
+    gpPBufFreeCallback = NULL;
+    gpPBufFreeCallbackParam = pParam;
+    gpPBufFreeCallback = pCallback;
 }
 
 uShortRangePbufList_t *pUShortRangePbufListAlloc(void)
@@ -175,6 +338,36 @@ void uShortRangePbufListMerge(uShortRangePbufList_t *pOldList, uShortRangePbufLi
 }
 
 
+uShortRangePbufList_t *pUShortRangePbufListSplit(uShortRangePbufList_t *pBufList,
+                                                 size_t maxNumPbufs)
+{
+    uShortRangePbufList_t *pNewList = NULL;
+    uShortRangePbuf_t *pTemp;
+
+    if ((pBufList != NULL) && (pBufList->pBufHead != NULL) && (maxNumPbufs > 0)) {
+        pNewList = pUShortRangePbufListAlloc();
+        if (pNewList != NULL) {
+            pNewList->edmChannel = pBufList->edmChannel;
+            pNewList->pBufHead = pBufList->pBufHead;
+            for (pTemp = pBufList->pBufHead; (pTemp != NULL) && (maxNumPbufs > 0);
+                 pTemp = pTemp->pNext) {
+                pNewList->pBufTail = pTemp;
+                pNewList->totalLen += pTemp->length;
+                maxNumPbufs--;
+            }
+            // What is left stays behind
+            pBufList->pBufHead = pNewList->pBufTail->pNext;
+            pNewList->pBufTail->pNext = NULL;
+            if (pBufList->pBufHead == NULL) {
+                pBufList->pBufTail = NULL;
+            }
+            pBufList->totalLen -= pNewList->totalLen;
+        }
+    }
+
+    return pNewList;
+}
+
 size_t uShortRangePbufListConsumeData(uShortRangePbufList_t *pBufList, char *pData, size_t len)
 {
     size_t copiedLen = 0;
@@ -184,12 +377,12 @@ size_t uShortRangePbufListConsumeData(uShortRangePbufList_t *pBufList, char *pDa
     if ((pBufList != NULL) && (pData != NULL)) {
 
         for (pTemp = pBufList->pBufHead; (len != 0 && pTemp != NULL); pTemp = pNext) {
-            // Basic sanity check - pbuf length should never be longer than pool block size
-            U_ASSERT(pTemp->length <= gPBufPool.blockSize);
+            // Basic sanity check - pbuf length should never be longer than its data buffer
+            U_ASSERT(pTemp->offset + pTemp->length <= pTemp->size);
 
             if (pTemp->length <= len) {
                 // Copy the data to the given buffer
-                memcpy(&pData[copiedLen], &pTemp->data[0], pTemp->length);
+                memcpy(&pData[copiedLen], &pTemp->data[pTemp->offset], pTemp->length);
                 copiedLen += pTemp->length;
                 pBufList->totalLen -= pTemp->length;
                 len -= pTemp->length;
@@ -201,13 +394,13 @@ size_t uShortRangePbufListConsumeData(uShortRangePbufList_t *pBufList, char *pDa
                     pBufList->pBufTail = NULL;
                 }
             } else {
-                // Do partial copy
-                memcpy(&pData[copiedLen], &pTemp->data[0], len);
+                // Do partial copy, the remaining data now
+                // starting that much further into the pbuf
+                memcpy(&pData[copiedLen], &pTemp->data[pTemp->offset], len);
                 copiedLen += len;
                 pBufList->totalLen -= (uint16_t)len;
                 pTemp->length -= (uint16_t)len;
-                // move the remaining data to start
-                memmove(&pTemp->data[0], &pTemp->data[len], pTemp->length);
+                pTemp->offset += (uint16_t)len;
                 len = 0;
             }
         }
@@ -241,6 +434,25 @@ int32_t uShortRangePktListAppend(uShortRangePktList_t *pPktList,
     return err;
 }
 
+uShortRangePbufList_t *pUShortRangePktListRemoveHead(uShortRangePktList_t *pPktList)
+{
+    uShortRangePbufList_t *pBufList = NULL;
+
+    if ((pPktList != NULL) && (pPktList->pktCount > 0)) {
+        pBufList = pPktList->pBufListHead;
+        if (pBufList != NULL) {
+            pPktList->pBufListHead = pBufList->pNext;
+            pBufList->pNext = NULL;
+            pPktList->pktCount--;
+            if (pPktList->pktCount == 0) {
+                memset((void *)pPktList, 0, sizeof(uShortRangePktList_t));
+            }
+        }
+    }
+
+    return pBufList;
+}
+
 int32_t uShortRangePktListConsumePacket(uShortRangePktList_t *pPktList, char *pData, size_t *pLen,
                                         int32_t *pEdmChannel)
 {
@@ -95,6 +95,8 @@ typedef struct uShortRangePrivateConnection_t {
 //lint -esym(768, uShortRangePrivateInstance_t::pWifiConnectionStatusCallbackParameter) Suppress not reference, it is
 //lint -esym(768, uShortRangePrivateInstance_t::pNetworkStatusCallback) Suppress not reference, it is
 //lint -esym(768, uShortRangePrivateInstance_t::pNetworkStatusCallbackParameter) Suppress not reference, it is
+//lint -esym(768, uShortRangePrivateInstance_t::pWifiScanContext) Suppress not reference, it is
+//lint -esym(768, uShortRangePrivateInstance_t::pWifiStaCache) Suppress not reference, it is
 typedef struct uShortRangePrivateInstance_t {
     uDeviceHandle_t devHandle; /**< handle for corresponding device. */
     uShortRangeModes_t mode;
@@ -119,6 +121,8 @@ typedef struct uShortRangePrivateInstance_t {
     void *pMqttConnectionStatusCallbackParameter;
     void (*pNetworkStatusCallback) (uDeviceHandle_t, int32_t, uint32_t, void *);
     void *pNetworkStatusCallbackParameter;
+    void *pWifiScanContext; /**< the asynchronous Wi-Fi scan in progress, if any. */
+    void *pWifiStaCache; /**< the Wi-Fi station configuration cache, see u_wifi.c. */
     void (*pSpsConnectionCallback)(int32_t, char *, int32_t, int32_t, int32_t, void *);
     void *pSpsConnectionCallbackParameter;
     void *pPendingSpsConnectionEvent;
@@ -49,7 +49,7 @@
 #include "u_port_os.h"
 #include "u_mempool.h"
 #include "u_short_range_pbuf.h"
-#include "u_short_range_edm.h" // For U_SHORT_RANGE_EDM_BLK_SIZE
+#include "u_short_range_edm.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -63,6 +63,16 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
+/** The length of the payload of the EDM data packets used when
+ * testing uShortRangeEdmParseBuffer().
+ */
+#define U_TEST_PBUF_EDM_PAYLOAD_LENGTH 1000
+
+/** Junk to put before the EDM data packets used when testing
+ * uShortRangeEdmParseBuffer(), including a tail byte (0x55).
+ */
+#define U_TEST_PBUF_EDM_JUNK "\x00\x55xyz\xff"
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -71,6 +81,14 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The EDM parser to test with.
+ */
+static uShortRangeEdmParser_t gParser;
+
+/** Count of the calls to pbufFreeCallback().
+ */
+static int32_t gPbufFreeCallbackCount = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -88,6 +106,66 @@ static int32_t generatePayLoad(uShortRangePbuf_t **ppBuf)
     }
     return errorCode;
 }
+
+// Parse pPacket with uShortRangeEdmParseBuffer() in chunks of
+// chunkSize and check that it results in the data event described.
+static void checkEdmParseBuffer(const char *pPacket, size_t length,
+                                size_t chunkSize, uint8_t channel,
+                                const char *pPayload, size_t payloadLength,
+                                char *pBuffer)
+{
+    uShortRangeEdmEvent_t *pEvent = NULL;
+    uShortRangePbufList_t *pBufList;
+    uShortRangePbuf_t *pBuf;
+    size_t numPbufs;
+    bool memAvailable = true;
+    size_t consumed = 0;
+    size_t thisChunk;
+    size_t numEvents = 0;
+
+    while (consumed < length) {
+        thisChunk = chunkSize;
+        if (thisChunk > length - consumed) {
+            thisChunk = length - consumed;
+        }
+        consumed += uShortRangeEdmParseBuffer(&gParser, pPacket + consumed, thisChunk,
+                                              &pEvent, &memAvailable);
+        U_PORT_TEST_ASSERT(memAvailable);
+        if (pEvent != NULL) {
+            // Must be the end of the packet
+            U_PORT_TEST_ASSERT(consumed == length);
+            U_PORT_TEST_ASSERT(!uShortRangeEdmParserReady(&gParser));
+            U_PORT_TEST_ASSERT(pEvent->type == U_SHORT_RANGE_EDM_EVENT_DATA);
+            U_PORT_TEST_ASSERT(pEvent->params.dataEvent.channel == channel);
+            pBufList = pEvent->params.dataEvent.pBufList;
+            U_PORT_TEST_ASSERT(pBufList->totalLen == payloadLength);
+            // With the default configuration the payload should
+            // be in no more than two (large) pbufs
+            numPbufs = 0;
+            for (pBuf = pBufList->pBufHead; pBuf != NULL; pBuf = pBuf->pNext) {
+                numPbufs++;
+            }
+            U_PORT_TEST_ASSERT(numPbufs <= 2);
+            memset(pBuffer, 0, payloadLength);
+            U_PORT_TEST_ASSERT(uShortRangePbufListConsumeData(pBufList, pBuffer,
+                                                              payloadLength) == payloadLength);
+            U_PORT_TEST_ASSERT(memcmp(pBuffer, pPayload, payloadLength) == 0);
+            uShortRangePbufListFree(pBufList);
+            uShortRangeEdmResetParser(&gParser);
+            numEvents++;
+            pEvent = NULL;
+        }
+    }
+    U_PORT_TEST_ASSERT(numEvents == 1);
+}
+
+// Callback for when pbufs are freed.
+static void pbufFreeCallback(void *pParam)
+{
+    (void) pParam;
+    gPbufFreeCallbackCount++;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -95,6 +173,7 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufInsertPayload")
 {
     int32_t errCode;
     uShortRangePbufList_t *pPbufList;
+    uShortRangePbufList_t *pSplitList;
     int32_t numOfBlks = 8;
     uShortRangePbuf_t *pBuf;
     int32_t heapUsed;
@@ -104,7 +183,7 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufInsertPayload")
     int32_t i;
     //lint -e{679} suppress loss of precision
     //lint -e{647} suppress suspicious truncation
-    size_t totalLen = numOfBlks * U_SHORT_RANGE_EDM_BLK_SIZE;
+    size_t totalLen = numOfBlks * U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES;
 
     // Whatever called us likely initialised the
     // port so deinitialise it here to obtain the
@@ -129,12 +208,32 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufInsertPayload")
 
     for (i = 0; i < numOfBlks; i++) {
         int32_t sizeOfBlk = generatePayLoad(&pBuf);
-        U_PORT_TEST_ASSERT_EQUAL(U_SHORT_RANGE_EDM_BLK_SIZE, sizeOfBlk);
+        U_PORT_TEST_ASSERT_EQUAL(U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES, sizeOfBlk);
         memcpy(&pBuffer2[i * sizeOfBlk], &pBuf->data[0], sizeOfBlk);
         errCode = uShortRangePbufListAppend(pPbufList, pBuf);
         U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
     }
 
+    // Split the first three pbufs off, check that they are the
+    // data of the first three and put them back by merging the
+    // rest onto them
+    pSplitList = pUShortRangePbufListSplit(pPbufList, 3);
+    U_PORT_TEST_ASSERT(pSplitList != NULL);
+    U_PORT_TEST_ASSERT(pSplitList->totalLen == 3 * U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(pPbufList->totalLen == totalLen - pSplitList->totalLen);
+    i = 0;
+    for (pBuf = pSplitList->pBufHead; pBuf != NULL; pBuf = pBuf->pNext) {
+        U_PORT_TEST_ASSERT(memcmp(&pBuf->data[pBuf->offset],
+                                  &pBuffer2[i * U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES],
+                                  pBuf->length) == 0);
+        i++;
+    }
+    U_PORT_TEST_ASSERT(i == 3);
+    U_PORT_TEST_ASSERT(pUShortRangePbufListSplit(pPbufList, 0) == NULL);
+    uShortRangePbufListMerge(pSplitList, pPbufList);
+    pPbufList = pSplitList;
+    U_PORT_TEST_ASSERT(pPbufList->totalLen == totalLen);
+
     for (i = 0; i < (int32_t)totalLen; i++) {
         copiedLen += uShortRangePbufListConsumeData(pPbufList, &pBuffer3[i], 1);
     }
@@ -144,6 +243,20 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufInsertPayload")
     errCode = memcmp(pBuffer2, pBuffer3, totalLen);
     U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
 
+    // Splitting more pbufs than there are takes them all
+    for (i = 0; i < 2; i++) {
+        U_PORT_TEST_ASSERT(generatePayLoad(&pBuf) > 0);
+        U_PORT_TEST_ASSERT(uShortRangePbufListAppend(pPbufList, pBuf) == 0);
+    }
+    pSplitList = pUShortRangePbufListSplit(pPbufList, 10);
+    U_PORT_TEST_ASSERT(pSplitList != NULL);
+    U_PORT_TEST_ASSERT(pSplitList->totalLen == 2 * U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES);
+    U_PORT_TEST_ASSERT((pPbufList->totalLen == 0) && (pPbufList->pBufHead == NULL) &&
+                       (pPbufList->pBufTail == NULL));
+    U_PORT_TEST_ASSERT(pUShortRangePbufListSplit(pPbufList, 1) == NULL);
+    uShortRangePbufListFree(pSplitList);
+    uShortRangePbufListFree(pPbufList);
+
     uShortRangeMemPoolDeInit();
     free(pBuffer2);
     free(pBuffer3);
@@ -171,7 +284,7 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufPktList")
     int32_t i;
     //lint -e{679} suppress loss of precision
     //lint -e{647} suppress suspicious truncation
-    size_t totalLen = numOfBlks * U_SHORT_RANGE_EDM_BLK_SIZE;
+    size_t totalLen = numOfBlks * U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES;
 
     // Whatever called us likely initialised the
     // port so deinitialise it here to obtain the
@@ -206,7 +319,7 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufPktList")
     // Fill it with random data
     for (i = 0; i < numOfBlks / 2; i++) {
         int32_t sizeOfBlk = generatePayLoad(&pBuf);
-        U_PORT_TEST_ASSERT_EQUAL(U_SHORT_RANGE_EDM_BLK_SIZE, sizeOfBlk);
+        U_PORT_TEST_ASSERT_EQUAL(U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES, sizeOfBlk);
         memcpy(&pBuffer1[i * sizeOfBlk], &pBuf->data[0], sizeOfBlk);
         errCode = uShortRangePbufListAppend(pPbufList1, pBuf);
         U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
@@ -240,6 +353,15 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufPktList")
 
     memset(pBuffer3, 0, totalLen);
 
+    // Take the second packet out without its data being
+    // touched and put it back again
+    U_PORT_TEST_ASSERT(pUShortRangePktListRemoveHead(&pktList) == pPbufList2);
+    U_PORT_TEST_ASSERT(pktList.pktCount == 0);
+    U_PORT_TEST_ASSERT(pPbufList2->totalLen == totalLen);
+    U_PORT_TEST_ASSERT(pUShortRangePktListRemoveHead(&pktList) == NULL);
+    errCode = uShortRangePktListAppend(&pktList, pPbufList2);
+    U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
+
     errCode = uShortRangePktListConsumePacket(&pktList, pBuffer3, &totalLen, NULL);
     U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
 
@@ -262,4 +384,308 @@ U_PORT_TEST_FUNCTION("[pbuf]", "pbufPktList")
     U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
 }
 
+U_PORT_TEST_FUNCTION("[pbuf]", "pbufEdmParseBuffer")
+{
+    int32_t errCode;
+    int32_t heapUsed;
+    char *pPayload;
+    char *pPacket;
+    char *pBuffer;
+    uShortRangeEdmEvent_t *pEvent = NULL;
+    uShortRangePbufList_t *pBufList;
+    bool memAvailable = true;
+    size_t packetLength;
+    size_t junkLength = sizeof(U_TEST_PBUF_EDM_JUNK) - 1;
+    size_t chunkSize[] = {1, 7, U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES,
+                          U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES + 1,
+                          U_TEST_PBUF_EDM_PAYLOAD_LENGTH * 2
+                         };
+    size_t x;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    rand();
+    heapUsed = uPortGetHeapFree();
+
+    errCode = uShortRangeMemPoolInit();
+    U_PORT_TEST_ASSERT(errCode == (int32_t)U_ERROR_COMMON_SUCCESS);
+    uShortRangeEdmParserInit(&gParser, 0);
+
+    pPayload = (char *)malloc(U_TEST_PBUF_EDM_PAYLOAD_LENGTH);
+    U_PORT_TEST_ASSERT(pPayload != NULL);
+    pBuffer = (char *)malloc(U_TEST_PBUF_EDM_PAYLOAD_LENGTH);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    pPacket = (char *)malloc(junkLength + U_TEST_PBUF_EDM_PAYLOAD_LENGTH +
+                             U_SHORT_RANGE_EDM_DATA_OVERHEAD);
+    U_PORT_TEST_ASSERT(pPacket != NULL);
+
+    // A data packet preceded by junk.  Note that the module sends
+    // data events while uShortRangeEdmData() creates a data command,
+    // hence the type is modified
+    for (x = 0; x < U_TEST_PBUF_EDM_PAYLOAD_LENGTH; x++) {
+        // Include plenty of start and tail bytes in the payload
+        pPayload[x] = (char) ((x & 1) ? 0xAA : rand());
+    }
+    memcpy(pPacket, U_TEST_PBUF_EDM_JUNK, junkLength);
+    errCode = uShortRangeEdmData(3, pPayload, U_TEST_PBUF_EDM_PAYLOAD_LENGTH,
+                                 pPacket + junkLength);
+    U_PORT_TEST_ASSERT(errCode == U_SHORT_RANGE_EDM_OK);
+    pPacket[junkLength + 4] = 0x31;
+    packetLength = junkLength + U_TEST_PBUF_EDM_PAYLOAD_LENGTH + U_SHORT_RANGE_EDM_DATA_OVERHEAD;
+
+    for (x = 0; x < sizeof(chunkSize) / sizeof(chunkSize[0]); x++) {
+        U_TEST_PRINT_LINE("parsing an EDM data packet in chunks of %d byte(s).",
+                          (int32_t) chunkSize[x]);
+        checkEdmParseBuffer(pPacket, packetLength, chunkSize[x], 3,
+                            pPayload, U_TEST_PBUF_EDM_PAYLOAD_LENGTH, pBuffer);
+    }
+
+    // While the parser is waiting for an event to be processed
+    // nothing should be consumed
+    U_PORT_TEST_ASSERT(uShortRangeEdmParseBuffer(&gParser, pPacket, packetLength, &pEvent,
+                                                 &memAvailable) == packetLength);
+    U_PORT_TEST_ASSERT(pEvent != NULL);
+    pBufList = pEvent->params.dataEvent.pBufList;
+    U_PORT_TEST_ASSERT(uShortRangeEdmParseBuffer(&gParser, pPacket, packetLength, &pEvent,
+                                                 &memAvailable) == 0);
+    U_PORT_TEST_ASSERT(pEvent == NULL);
+    uShortRangePbufListFree(pBufList);
+    uShortRangeEdmResetParser(&gParser);
+
+    uShortRangeMemPoolDeInit();
+    free(pPayload);
+    free(pBuffer);
+    free(pPacket);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+U_PORT_TEST_FUNCTION("[pbuf]", "pbufSizeClasses")
+{
+    int32_t heapUsed;
+    uShortRangePbufList_t *pPbufList;
+    uShortRangePbuf_t *pBuf[4];
+    uShortRangePbufClassCfg_t cfg[] = {{32, 2}, {200, 1}};
+    uShortRangePbufClassCfg_t cfgBad[] = {{200, 1}, {32, 2}};
+    uShortRangePbufClassCfg_t cfgDefault[] = {{U_SHORT_RANGE_PBUF_SMALL_DATA_SIZE_BYTES,
+            U_SHORT_RANGE_PBUF_SMALL_COUNT
+        },
+        {U_SHORT_RANGE_PBUF_LARGE_DATA_SIZE_BYTES, U_SHORT_RANGE_PBUF_LARGE_COUNT}
+    };
+    char buffer[200];
+    size_t x;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uShortRangePbufCfgSet(NULL, 1) < 0);
+    U_PORT_TEST_ASSERT(uShortRangePbufCfgSet(cfgBad, 2) < 0);
+    U_PORT_TEST_ASSERT(uShortRangePbufCfgSet(cfg, 2) == 0);
+    U_PORT_TEST_ASSERT(uShortRangeMemPoolInit() == 0);
+    U_PORT_TEST_ASSERT(uShortRangePbufCfgSet(cfg, 2) == (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE);
+
+    // A small allocation should come from the small class, a large
+    // one from the large class and, once the large class is empty,
+    // a large allocation should come from the small class
+    U_PORT_TEST_ASSERT(uShortRangePbufAllocSized(&pBuf[0], 10) == 32);
+    U_PORT_TEST_ASSERT(uShortRangePbufAllocSized(&pBuf[1], 1000) == 200);
+    U_PORT_TEST_ASSERT(uShortRangePbufAllocSized(&pBuf[2], 150) == 32);
+    U_PORT_TEST_ASSERT(uShortRangePbufAllocSized(&pBuf[3], 150) < 0);
+    U_PORT_TEST_ASSERT(pBuf[3] == NULL);
+
+    // Fill the large one and read it out in pieces
+    pPbufList = pUShortRangePbufListAlloc();
+    U_PORT_TEST_ASSERT(pPbufList != NULL);
+    for (x = 0; x < 200; x++) {
+        pBuf[1]->data[x] = (char) x;
+    }
+    pBuf[1]->length = 200;
+    U_PORT_TEST_ASSERT(uShortRangePbufListAppend(pPbufList, pBuf[1]) == 0);
+    for (x = 0; x < 200; x += 25) {
+        U_PORT_TEST_ASSERT(uShortRangePbufListConsumeData(pPbufList, buffer + x, 25) == 25);
+    }
+    U_PORT_TEST_ASSERT(pPbufList->totalLen == 0);
+    for (x = 0; x < 200; x++) {
+        U_PORT_TEST_ASSERT(buffer[x] == (char) x);
+    }
+    uShortRangePbufListFree(pPbufList);
+
+    // The large one is now free again
+    U_PORT_TEST_ASSERT(uShortRangePbufAllocSized(&pBuf[1], 1000) == 200);
+    pPbufList = pUShortRangePbufListAlloc();
+    U_PORT_TEST_ASSERT(pPbufList != NULL);
+    for (x = 0; x < 3; x++) {
+        U_PORT_TEST_ASSERT(uShortRangePbufListAppend(pPbufList, pBuf[x]) == 0);
+    }
+    uShortRangePbufListFree(pPbufList);
+
+    uShortRangeMemPoolDeInit();
+    // Put the default configuration back
+    U_PORT_TEST_ASSERT(uShortRangePbufCfgSet(cfgDefault, 2) == 0);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+U_PORT_TEST_FUNCTION("[pbuf]", "pbufRxQuota")
+{
+    int32_t heapUsed;
+    char *pPayload;
+    char *pPacket;
+    uShortRangeEdmEvent_t *pEvent = NULL;
+    uShortRangePbufList_t *pBufList[3];
+    uShortRangeEdmParser_t parser;
+    bool memAvailable = true;
+    size_t packetLength = U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE + U_SHORT_RANGE_EDM_DATA_OVERHEAD;
+    size_t consumed;
+    size_t x;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uShortRangeMemPoolInit() == 0);
+    uShortRangeEdmParserInit(&gParser, 0);
+    uShortRangePbufFreeCallbackSet(pbufFreeCallback, NULL);
+    gPbufFreeCallbackCount = 0;
+
+    // Check the quota settings
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaSet(&gParser, -1, 100) < 0);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaSet(&gParser, U_SHORT_RANGE_PBUF_CHANNEL_MAX_NUM,
+                                                100) < 0);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaGet(&gParser, 2) ==
+                       (uShortRangePbufPoolSizeBytes() *
+                        U_SHORT_RANGE_EDM_RX_QUOTA_DEFAULT_PERCENT) / 100);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaSet(&gParser, 2, 0) == U_SHORT_RANGE_EDM_OK);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaGet(&gParser, 2) == 0);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaSet(&gParser, 2, -1) == U_SHORT_RANGE_EDM_OK);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaGet(&gParser, 2) > 0);
+    // A quota of one IP MTU packet
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaSet(&gParser, 1,
+                                                U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE) ==
+                       U_SHORT_RANGE_EDM_OK);
+
+    pPayload = (char *)malloc(U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE);
+    U_PORT_TEST_ASSERT(pPayload != NULL);
+    pPacket = (char *)malloc(packetLength);
+    U_PORT_TEST_ASSERT(pPacket != NULL);
+    for (x = 0; x < U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE; x++) {
+        pPayload[x] = (char) x;
+    }
+    U_PORT_TEST_ASSERT(uShortRangeEdmData(1, pPayload, U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE,
+                                          pPacket) == U_SHORT_RANGE_EDM_OK);
+    // Make it a data event, as the module would send
+    pPacket[4] = 0x31;
+
+    // The first packet on channel 1 is charged to channel 1
+    U_PORT_TEST_ASSERT(uShortRangeEdmParseBuffer(&gParser, pPacket, packetLength, &pEvent,
+                                                 &memAvailable) == packetLength);
+    U_PORT_TEST_ASSERT(memAvailable);
+    U_PORT_TEST_ASSERT(pEvent != NULL);
+    pBufList[0] = pEvent->params.dataEvent.pBufList;
+    U_PORT_TEST_ASSERT(pBufList[0]->totalLen == U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE);
+    U_PORT_TEST_ASSERT(uShortRangePbufChannelHeldBytes(0, 1) >= U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE);
+    U_PORT_TEST_ASSERT(uShortRangePbufChannelHeldBytes(0, 0) == 0);
+    uShortRangeEdmResetParser(&gParser);
+
+    // With that not consumed, a second packet on channel 1 stalls
+    // for quota after the header
+    consumed = uShortRangeEdmParseBuffer(&gParser, pPacket, packetLength, &pEvent,
+                                         &memAvailable);
+    U_PORT_TEST_ASSERT(!memAvailable);
+    U_PORT_TEST_ASSERT(pEvent == NULL);
+    U_PORT_TEST_ASSERT(consumed == U_SHORT_RANGE_EDM_DATA_HEAD_SIZE);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaStalledChannel(&gParser) == 1);
+
+    // A parser with a different owner, i.e. another EDM stream, has
+    // its own accounting and so is not held up by the first
+    uShortRangeEdmParserInit(&parser, 1);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaSet(&parser, 1,
+                                                U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE) ==
+                       U_SHORT_RANGE_EDM_OK);
+    U_PORT_TEST_ASSERT(uShortRangeEdmParseBuffer(&parser, pPacket, packetLength, &pEvent,
+                                                 &memAvailable) == packetLength);
+    U_PORT_TEST_ASSERT(memAvailable);
+    U_PORT_TEST_ASSERT(pEvent != NULL);
+    pBufList[2] = pEvent->params.dataEvent.pBufList;
+    U_PORT_TEST_ASSERT(uShortRangePbufChannelHeldBytes(1, 1) >= U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaStalledChannel(&parser) < 0);
+    pEvent = NULL;
+    U_PORT_TEST_ASSERT(uShortRangeEdmParseBuffer(&gParser, pPacket + consumed,
+                                                 packetLength - consumed,
+                                                 &pEvent, &memAvailable) == 0);
+    U_PORT_TEST_ASSERT(!memAvailable);
+
+    // Consume half of the first packet: still too much held
+    x = uShortRangePbufListConsumeData(pBufList[0], pPayload,
+                                       U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE / 2);
+    U_PORT_TEST_ASSERT(x == U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE / 2);
+    U_PORT_TEST_ASSERT(uShortRangeEdmParseBuffer(&gParser, pPacket + consumed,
+                                                 packetLength - consumed,
+                                                 &pEvent, &memAvailable) == 0);
+    U_PORT_TEST_ASSERT(!memAvailable);
+
+    // Free the first packet: the credit returns, the callback is
+    // called and the second packet gets through
+    U_PORT_TEST_ASSERT(gPbufFreeCallbackCount == 0);
+    uShortRangePbufListFree(pBufList[0]);
+    U_PORT_TEST_ASSERT(gPbufFreeCallbackCount > 0);
+    U_PORT_TEST_ASSERT(uShortRangePbufChannelHeldBytes(0, 1) == 0);
+    U_PORT_TEST_ASSERT(uShortRangeEdmParseBuffer(&gParser, pPacket + consumed,
+                                                 packetLength - consumed,
+                                                 &pEvent, &memAvailable) ==
+                       packetLength - consumed);
+    U_PORT_TEST_ASSERT(memAvailable);
+    U_PORT_TEST_ASSERT(pEvent != NULL);
+    pBufList[0] = pEvent->params.dataEvent.pBufList;
+    uShortRangeEdmResetParser(&gParser);
+
+    // A packet on another channel is not held up by channel 1
+    pPacket[5] = 0;
+    U_PORT_TEST_ASSERT(uShortRangeEdmParseBuffer(&gParser, pPacket, packetLength, &pEvent,
+                                                 &memAvailable) == packetLength);
+    U_PORT_TEST_ASSERT(memAvailable);
+    U_PORT_TEST_ASSERT(pEvent != NULL);
+    U_PORT_TEST_ASSERT(pEvent->params.dataEvent.channel == 0);
+    pBufList[1] = pEvent->params.dataEvent.pBufList;
+    U_PORT_TEST_ASSERT(uShortRangePbufChannelHeldBytes(0, 0) >= U_SHORT_RANGE_EDM_MTU_IP_MAX_SIZE);
+    uShortRangeEdmResetParser(&gParser);
+
+    uShortRangePbufListFree(pBufList[0]);
+    uShortRangePbufListFree(pBufList[1]);
+    U_PORT_TEST_ASSERT(uShortRangePbufChannelHeldBytes(0, 0) == 0);
+    U_PORT_TEST_ASSERT(uShortRangePbufChannelHeldBytes(0, 1) == 0);
+    uShortRangePbufListFree(pBufList[2]);
+    U_PORT_TEST_ASSERT(uShortRangePbufChannelHeldBytes(1, 1) == 0);
+
+    uShortRangePbufFreeCallbackSet(NULL, NULL);
+    U_PORT_TEST_ASSERT(uShortRangeEdmRxQuotaSet(&gParser, 1, -1) == U_SHORT_RANGE_EDM_OK);
+    uShortRangeMemPoolDeInit();
+    free(pPayload);
+    free(pPacket);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
 // End of file
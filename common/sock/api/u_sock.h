@@ -77,6 +77,44 @@ extern "C" {
 # define U_SOCK_CLOSE_TIMEOUT_SECONDS 60
 #endif
 
+#ifndef U_SOCK_DNS_CACHE_NUM_ENTRIES
+/** The number of host names for which the result of a look-up
+ * by uSockGetHostByName() is cached, saving a trip to the DNS
+ * server (which, on cellular, can take seconds) the next time
+ * the same host name is looked up on the same device.  Set this
+ * to 0 to switch the cache off.
+ */
+# define U_SOCK_DNS_CACHE_NUM_ENTRIES 4
+#endif
+
+#ifndef U_SOCK_DNS_CACHE_HOST_NAME_MAX_LENGTH_BYTES
+/** The storage for a host name in the DNS cache, including room
+ * for the null terminator; a longer host name is looked up as
+ * normal but is not cached.
+ */
+# define U_SOCK_DNS_CACHE_HOST_NAME_MAX_LENGTH_BYTES 64
+#endif
+
+#ifndef U_SOCK_DNS_CACHE_TTL_SECONDS
+/** How long a successful look-up remains in the DNS cache.  The
+ * underlying modules do not report the time-to-live of a DNS
+ * record and so a fixed value is used: this should be no longer
+ * than the shortest time-to-live of the host names you look up.
+ */
+# define U_SOCK_DNS_CACHE_TTL_SECONDS 600
+#endif
+
+#ifndef U_SOCK_DNS_CACHE_NEGATIVE_TTL_SECONDS
+/** How long a look-up that failed because the host name could
+ * not be found remains in the DNS cache, during which time
+ * uSockGetHostByName() will fail for that host name straight
+ * away.  Look-ups that failed for any other reason (e.g.
+ * a timeout) are never cached.  Set this to 0 to switch off
+ * caching of failed look-ups.
+ */
+# define U_SOCK_DNS_CACHE_NEGATIVE_TTL_SECONDS 30
+#endif
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS: SOCKET OPTIONS FOR SOCKET LEVEL (-1)
  * -------------------------------------------------------------- */
@@ -190,6 +228,77 @@ extern "C" {
  */
 #define U_SOCK_OPT_NO_CHECK     0x100a
 
+/** Socket option: coalesce small writes to a TCP socket in a
+ * local buffer, so that many small uSockWrite()s become a few
+ * large writes to the module; each write to the module carries
+ * the overhead of an AT command round trip, which for a short
+ * record can be far larger than the record itself.  The option
+ * value is a #uSockCoalesce_t.  The buffer is flushed when it is
+ * full, when the timeout of the oldest data in it expires, when
+ * uSockFlush() is called and when the socket is closed.  A buffer
+ * size no larger than the maximum segment size of the underlying
+ * socket layer (e.g. U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES) means
+ * that each flush is a single write to the module.  This option
+ * is specific to ubxlib, it is not an LWIP or BSD option.
+ */
+#define U_SOCK_OPT_COALESCE     0x4001
+
+/** Socket option: put a connected cellular socket into direct
+ * link mode (AT+USODL), where the socket owns the stream to the
+ * module and data is written and read raw, without the overhead
+ * of an AT command per segment, which is much faster for bulk
+ * transfers.  The option value is an int32_t, non-zero to enter
+ * direct link mode, zero to leave it; leaving takes a few seconds
+ * since the escape sequence has to be surrounded by guard times.
+ * In direct link mode data is sent and received with uSockWrite()
+ * and uSockRead(); no AT commands can be sent to the module and no
+ * URCs are received, hence all other socket operations on the same
+ * module (including uSockSendTo()/uSockReceiveFrom() on this socket)
+ * return #U_SOCK_EBUSY and nothing else must use the module;
+ * received data not read when direct link mode is left is lost.
+ * Direct link mode uses the receive intercept of the AT client (see
+ * uAtClientStreamInterceptRx()) and so cannot be used while anything
+ * else needs that intercept.  This option is specific to ubxlib, it
+ * is not an LWIP or BSD option.
+ */
+#define U_SOCK_OPT_DIRECT_LINK  0x4002
+
+/** Socket option: the priority with which a cellular socket is
+ * told that received data is waiting, from 0 (the default) to
+ * #U_SOCK_OPT_READ_PRIORITY_MAX.  When several sockets have data
+ * waiting their data callbacks are called in order of priority,
+ * sockets of equal priority taking turns, rather than in the order
+ * the data arrived, so that, for instance, a control socket can
+ * be read promptly while a bulk-transfer socket keeps the link busy.
+ * Each time a socket with data waiting is passed over in favour of
+ * another its effective priority is raised by one, so that no
+ * socket is starved.  The option value is an int32_t.  This option
+ * is specific to ubxlib, it is not an LWIP or BSD option.
+ */
+#define U_SOCK_OPT_READ_PRIORITY 0x4003
+
+/** The maximum value of #U_SOCK_OPT_READ_PRIORITY.
+ */
+#define U_SOCK_OPT_READ_PRIORITY_MAX 255
+
+/** Socket option: the size, in bytes, of a read-ahead cache in RAM
+ * for a connected cellular socket, zero (the default) for none.
+ * With a read-ahead cache, a call to uSockRead() asking for less
+ * than the cache size reads as much as the cache will hold from the
+ * module in a single AT command and returns the rest of it from RAM
+ * on subsequent calls; if a data callback is registered the cache
+ * is also filled when the module reports that data has arrived.
+ * This means that a protocol parser which reads a header a few
+ * bytes at a time does not pay for an AT command per read.  The
+ * option value is an int32_t, at most the maximum segment size of
+ * the underlying socket layer (e.g.
+ * U_CELL_SOCK_MAX_SEGMENT_SIZE_BYTES); the cache size cannot be
+ * changed, or the cache removed, while it holds unread data.  The
+ * cache is used only by uSockRead(), not by uSockReceiveFrom().  This
+ * option is specific to ubxlib, it is not an LWIP or BSD option.
+ */
+#define U_SOCK_OPT_READ_AHEAD 0x4004
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS: SOCKET OPTIONS FOR IP LEVEL (0)
  * -------------------------------------------------------------- */
@@ -290,6 +399,31 @@ extern "C" {
                                      (*(pSet))[(d) / 8] & (1 << ((d) & 7));  \
                                  }
 
+/** Poll event: data may be read from the socket, see
+ * uSockPollSet().
+ */
+#define U_SOCK_POLL_EVENT_READ   0x01
+
+/** Poll event: data may be written to the socket, see
+ * uSockPollSet().
+ */
+#define U_SOCK_POLL_EVENT_WRITE  0x02
+
+/** Poll event: the socket has been closed, locally or by the
+ * remote host; this is reported for any socket that has been
+ * registered with uSockPollSet(), whether it is in the event
+ * mask or not.
+ */
+#define U_SOCK_POLL_EVENT_CLOSED 0x04
+
+/** Poll event: a connection started with uSockConnectAsync() has
+ * failed; like #U_SOCK_POLL_EVENT_CLOSED this is reported for any
+ * socket that has been registered with uSockPollSet(), whether it
+ * is in the event mask or not.  Success of uSockConnectAsync() is
+ * reported as #U_SOCK_POLL_EVENT_WRITE.
+ */
+#define U_SOCK_POLL_EVENT_ERROR  0x08
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -302,6 +436,23 @@ typedef int32_t uSockDescriptor_t;
  */
 typedef uint8_t uSockDescriptorSet_t[(U_SOCK_DESCRIPTOR_SET_SIZE + 7) / 8];
 
+/** A fragment of data for uSockSendv() and uSockReceivev(), as
+ * the iovec of POSIX; the struct is named so that the layers
+ * underneath, which do not include this header, can refer to it.
+ */
+typedef struct uSockIoVec_t {
+    void *pBase;   /**< the start of the fragment; for sending
+                        this is treated as pointing to const. */
+    size_t length; /**< the number of bytes at pBase. */
+} uSockIoVec_t;
+
+/** A socket that is ready, as returned by uSockPollWait().
+ */
+typedef struct {
+    uSockDescriptor_t descriptor;
+    uint32_t events; /**< a bitmap of U_SOCK_POLL_EVENT_xxx values. */
+} uSockPollEvent_t;
+
 /** Supported socket types: the numbers match those of LWIP.
  */
 typedef enum {
@@ -344,6 +495,30 @@ typedef struct {
     uint16_t port;
 } uSockAddress_t;
 
+/** A datagram for uSockSendToMany() and uSockReceiveFromMany(), as
+ * the mmsghdr of POSIX sendmmsg()/recvmmsg().
+ */
+typedef struct {
+    uSockAddress_t *pRemoteAddress; /**< when sending, the address of
+                                         the host to send to, NULL
+                                         to use the address given to
+                                         uSockConnect(), treated as
+                                         pointing to const; when
+                                         receiving, a place to put the
+                                         address of the host the
+                                         datagram came from, may be
+                                         NULL. */
+    void *pData;                    /**< the datagram; when sending
+                                         this is treated as pointing
+                                         to const. */
+    size_t dataSizeBytes;           /**< when sending, the length of
+                                         the datagram; when receiving,
+                                         the storage at pData. */
+    int32_t sizeBytes;              /**< set on return: the number of
+                                         bytes sent or received for
+                                         this datagram. */
+} uSockDatagram_t;
+
 /** Socket shut-down types: the numbers match those of LWIP.
  */
 typedef enum {
@@ -360,6 +535,64 @@ typedef struct {
     int32_t lingerSeconds;  //<! linger time in seconds.
 } uSockLinger_t;
 
+/** Struct to define the #U_SOCK_OPT_COALESCE socket option.
+ */
+typedef struct {
+    size_t bufferSizeBytes; /**< the size of the buffer to coalesce
+                                 writes into; use zero to switch
+                                 coalescing off again, in which
+                                 case anything in the buffer is
+                                 flushed first. */
+    int32_t timeoutMs;      /**< the longest time that data may sit
+                                 in the buffer before it is flushed;
+                                 use zero to flush only when the
+                                 buffer is full or on uSockFlush(). */
+} uSockCoalesce_t;
+
+/** Statistics for a socket, as returned by uSockStatsGet(); all
+ * of the values are from when the socket was created.
+ */
+typedef struct {
+    int32_t bytesSent;     /**< the number of bytes passed to the
+                                underlying socket layer, as returned
+                                by uSockGetTotalBytesSent(); data
+                                waiting in a coalescing buffer (see
+                                #U_SOCK_OPT_COALESCE) is not included. */
+    int32_t bytesReceived; /**< the number of bytes returned to the
+                                application by the read/receive
+                                functions. */
+    int32_t numReadsWouldBlock; /**< the number of read/receive calls
+                                     that returned with errno set to
+                                     #U_SOCK_EWOULDBLOCK, i.e. found
+                                     no data. */
+    int32_t numDataCallbacks;   /**< the number of times that the
+                                     underlying socket layer indicated
+                                     that data had arrived, e.g. from
+                                     a +UUSORD URC for cellular; these
+                                     indications are only requested
+                                     once uSockRegisterCallbackData()
+                                     has been called or uSockPollSet()
+                                     has been called with
+                                     #U_SOCK_POLL_EVENT_READ. */
+    int32_t numWrites;     /**< the number of successful writes to the
+                                underlying socket layer. */
+    int32_t writeLatencyAverageMs; /**< the average time taken by a write
+                                        to the underlying socket layer, -1
+                                        if there have been none. */
+    int32_t writeLatencyMaxMs;     /**< the longest time taken by a write
+                                        to the underlying socket layer, -1
+                                        if there have been none. */
+    int32_t readLatencyAverageMs;  /**< the average time from the first data
+                                        indication after a read to the next
+                                        read that returned data, i.e. how
+                                        long received data sits in the module
+                                        before the application picks it up;
+                                        -1 if there have been none. */
+    int32_t readLatencyMaxMs;      /**< the longest time from a data
+                                        indication to a read that returned
+                                        data, -1 if there have been none. */
+} uSockStats_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: CREATE/OPEN/CLOSE/CLEAN-UP
  * -------------------------------------------------------------- */
@@ -571,11 +804,57 @@ int32_t uSockReceiveFrom(uSockDescriptor_t descriptor,
                          uSockAddress_t *pRemoteAddress,
                          void *pData, size_t dataSizeBytes);
 
+/** Send several datagrams in one call, as sendmmsg() in POSIX.  This
+ * is useful for bursts of small datagrams: on cellular the datagrams
+ * are sent back-to-back with the AT interface locked throughout,
+ * rather than each send having to win the AT interface; on Wi-Fi
+ * each datagram is, as ever, a single EDM data frame.  Datagrams are
+ * sent in order and sending stops at the first failure.
+ *
+ * @param descriptor      the descriptor of the socket.
+ * @param[in,out] pDatagrams an array of numDatagrams datagrams; the
+ *                        sizeBytes field of each one sent is filled in.
+ * @param numDatagrams    the number of entries at pDatagrams.
+ * @return                on success the number of datagrams sent,
+ *                        from the start of the array, else negative
+ *                        error code (and errno will also be set to a
+ *                        value from u_sock_errno.h) if not even the
+ *                        first could be sent.
+ */
+int32_t uSockSendToMany(uSockDescriptor_t descriptor,
+                        uSockDatagram_t *pDatagrams,
+                        size_t numDatagrams);
+
+/** Receive up to numDatagrams datagrams in one call, as recvmmsg()
+ * in POSIX with MSG_WAITFORONE: if the socket is blocking this waits,
+ * as uSockReceiveFrom() would, for the first datagram, then collects
+ * whatever other datagrams are already waiting without blocking; on
+ * cellular the latter are read back-to-back with the AT interface
+ * locked throughout.  As for uSockReceiveFrom(), a datagram longer
+ * than the dataSizeBytes of its entry is truncated.
+ *
+ * @param descriptor      the descriptor of the socket.
+ * @param[in,out] pDatagrams an array of numDatagrams datagrams; the
+ *                        pRemoteAddress (where not NULL) and sizeBytes
+ *                        fields of each one received are filled in.
+ * @param numDatagrams    the number of entries at pDatagrams.
+ * @return                on success the number of datagrams received
+ *                        into the start of the array, else negative
+ *                        error code (and errno will also be set to a
+ *                        value from u_sock_errno.h).
+ */
+int32_t uSockReceiveFromMany(uSockDescriptor_t descriptor,
+                             uSockDatagram_t *pDatagrams,
+                             size_t numDatagrams);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: STREAM (TCP)
  * -------------------------------------------------------------- */
 
-/** Send data.
+/** Send data.  If #U_SOCK_OPT_COALESCE has been set on the socket
+ * the data may only have been copied into the coalescing buffer
+ * when this returns; an error in sending it later will be returned
+ * by the next call to uSockWrite() or uSockFlush().
  *
  * @param descriptor     the descriptor of the socket.
  * @param pData          the data to send.
@@ -587,6 +866,19 @@ int32_t uSockReceiveFrom(uSockDescriptor_t descriptor,
 int32_t uSockWrite(uSockDescriptor_t descriptor,
                    const void *pData, size_t dataSizeBytes);
 
+/** Send any data that is waiting in the coalescing buffer of a
+ * socket (see #U_SOCK_OPT_COALESCE); if the option has not been
+ * set on the socket this does nothing and returns success.
+ *
+ * @param descriptor     the descriptor of the socket.
+ * @return               zero on success else negative error code
+ *                       (and errno will also be set to a value
+ *                       from u_sock_errno.h); on failure any data
+ *                       that could not be sent remains in the
+ *                       coalescing buffer.
+ */
+int32_t uSockFlush(uSockDescriptor_t descriptor);
+
 /** Receive data.
  *
  * @param descriptor     the descriptor of the socket.
@@ -615,6 +907,73 @@ int32_t uSockRead(uSockDescriptor_t descriptor,
 int32_t uSockShutdown(uSockDescriptor_t descriptor,
                       uSockShutdown_t how);
 
+/* ----------------------------------------------------------------
+ * FUNCTIONS: SCATTER-GATHER
+ * -------------------------------------------------------------- */
+
+/** Send data that is held in several fragments, e.g. a header,
+ * a payload and a trailer, without first copying it into a single
+ * buffer.  Where the underlying transport allows, the fragments are
+ * sent with a single write to the module, e.g. a single AT+USOWR or
+ * AT+USOST command for cellular or a single EDM data frame for
+ * Wi-Fi, rather than one write per fragment.
+ *
+ * If pRemoteAddress is non-NULL, or the socket is a UDP socket,
+ * this behaves as uSockSendTo() with all of the fragments forming
+ * a single datagram; otherwise it behaves as uSockWrite().
+ *
+ * @param descriptor     the descriptor of the socket.
+ * @param pRemoteAddress the address of the remote host to send a
+ *                       datagram to; may be NULL, see above.
+ * @param pIoVec         an array of numIoVec fragments; an entry
+ *                       with a length of zero is ignored.
+ * @param numIoVec       the number of entries at pIoVec.
+ * @return               on success the number of bytes sent else
+ *                       negative error code (and errno will also
+ *                       be set to a value from u_sock_errno.h).
+ */
+int32_t uSockSendv(uSockDescriptor_t descriptor,
+                   const uSockAddress_t *pRemoteAddress,
+                   const uSockIoVec_t *pIoVec, size_t numIoVec);
+
+/** Receive data into several fragments, the counterpart of
+ * uSockSendv().  If pRemoteAddress is non-NULL, or the socket is a
+ * UDP socket, this behaves as uSockReceiveFrom(), a single datagram
+ * being spread across the fragments in order (note: this employs a
+ * temporary buffer of the total length of the fragments); otherwise
+ * it behaves as uSockRead(), the fragments being filled in order
+ * until no more data is available.
+ *
+ * @param descriptor          the descriptor of the socket.
+ * @param[out] pRemoteAddress a place to put the address of the
+ *                            remote host from which a datagram
+ *                            was received; may be NULL, see above.
+ * @param pIoVec              an array of numIoVec fragments to
+ *                            receive into.
+ * @param numIoVec            the number of entries at pIoVec.
+ * @return                    on success the number of bytes received
+ *                            else negative error code (and errno will
+ *                            also be set to a value from
+ *                            u_sock_errno.h).
+ */
+int32_t uSockReceivev(uSockDescriptor_t descriptor,
+                      uSockAddress_t *pRemoteAddress,
+                      const uSockIoVec_t *pIoVec, size_t numIoVec);
+
+/** Get the total length of the fragments of an I/O vector; this
+ * is provided for the layers underneath uSockSendv() and
+ * uSockReceivev().
+ *
+ * @param pIoVec   an array of numIoVec fragments; may be NULL
+ *                 only if numIoVec is zero.
+ * @param numIoVec the number of entries at pIoVec.
+ * @return         the total length of the fragments, which
+ *                 may be zero, else negative error code if an
+ *                 entry with a non-zero length has a NULL pBase
+ *                 or the total would exceed INT_MAX.
+ */
+int32_t uSockIoVecLength(const uSockIoVec_t *pIoVec, size_t numIoVec);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: ASYNC
  * -------------------------------------------------------------- */
@@ -664,6 +1023,123 @@ void uSockRegisterCallbackClosed(uSockDescriptor_t descriptor,
                                  void (*pCallback) (void *),
                                  void *pCallbackParameter);
 
+/** Connect to a server without blocking: this function returns
+ * as soon as the connection has been started, allowing several
+ * connections to be brought up in parallel from a single task.
+ * When the connection has completed pCallback is called and, if
+ * the socket has been registered with uSockPollSet(),
+ * #U_SOCK_POLL_EVENT_WRITE (success) or #U_SOCK_POLL_EVENT_ERROR
+ * (failure) is reported.  While the connection is in progress
+ * uSockConnect() on the same socket will fail with errno set to
+ * U_SOCK_EALREADY and reads/writes will fail.  If the connection
+ * fails the socket is returned to the state it was in before and
+ * so may be connected again.
+ *
+ * Where the underlying network is not able to connect
+ * asynchronously (Wi-Fi, and cellular modules other than
+ * SARA-R5, SARA-R422 and LARA-R6) this function behaves as
+ * uSockConnect(), blocking until the connection has completed,
+ * and, if it succeeds, calls pCallback before returning.
+ *
+ * The stack size of the task within which the callback is run is
+ * #U_AT_CLIENT_CALLBACK_TASK_STACK_SIZE_BYTES; the same
+ * IMPORTANT note as for uSockRegisterCallbackData() applies.
+ *
+ * @param descriptor         the descriptor of the socket.
+ * @param pRemoteAddress     the address of the server to
+ *                           connect to, possibly established
+ *                           via a call to uSockGetHostByName(),
+ *                           including port number.
+ * @param pCallback          the function to call when the
+ *                           connection has completed; the first
+ *                           parameter will be pCallbackParameter
+ *                           and the second U_SOCK_ENONE on success
+ *                           else a value from u_sock_errno.h.
+ *                           May be NULL, e.g. if uSockPollWait()
+ *                           is being used instead.  pCallback is
+ *                           only called if this function returns
+ *                           success.
+ * @param pCallbackParameter parameter to be passed to the
+ *                           pCallback function when it is
+ *                           called; may be NULL.
+ * @return                   zero if the connection has been
+ *                           started (or, where it cannot be done
+ *                           asynchronously, has been made), else
+ *                           negative error code (and errno will
+ *                           also be set to a value from
+ *                           u_sock_errno.h).
+ */
+int32_t uSockConnectAsync(uSockDescriptor_t descriptor,
+                          const uSockAddress_t *pRemoteAddress,
+                          void (*pCallback) (void *, int32_t),
+                          void *pCallbackParameter);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: POLL
+ * -------------------------------------------------------------- */
+
+/** Register interest in events on a socket, to be reported by
+ * uSockPollWait(); this is the alternative to uSockSelect() for
+ * a single task that serves many sockets: the interest is
+ * registered once and uSockPollWait() is woken directly by the
+ * data and closed events from the underlying cell/wifi socket
+ * layer, returning only the sockets that are ready, rather than
+ * scanning every socket on each wake-up.
+ *
+ * Events are edge-triggered: an event is reported once and is
+ * then not reported again until something new happens, e.g. more
+ * data arrives.  When #U_SOCK_POLL_EVENT_READ is reported the
+ * socket should be read, ideally non-blocking (see
+ * uSockBlockingSet()), until the read returns less than was asked
+ * for; a uSockRead() that fills the whole buffer, or any successful
+ * uSockReceiveFrom(), re-reports #U_SOCK_POLL_EVENT_READ since there
+ * may be more data waiting.
+ * #U_SOCK_POLL_EVENT_WRITE is reported when interest is first
+ * registered on a socket that can be written to, when a
+ * connection completes and after each successful write.  Since
+ * data may have arrived before interest was registered,
+ * #U_SOCK_POLL_EVENT_READ is also reported on registration, i.e.
+ * the first read may find nothing.  Closing a socket with
+ * uSockClose() removes any interest in it.
+ *
+ * Note that this uses the same data and closed indications
+ * from the underlying socket layer as uSockRegisterCallbackData()
+ * and uSockRegisterCallbackClosed(); it may be used alongside
+ * those callbacks.
+ *
+ * @param descriptor the descriptor of the socket.
+ * @param eventMask  a bitmap of the U_SOCK_POLL_EVENT_xxx events
+ *                   of interest, replacing any previous mask for
+ *                   this socket; use 0 to remove interest in the
+ *                   socket entirely, in which case any event not
+ *                   yet returned by uSockPollWait() for it is
+ *                   discarded.
+ * @return           zero on success else negative error code
+ *                   and errno is set.
+ */
+int32_t uSockPollSet(uSockDescriptor_t descriptor, uint32_t eventMask);
+
+/** Wait for one or more of the sockets registered with
+ * uSockPollSet() to become ready.  This is intended to be called
+ * by a single task; if more than one task waits at the same time
+ * an event will be returned to only one of them.
+ *
+ * @param[out] pEvents    a place to put the ready sockets and their
+ *                        events; cannot be NULL.
+ * @param maxNumEvents    the number of entries at pEvents; any
+ *                        further ready sockets are returned by the
+ *                        next call.
+ * @param timeMs          the time to wait in milliseconds for a
+ *                        socket to become ready; zero to
+ *                        return immediately, negative to wait
+ *                        forever.
+ * @return                the number of entries populated at
+ *                        pEvents, zero on timeout, else negative
+ *                        error code and errno is set.
+ */
+int32_t uSockPollWait(uSockPollEvent_t *pEvents, size_t maxNumEvents,
+                      int32_t timeMs);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: TCP INCOMING (TCP SERVER) ONLY
  * -------------------------------------------------------------- */
@@ -722,6 +1198,10 @@ int32_t uSockAccept(uSockDescriptor_t descriptor,
  *                              on any other error.  Use
  *                              #U_SOCK_FD_ISSET() to determine
  *                              which descriptor(s) were unblocked.
+ *                              NOTE: this is not currently
+ *                              implemented, please use
+ *                              uSockPollSet() and uSockPollWait()
+ *                              instead.
  */
 int32_t uSockSelect(int32_t maxDescriptor,
                     uSockDescriptorSet_t *pReadDescriptorSet,
@@ -738,6 +1218,18 @@ int32_t uSockSelect(int32_t maxDescriptor,
 
 int32_t uSockGetTotalBytesSent(uSockDescriptor_t descriptor);
 
+/** Get the statistics of a socket, e.g. to size buffers or to
+ * find where time is going in the field.
+ *
+ * @param descriptor   the descriptor of the socket.
+ * @param[out] pStats  a place to put the statistics; cannot
+ *                     be NULL.
+ * @return             zero on success else negative error code
+ *                     (and errno will also be set to a value
+ *                     from u_sock_errno.h).
+ */
+int32_t uSockStatsGet(uSockDescriptor_t descriptor, uSockStats_t *pStats);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: FINDING ADDRESSES
  * -------------------------------------------------------------- */
@@ -769,6 +1261,15 @@ int32_t uSockGetLocalAddress(uSockDescriptor_t descriptor,
  * straight away without any external action, hence this also
  * implements "get host by address".
  *
+ * The result of a look-up is cached (see
+ * #U_SOCK_DNS_CACHE_NUM_ENTRIES), so that looking up the same host
+ * name again on the same device within #U_SOCK_DNS_CACHE_TTL_SECONDS
+ * returns at once; the cache for a device is flushed when
+ * uNetworkInterfaceDown() is called or when a network status
+ * callback, set with uNetworkSetStatusCallback(), reports that the
+ * network has gone down.  Use uSockDnsCacheFlush() to flush it at
+ * any other time.
+ *
  * @param devHandle      the handle of the underlying network to
  *                       use for host name look-up.
  * @param pHostName      a string representing the host to search
@@ -784,6 +1285,17 @@ int32_t uSockGetLocalAddress(uSockDescriptor_t descriptor,
 int32_t uSockGetHostByName(uDeviceHandle_t devHandle, const char *pHostName,
                            uSockIpAddress_t *pHostIpAddress);
 
+/** Flush the DNS cache used by uSockGetHostByName(), e.g. because
+ * the network has changed.  This only takes a mutex, it does not
+ * call into the underlying cell/wifi layer, and so may be called
+ * from a network status callback.
+ *
+ * @param devHandle the handle of the device for which cached
+ *                  look-ups should be flushed; use NULL to
+ *                  flush the cached look-ups of all devices.
+ */
+void uSockDnsCacheFlush(uDeviceHandle_t devHandle);
+
 
 /* ----------------------------------------------------------------
  * FUNCTIONS: ADDRESS CONVERSION
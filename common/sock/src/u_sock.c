@@ -136,6 +136,21 @@
  * This function will only be called on a socket in state
  * U_SOCK_STATE_CREATED.
  *
+ * Connect to a server asynchronously (optional):
+ *
+ * int32_t uXxxSockConnectAsync(uDeviceHandle_t devHandle,
+ *                              int32_t sockHandle,
+ *                              const uSockAddress_t *pRemoteAddress,
+ *                              void (*pCallback) (uDeviceHandle_t,
+ *                                                 int32_t,
+ *                                                 int32_t));
+ *
+ * As uXxxSockConnect() but returns once the connection has been
+ * started, later calling pCallback with devHandle, sockHandle and
+ * U_SOCK_ENONE or the (non-negated) errno of the failure.  Should
+ * return -U_SOCK_ENOSYS if asynchronous connection is not possible,
+ * in which case uXxxSockConnect() is used instead.
+ *
  * Deinitialise (optional):
  *
  * void uXxxSockDeinit();
@@ -320,6 +335,7 @@
 #include "sys/time.h"      // mktime() and struct timeval in most cases
 
 #include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
 
 #include "u_error_common.h"
 
@@ -332,6 +348,11 @@
 #include "u_port.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"
+#include "u_port_event_queue.h"
+
+#include "u_mempool.h" // uMemPoolMalloc(), uMemPoolFree()
+#include "u_trace.h"
+#include "u_metrics.h"
 
 #include "u_sock.h"
 #include "u_sock_security.h"
@@ -356,6 +377,38 @@
 # define U_SOCK_NUM_STATIC_SOCKETS     7
 #endif
 
+#ifndef U_SOCK_INDEX_NUM_BUCKETS
+/** The number of buckets in each of the two indexes that are used
+ * to find a socket container quickly, one hashed on the socket
+ * descriptor and one on the socket handle of the underlying
+ * cell/wifi socket layer.  Since both are allocated sequentially,
+ * as long as there are no more than this many sockets open at
+ * once each will usually have a bucket to itself; beyond that
+ * a lookup will have a short chain to walk.
+ */
+# define U_SOCK_INDEX_NUM_BUCKETS      8
+#endif
+
+/** The bucket of an index that a non-negative descriptor or
+ * socket handle belongs in.
+ */
+#define U_SOCK_INDEX_BUCKET(x) ((x) % U_SOCK_INDEX_NUM_BUCKETS)
+
+#ifndef U_SOCK_COALESCE_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that flushes the coalescing buffers
+ * of sockets (see #U_SOCK_OPT_COALESCE) when their timeout expires;
+ * this task calls into the underlying cell/wifi socket layer.
+ */
+# define U_SOCK_COALESCE_TASK_STACK_SIZE_BYTES 2048
+#endif
+
+#ifndef U_SOCK_COALESCE_TASK_PRIORITY
+/** The priority of the task that flushes the coalescing buffers
+ * of sockets when their timeout expires.
+ */
+# define U_SOCK_COALESCE_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
 /** Increment a socket descriptor.
  */
 #define U_SOCK_INC_DESCRIPTOR(d)  (d)++;         \
@@ -372,6 +425,8 @@
 typedef enum {
     U_SOCK_STATE_CREATED,   /**< Freshly created, unsullied. */
     U_SOCK_STATE_CONNECTED, /**< TCP connected or UDP has an address. */
+    U_SOCK_STATE_CONNECTING, /**< An asynchronous connection is in
+                                  progress. */
     U_SOCK_STATE_SHUTDOWN_FOR_READ,  /**< Block all reads. */
     U_SOCK_STATE_SHUTDOWN_FOR_WRITE, /**< Block all writes. */
     U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE, /**< Block all reads and
@@ -383,6 +438,27 @@ typedef enum {
                                container may be re-used. */
 } uSockState_t;
 
+/** The statistics of a socket, from which uSockStatsGet()
+ * makes a uSockStats_t.
+ */
+typedef struct {
+    int32_t bytesReceived;
+    int32_t numReadsWouldBlock;
+    int32_t numDataCallbacks;
+    int32_t numWrites;
+    int64_t writeLatencyTotalMs;
+    int32_t writeLatencyMaxMs;
+    int32_t numReadLatencies;
+    int64_t readLatencyTotalMs;
+    int32_t readLatencyMaxMs;
+    int32_t dataAvailableTimeMs; /**< When data was first indicated
+                                      by the data callback since the
+                                      last read that returned data;
+                                      only valid if isDataAvailable
+                                      is true. */
+    bool isDataAvailable; // At end to optimise structure packing
+} uSockSocketStats_t;
+
 /** A socket.
  */
 typedef struct {
@@ -403,6 +479,30 @@ typedef struct {
     void *pDataCallbackParameter;
     void (*pClosedCallback) (void *);
     void *pClosedCallbackParameter;
+    void (*pConnectCallback) (void *, int32_t);
+    void *pConnectCallbackParameter;
+    uint32_t pollEventMask; /**< The U_SOCK_POLL_EVENT_xxx events
+                                 registered with uSockPollSet(),
+                                 zero if not registered. */
+    uint32_t pollEvents; /**< The events of interest that have
+                              happened but have not yet been
+                              returned by uSockPollWait(). */
+    char *pCoalesceBuffer; /**< The buffer that writes are coalesced
+                                into, NULL if #U_SOCK_OPT_COALESCE
+                                is not set. */
+    size_t coalesceBufferSize;
+    size_t coalesceLength; /**< The amount of data waiting in
+                                pCoalesceBuffer. */
+    int32_t coalesceTimeoutMs;
+    uPortTimerHandle_t coalesceTimerHandle; /**< Started when data
+                                                 is first put into
+                                                 an empty
+                                                 pCoalesceBuffer, NULL
+                                                 if coalesceTimeoutMs
+                                                 is zero. */
+    uSockSocketStats_t stats; /**< The fields written by the data
+                                   callback are protected by
+                                   gMutexPoll. */
     bool blocking; // At end to optimise structure packing
 } uSockSocket_t;
 
@@ -413,9 +513,36 @@ typedef struct uSockContainer_t {
     uSockDescriptor_t descriptor;
     uSockSocket_t socket;
     struct uSockContainer_t *pNext;
+    struct uSockContainer_t *pNextByDescriptor; /**< The next container in the
+                                                     same bucket of
+                                                     gpContainerIndexDescriptor. */
+    struct uSockContainer_t *pNextBySockHandle; /**< The next container in the
+                                                     same bucket of
+                                                     gpContainerIndexSockHandle. */
+    struct uSockContainer_t *pNextPollReady; /**< The next container in the
+                                                  poll ready list. */
+    bool isPollReady; /**< True if this container is in the
+                           poll ready list. */
     bool isStatic; // At end to optimise structure packing
 } uSockContainer_t;
 
+/** An entry in the DNS cache.
+ */
+typedef struct {
+    uDeviceHandle_t devHandle; /**< The device the look-up was
+                                    performed on, NULL if this entry
+                                    is not in use. */
+    char hostName[U_SOCK_DNS_CACHE_HOST_NAME_MAX_LENGTH_BYTES];
+    uSockIpAddress_t ipAddress; /**< The result of the look-up;
+                                     only valid if errnoLocal
+                                     is U_SOCK_ENONE. */
+    int32_t errnoLocal; /**< U_SOCK_ENONE if the look-up was
+                             successful, else the errno of the
+                             failed look-up. */
+    int32_t storedTimeMs; /**< When the entry was stored. */
+    int32_t usedTimeMs;   /**< When the entry was last used. */
+} uSockDnsCacheEntry_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -424,6 +551,28 @@ typedef struct uSockContainer_t {
  */
 static bool gInitialised = false;
 
+/** The upper limits of the bins of gMetricWriteMs.
+ */
+static const int32_t gMetricWriteMsBinLimit[] = {10, 100, 1000};
+
+/** The counts of the bins of gMetricWriteMs.
+ */
+static uint32_t gMetricWriteMsBinCount[(sizeof(gMetricWriteMsBinLimit) /
+                                        sizeof(gMetricWriteMsBinLimit[0])) + 1];
+
+/** Metric: bytes sent on all sockets.
+ */
+static uMetric_t gMetricBytesSent;
+
+/** Metric: bytes received on all sockets.
+ */
+static uMetric_t gMetricBytesReceived;
+
+/** Metric: the time taken by each write to the underlying
+ * socket layer.
+ */
+static uMetric_t gMetricWriteMs;
+
 /** Mutex to protect the container list.
  */
 static uPortMutexHandle_t gMutexContainer = NULL;
@@ -432,6 +581,35 @@ static uPortMutexHandle_t gMutexContainer = NULL;
  */
 static uPortMutexHandle_t gMutexCallbacks = NULL;
 
+/** Mutex to protect the poll ready list and the poll fields of
+ * the containers; this is separate from gMutexContainer since
+ * those fields are written from the data and closed callbacks.
+ */
+static uPortMutexHandle_t gMutexPoll = NULL;
+
+/** Semaphore that uSockPollWait() waits on, given when a
+ * container is added to the poll ready list.
+ */
+static uPortSemaphoreHandle_t gSemaphorePoll = NULL;
+
+/** Mutex to protect the DNS cache; this is separate from
+ * gMutexContainer so that the cache may be flushed from a
+ * network status callback.
+ */
+static uPortMutexHandle_t gMutexDnsCache = NULL;
+
+#if U_SOCK_DNS_CACHE_NUM_ENTRIES > 0
+/** The DNS cache.
+ */
+static uSockDnsCacheEntry_t gDnsCache[U_SOCK_DNS_CACHE_NUM_ENTRIES];
+#endif
+
+/** The handle of the event queue on which the coalescing buffer
+ * timers of the sockets ask for a flush, since a flush cannot be
+ * done in the timer callback itself; opened when first needed.
+ */
+static int32_t gEventQueueCoalesceHandle = -1;
+
 /** Root of the socket container list.
  */
 static uSockContainer_t *gpContainerListHead = NULL;
@@ -444,6 +622,28 @@ static uSockDescriptor_t gNextDescriptor = 0;
  */
 static uSockContainer_t gStaticContainers[U_SOCK_NUM_STATIC_SOCKETS];
 
+/** Index of the containers in the container list hashed on their
+ * descriptor; a container, in whatever state, is in here from
+ * when it is first given a descriptor until it is free()ed.
+ */
+static uSockContainer_t *gpContainerIndexDescriptor[U_SOCK_INDEX_NUM_BUCKETS] = {0};
+
+/** Index of the containers in the container list hashed on the
+ * socket handle of the underlying cell/wifi socket layer; only
+ * containers with a non-negative socket handle are in here.
+ */
+static uSockContainer_t *gpContainerIndexSockHandle[U_SOCK_INDEX_NUM_BUCKETS] = {0};
+
+/** The list of containers that have poll events waiting to be
+ * returned by uSockPollWait(), oldest first, linked through
+ * pNextPollReady.
+ */
+static uSockContainer_t *gpPollReadyListHead = NULL;
+
+/** The last entry in the poll ready list.
+ */
+static uSockContainer_t *gpPollReadyListTail = NULL;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
@@ -464,6 +664,15 @@ static int32_t init()
     if ((errorCode == 0) && (gMutexCallbacks == NULL)) {
         errorCode = uPortMutexCreate(&gMutexCallbacks);
     }
+    if ((errorCode == 0) && (gMutexPoll == NULL)) {
+        errorCode = uPortMutexCreate(&gMutexPoll);
+    }
+    if ((errorCode == 0) && (gSemaphorePoll == NULL)) {
+        errorCode = uPortSemaphoreCreate(&gSemaphorePoll, 0, 1);
+    }
+    if ((errorCode == 0) && (gMutexDnsCache == NULL)) {
+        errorCode = uPortMutexCreate(&gMutexDnsCache);
+    }
 
     if (errorCode == 0) {
         errnoLocal = U_SOCK_ENONE;
@@ -476,12 +685,21 @@ static int32_t init()
             }
 
             if (errnoLocal == U_SOCK_ENONE) {
+                // Any dynamic containers have been free()ed by now
+                // and the static ones are about to be made closed,
+                // so the indexes can start again empty
+                memset(gpContainerIndexDescriptor, 0, sizeof(gpContainerIndexDescriptor));
+                memset(gpContainerIndexSockHandle, 0, sizeof(gpContainerIndexSockHandle));
+                gpPollReadyListHead = NULL;
+                gpPollReadyListTail = NULL;
                 //  Link the static containers into the start of the container list
                 for (size_t x = 0; x < sizeof(gStaticContainers) /
                      sizeof(gStaticContainers[0]); x++) {
                     *ppContainer = &gStaticContainers[x];
                     (*ppContainer)->isStatic = true;
                     (*ppContainer)->socket.state = U_SOCK_STATE_CLOSED;
+                    (*ppContainer)->pNextPollReady = NULL;
+                    (*ppContainer)->isPollReady = false;
                     (*ppContainer)->pNext = NULL;
                     if (ppPreviousNext != NULL) {
                         *ppPreviousNext = *ppContainer;
@@ -492,6 +710,20 @@ static int32_t init()
                     ppContainer = &((*ppContainer)->pNext);
                 }
 
+                // Register the metrics the first time only,
+                // after that they just keep counting
+                if (pUMetricsName(&gMetricBytesSent) == NULL) {
+                    uMetricsCounterInit(&gMetricBytesSent, "sock.bytes_sent");
+                    uMetricsCounterInit(&gMetricBytesReceived, "sock.bytes_received");
+                    uMetricsHistogramInit(&gMetricWriteMs, "sock.write_ms",
+                                          gMetricWriteMsBinLimit, gMetricWriteMsBinCount,
+                                          sizeof(gMetricWriteMsBinCount) /
+                                          sizeof(gMetricWriteMsBinCount[0]));
+                }
+                uMetricsRegister(&gMetricBytesSent);
+                uMetricsRegister(&gMetricBytesReceived);
+                uMetricsRegister(&gMetricWriteMs);
+
                 gInitialised = true;
             }
         }
@@ -511,29 +743,420 @@ static void deinitButNotMutex()
         uCellSockDeinit();
         uWifiSockDeinit();
 
+        // The device handles in the DNS cache may not
+        // survive this
+        uSockDnsCacheFlush(NULL);
+
         gInitialised = false;
     }
 }
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: POLL
+ * -------------------------------------------------------------- */
+
+// Remove a container from the poll ready list, if it is there,
+// discarding any events it has waiting.
+// This does NOT lock gMutexPoll, you need to do that.
+static void pollReadyRemove(uSockContainer_t *pContainer)
+{
+    uSockContainer_t **ppThis = &gpPollReadyListHead;
+    uSockContainer_t *pPrevious = NULL;
+
+    if (pContainer->isPollReady) {
+        while ((*ppThis != NULL) && (*ppThis != pContainer)) {
+            pPrevious = *ppThis;
+            ppThis = &((*ppThis)->pNextPollReady);
+        }
+        if (*ppThis != NULL) {
+            *ppThis = pContainer->pNextPollReady;
+            if (gpPollReadyListTail == pContainer) {
+                gpPollReadyListTail = pPrevious;
+            }
+        }
+        pContainer->pNextPollReady = NULL;
+        pContainer->isPollReady = false;
+    }
+    pContainer->socket.pollEvents = 0;
+}
+
+// Record that the given U_SOCK_POLL_EVENT_xxx events have
+// happened on a socket and, if any are of interest, add its
+// container to the end of the poll ready list and wake up
+// uSockPollWait().  Does nothing if the socket has not been
+// registered with uSockPollSet().
+// This locks gMutexPoll but does not need gMutexContainer, hence
+// it may be called from the data and closed callbacks.
+static void pollEventsAdd(uSockContainer_t *pContainer, uint32_t events)
+{
+    U_PORT_MUTEX_LOCK(gMutexPoll);
+
+    if (pContainer->socket.pollEventMask != 0) {
+        // Closure and failure are always of interest
+        events &= pContainer->socket.pollEventMask | U_SOCK_POLL_EVENT_CLOSED |
+                  U_SOCK_POLL_EVENT_ERROR;
+        pContainer->socket.pollEvents |= events;
+        if ((pContainer->socket.pollEvents != 0) && !pContainer->isPollReady) {
+            pContainer->pNextPollReady = NULL;
+            if (gpPollReadyListTail != NULL) {
+                gpPollReadyListTail->pNextPollReady = pContainer;
+            } else {
+                gpPollReadyListHead = pContainer;
+            }
+            gpPollReadyListTail = pContainer;
+            pContainer->isPollReady = true;
+            uPortSemaphoreGive(gSemaphorePoll);
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(gMutexPoll);
+}
+
+// Work out the U_SOCK_POLL_EVENT_xxx events that a socket
+// could satisfy in its current state.
+static uint32_t pollEventsFromState(const uSockSocket_t *pSocket)
+{
+    uint32_t events = 0;
+
+    switch (pSocket->state) {
+        case U_SOCK_STATE_CREATED:
+            // A UDP socket doesn't need to be connected
+            if (pSocket->protocol == U_SOCK_PROTOCOL_UDP) {
+                events = U_SOCK_POLL_EVENT_READ | U_SOCK_POLL_EVENT_WRITE;
+            }
+            break;
+        case U_SOCK_STATE_CONNECTED:
+            events = U_SOCK_POLL_EVENT_READ | U_SOCK_POLL_EVENT_WRITE;
+            break;
+        case U_SOCK_STATE_SHUTDOWN_FOR_READ:
+            events = U_SOCK_POLL_EVENT_WRITE;
+            break;
+        case U_SOCK_STATE_SHUTDOWN_FOR_WRITE:
+            events = U_SOCK_POLL_EVENT_READ;
+            break;
+        case U_SOCK_STATE_CLOSED:
+            events = U_SOCK_POLL_EVENT_CLOSED;
+            break;
+        default:
+            break;
+    }
+
+    return events;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: STATISTICS
+ * -------------------------------------------------------------- */
+
+// Add a successful write of size bytes to the underlying socket
+// layer, which started at startTimeMs, to the statistics of a socket
+// and to the socket metrics.
+// This does NOT lock the mutex, you need to do that.
+static void statsWriteAdd(uSockSocket_t *pSocket, int32_t startTimeMs,
+                          int32_t size)
+{
+    int32_t latencyMs = uPortGetTickTimeMs() - startTimeMs;
+
+    uMetricsCounterAdd(&gMetricBytesSent, (uint32_t) size);
+    uMetricsHistogramAdd(&gMetricWriteMs, latencyMs);
+
+    pSocket->stats.numWrites++;
+    pSocket->stats.writeLatencyTotalMs += latencyMs;
+    if (latencyMs > pSocket->stats.writeLatencyMaxMs) {
+        pSocket->stats.writeLatencyMaxMs = latencyMs;
+    }
+}
+
+// Add the outcome of a read/receive, the number of bytes received
+// or a negated errno, to the statistics of a socket.
+// This locks gMutexPoll, since the data callback writes to the
+// data-available fields, but does NOT lock gMutexContainer, you
+// need to do that.
+static void statsReadAdd(uSockSocket_t *pSocket, int32_t negErrnoOrSize)
+{
+    int32_t latencyMs;
+
+    if (negErrnoOrSize > 0) {
+        pSocket->stats.bytesReceived += negErrnoOrSize;
+        uMetricsCounterAdd(&gMetricBytesReceived, (uint32_t) negErrnoOrSize);
+        U_PORT_MUTEX_LOCK(gMutexPoll);
+        if (pSocket->stats.isDataAvailable) {
+            latencyMs = uPortGetTickTimeMs() - pSocket->stats.dataAvailableTimeMs;
+            pSocket->stats.numReadLatencies++;
+            pSocket->stats.readLatencyTotalMs += latencyMs;
+            if (latencyMs > pSocket->stats.readLatencyMaxMs) {
+                pSocket->stats.readLatencyMaxMs = latencyMs;
+            }
+            pSocket->stats.isDataAvailable = false;
+        }
+        U_PORT_MUTEX_UNLOCK(gMutexPoll);
+    } else if (negErrnoOrSize == -U_SOCK_EWOULDBLOCK) {
+        pSocket->stats.numReadsWouldBlock++;
+    }
+}
+
+// Add an indication from the underlying socket layer that data
+// has arrived to the statistics of a socket.
+// This locks gMutexPoll but does not need gMutexContainer, hence
+// it may be called from the data callback.
+static void statsDataCallbackAdd(uSockSocket_t *pSocket)
+{
+    U_PORT_MUTEX_LOCK(gMutexPoll);
+    pSocket->stats.numDataCallbacks++;
+    if (!pSocket->stats.isDataAvailable) {
+        // Time from the first indication, further ones
+        // before a read are for the same wait
+        pSocket->stats.dataAvailableTimeMs = uPortGetTickTimeMs();
+        pSocket->stats.isDataAvailable = true;
+    }
+    U_PORT_MUTEX_UNLOCK(gMutexPoll);
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: WRITE COALESCING
+ * -------------------------------------------------------------- */
+
+// Send data, gathered from an I/O vector, to the underlying
+// cell/wifi socket layer; returns the number of bytes sent
+// or a negated value of errno from the U_SOCK_Exxx list.
+static int32_t underlyingWritev(uSockSocket_t *pSocket,
+                                const uSockIoVec_t *pIoVec,
+                                size_t numIoVec)
+{
+    int32_t errorCodeOrSize = -U_SOCK_ENOSYS;
+    int32_t devType = uDeviceGetDeviceType(pSocket->devHandle);
+    int32_t startTimeMs = uPortGetTickTimeMs();
+
+    // uXxxSockWritev() returns the number of bytes sent or
+    // a negated value of errno from the U_SOCK_Exxx list.
+    if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+        errorCodeOrSize = uCellSockWritev(pSocket->devHandle,
+                                          pSocket->sockHandle,
+                                          pIoVec, numIoVec);
+    } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+        errorCodeOrSize = uWifiSockWritev(pSocket->devHandle,
+                                          pSocket->sockHandle,
+                                          pIoVec, numIoVec);
+    }
+    if (errorCodeOrSize > 0) {
+        pSocket->bytesSent += errorCodeOrSize;
+        statsWriteAdd(pSocket, startTimeMs, errorCodeOrSize);
+    }
+
+    return errorCodeOrSize;
+}
+
+// Free the coalescing buffer and timer of a socket, throwing
+// away anything that is in the buffer.
+static void coalesceFree(uSockSocket_t *pSocket)
+{
+    if (pSocket->coalesceTimerHandle != NULL) {
+        uPortTimerDelete(pSocket->coalesceTimerHandle);
+        pSocket->coalesceTimerHandle = NULL;
+    }
+    free(pSocket->pCoalesceBuffer);
+    pSocket->pCoalesceBuffer = NULL;
+    pSocket->coalesceBufferSize = 0;
+    pSocket->coalesceLength = 0;
+    pSocket->coalesceTimeoutMs = 0;
+}
+
+// Send whatever is in the coalescing buffer of a socket, returning
+// U_SOCK_ENONE or the errno of the failure; anything that could
+// not be sent is left in the buffer, with the timer restarted.
+// This does NOT lock the mutex, you need to do that.
+static int32_t coalesceFlush(uSockSocket_t *pSocket)
+{
+    int32_t errnoLocal = U_SOCK_ENONE;
+    int32_t errorCodeOrSize;
+    uSockIoVec_t ioVec;
+
+    if (pSocket->coalesceTimerHandle != NULL) {
+        uPortTimerStop(pSocket->coalesceTimerHandle);
+    }
+    while ((pSocket->coalesceLength > 0) && (errnoLocal == U_SOCK_ENONE)) {
+        ioVec.pBase = pSocket->pCoalesceBuffer;
+        ioVec.length = pSocket->coalesceLength;
+        errorCodeOrSize = underlyingWritev(pSocket, &ioVec, 1);
+        if (errorCodeOrSize > 0) {
+            // Move anything that didn't go to the front
+            pSocket->coalesceLength -= errorCodeOrSize;
+            memmove(pSocket->pCoalesceBuffer,
+                    pSocket->pCoalesceBuffer + errorCodeOrSize,
+                    pSocket->coalesceLength);
+        } else if (errorCodeOrSize < 0) {
+            errnoLocal = -errorCodeOrSize;
+        } else {
+            // Nothing went, don't spin
+            errnoLocal = U_SOCK_EWOULDBLOCK;
+        }
+    }
+    if ((pSocket->coalesceLength > 0) &&
+        (pSocket->coalesceTimerHandle != NULL)) {
+        uPortTimerStart(pSocket->coalesceTimerHandle);
+    }
+
+    return errnoLocal;
+}
+
+// Write data, gathered from an I/O vector, to a socket that has a
+// coalescing buffer: the data is copied into the buffer, which is
+// flushed each time it fills up, except that data which would fill
+// an empty buffer anyway is sent straight to the underlying socket
+// layer.  Returns the number of bytes taken, which will only be
+// fewer than dataSizeBytes if a flush failed, or a negated value
+// of errno from the U_SOCK_Exxx list if none were taken.
+// This does NOT lock the mutex, you need to do that.
+static int32_t coalesceWritev(uSockSocket_t *pSocket,
+                              const uSockIoVec_t *pIoVec,
+                              size_t numIoVec, int32_t dataSizeBytes)
+{
+    int32_t errnoLocal = U_SOCK_ENONE;
+    int32_t errorCodeOrSize = 0;
+    int32_t sentSize;
+    size_t offset = 0;
+    size_t thisSize;
+
+    while ((numIoVec > 0) && (errnoLocal == U_SOCK_ENONE)) {
+        if ((pSocket->coalesceLength == 0) && (offset == 0) &&
+            ((size_t) (dataSizeBytes - errorCodeOrSize) >= pSocket->coalesceBufferSize)) {
+            // Nothing is waiting and the rest of the data is at
+            // least a buffer's worth: no point in copying it
+            sentSize = underlyingWritev(pSocket, pIoVec, numIoVec);
+            if (sentSize >= 0) {
+                errorCodeOrSize += sentSize;
+            } else {
+                errnoLocal = -sentSize;
+            }
+            numIoVec = 0;
+        } else {
+            thisSize = pSocket->coalesceBufferSize - pSocket->coalesceLength;
+            if (thisSize > pIoVec->length - offset) {
+                thisSize = pIoVec->length - offset;
+            }
+            if ((pSocket->coalesceLength == 0) && (thisSize > 0) &&
+                (pSocket->coalesceTimerHandle != NULL)) {
+                // Start the clock on the oldest data in the buffer
+                uPortTimerStart(pSocket->coalesceTimerHandle);
+            }
+            memcpy(pSocket->pCoalesceBuffer + pSocket->coalesceLength,
+                   ((const char *) pIoVec->pBase) + offset, thisSize);
+            pSocket->coalesceLength += thisSize;
+            errorCodeOrSize += (int32_t) thisSize;
+            offset += thisSize;
+            if (offset >= pIoVec->length) {
+                // Move on to the next fragment
+                pIoVec++;
+                numIoVec--;
+                offset = 0;
+            }
+            if (pSocket->coalesceLength >= pSocket->coalesceBufferSize) {
+                errnoLocal = coalesceFlush(pSocket);
+            }
+        }
+    }
+
+    if ((errorCodeOrSize == 0) && (errnoLocal != U_SOCK_ENONE)) {
+        errorCodeOrSize = -errnoLocal;
+    }
+
+    return errorCodeOrSize;
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: CONTAINER STUFF
  * -------------------------------------------------------------- */
 
+// Remove a container from the bucket of the descriptor index
+// it is in, if it is in one.
+// This does NOT lock the mutex, you need to do that.
+static void indexDescriptorRemove(uSockContainer_t *pContainer)
+{
+    uSockContainer_t **ppThis;
+
+    if (pContainer->descriptor >= 0) {
+        ppThis = &(gpContainerIndexDescriptor[U_SOCK_INDEX_BUCKET(pContainer->descriptor)]);
+        while ((*ppThis != NULL) && (*ppThis != pContainer)) {
+            ppThis = &((*ppThis)->pNextByDescriptor);
+        }
+        if (*ppThis != NULL) {
+            *ppThis = pContainer->pNextByDescriptor;
+        }
+    }
+    pContainer->pNextByDescriptor = NULL;
+}
+
+// Add a container to the descriptor index.
+// This does NOT lock the mutex, you need to do that.
+static void indexDescriptorAdd(uSockContainer_t *pContainer)
+{
+    uSockContainer_t **ppBucket;
+
+    if (pContainer->descriptor >= 0) {
+        ppBucket = &(gpContainerIndexDescriptor[U_SOCK_INDEX_BUCKET(pContainer->descriptor)]);
+        pContainer->pNextByDescriptor = *ppBucket;
+        *ppBucket = pContainer;
+    }
+}
+
+// Remove a container from the bucket of the socket handle index
+// it is in, if it is in one.
+// This does NOT lock the mutex, you need to do that.
+static void indexSockHandleRemove(uSockContainer_t *pContainer)
+{
+    uSockContainer_t **ppThis;
+
+    if (pContainer->socket.sockHandle >= 0) {
+        ppThis = &(gpContainerIndexSockHandle[U_SOCK_INDEX_BUCKET(pContainer->socket.sockHandle)]);
+        while ((*ppThis != NULL) && (*ppThis != pContainer)) {
+            ppThis = &((*ppThis)->pNextBySockHandle);
+        }
+        if (*ppThis != NULL) {
+            *ppThis = pContainer->pNextBySockHandle;
+        }
+    }
+    pContainer->pNextBySockHandle = NULL;
+}
+
+// Add a container to the socket handle index.
+// This does NOT lock the mutex, you need to do that.
+static void indexSockHandleAdd(uSockContainer_t *pContainer)
+{
+    uSockContainer_t **ppBucket;
+
+    if (pContainer->socket.sockHandle >= 0) {
+        ppBucket = &(gpContainerIndexSockHandle[U_SOCK_INDEX_BUCKET(pContainer->socket.sockHandle)]);
+        pContainer->pNextBySockHandle = *ppBucket;
+        *ppBucket = pContainer;
+    }
+}
+
+// Remove a container from both indexes, e.g. before it is free()ed.
+// This does NOT lock the mutex, you need to do that.
+static void indexRemove(uSockContainer_t *pContainer)
+{
+    indexDescriptorRemove(pContainer);
+    indexSockHandleRemove(pContainer);
+}
+
 // Find the socket container for the given descriptor.
 // Will not find sockets in state CLOSED.
 // This does NOT lock the mutex, you need to do that.
 static uSockContainer_t *pContainerFindByDescriptor(uSockDescriptor_t descriptor)
 {
     uSockContainer_t *pContainer = NULL;
-    uSockContainer_t *pContainerThis = gpContainerListHead;
+    uSockContainer_t *pContainerThis = NULL;
 
+    if (descriptor >= 0) {
+        pContainerThis = gpContainerIndexDescriptor[U_SOCK_INDEX_BUCKET(descriptor)];
+    }
     while ((pContainerThis != NULL) &&
            (pContainer == NULL)) {
         if ((pContainerThis->descriptor == descriptor) &&
             (pContainerThis->socket.state != U_SOCK_STATE_CLOSED)) {
             pContainer = pContainerThis;
         }
-        pContainerThis = pContainerThis->pNext;
+        pContainerThis = pContainerThis->pNextByDescriptor;
     }
 
     return pContainer;
@@ -548,17 +1171,36 @@ static uSockContainer_t *pContainerFindByDeviceHandle(uDeviceHandle_t devHandle,
                                                       int32_t sockHandle)
 {
     uSockContainer_t *pContainer = NULL;
-    uSockContainer_t *pContainerThis = gpContainerListHead;
-
-    while ((pContainerThis != NULL) &&
-           (pContainer == NULL)) {
-        if ((pContainerThis->socket.devHandle == devHandle) &&
-            ((pContainerThis->socket.sockHandle == sockHandle) ||
-             (pContainerThis->socket.sockHandle < 0)) &&
-            (pContainerThis->socket.state != U_SOCK_STATE_CLOSED)) {
-            pContainer = pContainerThis;
+    uSockContainer_t *pContainerThis;
+
+    if (sockHandle >= 0) {
+        // This is the frequent case, e.g. from dataCallback(), so
+        // use the index.  A container with a negative socket handle
+        // never has a device handle (the two are set together
+        // in uSockCreate()) hence cannot match here and need not
+        // be looked for
+        pContainerThis = gpContainerIndexSockHandle[U_SOCK_INDEX_BUCKET(sockHandle)];
+        while ((pContainerThis != NULL) &&
+               (pContainer == NULL)) {
+            if ((pContainerThis->socket.devHandle == devHandle) &&
+                (pContainerThis->socket.sockHandle == sockHandle) &&
+                (pContainerThis->socket.state != U_SOCK_STATE_CLOSED)) {
+                pContainer = pContainerThis;
+            }
+            pContainerThis = pContainerThis->pNextBySockHandle;
+        }
+    } else {
+        pContainerThis = gpContainerListHead;
+        while ((pContainerThis != NULL) &&
+               (pContainer == NULL)) {
+            if ((pContainerThis->socket.devHandle == devHandle) &&
+                ((pContainerThis->socket.sockHandle == sockHandle) ||
+                 (pContainerThis->socket.sockHandle < 0)) &&
+                (pContainerThis->socket.state != U_SOCK_STATE_CLOSED)) {
+                pContainer = pContainerThis;
+            }
+            pContainerThis = pContainerThis->pNext;
         }
-        pContainerThis = pContainerThis->pNext;
     }
 
     return pContainer;
@@ -605,18 +1247,39 @@ static uSockContainer_t *pSockContainerCreate(uSockDescriptor_t descriptor,
         // Reached the end of the list and found no re-usable
         // containers, so allocate memory for the new container
         // and add it to the list
-        pContainer = (uSockContainer_t *) malloc(sizeof (*pContainer));
+        pContainer = (uSockContainer_t *) uMemPoolMalloc(sizeof (*pContainer));
         if (pContainer != NULL) {
             pContainer->isStatic = false;
             pContainer->pPrevious = pContainerPrevious;
             pContainer->pNext = NULL;
+            // Not yet in either index
+            pContainer->descriptor = -1;
+            pContainer->socket.sockHandle = -1;
+            pContainer->pNextByDescriptor = NULL;
+            pContainer->pNextBySockHandle = NULL;
+            pContainer->pNextPollReady = NULL;
+            pContainer->isPollReady = false;
+            pContainer->socket.pCoalesceBuffer = NULL;
+            pContainer->socket.coalesceTimerHandle = NULL;
             *ppContainerThis = pContainer;
         }
     }
 
     // Set up the new container and socket
     if (pContainer != NULL) {
+        // Take a re-used container out of the indexes
+        // under its old descriptor and socket handle
+        indexRemove(pContainer);
         pContainer->descriptor = descriptor;
+        indexDescriptorAdd(pContainer);
+        // Nothing that happened to a previous socket
+        // in this container should be reported
+        U_PORT_MUTEX_LOCK(gMutexPoll);
+        pollReadyRemove(pContainer);
+        U_PORT_MUTEX_UNLOCK(gMutexPoll);
+        // A socket closed by the far end may still
+        // have a coalescing buffer
+        coalesceFree(&(pContainer->socket));
         memset(&(pContainer->socket), 0, sizeof(pContainer->socket));
         pContainer->socket.type = type;
         pContainer->socket.protocol = protocol;
@@ -630,6 +1293,8 @@ static uSockContainer_t *pSockContainerCreate(uSockDescriptor_t descriptor,
         pContainer->socket.pDataCallbackParameter = NULL;
         pContainer->socket.pClosedCallback = NULL;
         pContainer->socket.pClosedCallbackParameter = NULL;
+        pContainer->socket.pConnectCallback = NULL;
+        pContainer->socket.pConnectCallbackParameter = NULL;
     }
 
     return pContainer;
@@ -655,6 +1320,10 @@ static bool containerFree(uSockDescriptor_t descriptor)
 
     if ((ppContainer != NULL) && (*ppContainer != NULL)) {
         if (!(*ppContainer)->isStatic) {
+            indexRemove(*ppContainer);
+            U_PORT_MUTEX_LOCK(gMutexPoll);
+            pollReadyRemove(*ppContainer);
+            U_PORT_MUTEX_UNLOCK(gMutexPoll);
             // If we found it, and it wasn't static, free it
             // If there is a previous container, move its pNext
             if ((*ppContainer)->pPrevious != NULL) {
@@ -666,6 +1335,7 @@ static bool containerFree(uSockDescriptor_t descriptor)
             }
 
             // Free the memory and NULL the pointer
+            coalesceFree(&((*ppContainer)->socket));
             free(*ppContainer);
             *ppContainer = NULL;
         } else {
@@ -708,6 +1378,7 @@ static void closedCallback(uDeviceHandle_t devHandle,
         uSecurityTlsRemove(pContainer->socket.pSecurityContext);
         pContainer->socket.pSecurityContext = NULL;
         U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+        pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_CLOSED);
     }
 }
 
@@ -724,12 +1395,100 @@ static void dataCallback(uDeviceHandle_t devHandle,
     pContainer = pContainerFindByDeviceHandle(devHandle,
                                               sockHandle);
     if (pContainer != NULL) {
+        statsDataCallbackAdd(&(pContainer->socket));
         U_PORT_MUTEX_LOCK(gMutexCallbacks);
         if (pContainer->socket.pDataCallback != NULL) {
             pContainer->socket.pDataCallback(pContainer->socket.pDataCallbackParameter);
         }
         U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+        pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_READ);
+    }
+}
+
+// Callback for when an asynchronous connection at the underlying
+// cell/wifi socket layer has completed, errnoLocal being
+// U_SOCK_ENONE on success.
+static void connectCallback(uDeviceHandle_t devHandle,
+                            int32_t sockHandle,
+                            int32_t errnoLocal)
+{
+    uSockContainer_t *pContainer;
+    uint32_t pollEvent = U_SOCK_POLL_EVENT_WRITE;
+
+    // Don't lock the container mutex here, for the same
+    // reasons as dataCallback()
+    pContainer = pContainerFindByDeviceHandle(devHandle,
+                                              sockHandle);
+    if ((pContainer != NULL) &&
+        (pContainer->socket.state == U_SOCK_STATE_CONNECTING)) {
+        if (errnoLocal == U_SOCK_ENONE) {
+            pContainer->socket.state = U_SOCK_STATE_CONNECTED;
+            uPortLog("U_SOCK: socket with descriptor %d is connected.\n",
+                     pContainer->descriptor);
+        } else {
+            // Back to where we were so that the connection
+            // may be tried again
+            pContainer->socket.state = U_SOCK_STATE_CREATED;
+            memset(&(pContainer->socket.remoteAddress), 0,
+                   sizeof(pContainer->socket.remoteAddress));
+            uPortLog("U_SOCK: asynchronous connection of socket with"
+                     " descriptor %d failed, errno %d.\n",
+                     pContainer->descriptor, errnoLocal);
+            pollEvent = U_SOCK_POLL_EVENT_ERROR;
+        }
+        U_PORT_MUTEX_LOCK(gMutexCallbacks);
+        if (pContainer->socket.pConnectCallback != NULL) {
+            pContainer->socket.pConnectCallback(pContainer->socket.pConnectCallbackParameter,
+                                                errnoLocal);
+            pContainer->socket.pConnectCallback = NULL;
+        }
+        U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+        pollEventsAdd(pContainer, pollEvent);
+    }
+}
+
+// Callback for when the coalescing buffer timer of a socket
+// expires: the flush blocks on the underlying socket layer so
+// it can't be done here, instead it is passed to the coalescing
+// flush task.
+static void coalesceTimerCallback(const uPortTimerHandle_t timerHandle,
+                                  void *pParameter)
+{
+    uSockDescriptor_t descriptor = (uSockDescriptor_t) (intptr_t) pParameter;
+
+    (void) timerHandle;
+
+    // There is only ever one timer per socket, and it is not
+    // restarted until its flush has been done, so the queue,
+    // which has room for one event per socket, will not block
+    uPortEventQueueSend(gEventQueueCoalesceHandle, &descriptor,
+                        sizeof(descriptor));
+}
+
+// Event handler of the coalescing flush task.
+static void coalesceEventHandler(void *pParameter, size_t parameterLength)
+{
+    uSockDescriptor_t descriptor = *((uSockDescriptor_t *) pParameter);
+    uSockContainer_t *pContainer;
+
+    (void) parameterLength;
+
+    U_PORT_MUTEX_LOCK(gMutexContainer);
+
+    // The socket may have been flushed, or gone, since
+    // the timer expired
+    pContainer = pContainerFindByDescriptor(descriptor);
+    if ((pContainer != NULL) &&
+        (pContainer->socket.state == U_SOCK_STATE_CONNECTED) &&
+        (pContainer->socket.coalesceLength > 0)) {
+        if (coalesceFlush(&(pContainer->socket)) != U_SOCK_ENONE) {
+            // The failure will be returned by the next write
+            // or flush, let anyone polling know it is there
+            pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_ERROR);
+        }
     }
+
+    U_PORT_MUTEX_UNLOCK(gMutexContainer);
 }
 
 /* ----------------------------------------------------------------
@@ -1056,7 +1815,8 @@ static void printSocketOption(const void *pOptionValue,
 // Receive data on a socket, either UDP or TCP.
 static int32_t receive(const uSockContainer_t *pContainer,
                        uSockAddress_t *pRemoteAddress,
-                       void *pData, size_t dataSizeBytes)
+                       void *pData, size_t dataSizeBytes,
+                       bool blocking)
 {
     uDeviceHandle_t devHandle = pContainer->socket.devHandle;
     int32_t sockHandle = pContainer->socket.sockHandle;
@@ -1065,7 +1825,8 @@ static int32_t receive(const uSockContainer_t *pContainer,
     int32_t devType = uDeviceGetDeviceType(devHandle);
 
     // Run around the loop until a packet of data turns up
-    // or we time out or just once if we're non-blocking.
+    // or we time out or just once if we're non-blocking
+    // (or have been asked to behave as if we are).
     do {
         if (pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) {
             // UDP style
@@ -1096,12 +1857,14 @@ static int32_t receive(const uSockContainer_t *pContainer,
                                                dataSizeBytes);
             }
         }
-        if (negErrnoOrSize < 0) {
-            // Yield for the poll interval
+        if ((negErrnoOrSize < 0) &&
+            (blocking || !pContainer->socket.blocking)) {
+            // Yield for the poll interval, except when a blocking
+            // socket is being asked just once, for the follow-on
+            // fragments of readIoVec(), where there is no need
             uPortTaskBlock(U_SOCK_RECEIVE_POLL_INTERVAL_MS);
         }
-    } while ((negErrnoOrSize < 0) &&
-             (pContainer->socket.blocking) &&
+    } while ((negErrnoOrSize < 0) && blocking &&
              (uPortGetTickTimeMs() - startTimeMs <
               pContainer->socket.receiveTimeoutMs));
 
@@ -1109,35 +1872,681 @@ static int32_t receive(const uSockContainer_t *pContainer,
 }
 
 /* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS: CREATE/OPEN/CLOSE/CLEAN-UP
+ * STATIC FUNCTIONS: SEND/RECEIVE
  * -------------------------------------------------------------- */
 
-// Create a socket.
-int32_t uSockCreate(uDeviceHandle_t devHandle, uSockType_t type,
-                    uSockProtocol_t protocol)
+// Determine if a socket is a UDP socket.
+static bool isUdp(uSockDescriptor_t descriptor)
 {
-    int32_t descriptorOrError = (int32_t) U_ERROR_COMMON_SUCCESS;
-    int32_t errnoLocal;
-    uSockContainer_t *pContainer = NULL;
-    uSockDescriptor_t descriptor = gNextDescriptor;
-    int32_t sockHandle = -U_SOCK_ENOSYS;
+    bool udp = false;
+    uSockContainer_t *pContainer;
 
-    errnoLocal = init();
-    if (errnoLocal == U_SOCK_ENONE) {
-        // Check parameters
-        errnoLocal = U_SOCK_ENODEV;
-        if (uDeviceIsValidInstance(U_DEVICE_INSTANCE(devHandle))) {
-            errnoLocal = U_SOCK_EPROTONOSUPPORT;
-            if (((type == U_SOCK_TYPE_STREAM) && (protocol == U_SOCK_PROTOCOL_TCP)) ||
-                ((type == U_SOCK_TYPE_DGRAM) && (protocol == U_SOCK_PROTOCOL_UDP))) {
-                errnoLocal = U_SOCK_ENONE;
-            }
+    if (init() == U_SOCK_ENONE) {
+
+        U_PORT_MUTEX_LOCK(gMutexContainer);
+
+        pContainer = pContainerFindByDescriptor(descriptor);
+        if (pContainer != NULL) {
+            udp = (pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP);
         }
-    }
 
-    if (errnoLocal == U_SOCK_ENONE) {
+        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+    }
 
-        U_PORT_MUTEX_LOCK(gMutexContainer);
+    return udp;
+}
+
+// Send a datagram, gathered from an I/O vector, to the given host.
+static int32_t sendToIoVec(uSockDescriptor_t descriptor,
+                           const uSockAddress_t *pRemoteAddress,
+                           const uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errnoLocal;
+    int32_t dataSizeBytes = uSockIoVecLength(pIoVec, numIoVec);
+    uSockContainer_t *pContainer = NULL;
+    uDeviceHandle_t devHandle;
+    int32_t sockHandle;
+    int32_t startTimeMs;
+
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+
+        U_PORT_MUTEX_LOCK(gMutexContainer);
+
+        // Find the container
+        errnoLocal = U_SOCK_EBADF;
+        pContainer = pContainerFindByDescriptor(descriptor);
+        if (pContainer != NULL) {
+            // Check address and state
+            if (pRemoteAddress != NULL) {
+                errnoLocal = U_SOCK_ENONE;
+            } else {
+                // If there is no remote address and the socket was
+                // connected we must use the stored address
+                if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
+                    pRemoteAddress = &(pContainer->socket.remoteAddress);
+                    errnoLocal = U_SOCK_ENONE;
+                } else {
+                    if ((pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_WRITE) ||
+                        (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
+                        // Socket is shut down
+                        errnoLocal = U_SOCK_ESHUTDOWN;
+                    } else if (pContainer->socket.state == U_SOCK_STATE_CLOSING) {
+                        // I know connection isn't strictly relevant
+                        // to UDP transmission but I can't see anything
+                        // more appropriate to return
+                        errnoLocal = U_SOCK_ENOTCONN;
+                    } else {
+                        // Destination address required?
+                        errnoLocal = U_SOCK_EDESTADDRREQ;
+                    }
+                }
+            }
+            if ((errnoLocal == U_SOCK_ENONE) && (pRemoteAddress != NULL)) {
+                errnoLocal = U_SOCK_EPROTOTYPE;
+                // It is OK to send UDP packets on a TCP socket
+                if ((pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) ||
+                    (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP)) {
+                    errnoLocal = U_SOCK_EINVAL;
+                    if (dataSizeBytes < 0) {
+                        // Invalid argument
+                    } else {
+                        errnoLocal = U_SOCK_ENONE;
+                        if (dataSizeBytes > 0) {
+                            // Talk to the underlying cell/wifi
+                            // socket layer to send the datagram.
+                            // uXxxSockSendTo() returns the number of
+                            // bytes sent or a negated value of errno
+                            // from the U_SOCK_Exxx list.
+                            devHandle = pContainer->socket.devHandle;
+                            sockHandle = pContainer->socket.sockHandle;
+                            errorCodeOrSize = -U_SOCK_ENOSYS;
+                            startTimeMs = uPortGetTickTimeMs();
+                            int32_t devType = uDeviceGetDeviceType(devHandle);
+                            if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+                                errorCodeOrSize = uCellSockSendTov(devHandle,
+                                                                   sockHandle,
+                                                                   pRemoteAddress,
+                                                                   pIoVec,
+                                                                   numIoVec);
+                                if (errorCodeOrSize > 0) {
+                                    pContainer->socket.bytesSent += errorCodeOrSize;
+                                }
+                            } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+                                errorCodeOrSize = uWifiSockSendTov(devHandle,
+                                                                   sockHandle,
+                                                                   pRemoteAddress,
+                                                                   pIoVec,
+                                                                   numIoVec);
+                                if (errorCodeOrSize > 0) {
+                                    pContainer->socket.bytesSent += errorCodeOrSize;
+                                }
+                            }
+
+                            if (errorCodeOrSize < 0) {
+                                // Set errno
+                                errnoLocal = -errorCodeOrSize;
+                            } else {
+                                if (errorCodeOrSize > 0) {
+                                    statsWriteAdd(&(pContainer->socket), startTimeMs,
+                                                  errorCodeOrSize);
+                                }
+                                pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_WRITE);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCodeOrSize = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    U_TRACE(SOCK_SEND_TO, errorCodeOrSize);
+    return errorCodeOrSize;
+}
+
+// Receive a single datagram from the given host into the
+// fragments of an I/O vector.
+static int32_t receiveFromIoVec(uSockDescriptor_t descriptor,
+                                uSockAddress_t *pRemoteAddress,
+                                const uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errnoLocal;
+    uSockContainer_t *pContainer = NULL;
+    int32_t dataSizeBytes = uSockIoVecLength(pIoVec, numIoVec);
+    char *pData = NULL;
+    size_t offset = 0;
+    size_t thisSize;
+
+    U_PORT_SPAN_BEGIN("sockReceiveFrom");
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+
+        U_PORT_MUTEX_LOCK(gMutexContainer);
+
+        // Find the container
+        errnoLocal = U_SOCK_EBADF;
+        pContainer = pContainerFindByDescriptor(descriptor);
+        if (pContainer != NULL) {
+            errnoLocal = U_SOCK_EPROTOTYPE;
+            // It is OK to receive UDP-style on a TCP socket
+            if ((pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) ||
+                (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP)) {
+                // I know connection isn't strictly relevant
+                // to UDP but I can't see anything more
+                // appropriate to return
+                errnoLocal = U_SOCK_ENOTCONN;
+                if (pContainer->socket.state != U_SOCK_STATE_CLOSING) {
+                    errnoLocal = U_SOCK_ESHUTDOWN;
+                    if ((pContainer->socket.state != U_SOCK_STATE_SHUTDOWN_FOR_READ) &&
+                        (pContainer->socket.state != U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
+                        errnoLocal = U_SOCK_EINVAL;
+                        if (dataSizeBytes < 0) {
+                            // Invalid argument
+                        } else {
+                            errnoLocal = U_SOCK_ENONE;
+                            if ((dataSizeBytes > 0) && (numIoVec == 1)) {
+                                // Straight in
+                                pData = (char *) pIoVec->pBase;
+                            } else if (dataSizeBytes > 0) {
+                                // A datagram is received with a single
+                                // read so there has to be somewhere
+                                // to put the whole thing first
+                                errnoLocal = U_SOCK_ENOMEM;
+                                pData = (char *) malloc(dataSizeBytes);
+                                if (pData != NULL) {
+                                    errnoLocal = U_SOCK_ENONE;
+                                }
+                            }
+                            if (pData != NULL) {
+                                // Receive the datagram
+                                errorCodeOrSize = receive(pContainer,
+                                                          pRemoteAddress,
+                                                          pData,
+                                                          dataSizeBytes,
+                                                          pContainer->socket.blocking);
+                                statsReadAdd(&(pContainer->socket), errorCodeOrSize);
+                                if (pData != (char *) pIoVec->pBase) {
+                                    // Spread it across the fragments
+                                    for (size_t x = 0; (x < numIoVec) &&
+                                         ((int32_t) offset < errorCodeOrSize); x++) {
+                                        thisSize = (pIoVec + x)->length;
+                                        if (thisSize > (size_t) errorCodeOrSize - offset) {
+                                            thisSize = (size_t) errorCodeOrSize - offset;
+                                        }
+                                        if (thisSize > 0) {
+                                            memcpy((pIoVec + x)->pBase, pData + offset, thisSize);
+                                        }
+                                        offset += thisSize;
+                                    }
+                                    free(pData);
+                                }
+                                if (errorCodeOrSize < 0) {
+                                    // Set errno
+                                    errnoLocal = -errorCodeOrSize;
+                                } else {
+                                    // There may be another datagram waiting
+                                    pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_READ);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCodeOrSize = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    U_TRACE(SOCK_RECEIVE_FROM, errorCodeOrSize);
+    U_PORT_SPAN_END();
+    return errorCodeOrSize;
+}
+
+// Send data, gathered from an I/O vector, over a TCP socket.
+static int32_t writeIoVec(uSockDescriptor_t descriptor,
+                          const uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errnoLocal;
+    int32_t dataSizeBytes = uSockIoVecLength(pIoVec, numIoVec);
+    uSockContainer_t *pContainer = NULL;
+
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+
+        U_PORT_MUTEX_LOCK(gMutexContainer);
+
+        // Find the container
+        errnoLocal = U_SOCK_EBADF;
+        pContainer = pContainerFindByDescriptor(descriptor);
+        if (pContainer != NULL) {
+            errnoLocal = U_SOCK_EPROTOTYPE;
+            if (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP) {
+                if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
+                    errnoLocal = U_SOCK_EINVAL;
+                    if (dataSizeBytes < 0) {
+                        // Invalid argument
+                    } else {
+                        errnoLocal = U_SOCK_ENONE;
+                        if (dataSizeBytes > 0) {
+                            // Talk to the underlying cell/wifi
+                            // socket layer to send the data, via
+                            // the coalescing buffer if there is one
+                            if (pContainer->socket.pCoalesceBuffer != NULL) {
+                                errorCodeOrSize = coalesceWritev(&(pContainer->socket),
+                                                                 pIoVec, numIoVec,
+                                                                 dataSizeBytes);
+                            } else {
+                                errorCodeOrSize = underlyingWritev(&(pContainer->socket),
+                                                                   pIoVec, numIoVec);
+                            }
+
+                            if (errorCodeOrSize < 0) {
+                                // Set errno
+                                errnoLocal = -errorCodeOrSize;
+                            } else {
+                                pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_WRITE);
+                            }
+                        }
+                    }
+                } else {
+                    if ((pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ) ||
+                        (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
+                        // Socket is shut down
+                        errnoLocal = U_SOCK_ESHUTDOWN;
+                    } else if (pContainer->socket.state == U_SOCK_STATE_CLOSING) {
+                        // Not connected mate
+                        errnoLocal = U_SOCK_ENOTCONN;
+                    } else {
+                        // No route to host?
+                        errnoLocal = U_SOCK_EHOSTUNREACH;
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCodeOrSize = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    U_TRACE(SOCK_WRITE, errorCodeOrSize);
+    return errorCodeOrSize;
+}
+
+// Receive data from a TCP socket into the fragments of an
+// I/O vector, in order.
+static int32_t readIoVec(uSockDescriptor_t descriptor,
+                         const uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errnoLocal;
+    uSockContainer_t *pContainer = NULL;
+    int32_t dataSizeBytes = uSockIoVecLength(pIoVec, numIoVec);
+    int32_t thisSize;
+    bool blocking;
+    bool keepGoing;
+
+    U_PORT_SPAN_BEGIN("sockRead");
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+
+        U_PORT_MUTEX_LOCK(gMutexContainer);
+
+        // Find the container
+        errnoLocal = U_SOCK_EBADF;
+        pContainer = pContainerFindByDescriptor(descriptor);
+        if (pContainer != NULL) {
+            errnoLocal = U_SOCK_EPROTOTYPE;
+            if (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP) {
+                if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
+                    errnoLocal = U_SOCK_EINVAL;
+                    if (dataSizeBytes < 0) {
+                        // Invalid argument
+                    } else {
+                        errnoLocal = U_SOCK_ENONE;
+                        if (dataSizeBytes > 0) {
+                            // Fill the fragments in order, moving
+                            // on only when one is full; only the
+                            // first read may block, after that we
+                            // take whatever is already there
+                            blocking = pContainer->socket.blocking;
+                            keepGoing = true;
+                            for (size_t x = 0; (x < numIoVec) && keepGoing; x++) {
+                                if ((pIoVec + x)->length > 0) {
+                                    thisSize = receive(pContainer, NULL,
+                                                       (pIoVec + x)->pBase,
+                                                       (pIoVec + x)->length,
+                                                       blocking);
+                                    if (thisSize >= 0) {
+                                        errorCodeOrSize += thisSize;
+                                        keepGoing = (thisSize == (int32_t) (pIoVec + x)->length);
+                                        blocking = false;
+                                    } else {
+                                        if (errorCodeOrSize == 0) {
+                                            // Nothing at all was received
+                                            errorCodeOrSize = thisSize;
+                                        }
+                                        keepGoing = false;
+                                    }
+                                }
+                            }
+                            statsReadAdd(&(pContainer->socket), errorCodeOrSize);
+                            if (errorCodeOrSize < 0) {
+                                // Set errno
+                                errnoLocal = -errorCodeOrSize;
+                            } else if (errorCodeOrSize == dataSizeBytes) {
+                                // There may be more where that came from
+                                pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_READ);
+                            }
+                        }
+                    }
+                } else {
+                    if ((pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ) ||
+                        (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
+                        // Socket is shut down
+                        errnoLocal = U_SOCK_ESHUTDOWN;
+                    } else if (pContainer->socket.state == U_SOCK_STATE_CLOSING) {
+                        // Not connected mate
+                        errnoLocal = U_SOCK_ENOTCONN;
+                    } else {
+                        // No route to host?
+                        errnoLocal = U_SOCK_EHOSTUNREACH;
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCodeOrSize = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    U_TRACE(SOCK_READ, errorCodeOrSize);
+    U_PORT_SPAN_END();
+    return errorCodeOrSize;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: OPTIONS
+ * -------------------------------------------------------------- */
+
+// Set, change or remove the coalescing buffer of a TCP socket,
+// returning U_SOCK_ENONE or the errno of the failure.  Anything
+// already in the buffer is flushed first.
+// This does NOT lock the mutex, you need to do that.
+static int32_t coalesceSet(uSockContainer_t *pContainer,
+                           const uSockCoalesce_t *pCoalesce)
+{
+    int32_t errnoLocal = U_SOCK_ENOPROTOOPT;
+    uSockSocket_t *pSocket = &(pContainer->socket);
+    char *pBuffer = NULL;
+    uPortTimerHandle_t timerHandle = NULL;
+    int32_t errorCode;
+
+    if (pSocket->protocol == U_SOCK_PROTOCOL_TCP) {
+        errnoLocal = U_SOCK_EINVAL;
+        if (pCoalesce->timeoutMs >= 0) {
+            errnoLocal = coalesceFlush(pSocket);
+        }
+        if ((errnoLocal == U_SOCK_ENONE) && (pCoalesce->bufferSizeBytes > 0)) {
+            errnoLocal = U_SOCK_ENOMEM;
+            pBuffer = (char *) malloc(pCoalesce->bufferSizeBytes);
+            if ((pBuffer != NULL) && (pCoalesce->timeoutMs > 0) &&
+                (gEventQueueCoalesceHandle < 0)) {
+                // The flush task is shared by all sockets and
+                // stays until uSockDeinit()
+                gEventQueueCoalesceHandle = uPortEventQueueOpen(coalesceEventHandler,
+                                                                "sockCoalesce",
+                                                                sizeof(uSockDescriptor_t),
+                                                                U_SOCK_COALESCE_TASK_STACK_SIZE_BYTES,
+                                                                U_SOCK_COALESCE_TASK_PRIORITY,
+                                                                U_SOCK_MAX_NUM_SOCKETS);
+                if (gEventQueueCoalesceHandle < 0) {
+                    gEventQueueCoalesceHandle = -1;
+                }
+            }
+            if (pBuffer != NULL) {
+                errnoLocal = U_SOCK_ENONE;
+                if (pCoalesce->timeoutMs > 0) {
+                    errnoLocal = U_SOCK_ENOMEM;
+                    if (gEventQueueCoalesceHandle >= 0) {
+                        errorCode = uPortTimerCreate(&timerHandle, "sockCoalesce",
+                                                     coalesceTimerCallback,
+                                                     (void *) (intptr_t) pContainer->descriptor,
+                                                     (uint32_t) pCoalesce->timeoutMs,
+                                                     false);
+                        if (errorCode == 0) {
+                            errnoLocal = U_SOCK_ENONE;
+                        } else if (errorCode == (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED) {
+                            // No timers on this platform
+                            errnoLocal = U_SOCK_ENOSYS;
+                        }
+                    }
+                }
+                if (errnoLocal != U_SOCK_ENONE) {
+                    free(pBuffer);
+                    pBuffer = NULL;
+                }
+            }
+        }
+        if (errnoLocal == U_SOCK_ENONE) {
+            // The buffer is empty, swap it for the new one
+            coalesceFree(pSocket);
+            if (pBuffer != NULL) {
+                pSocket->pCoalesceBuffer = pBuffer;
+                pSocket->coalesceBufferSize = pCoalesce->bufferSizeBytes;
+                pSocket->coalesceTimeoutMs = pCoalesce->timeoutMs;
+                pSocket->coalesceTimerHandle = timerHandle;
+            }
+        }
+    }
+
+    return errnoLocal;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: DNS CACHE
+ * -------------------------------------------------------------- */
+
+#if U_SOCK_DNS_CACHE_NUM_ENTRIES > 0
+
+// Compare two host names, ignoring case as DNS does.
+static bool hostNameIsEqual(const char *pHostName1, const char *pHostName2)
+{
+    char c1;
+    char c2;
+
+    do {
+        c1 = *pHostName1;
+        c2 = *pHostName2;
+        if ((c1 >= 'A') && (c1 <= 'Z')) {
+            c1 = (char) (c1 - 'A' + 'a');
+        }
+        if ((c2 >= 'A') && (c2 <= 'Z')) {
+            c2 = (char) (c2 - 'A' + 'a');
+        }
+        pHostName1++;
+        pHostName2++;
+    } while ((c1 == c2) && (c1 != 0));
+
+    return (c1 == c2);
+}
+
+// Determine if a DNS cache entry has expired.
+static bool dnsCacheEntryIsExpired(const uSockDnsCacheEntry_t *pEntry)
+{
+    int32_t ttlMs = U_SOCK_DNS_CACHE_TTL_SECONDS * 1000;
+
+    if (pEntry->errnoLocal != U_SOCK_ENONE) {
+        ttlMs = U_SOCK_DNS_CACHE_NEGATIVE_TTL_SECONDS * 1000;
+    }
+
+    return (uPortGetTickTimeMs() - pEntry->storedTimeMs >= ttlMs);
+}
+
+#endif
+
+// Find a host name in the DNS cache: if it is there, and has not
+// expired, the errno of the cached look-up is returned and, if
+// that is U_SOCK_ENONE, the IP address is written to pIpAddress,
+// else -1 is returned.
+// This does NOT lock gMutexDnsCache, you need to do that.
+static int32_t dnsCacheFind(uDeviceHandle_t devHandle,
+                            const char *pHostName,
+                            uSockIpAddress_t *pIpAddress)
+{
+    int32_t errnoLocalOrNotFound = -1;
+
+#if U_SOCK_DNS_CACHE_NUM_ENTRIES > 0
+    uSockDnsCacheEntry_t *pEntry;
+
+    for (size_t x = 0; (x < sizeof(gDnsCache) / sizeof(gDnsCache[0])) &&
+         (errnoLocalOrNotFound < 0); x++) {
+        pEntry = &(gDnsCache[x]);
+        if ((pEntry->devHandle == devHandle) &&
+            hostNameIsEqual(pEntry->hostName, pHostName)) {
+            if (dnsCacheEntryIsExpired(pEntry)) {
+                // Too old, free the entry
+                pEntry->devHandle = NULL;
+            } else {
+                pEntry->usedTimeMs = uPortGetTickTimeMs();
+                errnoLocalOrNotFound = pEntry->errnoLocal;
+                if (errnoLocalOrNotFound == U_SOCK_ENONE) {
+                    *pIpAddress = pEntry->ipAddress;
+                }
+            }
+        }
+    }
+#else
+    (void) devHandle;
+    (void) pHostName;
+    (void) pIpAddress;
+#endif
+
+    return errnoLocalOrNotFound;
+}
+
+// Store the result of a look-up in the DNS cache, replacing any
+// existing entry for the host name; if the cache is full the
+// least recently used entry is replaced.  If the look-up failed
+// it is only stored if the failure was because the host name
+// could not be found.
+// This does NOT lock gMutexDnsCache, you need to do that.
+static void dnsCacheStore(uDeviceHandle_t devHandle,
+                          const char *pHostName,
+                          const uSockIpAddress_t *pIpAddress,
+                          int32_t errnoLocal)
+{
+#if U_SOCK_DNS_CACHE_NUM_ENTRIES > 0
+    uSockDnsCacheEntry_t *pEntry = NULL;
+    uSockDnsCacheEntry_t *pTmp;
+    size_t length = strlen(pHostName);
+
+    if ((devHandle != NULL) &&
+        (length < sizeof(gDnsCache[0].hostName)) &&
+        ((errnoLocal == U_SOCK_ENONE) ||
+         ((U_SOCK_DNS_CACHE_NEGATIVE_TTL_SECONDS > 0) &&
+          ((errnoLocal == U_SOCK_ENXIO) || (errnoLocal == U_SOCK_EHOSTUNREACH))))) {
+        // Look for an existing entry for this host name first,
+        // then for a free or expired entry
+        for (size_t x = 0; (x < sizeof(gDnsCache) / sizeof(gDnsCache[0])) &&
+             (pEntry == NULL); x++) {
+            pTmp = &(gDnsCache[x]);
+            if ((pTmp->devHandle == devHandle) &&
+                hostNameIsEqual(pTmp->hostName, pHostName)) {
+                pEntry = pTmp;
+            }
+        }
+        for (size_t x = 0; (x < sizeof(gDnsCache) / sizeof(gDnsCache[0])) &&
+             (pEntry == NULL); x++) {
+            pTmp = &(gDnsCache[x]);
+            if ((pTmp->devHandle == NULL) || dnsCacheEntryIsExpired(pTmp)) {
+                pEntry = pTmp;
+            }
+        }
+        if (pEntry == NULL) {
+            // Full: replace the least recently used entry
+            pEntry = &(gDnsCache[0]);
+            for (size_t x = 1; x < sizeof(gDnsCache) / sizeof(gDnsCache[0]); x++) {
+                pTmp = &(gDnsCache[x]);
+                if (pTmp->usedTimeMs - pEntry->usedTimeMs < 0) {
+                    pEntry = pTmp;
+                }
+            }
+        }
+        pEntry->devHandle = devHandle;
+        memcpy(pEntry->hostName, pHostName, length + 1);
+        memset(&(pEntry->ipAddress), 0, sizeof(pEntry->ipAddress));
+        if (errnoLocal == U_SOCK_ENONE) {
+            pEntry->ipAddress = *pIpAddress;
+        }
+        pEntry->errnoLocal = errnoLocal;
+        pEntry->storedTimeMs = uPortGetTickTimeMs();
+        pEntry->usedTimeMs = pEntry->storedTimeMs;
+    }
+#else
+    (void) devHandle;
+    (void) pHostName;
+    (void) pIpAddress;
+    (void) errnoLocal;
+#endif
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: CREATE/OPEN/CLOSE/CLEAN-UP
+ * -------------------------------------------------------------- */
+
+// Create a socket.
+int32_t uSockCreate(uDeviceHandle_t devHandle, uSockType_t type,
+                    uSockProtocol_t protocol)
+{
+    int32_t descriptorOrError = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errnoLocal;
+    uSockContainer_t *pContainer = NULL;
+    uSockDescriptor_t descriptor = gNextDescriptor;
+    int32_t sockHandle = -U_SOCK_ENOSYS;
+
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+        // Check parameters
+        errnoLocal = U_SOCK_ENODEV;
+        if (uDeviceIsValidInstance(U_DEVICE_INSTANCE(devHandle))) {
+            errnoLocal = U_SOCK_EPROTONOSUPPORT;
+            if (((type == U_SOCK_TYPE_STREAM) && (protocol == U_SOCK_PROTOCOL_TCP)) ||
+                ((type == U_SOCK_TYPE_DGRAM) && (protocol == U_SOCK_PROTOCOL_UDP))) {
+                errnoLocal = U_SOCK_ENONE;
+            }
+        }
+    }
+
+    if (errnoLocal == U_SOCK_ENONE) {
+
+        U_PORT_MUTEX_LOCK(gMutexContainer);
 
         errnoLocal = U_SOCK_ENOBUFS;
         if (numContainersInUse() < U_SOCK_MAX_NUM_SOCKETS) {
@@ -1205,6 +2614,7 @@ int32_t uSockCreate(uDeviceHandle_t devHandle, uSockType_t type,
                         // as it was already set above
                         pContainer->socket.sockHandle = sockHandle;
                         pContainer->socket.devHandle = devHandle;
+                        indexSockHandleAdd(pContainer);
                         pContainer->socket.bytesSent = 0;
                         uPortLog("U_SOCK: socket created, descriptor %d,"
                                  " network handle 0x%08x, socket handle %d.\n",
@@ -1259,7 +2669,9 @@ int32_t uSockConnect(uSockDescriptor_t descriptor,
             errnoLocal = U_SOCK_EBADF;
             if (pContainer != NULL) {
                 errnoLocal = U_SOCK_EPERM;
-                if (pContainer->socket.state == U_SOCK_STATE_CREATED) {
+                if (pContainer->socket.state == U_SOCK_STATE_CONNECTING) {
+                    errnoLocal = U_SOCK_EALREADY;
+                } else if (pContainer->socket.state == U_SOCK_STATE_CREATED) {
                     // We have found the container and it is
                     // in the right state, talk to the underlying
                     // cell/wifi socket layer to make the connection
@@ -1290,6 +2702,7 @@ int32_t uSockConnect(uSockDescriptor_t descriptor,
                                pRemoteAddress,
                                sizeof(pContainer->socket.remoteAddress));
                         pContainer->socket.state = U_SOCK_STATE_CONNECTED;
+                        pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_WRITE);
                         uPortLog("U_SOCK: socket with descriptor %d, network"
                                  " handle 0x%08x, socket handle %d, is "
                                  " connected to address \"%.*s\".\n",
@@ -1358,6 +2771,15 @@ int32_t uSockClose(uSockDescriptor_t descriptor)
             sockHandle = pContainer->socket.sockHandle;
             errnoLocal = U_SOCK_ENONE;
             errorCode = -U_SOCK_ENOSYS;
+            // Whoever closes the socket doesn't need to
+            // be told about it through uSockPollWait()
+            U_PORT_MUTEX_LOCK(gMutexPoll);
+            pollReadyRemove(pContainer);
+            pContainer->socket.pollEventMask = 0;
+            U_PORT_MUTEX_UNLOCK(gMutexPoll);
+            // Anything still waiting to be coalesced goes
+            // now, there is no-one to report a failure to
+            coalesceFlush(&(pContainer->socket));
             int32_t devType = uDeviceGetDeviceType(devHandle);
             if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
                 // In the cellular case asynchronous TCP
@@ -1379,6 +2801,7 @@ int32_t uSockClose(uSockDescriptor_t descriptor)
                          " network handle 0x%08x, socket handle %d,"
                          " has been closed.\n",
                          descriptor, devHandle, sockHandle);
+                coalesceFree(&(pContainer->socket));
                 if (pContainer->socket.state != U_SOCK_STATE_CLOSED) {
                     // Now mark the socket as closed (or closing).
                     // Socket is only freed by a call to
@@ -1458,7 +2881,12 @@ void uSockCleanUp()
                     devHandle = pContainer->socket.devHandle;
 
                     // Free the memory
-                    free(pContainer);
+                    indexRemove(pContainer);
+                    U_PORT_MUTEX_LOCK(gMutexPoll);
+                    pollReadyRemove(pContainer);
+                    U_PORT_MUTEX_UNLOCK(gMutexPoll);
+                    coalesceFree(&(pContainer->socket));
+                    uMemPoolFree(pContainer);
                     // Move to the next entry
                     pContainer = pTmp;
                 } else {
@@ -1518,6 +2946,7 @@ void uSockDeinit()
                 // we're closin' dowwwn...
                 devHandle = pContainer->socket.devHandle;
                 sockHandle = pContainer->socket.sockHandle;
+                coalesceFlush(&(pContainer->socket));
                 int32_t devType = uDeviceGetDeviceType(devHandle);
                 if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
                     uCellSockClose(devHandle, sockHandle, NULL);
@@ -1546,11 +2975,21 @@ void uSockDeinit()
                 pTmp = pContainer->pNext;
 
                 // Free the memory
-                free(pContainer);
+                indexRemove(pContainer);
+                U_PORT_MUTEX_LOCK(gMutexPoll);
+                pollReadyRemove(pContainer);
+                U_PORT_MUTEX_UNLOCK(gMutexPoll);
+                coalesceFree(&(pContainer->socket));
+                uMemPoolFree(pContainer);
                 // Move to the next entry
                 pContainer = pTmp;
             } else {
                 pContainer->socket.state = U_SOCK_STATE_CLOSED;
+                U_PORT_MUTEX_LOCK(gMutexPoll);
+                pollReadyRemove(pContainer);
+                pContainer->socket.pollEventMask = 0;
+                U_PORT_MUTEX_UNLOCK(gMutexPoll);
+                coalesceFree(&(pContainer->socket));
                 // Move on
                 pContainer = pContainer->pNext;
             }
@@ -1560,6 +2999,15 @@ void uSockDeinit()
         deinitButNotMutex();
 
         U_PORT_MUTEX_UNLOCK(gMutexContainer);
+
+        // The coalescing flush task takes the container
+        // mutex, so it can only be stopped once that has
+        // been released; the timers that drive it have
+        // all been deleted by now
+        if (gEventQueueCoalesceHandle >= 0) {
+            uPortEventQueueClose(gEventQueueCoalesceHandle);
+            gEventQueueCoalesceHandle = -1;
+        }
     }
 }
 
@@ -1677,6 +3125,27 @@ int32_t uSockOptionSet(uSockDescriptor_t descriptor,
                         printSocketOption(pOptionValue, optionValueLength);
                         uPortLog("\n");
                     }
+                } else if ((level == U_SOCK_OPT_LEVEL_SOCK) &&
+                           (option == U_SOCK_OPT_COALESCE)) {
+                    // Write coalescing we also do locally
+                    if ((pOptionValue != NULL) &&
+                        (optionValueLength == sizeof(uSockCoalesce_t))) {
+                        errnoLocal = coalesceSet(pContainer,
+                                                 (const uSockCoalesce_t *) pOptionValue);
+                    }
+                    if (errnoLocal == U_SOCK_ENONE) {
+                        uPortLog("U_SOCK: write coalescing for socket descriptor"
+                                 " %d set to %d byte(s), timeout %d ms.\n",
+                                 descriptor,
+                                 (int32_t) pContainer->socket.coalesceBufferSize,
+                                 pContainer->socket.coalesceTimeoutMs);
+                    } else {
+                        uPortLog("U_SOCK: errno %d when setting"
+                                 " socket option %d:0x%04x to value ",
+                                 errnoLocal, option, level);
+                        printSocketOption(pOptionValue, optionValueLength);
+                        uPortLog("\n");
+                    }
                 } else {
                     // Otherwise talk to the underlying socket
                     // layer to set the socket option.
@@ -1780,6 +3249,26 @@ int32_t uSockOptionGet(uSockDescriptor_t descriptor,
                             *pOptionValueLength = sizeof(struct timeval);
                         }
                     }
+                } else if ((level == U_SOCK_OPT_LEVEL_SOCK) &&
+                           (option == U_SOCK_OPT_COALESCE)) {
+                    // Write coalescing we also have locally
+                    if (pOptionValueLength != NULL) {
+                        if (pOptionValue != NULL) {
+                            if (*pOptionValueLength >= sizeof(uSockCoalesce_t)) {
+                                errnoLocal = U_SOCK_ENONE;
+                                // Return the answer
+                                ((uSockCoalesce_t *) pOptionValue)->bufferSizeBytes =
+                                    pContainer->socket.coalesceBufferSize;
+                                ((uSockCoalesce_t *) pOptionValue)->timeoutMs =
+                                    pContainer->socket.coalesceTimeoutMs;
+                                *pOptionValueLength = sizeof(uSockCoalesce_t);
+                            }
+                        } else {
+                            errnoLocal = U_SOCK_ENONE;
+                            // Caller just wants to know the length required
+                            *pOptionValueLength = sizeof(uSockCoalesce_t);
+                        }
+                    }
                 } else {
                     // Otherwise talk to the underlying socket layer
                     // to get the socket option.
@@ -1951,11 +3440,35 @@ int32_t uSockSendTo(uSockDescriptor_t descriptor,
                     const uSockAddress_t *pRemoteAddress,
                     const void *pData, size_t dataSizeBytes)
 {
-    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+    uSockIoVec_t ioVec;
+
+    ioVec.pBase = (void *) pData;
+    ioVec.length = dataSizeBytes;
+
+    return sendToIoVec(descriptor, pRemoteAddress, &ioVec, 1);
+}
+
+int32_t uSockGetTotalBytesSent(uSockDescriptor_t descriptor)
+{
+    int32_t errorCodeOrTotalBytesSent = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uSockContainer_t *pContainer;
+
+    pContainer = pContainerFindByDescriptor(descriptor);
+
+    if (pContainer != NULL) {
+        errorCodeOrTotalBytesSent = pContainer->socket.bytesSent;
+    }
+
+    return errorCodeOrTotalBytesSent;
+}
+
+// Get the statistics of a socket.
+int32_t uSockStatsGet(uSockDescriptor_t descriptor, uSockStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
     int32_t errnoLocal;
     uSockContainer_t *pContainer = NULL;
-    uDeviceHandle_t devHandle;
-    int32_t sockHandle;
+    const uSockSocketStats_t *pSocketStats;
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
@@ -1966,78 +3479,31 @@ int32_t uSockSendTo(uSockDescriptor_t descriptor,
         errnoLocal = U_SOCK_EBADF;
         pContainer = pContainerFindByDescriptor(descriptor);
         if (pContainer != NULL) {
-            // Check address and state
-            if (pRemoteAddress != NULL) {
+            errnoLocal = U_SOCK_EINVAL;
+            if (pStats != NULL) {
                 errnoLocal = U_SOCK_ENONE;
-            } else {
-                // If there is no remote address and the socket was
-                // connected we must use the stored address
-                if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
-                    pRemoteAddress = &(pContainer->socket.remoteAddress);
-                    errnoLocal = U_SOCK_ENONE;
-                } else {
-                    if ((pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_WRITE) ||
-                        (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
-                        // Socket is shut down
-                        errnoLocal = U_SOCK_ESHUTDOWN;
-                    } else if (pContainer->socket.state == U_SOCK_STATE_CLOSING) {
-                        // I know connection isn't strictly relevant
-                        // to UDP transmission but I can't see anything
-                        // more appropriate to return
-                        errnoLocal = U_SOCK_ENOTCONN;
-                    } else {
-                        // Destination address required?
-                        errnoLocal = U_SOCK_EDESTADDRREQ;
-                    }
+                pSocketStats = &(pContainer->socket.stats);
+                pStats->bytesSent = pContainer->socket.bytesSent;
+                pStats->bytesReceived = pSocketStats->bytesReceived;
+                pStats->numReadsWouldBlock = pSocketStats->numReadsWouldBlock;
+                pStats->numWrites = pSocketStats->numWrites;
+                pStats->writeLatencyAverageMs = -1;
+                pStats->writeLatencyMaxMs = -1;
+                if (pSocketStats->numWrites > 0) {
+                    pStats->writeLatencyAverageMs = (int32_t) (pSocketStats->writeLatencyTotalMs /
+                                                               pSocketStats->numWrites);
+                    pStats->writeLatencyMaxMs = pSocketStats->writeLatencyMaxMs;
                 }
-            }
-            if ((errnoLocal == U_SOCK_ENONE) && (pRemoteAddress != NULL)) {
-                errnoLocal = U_SOCK_EPROTOTYPE;
-                // It is OK to send UDP packets on a TCP socket
-                if ((pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) ||
-                    (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP)) {
-                    errnoLocal = U_SOCK_EINVAL;
-                    if ((pData == NULL) && (dataSizeBytes > 0)) {
-                        // Invalid argument
-                    } else {
-                        errnoLocal = U_SOCK_ENONE;
-                        if ((pData != NULL) && (dataSizeBytes > 0)) {
-                            // Talk to the underlying cell/wifi
-                            // socket layer to send the datagram.
-                            // uXxxSockSendTo() returns the number of
-                            // bytes sent or a negated value of errno
-                            // from the U_SOCK_Exxx list.
-                            devHandle = pContainer->socket.devHandle;
-                            sockHandle = pContainer->socket.sockHandle;
-                            errorCodeOrSize = -U_SOCK_ENOSYS;
-                            int32_t devType = uDeviceGetDeviceType(devHandle);
-                            if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
-                                errorCodeOrSize = uCellSockSendTo(devHandle,
-                                                                  sockHandle,
-                                                                  pRemoteAddress,
-                                                                  pData,
-                                                                  dataSizeBytes);
-                                if (errorCodeOrSize > 0) {
-                                    pContainer->socket.bytesSent += errorCodeOrSize;
-                                }
-                            } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
-                                errorCodeOrSize = uWifiSockSendTo(devHandle,
-                                                                  sockHandle,
-                                                                  pRemoteAddress,
-                                                                  pData,
-                                                                  dataSizeBytes);
-                                if (errorCodeOrSize > 0) {
-                                    pContainer->socket.bytesSent += errorCodeOrSize;
-                                }
-                            }
-
-                            if (errorCodeOrSize < 0) {
-                                // Set errno
-                                errnoLocal = -errorCodeOrSize;
-                            }
-                        }
-                    }
+                U_PORT_MUTEX_LOCK(gMutexPoll);
+                pStats->numDataCallbacks = pSocketStats->numDataCallbacks;
+                pStats->readLatencyAverageMs = -1;
+                pStats->readLatencyMaxMs = -1;
+                if (pSocketStats->numReadLatencies > 0) {
+                    pStats->readLatencyAverageMs = (int32_t) (pSocketStats->readLatencyTotalMs /
+                                                              pSocketStats->numReadLatencies);
+                    pStats->readLatencyMaxMs = pSocketStats->readLatencyMaxMs;
                 }
+                U_PORT_MUTEX_UNLOCK(gMutexPoll);
             }
         }
 
@@ -2047,34 +3513,42 @@ int32_t uSockSendTo(uSockDescriptor_t descriptor,
     if (errnoLocal != U_SOCK_ENONE) {
         // Write the errno
         errno = errnoLocal;
-        errorCodeOrSize = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+        errorCode = (int32_t) U_ERROR_COMMON_BSD_ERROR;
     }
 
-    return errorCodeOrSize;
+    return errorCode;
 }
 
-int32_t uSockGetTotalBytesSent(uSockDescriptor_t descriptor)
+// Receive a single datagram from the given host.
+int32_t uSockReceiveFrom(uSockDescriptor_t descriptor,
+                         uSockAddress_t *pRemoteAddress,
+                         void *pData, size_t dataSizeBytes)
 {
-    int32_t errorCodeOrTotalBytesSent = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-    uSockContainer_t *pContainer;
-
-    pContainer = pContainerFindByDescriptor(descriptor);
+    uSockIoVec_t ioVec;
 
-    if (pContainer != NULL) {
-        errorCodeOrTotalBytesSent = pContainer->socket.bytesSent;
-    }
+    ioVec.pBase = pData;
+    ioVec.length = dataSizeBytes;
 
-    return errorCodeOrTotalBytesSent;
+    return receiveFromIoVec(descriptor, pRemoteAddress, &ioVec, 1);
 }
 
-// Receive a single datagram from the given host.
-int32_t uSockReceiveFrom(uSockDescriptor_t descriptor,
-                         uSockAddress_t *pRemoteAddress,
-                         void *pData, size_t dataSizeBytes)
+// Send several datagrams.
+int32_t uSockSendToMany(uSockDescriptor_t descriptor,
+                        uSockDatagram_t *pDatagrams,
+                        size_t numDatagrams)
 {
-    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
     int32_t errnoLocal;
     uSockContainer_t *pContainer = NULL;
+    const uSockAddress_t *pRemoteAddress = NULL;
+    const uSockAddress_t *pAddress;
+    uDeviceHandle_t devHandle;
+    int32_t sockHandle;
+    int32_t devType;
+    int32_t startTimeMs;
+    int32_t bytesSent = 0;
+    uSockIoVec_t ioVec;
+    int32_t x = 0;
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
@@ -2085,37 +3559,77 @@ int32_t uSockReceiveFrom(uSockDescriptor_t descriptor,
         errnoLocal = U_SOCK_EBADF;
         pContainer = pContainerFindByDescriptor(descriptor);
         if (pContainer != NULL) {
-            errnoLocal = U_SOCK_EPROTOTYPE;
-            // It is OK to receive UDP-style on a TCP socket
-            if ((pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) ||
-                (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP)) {
-                // I know connection isn't strictly relevant
-                // to UDP but I can't see anything more
-                // appropriate to return
-                errnoLocal = U_SOCK_ENOTCONN;
-                if (pContainer->socket.state != U_SOCK_STATE_CLOSING) {
-                    errnoLocal = U_SOCK_ESHUTDOWN;
-                    if ((pContainer->socket.state != U_SOCK_STATE_SHUTDOWN_FOR_READ) &&
-                        (pContainer->socket.state != U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
-                        errnoLocal = U_SOCK_EINVAL;
-                        if ((pData == NULL) && (dataSizeBytes > 0)) {
-                            // Invalid argument
-                        } else {
-                            errnoLocal = U_SOCK_ENONE;
-                            if ((pData != NULL) && (dataSizeBytes != 0)) {
-                                // Receive the datagram
-                                errorCodeOrSize = receive(pContainer,
-                                                          pRemoteAddress,
-                                                          pData,
-                                                          dataSizeBytes);
-                                if (errorCodeOrSize < 0) {
-                                    // Set errno
-                                    errnoLocal = -errorCodeOrSize;
-                                }
-                            }
+            errnoLocal = U_SOCK_EINVAL;
+            if ((pDatagrams != NULL) || (numDatagrams == 0)) {
+                errnoLocal = U_SOCK_EPROTOTYPE;
+                // It is OK to send UDP packets on a TCP socket
+                if ((pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) ||
+                    (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP)) {
+                    errnoLocal = U_SOCK_ENONE;
+                    if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
+                        // Datagrams without an address go here
+                        pRemoteAddress = &(pContainer->socket.remoteAddress);
+                    } else if ((pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_WRITE) ||
+                               (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
+                        errnoLocal = U_SOCK_ESHUTDOWN;
+                    } else if (pContainer->socket.state == U_SOCK_STATE_CLOSING) {
+                        errnoLocal = U_SOCK_ENOTCONN;
+                    }
+                }
+            }
+            if (errnoLocal == U_SOCK_ENONE) {
+                devHandle = pContainer->socket.devHandle;
+                sockHandle = pContainer->socket.sockHandle;
+                devType = uDeviceGetDeviceType(devHandle);
+                startTimeMs = uPortGetTickTimeMs();
+                errorCodeOrCount = -U_SOCK_ENOSYS;
+                if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+                    // All under one AT lock
+                    errorCodeOrCount = uCellSockSendToMany(devHandle, sockHandle,
+                                                           pRemoteAddress,
+                                                           pDatagrams,
+                                                           numDatagrams);
+                } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+                    // Each datagram is an EDM data frame of its own,
+                    // there is no round trip to save
+                    errorCodeOrCount = 0;
+                    for (size_t y = 0; (y < numDatagrams) && (x >= 0); y++) {
+                        pAddress = (pDatagrams + y)->pRemoteAddress;
+                        if (pAddress == NULL) {
+                            pAddress = pRemoteAddress;
+                        }
+                        x = 0;
+                        if (pAddress == NULL) {
+                            x = -U_SOCK_EDESTADDRREQ;
+                        } else if ((pDatagrams + y)->dataSizeBytes > 0) {
+                            ioVec.pBase = (pDatagrams + y)->pData;
+                            ioVec.length = (pDatagrams + y)->dataSizeBytes;
+                            x = uWifiSockSendTov(devHandle, sockHandle,
+                                                 pAddress, &ioVec, 1);
                         }
+                        (pDatagrams + y)->sizeBytes = x;
+                        if (x >= 0) {
+                            errorCodeOrCount++;
+                        }
+                    }
+                    if ((errorCodeOrCount == 0) && (x < 0)) {
+                        errorCodeOrCount = x;
                     }
                 }
+                if (errorCodeOrCount < 0) {
+                    // Set errno
+                    errnoLocal = -errorCodeOrCount;
+                } else {
+                    for (int32_t y = 0; y < errorCodeOrCount; y++) {
+                        bytesSent += (pDatagrams + y)->sizeBytes;
+                    }
+                    if (bytesSent > 0) {
+                        pContainer->socket.bytesSent += bytesSent;
+                        statsWriteAdd(&(pContainer->socket), startTimeMs,
+                                      bytesSent);
+                    }
+                    pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_WRITE);
+                }
             }
         }
 
@@ -2125,25 +3639,24 @@ int32_t uSockReceiveFrom(uSockDescriptor_t descriptor,
     if (errnoLocal != U_SOCK_ENONE) {
         // Write the errno
         errno = errnoLocal;
-        errorCodeOrSize = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_BSD_ERROR;
     }
 
-    return errorCodeOrSize;
+    return errorCodeOrCount;
 }
 
-/* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS: STREAM (TCP)
- * -------------------------------------------------------------- */
-
-// Send data.
-int32_t uSockWrite(uSockDescriptor_t descriptor,
-                   const void *pData, size_t dataSizeBytes)
+// Receive several datagrams.
+int32_t uSockReceiveFromMany(uSockDescriptor_t descriptor,
+                             uSockDatagram_t *pDatagrams,
+                             size_t numDatagrams)
 {
-    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
     int32_t errnoLocal;
     uSockContainer_t *pContainer = NULL;
     uDeviceHandle_t devHandle;
     int32_t sockHandle;
+    int32_t devType;
+    int32_t x;
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
@@ -2154,82 +3667,98 @@ int32_t uSockWrite(uSockDescriptor_t descriptor,
         errnoLocal = U_SOCK_EBADF;
         pContainer = pContainerFindByDescriptor(descriptor);
         if (pContainer != NULL) {
-            errnoLocal = U_SOCK_EPROTOTYPE;
-            if (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP) {
-                if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
-                    errnoLocal = U_SOCK_EINVAL;
-                    if (((pData == NULL) && (dataSizeBytes > 0)) ||
-                        (dataSizeBytes > INT_MAX)) {
-                        // Invalid argument
-                    } else {
-                        errnoLocal = U_SOCK_ENONE;
-                        if ((pData != NULL) && (dataSizeBytes != 0)) {
-                            // Talk to the underlying cell/wifi
-                            // socket layer to send the datagram.
-                            // uXxxSockWrite() returns the number
-                            // of bytes sent or a negated value of
-                            // errno from the U_SOCK_Exxx list.
-                            devHandle = pContainer->socket.devHandle;
-                            sockHandle = pContainer->socket.sockHandle;
-                            errorCodeOrSize = -U_SOCK_ENOSYS;
-                            int32_t devType = uDeviceGetDeviceType(devHandle);
-                            if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
-                                errorCodeOrSize = uCellSockWrite(devHandle,
-                                                                 sockHandle,
-                                                                 pData,
-                                                                 dataSizeBytes);
-                                if (errorCodeOrSize > 0) {
-                                    pContainer->socket.bytesSent += errorCodeOrSize;
-                                }
-                            } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
-                                errorCodeOrSize = uWifiSockWrite(devHandle,
-                                                                 sockHandle,
-                                                                 pData,
-                                                                 dataSizeBytes);
-                                if (errorCodeOrSize > 0) {
-                                    pContainer->socket.bytesSent += errorCodeOrSize;
-                                }
-                            }
-
-                            if (errorCodeOrSize < 0) {
-                                // Set errno
-                                errnoLocal = -errorCodeOrSize;
-                            }
+            errnoLocal = U_SOCK_EINVAL;
+            if ((pDatagrams != NULL) && (numDatagrams > 0)) {
+                errnoLocal = U_SOCK_EPROTOTYPE;
+                if (pContainer->socket.protocol == U_SOCK_PROTOCOL_UDP) {
+                    errnoLocal = U_SOCK_ENOTCONN;
+                    if (pContainer->socket.state != U_SOCK_STATE_CLOSING) {
+                        errnoLocal = U_SOCK_ESHUTDOWN;
+                        if ((pContainer->socket.state != U_SOCK_STATE_SHUTDOWN_FOR_READ) &&
+                            (pContainer->socket.state != U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
+                            errnoLocal = U_SOCK_ENONE;
                         }
                     }
+                }
+            }
+            if (errnoLocal == U_SOCK_ENONE) {
+                // The first datagram, waiting for it if
+                // the socket is blocking
+                x = receive(pContainer, pDatagrams->pRemoteAddress,
+                            pDatagrams->pData, pDatagrams->dataSizeBytes,
+                            pContainer->socket.blocking);
+                statsReadAdd(&(pContainer->socket), x);
+                if (x < 0) {
+                    // Set errno
+                    errnoLocal = -x;
                 } else {
-                    if ((pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ) ||
-                        (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
-                        // Socket is shut down
-                        errnoLocal = U_SOCK_ESHUTDOWN;
-                    } else if (pContainer->socket.state == U_SOCK_STATE_CLOSING) {
-                        // Not connected mate
-                        errnoLocal = U_SOCK_ENOTCONN;
-                    } else {
-                        // No route to host?
-                        errnoLocal = U_SOCK_EHOSTUNREACH;
+                    pDatagrams->sizeBytes = x;
+                    errorCodeOrCount = 1;
+                    // Then whatever else is already waiting
+                    devHandle = pContainer->socket.devHandle;
+                    sockHandle = pContainer->socket.sockHandle;
+                    devType = uDeviceGetDeviceType(devHandle);
+                    if ((devType == (int32_t) U_DEVICE_TYPE_CELL) && (numDatagrams > 1)) {
+                        // All under one AT lock
+                        x = uCellSockReceiveFromMany(devHandle, sockHandle,
+                                                     pDatagrams + 1,
+                                                     numDatagrams - 1);
+                        for (int32_t y = 0; y < x; y++) {
+                            statsReadAdd(&(pContainer->socket),
+                                         (pDatagrams + 1 + y)->sizeBytes);
+                            errorCodeOrCount++;
+                        }
+                    } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+                        for (size_t y = 1; (y < numDatagrams) && (x >= 0); y++) {
+                            x = uWifiSockReceiveFrom(devHandle, sockHandle,
+                                                     (pDatagrams + y)->pRemoteAddress,
+                                                     (pDatagrams + y)->pData,
+                                                     (pDatagrams + y)->dataSizeBytes);
+                            if (x >= 0) {
+                                (pDatagrams + y)->sizeBytes = x;
+                                statsReadAdd(&(pContainer->socket), x);
+                                errorCodeOrCount++;
+                            }
+                        }
                     }
+                    // There may be another datagram waiting
+                    pollEventsAdd(pContainer, U_SOCK_POLL_EVENT_READ);
                 }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gMutexContainer);
-    }
+        U_PORT_MUTEX_UNLOCK(gMutexContainer);
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    return errorCodeOrCount;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: STREAM (TCP)
+ * -------------------------------------------------------------- */
+
+// Send data.
+int32_t uSockWrite(uSockDescriptor_t descriptor,
+                   const void *pData, size_t dataSizeBytes)
+{
+    uSockIoVec_t ioVec;
 
-    if (errnoLocal != U_SOCK_ENONE) {
-        // Write the errno
-        errno = errnoLocal;
-        errorCodeOrSize = (int32_t) U_ERROR_COMMON_BSD_ERROR;
-    }
+    ioVec.pBase = (void *) pData;
+    ioVec.length = dataSizeBytes;
 
-    return errorCodeOrSize;
+    return writeIoVec(descriptor, &ioVec, 1);
 }
 
-// Receive data.
-int32_t uSockRead(uSockDescriptor_t descriptor,
-                  void *pData, size_t dataSizeBytes)
+// Send anything waiting in the coalescing buffer.
+int32_t uSockFlush(uSockDescriptor_t descriptor)
 {
-    int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
     int32_t errnoLocal;
     uSockContainer_t *pContainer = NULL;
 
@@ -2242,38 +3771,13 @@ int32_t uSockRead(uSockDescriptor_t descriptor,
         errnoLocal = U_SOCK_EBADF;
         pContainer = pContainerFindByDescriptor(descriptor);
         if (pContainer != NULL) {
-            errnoLocal = U_SOCK_EPROTOTYPE;
-            if (pContainer->socket.protocol == U_SOCK_PROTOCOL_TCP) {
+            errnoLocal = U_SOCK_ENONE;
+            if (pContainer->socket.coalesceLength > 0) {
                 if (pContainer->socket.state == U_SOCK_STATE_CONNECTED) {
-                    errnoLocal = U_SOCK_EINVAL;
-                    if (((pData == NULL) && (dataSizeBytes > 0)) ||
-                        (dataSizeBytes > INT_MAX)) {
-                        // Invalid argument
-                    } else {
-                        errnoLocal = U_SOCK_ENONE;
-                        if ((pData != NULL) && (dataSizeBytes != 0)) {
-                            // Receive the datagram
-                            errorCodeOrSize = receive(pContainer,
-                                                      NULL, pData,
-                                                      dataSizeBytes);
-                            if (errorCodeOrSize < 0) {
-                                // Set errno
-                                errnoLocal = -errorCodeOrSize;
-                            }
-                        }
-                    }
+                    errnoLocal = coalesceFlush(&(pContainer->socket));
                 } else {
-                    if ((pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ) ||
-                        (pContainer->socket.state == U_SOCK_STATE_SHUTDOWN_FOR_READ_WRITE)) {
-                        // Socket is shut down
-                        errnoLocal = U_SOCK_ESHUTDOWN;
-                    } else if (pContainer->socket.state == U_SOCK_STATE_CLOSING) {
-                        // Not connected mate
-                        errnoLocal = U_SOCK_ENOTCONN;
-                    } else {
-                        // No route to host?
-                        errnoLocal = U_SOCK_EHOSTUNREACH;
-                    }
+                    // The data can no longer be sent
+                    errnoLocal = U_SOCK_ENOTCONN;
                 }
             }
         }
@@ -2284,10 +3788,22 @@ int32_t uSockRead(uSockDescriptor_t descriptor,
     if (errnoLocal != U_SOCK_ENONE) {
         // Write the errno
         errno = errnoLocal;
-        errorCodeOrSize = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+        errorCode = (int32_t) U_ERROR_COMMON_BSD_ERROR;
     }
 
-    return errorCodeOrSize;
+    return errorCode;
+}
+
+// Receive data.
+int32_t uSockRead(uSockDescriptor_t descriptor,
+                  void *pData, size_t dataSizeBytes)
+{
+    uSockIoVec_t ioVec;
+
+    ioVec.pBase = pData;
+    ioVec.length = dataSizeBytes;
+
+    return readIoVec(descriptor, &ioVec, 1);
 }
 
 // Prepare a TCP socket for being closed.
@@ -2309,6 +3825,11 @@ int32_t uSockShutdown(uSockDescriptor_t descriptor,
         errnoLocal = U_SOCK_EBADF;
         pContainer = pContainerFindByDescriptor(descriptor);
         if (pContainer != NULL) {
+            if (how != U_SOCK_SHUTDOWN_READ) {
+                // Anything waiting to be coalesced must go
+                // before writes are blocked
+                coalesceFlush(&(pContainer->socket));
+            }
             // Set the socket state
             switch (how) {
                 case U_SOCK_SHUTDOWN_READ:
@@ -2341,6 +3862,64 @@ int32_t uSockShutdown(uSockDescriptor_t descriptor,
     return errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: SCATTER-GATHER
+ * -------------------------------------------------------------- */
+
+// Send data held in several fragments.
+int32_t uSockSendv(uSockDescriptor_t descriptor,
+                   const uSockAddress_t *pRemoteAddress,
+                   const uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t errorCodeOrSize;
+
+    if ((pRemoteAddress != NULL) || isUdp(descriptor)) {
+        errorCodeOrSize = sendToIoVec(descriptor, pRemoteAddress,
+                                      pIoVec, numIoVec);
+    } else {
+        errorCodeOrSize = writeIoVec(descriptor, pIoVec, numIoVec);
+    }
+
+    return errorCodeOrSize;
+}
+
+// Receive data into several fragments.
+int32_t uSockReceivev(uSockDescriptor_t descriptor,
+                      uSockAddress_t *pRemoteAddress,
+                      const uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t errorCodeOrSize;
+
+    if ((pRemoteAddress != NULL) || isUdp(descriptor)) {
+        errorCodeOrSize = receiveFromIoVec(descriptor, pRemoteAddress,
+                                           pIoVec, numIoVec);
+    } else {
+        errorCodeOrSize = readIoVec(descriptor, pIoVec, numIoVec);
+    }
+
+    return errorCodeOrSize;
+}
+
+// Get the total length of the fragments of an I/O vector.
+int32_t uSockIoVecLength(const uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if ((pIoVec == NULL) && (numIoVec > 0)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+    for (size_t x = 0; (x < numIoVec) && (errorCodeOrLength >= 0); x++) {
+        if ((((pIoVec + x)->pBase == NULL) && ((pIoVec + x)->length > 0)) ||
+            ((pIoVec + x)->length > (size_t) (INT_MAX - errorCodeOrLength))) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        } else {
+            errorCodeOrLength += (int32_t) (pIoVec + x)->length;
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: ASYNC
  * -------------------------------------------------------------- */
@@ -2456,6 +4035,274 @@ void uSockRegisterCallbackClosed(uSockDescriptor_t descriptor,
     }
 }
 
+// Connect to a server without blocking.
+int32_t uSockConnectAsync(uSockDescriptor_t descriptor,
+                          const uSockAddress_t *pRemoteAddress,
+                          void (*pCallback) (void *, int32_t),
+                          void *pCallbackParameter)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errnoLocal;
+    uSockContainer_t *pContainer = NULL;
+    uDeviceHandle_t devHandle = NULL;
+    int32_t sockHandle = -1;
+    bool completed = false;
+#if U_CFG_ENABLE_LOGGING
+    char buffer[U_SOCK_ADDRESS_STRING_MAX_LENGTH_BYTES];
+#endif
+
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+        errnoLocal = U_SOCK_EINVAL;
+        // Check that the remote IP address is sensible
+        if (pRemoteAddress != NULL) {
+
+            U_PORT_MUTEX_LOCK(gMutexContainer);
+
+            // Find the container
+            pContainer = pContainerFindByDescriptor(descriptor);
+            errnoLocal = U_SOCK_EBADF;
+            if (pContainer != NULL) {
+                errnoLocal = U_SOCK_EPERM;
+                if (pContainer->socket.state == U_SOCK_STATE_CONNECTING) {
+                    errnoLocal = U_SOCK_EALREADY;
+                } else if (pContainer->socket.state == U_SOCK_STATE_CREATED) {
+                    devHandle = pContainer->socket.devHandle;
+                    sockHandle = pContainer->socket.sockHandle;
+                    errnoLocal = U_SOCK_ENONE;
+                    uPortLog("U_SOCK: connecting socket asynchronously to \"%.*s\"...\n",
+                             addressToString(pRemoteAddress, true,
+                                             buffer, sizeof(buffer)),
+                             buffer);
+                    // Everything must be in place before the
+                    // underlying layer is called since the
+                    // connection may complete at any time
+                    // after that
+                    memcpy(&pContainer->socket.remoteAddress,
+                           pRemoteAddress,
+                           sizeof(pContainer->socket.remoteAddress));
+                    U_PORT_MUTEX_LOCK(gMutexCallbacks);
+                    pContainer->socket.pConnectCallback = pCallback;
+                    pContainer->socket.pConnectCallbackParameter = pCallbackParameter;
+                    U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+                    pContainer->socket.state = U_SOCK_STATE_CONNECTING;
+                    // uXxxSockConnect[Async]() returns a negated
+                    // value of errno from the U_SOCK_Exxx list
+                    errorCode = -U_SOCK_ENOSYS;
+                    int32_t devType = uDeviceGetDeviceType(devHandle);
+                    if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+                        errorCode = uCellSockConnectAsync(devHandle,
+                                                          sockHandle,
+                                                          pRemoteAddress,
+                                                          connectCallback);
+                        if (errorCode == -U_SOCK_ENOSYS) {
+                            // Not supported by this module, have
+                            // to do it the blocking way
+                            errorCode = uCellSockConnect(devHandle,
+                                                         sockHandle,
+                                                         pRemoteAddress);
+                            completed = (errorCode == 0);
+                        }
+                    } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+                        errorCode = uWifiSockConnect(devHandle,
+                                                     sockHandle,
+                                                     pRemoteAddress);
+                        completed = (errorCode == 0);
+                    }
+
+                    if (errorCode != 0) {
+                        // Failed to even start, put things back
+                        errnoLocal = -errorCode;
+                        U_PORT_MUTEX_LOCK(gMutexCallbacks);
+                        pContainer->socket.pConnectCallback = NULL;
+                        pContainer->socket.pConnectCallbackParameter = NULL;
+                        U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+                        memset(&(pContainer->socket.remoteAddress), 0,
+                               sizeof(pContainer->socket.remoteAddress));
+                        pContainer->socket.state = U_SOCK_STATE_CREATED;
+                        uPortLog("U_SOCK: underlying layer errno %d on"
+                                 " address \"%.*s\", descriptor/"
+                                 "network/socket %d/0x%08x/%d.\n", errnoLocal,
+                                 addressToString(pRemoteAddress, true,
+                                                 buffer, sizeof(buffer)),
+                                 buffer, descriptor, devHandle,
+                                 sockHandle);
+                    }
+                }
+            }
+
+            U_PORT_MUTEX_UNLOCK(gMutexContainer);
+
+            if (completed) {
+                // The connection was made synchronously: complete
+                // it here, outside the container mutex in case the
+                // callback calls back into this API
+                connectCallback(devHandle, sockHandle, U_SOCK_ENONE);
+            }
+        }
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCode = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: POLL
+ * -------------------------------------------------------------- */
+
+// Register interest in events on a socket.
+int32_t uSockPollSet(uSockDescriptor_t descriptor, uint32_t eventMask)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errnoLocal;
+    uSockContainer_t *pContainer = NULL;
+    uDeviceHandle_t devHandle;
+    int32_t sockHandle;
+
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+        errnoLocal = U_SOCK_EINVAL;
+        if ((eventMask & ~(U_SOCK_POLL_EVENT_READ | U_SOCK_POLL_EVENT_WRITE |
+                           U_SOCK_POLL_EVENT_CLOSED | U_SOCK_POLL_EVENT_ERROR)) == 0) {
+
+            U_PORT_MUTEX_LOCK(gMutexContainer);
+
+            // Find the container
+            errnoLocal = U_SOCK_EBADF;
+            pContainer = pContainerFindByDescriptor(descriptor);
+            if (pContainer != NULL) {
+                errnoLocal = U_SOCK_ENONE;
+                if (eventMask != 0) {
+                    U_PORT_MUTEX_LOCK(gMutexCallbacks);
+
+                    // Talk to the underlying cell/wifi socket
+                    // layer to make sure that it tells us about
+                    // incoming data and closure; it is harmless
+                    // to do this again if the application has
+                    // already registered callbacks.
+                    devHandle = pContainer->socket.devHandle;
+                    sockHandle = pContainer->socket.sockHandle;
+                    errnoLocal = U_SOCK_ENOSYS;
+                    int32_t devType = uDeviceGetDeviceType(devHandle);
+                    if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+                        uCellSockRegisterCallbackData(devHandle,
+                                                      sockHandle,
+                                                      dataCallback);
+                        uCellSockRegisterCallbackClosed(devHandle,
+                                                        sockHandle,
+                                                        closedCallback);
+                        errnoLocal = U_SOCK_ENONE;
+                    } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+                        errnoLocal = -uWifiSockRegisterCallbackData(devHandle,
+                                                                    sockHandle,
+                                                                    dataCallback);
+                        if (errnoLocal == U_SOCK_ENONE) {
+                            errnoLocal = -uWifiSockRegisterCallbackClosed(devHandle,
+                                                                          sockHandle,
+                                                                          closedCallback);
+                        }
+                    }
+
+                    U_PORT_MUTEX_UNLOCK(gMutexCallbacks);
+                }
+
+                if (errnoLocal == U_SOCK_ENONE) {
+                    U_PORT_MUTEX_LOCK(gMutexPoll);
+                    // Start again with the new mask
+                    pollReadyRemove(pContainer);
+                    pContainer->socket.pollEventMask = eventMask;
+                    U_PORT_MUTEX_UNLOCK(gMutexPoll);
+                    // Report whatever the socket could do now:
+                    // data may have arrived before we were asked
+                    pollEventsAdd(pContainer,
+                                  pollEventsFromState(&(pContainer->socket)));
+                }
+            }
+
+            U_PORT_MUTEX_UNLOCK(gMutexContainer);
+        }
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCode = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    return errorCode;
+}
+
+// Wait for one or more registered sockets to become ready.
+int32_t uSockPollWait(uSockPollEvent_t *pEvents, size_t maxNumEvents,
+                      int32_t timeMs)
+{
+    int32_t errorCodeOrNum = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t errnoLocal;
+    uSockContainer_t *pContainer;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    int32_t waitMs;
+    size_t num = 0;
+    bool keepGoing;
+
+    errnoLocal = init();
+    if (errnoLocal == U_SOCK_ENONE) {
+        errnoLocal = U_SOCK_EINVAL;
+        if ((pEvents != NULL) && (maxNumEvents > 0)) {
+            errnoLocal = U_SOCK_ENONE;
+            do {
+                U_PORT_MUTEX_LOCK(gMutexPoll);
+
+                // Take what is ready from the front of the
+                // list; anything that doesn't fit stays
+                // there for the next call
+                while ((gpPollReadyListHead != NULL) && (num < maxNumEvents)) {
+                    pContainer = gpPollReadyListHead;
+                    gpPollReadyListHead = pContainer->pNextPollReady;
+                    if (gpPollReadyListHead == NULL) {
+                        gpPollReadyListTail = NULL;
+                    }
+                    pContainer->pNextPollReady = NULL;
+                    pContainer->isPollReady = false;
+                    (pEvents + num)->descriptor = pContainer->descriptor;
+                    (pEvents + num)->events = pContainer->socket.pollEvents;
+                    pContainer->socket.pollEvents = 0;
+                    num++;
+                }
+
+                U_PORT_MUTEX_UNLOCK(gMutexPoll);
+
+                waitMs = timeMs - (uPortGetTickTimeMs() - startTimeMs);
+                keepGoing = (num == 0) && ((timeMs < 0) || (waitMs > 0));
+                if (keepGoing) {
+                    // Block until pollEventsAdd() gives the
+                    // semaphore; it may have been given for
+                    // something we've already taken, in which
+                    // case we just go around again
+                    if (timeMs < 0) {
+                        uPortSemaphoreTake(gSemaphorePoll);
+                    } else {
+                        uPortSemaphoreTryTake(gSemaphorePoll, waitMs);
+                    }
+                }
+            } while (keepGoing);
+            errorCodeOrNum = (int32_t) num;
+        }
+    }
+
+    if (errnoLocal != U_SOCK_ENONE) {
+        // Write the errno
+        errno = errnoLocal;
+        errorCodeOrNum = (int32_t) U_ERROR_COMMON_BSD_ERROR;
+    }
+
+    return errorCodeOrNum;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TCP INCOMING (TCP SERVER) ONLY
  * -------------------------------------------------------------- */
@@ -2619,6 +4466,8 @@ int32_t uSockGetHostByName(uDeviceHandle_t devHandle,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
     int32_t errnoLocal;
+    bool useCache = false;
+    uSockAddress_t address;
 
     errnoLocal = init();
     if (errnoLocal == U_SOCK_ENONE) {
@@ -2626,26 +4475,46 @@ int32_t uSockGetHostByName(uDeviceHandle_t devHandle,
         // Check parameters
         if ((pHostName != NULL) && (pHostIpAddress != NULL)) {
 
-            U_PORT_MUTEX_LOCK(gMutexContainer);
+            // Don't clutter the cache with IP addresses
+            useCache = (uSockStringToAddress(pHostName, &address) < 0);
+            errnoLocal = -1;
+            if (useCache) {
+                U_PORT_MUTEX_LOCK(gMutexDnsCache);
+                errnoLocal = dnsCacheFind(devHandle, pHostName,
+                                          pHostIpAddress);
+                U_PORT_MUTEX_UNLOCK(gMutexDnsCache);
+            }
 
-            int32_t devType = uDeviceGetDeviceType(devHandle);
+            if (errnoLocal < 0) {
 
-            // Talk to the underlying cell/wifi
-            // socket layer to do the DNS look-up.
-            // uXxxSockGetHostByName() returns a negated
-            // value from the U_SOCK_Exxx list.
-            errnoLocal = U_SOCK_ENOSYS;
-            if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
-                errnoLocal = -uCellSockGetHostByName(devHandle,
-                                                     pHostName,
-                                                     pHostIpAddress);
-            } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
-                errnoLocal = -uWifiSockGetHostByName(devHandle,
-                                                     pHostName,
-                                                     pHostIpAddress);
-            }
+                U_PORT_MUTEX_LOCK(gMutexContainer);
 
-            U_PORT_MUTEX_UNLOCK(gMutexContainer);
+                int32_t devType = uDeviceGetDeviceType(devHandle);
+
+                // Talk to the underlying cell/wifi
+                // socket layer to do the DNS look-up.
+                // uXxxSockGetHostByName() returns a negated
+                // value from the U_SOCK_Exxx list.
+                errnoLocal = U_SOCK_ENOSYS;
+                if (devType == (int32_t) U_DEVICE_TYPE_CELL) {
+                    errnoLocal = -uCellSockGetHostByName(devHandle,
+                                                         pHostName,
+                                                         pHostIpAddress);
+                } else if (devType == (int32_t) U_DEVICE_TYPE_SHORT_RANGE) {
+                    errnoLocal = -uWifiSockGetHostByName(devHandle,
+                                                         pHostName,
+                                                         pHostIpAddress);
+                }
+
+                U_PORT_MUTEX_UNLOCK(gMutexContainer);
+
+                if (useCache) {
+                    U_PORT_MUTEX_LOCK(gMutexDnsCache);
+                    dnsCacheStore(devHandle, pHostName,
+                                  pHostIpAddress, errnoLocal);
+                    U_PORT_MUTEX_UNLOCK(gMutexDnsCache);
+                }
+            }
         }
     }
 
@@ -2658,6 +4527,29 @@ int32_t uSockGetHostByName(uDeviceHandle_t devHandle,
     return errorCode;
 }
 
+// Flush the DNS cache.
+void uSockDnsCacheFlush(uDeviceHandle_t devHandle)
+{
+    // The mutex is created by init() and never deleted: if it
+    // isn't there then nothing can have been cached
+    if (gMutexDnsCache != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutexDnsCache);
+
+#if U_SOCK_DNS_CACHE_NUM_ENTRIES > 0
+        for (size_t x = 0; x < sizeof(gDnsCache) / sizeof(gDnsCache[0]); x++) {
+            if ((devHandle == NULL) || (gDnsCache[x].devHandle == devHandle)) {
+                gDnsCache[x].devHandle = NULL;
+            }
+        }
+#else
+        (void) devHandle;
+#endif
+
+        U_PORT_MUTEX_UNLOCK(gMutexDnsCache);
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: ADDRESS CONVERSION
  * -------------------------------------------------------------- */
@@ -49,9 +49,13 @@ type Argument struct {
 	ServerPort string `json:"server-port"`
 	ServerCert string `json:"server-certificate-location"`
 	ServerKey  string `json:"server-key-location"`
+	// "echo" (the default), "discard" to read and throw away
+	// everything received or "source" to send data as fast as
+	// the connection will take it, for throughput testing
+	Mode       string `json:"mode"`
 }
 
-func secureEcho(certPath string, keyPath string, port string, verbose bool) {
+func secureEcho(certPath string, keyPath string, port string, mode string, verbose bool) {
 
 	// load certificates
 	serverCert, err := tls.LoadX509KeyPair(certPath, keyPath)
@@ -74,19 +78,19 @@ func secureEcho(certPath string, keyPath string, port string, verbose bool) {
 	}
 
 	tlsConfig.Rand = rand.Reader
-	echoServerThread(port, &tlsConfig, verbose)
+	echoServerThread(port, &tlsConfig, mode, verbose)
 }
 
-func echoServerThread(port string, tlsConfig *tls.Config, verbose bool) {
+func echoServerThread(port string, tlsConfig *tls.Config, mode string, verbose bool) {
 	// listen on all interfaces
 	var echoServer net.Listener
 	var err error
 	if tlsConfig != nil {
 		echoServer, err = tls.Listen("tcp", ":"+port, tlsConfig)
-		log.Println("Opening secure TCP server listening to port " + port)
+		log.Println("Opening secure TCP " + mode + " server listening to port " + port)
 	} else {
 		echoServer, err = net.Listen("tcp", ":"+port)
-		log.Println("Opening unsecure TCP server listening to port " + port)
+		log.Println("Opening unsecure TCP " + mode + " server listening to port " + port)
 	}
 
 	if err != nil {
@@ -101,7 +105,14 @@ func echoServerThread(port string, tlsConfig *tls.Config, verbose bool) {
 		if err != nil {
 			log.Printf("Error %s while trying to connect.", err)
 		} else {
-			go readWrite(connection, verbose)
+			switch mode {
+			case "discard":
+				go discard(connection, verbose)
+			case "source":
+				go source(connection, verbose)
+			default:
+				go readWrite(connection, verbose)
+			}
 		}
 	}
 }
@@ -135,12 +146,61 @@ func readWrite(connection net.Conn, verbose bool) {
 	}
 }
 
+// Read and throw away everything received, counting it.
+func discard(connection net.Conn, verbose bool) {
+	defer connection.Close()
+	buffer := make([]byte, 4096)
+	total := 0
+	for {
+		connection.SetReadDeadline(time.Now().Add(readTimeoutSecond * time.Second))
+		readBytes, err := connection.Read(buffer)
+		if err != nil {
+			if err != io.EOF {
+				log.Printf("Error %s while reading data. Expected an EOF to signal end of connection", err)
+			}
+			break
+		}
+		total += readBytes
+		if verbose {
+			log.Printf("Discarded %d bytes.", readBytes)
+		}
+	}
+	log.Printf("Discarded %d bytes in total.", total)
+}
+
+// Send a repeating pattern, as fast as the connection will take
+// it, until the far end closes the connection.
+func source(connection net.Conn, verbose bool) {
+	defer connection.Close()
+	buffer := make([]byte, 4096)
+	for x := range buffer {
+		buffer[x] = byte('0' + (x % 10))
+	}
+	total := 0
+	for {
+		connection.SetWriteDeadline(time.Now().Add(readTimeoutSecond * time.Second))
+		writeBytes, err := connection.Write(buffer)
+		total += writeBytes
+		if err != nil {
+			break
+		}
+		if verbose {
+			log.Printf("Sourced %d bytes.", writeBytes)
+		}
+	}
+	log.Printf("Sourced %d bytes in total.", total)
+}
+
 func startup(config Argument) {
-	log.Println("Starting TCP Echo application...")
+	mode := config.Mode
+	if mode == "" {
+		mode = "echo"
+	}
+	log.Println("Starting TCP " + mode + " application...")
 	if config.Secure {
-		secureEcho(config.ServerCert, config.ServerKey, config.ServerPort, config.Verbose)
+		secureEcho(config.ServerCert, config.ServerKey, config.ServerPort, mode, config.Verbose)
 	}
-	echoServerThread(config.ServerPort, nil, config.Verbose)
+	echoServerThread(config.ServerPort, nil, mode, config.Verbose)
 }
 
 func logSetup() {
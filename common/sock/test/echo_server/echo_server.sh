@@ -4,3 +4,8 @@
 ./echo_server -config config.json >/dev/null 2>&1 &
 ./echo_server -config config_secure.json >/dev/null 2>&1 &
 ./echo_server_udp -config config_udp.json >/dev/null 2>&1 &
+
+# Run the throughput servers
+./echo_server -config config_discard.json >/dev/null 2>&1 &
+./echo_server -config config_source.json >/dev/null 2>&1 &
+./echo_server_udp -config config_udp_discard.json >/dev/null 2>&1 &
@@ -40,9 +40,12 @@ type Argument struct {
 	Verbose    bool   `json:"verbose"`
 	Logging    bool   `json:"logging"`
 	ServerPort string `json:"server-port"`
+	// "echo" (the default) or "discard" to read and throw away
+	// everything received, for throughput testing
+	Mode       string `json:"mode"`
 }
 
-func echoServerThread(port string, verbose bool) {
+func echoServerThread(port string, discard bool, verbose bool) {
 	var err error
 	log.Println("Opening UDP server listening to port " + port)
 
@@ -69,6 +72,9 @@ func echoServerThread(port string, verbose bool) {
 						log.Printf("Message:\n %s\n from %s", buffer, addr)
 					}
 				}
+				if discard {
+					continue
+				}
 				writeBytes, err := connection.WriteTo(buffer[:readBytes], addr)
 				if err != nil {
 					log.Printf("Failed to send data with error: %s ", err)
@@ -85,7 +91,7 @@ func echoServerThread(port string, verbose bool) {
 
 func startup(config Argument) {
 	log.Println("Starting UDP Echo application...")
-	echoServerThread(config.ServerPort, config.Verbose)
+	echoServerThread(config.ServerPort, config.Mode == "discard", config.Verbose)
 }
 
 func logSetup() {
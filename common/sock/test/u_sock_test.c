@@ -43,6 +43,7 @@
 #include "stdbool.h"
 #include "sys/time.h"      // struct timeval in most cases
 #include "string.h"        // strncpy(), strcmp(), memcpy(), memset()
+#include "stdio.h"         // snprintf()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_app_platform_specific.h"
@@ -57,6 +58,8 @@
 #include "u_port_os.h"
 #include "u_port_event_queue.h"
 
+#include "u_at_client.h" // For the AT command count of the throughput benchmark
+
 #include "u_network.h"                  // In order to provide a comms
 #include "u_network_test_shared_cfg.h"  // path for the socket
 
@@ -64,6 +67,8 @@
 #include "u_sock.h"
 #include "u_sock_test_shared_cfg.h"
 
+#include "u_bench.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -157,6 +162,29 @@
 # define U_SOCK_TEST_TIME_MARGIN_MINUS_MS 100
 #endif
 
+#ifndef U_SOCK_TEST_THROUGHPUT_DURATION_SECONDS
+/** How long to run each direction of the throughput benchmark,
+ * sockBenchThroughput, for.
+ */
+# define U_SOCK_TEST_THROUGHPUT_DURATION_SECONDS 10
+#endif
+
+#ifndef U_SOCK_TEST_THROUGHPUT_NUM_LATENCIES
+/** The number of uSockWrite()/uSockSendTo()/uSockRead() call
+ * times that the throughput benchmark keeps to work out the
+ * percentiles from; if there are more calls than this the
+ * most recent are kept.
+ */
+# define U_SOCK_TEST_THROUGHPUT_NUM_LATENCIES 256
+#endif
+
+#ifndef U_SOCK_TEST_THROUGHPUT_AT_LATENCY_ENTRIES
+/** The number of entries in the AT client latency statistics
+ * used by the throughput benchmark to count the AT commands sent.
+ */
+# define U_SOCK_TEST_THROUGHPUT_AT_LATENCY_ENTRIES 16
+#endif
+
 // Do some cross-checking
 #ifdef U_AT_CLIENT_URC_TASK_PRIORITY
 # if (U_AT_CLIENT_URC_TASK_PRIORITY) <= (U_SOCK_TEST_TASK_PRIORITY)
@@ -320,6 +348,14 @@ static const char gAllChars[] = "the quick brown fox jumps over the lazy dog "
                                 "\x1d\x1e!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~\x7f"
                                 "\r\nOK\r\n \r\nERROR\r\n \r\nABORTED\r\n";
 
+/** The call times kept by the throughput benchmark.
+ */
+static int32_t gThroughputLatencyMs[U_SOCK_TEST_THROUGHPUT_NUM_LATENCIES];
+
+/** The buffer used by the throughput benchmark.
+ */
+static char gThroughputBuffer[U_SOCK_TEST_MAX_TCP_READ_WRITE_SIZE];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -676,8 +712,10 @@ static size_t sendTcp(uSockDescriptor_t descriptor,
     startTimeMs = uPortGetTickTimeMs();
     while ((sentSizeBytes < sizeBytes) &&
            ((uPortGetTickTimeMs() - startTimeMs) < 10000)) {
+        uBenchEnergyBegin("sockWrite");
         x = uSockWrite(descriptor, (const void *) pData,
                        sizeBytes - sentSizeBytes);
+        uBenchEnergyEnd("sockWrite");
         if (x > 0) {
             // Note: the underlying cellular/Wi-Fi layers
             // chunk the data anyway but we do the recursive
@@ -693,6 +731,31 @@ static size_t sendTcp(uSockDescriptor_t descriptor,
     return sentSizeBytes;
 }
 
+// Read TCP data until sizeBytes have arrived or timeoutMs passes
+static size_t readTcp(uSockDescriptor_t descriptor,
+                      char *pData, size_t sizeBytes,
+                      int32_t timeoutMs)
+{
+    int32_t x;
+    size_t readSizeBytes = 0;
+    int32_t startTimeMs;
+
+    startTimeMs = uPortGetTickTimeMs();
+    while ((readSizeBytes < sizeBytes) &&
+           ((uPortGetTickTimeMs() - startTimeMs) < timeoutMs)) {
+        x = uSockRead(descriptor, (void *) (pData + readSizeBytes),
+                      sizeBytes - readSizeBytes);
+        if (x > 0) {
+            readSizeBytes += x;
+        }
+    }
+    // A read that times out sets errno but that
+    // is not a failure here
+    errno = 0;
+
+    return readSizeBytes;
+}
+
 // Open a socket and use it; currently only UDP is supported.
 static uSockDescriptor_t openSocketAndUseIt(uDeviceHandle_t devHandle,
                                             const uSockAddress_t *pRemoteAddress,
@@ -743,6 +806,15 @@ static void setBoolCallback(void *pParameter)
     }
 }
 
+// Callback to store the result of an asynchronous
+// connection in the passed-in int32_t.
+static void connectResultCallback(void *pParameter, int32_t errnoLocal)
+{
+    if (pParameter != NULL) {
+        *((int32_t *) pParameter) = errnoLocal;
+    }
+}
+
 // Callback to send to event queue triggered by
 // data arriving.
 //lint -e{818} Suppress could be const, need to follow
@@ -759,6 +831,143 @@ static void sendToEventQueue(void *pParameter)
                         &pParameter, sizeof(uSockTestConfig_t *));
 }
 
+// Run one direction of the throughput benchmark for
+// U_SOCK_TEST_THROUGHPUT_DURATION_SECONDS: if isWrite is true
+// write to pRemoteAddress as fast as uSockWrite()/uSockSendTo()
+// will go, else read from it as fast as uSockRead() will go, then
+// report the throughput, the number of AT commands that each
+// megabyte took and percentiles of the time each call took.
+static void throughputRun(uDeviceHandle_t devHandle,
+                          const uSockAddress_t *pRemoteAddress,
+                          bool isTcp, bool isWrite,
+                          const char *pName)
+{
+    uSockDescriptor_t descriptor;
+    uAtClientHandle_t atHandle;
+    uAtClientLatencyEntry_t entry;
+    uBench_t bench;
+    bool closedCallbackCalled = false;
+    size_t blockSizeBytes = U_SOCK_TEST_MAX_TCP_READ_WRITE_SIZE;
+    size_t numCalls = 0;
+    size_t numLatencies;
+    uint32_t totalBytes = 0;
+    uint32_t numAtCommands = 0;
+    int32_t bitsPerSecond;
+    int32_t startTimeMs;
+    int32_t callStartTimeMs;
+    int32_t errorCode = -1;
+    int32_t latencyMs;
+    size_t y;
+
+    if (isTcp) {
+        descriptor = uSockCreate(devHandle, U_SOCK_TYPE_STREAM,
+                                 U_SOCK_PROTOCOL_TCP);
+    } else {
+        descriptor = uSockCreate(devHandle, U_SOCK_TYPE_DGRAM,
+                                 U_SOCK_PROTOCOL_UDP);
+        blockSizeBytes = U_SOCK_TEST_MAX_UDP_PACKET_SIZE;
+    }
+    U_PORT_TEST_ASSERT(descriptor >= 0);
+    uSockRegisterCallbackClosed(descriptor, setBoolCallback,
+                                &closedCallbackCalled);
+    if (isTcp) {
+        // Connections can fail so allow this a few goes
+        for (y = 2; (y > 0) && (errorCode < 0); y--) {
+            errorCode = uSockConnect(descriptor, pRemoteAddress);
+            if (errorCode < 0) {
+                errno = 0;
+            }
+        }
+        U_PORT_TEST_ASSERT(errorCode == 0);
+    }
+
+    // Count the AT commands, if there are any
+    atHandle = (uAtClientHandle_t) pUNetworkTestAtClientGet(devHandle);
+    if (atHandle != NULL) {
+        U_PORT_TEST_ASSERT(uAtClientLatencyStart(atHandle,
+                                                 U_SOCK_TEST_THROUGHPUT_AT_LATENCY_ENTRIES) == 0);
+    }
+
+    memcpy(gThroughputBuffer, gSendData, blockSizeBytes);
+    U_TEST_PRINT_LINE("%s: %s in blocks of %d byte(s) for %d second(s)...",
+                      pName, isWrite ? "writing" : "reading", blockSizeBytes,
+                      U_SOCK_TEST_THROUGHPUT_DURATION_SECONDS);
+    uBenchStart(&bench, pName);
+    startTimeMs = uPortGetTickTimeMs();
+    while (uPortGetTickTimeMs() - startTimeMs < U_SOCK_TEST_THROUGHPUT_DURATION_SECONDS * 1000) {
+        callStartTimeMs = uPortGetTickTimeMs();
+        if (!isWrite) {
+            errorCode = uSockRead(descriptor, gThroughputBuffer, blockSizeBytes);
+        } else if (isTcp) {
+            errorCode = uSockWrite(descriptor, gThroughputBuffer, blockSizeBytes);
+        } else {
+            errorCode = uSockSendTo(descriptor, pRemoteAddress,
+                                    gThroughputBuffer, blockSizeBytes);
+        }
+        if (errorCode > 0) {
+            totalBytes += errorCode;
+            gThroughputLatencyMs[numCalls % U_SOCK_TEST_THROUGHPUT_NUM_LATENCIES] =
+                uPortGetTickTimeMs() - callStartTimeMs;
+            numCalls++;
+        }
+        // A read that times out sets errno but that
+        // is not a failure here
+        errno = 0;
+    }
+    bitsPerSecond = uBenchStop(&bench, (int32_t) numCalls, totalBytes, "bytes") * 8;
+
+    if (atHandle != NULL) {
+        for (y = 0; uAtClientLatencyGet(atHandle, y, &entry) >= 0; y++) {
+            if (!entry.isUrc) {
+                numAtCommands += entry.count;
+            }
+        }
+        uAtClientLatencyStop(atHandle);
+    }
+
+    // Sort the call times to get the percentiles
+    numLatencies = numCalls;
+    if (numLatencies > U_SOCK_TEST_THROUGHPUT_NUM_LATENCIES) {
+        numLatencies = U_SOCK_TEST_THROUGHPUT_NUM_LATENCIES;
+    }
+    for (size_t x = 1; x < numLatencies; x++) {
+        latencyMs = gThroughputLatencyMs[x];
+        for (y = x; (y > 0) && (gThroughputLatencyMs[y - 1] > latencyMs); y--) {
+            gThroughputLatencyMs[y] = gThroughputLatencyMs[y - 1];
+        }
+        gThroughputLatencyMs[y] = latencyMs;
+    }
+
+    U_TEST_PRINT_LINE("%s: %u byte(s) in %d call(s), %d.%03d Mbits/s.",
+                      pName, totalBytes, numCalls, bitsPerSecond / 1000000,
+                      (bitsPerSecond / 1000) % 1000);
+    if ((atHandle != NULL) && (totalBytes > 0)) {
+        U_TEST_PRINT_LINE("%s: %u AT command(s), %u per MByte.", pName,
+                          numAtCommands,
+                          (uint32_t) (((uint64_t) numAtCommands * 1000000) / totalBytes));
+    }
+    if (numLatencies > 0) {
+        U_TEST_PRINT_LINE("%s: call time p50 %d ms, p90 %d ms, p99 %d ms,"
+                          " max %d ms (of the last %d call(s)).", pName,
+                          gThroughputLatencyMs[(numLatencies * 50) / 100],
+                          gThroughputLatencyMs[(numLatencies * 90) / 100],
+                          gThroughputLatencyMs[(numLatencies * 99) / 100],
+                          gThroughputLatencyMs[numLatencies - 1], numLatencies);
+    }
+    U_PORT_TEST_ASSERT(totalBytes > 0);
+
+    U_PORT_TEST_ASSERT(uSockClose(descriptor) == 0);
+    if (isTcp) {
+        // Don't insist on a clean closure: the source server
+        // may well still be sending
+        for (y = 0; (y < U_SOCK_TEST_TCP_CLOSE_SECONDS) &&
+             !closedCallbackCalled; y++) {
+            uPortTaskBlock(1000);
+        }
+    }
+    errno = 0;
+}
+
 // Release OS resources that may have been left hanging
 // by a failed test
 static void osCleanup()
@@ -916,6 +1125,11 @@ U_PORT_TEST_FUNCTION("[sock]", "sockBasicUdp")
     int32_t heapUsed;
     int32_t heapSockInitLoss = 0;
     int32_t heapXxxSockInitLoss = 0;
+    uSockDatagram_t datagrams[3];
+    char batchBuffer[3][16];
+#if U_SOCK_DNS_CACHE_NUM_ENTRIES > 0
+    int32_t startTimeMs;
+#endif
 
     // In case a previous test failed
     uNetworkTestCleanUp();
@@ -954,6 +1168,28 @@ U_PORT_TEST_FUNCTION("[sock]", "sockBasicUdp")
                                               &(remoteAddress.ipAddress)) == 0);
         heapSockInitLoss -= uPortGetHeapFree();
 
+#if U_SOCK_DNS_CACHE_NUM_ENTRIES > 0
+        // A second look-up should be answered from the DNS cache
+        U_TEST_PRINT_LINE("looking up \"%s\" again, should be cached...",
+                          U_SOCK_TEST_ECHO_UDP_SERVER_DOMAIN_NAME);
+        memset(&address, 0, sizeof(address));
+        startTimeMs = uPortGetTickTimeMs();
+        U_PORT_TEST_ASSERT(uSockGetHostByName(devHandle,
+                                              U_SOCK_TEST_ECHO_UDP_SERVER_DOMAIN_NAME,
+                                              &(address.ipAddress)) == 0);
+        startTimeMs = uPortGetTickTimeMs() - startTimeMs;
+        U_TEST_PRINT_LINE("cached look-up took %d ms.", startTimeMs);
+        U_PORT_TEST_ASSERT(startTimeMs < U_SOCK_RECEIVE_POLL_INTERVAL_MS);
+        addressAssert(&remoteAddress, &address, false);
+        // Flush the cache and check that a real look-up still works
+        uSockDnsCacheFlush(devHandle);
+        memset(&address, 0, sizeof(address));
+        U_PORT_TEST_ASSERT(uSockGetHostByName(devHandle,
+                                              U_SOCK_TEST_ECHO_UDP_SERVER_DOMAIN_NAME,
+                                              &(address.ipAddress)) == 0);
+        addressAssert(&remoteAddress, &address, false);
+#endif
+
         // Add the port number we will use
         remoteAddress.port = U_SOCK_TEST_ECHO_UDP_SERVER_PORT;
 
@@ -1022,6 +1258,43 @@ U_PORT_TEST_FUNCTION("[sock]", "sockBasicUdp")
                 }
             }
 
+            if (success) {
+                U_TEST_PRINT_LINE("sending/receiving a batch of datagrams...");
+                for (size_t y = 0; y < sizeof(datagrams) / sizeof(datagrams[0]); y++) {
+                    datagrams[y].pRemoteAddress = &remoteAddress;
+                    datagrams[y].pData = (void *) (gSendData + (y * 10));
+                    datagrams[y].dataSizeBytes = 10;
+                }
+                U_PORT_TEST_ASSERT(uSockSendToMany(descriptor, datagrams,
+                                                   sizeof(datagrams) / sizeof(datagrams[0])) ==
+                                   sizeof(datagrams) / sizeof(datagrams[0]));
+                U_PORT_TEST_ASSERT(errno == 0);
+                for (size_t y = 0; y < sizeof(datagrams) / sizeof(datagrams[0]); y++) {
+                    U_PORT_TEST_ASSERT(datagrams[y].sizeBytes == 10);
+                    datagrams[y].pRemoteAddress = NULL;
+                    datagrams[y].pData = batchBuffer[y];
+                    datagrams[y].dataSizeBytes = sizeof(batchBuffer[y]);
+                }
+                sizeBytes = 0;
+                for (size_t y = 0; (y < 10) &&
+                     (sizeBytes < sizeof(datagrams) / sizeof(datagrams[0])); y++) {
+                    errorCode = uSockReceiveFromMany(descriptor, datagrams + sizeBytes,
+                                                     (sizeof(datagrams) /
+                                                      sizeof(datagrams[0])) - sizeBytes);
+                    if (errorCode > 0) {
+                        sizeBytes += errorCode;
+                    }
+                }
+                errno = 0;
+                U_TEST_PRINT_LINE("%d datagram(s) of the batch came back.", sizeBytes);
+                if (sizeBytes < sizeof(datagrams) / sizeof(datagrams[0])) {
+                    success = false;
+                }
+                for (size_t y = 0; y < sizeBytes; y++) {
+                    U_PORT_TEST_ASSERT(datagrams[y].sizeBytes == 10);
+                }
+            }
+
             U_TEST_PRINT_LINE("check that uSockGetRemoteAddress() fails...");
             U_PORT_TEST_ASSERT(uSockGetRemoteAddress(descriptor,
                                                      &address) < 0);
@@ -1106,6 +1379,11 @@ U_PORT_TEST_FUNCTION("[sock]", "sockBasicTcp")
     int32_t heapUsed;
     int32_t heapSockInitLoss = 0;
     int32_t heapXxxSockInitLoss = 0;
+    uSockIoVec_t ioVec[3];
+    uSockCoalesce_t coalesce;
+    uSockStats_t stats;
+    uBench_t bench;
+    char benchName[32];
 
     // Call clean up to release OS resources that may
     // have been left hanging by a previous failed test
@@ -1200,6 +1478,11 @@ U_PORT_TEST_FUNCTION("[sock]", "sockBasicTcp")
 
         U_TEST_PRINT_LINE("sending/receiving data over a TCP socket...");
 
+        // Time the echo, from the first send to the last receive
+        snprintf(benchName, sizeof(benchName), "sockTcpEcho_%s",
+                 gpUNetworkTestTypeName[pTmp->networkType]);
+        uBenchStart(&bench, benchName);
+
         // Throw random sized TCP segments up...
         offset = 0;
         y = 0;
@@ -1255,6 +1538,7 @@ U_PORT_TEST_FUNCTION("[sock]", "sockBasicTcp")
             U_TEST_PRINT_LINE("all %d byte(s) received back after %d ms,"
                               " checking if they were as expected...", sizeBytes,
                               (int32_t) (uPortGetTickTimeMs() - startTimeMs));
+            uBenchStop(&bench, 1, (uint32_t) sizeBytes, "bytes");
         }
 
         // Check that we reassembled everything correctly
@@ -1263,6 +1547,133 @@ U_PORT_TEST_FUNCTION("[sock]", "sockBasicTcp")
                                                 pDataReceived,
                                                 sizeBytes));
 
+        U_TEST_PRINT_LINE("sending/receiving scattered data over a TCP socket...");
+        // Send the first 30 bytes of gSendData from three fragments
+        // and get them back into two fragments of a different size
+        ioVec[0].pBase = (void *) gSendData;
+        ioVec[0].length = 5;
+        ioVec[1].pBase = (void *) (gSendData + 5);
+        ioVec[1].length = 0;
+        ioVec[2].pBase = (void *) (gSendData + 5);
+        ioVec[2].length = 25;
+        U_PORT_TEST_ASSERT(uSockIoVecLength(ioVec, 3) == 30);
+        U_PORT_TEST_ASSERT(uSockSendv(descriptor, NULL, ioVec, 3) == 30);
+        U_PORT_TEST_ASSERT(errno == 0);
+        memset(pDataReceived, U_SOCK_TEST_FILL_CHARACTER,
+               (sizeof(gSendData) - 1) + (U_SOCK_TEST_GUARD_LENGTH_SIZE_BYTES * 2));
+        ioVec[0].pBase = pDataReceived + U_SOCK_TEST_GUARD_LENGTH_SIZE_BYTES;
+        ioVec[0].length = 17;
+        ioVec[1].pBase = pDataReceived + U_SOCK_TEST_GUARD_LENGTH_SIZE_BYTES + 17;
+        ioVec[1].length = 13;
+        startTimeMs = uPortGetTickTimeMs();
+        offset = 0;
+        while ((offset < 30) && (uPortGetTickTimeMs() - startTimeMs < 20000)) {
+            errorCode = uSockReceivev(descriptor, NULL, ioVec, 2);
+            if (errorCode > 0) {
+                offset += errorCode;
+                // Move the fragments on past what was received
+                for (y = 0; (y < 2) && (errorCode > 0); y++) {
+                    if (ioVec[y].length > (size_t) errorCode) {
+                        ioVec[y].pBase = (char *) ioVec[y].pBase + errorCode;
+                        ioVec[y].length -= errorCode;
+                        errorCode = 0;
+                    } else {
+                        errorCode -= (int32_t) ioVec[y].length;
+                        ioVec[y].pBase = (char *) ioVec[y].pBase + ioVec[y].length;
+                        ioVec[y].length = 0;
+                    }
+                }
+            }
+        }
+        errno = 0;
+        U_PORT_TEST_ASSERT(checkAgainstSentData(gSendData, 30,
+                                                pDataReceived, offset));
+
+        U_TEST_PRINT_LINE("sending/receiving coalesced data over a TCP socket...");
+        // Coalesce three small writes, flushing them explicitly
+        coalesce.bufferSizeBytes = 64;
+        coalesce.timeoutMs = 0;
+        U_PORT_TEST_ASSERT(uSockOptionSet(descriptor, U_SOCK_OPT_LEVEL_SOCK,
+                                          U_SOCK_OPT_COALESCE,
+                                          (void *) &coalesce,
+                                          sizeof(coalesce)) == 0);
+        U_PORT_TEST_ASSERT(errno == 0);
+        for (y = 0; y < 3; y++) {
+            U_PORT_TEST_ASSERT(uSockWrite(descriptor, gSendData + (y * 10), 10) == 10);
+        }
+        U_PORT_TEST_ASSERT(uSockFlush(descriptor) == 0);
+        U_PORT_TEST_ASSERT(errno == 0);
+        memset(pDataReceived, U_SOCK_TEST_FILL_CHARACTER,
+               (sizeof(gSendData) - 1) + (U_SOCK_TEST_GUARD_LENGTH_SIZE_BYTES * 2));
+        offset = readTcp(descriptor, pDataReceived + U_SOCK_TEST_GUARD_LENGTH_SIZE_BYTES,
+                         30, 20000);
+        U_PORT_TEST_ASSERT(checkAgainstSentData(gSendData, 30,
+                                                pDataReceived, offset));
+        // Now with a timeout and no flush, the timer should do it;
+        // not all platforms have timers.  The task that does the
+        // flushing is only released by uSockDeinit(), which we don't
+        // call here, so need to allow for it in the heap loss
+        // calculation
+        coalesce.timeoutMs = 500;
+        heapSockInitLoss += uPortGetHeapFree();
+        errorCode = uSockOptionSet(descriptor, U_SOCK_OPT_LEVEL_SOCK,
+                                   U_SOCK_OPT_COALESCE,
+                                   (void *) &coalesce,
+                                   sizeof(coalesce));
+        heapSockInitLoss -= uPortGetHeapFree();
+        if (errorCode == 0) {
+            sizeBytes = sizeof(coalesce);
+            memset(&coalesce, 0, sizeof(coalesce));
+            U_PORT_TEST_ASSERT(uSockOptionGet(descriptor, U_SOCK_OPT_LEVEL_SOCK,
+                                              U_SOCK_OPT_COALESCE,
+                                              (void *) &coalesce,
+                                              &sizeBytes) == 0);
+            U_PORT_TEST_ASSERT(sizeBytes == sizeof(coalesce));
+            U_PORT_TEST_ASSERT(coalesce.bufferSizeBytes == 64);
+            U_PORT_TEST_ASSERT(coalesce.timeoutMs == 500);
+            U_PORT_TEST_ASSERT(uSockWrite(descriptor, gSendData, 20) == 20);
+            memset(pDataReceived, U_SOCK_TEST_FILL_CHARACTER,
+                   (sizeof(gSendData) - 1) + (U_SOCK_TEST_GUARD_LENGTH_SIZE_BYTES * 2));
+            offset = readTcp(descriptor, pDataReceived + U_SOCK_TEST_GUARD_LENGTH_SIZE_BYTES,
+                             20, 20000);
+            U_PORT_TEST_ASSERT(checkAgainstSentData(gSendData, 20,
+                                                    pDataReceived, offset));
+        } else {
+            U_PORT_TEST_ASSERT(errno == U_SOCK_ENOSYS);
+            errno = 0;
+        }
+        // Switch coalescing off again
+        coalesce.bufferSizeBytes = 0;
+        coalesce.timeoutMs = 0;
+        U_PORT_TEST_ASSERT(uSockOptionSet(descriptor, U_SOCK_OPT_LEVEL_SOCK,
+                                          U_SOCK_OPT_COALESCE,
+                                          (void *) &coalesce,
+                                          sizeof(coalesce)) == 0);
+        U_PORT_TEST_ASSERT(errno == 0);
+
+        // Check that the statistics reflect all of the above
+        U_PORT_TEST_ASSERT(uSockStatsGet(descriptor, NULL) < 0);
+        U_PORT_TEST_ASSERT(errno == U_SOCK_EINVAL);
+        errno = 0;
+        U_PORT_TEST_ASSERT(uSockStatsGet(descriptor, &stats) == 0);
+        U_TEST_PRINT_LINE("stats: %d byte(s) sent in %d write(s), %d byte(s)"
+                          " received, %d read(s) found no data, %d data"
+                          " callback(s).", stats.bytesSent, stats.numWrites,
+                          stats.bytesReceived, stats.numReadsWouldBlock,
+                          stats.numDataCallbacks);
+        U_TEST_PRINT_LINE("stats: write latency average %d ms, max %d ms;"
+                          " read latency average %d ms, max %d ms.",
+                          stats.writeLatencyAverageMs, stats.writeLatencyMaxMs,
+                          stats.readLatencyAverageMs, stats.readLatencyMaxMs);
+        U_PORT_TEST_ASSERT(stats.bytesSent == uSockGetTotalBytesSent(descriptor));
+        U_PORT_TEST_ASSERT(stats.bytesReceived > 0);
+        U_PORT_TEST_ASSERT(stats.numWrites > 0);
+        U_PORT_TEST_ASSERT(stats.writeLatencyAverageMs >= 0);
+        U_PORT_TEST_ASSERT(stats.writeLatencyMaxMs >= stats.writeLatencyAverageMs);
+        U_PORT_TEST_ASSERT(stats.numDataCallbacks > 0);
+        U_PORT_TEST_ASSERT(stats.readLatencyAverageMs >= 0);
+        U_PORT_TEST_ASSERT(stats.readLatencyMaxMs >= stats.readLatencyAverageMs);
+
         U_TEST_PRINT_LINE("shutting down socket for read...");
         errorCode = uSockShutdown(descriptor,
                                   U_SOCK_SHUTDOWN_READ);
@@ -2755,6 +3166,308 @@ U_PORT_TEST_FUNCTION("[sock]", "sockAsyncTcpEcho")
     uNetworkTestListFree();
 }
 
+/** Test the poll API: a single loop waiting in uSockPollWait()
+ * serves a TCP echo socket.
+ */
+U_PORT_TEST_FUNCTION("[sock]", "sockPollTcp")
+{
+    uNetworkTestList_t *pList;
+    int32_t errorCode;
+    uDeviceHandle_t devHandle;
+    uSockAddress_t remoteAddress;
+    uSockDescriptor_t descriptor;
+    uSockPollEvent_t event;
+    size_t sizeBytes;
+    size_t offset;
+    int32_t y;
+    int32_t numWakeUps;
+    char *pDataReceived;
+    int32_t startTimeMs;
+
+    // Call clean up to release OS resources that may
+    // have been left hanging by a previous failed test
+    osCleanup();
+
+    // Do the standard preamble to make sure there is
+    // a network underneath us
+    pList = pStdPreamble();
+
+    // Repeat for all bearers
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        devHandle = *pTmp->pDevHandle;
+
+        U_TEST_PRINT_LINE("doing TCP poll test on %s.",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uSockGetHostByName(devHandle,
+                                              U_SOCK_TEST_ECHO_TCP_SERVER_DOMAIN_NAME,
+                                              &(remoteAddress.ipAddress)) == 0);
+        remoteAddress.port = U_SOCK_TEST_ECHO_TCP_SERVER_PORT;
+
+        descriptor = uSockCreate(devHandle, U_SOCK_TYPE_STREAM,
+                                 U_SOCK_PROTOCOL_TCP);
+        U_PORT_TEST_ASSERT(descriptor >= 0);
+        uSockBlockingSet(descriptor, false);
+
+        // Check that bad parameters are rejected
+        U_PORT_TEST_ASSERT(uSockPollSet(descriptor, 0x80) < 0);
+        U_PORT_TEST_ASSERT(errno == U_SOCK_EINVAL);
+        errno = 0;
+        U_PORT_TEST_ASSERT(uSockPollWait(NULL, 1, 0) < 0);
+        U_PORT_TEST_ASSERT(errno == U_SOCK_EINVAL);
+        errno = 0;
+
+        // Nothing can happen on an unconnected TCP socket
+        U_PORT_TEST_ASSERT(uSockPollSet(descriptor, U_SOCK_POLL_EVENT_READ |
+                                        U_SOCK_POLL_EVENT_WRITE) == 0);
+        U_PORT_TEST_ASSERT(uSockPollWait(&event, 1, 0) == 0);
+
+        errorCode = -1;
+        for (y = 2; (y > 0) && (errorCode < 0); y--) {
+            errorCode = uSockConnect(descriptor, &remoteAddress);
+            if (errorCode < 0) {
+                errno = 0;
+            }
+        }
+        U_PORT_TEST_ASSERT(errorCode == 0);
+
+        // Connection should make the socket writable
+        U_PORT_TEST_ASSERT(uSockPollWait(&event, 1, 1000) == 1);
+        U_PORT_TEST_ASSERT(event.descriptor == descriptor);
+        U_PORT_TEST_ASSERT(event.events == U_SOCK_POLL_EVENT_WRITE);
+
+        // Only interested in reads from now on
+        U_PORT_TEST_ASSERT(uSockPollSet(descriptor,
+                                        U_SOCK_POLL_EVENT_READ) == 0);
+        U_PORT_TEST_ASSERT(sendTcp(descriptor, gSendData,
+                                   sizeof(gSendData) - 1) == sizeof(gSendData) - 1);
+
+        pDataReceived = (char *) malloc(sizeof(gSendData) - 1);
+        U_PORT_TEST_ASSERT(pDataReceived != NULL);
+        startTimeMs = uPortGetTickTimeMs();
+        offset = 0;
+        numWakeUps = 0;
+        while ((offset < sizeof(gSendData) - 1) &&
+               (uPortGetTickTimeMs() - startTimeMs < 20000)) {
+            if (uSockPollWait(&event, 1, 1000) > 0) {
+                numWakeUps++;
+                U_PORT_TEST_ASSERT(event.descriptor == descriptor);
+                U_PORT_TEST_ASSERT((event.events & U_SOCK_POLL_EVENT_WRITE) == 0);
+                if (event.events & U_SOCK_POLL_EVENT_READ) {
+                    do {
+                        //lint -e(668) Suppress possible use of NULL pointer
+                        y = uSockRead(descriptor, pDataReceived + offset,
+                                      (sizeof(gSendData) - 1) - offset);
+                        if (y > 0) {
+                            offset += y;
+                        }
+                    } while ((y > 0) && (offset < sizeof(gSendData) - 1));
+                    errno = 0;
+                }
+            }
+        }
+        sizeBytes = offset;
+        U_TEST_PRINT_LINE("%d byte(s) received back in %d wake-up(s) after %d ms.",
+                          sizeBytes, numWakeUps,
+                          (int32_t) (uPortGetTickTimeMs() - startTimeMs));
+        U_PORT_TEST_ASSERT(sizeBytes == sizeof(gSendData) - 1);
+        U_PORT_TEST_ASSERT(memcmp(pDataReceived, gSendData, sizeBytes) == 0);
+        free(pDataReceived);
+
+        // Closing the socket ourselves should not wake us up
+        U_PORT_TEST_ASSERT(uSockClose(descriptor) == 0);
+        U_PORT_TEST_ASSERT(uSockPollWait(&event, 1, 0) == 0);
+        U_PORT_TEST_ASSERT(errno == 0);
+        uSockCleanUp();
+    }
+
+    // Remove each network type
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        U_TEST_PRINT_LINE("taking down %s...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceDown(*pTmp->pDevHandle,
+                                                 pTmp->networkType) == 0);
+    }
+
+    // To speed things up, do not close the device
+    uNetworkTestListFree();
+}
+
+/** Connect TCP sockets with uSockConnectAsync(): completion of the
+ * connection should be reported to the callback and should make the
+ * socket writable, as seen by uSockPollWait(), after which the
+ * socket should work exactly as one connected with uSockConnect().
+ */
+U_PORT_TEST_FUNCTION("[sock]", "sockConnectAsync")
+{
+    uNetworkTestList_t *pList;
+    int32_t errorCode;
+    uDeviceHandle_t devHandle;
+    uSockAddress_t remoteAddress;
+    uSockDescriptor_t descriptor;
+    uSockPollEvent_t event;
+    size_t sizeBytes;
+    int32_t y;
+    int32_t connectErrno;
+    char *pDataReceived;
+
+    // Call clean up to release OS resources that may
+    // have been left hanging by a previous failed test
+    osCleanup();
+
+    // Do the standard preamble to make sure there is
+    // a network underneath us
+    pList = pStdPreamble();
+
+    // Repeat for all bearers
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        devHandle = *pTmp->pDevHandle;
+
+        U_TEST_PRINT_LINE("doing asynchronous TCP connect test on %s.",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uSockGetHostByName(devHandle,
+                                              U_SOCK_TEST_ECHO_TCP_SERVER_DOMAIN_NAME,
+                                              &(remoteAddress.ipAddress)) == 0);
+        remoteAddress.port = U_SOCK_TEST_ECHO_TCP_SERVER_PORT;
+
+        descriptor = uSockCreate(devHandle, U_SOCK_TYPE_STREAM,
+                                 U_SOCK_PROTOCOL_TCP);
+        U_PORT_TEST_ASSERT(descriptor >= 0);
+
+        // Check that bad parameters are rejected
+        U_PORT_TEST_ASSERT(uSockConnectAsync(descriptor, NULL, NULL, NULL) < 0);
+        U_PORT_TEST_ASSERT(errno == U_SOCK_EINVAL);
+        errno = 0;
+
+        U_PORT_TEST_ASSERT(uSockPollSet(descriptor, U_SOCK_POLL_EVENT_WRITE) == 0);
+
+        // Connect without blocking: completion of the connection
+        // should make the socket writable, failure is reported
+        // as an error event
+        errorCode = -1;
+        for (y = 2; (y > 0) && (errorCode < 0); y--) {
+            connectErrno = -1;
+            errorCode = uSockConnectAsync(descriptor, &remoteAddress,
+                                          connectResultCallback,
+                                          &connectErrno);
+            U_TEST_PRINT_LINE("uSockConnectAsync() returned %d, errno %d.",
+                              errorCode, errno);
+            if (errorCode == 0) {
+                U_PORT_TEST_ASSERT(uSockPollWait(&event, 1,
+                                                 U_SOCK_TEST_TCP_CONNECT_SECONDS * 1000) == 1);
+                U_PORT_TEST_ASSERT(event.descriptor == descriptor);
+                if (event.events == U_SOCK_POLL_EVENT_ERROR) {
+                    U_PORT_TEST_ASSERT(connectErrno > 0);
+                    errorCode = -1;
+                } else {
+                    U_PORT_TEST_ASSERT(event.events == U_SOCK_POLL_EVENT_WRITE);
+                    U_PORT_TEST_ASSERT(connectErrno == U_SOCK_ENONE);
+                }
+            }
+            errno = 0;
+        }
+        U_PORT_TEST_ASSERT(errorCode == 0);
+
+        // Can't connect twice, either way
+        U_PORT_TEST_ASSERT(uSockConnectAsync(descriptor, &remoteAddress,
+                                             NULL, NULL) < 0);
+        U_PORT_TEST_ASSERT(errno == U_SOCK_EPERM);
+        errno = 0;
+        U_PORT_TEST_ASSERT(uSockConnect(descriptor, &remoteAddress) < 0);
+        errno = 0;
+
+        // The connection should work as normal
+        U_PORT_TEST_ASSERT(sendTcp(descriptor, gSendData,
+                                   sizeof(gSendData) - 1) == sizeof(gSendData) - 1);
+        pDataReceived = (char *) malloc(sizeof(gSendData) - 1);
+        U_PORT_TEST_ASSERT(pDataReceived != NULL);
+        //lint -e(668) Suppress possible use of NULL pointer
+        sizeBytes = readTcp(descriptor, pDataReceived, sizeof(gSendData) - 1, 20000);
+        U_TEST_PRINT_LINE("%d byte(s) received back.", sizeBytes);
+        U_PORT_TEST_ASSERT(sizeBytes == sizeof(gSendData) - 1);
+        U_PORT_TEST_ASSERT(memcmp(pDataReceived, gSendData, sizeBytes) == 0);
+        free(pDataReceived);
+
+        U_PORT_TEST_ASSERT(uSockClose(descriptor) == 0);
+        uSockCleanUp();
+    }
+
+    // Remove each network type
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        U_TEST_PRINT_LINE("taking down %s...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceDown(*pTmp->pDevHandle,
+                                                 pTmp->networkType) == 0);
+    }
+
+    // To speed things up, do not close the device
+    uNetworkTestListFree();
+}
+
+/** Throughput benchmark: for each bearer write to the TCP and UDP
+ * discard servers and read from the TCP source server, see
+ * echo_server/readme.md, as fast as possible, each for
+ * U_SOCK_TEST_THROUGHPUT_DURATION_SECONDS, reporting the throughput,
+ * the AT commands per megabyte and the spread of call times, so
+ * that any change to the sockets path can be measured.
+ */
+U_PORT_BENCH_FUNCTION("[sock]", "sockBenchThroughput")
+{
+    uNetworkTestList_t *pList;
+    uDeviceHandle_t devHandle;
+    uSockAddress_t remoteAddress;
+    char benchName[32];
+
+    // Call clean up to release OS resources that may
+    // have been left hanging by a previous failed test
+    osCleanup();
+
+    // Do the standard preamble to make sure there is
+    // a network underneath us
+    pList = pStdPreamble();
+
+    // Repeat for all bearers
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        devHandle = *pTmp->pDevHandle;
+
+        U_TEST_PRINT_LINE("measuring socket throughput on %s.",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uSockGetHostByName(devHandle,
+                                              U_SOCK_TEST_ECHO_TCP_SERVER_DOMAIN_NAME,
+                                              &(remoteAddress.ipAddress)) == 0);
+
+        remoteAddress.port = U_SOCK_TEST_DISCARD_TCP_SERVER_PORT;
+        snprintf(benchName, sizeof(benchName), "sockTcpWrite_%s",
+                 gpUNetworkTestTypeName[pTmp->networkType]);
+        throughputRun(devHandle, &remoteAddress, true, true, benchName);
+
+        remoteAddress.port = U_SOCK_TEST_SOURCE_TCP_SERVER_PORT;
+        snprintf(benchName, sizeof(benchName), "sockTcpRead_%s",
+                 gpUNetworkTestTypeName[pTmp->networkType]);
+        throughputRun(devHandle, &remoteAddress, true, false, benchName);
+
+        U_PORT_TEST_ASSERT(uSockGetHostByName(devHandle,
+                                              U_SOCK_TEST_ECHO_UDP_SERVER_DOMAIN_NAME,
+                                              &(remoteAddress.ipAddress)) == 0);
+        remoteAddress.port = U_SOCK_TEST_DISCARD_UDP_SERVER_PORT;
+        snprintf(benchName, sizeof(benchName), "sockUdpWrite_%s",
+                 gpUNetworkTestTypeName[pTmp->networkType]);
+        throughputRun(devHandle, &remoteAddress, false, true, benchName);
+
+        uSockCleanUp();
+    }
+
+    // Remove each network type
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        U_TEST_PRINT_LINE("taking down %s...",
+                          gpUNetworkTestTypeName[pTmp->networkType]);
+        U_PORT_TEST_ASSERT(uNetworkInterfaceDown(*pTmp->pDevHandle,
+                                                 pTmp->networkType) == 0);
+    }
+
+    // To speed things up, do not close the device
+    uNetworkTestListFree();
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
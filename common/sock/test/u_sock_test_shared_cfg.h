@@ -88,6 +88,28 @@
 # define U_SOCK_TEST_ECHO_SECURE_TCP_SERVER_PORT  5065
 #endif
 
+#ifndef U_SOCK_TEST_DISCARD_UDP_SERVER_PORT
+/** Port number on the echo server of a UDP server that throws
+ * away whatever it receives, for throughput testing.
+ */
+# define U_SOCK_TEST_DISCARD_UDP_SERVER_PORT  5051
+#endif
+
+#ifndef U_SOCK_TEST_DISCARD_TCP_SERVER_PORT
+/** Port number on the echo server of a TCP server that throws
+ * away whatever it receives, for throughput testing.
+ */
+# define U_SOCK_TEST_DISCARD_TCP_SERVER_PORT  5056
+#endif
+
+#ifndef U_SOCK_TEST_SOURCE_TCP_SERVER_PORT
+/** Port number on the echo server of a TCP server that sends
+ * data as fast as the connection will take it, for throughput
+ * testing.
+ */
+# define U_SOCK_TEST_SOURCE_TCP_SERVER_PORT  5057
+#endif
+
 #ifndef U_SOCK_TEST_LOCAL_PORT
 /** Local port number used when testing.
  */
@@ -110,6 +132,13 @@
 # define U_SOCK_TEST_TCP_CLOSE_SECONDS 60
 #endif
 
+#ifndef U_SOCK_TEST_TCP_CONNECT_SECONDS
+/** Time to wait for an asynchronous TCP connection,
+ * started with uSockConnectAsync(), to complete.
+ */
+# define U_SOCK_TEST_TCP_CONNECT_SECONDS 30
+#endif
+
 #endif // _U_SOCK_TEST_CFG_H_
 
 // End of file
@@ -56,10 +56,111 @@ extern "C" {
  */
 #define U_SPARTN_MESSAGE_LENGTH_MAX_BYTES (4 + 8 + 1024 + 64 + 4)
 
+#ifndef U_SPARTN_FRAMER_NUM_MESSAGE_TYPES
+/** The number of SPARTN message types (TF002) that a SPARTN framer
+ * counts individually, see uSpartnFramerStats_t; types 0 (OCB) to 4
+ * (EAS) are those defined by SPARTN version 2.
+ */
+# define U_SPARTN_FRAMER_NUM_MESSAGE_TYPES 5
+#endif
+
+#ifndef U_SPARTN_MERGER_WINDOW_NUM_MESSAGES
+/** The number of messages that a SPARTN merger, see uSpartnMerger_t,
+ * remembers: a copy of a message that arrives after this many other
+ * messages have been added to the merger is no longer recognised as
+ * a duplicate.  This should cover the messages that arrive, from all
+ * sources, in the time by which one source may lag another; each
+ * message remembered costs 16 bytes of the merger.
+ */
+# define U_SPARTN_MERGER_WINDOW_NUM_MESSAGES 128
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The statistics of a SPARTN framer, see uSpartnFramerGetStats().
+ */
+typedef struct {
+    size_t numMessages[U_SPARTN_FRAMER_NUM_MESSAGE_TYPES + 1];    /**< the number of valid
+                                                                       messages framed, indexed
+                                                                       by message type (TF002),
+                                                                       the last entry counting
+                                                                       all message types of
+                                                                       #U_SPARTN_FRAMER_NUM_MESSAGE_TYPES
+                                                                       or more. */
+    size_t numCrcFailures[U_SPARTN_FRAMER_NUM_MESSAGE_TYPES + 1]; /**< the number of messages
+                                                                       with a good header that
+                                                                       failed the message CRC
+                                                                       check, indexed as for
+                                                                       numMessages. */
+    size_t numBytesDiscarded;                                     /**< the number of bytes
+                                                                       that were not part of a
+                                                                       valid message. */
+} uSpartnFramerStats_t;
+
+/** A SPARTN framer: unlike uSpartnValidate(), which needs a whole
+ * message in the buffer it is given, this can be given data in
+ * chunks of any size, e.g. as they arrive from a socket or over
+ * MQTT, assembling messages in its own buffer, so that the caller
+ * does not need to keep an oversized buffer or look again from the
+ * start when a chunk ends part way through a message.  Initialise
+ * it with uSpartnFramerInit() and then pass it to
+ * uSpartnFramerFrame(); the contents are private to the framer,
+ * they are here only so that it may be allocated by the caller
+ * (it is a little over #U_SPARTN_MESSAGE_LENGTH_MAX_BYTES in size).
+ */
+typedef struct {
+    char buffer[U_SPARTN_MESSAGE_LENGTH_MAX_BYTES];
+    size_t length;
+    size_t messageLength;
+    bool messageReturned;
+    uSpartnFramerStats_t stats;
+} uSpartnFramer_t;
+
+/** The statistics of a SPARTN merger, see uSpartnMergerGetStats().
+ */
+typedef struct {
+    size_t numForwarded;  /**< the number of messages that were the
+                               first copy and so should be forwarded. */
+    size_t numDuplicates; /**< the number of messages that were
+                               duplicates. */
+} uSpartnMergerStats_t;
+
+/** What a SPARTN merger remembers of a message: the fields of the
+ * SPARTN header that identify it (message type (TF002), sub-type
+ * (TF007), GNSS time tag (TF009), solution ID (TF010) and solution
+ * processor ID (TF011)) and, since a set of corrections for one
+ * time may be split across several messages which differ only in
+ * their payload, the length and message CRC (TF018).
+ */
+typedef struct {
+    uint32_t timeTag;
+    uint32_t crc;
+    uint16_t length;
+    uint8_t type;
+    uint8_t subType;
+    uint8_t solutionId;
+    uint8_t processorId;
+} uSpartnMergerKey_t;
+
+/** A SPARTN merger: for when the same SPARTN corrections are received
+ * from more than one source, e.g. from a NEO-D9S L-band receiver and
+ * over MQTT, and only the first copy of each message should be
+ * forwarded to the GNSS chip, halving the load on the GNSS chip and
+ * on the link to it.  Initialise it with uSpartnMergerInit() and then
+ * pass it each whole message, from whichever source, with
+ * uSpartnMergerAdd(); the contents are private to the merger, they
+ * are here only so that it may be allocated by the caller (it is a
+ * little over 16 * #U_SPARTN_MERGER_WINDOW_NUM_MESSAGES bytes in size).
+ */
+typedef struct {
+    uSpartnMergerKey_t key[U_SPARTN_MERGER_WINDOW_NUM_MESSAGES];
+    size_t next;
+    size_t count;
+    uSpartnMergerStats_t stats;
+} uSpartnMerger_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -145,6 +246,134 @@ int32_t uSpartnDetect(const char *pBuffer, size_t bufferLengthBytes,
 int32_t uSpartnValidate(const char *pBuffer, size_t bufferLengthBytes,
                         const char **ppMessage);
 
+/** Initialise a SPARTN framer, see uSpartnFramer_t; this may also be
+ * called at any time to throw away any partial message and zero
+ * the statistics.
+ *
+ * @param[out] pFramer  a pointer to the framer; cannot be NULL.
+ */
+void uSpartnFramerInit(uSpartnFramer_t *pFramer);
+
+/** Pass a chunk of data to a SPARTN framer.  The data is consumed up
+ * to the end of the first message that it completes, ppBufferOut
+ * being set to point at the first byte after that, ready for the
+ * remainder of the chunk to be passed in again; if no message is
+ * completed the entire chunk is consumed and the framer remembers
+ * where it was.  Only messages that pass the message CRC check are
+ * returned; the bytes of a message which fails it are searched
+ * again for the start of a message since the CRC-4 of a SPARTN
+ * header offers little protection against false detection.
+ * For example:
+ *
+ * ```
+ * uSpartnFramer_t framer;
+ * const char *pEnd;
+ * const char *pMessage;
+ *
+ * uSpartnFramerInit(&framer);
+ * while ((bufferLength = myRead(dataIn, sizeof(dataIn))) > 0) {
+ *     const char *pBuffer = dataIn;
+ *     while (bufferLength > 0) {
+ *         int32_t x = uSpartnFramerFrame(&framer, pBuffer, bufferLength,
+ *                                        &pEnd, &pMessage);
+ *         if (x > 0) {
+ *             // Do something with the x bytes at pMessage here
+ *         }
+ *         bufferLength -= pEnd - pBuffer;
+ *         pBuffer = pEnd;
+ *     }
+ * }
+ * ```
+ *
+ * @param[in] pFramer          a pointer to the framer, initialised
+ *                             with uSpartnFramerInit(); cannot be
+ *                             NULL.
+ * @param[in] pBufferIn        a pointer to the data; may only be NULL
+ *                             if bufferLengthBytes is zero.
+ * @param bufferLengthBytes    the amount of data at pBufferIn.
+ * @param[out] ppBufferOut     a pointer to a place to put a pointer to
+ *                             the first byte of pBufferIn that has not
+ *                             been consumed; may be NULL.
+ * @param[out] ppMessage       a pointer to a place to put a pointer to
+ *                             the message, TF001 to TF018, which is in
+ *                             the buffer of the framer and remains
+ *                             valid until the framer is next called;
+ *                             cannot be NULL.
+ * @return                     on success the length of the message
+ *                             at ppMessage, else negative error code:
+ *                             #U_ERROR_COMMON_TIMEOUT if a message has
+ *                             begun but is not yet complete or
+ *                             #U_ERROR_COMMON_NOT_FOUND if there is
+ *                             nothing that might be the start of a
+ *                             message.
+ */
+int32_t uSpartnFramerFrame(uSpartnFramer_t *pFramer,
+                           const char *pBufferIn, size_t bufferLengthBytes,
+                           const char **ppBufferOut,
+                           const char **ppMessage);
+
+/** Get the statistics of a SPARTN framer.
+ *
+ * @param[in] pFramer  a pointer to the framer; cannot be NULL.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ */
+void uSpartnFramerGetStats(const uSpartnFramer_t *pFramer,
+                           uSpartnFramerStats_t *pStats);
+
+/** Initialise a SPARTN merger, see uSpartnMerger_t; this may also be
+ * called at any time to forget all of the messages seen so far and
+ * zero the statistics.
+ *
+ * @param[out] pMerger  a pointer to the merger; cannot be NULL.
+ */
+void uSpartnMergerInit(uSpartnMerger_t *pMerger);
+
+/** Add a SPARTN message, from any source, to a SPARTN merger and find
+ * out whether it should be forwarded to the GNSS chip: it should be
+ * if no copy of it has been added among the last
+ * #U_SPARTN_MERGER_WINDOW_NUM_MESSAGES messages.  The message must
+ * be whole and should have been validated, e.g. it is one returned
+ * by uSpartnFramerFrame() or uSpartnValidate(): only its header is
+ * decoded here.  Where messages arrive from each source in a
+ * different task, as they would from uGnssMsgReceiveStart() and from
+ * an MQTT callback, the caller must make sure that only one task at
+ * a time calls this function for a given merger.  For example:
+ *
+ * ```
+ * // Called with each message from each source's framer
+ * static void onMessage(const char *pMessage, int32_t length)
+ * {
+ *     uPortMutexLock(gMergerMutex);
+ *     if (uSpartnMergerAdd(&gMerger, pMessage, length) > 0) {
+ *         myForwardToGnss(pMessage, length);
+ *     }
+ *     uPortMutexUnlock(gMergerMutex);
+ * }
+ * ```
+ *
+ * @param[in] pMerger         a pointer to the merger, initialised
+ *                            with uSpartnMergerInit(); cannot be NULL.
+ * @param[in] pMessage        a pointer to the message, TF001 to TF018;
+ *                            cannot be NULL.
+ * @param messageLengthBytes  the length of the message at pMessage.
+ * @return                    messageLengthBytes if this is the first
+ *                            copy of the message, which should be
+ *                            forwarded, zero if it is a duplicate,
+ *                            else negative error code, e.g.
+ *                            #U_ERROR_COMMON_NOT_FOUND if pMessage does
+ *                            not contain exactly one SPARTN message.
+ */
+int32_t uSpartnMergerAdd(uSpartnMerger_t *pMerger, const char *pMessage,
+                         size_t messageLengthBytes);
+
+/** Get the statistics of a SPARTN merger.
+ *
+ * @param[in] pMerger  a pointer to the merger; cannot be NULL.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ */
+void uSpartnMergerGetStats(const uSpartnMerger_t *pMerger,
+                           uSpartnMergerStats_t *pStats);
+
 #ifdef __cplusplus
 }
 #endif
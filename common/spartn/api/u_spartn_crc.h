@@ -41,6 +41,17 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_SPARTN_CRC_SLICE_BY
+/** The number of bytes at a time that uSpartnCrc24() and
+ * uSpartnCrc32() work on, a trade-off between flash and speed:
+ * 1 uses only the usual 1 kbyte table per CRC, 4 adds 3 kbytes per
+ * CRC and is typically two to three times faster, 8 adds 7 kbytes
+ * per CRC and is faster still on processors with enough cache or
+ * fast enough flash.  The result is the same whichever is chosen.
+ */
+# define U_SPARTN_CRC_SLICE_BY 1
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -94,7 +94,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memcpy()
+#include "string.h"    // memcpy(), memmove(), memchr(), memset()
 
 #include "u_error_common.h"
 
@@ -123,6 +123,128 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Decode the SPARTN message header which begins, with the 0x73 of
+// FRAME START, at pInput, returning the length of the message,
+// U_ERROR_COMMON_TIMEOUT if there is not yet enough data to work that
+// out or U_ERROR_COMMON_NOT_FOUND if this is not a SPARTN message
+// header; on success *pCrcType is the message CRC type.
+static int32_t decodeHeaderAt(const uint8_t *pInput, size_t bufferLengthBytes,
+                              size_t *pCrcType)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    uint8_t frameBuffer[4];
+    size_t lengthHeader;
+    size_t lengthBeyondHeader;
+
+    if (bufferLengthBytes >= U_SPARTN_HEADER_LENGTH_MIN_BYTES) {
+        // Have enough data to work on the header; confirm that this
+        // is a FRAME START by doing a frame CRC check on it
+        // Copy everything from FRAME START except TF001 into a buffer
+        memcpy(&frameBuffer, pInput + 1, 3);
+        frameBuffer[3] = 0;
+
+        // frameBuffer now contains, in order of bit-arrival:
+        //
+        // bytes:    |      0     |     1     |      2      |     3     |
+        // contents: |<---T7---><-----L10------->E1-MCT2-FC4|           |
+        // meaning:  |M       L M |           |L    M L  M L|           |
+
+        // Remove the frame CRC that is in the lower four
+        // bits of byte 2, giving us 20 bits in the buffer with
+        // zero-fill elsewhere
+        frameBuffer[2] &= 0xf0;
+        // Compute the CRC-4 over 24 bits and check it against the frame CRC (TF006)
+        if (uSpartnCrc4((const char *) frameBuffer, 3) == (*(pInput + 3) & 0x0f)) {
+            lengthHeader = U_SPARTN_HEADER_LENGTH_MIN_BYTES;
+            // So far so good, now parse the PAYLOAD DESCRIPTION to work out
+            // how long it is; check if the TF008 (GNSS time tag type) bit is set
+            if (*(pInput + 4) & 0x08) {
+                // The GNSS time tag is 32 bits instead of 16, so account for that
+                lengthHeader += 2;
+            }
+            // Work out the length beyond the message header
+            // First the length of the payload from the 10-bit TF003 field,
+            // which is splattered across the three bytes of frameBuffer
+            lengthBeyondHeader = ((((size_t) frameBuffer[0]) & 0x01) << 9) +
+                                 (((size_t) frameBuffer[1]) << 1) +
+                                 ((((size_t) frameBuffer[2]) & 0x80) >> 7);
+            // Add the length of the message CRC by looking at
+            // the 2-bit message CRC type field (TF005).  Since we have
+            // 0: CRC-8, 1: CRC-16, 2: CRC-24, 3: CRC-32 it is easy
+            // to calculate
+            *pCrcType = (frameBuffer[2] & 0x30) >> 4;
+            lengthBeyondHeader += *pCrcType + 1;
+            // Work out the additions as a consequence of encryption/authentication
+            // being switched on
+            if (frameBuffer[2] & 0x40) {
+                // TF004 is set, so we need the ENCRYPT/AUTH fields to work
+                // out the message length; see if they are in the buffer
+                if ((int32_t) bufferLengthBytes - (int32_t) lengthHeader >= 2) {
+                    // The ENCRYPT/AUTH fields are in the buffer
+                    lengthHeader += 2;
+                    // To work out how big the AUTHENTICATION field is we
+                    // need to check if the authentication indicator field
+                    // (TF014) in PAYLOAD DESCRIPTION is greater than 1.
+                    // This is in the final byte of the header so we
+                    // can use lengthHeader, which is now pointing
+                    // at the start of the payload, to index to it
+                    if (((*(pInput + lengthHeader - 1) & 0x38) >> 3) > 1) {
+                        // AUTHENTICATION is present, find out how
+                        // big it is from the 3-bit authentication
+                        // length (TF015) at the beginning of the same
+                        // byte
+                        switch (*(pInput + lengthHeader - 1) & 0x07) {
+                            case 0: // 64 bits
+                                lengthBeyondHeader += 64 / 8;
+                                break;
+                            case 1: // 96 bits
+                                lengthBeyondHeader += 96 / 8;
+                                break;
+                            case 2: // 128 bits
+                                lengthBeyondHeader += 128 / 8;
+                                break;
+                            case 3: // 256 bits
+                                lengthBeyondHeader += 256 / 8;
+                                break;
+                            case 4: // 512 bits
+                                lengthBeyondHeader += 512 / 8;
+                                break;
+                            default:
+                                // Error case: not a supported message
+                                sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                                lengthHeader = 0;
+                                break;
+                        }
+                    }
+                } else {
+                    // Might be a message but we don't yet have enough
+                    // data to work out its length; set the length
+                    // of the header to zero to flag this
+                    lengthHeader = 0;
+                }
+            }
+            if (lengthHeader > 0) {
+                // We have a header length, so (a) there are no errors and (b)
+                // we have all the data we need to determine the message length,
+                // then we are done; otherwise sizeOrErrorCode is left at
+                // U_ERROR_COMMON_TIMEOUT (or U_ERROR_COMMON_NOT_FOUND if there
+                // was an error)
+                sizeOrErrorCode = (int32_t) (lengthHeader + lengthBeyondHeader);
+            }
+        } else {
+            // Not a SPARTN message
+            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        }
+    } else {
+        // Might be a SPARTN message but we don't yet have all of
+        // the header and hence can't work out the message
+        // length; leave sizeOrErrorCode at U_ERROR_COMMON_TIMEOUT
+        // so that the caller knows we need more data
+    }
+
+    return sizeOrErrorCode;
+}
+
 // Look for a SPARTN message header in a buffer and supply its position,
 // plus the message CRC position and type.
 static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
@@ -134,10 +256,7 @@ static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
     // Use a uint8_t pointer for maths, more certain of its behaviour than char
     const uint8_t *pInput = (const uint8_t *) pBuffer;
     const uint8_t *pMessage = NULL;
-    uint8_t frameBuffer[4];
-    size_t lengthHeader;
-    size_t lengthBeyondHeader;
-    size_t crcType;
+    size_t crcType = 0;
 
     if (pInput != NULL) {
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
@@ -145,119 +264,8 @@ static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
                (bufferLengthBytes > 0)) {
             if (*pInput == 0x73) {
                 // Potentially a FRAME START
-                sizeOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
                 pMessage = pInput;
-                if (bufferLengthBytes >= U_SPARTN_HEADER_LENGTH_MIN_BYTES) {
-                    // Have enough data to work on the header; confirm that this
-                    // is a FRAME START by doing a frame CRC check on it
-                    // Copy everything from FRAME START except TF001 into a buffer
-                    memcpy(&frameBuffer, pInput + 1, 3);
-                    frameBuffer[3] = 0;
-
-                    // frameBuffer now contains, in order of bit-arrival:
-                    //
-                    // bytes:    |      0     |     1     |      2      |     3     |
-                    // contents: |<---T7---><-----L10------->E1-MCT2-FC4|           |
-                    // meaning:  |M       L M |           |L    M L  M L|           |
-
-                    // Remove the frame CRC that is in the lower four
-                    // bits of byte 2, giving us 20 bits in the buffer with
-                    // zero-fill elsewhere
-                    frameBuffer[2] &= 0xf0;
-                    // Compute the CRC-4 over 24 bits and check it against the frame CRC (TF006)
-                    if (uSpartnCrc4((const char *) frameBuffer, 3) == (*(pInput + 3) & 0x0f)) {
-                        lengthHeader = U_SPARTN_HEADER_LENGTH_MIN_BYTES;
-                        // So far so good, now parse the PAYLOAD DESCRIPTION to work out
-                        // how long it is; check if the TF008 (GNSS time tag type) bit is set
-                        if (*(pInput + 4) & 0x08) {
-                            // The GNSS time tag is 32 bits instead of 16, so account for that
-                            lengthHeader += 2;
-                        }
-                        // Work out the length beyond the message header
-                        // First the length of the payload from the 10-bit TF003 field,
-                        // which is splattered across the three bytes of frameBuffer
-                        lengthBeyondHeader = ((((size_t) frameBuffer[0]) & 0x01) << 9) +
-                                             (((size_t) frameBuffer[1]) << 1) +
-                                             ((((size_t) frameBuffer[2]) & 0x80) >> 7);
-                        // Add the length of the message CRC by looking at
-                        // the 2-bit message CRC type field (TF005).  Since we have
-                        // 0: CRC-8, 1: CRC-16, 2: CRC-24, 3: CRC-32 it is easy
-                        // to calculate
-                        crcType = (frameBuffer[2] & 0x30) >> 4;
-                        lengthBeyondHeader += crcType + 1;
-                        if (pMessageCrcType != NULL) {
-                            *pMessageCrcType = (uSpartnCrcType_t) crcType;
-                        }
-                        // Work out the additions as a consequence of encryption/authentication
-                        // being switched on
-                        if (frameBuffer[2] & 0x40) {
-                            // TF004 is set, so we need the ENCRYPT/AUTH fields to work
-                            // out the message length; see if they are in the buffer
-                            if ((int32_t) bufferLengthBytes - (int32_t) lengthHeader >= 2) {
-                                // The ENCRYPT/AUTH fields are in the buffer
-                                lengthHeader += 2;
-                                // To work out how big the AUTHENTICATION field is we
-                                // need to check if the authentication indicator field
-                                // (TF014) in PAYLOAD DESCRIPTION is greater than 1.
-                                // This is in the final byte of the header so we
-                                // can use lengthHeader, which is now pointing
-                                // at the start of the payload, to index to it
-                                if (((*(pInput + lengthHeader - 1) & 0x38) >> 3) > 1) {
-                                    // AUTHENTICATION is present, find out how
-                                    // big it is from the 3-bit authentication
-                                    // length (TF015) at the beginning of the same
-                                    // byte
-                                    switch (*(pInput + lengthHeader - 1) & 0x07) {
-                                        case 0: // 64 bits
-                                            lengthBeyondHeader += 64 / 8;
-                                            break;
-                                        case 1: // 96 bits
-                                            lengthBeyondHeader += 96 / 8;
-                                            break;
-                                        case 2: // 128 bits
-                                            lengthBeyondHeader += 128 / 8;
-                                            break;
-                                        case 3: // 256 bits
-                                            lengthBeyondHeader += 256 / 8;
-                                            break;
-                                        case 4: // 512 bits
-                                            lengthBeyondHeader += 512 / 8;
-                                            break;
-                                        default:
-                                            // Error case: not a supported message
-                                            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
-                                            lengthHeader = 0;
-                                            break;
-                                    }
-                                }
-                            } else {
-                                // Might be a message but we don't yet have enough
-                                // data to work out its length; set the length
-                                // of the header to zero to flag this
-                                lengthHeader = 0;
-                            }
-                        }
-                        if (lengthHeader > 0) {
-                            // We have a header length, so (a) there are no errors and (b)
-                            // we have all the data we need to determine the message length,
-                            // then we are done; otherwise sizeOrErrorCode is left at
-                            // U_ERROR_COMMON_TIMEOUT (or U_ERROR_COMMON_NOT_FOUND if there
-                            // was an error)
-                            sizeOrErrorCode = (int32_t) (lengthHeader + lengthBeyondHeader);
-                            if (ppMessageCrcStart != NULL) {
-                                *ppMessageCrcStart = (const char *) pMessage + lengthHeader + lengthBeyondHeader - (crcType + 1);
-                            }
-                        }
-                    } else {
-                        // Not a SPARTN message
-                        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
-                    }
-                } else {
-                    // Might be a SPARTN message but we don't yet have all of
-                    // the header and hence can't work out the message
-                    // length; leave sizeOrErrorCode at U_ERROR_COMMON_TIMEOUT
-                    // so that the caller knows we need more data
-                }
+                sizeOrErrorCode = decodeHeaderAt(pInput, bufferLengthBytes, &crcType);
             }
 
             // Move along
@@ -266,13 +274,94 @@ static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
         }
     }
 
-    if ((sizeOrErrorCode >= 0) && (ppMessage != NULL)) {
-        *ppMessage = (const char *) pMessage;
+    if (sizeOrErrorCode >= 0) {
+        if (ppMessage != NULL) {
+            *ppMessage = (const char *) pMessage;
+        }
+        if (ppMessageCrcStart != NULL) {
+            *ppMessageCrcStart = (const char *) pMessage + sizeOrErrorCode - (crcType + 1);
+        }
+        if (pMessageCrcType != NULL) {
+            *pMessageCrcType = (uSpartnCrcType_t) crcType;
+        }
     }
 
     return sizeOrErrorCode;
 }
 
+// Throw away the first byte in the buffer of a SPARTN framer, which
+// is not the start of a valid message, and whatever follows it up
+// to the next byte that might be.
+static void framerResync(uSpartnFramer_t *pFramer)
+{
+    const char *pNext = NULL;
+    size_t discard = pFramer->length;
+
+    if (pFramer->length > 1) {
+        pNext = (const char *) memchr(pFramer->buffer + 1, 0x73, pFramer->length - 1);
+    }
+    if (pNext != NULL) {
+        discard = pNext - pFramer->buffer;
+    }
+    memmove(pFramer->buffer, pFramer->buffer + discard, pFramer->length - discard);
+    pFramer->length -= discard;
+    pFramer->messageLength = 0;
+    pFramer->stats.numBytesDiscarded += discard;
+}
+
+// Get numBits (no more than 32) bits of a SPARTN message, MSB first,
+// starting bitOffset bits from the start of the message.
+static uint32_t getBits(const uint8_t *pInput, size_t bitOffset,
+                        size_t numBits)
+{
+    uint32_t value = 0;
+
+    for (size_t x = bitOffset; x < bitOffset + numBits; x++) {
+        value = (value << 1) | ((*(pInput + (x >> 3)) >> (7 - (x & 0x07))) & 0x01);
+    }
+
+    return value;
+}
+
+// Fill in the key which identifies a whole SPARTN message for a
+// SPARTN merger, returning false if it is not a SPARTN message.
+static bool mergerKeyGet(const uint8_t *pInput, size_t messageLengthBytes,
+                         uSpartnMergerKey_t *pKey)
+{
+    bool isMessage = false;
+    size_t crcType = 0;
+    size_t bitOffset;
+    size_t timeTagBits = 16;
+
+    if ((messageLengthBytes <= U_SPARTN_MESSAGE_LENGTH_MAX_BYTES) &&
+        (*pInput == 0x73) &&
+        (decodeHeaderAt(pInput, messageLengthBytes, &crcType) == (int32_t) messageLengthBytes)) {
+        isMessage = true;
+        memset(pKey, 0, sizeof(*pKey));
+        pKey->length = (uint16_t) messageLengthBytes;
+        // TF002 is the top seven bits of the second byte
+        pKey->type = *(pInput + 1) >> 1;
+        // PAYLOAD DESCRIPTION starts at the fifth byte
+        bitOffset = 4 * 8;
+        pKey->subType = (uint8_t) getBits(pInput, bitOffset, 4);
+        bitOffset += 4;
+        if (getBits(pInput, bitOffset, 1)) {
+            timeTagBits = 32;
+        }
+        bitOffset++;
+        pKey->timeTag = getBits(pInput, bitOffset, timeTagBits);
+        bitOffset += timeTagBits;
+        pKey->solutionId = (uint8_t) getBits(pInput, bitOffset, 7);
+        bitOffset += 7;
+        pKey->processorId = (uint8_t) getBits(pInput, bitOffset, 4);
+        // The message CRC is the last crcType + 1 bytes
+        pKey->crc = getBits(pInput + messageLengthBytes - (crcType + 1), 0,
+                            (crcType + 1) * 8);
+    }
+
+    return isMessage;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -353,4 +442,204 @@ int32_t uSpartnValidate(const char *pBuffer, size_t bufferLengthBytes,
     return sizeOrErrorCode;
 }
 
+// Initialise a SPARTN framer.
+void uSpartnFramerInit(uSpartnFramer_t *pFramer)
+{
+    if (pFramer != NULL) {
+        memset(pFramer, 0, sizeof(*pFramer));
+    }
+}
+
+// Pass a chunk of data to a SPARTN framer.
+int32_t uSpartnFramerFrame(uSpartnFramer_t *pFramer,
+                           const char *pBufferIn, size_t bufferLengthBytes,
+                           const char **ppBufferOut,
+                           const char **ppMessage)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    bool keepGoing = true;
+    bool needData;
+    const char *pStart;
+    size_t count;
+    size_t crcType;
+    size_t messageType;
+    int32_t x;
+
+    if ((pFramer != NULL) && (ppMessage != NULL) &&
+        ((pBufferIn != NULL) || (bufferLengthBytes == 0))) {
+        if (pFramer->messageReturned) {
+            // The caller has finished with the last message: remove
+            // it, keeping anything that was buffered after it
+            pFramer->length -= pFramer->messageLength;
+            memmove(pFramer->buffer, pFramer->buffer + pFramer->messageLength,
+                    pFramer->length);
+            pFramer->messageLength = 0;
+            pFramer->messageReturned = false;
+        }
+        while (keepGoing) {
+            if (pFramer->length == 0) {
+                // Nothing buffered: throw away new data up to
+                // the first byte which might start a message
+                pStart = NULL;
+                if (bufferLengthBytes > 0) {
+                    pStart = (const char *) memchr(pBufferIn, 0x73, bufferLengthBytes);
+                }
+                count = bufferLengthBytes;
+                if (pStart != NULL) {
+                    count = pStart - pBufferIn;
+                }
+                pFramer->stats.numBytesDiscarded += count;
+                pBufferIn += count;
+                bufferLengthBytes -= count;
+                keepGoing = (bufferLengthBytes > 0);
+            }
+            if (keepGoing) {
+                needData = true;
+                if ((pFramer->messageLength == 0) &&
+                    (pFramer->length >= U_SPARTN_HEADER_LENGTH_MIN_BYTES)) {
+                    // See if we now have enough of the header to know
+                    // how long the message is
+                    x = decodeHeaderAt((const uint8_t *) pFramer->buffer,
+                                       pFramer->length, &crcType);
+                    if (x > 0) {
+                        pFramer->messageLength = (size_t) x;
+                    } else if (x == (int32_t) U_ERROR_COMMON_NOT_FOUND) {
+                        // Not a message, look again in what is left
+                        framerResync(pFramer);
+                        needData = false;
+                    }
+                }
+                if ((pFramer->messageLength > 0) &&
+                    (pFramer->length >= pFramer->messageLength)) {
+                    // Have the whole message, check its CRC
+                    needData = false;
+                    messageType = ((uint8_t) pFramer->buffer[1]) >> 1;
+                    if (messageType > U_SPARTN_FRAMER_NUM_MESSAGE_TYPES) {
+                        messageType = U_SPARTN_FRAMER_NUM_MESSAGE_TYPES;
+                    }
+                    if (uSpartnValidate(pFramer->buffer, pFramer->messageLength,
+                                        NULL) == (int32_t) pFramer->messageLength) {
+                        pFramer->stats.numMessages[messageType]++;
+                        pFramer->messageReturned = true;
+                        *ppMessage = pFramer->buffer;
+                        sizeOrErrorCode = (int32_t) pFramer->messageLength;
+                        keepGoing = false;
+                    } else {
+                        pFramer->stats.numCrcFailures[messageType]++;
+                        framerResync(pFramer);
+                    }
+                }
+                if (needData) {
+                    // Need more data: the rest of the message if its
+                    // length is known, else enough to decode the header,
+                    // which varies in length, a byte at a time once past
+                    // the minimum so as never to take more than the message
+                    count = 1;
+                    if (pFramer->messageLength > 0) {
+                        count = pFramer->messageLength - pFramer->length;
+                    } else if (pFramer->length < U_SPARTN_HEADER_LENGTH_MIN_BYTES) {
+                        count = U_SPARTN_HEADER_LENGTH_MIN_BYTES - pFramer->length;
+                    }
+                    if (count > bufferLengthBytes) {
+                        count = bufferLengthBytes;
+                    }
+                    memcpy(pFramer->buffer + pFramer->length, pBufferIn, count);
+                    pFramer->length += count;
+                    pBufferIn += count;
+                    bufferLengthBytes -= count;
+                    keepGoing = (count > 0);
+                }
+            }
+        }
+        if (sizeOrErrorCode < 0) {
+            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (pFramer->length > 0) {
+                sizeOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+            }
+        }
+        if (ppBufferOut != NULL) {
+            *ppBufferOut = pBufferIn;
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
+// Get the statistics of a SPARTN framer.
+void uSpartnFramerGetStats(const uSpartnFramer_t *pFramer,
+                           uSpartnFramerStats_t *pStats)
+{
+    if ((pFramer != NULL) && (pStats != NULL)) {
+        *pStats = pFramer->stats;
+    }
+}
+
+// Initialise a SPARTN merger.
+void uSpartnMergerInit(uSpartnMerger_t *pMerger)
+{
+    if (pMerger != NULL) {
+        memset(pMerger, 0, sizeof(*pMerger));
+    }
+}
+
+// Add a SPARTN message to a SPARTN merger.
+int32_t uSpartnMergerAdd(uSpartnMerger_t *pMerger, const char *pMessage,
+                         size_t messageLengthBytes)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uSpartnMergerKey_t key;
+    const uSpartnMergerKey_t *pKey;
+    size_t index;
+
+    if ((pMerger != NULL) && (pMessage != NULL)) {
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        if (mergerKeyGet((const uint8_t *) pMessage, messageLengthBytes, &key)) {
+            sizeOrErrorCode = (int32_t) messageLengthBytes;
+            // Look back through the window, newest first since a
+            // duplicate is most likely to be recent, comparing the
+            // CRC first as it is the field most likely to differ
+            index = pMerger->next;
+            for (size_t x = 0; (x < pMerger->count) && (sizeOrErrorCode > 0); x++) {
+                if (index == 0) {
+                    index = U_SPARTN_MERGER_WINDOW_NUM_MESSAGES;
+                }
+                index--;
+                pKey = &(pMerger->key[index]);
+                if ((pKey->crc == key.crc) && (pKey->timeTag == key.timeTag) &&
+                    (pKey->length == key.length) && (pKey->type == key.type) &&
+                    (pKey->subType == key.subType) &&
+                    (pKey->solutionId == key.solutionId) &&
+                    (pKey->processorId == key.processorId)) {
+                    sizeOrErrorCode = 0;
+                }
+            }
+            if (sizeOrErrorCode > 0) {
+                // First copy: remember it, overwriting the oldest
+                pMerger->key[pMerger->next] = key;
+                pMerger->next++;
+                if (pMerger->next >= U_SPARTN_MERGER_WINDOW_NUM_MESSAGES) {
+                    pMerger->next = 0;
+                }
+                if (pMerger->count < U_SPARTN_MERGER_WINDOW_NUM_MESSAGES) {
+                    pMerger->count++;
+                }
+                pMerger->stats.numForwarded++;
+            } else {
+                pMerger->stats.numDuplicates++;
+            }
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
+// Get the statistics of a SPARTN merger.
+void uSpartnMergerGetStats(const uSpartnMerger_t *pMerger,
+                           uSpartnMergerStats_t *pStats)
+{
+    if ((pMerger != NULL) && (pStats != NULL)) {
+        *pStats = pMerger->stats;
+    }
+}
+
 // End of file
@@ -39,6 +39,11 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#if (U_SPARTN_CRC_SLICE_BY != 1) && (U_SPARTN_CRC_SLICE_BY != 4) && \
+    (U_SPARTN_CRC_SLICE_BY != 8)
+# error U_SPARTN_CRC_SLICE_BY must be 1, 4 or 8.
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -222,10 +227,566 @@ static const uint32_t u32Crc32Table[] = {
     0xAFB010B1U, 0xAB710D06U, 0xA6322BDFU, 0xA2F33668U, 0xBCB4666DU, 0xB8757BDAU, 0xB5365D03U, 0xB1F740B4U
 };
 
+#if U_SPARTN_CRC_SLICE_BY > 1
+
+/** Tables for doing CRC24 U_SPARTN_CRC_SLICE_BY bytes at a time, see
+ * uSpartnCrc24(): entry [k - 1][i] is the CRC24 of the byte i
+ * followed by k zero bytes.
+ */
+static const uint32_t u32Crc24SliceTable[U_SPARTN_CRC_SLICE_BY - 1][256] = {
+    {
+        0x00000000U, 0x00668F48U, 0x00CD1E90U, 0x00AB91D8U, 0x001C71DBU, 0x007AFE93U, 0x00D16F4BU, 0x00B7E003U,
+        0x0038E3B6U, 0x005E6CFEU, 0x00F5FD26U, 0x0093726EU, 0x0024926DU, 0x00421D25U, 0x00E98CFDU, 0x008F03B5U,
+        0x0071C76CU, 0x00174824U, 0x00BCD9FCU, 0x00DA56B4U, 0x006DB6B7U, 0x000B39FFU, 0x00A0A827U, 0x00C6276FU,
+        0x004924DAU, 0x002FAB92U, 0x00843A4AU, 0x00E2B502U, 0x00555501U, 0x0033DA49U, 0x00984B91U, 0x00FEC4D9U,
+        0x00E38ED8U, 0x00850190U, 0x002E9048U, 0x00481F00U, 0x00FFFF03U, 0x0099704BU, 0x0032E193U, 0x00546EDBU,
+        0x00DB6D6EU, 0x00BDE226U, 0x001673FEU, 0x0070FCB6U, 0x00C71CB5U, 0x00A193FDU, 0x000A0225U, 0x006C8D6DU,
+        0x009249B4U, 0x00F4C6FCU, 0x005F5724U, 0x0039D86CU, 0x008E386FU, 0x00E8B727U, 0x004326FFU, 0x0025A9B7U,
+        0x00AAAA02U, 0x00CC254AU, 0x0067B492U, 0x00013BDAU, 0x00B6DBD9U, 0x00D05491U, 0x007BC549U, 0x001D4A01U,
+        0x0041514BU, 0x0027DE03U, 0x008C4FDBU, 0x00EAC093U, 0x005D2090U, 0x003BAFD8U, 0x00903E00U, 0x00F6B148U,
+        0x0079B2FDU, 0x001F3DB5U, 0x00B4AC6DU, 0x00D22325U, 0x0065C326U, 0x00034C6EU, 0x00A8DDB6U, 0x00CE52FEU,
+        0x00309627U, 0x0056196FU, 0x00FD88B7U, 0x009B07FFU, 0x002CE7FCU, 0x004A68B4U, 0x00E1F96CU, 0x00877624U,
+        0x00087591U, 0x006EFAD9U, 0x00C56B01U, 0x00A3E449U, 0x0014044AU, 0x00728B02U, 0x00D91ADAU, 0x00BF9592U,
+        0x00A2DF93U, 0x00C450DBU, 0x006FC103U, 0x00094E4BU, 0x00BEAE48U, 0x00D82100U, 0x0073B0D8U, 0x00153F90U,
+        0x009A3C25U, 0x00FCB36DU, 0x005722B5U, 0x0031ADFDU, 0x00864DFEU, 0x00E0C2B6U, 0x004B536EU, 0x002DDC26U,
+        0x00D318FFU, 0x00B597B7U, 0x001E066FU, 0x00788927U, 0x00CF6924U, 0x00A9E66CU, 0x000277B4U, 0x0064F8FCU,
+        0x00EBFB49U, 0x008D7401U, 0x0026E5D9U, 0x00406A91U, 0x00F78A92U, 0x009105DAU, 0x003A9402U, 0x005C1B4AU,
+        0x0082A296U, 0x00E42DDEU, 0x004FBC06U, 0x0029334EU, 0x009ED34DU, 0x00F85C05U, 0x0053CDDDU, 0x00354295U,
+        0x00BA4120U, 0x00DCCE68U, 0x00775FB0U, 0x0011D0F8U, 0x00A630FBU, 0x00C0BFB3U, 0x006B2E6BU, 0x000DA123U,
+        0x00F365FAU, 0x0095EAB2U, 0x003E7B6AU, 0x0058F422U, 0x00EF1421U, 0x00899B69U, 0x00220AB1U, 0x004485F9U,
+        0x00CB864CU, 0x00AD0904U, 0x000698DCU, 0x00601794U, 0x00D7F797U, 0x00B178DFU, 0x001AE907U, 0x007C664FU,
+        0x00612C4EU, 0x0007A306U, 0x00AC32DEU, 0x00CABD96U, 0x007D5D95U, 0x001BD2DDU, 0x00B04305U, 0x00D6CC4DU,
+        0x0059CFF8U, 0x003F40B0U, 0x0094D168U, 0x00F25E20U, 0x0045BE23U, 0x0023316BU, 0x0088A0B3U, 0x00EE2FFBU,
+        0x0010EB22U, 0x0076646AU, 0x00DDF5B2U, 0x00BB7AFAU, 0x000C9AF9U, 0x006A15B1U, 0x00C18469U, 0x00A70B21U,
+        0x00280894U, 0x004E87DCU, 0x00E51604U, 0x0083994CU, 0x0034794FU, 0x0052F607U, 0x00F967DFU, 0x009FE897U,
+        0x00C3F3DDU, 0x00A57C95U, 0x000EED4DU, 0x00686205U, 0x00DF8206U, 0x00B90D4EU, 0x00129C96U, 0x007413DEU,
+        0x00FB106BU, 0x009D9F23U, 0x00360EFBU, 0x005081B3U, 0x00E761B0U, 0x0081EEF8U, 0x002A7F20U, 0x004CF068U,
+        0x00B234B1U, 0x00D4BBF9U, 0x007F2A21U, 0x0019A569U, 0x00AE456AU, 0x00C8CA22U, 0x00635BFAU, 0x0005D4B2U,
+        0x008AD707U, 0x00EC584FU, 0x0047C997U, 0x002146DFU, 0x0096A6DCU, 0x00F02994U, 0x005BB84CU, 0x003D3704U,
+        0x00207D05U, 0x0046F24DU, 0x00ED6395U, 0x008BECDDU, 0x003C0CDEU, 0x005A8396U, 0x00F1124EU, 0x00979D06U,
+        0x00189EB3U, 0x007E11FBU, 0x00D58023U, 0x00B30F6BU, 0x0004EF68U, 0x00626020U, 0x00C9F1F8U, 0x00AF7EB0U,
+        0x0051BA69U, 0x00373521U, 0x009CA4F9U, 0x00FA2BB1U, 0x004DCBB2U, 0x002B44FAU, 0x0080D522U, 0x00E65A6AU,
+        0x006959DFU, 0x000FD697U, 0x00A4474FU, 0x00C2C807U, 0x00752804U, 0x0013A74CU, 0x00B83694U, 0x00DEB9DCU
+    },
+    {
+        0x00000000U, 0x008309D7U, 0x00805F55U, 0x00035682U, 0x0086F251U, 0x0005FB86U, 0x0006AD04U, 0x0085A4D3U,
+        0x008BA859U, 0x0008A18EU, 0x000BF70CU, 0x0088FEDBU, 0x000D5A08U, 0x008E53DFU, 0x008D055DU, 0x000E0C8AU,
+        0x00911C49U, 0x0012159EU, 0x0011431CU, 0x00924ACBU, 0x0017EE18U, 0x0094E7CFU, 0x0097B14DU, 0x0014B89AU,
+        0x001AB410U, 0x0099BDC7U, 0x009AEB45U, 0x0019E292U, 0x009C4641U, 0x001F4F96U, 0x001C1914U, 0x009F10C3U,
+        0x00A47469U, 0x00277DBEU, 0x00242B3CU, 0x00A722EBU, 0x00228638U, 0x00A18FEFU, 0x00A2D96DU, 0x0021D0BAU,
+        0x002FDC30U, 0x00ACD5E7U, 0x00AF8365U, 0x002C8AB2U, 0x00A92E61U, 0x002A27B6U, 0x00297134U, 0x00AA78E3U,
+        0x00356820U, 0x00B661F7U, 0x00B53775U, 0x00363EA2U, 0x00B39A71U, 0x003093A6U, 0x0033C524U, 0x00B0CCF3U,
+        0x00BEC079U, 0x003DC9AEU, 0x003E9F2CU, 0x00BD96FBU, 0x00383228U, 0x00BB3BFFU, 0x00B86D7DU, 0x003B64AAU,
+        0x00CEA429U, 0x004DADFEU, 0x004EFB7CU, 0x00CDF2ABU, 0x00485678U, 0x00CB5FAFU, 0x00C8092DU, 0x004B00FAU,
+        0x00450C70U, 0x00C605A7U, 0x00C55325U, 0x00465AF2U, 0x00C3FE21U, 0x0040F7F6U, 0x0043A174U, 0x00C0A8A3U,
+        0x005FB860U, 0x00DCB1B7U, 0x00DFE735U, 0x005CEEE2U, 0x00D94A31U, 0x005A43E6U, 0x00591564U, 0x00DA1CB3U,
+        0x00D41039U, 0x005719EEU, 0x00544F6CU, 0x00D746BBU, 0x0052E268U, 0x00D1EBBFU, 0x00D2BD3DU, 0x0051B4EAU,
+        0x006AD040U, 0x00E9D997U, 0x00EA8F15U, 0x006986C2U, 0x00EC2211U, 0x006F2BC6U, 0x006C7D44U, 0x00EF7493U,
+        0x00E17819U, 0x006271CEU, 0x0061274CU, 0x00E22E9BU, 0x00678A48U, 0x00E4839FU, 0x00E7D51DU, 0x0064DCCAU,
+        0x00FBCC09U, 0x0078C5DEU, 0x007B935CU, 0x00F89A8BU, 0x007D3E58U, 0x00FE378FU, 0x00FD610DU, 0x007E68DAU,
+        0x00706450U, 0x00F36D87U, 0x00F03B05U, 0x007332D2U, 0x00F69601U, 0x00759FD6U, 0x0076C954U, 0x00F5C083U,
+        0x001B04A9U, 0x00980D7EU, 0x009B5BFCU, 0x0018522BU, 0x009DF6F8U, 0x001EFF2FU, 0x001DA9ADU, 0x009EA07AU,
+        0x0090ACF0U, 0x0013A527U, 0x0010F3A5U, 0x0093FA72U, 0x00165EA1U, 0x00955776U, 0x009601F4U, 0x00150823U,
+        0x008A18E0U, 0x00091137U, 0x000A47B5U, 0x00894E62U, 0x000CEAB1U, 0x008FE366U, 0x008CB5E4U, 0x000FBC33U,
+        0x0001B0B9U, 0x0082B96EU, 0x0081EFECU, 0x0002E63BU, 0x008742E8U, 0x00044B3FU, 0x00071DBDU, 0x0084146AU,
+        0x00BF70C0U, 0x003C7917U, 0x003F2F95U, 0x00BC2642U, 0x00398291U, 0x00BA8B46U, 0x00B9DDC4U, 0x003AD413U,
+        0x0034D899U, 0x00B7D14EU, 0x00B487CCU, 0x00378E1BU, 0x00B22AC8U, 0x0031231FU, 0x0032759DU, 0x00B17C4AU,
+        0x002E6C89U, 0x00AD655EU, 0x00AE33DCU, 0x002D3A0BU, 0x00A89ED8U, 0x002B970FU, 0x0028C18DU, 0x00ABC85AU,
+        0x00A5C4D0U, 0x0026CD07U, 0x00259B85U, 0x00A69252U, 0x00233681U, 0x00A03F56U, 0x00A369D4U, 0x00206003U,
+        0x00D5A080U, 0x0056A957U, 0x0055FFD5U, 0x00D6F602U, 0x005352D1U, 0x00D05B06U, 0x00D30D84U, 0x00500453U,
+        0x005E08D9U, 0x00DD010EU, 0x00DE578CU, 0x005D5E5BU, 0x00D8FA88U, 0x005BF35FU, 0x0058A5DDU, 0x00DBAC0AU,
+        0x0044BCC9U, 0x00C7B51EU, 0x00C4E39CU, 0x0047EA4BU, 0x00C24E98U, 0x0041474FU, 0x004211CDU, 0x00C1181AU,
+        0x00CF1490U, 0x004C1D47U, 0x004F4BC5U, 0x00CC4212U, 0x0049E6C1U, 0x00CAEF16U, 0x00C9B994U, 0x004AB043U,
+        0x0071D4E9U, 0x00F2DD3EU, 0x00F18BBCU, 0x0072826BU, 0x00F726B8U, 0x00742F6FU, 0x007779EDU, 0x00F4703AU,
+        0x00FA7CB0U, 0x00797567U, 0x007A23E5U, 0x00F92A32U, 0x007C8EE1U, 0x00FF8736U, 0x00FCD1B4U, 0x007FD863U,
+        0x00E0C8A0U, 0x0063C177U, 0x006097F5U, 0x00E39E22U, 0x00663AF1U, 0x00E53326U, 0x00E665A4U, 0x00656C73U,
+        0x006B60F9U, 0x00E8692EU, 0x00EB3FACU, 0x0068367BU, 0x00ED92A8U, 0x006E9B7FU, 0x006DCDFDU, 0x00EEC42AU
+    },
+    {
+        0x00000000U, 0x00360952U, 0x006C12A4U, 0x005A1BF6U, 0x00D82548U, 0x00EE2C1AU, 0x00B437ECU, 0x00823EBEU,
+        0x0036066BU, 0x00000F39U, 0x005A14CFU, 0x006C1D9DU, 0x00EE2323U, 0x00D82A71U, 0x00823187U, 0x00B438D5U,
+        0x006C0CD6U, 0x005A0584U, 0x00001E72U, 0x00361720U, 0x00B4299EU, 0x008220CCU, 0x00D83B3AU, 0x00EE3268U,
+        0x005A0ABDU, 0x006C03EFU, 0x00361819U, 0x0000114BU, 0x00822FF5U, 0x00B426A7U, 0x00EE3D51U, 0x00D83403U,
+        0x00D819ACU, 0x00EE10FEU, 0x00B40B08U, 0x0082025AU, 0x00003CE4U, 0x003635B6U, 0x006C2E40U, 0x005A2712U,
+        0x00EE1FC7U, 0x00D81695U, 0x00820D63U, 0x00B40431U, 0x00363A8FU, 0x000033DDU, 0x005A282BU, 0x006C2179U,
+        0x00B4157AU, 0x00821C28U, 0x00D807DEU, 0x00EE0E8CU, 0x006C3032U, 0x005A3960U, 0x00002296U, 0x00362BC4U,
+        0x00821311U, 0x00B41A43U, 0x00EE01B5U, 0x00D808E7U, 0x005A3659U, 0x006C3F0BU, 0x003624FDU, 0x00002DAFU,
+        0x00367FA3U, 0x000076F1U, 0x005A6D07U, 0x006C6455U, 0x00EE5AEBU, 0x00D853B9U, 0x0082484FU, 0x00B4411DU,
+        0x000079C8U, 0x0036709AU, 0x006C6B6CU, 0x005A623EU, 0x00D85C80U, 0x00EE55D2U, 0x00B44E24U, 0x00824776U,
+        0x005A7375U, 0x006C7A27U, 0x003661D1U, 0x00006883U, 0x0082563DU, 0x00B45F6FU, 0x00EE4499U, 0x00D84DCBU,
+        0x006C751EU, 0x005A7C4CU, 0x000067BAU, 0x00366EE8U, 0x00B45056U, 0x00825904U, 0x00D842F2U, 0x00EE4BA0U,
+        0x00EE660FU, 0x00D86F5DU, 0x008274ABU, 0x00B47DF9U, 0x00364347U, 0x00004A15U, 0x005A51E3U, 0x006C58B1U,
+        0x00D86064U, 0x00EE6936U, 0x00B472C0U, 0x00827B92U, 0x0000452CU, 0x00364C7EU, 0x006C5788U, 0x005A5EDAU,
+        0x00826AD9U, 0x00B4638BU, 0x00EE787DU, 0x00D8712FU, 0x005A4F91U, 0x006C46C3U, 0x00365D35U, 0x00005467U,
+        0x00B46CB2U, 0x008265E0U, 0x00D87E16U, 0x00EE7744U, 0x006C49FAU, 0x005A40A8U, 0x00005B5EU, 0x0036520CU,
+        0x006CFF46U, 0x005AF614U, 0x0000EDE2U, 0x0036E4B0U, 0x00B4DA0EU, 0x0082D35CU, 0x00D8C8AAU, 0x00EEC1F8U,
+        0x005AF92DU, 0x006CF07FU, 0x0036EB89U, 0x0000E2DBU, 0x0082DC65U, 0x00B4D537U, 0x00EECEC1U, 0x00D8C793U,
+        0x0000F390U, 0x0036FAC2U, 0x006CE134U, 0x005AE866U, 0x00D8D6D8U, 0x00EEDF8AU, 0x00B4C47CU, 0x0082CD2EU,
+        0x0036F5FBU, 0x0000FCA9U, 0x005AE75FU, 0x006CEE0DU, 0x00EED0B3U, 0x00D8D9E1U, 0x0082C217U, 0x00B4CB45U,
+        0x00B4E6EAU, 0x0082EFB8U, 0x00D8F44EU, 0x00EEFD1CU, 0x006CC3A2U, 0x005ACAF0U, 0x0000D106U, 0x0036D854U,
+        0x0082E081U, 0x00B4E9D3U, 0x00EEF225U, 0x00D8FB77U, 0x005AC5C9U, 0x006CCC9BU, 0x0036D76DU, 0x0000DE3FU,
+        0x00D8EA3CU, 0x00EEE36EU, 0x00B4F898U, 0x0082F1CAU, 0x0000CF74U, 0x0036C626U, 0x006CDDD0U, 0x005AD482U,
+        0x00EEEC57U, 0x00D8E505U, 0x0082FEF3U, 0x00B4F7A1U, 0x0036C91FU, 0x0000C04DU, 0x005ADBBBU, 0x006CD2E9U,
+        0x005A80E5U, 0x006C89B7U, 0x00369241U, 0x00009B13U, 0x0082A5ADU, 0x00B4ACFFU, 0x00EEB709U, 0x00D8BE5BU,
+        0x006C868EU, 0x005A8FDCU, 0x0000942AU, 0x00369D78U, 0x00B4A3C6U, 0x0082AA94U, 0x00D8B162U, 0x00EEB830U,
+        0x00368C33U, 0x00008561U, 0x005A9E97U, 0x006C97C5U, 0x00EEA97BU, 0x00D8A029U, 0x0082BBDFU, 0x00B4B28DU,
+        0x00008A58U, 0x0036830AU, 0x006C98FCU, 0x005A91AEU, 0x00D8AF10U, 0x00EEA642U, 0x00B4BDB4U, 0x0082B4E6U,
+        0x00829949U, 0x00B4901BU, 0x00EE8BEDU, 0x00D882BFU, 0x005ABC01U, 0x006CB553U, 0x0036AEA5U, 0x0000A7F7U,
+        0x00B49F22U, 0x00829670U, 0x00D88D86U, 0x00EE84D4U, 0x006CBA6AU, 0x005AB338U, 0x0000A8CEU, 0x0036A19CU,
+        0x00EE959FU, 0x00D89CCDU, 0x0082873BU, 0x00B48E69U, 0x0036B0D7U, 0x0000B985U, 0x005AA273U, 0x006CAB21U,
+        0x00D893F4U, 0x00EE9AA6U, 0x00B48150U, 0x00828802U, 0x0000B6BCU, 0x0036BFEEU, 0x006CA418U, 0x005AAD4AU
+    },
+# if U_SPARTN_CRC_SLICE_BY > 4
+    {
+        0x00000000U, 0x00D9FE8CU, 0x0035B1E3U, 0x00EC4F6FU, 0x006B63C6U, 0x00B29D4AU, 0x005ED225U, 0x00872CA9U,
+        0x00D6C78CU, 0x000F3900U, 0x00E3766FU, 0x003A88E3U, 0x00BDA44AU, 0x00645AC6U, 0x008815A9U, 0x0051EB25U,
+        0x002BC3E3U, 0x00F23D6FU, 0x001E7200U, 0x00C78C8CU, 0x0040A025U, 0x00995EA9U, 0x007511C6U, 0x00ACEF4AU,
+        0x00FD046FU, 0x0024FAE3U, 0x00C8B58CU, 0x00114B00U, 0x009667A9U, 0x004F9925U, 0x00A3D64AU, 0x007A28C6U,
+        0x005787C6U, 0x008E794AU, 0x00623625U, 0x00BBC8A9U, 0x003CE400U, 0x00E51A8CU, 0x000955E3U, 0x00D0AB6FU,
+        0x0081404AU, 0x0058BEC6U, 0x00B4F1A9U, 0x006D0F25U, 0x00EA238CU, 0x0033DD00U, 0x00DF926FU, 0x00066CE3U,
+        0x007C4425U, 0x00A5BAA9U, 0x0049F5C6U, 0x00900B4AU, 0x001727E3U, 0x00CED96FU, 0x00229600U, 0x00FB688CU,
+        0x00AA83A9U, 0x00737D25U, 0x009F324AU, 0x0046CCC6U, 0x00C1E06FU, 0x00181EE3U, 0x00F4518CU, 0x002DAF00U,
+        0x00AF0F8CU, 0x0076F100U, 0x009ABE6FU, 0x004340E3U, 0x00C46C4AU, 0x001D92C6U, 0x00F1DDA9U, 0x00282325U,
+        0x0079C800U, 0x00A0368CU, 0x004C79E3U, 0x0095876FU, 0x0012ABC6U, 0x00CB554AU, 0x00271A25U, 0x00FEE4A9U,
+        0x0084CC6FU, 0x005D32E3U, 0x00B17D8CU, 0x00688300U, 0x00EFAFA9U, 0x00365125U, 0x00DA1E4AU, 0x0003E0C6U,
+        0x00520BE3U, 0x008BF56FU, 0x0067BA00U, 0x00BE448CU, 0x00396825U, 0x00E096A9U, 0x000CD9C6U, 0x00D5274AU,
+        0x00F8884AU, 0x002176C6U, 0x00CD39A9U, 0x0014C725U, 0x0093EB8CU, 0x004A1500U, 0x00A65A6FU, 0x007FA4E3U,
+        0x002E4FC6U, 0x00F7B14AU, 0x001BFE25U, 0x00C200A9U, 0x00452C00U, 0x009CD28CU, 0x00709DE3U, 0x00A9636FU,
+        0x00D34BA9U, 0x000AB525U, 0x00E6FA4AU, 0x003F04C6U, 0x00B8286FU, 0x0061D6E3U, 0x008D998CU, 0x00546700U,
+        0x00058C25U, 0x00DC72A9U, 0x00303DC6U, 0x00E9C34AU, 0x006EEFE3U, 0x00B7116FU, 0x005B5E00U, 0x0082A08CU,
+        0x00D853E3U, 0x0001AD6FU, 0x00EDE200U, 0x00341C8CU, 0x00B33025U, 0x006ACEA9U, 0x008681C6U, 0x005F7F4AU,
+        0x000E946FU, 0x00D76AE3U, 0x003B258CU, 0x00E2DB00U, 0x0065F7A9U, 0x00BC0925U, 0x0050464AU, 0x0089B8C6U,
+        0x00F39000U, 0x002A6E8CU, 0x00C621E3U, 0x001FDF6FU, 0x0098F3C6U, 0x00410D4AU, 0x00AD4225U, 0x0074BCA9U,
+        0x0025578CU, 0x00FCA900U, 0x0010E66FU, 0x00C918E3U, 0x004E344AU, 0x0097CAC6U, 0x007B85A9U, 0x00A27B25U,
+        0x008FD425U, 0x00562AA9U, 0x00BA65C6U, 0x00639B4AU, 0x00E4B7E3U, 0x003D496FU, 0x00D10600U, 0x0008F88CU,
+        0x005913A9U, 0x0080ED25U, 0x006CA24AU, 0x00B55CC6U, 0x0032706FU, 0x00EB8EE3U, 0x0007C18CU, 0x00DE3F00U,
+        0x00A417C6U, 0x007DE94AU, 0x0091A625U, 0x004858A9U, 0x00CF7400U, 0x00168A8CU, 0x00FAC5E3U, 0x00233B6FU,
+        0x0072D04AU, 0x00AB2EC6U, 0x004761A9U, 0x009E9F25U, 0x0019B38CU, 0x00C04D00U, 0x002C026FU, 0x00F5FCE3U,
+        0x00775C6FU, 0x00AEA2E3U, 0x0042ED8CU, 0x009B1300U, 0x001C3FA9U, 0x00C5C125U, 0x00298E4AU, 0x00F070C6U,
+        0x00A19BE3U, 0x0078656FU, 0x00942A00U, 0x004DD48CU, 0x00CAF825U, 0x001306A9U, 0x00FF49C6U, 0x0026B74AU,
+        0x005C9F8CU, 0x00856100U, 0x00692E6FU, 0x00B0D0E3U, 0x0037FC4AU, 0x00EE02C6U, 0x00024DA9U, 0x00DBB325U,
+        0x008A5800U, 0x0053A68CU, 0x00BFE9E3U, 0x0066176FU, 0x00E13BC6U, 0x0038C54AU, 0x00D48A25U, 0x000D74A9U,
+        0x0020DBA9U, 0x00F92525U, 0x00156A4AU, 0x00CC94C6U, 0x004BB86FU, 0x009246E3U, 0x007E098CU, 0x00A7F700U,
+        0x00F61C25U, 0x002FE2A9U, 0x00C3ADC6U, 0x001A534AU, 0x009D7FE3U, 0x0044816FU, 0x00A8CE00U, 0x0071308CU,
+        0x000B184AU, 0x00D2E6C6U, 0x003EA9A9U, 0x00E75725U, 0x00607B8CU, 0x00B98500U, 0x0055CA6FU, 0x008C34E3U,
+        0x00DDDFC6U, 0x0004214AU, 0x00E86E25U, 0x003190A9U, 0x00B6BC00U, 0x006F428CU, 0x00830DE3U, 0x005AF36FU
+    },
+    {
+        0x00000000U, 0x0036EB3DU, 0x006DD67AU, 0x005B3D47U, 0x00DBACF4U, 0x00ED47C9U, 0x00B67A8EU, 0x008091B3U,
+        0x00311513U, 0x0007FE2EU, 0x005CC369U, 0x006A2854U, 0x00EAB9E7U, 0x00DC52DAU, 0x00876F9DU, 0x00B184A0U,
+        0x00622A26U, 0x0054C11BU, 0x000FFC5CU, 0x00391761U, 0x00B986D2U, 0x008F6DEFU, 0x00D450A8U, 0x00E2BB95U,
+        0x00533F35U, 0x0065D408U, 0x003EE94FU, 0x00080272U, 0x008893C1U, 0x00BE78FCU, 0x00E545BBU, 0x00D3AE86U,
+        0x00C4544CU, 0x00F2BF71U, 0x00A98236U, 0x009F690BU, 0x001FF8B8U, 0x00291385U, 0x00722EC2U, 0x0044C5FFU,
+        0x00F5415FU, 0x00C3AA62U, 0x00989725U, 0x00AE7C18U, 0x002EEDABU, 0x00180696U, 0x00433BD1U, 0x0075D0ECU,
+        0x00A67E6AU, 0x00909557U, 0x00CBA810U, 0x00FD432DU, 0x007DD29EU, 0x004B39A3U, 0x001004E4U, 0x0026EFD9U,
+        0x00976B79U, 0x00A18044U, 0x00FABD03U, 0x00CC563EU, 0x004CC78DU, 0x007A2CB0U, 0x002111F7U, 0x0017FACAU,
+        0x000EE463U, 0x00380F5EU, 0x00633219U, 0x0055D924U, 0x00D54897U, 0x00E3A3AAU, 0x00B89EEDU, 0x008E75D0U,
+        0x003FF170U, 0x00091A4DU, 0x0052270AU, 0x0064CC37U, 0x00E45D84U, 0x00D2B6B9U, 0x00898BFEU, 0x00BF60C3U,
+        0x006CCE45U, 0x005A2578U, 0x0001183FU, 0x0037F302U, 0x00B762B1U, 0x0081898CU, 0x00DAB4CBU, 0x00EC5FF6U,
+        0x005DDB56U, 0x006B306BU, 0x00300D2CU, 0x0006E611U, 0x008677A2U, 0x00B09C9FU, 0x00EBA1D8U, 0x00DD4AE5U,
+        0x00CAB02FU, 0x00FC5B12U, 0x00A76655U, 0x00918D68U, 0x00111CDBU, 0x0027F7E6U, 0x007CCAA1U, 0x004A219CU,
+        0x00FBA53CU, 0x00CD4E01U, 0x00967346U, 0x00A0987BU, 0x002009C8U, 0x0016E2F5U, 0x004DDFB2U, 0x007B348FU,
+        0x00A89A09U, 0x009E7134U, 0x00C54C73U, 0x00F3A74EU, 0x007336FDU, 0x0045DDC0U, 0x001EE087U, 0x00280BBAU,
+        0x00998F1AU, 0x00AF6427U, 0x00F45960U, 0x00C2B25DU, 0x004223EEU, 0x0074C8D3U, 0x002FF594U, 0x00191EA9U,
+        0x001DC8C6U, 0x002B23FBU, 0x00701EBCU, 0x0046F581U, 0x00C66432U, 0x00F08F0FU, 0x00ABB248U, 0x009D5975U,
+        0x002CDDD5U, 0x001A36E8U, 0x00410BAFU, 0x0077E092U, 0x00F77121U, 0x00C19A1CU, 0x009AA75BU, 0x00AC4C66U,
+        0x007FE2E0U, 0x004909DDU, 0x0012349AU, 0x0024DFA7U, 0x00A44E14U, 0x0092A529U, 0x00C9986EU, 0x00FF7353U,
+        0x004EF7F3U, 0x00781CCEU, 0x00232189U, 0x0015CAB4U, 0x00955B07U, 0x00A3B03AU, 0x00F88D7DU, 0x00CE6640U,
+        0x00D99C8AU, 0x00EF77B7U, 0x00B44AF0U, 0x0082A1CDU, 0x0002307EU, 0x0034DB43U, 0x006FE604U, 0x00590D39U,
+        0x00E88999U, 0x00DE62A4U, 0x00855FE3U, 0x00B3B4DEU, 0x0033256DU, 0x0005CE50U, 0x005EF317U, 0x0068182AU,
+        0x00BBB6ACU, 0x008D5D91U, 0x00D660D6U, 0x00E08BEBU, 0x00601A58U, 0x0056F165U, 0x000DCC22U, 0x003B271FU,
+        0x008AA3BFU, 0x00BC4882U, 0x00E775C5U, 0x00D19EF8U, 0x00510F4BU, 0x0067E476U, 0x003CD931U, 0x000A320CU,
+        0x00132CA5U, 0x0025C798U, 0x007EFADFU, 0x004811E2U, 0x00C88051U, 0x00FE6B6CU, 0x00A5562BU, 0x0093BD16U,
+        0x002239B6U, 0x0014D28BU, 0x004FEFCCU, 0x007904F1U, 0x00F99542U, 0x00CF7E7FU, 0x00944338U, 0x00A2A805U,
+        0x00710683U, 0x0047EDBEU, 0x001CD0F9U, 0x002A3BC4U, 0x00AAAA77U, 0x009C414AU, 0x00C77C0DU, 0x00F19730U,
+        0x00401390U, 0x0076F8ADU, 0x002DC5EAU, 0x001B2ED7U, 0x009BBF64U, 0x00AD5459U, 0x00F6691EU, 0x00C08223U,
+        0x00D778E9U, 0x00E193D4U, 0x00BAAE93U, 0x008C45AEU, 0x000CD41DU, 0x003A3F20U, 0x00610267U, 0x0057E95AU,
+        0x00E66DFAU, 0x00D086C7U, 0x008BBB80U, 0x00BD50BDU, 0x003DC10EU, 0x000B2A33U, 0x00501774U, 0x0066FC49U,
+        0x00B552CFU, 0x0083B9F2U, 0x00D884B5U, 0x00EE6F88U, 0x006EFE3BU, 0x00581506U, 0x00032841U, 0x0035C37CU,
+        0x008447DCU, 0x00B2ACE1U, 0x00E991A6U, 0x00DF7A9BU, 0x005FEB28U, 0x00690015U, 0x00323D52U, 0x0004D66FU
+    },
+    {
+        0x00000000U, 0x003B918CU, 0x00772318U, 0x004CB294U, 0x00EE4630U, 0x00D5D7BCU, 0x00996528U, 0x00A2F4A4U,
+        0x005AC09BU, 0x00615117U, 0x002DE383U, 0x0016720FU, 0x00B486ABU, 0x008F1727U, 0x00C3A5B3U, 0x00F8343FU,
+        0x00B58136U, 0x008E10BAU, 0x00C2A22EU, 0x00F933A2U, 0x005BC706U, 0x0060568AU, 0x002CE41EU, 0x00177592U,
+        0x00EF41ADU, 0x00D4D021U, 0x009862B5U, 0x00A3F339U, 0x0001079DU, 0x003A9611U, 0x00762485U, 0x004DB509U,
+        0x00ED4E97U, 0x00D6DF1BU, 0x009A6D8FU, 0x00A1FC03U, 0x000308A7U, 0x0038992BU, 0x00742BBFU, 0x004FBA33U,
+        0x00B78E0CU, 0x008C1F80U, 0x00C0AD14U, 0x00FB3C98U, 0x0059C83CU, 0x006259B0U, 0x002EEB24U, 0x00157AA8U,
+        0x0058CFA1U, 0x00635E2DU, 0x002FECB9U, 0x00147D35U, 0x00B68991U, 0x008D181DU, 0x00C1AA89U, 0x00FA3B05U,
+        0x00020F3AU, 0x00399EB6U, 0x00752C22U, 0x004EBDAEU, 0x00EC490AU, 0x00D7D886U, 0x009B6A12U, 0x00A0FB9EU,
+        0x005CD1D5U, 0x00674059U, 0x002BF2CDU, 0x00106341U, 0x00B297E5U, 0x00890669U, 0x00C5B4FDU, 0x00FE2571U,
+        0x0006114EU, 0x003D80C2U, 0x00713256U, 0x004AA3DAU, 0x00E8577EU, 0x00D3C6F2U, 0x009F7466U, 0x00A4E5EAU,
+        0x00E950E3U, 0x00D2C16FU, 0x009E73FBU, 0x00A5E277U, 0x000716D3U, 0x003C875FU, 0x007035CBU, 0x004BA447U,
+        0x00B39078U, 0x008801F4U, 0x00C4B360U, 0x00FF22ECU, 0x005DD648U, 0x006647C4U, 0x002AF550U, 0x001164DCU,
+        0x00B19F42U, 0x008A0ECEU, 0x00C6BC5AU, 0x00FD2DD6U, 0x005FD972U, 0x006448FEU, 0x0028FA6AU, 0x00136BE6U,
+        0x00EB5FD9U, 0x00D0CE55U, 0x009C7CC1U, 0x00A7ED4DU, 0x000519E9U, 0x003E8865U, 0x00723AF1U, 0x0049AB7DU,
+        0x00041E74U, 0x003F8FF8U, 0x00733D6CU, 0x0048ACE0U, 0x00EA5844U, 0x00D1C9C8U, 0x009D7B5CU, 0x00A6EAD0U,
+        0x005EDEEFU, 0x00654F63U, 0x0029FDF7U, 0x00126C7BU, 0x00B098DFU, 0x008B0953U, 0x00C7BBC7U, 0x00FC2A4BU,
+        0x00B9A3AAU, 0x00823226U, 0x00CE80B2U, 0x00F5113EU, 0x0057E59AU, 0x006C7416U, 0x0020C682U, 0x001B570EU,
+        0x00E36331U, 0x00D8F2BDU, 0x00944029U, 0x00AFD1A5U, 0x000D2501U, 0x0036B48DU, 0x007A0619U, 0x00419795U,
+        0x000C229CU, 0x0037B310U, 0x007B0184U, 0x00409008U, 0x00E264ACU, 0x00D9F520U, 0x009547B4U, 0x00AED638U,
+        0x0056E207U, 0x006D738BU, 0x0021C11FU, 0x001A5093U, 0x00B8A437U, 0x008335BBU, 0x00CF872FU, 0x00F416A3U,
+        0x0054ED3DU, 0x006F7CB1U, 0x0023CE25U, 0x00185FA9U, 0x00BAAB0DU, 0x00813A81U, 0x00CD8815U, 0x00F61999U,
+        0x000E2DA6U, 0x0035BC2AU, 0x00790EBEU, 0x00429F32U, 0x00E06B96U, 0x00DBFA1AU, 0x0097488EU, 0x00ACD902U,
+        0x00E16C0BU, 0x00DAFD87U, 0x00964F13U, 0x00ADDE9FU, 0x000F2A3BU, 0x0034BBB7U, 0x00780923U, 0x004398AFU,
+        0x00BBAC90U, 0x00803D1CU, 0x00CC8F88U, 0x00F71E04U, 0x0055EAA0U, 0x006E7B2CU, 0x0022C9B8U, 0x00195834U,
+        0x00E5727FU, 0x00DEE3F3U, 0x00925167U, 0x00A9C0EBU, 0x000B344FU, 0x0030A5C3U, 0x007C1757U, 0x004786DBU,
+        0x00BFB2E4U, 0x00842368U, 0x00C891FCU, 0x00F30070U, 0x0051F4D4U, 0x006A6558U, 0x0026D7CCU, 0x001D4640U,
+        0x0050F349U, 0x006B62C5U, 0x0027D051U, 0x001C41DDU, 0x00BEB579U, 0x008524F5U, 0x00C99661U, 0x00F207EDU,
+        0x000A33D2U, 0x0031A25EU, 0x007D10CAU, 0x00468146U, 0x00E475E2U, 0x00DFE46EU, 0x009356FAU, 0x00A8C776U,
+        0x00083CE8U, 0x0033AD64U, 0x007F1FF0U, 0x00448E7CU, 0x00E67AD8U, 0x00DDEB54U, 0x009159C0U, 0x00AAC84CU,
+        0x0052FC73U, 0x00696DFFU, 0x0025DF6BU, 0x001E4EE7U, 0x00BCBA43U, 0x00872BCFU, 0x00CB995BU, 0x00F008D7U,
+        0x00BDBDDEU, 0x00862C52U, 0x00CA9EC6U, 0x00F10F4AU, 0x0053FBEEU, 0x00686A62U, 0x0024D8F6U, 0x001F497AU,
+        0x00E77D45U, 0x00DCECC9U, 0x00905E5DU, 0x00ABCFD1U, 0x00093B75U, 0x0032AAF9U, 0x007E186DU, 0x004589E1U
+    },
+    {
+        0x00000000U, 0x00F50BAFU, 0x006C5BA5U, 0x0099500AU, 0x00D8B74AU, 0x002DBCE5U, 0x00B4ECEFU, 0x0041E740U,
+        0x0037226FU, 0x00C229C0U, 0x005B79CAU, 0x00AE7265U, 0x00EF9525U, 0x001A9E8AU, 0x0083CE80U, 0x0076C52FU,
+        0x006E44DEU, 0x009B4F71U, 0x00021F7BU, 0x00F714D4U, 0x00B6F394U, 0x0043F83BU, 0x00DAA831U, 0x002FA39EU,
+        0x005966B1U, 0x00AC6D1EU, 0x00353D14U, 0x00C036BBU, 0x0081D1FBU, 0x0074DA54U, 0x00ED8A5EU, 0x001881F1U,
+        0x00DC89BCU, 0x00298213U, 0x00B0D219U, 0x0045D9B6U, 0x00043EF6U, 0x00F13559U, 0x00686553U, 0x009D6EFCU,
+        0x00EBABD3U, 0x001EA07CU, 0x0087F076U, 0x0072FBD9U, 0x00331C99U, 0x00C61736U, 0x005F473CU, 0x00AA4C93U,
+        0x00B2CD62U, 0x0047C6CDU, 0x00DE96C7U, 0x002B9D68U, 0x006A7A28U, 0x009F7187U, 0x0006218DU, 0x00F32A22U,
+        0x0085EF0DU, 0x0070E4A2U, 0x00E9B4A8U, 0x001CBF07U, 0x005D5847U, 0x00A853E8U, 0x003103E2U, 0x00C4084DU,
+        0x003F5F83U, 0x00CA542CU, 0x00530426U, 0x00A60F89U, 0x00E7E8C9U, 0x0012E366U, 0x008BB36CU, 0x007EB8C3U,
+        0x00087DECU, 0x00FD7643U, 0x00642649U, 0x00912DE6U, 0x00D0CAA6U, 0x0025C109U, 0x00BC9103U, 0x00499AACU,
+        0x00511B5DU, 0x00A410F2U, 0x003D40F8U, 0x00C84B57U, 0x0089AC17U, 0x007CA7B8U, 0x00E5F7B2U, 0x0010FC1DU,
+        0x00663932U, 0x0093329DU, 0x000A6297U, 0x00FF6938U, 0x00BE8E78U, 0x004B85D7U, 0x00D2D5DDU, 0x0027DE72U,
+        0x00E3D63FU, 0x0016DD90U, 0x008F8D9AU, 0x007A8635U, 0x003B6175U, 0x00CE6ADAU, 0x00573AD0U, 0x00A2317FU,
+        0x00D4F450U, 0x0021FFFFU, 0x00B8AFF5U, 0x004DA45AU, 0x000C431AU, 0x00F948B5U, 0x006018BFU, 0x00951310U,
+        0x008D92E1U, 0x0078994EU, 0x00E1C944U, 0x0014C2EBU, 0x005525ABU, 0x00A02E04U, 0x00397E0EU, 0x00CC75A1U,
+        0x00BAB08EU, 0x004FBB21U, 0x00D6EB2BU, 0x0023E084U, 0x006207C4U, 0x00970C6BU, 0x000E5C61U, 0x00FB57CEU,
+        0x007EBF06U, 0x008BB4A9U, 0x0012E4A3U, 0x00E7EF0CU, 0x00A6084CU, 0x005303E3U, 0x00CA53E9U, 0x003F5846U,
+        0x00499D69U, 0x00BC96C6U, 0x0025C6CCU, 0x00D0CD63U, 0x00912A23U, 0x0064218CU, 0x00FD7186U, 0x00087A29U,
+        0x0010FBD8U, 0x00E5F077U, 0x007CA07DU, 0x0089ABD2U, 0x00C84C92U, 0x003D473DU, 0x00A41737U, 0x00511C98U,
+        0x0027D9B7U, 0x00D2D218U, 0x004B8212U, 0x00BE89BDU, 0x00FF6EFDU, 0x000A6552U, 0x00933558U, 0x00663EF7U,
+        0x00A236BAU, 0x00573D15U, 0x00CE6D1FU, 0x003B66B0U, 0x007A81F0U, 0x008F8A5FU, 0x0016DA55U, 0x00E3D1FAU,
+        0x009514D5U, 0x00601F7AU, 0x00F94F70U, 0x000C44DFU, 0x004DA39FU, 0x00B8A830U, 0x0021F83AU, 0x00D4F395U,
+        0x00CC7264U, 0x003979CBU, 0x00A029C1U, 0x0055226EU, 0x0014C52EU, 0x00E1CE81U, 0x00789E8BU, 0x008D9524U,
+        0x00FB500BU, 0x000E5BA4U, 0x00970BAEU, 0x00620001U, 0x0023E741U, 0x00D6ECEEU, 0x004FBCE4U, 0x00BAB74BU,
+        0x0041E085U, 0x00B4EB2AU, 0x002DBB20U, 0x00D8B08FU, 0x009957CFU, 0x006C5C60U, 0x00F50C6AU, 0x000007C5U,
+        0x0076C2EAU, 0x0083C945U, 0x001A994FU, 0x00EF92E0U, 0x00AE75A0U, 0x005B7E0FU, 0x00C22E05U, 0x003725AAU,
+        0x002FA45BU, 0x00DAAFF4U, 0x0043FFFEU, 0x00B6F451U, 0x00F71311U, 0x000218BEU, 0x009B48B4U, 0x006E431BU,
+        0x00188634U, 0x00ED8D9BU, 0x0074DD91U, 0x0081D63EU, 0x00C0317EU, 0x00353AD1U, 0x00AC6ADBU, 0x00596174U,
+        0x009D6939U, 0x00686296U, 0x00F1329CU, 0x00043933U, 0x0045DE73U, 0x00B0D5DCU, 0x002985D6U, 0x00DC8E79U,
+        0x00AA4B56U, 0x005F40F9U, 0x00C610F3U, 0x00331B5CU, 0x0072FC1CU, 0x0087F7B3U, 0x001EA7B9U, 0x00EBAC16U,
+        0x00F32DE7U, 0x00062648U, 0x009F7642U, 0x006A7DEDU, 0x002B9AADU, 0x00DE9102U, 0x0047C108U, 0x00B2CAA7U,
+        0x00C40F88U, 0x00310427U, 0x00A8542DU, 0x005D5F82U, 0x001CB8C2U, 0x00E9B36DU, 0x0070E367U, 0x0085E8C8U
+    },
+# endif
+};
+
+/** Tables for doing CRC32 U_SPARTN_CRC_SLICE_BY bytes at a time, see
+ * uSpartnCrc32(): entry [k - 1][i] is the CRC32 of the byte i
+ * followed by k zero bytes.
+ */
+static const uint32_t u32Crc32SliceTable[U_SPARTN_CRC_SLICE_BY - 1][256] = {
+    {
+        0x00000000U, 0xD219C1DCU, 0xA0F29E0FU, 0x72EB5FD3U, 0x452421A9U, 0x973DE075U, 0xE5D6BFA6U, 0x37CF7E7AU,
+        0x8A484352U, 0x5851828EU, 0x2ABADD5DU, 0xF8A31C81U, 0xCF6C62FBU, 0x1D75A327U, 0x6F9EFCF4U, 0xBD873D28U,
+        0x10519B13U, 0xC2485ACFU, 0xB0A3051CU, 0x62BAC4C0U, 0x5575BABAU, 0x876C7B66U, 0xF58724B5U, 0x279EE569U,
+        0x9A19D841U, 0x4800199DU, 0x3AEB464EU, 0xE8F28792U, 0xDF3DF9E8U, 0x0D243834U, 0x7FCF67E7U, 0xADD6A63BU,
+        0x20A33626U, 0xF2BAF7FAU, 0x8051A829U, 0x524869F5U, 0x6587178FU, 0xB79ED653U, 0xC5758980U, 0x176C485CU,
+        0xAAEB7574U, 0x78F2B4A8U, 0x0A19EB7BU, 0xD8002AA7U, 0xEFCF54DDU, 0x3DD69501U, 0x4F3DCAD2U, 0x9D240B0EU,
+        0x30F2AD35U, 0xE2EB6CE9U, 0x9000333AU, 0x4219F2E6U, 0x75D68C9CU, 0xA7CF4D40U, 0xD5241293U, 0x073DD34FU,
+        0xBABAEE67U, 0x68A32FBBU, 0x1A487068U, 0xC851B1B4U, 0xFF9ECFCEU, 0x2D870E12U, 0x5F6C51C1U, 0x8D75901DU,
+        0x41466C4CU, 0x935FAD90U, 0xE1B4F243U, 0x33AD339FU, 0x04624DE5U, 0xD67B8C39U, 0xA490D3EAU, 0x76891236U,
+        0xCB0E2F1EU, 0x1917EEC2U, 0x6BFCB111U, 0xB9E570CDU, 0x8E2A0EB7U, 0x5C33CF6BU, 0x2ED890B8U, 0xFCC15164U,
+        0x5117F75FU, 0x830E3683U, 0xF1E56950U, 0x23FCA88CU, 0x1433D6F6U, 0xC62A172AU, 0xB4C148F9U, 0x66D88925U,
+        0xDB5FB40DU, 0x094675D1U, 0x7BAD2A02U, 0xA9B4EBDEU, 0x9E7B95A4U, 0x4C625478U, 0x3E890BABU, 0xEC90CA77U,
+        0x61E55A6AU, 0xB3FC9BB6U, 0xC117C465U, 0x130E05B9U, 0x24C17BC3U, 0xF6D8BA1FU, 0x8433E5CCU, 0x562A2410U,
+        0xEBAD1938U, 0x39B4D8E4U, 0x4B5F8737U, 0x994646EBU, 0xAE893891U, 0x7C90F94DU, 0x0E7BA69EU, 0xDC626742U,
+        0x71B4C179U, 0xA3AD00A5U, 0xD1465F76U, 0x035F9EAAU, 0x3490E0D0U, 0xE689210CU, 0x94627EDFU, 0x467BBF03U,
+        0xFBFC822BU, 0x29E543F7U, 0x5B0E1C24U, 0x8917DDF8U, 0xBED8A382U, 0x6CC1625EU, 0x1E2A3D8DU, 0xCC33FC51U,
+        0x828CD898U, 0x50951944U, 0x227E4697U, 0xF067874BU, 0xC7A8F931U, 0x15B138EDU, 0x675A673EU, 0xB543A6E2U,
+        0x08C49BCAU, 0xDADD5A16U, 0xA83605C5U, 0x7A2FC419U, 0x4DE0BA63U, 0x9FF97BBFU, 0xED12246CU, 0x3F0BE5B0U,
+        0x92DD438BU, 0x40C48257U, 0x322FDD84U, 0xE0361C58U, 0xD7F96222U, 0x05E0A3FEU, 0x770BFC2DU, 0xA5123DF1U,
+        0x189500D9U, 0xCA8CC105U, 0xB8679ED6U, 0x6A7E5F0AU, 0x5DB12170U, 0x8FA8E0ACU, 0xFD43BF7FU, 0x2F5A7EA3U,
+        0xA22FEEBEU, 0x70362F62U, 0x02DD70B1U, 0xD0C4B16DU, 0xE70BCF17U, 0x35120ECBU, 0x47F95118U, 0x95E090C4U,
+        0x2867ADECU, 0xFA7E6C30U, 0x889533E3U, 0x5A8CF23FU, 0x6D438C45U, 0xBF5A4D99U, 0xCDB1124AU, 0x1FA8D396U,
+        0xB27E75ADU, 0x6067B471U, 0x128CEBA2U, 0xC0952A7EU, 0xF75A5404U, 0x254395D8U, 0x57A8CA0BU, 0x85B10BD7U,
+        0x383636FFU, 0xEA2FF723U, 0x98C4A8F0U, 0x4ADD692CU, 0x7D121756U, 0xAF0BD68AU, 0xDDE08959U, 0x0FF94885U,
+        0xC3CAB4D4U, 0x11D37508U, 0x63382ADBU, 0xB121EB07U, 0x86EE957DU, 0x54F754A1U, 0x261C0B72U, 0xF405CAAEU,
+        0x4982F786U, 0x9B9B365AU, 0xE9706989U, 0x3B69A855U, 0x0CA6D62FU, 0xDEBF17F3U, 0xAC544820U, 0x7E4D89FCU,
+        0xD39B2FC7U, 0x0182EE1BU, 0x7369B1C8U, 0xA1707014U, 0x96BF0E6EU, 0x44A6CFB2U, 0x364D9061U, 0xE45451BDU,
+        0x59D36C95U, 0x8BCAAD49U, 0xF921F29AU, 0x2B383346U, 0x1CF74D3CU, 0xCEEE8CE0U, 0xBC05D333U, 0x6E1C12EFU,
+        0xE36982F2U, 0x3170432EU, 0x439B1CFDU, 0x9182DD21U, 0xA64DA35BU, 0x74546287U, 0x06BF3D54U, 0xD4A6FC88U,
+        0x6921C1A0U, 0xBB38007CU, 0xC9D35FAFU, 0x1BCA9E73U, 0x2C05E009U, 0xFE1C21D5U, 0x8CF77E06U, 0x5EEEBFDAU,
+        0xF33819E1U, 0x2121D83DU, 0x53CA87EEU, 0x81D34632U, 0xB61C3848U, 0x6405F994U, 0x16EEA647U, 0xC4F7679BU,
+        0x79705AB3U, 0xAB699B6FU, 0xD982C4BCU, 0x0B9B0560U, 0x3C547B1AU, 0xEE4DBAC6U, 0x9CA6E515U, 0x4EBF24C9U
+    },
+    {
+        0x00000000U, 0x01D8AC87U, 0x03B1590EU, 0x0269F589U, 0x0762B21CU, 0x06BA1E9BU, 0x04D3EB12U, 0x050B4795U,
+        0x0EC56438U, 0x0F1DC8BFU, 0x0D743D36U, 0x0CAC91B1U, 0x09A7D624U, 0x087F7AA3U, 0x0A168F2AU, 0x0BCE23ADU,
+        0x1D8AC870U, 0x1C5264F7U, 0x1E3B917EU, 0x1FE33DF9U, 0x1AE87A6CU, 0x1B30D6EBU, 0x19592362U, 0x18818FE5U,
+        0x134FAC48U, 0x129700CFU, 0x10FEF546U, 0x112659C1U, 0x142D1E54U, 0x15F5B2D3U, 0x179C475AU, 0x1644EBDDU,
+        0x3B1590E0U, 0x3ACD3C67U, 0x38A4C9EEU, 0x397C6569U, 0x3C7722FCU, 0x3DAF8E7BU, 0x3FC67BF2U, 0x3E1ED775U,
+        0x35D0F4D8U, 0x3408585FU, 0x3661ADD6U, 0x37B90151U, 0x32B246C4U, 0x336AEA43U, 0x31031FCAU, 0x30DBB34DU,
+        0x269F5890U, 0x2747F417U, 0x252E019EU, 0x24F6AD19U, 0x21FDEA8CU, 0x2025460BU, 0x224CB382U, 0x23941F05U,
+        0x285A3CA8U, 0x2982902FU, 0x2BEB65A6U, 0x2A33C921U, 0x2F388EB4U, 0x2EE02233U, 0x2C89D7BAU, 0x2D517B3DU,
+        0x762B21C0U, 0x77F38D47U, 0x759A78CEU, 0x7442D449U, 0x714993DCU, 0x70913F5BU, 0x72F8CAD2U, 0x73206655U,
+        0x78EE45F8U, 0x7936E97FU, 0x7B5F1CF6U, 0x7A87B071U, 0x7F8CF7E4U, 0x7E545B63U, 0x7C3DAEEAU, 0x7DE5026DU,
+        0x6BA1E9B0U, 0x6A794537U, 0x6810B0BEU, 0x69C81C39U, 0x6CC35BACU, 0x6D1BF72BU, 0x6F7202A2U, 0x6EAAAE25U,
+        0x65648D88U, 0x64BC210FU, 0x66D5D486U, 0x670D7801U, 0x62063F94U, 0x63DE9313U, 0x61B7669AU, 0x606FCA1DU,
+        0x4D3EB120U, 0x4CE61DA7U, 0x4E8FE82EU, 0x4F5744A9U, 0x4A5C033CU, 0x4B84AFBBU, 0x49ED5A32U, 0x4835F6B5U,
+        0x43FBD518U, 0x4223799FU, 0x404A8C16U, 0x41922091U, 0x44996704U, 0x4541CB83U, 0x47283E0AU, 0x46F0928DU,
+        0x50B47950U, 0x516CD5D7U, 0x5305205EU, 0x52DD8CD9U, 0x57D6CB4CU, 0x560E67CBU, 0x54679242U, 0x55BF3EC5U,
+        0x5E711D68U, 0x5FA9B1EFU, 0x5DC04466U, 0x5C18E8E1U, 0x5913AF74U, 0x58CB03F3U, 0x5AA2F67AU, 0x5B7A5AFDU,
+        0xEC564380U, 0xED8EEF07U, 0xEFE71A8EU, 0xEE3FB609U, 0xEB34F19CU, 0xEAEC5D1BU, 0xE885A892U, 0xE95D0415U,
+        0xE29327B8U, 0xE34B8B3FU, 0xE1227EB6U, 0xE0FAD231U, 0xE5F195A4U, 0xE4293923U, 0xE640CCAAU, 0xE798602DU,
+        0xF1DC8BF0U, 0xF0042777U, 0xF26DD2FEU, 0xF3B57E79U, 0xF6BE39ECU, 0xF766956BU, 0xF50F60E2U, 0xF4D7CC65U,
+        0xFF19EFC8U, 0xFEC1434FU, 0xFCA8B6C6U, 0xFD701A41U, 0xF87B5DD4U, 0xF9A3F153U, 0xFBCA04DAU, 0xFA12A85DU,
+        0xD743D360U, 0xD69B7FE7U, 0xD4F28A6EU, 0xD52A26E9U, 0xD021617CU, 0xD1F9CDFBU, 0xD3903872U, 0xD24894F5U,
+        0xD986B758U, 0xD85E1BDFU, 0xDA37EE56U, 0xDBEF42D1U, 0xDEE40544U, 0xDF3CA9C3U, 0xDD555C4AU, 0xDC8DF0CDU,
+        0xCAC91B10U, 0xCB11B797U, 0xC978421EU, 0xC8A0EE99U, 0xCDABA90CU, 0xCC73058BU, 0xCE1AF002U, 0xCFC25C85U,
+        0xC40C7F28U, 0xC5D4D3AFU, 0xC7BD2626U, 0xC6658AA1U, 0xC36ECD34U, 0xC2B661B3U, 0xC0DF943AU, 0xC10738BDU,
+        0x9A7D6240U, 0x9BA5CEC7U, 0x99CC3B4EU, 0x981497C9U, 0x9D1FD05CU, 0x9CC77CDBU, 0x9EAE8952U, 0x9F7625D5U,
+        0x94B80678U, 0x9560AAFFU, 0x97095F76U, 0x96D1F3F1U, 0x93DAB464U, 0x920218E3U, 0x906BED6AU, 0x91B341EDU,
+        0x87F7AA30U, 0x862F06B7U, 0x8446F33EU, 0x859E5FB9U, 0x8095182CU, 0x814DB4ABU, 0x83244122U, 0x82FCEDA5U,
+        0x8932CE08U, 0x88EA628FU, 0x8A839706U, 0x8B5B3B81U, 0x8E507C14U, 0x8F88D093U, 0x8DE1251AU, 0x8C39899DU,
+        0xA168F2A0U, 0xA0B05E27U, 0xA2D9ABAEU, 0xA3010729U, 0xA60A40BCU, 0xA7D2EC3BU, 0xA5BB19B2U, 0xA463B535U,
+        0xAFAD9698U, 0xAE753A1FU, 0xAC1CCF96U, 0xADC46311U, 0xA8CF2484U, 0xA9178803U, 0xAB7E7D8AU, 0xAAA6D10DU,
+        0xBCE23AD0U, 0xBD3A9657U, 0xBF5363DEU, 0xBE8BCF59U, 0xBB8088CCU, 0xBA58244BU, 0xB831D1C2U, 0xB9E97D45U,
+        0xB2275EE8U, 0xB3FFF26FU, 0xB19607E6U, 0xB04EAB61U, 0xB545ECF4U, 0xB49D4073U, 0xB6F4B5FAU, 0xB72C197DU
+    },
+    {
+        0x00000000U, 0xDC6D9AB7U, 0xBC1A28D9U, 0x6077B26EU, 0x7CF54C05U, 0xA098D6B2U, 0xC0EF64DCU, 0x1C82FE6BU,
+        0xF9EA980AU, 0x258702BDU, 0x45F0B0D3U, 0x999D2A64U, 0x851FD40FU, 0x59724EB8U, 0x3905FCD6U, 0xE5686661U,
+        0xF7142DA3U, 0x2B79B714U, 0x4B0E057AU, 0x97639FCDU, 0x8BE161A6U, 0x578CFB11U, 0x37FB497FU, 0xEB96D3C8U,
+        0x0EFEB5A9U, 0xD2932F1EU, 0xB2E49D70U, 0x6E8907C7U, 0x720BF9ACU, 0xAE66631BU, 0xCE11D175U, 0x127C4BC2U,
+        0xEAE946F1U, 0x3684DC46U, 0x56F36E28U, 0x8A9EF49FU, 0x961C0AF4U, 0x4A719043U, 0x2A06222DU, 0xF66BB89AU,
+        0x1303DEFBU, 0xCF6E444CU, 0xAF19F622U, 0x73746C95U, 0x6FF692FEU, 0xB39B0849U, 0xD3ECBA27U, 0x0F812090U,
+        0x1DFD6B52U, 0xC190F1E5U, 0xA1E7438BU, 0x7D8AD93CU, 0x61082757U, 0xBD65BDE0U, 0xDD120F8EU, 0x017F9539U,
+        0xE417F358U, 0x387A69EFU, 0x580DDB81U, 0x84604136U, 0x98E2BF5DU, 0x448F25EAU, 0x24F89784U, 0xF8950D33U,
+        0xD1139055U, 0x0D7E0AE2U, 0x6D09B88CU, 0xB164223BU, 0xADE6DC50U, 0x718B46E7U, 0x11FCF489U, 0xCD916E3EU,
+        0x28F9085FU, 0xF49492E8U, 0x94E32086U, 0x488EBA31U, 0x540C445AU, 0x8861DEEDU, 0xE8166C83U, 0x347BF634U,
+        0x2607BDF6U, 0xFA6A2741U, 0x9A1D952FU, 0x46700F98U, 0x5AF2F1F3U, 0x869F6B44U, 0xE6E8D92AU, 0x3A85439DU,
+        0xDFED25FCU, 0x0380BF4BU, 0x63F70D25U, 0xBF9A9792U, 0xA31869F9U, 0x7F75F34EU, 0x1F024120U, 0xC36FDB97U,
+        0x3BFAD6A4U, 0xE7974C13U, 0x87E0FE7DU, 0x5B8D64CAU, 0x470F9AA1U, 0x9B620016U, 0xFB15B278U, 0x277828CFU,
+        0xC2104EAEU, 0x1E7DD419U, 0x7E0A6677U, 0xA267FCC0U, 0xBEE502ABU, 0x6288981CU, 0x02FF2A72U, 0xDE92B0C5U,
+        0xCCEEFB07U, 0x108361B0U, 0x70F4D3DEU, 0xAC994969U, 0xB01BB702U, 0x6C762DB5U, 0x0C019FDBU, 0xD06C056CU,
+        0x3504630DU, 0xE969F9BAU, 0x891E4BD4U, 0x5573D163U, 0x49F12F08U, 0x959CB5BFU, 0xF5EB07D1U, 0x29869D66U,
+        0xA6E63D1DU, 0x7A8BA7AAU, 0x1AFC15C4U, 0xC6918F73U, 0xDA137118U, 0x067EEBAFU, 0x660959C1U, 0xBA64C376U,
+        0x5F0CA517U, 0x83613FA0U, 0xE3168DCEU, 0x3F7B1779U, 0x23F9E912U, 0xFF9473A5U, 0x9FE3C1CBU, 0x438E5B7CU,
+        0x51F210BEU, 0x8D9F8A09U, 0xEDE83867U, 0x3185A2D0U, 0x2D075CBBU, 0xF16AC60CU, 0x911D7462U, 0x4D70EED5U,
+        0xA81888B4U, 0x74751203U, 0x1402A06DU, 0xC86F3ADAU, 0xD4EDC4B1U, 0x08805E06U, 0x68F7EC68U, 0xB49A76DFU,
+        0x4C0F7BECU, 0x9062E15BU, 0xF0155335U, 0x2C78C982U, 0x30FA37E9U, 0xEC97AD5EU, 0x8CE01F30U, 0x508D8587U,
+        0xB5E5E3E6U, 0x69887951U, 0x09FFCB3FU, 0xD5925188U, 0xC910AFE3U, 0x157D3554U, 0x750A873AU, 0xA9671D8DU,
+        0xBB1B564FU, 0x6776CCF8U, 0x07017E96U, 0xDB6CE421U, 0xC7EE1A4AU, 0x1B8380FDU, 0x7BF43293U, 0xA799A824U,
+        0x42F1CE45U, 0x9E9C54F2U, 0xFEEBE69CU, 0x22867C2BU, 0x3E048240U, 0xE26918F7U, 0x821EAA99U, 0x5E73302EU,
+        0x77F5AD48U, 0xAB9837FFU, 0xCBEF8591U, 0x17821F26U, 0x0B00E14DU, 0xD76D7BFAU, 0xB71AC994U, 0x6B775323U,
+        0x8E1F3542U, 0x5272AFF5U, 0x32051D9BU, 0xEE68872CU, 0xF2EA7947U, 0x2E87E3F0U, 0x4EF0519EU, 0x929DCB29U,
+        0x80E180EBU, 0x5C8C1A5CU, 0x3CFBA832U, 0xE0963285U, 0xFC14CCEEU, 0x20795659U, 0x400EE437U, 0x9C637E80U,
+        0x790B18E1U, 0xA5668256U, 0xC5113038U, 0x197CAA8FU, 0x05FE54E4U, 0xD993CE53U, 0xB9E47C3DU, 0x6589E68AU,
+        0x9D1CEBB9U, 0x4171710EU, 0x2106C360U, 0xFD6B59D7U, 0xE1E9A7BCU, 0x3D843D0BU, 0x5DF38F65U, 0x819E15D2U,
+        0x64F673B3U, 0xB89BE904U, 0xD8EC5B6AU, 0x0481C1DDU, 0x18033FB6U, 0xC46EA501U, 0xA419176FU, 0x78748DD8U,
+        0x6A08C61AU, 0xB6655CADU, 0xD612EEC3U, 0x0A7F7474U, 0x16FD8A1FU, 0xCA9010A8U, 0xAAE7A2C6U, 0x768A3871U,
+        0x93E25E10U, 0x4F8FC4A7U, 0x2FF876C9U, 0xF395EC7EU, 0xEF171215U, 0x337A88A2U, 0x530D3ACCU, 0x8F60A07BU
+    },
+# if U_SPARTN_CRC_SLICE_BY > 4
+    {
+        0x00000000U, 0x490D678DU, 0x921ACF1AU, 0xDB17A897U, 0x20F48383U, 0x69F9E40EU, 0xB2EE4C99U, 0xFBE32B14U,
+        0x41E90706U, 0x08E4608BU, 0xD3F3C81CU, 0x9AFEAF91U, 0x611D8485U, 0x2810E308U, 0xF3074B9FU, 0xBA0A2C12U,
+        0x83D20E0CU, 0xCADF6981U, 0x11C8C116U, 0x58C5A69BU, 0xA3268D8FU, 0xEA2BEA02U, 0x313C4295U, 0x78312518U,
+        0xC23B090AU, 0x8B366E87U, 0x5021C610U, 0x192CA19DU, 0xE2CF8A89U, 0xABC2ED04U, 0x70D54593U, 0x39D8221EU,
+        0x036501AFU, 0x4A686622U, 0x917FCEB5U, 0xD872A938U, 0x2391822CU, 0x6A9CE5A1U, 0xB18B4D36U, 0xF8862ABBU,
+        0x428C06A9U, 0x0B816124U, 0xD096C9B3U, 0x999BAE3EU, 0x6278852AU, 0x2B75E2A7U, 0xF0624A30U, 0xB96F2DBDU,
+        0x80B70FA3U, 0xC9BA682EU, 0x12ADC0B9U, 0x5BA0A734U, 0xA0438C20U, 0xE94EEBADU, 0x3259433AU, 0x7B5424B7U,
+        0xC15E08A5U, 0x88536F28U, 0x5344C7BFU, 0x1A49A032U, 0xE1AA8B26U, 0xA8A7ECABU, 0x73B0443CU, 0x3ABD23B1U,
+        0x06CA035EU, 0x4FC764D3U, 0x94D0CC44U, 0xDDDDABC9U, 0x263E80DDU, 0x6F33E750U, 0xB4244FC7U, 0xFD29284AU,
+        0x47230458U, 0x0E2E63D5U, 0xD539CB42U, 0x9C34ACCFU, 0x67D787DBU, 0x2EDAE056U, 0xF5CD48C1U, 0xBCC02F4CU,
+        0x85180D52U, 0xCC156ADFU, 0x1702C248U, 0x5E0FA5C5U, 0xA5EC8ED1U, 0xECE1E95CU, 0x37F641CBU, 0x7EFB2646U,
+        0xC4F10A54U, 0x8DFC6DD9U, 0x56EBC54EU, 0x1FE6A2C3U, 0xE40589D7U, 0xAD08EE5AU, 0x761F46CDU, 0x3F122140U,
+        0x05AF02F1U, 0x4CA2657CU, 0x97B5CDEBU, 0xDEB8AA66U, 0x255B8172U, 0x6C56E6FFU, 0xB7414E68U, 0xFE4C29E5U,
+        0x444605F7U, 0x0D4B627AU, 0xD65CCAEDU, 0x9F51AD60U, 0x64B28674U, 0x2DBFE1F9U, 0xF6A8496EU, 0xBFA52EE3U,
+        0x867D0CFDU, 0xCF706B70U, 0x1467C3E7U, 0x5D6AA46AU, 0xA6898F7EU, 0xEF84E8F3U, 0x34934064U, 0x7D9E27E9U,
+        0xC7940BFBU, 0x8E996C76U, 0x558EC4E1U, 0x1C83A36CU, 0xE7608878U, 0xAE6DEFF5U, 0x757A4762U, 0x3C7720EFU,
+        0x0D9406BCU, 0x44996131U, 0x9F8EC9A6U, 0xD683AE2BU, 0x2D60853FU, 0x646DE2B2U, 0xBF7A4A25U, 0xF6772DA8U,
+        0x4C7D01BAU, 0x05706637U, 0xDE67CEA0U, 0x976AA92DU, 0x6C898239U, 0x2584E5B4U, 0xFE934D23U, 0xB79E2AAEU,
+        0x8E4608B0U, 0xC74B6F3DU, 0x1C5CC7AAU, 0x5551A027U, 0xAEB28B33U, 0xE7BFECBEU, 0x3CA84429U, 0x75A523A4U,
+        0xCFAF0FB6U, 0x86A2683BU, 0x5DB5C0ACU, 0x14B8A721U, 0xEF5B8C35U, 0xA656EBB8U, 0x7D41432FU, 0x344C24A2U,
+        0x0EF10713U, 0x47FC609EU, 0x9CEBC809U, 0xD5E6AF84U, 0x2E058490U, 0x6708E31DU, 0xBC1F4B8AU, 0xF5122C07U,
+        0x4F180015U, 0x06156798U, 0xDD02CF0FU, 0x940FA882U, 0x6FEC8396U, 0x26E1E41BU, 0xFDF64C8CU, 0xB4FB2B01U,
+        0x8D23091FU, 0xC42E6E92U, 0x1F39C605U, 0x5634A188U, 0xADD78A9CU, 0xE4DAED11U, 0x3FCD4586U, 0x76C0220BU,
+        0xCCCA0E19U, 0x85C76994U, 0x5ED0C103U, 0x17DDA68EU, 0xEC3E8D9AU, 0xA533EA17U, 0x7E244280U, 0x3729250DU,
+        0x0B5E05E2U, 0x4253626FU, 0x9944CAF8U, 0xD049AD75U, 0x2BAA8661U, 0x62A7E1ECU, 0xB9B0497BU, 0xF0BD2EF6U,
+        0x4AB702E4U, 0x03BA6569U, 0xD8ADCDFEU, 0x91A0AA73U, 0x6A438167U, 0x234EE6EAU, 0xF8594E7DU, 0xB15429F0U,
+        0x888C0BEEU, 0xC1816C63U, 0x1A96C4F4U, 0x539BA379U, 0xA878886DU, 0xE175EFE0U, 0x3A624777U, 0x736F20FAU,
+        0xC9650CE8U, 0x80686B65U, 0x5B7FC3F2U, 0x1272A47FU, 0xE9918F6BU, 0xA09CE8E6U, 0x7B8B4071U, 0x328627FCU,
+        0x083B044DU, 0x413663C0U, 0x9A21CB57U, 0xD32CACDAU, 0x28CF87CEU, 0x61C2E043U, 0xBAD548D4U, 0xF3D82F59U,
+        0x49D2034BU, 0x00DF64C6U, 0xDBC8CC51U, 0x92C5ABDCU, 0x692680C8U, 0x202BE745U, 0xFB3C4FD2U, 0xB231285FU,
+        0x8BE90A41U, 0xC2E46DCCU, 0x19F3C55BU, 0x50FEA2D6U, 0xAB1D89C2U, 0xE210EE4FU, 0x390746D8U, 0x700A2155U,
+        0xCA000D47U, 0x830D6ACAU, 0x581AC25DU, 0x1117A5D0U, 0xEAF48EC4U, 0xA3F9E949U, 0x78EE41DEU, 0x31E32653U
+    },
+    {
+        0x00000000U, 0x1B280D78U, 0x36501AF0U, 0x2D781788U, 0x6CA035E0U, 0x77883898U, 0x5AF02F10U, 0x41D82268U,
+        0xD9406BC0U, 0xC26866B8U, 0xEF107130U, 0xF4387C48U, 0xB5E05E20U, 0xAEC85358U, 0x83B044D0U, 0x989849A8U,
+        0xB641CA37U, 0xAD69C74FU, 0x8011D0C7U, 0x9B39DDBFU, 0xDAE1FFD7U, 0xC1C9F2AFU, 0xECB1E527U, 0xF799E85FU,
+        0x6F01A1F7U, 0x7429AC8FU, 0x5951BB07U, 0x4279B67FU, 0x03A19417U, 0x1889996FU, 0x35F18EE7U, 0x2ED9839FU,
+        0x684289D9U, 0x736A84A1U, 0x5E129329U, 0x453A9E51U, 0x04E2BC39U, 0x1FCAB141U, 0x32B2A6C9U, 0x299AABB1U,
+        0xB102E219U, 0xAA2AEF61U, 0x8752F8E9U, 0x9C7AF591U, 0xDDA2D7F9U, 0xC68ADA81U, 0xEBF2CD09U, 0xF0DAC071U,
+        0xDE0343EEU, 0xC52B4E96U, 0xE853591EU, 0xF37B5466U, 0xB2A3760EU, 0xA98B7B76U, 0x84F36CFEU, 0x9FDB6186U,
+        0x0743282EU, 0x1C6B2556U, 0x311332DEU, 0x2A3B3FA6U, 0x6BE31DCEU, 0x70CB10B6U, 0x5DB3073EU, 0x469B0A46U,
+        0xD08513B2U, 0xCBAD1ECAU, 0xE6D50942U, 0xFDFD043AU, 0xBC252652U, 0xA70D2B2AU, 0x8A753CA2U, 0x915D31DAU,
+        0x09C57872U, 0x12ED750AU, 0x3F956282U, 0x24BD6FFAU, 0x65654D92U, 0x7E4D40EAU, 0x53355762U, 0x481D5A1AU,
+        0x66C4D985U, 0x7DECD4FDU, 0x5094C375U, 0x4BBCCE0DU, 0x0A64EC65U, 0x114CE11DU, 0x3C34F695U, 0x271CFBEDU,
+        0xBF84B245U, 0xA4ACBF3DU, 0x89D4A8B5U, 0x92FCA5CDU, 0xD32487A5U, 0xC80C8ADDU, 0xE5749D55U, 0xFE5C902DU,
+        0xB8C79A6BU, 0xA3EF9713U, 0x8E97809BU, 0x95BF8DE3U, 0xD467AF8BU, 0xCF4FA2F3U, 0xE237B57BU, 0xF91FB803U,
+        0x6187F1ABU, 0x7AAFFCD3U, 0x57D7EB5BU, 0x4CFFE623U, 0x0D27C44BU, 0x160FC933U, 0x3B77DEBBU, 0x205FD3C3U,
+        0x0E86505CU, 0x15AE5D24U, 0x38D64AACU, 0x23FE47D4U, 0x622665BCU, 0x790E68C4U, 0x54767F4CU, 0x4F5E7234U,
+        0xD7C63B9CU, 0xCCEE36E4U, 0xE196216CU, 0xFABE2C14U, 0xBB660E7CU, 0xA04E0304U, 0x8D36148CU, 0x961E19F4U,
+        0xA5CB3AD3U, 0xBEE337ABU, 0x939B2023U, 0x88B32D5BU, 0xC96B0F33U, 0xD243024BU, 0xFF3B15C3U, 0xE41318BBU,
+        0x7C8B5113U, 0x67A35C6BU, 0x4ADB4BE3U, 0x51F3469BU, 0x102B64F3U, 0x0B03698BU, 0x267B7E03U, 0x3D53737BU,
+        0x138AF0E4U, 0x08A2FD9CU, 0x25DAEA14U, 0x3EF2E76CU, 0x7F2AC504U, 0x6402C87CU, 0x497ADFF4U, 0x5252D28CU,
+        0xCACA9B24U, 0xD1E2965CU, 0xFC9A81D4U, 0xE7B28CACU, 0xA66AAEC4U, 0xBD42A3BCU, 0x903AB434U, 0x8B12B94CU,
+        0xCD89B30AU, 0xD6A1BE72U, 0xFBD9A9FAU, 0xE0F1A482U, 0xA12986EAU, 0xBA018B92U, 0x97799C1AU, 0x8C519162U,
+        0x14C9D8CAU, 0x0FE1D5B2U, 0x2299C23AU, 0x39B1CF42U, 0x7869ED2AU, 0x6341E052U, 0x4E39F7DAU, 0x5511FAA2U,
+        0x7BC8793DU, 0x60E07445U, 0x4D9863CDU, 0x56B06EB5U, 0x17684CDDU, 0x0C4041A5U, 0x2138562DU, 0x3A105B55U,
+        0xA28812FDU, 0xB9A01F85U, 0x94D8080DU, 0x8FF00575U, 0xCE28271DU, 0xD5002A65U, 0xF8783DEDU, 0xE3503095U,
+        0x754E2961U, 0x6E662419U, 0x431E3391U, 0x58363EE9U, 0x19EE1C81U, 0x02C611F9U, 0x2FBE0671U, 0x34960B09U,
+        0xAC0E42A1U, 0xB7264FD9U, 0x9A5E5851U, 0x81765529U, 0xC0AE7741U, 0xDB867A39U, 0xF6FE6DB1U, 0xEDD660C9U,
+        0xC30FE356U, 0xD827EE2EU, 0xF55FF9A6U, 0xEE77F4DEU, 0xAFAFD6B6U, 0xB487DBCEU, 0x99FFCC46U, 0x82D7C13EU,
+        0x1A4F8896U, 0x016785EEU, 0x2C1F9266U, 0x37379F1EU, 0x76EFBD76U, 0x6DC7B00EU, 0x40BFA786U, 0x5B97AAFEU,
+        0x1D0CA0B8U, 0x0624ADC0U, 0x2B5CBA48U, 0x3074B730U, 0x71AC9558U, 0x6A849820U, 0x47FC8FA8U, 0x5CD482D0U,
+        0xC44CCB78U, 0xDF64C600U, 0xF21CD188U, 0xE934DCF0U, 0xA8ECFE98U, 0xB3C4F3E0U, 0x9EBCE468U, 0x8594E910U,
+        0xAB4D6A8FU, 0xB06567F7U, 0x9D1D707FU, 0x86357D07U, 0xC7ED5F6FU, 0xDCC55217U, 0xF1BD459FU, 0xEA9548E7U,
+        0x720D014FU, 0x69250C37U, 0x445D1BBFU, 0x5F7516C7U, 0x1EAD34AFU, 0x058539D7U, 0x28FD2E5FU, 0x33D52327U
+    },
+    {
+        0x00000000U, 0x4F576811U, 0x9EAED022U, 0xD1F9B833U, 0x399CBDF3U, 0x76CBD5E2U, 0xA7326DD1U, 0xE86505C0U,
+        0x73397BE6U, 0x3C6E13F7U, 0xED97ABC4U, 0xA2C0C3D5U, 0x4AA5C615U, 0x05F2AE04U, 0xD40B1637U, 0x9B5C7E26U,
+        0xE672F7CCU, 0xA9259FDDU, 0x78DC27EEU, 0x378B4FFFU, 0xDFEE4A3FU, 0x90B9222EU, 0x41409A1DU, 0x0E17F20CU,
+        0x954B8C2AU, 0xDA1CE43BU, 0x0BE55C08U, 0x44B23419U, 0xACD731D9U, 0xE38059C8U, 0x3279E1FBU, 0x7D2E89EAU,
+        0xC824F22FU, 0x87739A3EU, 0x568A220DU, 0x19DD4A1CU, 0xF1B84FDCU, 0xBEEF27CDU, 0x6F169FFEU, 0x2041F7EFU,
+        0xBB1D89C9U, 0xF44AE1D8U, 0x25B359EBU, 0x6AE431FAU, 0x8281343AU, 0xCDD65C2BU, 0x1C2FE418U, 0x53788C09U,
+        0x2E5605E3U, 0x61016DF2U, 0xB0F8D5C1U, 0xFFAFBDD0U, 0x17CAB810U, 0x589DD001U, 0x89646832U, 0xC6330023U,
+        0x5D6F7E05U, 0x12381614U, 0xC3C1AE27U, 0x8C96C636U, 0x64F3C3F6U, 0x2BA4ABE7U, 0xFA5D13D4U, 0xB50A7BC5U,
+        0x9488F9E9U, 0xDBDF91F8U, 0x0A2629CBU, 0x457141DAU, 0xAD14441AU, 0xE2432C0BU, 0x33BA9438U, 0x7CEDFC29U,
+        0xE7B1820FU, 0xA8E6EA1EU, 0x791F522DU, 0x36483A3CU, 0xDE2D3FFCU, 0x917A57EDU, 0x4083EFDEU, 0x0FD487CFU,
+        0x72FA0E25U, 0x3DAD6634U, 0xEC54DE07U, 0xA303B616U, 0x4B66B3D6U, 0x0431DBC7U, 0xD5C863F4U, 0x9A9F0BE5U,
+        0x01C375C3U, 0x4E941DD2U, 0x9F6DA5E1U, 0xD03ACDF0U, 0x385FC830U, 0x7708A021U, 0xA6F11812U, 0xE9A67003U,
+        0x5CAC0BC6U, 0x13FB63D7U, 0xC202DBE4U, 0x8D55B3F5U, 0x6530B635U, 0x2A67DE24U, 0xFB9E6617U, 0xB4C90E06U,
+        0x2F957020U, 0x60C21831U, 0xB13BA002U, 0xFE6CC813U, 0x1609CDD3U, 0x595EA5C2U, 0x88A71DF1U, 0xC7F075E0U,
+        0xBADEFC0AU, 0xF589941BU, 0x24702C28U, 0x6B274439U, 0x834241F9U, 0xCC1529E8U, 0x1DEC91DBU, 0x52BBF9CAU,
+        0xC9E787ECU, 0x86B0EFFDU, 0x574957CEU, 0x181E3FDFU, 0xF07B3A1FU, 0xBF2C520EU, 0x6ED5EA3DU, 0x2182822CU,
+        0x2DD0EE65U, 0x62878674U, 0xB37E3E47U, 0xFC295656U, 0x144C5396U, 0x5B1B3B87U, 0x8AE283B4U, 0xC5B5EBA5U,
+        0x5EE99583U, 0x11BEFD92U, 0xC04745A1U, 0x8F102DB0U, 0x67752870U, 0x28224061U, 0xF9DBF852U, 0xB68C9043U,
+        0xCBA219A9U, 0x84F571B8U, 0x550CC98BU, 0x1A5BA19AU, 0xF23EA45AU, 0xBD69CC4BU, 0x6C907478U, 0x23C71C69U,
+        0xB89B624FU, 0xF7CC0A5EU, 0x2635B26DU, 0x6962DA7CU, 0x8107DFBCU, 0xCE50B7ADU, 0x1FA90F9EU, 0x50FE678FU,
+        0xE5F41C4AU, 0xAAA3745BU, 0x7B5ACC68U, 0x340DA479U, 0xDC68A1B9U, 0x933FC9A8U, 0x42C6719BU, 0x0D91198AU,
+        0x96CD67ACU, 0xD99A0FBDU, 0x0863B78EU, 0x4734DF9FU, 0xAF51DA5FU, 0xE006B24EU, 0x31FF0A7DU, 0x7EA8626CU,
+        0x0386EB86U, 0x4CD18397U, 0x9D283BA4U, 0xD27F53B5U, 0x3A1A5675U, 0x754D3E64U, 0xA4B48657U, 0xEBE3EE46U,
+        0x70BF9060U, 0x3FE8F871U, 0xEE114042U, 0xA1462853U, 0x49232D93U, 0x06744582U, 0xD78DFDB1U, 0x98DA95A0U,
+        0xB958178CU, 0xF60F7F9DU, 0x27F6C7AEU, 0x68A1AFBFU, 0x80C4AA7FU, 0xCF93C26EU, 0x1E6A7A5DU, 0x513D124CU,
+        0xCA616C6AU, 0x8536047BU, 0x54CFBC48U, 0x1B98D459U, 0xF3FDD199U, 0xBCAAB988U, 0x6D5301BBU, 0x220469AAU,
+        0x5F2AE040U, 0x107D8851U, 0xC1843062U, 0x8ED35873U, 0x66B65DB3U, 0x29E135A2U, 0xF8188D91U, 0xB74FE580U,
+        0x2C139BA6U, 0x6344F3B7U, 0xB2BD4B84U, 0xFDEA2395U, 0x158F2655U, 0x5AD84E44U, 0x8B21F677U, 0xC4769E66U,
+        0x717CE5A3U, 0x3E2B8DB2U, 0xEFD23581U, 0xA0855D90U, 0x48E05850U, 0x07B73041U, 0xD64E8872U, 0x9919E063U,
+        0x02459E45U, 0x4D12F654U, 0x9CEB4E67U, 0xD3BC2676U, 0x3BD923B6U, 0x748E4BA7U, 0xA577F394U, 0xEA209B85U,
+        0x970E126FU, 0xD8597A7EU, 0x09A0C24DU, 0x46F7AA5CU, 0xAE92AF9CU, 0xE1C5C78DU, 0x303C7FBEU, 0x7F6B17AFU,
+        0xE4376989U, 0xAB600198U, 0x7A99B9ABU, 0x35CED1BAU, 0xDDABD47AU, 0x92FCBC6BU, 0x43050458U, 0x0C526C49U
+    },
+    {
+        0x00000000U, 0x5BA1DCCAU, 0xB743B994U, 0xECE2655EU, 0x6A466E9FU, 0x31E7B255U, 0xDD05D70BU, 0x86A40BC1U,
+        0xD48CDD3EU, 0x8F2D01F4U, 0x63CF64AAU, 0x386EB860U, 0xBECAB3A1U, 0xE56B6F6BU, 0x09890A35U, 0x5228D6FFU,
+        0xADD8A7CBU, 0xF6797B01U, 0x1A9B1E5FU, 0x413AC295U, 0xC79EC954U, 0x9C3F159EU, 0x70DD70C0U, 0x2B7CAC0AU,
+        0x79547AF5U, 0x22F5A63FU, 0xCE17C361U, 0x95B61FABU, 0x1312146AU, 0x48B3C8A0U, 0xA451ADFEU, 0xFFF07134U,
+        0x5F705221U, 0x04D18EEBU, 0xE833EBB5U, 0xB392377FU, 0x35363CBEU, 0x6E97E074U, 0x8275852AU, 0xD9D459E0U,
+        0x8BFC8F1FU, 0xD05D53D5U, 0x3CBF368BU, 0x671EEA41U, 0xE1BAE180U, 0xBA1B3D4AU, 0x56F95814U, 0x0D5884DEU,
+        0xF2A8F5EAU, 0xA9092920U, 0x45EB4C7EU, 0x1E4A90B4U, 0x98EE9B75U, 0xC34F47BFU, 0x2FAD22E1U, 0x740CFE2BU,
+        0x262428D4U, 0x7D85F41EU, 0x91679140U, 0xCAC64D8AU, 0x4C62464BU, 0x17C39A81U, 0xFB21FFDFU, 0xA0802315U,
+        0xBEE0A442U, 0xE5417888U, 0x09A31DD6U, 0x5202C11CU, 0xD4A6CADDU, 0x8F071617U, 0x63E57349U, 0x3844AF83U,
+        0x6A6C797CU, 0x31CDA5B6U, 0xDD2FC0E8U, 0x868E1C22U, 0x002A17E3U, 0x5B8BCB29U, 0xB769AE77U, 0xECC872BDU,
+        0x13380389U, 0x4899DF43U, 0xA47BBA1DU, 0xFFDA66D7U, 0x797E6D16U, 0x22DFB1DCU, 0xCE3DD482U, 0x959C0848U,
+        0xC7B4DEB7U, 0x9C15027DU, 0x70F76723U, 0x2B56BBE9U, 0xADF2B028U, 0xF6536CE2U, 0x1AB109BCU, 0x4110D576U,
+        0xE190F663U, 0xBA312AA9U, 0x56D34FF7U, 0x0D72933DU, 0x8BD698FCU, 0xD0774436U, 0x3C952168U, 0x6734FDA2U,
+        0x351C2B5DU, 0x6EBDF797U, 0x825F92C9U, 0xD9FE4E03U, 0x5F5A45C2U, 0x04FB9908U, 0xE819FC56U, 0xB3B8209CU,
+        0x4C4851A8U, 0x17E98D62U, 0xFB0BE83CU, 0xA0AA34F6U, 0x260E3F37U, 0x7DAFE3FDU, 0x914D86A3U, 0xCAEC5A69U,
+        0x98C48C96U, 0xC365505CU, 0x2F873502U, 0x7426E9C8U, 0xF282E209U, 0xA9233EC3U, 0x45C15B9DU, 0x1E608757U,
+        0x79005533U, 0x22A189F9U, 0xCE43ECA7U, 0x95E2306DU, 0x13463BACU, 0x48E7E766U, 0xA4058238U, 0xFFA45EF2U,
+        0xAD8C880DU, 0xF62D54C7U, 0x1ACF3199U, 0x416EED53U, 0xC7CAE692U, 0x9C6B3A58U, 0x70895F06U, 0x2B2883CCU,
+        0xD4D8F2F8U, 0x8F792E32U, 0x639B4B6CU, 0x383A97A6U, 0xBE9E9C67U, 0xE53F40ADU, 0x09DD25F3U, 0x527CF939U,
+        0x00542FC6U, 0x5BF5F30CU, 0xB7179652U, 0xECB64A98U, 0x6A124159U, 0x31B39D93U, 0xDD51F8CDU, 0x86F02407U,
+        0x26700712U, 0x7DD1DBD8U, 0x9133BE86U, 0xCA92624CU, 0x4C36698DU, 0x1797B547U, 0xFB75D019U, 0xA0D40CD3U,
+        0xF2FCDA2CU, 0xA95D06E6U, 0x45BF63B8U, 0x1E1EBF72U, 0x98BAB4B3U, 0xC31B6879U, 0x2FF90D27U, 0x7458D1EDU,
+        0x8BA8A0D9U, 0xD0097C13U, 0x3CEB194DU, 0x674AC587U, 0xE1EECE46U, 0xBA4F128CU, 0x56AD77D2U, 0x0D0CAB18U,
+        0x5F247DE7U, 0x0485A12DU, 0xE867C473U, 0xB3C618B9U, 0x35621378U, 0x6EC3CFB2U, 0x8221AAECU, 0xD9807626U,
+        0xC7E0F171U, 0x9C412DBBU, 0x70A348E5U, 0x2B02942FU, 0xADA69FEEU, 0xF6074324U, 0x1AE5267AU, 0x4144FAB0U,
+        0x136C2C4FU, 0x48CDF085U, 0xA42F95DBU, 0xFF8E4911U, 0x792A42D0U, 0x228B9E1AU, 0xCE69FB44U, 0x95C8278EU,
+        0x6A3856BAU, 0x31998A70U, 0xDD7BEF2EU, 0x86DA33E4U, 0x007E3825U, 0x5BDFE4EFU, 0xB73D81B1U, 0xEC9C5D7BU,
+        0xBEB48B84U, 0xE515574EU, 0x09F73210U, 0x5256EEDAU, 0xD4F2E51BU, 0x8F5339D1U, 0x63B15C8FU, 0x38108045U,
+        0x9890A350U, 0xC3317F9AU, 0x2FD31AC4U, 0x7472C60EU, 0xF2D6CDCFU, 0xA9771105U, 0x4595745BU, 0x1E34A891U,
+        0x4C1C7E6EU, 0x17BDA2A4U, 0xFB5FC7FAU, 0xA0FE1B30U, 0x265A10F1U, 0x7DFBCC3BU, 0x9119A965U, 0xCAB875AFU,
+        0x3548049BU, 0x6EE9D851U, 0x820BBD0FU, 0xD9AA61C5U, 0x5F0E6A04U, 0x04AFB6CEU, 0xE84DD390U, 0xB3EC0F5AU,
+        0xE1C4D9A5U, 0xBA65056FU, 0x56876031U, 0x0D26BCFBU, 0x8B82B73AU, 0xD0236BF0U, 0x3CC10EAEU, 0x6760D264U
+    },
+# endif
+};
+
+#endif // U_SPARTN_CRC_SLICE_BY > 1
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+#if U_SPARTN_CRC_SLICE_BY > 1
+
+// Return the four bytes at pData as a big-endian word.
+static uint32_t bigEndianWord(const uint8_t *pData)
+{
+    return ((uint32_t) pData[0] << 24) | ((uint32_t) pData[1] << 16) |
+           ((uint32_t) pData[2] << 8) | pData[3];
+}
+
+// Run a non-reflected CRC of 24 or 32 bits (numBitsInCrc) over as
+// much of the data at *ppData as will go U_SPARTN_CRC_SLICE_BY bytes
+// at a time, using pTable, the usual byte-wise table, and pSliceTable,
+// updating *ppData and *pSize to leave whatever remains for the
+// byte-wise loop, returning the new remainder.  The remainder is
+// worked on left-aligned in 32 bits, which makes CRC24 the same as
+// CRC32 apart from the tables.
+static uint32_t sliceCrc(const uint32_t *pTable,
+                         const uint32_t (*pSliceTable)[256],
+                         uint32_t remainder, uint8_t numBitsInCrc,
+                         const uint8_t **ppData, size_t *pSize)
+{
+    const uint8_t *pU8Msg = *ppData;
+    size_t size = *pSize;
+    uint32_t word1;
+# if U_SPARTN_CRC_SLICE_BY > 4
+    uint32_t word2;
+# endif
+
+    while (size >= U_SPARTN_CRC_SLICE_BY) {
+        word1 = (remainder << (32 - numBitsInCrc)) ^ bigEndianWord(pU8Msg);
+# if U_SPARTN_CRC_SLICE_BY > 4
+        word2 = bigEndianWord(pU8Msg + 4);
+        remainder = pSliceTable[6][word1 >> 24] ^
+                    pSliceTable[5][(word1 >> 16) & 0xFF] ^
+                    pSliceTable[4][(word1 >> 8) & 0xFF] ^
+                    pSliceTable[3][word1 & 0xFF] ^
+                    pSliceTable[2][word2 >> 24] ^
+                    pSliceTable[1][(word2 >> 16) & 0xFF] ^
+                    pSliceTable[0][(word2 >> 8) & 0xFF] ^
+                    pTable[word2 & 0xFF];
+# else
+        remainder = pSliceTable[2][word1 >> 24] ^
+                    pSliceTable[1][(word1 >> 16) & 0xFF] ^
+                    pSliceTable[0][(word1 >> 8) & 0xFF] ^
+                    pTable[word1 & 0xFF];
+# endif
+        pU8Msg += U_SPARTN_CRC_SLICE_BY;
+        size -= U_SPARTN_CRC_SLICE_BY;
+    }
+
+    *ppData = pU8Msg;
+    *pSize = size;
+
+    return remainder;
+}
+
+#endif // U_SPARTN_CRC_SLICE_BY > 1
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -290,6 +851,13 @@ uint32_t uSpartnCrc24(const char *pData, size_t size)
     uint8_t u8NumBitsInCrc = (8 * sizeof(uint8_t) * 3);
     const uint8_t *pU8Msg = (uint8_t *) pData;
 
+#if U_SPARTN_CRC_SLICE_BY > 1
+    // Do as much as possible U_SPARTN_CRC_SLICE_BY bytes at a time
+    u32Remainder = sliceCrc(u32Crc24Table, u32Crc24SliceTable,
+                            u32Remainder, u8NumBitsInCrc,
+                            &pU8Msg, &size);
+#endif
+
     // Compute the CRC value
     // Divide each byte of the message by the corresponding polynomial
     for (size_t x = 0; x < size; x++) {
@@ -310,6 +878,13 @@ uint32_t uSpartnCrc32(const char *pData, size_t size)
     uint32_t u32FinalXORValue = 0xFFFFFFFFU;
     const uint8_t *pU8Msg = (uint8_t *) pData;
 
+#if U_SPARTN_CRC_SLICE_BY > 1
+    // Do as much as possible U_SPARTN_CRC_SLICE_BY bytes at a time
+    u32Remainder = sliceCrc(u32Crc32Table, u32Crc32SliceTable,
+                            u32Remainder, u8NumBitsInCrc,
+                            &pU8Msg, &size);
+#endif
+
     // Compute the CRC value
     // Divide each byte of the message by the corresponding polynomial
     for (size_t x = 0; x < size; x++) {
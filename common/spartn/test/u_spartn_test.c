@@ -53,6 +53,8 @@
 #include "u_spartn_crc.h"
 #include "u_spartn_test_data.h"
 
+#include "u_bench.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -80,6 +82,28 @@
 # define U_SPARTN_TEST_BUFFER_SIZE_BYTES (U_SPARTN_MESSAGE_LENGTH_MAX_BYTES + U_SPARTN_TEST_BUFFER_EXTRA_SIZE_BYTES)
 #endif
 
+#ifndef U_SPARTN_TEST_CRC_BUFFER_SIZE_BYTES
+/** The size of the buffer that uSpartnCrc24() and uSpartnCrc32()
+ * are checked and timed over; an odd number so that there is always
+ * a tail left over after U_SPARTN_CRC_SLICE_BY bytes at a time.
+ */
+# define U_SPARTN_TEST_CRC_BUFFER_SIZE_BYTES 1031
+#endif
+
+#ifndef U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS
+/** The number of times uSpartnCrc24() and uSpartnCrc32() are run
+ * over #U_SPARTN_TEST_CRC_BUFFER_SIZE_BYTES when timing them.
+ */
+# define U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS 1000
+#endif
+
+#ifndef U_SPARTN_TEST_MERGER_LAG_NUM_MESSAGES
+/** The number of messages by which the second source lags the
+ * first when testing a SPARTN merger.
+ */
+# define U_SPARTN_TEST_MERGER_LAG_NUM_MESSAGES 10
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -181,6 +205,18 @@ static const uSpartnTestCrc_t gCrc32Ccitt = {
  */
 static const uSpartnTestCrc_t *gpTestData[] = {&gCrc4Ccitt, &gCrc8Ccitt, &gCrc16Ccitt, &gCrc32Ccitt};
 
+/** Buffer to check and time CRC-24 and CRC-32 over.
+ */
+static char gCrcBuffer[U_SPARTN_TEST_CRC_BUFFER_SIZE_BYTES];
+
+/** A SPARTN framer, static as it is rather large for a stack.
+ */
+static uSpartnFramer_t gFramer;
+
+/** A SPARTN merger, static as it is rather large for a stack.
+ */
+static uSpartnMerger_t gMerger;
+
 #ifndef __ZEPHYR__
 
 /** A shortish valid SPARTN message.
@@ -247,6 +283,88 @@ static crc24 crc_octets(unsigned char *octets, size_t len)
     return crc & 0xFFFFFFL;
 }
 
+// A bit-wise implementation of the CRC-32 used by SPARTN (polynomial
+// 0x04C11DB7, not reflected, initial value and final XOR 0xFFFFFFFF)
+// to check uSpartnCrc32() against.
+static uint32_t crc32Bitwise(const char *pData, size_t size)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (size > 0) {
+        crc ^= ((uint32_t) (uint8_t) *pData) << 24;
+        for (size_t x = 0; x < 8; x++) {
+            if (crc & 0x80000000) {
+                crc = (crc << 1) ^ 0x04C11DB7;
+            } else {
+                crc <<= 1;
+            }
+        }
+        pData++;
+        size--;
+    }
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+// Pass size bytes of data at pData through a SPARTN framer in
+// chunks of varying length, checking each message it returns,
+// and return the number of messages.
+static size_t frameAll(uSpartnFramer_t *pFramer, const char *pData, size_t size)
+{
+    size_t messageCount = 0;
+    size_t chunkCount = 0;
+    size_t chunkLength;
+    const char *pEnd;
+    const char *pMessage;
+    const char *pMessageValidated;
+    int32_t messageLength;
+
+    while (size > 0) {
+        // Chunks of 1 to 97 bytes, some much smaller than a
+        // SPARTN header, some much larger
+        chunkLength = (chunkCount % 97) + 1;
+        if (chunkLength > size) {
+            chunkLength = size;
+        }
+        size -= chunkLength;
+        while (chunkLength > 0) {
+            pMessage = NULL;
+            messageLength = uSpartnFramerFrame(pFramer, pData, chunkLength,
+                                               &pEnd, &pMessage);
+            U_PORT_TEST_ASSERT((pEnd > pData) && (pEnd <= pData + chunkLength));
+            if (messageLength > 0) {
+                messageCount++;
+                U_PORT_TEST_ASSERT(messageLength <= U_SPARTN_MESSAGE_LENGTH_MAX_BYTES);
+                // What is returned must be a whole, valid, message
+                U_PORT_TEST_ASSERT(uSpartnValidate(pMessage, messageLength,
+                                                   &pMessageValidated) == messageLength);
+                U_PORT_TEST_ASSERT(pMessageValidated == pMessage);
+            } else {
+                U_PORT_TEST_ASSERT((messageLength == (int32_t) U_ERROR_COMMON_TIMEOUT) ||
+                                   (messageLength == (int32_t) U_ERROR_COMMON_NOT_FOUND));
+                U_PORT_TEST_ASSERT(pEnd == pData + chunkLength);
+            }
+            chunkLength -= pEnd - pData;
+            pData = pEnd;
+        }
+        chunkCount++;
+    }
+
+    return messageCount;
+}
+
+// Return the total of an array of statistics of a SPARTN framer.
+static size_t sumStats(const size_t *pStats)
+{
+    size_t total = 0;
+
+    for (size_t x = 0; x < U_SPARTN_FRAMER_NUM_MESSAGE_TYPES + 1; x++) {
+        total += *(pStats + x);
+    }
+
+    return total;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -315,6 +433,263 @@ U_PORT_TEST_FUNCTION("[spartn]", "spartnCrc")
     U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
 }
 
+/** Check CRC-24 and CRC-32, which may be computed several bytes
+ * at a time (see #U_SPARTN_CRC_SLICE_BY), against bit-wise
+ * implementations for all alignments and for lengths that leave
+ * every possible tail, then time them.
+ */
+U_PORT_TEST_FUNCTION("[spartn]", "spartnCrcSpeed")
+{
+    int32_t heapUsed;
+    size_t length;
+    uint32_t calculated;
+    uint32_t expected;
+    uBench_t bench;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("testing CRC-24 and CRC-32, %d byte(s) at a time.",
+                      U_SPARTN_CRC_SLICE_BY);
+
+    for (size_t x = 0; x < sizeof(gCrcBuffer); x++) {
+        gCrcBuffer[x] = (char) ((x * 151) + (x >> 3));
+    }
+
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t y = 0; y <= 64; y++) {
+            // Finish with the whole of the rest of the buffer
+            length = y;
+            if (y == 64) {
+                length = sizeof(gCrcBuffer) - offset;
+            }
+            calculated = uSpartnCrc24(gCrcBuffer + offset, length);
+            expected = crc_octets((unsigned char *) gCrcBuffer + offset, length);
+            if (calculated != expected) {
+                U_TEST_PRINT_LINE("CRC-24 of %d byte(s) at offset %d: calculated"
+                                  " 0x%08x, expected 0x%08x.", (int32_t) length, (int32_t) offset,
+                                  calculated, expected);
+                U_PORT_TEST_ASSERT(false);
+            }
+            calculated = uSpartnCrc32(gCrcBuffer + offset, length);
+            expected = crc32Bitwise(gCrcBuffer + offset, length);
+            if (calculated != expected) {
+                U_TEST_PRINT_LINE("CRC-32 of %d byte(s) at offset %d: calculated"
+                                  " 0x%08x, expected 0x%08x.", (int32_t) length, (int32_t) offset,
+                                  calculated, expected);
+                U_PORT_TEST_ASSERT(false);
+            }
+        }
+    }
+
+    // Time them; no pass/fail here, this is for information
+    uBenchStart(&bench, "spartnCrc24");
+    for (size_t x = 0; x < U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS; x++) {
+        uSpartnCrc24(gCrcBuffer, sizeof(gCrcBuffer));
+    }
+    uBenchStop(&bench, U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS,
+               U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS * sizeof(gCrcBuffer), "bytes");
+    uBenchStart(&bench, "spartnCrc32");
+    for (size_t x = 0; x < U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS; x++) {
+        uSpartnCrc32(gCrcBuffer, sizeof(gCrcBuffer));
+    }
+    uBenchStop(&bench, U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS,
+               U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS * sizeof(gCrcBuffer), "bytes");
+
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+/** Test framing SPARTN messages from data that arrives in chunks.
+ */
+U_PORT_TEST_FUNCTION("[spartn]", "spartnFramer")
+{
+    int32_t heapUsed;
+    char *pBuffer;
+    const char *pMessage;
+    int32_t messageLength;
+    size_t messageCount;
+    uSpartnFramerStats_t stats;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing SPARTN framing.");
+
+    // Bad parameters
+    uSpartnFramerInit(&gFramer);
+    U_PORT_TEST_ASSERT(uSpartnFramerFrame(NULL, gUSpartnTestData, 1,
+                                          NULL, &pMessage) < 0);
+    U_PORT_TEST_ASSERT(uSpartnFramerFrame(&gFramer, gUSpartnTestData, 1,
+                                          NULL, NULL) < 0);
+    U_PORT_TEST_ASSERT(uSpartnFramerFrame(&gFramer, NULL, 1,
+                                          NULL, &pMessage) < 0);
+    U_PORT_TEST_ASSERT(uSpartnFramerFrame(&gFramer, NULL, 0, NULL,
+                                          &pMessage) == (int32_t) U_ERROR_COMMON_NOT_FOUND);
+
+    // All of the test data, in chunks
+    messageCount = frameAll(&gFramer, gUSpartnTestData, gUSpartnTestDataSize);
+    uSpartnFramerGetStats(&gFramer, &stats);
+    U_TEST_PRINT_LINE("framed %d message(s) out of %d, %d CRC failure(s),"
+                      " %d byte(s) discarded.", (int32_t) messageCount,
+                      (int32_t) gUSpartnTestDataNumMessages,
+                      (int32_t) sumStats(stats.numCrcFailures),
+                      (int32_t) stats.numBytesDiscarded);
+    for (size_t x = 0; x < U_SPARTN_FRAMER_NUM_MESSAGE_TYPES + 1; x++) {
+        U_TEST_PRINT_LINE("message type %d%s: %d.", (int32_t) x,
+                          x == U_SPARTN_FRAMER_NUM_MESSAGE_TYPES ? " or more" : "",
+                          (int32_t) stats.numMessages[x]);
+    }
+    U_PORT_TEST_ASSERT(messageCount == gUSpartnTestDataNumMessages);
+    U_PORT_TEST_ASSERT(sumStats(stats.numMessages) == messageCount);
+    U_PORT_TEST_ASSERT(sumStats(stats.numCrcFailures) == 0);
+
+    // Corrupt the middle of the first message in a copy of the
+    // test data: it must be rejected without losing any of
+    // the messages which follow it
+    pBuffer = (char *) malloc(gUSpartnTestDataSize);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    memcpy(pBuffer, gUSpartnTestData, gUSpartnTestDataSize);
+    messageLength = uSpartnValidate(pBuffer, gUSpartnTestDataSize, &pMessage);
+    U_PORT_TEST_ASSERT(messageLength > 0);
+    *(pBuffer + (pMessage - pBuffer) + (messageLength / 2)) ^= 0x01;
+    uSpartnFramerInit(&gFramer);
+    messageCount = frameAll(&gFramer, pBuffer, gUSpartnTestDataSize);
+    uSpartnFramerGetStats(&gFramer, &stats);
+    U_TEST_PRINT_LINE("with one message corrupted, framed %d message(s),"
+                      " %d CRC failure(s).", (int32_t) messageCount,
+                      (int32_t) sumStats(stats.numCrcFailures));
+    U_PORT_TEST_ASSERT(messageCount == gUSpartnTestDataNumMessages - 1);
+    U_PORT_TEST_ASSERT(sumStats(stats.numMessages) == messageCount);
+    U_PORT_TEST_ASSERT(sumStats(stats.numCrcFailures) >= 1);
+    free(pBuffer);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+/** Test merging SPARTN messages that arrive from two sources.
+ */
+U_PORT_TEST_FUNCTION("[spartn]", "spartnMerger")
+{
+    int32_t heapUsed;
+    char *pBuffer;
+    int32_t *pLength;
+    size_t messageCount = 0;
+    size_t offset = 0;
+    size_t lagOffset = 0;
+    const char *pData = gUSpartnTestData;
+    size_t size = gUSpartnTestDataSize;
+    const char *pEnd;
+    const char *pMessage;
+    int32_t messageLength;
+    uSpartnMergerStats_t stats;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing SPARTN merging.");
+
+    // Frame all of the test data into a buffer, one message
+    // after another, noting the length of each
+    pBuffer = (char *) malloc(gUSpartnTestDataSize);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    pLength = (int32_t *) malloc(gUSpartnTestDataNumMessages * sizeof(int32_t));
+    U_PORT_TEST_ASSERT(pLength != NULL);
+    uSpartnFramerInit(&gFramer);
+    while (size > 0) {
+        messageLength = uSpartnFramerFrame(&gFramer, pData, size, &pEnd, &pMessage);
+        if (messageLength > 0) {
+            U_PORT_TEST_ASSERT(messageCount < gUSpartnTestDataNumMessages);
+            memcpy(pBuffer + offset, pMessage, messageLength);
+            *(pLength + messageCount) = messageLength;
+            offset += messageLength;
+            messageCount++;
+        }
+        size -= pEnd - pData;
+        pData = pEnd;
+    }
+    U_PORT_TEST_ASSERT(messageCount == gUSpartnTestDataNumMessages);
+
+    // Bad parameters
+    uSpartnMergerInit(&gMerger);
+    U_PORT_TEST_ASSERT(uSpartnMergerAdd(NULL, pBuffer, *pLength) < 0);
+    U_PORT_TEST_ASSERT(uSpartnMergerAdd(&gMerger, NULL, *pLength) < 0);
+    // Not exactly one message
+    U_PORT_TEST_ASSERT(uSpartnMergerAdd(&gMerger, pBuffer,
+                                        *pLength - 1) == (int32_t) U_ERROR_COMMON_NOT_FOUND);
+    U_PORT_TEST_ASSERT(uSpartnMergerAdd(&gMerger, pBuffer + 1,
+                                        *pLength) == (int32_t) U_ERROR_COMMON_NOT_FOUND);
+    uSpartnMergerGetStats(&gMerger, &stats);
+    U_PORT_TEST_ASSERT((stats.numForwarded == 0) && (stats.numDuplicates == 0));
+
+    // Two sources, the second lagging the first by a few
+    // messages: only the first copy of each should be forwarded;
+    // note that several messages in the test data differ only
+    // in their payload, they must all be forwarded
+    offset = 0;
+    for (size_t x = 0; x < messageCount + U_SPARTN_TEST_MERGER_LAG_NUM_MESSAGES; x++) {
+        if (x < messageCount) {
+            U_PORT_TEST_ASSERT(uSpartnMergerAdd(&gMerger, pBuffer + offset,
+                                                *(pLength + x)) == *(pLength + x));
+            offset += *(pLength + x);
+        }
+        if (x >= U_SPARTN_TEST_MERGER_LAG_NUM_MESSAGES) {
+            U_PORT_TEST_ASSERT(uSpartnMergerAdd(&gMerger, pBuffer + lagOffset,
+                                                *(pLength + x - U_SPARTN_TEST_MERGER_LAG_NUM_MESSAGES)) == 0);
+            lagOffset += *(pLength + x - U_SPARTN_TEST_MERGER_LAG_NUM_MESSAGES);
+        }
+    }
+    uSpartnMergerGetStats(&gMerger, &stats);
+    U_TEST_PRINT_LINE("%d message(s) forwarded, %d duplicate(s).",
+                      (int32_t) stats.numForwarded, (int32_t) stats.numDuplicates);
+    U_PORT_TEST_ASSERT(stats.numForwarded == messageCount);
+    U_PORT_TEST_ASSERT(stats.numDuplicates == messageCount);
+
+    // A copy that arrives once the window has moved on is forwarded
+    // again
+    messageLength = uSpartnMergerAdd(&gMerger, pBuffer, *pLength);
+    if (messageCount >= U_SPARTN_MERGER_WINDOW_NUM_MESSAGES) {
+        U_PORT_TEST_ASSERT(messageLength == *pLength);
+    } else {
+        U_PORT_TEST_ASSERT(messageLength == 0);
+    }
+
+    // Re-initialising forgets everything
+    uSpartnMergerInit(&gMerger);
+    U_PORT_TEST_ASSERT(uSpartnMergerAdd(&gMerger, pBuffer, *pLength) == *pLength);
+
+    free(pLength);
+    free(pBuffer);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
 #ifndef __ZEPHYR__
 
 /** Testing of the SPARTN protocol utility functions against
@@ -56,6 +56,54 @@ extern "C" {
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A UBX protocol message to be encoded, see uUbxProtocolEncodeBatch().
+ */
+typedef struct {
+    int32_t messageClass;          /**< the UBX protocol message class. */
+    int32_t messageId;             /**< the UBX protocol message ID. */
+    const char *pBody;             /**< the message body, may be NULL
+                                        if the message has no body. */
+    size_t bodyLengthBytes;        /**< the length of the message body,
+                                        must be non-zero if pBody is
+                                        not NULL. */
+} uUbxProtocolMessage_t;
+
+/** The states of a UBX protocol decoder, see uUbxProtocolDecoder_t.
+ */
+typedef enum {
+    U_UBX_PROTOCOL_DECODER_STATE_SYNC_1,   /**< looking for 0xB5. */
+    U_UBX_PROTOCOL_DECODER_STATE_SYNC_2,   /**< looking for 0x62. */
+    U_UBX_PROTOCOL_DECODER_STATE_CLASS,
+    U_UBX_PROTOCOL_DECODER_STATE_ID,
+    U_UBX_PROTOCOL_DECODER_STATE_LENGTH_1,
+    U_UBX_PROTOCOL_DECODER_STATE_LENGTH_2,
+    U_UBX_PROTOCOL_DECODER_STATE_BODY,
+    U_UBX_PROTOCOL_DECODER_STATE_CK_A,
+    U_UBX_PROTOCOL_DECODER_STATE_CK_B
+} uUbxProtocolDecoderState_t;
+
+/** A resumable UBX protocol decoder: unlike uUbxProtocolDecode(),
+ * which needs a whole message in one buffer, this can be given
+ * data in chunks of any size, e.g. as they arrive from DMA,
+ * carrying the partial message and its checksum from one chunk to
+ * the next, so that nothing is ever scanned twice.  Initialise it
+ * with uUbxProtocolDecoderInit() and then pass it to
+ * uUbxProtocolDecoderDecode(); the contents are private to the
+ * decoder, they are here only so that it may be allocated by the
+ * caller.
+ */
+typedef struct {
+    uUbxProtocolDecoderState_t state;
+    char *pMessageBody;
+    size_t maxMessageBodyLengthBytes;
+    int32_t messageClass;
+    int32_t messageId;
+    size_t messageBodyLengthBytes;
+    size_t messageBodyCount;
+    uint8_t ca;
+    uint8_t cb;
+} uUbxProtocolDecoder_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -105,6 +153,24 @@ uint32_t uUbxProtocolUint32Decode(const char *pByte);
  */
 uint64_t uUbxProtocolUint64Decode(const char *pByte);
 
+/** Decode a float from a pointer to a little-endian IEEE 754
+ * single-precision value (UBX type R4), ensuring that the
+ * endianness of the decoded value is correct for this processor.
+ *
+ * @param[in] pByte  a pointer to an R4 value to decode; cannot be NULL.
+ * @return           the decoded value.
+ */
+float uUbxProtocolFloatDecode(const char *pByte);
+
+/** Decode a double from a pointer to a little-endian IEEE 754
+ * double-precision value (UBX type R8), ensuring that the
+ * endianness of the decoded value is correct for this processor.
+ *
+ * @param[in] pByte  a pointer to an R8 value to decode; cannot be NULL.
+ * @return           the decoded value.
+ */
+double uUbxProtocolDoubleDecode(const char *pByte);
+
 /** Encode the given uint16_t value with correct endianness for the UBX
  * protocol.
  *
@@ -129,6 +195,26 @@ uint32_t uUbxProtocolUint32Encode(uint32_t uint32);
  */
 uint64_t uUbxProtocolUint64Encode(uint64_t uint64);
 
+/** Update a UBX protocol checksum, the 8-bit Fletcher algorithm
+ * of the UBX protocol, with a block of data.  This is the one
+ * implementation of the checksum, used by all of the UBX code; it
+ * processes four bytes per iteration so it is worth passing in as
+ * much data as possible at a time.  The checksum of a UBX message
+ * runs from the class byte to the end of the body: start with
+ * *pCkA and *pCkB set to zero, call this as many times as required
+ * with consecutive blocks of that data and the two bytes which
+ * terminate the message will be *pCkA followed by *pCkB.
+ *
+ * @param[in] pData    the data; may only be NULL if size is zero.
+ * @param size         the number of bytes at pData.
+ * @param[in,out] pCkA a pointer to the first checksum byte; cannot
+ *                     be NULL.
+ * @param[in,out] pCkB a pointer to the second checksum byte; cannot
+ *                     be NULL.
+ */
+void uUbxProtocolChecksumUpdate(const char *pData, size_t size,
+                                uint8_t *pCkA, uint8_t *pCkB);
+
 /** Encode a UBX protocol message.
  *
  * @param messageClass            the UBX protocol message class.
@@ -151,6 +237,28 @@ int32_t uUbxProtocolEncode(int32_t messageClass, int32_t messageId,
                            const char *pMessageBody, size_t messageBodyLengthBytes,
                            char *pBuffer);
 
+/** Encode several UBX protocol messages back to back into one
+ * buffer, e.g. so that they can be sent to a GNSS chip in a single
+ * transport write.  Passing NULL as pBuffer returns the amount of
+ * buffer required without encoding anything.
+ *
+ * @param[in] pMessageList    the messages to encode; cannot be NULL.
+ * @param numMessages         the number of entries at pMessageList.
+ * @param[out] pBuffer        a buffer in which the encoded messages
+ *                            are to be stored; may be NULL.
+ * @param bufferLengthBytes   the amount of storage at pBuffer; ignored
+ *                            if pBuffer is NULL.
+ * @return                    on success the number of bytes written to
+ *                            pBuffer or, if pBuffer is NULL, the number
+ *                            of bytes that would be written, else negative
+ *                            error code; #U_ERROR_COMMON_NO_MEMORY is
+ *                            returned if bufferLengthBytes is too small,
+ *                            in which case nothing is written.
+ */
+int32_t uUbxProtocolEncodeBatch(const uUbxProtocolMessage_t *pMessageList,
+                                size_t numMessages, char *pBuffer,
+                                size_t bufferLengthBytes);
+
 /** Decode a UBX protocol message.  Call this function with a buffer
  * and it will return the first valid UBX format message it finds
  * in the buffer. ppBufferOut will be set to the first position in
@@ -229,6 +337,92 @@ int32_t uUbxProtocolDecode(const char *pBufferIn, size_t bufferLengthBytes,
                            char *pMessageBody, size_t maxMessageBodyLengthBytes,
                            const char **ppBufferOut);
 
+/** Initialise a resumable UBX protocol decoder, see
+ * uUbxProtocolDecoder_t; this may also be called at any time to
+ * abandon a partially decoded message and start again.
+ *
+ * @param[out] pDecoder              a pointer to the decoder; cannot
+ *                                   be NULL.
+ * @param[out] pMessageBody          a pointer to somewhere to store
+ *                                   the bodies of decoded messages;
+ *                                   may be NULL.
+ * @param maxMessageBodyLengthBytes  the amount of storage at pMessageBody.
+ */
+void uUbxProtocolDecoderInit(uUbxProtocolDecoder_t *pDecoder,
+                             char *pMessageBody,
+                             size_t maxMessageBodyLengthBytes);
+
+/** Pass a chunk of data to a resumable UBX protocol decoder.  The
+ * data is consumed up to the end of the first message that it
+ * completes, the body of the message being written to the storage
+ * given to uUbxProtocolDecoderInit(), and ppBufferOut is set to point
+ * at the first byte after that message, ready for the remainder of
+ * the chunk to be passed in again; if no message is completed the
+ * entire chunk is consumed and the decoder remembers where it was.
+ * For example:
+ *
+ * ```
+ * uUbxProtocolDecoder_t decoder;
+ * char messageBody[128];
+ * const char *pEnd;
+ * int32_t messageClass;
+ * int32_t messageId;
+ *
+ * uUbxProtocolDecoderInit(&decoder, messageBody, sizeof(messageBody));
+ * while ((bufferLength = myRead(dataIn, sizeof(dataIn))) > 0) {
+ *     const char *pBuffer = dataIn;
+ *     while (bufferLength > 0) {
+ *         int32_t x = uUbxProtocolDecoderDecode(&decoder, pBuffer,
+ *                                               bufferLength,
+ *                                               &messageClass,
+ *                                               &messageId, &pEnd);
+ *         if (x >= 0) {
+ *             // Handle the message here, bearing in mind that x may
+ *             // be larger than sizeof(messageBody)
+ *         }
+ *         bufferLength -= pEnd - pBuffer;
+ *         pBuffer = pEnd;
+ *     }
+ * }
+ * ```
+ *
+ * A byte which cannot be part of a message (e.g. a bad checksum)
+ * causes the decoder to throw away the partial message and look for
+ * the start of a new one from that byte onwards: the bytes of the
+ * abandoned message are not re-scanned since they may no longer exist.
+ *
+ * @param[in] pDecoder        a pointer to the decoder, initialised
+ *                            with uUbxProtocolDecoderInit(); cannot
+ *                            be NULL.
+ * @param[in] pBufferIn       a pointer to the data; may only be NULL
+ *                            if bufferLengthBytes is zero.
+ * @param bufferLengthBytes   the amount of data at pBufferIn.
+ * @param[out] pMessageClass  a pointer to somewhere to store the UBX
+ *                            message class of a completed message;
+ *                            may be NULL.
+ * @param[out] pMessageId     a pointer to somewhere to store the UBX
+ *                            message ID of a completed message; may
+ *                            be NULL.
+ * @param[out] ppBufferOut    a pointer to somewhere to store the
+ *                            pointer to the first byte not consumed;
+ *                            may be NULL.
+ * @return                    if a message was completed the length of
+ *                            its body, which may be larger than the
+ *                            storage given to uUbxProtocolDecoderInit(),
+ *                            only that much having been written;
+ *                            #U_ERROR_COMMON_TIMEOUT if all of the data
+ *                            was consumed and a message is partially
+ *                            decoded, #U_ERROR_COMMON_NOT_FOUND if all
+ *                            of the data was consumed and no message
+ *                            has been started, else negative error code.
+ */
+int32_t uUbxProtocolDecoderDecode(uUbxProtocolDecoder_t *pDecoder,
+                                  const char *pBufferIn,
+                                  size_t bufferLengthBytes,
+                                  int32_t *pMessageClass,
+                                  int32_t *pMessageId,
+                                  const char **ppBufferOut);
+
 #ifdef __cplusplus
 }
 #endif
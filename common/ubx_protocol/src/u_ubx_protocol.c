@@ -36,6 +36,8 @@
 
 #include "u_error_common.h"
 
+#include "u_port_debug.h"
+
 #include "u_ubx_protocol.h"
 
 /* ----------------------------------------------------------------
@@ -50,6 +52,11 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** Profiling probe for uUbxProtocolDecode(), only present if
+ * U_CFG_PROFILE is defined.
+ */
+U_PORT_PROFILE_PROBE(ubxDecode);
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -116,6 +123,28 @@ uint64_t uUbxProtocolUint64Decode(const char *pByte)
     return retValue;
 }
 
+// Decode a little-endian IEEE 754 single-precision value.
+float uUbxProtocolFloatDecode(const char *pByte)
+{
+    uint32_t bits = uUbxProtocolUint32Decode(pByte);
+    float retValue;
+
+    memcpy(&retValue, &bits, sizeof(retValue));
+
+    return retValue;
+}
+
+// Decode a little-endian IEEE 754 double-precision value.
+double uUbxProtocolDoubleDecode(const char *pByte)
+{
+    uint64_t bits = uUbxProtocolUint64Decode(pByte);
+    double retValue;
+
+    memcpy(&retValue, &bits, sizeof(retValue));
+
+    return retValue;
+}
+
 // Return a little-endian uint16_t from the given uint16_t.
 uint16_t uUbxProtocolUint16Encode(uint16_t uint16)
 {
@@ -163,6 +192,43 @@ uint64_t uUbxProtocolUint64Encode(uint64_t uint64)
     return  retValue;
 }
 
+// Update a UBX protocol checksum with a block of data.
+void uUbxProtocolChecksumUpdate(const char *pData, size_t size,
+                                uint8_t *pCkA, uint8_t *pCkB)
+{
+    // Use a uint8_t pointer for maths, more certain of its behaviour than char
+    const uint8_t *pInput = (const uint8_t *) pData;
+    // The checksum bytes are only ever needed modulo 256, which
+    // 32-bit arithmetic preserves through any wrap, so there
+    // is no need to mask as we go
+    uint32_t ca = *pCkA;
+    uint32_t cb = *pCkB;
+
+    // Four bytes at a time: ca gains the sum of the bytes
+    // while cb gains four times the old ca plus each byte
+    // weighted by the number of times it is added into ca
+    while (size >= 4) {
+        uint32_t b0 = *pInput;
+        uint32_t b1 = *(pInput + 1);
+        uint32_t b2 = *(pInput + 2);
+        uint32_t b3 = *(pInput + 3);
+        cb += ((ca + b0) << 2) + (b1 * 3) + (b2 << 1) + b3;
+        ca += b0 + b1 + b2 + b3;
+        pInput += 4;
+        size -= 4;
+    }
+    // Mop up
+    while (size > 0) {
+        ca += *pInput;
+        cb += ca;
+        pInput++;
+        size--;
+    }
+
+    *pCkA = (uint8_t) ca;
+    *pCkB = (uint8_t) cb;
+}
+
 // Encode a UBX protocol message.
 int32_t uUbxProtocolEncode(int32_t messageClass, int32_t messageId,
                            const char *pMessage, size_t messageBodyLengthBytes,
@@ -171,8 +237,8 @@ int32_t uUbxProtocolEncode(int32_t messageClass, int32_t messageId,
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     // Use a uint8_t pointer for maths, more certain of its behaviour than char
     uint8_t *pWrite = (uint8_t *) pBuffer;
-    int32_t ca = 0;
-    int32_t cb = 0;
+    uint8_t ca = 0;
+    uint8_t cb = 0;
 
     if (((messageBodyLengthBytes == 0) || (pMessage != NULL)) &&
         (pBuffer != NULL)) {
@@ -193,16 +259,11 @@ int32_t uUbxProtocolEncode(int32_t messageClass, int32_t messageId,
 
         // Work out the CRC over the variable elements of the
         // header and the body
-        pBuffer += 2;
-        for (size_t x = 0; x < messageBodyLengthBytes + 4; x++) {
-            ca += (uint8_t) *pBuffer; // *NOPAD*
-            cb += ca;
-            pBuffer++;
-        }
+        uUbxProtocolChecksumUpdate(pBuffer + 2, messageBodyLengthBytes + 4, &ca, &cb);
 
         // Write in the CRC
-        *pWrite++ = (uint8_t) (ca & (uint8_t) 0xff);
-        *pWrite = (uint8_t) (cb & (uint8_t) 0xff);
+        *pWrite++ = ca;
+        *pWrite = cb;
 
         errorCodeOrLength = (int32_t) (U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES + messageBodyLengthBytes);
     }
@@ -210,137 +271,224 @@ int32_t uUbxProtocolEncode(int32_t messageClass, int32_t messageId,
     return errorCodeOrLength;
 }
 
+// Encode several UBX protocol messages back to back.
+int32_t uUbxProtocolEncodeBatch(const uUbxProtocolMessage_t *pMessageList,
+                                size_t numMessages, char *pBuffer,
+                                size_t bufferLengthBytes)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uUbxProtocolMessage_t *pMessage = pMessageList;
+    size_t size = 0;
+    bool isValid = (pMessageList != NULL) || (numMessages == 0);
+
+    // Check everything and work out the size first, so that
+    // nothing is written if it is not all going to fit
+    for (size_t x = 0; isValid && (x < numMessages); x++) {
+        isValid = (pMessage->bodyLengthBytes == 0) || (pMessage->pBody != NULL);
+        size += pMessage->bodyLengthBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
+        pMessage++;
+    }
+
+    if (isValid) {
+        errorCodeOrLength = (int32_t) size;
+        if (pBuffer != NULL) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            if (size <= bufferLengthBytes) {
+                errorCodeOrLength = 0;
+                pMessage = pMessageList;
+                for (size_t x = 0; x < numMessages; x++) {
+                    errorCodeOrLength += uUbxProtocolEncode(pMessage->messageClass,
+                                                            pMessage->messageId,
+                                                            pMessage->pBody,
+                                                            pMessage->bodyLengthBytes,
+                                                            pBuffer + errorCodeOrLength);
+                    pMessage++;
+                }
+            }
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
 // Decode a UBX protocol message.
 int32_t uUbxProtocolDecode(const char *pBufferIn, size_t bufferLengthBytes,
                            int32_t *pMessageClass, int32_t *pMessageId,
                            char *pMessage, size_t maxMessageLengthBytes,
                            const char **ppBufferOut)
 {
-    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+    int32_t sizeOrErrorCode;
+    uUbxProtocolDecoder_t decoder;
+    U_PORT_PROFILE_BEGIN(ubxDecode);
+
+    // A whole-buffer decode is just a resumable decode that
+    // is never resumed
+    uUbxProtocolDecoderInit(&decoder, pMessage, maxMessageLengthBytes);
+
+    sizeOrErrorCode = uUbxProtocolDecoderDecode(&decoder, pBufferIn, bufferLengthBytes,
+                                                pMessageClass, pMessageId, ppBufferOut);
+
+    U_PORT_PROFILE_END(ubxDecode, bufferLengthBytes);
+
+    return sizeOrErrorCode;
+}
+
+// Initialise a resumable UBX protocol decoder.
+void uUbxProtocolDecoderInit(uUbxProtocolDecoder_t *pDecoder,
+                             char *pMessageBody,
+                             size_t maxMessageBodyLengthBytes)
+{
+    if (pDecoder != NULL) {
+        memset(pDecoder, 0, sizeof(*pDecoder));
+        pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_SYNC_1;
+        pDecoder->pMessageBody = pMessageBody;
+        pDecoder->maxMessageBodyLengthBytes = maxMessageBodyLengthBytes;
+    }
+}
+
+// Pass a chunk of data to a resumable UBX protocol decoder.
+int32_t uUbxProtocolDecoderDecode(uUbxProtocolDecoder_t *pDecoder,
+                                  const char *pBufferIn,
+                                  size_t bufferLengthBytes,
+                                  int32_t *pMessageClass,
+                                  int32_t *pMessageId,
+                                  const char **ppBufferOut)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     // Use a uint8_t pointer for maths, more certain of its behaviour than char
     const uint8_t *pInput = (const uint8_t *) pBufferIn;
-    int32_t overheadByteCount = 0;
-    bool updateCrc = false;
-    size_t expectedMessageByteCount = 0;
-    size_t messageByteCount = 0;
-    int32_t ca = 0;
-    int32_t cb = 0;
-
-    for (size_t x = 0; (x < bufferLengthBytes) &&
-         (overheadByteCount < U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES); x++) {
-        switch (overheadByteCount) {
-            case 0:
-                //lint -e{650} Suppress warning about 0xb5 being out of range for char
-                if (*pInput == 0xb5) {
-                    // Got first byte of header, increment count
-                    overheadByteCount++;
-                }
-                break;
-            case 1:
-                if (*pInput == 0x62) {
-                    // Got second byte of header, increment count
-                    overheadByteCount++;
-                } else {
-                    // Not a valid message, start again
-                    overheadByteCount = 0;
-                }
-                break;
-            case 2:
-                // Got message class, store it, start CRC
-                // calculation and increment count
-                if (pMessageClass != NULL) {
-                    *pMessageClass = *pInput;
-                }
-                ca = 0;
-                cb = 0;
-                updateCrc = true;
-                overheadByteCount++;
-                break;
-            case 3:
-                // Got message ID, store it, update CRC and
-                // increment count
-                if (pMessageId != NULL) {
-                    *pMessageId = *pInput;
-                }
-                updateCrc = true;
-                overheadByteCount++;
-                break;
-            case 4:
-                // Got first byte of length, store it, update
-                // CRC and increment count
-                expectedMessageByteCount = *pInput;
-                updateCrc = true;
-                overheadByteCount++;
-                break;
-            case 5:
-                // Got second byte of length, add it to the first,
-                // updat CRC, increment count and reset the
-                // message byte count ready for the body to come next.
-                // Cast twice to keep Lint happy
-                expectedMessageByteCount += ((size_t) *pInput) << 8; // *NOPAD*
-                messageByteCount = 0;
-                updateCrc = true;
-                overheadByteCount++;
-                break;
-            case 6:
-                if (messageByteCount < expectedMessageByteCount) {
-                    // Store the next byte of the message and
-                    // update CRC
-                    if ((pMessage != NULL) && (messageByteCount < maxMessageLengthBytes)) {
-                        *pMessage++ = (char) *pInput; // *NOPAD*
+    const uint8_t *pEnd = pInput + bufferLengthBytes;
+    bool updateCrc;
+    bool complete = false;
+
+    if ((pDecoder != NULL) && ((pBufferIn != NULL) || (bufferLengthBytes == 0))) {
+        for (; (pInput < pEnd) && !complete; pInput++) {
+            updateCrc = false;
+            switch (pDecoder->state) {
+                case U_UBX_PROTOCOL_DECODER_STATE_SYNC_1:
+                    //lint -e{650} Suppress warning about 0xb5 being out of range for char
+                    if (*pInput == 0xb5) {
+                        pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_SYNC_2;
+                    }
+                    break;
+                case U_UBX_PROTOCOL_DECODER_STATE_SYNC_2:
+                    if (*pInput == 0x62) {
+                        pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_CLASS;
+                    } else if (*pInput != 0xb5) {
+                        // Not a valid message, start again; a
+                        // repeated 0xb5 could still be the start
+                        pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_SYNC_1;
                     }
+                    break;
+                case U_UBX_PROTOCOL_DECODER_STATE_CLASS:
+                    // Got message class, store it and start
+                    // the CRC calculation
+                    pDecoder->messageClass = *pInput;
+                    pDecoder->ca = 0;
+                    pDecoder->cb = 0;
                     updateCrc = true;
-                    messageByteCount++;
-                } else {
-                    // First byte of CRC, check it
-                    ca &= 0xff;
-                    if ((uint8_t) ca == *pInput) {
-                        overheadByteCount++;
-                    } else {
-                        // Not a valid message, start again
-                        overheadByteCount = 0;
+                    pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_ID;
+                    break;
+                case U_UBX_PROTOCOL_DECODER_STATE_ID:
+                    pDecoder->messageId = *pInput;
+                    updateCrc = true;
+                    pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_LENGTH_1;
+                    break;
+                case U_UBX_PROTOCOL_DECODER_STATE_LENGTH_1:
+                    pDecoder->messageBodyLengthBytes = *pInput;
+                    updateCrc = true;
+                    pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_LENGTH_2;
+                    break;
+                case U_UBX_PROTOCOL_DECODER_STATE_LENGTH_2:
+                    // Cast twice to keep Lint happy
+                    pDecoder->messageBodyLengthBytes += ((size_t) *pInput) << 8; // *NOPAD*
+                    pDecoder->messageBodyCount = 0;
+                    updateCrc = true;
+                    pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_BODY;
+                    if (pDecoder->messageBodyLengthBytes == 0) {
+                        pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_CK_A;
+                    }
+                    break;
+                case U_UBX_PROTOCOL_DECODER_STATE_BODY:
+                {
+                    // Take as much of the body as is here in one go
+                    size_t x = pDecoder->messageBodyLengthBytes - pDecoder->messageBodyCount;
+                    size_t y = 0;
+                    if (x > (size_t) (pEnd - pInput)) {
+                        x = (size_t) (pEnd - pInput);
+                    }
+                    if ((pDecoder->pMessageBody != NULL) &&
+                        (pDecoder->messageBodyCount < pDecoder->maxMessageBodyLengthBytes)) {
+                        y = pDecoder->maxMessageBodyLengthBytes - pDecoder->messageBodyCount;
+                        if (y > x) {
+                            y = x;
+                        }
+                        // memmove() since it is permitted to decode
+                        // back into the input buffer
+                        memmove(pDecoder->pMessageBody + pDecoder->messageBodyCount,
+                                pInput, y);
+                    }
+                    uUbxProtocolChecksumUpdate((const char *) pInput, x,
+                                               &(pDecoder->ca), &(pDecoder->cb));
+                    pDecoder->messageBodyCount += x;
+                    // -1 since the loop increments pInput
+                    pInput += x - 1;
+                    if (pDecoder->messageBodyCount >= pDecoder->messageBodyLengthBytes) {
+                        pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_CK_A;
                     }
                 }
                 break;
-            case 7:
-                // Second byte of CRC, check it
-                cb &= 0xff;
-                if ((uint8_t) cb == *pInput) {
-                    overheadByteCount++;
-                } else {
-                    // Not a valid message, start again
-                    overheadByteCount = 0;
-                }
-                break;
-            default:
-                overheadByteCount = 0;
-                break;
+                case U_UBX_PROTOCOL_DECODER_STATE_CK_A:
+                    pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_CK_B;
+                    if (pDecoder->ca != *pInput) {
+                        // Not a valid message, start again
+                        pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_SYNC_1;
+                        //lint -e{650} Suppress warning about 0xb5 being out of range for char
+                        if (*pInput == 0xb5) {
+                            pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_SYNC_2;
+                        }
+                    }
+                    break;
+                case U_UBX_PROTOCOL_DECODER_STATE_CK_B:
+                    pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_SYNC_1;
+                    if (pDecoder->cb == *pInput) {
+                        complete = true;
+                    //lint -e{650} Suppress warning about 0xb5 being out of range for char
+                    } else if (*pInput == 0xb5) {
+                        pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_SYNC_2;
+                    }
+                    break;
+                default:
+                    pDecoder->state = U_UBX_PROTOCOL_DECODER_STATE_SYNC_1;
+                    break;
+            }
+
+            if (updateCrc) {
+                pDecoder->ca += *pInput;
+                pDecoder->cb += pDecoder->ca;
+            }
         }
 
-        if (updateCrc) {
-            ca += *pInput;
-            cb += ca;
-            updateCrc = false;
+        if (complete) {
+            if (pMessageClass != NULL) {
+                *pMessageClass = pDecoder->messageClass;
+            }
+            if (pMessageId != NULL) {
+                *pMessageId = pDecoder->messageId;
+            }
+            sizeOrErrorCode = (int32_t) pDecoder->messageBodyLengthBytes;
+        } else if (pDecoder->state != U_UBX_PROTOCOL_DECODER_STATE_SYNC_1) {
+            // Part way through a message
+            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        } else {
+            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
         }
 
-        // Next byte
-        pInput++;
-    }
-
-    if (overheadByteCount > 0) {
-        // We got some parts of the message overhead, so
-        // could be a message
-        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
-        if (overheadByteCount == U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) {
-            // We got all the overhead bytes, this is a complete message
-            sizeOrErrorCode = (int32_t) messageByteCount;
+        if (ppBufferOut != NULL) {
+            *ppBufferOut = (const char *) pInput;
         }
     }
 
-    if (ppBufferOut != NULL) {
-        *ppBufferOut =  (const char *) pInput;
-    }
-
     return sizeOrErrorCode;
 }
 
@@ -50,6 +50,8 @@
 
 #include "u_ubx_protocol.h"
 
+#include "u_bench.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -68,6 +70,27 @@
 # define U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE 1024
 #endif
 
+#ifndef U_UBX_PROTOCOL_TEST_CHECKSUM_ITERATIONS
+/** The number of times to checksum U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE
+ * bytes when timing the checksum.
+ */
+# define U_UBX_PROTOCOL_TEST_CHECKSUM_ITERATIONS 1000
+#endif
+
+#ifndef U_UBX_PROTOCOL_TEST_BENCH_ITERATIONS
+/** The number of times to encode and decode a message of
+ * U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE bytes in the benchmark.
+ */
+# define U_UBX_PROTOCOL_TEST_BENCH_ITERATIONS 2000
+#endif
+
+#ifndef U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE
+/** The message body size to use in the benchmark, a typical
+ * UBX-NAV-PVT.
+ */
+# define U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE 92
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -80,6 +103,17 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// The UBX checksum done the obvious way, a byte at a time, to
+// compare against.
+static void checksumSimple(const char *pData, size_t size,
+                           uint8_t *pCkA, uint8_t *pCkB)
+{
+    for (size_t x = 0; x < size; x++) {
+        *pCkA += (uint8_t) *(pData + x);
+        *pCkB += *pCkA;
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -98,6 +132,8 @@ U_PORT_TEST_FUNCTION("[ubxProtocol]", "ubxProtocolBackToBack")
     const char *pTmp;
     uint64_t z = 0xf0f1f2f3f4f5f6f7ULL;
     uint64_t intBuffer;
+    uUbxProtocolMessage_t batch[3];
+    int32_t batchLength;
 
     pBodyIn = (char *) malloc(U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE);
     U_PORT_TEST_ASSERT(pBodyIn != NULL);
@@ -152,6 +188,42 @@ U_PORT_TEST_FUNCTION("[ubxProtocol]", "ubxProtocolBackToBack")
     U_PORT_TEST_ASSERT(uUbxProtocolDecode(pBuffer, 10 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES,
                                           NULL, NULL, NULL, 0, NULL) == 10);
 
+    // Test batch encoding: three messages, one with no body
+    batch[0].messageClass = 0x06;
+    batch[0].messageId = 0x8a;
+    batch[0].pBody = pBodyIn;
+    batch[0].bodyLengthBytes = 10;
+    batch[1].messageClass = 0x0a;
+    batch[1].messageId = 0x04;
+    batch[1].pBody = NULL;
+    batch[1].bodyLengthBytes = 0;
+    batch[2].messageClass = 0x06;
+    batch[2].messageId = 0x8b;
+    batch[2].pBody = pBodyIn + 10;
+    batch[2].bodyLengthBytes = 20;
+    batchLength = 10 + 20 + (3 * U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(uUbxProtocolEncodeBatch(batch, 3, NULL, 0) == batchLength);
+    U_PORT_TEST_ASSERT(uUbxProtocolEncodeBatch(batch, 3, pBuffer,
+                                               batchLength - 1) == (int32_t) U_ERROR_COMMON_NO_MEMORY);
+    U_PORT_TEST_ASSERT(uUbxProtocolEncodeBatch(NULL, 3, pBuffer, batchLength) < 0);
+    U_PORT_TEST_ASSERT(uUbxProtocolEncodeBatch(batch, 0, pBuffer, batchLength) == 0);
+    U_PORT_TEST_ASSERT(uUbxProtocolEncodeBatch(batch, 3, pBuffer, batchLength) == batchLength);
+    pTmp = pBuffer;
+    for (size_t x = 0; x < sizeof(batch) / sizeof(batch[0]); x++) {
+        U_PORT_TEST_ASSERT(uUbxProtocolDecode(pTmp, (pBuffer + batchLength) - pTmp,
+                                              &classOut, &idOut, pBodyOut,
+                                              U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE,
+                                              &pTmp) == (int32_t) batch[x].bodyLengthBytes);
+        U_PORT_TEST_ASSERT(classOut == batch[x].messageClass);
+        U_PORT_TEST_ASSERT(idOut == batch[x].messageId);
+        U_PORT_TEST_ASSERT((batch[x].bodyLengthBytes == 0) ||
+                           (memcmp(pBodyOut, batch[x].pBody, batch[x].bodyLengthBytes) == 0));
+    }
+    U_PORT_TEST_ASSERT(pTmp == pBuffer + batchLength);
+    // A body length without a body is rejected
+    batch[1].bodyLengthBytes = 1;
+    U_PORT_TEST_ASSERT(uUbxProtocolEncodeBatch(batch, 3, NULL, 0) < 0);
+
     // Test the integer encode/decode functions
     // There is a bug in Zephyr (https://github.com/zephyrproject-rtos/zephyr/issues/30723)
     // where malloc() does not return a pointer that is aligned for 64-bit
@@ -165,12 +237,261 @@ U_PORT_TEST_FUNCTION("[ubxProtocol]", "ubxProtocolBackToBack")
     intBuffer = uUbxProtocolUint64Encode((uint64_t) z);
     U_PORT_TEST_ASSERT(uUbxProtocolUint64Decode((char *) &intBuffer) == z);
 
+    // ...and the floating point decode functions: 1.5 as an
+    // IEEE 754 single and as a double
+    intBuffer = uUbxProtocolUint32Encode(0x3fc00000UL);
+    U_PORT_TEST_ASSERT(uUbxProtocolFloatDecode((char *) &intBuffer) == 1.5f);
+    intBuffer = uUbxProtocolUint64Encode(0x3ff8000000000000ULL);
+    U_PORT_TEST_ASSERT(uUbxProtocolDoubleDecode((char *) &intBuffer) == 1.5);
+
     // Free memory
     free(pBodyIn);
     free(pBodyOut);
     free(pBuffer);
 }
 
+/** Test of the UBX protocol checksum: correctness against the
+ * obvious implementation for all alignments and for lengths that
+ * exercise the body and the tail of the unrolled loop, plus a
+ * measurement of how long it takes.
+ */
+U_PORT_TEST_FUNCTION("[ubxProtocol]", "ubxProtocolChecksum")
+{
+    char *pBuffer;
+    uint8_t ca1;
+    uint8_t cb1;
+    uint8_t ca2;
+    uint8_t cb2;
+    uBench_t bench;
+
+    pBuffer = (char *) malloc(U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    for (size_t x = 0; x < U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE; x++) {
+        //lint -e(613) Suppress possible nullness in pBuffer, it is checked above
+        *(pBuffer + x) = (char) ((x * 151) + 0xf0);
+    }
+
+    for (size_t offset = 0; offset < 4; offset++) {
+        for (size_t size = 0; size < 64; size++) {
+            ca1 = 0;
+            cb1 = 0;
+            checksumSimple(pBuffer + offset, size, &ca1, &cb1);
+            ca2 = 0;
+            cb2 = 0;
+            uUbxProtocolChecksumUpdate(pBuffer + offset, size, &ca2, &cb2);
+            U_PORT_TEST_ASSERT((ca1 == ca2) && (cb1 == cb2));
+        }
+    }
+    // A long one, done in uneven pieces, must match too
+    ca1 = 0;
+    cb1 = 0;
+    checksumSimple(pBuffer, U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE, &ca1, &cb1);
+    ca2 = 0;
+    cb2 = 0;
+    for (size_t x = 0; x < U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE; x += 7) {
+        size_t size = U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE - x;
+        if (size > 7) {
+            size = 7;
+        }
+        uUbxProtocolChecksumUpdate(pBuffer + x, size, &ca2, &cb2);
+    }
+    U_PORT_TEST_ASSERT((ca1 == ca2) && (cb1 == cb2));
+
+    // Time it against the obvious implementation, just for information
+    ca1 = 0;
+    cb1 = 0;
+    uBenchStart(&bench, "ubxProtocolChecksumSimple");
+    for (size_t x = 0; x < U_UBX_PROTOCOL_TEST_CHECKSUM_ITERATIONS; x++) {
+        checksumSimple(pBuffer, U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE, &ca1, &cb1);
+    }
+    uBenchStop(&bench, U_UBX_PROTOCOL_TEST_CHECKSUM_ITERATIONS,
+               U_UBX_PROTOCOL_TEST_CHECKSUM_ITERATIONS * U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE,
+               "bytes");
+    ca2 = 0;
+    cb2 = 0;
+    uBenchStart(&bench, "ubxProtocolChecksumUpdate");
+    for (size_t x = 0; x < U_UBX_PROTOCOL_TEST_CHECKSUM_ITERATIONS; x++) {
+        uUbxProtocolChecksumUpdate(pBuffer, U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE, &ca2, &cb2);
+    }
+    uBenchStop(&bench, U_UBX_PROTOCOL_TEST_CHECKSUM_ITERATIONS,
+               U_UBX_PROTOCOL_TEST_CHECKSUM_ITERATIONS * U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE,
+               "bytes");
+    // Also stops the compiler optimising the loops away
+    U_PORT_TEST_ASSERT((ca1 == ca2) && (cb1 == cb2));
+
+    // Free memory
+    free(pBuffer);
+}
+
+/** Test of the resumable UBX protocol decoder, feeding it a stream
+ * of messages, with junk and a corrupted message in between, in
+ * chunks of varying sizes.
+ */
+U_PORT_TEST_FUNCTION("[ubxProtocol]", "ubxProtocolDecoder")
+{
+    uUbxProtocolDecoder_t decoder;
+    char *pBodyIn;
+    char *pBodyOut;
+    char *pBuffer;
+    char *pWrite;
+    const char *pRead;
+    const char *pTmp;
+    size_t length;
+    size_t chunkSize;
+    size_t messageCount = 0;
+    size_t x;
+    int32_t y;
+    int32_t classOut;
+    int32_t idOut;
+    // Some message body sizes, one of them larger than the
+    // decode storage
+    const size_t bodySize[] = {0, 1, 17, 100, U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE / 2, 3};
+
+    pBodyIn = (char *) malloc(U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE);
+    U_PORT_TEST_ASSERT(pBodyIn != NULL);
+    pBodyOut = (char *) malloc(U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE / 4);
+    U_PORT_TEST_ASSERT(pBodyOut != NULL);
+    pBuffer = (char *) malloc(U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE * 2);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+
+    for (x = 0; x < U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE; x++) {
+        //lint -e(613) Suppress possible nullness in pBodyIn, it is checked above
+        *(pBodyIn + x) = (char) (x * 7);
+    }
+
+    // Build the stream: each message preceded by junk that includes
+    // a lone 0xb5, with a copy of the third message, CRC corrupted,
+    // just before the third message
+    pWrite = pBuffer;
+    for (x = 0; x < sizeof(bodySize) / sizeof(bodySize[0]); x++) {
+        *pWrite++ = 'j';
+        //lint -e(650) Suppress constant out of range; it isn't
+        *pWrite++ = (char) 0xb5;
+        *pWrite++ = 'k';
+        if (x == 2) {
+            y = uUbxProtocolEncode(0x10, 0x20, pBodyIn, bodySize[x], pWrite);
+            (*(pWrite + y - 1))++;
+            pWrite += y;
+        }
+        pWrite += uUbxProtocolEncode((int32_t) x, (int32_t) x + 1,
+                                     pBodyIn, bodySize[x], pWrite);
+    }
+    length = pWrite - pBuffer;
+
+    // Now decode it in chunks of 1 byte, 2 bytes, etc.
+    for (chunkSize = 1; chunkSize < length; chunkSize += (chunkSize * 2) + 1) {
+        uUbxProtocolDecoderInit(&decoder, pBodyOut, U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE / 4);
+        U_TEST_PRINT_LINE("decoding %d byte(s) in chunks of %d byte(s).",
+                          length, chunkSize);
+        messageCount = 0;
+        for (pRead = pBuffer; pRead < pBuffer + length; pRead += x) {
+            x = chunkSize;
+            if (x > (size_t) ((pBuffer + length) - pRead)) {
+                x = (size_t) ((pBuffer + length) - pRead);
+            }
+            pTmp = pRead;
+            while (pTmp < pRead + x) {
+                y = uUbxProtocolDecoderDecode(&decoder, pTmp, (pRead + x) - pTmp,
+                                              &classOut, &idOut, &pTmp);
+                if (y >= 0) {
+                    U_PORT_TEST_ASSERT(messageCount < sizeof(bodySize) / sizeof(bodySize[0]));
+                    U_PORT_TEST_ASSERT(y == (int32_t) bodySize[messageCount]);
+                    U_PORT_TEST_ASSERT(classOut == (int32_t) messageCount);
+                    U_PORT_TEST_ASSERT(idOut == (int32_t) messageCount + 1);
+                    if (y > U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE / 4) {
+                        y = U_UBX_PROTOCOL_TEST_MAX_BODY_SIZE / 4;
+                    }
+                    U_PORT_TEST_ASSERT(memcmp(pBodyOut, pBodyIn, y) == 0);
+                    messageCount++;
+                } else {
+                    // Only ever a partial message or nothing
+                    U_PORT_TEST_ASSERT((y == (int32_t) U_ERROR_COMMON_TIMEOUT) ||
+                                       (y == (int32_t) U_ERROR_COMMON_NOT_FOUND));
+                    U_PORT_TEST_ASSERT(pTmp == pRead + x);
+                }
+            }
+        }
+        U_PORT_TEST_ASSERT(messageCount == sizeof(bodySize) / sizeof(bodySize[0]));
+    }
+
+    // A partial message is reported as such and an empty chunk is fine
+    uUbxProtocolDecoderInit(&decoder, NULL, 0);
+    U_PORT_TEST_ASSERT(uUbxProtocolDecoderDecode(&decoder, NULL, 0, NULL, NULL,
+                                                 NULL) == (int32_t) U_ERROR_COMMON_NOT_FOUND);
+    y = uUbxProtocolEncode(0x01, 0x02, pBodyIn, 10, pBuffer);
+    U_PORT_TEST_ASSERT(uUbxProtocolDecoderDecode(&decoder, pBuffer, y - 1, NULL, NULL,
+                                                 NULL) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(uUbxProtocolDecoderDecode(&decoder, pBuffer + y - 1, 1, NULL, NULL,
+                                                 &pTmp) == 10);
+    U_PORT_TEST_ASSERT(pTmp == pBuffer + y);
+    // Bad parameters
+    U_PORT_TEST_ASSERT(uUbxProtocolDecoderDecode(NULL, pBuffer, y, NULL, NULL, NULL) < 0);
+    U_PORT_TEST_ASSERT(uUbxProtocolDecoderDecode(&decoder, NULL, 1, NULL, NULL, NULL) < 0);
+
+    // Free memory
+    free(pBodyIn);
+    free(pBodyOut);
+    free(pBuffer);
+}
+
+/** Benchmark encoding and decoding a UBX protocol message.
+ */
+U_PORT_BENCH_FUNCTION("[ubxProtocol]", "ubxProtocolBenchEncodeDecode")
+{
+    char *pBody;
+    char *pBodyOut;
+    char *pBuffer;
+    int32_t messageClass = -1;
+    int32_t messageId = -1;
+    const char *pBufferOut = NULL;
+    int32_t length = 0;
+    uBench_t bench;
+
+    pBody = (char *) malloc(U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE);
+    U_PORT_TEST_ASSERT(pBody != NULL);
+    pBodyOut = (char *) malloc(U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE);
+    U_PORT_TEST_ASSERT(pBodyOut != NULL);
+    pBuffer = (char *) malloc(U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE +
+                              U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    for (size_t x = 0; x < U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE; x++) {
+        //lint -e(613) Suppress possible nullness in pBody, it is checked above
+        *(pBody + x) = (char) ((x * 151) + 0xf0);
+    }
+
+    uBenchStart(&bench, "ubxProtocolEncode");
+    for (size_t x = 0; x < U_UBX_PROTOCOL_TEST_BENCH_ITERATIONS; x++) {
+        length = uUbxProtocolEncode(0x01, 0x07, pBody,
+                                    U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE, pBuffer);
+    }
+    uBenchStop(&bench, U_UBX_PROTOCOL_TEST_BENCH_ITERATIONS,
+               U_UBX_PROTOCOL_TEST_BENCH_ITERATIONS * (uint32_t) length, "bytes");
+    U_PORT_TEST_ASSERT(length == U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE +
+                       U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
+
+    uBenchStart(&bench, "ubxProtocolDecode");
+    for (size_t x = 0; x < U_UBX_PROTOCOL_TEST_BENCH_ITERATIONS; x++) {
+        length = uUbxProtocolDecode(pBuffer, U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE +
+                                    U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES,
+                                    &messageClass, &messageId, pBodyOut,
+                                    U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE, &pBufferOut);
+    }
+    uBenchStop(&bench, U_UBX_PROTOCOL_TEST_BENCH_ITERATIONS,
+               U_UBX_PROTOCOL_TEST_BENCH_ITERATIONS * (U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE +
+                                                       U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES),
+               "bytes");
+    U_PORT_TEST_ASSERT(length == U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE);
+    U_PORT_TEST_ASSERT(messageClass == 0x01);
+    U_PORT_TEST_ASSERT(messageId == 0x07);
+    //lint -e(668) Suppress possible NULL pointers, they are checked above
+    U_PORT_TEST_ASSERT(memcmp(pBody, pBodyOut, U_UBX_PROTOCOL_TEST_BENCH_BODY_SIZE) == 0);
+
+    // Free memory
+    free(pBuffer);
+    free(pBodyOut);
+    free(pBody);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -27,7 +27,11 @@
  */
 
 /** @file
- * @brief This header file defines base64 encode and decode functions.
+ * @brief This header file defines base64 encode and decode functions,
+ * both for a whole buffer at once and, with a context, for data that
+ * is processed a chunk at a time, e.g. as it is sent or received, so
+ * that the RAM required scales with the size of a chunk rather than
+ * with the size of the whole.
  */
 
 #ifdef __cplusplus
@@ -38,10 +42,51 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The maximum number of bytes of base 64 that uBase64EncodeChunk()
+ * may write for a chunk of the given number of bytes of binary data.
+ */
+#define U_BASE64_ENCODE_CHUNK_LENGTH_MAX(binaryLengthBytes) ((((binaryLengthBytes) + 2) / 3) * 4)
+
+/** The maximum number of bytes of base 64 that uBase64EncodeFinish()
+ * may write.
+ */
+#define U_BASE64_ENCODE_FINISH_LENGTH_MAX 4
+
+/** The maximum number of bytes of binary data that uBase64DecodeChunk()
+ * may write for a chunk of the given number of bytes of base 64.
+ */
+#define U_BASE64_DECODE_CHUNK_LENGTH_MAX(base64LengthBytes) ((((base64LengthBytes) + 3) / 4) * 3)
+
+/** The maximum number of bytes of binary data that uBase64DecodeFinish()
+ * may write.
+ */
+#define U_BASE64_DECODE_FINISH_LENGTH_MAX 2
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The context of a chunked base 64 encode, see
+ * uBase64EncodeStart(): not to be accessed directly, use the
+ * functions.
+ */
+typedef struct {
+    uint8_t carry[2];   /**< binary data left over from the last chunk. */
+    size_t carryLength; /**< the number of bytes in carry. */
+} uBase64EncodeContext_t;
+
+/** The context of a chunked base 64 decode, see
+ * uBase64DecodeStart(): not to be accessed directly, use the
+ * functions.
+ */
+typedef struct {
+    uint32_t bits;      /**< the six-bit values left over from the
+                             last chunk. */
+    size_t numValues;   /**< the number of six-bit values in bits. */
+    size_t padLength;   /**< the number of padding characters seen. */
+    bool error;         /**< true if the base 64 was found to be invalid. */
+} uBase64DecodeContext_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -87,6 +132,105 @@ int32_t uBase64Encode(const char *pBinary, size_t binaryLengthBytes,
 int32_t uBase64Decode(const char *pBase64, size_t base64LengthBytes,
                       char *pBinary, size_t binaryLengthBytes);
 
+/** Start a chunked base 64 encode: call uBase64EncodeChunk() with
+ * each chunk of binary data and then uBase64EncodeFinish().  The
+ * result is the same as calling uBase64Encode() on all of the binary
+ * data at once.
+ *
+ * @param[out] pContext  the context to initialise; cannot be NULL.
+ */
+void uBase64EncodeStart(uBase64EncodeContext_t *pContext);
+
+/** Base 64 encode a chunk of binary data; up to two bytes of binary
+ * data may be held in the context until the next chunk.
+ *
+ * @param[in] pContext      the context, initialised with
+ *                          uBase64EncodeStart().
+ * @param[in] pBinary       the binary data to be encoded.
+ * @param binaryLengthBytes the amount of binary data.
+ * @param[out] pBase64      a place to store the base 64; no
+ *                          null-terminator is included.
+ * @param base64LengthBytes the amount of storage at pBase64; if this
+ *                          is at least
+ *                          #U_BASE64_ENCODE_CHUNK_LENGTH_MAX
+ *                          (binaryLengthBytes) there will be room.
+ * @return                  the number of bytes stored at pBase64, else
+ *                          negative error code, in which case nothing
+ *                          has been encoded and the context is
+ *                          unchanged.
+ */
+int32_t uBase64EncodeChunk(uBase64EncodeContext_t *pContext,
+                           const char *pBinary, size_t binaryLengthBytes,
+                           char *pBase64, size_t base64LengthBytes);
+
+/** Finish a chunked base 64 encode, writing the padded encoding of
+ * whatever is held in the context; the context may then be used
+ * for another encode.
+ *
+ * @param[in] pContext      the context.
+ * @param[out] pBase64      a place to store the base 64; no
+ *                          null-terminator is included.
+ * @param base64LengthBytes the amount of storage at pBase64; if this
+ *                          is at least #U_BASE64_ENCODE_FINISH_LENGTH_MAX
+ *                          there will be room.
+ * @return                  the number of bytes stored at pBase64, else
+ *                          negative error code.
+ */
+int32_t uBase64EncodeFinish(uBase64EncodeContext_t *pContext,
+                            char *pBase64, size_t base64LengthBytes);
+
+/** Start a chunked base 64 decode: call uBase64DecodeChunk() with
+ * each chunk of base 64 and then uBase64DecodeFinish().  Unlike
+ * uBase64Decode(), the base 64 is checked: white space (e.g. the
+ * line breaks of a PEM file) is ignored, padding is optional but,
+ * if present, must be correct and must come at the end, and any
+ * other character is an error.
+ *
+ * @param[out] pContext  the context to initialise; cannot be NULL.
+ */
+void uBase64DecodeStart(uBase64DecodeContext_t *pContext);
+
+/** Decode a chunk of base 64; up to three characters of base 64
+ * may be held in the context until the next chunk.  Decoding cannot
+ * be done in place.
+ *
+ * @param[in] pContext      the context, initialised with
+ *                          uBase64DecodeStart().
+ * @param[in] pBase64       the base 64 data to be decoded.
+ * @param base64LengthBytes the amount of base 64 data.
+ * @param[out] pBinary      a place to store the decoded data.
+ * @param binaryLengthBytes the amount of storage at pBinary; this
+ *                          must be at least
+ *                          #U_BASE64_DECODE_CHUNK_LENGTH_MAX
+ *                          (base64LengthBytes).
+ * @return                  the number of bytes stored at pBinary, else
+ *                          negative error code;
+ *                          #U_ERROR_COMMON_INVALID_PARAMETER if the
+ *                          base 64 is invalid, after which all further
+ *                          calls with this context will fail until
+ *                          uBase64DecodeStart() is called again.
+ */
+int32_t uBase64DecodeChunk(uBase64DecodeContext_t *pContext,
+                           const char *pBase64, size_t base64LengthBytes,
+                           char *pBinary, size_t binaryLengthBytes);
+
+/** Finish a chunked base 64 decode, writing whatever is held
+ * in the context, which will only be the case if the base 64 was not
+ * padded; the context may then be used for another decode.
+ *
+ * @param[in] pContext      the context.
+ * @param[out] pBinary      a place to store the decoded data.
+ * @param binaryLengthBytes the amount of storage at pBinary; if this
+ *                          is at least #U_BASE64_DECODE_FINISH_LENGTH_MAX
+ *                          there will be room.
+ * @return                  the number of bytes stored at pBinary, else
+ *                          negative error code;
+ *                          #U_ERROR_COMMON_INVALID_PARAMETER if the
+ *                          base 64 was invalid or incomplete.
+ */
+int32_t uBase64DecodeFinish(uBase64DecodeContext_t *pContext,
+                            char *pBinary, size_t binaryLengthBytes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -68,11 +68,26 @@ size_t uBinToHex(const char *pBin, size_t binLength, char *pHex);
  * @param pHex      a pointer to the ASCII hex data.
  * @param hexLength the number of bytes pointed to by pHex.
  * @param pBin      a pointer to a buffer of length half hexLength
- *                  bytes to store the binary version.
+ *                  bytes to store the binary version; this may
+ *                  be the same as pHex, see uHexToBinInPlace().
  * @return          the number of bytes at pBin.
  */
 size_t uHexToBin(const char *pHex, size_t hexLength, char *pBin);
 
+/** Convert a buffer of ASCII hex into the binary equivalent in
+ * place, e.g. so that hex data read into a buffer need not be
+ * copied into a second buffer to be decoded: the binary version
+ * occupies the first half of the buffer.  If it is not possible to
+ * convert a character (e.g. because it is not valid ASCII hex) then
+ * conversion stops there.
+ *
+ * @param pBuffer   a pointer to the ASCII hex data, which will
+ *                  be overwritten with the binary version.
+ * @param hexLength the number of bytes of ASCII hex at pBuffer.
+ * @return          the number of bytes of binary at pBuffer.
+ */
+size_t uHexToBinInPlace(char *pBuffer, size_t hexLength);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_JSON_H_
+#define _U_JSON_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __utils
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a JSON tokenizer for the responses
+ * of modules and services: it walks the JSON once, in place, with no
+ * allocation, handing back each key/value pair as pointers into the
+ * original buffer, which need not be null-terminated.  Strings are
+ * returned as they appear in the JSON, i.e. escape sequences are not
+ * expanded.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The maximum depth of nesting of objects and arrays that
+ * uJsonParse() will accept; this is fixed by the width of the
+ * bit-map used to track nesting.
+ */
+#define U_JSON_MAX_DEPTH 32
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The types of JSON value.
+ */
+typedef enum {
+    U_JSON_TYPE_NONE,   /**< used by uJsonFind() for a key that was
+                             not found. */
+    U_JSON_TYPE_OBJECT,
+    U_JSON_TYPE_ARRAY,
+    U_JSON_TYPE_STRING,
+    U_JSON_TYPE_NUMBER,
+    U_JSON_TYPE_BOOL,
+    U_JSON_TYPE_NULL
+} uJsonType_t;
+
+/** A key/value pair, as handed back by uJsonParse() and
+ * uJsonFind(); all pointers are into the JSON that was parsed.
+ */
+typedef struct {
+    const char *pKey;   /**< the key, without quotes, NULL for the
+                             outermost value and for a member of an
+                             array. */
+    size_t keyLength;   /**< the number of characters at pKey. */
+    uJsonType_t type;   /**< the type of the value. */
+    const char *pValue; /**< the value: for a string this is the
+                             string without quotes, for an object or
+                             an array this is the opening bracket. */
+    size_t valueLength; /**< the number of characters at pValue; 1 for
+                             an object or an array. */
+    int32_t depth;      /**< 0 for the outermost value, 1 for the
+                             members of the outermost object, etc. */
+} uJsonItem_t;
+
+/** The callback called by uJsonParse() for each value.
+ *
+ * @param[in] pItem      the key/value pair; valid only for the
+ *                       duration of the callback, though the
+ *                       pointers in it remain valid for as long as
+ *                       the JSON that was parsed.
+ * @param[in] pParameter the parameter given to uJsonParse().
+ * @return               true to carry on parsing, false to stop.
+ */
+typedef bool (*uJsonCallback_t)(const uJsonItem_t *pItem, void *pParameter);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Walk a JSON value, in a single pass, calling the callback for
+ * each value in order, objects and arrays being reported when
+ * they open; parsing ends when the outermost value is complete,
+ * anything following it being ignored.
+ *
+ * @param[in] pJson      the JSON.
+ * @param length         the number of characters at pJson.
+ * @param pCallback      the callback; cannot be NULL.
+ * @param[in] pParameter a parameter to pass to the callback;
+ *                       may be NULL.
+ * @return               the number of values reported, which
+ *                       includes the one for which the callback
+ *                       returned false, if it did, else negative
+ *                       error code if the JSON is malformed or is
+ *                       nested more than #U_JSON_MAX_DEPTH deep.
+ */
+int32_t uJsonParse(const char *pJson, size_t length,
+                   uJsonCallback_t pCallback, void *pParameter);
+
+/** Find the values of a set of keys in the outermost object of
+ * some JSON in a single pass, stopping as soon as all have been
+ * found.
+ *
+ * @param[in] pJson   the JSON.
+ * @param length      the number of characters at pJson.
+ * @param[in] ppKey   an array of numKeys null-terminated keys.
+ * @param numKeys     the number of keys.
+ * @param[out] pItem  an array of numKeys items in which the value
+ *                    of each key is returned; the type of the
+ *                    item of a key that was not found is set to
+ *                    #U_JSON_TYPE_NONE.  Where a key appears more
+ *                    than once the first is returned.
+ * @return            the number of keys found, else negative error
+ *                    code if the JSON is malformed.
+ */
+int32_t uJsonFind(const char *pJson, size_t length,
+                  const char *const *ppKey, size_t numKeys,
+                  uJsonItem_t *pItem);
+
+/** Convert a JSON number into an int32_t with the given power of
+ * ten multiplier, without using floating point, e.g. 52.0187499
+ * with a powerOfTen of 7 becomes 520187499; digits beyond the
+ * given power of ten are truncated.
+ *
+ * @param[in] pItem   the item, which must be of type
+ *                    #U_JSON_TYPE_NUMBER.
+ * @param powerOfTen  the power of ten to multiply by, 0 or more.
+ * @param[out] pValue a place to put the result; cannot be NULL.
+ * @return            zero on success else negative error code, e.g.
+ *                    if the item is not a number or the result will
+ *                    not fit.
+ */
+int32_t uJsonToInt32(const uJsonItem_t *pItem, int32_t powerOfTen,
+                     int32_t *pValue);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_JSON_H_
+
+// End of file
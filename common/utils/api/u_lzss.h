@@ -0,0 +1,127 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_LZSS_H_
+#define _U_LZSS_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __utils
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a small-footprint LZSS compressor
+ * and decompressor, suitable for an MCU: neither allocates memory
+ * or needs any working storage beyond the input and output buffers,
+ * since the "window" in which earlier data is found is simply the
+ * part of the buffer that has already been processed, limited to
+ * #U_LZSS_WINDOW_LENGTH_BYTES back.
+ *
+ * The compressed form is a sequence of groups, each a flag byte
+ * followed by up to eight items, bit 0 of the flag byte describing
+ * the first item: a zero bit is a literal byte, a one bit is a
+ * two-byte reference, the lower eight bits of (offset - 1) followed
+ * by a byte with the upper four bits of (offset - 1) in its upper
+ * nibble and (length - #U_LZSS_MATCH_LENGTH_MIN) in its lower nibble,
+ * meaning "copy length bytes from offset bytes back".
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_LZSS_WINDOW_LENGTH_BYTES
+/** How far back uLzssCompress() looks for a match: a larger window
+ * may compress better but takes longer; cannot be more than 4096.
+ * This affects only compression, any compressed data can be
+ * decompressed whatever the setting.
+ */
+# define U_LZSS_WINDOW_LENGTH_BYTES 1024
+#endif
+
+/** The shortest match that is encoded as a reference.
+ */
+#define U_LZSS_MATCH_LENGTH_MIN 3
+
+/** The longest match that can be encoded as a reference.
+ */
+#define U_LZSS_MATCH_LENGTH_MAX (U_LZSS_MATCH_LENGTH_MIN + 15)
+
+/** The largest number of bytes that uLzssCompress() may write
+ * for the given number of bytes of input, i.e. for input that
+ * does not compress at all.
+ */
+#define U_LZSS_COMPRESS_LENGTH_MAX(lengthBytes) ((lengthBytes) + (((lengthBytes) + 7) / 8))
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Compress a buffer.
+ *
+ * @param[in] pIn         the data to compress; cannot be NULL.
+ * @param inLengthBytes   the number of bytes at pIn.
+ * @param[out] pOut       a place to put the compressed data; cannot
+ *                        be NULL.
+ * @param outLengthBytes  the number of bytes of storage at pOut;
+ *                        #U_LZSS_COMPRESS_LENGTH_MAX(inLengthBytes)
+ *                        is always enough.
+ * @return                on success the number of bytes written to
+ *                        pOut, else negative error code; in
+ *                        particular #U_ERROR_COMMON_NO_MEMORY if
+ *                        the compressed data would not fit in
+ *                        outLengthBytes, so a caller that only wants
+ *                        the compressed form if it is smaller can
+ *                        set outLengthBytes to inLengthBytes - 1.
+ */
+int32_t uLzssCompress(const char *pIn, size_t inLengthBytes,
+                      char *pOut, size_t outLengthBytes);
+
+/** Decompress a buffer that was compressed with uLzssCompress().
+ *
+ * @param[in] pIn         the compressed data; cannot be NULL.
+ * @param inLengthBytes   the number of bytes at pIn.
+ * @param[out] pOut       a place to put the decompressed data;
+ *                        cannot be NULL and must not overlap pIn.
+ * @param outLengthBytes  the number of bytes of storage at pOut.
+ * @return                on success the number of bytes written to
+ *                        pOut, else negative error code; in
+ *                        particular #U_ERROR_COMMON_NO_MEMORY if the
+ *                        decompressed data would not fit in
+ *                        outLengthBytes or
+ *                        #U_ERROR_COMMON_INVALID_PARAMETER if pIn
+ *                        is not valid compressed data.
+ */
+int32_t uLzssDecompress(const char *pIn, size_t inLengthBytes,
+                        char *pOut, size_t outLengthBytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_LZSS_H_
+
+// End of file
@@ -31,6 +31,16 @@
  * API for efficient EDM transport.  The API functions are thread-safe except for the
  * uMemPoolInit() and uMemPoolDeinit() APIs, which should not be called while any
  * of the other API calls are in progress.
+ *
+ * Also defined here is a slab allocator, a set of pools of blocks of
+ * different sizes ("classes"), where the free list of each class is
+ * lock-free, so that allocation and freeing may be performed from
+ * any task or from an interrupt, and all of the backing storage is
+ * obtained once, at initialisation, so that the heap is not
+ * fragmented over time.  A library-wide slab, uMemPoolMalloc() and
+ * uMemPoolFree(), sits in front of malloc()/free() for the small
+ * blocks the library allocates and frees repeatedly, e.g. the
+ * parameter blocks passed to URC callbacks.
  */
 #ifdef __cplusplus
 extern "C" {
@@ -40,6 +50,70 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_MEMPOOL_SLAB_CLASSES_MAX_NUM
+/** The maximum number of size classes in a slab.
+ */
+# define U_MEMPOOL_SLAB_CLASSES_MAX_NUM 4
+#endif
+
+#ifndef U_MEMPOOL_SLAB_BLOCKS_MAX_NUM
+/** The maximum number of blocks in a single class of a slab, limited
+ * by the free list of a class being held as 16-bit block indexes.
+ */
+# define U_MEMPOOL_SLAB_BLOCKS_MAX_NUM 0xFFFE
+#endif
+
+#ifndef U_MEMPOOL_SLAB_ALIGNMENT_BYTES
+/** The alignment of every block in a slab; block sizes are rounded
+ * up to a multiple of this.
+ */
+# define U_MEMPOOL_SLAB_ALIGNMENT_BYTES 8
+#endif
+
+#ifndef U_MEMPOOL_MALLOC_SMALL_BLOCK_SIZE
+/** The block size of the smallest class of the library-wide slab
+ * used by uMemPoolMalloc().
+ */
+# define U_MEMPOOL_MALLOC_SMALL_BLOCK_SIZE 32
+#endif
+
+#ifndef U_MEMPOOL_MALLOC_SMALL_BLOCK_COUNT
+/** The number of blocks in the smallest class of the library-wide
+ * slab used by uMemPoolMalloc(); set all of the
+ * U_MEMPOOL_MALLOC_xxx_BLOCK_COUNT values to zero for uMemPoolMalloc()
+ * to be exactly malloc().
+ */
+# define U_MEMPOOL_MALLOC_SMALL_BLOCK_COUNT 16
+#endif
+
+#ifndef U_MEMPOOL_MALLOC_MEDIUM_BLOCK_SIZE
+/** The block size of the middle class of the library-wide slab
+ * used by uMemPoolMalloc().
+ */
+# define U_MEMPOOL_MALLOC_MEDIUM_BLOCK_SIZE 64
+#endif
+
+#ifndef U_MEMPOOL_MALLOC_MEDIUM_BLOCK_COUNT
+/** The number of blocks in the middle class of the library-wide
+ * slab used by uMemPoolMalloc().
+ */
+# define U_MEMPOOL_MALLOC_MEDIUM_BLOCK_COUNT 8
+#endif
+
+#ifndef U_MEMPOOL_MALLOC_LARGE_BLOCK_SIZE
+/** The block size of the largest class of the library-wide slab
+ * used by uMemPoolMalloc(); anything bigger comes from malloc().
+ */
+# define U_MEMPOOL_MALLOC_LARGE_BLOCK_SIZE 192
+#endif
+
+#ifndef U_MEMPOOL_MALLOC_LARGE_BLOCK_COUNT
+/** The number of blocks in the largest class of the library-wide
+ * slab used by uMemPoolMalloc().
+ */
+# define U_MEMPOOL_MALLOC_LARGE_BLOCK_COUNT 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -53,6 +127,60 @@ typedef struct {
     uPortMutexHandle_t mutex; /**< mutex for thread protection. */
 } uMemPoolDesc_t;
 
+/** The configuration of one size class of a slab, see
+ * uMemPoolSlabInit().
+ */
+typedef struct {
+    size_t blockSize;  /**< the size of each block in the class. */
+    size_t blockCount; /**< the number of blocks in the class, up to
+                            #U_MEMPOOL_SLAB_BLOCKS_MAX_NUM. */
+} uMemPoolSlabClassCfg_t;
+
+/** The statistics of one size class of a slab, see
+ * uMemPoolSlabGetStats().
+ */
+typedef struct {
+    size_t blockSize;      /**< the size of each block in the class,
+                                which may be larger than was asked for
+                                in the configuration due to alignment. */
+    size_t blockCount;     /**< the number of blocks in the class. */
+    size_t inUse;          /**< the number of blocks currently allocated. */
+    size_t inUseHighWater; /**< the largest number of blocks that have
+                                been allocated at any one time. */
+    size_t failures;       /**< the number of allocations of a size
+                                that best fitted this class which could
+                                not be served by the slab at all. */
+} uMemPoolSlabStats_t;
+
+/** One size class of a slab: not to be accessed directly, use the
+ * functions.
+ */
+typedef struct {
+    uint8_t *pBuffer;                  /**< start of the blocks of the class. */
+    size_t blockSize;                  /**< the aligned block size. */
+    uint32_t blockCount;               /**< the number of blocks. */
+    volatile uint32_t freeHead;        /**< the index of the first free block in
+                                            the lower 16 bits, 0xFFFF if there is
+                                            none, plus a count that changes with
+                                            every update in the upper 16 bits. */
+    volatile uint32_t inUse;           /**< the number of blocks in use. */
+    volatile uint32_t inUseHighWater;  /**< the high-water mark of inUse. */
+    volatile uint32_t failures;        /**< the number of failed allocations. */
+} uMemPoolSlabClass_t;
+
+/** A slab: not to be accessed directly, use the functions.
+ */
+typedef struct {
+    uMemPoolSlabClass_t classes[U_MEMPOOL_SLAB_CLASSES_MAX_NUM]; /**< in
+                                                                      ascending
+                                                                      order of
+                                                                      block size. */
+    size_t numClasses;      /**< the number of entries in classes[]. */
+    uint8_t *pBuffer;       /**< the start of the backing storage. */
+    size_t bufferSize;      /**< the size of the backing storage. */
+    bool bufferIsMalloced;  /**< true if pBuffer was malloc()ed. */
+} uMemPoolSlab_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -98,6 +226,137 @@ void uMemPoolFreeMem(uMemPoolDesc_t *pMemPool, void *ptr);
  */
 void uMemPoolFreeAllMem(uMemPoolDesc_t *pMemPool);
 
+/* ----------------------------------------------------------------
+ * FUNCTIONS: SLAB
+ * -------------------------------------------------------------- */
+
+/** Get the size of the backing storage that uMemPoolSlabInit() needs
+ * for a given configuration, including any padding required for
+ * alignment; use this to size a static buffer.
+ *
+ * @param[in] pCfg      the configuration of the size classes; cannot
+ *                      be NULL.
+ * @param numClasses    the number of entries at pCfg.
+ * @return              the number of bytes of backing storage required.
+ */
+size_t uMemPoolSlabBufferSize(const uMemPoolSlabClassCfg_t *pCfg,
+                              size_t numClasses);
+
+/** Initialise a slab.  All of the backing storage is obtained here,
+ * from pBuffer if it is given else with a single malloc(), after
+ * which uMemPoolSlabAlloc() and uMemPoolSlabFree() never call
+ * malloc() or free() and may be called from an interrupt.  This
+ * function is not thread-safe and must not be called from an
+ * interrupt.
+ *
+ * @param[out] pSlab    pointer to the slab to initialise.
+ * @param[in] pCfg      the configuration of the size classes,
+ *                      which must be in ascending order of block
+ *                      size; cannot be NULL.
+ * @param numClasses    the number of entries at pCfg, up to
+ *                      #U_MEMPOOL_SLAB_CLASSES_MAX_NUM.
+ * @param[in] pBuffer   the backing storage to use, at least
+ *                      uMemPoolSlabBufferSize() bytes; use NULL
+ *                      to have the backing storage malloc()ed.
+ * @param bufferSize    the number of bytes at pBuffer, ignored if
+ *                      pBuffer is NULL.
+ * @return              zero on success else negative error code.
+ */
+int32_t uMemPoolSlabInit(uMemPoolSlab_t *pSlab,
+                         const uMemPoolSlabClassCfg_t *pCfg,
+                         size_t numClasses,
+                         void *pBuffer, size_t bufferSize);
+
+/** Deinitialise a slab, freeing the backing storage if it was
+ * malloc()ed; any blocks still allocated from the slab become invalid.
+ * This function is not thread-safe and must not be called from an
+ * interrupt.
+ *
+ * @param[in] pSlab     pointer to the slab.
+ */
+void uMemPoolSlabDeinit(uMemPoolSlab_t *pSlab);
+
+/** Allocate a block from a slab: the block comes from the class with
+ * the smallest block size that is at least size or, if that class
+ * has no free blocks, from the next class up, and so on.  Thread-safe
+ * and may be called from an interrupt.
+ *
+ * @param[in] pSlab     pointer to the slab.
+ * @param size          the number of bytes required.
+ * @return              a pointer to the block, aligned to
+ *                      #U_MEMPOOL_SLAB_ALIGNMENT_BYTES, or NULL if
+ *                      there is no free block large enough.
+ */
+void *uMemPoolSlabAlloc(uMemPoolSlab_t *pSlab, size_t size);
+
+/** Free a block that was allocated from a slab.  Thread-safe and
+ * may be called from an interrupt.
+ *
+ * @param[in] pSlab     pointer to the slab.
+ * @param[in] pMem      the block to free; may be NULL.
+ * @return              true if pMem was a block of the slab and has
+ *                      been freed, false if pMem is not a block of
+ *                      the slab (or is NULL), in which case nothing
+ *                      has been done.
+ */
+bool uMemPoolSlabFree(uMemPoolSlab_t *pSlab, void *pMem);
+
+/** Get the size of a block that was allocated from a slab, which
+ * may be larger than was asked for since uMemPoolSlabAlloc() moves
+ * up to the next class when a class is empty.  Thread-safe and may
+ * be called from an interrupt.
+ *
+ * @param[in] pSlab     pointer to the slab.
+ * @param[in] pMem      the block.
+ * @return              the size of the block, zero if pMem is not
+ *                      a block of the slab (or is NULL).
+ */
+size_t uMemPoolSlabBlockSize(const uMemPoolSlab_t *pSlab, const void *pMem);
+
+/** Get the statistics of a size class of a slab.
+ *
+ * @param[in] pSlab       pointer to the slab.
+ * @param classIndex      the index of the size class, in the order
+ *                        of the configuration given to
+ *                        uMemPoolSlabInit().
+ * @param[out] pStats     a place to put the statistics; cannot be NULL.
+ * @return                zero on success else negative error code.
+ */
+int32_t uMemPoolSlabGetStats(const uMemPoolSlab_t *pSlab,
+                             size_t classIndex,
+                             uMemPoolSlabStats_t *pStats);
+
+/** A drop-in replacement for malloc() for small blocks that are
+ * allocated and freed repeatedly: the block comes from a library-wide
+ * slab with static backing storage, the classes of which are
+ * configured with the U_MEMPOOL_MALLOC_xxx macros, or from
+ * pUPortHeapAlloc() if there is no free block large enough in the slab.  A block
+ * obtained with this function MUST be freed with uMemPoolFree().
+ *
+ * @param size          the number of bytes required.
+ * @return              a pointer to the block or NULL on failure.
+ */
+void *uMemPoolMalloc(size_t size);
+
+/** Free a block obtained with uMemPoolMalloc().
+ *
+ * @param[in] pMem      the block to free; may be NULL.
+ */
+void uMemPoolFree(void *pMem);
+
+/** Get the statistics of a size class of the library-wide slab
+ * used by uMemPoolMalloc().
+ *
+ * @param classIndex      the index of the size class: 0 for small,
+ *                        1 for medium and 2 for large, less any
+ *                        classes that are configured to have a zero
+ *                        block count.
+ * @param[out] pStats     a place to put the statistics; cannot be NULL.
+ * @return                zero on success else negative error code.
+ */
+int32_t uMemPoolMallocGetStats(size_t classIndex,
+                               uMemPoolSlabStats_t *pStats);
+
 #ifdef __cplusplus
 }
 #endif
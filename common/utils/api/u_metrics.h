@@ -0,0 +1,375 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_METRICS_H_
+#define _U_METRICS_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "stddef.h"
+#include "stdint.h"
+#include "stdbool.h"
+
+/** \addtogroup __utils
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a library-wide registry of named
+ * metrics: counters, gauges and histograms.  A subsystem sets up a
+ * metric, the memory for which, #uMetric_t, belongs to it, registers
+ * it with uMetricsRegister() and then updates it as it goes; anyone
+ * may then read all of the registered metrics through one API,
+ * uMetricsEnumerate(), or have them formatted as JSON with
+ * uMetricsToJson(), e.g. for a telemetry task, without any glue
+ * specific to a subsystem.  uMetricsExportStart() runs such a task
+ * for you, calling a function of your choosing periodically with
+ * the JSON; uMqttClientMetricsExportStart() uses this to publish
+ * the metrics to an MQTT topic.
+ *
+ * Updating a metric, uMetricsCounterAdd(), uMetricsGaugeSet() or
+ * uMetricsHistogramAdd(), is lock-free, costing a compare-and-swap
+ * or two, and so may be done from any task or from an interrupt;
+ * values are 32 bits wide and a counter wraps.  A gauge may instead
+ * be given a read function, so that a value a subsystem already
+ * keeps, e.g. a ring buffer loss count, can be reported without
+ * being copied on every change.  Registration, deregistration,
+ * enumeration and export are thread-safe but may not be called from
+ * an interrupt.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_METRICS_EXPORT_TASK_STACK_SIZE_BYTES
+/** The stack size of the task started by uMetricsExportStart();
+ * note that the export function is called from this task.
+ */
+# define U_METRICS_EXPORT_TASK_STACK_SIZE_BYTES 2560
+#endif
+
+#ifndef U_METRICS_EXPORT_TASK_PRIORITY
+/** The priority of the task started by uMetricsExportStart().
+ */
+# define U_METRICS_EXPORT_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+#ifndef U_METRICS_EXPORT_BUFFER_LENGTH_BYTES
+/** The size of the buffer, allocated by uMetricsExportStart(),
+ * into which the metrics are formatted as JSON for export; metrics
+ * that do not fit are left out of the export.
+ */
+# define U_METRICS_EXPORT_BUFFER_LENGTH_BYTES 1024
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The types of metric.
+ */
+typedef enum {
+    U_METRICS_TYPE_COUNTER,   /**< a value that only goes up, e.g. bytes sent. */
+    U_METRICS_TYPE_GAUGE,     /**< a value that goes up and down, e.g. the
+                                   minimum free stack of a task. */
+    U_METRICS_TYPE_HISTOGRAM, /**< a count of values in each of a set of bins,
+                                   e.g. latencies. */
+    U_METRICS_TYPE_MAX_NUM
+} uMetricsType_t;
+
+/** The function that returns the value of a gauge which is read
+ * when required rather than set, see uMetricsGaugeInit(); it is
+ * called from whichever task is enumerating or exporting the
+ * metrics and must not call into this API.
+ *
+ * @param[in] pReadParam  the parameter given to uMetricsGaugeInit().
+ * @return                the value of the gauge.
+ */
+typedef int32_t (*uMetricsRead_t)(void *pReadParam);
+
+/** A metric; the fields are private to this API, use
+ * uMetricsCounterInit(), uMetricsGaugeInit() or uMetricsHistogramInit()
+ * to set it up and uMetricsValue(), uMetricsHistogramBinCount() etc.
+ * to read it.
+ */
+typedef struct uMetric_t {
+    struct uMetric_t *pNext;      /**< the next registered metric. */
+    const char *pName;            /**< the name of the metric. */
+    uMetricsType_t type;          /**< the type of the metric. */
+    volatile int32_t value;       /**< the value of a counter or gauge,
+                                       the total of the values added to
+                                       a histogram. */
+    uMetricsRead_t pRead;         /**< the read function of a gauge,
+                                       may be NULL. */
+    void *pReadParam;             /**< the parameter for pRead. */
+    const int32_t *pBinLimit;     /**< the upper limit of each bin of
+                                       a histogram but the last. */
+    volatile uint32_t *pBinCount; /**< the count in each bin of a
+                                       histogram. */
+    size_t numBins;               /**< the number of bins of a histogram. */
+    bool registered;              /**< true if the metric is registered. */
+} uMetric_t;
+
+/** The function that uMetricsEnumerate() calls for each metric.
+ *
+ * @param[in] pMetric  the metric, which may be read with pUMetricsName(),
+ *                     uMetricsValue() etc. but must not be deregistered
+ *                     from within this function.
+ * @param[in] pParam   the parameter given to uMetricsEnumerate().
+ * @return             true to continue the enumeration, false to stop.
+ */
+typedef bool (*uMetricsCallback_t)(const uMetric_t *pMetric, void *pParam);
+
+/** The function that the task started by uMetricsExportStart()
+ * calls with the metrics.
+ *
+ * @param[in] pJson    the metrics as JSON, see uMetricsToJson(),
+ *                     null-terminated.
+ * @param length       the length of the string at pJson, not
+ *                     including the terminator.
+ * @param[in] pParam   the parameter given to uMetricsExportStart().
+ */
+typedef void (*uMetricsExport_t)(const char *pJson, size_t length,
+                                 void *pParam);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: SETTING UP
+ * -------------------------------------------------------------- */
+
+/** Set up a counter, starting at zero; this must be done once,
+ * before the metric is registered.
+ *
+ * @param[out] pMetric  the metric, cannot be NULL.
+ * @param[in] pName     the name of the metric, e.g. "sock.bytes_sent";
+ *                      the string is not copied and so must remain
+ *                      valid while the metric is registered.
+ */
+void uMetricsCounterInit(uMetric_t *pMetric, const char *pName);
+
+/** Set up a gauge, starting at zero; this must be done once, before
+ * the metric is registered.
+ *
+ * @param[out] pMetric     the metric, cannot be NULL.
+ * @param[in] pName        the name of the metric; the string is not
+ *                         copied and so must remain valid while the
+ *                         metric is registered.
+ * @param pRead            if non-NULL, the function that is called to
+ *                         obtain the value of the gauge whenever it is
+ *                         read, in which case uMetricsGaugeSet() has no
+ *                         effect; use NULL for a gauge that is set
+ *                         with uMetricsGaugeSet().
+ * @param[in] pReadParam   a parameter that will be passed to pRead.
+ */
+void uMetricsGaugeInit(uMetric_t *pMetric, const char *pName,
+                       uMetricsRead_t pRead, void *pReadParam);
+
+/** Set up a histogram, all counts starting at zero; this must be
+ * done once, before the metric is registered.  A value goes into
+ * the first bin for which it is less than or equal to the limit,
+ * or into the last bin if it is larger than all of the limits.
+ *
+ * @param[out] pMetric    the metric, cannot be NULL.
+ * @param[in] pName       the name of the metric; the string is not
+ *                        copied and so must remain valid while the
+ *                        metric is registered.
+ * @param[in] pBinLimit   the upper limit of each bin but the last, in
+ *                        ascending order, numBins - 1 entries; not
+ *                        copied, so must remain valid while the metric
+ *                        is registered.
+ * @param[out] pBinCount  storage for the counts, numBins entries.
+ * @param numBins         the number of bins, at least one.
+ */
+void uMetricsHistogramInit(uMetric_t *pMetric, const char *pName,
+                           const int32_t *pBinLimit,
+                           uint32_t *pBinCount, size_t numBins);
+
+/** Register a metric, making it visible to uMetricsEnumerate() and
+ * uMetricsFind(); if it is already registered this does nothing
+ * and returns success.  A metric is updated whether it is registered
+ * or not.
+ *
+ * @param[in] pMetric  the metric, set up with uMetricsCounterInit(),
+ *                     uMetricsGaugeInit() or uMetricsHistogramInit().
+ * @return             zero on success else negative error code.
+ */
+int32_t uMetricsRegister(uMetric_t *pMetric);
+
+/** Deregister a metric; if it is not registered this does nothing.
+ * Once this returns the memory of the metric may be released.
+ *
+ * @param[in] pMetric  the metric.
+ */
+void uMetricsDeregister(uMetric_t *pMetric);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: UPDATING
+ * -------------------------------------------------------------- */
+
+/** Add to a counter; may be called from an interrupt.
+ *
+ * @param[in] pMetric  the metric, which must be a counter.
+ * @param amount       the amount to add.
+ */
+void uMetricsCounterAdd(uMetric_t *pMetric, uint32_t amount);
+
+/** Set the value of a gauge that has no read function; may be
+ * called from an interrupt.
+ *
+ * @param[in] pMetric  the metric, which must be a gauge.
+ * @param value        the value.
+ */
+void uMetricsGaugeSet(uMetric_t *pMetric, int32_t value);
+
+/** Add a value to a histogram; may be called from an interrupt.
+ *
+ * @param[in] pMetric  the metric, which must be a histogram.
+ * @param value        the value.
+ */
+void uMetricsHistogramAdd(uMetric_t *pMetric, int32_t value);
+
+/** Set a counter, gauge or histogram back to zero.
+ *
+ * @param[in] pMetric  the metric.
+ */
+void uMetricsReset(uMetric_t *pMetric);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: READING
+ * -------------------------------------------------------------- */
+
+/** Call a function for each registered metric, in the order in
+ * which they were registered; registration and deregistration
+ * will wait until this returns.
+ *
+ * @param pCallback  the function to call, cannot be NULL.
+ * @param[in] pParam a parameter that will be passed to pCallback.
+ * @return           the number of metrics for which pCallback was
+ *                   called, else negative error code.
+ */
+int32_t uMetricsEnumerate(uMetricsCallback_t pCallback, void *pParam);
+
+/** Find a registered metric by name.
+ *
+ * @param[in] pName the name of the metric.
+ * @return          the metric, NULL if there is no registered
+ *                  metric of that name.
+ */
+const uMetric_t *pUMetricsFind(const char *pName);
+
+/** Get the name of a metric.
+ *
+ * @param[in] pMetric  the metric.
+ * @return             the name of the metric.
+ */
+const char *pUMetricsName(const uMetric_t *pMetric);
+
+/** Get the type of a metric.
+ *
+ * @param[in] pMetric  the metric.
+ * @return             the type of the metric.
+ */
+uMetricsType_t uMetricsType(const uMetric_t *pMetric);
+
+/** Get the value of a metric: for a counter its count, for a gauge
+ * its value, calling its read function if it has one, for a
+ * histogram the total of all of the values that have been added
+ * to it.
+ *
+ * @param[in] pMetric  the metric.
+ * @return             the value of the metric.
+ */
+int32_t uMetricsValue(const uMetric_t *pMetric);
+
+/** Get the number of bins of a histogram.
+ *
+ * @param[in] pMetric  the metric.
+ * @return             the number of bins, zero if the metric is not
+ *                     a histogram.
+ */
+size_t uMetricsHistogramNumBins(const uMetric_t *pMetric);
+
+/** Get the count in a bin of a histogram.
+ *
+ * @param[in] pMetric  the metric.
+ * @param bin          the bin, counting from zero.
+ * @return             the count in the bin, zero if the metric is
+ *                     not a histogram or bin is out of range.
+ */
+uint32_t uMetricsHistogramBinCount(const uMetric_t *pMetric, size_t bin);
+
+/** Format all of the registered metrics as a JSON object, for
+ * example:
+ *
+ * `{"sock.bytes_sent":1024,"sock.write_ms":{"sum":530,"bins":[3,12,1]}}`
+ *
+ * ...where a counter or a gauge is a number and a histogram is an
+ * object giving the total of the values added and the count in
+ * each bin.  Metrics that do not fit are left out, the JSON always
+ * being complete and null-terminated.
+ *
+ * @param[out] pBuffer  the buffer to write to, cannot be NULL.
+ * @param size          the size of pBuffer, including room for the
+ *                      terminator.
+ * @return              the length of the string written, not including
+ *                      the terminator, else negative error code.
+ */
+int32_t uMetricsToJson(char *pBuffer, size_t size);
+
+/** Print all of the registered metrics with uPortLog().
+ */
+void uMetricsPrint(void);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: EXPORT
+ * -------------------------------------------------------------- */
+
+/** Start exporting the metrics: a task is started which, every
+ * periodMs, formats the registered metrics with uMetricsToJson()
+ * into a buffer of #U_METRICS_EXPORT_BUFFER_LENGTH_BYTES and calls
+ * pExport with the result.  Only one export may run at a time;
+ * if one is already running it is stopped first.  uPortInit()
+ * must have been called.
+ *
+ * @param periodMs       the export period in milliseconds.
+ * @param pExport        the export function, cannot be NULL.
+ * @param[in] pParam     a parameter that will be passed to pExport.
+ * @return               zero on success else negative error code.
+ */
+int32_t uMetricsExportStart(int32_t periodMs, uMetricsExport_t pExport,
+                            void *pParam);
+
+/** Stop exporting the metrics; once this returns pExport will not
+ * be called again.
+ */
+void uMetricsExportStop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_METRICS_H_
+
+// End of file
@@ -29,7 +29,10 @@
 /** @file
  * @brief Ring buffer wrapper API for linear buffer.
  * All functions except uRingBufferCreate() and uRingBufferDelete()
- * are thread-safe.
+ * are thread-safe.  A ring buffer created with
+ * uRingBufferCreateLockFree() has no mutex: it may be shared between
+ * exactly one producer, which may be an interrupt, and exactly one
+ * consumer, see the "lock-free" section below.
  */
 
 #ifdef __cplusplus
@@ -40,10 +43,49 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS
+/** The number of bins in the occupancy histogram of a ring buffer,
+ * see uRingBufferStatOccupancy(); bin n counts the adds after which
+ * the ring buffer was between n and n + 1 bin-widths full, a bin being
+ * the size of the ring buffer divided by this number.
+ */
+# define U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS 8
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+typedef void *uParseHandle_t; //!< Parser handle.
+
+/** Parser function prototype, used with uRingBufferParseHandle()
+ * and uRingBufferParserRegister().
+ *
+ * @param parseHandle     the parser handle used to access the ring buffer.
+ * @param[in] pUserParam  a user parameter, passed in via uRingBufferParseHandle().
+ * @return                #U_ERROR_COMMON_TIMEOUT if more data is needed to
+ *                        conclude (see also uRingBufferParseNeedBytesUnprotected()),
+ *                        #U_ERROR_COMMON_NOT_FOUND if nothing found or
+ *                        #U_ERROR_COMMON_SUCCESS if sucessful.
+ */
+typedef int32_t (*U_RING_BUFFER_PARSER_f)(uParseHandle_t parseHandle, void *pUserParam);
+
+/** The parsers registered for a read handle and the state that lets
+ * uRingBufferParseRegistered() resume, see uRingBufferParserRegister();
+ * internal, not to be accessed directly.
+ */
+typedef struct {
+    U_RING_BUFFER_PARSER_f *pParserList; /**< NULL if none are registered. */
+    const char *pResumeFrom;             /**< the read position at which the
+                                              parsers last needed more data,
+                                              NULL if they did not. */
+    size_t resumeReadLossBytes;          /**< the read loss of the handle at
+                                              that time. */
+    size_t bytesNeeded;                  /**< the number of bytes that must be
+                                              available at pResumeFrom before
+                                              it is worth parsing again. */
+} uRingBufferParserState_t;
+
 /** Structure that defines a ring buffer; note that the contents
  * of this structure are internal, subject to change, please use
  * the access functions of this API to get to them, rather than
@@ -99,19 +141,37 @@ typedef struct {
                                          as a result of add or forced add
                                          being unable to write into the
                                          ring buffer. */
+    size_t statHighWaterMarkBytes;  /**< the most data there has been in the
+                                         ring buffer for the read pointer
+                                         furthest behind, sampled on add. */
+    size_t *statHighWaterMarkHandleBytes; /**< as statHighWaterMarkBytes but
+                                               for each read handle, allocated
+                                               alongside statReadLossBytes;
+                                               the zeroth entry is unused. */
+    size_t statForcedAddEvictions;  /**< the number of forced adds that
+                                         pushed data out from under a read
+                                         pointer. */
+    size_t statOccupancy[U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS]; /**< the
+                                         occupancy histogram, see
+                                         uRingBufferStatOccupancy(). */
+    bool lockFree;                  /**< true if the ring buffer was created
+                                         with uRingBufferCreateLockFree(), in
+                                         which case mutex is NULL, pDataWrite
+                                         is only written by the producer and
+                                         pDataReadNormal is only written by
+                                         the consumer. */
+    uRingBufferParserState_t *pParserState; /**< per read handle, malloc()ed
+                                                 by the first call to
+                                                 uRingBufferParserRegister(). */
 } uRingBuffer_t;
 
-typedef void *uParseHandle_t; //!< Parser handle.
-
-/** Parser function prototype, used with uRingBufferParseHandle().
- *
- * @param parseHandle     the parser handle used to access the ring buffer.
- * @param[in] pUserParam  a user parameter, passed in via uRingBufferParseHandle().
- * @return                #U_ERROR_COMMON_TIMEOUT if more data is needed to
- *                        conclude, #U_ERROR_COMMON_NOT_FOUND if nothing found or
- *                        #U_ERROR_COMMON_SUCCESS if sucessful.
+/** A span of data in place in a ring buffer, see uRingBufferPeekSpans().
  */
-typedef int32_t (*U_RING_BUFFER_PARSER_f)(uParseHandle_t parseHandle, void *pUserParam);
+typedef struct {
+    const char *pData; /**< the start of the span, NULL if it is empty. */
+    size_t length;     /**< the number of bytes at pData. */
+} uRingBufferSpan_t;
+
 
 /* ----------------------------------------------------------------
  * VARIABLES
@@ -257,6 +317,94 @@ size_t uRingBufferStatReadLoss(uRingBuffer_t *pRingBuffer);
  */
 size_t uRingBufferStatAddLoss(uRingBuffer_t *pRingBuffer);
 
+/** Get the largest amount of data there has been in the ring buffer,
+ * as seen by whichever read pointer (the "normal" one or a read handle)
+ * was furthest behind, sampled each time data is added; if this is
+ * close to the size of the ring buffer then data is likely being, or
+ * about to be, lost.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @return                the high water mark in bytes.
+ */
+size_t uRingBufferStatHighWaterMark(uRingBuffer_t *pRingBuffer);
+
+/** Get the number of times that uRingBufferForceAdd() has pushed data
+ * out from under a read pointer (the bytes themselves are counted by
+ * uRingBufferStatReadLoss() and uRingBufferStatReadLossHandle()).
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @return                the number of forced adds that evicted data.
+ */
+size_t uRingBufferStatForcedAddEvictions(uRingBuffer_t *pRingBuffer);
+
+/** Get the occupancy histogram of the ring buffer: each time data is
+ * successfully added the amount of data then in the ring buffer, as
+ * for uRingBufferStatHighWaterMark(), is sampled and the count in
+ * the corresponding one of #U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS bins
+ * is incremented, bin zero being nearly empty and the last bin nearly
+ * full.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param[out] pBins      a place to put the counts, cannot be NULL.
+ * @param numBins         the number of entries at pBins; if this is
+ *                        more than #U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS
+ *                        the extra entries are set to zero.
+ * @return                the number of bins of the histogram written
+ *                        to pBins.
+ */
+size_t uRingBufferStatOccupancy(uRingBuffer_t *pRingBuffer, size_t *pBins,
+                                size_t numBins);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: LOCK-FREE
+ * -------------------------------------------------------------- */
+
+/** Create a new ring buffer from a linear buffer that has no mutex,
+ * for a single producer, which may be an interrupt, e.g. a UART
+ * receive interrupt or a DMA-complete handler, and a single consumer,
+ * e.g. the task that parses the data.  The producer calls
+ * uRingBufferAddIrq() (or uRingBufferAdd()), the consumer calls
+ * uRingBufferRead(), uRingBufferPeek() and uRingBufferFlush();
+ * uRingBufferDataSize(), uRingBufferAvailableSize() and the stats
+ * functions may be called from either side.  uRingBufferForceAdd()
+ * behaves as uRingBufferAdd() since the producer cannot move the
+ * consumer's read pointer, uRingBufferReset() must only be called
+ * when neither side is active and the "read handle" functions
+ * are not supported.
+ *
+ * The producer only ever writes the write pointer and the consumer
+ * only ever writes the read pointer, each after a memory barrier
+ * (see #U_MEMORY_BARRIER) so that the data is in place before the
+ * pointer which covers it moves; this relies on a pointer being
+ * written to memory in a single access, which is the case on all
+ * of the supported platforms.
+ *
+ * @param[in] pRingBuffer   a pointer to a ring buffer, cannot be NULL.
+ * @param[in] pLinearBuffer a pointer to the linear buffer.
+ * @param size              the size of the linear buffer in bytes; the
+ *                          ring buffer will be of maximum size this
+ *                          number minus one as one byte is used to
+ *                          prevent pointer-wrap.
+ * @return                  zero on success else negative error code.
+ */
+int32_t uRingBufferCreateLockFree(uRingBuffer_t *pRingBuffer,
+                                  char *pLinearBuffer, size_t size);
+
+/** Add data to a ring buffer created with uRingBufferCreateLockFree();
+ * no mutex is taken and nothing is called which might block, hence
+ * this may be called from an interrupt.  The data is added all or
+ * nothing.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param[in] pData         pointer to the data.
+ * @param length            the length of the data.
+ * @return                  true if the data was added, false if there
+ *                          is not room enough or the ring buffer was
+ *                          not created with uRingBufferCreateLockFree().
+ */
+bool uRingBufferAddIrq(uRingBuffer_t *pRingBuffer, const char *pData,
+                       size_t length);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MULTIPLE READERS
  * -------------------------------------------------------------- */
@@ -395,6 +543,31 @@ size_t uRingBufferReadHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
 size_t uRingBufferPeekHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
                              char *pData, size_t length, size_t offset);
 
+/** Like uRingBufferPeekHandle() but, rather than copying the data,
+ * returns a pointer to it in place in the ring buffer; since the
+ * data may wrap around the end of the ring buffer only the part up
+ * to the wrap is made available, uRingBufferPeekHandle() must be used
+ * for the rest.  The pointer is only useful for as long as the data
+ * cannot be overwritten, i.e. while the read handle is locked (see
+ * uRingBufferLockReadHandle()) and nothing is read from the handle.
+ * To use this function the ring buffer must have been created by
+ * calling uRingBufferCreateWithReadHandle() rather than
+ * uRingBufferCreate().
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param handle            a read handle, as originally  returned by
+ *                          uRingBufferTakeReadHandle().
+ * @param[out] ppData       a place to put the pointer to the data;
+ *                          cannot be NULL.
+ * @param offset            the offset from the read pointer at which
+ *                          the data should begin.
+ * @return                  the number of contiguous bytes at *ppData.
+ */
+size_t uRingBufferPeekContiguousHandle(uRingBuffer_t *pRingBuffer,
+                                       int32_t handle,
+                                       const char **ppData,
+                                       size_t offset);
+
 /** Like uRingBufferDataSize() except for use by an entity that has
  * previously obtained a read handle by calling uRingBufferTakeReadHandle();
  * this mechanism should be employed if there is to be more than one consumer
@@ -441,6 +614,129 @@ void uRingBufferFlushHandle(uRingBuffer_t *pRingBuffer, int32_t handle);
 size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
                                      int32_t handle);
 
+/** Get the largest amount of data there has been waiting for the
+ * given read handle since it was taken, sampled each time data is
+ * added.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle, as originally returned by
+ *                        uRingBufferTakeReadHandle().
+ * @return                the high water mark in bytes.
+ */
+size_t uRingBufferStatHighWaterMarkHandle(uRingBuffer_t *pRingBuffer,
+                                          int32_t handle);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: ZERO-COPY
+ * -------------------------------------------------------------- */
+
+/** Get the data of uRingBufferRead() in place, without copying it:
+ * since the data may wrap around the end of the ring buffer it is
+ * given as up to two spans, the second one being empty unless the
+ * data wraps, their lengths adding up to what uRingBufferDataSize()
+ * would return.  The read pointer is not moved: once you are done
+ * with some or all of the data call uRingBufferReadCommit().  The
+ * spans remain valid until then provided nothing else reads from
+ * the ring buffer and uRingBufferForceAdd() is not used on it.
+ * If uRingBufferSetReadRequiresHandle() is true this will return
+ * zero.  May be used on a ring buffer created with
+ * uRingBufferCreateLockFree(), by the consumer.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param[out] pSpans       a pointer to an array of TWO spans; cannot
+ *                          be NULL.
+ * @return                  the total number of bytes in the spans.
+ */
+size_t uRingBufferPeekSpans(uRingBuffer_t *pRingBuffer, uRingBufferSpan_t *pSpans);
+
+/** Move the read pointer of uRingBufferRead() on, i.e. consume data
+ * that was looked at with uRingBufferPeekSpans().
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param length            the number of bytes to consume.
+ * @return                  the number of bytes consumed, which will be
+ *                          less than length if there were not length
+ *                          bytes in the ring buffer.
+ */
+size_t uRingBufferReadCommit(uRingBuffer_t *pRingBuffer, size_t length);
+
+/** As uRingBufferPeekSpans() but for a read handle; the spans remain
+ * valid until uRingBufferReadCommitHandle() is called provided that the
+ * read handle is locked (see uRingBufferLockReadHandle()) or that
+ * uRingBufferForceAdd() is not used on the ring buffer.  To use this
+ * function the ring buffer must have been created by calling
+ * uRingBufferCreateWithReadHandle().
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param handle            a read handle, as originally returned by
+ *                          uRingBufferTakeReadHandle().
+ * @param[out] pSpans       a pointer to an array of TWO spans; cannot
+ *                          be NULL.
+ * @return                  the total number of bytes in the spans.
+ */
+size_t uRingBufferPeekSpansHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  uRingBufferSpan_t *pSpans);
+
+/** As uRingBufferReadCommit() but for a read handle.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param handle            a read handle, as originally returned by
+ *                          uRingBufferTakeReadHandle().
+ * @param length            the number of bytes to consume.
+ * @return                  the number of bytes consumed.
+ */
+size_t uRingBufferReadCommitHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                   size_t length);
+
+/** Reserve space in a ring buffer to write data into directly,
+ * e.g. from a UART driver or a DMA transfer, rather than via
+ * a temporary buffer and uRingBufferAdd().  The space is contiguous,
+ * hence it ends at the end of the linear buffer: if more is needed,
+ * commit what has been written and reserve again.  Only as much is
+ * reserved as uRingBufferAdd() would be able to store.  Nothing is
+ * readable until uRingBufferWriteCommit() is called; there can be
+ * only one reservation outstanding and nothing else must add to
+ * the ring buffer until it has been committed.  May be used on a
+ * ring buffer created with uRingBufferCreateLockFree(), by the
+ * producer, from an interrupt if required.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param[out] ppData       a place to put the pointer to the reserved
+ *                          space; cannot be NULL.
+ * @param length            the maximum number of bytes to reserve.
+ * @return                  the number of bytes reserved at *ppData,
+ *                          which may be zero.
+ */
+size_t uRingBufferWriteReserve(uRingBuffer_t *pRingBuffer, char **ppData,
+                               size_t length);
+
+/** As uRingBufferWriteReserve() but makes room as uRingBufferForceAdd()
+ * would, i.e. moving any [non-locked] read pointers on, losing data
+ * from under them, at the time of the reservation.  On a ring buffer
+ * created with uRingBufferCreateLockFree() this behaves as
+ * uRingBufferWriteReserve().
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param[out] ppData       a place to put the pointer to the reserved
+ *                          space; cannot be NULL.
+ * @param length            the maximum number of bytes to reserve.
+ * @return                  the number of bytes reserved at *ppData,
+ *                          which may be zero.
+ */
+size_t uRingBufferForceWriteReserve(uRingBuffer_t *pRingBuffer, char **ppData,
+                                    size_t length);
+
+/** Make data written into space reserved with uRingBufferWriteReserve()
+ * or uRingBufferForceWriteReserve() readable.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param length            the number of bytes written, no more than
+ *                          were reserved; may be zero to drop the
+ *                          reservation.
+ * @return                  true if the data was committed.
+ */
+bool uRingBufferWriteCommit(uRingBuffer_t *pRingBuffer, size_t length);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: PARSER
  * -------------------------------------------------------------- */
@@ -459,6 +755,68 @@ size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
 size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
                               U_RING_BUFFER_PARSER_f *pParserList, void *pUserParam);
 
+/** Register a list of parsers for a read handle, for use with
+ * uRingBufferParseRegistered(), which keeps, for the handle, the
+ * "need more data" result of the parsers: if the data at the read
+ * position is the start of a message that has not yet arrived in
+ * full the parsers are not run again until enough data has arrived
+ * to complete it, rather than re-parsing the partial message every
+ * time more data is added; this matters for large messages arriving
+ * slowly.  A parser says how much more it needs by calling
+ * uRingBufferParseNeedBytesUnprotected() before returning
+ * #U_ERROR_COMMON_TIMEOUT; if it does not, the parsers are run again
+ * as soon as any more data arrives.  Registering the same list
+ * again is harmless and keeps the resume state, registering a
+ * different list drops it.  The registration is removed when the
+ * handle is given back.  The ring buffer must have been created
+ * with uRingBufferCreateWithReadHandle(); the first call with a given
+ * ring buffer allocates memory, which is freed by uRingBufferDelete().
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle, as originally returned by
+ *                        uRingBufferTakeReadHandle().
+ * @param[in] pParserList a pointer to a list of parsers, terminated by
+ *                        a NULL pointer, which must remain valid while
+ *                        it is registered; use NULL to remove a
+ *                        registration.
+ * @return                zero on success else negative error code.
+ */
+int32_t uRingBufferParserRegister(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  U_RING_BUFFER_PARSER_f *pParserList);
+
+/** As uRingBufferParseHandle() but using the parsers registered for
+ * the read handle with uRingBufferParserRegister() and, if those
+ * parsers last needed more data at the current read position and not
+ * enough has yet arrived, returning #U_ERROR_COMMON_TIMEOUT without
+ * running them.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle with parsers registered.
+ * @param[in] pUserParam  a user parameter to pass to each parser.
+ * @return                as uRingBufferParseHandle();
+ *                        #U_ERROR_COMMON_INVALID_PARAMETER if no parsers
+ *                        are registered for the handle.
+ */
+size_t uRingBufferParseRegistered(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  void *pUserParam);
+
+/** Say how many more bytes a parser needs, to be called from within
+ * a U_RING_BUFFER_PARSER_f function just before it returns
+ * #U_ERROR_COMMON_TIMEOUT, e.g. once it has read the length field of a
+ * message; only has an effect when the parser is called by
+ * uRingBufferParseRegistered().
+ *
+ * IMPORTANT: unlike all of the other ring-buffer functions, this function
+ * is NOT thread-safe, it is ONLY intended to be used from within a
+ * U_RING_BUFFER_PARSER_f function.
+ *
+ * @param parseHandle     the parser handle used to access the ring buffer.
+ * @param moreBytes       the number of bytes needed beyond those the parser
+ *                        has already taken from the ring buffer.
+ */
+void uRingBufferParseNeedBytesUnprotected(uParseHandle_t parseHandle,
+                                          size_t moreBytes);
+
 /** Get a byte from the ring buffer while in a parser function.
  *
  * IMPORTANT: unlike all of the other ring-buffer functions, this function
@@ -472,6 +830,27 @@ size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
  */
 bool uRingBufferGetByteUnprotected(uParseHandle_t parseHandle, void *p);
 
+/** Get a pointer to the next bytes in the ring buffer while in a
+ * parser function, without copying them; since the bytes in a ring
+ * buffer may wrap, fewer bytes than asked for may be returned even
+ * though more are available, in which case call this function again
+ * for the remainder.
+ *
+ * IMPORTANT: unlike all of the other ring-buffer functions, this function
+ * is NOT thread-safe, it is ONLY intended to be used from within a
+ * U_RING_BUFFER_PARSER_f function that will be called by uRingBufferParseHandle()
+ * (which adds thread-safety).
+ *
+ * @param parseHandle     the parser handle used to access the ring buffer.
+ * @param[out] ppData     a place to put the pointer to the bytes; cannot
+ *                        be NULL.
+ * @param size            the maximum number of bytes wanted.
+ * @return                the number of bytes at *ppData, which have been
+ *                        consumed.
+ */
+size_t uRingBufferGetBytesUnprotected(uParseHandle_t parseHandle,
+                                      const char **ppData, size_t size);
+
 /** Number of bytes in the ring buffer while in a parser function.
  *
  * IMPORTANT: unlike all of the other ring-buffer functions, this function
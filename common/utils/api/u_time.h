@@ -43,6 +43,20 @@ extern "C" {
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A broken-down UTC date and time, see uTimeToSecondsUtc() and
+ * uTimeFromSecondsUtc().  Unlike struct tm the month and the day
+ * both count from one and the year is the year itself, i.e. as they
+ * arrive from a GNSS chip or a cellular module.
+ */
+typedef struct {
+    int32_t year;   /**< the year, e.g. 2023. */
+    int32_t month;  /**< the month, 1 to 12. */
+    int32_t day;    /**< the day of the month, 1 to 31. */
+    int32_t hour;   /**< the hour, 0 to 23. */
+    int32_t minute; /**< the minute, 0 to 59. */
+    int32_t second; /**< the second, 0 to 60 (a leap second). */
+} uTimeDateTime_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -51,8 +65,8 @@ extern "C" {
  * FUNCTIONS
  * -------------------------------------------------------------- */
 
-/** Check if the given year is a leap year.  Not a UTC thing; any
- * year will work.
+/** Check if the given year is a leap year, according to the
+ * Gregorian calendar.  Not a UTC thing; any year will work.
  *
  * @param year the year.
  * @return     true if the year is a leap year, else false.
@@ -63,7 +77,8 @@ bool uTimeIsLeapYear(int32_t year);
  * the given number of UTC months, months since the
  * start of 1970 (counting from zero), taking into account
  * leap years.  Useful when converting a day/month/year count
- * into a UTC time.
+ * into a UTC time, though uTimeToSecondsUtc() does the
+ * whole job.
  *
  * @param monthsUtc the number of months since the start of
  *                  1970, counting from zero.
@@ -72,6 +87,42 @@ bool uTimeIsLeapYear(int32_t year);
  */
 int64_t uTimeMonthsToSecondsUtc(int32_t monthsUtc);
 
+/** Return the number of days from the start of 1970 to the given
+ * date; the calculation takes constant time and the start of the most
+ * recently converted month is cached, so converting dates in the same
+ * month as the last costs just an add.
+ *
+ * @param year  the year, e.g. 2023; may be before 1970, in which
+ *              case the answer is negative.
+ * @param month the month, 1 to 12; values outside this range are
+ *              taken to be in an earlier or later year, e.g. 13 is
+ *              January of the following year.
+ * @param day   the day of the month, 1 to 31.
+ * @return      the number of days since 1 January 1970.
+ */
+int32_t uTimeDaysFromDate(int32_t year, int32_t month, int32_t day);
+
+/** Convert a broken-down UTC date and time into seconds since
+ * the start of 1970, in constant time.  No check is made that the
+ * fields are in range, e.g. a second of 60 simply adds one more.
+ *
+ * @param[in] pDateTime the date and time; cannot be NULL.
+ * @return              the number of seconds since 1970.
+ */
+int64_t uTimeToSecondsUtc(const uTimeDateTime_t *pDateTime);
+
+/** Convert seconds since the start of 1970 into a broken-down UTC
+ * date and time, in constant time; as for uTimeDaysFromDate(), if
+ * the time is in the same month as the most recent conversion only
+ * a few adds are required.
+ *
+ * @param secondsUtc       the number of seconds since 1970, may be
+ *                         negative.
+ * @param[out] pDateTime   a place to put the date and time; cannot
+ *                         be NULL.
+ */
+void uTimeFromSecondsUtc(int64_t secondsUtc, uTimeDateTime_t *pDateTime);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_TIMER_WHEEL_H_
+#define _U_TIMER_WHEEL_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __utils
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a timer wheel: any number of
+ * software timers run from a single port timer, see uPortTimerCreate(),
+ * so that starting, stopping or restarting a timer costs a few pointer
+ * operations, with no allocation and no call into the OS.  The timers
+ * are held in a hierarchy of #U_TIMER_WHEEL_NUM_LEVELS wheels of
+ * 2 ^ #U_TIMER_WHEEL_LEVEL_BITS slots each, the finest of which moves
+ * on one slot every #U_TIMER_WHEEL_TICK_MS; all of the timers that
+ * expire within the same tick are handled together and the port timer
+ * only runs while there is a timer to run.
+ *
+ * The memory for a timer, #uTimerWheelTimer_t, belongs to the caller.
+ * A timer may have a callback, which is called in the context of the
+ * port timer callback, hence it must be short and must not block,
+ * or it may have no callback and be polled with uTimerWheelTimerExpired(),
+ * for instance in place of a loop comparing uPortGetTickTimeMs() against
+ * a start time.
+ *
+ * The API functions are thread-safe except for uTimerWheelInit() and
+ * uTimerWheelDeinit(), which should not be called while any of the
+ * other API calls are in progress; none may be called from an interrupt.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_TIMER_WHEEL_TICK_MS
+/** The resolution of the timer wheel: a timer expires on the first
+ * tick at or after its interval has elapsed, never before, and
+ * timers that expire within the same tick are handled together.
+ */
+# define U_TIMER_WHEEL_TICK_MS 10
+#endif
+
+#ifndef U_TIMER_WHEEL_LEVEL_BITS
+/** The number of slots in each level of the timer wheel as a power
+ * of two.
+ */
+# define U_TIMER_WHEEL_LEVEL_BITS 6
+#endif
+
+#ifndef U_TIMER_WHEEL_NUM_LEVELS
+/** The number of levels in the timer wheel; the longest interval
+ * is #U_TIMER_WHEEL_TICK_MS times two to the power of
+ * #U_TIMER_WHEEL_LEVEL_BITS times #U_TIMER_WHEEL_NUM_LEVELS, less
+ * one tick, about 46 hours with the defaults.
+ */
+# define U_TIMER_WHEEL_NUM_LEVELS 4
+#endif
+
+/** The longest interval that a timer may be started with.
+ */
+#define U_TIMER_WHEEL_INTERVAL_MAX_MS ((uint32_t) (((1ULL << (U_TIMER_WHEEL_LEVEL_BITS *           \
+                                                               U_TIMER_WHEEL_NUM_LEVELS)) - 1) * \
+                                                   U_TIMER_WHEEL_TICK_MS))
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+struct uTimerWheelTimer_t;
+
+/** The callback of a timer.
+ *
+ * @param[in] pTimer         the timer that has expired; the timer may
+ *                           be started again from within the callback.
+ * @param[in] pCallbackParam the parameter given to uTimerWheelTimerInit().
+ */
+typedef void (*uTimerWheelCallback_t)(struct uTimerWheelTimer_t *pTimer,
+                                      void *pCallbackParam);
+
+/** A timer; the fields are private to the timer wheel, use
+ * uTimerWheelTimerInit() to set it up.
+ */
+typedef struct uTimerWheelTimer_t {
+    struct uTimerWheelTimer_t *pNext;   /**< the next timer in the same slot. */
+    struct uTimerWheelTimer_t **ppPrev; /**< the pointer to this timer in
+                                             its slot, NULL if not running. */
+    uint32_t expiryTick;                /**< the tick on which the timer expires. */
+    uint32_t periodTicks;               /**< the period of a periodic timer,
+                                             zero for a one-shot timer. */
+    uTimerWheelCallback_t pCallback;    /**< the callback, may be NULL. */
+    void *pCallbackParam;               /**< the parameter for pCallback. */
+    volatile bool expired;              /**< see uTimerWheelTimerExpired(). */
+} uTimerWheelTimer_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Initialise the timer wheel, creating its port timer; uPortInit()
+ * must have been called.  If the timer wheel is already initialised
+ * this does nothing and returns success.
+ *
+ * @return  zero on success else negative error code.
+ */
+int32_t uTimerWheelInit(void);
+
+/** Deinitialise the timer wheel: all timers are stopped, their
+ * callbacks not being called, and the port timer is deleted.
+ */
+void uTimerWheelDeinit(void);
+
+/** Set up a timer; this must be done once, before the timer is
+ * first started, and must not be done while the timer is running.
+ *
+ * @param[out] pTimer        the timer, cannot be NULL.
+ * @param pCallback          the callback to be called when the timer
+ *                           expires, may be NULL if the timer is to
+ *                           be polled with uTimerWheelTimerExpired().
+ * @param[in] pCallbackParam a parameter that will be passed to
+ *                           pCallback, may be NULL.
+ */
+void uTimerWheelTimerInit(uTimerWheelTimer_t *pTimer,
+                          uTimerWheelCallback_t pCallback,
+                          void *pCallbackParam);
+
+/** Start a timer; if the timer is already running it is restarted
+ * with the new interval.
+ *
+ * @param[in] pTimer  the timer, set up with uTimerWheelTimerInit().
+ * @param intervalMs  the interval, up to #U_TIMER_WHEEL_INTERVAL_MAX_MS;
+ *                    the timer will expire the first tick, see
+ *                    #U_TIMER_WHEEL_TICK_MS, at or after this time.
+ * @param periodic    true if the timer should, having expired, restart
+ *                    with the same interval, counted from when it
+ *                    should have expired so that it does not drift.
+ * @return            zero on success else negative error code.
+ */
+int32_t uTimerWheelTimerStart(uTimerWheelTimer_t *pTimer,
+                              uint32_t intervalMs, bool periodic);
+
+/** Stop a timer; if the timer is not running this does nothing.  The
+ * callback of the timer may still be called if it is about to be
+ * called, or is being called, in the context of the port timer.
+ *
+ * @param[in] pTimer  the timer.
+ */
+void uTimerWheelTimerStop(uTimerWheelTimer_t *pTimer);
+
+/** Determine whether a timer is running.
+ *
+ * @param[in] pTimer  the timer.
+ * @return            true if the timer is running, else false.
+ */
+bool uTimerWheelTimerIsRunning(const uTimerWheelTimer_t *pTimer);
+
+/** Determine whether a timer has expired since it was last started;
+ * for a periodic timer this is true once it has first expired.
+ *
+ * @param[in] pTimer  the timer.
+ * @return            true if the timer has expired, else false.
+ */
+bool uTimerWheelTimerExpired(const uTimerWheelTimer_t *pTimer);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_TIMER_WHEEL_H_
+
+// End of file
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_TRACE_H_
+#define _U_TRACE_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "stddef.h"
+#include "stdint.h"
+#include "stdbool.h"
+
+/** \addtogroup __utils
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a binary trace: a fixed-size,
+ * statically allocated, circular store of #U_TRACE_NUM_ENTRIES
+ * entries, each a millisecond time-stamp, an event and a 32-bit
+ * parameter, into which any task, or an interrupt, may write with
+ * uTrace() at the cost of a compare-and-swap and three stores; no
+ * mutex is taken, no memory is allocated and no initialisation is
+ * required, so tracing is always on.  Once the store is full the
+ * oldest entries are overwritten.
+ *
+ * The trace points in the core ubxlib code (AT client, sockets,
+ * GNSS streaming and EDM) use the U_TRACE() macro, which compiles
+ * to nothing unless U_CFG_TRACE is defined.
+ *
+ * The contents of the store may be written out in binary form with
+ * uTraceDump(), e.g. to a UART with uTraceDumpUart(), or printed
+ * with uTracePrint(); neither disturbs tracing.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_TRACE_NUM_ENTRIES
+/** The number of entries in the trace store; MUST be a power of
+ * two.  Each entry occupies sizeof(#uTraceEntry_t), 12 bytes.
+ */
+# define U_TRACE_NUM_ENTRIES 256
+#endif
+
+/** The version of the binary format written by uTraceDump().
+ */
+#define U_TRACE_FORMAT_VERSION 1
+
+/** The magic number at the start of the output of uTraceDump(),
+ * "uTRC" when written out in little-endian form; if it is read
+ * back in the other order the dump came from a big-endian MCU.
+ */
+#define U_TRACE_DUMP_MAGIC 0x43525475
+
+#ifndef U_TRACE_EVENT_LIST_APP
+/** An application may add trace events of its own by defining
+ * this, e.g. with U_CFG_OVERRIDE, in the same form as
+ * #U_TRACE_EVENT_LIST, e.g.:
+ *
+ * `#define U_TRACE_EVENT_LIST_APP(X) X(MY_THING) X(MY_OTHER_THING)`
+ *
+ * ...giving the events U_TRACE_EVENT_MY_THING and
+ * U_TRACE_EVENT_MY_OTHER_THING.
+ */
+# define U_TRACE_EVENT_LIST_APP(X)
+#endif
+
+/** The trace events, from which both #uTraceEvent_t and the names
+ * printed by uTracePrint() are generated, so that the two cannot
+ * get out of step; add new events only at the end, before
+ * #U_TRACE_EVENT_LIST_APP, so that existing dumps can still be
+ * decoded.  The meaning of the parameter is given for each.
+ */
+#define U_TRACE_EVENT_LIST(X)                                          \
+    X(NONE)              /* An empty or overwritten entry. */          \
+    X(USER_0)            /* Free for temporary use. */                 \
+    X(USER_1)            /* Free for temporary use. */                 \
+    X(USER_2)            /* Free for temporary use. */                 \
+    X(USER_3)            /* Free for temporary use. */                 \
+    X(AT_COMMAND_START)  /* The AT client stream handle. */            \
+    X(AT_RESPONSE_START) /* The AT client stream handle. */            \
+    X(AT_RESPONSE_STOP)  /* The AT client error code. */               \
+    X(AT_ERROR)          /* The error code being set. */               \
+    X(AT_URC)            /* The time spent in the URC handler, ms. */  \
+    X(SOCK_SEND_TO)      /* The size sent or negative error code. */   \
+    X(SOCK_RECEIVE_FROM) /* The size received or error code. */        \
+    X(SOCK_WRITE)        /* The size written or error code. */         \
+    X(SOCK_READ)         /* The size read or error code. */            \
+    X(GNSS_STREAM_FILL)  /* The size read or error code. */            \
+    X(EDM_RX_EVENT)      /* The uShortRangeEdmEventType_t. */          \
+    X(EDM_TX)            /* The size written or error code. */         \
+    U_TRACE_EVENT_LIST_APP(X)
+
+#ifdef U_CFG_TRACE
+/** Add a trace point; this compiles to nothing unless U_CFG_TRACE
+ * is defined, in which case it calls uTrace().  Since the
+ * parameter is then not evaluated it must have no side effects.
+ *
+ * @param event     the event, without the U_TRACE_EVENT_ prefix,
+ *                  e.g. AT_COMMAND_START.
+ * @param parameter the parameter.
+ */
+# define U_TRACE(event, parameter) uTrace(U_TRACE_EVENT_##event, (int32_t) (parameter))
+#else
+# define U_TRACE(event, parameter)
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The trace events, see #U_TRACE_EVENT_LIST.
+ */
+typedef enum {
+#define U_TRACE_EVENT_ENUM(name) U_TRACE_EVENT_##name,
+    U_TRACE_EVENT_LIST(U_TRACE_EVENT_ENUM)
+#undef U_TRACE_EVENT_ENUM
+    U_TRACE_EVENT_MAX_NUM
+} uTraceEvent_t;
+
+/** An entry in the trace, as written by uTraceDump(), in the byte
+ * order of the MCU.
+ */
+typedef struct {
+    uint32_t tagAndEvent; /**< the event is in the lower 16 bits;
+                               the upper 16 bits are used internally
+                               to detect an entry that is being
+                               written and should be ignored. */
+    int32_t timeMs;       /**< the value of uPortGetTickTimeMs()
+                               when the entry was written. */
+    int32_t parameter;    /**< the parameter of the event. */
+} uTraceEntry_t;
+
+/** The header written by uTraceDump(), in the byte order of the
+ * MCU, followed by numEntries of #uTraceEntry_t, oldest first;
+ * an entry with the event #U_TRACE_EVENT_NONE should be ignored,
+ * it was overwritten or being written while the dump was made.
+ */
+typedef struct {
+    uint32_t magic;           /**< #U_TRACE_DUMP_MAGIC. */
+    uint16_t version;         /**< #U_TRACE_FORMAT_VERSION. */
+    uint16_t entrySizeBytes;  /**< sizeof(#uTraceEntry_t). */
+    uint32_t total;           /**< the number of entries written since
+                                   the trace began or was last cleared,
+                                   modulo 2^32; if this is more than
+                                   numEntries the rest were overwritten. */
+    uint32_t numEntries;      /**< the number of entries that follow. */
+} uTraceDumpHeader_t;
+
+/** The function that uTraceDump() calls to write its output.
+ *
+ * @param pParam  the parameter that was passed to uTraceDump().
+ * @param pData   the data to write.
+ * @param size    the number of bytes at pData.
+ * @return        zero on success else negative error code.
+ */
+typedef int32_t (*uTraceWrite_t)(void *pParam, const char *pData,
+                                 size_t size);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Add an entry to the trace; this may be called from any task at
+ * any time, or from an interrupt, and is lock-free.  Usually you
+ * would use the U_TRACE() macro rather than calling this directly.
+ *
+ * @param event     the event.
+ * @param parameter the parameter.
+ */
+void uTrace(uTraceEvent_t event, int32_t parameter);
+
+/** Switch tracing on or off; it is on from the start.
+ *
+ * @param onNotOff  true to switch tracing on, false to switch
+ *                  it off.
+ */
+void uTraceOn(bool onNotOff);
+
+/** Forget the entries in the trace so far; subsequent dumps will
+ * include only entries written after this call.
+ */
+void uTraceClear();
+
+/** Write the contents of the trace in binary form; see
+ * #uTraceDumpHeader_t for the format.  Tracing continues while
+ * the dump is made.
+ *
+ * @param pWrite       the function that writes the output, cannot
+ *                     be NULL; it is called several times and
+ *                     should not call uTrace() itself.
+ * @param pWriteParam  a parameter that will be passed to pWrite.
+ * @return             the number of entries written else negative
+ *                     error code, e.g. one returned by pWrite.
+ */
+int32_t uTraceDump(uTraceWrite_t pWrite, void *pWriteParam);
+
+/** Write the contents of the trace in binary form to a UART;
+ * a convenience wrapper for uTraceDump().
+ *
+ * @param uartHandle the handle of an open UART.
+ * @return           the number of entries written else negative
+ *                   error code.
+ */
+int32_t uTraceDumpUart(int32_t uartHandle);
+
+/** Get the name of an event, e.g. "AT_COMMAND_START".
+ *
+ * @param event the event.
+ * @return      the name of the event, "?" if it is out of range.
+ */
+const char *pUTraceEventName(uTraceEvent_t event);
+
+/** Print the contents of the trace with uPortLog().
+ */
+void uTracePrint();
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_TRACE_H_
+
+// End of file
@@ -21,7 +21,7 @@
  */
 
 /** @file
- * @brief functions to assist with time manipulation.
+ * @brief Implementation of base 64 encode and decode.
  */
 
 #ifdef U_CFG_OVERRIDE
@@ -30,6 +30,10 @@
 
 #include "stddef.h"    // size_t
 #include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_error_common.h"
 
 #include "u_base64.h"
 
@@ -43,6 +47,23 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The value in gBase64DecodeTable[] of a white space character.
+ */
+#define U_BASE64_DECODE_SPACE 0x40
+
+/** The value in gBase64DecodeTable[] of the padding character.
+ */
+#define U_BASE64_DECODE_PAD 0x41
+
+/** The value in gBase64DecodeTable[] of an invalid character.
+ */
+#define U_BASE64_DECODE_INVALID 0x80
+
+/** A mask which, applied to a value from gBase64DecodeTable[], is
+ * zero only for the six-bit value of a base 64 character.
+ */
+#define U_BASE64_DECODE_NOT_VALUE_MASK 0xC0
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -51,10 +72,75 @@
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
+/** Table to map a character to its six-bit base 64 value, or to
+ * #U_BASE64_DECODE_SPACE, #U_BASE64_DECODE_PAD or
+ * #U_BASE64_DECODE_INVALID.  Unlike unb64[] in base64.h, this tells
+ * an invalid character apart from 'A' so that the chunked decode can
+ * check what it is given.
+ */
+static const uint8_t gBase64DecodeTable[256] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x40, 0x40, 0x80, 0x80, 0x40, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x40, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3e, 0x80, 0x80, 0x80, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x80, 0x80, 0x80, 0x41, 0x80, 0x80,
+    0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+};
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Encode three bytes of binary data as four characters of base 64.
+static void encodeThree(const uint8_t *pBinary, char *pBase64)
+{
+    uint32_t value = (((uint32_t) pBinary[0]) << 16) |
+                     (((uint32_t) pBinary[1]) << 8) | pBinary[2];
+
+    pBase64[0] = b64[(value >> 18) & 0x3f];
+    pBase64[1] = b64[(value >> 12) & 0x3f];
+    pBase64[2] = b64[(value >> 6) & 0x3f];
+    pBase64[3] = b64[value & 0x3f];
+}
+
+// Write the three bytes of binary data represented by four six-bit
+// values.
+static void decodeFour(uint32_t bits, char *pBinary)
+{
+    pBinary[0] = (char) (bits >> 16);
+    pBinary[1] = (char) (bits >> 8);
+    pBinary[2] = (char) bits;
+}
+
+// Write the bytes of binary data represented by the two or three
+// six-bit values of an incomplete group of four; returns the number
+// of bytes written.
+static size_t decodePartial(uint32_t bits, size_t numValues, char *pBinary)
+{
+    size_t length = 0;
+
+    if (numValues == 2) {
+        pBinary[0] = (char) (bits >> 4);
+        length = 1;
+    } else if (numValues == 3) {
+        pBinary[0] = (char) (bits >> 10);
+        pBinary[1] = (char) (bits >> 2);
+        length = 2;
+    }
+
+    return length;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -101,4 +187,210 @@ int32_t uBase64Decode(const char *pBase64, size_t base64LengthBytes,
     return bytesDecoded;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: CHUNKED
+ * -------------------------------------------------------------- */
+
+// Start a chunked base 64 encode.
+void uBase64EncodeStart(uBase64EncodeContext_t *pContext)
+{
+    if (pContext != NULL) {
+        memset(pContext, 0, sizeof(*pContext));
+    }
+}
+
+// Base 64 encode a chunk.
+int32_t uBase64EncodeChunk(uBase64EncodeContext_t *pContext,
+                           const char *pBinary, size_t binaryLengthBytes,
+                           char *pBase64, size_t base64LengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uint8_t *pIn = (const uint8_t *) pBinary;
+    uint8_t group[3];
+    size_t length = 0;
+
+    if ((pContext != NULL) && ((pBinary != NULL) || (binaryLengthBytes == 0)) &&
+        ((pBase64 != NULL) || (base64LengthBytes == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        if (base64LengthBytes >= ((pContext->carryLength + binaryLengthBytes) / 3) * 4) {
+            if ((pContext->carryLength > 0) &&
+                (pContext->carryLength + binaryLengthBytes >= 3)) {
+                // Complete the group carried from last time
+                memcpy(group, pContext->carry, pContext->carryLength);
+                memcpy(group + pContext->carryLength, pIn, 3 - pContext->carryLength);
+                pIn += 3 - pContext->carryLength;
+                binaryLengthBytes -= 3 - pContext->carryLength;
+                pContext->carryLength = 0;
+                encodeThree(group, pBase64);
+                length += 4;
+            }
+            if (pContext->carryLength == 0) {
+                // Encode straight from the input
+                for (; binaryLengthBytes >= 3; binaryLengthBytes -= 3) {
+                    encodeThree(pIn, pBase64 + length);
+                    pIn += 3;
+                    length += 4;
+                }
+            }
+            // Keep what is left for next time
+            memcpy(pContext->carry + pContext->carryLength, pIn, binaryLengthBytes);
+            pContext->carryLength += binaryLengthBytes;
+            errorCode = (int32_t) length;
+        }
+    }
+
+    return errorCode;
+}
+
+// Finish a chunked base 64 encode.
+int32_t uBase64EncodeFinish(uBase64EncodeContext_t *pContext,
+                            char *pBase64, size_t base64LengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uint8_t group[3] = {0};
+
+    if (pContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pContext->carryLength > 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            if ((pBase64 != NULL) && (base64LengthBytes >= 4)) {
+                memcpy(group, pContext->carry, pContext->carryLength);
+                encodeThree(group, pBase64);
+                // One byte carried needs two characters of padding,
+                // two bytes need one
+                pBase64[3] = '=';
+                if (pContext->carryLength == 1) {
+                    pBase64[2] = '=';
+                }
+                errorCode = 4;
+            }
+        }
+        if (errorCode >= 0) {
+            uBase64EncodeStart(pContext);
+        }
+    }
+
+    return errorCode;
+}
+
+// Start a chunked base 64 decode.
+void uBase64DecodeStart(uBase64DecodeContext_t *pContext)
+{
+    if (pContext != NULL) {
+        memset(pContext, 0, sizeof(*pContext));
+    }
+}
+
+// Decode a chunk of base 64.
+int32_t uBase64DecodeChunk(uBase64DecodeContext_t *pContext,
+                           const char *pBase64, size_t base64LengthBytes,
+                           char *pBinary, size_t binaryLengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uint8_t *pIn = (const uint8_t *) pBase64;
+    const uint8_t *pEnd = pIn + base64LengthBytes;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+    uint32_t d;
+    size_t length = 0;
+
+    if ((pContext != NULL) && !pContext->error &&
+        ((pBase64 != NULL) || (base64LengthBytes == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        if ((pBinary != NULL) &&
+            (binaryLengthBytes >= U_BASE64_DECODE_CHUNK_LENGTH_MAX(base64LengthBytes))) {
+            while ((pIn < pEnd) && !pContext->error) {
+                if ((pContext->numValues == 0) && (pContext->padLength == 0)) {
+                    // Fast path: take four characters at a time, a single
+                    // test catching anything that is not a plain base 64
+                    // character, which is then dealt with below
+                    while (pEnd - pIn >= 4) {
+                        a = gBase64DecodeTable[pIn[0]];
+                        b = gBase64DecodeTable[pIn[1]];
+                        c = gBase64DecodeTable[pIn[2]];
+                        d = gBase64DecodeTable[pIn[3]];
+                        if (((a | b | c | d) & U_BASE64_DECODE_NOT_VALUE_MASK) != 0) {
+                            break;
+                        }
+                        decodeFour((a << 18) | (b << 12) | (c << 6) | d, pBinary + length);
+                        length += 3;
+                        pIn += 4;
+                    }
+                }
+                if (pIn < pEnd) {
+                    // Slow path: one character at a time
+                    a = gBase64DecodeTable[*pIn];
+                    pIn++;
+                    if (a == U_BASE64_DECODE_PAD) {
+                        // Padding may only complete a group of two
+                        // or three values
+                        if (pContext->numValues < 2) {
+                            pContext->error = true;
+                        } else {
+                            if (pContext->padLength == 0) {
+                                length += decodePartial(pContext->bits, pContext->numValues,
+                                                        pBinary + length);
+                            }
+                            pContext->padLength++;
+                            if (pContext->numValues + pContext->padLength > 4) {
+                                pContext->error = true;
+                            }
+                        }
+                    } else if (a != U_BASE64_DECODE_SPACE) {
+                        if (((a & U_BASE64_DECODE_NOT_VALUE_MASK) != 0) ||
+                            (pContext->padLength > 0)) {
+                            // Invalid, or something after the padding
+                            pContext->error = true;
+                        } else {
+                            pContext->bits = (pContext->bits << 6) | a;
+                            pContext->numValues++;
+                            if (pContext->numValues == 4) {
+                                decodeFour(pContext->bits, pBinary + length);
+                                length += 3;
+                                pContext->bits = 0;
+                                pContext->numValues = 0;
+                            }
+                        }
+                    }
+                }
+            }
+            errorCode = (int32_t) length;
+            if (pContext->error) {
+                errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Finish a chunked base 64 decode.
+int32_t uBase64DecodeFinish(uBase64DecodeContext_t *pContext,
+                            char *pBinary, size_t binaryLengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && !pContext->error) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pContext->padLength == 0) {
+            // Unpadded: one value left over cannot make a byte
+            if (pContext->numValues == 1) {
+                errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            } else if (pContext->numValues > 1) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                if ((pBinary != NULL) && (binaryLengthBytes >= pContext->numValues - 1)) {
+                    errorCode = (int32_t) decodePartial(pContext->bits, pContext->numValues,
+                                                        pBinary);
+                }
+            }
+        }
+        if (errorCode >= 0) {
+            uBase64DecodeStart(pContext);
+        }
+    }
+
+    return errorCode;
+}
+
 // End of file
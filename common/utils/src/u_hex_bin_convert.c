@@ -41,6 +41,12 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The value in gHexValue[] of a character that is not ASCII hex:
+ * a bit above the four bits of a valid value, so that the values of
+ * any number of characters can be OR'ed together and checked once.
+ */
+#define U_HEX_BIN_CONVERT_INVALID 0x10
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -49,24 +55,71 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
-static const char gHex[] = {'0', '1', '2', '3', '4', '5', '6', '7',
-                            '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
-                           };
+/** The ASCII hex of every byte value, two characters per byte, so
+ * that uBinToHex() does one look-up per byte rather than one per
+ * nibble; 512 bytes (plus the null terminator, which is not used).
+ */
+static const char gHexPair[] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+/** The value of every ASCII hex character, or
+ * #U_HEX_BIN_CONVERT_INVALID for a character that is not ASCII hex.
+ */
+static const uint8_t gHexValue[256] = {
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+};
 
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
 //lint -esym(429, pHex) Suppress Lint getting a bee in its
 // bonnet about pHex not being free()'d when it IS being free()'d.
 size_t uBinToHex(const char *pBin, size_t binLength, char *pHex)
 {
+    const char *pPair;
+
     U_ASSERT(pHex != NULL);
 
     for (size_t x = 0; x < binLength; x++) {
-        *pHex = gHex[((unsigned char) * pBin) >> 4];
+        pPair = gHexPair + (((size_t) (unsigned char) * pBin) << 1);
+        *pHex = *pPair;
         pHex++;
-        *pHex = gHex[*pBin & 0x0f];
+        *pHex = *(pPair + 1);
         pHex++;
         pBin++;
     }
@@ -78,39 +131,34 @@ size_t uBinToHex(const char *pBin, size_t binLength, char *pHex)
 // bonnet about pBin not being free()'d when it IS being free()'d.
 size_t uHexToBin(const char *pHex, size_t hexLength, char *pBin)
 {
-    bool success = true;
     size_t length;
-    char z[2];
+    uint32_t high;
+    uint32_t low;
 
     U_ASSERT(pBin != NULL);
 
-    for (length = 0; (length < hexLength / 2) && success; length++) {
-        z[0] = *pHex - '0';
-        pHex++;
-        z[1] = *pHex - '0';
-        pHex++;
-        for (size_t y = 0; (y < sizeof(z)) && success; y++) {
-            if (z[y] > 9) {
-                // Must be A to F or a to f
-                z[y] -= 'A' - '0';
-                z[y] += 10;
-            }
-            if (z[y] > 15) {
-                // Must be a to f
-                z[y] -= 'a' - 'A';
-            }
-            // Cast here to shut-up a warning under ESP-IDF
-            // which appears to have chars as unsigned and
-            // hence thinks the first condition is always true
-            success = ((signed char) z[y] >= 0) && (z[y] <= 15);
-        }
-        if (success) {
-            *pBin = (char) (((z[0] & 0x0f) << 4) | z[1]);
-            pBin++;
+    // No branches per character: each is looked up and the check
+    // for an invalid character is done once per byte.  Both characters
+    // are read before the byte is written, which is what makes
+    // decoding in place possible
+    for (length = 0; length < hexLength / 2; length++) {
+        high = gHexValue[(unsigned char) * pHex];
+        low = gHexValue[(unsigned char) * (pHex + 1)];
+        if (((high | low) & U_HEX_BIN_CONVERT_INVALID) != 0) {
+            break;
         }
+        pHex += 2;
+        *pBin = (char) ((high << 4) | low);
+        pBin++;
     }
 
     return length;
 }
 
+// Convert a buffer of ASCII hex into binary in place.
+size_t uHexToBinInPlace(char *pBuffer, size_t hexLength)
+{
+    return uHexToBin(pBuffer, hexLength, pBuffer);
+}
+
 // End of file
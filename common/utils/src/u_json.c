@@ -0,0 +1,366 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the single-pass JSON tokenizer.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strlen(), strncmp()
+#include "limits.h"    // INT32_MAX, INT32_MIN
+
+#include "u_error_common.h"
+
+#include "u_json.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The number of significant digits of a number that uJsonToInt32()
+ * keeps, such that they fit in an int64_t.
+ */
+#define U_JSON_MAX_SIGNIFICANT_DIGITS 18
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Context for uJsonFind().
+ */
+typedef struct {
+    const char *const *ppKey;
+    size_t numKeys;
+    uJsonItem_t *pItem;
+    size_t numFound;
+} uJsonFindContext_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return true if a character is JSON white space.
+static bool isWhiteSpace(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+// Return a pointer to the closing quote of a string, given a pointer
+// to the first character after the opening quote, or NULL if there
+// is none.
+static const char *pStringEnd(const char *pStr, const char *pEnd)
+{
+    while ((pStr < pEnd) && (*pStr != '"')) {
+        if (*pStr == '\\') {
+            // Step over the escaped character
+            pStr++;
+        }
+        pStr++;
+    }
+
+    return pStr < pEnd ? pStr : NULL;
+}
+
+// Callback for uJsonFind().
+static bool findCallback(const uJsonItem_t *pItem, void *pParameter)
+{
+    uJsonFindContext_t *pContext = (uJsonFindContext_t *) pParameter;
+    const char *pKey;
+
+    if ((pItem->depth == 1) && (pItem->pKey != NULL)) {
+        for (size_t x = 0; x < pContext->numKeys; x++) {
+            pKey = *(pContext->ppKey + x);
+            if (((pContext->pItem + x)->type == U_JSON_TYPE_NONE) &&
+                (strlen(pKey) == pItem->keyLength) &&
+                (strncmp(pKey, pItem->pKey, pItem->keyLength) == 0)) {
+                *(pContext->pItem + x) = *pItem;
+                pContext->numFound++;
+                break;
+            }
+        }
+    }
+
+    return pContext->numFound < pContext->numKeys;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Walk some JSON.
+int32_t uJsonParse(const char *pJson, size_t length,
+                   uJsonCallback_t pCallback, void *pParameter)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const char *pEnd = pJson + length;
+    // Bit n set means that the container at depth n is an array
+    uint32_t isArray = 0;
+    int32_t depth = 0;
+    bool expectKey = false;
+    bool keepGoing = true;
+    bool done = false;
+    uJsonItem_t item = {0};
+    const char *pTmp;
+    char c;
+
+    if ((pJson != NULL) && (pCallback != NULL)) {
+        errorCodeOrCount = 0;
+        while ((errorCodeOrCount >= 0) && keepGoing && !done && (pJson < pEnd)) {
+            c = *pJson;
+            item.type = U_JSON_TYPE_NONE;
+            if (isWhiteSpace(c)) {
+                pJson++;
+            } else if (c == '"') {
+                pTmp = pStringEnd(pJson + 1, pEnd);
+                if (pTmp == NULL) {
+                    errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                } else if (expectKey) {
+                    item.pKey = pJson + 1;
+                    item.keyLength = pTmp - item.pKey;
+                    // Must be followed by a colon
+                    pJson = pTmp + 1;
+                    while ((pJson < pEnd) && isWhiteSpace(*pJson)) {
+                        pJson++;
+                    }
+                    if ((pJson < pEnd) && (*pJson == ':')) {
+                        pJson++;
+                        expectKey = false;
+                    } else {
+                        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                    }
+                } else {
+                    item.type = U_JSON_TYPE_STRING;
+                    item.pValue = pJson + 1;
+                    item.valueLength = pTmp - item.pValue;
+                    pJson = pTmp + 1;
+                }
+            } else if ((c == '{') || (c == '[')) {
+                if (expectKey || (depth >= U_JSON_MAX_DEPTH)) {
+                    errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                } else {
+                    item.type = (c == '{') ? U_JSON_TYPE_OBJECT : U_JSON_TYPE_ARRAY;
+                    item.pValue = pJson;
+                    item.valueLength = 1;
+                    pJson++;
+                }
+            } else if ((c == '}') || (c == ']')) {
+                // Must match what was opened
+                if ((depth == 0) ||
+                    (((isArray >> (depth - 1)) & 1) != (uint32_t) (c == ']'))) {
+                    errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                } else {
+                    depth--;
+                    expectKey = false;
+                    pJson++;
+                    done = (depth == 0);
+                }
+            } else if (c == ',') {
+                if (depth == 0) {
+                    errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                } else {
+                    // In an object, a key comes next
+                    expectKey = (((isArray >> (depth - 1)) & 1) == 0);
+                    item.pKey = NULL;
+                    item.keyLength = 0;
+                    pJson++;
+                }
+            } else if (expectKey || (c == ':')) {
+                errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            } else {
+                // A number, true, false or null: runs until
+                // white space or punctuation
+                item.pValue = pJson;
+                while ((pJson < pEnd) && !isWhiteSpace(*pJson) && (*pJson != ',') &&
+                       (*pJson != '}') && (*pJson != ']') && (*pJson != ':')) {
+                    pJson++;
+                }
+                item.valueLength = pJson - item.pValue;
+                if ((c == 't') || (c == 'f')) {
+                    item.type = U_JSON_TYPE_BOOL;
+                } else if (c == 'n') {
+                    item.type = U_JSON_TYPE_NULL;
+                } else {
+                    item.type = U_JSON_TYPE_NUMBER;
+                }
+            }
+
+            if ((errorCodeOrCount >= 0) && (item.type != U_JSON_TYPE_NONE)) {
+                // Report the value
+                item.depth = depth;
+                errorCodeOrCount++;
+                keepGoing = pCallback(&item, pParameter);
+                item.pKey = NULL;
+                item.keyLength = 0;
+                if ((item.type == U_JSON_TYPE_OBJECT) || (item.type == U_JSON_TYPE_ARRAY)) {
+                    // Go down a level
+                    if (item.type == U_JSON_TYPE_ARRAY) {
+                        isArray |= 1UL << depth;
+                    } else {
+                        isArray &= ~(1UL << depth);
+                        expectKey = true;
+                    }
+                    depth++;
+                } else {
+                    // A value on its own is complete
+                    done = (depth == 0);
+                }
+            }
+        }
+        if (keepGoing && !done && (errorCodeOrCount >= 0)) {
+            // Ran out of JSON
+            errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Find the values of a set of keys.
+int32_t uJsonFind(const char *pJson, size_t length,
+                  const char *const *ppKey, size_t numKeys,
+                  uJsonItem_t *pItem)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uJsonFindContext_t context;
+
+    if ((ppKey != NULL) && (pItem != NULL)) {
+        for (size_t x = 0; x < numKeys; x++) {
+            memset(pItem + x, 0, sizeof(*pItem));
+            (pItem + x)->type = U_JSON_TYPE_NONE;
+        }
+        context.ppKey = ppKey;
+        context.numKeys = numKeys;
+        context.pItem = pItem;
+        context.numFound = 0;
+        errorCodeOrCount = 0;
+        if (numKeys > 0) {
+            errorCodeOrCount = uJsonParse(pJson, length, findCallback, &context);
+            if (errorCodeOrCount >= 0) {
+                errorCodeOrCount = (int32_t) context.numFound;
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Convert a JSON number into an int32_t.
+int32_t uJsonToInt32(const uJsonItem_t *pItem, int32_t powerOfTen,
+                     int32_t *pValue)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const char *pStr;
+    const char *pEnd;
+    int64_t mantissa = 0;
+    int32_t numDigits = 0;
+    int32_t exponent = 0;
+    int32_t exponentPart = 0;
+    bool negative = false;
+    bool exponentNegative = false;
+    bool fraction = false;
+    bool valid = false;
+
+    if ((pItem != NULL) && (pItem->type == U_JSON_TYPE_NUMBER) &&
+        (powerOfTen >= 0) && (pValue != NULL)) {
+        pStr = pItem->pValue;
+        pEnd = pStr + pItem->valueLength;
+        if ((pStr < pEnd) && (*pStr == '-')) {
+            negative = true;
+            pStr++;
+        }
+        // The integer and fractional parts
+        for (; pStr < pEnd; pStr++) {
+            if ((*pStr >= '0') && (*pStr <= '9')) {
+                valid = true;
+                if (numDigits < U_JSON_MAX_SIGNIFICANT_DIGITS) {
+                    mantissa = (mantissa * 10) + (*pStr - '0');
+                    if (mantissa > 0) {
+                        numDigits++;
+                    }
+                    if (fraction) {
+                        exponent--;
+                    }
+                } else if (!fraction) {
+                    // Too many digits to keep: scale instead
+                    exponent++;
+                }
+            } else if ((*pStr == '.') && !fraction) {
+                fraction = true;
+            } else {
+                break;
+            }
+        }
+        // The exponent part
+        if (valid && (pStr < pEnd) && ((*pStr == 'e') || (*pStr == 'E'))) {
+            pStr++;
+            if ((pStr < pEnd) && ((*pStr == '-') || (*pStr == '+'))) {
+                exponentNegative = (*pStr == '-');
+                pStr++;
+            }
+            valid = false;
+            for (; (pStr < pEnd) && (*pStr >= '0') && (*pStr <= '9'); pStr++) {
+                valid = true;
+                if (exponentPart < 1000) {
+                    exponentPart = (exponentPart * 10) + (*pStr - '0');
+                }
+            }
+            exponent += exponentNegative ? -exponentPart : exponentPart;
+        }
+        if (valid && (pStr == pEnd)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            exponent += powerOfTen;
+            // Apply the exponent, truncating
+            for (; (exponent < 0) && (mantissa != 0); exponent++) {
+                mantissa /= 10;
+            }
+            for (; (exponent > 0) && (mantissa != 0) && (errorCode == 0); exponent--) {
+                mantissa *= 10;
+                if (mantissa > (int64_t) INT32_MAX + 1) {
+                    errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                }
+            }
+            if (negative) {
+                mantissa = -mantissa;
+            }
+            if ((mantissa > INT32_MAX) || (mantissa < INT32_MIN)) {
+                errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            }
+            if (errorCode == 0) {
+                *pValue = (int32_t) mantissa;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// End of file
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of LZSS compression and decompression.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // size_t
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_error_common.h"
+
+#include "u_lzss.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The largest offset that a reference can encode.
+ */
+#define U_LZSS_OFFSET_MAX 4096
+
+#if U_LZSS_WINDOW_LENGTH_BYTES > U_LZSS_OFFSET_MAX
+# error U_LZSS_WINDOW_LENGTH_BYTES cannot be more than 4096
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Find the longest match for the data at pIn + position in the
+// window behind it, returning its length (zero if there is none
+// of at least U_LZSS_MATCH_LENGTH_MIN) and the offset back to it.
+static size_t matchFind(const uint8_t *pIn, size_t inLengthBytes,
+                        size_t position, size_t *pOffset)
+{
+    size_t bestLength = 0;
+    size_t lengthMax = inLengthBytes - position;
+    size_t windowStart = 0;
+    const uint8_t *pHere = pIn + position;
+    const uint8_t *pThere;
+    size_t length;
+
+    if (lengthMax > U_LZSS_MATCH_LENGTH_MAX) {
+        lengthMax = U_LZSS_MATCH_LENGTH_MAX;
+    }
+    if (position > U_LZSS_WINDOW_LENGTH_BYTES) {
+        windowStart = position - U_LZSS_WINDOW_LENGTH_BYTES;
+    }
+    if (lengthMax >= U_LZSS_MATCH_LENGTH_MIN) {
+        // Search from nearest to furthest so that, for
+        // matches of equal length, the nearest wins
+        for (size_t x = position; (x > windowStart) && (bestLength < lengthMax); x--) {
+            pThere = pIn + x - 1;
+            if ((pThere[0] == pHere[0]) && (pThere[bestLength] == pHere[bestLength])) {
+                // A match may run on into the data being matched,
+                // which the decompressor copes with as it copies
+                // a byte at a time
+                for (length = 1; (length < lengthMax) &&
+                     (pThere[length] == pHere[length]); length++) {
+                }
+                if (length > bestLength) {
+                    bestLength = length;
+                    *pOffset = position - (x - 1);
+                }
+            }
+        }
+    }
+    if (bestLength < U_LZSS_MATCH_LENGTH_MIN) {
+        bestLength = 0;
+    }
+
+    return bestLength;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Compress a buffer.
+int32_t uLzssCompress(const char *pIn, size_t inLengthBytes,
+                      char *pOut, size_t outLengthBytes)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uint8_t *pInU = (const uint8_t *) pIn;
+    uint8_t *pOutU = (uint8_t *) pOut;
+    size_t inPosition = 0;
+    size_t outPosition = 0;
+    size_t flagPosition = 0;
+    size_t itemCount = 0;
+    size_t length;
+    size_t offset = 0;
+
+    if ((pIn != NULL) && (pOut != NULL)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+        while ((inPosition < inLengthBytes) && (errorCodeOrLength == 0)) {
+            if ((itemCount & 0x07) == 0) {
+                // Room for a new flag byte
+                flagPosition = outPosition;
+                outPosition++;
+                if (outPosition > outLengthBytes) {
+                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                } else {
+                    pOutU[flagPosition] = 0;
+                }
+            }
+            if (errorCodeOrLength == 0) {
+                length = matchFind(pInU, inLengthBytes, inPosition, &offset);
+                if (length > 0) {
+                    if (outPosition + 2 > outLengthBytes) {
+                        errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                    } else {
+                        pOutU[flagPosition] |= (uint8_t) (1U << (itemCount & 0x07));
+                        pOutU[outPosition] = (uint8_t) (offset - 1);
+                        pOutU[outPosition + 1] = (uint8_t) ((((offset - 1) >> 4) & 0xF0) |
+                                                            (length - U_LZSS_MATCH_LENGTH_MIN));
+                        outPosition += 2;
+                        inPosition += length;
+                    }
+                } else {
+                    if (outPosition + 1 > outLengthBytes) {
+                        errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                    } else {
+                        pOutU[outPosition] = pInU[inPosition];
+                        outPosition++;
+                        inPosition++;
+                    }
+                }
+                itemCount++;
+            }
+        }
+        if (errorCodeOrLength == 0) {
+            errorCodeOrLength = (int32_t) outPosition;
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// Decompress a buffer.
+int32_t uLzssDecompress(const char *pIn, size_t inLengthBytes,
+                        char *pOut, size_t outLengthBytes)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uint8_t *pInU = (const uint8_t *) pIn;
+    uint8_t *pOutU = (uint8_t *) pOut;
+    size_t inPosition = 0;
+    size_t outPosition = 0;
+    uint8_t flags = 0;
+    size_t itemCount = 0;
+    size_t length;
+    size_t offset;
+
+    if ((pIn != NULL) && (pOut != NULL)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+        while ((inPosition < inLengthBytes) && (errorCodeOrLength == 0)) {
+            if ((itemCount & 0x07) == 0) {
+                flags = pInU[inPosition];
+                inPosition++;
+            }
+            if (inPosition < inLengthBytes) {
+                if (flags & (1U << (itemCount & 0x07))) {
+                    // A reference
+                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                    if (inPosition + 2 <= inLengthBytes) {
+                        offset = (size_t) pInU[inPosition] +
+                                 (((size_t) (pInU[inPosition + 1] & 0xF0)) << 4) + 1;
+                        length = (size_t) (pInU[inPosition + 1] & 0x0F) + U_LZSS_MATCH_LENGTH_MIN;
+                        inPosition += 2;
+                        if (offset <= outPosition) {
+                            errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                            if (outPosition + length <= outLengthBytes) {
+                                errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+                                // A byte at a time since the
+                                // source may overlap the destination
+                                for (size_t x = 0; x < length; x++) {
+                                    pOutU[outPosition] = pOutU[outPosition - offset];
+                                    outPosition++;
+                                }
+                            }
+                        }
+                    }
+                } else {
+                    // A literal
+                    if (outPosition < outLengthBytes) {
+                        pOutU[outPosition] = pInU[inPosition];
+                        outPosition++;
+                        inPosition++;
+                    } else {
+                        errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                    }
+                }
+                itemCount++;
+            }
+        }
+        if (errorCodeOrLength == 0) {
+            errorCodeOrLength = (int32_t) outPosition;
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// End of file
@@ -33,10 +33,12 @@
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
 
+#include "u_compiler.h" // For U_ATOMIC_CAS32 and U_MEMORY_BARRIER
 #include "u_assert.h"
 #include "u_port.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"
+#include "u_port_heap.h"
 #include "u_mempool.h"
 #include "u_error_common.h"
 
@@ -63,6 +65,25 @@
 
 #define U_FENCE_MAGIC 0xBEEF
 
+// The value of the index part of the free list head of a slab
+// class when the free list is empty.
+#define U_MEMPOOL_SLAB_INDEX_NONE 0xFFFF
+
+// Round a size up to the alignment of slab blocks.
+#define U_MEMPOOL_SLAB_ALIGN(size) ((((size) + U_MEMPOOL_SLAB_ALIGNMENT_BYTES - 1) / \
+                                     U_MEMPOOL_SLAB_ALIGNMENT_BYTES) * U_MEMPOOL_SLAB_ALIGNMENT_BYTES)
+
+// The size of the backing storage of the library-wide slab.
+#define U_MEMPOOL_MALLOC_BUFFER_SIZE                                                                  \
+    ((U_MEMPOOL_SLAB_ALIGN(U_MEMPOOL_MALLOC_SMALL_BLOCK_SIZE) * U_MEMPOOL_MALLOC_SMALL_BLOCK_COUNT) +   \
+     (U_MEMPOOL_SLAB_ALIGN(U_MEMPOOL_MALLOC_MEDIUM_BLOCK_SIZE) * U_MEMPOOL_MALLOC_MEDIUM_BLOCK_COUNT) + \
+     (U_MEMPOOL_SLAB_ALIGN(U_MEMPOOL_MALLOC_LARGE_BLOCK_SIZE) * U_MEMPOOL_MALLOC_LARGE_BLOCK_COUNT))
+
+// The states of the library-wide slab.
+#define U_MEMPOOL_MALLOC_STATE_NONE         0
+#define U_MEMPOOL_MALLOC_STATE_INITIALISING 1
+#define U_MEMPOOL_MALLOC_STATE_READY        2
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -79,6 +100,21 @@ typedef struct uMemPoolFree {
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
+/** The library-wide slab used by uMemPoolMalloc().
+ */
+static uMemPoolSlab_t gMallocSlab;
+
+/** The state of gMallocSlab, one of U_MEMPOOL_MALLOC_STATE_xxx.
+ */
+static volatile uint32_t gMallocSlabState = U_MEMPOOL_MALLOC_STATE_NONE;
+
+#if U_MEMPOOL_MALLOC_BUFFER_SIZE > 0
+/** The backing storage of gMallocSlab, as uint64_t for alignment.
+ */
+static uint64_t gMallocSlabBuffer[(U_MEMPOOL_MALLOC_BUFFER_SIZE + sizeof(uint64_t) - 1) /
+                                                                                       sizeof(uint64_t)];
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -100,6 +136,102 @@ static void initFreeList(uMemPoolDesc_t *pMemPool)
     pMemPool->usedBlockCount = 0;
 }
 
+// Atomically add a (possibly negative) amount to a counter,
+// returning the new value.
+static uint32_t atomicAdd(volatile uint32_t *pValue, int32_t amount)
+{
+    uint32_t oldValue;
+    uint32_t newValue;
+
+    do {
+        oldValue = *pValue;
+        newValue = oldValue + (uint32_t) amount;
+    } while (!U_ATOMIC_CAS32(pValue, oldValue, newValue));
+
+    return newValue;
+}
+
+// Pop a block from the free list of a slab class, NULL if there
+// is none.  The count in the upper 16 bits of the head protects
+// against the head being popped, re-used and pushed back between
+// reading it and swapping it.
+static void *slabClassPop(uMemPoolSlabClass_t *pClass)
+{
+    void *pBlock = NULL;
+    uint32_t head;
+    uint32_t index;
+    uint32_t next;
+
+    do {
+        head = pClass->freeHead;
+        index = head & 0xFFFF;
+        if (index == U_MEMPOOL_SLAB_INDEX_NONE) {
+            pBlock = NULL;
+            break;
+        }
+        pBlock = pClass->pBuffer + (index * pClass->blockSize);
+        next = *((volatile uint32_t *) pBlock);
+    } while (!U_ATOMIC_CAS32(&(pClass->freeHead), head,
+                             (head & 0xFFFF0000) + 0x10000 + next));
+
+    return pBlock;
+}
+
+// Push a block onto the free list of a slab class.
+static void slabClassPush(uMemPoolSlabClass_t *pClass, void *pBlock)
+{
+    uint32_t head;
+    uint32_t index = (uint32_t) (((uint8_t *) pBlock - pClass->pBuffer) / pClass->blockSize);
+
+    do {
+        head = pClass->freeHead;
+        *((volatile uint32_t *) pBlock) = head & 0xFFFF;
+    } while (!U_ATOMIC_CAS32(&(pClass->freeHead), head,
+                             (head & 0xFFFF0000) + 0x10000 + index));
+}
+
+// Initialise the library-wide slab if that has not been done; returns
+// true if the library-wide slab is ready for use.  Whoever gets here
+// first does the initialisation (there is no malloc() involved as the
+// backing storage is static); anyone who arrives while that is
+// happening is told that the slab is not ready.
+static bool mallocSlabReady()
+{
+    bool ready = (gMallocSlabState == U_MEMPOOL_MALLOC_STATE_READY);
+#if U_MEMPOOL_MALLOC_BUFFER_SIZE > 0
+    uMemPoolSlabClassCfg_t cfg[3];
+    size_t numClasses = 0;
+
+    if (!ready && U_ATOMIC_CAS32(&gMallocSlabState,
+                                 U_MEMPOOL_MALLOC_STATE_NONE,
+                                 U_MEMPOOL_MALLOC_STATE_INITIALISING)) {
+        if (U_MEMPOOL_MALLOC_SMALL_BLOCK_COUNT > 0) {
+            cfg[numClasses].blockSize = U_MEMPOOL_MALLOC_SMALL_BLOCK_SIZE;
+            cfg[numClasses].blockCount = U_MEMPOOL_MALLOC_SMALL_BLOCK_COUNT;
+            numClasses++;
+        }
+        if (U_MEMPOOL_MALLOC_MEDIUM_BLOCK_COUNT > 0) {
+            cfg[numClasses].blockSize = U_MEMPOOL_MALLOC_MEDIUM_BLOCK_SIZE;
+            cfg[numClasses].blockCount = U_MEMPOOL_MALLOC_MEDIUM_BLOCK_COUNT;
+            numClasses++;
+        }
+        if (U_MEMPOOL_MALLOC_LARGE_BLOCK_COUNT > 0) {
+            cfg[numClasses].blockSize = U_MEMPOOL_MALLOC_LARGE_BLOCK_SIZE;
+            cfg[numClasses].blockCount = U_MEMPOOL_MALLOC_LARGE_BLOCK_COUNT;
+            numClasses++;
+        }
+        if (uMemPoolSlabInit(&gMallocSlab, cfg, numClasses,
+                             gMallocSlabBuffer, sizeof(gMallocSlabBuffer)) == 0) {
+            U_MEMORY_BARRIER();
+            gMallocSlabState = U_MEMPOOL_MALLOC_STATE_READY;
+            ready = true;
+        }
+    }
+#endif
+
+    return ready;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -215,4 +347,235 @@ void uMemPoolFreeAllMem(uMemPoolDesc_t *pMemPool)
     }
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: SLAB
+ * -------------------------------------------------------------- */
+
+size_t uMemPoolSlabBufferSize(const uMemPoolSlabClassCfg_t *pCfg,
+                              size_t numClasses)
+{
+    // Allow for aligning the start of the buffer
+    size_t size = U_MEMPOOL_SLAB_ALIGNMENT_BYTES - 1;
+
+    if (pCfg != NULL) {
+        for (size_t x = 0; x < numClasses; x++) {
+            size += U_MEMPOOL_SLAB_ALIGN(pCfg[x].blockSize) * pCfg[x].blockCount;
+        }
+    }
+
+    return size;
+}
+
+int32_t uMemPoolSlabInit(uMemPoolSlab_t *pSlab,
+                         const uMemPoolSlabClassCfg_t *pCfg,
+                         size_t numClasses,
+                         void *pBuffer, size_t bufferSize)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMemPoolSlabClass_t *pClass;
+    uint8_t *pBlock;
+    size_t blockSize;
+    size_t previousBlockSize = 0;
+    size_t requiredSize;
+
+    if ((pSlab != NULL) && (pCfg != NULL) && (numClasses > 0) &&
+        (numClasses <= U_MEMPOOL_SLAB_CLASSES_MAX_NUM)) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; (x < numClasses) && (errorCode == 0); x++) {
+            blockSize = U_MEMPOOL_SLAB_ALIGN(pCfg[x].blockSize);
+            if ((blockSize < sizeof(uint32_t)) || (blockSize <= previousBlockSize) ||
+                (pCfg[x].blockCount == 0) ||
+                (pCfg[x].blockCount > U_MEMPOOL_SLAB_BLOCKS_MAX_NUM)) {
+                errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            }
+            previousBlockSize = blockSize;
+        }
+        requiredSize = uMemPoolSlabBufferSize(pCfg, numClasses);
+        if ((errorCode == 0) && (pBuffer != NULL) && (bufferSize < requiredSize)) {
+            // A static buffer that may not be aligned needs
+            // the whole of requiredSize
+            if (((((uintptr_t) pBuffer) % U_MEMPOOL_SLAB_ALIGNMENT_BYTES) != 0) ||
+                (bufferSize < requiredSize - (U_MEMPOOL_SLAB_ALIGNMENT_BYTES - 1))) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            }
+        }
+        if (errorCode == 0) {
+            memset(pSlab, 0, sizeof(*pSlab));
+            if (pBuffer == NULL) {
+                pBuffer = malloc(requiredSize);
+                bufferSize = requiredSize;
+                pSlab->bufferIsMalloced = true;
+            }
+            if (pBuffer != NULL) {
+                pSlab->pBuffer = (uint8_t *) pBuffer;
+                pSlab->bufferSize = bufferSize;
+                pBlock = pSlab->pBuffer;
+                pBlock += (U_MEMPOOL_SLAB_ALIGNMENT_BYTES -
+                           (((uintptr_t) pBlock) % U_MEMPOOL_SLAB_ALIGNMENT_BYTES)) %
+                          U_MEMPOOL_SLAB_ALIGNMENT_BYTES;
+                for (size_t x = 0; x < numClasses; x++) {
+                    pClass = &(pSlab->classes[x]);
+                    pClass->pBuffer = pBlock;
+                    pClass->blockSize = U_MEMPOOL_SLAB_ALIGN(pCfg[x].blockSize);
+                    pClass->blockCount = (uint32_t) pCfg[x].blockCount;
+                    // Chain the blocks in address order, each pointing
+                    // at the index of the next
+                    for (uint32_t y = 0; y < pClass->blockCount; y++) {
+                        *((uint32_t *) pBlock) = y + 1;
+                        pBlock += pClass->blockSize;
+                    }
+                    *((uint32_t *) (pBlock - pClass->blockSize)) = U_MEMPOOL_SLAB_INDEX_NONE;
+                    pClass->freeHead = 0;
+                }
+                pSlab->numClasses = numClasses;
+                U_MEMORY_BARRIER();
+            } else {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+void uMemPoolSlabDeinit(uMemPoolSlab_t *pSlab)
+{
+    if (pSlab != NULL) {
+        if (pSlab->bufferIsMalloced) {
+            free(pSlab->pBuffer);
+        }
+        memset(pSlab, 0, sizeof(*pSlab));
+    }
+}
+
+void *uMemPoolSlabAlloc(uMemPoolSlab_t *pSlab, size_t size)
+{
+    void *pMem = NULL;
+    uMemPoolSlabClass_t *pClass;
+    size_t bestFit = 0;
+    uint32_t inUse;
+    uint32_t highWater;
+
+    if (pSlab != NULL) {
+        while ((bestFit < pSlab->numClasses) &&
+               (pSlab->classes[bestFit].blockSize < size)) {
+            bestFit++;
+        }
+        for (size_t x = bestFit; (x < pSlab->numClasses) && (pMem == NULL); x++) {
+            pClass = &(pSlab->classes[x]);
+            pMem = slabClassPop(pClass);
+            if (pMem != NULL) {
+                inUse = atomicAdd(&(pClass->inUse), 1);
+                do {
+                    highWater = pClass->inUseHighWater;
+                } while ((inUse > highWater) &&
+                         !U_ATOMIC_CAS32(&(pClass->inUseHighWater), highWater, inUse));
+            }
+        }
+        if ((pMem == NULL) && (bestFit < pSlab->numClasses)) {
+            atomicAdd(&(pSlab->classes[bestFit].failures), 1);
+        }
+    }
+
+    return pMem;
+}
+
+bool uMemPoolSlabFree(uMemPoolSlab_t *pSlab, void *pMem)
+{
+    bool isOurs = false;
+    uMemPoolSlabClass_t *pClass;
+    uint8_t *pBlock = (uint8_t *) pMem;
+
+    if ((pSlab != NULL) && (pBlock != NULL)) {
+        for (size_t x = 0; (x < pSlab->numClasses) && !isOurs; x++) {
+            pClass = &(pSlab->classes[x]);
+            if ((pBlock >= pClass->pBuffer) &&
+                (pBlock < pClass->pBuffer + (pClass->blockSize * pClass->blockCount))) {
+                // Must be the start of a block
+                U_ASSERT(((pBlock - pClass->pBuffer) % pClass->blockSize) == 0);
+                U_ASSERT(pClass->inUse > 0);
+                slabClassPush(pClass, pBlock);
+                atomicAdd(&(pClass->inUse), -1);
+                isOurs = true;
+            }
+        }
+    }
+
+    return isOurs;
+}
+
+size_t uMemPoolSlabBlockSize(const uMemPoolSlab_t *pSlab, const void *pMem)
+{
+    size_t blockSize = 0;
+    const uMemPoolSlabClass_t *pClass;
+    const uint8_t *pBlock = (const uint8_t *) pMem;
+
+    if ((pSlab != NULL) && (pBlock != NULL)) {
+        for (size_t x = 0; (x < pSlab->numClasses) && (blockSize == 0); x++) {
+            pClass = &(pSlab->classes[x]);
+            if ((pBlock >= pClass->pBuffer) &&
+                (pBlock < pClass->pBuffer + (pClass->blockSize * pClass->blockCount))) {
+                blockSize = pClass->blockSize;
+            }
+        }
+    }
+
+    return blockSize;
+}
+
+int32_t uMemPoolSlabGetStats(const uMemPoolSlab_t *pSlab,
+                             size_t classIndex,
+                             uMemPoolSlabStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uMemPoolSlabClass_t *pClass;
+
+    if ((pSlab != NULL) && (classIndex < pSlab->numClasses) && (pStats != NULL)) {
+        pClass = &(pSlab->classes[classIndex]);
+        pStats->blockSize = pClass->blockSize;
+        pStats->blockCount = pClass->blockCount;
+        pStats->inUse = pClass->inUse;
+        pStats->inUseHighWater = pClass->inUseHighWater;
+        pStats->failures = pClass->failures;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+void *uMemPoolMalloc(size_t size)
+{
+    void *pMem = NULL;
+
+    if (mallocSlabReady()) {
+        pMem = uMemPoolSlabAlloc(&gMallocSlab, size);
+    }
+    if (pMem == NULL) {
+        pMem = pUPortHeapAlloc(size, U_PORT_HEAP_TAG_NONE);
+    }
+
+    return pMem;
+}
+
+void uMemPoolFree(void *pMem)
+{
+    // No need to check the state here: if gMallocSlab has not been
+    // initialised it has no classes and so will not claim pMem
+    if (!uMemPoolSlabFree(&gMallocSlab, pMem)) {
+        uPortHeapFree(pMem, U_PORT_HEAP_TAG_NONE);
+    }
+}
+
+int32_t uMemPoolMallocGetStats(size_t classIndex,
+                               uMemPoolSlabStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+
+    if (mallocSlabReady()) {
+        errorCode = uMemPoolSlabGetStats(&gMallocSlab, classIndex, pStats);
+    }
+
+    return errorCode;
+}
+
 // End of file
@@ -0,0 +1,576 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the metrics registry.  The registered
+ * metrics are kept in a singly-linked list through the caller-owned
+ * #uMetric_t structures, so the registry itself needs no memory.
+ * The list is protected by a lock taken with a compare-and-swap,
+ * rather than by a port mutex, so that there is nothing to create
+ * before the first metric is registered and nothing left behind;
+ * registration and enumeration are rare enough for a contended
+ * lock to simply yield until it is free.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc(), free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strcmp()
+#include "stdio.h"     // snprintf()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_compiler.h" // U_ATOMIC_CAS32
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_debug.h"
+
+#include "u_metrics.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The room that must be left at the end of the buffer passed to
+ * uMetricsToJson() for the closing brace and terminator.
+ */
+#define U_METRICS_JSON_END_LENGTH_BYTES 2
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Context for the JSON formatting callback.
+ */
+typedef struct {
+    char *pBuffer;
+    size_t size;
+    size_t length;
+    size_t count;
+} uMetricsJsonContext_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The lock on the list of metrics, non-zero when taken.
+ */
+static volatile uint32_t gLock = 0;
+
+/** The first registered metric.
+ */
+static uMetric_t *gpMetricListHead = NULL;
+
+/** Mutex held by the export task while it is running.
+ */
+static uPortMutexHandle_t gExportTaskRunningMutex = NULL;
+
+/** Semaphore given to make the export task stop.
+ */
+static uPortSemaphoreHandle_t gExportStopSemaphore = NULL;
+
+/** The export period.
+ */
+static int32_t gExportPeriodMs = 0;
+
+/** The export function.
+ */
+static uMetricsExport_t gpExport = NULL;
+
+/** The parameter for gpExport.
+ */
+static void *gpExportParam = NULL;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Take the lock on the list of metrics.
+static void lock(void)
+{
+    while (!U_ATOMIC_CAS32(&gLock, 0, 1)) {
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    }
+}
+
+// Release the lock on the list of metrics.
+static void unlock(void)
+{
+    U_ATOMIC_CAS32(&gLock, 1, 0);
+}
+
+// Add to a 32-bit value atomically.
+static void atomicAdd(volatile uint32_t *pValue, uint32_t amount)
+{
+    uint32_t oldValue;
+
+    do {
+        oldValue = *pValue;
+    } while (!U_ATOMIC_CAS32(pValue, oldValue, oldValue + amount));
+}
+
+// Add an item to the JSON being assembled, returning false
+// if it would not fit.
+static bool jsonAdd(uMetricsJsonContext_t *pContext, const uMetric_t *pMetric)
+{
+    char *pStart = pContext->pBuffer + pContext->length;
+    // Leave room for the closing brace and the terminator
+    size_t room = pContext->size - pContext->length - U_METRICS_JSON_END_LENGTH_BYTES;
+    size_t length = 0;
+    int32_t x;
+
+    x = snprintf(pStart, room + 1, "%s\"%s\":", pContext->count > 0 ? "," : "",
+                 pMetric->pName);
+    if ((x > 0) && ((size_t) x <= room)) {
+        length = (size_t) x;
+        if (pMetric->type == U_METRICS_TYPE_HISTOGRAM) {
+            x = snprintf(pStart + length, room + 1 - length, "{\"sum\":%d,\"bins\":[",
+                         (int) uMetricsValue(pMetric));
+            for (size_t y = 0; (x > 0) && (length + x <= room) &&
+                 (y < pMetric->numBins); y++) {
+                length += x;
+                x = snprintf(pStart + length, room + 1 - length, "%s%u",
+                             y > 0 ? "," : "", (unsigned) pMetric->pBinCount[y]);
+            }
+            if ((x > 0) && (length + x <= room)) {
+                length += x;
+                x = snprintf(pStart + length, room + 1 - length, "]}");
+            }
+        } else if (pMetric->type == U_METRICS_TYPE_COUNTER) {
+            x = snprintf(pStart + length, room + 1 - length, "%u",
+                         (unsigned) (uint32_t) uMetricsValue(pMetric));
+        } else {
+            x = snprintf(pStart + length, room + 1 - length, "%d",
+                         (int) uMetricsValue(pMetric));
+        }
+    }
+
+    if ((x > 0) && (length + x <= room)) {
+        pContext->length += length + x;
+        pContext->count++;
+    } else {
+        x = -1;
+        // Remove what didn't fit
+        *pStart = 0;
+    }
+
+    return (x > 0);
+}
+
+// Callback for uMetricsEnumerate() that adds a metric to the JSON;
+// a metric that doesn't fit is skipped, a shorter one may follow.
+static bool jsonCallback(const uMetric_t *pMetric, void *pParam)
+{
+    jsonAdd((uMetricsJsonContext_t *) pParam, pMetric);
+    return true;
+}
+
+// Callback for uMetricsEnumerate() that prints a metric.
+static bool printCallback(const uMetric_t *pMetric, void *pParam)
+{
+    (void) pParam;
+
+    if (pMetric->type == U_METRICS_TYPE_HISTOGRAM) {
+        uPortLog("U_METRICS: %s: sum %d, bins", pMetric->pName,
+                 uMetricsValue(pMetric));
+        for (size_t x = 0; x < pMetric->numBins; x++) {
+            if (x < pMetric->numBins - 1) {
+                uPortLog(" <=%d: %u", pMetric->pBinLimit[x],
+                         (unsigned) pMetric->pBinCount[x]);
+            } else {
+                uPortLog(" more: %u", (unsigned) pMetric->pBinCount[x]);
+            }
+        }
+        uPortLog(".\n");
+    } else if (pMetric->type == U_METRICS_TYPE_COUNTER) {
+        uPortLog("U_METRICS: %s: %u.\n", pMetric->pName,
+                 (unsigned) (uint32_t) uMetricsValue(pMetric));
+    } else {
+        uPortLog("U_METRICS: %s: %d.\n", pMetric->pName,
+                 uMetricsValue(pMetric));
+    }
+
+    return true;
+}
+
+// The export task.
+static void exportTask(void *pParam)
+{
+    char *pBuffer = (char *) pParam;
+    int32_t length;
+
+    U_PORT_MUTEX_LOCK(gExportTaskRunningMutex);
+
+    // Wait for the period or to be told to stop
+    while (uPortSemaphoreTryTake(gExportStopSemaphore, gExportPeriodMs) != 0) {
+        length = uMetricsToJson(pBuffer, U_METRICS_EXPORT_BUFFER_LENGTH_BYTES);
+        if (length >= 0) {
+            gpExport(pBuffer, (size_t) length, gpExportParam);
+        }
+    }
+
+    free(pBuffer);
+
+    U_PORT_MUTEX_UNLOCK(gExportTaskRunningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: SETTING UP
+ * -------------------------------------------------------------- */
+
+// Set up a counter.
+void uMetricsCounterInit(uMetric_t *pMetric, const char *pName)
+{
+    memset(pMetric, 0, sizeof(*pMetric));
+    pMetric->pName = pName;
+    pMetric->type = U_METRICS_TYPE_COUNTER;
+}
+
+// Set up a gauge.
+void uMetricsGaugeInit(uMetric_t *pMetric, const char *pName,
+                       uMetricsRead_t pRead, void *pReadParam)
+{
+    memset(pMetric, 0, sizeof(*pMetric));
+    pMetric->pName = pName;
+    pMetric->type = U_METRICS_TYPE_GAUGE;
+    pMetric->pRead = pRead;
+    pMetric->pReadParam = pReadParam;
+}
+
+// Set up a histogram.
+void uMetricsHistogramInit(uMetric_t *pMetric, const char *pName,
+                           const int32_t *pBinLimit,
+                           uint32_t *pBinCount, size_t numBins)
+{
+    memset(pMetric, 0, sizeof(*pMetric));
+    pMetric->pName = pName;
+    pMetric->type = U_METRICS_TYPE_HISTOGRAM;
+    pMetric->pBinLimit = pBinLimit;
+    pMetric->pBinCount = pBinCount;
+    pMetric->numBins = numBins;
+    memset(pBinCount, 0, numBins * sizeof(*pBinCount));
+}
+
+// Register a metric.
+int32_t uMetricsRegister(uMetric_t *pMetric)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMetric_t **ppMetric;
+
+    if ((pMetric != NULL) && (pMetric->pName != NULL) &&
+        (pMetric->type < U_METRICS_TYPE_MAX_NUM) &&
+        ((pMetric->type != U_METRICS_TYPE_HISTOGRAM) ||
+         ((pMetric->pBinCount != NULL) && (pMetric->numBins > 0) &&
+          ((pMetric->pBinLimit != NULL) || (pMetric->numBins == 1))))) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        lock();
+        if (!pMetric->registered) {
+            // Add to the end so that enumeration is in
+            // order of registration
+            ppMetric = &gpMetricListHead;
+            while (*ppMetric != NULL) {
+                ppMetric = &((*ppMetric)->pNext);
+            }
+            pMetric->pNext = NULL;
+            *ppMetric = pMetric;
+            pMetric->registered = true;
+        }
+        unlock();
+    }
+
+    return errorCode;
+}
+
+// Deregister a metric.
+void uMetricsDeregister(uMetric_t *pMetric)
+{
+    uMetric_t **ppMetric;
+
+    if (pMetric != NULL) {
+        lock();
+        ppMetric = &gpMetricListHead;
+        while ((*ppMetric != NULL) && (*ppMetric != pMetric)) {
+            ppMetric = &((*ppMetric)->pNext);
+        }
+        if (*ppMetric != NULL) {
+            *ppMetric = pMetric->pNext;
+        }
+        pMetric->pNext = NULL;
+        pMetric->registered = false;
+        unlock();
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: UPDATING
+ * -------------------------------------------------------------- */
+
+// Add to a counter.
+void uMetricsCounterAdd(uMetric_t *pMetric, uint32_t amount)
+{
+    if ((pMetric != NULL) && (pMetric->type == U_METRICS_TYPE_COUNTER)) {
+        atomicAdd((volatile uint32_t *) &(pMetric->value), amount);
+    }
+}
+
+// Set a gauge.
+void uMetricsGaugeSet(uMetric_t *pMetric, int32_t value)
+{
+    if ((pMetric != NULL) && (pMetric->type == U_METRICS_TYPE_GAUGE)) {
+        pMetric->value = value;
+    }
+}
+
+// Add a value to a histogram.
+void uMetricsHistogramAdd(uMetric_t *pMetric, int32_t value)
+{
+    size_t bin = 0;
+
+    if ((pMetric != NULL) && (pMetric->type == U_METRICS_TYPE_HISTOGRAM)) {
+        while ((bin < pMetric->numBins - 1) && (value > pMetric->pBinLimit[bin])) {
+            bin++;
+        }
+        atomicAdd(&(pMetric->pBinCount[bin]), 1);
+        atomicAdd((volatile uint32_t *) &(pMetric->value), (uint32_t) value);
+    }
+}
+
+// Reset a metric.
+void uMetricsReset(uMetric_t *pMetric)
+{
+    if (pMetric != NULL) {
+        pMetric->value = 0;
+        if (pMetric->type == U_METRICS_TYPE_HISTOGRAM) {
+            for (size_t x = 0; x < pMetric->numBins; x++) {
+                pMetric->pBinCount[x] = 0;
+            }
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: READING
+ * -------------------------------------------------------------- */
+
+// Call a function for each registered metric.
+int32_t uMetricsEnumerate(uMetricsCallback_t pCallback, void *pParam)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    bool keepGoing = true;
+
+    if (pCallback != NULL) {
+        errorCodeOrCount = 0;
+        lock();
+        for (uMetric_t *pMetric = gpMetricListHead; (pMetric != NULL) && keepGoing;
+             pMetric = pMetric->pNext) {
+            keepGoing = pCallback(pMetric, pParam);
+            errorCodeOrCount++;
+        }
+        unlock();
+    }
+
+    return errorCodeOrCount;
+}
+
+// Find a registered metric by name.
+const uMetric_t *pUMetricsFind(const char *pName)
+{
+    uMetric_t *pMetric = NULL;
+
+    if (pName != NULL) {
+        lock();
+        pMetric = gpMetricListHead;
+        while ((pMetric != NULL) && (strcmp(pMetric->pName, pName) != 0)) {
+            pMetric = pMetric->pNext;
+        }
+        unlock();
+    }
+
+    return pMetric;
+}
+
+// Get the name of a metric.
+const char *pUMetricsName(const uMetric_t *pMetric)
+{
+    return pMetric->pName;
+}
+
+// Get the type of a metric.
+uMetricsType_t uMetricsType(const uMetric_t *pMetric)
+{
+    return pMetric->type;
+}
+
+// Get the value of a metric.
+int32_t uMetricsValue(const uMetric_t *pMetric)
+{
+    int32_t value = pMetric->value;
+
+    if ((pMetric->type == U_METRICS_TYPE_GAUGE) && (pMetric->pRead != NULL)) {
+        value = pMetric->pRead(pMetric->pReadParam);
+    }
+
+    return value;
+}
+
+// Get the number of bins of a histogram.
+size_t uMetricsHistogramNumBins(const uMetric_t *pMetric)
+{
+    size_t numBins = 0;
+
+    if (pMetric->type == U_METRICS_TYPE_HISTOGRAM) {
+        numBins = pMetric->numBins;
+    }
+
+    return numBins;
+}
+
+// Get the count in a bin of a histogram.
+uint32_t uMetricsHistogramBinCount(const uMetric_t *pMetric, size_t bin)
+{
+    uint32_t count = 0;
+
+    if ((pMetric->type == U_METRICS_TYPE_HISTOGRAM) && (bin < pMetric->numBins)) {
+        count = pMetric->pBinCount[bin];
+    }
+
+    return count;
+}
+
+// Format the registered metrics as JSON.
+int32_t uMetricsToJson(char *pBuffer, size_t size)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMetricsJsonContext_t context;
+
+    // Need room for at least "{}" and a terminator
+    if ((pBuffer != NULL) && (size > U_METRICS_JSON_END_LENGTH_BYTES)) {
+        *pBuffer = '{';
+        context.pBuffer = pBuffer;
+        context.size = size;
+        context.length = 1;
+        context.count = 0;
+        uMetricsEnumerate(jsonCallback, &context);
+        *(pBuffer + context.length) = '}';
+        context.length++;
+        *(pBuffer + context.length) = 0;
+        errorCodeOrLength = (int32_t) context.length;
+    }
+
+    return errorCodeOrLength;
+}
+
+// Print the registered metrics.
+void uMetricsPrint(void)
+{
+    uMetricsEnumerate(printCallback, NULL);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: EXPORT
+ * -------------------------------------------------------------- */
+
+// Start exporting the metrics.
+int32_t uMetricsExportStart(int32_t periodMs, uMetricsExport_t pExport,
+                            void *pParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortTaskHandle_t taskHandle;
+    char *pBuffer;
+
+    if ((periodMs > 0) && (pExport != NULL)) {
+        // Only one at a time
+        uMetricsExportStop();
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        // The buffer is owned by the export task, which frees it
+        pBuffer = (char *) malloc(U_METRICS_EXPORT_BUFFER_LENGTH_BYTES);
+        if (pBuffer != NULL) {
+            errorCode = uPortMutexCreate(&gExportTaskRunningMutex);
+            if (errorCode == 0) {
+                errorCode = uPortSemaphoreCreate(&gExportStopSemaphore, 0, 1);
+                if (errorCode == 0) {
+                    gExportPeriodMs = periodMs;
+                    gpExport = pExport;
+                    gpExportParam = pParam;
+                    errorCode = uPortTaskCreate(exportTask, "metricsExport",
+                                                U_METRICS_EXPORT_TASK_STACK_SIZE_BYTES,
+                                                pBuffer,
+                                                U_METRICS_EXPORT_TASK_PRIORITY,
+                                                &taskHandle);
+                    if (errorCode == 0) {
+                        // Wait for the task to have hold of its running
+                        // mutex so that uMetricsExportStop() can't miss it
+                        while (uPortMutexTryLock(gExportTaskRunningMutex, 0) == 0) {
+                            uPortMutexUnlock(gExportTaskRunningMutex);
+                            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                        }
+                    }
+                }
+            }
+            if (errorCode != 0) {
+                // Clean up on error
+                if (gExportStopSemaphore != NULL) {
+                    uPortSemaphoreDelete(gExportStopSemaphore);
+                    gExportStopSemaphore = NULL;
+                }
+                if (gExportTaskRunningMutex != NULL) {
+                    uPortMutexDelete(gExportTaskRunningMutex);
+                    gExportTaskRunningMutex = NULL;
+                }
+                free(pBuffer);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Stop exporting the metrics.
+void uMetricsExportStop(void)
+{
+    if (gExportTaskRunningMutex != NULL) {
+        uPortSemaphoreGive(gExportStopSemaphore);
+        // Wait for the task to exit
+        U_PORT_MUTEX_LOCK(gExportTaskRunningMutex);
+        U_PORT_MUTEX_UNLOCK(gExportTaskRunningMutex);
+        // Give it a moment to delete itself
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        uPortSemaphoreDelete(gExportStopSemaphore);
+        gExportStopSemaphore = NULL;
+        uPortMutexDelete(gExportTaskRunningMutex);
+        gExportTaskRunningMutex = NULL;
+    }
+}
+
+// End of file
@@ -35,7 +35,7 @@
 #include "stdio.h"    // snprintf()
 
 #include "u_cfg_sw.h"
-#include "u_compiler.h" // For U_INLINE
+#include "u_compiler.h" // For U_INLINE and U_MEMORY_BARRIER
 
 #include "u_error_common.h"
 #include "u_assert.h"
@@ -67,6 +67,7 @@ typedef struct {
     const char *pSource;
     size_t bytesAvailable;
     size_t bytesParsed;
+    size_t bytesNeeded; /**< set by uRingBufferParseNeedBytesUnprotected(). */
 } uRingBufferParseContext_t;
 
 /* ----------------------------------------------------------------
@@ -117,6 +118,123 @@ static U_INLINE const char *pPtrOffset(const char *pData, size_t offset,
     return pData;
 }
 
+// Read a pointer that the other side of a lock-free ring buffer
+// may be moving, before reading anything that it covers.
+static U_INLINE const char *pPtrLoad(const char * const *ppPtr)
+{
+    const char *pPtr = *((const char * const volatile *) ppPtr);
+
+    U_MEMORY_BARRIER();
+
+    return pPtr;
+}
+
+// Move a pointer of a lock-free ring buffer, after everything
+// that it covers has been written or read.
+static U_INLINE void ptrStore(const char **ppPtr, const char *pPtr)
+{
+    U_MEMORY_BARRIER();
+    *((const char * volatile *) ppPtr) = pPtr;
+}
+
+// Add data to a lock-free ring buffer: called only by the producer.
+// Account for an add after which used bytes are in the ring buffer,
+// as seen by the read pointer furthest behind; in the lock-free case
+// this is only called by the producer, else the ring buffer's mutex
+// should be locked before this is called.
+static void statOccupancyUpdate(uRingBuffer_t *pRingBuffer, size_t used)
+{
+    size_t bin = (used * U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) / pRingBuffer->size;
+
+    if (used > pRingBuffer->statHighWaterMarkBytes) {
+        pRingBuffer->statHighWaterMarkBytes = used;
+    }
+    if (bin >= U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) {
+        bin = U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS - 1;
+    }
+    pRingBuffer->statOccupancy[bin]++;
+}
+
+static bool addLockFree(uRingBuffer_t *pRingBuffer, const char *pData,
+                        size_t length)
+{
+    bool dataFitsInBuffer = false;
+    const char *pRead = pPtrLoad(pRingBuffer->pDataRead);
+    char *pWrite = pRingBuffer->pDataWrite;
+    size_t x;
+
+    // Plus one since the pointers must not overlap
+    if (ptrDiff(pRead, pWrite, pRingBuffer->size) + length + 1 <= pRingBuffer->size) {
+        // Copy in up to two pieces, either side of the wrap
+        x = (pRingBuffer->pBuffer + pRingBuffer->size) - pWrite;
+        if (x > length) {
+            x = length;
+        }
+        memcpy(pWrite, pData, x);
+        memcpy(pRingBuffer->pBuffer, pData + x, length - x);
+        pWrite = (char *) pPtrOffset(pWrite, length, pRingBuffer->pBuffer,
+                                     pRingBuffer->size);
+        ptrStore((const char **) &(pRingBuffer->pDataWrite), pWrite);
+        dataFitsInBuffer = true;
+        // The consumer can only have made more room since pRead was
+        // loaded, so this may slightly over-estimate the occupancy, erring
+        // on the safe side
+        statOccupancyUpdate(pRingBuffer, ptrDiff(pRead, pWrite, pRingBuffer->size));
+    } else {
+        pRingBuffer->statAddLossBytes += length;
+    }
+
+    return dataFitsInBuffer;
+}
+
+// Read or peek data from a lock-free ring buffer: called only by
+// the consumer.
+static size_t readLockFree(uRingBuffer_t *pRingBuffer, char *pData,
+                           size_t length, size_t offset, bool destructive)
+{
+    size_t bytesRead = 0;
+    const char *pWrite = pPtrLoad((const char **) &(pRingBuffer->pDataWrite));
+    const char *pSource = pRingBuffer->pDataRead[0];
+    size_t available = ptrDiff(pSource, (char *) pWrite, pRingBuffer->size);
+    size_t x;
+
+    if (offset < available) {
+        available -= offset;
+        pSource = pPtrOffset(pSource, offset, pRingBuffer->pBuffer,
+                             pRingBuffer->size);
+        if (length > available) {
+            length = available;
+        }
+        if (pData != NULL) {
+            // Copy out in up to two pieces, either side of the wrap
+            x = (pRingBuffer->pBuffer + pRingBuffer->size) - pSource;
+            if (x > length) {
+                x = length;
+            }
+            memcpy(pData, pSource, x);
+            memcpy(pData + x, pRingBuffer->pBuffer, length - x);
+        }
+        bytesRead = length;
+        if (destructive) {
+            ptrStore(pRingBuffer->pDataRead,
+                     pPtrOffset(pSource, length, pRingBuffer->pBuffer,
+                                pRingBuffer->size));
+        }
+    }
+
+    return bytesRead;
+}
+
+// Forget where the parsers of a read handle last needed more data;
+// the ring buffer's mutex should be locked before this is called.
+static void parserResumeClear(uRingBuffer_t *pRingBuffer, size_t handle)
+{
+    if (pRingBuffer->pParserState != NULL) {
+        pRingBuffer->pParserState[handle].pResumeFrom = NULL;
+        pRingBuffer->pParserState[handle].bytesNeeded = 0;
+    }
+}
+
 // The ring buffer's mutex should be locked before this is called
 static void bufferReset(uRingBuffer_t *pRingBuffer)
 {
@@ -128,6 +246,7 @@ static void bufferReset(uRingBuffer_t *pRingBuffer)
         if (pRingBuffer->pDataRead[x] != NULL) {
             pRingBuffer->pDataRead[x] = pRingBuffer->pBuffer;
         }
+        parserResumeClear(pRingBuffer, x);
     }
     pRingBuffer->pDataWrite = pRingBuffer->pBuffer;
     // The default handle-less read pointer can always be set
@@ -176,11 +295,39 @@ static size_t read(uRingBuffer_t *pRingBuffer, int32_t handle, char *pData,
     return bytesRead;
 }
 
+// Update the high water marks and the occupancy histogram after data
+// has been added.
 // The ring buffer's mutex should be locked before this is called
-static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
-                size_t length, bool destructive)
+static void statUpdate(uRingBuffer_t *pRingBuffer)
+{
+    size_t used;
+    size_t usedMax = 0;
+
+    for (size_t x = 0; x < pRingBuffer->maxNumReadPointers; x++) {
+        // As in availableSize(), ignore the "normal" read pointer if
+        // a read handle is required since nothing reads from it
+        if ((pRingBuffer->pDataRead[x] != NULL) &&
+            ((x > 0) || !pRingBuffer->readHandleRequired)) {
+            used = ptrDiff(pRingBuffer->pDataRead[x], pRingBuffer->pDataWrite, pRingBuffer->size);
+            if ((x > 0) && (pRingBuffer->statHighWaterMarkHandleBytes != NULL) &&
+                (used > pRingBuffer->statHighWaterMarkHandleBytes[x])) {
+                pRingBuffer->statHighWaterMarkHandleBytes[x] = used;
+            }
+            if (used > usedMax) {
+                usedMax = used;
+            }
+        }
+    }
+    statOccupancyUpdate(pRingBuffer, usedMax);
+}
+
+// Make room for length bytes at the write pointer, moving read
+// pointers on where that is permitted.
+// The ring buffer's mutex should be locked before this is called
+static bool makeRoom(uRingBuffer_t *pRingBuffer, size_t length, bool destructive)
 {
     bool dataFitsInBuffer = true;
+    bool evicted = false;
     size_t lost;
     size_t used;
 
@@ -205,6 +352,13 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
                         } else {
                             pRingBuffer->statReadLossBytes[x] += lost;
                         }
+                        // Nothing reads from the "normal" read pointer
+                        // if a read handle is required, so moving it
+                        // on is not an eviction
+                        if (destructive && (lost > 0) &&
+                            ((x > 0) || !pRingBuffer->readHandleRequired)) {
+                            evicted = true;
+                        }
                     } else {
                         dataFitsInBuffer = false;
                     }
@@ -212,6 +366,18 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
             }
         }
     }
+    if (evicted) {
+        pRingBuffer->statForcedAddEvictions++;
+    }
+
+    return dataFitsInBuffer;
+}
+
+// The ring buffer's mutex should be locked before this is called
+static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
+                size_t length, bool destructive)
+{
+    bool dataFitsInBuffer = makeRoom(pRingBuffer, length, destructive);
 
     if (dataFitsInBuffer) {
         while (length > 0) {
@@ -221,6 +387,7 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
             length--;
             pData++;
         }
+        statUpdate(pRingBuffer);
     } else {
         pRingBuffer->statAddLossBytes += length;
     }
@@ -228,6 +395,88 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
     return dataFitsInBuffer;
 }
 
+// Return the largest length that makeRoom() would succeed for.
+// The ring buffer's mutex should be locked before this is called
+static size_t roomMax(const uRingBuffer_t *pRingBuffer, bool destructive)
+{
+    size_t room = pRingBuffer->size - 1;
+    size_t y;
+    bool limiting;
+
+    for (size_t x = 0; x < pRingBuffer->maxNumReadPointers; x++) {
+        if (pRingBuffer->pDataRead[x] != NULL) {
+            // This follows the rules of makeRoom(): a destructive
+            // add is only held back by locked read pointers, a
+            // non-destructive one by all of them except the "normal"
+            // read pointer in the readHandleRequired case
+            if (destructive) {
+                limiting = (x > 0) && ((pRingBuffer->dataReadLockBitmap & (1ULL << (x - 1))) != 0);
+            } else {
+                limiting = (x > 0) || !pRingBuffer->readHandleRequired;
+            }
+            if (limiting) {
+                y = pRingBuffer->size - 1 - ptrDiff(pRingBuffer->pDataRead[x],
+                                                    pRingBuffer->pDataWrite,
+                                                    pRingBuffer->size);
+                if (y < room) {
+                    room = y;
+                }
+            }
+        }
+    }
+
+    return room;
+}
+
+// Reserve up to length contiguous bytes at the write pointer.
+// The ring buffer's mutex should be locked before this is called
+static size_t reserve(uRingBuffer_t *pRingBuffer, char **ppData, size_t length,
+                      bool destructive)
+{
+    size_t y = roomMax(pRingBuffer, destructive);
+
+    if (length > y) {
+        length = y;
+    }
+    // Only as far as the wrap
+    y = (pRingBuffer->pBuffer + pRingBuffer->size) - pRingBuffer->pDataWrite;
+    if (length > y) {
+        length = y;
+    }
+    if ((length > 0) && makeRoom(pRingBuffer, length, destructive)) {
+        *ppData = pRingBuffer->pDataWrite;
+    } else {
+        length = 0;
+    }
+
+    return length;
+}
+
+// Fill in the (up to two) spans covering the data between pRead
+// and pWrite, returning the total length.
+static size_t spans(const uRingBuffer_t *pRingBuffer, const char *pRead,
+                    const char *pWrite, uRingBufferSpan_t *pSpans)
+{
+    size_t length = ptrDiff(pRead, (char *) pWrite, pRingBuffer->size);
+    size_t y = (pRingBuffer->pBuffer + pRingBuffer->size) - pRead;
+
+    pSpans->pData = pRead;
+    pSpans->length = length;
+    (pSpans + 1)->pData = NULL;
+    (pSpans + 1)->length = 0;
+    if (length > y) {
+        // The rest is after the wrap
+        pSpans->length = y;
+        (pSpans + 1)->pData = pRingBuffer->pBuffer;
+        (pSpans + 1)->length = length - y;
+    }
+    if (length == 0) {
+        pSpans->pData = NULL;
+    }
+
+    return length;
+}
+
 // This function does the ring buffer mutex locking itself.
 static size_t lock(uRingBuffer_t *pRingBuffer, int32_t handle, bool lockNotUnlock)
 {
@@ -259,7 +508,15 @@ static size_t availableSize(const uRingBuffer_t *pRingBuffer, bool max)
     size_t y = 0;
     bool foundADataReadPointer = false;
 
-    if (pRingBuffer->pBuffer != NULL) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        // Just the one read pointer, which can't be locked
+        size = pRingBuffer->size - 1;
+        if (!max) {
+            size -= ptrDiff(pPtrLoad(pRingBuffer->pDataRead),
+                            (char *) pPtrLoad((const char * const *) &(pRingBuffer->pDataWrite)),
+                            pRingBuffer->size);
+        }
+    } else if (pRingBuffer->pBuffer != NULL) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -342,6 +599,77 @@ static void printPointer(const char *pTitle, const char *pBuffer, size_t bufferS
     uPortLog("\n");
 }
 
+// Run a list of parsers over the data of a read handle; if pState
+// is not NULL it is used to avoid re-parsing a message that is not
+// yet complete. The ring buffer's mutex should be locked before
+// this is called.
+static size_t parse(uRingBuffer_t *pRingBuffer, int32_t handle,
+                    U_RING_BUFFER_PARSER_f *pParserList,
+                    uRingBufferParserState_t *pState, void *pUserParam)
+{
+    const char *pOffset = pPtrOffset(pRingBuffer->pDataRead[handle], 0, pRingBuffer->pBuffer,
+                                     pRingBuffer->size);
+    size_t bytesAvailable = ptrDiff(pOffset, pRingBuffer->pDataWrite, pRingBuffer->size);
+    size_t bytesDiscard  = 0;
+    size_t bytesNeeded = 0;
+    size_t errorCodeOrLength = U_ERROR_COMMON_TIMEOUT;
+
+    if ((pState != NULL) && (pState->pResumeFrom == pOffset) &&
+        (pState->resumeReadLossBytes == pRingBuffer->statReadLossBytes[handle]) &&
+        (bytesAvailable < pState->bytesNeeded)) {
+        // Still waiting for the rest of a message, nothing to do
+        bytesAvailable = 0;
+    } else if (pState != NULL) {
+        pState->pResumeFrom = NULL;
+    }
+    while (bytesAvailable) {
+        U_RING_BUFFER_PARSER_f *pParser = pParserList;
+        // find the right protocol
+        errorCodeOrLength = U_ERROR_COMMON_NOT_FOUND;
+        while (*pParser) {
+            uRingBufferParseContext_t ctx = {
+                .pRingBuffer    = pRingBuffer,
+                .pSource        = pOffset,
+                .bytesAvailable = bytesAvailable,
+                .bytesParsed    = 0,
+                .bytesNeeded    = 0
+            };
+            errorCodeOrLength = (*pParser)(&ctx, pUserParam);
+            pParser ++;
+            if (errorCodeOrLength == U_ERROR_COMMON_SUCCESS) {
+                errorCodeOrLength = ctx.bytesParsed;
+            }
+            if (errorCodeOrLength != U_ERROR_COMMON_NOT_FOUND) {
+                bytesNeeded = ctx.bytesNeeded;
+                break;
+            }
+        }
+        if (errorCodeOrLength != U_ERROR_COMMON_NOT_FOUND) {
+            break;
+        }
+        pOffset = pPtrInc(pOffset, pRingBuffer->pBuffer, pRingBuffer->size);
+        bytesDiscard ++;
+        bytesAvailable --;
+    }
+    if ((pState != NULL) && (bytesAvailable > 0) &&
+        (errorCodeOrLength == U_ERROR_COMMON_TIMEOUT)) {
+        // Remember where the parsers need more data and, if they
+        // didn't say how much, make it any more at all
+        if (bytesNeeded <= bytesAvailable) {
+            bytesNeeded = bytesAvailable + 1;
+        }
+        pState->pResumeFrom = pOffset;
+        pState->resumeReadLossBytes = pRingBuffer->statReadLossBytes[handle];
+        pState->bytesNeeded = bytesNeeded;
+    }
+    //
+    if (bytesDiscard > 0) {
+        errorCodeOrLength = bytesDiscard;
+    }
+
+    return errorCodeOrLength;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: DEBUG
  * -------------------------------------------------------------- */
@@ -401,16 +729,24 @@ int32_t uRingBufferCreate(uRingBuffer_t *pRingBuffer, char *pLinearBuffer, size_
 
 void uRingBufferDelete(uRingBuffer_t *pRingBuffer)
 {
-    if ((pRingBuffer != NULL) && (pRingBuffer->mutex != NULL)) {
+    if ((pRingBuffer != NULL) &&
+        ((pRingBuffer->mutex != NULL) || pRingBuffer->lockFree)) {
         if (pRingBuffer->isMalloced) {
             free(pRingBuffer->pDataRead);
             pRingBuffer->pDataRead = NULL;
             free(pRingBuffer->statReadLossBytes);
             pRingBuffer->statReadLossBytes = NULL;
+            free(pRingBuffer->statHighWaterMarkHandleBytes);
+            pRingBuffer->statHighWaterMarkHandleBytes = NULL;
+            free(pRingBuffer->pParserState);
+            pRingBuffer->pParserState = NULL;
         }
         pRingBuffer->maxNumReadPointers = 0;
-        uPortMutexDelete((uPortMutexHandle_t) pRingBuffer->mutex);
-        pRingBuffer->mutex = NULL;
+        if (pRingBuffer->mutex != NULL) {
+            uPortMutexDelete((uPortMutexHandle_t) pRingBuffer->mutex);
+            pRingBuffer->mutex = NULL;
+        }
+        pRingBuffer->lockFree = false;
         pRingBuffer->pBuffer = NULL;
     }
 }
@@ -419,7 +755,9 @@ bool uRingBufferAdd(uRingBuffer_t *pRingBuffer, const char *pData, size_t length
 {
     bool dataFitsInBuffer = false;
 
-    if (pRingBuffer->pBuffer != NULL) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        dataFitsInBuffer = addLockFree(pRingBuffer, pData, length);
+    } else if (pRingBuffer->pBuffer != NULL) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -435,7 +773,9 @@ bool uRingBufferForceAdd(uRingBuffer_t *pRingBuffer, const char *pData, size_t l
 {
     bool dataFitsInBuffer = false;
 
-    if (pRingBuffer->pBuffer != NULL) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        dataFitsInBuffer = addLockFree(pRingBuffer, pData, length);
+    } else if (pRingBuffer->pBuffer != NULL) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -451,7 +791,9 @@ size_t uRingBufferRead(uRingBuffer_t *pRingBuffer, char *pData, size_t length)
 {
     size_t bytesRead = 0;
 
-    if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        bytesRead = readLockFree(pRingBuffer, pData, length, 0, true);
+    } else if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -468,7 +810,9 @@ size_t uRingBufferPeek(uRingBuffer_t *pRingBuffer, char *pData, size_t length,
 {
     size_t bytesRead = 0;
 
-    if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        bytesRead = readLockFree(pRingBuffer, pData, length, offset, false);
+    } else if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -484,7 +828,11 @@ size_t uRingBufferDataSize(const uRingBuffer_t *pRingBuffer)
 {
     size_t dataSize = 0;
 
-    if (pRingBuffer->pBuffer != NULL) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        dataSize = ptrDiff(pPtrLoad(pRingBuffer->pDataRead),
+                           (char *) pPtrLoad((const char * const *) &(pRingBuffer->pDataWrite)),
+                           pRingBuffer->size);
+    } else if (pRingBuffer->pBuffer != NULL) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -506,7 +854,10 @@ size_t uRingBufferAvailableSize(const uRingBuffer_t *pRingBuffer)
 
 void uRingBufferFlush(uRingBuffer_t *pRingBuffer)
 {
-    if (pRingBuffer->pBuffer != NULL) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        ptrStore(pRingBuffer->pDataRead,
+                 pPtrLoad((const char * const *) &(pRingBuffer->pDataWrite)));
+    } else if (pRingBuffer->pBuffer != NULL) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -518,7 +869,10 @@ void uRingBufferFlush(uRingBuffer_t *pRingBuffer)
 
 void uRingBufferReset(uRingBuffer_t *pRingBuffer)
 {
-    if (pRingBuffer->pBuffer != NULL) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        // Neither side may be active, no need for barriers
+        bufferReset(pRingBuffer);
+    } else if (pRingBuffer->pBuffer != NULL) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -532,7 +886,10 @@ size_t uRingBufferStatReadLoss(uRingBuffer_t *pRingBuffer)
 {
     size_t bytesLost = 0;
 
-    if (pRingBuffer->pBuffer != NULL) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        // Nothing can push data out from under the consumer
+        bytesLost = pRingBuffer->statReadLossNormalBytes;
+    } else if (pRingBuffer->pBuffer != NULL) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -548,7 +905,10 @@ size_t uRingBufferStatAddLoss(uRingBuffer_t *pRingBuffer)
 {
     size_t bytesLost = 0;
 
-    if (pRingBuffer->pBuffer != NULL) {
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        // Only the producer writes this
+        bytesLost = *((volatile size_t *) &(pRingBuffer->statAddLossBytes));
+    } else if (pRingBuffer->pBuffer != NULL) {
 
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
@@ -560,6 +920,103 @@ size_t uRingBufferStatAddLoss(uRingBuffer_t *pRingBuffer)
     return bytesLost;
 }
 
+size_t uRingBufferStatHighWaterMark(uRingBuffer_t *pRingBuffer)
+{
+    size_t highWaterMark = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        // Only the producer writes this
+        highWaterMark = *((volatile size_t *) &(pRingBuffer->statHighWaterMarkBytes));
+    } else if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        highWaterMark = pRingBuffer->statHighWaterMarkBytes;
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return highWaterMark;
+}
+
+size_t uRingBufferStatForcedAddEvictions(uRingBuffer_t *pRingBuffer)
+{
+    size_t evictions = 0;
+
+    // Nothing is evicted in the lock-free case, a forced add
+    // being just an add
+    if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->lockFree) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        evictions = pRingBuffer->statForcedAddEvictions;
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return evictions;
+}
+
+size_t uRingBufferStatOccupancy(uRingBuffer_t *pRingBuffer, size_t *pBins,
+                                size_t numBins)
+{
+    size_t numBinsWritten = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+        numBinsWritten = numBins;
+        if (numBinsWritten > U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) {
+            numBinsWritten = U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS;
+        }
+        if (pRingBuffer->lockFree) {
+            // Only the producer writes these, the counts may
+            // just be one add apart from each other
+            memcpy(pBins, pRingBuffer->statOccupancy, numBinsWritten * sizeof(size_t));
+        } else {
+
+            U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+            memcpy(pBins, pRingBuffer->statOccupancy, numBinsWritten * sizeof(size_t));
+
+            U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        }
+        memset(pBins + numBinsWritten, 0, (numBins - numBinsWritten) * sizeof(size_t));
+    }
+
+    return numBinsWritten;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: LOCK-FREE
+ * -------------------------------------------------------------- */
+
+int32_t uRingBufferCreateLockFree(uRingBuffer_t *pRingBuffer, char *pLinearBuffer,
+                                  size_t size)
+{
+    memset(pRingBuffer, 0x00, sizeof(uRingBuffer_t));
+    // As uRingBufferCreate() but with no mutex
+    pRingBuffer->pDataRead = &(pRingBuffer->pDataReadNormal);
+    pRingBuffer->maxNumReadPointers = 1;
+    pRingBuffer->isMalloced = false;
+    pRingBuffer->lockFree = true;
+    pRingBuffer->pBuffer = pLinearBuffer;
+    pRingBuffer->size = size;
+    bufferReset(pRingBuffer);
+
+    return (int32_t) U_ERROR_COMMON_SUCCESS;
+}
+
+bool uRingBufferAddIrq(uRingBuffer_t *pRingBuffer, const char *pData,
+                       size_t length)
+{
+    bool dataFitsInBuffer = false;
+
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        dataFitsInBuffer = addLockFree(pRingBuffer, pData, length);
+    }
+
+    return dataFitsInBuffer;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MULTIPLE READERS
  * -------------------------------------------------------------- */
@@ -573,13 +1030,17 @@ int32_t uRingBufferCreateWithReadHandle(uRingBuffer_t *pRingBuffer, char *pLinea
     maxNumReadHandles++; // Add one more for the non-handled read
     pRingBuffer->pDataRead = (const char **) malloc((maxNumReadHandles) * sizeof(const char *));
     pRingBuffer->statReadLossBytes = (size_t *) malloc((maxNumReadHandles) * sizeof(size_t));
+    pRingBuffer->statHighWaterMarkHandleBytes = (size_t *) malloc((maxNumReadHandles) *
+                                                                  sizeof(size_t));
     if ((pRingBuffer->pDataRead != NULL) && (pRingBuffer->statReadLossBytes != NULL) &&
+        (pRingBuffer->statHighWaterMarkHandleBytes != NULL) &&
         (maxNumReadHandles < (sizeof(pRingBuffer->dataReadLockBitmap) * 8))) {
         pRingBuffer->isMalloced = true;
         pRingBuffer->maxNumReadPointers = maxNumReadHandles;
         for (size_t x = 0; x < pRingBuffer->maxNumReadPointers; x++) {
             pRingBuffer->pDataRead[x] = NULL;
             pRingBuffer->statReadLossBytes[x] = 0;
+            pRingBuffer->statHighWaterMarkHandleBytes[x] = 0;
         }
         errorCode = createCommon(pRingBuffer, pLinearBuffer, size);
     }
@@ -588,6 +1049,8 @@ int32_t uRingBufferCreateWithReadHandle(uRingBuffer_t *pRingBuffer, char *pLinea
         pRingBuffer->pDataRead = NULL;
         free(pRingBuffer->statReadLossBytes);
         pRingBuffer->statReadLossBytes = NULL;
+        free(pRingBuffer->statHighWaterMarkHandleBytes);
+        pRingBuffer->statHighWaterMarkHandleBytes = NULL;
         pRingBuffer->maxNumReadPointers = 0;
     }
 
@@ -633,6 +1096,7 @@ int32_t uRingBufferTakeReadHandle(uRingBuffer_t *pRingBuffer)
             if (pRingBuffer->pDataRead[x] == NULL) {
                 pRingBuffer->pDataRead[x] = pRingBuffer->pDataWrite;
                 pRingBuffer->statReadLossBytes[x] = 0;
+                pRingBuffer->statHighWaterMarkHandleBytes[x] = 0;
                 readHandle = x;
             }
         }
@@ -652,6 +1116,10 @@ void uRingBufferGiveReadHandle(uRingBuffer_t *pRingBuffer, int32_t handle)
         if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers)) {
             pRingBuffer->pDataRead[handle] = NULL;
             pRingBuffer->dataReadLockBitmap &= ~(1ULL << (handle - 1));
+            parserResumeClear(pRingBuffer, handle);
+            if (pRingBuffer->pParserState != NULL) {
+                pRingBuffer->pParserState[handle].pParserList = NULL;
+            }
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
@@ -724,6 +1192,41 @@ size_t uRingBufferPeekHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
     return bytesRead;
 }
 
+size_t uRingBufferPeekContiguousHandle(uRingBuffer_t *pRingBuffer,
+                                       int32_t handle,
+                                       const char **ppData,
+                                       size_t offset)
+{
+    size_t length = 0;
+    size_t available;
+    const char *pSource;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            available = ptrDiff(pRingBuffer->pDataRead[handle], pRingBuffer->pDataWrite,
+                                pRingBuffer->size);
+            if (offset < available) {
+                pSource = pPtrOffset(pRingBuffer->pDataRead[handle], offset,
+                                     pRingBuffer->pBuffer, pRingBuffer->size);
+                length = available - offset;
+                if (pSource + length > pRingBuffer->pBuffer + pRingBuffer->size) {
+                    // Only as far as the wrap
+                    length = (pRingBuffer->pBuffer + pRingBuffer->size) - pSource;
+                }
+                *ppData = pSource;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return length;
+}
+
 size_t uRingBufferDataSizeHandle(const uRingBuffer_t *pRingBuffer, int32_t handle)
 {
     size_t dataSize = 0;
@@ -757,6 +1260,7 @@ void uRingBufferFlushHandle(uRingBuffer_t *pRingBuffer, int32_t handle)
         if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
             (pRingBuffer->pDataRead[handle] != NULL)) {
             pRingBuffer->pDataRead[handle] = pRingBuffer->pDataWrite;
+            parserResumeClear(pRingBuffer, handle);
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
@@ -783,6 +1287,201 @@ size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
     return bytesLost;
 }
 
+size_t uRingBufferStatHighWaterMarkHandle(uRingBuffer_t *pRingBuffer,
+                                          int32_t handle)
+{
+    size_t highWaterMark = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            highWaterMark = pRingBuffer->statHighWaterMarkHandleBytes[handle];
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return highWaterMark;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: ZERO-COPY
+ * -------------------------------------------------------------- */
+
+size_t uRingBufferPeekSpans(uRingBuffer_t *pRingBuffer, uRingBufferSpan_t *pSpans)
+{
+    size_t length = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        length = spans(pRingBuffer, pRingBuffer->pDataRead[0],
+                       pPtrLoad((const char * const *) &(pRingBuffer->pDataWrite)),
+                       pSpans);
+    } else if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        length = spans(pRingBuffer, pRingBuffer->pDataRead[0],
+                       pRingBuffer->pDataWrite, pSpans);
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return length;
+}
+
+size_t uRingBufferReadCommit(uRingBuffer_t *pRingBuffer, size_t length)
+{
+    size_t bytesRead = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        bytesRead = readLockFree(pRingBuffer, NULL, length, 0, true);
+    } else if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        bytesRead = read(pRingBuffer, 0, NULL, length, 0, true);
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return bytesRead;
+}
+
+size_t uRingBufferPeekSpansHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  uRingBufferSpan_t *pSpans)
+{
+    size_t length = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            length = spans(pRingBuffer, pRingBuffer->pDataRead[handle],
+                           pRingBuffer->pDataWrite, pSpans);
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return length;
+}
+
+size_t uRingBufferReadCommitHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                   size_t length)
+{
+    size_t bytesRead = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if (handle >= 1) {
+            bytesRead = read(pRingBuffer, handle, NULL, length, 0, true);
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return bytesRead;
+}
+
+size_t uRingBufferWriteReserve(uRingBuffer_t *pRingBuffer, char **ppData,
+                               size_t length)
+{
+    size_t reserved = 0;
+    const char *pRead;
+
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        // Called only by the producer, the write pointer is ours
+        pRead = pPtrLoad(pRingBuffer->pDataRead);
+        reserved = pRingBuffer->size - 1 - ptrDiff(pRead, pRingBuffer->pDataWrite,
+                                                   pRingBuffer->size);
+        if (reserved > (size_t) ((pRingBuffer->pBuffer + pRingBuffer->size) - pRingBuffer->pDataWrite)) {
+            reserved = (pRingBuffer->pBuffer + pRingBuffer->size) - pRingBuffer->pDataWrite;
+        }
+        if (reserved > length) {
+            reserved = length;
+        }
+        if (reserved > 0) {
+            *ppData = pRingBuffer->pDataWrite;
+        }
+    } else if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        reserved = reserve(pRingBuffer, ppData, length, false);
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return reserved;
+}
+
+size_t uRingBufferForceWriteReserve(uRingBuffer_t *pRingBuffer, char **ppData,
+                                    size_t length)
+{
+    size_t reserved = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        // The producer can't move the consumer's read pointer
+        reserved = uRingBufferWriteReserve(pRingBuffer, ppData, length);
+    } else if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        reserved = reserve(pRingBuffer, ppData, length, true);
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return reserved;
+}
+
+bool uRingBufferWriteCommit(uRingBuffer_t *pRingBuffer, size_t length)
+{
+    bool committed = false;
+    char *pWrite;
+
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->lockFree) {
+        if (length <= (size_t) ((pRingBuffer->pBuffer + pRingBuffer->size) - pRingBuffer->pDataWrite)) {
+            // Reads only ever make more room, so whatever was
+            // reserved is still there
+            pWrite = (char *) pPtrOffset(pRingBuffer->pDataWrite, length,
+                                         pRingBuffer->pBuffer, pRingBuffer->size);
+            ptrStore((const char **) &(pRingBuffer->pDataWrite), pWrite);
+            committed = true;
+            statOccupancyUpdate(pRingBuffer, ptrDiff(pPtrLoad(pRingBuffer->pDataRead),
+                                                     pWrite, pRingBuffer->size));
+        }
+    } else if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        // The data is already in place, just make sure that no read
+        // pointer, e.g. one taken since the reservation, would be
+        // overrun by moving the write pointer on
+        if ((length <= (size_t) ((pRingBuffer->pBuffer + pRingBuffer->size) - pRingBuffer->pDataWrite)) &&
+            makeRoom(pRingBuffer, length, false)) {
+            pRingBuffer->pDataWrite = (char *) pPtrOffset(pRingBuffer->pDataWrite, length,
+                                                          pRingBuffer->pBuffer,
+                                                          pRingBuffer->size);
+            committed = true;
+            statUpdate(pRingBuffer);
+        } else {
+            pRingBuffer->statAddLossBytes += length;
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return committed;
+}
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: PARSER
  * -------------------------------------------------------------- */
@@ -795,48 +1494,78 @@ size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
         if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
             (pRingBuffer->pDataRead[handle] != NULL)) {
-            const char *pOffset = pPtrOffset(pRingBuffer->pDataRead[handle], 0, pRingBuffer->pBuffer,
-                                             pRingBuffer->size);
-            size_t bytesAvailable = ptrDiff(pOffset, pRingBuffer->pDataWrite, pRingBuffer->size);
-            size_t bytesDiscard  = 0;
-            errorCodeOrLength = U_ERROR_COMMON_TIMEOUT;
-            while (bytesAvailable) {
-                U_RING_BUFFER_PARSER_f *pParser = pParserList;
-                // find the right protocol
-                errorCodeOrLength = U_ERROR_COMMON_NOT_FOUND;
-                while (*pParser) {
-                    uRingBufferParseContext_t ctx = {
-                        .pRingBuffer    = pRingBuffer,
-                        .pSource        = pOffset,
-                        .bytesAvailable = bytesAvailable,
-                        .bytesParsed    = 0
-                    };
-                    errorCodeOrLength = (*pParser)(&ctx, pUserParam);
-                    pParser ++;
-                    if (errorCodeOrLength == U_ERROR_COMMON_SUCCESS) {
-                        errorCodeOrLength = ctx.bytesParsed;
-                    }
-                    if (errorCodeOrLength != U_ERROR_COMMON_NOT_FOUND) {
-                        break;
-                    }
-                }
-                if (errorCodeOrLength != U_ERROR_COMMON_NOT_FOUND) {
-                    break;
+            errorCodeOrLength = parse(pRingBuffer, handle, pParserList, NULL, pUserParam);
+        }
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+    return errorCodeOrLength;
+}
+
+int32_t uRingBufferParserRegister(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  U_RING_BUFFER_PARSER_f *pParserList)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uRingBufferParserState_t *pState;
+
+    if ((pRingBuffer->pBuffer != NULL) && pRingBuffer->isMalloced) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            if (pRingBuffer->pParserState == NULL) {
+                pRingBuffer->pParserState = (uRingBufferParserState_t *) malloc(
+                                                pRingBuffer->maxNumReadPointers *
+                                                sizeof(uRingBufferParserState_t));
+                if (pRingBuffer->pParserState != NULL) {
+                    memset(pRingBuffer->pParserState, 0,
+                           pRingBuffer->maxNumReadPointers * sizeof(uRingBufferParserState_t));
                 }
-                pOffset = pPtrInc(pOffset, pRingBuffer->pBuffer, pRingBuffer->size);
-                bytesDiscard ++;
-                bytesAvailable --;
             }
-            //
-            if (bytesDiscard > 0) {
-                errorCodeOrLength = bytesDiscard;
+            if (pRingBuffer->pParserState != NULL) {
+                pState = &(pRingBuffer->pParserState[handle]);
+                if (pState->pParserList != pParserList) {
+                    parserResumeClear(pRingBuffer, handle);
+                    pState->pParserList = pParserList;
+                }
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
             }
         }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return errorCode;
+}
+
+size_t uRingBufferParseRegistered(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  void *pUserParam)
+{
+    size_t errorCodeOrLength = U_ERROR_COMMON_INVALID_PARAMETER;
+    uRingBufferParserState_t *pState;
+
+    if (pRingBuffer->pBuffer != NULL) {
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL) &&
+            (pRingBuffer->pParserState != NULL) &&
+            (pRingBuffer->pParserState[handle].pParserList != NULL)) {
+            pState = &(pRingBuffer->pParserState[handle]);
+            errorCodeOrLength = parse(pRingBuffer, handle, pState->pParserList,
+                                      pState, pUserParam);
+        }
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
     }
     return errorCodeOrLength;
 }
 
+void uRingBufferParseNeedBytesUnprotected(uParseHandle_t parseHandle,
+                                          size_t moreBytes)
+{
+    uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
+    pCtx->bytesNeeded = pCtx->bytesParsed + moreBytes;
+}
 
 bool uRingBufferGetByteUnprotected(uParseHandle_t parseHandle, void *p)
 {
@@ -852,6 +1581,26 @@ bool uRingBufferGetByteUnprotected(uParseHandle_t parseHandle, void *p)
     return true;
 }
 
+size_t uRingBufferGetBytesUnprotected(uParseHandle_t parseHandle,
+                                      const char **ppData, size_t size)
+{
+    uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
+    const char *pEnd = pCtx->pRingBuffer->pBuffer + pCtx->pRingBuffer->size;
+    if (size > pCtx->bytesAvailable) {
+        size = pCtx->bytesAvailable;
+    }
+    // Only up to the wrap
+    if (size > (size_t) (pEnd - pCtx->pSource)) {
+        size = pEnd - pCtx->pSource;
+    }
+    *ppData = pCtx->pSource;
+    pCtx->pSource = pPtrOffset(pCtx->pSource, size, pCtx->pRingBuffer->pBuffer,
+                               pCtx->pRingBuffer->size);
+    pCtx->bytesParsed += size;
+    pCtx->bytesAvailable -= size;
+    return size;
+}
+
 size_t uRingBufferBytesAvailableUnprotected(uParseHandle_t parseHandle)
 {
     uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
@@ -37,6 +37,22 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The number of seconds in a day.
+ */
+#define U_TIME_SECONDS_PER_DAY (3600 * 24)
+
+/** The number of bits of gMonthCache that hold the number of days
+ * from the start of 1970 to the start of the cached month; the
+ * upper bits hold the month, counting from January 1970.
+ */
+#define U_TIME_MONTH_CACHE_DAYS_BITS 17
+
+/** The number of months that gMonthCache covers, limited so that
+ * the number of days to the start of the last of them fits into
+ * #U_TIME_MONTH_CACHE_DAYS_BITS.
+ */
+#define U_TIME_MONTH_CACHE_NUM_MONTHS 4096
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -48,14 +64,105 @@
 static const char gDaysInMonth[] = {31, 28, 31, 30, 31, 30, 31,
                                     31, 30, 31, 30, 31
                                    };
-static const char gDaysInMonthLeapYear[] = {31, 29, 31, 30, 31, 30,
-                                            31, 31, 30, 31, 30, 31
-                                           };
+
+/** The most recently converted month, if it is between 1970 and
+ * 2311: the month counting from January 1970 in the upper bits and the days from the start of 1970
+ * to the start of that month in the lower
+ * #U_TIME_MONTH_CACHE_DAYS_BITS; packed into a single 32-bit word so
+ * that it is always read and written in one go, no matter which
+ * tasks are converting times.  Zero, the initial value, is January
+ * 1970, which is correct.
+ */
+static volatile uint32_t gMonthCache = 0;
 
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Divide, rounding towards minus infinity.
+static int32_t divFloor(int32_t numerator, int32_t denominator)
+{
+    int32_t quotient = numerator / denominator;
+
+    if ((numerator % denominator) < 0) {
+        quotient--;
+    }
+
+    return quotient;
+}
+
+// The number of days from 1 January 1970 to the given date, where
+// month is 1 to 12; this is the "days_from_civil" algorithm of
+// Howard Hinnant, which works in eras of 400 years (146097 days)
+// with a year that starts on 1 March so that the leap day is last.
+static int32_t daysFromCivil(int32_t year, int32_t month, int32_t day)
+{
+    int32_t era;
+    int32_t yearOfEra;
+    int32_t dayOfYear;
+    int32_t dayOfEra;
+
+    if (month <= 2) {
+        year--;
+    }
+    era = divFloor(year, 400);
+    yearOfEra = year - (era * 400);                             // 0 to 399
+    if (month > 2) {
+        month -= 3;
+    } else {
+        month += 9;
+    }
+    dayOfYear = (((153 * month) + 2) / 5) + day - 1;            // 0 to 365
+    dayOfEra = (yearOfEra * 365) + (yearOfEra / 4) - (yearOfEra / 100) +
+               dayOfYear;                                       // 0 to 146096
+
+    // 719468 is the number of days from 1 March of the year 0
+    // to 1 January 1970
+    return (era * 146097) + dayOfEra - 719468;
+}
+
+// The inverse of daysFromCivil(), "civil_from_days".
+static void civilFromDays(int32_t days, uTimeDateTime_t *pDateTime)
+{
+    int32_t era;
+    int32_t dayOfEra;
+    int32_t yearOfEra;
+    int32_t dayOfYear;
+    int32_t monthFromMarch;
+
+    days += 719468;
+    era = divFloor(days, 146097);
+    dayOfEra = days - (era * 146097);                           // 0 to 146096
+    yearOfEra = (dayOfEra - (dayOfEra / 1460) + (dayOfEra / 36524) -
+                 (dayOfEra / 146096)) / 365;                    // 0 to 399
+    dayOfYear = dayOfEra - ((yearOfEra * 365) + (yearOfEra / 4) -
+                            (yearOfEra / 100));                 // 0 to 365
+    monthFromMarch = ((5 * dayOfYear) + 2) / 153;               // 0 to 11
+    pDateTime->day = dayOfYear - (((153 * monthFromMarch) + 2) / 5) + 1;
+    if (monthFromMarch < 10) {
+        pDateTime->month = monthFromMarch + 3;
+    } else {
+        pDateTime->month = monthFromMarch - 9;
+    }
+    pDateTime->year = yearOfEra + (era * 400);
+    if (pDateTime->month <= 2) {
+        pDateTime->year++;
+    }
+}
+
+// The number of days in the given month, counting from January 1970.
+static int32_t daysInMonth(int32_t monthsUtc)
+{
+    int32_t month = monthsUtc % 12;
+    int32_t days = gDaysInMonth[month];
+
+    if ((month == 1) && uTimeIsLeapYear((monthsUtc / 12) + 1970)) {
+        days++;
+    }
+
+    return days;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -66,7 +173,7 @@ bool uTimeIsLeapYear(int32_t year)
 
     if (year % 400 == 0) {
         isLeapYear = true;
-    } else if (year % 4 == 0) {
+    } else if ((year % 4 == 0) && (year % 100 != 0)) {
         isLeapYear = true;
     }
 
@@ -77,15 +184,90 @@ int64_t uTimeMonthsToSecondsUtc(int32_t monthsUtc)
 {
     int64_t secondsUtc = 0;
 
-    for (int32_t x = 0; x < monthsUtc; x++) {
-        if (uTimeIsLeapYear((x / 12) + 1970)) {
-            secondsUtc += gDaysInMonthLeapYear[x % 12] * 3600 * 24;
+    if (monthsUtc > 0) {
+        secondsUtc = ((int64_t) uTimeDaysFromDate(1970, monthsUtc + 1, 1)) *
+                     U_TIME_SECONDS_PER_DAY;
+    }
+
+    return secondsUtc;
+}
+
+int32_t uTimeDaysFromDate(int32_t year, int32_t month, int32_t day)
+{
+    int32_t monthsUtc;
+    int32_t days;
+    uint32_t cache;
+
+    // Bring the month into range
+    month--;
+    year += divFloor(month, 12);
+    month -= divFloor(month, 12) * 12;
+    monthsUtc = ((year - 1970) * 12) + month;
+    if ((monthsUtc >= 0) && (monthsUtc < (int32_t) U_TIME_MONTH_CACHE_NUM_MONTHS)) {
+        cache = gMonthCache;
+        if ((int32_t) (cache >> U_TIME_MONTH_CACHE_DAYS_BITS) == monthsUtc) {
+            days = (int32_t) (cache & ((1UL << U_TIME_MONTH_CACHE_DAYS_BITS) - 1));
         } else {
-            secondsUtc += gDaysInMonth[x % 12] * 3600 * 24;
+            days = daysFromCivil(year, month + 1, 1);
+            gMonthCache = (((uint32_t) monthsUtc) << U_TIME_MONTH_CACHE_DAYS_BITS) |
+                          (uint32_t) days;
         }
+        days += day - 1;
+    } else {
+        days = daysFromCivil(year, month + 1, day);
     }
 
+    return days;
+}
+
+int64_t uTimeToSecondsUtc(const uTimeDateTime_t *pDateTime)
+{
+    int64_t secondsUtc;
+
+    secondsUtc = ((int64_t) uTimeDaysFromDate(pDateTime->year, pDateTime->month,
+                                              pDateTime->day)) * U_TIME_SECONDS_PER_DAY;
+    secondsUtc += ((int64_t) pDateTime->hour) * 3600;
+    secondsUtc += ((int64_t) pDateTime->minute) * 60;
+    secondsUtc += pDateTime->second;
+
     return secondsUtc;
 }
 
+void uTimeFromSecondsUtc(int64_t secondsUtc, uTimeDateTime_t *pDateTime)
+{
+    int64_t days64 = secondsUtc / U_TIME_SECONDS_PER_DAY;
+    int32_t secondsOfDay = (int32_t) (secondsUtc - (days64 * U_TIME_SECONDS_PER_DAY));
+    int32_t days;
+    int32_t monthStartDays;
+    int32_t monthsUtc;
+    uint32_t cache;
+
+    if (secondsOfDay < 0) {
+        secondsOfDay += U_TIME_SECONDS_PER_DAY;
+        days64--;
+    }
+    days = (int32_t) days64;
+    pDateTime->hour = secondsOfDay / 3600;
+    pDateTime->minute = (secondsOfDay % 3600) / 60;
+    pDateTime->second = secondsOfDay % 60;
+
+    cache = gMonthCache;
+    monthsUtc = (int32_t) (cache >> U_TIME_MONTH_CACHE_DAYS_BITS);
+    monthStartDays = (int32_t) (cache & ((1UL << U_TIME_MONTH_CACHE_DAYS_BITS) - 1));
+    if ((days >= monthStartDays) &&
+        (days < monthStartDays + daysInMonth(monthsUtc))) {
+        // In the cached month
+        pDateTime->year = (monthsUtc / 12) + 1970;
+        pDateTime->month = (monthsUtc % 12) + 1;
+        pDateTime->day = days - monthStartDays + 1;
+    } else {
+        civilFromDays(days, pDateTime);
+        monthsUtc = ((pDateTime->year - 1970) * 12) + pDateTime->month - 1;
+        if ((monthsUtc >= 0) && (monthsUtc < (int32_t) U_TIME_MONTH_CACHE_NUM_MONTHS)) {
+            gMonthCache = (((uint32_t) monthsUtc) << U_TIME_MONTH_CACHE_DAYS_BITS) |
+                          (uint32_t) (days - pDateTime->day + 1);
+        }
+    }
+}
+
 // End of file
@@ -0,0 +1,453 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the timer wheel API.
+ *
+ * Design note: this is the classic hierarchical timer wheel.  A timer
+ * due within 2 ^ U_TIMER_WHEEL_LEVEL_BITS ticks goes into the slot of
+ * level 0 indexed by the bottom bits of its expiry tick, one due later
+ * into the slot of the first level that can reach it, indexed by the
+ * next U_TIMER_WHEEL_LEVEL_BITS bits of its expiry tick, and so on.
+ * Each time the bottom bits of the current tick wrap to zero the next
+ * slot of level 1 is "cascaded", its timers being put back into the
+ * wheel, where they now land in level 0, and likewise for the higher
+ * levels.  Starting or stopping a timer is therefore a doubly-linked
+ * list insertion or removal and each tick costs a slot check.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+
+#include "u_timer_wheel.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The number of slots in a level.
+ */
+#define U_TIMER_WHEEL_LEVEL_NUM_SLOTS (1UL << U_TIMER_WHEEL_LEVEL_BITS)
+
+/** The mask for a slot index.
+ */
+#define U_TIMER_WHEEL_LEVEL_MASK (U_TIMER_WHEEL_LEVEL_NUM_SLOTS - 1)
+
+/** The longest interval in ticks.
+ */
+#define U_TIMER_WHEEL_INTERVAL_MAX_TICKS ((uint32_t) ((1ULL << (U_TIMER_WHEEL_LEVEL_BITS * \
+                                                                U_TIMER_WHEEL_NUM_LEVELS)) - 1))
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Mutex to protect the wheel.
+ */
+static uPortMutexHandle_t gMutex = NULL;
+
+/** The port timer that drives the wheel.
+ */
+static uPortTimerHandle_t gPortTimer = NULL;
+
+/** True while gPortTimer is running.
+ */
+static bool gPortTimerRunning = false;
+
+/** The slots of the wheel.
+ */
+static uTimerWheelTimer_t *gpSlot[U_TIMER_WHEEL_NUM_LEVELS][U_TIMER_WHEEL_LEVEL_NUM_SLOTS];
+
+/** The timers that have expired on the current tick and have yet
+ * to be handled.
+ */
+static uTimerWheelTimer_t *gpExpired = NULL;
+
+/** The number of timers running, including those in gpExpired.
+ */
+static size_t gNumRunning = 0;
+
+/** The tick that has most recently been handled.
+ */
+static uint32_t gCurrentTick = 0;
+
+/** The time, as returned by uPortGetTickTimeMs(), of gCurrentTick.
+ */
+static int32_t gCurrentTickTimeMs = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Put a timer at the head of a list.
+// gMutex must be locked before this is called.
+static void listAdd(uTimerWheelTimer_t **ppList, uTimerWheelTimer_t *pTimer)
+{
+    pTimer->pNext = *ppList;
+    if (pTimer->pNext != NULL) {
+        pTimer->pNext->ppPrev = &(pTimer->pNext);
+    }
+    pTimer->ppPrev = ppList;
+    *ppList = pTimer;
+}
+
+// Remove a timer from whichever list it is in.
+// gMutex must be locked before this is called.
+static void listRemove(uTimerWheelTimer_t *pTimer)
+{
+    *(pTimer->ppPrev) = pTimer->pNext;
+    if (pTimer->pNext != NULL) {
+        pTimer->pNext->ppPrev = pTimer->ppPrev;
+    }
+    pTimer->pNext = NULL;
+    pTimer->ppPrev = NULL;
+}
+
+// Put a timer into the slot for its expiry tick, which must not
+// be before gCurrentTick.
+// gMutex must be locked before this is called.
+static void wheelAdd(uTimerWheelTimer_t *pTimer)
+{
+    uint32_t delta = pTimer->expiryTick - gCurrentTick;
+    size_t level = 0;
+
+    // Find the first level that reaches far enough
+    while ((level + 1 < U_TIMER_WHEEL_NUM_LEVELS) &&
+           (delta >> (U_TIMER_WHEEL_LEVEL_BITS * (level + 1))) != 0) {
+        level++;
+    }
+    listAdd(&(gpSlot[level][(pTimer->expiryTick >> (U_TIMER_WHEEL_LEVEL_BITS * level)) &
+                                                   U_TIMER_WHEEL_LEVEL_MASK]), pTimer);
+}
+
+// Move on to the next tick, cascading timers down the levels
+// as necessary, and move the timers which expire on that tick
+// to gpExpired.
+// gMutex must be locked before this is called.
+static void wheelTick(void)
+{
+    uTimerWheelTimer_t *pList;
+    uTimerWheelTimer_t *pTimer;
+    size_t slot;
+
+    gCurrentTick++;
+    gCurrentTickTimeMs += U_TIMER_WHEEL_TICK_MS;
+
+    // Cascade: level N is cascaded when the bits below it in
+    // the current tick have all wrapped to zero
+    for (size_t level = 1; (level < U_TIMER_WHEEL_NUM_LEVELS) &&
+         ((gCurrentTick & ((1UL << (U_TIMER_WHEEL_LEVEL_BITS * level)) - 1)) == 0); level++) {
+        slot = (gCurrentTick >> (U_TIMER_WHEEL_LEVEL_BITS * level)) & U_TIMER_WHEEL_LEVEL_MASK;
+        pList = gpSlot[level][slot];
+        gpSlot[level][slot] = NULL;
+        while (pList != NULL) {
+            pTimer = pList;
+            pList = pList->pNext;
+            wheelAdd(pTimer);
+        }
+    }
+
+    // Move the timers for this tick to the expired list
+    slot = gCurrentTick & U_TIMER_WHEEL_LEVEL_MASK;
+    while (gpSlot[0][slot] != NULL) {
+        pTimer = gpSlot[0][slot];
+        listRemove(pTimer);
+        listAdd(&gpExpired, pTimer);
+    }
+}
+
+// Stop the port timer if no timers are running.
+// gMutex must be locked before this is called.
+static void portTimerStopIfIdle(void)
+{
+    if ((gNumRunning == 0) && gPortTimerRunning) {
+        uPortTimerStop(gPortTimer);
+        gPortTimerRunning = false;
+    }
+}
+
+// The port timer callback: handle the ticks that have passed.
+static void portTimerCallback(const uPortTimerHandle_t timerHandle,
+                              void *pParam)
+{
+    uTimerWheelTimer_t *pTimer;
+    uTimerWheelCallback_t pCallback;
+    void *pCallbackParam;
+
+    (void) timerHandle;
+    (void) pParam;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        // Catch up with all of the ticks that have passed, in
+        // case the port timer has been held up
+        while ((int32_t) (uPortGetTickTimeMs() - gCurrentTickTimeMs) >= U_TIMER_WHEEL_TICK_MS) {
+            wheelTick();
+            // Handle the expired timers one at a time: the mutex
+            // is released while a callback is called, during which
+            // time anything may happen to the remaining timers
+            while (gpExpired != NULL) {
+                pTimer = gpExpired;
+                listRemove(pTimer);
+                pTimer->expired = true;
+                pCallback = pTimer->pCallback;
+                pCallbackParam = pTimer->pCallbackParam;
+                if (pTimer->periodTicks > 0) {
+                    // Restart from when it should have expired
+                    pTimer->expiryTick += pTimer->periodTicks;
+                    if ((int32_t) (pTimer->expiryTick - gCurrentTick) <= 0) {
+                        // A period has been missed entirely
+                        pTimer->expiryTick = gCurrentTick + 1;
+                    }
+                    wheelAdd(pTimer);
+                } else {
+                    gNumRunning--;
+                }
+                if (pCallback != NULL) {
+                    // Not U_PORT_MUTEX_UNLOCK()/U_PORT_MUTEX_LOCK()
+                    // since they must pair the other way around
+                    uPortMutexUnlock(gMutex);
+                    pCallback(pTimer, pCallbackParam);
+                    uPortMutexLock(gMutex);
+                }
+            }
+        }
+
+        portTimerStopIfIdle();
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Initialise the timer wheel.
+int32_t uTimerWheelInit(void)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (gMutex == NULL) {
+        errorCode = uPortMutexCreate(&gMutex);
+        if (errorCode == 0) {
+            errorCode = uPortTimerCreate(&gPortTimer, "timerWheel",
+                                         portTimerCallback, NULL,
+                                         U_TIMER_WHEEL_TICK_MS, true);
+            if (errorCode == 0) {
+                for (size_t x = 0; x < U_TIMER_WHEEL_NUM_LEVELS; x++) {
+                    for (size_t y = 0; y < U_TIMER_WHEEL_LEVEL_NUM_SLOTS; y++) {
+                        gpSlot[x][y] = NULL;
+                    }
+                }
+                gpExpired = NULL;
+                gNumRunning = 0;
+                gPortTimerRunning = false;
+                gCurrentTick = 0;
+                gCurrentTickTimeMs = uPortGetTickTimeMs();
+            } else {
+                gPortTimer = NULL;
+                uPortMutexDelete(gMutex);
+                gMutex = NULL;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Deinitialise the timer wheel.
+void uTimerWheelDeinit(void)
+{
+    uPortMutexHandle_t mutex = gMutex;
+
+    if (mutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(mutex);
+
+        // Stop any further port timer callbacks getting in
+        gMutex = NULL;
+        uPortTimerDelete(gPortTimer);
+        gPortTimer = NULL;
+        gPortTimerRunning = false;
+        for (size_t x = 0; x < U_TIMER_WHEEL_NUM_LEVELS; x++) {
+            for (size_t y = 0; y < U_TIMER_WHEEL_LEVEL_NUM_SLOTS; y++) {
+                while (gpSlot[x][y] != NULL) {
+                    listRemove(gpSlot[x][y]);
+                }
+            }
+        }
+        while (gpExpired != NULL) {
+            listRemove(gpExpired);
+        }
+        gNumRunning = 0;
+
+        U_PORT_MUTEX_UNLOCK(mutex);
+
+        uPortMutexDelete(mutex);
+    }
+}
+
+// Set up a timer.
+void uTimerWheelTimerInit(uTimerWheelTimer_t *pTimer,
+                          uTimerWheelCallback_t pCallback,
+                          void *pCallbackParam)
+{
+    if (pTimer != NULL) {
+        pTimer->pNext = NULL;
+        pTimer->ppPrev = NULL;
+        pTimer->expiryTick = 0;
+        pTimer->periodTicks = 0;
+        pTimer->pCallback = pCallback;
+        pTimer->pCallbackParam = pCallbackParam;
+        pTimer->expired = false;
+    }
+}
+
+// Start a timer.
+int32_t uTimerWheelTimerStart(uTimerWheelTimer_t *pTimer,
+                              uint32_t intervalMs, bool periodic)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uint32_t sinceTickMs;
+    uint32_t ticks;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pTimer != NULL) && (intervalMs <= U_TIMER_WHEEL_INTERVAL_MAX_MS)) {
+            if (pTimer->ppPrev != NULL) {
+                // Restart
+                listRemove(pTimer);
+                gNumRunning--;
+            }
+            if (gNumRunning == 0) {
+                // Nothing is running so the wheel may be well
+                // behind; skip the empty ticks
+                ticks = (uint32_t) (uPortGetTickTimeMs() - gCurrentTickTimeMs) /
+                        U_TIMER_WHEEL_TICK_MS;
+                gCurrentTick += ticks;
+                gCurrentTickTimeMs += (int32_t) (ticks * U_TIMER_WHEEL_TICK_MS);
+            }
+            // Round up so as never to expire early, allowing for
+            // the time since the current tick
+            sinceTickMs = (uint32_t) (uPortGetTickTimeMs() - gCurrentTickTimeMs);
+            ticks = (uint32_t) ((((uint64_t) sinceTickMs) + intervalMs +
+                                 U_TIMER_WHEEL_TICK_MS - 1) / U_TIMER_WHEEL_TICK_MS);
+            if (ticks == 0) {
+                ticks = 1;
+            }
+            if (ticks > U_TIMER_WHEEL_INTERVAL_MAX_TICKS) {
+                ticks = U_TIMER_WHEEL_INTERVAL_MAX_TICKS;
+            }
+            pTimer->expiryTick = gCurrentTick + ticks;
+            pTimer->periodTicks = 0;
+            if (periodic) {
+                pTimer->periodTicks = (intervalMs + U_TIMER_WHEEL_TICK_MS - 1) /
+                                      U_TIMER_WHEEL_TICK_MS;
+                if (pTimer->periodTicks == 0) {
+                    pTimer->periodTicks = 1;
+                }
+            }
+            pTimer->expired = false;
+            wheelAdd(pTimer);
+            gNumRunning++;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (!gPortTimerRunning) {
+                errorCode = uPortTimerStart(gPortTimer);
+                if (errorCode == 0) {
+                    gPortTimerRunning = true;
+                } else {
+                    listRemove(pTimer);
+                    gNumRunning--;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Stop a timer.
+void uTimerWheelTimerStop(uTimerWheelTimer_t *pTimer)
+{
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        if ((pTimer != NULL) && (pTimer->ppPrev != NULL)) {
+            listRemove(pTimer);
+            gNumRunning--;
+            // The port timer is left to stop itself on its next
+            // tick: a timer is often stopped only to be started
+            // again
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+// Determine whether a timer is running.
+bool uTimerWheelTimerIsRunning(const uTimerWheelTimer_t *pTimer)
+{
+    bool isRunning = false;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        isRunning = (pTimer != NULL) && (pTimer->ppPrev != NULL);
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return isRunning;
+}
+
+// Determine whether a timer has expired.
+bool uTimerWheelTimerExpired(const uTimerWheelTimer_t *pTimer)
+{
+    // No need to lock: a single flag written by the wheel
+    return (pTimer != NULL) && pTimer->expired;
+}
+
+// End of file
@@ -0,0 +1,294 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the binary trace.  A writer claims the
+ * next index with a compare-and-swap and writes the entry at that
+ * index modulo #U_TRACE_NUM_ENTRIES, writing the tag last: the tag
+ * holds the number of times the store has been gone around at that
+ * index, so that a reader can tell an entry that was fully written
+ * for the index it expects from one that is being written or has
+ * since been overwritten.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_compiler.h" // U_ATOMIC_CAS32, U_MEMORY_BARRIER
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_uart.h"
+
+#include "u_trace.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#if (U_TRACE_NUM_ENTRIES & (U_TRACE_NUM_ENTRIES - 1)) != 0
+# error U_TRACE_NUM_ENTRIES must be a power of two
+#endif
+
+/** The number of entries that uTraceDump() copies out at a time.
+ */
+#define U_TRACE_DUMP_CHUNK_NUM_ENTRIES 8
+
+/** Mask for the event in uTraceEntry_t.tagAndEvent.
+ */
+#define U_TRACE_EVENT_MASK 0x0000FFFFUL
+
+/** The tag for the entry at the given index: the number of times
+ * the store has been gone around, in the lower 15 bits, plus the
+ * top bit set so that the tag of a fully written entry is never
+ * zero.
+ */
+#define U_TRACE_TAG(index) (((((index) / U_TRACE_NUM_ENTRIES) & 0x7FFFUL) | 0x8000UL) << 16)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Context for uTraceDumpUart().
+ */
+typedef struct {
+    int32_t uartHandle;
+} uTraceDumpUartContext_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The trace store.
+ */
+static volatile uTraceEntry_t gEntry[U_TRACE_NUM_ENTRIES];
+
+/** The index that the next call to uTrace() will write.
+ */
+static volatile uint32_t gNextIndex = 0;
+
+/** The index at which the trace begins, moved on by uTraceClear().
+ */
+static volatile uint32_t gStartIndex = 0;
+
+/** Whether tracing is off.
+ */
+static volatile bool gOff = false;
+
+/** The names of the events.
+ */
+static const char *const gpEventName[] = {
+#define U_TRACE_EVENT_NAME(name) #name,
+    U_TRACE_EVENT_LIST(U_TRACE_EVENT_NAME)
+#undef U_TRACE_EVENT_NAME
+};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Work out the first index and the number of entries to read.
+static uint32_t getRange(uint32_t *pStartIndex, uint32_t *pTotal)
+{
+    uint32_t endIndex = gNextIndex;
+    uint32_t startIndex = gStartIndex;
+    uint32_t total = endIndex - startIndex;
+
+    if (total > U_TRACE_NUM_ENTRIES) {
+        startIndex = endIndex - U_TRACE_NUM_ENTRIES;
+    }
+    *pStartIndex = startIndex;
+    if (pTotal != NULL) {
+        *pTotal = total;
+    }
+
+    return endIndex - startIndex;
+}
+
+// Copy out the entry at the given index, returning false, with
+// the event set to U_TRACE_EVENT_NONE, if it is not the entry
+// written for that index.
+static bool entryGet(uint32_t index, uTraceEntry_t *pEntry)
+{
+    const volatile uTraceEntry_t *pSource = &(gEntry[index & (U_TRACE_NUM_ENTRIES - 1)]);
+    uint32_t tag = U_TRACE_TAG(index);
+    bool valid;
+
+    pEntry->tagAndEvent = pSource->tagAndEvent;
+    U_MEMORY_BARRIER();
+    pEntry->timeMs = pSource->timeMs;
+    pEntry->parameter = pSource->parameter;
+    U_MEMORY_BARRIER();
+    // Valid if the tag was right before we read the rest and
+    // had not changed afterwards
+    valid = ((pEntry->tagAndEvent & ~U_TRACE_EVENT_MASK) == tag) &&
+            (pSource->tagAndEvent == pEntry->tagAndEvent);
+    if (!valid) {
+        pEntry->tagAndEvent = (uint32_t) U_TRACE_EVENT_NONE;
+    }
+
+    return valid;
+}
+
+// Write function for uTraceDumpUart().
+static int32_t writeUart(void *pParam, const char *pData, size_t size)
+{
+    uTraceDumpUartContext_t *pContext = (uTraceDumpUartContext_t *) pParam;
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    while ((size > 0) && (errorCodeOrLength >= 0)) {
+        errorCodeOrLength = uPortUartWrite(pContext->uartHandle, pData, size);
+        if (errorCodeOrLength > 0) {
+            pData += errorCodeOrLength;
+            size -= (size_t) errorCodeOrLength;
+        } else if (errorCodeOrLength == 0) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        }
+    }
+
+    return (errorCodeOrLength < 0) ? errorCodeOrLength : (int32_t) U_ERROR_COMMON_SUCCESS;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add an entry to the trace.
+void uTrace(uTraceEvent_t event, int32_t parameter)
+{
+    uint32_t index;
+    volatile uTraceEntry_t *pEntry;
+
+    if (!gOff) {
+        do {
+            index = gNextIndex;
+        } while (!U_ATOMIC_CAS32(&gNextIndex, index, index + 1));
+        pEntry = &(gEntry[index & (U_TRACE_NUM_ENTRIES - 1)]);
+        // Invalidate the entry while it is being written
+        pEntry->tagAndEvent = 0;
+        U_MEMORY_BARRIER();
+        pEntry->timeMs = uPortGetTickTimeMs();
+        pEntry->parameter = parameter;
+        U_MEMORY_BARRIER();
+        pEntry->tagAndEvent = U_TRACE_TAG(index) |
+                              (((uint32_t) event) & U_TRACE_EVENT_MASK);
+    }
+}
+
+// Switch tracing on or off.
+void uTraceOn(bool onNotOff)
+{
+    gOff = !onNotOff;
+}
+
+// Forget the trace so far.
+void uTraceClear()
+{
+    gStartIndex = gNextIndex;
+}
+
+// Write the trace out in binary form.
+int32_t uTraceDump(uTraceWrite_t pWrite, void *pWriteParam)
+{
+    int32_t errorCodeOrNumEntries = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uTraceDumpHeader_t header;
+    uTraceEntry_t chunk[U_TRACE_DUMP_CHUNK_NUM_ENTRIES];
+    uint32_t index;
+    uint32_t numEntries;
+    size_t x;
+
+    if (pWrite != NULL) {
+        numEntries = getRange(&index, &(header.total));
+        header.magic = U_TRACE_DUMP_MAGIC;
+        header.version = U_TRACE_FORMAT_VERSION;
+        header.entrySizeBytes = (uint16_t) sizeof(uTraceEntry_t);
+        header.numEntries = numEntries;
+        errorCodeOrNumEntries = pWrite(pWriteParam, (const char *) &header,
+                                       sizeof(header));
+        while ((numEntries > 0) && (errorCodeOrNumEntries == 0)) {
+            for (x = 0; (x < sizeof(chunk) / sizeof(chunk[0])) &&
+                 (numEntries > 0); x++, index++, numEntries--) {
+                entryGet(index, &(chunk[x]));
+            }
+            errorCodeOrNumEntries = pWrite(pWriteParam, (const char *) chunk,
+                                           sizeof(chunk[0]) * x);
+        }
+        if (errorCodeOrNumEntries == 0) {
+            errorCodeOrNumEntries = (int32_t) header.numEntries;
+        }
+    }
+
+    return errorCodeOrNumEntries;
+}
+
+// Write the trace out in binary form to a UART.
+int32_t uTraceDumpUart(int32_t uartHandle)
+{
+    uTraceDumpUartContext_t context;
+
+    context.uartHandle = uartHandle;
+
+    return uTraceDump(writeUart, &context);
+}
+
+// Get the name of an event.
+const char *pUTraceEventName(uTraceEvent_t event)
+{
+    const char *pName = "?";
+
+    if ((size_t) event < sizeof(gpEventName) / sizeof(gpEventName[0])) {
+        pName = gpEventName[event];
+    }
+
+    return pName;
+}
+
+// Print the trace.
+void uTracePrint()
+{
+    uTraceEntry_t entry;
+    uint32_t index;
+    uint32_t total;
+    uint32_t numEntries = getRange(&index, &total);
+
+    uPortLog("------------- uTrace starts -------------\n");
+    if (total > numEntries) {
+        uPortLog("%d earlier entries overwritten.\n", (int32_t) (total - numEntries));
+    }
+    for (; numEntries > 0; index++, numEntries--) {
+        if (entryGet(index, &entry)) {
+            uPortLog("%10d: %s %d (%#x)\n", entry.timeMs,
+                     pUTraceEventName((uTraceEvent_t) (entry.tagAndEvent & U_TRACE_EVENT_MASK)),
+                     entry.parameter, entry.parameter);
+        }
+    }
+    uPortLog("-------------- uTrace ends --------------\n");
+}
+
+// End of file
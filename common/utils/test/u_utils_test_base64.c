@@ -0,0 +1,280 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the base 64 API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcmp(), memset(), strlen()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_base64.h"
+
+#include "u_bench.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_BASE64_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The amount of binary data to test chunking with.
+ */
+#define U_TEST_BASE64_BINARY_LENGTH_BYTES 100
+
+#ifndef U_TEST_BASE64_BENCH_ITERATIONS
+/** The number of times to encode/decode gBinary in the benchmark.
+ */
+# define U_TEST_BASE64_BENCH_ITERATIONS 10000
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A test vector.
+ */
+typedef struct {
+    const char *pBinary;
+    const char *pBase64;
+} uTestBase64Vector_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The test vectors of RFC 4648.
+ */
+static const uTestBase64Vector_t gVector[] = {{"", ""},
+    {"f", "Zg=="},
+    {"fo", "Zm8="},
+    {"foo", "Zm9v"},
+    {"foob", "Zm9vYg=="},
+    {"fooba", "Zm9vYmE="},
+    {"foobar", "Zm9vYmFy"}
+};
+
+/** Binary data for the chunking tests.
+ */
+static char gBinary[U_TEST_BASE64_BINARY_LENGTH_BYTES];
+
+/** The whole-buffer encoding of gBinary.
+ */
+static char gBase64[U_BASE64_ENCODE_CHUNK_LENGTH_MAX(U_TEST_BASE64_BINARY_LENGTH_BYTES)];
+
+/** Somewhere to put a chunked encode, with room for white space.
+ */
+static char gBuffer[sizeof(gBase64) * 2];
+
+/** Somewhere to put a chunked decode.
+ */
+static char gDecoded[U_BASE64_DECODE_CHUNK_LENGTH_MAX(sizeof(gBuffer))];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Decode pBase64 in chunks of chunkSize into gDecoded, returning
+// the decoded length or negative error code.
+static int32_t decodeChunked(const char *pBase64, size_t length,
+                             size_t chunkSize)
+{
+    int32_t errorCode = 0;
+    uBase64DecodeContext_t context;
+    size_t decodedLength = 0;
+    size_t thisChunk;
+
+    uBase64DecodeStart(&context);
+    for (size_t x = 0; (x < length) && (errorCode >= 0); x += thisChunk) {
+        thisChunk = chunkSize;
+        if (thisChunk > length - x) {
+            thisChunk = length - x;
+        }
+        errorCode = uBase64DecodeChunk(&context, pBase64 + x, thisChunk,
+                                       gDecoded + decodedLength,
+                                       sizeof(gDecoded) - decodedLength);
+        if (errorCode >= 0) {
+            decodedLength += errorCode;
+        }
+    }
+    if (errorCode >= 0) {
+        errorCode = uBase64DecodeFinish(&context, gDecoded + decodedLength,
+                                        sizeof(gDecoded) - decodedLength);
+        if (errorCode >= 0) {
+            errorCode = (int32_t) (decodedLength + errorCode);
+        }
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test the chunked base 64 encode and decode.
+ */
+U_PORT_TEST_FUNCTION("[base64]", "base64Chunked")
+{
+    uBase64EncodeContext_t encodeContext;
+    int32_t base64Length;
+    int32_t length;
+    size_t x;
+    size_t y;
+    size_t thisChunk;
+
+    U_TEST_PRINT_LINE("testing RFC 4648 vectors.");
+    for (x = 0; x < sizeof(gVector) / sizeof(gVector[0]); x++) {
+        uBase64EncodeStart(&encodeContext);
+        length = uBase64EncodeChunk(&encodeContext, gVector[x].pBinary,
+                                    strlen(gVector[x].pBinary),
+                                    gBuffer, sizeof(gBuffer));
+        U_PORT_TEST_ASSERT(length >= 0);
+        base64Length = uBase64EncodeFinish(&encodeContext, gBuffer + length,
+                                           sizeof(gBuffer) - length);
+        U_PORT_TEST_ASSERT(base64Length >= 0);
+        base64Length += length;
+        U_PORT_TEST_ASSERT(base64Length == (int32_t) strlen(gVector[x].pBase64));
+        U_PORT_TEST_ASSERT(memcmp(gBuffer, gVector[x].pBase64, base64Length) == 0);
+        length = decodeChunked(gVector[x].pBase64, strlen(gVector[x].pBase64), 1);
+        U_PORT_TEST_ASSERT(length == (int32_t) strlen(gVector[x].pBinary));
+        U_PORT_TEST_ASSERT(memcmp(gDecoded, gVector[x].pBinary, length) == 0);
+    }
+
+    for (x = 0; x < sizeof(gBinary); x++) {
+        gBinary[x] = (char) ((x * 97) + 13);
+    }
+    base64Length = uBase64Encode(gBinary, sizeof(gBinary), gBase64, sizeof(gBase64));
+    U_PORT_TEST_ASSERT(base64Length == (int32_t) sizeof(gBase64));
+
+    U_TEST_PRINT_LINE("testing chunk sizes 1 to 8.");
+    for (size_t chunkSize = 1; chunkSize <= 8; chunkSize++) {
+        // Encode in chunks, must give the same as the whole-buffer encode
+        uBase64EncodeStart(&encodeContext);
+        y = 0;
+        for (x = 0; x < sizeof(gBinary); x += thisChunk) {
+            thisChunk = chunkSize;
+            if (thisChunk > sizeof(gBinary) - x) {
+                thisChunk = sizeof(gBinary) - x;
+            }
+            length = uBase64EncodeChunk(&encodeContext, gBinary + x, thisChunk,
+                                        gBuffer + y, sizeof(gBuffer) - y);
+            U_PORT_TEST_ASSERT(length >= 0);
+            U_PORT_TEST_ASSERT(length <= (int32_t) U_BASE64_ENCODE_CHUNK_LENGTH_MAX(thisChunk));
+            y += length;
+        }
+        length = uBase64EncodeFinish(&encodeContext, gBuffer + y, sizeof(gBuffer) - y);
+        U_PORT_TEST_ASSERT(length >= 0);
+        y += length;
+        U_PORT_TEST_ASSERT(y == (size_t) base64Length);
+        U_PORT_TEST_ASSERT(memcmp(gBuffer, gBase64, y) == 0);
+        // Decode in chunks, must give back the binary
+        length = decodeChunked(gBase64, base64Length, chunkSize);
+        U_PORT_TEST_ASSERT(length == (int32_t) sizeof(gBinary));
+        U_PORT_TEST_ASSERT(memcmp(gDecoded, gBinary, length) == 0);
+    }
+
+    U_TEST_PRINT_LINE("testing white space, padding and invalid input.");
+    // Break the encoding into lines, as in a PEM file
+    y = 0;
+    for (x = 0; x < (size_t) base64Length; x++) {
+        gBuffer[y] = gBase64[x];
+        y++;
+        if ((x % 16) == 15) {
+            gBuffer[y] = '\r';
+            y++;
+            gBuffer[y] = '\n';
+            y++;
+        }
+    }
+    length = decodeChunked(gBuffer, y, 7);
+    U_PORT_TEST_ASSERT(length == (int32_t) sizeof(gBinary));
+    U_PORT_TEST_ASSERT(memcmp(gDecoded, gBinary, length) == 0);
+    // Unpadded input is fine
+    U_PORT_TEST_ASSERT(decodeChunked("Zm9vYg", 6, 4) == 4);
+    U_PORT_TEST_ASSERT(memcmp(gDecoded, "foob", 4) == 0);
+    U_PORT_TEST_ASSERT(decodeChunked("Zm9vYmE", 7, 3) == 5);
+    U_PORT_TEST_ASSERT(memcmp(gDecoded, "fooba", 5) == 0);
+    // A single left-over character, too much padding, padding in
+    // the wrong place, data after padding and invalid characters
+    // are all errors
+    U_PORT_TEST_ASSERT(decodeChunked("Zm9vY", 5, 2) < 0);
+    U_PORT_TEST_ASSERT(decodeChunked("Zm9vYmE==", 9, 2) < 0);
+    U_PORT_TEST_ASSERT(decodeChunked("Zm9v=Yg==", 9, 2) < 0);
+    U_PORT_TEST_ASSERT(decodeChunked("Zg==Zg==", 8, 2) < 0);
+    U_PORT_TEST_ASSERT(decodeChunked("Zm9v*mFy", 8, 8) < 0);
+    // Not enough room is an error
+    uBase64EncodeStart(&encodeContext);
+    U_PORT_TEST_ASSERT(uBase64EncodeChunk(&encodeContext, "foo", 3, gBuffer, 3) < 0);
+}
+
+/** Benchmark the whole-buffer base 64 encode and decode.
+ */
+U_PORT_BENCH_FUNCTION("[base64]", "base64BenchEncodeDecode")
+{
+    uBench_t bench;
+    int32_t length = 0;
+
+    for (size_t x = 0; x < sizeof(gBinary); x++) {
+        gBinary[x] = (char) ((x * 97) + 13);
+    }
+
+    uBenchStart(&bench, "base64Encode");
+    for (size_t x = 0; x < U_TEST_BASE64_BENCH_ITERATIONS; x++) {
+        length = uBase64Encode(gBinary, sizeof(gBinary), gBase64, sizeof(gBase64));
+    }
+    uBenchStop(&bench, U_TEST_BASE64_BENCH_ITERATIONS,
+               U_TEST_BASE64_BENCH_ITERATIONS * sizeof(gBinary), "bytes");
+    U_PORT_TEST_ASSERT(length == (int32_t) sizeof(gBase64));
+
+    uBenchStart(&bench, "base64Decode");
+    for (size_t x = 0; x < U_TEST_BASE64_BENCH_ITERATIONS; x++) {
+        length = uBase64Decode(gBase64, sizeof(gBase64), gDecoded, sizeof(gDecoded));
+    }
+    uBenchStop(&bench, U_TEST_BASE64_BENCH_ITERATIONS,
+               U_TEST_BASE64_BENCH_ITERATIONS * sizeof(gBase64), "bytes");
+    U_PORT_TEST_ASSERT(length == (int32_t) sizeof(gBinary));
+    U_PORT_TEST_ASSERT(memcmp(gDecoded, gBinary, length) == 0);
+}
+
+// End of file
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test and benchmark for the hex/binary conversion API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcmp(), memcpy()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_hex_bin_convert.h"
+
+#include "u_bench.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_HEX_BIN_CONVERT_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The amount of binary data to test with.
+ */
+#define U_TEST_HEX_BIN_LENGTH_BYTES 256
+
+#ifndef U_TEST_HEX_BIN_BENCHMARK_ITERATIONS
+/** The number of times to convert the test data when benchmarking.
+ */
+# define U_TEST_HEX_BIN_BENCHMARK_ITERATIONS 2000
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Binary data: every byte value once.
+ */
+static char gBin[U_TEST_HEX_BIN_LENGTH_BYTES];
+
+/** Somewhere to put hex.
+ */
+static char gHex[U_TEST_HEX_BIN_LENGTH_BYTES * 2];
+
+/** Somewhere to put the hex from the reference implementation.
+ */
+static char gHexReference[U_TEST_HEX_BIN_LENGTH_BYTES * 2];
+
+/** Somewhere to put binary.
+ */
+static char gBinOut[U_TEST_HEX_BIN_LENGTH_BYTES];
+
+/** Hex digits, for the reference implementation.
+ */
+static const char gHexDigit[] = "0123456789ABCDEF";
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Reference binary to hex, one nibble at a time, to benchmark against.
+static size_t referenceBinToHex(const char *pBin, size_t binLength, char *pHex)
+{
+    for (size_t x = 0; x < binLength; x++) {
+        *pHex = gHexDigit[((unsigned char) * pBin) >> 4];
+        pHex++;
+        *pHex = gHexDigit[*pBin & 0x0f];
+        pHex++;
+        pBin++;
+    }
+
+    return binLength * 2;
+}
+
+// Reference hex to binary, one nibble at a time with branches, to
+// benchmark against.
+static size_t referenceHexToBin(const char *pHex, size_t hexLength, char *pBin)
+{
+    bool success = true;
+    size_t length;
+    char z[2];
+
+    for (length = 0; (length < hexLength / 2) && success; length++) {
+        for (size_t y = 0; (y < sizeof(z)) && success; y++) {
+            z[y] = *pHex;
+            pHex++;
+            if ((z[y] >= '0') && (z[y] <= '9')) {
+                z[y] -= '0';
+            } else if ((z[y] >= 'A') && (z[y] <= 'F')) {
+                z[y] -= 'A' - 10;
+            } else if ((z[y] >= 'a') && (z[y] <= 'f')) {
+                z[y] -= 'a' - 10;
+            } else {
+                success = false;
+            }
+        }
+        if (success) {
+            *pBin = (char) ((z[0] << 4) | z[1]);
+            pBin++;
+        }
+    }
+
+    return length;
+}
+
+// Report how long a number of conversions of the test data took.
+static void benchStop(const uBench_t *pBench)
+{
+    uBenchStop(pBench, U_TEST_HEX_BIN_BENCHMARK_ITERATIONS,
+               U_TEST_HEX_BIN_BENCHMARK_ITERATIONS * U_TEST_HEX_BIN_LENGTH_BYTES,
+               "bytes");
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test hex/binary conversion, including in place, against a
+ * reference implementation.
+ */
+U_PORT_TEST_FUNCTION("[hexBinConvert]", "hexBinConvertBasic")
+{
+    char buffer[8];
+
+    for (size_t x = 0; x < sizeof(gBin); x++) {
+        gBin[x] = (char) x;
+    }
+
+    // Encode must match the reference
+    U_PORT_TEST_ASSERT(uBinToHex(gBin, sizeof(gBin), gHex) == sizeof(gHex));
+    referenceBinToHex(gBin, sizeof(gBin), gHexReference);
+    U_PORT_TEST_ASSERT(memcmp(gHex, gHexReference, sizeof(gHex)) == 0);
+    U_PORT_TEST_ASSERT(memcmp(gHex, "000102", 6) == 0);
+    U_PORT_TEST_ASSERT(memcmp(gHex + sizeof(gHex) - 4, "FEFF", 4) == 0);
+
+    // Decode, upper case
+    U_PORT_TEST_ASSERT(uHexToBin(gHex, sizeof(gHex), gBinOut) == sizeof(gBinOut));
+    U_PORT_TEST_ASSERT(memcmp(gBinOut, gBin, sizeof(gBin)) == 0);
+
+    // Lower case and mixed case
+    memcpy(buffer, "aBcDeF09", sizeof(buffer));
+    U_PORT_TEST_ASSERT(uHexToBin(buffer, sizeof(buffer), gBinOut) == 4);
+    U_PORT_TEST_ASSERT(memcmp(gBinOut, "\xab\xcd\xef\x09", 4) == 0);
+
+    // Invalid characters stop the conversion, including those
+    // either side of the ranges of valid characters
+    U_PORT_TEST_ASSERT(uHexToBin("12G4", 4, gBinOut) == 1);
+    U_PORT_TEST_ASSERT(uHexToBin("12/4", 4, gBinOut) == 1);
+    U_PORT_TEST_ASSERT(uHexToBin("12:4", 4, gBinOut) == 1);
+    U_PORT_TEST_ASSERT(uHexToBin("12@4", 4, gBinOut) == 1);
+    U_PORT_TEST_ASSERT(uHexToBin("12`4", 4, gBinOut) == 1);
+    U_PORT_TEST_ASSERT(uHexToBin("12g4", 4, gBinOut) == 1);
+    U_PORT_TEST_ASSERT(uHexToBin("12\xc1" "4", 4, gBinOut) == 1);
+    U_PORT_TEST_ASSERT(gBinOut[0] == 0x12);
+    // An odd character at the end is ignored
+    U_PORT_TEST_ASSERT(uHexToBin("123", 3, gBinOut) == 1);
+
+    // In place
+    U_PORT_TEST_ASSERT(uHexToBinInPlace(gHex, sizeof(gHex)) == sizeof(gBin));
+    U_PORT_TEST_ASSERT(memcmp(gHex, gBin, sizeof(gBin)) == 0);
+}
+
+/** Benchmark hex/binary conversion against a simple per-nibble
+ * implementation; the times are printed, not checked.
+ */
+U_PORT_BENCH_FUNCTION("[hexBinConvert]", "hexBinConvertBenchmark")
+{
+    uBench_t bench;
+    size_t x;
+
+    for (x = 0; x < sizeof(gBin); x++) {
+        gBin[x] = (char) (x * 7);
+    }
+
+    uBenchStart(&bench, "hexBinConvertReferenceBinToHex");
+    for (x = 0; x < U_TEST_HEX_BIN_BENCHMARK_ITERATIONS; x++) {
+        referenceBinToHex(gBin, sizeof(gBin), gHex);
+    }
+    benchStop(&bench);
+    uBenchStart(&bench, "hexBinConvertBinToHex");
+    for (x = 0; x < U_TEST_HEX_BIN_BENCHMARK_ITERATIONS; x++) {
+        uBinToHex(gBin, sizeof(gBin), gHex);
+    }
+    benchStop(&bench);
+
+    uBenchStart(&bench, "hexBinConvertReferenceHexToBin");
+    for (x = 0; x < U_TEST_HEX_BIN_BENCHMARK_ITERATIONS; x++) {
+        U_PORT_TEST_ASSERT(referenceHexToBin(gHex, sizeof(gHex), gBinOut) == sizeof(gBinOut));
+    }
+    benchStop(&bench);
+    uBenchStart(&bench, "hexBinConvertHexToBin");
+    for (x = 0; x < U_TEST_HEX_BIN_BENCHMARK_ITERATIONS; x++) {
+        U_PORT_TEST_ASSERT(uHexToBin(gHex, sizeof(gHex), gBinOut) == sizeof(gBinOut));
+    }
+    benchStop(&bench);
+    U_PORT_TEST_ASSERT(memcmp(gBinOut, gBin, sizeof(gBin)) == 0);
+}
+
+// End of file
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the JSON tokenizer.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strlen(), strncmp()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_json.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_JSON_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Context for parseCallback().
+ */
+typedef struct {
+    int32_t count;
+    int32_t maxDepth;
+    int32_t stopAt;
+} uTestJsonContext_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** A Cloud Locate response, deliberately not null-terminated
+ * where it is used.
+ */
+static const char gCloudLocate[] = "{\"Lat\":52.018749899999996,\"Lon\":-0.2471071,"
+                                   "\"Alt\":120.21600000000001,\"Acc\":29.877,"
+                                   "\"MeasTime\":\"2021-11-09T18:24:11\",\"Epochs\":1}";
+
+/** Some nested JSON with every type of value in it.
+ */
+static const char gNested[] = " { \"a\" : [1, 2.5e1, {\"b\": \"x\\\"y\"}],\n"
+                              "   \"c\": {\"d\": true, \"e\": null}, \"f\": false } trailing";
+
+/** Malformed JSON.
+ */
+static const char *const gpMalformed[] = {"{\"a\":1",
+                                          "{\"a\" 1}",
+                                          "{\"a\":1]",
+                                          "[1,2}",
+                                          "{1:2}",
+                                          "{\"a\":\"unterminated}",
+                                          "}",
+                                          ""
+                                         };
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Callback for uJsonParse().
+static bool parseCallback(const uJsonItem_t *pItem, void *pParameter)
+{
+    uTestJsonContext_t *pContext = (uTestJsonContext_t *) pParameter;
+
+    pContext->count++;
+    if (pItem->depth > pContext->maxDepth) {
+        pContext->maxDepth = pItem->depth;
+    }
+
+    return pContext->count != pContext->stopAt;
+}
+
+// Return true if an item has the given value.
+static bool valueIs(const uJsonItem_t *pItem, const char *pValue)
+{
+    return (pItem->valueLength == strlen(pValue)) &&
+           (strncmp(pItem->pValue, pValue, pItem->valueLength) == 0);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test the JSON tokenizer.
+ */
+U_PORT_TEST_FUNCTION("[json]", "jsonBasic")
+{
+    const char *pKey[] = {"Lon", "MeasTime", "Lat", "Alt", "Acc", "Missing"};
+    const char *pKeyNested[] = {"f", "c", "b"};
+    uJsonItem_t item[sizeof(pKey) / sizeof(pKey[0])];
+    uTestJsonContext_t context = {0};
+    int32_t x;
+
+    // Find the values of a Cloud Locate response in one pass,
+    // without the terminator
+    U_PORT_TEST_ASSERT(uJsonFind(gCloudLocate, sizeof(gCloudLocate) - 1,
+                                 pKey, sizeof(pKey) / sizeof(pKey[0]), item) == 5);
+    U_PORT_TEST_ASSERT(item[0].type == U_JSON_TYPE_NUMBER);
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[0]), 7, &x) == 0);
+    U_PORT_TEST_ASSERT(x == -2471071);
+    U_PORT_TEST_ASSERT(item[1].type == U_JSON_TYPE_STRING);
+    U_PORT_TEST_ASSERT(valueIs(&(item[1]), "2021-11-09T18:24:11"));
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[1]), 0, &x) < 0);
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[2]), 7, &x) == 0);
+    U_PORT_TEST_ASSERT(x == 520187498);
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[3]), 3, &x) == 0);
+    U_PORT_TEST_ASSERT(x == 120216);
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[4]), 0, &x) == 0);
+    U_PORT_TEST_ASSERT(x == 29);
+    U_PORT_TEST_ASSERT(item[5].type == U_JSON_TYPE_NONE);
+
+    // Only the outermost object is searched
+    U_PORT_TEST_ASSERT(uJsonFind(gNested, sizeof(gNested) - 1, pKeyNested,
+                                 sizeof(pKeyNested) / sizeof(pKeyNested[0]), item) == 2);
+    U_PORT_TEST_ASSERT(item[0].type == U_JSON_TYPE_BOOL);
+    U_PORT_TEST_ASSERT(valueIs(&(item[0]), "false"));
+    U_PORT_TEST_ASSERT(item[1].type == U_JSON_TYPE_OBJECT);
+    U_PORT_TEST_ASSERT(item[2].type == U_JSON_TYPE_NONE);
+
+    // Walk all of it: outer object, a, 1, 2.5e1, {}, b, c, d, e, f
+    U_PORT_TEST_ASSERT(uJsonParse(gNested, sizeof(gNested) - 1,
+                                  parseCallback, &context) == 10);
+    U_PORT_TEST_ASSERT(context.count == 10);
+    U_PORT_TEST_ASSERT(context.maxDepth == 3);
+    // Stop early
+    memset(&context, 0, sizeof(context));
+    context.stopAt = 3;
+    U_PORT_TEST_ASSERT(uJsonParse(gNested, sizeof(gNested) - 1,
+                                  parseCallback, &context) == 3);
+
+    // Malformed JSON
+    for (size_t y = 0; y < sizeof(gpMalformed) / sizeof(gpMalformed[0]); y++) {
+        memset(&context, 0, sizeof(context));
+        x = uJsonParse(gpMalformed[y], strlen(gpMalformed[y]), parseCallback, &context);
+        U_TEST_PRINT_LINE("malformed JSON %d returned %d.", y, x);
+        U_PORT_TEST_ASSERT(x < 0);
+    }
+
+    // Number conversion
+    item[0].type = U_JSON_TYPE_NUMBER;
+    item[0].pValue = "2.5e1";
+    item[0].valueLength = 5;
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[0]), 2, &x) == 0);
+    U_PORT_TEST_ASSERT(x == 2500);
+    item[0].pValue = "-1E-3";
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[0]), 3, &x) == 0);
+    U_PORT_TEST_ASSERT(x == -1);
+    item[0].pValue = "21474836470";
+    item[0].valueLength = 11;
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[0]), 0, &x) < 0);
+    item[0].pValue = "-2147483648";
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[0]), 0, &x) == 0);
+    U_PORT_TEST_ASSERT(x == INT32_MIN);
+    item[0].pValue = "12a";
+    item[0].valueLength = 3;
+    U_PORT_TEST_ASSERT(uJsonToInt32(&(item[0]), 0, &x) < 0);
+}
+
+// End of file
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the LZSS API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcmp(), strlen()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_lzss.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_LZSS_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The amount of pseudo-random data to test with.
+ */
+#define U_TEST_LZSS_RANDOM_LENGTH_BYTES 200
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** A typical telemetry payload.
+ */
+static const char gJson[] = "{\"temperature\":21.5,\"humidity\":40,"
+                            "\"pressure\":1013,\"temperature_min\":19.0,"
+                            "\"temperature_max\":23.5,\"humidity_min\":35,"
+                            "\"humidity_max\":45}";
+
+/** Pseudo-random, so incompressible, data.
+ */
+static char gRandom[U_TEST_LZSS_RANDOM_LENGTH_BYTES];
+
+/** Somewhere to put compressed data.
+ */
+static char gCompressed[U_LZSS_COMPRESS_LENGTH_MAX(U_TEST_LZSS_RANDOM_LENGTH_BYTES)];
+
+/** Somewhere to put decompressed data.
+ */
+static char gDecompressed[U_TEST_LZSS_RANDOM_LENGTH_BYTES];
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test LZSS compression and decompression.
+ */
+U_PORT_TEST_FUNCTION("[lzss]", "lzssRoundTrip")
+{
+    int32_t heapUsed;
+    int32_t compressedLength;
+    int32_t length;
+    uint32_t seed = 1;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("compressing %d bytes of JSON.", (int32_t) strlen(gJson));
+    compressedLength = uLzssCompress(gJson, strlen(gJson), gCompressed, sizeof(gCompressed));
+    U_TEST_PRINT_LINE("compressed to %d bytes.", compressedLength);
+    U_PORT_TEST_ASSERT(compressedLength > 0);
+    U_PORT_TEST_ASSERT(compressedLength < (int32_t) strlen(gJson));
+    length = uLzssDecompress(gCompressed, compressedLength, gDecompressed, sizeof(gDecompressed));
+    U_PORT_TEST_ASSERT(length == (int32_t) strlen(gJson));
+    U_PORT_TEST_ASSERT(memcmp(gDecompressed, gJson, length) == 0);
+    // Not enough room to decompress is an error
+    U_PORT_TEST_ASSERT(uLzssDecompress(gCompressed, compressedLength, gDecompressed,
+                                       length - 1) == (int32_t) U_ERROR_COMMON_NO_MEMORY);
+
+    U_TEST_PRINT_LINE("testing a run, which overlaps itself.");
+    memset(gRandom, 'a', sizeof(gRandom));
+    compressedLength = uLzssCompress(gRandom, sizeof(gRandom), gCompressed, sizeof(gCompressed));
+    U_PORT_TEST_ASSERT(compressedLength > 0);
+    U_PORT_TEST_ASSERT(compressedLength < (int32_t) sizeof(gRandom) / 4);
+    length = uLzssDecompress(gCompressed, compressedLength, gDecompressed, sizeof(gDecompressed));
+    U_PORT_TEST_ASSERT(length == (int32_t) sizeof(gRandom));
+    U_PORT_TEST_ASSERT(memcmp(gDecompressed, gRandom, length) == 0);
+
+    U_TEST_PRINT_LINE("testing incompressible data.");
+    for (size_t x = 0; x < sizeof(gRandom); x++) {
+        seed = (seed * 1103515245) + 12345;
+        gRandom[x] = (char) (seed >> 16);
+    }
+    compressedLength = uLzssCompress(gRandom, sizeof(gRandom), gCompressed, sizeof(gCompressed));
+    U_PORT_TEST_ASSERT(compressedLength > 0);
+    U_PORT_TEST_ASSERT(compressedLength <= (int32_t) sizeof(gCompressed));
+    length = uLzssDecompress(gCompressed, compressedLength, gDecompressed, sizeof(gDecompressed));
+    U_PORT_TEST_ASSERT(length == (int32_t) sizeof(gRandom));
+    U_PORT_TEST_ASSERT(memcmp(gDecompressed, gRandom, length) == 0);
+    // Asking for the compressed form only if it is smaller fails
+    U_PORT_TEST_ASSERT(uLzssCompress(gRandom, sizeof(gRandom), gCompressed,
+                                     sizeof(gRandom) - 1) == (int32_t) U_ERROR_COMMON_NO_MEMORY);
+
+    U_TEST_PRINT_LINE("testing invalid input.");
+    // A reference to before the start of the data
+    gCompressed[0] = 0x01;
+    gCompressed[1] = 0x05;
+    gCompressed[2] = 0x00;
+    U_PORT_TEST_ASSERT(uLzssDecompress(gCompressed, 3, gDecompressed,
+                                       sizeof(gDecompressed)) == (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+    // A truncated reference
+    U_PORT_TEST_ASSERT(uLzssDecompress(gCompressed, 2, gDecompressed,
+                                       sizeof(gDecompressed)) == (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+    U_PORT_TEST_ASSERT(uLzssCompress(NULL, 0, gCompressed,
+                                     sizeof(gCompressed)) == (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+    // Nothing in, nothing out
+    U_PORT_TEST_ASSERT(uLzssCompress(gJson, 0, gCompressed, sizeof(gCompressed)) == 0);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+// End of file
@@ -50,6 +50,8 @@
 #include "u_port_event_queue.h"
 #include "u_mempool.h"
 
+#include "u_bench.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -65,6 +67,17 @@
 #define TEST_BLOCK_COUNT 8
 #define TEST_BLOCK_SIZE  64
 
+/** The number of size classes in the slab test.
+ */
+#define TEST_SLAB_NUM_CLASSES 3
+
+#ifndef U_TEST_MEMPOOL_BENCH_ITERATIONS
+/** The number of times to allocate and free all of the blocks
+ * in the benchmark.
+ */
+# define U_TEST_MEMPOOL_BENCH_ITERATIONS 5000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -73,6 +86,19 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The configuration of the slab test: the block sizes are
+ * deliberately not multiples of the alignment.
+ */
+static const uMemPoolSlabClassCfg_t gSlabCfg[TEST_SLAB_NUM_CLASSES] = {{12, 4},
+    {30, 2},
+    {100, 1}
+};
+
+/** Static backing storage for the slab test, deliberately
+ * mis-aligned by one byte when used.
+ */
+static uint8_t gSlabBuffer[(16 * 4) + (32 * 2) + (104 * 1) + 8];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -228,4 +254,222 @@ U_PORT_TEST_FUNCTION("[mempool]", "mempoolFreeAllMem")
 
 }
 
-// End of file
\ No newline at end of file
+U_PORT_TEST_FUNCTION("[mempool]", "mempoolSlab")
+{
+    uMemPoolSlab_t slab;
+    uMemPoolSlabStats_t stats;
+    uint8_t *pBuf[4 + 2 + 1];
+    uint8_t notOurs;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing slab with static storage.");
+    U_PORT_TEST_ASSERT(uMemPoolSlabBufferSize(gSlabCfg,
+                                              TEST_SLAB_NUM_CLASSES) <= sizeof(gSlabBuffer) - 1);
+    // Too small a buffer should be rejected
+    U_PORT_TEST_ASSERT(uMemPoolSlabInit(&slab, gSlabCfg, 1, gSlabBuffer + 1, 16) < 0);
+    U_PORT_TEST_ASSERT(uMemPoolSlabInit(&slab, gSlabCfg, TEST_SLAB_NUM_CLASSES,
+                                        gSlabBuffer + 1, sizeof(gSlabBuffer) - 1) == 0);
+    U_PORT_TEST_ASSERT(uMemPoolSlabGetStats(&slab, TEST_SLAB_NUM_CLASSES, &stats) < 0);
+    U_PORT_TEST_ASSERT(uMemPoolSlabGetStats(&slab, 0, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.blockSize == 16);
+    U_PORT_TEST_ASSERT(stats.blockCount == 4);
+    U_PORT_TEST_ASSERT(stats.inUse == 0);
+
+    // Allocate everything there is, filling each block;
+    // the small class is used first, then the others
+    for (size_t x = 0; x < sizeof(pBuf) / sizeof(pBuf[0]); x++) {
+        pBuf[x] = (uint8_t *) uMemPoolSlabAlloc(&slab, 10);
+        U_PORT_TEST_ASSERT(pBuf[x] != NULL);
+        U_PORT_TEST_ASSERT((((uintptr_t) pBuf[x]) % U_MEMPOOL_SLAB_ALIGNMENT_BYTES) == 0);
+        memset(pBuf[x], (int) x, 12);
+    }
+    U_PORT_TEST_ASSERT(uMemPoolSlabAlloc(&slab, 10) == NULL);
+    U_PORT_TEST_ASSERT(uMemPoolSlabAlloc(&slab, 105) == NULL);
+    for (size_t x = 0; x < sizeof(pBuf) / sizeof(pBuf[0]); x++) {
+        U_PORT_TEST_ASSERT(isAllBytes(pBuf[x], 12, (uint8_t) x));
+    }
+    for (size_t x = 0; x < TEST_SLAB_NUM_CLASSES; x++) {
+        U_PORT_TEST_ASSERT(uMemPoolSlabGetStats(&slab, x, &stats) == 0);
+        U_TEST_PRINT_LINE("class %d: block size %d, %d in use, high-water %d,"
+                          " %d failure(s).", (int32_t) x, (int32_t) stats.blockSize,
+                          (int32_t) stats.inUse, (int32_t) stats.inUseHighWater,
+                          (int32_t) stats.failures);
+        U_PORT_TEST_ASSERT(stats.inUse == gSlabCfg[x].blockCount);
+        U_PORT_TEST_ASSERT(stats.inUseHighWater == gSlabCfg[x].blockCount);
+        // A 10 byte allocation that failed counts against the small
+        // class and a 105 byte allocation, too big for any class,
+        // against none
+        U_PORT_TEST_ASSERT(stats.failures == ((x == 0) ? 1 : 0));
+    }
+
+    // Something that is not ours should not be freed
+    U_PORT_TEST_ASSERT(!uMemPoolSlabFree(&slab, &notOurs));
+    U_PORT_TEST_ASSERT(!uMemPoolSlabFree(&slab, NULL));
+
+    // Free a block of the middle class and get it back
+    U_PORT_TEST_ASSERT(uMemPoolSlabFree(&slab, pBuf[5]));
+    U_PORT_TEST_ASSERT(uMemPoolSlabAlloc(&slab, 1) == pBuf[5]);
+
+    // Free everything
+    for (size_t x = 0; x < sizeof(pBuf) / sizeof(pBuf[0]); x++) {
+        U_PORT_TEST_ASSERT(uMemPoolSlabFree(&slab, pBuf[x]));
+    }
+    for (size_t x = 0; x < TEST_SLAB_NUM_CLASSES; x++) {
+        U_PORT_TEST_ASSERT(uMemPoolSlabGetStats(&slab, x, &stats) == 0);
+        U_PORT_TEST_ASSERT(stats.inUse == 0);
+        U_PORT_TEST_ASSERT(stats.inUseHighWater == gSlabCfg[x].blockCount);
+    }
+    // The large class should now serve a large block
+    pBuf[0] = (uint8_t *) uMemPoolSlabAlloc(&slab, 100);
+    U_PORT_TEST_ASSERT(pBuf[0] == pBuf[6]);
+    U_PORT_TEST_ASSERT(uMemPoolSlabFree(&slab, pBuf[0]));
+    uMemPoolSlabDeinit(&slab);
+
+    U_TEST_PRINT_LINE("testing slab with malloc()ed storage.");
+    U_PORT_TEST_ASSERT(uMemPoolSlabInit(&slab, gSlabCfg, TEST_SLAB_NUM_CLASSES,
+                                        NULL, 0) == 0);
+    pBuf[0] = (uint8_t *) uMemPoolSlabAlloc(&slab, 30);
+    U_PORT_TEST_ASSERT(pBuf[0] != NULL);
+    U_PORT_TEST_ASSERT(uMemPoolSlabGetStats(&slab, 1, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.inUse == 1);
+    U_PORT_TEST_ASSERT(uMemPoolSlabFree(&slab, pBuf[0]));
+    uMemPoolSlabDeinit(&slab);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+U_PORT_TEST_FUNCTION("[mempool]", "mempoolMalloc")
+{
+    uMemPoolSlabStats_t statsBefore;
+    uMemPoolSlabStats_t stats;
+    uint8_t *pSmall;
+    uint8_t *pBig;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    // Small things should come from the library-wide slab,
+    // big things from the heap, and both should be freed
+    // by uMemPoolFree()
+    pSmall = (uint8_t *) uMemPoolMalloc(1);
+    U_PORT_TEST_ASSERT(pSmall != NULL);
+    *pSmall = 0xa5;
+    pBig = (uint8_t *) uMemPoolMalloc(U_MEMPOOL_MALLOC_LARGE_BLOCK_SIZE + 1);
+    U_PORT_TEST_ASSERT(pBig != NULL);
+    memset(pBig, 0x5a, U_MEMPOOL_MALLOC_LARGE_BLOCK_SIZE + 1);
+    memset(&statsBefore, 0, sizeof(statsBefore));
+    if (uMemPoolMallocGetStats(0, &statsBefore) == 0) {
+        U_TEST_PRINT_LINE("library-wide slab smallest class: block size %d, %d"
+                          " block(s), %d in use, high-water %d, %d failure(s).",
+                          (int32_t) statsBefore.blockSize, (int32_t) statsBefore.blockCount,
+                          (int32_t) statsBefore.inUse, (int32_t) statsBefore.inUseHighWater,
+                          (int32_t) statsBefore.failures);
+        U_PORT_TEST_ASSERT(statsBefore.inUse > 0);
+    }
+    U_PORT_TEST_ASSERT(*pSmall == 0xa5);
+    U_PORT_TEST_ASSERT(isAllBytes(pBig, U_MEMPOOL_MALLOC_LARGE_BLOCK_SIZE + 1, 0x5a));
+    uMemPoolFree(pSmall);
+    uMemPoolFree(pBig);
+    uMemPoolFree(NULL);
+    if (uMemPoolMallocGetStats(0, &stats) == 0) {
+        U_PORT_TEST_ASSERT(stats.inUse == statsBefore.inUse - 1);
+    }
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+/** Benchmark allocating and freeing blocks from a memory pool, from
+ * a slab and from the library-wide slab with uMemPoolMalloc().
+ */
+U_PORT_BENCH_FUNCTION("[mempool]", "mempoolBenchAllocFree")
+{
+    uMemPoolDesc_t mempoolDesc;
+    uMemPoolSlab_t slab;
+    void *pBuf[TEST_BLOCK_COUNT];
+    uBench_t bench;
+    size_t numAllocs = 0;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uMemPoolInit(&mempoolDesc, TEST_BLOCK_SIZE,
+                                    TEST_BLOCK_COUNT) == U_ERROR_COMMON_SUCCESS);
+    uBenchStart(&bench, "mempoolAllocFree");
+    for (size_t x = 0; x < U_TEST_MEMPOOL_BENCH_ITERATIONS; x++) {
+        for (size_t y = 0; y < TEST_BLOCK_COUNT; y++) {
+            pBuf[y] = uMemPoolAllocMem(&mempoolDesc);
+            U_PORT_TEST_ASSERT(pBuf[y] != NULL);
+        }
+        for (size_t y = 0; y < TEST_BLOCK_COUNT; y++) {
+            uMemPoolFreeMem(&mempoolDesc, pBuf[y]);
+        }
+        numAllocs += TEST_BLOCK_COUNT;
+    }
+    uBenchStop(&bench, U_TEST_MEMPOOL_BENCH_ITERATIONS, (uint32_t) numAllocs, "allocs");
+    uMemPoolDeinit(&mempoolDesc);
+
+    U_PORT_TEST_ASSERT(uMemPoolSlabInit(&slab, gSlabCfg, TEST_SLAB_NUM_CLASSES,
+                                        gSlabBuffer + 1, sizeof(gSlabBuffer) - 1) == 0);
+    numAllocs = 0;
+    uBenchStart(&bench, "mempoolSlabAllocFree");
+    for (size_t x = 0; x < U_TEST_MEMPOOL_BENCH_ITERATIONS; x++) {
+        // One block of each class
+        for (size_t y = 0; y < TEST_SLAB_NUM_CLASSES; y++) {
+            pBuf[y] = uMemPoolSlabAlloc(&slab, gSlabCfg[y].blockSize);
+            U_PORT_TEST_ASSERT(pBuf[y] != NULL);
+        }
+        for (size_t y = 0; y < TEST_SLAB_NUM_CLASSES; y++) {
+            U_PORT_TEST_ASSERT(uMemPoolSlabFree(&slab, pBuf[y]));
+        }
+        numAllocs += TEST_SLAB_NUM_CLASSES;
+    }
+    uBenchStop(&bench, U_TEST_MEMPOOL_BENCH_ITERATIONS, (uint32_t) numAllocs, "allocs");
+    uMemPoolSlabDeinit(&slab);
+
+    numAllocs = 0;
+    uBenchStart(&bench, "mempoolMallocFree");
+    for (size_t x = 0; x < U_TEST_MEMPOOL_BENCH_ITERATIONS; x++) {
+        for (size_t y = 0; y < TEST_BLOCK_COUNT; y++) {
+            pBuf[y] = uMemPoolMalloc(TEST_BLOCK_SIZE);
+            U_PORT_TEST_ASSERT(pBuf[y] != NULL);
+        }
+        for (size_t y = 0; y < TEST_BLOCK_COUNT; y++) {
+            uMemPoolFree(pBuf[y]);
+        }
+        numAllocs += TEST_BLOCK_COUNT;
+    }
+    uBenchStop(&bench, U_TEST_MEMPOOL_BENCH_ITERATIONS, (uint32_t) numAllocs, "allocs");
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+// End of file
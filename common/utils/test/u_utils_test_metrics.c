@@ -0,0 +1,277 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the metrics registry API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strcmp(), strstr()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"  // For #define U_CFG_OS_CLIB_LEAKS
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* struct timeval in some cases. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+#include "u_metrics.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_METRICS_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The export period to use in the test.
+ */
+#define U_METRICS_TEST_EXPORT_PERIOD_MS 100
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The bin limits of the test histogram.
+ */
+static const int32_t gBinLimit[] = {10, 100};
+
+/** The bin counts of the test histogram.
+ */
+static uint32_t gBinCount[3];
+
+/** The value returned by the read function of the test gauge.
+ */
+static int32_t gReadValue = 0;
+
+/** The number of times exportCallback() has been called.
+ */
+static volatile int32_t gExportCount = 0;
+
+/** The length of the JSON passed to exportCallback().
+ */
+static volatile size_t gExportLength = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Read function for a gauge.
+static int32_t readCallback(void *pReadParam)
+{
+    return *((int32_t *) pReadParam);
+}
+
+// Enumeration callback that counts the metrics it is called with
+// and stops after the number given in the parameter.
+static bool enumerateCallback(const uMetric_t *pMetric, void *pParam)
+{
+    int32_t *pCount = (int32_t *) pParam;
+
+    U_TEST_PRINT_LINE("metric \"%s\", type %d, value %d.", pUMetricsName(pMetric),
+                      uMetricsType(pMetric), uMetricsValue(pMetric));
+    (*pCount)--;
+
+    return (*pCount > 0);
+}
+
+// Export callback.
+static void exportCallback(const char *pJson, size_t length, void *pParam)
+{
+    (void) pParam;
+
+    U_TEST_PRINT_LINE("export %s.", pJson);
+    gExportLength = length;
+    gExportCount++;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Basic test: set up, register, update, enumerate, format and
+ * export metrics of each type.
+ */
+U_PORT_TEST_FUNCTION("[metrics]", "metricsBasic")
+{
+    int32_t heapUsed;
+    uMetric_t counter;
+    uMetric_t gauge;
+    uMetric_t gaugeRead;
+    uMetric_t histogram;
+    const uMetric_t *pMetric;
+    char buffer[128];
+    int32_t x;
+    int32_t startTimeMs;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    uMetricsCounterInit(&counter, "test.counter");
+    uMetricsGaugeInit(&gauge, "test.gauge", NULL, NULL);
+    uMetricsGaugeInit(&gaugeRead, "test.gauge_read", readCallback, &gReadValue);
+    uMetricsHistogramInit(&histogram, "test.histogram", gBinLimit, gBinCount,
+                          sizeof(gBinCount) / sizeof(gBinCount[0]));
+
+    // Neither NULL nor a histogram with no bins is allowed
+    U_PORT_TEST_ASSERT(uMetricsRegister(NULL) < 0);
+    uMetricsHistogramInit(&histogram, "test.histogram", gBinLimit, gBinCount, 0);
+    U_PORT_TEST_ASSERT(uMetricsRegister(&histogram) < 0);
+    uMetricsHistogramInit(&histogram, "test.histogram", gBinLimit, gBinCount,
+                          sizeof(gBinCount) / sizeof(gBinCount[0]));
+
+    // Register them all, twice for one of them, which should be fine
+    U_PORT_TEST_ASSERT(uMetricsRegister(&counter) == 0);
+    U_PORT_TEST_ASSERT(uMetricsRegister(&counter) == 0);
+    U_PORT_TEST_ASSERT(uMetricsRegister(&gauge) == 0);
+    U_PORT_TEST_ASSERT(uMetricsRegister(&gaugeRead) == 0);
+    U_PORT_TEST_ASSERT(uMetricsRegister(&histogram) == 0);
+
+    // Update them
+    uMetricsCounterAdd(&counter, 5);
+    uMetricsCounterAdd(&counter, 7);
+    uMetricsGaugeSet(&gauge, -3);
+    // Setting a gauge that has a read function has no effect
+    uMetricsGaugeSet(&gaugeRead, 1000);
+    gReadValue = 42;
+    uMetricsHistogramAdd(&histogram, 1);
+    uMetricsHistogramAdd(&histogram, 10);
+    uMetricsHistogramAdd(&histogram, 11);
+    uMetricsHistogramAdd(&histogram, 5000);
+    // Adding to the wrong type should do nothing
+    uMetricsCounterAdd(&gauge, 1);
+    uMetricsGaugeSet(&counter, 1);
+
+    // Read them back
+    pMetric = pUMetricsFind("test.counter");
+    U_PORT_TEST_ASSERT(pMetric == &counter);
+    U_PORT_TEST_ASSERT(uMetricsType(pMetric) == U_METRICS_TYPE_COUNTER);
+    U_PORT_TEST_ASSERT(uMetricsValue(pMetric) == 12);
+    pMetric = pUMetricsFind("test.gauge");
+    U_PORT_TEST_ASSERT(pMetric == &gauge);
+    U_PORT_TEST_ASSERT(uMetricsValue(pMetric) == -3);
+    pMetric = pUMetricsFind("test.gauge_read");
+    U_PORT_TEST_ASSERT(pMetric == &gaugeRead);
+    U_PORT_TEST_ASSERT(uMetricsValue(pMetric) == 42);
+    pMetric = pUMetricsFind("test.histogram");
+    U_PORT_TEST_ASSERT(pMetric == &histogram);
+    U_PORT_TEST_ASSERT(uMetricsValue(pMetric) == 5022);
+    U_PORT_TEST_ASSERT(uMetricsHistogramNumBins(pMetric) == 3);
+    U_PORT_TEST_ASSERT(uMetricsHistogramBinCount(pMetric, 0) == 2);
+    U_PORT_TEST_ASSERT(uMetricsHistogramBinCount(pMetric, 1) == 1);
+    U_PORT_TEST_ASSERT(uMetricsHistogramBinCount(pMetric, 2) == 1);
+    U_PORT_TEST_ASSERT(uMetricsHistogramBinCount(pMetric, 3) == 0);
+    U_PORT_TEST_ASSERT(pUMetricsFind("test.not_there") == NULL);
+
+    // Enumerate: other modules may have registered metrics of
+    // their own so there will be at least four; then check that
+    // the enumeration can be stopped early
+    x = 1000;
+    U_PORT_TEST_ASSERT(uMetricsEnumerate(enumerateCallback, &x) >= 4);
+    x = 2;
+    U_PORT_TEST_ASSERT(uMetricsEnumerate(enumerateCallback, &x) == 2);
+    U_PORT_TEST_ASSERT(uMetricsEnumerate(NULL, NULL) < 0);
+    uMetricsPrint();
+
+    // Format as JSON; a buffer that is too small should still
+    // result in valid, if empty, JSON
+    U_PORT_TEST_ASSERT(uMetricsToJson(buffer, 2) < 0);
+    U_PORT_TEST_ASSERT(uMetricsToJson(buffer, 3) == 2);
+    U_PORT_TEST_ASSERT(strcmp(buffer, "{}") == 0);
+    x = uMetricsToJson(buffer, sizeof(buffer));
+    U_TEST_PRINT_LINE("JSON (%d byte(s)): %s.", x, buffer);
+    U_PORT_TEST_ASSERT(x == (int32_t) strlen(buffer));
+    U_PORT_TEST_ASSERT(buffer[0] == '{');
+    U_PORT_TEST_ASSERT(buffer[x - 1] == '}');
+    U_PORT_TEST_ASSERT(strstr(buffer, "\"test.counter\":12") != NULL);
+    U_PORT_TEST_ASSERT(strstr(buffer, "\"test.gauge\":-3") != NULL);
+    U_PORT_TEST_ASSERT(strstr(buffer, "\"test.gauge_read\":42") != NULL);
+    U_PORT_TEST_ASSERT(strstr(buffer,
+                              "\"test.histogram\":{\"sum\":5022,\"bins\":[2,1,1]}") != NULL);
+
+    // Export
+    gExportCount = 0;
+    U_PORT_TEST_ASSERT(uMetricsExportStart(0, exportCallback, NULL) < 0);
+    U_PORT_TEST_ASSERT(uMetricsExportStart(U_METRICS_TEST_EXPORT_PERIOD_MS,
+                                           exportCallback, NULL) == 0);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gExportCount < 2) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_METRICS_TEST_EXPORT_PERIOD_MS * 20)) {
+        uPortTaskBlock(10);
+    }
+    uMetricsExportStop();
+    x = gExportCount;
+    U_TEST_PRINT_LINE("export was called %d time(s).", x);
+    U_PORT_TEST_ASSERT(x >= 2);
+    U_PORT_TEST_ASSERT(gExportLength > 2);
+    uPortTaskBlock(U_METRICS_TEST_EXPORT_PERIOD_MS * 3);
+    U_PORT_TEST_ASSERT(gExportCount == x);
+    // Stopping twice should be fine
+    uMetricsExportStop();
+
+    // Reset and deregister
+    uMetricsReset(&histogram);
+    U_PORT_TEST_ASSERT(uMetricsValue(&histogram) == 0);
+    U_PORT_TEST_ASSERT(uMetricsHistogramBinCount(&histogram, 0) == 0);
+    uMetricsDeregister(&counter);
+    uMetricsDeregister(&gauge);
+    uMetricsDeregister(&gaugeRead);
+    uMetricsDeregister(&histogram);
+    // Twice should be fine
+    uMetricsDeregister(&histogram);
+    U_PORT_TEST_ASSERT(pUMetricsFind("test.counter") == NULL);
+    U_PORT_TEST_ASSERT(pUMetricsFind("test.histogram") == NULL);
+
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed <= 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+// End of file
@@ -46,6 +46,8 @@
 
 #include "u_ringbuffer.h"
 
+#include "u_bench.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -75,6 +77,20 @@
 # define U_TEST_UTILS_RINGBUFFER_FILL_CHAR 0x5a
 #endif
 
+#ifndef U_TEST_UTILS_RINGBUFFER_BENCH_ITERATIONS
+/** The number of add/read pairs to time in the benchmark.
+ */
+# define U_TEST_UTILS_RINGBUFFER_BENCH_ITERATIONS 20000
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_BENCH_CHUNK_SIZE
+/** The size of each add and read in the benchmark, deliberately
+ * not a divisor of the ring buffer size so that the adds and reads
+ * wrap.
+ */
+# define U_TEST_UTILS_RINGBUFFER_BENCH_CHUNK_SIZE 100
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -83,6 +99,19 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The number of times testParser() has been called.
+ */
+static size_t gParseCount = 0;
+
+/** Linear buffer for the benchmark.
+ */
+static char gBenchLinearBuffer[1024];
+
+/** Data buffers for the benchmark.
+ */
+static char gBenchIn[U_TEST_UTILS_RINGBUFFER_BENCH_CHUNK_SIZE];
+static char gBenchOut[U_TEST_UTILS_RINGBUFFER_BENCH_CHUNK_SIZE];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -107,6 +136,37 @@ static void printBuffer(const char *pTitle, const char *pStr, size_t length)
     uPortTaskBlock(10);
 }
 
+// A parser for messages which are 0xA5, a length byte and then
+// that many bytes of body.
+static int32_t testParser(uParseHandle_t parseHandle, void *pUserParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+    const char *pBody;
+    uint8_t c = 0;
+    size_t length;
+
+    (void) pUserParam;
+    gParseCount++;
+    if (!uRingBufferGetByteUnprotected(parseHandle, &c)) {
+        errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    } else if (c == 0xA5) {
+        errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        if (uRingBufferGetByteUnprotected(parseHandle, &c)) {
+            length = c;
+            if (length > uRingBufferBytesAvailableUnprotected(parseHandle)) {
+                uRingBufferParseNeedBytesUnprotected(parseHandle, length);
+            } else {
+                while (length > 0) {
+                    length -= uRingBufferGetBytesUnprotected(parseHandle, &pBody, length);
+                }
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -123,6 +183,7 @@ U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferBasic")
     size_t readLoss = 0;
     size_t readLossHandle[U_TEST_UTILS_RINGBUFFER_READ_HANDLES_MAX_NUM] = {0};
     char b = ~U_TEST_UTILS_RINGBUFFER_FILL_CHAR;
+    const char *pData;
     size_t y;
     size_t z;
 
@@ -806,6 +867,30 @@ U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferBasic")
     // Now the whole ring buffer should be available again
     U_PORT_TEST_ASSERT(uRingBufferAvailableSize(&ringBuffer) == sizeof(linearBuffer) - 1);
     U_PORT_TEST_ASSERT(uRingBufferAvailableSizeMax(&ringBuffer) == sizeof(linearBuffer) - 1);
+
+    // Look at data in place: it may wrap, in which case it comes in two parts
+    U_TEST_PRINT_LINE("testing in-place peek...");
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, sizeof(bufferIn) - 1));
+    pData = NULL;
+    y = uRingBufferPeekContiguousHandle(&ringBuffer, handle[0], &pData, 0);
+    U_TEST_PRINT_LINE(" in-place peek returned %d byte(s).", y);
+    U_PORT_TEST_ASSERT((y > 0) && (y <= sizeof(bufferIn) - 1));
+    U_PORT_TEST_ASSERT(memcmp(pData, bufferIn, y) == 0);
+    if (y < sizeof(bufferIn) - 1) {
+        z = uRingBufferPeekContiguousHandle(&ringBuffer, handle[0], &pData, y);
+        U_PORT_TEST_ASSERT(z == sizeof(bufferIn) - 1 - y);
+        U_PORT_TEST_ASSERT(pData == linearBuffer);
+        U_PORT_TEST_ASSERT(memcmp(pData, bufferIn + y, z) == 0);
+    }
+    U_PORT_TEST_ASSERT(uRingBufferPeekContiguousHandle(&ringBuffer, handle[0], &pData,
+                                                       sizeof(bufferIn) - 1) == 0);
+    // Nothing should have been read
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle[0]) == sizeof(bufferIn) - 1);
+    uRingBufferFlush(&ringBuffer);
+    uRingBufferFlushHandle(&ringBuffer, handle[0]);
+    uRingBufferFlushHandle(&ringBuffer, handle[1]);
+    U_PORT_TEST_ASSERT(uRingBufferAvailableSize(&ringBuffer) == sizeof(linearBuffer) - 1);
+
     uRingBufferGiveReadHandle(&ringBuffer, handle[0]);
     uRingBufferGiveReadHandle(&ringBuffer, handle[1]);
 
@@ -882,4 +967,515 @@ U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferBasic")
     U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
 }
 
-// End of file
\ No newline at end of file
+/** Test the lock-free ring buffer: since this can't be done from
+ * an interrupt here it is a single-threaded test of the pointer
+ * arithmetic, in particular around the wrap.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferLockFree")
+{
+    int32_t heapUsed;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    char bufferOut[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    char bufferIn[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    size_t addLoss = 0;
+    char c = 0;
+    size_t y;
+    size_t z;
+    size_t bytesRead = 0;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing lock-free ring buffer.");
+    for (size_t x = 0; x < sizeof(bufferIn); x++) {
+        bufferIn[x] = (char) x;
+    }
+    memset(linearBuffer, 0, sizeof(linearBuffer));
+
+    // uRingBufferAddIrq() must refuse a ring buffer with a mutex
+    U_PORT_TEST_ASSERT(uRingBufferCreate(&ringBuffer, linearBuffer, sizeof(linearBuffer)) == 0);
+    U_PORT_TEST_ASSERT(!uRingBufferAddIrq(&ringBuffer, bufferIn, 1));
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 0);
+    uRingBufferDelete(&ringBuffer);
+
+    U_PORT_TEST_ASSERT(uRingBufferCreateLockFree(&ringBuffer, linearBuffer,
+                                                 sizeof(linearBuffer)) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferAvailableSize(&ringBuffer) == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT(uRingBufferRead(&ringBuffer, bufferOut, sizeof(bufferOut)) == 0);
+    // Read handles are not supported
+    U_PORT_TEST_ASSERT(uRingBufferTakeReadHandle(&ringBuffer) < 0);
+
+    // Fill it, check that no more will go in, all or nothing
+    U_PORT_TEST_ASSERT(uRingBufferAddIrq(&ringBuffer, bufferIn, sizeof(bufferIn) - 1));
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == sizeof(bufferIn) - 1);
+    U_PORT_TEST_ASSERT(uRingBufferAvailableSize(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(!uRingBufferAddIrq(&ringBuffer, bufferIn, 1));
+    addLoss++;
+    // Forced add can't push data out from under the consumer
+    U_PORT_TEST_ASSERT(!uRingBufferForceAdd(&ringBuffer, bufferIn, 1));
+    addLoss++;
+    U_PORT_TEST_ASSERT(uRingBufferStatAddLoss(&ringBuffer) == addLoss);
+    U_PORT_TEST_ASSERT(uRingBufferStatReadLoss(&ringBuffer) == 0);
+
+    // Peek with an offset, then read it all
+    memset(bufferOut, U_TEST_UTILS_RINGBUFFER_FILL_CHAR, sizeof(bufferOut));
+    y = uRingBufferPeek(&ringBuffer, bufferOut, sizeof(bufferOut), 2);
+    U_PORT_TEST_ASSERT(y == sizeof(bufferIn) - 3);
+    U_PORT_TEST_ASSERT(memcmp(bufferOut, bufferIn + 2, y) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferPeek(&ringBuffer, bufferOut, sizeof(bufferOut),
+                                       sizeof(bufferIn) - 1) == 0);
+    memset(bufferOut, U_TEST_UTILS_RINGBUFFER_FILL_CHAR, sizeof(bufferOut));
+    y = uRingBufferRead(&ringBuffer, bufferOut, sizeof(bufferOut));
+    U_PORT_TEST_ASSERT(y == sizeof(bufferIn) - 1);
+    U_PORT_TEST_ASSERT(memcmp(bufferOut, bufferIn, y) == 0);
+    U_PORT_TEST_ASSERT(bufferOut[y] == U_TEST_UTILS_RINGBUFFER_FILL_CHAR);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferAvailableSize(&ringBuffer) == sizeof(linearBuffer) - 1);
+
+    // Now stream a sequence through it in chunks of every length
+    // that fits, reading in chunks of a different length, so that
+    // adds and reads land at every point of the wrap
+    U_TEST_PRINT_LINE("streaming through the lock-free ring buffer...");
+    y = 0;
+    for (size_t x = 0; x < 1000; x++) {
+        memset(bufferIn, 0, sizeof(bufferIn));
+        for (z = 0; z < (x % (sizeof(linearBuffer) - 1)) + 1; z++) {
+            bufferIn[z] = (char) (y + z);
+        }
+        if (uRingBufferAddIrq(&ringBuffer, bufferIn, (x % (sizeof(linearBuffer) - 1)) + 1)) {
+            y += (x % (sizeof(linearBuffer) - 1)) + 1;
+        } else {
+            addLoss += (x % (sizeof(linearBuffer) - 1)) + 1;
+        }
+        memset(bufferOut, 0, sizeof(bufferOut));
+        z = uRingBufferRead(&ringBuffer, bufferOut, (x % 3) + 3);
+        for (size_t w = 0; w < z; w++) {
+            U_PORT_TEST_ASSERT(bufferOut[w] == c);
+            c++;
+        }
+        bytesRead += z;
+    }
+    U_TEST_PRINT_LINE("%d byte(s) added, %d byte(s) read, %d byte(s) refused"
+                      " by a full ring buffer.", y, bytesRead, addLoss);
+    // Nothing must have been lost or repeated
+    U_PORT_TEST_ASSERT(bytesRead + uRingBufferDataSize(&ringBuffer) == y);
+    U_PORT_TEST_ASSERT(uRingBufferStatAddLoss(&ringBuffer) == addLoss);
+    uRingBufferFlush(&ringBuffer);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 0);
+
+    uRingBufferReset(&ringBuffer);
+    U_PORT_TEST_ASSERT(uRingBufferAvailableSize(&ringBuffer) == sizeof(linearBuffer) - 1);
+
+    U_TEST_PRINT_LINE("deleting lock-free ring buffer...");
+    uRingBufferDelete(&ringBuffer);
+    U_PORT_TEST_ASSERT(!uRingBufferAddIrq(&ringBuffer, bufferIn, 1));
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+/** Test the zero-copy functions, reserve/commit on the way in and
+ * spans/commit on the way out, for all three types of ring buffer.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferZeroCopy")
+{
+    int32_t heapUsed;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    uRingBufferSpan_t span[2];
+    int32_t handle = -1;
+    char *pWrite;
+    char c = 0;
+    char d = 0;
+    size_t y;
+    size_t z;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing zero-copy ring buffer access.");
+    for (size_t type = 0; type < 3; type++) {
+        memset(linearBuffer, 0, sizeof(linearBuffer));
+        switch (type) {
+            case 0:
+                U_TEST_PRINT_LINE(" normal ring buffer...");
+                U_PORT_TEST_ASSERT(uRingBufferCreate(&ringBuffer, linearBuffer,
+                                                     sizeof(linearBuffer)) == 0);
+                break;
+            case 1:
+                U_TEST_PRINT_LINE(" ring buffer with read handle...");
+                U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer,
+                                                                   sizeof(linearBuffer), 1) == 0);
+                uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+                handle = uRingBufferTakeReadHandle(&ringBuffer);
+                U_PORT_TEST_ASSERT(handle > 0);
+                break;
+            default:
+                U_TEST_PRINT_LINE(" lock-free ring buffer...");
+                U_PORT_TEST_ASSERT(uRingBufferCreateLockFree(&ringBuffer, linearBuffer,
+                                                             sizeof(linearBuffer)) == 0);
+                break;
+        }
+
+        // Empty: no spans, all of it reservable
+        if (type == 1) {
+            y = uRingBufferPeekSpansHandle(&ringBuffer, handle, span);
+        } else {
+            y = uRingBufferPeekSpans(&ringBuffer, span);
+        }
+        U_PORT_TEST_ASSERT(y == 0);
+        U_PORT_TEST_ASSERT((span[0].pData == NULL) && (span[0].length == 0));
+        U_PORT_TEST_ASSERT((span[1].pData == NULL) && (span[1].length == 0));
+        pWrite = NULL;
+        y = uRingBufferWriteReserve(&ringBuffer, &pWrite, sizeof(linearBuffer));
+        U_PORT_TEST_ASSERT(y == sizeof(linearBuffer) - 1);
+        U_PORT_TEST_ASSERT(pWrite == linearBuffer);
+        // Dropping the reservation adds nothing
+        U_PORT_TEST_ASSERT(uRingBufferWriteCommit(&ringBuffer, 0));
+
+        // Now stream a sequence through, writing and reading in
+        // place in chunks of different lengths so that both
+        // land at every point of the wrap
+        for (size_t x = 0; x < 200; x++) {
+            pWrite = NULL;
+            y = uRingBufferWriteReserve(&ringBuffer, &pWrite, (x % 4) + 1);
+            U_PORT_TEST_ASSERT(y <= (x % 4) + 1);
+            if (y > 0) {
+                U_PORT_TEST_ASSERT((pWrite >= linearBuffer) &&
+                                   (pWrite + y <= linearBuffer + sizeof(linearBuffer)));
+                for (z = 0; z < y; z++) {
+                    *(pWrite + z) = c;
+                    c++;
+                }
+                U_PORT_TEST_ASSERT(uRingBufferWriteCommit(&ringBuffer, y));
+            }
+            if (type == 1) {
+                y = uRingBufferPeekSpansHandle(&ringBuffer, handle, span);
+                U_PORT_TEST_ASSERT(y == uRingBufferDataSizeHandle(&ringBuffer, handle));
+            } else {
+                y = uRingBufferPeekSpans(&ringBuffer, span);
+                U_PORT_TEST_ASSERT(y == uRingBufferDataSize(&ringBuffer));
+            }
+            U_PORT_TEST_ASSERT(y == span[0].length + span[1].length);
+            if (span[1].length > 0) {
+                // Only the second span can start at the beginning
+                U_PORT_TEST_ASSERT(span[1].pData == linearBuffer);
+                U_PORT_TEST_ASSERT(span[0].pData + span[0].length == linearBuffer + sizeof(linearBuffer));
+            }
+            // Consume a varying amount, checking it as we go
+            z = (x % 3) + 1;
+            if (z > y) {
+                z = y;
+            }
+            for (size_t w = 0; w < z; w++) {
+                if (w < span[0].length) {
+                    U_PORT_TEST_ASSERT(*(span[0].pData + w) == d);
+                } else {
+                    U_PORT_TEST_ASSERT(*(span[1].pData + w - span[0].length) == d);
+                }
+                d++;
+            }
+            if (type == 1) {
+                U_PORT_TEST_ASSERT(uRingBufferReadCommitHandle(&ringBuffer, handle, z) == z);
+            } else {
+                U_PORT_TEST_ASSERT(uRingBufferReadCommit(&ringBuffer, z) == z);
+            }
+        }
+        // What was written and not yet read must still be there
+        if (type == 1) {
+            y = uRingBufferDataSizeHandle(&ringBuffer, handle);
+        } else {
+            y = uRingBufferDataSize(&ringBuffer);
+        }
+        U_PORT_TEST_ASSERT((char) (d + y) == c);
+        U_PORT_TEST_ASSERT(uRingBufferStatAddLoss(&ringBuffer) == 0);
+
+        if (type == 1) {
+            // With the ring buffer full, a forced reservation must
+            // make room by pushing the read handle on, but not
+            // if the read handle is locked
+            uRingBufferFlushHandle(&ringBuffer, handle);
+            for (z = 0; z < sizeof(linearBuffer) - 1; z++) {
+                U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, &c, 1));
+            }
+            U_PORT_TEST_ASSERT(uRingBufferWriteReserve(&ringBuffer, &pWrite, 1) == 0);
+            y = uRingBufferStatReadLossHandle(&ringBuffer, handle);
+            uRingBufferLockReadHandle(&ringBuffer, handle);
+            U_PORT_TEST_ASSERT(uRingBufferForceWriteReserve(&ringBuffer, &pWrite, 1) == 0);
+            uRingBufferUnlockReadHandle(&ringBuffer, handle);
+            U_PORT_TEST_ASSERT(uRingBufferForceWriteReserve(&ringBuffer, &pWrite, 1) == 1);
+            U_PORT_TEST_ASSERT(uRingBufferWriteCommit(&ringBuffer, 1));
+            U_PORT_TEST_ASSERT(uRingBufferStatReadLossHandle(&ringBuffer, handle) == y + 1);
+            U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == sizeof(linearBuffer) - 1);
+            uRingBufferGiveReadHandle(&ringBuffer, handle);
+        }
+        uRingBufferDelete(&ringBuffer);
+        c = 0;
+        d = 0;
+    }
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferParserResume")
+{
+    int32_t heapUsed;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[32];
+    U_RING_BUFFER_PARSER_f parserList[] = {testParser, NULL};
+    U_RING_BUFFER_PARSER_f otherParserList[] = {testParser, NULL};
+    int32_t handle;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing registered parsers.");
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer,
+                                                       sizeof(linearBuffer), 1) == 0);
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    // Nothing registered
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+    U_PORT_TEST_ASSERT(uRingBufferParserRegister(&ringBuffer, 0, parserList) < 0);
+    U_PORT_TEST_ASSERT(uRingBufferParserRegister(&ringBuffer, handle, parserList) == 0);
+
+    // A junk byte then the first four bytes of a message with
+    // eight bytes of body: the junk is discarded and the parsers
+    // reach the message but need more data
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "x\xa5\x08" "ab", 5));
+    gParseCount = 0;
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) == 1);
+    U_PORT_TEST_ASSERT(gParseCount == 2);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 1) == 1);
+    // Now the parsers should not be run again until all of the
+    // body has arrived, even though data keeps arriving
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "cde", 3));
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "fg", 2));
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(gParseCount == 2);
+    // uRingBufferParseHandle() has no resume state, it parses every time
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseHandle(&ringBuffer, handle, parserList, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(gParseCount == 3);
+    // Registering the same list again keeps the state
+    U_PORT_TEST_ASSERT(uRingBufferParserRegister(&ringBuffer, handle, parserList) == 0);
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(gParseCount == 3);
+    // The last byte completes the message
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "h", 1));
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) == 10);
+    U_PORT_TEST_ASSERT(gParseCount == 4);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 10) == 10);
+
+    // A message whose parser doesn't say how much it needs is
+    // re-parsed whenever anything more arrives
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "\xa5", 1));
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(gParseCount == 5);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "\x01", 1));
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(gParseCount == 6);
+
+    // Registering a different list drops the state, flushing
+    // likewise, and with no registration there is nothing to parse
+    U_PORT_TEST_ASSERT(uRingBufferParserRegister(&ringBuffer, handle, otherParserList) == 0);
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(gParseCount == 7);
+    uRingBufferFlushHandle(&ringBuffer, handle);
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(uRingBufferParserRegister(&ringBuffer, handle, NULL) == 0);
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseRegistered(&ringBuffer, handle, NULL) ==
+                       (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+
+    uRingBufferGiveReadHandle(&ringBuffer, handle);
+    uRingBufferDelete(&ringBuffer);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferStats")
+{
+    int32_t heapUsed;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[16];
+    char buffer[10] = {0};
+    size_t bins[U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS + 2];
+    size_t expectedBins[U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS + 2] = {0};
+    int32_t handle;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("testing ring buffer statistics.");
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer,
+                                                       sizeof(linearBuffer), 1) == 0);
+    uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMark(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMarkHandle(&ringBuffer, handle) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferStatForcedAddEvictions(&ringBuffer) == 0);
+
+    // Each add samples the occupancy after it
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, buffer, 4));
+    expectedBins[(4 * U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) / sizeof(linearBuffer)]++;
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 4) == 4);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, buffer, 2));
+    expectedBins[(2 * U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) / sizeof(linearBuffer)]++;
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMark(&ringBuffer) == 4);
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMarkHandle(&ringBuffer, handle) == 4);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, buffer, 10));
+    expectedBins[(12 * U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) / sizeof(linearBuffer)]++;
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMark(&ringBuffer) == 12);
+    // A failed add is not sampled
+    U_PORT_TEST_ASSERT(!uRingBufferAdd(&ringBuffer, buffer, 8));
+    // A forced add that pushes data out is an eviction
+    U_PORT_TEST_ASSERT(uRingBufferForceAdd(&ringBuffer, buffer, 8));
+    expectedBins[U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS - 1]++;
+    U_PORT_TEST_ASSERT(uRingBufferStatForcedAddEvictions(&ringBuffer) == 1);
+    U_PORT_TEST_ASSERT(uRingBufferStatReadLossHandle(&ringBuffer, handle) == 5);
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMark(&ringBuffer) == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMarkHandle(&ringBuffer,
+                                                          handle) == sizeof(linearBuffer) - 1);
+    // A forced add that fits is not
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 10) == 10);
+    U_PORT_TEST_ASSERT(uRingBufferForceAdd(&ringBuffer, buffer, 1));
+    expectedBins[(6 * U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) / sizeof(linearBuffer)]++;
+    U_PORT_TEST_ASSERT(uRingBufferStatForcedAddEvictions(&ringBuffer) == 1);
+    memset(bins, 0xff, sizeof(bins));
+    U_PORT_TEST_ASSERT(uRingBufferStatOccupancy(&ringBuffer, bins,
+                                                sizeof(bins) / sizeof(bins[0])) ==
+                       U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS);
+    U_PORT_TEST_ASSERT(memcmp(bins, expectedBins, sizeof(bins)) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferStatOccupancy(&ringBuffer, bins, 1) == 1);
+    U_PORT_TEST_ASSERT(bins[0] == expectedBins[0]);
+    // A new read handle starts with a fresh high water mark, the
+    // ring buffer as a whole does not
+    uRingBufferGiveReadHandle(&ringBuffer, handle);
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMarkHandle(&ringBuffer, handle) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMark(&ringBuffer) == sizeof(linearBuffer) - 1);
+    uRingBufferGiveReadHandle(&ringBuffer, handle);
+    uRingBufferDelete(&ringBuffer);
+
+    // The lock-free case
+    U_PORT_TEST_ASSERT(uRingBufferCreateLockFree(&ringBuffer, linearBuffer,
+                                                 sizeof(linearBuffer)) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferAddIrq(&ringBuffer, buffer, 3));
+    U_PORT_TEST_ASSERT(uRingBufferStatHighWaterMark(&ringBuffer) == 3);
+    U_PORT_TEST_ASSERT(uRingBufferStatOccupancy(&ringBuffer, bins,
+                                                U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) ==
+                       U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS);
+    U_PORT_TEST_ASSERT(bins[(3 * U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS) / sizeof(linearBuffer)] == 1);
+    U_PORT_TEST_ASSERT(uRingBufferStatForcedAddEvictions(&ringBuffer) == 0);
+    uRingBufferDelete(&ringBuffer);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+/** Benchmark adding to and reading from a ring buffer, both the
+ * normal (mutex-protected) form and the lock-free form.
+ */
+U_PORT_BENCH_FUNCTION("[ringbuffer]", "ringbufferBenchAddRead")
+{
+    int32_t heapUsed;
+    uRingBuffer_t ringBuffer = {0};
+    uBench_t bench;
+    size_t numBytes;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    for (size_t x = 0; x < sizeof(gBenchIn); x++) {
+        gBenchIn[x] = (char) x;
+    }
+
+    for (size_t y = 0; y < 2; y++) {
+        if (y == 0) {
+            U_PORT_TEST_ASSERT(uRingBufferCreate(&ringBuffer, gBenchLinearBuffer,
+                                                 sizeof(gBenchLinearBuffer)) == 0);
+            uBenchStart(&bench, "ringbufferAddRead");
+        } else {
+            U_PORT_TEST_ASSERT(uRingBufferCreateLockFree(&ringBuffer, gBenchLinearBuffer,
+                                                         sizeof(gBenchLinearBuffer)) == 0);
+            uBenchStart(&bench, "ringbufferAddReadLockFree");
+        }
+        numBytes = 0;
+        for (size_t x = 0; x < U_TEST_UTILS_RINGBUFFER_BENCH_ITERATIONS; x++) {
+            if (y == 0) {
+                U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, gBenchIn, sizeof(gBenchIn)));
+            } else {
+                U_PORT_TEST_ASSERT(uRingBufferAddIrq(&ringBuffer, gBenchIn, sizeof(gBenchIn)));
+            }
+            numBytes += uRingBufferRead(&ringBuffer, gBenchOut, sizeof(gBenchOut));
+        }
+        uBenchStop(&bench, U_TEST_UTILS_RINGBUFFER_BENCH_ITERATIONS,
+                   (uint32_t) numBytes, "bytes");
+        U_PORT_TEST_ASSERT(numBytes == U_TEST_UTILS_RINGBUFFER_BENCH_ITERATIONS *
+                           sizeof(gBenchOut));
+        U_PORT_TEST_ASSERT(memcmp(gBenchIn, gBenchOut, sizeof(gBenchOut)) == 0);
+        uRingBufferDelete(&ringBuffer);
+    }
+
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+// End of file
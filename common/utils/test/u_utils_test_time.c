@@ -0,0 +1,171 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the time API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_time.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_TIME_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The number of years to check uTimeMonthsToSecondsUtc() over.
+ */
+#define U_TEST_TIME_YEARS 400
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A test vector.
+ */
+typedef struct {
+    int64_t secondsUtc;
+    uTimeDateTime_t dateTime;
+} uTestTimeVector_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Test vectors, including either side of the leap days of 2000,
+ * which is a leap year, and 2100, which is not.
+ */
+static const uTestTimeVector_t gVector[] = {
+    {0, {1970, 1, 1, 0, 0, 0}},
+    {-1, {1969, 12, 31, 23, 59, 59}},
+    {68169600LL, {1972, 2, 29, 0, 0, 0}},
+    {951782400LL, {2000, 2, 29, 0, 0, 0}},
+    {951868800LL, {2000, 3, 1, 0, 0, 0}},
+    {1636482251LL, {2021, 11, 9, 18, 24, 11}},
+    {2114380800LL, {2037, 1, 1, 0, 0, 0}},
+    {2524608000LL, {2050, 1, 1, 0, 0, 0}},
+    {4107542399LL, {2100, 2, 28, 23, 59, 59}},
+    {4107542400LL, {2100, 3, 1, 0, 0, 0}},
+    {-2208988800LL, {1900, 1, 1, 0, 0, 0}}
+};
+
+/** Days in each month, for the reference implementation.
+ */
+static const int32_t gDaysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return true if the two date/times are the same.
+static bool dateTimeEqual(const uTimeDateTime_t *pA, const uTimeDateTime_t *pB)
+{
+    return (pA->year == pB->year) && (pA->month == pB->month) &&
+           (pA->day == pB->day) && (pA->hour == pB->hour) &&
+           (pA->minute == pB->minute) && (pA->second == pB->second);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test the calendar conversions.
+ */
+U_PORT_TEST_FUNCTION("[time]", "timeConversion")
+{
+    uTimeDateTime_t dateTime;
+    uTimeDateTime_t previous;
+    int64_t secondsUtc = 0;
+    int32_t days;
+
+    U_TEST_PRINT_LINE("testing vectors.");
+    for (size_t x = 0; x < sizeof(gVector) / sizeof(gVector[0]); x++) {
+        U_PORT_TEST_ASSERT(uTimeToSecondsUtc(&gVector[x].dateTime) == gVector[x].secondsUtc);
+        uTimeFromSecondsUtc(gVector[x].secondsUtc, &dateTime);
+        U_PORT_TEST_ASSERT(dateTimeEqual(&dateTime, &gVector[x].dateTime));
+    }
+    U_PORT_TEST_ASSERT(uTimeIsLeapYear(2000));
+    U_PORT_TEST_ASSERT(uTimeIsLeapYear(2024));
+    U_PORT_TEST_ASSERT(!uTimeIsLeapYear(2100));
+    U_PORT_TEST_ASSERT(!uTimeIsLeapYear(2023));
+    // Months out of range move the year
+    U_PORT_TEST_ASSERT(uTimeDaysFromDate(1970, 13, 1) == 365);
+    U_PORT_TEST_ASSERT(uTimeDaysFromDate(1971, 0, 31) == 364);
+
+    U_TEST_PRINT_LINE("testing months against a month-by-month count.");
+    for (int32_t months = 0; months < U_TEST_TIME_YEARS * 12; months++) {
+        U_PORT_TEST_ASSERT(uTimeMonthsToSecondsUtc(months) == secondsUtc);
+        days = gDaysInMonth[months % 12];
+        if (((months % 12) == 1) && uTimeIsLeapYear((months / 12) + 1970)) {
+            days++;
+        }
+        secondsUtc += ((int64_t) days) * 3600 * 24;
+    }
+
+    U_TEST_PRINT_LINE("testing every day back and forth from 1900 to 2300.");
+    uTimeFromSecondsUtc(-2208988800LL - 1, &previous);
+    for (days = -25567; days < 120526; days++) {
+        secondsUtc = (((int64_t) days) * 3600 * 24) + 45296;
+        uTimeFromSecondsUtc(secondsUtc, &dateTime);
+        U_PORT_TEST_ASSERT((dateTime.hour == 12) && (dateTime.minute == 34) &&
+                           (dateTime.second == 56));
+        U_PORT_TEST_ASSERT(uTimeToSecondsUtc(&dateTime) == secondsUtc);
+        // Must be the day after the previous one
+        if (dateTime.day > 1) {
+            U_PORT_TEST_ASSERT((dateTime.year == previous.year) &&
+                               (dateTime.month == previous.month) &&
+                               (dateTime.day == previous.day + 1));
+        } else if (dateTime.month > 1) {
+            U_PORT_TEST_ASSERT((dateTime.year == previous.year) &&
+                               (dateTime.month == previous.month + 1));
+        } else {
+            U_PORT_TEST_ASSERT((dateTime.year == previous.year + 1) &&
+                               (previous.month == 12) && (previous.day == 31));
+        }
+        previous = dateTime;
+    }
+}
+
+// End of file
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the timer wheel API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"  // For #define U_CFG_OS_CLIB_LEAKS
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* struct timeval in some cases. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+#include "u_timer_wheel.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_TIMER_WHEEL_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The number of one-shot timers in the basic test.
+ */
+#define U_TIMER_WHEEL_TEST_NUM_TIMERS 4
+
+/** The period of the periodic timer in the basic test.
+ */
+#define U_TIMER_WHEEL_TEST_PERIOD_MS 50
+
+/** The margin to allow on top of a tick for the OS to get
+ * around to calling the port timer callback.
+ */
+#define U_TIMER_WHEEL_TEST_MARGIN_MS 100
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Per-timer test data.
+ */
+typedef struct {
+    int32_t startTimeMs;
+    int32_t expiryTimeMs;
+    size_t count;
+    size_t order;
+} uTimerWheelTestTimer_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The intervals of the one-shot timers of the basic test, not in
+ * order and with the last reaching beyond the first level of the
+ * wheel.
+ */
+static const uint32_t gIntervalMs[U_TIMER_WHEEL_TEST_NUM_TIMERS] = {
+    300, 20, 150, (U_TIMER_WHEEL_TICK_MS * 64) + 200
+};
+
+/** The order in which the one-shot timers of the basic test
+ * should expire.
+ */
+static const size_t gOrder[U_TIMER_WHEEL_TEST_NUM_TIMERS] = {2, 0, 1, 3};
+
+/** The timers.
+ */
+static uTimerWheelTimer_t gTimer[U_TIMER_WHEEL_TEST_NUM_TIMERS + 1];
+
+/** Test data for the timers.
+ */
+static uTimerWheelTestTimer_t gTestTimer[U_TIMER_WHEEL_TEST_NUM_TIMERS + 1];
+
+/** The number of timers that have expired, used to check the order.
+ */
+static volatile size_t gNumExpired = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Timer callback.
+static void timerCallback(uTimerWheelTimer_t *pTimer, void *pCallbackParam)
+{
+    uTimerWheelTestTimer_t *pTestTimer = (uTimerWheelTestTimer_t *) pCallbackParam;
+
+    (void) pTimer;
+
+    if (pTestTimer->count == 0) {
+        pTestTimer->expiryTimeMs = uPortGetTickTimeMs();
+        pTestTimer->order = gNumExpired;
+        gNumExpired++;
+    }
+    pTestTimer->count++;
+}
+
+// Callback for the periodic timer: just counts, it must not
+// take part in the ordering of the one-shot timers.
+static void periodicTimerCallback(uTimerWheelTimer_t *pTimer, void *pCallbackParam)
+{
+    uTimerWheelTestTimer_t *pTestTimer = (uTimerWheelTestTimer_t *) pCallbackParam;
+
+    (void) pTimer;
+
+    pTestTimer->count++;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Basic test: one-shot timers expire in order and never early,
+ * a periodic timer keeps going, stopping a timer stops it and
+ * a timer without a callback can be polled.
+ */
+U_PORT_TEST_FUNCTION("[timerWheel]", "timerWheelBasic")
+{
+    int32_t heapUsed;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    uTimerWheelTestTimer_t *pTestTimer;
+    uTimerWheelTimer_t polledTimer;
+    size_t count;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_PORT_TEST_ASSERT(uTimerWheelInit() == 0);
+    // Twice should be fine
+    U_PORT_TEST_ASSERT(uTimerWheelInit() == 0);
+
+    // Not allowed to go beyond the maximum
+    uTimerWheelTimerInit(&polledTimer, NULL, NULL);
+    U_PORT_TEST_ASSERT(uTimerWheelTimerStart(&polledTimer, U_TIMER_WHEEL_INTERVAL_MAX_MS + 1,
+                                             false) < 0);
+    U_PORT_TEST_ASSERT(!uTimerWheelTimerIsRunning(&polledTimer));
+
+    // Start the one-shot timers
+    gNumExpired = 0;
+    for (size_t x = 0; x < U_TIMER_WHEEL_TEST_NUM_TIMERS; x++) {
+        pTestTimer = &(gTestTimer[x]);
+        pTestTimer->count = 0;
+        uTimerWheelTimerInit(&(gTimer[x]), timerCallback, pTestTimer);
+        pTestTimer->startTimeMs = uPortGetTickTimeMs();
+        U_PORT_TEST_ASSERT(uTimerWheelTimerStart(&(gTimer[x]), gIntervalMs[x], false) == 0);
+        U_PORT_TEST_ASSERT(uTimerWheelTimerIsRunning(&(gTimer[x])));
+        U_PORT_TEST_ASSERT(!uTimerWheelTimerExpired(&(gTimer[x])));
+    }
+
+    // Start the periodic timer
+    pTestTimer = &(gTestTimer[U_TIMER_WHEEL_TEST_NUM_TIMERS]);
+    pTestTimer->count = 0;
+    uTimerWheelTimerInit(&(gTimer[U_TIMER_WHEEL_TEST_NUM_TIMERS]), periodicTimerCallback,
+                         pTestTimer);
+    U_PORT_TEST_ASSERT(uTimerWheelTimerStart(&(gTimer[U_TIMER_WHEEL_TEST_NUM_TIMERS]),
+                                             U_TIMER_WHEEL_TEST_PERIOD_MS, true) == 0);
+
+    // Wait for the longest one-shot timer to be done
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gNumExpired < U_TIMER_WHEEL_TEST_NUM_TIMERS) &&
+           (uPortGetTickTimeMs() - startTimeMs < (int32_t) gIntervalMs[3] +
+            (U_TIMER_WHEEL_TEST_MARGIN_MS * 10))) {
+        uPortTaskBlock(10);
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("%d one-shot timer(s) expired in %d ms.", gNumExpired, durationMs);
+
+    // Stop the periodic timer and check it got there no
+    // more often than it should have
+    uTimerWheelTimerStop(&(gTimer[U_TIMER_WHEEL_TEST_NUM_TIMERS]));
+    U_PORT_TEST_ASSERT(!uTimerWheelTimerIsRunning(&(gTimer[U_TIMER_WHEEL_TEST_NUM_TIMERS])));
+    count = pTestTimer->count;
+    U_TEST_PRINT_LINE("periodic timer expired %d time(s).", count);
+    U_PORT_TEST_ASSERT(count <= (size_t) (durationMs / U_TIMER_WHEEL_TEST_PERIOD_MS) + 1);
+    U_PORT_TEST_ASSERT(count >= 2);
+
+    // Check the one-shot timers
+    U_PORT_TEST_ASSERT(gNumExpired == U_TIMER_WHEEL_TEST_NUM_TIMERS);
+    for (size_t x = 0; x < U_TIMER_WHEEL_TEST_NUM_TIMERS; x++) {
+        pTestTimer = &(gTestTimer[x]);
+        durationMs = pTestTimer->expiryTimeMs - pTestTimer->startTimeMs;
+        U_TEST_PRINT_LINE("timer %d, interval %d ms, expired %d time(s) after %d ms, order %d.",
+                          x, gIntervalMs[x], pTestTimer->count, durationMs, pTestTimer->order);
+        U_PORT_TEST_ASSERT(pTestTimer->count == 1);
+        U_PORT_TEST_ASSERT(!uTimerWheelTimerIsRunning(&(gTimer[x])));
+        U_PORT_TEST_ASSERT(uTimerWheelTimerExpired(&(gTimer[x])));
+        // Never early
+        U_PORT_TEST_ASSERT(durationMs >= (int32_t) gIntervalMs[x]);
+        U_PORT_TEST_ASSERT(durationMs <= (int32_t) gIntervalMs[x] + U_TIMER_WHEEL_TICK_MS +
+                           U_TIMER_WHEEL_TEST_MARGIN_MS);
+        // Expired in order of interval
+        U_PORT_TEST_ASSERT(pTestTimer->order == gOrder[x]);
+    }
+
+    // The periodic timer should do nothing more once stopped
+    uPortTaskBlock(U_TIMER_WHEEL_TEST_PERIOD_MS * 4);
+    U_PORT_TEST_ASSERT(gTestTimer[U_TIMER_WHEEL_TEST_NUM_TIMERS].count <= count + 1);
+
+    // Start a timer, restart it with a longer interval,
+    // stop it and check that it does not expire
+    pTestTimer = &(gTestTimer[0]);
+    pTestTimer->count = 0;
+    U_PORT_TEST_ASSERT(uTimerWheelTimerStart(&(gTimer[0]), 50, false) == 0);
+    U_PORT_TEST_ASSERT(uTimerWheelTimerStart(&(gTimer[0]), 200, false) == 0);
+    uPortTaskBlock(100);
+    U_PORT_TEST_ASSERT(pTestTimer->count == 0);
+    U_PORT_TEST_ASSERT(uTimerWheelTimerIsRunning(&(gTimer[0])));
+    uTimerWheelTimerStop(&(gTimer[0]));
+    U_PORT_TEST_ASSERT(!uTimerWheelTimerIsRunning(&(gTimer[0])));
+    uPortTaskBlock(200 + U_TIMER_WHEEL_TEST_MARGIN_MS);
+    U_PORT_TEST_ASSERT(pTestTimer->count == 0);
+    U_PORT_TEST_ASSERT(!uTimerWheelTimerExpired(&(gTimer[0])));
+
+    // Poll a timer that has no callback, in the way
+    // a uPortGetTickTimeMs() loop would be written
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(uTimerWheelTimerStart(&polledTimer, 250, false) == 0);
+    while (!uTimerWheelTimerExpired(&polledTimer) &&
+           (uPortGetTickTimeMs() - startTimeMs < 250 + (U_TIMER_WHEEL_TEST_MARGIN_MS * 10))) {
+        uPortTaskBlock(10);
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("polled timer expired after %d ms.", durationMs);
+    U_PORT_TEST_ASSERT(uTimerWheelTimerExpired(&polledTimer));
+    U_PORT_TEST_ASSERT(durationMs >= 250);
+    U_PORT_TEST_ASSERT(!uTimerWheelTimerIsRunning(&polledTimer));
+
+    // Leave a timer running across deinitialisation
+    U_PORT_TEST_ASSERT(uTimerWheelTimerStart(&polledTimer, 1000, false) == 0);
+    uTimerWheelDeinit();
+    U_PORT_TEST_ASSERT(!uTimerWheelTimerIsRunning(&polledTimer));
+    U_PORT_TEST_ASSERT(uTimerWheelTimerStart(&polledTimer, 1000, false) < 0);
+
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed <= 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+// End of file
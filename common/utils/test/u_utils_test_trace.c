@@ -0,0 +1,307 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the binary trace API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy(), strcmp()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* struct timeval in some cases. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+#include "u_trace.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_TRACE_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The number of tasks that write to the trace at the same time.
+ */
+#define U_TRACE_TEST_NUM_TASKS 3
+
+/** The number of entries each of those tasks writes.
+ */
+#define U_TRACE_TEST_NUM_ENTRIES_PER_TASK (U_TRACE_NUM_ENTRIES * 4)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Somewhere to capture the output of uTraceDump().
+ */
+typedef struct {
+    uTraceDumpHeader_t header;
+    uTraceEntry_t entry[U_TRACE_NUM_ENTRIES];
+    size_t size;
+    size_t numWrites;
+} uTraceTestDump_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The output of uTraceDump(); static as it may be large.
+ */
+static uTraceTestDump_t gDump;
+
+/** The number of tasks that have finished.
+ */
+static volatile int32_t gNumTasksDone = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Write function for uTraceDump(), capturing the output in gDump.
+static int32_t dumpWrite(void *pParam, const char *pData, size_t size)
+{
+    uTraceTestDump_t *pDump = (uTraceTestDump_t *) pParam;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+
+    if (pDump->size + size <= sizeof(pDump->header) + sizeof(pDump->entry)) {
+        if (pDump->size < sizeof(pDump->header)) {
+            // The header is always written on its own
+            memcpy(&(pDump->header), pData, size);
+        } else {
+            memcpy(((char *) pDump->entry) + pDump->size - sizeof(pDump->header),
+                   pData, size);
+        }
+        pDump->size += size;
+        pDump->numWrites++;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Dump the trace into gDump, returning what uTraceDump() returned.
+static int32_t dump()
+{
+    memset(&gDump, 0, sizeof(gDump));
+    return uTraceDump(dumpWrite, &gDump);
+}
+
+// Get the event of a dumped entry.
+static uTraceEvent_t eventGet(const uTraceEntry_t *pEntry)
+{
+    return (uTraceEvent_t) (pEntry->tagAndEvent & 0xFFFF);
+}
+
+// Task that writes to the trace, the parameter being its
+// index, which is put in the top byte of the parameter of
+// each entry, the bottom bytes being a count.
+static void traceTask(void *pParameter)
+{
+    int32_t index = (int32_t) (intptr_t) pParameter;
+
+    for (int32_t x = 0; x < U_TRACE_TEST_NUM_ENTRIES_PER_TASK; x++) {
+        uTrace(U_TRACE_EVENT_USER_1, (index << 24) | x);
+        if ((x % 64) == 0) {
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        }
+    }
+    gNumTasksDone++;
+    uPortTaskDelete(NULL);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Basic test of uTrace(), uTraceDump() and uTraceClear().
+ */
+U_PORT_TEST_FUNCTION("[trace]", "traceBasic")
+{
+    int32_t heapUsed;
+    int32_t startTimeMs;
+
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_PORT_TEST_ASSERT(strcmp(pUTraceEventName(U_TRACE_EVENT_AT_COMMAND_START),
+                              "AT_COMMAND_START") == 0);
+    U_PORT_TEST_ASSERT(strcmp(pUTraceEventName(U_TRACE_EVENT_MAX_NUM), "?") == 0);
+    U_PORT_TEST_ASSERT(uTraceDump(NULL, NULL) < 0);
+
+    // Start from nothing
+    uTraceClear();
+    U_PORT_TEST_ASSERT(dump() == 0);
+    U_PORT_TEST_ASSERT(gDump.header.magic == U_TRACE_DUMP_MAGIC);
+    U_PORT_TEST_ASSERT(gDump.header.version == U_TRACE_FORMAT_VERSION);
+    U_PORT_TEST_ASSERT(gDump.header.entrySizeBytes == sizeof(uTraceEntry_t));
+    U_PORT_TEST_ASSERT(gDump.header.total == 0);
+    U_PORT_TEST_ASSERT(gDump.header.numEntries == 0);
+    U_PORT_TEST_ASSERT(gDump.size == sizeof(gDump.header));
+
+    // Write a few entries and read them back
+    startTimeMs = uPortGetTickTimeMs();
+    uTrace(U_TRACE_EVENT_USER_0, 0);
+    uTrace(U_TRACE_EVENT_USER_1, -1);
+    uTrace(U_TRACE_EVENT_USER_2, 0x12345678);
+    U_PORT_TEST_ASSERT(dump() == 3);
+    U_PORT_TEST_ASSERT(gDump.header.total == 3);
+    U_PORT_TEST_ASSERT(gDump.header.numEntries == 3);
+    U_PORT_TEST_ASSERT(gDump.size == sizeof(gDump.header) + (sizeof(uTraceEntry_t) * 3));
+    U_PORT_TEST_ASSERT(eventGet(&(gDump.entry[0])) == U_TRACE_EVENT_USER_0);
+    U_PORT_TEST_ASSERT(gDump.entry[0].parameter == 0);
+    U_PORT_TEST_ASSERT(eventGet(&(gDump.entry[1])) == U_TRACE_EVENT_USER_1);
+    U_PORT_TEST_ASSERT(gDump.entry[1].parameter == -1);
+    U_PORT_TEST_ASSERT(eventGet(&(gDump.entry[2])) == U_TRACE_EVENT_USER_2);
+    U_PORT_TEST_ASSERT(gDump.entry[2].parameter == 0x12345678);
+    for (size_t x = 0; x < 3; x++) {
+        U_PORT_TEST_ASSERT(gDump.entry[x].timeMs - startTimeMs >= 0);
+        U_PORT_TEST_ASSERT(gDump.entry[x].timeMs - uPortGetTickTimeMs() <= 0);
+    }
+    uTracePrint();
+
+    // Nothing is added while tracing is off
+    uTraceOn(false);
+    uTrace(U_TRACE_EVENT_USER_3, 3);
+    uTraceOn(true);
+    U_PORT_TEST_ASSERT(dump() == 3);
+
+    // Overfill the trace: only the most recent entries should remain
+    uTraceClear();
+    for (int32_t x = 0; x < U_TRACE_NUM_ENTRIES + 10; x++) {
+        uTrace(U_TRACE_EVENT_USER_3, x);
+    }
+    U_PORT_TEST_ASSERT(dump() == U_TRACE_NUM_ENTRIES);
+    U_PORT_TEST_ASSERT(gDump.header.total == U_TRACE_NUM_ENTRIES + 10);
+    for (int32_t x = 0; x < U_TRACE_NUM_ENTRIES; x++) {
+        U_PORT_TEST_ASSERT(eventGet(&(gDump.entry[x])) == U_TRACE_EVENT_USER_3);
+        U_PORT_TEST_ASSERT(gDump.entry[x].parameter == x + 10);
+    }
+
+    uTraceClear();
+    U_PORT_TEST_ASSERT(dump() == 0);
+
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed <= 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+/** Test of several tasks writing to the trace at once.
+ */
+U_PORT_TEST_FUNCTION("[trace]", "traceTasks")
+{
+    int32_t heapUsed;
+    uPortTaskHandle_t taskHandle;
+    int32_t lastCount[U_TRACE_TEST_NUM_TASKS];
+    int32_t startTimeMs;
+    int32_t index;
+    int32_t count;
+    size_t numValid = 0;
+
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    uTraceClear();
+    gNumTasksDone = 0;
+    for (size_t x = 0; x < U_TRACE_TEST_NUM_TASKS; x++) {
+        lastCount[x] = -1;
+        U_PORT_TEST_ASSERT(uPortTaskCreate(traceTask, "traceTest",
+                                           U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES,
+                                           (void *) (intptr_t) x,
+                                           U_CFG_TEST_OS_TASK_PRIORITY,
+                                           &taskHandle) == 0);
+    }
+    // Dump while the tasks are writing: all that matters
+    // is that every valid entry is one that was written
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gNumTasksDone < U_TRACE_TEST_NUM_TASKS) &&
+           (uPortGetTickTimeMs() - startTimeMs < 10000)) {
+        U_PORT_TEST_ASSERT(dump() >= 0);
+        for (size_t x = 0; x < gDump.header.numEntries; x++) {
+            if (eventGet(&(gDump.entry[x])) != U_TRACE_EVENT_NONE) {
+                U_PORT_TEST_ASSERT(eventGet(&(gDump.entry[x])) == U_TRACE_EVENT_USER_1);
+                U_PORT_TEST_ASSERT((gDump.entry[x].parameter >> 24) < U_TRACE_TEST_NUM_TASKS);
+            }
+        }
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(gNumTasksDone == U_TRACE_TEST_NUM_TASKS);
+    // Give the tasks time to be deleted
+    uPortTaskBlock(U_CFG_OS_YIELD_MS * 10);
+
+    // Now the trace is still, all of the entries must be valid and,
+    // for each task, in order
+    U_PORT_TEST_ASSERT(dump() == U_TRACE_NUM_ENTRIES);
+    U_PORT_TEST_ASSERT(gDump.header.total == U_TRACE_TEST_NUM_TASKS *
+                       U_TRACE_TEST_NUM_ENTRIES_PER_TASK);
+    for (size_t x = 0; x < gDump.header.numEntries; x++) {
+        U_PORT_TEST_ASSERT(eventGet(&(gDump.entry[x])) == U_TRACE_EVENT_USER_1);
+        index = gDump.entry[x].parameter >> 24;
+        count = gDump.entry[x].parameter & 0xFFFFFF;
+        U_PORT_TEST_ASSERT((index >= 0) && (index < U_TRACE_TEST_NUM_TASKS));
+        U_PORT_TEST_ASSERT(count > lastCount[index]);
+        lastCount[index] = count;
+        numValid++;
+    }
+    U_TEST_PRINT_LINE("%d entries checked.", (int32_t) numValid);
+    // The last entry of every task must have made it
+    for (size_t x = 0; x < U_TRACE_TEST_NUM_TASKS; x++) {
+        U_PORT_TEST_ASSERT(lastCount[x] == U_TRACE_TEST_NUM_ENTRIES_PER_TASK - 1);
+    }
+
+    uTraceClear();
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed <= 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+// End of file
@@ -46,6 +46,36 @@ extern "C" {
 # define U_GNSS_I2C_ADDRESS 0x42
 #endif
 
+#ifndef U_GNSS_DATA_READY_THRESHOLD_BYTES
+/** The number of bytes that must be waiting in the GNSS chip for
+ * it to assert its TX-ready pin, see uGnssSetPinDataReady(); the
+ * GNSS chip works in units of 8 bytes.
+ */
+# define U_GNSS_DATA_READY_THRESHOLD_BYTES 8
+#endif
+
+#ifndef U_GNSS_SPI_FILL_THRESHOLD_BYTES
+/** When a GNSS chip connected via SPI has nothing to send it sends
+ * 0xFF; a run of at least this many 0xFF bytes is taken to be idle
+ * fill and is thrown away before it reaches the ring buffer.  Shorter
+ * runs are kept since they may be part of a message: anything that
+ * turns out not to be is discarded by the message decoder anyway.
+ */
+# define U_GNSS_SPI_FILL_THRESHOLD_BYTES 48
+#endif
+
+#ifndef U_GNSS_I2C_BURST_READ_LENGTH_BYTES
+/** When reading from a GNSS chip connected via I2C the number of
+ * bytes waiting (I2C registers 0xFD and 0xFE) is read in the same
+ * transaction as up to this many bytes of the data stream (register
+ * 0xFF) which follows it; the number of bytes left over is then
+ * remembered so that the next read need not query the length again.
+ * Set this to 0 to query the length in a separate transaction
+ * before every read.
+ */
+# define U_GNSS_I2C_BURST_READ_LENGTH_BYTES 64
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -105,6 +135,37 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                  bool leavePowerAlone,
                  uDeviceHandle_t *pGnssHandle);
 
+/** As uGnssAdd() but with control over the size and, optionally,
+ * the storage of the buffers used with a streaming transport (e.g.
+ * UART or I2C): a larger ring buffer may be needed if the GNSS chip
+ * is emitting many long messages (e.g. UBX-RXM-RAWX), see
+ * uGnssMsgReceiveStatStreamLoss() and
+ * uGnssMsgReceiveStatStreamHighWaterMark(), while a memory-constrained
+ * application may want it smaller.  pBufferCfg is ignored if the
+ * transport type is #U_GNSS_TRANSPORT_AT.
+ *
+ * @param moduleType         the GNSS module type.
+ * @param transportType      the type of transport that has been set up
+ *                           to talk with the GNSS module.
+ * @param transportHandle    the handle of the transport to use to
+ *                           talk with the GNSS module.  This must
+ *                           already have been created by the caller.
+ * @param pinGnssEnablePower the pin of the MCU that enables power to the
+ *                           GNSS module, see uGnssAdd().
+ * @param leavePowerAlone    see uGnssAdd().
+ * @param[in] pBufferCfg     the buffer configuration; may be NULL, in
+ *                           which case this is the same as uGnssAdd().
+ * @param[out] pGnssHandle   a pointer to the output handle. Will only be set on success.
+ * @return                   zero on success or negative error code on failure.
+ */
+int32_t uGnssAddWithBuffers(uGnssModuleType_t moduleType,
+                            uGnssTransportType_t transportType,
+                            const uGnssTransportHandle_t transportHandle,
+                            int32_t pinGnssEnablePower,
+                            bool leavePowerAlone,
+                            const uGnssBufferCfg_t *pBufferCfg,
+                            uDeviceHandle_t *pGnssHandle);
+
 /** Set the I2C address at which the GNSS device can be expected to
  * be found.  If not called the default #U_GNSS_I2C_ADDRESS is assumed.
  * Note that this does not _configure_ the I2C address inside the GNSS
@@ -183,6 +244,29 @@ void uGnssSetAtPinPwr(uDeviceHandle_t gnssHandle, int32_t pin);
  */
 void uGnssSetAtPinDataReady(uDeviceHandle_t gnssHandle, int32_t pin);
 
+/** If the transport type is I2C or SPI and a pin of this MCU is connected
+ * to a PIO of the GNSS chip, then this function may be called to
+ * configure that PIO as a TX-ready output (CFG-TXREADY) and to set
+ * an interrupt on the MCU pin.  The asynchronous message receive
+ * task (see u_gnss_msg.h) will then sleep until the GNSS chip
+ * indicates that it has at least #U_GNSS_DATA_READY_THRESHOLD_BYTES
+ * of data waiting, rather than polling the GNSS chip over I2C/SPI.
+ * The configuration is applied to the RAM layer only.
+ *
+ * Only supported on GNSS chips that support CFGVALXXX (M9 and
+ * later) and on platforms where uPortGpioInterruptSet() is
+ * supported.  Only one GNSS instance may use a given MCU pin.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ * @param pinMcu      the pin of this MCU that is connected to the
+ *                    GNSS chip; use -1 to stop using TX-ready.
+ * @param pinGnss     the PIO of the GNSS chip to use as TX-ready;
+ *                    ignored if pinMcu is negative.
+ * @return            zero on success else negative error code.
+ */
+int32_t uGnssSetPinDataReady(uDeviceHandle_t gnssHandle, int32_t pinMcu,
+                             int32_t pinGnss);
+
 /** Get the maximum time to wait for a response from the
  * GNSS chip for general API calls; does not apply to the
  * positioning calls, where #U_GNSS_POS_TIMEOUT_SECONDS and
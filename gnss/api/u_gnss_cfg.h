@@ -472,6 +472,34 @@ int32_t uGnssCfgValSetList(uDeviceHandle_t gnssHandle,
                            uGnssCfgValTransaction_t transaction,
                            uint32_t layers);
 
+/** Set the value of any number of configuration items, applying
+ * them all at once; only applicable to M9 modules and beyond, uses
+ * the UBX-CFG-VALSET mechanism.  Where uGnssCfgValSetList() sends a
+ * single UBX-CFG-VALSET message, and hence is limited in the number
+ * of values it can carry, this function packs the values into as few
+ * UBX-CFG-VALSET messages as will take them, sending each one as soon
+ * as the previous one has been acknowledged, and uses a transaction
+ * so that the GNSS chip applies none of the values until it has
+ * received all of them.  No other set/del operation can be performed
+ * on this GNSS instance while this function is running.  If an error
+ * occurs part way through then the transaction is never executed:
+ * none of the values will have been applied and the GNSS chip will
+ * discard them when the next transaction begins.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param[in] pList    a pointer to an array defining the values to
+ *                     set; cannot be NULL.
+ * @param numValues    the number of items in the array pointed-to
+ *                     by pList; must be greater than zero.
+ * @param layers       the layers to set the values in, a bit-map of
+ *                     #uGnssCfgValLayer_t values OR'ed together, see
+ *                     uGnssCfgValSetList().
+ * @return             zero on success else negative error code.
+ */
+int32_t uGnssCfgValSetListBatch(uDeviceHandle_t gnssHandle,
+                                const uGnssCfgVal_t *pList, size_t numValues,
+                                uint32_t layers);
+
 /** Delete a configuration item; only applicable to M9 modules
  * and beyond, using the UBX-CFG-VALDEL mechanism.
  *
@@ -608,6 +636,59 @@ int32_t uGnssCfgValDelListX(uDeviceHandle_t gnssHandle,
                             uGnssCfgValTransaction_t transaction,
                             uint32_t layers);
 
+/* ----------------------------------------------------------------
+ * FUNCTIONS: CONFIGURATION SHADOW
+ * -------------------------------------------------------------- */
+
+/** Switch the local shadow of the GNSS configuration on or off;
+ * it is off by default.  When the shadow is on, values read from,
+ * or successfully written to, the RAM layer of the GNSS chip with
+ * the uGnssCfgValXxx() functions are remembered, as is the
+ * UBX-CFG-NAV5 message behind uGnssCfgGetDynamic(),
+ * uGnssCfgGetFixMode() and uGnssCfgGetUtcStandard(), so that
+ * reading them again costs no message exchange with the GNSS chip.
+ * Up to U_GNSS_CFG_SHADOW_MAX_NUM_ITEMS (by default 32) key IDs
+ * are held, the oldest being forgotten when that number is exceeded.  Values set
+ * as part of a transaction are forgotten, since they only take
+ * effect when the transaction is executed, and the shadow is
+ * emptied when the GNSS chip is powered on or off.  IMPORTANT: the
+ * shadow cannot see configuration changes made by other means,
+ * e.g. with uGnssMsgSend(), or by the GNSS chip resetting itself;
+ * call uGnssCfgShadowClear() if you do such things.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ * @param onNotOff    true to switch the shadow on, false to switch
+ *                    it off and free the memory it occupies.
+ * @return            zero on success else negative error code.
+ */
+int32_t uGnssCfgSetShadow(uDeviceHandle_t gnssHandle, bool onNotOff);
+
+/** Fill the local shadow of the GNSS configuration by reading the
+ * given key IDs from the RAM layer of the GNSS chip in one go, e.g.
+ * at start of day, so that subsequent uGnssCfgValGet() calls for
+ * those key IDs are answered locally.  The shadow must have been
+ * switched on with uGnssCfgSetShadow().
+ *
+ * @param gnssHandle     the handle of the GNSS instance.
+ * @param[in] pKeyIdList a pointer to an array of key IDs to read;
+ *                       wildcards may be used but bear in mind that
+ *                       only U_GNSS_CFG_SHADOW_MAX_NUM_ITEMS values
+ *                       can be held.
+ * @param numKeyIds      the number of items in the array pointed-to
+ *                       by pKeyIdList.
+ * @return               on success the number of values read, else
+ *                       negative error code.
+ */
+int32_t uGnssCfgShadowFill(uDeviceHandle_t gnssHandle,
+                           const uint32_t *pKeyIdList, size_t numKeyIds);
+
+/** Empty the local shadow of the GNSS configuration, if it is on;
+ * the shadow remains on.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ */
+void uGnssCfgShadowClear(uDeviceHandle_t gnssHandle);
+
 #ifdef __cplusplus
 }
 #endif
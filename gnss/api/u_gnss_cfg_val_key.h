@@ -320,8 +320,10 @@ typedef enum {
                                                                     a shunt for current measurement). */
     U_GNSS_CFG_VAL_KEY_ITEM_HW_ANT_SUP_SHORT_THR_U1    = 0x55, /**< antenna supervisor MADC engine short detection
                                                                     threshold in milliVolts. */
-    U_GNSS_CFG_VAL_KEY_ITEM_HW_ANT_SUP_OPEN_THR_U1     = 0x56  /**< antenna supervisor MADC engine open/disconnect
+    U_GNSS_CFG_VAL_KEY_ITEM_HW_ANT_SUP_OPEN_THR_U1     = 0x56, /**< antenna supervisor MADC engine open/disconnect
                                                                     detection threshold in milliVolts. */
+    U_GNSS_CFG_VAL_KEY_ITEM_HW_RF_LNA_MODE_E1          = 0x57  /**< mode of the internal LNA: 0 means normal gain,
+                                                                    1 means low gain, 2 means bypass. */
 } uGnssCfgValKeyItemHw_t;
 
 /** Item IDs for #U_GNSS_CFG_VAL_KEY_GROUP_ID_I2C.
@@ -53,10 +53,27 @@ import platform # Figure out current OS
 #    ...erases anything between them and and writes all of the
 #    generated macros there instead.  A backup is made of the
 #    current file, just in case.
+#
+# 6. It then does the same between the same two markers in the
+#    file ../src/u_gnss_cfg_val_key_name.c, writing there a table
+#    of key names (e.g. CFG-ANA-USE_ANA) against key IDs, arranged
+#    as a minimal perfect hash so that the look-up functions in
+#    that file can find a name or a key ID in constant time.
 
 # The file to be read/modified
 TARGET_FILE_NAME = "u_gnss_cfg_val_key.h"
 
+# The file, relative to the directory of TARGET_FILE_NAME, to write the
+# name table into
+NAME_TABLE_FILE_NAME = os.path.join("..", "src", "u_gnss_cfg_val_key_name.c")
+
+# The average number of keys per bucket of the perfect hash: more keys
+# per bucket makes the seed table smaller but the seeds harder to find
+NAME_TABLE_KEYS_PER_BUCKET = 3
+
+# The largest seed that will fit into the seed tables (uint16_t)
+NAME_TABLE_SEED_MAX = 0xFFFF
+
 # The file extension to be used for the back-up of the file
 BACKUP_EXTENSION = "_bak"
 
@@ -288,6 +305,137 @@ def rewrite_line_list(key_id_list, input_line_list):
 
     return output_line_list
 
+def hash(data, seed):
+    '''Seeded FNV-1a with a final mix, MUST match hash() in u_gnss_cfg_val_key_name.c'''
+    h = 0x811c9dc5 ^ ((seed * 0x9e3779b9) & 0xFFFFFFFF)
+    if isinstance(data, str):
+        data = data.encode("ascii")
+    else:
+        # A key ID, hashed as four bytes, least significant first
+        data = data.to_bytes(4, "little")
+    for byte in data:
+        h = ((h ^ byte) * 0x01000193) & 0xFFFFFFFF
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & 0xFFFFFFFF
+    h ^= h >> 13
+    return h
+
+def perfect_hash(keys):
+    '''Return (seeds, slots) for the given list of unique keys: the
+       seed for key is seeds[hash(key, 0) % len(seeds)] and the key
+       is then at slots[hash(key, seed) % len(slots)], an index into keys'''
+    num_slots = len(keys)
+    num_buckets = (num_slots + NAME_TABLE_KEYS_PER_BUCKET - 1) // NAME_TABLE_KEYS_PER_BUCKET
+    buckets = [[] for _ in range(num_buckets)]
+    for idx, key in enumerate(keys):
+        buckets[hash(key, 0) % num_buckets].append(idx)
+    seeds = [0] * num_buckets
+    slots = [-1] * num_slots
+    # Place the fullest buckets first, while there is most room
+    for bucket_idx in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+        bucket = buckets[bucket_idx]
+        if not bucket:
+            continue
+        seed = 1
+        while seed <= NAME_TABLE_SEED_MAX:
+            wanted = [hash(keys[idx], seed) % num_slots for idx in bucket]
+            if len(set(wanted)) == len(wanted) and all(slots[w] < 0 for w in wanted):
+                for idx, slot in zip(bucket, wanted):
+                    slots[slot] = idx
+                seeds[bucket_idx] = seed
+                break
+            seed += 1
+        if seed > NAME_TABLE_SEED_MAX:
+            print("Could not find a perfect hash seed for {} key(s).".format(len(bucket)))
+            return [], []
+    return seeds, slots
+
+def format_table(values, per_line):
+    '''Return a list of lines listing values, per_line to a line'''
+    lines = []
+    for idx in range(0, len(values), per_line):
+        line = "    " + ", ".join(values[idx:idx + per_line])
+        if idx + per_line < len(values):
+            line += ","
+        lines.append(line + "\n")
+    return lines
+
+def name_table_line_list(key_name_list):
+    '''Create the lines of C for the name table from a list of (name, key ID, type) tuples'''
+    output_line_list = []
+    names = [key_name[0] for key_name in key_name_list]
+    # A key ID may in principle appear more than once: the first wins
+    key_ids = []
+    key_id_index = {}
+    for idx, key_name in enumerate(key_name_list):
+        if key_name[1] not in key_id_index:
+            key_id_index[key_name[1]] = idx
+            key_ids.append(key_name[1])
+    name_seeds, name_slots = perfect_hash(names)
+    id_seeds, id_slots = perfect_hash(key_ids)
+    if name_seeds and id_seeds:
+        output_line_list.append("static const uGnssCfgValKeyName_t gKeyName[] = {\n")
+        entries = []
+        for idx in name_slots:
+            key_name = key_name_list[idx]
+            entries.append("{{\"{}\", {}, '{}'}}".format(key_name[0], hex(key_name[1]), key_name[2]))
+        output_line_list += format_table(entries, 1)
+        output_line_list.append("};\n\n")
+        output_line_list.append("static const uint16_t gNameSeed[] = {\n")
+        output_line_list += format_table([str(seed) for seed in name_seeds], 12)
+        output_line_list.append("};\n\n")
+        output_line_list.append("static const uint16_t gIdSeed[] = {\n")
+        output_line_list += format_table([str(seed) for seed in id_seeds], 12)
+        output_line_list.append("};\n\n")
+        # gIdIndex[] gives the position in gKeyName[] of each key ID
+        name_position = {idx: position for position, idx in enumerate(name_slots)}
+        output_line_list.append("static const uint16_t gIdIndex[] = {\n")
+        output_line_list += format_table([str(name_position[key_id_index[key_ids[idx]]])
+                                          for idx in id_slots], 12)
+        output_line_list.append("};\n")
+        print("Name table: {} key(s), {} name seed(s), {} key ID seed(s).".  \
+              format(len(names), len(name_seeds), len(id_seeds)))
+    return output_line_list
+
+def rewrite_between_markers(generated_line_list, input_line_list):
+    '''Re-write the lines between the markers in input_line_list with generated_line_list'''
+    output_line_list = []
+    start_marker_index = -1
+    end_marker_index = -1
+
+    for idx, line in enumerate(input_line_list):
+        if start_marker_index < 0 and line.startswith(FILE_REWRITE_MARKER_START):
+            start_marker_index = idx
+        elif start_marker_index >= 0 and line.startswith(FILE_REWRITE_MARKER_END):
+            end_marker_index = idx
+            break
+    if start_marker_index < 0 or end_marker_index < 0:
+        print("Could not find the markers \"{}\" and \"{}\" in the file, stopping.". \
+              format(FILE_REWRITE_MARKER_START, FILE_REWRITE_MARKER_END))
+    else:
+        output_line_list = input_line_list[:start_marker_index + 1] + ["\n"] + \
+                           generated_line_list + ["\n"] + input_line_list[end_marker_index:]
+    return output_line_list
+
+def rewrite_name_table(key_name_list, name_table_file):
+    '''Re-write the name table in name_table_file, returning True on success'''
+    success = False
+    if os.path.isfile(name_table_file):
+        with open(name_table_file, "r") as file:
+            print("Reading file {}...".format(name_table_file))
+            line_list = file.readlines()
+        generated_line_list = name_table_line_list(key_name_list)
+        if generated_line_list:
+            line_list = rewrite_between_markers(generated_line_list, line_list)
+            if line_list and copy_file(name_table_file, name_table_file + BACKUP_EXTENSION):
+                with open(name_table_file, "w") as file:
+                    file.writelines(line_list)
+                    print("{} has been re-written.".format(name_table_file))
+                    success = True
+    else:
+        print("\"{}\" is not a file.".format(name_table_file))
+    return success
+
 def copy_file(source, destination):
     '''Copy a file from source to destination using OS commands'''
     success = False
@@ -310,13 +458,14 @@ def copy_file(source, destination):
                      error.returncode, error.output))
     return success
 
-def main(target_file):
+def main(target_file, name_table_file):
     '''Main as a function'''
     return_value = 1
     keep_going = True
     line_list = []
     key_size_list = []
     key_id_list = []
+    key_name_list = []
 
     signal(SIGINT, signal_handler)
 
@@ -362,6 +511,12 @@ def main(target_file):
                                 if key_id >= 0:
                                     key_id_list.append((enum_entry_prefix_items.replace("ITEM", "ID") + \
                                                        item_tuple[0], key_id))
+                                    # The name, as in the interface description, has
+                                    # no type on the end, e.g. CFG-ANA-USE_ANA
+                                    item_bits = item_tuple[0].split("_")
+                                    key_name_list.append(("CFG-" + group_id_tuple[0] + "-" + \
+                                                          "_".join(item_bits[:-1]), key_id,
+                                                          item_bits[-1][0]))
                                 else: 
                                     print("Could not find key size for item \"{}\";"      \
                                           " does it have an _X on the end, where X"       \
@@ -401,6 +556,7 @@ def main(target_file):
                     with open(target_file, "w") as file:
                         file.writelines(line_list)
                         print("{} has been re-written.".format(target_file))
+                    if rewrite_name_table(key_name_list, name_table_file):
                         return_value = 0
     else:
         print("\"{}\" is not a file.".format(target_file))
@@ -413,10 +569,16 @@ if __name__ == "__main__":
                                      " in " + TARGET_FILE_NAME + ".\n")
     PARSER.add_argument("-f", default=TARGET_FILE_NAME, help="the" \
                         " file name to update, default " + TARGET_FILE_NAME)
+    PARSER.add_argument("-n", default=None, help="the file in which" \
+                        " to update the key name table, default "      \
+                        + NAME_TABLE_FILE_NAME + " relative to the"    \
+                        " directory of the file to update")
     ARGS = PARSER.parse_args()
+    if ARGS.n is None:
+        ARGS.n = os.path.join(os.path.dirname(ARGS.f), NAME_TABLE_FILE_NAME)
 
     # Call main()
-    RETURN_VALUE = main(ARGS.f)
+    RETURN_VALUE = main(ARGS.f, ARGS.n)
 
     sys.exit(RETURN_VALUE)
 
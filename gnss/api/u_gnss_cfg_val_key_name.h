@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_CFG_VAL_KEY_NAME_H_
+#define _U_GNSS_CFG_VAL_KEY_NAME_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a run-time mapping between the
+ * names of the GNSS configuration keys, as they appear in the u-blox
+ * GNSS interface description (e.g. "CFG-NAVSPG-FIXMODE"), and the key
+ * IDs of u_gnss_cfg_val_key.h, e.g. for an application that reads
+ * its GNSS configuration from a text file and then passes the key IDs
+ * and values to uGnssCfgValSetList().
+ *
+ * A look-up in either direction takes constant time: the table
+ * behind it, in u_gnss_cfg_val_key_name.c, is a minimal perfect hash
+ * generated, along with the key ID macros, by the u_gnss_cfg_val_key.py
+ * script.  The table is a few tens of kbytes of constant data; it is
+ * only included in an application that calls these functions since
+ * ubxlib is compiled with -ffunction-sections -fdata-sections and
+ * linked with --gc-sections.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A GNSS configuration key name and its key ID.
+ */
+typedef struct {
+    const char *pName; /**< the name of the key, e.g. "CFG-NAVSPG-FIXMODE". */
+    uint32_t keyId;    /**< the key ID, e.g. #U_GNSS_CFG_VAL_KEY_ID_NAVSPG_FIXMODE_E1;
+                            U_GNSS_CFG_VAL_KEY_GET_SIZE() will give its
+                            storage size. */
+    char type;         /**< the type of the value as a letter from the
+                            u-blox GNSS interface description, i.e. 'L'
+                            (boolean), 'U' (unsigned), 'I' (signed),
+                            'E' (enumeration), 'X' (bitfield) or 'R'
+                            (floating point), useful when converting a
+                            value from text. */
+} uGnssCfgValKeyName_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Find a GNSS configuration key by name.
+ *
+ * @param[in] pName  the null-terminated name of the key, exactly as
+ *                   in the u-blox GNSS interface description, e.g.
+ *                   "CFG-NAVSPG-FIXMODE"; cannot be NULL.
+ * @return           a pointer to the entry for the key, NULL if there
+ *                   is no key of that name.
+ */
+const uGnssCfgValKeyName_t *pUGnssCfgValKeyNameFind(const char *pName);
+
+/** Find a GNSS configuration key by key ID.
+ *
+ * @param keyId  the key ID, e.g. #U_GNSS_CFG_VAL_KEY_ID_NAVSPG_FIXMODE_E1.
+ * @return       a pointer to the entry for the key, NULL if the key
+ *               ID is not known.
+ */
+const uGnssCfgValKeyName_t *pUGnssCfgValKeyNameFindId(uint32_t keyId);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_CFG_VAL_KEY_NAME_H_
+
+// End of file
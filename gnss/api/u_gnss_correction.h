@@ -0,0 +1,231 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_CORRECTION_H_
+#define _U_GNSS_CORRECTION_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+#include "u_sock.h"          // uSockDescriptor_t
+#include "u_mqtt_common.h"   // Required by u_mqtt_client.h
+#include "u_mqtt_client.h"   // uMqttClientContext_t
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the correction-data functions of
+ * the GNSS API: a pipeline that takes SPARTN and/or RTCM3 correction
+ * messages from an MQTT topic, a socket or any other source of your
+ * choosing, frames and validates them and forwards them to a
+ * high-precision GNSS chip (e.g. a ZED-F9P).  Only whole, valid,
+ * messages are forwarded and they are sent straight from the buffer
+ * they arrived in wherever possible, i.e. no copy is made of a
+ * message unless it straddles two reads from the source.  These
+ * functions are thread-safe.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_GNSS_CORRECTION_BUFFER_LENGTH_BYTES
+/** The default length of the buffer of a correction pipeline, used
+ * where zero is passed as bufferLengthBytes to uGnssCorrectionOpen().
+ * The buffer must be able to hold the largest message that will be
+ * forwarded: a SPARTN message may be up to 1108 bytes long and an
+ * RTCM3 message up to 1029 bytes.  Where the source is a socket the
+ * buffer is also where data is read into, hence making it larger
+ * than a message means fewer reads.
+ */
+# define U_GNSS_CORRECTION_BUFFER_LENGTH_BYTES 2048
+#endif
+
+#ifndef U_GNSS_CORRECTION_CHUNK_LENGTH_BYTES
+/** Messages are forwarded to the GNSS chip in chunks of at most
+ * this many bytes, so that a long message on a slow transport
+ * does not lock out other users of the GNSS API for the whole of
+ * its transmission time.
+ */
+# define U_GNSS_CORRECTION_CHUNK_LENGTH_BYTES 256
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The handle of a correction pipeline.
+ */
+typedef void *uGnssCorrectionHandle_t;
+
+/** The correction message protocols that a pipeline may forward;
+ * values may be OR'ed together to form a bit-map.
+ */
+typedef enum {
+    U_GNSS_CORRECTION_PROTOCOL_SPARTN = 0x01, /**< SPARTN, e.g. PointPerfect. */
+    U_GNSS_CORRECTION_PROTOCOL_RTCM = 0x02,   /**< RTCM version 3. */
+    U_GNSS_CORRECTION_PROTOCOL_ALL = 0x03
+} uGnssCorrectionProtocol_t;
+
+/** Statistics of a correction pipeline, see uGnssCorrectionGetStats().
+ */
+typedef struct {
+    size_t bytesReceived;      /**< the number of bytes received from
+                                    the source(s). */
+    size_t bytesForwarded;     /**< the number of bytes sent to the
+                                    GNSS chip. */
+    size_t messagesSpartn;     /**< the number of SPARTN messages sent
+                                    to the GNSS chip. */
+    size_t messagesRtcm;       /**< the number of RTCM3 messages sent
+                                    to the GNSS chip. */
+    size_t messagesBad;        /**< the number of messages that were
+                                    discarded because they failed
+                                    validation or were too long for
+                                    the buffer. */
+    size_t bytesDiscarded;     /**< the number of bytes received that
+                                    were not part of a forwarded
+                                    message. */
+    size_t sendFailures;       /**< the number of messages that could
+                                    not be completely sent to the
+                                    GNSS chip. */
+    int32_t sendTimeMaxMs;     /**< the longest time taken to send one
+                                    message to the GNSS chip. */
+    size_t bufferedBytes;      /**< the number of bytes currently held
+                                    in the buffer of the pipeline,
+                                    waiting for the rest of a message. */
+    size_t bufferHighWaterMark; /**< the largest number of bytes that
+                                     has been held in the buffer of the
+                                     pipeline. */
+} uGnssCorrectionStats_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Open a correction pipeline to a GNSS chip.  The GNSS chip must
+ * be configured to accept the correction protocol(s) on the
+ * interface it is connected to this MCU by; data can then be passed
+ * into the pipeline with uGnssCorrectionInput() or by binding it
+ * to a source with uGnssCorrectionBindMqtt() or
+ * uGnssCorrectionBindSock().  The GNSS transport must be a streaming
+ * one (UART, I2C or SPI).
+ *
+ * @param gnssHandle          the handle of the GNSS instance to
+ *                            forward messages to.
+ * @param protocolBitmap      a bit-map of the #uGnssCorrectionProtocol_t
+ *                            values that should be forwarded; anything
+ *                            else is discarded.
+ * @param bufferLengthBytes   the length of the buffer to allocate
+ *                            for the pipeline, zero to use
+ *                            #U_GNSS_CORRECTION_BUFFER_LENGTH_BYTES.
+ * @param[out] pHandle        a place to put the handle of the
+ *                            pipeline; cannot be NULL.
+ * @return                    zero on success else negative error code.
+ */
+int32_t uGnssCorrectionOpen(uDeviceHandle_t gnssHandle,
+                            uint32_t protocolBitmap,
+                            size_t bufferLengthBytes,
+                            uGnssCorrectionHandle_t *pHandle);
+
+/** Bind a correction pipeline to an MQTT topic filter: messages
+ * which arrive on the topic filter are framed, validated and
+ * forwarded to the GNSS chip as soon as they are received.  This
+ * uses uMqttClientRouteAdd() and so messages are subject to
+ * #U_MQTT_CLIENT_ROUTE_MESSAGE_MAX_LENGTH_BYTES, which should be
+ * increased if the MQTT messages carrying correction data can be
+ * longer.  It does NOT subscribe: call uMqttClientSubscribe() as
+ * well.  A pipeline may be bound to one MQTT topic filter; the
+ * binding is removed by uGnssCorrectionClose().
+ *
+ * @param handle               the handle of the pipeline.
+ * @param[in] pMqttContext     the MQTT context, as returned by
+ *                             pUMqttClientOpen(); cannot be NULL.
+ * @param[in] pTopicFilterStr  the null-terminated topic filter,
+ *                             e.g. "/pp/ip/eu"; cannot be NULL.  The
+ *                             string must remain valid for as long
+ *                             as the binding does.
+ * @return                     zero on success else negative error code.
+ */
+int32_t uGnssCorrectionBindMqtt(uGnssCorrectionHandle_t handle,
+                                uMqttClientContext_t *pMqttContext,
+                                const char *pTopicFilterStr);
+
+/** Bind a correction pipeline to a connected socket, e.g. one
+ * connected to an NTRIP caster: the socket is set to be non-blocking
+ * and, whenever data arrives on it, the data is read straight into
+ * the buffer of the pipeline, framed, validated and forwarded to the
+ * GNSS chip by a task belonging to the pipeline.  A pipeline may be
+ * bound to one socket; the binding is removed by
+ * uGnssCorrectionClose(), which must be called BEFORE the socket is
+ * closed.  Note that this takes the data callback of the socket,
+ * see uSockRegisterCallbackData().
+ *
+ * @param handle      the handle of the pipeline.
+ * @param descriptor  the descriptor of the socket.
+ * @return            zero on success else negative error code.
+ */
+int32_t uGnssCorrectionBindSock(uGnssCorrectionHandle_t handle,
+                                uSockDescriptor_t descriptor);
+
+/** Pass correction data into a pipeline from a source of your
+ * choosing, e.g. SPARTN extracted from the UBX-RXM-PMP messages of
+ * a NEO-D9S L-band receiver.  The data may be of any length and
+ * messages may be split across calls.  Complete valid messages are
+ * forwarded to the GNSS chip before this function returns.
+ *
+ * @param handle     the handle of the pipeline.
+ * @param[in] pData  the data; cannot be NULL.
+ * @param size       the number of bytes at pData.
+ * @return           on success the number of bytes forwarded to the
+ *                   GNSS chip, else negative error code.
+ */
+int32_t uGnssCorrectionInput(uGnssCorrectionHandle_t handle,
+                             const char *pData, size_t size);
+
+/** Get the statistics of a correction pipeline.
+ *
+ * @param handle       the handle of the pipeline.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uGnssCorrectionGetStats(uGnssCorrectionHandle_t handle,
+                                uGnssCorrectionStats_t *pStats);
+
+/** Close a correction pipeline, removing any binding and freeing
+ * its memory; any partial message it holds is lost.
+ *
+ * @param handle  the handle of the pipeline.
+ */
+void uGnssCorrectionClose(uGnssCorrectionHandle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_CORRECTION_H_
+
+// End of file
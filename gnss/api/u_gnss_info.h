@@ -88,7 +88,9 @@ typedef struct {
  * FUNCTIONS
  * -------------------------------------------------------------- */
 
-/** Get the version string from the GNSS chip.
+/** Get the version string from the GNSS chip.  The UBX-MON-VER
+ * message behind this (and uGnssInfoGetVersions()) is read once and
+ * then cached until the GNSS chip is powered on or off.
  *
  * @param gnssHandle  the handle of the GNSS instance.
  * @param[out] pStr   a pointer to size bytes of storage into which
@@ -120,7 +122,8 @@ int32_t uGnssInfoGetFirmwareVersionStr(uDeviceHandle_t gnssHandle,
 int32_t uGnssInfoGetVersions(uDeviceHandle_t gnssHandle,
                              uGnssVersionType_t *pVer);
 
-/** Get the chip ID from the GNSS chip.
+/** Get the chip ID from the GNSS chip.  The chip ID is read once
+ * and then cached until the GNSS chip is powered on or off.
  *
  * @param gnssHandle  the handle of the GNSS instance.
  * @param[out] pStr   a pointer to size bytes of storage into which
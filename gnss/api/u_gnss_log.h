@@ -0,0 +1,197 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_LOG_H_
+#define _U_GNSS_LOG_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the raw logging functions of the
+ * GNSS API: the stream from a GNSS chip, all of it or only the
+ * messages of interest (e.g. UBX-RXM-RAWX and UBX-RXM-SFRBX for
+ * post-processing), is copied as it arrives into blocks of a fixed
+ * size and each full block is handed to a writer of your choosing,
+ * e.g. one that appends the block to a file in the file system of
+ * a cellular module or to a file on a host.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_GNSS_LOG_BLOCK_LENGTH_BYTES
+/** The default length of the blocks that a log is written in, used
+ * where zero is passed as blockLengthBytes to uGnssLogStart(); two
+ * blocks are allocated, one being filled while the other is being
+ * written.
+ */
+# define U_GNSS_LOG_BLOCK_LENGTH_BYTES 4096
+#endif
+
+#ifndef U_GNSS_LOG_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that calls the writer of a log;
+ * this needs to be large enough for whatever the writer does,
+ * e.g. calling uCellFileWrite().
+ */
+# define U_GNSS_LOG_TASK_STACK_SIZE_BYTES 2304
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A writer for a log.  It is called in the context of the log task
+ * with a block of data which it should write in full, e.g. a writer
+ * that appends to a file in the file system of a cellular module
+ * might be:
+ *
+ * ```
+ * int32_t myWriter(const char *pData, size_t size, void *pWriterParam)
+ * {
+ *     return uCellFileWrite(*((uDeviceHandle_t *) pWriterParam),
+ *                           "gnss.ubx", pData, size);
+ * }
+ * ```
+ *
+ * ...while one that writes to a file on a host might be:
+ *
+ * ```
+ * int32_t myWriter(const char *pData, size_t size, void *pWriterParam)
+ * {
+ *     return (int32_t) fwrite(pData, 1, size, (FILE *) pWriterParam);
+ * }
+ * ```
+ *
+ * The writer may call any API except this one; it may take as long
+ * as it likes, data continues to be collected while it runs, but if
+ * it does not keep up on average data will be dropped.
+ *
+ * @param[in] pData          the data to write; all blocks other than
+ *                           the last one written before the log is
+ *                           stopped will be the block length given
+ *                           to uGnssLogStart().
+ * @param size               the number of bytes at pData.
+ * @param[in] pWriterParam   the writer parameter given to
+ *                           uGnssLogStart().
+ * @return                   the number of bytes written, which should
+ *                           be size, else negative error code.
+ */
+typedef int32_t (*uGnssLogWriter_t)(const char *pData, size_t size,
+                                    void *pWriterParam);
+
+/** Statistics of a log, see uGnssLogGetStats().
+ */
+typedef struct {
+    size_t messagesLogged;  /**< the number of messages copied into the log. */
+    size_t messagesDropped; /**< the number of wanted messages that could
+                                 not be logged because neither block had
+                                 room for them, i.e. the writer did not keep
+                                 up. */
+    size_t bytesLogged;     /**< the number of bytes copied into the log. */
+    size_t bytesDropped;    /**< the number of bytes of wanted messages
+                                 dropped, plus the number of bytes that the
+                                 writer failed to write. */
+    size_t bytesWritten;    /**< the number of bytes written by the writer. */
+    size_t bytesBuffered;   /**< the number of bytes waiting to be written. */
+    size_t blocksWritten;   /**< the number of times the writer was called. */
+    size_t writeFailures;   /**< the number of times the writer did not
+                                 write a whole block. */
+    int32_t writeTimeMaxMs; /**< the longest time the writer took. */
+} uGnssLogStats_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Start logging the stream from a GNSS chip.  Messages are copied
+ * into the log as they are framed, i.e. straight out of the internal
+ * ring buffer, in whichever task is bringing data in from the GNSS
+ * chip, so the cost to the receive path is that of a copy and the
+ * receive path never waits for the writer: if the writer has not
+ * finished with the other block when there is no room for a message
+ * in the block being filled, the message is dropped and counted.
+ * The asynchronous message receive task (see uGnssMsgReceiveStart())
+ * is started, if it is not already running, to keep data flowing,
+ * and is kept running while the log is running.  The GNSS transport
+ * must be a streaming one (UART, I2C or SPI).  There can be one log
+ * per GNSS instance.
+ *
+ * @param gnssHandle          the handle of the GNSS instance.
+ * @param[in] pMessageIdList  the message IDs to log, wild-cards
+ *                            permitted; use NULL to log everything,
+ *                            including any data which is not a
+ *                            recognised message, i.e. the raw stream.
+ * @param numMessageIds       the number of entries at pMessageIdList;
+ *                            ignored if pMessageIdList is NULL.
+ * @param blockLengthBytes    the length of the blocks that the writer
+ *                            is called with, zero for
+ *                            #U_GNSS_LOG_BLOCK_LENGTH_BYTES; twice this
+ *                            is allocated.
+ * @param pWriter             the writer; cannot be NULL.
+ * @param[in] pWriterParam    a parameter that will be passed to pWriter;
+ *                            may be NULL.
+ * @return                    zero on success else negative error code.
+ */
+int32_t uGnssLogStart(uDeviceHandle_t gnssHandle,
+                      const uGnssMessageId_t *pMessageIdList,
+                      size_t numMessageIds,
+                      size_t blockLengthBytes,
+                      uGnssLogWriter_t pWriter,
+                      void *pWriterParam);
+
+/** Get the statistics of the log of a GNSS instance.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uGnssLogGetStats(uDeviceHandle_t gnssHandle,
+                         uGnssLogStats_t *pStats);
+
+/** Stop logging: whatever is in the log is written, the last block
+ * being shorter than the block length, before this function returns.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param[out] pStats  a place to put the final statistics of the log;
+ *                     may be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uGnssLogStop(uDeviceHandle_t gnssHandle,
+                     uGnssLogStats_t *pStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_LOG_H_
+
+// End of file
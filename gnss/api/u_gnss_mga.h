@@ -0,0 +1,223 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_MGA_H_
+#define _U_GNSS_MGA_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the multiple GNSS assistance (MGA)
+ * functions of the GNSS API, used to upload AssistNow Online/Offline
+ * data to a GNSS chip quickly and to save/restore the navigation
+ * database of a GNSS chip.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_GNSS_MGA_UPLOAD_WINDOW_SIZE_MAX
+/** The maximum number of UBX-MGA messages that uGnssMgaUpload() can
+ * have sent to the GNSS chip and be waiting for a UBX-MGA-ACK for;
+ * each costs 12 bytes of stack.
+ */
+# define U_GNSS_MGA_UPLOAD_WINDOW_SIZE_MAX 16
+#endif
+
+#ifndef U_GNSS_MGA_UPLOAD_WINDOW_SIZE_DEFAULT
+/** The number of UBX-MGA messages that uGnssMgaUpload() will have
+ * outstanding, waiting for a UBX-MGA-ACK, if no other value is
+ * given; a GNSS chip is able to buffer several MGA messages so that
+ * it can be decoding one while the next is being sent.
+ */
+# define U_GNSS_MGA_UPLOAD_WINDOW_SIZE_DEFAULT 8
+#endif
+
+#ifndef U_GNSS_MGA_UPLOAD_ACK_TIMEOUT_MS_DEFAULT
+/** How long uGnssMgaUpload() will wait for the UBX-MGA-ACK for
+ * a message, if no other value is given.
+ */
+# define U_GNSS_MGA_UPLOAD_ACK_TIMEOUT_MS_DEFAULT 2000
+#endif
+
+#ifndef U_GNSS_MGA_DATABASE_SAVE_IDLE_TIMEOUT_MS
+/** The GNSS chip does not mark the end of the stream of UBX-MGA-DBD
+ * messages it sends in response to a poll: uGnssMgaDatabaseSave()
+ * considers the stream finished when no UBX-MGA-DBD message has
+ * arrived for this long.
+ */
+# define U_GNSS_MGA_DATABASE_SAVE_IDLE_TIMEOUT_MS 1000
+#endif
+
+#ifndef U_GNSS_MGA_DATABASE_SAVE_TIMEOUT_MS
+/** The maximum time uGnssMgaDatabaseSave() will spend collecting
+ * UBX-MGA-DBD messages.
+ */
+# define U_GNSS_MGA_DATABASE_SAVE_TIMEOUT_MS 10000
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Configuration for uGnssMgaUpload(); zero everything to get
+ * the defaults.
+ */
+typedef struct {
+    size_t windowSize;         /**< the number of UBX-MGA messages that may
+                                    be waiting for a UBX-MGA-ACK at any one time,
+                                    up to #U_GNSS_MGA_UPLOAD_WINDOW_SIZE_MAX;
+                                    use 1 to wait for the ACK of each message
+                                    before sending the next, zero for
+                                    #U_GNSS_MGA_UPLOAD_WINDOW_SIZE_DEFAULT. */
+    int32_t ackTimeoutMs;      /**< how long to wait for the UBX-MGA-ACK
+                                    of a message before giving up on it,
+                                    zero for #U_GNSS_MGA_UPLOAD_ACK_TIMEOUT_MS_DEFAULT. */
+    int32_t messageIntervalMs; /**< the minimum interval between the
+                                    start of one message and the start of
+                                    the next, a rate limit that may be
+                                    required if the GNSS chip is connected
+                                    via I2C with limited bus bandwidth; zero
+                                    for no limit. */
+} uGnssMgaUploadCfg_t;
+
+/** The outcome of uGnssMgaUpload().
+ */
+typedef struct {
+    size_t messagesSent;      /**< the number of UBX-MGA messages sent. */
+    size_t messagesAcked;     /**< the number of UBX-MGA messages that the
+                                   GNSS chip accepted. */
+    size_t messagesNacked;    /**< the number of UBX-MGA messages that the
+                                   GNSS chip rejected, e.g. because it does
+                                   not yet know the time. */
+    size_t messagesTimedOut;  /**< the number of UBX-MGA messages for which
+                                   no UBX-MGA-ACK was received. */
+    size_t bytesSent;         /**< the number of bytes sent. */
+    size_t bytesSkipped;      /**< the number of bytes of the data that were
+                                   not part of a UBX message. */
+    int32_t durationMs;       /**< how long the upload took. */
+} uGnssMgaUploadStats_t;
+
+/** The outcome of uGnssMgaDatabaseSave().
+ */
+typedef struct {
+    size_t numMessages;       /**< the number of UBX-MGA-DBD messages saved. */
+    size_t numBytes;          /**< the number of bytes written to the buffer. */
+    size_t numMessagesLost;   /**< the number of UBX-MGA-DBD messages that
+                                   did not fit into the buffer. */
+    int32_t durationMs;       /**< how long the save took, including
+                                   #U_GNSS_MGA_DATABASE_SAVE_IDLE_TIMEOUT_MS. */
+} uGnssMgaDatabaseSaveStats_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Upload a block of assistance data, e.g. as returned by the
+ * AssistNow Online or AssistNow Offline services, to a GNSS chip.
+ * The data must be a sequence of UBX-format messages; anything else
+ * is skipped.  Rather than waiting for the UBX-MGA-ACK of each
+ * UBX-MGA message before sending the next, up to windowSize messages
+ * may be waiting for their UBX-MGA-ACK at once, each UBX-MGA-ACK being
+ * matched to the message it is for, so that the time taken is mostly
+ * down to the speed of the transport.  UBX-MGA-ACKs are not given for
+ * UBX-MGA-DBD messages or for messages that are not UBX-MGA messages;
+ * these are sent without waiting.
+ *
+ * For UBX-MGA-ACKs to be sent, this function switches on "ACK aiding"
+ * in the GNSS chip (CFG-NAVSPG-ACKAIDING on M9 modules and beyond,
+ * the ackAiding field of UBX-CFG-NAVX5 for M8 modules), in RAM only,
+ * and leaves it on.  The GNSS transport must be a streaming one
+ * (UART, I2C or SPI) since this uses uGnssMsgReceiveStart() to
+ * capture the UBX-MGA-ACKs.
+ *
+ * uGnssMsgReceiveStart() is used for the duration of this function,
+ * hence one of the #U_GNSS_MSG_RECEIVER_MAX_NUM receivers must be free.
+ *
+ * @param gnssHandle     the handle of the GNSS instance.
+ * @param[in] pData      the assistance data; cannot be NULL.
+ * @param size           the amount of data at pData.
+ * @param[in] pCfg       the upload configuration; may be NULL to
+ *                       use the defaults.
+ * @param[out] pStats    a place to put the outcome of the upload;
+ *                       may be NULL.
+ * @return               on success the number of UBX-MGA messages that
+ *                       the GNSS chip accepted, which may be fewer than
+ *                       were sent (the detail is in pStats), else
+ *                       negative error code.
+ */
+int32_t uGnssMgaUpload(uDeviceHandle_t gnssHandle,
+                       const char *pData, size_t size,
+                       const uGnssMgaUploadCfg_t *pCfg,
+                       uGnssMgaUploadStats_t *pStats);
+
+/** Save the navigation database of a GNSS chip: ephemeris, almanac,
+ * ionosphere and clock parameters, position and time.  The GNSS chip
+ * is polled for UBX-MGA-DBD and the UBX-MGA-DBD messages that come
+ * back are written to pBuffer back to back, as complete UBX messages.
+ * The buffer can be stored, e.g. in non-volatile memory, and later
+ * passed to uGnssMgaUpload() to restore the database, e.g. after
+ * the GNSS chip has been without power.  With its database restored,
+ * the GNSS chip can get a fix much more quickly, as it would from a
+ * hot start.  The size of the database depends on the number of
+ * satellites in view. A few kbytes is typical, about 200 bytes
+ * per satellite.
+ *
+ * The GNSS transport must be a streaming one (UART, I2C or SPI)
+ * since this uses uGnssMsgReceiveStart() to capture the UBX-MGA-DBD
+ * messages, hence one of the #U_GNSS_MSG_RECEIVER_MAX_NUM receivers
+ * must be free.
+ *
+ * @param gnssHandle     the handle of the GNSS instance.
+ * @param[out] pBuffer   a place to put the UBX-MGA-DBD messages;
+ *                       cannot be NULL.
+ * @param size           the amount of storage at pBuffer.
+ * @param[out] pStats    a place to put the outcome of the save;
+ *                       may be NULL.
+ * @return               on success the number of bytes written to
+ *                       pBuffer, else negative error code; if not
+ *                       all of the UBX-MGA-DBD messages fitted into
+ *                       pBuffer then #U_ERROR_COMMON_NO_MEMORY is
+ *                       returned but the messages that did fit are
+ *                       still valid (the detail is in pStats).
+ */
+int32_t uGnssMgaDatabaseSave(uDeviceHandle_t gnssHandle,
+                             char *pBuffer, size_t size,
+                             uGnssMgaDatabaseSaveStats_t *pStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_MGA_H_
+
+// End of file
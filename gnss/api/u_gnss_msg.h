@@ -115,8 +115,8 @@ extern "C" {
  * when a matching message has been received from the GNSS chip.
  * This callback should be executed as quickly as possible to
  * avoid data loss.  The ONLY GNSS API calls that pCallback may make
- * are uGnssMsgReceiveCallbackRead() / uGnssMsgReceiveCallbackExtract(),
- * no others or you risk getting* mutex-locked.
+ * are uGnssMsgReceiveCallbackRead() / uGnssMsgReceiveCallbackExtract()
+ * and uGnssMsgReceiveCallbackGetArrivalTime(), no others or you risk getting* mutex-locked.
  * If you are checking for a specific UBX-format message (i.e. no
  * wild-cards) and a NACK is received for that message then
  * errorCodeOrLength will be set to #U_GNSS_ERROR_NACK and there
@@ -324,6 +324,27 @@ int32_t uGnssMsgReceive(uDeviceHandle_t gnssHandle,
                         int32_t timeoutMs,
                         bool (*pKeepGoingCallback)(uDeviceHandle_t gnssHandle));
 
+/** Get the time at which the message most recently returned by
+ * uGnssMsgReceive() arrived: this is the tick time (see
+ * uPortGetTickTimeMs()) at which the first byte of the message was
+ * read from the GNSS chip into the internal ring buffer, rather than
+ * the time at which uGnssMsgReceive() got around to returning it,
+ * so can be used to correct for any delay in between.  The time is
+ * only known if this MCU is streaming data from the GNSS chip (UART,
+ * I2C or SPI).  Call this straight after uGnssMsgReceive(), from the
+ * same task; if more than one task is calling uGnssMsgReceive() on the
+ * same GNSS instance then the answer may be for another task's message.
+ *
+ * @param gnssHandle    the handle of the GNSS instance.
+ * @param[out] pTimeMs  a place to put the arrival time; cannot be NULL.
+ * @return              zero on success, #U_ERROR_COMMON_NOT_FOUND if
+ *                      the last call to uGnssMsgReceive() did not return
+ *                      a message or the arrival time of the message
+ *                      is not known, else negative error code.
+ */
+int32_t uGnssMsgReceiveGetArrivalTime(uDeviceHandle_t gnssHandle,
+                                      int32_t *pTimeMs);
+
 /** Monitor the output of the GNSS chip for the given message,
  * non-blocking (see uGnssMsgReceive() for the blocking version).
  * This may be called multiple times; to stop listening for a given
@@ -353,7 +374,8 @@ int32_t uGnssMsgReceive(uDeviceHandle_t gnssHandle,
  *                               checksum, etc. will be included.
  *                               IMPORTANT: the ONLY GNSS API calls that
  *                               pCallback may make are
- *                               uGnssMsgReceiveCallbackRead() and
+ *                               uGnssMsgReceiveCallbackRead(),
+ *                               uGnssMsgReceiveCallbackGetArrivalTime() and
  *                               uGnssMsgIsGood(), no others or you risk
  *                               getting mutex-locked. pCallback is run in
  *                               the context of a task with a stack of size
@@ -399,7 +421,8 @@ int32_t uGnssMsgReceiveCallbackRead(uDeviceHandle_t gnssHandle,
  * once this is called the message will not be available to any of your
  * other pCallbacks.  Use this if the message you wish to read is very
  * large, larger than this codes' internal ring buffer
- * (#U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES) and so you need to read
+ * (#U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES by default, see
+ * uGnssAddWithBuffers()) and so you need to read
  * it directly in this way, in other words when the internal buffer simply
  * isn't big enough to store the msssage and pass it around; normally
  * you would use uGnssMsgReceiveCallbackRead().
@@ -418,6 +441,50 @@ int32_t uGnssMsgReceiveCallbackRead(uDeviceHandle_t gnssHandle,
 int32_t uGnssMsgReceiveCallbackExtract(uDeviceHandle_t gnssHandle,
                                        char *pBuffer, size_t size);
 
+/** To be called from the pCallback of uGnssMsgReceiveStart() to get
+ * the time at which the message being passed to pCallback arrived:
+ * this is the tick time (see uPortGetTickTimeMs()) at which the first
+ * byte of the message was read from the GNSS chip into the internal
+ * ring buffer, rather than the time at which pCallback happens to be
+ * called, so can be used to correct for any queueing delay.
+ *
+ * IMPORTANT: this function can ONLY be called from the message
+ * receive pCallback, it is NOT thread-safe to call it from anywhere else.
+ *
+ * @param gnssHandle    the handle of the GNSS instance.
+ * @param[out] pTimeMs  a place to put the arrival time; cannot be NULL.
+ * @return              zero on success, #U_ERROR_COMMON_NOT_FOUND if the
+ *                      arrival time of this message is not known (e.g.
+ *                      because the message receive task has fallen a
+ *                      long way behind), else negative error code.
+ */
+int32_t uGnssMsgReceiveCallbackGetArrivalTime(uDeviceHandle_t gnssHandle,
+                                              int32_t *pTimeMs);
+
+/** To be called from the pCallback of uGnssMsgReceiveStart() to
+ * look at a message where it sits in the internal ring buffer,
+ * without copying it; the accessor macros of u_gnss_ubx_view.h
+ * may then be used to read the fields of a UBX message in place.
+ * Since the message may wrap around the end of the ring buffer the
+ * returned length may be less than the length of the message; if it
+ * is too short for your purposes, use uGnssMsgReceiveCallbackRead()
+ * instead.  The pointer is valid only until pCallback returns or
+ * uGnssMsgReceiveCallbackExtract() is called.
+ *
+ * IMPORTANT: this function can ONLY be called from the message
+ * receive pCallback, it is NOT thread-safe to call it from anywhere else.
+ *
+ * @param gnssHandle     the handle of the GNSS instance.
+ * @param[out] ppBuffer  a place to put a pointer to the message,
+ *                       which includes any header, $, checksum
+ *                       etc.; cannot be NULL.
+ * @return               on success the number of contiguous bytes
+ *                       of the message at *ppBuffer, else negative
+ *                       error code.
+ */
+int32_t uGnssMsgReceiveCallbackView(uDeviceHandle_t gnssHandle,
+                                    const char **ppBuffer);
+
 /** Stop monitoring the output of the GNSS chip for a message.
  * Once this function returns the pCallback function passed to the
  * associated uGnssMsgReceiveStart() will no longer be called.
@@ -474,6 +541,62 @@ size_t uGnssMsgReceiveStatReadLoss(uDeviceHandle_t gnssHandle);
  */
 size_t uGnssMsgReceiveStatStreamLoss(uDeviceHandle_t gnssHandle);
 
+/** Get the largest number of bytes that have been waiting in the
+ * ring buffer for the non-blocking message receive handler since
+ * it was started; if this is getting close to the ring buffer
+ * length (see uGnssAddWithBuffers()) then
+ * uGnssMsgReceiveStatReadLoss() is likely to start climbing.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @return             the high water mark in bytes, zero if
+ *                     the non-blocking message receive handler
+ *                     is not running.
+ */
+size_t uGnssMsgReceiveStatReadHighWaterMark(uDeviceHandle_t gnssHandle);
+
+/** Get the largest number of bytes of the ring buffer that have
+ * been in use, as seen at the input of the ring buffer, since the
+ * GNSS instance was added; if this is getting close to the ring
+ * buffer length (see uGnssAddWithBuffers()) then
+ * uGnssMsgReceiveStatStreamLoss() is likely to start climbing.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @return             the high water mark in bytes.
+ */
+size_t uGnssMsgReceiveStatStreamHighWaterMark(uDeviceHandle_t gnssHandle);
+
+/** Get the number of times that data from a streaming source has
+ * been pushed out of the ring buffer before a reader was able to get
+ * at it, i.e. the number of occasions on which
+ * uGnssMsgReceiveStatReadLoss(), or the loss of some other reader of
+ * the ring buffer (e.g. the one behind uGnssMsgReceive()), went up.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @return             the number of evictions.
+ */
+size_t uGnssMsgReceiveStatStreamEvictions(uDeviceHandle_t gnssHandle);
+
+/** Get the occupancy histogram of the ring buffer since the GNSS
+ * instance was added: each time data from a streaming source is
+ * added to the ring buffer the amount of it that is then in use is
+ * sampled, and the count in the corresponding bin incremented, bin
+ * zero being nearly empty and the last bin nearly full: if the upper
+ * bins are always zero the ring buffer (see uGnssAddWithBuffers())
+ * could be made smaller, if the top bin is often non-zero it should
+ * be made larger.  The number of bins is set by
+ * #U_RING_BUFFER_STAT_OCCUPANCY_NUM_BINS, in u_ringbuffer.h, which is
+ * 8 by default.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param[out] pBins   a place to put the counts, cannot be NULL.
+ * @param numBins      the number of entries at pBins; any beyond
+ *                     the number of bins are set to zero.
+ * @return             the number of bins written to pBins, else
+ *                     negative error code.
+ */
+int32_t uGnssMsgReceiveStatStreamOccupancy(uDeviceHandle_t gnssHandle,
+                                           size_t *pBins, size_t numBins);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_NMEA_H_
+#define _U_GNSS_NMEA_H_
+
+/* No #includes allowed here */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines decoders for the common NMEA
+ * sentences, GGA, RMC, GSA, GSV and VTG, as received with
+ * uGnssMsgReceive() or seen in a uGnssMsgReceiveStart() callback,
+ * e.g. with uGnssMsgReceiveCallbackView().  The decoders work on the
+ * sentence where it is, without copying or modifying it and without
+ * allocating memory: the fields are tokenized, converted to fixed-point
+ * integers and the checksum is checked in a single pass.  Any talker
+ * (GP, GN, GL, GA, etc.) is accepted.
+ *
+ * An empty field, or one that cannot be understood, is returned as
+ * #U_GNSS_NMEA_EMPTY (or as zero for a character field).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The value of an integer field that was empty or could not be
+ * understood.
+ */
+#define U_GNSS_NMEA_EMPTY INT32_MIN
+
+/** The maximum number of satellites in a GSA sentence.
+ */
+#define U_GNSS_NMEA_GSA_MAX_NUM_SVS 12
+
+/** The maximum number of satellites in a GSV sentence.
+ */
+#define U_GNSS_NMEA_GSV_MAX_NUM_SVS 4
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A decoded GGA sentence: time, position and fix data.
+ */
+typedef struct {
+    int32_t timeOfDayMs;         /**< UTC time of day in milliseconds. */
+    int32_t latitudeX1e7;        /**< degrees * 10^7, negative for south. */
+    int32_t longitudeX1e7;       /**< degrees * 10^7, negative for west. */
+    int32_t quality;             /**< 0 for no fix, 1 for a fix, 2 for a
+                                      differential fix, 4 for RTK fixed,
+                                      5 for RTK float, 6 for dead reckoning. */
+    int32_t numSvs;              /**< the number of satellites used. */
+    int32_t hdopX100;            /**< horizontal dilution of precision * 100. */
+    int32_t altitudeMillimetres; /**< altitude above mean sea level. */
+    int32_t geoidSeparationMillimetres; /**< the height of the geoid above
+                                             the WGS84 ellipsoid. */
+} uGnssNmeaGga_t;
+
+/** A decoded RMC sentence: the recommended minimum data.
+ */
+typedef struct {
+    int32_t timeOfDayMs;        /**< UTC time of day in milliseconds. */
+    bool valid;                 /**< true if the status is 'A'. */
+    int32_t latitudeX1e7;       /**< degrees * 10^7, negative for south. */
+    int32_t longitudeX1e7;      /**< degrees * 10^7, negative for west. */
+    int32_t speedMillimetresPerSecond; /**< speed over ground. */
+    int32_t courseX100;         /**< course over ground in degrees * 100. */
+    int32_t day;                /**< day of the month, 1 to 31. */
+    int32_t month;              /**< 1 to 12. */
+    int32_t year;               /**< e.g. 2022. */
+    char mode;                  /**< the mode indicator, e.g. 'A' for
+                                     autonomous, 'D' for differential,
+                                     'N' for not valid; zero if absent. */
+} uGnssNmeaRmc_t;
+
+/** A decoded GSA sentence: dilution of precision and the satellites
+ * in use.
+ */
+typedef struct {
+    char opMode;                /**< 'M' for manual, 'A' for automatic. */
+    int32_t navMode;            /**< 1 for no fix, 2 for 2D, 3 for 3D. */
+    size_t numSvs;              /**< the number of entries in svId[]. */
+    int32_t svId[U_GNSS_NMEA_GSA_MAX_NUM_SVS]; /**< the satellites used. */
+    int32_t pdopX100;           /**< position dilution of precision * 100. */
+    int32_t hdopX100;           /**< horizontal dilution of precision * 100. */
+    int32_t vdopX100;           /**< vertical dilution of precision * 100. */
+    int32_t systemId;           /**< the GNSS system ID (NMEA 4.10 and
+                                     later), #U_GNSS_NMEA_EMPTY if absent. */
+} uGnssNmeaGsa_t;
+
+/** A satellite in a GSV sentence.
+ */
+typedef struct {
+    int32_t svId;
+    int32_t elevationDegrees;
+    int32_t azimuthDegrees;
+    int32_t cnoDbhz;            /**< #U_GNSS_NMEA_EMPTY if not tracked. */
+} uGnssNmeaGsvSv_t;
+
+/** A decoded GSV sentence: the satellites in view; there may be
+ * several GSV sentences for one talker in each epoch.
+ */
+typedef struct {
+    int32_t numMessages;        /**< the number of GSV sentences. */
+    int32_t messageNumber;      /**< the number of this one, from 1. */
+    int32_t numSvsInView;       /**< across all numMessages sentences. */
+    size_t numSvs;              /**< the number of entries in sv[]. */
+    uGnssNmeaGsvSv_t sv[U_GNSS_NMEA_GSV_MAX_NUM_SVS];
+    int32_t signalId;           /**< the signal ID (NMEA 4.10 and later),
+                                     #U_GNSS_NMEA_EMPTY if absent. */
+} uGnssNmeaGsv_t;
+
+/** A decoded VTG sentence: course and speed over ground.
+ */
+typedef struct {
+    int32_t courseTrueX100;     /**< true course in degrees * 100. */
+    int32_t courseMagneticX100; /**< magnetic course in degrees * 100. */
+    int32_t speedMillimetresPerSecond; /**< from the km/h field. */
+    char mode;                  /**< the mode indicator, zero if absent. */
+} uGnssNmeaVtg_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Decode a GGA sentence.
+ *
+ * @param[in] pSentence  the sentence, starting with '$' and ending
+ *                       with the checksum (a trailing CR/LF is
+ *                       allowed); need not be null-terminated.
+ * @param size           the number of bytes at pSentence.
+ * @param[out] pGga      a place to put the decoded sentence; cannot
+ *                       be NULL.
+ * @return               zero on success, else negative error code;
+ *                       #U_ERROR_COMMON_NOT_FOUND if the sentence is
+ *                       not a GGA sentence, #U_GNSS_ERROR_CRC if it
+ *                       is not a complete NMEA sentence with a good
+ *                       checksum.
+ */
+int32_t uGnssNmeaDecodeGga(const char *pSentence, size_t size,
+                           uGnssNmeaGga_t *pGga);
+
+/** Decode an RMC sentence.
+ *
+ * @param[in] pSentence  the sentence, see uGnssNmeaDecodeGga().
+ * @param size           the number of bytes at pSentence.
+ * @param[out] pRmc      a place to put the decoded sentence; cannot
+ *                       be NULL.
+ * @return               zero on success, else negative error code,
+ *                       see uGnssNmeaDecodeGga().
+ */
+int32_t uGnssNmeaDecodeRmc(const char *pSentence, size_t size,
+                           uGnssNmeaRmc_t *pRmc);
+
+/** Decode a GSA sentence.
+ *
+ * @param[in] pSentence  the sentence, see uGnssNmeaDecodeGga().
+ * @param size           the number of bytes at pSentence.
+ * @param[out] pGsa      a place to put the decoded sentence; cannot
+ *                       be NULL.
+ * @return               zero on success, else negative error code,
+ *                       see uGnssNmeaDecodeGga().
+ */
+int32_t uGnssNmeaDecodeGsa(const char *pSentence, size_t size,
+                           uGnssNmeaGsa_t *pGsa);
+
+/** Decode a GSV sentence.
+ *
+ * @param[in] pSentence  the sentence, see uGnssNmeaDecodeGga().
+ * @param size           the number of bytes at pSentence.
+ * @param[out] pGsv      a place to put the decoded sentence; cannot
+ *                       be NULL.
+ * @return               zero on success, else negative error code,
+ *                       see uGnssNmeaDecodeGga().
+ */
+int32_t uGnssNmeaDecodeGsv(const char *pSentence, size_t size,
+                           uGnssNmeaGsv_t *pGsv);
+
+/** Decode a VTG sentence.
+ *
+ * @param[in] pSentence  the sentence, see uGnssNmeaDecodeGga().
+ * @param size           the number of bytes at pSentence.
+ * @param[out] pVtg      a place to put the decoded sentence; cannot
+ *                       be NULL.
+ * @return               zero on success, else negative error code,
+ *                       see uGnssNmeaDecodeGga().
+ */
+int32_t uGnssNmeaDecodeVtg(const char *pSentence, size_t size,
+                           uGnssNmeaVtg_t *pVtg);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_NMEA_H_
+
+// End of file
@@ -67,6 +67,13 @@ extern "C" {
  */
 #define U_GNSS_RRLP_PSEUDORANGE_RMS_ERROR_INDEX_LIMIT_RECOMMENDED 3
 
+#ifndef U_GNSS_POS_STREAMED_PERIOD_MIN_MS
+/** The shortest measurement period that may be passed to
+ * uGnssPosGetStreamedStart(), 40 ms being 25 Hz.
+ */
+# define U_GNSS_POS_STREAMED_PERIOD_MIN_MS 40
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -188,6 +195,62 @@ int32_t uGnssPosGetStart(uDeviceHandle_t gnssHandle,
  */
 void uGnssPosGetStop(uDeviceHandle_t gnssHandle);
 
+/** Have the GNSS chip stream position, rather than polling for it
+ * as uGnssPosGet() and uGnssPosGetStart() do.  The GNSS chip is
+ * configured to emit UBX-NAV-PVT every measurement epoch on the port
+ * this MCU is connected to, optionally with a new measurement period,
+ * and each fix is delivered to pCallback as it arrives through
+ * the message receive machinery of uGnssMsgReceiveStart(); this
+ * halves the traffic on the interface compared with polling and
+ * allows rates of up to 25 Hz (subject to the capabilities of the
+ * GNSS chip).  The configuration that was in place before is
+ * restored by uGnssPosGetStreamedStop().
+ *
+ * This is only supported on M9 modules and beyond (it employs
+ * UBX-CFG-VALSET) and only where the GNSS chip is connected directly
+ * to this MCU via a streaming transport (i.e. UART or I2C).  It may
+ * be used alongside uGnssMsgReceiveStart() but not at the same time
+ * as uGnssPosGetStart().
+ *
+ * @param gnssHandle           the handle of the GNSS instance.
+ * @param measurementPeriodMs  the measurement period to set in
+ *                             milliseconds, no smaller than
+ *                             #U_GNSS_POS_STREAMED_PERIOD_MIN_MS;
+ *                             use -1 to leave the measurement
+ *                             period as it is.
+ * @param[in] pCallback        the callback to be called with each fix,
+ *                             parameters as for uGnssPosGetStart();
+ *                             it is called from the message receive
+ *                             task and the same restrictions apply as
+ *                             to the pCallback of uGnssMsgReceiveStart(),
+ *                             i.e. the callback should be quick and
+ *                             should not call back into this API.
+ *                             Cannot be NULL.
+ * @return                     zero on success or negative error code
+ *                             on failure; #U_ERROR_COMMON_NO_MEMORY
+ *                             is also returned if streaming is
+ *                             already running.
+ */
+int32_t uGnssPosGetStreamedStart(uDeviceHandle_t gnssHandle,
+                                 int32_t measurementPeriodMs,
+                                 void (*pCallback) (uDeviceHandle_t gnssHandle,
+                                                    int32_t errorCode,
+                                                    int32_t latitudeX1e7,
+                                                    int32_t longitudeX1e7,
+                                                    int32_t altitudeMillimetres,
+                                                    int32_t radiusMillimetres,
+                                                    int32_t speedMillimetresPerSecond,
+                                                    int32_t svs,
+                                                    int64_t timeUtc));
+
+/** Stop streamed position, as started by uGnssPosGetStreamedStart(),
+ * restoring the previous UBX-NAV-PVT output rate and measurement
+ * period; once this returns pCallback will not be called again.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ */
+void uGnssPosGetStreamedStop(uDeviceHandle_t gnssHandle);
+
 /** Get the binary RRLP information directly from the GNSS chip,
  * as returned by the UBX-RXM-MEASX command of the UBX protocol.  This
  * is more efficient, both in terms of power and time, than asking
@@ -107,6 +107,37 @@ extern "C" {
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Storage for the navigation database of a GNSS chip, used to
+ * give a hot start on a board where the GNSS chip has no backup
+ * supply, see uGnssPwrSetHotStart().
+ */
+typedef struct {
+    char *pBuffer;  /**< storage for the navigation database, a few
+                         kbytes, see uGnssMgaDatabaseSave(). */
+    size_t size;    /**< the amount of storage at pBuffer. */
+    size_t length;  /**< the number of bytes of valid data at pBuffer:
+                         written at power-off, read at power-on.  If
+                         you have put the contents of pBuffer
+                         somewhere else in the meantime, e.g. into
+                         non-volatile storage while the MCU slept, set
+                         this when you put them back; set it to zero
+                         if there is nothing to restore. */
+} uGnssPwrHotStart_t;
+
+/** The outcome of the most recent hot-start save and restore, see
+ * uGnssPwrGetHotStartStatus().
+ */
+typedef struct {
+    int32_t saveErrorCodeOrLength;  /**< the number of bytes saved at the last
+                                         power-off, else negative error code. */
+    size_t saveNumMessages;         /**< the number of UBX-MGA-DBD messages saved. */
+    int32_t saveDurationMs;         /**< how long the save added to power-off. */
+    int32_t restoreErrorCode;       /**< zero if the last restore at power-on
+                                         succeeded, else negative error code. */
+    size_t restoreNumBytes;         /**< the number of bytes restored. */
+    int32_t restoreDurationMs;      /**< how long the restore added to power-on. */
+} uGnssPwrHotStartStatus_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -156,6 +187,42 @@ int32_t uGnssPwrOff(uDeviceHandle_t gnssHandle);
  */
 int32_t uGnssPwrOffBackup(uDeviceHandle_t gnssHandle);
 
+/** Have the navigation database of a GNSS chip saved at power-off
+ * and restored at power-on, so that a board without a backup supply
+ * for the GNSS chip still gets a hot start, a first fix in a few
+ * seconds instead of the 30 seconds or more of a cold start.  When
+ * this is set, uGnssPwrOff() and uGnssPwrOffBackup() first save the
+ * database into pStore with uGnssMgaDatabaseSave(). uGnssPwrOn() then
+ * powers the GNSS chip on and restores the database from pStore with
+ * uGnssMgaUpload() before returning, so before any positioning is
+ * started.  The save adds around #U_GNSS_MGA_DATABASE_SAVE_IDLE_TIMEOUT_MS
+ * to power-off.  If the save fails, the data in pStore is left alone
+ * unless some of it was overwritten.  Use uGnssPwrGetHotStartStatus()
+ * to find out how the save and restore went.  Either can fail without
+ * affecting the power-on or power-off, e.g. because the GNSS transport
+ * is not a streaming one (UART, I2C or SPI).
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ * @param[in] pStore  the storage to use, which must remain valid until
+ *                    this function is called again; use NULL to stop
+ *                    saving and restoring.
+ * @return            zero on success else negative error code.
+ */
+int32_t uGnssPwrSetHotStart(uDeviceHandle_t gnssHandle,
+                            uGnssPwrHotStart_t *pStore);
+
+/** Get the outcome of the most recent hot-start save and restore,
+ * see uGnssPwrSetHotStart().
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param[out] pStatus a place to put the status; cannot be NULL.
+ * @return             zero on success else negative error code;
+ *                     #U_ERROR_COMMON_NOT_FOUND if
+ *                     uGnssPwrSetHotStart() has not been called.
+ */
+int32_t uGnssPwrGetHotStartStatus(uDeviceHandle_t gnssHandle,
+                                  uGnssPwrHotStartStatus_t *pStatus);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_TIME_SYNC_H_
+#define _U_GNSS_TIME_SYNC_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the time synchronisation functions
+ * of the GNSS API: the TIMEPULSE output of a GNSS chip, wired to an
+ * interrupt-capable pin of this MCU, is time-stamped with a host tick
+ * and matched with the UBX-TIM-TP message that the GNSS chip sends
+ * ahead of each pulse to say what GNSS time the pulse will mark.  From
+ * these pairs a model of the offset and drift of the host tick is
+ * kept, so that any host tick can be converted to GNSS time in
+ * constant time, without the request latency that
+ * uGnssInfoGetTimeUtc() suffers from.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_GNSS_TIME_SYNC_DRIFT_WINDOW_SECONDS
+/** The period over which the drift of the host tick is measured:
+ * drift is measured against the first pulse of the period, so the
+ * longer the period the more the jitter of the host tick is averaged
+ * out, but the slower the model follows changes in drift, e.g. with
+ * temperature.
+ */
+# define U_GNSS_TIME_SYNC_DRIFT_WINDOW_SECONDS 64
+#endif
+
+#ifndef U_GNSS_TIME_SYNC_MAX_DRIFT_PPM
+/** The largest difference, in parts per million, between the host
+ * tick and GNSS time over one pulse period that is believed; if the
+ * difference is larger, e.g. because a pulse was missed or the host
+ * tick wrapped, the model is started again.
+ */
+# define U_GNSS_TIME_SYNC_MAX_DRIFT_PPM 1000
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A host tick in microseconds; it must be callable from interrupt
+ * context and must not go backwards, except at a wrap.
+ */
+typedef int64_t (*uGnssTimeSyncTickUs_t)(void);
+
+/** The model that relates the host tick to GNSS time, see
+ * uGnssTimeSyncGetModel().  The GNSS time at host tick t is:
+ *
+ * timeUs + (t - tickUs) - ((t - tickUs) * driftPpb) / 1000000000
+ */
+typedef struct {
+    int64_t tickUs;      /**< the host tick at the most recent aligned
+                              time pulse. */
+    int64_t timeUs;      /**< the GNSS time of that time pulse in
+                              microseconds since midnight on 1 January
+                              1970; UTC if isUtc is true, else GNSS time,
+                              i.e. without leap seconds. */
+    int32_t driftPpb;    /**< how fast the host tick runs compared with
+                              GNSS time in parts per billion, positive if
+                              the host tick is fast; zero until a second
+                              time pulse has been aligned. */
+    bool isUtc;          /**< true if timeUs is UTC, which it is if the
+                              time grid of the time pulse is UTC (the
+                              default) and the GNSS chip knows the leap
+                              seconds. */
+    size_t numPulses;    /**< the number of time pulses aligned since the
+                              model was last started. */
+} uGnssTimeSyncModel_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Start aligning the host tick with GNSS time.  The TIMEPULSE pin
+ * of the GNSS chip must be connected to pinTimepulse of this MCU and
+ * the time pulse should be at the default settings (one pulse per
+ * second, rising edge at the top of the second).  UBX-TIM-TP output
+ * is switched on, in RAM, on the port the GNSS chip is connected on;
+ * this requires a GNSS chip that supports the CFGVALXXX configuration
+ * messages (M9 and later) and a streaming transport (UART, I2C or
+ * SPI), since uGnssMsgReceiveStart() is used to capture UBX-TIM-TP,
+ * hence one of the #U_GNSS_MSG_RECEIVER_MAX_NUM receivers must be free.
+ * There can be one time synchronisation per GNSS instance.
+ *
+ * The accuracy of the model depends on the resolution and interrupt
+ * latency of the host tick: with the default of uPortGetTickTimeMs()
+ * the model is only good to a millisecond or so; for sub-millisecond
+ * accuracy provide a microsecond counter, e.g. a free-running hardware
+ * timer, as pTickUs.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param pinTimepulse the pin of this MCU that the TIMEPULSE output
+ *                     of the GNSS chip is connected to; it will be
+ *                     configured as an input with an interrupt on
+ *                     the rising edge.
+ * @param pTickUs      the host tick to align, which will be called
+ *                     in interrupt context; use NULL for
+ *                     uPortGetTickTimeMs() * 1000, in which case
+ *                     the model will start again each time
+ *                     uPortGetTickTimeMs() wraps.
+ * @return             zero on success else negative error code.
+ */
+int32_t uGnssTimeSyncStart(uDeviceHandle_t gnssHandle,
+                           int32_t pinTimepulse,
+                           uGnssTimeSyncTickUs_t pTickUs);
+
+/** Get the current model relating the host tick to GNSS time.
+ *
+ * @param gnssHandle   the handle of the GNSS instance.
+ * @param[out] pModel  a place to put the model; cannot be NULL.
+ * @return             zero on success else negative error code;
+ *                     #U_ERROR_COMMON_NOT_FOUND if no time pulse
+ *                     has yet been aligned.
+ */
+int32_t uGnssTimeSyncGetModel(uDeviceHandle_t gnssHandle,
+                              uGnssTimeSyncModel_t *pModel);
+
+/** Convert a host tick, from the same source as that passed to
+ * uGnssTimeSyncStart(), to GNSS time.  This takes constant time: it
+ * does not talk to the GNSS chip and does not wait for any other
+ * GNSS API call to finish.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ * @param tickUs      the host tick.
+ * @return            the GNSS time at tickUs in microseconds since
+ *                    midnight on 1 January 1970 (see the isUtc
+ *                    field of #uGnssTimeSyncModel_t), else negative
+ *                    error code; #U_ERROR_COMMON_NOT_FOUND if no
+ *                    time pulse has yet been aligned.
+ */
+int64_t uGnssTimeSyncGetTimeUs(uDeviceHandle_t gnssHandle,
+                               int64_t tickUs);
+
+/** Stop aligning the host tick with GNSS time: the interrupt is
+ * removed from the pin and UBX-TIM-TP output is put back as it was.
+ *
+ * @param gnssHandle  the handle of the GNSS instance.
+ */
+void uGnssTimeSyncStop(uDeviceHandle_t gnssHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_TIME_SYNC_H_
+
+// End of file
@@ -127,6 +127,10 @@ typedef enum {
                                      PLEASE USE #U_GNSS_TRANSPORT_I2C instead and
                                      use uGnssCfgSetProtocolOut() to switch off NMEA
                                      message output if required. */
+    U_GNSS_TRANSPORT_SPI,       /**< the transport handle should be an SPI handle,
+                                     see u_port_spi.h.  Note that SPI is always
+                                     full duplex: whatever the GNSS chip sends while
+                                     this MCU is sending is kept. */
     U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX,
     U_GNSS_TRANSPORT_UBX_AT = U_GNSS_TRANSPORT_AT,      /**< \deprecated the transport handle should be an AT client
                                                              handle over which UBX commands will be
@@ -152,8 +156,36 @@ typedef union {
     void *pAt;      /**< for transport type #U_GNSS_TRANSPORT_AT. */
     int32_t uart;   /**< for transport type #U_GNSS_TRANSPORT_UART. */
     int32_t i2c;    /**< for transport type #U_GNSS_TRANSPORT_I2C. */
+    int32_t spi;    /**< for transport type #U_GNSS_TRANSPORT_SPI. */
 } uGnssTransportHandle_t;
 
+/** The buffers used by a GNSS instance with a streaming transport
+ * (e.g. UART or I2C), see uGnssAddWithBuffers(); all fields may be
+ * left at zero/NULL to get the defaults.
+ */
+typedef struct {
+    size_t ringBufferLengthBytes;      /**< the length of the ring buffer that
+                                            holds messages streamed from the
+                                            GNSS chip; use 0 for the default of
+                                            #U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES. */
+    char *pRingBuffer;                 /**< storage for the ring buffer, at least
+                                            ringBufferLengthBytes long, which must
+                                            remain valid until the instance is
+                                            removed; use NULL to have it allocated. */
+    size_t temporaryBufferLengthBytes; /**< the length of the temporary buffer used
+                                            to get data from the transport into
+                                            the ring buffer, must be less than
+                                            ringBufferLengthBytes - 1; use 0 for one
+                                            eighth of the ring buffer length. */
+    char *pTemporaryBuffer;            /**< storage for the temporary buffer, at
+                                            least temporaryBufferLengthBytes long,
+                                            which must remain valid until the instance
+                                            is removed; use NULL to have it allocated.
+                                            Note that the non-blocking message receive
+                                            task always allocates a temporary buffer
+                                            of its own, of the same length. */
+} uGnssBufferCfg_t;
+
 /** The port type on the GNSS chip itself; this is different
  * from the uGnssTransportType_t since, for instance, a USB port
  * on the MCU might be connected to a UART port on the GNSS chip,
@@ -0,0 +1,693 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_UBX_VIEW_H_
+#define _U_GNSS_UBX_VIEW_H_
+
+/* No #includes allowed here; the accessors below use the decode
+ * functions of u_ubx_protocol.h, which must be included first, and
+ * the offsets are derived with offsetof(), hence stddef.h must also
+ * have been included. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief Accessor macros that read the fields of commonly used UBX
+ * messages in place, from wherever the message body happens to be:
+ * a buffer filled by uGnssMsgReceive(), the pointer returned by
+ * uGnssMsgReceiveCallbackView() or a body returned by
+ * uGnssUtilUbxTransparentSendReceive().  No copy is made and
+ * endianness is respected; a field is decoded only when its
+ * accessor is used.  Each takes a pointer to the start of the message
+ * BODY (i.e. after the 6-byte UBX header, see #U_GNSS_UBX_VIEW_BODY());
+ * it is up to the caller to check, e.g. with
+ * #U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(), that the body is long enough
+ * before accessing it.
+ *
+ * Each message (or fixed part, or repeated block, of a message) is
+ * described once, as an X-macro list of its fields in order, giving
+ * the name, UBX type and scaling of each; from that list
+ * #U_GNSS_UBX_VIEW_DESCRIBE() generates, as compile-time constants:
+ *
+ * - U_GNSS_UBX_<msg>_OFFSET_<field>: the offset of the field,
+ * - U_GNSS_UBX_<msg>_TYPE_<field>: the UBX type of the field, one
+ *   of U_GNSS_UBX_VIEW_TYPE_xx,
+ * - U_GNSS_UBX_<msg>_SCALE_<field>: the power of ten that the field
+ *   must be multiplied by to get the units given in the list, e.g.
+ *   -7 for a latitude in degrees * 1e7,
+ * - U_GNSS_UBX_<msg>_LENGTH_BYTES: the length of the message, fixed
+ *   part or block,
+ *
+ * ...and checks the total length against the interface description.
+ * Fields are then read with #U_GNSS_UBX_VIEW_GET(), which fails
+ * compilation if the type given does not match that in the list,
+ * or with the named accessors below, which are built on it.
+ * Supporting a new message needs only its field list and one
+ * #U_GNSS_UBX_VIEW_DESCRIBE().
+ *
+ * Offsets, types and scaling are those of the u-blox M8/M9/M10
+ * interface descriptions.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: GENERAL
+ * -------------------------------------------------------------- */
+
+/** Fail compilation, by declaring an array of negative size, if
+ * condition is false.
+ */
+#define U_GNSS_UBX_VIEW_COMPILE_TIME_CHECK(name, condition) \
+    typedef char name[(condition) ? 1 : -1]
+
+/** Return a pointer to the body of a complete UBX message, i.e.
+ * one that begins 0xB5 0x62.
+ */
+#define U_GNSS_UBX_VIEW_BODY(pMessage) ((pMessage) + 6)
+
+/** Return the body length encoded in the header of a complete
+ * UBX message.
+ */
+#define U_GNSS_UBX_VIEW_BODY_LENGTH(pMessage) \
+    ((size_t) uUbxProtocolUint16Decode((pMessage) + 4))
+
+/** Return true if length bytes of a complete UBX message,
+ * starting at its header, are enough to include a body of
+ * bodyLength bytes.
+ */
+#define U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(length, bodyLength) \
+    ((size_t) (length) >= (size_t) (bodyLength) + 6)
+
+/** The UBX field types.
+ */
+#define U_GNSS_UBX_VIEW_TYPE_U1 0
+#define U_GNSS_UBX_VIEW_TYPE_I1 1
+#define U_GNSS_UBX_VIEW_TYPE_X1 2
+#define U_GNSS_UBX_VIEW_TYPE_U2 3
+#define U_GNSS_UBX_VIEW_TYPE_I2 4
+#define U_GNSS_UBX_VIEW_TYPE_X2 5
+#define U_GNSS_UBX_VIEW_TYPE_U4 6
+#define U_GNSS_UBX_VIEW_TYPE_I4 7
+#define U_GNSS_UBX_VIEW_TYPE_X4 8
+#define U_GNSS_UBX_VIEW_TYPE_R4 9
+#define U_GNSS_UBX_VIEW_TYPE_R8 10
+
+/** The size of each UBX field type.
+ */
+#define U_GNSS_UBX_VIEW_SIZE_U1 1
+#define U_GNSS_UBX_VIEW_SIZE_I1 1
+#define U_GNSS_UBX_VIEW_SIZE_X1 1
+#define U_GNSS_UBX_VIEW_SIZE_U2 2
+#define U_GNSS_UBX_VIEW_SIZE_I2 2
+#define U_GNSS_UBX_VIEW_SIZE_X2 2
+#define U_GNSS_UBX_VIEW_SIZE_U4 4
+#define U_GNSS_UBX_VIEW_SIZE_I4 4
+#define U_GNSS_UBX_VIEW_SIZE_X4 4
+#define U_GNSS_UBX_VIEW_SIZE_R4 4
+#define U_GNSS_UBX_VIEW_SIZE_R8 8
+
+/** Field accessors by UBX type, offsets in bytes from pBody:
+ * U1/I1/X1, U2/I2/X2, U4/I4/X4, R4 and R8.
+ */
+#define U_GNSS_UBX_VIEW_U1(pBody, offset) ((uint8_t) *((pBody) + (offset)))
+#define U_GNSS_UBX_VIEW_I1(pBody, offset) ((int8_t) *((pBody) + (offset)))
+#define U_GNSS_UBX_VIEW_U2(pBody, offset) uUbxProtocolUint16Decode((pBody) + (offset))
+#define U_GNSS_UBX_VIEW_I2(pBody, offset) ((int16_t) uUbxProtocolUint16Decode((pBody) + (offset)))
+#define U_GNSS_UBX_VIEW_U4(pBody, offset) uUbxProtocolUint32Decode((pBody) + (offset))
+#define U_GNSS_UBX_VIEW_I4(pBody, offset) ((int32_t) uUbxProtocolUint32Decode((pBody) + (offset)))
+#define U_GNSS_UBX_VIEW_R4(pBody, offset) uUbxProtocolFloatDecode((pBody) + (offset))
+#define U_GNSS_UBX_VIEW_R8(pBody, offset) uUbxProtocolDoubleDecode((pBody) + (offset))
+#define U_GNSS_UBX_VIEW_X1(pBody, offset) U_GNSS_UBX_VIEW_U1(pBody, offset)
+#define U_GNSS_UBX_VIEW_X2(pBody, offset) U_GNSS_UBX_VIEW_U2(pBody, offset)
+#define U_GNSS_UBX_VIEW_X4(pBody, offset) U_GNSS_UBX_VIEW_U4(pBody, offset)
+
+/** Read field name, of UBX type type, of the message, fixed part
+ * or block msg (e.g. NAV_PVT) from pBody; compilation fails if type
+ * is not the type of the field in the field list of msg.
+ */
+#define U_GNSS_UBX_VIEW_GET(pBody, msg, name, type)                      \
+    ((void) sizeof(char[(U_GNSS_UBX_##msg##_TYPE_##name ==                \
+                         U_GNSS_UBX_VIEW_TYPE_##type) ? 1 : -1]),         \
+     U_GNSS_UBX_VIEW_##type(pBody, U_GNSS_UBX_##msg##_OFFSET_##name))
+
+/** Helpers for #U_GNSS_UBX_VIEW_DESCRIBE(), each the X of a field
+ * list; the field names are always pasted so that they are never
+ * themselves macro-expanded.
+ */
+#define U_GNSS_UBX_VIEW_X_MEMBER(msg, name, type, scale) \
+    char field##name[U_GNSS_UBX_VIEW_SIZE_##type];
+#define U_GNSS_UBX_VIEW_X_OFFSET(msg, name, type, scale) \
+    U_GNSS_UBX_##msg##_OFFSET_##name = offsetof(uGnssUbxViewLayout##msg##_t, field##name),
+#define U_GNSS_UBX_VIEW_X_TYPE(msg, name, type, scale) \
+    U_GNSS_UBX_##msg##_TYPE_##name = U_GNSS_UBX_VIEW_TYPE_##type,
+#define U_GNSS_UBX_VIEW_X_SCALE(msg, name, type, scale) \
+    U_GNSS_UBX_##msg##_SCALE_##name = (scale),
+#define U_GNSS_UBX_VIEW_X_SIZE(msg, name, type, scale) \
+    + U_GNSS_UBX_VIEW_SIZE_##type
+
+/** Generate the constants of the message, fixed part or block msg,
+ * whose field list must be U_GNSS_UBX_<msg>_FIELDS(X, msg), an entry
+ * X(msg, name, type, scale) for each field in order (reserved fields
+ * included), and check at compile time that the fields add up to
+ * lengthBytes, the length given by the interface description.  The
+ * layout structure is only there for offsetof(): it is an array of
+ * chars so that there can be no padding, which is checked too.
+ */
+#define U_GNSS_UBX_VIEW_DESCRIBE(msg, lengthBytes)                        \
+    typedef struct {                                                     \
+        U_GNSS_UBX_##msg##_FIELDS(U_GNSS_UBX_VIEW_X_MEMBER, msg)         \
+    } uGnssUbxViewLayout##msg##_t;                                       \
+    enum {                                                               \
+        U_GNSS_UBX_##msg##_FIELDS(U_GNSS_UBX_VIEW_X_OFFSET, msg)         \
+        U_GNSS_UBX_##msg##_FIELDS(U_GNSS_UBX_VIEW_X_TYPE, msg)           \
+        U_GNSS_UBX_##msg##_FIELDS(U_GNSS_UBX_VIEW_X_SCALE, msg)          \
+        U_GNSS_UBX_##msg##_LENGTH_BYTES = 0                              \
+            U_GNSS_UBX_##msg##_FIELDS(U_GNSS_UBX_VIEW_X_SIZE, msg)       \
+    };                                                                   \
+    U_GNSS_UBX_VIEW_COMPILE_TIME_CHECK(uGnssUbxViewCheck##msg##_t,       \
+                                       (U_GNSS_UBX_##msg##_LENGTH_BYTES == \
+                                        (lengthBytes)) &&                \
+                                       (sizeof(uGnssUbxViewLayout##msg##_t) == \
+                                        (lengthBytes)))
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-NAV-PVT
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-NAV-PVT.
+ */
+#define U_GNSS_UBX_NAV_PVT_CLASS 0x01
+#define U_GNSS_UBX_NAV_PVT_ID    0x07
+
+/** The fields of UBX-NAV-PVT.
+ */
+#define U_GNSS_UBX_NAV_PVT_FIELDS(X, msg) \
+    X(msg, ITOW,      U4,  0) /* ms. */                  \
+    X(msg, YEAR,      U2,  0)                            \
+    X(msg, MONTH,     U1,  0) /* 1 to 12. */             \
+    X(msg, DAY,       U1,  0) /* 1 to 31. */             \
+    X(msg, HOUR,      U1,  0) /* 0 to 23. */             \
+    X(msg, MIN,       U1,  0) /* 0 to 59. */             \
+    X(msg, SEC,       U1,  0) /* 0 to 60. */             \
+    X(msg, VALID,     X1,  0)                            \
+    X(msg, T_ACC,     U4,  0) /* ns. */                  \
+    X(msg, NANO,      I4,  0) /* ns. */                  \
+    X(msg, FIX_TYPE,  U1,  0)                            \
+    X(msg, FLAGS,     X1,  0)                            \
+    X(msg, FLAGS2,    X1,  0)                            \
+    X(msg, NUM_SV,    U1,  0)                            \
+    X(msg, LON,       I4, -7) /* degrees. */             \
+    X(msg, LAT,       I4, -7) /* degrees. */             \
+    X(msg, HEIGHT,    I4,  0) /* mm above ellipsoid. */  \
+    X(msg, H_MSL,     I4,  0) /* mm above sea level. */  \
+    X(msg, H_ACC,     U4,  0) /* mm. */                  \
+    X(msg, V_ACC,     U4,  0) /* mm. */                  \
+    X(msg, VEL_N,     I4,  0) /* mm/s. */                \
+    X(msg, VEL_E,     I4,  0) /* mm/s. */                \
+    X(msg, VEL_D,     I4,  0) /* mm/s. */                \
+    X(msg, G_SPEED,   I4,  0) /* mm/s. */                \
+    X(msg, HEAD_MOT,  I4, -5) /* degrees. */             \
+    X(msg, S_ACC,     U4,  0) /* mm/s. */                \
+    X(msg, HEAD_ACC,  U4, -5) /* degrees. */             \
+    X(msg, P_DOP,     U2, -2)                            \
+    X(msg, FLAGS3,    X2,  0)                            \
+    X(msg, RESERVED1, U4,  0)                            \
+    X(msg, HEAD_VEH,  I4, -5) /* degrees. */             \
+    X(msg, MAG_DEC,   I2, -2) /* degrees. */             \
+    X(msg, MAG_ACC,   U2, -2) /* degrees. */
+
+/** The body length of UBX-NAV-PVT.
+ */
+#define U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES U_GNSS_UBX_NAV_PVT_LENGTH_BYTES
+
+/** The bits of the valid field of UBX-NAV-PVT that must both be set
+ * for the date and time to be valid.
+ */
+#define U_GNSS_UBX_NAV_PVT_VALID_DATE_TIME 0x03
+
+/** The gnssFixOK bit of the flags field of UBX-NAV-PVT.
+ */
+#define U_GNSS_UBX_NAV_PVT_FLAGS_GNSS_FIX_OK 0x01
+
+/** Accessors for the fields of UBX-NAV-PVT.
+ */
+#define U_GNSS_UBX_NAV_PVT_ITOW(pBody)     U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, ITOW, U4)
+#define U_GNSS_UBX_NAV_PVT_YEAR(pBody)     U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, YEAR, U2)
+#define U_GNSS_UBX_NAV_PVT_MONTH(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, MONTH, U1)
+#define U_GNSS_UBX_NAV_PVT_DAY(pBody)      U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, DAY, U1)
+#define U_GNSS_UBX_NAV_PVT_HOUR(pBody)     U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, HOUR, U1)
+#define U_GNSS_UBX_NAV_PVT_MIN(pBody)      U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, MIN, U1)
+#define U_GNSS_UBX_NAV_PVT_SEC(pBody)      U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, SEC, U1)
+#define U_GNSS_UBX_NAV_PVT_VALID(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, VALID, X1)
+#define U_GNSS_UBX_NAV_PVT_T_ACC(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, T_ACC, U4)
+#define U_GNSS_UBX_NAV_PVT_NANO(pBody)     U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, NANO, I4)
+#define U_GNSS_UBX_NAV_PVT_FIX_TYPE(pBody) U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, FIX_TYPE, U1)
+#define U_GNSS_UBX_NAV_PVT_FLAGS(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, FLAGS, X1)
+#define U_GNSS_UBX_NAV_PVT_FLAGS2(pBody)   U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, FLAGS2, X1)
+#define U_GNSS_UBX_NAV_PVT_NUM_SV(pBody)   U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, NUM_SV, U1)
+#define U_GNSS_UBX_NAV_PVT_LON(pBody)      U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, LON, I4)
+#define U_GNSS_UBX_NAV_PVT_LAT(pBody)      U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, LAT, I4)
+#define U_GNSS_UBX_NAV_PVT_HEIGHT(pBody)   U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, HEIGHT, I4)
+#define U_GNSS_UBX_NAV_PVT_H_MSL(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, H_MSL, I4)
+#define U_GNSS_UBX_NAV_PVT_H_ACC(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, H_ACC, U4)
+#define U_GNSS_UBX_NAV_PVT_V_ACC(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, V_ACC, U4)
+#define U_GNSS_UBX_NAV_PVT_VEL_N(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, VEL_N, I4)
+#define U_GNSS_UBX_NAV_PVT_VEL_E(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, VEL_E, I4)
+#define U_GNSS_UBX_NAV_PVT_VEL_D(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, VEL_D, I4)
+#define U_GNSS_UBX_NAV_PVT_G_SPEED(pBody)  U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, G_SPEED, I4)
+#define U_GNSS_UBX_NAV_PVT_HEAD_MOT(pBody) U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, HEAD_MOT, I4)
+#define U_GNSS_UBX_NAV_PVT_S_ACC(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, S_ACC, U4)
+#define U_GNSS_UBX_NAV_PVT_HEAD_ACC(pBody) U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, HEAD_ACC, U4)
+#define U_GNSS_UBX_NAV_PVT_P_DOP(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, P_DOP, U2)
+#define U_GNSS_UBX_NAV_PVT_FLAGS3(pBody)   U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, FLAGS3, X2)
+#define U_GNSS_UBX_NAV_PVT_HEAD_VEH(pBody) U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, HEAD_VEH, I4)
+#define U_GNSS_UBX_NAV_PVT_MAG_DEC(pBody)  U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, MAG_DEC, I2)
+#define U_GNSS_UBX_NAV_PVT_MAG_ACC(pBody)  U_GNSS_UBX_VIEW_GET(pBody, NAV_PVT, MAG_ACC, U2)
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-NAV-SAT
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-NAV-SAT.
+ */
+#define U_GNSS_UBX_NAV_SAT_CLASS 0x01
+#define U_GNSS_UBX_NAV_SAT_ID    0x35
+
+/** The fields of the fixed part of UBX-NAV-SAT.
+ */
+#define U_GNSS_UBX_NAV_SAT_FIELDS(X, msg) \
+    X(msg, ITOW,      U4, 0) /* ms. */ \
+    X(msg, VERSION,   U1, 0)           \
+    X(msg, NUM_SVS,   U1, 0)           \
+    X(msg, RESERVED1, U2, 0)
+
+/** The fields of a UBX-NAV-SAT per-satellite block.
+ */
+#define U_GNSS_UBX_NAV_SAT_BLOCK_FIELDS(X, msg) \
+    X(msg, GNSS_ID, U1,  0)                \
+    X(msg, SV_ID,   U1,  0)                \
+    X(msg, CNO,     U1,  0) /* dBHz. */    \
+    X(msg, ELEV,    I1,  0) /* degrees. */ \
+    X(msg, AZIM,    I2,  0) /* degrees. */ \
+    X(msg, PR_RES,  I2, -1) /* m. */       \
+    X(msg, FLAGS,   X4,  0)
+
+/** The length of the fixed part of the body of UBX-NAV-SAT; the
+ * length of each of the repeated per-satellite blocks that follow
+ * it is #U_GNSS_UBX_NAV_SAT_BLOCK_LENGTH_BYTES.
+ */
+#define U_GNSS_UBX_NAV_SAT_HEAD_LENGTH_BYTES U_GNSS_UBX_NAV_SAT_LENGTH_BYTES
+
+/** The body length of UBX-NAV-SAT for a given number of satellites.
+ */
+#define U_GNSS_UBX_NAV_SAT_BODY_LENGTH_BYTES(numSvs) \
+    (U_GNSS_UBX_NAV_SAT_HEAD_LENGTH_BYTES + ((numSvs) * U_GNSS_UBX_NAV_SAT_BLOCK_LENGTH_BYTES))
+
+/** Return a pointer to the per-satellite block with index n
+ * (0 to numSvs - 1) of UBX-NAV-SAT.
+ */
+#define U_GNSS_UBX_NAV_SAT_BLOCK(pBody, n) \
+    ((pBody) + U_GNSS_UBX_NAV_SAT_HEAD_LENGTH_BYTES + ((n) * U_GNSS_UBX_NAV_SAT_BLOCK_LENGTH_BYTES))
+
+/** Accessors for the fields of the fixed part of UBX-NAV-SAT.
+ */
+#define U_GNSS_UBX_NAV_SAT_ITOW(pBody)    U_GNSS_UBX_VIEW_GET(pBody, NAV_SAT, ITOW, U4)
+#define U_GNSS_UBX_NAV_SAT_VERSION(pBody) U_GNSS_UBX_VIEW_GET(pBody, NAV_SAT, VERSION, U1)
+#define U_GNSS_UBX_NAV_SAT_NUM_SVS(pBody) U_GNSS_UBX_VIEW_GET(pBody, NAV_SAT, NUM_SVS, U1)
+
+/** Accessors for the fields of a UBX-NAV-SAT per-satellite block,
+ * as returned by #U_GNSS_UBX_NAV_SAT_BLOCK().
+ */
+#define U_GNSS_UBX_NAV_SAT_GNSS_ID(pBlock) U_GNSS_UBX_VIEW_GET(pBlock, NAV_SAT_BLOCK, GNSS_ID, U1)
+#define U_GNSS_UBX_NAV_SAT_SV_ID(pBlock)   U_GNSS_UBX_VIEW_GET(pBlock, NAV_SAT_BLOCK, SV_ID, U1)
+#define U_GNSS_UBX_NAV_SAT_CNO(pBlock)     U_GNSS_UBX_VIEW_GET(pBlock, NAV_SAT_BLOCK, CNO, U1)
+#define U_GNSS_UBX_NAV_SAT_ELEV(pBlock)    U_GNSS_UBX_VIEW_GET(pBlock, NAV_SAT_BLOCK, ELEV, I1)
+#define U_GNSS_UBX_NAV_SAT_AZIM(pBlock)    U_GNSS_UBX_VIEW_GET(pBlock, NAV_SAT_BLOCK, AZIM, I2)
+#define U_GNSS_UBX_NAV_SAT_PR_RES(pBlock)  U_GNSS_UBX_VIEW_GET(pBlock, NAV_SAT_BLOCK, PR_RES, I2)
+#define U_GNSS_UBX_NAV_SAT_FLAGS(pBlock)   U_GNSS_UBX_VIEW_GET(pBlock, NAV_SAT_BLOCK, FLAGS, X4)
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-NAV-TIMEUTC
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-NAV-TIMEUTC.
+ */
+#define U_GNSS_UBX_NAV_TIMEUTC_CLASS 0x01
+#define U_GNSS_UBX_NAV_TIMEUTC_ID    0x21
+
+/** The fields of UBX-NAV-TIMEUTC.
+ */
+#define U_GNSS_UBX_NAV_TIMEUTC_FIELDS(X, msg) \
+    X(msg, ITOW,  U4, 0) /* ms. */         \
+    X(msg, T_ACC, U4, 0) /* ns. */         \
+    X(msg, NANO,  I4, 0) /* ns. */         \
+    X(msg, YEAR,  U2, 0)                   \
+    X(msg, MONTH, U1, 0) /* 1 to 12. */    \
+    X(msg, DAY,   U1, 0) /* 1 to 31. */    \
+    X(msg, HOUR,  U1, 0) /* 0 to 23. */    \
+    X(msg, MIN,   U1, 0) /* 0 to 59. */    \
+    X(msg, SEC,   U1, 0) /* 0 to 60. */    \
+    X(msg, VALID, X1, 0)
+
+/** The validUTC bit of the valid field of UBX-NAV-TIMEUTC.
+ */
+#define U_GNSS_UBX_NAV_TIMEUTC_VALID_UTC 0x04
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-RXM-RAWX
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-RXM-RAWX.
+ */
+#define U_GNSS_UBX_RXM_RAWX_CLASS 0x02
+#define U_GNSS_UBX_RXM_RAWX_ID    0x15
+
+/** The fields of the fixed part of UBX-RXM-RAWX.
+ */
+#define U_GNSS_UBX_RXM_RAWX_FIELDS(X, msg) \
+    X(msg, RCV_TOW,   R8, 0) /* s. */ \
+    X(msg, WEEK,      U2, 0)          \
+    X(msg, LEAP_S,    I1, 0) /* s. */ \
+    X(msg, NUM_MEAS,  U1, 0)          \
+    X(msg, REC_STAT,  X1, 0)          \
+    X(msg, VERSION,   U1, 0)          \
+    X(msg, RESERVED1, U2, 0)
+
+/** The fields of a UBX-RXM-RAWX per-measurement block.
+ */
+#define U_GNSS_UBX_RXM_RAWX_BLOCK_FIELDS(X, msg) \
+    X(msg, PR_MES,    R8, 0) /* m. */      \
+    X(msg, CP_MES,    R8, 0) /* cycles. */ \
+    X(msg, DO_MES,    R4, 0) /* Hz. */     \
+    X(msg, GNSS_ID,   U1, 0)               \
+    X(msg, SV_ID,     U1, 0)               \
+    X(msg, SIG_ID,    U1, 0)               \
+    X(msg, FREQ_ID,   U1, 0)               \
+    X(msg, LOCKTIME,  U2, 0) /* ms. */     \
+    X(msg, CNO,       U1, 0) /* dBHz. */   \
+    X(msg, PR_STDEV,  X1, 0)               \
+    X(msg, CP_STDEV,  X1, 0)               \
+    X(msg, DO_STDEV,  X1, 0)               \
+    X(msg, TRK_STAT,  X1, 0)               \
+    X(msg, RESERVED1, U1, 0)
+
+/** The length of the fixed part of the body of UBX-RXM-RAWX; the
+ * length of each of the repeated per-measurement blocks that follow
+ * it is #U_GNSS_UBX_RXM_RAWX_BLOCK_LENGTH_BYTES.
+ */
+#define U_GNSS_UBX_RXM_RAWX_HEAD_LENGTH_BYTES U_GNSS_UBX_RXM_RAWX_LENGTH_BYTES
+
+/** The body length of UBX-RXM-RAWX for a given number of
+ * measurements.
+ */
+#define U_GNSS_UBX_RXM_RAWX_BODY_LENGTH_BYTES(numMeas) \
+    (U_GNSS_UBX_RXM_RAWX_HEAD_LENGTH_BYTES + ((numMeas) * U_GNSS_UBX_RXM_RAWX_BLOCK_LENGTH_BYTES))
+
+/** Return a pointer to the per-measurement block with index n
+ * (0 to numMeas - 1) of UBX-RXM-RAWX.
+ */
+#define U_GNSS_UBX_RXM_RAWX_BLOCK(pBody, n) \
+    ((pBody) + U_GNSS_UBX_RXM_RAWX_HEAD_LENGTH_BYTES + ((n) * U_GNSS_UBX_RXM_RAWX_BLOCK_LENGTH_BYTES))
+
+/** Accessors for the fields of the fixed part of UBX-RXM-RAWX.
+ */
+#define U_GNSS_UBX_RXM_RAWX_RCV_TOW(pBody)  U_GNSS_UBX_VIEW_GET(pBody, RXM_RAWX, RCV_TOW, R8)
+#define U_GNSS_UBX_RXM_RAWX_WEEK(pBody)     U_GNSS_UBX_VIEW_GET(pBody, RXM_RAWX, WEEK, U2)
+#define U_GNSS_UBX_RXM_RAWX_LEAP_S(pBody)   U_GNSS_UBX_VIEW_GET(pBody, RXM_RAWX, LEAP_S, I1)
+#define U_GNSS_UBX_RXM_RAWX_NUM_MEAS(pBody) U_GNSS_UBX_VIEW_GET(pBody, RXM_RAWX, NUM_MEAS, U1)
+#define U_GNSS_UBX_RXM_RAWX_REC_STAT(pBody) U_GNSS_UBX_VIEW_GET(pBody, RXM_RAWX, REC_STAT, X1)
+#define U_GNSS_UBX_RXM_RAWX_VERSION(pBody)  U_GNSS_UBX_VIEW_GET(pBody, RXM_RAWX, VERSION, U1)
+
+/** Accessors for the fields of a UBX-RXM-RAWX per-measurement
+ * block, as returned by #U_GNSS_UBX_RXM_RAWX_BLOCK().
+ */
+#define U_GNSS_UBX_RXM_RAWX_PR_MES(pBlock)   U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, PR_MES, R8)
+#define U_GNSS_UBX_RXM_RAWX_CP_MES(pBlock)   U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, CP_MES, R8)
+#define U_GNSS_UBX_RXM_RAWX_DO_MES(pBlock)   U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, DO_MES, R4)
+#define U_GNSS_UBX_RXM_RAWX_GNSS_ID(pBlock)  U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, GNSS_ID, U1)
+#define U_GNSS_UBX_RXM_RAWX_SV_ID(pBlock)    U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, SV_ID, U1)
+#define U_GNSS_UBX_RXM_RAWX_SIG_ID(pBlock)   U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, SIG_ID, U1)
+#define U_GNSS_UBX_RXM_RAWX_FREQ_ID(pBlock)  U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, FREQ_ID, U1)
+#define U_GNSS_UBX_RXM_RAWX_LOCKTIME(pBlock) U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, LOCKTIME, U2)
+#define U_GNSS_UBX_RXM_RAWX_CNO(pBlock)      U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, CNO, U1)
+#define U_GNSS_UBX_RXM_RAWX_PR_STDEV(pBlock) U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, PR_STDEV, X1)
+#define U_GNSS_UBX_RXM_RAWX_CP_STDEV(pBlock) U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, CP_STDEV, X1)
+#define U_GNSS_UBX_RXM_RAWX_DO_STDEV(pBlock) U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, DO_STDEV, X1)
+#define U_GNSS_UBX_RXM_RAWX_TRK_STAT(pBlock) U_GNSS_UBX_VIEW_GET(pBlock, RXM_RAWX_BLOCK, TRK_STAT, X1)
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-RXM-PMREQ
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-RXM-PMREQ.
+ */
+#define U_GNSS_UBX_RXM_PMREQ_CLASS 0x02
+#define U_GNSS_UBX_RXM_PMREQ_ID    0x41
+
+/** The fields of the 16-byte version of UBX-RXM-PMREQ.
+ */
+#define U_GNSS_UBX_RXM_PMREQ_FIELDS(X, msg) \
+    X(msg, VERSION,        U1, 0)          \
+    X(msg, RESERVED1,      U1, 0)          \
+    X(msg, RESERVED2,      U2, 0)          \
+    X(msg, DURATION,       U4, 0) /* ms. */ \
+    X(msg, FLAGS,          X4, 0)          \
+    X(msg, WAKEUP_SOURCES, X4, 0)
+
+/** The backup bit of the flags field of UBX-RXM-PMREQ.
+ */
+#define U_GNSS_UBX_RXM_PMREQ_FLAGS_BACKUP 0x02
+
+/** The value of the wakeupSources field of UBX-RXM-PMREQ that
+ * selects all wake-up sources (UART RX, EXTINT0, EXTINT1, SPI CS).
+ */
+#define U_GNSS_UBX_RXM_PMREQ_WAKEUP_SOURCES_ALL 0xe4
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-CFG-NAV5
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-CFG-NAV5.
+ */
+#define U_GNSS_UBX_CFG_NAV5_CLASS 0x06
+#define U_GNSS_UBX_CFG_NAV5_ID    0x24
+
+/** The fields of UBX-CFG-NAV5.
+ */
+#define U_GNSS_UBX_CFG_NAV5_FIELDS(X, msg) \
+    X(msg, MASK,                 X2,  0)                \
+    X(msg, DYN_MODEL,            U1,  0)                \
+    X(msg, FIX_MODE,             U1,  0)                \
+    X(msg, FIXED_ALT,            I4, -2) /* m. */       \
+    X(msg, FIXED_ALT_VAR,        U4, -4) /* m^2. */     \
+    X(msg, MIN_ELEV,             I1,  0) /* degrees. */ \
+    X(msg, DR_LIMIT,             U1,  0) /* s. */       \
+    X(msg, P_DOP,                U2, -1)                \
+    X(msg, T_DOP,                U2, -1)                \
+    X(msg, P_ACC,                U2,  0) /* m. */       \
+    X(msg, T_ACC,                U2,  0) /* m. */       \
+    X(msg, STATIC_HOLD_THRESH,   U1,  0) /* cm/s. */    \
+    X(msg, DGNSS_TIMEOUT,        U1,  0) /* s. */       \
+    X(msg, CNO_THRESH_NUM_SVS,   U1,  0)                \
+    X(msg, CNO_THRESH,           U1,  0) /* dBHz. */    \
+    X(msg, RESERVED1,            U2,  0)                \
+    X(msg, STATIC_HOLD_MAX_DIST, U2,  0) /* m. */       \
+    X(msg, UTC_STANDARD,         U1,  0)                \
+    X(msg, RESERVED2,            U1,  0)                \
+    X(msg, RESERVED3,            U4,  0)
+
+/** The bits of the mask field of UBX-CFG-NAV5 that select the
+ * fields to be applied.
+ */
+#define U_GNSS_UBX_CFG_NAV5_MASK_DYN_MODEL    0x0001
+#define U_GNSS_UBX_CFG_NAV5_MASK_FIX_MODE     0x0004
+#define U_GNSS_UBX_CFG_NAV5_MASK_UTC_STANDARD 0x0400
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-CFG-RST
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-CFG-RST.
+ */
+#define U_GNSS_UBX_CFG_RST_CLASS 0x06
+#define U_GNSS_UBX_CFG_RST_ID    0x04
+
+/** The fields of UBX-CFG-RST.
+ */
+#define U_GNSS_UBX_CFG_RST_FIELDS(X, msg) \
+    X(msg, NAV_BBR_MASK, X2, 0) \
+    X(msg, RESET_MODE,   U1, 0) \
+    X(msg, RESERVED1,    U1, 0)
+
+/** Values of the resetMode field of UBX-CFG-RST.
+ */
+#define U_GNSS_UBX_CFG_RST_RESET_MODE_HW_IMMEDIATE 0x00
+#define U_GNSS_UBX_CFG_RST_RESET_MODE_GNSS_STOP    0x08
+#define U_GNSS_UBX_CFG_RST_RESET_MODE_GNSS_START   0x09
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-MON-GNSS
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-MON-GNSS.
+ */
+#define U_GNSS_UBX_MON_GNSS_CLASS 0x0a
+#define U_GNSS_UBX_MON_GNSS_ID    0x28
+
+/** The fields of UBX-MON-GNSS.
+ */
+#define U_GNSS_UBX_MON_GNSS_FIELDS(X, msg) \
+    X(msg, VERSION,      U1, 0) \
+    X(msg, SUPPORTED,    X1, 0) \
+    X(msg, DEFAULT_GNSS, X1, 0) \
+    X(msg, ENABLED,      X1, 0) \
+    X(msg, SIMULTANEOUS, U1, 0) \
+    X(msg, RESERVED1,    U1, 0) \
+    X(msg, RESERVED2,    U2, 0)
+
+/** The Galileo bit of the supported, defaultGnss and enabled fields
+ * of UBX-MON-GNSS.
+ */
+#define U_GNSS_UBX_MON_GNSS_GALILEO 0x08
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-MON-COMMS
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-MON-COMMS.
+ */
+#define U_GNSS_UBX_MON_COMMS_CLASS 0x0a
+#define U_GNSS_UBX_MON_COMMS_ID    0x36
+
+/** The fields of the fixed part of UBX-MON-COMMS; the four protocol
+ * IDs are the protocols that the four message counts of each
+ * per-port block are for.
+ */
+#define U_GNSS_UBX_MON_COMMS_FIELDS(X, msg) \
+    X(msg, VERSION,   U1, 0) \
+    X(msg, N_PORTS,   U1, 0) \
+    X(msg, TX_ERRORS, X1, 0) \
+    X(msg, RESERVED1, U1, 0) \
+    X(msg, PROT_ID0,  U1, 0) \
+    X(msg, PROT_ID1,  U1, 0) \
+    X(msg, PROT_ID2,  U1, 0) \
+    X(msg, PROT_ID3,  U1, 0)
+
+/** The fields of a UBX-MON-COMMS per-port block.
+ */
+#define U_GNSS_UBX_MON_COMMS_BLOCK_FIELDS(X, msg) \
+    X(msg, PORT_ID,         U2, 0)              \
+    X(msg, TX_PENDING,      U2, 0) /* bytes. */ \
+    X(msg, TX_BYTES,        U4, 0)              \
+    X(msg, TX_USAGE,        U1, 0) /* %. */     \
+    X(msg, TX_PEAK_USAGE,   U1, 0) /* %. */     \
+    X(msg, RX_PENDING,      U2, 0) /* bytes. */ \
+    X(msg, RX_BYTES,        U4, 0)              \
+    X(msg, RX_USAGE,        U1, 0) /* %. */     \
+    X(msg, RX_PEAK_USAGE,   U1, 0) /* %. */     \
+    X(msg, OVERRUN_ERRS,    U2, 0)              \
+    X(msg, MSGS0,           U2, 0)              \
+    X(msg, MSGS1,           U2, 0)              \
+    X(msg, MSGS2,           U2, 0)              \
+    X(msg, MSGS3,           U2, 0)              \
+    X(msg, RESERVED1,       U4, 0)              \
+    X(msg, RESERVED2,       U4, 0)              \
+    X(msg, SKIPPED,         U4, 0) /* bytes. */
+
+/** The version of UBX-MON-COMMS that the fields above describe.
+ */
+#define U_GNSS_UBX_MON_COMMS_VERSION 0
+
+/** Return a pointer to the per-port block with index n
+ * (0 to nPorts - 1) of UBX-MON-COMMS.
+ */
+#define U_GNSS_UBX_MON_COMMS_BLOCK(pBody, n) \
+    ((pBody) + U_GNSS_UBX_MON_COMMS_LENGTH_BYTES + ((n) * U_GNSS_UBX_MON_COMMS_BLOCK_LENGTH_BYTES))
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS: UBX-TIM-TP
+ * -------------------------------------------------------------- */
+
+/** The message class and ID of UBX-TIM-TP.
+ */
+#define U_GNSS_UBX_TIM_TP_CLASS 0x0d
+#define U_GNSS_UBX_TIM_TP_ID    0x01
+
+/** The fields of UBX-TIM-TP, which describes the NEXT time pulse.
+ */
+#define U_GNSS_UBX_TIM_TP_FIELDS(X, msg) \
+    X(msg, TOW_MS,     U4, 0) /* ms. */        \
+    X(msg, TOW_SUB_MS, U4, 0) /* 2^-32 ms. */  \
+    X(msg, Q_ERR,      I4, 0) /* ps. */        \
+    X(msg, WEEK,       U2, 0)                  \
+    X(msg, FLAGS,      X1, 0)                  \
+    X(msg, REF_INFO,   X1, 0)
+
+/** Accessors for the fields of UBX-TIM-TP.
+ */
+#define U_GNSS_UBX_TIM_TP_TOW_MS(pBody)     U_GNSS_UBX_VIEW_GET(pBody, TIM_TP, TOW_MS, U4)
+#define U_GNSS_UBX_TIM_TP_TOW_SUB_MS(pBody) U_GNSS_UBX_VIEW_GET(pBody, TIM_TP, TOW_SUB_MS, U4)
+#define U_GNSS_UBX_TIM_TP_Q_ERR(pBody)      U_GNSS_UBX_VIEW_GET(pBody, TIM_TP, Q_ERR, I4)
+#define U_GNSS_UBX_TIM_TP_WEEK(pBody)       U_GNSS_UBX_VIEW_GET(pBody, TIM_TP, WEEK, U2)
+#define U_GNSS_UBX_TIM_TP_FLAGS(pBody)      U_GNSS_UBX_VIEW_GET(pBody, TIM_TP, FLAGS, X1)
+#define U_GNSS_UBX_TIM_TP_REF_INFO(pBody)   U_GNSS_UBX_VIEW_GET(pBody, TIM_TP, REF_INFO, X1)
+
+/** The timeBase bit of the flags field of UBX-TIM-TP: set if the
+ * time is UTC, else it is GNSS time.
+ */
+#define U_GNSS_UBX_TIM_TP_FLAGS_TIME_BASE_UTC 0x01
+
+/** The utc bit of the flags field of UBX-TIM-TP: set if UTC
+ * is available.
+ */
+#define U_GNSS_UBX_TIM_TP_FLAGS_UTC_AVAILABLE 0x02
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The constants of each message, each checked against the length
+ * given in the interface description so that a field list edited by
+ * mistake is caught when this header is first compiled.
+ */
+U_GNSS_UBX_VIEW_DESCRIBE(NAV_PVT, 92);
+U_GNSS_UBX_VIEW_DESCRIBE(NAV_SAT, 8);
+U_GNSS_UBX_VIEW_DESCRIBE(NAV_SAT_BLOCK, 12);
+U_GNSS_UBX_VIEW_DESCRIBE(NAV_TIMEUTC, 20);
+U_GNSS_UBX_VIEW_DESCRIBE(RXM_RAWX, 16);
+U_GNSS_UBX_VIEW_DESCRIBE(RXM_RAWX_BLOCK, 32);
+U_GNSS_UBX_VIEW_DESCRIBE(RXM_PMREQ, 16);
+U_GNSS_UBX_VIEW_DESCRIBE(CFG_NAV5, 36);
+U_GNSS_UBX_VIEW_DESCRIBE(CFG_RST, 4);
+U_GNSS_UBX_VIEW_DESCRIBE(MON_GNSS, 8);
+U_GNSS_UBX_VIEW_DESCRIBE(MON_COMMS, 8);
+U_GNSS_UBX_VIEW_DESCRIBE(MON_COMMS_BLOCK, 40);
+U_GNSS_UBX_VIEW_DESCRIBE(TIM_TP, 16);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_UBX_VIEW_H_
+
+// End of file
@@ -48,6 +48,8 @@
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss.h"
+#include "u_gnss_cfg_val_key.h"
+#include "u_gnss_cfg.h"
 #include "u_gnss_msg.h"
 #include "u_gnss_private.h"
 
@@ -72,7 +74,8 @@ static const char *const gpTransportTypeText[] = {"None",       // U_GNSS_TRANSP
                                                   "AT",         // U_GNSS_TRANSPORT_AT
                                                   "I2C",        // U_GNSS_TRANSPORT_I2C
                                                   "UBX UART",   // U_GNSS_TRANSPORT_UBX_UART
-                                                  "UBX I2C"     // U_GNSS_TRANSPORT_UBX_I2C
+                                                  "UBX I2C",    // U_GNSS_TRANSPORT_UBX_I2C
+                                                  "SPI"         // U_GNSS_TRANSPORT_SPI
                                                  };
 
 /* ----------------------------------------------------------------
@@ -105,6 +108,9 @@ static uGnssPrivateInstance_t *pGetGnssInstanceTransportHandle(uGnssTransportTyp
                 case U_GNSS_TRANSPORT_UBX_I2C:
                     match = (pInstance->transportHandle.i2c == transportHandle.i2c);
                     break;
+                case U_GNSS_TRANSPORT_SPI:
+                    match = (pInstance->transportHandle.spi == transportHandle.spi);
+                    break;
                 default:
                     break;
             }
@@ -117,6 +123,15 @@ static uGnssPrivateInstance_t *pGetGnssInstanceTransportHandle(uGnssTransportTyp
     return pInstance;
 }
 
+// Interrupt handler for the TX-ready pin of the GNSS chip:
+// wake up the message receive task.
+static void dataReadyInterrupt(int32_t pin, void *pParam)
+{
+    (void) pin;
+
+    uPortSemaphoreGiveIrq((uPortSemaphoreHandle_t) pParam);
+}
+
 // Add a GNS instance to the list.
 // gUGnssPrivateMutex should be locked before this is called.
 // Note: doesn't copy it, just adds it.
@@ -124,47 +139,89 @@ static void addGnssInstance(uGnssPrivateInstance_t *pInstance)
 {
     pInstance->pNext = gpUGnssPrivateInstanceList;
     gpUGnssPrivateInstanceList = pInstance;
+    // Point the device instance at us for pUGnssPrivateGetInstance()
+    U_DEVICE_INSTANCE(pInstance->gnssHandle)->pDriverInstance = pInstance;
 }
 
 // Remove a GNSS instance from the list.
 // gUGnssPrivateMutex should be locked before this is called.
-static void deleteGnssInstance(uGnssPrivateInstance_t *pInstance)
+// Note: doesn't free it, deleteGnssInstance() does that.
+static void removeGnssInstance(const uGnssPrivateInstance_t *pInstance)
 {
     uGnssPrivateInstance_t *pCurrent;
     uGnssPrivateInstance_t *pPrev = NULL;
+    uDeviceInstance_t *pDevInstance;
 
     pCurrent = gpUGnssPrivateInstanceList;
     while (pCurrent != NULL) {
         if (pInstance == pCurrent) {
-            // Stop any asynchronous position establishment task
-            uGnssPrivateCleanUpPosTask(pInstance);
-            // Stop asynchronus message receive from happening
-            uGnssPrivateStopMsgReceive(pInstance);
-            if (pInstance->pLinearBuffer != NULL) {
-                // Free the streaming buffer
-                uRingBufferDelete(&(pInstance->ringBuffer));
-                free(pInstance->pLinearBuffer);
-            }
-            // This can go now too (it is legal C to free a NULL pointer)
-            free(pInstance->pTemporaryBuffer);
-            // Delete the transport mutex
-            uPortMutexDelete(pInstance->transportMutex);
-            // Deallocate the uDevice instance
-            uDeviceDestroyInstance(U_DEVICE_INSTANCE(pInstance->gnssHandle));
-            // Unlink the instance from the list
             if (pPrev != NULL) {
                 pPrev->pNext = pCurrent->pNext;
             } else {
                 gpUGnssPrivateInstanceList = pCurrent->pNext;
             }
             pCurrent = NULL;
-            // Free the instance
-            free(pInstance);
         } else {
             pPrev = pCurrent;
             pCurrent = pPrev->pNext;
         }
     }
+
+    // The device instance lives on until deleteGnssInstance()
+    // but must no longer find us
+    pDevInstance = U_DEVICE_INSTANCE(pInstance->gnssHandle);
+    if (pDevInstance != NULL) {
+        pDevInstance->pDriverInstance = NULL;
+    }
+}
+
+// Free a GNSS instance and everything hanging off it; the instance
+// must have been removed from the list and must not be in use,
+// see uGnssPrivateInstanceWaitUnused().
+static void deleteGnssInstance(uGnssPrivateInstance_t *pInstance)
+{
+    // Stop any asynchronous position establishment task
+    uGnssPrivateCleanUpPosTask(pInstance);
+    // Stop any logging, which may be using message receive
+    uGnssPrivateLogStop(pInstance);
+    // Stop asynchronus message receive from happening
+    uGnssPrivateStopMsgReceive(pInstance);
+    // That also stopped any streamed position, just the
+    // memory to free (it is legal C to free a NULL pointer)
+    free(pInstance->pStreamedPosition);
+    free(pInstance->pCfgShadow);
+    free(pInstance->pHotStartContext);
+    if (pInstance->pTimeSync != NULL) {
+        uPortGpioInterruptSet(pInstance->pTimeSync->pinTimepulse, true, NULL, NULL);
+        free(pInstance->pTimeSync);
+    }
+    uGnssPrivateIdentityCacheClear(pInstance);
+    // Nothing can be waiting on the data ready semaphore now
+    if (pInstance->pinDataReady >= 0) {
+        uPortGpioInterruptSet(pInstance->pinDataReady, false, NULL, NULL);
+    }
+    if (pInstance->dataReadySemaphore != NULL) {
+        uPortSemaphoreDelete(pInstance->dataReadySemaphore);
+    }
+    if (pInstance->pLinearBuffer != NULL) {
+        // Free the streaming buffer
+        uGnssPrivateFramerDelete(pInstance);
+        uRingBufferDelete(&(pInstance->ringBuffer));
+        if (!pInstance->linearBufferIsUser) {
+            free(pInstance->pLinearBuffer);
+        }
+    }
+    // This can go now too (it is legal C to free a NULL pointer)
+    if (!pInstance->temporaryBufferIsUser) {
+        free(pInstance->pTemporaryBuffer);
+    }
+    // Delete the transport mutex and the instance mutex
+    uPortMutexDelete(pInstance->transportMutex);
+    uPortMutexDelete(pInstance->mutex);
+    // Deallocate the uDevice instance
+    uDeviceDestroyInstance(U_DEVICE_INSTANCE(pInstance->gnssHandle));
+    // Free the instance
+    free(pInstance);
 }
 
 /* ----------------------------------------------------------------
@@ -187,17 +244,24 @@ int32_t uGnssInit()
 // Shut-down the GNSS driver.
 void uGnssDeinit()
 {
-    if (gUGnssPrivateMutex != NULL) {
+    uGnssPrivateInstance_t *pInstance;
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+    if (gUGnssPrivateMutex != NULL) {
 
         // Remove all GNSS instances
-        while (gpUGnssPrivateInstanceList != NULL) {
-            deleteGnssInstance(gpUGnssPrivateInstanceList);
-        }
+        do {
+            U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+            pInstance = gpUGnssPrivateInstanceList;
+            if (pInstance != NULL) {
+                removeGnssInstance(pInstance);
+            }
+            U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+            if (pInstance != NULL) {
+                uGnssPrivateInstanceWaitUnused(pInstance);
+                deleteGnssInstance(pInstance);
+            }
+        } while (pInstance != NULL);
 
-        // Unlock the mutex so that we can delete it
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
         uPortMutexDelete(gUGnssPrivateMutex);
         gUGnssPrivateMutex = NULL;
     }
@@ -212,17 +276,45 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                  int32_t pinGnssEnablePower,
                  bool leavePowerAlone,
                  uDeviceHandle_t *pGnssHandle)
+{
+    return uGnssAddWithBuffers(moduleType, transportType, transportHandle,
+                               pinGnssEnablePower, leavePowerAlone,
+                               NULL, pGnssHandle);
+}
+
+// Add a GNSS instance with the given buffer configuration.
+//lint -esym(1746, transportHandle) Suppress could
+// be made const: it is!
+int32_t uGnssAddWithBuffers(uGnssModuleType_t moduleType,
+                            uGnssTransportType_t transportType,
+                            const uGnssTransportHandle_t transportHandle,
+                            int32_t pinGnssEnablePower,
+                            bool leavePowerAlone,
+                            const uGnssBufferCfg_t *pBufferCfg,
+                            uDeviceHandle_t *pGnssHandle)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance = NULL;
     uPortGpioConfig_t gpioConfig;
     int32_t platformError = 0;
+    size_t ringBufferLengthBytes = U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES;
+    size_t temporaryBufferLengthBytes = U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES;
     int32_t pinGnssEnablePowerOnState = (pinGnssEnablePower & U_GNSS_PIN_INVERTED) ?
                                         !U_GNSS_PIN_ENABLE_POWER_ON_STATE : U_GNSS_PIN_ENABLE_POWER_ON_STATE;
     uPortGpioDriveMode_t pinGnssEnablePowerDriveMode;
 
     pinGnssEnablePower &= ~U_GNSS_PIN_INVERTED;
 
+    if (pBufferCfg != NULL) {
+        if (pBufferCfg->ringBufferLengthBytes > 0) {
+            ringBufferLengthBytes = pBufferCfg->ringBufferLengthBytes;
+            temporaryBufferLengthBytes = ringBufferLengthBytes / 8;
+        }
+        if (pBufferCfg->temporaryBufferLengthBytes > 0) {
+            temporaryBufferLengthBytes = pBufferCfg->temporaryBufferLengthBytes;
+        }
+    }
+
 #ifdef U_GNSS_PIN_ENABLE_POWER_DRIVE_MODE
     // User override
     pinGnssEnablePowerDriveMode = U_GNSS_PIN_ENABLE_POWER_DRIVE_MODE;
@@ -253,6 +345,8 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
             // Check parameters
             errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
             if (((size_t) moduleType < gUGnssPrivateModuleListSize) &&
+                (temporaryBufferLengthBytes > 0) &&
+                (temporaryBufferLengthBytes + 1 < ringBufferLengthBytes) &&
                 ((transportType > U_GNSS_TRANSPORT_NONE) &&
                  (transportType < U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX)) &&
                 ((transportType == U_GNSS_TRANSPORT_I2C) ||
@@ -266,13 +360,19 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                     memset(pInstance, 0, sizeof(*pInstance));
                     pInstance->pinGnssEnablePowerOnState = pinGnssEnablePowerOnState;
                     // Create a transport mutex
-                    pInstance->gnssHandle = (uDeviceHandle_t)pDevInstance;
+                    pInstance->gnssHandle = U_DEVICE_HANDLE(pDevInstance);
                     pInstance->transportMutex = NULL;
                     errorCode = uPortMutexCreate(&pInstance->transportMutex);
+                    if (errorCode == 0) {
+                        // ...and the mutex that serialises API calls
+                        errorCode = uPortMutexCreate(&pInstance->mutex);
+                    }
                     if (errorCode == 0) {
                         pInstance->transportType = transportType;
                         pInstance->pLinearBuffer = NULL;
+                        pInstance->ringBufferLengthBytes = ringBufferLengthBytes;
                         pInstance->pTemporaryBuffer = NULL;
+                        pInstance->temporaryBufferLengthBytes = temporaryBufferLengthBytes;
                         pInstance->ringBufferReadHandlePrivate = -1;
                         pInstance->ringBufferReadHandleMsgReceive = -1;
                         pInstance->pModule = &(gUGnssPrivateModuleList[moduleType]);
@@ -283,10 +383,13 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                         pInstance->pinGnssEnablePower = pinGnssEnablePower;
                         pInstance->atModulePinPwr = -1;
                         pInstance->atModulePinDataReady = -1;
+                        pInstance->pinDataReady = -1;
                         pInstance->portNumber = U_GNSS_PORT_I2C;
                         if ((transportType == U_GNSS_TRANSPORT_UART) ||
                             (transportType == U_GNSS_TRANSPORT_UBX_UART)) {
                             pInstance->portNumber = U_GNSS_PORT_UART;
+                        } else if (transportType == U_GNSS_TRANSPORT_SPI) {
+                            pInstance->portNumber = U_GNSS_PORT_SPI;
                         }
 #if defined(_WIN32) || (defined(__ZEPHYR__) && defined(CONFIG_UART_NATIVE_POSIX))
                         // For Windows and Linux the GNSS-side connection is assumed to be USB
@@ -348,18 +451,29 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                             // Provided we're not on AT transport, i.e. we're on
                             // a streaming transport, then set up the buffer into
                             // which we stream messages received from the module
-                            pInstance->pLinearBuffer = (char *) malloc(U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES);
+                            if ((pBufferCfg != NULL) && (pBufferCfg->pRingBuffer != NULL)) {
+                                pInstance->pLinearBuffer = pBufferCfg->pRingBuffer;
+                                pInstance->linearBufferIsUser = true;
+                            } else {
+                                pInstance->pLinearBuffer = (char *) malloc(ringBufferLengthBytes);
+                            }
                             if (pInstance->pLinearBuffer != NULL) {
                                 // Also need a temporary buffer to get stuff out
                                 // of the UART/I2C in the first place
-                                pInstance->pTemporaryBuffer = (char *) malloc(U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
+                                if ((pBufferCfg != NULL) && (pBufferCfg->pTemporaryBuffer != NULL)) {
+                                    pInstance->pTemporaryBuffer = pBufferCfg->pTemporaryBuffer;
+                                    pInstance->temporaryBufferIsUser = true;
+                                } else {
+                                    pInstance->pTemporaryBuffer = (char *) malloc(temporaryBufferLengthBytes);
+                                }
                                 if (pInstance->pTemporaryBuffer != NULL) {
-                                    // +2 below to keep one for ourselves and one for the
-                                    // blocking transparent receive function
+                                    // +3 below to keep one for ourselves, one for the
+                                    // blocking transparent receive function and one
+                                    // for the framer
                                     errorCode = uRingBufferCreateWithReadHandle(&(pInstance->ringBuffer),
                                                                                 pInstance->pLinearBuffer,
-                                                                                U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES,
-                                                                                U_GNSS_MSG_RECEIVER_MAX_NUM + 2);
+                                                                                ringBufferLengthBytes,
+                                                                                U_GNSS_MSG_RECEIVER_MAX_NUM + 3);
                                     if (errorCode == 0) {
                                         // No sneaky uRingBufferRead()'s allowed
                                         uRingBufferSetReadRequiresHandle(&(pInstance->ringBuffer), true);
@@ -371,6 +485,10 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                                             errorCode = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
                                             if (errorCode >= 0) {
                                                 pInstance->ringBufferReadHandleMsgReceive = errorCode;
+                                                // Frame messages once as they arrive; if
+                                                // this fails each reader simply parses
+                                                // the ring buffer for itself
+                                                uGnssPrivateFramerCreate(pInstance);
                                                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                                             } else {
                                                 uRingBufferDelete(&(pInstance->ringBuffer));
@@ -392,15 +510,22 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                     if ((errorCode != 0) || (platformError != 0)) {
                         // If we hit an error, free memory again
                         if (pInstance->pLinearBuffer != NULL) {
+                            uGnssPrivateFramerDelete(pInstance);
                             uRingBufferDelete(&(pInstance->ringBuffer));
-                            free(pInstance->pLinearBuffer);
+                            if (!pInstance->linearBufferIsUser) {
+                                free(pInstance->pLinearBuffer);
+                            }
                         }
-                        if (pInstance->pTemporaryBuffer != NULL) {
+                        if ((pInstance->pTemporaryBuffer != NULL) &&
+                            !pInstance->temporaryBufferIsUser) {
                             free(pInstance->pTemporaryBuffer);
                         }
                         if (pInstance->transportMutex != NULL) {
                             uPortMutexDelete(pInstance->transportMutex);
                         }
+                        if (pInstance->mutex != NULL) {
+                            uPortMutexDelete(pInstance->mutex);
+                        }
                         free(pInstance);
                     }
                 }
@@ -426,16 +551,15 @@ int32_t uGnssSetI2cAddress(uDeviceHandle_t gnssHandle, int32_t i2cAddress)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (i2cAddress > 0)) {
             pInstance->i2cAddress = i2cAddress;
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -449,15 +573,14 @@ int32_t uGnssGetI2cAddress(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrI2cAddress = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             errorCodeOrI2cAddress = pInstance->i2cAddress;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrI2cAddress;
@@ -466,7 +589,7 @@ int32_t uGnssGetI2cAddress(uDeviceHandle_t gnssHandle)
 // Remove a GNSS instance.
 void uGnssRemove(uDeviceHandle_t gnssHandle)
 {
-    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateInstance_t *pInstance = NULL;
 
     if (gUGnssPrivateMutex != NULL) {
 
@@ -474,10 +597,17 @@ void uGnssRemove(uDeviceHandle_t gnssHandle)
 
         pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
-            deleteGnssInstance(pInstance);
+            removeGnssInstance(pInstance);
         }
 
         U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+
+        if (pInstance != NULL) {
+            // Now that it is out of the list, wait for any API
+            // call on the instance to finish before freeing it
+            uGnssPrivateInstanceWaitUnused(pInstance);
+            deleteGnssInstance(pInstance);
+        }
     }
 }
 
@@ -492,10 +622,9 @@ int32_t uGnssGetTransportHandle(uDeviceHandle_t gnssHandle,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             if (pTransportType != NULL) {
                 *pTransportType = pInstance->transportType;
@@ -506,7 +635,7 @@ int32_t uGnssGetTransportHandle(uDeviceHandle_t gnssHandle,
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -520,14 +649,13 @@ void uGnssSetAtPinPwr(uDeviceHandle_t gnssHandle, int32_t pin)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             pInstance->atModulePinPwr = pin;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 }
 
@@ -538,17 +666,112 @@ void uGnssSetAtPinDataReady(uDeviceHandle_t gnssHandle, int32_t pin)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             pInstance->atModulePinDataReady = pin;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 }
 
+// Set the MCU pin that is connected to the TX-ready pin of the GNSS chip.
+int32_t uGnssSetPinDataReady(uDeviceHandle_t gnssHandle, int32_t pinMcu,
+                             int32_t pinGnss)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uPortSemaphoreHandle_t semaphore = NULL;
+    int32_t pinMcuPrevious = -1;
+    int32_t streamType;
+    uPortGpioConfig_t gpioConfig;
+    uGnssCfgVal_t cfgVal[] = {{U_GNSS_CFG_VAL_KEY_ID_TXREADY_ENABLED_L, 0},
+        {U_GNSS_CFG_VAL_KEY_ID_TXREADY_POLARITY_L, 0}, // Active high
+        {U_GNSS_CFG_VAL_KEY_ID_TXREADY_PIN_U1, 0},
+        {U_GNSS_CFG_VAL_KEY_ID_TXREADY_THRESHOLD_U2, U_GNSS_DATA_READY_THRESHOLD_BYTES / 8},
+        {U_GNSS_CFG_VAL_KEY_ID_TXREADY_INTERFACE_E1, U_GNSS_CFG_VAL_KEY_ITEM_VALUE_TXREADY_INTERFACE_I2C}
+    };
+    size_t numValues = 1;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && ((pinMcu < 0) || (pinGnss >= 0))) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            streamType = uGnssPrivateGetStreamType(pInstance->transportType);
+            if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX) &&
+                ((streamType == U_GNSS_PRIVATE_STREAM_TYPE_I2C) ||
+                 (streamType == U_GNSS_PRIVATE_STREAM_TYPE_SPI))) {
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                if (streamType == U_GNSS_PRIVATE_STREAM_TYPE_SPI) {
+                    cfgVal[4].value = U_GNSS_CFG_VAL_KEY_ITEM_VALUE_TXREADY_INTERFACE_SPI;
+                }
+                // Stop using any existing pin: the message receive
+                // task will go back to polling until we're done
+                pinMcuPrevious = pInstance->pinDataReady;
+                pInstance->pinDataReady = -1;
+                if ((pinMcu >= 0) && (pInstance->dataReadySemaphore == NULL)) {
+                    // The semaphore, once created, stays until the
+                    // instance is removed so that the message receive
+                    // task can never be left waiting on a deleted one
+                    errorCode = uPortSemaphoreCreate(&(pInstance->dataReadySemaphore), 0, 1);
+                }
+                semaphore = pInstance->dataReadySemaphore;
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+        if (errorCode == 0) {
+            if (pinMcuPrevious >= 0) {
+                uPortGpioInterruptSet(pinMcuPrevious, false, NULL, NULL);
+            }
+            if (semaphore != NULL) {
+                // Kick the message receive task in case it is waiting
+                uPortSemaphoreGive(semaphore);
+            }
+            if (pinMcu >= 0) {
+                cfgVal[0].value = 1;
+                cfgVal[2].value = (uint64_t) pinGnss;
+                numValues = sizeof(cfgVal) / sizeof(cfgVal[0]);
+                U_PORT_GPIO_SET_DEFAULT(&gpioConfig);
+                gpioConfig.pin = pinMcu;
+                gpioConfig.direction = U_PORT_GPIO_DIRECTION_INPUT;
+                gpioConfig.pullMode = U_PORT_GPIO_PULL_MODE_PULL_DOWN;
+                errorCode = uPortGpioConfig(&gpioConfig);
+                if (errorCode == 0) {
+                    errorCode = uPortGpioInterruptSet(pinMcu, true,
+                                                      dataReadyInterrupt,
+                                                      semaphore);
+                }
+            }
+            if (errorCode == 0) {
+                errorCode = uGnssCfgValSetList(gnssHandle, cfgVal, numValues,
+                                               U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                                               U_GNSS_CFG_VAL_LAYER_RAM);
+            }
+            if (pinMcu >= 0) {
+                if (errorCode == 0) {
+                    U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+                    if (pInstance != NULL) {
+                        pInstance->pinDataReady = pinMcu;
+                    }
+
+                    U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+                } else {
+                    uPortGpioInterruptSet(pinMcu, true, NULL, NULL);
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 // Get the maximum time to wait for a response from the GNSS chip.
 int32_t uGnssGetTimeout(uDeviceHandle_t gnssHandle)
 {
@@ -557,15 +780,14 @@ int32_t uGnssGetTimeout(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrTimeout = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             errorCodeOrTimeout = pInstance->timeoutMs;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrTimeout;
@@ -578,14 +800,13 @@ void uGnssSetTimeout(uDeviceHandle_t gnssHandle, int32_t timeoutMs)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             pInstance->timeoutMs = timeoutMs;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 }
 
@@ -597,14 +818,13 @@ bool uGnssGetUbxMessagePrint(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             isOn = pInstance->printUbxMessages;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isOn;
@@ -617,14 +837,13 @@ void uGnssSetUbxMessagePrint(uDeviceHandle_t gnssHandle, bool onNotOff)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             pInstance->printUbxMessages = onNotOff;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 }
 
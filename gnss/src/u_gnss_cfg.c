@@ -48,6 +48,7 @@
 #include "u_gnss_private.h"
 #include "u_gnss_msg.h" // uGnssMsgReceiveStatStreamLoss()
 #include "u_gnss_private.h"
+#include "u_gnss_ubx_view.h"
 #include "u_gnss_cfg_val_key.h"
 #include "u_gnss_cfg.h"
 
@@ -60,6 +61,14 @@
  */
 #define U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES 64
 
+#ifndef U_GNSS_CFG_VAL_SET_MAX_BODY_LENGTH_BYTES
+/** The maximum length of the body of a UBX-CFG-VALSET message
+ * sent by uGnssCfgValSetListBatch(): #U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES
+ * values of the largest size, plus the header, will fit.
+ */
+# define U_GNSS_CFG_VAL_SET_MAX_BODY_LENGTH_BYTES (4 + (U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES * (4 + 8)))
+#endif
+
 #ifndef U_GNSS_CFG_MAX_NUM_VAL_GET_SEGMENTS
 /** The maximum number of a VALGET message segments, each containing
  * U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES, that we can handle.
@@ -84,6 +93,125 @@ typedef struct {
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: CONFIGURATION SHADOW
+ * -------------------------------------------------------------- */
+
+// Find a key ID in the configuration shadow, returning NULL if
+// it is not there.
+// Note: the instance should be locked before this is called.
+static uGnssPrivateCfgShadowItem_t *pShadowFind(uGnssPrivateCfgShadow_t *pShadow,
+                                                uint32_t keyId)
+{
+    uGnssPrivateCfgShadowItem_t *pItem = NULL;
+
+    for (size_t x = 0; (x < pShadow->numItems) && (pItem == NULL); x++) {
+        if (pShadow->item[x].keyId == keyId) {
+            pItem = &(pShadow->item[x]);
+        }
+    }
+
+    return pItem;
+}
+
+// Put the value of a key ID in the configuration shadow, if there
+// is one, overwriting the oldest entry if it is full.
+// Note: the instance should be locked before this is called.
+static void shadowStore(const uGnssPrivateInstance_t *pInstance,
+                        uint32_t keyId, uint64_t value)
+{
+    uGnssPrivateCfgShadow_t *pShadow = pInstance->pCfgShadow;
+    uGnssPrivateCfgShadowItem_t *pItem;
+
+    if (pShadow != NULL) {
+        pItem = pShadowFind(pShadow, keyId);
+        if (pItem == NULL) {
+            if (pShadow->numItems < sizeof(pShadow->item) / sizeof(pShadow->item[0])) {
+                pItem = &(pShadow->item[pShadow->numItems]);
+                pShadow->numItems++;
+            } else {
+                pItem = &(pShadow->item[pShadow->nextItem]);
+                pShadow->nextItem++;
+                if (pShadow->nextItem >= sizeof(pShadow->item) / sizeof(pShadow->item[0])) {
+                    pShadow->nextItem = 0;
+                }
+            }
+            pItem->keyId = keyId;
+        }
+        pItem->value = value;
+    }
+}
+
+// Remove a key ID from the configuration shadow, if there is one.
+// Note: the instance should be locked before this is called.
+static void shadowRemove(const uGnssPrivateInstance_t *pInstance, uint32_t keyId)
+{
+    uGnssPrivateCfgShadow_t *pShadow = pInstance->pCfgShadow;
+    uGnssPrivateCfgShadowItem_t *pItem;
+
+    if (pShadow != NULL) {
+        pItem = pShadowFind(pShadow, keyId);
+        if (pItem != NULL) {
+            // Move the last entry into the gap
+            pShadow->numItems--;
+            *pItem = pShadow->item[pShadow->numItems];
+            if (pShadow->nextItem >= pShadow->numItems) {
+                pShadow->nextItem = 0;
+            }
+        }
+    }
+}
+
+// Update the configuration shadow, if there is one, after a
+// successful VALSET: a value set outside a transaction is now
+// known, one set inside a transaction is not known until the
+// transaction is executed so it is forgotten.  Either way a
+// VALSET may change what UBX-CFG-NAV5 would return.
+// Note: the instance should be locked before this is called.
+static void shadowValSet(const uGnssPrivateInstance_t *pInstance,
+                         const uGnssCfgVal_t *pList, size_t numValues,
+                         bool known, uint32_t layers)
+{
+    if ((pInstance->pCfgShadow != NULL) &&
+        ((layers & U_GNSS_CFG_VAL_LAYER_RAM) != 0)) {
+        pInstance->pCfgShadow->nav5Valid = false;
+        for (size_t x = 0; x < numValues; x++, pList++) {
+            if (known) {
+                shadowStore(pInstance, pList->keyId, pList->value);
+            } else {
+                shadowRemove(pInstance, pList->keyId);
+            }
+        }
+    }
+}
+
+// Get a value from the configuration shadow, returning true if it
+// was there.
+static bool shadowGet(uDeviceHandle_t gnssHandle, uint32_t keyId,
+                      uint64_t *pValue)
+{
+    bool found = false;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateCfgShadowItem_t *pItem;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if ((pInstance != NULL) && (pInstance->pCfgShadow != NULL)) {
+            pItem = pShadowFind(pInstance->pCfgShadow, keyId);
+            if (pItem != NULL) {
+                *pValue = pItem->value;
+                found = true;
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return found;
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: OLDE WORLDE
  * -------------------------------------------------------------- */
@@ -98,23 +226,35 @@ static int32_t getUbxCfgNav5(uDeviceHandle_t gnssHandle,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
-            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
-            // Poll with the message class and ID of the
-            // UBX-CFG-NAV5 message
-            if (uGnssPrivateSendReceiveUbxMessage(pInstance,
-                                                  0x06, 0x24,
-                                                  NULL, 0,
-                                                  pBuffer, 36) == 36) {
+            if ((pInstance->pCfgShadow != NULL) && pInstance->pCfgShadow->nav5Valid) {
+                // Already know the answer
+                memcpy(pBuffer, pInstance->pCfgShadow->nav5, sizeof(pInstance->pCfgShadow->nav5));
                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            } else {
+                errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+                // Poll with the message class and ID of the
+                // UBX-CFG-NAV5 message
+                if (uGnssPrivateSendReceiveUbxMessage(pInstance,
+                                                      U_GNSS_UBX_CFG_NAV5_CLASS,
+                                                      U_GNSS_UBX_CFG_NAV5_ID,
+                                                      NULL, 0, pBuffer,
+                                                      U_GNSS_UBX_CFG_NAV5_LENGTH_BYTES) ==
+                    U_GNSS_UBX_CFG_NAV5_LENGTH_BYTES) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    if (pInstance->pCfgShadow != NULL) {
+                        memcpy(pInstance->pCfgShadow->nav5, pBuffer,
+                               sizeof(pInstance->pCfgShadow->nav5));
+                        pInstance->pCfgShadow->nav5Valid = true;
+                    }
+                }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -130,14 +270,13 @@ static int32_t setUbxCfgNav5(uDeviceHandle_t gnssHandle,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
     // Enough room for the body of the UBX-CFG-NAV5 message
-    char message[36] = {0};
+    char message[U_GNSS_UBX_CFG_NAV5_LENGTH_BYTES] = {0};
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             // Set the mask bytes at the start of the message
             *((uint16_t *) message) = uUbxProtocolUint16Encode(mask);
@@ -146,12 +285,16 @@ static int32_t setUbxCfgNav5(uDeviceHandle_t gnssHandle,
             memcpy(message + offset, pBuffer, size);
             // Send the UBX-CFG-NAV5 message
             errorCode = uGnssPrivateSendUbxMessage(pInstance,
-                                                   0x06, 0x24,
+                                                   U_GNSS_UBX_CFG_NAV5_CLASS,
+                                                   U_GNSS_UBX_CFG_NAV5_ID,
                                                    message,
                                                    sizeof(message));
+            // This may change any of the CFG-NAVSPG items as
+            // well as UBX-CFG-NAV5 so forget the lot
+            uGnssPrivateCfgShadowClear(pInstance);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -380,10 +523,9 @@ static int32_t valGetListAlloc(uDeviceHandle_t gnssHandle,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (pKeyIdList != NULL) && (numKeyIds > 0) &&
             (pList != NULL) && (encodedLayer >= 0)) {
             errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
@@ -425,6 +567,11 @@ static int32_t valGetListAlloc(uDeviceHandle_t gnssHandle,
                     // an error code
                     if (messageInCount > 0) {
                         errorCodeOrCount = unpackMessageAlloc(messageIn, messageInCount, pList);
+                        if (layer == U_GNSS_CFG_VAL_LAYER_RAM) {
+                            for (int32_t x = 0; x < errorCodeOrCount; x++) {
+                                shadowStore(pInstance, (*pList + x)->keyId, (*pList + x)->value);
+                            }
+                        }
                         // Free the memory that was allocated by the send/receive calls
                         for (size_t x = 0; x < messageInCount; x++) {
                             free(messageIn[x].pBody);
@@ -437,12 +584,47 @@ static int32_t valGetListAlloc(uDeviceHandle_t gnssHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrCount;
 }
 
+// Work out the size of the body of a VALSET message carrying
+// numValues items from pList.
+static size_t valSetMessageSize(const uGnssCfgVal_t *pList, size_t numValues)
+{
+    size_t messageSize = 4 + (4 * numValues);
+
+    // We already have the overhead and the amount per key ID,
+    // need to add the amount per value
+    for (size_t x = 0; x < numValues; x++) {
+        messageSize += getStorageSizeBytes(U_GNSS_CFG_VAL_KEY_GET_SIZE((pList + x)->keyId));
+    }
+
+    return messageSize;
+}
+
+// Assemble a VALSET message in pMessage, which must be of size
+// messageSize as returned by valSetMessageSize(), and send it.
+// Note: the instance should be locked before this is called.
+static int32_t valSetMessageSend(uGnssPrivateInstance_t *pInstance,
+                                 const uGnssCfgVal_t *pList, size_t numValues,
+                                 uGnssCfgValTransaction_t transaction,
+                                 int32_t layers, char *pMessage,
+                                 size_t messageSize)
+{
+    *pMessage       = 0; // Version
+    *(pMessage + 1) = (char) layers;
+    *(pMessage + 2) = (char) transaction;
+    *(pMessage + 3) = 0; // Reserved
+    // Add the values
+    packMessage(pList, numValues, pMessage + 4, messageSize - 4);
+    // Send them all off
+    return uGnssPrivateSendUbxMessage(pInstance, 0x06, 0x8a,
+                                      pMessage, messageSize);
+}
+
 // Set a list of configuration items using VALSET.
 static int32_t valSetList(uDeviceHandle_t gnssHandle,
                           const uGnssCfgVal_t *pList, size_t numValues,
@@ -452,14 +634,13 @@ static int32_t valSetList(uDeviceHandle_t gnssHandle,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
     char *pMessage = NULL;
-    size_t messageSize = 4 + (4 * numValues);
+    size_t messageSize;
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) &&
             ((pList != NULL) || (numValues == 0)) &&
             (numValues <= U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES) &&
@@ -468,32 +649,114 @@ static int32_t valSetList(uDeviceHandle_t gnssHandle,
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
                 errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-                // Work out how much memory we need for the message;
-                // we already have the overhead and the amount per key ID,
-                // need to add the amount per value
-                for (size_t x = 0; x < numValues; x++) {
-                    messageSize += getStorageSizeBytes(U_GNSS_CFG_VAL_KEY_GET_SIZE((pList + x)->keyId));
-                }
                 // Get memory for the body of the UBX-CFG-VALSET message
+                messageSize = valSetMessageSize(pList, numValues);
                 pMessage = (char *) malloc(messageSize);
                 if (pMessage != NULL) {
-                    // Assemble the message
-                    *pMessage       = 0; // Version
-                    *(pMessage + 1) = layers;
-                    *(pMessage + 2) = transaction;
-                    *(pMessage + 3) = 0; // Reserved
-                    // Add the values
-                    packMessage(pList, numValues, pMessage + 4, messageSize - 4);
-                    // Send them all off
-                    errorCode = uGnssPrivateSendUbxMessage(pInstance, 0x06, 0x8a,
-                                                           pMessage, messageSize);
+                    errorCode = valSetMessageSend(pInstance, pList, numValues,
+                                                  transaction, layers,
+                                                  pMessage, messageSize);
+                    if (errorCode == 0) {
+                        shadowValSet(pInstance, pList, numValues,
+                                     transaction == U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                                     layers);
+                    }
                     // Free memory
                     free(pMessage);
                 }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Set an arbitrarily long list of configuration items using as
+// few VALSET messages as possible, applying them in one transaction.
+static int32_t valSetListBatch(uDeviceHandle_t gnssHandle,
+                               const uGnssCfgVal_t *pList, size_t numValues,
+                               int32_t layers)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssCfgValTransaction_t transaction;
+    char *pMessage = NULL;
+    size_t messageSize;
+    size_t itemSize;
+    size_t numValuesThisMessage;
+    size_t numValuesSent = 0;
+    const uGnssCfgVal_t *pItem;
+    bool fits;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pList != NULL) && (numValues > 0) &&
+            (layers > 0) && ((layers & ~U_GNSS_CFG_VAL_LAYER_DEFAULT) == 0)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                // Get memory for the body of the largest UBX-CFG-VALSET
+                // message we will send, which is re-used for each one
+                pMessage = (char *) malloc(U_GNSS_CFG_VAL_SET_MAX_BODY_LENGTH_BYTES);
+                if (pMessage != NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    // We hold the instance lock throughout so that no
+                    // other set/del can interleave and cancel the
+                    // transaction; each message is sent as soon as the
+                    // previous one has been acknowledged
+                    while ((numValuesSent < numValues) && (errorCode == 0)) {
+                        // Fit as many values as we can into this message
+                        messageSize = 4;
+                        numValuesThisMessage = 0;
+                        fits = true;
+                        while (fits && (numValuesSent + numValuesThisMessage < numValues) &&
+                               (numValuesThisMessage < U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES)) {
+                            pItem = pList + numValuesSent + numValuesThisMessage;
+                            itemSize = 4 + getStorageSizeBytes(U_GNSS_CFG_VAL_KEY_GET_SIZE(pItem->keyId));
+                            fits = (messageSize + itemSize <= U_GNSS_CFG_VAL_SET_MAX_BODY_LENGTH_BYTES);
+                            if (fits) {
+                                messageSize += itemSize;
+                                numValuesThisMessage++;
+                            }
+                        }
+                        // Work out where we are in the transaction: if
+                        // everything fits in one message there is no
+                        // need for a transaction at all
+                        transaction = U_GNSS_CFG_VAL_TRANSACTION_CONTINUE;
+                        if (numValuesSent + numValuesThisMessage >= numValues) {
+                            transaction = U_GNSS_CFG_VAL_TRANSACTION_EXCUTE;
+                            if (numValuesSent == 0) {
+                                transaction = U_GNSS_CFG_VAL_TRANSACTION_NONE;
+                            }
+                        } else if (numValuesSent == 0) {
+                            transaction = U_GNSS_CFG_VAL_TRANSACTION_BEGIN;
+                        }
+                        if (numValuesThisMessage > 0) {
+                            errorCode = valSetMessageSend(pInstance, pList + numValuesSent,
+                                                          numValuesThisMessage, transaction,
+                                                          layers, pMessage, messageSize);
+                            numValuesSent += numValuesThisMessage;
+                        } else {
+                            // U_GNSS_CFG_VAL_SET_MAX_BODY_LENGTH_BYTES is too small
+                            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        }
+                    }
+                    if (errorCode == 0) {
+                        // The transaction has been executed, all is known
+                        shadowValSet(pInstance, pList, numValues, true, layers);
+                    }
+                    // Free memory
+                    free(pMessage);
+                }
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -513,10 +776,9 @@ static int32_t valDelList(uDeviceHandle_t gnssHandle,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) &&
             ((pKeyIdList != NULL) || (numKeyIds == 0)) &&
             (numKeyIds <= U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES) &&
@@ -550,7 +812,7 @@ static int32_t valDelList(uDeviceHandle_t gnssHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -565,12 +827,11 @@ int32_t uGnssCfgGetDynamic(uDeviceHandle_t gnssHandle)
 {
     int32_t errorCodeOrDynamic;
     // Enough room for the body of the UBX-CFG-NAV5 message
-    char message[36];
+    char message[U_GNSS_UBX_CFG_NAV5_LENGTH_BYTES];
 
     errorCodeOrDynamic = getUbxCfgNav5(gnssHandle, message);
     if (errorCodeOrDynamic == 0) {
-        // The dynamic platform model is at offset 2
-        errorCodeOrDynamic = message[2];
+        errorCodeOrDynamic = (int32_t) U_GNSS_UBX_VIEW_GET(message, CFG_NAV5, DYN_MODEL, U1);
     }
 
     return errorCodeOrDynamic;
@@ -580,9 +841,9 @@ int32_t uGnssCfgGetDynamic(uDeviceHandle_t gnssHandle)
 int32_t uGnssCfgSetDynamic(uDeviceHandle_t gnssHandle, uGnssDynamic_t dynamic)
 {
     return setUbxCfgNav5(gnssHandle,
-                         0x01, /* Mask for dynamic model */
-                         (char *) &dynamic,
-                         1, 2 /* One byte at offset 2 */);
+                         U_GNSS_UBX_CFG_NAV5_MASK_DYN_MODEL,
+                         (char *) &dynamic, 1,
+                         U_GNSS_UBX_CFG_NAV5_OFFSET_DYN_MODEL);
 }
 
 // Get the fix mode from the GNSS chip.
@@ -590,12 +851,11 @@ int32_t uGnssCfgGetFixMode(uDeviceHandle_t gnssHandle)
 {
     int32_t errorCodeOrFixMode;
     // Enough room for the body of the UBX-CFG-NAV5 message
-    char message[36];
+    char message[U_GNSS_UBX_CFG_NAV5_LENGTH_BYTES];
 
     errorCodeOrFixMode = getUbxCfgNav5(gnssHandle, message);
     if (errorCodeOrFixMode == 0) {
-        // The fix mode is at offset 3
-        errorCodeOrFixMode = message[3];
+        errorCodeOrFixMode = (int32_t) U_GNSS_UBX_VIEW_GET(message, CFG_NAV5, FIX_MODE, U1);
     }
 
     return errorCodeOrFixMode;
@@ -605,9 +865,9 @@ int32_t uGnssCfgGetFixMode(uDeviceHandle_t gnssHandle)
 int32_t uGnssCfgSetFixMode(uDeviceHandle_t gnssHandle, uGnssFixMode_t fixMode)
 {
     return setUbxCfgNav5(gnssHandle,
-                         0x04, /* Mask for fix mode */
-                         (char *) &fixMode,
-                         1, 3 /* One byte at offset 3 */);
+                         U_GNSS_UBX_CFG_NAV5_MASK_FIX_MODE,
+                         (char *) &fixMode, 1,
+                         U_GNSS_UBX_CFG_NAV5_OFFSET_FIX_MODE);
 }
 
 // Get the UTC standard from the GNSS chip.
@@ -615,12 +875,11 @@ int32_t uGnssCfgGetUtcStandard(uDeviceHandle_t gnssHandle)
 {
     int32_t errorCodeOrUtcStandard;
     // Enough room for the body of the UBX-CFG-NAV5 message
-    char message[36];
+    char message[U_GNSS_UBX_CFG_NAV5_LENGTH_BYTES];
 
     errorCodeOrUtcStandard = getUbxCfgNav5(gnssHandle, message);
     if (errorCodeOrUtcStandard == 0) {
-        // The UTC standard is at offset 30
-        errorCodeOrUtcStandard = message[30];
+        errorCodeOrUtcStandard = (int32_t) U_GNSS_UBX_VIEW_GET(message, CFG_NAV5, UTC_STANDARD, U1);
     }
 
     return errorCodeOrUtcStandard;
@@ -631,9 +890,9 @@ int32_t uGnssCfgSetUtcStandard(uDeviceHandle_t gnssHandle,
                                uGnssUtcStandard_t utcStandard)
 {
     return setUbxCfgNav5(gnssHandle,
-                         0x0400, /* Mask for UTC standard */
-                         (char *) &utcStandard,
-                         1, 30 /* One byte at offset 30 */);
+                         U_GNSS_UBX_CFG_NAV5_MASK_UTC_STANDARD,
+                         (char *) &utcStandard, 1,
+                         U_GNSS_UBX_CFG_NAV5_OFFSET_UTC_STANDARD);
 }
 
 // Get the protocol types output by the GNSS chip.
@@ -644,14 +903,13 @@ int32_t uGnssCfgGetProtocolOut(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             errorCodeOrBitMap = uGnssPrivateGetProtocolOut(pInstance);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrBitMap;
@@ -667,16 +925,15 @@ int32_t uGnssCfgSetProtocolOut(uDeviceHandle_t gnssHandle,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             errorCode = uGnssPrivateSetProtocolOut(pInstance,
                                                    protocol,
                                                    onNotOff);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -694,18 +951,31 @@ int32_t uGnssCfgValGet(uDeviceHandle_t gnssHandle, uint32_t keyId,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     uGnssCfgVal_t *pList = NULL;
     size_t storageSizeBytes;
+    uint64_t shadowValue;
 
     if ((U_GNSS_CFG_VAL_KEY_GET_GROUP_ID(keyId) != U_GNSS_CFG_VAL_KEY_GROUP_ID_ALL) &&
         (U_GNSS_CFG_VAL_KEY_GET_ITEM_ID(keyId) != U_GNSS_CFG_VAL_KEY_ITEM_ID_ALL) &&
         ((pValue != NULL) || (size == 0))) {
-        errorCode = valGetListAlloc(gnssHandle, &keyId, 1, &pList, layer);
-        if (errorCode > 0) {
+        storageSizeBytes = getStorageSizeBytes(U_GNSS_CFG_VAL_KEY_GET_SIZE(keyId));
+        if ((layer == U_GNSS_CFG_VAL_LAYER_RAM) &&
+            shadowGet(gnssHandle, keyId, &shadowValue)) {
+            // Served from the shadow
             errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-            storageSizeBytes = getStorageSizeBytes(U_GNSS_CFG_VAL_KEY_GET_SIZE(keyId));
             if ((pValue == NULL) || (size >= storageSizeBytes)) {
                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                 if (pValue != NULL) {
-                    memcpy(pValue, &(pList->value), storageSizeBytes);
+                    memcpy(pValue, &shadowValue, storageSizeBytes);
+                }
+            }
+        } else {
+            errorCode = valGetListAlloc(gnssHandle, &keyId, 1, &pList, layer);
+            if (errorCode > 0) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                if ((pValue == NULL) || (size >= storageSizeBytes)) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    if (pValue != NULL) {
+                        memcpy(pValue, &(pList->value), storageSizeBytes);
+                    }
                 }
             }
         }
@@ -756,6 +1026,14 @@ int32_t uGnssCfgValSetList(uDeviceHandle_t gnssHandle,
     return valSetList(gnssHandle, pList, numValues, transaction, layers);
 }
 
+// Set the value of any number of configuration items in one transaction.
+int32_t uGnssCfgValSetListBatch(uDeviceHandle_t gnssHandle,
+                                const uGnssCfgVal_t *pList, size_t numValues,
+                                uint32_t layers)
+{
+    return valSetListBatch(gnssHandle, pList, numValues, layers);
+}
+
 // Delete a configuration item.
 int32_t uGnssCfgValDel(uDeviceHandle_t gnssHandle, uint32_t keyId,
                        uGnssCfgValTransaction_t transaction,
@@ -805,4 +1083,90 @@ int32_t uGnssCfgValDelListX(uDeviceHandle_t gnssHandle,
     return errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: CONFIGURATION SHADOW
+ * -------------------------------------------------------------- */
+
+// Switch the configuration shadow on or off.
+int32_t uGnssCfgSetShadow(uDeviceHandle_t gnssHandle, bool onNotOff)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (onNotOff) {
+                if (pInstance->pCfgShadow == NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                    pInstance->pCfgShadow = (uGnssPrivateCfgShadow_t *) malloc(sizeof(uGnssPrivateCfgShadow_t));
+                    if (pInstance->pCfgShadow != NULL) {
+                        memset(pInstance->pCfgShadow, 0, sizeof(*(pInstance->pCfgShadow)));
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    }
+                }
+            } else {
+                free(pInstance->pCfgShadow);
+                pInstance->pCfgShadow = NULL;
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Fill the configuration shadow.
+int32_t uGnssCfgShadowFill(uDeviceHandle_t gnssHandle,
+                           const uint32_t *pKeyIdList, size_t numKeyIds)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssCfgVal_t *pList = NULL;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pInstance->pCfgShadow != NULL)) {
+            errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+        if (errorCodeOrCount == 0) {
+            // Reading the RAM layer is all it takes to fill the shadow
+            errorCodeOrCount = valGetListAlloc(gnssHandle, pKeyIdList, numKeyIds,
+                                               &pList, U_GNSS_CFG_VAL_LAYER_RAM);
+            // Free memory; it is legal C to free a NULL pointer
+            free(pList);
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Empty the configuration shadow.
+void uGnssCfgShadowClear(uDeviceHandle_t gnssHandle)
+{
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if (pInstance != NULL) {
+            uGnssPrivateCfgShadowClear(pInstance);
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+}
+
 // End of file
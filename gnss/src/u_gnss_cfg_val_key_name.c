@@ -0,0 +1,1245 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the GNSS configuration key name look-up.
+ */
+
+/* NOTE TO MAINTAINERS: the tables in the area marked for automatic
+ * update are generated by the u_gnss_cfg_val_key.py Python script,
+ * at the same time as the key ID macros in u_gnss_cfg_val_key.h, and
+ * the hash function used to generate them must match hash() below;
+ * do NOT edit that area by hand.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strcmp()
+
+#include "u_gnss_cfg_val_key_name.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The number of elements in an array.
+ */
+#define U_GNSS_CFG_VAL_KEY_NAME_ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* Each look-up is in two steps: the hash of the name (or key ID)
+ * with a seed of zero selects a bucket in gNameSeed[] (or gIdSeed[]),
+ * the hash with the seed found there then selects the entry in
+ * gKeyName[] (or in gIdIndex[], which gives the index into
+ * gKeyName[]); the generator has chosen the seeds so that no two
+ * keys end up in the same place.
+ */
+
+// *** DO NOT MODIFY THIS LINE OR BELOW: AUTO-GENERATED BY u_gnss_cfg_val_key.py ***
+
+static const uGnssCfgValKeyName_t gKeyName[] = {
+    {"CFG-TP-SYNC_GNSS_TP2", 0x10050013, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGAL_USB", 0x20910533, 'U'},
+    {"CFG-RATE-MEAS", 0x30210001, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_ODO_SPI", 0x20910082, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSA_SPI", 0x209100c3, 'U'},
+    {"CFG-RINV-DUMP", 0x10c70001, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_RMC_UART1", 0x209100ac, 'U'},
+    {"CFG-MSGOUT-UBX_MON_IO_USB", 0x209101a8, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_VLW_SPI", 0x209100eb, 'U'},
+    {"CFG-SIGNAL-QZSS_ENA", 0x10310024, 'L'},
+    {"CFG-NMEA-MAXSVS", 0x20930002, 'E'},
+    {"CFG-UART1-ENABLED", 0x10520005, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_POSECEF_USB", 0x20910483, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SIG_I2C", 0x20910505, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SLAS_USB", 0x20910513, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_STATUS_UART2", 0x2091001c, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_QZSSL6_USB", 0x2091033d, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMELS_UART2", 0x20910547, 'U'},
+    {"CFG-RTCM-DF003_IN", 0x30090008, 'U'},
+    {"CFG-TMODE-ECEF_Z", 0x40030005, 'I'},
+    {"CFG-MSGOUT-PUBX_ID_POLYP_SPI", 0x209100f0, 'U'},
+    {"CFG-UART2INPROT-NMEA", 0x10750002, 'L'},
+    {"CFG-UART2-BAUDRATE", 0x40530001, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SAT_SPI", 0x20910499, 'U'},
+    {"CFG-TP-FREQ_LOCK_TP2", 0x40050027, 'U'},
+    {"CFG-USB-VENDOR_STR3", 0x50650010, 'X'},
+    {"CFG-NAVSPG-INFIL_MINSVS", 0x201100a1, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_VTG_I2C", 0x209100b0, 'U'},
+    {"CFG-MSGOUT-UBX_MON_TXBUF_UART2", 0x2091019d, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_CLOCK_UART1", 0x20910066, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEBDS_SPI", 0x20910055, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RXR_UART1", 0x20910188, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_VELNED_UART2", 0x20910562, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_EOE_SPI", 0x20910163, 'U'},
+    {"CFG-NMEA-OUT_INVDATE", 0x10930024, 'L'},
+    {"CFG-SBAS-USE_TESTMODE", 0x10360002, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_TIMELS_SPI", 0x20910064, 'U'},
+    {"CFG-QZSS-L6_SVIDA", 0x20370020, 'I'},
+    {"CFG-MSGOUT-NMEA_ID_ZDA_USB", 0x209100db, 'U'},
+    {"CFG-PM-LIMITPEAKCURR", 0x10d00010, 'L'},
+    {"CFG-NAVSPG-ACKAIDING", 0x10110025, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_AOPSTATUS_USB", 0x2091007c, 'U'},
+    {"CFG-TP-USER_DELAY_TP2", 0x40050011, 'I'},
+    {"CFG-MSGOUT-UBX_NAV2_SLAS_I2C", 0x20910510, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGLO_USB", 0x2091004f, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSA_UART1", 0x209100c0, 'U'},
+    {"CFG-ANA-USE_ANA", 0x10230001, 'L'},
+    {"CFG-MSGOUT-UBX_MON_SYS_I2C", 0x2091069d, 'U'},
+    {"CFG-TP-DUTY_LOCK_TP2", 0x5005002d, 'R'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGAL_UART1", 0x20910531, 'U'},
+    {"CFG-I2CINPROT-NMEA", 0x10710002, 'L'},
+    {"CFG-NAVSPG-OUTFIL_FACC", 0x301100b5, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_ODO_SPI", 0x20910479, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSV_UART2", 0x209100c6, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SLAS_SPI", 0x20910514, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RLM_I2C", 0x2091025e, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SLAS_UART2", 0x20910338, 'U'},
+    {"CFG-SFIMU-IMU_EN", 0x1006001d, 'L'},
+    {"CFG-MSGOUT-UBX_MON_HW2_I2C", 0x209101b9, 'U'},
+    {"CFG-SPIINPROT-UBX", 0x10790001, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEBDS_USB", 0x20910528, 'U'},
+    {"CFG-PM-WAITTIMEFIX", 0x10d00009, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_GEOFENCE_USB", 0x209100a4, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSECEF_UART2", 0x20910026, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_RLM_USB", 0x20910403, 'U'},
+    {"CFG-ITFM-ENABLE", 0x1041000d, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_GRS_USB", 0x209100d1, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SAT_USB", 0x20910498, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GGA_I2C", 0x20910661, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_COV_UART1", 0x20910084, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_STATUS_UART1", 0x20910516, 'U'},
+    {"CFG-UART2-ENABLED", 0x10530005, 'L'},
+    {"CFG-TP-PERIOD_LOCK_TP2", 0x4005000e, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SVIN_SPI", 0x2091008c, 'U'},
+    {"CFG-GEOFENCE-CONFLVL", 0x20240011, 'E'},
+    {"CFG-NAVSPG-USRDAT", 0x10110061, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_PVT_USB", 0x20910009, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEUTC_SPI", 0x2091005f, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGLO_USB", 0x20910538, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_STATUS_UART2", 0x20910517, 'U'},
+    {"CFG-SPI-CPOLARITY", 0x10640002, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_RTCM_SPI", 0x2091026c, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_SFRBX_I2C", 0x20910231, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYT_UART2", 0x209100f8, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GLL_UART2", 0x209100cb, 'U'},
+    {"CFG-INFMSG-UBX_SPI", 0x20920005, 'X'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GSA_UART1", 0x20910667, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_ODO_I2C", 0x20910475, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1097_SPI", 0x2091031c, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_VELECEF_UART1", 0x20910556, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RLM_SPI", 0x20910262, 'U'},
+    {"CFG-UART2OUTPROT-NMEA", 0x10760002, 'L'},
+    {"CFG-USB-SERIAL_NO_STR2", 0x50650017, 'X'},
+    {"CFG-MSGOUT-UBX_NAV_SBAS_UART2", 0x2091006c, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GSA_SPI", 0x2091066a, 'U'},
+    {"CFG-MSGOUT-UBX_MON_COMMS_USB", 0x20910352, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_AOPSTATUS_SPI", 0x2091007d, 'U'},
+    {"CFG-TP-FREQ_TP2", 0x40050026, 'U'},
+    {"CFG-NAVSPG-INFIL_MINCNO", 0x201100a3, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEBDS_UART1", 0x20910052, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1084_UART1", 0x20910364, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GLL_USB", 0x20910673, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_INS_I2C", 0x20910114, 'U'},
+    {"CFG-ODO-OUTLPVEL", 0x10220003, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_SFRBX_USB", 0x20910234, 'U'},
+    {"CFG-NAVHPG-DGNSSMODE", 0x20140011, 'E'},
+    {"CFG-MSGOUT-UBX_NAV_VELECEF_UART1", 0x2091003e, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RAWX_UART1", 0x209102a5, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GNS_USB", 0x209100b8, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEQZSS_I2C", 0x20910386, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1005_UART2", 0x209102bf, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGLO_I2C", 0x20910535, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_DOP_UART1", 0x20910039, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_COR_UART2", 0x209106b8, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_ODO_I2C", 0x2091007e, 'U'},
+    {"CFG-TP-DUTY_TP2", 0x5005002c, 'R'},
+    {"CFG-MSGOUT-UBX_RXM_SFRBX_UART2", 0x20910233, 'U'},
+    {"CFG-TP-PERIOD_TP2", 0x4005000d, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RAWX_UART2", 0x209102a6, 'U'},
+    {"CFG-I2CINPROT-SPARTN", 0x10710005, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_MEASX_I2C", 0x20910204, 'U'},
+    {"CFG-NMEA-OUT_ONLYGPS", 0x10930025, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_STATUS_USB", 0x2091001d, 'U'},
+    {"CFG-BATCH-ENABLE", 0x10260013, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_PMP_USB", 0x20910320, 'U'},
+    {"CFG-GEOFENCE-FENCE1_LAT", 0x40240021, 'I'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGLO_UART2", 0x2091004e, 'U'},
+    {"CFG-NAVSPG-FIXMODE", 0x20110011, 'E'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGAL_SPI", 0x2091005a, 'U'},
+    {"CFG-TP-PERIOD_TP1", 0x40050002, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_GEOFENCE_UART1", 0x209100a2, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1074_USB", 0x20910361, 'U'},
+    {"CFG-MOT-GNSSSPEED_THRS", 0x20250038, 'U'},
+    {"CFG-TP-POL_TP1", 0x1005000b, 'L'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1084_UART2", 0x20910365, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1230_UART2", 0x20910305, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_VLW_USB", 0x209100ea, 'U'},
+    {"CFG-SBAS-PRNSCANMASK", 0x50360006, 'X'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1097_I2C", 0x20910318, 'U'},
+    {"CFG-HW-ANT_SUP_ENGINE", 0x20a30054, 'E'},
+    {"CFG-MSGOUT-UBX_MON_HW3_USB", 0x20910357, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RXR_I2C", 0x20910187, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_DOP_UART1", 0x20910466, 'U'},
+    {"CFG-GEOFENCE-FENCE1_RAD", 0x40240023, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1094_I2C", 0x20910368, 'U'},
+    {"CFG-HW-ANT_CFG_OPENDET", 0x10a30031, 'L'},
+    {"CFG-NAVSPG-USRDAT_MAJA", 0x50110062, 'R'},
+    {"CFG-NAVSPG-USRDAT_DX", 0x40110064, 'R'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_RMC_UART2", 0x20910654, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_VTG_USB", 0x209100b3, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SVIN_UART1", 0x20910089, 'U'},
+    {"CFG-I2CINPROT-RTCM3X", 0x10710004, 'L'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1084_I2C", 0x20910363, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_COV_USB", 0x20910438, 'U'},
+    {"CFG-TP-LEN_TP1", 0x40050004, 'U'},
+    {"CFG-GEOFENCE-FENCE4_LAT", 0x40240051, 'I'},
+    {"CFG-MSGOUT-UBX_NAV_VELNED_UART2", 0x20910044, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMELS_UART2", 0x20910062, 'U'},
+    {"CFG-MSGOUT-UBX_MON_SPAN_UART2", 0x2091038d, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GGA_USB", 0x20910664, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_DOP_UART2", 0x20910467, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_MEAS_UART1", 0x20910278, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEUTC_I2C", 0x2091005b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGLO_SPI", 0x20910050, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GGA_SPI", 0x209100be, 'U'},
+    {"CFG-SFODO-FACTOR", 0x40070007, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1127_I2C", 0x209102d6, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGAL_SPI", 0x20910534, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMELS_USB", 0x20910063, 'U'},
+    {"CFG-TMODE-ECEF_X", 0x40030003, 'I'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_ZDA_I2C", 0x2091067f, 'U'},
+    {"CFG-MSGOUT-UBX_MON_COMMS_SPI", 0x20910353, 'U'},
+    {"CFG-MSGOUT-UBX_MON_TXBUF_I2C", 0x2091019b, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYT_I2C", 0x209100f6, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GBS_SPI", 0x209100e1, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGPS_UART2", 0x20910049, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_SFRBX_SPI", 0x20910235, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYP_I2C", 0x209100ec, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_ALG_I2C", 0x2091010f, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSV_USB", 0x209100c7, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEQZSS_I2C", 0x20910575, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_MEASX_UART2", 0x20910206, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1005_UART1", 0x209102be, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1094_UART1", 0x20910369, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_QZSSL6_UART2", 0x2091033c, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_ODO_UART2", 0x20910477, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW3_UART2", 0x20910356, 'U'},
+    {"CFG-NMEA-FILT_GAL", 0x10930013, 'L'},
+    {"CFG-NMEA-COMPAT", 0x10930003, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_GRS_I2C", 0x209100ce, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_RMC_SPI", 0x20910656, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RXBUF_UART1", 0x209101a1, 'U'},
+    {"CFG-TMODE-LAT_HP", 0x2003000c, 'I'},
+    {"CFG-MSGOUT-UBX_TIM_VRFY_SPI", 0x20910096, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SAT_SPI", 0x20910019, 'U'},
+    {"CFG-MSGOUT-UBX_MON_TXBUF_USB", 0x2091019e, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_VRFY_USB", 0x20910095, 'U'},
+    {"CFG-PM-EXTINTSEL", 0x20d0000b, 'E'},
+    {"CFG-INFMSG-UBX_I2C", 0x20920001, 'X'},
+    {"CFG-MSGOUT-UBX_NAV_COV_I2C", 0x20910083, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_RMC_USB", 0x20910655, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE4072_0_UART2", 0x20910300, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_VTG_I2C", 0x20910657, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RF_UART1", 0x2091035a, 'U'},
+    {"CFG-TMODE-MODE", 0x20030001, 'E'},
+    {"CFG-MSGOUT-UBX_TIM_TM2_I2C", 0x20910178, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SLAS_USB", 0x20910339, 'U'},
+    {"CFG-RTCM-DF003_OUT", 0x30090001, 'U'},
+    {"CFG-NMEA-OUT_FROZENCOG", 0x10930026, 'L'},
+    {"CFG-USB-PRODUCT_STR0", 0x50650011, 'X'},
+    {"CFG-HW-ANT_CFG_OPENDET_POL", 0x10a30032, 'L'},
+    {"CFG-MSGOUT-UBX_MON_COMMS_I2C", 0x2091034f, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGPS_USB", 0x2091004a, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEBDS_UART1", 0x20910526, 'U'},
+    {"CFG-USB-VENDOR_STR0", 0x5065000d, 'X'},
+    {"CFG-SFIMU-GYRO_TC_UPDATE_PERIOD", 0x30060007, 'U'},
+    {"CFG-RINV-DATA_SIZE", 0x20c70003, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_RAW_UART1", 0x209102a0, 'U'},
+    {"CFG-TMODE-ECEF_X_HP", 0x20030006, 'I'},
+    {"CFG-MSGOUT-UBX_NAV2_SVIN_USB", 0x20910523, 'U'},
+    {"CFG-SIGNAL-GPS_L2C_ENA", 0x10310003, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGPS_I2C", 0x20910047, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GGA_SPI", 0x20910665, 'U'},
+    {"CFG-NAVSPG-USE_PPP", 0x10110019, 'L'},
+    {"CFG-SFODO-FREQUENCY", 0x2007000b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SIG_UART1", 0x20910346, 'U'},
+    {"CFG-USB-VENDOR_ID", 0x3065000a, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_PVT_UART1", 0x20910007, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_CLOCK_UART2", 0x20910067, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1087_UART1", 0x209102d2, 'U'},
+    {"CFG-NAVSPG-INFIL_NCNOTHRS", 0x201100aa, 'U'},
+    {"CFG-USBINPROT-RTCM3X", 0x10770004, 'L'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_ZDA_SPI", 0x20910683, 'U'},
+    {"CFG-SFODO-COUNT_MAX", 0x40070009, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYS_UART2", 0x209100f3, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEBDS_USB", 0x20910054, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSECEF_UART2", 0x20910030, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1087_UART2", 0x209102d3, 'U'},
+    {"CFG-SFIMU-IMU_I2C_SDA_PIO", 0x2006001f, 'U'},
+    {"CFG-GEOFENCE-FENCE4_LON", 0x40240052, 'I'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSLLH_USB", 0x20910036, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_COV_UART2", 0x20910085, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1094_UART2", 0x2091036a, 'U'},
+    {"CFG-TP-USE_LOCKED_TP2", 0x10050014, 'L'},
+    {"CFG-USB-PRODUCT_STR1", 0x50650012, 'X'},
+    {"CFG-NMEA-CONSIDER", 0x10930004, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_RTCM_UART1", 0x20910269, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_RMC_UART2", 0x209100ad, 'U'},
+    {"CFG-MSGOUT-UBX_MON_TXBUF_SPI", 0x2091019f, 'U'},
+    {"CFG-TMODE-POS_TYPE", 0x20030002, 'E'},
+    {"CFG-MSGOUT-UBX_NAV2_COV_UART2", 0x20910437, 'U'},
+    {"CFG-I2C-ADDRESS", 0x20510001, 'U'},
+    {"CFG-MSGOUT-UBX_MON_COMMS_UART2", 0x20910351, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1005_SPI", 0x209102c1, 'U'},
+    {"CFG-MOT-GNSSDIST_THRS", 0x3025003b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_AOPSTATUS_UART2", 0x2091007b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_RELPOSNED_UART2", 0x2091008f, 'U'},
+    {"CFG-MSGOUT-UBX_MON_MSGPP_I2C", 0x20910196, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_PL_I2C", 0x20910415, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW3_SPI", 0x20910358, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1077_SPI", 0x209102d0, 'U'},
+    {"CFG-MSGOUT-UBX_MON_SPAN_USB", 0x2091038e, 'U'},
+    {"CFG-TP-TIMEGRID_TP1", 0x2005000c, 'E'},
+    {"CFG-USBINPROT-NMEA", 0x10770002, 'L'},
+    {"CFG-PM-EXTINTWAKE", 0x10d0000c, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_SPARTN_I2C", 0x20910605, 'U'},
+    {"CFG-NAVSPG-USRDAT_ROTZ", 0x40110069, 'R'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSLLH_I2C", 0x20910033, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_POSECEF_SPI", 0x20910484, 'U'},
+    {"CFG-USB-SERIAL_NO_STR0", 0x50650015, 'X'},
+    {"CFG-MSGOUT-NMEA_ID_GST_UART2", 0x209100d5, 'U'},
+    {"CFG-MSGOUT-UBX_MON_SYS_UART2", 0x2091069f, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_COV_UART1", 0x20910436, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_VELNED_SPI", 0x20910564, 'U'},
+    {"CFG-PM-OPERATEMODE", 0x20d00001, 'E'},
+    {"CFG-SFODO-USE_WT_PIN", 0x1007000f, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_DTM_SPI", 0x209100aa, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GNS_UART1", 0x2091065d, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSV_SPI", 0x209100c8, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_DOP_I2C", 0x20910465, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GNS_UART2", 0x209100b7, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_POSLLH_SPI", 0x20910489, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_COV_I2C", 0x20910435, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW_USB", 0x209101b7, 'U'},
+    {"CFG-GEOFENCE-FENCE2_RAD", 0x40240033, 'U'},
+    {"CFG-SBAS-USE_RANGING", 0x10360003, 'L'},
+    {"CFG-GEOFENCE-USE_FENCE3", 0x10240040, 'L'},
+    {"CFG-MSGOUT-UBX_ESF_RAW_USB", 0x209102a2, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYT_UART1", 0x209100f7, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1230_UART1", 0x20910304, 'U'},
+    {"CFG-LOGFILTER-POSITION_THRS", 0x40de0008, 'U'},
+    {"CFG-TP-ANT_CABLEDELAY", 0x30050001, 'I'},
+    {"CFG-MSGOUT-UBX_NAV_VELNED_I2C", 0x20910042, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEQZSS_SPI", 0x20910579, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SLAS_SPI", 0x2091033a, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_POSLLH_I2C", 0x20910485, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SBAS_UART1", 0x20910501, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_TM2_USB", 0x2091017b, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1087_I2C", 0x209102d1, 'U'},
+    {"CFG-SFODO-DIR_PINPOL", 0x10070010, 'L'},
+    {"CFG-RINV-CHUNK3", 0x50c70007, 'X'},
+    {"CFG-SFIMU-GYRO_FREQUENCY", 0x20060009, 'U'},
+    {"CFG-SPIOUTPROT-UBX", 0x107a0001, 'L'},
+    {"CFG-ANA-ORBMAXERR", 0x30230002, 'U'},
+    {"CFG-NMEA-HIGHPREC", 0x10930006, 'L'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_VTG_UART2", 0x20910649, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYP_UART2", 0x209100ee, 'U'},
+    {"CFG-GEOFENCE-USE_FENCE1", 0x10240020, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_POSLLH_USB", 0x20910488, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SIG_SPI", 0x20910349, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_VELECEF_SPI", 0x20910041, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEBDS_I2C", 0x20910051, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_CLOCK_USB", 0x20910068, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GBS_USB", 0x209100e0, 'U'},
+    {"CFG-MSGOUT-UBX_MON_SPAN_SPI", 0x2091038f, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYP_USB", 0x209100ef, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SIG_UART2", 0x20910507, 'U'},
+    {"CFG-UART1INPROT-RTCM3X", 0x10730004, 'L'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1124_I2C", 0x2091036d, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_RMC_UART1", 0x20910653, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GGA_UART2", 0x209100bc, 'U'},
+    {"CFG-ODO-COGMAXSPEED", 0x20220021, 'U'},
+    {"CFG-SPI-MAXFF", 0x20640001, 'U'},
+    {"CFG-ODO-COGMAXPOSACC", 0x20220022, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_GEOFENCE_I2C", 0x209100a1, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_INS_UART2", 0x20910116, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_TP_SPI", 0x20910181, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_VLW_I2C", 0x209100e7, 'U'},
+    {"CFG-BATCH-EXTRAODO", 0x1026001b, 'L'},
+    {"CFG-SIGNAL-BDS_B2_ENA", 0x1031000e, 'L'},
+    {"CFG-MSGOUT-UBX_ESF_STATUS_UART2", 0x20910107, 'U'},
+    {"CFG-TP-FREQ_TP1", 0x40050024, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SLAS_UART2", 0x20910512, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEUTC_UART1", 0x2091005c, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GNS_USB", 0x2091065f, 'U'},
+    {"CFG-NAVSPG-INFIL_MINELEV", 0x201100a4, 'I'},
+    {"CFG-NAVSPG-OUTFIL_TDOP", 0x301100b2, 'U'},
+    {"CFG-TP-USER_DELAY_TP1", 0x40050006, 'I'},
+    {"CFG-MSGOUT-UBX_NAV_SBAS_USB", 0x2091006d, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_INS_USB", 0x20910117, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GBS_UART1", 0x209100de, 'U'},
+    {"CFG-HW-ANT_CFG_SHORTDET_POL", 0x10a30030, 'L'},
+    {"CFG-SBAS-USE_DIFFCORR", 0x10360004, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_ORB_UART1", 0x20910011, 'U'},
+    {"CFG-PM-ACQPERIOD", 0x40d00003, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_VELNED_UART1", 0x20910561, 'U'},
+    {"CFG-SPIINPROT-RTCM3X", 0x10790004, 'L'},
+    {"CFG-NAVSPG-UTCSTANDARD", 0x2011001c, 'E'},
+    {"CFG-RINV-CHUNK0", 0x50c70004, 'X'},
+    {"CFG-SPIOUTPROT-NMEA", 0x107a0002, 'L'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1094_SPI", 0x2091036c, 'U'},
+    {"CFG-USB-SERIAL_NO_STR1", 0x50650016, 'X'},
+    {"CFG-MSGOUT-UBX_NAV2_PVT_SPI", 0x20910494, 'U'},
+    {"CFG-SFODO-DIS_AUTOSPEED", 0x10070006, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_ZDA_SPI", 0x209100dc, 'U'},
+    {"CFG-QZSS-USE_SLAS_DGNSS", 0x10370005, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_VELECEF_I2C", 0x2091003d, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEQZSS_UART1", 0x20910576, 'U'},
+    {"CFG-MSGOUT-UBX_MON_IO_UART2", 0x209101a7, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_CLOCK_I2C", 0x20910065, 'U'},
+    {"CFG-NAVSPG-SIGATTCOMP", 0x201100d6, 'E'},
+    {"CFG-SFIMU-ACCEL_ACCURACY", 0x30060018, 'U'},
+    {"CFG-UART1OUTPROT-UBX", 0x10740001, 'L'},
+    {"CFG-SIGNAL-GAL_E1_ENA", 0x10310007, 'L'},
+    {"CFG-LOGFILTER-ONCE_PER_WAKE_UP_ENA", 0x10de0003, 'L'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1077_I2C", 0x209102cc, 'U'},
+    {"CFG-TP-DUTY_TP1", 0x5005002a, 'R'},
+    {"CFG-MSGOUT-UBX_NAV2_VELECEF_I2C", 0x20910555, 'U'},
+    {"CFG-SEC-CFG_LOCK", 0x10f60009, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_VTG_SPI", 0x209100b4, 'U'},
+    {"CFG-TMODE-HEIGHT_HP", 0x2003000e, 'I'},
+    {"CFG-TMODE-ECEF_Y", 0x40030004, 'I'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GGA_UART2", 0x20910663, 'U'},
+    {"CFG-NAVSPG-CONSTR_DGNSSTO", 0x201100c4, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_COR_UART1", 0x209106b7, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_DTM_UART2", 0x209100a8, 'U'},
+    {"CFG-USB-VENDOR_STR1", 0x5065000e, 'X'},
+    {"CFG-MSGOUT-NMEA_ID_GRS_UART1", 0x209100cf, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1230_SPI", 0x20910307, 'U'},
+    {"CFG-QZSS-L6_MSGA", 0x20370050, 'E'},
+    {"CFG-NAVSPG-USRDAT_DZ", 0x40110066, 'R'},
+    {"CFG-MSGOUT-UBX_NAV_ODO_UART1", 0x2091007f, 'U'},
+    {"CFG-SFIMU-IMU_MNTALG_ROLL", 0x3006002f, 'I'},
+    {"CFG-TP-DUTY_LOCK_TP1", 0x5005002b, 'R'},
+    {"CFG-MSGOUT-UBX_NAV2_DOP_SPI", 0x20910469, 'U'},
+    {"CFG-NMEA-OUT_MSKFIX", 0x10930022, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_GSA_UART2", 0x209100c1, 'U'},
+    {"CFG-NAVSPG-INIFIX3D", 0x10110013, 'L'},
+    {"CFG-LOGFILTER-SPEED_THRS", 0x30de0007, 'U'},
+    {"CFG-MSGOUT-UBX_LOG_INFO_USB", 0x2091025c, 'U'},
+    {"CFG-TP-DRSTR_TP2", 0x20050036, 'E'},
+    {"CFG-USB-PRODUCT_ID", 0x3065000b, 'U'},
+    {"CFG-RATE-TIMEREF", 0x20210003, 'E'},
+    {"CFG-MSGOUT-UBX_LOG_INFO_I2C", 0x20910259, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SAT_UART2", 0x20910017, 'U'},
+    {"CFG-NAVSPG-OUTFIL_PACC", 0x301100b3, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_TP_UART2", 0x2091017f, 'U'},
+    {"CFG-PMP-UNIQUE_WORD", 0x50b1001a, 'U'},
+    {"CFG-UART2OUTPROT-RTCM3X", 0x10760004, 'L'},
+    {"CFG-GEOFENCE-FENCE2_LON", 0x40240032, 'I'},
+    {"CFG-MSGOUT-UBX_MON_SPAN_UART1", 0x2091038c, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_ZDA_UART2", 0x20910681, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSECEF_SPI", 0x20910032, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_AOPSTATUS_I2C", 0x20910079, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSV_UART1", 0x209100c5, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SVIN_USB", 0x2091008b, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1097_UART1", 0x20910319, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW3_I2C", 0x20910354, 'U'},
+    {"CFG-USB-PRODUCT_STR2", 0x50650013, 'X'},
+    {"CFG-MSGOUT-UBX_TIM_TM2_UART2", 0x2091017a, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RTCM_USB", 0x2091026b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEUTC_SPI", 0x20910554, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_RMC_I2C", 0x20910652, 'U'},
+    {"CFG-NAVSPG-USRDAT_FLAT", 0x50110063, 'R'},
+    {"CFG-MSGOUT-UBX_MON_RXR_USB", 0x2091018a, 'U'},
+    {"CFG-PM-MAXACQTIME", 0x20d00007, 'U'},
+    {"CFG-SPI-CPHASE", 0x10640003, 'L'},
+    {"CFG-SFIMU-AUTO_MNTALG_ENA", 0x10060027, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGLO_UART1", 0x20910536, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEUTC_USB", 0x2091005e, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_DTM_UART1", 0x209100a7, 'U'},
+    {"CFG-PMP-DESCRAMBLER_INIT", 0x30b10015, 'U'},
+    {"CFG-SFODO-DIS_AUTOSW", 0x10070011, 'L'},
+    {"CFG-PMP-USE_PRESCRAMBLING", 0x10b10019, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_SPARTN_USB", 0x20910608, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_EOE_I2C", 0x20910565, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RXBUF_UART2", 0x209101a2, 'U'},
+    {"CFG-SFODO-LATENCY", 0x3007000a, 'U'},
+    {"CFG-UART1-PARITY", 0x20520004, 'E'},
+    {"CFG-PM-GRIDOFFSET", 0x40d00004, 'U'},
+    {"CFG-UART1INPROT-NMEA", 0x10730002, 'L'},
+    {"CFG-TMODE-LAT", 0x40030009, 'I'},
+    {"CFG-TP-FREQ_LOCK_TP1", 0x40050025, 'U'},
+    {"CFG-SEC-CFG_LOCK_UNLOCKGRP1", 0x30f6000a, 'U'},
+    {"CFG-QZSS-L6_SVIDB", 0x20370030, 'I'},
+    {"CFG-TXREADY-PIN", 0x20a20003, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGPS_SPI", 0x2091004b, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GNS_UART2", 0x2091065e, 'U'},
+    {"CFG-SFODO-USE_SPEED", 0x10070003, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_SPARTN_UART2", 0x20910607, 'U'},
+    {"CFG-SFIMU-ACCEL_FREQUENCY", 0x20060016, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_STATUS_I2C", 0x20910515, 'U'},
+    {"CFG-NAVSPG-CONSTR_ALTVAR", 0x401100c2, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_MEASX_USB", 0x20910207, 'U'},
+    {"CFG-I2C-EXTENDEDTIMEOUT", 0x10510002, 'L'},
+    {"CFG-SPIINPROT-SPARTN", 0x10790005, 'L'},
+    {"CFG-MSGOUT-UBX_ESF_RAW_UART2", 0x209102a1, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_POSECEF_I2C", 0x20910480, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GRS_SPI", 0x209100d2, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RLM_UART2", 0x20910260, 'U'},
+    {"CFG-QZSS-USE_SLAS_TESTMODE", 0x10370006, 'L'},
+    {"CFG-TP-LEN_TP2", 0x4005000f, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_DOP_SPI", 0x2091003c, 'U'},
+    {"CFG-UART1-STOPBITS", 0x20520002, 'E'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1127_USB", 0x209102d9, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_PL_SPI", 0x20910419, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_PVT_UART2", 0x20910492, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_COR_SPI", 0x209106ba, 'U'},
+    {"CFG-GEOFENCE-USE_FENCE4", 0x10240050, 'L'},
+    {"CFG-MSGOUT-UBX_ESF_STATUS_SPI", 0x20910109, 'U'},
+    {"CFG-NAVSPG-USRDAT_SCALE", 0x4011006a, 'R'},
+    {"CFG-MSGOUT-NMEA_ID_VTG_UART2", 0x209100b2, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_VTG_UART1", 0x20910658, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_QZSSL6_I2C", 0x2091033f, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GST_I2C", 0x209100d3, 'U'},
+    {"CFG-RATE-NAV", 0x30210002, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSLLH_I2C", 0x20910029, 'U'},
+    {"CFG-SPI-EXTENDEDTIMEOUT", 0x10640005, 'L'},
+    {"CFG-SPIOUTPROT-RTCM3X", 0x107a0004, 'L'},
+    {"CFG-GEOFENCE-USE_FENCE2", 0x10240030, 'L'},
+    {"CFG-BATCH-PIOENABLE", 0x10260014, 'L'},
+    {"CFG-UART1-BAUDRATE", 0x40520001, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1124_USB", 0x20910370, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEUTC_USB", 0x20910553, 'U'},
+    {"CFG-UART2INPROT-RTCM3X", 0x10750004, 'L'},
+    {"CFG-INFMSG-UBX_UART2", 0x20920003, 'X'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGAL_I2C", 0x20910530, 'U'},
+    {"CFG-SFODO-DIS_AUTODIRPINPOL", 0x10070005, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_POSLLH_UART2", 0x20910487, 'U'},
+    {"CFG-SIGNAL-GLO_L1_ENA", 0x10310018, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEQZSS_USB", 0x20910389, 'U'},
+    {"CFG-NAV2-OUT_ENABLED", 0x10170001, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_RLM_I2C", 0x20910400, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1074_I2C", 0x2091035e, 'U'},
+    {"CFG-HW-RF_LNA_MODE", 0x20a30057, 'E'},
+    {"CFG-SFODO-COMBINE_TICKS", 0x10070001, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_DOP_I2C", 0x20910038, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_STATUS_USB", 0x20910108, 'U'},
+    {"CFG-GEOFENCE-FENCE3_RAD", 0x40240043, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GSA_I2C", 0x20910666, 'U'},
+    {"CFG-QZSS-USE_SLAS_RAIM_UNCORR", 0x10370007, 'L'},
+    {"CFG-MSGOUT-UBX_ESF_RAW_SPI", 0x209102a3, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GBS_I2C", 0x209100dd, 'U'},
+    {"CFG-RINV-CHUNK1", 0x50c70005, 'X'},
+    {"CFG-LOGFILTER-APPLY_ALL_FILTERS", 0x10de0004, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_CLOCK_USB", 0x20910433, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW_UART1", 0x209101b5, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1127_UART2", 0x209102d8, 'U'},
+    {"CFG-TP-DRSTR_TP1", 0x20050035, 'E'},
+    {"CFG-PM-ONTIME", 0x30d00005, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1084_SPI", 0x20910367, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEQZSS_SPI", 0x2091038a, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SVIN_I2C", 0x20910520, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RXR_SPI", 0x2091018b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMELS_USB", 0x20910548, 'U'},
+    {"CFG-MSGOUT-UBX_MON_SYS_SPI", 0x209106a1, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_PMP_UART1", 0x2091031e, 'U'},
+    {"CFG-TMODE-SVIN_ACC_LIMIT", 0x40030011, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_DTM_USB", 0x209100a9, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_STATUS_I2C", 0x2091001a, 'U'},
+    {"CFG-GEOFENCE-PINPOL", 0x20240013, 'E'},
+    {"CFG-UART2-DATABITS", 0x20530003, 'E'},
+    {"CFG-MSGOUT-UBX_NAV2_VELECEF_SPI", 0x20910559, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMELS_UART1", 0x20910061, 'U'},
+    {"CFG-INFMSG-UBX_UART1", 0x20920002, 'X'},
+    {"CFG-MSGOUT-UBX_TIM_VRFY_UART1", 0x20910093, 'U'},
+    {"CFG-PM-EXTINTINACTIVITY", 0x40d0000f, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_ORB_UART2", 0x20910012, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSA_USB", 0x209100c2, 'U'},
+    {"CFG-HW-ANT_CFG_PWRDOWN", 0x10a30033, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_CLOCK_SPI", 0x20910069, 'U'},
+    {"CFG-NMEA-OUT_INVFIX", 0x10930021, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_ODO_USB", 0x20910081, 'U'},
+    {"CFG-PMP-SERVICE_ID", 0x30b10017, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SVIN_UART1", 0x20910521, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GGA_UART1", 0x20910662, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_PVT_UART2", 0x20910008, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEUTC_I2C", 0x20910550, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SBAS_I2C", 0x20910500, 'U'},
+    {"CFG-BATCH-WARNTHRS", 0x30260016, 'U'},
+    {"CFG-SFIMU-GYRO_LATENCY", 0x3006000a, 'U'},
+    {"CFG-UART2INPROT-UBX", 0x10750001, 'L'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1124_UART2", 0x2091036f, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1097_UART2", 0x2091031a, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RTCM_I2C", 0x20910268, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSV_I2C", 0x209100c4, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_EOE_UART1", 0x20910160, 'U'},
+    {"CFG-ITFM-BBTHRESHOLD", 0x20410001, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_QZSSL6_UART1", 0x2091033b, 'U'},
+    {"CFG-TP-PULSE_DEF", 0x20050023, 'E'},
+    {"CFG-MSGOUT-UBX_NAV_COV_SPI", 0x20910087, 'U'},
+    {"CFG-SFIMU-ACCEL_RMSTHDL", 0x20060015, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGAL_USB", 0x20910059, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SAT_UART1", 0x20910016, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSLLH_UART1", 0x2091002a, 'U'},
+    {"CFG-ODO-USE_ODO", 0x10220001, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSLLH_UART1", 0x20910034, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE4072_0_UART1", 0x209102ff, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_STATUS_I2C", 0x20910105, 'U'},
+    {"CFG-NMEA-MAINTALKERID", 0x20930031, 'E'},
+    {"CFG-MSGOUT-UBX_RXM_RTCM_UART2", 0x2091026a, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1084_USB", 0x20910366, 'U'},
+    {"CFG-TXREADY-THRESHOLD", 0x30a20004, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1077_USB", 0x209102cf, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_COV_USB", 0x20910086, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GLL_I2C", 0x20910670, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RXBUF_USB", 0x209101a3, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GLL_USB", 0x209100cc, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_VTG_USB", 0x2091065a, 'U'},
+    {"CFG-SIGNAL-GLO_ENA", 0x10310025, 'L'},
+    {"CFG-SFCORE-USE_SF", 0x10080001, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_RLM_UART2", 0x20910402, 'U'},
+    {"CFG-MSGOUT-UBX_MON_IO_UART1", 0x209101a6, 'U'},
+    {"CFG-UART2-STOPBITS", 0x20530002, 'E'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GLL_UART2", 0x20910672, 'U'},
+    {"CFG-PM-EXTINTBACKUP", 0x10d0000d, 'L'},
+    {"CFG-MSGOUT-UBX_MON_SYS_UART1", 0x2091069e, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_EOE_UART2", 0x20910567, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW2_UART2", 0x209101bb, 'U'},
+    {"CFG-PM-ONOTENTEROFF", 0x10d00008, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_SLAS_UART1", 0x20910337, 'U'},
+    {"CFG-I2COUTPROT-RTCM3X", 0x10720004, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEQZSS_UART1", 0x20910387, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEBDS_UART2", 0x20910527, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEUTC_UART1", 0x20910551, 'U'},
+    {"CFG-MSGOUT-UBX_MON_COMMS_UART1", 0x20910350, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYS_SPI", 0x209100f5, 'U'},
+    {"CFG-NAVSPG-CONSTR_ALT", 0x401100c1, 'I'},
+    {"CFG-I2COUTPROT-UBX", 0x10720001, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_RMC_I2C", 0x209100ab, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYP_UART1", 0x209100ed, 'U'},
+    {"CFG-MSGOUT-UBX_MON_MSGPP_UART1", 0x20910197, 'U'},
+    {"CFG-NAV2-SBAS_USE_INTEGRITY", 0x10170002, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_STATUS_SPI", 0x20910519, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1077_UART1", 0x209102cd, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_POSLLH_UART1", 0x20910486, 'U'},
+    {"CFG-SIGNAL-GPS_L1CA_ENA", 0x10310001, 'L'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_ZDA_UART1", 0x20910680, 'U'},
+    {"CFG-UART1INPROT-UBX", 0x10730001, 'L'},
+    {"CFG-HW-ANT_CFG_SHORTDET", 0x10a3002f, 'L'},
+    {"CFG-TMODE-LON", 0x4003000a, 'I'},
+    {"CFG-SEC-CFG_LOCK_UNLOCKGRP2", 0x30f6000b, 'U'},
+    {"CFG-MSGOUT-UBX_MON_IO_I2C", 0x209101a5, 'U'},
+    {"CFG-MSGOUT-UBX_MON_MSGPP_USB", 0x20910199, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_TP_UART1", 0x2091017e, 'U'},
+    {"CFG-TP-POL_TP2", 0x10050016, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_PMP_UART2", 0x2091031f, 'U'},
+    {"CFG-USB-SERIAL_NO_STR3", 0x50650018, 'X'},
+    {"CFG-HW-ANT_CFG_RECOVER", 0x10a30035, 'L'},
+    {"CFG-SFIMU-IMU_MNTALG_PITCH", 0x3006002e, 'I'},
+    {"CFG-MSGOUT-UBX_ESF_MEAS_USB", 0x2091027a, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYS_USB", 0x209100f4, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1097_USB", 0x2091031b, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYS_I2C", 0x209100f1, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1087_SPI", 0x209102d5, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_VELECEF_USB", 0x20910040, 'U'},
+    {"CFG-GEOFENCE-FENCE3_LAT", 0x40240041, 'I'},
+    {"CFG-MSGOUT-UBX_MON_IO_SPI", 0x209101a9, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_POSECEF_UART1", 0x20910481, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_VELECEF_UART2", 0x20910557, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SAT_UART1", 0x20910496, 'U'},
+    {"CFG-NAVSPG-INFIL_MAXSVS", 0x201100a2, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGLO_I2C", 0x2091004c, 'U'},
+    {"CFG-QZSS-L6_RSDECODER", 0x20370080, 'E'},
+    {"CFG-MSGOUT-UBX_NAV_GEOFENCE_UART2", 0x209100a3, 'U'},
+    {"CFG-NAVSPG-OUTFIL_TACC", 0x301100b4, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_EOE_UART1", 0x20910566, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEBDS_SPI", 0x20910529, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GNS_UART1", 0x209100b6, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_PMP_I2C", 0x2091031d, 'U'},
+    {"CFG-ODO-VELLPGAIN", 0x20220031, 'U'},
+    {"CFG-ODO-PROFILE", 0x20220005, 'E'},
+    {"CFG-MSGOUT-UBX_NAV2_SBAS_UART2", 0x20910502, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_PL_UART1", 0x20910416, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_EOE_UART2", 0x20910161, 'U'},
+    {"CFG-SIGNAL-QZSS_L1CA_ENA", 0x10310012, 'L'},
+    {"CFG-MSGOUT-UBX_MON_HW3_UART1", 0x20910355, 'U'},
+    {"CFG-LOGFILTER-MIN_INTERVAL", 0x30de0005, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_DOP_USB", 0x2091003b, 'U'},
+    {"CFG-INFMSG-UBX_USB", 0x20920004, 'X'},
+    {"CFG-TP-TP1_ENA", 0x10050007, 'L'},
+    {"CFG-NMEA-GSVTALKERID", 0x20930032, 'E'},
+    {"CFG-MSGOUT-UBX_RXM_COR_I2C", 0x209106b6, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_PVT_UART1", 0x20910491, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_SPARTN_UART1", 0x20910606, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1074_SPI", 0x20910362, 'U'},
+    {"CFG-NAVSPG-PL_ENA", 0x101100d7, 'L'},
+    {"CFG-UART2OUTPROT-UBX", 0x10760001, 'L'},
+    {"CFG-HW-ANT_SUP_SWITCH_PIN", 0x20a30036, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RXR_UART2", 0x20910189, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SLAS_UART1", 0x20910511, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_VTG_UART1", 0x209100b1, 'U'},
+    {"CFG-PMP-DATA_RATE", 0x30b10013, 'E'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGPS_I2C", 0x20910540, 'U'},
+    {"CFG-HW-ANT_SUP_SHORT_PIN", 0x20a30037, 'U'},
+    {"CFG-SIGNAL-GAL_E5B_ENA", 0x1031000a, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_SBAS_SPI", 0x20910504, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RXBUF_I2C", 0x209101a0, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RLM_USB", 0x20910261, 'U'},
+    {"CFG-RTCM-DF003_IN_FILTER", 0x20090009, 'E'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1124_UART1", 0x2091036e, 'U'},
+    {"CFG-NAVSPG-WKNROLLOVER", 0x30110017, 'U'},
+    {"CFG-MSGOUT-UBX_LOG_INFO_UART1", 0x2091025a, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_ODO_UART1", 0x20910476, 'U'},
+    {"CFG-LOGFILTER-TIME_THRS", 0x30de0006, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGPS_UART2", 0x20910542, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMELS_UART1", 0x20910546, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_ALG_SPI", 0x20910113, 'U'},
+    {"CFG-PMP-USE_SERVICE_ID", 0x10b10016, 'L'},
+    {"CFG-MSGOUT-UBX_LOG_INFO_UART2", 0x2091025b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEUTC_UART2", 0x20910552, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1230_USB", 0x20910306, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GNS_I2C", 0x209100b5, 'U'},
+    {"CFG-BATCH-MAXENTRIES", 0x30260015, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_RLM_UART1", 0x20910401, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEBDS_I2C", 0x20910525, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SVIN_SPI", 0x20910524, 'U'},
+    {"CFG-LOGFILTER-RECORD_ENA", 0x10de0002, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_COV_SPI", 0x20910439, 'U'},
+    {"CFG-SFIMU-ACCEL_LATENCY", 0x30060017, 'U'},
+    {"CFG-NMEA-FILT_SBAS", 0x10930012, 'L'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1005_I2C", 0x209102bd, 'U'},
+    {"CFG-INFMSG-NMEA_UART2", 0x20920008, 'X'},
+    {"CFG-NMEA-BDSTALKERID", 0x30930033, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GRS_UART2", 0x209100d0, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEQZSS_UART2", 0x20910577, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1127_UART1", 0x209102d7, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SIG_USB", 0x20910508, 'U'},
+    {"CFG-TMODE-SVIN_MIN_DUR", 0x40030010, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_ZDA_I2C", 0x209100d8, 'U'},
+    {"CFG-NAVSPG-USRDAT_ROTX", 0x40110067, 'R'},
+    {"CFG-TP-ALIGN_TO_TOW_TP2", 0x10050015, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMELS_I2C", 0x20910545, 'U'},
+    {"CFG-BDS-USE_GEO_PRN", 0x10340014, 'L'},
+    {"CFG-NAVSPG-OUTFIL_PDOP", 0x301100b1, 'U'},
+    {"CFG-MSGOUT-UBX_MON_TXBUF_UART1", 0x2091019c, 'U'},
+    {"CFG-USB-VENDOR_STR2", 0x5065000f, 'X'},
+    {"CFG-MSGOUT-UBX_NAV_RELPOSNED_UART1", 0x2091008e, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGAL_UART2", 0x20910058, 'U'},
+    {"CFG-NAVSPG-DYNMODEL", 0x20110021, 'E'},
+    {"CFG-MSGOUT-UBX_RXM_QZSSL6_SPI", 0x2091033e, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_TM2_UART1", 0x20910179, 'U'},
+    {"CFG-SPIINPROT-NMEA", 0x10790002, 'L'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GNS_SPI", 0x20910660, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_ODO_UART2", 0x20910080, 'U'},
+    {"CFG-GEOFENCE-PIN", 0x20240014, 'U'},
+    {"CFG-TMODE-FIXED_POS_ACC", 0x4003000f, 'U'},
+    {"CFG-I2COUTPROT-NMEA", 0x10720002, 'L'},
+    {"CFG-PMP-SEARCH_WINDOW", 0x30b10012, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GSA_I2C", 0x209100bf, 'U'},
+    {"CFG-SIGNAL-GAL_ENA", 0x10310021, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_SIG_I2C", 0x20910345, 'U'},
+    {"CFG-UART1-DATABITS", 0x20520003, 'E'},
+    {"CFG-INFMSG-NMEA_I2C", 0x20920006, 'X'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSECEF_UART1", 0x2091002f, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGPS_USB", 0x20910543, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RF_I2C", 0x20910359, 'U'},
+    {"CFG-NMEA-FILT_BDS", 0x10930017, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_SBAS_USB", 0x20910503, 'U'},
+    {"CFG-SFODO-CNT_BOTH_EDGES", 0x1007000d, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_VELNED_SPI", 0x20910046, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGAL_I2C", 0x20910056, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_SFRBX_UART1", 0x20910232, 'U'},
+    {"CFG-TMODE-ECEF_Z_HP", 0x20030008, 'I'},
+    {"CFG-ITFM-CWTHRESHOLD", 0x20410002, 'U'},
+    {"CFG-TP-LEN_LOCK_TP1", 0x40050005, 'U'},
+    {"CFG-SIGNAL-BDS_B1_ENA", 0x1031000d, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_RELPOSNED_I2C", 0x2091008d, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SIG_SPI", 0x20910509, 'U'},
+    {"CFG-TMODE-LON_HP", 0x2003000d, 'I'},
+    {"CFG-MSGOUT-UBX_NAV_SIG_UART2", 0x20910347, 'U'},
+    {"CFG-SIGNAL-QZSS_L2C_ENA", 0x10310015, 'L'},
+    {"CFG-NAVSPG-USRDAT_ROTY", 0x40110068, 'R'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGAL_UART1", 0x20910057, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RLM_UART1", 0x2091025f, 'U'},
+    {"CFG-UART1OUTPROT-NMEA", 0x10740002, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_SAT_I2C", 0x20910015, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GLL_UART1", 0x209100ca, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_VLW_UART2", 0x209100e9, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_TP_I2C", 0x2091017d, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_DOP_USB", 0x20910468, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSLLH_UART2", 0x20910035, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1074_UART1", 0x2091035f, 'U'},
+    {"CFG-TP-LEN_LOCK_TP2", 0x40050010, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMELS_I2C", 0x20910060, 'U'},
+    {"CFG-USB-PRODUCT_STR3", 0x50650014, 'X'},
+    {"CFG-SBAS-USE_INTEGRITY", 0x10360005, 'L'},
+    {"CFG-MSGOUT-UBX_RXM_MEASX_UART1", 0x20910205, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_CLOCK_I2C", 0x20910430, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SVIN_UART2", 0x2091008a, 'U'},
+    {"CFG-PMP-CENTER_FREQUENCY", 0x40b10011, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GST_SPI", 0x209100d7, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GST_USB", 0x209100d6, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_ZDA_UART1", 0x209100d9, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GBS_UART2", 0x209100df, 'U'},
+    {"CFG-SFODO-SPEED_BAND", 0x3007000e, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSLLH_SPI", 0x2091002d, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE4072_0_I2C", 0x209102fe, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_ZDA_UART2", 0x209100da, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_INS_SPI", 0x20910118, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_POSECEF_UART2", 0x20910482, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW_SPI", 0x209101b8, 'U'},
+    {"CFG-SFIMU-IMU_MNTALG_YAW", 0x4006002d, 'U'},
+    {"CFG-SIGNAL-GLO_L2_ENA", 0x1031001a, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_SIG_USB", 0x20910348, 'U'},
+    {"CFG-USBOUTPROT-RTCM3X", 0x10780004, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_VELECEF_USB", 0x20910558, 'U'},
+    {"CFG-INFMSG-NMEA_UART1", 0x20920007, 'X'},
+    {"CFG-TXREADY-POLARITY", 0x10a20002, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_RMC_USB", 0x209100ae, 'U'},
+    {"CFG-INFMSG-NMEA_SPI", 0x2092000a, 'X'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGPS_SPI", 0x20910544, 'U'},
+    {"CFG-TP-SYNC_GNSS_TP1", 0x10050008, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_PVT_SPI", 0x2091000a, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GNS_SPI", 0x209100b9, 'U'},
+    {"CFG-HW-ANT_CFG_VOLTCTRL", 0x10a3002e, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSECEF_I2C", 0x2091002e, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW_UART2", 0x209101b6, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSECEF_I2C", 0x20910024, 'U'},
+    {"CFG-SPARTN-USE_SOURCE", 0x20a70001, 'E'},
+    {"CFG-UART1INPROT-SPARTN", 0x10730005, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_PVT_USB", 0x20910493, 'U'},
+    {"CFG-HW-ANT_CFG_PWRDOWN_POL", 0x10a30034, 'L'},
+    {"CFG-PM-UPDATEEPH", 0x10d0000a, 'L'},
+    {"CFG-MSGOUT-UBX_MON_SYS_USB", 0x209106a0, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSLLH_UART2", 0x2091002b, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYS_UART1", 0x209100f2, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1230_I2C", 0x20910303, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1127_SPI", 0x209102da, 'U'},
+    {"CFG-USB-POWER", 0x3065000c, 'U'},
+    {"CFG-NMEA-FILT_GLO", 0x10930016, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_EOE_USB", 0x20910568, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_DOP_UART2", 0x2091003a, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_VELNED_UART1", 0x20910043, 'U'},
+    {"CFG-SIGNAL-SBAS_L1CA_ENA", 0x10310005, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_VELECEF_UART2", 0x2091003f, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_DTM_I2C", 0x209100a6, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_VELNED_USB", 0x20910045, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMELS_SPI", 0x20910549, 'U'},
+    {"CFG-MSGOUT-UBX_MON_MSGPP_SPI", 0x2091019a, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SVIN_I2C", 0x20910088, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GGA_I2C", 0x209100ba, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RF_SPI", 0x2091035d, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_CLOCK_UART1", 0x20910431, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGLO_SPI", 0x20910539, 'U'},
+    {"CFG-USBINPROT-UBX", 0x10770001, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEUTC_UART2", 0x2091005d, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_EOE_USB", 0x20910162, 'U'},
+    {"CFG-PMP-USE_DESCRAMBLER", 0x10b10014, 'L'},
+    {"CFG-SFIMU-IMU_I2C_SCL_PIO", 0x2006001e, 'U'},
+    {"CFG-TP-TIMEGRID_TP2", 0x20050017, 'E'},
+    {"CFG-MSGOUT-UBX_NAV_ORB_SPI", 0x20910014, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_COR_USB", 0x209106b9, 'U'},
+    {"CFG-NAVSPG-INFIL_CNOTHRS", 0x201100ab, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_GEOFENCE_SPI", 0x209100a5, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_ORB_I2C", 0x20910010, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_INS_UART1", 0x20910115, 'U'},
+    {"CFG-USBOUTPROT-UBX", 0x10780001, 'L'},
+    {"CFG-MSGOUT-UBX_MON_HW2_USB", 0x209101bc, 'U'},
+    {"CFG-ODO-USE_COG", 0x10220002, 'L'},
+    {"CFG-RINV-BINARY", 0x10c70002, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_POSECEF_UART1", 0x20910025, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGPS_UART1", 0x20910048, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSLLH_USB", 0x2091002c, 'U'},
+    {"CFG-NMEA-FILT_QZSS", 0x10930015, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_AOPSTATUS_UART1", 0x2091007a, 'U'},
+    {"CFG-GEOFENCE-FENCE3_LON", 0x40240042, 'I'},
+    {"CFG-TP-PERIOD_LOCK_TP1", 0x40050003, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GST_UART1", 0x209100d4, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_VRFY_UART2", 0x20910094, 'U'},
+    {"CFG-TP-ALIGN_TO_TOW_TP1", 0x1005000a, 'L'},
+    {"CFG-UART2INPROT-SPARTN", 0x10750005, 'L'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1124_SPI", 0x20910371, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_MEASX_SPI", 0x20910208, 'U'},
+    {"CFG-GEOFENCE-FENCE1_LON", 0x40240022, 'I'},
+    {"CFG-MSGOUT-NMEA_ID_GLL_SPI", 0x209100cd, 'U'},
+    {"CFG-NMEA-FILT_GPS", 0x10930011, 'L'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GLL_UART1", 0x20910671, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1094_USB", 0x2091036b, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GSA_UART2", 0x20910668, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_RELPOSNED_SPI", 0x20910091, 'U'},
+    {"CFG-BATCH-PIOACTIVELOW", 0x10260018, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_SAT_UART2", 0x20910497, 'U'},
+    {"CFG-ODO-OUTLPCOG", 0x10220004, 'L'},
+    {"CFG-SIGNAL-SBAS_ENA", 0x10310020, 'L'},
+    {"CFG-MSGOUT-UBX_ESF_MEAS_UART2", 0x20910279, 'U'},
+    {"CFG-HW-ANT_SUP_OPEN_THR", 0x20a30056, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GGA_USB", 0x209100bd, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_RELPOSNED_USB", 0x20910090, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GSA_USB", 0x20910669, 'U'},
+    {"CFG-HW-ANT_SUP_OPEN_PIN", 0x20a30038, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSECEF_USB", 0x20910031, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYT_USB", 0x209100f9, 'U'},
+    {"CFG-INFMSG-NMEA_USB", 0x20920009, 'X'},
+    {"CFG-MSGOUT-UBX_ESF_MEAS_I2C", 0x20910277, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RAWX_I2C", 0x209102a4, 'U'},
+    {"CFG-BATCH-PIOID", 0x20260019, 'U'},
+    {"CFG-MSGOUT-PUBX_ID_POLYT_SPI", 0x209100fa, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1005_USB", 0x209102c0, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_GLL_I2C", 0x209100c9, 'U'},
+    {"CFG-SFIMU-GYRO_ACCURACY", 0x3006000b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGLO_UART2", 0x20910537, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RF_UART2", 0x2091035b, 'U'},
+    {"CFG-USB-SELFPOW", 0x10650002, 'L'},
+    {"CFG-USB-ENABLED", 0x10650001, 'L'},
+    {"CFG-GEOFENCE-FENCE4_RAD", 0x40240053, 'U'},
+    {"CFG-TXREADY-INTERFACE", 0x20a20005, 'E'},
+    {"CFG-MSGOUT-UBX_NAV_HPPOSLLH_SPI", 0x20910037, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SIG_UART1", 0x20910506, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_CLOCK_SPI", 0x20910434, 'U'},
+    {"CFG-MSGOUT-UBX_MON_SPAN_I2C", 0x2091038b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SAT_USB", 0x20910018, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_RAW_I2C", 0x2091029f, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_PVT_I2C", 0x20910006, 'U'},
+    {"CFG-QZSS-L6_MSGB", 0x20370060, 'E'},
+    {"CFG-MSGOUT-UBX_ESF_MEAS_SPI", 0x2091027b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_CLOCK_UART2", 0x20910432, 'U'},
+    {"CFG-ITFM-ANTSETTING", 0x20410010, 'E'},
+    {"CFG-I2C-ENABLED", 0x10510003, 'L'},
+    {"CFG-MSGOUT-UBX_NAV2_ODO_USB", 0x20910478, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSECEF_SPI", 0x20910028, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_VRFY_I2C", 0x20910092, 'U'},
+    {"CFG-SIGNAL-BDS_ENA", 0x10310022, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_SBAS_SPI", 0x2091006e, 'U'},
+    {"CFG-PM-MINACQTIME", 0x20d00006, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RAWX_SPI", 0x209102a8, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_EOE_SPI", 0x20910569, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_ZDA_USB", 0x20910682, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_VLW_UART1", 0x209100e8, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEQZSS_USB", 0x20910578, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_STATUS_SPI", 0x2091001e, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1087_USB", 0x209102d4, 'U'},
+    {"CFG-TXREADY-ENABLED", 0x10a20001, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_STATUS_UART1", 0x2091001b, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEGLO_UART1", 0x2091004d, 'U'},
+    {"CFG-MSGOUT-UBX_LOG_INFO_SPI", 0x2091025d, 'U'},
+    {"CFG-QZSS-SLAS_MAX_BASELINE", 0x30370008, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_ALG_UART2", 0x20910111, 'U'},
+    {"CFG-PM-EXTINTINACTIVE", 0x10d0000e, 'L'},
+    {"CFG-NMEA-LIMIT82", 0x10930005, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEBDS_UART2", 0x20910053, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_VTG_SPI", 0x2091065b, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_ALG_UART1", 0x20910110, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW2_UART1", 0x209101ba, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGPS_UART1", 0x20910541, 'U'},
+    {"CFG-I2CINPROT-UBX", 0x10710001, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_EOE_I2C", 0x2091015f, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_VELNED_USB", 0x20910563, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1077_UART2", 0x209102ce, 'U'},
+    {"CFG-MSGOUT-NMEA_ID_RMC_SPI", 0x209100af, 'U'},
+    {"CFG-TMODE-ECEF_Y_HP", 0x20030007, 'I'},
+    {"CFG-TP-TP2_ENA", 0x10050012, 'L'},
+    {"CFG-TMODE-HEIGHT", 0x4003000b, 'I'},
+    {"CFG-ITFM-ENABLE_AUX", 0x10410013, 'L'},
+    {"CFG-NMEA-SVNUMBERING", 0x20930007, 'E'},
+    {"CFG-UART2-PARITY", 0x20530004, 'E'},
+    {"CFG-SIGNAL-GPS_ENA", 0x1031001f, 'L'},
+    {"CFG-PM-POSUPDATEPERIOD", 0x40d00002, 'U'},
+    {"CFG-SFODO-DIS_AUTOCOUNTMAX", 0x10070004, 'L'},
+    {"CFG-RINV-CHUNK2", 0x50c70006, 'X'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GLL_SPI", 0x20910674, 'U'},
+    {"CFG-SFIMU-GYRO_RMSTHDL", 0x20060008, 'U'},
+    {"CFG-MSGOUT-UBX_MON_RF_USB", 0x2091035c, 'U'},
+    {"CFG-TP-PULSE_LENGTH_DEF", 0x20050030, 'E'},
+    {"CFG-MSGOUT-UBX_NAV_TIMEQZSS_UART2", 0x20910388, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_VELNED_I2C", 0x20910560, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_PL_UART2", 0x20910417, 'U'},
+    {"CFG-NMEA-OUT_INVTIME", 0x10930023, 'L'},
+    {"CFG-USBINPROT-SPARTN", 0x10770005, 'L'},
+    {"CFG-MSGOUT-UBX_ESF_ALG_USB", 0x20910112, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_PMP_SPI", 0x20910321, 'U'},
+    {"CFG-TP-USE_LOCKED_TP1", 0x10050009, 'L'},
+    {"CFG-GEOFENCE-USE_PIO", 0x10240012, 'L'},
+    {"CFG-SPI-ENABLED", 0x10640006, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_RLM_SPI", 0x20910404, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_RAWX_USB", 0x209102a7, 'U'},
+    {"CFG-SIGNAL-QZSS_L1S_ENA", 0x10310014, 'L'},
+    {"CFG-GEOFENCE-FENCE2_LAT", 0x40240031, 'I'},
+    {"CFG-MSGOUT-UBX_MON_RXBUF_SPI", 0x209101a4, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE4072_0_SPI", 0x20910302, 'U'},
+    {"CFG-HW-ANT_SUP_SHORT_THR", 0x20a30055, 'U'},
+    {"CFG-UART1OUTPROT-RTCM3X", 0x10740004, 'L'},
+    {"CFG-MSGOUT-UBX_NAV_SLAS_I2C", 0x20910336, 'U'},
+    {"CFG-MSGOUT-NMEA_NAV2_ID_GNS_I2C", 0x2091065c, 'U'},
+    {"CFG-NAVSPG-USRDAT_DY", 0x40110065, 'R'},
+    {"CFG-MSGOUT-UBX_NAV_ORB_USB", 0x20910013, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW_I2C", 0x209101b4, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_PVT_I2C", 0x20910490, 'U'},
+    {"CFG-MSGOUT-UBX_TIM_TP_USB", 0x20910180, 'U'},
+    {"CFG-MSGOUT-UBX_MON_HW2_SPI", 0x209101bd, 'U'},
+    {"CFG-SFODO-QUANT_ERROR", 0x40070008, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_TIMEGAL_UART2", 0x20910532, 'U'},
+    {"CFG-BATCH-EXTRAPVT", 0x1026001a, 'L'},
+    {"CFG-MSGOUT-NMEA_ID_GGA_UART1", 0x209100bb, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_STATUS_USB", 0x20910518, 'U'},
+    {"CFG-USBOUTPROT-NMEA", 0x10780002, 'L'},
+    {"CFG-ODO-COGLPGAIN", 0x20220032, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SVIN_UART2", 0x20910522, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SBAS_I2C", 0x2091006a, 'U'},
+    {"CFG-MSGOUT-UBX_ESF_STATUS_UART1", 0x20910106, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_PL_USB", 0x20910418, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_POSECEF_USB", 0x20910027, 'U'},
+    {"CFG-MSGOUT-UBX_NAV2_SAT_I2C", 0x20910495, 'U'},
+    {"CFG-MSGOUT-RTCM_3X_TYPE1074_UART2", 0x20910360, 'U'},
+    {"CFG-MSGOUT-UBX_MON_MSGPP_UART2", 0x20910198, 'U'},
+    {"CFG-NMEA-PROTVER", 0x20930001, 'E'},
+    {"CFG-MSGOUT-UBX_TIM_TM2_SPI", 0x2091017c, 'U'},
+    {"CFG-MSGOUT-UBX_NAV_SBAS_UART1", 0x2091006b, 'U'},
+    {"CFG-MSGOUT-UBX_RXM_SPARTN_SPI", 0x20910609, 'U'}
+};
+
+static const uint16_t gNameSeed[] = {
+    0, 11, 0, 17, 62, 7, 19, 5, 11, 18, 79, 0,
+    2, 3, 5, 6, 1, 6, 2, 1, 15, 3, 10, 14,
+    4, 0, 10, 3, 4, 8, 12, 0, 1, 6, 47, 52,
+    20, 1, 1, 13, 19, 26, 51, 50, 2, 7, 7, 0,
+    37, 6, 23, 0, 21, 1, 1, 37, 5, 41, 36, 3,
+    146, 29, 29, 1, 0, 10, 27, 28, 1, 204, 5, 6,
+    80, 17, 7, 3, 30, 3, 4, 29, 1, 6, 1, 55,
+    7, 29, 23, 187, 9, 44, 69, 1, 4, 8, 1, 22,
+    13, 4, 2, 9, 10, 2, 25, 3, 19, 5, 68, 11,
+    13, 1, 50, 4, 31, 41, 4, 1, 0, 11, 9, 32,
+    1, 30, 77, 19, 1, 42, 6, 30, 0, 4, 38, 33,
+    13, 14, 99, 60, 1, 31, 26, 6, 4, 12, 1, 3,
+    19, 9, 50, 1, 23, 16, 98, 1, 82, 13, 139, 15,
+    57, 7, 22, 14, 6, 2, 68, 87, 23, 14, 35, 27,
+    38, 9, 24, 15, 17, 2, 2, 25, 8, 5, 4, 16,
+    122, 38, 10, 92, 75, 57, 43, 5, 46, 12, 6, 28,
+    28, 123, 42, 59, 152, 114, 114, 46, 54, 24, 60, 72,
+    16, 48, 20, 90, 19, 8, 20, 5, 3, 1, 8, 4,
+    44, 273, 5, 1, 57, 9, 36, 47, 105, 3, 1, 46,
+    68, 26, 15, 444, 34, 53, 91, 24, 1, 25, 4, 61,
+    183, 33, 38, 21, 131, 16, 0, 6, 32, 1, 421, 14,
+    33, 305, 115, 0, 56, 404, 6, 10, 301, 170, 34, 0,
+    238, 8, 13, 52, 70, 106, 484, 113, 140, 80, 42, 12,
+    20, 1, 59, 62, 0, 2, 140, 330, 319, 8, 4, 7,
+    45, 247, 4, 85, 5, 19, 138, 0, 172, 0, 324, 439,
+    452, 799, 161, 2152, 6, 98, 4, 358, 378, 35, 25, 0,
+    17, 28, 58, 154, 232, 6, 117, 27
+};
+
+static const uint16_t gIdSeed[] = {
+    7, 6, 30, 6, 5, 76, 0, 13, 7, 18, 7, 9,
+    9, 18, 5, 1, 53, 6, 2, 41, 0, 2, 15, 48,
+    2, 19, 6, 2, 58, 4, 44, 1, 5, 2, 10, 4,
+    19, 3, 0, 2, 4, 1, 5, 56, 3, 0, 4, 60,
+    3, 13, 5, 23, 10, 12, 1, 4, 1, 83, 6, 11,
+    37, 4, 11, 49, 41, 3, 7, 29, 0, 24, 15, 12,
+    5, 6, 12, 36, 0, 3, 43, 8, 9, 57, 18, 0,
+    5, 0, 20, 4, 5, 21, 9, 37, 11, 18, 30, 3,
+    15, 1, 7, 48, 13, 0, 0, 5, 124, 30, 4, 69,
+    7, 95, 106, 71, 3, 2, 23, 6, 1, 8, 94, 59,
+    9, 6, 13, 0, 53, 24, 3, 28, 16, 1, 1, 31,
+    48, 2, 5, 8, 33, 16, 7, 10, 119, 107, 14, 36,
+    5, 9, 2, 49, 25, 8, 11, 2, 63, 7, 38, 24,
+    17, 19, 2, 77, 1, 11, 10, 2, 96, 1, 57, 2,
+    12, 1, 2, 1, 123, 15, 109, 11, 8, 4, 85, 25,
+    4, 8, 0, 21, 2, 21, 19, 122, 64, 128, 129, 0,
+    39, 17, 6, 10, 76, 57, 1, 173, 10, 0, 67, 6,
+    30, 0, 72, 61, 6, 33, 3, 0, 74, 28, 3, 42,
+    69, 35, 21, 13, 143, 43, 2, 223, 5, 8, 78, 17,
+    151, 18, 3, 191, 26, 2, 27, 38, 57, 1, 72, 2,
+    1, 49, 23, 67, 48, 48, 7, 257, 84, 13, 9, 99,
+    94, 2, 0, 163, 71, 30, 1, 261, 372, 4, 253, 16,
+    49, 161, 69, 156, 127, 25, 3, 0, 42, 2, 94, 42,
+    217, 134, 1, 13, 47, 45, 60, 184, 6, 5, 25, 13,
+    22, 77, 13, 531, 2, 145, 10, 47, 334, 3, 19, 147,
+    40, 142, 404, 33, 52, 5, 0, 163, 5, 1, 1, 2,
+    90, 2, 10, 395, 186, 164, 0, 303
+};
+
+static const uint16_t gIdIndex[] = {
+    948, 38, 618, 195, 566, 841, 410, 69, 799, 533, 90, 415,
+    467, 56, 696, 686, 908, 357, 665, 918, 440, 510, 434, 421,
+    530, 133, 224, 750, 165, 735, 790, 273, 160, 329, 798, 725,
+    269, 214, 957, 28, 633, 405, 122, 351, 8, 86, 188, 672,
+    761, 80, 346, 653, 834, 509, 615, 219, 78, 866, 54, 51,
+    604, 5, 775, 622, 229, 626, 64, 103, 400, 679, 238, 466,
+    490, 498, 842, 742, 700, 587, 582, 345, 181, 354, 800, 608,
+    230, 922, 517, 125, 744, 682, 749, 789, 12, 319, 824, 832,
+    460, 731, 87, 639, 443, 607, 693, 83, 375, 515, 610, 399,
+    241, 403, 111, 373, 694, 697, 409, 728, 374, 263, 196, 504,
+    573, 813, 874, 941, 495, 767, 907, 526, 145, 34, 63, 159,
+    17, 563, 296, 837, 710, 598, 378, 202, 99, 839, 454, 774,
+    217, 379, 708, 476, 383, 407, 9, 350, 843, 291, 58, 244,
+    840, 699, 187, 581, 117, 649, 119, 847, 458, 905, 1, 477,
+    716, 856, 575, 525, 314, 127, 778, 723, 772, 50, 826, 294,
+    428, 931, 427, 528, 479, 548, 879, 781, 505, 101, 150, 336,
+    871, 719, 936, 464, 508, 242, 457, 706, 924, 13, 120, 733,
+    763, 765, 94, 261, 880, 46, 838, 770, 836, 220, 134, 453,
+    711, 290, 284, 491, 297, 23, 937, 659, 408, 174, 151, 192,
+    279, 507, 492, 707, 251, 814, 193, 371, 630, 797, 254, 889,
+    84, 82, 221, 544, 95, 19, 135, 72, 888, 442, 359, 791,
+    207, 642, 829, 786, 875, 68, 7, 534, 870, 760, 225, 153,
+    366, 21, 612, 903, 571, 15, 560, 293, 474, 722, 62, 556,
+    381, 320, 256, 137, 660, 628, 489, 168, 55, 782, 352, 14,
+    954, 958, 574, 162, 112, 446, 545, 739, 456, 246, 551, 142,
+    656, 235, 20, 769, 846, 114, 2, 869, 305, 506, 347, 116,
+    634, 392, 353, 422, 452, 139, 432, 627, 105, 516, 902, 524,
+    554, 396, 801, 227, 71, 267, 828, 859, 736, 161, 358, 746,
+    144, 897, 625, 737, 921, 890, 149, 204, 130, 569, 669, 16,
+    113, 312, 603, 301, 335, 944, 784, 751, 248, 539, 426, 110,
+    190, 126, 867, 923, 714, 486, 289, 792, 228, 77, 715, 292,
+    601, 175, 89, 213, 156, 384, 226, 285, 950, 413, 342, 586,
+    271, 873, 747, 265, 24, 488, 914, 521, 613, 785, 431, 385,
+    148, 412, 662, 685, 321, 951, 348, 364, 827, 878, 645, 620,
+    308, 884, 470, 316, 262, 865, 745, 91, 171, 414, 200, 589,
+    35, 718, 684, 257, 441, 855, 609, 404, 469, 389, 270, 313,
+    480, 780, 26, 862, 720, 420, 75, 635, 519, 689, 376, 485,
+    564, 438, 4, 946, 322, 411, 166, 619, 692, 532, 93, 547,
+    325, 42, 940, 326, 280, 332, 445, 447, 212, 885, 864, 681,
+    140, 777, 513, 177, 430, 29, 567, 163, 66, 333, 794, 904,
+    85, 302, 788, 930, 482, 388, 512, 881, 310, 53, 809, 698,
+    680, 953, 300, 702, 695, 943, 275, 487, 640, 657, 606, 41,
+    647, 341, 429, 816, 274, 52, 835, 743, 232, 831, 894, 33,
+    676, 340, 949, 712, 703, 520, 102, 73, 243, 180, 173, 401,
+    494, 390, 183, 236, 118, 107, 450, 588, 179, 57, 303, 288,
+    3, 45, 593, 468, 367, 484, 48, 748, 318, 561, 255, 683,
+    281, 701, 868, 911, 167, 96, 386, 315, 596, 807, 478, 356,
+    536, 208, 199, 688, 258, 154, 210, 910, 550, 344, 849, 891,
+    138, 463, 449, 309, 387, 264, 803, 570, 691, 343, 614, 511,
+    185, 471, 651, 690, 131, 25, 546, 286, 223, 455, 597, 631,
+    821, 419, 324, 579, 578, 721, 822, 886, 667, 887, 671, 724,
+    451, 128, 540, 793, 184, 268, 915, 331, 164, 277, 205, 557,
+    363, 423, 621, 933, 247, 648, 617, 234, 804, 562, 752, 901,
+    306, 65, 664, 10, 658, 912, 240, 851, 580, 109, 758, 37,
+    585, 27, 465, 938, 61, 762, 360, 848, 59, 298, 677, 123,
+    39, 523, 158, 370, 398, 176, 182, 402, 833, 79, 652, 753,
+    497, 812, 732, 473, 6, 623, 709, 939, 802, 253, 218, 644,
+    31, 740, 115, 43, 327, 845, 819, 98, 157, 338, 583, 121,
+    136, 233, 216, 727, 755, 337, 768, 952, 555, 825, 535, 18,
+    362, 637, 67, 945, 674, 97, 850, 896, 201, 675, 538, 877,
+    808, 795, 817, 391, 559, 393, 920, 152, 806, 942, 222, 141,
+    913, 424, 673, 245, 541, 365, 433, 705, 668, 330, 611, 36,
+    231, 503, 646, 172, 584, 197, 592, 30, 543, 863, 853, 572,
+    215, 796, 295, 815, 416, 730, 595, 955, 481, 549, 307, 439,
+    339, 522, 518, 531, 636, 956, 317, 106, 729, 899, 935, 311,
+    100, 170, 334, 663, 650, 493, 917, 194, 552, 70, 155, 882,
+    616, 916, 252, 44, 771, 60, 394, 382, 237, 934, 483, 372,
+    854, 283, 417, 249, 600, 189, 830, 565, 74, 734, 459, 861,
+    919, 328, 448, 475, 783, 638, 437, 211, 893, 741, 514, 773,
+    501, 250, 499, 666, 500, 757, 641, 553, 895, 726, 129, 272,
+    22, 287, 810, 713, 678, 756, 766, 169, 47, 444, 860, 764,
+    496, 239, 805, 323, 906, 643, 191, 883, 369, 397, 655, 898,
+    558, 355, 406, 594, 76, 852, 932, 759, 577, 872, 502, 276,
+    818, 368, 349, 186, 670, 591, 124, 909, 823, 361, 209, 527,
+    104, 88, 203, 776, 461, 304, 435, 858, 260, 576, 537, 629,
+    599, 654, 787, 436, 811, 425, 198, 857, 844, 146, 779, 529,
+    206, 892, 542, 929, 876, 380, 632, 278, 602, 32, 900, 925,
+    40, 259, 472, 568, 132, 605, 81, 49, 717, 927, 661, 0,
+    282, 147, 377, 395, 590, 704, 418, 947, 299, 108, 462, 928,
+    266, 11, 687, 820, 92, 624, 754, 143, 926, 178, 738
+};
+
+// *** DO NOT MODIFY THIS LINE OR ABOVE: DO NOT MODIFY AREA ENDS ***
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Seeded FNV-1a with a final mix, over pData or, if pData is NULL,
+// over the four bytes of value, least significant first; this MUST
+// match hash() in u_gnss_cfg_val_key.py.
+static uint32_t hash(const char *pData, uint32_t value, uint32_t seed)
+{
+    uint32_t h = 0x811c9dc5U ^ (seed * 0x9e3779b9U);
+
+    if (pData != NULL) {
+        while (*pData != 0) {
+            h = (h ^ (uint8_t) *pData) * 0x01000193U;
+            pData++;
+        }
+    } else {
+        for (size_t x = 0; x < 4; x++) {
+            h = (h ^ (value & 0xFF)) * 0x01000193U;
+            value >>= 8;
+        }
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+
+    return h;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Find a key by name.
+const uGnssCfgValKeyName_t *pUGnssCfgValKeyNameFind(const char *pName)
+{
+    const uGnssCfgValKeyName_t *pKeyName = NULL;
+    uint32_t seed;
+
+    if (pName != NULL) {
+        seed = gNameSeed[hash(pName, 0, 0) % U_GNSS_CFG_VAL_KEY_NAME_ARRAY_SIZE(gNameSeed)];
+        pKeyName = &(gKeyName[hash(pName, 0, seed) % U_GNSS_CFG_VAL_KEY_NAME_ARRAY_SIZE(gKeyName)]);
+        // The hash puts any name somewhere, so check it
+        if (strcmp(pKeyName->pName, pName) != 0) {
+            pKeyName = NULL;
+        }
+    }
+
+    return pKeyName;
+}
+
+// Find a key by key ID.
+const uGnssCfgValKeyName_t *pUGnssCfgValKeyNameFindId(uint32_t keyId)
+{
+    const uGnssCfgValKeyName_t *pKeyName;
+    uint32_t seed;
+
+    seed = gIdSeed[hash(NULL, keyId, 0) % U_GNSS_CFG_VAL_KEY_NAME_ARRAY_SIZE(gIdSeed)];
+    pKeyName = &(gKeyName[gIdIndex[hash(NULL, keyId, seed) %
+                                   U_GNSS_CFG_VAL_KEY_NAME_ARRAY_SIZE(gIdIndex)]]);
+    if (pKeyName->keyId != keyId) {
+        pKeyName = NULL;
+    }
+
+    return pKeyName;
+}
+
+// End of file
@@ -0,0 +1,667 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief This source file contains the implementation of the
+ * correction-data functions of the GNSS API.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset(), memcpy(), memmove()
+
+#include "u_cfg_os_platform_specific.h"
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_event_queue.h"
+
+#include "u_device.h"
+#include "u_sock.h"
+#include "u_mqtt_common.h"
+#include "u_mqtt_client.h"
+
+#include "u_spartn.h"
+#include "u_spartn_crc.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss_msg.h"
+#include "u_gnss_correction.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_GNSS_CORRECTION_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that reads data from a socket
+ * bound with uGnssCorrectionBindSock().
+ */
+# define U_GNSS_CORRECTION_TASK_STACK_SIZE_BYTES 2304
+#endif
+
+#ifndef U_GNSS_CORRECTION_TASK_PRIORITY
+/** The priority of the task that reads data from a socket
+ * bound with uGnssCorrectionBindSock().
+ */
+# define U_GNSS_CORRECTION_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+#ifndef U_GNSS_CORRECTION_EVENT_QUEUE_LENGTH
+/** The length of the event queue used to wake up the task that
+ * reads data from a socket; since each event causes all of the
+ * data waiting on the socket to be read, this need not be long.
+ */
+# define U_GNSS_CORRECTION_EVENT_QUEUE_LENGTH 2
+#endif
+
+/** The first byte of a SPARTN message.
+ */
+#define U_GNSS_CORRECTION_SPARTN_PREAMBLE 0x73
+
+/** The first byte of an RTCM3 message.
+ */
+#define U_GNSS_CORRECTION_RTCM_PREAMBLE 0xd3
+
+/** The number of bytes of header plus CRC in an RTCM3 message.
+ */
+#define U_GNSS_CORRECTION_RTCM_OVERHEAD_BYTES (3 + 3)
+
+/** The number of bytes that is enough to determine the length
+ * of any SPARTN or RTCM3 message.
+ */
+#define U_GNSS_CORRECTION_HEADER_MAX_LENGTH_BYTES 16
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A correction pipeline.
+ */
+typedef struct {
+    uDeviceHandle_t gnssHandle;
+    uint32_t protocolBitmap;
+    uPortMutexHandle_t mutex;
+    char *pBuffer;
+    size_t bufferLengthBytes;
+    size_t bufferedBytes; /**< the amount of data held in pBuffer, always
+                               from the start of a (partial) message. */
+    size_t bufferNeeded;  /**< the length of the message in pBuffer, zero
+                               if not yet known. */
+    uMqttClientContext_t *pMqttContext;
+    const char *pTopicFilterStr;
+    uSockDescriptor_t sockDescriptor;
+    int32_t eventQueueHandle;
+    uGnssCorrectionStats_t stats;
+} uGnssCorrectionContext_t;
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Find the first candidate message at or after the start of pBuffer;
+// *ppMessage is set to the candidate and *pProtocol to its protocol.
+// Returns the length of the candidate message (which may be larger
+// than the data available), U_ERROR_COMMON_TIMEOUT if there may be
+// a message at *ppMessage but there is not yet enough data to tell
+// how long it is, or U_ERROR_COMMON_NOT_FOUND if there is no
+// candidate at all.
+static int32_t candidateFind(uint32_t protocolBitmap,
+                             const char *pBuffer, size_t size,
+                             const char **ppMessage,
+                             uGnssCorrectionProtocol_t *pProtocol)
+{
+    int32_t lengthOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+    int32_t x;
+    const char *pSpartn = NULL;
+    const uint8_t *pRtcm = NULL;
+    const char *pEnd = pBuffer + size;
+
+    if ((protocolBitmap & U_GNSS_CORRECTION_PROTOCOL_SPARTN) != 0) {
+        // Let the SPARTN code find the first frame start that passes
+        // its header CRC; if it can't decide because the data stops
+        // part way through a header then the undecided frame start
+        // must be within the last few bytes, since any before that
+        // would have been decided, so take the first preamble byte
+        // there as the candidate
+        x = uSpartnDetect(pBuffer, size, &pSpartn);
+        if (x >= 0) {
+            lengthOrErrorCode = x;
+            *ppMessage = pSpartn;
+            *pProtocol = U_GNSS_CORRECTION_PROTOCOL_SPARTN;
+        } else if (x == (int32_t) U_ERROR_COMMON_TIMEOUT) {
+            x = 0;
+            if (size > U_GNSS_CORRECTION_HEADER_MAX_LENGTH_BYTES) {
+                x = size - U_GNSS_CORRECTION_HEADER_MAX_LENGTH_BYTES;
+            }
+            pSpartn = (const char *) memchr(pBuffer + x, U_GNSS_CORRECTION_SPARTN_PREAMBLE,
+                                            size - x);
+            if (pSpartn != NULL) {
+                lengthOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                *ppMessage = pSpartn;
+                *pProtocol = U_GNSS_CORRECTION_PROTOCOL_SPARTN;
+            }
+        }
+        if (pSpartn != NULL) {
+            // No need to look for RTCM beyond here
+            pEnd = pSpartn;
+        }
+    }
+
+    if ((protocolBitmap & U_GNSS_CORRECTION_PROTOCOL_RTCM) != 0) {
+        // An RTCM3 message is 0xd3, six zero bits, a ten-bit length,
+        // then the body and a three byte CRC
+        for (const uint8_t *pTmp = (const uint8_t *) pBuffer;
+             (pRtcm == NULL) && (pTmp < (const uint8_t *) pEnd); pTmp++) {
+            if (*pTmp == U_GNSS_CORRECTION_RTCM_PREAMBLE) {
+                if ((const char *) pTmp + 3 > pBuffer + size) {
+                    pRtcm = pTmp;
+                    lengthOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                } else if ((*(pTmp + 1) & 0xfc) == 0) {
+                    pRtcm = pTmp;
+                    lengthOrErrorCode = (int32_t) (((((size_t) * (pTmp + 1)) & 0x03) << 8) +
+                                                   *(pTmp + 2) +
+                                                   U_GNSS_CORRECTION_RTCM_OVERHEAD_BYTES);
+                }
+            }
+        }
+        if (pRtcm != NULL) {
+            *ppMessage = (const char *) pRtcm;
+            *pProtocol = U_GNSS_CORRECTION_PROTOCOL_RTCM;
+        }
+    }
+
+    return lengthOrErrorCode;
+}
+
+// Check that a complete candidate message is valid.
+static bool messageIsValid(const char *pMessage, size_t size,
+                           uGnssCorrectionProtocol_t protocol)
+{
+    bool isValid = false;
+    const char *pTmp = NULL;
+    const uint8_t *pCrc;
+
+    switch (protocol) {
+        case U_GNSS_CORRECTION_PROTOCOL_SPARTN:
+            isValid = (uSpartnValidate(pMessage, size, &pTmp) == (int32_t) size) &&
+                      (pTmp == pMessage);
+            break;
+        case U_GNSS_CORRECTION_PROTOCOL_RTCM:
+            // RTCM3 uses CRC-24Q, which is the same as the SPARTN CRC-24,
+            // over the header and body, MSB first
+            pCrc = (const uint8_t *) pMessage + size - 3;
+            isValid = (uSpartnCrc24(pMessage, size - 3) ==
+                       ((((uint32_t) * pCrc) << 16) +
+                        (((uint32_t) * (pCrc + 1)) << 8) +
+                        ((uint32_t) * (pCrc + 2))));
+            break;
+        default:
+            break;
+    }
+
+    return isValid;
+}
+
+// Send a message to the GNSS chip in chunks.
+static void messageSend(uGnssCorrectionContext_t *pContext,
+                        const char *pMessage, size_t size,
+                        uGnssCorrectionProtocol_t protocol)
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    size_t offset = 0;
+    size_t thisSize;
+    bool keepGoing = true;
+
+    while (keepGoing && (offset < size)) {
+        thisSize = size - offset;
+        if (thisSize > U_GNSS_CORRECTION_CHUNK_LENGTH_BYTES) {
+            thisSize = U_GNSS_CORRECTION_CHUNK_LENGTH_BYTES;
+        }
+        keepGoing = (uGnssMsgSend(pContext->gnssHandle, pMessage + offset,
+                                  thisSize) == (int32_t) thisSize);
+        if (keepGoing) {
+            offset += thisSize;
+        }
+    }
+    pContext->stats.bytesForwarded += offset;
+    pContext->stats.bytesDiscarded += size - offset;
+    if (keepGoing) {
+        if (protocol == U_GNSS_CORRECTION_PROTOCOL_SPARTN) {
+            pContext->stats.messagesSpartn++;
+        } else {
+            pContext->stats.messagesRtcm++;
+        }
+    } else {
+        pContext->stats.sendFailures++;
+    }
+    if (uPortGetTickTimeMs() - startTimeMs > pContext->stats.sendTimeMaxMs) {
+        pContext->stats.sendTimeMaxMs = uPortGetTickTimeMs() - startTimeMs;
+    }
+}
+
+// Forward all of the complete, valid, messages in the given data to
+// the GNSS chip, straight from where they are.  Returns the number of
+// bytes of pData that have been dealt with: anything from there on is
+// the start of a message that has not been completely received.  If
+// pNeeded is not NULL then it is set to the number of bytes the
+// remaining message is known to need, zero if that is not yet known.
+// Note: the mutex of the pipeline should be locked before this is called.
+static size_t frameAndForward(uGnssCorrectionContext_t *pContext,
+                              const char *pData, size_t size,
+                              size_t *pNeeded)
+{
+    const char *pStart = pData;
+    const char *pMessage = NULL;
+    uGnssCorrectionProtocol_t protocol = U_GNSS_CORRECTION_PROTOCOL_SPARTN;
+    int32_t x;
+    bool keepGoing = true;
+
+    if (pNeeded != NULL) {
+        *pNeeded = 0;
+    }
+    while (keepGoing && (size > 0)) {
+        x = candidateFind(pContext->protocolBitmap, pData, size,
+                          &pMessage, &protocol);
+        if (x == (int32_t) U_ERROR_COMMON_NOT_FOUND) {
+            // Nothing of interest
+            pContext->stats.bytesDiscarded += size;
+            pData += size;
+            size = 0;
+        } else {
+            // Skip anything before the candidate
+            pContext->stats.bytesDiscarded += pMessage - pData;
+            size -= pMessage - pData;
+            pData = pMessage;
+            if ((x > 0) && ((size_t) x <= size)) {
+                // It's all here: check it
+                if (messageIsValid(pMessage, x, protocol)) {
+                    messageSend(pContext, pMessage, x, protocol);
+                    pData += x;
+                    size -= x;
+                } else {
+                    // Not valid, move past the preamble byte and
+                    // look again
+                    pContext->stats.messagesBad++;
+                    pContext->stats.bytesDiscarded++;
+                    pData++;
+                    size--;
+                }
+            } else if ((x > 0) && ((size_t) x > pContext->bufferLengthBytes)) {
+                // It can never fit into the buffer, give up on it
+                pContext->stats.messagesBad++;
+                pContext->stats.bytesDiscarded++;
+                pData++;
+                size--;
+            } else {
+                // Need more data
+                if ((pNeeded != NULL) && (x > 0)) {
+                    *pNeeded = x;
+                }
+                keepGoing = false;
+            }
+        }
+    }
+
+    return (size_t) (pData - pStart);
+}
+
+// Frame the contents of the buffer of the pipeline, forward what can
+// be forwarded and shuffle what is left down to the start of the
+// buffer, updating bufferNeeded.
+// Note: the mutex of the pipeline should be locked before this is called.
+static void bufferFrameAndForward(uGnssCorrectionContext_t *pContext)
+{
+    size_t consumed;
+
+    consumed = frameAndForward(pContext, pContext->pBuffer,
+                               pContext->bufferedBytes,
+                               &(pContext->bufferNeeded));
+    pContext->bufferedBytes -= consumed;
+    if ((consumed > 0) && (pContext->bufferedBytes > 0)) {
+        // Only ever the start of one message, so not a big move
+        memmove(pContext->pBuffer, pContext->pBuffer + consumed,
+                pContext->bufferedBytes);
+    }
+    if (pContext->bufferedBytes >= pContext->bufferLengthBytes) {
+        // Can't happen since frameAndForward() won't wait for
+        // a message longer than the buffer but, just in case,
+        // make sure we can't get stuck with a full buffer
+        pContext->stats.bytesDiscarded += pContext->bufferedBytes;
+        pContext->bufferedBytes = 0;
+        pContext->bufferNeeded = 0;
+    }
+}
+
+// Note the buffer usage of the pipeline in the statistics.
+// Note: the mutex of the pipeline should be locked before this is called.
+static void bufferStatsUpdate(uGnssCorrectionContext_t *pContext)
+{
+    pContext->stats.bufferedBytes = pContext->bufferedBytes;
+    if (pContext->bufferedBytes > pContext->stats.bufferHighWaterMark) {
+        pContext->stats.bufferHighWaterMark = pContext->bufferedBytes;
+    }
+}
+
+// Process data from outside the pipeline.  Messages wholly inside
+// pData are forwarded from pData; only a message that straddles the
+// end of pData, or began in an earlier call, is copied into the
+// buffer of the pipeline, and then only as much of it as is needed
+// to complete it.
+// Note: the mutex of the pipeline should be locked before this is called.
+static void process(uGnssCorrectionContext_t *pContext,
+                    const char *pData, size_t size)
+{
+    size_t thisSize;
+    size_t consumed;
+
+    pContext->stats.bytesReceived += size;
+    while (size > 0) {
+        if (pContext->bufferedBytes > 0) {
+            // Top up the partial message in the buffer with
+            // just enough to complete it, or to find out how
+            // long it is
+            if (pContext->bufferNeeded > pContext->bufferedBytes) {
+                thisSize = pContext->bufferNeeded - pContext->bufferedBytes;
+            } else {
+                thisSize = U_GNSS_CORRECTION_HEADER_MAX_LENGTH_BYTES;
+            }
+            if (thisSize > size) {
+                thisSize = size;
+            }
+            if (thisSize > pContext->bufferLengthBytes - pContext->bufferedBytes) {
+                thisSize = pContext->bufferLengthBytes - pContext->bufferedBytes;
+            }
+            memcpy(pContext->pBuffer + pContext->bufferedBytes, pData, thisSize);
+            pContext->bufferedBytes += thisSize;
+            pData += thisSize;
+            size -= thisSize;
+            bufferStatsUpdate(pContext);
+            bufferFrameAndForward(pContext);
+        } else {
+            // Nothing in the buffer: forward straight from pData
+            consumed = frameAndForward(pContext, pData, size, NULL);
+            pData += consumed;
+            size -= consumed;
+            if (size > 0) {
+                // The start of a message is left, which will be less
+                // than the length of the buffer, keep hold of it
+                thisSize = size;
+                if (thisSize > pContext->bufferLengthBytes) {
+                    thisSize = pContext->bufferLengthBytes;
+                }
+                memcpy(pContext->pBuffer, pData, thisSize);
+                pContext->bufferedBytes = thisSize;
+                pData += thisSize;
+                size -= thisSize;
+                bufferStatsUpdate(pContext);
+                bufferFrameAndForward(pContext);
+            }
+        }
+    }
+    bufferStatsUpdate(pContext);
+}
+
+// Handler for the MQTT route of a pipeline.
+static void mqttHandler(uMqttClientContext_t *pMqttContext,
+                        const char *pTopicNameStr,
+                        const char *pMessage, size_t messageSizeBytes,
+                        uMqttQos_t qos, void *pParam)
+{
+    uGnssCorrectionContext_t *pContext = (uGnssCorrectionContext_t *) pParam;
+
+    (void) pMqttContext;
+    (void) pTopicNameStr;
+    (void) qos;
+
+    U_PORT_MUTEX_LOCK(pContext->mutex);
+    process(pContext, pMessage, messageSizeBytes);
+    U_PORT_MUTEX_UNLOCK(pContext->mutex);
+}
+
+// Event handler for a socket bound to a pipeline: read all of the
+// data waiting on the socket straight into the buffer and forward it.
+static void sockEventHandler(void *pParam, size_t paramLength)
+{
+    uGnssCorrectionContext_t *pContext = *((uGnssCorrectionContext_t **) pParam);
+    int32_t x;
+
+    (void) paramLength;
+
+    U_PORT_MUTEX_LOCK(pContext->mutex);
+
+    do {
+        x = uSockRead(pContext->sockDescriptor,
+                      pContext->pBuffer + pContext->bufferedBytes,
+                      pContext->bufferLengthBytes - pContext->bufferedBytes);
+        if (x > 0) {
+            pContext->stats.bytesReceived += x;
+            pContext->bufferedBytes += x;
+            bufferStatsUpdate(pContext);
+            bufferFrameAndForward(pContext);
+            bufferStatsUpdate(pContext);
+        }
+    } while (x > 0);
+
+    U_PORT_MUTEX_UNLOCK(pContext->mutex);
+}
+
+// Data callback for a socket bound to a pipeline: this is called
+// from the socket layer so just wake up sockEventHandler().
+static void sockDataCallback(void *pParam)
+{
+    uGnssCorrectionContext_t *pContext = (uGnssCorrectionContext_t *) pParam;
+
+    uPortEventQueueSend(pContext->eventQueueHandle, &pContext, sizeof(pContext));
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Open a correction pipeline.
+int32_t uGnssCorrectionOpen(uDeviceHandle_t gnssHandle,
+                            uint32_t protocolBitmap,
+                            size_t bufferLengthBytes,
+                            uGnssCorrectionHandle_t *pHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssCorrectionContext_t *pContext;
+
+    if (bufferLengthBytes == 0) {
+        bufferLengthBytes = U_GNSS_CORRECTION_BUFFER_LENGTH_BYTES;
+    }
+    if ((gnssHandle != NULL) && (pHandle != NULL) &&
+        ((protocolBitmap & U_GNSS_CORRECTION_PROTOCOL_ALL) != 0) &&
+        ((protocolBitmap & ~U_GNSS_CORRECTION_PROTOCOL_ALL) == 0) &&
+        (bufferLengthBytes >= U_GNSS_CORRECTION_HEADER_MAX_LENGTH_BYTES)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        // Allocate the context and buffer in one go
+        pContext = (uGnssCorrectionContext_t *) malloc(sizeof(*pContext) + bufferLengthBytes);
+        if (pContext != NULL) {
+            memset(pContext, 0, sizeof(*pContext));
+            pContext->gnssHandle = gnssHandle;
+            pContext->protocolBitmap = protocolBitmap;
+            pContext->pBuffer = ((char *) pContext) + sizeof(*pContext);
+            pContext->bufferLengthBytes = bufferLengthBytes;
+            pContext->sockDescriptor = -1;
+            pContext->eventQueueHandle = -1;
+            errorCode = uPortMutexCreate(&(pContext->mutex));
+            if (errorCode == 0) {
+                *pHandle = (uGnssCorrectionHandle_t) pContext;
+            } else {
+                free(pContext);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Bind a correction pipeline to an MQTT topic filter.
+int32_t uGnssCorrectionBindMqtt(uGnssCorrectionHandle_t handle,
+                                uMqttClientContext_t *pMqttContext,
+                                const char *pTopicFilterStr)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssCorrectionContext_t *pContext = (uGnssCorrectionContext_t *) handle;
+
+    if ((pContext != NULL) && (pMqttContext != NULL) && (pTopicFilterStr != NULL)) {
+
+        U_PORT_MUTEX_LOCK(pContext->mutex);
+
+        if (pContext->pMqttContext == NULL) {
+            errorCode = uMqttClientRouteAdd(pMqttContext, pTopicFilterStr,
+                                            mqttHandler, pContext);
+            if (errorCode == 0) {
+                pContext->pMqttContext = pMqttContext;
+                pContext->pTopicFilterStr = pTopicFilterStr;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(pContext->mutex);
+    }
+
+    return errorCode;
+}
+
+// Bind a correction pipeline to a socket.
+int32_t uGnssCorrectionBindSock(uGnssCorrectionHandle_t handle,
+                                uSockDescriptor_t descriptor)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssCorrectionContext_t *pContext = (uGnssCorrectionContext_t *) handle;
+
+    if ((pContext != NULL) && (descriptor >= 0)) {
+
+        U_PORT_MUTEX_LOCK(pContext->mutex);
+
+        if (pContext->sockDescriptor < 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (pContext->eventQueueHandle < 0) {
+                errorCode = uPortEventQueueOpen(sockEventHandler,
+                                                "gnssCorrection",
+                                                sizeof(uGnssCorrectionContext_t *),
+                                                U_GNSS_CORRECTION_TASK_STACK_SIZE_BYTES,
+                                                U_GNSS_CORRECTION_TASK_PRIORITY,
+                                                U_GNSS_CORRECTION_EVENT_QUEUE_LENGTH);
+                if (errorCode >= 0) {
+                    pContext->eventQueueHandle = errorCode;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+            if (errorCode == 0) {
+                pContext->sockDescriptor = descriptor;
+                uSockBlockingSet(descriptor, false);
+                uSockRegisterCallbackData(descriptor, sockDataCallback, pContext);
+                // Data may already be waiting
+                uPortEventQueueSend(pContext->eventQueueHandle,
+                                    &pContext, sizeof(pContext));
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(pContext->mutex);
+    }
+
+    return errorCode;
+}
+
+// Pass correction data into a pipeline.
+int32_t uGnssCorrectionInput(uGnssCorrectionHandle_t handle,
+                             const char *pData, size_t size)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssCorrectionContext_t *pContext = (uGnssCorrectionContext_t *) handle;
+    size_t bytesForwarded;
+
+    if ((pContext != NULL) && (pData != NULL)) {
+
+        U_PORT_MUTEX_LOCK(pContext->mutex);
+
+        bytesForwarded = pContext->stats.bytesForwarded;
+        process(pContext, pData, size);
+        errorCodeOrLength = (int32_t) (pContext->stats.bytesForwarded - bytesForwarded);
+
+        U_PORT_MUTEX_UNLOCK(pContext->mutex);
+    }
+
+    return errorCodeOrLength;
+}
+
+// Get the statistics of a correction pipeline.
+int32_t uGnssCorrectionGetStats(uGnssCorrectionHandle_t handle,
+                                uGnssCorrectionStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssCorrectionContext_t *pContext = (uGnssCorrectionContext_t *) handle;
+
+    if ((pContext != NULL) && (pStats != NULL)) {
+
+        U_PORT_MUTEX_LOCK(pContext->mutex);
+
+        *pStats = pContext->stats;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+        U_PORT_MUTEX_UNLOCK(pContext->mutex);
+    }
+
+    return errorCode;
+}
+
+// Close a correction pipeline.
+void uGnssCorrectionClose(uGnssCorrectionHandle_t handle)
+{
+    uGnssCorrectionContext_t *pContext = (uGnssCorrectionContext_t *) handle;
+
+    if (pContext != NULL) {
+        // Stop the sources first, without the mutex locked
+        // since their handlers lock it
+        if (pContext->pMqttContext != NULL) {
+            uMqttClientRouteRemove(pContext->pMqttContext,
+                                   pContext->pTopicFilterStr);
+        }
+        if (pContext->sockDescriptor >= 0) {
+            uSockRegisterCallbackData(pContext->sockDescriptor, NULL, NULL);
+        }
+        if (pContext->eventQueueHandle >= 0) {
+            uPortEventQueueClose(pContext->eventQueueHandle);
+        }
+        // Make sure that no handler is still running
+        U_PORT_MUTEX_LOCK(pContext->mutex);
+        U_PORT_MUTEX_UNLOCK(pContext->mutex);
+        uPortMutexDelete(pContext->mutex);
+        free(pContext);
+    }
+}
+
+// End of file
@@ -50,6 +50,7 @@
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss_private.h"
+#include "u_gnss_ubx_view.h"
 #include "u_gnss_msg.h" // uGnssMsgReceiveStatStreamLoss()
 #include "u_gnss_info.h"
 
@@ -61,7 +62,9 @@
  * UBX-MON-COMMS message (see uGnssInfoGetCommunicationStats())
  * with max port numbers.
  */
-#define U_GNSS_INFO_MESSAGE_BODY_LENGTH_UBX_MON_COMMS (8 + (40 * U_GNSS_PORT_MAX_NUM))
+#define U_GNSS_INFO_MESSAGE_BODY_LENGTH_UBX_MON_COMMS (U_GNSS_UBX_MON_COMMS_LENGTH_BYTES +      \
+                                                       (U_GNSS_UBX_MON_COMMS_BLOCK_LENGTH_BYTES * \
+                                                        U_GNSS_PORT_MAX_NUM))
 
 /* ----------------------------------------------------------------
  * TYPES
@@ -75,6 +78,38 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Get the body of the UBX-MON-VER message, from the identity cache
+// if it is there, else from the GNSS chip, populating the cache;
+// *ppBody remains valid until the identity cache is cleared.
+static int32_t monVerGet(uGnssPrivateInstance_t *pInstance,
+                         const char **ppBody)
+{
+    uGnssPrivateIdentityCache_t *pCache = &(pInstance->identityCache);
+    int32_t errorCodeOrLength = pCache->monVerLength;
+    char *pBody = NULL;
+
+    if (pCache->pMonVer == NULL) {
+        // Poll with the message class and ID of the UBX-MON-VER message
+        errorCodeOrLength = uGnssPrivateSendReceiveUbxMessageAlloc(pInstance,
+                                                                   0x0a, 0x04,
+                                                                   NULL, 0,
+                                                                   &pBody);
+        if ((errorCodeOrLength > 0) && (pBody != NULL)) {
+            pCache->pMonVer = pBody;
+            pCache->monVerLength = errorCodeOrLength;
+        } else {
+            // It is legal C to free a NULL pointer
+            free(pBody);
+            if (errorCodeOrLength >= 0) {
+                errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_RESPONDING;
+            }
+        }
+    }
+    *ppBody = pCache->pMonVer;
+
+    return errorCodeOrLength;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -85,29 +120,25 @@ int32_t uGnssInfoGetFirmwareVersionStr(uDeviceHandle_t gnssHandle,
 {
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
+    const char *pBody;
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
-            // Poll with the message class and ID of the UBX-MON-VER
-            // message and pass the message body directly back
-            errorCodeOrLength = uGnssPrivateSendReceiveUbxMessage(pInstance,
-                                                                  0x0a, 0x04,
-                                                                  NULL, 0,
-                                                                  pStr, size);
-            // Add a terminator
-            if ((errorCodeOrLength > 0) && (size > 0)) {
-                if (errorCodeOrLength == size) {
-                    errorCodeOrLength--;
+            errorCodeOrLength = monVerGet(pInstance, &pBody);
+            // Pass the message body back, with a terminator
+            if ((errorCodeOrLength > 0) && (pStr != NULL) && (size > 0)) {
+                if (errorCodeOrLength >= (int32_t) size) {
+                    errorCodeOrLength = (int32_t) size - 1;
                 }
+                memcpy(pStr, pBody, errorCodeOrLength);
                 *(pStr + errorCodeOrLength) = 0;
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrLength;
@@ -118,25 +149,27 @@ int32_t uGnssInfoGetVersions(uDeviceHandle_t gnssHandle,
 {
     int32_t errorCodeOrLength = U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
+    const char *pBody;
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrLength = U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (NULL != pVer)) {
-            // Poll with the message class and ID of the UBX-MON-VER
-            // message and pass the message body directly back
+            // Get the UBX-MON-VER message body and copy it in
             struct {
                 char sw[30];
                 char hw[10];
                 char ext[10][30];
             } message;
-            errorCodeOrLength = uGnssPrivateSendReceiveUbxMessage(pInstance,
-                                                                  0x0a, 0x04,
-                                                                  NULL, 0,
-                                                                  (char *)&message, sizeof(message));
+            errorCodeOrLength = monVerGet(pInstance, &pBody);
+            if (errorCodeOrLength > (int32_t) sizeof(message)) {
+                errorCodeOrLength = (int32_t) sizeof(message);
+            }
+            if (errorCodeOrLength > 0) {
+                memcpy((char *) &message, pBody, errorCodeOrLength);
+            }
             // Add a terminator
             if (errorCodeOrLength > sizeof(message.sw) + sizeof(message.hw)) {
                 memset(pVer, 0, sizeof(*pVer));
@@ -160,7 +193,7 @@ int32_t uGnssInfoGetVersions(uDeviceHandle_t gnssHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrLength;
@@ -173,45 +206,56 @@ int32_t uGnssInfoGetIdStr(uDeviceHandle_t gnssHandle,
 {
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateIdentityCache_t *pCache;
     // Enough room for the body of the UBX-SEC-UNIQID message
     char message[9];
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
-            // Poll with the message class and ID of the UBX-SEC-UNIQID command
-            errorCodeOrLength = uGnssPrivateSendReceiveUbxMessage(pInstance,
-                                                                  0x27, 0x03,
-                                                                  NULL, 0, message,
-                                                                  sizeof(message));
-            if (errorCodeOrLength >= (int32_t) sizeof(message)) {
-                // The first byte of the first uint32_t should indicate version 1
-                if ((uUbxProtocolUint32Decode(message) & 0xFF) == 1) {
-                    // The remaining bytes are the chip ID
-                    errorCodeOrLength -= 4;
-                    // Copy them in and add a terminator
-                    if (size > 0) {
-                        size--;
-                        if (errorCodeOrLength > (int32_t) size) {
-                            errorCodeOrLength = (int32_t) size;
-                        }
-                        if (pStr != NULL) {
-                            memcpy(pStr, message + 4, errorCodeOrLength);
-                            *(pStr + errorCodeOrLength) = 0;
-                        }
+            pCache = &(pInstance->identityCache);
+            errorCodeOrLength = pCache->chipIdLength;
+            if (errorCodeOrLength == 0) {
+                // Poll with the message class and ID of the UBX-SEC-UNIQID command
+                errorCodeOrLength = uGnssPrivateSendReceiveUbxMessage(pInstance,
+                                                                      0x27, 0x03,
+                                                                      NULL, 0, message,
+                                                                      sizeof(message));
+                if (errorCodeOrLength >= (int32_t) sizeof(message)) {
+                    // The first byte of the first uint32_t should indicate version 1
+                    if ((uUbxProtocolUint32Decode(message) & 0xFF) == 1) {
+                        // The remaining bytes are the chip ID: cache them,
+                        // it can't change
+                        errorCodeOrLength = sizeof(message) - 4;
+                        memcpy(pCache->chipId, message + 4, errorCodeOrLength);
+                        pCache->chipIdLength = errorCodeOrLength;
                     } else {
-                        errorCodeOrLength = 0;
+                        errorCodeOrLength = (int32_t) U_ERROR_COMMON_PLATFORM;
+                    }
+                } else if (errorCodeOrLength >= 0) {
+                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_RESPONDING;
+                }
+            }
+            if (errorCodeOrLength > 0) {
+                // Copy the chip ID in and add a terminator
+                if (size > 0) {
+                    size--;
+                    if (errorCodeOrLength > (int32_t) size) {
+                        errorCodeOrLength = (int32_t) size;
+                    }
+                    if (pStr != NULL) {
+                        memcpy(pStr, pCache->chipId, errorCodeOrLength);
+                        *(pStr + errorCodeOrLength) = 0;
                     }
                 } else {
-                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_PLATFORM;
+                    errorCodeOrLength = 0;
                 }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrLength;
@@ -223,49 +267,46 @@ int64_t uGnssInfoGetTimeUtc(uDeviceHandle_t gnssHandle)
     int64_t errorCodeOrTime = (int64_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
     // Enough room for the body of the UBX-NAV-TIMEUTC message
-    char message[20];
-    int32_t months;
-    int32_t year;
+    char message[U_GNSS_UBX_NAV_TIMEUTC_LENGTH_BYTES];
+    uTimeDateTime_t dateTime;
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrTime = (int64_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             // Poll with the message class and ID of the UBX-NAV-TIMEUTC command
             errorCodeOrTime = uGnssPrivateSendReceiveUbxMessage(pInstance,
-                                                                0x01, 0x21,
+                                                                U_GNSS_UBX_NAV_TIMEUTC_CLASS,
+                                                                U_GNSS_UBX_NAV_TIMEUTC_ID,
                                                                 NULL, 0, message,
                                                                 sizeof(message));
             if (errorCodeOrTime >= (int64_t) sizeof(message)) {
                 // Check the validity flag
                 errorCodeOrTime = (int64_t) U_ERROR_COMMON_UNKNOWN;
-                if (message[19] & 0x04) {
-                    errorCodeOrTime = 0;
-                    // Year is 1999-2099, so need to adjust to get year since 1970
-                    year = (uUbxProtocolUint16Decode(message + 12) - 1999) + 29;
-                    // Month (1 to 12), so take away 1 to make it zero-based
-                    months = message[14] - 1;
-                    months += year * 12;
-                    // Work out the number of seconds due to the year/month count
-                    errorCodeOrTime += uTimeMonthsToSecondsUtc(months);
+                if (U_GNSS_UBX_VIEW_GET(message, NAV_TIMEUTC, VALID, X1) &
+                    U_GNSS_UBX_NAV_TIMEUTC_VALID_UTC) {
+                    // Year is 1999-2099
+                    dateTime.year = U_GNSS_UBX_VIEW_GET(message, NAV_TIMEUTC, YEAR, U2);
+                    // Month (1 to 12)
+                    dateTime.month = U_GNSS_UBX_VIEW_GET(message, NAV_TIMEUTC, MONTH, U1);
                     // Day (1 to 31)
-                    errorCodeOrTime += ((int32_t) message[15] - 1) * 3600 * 24;
+                    dateTime.day = U_GNSS_UBX_VIEW_GET(message, NAV_TIMEUTC, DAY, U1);
                     // Hour (0 to 23)
-                    errorCodeOrTime += ((int32_t) message[16]) * 3600;
+                    dateTime.hour = U_GNSS_UBX_VIEW_GET(message, NAV_TIMEUTC, HOUR, U1);
                     // Minute (0 to 59)
-                    errorCodeOrTime += ((int32_t) message[17]) * 60;
+                    dateTime.minute = U_GNSS_UBX_VIEW_GET(message, NAV_TIMEUTC, MIN, U1);
                     // Second (0 to 60)
-                    errorCodeOrTime += message[18];
+                    dateTime.second = U_GNSS_UBX_VIEW_GET(message, NAV_TIMEUTC, SEC, U1);
+                    errorCodeOrTime = uTimeToSecondsUtc(&dateTime);
 
                     uPortLog("U_GNSS_POS: UTC time is %d.\n", (int32_t) errorCodeOrTime);
                 }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrTime;
@@ -279,16 +320,16 @@ int32_t uGnssInfoGetCommunicationStats(uDeviceHandle_t gnssHandle,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
     char *pMessage;
+    const char *pBlock;
     int32_t messageLength;
     int32_t numPorts = -1;
     int32_t protocolId;
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             // TODO: fix this properly with versioned UBX messaging later
@@ -327,52 +368,61 @@ int32_t uGnssInfoGetCommunicationStats(uDeviceHandle_t gnssHandle,
                     }
                     // Poll with the message class and ID of the UBX-MON-COMMS command
                     errorCode = uGnssPrivateSendReceiveUbxMessage(pInstance,
-                                                                  0x0a, 0x36,
+                                                                  U_GNSS_UBX_MON_COMMS_CLASS,
+                                                                  U_GNSS_UBX_MON_COMMS_ID,
                                                                   NULL, 0, pMessage,
                                                                   U_GNSS_INFO_MESSAGE_BODY_LENGTH_UBX_MON_COMMS);
                     if (errorCode >= 0) {
                         messageLength = errorCode;
-                        if ((messageLength >= 2) && (*pMessage == 0)) {
+                        if ((messageLength >= U_GNSS_UBX_MON_COMMS_OFFSET_N_PORTS + 1) &&
+                            (U_GNSS_UBX_VIEW_GET(pMessage, MON_COMMS, VERSION, U1) ==
+                             U_GNSS_UBX_MON_COMMS_VERSION)) {
                             // Have a message in a version we understand;
                             // get the number of ports reported in it
-                            numPorts = *(pMessage + 1);
+                            numPorts = U_GNSS_UBX_VIEW_GET(pMessage, MON_COMMS, N_PORTS, U1);
                         }
                         errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
-                        if ((numPorts > 0) && (messageLength >= 8 + (numPorts * 40))) {
+                        if ((numPorts > 0) &&
+                            (messageLength >= U_GNSS_UBX_MON_COMMS_LENGTH_BYTES +
+                             (numPorts * U_GNSS_UBX_MON_COMMS_BLOCK_LENGTH_BYTES))) {
                             // The message has some ports in it and is of the correct
                             // length for that number of ports; run through the
-                            // message in blocks of 40 bytes, the length of the
-                            // report for one port being 40 bytes, after the initial
-                            // 8 bytes, to find the report for our port number
-                            for (int32_t offset = 0; (8 + offset < messageLength) &&
-                                 (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS); offset += 40) {
+                            // per-port blocks which follow the fixed part of the
+                            // message to find the report for our port number
+                            for (int32_t offset = U_GNSS_UBX_MON_COMMS_LENGTH_BYTES;
+                                 (offset < messageLength) &&
+                                 (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS);
+                                 offset += U_GNSS_UBX_MON_COMMS_BLOCK_LENGTH_BYTES) {
+                                pBlock = pMessage + offset;
                                 // No endian conversion here as port is already endian converted
-                                if (*(uint16_t *) (pMessage + 8 + offset) == port) {
+                                if (*(uint16_t *) (pBlock + U_GNSS_UBX_MON_COMMS_BLOCK_OFFSET_PORT_ID) == port) {
                                     errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                                     if (pStats != NULL) {
-                                        pStats->txPendingBytes = uUbxProtocolUint16Decode(pMessage + 10 + offset);
-                                        pStats->txBytes = uUbxProtocolUint32Decode(pMessage + 12 + offset);
-                                        pStats->txPercentageUsage = *(pMessage + 16 + offset);
-                                        pStats->txPeakPercentageUsage = *(pMessage + 17 + offset);
-                                        pStats->rxPendingBytes = uUbxProtocolUint16Decode(pMessage + 18 + offset);
-                                        pStats->rxBytes = uUbxProtocolUint32Decode(pMessage + 20 + offset);
-                                        pStats->rxPercentageUsage = *(pMessage + 24 + offset);
-                                        pStats->rxPeakPercentageUsage = *(pMessage + 25 + offset);
-                                        pStats->rxOverrunErrors = uUbxProtocolUint16Decode(pMessage + 26 + offset);
+                                        pStats->txPendingBytes = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, TX_PENDING, U2);
+                                        pStats->txBytes = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, TX_BYTES, U4);
+                                        pStats->txPercentageUsage = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, TX_USAGE, U1);
+                                        pStats->txPeakPercentageUsage = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, TX_PEAK_USAGE, U1);
+                                        pStats->rxPendingBytes = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, RX_PENDING, U2);
+                                        pStats->rxBytes = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, RX_BYTES, U4);
+                                        pStats->rxPercentageUsage = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, RX_USAGE, U1);
+                                        pStats->rxPeakPercentageUsage = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, RX_PEAK_USAGE, U1);
+                                        pStats->rxOverrunErrors = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, OVERRUN_ERRS, U2);
                                         // The number of messages parsed is in the array which follows
-                                        // based on the array of protocol IDs way back at the start
-                                        // of the message in byte 4
+                                        // based on the array of protocol IDs way back in the fixed
+                                        // part of the message
                                         for (size_t x = 0; x < sizeof(pStats->rxNumMessages) / sizeof(pStats->rxNumMessages[0]); x++) {
                                             pStats->rxNumMessages[x] = -1;
                                         }
                                         for (size_t x = 0; x < 4; x++) {
-                                            protocolId = *(pMessage + 4 + x);
+                                            protocolId = *(pMessage + U_GNSS_UBX_MON_COMMS_OFFSET_PROT_ID0 + x);
                                             if ((protocolId >= 0) &&
                                                 (protocolId < sizeof(pStats->rxNumMessages) / sizeof(pStats->rxNumMessages[0]))) {
-                                                pStats->rxNumMessages[protocolId] = uUbxProtocolUint16Decode(pMessage + 28 + offset + (x * 2));
+                                                pStats->rxNumMessages[protocolId] = uUbxProtocolUint16Decode(pBlock +
+                                                                                                             U_GNSS_UBX_MON_COMMS_BLOCK_OFFSET_MSGS0 +
+                                                                                                             (x * 2));
                                             }
                                         }
-                                        pStats->rxSkippedBytes = uUbxProtocolUint32Decode(pMessage + 44 + offset);
+                                        pStats->rxSkippedBytes = U_GNSS_UBX_VIEW_GET(pBlock, MON_COMMS_BLOCK, SKIPPED, U4);
                                     }
                                 }
                             }
@@ -385,7 +435,7 @@ int32_t uGnssInfoGetCommunicationStats(uDeviceHandle_t gnssHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -0,0 +1,493 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief This source file contains the implementation of the raw
+ * logging functions of the GNSS API.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+
+#include "u_ringbuffer.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss_private.h"
+#include "u_gnss_log.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_GNSS_LOG_TASK_PRIORITY
+/** The priority of the task that calls the writer of a log: lower
+ * than that of the message receive task, so that writing never holds
+ * up the bringing in of data from the GNSS chip.
+ */
+# define U_GNSS_LOG_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Hand the block being filled over to the log task and start
+// filling the other one, which must not be pending.
+// Note: the log mutex should be locked before this is called.
+static void blockSwap(uGnssPrivateLog_t *pLog)
+{
+    pLog->pending = true;
+    pLog->active = 1 - pLog->active;
+    pLog->fill = 0;
+    uPortSemaphoreGive(pLog->semaphore);
+}
+
+// Call the writer with a block and account for the outcome.
+static void blockWrite(uGnssPrivateLog_t *pLog, const char *pData,
+                       size_t size)
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    int32_t written;
+
+    written = ((uGnssLogWriter_t) pLog->pWriter)(pData, size, pLog->pWriterParam);
+    startTimeMs = uPortGetTickTimeMs() - startTimeMs;
+
+    U_PORT_MUTEX_LOCK(pLog->mutex);
+
+    pLog->blocksWritten++;
+    if (startTimeMs > pLog->writeTimeMaxMs) {
+        pLog->writeTimeMaxMs = startTimeMs;
+    }
+    if (written < 0) {
+        written = 0;
+    }
+    if (written > (int32_t) size) {
+        written = (int32_t) size;
+    }
+    pLog->bytesWritten += written;
+    if (written < (int32_t) size) {
+        pLog->writeFailures++;
+        pLog->bytesDropped += size - written;
+    }
+
+    U_PORT_MUTEX_UNLOCK(pLog->mutex);
+}
+
+// The log task: writes out blocks as they are filled and, when
+// told to stop, whatever is left.
+static void logTask(void *pParam)
+{
+    uGnssPrivateLog_t *pLog = (uGnssPrivateLog_t *) pParam;
+    const char *pData;
+    size_t size = 0;
+    bool keepGoing = true;
+
+    U_PORT_MUTEX_LOCK(pLog->taskRunningMutexHandle);
+
+    while (keepGoing) {
+        uPortSemaphoreTake(pLog->semaphore);
+        keepGoing = pLog->taskKeepGoing;
+        do {
+            pData = NULL;
+
+            U_PORT_MUTEX_LOCK(pLog->mutex);
+
+            if (pLog->pending) {
+                pData = pLog->pBlock[1 - pLog->active];
+                size = pLog->blockSize;
+            } else if (!keepGoing && (pLog->fill > 0)) {
+                // Stopping and the log is no longer attached to
+                // the framer, so the partial block can go too
+                pData = pLog->pBlock[pLog->active];
+                size = pLog->fill;
+                pLog->fill = 0;
+            }
+
+            U_PORT_MUTEX_UNLOCK(pLog->mutex);
+
+            if (pData != NULL) {
+                blockWrite(pLog, pData, size);
+
+                U_PORT_MUTEX_LOCK(pLog->mutex);
+
+                if (pData != pLog->pBlock[pLog->active]) {
+                    pLog->pending = false;
+                    if (pLog->fill == pLog->blockSize) {
+                        // Filled up while we were writing
+                        blockSwap(pLog);
+                    }
+                }
+
+                U_PORT_MUTEX_UNLOCK(pLog->mutex);
+            }
+        } while (pData != NULL);
+    }
+
+    U_PORT_MUTEX_UNLOCK(pLog->taskRunningMutexHandle);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+// Free a log and its OS resources; the log task must not be running.
+static void logFree(uGnssPrivateLog_t *pLog)
+{
+    if (pLog->taskRunningMutexHandle != NULL) {
+        uPortMutexDelete(pLog->taskRunningMutexHandle);
+    }
+    if (pLog->semaphore != NULL) {
+        uPortSemaphoreDelete(pLog->semaphore);
+    }
+    if (pLog->mutex != NULL) {
+        uPortMutexDelete(pLog->mutex);
+    }
+    // It is legal C to free a NULL pointer
+    free(pLog->pBlock[0]);
+    free(pLog->pBlock[1]);
+    free(pLog->pMessageIdList);
+    free(pLog);
+}
+
+// Copy the statistics of a log.
+static void statsGet(uGnssPrivateLog_t *pLog, uGnssLogStats_t *pStats)
+{
+    U_PORT_MUTEX_LOCK(pLog->mutex);
+
+    pStats->messagesLogged = pLog->messagesLogged;
+    pStats->messagesDropped = pLog->messagesDropped;
+    pStats->bytesLogged = pLog->bytesLogged;
+    pStats->bytesDropped = pLog->bytesDropped;
+    pStats->bytesWritten = pLog->bytesWritten;
+    pStats->bytesBuffered = pLog->fill;
+    if (pLog->pending) {
+        pStats->bytesBuffered += pLog->blockSize;
+    }
+    pStats->blocksWritten = pLog->blocksWritten;
+    pStats->writeFailures = pLog->writeFailures;
+    pStats->writeTimeMaxMs = pLog->writeTimeMaxMs;
+
+    U_PORT_MUTEX_UNLOCK(pLog->mutex);
+}
+
+// Stop the log of an instance, writing out what is left.
+// Note: the instance should be locked before this is called.
+static void logStop(uGnssPrivateInstance_t *pInstance,
+                    uGnssLogStats_t *pStats)
+{
+    uGnssPrivateLog_t *pLog = pInstance->pLog;
+
+    if (pLog != NULL) {
+        // Detach the log from the framer so that nothing more
+        // is added to it
+        U_PORT_MUTEX_LOCK(pInstance->pFramer->mutex);
+        pInstance->pLog = NULL;
+        U_PORT_MUTEX_UNLOCK(pInstance->pFramer->mutex);
+
+        // Get the task to write what is left and exit
+        pLog->taskKeepGoing = false;
+        uPortSemaphoreGive(pLog->semaphore);
+        U_PORT_MUTEX_LOCK(pLog->taskRunningMutexHandle);
+        U_PORT_MUTEX_UNLOCK(pLog->taskRunningMutexHandle);
+        // Pause to allow the task deletion to actually occur
+        // in the idle thread, required by some RTOSs
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+
+        if (pStats != NULL) {
+            statsGet(pLog, pStats);
+        }
+        logFree(pLog);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS THAT ARE PRIVATE TO GNSS
+ * -------------------------------------------------------------- */
+
+// Stop any log; for GNSS deinitialisation.
+void uGnssPrivateLogStop(uGnssPrivateInstance_t *pInstance)
+{
+    if (pInstance != NULL) {
+        logStop(pInstance, NULL);
+    }
+}
+
+// Copy a framed message into the log, if it is wanted.
+void uGnssPrivateLogFrame(uGnssPrivateInstance_t *pInstance,
+                          const uGnssPrivateMessageId_t *pMessageId,
+                          size_t length)
+{
+    uGnssPrivateLog_t *pLog = pInstance->pLog;
+    uGnssPrivateMessageId_t messageId = *pMessageId;
+    bool wanted = pLog->all;
+    size_t room;
+    size_t offset = 0;
+    size_t x;
+
+    if (!wanted && (messageId.type != U_GNSS_PROTOCOL_UNKNOWN) &&
+        uGnssPrivateMsgFilterMatch(&(pLog->filter), &messageId)) {
+        // The filter may let through more than is wanted,
+        // check properly
+        for (size_t y = 0; (y < pLog->numMessageIds) && !wanted; y++) {
+            wanted = uGnssPrivateMessageIdIsWanted(&messageId,
+                                                   &(pLog->pMessageIdList[y]));
+        }
+    }
+
+    if (wanted) {
+
+        U_PORT_MUTEX_LOCK(pLog->mutex);
+
+        room = pLog->blockSize - pLog->fill;
+        if (!pLog->pending) {
+            room += pLog->blockSize;
+        }
+        if (length <= room) {
+            while (offset < length) {
+                if (pLog->fill == pLog->blockSize) {
+                    // The room check above means that the
+                    // other block must be free
+                    blockSwap(pLog);
+                }
+                x = length - offset;
+                if (x > pLog->blockSize - pLog->fill) {
+                    x = pLog->blockSize - pLog->fill;
+                }
+                x = uRingBufferPeekHandle(&(pInstance->ringBuffer),
+                                          pInstance->pFramer->ringBufferReadHandle,
+                                          pLog->pBlock[pLog->active] + pLog->fill,
+                                          x, offset);
+                pLog->fill += x;
+                offset += x;
+                if (x == 0) {
+                    // Shouldn't happen, the message is all there,
+                    // but don't get stuck if it does
+                    pLog->bytesDropped += length - offset;
+                    length = offset;
+                }
+            }
+            if ((pLog->fill == pLog->blockSize) && !pLog->pending) {
+                // Send full blocks on their way straight away
+                blockSwap(pLog);
+            }
+            pLog->messagesLogged++;
+            pLog->bytesLogged += offset;
+        } else {
+            // The writer isn't keeping up
+            pLog->messagesDropped++;
+            pLog->bytesDropped += length;
+        }
+
+        U_PORT_MUTEX_UNLOCK(pLog->mutex);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start logging.
+int32_t uGnssLogStart(uDeviceHandle_t gnssHandle,
+                      const uGnssMessageId_t *pMessageIdList,
+                      size_t numMessageIds,
+                      size_t blockLengthBytes,
+                      uGnssLogWriter_t pWriter,
+                      void *pWriterParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateLog_t *pLog;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pMessageIdList == NULL) {
+            numMessageIds = 0;
+        }
+        if (blockLengthBytes == 0) {
+            blockLengthBytes = U_GNSS_LOG_BLOCK_LENGTH_BYTES;
+        }
+        if ((pInstance != NULL) && (pWriter != NULL) &&
+            ((pMessageIdList == NULL) || (numMessageIds > 0))) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            // Logging hangs off the framer, which only exists
+            // for streaming transports, and there can be only one
+            if ((pInstance->pFramer != NULL) && (pInstance->pLog == NULL)) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pLog = (uGnssPrivateLog_t *) malloc(sizeof(uGnssPrivateLog_t));
+                if (pLog != NULL) {
+                    memset(pLog, 0, sizeof(*pLog));
+                    pLog->pWriter = (void *) pWriter;
+                    pLog->pWriterParam = pWriterParam;
+                    pLog->all = (pMessageIdList == NULL);
+                    pLog->blockSize = blockLengthBytes;
+                    pLog->pBlock[0] = (char *) malloc(blockLengthBytes);
+                    pLog->pBlock[1] = (char *) malloc(blockLengthBytes);
+                    if (numMessageIds > 0) {
+                        pLog->pMessageIdList = (uGnssPrivateMessageId_t *) malloc(numMessageIds *
+                                                                                  sizeof(uGnssPrivateMessageId_t));
+                    }
+                    if ((pLog->pBlock[0] != NULL) && (pLog->pBlock[1] != NULL) &&
+                        ((numMessageIds == 0) || (pLog->pMessageIdList != NULL))) {
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        for (size_t x = 0; (x < numMessageIds) && (errorCode == 0); x++) {
+                            errorCode = uGnssPrivateMessageIdToPrivate(pMessageIdList + x,
+                                                                       &(pLog->pMessageIdList[x]));
+                            if (errorCode == 0) {
+                                uGnssPrivateMsgFilterAdd(&(pLog->filter),
+                                                         &(pLog->pMessageIdList[x]));
+                            }
+                        }
+                        pLog->numMessageIds = numMessageIds;
+                        if (errorCode == 0) {
+                            errorCode = uPortMutexCreate(&(pLog->mutex));
+                        }
+                        if (errorCode == 0) {
+                            errorCode = uPortSemaphoreCreate(&(pLog->semaphore), 0, 1);
+                        }
+                        if (errorCode == 0) {
+                            errorCode = uPortMutexCreate(&(pLog->taskRunningMutexHandle));
+                        }
+                        if (errorCode == 0) {
+                            pLog->taskKeepGoing = true;
+                            errorCode = uPortTaskCreate(logTask, "gnssLog",
+                                                        U_GNSS_LOG_TASK_STACK_SIZE_BYTES,
+                                                        pLog, U_GNSS_LOG_TASK_PRIORITY,
+                                                        &(pLog->taskHandle));
+                            if (errorCode == 0) {
+                                // Wait for the task to lock the mutex,
+                                // which shows it is running
+                                while (uPortMutexTryLock(pLog->taskRunningMutexHandle, 0) == 0) {
+                                    uPortMutexUnlock(pLog->taskRunningMutexHandle);
+                                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                                }
+                            }
+                        }
+                    }
+                    if (errorCode == 0) {
+                        // Attach the log to the framer
+                        U_PORT_MUTEX_LOCK(pInstance->pFramer->mutex);
+                        pInstance->pLog = pLog;
+                        U_PORT_MUTEX_UNLOCK(pInstance->pFramer->mutex);
+                        // Make sure that something is bringing data in
+                        errorCode = uGnssPrivateStartMsgReceive(pInstance);
+                        if (errorCode != 0) {
+                            logStop(pInstance, NULL);
+                        }
+                    } else {
+                        // The task is the last thing to be created,
+                        // so it can't be running
+                        logFree(pLog);
+                    }
+                }
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Get the statistics of a log.
+int32_t uGnssLogGetStats(uDeviceHandle_t gnssHandle,
+                         uGnssLogStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pStats != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (pInstance->pLog != NULL) {
+                statsGet(pInstance->pLog, pStats);
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Stop logging.
+int32_t uGnssLogStop(uDeviceHandle_t gnssHandle,
+                     uGnssLogStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (pInstance->pLog != NULL) {
+                logStop(pInstance, pStats);
+                if ((pInstance->pMsgReceive != NULL) &&
+                    (pInstance->pMsgReceive->pReaderList == NULL)) {
+                    // The message receive task was only
+                    // running for us, it can stop now
+                    uGnssPrivateStopMsgReceive(pInstance);
+                }
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// End of file
@@ -0,0 +1,479 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief This source file contains the implementation of the
+ * multiple GNSS assistance (MGA) functions of the GNSS API.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset(), memcpy(), memcmp()
+
+#include "u_cfg_sw.h"
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"  // Required by u_gnss_private.h
+
+#include "u_ubx_protocol.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_cfg_val_key.h"
+#include "u_gnss_cfg.h"
+#include "u_gnss_msg.h"
+#include "u_gnss_mga.h"
+#include "u_gnss_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The UBX message class of all MGA messages.
+ */
+#define U_GNSS_MGA_MESSAGE_CLASS 0x13
+
+/** The UBX message ID of UBX-MGA-ACK.
+ */
+#define U_GNSS_MGA_MESSAGE_ID_ACK 0x60
+
+/** The UBX message ID of UBX-MGA-DBD, which is not ACKed.
+ */
+#define U_GNSS_MGA_MESSAGE_ID_DBD 0x80
+
+/** The length of the body of a UBX-MGA-ACK-DATA0 message.
+ */
+#define U_GNSS_MGA_ACK_BODY_LENGTH_BYTES 8
+
+/** The number of bytes of the start of the body of an MGA message
+ * that are echoed in its UBX-MGA-ACK-DATA0.
+ */
+#define U_GNSS_MGA_ACK_PAYLOAD_START_LENGTH_BYTES 4
+
+/** The length of the body of a UBX-CFG-NAVX5 message.
+ */
+#define U_GNSS_MGA_CFG_NAVX5_BODY_LENGTH_BYTES 40
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** An MGA message that has been sent but not yet ACKed.
+ */
+typedef struct {
+    uint8_t messageId;
+    char payloadStart[U_GNSS_MGA_ACK_PAYLOAD_START_LENGTH_BYTES];
+    int32_t sentTimeMs;
+} uGnssMgaOutstanding_t;
+
+/** The state of an upload, shared with ackCallback().
+ */
+typedef struct {
+    uPortMutexHandle_t mutex;
+    uPortSemaphoreHandle_t semaphore;
+    uGnssMgaOutstanding_t outstanding[U_GNSS_MGA_UPLOAD_WINDOW_SIZE_MAX];
+    size_t numOutstanding;
+    uGnssMgaUploadStats_t stats;
+} uGnssMgaUpload_t;
+
+/** The state of a database save, shared with dbdCallback().
+ */
+typedef struct {
+    uPortSemaphoreHandle_t semaphore;
+    char *pBuffer;
+    size_t size;
+    size_t length;
+    uGnssMgaDatabaseSaveStats_t stats;
+} uGnssMgaDatabaseSave_t;
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Remove an entry from the outstanding list.
+// Note: the mutex of the upload should be locked before this is called.
+static void outstandingRemove(uGnssMgaUpload_t *pUpload, size_t index)
+{
+    pUpload->numOutstanding--;
+    for (size_t x = index; x < pUpload->numOutstanding; x++) {
+        pUpload->outstanding[x] = pUpload->outstanding[x + 1];
+    }
+}
+
+// Callback for UBX-MGA-ACK messages: match the ACK with the
+// oldest outstanding message it could be for.
+static void ackCallback(uDeviceHandle_t gnssHandle,
+                        const uGnssMessageId_t *pMessageId,
+                        int32_t errorCodeOrLength,
+                        void *pCallbackParam)
+{
+    uGnssMgaUpload_t *pUpload = (uGnssMgaUpload_t *) pCallbackParam;
+    char message[U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES + U_GNSS_MGA_ACK_BODY_LENGTH_BYTES];
+    const char *pBody = message + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES;
+    bool found = false;
+
+    (void) pMessageId;
+
+    // Only interested in UBX-MGA-ACK-DATA0, the only one of its length
+    if ((errorCodeOrLength == sizeof(message)) &&
+        (uGnssMsgReceiveCallbackRead(gnssHandle, message,
+                                     sizeof(message)) == sizeof(message))) {
+
+        U_PORT_MUTEX_LOCK(pUpload->mutex);
+
+        for (size_t x = 0; (x < pUpload->numOutstanding) && !found; x++) {
+            // Byte 3 is the ID of the message being ACKed, the
+            // start of its payload follows
+            if ((pUpload->outstanding[x].messageId == (uint8_t) * (pBody + 3)) &&
+                (memcmp(pUpload->outstanding[x].payloadStart, pBody + 4,
+                        sizeof(pUpload->outstanding[x].payloadStart)) == 0)) {
+                found = true;
+                // Byte 0 is 1 if the message was accepted
+                if (*pBody == 1) {
+                    pUpload->stats.messagesAcked++;
+                } else {
+                    pUpload->stats.messagesNacked++;
+                }
+                outstandingRemove(pUpload, x);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(pUpload->mutex);
+
+        if (found) {
+            uPortSemaphoreGive(pUpload->semaphore);
+        }
+    }
+}
+
+// Wait until no more than the given number of messages are
+// outstanding, giving up on any that have waited too long.
+static void windowWait(uGnssMgaUpload_t *pUpload, size_t numOutstandingMax,
+                       int32_t ackTimeoutMs)
+{
+    int32_t waitMs = 0;
+    bool keepGoing = true;
+
+    while (keepGoing) {
+
+        U_PORT_MUTEX_LOCK(pUpload->mutex);
+
+        // Give up on the oldest message if its time is up
+        while ((pUpload->numOutstanding > 0) &&
+               (uPortGetTickTimeMs() - pUpload->outstanding[0].sentTimeMs >= ackTimeoutMs)) {
+            pUpload->stats.messagesTimedOut++;
+            outstandingRemove(pUpload, 0);
+        }
+        keepGoing = (pUpload->numOutstanding > numOutstandingMax);
+        if (keepGoing) {
+            waitMs = ackTimeoutMs - (uPortGetTickTimeMs() - pUpload->outstanding[0].sentTimeMs);
+        }
+
+        U_PORT_MUTEX_UNLOCK(pUpload->mutex);
+
+        if (keepGoing && (waitMs > 0)) {
+            // Wait for ackCallback() to tell us something has changed
+            uPortSemaphoreTryTake(pUpload->semaphore, waitMs);
+        }
+    }
+}
+
+// Callback for UBX-MGA-DBD messages: append each one to the buffer.
+static void dbdCallback(uDeviceHandle_t gnssHandle,
+                        const uGnssMessageId_t *pMessageId,
+                        int32_t errorCodeOrLength,
+                        void *pCallbackParam)
+{
+    uGnssMgaDatabaseSave_t *pSave = (uGnssMgaDatabaseSave_t *) pCallbackParam;
+
+    (void) pMessageId;
+
+    if (errorCodeOrLength > 0) {
+        if ((pSave->length + errorCodeOrLength <= pSave->size) &&
+            (uGnssMsgReceiveCallbackRead(gnssHandle, pSave->pBuffer + pSave->length,
+                                         errorCodeOrLength) == errorCodeOrLength)) {
+            pSave->length += errorCodeOrLength;
+            pSave->stats.numMessages++;
+        } else {
+            pSave->stats.numMessagesLost++;
+        }
+        uPortSemaphoreGive(pSave->semaphore);
+    }
+}
+
+// Switch on ACKs for MGA messages.
+static int32_t ackAidingSet(uDeviceHandle_t gnssHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    char message[U_GNSS_MGA_CFG_NAVX5_BODY_LENGTH_BYTES] = {0};
+    bool useCfgVal = false;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
+                useCfgVal = true;
+            } else {
+                // Send UBX-CFG-NAVX5 version 2 with only the ackAid
+                // bit of mask1 set and the ackAiding field set
+                *message = 0x02;
+                *((uint16_t *) (message + 2)) = uUbxProtocolUint16Encode(0x0400);
+                *(message + 17) = 1;
+                errorCode = uGnssPrivateSendUbxMessage(pInstance, 0x06, 0x23,
+                                                       message, sizeof(message));
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+        if (useCfgVal) {
+            // Done outside the mutex as this is a public function
+            errorCode = uGnssCfgValSet(gnssHandle,
+                                       U_GNSS_CFG_VAL_KEY_ID_NAVSPG_ACKAIDING_L,
+                                       1, U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                                       U_GNSS_CFG_VAL_LAYER_RAM);
+        }
+    }
+
+    return errorCode;
+}
+
+// Send the MGA data, the UBX-MGA-ACK receiver having been started.
+static int32_t uploadSend(uDeviceHandle_t gnssHandle, uGnssMgaUpload_t *pUpload,
+                          const char *pData, size_t size, size_t windowSize,
+                          int32_t ackTimeoutMs, int32_t messageIntervalMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    const char *pEnd = pData + size;
+    const char *pNext = NULL;
+    const char *pMessage;
+    int32_t messageClass;
+    int32_t messageId;
+    int32_t bodyLength;
+    int32_t lastSendTimeMs = 0;
+    int32_t waitMs;
+    uGnssMgaOutstanding_t *pOutstanding = NULL;
+    bool needsAck;
+
+    while ((errorCode == 0) && (pData < pEnd)) {
+        bodyLength = uUbxProtocolDecode(pData, pEnd - pData, &messageClass,
+                                        &messageId, NULL, 0, &pNext);
+        if (bodyLength >= 0) {
+            // Anything before the message is not UBX
+            pMessage = pNext - (bodyLength + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
+            pUpload->stats.bytesSkipped += pMessage - pData;
+            needsAck = (messageClass == U_GNSS_MGA_MESSAGE_CLASS) &&
+                       (messageId != U_GNSS_MGA_MESSAGE_ID_ACK) &&
+                       (messageId != U_GNSS_MGA_MESSAGE_ID_DBD);
+            if (needsAck) {
+                // Wait for room in the window
+                windowWait(pUpload, windowSize - 1, ackTimeoutMs);
+            }
+            if ((messageIntervalMs > 0) && (pUpload->stats.bytesSent > 0)) {
+                waitMs = messageIntervalMs - (uPortGetTickTimeMs() - lastSendTimeMs);
+                if (waitMs > 0) {
+                    uPortTaskBlock(waitMs);
+                }
+            }
+            lastSendTimeMs = uPortGetTickTimeMs();
+            if (needsAck) {
+                // Add to the outstanding list before sending, as the
+                // UBX-MGA-ACK could arrive before uGnssMsgSend() returns
+                U_PORT_MUTEX_LOCK(pUpload->mutex);
+                pOutstanding = &(pUpload->outstanding[pUpload->numOutstanding]);
+                pOutstanding->messageId = (uint8_t) messageId;
+                memset(pOutstanding->payloadStart, 0, sizeof(pOutstanding->payloadStart));
+                if (bodyLength > (int32_t) sizeof(pOutstanding->payloadStart)) {
+                    bodyLength = sizeof(pOutstanding->payloadStart);
+                }
+                memcpy(pOutstanding->payloadStart,
+                       pMessage + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES, bodyLength);
+                pOutstanding->sentTimeMs = lastSendTimeMs;
+                pUpload->numOutstanding++;
+                U_PORT_MUTEX_UNLOCK(pUpload->mutex);
+            }
+            if (uGnssMsgSend(gnssHandle, pMessage, pNext - pMessage) == pNext - pMessage) {
+                pUpload->stats.bytesSent += pNext - pMessage;
+                if (needsAck) {
+                    pUpload->stats.messagesSent++;
+                }
+            } else {
+                errorCode = (int32_t) U_GNSS_ERROR_TRANSPORT;
+                if (needsAck) {
+                    // Only this task removes entries other than through
+                    // an ACK, which this message won't get, so the one
+                    // we added is still the last one
+                    U_PORT_MUTEX_LOCK(pUpload->mutex);
+                    pUpload->numOutstanding--;
+                    U_PORT_MUTEX_UNLOCK(pUpload->mutex);
+                }
+            }
+            pData = pNext;
+        } else {
+            // No more UBX messages
+            pUpload->stats.bytesSkipped += pEnd - pData;
+            pData = pEnd;
+        }
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Upload a block of assistance data.
+int32_t uGnssMgaUpload(uDeviceHandle_t gnssHandle,
+                       const char *pData, size_t size,
+                       const uGnssMgaUploadCfg_t *pCfg,
+                       uGnssMgaUploadStats_t *pStats)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    uGnssMgaUpload_t upload;
+    uGnssMessageId_t messageId = {.type = U_GNSS_PROTOCOL_UBX,
+                                  .id.ubx = (U_GNSS_MGA_MESSAGE_CLASS << 8) | U_GNSS_MGA_MESSAGE_ID_ACK
+                                 };
+    size_t windowSize = U_GNSS_MGA_UPLOAD_WINDOW_SIZE_DEFAULT;
+    int32_t ackTimeoutMs = U_GNSS_MGA_UPLOAD_ACK_TIMEOUT_MS_DEFAULT;
+    int32_t messageIntervalMs = 0;
+    int32_t asyncHandle;
+
+    memset(&upload, 0, sizeof(upload));
+    if (pCfg != NULL) {
+        if (pCfg->windowSize > 0) {
+            windowSize = pCfg->windowSize;
+        }
+        if (pCfg->ackTimeoutMs != 0) {
+            ackTimeoutMs = pCfg->ackTimeoutMs;
+        }
+        messageIntervalMs = pCfg->messageIntervalMs;
+    }
+    if ((gnssHandle != NULL) && (pData != NULL) &&
+        (windowSize <= U_GNSS_MGA_UPLOAD_WINDOW_SIZE_MAX) &&
+        (ackTimeoutMs > 0) && (messageIntervalMs >= 0)) {
+        errorCodeOrCount = uPortMutexCreate(&(upload.mutex));
+        if (errorCodeOrCount == 0) {
+            errorCodeOrCount = uPortSemaphoreCreate(&(upload.semaphore), 0, 1);
+            if (errorCodeOrCount == 0) {
+                errorCodeOrCount = ackAidingSet(gnssHandle);
+                if (errorCodeOrCount == 0) {
+                    asyncHandle = uGnssMsgReceiveStart(gnssHandle, &messageId,
+                                                       ackCallback, &upload);
+                    errorCodeOrCount = asyncHandle;
+                    if (asyncHandle >= 0) {
+                        errorCodeOrCount = uploadSend(gnssHandle, &upload, pData, size,
+                                                      windowSize, ackTimeoutMs,
+                                                      messageIntervalMs);
+                        // Wait for the stragglers
+                        windowWait(&upload, 0, ackTimeoutMs);
+                        uGnssMsgReceiveStop(gnssHandle, asyncHandle);
+                    }
+                }
+                uPortSemaphoreDelete(upload.semaphore);
+            }
+            uPortMutexDelete(upload.mutex);
+        }
+        upload.stats.durationMs = uPortGetTickTimeMs() - startTimeMs;
+        if (pStats != NULL) {
+            *pStats = upload.stats;
+        }
+        if (errorCodeOrCount == 0) {
+            errorCodeOrCount = (int32_t) upload.stats.messagesAcked;
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Save the navigation database of a GNSS chip.
+int32_t uGnssMgaDatabaseSave(uDeviceHandle_t gnssHandle,
+                             char *pBuffer, size_t size,
+                             uGnssMgaDatabaseSaveStats_t *pStats)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    uGnssMgaDatabaseSave_t save;
+    uGnssMessageId_t messageId = {.type = U_GNSS_PROTOCOL_UBX,
+                                  .id.ubx = (U_GNSS_MGA_MESSAGE_CLASS << 8) | U_GNSS_MGA_MESSAGE_ID_DBD
+                                 };
+    // Room for a UBX-MGA-DBD poll, which has no body
+    char message[U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES];
+    int32_t asyncHandle;
+
+    memset(&save, 0, sizeof(save));
+    if ((gnssHandle != NULL) && (pBuffer != NULL)) {
+        save.pBuffer = pBuffer;
+        save.size = size;
+        errorCodeOrLength = uPortSemaphoreCreate(&(save.semaphore), 0, 1);
+        if (errorCodeOrLength == 0) {
+            asyncHandle = uGnssMsgReceiveStart(gnssHandle, &messageId,
+                                               dbdCallback, &save);
+            errorCodeOrLength = asyncHandle;
+            if (asyncHandle >= 0) {
+                uUbxProtocolEncode(U_GNSS_MGA_MESSAGE_CLASS, U_GNSS_MGA_MESSAGE_ID_DBD,
+                                   NULL, 0, message);
+                errorCodeOrLength = (int32_t) U_GNSS_ERROR_TRANSPORT;
+                if (uGnssMsgSend(gnssHandle, message, sizeof(message)) == sizeof(message)) {
+                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    // There is no end marker: wait until the messages stop coming
+                    while ((uPortSemaphoreTryTake(save.semaphore,
+                                                  U_GNSS_MGA_DATABASE_SAVE_IDLE_TIMEOUT_MS) == 0) &&
+                           (uPortGetTickTimeMs() - startTimeMs < U_GNSS_MGA_DATABASE_SAVE_TIMEOUT_MS)) {}
+                }
+                uGnssMsgReceiveStop(gnssHandle, asyncHandle);
+            }
+            uPortSemaphoreDelete(save.semaphore);
+        }
+        save.stats.numBytes = save.length;
+        save.stats.durationMs = uPortGetTickTimeMs() - startTimeMs;
+        if (pStats != NULL) {
+            *pStats = save.stats;
+        }
+        if (errorCodeOrLength == 0) {
+            errorCodeOrLength = (int32_t) save.length;
+            if (save.stats.numMessagesLost > 0) {
+                errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            }
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// End of file
@@ -75,12 +75,14 @@
 #include "u_port_debug.h"
 #include "u_port_uart.h"
 #include "u_port_i2c.h"
+#include "u_port_gpio.h"
 
 #include "u_at_client.h"
 
 #include "u_ubx_protocol.h"
 
 #include "u_hex_bin_convert.h"
+#include "u_mempool.h" // uMemPoolMalloc(), uMemPoolFree()
 
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
@@ -116,6 +118,15 @@
 # define U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS 50
 #endif
 
+#ifndef U_GNSS_MSG_DATA_READY_WAIT_MAX_MS
+/** When a TX-ready pin is in use (see uGnssSetPinDataReady()), the
+ * maximum time that the asynchronous message receive task will sleep
+ * waiting for it; this is a backstop in case fewer than
+ * #U_GNSS_DATA_READY_THRESHOLD_BYTES are left in the GNSS chip.
+ */
+# define U_GNSS_MSG_DATA_READY_WAIT_MAX_MS 1000
+#endif
+
 #if U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS < U_CFG_OS_YIELD_MS
 /* U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS must be at least as big as U_CFG_OS_YIELD_MS
  * or the asynchronous message receive task will be all-consuming.
@@ -131,6 +142,12 @@
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
+/** Profiling probe for the decoding and dispatching of a message by
+ * the asynchronous message receive task, units being messages, if
+ * U_CFG_PROFILE is defined.
+ */
+U_PORT_PROFILE_PROBE(gnssMsgDispatch);
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -145,6 +162,7 @@ static void msgReceiveTask(void *pParam)
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_UNKNOWN;
     int32_t receiveSize;
     int32_t yieldTimeMs;
+    int32_t pinDataReady;
     size_t discardSize = 0;
     uGnssMessageId_t messageId;
     uGnssPrivateMessageId_t privateMessageId;
@@ -160,7 +178,7 @@ static void msgReceiveTask(void *pParam)
     // will cause us to exit
     while (uPortQueueTryReceive(pMsgReceive->taskExitQueueHandle, 0, queueItem) < 0) {
 
-        // Note that this does NOT lock gUGnssPrivateMutex: it doesn't need to,
+        // Note that this does NOT lock the instance: it doesn't need to,
         // provided this task is brought up and torn down in an organised way
 
         // Pull stuff into the ring buffer
@@ -176,6 +194,7 @@ static void msgReceiveTask(void *pParam)
             // Run around a loop processing the data from the ring buffer
             // for as long as we're still finding messages in it
             while (errorCodeOrLength > 0) {
+                U_PORT_PROFILE_BEGIN(gnssMsgDispatch);
                 privateMessageId.type = U_GNSS_PROTOCOL_ALL;
                 // Attempt to decode a message of any type from the ring buffer
                 errorCodeOrLength = uGnssPrivateStreamDecodeRingBuffer(pInstance,
@@ -187,13 +206,21 @@ static void msgReceiveTask(void *pParam)
                     if (errorCodeOrLength > 0) {
                         pMsgReceive->msgBytesLeftToRead = errorCodeOrLength;
                     }
-
-                    if (uGnssPrivateMessageIdToPublic(&privateMessageId, &messageId, nmeaId) == 0) {
+                    // Note when it arrived, before any reader moves
+                    // the read pointer on
+                    pMsgReceive->msgArrivalTimeValid = (uGnssPrivateStreamGetArrivalTime(pInstance,
+                                                                                         pMsgReceive->ringBufferReadHandle,
+                                                                                         &(pMsgReceive->msgArrivalTimeMs)) == 0);
+
+                    U_PORT_MUTEX_LOCK(pMsgReceive->readerMutexHandle);
+                    U_PORT_SPAN_BEGIN("gnssMsgDispatch");
+
+                    // Only bother with the readers if the filter says
+                    // that one of them might be interested
+                    if (uGnssPrivateMsgFilterMatch(&(pMsgReceive->filter), &privateMessageId) &&
+                        (uGnssPrivateMessageIdToPublic(&privateMessageId, &messageId, nmeaId) == 0)) {
                         // Got something, with a message ID now in public form;
                         // go through the list of readers looking for those interested
-
-                        U_PORT_MUTEX_LOCK(pMsgReceive->readerMutexHandle);
-
                         pReader = pMsgReceive->pReaderList;
                         while (pReader != NULL) {
                             if (uGnssPrivateMessageIdIsWanted(&privateMessageId,
@@ -207,15 +234,17 @@ static void msgReceiveTask(void *pParam)
                             // Next!
                             pReader = pReader->pNext;
                         }
-
-                        U_PORT_MUTEX_UNLOCK(pMsgReceive->readerMutexHandle);
                     }
 
+                    U_PORT_SPAN_END();
+                    U_PORT_MUTEX_UNLOCK(pMsgReceive->readerMutexHandle);
+
                     // Clear out any remaining data
                     uRingBufferReadHandle(&(pInstance->ringBuffer),
                                           pMsgReceive->ringBufferReadHandle, NULL,
                                           pMsgReceive->msgBytesLeftToRead);
                 }
+                U_PORT_PROFILE_END(gnssMsgDispatch, (errorCodeOrLength > 0) ? 1 : 0);
             }
         }
 
@@ -226,7 +255,19 @@ static void msgReceiveTask(void *pParam)
         if ((receiveSize == 0) && (errorCodeOrLength != (int32_t) U_ERROR_COMMON_TIMEOUT))  {
             yieldTimeMs *= 2;
         }
-        uPortTaskBlock(yieldTimeMs);
+        pinDataReady = pInstance->pinDataReady;
+        if ((pinDataReady >= 0) && (receiveSize == 0) &&
+            (errorCodeOrLength != (int32_t) U_ERROR_COMMON_TIMEOUT) &&
+            (uPortGpioGet(pinDataReady) == 0)) {
+            // The GNSS chip has told us it has nothing for us: rather
+            // than polling it, sleep until its TX-ready pin goes active;
+            // if it goes active after the check above the semaphore
+            // will already have been given so nothing is missed
+            uPortSemaphoreTryTake(pInstance->dataReadySemaphore,
+                                  U_GNSS_MSG_DATA_READY_WAIT_MAX_MS);
+        } else {
+            uPortTaskBlock(yieldTimeMs);
+        }
     }
 
     // Now we can unlock our ring buffer read handle.  Phew.
@@ -239,6 +280,88 @@ static void msgReceiveTask(void *pParam)
     uPortTaskDelete(NULL);
 }
 
+// Start the message receive task, if it is not already running.
+// Note: the instance should be locked before this is called.
+static int32_t msgReceiveTaskStart(uGnssPrivateInstance_t *pInstance)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    uGnssPrivateMsgReceive_t *pMsgReceive;
+    const char *pTaskName = "gnssMsgRx";
+
+    if (pInstance->pMsgReceive == NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pInstance->pMsgReceive = (uGnssPrivateMsgReceive_t *) malloc(sizeof(uGnssPrivateMsgReceive_t));
+        if (pInstance->pMsgReceive != NULL) {
+            pMsgReceive = pInstance->pMsgReceive;
+            memset(pMsgReceive, 0, sizeof(*pMsgReceive));
+            // Take a "master" read handle
+            pMsgReceive->ringBufferReadHandle = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
+            if (pMsgReceive->ringBufferReadHandle >= 0) {
+                // Allocate a temporary buffer that we can use to pull data
+                // from the streaming source into the ring-buffer from our
+                // asynchronous task
+                pMsgReceive->pTemporaryBuffer = (char *) malloc(pInstance->temporaryBufferLengthBytes);
+                if (pMsgReceive->pTemporaryBuffer != NULL) {
+                    // Create the mutex that controls access to the linked-list of readers
+                    errorCode = uPortMutexCreate(&(pMsgReceive->readerMutexHandle));
+                    if (errorCode == 0) {
+                        // Create the queue that allows us to get the task to exit
+                        errorCode = uPortQueueCreate(U_GNSS_MSG_RECEIVE_TASK_QUEUE_LENGTH,
+                                                     U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES,
+                                                     &(pMsgReceive->taskExitQueueHandle));
+                        if (errorCode == 0) {
+                            // Create the mutex for task running status
+                            errorCode = uPortMutexCreate(&(pMsgReceive->taskRunningMutexHandle));
+                            if (errorCode == 0) {
+                                //... and then the task
+                                errorCode = uPortTaskCreate(msgReceiveTask,
+                                                            pTaskName,
+                                                            U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES,
+                                                            pInstance, U_GNSS_MSG_RECEIVE_TASK_PRIORITY,
+                                                            &(pMsgReceive->taskHandle));
+                                if (errorCode == 0) {
+                                    // Wait for the task to lock the mutex,
+                                    // which shows it is running
+                                    while (uPortMutexTryLock(pMsgReceive->taskRunningMutexHandle, 0) == 0) {
+                                        uPortMutexUnlock(pMsgReceive->taskRunningMutexHandle);
+                                        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+                if (errorCode != 0) {
+                    // Tidy up if we couldn't get OS resources
+                    if (pMsgReceive->taskHandle != NULL) {
+                        uPortTaskDelete(msgReceiveTask);
+                    }
+                    if (pMsgReceive->taskRunningMutexHandle != NULL) {
+                        uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
+                    }
+                    if (pMsgReceive->taskExitQueueHandle != NULL) {
+                        uPortQueueDelete(pMsgReceive->taskExitQueueHandle);
+                    }
+                    if (pMsgReceive->readerMutexHandle != NULL) {
+                        uPortMutexDelete(pMsgReceive->readerMutexHandle);
+                    }
+                    free(pMsgReceive->pTemporaryBuffer);
+                    uRingBufferGiveReadHandle(&(pInstance->ringBuffer),
+                                              pMsgReceive->ringBufferReadHandle);
+                    free(pInstance->pMsgReceive);
+                    pInstance->pMsgReceive = NULL;
+                }
+            } else {
+                // Out of handles already
+                free(pInstance->pMsgReceive);
+                pInstance->pMsgReceive = NULL;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 // Read a message from the ring buffer into a user's buffer.
 int32_t msgReceiveCallbackRead(uDeviceHandle_t gnssHandle,
                                char *pBuffer, size_t size,
@@ -277,6 +400,22 @@ int32_t msgReceiveCallbackRead(uDeviceHandle_t gnssHandle,
     return errorCodeOrLength;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS THAT ARE PRIVATE TO GNSS
+ * -------------------------------------------------------------- */
+
+// Start the message receive task without adding a reader.
+int32_t uGnssPrivateStartMsgReceive(uGnssPrivateInstance_t *pInstance)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pInstance != NULL) {
+        errorCode = msgReceiveTaskStart(pInstance);
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
@@ -324,9 +463,8 @@ void uGnssMsgReceiveFlush(uDeviceHandle_t gnssHandle, bool asyncAlso)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             // Bring any existing new data into the ring buffer first
             uGnssPrivateStreamFillRingBuffer(pInstance,
@@ -341,7 +479,7 @@ void uGnssMsgReceiveFlush(uDeviceHandle_t gnssHandle, bool asyncAlso)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 }
 
@@ -355,10 +493,9 @@ int32_t uGnssMsgSend(uDeviceHandle_t gnssHandle, const char *pBuffer, size_t siz
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (pBuffer != NULL)) {
 
             errorCodeOrLength = (int32_t) U_GNSS_ERROR_TRANSPORT;
@@ -373,6 +510,9 @@ int32_t uGnssMsgSend(uDeviceHandle_t gnssHandle, const char *pBuffer, size_t siz
                 case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
                     streamHandle = pInstance->transportHandle.i2c;
                     break;
+                case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+                    streamHandle = pInstance->transportHandle.spi;
+                    break;
                 default:
                     break;
             }
@@ -392,6 +532,11 @@ int32_t uGnssMsgSend(uDeviceHandle_t gnssHandle, const char *pBuffer, size_t siz
                             errorCodeOrLength = (int32_t) size;
                         }
                         break;
+                    case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+                        // Anything received during the send is kept
+                        errorCodeOrLength = uGnssPrivateStreamSendSpi(pInstance,
+                                                                      pBuffer, size);
+                        break;
                     default:
                         break;
                 }
@@ -407,7 +552,7 @@ int32_t uGnssMsgSend(uDeviceHandle_t gnssHandle, const char *pBuffer, size_t siz
             U_PORT_MUTEX_UNLOCK(pInstance->transportMutex);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrLength;
@@ -425,26 +570,55 @@ int32_t uGnssMsgReceive(uDeviceHandle_t gnssHandle,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (pMessageId != NULL) &&
             (uGnssPrivateMessageIdToPrivate(pMessageId, &privateMessageId) == 0)) {
+            pInstance->receiveArrivalTimeValid = false;
             errorCodeOrLength = uGnssPrivateReceiveStreamMessage(pInstance,
                                                                  &privateMessageId,
                                                                  pInstance->ringBufferReadHandleMsgReceive,
                                                                  ppBuffer, size,
                                                                  timeoutMs,
                                                                  pKeepGoingCallback);
+            pInstance->msgReceiveArrivalTimeMs = pInstance->receiveArrivalTimeMs;
+            pInstance->msgReceiveArrivalTimeValid = (errorCodeOrLength > 0) &&
+                                                    pInstance->receiveArrivalTimeValid;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrLength;
 }
 
+// Get the arrival time of the message last returned by uGnssMsgReceive().
+int32_t uGnssMsgReceiveGetArrivalTime(uDeviceHandle_t gnssHandle,
+                                      int32_t *pTimeMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pTimeMs != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (pInstance->msgReceiveArrivalTimeValid) {
+                *pTimeMs = pInstance->msgReceiveArrivalTimeMs;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
 // Monitor the output of the GNSS chip for a message, async version.
 int32_t uGnssMsgReceiveStart(uDeviceHandle_t gnssHandle,
                              const uGnssMessageId_t *pMessageId,
@@ -453,95 +627,24 @@ int32_t uGnssMsgReceiveStart(uDeviceHandle_t gnssHandle,
 {
     int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
-    uGnssPrivateMsgReceive_t *pMsgReceive;
     uGnssPrivateMsgReader_t *pReader;
-    const char *pTaskName = "gnssMsgRx";
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (pMessageId != NULL) && (pCallback != NULL)) {
             errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-            pReader = (uGnssPrivateMsgReader_t *) malloc(sizeof(uGnssPrivateMsgReader_t));
+            pReader = (uGnssPrivateMsgReader_t *) uMemPoolMalloc(sizeof(uGnssPrivateMsgReader_t));
             if (pReader != NULL) {
                 memset(pReader, 0, sizeof(*pReader));
                 // If the message receive task is not running
                 // at the moment, start it
-                if (pInstance->pMsgReceive == NULL) {
-                    pInstance->pMsgReceive = (uGnssPrivateMsgReceive_t *) malloc(sizeof(uGnssPrivateMsgReceive_t));
-                    if (pInstance->pMsgReceive != NULL) {
-                        pMsgReceive = pInstance->pMsgReceive;
-                        memset(pMsgReceive, 0, sizeof(*pMsgReceive));
-                        // Take a "master" read handle
-                        pMsgReceive->ringBufferReadHandle = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
-                        if (pMsgReceive->ringBufferReadHandle >= 0) {
-                            // Allocate a temporary buffer that we can use to pull data
-                            // from the streaming source into the ring-buffer from our
-                            // asynchronous task
-                            pMsgReceive->pTemporaryBuffer = (char *) malloc(U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
-                            if (pMsgReceive->pTemporaryBuffer != NULL) {
-                                // Create the mutex that controls access to the linked-list of readers
-                                errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->readerMutexHandle));
-                                if (errorCodeOrHandle == 0) {
-                                    // Create the queue that allows us to get the task to exit
-                                    errorCodeOrHandle = uPortQueueCreate(U_GNSS_MSG_RECEIVE_TASK_QUEUE_LENGTH,
-                                                                         U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES,
-                                                                         &(pMsgReceive->taskExitQueueHandle));
-                                    if (errorCodeOrHandle == 0) {
-                                        // Create the mutex for task running status
-                                        errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->taskRunningMutexHandle));
-                                        if (errorCodeOrHandle == 0) {
-                                            //... and then the task
-                                            errorCodeOrHandle = uPortTaskCreate(msgReceiveTask,
-                                                                                pTaskName,
-                                                                                U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES,
-                                                                                pInstance, U_GNSS_MSG_RECEIVE_TASK_PRIORITY,
-                                                                                &(pMsgReceive->taskHandle));
-                                            if (errorCodeOrHandle == 0) {
-                                                // Wait for the task to lock the mutex,
-                                                // which shows it is running
-                                                while (uPortMutexTryLock(pMsgReceive->taskRunningMutexHandle, 0) == 0) {
-                                                    uPortMutexUnlock(pMsgReceive->taskRunningMutexHandle);
-                                                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                            if (errorCodeOrHandle != 0) {
-                                // Tidy up if we couldn't get OS resources
-                                if (pMsgReceive->taskHandle != NULL) {
-                                    uPortTaskDelete(msgReceiveTask);
-                                }
-                                if (pMsgReceive->taskRunningMutexHandle != NULL) {
-                                    uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
-                                }
-                                if (pMsgReceive->taskExitQueueHandle != NULL) {
-                                    uPortQueueDelete(pMsgReceive->taskExitQueueHandle);
-                                }
-                                if (pMsgReceive->readerMutexHandle != NULL) {
-                                    uPortMutexDelete(pMsgReceive->readerMutexHandle);
-                                }
-                                free(pInstance->pTemporaryBuffer);
-                                uRingBufferGiveReadHandle(&(pInstance->ringBuffer),
-                                                          pMsgReceive->ringBufferReadHandle);
-                                free(pInstance->pMsgReceive);
-                                pInstance->pMsgReceive = NULL;
-                            }
-                        } else {
-                            // Out of handles already
-                            free(pInstance->pMsgReceive);
-                            pInstance->pMsgReceive = NULL;
-                        }
-                    }
-                }
+                errorCodeOrHandle = msgReceiveTaskStart(pInstance);
                 if (pInstance->pMsgReceive == NULL) {
                     // Clean up on error
-                    free(pReader);
+                    uMemPoolFree(pReader);
                     pReader = NULL;
                 }
             }
@@ -559,6 +662,8 @@ int32_t uGnssMsgReceiveStart(uDeviceHandle_t gnssHandle,
                 U_PORT_MUTEX_LOCK(pInstance->pMsgReceive->readerMutexHandle);
 
                 pInstance->pMsgReceive->pReaderList = pReader;
+                uGnssPrivateMsgFilterAdd(&(pInstance->pMsgReceive->filter),
+                                         &(pReader->privateMessageId));
 
                 U_PORT_MUTEX_UNLOCK(pInstance->pMsgReceive->readerMutexHandle);
 
@@ -567,14 +672,14 @@ int32_t uGnssMsgReceiveStart(uDeviceHandle_t gnssHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrHandle;
 }
 
 // Read a message from the ring buffer into a user's buffer.
-// This function does NOT lock gUGnssPrivateMutex in order
+// This function does NOT lock the instance in order
 // that it can be called from pCallback; this is fine since
 // the asynchronous receive task is brought up and torn down
 // in an organised way.
@@ -585,7 +690,7 @@ int32_t uGnssMsgReceiveCallbackRead(uDeviceHandle_t gnssHandle,
 }
 
 // Extract a message from the ring buffer into a user's buffer.
-// This function does NOT lock gUGnssPrivateMutex in order
+// This function does NOT lock the instance in order
 // that it can be called from pCallback; this is fine since
 // the asynchronous receive task is brought up and torn down
 // in an organised way.
@@ -595,6 +700,69 @@ int32_t uGnssMsgReceiveCallbackExtract(uDeviceHandle_t gnssHandle,
     return msgReceiveCallbackRead(gnssHandle, pBuffer, size, true);
 }
 
+// Look at a message in place in the ring buffer.
+// This function does NOT lock the instance in order
+// that it can be called from pCallback; this is fine since
+// the asynchronous receive task is brought up and torn down
+// in an organised way.
+int32_t uGnssMsgReceiveCallbackView(uDeviceHandle_t gnssHandle,
+                                    const char **ppBuffer)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssPrivateMsgReceive_t *pMsgReceive;
+    uGnssPrivateInstance_t *pInstance;
+    size_t size;
+
+    pInstance = pUGnssPrivateGetInstance(gnssHandle);
+    if ((pInstance != NULL) && (ppBuffer != NULL)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        pMsgReceive = pInstance->pMsgReceive;
+        if ((pMsgReceive != NULL) &&
+            uPortTaskIsThis(pMsgReceive->taskHandle)) {
+            // The task keeps its read handle locked, so what is
+            // there can't be overwritten while the callback runs
+            size = uRingBufferPeekContiguousHandle(&(pInstance->ringBuffer),
+                                                   pMsgReceive->ringBufferReadHandle,
+                                                   ppBuffer, 0);
+            if (size > pMsgReceive->msgBytesLeftToRead) {
+                size = pMsgReceive->msgBytesLeftToRead;
+            }
+            errorCodeOrLength = (int32_t) size;
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// Get the arrival time of the message passed to a callback.
+// This function does NOT lock the instance in order
+// that it can be called from pCallback; this is fine since
+// the asynchronous receive task is brought up and torn down
+// in an organised way.
+int32_t uGnssMsgReceiveCallbackGetArrivalTime(uDeviceHandle_t gnssHandle,
+                                              int32_t *pTimeMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssPrivateMsgReceive_t *pMsgReceive;
+    uGnssPrivateInstance_t *pInstance;
+
+    pInstance = pUGnssPrivateGetInstance(gnssHandle);
+    if ((pInstance != NULL) && (pTimeMs != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        pMsgReceive = pInstance->pMsgReceive;
+        if ((pMsgReceive != NULL) &&
+            uPortTaskIsThis(pMsgReceive->taskHandle)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (pMsgReceive->msgArrivalTimeValid) {
+                *pTimeMs = pMsgReceive->msgArrivalTimeMs;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 // Stop monitoring the output of the GNSS chip for a message.
 int32_t uGnssMsgReceiveStop(uDeviceHandle_t gnssHandle, int32_t asyncHandle)
 {
@@ -606,10 +774,9 @@ int32_t uGnssMsgReceiveStop(uDeviceHandle_t gnssHandle, int32_t asyncHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
             if (pInstance->pMsgReceive != NULL) {
@@ -627,7 +794,7 @@ int32_t uGnssMsgReceiveStop(uDeviceHandle_t gnssHandle, int32_t asyncHandle)
                         } else {
                             pMsgReceive->pReaderList = pCurrent->pNext;
                         }
-                        free(pCurrent);
+                        uMemPoolFree(pCurrent);
                         pCurrent = NULL;
                         errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                     } else {
@@ -635,18 +802,28 @@ int32_t uGnssMsgReceiveStop(uDeviceHandle_t gnssHandle, int32_t asyncHandle)
                         pCurrent = pPrev->pNext;
                     }
                 }
+                if (errorCode == 0) {
+                    // Rebuild the filter from the readers that are left
+                    memset(&(pMsgReceive->filter), 0, sizeof(pMsgReceive->filter));
+                    pCurrent = pMsgReceive->pReaderList;
+                    while (pCurrent != NULL) {
+                        uGnssPrivateMsgFilterAdd(&(pMsgReceive->filter),
+                                                 &(pCurrent->privateMessageId));
+                        pCurrent = pCurrent->pNext;
+                    }
+                }
 
                 U_PORT_MUTEX_UNLOCK(pMsgReceive->readerMutexHandle);
 
-                if (pMsgReceive->pReaderList == NULL) {
-                    // All gone, shut the task etc. down also
+                if ((pMsgReceive->pReaderList == NULL) && (pInstance->pLog == NULL)) {
+                    // All gone and not needed by a log, shut the task etc. down also
                     uGnssPrivateStopMsgReceive(pInstance);
                 }
 
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -657,20 +834,33 @@ int32_t uGnssMsgReceiveStopAll(uDeviceHandle_t gnssHandle)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateMsgReader_t *pReader;
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-            // We can just call the shut down function to lose the lot
-            uGnssPrivateStopMsgReceive(pInstance);
+            if (pInstance->pLog == NULL) {
+                // We can just call the shut down function to lose the lot
+                uGnssPrivateStopMsgReceive(pInstance);
+            } else if (pInstance->pMsgReceive != NULL) {
+                // A log needs the task to keep running, just lose the readers
+                U_PORT_MUTEX_LOCK(pInstance->pMsgReceive->readerMutexHandle);
+                while (pInstance->pMsgReceive->pReaderList != NULL) {
+                    pReader = pInstance->pMsgReceive->pReaderList->pNext;
+                    uMemPoolFree(pInstance->pMsgReceive->pReaderList);
+                    pInstance->pMsgReceive->pReaderList = pReader;
+                }
+                memset(&(pInstance->pMsgReceive->filter), 0,
+                       sizeof(pInstance->pMsgReceive->filter));
+                U_PORT_MUTEX_UNLOCK(pInstance->pMsgReceive->readerMutexHandle);
+            }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -684,15 +874,14 @@ int32_t uGnssMsgReceiveStackMinFree(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrStackMinFree = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL)) {
             errorCodeOrStackMinFree = uPortTaskStackMinFree(pInstance->pMsgReceive->taskHandle);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrStackMinFree;
@@ -706,15 +895,14 @@ size_t uGnssMsgReceiveStatReadLoss(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL)) {
             bytesLost = uRingBufferStatReadLossHandle(&(pInstance->ringBuffer),
                                                       pInstance->pMsgReceive->ringBufferReadHandle);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return bytesLost;
@@ -728,17 +916,100 @@ size_t uGnssMsgReceiveStatStreamLoss(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             bytesLost = uRingBufferStatAddLoss(&(pInstance->ringBuffer));
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return bytesLost;
 }
 
+// The most data there has been waiting for the non-blocking message
+// receive handler.
+size_t uGnssMsgReceiveStatReadHighWaterMark(uDeviceHandle_t gnssHandle)
+{
+    size_t highWaterMark = 0;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL)) {
+            highWaterMark = pInstance->pMsgReceive->highWaterMark;
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return highWaterMark;
+}
+
+// The most of the ring buffer that has been in use.
+size_t uGnssMsgReceiveStatStreamHighWaterMark(uDeviceHandle_t gnssHandle)
+{
+    size_t highWaterMark = 0;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if (pInstance != NULL) {
+            highWaterMark = pInstance->ringBufferStreamHighWaterMark;
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return highWaterMark;
+}
+
+// The number of times data has been pushed out of the ring buffer.
+size_t uGnssMsgReceiveStatStreamEvictions(uDeviceHandle_t gnssHandle)
+{
+    size_t evictions = 0;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if (pInstance != NULL) {
+            evictions = uRingBufferStatForcedAddEvictions(&(pInstance->ringBuffer));
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return evictions;
+}
+
+// The occupancy histogram of the ring buffer.
+int32_t uGnssMsgReceiveStatStreamOccupancy(uDeviceHandle_t gnssHandle,
+                                           size_t *pBins, size_t numBins)
+{
+    int32_t errorCodeOrNumBins = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCodeOrNumBins = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pBins != NULL)) {
+            errorCodeOrNumBins = (int32_t) uRingBufferStatOccupancy(&(pInstance->ringBuffer),
+                                                                    pBins, numBins);
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCodeOrNumBins;
+}
+
 // End of file
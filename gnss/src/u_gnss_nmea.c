@@ -0,0 +1,503 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief This source file contains the implementation of the NMEA
+ * sentence decoders of the GNSS API.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset(), memcmp()
+
+#include "u_error_common.h"
+
+#include "u_device.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"    // U_GNSS_ERROR_CRC
+#include "u_gnss_nmea.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The length of the address field of a sentence, e.g. "GPGGA":
+ * a two character talker and a three character sentence formatter.
+ */
+#define U_GNSS_NMEA_ADDRESS_LENGTH 5
+
+/** The largest magnitude accepted while converting a number, keeping
+ * well clear of overflow of an int64_t however it is scaled later.
+ */
+#define U_GNSS_NMEA_NUMBER_MAX 1000000000000000LL
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Where we are in a sentence: each character is looked at once,
+ * as the fields are stepped over, and added to the checksum then.
+ */
+typedef struct {
+    const char *pNext; /**< the start of the next field. */
+    const char *pEnd;  /**< one beyond the last character. */
+    uint8_t checksum;
+    bool atEnd;        /**< true once the '*' has been passed. */
+    bool truncated;    /**< true if the sentence ended without a '*'. */
+} uGnssNmeaCursor_t;
+
+/** A field in a sentence, NOT null-terminated.
+ */
+typedef struct {
+    const char *pStart;
+    size_t length;
+} uGnssNmeaField_t;
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: TOKENIZING
+ * -------------------------------------------------------------- */
+
+// Get the next field of a sentence; once the end has been reached
+// every field is empty.
+static void fieldNext(uGnssNmeaCursor_t *pCursor, uGnssNmeaField_t *pField)
+{
+    pField->pStart = pCursor->pNext;
+    pField->length = 0;
+    if (!pCursor->atEnd) {
+        while ((pCursor->pNext < pCursor->pEnd) &&
+               (*pCursor->pNext != ',') && (*pCursor->pNext != '*')) {
+            pCursor->checksum ^= (uint8_t) *pCursor->pNext;
+            pCursor->pNext++;
+            pField->length++;
+        }
+        if (pCursor->pNext < pCursor->pEnd) {
+            if (*pCursor->pNext == ',') {
+                pCursor->checksum ^= (uint8_t) ',';
+            } else {
+                pCursor->atEnd = true;
+            }
+            pCursor->pNext++;
+        } else {
+            pCursor->atEnd = true;
+            pCursor->truncated = true;
+        }
+    }
+}
+
+// Start on a sentence, checking that it is of the given type.
+static int32_t cursorStart(uGnssNmeaCursor_t *pCursor,
+                           const char *pSentence, size_t size,
+                           const char *pType)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssNmeaField_t field;
+
+    if (pSentence != NULL) {
+        errorCode = (int32_t) U_GNSS_ERROR_CRC;
+        if ((size > 0) && (*pSentence == '$')) {
+            memset(pCursor, 0, sizeof(*pCursor));
+            pCursor->pNext = pSentence + 1;
+            pCursor->pEnd = pSentence + size;
+            fieldNext(pCursor, &field);
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if ((field.length == U_GNSS_NMEA_ADDRESS_LENGTH) &&
+                (memcmp(field.pStart + U_GNSS_NMEA_ADDRESS_LENGTH - 3, pType, 3) == 0)) {
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Convert a hex character to a value, -1 if it is not hex.
+static int32_t hexValue(char c)
+{
+    int32_t value = -1;
+
+    if ((c >= '0') && (c <= '9')) {
+        value = c - '0';
+    } else if ((c >= 'A') && (c <= 'F')) {
+        value = c - 'A' + 10;
+    } else if ((c >= 'a') && (c <= 'f')) {
+        value = c - 'a' + 10;
+    }
+
+    return value;
+}
+
+// Finish a sentence: step over any remaining fields and check
+// the checksum.
+static int32_t cursorFinish(uGnssNmeaCursor_t *pCursor)
+{
+    int32_t errorCode = (int32_t) U_GNSS_ERROR_CRC;
+    uGnssNmeaField_t field;
+    int32_t high;
+    int32_t low;
+
+    while (!pCursor->atEnd) {
+        fieldNext(pCursor, &field);
+    }
+    if (!pCursor->truncated && (pCursor->pNext + 2 <= pCursor->pEnd)) {
+        high = hexValue(*pCursor->pNext);
+        low = hexValue(*(pCursor->pNext + 1));
+        if ((high >= 0) && (low >= 0) &&
+            (((high << 4) | low) == pCursor->checksum)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: FIELD CONVERSION
+ * -------------------------------------------------------------- */
+
+// Convert a field holding a decimal number, e.g. "-12.345", to an
+// integer scaled by 10 to the power decimals, dropping any further
+// digits; returns false if the field is empty or not a number.
+static bool fieldToInt64(const uGnssNmeaField_t *pField, int32_t decimals,
+                         int64_t *pValue)
+{
+    bool success = false;
+    bool negative = false;
+    bool point = false;
+    int64_t value = 0;
+    size_t x = 0;
+    char c;
+
+    if ((pField->length > 0) &&
+        ((*pField->pStart == '-') || (*pField->pStart == '+'))) {
+        negative = (*pField->pStart == '-');
+        x++;
+    }
+    for (; x < pField->length; x++) {
+        c = *(pField->pStart + x);
+        if ((c == '.') && !point) {
+            point = true;
+        } else if ((c >= '0') && (c <= '9') && (value < U_GNSS_NMEA_NUMBER_MAX)) {
+            if (!point || (decimals > 0)) {
+                value = (value * 10) + (c - '0');
+                if (point) {
+                    decimals--;
+                }
+            }
+            success = true;
+        } else {
+            success = false;
+            break;
+        }
+    }
+    if (success) {
+        for (; decimals > 0; decimals--) {
+            value *= 10;
+        }
+        *pValue = negative ? -value : value;
+    }
+
+    return success;
+}
+
+// As fieldToInt64() but for a result that fits an int32_t,
+// U_GNSS_NMEA_EMPTY if there isn't one.
+static int32_t fieldToInt(const uGnssNmeaField_t *pField, int32_t decimals)
+{
+    int32_t value = U_GNSS_NMEA_EMPTY;
+    int64_t x;
+
+    if (fieldToInt64(pField, decimals, &x) &&
+        (x > INT32_MIN) && (x <= INT32_MAX)) {
+        value = (int32_t) x;
+    }
+
+    return value;
+}
+
+// The first character of a field, zero if it is empty.
+static char fieldToChar(const uGnssNmeaField_t *pField)
+{
+    return (pField->length > 0) ? *pField->pStart : 0;
+}
+
+// Read a "hhmmss.sss" time field as milliseconds since midnight.
+static int32_t timeGet(uGnssNmeaCursor_t *pCursor)
+{
+    int32_t timeMs = U_GNSS_NMEA_EMPTY;
+    uGnssNmeaField_t field;
+    int64_t x;
+
+    fieldNext(pCursor, &field);
+    if (fieldToInt64(&field, 3, &x) && (x >= 0)) {
+        // x is hhmmss * 1000 + milliseconds
+        timeMs = (int32_t) (((x / 10000000) * 3600000) +
+                            (((x / 100000) % 100) * 60000) +
+                            (x % 100000));
+    }
+
+    return timeMs;
+}
+
+// Read a "dddmm.mmmmm" latitude or longitude field plus the following
+// hemisphere field as degrees * 10^7.
+static int32_t latLongGet(uGnssNmeaCursor_t *pCursor)
+{
+    int32_t valueX1e7 = U_GNSS_NMEA_EMPTY;
+    uGnssNmeaField_t field;
+    int64_t x;
+    char hemisphere;
+
+    fieldNext(pCursor, &field);
+    if (fieldToInt64(&field, 7, &x) && (x >= 0)) {
+        // x is degrees * 10^9 + minutes * 10^7
+        valueX1e7 = (int32_t) (((x / 1000000000) * 10000000) +
+                               ((x % 1000000000) / 60));
+    }
+    fieldNext(pCursor, &field);
+    hemisphere = fieldToChar(&field);
+    if ((valueX1e7 != U_GNSS_NMEA_EMPTY) &&
+        ((hemisphere == 'S') || (hemisphere == 'W'))) {
+        valueX1e7 = -valueX1e7;
+    }
+
+    return valueX1e7;
+}
+
+// Read a decimal number field scaled by 10 to the power decimals.
+static int32_t intGet(uGnssNmeaCursor_t *pCursor, int32_t decimals)
+{
+    uGnssNmeaField_t field;
+
+    fieldNext(pCursor, &field);
+    return fieldToInt(&field, decimals);
+}
+
+// Read a speed field, in units of unitMillimetresPerHour, as
+// millimetres per second.
+static int32_t speedGet(uGnssNmeaCursor_t *pCursor,
+                        int64_t unitMillimetresPerHour)
+{
+    int32_t speedMillimetresPerSecond = U_GNSS_NMEA_EMPTY;
+    uGnssNmeaField_t field;
+    int64_t x;
+
+    fieldNext(pCursor, &field);
+    if (fieldToInt64(&field, 3, &x)) {
+        speedMillimetresPerSecond = (int32_t) ((x * unitMillimetresPerHour) / (3600 * 1000));
+    }
+
+    return speedMillimetresPerSecond;
+}
+
+// Read a character field.
+static char charGet(uGnssNmeaCursor_t *pCursor)
+{
+    uGnssNmeaField_t field;
+
+    fieldNext(pCursor, &field);
+    return fieldToChar(&field);
+}
+
+// Step over a number of fields.
+static void skip(uGnssNmeaCursor_t *pCursor, size_t numFields)
+{
+    uGnssNmeaField_t field;
+
+    for (size_t x = 0; x < numFields; x++) {
+        fieldNext(pCursor, &field);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Decode GGA.
+int32_t uGnssNmeaDecodeGga(const char *pSentence, size_t size,
+                           uGnssNmeaGga_t *pGga)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssNmeaCursor_t cursor;
+
+    if (pGga != NULL) {
+        errorCode = cursorStart(&cursor, pSentence, size, "GGA");
+        if (errorCode == 0) {
+            pGga->timeOfDayMs = timeGet(&cursor);
+            pGga->latitudeX1e7 = latLongGet(&cursor);
+            pGga->longitudeX1e7 = latLongGet(&cursor);
+            pGga->quality = intGet(&cursor, 0);
+            pGga->numSvs = intGet(&cursor, 0);
+            pGga->hdopX100 = intGet(&cursor, 2);
+            pGga->altitudeMillimetres = intGet(&cursor, 3);
+            skip(&cursor, 1); // Units, always M
+            pGga->geoidSeparationMillimetres = intGet(&cursor, 3);
+            errorCode = cursorFinish(&cursor);
+        }
+    }
+
+    return errorCode;
+}
+
+// Decode RMC.
+int32_t uGnssNmeaDecodeRmc(const char *pSentence, size_t size,
+                           uGnssNmeaRmc_t *pRmc)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssNmeaCursor_t cursor;
+    int32_t date;
+
+    if (pRmc != NULL) {
+        errorCode = cursorStart(&cursor, pSentence, size, "RMC");
+        if (errorCode == 0) {
+            pRmc->timeOfDayMs = timeGet(&cursor);
+            pRmc->valid = (charGet(&cursor) == 'A');
+            pRmc->latitudeX1e7 = latLongGet(&cursor);
+            pRmc->longitudeX1e7 = latLongGet(&cursor);
+            // 1852 metres in a nautical mile
+            pRmc->speedMillimetresPerSecond = speedGet(&cursor, 1852000);
+            pRmc->courseX100 = intGet(&cursor, 2);
+            // ddmmyy
+            date = intGet(&cursor, 0);
+            pRmc->day = U_GNSS_NMEA_EMPTY;
+            pRmc->month = U_GNSS_NMEA_EMPTY;
+            pRmc->year = U_GNSS_NMEA_EMPTY;
+            if (date >= 0) {
+                pRmc->day = date / 10000;
+                pRmc->month = (date / 100) % 100;
+                pRmc->year = 2000 + (date % 100);
+            }
+            skip(&cursor, 2); // Magnetic variation and its direction
+            pRmc->mode = charGet(&cursor);
+            errorCode = cursorFinish(&cursor);
+        }
+    }
+
+    return errorCode;
+}
+
+// Decode GSA.
+int32_t uGnssNmeaDecodeGsa(const char *pSentence, size_t size,
+                           uGnssNmeaGsa_t *pGsa)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssNmeaCursor_t cursor;
+    int32_t svId;
+
+    if (pGsa != NULL) {
+        errorCode = cursorStart(&cursor, pSentence, size, "GSA");
+        if (errorCode == 0) {
+            pGsa->opMode = charGet(&cursor);
+            pGsa->navMode = intGet(&cursor, 0);
+            pGsa->numSvs = 0;
+            for (size_t x = 0; x < U_GNSS_NMEA_GSA_MAX_NUM_SVS; x++) {
+                svId = intGet(&cursor, 0);
+                if (svId != U_GNSS_NMEA_EMPTY) {
+                    pGsa->svId[pGsa->numSvs] = svId;
+                    pGsa->numSvs++;
+                }
+            }
+            pGsa->pdopX100 = intGet(&cursor, 2);
+            pGsa->hdopX100 = intGet(&cursor, 2);
+            pGsa->vdopX100 = intGet(&cursor, 2);
+            pGsa->systemId = intGet(&cursor, 0);
+            errorCode = cursorFinish(&cursor);
+        }
+    }
+
+    return errorCode;
+}
+
+// Decode GSV.
+int32_t uGnssNmeaDecodeGsv(const char *pSentence, size_t size,
+                           uGnssNmeaGsv_t *pGsv)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssNmeaCursor_t cursor;
+    uGnssNmeaField_t field;
+    uGnssNmeaGsvSv_t *pSv;
+
+    if (pGsv != NULL) {
+        errorCode = cursorStart(&cursor, pSentence, size, "GSV");
+        if (errorCode == 0) {
+            pGsv->numMessages = intGet(&cursor, 0);
+            pGsv->messageNumber = intGet(&cursor, 0);
+            pGsv->numSvsInView = intGet(&cursor, 0);
+            pGsv->numSvs = 0;
+            pGsv->signalId = U_GNSS_NMEA_EMPTY;
+            // Blocks of four fields follow, then maybe a signal ID:
+            // a field on its own at the end can only be the latter
+            while (!cursor.atEnd) {
+                fieldNext(&cursor, &field);
+                if (cursor.atEnd || (pGsv->numSvs >= U_GNSS_NMEA_GSV_MAX_NUM_SVS)) {
+                    pGsv->signalId = fieldToInt(&field, 0);
+                } else {
+                    pSv = &(pGsv->sv[pGsv->numSvs]);
+                    pSv->svId = fieldToInt(&field, 0);
+                    pSv->elevationDegrees = intGet(&cursor, 0);
+                    pSv->azimuthDegrees = intGet(&cursor, 0);
+                    pSv->cnoDbhz = intGet(&cursor, 0);
+                    pGsv->numSvs++;
+                }
+            }
+            errorCode = cursorFinish(&cursor);
+        }
+    }
+
+    return errorCode;
+}
+
+// Decode VTG.
+int32_t uGnssNmeaDecodeVtg(const char *pSentence, size_t size,
+                           uGnssNmeaVtg_t *pVtg)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssNmeaCursor_t cursor;
+
+    if (pVtg != NULL) {
+        errorCode = cursorStart(&cursor, pSentence, size, "VTG");
+        if (errorCode == 0) {
+            pVtg->courseTrueX100 = intGet(&cursor, 2);
+            skip(&cursor, 1); // T
+            pVtg->courseMagneticX100 = intGet(&cursor, 2);
+            skip(&cursor, 3); // M, speed in knots, N
+            pVtg->speedMillimetresPerSecond = speedGet(&cursor, 1000000);
+            skip(&cursor, 1); // K
+            pVtg->mode = charGet(&cursor);
+            errorCode = cursorFinish(&cursor);
+        }
+    }
+
+    return errorCode;
+}
+
+// End of file
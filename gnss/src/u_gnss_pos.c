@@ -51,6 +51,10 @@
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss_private.h"
+#include "u_gnss_ubx_view.h"
+#include "u_gnss_cfg_val_key.h"
+#include "u_gnss_cfg.h"
+#include "u_gnss_msg.h"
 #include "u_gnss_pos.h"
 
 /* ----------------------------------------------------------------
@@ -105,6 +109,19 @@ typedef struct {
                        int64_t timeUtc);
 } uGnssPosGetTaskParameters_t;
 
+/** The type of the position callback, as passed to
+ * uGnssPosGetStart() and uGnssPosGetStreamedStart().
+ */
+typedef void (*uGnssPosCallback_t) (uDeviceHandle_t gnssHandle,
+                                    int32_t errorCode,
+                                    int32_t latitudeX1e7,
+                                    int32_t longitudeX1e7,
+                                    int32_t altitudeMillimetres,
+                                    int32_t radiusMillimetres,
+                                    int32_t speedMillimetresPerSecond,
+                                    int32_t svs,
+                                    int64_t timeUtc);
+
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
@@ -113,126 +130,141 @@ typedef struct {
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
-// Establish position.
-static int32_t posGet(uGnssPrivateInstance_t *pInstance,
-                      int32_t *pLatitudeX1e7, int32_t *pLongitudeX1e7,
-                      int32_t *pAltitudeMillimetres,
-                      int32_t *pRadiusMillimetres,
-                      int32_t *pSpeedMillimetresPerSecond,
-                      int32_t *pSvs, int64_t *pTimeUtc, bool printIt)
+// Decode the body of a UBX-NAV-PVT message.
+static int32_t decodeNavPvt(const char *message,
+                            int32_t *pLatitudeX1e7, int32_t *pLongitudeX1e7,
+                            int32_t *pAltitudeMillimetres,
+                            int32_t *pRadiusMillimetres,
+                            int32_t *pSpeedMillimetresPerSecond,
+                            int32_t *pSvs, int64_t *pTimeUtc, bool printIt)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
-    // Enough room for the body of the UBX-NAV-PVT message
-    char message[92] = {0};
-    int32_t months;
-    int32_t year;
+    int32_t fixType;
+    uTimeDateTime_t dateTime;
     int32_t y;
     int64_t t = -1;
 
-    y = uGnssPrivateSendReceiveUbxMessage(pInstance,
-                                          0x01, 0x07, NULL, 0,
-                                          message, sizeof(message));
-    if (y == sizeof(message)) {
-        // Got the correct message body length, process it
-        if ((message[11] & 0x03) == 0x03) {
-            // Time and date are valid; we don't indicate
-            // success based on this but we report it anyway
-            // if it is valid
-            t = 0;
-            // Year is 1999-2099, so need to adjust to get year since 1970
-            year = ((int32_t) uUbxProtocolUint16Decode(message + 4) - 1999) + 29;
-            // Month (1 to 12), so take away 1 to make it zero-based
-            months = message[6] - 1;
-            months += year * 12;
-            // Work out the number of seconds due to the year/month count
-            t += uTimeMonthsToSecondsUtc(months);
-            // Day (1 to 31)
-            t += ((int32_t) message[7] - 1) * 3600 * 24;
-            // Hour (0 to 23)
-            t += ((int32_t) message[8]) * 3600;
-            // Minute (0 to 59)
-            t += ((int32_t) message[9]) * 60;
-            // Second (0 to 60)
-            t += message[10];
-            if (printIt) {
-                uPortLog("U_GNSS_POS: UTC time = %d.\n", (int32_t) t);
-            }
+    if ((U_GNSS_UBX_NAV_PVT_VALID(message) & U_GNSS_UBX_NAV_PVT_VALID_DATE_TIME) ==
+        U_GNSS_UBX_NAV_PVT_VALID_DATE_TIME) {
+        // Time and date are valid; we don't indicate
+        // success based on this but we report it anyway
+        // if it is valid
+        // Year is 1999-2099
+        dateTime.year = (int32_t) U_GNSS_UBX_NAV_PVT_YEAR(message);
+        // Month (1 to 12)
+        dateTime.month = U_GNSS_UBX_NAV_PVT_MONTH(message);
+        // Day (1 to 31)
+        dateTime.day = U_GNSS_UBX_NAV_PVT_DAY(message);
+        // Hour (0 to 23)
+        dateTime.hour = U_GNSS_UBX_NAV_PVT_HOUR(message);
+        // Minute (0 to 59)
+        dateTime.minute = U_GNSS_UBX_NAV_PVT_MIN(message);
+        // Second (0 to 60)
+        dateTime.second = U_GNSS_UBX_NAV_PVT_SEC(message);
+        t = uTimeToSecondsUtc(&dateTime);
+        if (printIt) {
+            uPortLog("U_GNSS_POS: UTC time = %d.\n", (int32_t) t);
         }
-        if (pTimeUtc != NULL) {
-            *pTimeUtc = t;
+    }
+    if (pTimeUtc != NULL) {
+        *pTimeUtc = t;
+    }
+    // From here onwards Lint complains about accesses
+    // into message[] and it doesn't seem to be possible
+    // to suppress those warnings with -esym(690, message)
+    // or even -e(690), hence do it the blunt way
+    //lint -save -e690
+    fixType = U_GNSS_UBX_NAV_PVT_FIX_TYPE(message);
+    //// if (message[21] & 0x01) {
+    if (fixType > 0) {  // TP changed to return a fix even outside target limits
+        if (printIt) {
+            uPortLog("U_GNSS_POS: %dD fix achieved.\n", fixType);
         }
-        // From here onwards Lint complains about accesses
-        // into message[] and it doesn't seem to be possible
-        // to suppress those warnings with -esym(690, message)
-        // or even -e(690), hence do it the blunt way
-        //lint -save -e690
-        //// if (message[21] & 0x01) {
-        if (message[20] > 0) {  // TP changed to return a fix even outside target limits
-            if (printIt) {
-                uPortLog("U_GNSS_POS: %dD fix achieved.\n", message[20]);
-            }
-            y = (int32_t) message[23];
-            if (printIt) {
-                uPortLog("U_GNSS_POS: satellite(s) = %d.\n", y);
-            }
-            if (pSvs != NULL) {
-                *pSvs = y;
-            }
-            y = (int32_t) uUbxProtocolUint32Decode(message + 24);
-            if (printIt) {
-                uPortLog("U_GNSS_POS: longitude = %d (degrees * 10^7).\n", y);
-            }
-            if (pLongitudeX1e7 != NULL) {
-                *pLongitudeX1e7 = y;
-            }
-            y = (int32_t) uUbxProtocolUint32Decode(message + 28);
-            if (printIt) {
-                uPortLog("U_GNSS_POS: latitude = %d (degrees * 10^7).\n", y);
-            }
-            if (pLatitudeX1e7 != NULL) {
-                *pLatitudeX1e7 = y;
-            }
-            y = INT_MIN;
-            if (message[20] == 0x03) {
-                y = (int32_t) uUbxProtocolUint32Decode(message + 36);
-                if (printIt) {
-                    uPortLog("U_GNSS_POS: altitude = %d (mm).\n", y);
-                }
-            }
-            if (pAltitudeMillimetres != NULL) {
-                *pAltitudeMillimetres = y;
-            }
-            y = (int32_t) uUbxProtocolUint32Decode(message + 40);
-            if (printIt) {
-                uPortLog("U_GNSS_POS: radius = %d (mm).\n", y);
-            }
-            if (pRadiusMillimetres != NULL) {
-                *pRadiusMillimetres = y;
-            }
-            y = (int32_t) uUbxProtocolUint32Decode(message + 60);
+        y = (int32_t) U_GNSS_UBX_NAV_PVT_NUM_SV(message);
+        if (printIt) {
+            uPortLog("U_GNSS_POS: satellite(s) = %d.\n", y);
+        }
+        if (pSvs != NULL) {
+            *pSvs = y;
+        }
+        y = U_GNSS_UBX_NAV_PVT_LON(message);
+        if (printIt) {
+            uPortLog("U_GNSS_POS: longitude = %d (degrees * 10^7).\n", y);
+        }
+        if (pLongitudeX1e7 != NULL) {
+            *pLongitudeX1e7 = y;
+        }
+        y = U_GNSS_UBX_NAV_PVT_LAT(message);
+        if (printIt) {
+            uPortLog("U_GNSS_POS: latitude = %d (degrees * 10^7).\n", y);
+        }
+        if (pLatitudeX1e7 != NULL) {
+            *pLatitudeX1e7 = y;
+        }
+        y = INT_MIN;
+        if (fixType == 0x03) {
+            y = U_GNSS_UBX_NAV_PVT_H_MSL(message);
             if (printIt) {
-                uPortLog("U_GNSS_POS: speed = %d (mm/s).\n", y);
-            }
-            if (pSpeedMillimetresPerSecond != NULL) {
-                *pSpeedMillimetresPerSecond = y;
-            }
-            if (message[21] & 0x01) {   //TP added
-                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                uPortLog("U_GNSS_POS: altitude = %d (mm).\n", y);
             }
-            //lint -restore
         }
-    } else {
-        errorCode = y;
-        if (errorCode >= 0) {
-            errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+        if (pAltitudeMillimetres != NULL) {
+            *pAltitudeMillimetres = y;
         }
+        y = (int32_t) U_GNSS_UBX_NAV_PVT_H_ACC(message);
+        if (printIt) {
+            uPortLog("U_GNSS_POS: radius = %d (mm).\n", y);
+        }
+        if (pRadiusMillimetres != NULL) {
+            *pRadiusMillimetres = y;
+        }
+        y = U_GNSS_UBX_NAV_PVT_G_SPEED(message);
+        if (printIt) {
+            uPortLog("U_GNSS_POS: speed = %d (mm/s).\n", y);
+        }
+        if (pSpeedMillimetresPerSecond != NULL) {
+            *pSpeedMillimetresPerSecond = y;
+        }
+        if (U_GNSS_UBX_NAV_PVT_FLAGS(message) & U_GNSS_UBX_NAV_PVT_FLAGS_GNSS_FIX_OK) {   //TP added
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+        //lint -restore
+    }
+
+    return errorCode;
+}
+
+// Establish position.
+static int32_t posGet(uGnssPrivateInstance_t *pInstance,
+                      int32_t *pLatitudeX1e7, int32_t *pLongitudeX1e7,
+                      int32_t *pAltitudeMillimetres,
+                      int32_t *pRadiusMillimetres,
+                      int32_t *pSpeedMillimetresPerSecond,
+                      int32_t *pSvs, int64_t *pTimeUtc, bool printIt)
+{
+    int32_t errorCode;
+    // Enough room for the body of the UBX-NAV-PVT message
+    char message[U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES] = {0};
+
+    errorCode = uGnssPrivateSendReceiveUbxMessage(pInstance,
+                                                  U_GNSS_UBX_NAV_PVT_CLASS,
+                                                  U_GNSS_UBX_NAV_PVT_ID, NULL, 0,
+                                                  message, sizeof(message));
+    if (errorCode == sizeof(message)) {
+        // Got the correct message body length, process it
+        errorCode = decodeNavPvt(message, pLatitudeX1e7, pLongitudeX1e7,
+                                 pAltitudeMillimetres, pRadiusMillimetres,
+                                 pSpeedMillimetresPerSecond, pSvs,
+                                 pTimeUtc, printIt);
+    } else if (errorCode >= 0) {
+        errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
     }
 
     return errorCode;
 }
 
 // Establish position as a task.
-// IMPORTANT: this does NOT lock gUGnssPrivateMutex and hence it
+// IMPORTANT: this does NOT lock the instance and hence it
 // is important that it is stopped before a pInstance is released.
 static void posGetTask(void *pParameter)
 {
@@ -282,6 +314,81 @@ static void posGetTask(void *pParameter)
     uPortTaskDelete(NULL);
 }
 
+// Message receive callback for streamed position: decode
+// UBX-NAV-PVT, in place if possible, and pass it on.
+static void streamedPositionCallback(uDeviceHandle_t gnssHandle,
+                                     const uGnssMessageId_t *pMessageId,
+                                     int32_t errorCodeOrLength,
+                                     void *pCallbackParam)
+{
+    uGnssPrivateStreamedPosition_t *pStreamedPosition = (uGnssPrivateStreamedPosition_t *) pCallbackParam;
+    // Enough room for a whole UBX-NAV-PVT message, header and CRC
+    char buffer[U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES];
+    const char *pMessage = NULL;
+    int32_t errorCode;
+    int32_t latitudeX1e7 = INT_MIN;
+    int32_t longitudeX1e7 = INT_MIN;
+    int32_t altitudeMillimetres = INT_MIN;
+    int32_t radiusMillimetres = -1;
+    int32_t speedMillimetresPerSecond = INT_MIN;
+    int32_t svs = -1;
+    int64_t timeUtc = -1;
+
+    (void) pMessageId;
+
+    if (errorCodeOrLength == (int32_t) sizeof(buffer)) {
+        // Look at the message where it is, only copying it
+        // if it happens to wrap in the ring buffer
+        errorCodeOrLength = uGnssMsgReceiveCallbackView(gnssHandle, &pMessage);
+        if (!U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(errorCodeOrLength,
+                                            U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES)) {
+            errorCodeOrLength = uGnssMsgReceiveCallbackRead(gnssHandle, buffer, sizeof(buffer));
+            pMessage = buffer;
+        }
+        if (U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(errorCodeOrLength,
+                                           U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES) &&
+            (U_GNSS_UBX_VIEW_BODY_LENGTH(pMessage) == U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES)) {
+            errorCode = decodeNavPvt(U_GNSS_UBX_VIEW_BODY(pMessage),
+                                     &latitudeX1e7, &longitudeX1e7,
+                                     &altitudeMillimetres, &radiusMillimetres,
+                                     &speedMillimetresPerSecond, &svs,
+                                     &timeUtc, false);
+            ((uGnssPosCallback_t) pStreamedPosition->pCallback)(gnssHandle, errorCode,
+                                                                latitudeX1e7, longitudeX1e7,
+                                                                altitudeMillimetres,
+                                                                radiusMillimetres,
+                                                                speedMillimetresPerSecond,
+                                                                svs, timeUtc);
+        }
+    }
+}
+
+// Stop streamed position, restoring the configuration of the GNSS
+// chip as far as it was changed.
+// IMPORTANT: this calls the public CFG and MSG APIs and hence
+// the instance must NOT be locked when it is called.
+static void streamedPositionStop(uDeviceHandle_t gnssHandle,
+                                 uGnssPrivateStreamedPosition_t *pStreamedPosition)
+{
+    uGnssCfgVal_t cfgVal[2];
+    size_t numValues = 0;
+
+    if (pStreamedPosition->asyncHandle >= 0) {
+        uGnssMsgReceiveStop(gnssHandle, pStreamedPosition->asyncHandle);
+    }
+    cfgVal[numValues].keyId = pStreamedPosition->keyIdMsgOut;
+    cfgVal[numValues].value = pStreamedPosition->msgOutSaved;
+    numValues++;
+    if (pStreamedPosition->rateMeasSaved >= 0) {
+        cfgVal[numValues].keyId = U_GNSS_CFG_VAL_KEY_ID_RATE_MEAS_U2;
+        cfgVal[numValues].value = (uint64_t) pStreamedPosition->rateMeasSaved;
+        numValues++;
+    }
+    uGnssCfgValSetList(gnssHandle, cfgVal, numValues,
+                       U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                       U_GNSS_CFG_VAL_LAYER_RAM);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -304,9 +411,8 @@ int32_t uGnssPosGet(uDeviceHandle_t gnssHandle,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
 #ifdef U_CFG_SARA_R5_M8_WORKAROUND
             if (pInstance->transportType == U_GNSS_TRANSPORT_AT) {
@@ -347,7 +453,7 @@ int32_t uGnssPosGet(uDeviceHandle_t gnssHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -375,10 +481,9 @@ int32_t uGnssPosGetStart(uDeviceHandle_t gnssHandle,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (pCallback != NULL)) {
             errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
             if (pInstance->posTaskFlags == 0) {
@@ -450,7 +555,7 @@ int32_t uGnssPosGetStart(uDeviceHandle_t gnssHandle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -463,14 +568,165 @@ void uGnssPosGetStop(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             uGnssPrivateCleanUpPosTask(pInstance);
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+}
+
+// Start streamed position.
+int32_t uGnssPosGetStreamedStart(uDeviceHandle_t gnssHandle,
+                                 int32_t measurementPeriodMs,
+                                 void (*pCallback) (uDeviceHandle_t gnssHandle,
+                                                    int32_t errorCode,
+                                                    int32_t latitudeX1e7,
+                                                    int32_t longitudeX1e7,
+                                                    int32_t altitudeMillimetres,
+                                                    int32_t radiusMillimetres,
+                                                    int32_t speedMillimetresPerSecond,
+                                                    int32_t svs,
+                                                    int64_t timeUtc))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateStreamedPosition_t *pStreamedPosition = NULL;
+    uGnssMessageId_t messageId;
+    uGnssCfgVal_t cfgVal[2];
+    size_t numValues = 0;
+    uint32_t keyIdMsgOut = 0;
+    uint8_t msgOut = 0;
+    uint16_t rateMeas = 0;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pCallback != NULL) &&
+            ((measurementPeriodMs < 0) ||
+             ((measurementPeriodMs >= U_GNSS_POS_STREAMED_PERIOD_MIN_MS) &&
+              (measurementPeriodMs <= UINT16_MAX)))) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
+                switch (uGnssPrivateGetStreamType(pInstance->transportType)) {
+                    case U_GNSS_PRIVATE_STREAM_TYPE_UART:
+                        keyIdMsgOut = U_GNSS_CFG_VAL_KEY_ID_MSGOUT_UBX_NAV_PVT_UART1_U1;
+                        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        break;
+                    case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
+                        keyIdMsgOut = U_GNSS_CFG_VAL_KEY_ID_MSGOUT_UBX_NAV_PVT_I2C_U1;
+                        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        break;
+                    case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+                        keyIdMsgOut = U_GNSS_CFG_VAL_KEY_ID_MSGOUT_UBX_NAV_PVT_SPI_U1;
+                        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        break;
+                    default:
+                        break;
+                }
+                if ((errorCode == (int32_t) U_ERROR_COMMON_NO_MEMORY) &&
+                    (pInstance->pStreamedPosition == NULL)) {
+                    pStreamedPosition = (uGnssPrivateStreamedPosition_t *) malloc(sizeof(*pStreamedPosition));
+                    if (pStreamedPosition != NULL) {
+                        memset(pStreamedPosition, 0, sizeof(*pStreamedPosition));
+                        pStreamedPosition->asyncHandle = -1;
+                        pStreamedPosition->rateMeasSaved = -1;
+                        pStreamedPosition->keyIdMsgOut = keyIdMsgOut;
+                        pStreamedPosition->pCallback = (void *) pCallback;
+                        // Claim the slot now, the rest is done outside
+                        // the mutex since it uses public APIs
+                        pInstance->pStreamedPosition = pStreamedPosition;
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    }
+                }
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+        if (pStreamedPosition != NULL) {
+            // Remember what we're about to change
+            errorCode = uGnssCfgValGet(gnssHandle, pStreamedPosition->keyIdMsgOut,
+                                       &msgOut, sizeof(msgOut),
+                                       U_GNSS_CFG_VAL_LAYER_RAM);
+            pStreamedPosition->msgOutSaved = msgOut;
+            if ((errorCode == 0) && (measurementPeriodMs >= 0)) {
+                errorCode = uGnssCfgValGet(gnssHandle, U_GNSS_CFG_VAL_KEY_ID_RATE_MEAS_U2,
+                                           &rateMeas, sizeof(rateMeas),
+                                           U_GNSS_CFG_VAL_LAYER_RAM);
+                if (errorCode == 0) {
+                    pStreamedPosition->rateMeasSaved = rateMeas;
+                }
+            }
+            if (errorCode == 0) {
+                // Start listening before the messages start to flow
+                messageId.type = U_GNSS_PROTOCOL_UBX;
+                messageId.id.ubx = (U_GNSS_UBX_NAV_PVT_CLASS << 8) | U_GNSS_UBX_NAV_PVT_ID;
+                errorCode = uGnssMsgReceiveStart(gnssHandle, &messageId,
+                                                 streamedPositionCallback,
+                                                 pStreamedPosition);
+                if (errorCode >= 0) {
+                    pStreamedPosition->asyncHandle = errorCode;
+                    // Now switch on UBX-NAV-PVT every epoch and
+                    // set the measurement period
+                    cfgVal[numValues].keyId = pStreamedPosition->keyIdMsgOut;
+                    cfgVal[numValues].value = 1;
+                    numValues++;
+                    if (measurementPeriodMs >= 0) {
+                        cfgVal[numValues].keyId = U_GNSS_CFG_VAL_KEY_ID_RATE_MEAS_U2;
+                        cfgVal[numValues].value = (uint64_t) measurementPeriodMs;
+                        numValues++;
+                    }
+                    errorCode = uGnssCfgValSetList(gnssHandle, cfgVal, numValues,
+                                                   U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                                                   U_GNSS_CFG_VAL_LAYER_RAM);
+                }
+            }
+            if (errorCode != 0) {
+                // Put things back as they were
+                streamedPositionStop(gnssHandle, pStreamedPosition);
+
+                U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+                if (pInstance != NULL) {
+                    pInstance->pStreamedPosition = NULL;
+                }
+
+                U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+                free(pStreamedPosition);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Stop streamed position.
+void uGnssPosGetStreamedStop(uDeviceHandle_t gnssHandle)
+{
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateStreamedPosition_t *pStreamedPosition = NULL;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if (pInstance != NULL) {
+            pStreamedPosition = pInstance->pStreamedPosition;
+            pInstance->pStreamedPosition = NULL;
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+        if (pStreamedPosition != NULL) {
+            streamedPositionStop(gnssHandle, pStreamedPosition);
+            free(pStreamedPosition);
+        }
     }
 }
 
@@ -490,8 +746,8 @@ int32_t uGnssPosGetRrlp(uDeviceHandle_t gnssHandle, char *pBuffer,
     int32_t z;
     int32_t numMeetingCriteria;
     bool goodSatellite;
-    int32_t ca = 0;
-    int32_t cb = 0;
+    uint8_t ca = 0;
+    uint8_t cb = 0;
     // Access the buffer as a uint8_t to avoid maths funnies with
     // chars being signed or unsigned
     uint8_t *pBufferUint8 = (uint8_t *) pBuffer;
@@ -501,10 +757,9 @@ int32_t uGnssPosGetRrlp(uDeviceHandle_t gnssHandle, char *pBuffer,
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if ((pInstance != NULL) && (pBufferUint8 != NULL) &&
             (sizeBytes >= U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES)) {
 
@@ -610,21 +865,18 @@ int32_t uGnssPosGetRrlp(uDeviceHandle_t gnssHandle, char *pBuffer,
                     // is across the class, ID, length and body so
                     // reconstruct that here
                     pBufferUint8 += 2;
-                    for (int32_t x = 0; x < numBytes + 4; x++) {
-                        ca += *pBufferUint8;
-                        cb += ca;
-                        pBufferUint8++;
-                    }
+                    uUbxProtocolChecksumUpdate((const char *) pBufferUint8, numBytes + 4, &ca, &cb);
+                    pBufferUint8 += numBytes + 4;
                     // Write in the CRC
-                    *pBufferUint8++ = (uint8_t) (ca & 0xff);
-                    *pBufferUint8 = (uint8_t) (cb & 0xff);
+                    *pBufferUint8++ = ca;
+                    *pBufferUint8 = cb;
 
                     errorCodeOrLength = numBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
                 }
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCodeOrLength;
@@ -48,9 +48,12 @@
 #include "u_port_os.h"
 #include "u_port_uart.h"
 #include "u_port_i2c.h"
+#include "u_port_spi.h"
 #include "u_port_debug.h"
 
 #include "u_hex_bin_convert.h"
+#include "u_mempool.h" // uMemPoolMalloc(), uMemPoolFree()
+#include "u_trace.h"
 
 #include "u_at_client.h"
 
@@ -70,6 +73,11 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** How often to check whether an instance that is being removed
+ * is still in use.
+ */
+#define U_GNSS_PRIVATE_INSTANCE_UNUSED_POLL_MS 10
+
 #ifndef U_GNSS_AT_BUFFER_LENGTH_BYTES
 /** The length of a temporary buffer store a hex-encoded UBX-format
  * message when receiving responses over an AT interface.
@@ -145,9 +153,21 @@ const uGnssPrivateStreamType_t gGnssPrivateTransportTypeToStream[] = {
     U_GNSS_PRIVATE_STREAM_TYPE_NONE, // U_GNSS_TRANSPORT_AT
     U_GNSS_PRIVATE_STREAM_TYPE_I2C,  // U_GNSS_TRANSPORT_I2C
     U_GNSS_PRIVATE_STREAM_TYPE_UART, // U_GNSS_TRANSPORT_UBX_UART
-    U_GNSS_PRIVATE_STREAM_TYPE_I2C   // U_GNSS_TRANSPORT_UBX_I2C
+    U_GNSS_PRIVATE_STREAM_TYPE_I2C,  // U_GNSS_TRANSPORT_UBX_I2C
+    U_GNSS_PRIVATE_STREAM_TYPE_SPI   // U_GNSS_TRANSPORT_SPI
 };
 
+/** Profiling probe for uGnssPrivateParseUbx(), only present if
+ * U_CFG_PROFILE is defined.
+ */
+U_PORT_PROFILE_PROBE(gnssParseUbx);
+
+/** The AT command that carries a UBX message to a GNSS chip inside
+ * or behind a cellular module, prepared once since it is sent for
+ * every UBX message over an AT transport.
+ */
+static const uAtClientPreparedCommand_t gUgubx = U_AT_CLIENT_PREPARED_COMMAND("AT+UGUBX=", "s");
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: MESSAGE RELATED
  * -------------------------------------------------------------- */
@@ -189,10 +209,164 @@ static bool ubxIdMatch(uint16_t ubxIdActual, uint16_t ubxIdWanted)
     return ubxIdActual == ubxIdWanted;
 }
 
+// Set bit n in a bitmap.
+static void bitmapSet(uint32_t *pBitmap, size_t n)
+{
+    *(pBitmap + (n >> 5)) |= 1UL << (n & 0x1f);
+}
+
+// Return true if bit n is set in a bitmap.
+static bool bitmapIsSet(const uint32_t *pBitmap, size_t n)
+{
+    return ((*(pBitmap + (n >> 5)) & (1UL << (n & 0x1f))) != 0);
+}
+
+// Hash, to a bit number in a 32-bit bitmap, numCharacters of an
+// NMEA ID starting at pNmeaId, stopping at any null terminator.
+static size_t nmeaHash(const char *pNmeaId, size_t numCharacters)
+{
+    size_t hash = 0;
+
+    for (size_t x = 0; (x < numCharacters) && (*pNmeaId != 0); x++) {
+        hash = (hash * 7) + (uint8_t) *pNmeaId;
+        pNmeaId++;
+    }
+
+    return hash & 0x1f;
+}
+
+// Return true if numCharacters of an NMEA ID starting at pNmeaId
+// are all present and none of them is a wildcard.
+static bool nmeaIsExact(const char *pNmeaId, size_t numCharacters)
+{
+    bool isExact = true;
+
+    for (size_t x = 0; (x < numCharacters) && isExact; x++) {
+        if ((*pNmeaId == 0) || (*pNmeaId == '?')) {
+            isExact = false;
+        }
+        pNmeaId++;
+    }
+
+    return isExact;
+}
+
+// Find the entry for a UBX message class in a message filter,
+// creating it if there is room, else return NULL.
+static uGnssPrivateMsgFilterUbxClass_t *pUbxClassGet(uGnssPrivateMsgFilter_t *pFilter,
+                                                     uint8_t messageClass)
+{
+    uGnssPrivateMsgFilterUbxClass_t *pUbxClass = NULL;
+
+    for (size_t x = 0; (x < pFilter->ubxClassCount) && (pUbxClass == NULL); x++) {
+        if (pFilter->ubxClass[x].messageClass == messageClass) {
+            pUbxClass = &(pFilter->ubxClass[x]);
+        }
+    }
+    if ((pUbxClass == NULL) &&
+        (pFilter->ubxClassCount < sizeof(pFilter->ubxClass) / sizeof(pFilter->ubxClass[0]))) {
+        pUbxClass = &(pFilter->ubxClass[pFilter->ubxClassCount]);
+        memset(pUbxClass, 0, sizeof(*pUbxClass));
+        pUbxClass->messageClass = messageClass;
+        pFilter->ubxClassCount++;
+    }
+
+    return pUbxClass;
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: STREAMING TRANSPORT ONLY
  * -------------------------------------------------------------- */
 
+// Get the temporary buffer to use for getting stuff into the ring
+// buffer: if we're being called from the message receive task,
+// which does not lock the instance, we use its temporary
+// buffer in order to avoid clashes with the main application task.
+static char *pTemporaryBufferGet(const uGnssPrivateInstance_t *pInstance)
+{
+    char *pTemporaryBuffer = pInstance->pTemporaryBuffer;
+
+    if ((pInstance->pMsgReceive != NULL) &&
+        uPortTaskIsThis(pInstance->pMsgReceive->taskHandle)) {
+        pTemporaryBuffer = pInstance->pMsgReceive->pTemporaryBuffer;
+    }
+
+    return pTemporaryBuffer;
+}
+
+#if U_GNSS_I2C_BURST_READ_LENGTH_BYTES > 0
+// Read from the data stream of a GNSS chip connected via I2C into
+// pBuffer, which must be at least size bytes long and size must be
+// at least 3.  If there are bytes remaining from the last length
+// query they are read directly, otherwise the length registers are
+// read in the same transaction as the data stream that follows them.
+// On success *ppData is set to point to the start of the data read
+// and the number of bytes of data read is returned.
+static int32_t i2cReadStream(uGnssPrivateInstance_t *pInstance,
+                             char *pBuffer, size_t size, char **ppData)
+{
+    int32_t errorCodeOrLength;
+    char address = (char) 0xFD;
+    size_t length;
+    size_t tail;
+
+    *ppData = pBuffer;
+    if (pInstance->i2cReceiveRemaining > 0) {
+        // Still bytes there from the last query: the register
+        // address in the GNSS chip sticks at 0xFF, the data stream,
+        // so we can just read them
+        if (size > pInstance->i2cReceiveRemaining) {
+            size = pInstance->i2cReceiveRemaining;
+        }
+        errorCodeOrLength = uPortI2cControllerSendReceive(pInstance->transportHandle.i2c,
+                                                          pInstance->i2cAddress,
+                                                          NULL, 0, pBuffer, size);
+        if (errorCodeOrLength > 0) {
+            if ((size_t) errorCodeOrLength < pInstance->i2cReceiveRemaining) {
+                pInstance->i2cReceiveRemaining -= errorCodeOrLength;
+            } else {
+                pInstance->i2cReceiveRemaining = 0;
+            }
+        } else {
+            // Re-query next time
+            pInstance->i2cReceiveRemaining = 0;
+        }
+    } else {
+        // Write the address of the big-endian length registers and
+        // read on through them into the data stream, all in one
+        if (size > U_GNSS_I2C_BURST_READ_LENGTH_BYTES + 2) {
+            size = U_GNSS_I2C_BURST_READ_LENGTH_BYTES + 2;
+        }
+        errorCodeOrLength = uPortI2cControllerSendReceive(pInstance->transportHandle.i2c,
+                                                          pInstance->i2cAddress,
+                                                          &address, 1, pBuffer, size);
+        if (errorCodeOrLength > 2) {
+            length = (((size_t) (uint8_t) *pBuffer) << 8) + (size_t) (uint8_t) * (pBuffer + 1);
+            tail = errorCodeOrLength - 2;
+            *ppData = pBuffer + 2;
+            if (length >= tail) {
+                // All of what we read is real
+                pInstance->i2cReceiveRemaining = length - tail;
+            } else {
+                // We read beyond what was waiting: the GNSS chip
+                // returns 0xFF once it is empty but anything that
+                // arrived during the read is real, so keep
+                // everything up to the trailing run of 0xFF
+                while ((tail > length) && (*(pBuffer + 2 + tail - 1) == (char) 0xFF)) {
+                    tail--;
+                }
+                pInstance->i2cReceiveRemaining = 0;
+            }
+            errorCodeOrLength = (int32_t) tail;
+        } else if (errorCodeOrLength >= 0) {
+            errorCodeOrLength = 0;
+        }
+    }
+
+    return errorCodeOrLength;
+}
+#endif
+
 // Read or peek-at the data in the internal ring buffer.
 static int32_t streamGetFromRingBuffer(uGnssPrivateInstance_t *pInstance,
                                        int32_t readHandle,
@@ -246,26 +420,31 @@ static int32_t streamGetFromRingBuffer(uGnssPrivateInstance_t *pInstance,
     return errorCodeOrLength;
 }
 
-// Send a message over UART or I2C.
-static int32_t sendMessageStream(int32_t streamHandle,
-                                 uGnssPrivateStreamType_t streamType,
-                                 uint16_t i2cAddress,
+// Send a message over UART, I2C or SPI.
+// Note: the transport mutex should be locked before this is called.
+static int32_t sendMessageStream(uGnssPrivateInstance_t *pInstance,
                                  const char *pMessage,
                                  size_t messageLengthBytes, bool printIt)
 {
     int32_t errorCodeOrSentLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
 
-    switch (streamType) {
+    switch (uGnssPrivateGetStreamType(pInstance->transportType)) {
         case U_GNSS_PRIVATE_STREAM_TYPE_UART:
-            errorCodeOrSentLength = uPortUartWrite(streamHandle, pMessage, messageLengthBytes);
+            errorCodeOrSentLength = uPortUartWrite(pInstance->transportHandle.uart,
+                                                   pMessage, messageLengthBytes);
             break;
         case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
-            errorCodeOrSentLength = uPortI2cControllerSend(streamHandle, i2cAddress,
+            errorCodeOrSentLength = uPortI2cControllerSend(pInstance->transportHandle.i2c,
+                                                           pInstance->i2cAddress,
                                                            pMessage, messageLengthBytes, false);
             if (errorCodeOrSentLength == 0) {
                 errorCodeOrSentLength = messageLengthBytes;
             }
             break;
+        case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+            errorCodeOrSentLength = uGnssPrivateStreamSendSpi(pInstance, pMessage,
+                                                              messageLengthBytes);
+            break;
         default:
             break;
     }
@@ -402,10 +581,7 @@ static int32_t sendReceiveUbxMessageAt(const uAtClientHandle_t atHandle,
         *(pBuffer + bytesToSend) = 0;
         uAtClientLock(atHandle);
         uAtClientTimeoutSet(atHandle, timeoutMs);
-        uAtClientCommandStart(atHandle, "AT+UGUBX=");
-        uAtClientWriteString(atHandle, pBuffer, true);
-        // Read the response
-        uAtClientCommandStop(atHandle);
+        uAtClientCommandPrepared(atHandle, &gUgubx, (const char *) pBuffer);
         if (printIt) {
             uPortLog("U_GNSS: sent UBX command");
             uGnssPrivatePrintBuffer(pSend, sendLengthBytes);
@@ -483,6 +659,135 @@ static int32_t sendReceiveUbxMessageAt(const uAtClientHandle_t atHandle,
     return errorCodeOrLength;
 }
 
+// Send several UBX format messages that only have an Ack response
+// over an AT interface, under a single lock of the AT client and,
+// as far as U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES allows, with
+// several AT+UGUBX commands concatenated onto each command line,
+// checking that they are all Acked; processing stops at the first
+// line that fails.  The transport mutex should be locked before
+// this is called.
+static int32_t sendUbxMessageBatchAt(const uAtClientHandle_t atHandle,
+                                     const uUbxProtocolMessage_t *pMessageList,
+                                     size_t numMessages,
+                                     int32_t timeoutMs, bool printIt)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    size_t encodedLengthMax = 0;
+    char *pEncoded;
+    char *pHex;
+    size_t lineStart = 0;
+    size_t lineEnd;
+    size_t lineLength;
+    size_t length;
+    size_t numAcks = 0;
+    bool nacked = false;
+    int32_t x;
+    int32_t cls;
+    int32_t id;
+    // Room for the hex of a UBX-ACK-ACK or UBX-ACK-NAK
+    char ackHex[((U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES + 2) * 2) + 1];
+    char ackBody[2];
+    bool atPrintOn = uAtClientPrintAtGet(atHandle);
+    bool atDebugPrintOn = uAtClientDebugGet(atHandle);
+
+    for (size_t y = 0; y < numMessages; y++) {
+        length = (pMessageList + y)->bodyLengthBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
+        if (length > encodedLengthMax) {
+            encodedLengthMax = length;
+        }
+    }
+    // One buffer for a single encoded message followed by its hex
+    pEncoded = (char *) malloc(encodedLengthMax + (encodedLengthMax * 2) + 1);
+    if (pEncoded != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        pHex = pEncoded + encodedLengthMax;
+        if (!printIt) {
+            // As in sendReceiveUbxMessageAt()
+            uAtClientPrintAtSet(atHandle, false);
+            uAtClientDebugSet(atHandle, false);
+        }
+        uAtClientLock(atHandle);
+        uAtClientTimeoutSet(atHandle, timeoutMs);
+        while ((lineStart < numMessages) && (errorCode == 0)) {
+            // Work out how many commands can go on this line: the
+            // first is "AT+UGUBX=" plus the quoted hex, subsequent
+            // ones ";+UGUBX=" plus the quoted hex
+            lineEnd = lineStart + 1;
+            lineLength = 9 + ((((pMessageList + lineStart)->bodyLengthBytes +
+                                U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) * 2) + 2);
+            while (lineEnd < numMessages) {
+                length = 8 + ((((pMessageList + lineEnd)->bodyLengthBytes +
+                                U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) * 2) + 2);
+                if (lineLength + length > U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES) {
+                    break;
+                }
+                lineLength += length;
+                lineEnd++;
+            }
+            // Write the line, encoding each message as we go
+            for (size_t y = lineStart; y < lineEnd; y++) {
+                x = uUbxProtocolEncode((pMessageList + y)->messageClass,
+                                       (pMessageList + y)->messageId,
+                                       (pMessageList + y)->pBody,
+                                       (pMessageList + y)->bodyLengthBytes,
+                                       pEncoded);
+                if (x < 0) {
+                    x = 0;
+                }
+                *(pHex + uBinToHex(pEncoded, x, pHex)) = 0;
+                if (y == lineStart) {
+                    uAtClientCommandStart(atHandle, "AT+UGUBX=\"");
+                } else {
+                    uAtClientWritePartialString(atHandle, false, ";+UGUBX=\"");
+                }
+                uAtClientWritePartialString(atHandle, false, pHex);
+                uAtClientWritePartialString(atHandle, false, "\"");
+                if (printIt) {
+                    uPortLog("U_GNSS: sent UBX command");
+                    uGnssPrivatePrintBuffer(pEncoded, x);
+                    uPortLog(".\n");
+                }
+            }
+            uAtClientCommandStop(atHandle);
+            // Check the responses, in order
+            for (size_t y = lineStart; y < lineEnd; y++) {
+                uAtClientResponseStart(atHandle, "+UGUBX:");
+                x = uAtClientReadString(atHandle, ackHex, sizeof(ackHex), false);
+                if (x > 0) {
+                    x = (int32_t) uHexToBin(ackHex, x, ackHex);
+                    if ((uUbxProtocolDecode(ackHex, x, &cls, &id, ackBody,
+                                            sizeof(ackBody), NULL) == 2) &&
+                        (cls == 0x05) &&
+                        (ackBody[0] == (char) (pMessageList + y)->messageClass) &&
+                        (ackBody[1] == (char) (pMessageList + y)->messageId)) {
+                        numAcks++;
+                        if (id != 0x01) {
+                            nacked = true;
+                        }
+                    }
+                }
+            }
+            uAtClientResponseStop(atHandle);
+            if (uAtClientErrorGet(atHandle) < 0) {
+                errorCode = (int32_t) U_GNSS_ERROR_TRANSPORT;
+            } else if (nacked) {
+                errorCode = (int32_t) U_GNSS_ERROR_NACK;
+            } else if (numAcks < lineEnd) {
+                errorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
+            }
+            lineStart = lineEnd;
+        }
+        uAtClientUnlock(atHandle);
+
+        uAtClientPrintAtSet(atHandle, atPrintOn);
+        uAtClientDebugSet(atHandle, atDebugPrintOn);
+
+        free(pEncoded);
+    }
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: ANY TRANSPORT
  * -------------------------------------------------------------- */
@@ -536,23 +841,13 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
                     case U_GNSS_TRANSPORT_UART:
                     //lint -fallthrough
                     case U_GNSS_TRANSPORT_UBX_UART:
-                        errorCodeOrResponseLength = sendMessageStream(pInstance->transportHandle.uart,
-                                                                      U_GNSS_PRIVATE_STREAM_TYPE_UART,
-                                                                      pInstance->i2cAddress,
-                                                                      pBuffer, bytesToSend,
-                                                                      pInstance->printUbxMessages);
-                        if (errorCodeOrResponseLength >= 0) {
-                            errorCodeOrResponseLength = receiveUbxMessageStream(pInstance, pResponse,
-                                                                                pInstance->timeoutMs,
-                                                                                pInstance->printUbxMessages);
-                        }
-                        break;
+                    //lint -fallthrough
                     case U_GNSS_TRANSPORT_I2C:
                     //lint -fallthrough
                     case U_GNSS_TRANSPORT_UBX_I2C:
-                        errorCodeOrResponseLength = sendMessageStream(pInstance->transportHandle.i2c,
-                                                                      U_GNSS_PRIVATE_STREAM_TYPE_I2C,
-                                                                      pInstance->i2cAddress,
+                    //lint -fallthrough
+                    case U_GNSS_TRANSPORT_SPI:
+                        errorCodeOrResponseLength = sendMessageStream(pInstance,
                                                                       pBuffer, bytesToSend,
                                                                       pInstance->printUbxMessages);
                         if (errorCodeOrResponseLength >= 0) {
@@ -591,13 +886,13 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
  * STATIC FUNCTIONS: MESSAGE PARSERS
  * -------------------------------------------------------------- */
 
-/** UBX Parser function.
+/** The body of the UBX parser function, uGnssPrivateParseUbx().
  *
  * @param parseHandle    the parse handle of the ring buffer to read from.
  * @param[in] pUserParam the user parameter passed to uRingBufferParseHandle().
  * @return               negative error or success code.
  */
-static int32_t uGnssPrivateParseUbx(uParseHandle_t parseHandle, void *pUserParam)
+static int32_t parseUbx(uParseHandle_t parseHandle, void *pUserParam)
 {
     uGnssPrivateMessageId_t *pMsgId = (uGnssPrivateMessageId_t *) pUserParam;
     uint8_t by = 0;
@@ -635,15 +930,17 @@ static int32_t uGnssPrivateParseUbx(uParseHandle_t parseHandle, void *pUserParam
     ckb += cka;
     l += (by << 8);
     if (l > uRingBufferBytesAvailableUnprotected(parseHandle)) {
+        // Body plus two bytes of checksum
+        uRingBufferParseNeedBytesUnprotected(parseHandle, l + 2);
         return U_ERROR_COMMON_TIMEOUT;
     }
-    while (l --) {
-        uRingBufferGetByteUnprotected(parseHandle, &by);
-        cka += by;
-        ckb += cka;
+    while (l > 0) {
+        // At most twice, since the body may wrap in the ring buffer
+        const char *pBody;
+        size_t x = uRingBufferGetBytesUnprotected(parseHandle, &pBody, l);
+        uUbxProtocolChecksumUpdate(pBody, x, &cka, &ckb);
+        l -= (uint16_t) x;
     }
-    cka = cka & 0xFF;
-    ckb = ckb & 0xFF;
     if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
         return U_ERROR_COMMON_TIMEOUT;
     }
@@ -660,6 +957,25 @@ static int32_t uGnssPrivateParseUbx(uParseHandle_t parseHandle, void *pUserParam
     return U_ERROR_COMMON_SUCCESS;
 }
 
+/** UBX Parser function; profiled, units being messages found, if
+ * U_CFG_PROFILE is defined.
+ *
+ * @param parseHandle    the parse handle of the ring buffer to read from.
+ * @param[in] pUserParam the user parameter passed to uRingBufferParseHandle().
+ * @return               negative error or success code.
+ */
+static int32_t uGnssPrivateParseUbx(uParseHandle_t parseHandle, void *pUserParam)
+{
+    int32_t errorCode;
+    U_PORT_PROFILE_BEGIN(gnssParseUbx);
+
+    errorCode = parseUbx(parseHandle, pUserParam);
+
+    U_PORT_PROFILE_END(gnssParseUbx, (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) ? 1 : 0);
+
+    return errorCode;
+}
+
 /** NMEA Parser function.
  *
  * @param parseHandle    the parse handle of the ring buffer to read from.
@@ -753,10 +1069,19 @@ static int32_t uGnssPrivateParseRtcm(uParseHandle_t parseHandle, void *pUserPara
         return U_ERROR_COMMON_NOT_FOUND;
     }
     uint16_t l = (by & 0x3) << 8;
+    uint8_t lengthHi = by;
     if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
         return U_ERROR_COMMON_TIMEOUT;
     }
-    l += by + 2;
+    // The length is that of the body, which includes the two bytes
+    // of message number read below, and is followed by three bytes
+    // of CRC; the CRC covers the preamble and length bytes also
+    l += by;
+    if (l < 2) {
+        return U_ERROR_COMMON_NOT_FOUND;
+    }
+    l = l - 2 + 3;
+    uint8_t lengthLo = by;
     uint8_t idLo, idHi;
     uint32_t crc = 0;
     // CRC24Q check
@@ -795,6 +1120,9 @@ static int32_t uGnssPrivateParseRtcm(uParseHandle_t parseHandle, void *pUserPara
         /* f8 */ 0x42fa2f, 0xc4b6d4, 0xc82f22, 0x4e63d9, 0xd11cce, 0x575035, 0x5bc9c3, 0xdd8538
     };
 #define RTCM_CRC(crc, by) ((crc << 8) | by) ^ _crc24qTable[(crc >> 16) & 0xff]
+    crc = RTCM_CRC(crc, 0xD3);
+    crc = RTCM_CRC(crc, lengthHi);
+    crc = RTCM_CRC(crc, lengthLo);
     if (!uRingBufferGetByteUnprotected(parseHandle, &idLo)) {
         return U_ERROR_COMMON_TIMEOUT;
     }
@@ -805,6 +1133,7 @@ static int32_t uGnssPrivateParseRtcm(uParseHandle_t parseHandle, void *pUserPara
     crc = RTCM_CRC(crc, idHi);
     pMsgId->id.rtcm = (idHi >> 4) + (idLo << 4);
     if (l  > uRingBufferBytesAvailableUnprotected(parseHandle)) {
+        uRingBufferParseNeedBytesUnprotected(parseHandle, l);
         return U_ERROR_COMMON_TIMEOUT;
     }
     while (l--) {
@@ -818,6 +1147,297 @@ static int32_t uGnssPrivateParseRtcm(uParseHandle_t parseHandle, void *pUserPara
     return U_ERROR_COMMON_SUCCESS;
 }
 
+/** The parsers, registered with the ring buffer for each read handle
+ * that is parsed so that a large message which is arriving slowly
+ * is not re-parsed from the start every time more of it arrives.
+ */
+static U_RING_BUFFER_PARSER_f gParserList[] = {
+    uGnssPrivateParseUbx,
+    uGnssPrivateParseNmea,
+    uGnssPrivateParseRtcm,
+    NULL
+};
+
+// Parse the ring buffer at readHandle with gParserList, using the
+// registered resume state if possible.
+static int32_t parseRingBuffer(uGnssPrivateInstance_t *pInstance,
+                               int32_t readHandle,
+                               uGnssPrivateMessageId_t *pMsg)
+{
+    int32_t errorCodeOrLength;
+
+    memset(pMsg, 0, sizeof(*pMsg));
+    pMsg->type = U_GNSS_PROTOCOL_UNKNOWN;
+    if (uRingBufferParserRegister(&(pInstance->ringBuffer), readHandle,
+                                  gParserList) == 0) {
+        errorCodeOrLength = (int32_t) uRingBufferParseRegistered(&(pInstance->ringBuffer),
+                                                                 readHandle, pMsg);
+    } else {
+        errorCodeOrLength = (int32_t) uRingBufferParseHandle(&(pInstance->ringBuffer),
+                                                             readHandle, gParserList,
+                                                             pMsg);
+    }
+
+    return errorCodeOrLength;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: DECODING AND FRAMING
+ * -------------------------------------------------------------- */
+
+// Act on a message, or a lump of unrecognised data, of the given
+// length that has been found at the current position of readHandle:
+// if it is wanted pPrivateMessageId is populated and the length is
+// returned, else it is discarded, with the special case of a NACK
+// for a wanted UBX message, where U_GNSS_ERROR_NACK is returned.
+// *pFinished is set to true if the caller should return the value
+// returned by this function, else the caller should move on to the
+// next message.
+static int32_t decodeMessage(uGnssPrivateInstance_t *pInstance,
+                             int32_t readHandle,
+                             const uGnssPrivateMessageId_t *pMsg,
+                             int32_t length,
+                             uGnssPrivateMessageId_t *pPrivateMessageId,
+                             bool *pFinished)
+{
+    int32_t errorCodeOrLength = length;
+    uint8_t buffer[10];
+    uint16_t ubxId;
+
+    *pFinished = false;
+    if (uGnssPrivateMessageIdIsWanted((uGnssPrivateMessageId_t *) pMsg, pPrivateMessageId)) {
+        memcpy(pPrivateMessageId, pMsg, sizeof(uGnssPrivateMessageId_t));
+#ifdef U_GNSS_PRIVATE_DEBUG_PARSING
+        if (pMsg->type == U_GNSS_PROTOCOL_UBX) {
+            uPortLog("** UBX %04X size %d\n", pMsg->id.ubx, length);
+        } else if (pMsg->type == U_GNSS_PROTOCOL_NMEA) {
+            uPortLog("** NMEA %s size %d\n", pMsg->id.nmea, length);
+        } else if (pMsg->type == U_GNSS_PROTOCOL_RTCM) {
+            uPortLog("** RTCM %d size %d\n", pMsg->id.rtcm, length);
+        } else if (pMsg->type == U_GNSS_PROTOCOL_UNKNOWN) {
+            uPortLog("** UNKNOWN size %d\n", length);
+        } else {
+            uPortLog("** ERROR size %d\n", length);
+        }
+#endif
+        *pFinished = true;
+    } else {
+#ifdef U_GNSS_PRIVATE_DEBUG_PARSING
+        uPortLog("** DISCARD %d %d size %d\n", pMsg->type, pPrivateMessageId->type, length);
+#endif
+        if ((pPrivateMessageId->type == U_GNSS_PROTOCOL_UBX) &&
+            (pMsg->type == U_GNSS_PROTOCOL_UBX) &&
+            (pMsg->id.ubx == 0x0500/*ACK-NACK*/) && (length == sizeof(buffer))) {
+            if (uRingBufferReadHandle(&(pInstance->ringBuffer), readHandle,
+                                      (char *) buffer, sizeof(buffer)) == sizeof(buffer)) {
+                ubxId = (buffer[6]/*CLS*/ << 8) | buffer[7]/*ID*/;
+                if (ubxIdMatch(ubxId, pPrivateMessageId->id.ubx)) {
+#ifdef U_GNSS_PRIVATE_DEBUG_PARSING
+                    uPortLog("** ACK-NACK %04X => U_GNSS_ERROR_NACK\n", ubxId);
+#endif
+                    errorCodeOrLength = (int32_t) U_GNSS_ERROR_NACK;
+                    *pFinished = true;
+                }
+            }
+        } else {
+            // Discard what is not wanted by the caller
+            uRingBufferReadHandle(&(pInstance->ringBuffer), readHandle, NULL, length);
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// Keep the high water marks of the ring buffer up to date after an
+// add; nothing else writes these so being slightly out is harmless.
+static void ringBufferHighWaterUpdate(uGnssPrivateInstance_t *pInstance)
+{
+    uGnssPrivateMsgReceive_t *pMsgReceive;
+    size_t used;
+
+    used = pInstance->ringBufferLengthBytes -
+           uRingBufferAvailableSizeMax(&(pInstance->ringBuffer));
+    if (used > pInstance->ringBufferStreamHighWaterMark) {
+        pInstance->ringBufferStreamHighWaterMark = used;
+    }
+    pMsgReceive = pInstance->pMsgReceive;
+    if (pMsgReceive != NULL) {
+        used = uRingBufferDataSizeHandle(&(pInstance->ringBuffer),
+                                         pMsgReceive->ringBufferReadHandle);
+        if (used > pMsgReceive->highWaterMark) {
+            pMsgReceive->highWaterMark = used;
+        }
+    }
+}
+
+#if U_GNSS_PRIVATE_FRAME_INDEX_LENGTH > 0
+
+// Work out the time at which the byte at the given stream position,
+// which must be at or beyond indexedUpTo, was added to the ring buffer.
+// Note: the framer mutex should be locked before this is called.
+static int32_t framerArrivalTime(const uGnssPrivateFramer_t *pFramer,
+                                 uint32_t position)
+{
+    int32_t timeMs = pFramer->indexedUpToTimeMs;
+
+    if ((int32_t) (position - pFramer->addPosition) >= 0) {
+        // Arrived in the most recent add
+        timeMs = pFramer->addTimeMs;
+    }
+
+    return timeMs;
+}
+
+// Frame any complete messages that have arrived in the ring buffer
+// since this was last called, adding them to the index.
+// Note: the framer mutex should be locked before this is called.
+static void framerUpdate(uGnssPrivateInstance_t *pInstance)
+{
+    uGnssPrivateFramer_t *pFramer = pInstance->pFramer;
+    uGnssPrivateFrame_t *pFrame;
+    uGnssPrivateMessageId_t msg;
+    int32_t length = 1;
+    uint32_t position;
+
+    position = pFramer->totalAdded - (uint32_t) uRingBufferDataSizeHandle(&(pInstance->ringBuffer),
+                                                                           pFramer->ringBufferReadHandle);
+    if (position != pFramer->indexedUpTo) {
+        // A forced add has pushed data out from under the framer,
+        // the index is no longer contiguous with what follows
+        pFramer->count = 0;
+        pFramer->indexedUpTo = position;
+        pFramer->indexedUpToTimeMs = framerArrivalTime(pFramer, position);
+    }
+    while (length > 0) {
+        length = parseRingBuffer(pInstance, pFramer->ringBufferReadHandle, &msg);
+        if (length > 0) {
+            if (pFramer->count >= U_GNSS_PRIVATE_FRAME_INDEX_LENGTH) {
+                // Lose the oldest entry
+                pFramer->first = (pFramer->first + 1) % U_GNSS_PRIVATE_FRAME_INDEX_LENGTH;
+                pFramer->count--;
+            }
+            pFrame = &(pFramer->index[(pFramer->first + pFramer->count) %
+                                                                         U_GNSS_PRIVATE_FRAME_INDEX_LENGTH]);
+            pFrame->position = pFramer->indexedUpTo;
+            pFrame->length = length;
+            pFrame->messageId = msg;
+            pFrame->arrivalTimeMs = framerArrivalTime(pFramer, pFramer->indexedUpTo);
+            pFramer->count++;
+            pFramer->indexedUpTo += (uint32_t) length;
+            if (pInstance->pLog != NULL) {
+                // Copy it to the log while it is still in place
+                uGnssPrivateLogFrame(pInstance, &msg, (size_t) length);
+            }
+            uRingBufferReadHandle(&(pInstance->ringBuffer),
+                                  pFramer->ringBufferReadHandle, NULL, length);
+        }
+    }
+    // Remember when the start of any partial message that remains
+    // arrived, since the rest of it will arrive in a later add
+    pFramer->indexedUpToTimeMs = framerArrivalTime(pFramer, pFramer->indexedUpTo);
+}
+
+// Do what uGnssPrivateStreamDecodeRingBuffer() does but using the
+// index; *pIndexed is set to false if the index does not cover the
+// position of readHandle, in which case the caller must parse
+// the ring buffer itself.
+static int32_t framerDecode(uGnssPrivateInstance_t *pInstance,
+                            int32_t readHandle,
+                            uGnssPrivateMessageId_t *pPrivateMessageId,
+                            bool *pIndexed)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    uGnssPrivateFramer_t *pFramer = pInstance->pFramer;
+    const uGnssPrivateFrame_t *pFrame;
+    uGnssPrivateMessageId_t msg;
+    uint32_t position;
+    int32_t length;
+    bool finished = false;
+
+    *pIndexed = false;
+
+    U_PORT_MUTEX_LOCK(pFramer->mutex);
+
+    while (!finished) {
+        position = pFramer->totalAdded - (uint32_t) uRingBufferDataSizeHandle(&(pInstance->ringBuffer),
+                                                                               readHandle);
+        finished = true;
+        if (position == pFramer->indexedUpTo) {
+            // Nothing more that is complete
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_TIMEOUT;
+            *pIndexed = true;
+        } else {
+            pFrame = NULL;
+            for (size_t x = 0; (x < pFramer->count) && (pFrame == NULL); x++) {
+                pFrame = &(pFramer->index[(pFramer->first + x) % U_GNSS_PRIVATE_FRAME_INDEX_LENGTH]);
+                if ((uint32_t) (position - pFrame->position) >= (uint32_t) pFrame->length) {
+                    pFrame = NULL;
+                }
+            }
+            *pIndexed = (pFrame != NULL);
+            if (pFrame != NULL) {
+                msg = pFrame->messageId;
+                length = pFrame->length;
+                if (position != pFrame->position) {
+                    // Part of the message has already been read from
+                    // this handle, the rest is just data
+                    memset(&msg, 0, sizeof(msg));
+                    msg.type = U_GNSS_PROTOCOL_UNKNOWN;
+                    length = (int32_t) (pFrame->position + (uint32_t) pFrame->length - position);
+                }
+                errorCodeOrLength = decodeMessage(pInstance, readHandle, &msg,
+                                                  length, pPrivateMessageId,
+                                                  &finished);
+            }
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pFramer->mutex);
+
+    return errorCodeOrLength;
+}
+
+// Read up to size bytes from a UART straight into the ring buffer,
+// saving the copy through the temporary buffer, and frame them.
+// The framer mutex is held from reservation to commit so that
+// nothing else can add to the ring buffer in between.  Returns
+// the number of bytes read, else negative error code;
+// U_ERROR_COMMON_NO_MEMORY is returned if there is no room
+// in the ring buffer without pushing data out from under a read
+// handle, in which case the caller should fall back to reading
+// into the temporary buffer and doing a forced add.
+static int32_t framerUartReadRingBuffer(uGnssPrivateInstance_t *pInstance,
+                                        int32_t streamHandle, size_t size)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    uGnssPrivateFramer_t *pFramer = pInstance->pFramer;
+    char *pData = NULL;
+
+    U_PORT_MUTEX_LOCK(pFramer->mutex);
+
+    size = uRingBufferWriteReserve(&(pInstance->ringBuffer), &pData, size);
+    if (size > 0) {
+        errorCodeOrLength = uPortUartRead(streamHandle, pData, size);
+        if ((errorCodeOrLength > 0) &&
+            uRingBufferWriteCommit(&(pInstance->ringBuffer), errorCodeOrLength)) {
+            pFramer->addPosition = pFramer->totalAdded;
+            pFramer->addTimeMs = uPortGetTickTimeMs();
+            pFramer->totalAdded += (uint32_t) errorCodeOrLength;
+            framerUpdate(pInstance);
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pFramer->mutex);
+
+    if (errorCodeOrLength > 0) {
+        ringBufferHighWaterUpdate(pInstance);
+    }
+
+    return errorCodeOrLength;
+}
+
+#endif // #if U_GNSS_PRIVATE_FRAME_INDEX_LENGTH > 0
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS THAT ARE PRIVATE TO GNSS: MISC
  * -------------------------------------------------------------- */
@@ -825,7 +1445,8 @@ static int32_t uGnssPrivateParseRtcm(uParseHandle_t parseHandle, void *pUserPara
 // Find a GNSS instance in the list by instance handle.
 uGnssPrivateInstance_t *pUGnssPrivateGetInstance(uDeviceHandle_t handle)
 {
-    uGnssPrivateInstance_t *pInstance = gpUGnssPrivateInstanceList;
+    uGnssPrivateInstance_t *pInstance = NULL;
+    uDeviceInstance_t *pDevInstance;
     uDeviceHandle_t gnssHandle = uNetworkGetDeviceHandle(handle,
                                                          U_NETWORK_TYPE_GNSS);
 
@@ -835,13 +1456,73 @@ uGnssPrivateInstance_t *pUGnssPrivateGetInstance(uDeviceHandle_t handle)
         // just use what we were given
         gnssHandle = handle;
     }
-    while ((pInstance != NULL) && (pInstance->gnssHandle != gnssHandle)) {
-        pInstance = pInstance->pNext;
+    // The handle leads straight to the device instance, which
+    // points at the GNSS instance, no need to walk the list
+    pDevInstance = U_DEVICE_INSTANCE(gnssHandle);
+    if ((pDevInstance != NULL) &&
+        (pDevInstance->deviceType == U_DEVICE_TYPE_GNSS)) {
+        pInstance = (uGnssPrivateInstance_t *) pDevInstance->pDriverInstance;
+        if ((pInstance != NULL) && (pInstance->gnssHandle != gnssHandle)) {
+            pInstance = NULL;
+        }
     }
 
     return pInstance;
 }
 
+// Find a GNSS instance and lock it.
+uGnssPrivateInstance_t *pUGnssPrivateInstanceLock(uDeviceHandle_t handle)
+{
+    uGnssPrivateInstance_t *pInstance = NULL;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        pInstance = pUGnssPrivateGetInstance(handle);
+        if (pInstance != NULL) {
+            // Registering as a user stops the instance being
+            // free'd while we wait for it
+            pInstance->lockUsers++;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+
+        if (pInstance != NULL) {
+            uPortMutexLock(pInstance->mutex);
+        }
+    }
+
+    return pInstance;
+}
+
+// Unlock a GNSS instance.
+void uGnssPrivateInstanceUnlock(uGnssPrivateInstance_t *pInstance)
+{
+    if (pInstance != NULL) {
+        uPortMutexUnlock(pInstance->mutex);
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        pInstance->lockUsers--;
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+}
+
+// Wait until no-one is using the lock of an instance.
+void uGnssPrivateInstanceWaitUnused(uGnssPrivateInstance_t *pInstance)
+{
+    int32_t lockUsers;
+
+    do {
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        lockUsers = pInstance->lockUsers;
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        if (lockUsers > 0) {
+            uPortTaskBlock(U_GNSS_PRIVATE_INSTANCE_UNUSED_POLL_MS);
+        }
+    } while (lockUsers > 0);
+}
+
 // Get the module characteristics for a given instance.
 const uGnssPrivateModule_t *pUGnssPrivateGetModule(uDeviceHandle_t gnssHandle)
 {
@@ -990,6 +1671,24 @@ int32_t uGnssPrivateGetProtocolOut(uGnssPrivateInstance_t *pInstance)
     return errorCodeOrBitMap;
 }
 
+// Forget everything in the configuration shadow.
+void uGnssPrivateCfgShadowClear(uGnssPrivateInstance_t *pInstance)
+{
+    if (pInstance->pCfgShadow != NULL) {
+        pInstance->pCfgShadow->nav5Valid = false;
+        pInstance->pCfgShadow->numItems = 0;
+        pInstance->pCfgShadow->nextItem = 0;
+    }
+}
+
+// Forget the cached identity of the GNSS chip.
+void uGnssPrivateIdentityCacheClear(uGnssPrivateInstance_t *pInstance)
+{
+    // It is legal C to free a NULL pointer
+    free(pInstance->identityCache.pMonVer);
+    memset(&(pInstance->identityCache), 0, sizeof(pInstance->identityCache));
+}
+
 // Shut down and free memory from a running pos task.
 void uGnssPrivateCleanUpPosTask(uGnssPrivateInstance_t *pInstance)
 {
@@ -1053,6 +1752,10 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
 
         // Sending the task anything will cause it to exit
         uPortQueueSend(pMsgReceive->taskExitQueueHandle, queueItem);
+        if (pInstance->dataReadySemaphore != NULL) {
+            // Wake it up if it is waiting on TX-ready
+            uPortSemaphoreGive(pInstance->dataReadySemaphore);
+        }
         U_PORT_MUTEX_LOCK(pMsgReceive->taskRunningMutexHandle);
         U_PORT_MUTEX_UNLOCK(pMsgReceive->taskRunningMutexHandle);
         // Wait for the task to actually exit: the STM32F4 platform
@@ -1063,7 +1766,7 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
         // we've shut the task down
         while (pMsgReceive->pReaderList != NULL) {
             pNext = pMsgReceive->pReaderList->pNext;
-            free(pMsgReceive->pReaderList);
+            uMemPoolFree(pMsgReceive->pReaderList);
             pMsgReceive->pReaderList = pNext;
         }
 
@@ -1091,6 +1794,55 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
     }
 }
 
+// Create the framer for the ring buffer of a GNSS instance.
+int32_t uGnssPrivateFramerCreate(uGnssPrivateInstance_t *pInstance)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+#if U_GNSS_PRIVATE_FRAME_INDEX_LENGTH > 0
+    uGnssPrivateFramer_t *pFramer;
+
+    if ((pInstance != NULL) && (pInstance->pFramer == NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pFramer = (uGnssPrivateFramer_t *) malloc(sizeof(uGnssPrivateFramer_t));
+        if (pFramer != NULL) {
+            memset(pFramer, 0, sizeof(*pFramer));
+            errorCode = uPortMutexCreate(&(pFramer->mutex));
+            if (errorCode == 0) {
+                // The framer's read handle is never locked, so it
+                // can't hold up forced adds to the ring buffer
+                errorCode = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
+                if (errorCode >= 0) {
+                    pFramer->ringBufferReadHandle = errorCode;
+                    pInstance->pFramer = pFramer;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                } else {
+                    uPortMutexDelete(pFramer->mutex);
+                }
+            }
+            if (errorCode != 0) {
+                free(pFramer);
+            }
+        }
+    }
+#else
+    (void) pInstance;
+#endif
+
+    return errorCode;
+}
+
+// Free the framer of a GNSS instance.
+void uGnssPrivateFramerDelete(uGnssPrivateInstance_t *pInstance)
+{
+    if ((pInstance != NULL) && (pInstance->pFramer != NULL)) {
+        uRingBufferGiveReadHandle(&(pInstance->ringBuffer),
+                                  pInstance->pFramer->ringBufferReadHandle);
+        uPortMutexDelete(pInstance->pFramer->mutex);
+        free(pInstance->pFramer);
+        pInstance->pFramer = NULL;
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS THAT ARE PRIVATE TO GNSS: MESSAGE RELATED
  * -------------------------------------------------------------- */
@@ -1196,6 +1948,110 @@ bool uGnssPrivateMessageIdIsWanted(uGnssPrivateMessageId_t *pMessageId,
     return isWanted;
 }
 
+// Add a wanted message ID to a message filter.
+void uGnssPrivateMsgFilterAdd(uGnssPrivateMsgFilter_t *pFilter,
+                              const uGnssPrivateMessageId_t *pMessageIdWanted)
+{
+    uGnssPrivateMsgFilterUbxClass_t *pUbxClass;
+    uint8_t messageClass;
+    uint8_t messageId;
+
+    switch (pMessageIdWanted->type) {
+        case U_GNSS_PROTOCOL_ANY:
+            pFilter->protocolBitmap |= 1UL << U_GNSS_PROTOCOL_UNKNOWN;
+        //lint -fallthrough
+        case U_GNSS_PROTOCOL_ALL:
+            pFilter->protocolBitmap |= (1UL << U_GNSS_PROTOCOL_UBX) |
+                                       (1UL << U_GNSS_PROTOCOL_NMEA) |
+                                       (1UL << U_GNSS_PROTOCOL_RTCM);
+            break;
+        case U_GNSS_PROTOCOL_UNKNOWN:
+            pFilter->protocolBitmap |= 1UL << U_GNSS_PROTOCOL_UNKNOWN;
+            break;
+        case U_GNSS_PROTOCOL_RTCM:
+            pFilter->rtcmBitmap |= 1UL << (pMessageIdWanted->id.rtcm & 0x1f);
+            break;
+        case U_GNSS_PROTOCOL_NMEA:
+            // A wildcard, or a wanted ID which is shorter than a
+            // full talker ID/sentence formatter, lets everything through
+            if (nmeaIsExact(pMessageIdWanted->id.nmea, 2)) {
+                pFilter->nmeaTalkerBitmap |= 1UL << nmeaHash(pMessageIdWanted->id.nmea, 2);
+            } else {
+                pFilter->nmeaTalkerBitmap = UINT32_MAX;
+            }
+            if (nmeaIsExact(pMessageIdWanted->id.nmea, 5)) {
+                pFilter->nmeaSentenceBitmap |= 1UL << nmeaHash(pMessageIdWanted->id.nmea + 2, 3);
+            } else {
+                pFilter->nmeaSentenceBitmap = UINT32_MAX;
+            }
+            break;
+        case U_GNSS_PROTOCOL_UBX:
+            messageClass = (uint8_t) (pMessageIdWanted->id.ubx >> 8);
+            messageId = (uint8_t) pMessageIdWanted->id.ubx;
+            if (messageClass == U_GNSS_UBX_MESSAGE_CLASS_ALL) {
+                if (messageId == U_GNSS_UBX_MESSAGE_ID_ALL) {
+                    pFilter->protocolBitmap |= 1UL << U_GNSS_PROTOCOL_UBX;
+                } else {
+                    bitmapSet(pFilter->ubxIdAnyClassBitmap, messageId);
+                }
+            } else {
+                bitmapSet(pFilter->ubxClassBitmap, messageClass);
+                pUbxClass = pUbxClassGet(pFilter, messageClass);
+                if (pUbxClass == NULL) {
+                    pFilter->ubxClassFull = true;
+                } else if (messageId == U_GNSS_UBX_MESSAGE_ID_ALL) {
+                    memset(pUbxClass->idBitmap, 0xff, sizeof(pUbxClass->idBitmap));
+                } else {
+                    bitmapSet(pUbxClass->idBitmap, messageId);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Determine if a private message ID passes a message filter.
+bool uGnssPrivateMsgFilterMatch(const uGnssPrivateMsgFilter_t *pFilter,
+                                const uGnssPrivateMessageId_t *pMessageId)
+{
+    bool isMatch = false;
+    uint8_t messageClass;
+    uint8_t messageId;
+
+    if (((int32_t) pMessageId->type < 32) &&
+        ((pFilter->protocolBitmap & (1UL << pMessageId->type)) != 0)) {
+        isMatch = true;
+    } else {
+        switch (pMessageId->type) {
+            case U_GNSS_PROTOCOL_RTCM:
+                isMatch = ((pFilter->rtcmBitmap & (1UL << (pMessageId->id.rtcm & 0x1f))) != 0);
+                break;
+            case U_GNSS_PROTOCOL_NMEA:
+                isMatch = ((pFilter->nmeaTalkerBitmap & (1UL << nmeaHash(pMessageId->id.nmea, 2))) != 0) &&
+                          ((pFilter->nmeaSentenceBitmap & (1UL << nmeaHash(pMessageId->id.nmea + 2, 3))) != 0);
+                break;
+            case U_GNSS_PROTOCOL_UBX:
+                messageClass = (uint8_t) (pMessageId->id.ubx >> 8);
+                messageId = (uint8_t) pMessageId->id.ubx;
+                isMatch = bitmapIsSet(pFilter->ubxIdAnyClassBitmap, messageId);
+                if (!isMatch && bitmapIsSet(pFilter->ubxClassBitmap, messageClass)) {
+                    isMatch = pFilter->ubxClassFull;
+                    for (size_t x = 0; (x < pFilter->ubxClassCount) && !isMatch; x++) {
+                        if (pFilter->ubxClass[x].messageClass == messageClass) {
+                            isMatch = bitmapIsSet(pFilter->ubxClass[x].idBitmap, messageId);
+                        }
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return isMatch;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS THAT ARE PRIVATE TO GNSS: STREAMING TRANSPORT ONLY
  * -------------------------------------------------------------- */
@@ -1214,6 +2070,37 @@ int32_t uGnssPrivateGetStreamType(uGnssTransportType_t transportType)
     return errorCodeOrStreamType;
 }
 
+// Remove the idle fill that a GNSS chip sends over SPI.
+size_t uGnssPrivateSpiFilterFill(char *pBuffer, size_t size)
+{
+    size_t readIndex = 0;
+    size_t writeIndex = 0;
+    size_t runStart;
+    size_t runLength;
+
+    while (readIndex < size) {
+        if (*(pBuffer + readIndex) != (char) 0xFF) {
+            *(pBuffer + writeIndex) = *(pBuffer + readIndex);
+            writeIndex++;
+            readIndex++;
+        } else {
+            // Measure the run of 0xFF
+            runStart = readIndex;
+            while ((readIndex < size) && (*(pBuffer + readIndex) == (char) 0xFF)) {
+                readIndex++;
+            }
+            runLength = readIndex - runStart;
+            if (runLength < U_GNSS_SPI_FILL_THRESHOLD_BYTES) {
+                // Too short to be fill: keep it
+                memset(pBuffer + writeIndex, 0xFF, runLength);
+                writeIndex += runLength;
+            }
+        }
+    }
+
+    return writeIndex;
+}
+
 // Get the number of bytes waiting for us when using a streaming transport.
 // IMPORTANT: this function should not do anything that has "global"
 // effect on the instance data since it is called by
@@ -1225,6 +2112,7 @@ int32_t uGnssPrivateStreamGetReceiveSize(int32_t streamHandle,
 {
     int32_t errorCodeOrReceiveSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     char buffer[2];
+    char lengthAddress = (char) 0xFD;
 
     switch (streamType) {
         case U_GNSS_PRIVATE_STREAM_TYPE_UART:
@@ -1234,19 +2122,20 @@ int32_t uGnssPrivateStreamGetReceiveSize(int32_t streamHandle,
             // The number of bytes waiting for us is available by a read of
             // I2C register addresses 0xFD and 0xFE in the GNSS chip.
             // The register address in the GNSS chip auto-increments, so sending
-            // 0xFD, with no stop bit, and then a read request for two bytes
-            // should get us the [big-endian] length
-            buffer[0] = 0xFD;
-            errorCodeOrReceiveSize = uPortI2cControllerSend(streamHandle, i2cAddress,
-                                                            buffer, 1, true);
-            if (errorCodeOrReceiveSize == 0) {
-                errorCodeOrReceiveSize = uPortI2cControllerSendReceive(streamHandle, i2cAddress,
-                                                                       NULL, 0, buffer, sizeof(buffer));
-                if (errorCodeOrReceiveSize == sizeof(buffer)) {
-                    errorCodeOrReceiveSize = (int32_t) ((((uint32_t) buffer[0]) << 8) + (uint32_t) buffer[1]);
-                }
+            // 0xFD and then, with a repeated start, a read request for two
+            // bytes, all in one transaction, should get us the [big-endian] length
+            errorCodeOrReceiveSize = uPortI2cControllerSendReceive(streamHandle, i2cAddress,
+                                                                   &lengthAddress, 1,
+                                                                   buffer, sizeof(buffer));
+            if (errorCodeOrReceiveSize == sizeof(buffer)) {
+                errorCodeOrReceiveSize = (int32_t) ((((uint32_t) buffer[0]) << 8) + (uint32_t) buffer[1]);
             }
             break;
+        case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+            // SPI is full duplex with no length register: data can only
+            // be had by clocking it out, see uGnssPrivateStreamFillRingBuffer()
+            errorCodeOrReceiveSize = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            break;
         default:
             break;
     }
@@ -1254,6 +2143,85 @@ int32_t uGnssPrivateStreamGetReceiveSize(int32_t streamHandle,
     return errorCodeOrReceiveSize;
 }
 
+// Add data to the internal ring buffer, framing it on the way in.
+// IMPORTANT: this function should not do anything that has "global"
+// effect on the instance data since it may be called at any time
+// by the message receive task over in u_gnss_msg.c.
+int32_t uGnssPrivateStreamAddRingBuffer(uGnssPrivateInstance_t *pInstance,
+                                        const char *pData, size_t size)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pInstance != NULL) && ((pData != NULL) || (size == 0))) {
+        errorCodeOrLength = (int32_t) size;
+        // We use a forced add: it is up to this MCU to keep up, we
+        // don't want to block data from the GNSS chip, after all it
+        // has no flow control lines that we can stop it with
+#if U_GNSS_PRIVATE_FRAME_INDEX_LENGTH > 0
+        if (pInstance->pFramer != NULL) {
+            // Add and frame atomically so that the
+            // index always matches the ring buffer
+            U_PORT_MUTEX_LOCK(pInstance->pFramer->mutex);
+            pInstance->pFramer->addPosition = pInstance->pFramer->totalAdded;
+            pInstance->pFramer->addTimeMs = uPortGetTickTimeMs();
+            if (uRingBufferForceAdd(&(pInstance->ringBuffer), pData, size)) {
+                pInstance->pFramer->totalAdded += (uint32_t) size;
+                framerUpdate(pInstance);
+            } else {
+                errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            }
+            U_PORT_MUTEX_UNLOCK(pInstance->pFramer->mutex);
+        } else
+#endif
+            if (!uRingBufferForceAdd(&(pInstance->ringBuffer), pData, size)) {
+                errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            }
+        ringBufferHighWaterUpdate(pInstance);
+    }
+
+    return errorCodeOrLength;
+}
+
+// Send data over SPI, keeping whatever the GNSS chip sends back.
+// Note: the transport mutex should be locked before this is called.
+int32_t uGnssPrivateStreamSendSpi(uGnssPrivateInstance_t *pInstance,
+                                  const char *pData, size_t size)
+{
+    int32_t errorCodeOrSentLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    char *pTemporaryBuffer;
+    size_t thisSize;
+    size_t receiveSize;
+    size_t sentSize = 0;
+
+    if ((pInstance != NULL) && (pData != NULL)) {
+        errorCodeOrSentLength = 0;
+        pTemporaryBuffer = pTemporaryBufferGet(pInstance);
+        while ((sentSize < size) && (errorCodeOrSentLength >= 0)) {
+            thisSize = size - sentSize;
+            if (thisSize > pInstance->temporaryBufferLengthBytes) {
+                thisSize = pInstance->temporaryBufferLengthBytes;
+            }
+            errorCodeOrSentLength = uPortSpiControllerSendReceiveBlock(pInstance->transportHandle.spi,
+                                                                       pData + sentSize,
+                                                                       pTemporaryBuffer,
+                                                                       thisSize);
+            if (errorCodeOrSentLength >= 0) {
+                sentSize += thisSize;
+                // SPI is full duplex: anything the GNSS chip clocked
+                // out while we were sending is real data, keep it
+                receiveSize = uGnssPrivateSpiFilterFill(pTemporaryBuffer, thisSize);
+                if (receiveSize > 0) {
+                    uGnssPrivateStreamAddRingBuffer(pInstance, pTemporaryBuffer,
+                                                    receiveSize);
+                }
+                errorCodeOrSentLength = (int32_t) sentSize;
+            }
+        }
+    }
+
+    return errorCodeOrSentLength;
+}
+
 // Find the given message ID in the ring buffer.
 // IMPORTANT: this function should not do anything that has "global"
 // effect on the instance data since it is called by
@@ -1264,63 +2232,30 @@ int32_t uGnssPrivateStreamDecodeRingBuffer(uGnssPrivateInstance_t *pInstance,
                                            uGnssPrivateMessageId_t *pPrivateMessageId)
 {
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    bool finished = false;
+    uGnssPrivateMessageId_t msg;
+
     if ((pInstance != NULL) && (pPrivateMessageId != NULL)) {
-        while (1) {
-            U_RING_BUFFER_PARSER_f parserList[] = {
-                uGnssPrivateParseUbx,
-                uGnssPrivateParseNmea,
-                uGnssPrivateParseRtcm,
-                NULL
-            };
-            uGnssPrivateMessageId_t msg;
-            memset(&msg, 0, sizeof(msg));
-            msg.type = U_GNSS_PROTOCOL_UNKNOWN;
-            errorCodeOrLength = uRingBufferParseHandle(&(pInstance->ringBuffer), readHandle, parserList, &msg);
-            if (errorCodeOrLength <= 0) {
-                break;
-            } else if (uGnssPrivateMessageIdIsWanted(&msg, pPrivateMessageId)) {
-                memcpy(pPrivateMessageId, &msg, sizeof(uGnssPrivateMessageId_t));
-#ifdef U_GNSS_PRIVATE_DEBUG_PARSING
-                if (msg.type == U_GNSS_PROTOCOL_UBX) {
-                    uPortLog("** UBX %04X size %d\n", msg.id.ubx, errorCodeOrLength);
-                } else if (msg.type == U_GNSS_PROTOCOL_NMEA) {
-                    uPortLog("** NMEA %s size %d\n", msg.id.nmea, errorCodeOrLength);
-                } else if (msg.type == U_GNSS_PROTOCOL_RTCM) {
-                    uPortLog("** RTCM %d size %d\n", msg.id.rtcm, errorCodeOrLength);
-                } else if (msg.type == U_GNSS_PROTOCOL_UNKNOWN) {
-                    uPortLog("** UNKNOWN size %d\n", errorCodeOrLength);
-                } else {
-                    uPortLog("** ERROR size %d\n", errorCodeOrLength);
-                }
+#if U_GNSS_PRIVATE_FRAME_INDEX_LENGTH > 0
+        if ((pInstance->pFramer != NULL) &&
+            (readHandle != pInstance->pFramer->ringBufferReadHandle)) {
+            // Use the index if it covers where this handle is
+            errorCodeOrLength = framerDecode(pInstance, readHandle,
+                                             pPrivateMessageId, &finished);
+        }
 #endif
-                break;
+        while (!finished) {
+            errorCodeOrLength = parseRingBuffer(pInstance, readHandle, &msg);
+            if (errorCodeOrLength <= 0) {
+                finished = true;
             } else {
-#ifdef U_GNSS_PRIVATE_DEBUG_PARSING
-                uPortLog("** DISCARD %d %d size %d\n", msg, pPrivateMessageId->type, errorCodeOrLength);
-#endif
-                if ((pPrivateMessageId->type == U_GNSS_PROTOCOL_UBX) &&
-                    (msg.type == U_GNSS_PROTOCOL_UBX) &&
-                    (msg.id.ubx == 0x0500/*ACK-NACK*/) && (errorCodeOrLength == 10)) {
-                    uint8_t msg[10];
-                    if (10 == uRingBufferReadHandle(&(pInstance->ringBuffer), readHandle, (char *)msg, 10)) {
-                        uint16_t ubxId = (msg[6]/*CLS*/ << 8) | msg[7]/*ID*/;
-                        if (ubxIdMatch(ubxId, pPrivateMessageId->id.ubx)) {
-#ifdef U_GNSS_PRIVATE_DEBUG_PARSING
-                            uPortLog("** ACK-NACK %04X => U_GNSS_ERROR_NACK\n", ubxId);
-#endif
-                            errorCodeOrLength = U_GNSS_ERROR_NACK;
-                            break;
-                        }
-                    }
-                } else {
-                    // discard what is not wanted by the calling
-
-                    // wouldnt it be better to just adbvance the read handle here
-                    uRingBufferReadHandle(&(pInstance->ringBuffer), readHandle, NULL, errorCodeOrLength);
-                }
+                errorCodeOrLength = decodeMessage(pInstance, readHandle, &msg,
+                                                  errorCodeOrLength,
+                                                  pPrivateMessageId, &finished);
             }
-        };
+        }
     }
+
     return errorCodeOrLength;
 }
 
@@ -1339,17 +2274,10 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
     int32_t totalReceiveSize = 0;
     int32_t ringBufferAvailableSize;
     char *pTemporaryBuffer;
+    char *pData;
 
     if (pInstance != NULL) {
-        pTemporaryBuffer = pInstance->pTemporaryBuffer;
-        if ((pInstance->pMsgReceive != NULL) &&
-            uPortTaskIsThis(pInstance->pMsgReceive->taskHandle)) {
-            // If we're being called from the message receive task,
-            // which does not lock gUGnssPrivateMutex, we use its
-            // temporary buffer in order to avoid clashes with
-            // the main application task
-            pTemporaryBuffer = pInstance->pMsgReceive->pTemporaryBuffer;
-        }
+        pTemporaryBuffer = pTemporaryBufferGet(pInstance);
         errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
         streamType = uGnssPrivateGetStreamType(pInstance->transportType);
         switch (streamType) {
@@ -1359,6 +2287,9 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
             case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
                 streamHandle = pInstance->transportHandle.i2c;
                 break;
+            case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+                streamHandle = pInstance->transportHandle.spi;
+                break;
             default:
                 break;
         }
@@ -1368,9 +2299,21 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
             // This is constructed as a do()/while() so that
             // it always has one go even with a zero timeout
             do {
-                receiveSize = uGnssPrivateStreamGetReceiveSize(streamHandle,
-                                                               (uGnssPrivateStreamType_t) streamType,
-                                                               pInstance->i2cAddress);
+                pData = pTemporaryBuffer;
+                if ((streamType == (int32_t) U_GNSS_PRIVATE_STREAM_TYPE_SPI)
+#if U_GNSS_I2C_BURST_READ_LENGTH_BYTES > 0
+                    || (streamType == (int32_t) U_GNSS_PRIVATE_STREAM_TYPE_I2C)
+#endif
+                   ) {
+                    // There is no way to know how much is waiting over
+                    // SPI and for I2C the length is read along with
+                    // the data: ask for as much as we could possibly take
+                    receiveSize = (int32_t) pInstance->temporaryBufferLengthBytes;
+                } else {
+                    receiveSize = uGnssPrivateStreamGetReceiveSize(streamHandle,
+                                                                   (uGnssPrivateStreamType_t) streamType,
+                                                                   pInstance->i2cAddress);
+                }
                 // Don't try to read in more than uRingBufferForceAdd()
                 // can put into the ring buffer
                 ringBufferAvailableSize = uRingBufferAvailableSizeMax(&(pInstance->ringBuffer));
@@ -1379,18 +2322,48 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
                 }
                 if (receiveSize > 0) {
                     // Read into a temporary buffer
-                    if (receiveSize > U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES) {
-                        receiveSize = U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES;
+                    if (receiveSize > (int32_t) pInstance->temporaryBufferLengthBytes) {
+                        receiveSize = (int32_t) pInstance->temporaryBufferLengthBytes;
                     }
                     switch (streamType) {
                         case U_GNSS_PRIVATE_STREAM_TYPE_UART:
                             // For UART we ask for as much data as we can, it will just
                             // bring in more if more has arrived between the "receive
                             // size" call above and now
+#if U_GNSS_PRIVATE_FRAME_INDEX_LENGTH > 0
+                            if (pInstance->pFramer != NULL) {
+                                // Straight into the ring buffer if there's room
+                                receiveSize = framerUartReadRingBuffer(pInstance, streamHandle,
+                                                                       pInstance->temporaryBufferLengthBytes);
+                                if (receiveSize != (int32_t) U_ERROR_COMMON_NO_MEMORY) {
+                                    if (receiveSize > 0) {
+                                        totalReceiveSize += receiveSize;
+                                        errorCodeOrLength = totalReceiveSize;
+                                    }
+                                    // Already added, or an error
+                                    pData = NULL;
+                                    break;
+                                }
+                            }
+#endif
                             receiveSize = uPortUartRead(streamHandle, pTemporaryBuffer,
-                                                        U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
+                                                        pInstance->temporaryBufferLengthBytes);
                             break;
                         case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
+#if U_GNSS_I2C_BURST_READ_LENGTH_BYTES > 0
+                            if (receiveSize > 2) {
+                                receiveSize = i2cReadStream(pInstance, pTemporaryBuffer,
+                                                            receiveSize, &pData);
+                                if ((receiveSize == 0) && (timeoutMs > 0)) {
+                                    // Nothing there, relax a little
+                                    uPortTaskBlock(10);
+                                }
+                            } else {
+                                // Not enough room in the ring buffer to
+                                // be worth it, wait until there is
+                                receiveSize = 0;
+                            }
+#else
                             // For I2C we need to ask for the amount we know is there since
                             // the I2C buffer is effectively on the GNSS chip and I2C drivers
                             // often don't say how much they've read, just giving us back
@@ -1400,22 +2373,35 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
                                                                         NULL, 0,
                                                                         pTemporaryBuffer,
                                                                         receiveSize);
+#endif
+                            break;
+                        case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+                            // For SPI we clock out fill and throw away whatever
+                            // idle fill the GNSS chip sends back
+                            receiveSize = uPortSpiControllerSendReceiveBlock(streamHandle, NULL,
+                                                                             pTemporaryBuffer,
+                                                                             receiveSize);
+                            if (receiveSize > 0) {
+                                receiveSize = (int32_t) uGnssPrivateSpiFilterFill(pTemporaryBuffer,
+                                                                                  receiveSize);
+                                if ((receiveSize == 0) && (timeoutMs > 0)) {
+                                    // Nothing there, relax a little
+                                    uPortTaskBlock(10);
+                                }
+                            }
                             break;
                         default:
                             break;
                     }
-                    if (receiveSize >= 0) {
+                    if ((receiveSize > 0) && (pData != NULL)) {
                         totalReceiveSize += receiveSize;
-                        errorCodeOrLength = totalReceiveSize;
-                        // Now stuff this into the ring buffer; we use a forced
-                        // add: it is up to this MCU to keep up, we don't want
-                        // to block data from the GNSS chip, after all it has
-                        // no UART flow control lines that we can stop it with
-                        if (!uRingBufferForceAdd(&(pInstance->ringBuffer),
-                                                 pTemporaryBuffer, receiveSize)) {
-                            errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        errorCodeOrLength = uGnssPrivateStreamAddRingBuffer(pInstance,
+                                                                            pData,
+                                                                            receiveSize);
+                        if (errorCodeOrLength >= 0) {
+                            errorCodeOrLength = totalReceiveSize;
                         }
-                    } else {
+                    } else if (receiveSize < 0) {
                         // Error case
                         errorCodeOrLength = receiveSize;
                     }
@@ -1440,6 +2426,7 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
         errorCodeOrLength = totalReceiveSize;
     }
 
+    U_TRACE(GNSS_STREAM_FILL, errorCodeOrLength);
     return errorCodeOrLength;
 }
 
@@ -1464,8 +2451,50 @@ int32_t uGnssPrivateStreamPeekRingBuffer(uGnssPrivateInstance_t *pInstance,
                                    offset, maxTimeMs, false);
 }
 
-// Send a UBX format message over UART or I2C.
-int32_t uGnssPrivateSendOnlyStreamUbxMessage(const uGnssPrivateInstance_t *pInstance,
+// Get the arrival time of the message at the read position of a handle.
+int32_t uGnssPrivateStreamGetArrivalTime(uGnssPrivateInstance_t *pInstance,
+                                         int32_t readHandle,
+                                         int32_t *pTimeMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+#if U_GNSS_PRIVATE_FRAME_INDEX_LENGTH > 0
+    uGnssPrivateFramer_t *pFramer;
+    const uGnssPrivateFrame_t *pFrame;
+    uint32_t position;
+
+    if ((pInstance != NULL) && (pTimeMs != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        pFramer = pInstance->pFramer;
+        if (pFramer != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+
+            U_PORT_MUTEX_LOCK(pFramer->mutex);
+
+            position = pFramer->totalAdded - (uint32_t) uRingBufferDataSizeHandle(&(pInstance->ringBuffer),
+                                                                                   readHandle);
+            for (size_t x = 0; (x < pFramer->count) && (errorCode != 0); x++) {
+                pFrame = &(pFramer->index[(pFramer->first + x) % U_GNSS_PRIVATE_FRAME_INDEX_LENGTH]);
+                if (pFrame->position == position) {
+                    *pTimeMs = pFrame->arrivalTimeMs;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+
+            U_PORT_MUTEX_UNLOCK(pFramer->mutex);
+        }
+    }
+#else
+    (void) readHandle;
+    if ((pInstance != NULL) && (pTimeMs != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+    }
+#endif
+
+    return errorCode;
+}
+
+// Send a UBX format message over UART, I2C or SPI.
+int32_t uGnssPrivateSendOnlyStreamUbxMessage(uGnssPrivateInstance_t *pInstance,
                                              int32_t messageClass,
                                              int32_t messageId,
                                              const char *pMessageBody,
@@ -1473,7 +2502,6 @@ int32_t uGnssPrivateSendOnlyStreamUbxMessage(const uGnssPrivateInstance_t *pInst
 {
     int32_t errorCodeOrSentLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     int32_t transportTypeStream;
-    int32_t streamHandle = -1;
     int32_t bytesToSend = 0;
     char *pBuffer;
 
@@ -1493,20 +2521,7 @@ int32_t uGnssPrivateSendOnlyStreamUbxMessage(const uGnssPrivateInstance_t *pInst
 
                 U_PORT_MUTEX_LOCK(pInstance->transportMutex);
 
-                switch (transportTypeStream) {
-                    case U_GNSS_PRIVATE_STREAM_TYPE_UART:
-                        streamHandle = pInstance->transportHandle.uart;
-                        break;
-                    case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
-                        streamHandle = pInstance->transportHandle.i2c;
-                        break;
-                    default:
-                        break;
-                }
-
-                errorCodeOrSentLength = sendMessageStream(streamHandle,
-                                                          (uGnssPrivateStreamType_t) transportTypeStream,
-                                                          pInstance->i2cAddress,
+                errorCodeOrSentLength = sendMessageStream(pInstance,
                                                           pBuffer, bytesToSend,
                                                           pInstance->printUbxMessages);
 
@@ -1615,6 +2630,10 @@ int32_t uGnssPrivateReceiveStreamMessage(uGnssPrivateInstance_t *pInstance,
                                                                            readHandle,
                                                                            pPrivateMessageId);
                     if (errorCodeOrLength > 0) {
+                        // Note when the message arrived before any of it is read
+                        pInstance->receiveArrivalTimeValid = (uGnssPrivateStreamGetArrivalTime(pInstance,
+                                                                                               readHandle,
+                                                                                               &(pInstance->receiveArrivalTimeMs)) == 0);
                         if (*ppBuffer == NULL) {
                             // The caller didn't give us any memory; allocate the right
                             // amount; the caller must free this memory
@@ -1758,4 +2777,126 @@ int32_t uGnssPrivateSendUbxMessage(uGnssPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Send several UBX format messages that only have an Ack response
+// and check that they are all Acked.
+int32_t uGnssPrivateSendUbxMessageBatch(uGnssPrivateInstance_t *pInstance,
+                                        const uUbxProtocolMessage_t *pMessageList,
+                                        size_t numMessages)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t bytesToSend;
+    char *pBuffer;
+    uGnssPrivateUbxReceiveMessage_t response;
+    char ackBody[2] = {0};
+    char *pBody = &(ackBody[0]);
+    size_t numAcks = 0;
+    bool nacked = false;
+    int32_t startTimeMs;
+    int32_t x;
+
+    if ((pInstance != NULL) && ((pMessageList != NULL) || (numMessages == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pInstance->transportType == U_GNSS_TRANSPORT_AT) {
+            if (numMessages > 0) {
+
+                U_PORT_MUTEX_LOCK(pInstance->transportMutex);
+
+                //lint -e{1773} Suppress attempt to cast away const: I'm not!
+                errorCode = sendUbxMessageBatchAt((const uAtClientHandle_t)
+                                                  pInstance->transportHandle.pAt,
+                                                  pMessageList, numMessages,
+                                                  pInstance->timeoutMs,
+                                                  pInstance->printUbxMessages);
+
+                U_PORT_MUTEX_UNLOCK(pInstance->transportMutex);
+            }
+        } else if (uGnssPrivateGetStreamType(pInstance->transportType) < 0) {
+            // One at a time, stopping at the first failure
+            for (size_t y = 0; (y < numMessages) && (errorCode == 0); y++) {
+                errorCode = uGnssPrivateSendUbxMessage(pInstance,
+                                                       (pMessageList + y)->messageClass,
+                                                       (pMessageList + y)->messageId,
+                                                       (pMessageList + y)->pBody,
+                                                       (pMessageList + y)->bodyLengthBytes);
+            }
+        } else if (numMessages > 0) {
+            errorCode = uUbxProtocolEncodeBatch(pMessageList, numMessages, NULL, 0);
+            if (errorCode > 0) {
+                bytesToSend = errorCode;
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pBuffer = (char *) malloc(bytesToSend);
+                if (pBuffer != NULL) {
+                    uUbxProtocolEncodeBatch(pMessageList, numMessages, pBuffer, bytesToSend);
+
+                    U_PORT_MUTEX_LOCK(pInstance->transportMutex);
+
+                    // As in sendReceiveUbxMessage(), clear out any history
+                    // and lock our read pointer before the send so that
+                    // no Ack can be missed
+                    uGnssPrivateStreamFillRingBuffer(pInstance,
+                                                     U_GNSS_RING_BUFFER_MIN_FILL_TIME_MS,
+                                                     U_GNSS_RING_BUFFER_MAX_FILL_TIME_MS);
+                    uRingBufferLockReadHandle(&(pInstance->ringBuffer),
+                                              pInstance->ringBufferReadHandlePrivate);
+                    uRingBufferFlushHandle(&(pInstance->ringBuffer),
+                                           pInstance->ringBufferReadHandlePrivate);
+
+                    errorCode = sendMessageStream(pInstance, pBuffer, bytesToSend,
+                                                  pInstance->printUbxMessages);
+                    if (errorCode == bytesToSend) {
+                        // Collect an Ack or a Nack for each message, allowing
+                        // the usual timeout for each of them
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        startTimeMs = uPortGetTickTimeMs();
+                        while ((numAcks < numMessages) && (errorCode == 0) &&
+                               (uPortGetTickTimeMs() - startTimeMs <
+                                pInstance->timeoutMs * (int32_t) numMessages)) {
+                            response.cls = 0x05;
+                            response.id = -1;
+                            response.ppBody = &pBody;
+                            response.bodySize = sizeof(ackBody);
+                            x = receiveUbxMessageStream(pInstance, &response,
+                                                        pInstance->timeoutMs,
+                                                        pInstance->printUbxMessages);
+                            if (x == 2) {
+                                // Only count those that are for one of our messages
+                                for (size_t y = 0; y < numMessages; y++) {
+                                    if ((ackBody[0] == (char) (pMessageList + y)->messageClass) &&
+                                        (ackBody[1] == (char) (pMessageList + y)->messageId)) {
+                                        numAcks++;
+                                        if (response.id != 0x01) {
+                                            nacked = true;
+                                        }
+                                        break;
+                                    }
+                                }
+                            } else if (x < 0) {
+                                errorCode = x;
+                            }
+                        }
+                        if (nacked) {
+                            errorCode = (int32_t) U_GNSS_ERROR_NACK;
+                        } else if ((errorCode == 0) && (numAcks < numMessages)) {
+                            errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                        }
+                    } else if (errorCode >= 0) {
+                        errorCode = (int32_t) U_GNSS_ERROR_TRANSPORT;
+                    }
+
+                    // Make sure the read handle is always unlocked afterwards
+                    uRingBufferUnlockReadHandle(&(pInstance->ringBuffer),
+                                                pInstance->ringBufferReadHandlePrivate);
+
+                    U_PORT_MUTEX_UNLOCK(pInstance->transportMutex);
+
+                    // Free memory
+                    free(pBuffer);
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 // End of file
@@ -24,6 +24,7 @@
 
 #include "u_device.h"
 #include "u_ringbuffer.h"
+#include "u_ubx_protocol.h"
 
 /** @file
  * @brief This header file defines types, functions and inclusions that
@@ -75,6 +76,51 @@ extern "C" {
 # define U_GNSS_RING_BUFFER_MIN_FILL_TIME_MS 100
 #endif
 
+#ifndef U_GNSS_PRIVATE_FRAME_INDEX_LENGTH
+/** The number of entries in the index of messages that is built
+ * as data is streamed into the ring buffer (see
+ * uGnssPrivateStreamFillRingBuffer()), so that every byte need only
+ * be framed once however many readers there are; each entry
+ * occupies around 20 bytes.  Readers that fall further behind
+ * than this many messages simply parse the ring buffer themselves,
+ * as they would if there were no index.  Set to 0 to not use
+ * an index at all.
+ */
+# define U_GNSS_PRIVATE_FRAME_INDEX_LENGTH 32
+#endif
+
+#ifndef U_GNSS_PRIVATE_MSG_FILTER_UBX_CLASSES
+/** The number of UBX message classes for which a message filter
+ * (see uGnssPrivateMsgFilterAdd()) can hold a bitmap of individual
+ * message IDs; each occupies 36 bytes.  Beyond this the filter lets
+ * through any message ID of a wanted class, which is still correct,
+ * just less selective.
+ */
+# define U_GNSS_PRIVATE_MSG_FILTER_UBX_CLASSES 4
+#endif
+
+#ifndef U_GNSS_CFG_SHADOW_MAX_NUM_ITEMS
+/** The number of configuration items that can be held in the
+ * shadow of the configuration of a GNSS chip, see
+ * uGnssCfgSetShadow(); each occupies 16 bytes.  When the shadow
+ * is full the oldest item is overwritten.
+ */
+# define U_GNSS_CFG_SHADOW_MAX_NUM_ITEMS 32
+#endif
+
+#ifndef U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES
+/** The maximum length of an AT command line, excluding the command
+ * delimiter, that uGnssPrivateSendUbxMessageBatch() will assemble
+ * when concatenating several AT+UGUBX commands, separated by ";",
+ * over an AT transport; set this to zero for a cellular module whose
+ * firmware does not accept concatenated AT+UGUBX commands, in which
+ * case each is sent on a line of its own, still under a single lock
+ * of the AT client.  The default refers to u_at_client.h, which
+ * must be included wherever this is used.
+ */
+# define U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES U_AT_CLIENT_BATCH_LINE_LENGTH_MAX_BYTES
+#endif
+
 /** Determine if the given feature is supported or not
  * by the pointed-to module.
  */
@@ -94,6 +140,22 @@ extern "C" {
  */
 #define U_GNSS_POS_TASK_FLAG_KEEP_GOING 0x02
 
+/** Helper to lock the GNSS instance with the given handle for the
+ * duration of an API call, making sure that lock/unlock pairs are
+ * always balanced: pInstance is set to the locked instance or to
+ * NULL if there is no such instance, in which case nothing is
+ * locked.  Must be paired with U_GNSS_PRIVATE_INSTANCE_UNLOCK() in
+ * the same block.
+ */
+#define U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance)                           \
+    { uGnssPrivateInstance_t *pGnssLockedInstance = pUGnssPrivateInstanceLock(gnssHandle); \
+      pInstance = pGnssLockedInstance
+
+/** Helper to unlock an instance locked with
+ * U_GNSS_PRIVATE_INSTANCE_LOCK().
+ */
+#define U_GNSS_PRIVATE_INSTANCE_UNLOCK() uGnssPrivateInstanceUnlock(pGnssLockedInstance); }
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -126,6 +188,7 @@ typedef enum {
     U_GNSS_PRIVATE_STREAM_TYPE_NONE,
     U_GNSS_PRIVATE_STREAM_TYPE_UART,
     U_GNSS_PRIVATE_STREAM_TYPE_I2C,
+    U_GNSS_PRIVATE_STREAM_TYPE_SPI,
     U_GNSS_PRIVATE_STREAM_TYPE_MAX_NUM
 } uGnssPrivateStreamType_t;
 
@@ -149,6 +212,88 @@ typedef struct {
     } id;
 } uGnssPrivateMessageId_t;
 
+/** An entry in the index of messages in the ring buffer.
+ */
+typedef struct {
+    uint32_t position; /**< the position of the start of the message
+                            in the stream, counted from the first
+                            byte added to the ring buffer; wraps. */
+    int32_t length;    /**< the length of the message (or of the
+                            unrecognised data) in bytes. */
+    uGnssPrivateMessageId_t messageId; /**< the message ID, type
+                                            #U_GNSS_PROTOCOL_UNKNOWN
+                                            for unrecognised data. */
+    int32_t arrivalTimeMs; /**< the tick time at which the first byte
+                                of the message was added to the ring
+                                buffer. */
+} uGnssPrivateFrame_t;
+
+/** The framer: it parses data once as it is added to the ring buffer,
+ * using its own read handle, building an index of the messages found
+ * which uGnssPrivateStreamDecodeRingBuffer() can use for any other
+ * read handle.
+ */
+typedef struct {
+    uPortMutexHandle_t mutex; /**< protects everything here and
+                                   makes adding data to the ring
+                                   buffer atomic with framing it. */
+    int32_t ringBufferReadHandle; /**< the framer's own read handle. */
+    uint32_t totalAdded;  /**< the number of bytes ever added to
+                               the ring buffer; wraps. */
+    uint32_t indexedUpTo; /**< the stream position at the end of
+                               the newest entry in the index. */
+    int32_t indexedUpToTimeMs; /**< the tick time at which the byte
+                                    at indexedUpTo was added to the
+                                    ring buffer. */
+    uint32_t addPosition; /**< the stream position of the start of
+                               the data most recently added to the
+                               ring buffer. */
+    int32_t addTimeMs;    /**< the tick time at which the data at
+                               addPosition was added. */
+    size_t first;         /**< the oldest entry in the index. */
+    size_t count;         /**< the number of entries in the index. */
+#if U_GNSS_PRIVATE_FRAME_INDEX_LENGTH > 0
+    uGnssPrivateFrame_t index[U_GNSS_PRIVATE_FRAME_INDEX_LENGTH];
+#endif
+} uGnssPrivateFramer_t;
+
+/** The message IDs wanted by one UBX message class in a message
+ * filter.
+ */
+typedef struct {
+    uint8_t messageClass;
+    uint32_t idBitmap[256 / 32]; /**< bit n set if message ID n is wanted. */
+} uGnssPrivateMsgFilterUbxClass_t;
+
+/** A message filter: the union of any number of wanted message IDs,
+ * compiled into bitmaps so that uGnssPrivateMsgFilterMatch() takes
+ * the same time however many message IDs were added.  The filter
+ * may let through messages that none of the wanted message IDs
+ * would match (e.g. where NMEA hashes collide) but will never
+ * reject one that would be matched; uGnssPrivateMessageIdIsWanted()
+ * is still required for an exact answer.  Zero the structure
+ * to empty it.
+ */
+typedef struct {
+    uint32_t protocolBitmap;  /**< bit (1 << #uGnssProtocol_t) set if
+                                   every message of that protocol is
+                                   wanted. */
+    uint32_t ubxClassBitmap[256 / 32]; /**< bit n set if a message of
+                                            UBX class n may be wanted. */
+    uint32_t ubxIdAnyClassBitmap[256 / 32]; /**< bit n set if a UBX
+                                                 message ID n of any class
+                                                 is wanted. */
+    bool ubxClassFull; /**< true if there was no room in ubxClass[]
+                            for a wanted class, in which case any message
+                            ID of a class in ubxClassBitmap passes. */
+    size_t ubxClassCount;
+    uGnssPrivateMsgFilterUbxClass_t ubxClass[U_GNSS_PRIVATE_MSG_FILTER_UBX_CLASSES];
+    uint32_t nmeaTalkerBitmap;   /**< hashed talker IDs, e.g. "GP". */
+    uint32_t nmeaSentenceBitmap; /**< hashed sentence formatters,
+                                      e.g. "GGA". */
+    uint32_t rtcmBitmap;         /**< hashed RTCM message IDs. */
+} uGnssPrivateMsgFilter_t;
+
 /** Structure to hold the data associated with one non-blocking
  * message read utility function, intended to be used in a
  * linked-list.
@@ -175,9 +320,128 @@ typedef struct {
     uPortMutexHandle_t readerMutexHandle;
     int32_t ringBufferReadHandle;
     size_t msgBytesLeftToRead;
+    int32_t msgArrivalTimeMs; /**< the arrival time of the message
+                                   being passed to the readers. */
+    bool msgArrivalTimeValid; /**< true if msgArrivalTimeMs is valid. */
+    size_t highWaterMark; /**< the most data there has been waiting for
+                               ringBufferReadHandle. */
     uGnssPrivateMsgReader_t *pReaderList;
+    uGnssPrivateMsgFilter_t filter; /**< what any reader in pReaderList
+                                         wants, protected by
+                                         readerMutexHandle. */
 } uGnssPrivateMsgReceive_t;
 
+/** Structure to hold the data associated with streamed position,
+ * see uGnssPosGetStreamedStart().
+ */
+typedef struct {
+    int32_t asyncHandle; /**< the uGnssMsgReceiveStart() handle. */
+    uint32_t keyIdMsgOut; /**< the key ID of CFG-MSGOUT-UBX_NAV_PVT_xxx. */
+    uint8_t msgOutSaved; /**< the value of keyIdMsgOut before we started. */
+    int32_t rateMeasSaved; /**< the value of CFG-RATE-MEAS before we
+                                started, -1 if it was not changed. */
+    void *pCallback; /**< stored as a void * to avoid having to bring
+                          the callback type into everything. */
+} uGnssPrivateStreamedPosition_t;
+
+/** A configuration item held in the shadow.
+ */
+typedef struct {
+    uint32_t keyId;
+    uint64_t value;
+} uGnssPrivateCfgShadowItem_t;
+
+/** Structure to hold a shadow of the RAM layer of the configuration
+ * of a GNSS chip, see uGnssCfgSetShadow().
+ */
+typedef struct {
+    bool nav5Valid; /**< true if nav5 holds the current UBX-CFG-NAV5. */
+    char nav5[36]; /**< the body of UBX-CFG-NAV5. */
+    size_t numItems; /**< the number of valid entries in item[]. */
+    size_t nextItem; /**< the entry of item[] to overwrite next when full. */
+    uGnssPrivateCfgShadowItem_t item[U_GNSS_CFG_SHADOW_MAX_NUM_ITEMS];
+} uGnssPrivateCfgShadow_t;
+
+/** Structure to cache the identity of a GNSS chip, which cannot
+ * change while it is powered, see u_gnss_info.c.
+ */
+typedef struct {
+    char *pMonVer; /**< the body of UBX-MON-VER, malloc()ed, NULL if not yet read. */
+    int32_t monVerLength; /**< the number of bytes at pMonVer. */
+    char chipId[5]; /**< the chip ID from UBX-SEC-UNIQID. */
+    int32_t chipIdLength; /**< the number of bytes in chipId, zero if not yet read. */
+} uGnssPrivateIdentityCache_t;
+
+/** Structure to hold the data associated with the raw logging
+ * of the stream from a GNSS chip, see uGnssLogStart().  Messages
+ * are copied into the block being filled, block[active], by the
+ * framer, i.e. in whichever task is filling the ring buffer, and
+ * the other block is written out by the log task.
+ */
+typedef struct {
+    uPortMutexHandle_t mutex; /**< protects everything below that
+                                   is not constant while logging. */
+    uPortSemaphoreHandle_t semaphore; /**< given when there is a
+                                           block to be written. */
+    uPortTaskHandle_t taskHandle;
+    uPortMutexHandle_t taskRunningMutexHandle;
+    volatile bool taskKeepGoing;
+    void *pWriter; /**< stored as a void * to avoid having to bring
+                        the writer type into everything. */
+    void *pWriterParam;
+    bool all; /**< true to log everything, including data that is
+                   not a recognised message. */
+    uGnssPrivateMsgFilter_t filter;
+    size_t numMessageIds;
+    uGnssPrivateMessageId_t *pMessageIdList; /**< numMessageIds entries,
+                                                  allocated with this. */
+    size_t blockSize;
+    char *pBlock[2];
+    size_t active;  /**< the index of the block being filled. */
+    size_t fill;    /**< the number of bytes in the block being filled. */
+    bool pending;   /**< true if the other block is waiting to be written. */
+    size_t messagesLogged;
+    size_t messagesDropped;
+    size_t bytesLogged;
+    size_t bytesDropped;
+    size_t bytesWritten;
+    size_t blocksWritten;
+    size_t writeFailures;
+    int32_t writeTimeMaxMs;
+} uGnssPrivateLog_t;
+
+/** Structure to hold the data associated with aligning a host
+ * tick with GNSS time, see uGnssTimeSyncStart().  pulseTickUs and
+ * pulseCount are written by the TIMEPULSE interrupt, everything from
+ * pulseCountTimTp on is written by the UBX-TIM-TP callback and the
+ * model, i.e. refTickUs onwards, is protected by gUGnssPrivateMutex
+ * so that it can be read without waiting on the instance mutex.
+ */
+typedef struct {
+    int32_t asyncHandle; /**< the uGnssMsgReceiveStart() handle. */
+    uint32_t keyIdMsgOut; /**< the key ID of CFG-MSGOUT-UBX_TIM_TP_xxx. */
+    uint8_t msgOutSaved; /**< the value of keyIdMsgOut before we started. */
+    int32_t pinTimepulse; /**< the MCU pin the TIMEPULSE is connected to. */
+    void *pTickUs; /**< stored as a void * to avoid having to bring
+                        the tick type into everything. */
+    volatile int64_t pulseTickUs; /**< the host tick at the latest pulse. */
+    volatile uint32_t pulseCount; /**< incremented on each pulse. */
+    uint32_t pulseCountTimTp; /**< pulseCount at the latest UBX-TIM-TP. */
+    bool nextPulseValid; /**< true if nextPulseTimeUs is valid. */
+    int64_t nextPulseTimeUs; /**< the time of the pulse that the latest
+                                  UBX-TIM-TP said was coming. */
+    bool nextPulseIsUtc;
+    int64_t refTickUs; /**< the host tick at the latest aligned pulse. */
+    int64_t refTimeUs; /**< the time at the latest aligned pulse. */
+    int32_t driftPpb;
+    bool isUtc;
+    size_t numPulses; /**< zero if there is no model. */
+    bool driftFromWindow; /**< true once driftPpb has been measured over
+                               a whole #U_GNSS_TIME_SYNC_DRIFT_WINDOW_SECONDS. */
+    int64_t anchorTickUs; /**< the start of the drift measurement. */
+    int64_t anchorTimeUs;
+} uGnssPrivateTimeSync_t;
+
 /** Definition of a GNSS instance.
  * Note: a pointer to this structure is passed to the asynchronous
  * "get position" function (posGetTask()) which does NOT lock the
@@ -194,16 +458,25 @@ typedef struct uGnssPrivateInstance_t {
     uGnssTransportHandle_t transportHandle; /**< the handle of the transport to use. */
     uRingBuffer_t ringBuffer; /**< the ring buffer where we put messages from the GNSS chip. */
     char *pLinearBuffer; /**< the linear buffer that will be used by ringBuffer. */
+    size_t ringBufferLengthBytes; /**< the length of pLinearBuffer. */
+    bool linearBufferIsUser; /**< true if pLinearBuffer was provided by the user, i.e. is not to be freed. */
     char *pTemporaryBuffer; /**< a temporary buffer, used to get stuff into ringBuffer. */
+    size_t temporaryBufferLengthBytes; /**< the length of pTemporaryBuffer and of pMsgReceive->pTemporaryBuffer. */
+    bool temporaryBufferIsUser; /**< true if pTemporaryBuffer was provided by the user, i.e. is not to be freed. */
+    size_t ringBufferStreamHighWaterMark; /**< the most the ring buffer has been filled, as seen by uRingBufferForceAdd(). */
     int32_t ringBufferReadHandlePrivate; /**< the read handle for this code to use, -1 if there isn't one. */
     int32_t ringBufferReadHandleMsgReceive; /**< the read handle for uGnssUtilTransparentReceive(). */
+    uGnssPrivateFramer_t *pFramer; /**< the framer for ringBuffer, NULL if there isn't one. */
     uint16_t i2cAddress; /**< the I2C address of the GNSS chip, only relevant if the transport is I2C. */
+    size_t i2cReceiveRemaining; /**< the number of bytes known to be waiting in the GNSS chip from the last I2C length query. */
     int32_t timeoutMs; /**< the timeout for responses from the GNSS chip in milliseconds. */
     bool printUbxMessages; /**< whether debug printing of UBX messages is on or off. */
     int32_t pinGnssEnablePower; /**< the pin of the MCU that enables power to the GNSS module. */
     int32_t pinGnssEnablePowerOnState; /**< the value to set pinGnssEnablePower to for "on". */
     int32_t atModulePinPwr; /**< the pin of the AT module that enables power to the GNSS chip (only relevant for transport type AT). */
     int32_t atModulePinDataReady; /**< the pin of the AT module that is connected to the Data Ready pin of the GNSS chip (only relevant for transport type AT). */
+    volatile int32_t pinDataReady; /**< the pin of the MCU that is connected to the TX-ready pin of the GNSS chip, -1 if not in use. */
+    uPortSemaphoreHandle_t dataReadySemaphore; /**< given from interrupt when pinDataReady goes active, NULL if never used. */
     uGnssPort_t portNumber; /**< the internal port number of the GNSS device that we are connected on. */
     uPortMutexHandle_t transportMutex; /**< mutex so that we can have an asynchronous
                                             task use the transport. */
@@ -212,8 +485,31 @@ typedef struct uGnssPrivateInstance_t {
     uPortMutexHandle_t posMutex; /**< handle for mutex associated with
                                       non-blocking position establishment. */
     volatile uint8_t posTaskFlags; /**< flags to synchronisation the pos task. */
+    uGnssPrivateStreamedPosition_t *pStreamedPosition; /**< streamed position, NULL
+                                                            if not running. */
     uGnssPrivateMsgReceive_t *pMsgReceive; /**< stuff associated with the asychronous
                                                 message receive utility functions. */
+    uGnssPrivateCfgShadow_t *pCfgShadow; /**< shadow of the configuration, NULL
+                                              if not enabled. */
+    uGnssPrivateIdentityCache_t identityCache; /**< cleared at power on/off. */
+    void *pHotStartContext; /**< hot start context, see u_gnss_pwr.c, lodged
+                                 here as a void * to avoid spreading its
+                                 types all over. */
+    int32_t receiveArrivalTimeMs; /**< the arrival time of the message most recently
+                                       returned by uGnssPrivateReceiveStreamMessage(). */
+    bool receiveArrivalTimeValid; /**< true if receiveArrivalTimeMs is valid. */
+    int32_t msgReceiveArrivalTimeMs; /**< the arrival time of the message most recently
+                                          returned by uGnssMsgReceive(). */
+    bool msgReceiveArrivalTimeValid; /**< true if msgReceiveArrivalTimeMs is valid. */
+    uGnssPrivateLog_t *pLog; /**< raw logging of the stream, NULL if not logging;
+                                  protected by the framer mutex. */
+    uGnssPrivateTimeSync_t *pTimeSync; /**< host tick alignment, NULL if not
+                                            running; the pointer is only changed
+                                            with gUGnssPrivateMutex locked. */
+    uPortMutexHandle_t mutex; /**< Serialises API calls on this instance. */
+    int32_t lockUsers; /**< The number of callers holding or waiting
+                            for mutex, protected by gUGnssPrivateMutex;
+                            the instance is not freed until this is zero. */
     struct uGnssPrivateInstance_t *pNext;
 } uGnssPrivateInstance_t;
 // *INDENT-ON*
@@ -235,7 +531,9 @@ extern const size_t gUGnssPrivateModuleListSize;
  */
 extern uGnssPrivateInstance_t *gpUGnssPrivateInstanceList;
 
-/** Mutex to protect the linked list.
+/** Mutex to protect the linked list; API calls on an instance are
+ * serialised by the mutex of that instance instead, see
+ * pUGnssPrivateInstanceLock().
  */
 extern uPortMutexHandle_t gUGnssPrivateMutex;
 
@@ -255,9 +553,43 @@ extern uPortMutexHandle_t gUGnssPrivateMutex;
  */
 uGnssPrivateInstance_t *pUGnssPrivateGetInstance(uDeviceHandle_t handle);
 
+/** Find a GNSS instance and lock it.  gUGnssPrivateMutex is held
+ * only while the instance is looked up, so that an API call on one
+ * instance does not hold up API calls on another; the instance
+ * cannot be removed while it is locked.  Where a "locked" instance
+ * is referred to in the notes of this API, this is the lock that is
+ * meant.  gUGnssPrivateMutex must NOT be locked when this is called.
+ * Use U_GNSS_PRIVATE_INSTANCE_LOCK()/U_GNSS_PRIVATE_INSTANCE_UNLOCK()
+ * rather than calling this directly where possible.
+ *
+ * @param handle  the instance handle, which may be any handle
+ *                accepted by pUGnssPrivateGetInstance().
+ * @return        a pointer to the locked instance, NULL if there
+ *                is no such instance or the GNSS API is not
+ *                initialised.
+ */
+uGnssPrivateInstance_t *pUGnssPrivateInstanceLock(uDeviceHandle_t handle);
+
+/** Unlock an instance locked with pUGnssPrivateInstanceLock().
+ *
+ * @param pInstance   a pointer to the instance, may be NULL in
+ *                    which case this does nothing.
+ */
+void uGnssPrivateInstanceUnlock(uGnssPrivateInstance_t *pInstance);
+
+/** Wait until no-one is holding or waiting for the lock of an
+ * instance; called when the instance has been taken out of the
+ * linked list, and hence can acquire no new users, before it is
+ * free'd.  gUGnssPrivateMutex must NOT be locked when this is
+ * called.
+ *
+ * @param pInstance   a pointer to the instance.
+ */
+void uGnssPrivateInstanceWaitUnused(uGnssPrivateInstance_t *pInstance);
+
 /** Get the module characteristics for a given instance.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param gnssHandle  the instance handle.
  * @return            a pointer to the module characteristics.
@@ -279,7 +611,7 @@ void uGnssPrivatePrintBuffer(const char *pBuffer,
  * where an AT transports is in use since only the UBX protocol is
  * currently supported through that transport.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL.
  * @return               a bit-map of the protocol types that are
@@ -291,7 +623,7 @@ int32_t uGnssPrivateGetProtocolOut(uGnssPrivateInstance_t *pInstance);
  * where an AT transports is in use since only the UBX protocol is
  * currently supported through that transport.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL.
  * @param protocol       the protocol type; #U_GNSS_PROTOCOL_ALL may
@@ -312,17 +644,37 @@ int32_t uGnssPrivateSetProtocolOut(uGnssPrivateInstance_t *pInstance,
 
 /** Shut down and free memory from a [potentially] running pos task.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance  a pointer to the GNSS instance, cannot  be NULL.
  */
 void uGnssPrivateCleanUpPosTask(uGnssPrivateInstance_t *pInstance);
 
+/** Forget everything in the configuration shadow, if there is one;
+ * to be called whenever the GNSS chip may have lost or changed its
+ * configuration behind our back, e.g. on power off or reset.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot  be NULL.
+ */
+void uGnssPrivateCfgShadowClear(uGnssPrivateInstance_t *pInstance);
+
+/** Forget the cached identity of the GNSS chip, freeing any memory
+ * it occupied; to be called whenever the GNSS chip may be powered
+ * off or reset, since its firmware could be changed in between.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot  be NULL.
+ */
+void uGnssPrivateIdentityCacheClear(uGnssPrivateInstance_t *pInstance);
+
 /** Check whether a GNSS chip that we are using via a cellular module
  * is on-board the cellular module, in which case the AT+GPIOC
  * comands are not used.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance  a pointer to the GNSS instance, cannot  be NULL.
  * @return              true if there is a GNSS chip inside the cellular
@@ -330,15 +682,80 @@ void uGnssPrivateCleanUpPosTask(uGnssPrivateInstance_t *pInstance);
 */
 bool uGnssPrivateIsInsideCell(const uGnssPrivateInstance_t *pInstance);
 
+/** Create the framer for the ring buffer of a GNSS instance, see
+ * #uGnssPrivateFramer_t; it is not an error for there to be no
+ * framer, everything works without it, just less efficiently, so
+ * a failure here need not be fatal.  Does nothing if
+ * #U_GNSS_PRIVATE_FRAME_INDEX_LENGTH is 0.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL;
+ *                       the ring buffer must have been created.
+ * @return               zero on success or negative error code.
+ */
+int32_t uGnssPrivateFramerCreate(uGnssPrivateInstance_t *pInstance);
+
+/** Free the framer of a GNSS instance, if there is one; must be
+ * called before the ring buffer is deleted.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL.
+ */
+void uGnssPrivateFramerDelete(uGnssPrivateInstance_t *pInstance);
+
 /** Stop the asynchronous message receive task; kept here so that
  * GNSS deinitialisation can call it.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance  a pointer to the GNSS instance, cannot  be NULL.
  */
 void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance);
 
+/** Start the asynchronous message receive task, if it is not
+ * already running, without adding a reader; this is implemented
+ * in u_gnss_msg.c, since that is where the task lives, and is used
+ * by the logging code to keep data flowing into the ring buffer.
+ * The task is stopped when the last reader is removed, unless a log
+ * is running.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot  be NULL.
+ * @return               zero on success else negative error code.
+ */
+int32_t uGnssPrivateStartMsgReceive(uGnssPrivateInstance_t *pInstance);
+
+/** Stop any raw logging of the stream, see uGnssLogStop(); this is
+ * implemented in u_gnss_log.c and kept here so that GNSS
+ * deinitialisation can call it.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot  be NULL.
+ */
+void uGnssPrivateLogStop(uGnssPrivateInstance_t *pInstance);
+
+/** Pass a message that the framer has found to the log, if the log
+ * wants it; implemented in u_gnss_log.c.  The message must be at the
+ * read position of the framer's read handle.  This never blocks for
+ * anything more than a copy: if there is no room the message is
+ * dropped.
+ *
+ * Note: the framer mutex should be locked before this is called
+ * and pInstance->pLog must not be NULL.
+ *
+ * @param[in] pInstance   a pointer to the GNSS instance, cannot be NULL.
+ * @param[in] pMessageId  the message ID, type #U_GNSS_PROTOCOL_UNKNOWN
+ *                        for unrecognised data; cannot be NULL.
+ * @param length          the length of the message.
+ */
+void uGnssPrivateLogFrame(uGnssPrivateInstance_t *pInstance,
+                          const uGnssPrivateMessageId_t *pMessageId,
+                          size_t length);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MESSAGE RELATED
  * -------------------------------------------------------------- */
@@ -385,6 +802,29 @@ int32_t uGnssPrivateMessageIdToPublic(const uGnssPrivateMessageId_t *pPrivateMes
 bool uGnssPrivateMessageIdIsWanted(uGnssPrivateMessageId_t *pMessageId,
                                    uGnssPrivateMessageId_t *pMessageIdWanted);
 
+/** Add a wanted message ID to a message filter.
+ *
+ * @param[in] pFilter          the filter to add to; cannot be NULL.
+ * @param[in] pMessageIdWanted the wanted private message ID, as
+ *                             would be passed to
+ *                             uGnssPrivateMessageIdIsWanted(); cannot
+ *                             be NULL.
+ */
+void uGnssPrivateMsgFilterAdd(uGnssPrivateMsgFilter_t *pFilter,
+                              const uGnssPrivateMessageId_t *pMessageIdWanted);
+
+/** Determine if a private message ID passes a message filter.
+ *
+ * @param[in] pFilter    the filter; cannot be NULL.
+ * @param[in] pMessageId the private message ID to check; cannot
+ *                       be NULL.
+ * @return               true if pMessageId might be wanted by one of
+ *                       the message IDs added to pFilter, false
+ *                       if it is definitely not.
+ */
+bool uGnssPrivateMsgFilterMatch(const uGnssPrivateMsgFilter_t *pFilter,
+                                const uGnssPrivateMessageId_t *pMessageId);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: STREAMING TRANSPORT ONLY
  * -------------------------------------------------------------- */
@@ -397,8 +837,55 @@ bool uGnssPrivateMessageIdIsWanted(uGnssPrivateMessageId_t *pMessageId,
  */
 int32_t uGnssPrivateGetStreamType(uGnssTransportType_t transportType);
 
+/** Remove the idle fill that a GNSS chip sends over SPI when it has
+ * nothing to say, i.e. runs of at least #U_GNSS_SPI_FILL_THRESHOLD_BYTES
+ * of 0xFF, compacting the buffer in place.  Shorter runs of 0xFF are
+ * kept since they may be real data.
+ *
+ * @param[in,out] pBuffer the data received over SPI, cannot be NULL.
+ * @param size            the number of bytes at pBuffer.
+ * @return                the number of bytes left at pBuffer.
+ */
+size_t uGnssPrivateSpiFilterFill(char *pBuffer, size_t size);
+
+/** Add a time pulse, with the host tick at which it was seen and
+ * the GNSS time it marks, to the model of a time synchronisation,
+ * see uGnssTimeSyncStart(); implemented in u_gnss_time_sync.c.  If
+ * the pulse does not fit the model (a missed pulse, a wrap of the
+ * host tick or a change of time base) the model is started again
+ * from this pulse.
+ *
+ * Note: gUGnssPrivateMutex should be locked before this is called,
+ * unless pTimeSync is not attached to an instance.
+ *
+ * @param[in,out] pTimeSync  the time synchronisation, cannot be NULL.
+ * @param tickUs             the host tick at the pulse.
+ * @param timeUs             the GNSS time of the pulse.
+ * @param isUtc              true if timeUs is UTC.
+ */
+void uGnssPrivateTimeSyncUpdate(uGnssPrivateTimeSync_t *pTimeSync,
+                                int64_t tickUs, int64_t timeUs, bool isUtc);
+
+/** Convert a host tick to GNSS time using the model of a time
+ * synchronisation; implemented in u_gnss_time_sync.c.
+ *
+ * Note: gUGnssPrivateMutex should be locked before this is called,
+ * unless pTimeSync is not attached to an instance.
+ *
+ * @param[in] pTimeSync  the time synchronisation, cannot be NULL.
+ * @param tickUs         the host tick.
+ * @return               the GNSS time at tickUs, else
+ *                       #U_ERROR_COMMON_NOT_FOUND if no time pulse
+ *                       has yet been added to the model.
+ */
+int64_t uGnssPrivateTimeSyncGetTimeUs(const uGnssPrivateTimeSync_t *pTimeSync,
+                                      int64_t tickUs);
+
 /** Get the number of bytes waiting for us from the GNSS chip when using
- * a streaming transport (e.g. UART or I2C).
+ * a streaming transport (e.g. UART or I2C).  SPI has no way of
+ * telling, the GNSS chip just sends 0xFF when it has nothing, so
+ * for #U_GNSS_PRIVATE_STREAM_TYPE_SPI this returns
+ * #U_ERROR_COMMON_NOT_SUPPORTED.
  *
  * @param streamHandle  the handle of the streaming transport.
  * @param streamType    the streaming transport type.
@@ -412,6 +899,37 @@ int32_t uGnssPrivateStreamGetReceiveSize(int32_t streamHandle,
                                          uGnssPrivateStreamType_t streamType,
                                          uint16_t i2cAddress);
 
+/** Add data to the internal ring buffer, keeping the framer, if
+ * there is one, in step; the add is forced, i.e. old data will be
+ * lost if a reader is not keeping up.
+ * IMPORTANT: this function should not do anything that has "global"
+ * effect on the instance data since it may be called at any time by
+ * the message receive task.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL.
+ * @param[in] pData      the data to add, cannot be NULL.
+ * @param size           the number of bytes at pData.
+ * @return               zero on success else negative error code.
+ */
+int32_t uGnssPrivateStreamAddRingBuffer(uGnssPrivateInstance_t *pInstance,
+                                        const char *pData, size_t size);
+
+/** Send data over SPI: since SPI is full duplex whatever the GNSS
+ * chip sends at the same time is filtered of idle fill and added to
+ * the internal ring buffer.
+ *
+ * Note: the transport mutex of the instance should be locked before
+ * this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL.
+ * @param[in] pData      the data to send, cannot be NULL.
+ * @param size           the number of bytes at pData.
+ * @return               the number of bytes sent else negative error
+ *                       code.
+ */
+int32_t uGnssPrivateStreamSendSpi(uGnssPrivateInstance_t *pInstance,
+                                  const char *pData, size_t size);
+
 /** Fill the internal ring buffer with as much data as possible from
  * the GNSS chip when using a streaming transport (e.g. UART or I2C).
  *
@@ -419,9 +937,9 @@ int32_t uGnssPrivateStreamGetReceiveSize(int32_t streamHandle,
  * timeoutMs + maxTimeMs.  For a "quick check", to just read in a
  * buffer-full of data that is already available, set timeoutMs to 0.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called, but
+ * Note: the instance should be locked before this is called, but
  * it is also safe to call this from the task that is checking for
- * asynchronous messages, even though that doesn't lock gUGnssPrivateMutex,
+ * asynchronous messages, even though that doesn't lock the instance,
  * since it is otherwise thread-safe and that task is brought up and
  * down in a controlled fashion.
  *
@@ -455,14 +973,15 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
  * uGnssPrivateStreamFillRingBuffer() to do that, it only parses data
  * that is already in the ring buffer.  See the msgReceiveTask() asynchronous
  * message receive function in u_gnss_msg.c for an example of how this
- * might be done.
+ * might be done.  Where the instance has a framer the messages are
+ * looked up in the framer's index rather than being parsed again.
  *
  * Note: it is important that pDiscard (see below) is obeyed, i.e.
  * always discard that many bytes of data from the ring-buffer at the
  * given read handle before this function is called again.
- * Note: gUGnssPrivateMutex should be locked before this is called, but
+ * Note: the instance should be locked before this is called, but
  * it is also safe to call this from the task that is checking for
- * asynchronous messages, even though that doesn't lock gUGnssPrivateMutex,
+ * asynchronous messages, even though that doesn't lock the instance,
  * since it is otherwise thread-safe and that task is brought up and
  * down in a controlled fashion.
  *
@@ -490,10 +1009,10 @@ int32_t uGnssPrivateStreamDecodeRingBuffer(uGnssPrivateInstance_t *pInstance,
 
 /** Read data from the internal ring buffer into the given linear buffer.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called, but
+ * Note: the instance should be locked before this is called, but
  * it is also safe to call this from the task that is checking for
  * asynchronous receipt of messages, even though that doesn't lock
- * gUGnssPrivateMutex, since it is otherwise thread-safe and that task
+ * the instance, since it is otherwise thread-safe and that task
  * is brought up and down in a controlled fashion.
  *
  * @param[in] pInstance a pointer to the GNSS instance, cannot be NULL.
@@ -514,10 +1033,10 @@ int32_t uGnssPrivateStreamReadRingBuffer(uGnssPrivateInstance_t *pInstance,
 /** Take a peek into the internal ring buffer, copying the data into a
  * linear buffer.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called, but
+ * Note: the instance should be locked before this is called, but
  * it is also safe to call this from the task that is checking for
  * asynchronous recipt of messages, even though that doesn't lock
- * gUGnssPrivateMutex, since it is otherwise thread-safe and that task
+ * the instance, since it is otherwise thread-safe and that task
  * is brought up and down in a controlled fashion.
  *
  * @param[in] pInstance a pointer to the GNSS instance, cannot be NULL.
@@ -537,9 +1056,35 @@ int32_t uGnssPrivateStreamPeekRingBuffer(uGnssPrivateInstance_t *pInstance,
                                          size_t offset,
                                          int32_t maxTimeMs);
 
-/** Send a UBX format message over UART or I2C (do not wait for the response).
+/** Get the time at which the message at the current read position of
+ * the given read handle arrived, i.e. the tick time (see
+ * uPortGetTickTimeMs()) at which the first byte of the message was
+ * added to the internal ring buffer by
+ * uGnssPrivateStreamFillRingBuffer(); call this once
+ * uGnssPrivateStreamDecodeRingBuffer() has found a message and before
+ * any of it has been read.  This relies on the index of the framer:
+ * if there is no framer, or the reader has fallen so far behind that
+ * the message has dropped out of the index, the arrival time is not
+ * known.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called, but
+ * it is also safe to call this from the task that is checking for
+ * asynchronous receipt of messages, even though that doesn't lock
+ * the instance, since it is otherwise thread-safe and that task
+ * is brought up and down in a controlled fashion.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL.
+ * @param readHandle     the read handle of the ring buffer.
+ * @param[out] pTimeMs   a place to put the arrival time; cannot be NULL.
+ * @return               zero on success else negative error code.
+ */
+int32_t uGnssPrivateStreamGetArrivalTime(uGnssPrivateInstance_t *pInstance,
+                                         int32_t readHandle,
+                                         int32_t *pTimeMs);
+
+/** Send a UBX format message over UART, I2C or SPI (do not wait for the response).
+ *
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance              a pointer to the GNSS instance, cannot
  *                                   be NULL.
@@ -553,7 +1098,7 @@ int32_t uGnssPrivateStreamPeekRingBuffer(uGnssPrivateInstance_t *pInstance,
  *                                   UBX protocol coding overhead, else negative
  *                                   error code.
  */
-int32_t uGnssPrivateSendOnlyStreamUbxMessage(const uGnssPrivateInstance_t *pInstance,
+int32_t uGnssPrivateSendOnlyStreamUbxMessage(uGnssPrivateInstance_t *pInstance,
                                              int32_t messageClass,
                                              int32_t messageId,
                                              const char *pMessageBody,
@@ -563,7 +1108,7 @@ int32_t uGnssPrivateSendOnlyStreamUbxMessage(const uGnssPrivateInstance_t *pInst
  * over a stream and check that it was accepted by the GNSS chip
  * by querying the GNSS chip's message count.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance              a pointer to the GNSS instance, cannot
  *                                   be NULL.
@@ -594,7 +1139,7 @@ int32_t uGnssPrivateSendOnlyCheckStreamUbxMessage(uGnssPrivateInstance_t *pInsta
  * error code #U_GNSS_ERROR_NACK will be returned (and the message will
  * be discarded).
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance              a pointer to the GNSS instance, cannot
  *                                   be NULL.
@@ -660,7 +1205,7 @@ int32_t uGnssPrivateReceiveStreamMessage(uGnssPrivateInstance_t *pInstance,
  * internally call uGnssPrivateStreamFillRingBuffer() to fill the ring
  * buffer with data and then uGnssPrivateStreamReadRingBuffer() to read it.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance              a pointer to the GNSS instance, cannot
  *                                   be NULL.
@@ -695,7 +1240,7 @@ int32_t uGnssPrivateSendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
  * uGnssPrivateStreamFillRingBuffer() to fill the ring buffer with data
  * and then uGnssPrivateStreamReadRingBuffer() to read it.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance              a pointer to the GNSS instance, cannot
  *                                   be NULL.
@@ -722,7 +1267,7 @@ int32_t uGnssPrivateSendReceiveUbxMessageAlloc(uGnssPrivateInstance_t *pInstance
 /** Send a UBX format message to the GNSS module that only has an Ack
  * response and check that it is Acked.  May be used with any transport.
  *
- * Note: gUGnssPrivateMutex should be locked before this is called.
+ * Note: the instance should be locked before this is called.
  *
  * @param[in] pInstance              a pointer to the GNSS instance, cannot
  *                                   be NULL.
@@ -742,6 +1287,34 @@ int32_t uGnssPrivateSendUbxMessage(uGnssPrivateInstance_t *pInstance,
                                    const char *pMessageBody,
                                    size_t messageBodyLengthBytes);
 
+/** Send several UBX format messages to the GNSS module, each of which
+ * only has an Ack response, and check that they are all Acked.  With a
+ * streamed transport the messages are encoded back to back and sent in
+ * a single transport write, the Acks then being collected; with an AT
+ * transport, which carries only one UBX message per AT+UGUBX command,
+ * the commands are sent under a single lock of the AT client and, up
+ * to #U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES, concatenated onto one
+ * command line, stopping at the first line that fails.  Note that,
+ * in the streamed case, and for the messages on a single line in the
+ * AT case, all of the messages are sent even if an earlier one is
+ * going to be Nacked; if that matters, e.g. because the later
+ * messages depend on the earlier ones, send them separately.
+ *
+ * Note: the instance should be locked before this is called.
+ *
+ * @param[in] pInstance      a pointer to the GNSS instance, cannot
+ *                           be NULL.
+ * @param[in] pMessageList   the messages to send; cannot be NULL.
+ * @param numMessages        the number of entries at pMessageList.
+ * @return                   zero if all of the messages were Acked, else
+ *                           negative error code; if any message was Nacked
+ *                           by the GNSS module #U_GNSS_ERROR_NACK will be
+ *                           returned.
+ */
+int32_t uGnssPrivateSendUbxMessageBatch(uGnssPrivateInstance_t *pInstance,
+                                        const uUbxProtocolMessage_t *pMessageList,
+                                        size_t numMessages);
+
 #ifdef __cplusplus
 }
 #endif
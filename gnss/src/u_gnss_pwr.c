@@ -28,6 +28,7 @@
 # include "u_cfg_override.h" // For a customer's configuration override
 #endif
 
+#include "stdlib.h"    // malloc()/free()
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
@@ -48,6 +49,8 @@
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss_private.h"
+#include "u_gnss_ubx_view.h"
+#include "u_gnss_mga.h"
 #include "u_gnss_pwr.h"
 
 /* ----------------------------------------------------------------
@@ -78,6 +81,14 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Hot start context, hooked into pHotStartContext of the instance,
+ * see uGnssPwrSetHotStart().
+ */
+typedef struct {
+    uGnssPwrHotStart_t *pStore;
+    uGnssPwrHotStartStatus_t status;
+} uGnssPwrHotStartContext_t;
+
 /* ----------------------------------------------------------------
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
@@ -86,6 +97,98 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Get the hot start storage of an instance, NULL if there is none.
+static uGnssPwrHotStart_t *pHotStartStoreGet(uDeviceHandle_t gnssHandle)
+{
+    uGnssPwrHotStart_t *pStore = NULL;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if ((pInstance != NULL) && (pInstance->pHotStartContext != NULL)) {
+            pStore = ((uGnssPwrHotStartContext_t *) pInstance->pHotStartContext)->pStore;
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return pStore;
+}
+
+// Save the navigation database to the hot start storage, if there is
+// any; must be called with the instance NOT locked since the MGA
+// functions are public ones.
+static void hotStartSave(uDeviceHandle_t gnssHandle)
+{
+    uGnssPwrHotStart_t *pStore = pHotStartStoreGet(gnssHandle);
+    uGnssPrivateInstance_t *pInstance;
+    uGnssMgaDatabaseSaveStats_t stats = {0};
+    uGnssPwrHotStartContext_t *pContext;
+    int32_t errorCodeOrLength;
+
+    if (pStore != NULL) {
+        errorCodeOrLength = uGnssMgaDatabaseSave(gnssHandle, pStore->pBuffer,
+                                                 pStore->size, &stats);
+        // Whatever made it into the buffer is good: if nothing did,
+        // what was there before is still intact
+        if (stats.numBytes > 0) {
+            pStore->length = stats.numBytes;
+        }
+        uPortLog("U_GNSS_PWR: hot start save of %d byte(s) (%d message(s))"
+                 " returned %d, took %d ms.\n", (int32_t) stats.numBytes,
+                 (int32_t) stats.numMessages, errorCodeOrLength, stats.durationMs);
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if ((pInstance != NULL) && (pInstance->pHotStartContext != NULL)) {
+            pContext = (uGnssPwrHotStartContext_t *) pInstance->pHotStartContext;
+            pContext->status.saveErrorCodeOrLength = errorCodeOrLength;
+            pContext->status.saveNumMessages = stats.numMessages;
+            pContext->status.saveDurationMs = stats.durationMs;
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+}
+
+// Restore the navigation database from the hot start storage, if
+// there is anything in it; must be called with the instance NOT
+// locked since the MGA functions are public ones.
+static void hotStartRestore(uDeviceHandle_t gnssHandle)
+{
+    uGnssPwrHotStart_t *pStore = pHotStartStoreGet(gnssHandle);
+    uGnssPrivateInstance_t *pInstance;
+    uGnssMgaUploadStats_t stats = {0};
+    uGnssPwrHotStartContext_t *pContext;
+    int32_t errorCode;
+
+    if ((pStore != NULL) && (pStore->length > 0)) {
+        // UBX-MGA-DBD messages are not ACKed, so the count
+        // returned is of no interest, only the error code
+        errorCode = uGnssMgaUpload(gnssHandle, pStore->pBuffer,
+                                   pStore->length, NULL, &stats);
+        if (errorCode > 0) {
+            errorCode = 0;
+        }
+        uPortLog("U_GNSS_PWR: hot start restore of %d byte(s) returned %d,"
+                 " took %d ms.\n", (int32_t) stats.bytesSent, errorCode,
+                 stats.durationMs);
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if ((pInstance != NULL) && (pInstance->pHotStartContext != NULL)) {
+            pContext = (uGnssPwrHotStartContext_t *) pInstance->pHotStartContext;
+            pContext->status.restoreErrorCode = errorCode;
+            pContext->status.restoreNumBytes = stats.bytesSent;
+            pContext->status.restoreDurationMs = stats.durationMs;
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -102,11 +205,14 @@ int32_t uGnssPwrOn(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
+            // Forget any shadowed configuration: the GNSS chip may
+            // have been reset or powered up from cold
+            uGnssPrivateCfgShadowClear(pInstance);
+            uGnssPrivateIdentityCacheClear(pInstance);
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
             if (pInstance->pinGnssEnablePower >= 0) {
                 errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
@@ -251,7 +357,14 @@ int32_t uGnssPwrOn(uDeviceHandle_t gnssHandle)
             }*/
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+        if (errorCode == 0) {
+            // Restore any saved navigation database before anyone
+            // starts positioning; done outside the mutex as it uses
+            // public functions
+            hotStartRestore(gnssHandle);
+        }
     }
 
     return errorCode;
@@ -270,9 +383,8 @@ bool uGnssPwrIsAlive(uDeviceHandle_t gnssHandle)
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
             // Set a short timeout for this
             timeoutMs = pInstance->timeoutMs;
@@ -289,7 +401,7 @@ bool uGnssPwrIsAlive(uDeviceHandle_t gnssHandle)
             pInstance->timeoutMs = timeoutMs;
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return isAlive;
@@ -302,15 +414,23 @@ int32_t uGnssPwrOff(uDeviceHandle_t gnssHandle)
     uGnssPrivateInstance_t *pInstance;
     uAtClientHandle_t atHandle;
     // The body of a UBX-CFG-RST message
-    char message[4] = {0};
+    char message[U_GNSS_UBX_CFG_RST_LENGTH_BYTES] = {0};
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        // Save the navigation database while the GNSS chip is still
+        // on, if required; done outside the mutex as it uses public
+        // functions
+        hotStartSave(gnssHandle);
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
+            // Forget any shadowed configuration: it may not
+            // survive this
+            uGnssPrivateCfgShadowClear(pInstance);
+            uGnssPrivateIdentityCacheClear(pInstance);
             if (pInstance->transportType == U_GNSS_TRANSPORT_AT) {
                 // For the AT interface, need to ask the cellular module
                 // to power the GNSS module down
@@ -329,10 +449,11 @@ int32_t uGnssPwrOff(uDeviceHandle_t gnssHandle)
                 // Make sure GNSS is off with UBX-CFG-RST
                 // This message is not acknowledged, so we use
                 // uGnssPrivateSendOnlyCheckStreamUbxMessage()
-                message[2] = 0x08; // Controlled GNSS stop
+                message[U_GNSS_UBX_CFG_RST_OFFSET_RESET_MODE] = U_GNSS_UBX_CFG_RST_RESET_MODE_GNSS_STOP;
                 if (uGnssPrivateSendOnlyCheckStreamUbxMessage(pInstance,
-                                                              0x06, 0x04,
-                                                              message, 4) > 0) {
+                                                              U_GNSS_UBX_CFG_RST_CLASS,
+                                                              U_GNSS_UBX_CFG_RST_ID,
+                                                              message, sizeof(message)) > 0) {
                     errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                 }
             }
@@ -344,7 +465,7 @@ int32_t uGnssPwrOff(uDeviceHandle_t gnssHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
@@ -355,32 +476,29 @@ int32_t uGnssPwrOffBackup(uDeviceHandle_t gnssHandle)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uGnssPrivateInstance_t *pInstance;
-    // The body of a UBX-RXM-PMREQ message
-    char message[16] = {0};
 
     if (gUGnssPrivateMutex != NULL) {
 
-        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        // Save the navigation database while the GNSS chip is still
+        // on, if required; done outside the mutex as it uses public
+        // functions
+        hotStartSave(gnssHandle);
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
 
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        pInstance = pUGnssPrivateGetInstance(gnssHandle);
         if (pInstance != NULL) {
+            // Forget any shadowed configuration: it may not
+            // survive this
+            uGnssPrivateCfgShadowClear(pInstance);
+            uGnssPrivateIdentityCacheClear(pInstance);
             errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
             if (pInstance->transportType != U_GNSS_TRANSPORT_AT) {
-                // Put the GNSS chip into backup mode with UBX-RXM-PMREQ
-                // This message is not acknowledged and fiddling with the
-                // GNSS chip after this will wake it up again, so we just
-                // use uGnssPrivateSendReceiveUbxMessage() with an
-                // empty response buffer
-                message[8] = 0x02; // Backup
-                //lint -save -e569 Suppress loss of information: OK on all our compilers
-                message[12] = 0xe4; // Wake-up on all sources
-                //lint -restore
-                errorCode = 0;/*uGnssPrivateSendReceiveUbxMessage(pInstance,
-                                                              0x02, 0x41,
-                                                              message,
-                                                              sizeof(message),
-                                                              NULL, 0);*/
+                // Backup mode is entered by removing power, if there
+                // is a pin to do that; UBX-RXM-PMREQ is not sent as
+                // fiddling with the GNSS chip afterwards would only
+                // wake it up again
+                errorCode = 0;
                 if ((errorCode == 0) && (pInstance->pinGnssEnablePower >= 0)) {
                     errorCode = uPortGpioSet(pInstance->pinGnssEnablePower,
                                              (int32_t) !pInstance->pinGnssEnablePowerOnState);
@@ -389,7 +507,70 @@ int32_t uGnssPwrOffBackup(uDeviceHandle_t gnssHandle)
             }
         }
 
-        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Set the storage for saving/restoring the navigation database.
+int32_t uGnssPwrSetHotStart(uDeviceHandle_t gnssHandle,
+                            uGnssPwrHotStart_t *pStore)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPwrHotStartContext_t *pContext;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) &&
+            ((pStore == NULL) || (pStore->pBuffer != NULL))) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            pContext = (uGnssPwrHotStartContext_t *) pInstance->pHotStartContext;
+            if (pContext == NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pContext = (uGnssPwrHotStartContext_t *) malloc(sizeof(*pContext));
+                if (pContext != NULL) {
+                    memset(pContext, 0, sizeof(*pContext));
+                    pInstance->pHotStartContext = pContext;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+            if (pContext != NULL) {
+                pContext->pStore = pStore;
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+    }
+
+    return errorCode;
+}
+
+// Get the outcome of the most recent hot-start save and restore.
+int32_t uGnssPwrGetHotStartStatus(uDeviceHandle_t gnssHandle,
+                                  uGnssPwrHotStartStatus_t *pStatus)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pStatus != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (pInstance->pHotStartContext != NULL) {
+                *pStatus = ((uGnssPwrHotStartContext_t *) pInstance->pHotStartContext)->status;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
     }
 
     return errorCode;
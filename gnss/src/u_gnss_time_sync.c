@@ -0,0 +1,474 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief This source file contains the implementation of the time
+ * synchronisation functions of the GNSS API.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_gpio.h"
+
+#include "u_ubx_protocol.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss_private.h"
+#include "u_gnss_ubx_view.h"
+#include "u_gnss_cfg_val_key.h"
+#include "u_gnss_cfg.h"
+#include "u_gnss_msg.h"
+#include "u_gnss_time_sync.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The number of microseconds between midnight on 1 January 1970
+ * and the start of GPS week zero, midnight on 6 January 1980.
+ */
+#define U_GNSS_TIME_SYNC_GPS_EPOCH_US 315964800000000LL
+
+/** The number of microseconds in a week.
+ */
+#define U_GNSS_TIME_SYNC_WEEK_US 604800000000LL
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// The default host tick.
+static int64_t defaultTickUs(void)
+{
+    return ((int64_t) uPortGetTickTimeMs()) * 1000;
+}
+
+// TIMEPULSE interrupt: INTERRUPT CONTEXT, do as little as possible.
+static void timepulseInterrupt(int32_t pin, void *pParam)
+{
+    uGnssPrivateTimeSync_t *pTimeSync = (uGnssPrivateTimeSync_t *) pParam;
+
+    (void) pin;
+
+    pTimeSync->pulseTickUs = ((uGnssTimeSyncTickUs_t) pTimeSync->pTickUs)();
+    pTimeSync->pulseCount++;
+}
+
+// Take a consistent copy of the pulse tick and count: the tick is
+// 64 bits, so on a 32-bit MCU it could be torn by the interrupt.
+static uint32_t pulseGet(const uGnssPrivateTimeSync_t *pTimeSync,
+                         int64_t *pTickUs)
+{
+    uint32_t pulseCount;
+
+    do {
+        pulseCount = pTimeSync->pulseCount;
+        *pTickUs = pTimeSync->pulseTickUs;
+    } while (pulseCount != pTimeSync->pulseCount);
+
+    return pulseCount;
+}
+
+// Callback for UBX-TIM-TP, which arrives ahead of the pulse it
+// describes: pair the pulse seen since the previous UBX-TIM-TP with
+// the time that message predicted, then store the new prediction.
+static void timTpCallback(uDeviceHandle_t gnssHandle,
+                          const uGnssMessageId_t *pMessageId,
+                          int32_t errorCodeOrLength,
+                          void *pCallbackParam)
+{
+    uGnssPrivateTimeSync_t *pTimeSync = (uGnssPrivateTimeSync_t *) pCallbackParam;
+    // Enough room for a whole UBX-TIM-TP message, header and CRC
+    char buffer[U_GNSS_UBX_TIM_TP_LENGTH_BYTES + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES];
+    const char *pMessage = NULL;
+    const char *pBody;
+    uint32_t pulseCount;
+    int64_t tickUs = 0;
+    int64_t timeUs;
+    uint8_t flags;
+
+    (void) pMessageId;
+
+    if (errorCodeOrLength == (int32_t) sizeof(buffer)) {
+        // Time-stamp the pulse before anything else
+        pulseCount = pulseGet(pTimeSync, &tickUs);
+        errorCodeOrLength = uGnssMsgReceiveCallbackView(gnssHandle, &pMessage);
+        if (!U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(errorCodeOrLength,
+                                            U_GNSS_UBX_TIM_TP_LENGTH_BYTES)) {
+            errorCodeOrLength = uGnssMsgReceiveCallbackRead(gnssHandle, buffer, sizeof(buffer));
+            pMessage = buffer;
+        }
+        if (U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(errorCodeOrLength,
+                                           U_GNSS_UBX_TIM_TP_LENGTH_BYTES) &&
+            (U_GNSS_UBX_VIEW_BODY_LENGTH(pMessage) == U_GNSS_UBX_TIM_TP_LENGTH_BYTES)) {
+            if (pTimeSync->nextPulseValid &&
+                (pulseCount - pTimeSync->pulseCountTimTp == 1)) {
+                // Exactly one pulse since the previous UBX-TIM-TP,
+                // so it must be the one that message described
+
+                U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+                uGnssPrivateTimeSyncUpdate(pTimeSync, tickUs,
+                                           pTimeSync->nextPulseTimeUs,
+                                           pTimeSync->nextPulseIsUtc);
+
+                U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+
+            }
+            pBody = U_GNSS_UBX_VIEW_BODY(pMessage);
+            flags = U_GNSS_UBX_TIM_TP_FLAGS(pBody);
+            // The sub-millisecond part is in units of 2^-32 ms
+            timeUs = U_GNSS_TIME_SYNC_GPS_EPOCH_US +
+                     (((int64_t) U_GNSS_UBX_TIM_TP_WEEK(pBody)) * U_GNSS_TIME_SYNC_WEEK_US) +
+                     (((int64_t) U_GNSS_UBX_TIM_TP_TOW_MS(pBody)) * 1000) +
+                     ((((int64_t) U_GNSS_UBX_TIM_TP_TOW_SUB_MS(pBody)) * 1000) >> 32);
+            pTimeSync->nextPulseTimeUs = timeUs;
+            pTimeSync->nextPulseIsUtc = ((flags & U_GNSS_UBX_TIM_TP_FLAGS_TIME_BASE_UTC) != 0) &&
+                                        ((flags & U_GNSS_UBX_TIM_TP_FLAGS_UTC_AVAILABLE) != 0);
+            pTimeSync->pulseCountTimTp = pulseCount;
+            pTimeSync->nextPulseValid = true;
+        }
+    }
+}
+
+// Stop time synchronisation, putting everything back as it was.
+static void timeSyncStop(uDeviceHandle_t gnssHandle,
+                         uGnssPrivateTimeSync_t *pTimeSync)
+{
+    uGnssCfgVal_t cfgVal;
+
+    uPortGpioInterruptSet(pTimeSync->pinTimepulse, true, NULL, NULL);
+    if (pTimeSync->asyncHandle >= 0) {
+        uGnssMsgReceiveStop(gnssHandle, pTimeSync->asyncHandle);
+    }
+    cfgVal.keyId = pTimeSync->keyIdMsgOut;
+    cfgVal.value = pTimeSync->msgOutSaved;
+    uGnssCfgValSetList(gnssHandle, &cfgVal, 1,
+                       U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                       U_GNSS_CFG_VAL_LAYER_RAM);
+}
+
+// Set or clear the time synchronisation pointer of an instance.
+static void timeSyncSet(uDeviceHandle_t gnssHandle,
+                        uGnssPrivateTimeSync_t *pTimeSync)
+{
+    uGnssPrivateInstance_t *pInstance;
+
+    U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+    pInstance = pUGnssPrivateGetInstance(gnssHandle);
+    if (pInstance != NULL) {
+        pInstance->pTimeSync = pTimeSync;
+    }
+
+    U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS THAT ARE PRIVATE TO GNSS
+ * -------------------------------------------------------------- */
+
+// Add a pulse at a known time to the model.
+void uGnssPrivateTimeSyncUpdate(uGnssPrivateTimeSync_t *pTimeSync,
+                                int64_t tickUs, int64_t timeUs, bool isUtc)
+{
+    int64_t deltaTimeUs;
+    int64_t deltaTickUs;
+
+    if (pTimeSync->numPulses > 0) {
+        deltaTimeUs = timeUs - pTimeSync->refTimeUs;
+        deltaTickUs = tickUs - pTimeSync->refTickUs;
+        if ((isUtc != pTimeSync->isUtc) || (deltaTimeUs <= 0) ||
+            (deltaTickUs - deltaTimeUs > (deltaTimeUs * U_GNSS_TIME_SYNC_MAX_DRIFT_PPM) / 1000000) ||
+            (deltaTimeUs - deltaTickUs > (deltaTimeUs * U_GNSS_TIME_SYNC_MAX_DRIFT_PPM) / 1000000)) {
+            // Not believable (a missed pulse, a wrap of the host
+            // tick or a change of time base): start again
+            pTimeSync->numPulses = 0;
+        }
+    }
+
+    if (pTimeSync->numPulses == 0) {
+        pTimeSync->anchorTickUs = tickUs;
+        pTimeSync->anchorTimeUs = timeUs;
+        pTimeSync->driftPpb = 0;
+        pTimeSync->driftFromWindow = false;
+    } else {
+        // Measure drift against the anchor: until a whole window
+        // has passed use whatever baseline there is, after that
+        // only update drift, and move the anchor on, once per window
+        deltaTimeUs = timeUs - pTimeSync->anchorTimeUs;
+        deltaTickUs = tickUs - pTimeSync->anchorTickUs;
+        if ((deltaTimeUs >= ((int64_t) U_GNSS_TIME_SYNC_DRIFT_WINDOW_SECONDS) * 1000000) ||
+            !pTimeSync->driftFromWindow) {
+            pTimeSync->driftPpb = (int32_t) (((deltaTickUs - deltaTimeUs) * 1000000000) / deltaTimeUs);
+        }
+        if (deltaTimeUs >= ((int64_t) U_GNSS_TIME_SYNC_DRIFT_WINDOW_SECONDS) * 1000000) {
+            pTimeSync->anchorTickUs = tickUs;
+            pTimeSync->anchorTimeUs = timeUs;
+            pTimeSync->driftFromWindow = true;
+        }
+    }
+
+    pTimeSync->refTickUs = tickUs;
+    pTimeSync->refTimeUs = timeUs;
+    pTimeSync->isUtc = isUtc;
+    pTimeSync->numPulses++;
+}
+
+// Convert a host tick to GNSS time using the model.
+int64_t uGnssPrivateTimeSyncGetTimeUs(const uGnssPrivateTimeSync_t *pTimeSync,
+                                      int64_t tickUs)
+{
+    int64_t errorCodeOrTime = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+
+    if (pTimeSync->numPulses > 0) {
+        tickUs -= pTimeSync->refTickUs;
+        errorCodeOrTime = pTimeSync->refTimeUs + tickUs -
+                          ((tickUs * pTimeSync->driftPpb) / 1000000000);
+    }
+
+    return errorCodeOrTime;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start time synchronisation.
+int32_t uGnssTimeSyncStart(uDeviceHandle_t gnssHandle,
+                           int32_t pinTimepulse,
+                           uGnssTimeSyncTickUs_t pTickUs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateTimeSync_t *pTimeSync = NULL;
+    uGnssMessageId_t messageId;
+    uGnssCfgVal_t cfgVal;
+    uPortGpioConfig_t gpioConfig;
+    uint32_t keyIdMsgOut = 0;
+    uint8_t msgOut = 0;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pinTimepulse >= 0)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
+                switch (uGnssPrivateGetStreamType(pInstance->transportType)) {
+                    case U_GNSS_PRIVATE_STREAM_TYPE_UART:
+                        keyIdMsgOut = U_GNSS_CFG_VAL_KEY_ID_MSGOUT_UBX_TIM_TP_UART1_U1;
+                        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        break;
+                    case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
+                        keyIdMsgOut = U_GNSS_CFG_VAL_KEY_ID_MSGOUT_UBX_TIM_TP_I2C_U1;
+                        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        break;
+                    case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+                        keyIdMsgOut = U_GNSS_CFG_VAL_KEY_ID_MSGOUT_UBX_TIM_TP_SPI_U1;
+                        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        break;
+                    default:
+                        break;
+                }
+                if ((errorCode == (int32_t) U_ERROR_COMMON_NO_MEMORY) &&
+                    (pInstance->pTimeSync == NULL)) {
+                    pTimeSync = (uGnssPrivateTimeSync_t *) malloc(sizeof(*pTimeSync));
+                    if (pTimeSync != NULL) {
+                        memset(pTimeSync, 0, sizeof(*pTimeSync));
+                        pTimeSync->asyncHandle = -1;
+                        pTimeSync->keyIdMsgOut = keyIdMsgOut;
+                        pTimeSync->pinTimepulse = pinTimepulse;
+                        if (pTickUs == NULL) {
+                            pTickUs = defaultTickUs;
+                        }
+                        pTimeSync->pTickUs = (void *) pTickUs;
+                        // Claim the slot now, the rest is done outside
+                        // the mutex since it uses public APIs
+                        timeSyncSet(gnssHandle, pTimeSync);
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    }
+                }
+            }
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+        if (pTimeSync != NULL) {
+            // Remember what we're about to change
+            errorCode = uGnssCfgValGet(gnssHandle, pTimeSync->keyIdMsgOut,
+                                       &msgOut, sizeof(msgOut),
+                                       U_GNSS_CFG_VAL_LAYER_RAM);
+            pTimeSync->msgOutSaved = msgOut;
+            if (errorCode == 0) {
+                U_PORT_GPIO_SET_DEFAULT(&gpioConfig);
+                gpioConfig.pin = pinTimepulse;
+                gpioConfig.direction = U_PORT_GPIO_DIRECTION_INPUT;
+                gpioConfig.pullMode = U_PORT_GPIO_PULL_MODE_PULL_DOWN;
+                errorCode = uPortGpioConfig(&gpioConfig);
+            }
+            if (errorCode == 0) {
+                errorCode = uPortGpioInterruptSet(pinTimepulse, true,
+                                                  timepulseInterrupt,
+                                                  pTimeSync);
+            }
+            if (errorCode == 0) {
+                // Start listening before the messages start to flow
+                messageId.type = U_GNSS_PROTOCOL_UBX;
+                messageId.id.ubx = (U_GNSS_UBX_TIM_TP_CLASS << 8) | U_GNSS_UBX_TIM_TP_ID;
+                errorCode = uGnssMsgReceiveStart(gnssHandle, &messageId,
+                                                 timTpCallback, pTimeSync);
+                if (errorCode >= 0) {
+                    pTimeSync->asyncHandle = errorCode;
+                    // Now switch on UBX-TIM-TP every epoch
+                    cfgVal.keyId = pTimeSync->keyIdMsgOut;
+                    cfgVal.value = 1;
+                    errorCode = uGnssCfgValSetList(gnssHandle, &cfgVal, 1,
+                                                   U_GNSS_CFG_VAL_TRANSACTION_NONE,
+                                                   U_GNSS_CFG_VAL_LAYER_RAM);
+                }
+            }
+            if (errorCode != 0) {
+                // Put things back as they were
+                timeSyncStop(gnssHandle, pTimeSync);
+                timeSyncSet(gnssHandle, NULL);
+                free(pTimeSync);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Get the model.
+int32_t uGnssTimeSyncGetModel(uDeviceHandle_t gnssHandle,
+                              uGnssTimeSyncModel_t *pModel)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateTimeSync_t *pTimeSync;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        // Deliberately not the instance lock: this must not wait
+        // for whatever else might be talking to the GNSS chip
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) && (pModel != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            pTimeSync = pInstance->pTimeSync;
+            if ((pTimeSync != NULL) && (pTimeSync->numPulses > 0)) {
+                pModel->tickUs = pTimeSync->refTickUs;
+                pModel->timeUs = pTimeSync->refTimeUs;
+                pModel->driftPpb = pTimeSync->driftPpb;
+                pModel->isUtc = pTimeSync->isUtc;
+                pModel->numPulses = pTimeSync->numPulses;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Convert a host tick to GNSS time.
+int64_t uGnssTimeSyncGetTimeUs(uDeviceHandle_t gnssHandle,
+                               int64_t tickUs)
+{
+    int64_t errorCodeOrTime = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        // Deliberately not the instance lock, as for
+        // uGnssTimeSyncGetModel()
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCodeOrTime = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+            errorCodeOrTime = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            if (pInstance->pTimeSync != NULL) {
+                errorCodeOrTime = uGnssPrivateTimeSyncGetTimeUs(pInstance->pTimeSync,
+                                                                tickUs);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCodeOrTime;
+}
+
+// Stop time synchronisation.
+void uGnssTimeSyncStop(uDeviceHandle_t gnssHandle)
+{
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateTimeSync_t *pTimeSync = NULL;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_GNSS_PRIVATE_INSTANCE_LOCK(gnssHandle, pInstance);
+
+        if (pInstance != NULL) {
+            pTimeSync = pInstance->pTimeSync;
+            timeSyncSet(gnssHandle, NULL);
+        }
+
+        U_GNSS_PRIVATE_INSTANCE_UNLOCK();
+
+        if (pTimeSync != NULL) {
+            timeSyncStop(gnssHandle, pTimeSync);
+            free(pTimeSync);
+        }
+    }
+}
+
+// End of file
@@ -0,0 +1,729 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Benchmark of the GNSS message pipeline: synthetic UBX, NMEA
+ * and RTCM data from u_gnss_test_generator.c is fed into the ring
+ * buffer of a GNSS instance that has no GNSS chip behind it and
+ * read by 1, 4 and then 10 non-blocking message readers, one of
+ * which decodes UBX-NAV-PVT in the way that uGnssPosGet() does;
+ * messages per second, loss counters and, if U_CFG_PROFILE is
+ * defined, the cycles spent decoding and dispatching each message,
+ * are printed.  No GNSS chip is required.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"   // Required by u_gnss_private.h
+
+#include "u_ubx_protocol.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_msg.h"
+#include "u_gnss_ubx_view.h"
+#include "u_gnss_private.h"
+
+#include "u_gnss_test_generator.h"
+
+// NRF52, which we use NRF5SDK on, doesn't have enough heap for this test
+#ifndef U_CFG_TEST_USING_NRF5SDK
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_BENCHMARK_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_GNSS_BENCHMARK_TEST_MODULE_TYPE
+# ifdef U_CFG_TEST_GNSS_MODULE_TYPE
+/** The module type that the virtual stream pretends to be.
+ */
+#  define U_GNSS_BENCHMARK_TEST_MODULE_TYPE U_CFG_TEST_GNSS_MODULE_TYPE
+# else
+#  define U_GNSS_BENCHMARK_TEST_MODULE_TYPE U_GNSS_MODULE_TYPE_M9
+# endif
+#endif
+
+#ifndef U_GNSS_BENCHMARK_TEST_MIX
+/** The mix of messages in each epoch, see uGnssTestGeneratorMix_t.
+ */
+# define U_GNSS_BENCHMARK_TEST_MIX U_GNSS_TEST_GENERATOR_MIX_DEFAULTS
+#endif
+
+#ifndef U_GNSS_BENCHMARK_TEST_EPOCH_PERIOD_MS
+/** The period between epochs: 20 Hz with the default mix is
+ * about 55 kbytes/s, a fully loaded 921,600 bits/s UART.
+ */
+# define U_GNSS_BENCHMARK_TEST_EPOCH_PERIOD_MS 50
+#endif
+
+#ifndef U_GNSS_BENCHMARK_TEST_NUM_EPOCHS
+/** The number of epochs to feed for each number of readers.
+ */
+# define U_GNSS_BENCHMARK_TEST_NUM_EPOCHS 100
+#endif
+
+#ifndef U_GNSS_BENCHMARK_TEST_RING_BUFFER_LENGTH_BYTES
+/** The length of ring buffer to use: the message receive task only
+ * runs every #U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS or so, hence the
+ * ring buffer has to hold a few epochs.
+ */
+# define U_GNSS_BENCHMARK_TEST_RING_BUFFER_LENGTH_BYTES (1024 * 16)
+#endif
+
+#ifndef U_GNSS_BENCHMARK_TEST_DRAIN_TIMEOUT_MS
+/** How long to wait for the readers to catch up once the last
+ * epoch has been fed.
+ */
+# define U_GNSS_BENCHMARK_TEST_DRAIN_TIMEOUT_MS 2000
+#endif
+
+/** The number of readers in each run.
+ */
+#define U_GNSS_BENCHMARK_TEST_NUM_READERS {1, 4, 10}
+
+/** The mix for the message filter test: one of each kind of
+ * message that the generator produces in every epoch, see
+ * gFilterEpoch[].
+ */
+#define U_GNSS_BENCHMARK_TEST_FILTER_MIX {1, 1, 8, 6, 6, 100, 256}
+
+/** The number of epochs to feed in each step of the message filter
+ * test.
+ */
+#define U_GNSS_BENCHMARK_TEST_FILTER_NUM_EPOCHS 20
+
+/** The period between epochs in the message filter test, slow
+ * enough that nothing should be lost.
+ */
+#define U_GNSS_BENCHMARK_TEST_FILTER_EPOCH_PERIOD_MS 20
+
+/** How long to wait, once the readers in the message filter test
+ * have what they should, for anything more that they should not.
+ */
+#define U_GNSS_BENCHMARK_TEST_FILTER_SETTLE_TIME_MS 250
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** What a reader subscribes to and how many of the generated
+ * messages that should match.
+ */
+typedef struct {
+    uGnssProtocol_t protocol;
+    uint16_t id;            /**< UBX class/ID or RTCM type. */
+    const char *pNmea;      /**< for NMEA, NULL for all. */
+    bool decodeNavPvt;      /**< decode rather than copy out. */
+} uGnssBenchmarkTestSubscription_t;
+
+/** The state of a reader.
+ */
+typedef struct {
+    const uGnssBenchmarkTestSubscription_t *pSubscription;
+    int32_t asyncHandle;
+    size_t numReceived;
+    size_t numBytes;
+    size_t numBad;
+} uGnssBenchmarkTestReader_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The subscriptions of the readers, in the order the readers
+ * are started; the first reader takes everything so that its count
+ * is the number of messages that made it through the pipeline.
+ */
+static const uGnssBenchmarkTestSubscription_t gSubscription[] = {
+    {U_GNSS_PROTOCOL_ALL, 0, NULL, false},
+    {U_GNSS_PROTOCOL_UBX, (U_GNSS_UBX_NAV_PVT_CLASS << 8) | U_GNSS_UBX_NAV_PVT_ID, NULL, true},
+    {U_GNSS_PROTOCOL_NMEA, 0, NULL, false},
+    {U_GNSS_PROTOCOL_RTCM, 1077, NULL, false},
+    {U_GNSS_PROTOCOL_UBX, (U_GNSS_UBX_RXM_RAWX_CLASS << 8) | U_GNSS_UBX_RXM_RAWX_ID, NULL, false},
+    {U_GNSS_PROTOCOL_UBX, (U_GNSS_UBX_MESSAGE_CLASS_ALL << 8) | U_GNSS_UBX_MESSAGE_ID_ALL, NULL, false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "G?GSV", false},
+    {U_GNSS_PROTOCOL_RTCM, 1230, NULL, false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GNGGA", false},
+    {U_GNSS_PROTOCOL_ALL, 0, NULL, false}
+};
+
+/** The messages in each epoch with #U_GNSS_BENCHMARK_TEST_FILTER_MIX,
+ * in the order the generator produces them.
+ */
+static const uGnssBenchmarkTestSubscription_t gFilterEpoch[] = {
+    {U_GNSS_PROTOCOL_UBX, (U_GNSS_UBX_NAV_PVT_CLASS << 8) | U_GNSS_UBX_NAV_PVT_ID, NULL, false},
+    {U_GNSS_PROTOCOL_UBX, (U_GNSS_UBX_RXM_RAWX_CLASS << 8) | U_GNSS_UBX_RXM_RAWX_ID, NULL, false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GNGGA", false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GNRMC", false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GNGSA", false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGSV", false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGSV", false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGSV", false},
+    {U_GNSS_PROTOCOL_RTCM, 1005, NULL, false},
+    {U_GNSS_PROTOCOL_RTCM, 1077, NULL, false},
+    {U_GNSS_PROTOCOL_RTCM, 1087, NULL, false},
+    {U_GNSS_PROTOCOL_RTCM, 1097, NULL, false},
+    {U_GNSS_PROTOCOL_RTCM, 1127, NULL, false},
+    {U_GNSS_PROTOCOL_RTCM, 1230, NULL, false}
+};
+
+/** The subscriptions of the readers in the message filter test:
+ * only selective ones, so that the filter has something to drop;
+ * each wants exactly one message of gFilterEpoch[].
+ */
+static const uGnssBenchmarkTestSubscription_t gFilterSubscription[] = {
+    {U_GNSS_PROTOCOL_UBX, (U_GNSS_UBX_NAV_PVT_CLASS << 8) | U_GNSS_UBX_NAV_PVT_ID, NULL, true},
+    {U_GNSS_PROTOCOL_RTCM, 1077, NULL, false},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GNGGA", false}
+};
+
+/** The readers.
+ */
+static uGnssBenchmarkTestReader_t gReader[sizeof(gSubscription) / sizeof(gSubscription[0])];
+
+/** The generator.
+ */
+static uGnssTestGenerator_t gGenerator = {0};
+
+/** Somewhere for the readers to copy messages to; they are all
+ * called from the same task so they can share it.
+ */
+static char *gpMessageBuffer = NULL;
+
+/** The length of gpMessageBuffer.
+ */
+static size_t gMessageBufferLength = 0;
+
+/** The handle of the GNSS instance with the virtual stream.
+ */
+static uDeviceHandle_t gGnssHandle = NULL;
+
+/** A variable to track errors in the callbacks.
+ */
+static int32_t gCallbackErrorCode = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Callback for the non-blocking message receives.
+static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
+                                   const uGnssMessageId_t *pMessageId,
+                                   int32_t errorCodeOrLength,
+                                   void *pCallbackParam)
+{
+    uGnssBenchmarkTestReader_t *pReader = (uGnssBenchmarkTestReader_t *) pCallbackParam;
+    const char *pMessage = NULL;
+    int32_t length;
+
+    if (gnssHandle != gGnssHandle) {
+        gCallbackErrorCode = 1;
+    }
+    if ((pMessageId == NULL) || (errorCodeOrLength < 0) || (pReader == NULL)) {
+        gCallbackErrorCode = 2;
+    } else {
+        pReader->numReceived++;
+        pReader->numBytes += errorCodeOrLength;
+        if (pReader->pSubscription->decodeNavPvt) {
+            // Do what uGnssPosGet() and friends do: look at it in
+            // place, copying it out only if it wraps
+            length = uGnssMsgReceiveCallbackView(gnssHandle, &pMessage);
+            if (!U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(length, U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES)) {
+                length = uGnssMsgReceiveCallbackRead(gnssHandle, gpMessageBuffer,
+                                                     gMessageBufferLength);
+                pMessage = gpMessageBuffer;
+            }
+            if (!U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(length, U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES) ||
+                (U_GNSS_UBX_NAV_PVT_FIX_TYPE(U_GNSS_UBX_VIEW_BODY(pMessage)) != 3) ||
+                (U_GNSS_UBX_NAV_PVT_NUM_SV(U_GNSS_UBX_VIEW_BODY(pMessage)) != 12) ||
+                (U_GNSS_UBX_NAV_PVT_LAT(U_GNSS_UBX_VIEW_BODY(pMessage)) > gGenerator.latitudeX1e7) ||
+                (U_GNSS_UBX_NAV_PVT_LON(U_GNSS_UBX_VIEW_BODY(pMessage)) > gGenerator.longitudeX1e7)) {
+                pReader->numBad++;
+            }
+        } else if ((errorCodeOrLength <= (int32_t) gMessageBufferLength) &&
+                   (uGnssMsgReceiveCallbackRead(gnssHandle, gpMessageBuffer,
+                                                gMessageBufferLength) != errorCodeOrLength)) {
+            pReader->numBad++;
+        }
+    }
+}
+
+// Return the number of messages that a subscription should have
+// matched, given what the generator has generated.
+static size_t numExpected(const uGnssBenchmarkTestSubscription_t *pSubscription,
+                          const uGnssTestGenerator_t *pGenerator)
+{
+    size_t num = 0;
+    size_t numNmea = pGenerator->numMessages[U_GNSS_TEST_GENERATOR_KIND_NMEA];
+    size_t numRtcm = pGenerator->numMessages[U_GNSS_TEST_GENERATOR_KIND_RTCM];
+    uint16_t ubxAll = (U_GNSS_UBX_MESSAGE_CLASS_ALL << 8) | U_GNSS_UBX_MESSAGE_ID_ALL;
+
+    switch (pSubscription->protocol) {
+        case U_GNSS_PROTOCOL_ALL:
+            for (size_t x = 0; x < U_GNSS_TEST_GENERATOR_KIND_MAX_NUM; x++) {
+                num += pGenerator->numMessages[x];
+            }
+            break;
+        case U_GNSS_PROTOCOL_UBX:
+            if ((pSubscription->id == ubxAll) ||
+                (pSubscription->id == ((U_GNSS_UBX_NAV_PVT_CLASS << 8) | U_GNSS_UBX_NAV_PVT_ID))) {
+                num += pGenerator->numMessages[U_GNSS_TEST_GENERATOR_KIND_NAV_PVT];
+            }
+            if ((pSubscription->id == ubxAll) ||
+                (pSubscription->id == ((U_GNSS_UBX_RXM_RAWX_CLASS << 8) | U_GNSS_UBX_RXM_RAWX_ID))) {
+                num += pGenerator->numMessages[U_GNSS_TEST_GENERATOR_KIND_RXM_RAWX];
+            }
+            break;
+        case U_GNSS_PROTOCOL_NMEA:
+            // The generator cycles through GGA, RMC, GSA and then
+            // three GSVs
+            num = numNmea;
+            if (pSubscription->pNmea != NULL) {
+                if (strcmp(pSubscription->pNmea, "GNGGA") == 0) {
+                    num = (numNmea / 6) + ((numNmea % 6) > 0 ? 1 : 0);
+                } else {
+                    num = ((numNmea / 6) * 3) + ((numNmea % 6) > 3 ? (numNmea % 6) - 3 : 0);
+                }
+            }
+            break;
+        case U_GNSS_PROTOCOL_RTCM:
+            // The generator cycles through 1005, 1077, 1087, 1097,
+            // 1127 and 1230
+            num = numRtcm / 6;
+            if (((pSubscription->id == 1077) && ((numRtcm % 6) > 1)) ||
+                ((pSubscription->id == 1230) && ((numRtcm % 6) > 5))) {
+                num++;
+            }
+            break;
+        default:
+            break;
+    }
+
+    return num;
+}
+
+// Stop all of the readers.
+static void stopReaders()
+{
+    for (size_t x = 0; x < sizeof(gReader) / sizeof(gReader[0]); x++) {
+        if (gReader[x].asyncHandle >= 0) {
+            uGnssMsgReceiveStop(gGnssHandle, gReader[x].asyncHandle);
+            gReader[x].asyncHandle = -1;
+        }
+    }
+}
+
+// Convert a subscription into a public message ID.
+static void messageIdFromSubscription(const uGnssBenchmarkTestSubscription_t *pSubscription,
+                                      uGnssMessageId_t *pMessageId)
+{
+    pMessageId->type = pSubscription->protocol;
+    if (pMessageId->type == U_GNSS_PROTOCOL_NMEA) {
+        pMessageId->id.pNmea = (char *) pSubscription->pNmea;
+    } else if (pMessageId->type == U_GNSS_PROTOCOL_RTCM) {
+        pMessageId->id.rtcm = pSubscription->id;
+    } else {
+        pMessageId->id.ubx = pSubscription->id;
+    }
+}
+
+// Return the number of the messages in an epoch of gFilterEpoch[]
+// that pass the message filter of the message receive task.
+static size_t filterNumPassed()
+{
+    size_t num = 0;
+    uGnssPrivateInstance_t *pInstance = pUGnssPrivateGetInstance(gGnssHandle);
+    uGnssMessageId_t messageId;
+    uGnssPrivateMessageId_t privateMessageId;
+
+    U_PORT_TEST_ASSERT((pInstance != NULL) && (pInstance->pMsgReceive != NULL));
+    for (size_t x = 0; x < sizeof(gFilterEpoch) / sizeof(gFilterEpoch[0]); x++) {
+        messageIdFromSubscription(&(gFilterEpoch[x]), &messageId);
+        U_PORT_TEST_ASSERT(uGnssPrivateMessageIdToPrivate(&messageId, &privateMessageId) == 0);
+        if (uGnssPrivateMsgFilterMatch(&(pInstance->pMsgReceive->filter), &privateMessageId)) {
+            num++;
+        }
+    }
+
+    return num;
+}
+
+// Feed epochs from the generator and wait for each reader of the
+// message filter test to have received the given number of
+// messages, then a little longer in case any more turn up.
+static void filterFeed(int32_t numEpochs, const size_t *pNumExpected)
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    bool done = false;
+
+    U_PORT_TEST_ASSERT(uGnssTestGeneratorFeed(gGnssHandle, &gGenerator, numEpochs,
+                                              U_GNSS_BENCHMARK_TEST_FILTER_EPOCH_PERIOD_MS) ==
+                       numEpochs);
+    while (!done &&
+           (uPortGetTickTimeMs() - startTimeMs < (numEpochs *
+                                                 U_GNSS_BENCHMARK_TEST_FILTER_EPOCH_PERIOD_MS) +
+            U_GNSS_BENCHMARK_TEST_DRAIN_TIMEOUT_MS)) {
+        done = true;
+        for (size_t x = 0; x < sizeof(gFilterSubscription) / sizeof(gFilterSubscription[0]); x++) {
+            if (gReader[x].numReceived < *(pNumExpected + x)) {
+                done = false;
+            }
+        }
+        uPortTaskBlock(10);
+    }
+    uPortTaskBlock(U_GNSS_BENCHMARK_TEST_FILTER_SETTLE_TIME_MS);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Benchmark the message pipeline with 1, 4 and 10 readers.
+ */
+U_PORT_TEST_FUNCTION("[gnssBenchmark]", "gnssBenchmarkPipeline")
+{
+    int32_t heapUsed;
+    uGnssTestGeneratorMix_t mix = U_GNSS_BENCHMARK_TEST_MIX;
+    size_t numReaders[] = U_GNSS_BENCHMARK_TEST_NUM_READERS;
+    uGnssMessageId_t messageId;
+    size_t numGenerated;
+    size_t numDelivered;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t x;
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uGnssInit() == 0);
+
+    gMessageBufferLength = U_GNSS_UBX_RXM_RAWX_BODY_LENGTH_BYTES(mix.rxmRawxNumMeas) +
+                           U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
+    if (gMessageBufferLength < mix.rtcmBodyLengthBytes + 6) {
+        gMessageBufferLength = mix.rtcmBodyLengthBytes + 6;
+    }
+    gpMessageBuffer = (char *) malloc(gMessageBufferLength);
+    U_PORT_TEST_ASSERT(gpMessageBuffer != NULL);
+
+    for (size_t r = 0; r < sizeof(numReaders) / sizeof(numReaders[0]); r++) {
+        U_TEST_PRINT_LINE("%d reader(s), %d epoch(s) every %d ms of %d NAV-PVT,"
+                          " %d RXM-RAWX (%d measurements), %d NMEA and %d"
+                          " RTCM (%d byte body).", numReaders[r],
+                          U_GNSS_BENCHMARK_TEST_NUM_EPOCHS,
+                          U_GNSS_BENCHMARK_TEST_EPOCH_PERIOD_MS,
+                          mix.numNavPvt, mix.numRxmRawx, mix.rxmRawxNumMeas,
+                          mix.numNmea, mix.numRtcm, mix.rtcmBodyLengthBytes);
+        U_PORT_TEST_ASSERT(uGnssTestGeneratorInit(&gGenerator, &mix) == 0);
+        U_PORT_TEST_ASSERT(uGnssTestGeneratorAdd(U_GNSS_BENCHMARK_TEST_MODULE_TYPE,
+                                                 U_GNSS_BENCHMARK_TEST_RING_BUFFER_LENGTH_BYTES,
+                                                 &gGnssHandle) == 0);
+        memset(gReader, 0, sizeof(gReader));
+        for (size_t y = 0; y < sizeof(gReader) / sizeof(gReader[0]); y++) {
+            gReader[y].pSubscription = &(gSubscription[y]);
+            gReader[y].asyncHandle = -1;
+        }
+        for (size_t y = 0; (y < numReaders[r]) && (y < sizeof(gReader) / sizeof(gReader[0])); y++) {
+            messageId.type = gSubscription[y].protocol;
+            if (messageId.type == U_GNSS_PROTOCOL_NMEA) {
+                messageId.id.pNmea = (char *) gSubscription[y].pNmea;
+            } else if (messageId.type == U_GNSS_PROTOCOL_RTCM) {
+                messageId.id.rtcm = gSubscription[y].id;
+            } else {
+                messageId.id.ubx = gSubscription[y].id;
+            }
+            gReader[y].asyncHandle = uGnssMsgReceiveStart(gGnssHandle, &messageId,
+                                                          messageReceiveCallback,
+                                                          &(gReader[y]));
+            U_PORT_TEST_ASSERT(gReader[y].asyncHandle >= 0);
+        }
+#ifdef U_CFG_PROFILE
+        uPortProfileReset();
+#endif
+
+        // Feed the epochs and then wait for the first reader,
+        // which takes everything, to catch up
+        startTimeMs = uPortGetTickTimeMs();
+        U_PORT_TEST_ASSERT(uGnssTestGeneratorFeed(gGnssHandle, &gGenerator,
+                                                  U_GNSS_BENCHMARK_TEST_NUM_EPOCHS,
+                                                  U_GNSS_BENCHMARK_TEST_EPOCH_PERIOD_MS) ==
+                           U_GNSS_BENCHMARK_TEST_NUM_EPOCHS);
+        numGenerated = numExpected(&(gSubscription[0]), &gGenerator);
+        while ((gReader[0].numReceived < numGenerated) &&
+               (uPortGetTickTimeMs() - startTimeMs <
+                (U_GNSS_BENCHMARK_TEST_NUM_EPOCHS * U_GNSS_BENCHMARK_TEST_EPOCH_PERIOD_MS) +
+                U_GNSS_BENCHMARK_TEST_DRAIN_TIMEOUT_MS)) {
+            uPortTaskBlock(10);
+        }
+        durationMs = uPortGetTickTimeMs() - startTimeMs;
+        numDelivered = gReader[0].numReceived;
+        if (durationMs <= 0) {
+            durationMs = 1;
+        }
+
+        U_TEST_PRINT_LINE("%d message(s), %d byte(s), generated, %d delivered"
+                          " in %d ms: %d message(s)/s.", numGenerated,
+                          gGenerator.numBytes, numDelivered, durationMs,
+                          (int32_t) (((int64_t) numDelivered * 1000) / durationMs));
+        U_TEST_PRINT_LINE("%d byte(s) dropped by the feed, read loss %d byte(s),"
+                          " stream loss %d byte(s), %d eviction(s), read high"
+                          " water mark %d byte(s) of %d.",
+                          gGenerator.numBytesDropped,
+                          uGnssMsgReceiveStatReadLoss(gGnssHandle),
+                          uGnssMsgReceiveStatStreamLoss(gGnssHandle),
+                          uGnssMsgReceiveStatStreamEvictions(gGnssHandle),
+                          uGnssMsgReceiveStatReadHighWaterMark(gGnssHandle),
+                          U_GNSS_BENCHMARK_TEST_RING_BUFFER_LENGTH_BYTES);
+        for (size_t y = 0; y < numReaders[r]; y++) {
+            U_TEST_PRINT_LINE("  reader %2d: %5d of %5d message(s), %7d byte(s), %d bad.",
+                              y + 1, gReader[y].numReceived,
+                              numExpected(gReader[y].pSubscription, &gGenerator),
+                              gReader[y].numBytes, gReader[y].numBad);
+            U_PORT_TEST_ASSERT(gReader[y].numBad == 0);
+            U_PORT_TEST_ASSERT(gReader[y].numReceived <=
+                               numExpected(gReader[y].pSubscription, &gGenerator));
+        }
+#ifdef U_CFG_PROFILE
+        // The gnssMsgDispatch probe gives the cycles per message
+        uPortProfilePrint();
+#endif
+        x = uGnssMsgReceiveStackMinFree(gGnssHandle);
+        if (x >= 0) {
+            U_TEST_PRINT_LINE("message receive task had a minimum of %d byte(s)"
+                              " stack free.", x);
+        }
+        U_PORT_TEST_ASSERT(gCallbackErrorCode == 0);
+        U_PORT_TEST_ASSERT(numDelivered > 0);
+
+        stopReaders();
+        uGnssRemove(gGnssHandle);
+        gGnssHandle = NULL;
+        uGnssTestGeneratorDeinit(&gGenerator);
+    }
+
+    free(gpMessageBuffer);
+    gpMessageBuffer = NULL;
+
+    uGnssDeinit();
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Check that the message filter of the message receive task drops
+ * exactly the messages that none of a set of selective readers
+ * wants, that each reader gets exactly what it asked for and that
+ * the filter is rebuilt as readers are stopped.
+ */
+U_PORT_TEST_FUNCTION("[gnssBenchmark]", "gnssBenchmarkFilter")
+{
+    int32_t heapUsed;
+    uGnssTestGeneratorMix_t mix = U_GNSS_BENCHMARK_TEST_FILTER_MIX;
+    const size_t numReaders = sizeof(gFilterSubscription) / sizeof(gFilterSubscription[0]);
+    const size_t numPerEpoch = sizeof(gFilterEpoch) / sizeof(gFilterEpoch[0]);
+    const int32_t numEpochs = U_GNSS_BENCHMARK_TEST_FILTER_NUM_EPOCHS;
+    size_t numExpectedReceived[sizeof(gFilterSubscription) / sizeof(gFilterSubscription[0])];
+    uGnssMessageId_t messageId;
+    size_t numPassed;
+    size_t numDropped = 0;
+    uGnssPrivateInstance_t *pInstance;
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uGnssInit() == 0);
+
+    gMessageBufferLength = U_GNSS_UBX_RXM_RAWX_BODY_LENGTH_BYTES(mix.rxmRawxNumMeas) +
+                           U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
+    if (gMessageBufferLength < mix.rtcmBodyLengthBytes + 6) {
+        gMessageBufferLength = mix.rtcmBodyLengthBytes + 6;
+    }
+    gpMessageBuffer = (char *) malloc(gMessageBufferLength);
+    U_PORT_TEST_ASSERT(gpMessageBuffer != NULL);
+    U_PORT_TEST_ASSERT(uGnssTestGeneratorInit(&gGenerator, &mix) == 0);
+    U_PORT_TEST_ASSERT(uGnssTestGeneratorAdd(U_GNSS_BENCHMARK_TEST_MODULE_TYPE,
+                                             U_GNSS_BENCHMARK_TEST_RING_BUFFER_LENGTH_BYTES,
+                                             &gGnssHandle) == 0);
+    memset(gReader, 0, sizeof(gReader));
+    for (size_t x = 0; x < sizeof(gReader) / sizeof(gReader[0]); x++) {
+        gReader[x].asyncHandle = -1;
+    }
+    for (size_t x = 0; x < numReaders; x++) {
+        gReader[x].pSubscription = &(gFilterSubscription[x]);
+        messageIdFromSubscription(&(gFilterSubscription[x]), &messageId);
+        gReader[x].asyncHandle = uGnssMsgReceiveStart(gGnssHandle, &messageId,
+                                                      messageReceiveCallback,
+                                                      &(gReader[x]));
+        U_PORT_TEST_ASSERT(gReader[x].asyncHandle >= 0);
+    }
+
+    // Each reader wants exactly one message of an epoch and the
+    // filter should let through only those
+    numPassed = filterNumPassed();
+    U_TEST_PRINT_LINE("%d reader(s), %d of %d message(s) per epoch pass the filter.",
+                      numReaders, numPassed, numPerEpoch);
+    U_PORT_TEST_ASSERT(numPassed == numReaders);
+    for (size_t x = 0; x < numReaders; x++) {
+        numExpectedReceived[x] = numEpochs;
+    }
+    filterFeed(numEpochs, numExpectedReceived);
+    numDropped += (numPerEpoch - numPassed) * numEpochs;
+    U_PORT_TEST_ASSERT(numExpected(&(gSubscription[0]), &gGenerator) == numPerEpoch * numEpochs);
+    U_PORT_TEST_ASSERT(gGenerator.numBytesDropped == 0);
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStatReadLoss(gGnssHandle) == 0);
+    for (size_t x = 0; x < numReaders; x++) {
+        U_TEST_PRINT_LINE("  reader %d: %d message(s), expected %d.", x + 1,
+                          gReader[x].numReceived, numExpectedReceived[x]);
+        U_PORT_TEST_ASSERT(gReader[x].numReceived == numExpectedReceived[x]);
+        U_PORT_TEST_ASSERT(gReader[x].numBad == 0);
+    }
+
+    // Stop the NAV-PVT reader: the filter should be rebuilt so that
+    // NAV-PVT is dropped from now on and the reader gets no more
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gGnssHandle, gReader[0].asyncHandle) == 0);
+    gReader[0].asyncHandle = -1;
+    numPassed = filterNumPassed();
+    U_PORT_TEST_ASSERT(numPassed == numReaders - 1);
+    for (size_t x = 1; x < numReaders; x++) {
+        numExpectedReceived[x] += numEpochs;
+    }
+    filterFeed(numEpochs, numExpectedReceived);
+    numDropped += (numPerEpoch - numPassed) * numEpochs;
+    U_PORT_TEST_ASSERT(gGenerator.numBytesDropped == 0);
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStatReadLoss(gGnssHandle) == 0);
+    for (size_t x = 0; x < numReaders; x++) {
+        U_TEST_PRINT_LINE("  reader %d: %d message(s), expected %d.", x + 1,
+                          gReader[x].numReceived, numExpectedReceived[x]);
+        U_PORT_TEST_ASSERT(gReader[x].numReceived == numExpectedReceived[x]);
+        U_PORT_TEST_ASSERT(gReader[x].numBad == 0);
+    }
+    U_TEST_PRINT_LINE("%d message(s) generated, %d dropped by the filter.",
+                      numExpected(&(gSubscription[0]), &gGenerator), numDropped);
+    U_PORT_TEST_ASSERT(numDropped == ((numPerEpoch - numReaders) * numEpochs) +
+                       ((numPerEpoch - numReaders + 1) * numEpochs));
+
+    // Stop the NMEA reader: only RTCM 1077 should now get through
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gGnssHandle, gReader[2].asyncHandle) == 0);
+    gReader[2].asyncHandle = -1;
+    U_PORT_TEST_ASSERT(filterNumPassed() == 1);
+
+    // Stop the last reader: the message receive task, and its
+    // filter, should go
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gGnssHandle, gReader[1].asyncHandle) == 0);
+    gReader[1].asyncHandle = -1;
+    pInstance = pUGnssPrivateGetInstance(gGnssHandle);
+    U_PORT_TEST_ASSERT((pInstance != NULL) && (pInstance->pMsgReceive == NULL));
+    U_PORT_TEST_ASSERT(gCallbackErrorCode == 0);
+
+    uGnssRemove(gGnssHandle);
+    gGnssHandle = NULL;
+    uGnssTestGeneratorDeinit(&gGenerator);
+    free(gpMessageBuffer);
+    gpMessageBuffer = NULL;
+
+    uGnssDeinit();
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[gnssBenchmark]", "gnssBenchmarkCleanUp")
+{
+    int32_t x;
+
+    if (gGnssHandle != NULL) {
+        stopReaders();
+        uGnssRemove(gGnssHandle);
+        gGnssHandle = NULL;
+    }
+    uGnssTestGeneratorDeinit(&gGenerator);
+    free(gpMessageBuffer);
+    gpMessageBuffer = NULL;
+    uGnssDeinit();
+
+    x = uPortTaskStackMinFree(NULL);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("main task stack had a minimum of %d byte(s)"
+                          " free at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_OS_MAIN_TASK_MIN_FREE_STACK_BYTES);
+    }
+
+    uPortDeinit();
+
+    x = uPortGetHeapMinFree();
+    if (x >= 0) {
+        U_TEST_PRINT_LINE("heap had a minimum of %d byte(s) free"
+                          " at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_HEAP_MIN_FREE_BYTES);
+    }
+}
+
+#endif // #ifndef U_CFG_TEST_USING_NRF5SDK
+
+// End of file
@@ -535,6 +535,40 @@ U_PORT_TEST_FUNCTION("[gnssCfg]", "gnssCfgValBasic")
                 uPortTaskBlock(10);
             }
 
+            // Modify them all again and write them back using the
+            // batch function, which should give the same result
+            U_TEST_PRINT_LINE("modifying all the GEOFENCE values again.");
+            modValues(pCfgValList, numValues);
+            U_TEST_PRINT_LINE("writing GEOFENCE values as a batch.");
+            U_PORT_TEST_ASSERT(uGnssCfgValSetListBatch(gnssHandle, pCfgValList, numValues,
+                                                       U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+            U_TEST_PRINT_LINE("reading back the modified GEOFENCE values.");
+            for (int32_t x = 0; x < numValues; x++) {
+                value = 0;
+                U_PORT_TEST_ASSERT(uGnssCfgValGet(gnssHandle, gKeyIdGeofence[x],
+                                                  &value, storageSizeBytes(gKeyIdGeofence[x]),
+                                                  U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+                U_PORT_TEST_ASSERT(valueMatches(gKeyIdGeofence[x], value,  pCfgValList, numValues));
+                // Don't overload logging
+                uPortTaskBlock(10);
+            }
+
+            // Switch the configuration shadow on, fill it and check
+            // that the values it returns are the same
+            U_TEST_PRINT_LINE("reading GEOFENCE values through the shadow.");
+            U_PORT_TEST_ASSERT(uGnssCfgShadowFill(gnssHandle, gKeyIdGeofence, numValues) < 0);
+            U_PORT_TEST_ASSERT(uGnssCfgSetShadow(gnssHandle, true) == 0);
+            U_PORT_TEST_ASSERT(uGnssCfgShadowFill(gnssHandle, gKeyIdGeofence,
+                                                  numValues) == numValues);
+            for (int32_t x = 0; x < numValues; x++) {
+                value = 0;
+                U_PORT_TEST_ASSERT(uGnssCfgValGet(gnssHandle, gKeyIdGeofence[x],
+                                                  &value, storageSizeBytes(gKeyIdGeofence[x]),
+                                                  U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+                U_PORT_TEST_ASSERT(valueMatches(gKeyIdGeofence[x], value,  pCfgValList, numValues));
+            }
+            U_PORT_TEST_ASSERT(uGnssCfgSetShadow(gnssHandle, false) == 0);
+
             // Now modify one value, non-list style, using the helper macro
             value = 0xFFFFFFFF;
             U_TEST_PRINT_LINE("modifying one GEOFENCE value 0x%08x to 0x%08x.",
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the GNSS configuration key name look-up: these
+ * should pass on all platforms and do not require a GNSS module.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strcmp()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_gnss_cfg_val_key.h"
+#include "u_gnss_cfg_val_key_name.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_CFG_VAL_KEY_NAME_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A key name with the key ID and type it should map to.
+ */
+typedef struct {
+    const char *pName;
+    uint32_t keyId;
+    char type;
+} uGnssCfgValKeyNameTest_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Some keys, from the first and last groups and a few in between.
+ */
+static const uGnssCfgValKeyNameTest_t gKeyNameTest[] = {
+    {"CFG-ANA-USE_ANA", U_GNSS_CFG_VAL_KEY_ID_ANA_USE_ANA_L, 'L'},
+    {"CFG-HW-RF_LNA_MODE", U_GNSS_CFG_VAL_KEY_ID_HW_RF_LNA_MODE_E1, 'E'},
+    {"CFG-NAVSPG-FIXMODE", U_GNSS_CFG_VAL_KEY_ID_NAVSPG_FIXMODE_E1, 'E'},
+    {"CFG-RATE-MEAS", U_GNSS_CFG_VAL_KEY_ID_RATE_MEAS_U2, 'U'},
+    {"CFG-USB-SERIAL_NO_STR3", U_GNSS_CFG_VAL_KEY_ID_USB_SERIAL_NO_STR3_X8, 'X'},
+    {"CFG-USBOUTPROT-RTCM3X", U_GNSS_CFG_VAL_KEY_ID_USBOUTPROT_RTCM3X_L, 'L'}
+};
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test looking up key names and key IDs.
+ */
+U_PORT_TEST_FUNCTION("[gnssCfgValKeyName]", "gnssCfgValKeyNameBasic")
+{
+    const uGnssCfgValKeyNameTest_t *pTest;
+    const uGnssCfgValKeyName_t *pKeyName;
+
+    for (size_t x = 0; x < sizeof(gKeyNameTest) / sizeof(gKeyNameTest[0]); x++) {
+        pTest = &(gKeyNameTest[x]);
+        U_TEST_PRINT_LINE("looking up \"%s\".", pTest->pName);
+        pKeyName = pUGnssCfgValKeyNameFind(pTest->pName);
+        U_PORT_TEST_ASSERT(pKeyName != NULL);
+        U_PORT_TEST_ASSERT(strcmp(pKeyName->pName, pTest->pName) == 0);
+        U_PORT_TEST_ASSERT(pKeyName->keyId == pTest->keyId);
+        U_PORT_TEST_ASSERT(pKeyName->type == pTest->type);
+        U_PORT_TEST_ASSERT(pUGnssCfgValKeyNameFindId(pTest->keyId) == pKeyName);
+    }
+
+    U_TEST_PRINT_LINE("looking up things that are not there.");
+    U_PORT_TEST_ASSERT(pUGnssCfgValKeyNameFind(NULL) == NULL);
+    U_PORT_TEST_ASSERT(pUGnssCfgValKeyNameFind("") == NULL);
+    // Not the way it is written in the interface description
+    U_PORT_TEST_ASSERT(pUGnssCfgValKeyNameFind("cfg-navspg-fixmode") == NULL);
+    U_PORT_TEST_ASSERT(pUGnssCfgValKeyNameFind("CFG-NAVSPG-FIXMODE_E1") == NULL);
+    U_PORT_TEST_ASSERT(pUGnssCfgValKeyNameFindId(0) == NULL);
+    U_PORT_TEST_ASSERT(pUGnssCfgValKeyNameFindId(U_GNSS_CFG_VAL_KEY_ID_NAVSPG_FIXMODE_E1 + 0x100) == NULL);
+}
+
+// End of file
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the GNSS correction-data API: these should pass on
+ * all platforms that have a GNSS module connected to them.  They
+ * are only compiled if U_CFG_TEST_GNSS_MODULE_TYPE is defined.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_TEST_GNSS_MODULE_TYPE
+
+# ifdef U_CFG_OVERRIDE
+#  include "u_cfg_override.h" // For a customer's configuration override
+# endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"   // Required by u_gnss_private.h
+#include "u_port_uart.h"
+
+#include "u_sock.h"
+#include "u_mqtt_common.h"
+#include "u_mqtt_client.h"
+
+#include "u_spartn_test_data.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_correction.h"
+#include "u_gnss_private.h"
+
+#include "u_gnss_test_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_CORRECTION_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The number of bytes of junk to put between the test messages.
+ */
+#define U_GNSS_CORRECTION_TEST_JUNK_LENGTH_BYTES 5
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Handles.
+ */
+static uGnssTestPrivate_t gHandles = U_GNSS_TEST_PRIVATE_DEFAULTS;
+
+/** Junk that looks a bit like the start of a SPARTN or RTCM message.
+ */
+static const char gJunk[U_GNSS_CORRECTION_TEST_JUNK_LENGTH_BYTES] = {0x73, 0xd3, 0x00, 0x73, 0x00};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Pass SPARTN data through a correction pipeline to the GNSS chip
+ * in awkward chunk sizes.
+ */
+U_PORT_TEST_FUNCTION("[gnssCorrection]", "gnssCorrectionInput")
+{
+    uDeviceHandle_t gnssHandle;
+    uGnssCorrectionHandle_t correctionHandle = NULL;
+    uGnssCorrectionStats_t stats;
+    int32_t heapUsed;
+    size_t chunkSize;
+    size_t thisSize;
+    size_t iterations;
+    uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
+
+    // In case a previous test failed
+    uGnssTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    iterations = uGnssTestPrivateTransportTypesSet(transportTypes, U_CFG_APP_GNSS_UART,
+                                                   U_CFG_APP_GNSS_I2C);
+    for (size_t w = 0; w < iterations; w++) {
+        // Only streaming transports are supported
+        if (transportTypes[w] != U_GNSS_TRANSPORT_AT) {
+            // Do the standard preamble
+            U_TEST_PRINT_LINE("testing on transport %s...",
+                              pGnssTestPrivateTransportTypeName(transportTypes[w]));
+            U_PORT_TEST_ASSERT(uGnssTestPrivatePreamble(U_CFG_TEST_GNSS_MODULE_TYPE,
+                                                        transportTypes[w], &gHandles, true,
+                                                        U_CFG_APP_CELL_PIN_GNSS_POWER,
+                                                        U_CFG_APP_CELL_PIN_GNSS_DATA_READY) == 0);
+            gnssHandle = gHandles.gnssHandle;
+
+            // Check that bad parameters are rejected
+            U_PORT_TEST_ASSERT(uGnssCorrectionOpen(NULL, U_GNSS_CORRECTION_PROTOCOL_SPARTN,
+                                                   0, &correctionHandle) < 0);
+            U_PORT_TEST_ASSERT(uGnssCorrectionOpen(gnssHandle, 0, 0, &correctionHandle) < 0);
+            U_PORT_TEST_ASSERT(uGnssCorrectionOpen(gnssHandle, U_GNSS_CORRECTION_PROTOCOL_SPARTN,
+                                                   0, NULL) < 0);
+
+            // Send the SPARTN test data, with some junk in front of it,
+            // in chunk sizes that split messages in all sorts of places;
+            // the GNSS chip will ignore the messages unless it is a
+            // high-precision one but that doesn't matter
+            for (chunkSize = 1; chunkSize < gUSpartnTestDataSize; chunkSize = (chunkSize * 7) + 3) {
+                U_TEST_PRINT_LINE("sending %d byte(s) of SPARTN data in chunks of %d byte(s).",
+                                  gUSpartnTestDataSize, chunkSize);
+                U_PORT_TEST_ASSERT(uGnssCorrectionOpen(gnssHandle, U_GNSS_CORRECTION_PROTOCOL_ALL,
+                                                       0, &correctionHandle) == 0);
+                U_PORT_TEST_ASSERT(uGnssCorrectionInput(correctionHandle, gJunk,
+                                                        sizeof(gJunk)) == 0);
+                for (size_t x = 0; x < gUSpartnTestDataSize; x += thisSize) {
+                    thisSize = gUSpartnTestDataSize - x;
+                    if (thisSize > chunkSize) {
+                        thisSize = chunkSize;
+                    }
+                    U_PORT_TEST_ASSERT(uGnssCorrectionInput(correctionHandle,
+                                                            gUSpartnTestData + x,
+                                                            thisSize) >= 0);
+                }
+                U_PORT_TEST_ASSERT(uGnssCorrectionGetStats(correctionHandle, &stats) == 0);
+                U_TEST_PRINT_LINE("%d SPARTN message(s), %d byte(s) forwarded, %d"
+                                  " byte(s) discarded, longest send %d ms, buffer"
+                                  " high water mark %d byte(s).",
+                                  stats.messagesSpartn, stats.bytesForwarded,
+                                  stats.bytesDiscarded, stats.sendTimeMaxMs,
+                                  stats.bufferHighWaterMark);
+                U_PORT_TEST_ASSERT(stats.bytesReceived == gUSpartnTestDataSize + sizeof(gJunk));
+                U_PORT_TEST_ASSERT(stats.messagesSpartn == gUSpartnTestDataNumMessages);
+                U_PORT_TEST_ASSERT(stats.messagesRtcm == 0);
+                U_PORT_TEST_ASSERT(stats.sendFailures == 0);
+                U_PORT_TEST_ASSERT(stats.bytesForwarded == gUSpartnTestDataSize);
+                U_PORT_TEST_ASSERT(stats.bytesDiscarded == sizeof(gJunk));
+                U_PORT_TEST_ASSERT(stats.bufferedBytes == 0);
+                uGnssCorrectionClose(correctionHandle);
+                correctionHandle = NULL;
+            }
+
+            // Do the standard postamble
+            uGnssTestPrivatePostamble(&gHandles, false);
+        }
+    }
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[gnssCorrection]", "gnssCorrectionCleanUp")
+{
+    int32_t x;
+
+    uGnssTestPrivateCleanup(&gHandles);
+
+    x = uPortTaskStackMinFree(NULL);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("main task stack had a minimum of %d byte(s)"
+                          " free at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_OS_MAIN_TASK_MIN_FREE_STACK_BYTES);
+    }
+
+    uPortDeinit();
+
+    x = uPortGetHeapMinFree();
+    if (x >= 0) {
+        U_TEST_PRINT_LINE("heap had a minimum of %d byte(s) free"
+                          " at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_HEAP_MIN_FREE_BYTES);
+    }
+}
+
+#endif // #ifdef U_CFG_TEST_GNSS_MODULE_TYPE
+
+// End of file
@@ -59,6 +59,7 @@
 #include "u_gnss_info.h"
 #include "u_gnss_cfg.h" // uGnssCfgSetUtcStandard()
 #include "u_gnss_msg.h" // uGnssMsgReceiveStatStreamLoss()
+#include "u_gnss_time_sync.h"
 #include "u_gnss_private.h"
 
 #include "u_gnss_test_private.h"
@@ -93,6 +94,19 @@
 #define U_GNSS_TIME_TEST_TIMEOUT_SECONDS 180
 #endif
 
+#ifndef U_CFG_TEST_PIN_GNSS_TIMEPULSE
+/** The pin of this MCU that the TIMEPULSE output of the GNSS chip
+ * is connected to for the time synchronisation test; -1 if it is
+ * not connected, in which case the test is not run.
+ */
+# define U_CFG_TEST_PIN_GNSS_TIMEPULSE -1
+#endif
+
+/** The number of time pulses to wait for in the time
+ * synchronisation test.
+ */
+#define U_GNSS_TIME_SYNC_TEST_NUM_PULSES 5
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -314,6 +328,125 @@ U_PORT_TEST_FUNCTION("[gnssInfo]", "gnssInfoTime")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+#if (U_CFG_TEST_PIN_GNSS_TIMEPULSE >= 0)
+/** Align the host tick with GNSS time using the TIMEPULSE output of
+ * the GNSS chip, which must be wired to U_CFG_TEST_PIN_GNSS_TIMEPULSE.
+ */
+U_PORT_TEST_FUNCTION("[gnssInfo]", "gnssInfoTimeSync")
+{
+    uDeviceHandle_t gnssHandle;
+    const uGnssPrivateModule_t *pModule;
+    uGnssTimeSyncModel_t model;
+    int64_t tickUs;
+    int64_t timeUs;
+    int64_t timeUtc;
+    int32_t y;
+    int32_t startTimeMs;
+    int32_t heapUsed;
+    size_t iterations;
+    uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
+
+    // In case a previous test failed
+    uGnssTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Repeat for all transport types
+    iterations = uGnssTestPrivateTransportTypesSet(transportTypes, U_CFG_APP_GNSS_UART,
+                                                   U_CFG_APP_GNSS_I2C);
+    for (size_t w = 0; w < iterations; w++) {
+        // Do the standard preamble
+        U_TEST_PRINT_LINE("testing time sync on transport %s...",
+                          pGnssTestPrivateTransportTypeName(transportTypes[w]));
+        U_PORT_TEST_ASSERT(uGnssTestPrivatePreamble(U_CFG_TEST_GNSS_MODULE_TYPE,
+                                                    transportTypes[w], &gHandles, true,
+                                                    U_CFG_APP_CELL_PIN_GNSS_POWER,
+                                                    U_CFG_APP_CELL_PIN_GNSS_DATA_READY) == 0);
+        gnssHandle = gHandles.gnssHandle;
+        pModule = pUGnssPrivateGetModule(gnssHandle);
+        U_PORT_TEST_ASSERT(pModule != NULL);
+
+        // Check that bad parameters are rejected and that there
+        // is no model before we start
+        U_PORT_TEST_ASSERT(uGnssTimeSyncStart(gnssHandle, -1, NULL) < 0);
+        U_PORT_TEST_ASSERT(uGnssTimeSyncGetModel(gnssHandle, NULL) < 0);
+        U_PORT_TEST_ASSERT(uGnssTimeSyncGetModel(gnssHandle, &model) ==
+                           (int32_t) U_ERROR_COMMON_NOT_FOUND);
+        U_PORT_TEST_ASSERT(uGnssTimeSyncGetTimeUs(gnssHandle, 0) ==
+                           (int32_t) U_ERROR_COMMON_NOT_FOUND);
+
+        y = uGnssTimeSyncStart(gnssHandle, U_CFG_TEST_PIN_GNSS_TIMEPULSE, NULL);
+        U_TEST_PRINT_LINE("uGnssTimeSyncStart() returned %d.", y);
+        if (!U_GNSS_PRIVATE_HAS(pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX) ||
+            (transportTypes[w] == U_GNSS_TRANSPORT_AT)) {
+            U_PORT_TEST_ASSERT(y == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+        } else {
+            U_PORT_TEST_ASSERT(y == 0);
+            // Can't start twice
+            U_PORT_TEST_ASSERT(uGnssTimeSyncStart(gnssHandle,
+                                                  U_CFG_TEST_PIN_GNSS_TIMEPULSE,
+                                                  NULL) < 0);
+            // Wait for enough time pulses to be aligned; there
+            // will be none until the GNSS chip has found time
+            U_TEST_PRINT_LINE("waiting up to %d second(s) for %d time pulse(s)...",
+                              U_GNSS_TIME_TEST_TIMEOUT_SECONDS,
+                              U_GNSS_TIME_SYNC_TEST_NUM_PULSES);
+            memset(&model, 0, sizeof(model));
+            startTimeMs = uPortGetTickTimeMs();
+            while ((model.numPulses < U_GNSS_TIME_SYNC_TEST_NUM_PULSES) &&
+                   (uPortGetTickTimeMs() - startTimeMs < (U_GNSS_TIME_TEST_TIMEOUT_SECONDS * 1000))) {
+                uPortTaskBlock(1000);
+                uGnssTimeSyncGetModel(gnssHandle, &model);
+            }
+            U_TEST_PRINT_LINE("%d time pulse(s), time %d second(s) (%s),"
+                              " drift %d ppb.", (int32_t) model.numPulses,
+                              (int32_t) (model.timeUs / 1000000),
+                              model.isUtc ? "UTC" : "GNSS", model.driftPpb);
+            U_PORT_TEST_ASSERT(model.numPulses >= U_GNSS_TIME_SYNC_TEST_NUM_PULSES);
+            U_PORT_TEST_ASSERT(model.timeUs / 1000000 > U_GNSS_TEST_MIN_UTC_TIME);
+            // The default host tick is uPortGetTickTimeMs(), which
+            // should be well within the believable drift
+            U_PORT_TEST_ASSERT(model.driftPpb <= U_GNSS_TIME_SYNC_MAX_DRIFT_PPM * 1000);
+            U_PORT_TEST_ASSERT(model.driftPpb >= -U_GNSS_TIME_SYNC_MAX_DRIFT_PPM * 1000);
+            U_PORT_TEST_ASSERT(uGnssTimeSyncGetTimeUs(gnssHandle, model.tickUs) == model.timeUs);
+
+            if (model.isUtc) {
+                // Converting the tick now should agree with the
+                // UTC time the GNSS chip reports, within the
+                // latency of asking for it
+                tickUs = ((int64_t) uPortGetTickTimeMs()) * 1000;
+                timeUtc = uGnssInfoGetTimeUtc(gnssHandle);
+                timeUs = uGnssTimeSyncGetTimeUs(gnssHandle, tickUs);
+                U_TEST_PRINT_LINE("host tick now converts to %d second(s),"
+                                  " GNSS reports %d.", (int32_t) (timeUs / 1000000),
+                                  (int32_t) timeUtc);
+                U_PORT_TEST_ASSERT(timeUtc > U_GNSS_TEST_MIN_UTC_TIME);
+                U_PORT_TEST_ASSERT(timeUs / 1000000 >= timeUtc - 2);
+                U_PORT_TEST_ASSERT(timeUs / 1000000 <= timeUtc + 2);
+            }
+
+            uGnssTimeSyncStop(gnssHandle);
+            U_PORT_TEST_ASSERT(uGnssTimeSyncGetModel(gnssHandle, &model) ==
+                               (int32_t) U_ERROR_COMMON_NOT_FOUND);
+        }
+        // Stopping when not started is fine
+        uGnssTimeSyncStop(gnssHandle);
+
+        // Do the standard postamble, leaving the module on for the next
+        // test to speed things up
+        uGnssTestPrivatePostamble(&gHandles, false);
+    }
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+#endif
+
 #endif // #ifdef U_CFG_TEST_GNSS_MODULE_TYPE
 
 // End of file
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the GNSS log API: these should pass on
+ * all platforms that have a GNSS module connected to them.  They
+ * are only compiled if U_CFG_TEST_GNSS_MODULE_TYPE is defined.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_TEST_GNSS_MODULE_TYPE
+
+# ifdef U_CFG_OVERRIDE
+#  include "u_cfg_override.h" // For a customer's configuration override
+# endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"   // Required by u_gnss_private.h
+#include "u_port_uart.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_cfg.h"
+#include "u_gnss_log.h"
+#include "u_gnss_private.h"
+
+#include "u_gnss_test_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_LOG_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_GNSS_LOG_TEST_DURATION_MS
+/** How long to log for in each test.
+ */
+# define U_GNSS_LOG_TEST_DURATION_MS 5000
+#endif
+
+#ifndef U_GNSS_LOG_TEST_BLOCK_LENGTH_BYTES
+/** The block length to use: small, so that the writer is
+ * called often.
+ */
+# define U_GNSS_LOG_TEST_BLOCK_LENGTH_BYTES 512
+#endif
+
+/** The number of bytes at the start of the log that the test
+ * writer keeps a copy of.
+ */
+#define U_GNSS_LOG_TEST_CAPTURE_LENGTH_BYTES 128
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The context of the test writer.
+ */
+typedef struct {
+    size_t size;
+    size_t calls;
+    char capture[U_GNSS_LOG_TEST_CAPTURE_LENGTH_BYTES];
+    char lastTwo[2];
+} uGnssLogTestWriter_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Handles.
+ */
+static uGnssTestPrivate_t gHandles = U_GNSS_TEST_PRIVATE_DEFAULTS;
+
+/** The context of the test writer.
+ */
+static uGnssLogTestWriter_t gWriter;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// A writer that keeps a copy of the start of the log, the last
+// two bytes of it and a count of the bytes.
+static int32_t writer(const char *pData, size_t size, void *pWriterParam)
+{
+    uGnssLogTestWriter_t *pWriter = (uGnssLogTestWriter_t *) pWriterParam;
+    size_t x;
+
+    if (pWriter->size < sizeof(pWriter->capture)) {
+        x = sizeof(pWriter->capture) - pWriter->size;
+        if (x > size) {
+            x = size;
+        }
+        memcpy(pWriter->capture + pWriter->size, pData, x);
+    }
+    if (size >= 2) {
+        memcpy(pWriter->lastTwo, pData + size - 2, 2);
+    } else if (size == 1) {
+        pWriter->lastTwo[0] = pWriter->lastTwo[1];
+        pWriter->lastTwo[1] = *pData;
+    }
+    pWriter->size += size;
+    pWriter->calls++;
+
+    return (int32_t) size;
+}
+
+// Print the statistics of a log.
+static void printStats(const uGnssLogStats_t *pStats)
+{
+    U_TEST_PRINT_LINE("%d message(s) (%d byte(s)) logged, %d message(s)"
+                      " dropped (%d byte(s)).", pStats->messagesLogged,
+                      pStats->bytesLogged, pStats->messagesDropped,
+                      pStats->bytesDropped);
+    U_TEST_PRINT_LINE("%d byte(s) written in %d block(s), %d byte(s) buffered,"
+                      " %d write failure(s), longest write %d ms.",
+                      pStats->bytesWritten, pStats->blocksWritten,
+                      pStats->bytesBuffered, pStats->writeFailures,
+                      pStats->writeTimeMaxMs);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Log the stream, filtered and unfiltered.
+ */
+U_PORT_TEST_FUNCTION("[gnssLog]", "gnssLogBasic")
+{
+    uDeviceHandle_t gnssHandle;
+    uGnssLogStats_t stats;
+    uGnssMessageId_t messageId;
+    int32_t heapUsed;
+    size_t iterations;
+    uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
+
+    // In case a previous test failed
+    uGnssTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    iterations = uGnssTestPrivateTransportTypesSet(transportTypes, U_CFG_APP_GNSS_UART,
+                                                   U_CFG_APP_GNSS_I2C);
+    for (size_t w = 0; w < iterations; w++) {
+        // Only streaming transports are supported
+        if (transportTypes[w] != U_GNSS_TRANSPORT_AT) {
+            // Do the standard preamble
+            U_TEST_PRINT_LINE("testing on transport %s...",
+                              pGnssTestPrivateTransportTypeName(transportTypes[w]));
+            U_PORT_TEST_ASSERT(uGnssTestPrivatePreamble(U_CFG_TEST_GNSS_MODULE_TYPE,
+                                                        transportTypes[w], &gHandles, true,
+                                                        U_CFG_APP_CELL_PIN_GNSS_POWER,
+                                                        U_CFG_APP_CELL_PIN_GNSS_DATA_READY) == 0);
+            gnssHandle = gHandles.gnssHandle;
+
+            // Make sure there is some NMEA to log
+            U_PORT_TEST_ASSERT(uGnssCfgSetProtocolOut(gnssHandle, U_GNSS_PROTOCOL_NMEA, true) == 0);
+
+            // Check that bad parameters are rejected
+            messageId.type = U_GNSS_PROTOCOL_NMEA;
+            messageId.id.pNmea = NULL;
+            U_PORT_TEST_ASSERT(uGnssLogStart(gnssHandle, &messageId, 1, 0, NULL, NULL) < 0);
+            U_PORT_TEST_ASSERT(uGnssLogGetStats(gnssHandle, NULL) < 0);
+            // Nothing to get or stop
+            U_PORT_TEST_ASSERT(uGnssLogGetStats(gnssHandle, &stats) < 0);
+            U_PORT_TEST_ASSERT(uGnssLogStop(gnssHandle, NULL) < 0);
+
+            // Log all NMEA messages: the log must then start with
+            // the start of an NMEA message and end with the end of one
+            U_TEST_PRINT_LINE("logging NMEA messages for %d second(s).",
+                              U_GNSS_LOG_TEST_DURATION_MS / 1000);
+            memset(&gWriter, 0, sizeof(gWriter));
+            U_PORT_TEST_ASSERT(uGnssLogStart(gnssHandle, &messageId, 1,
+                                             U_GNSS_LOG_TEST_BLOCK_LENGTH_BYTES,
+                                             writer, &gWriter) == 0);
+            // Only one log at a time
+            U_PORT_TEST_ASSERT(uGnssLogStart(gnssHandle, NULL, 0, 0,
+                                             writer, &gWriter) < 0);
+            uPortTaskBlock(U_GNSS_LOG_TEST_DURATION_MS);
+            U_PORT_TEST_ASSERT(uGnssLogGetStats(gnssHandle, &stats) == 0);
+            U_PORT_TEST_ASSERT(stats.messagesLogged > 0);
+            U_PORT_TEST_ASSERT(uGnssLogStop(gnssHandle, &stats) == 0);
+            printStats(&stats);
+            U_PORT_TEST_ASSERT(stats.messagesLogged > 0);
+            U_PORT_TEST_ASSERT(stats.writeFailures == 0);
+            U_PORT_TEST_ASSERT(stats.bytesBuffered == 0);
+            U_PORT_TEST_ASSERT(stats.bytesWritten == stats.bytesLogged);
+            U_PORT_TEST_ASSERT(stats.bytesWritten == gWriter.size);
+            U_PORT_TEST_ASSERT(stats.blocksWritten == gWriter.calls);
+            U_PORT_TEST_ASSERT(gWriter.capture[0] == '$');
+            U_PORT_TEST_ASSERT((gWriter.lastTwo[0] == '\r') && (gWriter.lastTwo[1] == '\n'));
+            // Nothing left to stop
+            U_PORT_TEST_ASSERT(uGnssLogStop(gnssHandle, NULL) < 0);
+
+            // Log everything, with the default block length
+            U_TEST_PRINT_LINE("logging everything for %d second(s).",
+                              U_GNSS_LOG_TEST_DURATION_MS / 1000);
+            memset(&gWriter, 0, sizeof(gWriter));
+            U_PORT_TEST_ASSERT(uGnssLogStart(gnssHandle, NULL, 0, 0,
+                                             writer, &gWriter) == 0);
+            uPortTaskBlock(U_GNSS_LOG_TEST_DURATION_MS);
+            U_PORT_TEST_ASSERT(uGnssLogStop(gnssHandle, &stats) == 0);
+            printStats(&stats);
+            U_PORT_TEST_ASSERT(stats.bytesLogged > 0);
+            U_PORT_TEST_ASSERT(stats.writeFailures == 0);
+            U_PORT_TEST_ASSERT(stats.bytesBuffered == 0);
+            U_PORT_TEST_ASSERT(stats.bytesWritten == stats.bytesLogged);
+            U_PORT_TEST_ASSERT(stats.bytesWritten == gWriter.size);
+
+            // Do the standard postamble
+            uGnssTestPrivatePostamble(&gHandles, false);
+        }
+    }
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[gnssLog]", "gnssLogCleanUp")
+{
+    int32_t x;
+
+    uGnssTestPrivateCleanup(&gHandles);
+
+    x = uPortTaskStackMinFree(NULL);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("main task stack had a minimum of %d byte(s)"
+                          " free at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_OS_MAIN_TASK_MIN_FREE_STACK_BYTES);
+    }
+
+    uPortDeinit();
+
+    x = uPortGetHeapMinFree();
+    if (x >= 0) {
+        U_TEST_PRINT_LINE("heap had a minimum of %d byte(s) free"
+                          " at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_HEAP_MIN_FREE_BYTES);
+    }
+}
+
+#endif // #ifdef U_CFG_TEST_GNSS_MODULE_TYPE
+
+// End of file
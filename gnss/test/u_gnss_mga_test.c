@@ -0,0 +1,254 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the GNSS MGA API: these should pass on
+ * all platforms that have a GNSS module connected to them.  They
+ * are only compiled if U_CFG_TEST_GNSS_MODULE_TYPE is defined.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_TEST_GNSS_MODULE_TYPE
+
+# ifdef U_CFG_OVERRIDE
+#  include "u_cfg_override.h" // For a customer's configuration override
+# endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"   // Required by u_gnss_private.h
+#include "u_port_uart.h"
+
+#include "u_ubx_protocol.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_mga.h"
+#include "u_gnss_private.h"
+
+#include "u_gnss_test_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_MGA_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The number of UBX-MGA-INI-POS_LLH messages to upload.
+ */
+#define U_GNSS_MGA_TEST_NUM_MESSAGES 20
+
+/** The length of the body of a UBX-MGA-INI-POS_LLH message.
+ */
+#define U_GNSS_MGA_TEST_BODY_LENGTH_BYTES 20
+
+/** The number of bytes of junk to put between the test messages.
+ */
+#define U_GNSS_MGA_TEST_JUNK_LENGTH_BYTES 3
+
+/** The length of one test message plus its junk.
+ */
+#define U_GNSS_MGA_TEST_ITEM_LENGTH_BYTES (U_GNSS_MGA_TEST_BODY_LENGTH_BYTES + \
+                                           U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES + \
+                                           U_GNSS_MGA_TEST_JUNK_LENGTH_BYTES)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Handles.
+ */
+static uGnssTestPrivate_t gHandles = U_GNSS_TEST_PRIVATE_DEFAULTS;
+
+/** The data to upload.
+ */
+static char gData[U_GNSS_MGA_TEST_ITEM_LENGTH_BYTES * U_GNSS_MGA_TEST_NUM_MESSAGES];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Fill gData with UBX-MGA-INI-POS_LLH messages, each followed by
+// some junk; the position is 0, 0 with an accuracy of 1000 km, which
+// won't be news to the GNSS chip, the latitude being varied a little
+// so that all of the messages are different.
+static void dataFill()
+{
+    char body[U_GNSS_MGA_TEST_BODY_LENGTH_BYTES];
+    char *pData = gData;
+
+    for (size_t x = 0; x < U_GNSS_MGA_TEST_NUM_MESSAGES; x++) {
+        memset(body, 0, sizeof(body));
+        body[0] = 0x01; // type: POS_LLH
+        *((uint32_t *) (body + 4)) = uUbxProtocolUint32Encode((uint32_t) x);
+        *((uint32_t *) (body + 16)) = uUbxProtocolUint32Encode(100000000);
+        pData += uUbxProtocolEncode(0x13, 0x40, body, sizeof(body), pData);
+        memset(pData, 0xb5, U_GNSS_MGA_TEST_JUNK_LENGTH_BYTES);
+        pData += U_GNSS_MGA_TEST_JUNK_LENGTH_BYTES;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Upload MGA messages with various window sizes.
+ */
+U_PORT_TEST_FUNCTION("[gnssMga]", "gnssMgaUpload")
+{
+    uDeviceHandle_t gnssHandle;
+    uGnssMgaUploadCfg_t cfg;
+    uGnssMgaUploadStats_t stats;
+    int32_t heapUsed;
+    int32_t x;
+    size_t iterations;
+    uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
+    const size_t windowSize[] = {1, 4, U_GNSS_MGA_UPLOAD_WINDOW_SIZE_MAX};
+
+    // In case a previous test failed
+    uGnssTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    dataFill();
+
+    iterations = uGnssTestPrivateTransportTypesSet(transportTypes, U_CFG_APP_GNSS_UART,
+                                                   U_CFG_APP_GNSS_I2C);
+    for (size_t w = 0; w < iterations; w++) {
+        // Only streaming transports are supported
+        if (transportTypes[w] != U_GNSS_TRANSPORT_AT) {
+            // Do the standard preamble
+            U_TEST_PRINT_LINE("testing on transport %s...",
+                              pGnssTestPrivateTransportTypeName(transportTypes[w]));
+            U_PORT_TEST_ASSERT(uGnssTestPrivatePreamble(U_CFG_TEST_GNSS_MODULE_TYPE,
+                                                        transportTypes[w], &gHandles, true,
+                                                        U_CFG_APP_CELL_PIN_GNSS_POWER,
+                                                        U_CFG_APP_CELL_PIN_GNSS_DATA_READY) == 0);
+            gnssHandle = gHandles.gnssHandle;
+
+            // Check that bad parameters are rejected
+            memset(&cfg, 0, sizeof(cfg));
+            U_PORT_TEST_ASSERT(uGnssMgaUpload(gnssHandle, NULL, sizeof(gData), NULL, NULL) < 0);
+            cfg.windowSize = U_GNSS_MGA_UPLOAD_WINDOW_SIZE_MAX + 1;
+            U_PORT_TEST_ASSERT(uGnssMgaUpload(gnssHandle, gData, sizeof(gData), &cfg, NULL) < 0);
+            cfg.windowSize = 0;
+            cfg.messageIntervalMs = -1;
+            U_PORT_TEST_ASSERT(uGnssMgaUpload(gnssHandle, gData, sizeof(gData), &cfg, NULL) < 0);
+
+            for (size_t y = 0; y < sizeof(windowSize) / sizeof(windowSize[0]); y++) {
+                memset(&cfg, 0, sizeof(cfg));
+                cfg.windowSize = windowSize[y];
+                // Rate-limit the last one
+                if (y == (sizeof(windowSize) / sizeof(windowSize[0])) - 1) {
+                    cfg.messageIntervalMs = 10;
+                }
+                U_TEST_PRINT_LINE("uploading %d UBX-MGA message(s), window size %d,"
+                                  " interval %d ms.", U_GNSS_MGA_TEST_NUM_MESSAGES,
+                                  cfg.windowSize, cfg.messageIntervalMs);
+                x = uGnssMgaUpload(gnssHandle, gData, sizeof(gData), &cfg, &stats);
+                U_TEST_PRINT_LINE("%d accepted, %d sent, %d ACKed, %d NACKed, %d timed out,"
+                                  " %d byte(s) sent, %d skipped, took %d ms.", x,
+                                  stats.messagesSent, stats.messagesAcked,
+                                  stats.messagesNacked, stats.messagesTimedOut,
+                                  stats.bytesSent, stats.bytesSkipped, stats.durationMs);
+                U_PORT_TEST_ASSERT(x == (int32_t) stats.messagesAcked);
+                U_PORT_TEST_ASSERT(stats.messagesSent == U_GNSS_MGA_TEST_NUM_MESSAGES);
+                U_PORT_TEST_ASSERT(stats.messagesAcked + stats.messagesNacked == U_GNSS_MGA_TEST_NUM_MESSAGES);
+                U_PORT_TEST_ASSERT(stats.messagesTimedOut == 0);
+                U_PORT_TEST_ASSERT(stats.bytesSent + stats.bytesSkipped == sizeof(gData));
+                U_PORT_TEST_ASSERT(stats.bytesSkipped == U_GNSS_MGA_TEST_JUNK_LENGTH_BYTES *
+                                   U_GNSS_MGA_TEST_NUM_MESSAGES);
+            }
+
+            // Do the standard postamble
+            uGnssTestPrivatePostamble(&gHandles, false);
+        }
+    }
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[gnssMga]", "gnssMgaCleanUp")
+{
+    int32_t x;
+
+    uGnssTestPrivateCleanup(&gHandles);
+
+    x = uPortTaskStackMinFree(NULL);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("main task stack had a minimum of %d byte(s)"
+                          " free at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_OS_MAIN_TASK_MIN_FREE_STACK_BYTES);
+    }
+
+    uPortDeinit();
+
+    x = uPortGetHeapMinFree();
+    if (x >= 0) {
+        U_TEST_PRINT_LINE("heap had a minimum of %d byte(s) free"
+                          " at the end of these tests.", x);
+        U_PORT_TEST_ASSERT(x >= U_CFG_TEST_HEAP_MIN_FREE_BYTES);
+    }
+}
+
+#endif // #ifdef U_CFG_TEST_GNSS_MODULE_TYPE
+
+// End of file
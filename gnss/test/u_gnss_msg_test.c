@@ -147,6 +147,7 @@ typedef struct {
     size_t numRead;
     size_t numDecoded;
     size_t numOutsize;
+    size_t numArrivalTimeKnown;
     bool stopped;
     size_t numWhenStopped;
     size_t numNotWanted;
@@ -258,6 +259,7 @@ static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
 {
     uGnssMsgTestReceive_t *pMsgReceive = (uGnssMsgTestReceive_t *) pCallbackParam;
     int32_t nmeaComprehenderErrorCode;
+    int32_t arrivalTimeMs;
 
     if (gnssHandle != gHandles.gnssHandle) {
         gCallbackErrorCode = 1;
@@ -280,6 +282,13 @@ static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
         if ((pMessageId != NULL) && (pMessageId->type != pMsgReceive->messageId.type)) {
             pMsgReceive->numNotWanted++;
         }
+        if (uGnssMsgReceiveCallbackGetArrivalTime(gnssHandle, &arrivalTimeMs) == 0) {
+            pMsgReceive->numArrivalTimeKnown++;
+            // The message can't have arrived in the future
+            if (uPortGetTickTimeMs() - arrivalTimeMs < 0) {
+                gCallbackErrorCode = 6;
+            }
+        }
         if ((errorCodeOrLength > 0) &&
             (errorCodeOrLength <= U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_BUFFER_SIZE_BYTES)) {
             if (uGnssMsgReceiveCallbackRead(gnssHandle,
@@ -352,6 +361,8 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveBlocking")
     uGnssMessageId_t messageId;
     size_t iterations;
     uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
+    int32_t startTimeMs;
+    int32_t arrivalTimeMs;
 
     // In case a previous test failed
     uGnssTestPrivateCleanup(&gHandles);
@@ -402,6 +413,7 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveBlocking")
             // Since we're going to use wild-card receive, need to flush the
             // buffer first to only pick up the message that is a response
             uGnssMsgReceiveFlush(gnssHandle, false);
+            startTimeMs = uPortGetTickTimeMs();
             x = uGnssMsgSend(gnssHandle, command, sizeof(command));
             U_TEST_PRINT_LINE("%d byte(s) sent.", x);
             U_PORT_TEST_ASSERT(x == sizeof(command));
@@ -420,6 +432,13 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveBlocking")
             checkMessageReceive(&messageId, pBuffer3, x, messageId.id.ubx,
                                 y + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES, pBuffer1);
             U_PORT_TEST_ASSERT(gCallbackErrorCode == 0);
+            // The response must have arrived after the request was sent
+            U_PORT_TEST_ASSERT(uGnssMsgReceiveGetArrivalTime(gnssHandle, &arrivalTimeMs) == 0);
+            U_TEST_PRINT_LINE("response arrived %d ms after the request was sent,"
+                              " was returned %d ms later.", arrivalTimeMs - startTimeMs,
+                              uPortGetTickTimeMs() - arrivalTimeMs);
+            U_PORT_TEST_ASSERT(arrivalTimeMs - startTimeMs >= 0);
+            U_PORT_TEST_ASSERT(uPortGetTickTimeMs() - arrivalTimeMs >= 0);
 
             U_TEST_PRINT_LINE("getting the version string using transparent API,"
                               " blocking call...");
@@ -682,6 +701,9 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                     if (pTmp->numNotWanted > 0) {
                         bad = true;
                     }
+                    if ((pTmp->numReceived > 0) && (pTmp->numArrivalTimeKnown == 0)) {
+                        bad = true;
+                    }
                     if (pTmp->numWhenStopped > 0) {
                         bad = true;
                     }
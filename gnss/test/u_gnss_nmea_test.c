@@ -0,0 +1,200 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the GNSS NMEA decoders: these should pass on all
+ * platforms and do not require a GNSS module.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strlen()/memcpy()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_nmea.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_NMEA_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** A GGA sentence, with CR/LF as it would arrive from the module.
+ */
+static const char gGga[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+
+/** An RMC sentence, with CR/LF as it would arrive from the module.
+ */
+static const char gRmc[] = "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n";
+
+/** A GSA sentence, with no CR/LF.
+ */
+static const char gGsa[] = "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A";
+
+/** The last of a set of GSV sentences, with only three satellites
+ * and some empty fields.
+ */
+static const char gGsv[] = "$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76";
+
+/** A VTG sentence with an empty magnetic course.
+ */
+static const char gVtg[] = "$GPVTG,77.52,T,,M,0.004,N,0.008,K,A*06";
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test the NMEA decoders.
+ */
+U_PORT_TEST_FUNCTION("[gnssNmea]", "gnssNmeaDecode")
+{
+    int32_t heapUsed;
+    uGnssNmeaGga_t gga;
+    uGnssNmeaRmc_t rmc;
+    uGnssNmeaGsa_t gsa;
+    uGnssNmeaGsv_t gsv;
+    uGnssNmeaVtg_t vtg;
+    char buffer[sizeof(gGga)];
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_TEST_PRINT_LINE("decoding GGA...");
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeGga(gGga, strlen(gGga), &gga) == 0);
+    U_PORT_TEST_ASSERT(gga.timeOfDayMs == 34070000);
+    U_PORT_TEST_ASSERT(gga.latitudeX1e7 == 533613366);
+    U_PORT_TEST_ASSERT(gga.longitudeX1e7 == -65056200);
+    U_PORT_TEST_ASSERT(gga.quality == 1);
+    U_PORT_TEST_ASSERT(gga.numSvs == 8);
+    U_PORT_TEST_ASSERT(gga.hdopX100 == 103);
+    U_PORT_TEST_ASSERT(gga.altitudeMillimetres == 61700);
+    U_PORT_TEST_ASSERT(gga.geoidSeparationMillimetres == 55200);
+
+    U_TEST_PRINT_LINE("decoding RMC...");
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeRmc(gRmc, strlen(gRmc), &rmc) == 0);
+    U_PORT_TEST_ASSERT(rmc.timeOfDayMs == 34070000);
+    U_PORT_TEST_ASSERT(rmc.valid);
+    U_PORT_TEST_ASSERT(rmc.latitudeX1e7 == 533613366);
+    U_PORT_TEST_ASSERT(rmc.longitudeX1e7 == -65056200);
+    // 0.02 knots
+    U_PORT_TEST_ASSERT(rmc.speedMillimetresPerSecond == 10);
+    U_PORT_TEST_ASSERT(rmc.courseX100 == 3166);
+    U_PORT_TEST_ASSERT(rmc.day == 28);
+    U_PORT_TEST_ASSERT(rmc.month == 5);
+    U_PORT_TEST_ASSERT(rmc.year == 2011);
+    U_PORT_TEST_ASSERT(rmc.mode == 'A');
+
+    U_TEST_PRINT_LINE("decoding GSA...");
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeGsa(gGsa, strlen(gGsa), &gsa) == 0);
+    U_PORT_TEST_ASSERT(gsa.opMode == 'A');
+    U_PORT_TEST_ASSERT(gsa.navMode == 3);
+    U_PORT_TEST_ASSERT(gsa.numSvs == 8);
+    U_PORT_TEST_ASSERT(gsa.svId[0] == 10);
+    U_PORT_TEST_ASSERT(gsa.svId[7] == 13);
+    U_PORT_TEST_ASSERT(gsa.pdopX100 == 172);
+    U_PORT_TEST_ASSERT(gsa.hdopX100 == 103);
+    U_PORT_TEST_ASSERT(gsa.vdopX100 == 138);
+    U_PORT_TEST_ASSERT(gsa.systemId == U_GNSS_NMEA_EMPTY);
+
+    U_TEST_PRINT_LINE("decoding GSV...");
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeGsv(gGsv, strlen(gGsv), &gsv) == 0);
+    U_PORT_TEST_ASSERT(gsv.numMessages == 3);
+    U_PORT_TEST_ASSERT(gsv.messageNumber == 3);
+    U_PORT_TEST_ASSERT(gsv.numSvsInView == 11);
+    U_PORT_TEST_ASSERT(gsv.numSvs == 3);
+    U_PORT_TEST_ASSERT(gsv.sv[0].svId == 29);
+    U_PORT_TEST_ASSERT(gsv.sv[0].cnoDbhz == 24);
+    U_PORT_TEST_ASSERT(gsv.sv[1].azimuthDegrees == 20);
+    U_PORT_TEST_ASSERT(gsv.sv[1].cnoDbhz == U_GNSS_NMEA_EMPTY);
+    U_PORT_TEST_ASSERT(gsv.sv[2].svId == 36);
+    U_PORT_TEST_ASSERT(gsv.sv[2].elevationDegrees == U_GNSS_NMEA_EMPTY);
+    U_PORT_TEST_ASSERT(gsv.signalId == U_GNSS_NMEA_EMPTY);
+
+    U_TEST_PRINT_LINE("decoding VTG...");
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeVtg(gVtg, strlen(gVtg), &vtg) == 0);
+    U_PORT_TEST_ASSERT(vtg.courseTrueX100 == 7752);
+    U_PORT_TEST_ASSERT(vtg.courseMagneticX100 == U_GNSS_NMEA_EMPTY);
+    // 0.008 km/h
+    U_PORT_TEST_ASSERT(vtg.speedMillimetresPerSecond == 2);
+    U_PORT_TEST_ASSERT(vtg.mode == 'A');
+
+    U_TEST_PRINT_LINE("checking bad input...");
+    // Wrong sentence type
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeGga(gRmc, strlen(gRmc),
+                                          &gga) == (int32_t) U_ERROR_COMMON_NOT_FOUND);
+    // Truncated
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeGga(gGga, 30, &gga) == (int32_t) U_GNSS_ERROR_CRC);
+    // Corrupted
+    memcpy(buffer, gGga, sizeof(buffer));
+    buffer[10] = '9';
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeGga(buffer, strlen(buffer),
+                                          &gga) == (int32_t) U_GNSS_ERROR_CRC);
+    // The decoders must not have modified the sentence
+    buffer[10] = gGga[10];
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeGga(buffer, strlen(buffer), &gga) == 0);
+    U_PORT_TEST_ASSERT(memcmp(buffer, gGga, sizeof(buffer)) == 0);
+    U_PORT_TEST_ASSERT(uGnssNmeaDecodeGga(NULL, 0,
+                                          &gga) == (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
+// End of file
@@ -59,6 +59,7 @@
 #include "u_gnss_type.h"
 #include "u_gnss.h"
 #include "u_gnss_cfg.h"
+#include "u_gnss_cfg_val_key.h"
 #include "u_gnss_pwr.h"
 #include "u_gnss_msg.h" // uGnssMsgReceiveStatStreamLoss()
 #include "u_gnss_pos.h"
@@ -66,6 +67,8 @@
 
 #include "u_gnss_test_private.h"
 
+#include "u_bench.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -88,6 +91,18 @@
 #define U_GNSS_POS_TEST_TIMEOUT_SECONDS 180
 #endif
 
+#ifndef U_GNSS_POS_TEST_STREAMED_PERIOD_MS
+/** The measurement period to use when testing streamed position.
+ */
+#define U_GNSS_POS_TEST_STREAMED_PERIOD_MS 200
+#endif
+
+#ifndef U_GNSS_POS_TEST_STREAMED_DURATION_MS
+/** How long to count streamed fixes for.
+ */
+#define U_GNSS_POS_TEST_STREAMED_DURATION_MS 5000
+#endif
+
 #ifndef U_GNSS_POS_RRLP_SIZE_BYTES
 /** The number of bytes of buffer to allow for storing the RRLP
  * information.
@@ -171,6 +186,14 @@ static int32_t gSvs = 0;
  */
 static int64_t gTimeUtc = LONG_MIN;
 
+/** The number of fixes seen by streamedCallback().
+ */
+static volatile int32_t gStreamedCount = 0;
+
+/** The number of good fixes seen by streamedCallback().
+ */
+static volatile int32_t gStreamedGoodCount = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -210,6 +233,27 @@ static void posCallback(uDeviceHandle_t gnssHandle,
     gTimeUtc = timeUtc;
 }
 
+// Callback function for streamed position: counts the fixes and,
+// for the good ones, also stores them as posCallback() would.
+static void streamedCallback(uDeviceHandle_t gnssHandle,
+                             int32_t errorCode,
+                             int32_t latitudeX1e7,
+                             int32_t longitudeX1e7,
+                             int32_t altitudeMillimetres,
+                             int32_t radiusMillimetres,
+                             int32_t speedMillimetresPerSecond,
+                             int32_t svs,
+                             int64_t timeUtc)
+{
+    gStreamedCount++;
+    if (errorCode == 0) {
+        gStreamedGoodCount++;
+        posCallback(gnssHandle, errorCode, latitudeX1e7, longitudeX1e7,
+                    altitudeMillimetres, radiusMillimetres,
+                    speedMillimetresPerSecond, svs, timeUtc);
+    }
+}
+
 // Convert a lat/long into a whole number and a
 // bit-after-the-decimal-point that can be printed
 // without having to invoke floating point operations,
@@ -296,6 +340,7 @@ U_PORT_TEST_FUNCTION("[gnssPos]", "gnssPosPos")
 
         startTime = uPortGetTickTimeMs();
         gStopTimeMs = startTime + U_GNSS_POS_TEST_TIMEOUT_SECONDS * 1000;
+        uBenchEnergyBegin("gnssPosGet");
         y = uGnssPosGet(gnssHandle,
                         &latitudeX1e7, &longitudeX1e7,
                         &altitudeMillimetres,
@@ -303,6 +348,7 @@ U_PORT_TEST_FUNCTION("[gnssPos]", "gnssPosPos")
                         &speedMillimetresPerSecond,
                         &svs, &timeUtc,
                         keepGoingCallback);
+        uBenchEnergyEnd("gnssPosGet");
 
         U_PORT_TEST_ASSERT(y == 0);
 
@@ -486,6 +532,124 @@ U_PORT_TEST_FUNCTION("[gnssPos]", "gnssPosRrlp")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Test streamed position: UBX-NAV-PVT should arrive at the
+ * measurement rate that was set, which should be put back
+ * afterwards.
+ */
+U_PORT_TEST_FUNCTION("[gnssPos]", "gnssPosStreamed")
+{
+    uDeviceHandle_t gnssHandle;
+    const uGnssPrivateModule_t *pModule;
+    uint16_t rateMeasBefore = 0;
+    uint16_t rateMeas = 0;
+    int32_t count;
+    int32_t y;
+    int32_t startTimeMs;
+    int32_t heapUsed;
+    size_t iterations;
+    uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
+
+    // In case a previous test failed
+    uGnssTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Repeat for all transport types
+    iterations = uGnssTestPrivateTransportTypesSet(transportTypes, U_CFG_APP_GNSS_UART,
+                                                   U_CFG_APP_GNSS_I2C);
+    for (size_t x = 0; x < iterations; x++) {
+        // Do the standard preamble
+        U_TEST_PRINT_LINE("testing streamed position on transport %s...",
+                          pGnssTestPrivateTransportTypeName(transportTypes[x]));
+        U_PORT_TEST_ASSERT(uGnssTestPrivatePreamble(U_CFG_TEST_GNSS_MODULE_TYPE,
+                                                    transportTypes[x], &gHandles, true,
+                                                    U_CFG_APP_CELL_PIN_GNSS_POWER,
+                                                    U_CFG_APP_CELL_PIN_GNSS_DATA_READY) == 0);
+        gnssHandle = gHandles.gnssHandle;
+        pModule = pUGnssPrivateGetModule(gnssHandle);
+        U_PORT_TEST_ASSERT(pModule != NULL);
+
+        // Check that bad parameters are rejected
+        U_PORT_TEST_ASSERT(uGnssPosGetStreamedStart(gnssHandle, -1, NULL) < 0);
+        U_PORT_TEST_ASSERT(uGnssPosGetStreamedStart(gnssHandle,
+                                                    U_GNSS_POS_STREAMED_PERIOD_MIN_MS - 1,
+                                                    streamedCallback) < 0);
+
+        if (U_GNSS_PRIVATE_HAS(pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
+            U_PORT_TEST_ASSERT(uGnssCfgValGet(gnssHandle, U_GNSS_CFG_VAL_KEY_ID_RATE_MEAS_U2,
+                                              &rateMeasBefore, sizeof(rateMeasBefore),
+                                              U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+        }
+        gStreamedCount = 0;
+        gStreamedGoodCount = 0;
+        y = uGnssPosGetStreamedStart(gnssHandle, U_GNSS_POS_TEST_STREAMED_PERIOD_MS,
+                                     streamedCallback);
+        U_TEST_PRINT_LINE("uGnssPosGetStreamedStart() returned %d.", y);
+        if (!U_GNSS_PRIVATE_HAS(pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX) ||
+            (transportTypes[x] == U_GNSS_TRANSPORT_AT)) {
+            U_PORT_TEST_ASSERT(y == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+        } else {
+            U_PORT_TEST_ASSERT(y == 0);
+            // Can't start twice
+            U_PORT_TEST_ASSERT(uGnssPosGetStreamedStart(gnssHandle, -1,
+                                                        streamedCallback) < 0);
+            // Wait for a fix and then count how many arrive
+            startTimeMs = uPortGetTickTimeMs();
+            while ((gStreamedGoodCount == 0) &&
+                   (uPortGetTickTimeMs() - startTimeMs < U_GNSS_POS_TEST_TIMEOUT_SECONDS * 1000)) {
+                uPortTaskBlock(100);
+            }
+            U_TEST_PRINT_LINE("first good fix took %d second(s).",
+                              (int32_t) (uPortGetTickTimeMs() - startTimeMs) / 1000);
+            U_PORT_TEST_ASSERT(gStreamedGoodCount > 0);
+            U_PORT_TEST_ASSERT(gGnssHandle == gnssHandle);
+            U_PORT_TEST_ASSERT(gLatitudeX1e7 > INT_MIN);
+            U_PORT_TEST_ASSERT(gLongitudeX1e7 > INT_MIN);
+            U_PORT_TEST_ASSERT(gTimeUtc > 0);
+            count = gStreamedCount;
+            uPortTaskBlock(U_GNSS_POS_TEST_STREAMED_DURATION_MS);
+            count = gStreamedCount - count;
+            U_TEST_PRINT_LINE("%d fix(es) in %d ms, period %d ms.", count,
+                              U_GNSS_POS_TEST_STREAMED_DURATION_MS,
+                              U_GNSS_POS_TEST_STREAMED_PERIOD_MS);
+            // Allow some slack either way
+            U_PORT_TEST_ASSERT(count >= (U_GNSS_POS_TEST_STREAMED_DURATION_MS /
+                                         U_GNSS_POS_TEST_STREAMED_PERIOD_MS) / 2);
+            U_PORT_TEST_ASSERT(count <= (U_GNSS_POS_TEST_STREAMED_DURATION_MS /
+                                         U_GNSS_POS_TEST_STREAMED_PERIOD_MS) * 2);
+            U_PORT_TEST_ASSERT(uGnssCfgValGet(gnssHandle, U_GNSS_CFG_VAL_KEY_ID_RATE_MEAS_U2,
+                                              &rateMeas, sizeof(rateMeas),
+                                              U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+            U_PORT_TEST_ASSERT(rateMeas == U_GNSS_POS_TEST_STREAMED_PERIOD_MS);
+
+            uGnssPosGetStreamedStop(gnssHandle);
+            // Nothing more should arrive and the rate should be back
+            count = gStreamedCount;
+            uPortTaskBlock(U_GNSS_POS_TEST_STREAMED_PERIOD_MS * 5);
+            U_PORT_TEST_ASSERT(gStreamedCount == count);
+            U_PORT_TEST_ASSERT(uGnssCfgValGet(gnssHandle, U_GNSS_CFG_VAL_KEY_ID_RATE_MEAS_U2,
+                                              &rateMeas, sizeof(rateMeas),
+                                              U_GNSS_CFG_VAL_LAYER_RAM) == 0);
+            U_TEST_PRINT_LINE("measurement period is back to %d ms.", rateMeas);
+            U_PORT_TEST_ASSERT(rateMeas == rateMeasBefore);
+        }
+        // Stopping when not started is fine
+        uGnssPosGetStreamedStop(gnssHandle);
+
+        // Do the standard postamble, leaving the module on for the next
+        // test to speed things up
+        uGnssTestPrivatePostamble(&gHandles, false);
+    }
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -35,6 +35,7 @@
 #  include "u_cfg_override.h" // For a customer's configuration override
 # endif
 
+#include "stdlib.h"    // malloc()/free()
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
@@ -76,6 +77,12 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
+#ifndef U_GNSS_PWR_TEST_HOT_START_BUFFER_SIZE
+/** The size of buffer to use when testing hot start.
+ */
+# define U_GNSS_PWR_TEST_HOT_START_BUFFER_SIZE (1024 * 8)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -105,6 +112,8 @@ U_PORT_TEST_FUNCTION("[gnssPwr]", "gnssPwrBasic")
     size_t iterations;
     uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM_WITH_UBX];
     int32_t y;
+    uGnssPwrHotStart_t hotStart = {0};
+    uGnssPwrHotStartStatus_t hotStartStatus;
 
     // Whatever called us likely initialised the
     // port so deinitialise it here to obtain the
@@ -164,6 +173,41 @@ U_PORT_TEST_FUNCTION("[gnssPwr]", "gnssPwrBasic")
         U_PORT_TEST_ASSERT(!uGnssPwrIsAlive(gnssHandle));
 #endif
 
+        if (transportTypes[x] != U_GNSS_TRANSPORT_AT) {
+            // Saving the navigation database needs a streamed transport
+            U_TEST_PRINT_LINE("testing hot start...");
+            U_PORT_TEST_ASSERT(uGnssPwrGetHotStartStatus(gnssHandle,
+                                                         &hotStartStatus) == U_ERROR_COMMON_NOT_FOUND);
+            hotStart.pBuffer = (char *) malloc(U_GNSS_PWR_TEST_HOT_START_BUFFER_SIZE);
+            U_PORT_TEST_ASSERT(hotStart.pBuffer != NULL);
+            hotStart.size = U_GNSS_PWR_TEST_HOT_START_BUFFER_SIZE;
+            hotStart.length = 0;
+            U_PORT_TEST_ASSERT(uGnssPwrSetHotStart(gnssHandle, &hotStart) == 0);
+            U_PORT_TEST_ASSERT(uGnssPwrOn(gnssHandle) == 0);
+            U_PORT_TEST_ASSERT(uGnssPwrOff(gnssHandle) == 0);
+            U_PORT_TEST_ASSERT(uGnssPwrGetHotStartStatus(gnssHandle, &hotStartStatus) == 0);
+            U_TEST_PRINT_LINE("save returned %d (%d message(s)), took %d ms.",
+                              hotStartStatus.saveErrorCodeOrLength,
+                              hotStartStatus.saveNumMessages,
+                              hotStartStatus.saveDurationMs);
+            // With no sky view the database may well be empty, but
+            // the save must still have worked
+            U_PORT_TEST_ASSERT(hotStartStatus.saveErrorCodeOrLength == (int32_t) hotStart.length);
+            U_PORT_TEST_ASSERT(uGnssPwrOn(gnssHandle) == 0);
+            U_PORT_TEST_ASSERT(uGnssPwrGetHotStartStatus(gnssHandle, &hotStartStatus) == 0);
+            if (hotStart.length > 0) {
+                U_TEST_PRINT_LINE("restore returned %d (%d byte(s)), took %d ms.",
+                                  hotStartStatus.restoreErrorCode,
+                                  hotStartStatus.restoreNumBytes,
+                                  hotStartStatus.restoreDurationMs);
+                U_PORT_TEST_ASSERT(hotStartStatus.restoreErrorCode == 0);
+                U_PORT_TEST_ASSERT(hotStartStatus.restoreNumBytes == hotStart.length);
+            }
+            U_PORT_TEST_ASSERT(uGnssPwrSetHotStart(gnssHandle, NULL) == 0);
+            U_PORT_TEST_ASSERT(uGnssPwrOff(gnssHandle) == 0);
+            free(hotStart.pBuffer);
+        }
+
         // Check that we haven't dropped any incoming data
         y = uGnssMsgReceiveStatStreamLoss(gnssHandle);
         U_TEST_PRINT_LINE("%d byte(s) lost from the message stream during that test.", y);
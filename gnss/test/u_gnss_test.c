@@ -36,7 +36,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memcmp()
+#include "string.h"    // memcmp(), memset(), strncmp(), strchr()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_os_platform_specific.h"
@@ -51,14 +51,23 @@
 #include "u_port_uart.h"
 #include "u_port_i2c.h"
 
+#include "u_hex_bin_convert.h" // uHexToBin(), uBinToHex()
+
+#include "u_at_client.h"
+
+#include "u_ubx_protocol.h"
+
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss.h"
+#include "u_gnss_msg.h"  // uGnssMsgReceiveStatStreamXxx()
+#include "u_gnss_time_sync.h" // U_GNSS_TIME_SYNC_DRIFT_WINDOW_SECONDS
+#include "u_gnss_private.h" // uGnssPrivateSpiFilterFill(), uGnssPrivateTimeSyncXxx(),
+                            // uGnssPrivateSendUbxMessageBatch()
 
 #if (U_CFG_APP_GNSS_I2C >= 0) && defined(U_GNSS_TEST_I2C_ADDRESS_EXTRA)
 #include "u_gnss_pwr.h"  // So that we can do something with the extra address
 #include "u_gnss_info.h" // To print something GNSS-module specific, show that we're not accidentally using address 0x42
-#include "u_gnss_msg.h"  // uGnssMsgReceiveStatStreamLoss()
 #endif
 
 /* ----------------------------------------------------------------
@@ -81,10 +90,94 @@
 # endif
 #endif
 
+#ifndef U_GNSS_TEST_RING_BUFFER_LENGTH_BYTES
+/** The length of user-supplied ring buffer to test with.
+ */
+# define U_GNSS_TEST_RING_BUFFER_LENGTH_BYTES 512
+#endif
+
+#ifndef U_GNSS_TEST_TEMPORARY_BUFFER_LENGTH_BYTES
+/** The length of user-supplied temporary buffer to test with.
+ */
+# define U_GNSS_TEST_TEMPORARY_BUFFER_LENGTH_BYTES 64
+#endif
+
+/** A GNSS time to start the time synchronisation model from, in
+ * microseconds (21 July 2021 13:40:36).
+ */
+#define U_GNSS_TEST_TIME_SYNC_START_US 1626874836000000LL
+
+/** How fast the host tick runs in the time synchronisation model
+ * test, in parts per billion.
+ */
+#define U_GNSS_TEST_TIME_SYNC_DRIFT_PPB 100000
+
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+# ifndef U_GNSS_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that runs the dummy AT server
+ * of gnssUbxBatchAt.
+ */
+#  define U_GNSS_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES 2304
+# endif
+
+# ifndef U_GNSS_TEST_AT_SERVER_TASK_PRIORITY
+/** The priority of the task that runs the dummy AT server of
+ * gnssUbxBatchAt.
+ */
+#  define U_GNSS_TEST_AT_SERVER_TASK_PRIORITY U_AT_CLIENT_URC_TASK_PRIORITY
+# endif
+
+/** The longest line that the dummy AT server of gnssUbxBatchAt
+ * can assemble.
+ */
+# define U_GNSS_TEST_AT_SERVER_LINE_LENGTH_BYTES 512
+
+/** The number of UBX messages that the dummy AT server of
+ * gnssUbxBatchAt can record.
+ */
+# define U_GNSS_TEST_AT_SERVER_MAX_NUM_MESSAGES 16
+
+/** The number of short UBX messages that gnssUbxBatchAt sends,
+ * enough that they don't all fit on one line.
+ */
+# define U_GNSS_TEST_UBX_BATCH_NUM_SHORT 8
+
+/** The body length of the short UBX messages that gnssUbxBatchAt
+ * sends.
+ */
+# define U_GNSS_TEST_UBX_BATCH_SHORT_BODY_LENGTH_BYTES 4
+
+/** The body length of the long UBX message that gnssUbxBatchAt
+ * sends, too long to share a line with a short one.
+ */
+# define U_GNSS_TEST_UBX_BATCH_LONG_BODY_LENGTH_BYTES 48
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+/** Context for the dummy AT server of gnssUbxBatchAt, which
+ * pretends to be a cellular module with a GNSS chip behind it.
+ */
+typedef struct {
+    char line[U_GNSS_TEST_AT_SERVER_LINE_LENGTH_BYTES];
+    size_t lineLength;
+    size_t numLines;       /**< the number of lines received. */
+    size_t maxLineLength;  /**< the length of the longest line received. */
+    int32_t messageId[U_GNSS_TEST_AT_SERVER_MAX_NUM_MESSAGES]; /**< the IDs of
+                                                                    the UBX messages
+                                                                    received, in order. */
+    size_t numMessages;    /**< the number of entries in messageId[]. */
+    int32_t nackMessageId; /**< the ID of a UBX message to Nack, -1 for none. */
+    bool swapAcks;         /**< send the first two Acks of a line the wrong
+                                way around. */
+    char ackHex[U_GNSS_TEST_AT_SERVER_MAX_NUM_MESSAGES]
+    [((U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES + 2) * 2) + 1];
+} uGnssTestAtServer_t;
+#endif
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -101,10 +194,182 @@ static uGnssTransportType_t gTransportTypeA = U_GNSS_TRANSPORT_NONE;
  */
 static int32_t gUartBHandle = -1;
 
+#if (U_CFG_TEST_UART_A >= 0) || (U_CFG_APP_GNSS_I2C >= 0)
+/** User-supplied ring buffer storage.
+ */
+static char gRingBuffer[U_GNSS_TEST_RING_BUFFER_LENGTH_BYTES];
+
+/** User-supplied temporary buffer storage.
+ */
+static char gTemporaryBuffer[U_GNSS_TEST_TEMPORARY_BUFFER_LENGTH_BYTES];
+#endif
+
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+/** The dummy AT server of gnssUbxBatchAt.
+ */
+static uGnssTestAtServer_t gAtServer;
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+
+// Write a string to the UART of the dummy AT server.
+static void atServerWrite(int32_t uartHandle, const char *pStr)
+{
+    uPortUartWrite(uartHandle, pStr, strlen(pStr));
+}
+
+// Respond to a line received by the dummy AT server, which should
+// contain one or more AT+UGUBX commands separated by ";", with a
+// +UGUBX response carrying the Ack or Nack of each UBX message,
+// in order unless the server has been told otherwise.
+static void atServerRespond(int32_t uartHandle, uGnssTestAtServer_t *pServer)
+{
+    char body[U_GNSS_TEST_AT_SERVER_LINE_LENGTH_BYTES / 2];
+    char encoded[U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES + 2];
+    const char *pHex = NULL;
+    const char *pEnd;
+    size_t numAcks = 0;
+    size_t y;
+    int32_t cls;
+    int32_t id;
+    int32_t length;
+
+    if (strncmp(pServer->line, "AT+UGUBX=\"", 10) == 0) {
+        pHex = pServer->line + 10;
+    }
+    while ((pHex != NULL) && (numAcks < U_GNSS_TEST_AT_SERVER_MAX_NUM_MESSAGES) &&
+           (pServer->numMessages < U_GNSS_TEST_AT_SERVER_MAX_NUM_MESSAGES)) {
+        pEnd = strchr(pHex, '"');
+        if (pEnd == NULL) {
+            break;
+        }
+        length = (int32_t) uHexToBin(pHex, pEnd - pHex, body);
+        if (uUbxProtocolDecode(body, length, &cls, &id, body, sizeof(body), NULL) < 0) {
+            break;
+        }
+        pServer->messageId[pServer->numMessages] = id;
+        pServer->numMessages++;
+        body[0] = (char) cls;
+        body[1] = (char) id;
+        length = uUbxProtocolEncode(0x05, (id == pServer->nackMessageId) ? 0x00 : 0x01,
+                                    body, 2, encoded);
+        pServer->ackHex[numAcks][uBinToHex(encoded, length, pServer->ackHex[numAcks])] = 0;
+        numAcks++;
+        pHex = NULL;
+        if (strncmp(pEnd + 1, ";+UGUBX=\"", 9) == 0) {
+            pHex = pEnd + 10;
+        }
+    }
+    for (size_t x = 0; x < numAcks; x++) {
+        y = x;
+        if (pServer->swapAcks && (numAcks > 1) && (x < 2)) {
+            y = 1 - x;
+        }
+        atServerWrite(uartHandle, "\r\n+UGUBX: \"");
+        atServerWrite(uartHandle, pServer->ackHex[y]);
+        atServerWrite(uartHandle, "\"\r\n");
+    }
+    if (numAcks > 0) {
+        atServerWrite(uartHandle, "\r\nOK\r\n");
+    } else {
+        atServerWrite(uartHandle, "\r\nERROR\r\n");
+    }
+}
+
+// Callback for data arriving at the dummy AT server: assembles
+// lines and responds to each one.
+static void atServerCallback(int32_t uartHandle, uint32_t eventBitmask,
+                             void *pParameters)
+{
+    uGnssTestAtServer_t *pServer = (uGnssTestAtServer_t *) pParameters;
+    char buffer[32];
+    int32_t length;
+
+    if (eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) {
+        do {
+            length = uPortUartRead(uartHandle, buffer, sizeof(buffer));
+            for (int32_t x = 0; x < length; x++) {
+                if (buffer[x] == '\r') {
+                    pServer->line[pServer->lineLength] = 0;
+                    if (pServer->lineLength > 0) {
+                        pServer->numLines++;
+                        if (pServer->lineLength > pServer->maxLineLength) {
+                            pServer->maxLineLength = pServer->lineLength;
+                        }
+                        atServerRespond(uartHandle, pServer);
+                    }
+                    pServer->lineLength = 0;
+                } else if ((buffer[x] != '\n') &&
+                           (pServer->lineLength < sizeof(pServer->line) - 1)) {
+                    pServer->line[pServer->lineLength] = buffer[x];
+                    pServer->lineLength++;
+                }
+            }
+        } while (length > 0);
+    }
+}
+
+// Reset the record kept by the dummy AT server.
+static void atServerReset(uGnssTestAtServer_t *pServer)
+{
+    pServer->numLines = 0;
+    pServer->maxLineLength = 0;
+    pServer->numMessages = 0;
+    pServer->nackMessageId = -1;
+    pServer->swapAcks = false;
+}
+
+// Work out how many lines uGnssPrivateSendUbxMessageBatch() should
+// put the given messages on over an AT transport, and the length of
+// the longest of those lines: the first command on a line is
+// "AT+UGUBX=" followed by the quoted hex of the UBX message, any
+// subsequent ones ";+UGUBX=" followed by the quoted hex.
+static size_t batchAtNumLines(const uUbxProtocolMessage_t *pMessageList,
+                              size_t numMessages, size_t *pMaxLineLength)
+{
+    size_t numLines = 0;
+    size_t lineLength = 0;
+    size_t length;
+
+    *pMaxLineLength = 0;
+    for (size_t x = 0; x < numMessages; x++) {
+        length = 8 + (((pMessageList + x)->bodyLengthBytes +
+                       U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) * 2) + 2;
+        if ((numLines == 0) ||
+            (lineLength + length > U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES)) {
+            numLines++;
+            lineLength = length + 1;
+        } else {
+            lineLength += length;
+        }
+        if (lineLength > *pMaxLineLength) {
+            *pMaxLineLength = lineLength;
+        }
+    }
+
+    return numLines;
+}
+
+// Check that the dummy AT server received the IDs of the given
+// messages, in order.
+static bool batchAtCheckOrder(const uUbxProtocolMessage_t *pMessageList,
+                              size_t numMessages)
+{
+    bool isGood = (gAtServer.numMessages == numMessages);
+
+    for (size_t x = 0; (x < numMessages) && isGood; x++) {
+        isGood = (gAtServer.messageId[x] == (pMessageList + x)->messageId);
+    }
+
+    return isGood;
+}
+
+#endif // #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -123,6 +388,138 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssInitialisation")
     uPortDeinit();
 }
 
+/** Test the filtering of the idle fill that a GNSS chip sends
+ * over SPI; this needs no GNSS module.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssSpiFilterFill")
+{
+    char buffer[(U_GNSS_SPI_FILL_THRESHOLD_BYTES * 3) + 10];
+    size_t x = 0;
+    size_t y;
+
+    // Nothing in, nothing out
+    U_PORT_TEST_ASSERT(uGnssPrivateSpiFilterFill(buffer, 0) == 0);
+
+    // All fill
+    memset(buffer, 0xFF, sizeof(buffer));
+    U_PORT_TEST_ASSERT(uGnssPrivateSpiFilterFill(buffer, sizeof(buffer)) == 0);
+
+    // Data, a run of 0xFF just too short to be fill, which must be
+    // kept, more data, a run of 0xFF just long enough to be fill,
+    // which must be removed, then data and trailing fill
+    buffer[x++] = 0xB5;
+    buffer[x++] = 0x62;
+    memset(buffer + x, 0xFF, U_GNSS_SPI_FILL_THRESHOLD_BYTES - 1);
+    x += U_GNSS_SPI_FILL_THRESHOLD_BYTES - 1;
+    buffer[x++] = 0x01;
+    memset(buffer + x, 0xFF, U_GNSS_SPI_FILL_THRESHOLD_BYTES);
+    x += U_GNSS_SPI_FILL_THRESHOLD_BYTES;
+    buffer[x++] = 0x07;
+    buffer[x++] = 0xFF;
+    buffer[x++] = 0x5C;
+    memset(buffer + x, 0xFF, U_GNSS_SPI_FILL_THRESHOLD_BYTES + 2);
+    x += U_GNSS_SPI_FILL_THRESHOLD_BYTES + 2;
+    U_PORT_TEST_ASSERT(x <= sizeof(buffer));
+
+    y = uGnssPrivateSpiFilterFill(buffer, x);
+    U_TEST_PRINT_LINE("%d byte(s) filtered down to %d.", (int32_t) x, (int32_t) y);
+    U_PORT_TEST_ASSERT(y == 2 + (U_GNSS_SPI_FILL_THRESHOLD_BYTES - 1) + 1 + 3);
+    U_PORT_TEST_ASSERT(buffer[0] == (char) 0xB5);
+    U_PORT_TEST_ASSERT(buffer[1] == 0x62);
+    for (x = 2; x < 2 + (U_GNSS_SPI_FILL_THRESHOLD_BYTES - 1); x++) {
+        U_PORT_TEST_ASSERT(buffer[x] == (char) 0xFF);
+    }
+    U_PORT_TEST_ASSERT(buffer[x++] == 0x01);
+    U_PORT_TEST_ASSERT(buffer[x++] == 0x07);
+    U_PORT_TEST_ASSERT(buffer[x++] == (char) 0xFF);
+    U_PORT_TEST_ASSERT(buffer[x++] == 0x5C);
+    U_PORT_TEST_ASSERT(x == y);
+}
+
+/** Test the model that relates a host tick to GNSS time, as kept
+ * by uGnssTimeSyncStart(), by feeding it time pulses directly; this
+ * needs no GNSS module.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssTimeSyncModel")
+{
+    uGnssPrivateTimeSync_t timeSync;
+    // One second of host tick, which runs fast
+    int64_t periodTickUs = 1000000 + (U_GNSS_TEST_TIME_SYNC_DRIFT_PPB / 1000);
+    int64_t tickUs = 1000000;
+    int64_t timeUs = U_GNSS_TEST_TIME_SYNC_START_US;
+    size_t numPulses = U_GNSS_TIME_SYNC_DRIFT_WINDOW_SECONDS + 2;
+
+    memset(&timeSync, 0, sizeof(timeSync));
+
+    // No model yet
+    U_PORT_TEST_ASSERT(uGnssPrivateTimeSyncGetTimeUs(&timeSync, tickUs) ==
+                       (int32_t) U_ERROR_COMMON_NOT_FOUND);
+
+    // With one pulse there is an offset but no drift
+    uGnssPrivateTimeSyncUpdate(&timeSync, tickUs, timeUs, true);
+    U_PORT_TEST_ASSERT(timeSync.numPulses == 1);
+    U_PORT_TEST_ASSERT(timeSync.driftPpb == 0);
+    U_PORT_TEST_ASSERT(timeSync.isUtc);
+    U_PORT_TEST_ASSERT(uGnssPrivateTimeSyncGetTimeUs(&timeSync, tickUs) == timeUs);
+    U_PORT_TEST_ASSERT(uGnssPrivateTimeSyncGetTimeUs(&timeSync, tickUs + 500000) ==
+                       timeUs + 500000);
+
+    // A second pulse gives the drift, which must then hold
+    // across more than a whole drift window
+    for (size_t x = 1; x < numPulses; x++) {
+        tickUs += periodTickUs;
+        timeUs += 1000000;
+        uGnssPrivateTimeSyncUpdate(&timeSync, tickUs, timeUs, true);
+        U_PORT_TEST_ASSERT(timeSync.numPulses == x + 1);
+        U_PORT_TEST_ASSERT(timeSync.driftPpb == U_GNSS_TEST_TIME_SYNC_DRIFT_PPB);
+    }
+    U_PORT_TEST_ASSERT(timeSync.driftFromWindow);
+    U_TEST_PRINT_LINE("%d pulse(s), drift %d ppb.", (int32_t) timeSync.numPulses,
+                      timeSync.driftPpb);
+    // The drift must be taken out when converting a tick
+    U_PORT_TEST_ASSERT(uGnssPrivateTimeSyncGetTimeUs(&timeSync, tickUs) == timeUs);
+    U_PORT_TEST_ASSERT(uGnssPrivateTimeSyncGetTimeUs(&timeSync, tickUs + periodTickUs) ==
+                       timeUs + 1000000);
+    U_PORT_TEST_ASSERT(uGnssPrivateTimeSyncGetTimeUs(&timeSync, tickUs - periodTickUs) ==
+                       timeUs - 1000000);
+
+    // Jitter on one pulse must not disturb the drift measured
+    // over the window
+    tickUs += periodTickUs + 50;
+    timeUs += 1000000;
+    uGnssPrivateTimeSyncUpdate(&timeSync, tickUs, timeUs, true);
+    U_PORT_TEST_ASSERT(timeSync.numPulses == numPulses + 1);
+    U_PORT_TEST_ASSERT(timeSync.driftPpb == U_GNSS_TEST_TIME_SYNC_DRIFT_PPB);
+
+    // A pulse that does not fit, e.g. because one was missed, starts
+    // the model again
+    tickUs += periodTickUs * 2;
+    timeUs += 1000000;
+    uGnssPrivateTimeSyncUpdate(&timeSync, tickUs, timeUs, true);
+    U_PORT_TEST_ASSERT(timeSync.numPulses == 1);
+    U_PORT_TEST_ASSERT(timeSync.driftPpb == 0);
+    U_PORT_TEST_ASSERT(uGnssPrivateTimeSyncGetTimeUs(&timeSync, tickUs) == timeUs);
+
+    // So does a host tick that goes backwards, e.g. at a wrap
+    tickUs = 0;
+    timeUs += 1000000;
+    uGnssPrivateTimeSyncUpdate(&timeSync, tickUs, timeUs, true);
+    U_PORT_TEST_ASSERT(timeSync.numPulses == 1);
+    tickUs += periodTickUs;
+    timeUs += 1000000;
+    uGnssPrivateTimeSyncUpdate(&timeSync, tickUs, timeUs, true);
+    U_PORT_TEST_ASSERT(timeSync.numPulses == 2);
+    U_PORT_TEST_ASSERT(timeSync.driftPpb == U_GNSS_TEST_TIME_SYNC_DRIFT_PPB);
+
+    // ...and a change of time base
+    tickUs += periodTickUs;
+    timeUs += 1000000;
+    uGnssPrivateTimeSyncUpdate(&timeSync, tickUs, timeUs, false);
+    U_PORT_TEST_ASSERT(timeSync.numPulses == 1);
+    U_PORT_TEST_ASSERT(!timeSync.isUtc);
+    U_PORT_TEST_ASSERT(timeSync.driftPpb == 0);
+}
+
 #if (U_CFG_TEST_UART_A >= 0) || (U_CFG_APP_GNSS_I2C >= 0)
 /** Add a streaming GNSS instance, e.g. UART or I2C,
  * and remove it again.
@@ -143,6 +540,8 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssAddStream")
     int32_t errorCode;
     int32_t heapUsed;
     bool printUbxMessagesDefault;
+    uGnssBufferCfg_t bufferCfg = {0};
+    size_t occupancy[2];
 
     // Whatever called us likely initialised the
     // port so deinitialise it here to obtain the
@@ -263,6 +662,31 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssAddStream")
     U_TEST_PRINT_LINE("removing first GNSS instance...");
     uGnssRemove(gnssHandleA);
 
+    U_TEST_PRINT_LINE("adding it with a temporary buffer that is too big, should fail...");
+    bufferCfg.ringBufferLengthBytes = sizeof(gRingBuffer);
+    bufferCfg.temporaryBufferLengthBytes = sizeof(gRingBuffer) - 1;
+    U_PORT_TEST_ASSERT(uGnssAddWithBuffers(U_GNSS_MODULE_TYPE_M8,
+                                           gTransportTypeA, transportHandleA,
+                                           -1, false, &bufferCfg,
+                                           &gnssHandleA) < 0);
+
+    U_TEST_PRINT_LINE("adding it with user-supplied buffers...");
+    bufferCfg.pRingBuffer = gRingBuffer;
+    bufferCfg.temporaryBufferLengthBytes = sizeof(gTemporaryBuffer);
+    bufferCfg.pTemporaryBuffer = gTemporaryBuffer;
+    errorCode = uGnssAddWithBuffers(U_GNSS_MODULE_TYPE_M8,
+                                    gTransportTypeA, transportHandleA,
+                                    -1, false, &bufferCfg, &gnssHandleA);
+    U_PORT_TEST_ASSERT_EQUAL((int32_t) U_ERROR_COMMON_SUCCESS, errorCode);
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStatStreamHighWaterMark(gnssHandleA) <= sizeof(gRingBuffer));
+    // Not running, so should be zero
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStatReadHighWaterMark(gnssHandleA) == 0);
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStatStreamOccupancy(gnssHandleA, occupancy,
+                                                          sizeof(occupancy) /
+                                                          sizeof(occupancy[0])) == 2);
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStatStreamEvictions(gnssHandleA) == 0);
+    uGnssRemove(gnssHandleA);
+
     U_TEST_PRINT_LINE("adding it again...");
     // Still need to test the UBX form until we remove it
     if (gTransportTypeA == U_GNSS_TRANSPORT_UART) {
@@ -479,6 +903,203 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssI2cAddress")
 }
 #endif
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+/** Test sending a batch of UBX messages over an AT transport, i.e.
+ * as AT+UGUBX commands, against a dummy AT server on UART B that
+ * pretends to be a cellular module with a GNSS chip behind it:
+ * the commands should be concatenated onto as few lines as
+ * #U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES allows, the Acks should be
+ * checked in order and a Nack should stop the batch at the end of
+ * the line it is on.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssUbxBatchAt")
+{
+    uAtClientHandle_t atClientHandle;
+    uGnssTransportHandle_t transportHandle;
+    uDeviceHandle_t gnssHandle;
+    uGnssPrivateInstance_t *pInstance;
+    char shortBody[U_GNSS_TEST_UBX_BATCH_NUM_SHORT][U_GNSS_TEST_UBX_BATCH_SHORT_BODY_LENGTH_BYTES];
+    char longBody[U_GNSS_TEST_UBX_BATCH_LONG_BODY_LENGTH_BYTES];
+    uUbxProtocolMessage_t messages[U_GNSS_TEST_UBX_BATCH_NUM_SHORT];
+    uUbxProtocolMessage_t messagesMixed[4];
+    size_t shortLength;
+    size_t perLine;
+    size_t numLines;
+    size_t maxLineLength;
+    int32_t errorCode;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Some short UBX-CFG messages, each with its own ID
+    for (size_t x = 0; x < U_GNSS_TEST_UBX_BATCH_NUM_SHORT; x++) {
+        memset(shortBody[x], (int) x, sizeof(shortBody[x]));
+        messages[x].messageClass = 0x06;
+        messages[x].messageId = 0x40 + (int32_t) x;
+        messages[x].pBody = shortBody[x];
+        messages[x].bodyLengthBytes = sizeof(shortBody[x]);
+    }
+    // A mix of short and long messages, the long one too long to
+    // share a line with either of its neighbours
+    memset(longBody, 0xff, sizeof(longBody));
+    messagesMixed[0] = messages[0];
+    messagesMixed[1] = messages[1];
+    messagesMixed[1].pBody = longBody;
+    messagesMixed[1].bodyLengthBytes = sizeof(longBody);
+    messagesMixed[2] = messages[2];
+    messagesMixed[3] = messages[3];
+
+    gStreamAHandle = uPortUartOpen(U_CFG_TEST_UART_A,
+                                   U_CFG_TEST_BAUD_RATE,
+                                   NULL,
+                                   U_GNSS_UART_BUFFER_LENGTH_BYTES,
+                                   U_CFG_TEST_PIN_UART_A_TXD,
+                                   U_CFG_TEST_PIN_UART_A_RXD,
+                                   U_CFG_TEST_PIN_UART_A_CTS,
+                                   U_CFG_TEST_PIN_UART_A_RTS);
+    U_PORT_TEST_ASSERT(gStreamAHandle >= 0);
+    gTransportTypeA = U_GNSS_TRANSPORT_UART;
+    gUartBHandle = uPortUartOpen(U_CFG_TEST_UART_B,
+                                 U_CFG_TEST_BAUD_RATE,
+                                 NULL,
+                                 U_GNSS_UART_BUFFER_LENGTH_BYTES,
+                                 U_CFG_TEST_PIN_UART_B_TXD,
+                                 U_CFG_TEST_PIN_UART_B_RXD,
+                                 U_CFG_TEST_PIN_UART_B_CTS,
+                                 U_CFG_TEST_PIN_UART_B_RTS);
+    U_PORT_TEST_ASSERT(gUartBHandle >= 0);
+
+    U_TEST_PRINT_LINE("AT client on UART %d, dummy AT server on UART %d,"
+                      " make sure they are cross-connected.",
+                      U_CFG_TEST_UART_A, U_CFG_TEST_UART_B);
+    memset(&gAtServer, 0, sizeof(gAtServer));
+    atServerReset(&gAtServer);
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(gUartBHandle,
+                                                 U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                 atServerCallback, &gAtServer,
+                                                 U_GNSS_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES,
+                                                 U_GNSS_TEST_AT_SERVER_TASK_PRIORITY) == 0);
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+    atClientHandle = uAtClientAdd(gStreamAHandle, U_AT_CLIENT_STREAM_TYPE_UART,
+                                  NULL, U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    U_PORT_TEST_ASSERT(uGnssInit() == 0);
+    transportHandle.pAt = atClientHandle;
+    U_PORT_TEST_ASSERT(uGnssAdd(U_GNSS_MODULE_TYPE_M9, U_GNSS_TRANSPORT_AT,
+                                transportHandle, -1, false, &gnssHandle) == 0);
+    pInstance = pUGnssPrivateGetInstance(gnssHandle);
+    U_PORT_TEST_ASSERT(pInstance != NULL);
+
+    // Nothing to send is fine and sends nothing
+    U_PORT_TEST_ASSERT(uGnssPrivateSendUbxMessageBatch(pInstance, NULL, 1) < 0);
+    U_PORT_TEST_ASSERT(uGnssPrivateSendUbxMessageBatch(pInstance, messages, 0) == 0);
+    U_PORT_TEST_ASSERT(gAtServer.numLines == 0);
+
+    // The first command on a line is "AT+UGUBX=" and the quoted hex,
+    // the rest lose the "AT" and gain a ';'; the test assumes that
+    // more than one, but fewer than half, of the short messages fit
+    // on a line
+    shortLength = 9 + ((U_GNSS_TEST_UBX_BATCH_SHORT_BODY_LENGTH_BYTES +
+                        U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) * 2) + 2;
+    perLine = 1 + ((U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES - shortLength) / (shortLength - 1));
+    U_PORT_TEST_ASSERT((perLine > 1) && (perLine * 2 < U_GNSS_TEST_UBX_BATCH_NUM_SHORT));
+
+    // All Acked: concatenated onto as few lines as possible, in order
+    errorCode = uGnssPrivateSendUbxMessageBatch(pInstance, messages,
+                                                U_GNSS_TEST_UBX_BATCH_NUM_SHORT);
+    numLines = batchAtNumLines(messages, U_GNSS_TEST_UBX_BATCH_NUM_SHORT, &maxLineLength);
+    U_TEST_PRINT_LINE("%d short UBX message(s) returned %d and went on %d line(s),"
+                      " the longest %d byte(s).", U_GNSS_TEST_UBX_BATCH_NUM_SHORT,
+                      errorCode, (int) gAtServer.numLines, (int) gAtServer.maxLineLength);
+    U_PORT_TEST_ASSERT(errorCode == 0);
+    U_PORT_TEST_ASSERT(numLines == (U_GNSS_TEST_UBX_BATCH_NUM_SHORT + perLine - 1) / perLine);
+    U_PORT_TEST_ASSERT(maxLineLength == shortLength + ((perLine - 1) * (shortLength - 1)));
+    U_PORT_TEST_ASSERT(gAtServer.numLines == numLines);
+    U_PORT_TEST_ASSERT(gAtServer.maxLineLength == maxLineLength);
+    U_PORT_TEST_ASSERT(gAtServer.maxLineLength <= U_GNSS_AT_BATCH_LINE_LENGTH_MAX_BYTES);
+    U_PORT_TEST_ASSERT(batchAtCheckOrder(messages, U_GNSS_TEST_UBX_BATCH_NUM_SHORT));
+
+    // A message too long to share a line with its neighbours
+    // splits the batch either side of it
+    atServerReset(&gAtServer);
+    errorCode = uGnssPrivateSendUbxMessageBatch(pInstance, messagesMixed,
+                                                sizeof(messagesMixed) / sizeof(messagesMixed[0]));
+    numLines = batchAtNumLines(messagesMixed, sizeof(messagesMixed) / sizeof(messagesMixed[0]),
+                               &maxLineLength);
+    U_TEST_PRINT_LINE("mixed UBX messages returned %d and went on %d line(s),"
+                      " the longest %d byte(s).", errorCode,
+                      (int) gAtServer.numLines, (int) gAtServer.maxLineLength);
+    U_PORT_TEST_ASSERT(errorCode == 0);
+    U_PORT_TEST_ASSERT(numLines == 3);
+    U_PORT_TEST_ASSERT(gAtServer.numLines == numLines);
+    U_PORT_TEST_ASSERT(gAtServer.maxLineLength == maxLineLength);
+    U_PORT_TEST_ASSERT(batchAtCheckOrder(messagesMixed,
+                                         sizeof(messagesMixed) / sizeof(messagesMixed[0])));
+
+    // A Nack in the middle of the second line: the rest of that line
+    // has already gone but the lines after it are never sent
+    atServerReset(&gAtServer);
+    gAtServer.nackMessageId = messages[perLine + 1].messageId;
+    errorCode = uGnssPrivateSendUbxMessageBatch(pInstance, messages,
+                                                U_GNSS_TEST_UBX_BATCH_NUM_SHORT);
+    U_TEST_PRINT_LINE("batch with a Nack returned %d after %d line(s).",
+                      errorCode, (int) gAtServer.numLines);
+    U_PORT_TEST_ASSERT(errorCode == (int32_t) U_GNSS_ERROR_NACK);
+    U_PORT_TEST_ASSERT(gAtServer.numLines == 2);
+    U_PORT_TEST_ASSERT(batchAtCheckOrder(messages, perLine * 2));
+
+    // Acks that arrive out of order are not accepted and,
+    // again, the lines after are never sent
+    atServerReset(&gAtServer);
+    gAtServer.swapAcks = true;
+    errorCode = uGnssPrivateSendUbxMessageBatch(pInstance, messages,
+                                                U_GNSS_TEST_UBX_BATCH_NUM_SHORT);
+    U_TEST_PRINT_LINE("batch with swapped Acks returned %d after %d line(s).",
+                      errorCode, (int) gAtServer.numLines);
+    U_PORT_TEST_ASSERT(errorCode < 0);
+    U_PORT_TEST_ASSERT(errorCode != (int32_t) U_GNSS_ERROR_NACK);
+    U_PORT_TEST_ASSERT(gAtServer.numLines == 1);
+    U_PORT_TEST_ASSERT(batchAtCheckOrder(messages, perLine));
+
+    // The AT client must still be usable afterwards
+    atServerReset(&gAtServer);
+    U_PORT_TEST_ASSERT(uGnssPrivateSendUbxMessageBatch(pInstance, messages, 1) == 0);
+    U_PORT_TEST_ASSERT(gAtServer.numLines == 1);
+    U_PORT_TEST_ASSERT(batchAtCheckOrder(messages, 1));
+
+    uGnssDeinit();
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+    uPortUartClose(gStreamAHandle);
+    gStreamAHandle = -1;
+    uPortDeinit();
+
+# ifndef __XTENSA__
+    // Check for memory leaks
+    // TODO: this if'ed out for ESP32 (xtensa compiler) at
+    // the moment as there is an issue with ESP32 hanging
+    // on to memory in the UART drivers that can't easily be
+    // accounted for.
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+# else
+    (void) heapUsed;
+# endif
+}
+#endif
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
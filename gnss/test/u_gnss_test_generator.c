@@ -0,0 +1,498 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief A generator of synthetic GNSS data for testing, see
+ * u_gnss_test_generator.h.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdlib.h"    // malloc()/free()
+#include "string.h"    // memset(), memcpy()
+#include "stdio.h"     // snprintf()
+
+#include "u_cfg_sw.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_os.h"   // Required by u_gnss_private.h
+
+#include "u_ubx_protocol.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_ubx_view.h"
+#include "u_gnss_private.h"
+
+#include "u_gnss_test_generator.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** Room for the longest NMEA sentence we generate, with some margin.
+ */
+#define U_GNSS_TEST_GENERATOR_NMEA_LENGTH_MAX_BYTES 100
+
+/** The overhead of an RTCM3 message: preamble, length and CRC.
+ */
+#define U_GNSS_TEST_GENERATOR_RTCM_OVERHEAD_LENGTH_BYTES 6
+
+/** The position of the first epoch (somewhere near Cambridge, UK).
+ */
+#define U_GNSS_TEST_GENERATOR_LATITUDE_START_X1E7  522053000
+#define U_GNSS_TEST_GENERATOR_LONGITUDE_START_X1E7 1218000
+
+/** How far the position moves at each epoch, about a metre north
+ * and half a metre east.
+ */
+#define U_GNSS_TEST_GENERATOR_LATITUDE_STEP_X1E7  90
+#define U_GNSS_TEST_GENERATOR_LONGITUDE_STEP_X1E7 70
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The RTCM3 message types that are cycled through.
+ */
+static const uint16_t gRtcmType[] = {1005, 1077, 1087, 1097, 1127, 1230};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Write a little-endian uint16_t.
+static void putUint16(char *pBuffer, uint16_t value)
+{
+    value = uUbxProtocolUint16Encode(value);
+    memcpy(pBuffer, &value, sizeof(value));
+}
+
+// Write a little-endian uint32_t.
+static void putUint32(char *pBuffer, uint32_t value)
+{
+    value = uUbxProtocolUint32Encode(value);
+    memcpy(pBuffer, &value, sizeof(value));
+}
+
+// Write a little-endian double.
+static void putDouble(char *pBuffer, double value)
+{
+    uint64_t x;
+
+    memcpy(&x, &value, sizeof(x));
+    x = uUbxProtocolUint64Encode(x);
+    memcpy(pBuffer, &x, sizeof(x));
+}
+
+// Return the length of an epoch of the given mix.
+static size_t epochLength(const uGnssTestGeneratorMix_t *pMix)
+{
+    return (pMix->numNavPvt * (U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES +
+                               U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES)) +
+           (pMix->numRxmRawx * (U_GNSS_UBX_RXM_RAWX_BODY_LENGTH_BYTES(pMix->rxmRawxNumMeas) +
+                                U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES)) +
+           (pMix->numNmea * U_GNSS_TEST_GENERATOR_NMEA_LENGTH_MAX_BYTES) +
+           (pMix->numRtcm * (pMix->rtcmBodyLengthBytes +
+                             U_GNSS_TEST_GENERATOR_RTCM_OVERHEAD_LENGTH_BYTES));
+}
+
+// Return the length of the scratch area needed to assemble a UBX body.
+static size_t scratchLength(const uGnssTestGeneratorMix_t *pMix)
+{
+    size_t length = U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES;
+
+    if (U_GNSS_UBX_RXM_RAWX_BODY_LENGTH_BYTES(pMix->rxmRawxNumMeas) > length) {
+        length = U_GNSS_UBX_RXM_RAWX_BODY_LENGTH_BYTES(pMix->rxmRawxNumMeas);
+    }
+
+    return length;
+}
+
+// Encode a UBX-NAV-PVT for the current epoch at pBuffer, assembling
+// the body in pScratch; returns the length.
+static int32_t navPvt(uGnssTestGenerator_t *pGenerator, char *pBuffer,
+                      char *pScratch)
+{
+    uint32_t secondsOfDay = (43200 + pGenerator->epoch) % 86400;
+
+    memset(pScratch, 0, U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES);
+    putUint32(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_ITOW, pGenerator->epoch * 1000);
+    putUint16(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_YEAR, 2024);
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_MONTH) = 6;
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_DAY) = 1;
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_HOUR) = (char) (secondsOfDay / 3600);
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_MIN) = (char) ((secondsOfDay / 60) % 60);
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_SEC) = (char) (secondsOfDay % 60);
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_VALID) = U_GNSS_UBX_NAV_PVT_VALID_DATE_TIME;
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_FIX_TYPE) = 3;
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_FLAGS) = U_GNSS_UBX_NAV_PVT_FLAGS_GNSS_FIX_OK;
+    *(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_NUM_SV) = 12;
+    putUint32(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_LON, (uint32_t) pGenerator->longitudeX1e7);
+    putUint32(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_LAT, (uint32_t) pGenerator->latitudeX1e7);
+    putUint32(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_HEIGHT, 62000);
+    putUint32(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_H_MSL, 15000);
+    putUint32(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_H_ACC, 1500);
+    putUint32(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_V_ACC, 2500);
+    putUint32(pScratch + U_GNSS_UBX_NAV_PVT_OFFSET_G_SPEED, 1100);
+
+    return uUbxProtocolEncode(U_GNSS_UBX_NAV_PVT_CLASS, U_GNSS_UBX_NAV_PVT_ID,
+                              pScratch, U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES,
+                              pBuffer);
+}
+
+// Encode a UBX-RXM-RAWX for the current epoch at pBuffer, assembling
+// the body in pScratch; returns the length.
+static int32_t rxmRawx(uGnssTestGenerator_t *pGenerator, char *pBuffer,
+                       char *pScratch)
+{
+    size_t numMeas = pGenerator->mix.rxmRawxNumMeas;
+    size_t bodyLength = U_GNSS_UBX_RXM_RAWX_BODY_LENGTH_BYTES(numMeas);
+    char *pBlock;
+
+    memset(pScratch, 0, bodyLength);
+    putDouble(pScratch + U_GNSS_UBX_RXM_RAWX_OFFSET_RCV_TOW, (double) pGenerator->epoch);
+    putUint16(pScratch + U_GNSS_UBX_RXM_RAWX_OFFSET_WEEK, 2317);
+    *(pScratch + U_GNSS_UBX_RXM_RAWX_OFFSET_LEAP_S) = 18;
+    *(pScratch + U_GNSS_UBX_RXM_RAWX_OFFSET_NUM_MEAS) = (char) numMeas;
+    *(pScratch + U_GNSS_UBX_RXM_RAWX_OFFSET_REC_STAT) = 0x01;
+    *(pScratch + U_GNSS_UBX_RXM_RAWX_OFFSET_VERSION) = 0x01;
+    for (size_t x = 0; x < numMeas; x++) {
+        pBlock = U_GNSS_UBX_RXM_RAWX_BLOCK(pScratch, x);
+        putDouble(pBlock + U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_PR_MES,
+                  20000000.0 + (double) (x * 100000) + (double) pGenerator->epoch);
+        putDouble(pBlock + U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_CP_MES,
+                  100000000.0 + (double) (x * 500000) + (double) (pGenerator->epoch * 5));
+        *(pBlock + U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_GNSS_ID) = (char) (x % 4);
+        *(pBlock + U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_SV_ID) = (char) (1 + (x / 4));
+        *(pBlock + U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_CNO) = (char) (30 + (x % 15));
+        *(pBlock + U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_TRK_STAT) = 0x07;
+    }
+
+    return uUbxProtocolEncode(U_GNSS_UBX_RXM_RAWX_CLASS, U_GNSS_UBX_RXM_RAWX_ID,
+                              pScratch, bodyLength, pBuffer);
+}
+
+// Write a latitude or longitude in NMEA form, (d)ddmm.mmmmm,H.
+static int32_t nmeaDegrees(char *pBuffer, size_t bufferLength,
+                           int32_t valueX1e7, bool isLatitude)
+{
+    char hemisphere = isLatitude ? 'N' : 'E';
+    int32_t degrees;
+    int32_t minutesX1e5;
+
+    if (valueX1e7 < 0) {
+        hemisphere = isLatitude ? 'S' : 'W';
+        valueX1e7 = -valueX1e7;
+    }
+    degrees = valueX1e7 / 10000000;
+    minutesX1e5 = (int32_t) (((int64_t) (valueX1e7 % 10000000) * 60) / 100);
+
+    return snprintf(pBuffer, bufferLength, isLatitude ? "%02d%02d.%05d,%c" : "%03d%02d.%05d,%c",
+                    (int) degrees, (int) (minutesX1e5 / 100000),
+                    (int) (minutesX1e5 % 100000), hemisphere);
+}
+
+// Write the next NMEA sentence of the cycle at pBuffer, returning
+// the length.
+static int32_t nmea(uGnssTestGenerator_t *pGenerator, char *pBuffer)
+{
+    uint32_t secondsOfDay = (43200 + pGenerator->epoch) % 86400;
+    char time[12];
+    char latitude[16];
+    char longitude[16];
+    int32_t length = 0;
+    uint8_t checksum = 0;
+    size_t gsvIndex;
+
+    snprintf(time, sizeof(time), "%02d%02d%02d.00", (int) (secondsOfDay / 3600),
+             (int) ((secondsOfDay / 60) % 60), (int) (secondsOfDay % 60));
+    nmeaDegrees(latitude, sizeof(latitude), pGenerator->latitudeX1e7, true);
+    nmeaDegrees(longitude, sizeof(longitude), pGenerator->longitudeX1e7, false);
+    switch (pGenerator->nmeaIndex % 6) {
+        case 0:
+            length = snprintf(pBuffer, U_GNSS_TEST_GENERATOR_NMEA_LENGTH_MAX_BYTES,
+                              "$GNGGA,%s,%s,%s,1,12,0.80,15.0,M,47.0,M,,", time,
+                              latitude, longitude);
+            break;
+        case 1:
+            length = snprintf(pBuffer, U_GNSS_TEST_GENERATOR_NMEA_LENGTH_MAX_BYTES,
+                              "$GNRMC,%s,A,%s,%s,2.14,45.00,010624,,,A,V", time,
+                              latitude, longitude);
+            break;
+        case 2:
+            length = snprintf(pBuffer, U_GNSS_TEST_GENERATOR_NMEA_LENGTH_MAX_BYTES,
+                              "$GNGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,1.40,0.80,1.15,1");
+            break;
+        default:
+            // Three GSV sentences of four satellites each
+            gsvIndex = (pGenerator->nmeaIndex % 6) - 3;
+            length = snprintf(pBuffer, U_GNSS_TEST_GENERATOR_NMEA_LENGTH_MAX_BYTES,
+                              "$GPGSV,3,%d,12,%02d,45,%03d,40,%02d,30,%03d,38,%02d,60,%03d,42,%02d,15,%03d,31,1",
+                              (int) (gsvIndex + 1),
+                              (int) ((gsvIndex * 4) + 1), (int) ((gsvIndex * 90) + 10),
+                              (int) ((gsvIndex * 4) + 2), (int) ((gsvIndex * 90) + 30),
+                              (int) ((gsvIndex * 4) + 3), (int) ((gsvIndex * 90) + 50),
+                              (int) ((gsvIndex * 4) + 4), (int) ((gsvIndex * 90) + 70));
+            break;
+    }
+    pGenerator->nmeaIndex++;
+    for (int32_t x = 1; x < length; x++) {
+        checksum ^= (uint8_t) pBuffer[x];
+    }
+    length += snprintf(pBuffer + length, U_GNSS_TEST_GENERATOR_NMEA_LENGTH_MAX_BYTES - length,
+                       "*%02X\r\n", checksum);
+
+    return length;
+}
+
+// Compute the CRC24Q of an RTCM3 message.
+static uint32_t crc24q(const char *pBuffer, size_t length)
+{
+    uint32_t crc = 0;
+
+    for (size_t x = 0; x < length; x++) {
+        crc ^= ((uint32_t) (uint8_t) pBuffer[x]) << 16;
+        for (size_t y = 0; y < 8; y++) {
+            crc <<= 1;
+            if (crc & 0x1000000) {
+                crc ^= 0x1864cfb;
+            }
+        }
+    }
+
+    return crc & 0xffffff;
+}
+
+// Write the next RTCM3 message of the cycle at pBuffer, returning
+// the length; the body is the message type followed by
+// pseudo-random filling.
+static int32_t rtcm(uGnssTestGenerator_t *pGenerator, char *pBuffer)
+{
+    size_t bodyLength = pGenerator->mix.rtcmBodyLengthBytes;
+    uint16_t type = gRtcmType[pGenerator->rtcmIndex % (sizeof(gRtcmType) / sizeof(gRtcmType[0]))];
+    uint32_t crc;
+
+    pGenerator->rtcmIndex++;
+    *pBuffer = (char) 0xd3;
+    *(pBuffer + 1) = (char) ((bodyLength >> 8) & 0x03);
+    *(pBuffer + 2) = (char) (bodyLength & 0xff);
+    *(pBuffer + 3) = (char) (type >> 4);
+    *(pBuffer + 4) = (char) ((type & 0x0f) << 4);
+    for (size_t x = 2; x < bodyLength; x++) {
+        pGenerator->pseudoRandom = (pGenerator->pseudoRandom * 1103515245) + 12345;
+        *(pBuffer + 3 + x) = (char) (pGenerator->pseudoRandom >> 16);
+    }
+    crc = crc24q(pBuffer, bodyLength + 3);
+    *(pBuffer + 3 + bodyLength) = (char) (crc >> 16);
+    *(pBuffer + 4 + bodyLength) = (char) (crc >> 8);
+    *(pBuffer + 5 + bodyLength) = (char) crc;
+
+    return (int32_t) (bodyLength + U_GNSS_TEST_GENERATOR_RTCM_OVERHEAD_LENGTH_BYTES);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Initialise a generator.
+int32_t uGnssTestGeneratorInit(uGnssTestGenerator_t *pGenerator,
+                               const uGnssTestGeneratorMix_t *pMix)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pGenerator != NULL) && (pMix != NULL) &&
+        (pMix->rxmRawxNumMeas <= U_GNSS_TEST_GENERATOR_RAWX_NUM_MEAS_MAX) &&
+        ((pMix->numRtcm == 0) ||
+         ((pMix->rtcmBodyLengthBytes >= 2) &&
+          (pMix->rtcmBodyLengthBytes <= U_GNSS_TEST_GENERATOR_RTCM_BODY_LENGTH_MAX_BYTES)))) {
+        memset(pGenerator, 0, sizeof(*pGenerator));
+        pGenerator->mix = *pMix;
+        pGenerator->latitudeX1e7 = U_GNSS_TEST_GENERATOR_LATITUDE_START_X1E7;
+        pGenerator->longitudeX1e7 = U_GNSS_TEST_GENERATOR_LONGITUDE_START_X1E7;
+        pGenerator->pseudoRandom = 1;
+        pGenerator->bufferLengthBytes = epochLength(pMix);
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        // Add room at the end for assembling UBX message bodies
+        pGenerator->pBuffer = (char *) malloc(pGenerator->bufferLengthBytes +
+                                              scratchLength(pMix));
+        if (pGenerator->pBuffer != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Free the buffer of a generator.
+void uGnssTestGeneratorDeinit(uGnssTestGenerator_t *pGenerator)
+{
+    if (pGenerator != NULL) {
+        free(pGenerator->pBuffer);
+        pGenerator->pBuffer = NULL;
+    }
+}
+
+// Generate an epoch.
+int32_t uGnssTestGeneratorEpoch(uGnssTestGenerator_t *pGenerator)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t numLeft[U_GNSS_TEST_GENERATOR_KIND_MAX_NUM];
+    size_t total = 0;
+    int32_t length;
+    char *pScratch;
+    bool done = false;
+
+    if ((pGenerator != NULL) && (pGenerator->pBuffer != NULL)) {
+        pScratch = pGenerator->pBuffer + pGenerator->bufferLengthBytes;
+        numLeft[U_GNSS_TEST_GENERATOR_KIND_NAV_PVT] = pGenerator->mix.numNavPvt;
+        numLeft[U_GNSS_TEST_GENERATOR_KIND_RXM_RAWX] = pGenerator->mix.numRxmRawx;
+        numLeft[U_GNSS_TEST_GENERATOR_KIND_NMEA] = pGenerator->mix.numNmea;
+        numLeft[U_GNSS_TEST_GENERATOR_KIND_RTCM] = pGenerator->mix.numRtcm;
+        pGenerator->latitudeX1e7 += U_GNSS_TEST_GENERATOR_LATITUDE_STEP_X1E7;
+        pGenerator->longitudeX1e7 += U_GNSS_TEST_GENERATOR_LONGITUDE_STEP_X1E7;
+        // Interleave the kinds, one of each in turn
+        while (!done) {
+            done = true;
+            for (size_t kind = 0; kind < U_GNSS_TEST_GENERATOR_KIND_MAX_NUM; kind++) {
+                if (numLeft[kind] > 0) {
+                    switch (kind) {
+                        case U_GNSS_TEST_GENERATOR_KIND_NAV_PVT:
+                            length = navPvt(pGenerator, pGenerator->pBuffer + total, pScratch);
+                            break;
+                        case U_GNSS_TEST_GENERATOR_KIND_RXM_RAWX:
+                            length = rxmRawx(pGenerator, pGenerator->pBuffer + total, pScratch);
+                            break;
+                        case U_GNSS_TEST_GENERATOR_KIND_NMEA:
+                            length = nmea(pGenerator, pGenerator->pBuffer + total);
+                            break;
+                        default:
+                            length = rtcm(pGenerator, pGenerator->pBuffer + total);
+                            break;
+                    }
+                    if (length > 0) {
+                        total += length;
+                        pGenerator->numMessages[kind]++;
+                    }
+                    numLeft[kind]--;
+                    done = false;
+                }
+            }
+        }
+        pGenerator->epoch++;
+        pGenerator->numBytes += total;
+        errorCodeOrLength = (int32_t) total;
+    }
+
+    return errorCodeOrLength;
+}
+
+// Add a GNSS instance with a virtual stream.
+int32_t uGnssTestGeneratorAdd(uGnssModuleType_t moduleType,
+                              size_t ringBufferLengthBytes,
+                              uDeviceHandle_t *pGnssHandle)
+{
+    uGnssTransportHandle_t transportHandle;
+    uGnssBufferCfg_t bufferCfg = {0};
+
+    transportHandle.uart = U_GNSS_TEST_GENERATOR_VIRTUAL_UART_HANDLE;
+    bufferCfg.ringBufferLengthBytes = ringBufferLengthBytes;
+
+    return uGnssAddWithBuffers(moduleType, U_GNSS_TRANSPORT_UART,
+                               transportHandle, -1, true,
+                               &bufferCfg, pGnssHandle);
+}
+
+// Feed epochs into the ring buffer of a GNSS instance.
+int32_t uGnssTestGeneratorFeed(uDeviceHandle_t gnssHandle,
+                               uGnssTestGenerator_t *pGenerator,
+                               int32_t numEpochs, int32_t epochPeriodMs)
+{
+    int32_t errorCodeOrEpochs = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    int32_t startTimeMs;
+    int32_t length;
+    size_t chunkLength;
+    int32_t waitMs;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+
+        errorCodeOrEpochs = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pGenerator != NULL) && (numEpochs >= 0)) {
+            startTimeMs = uPortGetTickTimeMs();
+            errorCodeOrEpochs = 0;
+            while ((errorCodeOrEpochs >= 0) && (errorCodeOrEpochs < numEpochs)) {
+                length = uGnssTestGeneratorEpoch(pGenerator);
+                // Add it in chunks, as a UART driver would deliver it
+                for (int32_t x = 0; x < length; x += (int32_t) chunkLength) {
+                    chunkLength = length - x;
+                    if ((pGenerator->mix.chunkLengthBytes > 0) &&
+                        (chunkLength > pGenerator->mix.chunkLengthBytes)) {
+                        chunkLength = pGenerator->mix.chunkLengthBytes;
+                    }
+                    if (uGnssPrivateStreamAddRingBuffer(pInstance, pGenerator->pBuffer + x,
+                                                        chunkLength) < 0) {
+                        // No room: drop it, as a UART would on overrun
+                        pGenerator->numBytesDropped += chunkLength;
+                    }
+                }
+                if (length < 0) {
+                    errorCodeOrEpochs = length;
+                }
+                if (errorCodeOrEpochs >= 0) {
+                    errorCodeOrEpochs++;
+                    if (epochPeriodMs > 0) {
+                        // Wait until the next epoch is due
+                        waitMs = (errorCodeOrEpochs * epochPeriodMs) -
+                                 (uPortGetTickTimeMs() - startTimeMs);
+                        if (waitMs > 0) {
+                            uPortTaskBlock(waitMs);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return errorCodeOrEpochs;
+}
+
+// End of file
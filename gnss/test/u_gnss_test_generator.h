@@ -0,0 +1,195 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_TEST_GENERATOR_H_
+#define _U_GNSS_TEST_GENERATOR_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** @file
+ * @brief A generator of synthetic GNSS data for testing: it produces
+ * valid UBX-NAV-PVT, UBX-RXM-RAWX, NMEA and RTCM3 messages, interleaved
+ * in a configurable mix, one epoch at a time, and can feed them at a
+ * configurable rate into the ring buffer of a GNSS instance that has
+ * no GNSS chip behind it (a "virtual stream"), so that the message
+ * pipeline (uGnssPrivateStreamFillRingBuffer(), the non-blocking
+ * message receive task and the decoders) can be benchmarked with
+ * repeatable input.  The output is deterministic: the same mix
+ * always produces the same bytes.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_GNSS_TEST_GENERATOR_VIRTUAL_UART_HANDLE
+/** The UART handle given to uGnssAddWithBuffers() for a virtual
+ * stream; it must be one that is never opened so that
+ * uGnssPrivateStreamFillRingBuffer() finds nothing to read.
+ */
+# define U_GNSS_TEST_GENERATOR_VIRTUAL_UART_HANDLE -1
+#endif
+
+/** The maximum number of measurements in a generated UBX-RXM-RAWX.
+ */
+#define U_GNSS_TEST_GENERATOR_RAWX_NUM_MEAS_MAX 64
+
+/** The maximum length of the body of a generated RTCM3 message.
+ */
+#define U_GNSS_TEST_GENERATOR_RTCM_BODY_LENGTH_MAX_BYTES 1023
+
+/** The default mix: roughly what an M9 configured for RTK logging
+ * puts out at each epoch.
+ */
+#define U_GNSS_TEST_GENERATOR_MIX_DEFAULTS {1, 1, 32, 8, 4, 200, 256}
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The kinds of message that the generator produces.
+ */
+typedef enum {
+    U_GNSS_TEST_GENERATOR_KIND_NAV_PVT,
+    U_GNSS_TEST_GENERATOR_KIND_RXM_RAWX,
+    U_GNSS_TEST_GENERATOR_KIND_NMEA,
+    U_GNSS_TEST_GENERATOR_KIND_RTCM,
+    U_GNSS_TEST_GENERATOR_KIND_MAX_NUM
+} uGnssTestGeneratorKind_t;
+
+/** The mix of messages in each epoch; the messages are interleaved,
+ * one of each kind in turn, until the numbers for the epoch are
+ * used up.
+ */
+typedef struct {
+    size_t numNavPvt;              /**< UBX-NAV-PVT messages per epoch. */
+    size_t numRxmRawx;             /**< UBX-RXM-RAWX messages per epoch. */
+    size_t rxmRawxNumMeas;         /**< measurements in each UBX-RXM-RAWX,
+                                        at most
+                                        #U_GNSS_TEST_GENERATOR_RAWX_NUM_MEAS_MAX. */
+    size_t numNmea;                /**< NMEA sentences per epoch, cycling
+                                        through GGA, RMC, GSA and GSV. */
+    size_t numRtcm;                /**< RTCM3 messages per epoch, cycling
+                                        through types 1005, 1077, 1087,
+                                        1097, 1127 and 1230. */
+    size_t rtcmBodyLengthBytes;    /**< the length of the body of each
+                                        RTCM3 message, 6 to
+                                        #U_GNSS_TEST_GENERATOR_RTCM_BODY_LENGTH_MAX_BYTES. */
+    size_t chunkLengthBytes;       /**< the size of the pieces in which an
+                                        epoch is added to the ring buffer,
+                                        like a UART driver delivering it;
+                                        zero for a whole epoch at once. */
+} uGnssTestGeneratorMix_t;
+
+/** The state of a generator; the counts may be read at any time by
+ * the owner of the generator.
+ */
+typedef struct {
+    uGnssTestGeneratorMix_t mix;
+    char *pBuffer;                 /**< a buffer big enough for one epoch. */
+    size_t bufferLengthBytes;
+    uint32_t epoch;                /**< the number of epochs generated. */
+    int32_t latitudeX1e7;          /**< the position in the last NAV-PVT. */
+    int32_t longitudeX1e7;
+    size_t numMessages[U_GNSS_TEST_GENERATOR_KIND_MAX_NUM]; /**< messages
+                                                                 generated. */
+    size_t numBytes;               /**< bytes generated. */
+    size_t numBytesDropped;        /**< bytes that uGnssTestGeneratorFeed()
+                                        could not add to the ring buffer
+                                        because it was full. */
+    size_t nmeaIndex;              /**< where we are in the NMEA cycle. */
+    size_t rtcmIndex;              /**< where we are in the RTCM cycle. */
+    uint32_t pseudoRandom;         /**< for the filling of RTCM bodies. */
+} uGnssTestGenerator_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Initialise a generator, allocating a buffer for an epoch.
+ *
+ * @param[out] pGenerator a pointer to the generator, cannot be NULL.
+ * @param[in] pMix        the mix of messages, cannot be NULL; this is
+ *                        copied.
+ * @return                zero on success else negative error code.
+ */
+int32_t uGnssTestGeneratorInit(uGnssTestGenerator_t *pGenerator,
+                               const uGnssTestGeneratorMix_t *pMix);
+
+/** Free the buffer of a generator.
+ *
+ * @param[in] pGenerator a pointer to the generator.
+ */
+void uGnssTestGeneratorDeinit(uGnssTestGenerator_t *pGenerator);
+
+/** Generate the next epoch into the buffer of the generator.
+ *
+ * @param[in] pGenerator a pointer to the generator, cannot be NULL.
+ * @return               the number of bytes at pGenerator->pBuffer
+ *                       else negative error code.
+ */
+int32_t uGnssTestGeneratorEpoch(uGnssTestGenerator_t *pGenerator);
+
+/** Add a GNSS instance with a virtual stream, i.e. a UART transport
+ * whose handle is #U_GNSS_TEST_GENERATOR_VIRTUAL_UART_HANDLE, for use
+ * with uGnssTestGeneratorFeed(); uGnssInit() must have been called.
+ * Remove it with uGnssRemove() as normal.
+ *
+ * @param moduleType            the module type to pretend to be.
+ * @param ringBufferLengthBytes the length of the ring buffer, zero for
+ *                              the default.
+ * @param[out] pGnssHandle      a place to put the handle of the GNSS
+ *                              instance, cannot be NULL.
+ * @return                      zero on success else negative error code.
+ */
+int32_t uGnssTestGeneratorAdd(uGnssModuleType_t moduleType,
+                              size_t ringBufferLengthBytes,
+                              uDeviceHandle_t *pGnssHandle);
+
+/** Feed epochs from a generator into the ring buffer of a GNSS
+ * instance, as if they had been received from the GNSS chip, at a
+ * fixed rate; this blocks until the epochs have been fed.  Should
+ * the ring buffer be full, the data that does not fit is dropped,
+ * as it would be by a UART on overrun, and counted in the
+ * numBytesDropped field of the generator.
+ *
+ * @param gnssHandle     the handle of the GNSS instance, usually one
+ *                       added with uGnssTestGeneratorAdd().
+ * @param[in] pGenerator a pointer to the generator, cannot be NULL.
+ * @param numEpochs      the number of epochs to feed.
+ * @param epochPeriodMs  the period between epochs in milliseconds;
+ *                       zero to feed them as fast as possible.
+ * @return               the number of epochs fed, else negative error
+ *                       code.
+ */
+int32_t uGnssTestGeneratorFeed(uDeviceHandle_t gnssHandle,
+                               uGnssTestGenerator_t *pGenerator,
+                               int32_t numEpochs, int32_t epochPeriodMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_GNSS_TEST_GENERATOR_H_
+
+// End of file
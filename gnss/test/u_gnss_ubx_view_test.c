@@ -0,0 +1,277 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the UBX message view accessors: these should pass
+ * on all platforms and do not require a GNSS module.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy(), memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_ubx_protocol.h"
+
+#include "u_gnss_ubx_view.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_UBX_VIEW_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The number of satellites to put in the UBX-NAV-SAT message.
+ */
+#define U_GNSS_UBX_VIEW_TEST_NUM_SVS 3
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Buffer for an encoded message, big enough for the largest.
+ */
+static char gBuffer[U_GNSS_UBX_NAV_SAT_BODY_LENGTH_BYTES(U_GNSS_UBX_VIEW_TEST_NUM_SVS) +
+                                                         U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Write a uint16_t, little-endian, at the given offset.
+static void putUint16(char *pBody, size_t offset, uint16_t value)
+{
+    value = uUbxProtocolUint16Encode(value);
+    memcpy(pBody + offset, &value, sizeof(value));
+}
+
+// Write a uint32_t, little-endian, at the given offset.
+static void putUint32(char *pBody, size_t offset, uint32_t value)
+{
+    value = uUbxProtocolUint32Encode(value);
+    memcpy(pBody + offset, &value, sizeof(value));
+}
+
+// Write a float, little-endian, at the given offset.
+static void putFloat(char *pBody, size_t offset, float value)
+{
+    uint32_t uint32;
+
+    memcpy(&uint32, &value, sizeof(uint32));
+    putUint32(pBody, offset, uint32);
+}
+
+// Write a double, little-endian, at the given offset.
+static void putDouble(char *pBody, size_t offset, double value)
+{
+    uint64_t uint64;
+
+    memcpy(&uint64, &value, sizeof(uint64));
+    uint64 = uUbxProtocolUint64Encode(uint64);
+    memcpy(pBody + offset, &uint64, sizeof(uint64));
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Encode a UBX-NAV-PVT message field by field, then check that
+ * the accessors read every value back, including the signed ones.
+ */
+U_PORT_TEST_FUNCTION("[gnssUbxView]", "gnssUbxViewNavPvt")
+{
+    char body[U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES];
+    const char *pBody;
+    int32_t length;
+
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES == 92);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_OFFSET_LAT == 28);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_OFFSET_MAG_ACC == 90);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_SCALE_LAT == -7);
+
+    memset(body, 0, sizeof(body));
+    putUint32(body, U_GNSS_UBX_NAV_PVT_OFFSET_ITOW, 0x12345678);
+    putUint16(body, U_GNSS_UBX_NAV_PVT_OFFSET_YEAR, 2026);
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_MONTH] = 10;
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_DAY] = 15;
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_HOUR] = 23;
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_MIN] = 59;
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_SEC] = 60;
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_VALID] = U_GNSS_UBX_NAV_PVT_VALID_DATE_TIME;
+    putUint32(body, U_GNSS_UBX_NAV_PVT_OFFSET_NANO, (uint32_t) -999999);
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_FIX_TYPE] = 3;
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_FLAGS] = U_GNSS_UBX_NAV_PVT_FLAGS_GNSS_FIX_OK;
+    body[U_GNSS_UBX_NAV_PVT_OFFSET_NUM_SV] = 12;
+    putUint32(body, U_GNSS_UBX_NAV_PVT_OFFSET_LON, (uint32_t) -1234567890);
+    putUint32(body, U_GNSS_UBX_NAV_PVT_OFFSET_LAT, 523456789);
+    putUint32(body, U_GNSS_UBX_NAV_PVT_OFFSET_H_MSL, (uint32_t) -430000);
+    putUint32(body, U_GNSS_UBX_NAV_PVT_OFFSET_H_ACC, 0xfedcba98);
+    putUint32(body, U_GNSS_UBX_NAV_PVT_OFFSET_VEL_D, (uint32_t) -5);
+    putUint16(body, U_GNSS_UBX_NAV_PVT_OFFSET_P_DOP, 0xabcd);
+    putUint16(body, U_GNSS_UBX_NAV_PVT_OFFSET_MAG_DEC, (uint16_t) -1234);
+    putUint16(body, U_GNSS_UBX_NAV_PVT_OFFSET_MAG_ACC, 321);
+
+    // Wrap it in a UBX message and read it back through the view
+    length = uUbxProtocolEncode(U_GNSS_UBX_NAV_PVT_CLASS, U_GNSS_UBX_NAV_PVT_ID,
+                                body, sizeof(body), gBuffer);
+    U_TEST_PRINT_LINE("encoded UBX-NAV-PVT is %d byte(s).", (int) length);
+    U_PORT_TEST_ASSERT(length == sizeof(body) + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_VIEW_BODY_LENGTH(gBuffer) == sizeof(body));
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(length, U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES));
+    // The checksum is not part of the body
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(length - 2,
+                                                       U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES));
+    U_PORT_TEST_ASSERT(!U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(length - 3,
+                                                        U_GNSS_UBX_NAV_PVT_BODY_LENGTH_BYTES));
+    pBody = U_GNSS_UBX_VIEW_BODY(gBuffer);
+
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_ITOW(pBody) == 0x12345678);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_YEAR(pBody) == 2026);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_MONTH(pBody) == 10);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_DAY(pBody) == 15);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_HOUR(pBody) == 23);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_MIN(pBody) == 59);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_SEC(pBody) == 60);
+    U_PORT_TEST_ASSERT((U_GNSS_UBX_NAV_PVT_VALID(pBody) & U_GNSS_UBX_NAV_PVT_VALID_DATE_TIME) ==
+                       U_GNSS_UBX_NAV_PVT_VALID_DATE_TIME);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_T_ACC(pBody) == 0);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_NANO(pBody) == -999999);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_FIX_TYPE(pBody) == 3);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_FLAGS(pBody) & U_GNSS_UBX_NAV_PVT_FLAGS_GNSS_FIX_OK);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_NUM_SV(pBody) == 12);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_LON(pBody) == -1234567890);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_LAT(pBody) == 523456789);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_HEIGHT(pBody) == 0);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_H_MSL(pBody) == -430000);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_H_ACC(pBody) == 0xfedcba98);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_VEL_D(pBody) == -5);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_P_DOP(pBody) == 0xabcd);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_MAG_DEC(pBody) == -1234);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_PVT_MAG_ACC(pBody) == 321);
+}
+
+/** Encode a UBX-NAV-SAT message with several per-satellite blocks
+ * and a UBX-RXM-RAWX body, then check that the accessors read the
+ * values back from the right block.
+ */
+U_PORT_TEST_FUNCTION("[gnssUbxView]", "gnssUbxViewBlocks")
+{
+    char body[U_GNSS_UBX_NAV_SAT_BODY_LENGTH_BYTES(U_GNSS_UBX_VIEW_TEST_NUM_SVS)];
+    char rawx[U_GNSS_UBX_RXM_RAWX_BODY_LENGTH_BYTES(1)];
+    char *pBlock;
+    const char *pBody;
+    int32_t length;
+
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_HEAD_LENGTH_BYTES == 8);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_BLOCK_LENGTH_BYTES == 12);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_HEAD_LENGTH_BYTES == 16);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_BLOCK_LENGTH_BYTES == 32);
+
+    memset(body, 0, sizeof(body));
+    putUint32(body, U_GNSS_UBX_NAV_SAT_OFFSET_ITOW, 86400000);
+    body[U_GNSS_UBX_NAV_SAT_OFFSET_VERSION] = 1;
+    body[U_GNSS_UBX_NAV_SAT_OFFSET_NUM_SVS] = U_GNSS_UBX_VIEW_TEST_NUM_SVS;
+    for (size_t x = 0; x < U_GNSS_UBX_VIEW_TEST_NUM_SVS; x++) {
+        pBlock = U_GNSS_UBX_NAV_SAT_BLOCK(body, x);
+        pBlock[U_GNSS_UBX_NAV_SAT_BLOCK_OFFSET_GNSS_ID] = (char) x;
+        pBlock[U_GNSS_UBX_NAV_SAT_BLOCK_OFFSET_SV_ID] = (char) (x + 10);
+        pBlock[U_GNSS_UBX_NAV_SAT_BLOCK_OFFSET_CNO] = (char) (x + 40);
+        pBlock[U_GNSS_UBX_NAV_SAT_BLOCK_OFFSET_ELEV] = (char) (int8_t) (-90 + x);
+        putUint16(pBlock, U_GNSS_UBX_NAV_SAT_BLOCK_OFFSET_AZIM, (uint16_t) (180 - x));
+        putUint16(pBlock, U_GNSS_UBX_NAV_SAT_BLOCK_OFFSET_PR_RES, (uint16_t) (-100 - (int32_t) x));
+        putUint32(pBlock, U_GNSS_UBX_NAV_SAT_BLOCK_OFFSET_FLAGS, 0x80000000 | x);
+    }
+
+    length = uUbxProtocolEncode(U_GNSS_UBX_NAV_SAT_CLASS, U_GNSS_UBX_NAV_SAT_ID,
+                                body, sizeof(body), gBuffer);
+    U_TEST_PRINT_LINE("encoded UBX-NAV-SAT is %d byte(s).", (int) length);
+    U_PORT_TEST_ASSERT(length == sizeof(gBuffer));
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(length,
+                                                       U_GNSS_UBX_NAV_SAT_BODY_LENGTH_BYTES(U_GNSS_UBX_VIEW_TEST_NUM_SVS)));
+    U_PORT_TEST_ASSERT(!U_GNSS_UBX_VIEW_IS_LONG_ENOUGH(length,
+                                                        U_GNSS_UBX_NAV_SAT_BODY_LENGTH_BYTES(U_GNSS_UBX_VIEW_TEST_NUM_SVS + 1)));
+    pBody = U_GNSS_UBX_VIEW_BODY(gBuffer);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_ITOW(pBody) == 86400000);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_VERSION(pBody) == 1);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_NUM_SVS(pBody) == U_GNSS_UBX_VIEW_TEST_NUM_SVS);
+    for (size_t x = 0; x < U_GNSS_UBX_VIEW_TEST_NUM_SVS; x++) {
+        const char *pSat = U_GNSS_UBX_NAV_SAT_BLOCK(pBody, x);
+        U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_GNSS_ID(pSat) == x);
+        U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_SV_ID(pSat) == x + 10);
+        U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_CNO(pSat) == x + 40);
+        U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_ELEV(pSat) == -90 + (int32_t) x);
+        U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_AZIM(pSat) == 180 - (int32_t) x);
+        U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_PR_RES(pSat) == -100 - (int32_t) x);
+        U_PORT_TEST_ASSERT(U_GNSS_UBX_NAV_SAT_FLAGS(pSat) == (0x80000000 | x));
+    }
+
+    // The R8 and R4 fields of UBX-RXM-RAWX
+    memset(rawx, 0, sizeof(rawx));
+    putDouble(rawx, U_GNSS_UBX_RXM_RAWX_OFFSET_RCV_TOW, 123456.789);
+    putUint16(rawx, U_GNSS_UBX_RXM_RAWX_OFFSET_WEEK, 2400);
+    rawx[U_GNSS_UBX_RXM_RAWX_OFFSET_LEAP_S] = (char) (int8_t) -18;
+    rawx[U_GNSS_UBX_RXM_RAWX_OFFSET_NUM_MEAS] = 1;
+    pBlock = U_GNSS_UBX_RXM_RAWX_BLOCK(rawx, 0);
+    putDouble(pBlock, U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_PR_MES, -21000000.25);
+    putFloat(pBlock, U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_DO_MES, -1500.5f);
+    putUint16(pBlock, U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_LOCKTIME, 64500);
+    pBlock[U_GNSS_UBX_RXM_RAWX_BLOCK_OFFSET_TRK_STAT] = 0x0f;
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_RCV_TOW(rawx) == 123456.789);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_WEEK(rawx) == 2400);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_LEAP_S(rawx) == -18);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_NUM_MEAS(rawx) == 1);
+    pBody = U_GNSS_UBX_RXM_RAWX_BLOCK(rawx, 0);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_PR_MES(pBody) == -21000000.25);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_CP_MES(pBody) == 0);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_DO_MES(pBody) == -1500.5f);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_LOCKTIME(pBody) == 64500);
+    U_PORT_TEST_ASSERT(U_GNSS_UBX_RXM_RAWX_TRK_STAT(pBody) == 0x0f);
+}
+
+// End of file
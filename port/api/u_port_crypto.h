@@ -73,6 +73,44 @@ int32_t uPortCryptoSha256(const char *pInput,
                           size_t inputLengthBytes,
                           char *pOutput);
 
+/** Start a SHA256 calculation on data that is too large to hold
+ * in one block, e.g. a firmware image; feed the data in with
+ * uPortCryptoSha256Update() and obtain the result with
+ * uPortCryptoSha256Finish(), which must be called to free the
+ * context even if the result is not wanted.
+ *
+ * @param[out] ppContext a place to put the context of the
+ *                       calculation; cannot be NULL.
+ * @return               zero on success else negative error code.
+ */
+int32_t uPortCryptoSha256Start(void **ppContext);
+
+/** Add data to a SHA256 calculation begun with
+ * uPortCryptoSha256Start().
+ *
+ * @param[in] pContext     the context returned by
+ *                         uPortCryptoSha256Start().
+ * @param pInput           a pointer to the input data; cannot be
+ *                         NULL unless inputLengthBytes is zero.
+ * @param inputLengthBytes the length of the input data.
+ * @return                 zero on success else negative error code.
+ */
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes);
+
+/** Complete a SHA256 calculation begun with
+ * uPortCryptoSha256Start(), freeing the context.
+ *
+ * @param[in] pContext the context returned by
+ *                     uPortCryptoSha256Start().
+ * @param[out] pOutput a pointer to at least 32 bytes of space
+ *                     to which the output will be written; may be
+ *                     NULL if only the context is to be freed.
+ * @return             zero on success else negative error code.
+ */
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput);
+
 /** Perform a HMAC SHA256 calculation on a block of data.
  *
  * @param pKey             a pointer to the key; cannot be NULL.
@@ -49,10 +49,100 @@ extern "C" {
 # define uPortLog(...)
 #endif
 
+#ifndef U_PORT_PROFILE_MAX_NUM_PROBES
+/** The maximum number of profiling probes that can be registered,
+ * only relevant if #U_CFG_PROFILE is defined; probes beyond this
+ * number are still timed but are not printed by uPortProfilePrint().
+ */
+# define U_PORT_PROFILE_MAX_NUM_PROBES 16
+#endif
+
+#ifdef U_CFG_PROFILE
+/* Define #U_CFG_PROFILE to enable the profiling probes: the probes
+ * read the cycle counter of the core, the DWT cycle counter on
+ * Cortex-M3/M4/M7/M33 and the CCOUNT register on Xtensa, else
+ * uPortProfileCyclesGet(), which the platform may override; for
+ * a probe to cost only a couple of instructions the cycle
+ * counter is read inline.
+ */
+# if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#  define U_PORT_PROFILE_CYCLES() (*((volatile uint32_t *) 0xE0001004UL))
+# elif defined(__XTENSA__)
+#  define U_PORT_PROFILE_CYCLES() \
+              __extension__ ({uint32_t _c; __asm__ __volatile__("rsr %0, ccount" : "=a" (_c)); _c;})
+# else
+#  define U_PORT_PROFILE_CYCLES() uPortProfileCyclesGet()
+# endif
+
+/** Define a profiling probe; place this at file scope, e.g.
+ * U_PORT_PROFILE_PROBE(myThing);
+ */
+# define U_PORT_PROFILE_PROBE(name) \
+             static uPortProfileProbe_t gUPortProfileProbe_##name = {#name, 0, 0, 0, 0, 0, 0}
+
+/** Begin a profiled section, within the same block as the
+ * matching U_PORT_PROFILE_END(); this declares a variable
+ * so it must be placed where a declaration is allowed.
+ */
+# define U_PORT_PROFILE_BEGIN(name) \
+             uint32_t uPortProfileStart_##name = U_PORT_PROFILE_CYCLES()
+
+/** End a profiled section, counting units (e.g. bytes) against
+ * it so that the cost per unit can be printed.
+ */
+# define U_PORT_PROFILE_END(name, units) \
+             uPortProfileProbeAdd(&gUPortProfileProbe_##name, \
+                                  U_PORT_PROFILE_CYCLES() - uPortProfileStart_##name, \
+                                  (uint32_t) (units))
+#else
+# define U_PORT_PROFILE_PROBE(name) struct uPortProfileUnused_##name
+# define U_PORT_PROFILE_BEGIN(name)
+# define U_PORT_PROFILE_END(name, units)
+#endif
+
+#ifdef U_CFG_SPAN_TRACE
+/* Define #U_CFG_SPAN_TRACE to enable the timed spans, which are
+ * only supported on the Windows and Linux platforms: each span,
+ * e.g. an AT command, a URC, a socket read, a GNSS message being
+ * dispatched or an event queue handler, is written, with the
+ * thread it ran in, to the file opened with uPortSpanTraceOpen()
+ * in Chrome trace format, which may be loaded into chrome://tracing
+ * or https://ui.perfetto.dev to see how the tasks interleave.
+ */
+
+/** Begin a timed span; pName may be any string, e.g. an AT
+ * command, it is escaped as necessary.  Spans must be ended in the reverse
+ * order to that in which they were begun, by the same task.
+ */
+# define U_PORT_SPAN_BEGIN(pName) uPortSpanBegin(pName)
+
+/** End the most recently begun timed span of this task.
+ */
+# define U_PORT_SPAN_END() uPortSpanEnd()
+#else
+# define U_PORT_SPAN_BEGIN(pName)
+# define U_PORT_SPAN_END()
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A profiling probe, defined with U_PORT_PROFILE_PROBE(); the
+ * fields are updated without locking so, where the same section is
+ * run by more than one task at the same time, the figures are
+ * approximate.
+ */
+typedef struct {
+    const char *pName;
+    volatile uint32_t registered;
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint64_t totalUnits;
+} uPortProfileProbe_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -82,6 +172,73 @@ int32_t uPortLogOff(void);
  */
 int32_t uPortLogOn(void);
 
+/** Add a sample to a profiling probe; this function is not usually
+ * called directly, please use U_PORT_PROFILE_BEGIN() and
+ * U_PORT_PROFILE_END() instead so that #U_CFG_PROFILE controls
+ * whether profiling is on or off.  The first sample of a probe
+ * registers it and is discarded, since on some platforms that is
+ * when the cycle counter is started.
+ *
+ * @param[in] pProbe the probe.
+ * @param cycles     the number of cycles the section took.
+ * @param units      the number of units (e.g. bytes) processed.
+ */
+void uPortProfileProbeAdd(uPortProfileProbe_t *pProbe, uint32_t cycles,
+                          uint32_t units);
+
+/** Get the cycle count where the core has no cycle counter that the
+ * profiling probes know how to read inline; the default
+ * implementation returns the tick time in milliseconds, a platform
+ * may override it with something more useful.
+ *
+ * @return a free-running count, wrapping at 32 bits.
+ */
+uint32_t uPortProfileCyclesGet(void);
+
+/** Print the figures for all of the profiling probes that have
+ * been registered, using uPortLog(): number of samples, minimum,
+ * maximum and average cycles per sample and average cycles per unit.
+ */
+void uPortProfilePrint(void);
+
+/** Reset the figures of all of the profiling probes.
+ */
+void uPortProfileReset(void);
+
+/** Open a file to which the timed spans, see #U_CFG_SPAN_TRACE,
+ * will be written, in Chrome trace format, closing any file that
+ * was already open; spans that begin or end while no file is open
+ * are ignored.  Only implemented on Windows and Linux, where the
+ * spans are time-stamped to the microsecond with the high
+ * resolution timer of the host.
+ *
+ * @param[in] pFileName the name of the file, which will be
+ *                      overwritten if it exists.
+ * @return              zero on success else negative error code.
+ */
+int32_t uPortSpanTraceOpen(const char *pFileName);
+
+/** Close the file opened with uPortSpanTraceOpen(); if no file is
+ * open this does nothing.  Only implemented on Windows and Linux.
+ */
+void uPortSpanTraceClose(void);
+
+/** Begin a timed span; this function is not usually called
+ * directly, please use U_PORT_SPAN_BEGIN() instead so that
+ * #U_CFG_SPAN_TRACE controls whether span tracing is on or off.
+ * Only implemented on Windows and Linux.
+ *
+ * @param[in] pName the name of the span.
+ */
+void uPortSpanBegin(const char *pName);
+
+/** End the most recently begun timed span of this task; this
+ * function is not usually called directly, please use
+ * U_PORT_SPAN_END() instead.  Only implemented on Windows
+ * and Linux.
+ */
+void uPortSpanEnd(void);
+
 #ifdef __cplusplus
 }
 #endif
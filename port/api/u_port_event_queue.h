@@ -83,10 +83,33 @@
  * repeated as necessary. `uPortEventQueueSendIrq()` is
  * a version which is safe to call from an interrupt.
  *
+ * Where the parameter block is large, or is already in memory
+ * that `myFunction()` could simply be given, `uPortEventQueueSendRef()`
+ * puts only a pointer to the block on the queue: `myFunction()`
+ * is called with the block itself and, when it returns, the
+ * block is given back to whoever owns it (e.g. a pool from
+ * u_mempool.h) through a free function provided with the block.
+ * Nothing is copied and no memory is allocated on the way.
+ *
  * `uPortEventQueueClose()` shuts down the queue and deletes
  * the task.  This is a cooperative process: your function
  * must have emptied the queue and exited for shut-down to
  * complete.
+ *
+ * If #U_PORT_EVENT_QUEUE_POOL_NUM_TASKS is set to a non-zero
+ * value then, rather than each event queue having a task of its
+ * own, any event queue which asks for no more stack than
+ * #U_PORT_EVENT_QUEUE_POOL_STACK_SIZE_BYTES and no higher priority
+ * than #U_PORT_EVENT_QUEUE_POOL_PRIORITY is instead served by a
+ * shared pool of that many worker tasks; event queues which need
+ * more continue to have a task of their own.  The calls to a given
+ * event queue's function remain in the order they were sent and
+ * are never run concurrently, but the pool can only run as many
+ * event queue functions at once as it has worker tasks, so the
+ * pool should be sized for the number of event queue functions
+ * which might block at the same time: if the function of one
+ * event queue waits for the function of another to run, and all
+ * the workers are taken, neither will proceed.
  */
 
 #ifdef __cplusplus
@@ -110,9 +133,11 @@ extern "C" {
 # define U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES 128
 #endif
 
-/** The length of uEventQueueControlOrSize_t (see implementation).
+/** The length of the header that is prefixed to each parameter
+ * block on the OS queue: uEventQueueControlOrSize_t followed by
+ * the time at which the block was sent (see implementation).
  */
-#define U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES 4
+#define U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES 8
 
 #ifndef U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES
 /** The minimum stack size for an event queue task.
@@ -122,10 +147,82 @@ extern "C" {
                            U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES
 #endif
 
+#ifndef U_PORT_EVENT_QUEUE_HIGH_PRIORITY_QUEUE_LENGTH
+/** The number of events sent with uPortEventQueueSendHighPriority()
+ * that each event queue can hold; zero means that there is no
+ * separate high priority queue, uPortEventQueueSendHighPriority()
+ * then behaving the same as uPortEventQueueSend().
+ */
+# define U_PORT_EVENT_QUEUE_HIGH_PRIORITY_QUEUE_LENGTH 2
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_BATCH_MAX_NUM
+/** The maximum number of events that an event queue will handle
+ * in one batch, i.e. without checking for high priority events;
+ * 1, the default, means a high priority event never waits behind
+ * more than the event being handled.  A larger number saves
+ * checking the high priority queue for every event at the cost of
+ * high priority events waiting behind up to this many others.
+ */
+# define U_PORT_EVENT_QUEUE_BATCH_MAX_NUM 1
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_POOL_NUM_TASKS
+/** The number of worker tasks in the shared pool that serves event
+ * queues, see the description at the top of this file; zero, the
+ * default, means that there is no pool and every event queue has a
+ * task of its own.
+ */
+# define U_PORT_EVENT_QUEUE_POOL_NUM_TASKS 0
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_POOL_STACK_SIZE_BYTES
+/** The stack size of each worker task in the pool; an event queue
+ * that is opened with a larger stack size than this has a task of
+ * its own.
+ */
+# define U_PORT_EVENT_QUEUE_POOL_STACK_SIZE_BYTES 2304
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_POOL_PRIORITY
+/** The priority of the worker tasks in the pool; an event queue that
+ * is opened with a higher priority than this has a task of its own,
+ * one opened with the same or a lower priority is run at this priority.
+ */
+# define U_PORT_EVENT_QUEUE_POOL_PRIORITY (U_CFG_OS_PRIORITY_MAX - 5)
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_POOL_QUEUE_LENGTH
+/** The length of the queue on which the worker tasks in the pool
+ * are told that an event queue has something for them; there is
+ * one entry on this queue for each event waiting on any of the event
+ * queues served by the pool, so it should be at least as long as
+ * the number of events those event queues may hold in total.
+ */
+# define U_PORT_EVENT_QUEUE_POOL_QUEUE_LENGTH 32
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Statistics for an event queue, see uPortEventQueueGetStats();
+ * counted from when the event queue was opened.
+ */
+typedef struct {
+    uint32_t numEvents;             /**< the number of events handled, including
+                                         high priority events. */
+    uint32_t numHighPriorityEvents; /**< the number of events handled that were
+                                         sent with uPortEventQueueSendHighPriority(). */
+    int32_t latencyAverageMs;       /**< the average time from an event being
+                                         sent to it being handled. */
+    int32_t latencyMaxMs;           /**< the largest time from an event being
+                                         sent to it being handled. */
+    size_t batchSizeMax;            /**< the largest number of events handled
+                                         in one batch, see
+                                         #U_PORT_EVENT_QUEUE_BATCH_MAX_NUM. */
+} uPortEventQueueStats_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -145,7 +242,13 @@ extern "C" {
  * @param stackSizeBytes       the stack size of the task that the
  *                             function will be run in, must be
  *                             at least
- *                             #U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES.
+ *                             #U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES;
+ *                             if this is no more than
+ *                             #U_PORT_EVENT_QUEUE_POOL_STACK_SIZE_BYTES,
+ *                             and there is a pool (see
+ *                             #U_PORT_EVENT_QUEUE_POOL_NUM_TASKS),
+ *                             the function may be run by a worker
+ *                             task of the pool instead.
  * @param priority             the priority of the task that the
  *                             function will be run in; see
  *                             u_cfg_os_platform_specific.h for
@@ -201,11 +304,37 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
 int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
                             size_t paramLengthBytes);
 
+/** Send to an event queue at high priority: the event is handled
+ * ahead of any events sent with uPortEventQueueSend() or
+ * uPortEventQueueSendIrq() that have not yet been handled, see
+ * also #U_PORT_EVENT_QUEUE_BATCH_MAX_NUM; high priority events
+ * are handled in the order they were sent.  Use this for rare,
+ * important, events (e.g. a disconnection) that should not wait
+ * behind a queue of routine ones (e.g. data arriving).  If the
+ * high priority queue, of length
+ * #U_PORT_EVENT_QUEUE_HIGH_PRIORITY_QUEUE_LENGTH, is full this
+ * function will block until room is available.  An event queue
+ * should not be closed while this function is in progress.
+ *
+ * @param handle            the handle for the event queue.
+ * @param[in] pParam        a pointer to the parameters structure
+ *                          to send.  May be NULL, in which case
+ *                          paramLengthBytes must be zero.
+ * @param paramLengthBytes  the length of the parameters
+ *                          structure.  Must be less than or
+ *                          equal to paramMaxLengthBytes as
+ *                          given to uPortEventQueueOpen().
+ * @return                  zero on success else negative error code.
+ */
+int32_t uPortEventQueueSendHighPriority(int32_t handle, const void *pParam,
+                                        size_t paramLengthBytes);
+
 /** Send to an event queue from an interrupt.  The data at
  * pParam will be copied onto the queue.  If the queue is full
  * the event will not be sent and an error will be returned.
  * Note: you must ensure that your interrupt stack is large
- * enough to hold an array of size paramLengthBytes +
+ * enough to hold an array of size paramMaxLengthBytes (as given
+ * to uPortEventQueueOpen()) +
  * #U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES. An event
  * queue should not be closed while this function is in
  * progress.
@@ -223,6 +352,40 @@ int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
 int32_t uPortEventQueueSendIrq(int32_t handle, const void *pParam,
                                size_t paramLengthBytes);
 
+/** Send a block to an event queue by reference: rather than the
+ * block being copied onto the queue, only a pointer to it is, and
+ * the function of the event queue is called with pBlock and
+ * blockLengthBytes themselves.  The block belongs to that function
+ * for the duration of the call; when the function returns the block
+ * is given back by calling pFree(pBlock), so the function must not
+ * keep the pointer.  Typically pBlock would come from a pool, e.g.
+ * one from uMemPoolMalloc() with pFree being uMemPoolFree(), so
+ * that neither the block nor the event involves a copy or the heap.
+ * If the event queue is closed with the event still on it, pFree
+ * is called without the function being called.  The block need
+ * not fit within the paramMaxLengthBytes given to
+ * uPortEventQueueOpen() and there is no interrupt version.  If
+ * the queue is full this function will block until room is
+ * available.  An event queue should not be closed while this
+ * function is in progress.
+ *
+ * @param handle            the handle for the event queue.
+ * @param[in] pBlock        the block to send; cannot be NULL.
+ * @param blockLengthBytes  the length of the block, passed to the
+ *                          function of the event queue as its
+ *                          second parameter.
+ * @param[in] pFree         the function that gives back the block
+ *                          once the function of the event queue
+ *                          is done with it; may be NULL if the block
+ *                          does not need to be given back.
+ * @return                  zero on success else negative error
+ *                          code; on failure the block still belongs
+ *                          to the caller.
+ */
+int32_t uPortEventQueueSendRef(int32_t handle, void *pBlock,
+                               size_t blockLengthBytes,
+                               void (*pFree)(void *));
+
 /** Detect whether the task currently executing is the
  * event task for the given event queue.  Useful if you
  * have code which is called a few levels down from the
@@ -242,10 +405,23 @@ bool uPortEventQueueIsTask(int32_t handle);
  * @param handle   the handle of the queue to check.
  * @return         the minimum stack free for the lifetime
  *                 of the event task in bytes, else
- *                 negative error code.
+ *                 negative error code; where the event
+ *                 queue is served by the pool this is the
+ *                 minimum across all of the worker tasks.
  */
 int32_t uPortEventQueueStackMinFree(int32_t handle);
 
+/** Get the statistics of an event queue: how many events it has
+ * handled and the time they took from being sent to being handled,
+ * which goes with uPortEventQueueStackMinFree() when sizing the
+ * task(s) and queue length of an event queue.
+ *
+ * @param handle      the handle of the event queue.
+ * @param[out] pStats a place to put the statistics, cannot be NULL.
+ * @return            zero on success else negative error code.
+ */
+int32_t uPortEventQueueGetStats(int32_t handle, uPortEventQueueStats_t *pStats);
+
 /** Close an event queue.
  *
  * COMMON CODING ERROR: there is a common coding error
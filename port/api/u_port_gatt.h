@@ -59,6 +59,21 @@ extern "C" {
 
 #define U_PORT_GATT_GAP_INVALID_CONNHANDLE     -1
 
+// LE PHYs, for uPortGattUpdatePhy() and #uPortGattLinkParams_t
+#define U_PORT_GATT_PHY_1M    0x01
+#define U_PORT_GATT_PHY_2M    0x02
+#define U_PORT_GATT_PHY_CODED 0x04
+
+/** The largest link layer payload when LE Data Length Extension
+ * is in use, for uPortGattUpdateDataLength().
+ */
+#define U_PORT_GATT_DATA_LENGTH_MAX_OCTETS 251
+
+/** The time it takes to send #U_PORT_GATT_DATA_LENGTH_MAX_OCTETS
+ * on the 1M PHY in microseconds, for uPortGattUpdateDataLength().
+ */
+#define U_PORT_GATT_DATA_LENGTH_MAX_TIME_US 2120
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -161,6 +176,26 @@ typedef void (*uPortGattGapConnStatusCallback_t)(int32_t connHandle,
  */
 typedef void (*mtuXchangeRespCallback_t)(int32_t connHandle, uint8_t err);
 
+/** Transmit complete callback, see uPortGattNotifyCb() and
+ * uPortGattWriteAttributeCb().
+ *
+ * @param connHandle      handle for GAP connection.
+ * @param pCallbackParam  the parameter given when the data was queued.
+ */
+typedef void (*uPortGattTxCompleteCallback_t)(int32_t connHandle, void *pCallbackParam);
+
+/** Statistics from uPortGattWriteBulk().
+ */
+typedef struct {
+    size_t bytes;           /**< the number of bytes handed to the
+                                 controller. */
+    size_t numPdus;         /**< the number of writes they took. */
+    size_t pdusInFlightMax; /**< the most writes that were queued in
+                                 the BLE stack at any one time. */
+    int32_t durationMs;     /**< how long it took. */
+    int32_t bytesPerSecond; /**< the throughput achieved. */
+} uPortGattWriteBulkStats_t;
+
 /** GATT attribute write callback type.
  *
  * @param connHandle handle for GAP connection.
@@ -340,6 +375,32 @@ typedef uPortGattIter_t (*uPortGattDescriptorDiscoveryCallback_t)(int32_t connHa
                                                                   uPortGattUuid_t *pUuid,
                                                                   uint16_t attrHandle);
 
+/** The link layer parameters of a connection, see
+ * uPortGattGetLinkParams().
+ *
+ *  @param connInterval     connection interval (N*1.25 ms).
+ *  @param connLatency      connection latency, nbr of connection intervals.
+ *  @param linkLossTimeout  link loss timeout in ms.
+ *  @param txDataLength     largest link layer payload that may be sent,
+ *                          27 unless LE Data Length Extension is in use;
+ *                          0 if not known.
+ *  @param rxDataLength     largest link layer payload that may be received;
+ *                          0 if not known.
+ *  @param txPhy            the PHY used to send, a U_PORT_GATT_PHY_xxx
+ *                          value; 0 if not known.
+ *  @param rxPhy            the PHY used to receive, a U_PORT_GATT_PHY_xxx
+ *                          value; 0 if not known.
+ */
+typedef struct {
+    uint16_t connInterval;
+    uint16_t connLatency;
+    uint32_t linkLossTimeout;
+    uint16_t txDataLength;
+    uint16_t rxDataLength;
+    uint8_t  txPhy;
+    uint8_t  rxPhy;
+} uPortGattLinkParams_t;
+
 extern const uPortGattGapParams_t uPortGattGapParamsDefault;
 
 /* ----------------------------------------------------------------
@@ -419,6 +480,60 @@ int32_t uPortGattGetMtu(int32_t connHandle);
 int32_t uPortGattExchangeMtu(int32_t connHandle,
                              mtuXchangeRespCallback_t respCallback);
 
+/** Ask for the connection interval, latency and link loss timeout
+ * of a connection to be changed; the outcome is decided by the
+ * central and the controllers and may be read later with
+ * uPortGattGetLinkParams().
+ *
+ * @param connHandle      connection handle.
+ * @param[in] pGapParams  the connIntervalMin, connIntervalMax, connLatency
+ *                        and linkLossTimeout fields are used, the
+ *                        others are ignored; cannot be NULL.
+ * @return                zero on success else negative error code.
+ */
+int32_t uPortGattUpdateConnParams(int32_t connHandle,
+                                  const uPortGattGapParams_t *pGapParams);
+
+/** Ask for the PHY of a connection to be changed; the outcome is
+ * decided by the controllers and may be read later with
+ * uPortGattGetLinkParams().
+ *
+ * @param connHandle  connection handle.
+ * @param phys        bitmap of the preferred PHYs, made up of
+ *                    U_PORT_GATT_PHY_xxx values.
+ * @return            zero on success else negative error code;
+ *                    #U_ERROR_COMMON_NOT_SUPPORTED if the BLE stack
+ *                    has not been configured to allow it.
+ */
+int32_t uPortGattUpdatePhy(int32_t connHandle, uint8_t phys);
+
+/** Ask for LE Data Length Extension, i.e. a link layer payload
+ * longer than 27 bytes, on a connection; the outcome is decided
+ * by the controllers and may be read later with
+ * uPortGattGetLinkParams().
+ *
+ * @param connHandle  connection handle.
+ * @param txOctets    the wanted link layer payload size, at most
+ *                    #U_PORT_GATT_DATA_LENGTH_MAX_OCTETS.
+ * @param txTimeUs    the wanted maximum time to send a packet in
+ *                    microseconds, at most
+ *                    #U_PORT_GATT_DATA_LENGTH_MAX_TIME_US.
+ * @return            zero on success else negative error code;
+ *                    #U_ERROR_COMMON_NOT_SUPPORTED if the BLE stack
+ *                    has not been configured to allow it.
+ */
+int32_t uPortGattUpdateDataLength(int32_t connHandle, uint16_t txOctets,
+                                  uint16_t txTimeUs);
+
+/** Get the current link layer parameters of a connection.
+ *
+ * @param connHandle    connection handle.
+ * @param[out] pParams  a place to put the parameters; cannot be NULL.
+ * @return              zero on success else negative error code.
+ */
+int32_t uPortGattGetLinkParams(int32_t connHandle,
+                               uPortGattLinkParams_t *pParams);
+
 /** Send characteristic notification.
  *
  * @param connHandle     connection handle.
@@ -469,6 +584,91 @@ int32_t uPortGattGetRemoteAddress(int32_t connHandle, uint8_t *pAddr,
 int32_t uPortGattWriteAttribute(int32_t connHandle, uint16_t handle, const void *pData,
                                 uint16_t len);
 
+/** As uPortGattNotify() but with a callback which is called once the
+ * notification has been handed to the controller for sending; use
+ * this together with uPortGattGetTxBufferCount() to keep several
+ * notifications in flight, so that they may go out in the same
+ * connection event, without ever blocking in the BLE stack for want
+ * of a buffer.  The callback for a connection is that given with the
+ * last call to this function or uPortGattWriteAttributeCb() for it.
+ *
+ * @param connHandle          connection handle.
+ * @param[in] pChar           pointer to characteristic.
+ * @param[in] data            pointer to notification data to send.
+ * @param len                 length of data to send.
+ * @param[in] pCallback       the callback, may be NULL.
+ * @param[in] pCallbackParam  parameter passed to pCallback.
+ * @return                    zero on success else negative error code.
+ */
+int32_t uPortGattNotifyCb(int32_t connHandle,
+                          const uPortGattCharacteristic_t *pChar,
+                          const void *data, uint16_t len,
+                          uPortGattTxCompleteCallback_t pCallback,
+                          void *pCallbackParam);
+
+/** As uPortGattWriteAttribute() but with a callback which is called
+ * once the write has been handed to the controller for sending, see
+ * uPortGattNotifyCb().
+ *
+ * @param connHandle          connection handle.
+ * @param handle              characteristics handle.
+ * @param[in] pData           data to write.
+ * @param len                 length of data.
+ * @param[in] pCallback       the callback, may be NULL.
+ * @param[in] pCallbackParam  parameter passed to pCallback.
+ * @return                    zero on success else negative error code.
+ */
+int32_t uPortGattWriteAttributeCb(int32_t connHandle, uint16_t handle,
+                                  const void *pData, uint16_t len,
+                                  uPortGattTxCompleteCallback_t pCallback,
+                                  void *pCallbackParam);
+
+/** Write a block of data, e.g. a firmware image, to an attribute on
+ * a remote GATT server with writes without response, as fast as the
+ * link allows: the data is split into writes of the largest size the
+ * MTU permits and these are queued back to back, with a completion
+ * callback, until all of the transmit buffers of the BLE stack (see
+ * uPortGattGetTxBufferCount()) are in use, the next write being
+ * queued as soon as one of them has gone to the controller, so that
+ * the controller always has something to send.  This function
+ * blocks until all of the writes have gone to the controller or
+ * timeoutMs has passed.  Note that a write without response is not
+ * acknowledged by the remote GATT server, so any end-to-end flow
+ * control or check of the data is up to the application.
+ *
+ * @param connHandle          connection handle.
+ * @param handle              characteristics handle.
+ * @param[in] pData           the data to write.
+ * @param length              the number of bytes at pData.
+ * @param timeoutMs           the maximum time to spend writing.
+ * @param[in] pCallback       a callback that is called, from the BLE
+ *                            stack, as each write goes to the
+ *                            controller, may be NULL.
+ * @param[in] pCallbackParam  parameter passed to pCallback.
+ * @param[out] pStats         a place to put statistics on the write,
+ *                            including the throughput achieved; may
+ *                            be NULL.
+ * @return                    on success the number of bytes written,
+ *                            which will be less than length if the
+ *                            timeout expired, else negative error code.
+ */
+int32_t uPortGattWriteBulk(int32_t connHandle, uint16_t handle,
+                           const void *pData, size_t length,
+                           int32_t timeoutMs,
+                           uPortGattTxCompleteCallback_t pCallback,
+                           void *pCallbackParam,
+                           uPortGattWriteBulkStats_t *pStats);
+
+/** Get the number of ATT PDUs the BLE stack can have queued for
+ * transmission at any one time, i.e. how many calls to
+ * uPortGattNotifyCb() or uPortGattWriteAttributeCb() may be
+ * outstanding before one of them would have to wait for a buffer.
+ * Note that the buffers are shared by all connections.
+ *
+ * @return the number of transmit buffers, at least 1.
+ */
+int32_t uPortGattGetTxBufferCount(void);
+
 /** Initiate subscription to notifications or indications
  * from characteristic.
  *
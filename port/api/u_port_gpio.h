@@ -39,6 +39,13 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_PORT_GPIO_INTERRUPT_MAX_NUM
+/** The maximum number of GPIO pins that may have an interrupt
+ * set on them, using uPortGpioInterruptSet(), at any one time.
+ */
+# define U_PORT_GPIO_INTERRUPT_MAX_NUM 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -153,6 +160,34 @@ int32_t uPortGpioSet(int32_t pin, int32_t level);
  */
 int32_t uPortGpioGet(int32_t pin);
 
+/** Set or remove an interrupt on a GPIO pin, which should already
+ * have been configured as an input with uPortGpioConfig().  Note
+ * that the pin number is that of the MCU.  Not all platforms
+ * support this: where it is not supported
+ * #U_ERROR_COMMON_NOT_SUPPORTED will be returned.
+ *
+ * IMPORTANT: pCallback is called in INTERRUPT CONTEXT: it must
+ * do as little as possible and must only call functions that
+ * are interrupt-safe, e.g. uPortSemaphoreGiveIrq().
+ *
+ * @param pin             the pin, a positive integer.
+ * @param risingEdge      true if the interrupt should occur on a
+ *                        rising edge, false for a falling edge.
+ * @param[in] pCallback   the callback, which will be given the pin
+ *                        and pCallbackParam; use NULL to remove
+ *                        the interrupt from the pin.
+ * @param[in] pCallbackParam a parameter that will be passed to
+ *                        pCallback; may be NULL.
+ * @return                zero on success else negative error code;
+ *                        #U_ERROR_COMMON_NO_MEMORY if there are
+ *                        already #U_PORT_GPIO_INTERRUPT_MAX_NUM
+ *                        pins with interrupts set.
+ */
+int32_t uPortGpioInterruptSet(int32_t pin, bool risingEdge,
+                              void (*pCallback) (int32_t pin,
+                                                 void *pCallbackParam),
+                              void *pCallbackParam);
+
 #ifdef __cplusplus
 }
 #endif
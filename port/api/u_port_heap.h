@@ -0,0 +1,272 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_PORT_HEAP_H_
+#define _U_PORT_HEAP_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __port
+ *  @{
+ */
+
+/** @file
+ * @brief Porting layer for heap memory: by default ubxlib memory
+ * obtained through these functions comes from malloc() and is
+ * returned with free() but an application may instead provide its own
+ * allocator, e.g. one with a separate heap for ubxlib so that ubxlib
+ * cannot fragment the application's heap, with uPortHeapAllocatorSet().
+ * Every allocation carries a tag saying which part of ubxlib it is for,
+ * which is passed to the allocator and used to keep per-tag statistics.
+ *
+ * If U_CFG_HEAP_TRACKER is defined, each allocation also carries a
+ * small header recording its size and tag, so that the number of bytes
+ * live, and the peak of that, can be kept for each tag, e.g. to find
+ * which part of ubxlib is using the memory, or leaking it; the cost is
+ * U_PORT_HEAP_ARENA_ALIGNMENT_BYTES or so per allocation.
+ *
+ * Also provided here is an arena: memory for the many small allocations
+ * of a single operation is taken from a few large chunks which are
+ * all released in one step at the end of the operation.
+ *
+ * These functions are thread-safe, with the exception of the
+ * arena functions: an arena should be used by only one thread at
+ * a time.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_HEAP_ARENA_CHUNK_SIZE_BYTES
+/** The default size of a chunk of an arena, used where zero is
+ * passed as chunkSizeBytes to uPortHeapArenaInit().
+ */
+# define U_PORT_HEAP_ARENA_CHUNK_SIZE_BYTES 512
+#endif
+
+#ifndef U_PORT_HEAP_ARENA_ALIGNMENT_BYTES
+/** The alignment of every allocation from an arena.
+ */
+# define U_PORT_HEAP_ARENA_ALIGNMENT_BYTES 8
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The tags that say what an allocation is for.
+ */
+typedef enum {
+    U_PORT_HEAP_TAG_NONE = 0,   /**< not attributed to any particular module. */
+    U_PORT_HEAP_TAG_PORT,
+    U_PORT_HEAP_TAG_UTILS,
+    U_PORT_HEAP_TAG_AT_CLIENT,
+    U_PORT_HEAP_TAG_DEVICE,
+    U_PORT_HEAP_TAG_NETWORK,
+    U_PORT_HEAP_TAG_SOCK,
+    U_PORT_HEAP_TAG_SECURITY,
+    U_PORT_HEAP_TAG_MQTT,
+    U_PORT_HEAP_TAG_LOCATION,
+    U_PORT_HEAP_TAG_CELL,
+    U_PORT_HEAP_TAG_GNSS,
+    U_PORT_HEAP_TAG_SHORT_RANGE,
+    U_PORT_HEAP_TAG_WIFI,
+    U_PORT_HEAP_TAG_BLE,
+    U_PORT_HEAP_TAG_APPLICATION, /**< for the application's own use. */
+    U_PORT_HEAP_TAG_MAX_NUM      /**< if you add a tag, add its name to
+                                      gpTagName in u_port_heap.c. */
+} uPortHeapTag_t;
+
+/** An allocator, see uPortHeapAllocatorSet().  Each function is
+ * given the tag the allocation is for and the pParam member of this
+ * structure.  The functions must be thread-safe and must behave as
+ * malloc(), realloc() and free() do, e.g. pFree() must accept NULL.
+ */
+typedef struct {
+    void *(*pAlloc)(size_t sizeBytes, uPortHeapTag_t tag, void *pParam);
+    void *(*pRealloc)(void *pMemory, size_t sizeBytes, uPortHeapTag_t tag,
+                      void *pParam);
+    void (*pFree)(void *pMemory, uPortHeapTag_t tag, void *pParam);
+    void *pParam;
+} uPortHeapAllocator_t;
+
+/** The statistics for a tag, see uPortHeapGetStats().
+ */
+typedef struct {
+    size_t allocCount;    /**< the number of successful allocations. */
+    size_t freeCount;     /**< the number of frees of allocated memory. */
+    size_t failureCount;  /**< the number of allocations that failed. */
+    size_t outstanding;   /**< allocCount less freeCount. */
+    size_t liveBytes;     /**< the number of bytes currently allocated;
+                               always zero if U_CFG_HEAP_TRACKER is not
+                               defined. */
+    size_t liveBytesPeak; /**< the peak of liveBytes; always zero if
+                               U_CFG_HEAP_TRACKER is not defined. */
+} uPortHeapStats_t;
+
+/** A chunk of an arena: not to be accessed directly, use the
+ * functions.
+ */
+typedef struct uPortHeapArenaChunk_t {
+    struct uPortHeapArenaChunk_t *pNext;
+    size_t sizeBytes;  /**< the usable size of the chunk. */
+    size_t usedBytes;  /**< how much has been allocated from the chunk. */
+    bool isStatic;     /**< true if this chunk was not allocated. */
+} uPortHeapArenaChunk_t;
+
+/** An arena, see uPortHeapArenaInit(): not to be accessed directly,
+ * use the functions.
+ */
+typedef struct {
+    uPortHeapArenaChunk_t *pChunkList; /**< the newest chunk first. */
+    size_t chunkSizeBytes;
+    uPortHeapTag_t tag;
+    size_t allocatedBytes;             /**< the total allocated from the
+                                            arena since it was initialised
+                                            or last released. */
+} uPortHeapArena_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Set the allocator that is used by pUPortHeapAlloc(),
+ * pUPortHeapRealloc() and uPortHeapFree().  Memory must be freed
+ * by the allocator that allocated it, hence this may only be done
+ * when nothing is allocated, i.e. it should be called before
+ * uPortInit(), or after uPortDeinit() once all of ubxlib has been
+ * closed down.  This may be called before uPortInit().
+ *
+ * @param[in] pAllocator the allocator to use, which is copied;
+ *                       all of pAlloc, pRealloc and pFree must
+ *                       be non-NULL.  Use NULL to return to using
+ *                       malloc(), realloc() and free().
+ * @return               zero on success else negative error code;
+ *                       #U_ERROR_COMMON_TEMPORARY_FAILURE if anything
+ *                       is currently allocated.
+ */
+int32_t uPortHeapAllocatorSet(const uPortHeapAllocator_t *pAllocator);
+
+/** Allocate memory.  This may be called before uPortInit().
+ *
+ * @param sizeBytes  the number of bytes required.
+ * @param tag        what the memory is for.
+ * @return           a pointer to the memory or NULL on failure.
+ */
+void *pUPortHeapAlloc(size_t sizeBytes, uPortHeapTag_t tag);
+
+/** Change the size of allocated memory, as realloc() would.
+ *
+ * @param[in] pMemory  memory obtained with pUPortHeapAlloc() or
+ *                     pUPortHeapRealloc(), or NULL.
+ * @param sizeBytes    the number of bytes now required.
+ * @param tag          what the memory is for.
+ * @return             a pointer to the memory or NULL on failure,
+ *                     in which case pMemory is untouched.
+ */
+void *pUPortHeapRealloc(void *pMemory, size_t sizeBytes, uPortHeapTag_t tag);
+
+/** Free memory obtained with pUPortHeapAlloc() or pUPortHeapRealloc().
+ *
+ * @param[in] pMemory  the memory to free; may be NULL.
+ * @param tag          the tag the memory was allocated with.
+ */
+void uPortHeapFree(void *pMemory, uPortHeapTag_t tag);
+
+/** Get the allocation statistics for a tag.
+ *
+ * @param tag          the tag.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uPortHeapGetStats(uPortHeapTag_t tag, uPortHeapStats_t *pStats);
+
+/** Print the statistics of every tag that has been used, including
+ * the allocation rate since the last call to this function (or since
+ * boot on the first call), with uPortLog().  Since the allocation
+ * rate is worked out here, this should be called from only one task.
+ */
+void uPortHeapPrintStats();
+
+/** Print, with uPortLog(), the number of allocations that are
+ * outstanding for a tag, i.e. have been allocated and not freed;
+ * useful as a leak report when the part of ubxlib that the tag
+ * represents has been closed.  Nothing is printed if nothing is
+ * outstanding.
+ *
+ * @param tag  the tag, use #U_PORT_HEAP_TAG_MAX_NUM for all tags.
+ * @return     the number of allocations outstanding.
+ */
+size_t uPortHeapPrintOutstanding(uPortHeapTag_t tag);
+
+/** Initialise an arena.  An arena obtains chunks of memory with
+ * pUPortHeapAlloc() as required and hands out pieces of them; the
+ * pieces cannot be freed individually, instead the whole lot is
+ * returned in one step with uPortHeapArenaRelease().  No memory is
+ * allocated by this function.
+ *
+ * @param[out] pArena        a pointer to the arena to initialise.
+ * @param chunkSizeBytes     the usable size of each chunk, zero for
+ *                           #U_PORT_HEAP_ARENA_CHUNK_SIZE_BYTES; an
+ *                           allocation larger than this gets a chunk
+ *                           of its own.
+ * @param tag                the tag to allocate chunks with.
+ * @param[in] pBuffer        an optional buffer to use as the first
+ *                           chunk, e.g. on the stack of the caller,
+ *                           so that small operations need allocate
+ *                           nothing at all; may be NULL.
+ * @param bufferSizeBytes    the size of pBuffer; ignored if pBuffer
+ *                           is NULL.
+ */
+void uPortHeapArenaInit(uPortHeapArena_t *pArena, size_t chunkSizeBytes,
+                        uPortHeapTag_t tag, void *pBuffer,
+                        size_t bufferSizeBytes);
+
+/** Allocate memory from an arena.
+ *
+ * @param[in] pArena     a pointer to the arena.
+ * @param sizeBytes      the number of bytes required.
+ * @return               a pointer to the memory, aligned to
+ *                       #U_PORT_HEAP_ARENA_ALIGNMENT_BYTES, or NULL
+ *                       on failure.
+ */
+void *pUPortHeapArenaAlloc(uPortHeapArena_t *pArena, size_t sizeBytes);
+
+/** Release all of the memory allocated from an arena; the arena
+ * may be used again afterwards, any static buffer passed to
+ * uPortHeapArenaInit() being re-used.
+ *
+ * @param[in] pArena     a pointer to the arena.
+ */
+void uPortHeapArenaRelease(uPortHeapArena_t *pArena);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_PORT_HEAP_H_
+
+// End of file
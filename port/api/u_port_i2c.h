@@ -56,10 +56,37 @@ extern "C" {
 # define U_PORT_I2C_TIMEOUT_MILLISECONDS 10
 #endif
 
+#ifndef U_PORT_I2C_ASYNC_MAX_NUM
+/** The maximum number of I2C instances on which uPortI2cAsyncOpen()
+ * may be in effect at any one time.
+ */
+# define U_PORT_I2C_ASYNC_MAX_NUM 2
+#endif
+
+#ifndef U_PORT_I2C_ASYNC_QUEUE_LENGTH
+/** The number of calls to uPortI2cControllerSendReceiveAsync() that
+ * may be outstanding on an I2C instance before the next one blocks.
+ */
+# define U_PORT_I2C_ASYNC_QUEUE_LENGTH 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Callback called when a transfer started by
+ * uPortI2cControllerSendReceiveAsync() has completed.
+ *
+ * @param handle            the handle of the I2C instance.
+ * @param errorCodeOrLength the outcome, as would have been returned
+ *                          by uPortI2cControllerSendReceive().
+ * @param pCallbackParam    the parameter that was passed to
+ *                          uPortI2cControllerSendReceiveAsync().
+ */
+typedef void (*uPortI2cCallback_t)(int32_t handle,
+                                   int32_t errorCodeOrLength,
+                                   void *pCallbackParam);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -208,6 +235,10 @@ int32_t uPortI2cSetTimeout(int32_t handle, int32_t timeoutMs);
 int32_t uPortI2cGetTimeout(int32_t handle);
 
 /** Send and/or receive over the I2C interface as a controller.
+ * If both pSend and pReceive are given this is a single
+ * transaction: the receive follows the send with a repeated start,
+ * no stop bit in between, as is required to read a register of
+ * a device such as a u-blox GNSS module.
  * Note that the NRF52 and NRF53 chips require all buffers to
  * be in RAM.
  * Note that the uPortI2cSetTimeout() (or the equivalent set
@@ -291,6 +322,80 @@ int32_t uPortI2cControllerSend(int32_t handle, uint16_t address,
                                const char *pSend, size_t bytesToSend,
                                bool noStop);
 
+/** Enable uPortI2cControllerSendReceiveAsync() on the given I2C
+ * instance; this creates the task in which the transfers are
+ * performed and the completion callbacks are called, for which the
+ * stack size and priority can be specified.  uPortI2cAsyncClose()
+ * MUST be called before the I2C instance is closed.  This function
+ * should not be called at the same time as uPortI2cAsyncClose() or
+ * uPortI2cControllerSendReceiveAsync() for the same I2C instance.
+ *
+ * A default implementation is provided, common to all platforms,
+ * which performs each transfer with uPortI2cControllerSendReceive()
+ * in its own task; it is weakly linked, as are uPortI2cAsyncClose()
+ * and uPortI2cControllerSendReceiveAsync(), so that a platform which
+ * can transfer asynchronously (e.g. with DMA and a transfer-complete
+ * interrupt) may provide its own.
+ *
+ * @param handle         the handle of the I2C instance.
+ * @param stackSizeBytes the number of bytes of stack for the task
+ *                       in which the callbacks are called, must
+ *                       be at least
+ *                       #U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES.
+ * @param priority       the priority of that task.
+ * @return               zero on success else negative error code.
+ */
+int32_t uPortI2cAsyncOpen(int32_t handle, size_t stackSizeBytes,
+                          int32_t priority);
+
+/** Disable uPortI2cControllerSendReceiveAsync() on the given I2C
+ * instance; any transfers that are still outstanding are completed,
+ * and their callbacks called, before this function returns.  Must
+ * not be called from a completion callback.
+ *
+ * @param handle the handle of the I2C instance.
+ */
+void uPortI2cAsyncClose(int32_t handle);
+
+/** As uPortI2cControllerSendReceive() but without waiting for the
+ * transfer to happen: this function returns as soon as the transfer
+ * has been queued and pCallback, if not NULL, is called when it has
+ * completed, with the outcome, so that the calling task can get on
+ * with other work in the meantime.  The buffers at pSend and
+ * pReceive MUST remain valid until the callback has been called.
+ * Transfers are performed in the order they are queued; they may be
+ * interleaved with calls to uPortI2cControllerSendReceive() or
+ * uPortI2cControllerSend() but each transfer is performed as a
+ * whole.  uPortI2cAsyncOpen() must have been called first.  If
+ * #U_PORT_I2C_ASYNC_QUEUE_LENGTH transfers are already outstanding
+ * this function blocks until there is room.
+ *
+ * @param handle         the handle of the I2C instance.
+ * @param address        the I2C address, see
+ *                       uPortI2cControllerSendReceive().
+ * @param pSend          a pointer to the data to send, use NULL
+ *                       if only receive is required.
+ * @param bytesToSend    the number of bytes to send, must be zero if
+ *                       pSend is NULL.
+ * @param pReceive       a pointer to a buffer in which to store
+ *                       received data, use NULL if only send is
+ *                       required.
+ * @param bytesToReceive the size of buffer pointed to by pReceive,
+ *                       must be zero if pReceive is NULL.
+ * @param pCallback      the callback to be called when the transfer
+ *                       has completed, may be NULL.
+ * @param pCallbackParam a parameter that will be passed to
+ *                       pCallback, may be NULL.
+ * @return               zero if the transfer has been queued, else
+ *                       negative error code, in which case pCallback
+ *                       will not be called.
+ */
+int32_t uPortI2cControllerSendReceiveAsync(int32_t handle, uint16_t address,
+                                           const char *pSend, size_t bytesToSend,
+                                           char *pReceive, size_t bytesToReceive,
+                                           uPortI2cCallback_t pCallback,
+                                           void *pCallbackParam);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,6 +55,61 @@ extern "C" {
  */
 #define U_PORT_EXECUTABLE_CHUNK_NO_FLAGS      0
 
+#ifndef U_PORT_TASK_RUNTIME_STATS_NAME_MAX_LENGTH_BYTES
+/** The maximum length of the task name in #uPortTaskRuntimeStats_t,
+ * including the null terminator; longer names are truncated.
+ */
+# define U_PORT_TASK_RUNTIME_STATS_NAME_MAX_LENGTH_BYTES 16
+#endif
+
+#ifndef U_PORT_TASK_STACK_MAX_NUM
+/** The maximum number of tasks that the task stack registry, see
+ * #U_CFG_TASK_STACK_REGISTRY, can keep track of; a task that is
+ * created again with the same name once the last one has been
+ * deleted re-uses its entry.
+ */
+# define U_PORT_TASK_STACK_MAX_NUM 24
+#endif
+
+#ifndef U_PORT_TASK_STACK_NAME_MAX_LENGTH_BYTES
+/** The maximum length of the task name in #uPortTaskStack_t,
+ * including the null terminator; longer names are truncated.
+ */
+# define U_PORT_TASK_STACK_NAME_MAX_LENGTH_BYTES 16
+#endif
+
+#ifndef U_PORT_TASK_STACK_MARGIN_PERCENT
+/** The margin, as a percentage of the most stack a task has been
+ * seen to use, that the task stack registry adds when recommending
+ * a stack size.
+ */
+# define U_PORT_TASK_STACK_MARGIN_PERCENT 25
+#endif
+
+#ifndef U_PORT_TASK_STACK_MARGIN_MIN_BYTES
+/** The least margin, in bytes, that the task stack registry adds
+ * when recommending a stack size.
+ */
+# define U_PORT_TASK_STACK_MARGIN_MIN_BYTES 256
+#endif
+
+#ifdef U_CFG_TASK_STACK_REGISTRY
+/* Define #U_CFG_TASK_STACK_REGISTRY to have every task created
+ * with uPortTaskCreate() recorded, with its stack size and the
+ * least stack it had free, so that uPortTaskStackPrint() can, after
+ * a representative run, recommend a size for each stack.  These
+ * macros are called by the platform's uPortTaskCreate() and
+ * uPortTaskDelete().
+ */
+# define U_PORT_TASK_STACK_REGISTER(taskHandle, pName, stackSizeBytes) \
+             uPortTaskStackRegister(taskHandle, pName, stackSizeBytes)
+# define U_PORT_TASK_STACK_DEREGISTER(taskHandle) \
+             uPortTaskStackDeregister(taskHandle)
+#else
+# define U_PORT_TASK_STACK_REGISTER(taskHandle, pName, stackSizeBytes)
+# define U_PORT_TASK_STACK_DEREGISTER(taskHandle)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -101,6 +156,55 @@ typedef enum {
  */
 typedef uint32_t uPortExeChunkFlags_t;
 
+/** The run-time statistics of a task, as returned by
+ * uPortTaskGetRuntimeStats().
+ */
+typedef struct {
+    uPortTaskHandle_t taskHandle; /**< the handle of the task, NULL
+                                       where the platform cannot
+                                       supply it. */
+    char name[U_PORT_TASK_RUNTIME_STATS_NAME_MAX_LENGTH_BYTES]; /**< the
+                                       name of the task, null-terminated,
+                                       empty if the task has no name. */
+    uint64_t runtimeTicks;        /**< the CPU time the task has used;
+                                       the unit is platform specific
+                                       (e.g. FreeRTOS run-time counter
+                                       ticks, Zephyr cycles, Linux clock
+                                       ticks), so compare only with other
+                                       entries from the same platform. */
+    int32_t percent;              /**< runtimeTicks as a percentage of
+                                       the total for all tasks, rounded
+                                       down. */
+    bool isIdle;                  /**< true if this is an idle task of
+                                       the RTOS. */
+} uPortTaskRuntimeStats_t;
+
+/** The stack figures for a task, or for all of the tasks that have
+ * been created, one after the other, with the same name, as kept
+ * by the task stack registry, see #U_CFG_TASK_STACK_REGISTRY.
+ */
+typedef struct {
+    char name[U_PORT_TASK_STACK_NAME_MAX_LENGTH_BYTES]; /**< the name
+                                     of the task, null-terminated. */
+    size_t stackSizeBytes;      /**< the stack size the task was last
+                                     created with. */
+    int32_t usedMaxBytes;       /**< the most stack that the task has
+                                     been seen to use, negative error
+                                     code if the platform cannot tell
+                                     (see uPortTaskStackMinFree()). */
+    int32_t recommendedBytes;   /**< the recommended stack size:
+                                     usedMaxBytes plus a margin (see
+                                     #U_PORT_TASK_STACK_MARGIN_PERCENT
+                                     and #U_PORT_TASK_STACK_MARGIN_MIN_BYTES),
+                                     negative error code if usedMaxBytes
+                                     is. */
+    size_t numCreated;          /**< the number of times the task has
+                                     been created. */
+    bool running;               /**< true if the task is running now,
+                                     in which case the figures may
+                                     still change. */
+} uPortTaskStack_t;
+
 /** The function signature for a timer callback.
  */
 typedef void (pTimerCallback_t) (const uPortTimerHandle_t, void *);
@@ -191,6 +295,85 @@ int32_t uPortTaskStackMinFree(const uPortTaskHandle_t taskHandle);
  */
 int32_t uPortTaskGetHandle(uPortTaskHandle_t *pTaskHandle);
 
+/** Get the run-time statistics of all tasks, i.e. the CPU time
+ * that each has used since it was created, so that CPU load can be
+ * attributed to the tasks that cause it: take two sets of statistics,
+ * some time apart, and compare them.  The percentages are of the
+ * total of the CPU time used by all tasks, including any idle tasks,
+ * at the time of the call.
+ *
+ * It is NOT a requirement that this API is implemented: where it is
+ * not implemented #U_ERROR_COMMON_NOT_IMPLEMENTED should be returned;
+ * where the underlying RTOS has not been configured to collect
+ * run-time statistics (e.g. for FreeRTOS configUSE_TRACE_FACILITY
+ * and configGENERATE_RUN_TIME_STATS must be 1, for Zephyr
+ * CONFIG_THREAD_MONITOR and CONFIG_THREAD_RUNTIME_STATS must be
+ * enabled) #U_ERROR_COMMON_NOT_SUPPORTED will be returned.
+ *
+ * @param[out] pStats       a place to put the statistics, an array
+ *                          of maxNumStats entries; may be NULL
+ *                          if only the idle percentage is required.
+ * @param maxNumStats       the number of entries at pStats; if there
+ *                          are more tasks than this the statistics
+ *                          of the rest are not returned but are
+ *                          still included in the total.
+ * @param[out] pIdlePercent a place to put the percentage of the
+ *                          total CPU time used by the idle task(s)
+ *                          of the RTOS, rounded down; -1 will be
+ *                          returned where there is no idle task
+ *                          (e.g. on Linux).  May be NULL.
+ * @return                  the number of entries written to pStats,
+ *                          else negative error code.
+ */
+int32_t uPortTaskGetRuntimeStats(uPortTaskRuntimeStats_t *pStats,
+                                 size_t maxNumStats,
+                                 int32_t *pIdlePercent);
+
+/** Add a task to the task stack registry; this function is not
+ * usually called directly, it is called, through
+ * U_PORT_TASK_STACK_REGISTER(), by the platform's uPortTaskCreate()
+ * if #U_CFG_TASK_STACK_REGISTRY is defined.
+ *
+ * @param taskHandle     the handle of the task that has been created.
+ * @param[in] pName      the name of the task; may be NULL.
+ * @param stackSizeBytes the stack size the task was created with.
+ */
+void uPortTaskStackRegister(const uPortTaskHandle_t taskHandle,
+                            const char *pName, size_t stackSizeBytes);
+
+/** Record the final stack figures of a task in the task stack
+ * registry; this function is not usually called directly, it is
+ * called, through U_PORT_TASK_STACK_DEREGISTER(), by the platform's
+ * uPortTaskDelete(), before the task is deleted, if
+ * #U_CFG_TASK_STACK_REGISTRY is defined.
+ *
+ * @param taskHandle the handle of the task about to be deleted;
+ *                   NULL for the current task.
+ */
+void uPortTaskStackDeregister(const uPortTaskHandle_t taskHandle);
+
+/** Get the figures for an entry in the task stack registry, see
+ * #U_CFG_TASK_STACK_REGISTRY.
+ *
+ * @param index            the index of the entry, starting at zero.
+ * @param[out] pTaskStack  a place to put the figures; cannot be NULL.
+ * @return                 zero on success, #U_ERROR_COMMON_NOT_FOUND
+ *                         if there is no entry at index (so there are
+ *                         none beyond it either), else negative error
+ *                         code.
+ */
+int32_t uPortTaskStackGet(size_t index, uPortTaskStack_t *pTaskStack);
+
+/** Print the task stack registry, see #U_CFG_TASK_STACK_REGISTRY,
+ * using uPortLog(): for each task the stack size, the most stack
+ * used and the recommended stack size and, at the end, the total
+ * that would be saved by using the recommended sizes.  Call this
+ * after a run that has exercised everything your application does,
+ * then set the stack-size compile-time constants of ubxlib (e.g.
+ * U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES) to match.
+ */
+void uPortTaskStackPrint(void);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: QUEUES
  * -------------------------------------------------------------- */
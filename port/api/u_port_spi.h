@@ -0,0 +1,158 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_PORT_SPI_H_
+#define _U_PORT_SPI_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __port
+ *  @{
+ */
+
+/** @file
+ * @brief Porting layer for SPI access functions.  These functions
+ * are thread-safe.  Only controller (master) mode is supported,
+ * with SPI mode 0 (CPOL 0, CPHA 0), most significant bit first,
+ * which is what u-blox GNSS chips require; chip select is driven
+ * as a GPIO by this code, active low, around each transfer.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_SPI_CLOCK_FREQUENCY_HERTZ
+/** The default SPI clock frequency in Hertz.
+ */
+# define U_PORT_SPI_CLOCK_FREQUENCY_HERTZ 1000000
+#endif
+
+#ifndef U_PORT_SPI_FILL_BYTE
+/** The byte that is sent by uPortSpiControllerSendReceiveBlock()
+ * when there is nothing to send.
+ */
+# define U_PORT_SPI_FILL_BYTE 0xFF
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Initialise SPI handling.  If SPI has already been initialised
+ * this function will return success without doing anything.
+ *
+ * @return  zero on success else negative error code.
+ */
+int32_t uPortSpiInit();
+
+/** Shutdown SPI handling; any open SPI instances will be closed.
+ */
+void uPortSpiDeinit();
+
+/** Open an SPI instance as a controller.  If an SPI instance has
+ * already been opened on the given SPI HW block this function
+ * returns an error.  Note that the pin numbers are those of the MCU.
+ * IMPORTANT: some platforms, specifically Zephyr, do not permit SPI
+ * pin choices to be made at link-time, only at compile time.  For
+ * such platforms pinMosi, pinMiso and pinClk MUST be -1 (otherwise
+ * an error will be returned) and you MUST check the README.md for
+ * that platform to find out how the pins are chosen; pinSelect is
+ * always set at run-time since it is driven as a GPIO.
+ *
+ * @param spi        the SPI HW block to use.
+ * @param pinMosi    the controller-out, peripheral-in data pin, a
+ *                   positive integer or -1 if the pin choice has
+ *                   already been determined at compile time.
+ * @param pinMiso    the controller-in, peripheral-out data pin, a
+ *                   positive integer or -1 if the pin choice has
+ *                   already been determined at compile time.
+ * @param pinClk     the clock pin, a positive integer or -1 if the
+ *                   pin choice has already been determined at
+ *                   compile time.
+ * @param pinSelect  the chip select pin, a positive integer.
+ * @return           an SPI handle else negative error code.
+ */
+int32_t uPortSpiOpen(int32_t spi, int32_t pinMosi, int32_t pinMiso,
+                     int32_t pinClk, int32_t pinSelect);
+
+/** Close an SPI instance.
+ *
+ * @param handle the handle of the SPI instance to close.
+ */
+void uPortSpiClose(int32_t handle);
+
+/** Set the SPI clock frequency.  If this is not called
+ * #U_PORT_SPI_CLOCK_FREQUENCY_HERTZ will be used.  The HW may
+ * round the frequency down to one that it can achieve.
+ *
+ * @param handle      the handle of the SPI instance.
+ * @param clockHertz  the clock frequency in Hertz.
+ * @return            zero on success else negative error code.
+ */
+int32_t uPortSpiControllerSetClock(int32_t handle, int32_t clockHertz);
+
+/** Get the SPI clock frequency.
+ *
+ * @param handle     the handle of the SPI instance.
+ * @return           the clock frequency in Hertz, else negative
+ *                   error code.
+ */
+int32_t uPortSpiControllerGetClock(int32_t handle);
+
+/** Exchange a block of data over SPI as a controller: since SPI
+ * is full duplex, size bytes are always clocked out and size
+ * bytes are always clocked in.  Chip select is asserted for the
+ * whole block.
+ * Note that on some platforms (e.g. ESP-IDF with DMA) the buffers
+ * must be in RAM.
+ *
+ * @param handle        the handle of the SPI instance.
+ * @param[in] pSend     a pointer to the size bytes of data to send;
+ *                      use NULL to send #U_PORT_SPI_FILL_BYTE
+ *                      instead, e.g. if only receive is required.
+ * @param[out] pReceive a pointer to a buffer of at least size bytes
+ *                      in which to store the received data; use
+ *                      NULL if the received data is not required.
+ * @param size          the number of bytes to exchange.
+ * @return              the number of bytes exchanged else negative
+ *                      error code.
+ */
+int32_t uPortSpiControllerSendReceiveBlock(int32_t handle,
+                                           const char *pSend,
+                                           char *pReceive,
+                                           size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_PORT_SPI_H_
+
+// End of file
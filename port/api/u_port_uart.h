@@ -61,14 +61,105 @@ extern "C" {
 /** The event which means that received data is available; this
  * will be sent if the receive buffer goes from empty to containing
  * one or more bytes of received data. It is used as a bit-mask.
- * It is the only U_PORT_UART_EVENT_BITMASK_xxx currently supported.
+ * It is supported on all platforms.
  */
 #define U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED 0x01
 
+/** The event which means that a complete line, i.e. one ending
+ * in a line-feed character, has been received; it will also be sent
+ * if the receive buffer overflows, since then a line-feed may never
+ * arrive.  It is used as a bit-mask.  Only ESP-IDF, where the UART
+ * hardware does the character detection, supports this event at
+ * the moment; other platforms will accept it in a filter but will
+ * never send it.
+ */
+#define U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED 0x02
+
+#ifndef U_PORT_UART_WRITEV_BUFFER_LENGTH_BYTES
+/** The size of the buffer on the stack that the default
+ * implementation of uPortUartWritev() gathers data into; if the
+ * total to be written is larger than this a buffer is allocated
+ * from the heap instead.
+ */
+# define U_PORT_UART_WRITEV_BUFFER_LENGTH_BYTES 64
+#endif
+
+#ifndef U_PORT_UART_WRITE_ASYNC_MAX_NUM
+/** The maximum number of UARTs on which uPortUartWriteAsyncOpen()
+ * may be in effect at any one time.
+ */
+# define U_PORT_UART_WRITE_ASYNC_MAX_NUM 2
+#endif
+
+#ifndef U_PORT_UART_WRITE_ASYNC_MAX_NUM_IO_VEC
+/** The maximum number of pieces of data that may be passed to
+ * a single call to uPortUartWriteAsync().
+ */
+# define U_PORT_UART_WRITE_ASYNC_MAX_NUM_IO_VEC 4
+#endif
+
+#ifndef U_PORT_UART_WRITE_ASYNC_QUEUE_LENGTH
+/** The number of calls to uPortUartWriteAsync() that may be
+ * outstanding on a UART before the next one blocks.
+ */
+# define U_PORT_UART_WRITE_ASYNC_QUEUE_LENGTH 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A piece of data to be written by uPortUartWritev().
+ */
+typedef struct {
+    const void *pBase; /**< the start of the data. */
+    size_t length;     /**< the number of bytes at pBase. */
+} uPortUartIoVec_t;
+
+/** Callback called when a write started by uPortUartWriteAsync()
+ * has completed.
+ *
+ * @param handle          the handle of the UART instance.
+ * @param sizeOrErrorCode the number of bytes sent or negative
+ *                        error code.
+ * @param pCallbackParam  the parameter that was passed to
+ *                        uPortUartWriteAsync().
+ */
+typedef void (*uPortUartWriteCallback_t)(int32_t handle,
+                                         int32_t sizeOrErrorCode,
+                                         void *pCallbackParam);
+
+/** Statistics for a UART instance, as returned by
+ * uPortUartGetStats(): all are counted from when the UART instance
+ * was opened.  Not every platform is able to measure every one of
+ * these; those which cannot be measured on a given platform
+ * remain at zero.
+ */
+typedef struct {
+    uint32_t rxBytes;             /**< the number of bytes received. */
+    uint32_t txBytes;             /**< the number of bytes transmitted. */
+    uint32_t rxOverrunErrors;     /**< the number of times received data
+                                       was lost because the UART hardware
+                                       was not serviced in time. */
+    uint32_t rxFramingErrors;     /**< the number of framing, noise or
+                                       parity errors detected by the UART
+                                       hardware. */
+    uint32_t rxBufferOverflows;   /**< the number of times received data
+                                       was lost, or transfer into the
+                                       receive buffer was held off, because
+                                       the receive buffer was full. */
+    size_t rxBufferHighWaterMark; /**< the largest number of bytes that have
+                                       been waiting in the receive buffer. */
+    uint32_t ctsStalls;           /**< the number of times transmission
+                                       was held off by the far end
+                                       de-asserting CTS. */
+    int32_t eventCallbackLatencyMaxMs; /**< the longest time between an
+                                            event being raised by the UART
+                                            and the callback set with
+                                            uPortUartEventCallbackSet()
+                                            being called. */
+} uPortUartStats_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -190,6 +281,156 @@ int32_t uPortUartRead(int32_t handle, void *pBuffer,
 int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
                        size_t sizeBytes);
 
+/** Write data that is in several pieces to the given UART
+ * interface as a single transfer, e.g. a header, a payload and
+ * a trailer.  Will block until all of the data has been written
+ * or an error has occurred.
+ *
+ * A default implementation is provided, common to all platforms,
+ * which gathers the data into one buffer and calls uPortUartWrite()
+ * once; it is weakly linked so that a platform which can transmit
+ * directly from several buffers (e.g. with a DMA descriptor chain)
+ * may provide its own.  Should the gathering buffer not be available
+ * the pieces are written one at a time.
+ *
+ * @param handle      the handle of the UART instance.
+ * @param[in] pIoVec  an array of the pieces of data to send.
+ * @param numIoVec    the number of entries at pIoVec.
+ * @return            the number of bytes sent or negative
+ *                    error code.
+ */
+int32_t uPortUartWritev(int32_t handle, const uPortUartIoVec_t *pIoVec,
+                        size_t numIoVec);
+
+/** Get a pointer to the data already received by the given UART
+ * instance, non-blocking, without copying it: this is the
+ * zero-copy equivalent of uPortUartRead().  pData is set to point
+ * at the received data in the receive buffer of the UART, e.g. the
+ * memory written to by the receive DMA, and the number of bytes
+ * there that may be read is returned; since the receive buffer
+ * is circular this may be less than uPortUartGetReceiveSize(),
+ * the remainder being available by calling this function again
+ * once the first span of data has been released.
+ *
+ * The data at pData remains valid until it is released with
+ * uPortUartReleaseSpan() and MUST be released, otherwise it will
+ * be returned again and the receive buffer will eventually fill
+ * up.  Data may be released in pieces, e.g. as it is parsed, and
+ * when all of it has been released the span is closed; only one
+ * span may be open on a UART at a time, do not call uPortUartRead()
+ * while a span is open.
+ *
+ * A default implementation, common to all platforms, returns
+ * #U_ERROR_COMMON_NOT_SUPPORTED (in which case uPortUartRead() must
+ * be used instead); it is weakly linked so that a platform which
+ * receives into a buffer that can be read directly may provide its
+ * own.
+ *
+ * @param handle      the handle of the UART instance.
+ * @param[out] ppData a pointer to a place to put the pointer to
+ *                    the received data; cannot be NULL.
+ * @return            the number of bytes at *ppData, zero if
+ *                    there is no received data, else negative
+ *                    error code.
+ */
+int32_t uPortUartReadSpan(int32_t handle, const char **ppData);
+
+/** Release data that was returned by uPortUartReadSpan(), making
+ * the space it occupied available for new received data.
+ *
+ * A default implementation, common to all platforms, returns
+ * #U_ERROR_COMMON_NOT_SUPPORTED; it is weakly linked so that a
+ * platform which supports uPortUartReadSpan() may provide its own.
+ *
+ * @param handle    the handle of the UART instance.
+ * @param sizeBytes the number of bytes to release, which must be
+ *                  no more than the number returned by the
+ *                  last call to uPortUartReadSpan() less any
+ *                  already released.
+ * @return          zero on success else negative error code.
+ */
+int32_t uPortUartReleaseSpan(int32_t handle, size_t sizeBytes);
+
+/** Enable uPortUartWriteAsync() on the given UART instance; this
+ * creates the task in which the writes are performed and the
+ * completion callbacks are called, for which the stack size and
+ * priority can be specified.  uPortUartWriteAsyncClose() MUST be
+ * called before the UART instance is closed.  This function should
+ * not be called at the same time as uPortUartWriteAsyncClose() or
+ * uPortUartWriteAsync() for the same UART instance.
+ *
+ * A default implementation is provided, common to all platforms,
+ * which performs each write with uPortUartWritev() in its own
+ * task; it is weakly linked, as are uPortUartWriteAsyncClose()
+ * and uPortUartWriteAsync(), so that a platform which can transmit
+ * asynchronously (e.g. with DMA and a transmit-complete interrupt)
+ * may provide its own.
+ *
+ * @param handle         the handle of the UART instance.
+ * @param stackSizeBytes the number of bytes of stack for the task
+ *                       in which the callbacks are called, must
+ *                       be at least
+ *                       #U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES.
+ * @param priority       the priority of that task; see
+ *                       uPortUartEventCallbackSet() for advice.
+ * @return               zero on success else negative error code.
+ */
+int32_t uPortUartWriteAsyncOpen(int32_t handle, size_t stackSizeBytes,
+                                int32_t priority);
+
+/** Disable uPortUartWriteAsync() on the given UART instance; any
+ * writes that are still outstanding are completed, and their
+ * callbacks called, before this function returns.  Must not be
+ * called from a completion callback.
+ *
+ * @param handle the handle of the UART instance.
+ */
+void uPortUartWriteAsyncClose(int32_t handle);
+
+/** Write data, which may be in several pieces, to the given UART
+ * instance without waiting for it to be sent: this function
+ * returns as soon as the write has been queued and pCallback,
+ * if not NULL, is called when it has completed, with the outcome.
+ * In the meantime the caller may get on with preparing the next
+ * data.  The data pointed to by pIoVec MUST remain valid until the
+ * callback has been called; the array at pIoVec need not, it is
+ * copied.  Writes are performed in the order they are queued;
+ * they may be interleaved with writes made with uPortUartWrite()
+ * or uPortUartWritev() but each write is sent as a whole.
+ * uPortUartWriteAsyncOpen() must have been called first.  If
+ * #U_PORT_UART_WRITE_ASYNC_QUEUE_LENGTH writes are already
+ * outstanding this function blocks until there is room.
+ *
+ * @param handle         the handle of the UART instance.
+ * @param[in] pIoVec     an array of the pieces of data to send.
+ * @param numIoVec       the number of entries at pIoVec, at most
+ *                       #U_PORT_UART_WRITE_ASYNC_MAX_NUM_IO_VEC.
+ * @param pCallback      the callback to be called when the write
+ *                       has completed, may be NULL.
+ * @param pCallbackParam a parameter that will be passed to
+ *                       pCallback, may be NULL.
+ * @return               zero if the write has been queued, else
+ *                       negative error code, in which case
+ *                       pCallback will not be called.
+ */
+int32_t uPortUartWriteAsync(int32_t handle, const uPortUartIoVec_t *pIoVec,
+                            size_t numIoVec, uPortUartWriteCallback_t pCallback,
+                            void *pCallbackParam);
+
+/** Get the statistics of the given UART instance, e.g. to find out
+ * whether throughput problems are due to overruns, framing errors
+ * or the receive buffer becoming full.
+ *
+ * A default implementation, common to all platforms, returns
+ * #U_ERROR_COMMON_NOT_SUPPORTED; it is weakly linked so that a
+ * platform which keeps statistics may provide its own.
+ *
+ * @param handle      the handle of the UART instance.
+ * @param[out] pStats a place to put the statistics; cannot be NULL.
+ * @return            zero on success else negative error code.
+ */
+int32_t uPortUartGetStats(int32_t handle, uPortUartStats_t *pStats);
+
 /** Set a callback to be called when a UART event occurs.
  * pFunction will be called asynchronously in its own task,
  * for which the stack size and priority can be specified.
@@ -77,4 +77,18 @@ int32_t uPortGpioGet(int32_t pin)
     return (int32_t) errorCode;
 }
 
+// Set an interrupt on a GPIO: not supported on this platform.
+int32_t uPortGpioInterruptSet(int32_t pin, bool risingEdge,
+                              void (*pCallback) (int32_t pin,
+                                                 void *pCallbackParam),
+                              void *pCallbackParam)
+{
+    (void) pin;
+    (void) risingEdge;
+    (void) pCallback;
+    (void) pCallbackParam;
+
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
 // End of file
@@ -159,6 +159,18 @@ int32_t uPortTaskGetHandle(uPortTaskHandle_t *pTaskHandle)
     return errorCode;
 }
 
+// Get the run-time statistics of all tasks.
+int32_t uPortTaskGetRuntimeStats(uPortTaskRuntimeStats_t *pStats,
+                                 size_t maxNumStats,
+                                 int32_t *pIdlePercent)
+{
+    (void) pStats;
+    (void) maxNumStats;
+    (void) pIdlePercent;
+
+    return (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: QUEUES
  * -------------------------------------------------------------- */
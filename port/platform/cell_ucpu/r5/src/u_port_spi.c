@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Implementation of the port SPI API for the SARA-R5 platform;
+ * SPI is not currently supported on this platform.
+ */
+
+#include "stddef.h"
+#include "stdint.h"
+#include "stdbool.h"
+
+#include "u_error_common.h"
+#include "u_port_spi.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Initialise SPI handling.
+int32_t uPortSpiInit()
+{
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Shutdown SPI handling.
+void uPortSpiDeinit()
+{
+    // Not supported.
+}
+
+// Open an SPI instance.
+int32_t uPortSpiOpen(int32_t spi, int32_t pinMosi, int32_t pinMiso,
+                     int32_t pinClk, int32_t pinSelect)
+{
+    (void) spi;
+    (void) pinMosi;
+    (void) pinMiso;
+    (void) pinClk;
+    (void) pinSelect;
+
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Close an SPI instance.
+void uPortSpiClose(int32_t handle)
+{
+    (void) handle;
+}
+
+// Set the SPI clock frequency.
+int32_t uPortSpiControllerSetClock(int32_t handle, int32_t clockHertz)
+{
+    (void) handle;
+    (void) clockHertz;
+
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Get the SPI clock frequency.
+int32_t uPortSpiControllerGetClock(int32_t handle)
+{
+    (void) handle;
+
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Exchange a block of data over SPI.
+int32_t uPortSpiControllerSendReceiveBlock(int32_t handle,
+                                           const char *pSend,
+                                           char *pReceive,
+                                           size_t size)
+{
+    (void) handle;
+    (void) pSend;
+    (void) pReceive;
+    (void) size;
+
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// End of file
@@ -0,0 +1,275 @@
+#!/usr/bin/env python
+
+'''Pair the energy markers printed by the tests with a power-analyser capture.
+
+A test brackets an operation with uBenchEnergyBegin()/uBenchEnergyEnd()
+(see port/platform/common/test/u_bench.h), which print lines of the form:
+
+U_BENCH_ENERGY: name=mqttClientPublish mark=begin timeMs=10234
+
+...and, if U_CFG_TEST_PIN_ENERGY_MARKER is defined, drive that pin high
+for the duration of the operation.  This script reads those lines from
+the JUnit XML report written by u_monitor.py (or from any log file),
+reads a CSV file captured by a power analyser (e.g. an Otii or a
+Joulescope) and integrates the current, and voltage if captured, over
+each operation, reporting the charge and energy consumed per operation;
+if the input was a JUnit XML report the results are written back into
+it as properties of the test case that ran the operation, named
+energy.<name>.uAh, energy.<name>.mJ, energy.<name>.durationMs and
+energy.<name>.count.
+
+The markers are lined up with the capture in one of two ways: if the
+capture includes a digital channel connected to the marker pin then
+the Nth high pulse on that channel is the Nth operation, which is
+exact; otherwise the capture time, in seconds, of the first "begin"
+marker must be given and the rest are placed using the device times
+in the markers, which is only as good as the device tick.'''
+
+import sys
+import argparse
+import csv
+import re
+from logging import Logger
+from lxml import etree
+from scripts.u_logging import ULog
+
+# Prefix to put at the start of all prints
+PROMPT = "u_energy"
+
+# The logger
+U_LOG: Logger = None
+
+# The regex of an energy marker line, see u_bench.h
+MARKER_REGEX = r"U_BENCH_ENERGY: name=(\S+) mark=(begin|end) timeMs=(-?[0-9]+)"
+
+# The level above which the digital marker channel is high
+MARKER_THRESHOLD = 0.5
+
+def column_index(header, column):
+    '''Return the index of a column given as a name or a number'''
+    if column is None:
+        return None
+    if isinstance(column, int) or column.isdigit():
+        return int(column)
+    return header.index(column)
+
+def load_capture(file_name, time_column, current_column,
+                 voltage_column=None, marker_column=None):
+    '''Load a power-analyser capture from a CSV file with a header row'''
+    capture = {"time": [], "current": [], "voltage": None, "marker": None}
+    with open(file_name, "r", newline="") as file:
+        reader = csv.reader(file)
+        header = [item.strip() for item in next(reader)]
+        time_index = column_index(header, time_column)
+        current_index = column_index(header, current_column)
+        voltage_index = column_index(header, voltage_column)
+        marker_index = column_index(header, marker_column)
+        if voltage_index is not None:
+            capture["voltage"] = []
+        if marker_index is not None:
+            capture["marker"] = []
+        for row in reader:
+            if not row:
+                continue
+            capture["time"].append(float(row[time_index]))
+            capture["current"].append(float(row[current_index]))
+            if voltage_index is not None:
+                capture["voltage"].append(float(row[voltage_index]))
+            if marker_index is not None:
+                capture["marker"].append(float(row[marker_index]) > MARKER_THRESHOLD)
+    return capture
+
+def markers_from_lines(lines):
+    '''Return a list of (name, begin time ms, end time ms) from log lines'''
+    operations = []
+    open_markers = {}
+    for line in lines:
+        match = re.search(MARKER_REGEX, line)
+        if match:
+            name = match.group(1)
+            time_ms = int(match.group(3))
+            if match.group(2) == "begin":
+                open_markers[name] = time_ms
+            elif name in open_markers:
+                operations.append((name, open_markers.pop(name), time_ms))
+    return operations
+
+def load_markers(file_name):
+    '''Load the markers from a JUnit XML report or a log file; returns
+       the XML tree, or None if it was a log file, and a list of
+       (test case element, list of operations)'''
+    tree = None
+    test_cases = []
+    try:
+        tree = etree.parse(file_name)
+    except etree.XMLSyntaxError:
+        tree = None
+    if tree is not None:
+        for tc_el in tree.getroot().iter("testcase"):
+            stdout_el = tc_el.find("system-out")
+            if stdout_el is not None and stdout_el.text:
+                operations = markers_from_lines(stdout_el.text.splitlines())
+                if operations:
+                    test_cases.append((tc_el, operations))
+    else:
+        with open(file_name, "r", errors="replace") as file:
+            operations = markers_from_lines(file)
+            if operations:
+                test_cases.append((None, operations))
+    return tree, test_cases
+
+def marker_pulses(capture):
+    '''Return the (start, end) capture times of the pulses on the marker channel'''
+    pulses = []
+    start = None
+    for time_s, level in zip(capture["time"], capture["marker"]):
+        if level and start is None:
+            start = time_s
+        elif not level and start is not None:
+            pulses.append((start, time_s))
+            start = None
+    return pulses
+
+def integrate(capture, start_s, end_s, voltage):
+    '''Integrate over the capture between two times, returning the
+       charge in As and the energy in J (None if no voltage is known)'''
+    charge = 0.0
+    energy = 0.0
+    times = capture["time"]
+    for index in range(1, len(times)):
+        t_a = max(times[index - 1], start_s)
+        t_b = min(times[index], end_s)
+        if t_b > t_a:
+            current = (capture["current"][index - 1] + capture["current"][index]) / 2
+            if capture["voltage"] is not None:
+                volts = (capture["voltage"][index - 1] + capture["voltage"][index]) / 2
+            else:
+                volts = voltage
+            charge += current * (t_b - t_a)
+            if volts is not None:
+                energy += current * volts * (t_b - t_a)
+    if capture["voltage"] is None and voltage is None:
+        energy = None
+    return charge, energy
+
+def measure(capture, test_cases, first_begin_s, voltage):
+    '''Work out the charge/energy of each operation, returning a list of
+       (test case element, dictionary of results per operation name)'''
+    results = []
+    pulses = None
+    pulse_index = 0
+    first_begin_ms = None
+    if capture["marker"] is not None:
+        pulses = marker_pulses(capture)
+        U_LOG.info("{} pulse(s) found on the marker channel.".format(len(pulses)))
+    for tc_el, operations in test_cases:
+        per_name = {}
+        for name, begin_ms, end_ms in operations:
+            if pulses is not None:
+                if pulse_index >= len(pulses):
+                    U_LOG.warning("more markers than pulses, \"{}\" onwards ignored.". \
+                                  format(name))
+                    break
+                start_s, end_s = pulses[pulse_index]
+                pulse_index += 1
+            else:
+                if first_begin_ms is None:
+                    first_begin_ms = begin_ms
+                start_s = first_begin_s + (begin_ms - first_begin_ms) / 1000
+                end_s = first_begin_s + (end_ms - first_begin_ms) / 1000
+            charge, energy = integrate(capture, start_s, end_s, voltage)
+            entry = per_name.setdefault(name, {"count": 0, "durationMs": 0.0,
+                                               "uAh": 0.0, "mJ": None})
+            entry["count"] += 1
+            entry["durationMs"] += (end_s - start_s) * 1000
+            entry["uAh"] += charge * 1000000 / 3600
+            if energy is not None:
+                entry["mJ"] = (entry["mJ"] or 0.0) + energy * 1000
+        # Convert the totals into averages per operation
+        for entry in per_name.values():
+            entry["durationMs"] /= entry["count"]
+            entry["uAh"] /= entry["count"]
+            if entry["mJ"] is not None:
+                entry["mJ"] /= entry["count"]
+        results.append((tc_el, per_name))
+    if pulses is not None and pulse_index < len(pulses):
+        U_LOG.warning("{} pulse(s) on the marker channel had no marker.". \
+                      format(len(pulses) - pulse_index))
+    return results
+
+def run(capture_file, markers_file, time_column="0", current_column="1",
+        voltage_column=None, marker_column=None, first_begin_s=None,
+        voltage=None):
+    '''Report the energy per operation; returns zero on success'''
+    # "global" should be avoided, but we make an exception for the logger
+    global U_LOG # pylint: disable=global-statement
+    U_LOG = ULog.get_logger(PROMPT)
+
+    if marker_column is None and first_begin_s is None:
+        U_LOG.error("either a marker column or the capture time of the"
+                    " first \"begin\" marker must be given.")
+        return -1
+    capture = load_capture(capture_file, time_column, current_column,
+                           voltage_column, marker_column)
+    U_LOG.info("{} sample(s) loaded from \"{}\".".format(len(capture["time"]),
+                                                         capture_file))
+    tree, test_cases = load_markers(markers_file)
+    if not test_cases:
+        U_LOG.error("no energy markers found in \"{}\".".format(markers_file))
+        return -1
+    results = measure(capture, test_cases, first_begin_s, voltage)
+    for tc_el, per_name in results:
+        props_el = None
+        if tc_el is not None:
+            props_el = tc_el.find("properties")
+            if props_el is None:
+                props_el = etree.Element("properties")
+                tc_el.insert(0, props_el)
+        for name, entry in per_name.items():
+            energy_str = "unknown"
+            if entry["mJ"] is not None:
+                energy_str = "{:.3f} mJ".format(entry["mJ"])
+            U_LOG.info("{}: {:.3f} uAh, {}, {:.1f} ms per operation ({} operation(s)).". \
+                       format(name, entry["uAh"], energy_str, entry["durationMs"],
+                              entry["count"]))
+            if props_el is not None:
+                for key, value in entry.items():
+                    if value is not None:
+                        if isinstance(value, float):
+                            value = "{:.3f}".format(value)
+                        etree.SubElement(props_el, "property",
+                                         name=f"energy.{name}.{key}",
+                                         value=str(value))
+    if tree is not None:
+        tree.write(markers_file, encoding='utf-8', pretty_print=True)
+    return 0
+
+if __name__ == "__main__":
+    PARSER = argparse.ArgumentParser(description="A script to pair the"  \
+                                     " energy markers printed by the"    \
+                                     " tests with a power-analyser"      \
+                                     " capture and report the charge"    \
+                                     " and energy consumed per operation.")
+    PARSER.add_argument("capture", help="the power-analyser capture, a"  \
+                        " CSV file with a header row.")
+    PARSER.add_argument("markers", help="the JUnit XML report written by" \
+                        " u_monitor.py, to which the results are added, or" \
+                        " a log file containing the markers.")
+    PARSER.add_argument("-t", default="0", help="the name or index of the" \
+                        " time column, in seconds (default 0).")
+    PARSER.add_argument("-i", default="1", help="the name or index of the" \
+                        " current column, in amps (default 1).")
+    PARSER.add_argument("-v", default=None, help="the name or index of the" \
+                        " voltage column, in volts.")
+    PARSER.add_argument("-m", default=None, help="the name or index of the" \
+                        " digital channel connected to the marker pin.")
+    PARSER.add_argument("-f", type=float, default=None, help="if there is no"  \
+                        " marker channel, the capture time in seconds of the" \
+                        " first \"begin\" marker.")
+    PARSER.add_argument("-n", type=float, default=None, help="if there is no"  \
+                        " voltage column, the nominal supply voltage to use.")
+    ARGS = PARSER.parse_args()
+
+    ULog.setup_logging()
+    sys.exit(run(ARGS.capture, ARGS.markers, ARGS.t, ARGS.i, ARGS.v, ARGS.m,
+                 ARGS.f, ARGS.n))
@@ -45,6 +45,7 @@ class TestCaseResult:
     status: str = None
     stdout: str = ""
     message: str = None
+    benchmarks: List[dict] = field(default_factory=list)
 
 @dataclass
 class TestResults:
@@ -164,6 +165,22 @@ def fail_callback(match, user_parameter, results: TestResults, reporter):
     msg = match.group(2)
     record_outcome(results, "FAIL", reporter, msg)
 
+def bench_callback(match, user_parameter, results: TestResults, reporter):
+    '''Handler for a benchmark result'''
+    del user_parameter
+    del reporter
+    bench = {"name": match.group(1),
+             "iterations": int(match.group(2)),
+             "elapsedMs": int(match.group(3)),
+             "units": int(match.group(4)),
+             "unit": match.group(5),
+             "perSecond": int(match.group(6))}
+    U_LOG.info("benchmark {}: {} {}/second ({} iteration(s) in {} ms).". \
+               format(bench["name"], bench["perSecond"], bench["unit"],
+                      bench["iterations"], bench["elapsedMs"]))
+    if results.current:
+        results.current.benchmarks.append(bench)
+
 def finish_callback(match, user_parameter, results: TestResults, reporter):
     '''Handler for a run finishing'''
     del user_parameter
@@ -211,6 +228,10 @@ INTERESTING = [[r"abort()", reboot_callback, None],
                # Match, for example "C:/temp/file.c:900:tcpEchoAsync:FAIL:Function sock.
                # Expression Evaluated To FALSE" capturing the "connectThings" part
                [r"(?:^.*?(?:\.c:))(?:[0-9]*:)(.*?):FAIL:(.*)", fail_callback, None],
+               # Match, for example "U_BENCH: name=ubxProtocolEncode iterations=2000
+               # elapsedMs=12 units=200000 unit=bytes perSecond=16666666" capturing the values
+               [r"U_BENCH: name=(\S+) iterations=([0-9]+) elapsedMs=([0-9]+)" \
+                r" units=([0-9]+) unit=(\S+) perSecond=([0-9]+)", bench_callback, None],
                # Match, for example "22 Tests 1 Failures 0 Ignored" capturing the numbers
                [r"(^[0-9]+) Test(?:s*) ([0-9]+) Failure(?:s*) ([0-9]+) Ignored", finish_callback, None]]
 
@@ -532,6 +553,15 @@ def main(connection_handle, connection_type, guard_time_seconds,
             for tc in results.test_cases:
                 tc_el = etree.SubElement(ts_el, "testcase", classname=f"ubxlib.instance_{instance_str}",
                                          name=tc.name, time=str(tc.duration), status=tc.status)
+                if tc.benchmarks:
+                    # Benchmark results are added as properties so that
+                    # they can be tracked from run to run
+                    props_el = etree.SubElement(tc_el, "properties")
+                    for bench in tc.benchmarks:
+                        for key in ["perSecond", "elapsedMs", "iterations", "units"]:
+                            etree.SubElement(props_el, "property",
+                                             name=f"bench.{bench['name']}.{key}",
+                                             value=str(bench[key]))
                 if tc.status == "FAIL":
                     etree.SubElement(tc_el, "failure", message=tc.message)
                 elif tc.status == "ERROR":
@@ -3,6 +3,8 @@
 '''Build the platform independent, non-test, non-example of ubxlib to establish static sizes.'''
 
 import os           # For sep(), getcwd()
+import shutil       # For copyfile()
+import hashlib      # For md5()
 from logging import Logger
 from scripts import u_report, u_utils, u_settings
 from scripts.u_logging import ULog
@@ -23,6 +25,17 @@ GNU_COMPILER = "arm-none-eabi-gcc"
 # Expected name for size
 GNU_SIZE = "arm-none-eabi-size"
 
+# Directory where a baseline of the size report is kept
+# for each configuration
+BASELINE_DIR = u_settings.STATIC_SIZE_BASELINE_DIR
+
+# The name of the size report written by the build
+REPORT_FILE_NAME = "static_size_float.json"
+
+# The sub-directory of the build directory where the
+# size report is written
+REPORT_SUBDIR = "float"
+
 # STATIC_SIZE directory (off ubxlib root)
 MAKEFILE_DIR = "port/platform/static_size"
 
@@ -58,6 +71,15 @@ def run(defines, ubxlib_dir, reporter):
         for define in defines:
             cflags +=" -D" + define
 
+    # Each combination of #defines has its own baseline
+    # size report, kept in a sub-directory named after
+    # a hash of the #defines
+    baseline_dir = BASELINE_DIR + os.sep + \
+                   hashlib.md5(" ".join(sorted(defines or [])).encode()).hexdigest()[:8]
+    baseline_file = baseline_dir + os.sep + REPORT_FILE_NAME
+    if os.path.isfile(baseline_file):
+        U_LOG.info("comparing sizes with baseline \"{}\"".format(baseline_file))
+
     # Assemble the call list
     # Call size on the result
     call_list = [
@@ -67,6 +89,7 @@ def run(defines, ubxlib_dir, reporter):
         "SIZE=" + GNU_INSTALL_ROOT + os.sep + GNU_SIZE,
         "OUTDIR=" + build_dir,
         "CFLAGS=" + cflags,
+        "SIZE_BASELINE_DIR=" + baseline_dir,
         "-j8",
         "float_size"
     ]
@@ -76,6 +99,15 @@ def run(defines, ubxlib_dir, reporter):
         return_value = 0
         reporter.event(u_report.EVENT_TYPE_BUILD,
                        u_report.EVENT_COMPLETE)
+        # If there is no baseline for this configuration
+        # yet, this run becomes the baseline; delete the
+        # baseline file to start again
+        report_file = build_dir + os.sep + REPORT_SUBDIR + os.sep + REPORT_FILE_NAME
+        if not os.path.isfile(baseline_file) and os.path.isfile(report_file):
+            if not os.path.isdir(baseline_dir):
+                os.makedirs(baseline_dir)
+            shutil.copyfile(report_file, baseline_file)
+            U_LOG.info("size report stored as the baseline in \"{}\"".format(baseline_file))
     else:
         reporter.event(u_report.EVENT_TYPE_BUILD,
                        u_report.EVENT_FAILED,
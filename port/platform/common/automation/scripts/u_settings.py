@@ -162,6 +162,10 @@ __DEFAULT_SETTINGS["DOXYGEN_DOXYFILE"] = "Doxyfile"
 #u_run_static_size.py
 __DEFAULT_SETTINGS["STATIC_SIZE_ARM_GNU_INSTALL_ROOT" + __SETTINGS_POSTFIX_AGENT_SPECIFIC] = \
     "C:/Program Files (x86)/GNU Arm Embedded Toolchain/10 2020-q4-major/bin"
+# Directory in which the per-subsystem size report of each
+# configuration is kept as the baseline for the next run
+__DEFAULT_SETTINGS["STATIC_SIZE_BASELINE_DIR" + __SETTINGS_POSTFIX_AGENT_SPECIFIC] = \
+    os.path.join(os.path.expanduser("~"), "static_size_baseline")
 # u_run_windows.py
 __DEFAULT_SETTINGS["WINDOWS_MSVC_BUILD_TOOLS_PATH" + __SETTINGS_POSTFIX_AGENT_SPECIFIC] =         \
     "C:\\Program Files (x86)\\Microsoft Visual Studio\\2022\\BuildTools"
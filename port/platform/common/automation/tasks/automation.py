@@ -5,7 +5,7 @@ from pathlib import PurePath
 from scripts import u_utils, u_data, u_connection, u_select, u_report
 from scripts import u_run_log, u_run_windows, u_run_linux, u_run_doxygen, u_run_astyle
 from scripts import u_run_pylint, u_run_static_size, u_run_no_floating_point
-from scripts import u_run_check_ubxlib_h
+from scripts import u_run_check_ubxlib_h, u_energy
 
 from scripts.packages import u_package
 from scripts.u_logging import ULog
@@ -307,6 +307,20 @@ def run(ctx, instance, build_dir=None, summary_file="summary.txt",
          summary_file=summary_file, debug_file=debug_file,
          test_report=test_report)
 
+@task()
+def energy(ctx, capture, test_report="test_report.xml", time_column="0",
+           current_column="1", voltage_column=None, marker_column=None,
+           first_begin_s=None, voltage=None):
+    """Add the energy per operation from a power-analyser capture to a test report"""
+    ULog.setup_logging()
+    if first_begin_s is not None:
+        first_begin_s = float(first_begin_s)
+    if voltage is not None:
+        voltage = float(voltage)
+    check_return_code(u_energy.run(capture, test_report, time_column,
+                                   current_column, voltage_column,
+                                   marker_column, first_begin_s, voltage))
+
 @task()
 def get_test_selection(ctx, message="", files="", run_everything=False):
     # Get the instance DATABASE by parsing the data file
@@ -24,6 +24,23 @@
  * protection) but, most importantly, means that no loop is required
  * to find a queue, ensuring the lowest possible latency so that
  * send-to-queue can safely be called from an interrupt.
+ *
+ * Design note: where U_PORT_EVENT_QUEUE_POOL_NUM_TASKS is non-zero
+ * an event queue may be served by a pool of worker tasks rather
+ * than by a task of its own.  Such an event queue still has its own
+ * OS queue, so that the order of its events is preserved, and each
+ * event sent to it is followed by an item on a single shared pool
+ * queue, carrying the handle of the event queue, which wakes up a
+ * worker.  A worker marks the event queue as busy while it empties
+ * it; an item arriving for a busy event queue is handed to the
+ * worker already on it, so the function of an event queue is never
+ * run by two workers at once.
+ *
+ * Design note: events sent with uPortEventQueueSendHighPriority()
+ * go onto a second OS queue which is emptied before each batch of
+ * events is taken from the main one; since a task can only block
+ * on one OS queue, a control word is also sent on the main OS
+ * queue to wake the task up.
  */
 
 #ifdef U_CFG_OVERRIDE
@@ -38,20 +55,28 @@
 #include "u_cfg_os_platform_specific.h"
 #include "u_error_common.h"
 #include "u_assert.h"
+#include "u_port.h"
 #include "u_port_os.h"
+#include "u_cfg_sw.h"
+#include "u_port_debug.h" // U_PORT_SPAN_BEGIN()/U_PORT_SPAN_END()
 
 #include "u_port_event_queue_private.h"
 #include "u_port_event_queue.h"
 
-#if defined(__NEWLIB__) && defined(_REENT_SMALL) && !_REENT_GLOBAL_STDIO_STREAMS
-#include "u_cfg_sw.h"
-#include "u_port_debug.h"
-#endif
-
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The length of the largest item there can be on an OS queue:
+ * the header plus the larger of the largest parameter block and
+ * a uEventQueueReference_t.
+ */
+#define U_EVENT_QUEUE_ITEM_MAX_LENGTH_BYTES (U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES +   \
+                                             ((U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES >       \
+                                               sizeof(uEventQueueReference_t)) ?                 \
+                                              U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES :        \
+                                              sizeof(uEventQueueReference_t)))
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -62,9 +87,24 @@ typedef struct uEventQueue_t {
     void (*pFunction)(void *, size_t); /** The function to be called. */
     int32_t handle;            /** Handle for this event queue. */
     uPortQueueHandle_t queue; /** Handle for the OS queue. */
-    size_t paramMaxLengthBytes; /** Max length of an item on this OS queue. */
+    uPortQueueHandle_t highPriorityQueue; /** Handle for the high priority OS queue,
+                                              NULL if there isn't one. */
+    size_t paramMaxLengthBytes; /** Max length of a parameter block. */
+    size_t itemSizeBytes; /** The length of an item on the OS queue(s). */
     uPortTaskHandle_t task; /** Handle for the OS task. */
     uPortMutexHandle_t taskRunningMutex; /** Mutex to determine if task has exited. */
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+    bool pooled; /** True if this event queue is served by the pool. */
+    int32_t poolSequence; /** Distinguishes this event queue from a previous one
+                              with the same handle. */
+    bool poolBusy; /** True while a worker is emptying the OS queue;
+                       task is then the handle of the worker task. */
+    bool poolPending; /** True if an item arrived while poolBusy was true. */
+    uint32_t poolDrainCount; /** Incremented each time a worker has emptied
+                                 the OS queue. */
+#endif
+    uPortEventQueueStats_t stats; /** Statistics, apart from latencyAverageMs. */
+    uint32_t latencyTotalMs; /** The sum of the latencies of stats.numEvents. */
 } uEventQueue_t;
 
 /** The control/size word, prefixed to the parameter block sent to
@@ -77,9 +117,48 @@ typedef enum {
                                                * be 32 bit so that it can
                                                * also be used as a size. */
     U_EVENT_CONTROL_NONE = 0,
-    U_EVENT_CONTROL_EXIT_NOW = -1
+    U_EVENT_CONTROL_EXIT_NOW = -1,
+    U_EVENT_CONTROL_WAKE_UP = -2, /* There are high priority events. */
+    U_EVENT_CONTROL_REFERENCE = -3 /* The block that follows is a
+                                      uEventQueueReference_t. */
 } uEventQueueControlOrSize_t;
 
+/** The header prefixed to the parameter block sent to the queue,
+ * of length U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES.
+ */
+typedef struct {
+    uEventQueueControlOrSize_t controlOrSize;
+    int32_t timeMs; /* The time at which the block was sent. */
+} uEventQueueHeader_t;
+
+/** What is sent on the OS queue, after the header, for an event
+ * sent with uPortEventQueueSendRef().
+ */
+typedef struct {
+    void *pBlock;
+    size_t blockLengthBytes;
+    void (*pFree)(void *);
+} uEventQueueReference_t;
+
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+
+/** An item on the pool queue.
+ */
+typedef struct {
+    int32_t handle;   /** The event queue that has an event, negative
+                          to tell the worker to exit. */
+    int32_t sequence; /** The poolSequence of that event queue. */
+} uEventQueuePoolItem_t;
+
+/** A worker task in the pool.
+ */
+typedef struct {
+    uPortTaskHandle_t task; /** Handle for the OS task. */
+    uPortMutexHandle_t taskRunningMutex; /** Mutex to determine if task has exited. */
+} uEventQueuePoolWorker_t;
+
+#endif
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -93,21 +172,35 @@ static uPortMutexHandle_t gMutex = NULL;
  */
 static uEventQueue_t *gpEventQueue[U_PORT_EVENT_QUEUE_MAX_NUM];
 
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+
+/** Mutex to protect the pool fields of the event queues; this is
+ * separate to gMutex since uPortEventQueueClose() holds gMutex
+ * while it waits for a worker to finish with an event queue.
+ */
+static uPortMutexHandle_t gPoolMutex = NULL;
+
+/** The queue on which the workers in the pool are woken up.
+ */
+static uPortQueueHandle_t gPoolQueue = NULL;
+
+/** The worker tasks of the pool.
+ */
+static uEventQueuePoolWorker_t gPoolWorker[U_PORT_EVENT_QUEUE_POOL_NUM_TASKS];
+
+/** The sequence number to give to the next pooled event queue.
+ */
+static int32_t gPoolSequence = 0;
+
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
-// Run the user function.  This will be run multiple times in a
-// task of its own.
-static void eventQueueTask(void *pParam)
+// Called at the start of a task that runs user functions.
+static void eventQueueTaskStart(void)
 {
-    uEventQueue_t *pEventQueue = (uEventQueue_t *) pParam;
-    char param[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES +
-                                                               U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES];
-    uEventQueueControlOrSize_t *pControlOrSize = (uEventQueueControlOrSize_t *)
-                                                 & (param[0]);
-
-    U_PORT_MUTEX_LOCK(pEventQueue->taskRunningMutex);
 #if defined(__NEWLIB__) && defined(_REENT_SMALL) && \
     !defined(_REENT_GLOBAL_STDIO_STREAMS) && !defined(_UNBUF_STREAM_OPT)
     // This is a temporary workaround to prevent false memory leak failures
@@ -121,25 +214,122 @@ static void eventQueueTask(void *pParam)
     // Note: If this is enabled for ESP32 it will crash... (?)
     uPortLog("");
 #endif
+}
+
+// Call the user function of an event queue with a block received
+// from its OS queue, unless the block is a control message, and
+// update the statistics; returns the number of events handled,
+// i.e. 1 or, for a control message, 0.
+static size_t eventQueueCall(uEventQueue_t *pEventQueue, char *pParam,
+                             bool highPriority)
+{
+    //lint -e(826) Suppress area too small; pParam is always at least
+    // U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
+    uEventQueueHeader_t *pHeader = (uEventQueueHeader_t *) pParam;
+    uEventQueueControlOrSize_t *pControlOrSize = &(pHeader->controlOrSize);
+    uPortEventQueueStats_t *pStats = &(pEventQueue->stats);
+    uEventQueueReference_t reference;
+    size_t numEvents = 0;
+    int32_t latencyMs;
+
+    // If this is not a control message, call the
+    // user function with the parameter block,
+    // skipping the "control or size" word at the
+    // start and passing it in instead as the size
+    // parameter or, if the parameter block was sent
+    // by reference, with the referenced block, which
+    // is then given back to its owner
+    if (((int32_t) *pControlOrSize >= 0) ||
+        (*pControlOrSize == U_EVENT_CONTROL_REFERENCE)) {
+        U_PORT_SPAN_BEGIN("eventQueue");
+        if (*pControlOrSize == U_EVENT_CONTROL_REFERENCE) {
+            memcpy(&reference, pParam + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+                   sizeof(reference));
+            pEventQueue->pFunction(reference.pBlock, reference.blockLengthBytes);
+            if (reference.pFree != NULL) {
+                reference.pFree(reference.pBlock);
+            }
+        } else if ((int32_t) *pControlOrSize > 0) {
+            pEventQueue->pFunction((void *) (pParam +
+                                             U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES),
+                                   // Cast in two stages to keep Lint happy
+                                   (size_t) (int32_t) *pControlOrSize);
+        } else {
+            pEventQueue->pFunction(NULL, 0);
+        }
+        U_PORT_SPAN_END();
+        // Only this task writes the statistics
+        latencyMs = uPortGetTickTimeMs() - pHeader->timeMs;
+        if (latencyMs < 0) {
+            latencyMs = 0;
+        }
+        pStats->numEvents++;
+        if (highPriority) {
+            pStats->numHighPriorityEvents++;
+        }
+        pEventQueue->latencyTotalMs += (uint32_t) latencyMs;
+        if (latencyMs > pStats->latencyMaxMs) {
+            pStats->latencyMaxMs = latencyMs;
+        }
+        numEvents = 1;
+    }
+
+    return numEvents;
+}
+
+// Handle everything on the high priority OS queue of an event
+// queue, returning the number of events handled.
+static size_t eventQueueHighPriorityCall(uEventQueue_t *pEventQueue, char *pParam)
+{
+    size_t numEvents = 0;
+
+    if (pEventQueue->highPriorityQueue != NULL) {
+        while (uPortQueueTryReceive(pEventQueue->highPriorityQueue, 0, pParam) == 0) {
+            numEvents += eventQueueCall(pEventQueue, pParam, true);
+        }
+    }
+
+    return numEvents;
+}
+
+// Update the maximum batch size of an event queue.
+static void eventQueueBatchDone(uEventQueue_t *pEventQueue, size_t batchSize)
+{
+    if (batchSize > pEventQueue->stats.batchSizeMax) {
+        pEventQueue->stats.batchSizeMax = batchSize;
+    }
+}
+
+// Run the user function.  This will be run multiple times in a
+// task of its own.
+static void eventQueueTask(void *pParam)
+{
+    uEventQueue_t *pEventQueue = (uEventQueue_t *) pParam;
+    char param[U_EVENT_QUEUE_ITEM_MAX_LENGTH_BYTES];
+    uEventQueueControlOrSize_t *pControlOrSize = (uEventQueueControlOrSize_t *)
+                                                 & (param[0]);
+    bool exitNow = false;
+    size_t batchSize;
+
+    U_PORT_MUTEX_LOCK(pEventQueue->taskRunningMutex);
+    eventQueueTaskStart();
 
-    *pControlOrSize = U_EVENT_CONTROL_NONE;
     // Continue until we're told to exit
-    while (*pControlOrSize != U_EVENT_CONTROL_EXIT_NOW) {
+    while (!exitNow) {
         if (uPortQueueReceive(pEventQueue->queue, param) == 0) {
-            // If this is not a control message, call the
-            // user function with the parameter block,
-            // skipping the "control or size" word at the
-            // start and passing it in instead as the size
-            // parameter
-            if ((int32_t) *pControlOrSize >= 0) {
-                if ((int32_t) *pControlOrSize > 0) {
-                    pEventQueue->pFunction((void *) & (param[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES]),
-                                           // Cast in two stages to keep Lint happy
-                                           (size_t) (int32_t) *pControlOrSize);
-                } else {
-                    pEventQueue->pFunction(NULL, 0);
+            exitNow = (*pControlOrSize == U_EVENT_CONTROL_EXIT_NOW);
+            batchSize = eventQueueCall(pEventQueue, param, false);
+            if (!exitNow) {
+                // Handle any high priority events, then up
+                // to a batch of events without checking again
+                batchSize += eventQueueHighPriorityCall(pEventQueue, param);
+                for (size_t x = 1; !exitNow && (x < U_PORT_EVENT_QUEUE_BATCH_MAX_NUM) &&
+                     (uPortQueueTryReceive(pEventQueue->queue, 0, param) == 0); x++) {
+                    exitNow = (*pControlOrSize == U_EVENT_CONTROL_EXIT_NOW);
+                    batchSize += eventQueueCall(pEventQueue, param, false);
                 }
             }
+            eventQueueBatchDone(pEventQueue, batchSize);
         }
     }
 
@@ -149,6 +339,68 @@ static void eventQueueTask(void *pParam)
     uPortTaskDelete(NULL);
 }
 
+// Create the OS queue(s) of an event queue.
+static int32_t osQueuesCreate(uEventQueue_t *pEventQueue, size_t queueLength)
+{
+    int32_t errorCode;
+    size_t itemSizeBytes = pEventQueue->paramMaxLengthBytes;
+
+    // There must always be room for a reference
+    if (itemSizeBytes < sizeof(uEventQueueReference_t)) {
+        itemSizeBytes = sizeof(uEventQueueReference_t);
+    }
+    itemSizeBytes += U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES;
+    pEventQueue->itemSizeBytes = itemSizeBytes;
+    pEventQueue->highPriorityQueue = NULL;
+    errorCode = uPortQueueCreate(queueLength, itemSizeBytes, &(pEventQueue->queue));
+#if U_PORT_EVENT_QUEUE_HIGH_PRIORITY_QUEUE_LENGTH > 0
+    if (errorCode == 0) {
+        errorCode = uPortQueueCreate(U_PORT_EVENT_QUEUE_HIGH_PRIORITY_QUEUE_LENGTH,
+                                     itemSizeBytes, &(pEventQueue->highPriorityQueue));
+        if (errorCode != 0) {
+            uPortQueueDelete(pEventQueue->queue);
+            pEventQueue->highPriorityQueue = NULL;
+        }
+    }
+#endif
+
+    return errorCode;
+}
+
+// Give back any blocks sent by reference that are still on
+// an OS queue, emptying it.
+static void osQueueReferencesFree(uPortQueueHandle_t queue)
+{
+    char param[U_EVENT_QUEUE_ITEM_MAX_LENGTH_BYTES];
+    uEventQueueReference_t reference;
+
+    while (uPortQueueTryReceive(queue, 0, param) == 0) {
+        //lint -e(826) Suppress area too small
+        if (*((uEventQueueControlOrSize_t *) param) == U_EVENT_CONTROL_REFERENCE) {
+            memcpy(&reference, param + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+                   sizeof(reference));
+            if (reference.pFree != NULL) {
+                reference.pFree(reference.pBlock);
+            }
+        }
+    }
+}
+
+// Delete the OS queue(s) of an event queue, returning the
+// result of deleting the main one; any blocks sent by reference
+// that were never handled are given back first.
+static int32_t osQueuesDelete(uEventQueue_t *pEventQueue)
+{
+    osQueueReferencesFree(pEventQueue->queue);
+    if (pEventQueue->highPriorityQueue != NULL) {
+        osQueueReferencesFree(pEventQueue->highPriorityQueue);
+        uPortQueueDelete(pEventQueue->highPriorityQueue);
+        pEventQueue->highPriorityQueue = NULL;
+    }
+
+    return uPortQueueDelete(pEventQueue->queue);
+}
+
 // Get the next free event handle.
 static int32_t nextEventHandleGet()
 {
@@ -165,45 +417,111 @@ static int32_t nextEventHandleGet()
     return handle;
 }
 
-// Close an event queue.
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+
+// Close an event queue that is served by the pool.
 // The mutex must be locked before this is called.
-static int32_t eventQueueClose(uEventQueue_t *pEventQueue)
+static int32_t eventQueuePoolClose(uEventQueue_t *pEventQueue)
 {
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-    void *pControl;
+    int32_t errorCode;
+    uEventQueuePoolItem_t item;
+    uint32_t drainCount;
+    bool drained = false;
+
+    item.handle = pEventQueue->handle;
+    item.sequence = pEventQueue->poolSequence;
+
+    U_PORT_MUTEX_LOCK(gPoolMutex);
+    drainCount = pEventQueue->poolDrainCount;
+    U_PORT_MUTEX_UNLOCK(gPoolMutex);
+
+    // Send an item of our own to the pool, persisting until it
+    // is done, which makes sure that a worker gets to this event
+    // queue even if the item for an event sent from an interrupt
+    // didn't fit on the pool queue; then wait for a worker to
+    // have emptied the event queue since we started
+    while (uPortQueueSend(gPoolQueue, &item) != 0) {
+        uPortTaskBlock(10);
+    }
+    while (!drained) {
+
+        U_PORT_MUTEX_LOCK(gPoolMutex);
+
+        drained = !pEventQueue->poolBusy &&
+                  (pEventQueue->poolDrainCount != drainCount);
+        if (drained) {
+            // Remove it from the list while we have the pool
+            // mutex, so that no worker can pick it up again
+            gpEventQueue[pEventQueue->handle] = NULL;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gPoolMutex);
 
-    // It would be nice to send just U_EVENT_CONTROL_EXIT_NOW
-    // on its own here but, as address sanitizer points out,
-    // the uPortQueueSend() function must copy the required
-    // length for an item on the queue so it has to be
-    // given that data size, hence we malloc() the block,
-    // put U_EVENT_CONTROL_EXIT_NOW at the start of it and
-    // then free it once it is sent
-    pControl = malloc(pEventQueue->paramMaxLengthBytes +
-                      U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-
-    if (pControl != NULL) {
-        *((uEventQueueControlOrSize_t *) pControl) = U_EVENT_CONTROL_EXIT_NOW;
-        // Get the task to exit, persisting until it is done
-        while (uPortQueueSend(pEventQueue->queue, pControl) != 0) {
+        if (!drained) {
             uPortTaskBlock(10);
         }
-        free(pControl);
-        U_PORT_MUTEX_LOCK(pEventQueue->taskRunningMutex);
-        U_PORT_MUTEX_UNLOCK(pEventQueue->taskRunningMutex);
+    }
 
-        // Tidy up
-        uPortMutexDelete(pEventQueue->taskRunningMutex);
-        errorCode = uPortQueueDelete(pEventQueue->queue);
+    // Tidy up
+    errorCode = osQueuesDelete(pEventQueue);
 
-        // Pause here to allow the deletions
-        // above to actually occur in the idle thread,
-        // required by some RTOSs (e.g. FreeRTOS)
-        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    // Pause here to allow the deletion
+    // above to actually occur in the idle thread,
+    // required by some RTOSs (e.g. FreeRTOS)
+    uPortTaskBlock(U_CFG_OS_YIELD_MS);
 
-        // Now remove it from the list and free it
-        gpEventQueue[pEventQueue->handle] = NULL;
-        free(pEventQueue);
+    free(pEventQueue);
+
+    return errorCode;
+}
+
+#endif
+
+// Close an event queue.
+// The mutex must be locked before this is called.
+static int32_t eventQueueClose(uEventQueue_t *pEventQueue)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    void *pControl;
+
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+    if (pEventQueue->pooled) {
+        errorCode = eventQueuePoolClose(pEventQueue);
+    } else
+#endif
+    {
+        // It would be nice to send just U_EVENT_CONTROL_EXIT_NOW
+        // on its own here but, as address sanitizer points out,
+        // the uPortQueueSend() function must copy the required
+        // length for an item on the queue so it has to be
+        // given that data size, hence we malloc() the block,
+        // put U_EVENT_CONTROL_EXIT_NOW at the start of it and
+        // then free it once it is sent
+        pControl = malloc(pEventQueue->itemSizeBytes);
+
+        if (pControl != NULL) {
+            *((uEventQueueControlOrSize_t *) pControl) = U_EVENT_CONTROL_EXIT_NOW;
+            // Get the task to exit, persisting until it is done
+            while (uPortQueueSend(pEventQueue->queue, pControl) != 0) {
+                uPortTaskBlock(10);
+            }
+            free(pControl);
+            U_PORT_MUTEX_LOCK(pEventQueue->taskRunningMutex);
+            U_PORT_MUTEX_UNLOCK(pEventQueue->taskRunningMutex);
+
+            // Tidy up
+            uPortMutexDelete(pEventQueue->taskRunningMutex);
+            errorCode = osQueuesDelete(pEventQueue);
+
+            // Pause here to allow the deletions
+            // above to actually occur in the idle thread,
+            // required by some RTOSs (e.g. FreeRTOS)
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+
+            // Now remove it from the list and free it
+            gpEventQueue[pEventQueue->handle] = NULL;
+            free(pEventQueue);
+        }
     }
 
     return errorCode;
@@ -223,6 +541,275 @@ static inline uEventQueue_t *pEventQueueGet(int32_t handle)
     return pEventQueue;
 }
 
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+
+// A worker task of the pool: empty whichever event queue it is
+// told about, unless another worker is already doing so.
+static void eventQueuePoolTask(void *pParam)
+{
+    uEventQueuePoolWorker_t *pWorker = (uEventQueuePoolWorker_t *) pParam;
+    uEventQueuePoolItem_t item = {0};
+    uEventQueue_t *pEventQueue;
+    char param[U_EVENT_QUEUE_ITEM_MAX_LENGTH_BYTES];
+    bool keepGoing;
+    size_t batchSize;
+
+    U_PORT_MUTEX_LOCK(pWorker->taskRunningMutex);
+    eventQueueTaskStart();
+
+    // Continue until we're told to exit
+    while (item.handle >= 0) {
+        if ((uPortQueueReceive(gPoolQueue, &item) == 0) && (item.handle >= 0)) {
+
+            U_PORT_MUTEX_LOCK(gPoolMutex);
+
+            pEventQueue = pEventQueueGet(item.handle);
+            if ((pEventQueue != NULL) && pEventQueue->pooled &&
+                (pEventQueue->poolSequence == item.sequence)) {
+                if (pEventQueue->poolBusy) {
+                    // Another worker is emptying this event
+                    // queue, let it know there is more
+                    pEventQueue->poolPending = true;
+                    pEventQueue = NULL;
+                } else {
+                    pEventQueue->poolBusy = true;
+                    pEventQueue->task = pWorker->task;
+                }
+            } else {
+                // The event queue has been closed since the
+                // item was sent
+                pEventQueue = NULL;
+            }
+
+            U_PORT_MUTEX_UNLOCK(gPoolMutex);
+
+            keepGoing = (pEventQueue != NULL);
+            while (keepGoing) {
+                // High priority events first, then up to a batch
+                batchSize = eventQueueHighPriorityCall(pEventQueue, param);
+                for (size_t x = 0; (x < U_PORT_EVENT_QUEUE_BATCH_MAX_NUM) &&
+                     (uPortQueueTryReceive(pEventQueue->queue, 0, param) == 0); x++) {
+                    batchSize += eventQueueCall(pEventQueue, param, false);
+                }
+                if (batchSize > 0) {
+                    eventQueueBatchDone(pEventQueue, batchSize);
+                } else {
+                    // Empty: stop unless something arrived that
+                    // another worker handed to us while we were busy
+
+                    U_PORT_MUTEX_LOCK(gPoolMutex);
+
+                    keepGoing = pEventQueue->poolPending;
+                    pEventQueue->poolPending = false;
+                    if (!keepGoing) {
+                        pEventQueue->poolBusy = false;
+                        pEventQueue->task = NULL;
+                        pEventQueue->poolDrainCount++;
+                    }
+
+                    U_PORT_MUTEX_UNLOCK(gPoolMutex);
+                }
+            }
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pWorker->taskRunningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+// Stop the worker tasks of the pool and free its resources.
+static void poolStop(void)
+{
+    uEventQueuePoolItem_t item = {-1, 0};
+    uEventQueuePoolWorker_t *pWorker;
+
+    for (size_t x = 0; x < sizeof(gPoolWorker) / sizeof(gPoolWorker[0]); x++) {
+        pWorker = &(gPoolWorker[x]);
+        if (pWorker->task != NULL) {
+            // Get a worker to exit, persisting until it is done;
+            // any of them may pick this up, so wait on this one
+            // only after all have been told
+            while (uPortQueueSend(gPoolQueue, &item) != 0) {
+                uPortTaskBlock(10);
+            }
+        }
+    }
+    for (size_t x = 0; x < sizeof(gPoolWorker) / sizeof(gPoolWorker[0]); x++) {
+        pWorker = &(gPoolWorker[x]);
+        if (pWorker->task != NULL) {
+            U_PORT_MUTEX_LOCK(pWorker->taskRunningMutex);
+            U_PORT_MUTEX_UNLOCK(pWorker->taskRunningMutex);
+            pWorker->task = NULL;
+        }
+        if (pWorker->taskRunningMutex != NULL) {
+            uPortMutexDelete(pWorker->taskRunningMutex);
+            pWorker->taskRunningMutex = NULL;
+        }
+    }
+    if (gPoolQueue != NULL) {
+        uPortQueueDelete(gPoolQueue);
+        gPoolQueue = NULL;
+    }
+    if (gPoolMutex != NULL) {
+        uPortMutexDelete(gPoolMutex);
+        gPoolMutex = NULL;
+    }
+
+    // Pause here to allow the deletions
+    // above to actually occur in the idle thread,
+    // required by some RTOSs (e.g. FreeRTOS)
+    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+}
+
+// Create the pool and start its worker tasks.
+static int32_t poolStart(void)
+{
+    int32_t errorCode;
+    uEventQueuePoolWorker_t *pWorker;
+
+    memset(gPoolWorker, 0, sizeof(gPoolWorker));
+    errorCode = uPortMutexCreate(&gPoolMutex);
+    if (errorCode == 0) {
+        errorCode = uPortQueueCreate(U_PORT_EVENT_QUEUE_POOL_QUEUE_LENGTH,
+                                     sizeof(uEventQueuePoolItem_t), &gPoolQueue);
+    }
+    for (size_t x = 0; (errorCode == 0) &&
+         (x < sizeof(gPoolWorker) / sizeof(gPoolWorker[0])); x++) {
+        pWorker = &(gPoolWorker[x]);
+        errorCode = uPortMutexCreate(&(pWorker->taskRunningMutex));
+        if (errorCode == 0) {
+            errorCode = uPortTaskCreate(eventQueuePoolTask, "eventQueuePool",
+                                        U_PORT_EVENT_QUEUE_POOL_STACK_SIZE_BYTES,
+                                        (void *) pWorker,
+                                        U_PORT_EVENT_QUEUE_POOL_PRIORITY,
+                                        &(pWorker->task));
+            if (errorCode == 0) {
+                // Wait for the worker to lock the mutex,
+                // which shows it is running
+                while (uPortMutexTryLock(pWorker->taskRunningMutex, 0) == 0) {
+                    uPortMutexUnlock(pWorker->taskRunningMutex);
+                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                }
+            } else {
+                pWorker->task = NULL;
+            }
+        }
+    }
+    if (errorCode != 0) {
+        poolStop();
+    }
+
+    return errorCode;
+}
+
+#endif
+
+// Send to an event queue, optionally at high priority; if
+// pReference is not NULL it is sent instead of pParam, which
+// must then be NULL, and no memory is allocated.
+static int32_t eventQueueSend(int32_t handle, const void *pParam,
+                              size_t paramLengthBytes, bool highPriority,
+                              const uEventQueueReference_t *pReference)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uEventQueue_t *pEventQueue;
+    char *pBlock = NULL;
+    char referenceBlock[U_EVENT_QUEUE_ITEM_MAX_LENGTH_BYTES];
+    uPortQueueHandle_t queue = NULL;
+    uPortQueueHandle_t wakeUpQueue = NULL;
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+    uEventQueuePoolItem_t item = {-1, 0};
+#endif
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        pEventQueue = pEventQueueGet(handle);
+        if ((pEventQueue != NULL) &&
+            (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
+            ((pParam != NULL) || (paramLengthBytes == 0))) {
+            queue = pEventQueue->queue;
+            if (highPriority && (pEventQueue->highPriorityQueue != NULL)) {
+                queue = pEventQueue->highPriorityQueue;
+                wakeUpQueue = pEventQueue->queue;
+            }
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+            if (pEventQueue->pooled) {
+                item.handle = handle;
+                item.sequence = pEventQueue->poolSequence;
+                // The pool item does the waking up
+                wakeUpQueue = NULL;
+            }
+#endif
+            errorCode = U_ERROR_COMMON_NO_MEMORY;
+            if (pReference != NULL) {
+                // Only the reference goes on the queue, which
+                // always fits in referenceBlock
+                pBlock = referenceBlock;
+                //lint -e(826) Suppress area too small
+                *((uEventQueueControlOrSize_t *) pBlock) = U_EVENT_CONTROL_REFERENCE;
+                ((uEventQueueHeader_t *) pBlock)->timeMs = uPortGetTickTimeMs();
+                memcpy(pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+                       pReference, sizeof(*pReference));
+            } else {
+                // We need to add the control word to the start, so malloc
+                // a block that is the item size of the queue (i.e. not
+                // just the paramLengthBytes passed in, since
+                // uPortQueueSend() will expect to copy the full length)
+                pBlock = (char *) malloc(pEventQueue->itemSizeBytes);
+            }
+            if ((pBlock != NULL) && (pReference == NULL)) {
+                // Copy in the control word, which is actually just
+                // the size in this case
+                //lint -e(826) Suppress area too small; the size of pBlock is always
+                // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
+                *((uEventQueueControlOrSize_t *) pBlock) = (uEventQueueControlOrSize_t) paramLengthBytes;
+                ((uEventQueueHeader_t *) pBlock)->timeMs = uPortGetTickTimeMs();
+                if (pParam != NULL) {
+                    // Copy in param
+                    //lint -e{826} Suppress pointed-to area too small, we make sure it is OK above
+                    memcpy(pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+                           pParam, paramLengthBytes);
+                }
+            }
+        }
+
+        // We release the mutex before sending to the
+        // queue since the send process may block (e.g.
+        // if the queue is full) and we don't want
+        // that to block the entire API
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
+        if (pBlock != NULL) {
+            if (queue != NULL) {
+                // Send it off
+                errorCode = (uErrorCode_t) uPortQueueSend(queue, pBlock);
+                if ((errorCode == U_ERROR_COMMON_SUCCESS) && (wakeUpQueue != NULL)) {
+                    // Wake the task up, re-using the block
+                    *((uEventQueueControlOrSize_t *) pBlock) = U_EVENT_CONTROL_WAKE_UP;
+                    errorCode = (uErrorCode_t) uPortQueueSend(wakeUpQueue, pBlock);
+                }
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+                if ((errorCode == U_ERROR_COMMON_SUCCESS) && (item.handle >= 0)) {
+                    // Wake up a worker to deal with it
+                    errorCode = (uErrorCode_t) uPortQueueSend(gPoolQueue, &item);
+                }
+#endif
+            }
+            if (pBlock != referenceBlock) {
+                // Free memory again
+                free(pBlock);
+            }
+        }
+    }
+
+    return (int32_t) errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: BUT ONES THAT SHOULD BE CALLED INTERNALLY ONLY
  * -------------------------------------------------------------- */
@@ -245,6 +832,15 @@ int32_t uPortEventQueuePrivateInit(void)
         }
         // Allocate the mutex to protect the table
         errorCode = uPortMutexCreate(&gMutex);
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+        if (errorCode == 0) {
+            errorCode = poolStart();
+            if (errorCode != 0) {
+                uPortMutexDelete(gMutex);
+                gMutex = NULL;
+            }
+        }
+#endif
     }
 
     return errorCode;
@@ -273,6 +869,11 @@ void uPortEventQueuePrivateDeinit(void)
 
         U_PORT_MUTEX_UNLOCK(gMutex);
 
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+        // With no event queues left the pool can go
+        poolStop();
+#endif
+
         // Finally delete the mutex
         uPortMutexDelete(gMutex);
         gMutex = NULL;
@@ -317,11 +918,34 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                 if (pEventQueue != NULL) {
                     pEventQueue->pFunction = pFunction;
                     pEventQueue->paramMaxLengthBytes = paramMaxLengthBytes;
-                    // Create the queue
-                    handleOrError = (uErrorCode_t) uPortQueueCreate(queueLength,
-                                                                    paramMaxLengthBytes +
-                                                                    U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                                                                    &(pEventQueue->queue));
+                    memset(&(pEventQueue->stats), 0, sizeof(pEventQueue->stats));
+                    pEventQueue->latencyTotalMs = 0;
+                    // Create the queue(s)
+                    handleOrError = (uErrorCode_t) osQueuesCreate(pEventQueue, queueLength);
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+                    pEventQueue->pooled =
+                        (stackSizeBytes <= U_PORT_EVENT_QUEUE_POOL_STACK_SIZE_BYTES) &&
+                        (priority <= U_PORT_EVENT_QUEUE_POOL_PRIORITY);
+                    pEventQueue->poolBusy = false;
+                    pEventQueue->poolPending = false;
+                    pEventQueue->poolDrainCount = 0;
+                    pEventQueue->task = NULL;
+                    pEventQueue->taskRunningMutex = NULL;
+                    if ((handleOrError == U_ERROR_COMMON_SUCCESS) && pEventQueue->pooled) {
+                        // No task needed, the pool will serve it: add
+                        // the event queue structure to the list, with
+                        // the pool mutex locked as the workers look
+                        // at the list
+                        U_PORT_MUTEX_LOCK(gPoolMutex);
+                        pEventQueue->poolSequence = gPoolSequence;
+                        gPoolSequence++;
+                        pEventQueue->handle = handle;
+                        gpEventQueue[handle] = pEventQueue;
+                        U_PORT_MUTEX_UNLOCK(gPoolMutex);
+                        // Return the handle
+                        handleOrError = (uErrorCode_t) handle;
+                    } else
+#endif
                     if (handleOrError == U_ERROR_COMMON_SUCCESS) {
                         // Create the mutex for task running status
                         handleOrError = (uErrorCode_t) uPortMutexCreate(&(pEventQueue->taskRunningMutex));
@@ -352,13 +976,13 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                                 // Couldn't create the task, delete the
                                 // mutex and queue and free the structure
                                 uPortMutexDelete(pEventQueue->taskRunningMutex);
-                                uPortQueueDelete(pEventQueue->queue);
+                                osQueuesDelete(pEventQueue);
                                 free(pEventQueue);
                             }
                         } else {
                             // Couldn't create the mutex, delete the queue
                             // and free the structure
-                            uPortQueueDelete(pEventQueue->queue);
+                            osQueuesDelete(pEventQueue);
                             free(pEventQueue);
                         }
                     } else {
@@ -379,61 +1003,32 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
 int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
                             size_t paramLengthBytes)
 {
-    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
-    uEventQueue_t *pEventQueue;
-    char *pBlock = NULL;
-    uPortQueueHandle_t queue = NULL;
-
-    if (gMutex != NULL) {
-
-        U_PORT_MUTEX_LOCK(gMutex);
-
-        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        pEventQueue = pEventQueueGet(handle);
-        if ((pEventQueue != NULL) &&
-            (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
-            ((pParam != NULL) || (paramLengthBytes == 0))) {
-            queue = pEventQueue->queue;
-            errorCode = U_ERROR_COMMON_NO_MEMORY;
-            // We need to add the control word to the start, so malloc
-            // a block that is paramMaxLengthBytes (i.e. paramMaxLengthBytes
-            // of the queue, not just the paramLengthBytes passed in, since
-            // uPortQueueSend() will expect to copy the full length) plus
-            // plus the control word length
-            pBlock = (char *) malloc(pEventQueue->paramMaxLengthBytes +
-                                     U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-            if (pBlock != NULL) {
-                // Copy in the control word, which is actually just
-                // the size in this case
-                //lint -e(826) Suppress area too small; the size of pBlock is always
-                // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
-                *((uEventQueueControlOrSize_t *) pBlock) = (uEventQueueControlOrSize_t) paramLengthBytes;
-                if (pParam != NULL) {
-                    // Copy in param
-                    //lint -e{826} Suppress pointed-to area too small, we make sure it is OK above
-                    memcpy(pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                           pParam, paramLengthBytes);
-                }
-            }
-        }
+    return eventQueueSend(handle, pParam, paramLengthBytes, false, NULL);
+}
 
-        // We release the mutex before sending to the
-        // queue since the send process may block (e.g.
-        // if the queue is full) and we don't want
-        // that to block the entire API
-        U_PORT_MUTEX_UNLOCK(gMutex);
+// Send to an event queue at high priority.
+int32_t uPortEventQueueSendHighPriority(int32_t handle, const void *pParam,
+                                        size_t paramLengthBytes)
+{
+    return eventQueueSend(handle, pParam, paramLengthBytes, true, NULL);
+}
 
-        if (pBlock != NULL) {
-            if (queue != NULL) {
-                // Send it off
-                errorCode = (uErrorCode_t) uPortQueueSend(queue, pBlock);
-            }
-            // Free memory again
-            free(pBlock);
-        }
+// Send a block to an event queue by reference.
+int32_t uPortEventQueueSendRef(int32_t handle, void *pBlock,
+                               size_t blockLengthBytes,
+                               void (*pFree)(void *))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uEventQueueReference_t reference;
+
+    if (pBlock != NULL) {
+        reference.pBlock = pBlock;
+        reference.blockLengthBytes = blockLengthBytes;
+        reference.pFree = pFree;
+        errorCode = eventQueueSend(handle, NULL, 0, false, &reference);
     }
 
-    return (int32_t) errorCode;
+    return errorCode;
 }
 
 // Send to an event queue from an interrupt.
@@ -443,8 +1038,6 @@ int32_t uPortEventQueueSendIrq(int32_t handle, const void *pParam,
 #ifndef _WIN32
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
     uEventQueue_t *pEventQueue;
-    char block[paramLengthBytes +
-                                U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES];
 
     if (gMutex != NULL) {
         // Can't lock the mutex, we're in an interrupt.
@@ -453,12 +1046,16 @@ int32_t uPortEventQueueSendIrq(int32_t handle, const void *pParam,
         if ((pEventQueue != NULL) &&
             (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
             ((pParam != NULL) || (paramLengthBytes == 0))) {
+            // Must be a whole item since uPortQueueSendIrq()
+            // copies that much
+            char block[pEventQueue->itemSizeBytes];
             // Copy in the control word, which is actually just
             // the size in this case
             //lint -e(826) Suppress area too small; the size of pBlock is always
             // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
             uEventQueueControlOrSize_t *pControlOrSize = (uEventQueueControlOrSize_t *) block;
             *pControlOrSize = (uEventQueueControlOrSize_t) paramLengthBytes;
+            ((uEventQueueHeader_t *) block)->timeMs = uPortGetTickTimeMs();
             if (pParam != NULL) {
                 // Copy in param
                 memcpy(block + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
@@ -467,6 +1064,17 @@ int32_t uPortEventQueueSendIrq(int32_t handle, const void *pParam,
             // Send it off
             errorCode = (uErrorCode_t) uPortQueueSendIrq(pEventQueue->queue,
                                                          block);
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+            if ((errorCode == U_ERROR_COMMON_SUCCESS) && pEventQueue->pooled) {
+                // Wake up a worker to deal with it; if the pool queue
+                // is full the event is still on the event queue and
+                // will be dealt with when the next item for this
+                // event queue arrives, so don't report an error,
+                // which might cause the event to be sent twice
+                uEventQueuePoolItem_t item = {handle, pEventQueue->poolSequence};
+                uPortQueueSendIrq(gPoolQueue, &item);
+            }
+#endif
         }
     }
 #else
@@ -498,7 +1106,15 @@ bool uPortEventQueueIsTask(int32_t handle)
 
         pEventQueue = pEventQueueGet(handle);
         if (pEventQueue != NULL) {
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+            // For an event queue served by the pool, task is only
+            // the worker task while the worker is busy with it
+            isEventTask = (!pEventQueue->pooled || pEventQueue->poolBusy) &&
+                          (pEventQueue->task != NULL) &&
+                          uPortTaskIsThis(pEventQueue->task);
+#else
             isEventTask = uPortTaskIsThis(pEventQueue->task);
+#endif
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -520,7 +1136,20 @@ int32_t uPortEventQueueStackMinFree(int32_t handle)
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         pEventQueue = pEventQueueGet(handle);
         if (pEventQueue != NULL) {
-            sizeOrErrorCode = uPortTaskStackMinFree(pEventQueue->task);
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+            if (pEventQueue->pooled) {
+                // Any of the workers might run it
+                for (size_t x = 0; x < sizeof(gPoolWorker) / sizeof(gPoolWorker[0]); x++) {
+                    int32_t minFree = uPortTaskStackMinFree(gPoolWorker[x].task);
+                    if ((x == 0) || (minFree < sizeOrErrorCode)) {
+                        sizeOrErrorCode = minFree;
+                    }
+                }
+            } else
+#endif
+            {
+                sizeOrErrorCode = uPortTaskStackMinFree(pEventQueue->task);
+            }
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -529,6 +1158,34 @@ int32_t uPortEventQueueStackMinFree(int32_t handle)
     return sizeOrErrorCode;
 }
 
+// Get the statistics of an event queue.
+int32_t uPortEventQueueGetStats(int32_t handle, uPortEventQueueStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uEventQueue_t *pEventQueue;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pEventQueue = pEventQueueGet(handle);
+        if ((pEventQueue != NULL) && (pStats != NULL)) {
+            *pStats = pEventQueue->stats;
+            pStats->latencyAverageMs = 0;
+            if (pStats->numEvents > 0) {
+                pStats->latencyAverageMs = (int32_t) (pEventQueue->latencyTotalMs /
+                                                      pStats->numEvents);
+            }
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
 // Close an event queue.
 int32_t uPortEventQueueClose(int32_t handle)
 {
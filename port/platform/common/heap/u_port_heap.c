@@ -0,0 +1,564 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the heap porting API, common to all
+ * platforms.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdlib.h"    // malloc(), realloc(), free()
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+
+#include "u_compiler.h" // U_ATOMIC_CAS32
+
+#include "u_error_common.h"
+
+#include "u_port.h"       // uPortGetTickTimeMs()
+#include "u_port_debug.h"
+#include "u_port_heap.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** Round a size up to the alignment of arena allocations.
+ */
+#define U_PORT_HEAP_ARENA_ALIGN(size) ((((size) + U_PORT_HEAP_ARENA_ALIGNMENT_BYTES - 1) / \
+                                        U_PORT_HEAP_ARENA_ALIGNMENT_BYTES) *                \
+                                       U_PORT_HEAP_ARENA_ALIGNMENT_BYTES)
+
+/** The space taken by the header of an arena chunk.
+ */
+#define U_PORT_HEAP_ARENA_CHUNK_HEADER_SIZE U_PORT_HEAP_ARENA_ALIGN(sizeof(uPortHeapArenaChunk_t))
+
+#ifdef U_CFG_HEAP_TRACKER
+/** The space taken by the header that the tracker puts in front
+ * of every allocation.
+ */
+# define U_PORT_HEAP_TRACKER_HEADER_SIZE U_PORT_HEAP_ARENA_ALIGN(sizeof(uPortHeapTrackerHeader_t))
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The counters kept for each tag.
+ */
+typedef struct {
+    volatile uint32_t allocCount;
+    volatile uint32_t freeCount;
+    volatile uint32_t failureCount;
+#ifdef U_CFG_HEAP_TRACKER
+    volatile uint32_t liveBytes;
+    volatile uint32_t liveBytesPeak;
+#endif
+} uPortHeapCounters_t;
+
+#ifdef U_CFG_HEAP_TRACKER
+/** The header that the tracker puts in front of every allocation.
+ */
+typedef struct {
+    size_t sizeBytes;
+    uPortHeapTag_t tag;
+} uPortHeapTrackerHeader_t;
+#endif
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The allocator, valid if gAllocatorIsSet is true.
+ */
+static uPortHeapAllocator_t gAllocator;
+
+/** Whether gAllocator is to be used or malloc() etc.
+ */
+static bool gAllocatorIsSet = false;
+
+/** The counters for each tag.
+ */
+static uPortHeapCounters_t gCounters[U_PORT_HEAP_TAG_MAX_NUM];
+
+/** The names of the tags, for printing; must be in the same order
+ * as uPortHeapTag_t.
+ */
+static const char *const gpTagName[] = {"none", "port", "utils",
+                                        "AT client", "device",
+                                        "network", "sock",
+                                        "security", "MQTT",
+                                        "location", "cell", "GNSS",
+                                        "short range", "wifi", "BLE",
+                                        "application"
+                                       };
+
+/** The allocation count of each tag at the last call to
+ * uPortHeapPrintStats(), for the allocation rate.
+ */
+static uint32_t gLastPrintAllocCount[U_PORT_HEAP_TAG_MAX_NUM];
+
+/** The time of the last call to uPortHeapPrintStats().
+ */
+static int32_t gLastPrintTimeMs = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Atomically add to a counter, returning the new value.
+static uint32_t add(volatile uint32_t *pCounter, uint32_t amount)
+{
+    uint32_t value;
+
+    do {
+        value = *pCounter;
+    } while (!U_ATOMIC_CAS32(pCounter, value, value + amount));
+
+    return value + amount;
+}
+
+// Atomically increment a counter.
+static void increment(volatile uint32_t *pCounter)
+{
+    add(pCounter, 1);
+}
+
+// Return the counters for a tag, those of U_PORT_HEAP_TAG_NONE
+// if the tag is out of range.
+static uPortHeapCounters_t *pCounters(uPortHeapTag_t tag)
+{
+    if (((int32_t) tag < 0) || (tag >= U_PORT_HEAP_TAG_MAX_NUM)) {
+        tag = U_PORT_HEAP_TAG_NONE;
+    }
+
+    return &(gCounters[tag]);
+}
+
+// Initialise a chunk of an arena in a buffer and add it to the
+// front of the chunk list; pBuffer must be aligned.
+static uPortHeapArenaChunk_t *pArenaChunkAdd(uPortHeapArena_t *pArena,
+                                             void *pBuffer, size_t sizeBytes,
+                                             bool isStatic)
+{
+    uPortHeapArenaChunk_t *pChunk = (uPortHeapArenaChunk_t *) pBuffer;
+
+    pChunk->sizeBytes = sizeBytes - U_PORT_HEAP_ARENA_CHUNK_HEADER_SIZE;
+    pChunk->usedBytes = 0;
+    pChunk->isStatic = isStatic;
+    pChunk->pNext = pArena->pChunkList;
+    pArena->pChunkList = pChunk;
+
+    return pChunk;
+}
+
+// Allocate memory with the allocator or malloc().
+static void *pAllocRaw(size_t sizeBytes, uPortHeapTag_t tag)
+{
+    void *pMemory;
+
+    if (gAllocatorIsSet) {
+        pMemory = gAllocator.pAlloc(sizeBytes, tag, gAllocator.pParam);
+    } else {
+        pMemory = malloc(sizeBytes);
+    }
+
+    return pMemory;
+}
+
+// Re-allocate memory with the allocator or realloc().
+static void *pReallocRaw(void *pMemory, size_t sizeBytes, uPortHeapTag_t tag)
+{
+    void *pNewMemory;
+
+    if (gAllocatorIsSet) {
+        pNewMemory = gAllocator.pRealloc(pMemory, sizeBytes, tag, gAllocator.pParam);
+    } else {
+        pNewMemory = realloc(pMemory, sizeBytes);
+    }
+
+    return pNewMemory;
+}
+
+// Free memory with the allocator or free().
+static void freeRaw(void *pMemory, uPortHeapTag_t tag)
+{
+    if (gAllocatorIsSet) {
+        gAllocator.pFree(pMemory, tag, gAllocator.pParam);
+    } else {
+        free(pMemory);
+    }
+}
+
+#ifdef U_CFG_HEAP_TRACKER
+
+// Add a number of live bytes to the counters of a tag, updating
+// the peak.
+static void trackerAddLive(uPortHeapCounters_t *pCounter, size_t sizeBytes)
+{
+    uint32_t liveBytes = add(&(pCounter->liveBytes), (uint32_t) sizeBytes);
+    uint32_t peak;
+
+    do {
+        peak = pCounter->liveBytesPeak;
+    } while ((liveBytes > peak) &&
+             !U_ATOMIC_CAS32(&(pCounter->liveBytesPeak), peak, liveBytes));
+}
+
+// Remove a number of live bytes from the counters of a tag.
+static void trackerRemoveLive(uPortHeapCounters_t *pCounter, size_t sizeBytes)
+{
+    add(&(pCounter->liveBytes), (uint32_t) (0 - (uint32_t) sizeBytes));
+}
+
+// Fill in the tracker header at the start of a block that has just
+// been allocated, returning the pointer to give to the caller.
+static void *pTrackerHeaderSet(void *pBlock, size_t sizeBytes, uPortHeapTag_t tag)
+{
+    uPortHeapTrackerHeader_t *pHeader = (uPortHeapTrackerHeader_t *) pBlock;
+
+    pHeader->sizeBytes = sizeBytes;
+    pHeader->tag = tag;
+
+    return ((uint8_t *) pBlock) + U_PORT_HEAP_TRACKER_HEADER_SIZE;
+}
+
+// Get the tracker header of memory given to a caller.
+static uPortHeapTrackerHeader_t *pTrackerHeaderGet(void *pMemory)
+{
+    return (uPortHeapTrackerHeader_t *) (((uint8_t *) pMemory) -
+                                         U_PORT_HEAP_TRACKER_HEADER_SIZE);
+}
+
+#endif // #ifdef U_CFG_HEAP_TRACKER
+
+// Get the name of a tag.
+static const char *pTagName(uPortHeapTag_t tag)
+{
+    const char *pName = "unknown";
+
+    if (((int32_t) tag >= 0) &&
+        ((size_t) tag < sizeof(gpTagName) / sizeof(gpTagName[0]))) {
+        pName = gpTagName[tag];
+    }
+
+    return pName;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Set the allocator.
+int32_t uPortHeapAllocatorSet(const uPortHeapAllocator_t *pAllocator)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortHeapStats_t stats;
+
+    if ((pAllocator == NULL) ||
+        ((pAllocator->pAlloc != NULL) && (pAllocator->pRealloc != NULL) &&
+         (pAllocator->pFree != NULL))) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; (x < U_PORT_HEAP_TAG_MAX_NUM) && (errorCode == 0); x++) {
+            uPortHeapGetStats((uPortHeapTag_t) x, &stats);
+            if (stats.outstanding > 0) {
+                errorCode = (int32_t) U_ERROR_COMMON_TEMPORARY_FAILURE;
+            }
+        }
+        if (errorCode == 0) {
+            gAllocatorIsSet = false;
+            if (pAllocator != NULL) {
+                gAllocator = *pAllocator;
+                gAllocatorIsSet = true;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Allocate memory.
+void *pUPortHeapAlloc(size_t sizeBytes, uPortHeapTag_t tag)
+{
+    void *pMemory;
+
+#ifdef U_CFG_HEAP_TRACKER
+    pMemory = pAllocRaw(sizeBytes + U_PORT_HEAP_TRACKER_HEADER_SIZE, tag);
+    if (pMemory != NULL) {
+        pMemory = pTrackerHeaderSet(pMemory, sizeBytes, tag);
+        trackerAddLive(pCounters(tag), sizeBytes);
+    }
+#else
+    pMemory = pAllocRaw(sizeBytes, tag);
+#endif
+    if (pMemory != NULL) {
+        increment(&(pCounters(tag)->allocCount));
+    } else {
+        increment(&(pCounters(tag)->failureCount));
+    }
+
+    return pMemory;
+}
+
+// Re-allocate memory.
+void *pUPortHeapRealloc(void *pMemory, size_t sizeBytes, uPortHeapTag_t tag)
+{
+    void *pNewMemory;
+#ifdef U_CFG_HEAP_TRACKER
+    uPortHeapTrackerHeader_t *pHeader;
+    size_t oldSizeBytes;
+
+    if (pMemory == NULL) {
+        pNewMemory = pAllocRaw(sizeBytes + U_PORT_HEAP_TRACKER_HEADER_SIZE, tag);
+        if (pNewMemory != NULL) {
+            pNewMemory = pTrackerHeaderSet(pNewMemory, sizeBytes, tag);
+            trackerAddLive(pCounters(tag), sizeBytes);
+        }
+    } else if (sizeBytes == 0) {
+        // As realloc() may, free the memory
+        uPortHeapFree(pMemory, tag);
+        pNewMemory = NULL;
+    } else {
+        pHeader = pTrackerHeaderGet(pMemory);
+        // The tag the memory was allocated with is the one that counts
+        tag = pHeader->tag;
+        oldSizeBytes = pHeader->sizeBytes;
+        pNewMemory = pReallocRaw(pHeader, sizeBytes + U_PORT_HEAP_TRACKER_HEADER_SIZE, tag);
+        if (pNewMemory != NULL) {
+            pNewMemory = pTrackerHeaderSet(pNewMemory, sizeBytes, tag);
+            trackerRemoveLive(pCounters(tag), oldSizeBytes);
+            trackerAddLive(pCounters(tag), sizeBytes);
+        }
+    }
+#else
+    pNewMemory = pReallocRaw(pMemory, sizeBytes, tag);
+#endif
+    if (pNewMemory == NULL) {
+        if (sizeBytes > 0) {
+            increment(&(pCounters(tag)->failureCount));
+        }
+    } else if (pMemory == NULL) {
+        // Behaved as an allocation
+        increment(&(pCounters(tag)->allocCount));
+    }
+
+    return pNewMemory;
+}
+
+// Free memory.
+void uPortHeapFree(void *pMemory, uPortHeapTag_t tag)
+{
+#ifdef U_CFG_HEAP_TRACKER
+    uPortHeapTrackerHeader_t *pHeader;
+#endif
+
+    if (pMemory != NULL) {
+#ifdef U_CFG_HEAP_TRACKER
+        pHeader = pTrackerHeaderGet(pMemory);
+        // The tag the memory was allocated with is the one that counts
+        tag = pHeader->tag;
+        trackerRemoveLive(pCounters(tag), pHeader->sizeBytes);
+        pMemory = pHeader;
+#endif
+        freeRaw(pMemory, tag);
+        increment(&(pCounters(tag)->freeCount));
+    }
+}
+
+// Get the statistics for a tag.
+int32_t uPortHeapGetStats(uPortHeapTag_t tag, uPortHeapStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uPortHeapCounters_t *pCounter;
+
+    if (((int32_t) tag >= 0) && (tag < U_PORT_HEAP_TAG_MAX_NUM) && (pStats != NULL)) {
+        pCounter = &(gCounters[tag]);
+        pStats->allocCount = pCounter->allocCount;
+        pStats->freeCount = pCounter->freeCount;
+        pStats->failureCount = pCounter->failureCount;
+        pStats->outstanding = pStats->allocCount - pStats->freeCount;
+#ifdef U_CFG_HEAP_TRACKER
+        pStats->liveBytes = pCounter->liveBytes;
+        pStats->liveBytesPeak = pCounter->liveBytesPeak;
+#else
+        pStats->liveBytes = 0;
+        pStats->liveBytesPeak = 0;
+#endif
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Print the statistics of all tags that have been used.
+void uPortHeapPrintStats()
+{
+    uPortHeapStats_t stats;
+    int32_t nowMs = uPortGetTickTimeMs();
+    int32_t elapsedMs = nowMs - gLastPrintTimeMs;
+
+    (void) elapsedMs; // Unused if logging is compiled out
+
+    for (size_t x = 0; x < U_PORT_HEAP_TAG_MAX_NUM; x++) {
+        uPortHeapGetStats((uPortHeapTag_t) x, &stats);
+        if ((stats.allocCount > 0) || (stats.failureCount > 0)) {
+            uPortLog("U_PORT_HEAP: %-12s %d alloc(s) (%d/s), %d outstanding,"
+                     " %d failure(s)", pTagName((uPortHeapTag_t) x),
+                     (int32_t) stats.allocCount,
+                     (int32_t) ((elapsedMs > 0) ?
+                                ((((uint64_t) ((uint32_t) stats.allocCount -
+                                               gLastPrintAllocCount[x])) * 1000) /
+                                 (uint32_t) elapsedMs) : 0),
+                     (int32_t) stats.outstanding, (int32_t) stats.failureCount);
+#ifdef U_CFG_HEAP_TRACKER
+            uPortLog(", %d byte(s) live, peak %d", (int32_t) stats.liveBytes,
+                     (int32_t) stats.liveBytesPeak);
+#endif
+            uPortLog(".\n");
+        }
+        gLastPrintAllocCount[x] = (uint32_t) stats.allocCount;
+    }
+    gLastPrintTimeMs = nowMs;
+}
+
+// Print what is outstanding for a tag, or all tags.
+size_t uPortHeapPrintOutstanding(uPortHeapTag_t tag)
+{
+    size_t outstanding = 0;
+    uPortHeapStats_t stats;
+
+    for (size_t x = 0; x < U_PORT_HEAP_TAG_MAX_NUM; x++) {
+        if (((tag == U_PORT_HEAP_TAG_MAX_NUM) || ((size_t) tag == x)) &&
+            (uPortHeapGetStats((uPortHeapTag_t) x, &stats) == 0) &&
+            (stats.outstanding > 0)) {
+            uPortLog("U_PORT_HEAP: %d allocation(s)", (int32_t) stats.outstanding);
+#ifdef U_CFG_HEAP_TRACKER
+            uPortLog(" (%d byte(s))", (int32_t) stats.liveBytes);
+#endif
+            uPortLog(" tagged \"%s\" outstanding.\n", pTagName((uPortHeapTag_t) x));
+            outstanding += stats.outstanding;
+        }
+    }
+
+    return outstanding;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: ARENA
+ * -------------------------------------------------------------- */
+
+// Initialise an arena.
+void uPortHeapArenaInit(uPortHeapArena_t *pArena, size_t chunkSizeBytes,
+                        uPortHeapTag_t tag, void *pBuffer,
+                        size_t bufferSizeBytes)
+{
+    size_t offset;
+
+    if (pArena != NULL) {
+        memset(pArena, 0, sizeof(*pArena));
+        if (chunkSizeBytes == 0) {
+            chunkSizeBytes = U_PORT_HEAP_ARENA_CHUNK_SIZE_BYTES;
+        }
+        pArena->chunkSizeBytes = U_PORT_HEAP_ARENA_ALIGN(chunkSizeBytes);
+        pArena->tag = tag;
+        if (pBuffer != NULL) {
+            // Align the static buffer and use it only if it is
+            // big enough to be worth having
+            offset = (U_PORT_HEAP_ARENA_ALIGNMENT_BYTES -
+                      (((uintptr_t) pBuffer) % U_PORT_HEAP_ARENA_ALIGNMENT_BYTES)) %
+                     U_PORT_HEAP_ARENA_ALIGNMENT_BYTES;
+            if (bufferSizeBytes > offset + U_PORT_HEAP_ARENA_CHUNK_HEADER_SIZE) {
+                pArenaChunkAdd(pArena, ((uint8_t *) pBuffer) + offset,
+                               bufferSizeBytes - offset, true);
+            }
+        }
+    }
+}
+
+// Allocate memory from an arena.
+void *pUPortHeapArenaAlloc(uPortHeapArena_t *pArena, size_t sizeBytes)
+{
+    void *pMemory = NULL;
+    uPortHeapArenaChunk_t *pChunk;
+    size_t chunkSizeBytes;
+
+    if (pArena != NULL) {
+        sizeBytes = U_PORT_HEAP_ARENA_ALIGN(sizeBytes);
+        // Only the newest chunk is used: older ones are likely
+        // to be full and slop is cheaper than searching
+        pChunk = pArena->pChunkList;
+        if ((pChunk == NULL) || (pChunk->sizeBytes - pChunk->usedBytes < sizeBytes)) {
+            chunkSizeBytes = pArena->chunkSizeBytes;
+            if (sizeBytes > chunkSizeBytes) {
+                chunkSizeBytes = sizeBytes;
+            }
+            chunkSizeBytes += U_PORT_HEAP_ARENA_CHUNK_HEADER_SIZE;
+            pChunk = (uPortHeapArenaChunk_t *) pUPortHeapAlloc(chunkSizeBytes, pArena->tag);
+            if (pChunk != NULL) {
+                pChunk = pArenaChunkAdd(pArena, pChunk, chunkSizeBytes, false);
+            }
+        }
+        if (pChunk != NULL) {
+            pMemory = ((uint8_t *) pChunk) + U_PORT_HEAP_ARENA_CHUNK_HEADER_SIZE +
+                      pChunk->usedBytes;
+            pChunk->usedBytes += sizeBytes;
+            pArena->allocatedBytes += sizeBytes;
+        }
+    }
+
+    return pMemory;
+}
+
+// Release all of the memory of an arena.
+void uPortHeapArenaRelease(uPortHeapArena_t *pArena)
+{
+    uPortHeapArenaChunk_t *pChunk;
+    uPortHeapArenaChunk_t *pStaticChunk = NULL;
+
+    if (pArena != NULL) {
+        while (pArena->pChunkList != NULL) {
+            pChunk = pArena->pChunkList;
+            pArena->pChunkList = pChunk->pNext;
+            if (pChunk->isStatic) {
+                pStaticChunk = pChunk;
+            } else {
+                uPortHeapFree(pChunk, pArena->tag);
+            }
+        }
+        if (pStaticChunk != NULL) {
+            // Keep the static chunk for re-use
+            pStaticChunk->usedBytes = 0;
+            pStaticChunk->pNext = NULL;
+            pArena->pChunkList = pStaticChunk;
+        }
+        pArena->allocatedBytes = 0;
+    }
+}
+
+// End of file
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Default implementation of uPortI2cAsyncOpen(),
+ * uPortI2cAsyncClose() and uPortI2cControllerSendReceiveAsync(),
+ * common to all platforms; a platform may override them.  The
+ * transfers are performed, with uPortI2cControllerSendReceive(), in
+ * the task of an event queue, one event queue per I2C instance.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_compiler.h" // U_WEAK
+
+#include "u_error_common.h"
+
+#include "u_port_event_queue.h"
+#include "u_port_i2c.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** An I2C instance on which uPortI2cAsyncOpen() has been called.
+ */
+typedef struct {
+    bool inUse;
+    int32_t i2cHandle;
+    int32_t eventQueueHandle;
+} uPortI2cAsyncInstance_t;
+
+/** The parameter block of the event queue: a transfer.
+ */
+typedef struct {
+    int32_t i2cHandle;
+    uint16_t address;
+    const char *pSend;
+    size_t bytesToSend;
+    char *pReceive;
+    size_t bytesToReceive;
+    uPortI2cCallback_t pCallback;
+    void *pCallbackParam;
+} uPortI2cAsyncEvent_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The I2C instances on which uPortI2cAsyncOpen() has been called.
+ */
+static uPortI2cAsyncInstance_t gInstance[U_PORT_I2C_ASYNC_MAX_NUM];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Find the instance for the given I2C handle, NULL if not found.
+static uPortI2cAsyncInstance_t *pGetInstance(int32_t i2cHandle)
+{
+    uPortI2cAsyncInstance_t *pInstance = NULL;
+
+    for (size_t x = 0; (x < sizeof(gInstance) / sizeof(gInstance[0])) &&
+         (pInstance == NULL); x++) {
+        if (gInstance[x].inUse && (gInstance[x].i2cHandle == i2cHandle)) {
+            pInstance = &(gInstance[x]);
+        }
+    }
+
+    return pInstance;
+}
+
+// Event handler: perform a transfer and call the callback.
+static void eventHandler(void *pParam, size_t paramLength)
+{
+    uPortI2cAsyncEvent_t *pEvent = (uPortI2cAsyncEvent_t *) pParam;
+    int32_t errorCodeOrLength;
+
+    (void) paramLength;
+
+    errorCodeOrLength = uPortI2cControllerSendReceive(pEvent->i2cHandle,
+                                                      pEvent->address,
+                                                      pEvent->pSend,
+                                                      pEvent->bytesToSend,
+                                                      pEvent->pReceive,
+                                                      pEvent->bytesToReceive);
+    if (pEvent->pCallback != NULL) {
+        pEvent->pCallback(pEvent->i2cHandle, errorCodeOrLength,
+                          pEvent->pCallbackParam);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Enable uPortI2cControllerSendReceiveAsync() on an I2C instance.
+U_WEAK int32_t uPortI2cAsyncOpen(int32_t handle, size_t stackSizeBytes,
+                                 int32_t priority)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortI2cAsyncInstance_t *pInstance = NULL;
+
+    if ((handle >= 0) && (pGetInstance(handle) == NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        for (size_t x = 0; (x < sizeof(gInstance) / sizeof(gInstance[0])) &&
+             (pInstance == NULL); x++) {
+            if (!gInstance[x].inUse) {
+                pInstance = &(gInstance[x]);
+            }
+        }
+        if (pInstance != NULL) {
+            errorCode = uPortEventQueueOpen(eventHandler, "i2cAsync",
+                                            sizeof(uPortI2cAsyncEvent_t),
+                                            stackSizeBytes, priority,
+                                            U_PORT_I2C_ASYNC_QUEUE_LENGTH);
+            if (errorCode >= 0) {
+                pInstance->i2cHandle = handle;
+                pInstance->eventQueueHandle = errorCode;
+                pInstance->inUse = true;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Disable uPortI2cControllerSendReceiveAsync() on an I2C instance.
+U_WEAK void uPortI2cAsyncClose(int32_t handle)
+{
+    uPortI2cAsyncInstance_t *pInstance = pGetInstance(handle);
+
+    if (pInstance != NULL) {
+        // Closing the event queue lets the transfers already
+        // queued complete first
+        uPortEventQueueClose(pInstance->eventQueueHandle);
+        pInstance->inUse = false;
+    }
+}
+
+// Send and/or receive over I2C without waiting.
+U_WEAK int32_t uPortI2cControllerSendReceiveAsync(int32_t handle, uint16_t address,
+                                                  const char *pSend, size_t bytesToSend,
+                                                  char *pReceive, size_t bytesToReceive,
+                                                  uPortI2cCallback_t pCallback,
+                                                  void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortI2cAsyncInstance_t *pInstance = pGetInstance(handle);
+    uPortI2cAsyncEvent_t event;
+
+    if ((pInstance != NULL) &&
+        ((pSend != NULL) || (bytesToSend == 0)) &&
+        ((pReceive != NULL) || (bytesToReceive == 0))) {
+        event.i2cHandle = handle;
+        event.address = address;
+        event.pSend = pSend;
+        event.bytesToSend = bytesToSend;
+        event.pReceive = pReceive;
+        event.bytesToReceive = bytesToReceive;
+        event.pCallback = pCallback;
+        event.pCallbackParam = pCallbackParam;
+        errorCode = uPortEventQueueSend(pInstance->eventQueueHandle,
+                                        &event, sizeof(event));
+    }
+
+    return errorCode;
+}
+
+// End of file
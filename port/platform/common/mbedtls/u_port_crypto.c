@@ -15,13 +15,18 @@
  */
 
 /** @file
- * @brief Implementation of the crypto API using mbedTLS.
+ * @brief Implementation of the crypto API using mbedTLS.  If
+ * U_PORT_CRYPTO_HARDWARE is defined the crypto API is instead
+ * implemented by the platform, using its hardware crypto
+ * peripherals, and the functions here, see u_port_crypto_mbedtls.h,
+ * are what it falls back to where the hardware can't help.
  */
 
 #ifdef U_CFG_OVERRIDE
 # include "u_cfg_override.h" // For a customer's configuration override
 #endif
 
+#include "stdlib.h"    // malloc(), free()
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
@@ -35,6 +40,8 @@
 #include "u_port.h"
 #include "u_port_crypto.h"
 
+#include "u_port_crypto_mbedtls.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -56,9 +63,9 @@
  * -------------------------------------------------------------- */
 
 // Perform a SHA256 calculation on a block of data.
-int32_t uPortCryptoSha256(const char *pInput,
-                          size_t inputLengthBytes,
-                          char *pOutput)
+int32_t uPortCryptoMbedtlsSha256(const char *pInput,
+                                 size_t inputLengthBytes,
+                                 char *pOutput)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
 
@@ -77,12 +84,69 @@ int32_t uPortCryptoSha256(const char *pInput,
     return errorCode;
 }
 
+// Start a SHA256 calculation.
+int32_t uPortCryptoMbedtlsSha256Start(void **ppContext)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    mbedtls_sha256_context *pContext;
+
+    if (ppContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pContext = (mbedtls_sha256_context *) malloc(sizeof(*pContext));
+        if (pContext != NULL) {
+            mbedtls_sha256_init(pContext);
+            // As for uPortCryptoMbedtlsSha256(), use the
+            // functions that NRF5 has
+            mbedtls_sha256_starts(pContext, 0);
+            *ppContext = pContext;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Add data to a SHA256 calculation.
+int32_t uPortCryptoMbedtlsSha256Update(void *pContext,
+                                       const char *pInput,
+                                       size_t inputLengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && ((pInput != NULL) || (inputLengthBytes == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        mbedtls_sha256_update((mbedtls_sha256_context *) pContext,
+                              (const unsigned char *) pInput,
+                              inputLengthBytes);
+    }
+
+    return errorCode;
+}
+
+// Complete a SHA256 calculation.
+int32_t uPortCryptoMbedtlsSha256Finish(void *pContext, char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pOutput != NULL) {
+            mbedtls_sha256_finish((mbedtls_sha256_context *) pContext,
+                                  (unsigned char *) pOutput);
+        }
+        mbedtls_sha256_free((mbedtls_sha256_context *) pContext);
+        free(pContext);
+    }
+
+    return errorCode;
+}
+
 // Perform a HMAC SHA256 calculation on a block of data.
-int32_t uPortCryptoHmacSha256(const char *pKey,
-                              size_t keyLengthBytes,
-                              const char *pInput,
-                              size_t inputLengthBytes,
-                              char *pOutput)
+int32_t uPortCryptoMbedtlsHmacSha256(const char *pKey,
+                                     size_t keyLengthBytes,
+                                     const char *pInput,
+                                     size_t inputLengthBytes,
+                                     char *pOutput)
 {
     // mbedTLS has it sorted
     const mbedtls_md_info_t *pInfo = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
@@ -95,12 +159,12 @@ int32_t uPortCryptoHmacSha256(const char *pKey,
 }
 
 // Perform AES 128 CBC encryption of a block of data.
-int32_t uPortCryptoAes128CbcEncrypt(const char *pKey,
-                                    size_t keyLengthBytes,
-                                    char *pInitVector,
-                                    const char *pInput,
-                                    size_t lengthBytes,
-                                    char *pOutput)
+int32_t uPortCryptoMbedtlsAes128CbcEncrypt(const char *pKey,
+                                           size_t keyLengthBytes,
+                                           char *pInitVector,
+                                           const char *pInput,
+                                           size_t lengthBytes,
+                                           char *pOutput)
 {
     int32_t errorCode;
     mbedtls_aes_context context;
@@ -121,12 +185,12 @@ int32_t uPortCryptoAes128CbcEncrypt(const char *pKey,
 }
 
 // Perform AES 128 CBC decryption of a block of data.
-int32_t uPortCryptoAes128CbcDecrypt(const char *pKey,
-                                    size_t keyLengthBytes,
-                                    char *pInitVector,
-                                    const char *pInput,
-                                    size_t lengthBytes,
-                                    char *pOutput)
+int32_t uPortCryptoMbedtlsAes128CbcDecrypt(const char *pKey,
+                                           size_t keyLengthBytes,
+                                           char *pInitVector,
+                                           const char *pInput,
+                                           size_t lengthBytes,
+                                           char *pOutput)
 {
     int32_t errorCode;
     mbedtls_aes_context context;
@@ -146,4 +210,75 @@ int32_t uPortCryptoAes128CbcDecrypt(const char *pKey,
     return errorCode;
 }
 
+#ifndef U_PORT_CRYPTO_HARDWARE
+
+// Perform a SHA256 calculation on a block of data.
+int32_t uPortCryptoSha256(const char *pInput,
+                          size_t inputLengthBytes,
+                          char *pOutput)
+{
+    return uPortCryptoMbedtlsSha256(pInput, inputLengthBytes, pOutput);
+}
+
+// Start a SHA256 calculation.
+int32_t uPortCryptoSha256Start(void **ppContext)
+{
+    return uPortCryptoMbedtlsSha256Start(ppContext);
+}
+
+// Add data to a SHA256 calculation.
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    return uPortCryptoMbedtlsSha256Update(pContext, pInput,
+                                          inputLengthBytes);
+}
+
+// Complete a SHA256 calculation.
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    return uPortCryptoMbedtlsSha256Finish(pContext, pOutput);
+}
+
+// Perform a HMAC SHA256 calculation on a block of data.
+int32_t uPortCryptoHmacSha256(const char *pKey,
+                              size_t keyLengthBytes,
+                              const char *pInput,
+                              size_t inputLengthBytes,
+                              char *pOutput)
+{
+    return uPortCryptoMbedtlsHmacSha256(pKey, keyLengthBytes,
+                                        pInput, inputLengthBytes,
+                                        pOutput);
+}
+
+// Perform AES 128 CBC encryption of a block of data.
+int32_t uPortCryptoAes128CbcEncrypt(const char *pKey,
+                                    size_t keyLengthBytes,
+                                    char *pInitVector,
+                                    const char *pInput,
+                                    size_t lengthBytes,
+                                    char *pOutput)
+{
+    return uPortCryptoMbedtlsAes128CbcEncrypt(pKey, keyLengthBytes,
+                                              pInitVector, pInput,
+                                              lengthBytes, pOutput);
+}
+
+// Perform AES 128 CBC decryption of a block of data.
+int32_t uPortCryptoAes128CbcDecrypt(const char *pKey,
+                                    size_t keyLengthBytes,
+                                    char *pInitVector,
+                                    const char *pInput,
+                                    size_t lengthBytes,
+                                    char *pOutput)
+{
+    return uPortCryptoMbedtlsAes128CbcDecrypt(pKey, keyLengthBytes,
+                                              pInitVector, pInput,
+                                              lengthBytes, pOutput);
+}
+
+#endif // #ifndef U_PORT_CRYPTO_HARDWARE
+
 // End of file
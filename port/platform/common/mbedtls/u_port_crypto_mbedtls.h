@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_PORT_CRYPTO_MBEDTLS_H_
+#define _U_PORT_CRYPTO_MBEDTLS_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** @file
+ * @brief The mbedTLS implementation of the crypto API, for use
+ * by a platform that implements u_port_crypto.h itself with
+ * hardware acceleration (i.e. where U_PORT_CRYPTO_HARDWARE is
+ * defined) as a fall-back for anything the hardware can't do.
+ * Parameters and return values are exactly as for the functions
+ * of the same name, minus "Mbedtls", in u_port_crypto.h.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Perform a SHA256 calculation on a block of data using mbedTLS,
+ * see uPortCryptoSha256().
+ */
+int32_t uPortCryptoMbedtlsSha256(const char *pInput,
+                                 size_t inputLengthBytes,
+                                 char *pOutput);
+
+/** Start a SHA256 calculation using mbedTLS, see
+ * uPortCryptoSha256Start().
+ */
+int32_t uPortCryptoMbedtlsSha256Start(void **ppContext);
+
+/** Add data to a SHA256 calculation using mbedTLS, see
+ * uPortCryptoSha256Update().
+ */
+int32_t uPortCryptoMbedtlsSha256Update(void *pContext,
+                                       const char *pInput,
+                                       size_t inputLengthBytes);
+
+/** Complete a SHA256 calculation using mbedTLS, see
+ * uPortCryptoSha256Finish().
+ */
+int32_t uPortCryptoMbedtlsSha256Finish(void *pContext, char *pOutput);
+
+/** Perform a HMAC SHA256 calculation on a block of data using
+ * mbedTLS, see uPortCryptoHmacSha256().
+ */
+int32_t uPortCryptoMbedtlsHmacSha256(const char *pKey,
+                                     size_t keyLengthBytes,
+                                     const char *pInput,
+                                     size_t inputLengthBytes,
+                                     char *pOutput);
+
+/** Perform AES 128 CBC encryption of a block of data using
+ * mbedTLS, see uPortCryptoAes128CbcEncrypt().
+ */
+int32_t uPortCryptoMbedtlsAes128CbcEncrypt(const char *pKey,
+                                           size_t keyLengthBytes,
+                                           char *pInitVector,
+                                           const char *pInput,
+                                           size_t lengthBytes,
+                                           char *pOutput);
+
+/** Perform AES 128 CBC decryption of a block of data using
+ * mbedTLS, see uPortCryptoAes128CbcDecrypt().
+ */
+int32_t uPortCryptoMbedtlsAes128CbcDecrypt(const char *pKey,
+                                           size_t keyLengthBytes,
+                                           char *pInitVector,
+                                           const char *pInput,
+                                           size_t lengthBytes,
+                                           char *pOutput);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_PORT_CRYPTO_MBEDTLS_H_
+
+// End of file
@@ -0,0 +1,983 @@
+#!/usr/bin/env python
+
+'''Scriptable emulator of a u-blox cellular or short-range module.
+
+Presents the AT interface of a module on a Linux pseudo-terminal or
+on a (virtual) COM port so that the real ubxlib code can be run
+against it with configurable response latency, URC bursts and data
+rates, e.g. to load-test the library at many times real traffic and
+measure its own overhead with the module taken out of the
+measurement.  See the README.md in this directory for details.'''
+
+import argparse
+import json
+import os
+import re
+import select
+import sys
+import time
+from collections import deque
+from heapq import heappush, heappop
+
+# Prefix to put at the start of all prints
+PROMPT = "u_module_emulator: "
+
+# The default settings: a scenario file need only contain the
+# values it wishes to change
+DEFAULT_SETTINGS = {
+    # "cell" or "short_range"
+    "module": "cell",
+    # Divides all latencies and periods and multiplies all data rates
+    "speed": 1.0,
+    # The time between a command arriving and its response
+    "latency_ms": 20,
+    # Per-command latency, keyed by the command name, e.g. "AT+USORD"
+    "latency_ms_per_command": {},
+    # The rate at which bytes are written towards the host, 0 for
+    # as fast as possible; emulates the module's UART
+    "line_rate_bytes_per_second": 0,
+    # How long after AT+CFUN=1/AT+COPS=0 registration completes
+    "registration_delay_ms": 2000,
+    # "echo": socket data written is returned, "sink": it is discarded
+    "socket_mode": "echo",
+    # How long after an echo the +UUSORD/+UUSORF URC is sent
+    "socket_echo_delay_ms": 10,
+    # Inbound data generated for every connected socket
+    "socket_rx_bytes_per_second": 0,
+    # The most that one AT+USORD/AT+USORF will return
+    "socket_read_max_bytes": 1024,
+    # Inbound MQTT messages generated on "topic" (if subscribed)
+    "mqtt_inbound": {"topic": "ubxlib/emulator",
+                     "messages_per_second": 0, "size": 32},
+    # Timed URC bursts, each a dict of urc, start_ms, period_ms,
+    # count (number of periods, 0 for forever) and burst (URCs
+    # per period)
+    "urc_bursts": [],
+    # Scripted responses, checked before the built-in ones, each a
+    # dict of match (a regular expression matched against the
+    # whole command line), lines (the lines to send, "OK" is NOT
+    # added) and, optionally, latency_ms and urcs (lines to send
+    # afterwards as URCs)
+    "responses": [],
+    # What the module says about itself
+    "identity": {"manufacturer": "u-blox",
+                 "model": "SARA-R510M8S",
+                 "revision": "03.15",
+                 "short_range_model": "NINA-W156",
+                 "imei": "004999010640000",
+                 "imsi": "001010123456789",
+                 "iccid": "8944000000000000000",
+                 "ip_address": "10.0.0.2"},
+    # Periodically print statistics, 0 for only at exit
+    "stats_interval_seconds": 0,
+    # Gaps longer than this between a response and the next command
+    # count as the host being idle rather than as host overhead
+    "idle_ms": 500
+}
+
+# The EDM framing used by short-range modules
+EDM_HEAD = 0xAA
+EDM_TAIL = 0x55
+EDM_TYPE_AT_REQUEST = 0x0044
+EDM_TYPE_AT_RESPONSE = 0x0045
+EDM_TYPE_AT_EVENT = 0x0041
+EDM_TYPE_START_EVENT = 0x0071
+
+# The number of sockets a cellular module supports
+CELL_SOCKET_MAX_NUM = 7
+
+class PtyPort():
+    '''A Linux pseudo-terminal: the host opens the slave.'''
+    def __init__(self):
+        import tty # pylint: disable=import-outside-toplevel
+        self.master, slave = os.openpty()
+        tty.setraw(slave)
+        self.name = os.ttyname(slave)
+        # Keep the slave open so that the PTY persists across
+        # the host closing and re-opening it
+        self.slave = slave
+        os.set_blocking(self.master, False)
+
+    def read(self, timeout):
+        '''Read whatever is available, waiting up to timeout seconds.'''
+        data = b""
+        readable, _, _ = select.select([self.master], [], [], max(timeout, 0))
+        if readable:
+            try:
+                data = os.read(self.master, 4096)
+            except (BlockingIOError, OSError):
+                pass
+        return data
+
+    def write(self, data):
+        '''Write all of data.'''
+        while data:
+            try:
+                written = os.write(self.master, data)
+                data = data[written:]
+            except BlockingIOError:
+                select.select([], [self.master], [], 0.1)
+
+    def close(self):
+        '''Close the port.'''
+        os.close(self.master)
+        os.close(self.slave)
+
+class SerialPort():
+    '''A serial port, e.g. one end of a com0com virtual pair on Windows.'''
+    def __init__(self, name, baud_rate):
+        import serial # pylint: disable=import-outside-toplevel
+        self.name = name
+        self.serial = serial.Serial(name, baud_rate, timeout=0)
+
+    def read(self, timeout):
+        '''Read whatever is available, waiting up to timeout seconds.'''
+        self.serial.timeout = max(timeout, 0)
+        data = self.serial.read(1)
+        if data:
+            self.serial.timeout = 0
+            data += self.serial.read(4096)
+        return data
+
+    def write(self, data):
+        '''Write all of data.'''
+        self.serial.write(data)
+
+    def close(self):
+        '''Close the port.'''
+        self.serial.close()
+
+class Stats():
+    '''Statistics gathering.'''
+    def __init__(self):
+        self.start = time.monotonic()
+        self.commands = {}
+        self.turnaround_ms = []
+        self.idle_gaps = 0
+        self.bytes_in = 0
+        self.bytes_out = 0
+        self.urcs = 0
+        self.socket_bytes_in = 0
+        self.socket_bytes_out = 0
+        self.mqtt_published = 0
+        self.mqtt_delivered = 0
+
+    def command(self, name):
+        '''Count a command.'''
+        self.commands[name] = self.commands.get(name, 0) + 1
+
+    def report(self):
+        '''Return the statistics as a printable string.'''
+        elapsed = time.monotonic() - self.start
+        lines = [f"{elapsed:.1f} second(s): {self.bytes_in} byte(s) in,"
+                 f" {self.bytes_out} byte(s) out, {self.urcs} URC(s),"
+                 f" socket data {self.socket_bytes_in} byte(s) in/"
+                 f"{self.socket_bytes_out} byte(s) out, MQTT"
+                 f" {self.mqtt_published} published/{self.mqtt_delivered}"
+                 " delivered."]
+        if self.turnaround_ms:
+            ordered = sorted(self.turnaround_ms)
+            count = len(ordered)
+            lines.append(f"host turnaround (response complete to next command"
+                         f" started) over {count} command(s), excluding"
+                         f" {self.idle_gaps} idle gap(s): mean"
+                         f" {sum(ordered) / count:.2f} ms, 50% {ordered[count // 2]:.2f} ms,"
+                         f" 99% {ordered[min((count * 99) // 100, count - 1)]:.2f} ms,"
+                         f" max {ordered[-1]:.2f} ms.")
+        for name, count in sorted(self.commands.items(), key=lambda x: -x[1]):
+            lines.append(f"  {name}: {count} ({count / elapsed:.1f}/s)")
+        return "\n".join(lines)
+
+class Emulator():
+    '''The emulator: one instance per port.'''
+    # pylint: disable=too-many-instance-attributes
+    def __init__(self, port, settings, verbose):
+        self.port = port
+        self.settings = settings
+        self.verbose = verbose
+        self.speed = float(settings["speed"])
+        self.identity = settings["identity"]
+        self.stats = Stats()
+        self.short_range = settings["module"] == "short_range"
+        # Output scheduling: a heap of (time, sequence, bytes, is_final)
+        self.scheduled = []
+        self.sequence = 0
+        self.line_free_time = 0
+        self.last_final_time = None
+        # Input parsing
+        self.line = bytearray()
+        self.binary_wanted = 0
+        self.binary = bytearray()
+        self.binary_handler = None
+        self.edm_mode = False
+        self.edm_buffer = bytearray()
+        self.off_until = 0
+        # Module state
+        self.echo = True
+        self.hex_mode = False
+        self.cfun = 1
+        self.reg_stat = 0
+        self.reg_urc_level = {"+CREG": 0, "+CGREG": 0, "+CEREG": 0}
+        self.sockets = {}
+        self.files = {}
+        self.mqtt_connected = False
+        self.mqtt_subscriptions = {}
+        self.mqtt_messages = deque()
+        self.timers = []
+        self.compiled_responses = [(re.compile(x["match"]), x)
+                                   for x in settings["responses"]]
+        now = time.monotonic()
+        for burst in settings["urc_bursts"]:
+            self.add_timer(now + self.scale_ms(burst.get("start_ms", 0)),
+                           self.urc_burst, dict(burst, done=0))
+        if self.rate(settings["socket_rx_bytes_per_second"]) > 0:
+            self.add_timer(now + 0.1, self.socket_source, None)
+        if self.rate(settings["mqtt_inbound"]["messages_per_second"]) > 0:
+            self.add_timer(now + 1 / self.rate(settings["mqtt_inbound"]["messages_per_second"]),
+                           self.mqtt_source, None)
+        if settings["stats_interval_seconds"] > 0:
+            self.add_timer(now + settings["stats_interval_seconds"],
+                           self.print_stats, None)
+        if self.cfun == 1:
+            self.start_registration()
+
+    # ---- helpers ----
+
+    def log(self, text):
+        '''Print if verbose.'''
+        if self.verbose:
+            print(f"{PROMPT}{text}")
+
+    def scale_ms(self, milliseconds):
+        '''Convert a configured time in milliseconds to scaled seconds.'''
+        return (milliseconds / 1000) / self.speed
+
+    def rate(self, per_second):
+        '''Scale a configured rate.'''
+        return per_second * self.speed
+
+    def add_timer(self, when, function, param):
+        '''Call function(param) at monotonic time when.'''
+        self.sequence += 1
+        heappush(self.timers, (when, self.sequence, function, param))
+
+    def latency(self, name):
+        '''Return the scaled response latency for a command in seconds.'''
+        return self.scale_ms(self.settings["latency_ms_per_command"].
+                             get(name, self.settings["latency_ms"]))
+
+    def send(self, data, delay=0, is_final=False, is_urc=False):
+        '''Queue data for the host after delay seconds.'''
+        if isinstance(data, str):
+            data = data.encode("latin-1")
+        if self.edm_mode:
+            data = edm_frame(EDM_TYPE_AT_EVENT if is_urc else EDM_TYPE_AT_RESPONSE,
+                             data)
+        if is_urc:
+            self.stats.urcs += 1
+        self.sequence += 1
+        heappush(self.scheduled, (time.monotonic() + delay, self.sequence,
+                                  data, is_final))
+
+    def respond(self, name, lines, final="OK", urcs=None, extra_delay=0):
+        '''Queue the response lines to a command, then the final
+        result and then any URCs.'''
+        delay = self.latency(name) + extra_delay
+        text = "".join(f"\r\n{x}" for x in lines)
+        if lines:
+            text += "\r\n"
+        if final is not None:
+            text += f"\r\n{final}\r\n"
+        self.send(text, delay, is_final=final is not None)
+        for urc in urcs or []:
+            self.send(f"\r\n{urc}\r\n", delay, is_urc=True)
+
+    def urc(self, text, delay=0):
+        '''Queue a URC.'''
+        self.send(f"\r\n{text}\r\n", delay, is_urc=True)
+
+    def expect_binary(self, length, handler):
+        '''Switch the input to binary for length bytes, calling
+        handler(bytes) when they have all arrived.'''
+        self.binary_wanted = length
+        self.binary = bytearray()
+        self.binary_handler = handler
+        if length == 0:
+            self.finish_binary()
+
+    def finish_binary(self):
+        '''Binary input is complete.'''
+        handler = self.binary_handler
+        data = bytes(self.binary)
+        self.binary_wanted = 0
+        self.binary_handler = None
+        self.binary = bytearray()
+        handler(data)
+
+    # ---- the main loop ----
+
+    def run(self):
+        '''Run until interrupted.'''
+        print(f"{PROMPT}emulating a {self.settings['module']} module on"
+              f" {self.port.name} at {self.speed}x speed.")
+        while True:
+            now = time.monotonic()
+            timeout = 0.05
+            if self.scheduled:
+                timeout = min(timeout, self.scheduled[0][0] - now)
+            if self.timers:
+                timeout = min(timeout, self.timers[0][0] - now)
+            data = self.port.read(timeout)
+            if data:
+                self.stats.bytes_in += len(data)
+                if time.monotonic() >= self.off_until:
+                    self.receive(data)
+            self.service_timers()
+            self.service_output()
+
+    def service_timers(self):
+        '''Call any timers that are due.'''
+        now = time.monotonic()
+        while self.timers and self.timers[0][0] <= now:
+            _, _, function, param = heappop(self.timers)
+            function(param)
+
+    def service_output(self):
+        '''Write any output that is due, paced by the line rate.'''
+        line_rate = self.rate(self.settings["line_rate_bytes_per_second"])
+        now = time.monotonic()
+        while self.scheduled and self.scheduled[0][0] <= now and \
+              self.line_free_time <= now:
+            _, _, data, is_final = heappop(self.scheduled)
+            self.port.write(data)
+            self.stats.bytes_out += len(data)
+            if line_rate > 0:
+                self.line_free_time = now + len(data) / line_rate
+            if is_final:
+                self.last_final_time = time.monotonic()
+
+    def command_started(self):
+        '''Note the time that the host began a command.'''
+        if self.last_final_time is not None:
+            gap_ms = (time.monotonic() - self.last_final_time) * 1000
+            if gap_ms < self.settings["idle_ms"]:
+                self.stats.turnaround_ms.append(gap_ms)
+            else:
+                self.stats.idle_gaps += 1
+            self.last_final_time = None
+
+    def receive(self, data):
+        '''Handle data from the host.'''
+        index = 0
+        while index < len(data):
+            if self.binary_handler is not None:
+                take = min(self.binary_wanted - len(self.binary), len(data) - index)
+                self.binary += data[index:index + take]
+                index += take
+                if len(self.binary) >= self.binary_wanted:
+                    self.finish_binary()
+            elif self.edm_mode:
+                self.edm_buffer += data[index:]
+                index = len(data)
+                self.receive_edm()
+            else:
+                byte = data[index]
+                index += 1
+                if not self.line:
+                    self.command_started()
+                if byte == 0x0D:
+                    line = self.line.decode("latin-1").strip()
+                    if self.echo and line:
+                        self.send(bytes(self.line) + b"\r")
+                    self.line = bytearray()
+                    if line:
+                        self.command(line)
+                elif byte != 0x0A or self.line:
+                    self.line.append(byte)
+
+    def receive_edm(self):
+        '''Parse EDM frames in edm_buffer.'''
+        while True:
+            # Resynchronise on the head
+            while self.edm_buffer and self.edm_buffer[0] != EDM_HEAD:
+                del self.edm_buffer[0]
+            if len(self.edm_buffer) < 3:
+                break
+            length = ((self.edm_buffer[1] & 0x0F) << 8) | self.edm_buffer[2]
+            if len(self.edm_buffer) < length + 4:
+                break
+            frame = bytes(self.edm_buffer[:length + 4])
+            del self.edm_buffer[:length + 4]
+            if frame[-1] != EDM_TAIL or length < 2:
+                continue
+            frame_type = (frame[3] << 8) | frame[4]
+            if frame_type == EDM_TYPE_AT_REQUEST:
+                self.command_started()
+                line = frame[5:-1].decode("latin-1").strip()
+                if line:
+                    self.command(line)
+            else:
+                self.log(f"ignoring EDM frame type 0x{frame_type:04x}.")
+
+    # ---- command dispatch ----
+
+    def command(self, line):
+        '''Handle a complete command line.'''
+        self.log(f"<- {line}")
+        name = re.match(r"^(AT[+&]?[A-Z0-9]*|AT)", line.upper())
+        name = name.group(1) if name else line
+        self.stats.command(name)
+        for regex, scripted in self.compiled_responses:
+            if regex.search(line):
+                delay = 0
+                if "latency_ms" in scripted:
+                    delay = self.scale_ms(scripted["latency_ms"]) - self.latency(name)
+                self.respond(name, scripted.get("lines", []), final=None,
+                             urcs=scripted.get("urcs"), extra_delay=delay)
+                if self.verbose:
+                    self.log(f"-> (scripted) {scripted.get('lines', [])}")
+                return
+        params = line[len(name):]
+        handler = self.short_range_command if self.short_range else self.cell_command
+        if not handler(name.upper(), params):
+            # Anything not emulated is simply accepted
+            self.respond(name, [])
+
+    def cell_command(self, name, params):
+        '''Handle a cellular command; returns False if not handled.'''
+        # pylint: disable=too-many-branches, too-many-return-statements
+        handled = True
+        query = params == "?"
+        args = split_params(params[1:]) if params.startswith("=") else []
+        if name in ("ATE0", "ATE1", "ATE"):
+            self.echo = name == "ATE1"
+            self.respond(name, [])
+        elif name in ("AT+CGMI", "AT+GMI"):
+            self.respond(name, [self.identity["manufacturer"]])
+        elif name in ("AT+CGMM", "AT+GMM"):
+            self.respond(name, [self.identity["model"]])
+        elif name in ("AT+CGMR", "AT+GMR"):
+            self.respond(name, [self.identity["revision"]])
+        elif name == "ATI9":
+            self.respond(name, [f"{self.identity['revision']},A.02.00"])
+        elif name in ("AT+CGSN", "AT+GSN"):
+            self.respond(name, [self.identity["imei"]])
+        elif name == "AT+CIMI":
+            self.respond(name, [self.identity["imsi"]])
+        elif name == "AT+CCID":
+            self.respond(name, [f"+CCID: {self.identity['iccid']}"])
+        elif name == "AT+CPWROFF":
+            self.respond(name, [])
+            self.power_off()
+        elif name in ("AT+CFUN", "AT+COPS", "AT+CREG", "AT+CGREG", "AT+CEREG",
+                      "AT+CGATT", "AT+CGACT", "AT+CGPADDR", "AT+CGDCONT",
+                      "AT+UPSND", "AT+CSQ", "AT+UDCONF", "AT+UDNSRN"):
+            self.cell_registration_command(name, query, args)
+        elif name.startswith("AT+USO"):
+            handled = self.cell_socket_command(name, args)
+        elif name in ("AT+UMQTT", "AT+UMQTTC"):
+            handled = self.cell_mqtt_command(name, args)
+        elif name in ("AT+UDWNFILE", "AT+URDFILE", "AT+URDBLOCK",
+                      "AT+UDELFILE", "AT+ULSTFILE"):
+            self.cell_file_command(name, args)
+        else:
+            handled = False
+        return handled
+
+    # ---- cellular: registration ----
+
+    def start_registration(self):
+        '''Begin registering, completing after the registration delay.'''
+        self.set_reg_stat(2)
+        self.add_timer(time.monotonic() +
+                       self.scale_ms(self.settings["registration_delay_ms"]),
+                       lambda _: self.set_reg_stat(1) if self.cfun == 1 else None,
+                       None)
+
+    def set_reg_stat(self, stat):
+        '''Change registration status, sending URCs where enabled.'''
+        if stat != self.reg_stat:
+            self.reg_stat = stat
+            self.log(f"registration status now {stat}.")
+            if self.reg_urc_level["+CEREG"] > 0:
+                if self.reg_urc_level["+CEREG"] >= 2 and stat in (1, 5):
+                    self.urc(f"+CEREG: {stat},\"0001\",\"01A2D001\",7")
+                else:
+                    self.urc(f"+CEREG: {stat}")
+
+    def cell_registration_command(self, name, query, args):
+        '''Registration and packet-data commands.'''
+        # pylint: disable=too-many-branches
+        lines = []
+        final = "OK"
+        registered = self.reg_stat in (1, 5)
+        ip_address = self.identity["ip_address"]
+        if name == "AT+CFUN":
+            if query:
+                lines = [f"+CFUN: {self.cfun},0"]
+            elif args:
+                self.cfun = int_arg(args, 0, 1)
+                if self.cfun == 1:
+                    self.start_registration()
+                else:
+                    self.set_reg_stat(0)
+        elif name == "AT+COPS":
+            if query:
+                lines = ["+COPS: 0,0,\"u-blox emulator\",7" if registered else "+COPS: 0"]
+            elif args and int_arg(args, 0, 0) == 2:
+                self.set_reg_stat(0)
+            elif args and not registered and self.cfun == 1:
+                self.start_registration()
+        elif name in ("AT+CREG", "AT+CGREG", "AT+CEREG"):
+            prefix = name[2:]
+            if query:
+                # Only ever registered on LTE
+                stat = self.reg_stat if prefix == "+CEREG" else 0
+                lines = [f"{prefix}: {self.reg_urc_level[prefix]},{stat}"]
+            elif args:
+                self.reg_urc_level[prefix] = int_arg(args, 0, 0)
+        elif name == "AT+CGATT":
+            if query:
+                lines = [f"+CGATT: {int(registered)}"]
+        elif name == "AT+CGACT":
+            if query:
+                lines = [f"+CGACT: 1,{int(registered)}"]
+        elif name == "AT+CGPADDR":
+            lines = [f"+CGPADDR: 1,\"{ip_address}\""]
+        elif name == "AT+CGDCONT":
+            if query:
+                lines = [f"+CGDCONT: 1,\"IP\",\"internet\",\"{ip_address}\",0,0"]
+        elif name == "AT+UPSND":
+            if len(args) >= 2:
+                if int_arg(args, 1, 0) == 8:
+                    lines = [f"+UPSND: {args[0]},8,{int(registered)}"]
+                elif int_arg(args, 1, 0) == 0:
+                    lines = [f"+UPSND: {args[0]},0,\"{ip_address}\""]
+        elif name == "AT+CSQ":
+            lines = ["+CSQ: 20,99" if registered else "+CSQ: 99,99"]
+        elif name == "AT+UDCONF":
+            if args and int_arg(args, 0, -1) == 1:
+                if len(args) > 1:
+                    self.hex_mode = int_arg(args, 1, 0) == 1
+                else:
+                    lines = [f"+UDCONF: 1,{int(self.hex_mode)}"]
+        elif name == "AT+UDNSRN":
+            # Every name resolves to the emulator
+            lines = ["+UDNSRN: \"127.0.0.1\""]
+        self.respond(name, lines, final)
+
+    # ---- cellular: sockets ----
+
+    def cell_socket_command(self, name, args):
+        '''Socket commands; returns False if not handled.'''
+        # pylint: disable=too-many-branches, too-many-statements
+        handled = True
+        sock = self.sockets.get(int_arg(args, 0, -1))
+        if name == "AT+USOCR":
+            free = [x for x in range(CELL_SOCKET_MAX_NUM) if x not in self.sockets]
+            if free:
+                protocol = int_arg(args, 0, 6)
+                self.sockets[free[0]] = {"protocol": protocol,
+                                         "connected": protocol == 17,
+                                         "rx": bytearray(),
+                                         "remote": ("127.0.0.1", 0)}
+                self.respond(name, [f"+USOCR: {free[0]}"])
+            else:
+                self.respond(name, [], "+CME ERROR: operation not allowed")
+        elif sock is None:
+            if name in ("AT+USOER",):
+                self.respond(name, ["+USOER: 0"])
+            else:
+                self.respond(name, [], "+CME ERROR: operation not allowed")
+        elif name == "AT+USOCO":
+            sock["connected"] = True
+            sock["remote"] = (args[1].strip("\""), int_arg(args, 2, 0))
+            if int_arg(args, 3, 0) == 1:
+                self.respond(name, [], urcs=[f"+UUSOCO: {args[0]},0"])
+            else:
+                self.respond(name, [])
+        elif name in ("AT+USOWR", "AT+USOST"):
+            length_index = 1 if name == "AT+USOWR" else 3
+            length = int_arg(args, length_index, 0)
+            prefix = name[2:]
+            if len(args) > length_index + 1:
+                # Hex (or text) data inline
+                data = args[length_index + 1].strip("\"")
+                data = bytes.fromhex(data) if self.hex_mode else data.encode("latin-1")
+                self.socket_write(int(args[0]), data)
+                self.respond(name, [f"{prefix}: {args[0]},{len(data)}"])
+            else:
+                self.send("@", self.latency(name))
+                self.expect_binary(length, lambda data, s=args[0], p=prefix, n=name:
+                                   (self.socket_write(int(s), data),
+                                    self.respond(n, [f"{p}: {s},{len(data)}"])))
+        elif name in ("AT+USORD", "AT+USORF"):
+            wanted = min(int_arg(args, 1, 0), self.settings["socket_read_max_bytes"])
+            prefix = name[2:]
+            remote = ""
+            if name == "AT+USORF":
+                remote = f"\"{sock['remote'][0]}\",{sock['remote'][1]},"
+            if wanted == 0:
+                self.respond(name, [f"{prefix}: {args[0]},{len(sock['rx'])}"])
+            else:
+                data = bytes(sock["rx"][:wanted])
+                del sock["rx"][:wanted]
+                self.stats.socket_bytes_out += len(data)
+                if self.hex_mode:
+                    payload = data.hex().upper().encode("latin-1")
+                else:
+                    payload = data
+                self.send(f"\r\n{prefix}: {args[0]},{remote}{len(data)},\"".encode("latin-1") +
+                          payload + b"\"\r\n\r\nOK\r\n", self.latency(name), is_final=True)
+        elif name == "AT+USOCL":
+            del self.sockets[int(args[0])]
+            if int_arg(args, 1, 0) == 1:
+                self.respond(name, [], urcs=[f"+UUSOCL: {args[0]}"])
+            else:
+                self.respond(name, [])
+        elif name == "AT+USOCTL":
+            param = int_arg(args, 1, 0)
+            value = 0
+            if param == 10:
+                # TCP state: established
+                value = 4 if sock["connected"] else 0
+            elif param == 11:
+                # Bytes sent but not acknowledged
+                value = 0
+            self.respond(name, [f"+USOCTL: {args[0]},{param},{value}"])
+        elif name == "AT+USOER":
+            self.respond(name, ["+USOER: 0"])
+        else:
+            handled = False
+        return handled
+
+    def socket_write(self, sock_id, data):
+        '''Data has been written to a socket.'''
+        sock = self.sockets.get(sock_id)
+        self.stats.socket_bytes_in += len(data)
+        if sock is not None and self.settings["socket_mode"] == "echo":
+            self.socket_receive(sock_id, data,
+                                self.scale_ms(self.settings["socket_echo_delay_ms"]))
+
+    def socket_receive(self, sock_id, data, delay=0):
+        '''Data has arrived for a socket.'''
+        sock = self.sockets[sock_id]
+        was_empty = not sock["rx"]
+        sock["rx"] += data
+        # Like the real module, only indicate data when the
+        # socket has been emptied
+        if was_empty and data:
+            urc = "+UUSORF" if sock["protocol"] == 17 else "+UUSORD"
+            self.urc(f"{urc}: {sock_id},{len(sock['rx'])}", delay)
+
+    def socket_source(self, _):
+        '''Generate inbound data for each connected socket.'''
+        interval = 0.1
+        length = max(1, int(self.rate(self.settings["socket_rx_bytes_per_second"]) * interval))
+        for sock_id, sock in self.sockets.items():
+            if sock["connected"]:
+                self.socket_receive(sock_id, bytes((x & 0x7F) or 0x20 for x in range(length)))
+        self.add_timer(time.monotonic() + interval, self.socket_source, None)
+
+    # ---- cellular: MQTT ----
+
+    def cell_mqtt_command(self, name, args):
+        '''MQTT commands; returns False if not handled.'''
+        # pylint: disable=too-many-branches
+        handled = True
+        op_code = int_arg(args, 0, -1)
+        if name == "AT+UMQTT":
+            if len(args) > 1:
+                self.respond(name, [f"+UMQTT: {op_code},1"])
+            else:
+                handled = False
+        elif op_code == 0:
+            self.mqtt_connected = False
+            self.respond(name, ["+UMQTTC: 0,1"], urcs=["+UUMQTTC: 0,1"])
+        elif op_code == 1:
+            self.mqtt_connected = True
+            self.respond(name, ["+UMQTTC: 1,1"], urcs=["+UUMQTTC: 1,1"])
+        elif op_code == 2 and len(args) >= 6:
+            # Publish text/hex: 2,qos,retain,hex,"topic","message"
+            message = args[5].strip("\"")
+            if int_arg(args, 3, 0) == 1:
+                message = bytes.fromhex(message)
+            else:
+                message = message.encode("latin-1")
+            self.mqtt_publish(args[4].strip("\""), message, int_arg(args, 1, 0))
+            self.respond(name, ["+UMQTTC: 2,1"], urcs=["+UUMQTTC: 2,1"])
+        elif op_code == 9 and len(args) >= 5:
+            # Publish binary: 9,qos,retain,"topic",length then prompt
+            self.send(">", self.latency(name))
+            self.expect_binary(int_arg(args, 4, 0),
+                               lambda data, t=args[3].strip("\""), q=int_arg(args, 1, 0):
+                               (self.mqtt_publish(t, data, q),
+                                self.respond(name, [], urcs=["+UUMQTTC: 9,1"])))
+        elif op_code == 4 and len(args) >= 3:
+            topic_filter = args[2].strip("\"")
+            self.mqtt_subscriptions[topic_filter] = int_arg(args, 1, 0)
+            self.respond(name, ["+UMQTTC: 4,1"],
+                         urcs=[f"+UUMQTTC: 4,1,{int_arg(args, 1, 0)},\"{topic_filter}\""])
+        elif op_code == 5 and len(args) >= 2:
+            self.mqtt_subscriptions.pop(args[1].strip("\""), None)
+            self.respond(name, ["+UMQTTC: 5,1"], urcs=["+UUMQTTC: 5,1"])
+        elif op_code == 6:
+            if self.mqtt_messages:
+                topic, message, qos = self.mqtt_messages.popleft()
+                self.stats.mqtt_delivered += 1
+                self.send(f"\r\n+UMQTTC: 6,{qos},{len(topic) + len(message)},{len(topic)},"
+                          f"\"{topic}\",{len(message)},\"".encode("latin-1") +
+                          message + b"\"\r\n\r\nOK\r\n", self.latency(name), is_final=True)
+            else:
+                self.respond(name, [], "+CME ERROR: operation not allowed")
+        else:
+            handled = False
+        return handled
+
+    def mqtt_publish(self, topic, message, qos):
+        '''A message has been published: the emulator is also the
+        broker, delivering it if a subscription matches.'''
+        self.stats.mqtt_published += 1
+        for topic_filter, sub_qos in self.mqtt_subscriptions.items():
+            if mqtt_topic_matches(topic_filter, topic):
+                self.mqtt_messages.append((topic, message, min(qos, sub_qos)))
+                self.urc(f"+UUMQTTC: 6,{len(self.mqtt_messages)}",
+                         self.scale_ms(self.settings["socket_echo_delay_ms"]))
+                break
+
+    def mqtt_source(self, _):
+        '''Generate an inbound MQTT message.'''
+        inbound = self.settings["mqtt_inbound"]
+        if self.mqtt_connected:
+            self.mqtt_publish(inbound["topic"], b"x" * inbound["size"], 0)
+        self.add_timer(time.monotonic() + 1 / self.rate(inbound["messages_per_second"]),
+                       self.mqtt_source, None)
+
+    # ---- cellular: file system ----
+
+    def cell_file_command(self, name, args):
+        '''File system commands.'''
+        file_name = args[0].strip("\"") if args else ""
+        error = "+CME ERROR: FILE NOT FOUND"
+        if name == "AT+UDWNFILE":
+            self.send(">", self.latency(name))
+            self.expect_binary(int_arg(args, 1, 0),
+                               lambda data, f=file_name: self.file_append(name, f, data))
+        elif file_name not in self.files and name != "AT+ULSTFILE":
+            self.respond(name, [], error)
+        elif name == "AT+URDFILE":
+            data = self.files[file_name]
+            self.send(f"\r\n+URDFILE: \"{file_name}\",{len(data)},\"".encode("latin-1") +
+                      data + b"\"\r\n\r\nOK\r\n", self.latency(name), is_final=True)
+        elif name == "AT+URDBLOCK":
+            offset = int_arg(args, 1, 0)
+            data = self.files[file_name][offset:offset + int_arg(args, 2, 0)]
+            self.send(f"\r\n+URDBLOCK: \"{file_name}\",{len(data)},\"".encode("latin-1") +
+                      data + b"\"\r\n\r\nOK\r\n", self.latency(name), is_final=True)
+        elif name == "AT+UDELFILE":
+            del self.files[file_name]
+            self.respond(name, [])
+        else:
+            # AT+ULSTFILE: 0 lists, 1 is free space, 2 is the size of a file
+            op_code = int_arg(args, 0, 0)
+            if op_code == 0:
+                names = ",".join(f"\"{x}\"" for x in self.files)
+                self.respond(name, [f"+ULSTFILE: {names}"] if names else [])
+            elif op_code == 1:
+                self.respond(name, ["+ULSTFILE: 1000000"])
+            else:
+                file_name = args[1].strip("\"") if len(args) > 1 else ""
+                if file_name in self.files:
+                    self.respond(name, [f"+ULSTFILE: {len(self.files[file_name])}"])
+                else:
+                    self.respond(name, [], error)
+
+    def file_append(self, name, file_name, data):
+        '''Data for AT+UDWNFILE has arrived.'''
+        self.files[file_name] = self.files.get(file_name, b"") + data
+        self.respond(name, [])
+
+    # ---- short-range ----
+
+    def short_range_command(self, name, params):
+        '''Handle a short-range command; returns False if not handled.'''
+        handled = True
+        args = split_params(params[1:]) if params.startswith("=") else []
+        if name == "ATO2" or name == "ATO":
+            self.respond(name, [])
+            # Switch to EDM once the OK has gone out
+            self.add_timer(time.monotonic() + self.latency(name),
+                           self.enter_edm, None)
+        elif name in ("ATE0", "ATE1", "ATE"):
+            self.echo = name == "ATE1"
+            self.respond(name, [])
+        elif name in ("AT+GMM", "AT+CGMM"):
+            self.respond(name, [f"\"{self.identity['short_range_model']}\""])
+        elif name in ("AT+GMI", "AT+CGMI"):
+            self.respond(name, [f"\"{self.identity['manufacturer']}\""])
+        elif name in ("AT+GMR", "AT+CGMR"):
+            self.respond(name, [f"\"{self.identity['revision']}\""])
+        elif name in ("AT+CGSN", "AT+GSN"):
+            self.respond(name, [f"\"{self.identity['imei']}\""])
+        elif name == "AT+CPWROFF":
+            self.respond(name, [])
+            self.power_off()
+        elif name == "AT+UWSCA" and len(args) >= 2:
+            # Wi-Fi station connect (3) or disconnect (4)
+            if int_arg(args, 1, 0) == 3:
+                self.respond(name, [], urcs=[f"+UUWLE:{args[0]},000000000000,6",
+                                             "+UUNU:0"],
+                             extra_delay=self.scale_ms(self.settings["registration_delay_ms"]))
+            else:
+                self.respond(name, [], urcs=[f"+UUWLD:{args[0]},0", "+UUND:0"])
+        else:
+            handled = False
+        return handled
+
+    def enter_edm(self, _):
+        '''Switch to EDM framing.'''
+        self.edm_mode = True
+        self.echo = False
+        self.edm_buffer = bytearray()
+        self.log("now in EDM mode.")
+
+    # ---- common ----
+
+    def power_off(self):
+        '''The module has been told to power off: go quiet, then
+        restart with default settings.'''
+        self.off_until = time.monotonic() + self.latency("AT+CPWROFF") + 0.5
+        self.add_timer(self.off_until, self.restart, None)
+
+    def restart(self, _):
+        '''Restart after a power off.'''
+        self.echo = True
+        self.hex_mode = False
+        self.edm_mode = False
+        self.sockets = {}
+        self.mqtt_connected = False
+        self.mqtt_subscriptions = {}
+        self.mqtt_messages.clear()
+        self.reg_urc_level = {"+CREG": 0, "+CGREG": 0, "+CEREG": 0}
+        self.reg_stat = 0
+        self.line = bytearray()
+        if self.short_range:
+            self.send("\r\n+STARTUP\r\n")
+        elif self.cfun == 1:
+            self.start_registration()
+
+    def urc_burst(self, burst):
+        '''Send one period's worth of a scripted URC burst.'''
+        for _ in range(burst.get("burst", 1)):
+            self.urc(burst["urc"])
+        burst["done"] += 1
+        if burst.get("count", 1) == 0 or burst["done"] < burst.get("count", 1):
+            self.add_timer(time.monotonic() + self.scale_ms(burst.get("period_ms", 1000)),
+                           self.urc_burst, burst)
+
+    def print_stats(self, _):
+        '''Print the statistics periodically.'''
+        print(f"{PROMPT}{self.stats.report()}")
+        self.add_timer(time.monotonic() + self.settings["stats_interval_seconds"],
+                       self.print_stats, None)
+
+def edm_frame(frame_type, payload):
+    '''Wrap payload in an EDM frame.'''
+    length = len(payload) + 2
+    return bytes([EDM_HEAD, (length >> 8) & 0x0F, length & 0xFF,
+                  (frame_type >> 8) & 0xFF, frame_type & 0xFF]) + payload + bytes([EDM_TAIL])
+
+def split_params(text):
+    '''Split AT command parameters on commas outside quotes.'''
+    params = []
+    current = ""
+    quoted = False
+    for char in text:
+        if char == "\"":
+            quoted = not quoted
+        if char == "," and not quoted:
+            params.append(current.strip())
+            current = ""
+        else:
+            current += char
+    if current or params:
+        params.append(current.strip())
+    return params
+
+def int_arg(args, index, default):
+    '''Return args[index] as an integer, or default.'''
+    try:
+        return int(args[index].strip("\""))
+    except (IndexError, ValueError):
+        return default
+
+def mqtt_topic_matches(topic_filter, topic):
+    '''Return True if an MQTT topic matches a filter with + and # wildcards.'''
+    filter_levels = topic_filter.split("/")
+    topic_levels = topic.split("/")
+    for index, level in enumerate(filter_levels):
+        if level == "#":
+            return True
+        if index >= len(topic_levels) or (level not in ("+", topic_levels[index])):
+            return False
+    return len(filter_levels) == len(topic_levels)
+
+def load_settings(file_path, overrides):
+    '''Load the settings from a YAML or JSON scenario file.'''
+    settings = json.loads(json.dumps(DEFAULT_SETTINGS))
+    if file_path:
+        with open(file_path, "r", encoding="utf8") as file:
+            if file_path.endswith((".yml", ".yaml")):
+                import yaml # pylint: disable=import-outside-toplevel
+                loaded = yaml.safe_load(file) or {}
+            else:
+                loaded = json.load(file)
+        for key, value in loaded.items():
+            if isinstance(value, dict) and isinstance(settings.get(key), dict):
+                settings[key].update(value)
+            else:
+                settings[key] = value
+    settings.update({key: value for key, value in overrides.items() if value is not None})
+    return settings
+
+def main():
+    '''Entry point.'''
+    parser = argparse.ArgumentParser(description="Emulate a u-blox cellular or"
+                                     " short-range module on a pseudo-terminal"
+                                     " (Linux) or serial port (e.g. one end of"
+                                     " a com0com pair on Windows).")
+    parser.add_argument("-s", "--scenario", help="a YAML or JSON scenario file.")
+    parser.add_argument("-p", "--port", help="a serial port to use instead of a"
+                        " pseudo-terminal, e.g. COM10.")
+    parser.add_argument("-b", "--baud", type=int, default=115200,
+                        help="the baud rate for --port (default 115200).")
+    parser.add_argument("-m", "--module", choices=["cell", "short_range"],
+                        help="the module type, overriding the scenario.")
+    parser.add_argument("-x", "--speed", type=float,
+                        help="the speed multiplier, overriding the scenario,"
+                        " e.g. 10 for ten times real traffic.")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="print every command.")
+    args = parser.parse_args()
+
+    settings = load_settings(args.scenario, {"module": args.module,
+                                             "speed": args.speed})
+    if args.port:
+        port = SerialPort(args.port, args.baud)
+    else:
+        if not hasattr(os, "openpty"):
+            print(f"{PROMPT}this platform has no pseudo-terminals, please use --port.")
+            return 1
+        port = PtyPort()
+    emulator = Emulator(port, settings, args.verbose)
+    try:
+        emulator.run()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        print(f"\n{PROMPT}{emulator.stats.report()}")
+        port.close()
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -16,7 +16,7 @@
 
 /** @file
  * @brief This file implements some functions that may be useful
- * when debugging a mutex deadlock.
+ * when debugging a mutex deadlock or measuring mutex contention.
  */
 
 #ifdef U_CFG_OVERRIDE
@@ -27,7 +27,7 @@
 
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memset()
+#include "string.h"    // memset(), strcmp()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_os_platform_specific.h"
@@ -88,6 +88,23 @@ typedef struct uMutexFunctionInfo_t {
     struct uMutexFunctionInfo_t *pNext;
 } uMutexFunctionInfo_t;
 
+/** Contention statistics for a mutex, identified by where it was
+ * created, when locked from a given place.
+ */
+typedef struct {
+    const char *pCreatorFile; // If this is NULL the entry is not in use.
+    int32_t creatorLine;
+    const char *pFile;
+    int32_t line;
+    int32_t numAcquisitions;
+    int32_t numContended;
+    int32_t numTimedOut;
+    int32_t waitTotalMs;
+    int32_t waitMaxMs;
+    int32_t holdTotalMs;
+    int32_t holdMaxMs;
+} uMutexStats_t;
+
 /** A structure to keep track of a mutex as part of a linked list.
  * Note that the handle MUST be the first member of the structure.
  * This is because, when simulating critical sections under Windows,
@@ -99,6 +116,8 @@ typedef struct uMutexInfo_t {
     uMutexFunctionInfo_t *pCreator; // If this is NULL the entry is not in use.
     uMutexFunctionInfo_t *pLocker;
     uMutexFunctionInfo_t *pWaiting;
+    uMutexStats_t *pLockerStats; // The statistics of the current locker.
+    int32_t lockedMs;
     struct uMutexInfo_t *pNext;
 } uMutexInfo_t;
 
@@ -149,6 +168,20 @@ static uMutexInfo_t gMutexInfo[U_MUTEX_DEBUG_MUTEX_INFO_MAX_NUM];
  */
 static uMutexFunctionInfo_t gMutexFunctionInfo[U_MUTEX_DEBUG_FUNCTION_INFO_MAX_NUM];
 
+/** Array of contention statistics.
+ */
+static uMutexStats_t gMutexStats[U_MUTEX_DEBUG_STATS_MAX_NUM];
+
+/** The number of acquisitions for which there was no room in
+ * gMutexStats.
+ */
+static int32_t gMutexStatsNumLost = 0;
+
+/** Used by uMutexDebugStatsPrint() to sort gMutexStats, which
+ * cannot be sorted in place as uMutexInfo_t points into it.
+ */
+static uMutexStats_t *gpMutexStatsSorted[U_MUTEX_DEBUG_STATS_MAX_NUM];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS; ONES THAT DO NOT LOCK THE LIST MUTEX
  * -------------------------------------------------------------- */
@@ -195,6 +228,7 @@ static uMutexInfo_t *pAllocMutexInformationBlock()
             pMutexInfo = &(gMutexInfo[x]);
             pMutexInfo->pLocker = NULL;
             pMutexInfo->pWaiting = NULL;
+            pMutexInfo->pLockerStats = NULL;
             pMutexInfo->handle = NULL;
             pMutexInfo->pNext = NULL;
         }
@@ -289,6 +323,113 @@ static bool unlinkWaiting(uMutexInfo_t *pMutexInfo,
     return success;
 }
 
+// Find the contention statistics for a mutex locked from the
+// given place, allocating an entry if there isn't one; returns
+// NULL if there is no room.
+// gMutexList should be locked before this is called.
+static uMutexStats_t *pGetStats(uMutexInfo_t *pMutexInfo,
+                                const char *pFile, int32_t line)
+{
+    uMutexStats_t *pStats = NULL;
+    uMutexStats_t *pFree = NULL;
+    const char *pCreatorFile = pMutexInfo->pCreator->pFile;
+    int32_t creatorLine = pMutexInfo->pCreator->line;
+
+    for (size_t x = 0; (x < sizeof(gMutexStats) / sizeof(gMutexStats[0])) &&
+         (pStats == NULL); x++) {
+        if (gMutexStats[x].pCreatorFile == NULL) {
+            if (pFree == NULL) {
+                pFree = &(gMutexStats[x]);
+            }
+        } else if ((gMutexStats[x].line == line) &&
+                   (gMutexStats[x].creatorLine == creatorLine) &&
+                   (strcmp(gMutexStats[x].pFile, pFile) == 0) &&
+                   (strcmp(gMutexStats[x].pCreatorFile, pCreatorFile) == 0)) {
+            pStats = &(gMutexStats[x]);
+        }
+    }
+    if ((pStats == NULL) && (pFree != NULL)) {
+        pStats = pFree;
+        memset(pStats, 0, sizeof(*pStats));
+        pStats->pCreatorFile = pCreatorFile;
+        pStats->creatorLine = creatorLine;
+        pStats->pFile = pFile;
+        pStats->line = line;
+    }
+    if (pStats == NULL) {
+        gMutexStatsNumLost++;
+    }
+
+    return pStats;
+}
+
+// Record a wait for a mutex in its contention statistics, returning
+// the statistics entry.
+// gMutexList should be locked before this is called.
+static uMutexStats_t *pAddStatsWait(uMutexInfo_t *pMutexInfo,
+                                    uMutexFunctionInfo_t *pWaiting,
+                                    bool contended, bool timedOut,
+                                    int32_t waitMs)
+{
+    uMutexStats_t *pStats = NULL;
+
+    if (pMutexInfo->pCreator != NULL) {
+        pStats = pGetStats(pMutexInfo, pWaiting->pFile, pWaiting->line);
+        if (pStats != NULL) {
+            if (timedOut) {
+                pStats->numTimedOut++;
+            } else {
+                pStats->numAcquisitions++;
+            }
+            if (contended) {
+                pStats->numContended++;
+            }
+            pStats->waitTotalMs += waitMs;
+            if (waitMs > pStats->waitMaxMs) {
+                pStats->waitMaxMs = waitMs;
+            }
+        }
+    }
+
+    return pStats;
+}
+
+// Lock a mutex, first trying without waiting so as to tell whether
+// it is contended, waiting at most delayMs if delayMs is not negative.
+static int32_t lockMeasured(uMutexInfo_t *pMutexInfo, int32_t delayMs,
+                            bool *pContended, int32_t *pWaitMs)
+{
+    int32_t errorCode;
+    int32_t startMs = uPortGetTickTimeMs();
+
+    *pContended = false;
+    errorCode = _uPortMutexTryLock(pMutexInfo->handle, 0);
+    if ((errorCode != 0) && (delayMs != 0)) {
+        *pContended = true;
+        if (delayMs < 0) {
+            errorCode = _uPortMutexLock(pMutexInfo->handle);
+        } else {
+            errorCode = _uPortMutexTryLock(pMutexInfo->handle, delayMs);
+        }
+    }
+    *pWaitMs = uPortGetTickTimeMs() - startMs;
+
+    return errorCode;
+}
+
+// Print one contention statistics entry.
+static void printStats(const uMutexStats_t *pStats)
+{
+    uPortLog("U_MUTEX_DEBUG_STATS: %s:%d locked at %s:%d:\n",
+             pStats->pCreatorFile, pStats->creatorLine,
+             pStats->pFile, pStats->line);
+    uPortLog("U_MUTEX_DEBUG_STATS:   %d acquisition(s), %d contended, %d timed out,"
+             " wait %d ms (max %d ms), hold %d ms (max %d ms).\n",
+             pStats->numAcquisitions, pStats->numContended, pStats->numTimedOut,
+             pStats->waitTotalMs, pStats->waitMaxMs,
+             pStats->holdTotalMs, pStats->holdMaxMs);
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: ONES THAT LOCK THE LIST MUTEX
  * -------------------------------------------------------------- */
@@ -322,9 +463,11 @@ static uMutexFunctionInfo_t *pLockAddWaiting(uMutexInfo_t *pMutexInfo,
     return pWaiting;
 }
 
-// Move a waiting entry to become a locker entry.
+// Move a waiting entry to become a locker entry, recording
+// how long it waited in the contention statistics.
 static bool lockMoveWaitingToLocker(uMutexInfo_t *pMutexInfo,
-                                    uMutexFunctionInfo_t *pWaiting)
+                                    uMutexFunctionInfo_t *pWaiting,
+                                    bool contended, int32_t waitMs)
 {
     bool success = false;
 
@@ -339,6 +482,9 @@ static bool lockMoveWaitingToLocker(uMutexInfo_t *pMutexInfo,
         // disappeared in the meantime
         success = unlinkWaiting(pMutexInfo, pWaiting);
         if (success) {
+            pMutexInfo->pLockerStats = pAddStatsWait(pMutexInfo, pWaiting,
+                                                     contended, false, waitMs);
+            pMutexInfo->lockedMs = uPortGetTickTimeMs();
             // The waiting entry is now the locker
             pMutexInfo->pLocker = pWaiting;
             // Zero the counter
@@ -353,16 +499,20 @@ static bool lockMoveWaitingToLocker(uMutexInfo_t *pMutexInfo,
     return success;
 }
 
-// Free a waiting entry.
+// Free a waiting entry, recording a time-out in the contention
+// statistics if timedOut is true.
 static void lockFreeWaiting(uMutexInfo_t *pMutexInfo,
-                            uMutexFunctionInfo_t *pWaiting)
+                            uMutexFunctionInfo_t *pWaiting,
+                            bool timedOut, int32_t waitMs)
 {
     if ((gMutexList != NULL) && (pMutexInfo != NULL)) {
 
         U_MUTEX_DEBUG_PORT_MUTEX_LOCK(gMutexList);
 
         // Find the waiting entry in the list and free it
-        unlinkWaiting(pMutexInfo, pWaiting);
+        if (unlinkWaiting(pMutexInfo, pWaiting) && timedOut) {
+            pAddStatsWait(pMutexInfo, pWaiting, true, true, waitMs);
+        }
         freeFunctionInformationBlock(pWaiting);
 
         U_MUTEX_DEBUG_PORT_MUTEX_UNLOCK(gMutexList);
@@ -514,6 +664,8 @@ int32_t uMutexDebugLock(uPortMutexHandle_t mutexHandle,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uMutexInfo_t *pMutexInfo = (uMutexInfo_t *) mutexHandle;
     uMutexFunctionInfo_t *pWaiting;
+    bool contended;
+    int32_t waitMs;
 
     if (gMutexList != NULL) {
 
@@ -524,13 +676,13 @@ int32_t uMutexDebugLock(uPortMutexHandle_t mutexHandle,
         errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
         pWaiting = pLockAddWaiting(pMutexInfo, pFile, line);
         if (pWaiting != NULL) {
-            errorCode = _uPortMutexLock(pMutexInfo->handle);
+            errorCode = lockMeasured(pMutexInfo, -1, &contended, &waitMs);
             if (errorCode == 0) {
-                if (!lockMoveWaitingToLocker(pMutexInfo, pWaiting)) {
-                    lockFreeWaiting(pMutexInfo, pWaiting);
+                if (!lockMoveWaitingToLocker(pMutexInfo, pWaiting, contended, waitMs)) {
+                    lockFreeWaiting(pMutexInfo, pWaiting, false, 0);
                 }
             } else {
-                lockFreeWaiting(pMutexInfo, pWaiting);
+                lockFreeWaiting(pMutexInfo, pWaiting, false, 0);
             }
         }
     }
@@ -547,6 +699,8 @@ int32_t uMutexDebugTryLock(uPortMutexHandle_t mutexHandle,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uMutexInfo_t *pMutexInfo = (uMutexInfo_t *) mutexHandle;
     uMutexFunctionInfo_t *pWaiting;
+    bool contended;
+    int32_t waitMs;
 
     if (gMutexList != NULL) {
 
@@ -557,13 +711,16 @@ int32_t uMutexDebugTryLock(uPortMutexHandle_t mutexHandle,
         errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
         pWaiting = pLockAddWaiting(pMutexInfo, pFile, line);
         if (pWaiting != NULL) {
-            errorCode = _uPortMutexTryLock(pMutexInfo->handle, delayMs);
+            if (delayMs < 0) {
+                delayMs = 0;
+            }
+            errorCode = lockMeasured(pMutexInfo, delayMs, &contended, &waitMs);
             if (errorCode == 0) {
-                if (!lockMoveWaitingToLocker(pMutexInfo, pWaiting)) {
-                    lockFreeWaiting(pMutexInfo, pWaiting);
+                if (!lockMoveWaitingToLocker(pMutexInfo, pWaiting, contended, waitMs)) {
+                    lockFreeWaiting(pMutexInfo, pWaiting, false, 0);
                 }
             } else {
-                lockFreeWaiting(pMutexInfo, pWaiting);
+                lockFreeWaiting(pMutexInfo, pWaiting, true, waitMs);
             }
         }
     }
@@ -576,11 +733,24 @@ int32_t uMutexDebugUnlock(uPortMutexHandle_t mutexHandle)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uMutexInfo_t *pMutexInfo = (uMutexInfo_t *) mutexHandle;
+    uMutexStats_t *pStats;
+    int32_t holdMs;
 
     if (gMutexList != NULL) {
 
         U_MUTEX_DEBUG_PORT_MUTEX_LOCK(gMutexList);
 
+        // Record the hold time in the contention statistics
+        pStats = pMutexInfo->pLockerStats;
+        if (pStats != NULL) {
+            holdMs = uPortGetTickTimeMs() - pMutexInfo->lockedMs;
+            pStats->holdTotalMs += holdMs;
+            if (holdMs > pStats->holdMaxMs) {
+                pStats->holdMaxMs = holdMs;
+            }
+            pMutexInfo->pLockerStats = NULL;
+        }
+
         // Unlock the mutex and free the locker entry
         errorCode = _uPortMutexUnlock(pMutexInfo->handle);
         freeFunctionInformationBlock(pMutexInfo->pLocker);
@@ -604,6 +774,8 @@ int32_t uMutexDebugInit(void)
     if (gMutexList == NULL) {
         memset(gMutexInfo, 0, sizeof(gMutexInfo));
         memset(gMutexFunctionInfo, 0, sizeof(gMutexFunctionInfo));
+        memset(gMutexStats, 0, sizeof(gMutexStats));
+        gMutexStatsNumLost = 0;
         errorCode = _uPortMutexCreate(&gMutexList);
     }
 
@@ -749,6 +921,68 @@ void uMutexDebugPrint(void *pParam)
     }
 }
 
+// Print out the contention statistics of all mutexes.
+void uMutexDebugStatsPrint(void *pParam)
+{
+    size_t numStats = 0;
+    size_t y;
+    uMutexStats_t *pStats;
+
+    (void) pParam;
+
+    if (gMutexList != NULL) {
+
+        U_MUTEX_DEBUG_PORT_MUTEX_LOCK(gMutexList);
+
+        // Insertion sort of the entries in use, most waiting first
+        for (size_t x = 0; x < sizeof(gMutexStats) / sizeof(gMutexStats[0]); x++) {
+            pStats = &(gMutexStats[x]);
+            if (pStats->pCreatorFile != NULL) {
+                for (y = numStats; (y > 0) &&
+                     (gpMutexStatsSorted[y - 1]->waitTotalMs < pStats->waitTotalMs); y--) {
+                    gpMutexStatsSorted[y] = gpMutexStatsSorted[y - 1];
+                }
+                gpMutexStatsSorted[y] = pStats;
+                numStats++;
+            }
+        }
+
+        for (size_t x = 0; x < numStats; x++) {
+            printStats(gpMutexStatsSorted[x]);
+        }
+        uPortLog("U_MUTEX_DEBUG_STATS: %d call site(s)", (int32_t) numStats);
+        if (gMutexStatsNumLost > 0) {
+            uPortLog(", %d acquisition(s) not recorded, increase"
+                     " U_MUTEX_DEBUG_STATS_MAX_NUM", gMutexStatsNumLost);
+        }
+        uPortLog(".\n");
+
+        U_MUTEX_DEBUG_PORT_MUTEX_UNLOCK(gMutexList);
+    }
+}
+
+// Reset the contention statistics of all mutexes.
+void uMutexDebugStatsReset(void)
+{
+    uMutexInfo_t *pMutexInfo;
+
+    if (gMutexList != NULL) {
+
+        U_MUTEX_DEBUG_PORT_MUTEX_LOCK(gMutexList);
+
+        memset(gMutexStats, 0, sizeof(gMutexStats));
+        gMutexStatsNumLost = 0;
+        // Current lockers no longer have an entry to add to
+        pMutexInfo = gpMutexInfoList;
+        while (pMutexInfo != NULL) {
+            pMutexInfo->pLockerStats = NULL;
+            pMutexInfo = pMutexInfo->pNext;
+        }
+
+        U_MUTEX_DEBUG_PORT_MUTEX_UNLOCK(gMutexList);
+    }
+}
+
 #endif // U_CFG_MUTEX_DEBUG
 
 // End of file
@@ -90,6 +90,23 @@
  * U_MUTEX_DEBUG_0x2000a7e8: created by C:/projects/ubxlib/port/platform/stm32cube/src/u_port_uart.c:892 approx. 12 second(s) ago is not locked.
  * U_MUTEX_DEBUG_0x2000a840: created by C:/projects/ubxlib/port/platform/common/event_queue/u_port_event_queue.c:229 approx. 12 second(s) ago is not locked.
  * U_MUTEX_DEBUG: 3 mutex(es), 1 locked, a maximum of 1 waiting, max waiting time approx. 12 second(s).
+ *
+ * Mutex debug also measures contention: for each mutex, identified
+ * by where it was created, and each place that mutex is locked from,
+ * it counts the acquisitions, how many of those found the mutex
+ * already locked and had to wait, how many timed out (for
+ * uPortMutexTryLock()), the total and maximum time spent waiting
+ * and the total and maximum time the mutex was then held for.
+ * Call uMutexDebugStatsPrint() at any time to print these, the call
+ * sites with the most waiting first, e.g.:
+ *
+ * U_MUTEX_DEBUG_STATS: common/at_client/src/u_at_client.c:4512 locked at common/at_client/src/u_at_client.c:3668:
+ * U_MUTEX_DEBUG_STATS:   1024 acquisition(s), 37 contended, 0 timed out, wait 1210 ms (max 305 ms), hold 8832 ms (max 1206 ms).
+ *
+ * Times are measured with uPortGetTickTimeMs() and so a short wait
+ * may be recorded as zero; it is still counted as contended.  Use
+ * uMutexDebugStatsReset() to start measuring afresh, e.g. once
+ * start-up is complete.
  */
 
 #ifdef __cplusplus
@@ -114,6 +131,14 @@ extern "C" {
 # define U_MUTEX_DEBUG_FUNCTION_INFO_MAX_NUM 256
 #endif
 
+#ifndef U_MUTEX_DEBUG_STATS_MAX_NUM
+/** The maximum number of contention statistics entries, one for
+ * each combination of a mutex (identified by where it was created)
+ * and a place that it is locked from.
+ */
+# define U_MUTEX_DEBUG_STATS_MAX_NUM 128
+#endif
+
 #ifndef U_MUTEX_DEBUG_WATCHDOG_TIMEOUT_SECONDS
 /** A good default watchdog timeout (in seconds).
  */
@@ -279,6 +304,20 @@ int32_t uMutexDebugWatchdog(void (*pCallback) (void *),
  */
 void uMutexDebugPrint(void *pParam);
 
+/** Print out the contention statistics of all mutexes, per place
+ * each mutex is locked from, sorted by the total time spent waiting
+ * for the lock, most first; may be passed as a callback to
+ * uMutexDebugWatchdog().
+ *
+ * @param pParam  a dummy parameter so that this function matches
+ *                the function signature for uMutexDebugWatchdog().
+ */
+void uMutexDebugStatsPrint(void *pParam);
+
+/** Reset the contention statistics of all mutexes.
+ */
+void uMutexDebugStatsReset(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the profiling probes, common to all
+ * platforms; a platform may override uPortProfileCyclesGet().
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_cfg_sw.h"
+
+#include "u_compiler.h" // U_WEAK, U_ATOMIC_CAS32
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+/** The Cortex-M debug exception and monitor control register.
+ */
+# define U_PORT_PROFILE_DEMCR (*((volatile uint32_t *) 0xE000EDFCUL))
+
+/** The DWT control register.
+ */
+# define U_PORT_PROFILE_DWT_CTRL (*((volatile uint32_t *) 0xE0001000UL))
+
+/** The DWT lock access register, only present on Cortex-M7.
+ */
+# define U_PORT_PROFILE_DWT_LAR (*((volatile uint32_t *) 0xE0001FB0UL))
+#endif
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The registered probes.
+ */
+static uPortProfileProbe_t *gpProbe[U_PORT_PROFILE_MAX_NUM_PROBES] = {0};
+
+/** The number of entries of gpProbe[] that have been claimed, may
+ * be larger than U_PORT_PROFILE_MAX_NUM_PROBES.
+ */
+static volatile uint32_t gNumProbes = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start the cycle counter, if it needs starting.
+static void cyclesStart(void)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+    if ((U_PORT_PROFILE_DWT_CTRL & 1) == 0) {
+        // Enable trace, unlock the DWT (Cortex-M7) and start CYCCNT
+        U_PORT_PROFILE_DEMCR |= (1UL << 24);
+# ifdef __ARM_ARCH_7EM__
+        U_PORT_PROFILE_DWT_LAR = 0xC5ACCE55UL;
+# endif
+        U_PORT_PROFILE_DWT_CTRL |= 1;
+    }
+#endif
+}
+
+// Print a number with two decimal places, given it multiplied by 100.
+static void printHundredths(uint64_t x)
+{
+    uPortLog("%8u.%02u", (unsigned int) (x / 100), (unsigned int) (x % 100));
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add a sample to a probe.
+void uPortProfileProbeAdd(uPortProfileProbe_t *pProbe, uint32_t cycles,
+                          uint32_t units)
+{
+    uint32_t index;
+
+    if (pProbe->registered == 0) {
+        // Only one caller gets to register the probe
+        if (U_ATOMIC_CAS32(&(pProbe->registered), 0, 1)) {
+            cyclesStart();
+            pProbe->minCycles = UINT32_MAX;
+            do {
+                index = gNumProbes;
+            } while (!U_ATOMIC_CAS32(&gNumProbes, index, index + 1));
+            if (index < U_PORT_PROFILE_MAX_NUM_PROBES) {
+                gpProbe[index] = pProbe;
+            }
+        }
+        // The first sample may pre-date the cycle counter being started
+    } else {
+        pProbe->count++;
+        if (cycles < pProbe->minCycles) {
+            pProbe->minCycles = cycles;
+        }
+        if (cycles > pProbe->maxCycles) {
+            pProbe->maxCycles = cycles;
+        }
+        pProbe->totalCycles += cycles;
+        pProbe->totalUnits += units;
+    }
+}
+
+// Get the cycle count where there is no inline cycle counter.
+U_WEAK uint32_t uPortProfileCyclesGet(void)
+{
+    return (uint32_t) uPortGetTickTimeMs();
+}
+
+// Print the figures for all probes.
+void uPortProfilePrint(void)
+{
+    uint32_t numProbes = gNumProbes;
+    uPortProfileProbe_t *pProbe;
+
+    if (numProbes > U_PORT_PROFILE_MAX_NUM_PROBES) {
+        uPortLog("U_PORT_PROFILE: %d probe(s) not printed, increase"
+                 " U_PORT_PROFILE_MAX_NUM_PROBES.\n",
+                 (int32_t) (numProbes - U_PORT_PROFILE_MAX_NUM_PROBES));
+        numProbes = U_PORT_PROFILE_MAX_NUM_PROBES;
+    }
+    uPortLog("U_PORT_PROFILE: %-24s %10s %10s %10s %11s %11s\n", "probe",
+             "count", "min", "max", "average", "per unit");
+    for (size_t x = 0; x < numProbes; x++) {
+        pProbe = gpProbe[x];
+        if (pProbe != NULL) {
+            uPortLog("U_PORT_PROFILE: %-24s %10u", pProbe->pName,
+                     (unsigned int) pProbe->count);
+            if (pProbe->count > 0) {
+                uPortLog(" %10u %10u ", (unsigned int) pProbe->minCycles,
+                         (unsigned int) pProbe->maxCycles);
+                printHundredths((pProbe->totalCycles * 100) / pProbe->count);
+                uPortLog(" ");
+                if (pProbe->totalUnits > 0) {
+                    printHundredths((pProbe->totalCycles * 100) / pProbe->totalUnits);
+                } else {
+                    uPortLog("%11s", "-");
+                }
+            }
+            uPortLog("\n");
+        }
+    }
+}
+
+// Reset the figures for all probes.
+void uPortProfileReset(void)
+{
+    uint32_t numProbes = gNumProbes;
+    uPortProfileProbe_t *pProbe;
+
+    if (numProbes > U_PORT_PROFILE_MAX_NUM_PROBES) {
+        numProbes = U_PORT_PROFILE_MAX_NUM_PROBES;
+    }
+    for (size_t x = 0; x < numProbes; x++) {
+        pProbe = gpProbe[x];
+        if (pProbe != NULL) {
+            pProbe->count = 0;
+            pProbe->minCycles = UINT32_MAX;
+            pProbe->maxCycles = 0;
+            pProbe->totalCycles = 0;
+            pProbe->totalUnits = 0;
+        }
+    }
+}
+
+// End of file
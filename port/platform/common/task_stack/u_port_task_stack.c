@@ -0,0 +1,361 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the task stack registry, common to all
+ * platforms.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strncpy(), strcmp()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h" // U_CFG_OS_YIELD_MS
+
+#include "u_compiler.h" // U_ATOMIC_CAS32
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_debug.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** Recommended stack sizes are rounded up to a multiple of this,
+ * the stack alignment of the strictest platform.
+ */
+#define U_PORT_TASK_STACK_ROUND_BYTES 8
+
+/** The number of tasks that can end before they have been
+ * registered (see gEndedEarly) at any one time.
+ */
+#define U_PORT_TASK_STACK_ENDED_EARLY_MAX_NUM 4
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The states of an entry in the registry; an entry is only
+ * changed by the task that has moved it into CLAIMED.
+ */
+typedef enum {
+    U_PORT_TASK_STACK_STATE_FREE = 0,
+    U_PORT_TASK_STACK_STATE_CLAIMED, // Being written
+    U_PORT_TASK_STACK_STATE_RUNNING,
+    U_PORT_TASK_STACK_STATE_READING, // Running, stack being read
+    U_PORT_TASK_STACK_STATE_ENDED
+} uPortTaskStackState_t;
+
+/** An entry in the registry.
+ */
+typedef struct {
+    volatile uint32_t state; // uPortTaskStackState_t, uint32_t for U_ATOMIC_CAS32()
+    uPortTaskHandle_t taskHandle;
+    uPortTaskStack_t taskStack; // recommendedBytes is worked out when read
+} uPortTaskStackEntry_t;
+
+/** A task that ended before it was registered.
+ */
+typedef struct {
+    volatile uint32_t state; // FREE, CLAIMED or ENDED
+    uPortTaskHandle_t taskHandle;
+} uPortTaskStackEndedEarly_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The registry.
+ */
+static uPortTaskStackEntry_t gEntry[U_PORT_TASK_STACK_MAX_NUM] = {0};
+
+/** The number of tasks that could not be recorded because the
+ * registry was full.
+ */
+static volatile uint32_t gNumNotRecorded = 0;
+
+/** A task of higher priority than its creator may run, and even
+ * delete itself, before its creator has been able to register it;
+ * such tasks are noted here so that registration doesn't leave
+ * behind an entry for a task that no longer exists.
+ */
+static uPortTaskStackEndedEarly_t gEndedEarly[U_PORT_TASK_STACK_ENDED_EARLY_MAX_NUM] = {0};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Work out how much stack a task has used, negative error code if
+// the platform cannot tell.
+static int32_t usedBytes(const uPortTaskHandle_t taskHandle,
+                         size_t stackSizeBytes)
+{
+    int32_t errorCodeOrUsed = uPortTaskStackMinFree(taskHandle);
+
+    if (errorCodeOrUsed >= 0) {
+        errorCodeOrUsed = (int32_t) stackSizeBytes - errorCodeOrUsed;
+        if (errorCodeOrUsed < 0) {
+            errorCodeOrUsed = 0;
+        }
+    }
+
+    return errorCodeOrUsed;
+}
+
+// Note a task that has ended before it was registered.
+static void endedEarlyAdd(const uPortTaskHandle_t taskHandle)
+{
+    bool added = false;
+
+    // Use a free slot or, failing that, overwrite one: the list may
+    // also collect tasks that were never going to be registered
+    // (because the registry was full) and the newest is the one
+    // that matters
+    for (size_t y = 0; (y < 2) && !added; y++) {
+        for (size_t x = 0; (x < U_PORT_TASK_STACK_ENDED_EARLY_MAX_NUM) && !added; x++) {
+            if (U_ATOMIC_CAS32(&(gEndedEarly[x].state),
+                               (y == 0) ? U_PORT_TASK_STACK_STATE_FREE : U_PORT_TASK_STACK_STATE_ENDED,
+                               U_PORT_TASK_STACK_STATE_CLAIMED)) {
+                gEndedEarly[x].taskHandle = taskHandle;
+                gEndedEarly[x].state = U_PORT_TASK_STACK_STATE_ENDED;
+                added = true;
+            }
+        }
+    }
+}
+
+// Check if a task has ended before it was registered, removing
+// it from the list if so.
+static bool endedEarlyRemove(const uPortTaskHandle_t taskHandle)
+{
+    bool removed = false;
+
+    for (size_t x = 0; (x < U_PORT_TASK_STACK_ENDED_EARLY_MAX_NUM) && !removed; x++) {
+        if ((gEndedEarly[x].taskHandle == taskHandle) &&
+            U_ATOMIC_CAS32(&(gEndedEarly[x].state), U_PORT_TASK_STACK_STATE_ENDED,
+                           U_PORT_TASK_STACK_STATE_CLAIMED)) {
+            gEndedEarly[x].taskHandle = NULL;
+            gEndedEarly[x].state = U_PORT_TASK_STACK_STATE_FREE;
+            removed = true;
+        }
+    }
+
+    return removed;
+}
+
+// Add usedBytes to the figures for a task.
+static void usedAdd(uPortTaskStack_t *pTaskStack, int32_t used)
+{
+    if ((used >= 0) && (used > pTaskStack->usedMaxBytes)) {
+        pTaskStack->usedMaxBytes = used;
+    }
+}
+
+// Work out the recommended stack size for a task.
+static int32_t recommendedBytes(int32_t usedMaxBytes)
+{
+    int32_t errorCodeOrRecommended = usedMaxBytes;
+    int32_t margin;
+
+    if (errorCodeOrRecommended >= 0) {
+        margin = (usedMaxBytes * U_PORT_TASK_STACK_MARGIN_PERCENT) / 100;
+        if (margin < U_PORT_TASK_STACK_MARGIN_MIN_BYTES) {
+            margin = U_PORT_TASK_STACK_MARGIN_MIN_BYTES;
+        }
+        errorCodeOrRecommended += margin + U_PORT_TASK_STACK_ROUND_BYTES - 1;
+        errorCodeOrRecommended -= errorCodeOrRecommended % U_PORT_TASK_STACK_ROUND_BYTES;
+    }
+
+    return errorCodeOrRecommended;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add a task to the registry.
+void uPortTaskStackRegister(const uPortTaskHandle_t taskHandle,
+                            const char *pName, size_t stackSizeBytes)
+{
+    uPortTaskStackEntry_t *pEntry = NULL;
+    uPortTaskStack_t *pTaskStack;
+    uint32_t numNotRecorded;
+
+    if (pName == NULL) {
+        pName = "";
+    }
+    // Re-use the entry of an earlier task of the same name,
+    // so that its figures carry on
+    for (size_t x = 0; (x < U_PORT_TASK_STACK_MAX_NUM) && (pEntry == NULL); x++) {
+        if ((gEntry[x].state == U_PORT_TASK_STACK_STATE_ENDED) &&
+            (strncmp(gEntry[x].taskStack.name, pName,
+                     sizeof(gEntry[x].taskStack.name) - 1) == 0) &&
+            U_ATOMIC_CAS32(&(gEntry[x].state), U_PORT_TASK_STACK_STATE_ENDED,
+                           U_PORT_TASK_STACK_STATE_CLAIMED)) {
+            pEntry = &(gEntry[x]);
+        }
+    }
+    if (pEntry == NULL) {
+        for (size_t x = 0; (x < U_PORT_TASK_STACK_MAX_NUM) && (pEntry == NULL); x++) {
+            if (U_ATOMIC_CAS32(&(gEntry[x].state), U_PORT_TASK_STACK_STATE_FREE,
+                               U_PORT_TASK_STACK_STATE_CLAIMED)) {
+                pEntry = &(gEntry[x]);
+                pTaskStack = &(pEntry->taskStack);
+                memset(pTaskStack, 0, sizeof(*pTaskStack));
+                strncpy(pTaskStack->name, pName, sizeof(pTaskStack->name) - 1);
+                pTaskStack->usedMaxBytes = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            }
+        }
+    }
+    if (pEntry != NULL) {
+        pTaskStack = &(pEntry->taskStack);
+        pEntry->taskHandle = taskHandle;
+        pTaskStack->stackSizeBytes = stackSizeBytes;
+        pTaskStack->numCreated++;
+        if (endedEarlyRemove(taskHandle)) {
+            // Too late to measure it
+            pEntry->taskHandle = NULL;
+            pEntry->state = U_PORT_TASK_STACK_STATE_ENDED;
+        } else {
+            pEntry->state = U_PORT_TASK_STACK_STATE_RUNNING;
+        }
+    } else {
+        do {
+            numNotRecorded = gNumNotRecorded;
+        } while (!U_ATOMIC_CAS32(&gNumNotRecorded, numNotRecorded, numNotRecorded + 1));
+    }
+}
+
+// Record the final figures of a task that is about to be deleted.
+void uPortTaskStackDeregister(const uPortTaskHandle_t taskHandle)
+{
+    uPortTaskHandle_t handle = taskHandle;
+    uPortTaskStackEntry_t *pEntry = NULL;
+
+    if ((handle != NULL) || (uPortTaskGetHandle(&handle) == 0)) {
+        for (size_t x = 0; (x < U_PORT_TASK_STACK_MAX_NUM) && (pEntry == NULL); x++) {
+            if ((gEntry[x].taskHandle == handle) &&
+                ((gEntry[x].state == U_PORT_TASK_STACK_STATE_RUNNING) ||
+                 (gEntry[x].state == U_PORT_TASK_STACK_STATE_READING))) {
+                pEntry = &(gEntry[x]);
+            }
+        }
+        if (pEntry != NULL) {
+            // Wait for anyone reading the figures of the
+            // task to finish before it is allowed to go
+            while (!U_ATOMIC_CAS32(&(pEntry->state), U_PORT_TASK_STACK_STATE_RUNNING,
+                                   U_PORT_TASK_STACK_STATE_CLAIMED)) {
+                uPortTaskBlock(U_CFG_OS_YIELD_MS);
+            }
+            usedAdd(&(pEntry->taskStack), usedBytes(taskHandle,
+                                                    pEntry->taskStack.stackSizeBytes));
+            pEntry->taskHandle = NULL;
+            pEntry->state = U_PORT_TASK_STACK_STATE_ENDED;
+        } else {
+            endedEarlyAdd(handle);
+        }
+    }
+}
+
+// Get the figures for an entry in the registry.
+int32_t uPortTaskStackGet(size_t index, uPortTaskStack_t *pTaskStack)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortTaskStackEntry_t *pEntry;
+    bool gotIt = false;
+
+    if (pTaskStack != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        if (index < U_PORT_TASK_STACK_MAX_NUM) {
+            pEntry = &(gEntry[index]);
+            // Entries are claimed in order, so the first free
+            // one is the end; skip any that are being written
+            while ((pEntry->state != U_PORT_TASK_STACK_STATE_FREE) && !gotIt) {
+                if (U_ATOMIC_CAS32(&(pEntry->state), U_PORT_TASK_STACK_STATE_RUNNING,
+                                   U_PORT_TASK_STACK_STATE_READING)) {
+                    // Running: include what it has used so far,
+                    // the task can't be deleted while we do this
+                    *pTaskStack = pEntry->taskStack;
+                    usedAdd(pTaskStack, usedBytes(pEntry->taskHandle,
+                                                  pTaskStack->stackSizeBytes));
+                    pTaskStack->running = true;
+                    pEntry->state = U_PORT_TASK_STACK_STATE_RUNNING;
+                    gotIt = true;
+                } else if (U_ATOMIC_CAS32(&(pEntry->state), U_PORT_TASK_STACK_STATE_ENDED,
+                                          U_PORT_TASK_STACK_STATE_CLAIMED)) {
+                    *pTaskStack = pEntry->taskStack;
+                    pTaskStack->running = false;
+                    pEntry->state = U_PORT_TASK_STACK_STATE_ENDED;
+                    gotIt = true;
+                } else {
+                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                }
+            }
+            if (gotIt) {
+                pTaskStack->recommendedBytes = recommendedBytes(pTaskStack->usedMaxBytes);
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Print the registry.
+void uPortTaskStackPrint(void)
+{
+    uPortTaskStack_t taskStack;
+    int32_t savedBytes = 0;
+
+    uPortLog("U_PORT_TASK_STACK: %-16s %7s %7s %10s %10s %11s\n", "task",
+             "created", "running", "size", "used max", "recommended");
+    for (size_t x = 0; uPortTaskStackGet(x, &taskStack) == 0; x++) {
+        uPortLog("U_PORT_TASK_STACK: %-16s %7d %7s %10d", taskStack.name,
+                 (int32_t) taskStack.numCreated, taskStack.running ? "yes" : "no",
+                 (int32_t) taskStack.stackSizeBytes);
+        if (taskStack.usedMaxBytes >= 0) {
+            uPortLog(" %10d %11d\n", taskStack.usedMaxBytes, taskStack.recommendedBytes);
+            if (taskStack.recommendedBytes < (int32_t) taskStack.stackSizeBytes) {
+                savedBytes += (int32_t) taskStack.stackSizeBytes - taskStack.recommendedBytes;
+            }
+        } else {
+            uPortLog(" %10s %11s\n", "-", "-");
+        }
+    }
+    uPortLog("U_PORT_TASK_STACK: %d byte(s) of stack would be saved by"
+             " using the recommended sizes.\n", savedBytes);
+    if (gNumNotRecorded > 0) {
+        uPortLog("U_PORT_TASK_STACK: %d task(s) not recorded, increase"
+                 " U_PORT_TASK_STACK_MAX_NUM.\n", (int32_t) gNumNotRecorded);
+    }
+}
+
+// End of file
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the timing harness for benchmarks.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_cfg_sw.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_gpio.h"
+
+#include "u_bench.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Whether #U_CFG_TEST_PIN_ENERGY_MARKER has been configured.
+ */
+static bool gEnergyPinConfigured = false;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Set the level of the energy marker pin, if there is one.
+static void energyPinSet(int32_t level)
+{
+    uPortGpioConfig_t gpioConfig = U_PORT_GPIO_CONFIG_DEFAULT;
+
+    if (U_CFG_TEST_PIN_ENERGY_MARKER >= 0) {
+        if (!gEnergyPinConfigured) {
+            // Set the level first so that there is no glitch
+            uPortGpioSet(U_CFG_TEST_PIN_ENERGY_MARKER, 0);
+            gpioConfig.pin = U_CFG_TEST_PIN_ENERGY_MARKER;
+            gpioConfig.direction = U_PORT_GPIO_DIRECTION_OUTPUT;
+            gEnergyPinConfigured = (uPortGpioConfig(&gpioConfig) == 0);
+        }
+        if (gEnergyPinConfigured) {
+            uPortGpioSet(U_CFG_TEST_PIN_ENERGY_MARKER, level);
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start a benchmark measurement.
+void uBenchStart(uBench_t *pBench, const char *pName)
+{
+    pBench->pName = pName;
+    pBench->startTimeMs = uPortGetTickTimeMs();
+}
+
+// Stop a benchmark measurement and print the result.
+int32_t uBenchStop(const uBench_t *pBench, int32_t iterations,
+                   uint32_t units, const char *pUnit)
+{
+    int32_t elapsedMs = uPortGetTickTimeMs() - pBench->startTimeMs;
+    uint64_t perSecond;
+
+    if (elapsedMs <= 0) {
+        elapsedMs = 1;
+    }
+    perSecond = ((uint64_t) units * 1000) / (uint32_t) elapsedMs;
+    if (perSecond > INT32_MAX) {
+        perSecond = INT32_MAX;
+    }
+
+    uPortLog(U_BENCH_PREFIX "name=%s iterations=%d elapsedMs=%d units=%u"
+             " unit=%s perSecond=%d\n", pBench->pName, iterations, elapsedMs,
+             (unsigned int) units, pUnit, (int32_t) perSecond);
+
+    return (int32_t) perSecond;
+}
+
+// Mark the start of an operation whose energy is to be measured.
+void uBenchEnergyBegin(const char *pName)
+{
+    // Print first so that the print is not part of the operation
+    uPortLog(U_BENCH_ENERGY_PREFIX "name=%s mark=begin timeMs=%d\n",
+             pName, uPortGetTickTimeMs());
+    energyPinSet(1);
+}
+
+// Mark the end of an operation whose energy is to be measured.
+void uBenchEnergyEnd(const char *pName)
+{
+    int32_t timeMs = uPortGetTickTimeMs();
+
+    energyPinSet(0);
+    uPortLog(U_BENCH_ENERGY_PREFIX "name=%s mark=end timeMs=%d\n",
+             pName, timeMs);
+}
+
+// End of file
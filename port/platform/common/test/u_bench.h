@@ -0,0 +1,157 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_BENCH_H_
+#define _U_BENCH_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** @file
+ * @brief A timing harness for benchmarks that are run by the test
+ * runner.  A benchmark is defined with U_PORT_BENCH_FUNCTION(),
+ * which follows exactly the same naming rules as
+ * U_PORT_TEST_FUNCTION() so that the test automation runs it along
+ * with the tests of the same API, and reports its result with
+ * uBenchStop(), which prints a single line of the form:
+ *
+ * U_BENCH: name=ubxProtocolEncode iterations=10000 elapsedMs=123 units=1000000 unit=bytes perSecond=8130081
+ *
+ * ...which the automation script u_monitor.py picks out and adds
+ * to the test report as properties of the test case.  A benchmark
+ * should check what it does, asserting as a test would, so that it
+ * cannot report the speed of something that is broken.
+ *
+ * For energy measurements an operation may be bracketed with
+ * uBenchEnergyBegin() and uBenchEnergyEnd(), which print lines of
+ * the form:
+ *
+ * U_BENCH_ENERGY: name=mqttClientPublish mark=begin timeMs=10234
+ *
+ * ...and, if #U_CFG_TEST_PIN_ENERGY_MARKER is set, drive that pin
+ * high for the duration of the operation; the automation script
+ * u_energy.py pairs these markers with a power-analyser capture
+ * to report the charge and energy consumed per operation.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The prefix of the line printed by uBenchStop(), for the test
+ * automation to look for.
+ */
+#define U_BENCH_PREFIX "U_BENCH: "
+
+/** The prefix of the lines printed by uBenchEnergyBegin() and
+ * uBenchEnergyEnd(), for the test automation to look for.
+ */
+#define U_BENCH_ENERGY_PREFIX "U_BENCH_ENERGY: "
+
+#ifndef U_CFG_TEST_PIN_ENERGY_MARKER
+/** The pin that uBenchEnergyBegin() sets high and uBenchEnergyEnd()
+ * sets low, to be wired to a digital input of the power analyser
+ * so that the markers line up exactly with its capture; -1 for
+ * none, in which case the markers can only be lined up using the
+ * times that are printed.
+ */
+# define U_CFG_TEST_PIN_ENERGY_MARKER -1
+#endif
+
+/** Macro to wrap the definition of a benchmark function; the group
+ * and name strings must follow the same rules as those of
+ * U_PORT_TEST_FUNCTION(), e.g. "[ubxProtocol]" and
+ * "ubxProtocolBenchEncodeDecode".
+ */
+#define U_PORT_BENCH_FUNCTION(group, name) U_PORT_TEST_FUNCTION(group, name)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A benchmark measurement, set up by uBenchStart().
+ */
+typedef struct {
+    const char *pName;
+    int32_t startTimeMs;
+} uBench_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Start a benchmark measurement.
+ *
+ * @param[out] pBench a place to store the measurement; cannot be NULL.
+ * @param[in] pName   the name of the measurement, which should contain
+ *                    no spaces and must remain valid until uBenchStop()
+ *                    has been called; cannot be NULL.
+ */
+void uBenchStart(uBench_t *pBench, const char *pName);
+
+/** Stop a benchmark measurement and print the result as a single
+ * line beginning with #U_BENCH_PREFIX.  Since the tick timer may
+ * have a resolution no better than a millisecond an elapsed time
+ * of zero is treated as one millisecond; choose the number of
+ * iterations such that the elapsed time is at least a few hundred
+ * milliseconds on the slowest platform.
+ *
+ * @param[in] pBench   the measurement, as passed to uBenchStart();
+ *                     cannot be NULL.
+ * @param iterations   the number of iterations of the operation
+ *                     that was measured.
+ * @param units        the number of units, e.g. bytes, that were
+ *                     processed in total.
+ * @param[in] pUnit    the name of the units, e.g. "bytes", which
+ *                     should contain no spaces; cannot be NULL.
+ * @return             the number of units per second.
+ */
+int32_t uBenchStop(const uBench_t *pBench, int32_t iterations,
+                   uint32_t units, const char *pUnit);
+
+/** Mark the start of an operation whose energy is to be measured:
+ * prints a line beginning with #U_BENCH_ENERGY_PREFIX and then,
+ * if #U_CFG_TEST_PIN_ENERGY_MARKER is not -1, sets that pin high.
+ * Operations that are marked must not overlap.
+ *
+ * @param[in] pName the name of the operation, e.g.
+ *                  "cellNetConnect", which should contain no
+ *                  spaces; cannot be NULL.
+ */
+void uBenchEnergyBegin(const char *pName);
+
+/** Mark the end of an operation whose energy is to be measured:
+ * if #U_CFG_TEST_PIN_ENERGY_MARKER is not -1 sets that pin low
+ * and then prints a line beginning with #U_BENCH_ENERGY_PREFIX.
+ *
+ * @param[in] pName the name of the operation, as passed to
+ *                  uBenchEnergyBegin(); cannot be NULL.
+ */
+void uBenchEnergyEnd(const char *pName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_BENCH_H_
+
+// End of file
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the C++17 layer of ubxlib.hpp.  No module is
+ * required: the tests check the Span type and that the owning
+ * classes behave correctly when the underlying C API refuses, in
+ * particular that a handle is kept when a close fails.  Where the
+ * tests are compiled as C, or as C++ earlier than C++17, they
+ * compile to nothing.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcmp()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+
+#if defined(__cplusplus) && (__cplusplus >= 201703L)
+
+#include "ubxlib.hpp"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_UBXLIB_HPP_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** A device handle that no device has: the first slot but a
+ * generation that has not been reached.
+ */
+#define U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE ((uDeviceHandle_t) (uintptr_t) 0x7f01)
+
+/** A socket descriptor that no socket has.
+ */
+#define U_UBXLIB_HPP_TEST_BAD_DESCRIPTOR 42
+
+/** An asynchronous GNSS message reader handle that no reader has.
+ */
+#define U_UBXLIB_HPP_TEST_BAD_ASYNC_HANDLE 3
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test Span and byteSpan().
+ */
+U_PORT_TEST_FUNCTION("[ubxlibHpp]", "ubxlibHppSpan")
+{
+    char buffer[10] = "012345678";
+    const char literal[] = "abc";
+    ubxlib::Span<char> span(buffer);
+    ubxlib::Span<const char> constSpan = span;
+    ubxlib::Span<char> empty;
+
+    U_PORT_TEST_ASSERT(span.data() == buffer);
+    U_PORT_TEST_ASSERT(span.size() == sizeof(buffer));
+    U_PORT_TEST_ASSERT(span.sizeBytes() == sizeof(buffer));
+    U_PORT_TEST_ASSERT(!span.empty());
+    U_PORT_TEST_ASSERT(span.end() - span.begin() == (int32_t) sizeof(buffer));
+    U_PORT_TEST_ASSERT(span[3] == '3');
+    U_PORT_TEST_ASSERT(constSpan.data() == buffer);
+    U_PORT_TEST_ASSERT(constSpan.size() == span.size());
+    U_PORT_TEST_ASSERT(empty.empty());
+    U_PORT_TEST_ASSERT(empty.data() == nullptr);
+
+    // first() and subspan() are clipped to what is there
+    U_PORT_TEST_ASSERT(span.first(4).size() == 4);
+    U_PORT_TEST_ASSERT(span.first(100).size() == sizeof(buffer));
+    U_PORT_TEST_ASSERT(span.subspan(2).data() == buffer + 2);
+    U_PORT_TEST_ASSERT(span.subspan(2).size() == sizeof(buffer) - 2);
+    U_PORT_TEST_ASSERT(span.subspan(2, 3).size() == 3);
+    U_PORT_TEST_ASSERT(memcmp(span.subspan(2, 3).data(), "234", 3) == 0);
+    U_PORT_TEST_ASSERT(span.subspan(8, 5).size() == 2);
+    U_PORT_TEST_ASSERT(span.subspan(100).empty());
+    U_PORT_TEST_ASSERT(span.subspan(100).data() == buffer + sizeof(buffer));
+
+    // A span of a string literal includes the terminator
+    auto literalSpan = ubxlib::byteSpan(literal);
+    U_PORT_TEST_ASSERT(literalSpan.data() == literal);
+    U_PORT_TEST_ASSERT(literalSpan.size() == 4);
+
+    // Writing through a span writes the buffer
+    span[0] = 'x';
+    U_PORT_TEST_ASSERT(buffer[0] == 'x');
+}
+
+/** Test the owning classes against the C APIs, without a module:
+ * in particular that an owner keeps its handle when the C API
+ * refuses to close it.
+ */
+U_PORT_TEST_FUNCTION("[ubxlibHpp]", "ubxlibHppOwners")
+{
+    int32_t heapUsed;
+    uDeviceCfg_t deviceCfg;
+    uGnssMessageId_t messageId;
+    int32_t callCount = 0;
+    auto callable = [&callCount](const ubxlib::GnssMessage &) {
+        callCount++;
+    };
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uDeviceInit() == 0);
+
+    U_TEST_PRINT_LINE("testing Device...");
+    {
+        ubxlib::Device device;
+        U_PORT_TEST_ASSERT(!device);
+        U_PORT_TEST_ASSERT(device.close() == 0);
+        // An open that fails leaves nothing owned
+        memset(&deviceCfg, 0, sizeof(deviceCfg));
+        deviceCfg.deviceType = U_DEVICE_TYPE_NONE;
+        U_PORT_TEST_ASSERT(device.open(deviceCfg) < 0);
+        U_PORT_TEST_ASSERT(!device);
+        // A close that fails keeps the handle, and so does an
+        // open, which has to close first
+        ubxlib::Device badDevice(U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE);
+        U_PORT_TEST_ASSERT(badDevice.close() < 0);
+        U_PORT_TEST_ASSERT(badDevice);
+        U_PORT_TEST_ASSERT(badDevice.handle() == U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE);
+        U_PORT_TEST_ASSERT(badDevice.open(deviceCfg) < 0);
+        U_PORT_TEST_ASSERT(badDevice.handle() == U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE);
+        // Ownership moves
+        device = std::move(badDevice);
+        U_PORT_TEST_ASSERT(!badDevice);
+        U_PORT_TEST_ASSERT(device.handle() == U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE);
+        ubxlib::Device movedDevice(std::move(device));
+        U_PORT_TEST_ASSERT(!device);
+        U_PORT_TEST_ASSERT(movedDevice.release() == U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE);
+        U_PORT_TEST_ASSERT(!movedDevice);
+    }
+
+    U_TEST_PRINT_LINE("testing Socket...");
+    {
+        ubxlib::Socket sock;
+        char buffer[8];
+        auto dataCallable = []() {};
+        U_PORT_TEST_ASSERT(!sock);
+        U_PORT_TEST_ASSERT(sock.close() == 0);
+        U_PORT_TEST_ASSERT(sock.create(nullptr, U_SOCK_TYPE_STREAM, U_SOCK_PROTOCOL_TCP) < 0);
+        U_PORT_TEST_ASSERT(!sock);
+        ubxlib::Socket badSock(U_UBXLIB_HPP_TEST_BAD_DESCRIPTOR);
+        U_PORT_TEST_ASSERT(badSock.write("x") < 0);
+        U_PORT_TEST_ASSERT(badSock.read(buffer) < 0);
+        badSock.onData(dataCallable);
+        badSock.onClosed(dataCallable);
+        U_PORT_TEST_ASSERT(badSock.close() < 0);
+        U_PORT_TEST_ASSERT(badSock);
+        U_PORT_TEST_ASSERT(badSock.descriptor() == U_UBXLIB_HPP_TEST_BAD_DESCRIPTOR);
+        U_PORT_TEST_ASSERT(badSock.create(nullptr, U_SOCK_TYPE_STREAM, U_SOCK_PROTOCOL_TCP) < 0);
+        U_PORT_TEST_ASSERT(badSock.descriptor() == U_UBXLIB_HPP_TEST_BAD_DESCRIPTOR);
+        sock = std::move(badSock);
+        U_PORT_TEST_ASSERT(!badSock);
+        U_PORT_TEST_ASSERT(sock.release() == U_UBXLIB_HPP_TEST_BAD_DESCRIPTOR);
+        U_PORT_TEST_ASSERT(!sock);
+    }
+
+    U_TEST_PRINT_LINE("testing GnssReader...");
+    {
+        ubxlib::GnssReader reader;
+        memset(&messageId, 0, sizeof(messageId));
+        messageId.type = U_GNSS_PROTOCOL_ALL;
+        U_PORT_TEST_ASSERT(!reader);
+        U_PORT_TEST_ASSERT(reader.stop() == 0);
+        U_PORT_TEST_ASSERT(reader.start(U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE,
+                                        messageId, callable) < 0);
+        U_PORT_TEST_ASSERT(!reader);
+        ubxlib::GnssReader badReader(U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE,
+                                     U_UBXLIB_HPP_TEST_BAD_ASYNC_HANDLE);
+        U_PORT_TEST_ASSERT(badReader.stop() < 0);
+        U_PORT_TEST_ASSERT(badReader);
+        U_PORT_TEST_ASSERT(badReader.asyncHandle() == U_UBXLIB_HPP_TEST_BAD_ASYNC_HANDLE);
+        U_PORT_TEST_ASSERT(badReader.gnssHandle() == U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE);
+        U_PORT_TEST_ASSERT(badReader.start(U_UBXLIB_HPP_TEST_BAD_DEVICE_HANDLE,
+                                           messageId, callable) < 0);
+        U_PORT_TEST_ASSERT(badReader.asyncHandle() == U_UBXLIB_HPP_TEST_BAD_ASYNC_HANDLE);
+        reader = std::move(badReader);
+        U_PORT_TEST_ASSERT(!badReader);
+        U_PORT_TEST_ASSERT(reader.release() == U_UBXLIB_HPP_TEST_BAD_ASYNC_HANDLE);
+        U_PORT_TEST_ASSERT(!reader);
+        U_PORT_TEST_ASSERT(reader.gnssHandle() == nullptr);
+        U_PORT_TEST_ASSERT(callCount == 0);
+    }
+
+    U_TEST_PRINT_LINE("testing MqttClient...");
+    {
+        ubxlib::MqttClient mqttClient;
+        U_PORT_TEST_ASSERT(!mqttClient);
+        U_PORT_TEST_ASSERT(mqttClient.open(nullptr) < 0);
+        U_PORT_TEST_ASSERT(!mqttClient);
+        U_PORT_TEST_ASSERT(mqttClient.release() == nullptr);
+    }
+
+    uSockDeinit();
+    uDeviceDeinit();
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
+#endif // defined(__cplusplus) && (__cplusplus >= 201703L)
+
+// End of file
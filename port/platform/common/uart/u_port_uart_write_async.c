@@ -0,0 +1,199 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Default implementation of uPortUartWriteAsyncOpen(),
+ * uPortUartWriteAsyncClose() and uPortUartWriteAsync(), common to
+ * all platforms; a platform may override them.  The writes are
+ * performed, with uPortUartWritev(), in the task of an event queue,
+ * one event queue per UART.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t, offsetof() etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy()
+
+#include "u_compiler.h" // U_WEAK
+
+#include "u_error_common.h"
+
+#include "u_port_event_queue.h"
+#include "u_port_uart.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A UART on which uPortUartWriteAsyncOpen() has been called.
+ */
+typedef struct {
+    bool inUse;
+    int32_t uartHandle;
+    int32_t eventQueueHandle;
+} uPortUartWriteAsyncInstance_t;
+
+/** The parameter block of the event queue: a write.  ioVec
+ * MUST be the last member as only the entries that are used
+ * are sent.
+ */
+typedef struct {
+    int32_t uartHandle;
+    uPortUartWriteCallback_t pCallback;
+    void *pCallbackParam;
+    size_t numIoVec;
+    uPortUartIoVec_t ioVec[U_PORT_UART_WRITE_ASYNC_MAX_NUM_IO_VEC];
+} uPortUartWriteAsyncEvent_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The UARTs on which uPortUartWriteAsyncOpen() has been called.
+ */
+static uPortUartWriteAsyncInstance_t gInstance[U_PORT_UART_WRITE_ASYNC_MAX_NUM];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Find the instance for the given UART handle, NULL if not found.
+static uPortUartWriteAsyncInstance_t *pGetInstance(int32_t uartHandle)
+{
+    uPortUartWriteAsyncInstance_t *pInstance = NULL;
+
+    for (size_t x = 0; (x < sizeof(gInstance) / sizeof(gInstance[0])) &&
+         (pInstance == NULL); x++) {
+        if (gInstance[x].inUse && (gInstance[x].uartHandle == uartHandle)) {
+            pInstance = &(gInstance[x]);
+        }
+    }
+
+    return pInstance;
+}
+
+// Event handler: perform a write and call the callback.
+static void eventHandler(void *pParam, size_t paramLength)
+{
+    uPortUartWriteAsyncEvent_t *pEvent = (uPortUartWriteAsyncEvent_t *) pParam;
+    int32_t sizeOrErrorCode = 0;
+    size_t length = 0;
+
+    (void) paramLength;
+
+    for (size_t x = 0; x < pEvent->numIoVec; x++) {
+        length += pEvent->ioVec[x].length;
+    }
+    if (length > 0) {
+        sizeOrErrorCode = uPortUartWritev(pEvent->uartHandle,
+                                          pEvent->ioVec, pEvent->numIoVec);
+    }
+    if (pEvent->pCallback != NULL) {
+        pEvent->pCallback(pEvent->uartHandle, sizeOrErrorCode,
+                          pEvent->pCallbackParam);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Enable uPortUartWriteAsync() on a UART.
+U_WEAK int32_t uPortUartWriteAsyncOpen(int32_t handle, size_t stackSizeBytes,
+                                       int32_t priority)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortUartWriteAsyncInstance_t *pInstance = NULL;
+
+    if ((handle >= 0) && (pGetInstance(handle) == NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        for (size_t x = 0; (x < sizeof(gInstance) / sizeof(gInstance[0])) &&
+             (pInstance == NULL); x++) {
+            if (!gInstance[x].inUse) {
+                pInstance = &(gInstance[x]);
+            }
+        }
+        if (pInstance != NULL) {
+            errorCode = uPortEventQueueOpen(eventHandler, "uartTxAsync",
+                                            sizeof(uPortUartWriteAsyncEvent_t),
+                                            stackSizeBytes, priority,
+                                            U_PORT_UART_WRITE_ASYNC_QUEUE_LENGTH);
+            if (errorCode >= 0) {
+                pInstance->uartHandle = handle;
+                pInstance->eventQueueHandle = errorCode;
+                pInstance->inUse = true;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Disable uPortUartWriteAsync() on a UART.
+U_WEAK void uPortUartWriteAsyncClose(int32_t handle)
+{
+    uPortUartWriteAsyncInstance_t *pInstance = pGetInstance(handle);
+
+    if (pInstance != NULL) {
+        // Closing the event queue lets the writes already
+        // queued complete first
+        uPortEventQueueClose(pInstance->eventQueueHandle);
+        pInstance->inUse = false;
+    }
+}
+
+// Write to a UART without waiting.
+U_WEAK int32_t uPortUartWriteAsync(int32_t handle, const uPortUartIoVec_t *pIoVec,
+                                   size_t numIoVec, uPortUartWriteCallback_t pCallback,
+                                   void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortUartWriteAsyncInstance_t *pInstance = pGetInstance(handle);
+    uPortUartWriteAsyncEvent_t event;
+
+    if ((pInstance != NULL) && ((pIoVec != NULL) || (numIoVec == 0)) &&
+        (numIoVec <= U_PORT_UART_WRITE_ASYNC_MAX_NUM_IO_VEC)) {
+        event.uartHandle = handle;
+        event.pCallback = pCallback;
+        event.pCallbackParam = pCallbackParam;
+        event.numIoVec = numIoVec;
+        if (numIoVec > 0) {
+            memcpy(event.ioVec, pIoVec, sizeof(event.ioVec[0]) * numIoVec);
+        }
+        errorCode = uPortEventQueueSend(pInstance->eventQueueHandle, &event,
+                                        offsetof(uPortUartWriteAsyncEvent_t, ioVec) +
+                                        (sizeof(event.ioVec[0]) * numIoVec));
+    }
+
+    return errorCode;
+}
+
+// End of file
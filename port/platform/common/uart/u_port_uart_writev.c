@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Default implementation of uPortUartWritev(), common to all
+ * platforms; a platform may override it.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy()
+
+#include "u_compiler.h" // U_WEAK
+
+#include "u_error_common.h"
+
+#include "u_port_heap.h"
+#include "u_port_uart.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Write the pieces of data one at a time.
+static int32_t writeEach(int32_t handle, const uPortUartIoVec_t *pIoVec,
+                         size_t numIoVec)
+{
+    int32_t sizeOrErrorCode = 0;
+    int32_t written;
+
+    for (size_t x = 0; (x < numIoVec) && (sizeOrErrorCode >= 0); x++) {
+        if ((pIoVec + x)->length > 0) {
+            written = uPortUartWrite(handle, (pIoVec + x)->pBase,
+                                     (pIoVec + x)->length);
+            if (written >= 0) {
+                sizeOrErrorCode += written;
+            } else {
+                sizeOrErrorCode = written;
+            }
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+U_WEAK int32_t uPortUartWritev(int32_t handle, const uPortUartIoVec_t *pIoVec,
+                               size_t numIoVec)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    char buffer[U_PORT_UART_WRITEV_BUFFER_LENGTH_BYTES];
+    char *pBuffer = buffer;
+    size_t length = 0;
+    bool ioVecValid = (pIoVec != NULL);
+
+    for (size_t x = 0; ioVecValid && (x < numIoVec); x++) {
+        if (((pIoVec + x)->pBase == NULL) && ((pIoVec + x)->length > 0)) {
+            ioVecValid = false;
+        }
+        length += (pIoVec + x)->length;
+    }
+
+    if (ioVecValid && (length > 0) && (length <= INT32_MAX)) {
+        if (length > sizeof(buffer)) {
+            pBuffer = (char *) pUPortHeapAlloc(length, U_PORT_HEAP_TAG_PORT);
+        }
+        if (pBuffer != NULL) {
+            // Gather the pieces and write them in one go
+            length = 0;
+            for (size_t x = 0; x < numIoVec; x++) {
+                if ((pIoVec + x)->length > 0) {
+                    memcpy(pBuffer + length, (pIoVec + x)->pBase, (pIoVec + x)->length);
+                    length += (pIoVec + x)->length;
+                }
+            }
+            sizeOrErrorCode = uPortUartWrite(handle, pBuffer, length);
+            if (pBuffer != buffer) {
+                uPortHeapFree(pBuffer, U_PORT_HEAP_TAG_PORT);
+            }
+        } else {
+            // No memory, just have to write the pieces separately
+            sizeOrErrorCode = writeEach(handle, pIoVec, numIoVec);
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
+// End of file
@@ -29,6 +29,7 @@
 #include "u_port.h"
 #include "u_port_gpio.h"
 
+#include "freertos/FreeRTOS.h" // For portMUX_TYPE
 #include "driver/gpio.h"
 #include "driver/rtc_io.h"
 
@@ -40,14 +41,59 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Structure to keep track of a GPIO interrupt.
+ */
+typedef struct {
+    int32_t pin;
+    void (*pCallback) (int32_t, void *);
+    void *pCallbackParam;
+} uPortGpioInterrupt_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The GPIO interrupts; an entry is free if pCallback is NULL.
+ */
+static uPortGpioInterrupt_t gInterrupt[U_PORT_GPIO_INTERRUPT_MAX_NUM] = {0};
+
+/** Spinlock protecting gInterrupt.
+ */
+static portMUX_TYPE gInterruptSpinlock = portMUX_INITIALIZER_UNLOCKED;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// The interrupt handler for all GPIO interrupts.
+static void interruptHandler(void *pParam)
+{
+    uPortGpioInterrupt_t *pInterrupt = (uPortGpioInterrupt_t *) pParam;
+    void (*pCallback) (int32_t, void *) = pInterrupt->pCallback;
+
+    if (pCallback != NULL) {
+        pCallback(pInterrupt->pin, pInterrupt->pCallbackParam);
+    }
+}
+
+// Find the interrupt entry for the given pin or, if pin is
+// negative, a free entry.
+// Note: gInterruptSpinlock should be taken before this is called.
+static uPortGpioInterrupt_t *pInterruptGet(int32_t pin)
+{
+    uPortGpioInterrupt_t *pInterrupt = NULL;
+
+    for (size_t x = 0; (x < sizeof(gInterrupt) / sizeof(gInterrupt[0])) &&
+         (pInterrupt == NULL); x++) {
+        if (((pin >= 0) && (gInterrupt[x].pCallback != NULL) && (gInterrupt[x].pin == pin)) ||
+            ((pin < 0) && (gInterrupt[x].pCallback == NULL))) {
+            pInterrupt = &(gInterrupt[x]);
+        }
+    }
+
+    return pInterrupt;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -156,4 +202,61 @@ int32_t uPortGpioGet(int32_t pin)
     return gpio_get_level((gpio_num_t) pin);
 }
 
+// Set or remove an interrupt on a GPIO.
+int32_t uPortGpioInterruptSet(int32_t pin, bool risingEdge,
+                              void (*pCallback) (int32_t pin,
+                                                 void *pCallbackParam),
+                              void *pCallbackParam)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortGpioInterrupt_t *pInterrupt;
+    esp_err_t espErr;
+
+    if (pin >= 0) {
+        errorCode = U_ERROR_COMMON_SUCCESS;
+        portENTER_CRITICAL(&gInterruptSpinlock);
+        pInterrupt = pInterruptGet(pin);
+        if (pCallback == NULL) {
+            if (pInterrupt != NULL) {
+                // Mark the entry as free first so that the
+                // handler does nothing if it is running
+                pInterrupt->pCallback = NULL;
+            }
+        } else {
+            if (pInterrupt == NULL) {
+                pInterrupt = pInterruptGet(-1);
+            }
+            if (pInterrupt != NULL) {
+                pInterrupt->pin = pin;
+                pInterrupt->pCallbackParam = pCallbackParam;
+                pInterrupt->pCallback = pCallback;
+            } else {
+                errorCode = U_ERROR_COMMON_NO_MEMORY;
+            }
+        }
+        portEXIT_CRITICAL(&gInterruptSpinlock);
+
+        if (pCallback == NULL) {
+            gpio_set_intr_type((gpio_num_t) pin, GPIO_INTR_DISABLE);
+            gpio_isr_handler_remove((gpio_num_t) pin);
+        } else if (errorCode == U_ERROR_COMMON_SUCCESS) {
+            errorCode = U_ERROR_COMMON_PLATFORM;
+            // The ISR service may already have been installed,
+            // by us or by someone else, that's fine
+            espErr = gpio_install_isr_service(0);
+            if (((espErr == ESP_OK) || (espErr == ESP_ERR_INVALID_STATE)) &&
+                (gpio_set_intr_type((gpio_num_t) pin,
+                                    risingEdge ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE) == ESP_OK) &&
+                (gpio_isr_handler_add((gpio_num_t) pin, interruptHandler,
+                                      (void *) pInterrupt) == ESP_OK)) {
+                errorCode = U_ERROR_COMMON_SUCCESS;
+            } else {
+                pInterrupt->pCallback = NULL;
+            }
+        }
+    }
+
+    return (int32_t) errorCode;
+}
+
 // End of file
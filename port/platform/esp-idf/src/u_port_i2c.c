@@ -468,7 +468,8 @@ int32_t uPortI2cControllerSendReceive(int32_t handle, uint16_t address,
             ((pReceive != NULL) || (bytesToReceive == 0))) {
             errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
             if (pSend != NULL) {
-                errorCodeOrLength = send(handle, address, pSend, bytesToSend, false);
+                errorCodeOrLength = send(handle, address, pSend, bytesToSend,
+                                         (pReceive != NULL));
             }
             if ((errorCodeOrLength == (int32_t) U_ERROR_COMMON_SUCCESS) &&
                 (pReceive != NULL)) {
@@ -0,0 +1,343 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Implementation of the port SPI API for the ESP-IDF platform.
+ */
+
+#include "stddef.h"
+#include "stdint.h"
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_gpio.h"
+#include "u_port_spi.h"
+
+#include "driver/spi_master.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_SPI_MAX_NUM
+/** The number of SPI HW blocks that are available on ESP32,
+ * noting that SPI 0 (SPI1_HOST) is used for flash and so
+ * is not available.
+ */
+# define U_PORT_SPI_MAX_NUM 3
+#endif
+
+#ifndef U_PORT_SPI_MAX_TRANSFER_LENGTH_BYTES
+/** The largest single transfer to hand to the ESP-IDF SPI driver;
+ * the default maximum when DMA is in use is 4092 bytes, longer
+ * blocks are split.
+ */
+# define U_PORT_SPI_MAX_TRANSFER_LENGTH_BYTES 4092
+#endif
+
+#ifndef U_PORT_SPI_FILL_BUFFER_LENGTH_BYTES
+/** The size of the buffer of #U_PORT_SPI_FILL_BYTE that is sent
+ * when the caller has nothing to send.
+ */
+# define U_PORT_SPI_FILL_BUFFER_LENGTH_BYTES 64
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Structure of the things we need to keep track of per SPI instance.
+ */
+typedef struct {
+    spi_device_handle_t device;
+    int32_t pinSelect;
+    int32_t clockHertz; // This also used as a flag to indicate "in use"
+} uPortSpiData_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Mutex to ensure thread-safety.
+ */
+static uPortMutexHandle_t gMutex = NULL;
+
+/** SPI device data.
+ */
+static uPortSpiData_t gSpiData[U_PORT_SPI_MAX_NUM];
+
+/** Something to send when there is nothing to send; static so that
+ * it is in DMA-capable memory.
+ */
+static char gFill[U_PORT_SPI_FILL_BUFFER_LENGTH_BYTES];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add the device to an SPI bus with the given clock.
+static int32_t addDevice(int32_t index, int32_t clockHertz)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+    spi_device_interface_config_t cfg = {0};
+
+    cfg.mode = 0;
+    cfg.clock_speed_hz = clockHertz;
+    // Chip select is driven by us, as a GPIO, so that
+    // it can be held across a split block
+    cfg.spics_io_num = -1;
+    cfg.queue_size = 1;
+    if (spi_bus_add_device((spi_host_device_t) index, &cfg,
+                           &(gSpiData[index].device)) == ESP_OK) {
+        gSpiData[index].clockHertz = clockHertz;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Close an SPI instance.
+static void closeSpi(int32_t index)
+{
+    if (gSpiData[index].clockHertz > 0) {
+        spi_bus_remove_device(gSpiData[index].device);
+        spi_bus_free((spi_host_device_t) index);
+        uPortGpioSet(gSpiData[index].pinSelect, 1);
+        gSpiData[index].clockHertz = -1;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Initialise SPI handling.
+int32_t uPortSpiInit()
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (gMutex == NULL) {
+        errorCode = uPortMutexCreate(&gMutex);
+        if (errorCode == 0) {
+            memset(gFill, U_PORT_SPI_FILL_BYTE, sizeof(gFill));
+            for (size_t x = 0; x < sizeof(gSpiData) / sizeof(gSpiData[0]); x++) {
+                gSpiData[x].pinSelect = -1;
+                gSpiData[x].clockHertz = -1;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Shutdown SPI handling.
+void uPortSpiDeinit()
+{
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        // Shut down any open instances
+        for (size_t x = 0; x < sizeof(gSpiData) / sizeof(gSpiData[0]); x++) {
+            closeSpi(x);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+        uPortMutexDelete(gMutex);
+        gMutex = NULL;
+    }
+}
+
+// Open an SPI instance.
+int32_t uPortSpiOpen(int32_t spi, int32_t pinMosi, int32_t pinMiso,
+                     int32_t pinClk, int32_t pinSelect)
+{
+    int32_t handleOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    spi_bus_config_t cfg = {0};
+    uPortGpioConfig_t gpioConfig;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        handleOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        // SPI 0 is the flash, not available to us
+        if ((spi > 0) && (spi < sizeof(gSpiData) / sizeof(gSpiData[0])) &&
+            (gSpiData[spi].clockHertz < 0) && (pinMosi >= 0) &&
+            (pinMiso >= 0) && (pinClk >= 0) && (pinSelect >= 0)) {
+            // Chip select is active low: set it high before
+            // making it an output
+            uPortGpioSet(pinSelect, 1);
+            U_PORT_GPIO_SET_DEFAULT(&gpioConfig);
+            gpioConfig.pin = pinSelect;
+            gpioConfig.direction = U_PORT_GPIO_DIRECTION_OUTPUT;
+            handleOrErrorCode = uPortGpioConfig(&gpioConfig);
+            if (handleOrErrorCode == 0) {
+                handleOrErrorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+                cfg.mosi_io_num = pinMosi;
+                cfg.miso_io_num = pinMiso;
+                cfg.sclk_io_num = pinClk;
+                cfg.quadwp_io_num = -1;
+                cfg.quadhd_io_num = -1;
+                cfg.max_transfer_sz = U_PORT_SPI_MAX_TRANSFER_LENGTH_BYTES;
+                if (spi_bus_initialize((spi_host_device_t) spi, &cfg,
+                                       SPI_DMA_CH_AUTO) == ESP_OK) {
+                    handleOrErrorCode = addDevice(spi, U_PORT_SPI_CLOCK_FREQUENCY_HERTZ);
+                    if (handleOrErrorCode == 0) {
+                        gSpiData[spi].pinSelect = pinSelect;
+                        // Return the SPI HW block number as the handle
+                        handleOrErrorCode = spi;
+                    } else {
+                        spi_bus_free((spi_host_device_t) spi);
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return handleOrErrorCode;
+}
+
+// Close an SPI instance.
+void uPortSpiClose(int32_t handle)
+{
+    if ((gMutex != NULL) && (handle >= 0) &&
+        (handle < sizeof(gSpiData) / sizeof(gSpiData[0]))) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        closeSpi(handle);
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+// Set the SPI clock frequency.
+int32_t uPortSpiControllerSetClock(int32_t handle, int32_t clockHertz)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((handle >= 0) && (handle < sizeof(gSpiData) / sizeof(gSpiData[0])) &&
+            (gSpiData[handle].clockHertz > 0) && (clockHertz > 0)) {
+            // The only way to change the clock is to remove
+            // the device and add it again
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            if (spi_bus_remove_device(gSpiData[handle].device) == ESP_OK) {
+                errorCode = addDevice(handle, clockHertz);
+                if (errorCode != 0) {
+                    // Put it back as it was
+                    addDevice(handle, gSpiData[handle].clockHertz);
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Get the SPI clock frequency.
+int32_t uPortSpiControllerGetClock(int32_t handle)
+{
+    int32_t errorCodeOrClock = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCodeOrClock = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((handle >= 0) && (handle < sizeof(gSpiData) / sizeof(gSpiData[0])) &&
+            (gSpiData[handle].clockHertz > 0)) {
+            errorCodeOrClock = gSpiData[handle].clockHertz;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCodeOrClock;
+}
+
+// Exchange a block of data over SPI.
+int32_t uPortSpiControllerSendReceiveBlock(int32_t handle,
+                                           const char *pSend,
+                                           char *pReceive,
+                                           size_t size)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    spi_transaction_t transaction;
+    size_t thisSize;
+    size_t offset = 0;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((handle >= 0) && (handle < sizeof(gSpiData) / sizeof(gSpiData[0])) &&
+            (gSpiData[handle].clockHertz > 0)) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+            uPortGpioSet(gSpiData[handle].pinSelect, 0);
+            while ((offset < size) && (errorCodeOrLength == 0)) {
+                thisSize = size - offset;
+                if (thisSize > U_PORT_SPI_MAX_TRANSFER_LENGTH_BYTES) {
+                    thisSize = U_PORT_SPI_MAX_TRANSFER_LENGTH_BYTES;
+                }
+                if ((pSend == NULL) && (thisSize > sizeof(gFill))) {
+                    thisSize = sizeof(gFill);
+                }
+                memset(&transaction, 0, sizeof(transaction));
+                transaction.length = thisSize * 8;
+                transaction.tx_buffer = gFill;
+                if (pSend != NULL) {
+                    transaction.tx_buffer = pSend + offset;
+                }
+                if (pReceive != NULL) {
+                    transaction.rx_buffer = pReceive + offset;
+                    transaction.rxlength = transaction.length;
+                }
+                if (spi_device_polling_transmit(gSpiData[handle].device,
+                                                &transaction) == ESP_OK) {
+                    offset += thisSize;
+                } else {
+                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_PLATFORM;
+                }
+            }
+            uPortGpioSet(gSpiData[handle].pinSelect, 1);
+            if (errorCodeOrLength == 0) {
+                errorCodeOrLength = (int32_t) size;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCodeOrLength;
+}
+
+// End of file
@@ -25,6 +25,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // memset()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_hw_platform_specific.h"
@@ -51,6 +52,19 @@
  */
 #define U_PORT_UART_EVENT_MIN_TASK_STACK_SIZE_BYTES 768
 
+#ifndef U_PORT_UART_PATTERN_QUEUE_LENGTH
+/** The number of line-feed positions that the ESP32 UART driver
+ * may record when U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED is in the
+ * event filter; if this fills up the driver stops detecting the
+ * pattern, so the event task pops a position for every line event.
+ */
+# define U_PORT_UART_PATTERN_QUEUE_LENGTH 16
+#endif
+
+/** The character that ends a line.
+ */
+#define U_PORT_UART_LINE_END_CHARACTER '\n'
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -66,6 +80,7 @@ typedef struct {
     uint32_t eventFilter;
     void (*pEventCallback)(int32_t, uint32_t, void *);
     void *pEventCallbackParam;
+    uPortUartStats_t stats;
 } uPortUartData_t;
 
 /* ----------------------------------------------------------------
@@ -82,10 +97,16 @@ static uPortMutexHandle_t gMutex = NULL;
  */
 static uPortUartData_t gUartData[U_PORT_UART_MAX_NUM];
 
-/** Convert an ESP32 event into one of our bit-map events.
- * Only UART_DATA supported at the moment.
+/** Convert an ESP32 event into one of our bit-map events.  A full
+ * buffer or FIFO counts as a line since, otherwise, a user waiting
+ * for a line might never be told to empty it.
  */
-static uint32_t gEsp32EventToEvent[] = { U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED /* UART_DATA */};
+static uint32_t gEsp32EventToEvent[] = {
+    [UART_DATA] = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+    [UART_BUFFER_FULL] = U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED,
+    [UART_FIFO_OVF] = U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED,
+    [UART_PATTERN_DET] = U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED
+};
 
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
@@ -107,6 +128,63 @@ static uint32_t getEventFromEsp32Event(uart_event_type_t esp32Event)
 // Get the event task and its associated OS thingies
 // to exit
 // Note: gMutex should !!!NOT!!! be locked before this is called.
+// Update the high-water mark of the receive buffer.
+// Note: gMutex should be locked before this is called.
+static void updateHighWaterMark(int32_t handle)
+{
+    size_t receiveSize;
+
+    if ((uart_get_buffered_data_len(handle, &receiveSize) == 0) &&
+        (receiveSize > gUartData[handle].stats.rxBufferHighWaterMark)) {
+        gUartData[handle].stats.rxBufferHighWaterMark = receiveSize;
+    }
+}
+
+// Count the errors that the ESP32 UART driver reports as events;
+// these are only seen while an event task is running.
+static void updateErrorStats(int32_t handle, uart_event_type_t esp32Event)
+{
+    switch (esp32Event) {
+        case UART_FIFO_OVF:
+            gUartData[handle].stats.rxOverrunErrors++;
+            break;
+        case UART_BUFFER_FULL:
+            gUartData[handle].stats.rxBufferOverflows++;
+            break;
+        case UART_FRAME_ERR:
+        case UART_PARITY_ERR:
+            gUartData[handle].stats.rxFramingErrors++;
+            break;
+        default:
+            break;
+    }
+}
+
+// Switch hardware detection of the end of a line on or off
+// depending on whether the filter asks for line events.
+// Note: gMutex should be locked before this is called.
+static int32_t setLineDetect(int32_t handle, uint32_t filter)
+{
+    esp_err_t espError;
+
+    if (filter & U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED) {
+        // A single character, so the timing parameters are
+        // those of the ESP-IDF example and don't matter much
+        espError = uart_enable_pattern_det_baud_intr(handle,
+                                                     U_PORT_UART_LINE_END_CHARACTER,
+                                                     1, 9, 0, 0);
+        if (espError == ESP_OK) {
+            espError = uart_pattern_queue_reset(handle,
+                                                U_PORT_UART_PATTERN_QUEUE_LENGTH);
+        }
+    } else {
+        espError = uart_disable_pattern_det_intr(handle);
+    }
+
+    return (espError == ESP_OK) ? (int32_t) U_ERROR_COMMON_SUCCESS :
+           (int32_t) U_ERROR_COMMON_PLATFORM;
+}
+
 static void deleteEventTaskRequiresMutex(int32_t handle)
 {
     uart_event_t uartEvent;
@@ -131,6 +209,9 @@ static void deleteEventTaskRequiresMutex(int32_t handle)
         // Delete the mutex
         uPortMutexDelete(gUartData[handle].eventTaskRunningMutex);
         gUartData[handle].eventTaskRunningMutex = NULL;
+        if (gUartData[handle].eventFilter & U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED) {
+            uart_disable_pattern_det_intr(handle);
+        }
     }
 }
 
@@ -166,6 +247,13 @@ static void eventTask(void *pParam)
     do {
         if (uPortQueueReceive((const uPortQueueHandle_t) gUartData[handle].queue,
                               &event) == 0) {
+            updateErrorStats(handle, event.type);
+            if (event.type == UART_PATTERN_DET) {
+                // We don't need the position of the line-feed
+                // but it must be removed from the driver's queue
+                // or pattern detection will stop when that fills up
+                uart_pattern_pop_pos(handle);
+            }
             // Check if it is in the filter
             eventBitMask = getEventFromEsp32Event(event.type);
             if (eventBitMask & gUartData[handle].eventFilter) {
@@ -268,6 +356,7 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
             gUartData[uart].eventTaskRunningMutex = NULL;
             gUartData[uart].pEventCallback = NULL;
             gUartData[uart].pEventCallbackParam = NULL;
+            memset(&gUartData[uart].stats, 0, sizeof(gUartData[uart].stats));
             gUartData[uart].eventFilter = 0;
 
             // Set the things that won't change
@@ -382,6 +471,9 @@ int32_t uPortUartGetReceiveSize(int32_t handle)
             // Will get back either size or -1
             if (uart_get_buffered_data_len(handle, &receiveSize) == 0) {
                 sizeOrErrorCode = receiveSize;
+                if (receiveSize > gUartData[handle].stats.rxBufferHighWaterMark) {
+                    gUartData[handle].stats.rxBufferHighWaterMark = receiveSize;
+                }
             }
         }
 
@@ -406,12 +498,17 @@ int32_t uPortUartRead(int32_t handle, void *pBuffer,
             (handle < sizeof(gUartData) / sizeof(gUartData[0])) &&
             !gUartData[handle].markedForDeletion) {
 
+            updateHighWaterMark(handle);
             // Will get back either size or -1
             sizeOrErrorCode = uart_read_bytes(handle,
                                               (uint8_t *) pBuffer,
                                               sizeBytes, 0);
             if (sizeOrErrorCode < 0) {
                 sizeOrErrorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            } else {
+                // The driver hides the bytes as they arrive so count
+                // them as they are read
+                gUartData[handle].stats.rxBytes += sizeOrErrorCode;
             }
         }
 
@@ -451,6 +548,8 @@ int32_t uPortUartWrite(int32_t handle,
                                                sizeBytes);
             if (sizeOrErrorCode < 0) {
                 sizeOrErrorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            } else {
+                gUartData[handle].stats.txBytes += sizeOrErrorCode;
             }
         }
 
@@ -460,6 +559,30 @@ int32_t uPortUartWrite(int32_t handle,
     return sizeOrErrorCode;
 }
 
+// Get the statistics of a UART.
+int32_t uPortUartGetStats(int32_t handle, uPortUartStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pStats != NULL) && (handle >= 0) &&
+            (handle < sizeof(gUartData) / sizeof(gUartData[0])) &&
+            (gUartData[handle].queue != NULL) &&
+            !gUartData[handle].markedForDeletion) {
+            *pStats = gUartData[handle].stats;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
 // Set an event callback.
 int32_t uPortUartEventCallbackSet(int32_t handle,
                                   uint32_t filter,
@@ -494,7 +617,10 @@ int32_t uPortUartEventCallbackSet(int32_t handle,
             // so rather than using the event queue we
             // instantiate a task to read from the queue
             // and a mutex to manage the task
-            errorCode = uPortMutexCreate(&(gUartData[handle].eventTaskRunningMutex));
+            errorCode = setLineDetect(handle, filter);
+            if (errorCode == 0) {
+                errorCode = uPortMutexCreate(&(gUartData[handle].eventTaskRunningMutex));
+            }
             if (errorCode == 0) {
                 errorCode = uPortTaskCreate(eventTask,
                                             "eventTask",
@@ -509,6 +635,8 @@ int32_t uPortUartEventCallbackSet(int32_t handle,
                     // Couldn't create the task, delete the
                     // mutex
                     uPortMutexDelete(gUartData[handle].eventTaskRunningMutex);
+                    gUartData[handle].eventTaskRunningMutex = NULL;
+                    setLineDetect(handle, 0);
                 }
             }
         }
@@ -582,8 +710,10 @@ int32_t uPortUartEventCallbackFilterSet(int32_t handle,
             !gUartData[handle].markedForDeletion &&
             (gUartData[handle].eventTaskRunningMutex != NULL)  &&
             (filter != 0)) {
-            gUartData[handle].eventFilter = filter;
-            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            errorCode = setLineDetect(handle, filter);
+            if (errorCode == 0) {
+                gUartData[handle].eventFilter = filter;
+            }
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -606,15 +736,21 @@ int32_t uPortUartEventSend(int32_t handle, uint32_t eventBitMap)
         // The eventBitMap needs to be translated into the
         // event types known to the ESP32 platform (not a
         // bitmap unfortunately) as they send to the queue
-        // also.  The only eventBitMap type we support at the
-        // moment is U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED
-        // which translates to UART_DATA.
+        // also: U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED
+        // translates to UART_DATA and
+        // U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED to
+        // UART_PATTERN_DET (popping a position from an
+        // empty pattern queue in the event task is harmless).
         if ((handle >= 0) &&
             (handle < sizeof(gUartData) / sizeof(gUartData[0])) &&
             !gUartData[handle].markedForDeletion &&
             (gUartData[handle].eventTaskRunningMutex != NULL)  &&
-            (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
+            ((eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) ||
+             (eventBitMap == U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED))) {
             event.type = UART_DATA;
+            if (eventBitMap == U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED) {
+                event.type = UART_PATTERN_DET;
+            }
             event.size = 0;
             errorCode = uPortQueueSend((const uPortQueueHandle_t) gUartData[handle].queue,
                                        (void *) &event);
@@ -642,15 +778,21 @@ int32_t uPortUartEventTrySend(int32_t handle, uint32_t eventBitMap,
         // The eventBitMap needs to be translated into the
         // event types known to the ESP32 platform (not a
         // bitmap unfortunately) as they send to the queue
-        // also.  The only eventBitMap type we support at the
-        // moment is U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED
-        // which translates to UART_DATA.
+        // also: U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED
+        // translates to UART_DATA and
+        // U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED to
+        // UART_PATTERN_DET (popping a position from an
+        // empty pattern queue in the event task is harmless).
         if ((handle >= 0) &&
             (handle < sizeof(gUartData) / sizeof(gUartData[0])) &&
             !gUartData[handle].markedForDeletion &&
             (gUartData[handle].eventTaskRunningMutex != NULL)  &&
-            (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
+            ((eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) ||
+             (eventBitMap == U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED))) {
             event.type = UART_DATA;
+            if (eventBitMap == U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED) {
+                event.type = UART_PATTERN_DET;
+            }
             event.size = 0;
             do {
                 // Push an event to event queue, IRQ version so as not to block
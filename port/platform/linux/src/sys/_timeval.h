@@ -0,0 +1,30 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _U_PORT_SYS__TIMEVAL_H_
+#define _U_PORT_SYS__TIMEVAL_H_
+
+/** @file
+ * @brief glibc has no sys/_timeval.h, which is where newlib keeps
+ * struct timeval; bring in the glibc definition instead.
+ */
+
+#include <sys/time.h>
+
+#endif // _U_PORT_SYS__TIMEVAL_H_
+
+// End of file
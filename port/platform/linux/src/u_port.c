@@ -0,0 +1,161 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/** @file
+ * @brief Implementation of generic porting functions for Linux.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "limits.h"    // INT_MAX
+
+#include "time.h"
+
+#include "u_cfg_sw.h"
+#include "u_compiler.h" // For U_INLINE
+#include "u_cfg_hw_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+#include "u_assert.h"
+
+#include "u_port_debug.h"
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_uart.h"
+#include "u_port_private.h"
+#include "u_port_event_queue_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+// Keep track of whether we've been initialised or not.
+static bool gInitialised = false;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start the platform.
+int32_t uPortPlatformStart(void (*pEntryPoint)(void *),
+                           void *pParameter,
+                           size_t stackSizeBytes,
+                           int32_t priority)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    // The entry point is run in the main thread, whose stack
+    // size is set by the shell (ulimit -s), and priorities are
+    // not supported on this platform
+    (void) stackSizeBytes;
+    (void) priority;
+
+    if (pEntryPoint != NULL) {
+        // Add the main thread to the list of tasks so that it
+        // is suspended by critical sections like any other
+        errorCode = uPortPrivateTaskAddThis();
+        if (errorCode == 0) {
+            pEntryPoint(pParameter);
+            uPortPrivateTaskRemoveThis();
+        }
+    }
+
+    return errorCode;
+}
+
+// Initialise the porting layer.
+int32_t uPortInit()
+{
+    int32_t errorCode = 0;
+
+    if (!gInitialised) {
+        errorCode = uPortPrivateInit();
+        if (errorCode == 0) {
+            errorCode = uPortEventQueuePrivateInit();
+            if (errorCode == 0) {
+                errorCode = uPortUartInit();
+            }
+        }
+        gInitialised = (errorCode == 0);
+    }
+
+    return errorCode;
+}
+
+// Deinitialise the porting layer.
+void uPortDeinit()
+{
+    if (gInitialised) {
+        uPortUartDeinit();
+        uPortEventQueuePrivateDeinit();
+        uPortPrivateDeinit();
+        gInitialised = false;
+    }
+}
+
+// Get the current tick in milliseconds.
+int32_t uPortGetTickTimeMs()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int32_t) ((((int64_t) now.tv_sec * 1000) + (now.tv_nsec / 1000000)) % INT_MAX);
+}
+
+// Get the minimum amount of heap free, ever, in bytes.
+int32_t uPortGetHeapMinFree()
+{
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Get the current free heap.
+int32_t uPortGetHeapFree()
+{
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Enter a critical section.
+int32_t uPortEnterCritical()
+{
+    return uPortPrivateEnterCritical();
+}
+
+// Leave a critical section.
+void uPortExitCritical()
+{
+    U_ASSERT(uPortPrivateExitCritical() == 0);
+}
+
+// End of file
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/** @file
+ * @brief Implementation of the crypto API on Linux, using the
+ * libcrypto library of OpenSSL.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy()
+
+#include "openssl/evp.h"
+#include "openssl/hmac.h"
+#include "openssl/sha.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_crypto.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The AES block size.
+ */
+#define U_PORT_CRYPTO_AES_BLOCK_LENGTH_BYTES 16
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Perform AES CBC encryption or decryption of a block of data,
+// updating the initialisation vector as the other platforms do.
+static int32_t aesCbc(const char *pKey, size_t keyLengthBytes,
+                      char *pInitVector, const char *pInput,
+                      size_t lengthBytes, char *pOutput,
+                      bool encrypt)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const EVP_CIPHER *pCipher = NULL;
+    EVP_CIPHER_CTX *pContext;
+    char nextInitVector[U_PORT_CRYPTO_AES128_INITIALISATION_VECTOR_LENGTH_BYTES];
+    int outputLength = 0;
+
+    switch (keyLengthBytes) {
+        case 16:
+            pCipher = EVP_aes_128_cbc();
+            break;
+        case 24:
+            pCipher = EVP_aes_192_cbc();
+            break;
+        case 32:
+            pCipher = EVP_aes_256_cbc();
+            break;
+        default:
+            break;
+    }
+
+    if ((pCipher != NULL) && (pKey != NULL) && (pInitVector != NULL) &&
+        (pInput != NULL) && (pOutput != NULL) && (lengthBytes > 0) &&
+        ((lengthBytes % U_PORT_CRYPTO_AES_BLOCK_LENGTH_BYTES) == 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if (!encrypt) {
+            // When decrypting the next initialisation vector is
+            // the last block of input, which may be overwritten
+            // if the input and output are the same buffer
+            memcpy(nextInitVector, pInput + lengthBytes - sizeof(nextInitVector),
+                   sizeof(nextInitVector));
+        }
+        pContext = EVP_CIPHER_CTX_new();
+        if (pContext != NULL) {
+            if ((EVP_CipherInit_ex(pContext, pCipher, NULL,
+                                   (const unsigned char *) pKey,
+                                   (const unsigned char *) pInitVector,
+                                   encrypt ? 1 : 0) == 1) &&
+                // No padding: the length is a multiple of the block size
+                (EVP_CIPHER_CTX_set_padding(pContext, 0) == 1) &&
+                (EVP_CipherUpdate(pContext, (unsigned char *) pOutput, &outputLength,
+                                  (const unsigned char *) pInput, (int) lengthBytes) == 1) &&
+                (outputLength == (int) lengthBytes)) {
+                if (encrypt) {
+                    // When encrypting the next initialisation vector
+                    // is the last block of output
+                    memcpy(nextInitVector, pOutput + lengthBytes - sizeof(nextInitVector),
+                           sizeof(nextInitVector));
+                }
+                memcpy(pInitVector, nextInitVector, sizeof(nextInitVector));
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+            EVP_CIPHER_CTX_free(pContext);
+        }
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Perform a SHA256 calculation on a block of data.
+int32_t uPortCryptoSha256(const char *pInput,
+                          size_t inputLengthBytes,
+                          char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    unsigned int outputLength = 0;
+
+    if (((pInput != NULL) || (inputLengthBytes == 0)) && (pOutput != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if ((EVP_Digest(pInput, inputLengthBytes, (unsigned char *) pOutput,
+                        &outputLength, EVP_sha256(), NULL) == 1) &&
+            (outputLength == U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Start a SHA256 calculation.
+int32_t uPortCryptoSha256Start(void **ppContext)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    EVP_MD_CTX *pContext;
+
+    if (ppContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        pContext = EVP_MD_CTX_new();
+        if (pContext != NULL) {
+            if (EVP_DigestInit_ex(pContext, EVP_sha256(), NULL) == 1) {
+                *ppContext = pContext;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            } else {
+                EVP_MD_CTX_free(pContext);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Add data to a SHA256 calculation.
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && ((pInput != NULL) || (inputLengthBytes == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if (EVP_DigestUpdate((EVP_MD_CTX *) pContext, pInput,
+                             inputLengthBytes) == 1) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Complete a SHA256 calculation.
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    unsigned int outputLength = 0;
+
+    if (pContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pOutput != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            if ((EVP_DigestFinal_ex((EVP_MD_CTX *) pContext,
+                                    (unsigned char *) pOutput,
+                                    &outputLength) == 1) &&
+                (outputLength == U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES)) {
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+        EVP_MD_CTX_free((EVP_MD_CTX *) pContext);
+    }
+
+    return errorCode;
+}
+
+// Perform a HMAC SHA256 calculation on a block of data.
+int32_t uPortCryptoHmacSha256(const char *pKey,
+                              size_t keyLengthBytes,
+                              const char *pInput,
+                              size_t inputLengthBytes,
+                              char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    unsigned int outputLength = 0;
+
+    if ((pKey != NULL) && ((pInput != NULL) || (inputLengthBytes == 0)) &&
+        (pOutput != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if ((HMAC(EVP_sha256(), pKey, (int) keyLengthBytes,
+                  (const unsigned char *) pInput, inputLengthBytes,
+                  (unsigned char *) pOutput, &outputLength) != NULL) &&
+            (outputLength == U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Perform AES 128 CBC encryption of a block of data.
+int32_t uPortCryptoAes128CbcEncrypt(const char *pKey,
+                                    size_t keyLengthBytes,
+                                    char *pInitVector,
+                                    const char *pInput,
+                                    size_t lengthBytes,
+                                    char *pOutput)
+{
+    return aesCbc(pKey, keyLengthBytes, pInitVector,
+                  pInput, lengthBytes, pOutput, true);
+}
+
+// Perform AES 128 CBC decryption of a block of data.
+int32_t uPortCryptoAes128CbcDecrypt(const char *pKey,
+                                    size_t keyLengthBytes,
+                                    char *pInitVector,
+                                    const char *pInput,
+                                    size_t lengthBytes,
+                                    char *pOutput)
+{
+    return aesCbc(pKey, keyLengthBytes, pInitVector,
+                  pInput, lengthBytes, pOutput, false);
+}
+
+// End of file
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Implementation of the port debug API on Linux.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+#include "stdio.h"
+#include "stdarg.h"
+#include "stdint.h"
+#include "stdbool.h"
+#include "time.h"
+#include "unistd.h"      // syscall()
+#include "sys/syscall.h" // SYS_gettid
+#include "pthread.h"
+
+#include "u_error_common.h"
+
+#include "u_port_debug.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Keep track of whether logging is on or off.
+ */
+static bool gPortLogOn = true;
+
+/** Only used for detecting inactivity
+ */
+volatile int32_t gStdoutCounter;
+
+/** Mutex protecting the span trace file.
+ */
+static pthread_mutex_t gSpanMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** The span trace file, NULL if there isn't one open.
+ */
+static FILE *gpSpanFile = NULL;
+
+/** The time at which the span trace file was opened, microseconds.
+ */
+static uint64_t gSpanStartTimeUs = 0;
+
+/** The number of events written to the span trace file.
+ */
+static uint32_t gSpanNumEvents = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Get the monotonic time in microseconds.
+static uint64_t timeUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+}
+
+// Write the name of a span to the span trace file as a JSON
+// string, escaping anything that JSON would not allow as-is.
+static void spanWriteName(const char *pName)
+{
+    fprintf(gpSpanFile, ",\"name\":\"");
+    for (; *pName != 0; pName++) {
+        if ((*pName == '"') || (*pName == '\\')) {
+            fprintf(gpSpanFile, "\\%c", *pName);
+        } else if ((uint8_t) *pName < 0x20) {
+            fprintf(gpSpanFile, "\\u%04x", (uint8_t) *pName);
+        } else {
+            fputc(*pName, gpSpanFile);
+        }
+    }
+    fputc('"', gpSpanFile);
+}
+
+// Write a span event, phase 'B' or 'E', to the span trace file.
+static void spanWrite(char phase, const char *pName)
+{
+    uint64_t nowUs = timeUs();
+
+    pthread_mutex_lock(&gSpanMutex);
+    if (gpSpanFile != NULL) {
+        fprintf(gpSpanFile, "%s{\"ph\":\"%c\",\"ts\":%llu,\"pid\":%d,\"tid\":%ld",
+                gSpanNumEvents > 0 ? ",\n" : "", phase,
+                (unsigned long long) (nowUs - gSpanStartTimeUs),
+                (int) getpid(), (long) syscall(SYS_gettid));
+        if (pName != NULL) {
+            spanWriteName(pName);
+        }
+        fprintf(gpSpanFile, "}");
+        gSpanNumEvents++;
+    }
+    pthread_mutex_unlock(&gSpanMutex);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// printf()-style logging.
+void uPortLogF(const char *pFormat, ...)
+{
+    va_list args;
+
+    if (gPortLogOn) {
+        va_start(args, pFormat);
+        vprintf(pFormat, args);
+        va_end(args);
+
+        fflush(stdout);
+    }
+    gStdoutCounter++;
+}
+
+// Switch logging off.
+int32_t uPortLogOff(void)
+{
+    gPortLogOn = false;
+    return (int32_t) U_ERROR_COMMON_SUCCESS;
+}
+
+// Switch logging on.
+int32_t uPortLogOn(void)
+{
+    gPortLogOn = true;
+    return (int32_t) U_ERROR_COMMON_SUCCESS;
+}
+
+// Get the "cycle" count for the profiling probes: there is no
+// portable way to read a cycle counter from user space so use
+// the monotonic clock in nanoseconds.
+uint32_t uPortProfileCyclesGet(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec);
+}
+
+// Open the span trace file.
+int32_t uPortSpanTraceOpen(const char *pFileName)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pFileName != NULL) {
+        uPortSpanTraceClose();
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        pthread_mutex_lock(&gSpanMutex);
+        gpSpanFile = fopen(pFileName, "w");
+        if (gpSpanFile != NULL) {
+            gSpanStartTimeUs = timeUs();
+            gSpanNumEvents = 0;
+            fprintf(gpSpanFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+        pthread_mutex_unlock(&gSpanMutex);
+    }
+
+    return errorCode;
+}
+
+// Close the span trace file.
+void uPortSpanTraceClose(void)
+{
+    pthread_mutex_lock(&gSpanMutex);
+    if (gpSpanFile != NULL) {
+        fprintf(gpSpanFile, "\n]}\n");
+        fclose(gpSpanFile);
+        gpSpanFile = NULL;
+    }
+    pthread_mutex_unlock(&gSpanMutex);
+}
+
+// Begin a timed span.
+void uPortSpanBegin(const char *pName)
+{
+    spanWrite('B', pName);
+}
+
+// End a timed span.
+void uPortSpanEnd(void)
+{
+    spanWrite('E', NULL);
+}
+
+// End of file
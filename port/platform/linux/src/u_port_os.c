@@ -0,0 +1,794 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/** @file
+ * @brief Implementation of the port OS API for Linux.
+ *
+ * Implementation note 1: tasks are POSIX threads; the task handle is
+ * the pthread_t of the thread.  Thread priorities are not available
+ * under the default Linux scheduling policy without privileges and
+ * hence the priority passed to uPortTaskCreate() is range-checked
+ * but otherwise ignored.
+ * Implementation note 2: POSIX message queues cannot be peeked and
+ * need a file descriptor each, hence queues are implemented here as
+ * a ring buffer protected by a mutex and two conditions.
+ * Implementation note 3: mutexes are default, i.e. non-recursive,
+ * pthread mutexes, which is what the rest of ubxlib expects (and
+ * tests for).
+ * Implementation note 4: there are no interrupts on Linux so the
+ * "Irq" versions of the functions here are simply the non-blocking
+ * versions of the normal ones.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+/* The remaining include files come after the mutex debug macros. */
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS FOR MUTEX DEBUG
+ * -------------------------------------------------------------- */
+
+#ifdef U_CFG_MUTEX_DEBUG
+/** If we're adding the mutex debug intermediate functions to
+ * the build then the implementations of the mutex functions
+ * here get an underscore before them
+ */
+# define MAKE_MTX_FN(x, ...) _ ## x ##__VA_ARGS__
+#else
+/** The normal case: a mutex function is not fiddled with.
+ */
+# define MAKE_MTX_FN(x, ...) x ##__VA_ARGS__
+#endif
+
+/** This macro, working in conjunction with the MAKE_MTX_FN()
+ * macro above, should wrap all of the uPortOsMutex* functions
+ * in this file.  The functions are then pre-fixed with an
+ * underscore if U_CFG_MUTEX_DEBUG is defined, allowing the
+ * intermediate mutex macros/functions over in u_mutex_debug.c
+ * to take their place.  Those functions subsequently call
+ * back into the "underscore versions" of the uPortOsMutex*
+ * functions here.
+ */
+#define MTX_FN(x, ...) MAKE_MTX_FN(x ##__VA_ARGS__)
+
+// Now undef U_CFG_MUTEX_DEBUG so that this file is not polluted
+// by the u_mutex_debug.h stuff brought in through u_port_os.h.
+#undef U_CFG_MUTEX_DEBUG
+
+/* ----------------------------------------------------------------
+ * INCLUDE FILES
+ * -------------------------------------------------------------- */
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy(), strchr(), strrchr()
+#include "stdio.h"     // fopen(), snprintf(), sscanf()
+#include "errno.h"
+#include "dirent.h"    // opendir(), readdir()
+
+#include "time.h"
+#include "signal.h"
+#include "sched.h"     // sched_yield()
+#include "pthread.h"
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_debug.h"
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A queue.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t condNotEmpty;
+    pthread_cond_t condNotFull;
+    size_t itemSizeBytes;
+    size_t queueLength;
+    size_t numItems;
+    size_t readIndex;
+    char *pBuffer;
+} uPortOsQueue_t;
+
+/** A semaphore.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t count;
+    uint32_t limit;
+} uPortOsSemaphore_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Clean-up handler, should a task be cancelled while waiting
+// on a condition, which leaves the mutex locked.
+static void mutexUnlockCleanUp(void *pMutex)
+{
+    pthread_mutex_unlock((pthread_mutex_t *) pMutex);
+}
+
+// Wait on a condition, for ever if waitMs is negative, else
+// until the given absolute time; returns zero on success.
+static int condWait(pthread_cond_t *pCond, pthread_mutex_t *pMutex,
+                    int32_t waitMs, const struct timespec *pUntil)
+{
+    int result;
+
+    pthread_cleanup_push(mutexUnlockCleanUp, pMutex);
+    if (waitMs < 0) {
+        result = pthread_cond_wait(pCond, pMutex);
+    } else {
+        result = pthread_cond_timedwait(pCond, pMutex, pUntil);
+    }
+    pthread_cleanup_pop(0);
+
+    return result;
+}
+
+// Send to a queue, waiting up to waitMs (forever if negative).
+static int32_t queueSend(const uPortQueueHandle_t queueHandle,
+                         const void *pEventData, int32_t waitMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsQueue_t *pQueue = (uPortOsQueue_t *) queueHandle;
+    struct timespec until;
+    size_t writeIndex;
+
+    if ((pQueue != NULL) && (pEventData != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        uPortPrivateTimeGet(&until, waitMs, CLOCK_REALTIME);
+        pthread_mutex_lock(&(pQueue->mutex));
+        while ((pQueue->numItems >= pQueue->queueLength) && (waitMs != 0) &&
+               (condWait(&(pQueue->condNotFull), &(pQueue->mutex), waitMs, &until) == 0)) {}
+        if (pQueue->numItems < pQueue->queueLength) {
+            writeIndex = (pQueue->readIndex + pQueue->numItems) % pQueue->queueLength;
+            memcpy(pQueue->pBuffer + (writeIndex * pQueue->itemSizeBytes),
+                   pEventData, pQueue->itemSizeBytes);
+            pQueue->numItems++;
+            pthread_cond_signal(&(pQueue->condNotEmpty));
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+        pthread_mutex_unlock(&(pQueue->mutex));
+    }
+
+    return errorCode;
+}
+
+// Receive from a queue, waiting up to waitMs (forever if negative),
+// optionally leaving the item on the queue.
+static int32_t queueReceive(const uPortQueueHandle_t queueHandle,
+                            void *pEventData, int32_t waitMs, bool peek)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsQueue_t *pQueue = (uPortOsQueue_t *) queueHandle;
+    struct timespec until;
+
+    if ((pQueue != NULL) && (pEventData != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        uPortPrivateTimeGet(&until, waitMs, CLOCK_REALTIME);
+        pthread_mutex_lock(&(pQueue->mutex));
+        while ((pQueue->numItems == 0) && (waitMs != 0) &&
+               (condWait(&(pQueue->condNotEmpty), &(pQueue->mutex), waitMs, &until) == 0)) {}
+        if (pQueue->numItems > 0) {
+            memcpy(pEventData, pQueue->pBuffer + (pQueue->readIndex * pQueue->itemSizeBytes),
+                   pQueue->itemSizeBytes);
+            if (!peek) {
+                pQueue->readIndex = (pQueue->readIndex + 1) % pQueue->queueLength;
+                pQueue->numItems--;
+                pthread_cond_signal(&(pQueue->condNotFull));
+            }
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+        pthread_mutex_unlock(&(pQueue->mutex));
+    }
+
+    return errorCode;
+}
+
+// Take a semaphore, waiting up to waitMs (forever if negative).
+static int32_t semaphoreTake(const uPortSemaphoreHandle_t semaphoreHandle,
+                             int32_t waitMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsSemaphore_t *pSemaphore = (uPortOsSemaphore_t *) semaphoreHandle;
+    struct timespec until;
+
+    if (pSemaphore != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        uPortPrivateTimeGet(&until, waitMs, CLOCK_REALTIME);
+        pthread_mutex_lock(&(pSemaphore->mutex));
+        while ((pSemaphore->count == 0) && (waitMs != 0) &&
+               (condWait(&(pSemaphore->cond), &(pSemaphore->mutex), waitMs, &until) == 0)) {}
+        if (pSemaphore->count > 0) {
+            pSemaphore->count--;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+        pthread_mutex_unlock(&(pSemaphore->mutex));
+    }
+
+    return errorCode;
+}
+
+// Read the name and CPU time, user plus system, in clock ticks,
+// of the thread that has the given ID in this process from
+// /proc/self/task/<tid>/stat, returning true on success.
+static bool threadStatRead(const char *pTid, char *pName, size_t nameSize,
+                           uint64_t *pTicks)
+{
+    bool success = false;
+    char buffer[512];
+    FILE *pFile;
+    char *pStart;
+    char *pEnd;
+    unsigned long long userTicks;
+    unsigned long long systemTicks;
+    size_t length;
+
+    snprintf(buffer, sizeof(buffer), "/proc/self/task/%s/stat", pTid);
+    pFile = fopen(buffer, "r");
+    if (pFile != NULL) {
+        if (fgets(buffer, sizeof(buffer), pFile) != NULL) {
+            // The name is in brackets and may itself contain
+            // brackets or spaces, hence the first and last
+            pStart = strchr(buffer, '(');
+            pEnd = strrchr(buffer, ')');
+            if ((pStart != NULL) && (pEnd != NULL) && (pEnd > pStart)) {
+                pStart++;
+                length = pEnd - pStart;
+                if (length >= nameSize) {
+                    length = nameSize - 1;
+                }
+                memcpy(pName, pStart, length);
+                pName[length] = 0;
+                // After the name come the state, then 10 fields
+                // we don't need, then the user and system times
+                success = (sscanf(pEnd + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                                  &userTicks, &systemTicks) == 2);
+                if (success) {
+                    *pTicks = userTicks + systemTicks;
+                }
+            }
+        }
+        fclose(pFile);
+    }
+
+    return success;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TASKS
+ * -------------------------------------------------------------- */
+
+// Create a task.
+int32_t uPortTaskCreate(void (*pFunction)(void *),
+                        const char *pName,
+                        size_t stackSizeBytes,
+                        void *pParameter,
+                        int32_t priority,
+                        uPortTaskHandle_t *pTaskHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pFunction != NULL) && (pTaskHandle != NULL) &&
+        (priority >= U_CFG_OS_PRIORITY_MIN) &&
+        (priority <= U_CFG_OS_PRIORITY_MAX)) {
+        errorCode = uPortPrivateTaskCreate(pFunction, pName,
+                                           stackSizeBytes,
+                                           pParameter,
+                                           pTaskHandle);
+        if (errorCode == 0) {
+            U_PORT_TASK_STACK_REGISTER(*pTaskHandle, pName, stackSizeBytes);
+        }
+    }
+
+    return errorCode;
+}
+
+// Delete the given task.
+int32_t uPortTaskDelete(const uPortTaskHandle_t taskHandle)
+{
+    U_PORT_TASK_STACK_DEREGISTER(taskHandle);
+    return uPortPrivateTaskDelete(taskHandle);
+}
+
+// Check if the current task handle is equal to the given task handle.
+bool uPortTaskIsThis(const uPortTaskHandle_t taskHandle)
+{
+    return (taskHandle != NULL) &&
+           pthread_equal(pthread_self(), (pthread_t) taskHandle);
+}
+
+// Block the current task for a time.
+void uPortTaskBlock(int32_t delayMs)
+{
+    struct timespec until;
+
+    if (delayMs > 0) {
+        uPortPrivateTimeGet(&until, delayMs, CLOCK_MONOTONIC);
+        // Go back to sleep if woken early by a signal, e.g.
+        // because of a critical section
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {}
+    } else {
+        // Still a scheduling point
+        sched_yield();
+    }
+}
+
+// Get the minimum free stack for a given task.
+int32_t uPortTaskStackMinFree(const uPortTaskHandle_t taskHandle)
+{
+    (void) taskHandle;
+    // Not available for a POSIX thread and, with stack sizes of
+    // hundreds of kbytes, makes little sense on Linux anyway
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Get the current task handle.
+int32_t uPortTaskGetHandle(uPortTaskHandle_t *pTaskHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pTaskHandle != NULL) {
+        *pTaskHandle = (uPortTaskHandle_t) pthread_self();
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Get the run-time statistics of all tasks.
+int32_t uPortTaskGetRuntimeStats(uPortTaskRuntimeStats_t *pStats,
+                                 size_t maxNumStats,
+                                 int32_t *pIdlePercent)
+{
+    int32_t errorCodeOrNumStats = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    DIR *pDir;
+    struct dirent *pEntry;
+    uPortTaskRuntimeStats_t stats;
+    uint64_t totalTicks = 0;
+    size_t numStats = 0;
+
+    if ((pStats != NULL) || (maxNumStats == 0)) {
+        errorCodeOrNumStats = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        // Each thread of this process has an entry in /proc/self/task;
+        // there is no way to get the pthread_t of a thread from
+        // there, hence the task handle is left as NULL
+        pDir = opendir("/proc/self/task");
+        if (pDir != NULL) {
+            while ((pEntry = readdir(pDir)) != NULL) {
+                if ((pEntry->d_name[0] != '.') &&
+                    threadStatRead(pEntry->d_name, stats.name, sizeof(stats.name),
+                                   &(stats.runtimeTicks))) {
+                    totalTicks += stats.runtimeTicks;
+                    if (numStats < maxNumStats) {
+                        stats.taskHandle = NULL;
+                        stats.isIdle = false;
+                        pStats[numStats] = stats;
+                        numStats++;
+                    }
+                }
+            }
+            closedir(pDir);
+            for (size_t x = 0; x < numStats; x++) {
+                pStats[x].percent = 0;
+                if (totalTicks > 0) {
+                    pStats[x].percent = (int32_t) ((pStats[x].runtimeTicks * 100) / totalTicks);
+                }
+            }
+            if (pIdlePercent != NULL) {
+                // The idle time of Linux belongs to no thread of ours
+                *pIdlePercent = -1;
+            }
+            errorCodeOrNumStats = (int32_t) numStats;
+        }
+    }
+
+    return errorCodeOrNumStats;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: QUEUES
+ * -------------------------------------------------------------- */
+
+// Create a queue.
+int32_t uPortQueueCreate(size_t queueLength,
+                         size_t itemSizeBytes,
+                         uPortQueueHandle_t *pQueueHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsQueue_t *pQueue;
+
+    if ((pQueueHandle != NULL) && (queueLength > 0) && (itemSizeBytes > 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pQueue = (uPortOsQueue_t *) malloc(sizeof(*pQueue));
+        if (pQueue != NULL) {
+            memset(pQueue, 0, sizeof(*pQueue));
+            pQueue->pBuffer = (char *) malloc(queueLength * itemSizeBytes);
+            if (pQueue->pBuffer != NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+                pQueue->itemSizeBytes = itemSizeBytes;
+                pQueue->queueLength = queueLength;
+                if (pthread_mutex_init(&(pQueue->mutex), NULL) == 0) {
+                    if (pthread_cond_init(&(pQueue->condNotEmpty), NULL) == 0) {
+                        if (pthread_cond_init(&(pQueue->condNotFull), NULL) == 0) {
+                            *pQueueHandle = (uPortQueueHandle_t) pQueue;
+                            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        } else {
+                            pthread_cond_destroy(&(pQueue->condNotEmpty));
+                        }
+                    }
+                    if (errorCode != 0) {
+                        pthread_mutex_destroy(&(pQueue->mutex));
+                    }
+                }
+                if (errorCode != 0) {
+                    free(pQueue->pBuffer);
+                }
+            }
+            if (errorCode != 0) {
+                free(pQueue);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Delete the given queue.
+int32_t uPortQueueDelete(const uPortQueueHandle_t queueHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsQueue_t *pQueue = (uPortOsQueue_t *) queueHandle;
+
+    if (pQueue != NULL) {
+        pthread_cond_destroy(&(pQueue->condNotFull));
+        pthread_cond_destroy(&(pQueue->condNotEmpty));
+        pthread_mutex_destroy(&(pQueue->mutex));
+        free(pQueue->pBuffer);
+        free(pQueue);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Send to the given queue.
+int32_t uPortQueueSend(const uPortQueueHandle_t queueHandle,
+                       const void *pEventData)
+{
+    return queueSend(queueHandle, pEventData, -1);
+}
+
+// Send to the given queue from an interrupt: there are no
+// interrupts on Linux and, since task priorities are not applied,
+// a non-blocking send may not be drained in time, hence this is
+// not supported, as on Windows.
+int32_t uPortQueueSendIrq(const uPortQueueHandle_t queueHandle,
+                          const void *pEventData)
+{
+    (void) queueHandle;
+    (void) pEventData;
+
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Receive from the given queue, blocking.
+int32_t uPortQueueReceive(const uPortQueueHandle_t queueHandle,
+                          void *pEventData)
+{
+    return queueReceive(queueHandle, pEventData, -1, false);
+}
+
+// Receive from the given queue, non-blocking.
+int32_t uPortQueueReceiveIrq(const uPortQueueHandle_t queueHandle,
+                             void *pEventData)
+{
+    return queueReceive(queueHandle, pEventData, 0, false);
+}
+
+// Receive from the given queue, with a wait time.
+int32_t uPortQueueTryReceive(const uPortQueueHandle_t queueHandle,
+                             int32_t waitMs, void *pEventData)
+{
+    if (waitMs < 0) {
+        waitMs = 0;
+    }
+    return queueReceive(queueHandle, pEventData, waitMs, false);
+}
+
+// Peek the given queue.
+int32_t uPortQueuePeek(const uPortQueueHandle_t queueHandle,
+                       void *pEventData)
+{
+    return queueReceive(queueHandle, pEventData, 0, true);
+}
+
+// Get the number of free spaces in the given queue.
+int32_t uPortQueueGetFree(const uPortQueueHandle_t queueHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsQueue_t *pQueue = (uPortOsQueue_t *) queueHandle;
+
+    if (pQueue != NULL) {
+        pthread_mutex_lock(&(pQueue->mutex));
+        errorCode = (int32_t) (pQueue->queueLength - pQueue->numItems);
+        pthread_mutex_unlock(&(pQueue->mutex));
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: MUTEXES
+ * -------------------------------------------------------------- */
+
+// Create a mutex.
+int32_t MTX_FN(uPortMutexCreate(uPortMutexHandle_t *pMutexHandle))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    pthread_mutex_t *pMutex;
+
+    if (pMutexHandle != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pMutex = (pthread_mutex_t *) malloc(sizeof(*pMutex));
+        if (pMutex != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            if (pthread_mutex_init(pMutex, NULL) == 0) {
+                *pMutexHandle = (uPortMutexHandle_t) pMutex;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            } else {
+                free(pMutex);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Destroy a mutex.
+int32_t MTX_FN(uPortMutexDelete(const uPortMutexHandle_t mutexHandle))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (mutexHandle != NULL) {
+        pthread_mutex_destroy((pthread_mutex_t *) mutexHandle);
+        free(mutexHandle);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Lock the given mutex.
+int32_t MTX_FN(uPortMutexLock(const uPortMutexHandle_t mutexHandle))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (mutexHandle != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if (pthread_mutex_lock((pthread_mutex_t *) mutexHandle) == 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Try to lock the given mutex.
+int32_t MTX_FN(uPortMutexTryLock(const uPortMutexHandle_t mutexHandle,
+                                 int32_t delayMs))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    struct timespec until;
+    int result;
+
+    if (mutexHandle != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if (delayMs > 0) {
+            uPortPrivateTimeGet(&until, delayMs, CLOCK_REALTIME);
+            result = pthread_mutex_timedlock((pthread_mutex_t *) mutexHandle, &until);
+        } else {
+            result = pthread_mutex_trylock((pthread_mutex_t *) mutexHandle);
+        }
+        if (result == 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        } else if ((result == ETIMEDOUT) || (result == EBUSY)) {
+            errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        }
+    }
+
+    return errorCode;
+}
+
+// Unlock the given mutex.
+int32_t MTX_FN(uPortMutexUnlock(const uPortMutexHandle_t mutexHandle))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (mutexHandle != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if (pthread_mutex_unlock((pthread_mutex_t *) mutexHandle) == 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: SEMAPHORES
+ * -------------------------------------------------------------- */
+
+// Create a semaphore.
+int32_t uPortSemaphoreCreate(uPortSemaphoreHandle_t *pSemaphoreHandle,
+                             uint32_t initialCount,
+                             uint32_t limit)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsSemaphore_t *pSemaphore;
+
+    if ((pSemaphoreHandle != NULL) && (limit != 0) && (initialCount <= limit)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pSemaphore = (uPortOsSemaphore_t *) malloc(sizeof(*pSemaphore));
+        if (pSemaphore != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            pSemaphore->count = initialCount;
+            pSemaphore->limit = limit;
+            if (pthread_mutex_init(&(pSemaphore->mutex), NULL) == 0) {
+                if (pthread_cond_init(&(pSemaphore->cond), NULL) == 0) {
+                    *pSemaphoreHandle = (uPortSemaphoreHandle_t) pSemaphore;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                } else {
+                    pthread_mutex_destroy(&(pSemaphore->mutex));
+                }
+            }
+            if (errorCode != 0) {
+                free(pSemaphore);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Destroy a semaphore.
+int32_t uPortSemaphoreDelete(const uPortSemaphoreHandle_t semaphoreHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsSemaphore_t *pSemaphore = (uPortOsSemaphore_t *) semaphoreHandle;
+
+    if (pSemaphore != NULL) {
+        pthread_cond_destroy(&(pSemaphore->cond));
+        pthread_mutex_destroy(&(pSemaphore->mutex));
+        free(pSemaphore);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Take the given semaphore.
+int32_t uPortSemaphoreTake(const uPortSemaphoreHandle_t semaphoreHandle)
+{
+    return semaphoreTake(semaphoreHandle, -1);
+}
+
+// Try to take the given semaphore.
+int32_t uPortSemaphoreTryTake(const uPortSemaphoreHandle_t semaphoreHandle,
+                              int32_t delayMs)
+{
+    if (delayMs < 0) {
+        delayMs = 0;
+    }
+    return semaphoreTake(semaphoreHandle, delayMs);
+}
+
+// Give the semaphore.
+int32_t uPortSemaphoreGive(const uPortSemaphoreHandle_t semaphoreHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortOsSemaphore_t *pSemaphore = (uPortOsSemaphore_t *) semaphoreHandle;
+
+    if (pSemaphore != NULL) {
+        pthread_mutex_lock(&(pSemaphore->mutex));
+        // Giving too many times is not an error
+        if (pSemaphore->count < pSemaphore->limit) {
+            pSemaphore->count++;
+            pthread_cond_signal(&(pSemaphore->cond));
+        }
+        pthread_mutex_unlock(&(pSemaphore->mutex));
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Give the semaphore from interrupt; there are no interrupts
+// on Linux so this is the same as uPortSemaphoreGive().
+int32_t uPortSemaphoreGiveIrq(const uPortSemaphoreHandle_t semaphoreHandle)
+{
+    return uPortSemaphoreGive(semaphoreHandle);
+}
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: TIMERS
+ * -------------------------------------------------------------- */
+
+// Create a timer.
+int32_t uPortTimerCreate(uPortTimerHandle_t *pTimerHandle,
+                         const char *pName,
+                         pTimerCallback_t *pCallback,
+                         void *pCallbackParam,
+                         uint32_t intervalMs,
+                         bool periodic)
+{
+    return uPortPrivateTimerCreate(pTimerHandle,
+                                   pName, pCallback,
+                                   pCallbackParam,
+                                   intervalMs,
+                                   periodic);
+}
+
+// Destroy a timer.
+int32_t uPortTimerDelete(const uPortTimerHandle_t timerHandle)
+{
+    return uPortPrivateTimerDelete(timerHandle);
+}
+
+// Start a timer.
+int32_t uPortTimerStart(const uPortTimerHandle_t timerHandle)
+{
+    return uPortPrivateTimerStart(timerHandle);
+}
+
+// Stop a timer.
+int32_t uPortTimerStop(const uPortTimerHandle_t timerHandle)
+{
+    return uPortPrivateTimerStop(timerHandle);
+}
+
+// Change a timer interval.
+int32_t uPortTimerChange(const uPortTimerHandle_t timerHandle,
+                         uint32_t intervalMs)
+{
+    return uPortPrivateTimerChange(timerHandle, intervalMs);
+}
+
+// End of file
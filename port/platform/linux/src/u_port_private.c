@@ -0,0 +1,852 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/** @file
+ * @brief Stuff private to the Linux porting layer.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#ifndef _GNU_SOURCE
+/** Needed for pthread_setname_np().
+ */
+# define _GNU_SOURCE
+#endif
+
+#include "stdlib.h"    // For malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdio.h"     // snprintf()
+#include "string.h"    // memset()
+#include "errno.h"
+
+#include "time.h"
+#include "signal.h"
+#include "pthread.h"
+#include "semaphore.h"
+#include "unistd.h"    // sysconf()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_error_common.h"
+#include "u_assert.h"
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+#include "u_port_private.h"
+
+#ifdef U_CFG_MUTEX_DEBUG
+/** Grab the handle of the mutex watchdog task; this is so
+ * that, on Linux, when we simulate a critical section, we can
+ * leave it running to catch situations where we might end up
+ * sitting in a critical section for _far_ longer than we should.
+ */
+extern uPortTaskHandle_t gMutexDebugWatchdogTaskHandle;
+#else
+uPortTaskHandle_t gMutexDebugWatchdogTaskHandle = NULL;
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The maximum length of a thread name on Linux, including the
+ * terminator.
+ */
+#define U_PORT_PRIVATE_TASK_NAME_MAX_LENGTH_BYTES 16
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A task in the list of tasks.
+ */
+typedef struct {
+    bool inUse;
+    bool suspended;
+    pthread_t thread;
+} uPortPrivateTask_t;
+
+/** What a newly created task is given to start itself with.
+ */
+typedef struct {
+    void (*pFunction)(void *);
+    void *pParameter;
+} uPortPrivateTaskStart_t;
+
+/** Type to hold timer information.
+ */
+typedef struct uPortPrivateTimer_t {
+    pTimerCallback_t *pCallback;
+    void *pCallbackParam;
+    uint32_t intervalMs;
+    bool periodic;
+    bool running;
+    struct timespec expiry; /**< on the monotonic clock. */
+    struct uPortPrivateTimer_t *pNext;
+} uPortPrivateTimer_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Keep track of whether we've been initialised or not.
+ */
+static bool gInitialised = false;
+
+/** Mutex to protect the list of tasks; statically initialised
+ * since a task may be created before the porting layer is
+ * initialised, e.g. by the uMutexDebug initialisation code.
+ */
+static pthread_mutex_t gMutexTask = PTHREAD_MUTEX_INITIALIZER;
+
+/** The list of tasks, only needed in order to simulate critical
+ * sections.
+ */
+static uPortPrivateTask_t gTask[U_PORT_MAX_NUM_TASKS] = {0};
+
+/** For debug purposes.
+ */
+static bool gInCriticalSection = false;
+
+/** Set while in a critical section, checked by the suspend
+ * signal handler.
+ */
+static volatile sig_atomic_t gSuspend = 0;
+
+/** Given by each task as it is suspended.
+ */
+static sem_t gSemaphoreSuspended;
+
+/** Given by each task as it is resumed.
+ */
+static sem_t gSemaphoreResumed;
+
+/** Mutex to protect the linked list of timers.
+ */
+static pthread_mutex_t gMutexTimer = PTHREAD_MUTEX_INITIALIZER;
+
+/** Condition, on the monotonic clock, used to wake up the timer
+ * task.
+ */
+static pthread_cond_t gCondTimer;
+
+/** Condition used to signal that a timer callback has returned,
+ * and also that the timer task has exited.
+ */
+static pthread_cond_t gCondTimerDone;
+
+/** A hook for the linked list of timers.
+ */
+static uPortPrivateTimer_t *gpTimerList = NULL;
+
+/** The timer whose callback is currently being called.
+ */
+static uPortPrivateTimer_t *gpTimerInCallback = NULL;
+
+/** The task that runs the timers.
+ */
+static uPortTaskHandle_t gTimerTaskHandle = NULL;
+
+/** Set to get the timer task to exit.
+ */
+static bool gTimerTaskExit = false;
+
+/** True while the timer task is running.
+ */
+static bool gTimerTaskRunning = false;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: TIME
+ * -------------------------------------------------------------- */
+
+// Add a number of milliseconds to a time.
+static void timeAdd(struct timespec *pTime, int64_t ms)
+{
+    pTime->tv_sec += ms / 1000;
+    pTime->tv_nsec += (ms % 1000) * 1000000;
+    if (pTime->tv_nsec >= 1000000000) {
+        pTime->tv_sec++;
+        pTime->tv_nsec -= 1000000000;
+    }
+}
+
+// Return true if time A is before time B.
+static bool timeIsBefore(const struct timespec *pTimeA,
+                         const struct timespec *pTimeB)
+{
+    return (pTimeA->tv_sec < pTimeB->tv_sec) ||
+           ((pTimeA->tv_sec == pTimeB->tv_sec) && (pTimeA->tv_nsec < pTimeB->tv_nsec));
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: TASKS
+ * -------------------------------------------------------------- */
+
+// Find a task in the list; use NULL to find a free entry.
+// gMutexTask should be locked before this is called.
+static uPortPrivateTask_t *pTaskFind(const pthread_t *pThread)
+{
+    uPortPrivateTask_t *pFound = NULL;
+
+    for (size_t x = 0; (pFound == NULL) && (x < sizeof(gTask) / sizeof(gTask[0])); x++) {
+        if (pThread == NULL) {
+            if (!gTask[x].inUse) {
+                pFound = &(gTask[x]);
+            }
+        } else if (gTask[x].inUse && pthread_equal(gTask[x].thread, *pThread)) {
+            pFound = &(gTask[x]);
+        }
+    }
+
+    return pFound;
+}
+
+// Remove the calling task from the list, called as a task exits,
+// whether it returns, deletes itself or is cancelled.
+static void taskCleanUp(void *pParam)
+{
+    (void) pParam;
+    uPortPrivateTaskRemoveThis();
+}
+
+// All tasks start here.
+static void *taskStart(void *pParam)
+{
+    uPortPrivateTaskStart_t start = *((uPortPrivateTaskStart_t *) pParam);
+
+    free(pParam);
+
+    // Wait for the creating task to have added us to the list
+    pthread_mutex_lock(&gMutexTask);
+    pthread_mutex_unlock(&gMutexTask);
+
+    pthread_cleanup_push(taskCleanUp, NULL);
+    start.pFunction(start.pParameter);
+    pthread_cleanup_pop(1);
+
+    return NULL;
+}
+
+// Signal handler that suspends a task until a critical
+// section is over.
+static void signalHandlerSuspend(int signalNumber)
+{
+    int errnoSaved = errno;
+    sigset_t mask;
+
+    (void) signalNumber;
+
+    // Let the task entering the critical section know
+    // that we are suspended
+    sem_post(&gSemaphoreSuspended);
+    // Wait, with everything but the resume signal blocked,
+    // for the critical section to end; the resume signal is
+    // blocked while this handler runs so that it cannot be
+    // lost between checking gSuspend and calling sigsuspend()
+    sigfillset(&mask);
+    sigdelset(&mask, U_PORT_PRIVATE_SIGNAL_RESUME);
+    while (gSuspend) {
+        sigsuspend(&mask);
+    }
+    sem_post(&gSemaphoreResumed);
+
+    errno = errnoSaved;
+}
+
+// Signal handler for the resume signal: all it has to do is
+// exist, so that sigsuspend() returns.
+static void signalHandlerResume(int signalNumber)
+{
+    (void) signalNumber;
+}
+
+// Wait for a semaphore a number of times, ignoring signals.
+static void semaphoreWait(sem_t *pSemaphore, size_t count)
+{
+    for (size_t x = 0; x < count; x++) {
+        while ((sem_wait(pSemaphore) != 0) && (errno == EINTR)) {}
+    }
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: TIMERS
+ * -------------------------------------------------------------- */
+
+// Find a timer in the list.
+// gMutexTimer should be locked before this is called.
+static uPortPrivateTimer_t *pTimerFind(uPortTimerHandle_t handle)
+{
+    uPortPrivateTimer_t *pTimer = gpTimerList;
+
+    while ((pTimer != NULL) && (pTimer != (uPortPrivateTimer_t *) handle)) {
+        pTimer = pTimer->pNext;
+    }
+
+    return pTimer;
+}
+
+// Remove a timer from the list and free it.
+// gMutexTimer should be locked before this is called.
+static void timerRemove(const uPortPrivateTimer_t *pTimerToRemove)
+{
+    uPortPrivateTimer_t **ppTimer = &gpTimerList;
+
+    while ((*ppTimer != NULL) && (*ppTimer != pTimerToRemove)) {
+        ppTimer = &((*ppTimer)->pNext);
+    }
+    if (*ppTimer != NULL) {
+        *ppTimer = (*ppTimer)->pNext;
+        free((void *) pTimerToRemove);
+    }
+}
+
+// Find the running timer that is due to expire first.
+// gMutexTimer should be locked before this is called.
+static uPortPrivateTimer_t *pTimerNext(void)
+{
+    uPortPrivateTimer_t *pNext = NULL;
+
+    for (uPortPrivateTimer_t *pTimer = gpTimerList; pTimer != NULL; pTimer = pTimer->pNext) {
+        if (pTimer->running &&
+            ((pNext == NULL) || timeIsBefore(&(pTimer->expiry), &(pNext->expiry)))) {
+            pNext = pTimer;
+        }
+    }
+
+    return pNext;
+}
+
+// The task that runs all of the timers.
+static void timerTask(void *pParam)
+{
+    uPortPrivateTimer_t *pTimer;
+    pTimerCallback_t *pCallback;
+    void *pCallbackParam;
+    struct timespec now;
+
+    (void) pParam;
+
+    pthread_mutex_lock(&gMutexTimer);
+
+    while (!gTimerTaskExit) {
+        pTimer = pTimerNext();
+        if (pTimer == NULL) {
+            pthread_cond_wait(&gCondTimer, &gMutexTimer);
+        } else {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (timeIsBefore(&now, &(pTimer->expiry))) {
+                pthread_cond_timedwait(&gCondTimer, &gMutexTimer, &(pTimer->expiry));
+            } else {
+                pTimer->running = pTimer->periodic;
+                if (pTimer->periodic) {
+                    // Restart from when it should have expired so
+                    // as not to drift, unless that's already gone
+                    timeAdd(&(pTimer->expiry), pTimer->intervalMs);
+                    if (timeIsBefore(&(pTimer->expiry), &now)) {
+                        pTimer->expiry = now;
+                        timeAdd(&(pTimer->expiry), pTimer->intervalMs);
+                    }
+                }
+                // Call the callback outside the lock so that
+                // it may call back into the timer API
+                gpTimerInCallback = pTimer;
+                pCallback = pTimer->pCallback;
+                pCallbackParam = pTimer->pCallbackParam;
+                pthread_mutex_unlock(&gMutexTimer);
+                if (pCallback != NULL) {
+                    pCallback((uPortTimerHandle_t) pTimer, pCallbackParam);
+                }
+                pthread_mutex_lock(&gMutexTimer);
+                gpTimerInCallback = NULL;
+                pthread_cond_broadcast(&gCondTimerDone);
+            }
+        }
+    }
+
+    gTimerTaskRunning = false;
+    pthread_cond_broadcast(&gCondTimerDone);
+
+    pthread_mutex_unlock(&gMutexTimer);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS SPECIFIC TO THIS PORT: MISC
+ * -------------------------------------------------------------- */
+
+// Initialise the private stuff.
+int32_t uPortPrivateInit(void)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    struct sigaction action;
+    pthread_condattr_t condAttr;
+
+    if (!gInitialised) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        // Set up the signals used to simulate critical sections
+        memset(&action, 0, sizeof(action));
+        sigemptyset(&action.sa_mask);
+        sigaddset(&action.sa_mask, U_PORT_PRIVATE_SIGNAL_RESUME);
+        action.sa_flags = SA_RESTART;
+        action.sa_handler = signalHandlerSuspend;
+        if ((sem_init(&gSemaphoreSuspended, 0, 0) == 0) &&
+            (sem_init(&gSemaphoreResumed, 0, 0) == 0) &&
+            (sigaction(U_PORT_PRIVATE_SIGNAL_SUSPEND, &action, NULL) == 0)) {
+            sigemptyset(&action.sa_mask);
+            action.sa_handler = signalHandlerResume;
+            if ((sigaction(U_PORT_PRIVATE_SIGNAL_RESUME, &action, NULL) == 0) &&
+                (pthread_condattr_init(&condAttr) == 0)) {
+                // The timer condition runs on the monotonic clock
+                // so that it is not affected by changes to the time
+                if ((pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC) == 0) &&
+                    (pthread_cond_init(&gCondTimer, &condAttr) == 0)) {
+                    if (pthread_cond_init(&gCondTimerDone, NULL) == 0) {
+                        // Start the timer task
+                        gTimerTaskExit = false;
+                        gTimerTaskRunning = true;
+                        errorCode = uPortPrivateTaskCreate(timerTask, "timer", 0, NULL,
+                                                           &gTimerTaskHandle);
+                        if (errorCode != 0) {
+                            gTimerTaskRunning = false;
+                            pthread_cond_destroy(&gCondTimerDone);
+                        }
+                    }
+                    if (errorCode != 0) {
+                        pthread_cond_destroy(&gCondTimer);
+                    }
+                }
+                pthread_condattr_destroy(&condAttr);
+            }
+        }
+        if (errorCode == 0) {
+            gInitialised = true;
+        } else {
+            sem_destroy(&gSemaphoreSuspended);
+            sem_destroy(&gSemaphoreResumed);
+        }
+    }
+
+    return errorCode;
+}
+
+// Deinitialise the private stuff.
+void uPortPrivateDeinit(void)
+{
+    if (gInitialised) {
+        pthread_mutex_lock(&gMutexTimer);
+        // Stop the timer task and wait for it to exit
+        gTimerTaskExit = true;
+        pthread_cond_signal(&gCondTimer);
+        while (gTimerTaskRunning) {
+            pthread_cond_wait(&gCondTimerDone, &gMutexTimer);
+        }
+        gTimerTaskHandle = NULL;
+        // Tidy away the timers
+        while (gpTimerList != NULL) {
+            timerRemove(gpTimerList);
+        }
+        pthread_mutex_unlock(&gMutexTimer);
+        pthread_cond_destroy(&gCondTimer);
+        pthread_cond_destroy(&gCondTimerDone);
+
+        // Note: cannot tidy away the tasks here,
+        // we have no idea what state they are in,
+        // that must be up to the user
+        sem_destroy(&gSemaphoreSuspended);
+        sem_destroy(&gSemaphoreResumed);
+        gInitialised = false;
+    }
+}
+
+// Enter a critical section.
+int32_t uPortPrivateEnterCritical(void)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    pthread_t thisThread = pthread_self();
+    pthread_t watchdogThread = (pthread_t) gMutexDebugWatchdogTaskHandle;
+    size_t numSuspended = 0;
+
+    if (gInitialised) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+        pthread_mutex_lock(&gMutexTask);
+
+        U_ASSERT(!gInCriticalSection);
+
+        // Suspend all of the tasks in the list except ourselves
+        gSuspend = 1;
+        for (size_t x = 0; x < sizeof(gTask) / sizeof(gTask[0]); x++) {
+            gTask[x].suspended = false;
+            if (gTask[x].inUse && !pthread_equal(gTask[x].thread, thisThread) &&
+                ((gMutexDebugWatchdogTaskHandle == NULL) ||
+                 !pthread_equal(gTask[x].thread, watchdogThread)) &&
+                (pthread_kill(gTask[x].thread, U_PORT_PRIVATE_SIGNAL_SUSPEND) == 0)) {
+                gTask[x].suspended = true;
+                numSuspended++;
+            }
+        }
+        // Wait for them all to have stopped
+        semaphoreWait(&gSemaphoreSuspended, numSuspended);
+
+        gInCriticalSection = true;
+
+        pthread_mutex_unlock(&gMutexTask);
+    }
+
+    return errorCode;
+}
+
+// Leave a critical section.
+int32_t uPortPrivateExitCritical(void)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    size_t numResumed = 0;
+
+    if (gInitialised) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+        pthread_mutex_lock(&gMutexTask);
+
+        U_ASSERT(gInCriticalSection);
+
+        // Resume all of the suspended tasks
+        gSuspend = 0;
+        for (size_t x = 0; x < sizeof(gTask) / sizeof(gTask[0]); x++) {
+            if (gTask[x].suspended) {
+                pthread_kill(gTask[x].thread, U_PORT_PRIVATE_SIGNAL_RESUME);
+                gTask[x].suspended = false;
+                numResumed++;
+            }
+        }
+        // Wait for them all to have left the signal handler, so
+        // that they are ready to be suspended again
+        semaphoreWait(&gSemaphoreResumed, numResumed);
+
+        gInCriticalSection = false;
+
+        pthread_mutex_unlock(&gMutexTask);
+    }
+
+    return errorCode;
+}
+
+// Get the time a number of milliseconds from now.
+void uPortPrivateTimeGet(struct timespec *pTime, int32_t waitMs,
+                         clockid_t clockId)
+{
+    clock_gettime(clockId, pTime);
+    if (waitMs > 0) {
+        timeAdd(pTime, waitMs);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS SPECIFIC TO THIS PORT: TASKS
+ * -------------------------------------------------------------- */
+
+// Create a task.
+int32_t uPortPrivateTaskCreate(void (*pFunction)(void *),
+                               const char *pName,
+                               size_t stackSizeBytes,
+                               void *pParameter,
+                               uPortTaskHandle_t *pTaskHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    uPortPrivateTask_t *pTask;
+    uPortPrivateTaskStart_t *pStart;
+    pthread_attr_t attr;
+    pthread_t thread;
+    char name[U_PORT_PRIVATE_TASK_NAME_MAX_LENGTH_BYTES];
+    size_t pageSizeBytes = (size_t) sysconf(_SC_PAGESIZE);
+
+    pthread_mutex_lock(&gMutexTask);
+
+    // Find a free entry in the list
+    pTask = pTaskFind(NULL);
+    pStart = (uPortPrivateTaskStart_t *) malloc(sizeof(*pStart));
+    if ((pTask != NULL) && (pStart != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        pStart->pFunction = pFunction;
+        pStart->pParameter = pParameter;
+        if (stackSizeBytes < U_PORT_PRIVATE_TASK_STACK_SIZE_MIN_BYTES) {
+            stackSizeBytes = U_PORT_PRIVATE_TASK_STACK_SIZE_MIN_BYTES;
+        }
+        // Stack size must be a whole number of pages
+        stackSizeBytes = ((stackSizeBytes + pageSizeBytes - 1) / pageSizeBytes) * pageSizeBytes;
+        if (pthread_attr_init(&attr) == 0) {
+            if ((pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) == 0) &&
+                (pthread_attr_setstacksize(&attr, stackSizeBytes) == 0) &&
+                (pthread_create(&thread, &attr, taskStart, pStart) == 0)) {
+                // The task now owns pStart
+                pStart = NULL;
+                pTask->inUse = true;
+                pTask->suspended = false;
+                pTask->thread = thread;
+                if (pName != NULL) {
+                    // Just for debug, doesn't matter if it fails
+                    snprintf(name, sizeof(name), "%s", pName);
+                    pthread_setname_np(thread, name);
+                }
+                *pTaskHandle = (uPortTaskHandle_t) thread;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+            pthread_attr_destroy(&attr);
+        }
+    }
+    free(pStart);
+
+    pthread_mutex_unlock(&gMutexTask);
+
+    return errorCode;
+}
+
+// Delete the given task.
+int32_t uPortPrivateTaskDelete(const uPortTaskHandle_t taskHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    pthread_t thread = (pthread_t) taskHandle;
+    uPortPrivateTask_t *pTask;
+    int result;
+
+    if (taskHandle == NULL) {
+        thread = pthread_self();
+    }
+
+    pthread_mutex_lock(&gMutexTask);
+
+    pTask = pTaskFind(&thread);
+    if (pTask != NULL) {
+        if (taskHandle == NULL) {
+            // Current thread: just exit, unlocking gMutexTask
+            // first; the clean-up function will remove the task
+            // from the list
+            pthread_mutex_unlock(&gMutexTask);
+            pthread_exit(NULL);
+            // CODE EXECUTION NEVER GETS HERE
+        } else {
+            // Another thread: it will go at its next cancellation
+            // point, e.g. when it next blocks; ESRCH means that it
+            // has already gone, which is fine
+            result = pthread_cancel(thread);
+            if ((result == 0) || (result == ESRCH)) {
+                pTask->inUse = false;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&gMutexTask);
+
+    return errorCode;
+}
+
+// Add the calling thread to the list of tasks.
+int32_t uPortPrivateTaskAddThis(void)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    pthread_t thread = pthread_self();
+    uPortPrivateTask_t *pTask;
+
+    pthread_mutex_lock(&gMutexTask);
+
+    pTask = pTaskFind(&thread);
+    if (pTask == NULL) {
+        pTask = pTaskFind(NULL);
+    }
+    if (pTask != NULL) {
+        pTask->inUse = true;
+        pTask->suspended = false;
+        pTask->thread = thread;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    pthread_mutex_unlock(&gMutexTask);
+
+    return errorCode;
+}
+
+// Remove the calling thread from the list of tasks.
+void uPortPrivateTaskRemoveThis(void)
+{
+    pthread_t thread = pthread_self();
+    uPortPrivateTask_t *pTask;
+
+    pthread_mutex_lock(&gMutexTask);
+
+    pTask = pTaskFind(&thread);
+    if (pTask != NULL) {
+        pTask->inUse = false;
+    }
+
+    pthread_mutex_unlock(&gMutexTask);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS SPECIFIC TO THIS PORT: TIMERS
+ * -------------------------------------------------------------- */
+
+// Create a timer.
+int32_t uPortPrivateTimerCreate(uPortTimerHandle_t *pHandle,
+                                const char *pName,
+                                pTimerCallback_t *pCallback,
+                                void *pCallbackParam,
+                                uint32_t intervalMs,
+                                bool periodic)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortPrivateTimer_t *pTimer;
+
+    // Name is not used on this platform
+    (void) pName;
+
+    if (gInitialised) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pHandle != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pTimer = (uPortPrivateTimer_t *) malloc(sizeof(*pTimer));
+            if (pTimer != NULL) {
+                memset(pTimer, 0, sizeof(*pTimer));
+                pTimer->pCallback = pCallback;
+                pTimer->pCallbackParam = pCallbackParam;
+                pTimer->intervalMs = intervalMs;
+                pTimer->periodic = periodic;
+
+                pthread_mutex_lock(&gMutexTimer);
+                pTimer->pNext = gpTimerList;
+                gpTimerList = pTimer;
+                pthread_mutex_unlock(&gMutexTimer);
+
+                *pHandle = (uPortTimerHandle_t) pTimer;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Delete a timer.
+int32_t uPortPrivateTimerDelete(const uPortTimerHandle_t handle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortPrivateTimer_t *pTimer;
+
+    if (gInitialised) {
+
+        pthread_mutex_lock(&gMutexTimer);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pTimer = pTimerFind(handle);
+        if (pTimer != NULL) {
+            pTimer->running = false;
+            // If the callback of this timer is being called by the
+            // timer task, and we're not the timer task, wait for
+            // it to return before freeing the timer
+            while ((gpTimerInCallback == pTimer) && !uPortTaskIsThis(gTimerTaskHandle)) {
+                pthread_cond_wait(&gCondTimerDone, &gMutexTimer);
+            }
+            timerRemove(pTimer);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        pthread_mutex_unlock(&gMutexTimer);
+    }
+
+    return errorCode;
+}
+
+// Start a timer.
+int32_t uPortPrivateTimerStart(const uPortTimerHandle_t handle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortPrivateTimer_t *pTimer;
+
+    if (gInitialised) {
+
+        pthread_mutex_lock(&gMutexTimer);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pTimer = pTimerFind(handle);
+        if (pTimer != NULL) {
+            uPortPrivateTimeGet(&(pTimer->expiry), (int32_t) pTimer->intervalMs,
+                                CLOCK_MONOTONIC);
+            pTimer->running = true;
+            pthread_cond_signal(&gCondTimer);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        pthread_mutex_unlock(&gMutexTimer);
+    }
+
+    return errorCode;
+}
+
+// Stop a timer.
+int32_t uPortPrivateTimerStop(const uPortTimerHandle_t handle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortPrivateTimer_t *pTimer;
+
+    if (gInitialised) {
+
+        pthread_mutex_lock(&gMutexTimer);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pTimer = pTimerFind(handle);
+        if (pTimer != NULL) {
+            pTimer->running = false;
+            pthread_cond_signal(&gCondTimer);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        pthread_mutex_unlock(&gMutexTimer);
+    }
+
+    return errorCode;
+}
+
+// Change a timer interval.
+int32_t uPortPrivateTimerChange(const uPortTimerHandle_t handle,
+                                uint32_t intervalMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortPrivateTimer_t *pTimer;
+
+    if (gInitialised) {
+
+        pthread_mutex_lock(&gMutexTimer);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pTimer = pTimerFind(handle);
+        if (pTimer != NULL) {
+            // As on Windows, a running timer carries on as it
+            // was, the new interval applies from the next start
+            // or, for a periodic timer, the next period
+            pTimer->intervalMs = intervalMs;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        pthread_mutex_unlock(&gMutexTimer);
+    }
+
+    return errorCode;
+}
+
+// End of file
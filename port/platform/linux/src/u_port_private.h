@@ -0,0 +1,219 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _U_PORT_PRIVATE_H_
+#define _U_PORT_PRIVATE_H_
+
+/** @file
+ * @brief Stuff private to the Linux porting layer.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_MAX_NUM_TASKS
+/** The maximum number of tasks that can be created.
+ */
+# define U_PORT_MAX_NUM_TASKS 64
+#endif
+
+#ifndef U_PORT_PRIVATE_TASK_STACK_SIZE_MIN_BYTES
+/** The minimum stack size to give a task: the stack sizes passed
+ * in by ubxlib are sized for an MCU, whereas on Linux the C library
+ * alone can use far more than that, e.g. for a printf(); the memory
+ * is only committed as it is used.
+ */
+# define U_PORT_PRIVATE_TASK_STACK_SIZE_MIN_BYTES (1024 * 256)
+#endif
+
+#ifndef U_PORT_PRIVATE_SIGNAL_SUSPEND
+/** The signal used to suspend the other tasks while in a critical
+ * section, see uPortPrivateEnterCritical().
+ */
+# define U_PORT_PRIVATE_SIGNAL_SUSPEND SIGUSR1
+#endif
+
+#ifndef U_PORT_PRIVATE_SIGNAL_RESUME
+/** The signal used to resume the suspended tasks on leaving a
+ * critical section, see uPortPrivateExitCritical().
+ */
+# define U_PORT_PRIVATE_SIGNAL_RESUME SIGUSR2
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: MISC
+ * -------------------------------------------------------------- */
+
+/** Initialise the private bits of the porting layer.
+ *
+ * @return: zero on success else negative error code.
+ */
+int32_t uPortPrivateInit(void);
+
+/** Deinitialise the private bits of the porting layer.
+ */
+void uPortPrivateDeinit(void);
+
+/** Enter a critical section: Linux has no such thing so all of
+ * the tasks created through this porting layer, other than the
+ * calling one, are suspended, by sending each of them
+ * #U_PORT_PRIVATE_SIGNAL_SUSPEND, until uPortPrivateExitCritical()
+ * is called.
+ *
+ * @return zero on success else negative error code.
+ */
+int32_t uPortPrivateEnterCritical(void);
+
+/** Leave a critical section.
+ *
+ * @return zero on success else negative error code.
+ */
+int32_t uPortPrivateExitCritical(void);
+
+/** Get the absolute time on the monotonic clock a number of
+ * milliseconds from now, for use with the pthread timed-wait
+ * functions.
+ *
+ * @param[out] pTime the place to put the time, cannot be NULL.
+ * @param waitMs     the number of milliseconds from now.
+ * @param clockId    the clock, CLOCK_MONOTONIC or CLOCK_REALTIME.
+ */
+void uPortPrivateTimeGet(struct timespec *pTime, int32_t waitMs,
+                         clockid_t clockId);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: TASKS
+ * -------------------------------------------------------------- */
+
+/** Create and start a task.
+ *
+ * @param pFunction      the function that forms the task.
+ * @param pName          a name for the task, may be NULL.
+ * @param stackSizeBytes the number of bytes of memory to dynamically
+ *                       allocate for stack; at least
+ *                       #U_PORT_PRIVATE_TASK_STACK_SIZE_MIN_BYTES
+ *                       will be used.
+ * @param pParameter     a pointer that will be passed to pFunction
+ *                       when the task is started.
+ *                       The thing at the end of this pointer must be
+ *                       there for the lifetime of the task, it is
+ *                       not copied.  May be NULL.
+ * @param pTaskHandle    a place to put the handle of the created
+ *                       task.
+ * @return               zero on success else negative error code.
+ */
+int32_t uPortPrivateTaskCreate(void (*pFunction)(void *),
+                               const char *pName,
+                               size_t stackSizeBytes,
+                               void *pParameter,
+                               uPortTaskHandle_t *pTaskHandle);
+
+/** Delete the given task.
+ *
+ * @param taskHandle  the handle of the task to be deleted.
+ *                    Use NULL to delete the current task.
+ * @return            zero on success else negative error code.
+ */
+int32_t uPortPrivateTaskDelete(const uPortTaskHandle_t taskHandle);
+
+/** Add the calling thread, which was not created with
+ * uPortPrivateTaskCreate(), e.g. the main thread, to the list
+ * of tasks that a critical section suspends.
+ *
+ * @return zero on success else negative error code.
+ */
+int32_t uPortPrivateTaskAddThis(void);
+
+/** Remove the calling thread from the list of tasks that a
+ * critical section suspends.
+ */
+void uPortPrivateTaskRemoveThis(void);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: TIMERS
+ * -------------------------------------------------------------- */
+
+/** Create a timer; all timers are run from a single timer thread
+ * which calls the timer callbacks.
+ *
+ * @param pHandle         a place to put the timer handle.
+ * @param pName           a name for the timer, used for debug
+ *                        purposes only; should be a null-terminated
+ *                        string, may be NULL.
+ * @param pCallback       the timer callback routine.
+ * @param pCallbackParam  a parameter that will be provided to the
+ *                        timer callback routine as its second parameter
+ *                        when it is called; may be NULL.
+ * @param intervalMs      the time interval in milliseconds.
+ * @param periodic        if true the timer will be restarted after it
+ *                        has expired, else the timer will be one-shot.
+ * @return                zero on success else negative error code.
+ */
+int32_t uPortPrivateTimerCreate(uPortTimerHandle_t *pHandle,
+                                const char *pName,
+                                pTimerCallback_t *pCallback,
+                                void *pCallbackParam,
+                                uint32_t intervalMs,
+                                bool periodic);
+
+/** Delete a timer; if the callback of the timer is being called
+ * by another thread this waits for it to return.
+ *
+ * @param handle  the handle of the timer to be removed.
+ * @return        zero on success else negative error code.
+ */
+int32_t uPortPrivateTimerDelete(const uPortTimerHandle_t handle);
+
+/** Start a timer.
+ *
+ * @param handle  the handle of the timer.
+ * @return        zero on success else negative error code.
+ */
+int32_t uPortPrivateTimerStart(const uPortTimerHandle_t handle);
+
+/** Stop a timer.
+ *
+ * @param handle  the handle of the timer.
+ * @return        zero on success else negative error code.
+ */
+int32_t uPortPrivateTimerStop(const uPortTimerHandle_t handle);
+
+/** Change a timer interval.
+ *
+ * @param handle       the handle of the timer.
+ * @param intervalMs   the new time interval in milliseconds.
+ * @return             zero on success else negative error code.
+ */
+int32_t uPortPrivateTimerChange(const uPortTimerHandle_t handle,
+                                uint32_t intervalMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_PORT_PRIVATE_H_
+
+// End of file
@@ -0,0 +1,1294 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/** @file
+ * @brief Implementation of the port UART API on Linux, i.e. a serial
+ * port opened through termios.
+ *
+ * Each UART has a receive thread which waits, using epoll, on the
+ * serial port and on an eventfd used to ask it to terminate, reading
+ * whatever arrives into the receive buffer.  The receive thread is
+ * not a ubxlib task and hence is not suspended by a critical section
+ * (in the same way that the interrupt-driven ring buffer of an MCU
+ * UART is not).
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stdlib.h"    // malloc()/free()
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdio.h"     // snprintf()
+#include "string.h"    // memset(), strncmp()
+#include "errno.h"
+
+#include "unistd.h"
+#include "fcntl.h"
+#include "termios.h"
+#include "pthread.h"
+#include "sys/ioctl.h"
+#include "sys/epoll.h"
+#include "sys/eventfd.h"
+#include "linux/serial.h" // struct serial_icounter_struct
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port_debug.h"
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_uart.h"
+#include "u_port_event_queue.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_UART_DEVICE_NAME_FORMAT
+/** The format of the name of the serial device of a UART, with
+ * the UART number as the only parameter; e.g. set this to
+ * "/dev/ttyACM%d" for USB CDC devices or "/dev/pts/%d" to talk
+ * to a pseudo-terminal for host-side testing.
+ */
+# define U_PORT_UART_DEVICE_NAME_FORMAT "/dev/ttyUSB%d"
+#endif
+
+#ifndef U_PORT_UART_MAX_DEVICE_NAME_BUFFER_LENGTH
+/** The size of buffer required to contain a serial device name,
+ * including the terminator.
+ */
+# define U_PORT_UART_MAX_DEVICE_NAME_BUFFER_LENGTH 64
+#endif
+
+#ifndef U_PORT_UART_TIMER_POLL_TIME_MS
+/** Poll every 10 milliseconds to catch anything we might have
+ * missed, e.g. because the receive buffer was full, and to
+ * update the statistics.
+ */
+# define U_PORT_UART_TIMER_POLL_TIME_MS 10
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Structure of the things we need to keep track of per UART in
+ * a linked list.
+ */
+typedef struct uPortUartData_t {
+    int32_t uartHandle;
+    bool markedForDeletion;
+    char nameStr[U_PORT_UART_MAX_DEVICE_NAME_BUFFER_LENGTH];
+    int fd;          /**< the file descriptor of the serial port. */
+    int epollFd;     /**< the epoll instance of the receive thread. */
+    int terminateFd; /**< eventfd written to terminate the receive thread. */
+    pthread_t rxThread;
+    bool rxThreadRunning;
+    bool rxBufferIsMalloced;
+    size_t rxBufferSizeBytes;
+    char *pRxBufferStart;
+    volatile char *pRxBufferRead;
+    volatile char *pRxBufferWrite;
+    bool ctsFlowControlSuspended;
+    int32_t eventQueueHandle;
+    uint32_t eventFilter;
+    void (*pEventCallback)(int32_t, uint32_t, void *);
+    void *pEventCallbackParam;
+    bool userNeedsNotify; /**< set this when all the data has
+                           * been read and hence the user
+                           * would like a notification
+                           * when new data arrives. */
+    uPortUartStats_t stats;
+    struct serial_icounter_struct icount; /**< the last driver error counts. */
+    bool icountValid;
+    bool ctsHold; /**< the last CTS hold state, for the statistics. */
+    volatile bool hardwareFlowControl; /**< true if CRTSCTS is set. */
+    struct uPortUartData_t *pNext;
+} uPortUartData_t;
+
+/** Structure describing an event.
+ */
+typedef struct {
+    int32_t uartHandle;
+    uint32_t eventBitMap;
+    void (*pEventCallback)(int32_t, uint32_t, void *);
+    void *pEventCallbackParam;
+    uPortUartStats_t *pStats; /**< valid since the event queue is
+                                   closed before the UART is freed. */
+    int32_t timeMs; /**< when the event was sent, for the latency statistic. */
+} uPortUartEvent_t;
+
+/** Map of baud rate to termios speed.
+ */
+typedef struct {
+    int32_t baudRate;
+    speed_t speed;
+} uPortUartBaudRate_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Mutex to protect UART data.
+ */
+static uPortMutexHandle_t gMutex = NULL;
+
+/** Root of linked list of UART data.
+ */
+static uPortUartData_t *gpUartListRoot = NULL;
+
+/** The next UART handle to use.
+ */
+static int32_t gUartHandleNext = 0;
+
+/** The baud rates that termios supports.
+ */
+static const uPortUartBaudRate_t gBaudRate[] = {
+    {1200, B1200}, {2400, B2400}, {4800, B4800}, {9600, B9600},
+    {19200, B19200}, {38400, B38400}, {57600, B57600},
+    {115200, B115200}, {230400, B230400}, {460800, B460800},
+    {500000, B500000}, {576000, B576000}, {921600, B921600},
+    {1000000, B1000000}, {1152000, B1152000}, {1500000, B1500000},
+    {2000000, B2000000}, {2500000, B2500000}, {3000000, B3000000},
+    {3500000, B3500000}, {4000000, B4000000}
+};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Find a UART in the list by handle.
+// gMutex should be locked before this is called.
+static uPortUartData_t *pUartGetByHandle(int32_t handle)
+{
+    uPortUartData_t *pTmp = gpUartListRoot;
+
+    while ((pTmp != NULL) && (pTmp->uartHandle != handle)) {
+        pTmp = pTmp->pNext;
+    }
+
+    return pTmp;
+}
+
+// Find a UART in the list by name.
+// gMutex should be locked before this is called.
+static uPortUartData_t *pUartGetByName(const char *pNameStr)
+{
+    uPortUartData_t *pTmp = gpUartListRoot;
+
+    while ((pTmp != NULL) &&
+           (strncmp(pTmp->nameStr, pNameStr, sizeof(pTmp->nameStr)) != 0)) {
+        pTmp = pTmp->pNext;
+    }
+
+    return pTmp;
+}
+
+// Add a UART to the list, populating its UART handle and returning a
+// pointer to it.
+// gMutex should be locked before this is called.
+static uPortUartData_t *pUartAdd()
+{
+    uPortUartData_t *pTmp;
+    bool success = true;
+    int32_t x;
+
+    pTmp = (uPortUartData_t *) malloc(sizeof(uPortUartData_t));
+    if (pTmp != NULL) {
+        memset(pTmp, 0, sizeof(*pTmp));
+        pTmp->eventQueueHandle = -1;
+        pTmp->uartHandle = -1;
+        pTmp->fd = -1;
+        pTmp->epollFd = -1;
+        pTmp->terminateFd = -1;
+        pTmp->pNext = NULL;
+        // Get the next UART handle
+        x = gUartHandleNext;
+        while ((pUartGetByHandle(gUartHandleNext) != NULL) && success) {
+            gUartHandleNext++;
+            if (gUartHandleNext < 0) {
+                gUartHandleNext = 0;
+            }
+            if (gUartHandleNext == x) {
+                // Looped
+                success = false;
+            }
+        }
+        if (success) {
+            pTmp->uartHandle = gUartHandleNext;
+            pTmp->pNext = gpUartListRoot;
+            gpUartListRoot = pTmp;
+        } else {
+            // Clean up
+            free(pTmp);
+            pTmp = NULL;
+        }
+    }
+
+    return pTmp;
+}
+
+// Remove a UART from the list.
+// gMutex should be locked before this is called.
+static void uartRemove(const uPortUartData_t *pUartData)
+{
+    uPortUartData_t *pTmp = gpUartListRoot;
+    uPortUartData_t *pPrevious = NULL;
+
+    while (pTmp != NULL) {
+        if (pTmp == pUartData) {
+            if (pPrevious == NULL) {
+                // At head
+                gpUartListRoot = pTmp->pNext;
+            } else {
+                pPrevious->pNext = pTmp->pNext;
+            }
+            free(pTmp);
+            // Force exit
+            pTmp = NULL;
+        } else {
+            pPrevious = pTmp;
+            pTmp = pTmp->pNext;
+        }
+    }
+}
+
+// Stop the receive thread of a UART and close its file descriptors.
+static void uartStop(uPortUartData_t *pUartData)
+{
+    uint64_t value = 1;
+
+    if (pUartData->rxThreadRunning) {
+        // Ask the receive thread to exit and wait for it to do so
+        if (write(pUartData->terminateFd, &value, sizeof(value)) == sizeof(value)) {
+            pthread_join(pUartData->rxThread, NULL);
+        }
+        pUartData->rxThreadRunning = false;
+    }
+    if (pUartData->terminateFd >= 0) {
+        close(pUartData->terminateFd);
+        pUartData->terminateFd = -1;
+    }
+    if (pUartData->epollFd >= 0) {
+        close(pUartData->epollFd);
+        pUartData->epollFd = -1;
+    }
+    if (pUartData->fd >= 0) {
+        close(pUartData->fd);
+        pUartData->fd = -1;
+    }
+}
+
+// Close a UART.
+// !!! gMutex should NOT be locked when this is called !!!
+static void uartCloseRequiresMutex(uPortUartData_t *pUartData)
+{
+    // Stop the receive thread
+    uartStop(pUartData);
+    // Remove the callback if there is one
+    if (pUartData->eventQueueHandle >= 0) {
+        uPortEventQueueClose(pUartData->eventQueueHandle);
+    }
+
+    // Now lock the mutex for the remaining bits
+    U_PORT_MUTEX_LOCK(gMutex);
+
+    if (pUartData->rxBufferIsMalloced) {
+        // Free the buffer
+        free(pUartData->pRxBufferStart);
+    }
+    // And then take it out of the list
+    uartRemove(pUartData);
+
+    U_PORT_MUTEX_UNLOCK(gMutex);
+}
+
+// Event handler, calls the user's event callback.
+static void eventHandler(void *pParam, size_t paramLength)
+{
+    uPortUartEvent_t *pEvent = (uPortUartEvent_t *) pParam;
+    int32_t latencyMs = uPortGetTickTimeMs() - pEvent->timeMs;
+
+    (void) paramLength;
+
+    // Don't need to worry about locking the mutex,
+    // the close() function makes sure this event handler
+    // exits cleanly and, in any case, the user callback
+    // will want to be able to access functions in this
+    // API which will need to lock the mutex.
+
+    if (pEvent->pEventCallback != NULL) {
+        if (latencyMs > pEvent->pStats->eventCallbackLatencyMaxMs) {
+            pEvent->pStats->eventCallbackLatencyMaxMs = latencyMs;
+        }
+        pEvent->pEventCallback(pEvent->uartHandle,
+                               pEvent->eventBitMap,
+                               pEvent->pEventCallbackParam);
+    }
+}
+
+// Work out how much linear space is free in the receive buffer,
+// i.e. how much can be written at pRxBufferWrite in one go;
+// called from the thread that fills the receive buffer.
+static int32_t rxBufferSpaceAvailable(const uPortUartData_t *pUartData)
+{
+    int32_t spaceAvailable;
+    const volatile char *pRxBufferRead = pUartData->pRxBufferRead;
+
+    if (pUartData->pRxBufferWrite >= pRxBufferRead) {
+        // Write pointer is at or ahead of the read pointer,
+        // bytes available are from the write pointer
+        // up to the end of the buffer but we also need to
+        // make sure that wouldn't cause the pointers to
+        // catch up
+        spaceAvailable = pUartData->pRxBufferStart +
+                         (pUartData->rxBufferSizeBytes) -
+                         pUartData->pRxBufferWrite;
+        if ((spaceAvailable > 0) &&
+            (pRxBufferRead == pUartData->pRxBufferStart)) {
+            spaceAvailable--;
+        }
+    } else {
+        // Write pointer is behind read, bytes available is
+        // simply the difference, -1 so that they don't catch up
+        spaceAvailable = (pRxBufferRead - pUartData->pRxBufferWrite) - 1;
+    }
+
+    return spaceAvailable;
+}
+
+// Let the user know that data has been received, if they
+// are waiting for that.
+static void notifyDataReceived(uPortUartData_t *pUartData)
+{
+    uPortUartEvent_t event;
+
+    if ((pUartData->userNeedsNotify) &&
+        (pUartData->eventQueueHandle >= 0)) {
+        // Call the user callback
+        pUartData->userNeedsNotify = false;
+        event.uartHandle = pUartData->uartHandle;
+        event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
+        event.pEventCallback = pUartData->pEventCallback;
+        event.pEventCallbackParam = pUartData->pEventCallbackParam;
+        event.pStats = &(pUartData->stats);
+        event.timeMs = uPortGetTickTimeMs();
+        uPortEventQueueSend(pUartData->eventQueueHandle, &event, sizeof(event));
+    }
+}
+
+// Update the statistics from the driver's error counts and from
+// the receive buffer, called by the receive thread.
+static void updateStats(uPortUartData_t *pUartData)
+{
+    struct serial_icounter_struct icount;
+    int waitingInDriver = 0;
+    int modemStatus = 0;
+    bool ctsHold;
+    size_t waiting;
+    const volatile char *pRxBufferRead = pUartData->pRxBufferRead;
+
+    // Not all serial drivers (e.g. pseudo-terminals and some USB
+    // serial adapters) support the error counts, or the modem
+    // status, in which case those statistics remain at zero
+    if (ioctl(pUartData->fd, TIOCGICOUNT, &icount) == 0) {
+        if (pUartData->icountValid) {
+            pUartData->stats.rxOverrunErrors += icount.overrun - pUartData->icount.overrun;
+            pUartData->stats.rxFramingErrors += (icount.frame - pUartData->icount.frame) +
+                                                (icount.parity - pUartData->icount.parity);
+            pUartData->stats.rxBufferOverflows += icount.buf_overrun -
+                                                  pUartData->icount.buf_overrun;
+        }
+        pUartData->icount = icount;
+        pUartData->icountValid = true;
+    }
+    if ((ioctl(pUartData->fd, FIONREAD, &waitingInDriver) == 0) &&
+        (waitingInDriver > 0) && (rxBufferSpaceAvailable(pUartData) == 0)) {
+        // Data is waiting in the driver because our buffer is full
+        pUartData->stats.rxBufferOverflows++;
+    }
+    if (pUartData->hardwareFlowControl &&
+        (ioctl(pUartData->fd, TIOCMGET, &modemStatus) == 0)) {
+        // Count each time CTS starts holding off transmission
+        ctsHold = ((modemStatus & TIOCM_CTS) == 0);
+        if (ctsHold && !pUartData->ctsHold) {
+            pUartData->stats.ctsStalls++;
+        }
+        pUartData->ctsHold = ctsHold;
+    }
+
+    if (pUartData->pRxBufferWrite >= pRxBufferRead) {
+        waiting = pUartData->pRxBufferWrite - pRxBufferRead;
+    } else {
+        waiting = pUartData->rxBufferSizeBytes -
+                  (pRxBufferRead - pUartData->pRxBufferWrite);
+    }
+    if (waiting > pUartData->stats.rxBufferHighWaterMark) {
+        pUartData->stats.rxBufferHighWaterMark = waiting;
+    }
+}
+
+// Read whatever is waiting in the serial port into the receive
+// buffer, called by rxThread(); returns true if the receive
+// buffer is full.
+static bool rxRead(uPortUartData_t *pUartData)
+{
+    ssize_t bytesRead;
+    size_t totalSize = 0;
+    int32_t spaceAvailable;
+
+    do {
+        bytesRead = 0;
+        // Work out how much linear space we have
+        // free in the buffer
+        spaceAvailable = rxBufferSpaceAvailable(pUartData);
+        if (spaceAvailable > 0) {
+            // Non-blocking since VMIN and VTIME are zero
+            bytesRead = read(pUartData->fd, (char *) pUartData->pRxBufferWrite,
+                             spaceAvailable);
+            if (bytesRead > 0) {
+                // Move the write pointer on
+                pUartData->pRxBufferWrite += bytesRead;
+                totalSize += bytesRead;
+                if (pUartData->pRxBufferWrite >= pUartData->pRxBufferStart +
+                    pUartData->rxBufferSizeBytes) {
+                    pUartData->pRxBufferWrite = pUartData->pRxBufferStart;
+                }
+            }
+        }
+        // Keep reading while there is stuff to read
+    } while ((bytesRead > 0) || ((bytesRead < 0) && (errno == EINTR)));
+
+    pUartData->stats.rxBytes += totalSize;
+    updateStats(pUartData);
+
+    if (totalSize > 0) {
+        notifyDataReceived(pUartData);
+    }
+
+    return (rxBufferSpaceAvailable(pUartData) == 0);
+}
+
+// Receive thread, one per UART.
+static void *rxThread(void *pParam)
+{
+    uPortUartData_t *pUartData = (uPortUartData_t *) pParam;
+    struct epoll_event event;
+    bool rxEnabled = true;
+    bool keepGoing = true;
+    bool full;
+    int x;
+
+    while (keepGoing) {
+        x = epoll_wait(pUartData->epollFd, &event, 1, U_PORT_UART_TIMER_POLL_TIME_MS);
+        if ((x > 0) && (event.data.fd == pUartData->terminateFd)) {
+            keepGoing = false;
+        } else if ((x >= 0) || (errno == EINTR)) {
+            // Either data has arrived or the periodic poll
+            // time has passed, do a read
+            full = rxRead(pUartData);
+            if (full == rxEnabled) {
+                // While the receive buffer is full stop waiting on
+                // the serial port, otherwise epoll would return
+                // immediately, over and over; the periodic poll
+                // will pick up the data once the user has read
+                // from the buffer
+                memset(&event, 0, sizeof(event));
+                event.events = full ? 0 : EPOLLIN;
+                event.data.fd = pUartData->fd;
+                if (epoll_ctl(pUartData->epollFd, EPOLL_CTL_MOD,
+                              pUartData->fd, &event) == 0) {
+                    rxEnabled = !full;
+                }
+            }
+        } else {
+            // Something has gone badly wrong with epoll, no
+            // point in spinning
+            keepGoing = false;
+        }
+    }
+
+    return NULL;
+}
+
+// Convert a baud rate to a termios speed, returning B0 if
+// the baud rate is not supported.
+static speed_t baudRateToSpeed(int32_t baudRate)
+{
+    speed_t speed = B0;
+
+    for (size_t x = 0; (speed == B0) && (x < sizeof(gBaudRate) / sizeof(gBaudRate[0])); x++) {
+        if (gBaudRate[x].baudRate == baudRate) {
+            speed = gBaudRate[x].speed;
+        }
+    }
+
+    return speed;
+}
+
+// Open and configure the serial port of a UART and start its
+// receive thread.
+// gMutex should be locked before this is called.
+static int32_t uartStart(uPortUartData_t *pUartData, speed_t speed,
+                         bool hardwareFlowControl)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+    struct termios tty;
+    struct epoll_event event;
+    int flags;
+
+    // Open non-blocking so as not to wait for carrier
+    // detect, then switch blocking back on for writes;
+    // reads never block since VMIN and VTIME are zero
+    pUartData->fd = open(pUartData->nameStr, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (pUartData->fd >= 0) {
+        flags = fcntl(pUartData->fd, F_GETFL);
+        if ((flags >= 0) && (fcntl(pUartData->fd, F_SETFL, flags & ~O_NONBLOCK) == 0) &&
+            (tcgetattr(pUartData->fd, &tty) == 0)) {
+            // Raw, 8N1, no software flow control
+            cfmakeraw(&tty);
+            tty.c_cflag |= CLOCAL | CREAD;
+            tty.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+            // CTS and RTS flow control can only be switched
+            // on and off together on Linux
+            if (hardwareFlowControl) {
+                tty.c_cflag |= CRTSCTS;
+            }
+            tty.c_cc[VMIN] = 0;
+            tty.c_cc[VTIME] = 0;
+            if ((cfsetispeed(&tty, speed) == 0) && (cfsetospeed(&tty, speed) == 0) &&
+                (tcsetattr(pUartData->fd, TCSANOW, &tty) == 0)) {
+                pUartData->hardwareFlowControl = hardwareFlowControl;
+                tcflush(pUartData->fd, TCIOFLUSH);
+                pUartData->terminateFd = eventfd(0, 0);
+                pUartData->epollFd = epoll_create1(0);
+                if ((pUartData->terminateFd >= 0) && (pUartData->epollFd >= 0)) {
+                    memset(&event, 0, sizeof(event));
+                    event.events = EPOLLIN;
+                    event.data.fd = pUartData->terminateFd;
+                    if (epoll_ctl(pUartData->epollFd, EPOLL_CTL_ADD,
+                                  pUartData->terminateFd, &event) == 0) {
+                        event.data.fd = pUartData->fd;
+                        if ((epoll_ctl(pUartData->epollFd, EPOLL_CTL_ADD,
+                                       pUartData->fd, &event) == 0) &&
+                            (pthread_create(&(pUartData->rxThread), NULL,
+                                            rxThread, pUartData) == 0)) {
+                            pUartData->rxThreadRunning = true;
+                            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (errorCode != 0) {
+        uartStop(pUartData);
+    }
+
+    return errorCode;
+}
+
+// Switch hardware flow control on or off.
+// gMutex should be locked before this is called.
+static bool setHardwareFlowControl(uPortUartData_t *pUartData, bool onNotOff)
+{
+    bool success = false;
+    struct termios tty;
+
+    if (tcgetattr(pUartData->fd, &tty) == 0) {
+        if (onNotOff) {
+            tty.c_cflag |= CRTSCTS;
+        } else {
+            tty.c_cflag &= ~CRTSCTS;
+        }
+        if (tcsetattr(pUartData->fd, TCSANOW, &tty) == 0) {
+            pUartData->hardwareFlowControl = onNotOff;
+            success = true;
+        }
+    }
+
+    return success;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Initialise the UART driver.
+int32_t uPortUartInit()
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (gMutex == NULL) {
+        errorCode = uPortMutexCreate(&gMutex);
+    }
+
+    return errorCode;
+}
+
+// Deinitialise the UART driver.
+void uPortUartDeinit()
+{
+    uPortUartData_t *pTmp = gpUartListRoot;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        // First, mark all instances for deletion
+        while (pTmp != NULL) {
+            pTmp->markedForDeletion = true;
+            pTmp = pTmp->pNext;
+        }
+
+        // Release the mutex so that deletion can occur
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
+        // Now close all the UART instances
+        while (gpUartListRoot != NULL) {
+            uartCloseRequiresMutex(gpUartListRoot);
+        }
+
+        // Delete the mutex
+        uPortMutexDelete(gMutex);
+        gMutex = NULL;
+    }
+}
+
+// Open a UART instance.
+int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
+                      void *pReceiveBuffer,
+                      size_t receiveBufferSizeBytes,
+                      int32_t pinTx, int32_t pinRx,
+                      int32_t pinCts, int32_t pinRts)
+{
+    int32_t handleOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+    char nameStr[U_PORT_UART_MAX_DEVICE_NAME_BUFFER_LENGTH];
+    speed_t speed = baudRateToSpeed(baudRate);
+
+    // TX/RX pins are managed by Linux
+    (void) pinTx;
+    (void) pinRx;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        snprintf(nameStr, sizeof(nameStr), U_PORT_UART_DEVICE_NAME_FORMAT, (int) uart);
+        handleOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((uart >= 0) && (speed != B0) && (pUartGetByName(nameStr) == NULL) &&
+            (receiveBufferSizeBytes > 0)) {
+            handleOrErrorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pUartData = pUartAdd();
+            if (pUartData != NULL) {
+                pUartData->markedForDeletion = false;
+                pUartData->userNeedsNotify = true;
+                pUartData->pRxBufferStart = (char *) pReceiveBuffer;
+                if (pUartData->pRxBufferStart == NULL) {
+                    // Malloc memory for the read buffer
+                    pUartData->pRxBufferStart = (char *) malloc(receiveBufferSizeBytes);
+                    pUartData->rxBufferIsMalloced = true;
+                }
+                if (pUartData->pRxBufferStart != NULL) {
+                    pUartData->rxBufferSizeBytes = receiveBufferSizeBytes;
+                    pUartData->pRxBufferRead = pUartData->pRxBufferStart;
+                    pUartData->pRxBufferWrite = pUartData->pRxBufferStart;
+                    strncpy(pUartData->nameStr, nameStr, sizeof(pUartData->nameStr));
+                    // As on Windows, the CTS and RTS pins are simply
+                    // flags indicating whether flow control should be on
+                    handleOrErrorCode = uartStart(pUartData, speed,
+                                                  (pinCts >= 0) || (pinRts >= 0));
+                    if (handleOrErrorCode == 0) {
+                        handleOrErrorCode = pUartData->uartHandle;
+                    }
+                }
+
+                if (handleOrErrorCode < 0) {
+                    // Clean up
+                    if (pUartData->rxBufferIsMalloced) {
+                        free(pUartData->pRxBufferStart);
+                    }
+                    uartRemove(pUartData);
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return handleOrErrorCode;
+}
+
+// Close a UART instance.
+void uPortUartClose(int32_t handle)
+{
+    uPortUartData_t *pUartData = NULL;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion) {
+            // Mark the UART for deletion within the mutex
+            pUartData->markedForDeletion = true;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
+        if (pUartData != NULL) {
+            // Actually delete the UART outside the mutex
+            uartCloseRequiresMutex(pUartData);
+        }
+    }
+}
+
+// Get the number of bytes waiting in the receive buffer.
+int32_t uPortUartGetReceiveSize(int32_t handle)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+    const volatile char *pRxBufferWrite;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion) {
+            pRxBufferWrite = pUartData->pRxBufferWrite;
+            sizeOrErrorCode = 0;
+            if (pUartData->pRxBufferRead < pRxBufferWrite) {
+                // Read pointer is behind write, bytes
+                // received is simply the difference
+                sizeOrErrorCode = pRxBufferWrite - pUartData->pRxBufferRead;
+            } else if (pUartData->pRxBufferRead > pRxBufferWrite) {
+                // Read pointer is ahead of write, bytes received
+                // is from the read pointer up to the end of the buffer
+                // then wrap around to the write pointer
+                sizeOrErrorCode = (pUartData->pRxBufferStart +
+                                   pUartData->rxBufferSizeBytes -
+                                   pUartData->pRxBufferRead) +
+                                  (pRxBufferWrite - pUartData->pRxBufferStart);
+            }
+
+            if (sizeOrErrorCode == 0) {
+                pUartData->userNeedsNotify = true;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return sizeOrErrorCode;
+}
+
+// Read from the given UART interface.
+int32_t uPortUartRead(int32_t handle, void *pBuffer,
+                      size_t sizeBytes)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    size_t thisSize;
+    uPortUartData_t *pUartData;
+    const volatile char *pRxBufferWrite;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pBuffer != NULL) && (sizeBytes > 0) &&
+            (pUartData != NULL) && !pUartData->markedForDeletion) {
+            sizeOrErrorCode = 0;
+            pRxBufferWrite = pUartData->pRxBufferWrite;
+            if (pUartData->pRxBufferRead < pRxBufferWrite) {
+                // Read pointer is behind write, just take as much
+                // of the difference as the user allows
+                sizeOrErrorCode = pRxBufferWrite - pUartData->pRxBufferRead;
+                if (sizeOrErrorCode > (int32_t) sizeBytes) {
+                    sizeOrErrorCode = sizeBytes;
+                }
+                memcpy(pBuffer, (const char *) pUartData->pRxBufferRead,
+                       sizeOrErrorCode);
+                // Move the pointer on
+                pUartData->pRxBufferRead += sizeOrErrorCode;
+            } else if (pUartData->pRxBufferRead > pRxBufferWrite) {
+                // Read pointer is ahead of write, first take up to the
+                // end of the buffer as far as the user allows
+                thisSize = pUartData->pRxBufferStart +
+                           pUartData->rxBufferSizeBytes -
+                           pUartData->pRxBufferRead;
+                if (thisSize > sizeBytes) {
+                    thisSize = sizeBytes;
+                }
+                memcpy(pBuffer, (const char *) pUartData->pRxBufferRead, thisSize);
+                pBuffer = (char *) pBuffer + thisSize;
+                sizeBytes -= thisSize;
+                sizeOrErrorCode = thisSize;
+                // Move the read pointer on, wrapping as necessary
+                pUartData->pRxBufferRead += thisSize;
+                if (pUartData->pRxBufferRead >= pUartData->pRxBufferStart +
+                    pUartData->rxBufferSizeBytes) {
+                    pUartData->pRxBufferRead = pUartData->pRxBufferStart;
+                }
+                // If there is still room in the user buffer then
+                // carry on taking up to the write pointer
+                if (sizeBytes > 0) {
+                    thisSize = pRxBufferWrite - pUartData->pRxBufferRead;
+                    if (thisSize > sizeBytes) {
+                        thisSize = sizeBytes;
+                    }
+                    memcpy(pBuffer, (const char *) pUartData->pRxBufferRead, thisSize);
+                    pBuffer = (char *) pBuffer + thisSize;
+                    sizeBytes -= thisSize;
+                    sizeOrErrorCode += thisSize;
+                    // Move the read pointer on
+                    pUartData->pRxBufferRead += thisSize;
+                }
+            }
+
+            if (sizeOrErrorCode == 0) {
+                pUartData->userNeedsNotify = true;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return sizeOrErrorCode;
+}
+
+// Write to the given UART interface.
+int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
+                       size_t sizeBytes)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    ssize_t bytesWritten;
+    size_t totalSize = 0;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pBuffer != NULL) && (sizeBytes > 0) &&
+            (pUartData != NULL) && !pUartData->markedForDeletion) {
+            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            // Blocking write, keep going until it's all gone
+            do {
+                bytesWritten = write(pUartData->fd, (const char *) pBuffer + totalSize,
+                                     sizeBytes - totalSize);
+                if (bytesWritten > 0) {
+                    totalSize += bytesWritten;
+                }
+            } while ((totalSize < sizeBytes) &&
+                     ((bytesWritten > 0) || ((bytesWritten < 0) && (errno == EINTR))));
+            if (totalSize > 0) {
+                sizeOrErrorCode = (int32_t) totalSize;
+                pUartData->stats.txBytes += totalSize;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return sizeOrErrorCode;
+}
+
+// Get the statistics of a UART.
+int32_t uPortUartGetStats(int32_t handle, uPortUartStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pStats != NULL) && (pUartData != NULL) &&
+            !pUartData->markedForDeletion) {
+            *pStats = pUartData->stats;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Set an event callback.
+int32_t uPortUartEventCallbackSet(int32_t handle,
+                                  uint32_t filter,
+                                  void (*pFunction)(int32_t,
+                                                    uint32_t,
+                                                    void *),
+                                  void *pParam,
+                                  size_t stackSizeBytes,
+                                  int32_t priority)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+    char name[16];
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion &&
+            (pUartData->eventQueueHandle < 0) &&
+            (filter != 0) && (pFunction != NULL)) {
+            // Open an event queue to eventHandler()
+            // which will receive uPortUartEvent_t
+            // and give it a useful name for debug purposes
+            snprintf(name, sizeof(name), "eventUart%d", (int) handle);
+            errorCode = uPortEventQueueOpen(eventHandler, name,
+                                            sizeof(uPortUartEvent_t),
+                                            stackSizeBytes,
+                                            priority,
+                                            U_PORT_UART_EVENT_QUEUE_SIZE);
+            if (errorCode >= 0) {
+                pUartData->eventQueueHandle = errorCode;
+                pUartData->eventFilter = filter;
+                pUartData->pEventCallback = pFunction;
+                pUartData->pEventCallbackParam = pParam;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Remove an event callback.
+void uPortUartEventCallbackRemove(int32_t handle)
+{
+    int32_t eventQueueHandle = -1;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion) {
+            // Save the eventQueueHandle and set all
+            // the parameters to indicate that the
+            // queue is closed
+            eventQueueHandle = pUartData->eventQueueHandle;
+            pUartData->eventQueueHandle = -1;
+            pUartData->pEventCallback = NULL;
+            pUartData->eventFilter = 0;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
+        // Now close the event queue
+        // outside the gMutex lock.  Reason for this
+        // is that the event task could be calling
+        // back into here and we don't want it
+        // blocked by us or we'll get stuck.
+        if (eventQueueHandle >= 0) {
+            uPortEventQueueClose(eventQueueHandle);
+        }
+    }
+}
+
+// Get the callback filter bit-mask.
+uint32_t uPortUartEventCallbackFilterGet(int32_t handle)
+{
+    uint32_t filter = 0;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion) {
+            filter = pUartData->eventFilter;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return filter;
+}
+
+// Change the callback filter bit-mask.
+int32_t uPortUartEventCallbackFilterSet(int32_t handle,
+                                        uint32_t filter)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((filter != 0) && (pUartData != NULL) &&
+            !pUartData->markedForDeletion) {
+            pUartData->eventFilter = filter;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Send an event to the callback.
+int32_t uPortUartEventSend(int32_t handle, uint32_t eventBitMap)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+    uPortUartEvent_t event;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion &&
+            (pUartData->eventQueueHandle >= 0) &&
+            // The only event we support right now
+            (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
+            event.uartHandle = handle;
+            event.eventBitMap = eventBitMap;
+            event.pEventCallback = pUartData->pEventCallback;
+            event.pEventCallbackParam = pUartData->pEventCallbackParam;
+            event.pStats = &(pUartData->stats);
+            event.timeMs = uPortGetTickTimeMs();
+            errorCode = uPortEventQueueSend(pUartData->eventQueueHandle,
+                                            &event, sizeof(event));
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Send an event to the callback, non-blocking version.
+int32_t uPortUartEventTrySend(int32_t handle, uint32_t eventBitMap,
+                              int32_t delayMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+    uPortUartEvent_t event;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion &&
+            (pUartData->eventQueueHandle >= 0) &&
+            // The only event we support right now
+            (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
+            event.uartHandle = handle;
+            event.eventBitMap = eventBitMap;
+            event.pEventCallback = pUartData->pEventCallback;
+            event.pEventCallbackParam = pUartData->pEventCallbackParam;
+            event.pStats = &(pUartData->stats);
+            event.timeMs = startTimeMs;
+            // uPortEventQueueSendIrq() is not supported on Linux so
+            // wait for there to be room and then do a normal send,
+            // which will not then block
+            errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+            while ((uPortEventQueueGetFree(pUartData->eventQueueHandle) <= 0) &&
+                   (uPortGetTickTimeMs() - startTimeMs < delayMs)) {
+                uPortTaskBlock(U_CFG_OS_YIELD_MS);
+            }
+            if (uPortEventQueueGetFree(pUartData->eventQueueHandle) > 0) {
+                errorCode = uPortEventQueueSend(pUartData->eventQueueHandle,
+                                                &event, sizeof(event));
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Return true if we're in an event callback.
+bool uPortUartEventIsCallback(int32_t handle)
+{
+    bool isEventCallback = false;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion &&
+            (pUartData->eventQueueHandle >= 0)) {
+            isEventCallback = uPortEventQueueIsTask(pUartData->eventQueueHandle);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return isEventCallback;
+}
+
+// Get the stack high watermark for the task on the event queue.
+int32_t uPortUartEventStackMinFree(int32_t handle)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion &&
+            (pUartData->eventQueueHandle >= 0)) {
+            sizeOrErrorCode = uPortEventQueueStackMinFree(pUartData->eventQueueHandle);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return sizeOrErrorCode;
+}
+
+// Determine if RTS flow control is enabled.
+bool uPortUartIsRtsFlowControlEnabled(int32_t handle)
+{
+    bool rtsFlowControlIsEnabled = false;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion) {
+            // CTS and RTS flow control go together on Linux
+            rtsFlowControlIsEnabled = pUartData->hardwareFlowControl;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return rtsFlowControlIsEnabled;
+}
+
+// Determine if CTS flow control is enabled.
+bool uPortUartIsCtsFlowControlEnabled(int32_t handle)
+{
+    bool ctsFlowControlIsEnabled = false;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion) {
+            ctsFlowControlIsEnabled = pUartData->hardwareFlowControl;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return ctsFlowControlIsEnabled;
+}
+
+// Suspend CTS flow control.
+int32_t uPortUartCtsSuspend(int32_t handle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if (pUartData != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (!pUartData->ctsFlowControlSuspended && pUartData->hardwareFlowControl) {
+                // Linux can only switch CTS and RTS flow control
+                // off together, which is fine for the purpose of
+                // this function, waking up a sleeping module
+                errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+                if (setHardwareFlowControl(pUartData, false)) {
+                    pUartData->ctsFlowControlSuspended = true;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Resume CTS flow control.
+void uPortUartCtsResume(int32_t handle)
+{
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && (pUartData->ctsFlowControlSuspended) &&
+            setHardwareFlowControl(pUartData, true)) {
+            pUartData->ctsFlowControlSuspended = false;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+// End of file
@@ -50,6 +50,9 @@
 #include "nrf_log.h"
 #include "nrf_log_ctrl.h"
 #include "nrf_log_default_backends.h"
+#ifdef U_PORT_CRYPTO_HARDWARE
+# include "nrf_crypto.h"
+#endif
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -141,6 +144,13 @@ int32_t uPortInit()
                 errorCode = uPortUartInit();
             }
         }
+#ifdef U_PORT_CRYPTO_HARDWARE
+        if ((errorCode == 0) && !nrf_crypto_is_initialized()) {
+            // Not fatal: u_port_crypto.c falls back to mbedTLS
+            // if nrf_crypto is not initialised
+            nrf_crypto_init();
+        }
+#endif
         gInitialised = (errorCode == 0);
     }
 
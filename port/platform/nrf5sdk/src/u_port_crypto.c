@@ -0,0 +1,239 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Implementation of the crypto API for the NRF52 platform
+ * using nrf_crypto with the CryptoCell CC310 backend of the NRF52840.
+ * Only compiled in if U_PORT_CRYPTO_HARDWARE is defined, otherwise
+ * the mbedTLS implementation in port/platform/common/mbedtls is
+ * used.  Anything the CC310 can't do (e.g. input data that is not
+ * in RAM, since the CC310 reads it by DMA) or a call made while the
+ * CC310 is in use by another task falls back to mbedTLS.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#ifdef U_PORT_CRYPTO_HARDWARE
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy()
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_crypto.h"
+
+#include "u_port_crypto_mbedtls.h"
+
+#include "nrfx_common.h" // nrfx_is_in_ram()
+#include "nrf_crypto.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The length of an AES 128 key.
+ */
+#define U_PORT_CRYPTO_AES128_KEY_LENGTH_BYTES 16
+
+/** The length of an AES block.
+ */
+#define U_PORT_CRYPTO_AES_BLOCK_LENGTH_BYTES 16
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return true if the CC310 can read the given buffer.
+static bool isUsable(const char *pBuffer, size_t length)
+{
+    return (length == 0) || ((pBuffer != NULL) && nrfx_is_in_ram(pBuffer) &&
+                             nrfx_is_in_ram(pBuffer + length - 1));
+}
+
+// Perform AES 128 CBC encryption or decryption using the CC310,
+// returning true if it was done.
+static bool aes128Cbc(nrf_crypto_operation_t operation,
+                      const char *pKey, size_t keyLengthBytes,
+                      char *pInitVector, const char *pInput,
+                      size_t lengthBytes, char *pOutput)
+{
+    bool done = false;
+    nrf_crypto_aes_context_t context;
+    // Keep a copy of the key and initialisation vector in RAM:
+    // nrf_crypto wants them non-const and the CC310 needs them in RAM
+    uint8_t key[U_PORT_CRYPTO_AES128_KEY_LENGTH_BYTES];
+    uint8_t iv[U_PORT_CRYPTO_AES128_INITIALISATION_VECTOR_LENGTH_BYTES];
+    char nextIv[U_PORT_CRYPTO_AES128_INITIALISATION_VECTOR_LENGTH_BYTES];
+    size_t outputLength = lengthBytes;
+
+    if (nrf_crypto_is_initialized() && (pKey != NULL) &&
+        (keyLengthBytes == sizeof(key)) && (pInitVector != NULL) &&
+        (lengthBytes > 0) && (lengthBytes % U_PORT_CRYPTO_AES_BLOCK_LENGTH_BYTES == 0) &&
+        isUsable(pInput, lengthBytes) && (pOutput != NULL)) {
+        memcpy(key, pKey, sizeof(key));
+        memcpy(iv, pInitVector, sizeof(iv));
+        if (operation == NRF_CRYPTO_DECRYPT) {
+            // When decrypting the next initialisation vector is the
+            // last block of the input, which may be overwritten
+            memcpy(nextIv, pInput + lengthBytes - sizeof(nextIv), sizeof(nextIv));
+        }
+        if (nrf_crypto_aes_crypt(&context, &g_nrf_crypto_aes_cbc_128_info,
+                                 operation, key, iv, (uint8_t *) pInput,
+                                 lengthBytes, (uint8_t *) pOutput,
+                                 &outputLength) == NRF_SUCCESS) {
+            // Update the initialisation vector exactly as mbedTLS would
+            if (operation == NRF_CRYPTO_ENCRYPT) {
+                memcpy(nextIv, pOutput + lengthBytes - sizeof(nextIv), sizeof(nextIv));
+            }
+            memcpy(pInitVector, nextIv, sizeof(nextIv));
+            done = true;
+        }
+    }
+
+    return done;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Perform a SHA256 calculation on a block of data.
+int32_t uPortCryptoSha256(const char *pInput,
+                          size_t inputLengthBytes,
+                          char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    nrf_crypto_hash_context_t context;
+    size_t outputLength = U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES;
+
+    if (!nrf_crypto_is_initialized() || (inputLengthBytes == 0) ||
+        !isUsable(pInput, inputLengthBytes) || (pOutput == NULL) ||
+        (nrf_crypto_hash_calculate(&context, &g_nrf_crypto_hash_sha256_info,
+                                   (const uint8_t *) pInput, inputLengthBytes,
+                                   (uint8_t *) pOutput,
+                                   &outputLength) != NRF_SUCCESS)) {
+        errorCode = uPortCryptoMbedtlsSha256(pInput, inputLengthBytes, pOutput);
+    }
+
+    return errorCode;
+}
+
+// Start a SHA256 calculation: the hardware is only used for
+// one-shot calculations, which don't tie it up, so this is done
+// with mbedTLS.
+int32_t uPortCryptoSha256Start(void **ppContext)
+{
+    return uPortCryptoMbedtlsSha256Start(ppContext);
+}
+
+// Add data to a SHA256 calculation.
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    return uPortCryptoMbedtlsSha256Update(pContext, pInput,
+                                          inputLengthBytes);
+}
+
+// Complete a SHA256 calculation.
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    return uPortCryptoMbedtlsSha256Finish(pContext, pOutput);
+}
+
+// Perform a HMAC SHA256 calculation on a block of data.
+int32_t uPortCryptoHmacSha256(const char *pKey,
+                              size_t keyLengthBytes,
+                              const char *pInput,
+                              size_t inputLengthBytes,
+                              char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    nrf_crypto_hmac_context_t context;
+    size_t outputLength = U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES;
+
+    if (!nrf_crypto_is_initialized() || (keyLengthBytes == 0) ||
+        !isUsable(pKey, keyLengthBytes) || (inputLengthBytes == 0) ||
+        !isUsable(pInput, inputLengthBytes) || (pOutput == NULL) ||
+        (nrf_crypto_hmac_calculate(&context, &g_nrf_crypto_hmac_sha256_info,
+                                   (uint8_t *) pOutput, &outputLength,
+                                   (const uint8_t *) pKey, keyLengthBytes,
+                                   (const uint8_t *) pInput,
+                                   inputLengthBytes) != NRF_SUCCESS)) {
+        errorCode = uPortCryptoMbedtlsHmacSha256(pKey, keyLengthBytes,
+                                                 pInput, inputLengthBytes,
+                                                 pOutput);
+    }
+
+    return errorCode;
+}
+
+// Perform AES 128 CBC encryption of a block of data.
+int32_t uPortCryptoAes128CbcEncrypt(const char *pKey,
+                                    size_t keyLengthBytes,
+                                    char *pInitVector,
+                                    const char *pInput,
+                                    size_t lengthBytes,
+                                    char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (!aes128Cbc(NRF_CRYPTO_ENCRYPT, pKey, keyLengthBytes, pInitVector,
+                   pInput, lengthBytes, pOutput)) {
+        errorCode = uPortCryptoMbedtlsAes128CbcEncrypt(pKey, keyLengthBytes,
+                                                       pInitVector, pInput,
+                                                       lengthBytes, pOutput);
+    }
+
+    return errorCode;
+}
+
+// Perform AES 128 CBC decryption of a block of data.
+int32_t uPortCryptoAes128CbcDecrypt(const char *pKey,
+                                    size_t keyLengthBytes,
+                                    char *pInitVector,
+                                    const char *pInput,
+                                    size_t lengthBytes,
+                                    char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (!aes128Cbc(NRF_CRYPTO_DECRYPT, pKey, keyLengthBytes, pInitVector,
+                   pInput, lengthBytes, pOutput)) {
+        errorCode = uPortCryptoMbedtlsAes128CbcDecrypt(pKey, keyLengthBytes,
+                                                       pInitVector, pInput,
+                                                       lengthBytes, pOutput);
+    }
+
+    return errorCode;
+}
+
+#endif // #ifdef U_PORT_CRYPTO_HARDWARE
+
+// End of file
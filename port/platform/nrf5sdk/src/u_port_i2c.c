@@ -470,41 +470,37 @@ int32_t uPortI2cControllerSendReceive(int32_t handle, uint16_t address,
             ((pReceive != NULL) || (bytesToReceive == 0))) {
             errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
             nrfx_twim_enable(&(gI2cData[handle].instance));
-            if (pSend != NULL) {
+            xferDescription.address = (uint8_t) address;
+            if ((pSend != NULL) && (pReceive != NULL)) {
+                // Both: a single EasyDMA transfer with a repeated start
+                xferDescription.type = NRFX_TWIM_XFER_TXRX;
+                xferDescription.primary_length = bytesToSend;
+                xferDescription.p_primary_buf = (uint8_t *) pSend;
+                xferDescription.secondary_length = bytesToReceive;
+                xferDescription.p_secondary_buf = (uint8_t *) pReceive;
+            } else if (pSend != NULL) {
                 xferDescription.type = NRFX_TWIM_XFER_TX;
-                xferDescription.address = (uint8_t) address;
                 xferDescription.primary_length = bytesToSend;
                 xferDescription.p_primary_buf = (uint8_t *) pSend;
-                // Make sure the semaphore is empty
-                uPortSemaphoreTryTake(gI2cData[handle].completionSemaphore, 0);
-                gI2cData[handle].xferErrorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
-                if (nrfx_twim_xfer(&(gI2cData[handle].instance),
-                                   &xferDescription, 0) == NRFX_SUCCESS) {
-                    // Wait for the event handler to give the semaphore
-                    errorCodeOrLength = uPortSemaphoreTryTake(gI2cData[handle].completionSemaphore,
-                                                              gI2cData[handle].timeoutMs * bytesToSend);
-                    if (errorCodeOrLength == 0) {
-                        errorCodeOrLength = gI2cData[handle].xferErrorCode;
-                    }
-                }
-            }
-            if ((errorCodeOrLength == (int32_t) U_ERROR_COMMON_SUCCESS) &&
-                (pReceive != NULL)) {
+            } else if (pReceive != NULL) {
                 xferDescription.type = NRFX_TWIM_XFER_RX;
-                xferDescription.address = (uint8_t) address;
                 xferDescription.primary_length = bytesToReceive;
                 xferDescription.p_primary_buf = (uint8_t *) pReceive;
+            }
+            if ((pSend != NULL) || (pReceive != NULL)) {
                 // Make sure the semaphore is empty
                 uPortSemaphoreTryTake(gI2cData[handle].completionSemaphore, 0);
                 gI2cData[handle].xferErrorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
+                errorCodeOrLength = (int32_t) U_ERROR_COMMON_PLATFORM;
                 if (nrfx_twim_xfer(&(gI2cData[handle].instance),
                                    &xferDescription, 0) == NRFX_SUCCESS) {
                     // Wait for the event handler to give the semaphore
                     errorCodeOrLength = uPortSemaphoreTryTake(gI2cData[handle].completionSemaphore,
-                                                              gI2cData[handle].timeoutMs * bytesToReceive);
+                                                              gI2cData[handle].timeoutMs *
+                                                              (bytesToSend + bytesToReceive));
                     if (errorCodeOrLength == 0) {
                         errorCodeOrLength = gI2cData[handle].xferErrorCode;
-                        if (errorCodeOrLength == 0) {
+                        if ((errorCodeOrLength == 0) && (pReceive != NULL)) {
                             errorCodeOrLength = (int32_t) bytesToReceive;
                         }
                     }
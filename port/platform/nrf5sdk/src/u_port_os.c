@@ -62,6 +62,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // strncmp(), strncpy()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_os_platform_specific.h"
@@ -116,6 +117,7 @@ int32_t uPortTaskCreate(void (*pFunction)(void *),
         if (xTaskCreate(pFunction, pName, stackSizeBytes / 4,
                         pParameter, priority,
                         (TaskHandle_t *) pTaskHandle) == pdPASS) {
+            U_PORT_TASK_STACK_REGISTER(*pTaskHandle, pName, stackSizeBytes);
             errorCode = U_ERROR_COMMON_SUCCESS;
         }
     }
@@ -130,6 +132,7 @@ int32_t uPortTaskDelete(const uPortTaskHandle_t taskHandle)
 
     // Can only delete oneself in freeRTOS
     if (taskHandle == NULL) {
+        U_PORT_TASK_STACK_DEREGISTER(taskHandle);
         vTaskDelete((TaskHandle_t) taskHandle);
         errorCode = U_ERROR_COMMON_SUCCESS;
     }
@@ -179,6 +182,68 @@ int32_t uPortTaskGetHandle(uPortTaskHandle_t *pTaskHandle)
     return (int32_t) errorCode;
 }
 
+// Get the run-time statistics of all tasks.
+int32_t uPortTaskGetRuntimeStats(uPortTaskRuntimeStats_t *pStats,
+                                 size_t maxNumStats,
+                                 int32_t *pIdlePercent)
+{
+    int32_t errorCodeOrNumStats = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#if (configUSE_TRACE_FACILITY == 1) && (configGENERATE_RUN_TIME_STATS == 1)
+    TaskStatus_t *pTaskStatus;
+    UBaseType_t numTasks;
+    uint64_t totalTicks = 0;
+    uint64_t idleTicks = 0;
+    bool isIdle;
+
+    errorCodeOrNumStats = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    if ((pStats != NULL) || (maxNumStats == 0)) {
+        errorCodeOrNumStats = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        // Allow for a few tasks being created while we allocate
+        numTasks = uxTaskGetNumberOfTasks() + 4;
+        pTaskStatus = (TaskStatus_t *) pvPortMalloc(sizeof(TaskStatus_t) * numTasks);
+        if (pTaskStatus != NULL) {
+            numTasks = uxTaskGetSystemState(pTaskStatus, numTasks, NULL);
+            for (size_t x = 0; x < numTasks; x++) {
+                totalTicks += pTaskStatus[x].ulRunTimeCounter;
+                // The idle task(s) are called "IDLE", maybe followed
+                // by the core number
+                if (strncmp(pTaskStatus[x].pcTaskName, "IDLE", 4) == 0) {
+                    idleTicks += pTaskStatus[x].ulRunTimeCounter;
+                }
+            }
+            errorCodeOrNumStats = 0;
+            for (size_t x = 0; (x < numTasks) && (x < maxNumStats); x++) {
+                isIdle = (strncmp(pTaskStatus[x].pcTaskName, "IDLE", 4) == 0);
+                pStats->taskHandle = (uPortTaskHandle_t) pTaskStatus[x].xHandle;
+                strncpy(pStats->name, pTaskStatus[x].pcTaskName, sizeof(pStats->name));
+                pStats->name[sizeof(pStats->name) - 1] = 0;
+                pStats->runtimeTicks = pTaskStatus[x].ulRunTimeCounter;
+                pStats->percent = 0;
+                if (totalTicks > 0) {
+                    pStats->percent = (int32_t) ((pStats->runtimeTicks * 100) / totalTicks);
+                }
+                pStats->isIdle = isIdle;
+                pStats++;
+                errorCodeOrNumStats++;
+            }
+            if (pIdlePercent != NULL) {
+                *pIdlePercent = 0;
+                if (totalTicks > 0) {
+                    *pIdlePercent = (int32_t) ((idleTicks * 100) / totalTicks);
+                }
+            }
+            vPortFree(pTaskStatus);
+        }
+    }
+#else
+    (void) pStats;
+    (void) maxNumStats;
+    (void) pIdlePercent;
+#endif
+
+    return errorCodeOrNumStats;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: QUEUES
  * -------------------------------------------------------------- */
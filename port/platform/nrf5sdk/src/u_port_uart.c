@@ -69,7 +69,7 @@
 
 #include "limits.h" // For INT_MAX
 #include "stdlib.h" // For malloc()/free()
-#include "string.h" // For memcpy()
+#include "string.h" // For memcpy(), memset()
 
 /* Design note: it took ages to get this to work.
  * Rx DMA length is set to 1 byte because UART H/W must notify the
@@ -141,6 +141,7 @@ typedef struct {
     bool disableTxIrq;
     uPortSemaphoreHandle_t txSem;
     uPortQueueHandle_t txQueueHandle;
+    uPortUartStats_t stats;
 } uPortUartData_t;
 
 /** Structure describing an event.
@@ -148,6 +149,7 @@ typedef struct {
 typedef struct {
     int32_t uartHandle;
     uint32_t eventBitMap;
+    int32_t timeMs; /**< when the event was sent, for the latency statistic. */
 } uPortUartEvent_t;
 
 typedef struct {
@@ -217,6 +219,8 @@ static uint32_t uartGetRxdBytes(uPortUartData_t *pUartData)
 static void eventHandler(void *pParam, size_t paramLength)
 {
     uPortUartEvent_t *pEvent = (uPortUartEvent_t *) pParam;
+    uPortUartData_t *pUartData;
+    int32_t latencyMs;
 
     (void) paramLength;
 
@@ -229,6 +233,11 @@ static void eventHandler(void *pParam, size_t paramLength)
     if ((pEvent->uartHandle >= 0) &&
         (pEvent->uartHandle < sizeof(gUartData) / sizeof(gUartData[0]))) {
         if (gUartData[pEvent->uartHandle].pEventCallback != NULL) {
+            pUartData = &gUartData[pEvent->uartHandle];
+            latencyMs = uPortGetTickTimeMs() - pEvent->timeMs;
+            if (latencyMs > pUartData->stats.eventCallbackLatencyMaxMs) {
+                pUartData->stats.eventCallbackLatencyMaxMs = latencyMs;
+            }
             gUartData[pEvent->uartHandle].pEventCallback(pEvent->uartHandle,
                                                          pEvent->eventBitMap,
                                                          gUartData[pEvent->uartHandle].pEventCallbackParam);
@@ -309,6 +318,7 @@ static void userNotify(uPortUartData_t *pUartData)
         uPortUartEvent_t event;
         event.uartHandle = pUartData->uartHandle;
         event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
+        event.timeMs = uPortGetTickTimeMs();
         uPortEventQueueSendIrq(pUartData->eventQueueHandle,
                                &event, sizeof(event));
     }
@@ -361,6 +371,8 @@ static void uartIrqHandler(uPortUartData_t *pUartData)
 {
     NRF_UARTE_Type *pReg = pUartData->pReg;
     bool read = false;
+    uint32_t errorSrc;
+    size_t waiting;
 
     if (nrf_uarte_int_enable_check(pReg, NRF_UARTE_INT_ENDTX_MASK) &&
         nrf_uarte_event_check(pReg, NRF_UARTE_EVENT_ENDTX)) {
@@ -379,6 +391,13 @@ static void uartIrqHandler(uPortUartData_t *pUartData)
 
     if (nrf_uarte_event_check(pReg, NRF_UARTE_EVENT_ERROR)) {
         nrf_uarte_event_clear(pReg, NRF_UARTE_EVENT_ERROR);
+        errorSrc = nrf_uarte_errorsrc_get_and_clear(pReg);
+        if (errorSrc & NRF_UARTE_ERROR_OVERRUN_MASK) {
+            pUartData->stats.rxOverrunErrors++;
+        }
+        if (errorSrc & (NRF_UARTE_ERROR_PARITY_MASK | NRF_UARTE_ERROR_FRAMING_MASK)) {
+            pUartData->stats.rxFramingErrors++;
+        }
     }
 
     // Handle Rx
@@ -390,23 +409,36 @@ static void uartIrqHandler(uPortUartData_t *pUartData)
 
                 pUartData->bufferWrite++;
                 pUartData->bufferWrite %= pUartData->rxBufferSizeBytes;
+                pUartData->stats.rxBytes++;
                 read = true;
                 // Stop Rx interrupt when there is no more space
                 // Rx interrupts will be renabled in the uPortUartRead
                 if (pUartData->bufferWrite == pUartData->bufferRead) {
                     pUartData->bufferFull = true;
+                    pUartData->stats.rxBufferOverflows++;
                     nrf_uarte_int_disable(pReg, NRF_UARTE_INT_ENDRX_MASK);
                     break;
                 }
             }
 
             if (read) {
+                waiting = uartGetRxdBytes(pUartData);
+                if (waiting > pUartData->stats.rxBufferHighWaterMark) {
+                    pUartData->stats.rxBufferHighWaterMark = waiting;
+                }
                 //signal the user to read
                 userNotify(pUartData);
             }
         }
     }
 
+    // The NCTS event is set, whether its interrupt is enabled
+    // or not, each time the far end de-asserts CTS
+    if (nrf_uarte_event_check(pReg, NRF_UARTE_EVENT_NCTS)) {
+        nrf_uarte_event_clear(pReg, NRF_UARTE_EVENT_NCTS);
+        pUartData->stats.ctsStalls++;
+    }
+
     // Handle Tx
     if (pUartData->disableTxIrq == false &&
         nrf_uarte_int_enable_check(pReg, NRF_UARTE_INT_TXSTOPPED_MASK) &&
@@ -613,6 +645,7 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
                 gUartData[uart].bufferRead = 0;
                 gUartData[uart].bufferWrite = 0;
                 gUartData[uart].bufferFull = false;
+                memset(&gUartData[uart].stats, 0, sizeof(gUartData[uart].stats));
                 uPortSemaphoreCreate(&gUartData[uart].txSem, 0, 1);
                 nrf_uarte_disable(pReg);
                 // Set baud rate
@@ -759,6 +792,95 @@ int32_t uPortUartRead(int32_t handle, void *pBuffer,
     return (int32_t) sizeOrErrorCode;
 }
 
+// Get a pointer to received data, straight from the Rx buffer.
+int32_t uPortUartReadSpan(int32_t handle, const char **ppData)
+{
+    uErrorCode_t sizeOrErrorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        sizeOrErrorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((ppData != NULL) && (handle >= 0) &&
+            (handle < sizeof(gUartData) / sizeof(gUartData[0])) &&
+            (gUartData[handle].pRxBuff != NULL)) {
+            pUartData = &gUartData[handle];
+            *ppData = (const char *) pUartData->pRxBuff + pUartData->bufferRead;
+            // No of bytes available to read, limited to those
+            // before the end of the buffer: the rest, from the
+            // start of the buffer, is the next span
+            sizeOrErrorCode = uartGetRxdBytes(pUartData);
+            if (sizeOrErrorCode > pUartData->rxBufferSizeBytes - pUartData->bufferRead) {
+                sizeOrErrorCode = pUartData->rxBufferSizeBytes - pUartData->bufferRead;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return (int32_t) sizeOrErrorCode;
+}
+
+// Release data returned by uPortUartReadSpan().
+int32_t uPortUartReleaseSpan(int32_t handle, size_t sizeBytes)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((handle >= 0) &&
+            (handle < sizeof(gUartData) / sizeof(gUartData[0])) &&
+            (gUartData[handle].pRxBuff != NULL)) {
+            pUartData = &gUartData[handle];
+            if ((sizeBytes <= uartGetRxdBytes(pUartData)) &&
+                (sizeBytes <= pUartData->rxBufferSizeBytes - pUartData->bufferRead)) {
+                if (sizeBytes > 0) {
+                    pUartData->bufferRead += sizeBytes;
+                    pUartData->bufferRead %= pUartData->rxBufferSizeBytes;
+                    // Reset buffer full condition and renable
+                    // Rx interrupts, as uPortUartRead() does
+                    pUartData->bufferFull = false;
+                    nrf_uarte_int_enable(pUartData->pReg, NRF_UARTE_INT_ENDRX_MASK);
+                }
+                errorCode = U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return (int32_t) errorCode;
+}
+
+// Get the statistics of a UART.
+int32_t uPortUartGetStats(int32_t handle, uPortUartStats_t *pStats)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pStats != NULL) && (handle >= 0) &&
+            (handle < sizeof(gUartData) / sizeof(gUartData[0])) &&
+            (gUartData[handle].pRxBuff != NULL)) {
+            *pStats = gUartData[handle].stats;
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return (int32_t) errorCode;
+}
+
 // Write to the given UART interface.
 int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
                        size_t sizeBytes)
@@ -786,6 +908,7 @@ int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
             uPortQueueSend(txQueueHandle, (void *)&txData);
             nrf_uarte_int_enable(pReg, NRF_UARTE_INT_TXSTOPPED_MASK);
             uPortSemaphoreTake(gUartData[handle].txSem);
+            gUartData[handle].stats.txBytes += sizeBytes;
             U_PORT_MUTEX_UNLOCK(gMutex);
             sizeOrErrorCode = sizeBytes;
         }
@@ -939,6 +1062,7 @@ int32_t uPortUartEventSend(int32_t handle, uint32_t eventBitMap)
             (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
             event.uartHandle = handle;
             event.eventBitMap = eventBitMap;
+            event.timeMs = uPortGetTickTimeMs();
             errorCode = uPortEventQueueSend(gUartData[handle].eventQueueHandle,
                                             &event, sizeof(event));
         }
@@ -969,6 +1093,7 @@ int32_t uPortUartEventTrySend(int32_t handle, uint32_t eventBitMap,
             (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
             event.uartHandle = handle;
             event.eventBitMap = eventBitMap;
+            event.timeMs = uPortGetTickTimeMs();
             do {
                 // Push an event to event queue, IRQ version so as not to block
                 errorCode = uPortEventQueueSendIrq(gUartData[handle].eventQueueHandle,
@@ -31,6 +31,7 @@
 #include "u_port_gpio.h"
 #include "u_port_uart.h"
 #include "u_port_i2c.h"
+#include "u_port_spi.h"
 #include "u_port_event_queue.h"
 #include "u_port_crypto.h"
 
@@ -119,6 +120,15 @@ int32_t uPortTaskGetHandle(uPortTaskHandle_t *pTaskHandle)
     (void) pTaskHandle;
     return 0;
 }
+int32_t uPortTaskGetRuntimeStats(uPortTaskRuntimeStats_t *pStats,
+                                 size_t maxNumStats,
+                                 int32_t *pIdlePercent)
+{
+    (void) pStats;
+    (void) maxNumStats;
+    (void) pIdlePercent;
+    return 0;
+}
 int32_t uPortQueueCreate(size_t queueLength,
                          size_t itemSizeBytes,
                          uPortQueueHandle_t *pQueueHandle)
@@ -306,6 +316,17 @@ int32_t uPortGpioGet(int32_t pin)
     (void) pin;
     return 0;
 }
+int32_t uPortGpioInterruptSet(int32_t pin, bool risingEdge,
+                              void (*pCallback) (int32_t pin,
+                                                 void *pCallbackParam),
+                              void *pCallbackParam)
+{
+    (void) pin;
+    (void) risingEdge;
+    (void) pCallback;
+    (void) pCallbackParam;
+    return 0;
+}
 
 // From u_port_uart.h
 int32_t uPortUartInit()
@@ -509,6 +530,51 @@ int32_t uPortI2cControllerSend(int32_t handle, uint16_t address,
     return 0;
 }
 
+// From u_port_spi.h
+int32_t uPortSpiInit()
+{
+    return 0;
+}
+void uPortSpiDeinit()
+{
+}
+int32_t uPortSpiOpen(int32_t spi, int32_t pinMosi, int32_t pinMiso,
+                     int32_t pinClk, int32_t pinSelect)
+{
+    (void) spi;
+    (void) pinMosi;
+    (void) pinMiso;
+    (void) pinClk;
+    (void) pinSelect;
+    return 0;
+}
+void uPortSpiClose(int32_t handle)
+{
+    (void) handle;
+}
+int32_t uPortSpiControllerSetClock(int32_t handle, int32_t clockHertz)
+{
+    (void) handle;
+    (void) clockHertz;
+    return 0;
+}
+int32_t uPortSpiControllerGetClock(int32_t handle)
+{
+    (void) handle;
+    return 0;
+}
+int32_t uPortSpiControllerSendReceiveBlock(int32_t handle,
+                                           const char *pSend,
+                                           char *pReceive,
+                                           size_t size)
+{
+    (void) handle;
+    (void) pSend;
+    (void) pReceive;
+    (void) size;
+    return 0;
+}
+
 // From u_port_crypto.h.
 int32_t uPortCryptoSha256(const char *pInput,
                           size_t inputLengthBytes,
@@ -519,6 +585,26 @@ int32_t uPortCryptoSha256(const char *pInput,
     (void) pOutput;
     return 0;
 }
+int32_t uPortCryptoSha256Start(void **ppContext)
+{
+    (void) ppContext;
+    return 0;
+}
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    (void) pContext;
+    (void) pInput;
+    (void) inputLengthBytes;
+    return 0;
+}
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    (void) pContext;
+    (void) pOutput;
+    return 0;
+}
 int32_t uPortCryptoHmacSha256(const char *pKey,
                               size_t keyLengthBytes,
                               const char *pInput,
@@ -0,0 +1,187 @@
+#!/usr/bin/env python
+
+'''Report the static flash/RAM sizes of ubxlib per subsystem, optionally against a baseline.'''
+
+import os           # For sep(), walk()
+import sys
+import json
+import argparse
+import subprocess
+
+# The version of the JSON report format
+REPORT_VERSION = 1
+
+# Directories at the top of the ubxlib tree that are
+# subsystems in their own right; under "common" each
+# sub-directory is a subsystem (at_client, sock, etc.)
+TOP_LEVEL_SUBSYSTEMS = ["ble", "cell", "gnss", "short_range", "wifi", "port"]
+
+# The subsystem that the static_size stubs are assigned to
+STUBS_SUBSYSTEM = "stubs"
+
+# Path of this directory relative to the ubxlib root,
+# used to spot the stubs
+STATIC_SIZE_DIR = "port/platform/static_size"
+
+def subsystem_get(relative_path):
+    '''Return the subsystem an object file belongs to from its path relative to the object directory'''
+    subsystem = "other"
+    path = relative_path.replace(os.sep, "/")
+    parts = path.split("/")
+    if path.startswith(STATIC_SIZE_DIR + "/"):
+        subsystem = STUBS_SUBSYSTEM
+    elif parts[0] == "common" and len(parts) > 2:
+        subsystem = parts[1]
+    elif parts[0] in TOP_LEVEL_SUBSYSTEMS:
+        subsystem = parts[0]
+    return subsystem
+
+def object_files_get(obj_dir):
+    '''Return a list of all of the object files below obj_dir'''
+    object_files = []
+    for root, _directories, files in os.walk(obj_dir):
+        for file in files:
+            if file.endswith(".o"):
+                object_files.append(os.path.join(root, file))
+    return sorted(object_files)
+
+def sizes_get(size_exe, object_files):
+    '''Run the size utility in Berkeley format on the object files, returning text/data/bss per file'''
+    sizes = {}
+    output = subprocess.check_output([size_exe, "-B"] + object_files,
+                                     universal_newlines=True)
+    # Berkeley format is a header line followed by
+    # "   text    data     bss     dec     hex filename"
+    for line in output.splitlines()[1:]:
+        fields = line.split(None, 5)
+        if len(fields) == 6:
+            sizes[fields[5].strip()] = {"text": int(fields[0]),
+                                        "data": int(fields[1]),
+                                        "bss": int(fields[2])}
+    return sizes
+
+def report_create(size_exe, obj_dir, configuration):
+    '''Create the report dictionary: flash is text + data, RAM is data + bss'''
+    subsystems = {}
+    total = {"flash": 0, "ram": 0}
+    object_files = object_files_get(obj_dir)
+    if object_files:
+        for object_file, size in sizes_get(size_exe, object_files).items():
+            name = subsystem_get(os.path.relpath(object_file, obj_dir))
+            if name not in subsystems:
+                subsystems[name] = {"flash": 0, "ram": 0}
+            flash = size["text"] + size["data"]
+            ram = size["data"] + size["bss"]
+            subsystems[name]["flash"] += flash
+            subsystems[name]["ram"] += ram
+            total["flash"] += flash
+            total["ram"] += ram
+    return {"version": REPORT_VERSION,
+            "configuration": configuration,
+            "subsystems": subsystems,
+            "total": total}
+
+def delta_string(value, baseline_value):
+    '''Return a printable difference from a baseline value'''
+    string = ""
+    if baseline_value is not None:
+        delta = value - baseline_value
+        string = "{:+d}".format(delta)
+        if baseline_value > 0:
+            string += " ({:+.1f}%)".format(delta * 100 / baseline_value)
+    return string
+
+def report_print(report, baseline):
+    '''Print the report as a table, with the differences from the baseline if there is one'''
+    baseline_subsystems = {}
+    baseline_total = {}
+    if baseline:
+        baseline_subsystems = baseline["subsystems"]
+        baseline_total = baseline["total"]
+        if baseline["configuration"] != report["configuration"]:
+            print("WARNING: baseline configuration \"{}\" is not the same as"  \
+                  " this configuration \"{}\".".format(baseline["configuration"],
+                                                       report["configuration"]))
+    print("Static sizes for configuration \"{}\":".format(report["configuration"]))
+    print("{:<20} {:>8} {:>18} {:>8} {:>18}".format("subsystem", "flash",
+                                                   "vs baseline" if baseline else "",
+                                                   "RAM",
+                                                   "vs baseline" if baseline else "").rstrip())
+    # Include subsystems that have disappeared since the baseline
+    names = sorted(set(report["subsystems"]) | set(baseline_subsystems))
+    for name in names:
+        sizes = report["subsystems"].get(name, {"flash": 0, "ram": 0})
+        baseline_sizes = baseline_subsystems.get(name, {})
+        if baseline and not baseline_sizes:
+            baseline_sizes = {"flash": 0, "ram": 0}
+        print("{:<20} {:>8} {:>18} {:>8} {:>18}".format(name, sizes["flash"],
+                                                       delta_string(sizes["flash"],
+                                                                    baseline_sizes.get("flash")),
+                                                       sizes["ram"],
+                                                       delta_string(sizes["ram"],
+                                                                    baseline_sizes.get("ram"))))
+    print("{:<20} {:>8} {:>18} {:>8} {:>18}".format("TOTAL", report["total"]["flash"],
+                                                   delta_string(report["total"]["flash"],
+                                                                baseline_total.get("flash")),
+                                                   report["total"]["ram"],
+                                                   delta_string(report["total"]["ram"],
+                                                                baseline_total.get("ram"))))
+
+def growth_check(report, baseline, max_increase_percent):
+    '''Return a list of the subsystems that have grown by more than max_increase_percent'''
+    grown = []
+    for name, sizes in report["subsystems"].items():
+        baseline_sizes = baseline["subsystems"].get(name)
+        if baseline_sizes:
+            for key in ["flash", "ram"]:
+                limit = baseline_sizes[key] * (100 + max_increase_percent) / 100
+                if sizes[key] > limit:
+                    grown.append("{} {} {} -> {}".format(name, key,
+                                                         baseline_sizes[key],
+                                                         sizes[key]))
+    return grown
+
+def main():
+    '''Entry point'''
+    return_value = 0
+    parser = argparse.ArgumentParser(description="Report the static flash/RAM"   \
+                                     " sizes of ubxlib per subsystem.")
+    parser.add_argument("obj_dir", help="the directory containing the object"    \
+                        " files of the build, laid out as in the ubxlib tree.")
+    parser.add_argument("-s", dest="size_exe", default="arm-none-eabi-size",
+                        help="the size utility to use.")
+    parser.add_argument("-c", dest="configuration", default="",
+                        help="a string describing the configuration built, e.g."  \
+                        " the features and #defines.")
+    parser.add_argument("-o", dest="output_file", help="write the report, in JSON"  \
+                        " form, to this file.")
+    parser.add_argument("-b", dest="baseline_file", help="compare against this"  \
+                        " baseline report, as previously written with -o.")
+    parser.add_argument("-m", dest="max_increase_percent", type=float,
+                        help="return an error if any subsystem has grown by more"  \
+                        " than this percentage compared with the baseline.")
+    args = parser.parse_args()
+
+    report = report_create(args.size_exe, args.obj_dir, args.configuration)
+    baseline = None
+    if args.baseline_file:
+        if os.path.isfile(args.baseline_file):
+            with open(args.baseline_file, "r", encoding="utf8") as file:
+                baseline = json.load(file)
+        else:
+            print("WARNING: baseline file \"{}\" not found.".format(args.baseline_file))
+    report_print(report, baseline)
+    if args.output_file:
+        with open(args.output_file, "w", encoding="utf8") as file:
+            json.dump(report, file, indent=2, sort_keys=True)
+    if baseline and args.max_increase_percent is not None:
+        grown = growth_check(report, baseline, args.max_increase_percent)
+        for item in grown:
+            print("ERROR: {} has grown by more than {}%.".format(item,
+                                                                args.max_increase_percent))
+        if grown:
+            return_value = 1
+    return return_value
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -16,12 +16,14 @@ PLATFORM_PATH = $(UBXLIB_BASE)/platform/stm32cube/mcu/stm32f4
 UBXLIB_SRC += \
 	$(UBXLIB_BASE)/port/clib/u_port_clib_mktime64.c \
 	$(UBXLIB_BASE)/port/platform/common/mbedtls/u_port_crypto.c \
+	$(PLATFORM_PATH)/src/u_port_crypto.c \
 	$(PLATFORM_PATH)/src/u_port_debug.c \
 	$(PLATFORM_PATH)/src/u_port_gpio.c \
 	$(PLATFORM_PATH)/src/u_port_os.c \
 	$(PLATFORM_PATH)/src/u_port_private.c \
 	$(PLATFORM_PATH)/src/u_port_uart.c \
 	$(PLATFORM_PATH)/src/u_port_i2c.c \
+	$(PLATFORM_PATH)/src/u_port_spi.c \
 	$(PLATFORM_PATH)/src/u_port.c \
 	$(PLATFORM_PATH)/src/heap_useNewlib.c
 
@@ -31,6 +33,7 @@ UBXLIB_ASM += \
 UBXLIB_INC += \
 	$(UBXLIB_PRIVATE_INC) \
 	$(UBXLIB_BASE)/port/clib \
+	$(UBXLIB_BASE)/port/platform/common/mbedtls \
 	$(PLATFORM_PATH)/src \
 	$(PLATFORM_PATH)
 
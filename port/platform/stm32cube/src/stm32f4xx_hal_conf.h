@@ -85,6 +85,11 @@ extern "C" {
 #define HAL_FLASH_MODULE_ENABLED
 #define HAL_PWR_MODULE_ENABLED
 #define HAL_CORTEX_MODULE_ENABLED
+#ifdef U_PORT_CRYPTO_HARDWARE
+/* The HASH and CRYP peripherals are used by u_port_crypto.c */
+#define HAL_CRYP_MODULE_ENABLED
+#define HAL_HASH_MODULE_ENABLED
+#endif
 
 /* ########################## HSE/HSI Values adaptation ##################### */
 /**
@@ -0,0 +1,335 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Implementation of the crypto API for the STM32F4 platform
+ * using the HASH and CRYP peripherals of the STM32F43x/STM32F439
+ * parts.  Only compiled in if U_PORT_CRYPTO_HARDWARE is defined,
+ * otherwise the mbedTLS implementation in
+ * port/platform/common/mbedtls is used.  Anything the peripherals
+ * can't do (e.g. a zero-length input, an unaligned AES buffer) or
+ * a call made while the peripheral is in use by another task falls
+ * back to mbedTLS.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#ifdef U_PORT_CRYPTO_HARDWARE
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy()
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_crypto.h"
+
+#include "u_port_crypto_mbedtls.h"
+
+#include "stm32f4xx_hal.h" // Brings in the HASH and CRYP HAL, see stm32f4xx_hal_conf.h
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_CRYPTO_HARDWARE_TIMEOUT_MS
+/** How long to wait for the HASH or CRYP peripheral to complete
+ * an operation.
+ */
+# define U_PORT_CRYPTO_HARDWARE_TIMEOUT_MS 1000
+#endif
+
+/** The length of an AES 128 key.
+ */
+#define U_PORT_CRYPTO_AES128_KEY_LENGTH_BYTES 16
+
+/** The length of an AES block.
+ */
+#define U_PORT_CRYPTO_AES_BLOCK_LENGTH_BYTES 16
+
+/** The largest input the CRYP HAL can handle in one go: the size
+ * parameter is 16 bits.
+ */
+#define U_PORT_CRYPTO_CRYP_MAX_LENGTH_BYTES 0xFFF0
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Set while the HASH peripheral is in use.
+ */
+static volatile bool gHashBusy = false;
+
+/** Set while the CRYP peripheral is in use.
+ */
+static volatile bool gCrypBusy = false;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Claim a peripheral, returning false if it is already in use:
+// the caller will then fall back to mbedTLS rather than wait.
+static bool claim(volatile bool *pBusy)
+{
+    bool claimed = false;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (!*pBusy) {
+        *pBusy = true;
+        claimed = true;
+    }
+    __set_PRIMASK(primask);
+
+    return claimed;
+}
+
+// Pack a 16 byte array into four words, first byte most
+// significant, which is how the CRYP peripheral wants the key and
+// initialisation vector.
+static void packWords(const char *pBytes, uint32_t *pWords)
+{
+    const uint8_t *pIn = (const uint8_t *) pBytes;
+
+    for (size_t x = 0; x < 4; x++) {
+        *(pWords + x) = ((uint32_t) *pIn << 24) | ((uint32_t) *(pIn + 1) << 16) |
+                        ((uint32_t) *(pIn + 2) << 8) | (uint32_t) *(pIn + 3);
+        pIn += 4;
+    }
+}
+
+// Perform an HMAC SHA256 (if pKey is not NULL) or a plain SHA256
+// using the HASH peripheral, returning true if it was done.
+static bool hashSha256(const char *pKey, size_t keyLengthBytes,
+                       const char *pInput, size_t inputLengthBytes,
+                       char *pOutput)
+{
+    bool done = false;
+    HASH_HandleTypeDef handle = {0};
+    HAL_StatusTypeDef status;
+
+    if ((inputLengthBytes > 0) && (pInput != NULL) && (pOutput != NULL) &&
+        ((pKey == NULL) || (keyLengthBytes > 0)) && claim(&gHashBusy)) {
+        __HAL_RCC_HASH_CLK_ENABLE();
+        handle.Init.DataType = HASH_DATATYPE_8B;
+        if (pKey != NULL) {
+            handle.Init.KeySize = keyLengthBytes;
+            handle.Init.pKey = (uint8_t *) pKey;
+        }
+        status = HAL_HASH_Init(&handle);
+        if (status == HAL_OK) {
+            if (pKey != NULL) {
+                status = HAL_HMACEx_SHA256_Start(&handle, (uint8_t *) pInput,
+                                                 inputLengthBytes, (uint8_t *) pOutput,
+                                                 U_PORT_CRYPTO_HARDWARE_TIMEOUT_MS);
+            } else {
+                status = HAL_HASHEx_SHA256_Start(&handle, (uint8_t *) pInput,
+                                                 inputLengthBytes, (uint8_t *) pOutput,
+                                                 U_PORT_CRYPTO_HARDWARE_TIMEOUT_MS);
+            }
+            done = (status == HAL_OK);
+            HAL_HASH_DeInit(&handle);
+        }
+        __HAL_RCC_HASH_CLK_DISABLE();
+        gHashBusy = false;
+    }
+
+    return done;
+}
+
+// Perform AES 128 CBC encryption or decryption using the CRYP
+// peripheral, returning true if it was done.  The CRYP HAL reads
+// and writes the data as words, hence the alignment requirement.
+static bool crypAes128Cbc(bool encrypt, const char *pKey, size_t keyLengthBytes,
+                          char *pInitVector, const char *pInput,
+                          size_t lengthBytes, char *pOutput)
+{
+    bool done = false;
+    CRYP_HandleTypeDef handle = {0};
+    uint32_t key[U_PORT_CRYPTO_AES128_KEY_LENGTH_BYTES / sizeof(uint32_t)];
+    uint32_t iv[U_PORT_CRYPTO_AES128_INITIALISATION_VECTOR_LENGTH_BYTES / sizeof(uint32_t)];
+    char nextIv[U_PORT_CRYPTO_AES128_INITIALISATION_VECTOR_LENGTH_BYTES];
+    HAL_StatusTypeDef status = HAL_ERROR;
+
+    if ((pKey != NULL) && (keyLengthBytes == U_PORT_CRYPTO_AES128_KEY_LENGTH_BYTES) &&
+        (pInitVector != NULL) && (pInput != NULL) && (pOutput != NULL) &&
+        (lengthBytes > 0) && (lengthBytes % U_PORT_CRYPTO_AES_BLOCK_LENGTH_BYTES == 0) &&
+        (lengthBytes <= U_PORT_CRYPTO_CRYP_MAX_LENGTH_BYTES) &&
+        (((uintptr_t) pInput) % sizeof(uint32_t) == 0) &&
+        (((uintptr_t) pOutput) % sizeof(uint32_t) == 0) && claim(&gCrypBusy)) {
+        packWords(pKey, key);
+        packWords(pInitVector, iv);
+        if (!encrypt) {
+            // When decrypting the next initialisation vector is the
+            // last block of the input, which may be overwritten
+            memcpy(nextIv, pInput + lengthBytes - sizeof(nextIv), sizeof(nextIv));
+        }
+        __HAL_RCC_CRYP_CLK_ENABLE();
+        handle.Instance = CRYP;
+        handle.Init.DataType = CRYP_DATATYPE_8B;
+        handle.Init.KeySize = CRYP_KEYSIZE_128B;
+        handle.Init.pKey = key;
+        handle.Init.pInitVect = iv;
+        handle.Init.Algorithm = CRYP_AES_CBC;
+#ifdef CRYP_DATAWIDTHUNIT_BYTE
+        handle.Init.DataWidthUnit = CRYP_DATAWIDTHUNIT_BYTE;
+#endif
+        if (HAL_CRYP_Init(&handle) == HAL_OK) {
+#ifndef CRYP_DATAWIDTHUNIT_BYTE
+            // Older HALs take the size in words
+            lengthBytes /= sizeof(uint32_t);
+#endif
+            if (encrypt) {
+                status = HAL_CRYP_Encrypt(&handle, (uint32_t *) pInput,
+                                          (uint16_t) lengthBytes, (uint32_t *) pOutput,
+                                          U_PORT_CRYPTO_HARDWARE_TIMEOUT_MS);
+            } else {
+                status = HAL_CRYP_Decrypt(&handle, (uint32_t *) pInput,
+                                          (uint16_t) lengthBytes, (uint32_t *) pOutput,
+                                          U_PORT_CRYPTO_HARDWARE_TIMEOUT_MS);
+            }
+#ifndef CRYP_DATAWIDTHUNIT_BYTE
+            lengthBytes *= sizeof(uint32_t);
+#endif
+            HAL_CRYP_DeInit(&handle);
+        }
+        __HAL_RCC_CRYP_CLK_DISABLE();
+        gCrypBusy = false;
+        if (status == HAL_OK) {
+            // Update the initialisation vector exactly as mbedTLS would
+            if (encrypt) {
+                memcpy(nextIv, pOutput + lengthBytes - sizeof(nextIv), sizeof(nextIv));
+            }
+            memcpy(pInitVector, nextIv, sizeof(nextIv));
+            done = true;
+        }
+    }
+
+    return done;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Perform a SHA256 calculation on a block of data.
+int32_t uPortCryptoSha256(const char *pInput,
+                          size_t inputLengthBytes,
+                          char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (!hashSha256(NULL, 0, pInput, inputLengthBytes, pOutput)) {
+        errorCode = uPortCryptoMbedtlsSha256(pInput, inputLengthBytes, pOutput);
+    }
+
+    return errorCode;
+}
+
+// Start a SHA256 calculation: the hardware is only used for
+// one-shot calculations, which don't tie it up, so this is done
+// with mbedTLS.
+int32_t uPortCryptoSha256Start(void **ppContext)
+{
+    return uPortCryptoMbedtlsSha256Start(ppContext);
+}
+
+// Add data to a SHA256 calculation.
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    return uPortCryptoMbedtlsSha256Update(pContext, pInput,
+                                          inputLengthBytes);
+}
+
+// Complete a SHA256 calculation.
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    return uPortCryptoMbedtlsSha256Finish(pContext, pOutput);
+}
+
+// Perform a HMAC SHA256 calculation on a block of data.
+int32_t uPortCryptoHmacSha256(const char *pKey,
+                              size_t keyLengthBytes,
+                              const char *pInput,
+                              size_t inputLengthBytes,
+                              char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if ((pKey == NULL) ||
+        !hashSha256(pKey, keyLengthBytes, pInput, inputLengthBytes, pOutput)) {
+        errorCode = uPortCryptoMbedtlsHmacSha256(pKey, keyLengthBytes,
+                                                 pInput, inputLengthBytes,
+                                                 pOutput);
+    }
+
+    return errorCode;
+}
+
+// Perform AES 128 CBC encryption of a block of data.
+int32_t uPortCryptoAes128CbcEncrypt(const char *pKey,
+                                    size_t keyLengthBytes,
+                                    char *pInitVector,
+                                    const char *pInput,
+                                    size_t lengthBytes,
+                                    char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (!crypAes128Cbc(true, pKey, keyLengthBytes, pInitVector,
+                       pInput, lengthBytes, pOutput)) {
+        errorCode = uPortCryptoMbedtlsAes128CbcEncrypt(pKey, keyLengthBytes,
+                                                       pInitVector, pInput,
+                                                       lengthBytes, pOutput);
+    }
+
+    return errorCode;
+}
+
+// Perform AES 128 CBC decryption of a block of data.
+int32_t uPortCryptoAes128CbcDecrypt(const char *pKey,
+                                    size_t keyLengthBytes,
+                                    char *pInitVector,
+                                    const char *pInput,
+                                    size_t lengthBytes,
+                                    char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (!crypAes128Cbc(false, pKey, keyLengthBytes, pInitVector,
+                       pInput, lengthBytes, pOutput)) {
+        errorCode = uPortCryptoMbedtlsAes128CbcDecrypt(pKey, keyLengthBytes,
+                                                       pInitVector, pInput,
+                                                       lengthBytes, pOutput);
+    }
+
+    return errorCode;
+}
+
+#endif // #ifdef U_PORT_CRYPTO_HARDWARE
+
+// End of file
@@ -863,9 +863,15 @@ int32_t uPortI2cControllerSendReceive(int32_t handle, uint16_t address,
             pReg = gI2cData[handle].pReg;
             errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
             if (pSend != NULL) {
+                // If there is to be a receive, no stop, so that the
+                // receive follows with a repeated start
                 errorCodeOrLength = send(pReg, address, pSend, bytesToSend,
-                                         gI2cData[handle].timeoutMs, false,
+                                         gI2cData[handle].timeoutMs, (pReceive != NULL),
                                          &(gI2cData[handle].ignoreBusy));
+                if ((errorCodeOrLength == 0) && (pReceive != NULL)) {
+                    // Ignore the busy flag since we haven't sent a stop
+                    gI2cData[handle].ignoreBusy = true;
+                }
             }
             if ((errorCodeOrLength == 0) && (pReceive != NULL)) {
                 errorCodeOrLength = receive(pReg, address, pReceive, bytesToReceive,
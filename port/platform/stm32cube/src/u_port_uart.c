@@ -130,6 +130,7 @@ typedef struct uPortUartData_t {
     volatile bool userNeedsNotify; /**!< set this if there is no data to read
                                     * so that the user is notified when new
                                     * data arrives. */
+    uPortUartStats_t stats;
     struct uPortUartData_t *pNext;
 } uPortUartData_t;
 
@@ -138,6 +139,7 @@ typedef struct uPortUartData_t {
 typedef struct {
     int32_t uartHandle;
     uint32_t eventBitMap;
+    int32_t timeMs; /**< when the event was sent, for the latency statistic. */
 } uPortUartEvent_t;
 
 /** Function pointers for STM32Cube functions
@@ -536,6 +538,7 @@ static void eventHandler(void *pParam, size_t paramLength)
 {
     uPortUartEvent_t *pEvent = (uPortUartEvent_t *) pParam;
     uPortUartData_t *pUartData;
+    int32_t latencyMs;
 
     (void) paramLength;
 
@@ -547,6 +550,10 @@ static void eventHandler(void *pParam, size_t paramLength)
 
     pUartData = pGetUartDataByHandle(pEvent->uartHandle);
     if ((pUartData != NULL) && (pUartData->pEventCallback != NULL)) {
+        latencyMs = uPortGetTickTimeMs() - pEvent->timeMs;
+        if (latencyMs > pUartData->stats.eventCallbackLatencyMaxMs) {
+            pUartData->stats.eventCallbackLatencyMaxMs = latencyMs;
+        }
         pUartData->pEventCallback(pEvent->uartHandle,
                                   pEvent->eventBitMap,
                                   pUartData->pEventCallbackParam);
@@ -600,6 +607,7 @@ static inline void dataIrqHandler(uPortUartData_t *pUartData,
                                   char *pRxBufferWriteDma)
 {
     uPortUartEventData_t uartSizeOrError = 0;
+    size_t waiting;
 
     // Work out how much new data there is
     if (pUartData->pRxBufferWrite < pRxBufferWriteDma) {
@@ -617,6 +625,27 @@ static inline void dataIrqHandler(uPortUartData_t *pUartData,
                           (pRxBufferWriteDma - pUartData->pRxBufferStart);
     }
 
+    // Keep statistics: what was waiting already plus the new data;
+    // if that is more than the buffer can hold, the DMA, which never
+    // stops, has written over data that had not been read
+    if (pUartData->pRxBufferWrite >= pUartData->pRxBufferRead) {
+        waiting = pUartData->pRxBufferWrite - pUartData->pRxBufferRead;
+    } else {
+        waiting = pUartData->rxBufferSizeBytes -
+                  (pUartData->pRxBufferRead - pUartData->pRxBufferWrite);
+    }
+    waiting += uartSizeOrError;
+    if (waiting >= pUartData->rxBufferSizeBytes) {
+        if (uartSizeOrError > 0) {
+            pUartData->stats.rxBufferOverflows++;
+        }
+        waiting = pUartData->rxBufferSizeBytes;
+    }
+    if (waiting > pUartData->stats.rxBufferHighWaterMark) {
+        pUartData->stats.rxBufferHighWaterMark = waiting;
+    }
+    pUartData->stats.rxBytes += uartSizeOrError;
+
     // Move the write pointer on
     pUartData->pRxBufferWrite += uartSizeOrError;
     if (pUartData->pRxBufferWrite >= pUartData->pRxBufferStart +
@@ -633,6 +662,7 @@ static inline void dataIrqHandler(uPortUartData_t *pUartData,
             uPortUartEvent_t event;
             event.uartHandle = pUartData->uartHandle;
             event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
+            event.timeMs = uPortGetTickTimeMs();
             uPortEventQueueSendIrq(pUartData->eventQueueHandle,
                                    &event, sizeof(event));
         }
@@ -689,6 +719,21 @@ void uartIrqHandler(uPortUartData_t *pUartData)
     const uPortUartConstData_t *pUartCfg = pUartData->pConstData;
     USART_TypeDef *const pUartReg = pUartCfg->pReg;
 
+    // Check for errors, enabled by the error interrupt: on this
+    // MCU clearing any one of these flags (by reading the status
+    // and then the data register) clears all of them
+    if (LL_USART_IsEnabledIT_ERROR(pUartReg)) {
+        if (LL_USART_IsActiveFlag_ORE(pUartReg)) {
+            pUartData->stats.rxOverrunErrors++;
+        }
+        if (LL_USART_IsActiveFlag_FE(pUartReg) ||
+            LL_USART_IsActiveFlag_NE(pUartReg) ||
+            LL_USART_IsActiveFlag_PE(pUartReg)) {
+            pUartData->stats.rxFramingErrors++;
+        }
+        LL_USART_ClearFlag_ORE(pUartReg);
+    }
+
     // Check for IDLE line interrupt
     if (LL_USART_IsEnabledIT_IDLE(pUartReg) &&
         LL_USART_IsActiveFlag_IDLE(pUartReg)) {
@@ -1128,11 +1173,13 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
                     // Connect it all together
                     if (platformError == SUCCESS) {
                         // Asynchronous UART/USART with DMA on the receive
-                        // and include only the idle line interrupt,
-                        // DMA does the rest
+                        // and include only the idle line interrupt, plus
+                        // the error interrupt for the statistics, DMA
+                        // does the rest
                         LL_USART_ConfigAsyncMode(pUartReg);
                         LL_USART_EnableDMAReq_RX(pUartReg);
                         LL_USART_EnableIT_IDLE(pUartReg);
+                        LL_USART_EnableIT_ERROR(pUartReg);
 
                         // Enable the UART/USART interrupt
                         NVIC_SetPriority(uartIrq,
@@ -1303,6 +1350,89 @@ int32_t uPortUartRead(int32_t handle, void *pBuffer,
     return (int32_t) sizeOrErrorCode;
 }
 
+// Get a pointer to received data, straight from the DMA buffer.
+int32_t uPortUartReadSpan(int32_t handle, const char **ppData)
+{
+    uErrorCode_t sizeOrErrorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+    const volatile char *pRxBufferWrite;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        sizeOrErrorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pGetUartDataByHandle(handle);
+        if ((pUartData != NULL) && (ppData != NULL)) {
+            // As in uPortUartRead(), re-enable UART receive
+            // events right before sampling pRxBufferWrite
+            pUartData->userNeedsNotify = true;
+            pRxBufferWrite = pUartData->pRxBufferWrite;
+            *ppData = pUartData->pRxBufferRead;
+            if (pUartData->pRxBufferRead < pRxBufferWrite) {
+                // Read pointer is behind write, the span is
+                // simply the difference
+                sizeOrErrorCode = pRxBufferWrite - pUartData->pRxBufferRead;
+            } else if (pUartData->pRxBufferRead > pRxBufferWrite) {
+                // Read pointer is ahead of write, the span is up
+                // to the end of the buffer; the rest, from the
+                // start of the buffer, is the next span
+                sizeOrErrorCode = pUartData->pRxBufferStart +
+                                  pUartData->rxBufferSizeBytes -
+                                  pUartData->pRxBufferRead;
+            } else {
+                sizeOrErrorCode = 0;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return (int32_t) sizeOrErrorCode;
+}
+
+// Release data returned by uPortUartReadSpan().
+int32_t uPortUartReleaseSpan(int32_t handle, size_t sizeBytes)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+    const volatile char *pRxBufferWrite;
+    size_t available = 0;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pGetUartDataByHandle(handle);
+        if (pUartData != NULL) {
+            // The span can only have grown since it was returned
+            // so check against what is there now
+            pRxBufferWrite = pUartData->pRxBufferWrite;
+            if (pUartData->pRxBufferRead < pRxBufferWrite) {
+                available = pRxBufferWrite - pUartData->pRxBufferRead;
+            } else if (pUartData->pRxBufferRead > pRxBufferWrite) {
+                available = pUartData->pRxBufferStart +
+                            pUartData->rxBufferSizeBytes -
+                            pUartData->pRxBufferRead;
+            }
+            if (sizeBytes <= available) {
+                // Move the read pointer on, wrapping as necessary
+                pUartData->pRxBufferRead += sizeBytes;
+                if (pUartData->pRxBufferRead >= pUartData->pRxBufferStart +
+                    pUartData->rxBufferSizeBytes) {
+                    pUartData->pRxBufferRead = pUartData->pRxBufferStart;
+                }
+                errorCode = U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return (int32_t) errorCode;
+}
+
 // Write to the given UART interface.
 int32_t uPortUartWrite(int32_t handle,
                        const void *pBuffer,
@@ -1313,6 +1443,7 @@ int32_t uPortUartWrite(int32_t handle,
     uPortUartData_t *pUartData;
     USART_TypeDef *pReg;
     bool txOk = true;
+    bool ctsFlowControl;
     int32_t startTimeMs;
 
     if (gMutex != NULL) {
@@ -1323,6 +1454,13 @@ int32_t uPortUartWrite(int32_t handle,
         pUartData = pGetUartDataByHandle(handle);
         if (pUartData != NULL) {
             pReg = gUartCfg[pUartData->uart].pReg;
+            // The CTS flag is set by any change of the CTS line,
+            // hence, since it will change back again, a change
+            // during the send counts as one stall
+            ctsFlowControl = ((LL_USART_GetHWFlowCtrl(pReg) & LL_USART_HWCONTROL_CTS) != 0);
+            if (ctsFlowControl) {
+                LL_USART_ClearFlag_nCTS(pReg);
+            }
             // Do the blocking send
             sizeOrErrorCode = (int32_t) sizeBytes;
             startTimeMs = uPortGetTickTimeMs();
@@ -1348,6 +1486,10 @@ int32_t uPortUartWrite(int32_t handle,
             while (!LL_USART_IsActiveFlag_TC(pReg) &&
                    (uPortGetTickTimeMs() - startTimeMs < U_PORT_UART_WRITE_TIMEOUT_MS)) {}
             sizeOrErrorCode -= (int32_t) sizeBytes;
+            pUartData->stats.txBytes += sizeOrErrorCode;
+            if (ctsFlowControl && LL_USART_IsActiveFlag_nCTS(pReg)) {
+                pUartData->stats.ctsStalls++;
+            }
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -1356,6 +1498,29 @@ int32_t uPortUartWrite(int32_t handle,
     return sizeOrErrorCode;
 }
 
+// Get the statistics of a UART.
+int32_t uPortUartGetStats(int32_t handle, uPortUartStats_t *pStats)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pGetUartDataByHandle(handle);
+        if ((pUartData != NULL) && (pStats != NULL)) {
+            *pStats = pUartData->stats;
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return (int32_t) errorCode;
+}
+
 // Set an event callback.
 int32_t uPortUartEventCallbackSet(int32_t handle,
                                   uint32_t filter,
@@ -1504,6 +1669,7 @@ int32_t uPortUartEventSend(int32_t handle, uint32_t eventBitMap)
             (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
             event.uartHandle = handle;
             event.eventBitMap = eventBitMap;
+            event.timeMs = uPortGetTickTimeMs();
             errorCode = uPortEventQueueSend(pUartData->eventQueueHandle,
                                             &event, sizeof(event));
         }
@@ -1535,6 +1701,7 @@ int32_t uPortUartEventTrySend(int32_t handle, uint32_t eventBitMap,
             (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
             event.uartHandle = handle;
             event.eventBitMap = eventBitMap;
+            event.timeMs = uPortGetTickTimeMs();
             do {
                 // Push an event to event queue, IRQ version so as not to block
                 errorCode = uPortEventQueueSendIrq(pUartData->eventQueueHandle,
@@ -131,6 +131,15 @@
 # define U_CFG_TEST_UART_B          -1
 #endif
 
+/** The UART number to use for a replay UART (see
+ * u_port_uart_replay.h) during testing; a replay UART has no
+ * COM port behind it and so this need only be a number that is
+ * not otherwise in use.  Specify -1 to not run the replay tests.
+ */
+#ifndef U_CFG_TEST_UART_REPLAY
+# define U_CFG_TEST_UART_REPLAY    250
+#endif
+
 /** The baud rate to test the UART at.
  */
 #ifndef U_CFG_TEST_BAUD_RATE
@@ -22,6 +22,7 @@
 # include "u_cfg_override.h" // For a customer's configuration override
 #endif
 
+#include "stdlib.h"    // malloc(), free()
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
@@ -43,6 +44,14 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The context of a SHA256 calculation begun with
+ * uPortCryptoSha256Start().
+ */
+typedef struct {
+    BCRYPT_ALG_HANDLE algorithmHandle;
+    BCRYPT_HASH_HANDLE hashHandle;
+} uPortCryptoSha256Context_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -92,6 +101,80 @@ int32_t uPortCryptoSha256(const char *pInput,
     return errorCode;
 }
 
+// Start a SHA256 calculation.
+int32_t uPortCryptoSha256Start(void **ppContext)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortCryptoSha256Context_t *pContext;
+
+    if (ppContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pContext = (uPortCryptoSha256Context_t *) malloc(sizeof(*pContext));
+        if (pContext != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            pContext->algorithmHandle = NULL;
+            pContext->hashHandle = NULL;
+            if (BCryptOpenAlgorithmProvider(&(pContext->algorithmHandle),
+                                            BCRYPT_SHA256_ALGORITHM,
+                                            NULL, 0) >= 0) {
+                if (BCryptCreateHash(pContext->algorithmHandle,
+                                     &(pContext->hashHandle),
+                                     NULL, 0, NULL, 0, 0) >= 0) {
+                    *ppContext = pContext;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                } else {
+                    BCryptCloseAlgorithmProvider(pContext->algorithmHandle, 0);
+                }
+            }
+            if (errorCode != 0) {
+                free(pContext);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Add data to a SHA256 calculation.
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && ((pInput != NULL) || (inputLengthBytes == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if (BCryptHashData(((uPortCryptoSha256Context_t *) pContext)->hashHandle,
+                           (PBYTE) pInput, inputLengthBytes, 0) >= 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Complete a SHA256 calculation.
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortCryptoSha256Context_t *pSha256Context = (uPortCryptoSha256Context_t *) pContext;
+
+    if (pSha256Context != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if ((pOutput != NULL) &&
+            (BCryptFinishHash(pSha256Context->hashHandle, (PUCHAR) pOutput,
+                              U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES,
+                              0) < 0)) {
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        }
+        BCryptDestroyHash(pSha256Context->hashHandle);
+        BCryptCloseAlgorithmProvider(pSha256Context->algorithmHandle, 0);
+        free(pSha256Context);
+    }
+
+    return errorCode;
+}
+
 // Perform a HMAC SHA256 calculation on a block of data.
 int32_t uPortCryptoHmacSha256(const char *pKey,
                               size_t keyLengthBytes,
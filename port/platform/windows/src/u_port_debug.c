@@ -26,8 +26,12 @@
 #include "stdint.h"
 #include "stdbool.h"
 
+#include "windows.h"
+
 #include "u_error_common.h"
 
+#include "u_port_debug.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -48,10 +52,76 @@ static bool gPortLogOn = true;
  */
 volatile int32_t gStdoutCounter;
 
+/** Lock protecting the span trace file.
+ */
+static SRWLOCK gSpanLock = SRWLOCK_INIT;
+
+/** The span trace file, NULL if there isn't one open.
+ */
+static FILE *gpSpanFile = NULL;
+
+/** The value of the performance counter when the span trace
+ * file was opened.
+ */
+static LARGE_INTEGER gSpanStartCount = {0};
+
+/** The frequency of the performance counter.
+ */
+static LARGE_INTEGER gSpanCountFrequency = {0};
+
+/** The number of events written to the span trace file.
+ */
+static uint32_t gSpanNumEvents = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Write the name of a span to the span trace file as a JSON
+// string, escaping anything that JSON would not allow as-is.
+static void spanWriteName(const char *pName)
+{
+    fprintf(gpSpanFile, ",\"name\":\"");
+    for (; *pName != 0; pName++) {
+        if ((*pName == '"') || (*pName == '\\')) {
+            fprintf(gpSpanFile, "\\%c", *pName);
+        } else if ((uint8_t) *pName < 0x20) {
+            fprintf(gpSpanFile, "\\u%04x", (uint8_t) *pName);
+        } else {
+            fputc(*pName, gpSpanFile);
+        }
+    }
+    fputc('"', gpSpanFile);
+}
+
+// Write a span event, phase 'B' or 'E', to the span trace file.
+static void spanWrite(char phase, const char *pName)
+{
+    LARGE_INTEGER count;
+    uint64_t elapsed;
+
+    QueryPerformanceCounter(&count);
+    AcquireSRWLockExclusive(&gSpanLock);
+    if (gpSpanFile != NULL) {
+        // Convert to microseconds in two parts to avoid overflow
+        elapsed = (uint64_t) (count.QuadPart - gSpanStartCount.QuadPart);
+        elapsed = ((elapsed / gSpanCountFrequency.QuadPart) * 1000000ULL) +
+                  (((elapsed % gSpanCountFrequency.QuadPart) * 1000000ULL) /
+                   gSpanCountFrequency.QuadPart);
+        fprintf(gpSpanFile, "%s{\"ph\":\"%c\",\"ts\":%llu,\"pid\":%lu,\"tid\":%lu",
+                gSpanNumEvents > 0 ? ",\n" : "", phase,
+                (unsigned long long) elapsed,
+                (unsigned long) GetCurrentProcessId(),
+                (unsigned long) GetCurrentThreadId());
+        if (pName != NULL) {
+            spanWriteName(pName);
+        }
+        fprintf(gpSpanFile, "}");
+        gSpanNumEvents++;
+    }
+    ReleaseSRWLockExclusive(&gSpanLock);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -85,4 +155,52 @@ int32_t uPortLogOn(void)
     return (int32_t) U_ERROR_COMMON_SUCCESS;
 }
 
+// Open the span trace file.
+int32_t uPortSpanTraceOpen(const char *pFileName)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pFileName != NULL) {
+        uPortSpanTraceClose();
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        AcquireSRWLockExclusive(&gSpanLock);
+        if (fopen_s(&gpSpanFile, pFileName, "w") == 0) {
+            QueryPerformanceFrequency(&gSpanCountFrequency);
+            QueryPerformanceCounter(&gSpanStartCount);
+            gSpanNumEvents = 0;
+            fprintf(gpSpanFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        } else {
+            gpSpanFile = NULL;
+        }
+        ReleaseSRWLockExclusive(&gSpanLock);
+    }
+
+    return errorCode;
+}
+
+// Close the span trace file.
+void uPortSpanTraceClose(void)
+{
+    AcquireSRWLockExclusive(&gSpanLock);
+    if (gpSpanFile != NULL) {
+        fprintf(gpSpanFile, "\n]}\n");
+        fclose(gpSpanFile);
+        gpSpanFile = NULL;
+    }
+    ReleaseSRWLockExclusive(&gSpanLock);
+}
+
+// Begin a timed span.
+void uPortSpanBegin(const char *pName)
+{
+    spanWrite('B', pName);
+}
+
+// End a timed span.
+void uPortSpanEnd(void)
+{
+    spanWrite('E', NULL);
+}
+
 // End of file
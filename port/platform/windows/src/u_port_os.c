@@ -150,6 +150,9 @@ int32_t uPortTaskCreate(void (*pFunction)(void *),
                                            pParameter,
                                            priority,
                                            pTaskHandle);
+        if (errorCode == U_ERROR_COMMON_SUCCESS) {
+            U_PORT_TASK_STACK_REGISTER(*pTaskHandle, pName, stackSizeBytes);
+        }
     }
 
     return (int32_t) errorCode;
@@ -158,6 +161,7 @@ int32_t uPortTaskCreate(void (*pFunction)(void *),
 // Delete the given task.
 int32_t uPortTaskDelete(const uPortTaskHandle_t taskHandle)
 {
+    U_PORT_TASK_STACK_DEREGISTER(taskHandle);
     return uPortPrivateTaskDelete(taskHandle);
 }
 
@@ -214,6 +218,18 @@ int32_t uPortTaskGetHandle(uPortTaskHandle_t *pTaskHandle)
     return (int32_t) errorCode;
 }
 
+// Get the run-time statistics of all tasks.
+int32_t uPortTaskGetRuntimeStats(uPortTaskRuntimeStats_t *pStats,
+                                 size_t maxNumStats,
+                                 int32_t *pIdlePercent)
+{
+    (void) pStats;
+    (void) maxNumStats;
+    (void) pIdlePercent;
+
+    return (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: QUEUES
  * -------------------------------------------------------------- */
@@ -42,6 +42,10 @@
 #include "u_port_uart.h"
 #include "u_port_event_queue.h"
 #include "u_port_private.h"
+#include "u_port_uart_replay.h"
+
+#include "u_at_client.h"
+#include "u_at_client_record.h" // uAtClientRecordGet() for the replay UART
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -61,7 +65,8 @@
 #endif
 
 #ifndef U_PORT_UART_TIMER_POLL_TIME_MS
-/** Poll every 10 milliseconds to catch anything we might have missed.
+/** How long to wait before trying again when the receive buffer
+ * is full or a read has failed.
  */
 # define U_PORT_UART_TIMER_POLL_TIME_MS 10
 #endif
@@ -78,9 +83,9 @@ typedef struct uPortUartData_t {
     bool markedForDeletion;
     char nameStr[U_PORT_UART_MAX_COM_PORT_NAME_BUFFER_LENGTH];
     HANDLE windowsUartHandle;
-    HANDLE waitCommEventThreadHandle;
-    HANDLE waitCommEventThreadReadyHandle;
-    HANDLE waitCommEventThreadTerminateHandle;
+    HANDLE rxThreadHandle;
+    HANDLE rxThreadReadyHandle;
+    HANDLE rxThreadTerminateHandle;
     bool rxBufferIsMalloced;
     size_t rxBufferSizeBytes;
     char *pRxBufferStart;
@@ -95,9 +100,27 @@ typedef struct uPortUartData_t {
                            * been read and hence the user
                            * would like a notification
                            * when new data arrives. */
+    const char *pReplaySession; /**< non-NULL if this is a replay UART. */
+    size_t replaySessionLength;
+    int32_t replayTimeScalePercent;
+    HANDLE replayTxEventHandle; /**< set when the user writes to a replay UART. */
+    volatile size_t replayTxCount; /**< the number of bytes the user has
+                                    * written to a replay UART. */
+    volatile bool replayFinished;
+    uPortUartStats_t stats;
+    bool ctsHold; /**< the last CTS hold state, for the statistics. */
     struct uPortUartData_t *pNext;
 } uPortUartData_t;
 
+/** A session set with uPortUartReplaySet().
+ */
+typedef struct {
+    int32_t uart;
+    const char *pSession; /**< NULL if this entry is not in use. */
+    size_t length;
+    int32_t timeScalePercent;
+} uPortUartReplay_t;
+
 /** Structure describing an event.
  */
 typedef struct {
@@ -105,6 +128,9 @@ typedef struct {
     uint32_t eventBitMap;
     void (*pEventCallback)(int32_t, uint32_t, void *);
     void *pEventCallbackParam;
+    uPortUartStats_t *pStats; /**< valid since the event queue is
+                                   closed before the UART is freed. */
+    int32_t timeMs; /**< when the event was sent, for the latency statistic. */
 } uPortUartEvent_t;
 
 /* ----------------------------------------------------------------
@@ -123,6 +149,10 @@ static uPortUartData_t *gpUartListRoot = NULL;
  */
 static int32_t gUartHandleNext = 0;
 
+/** The sessions set with uPortUartReplaySet().
+ */
+static uPortUartReplay_t gReplay[U_PORT_UART_REPLAY_MAX_NUM] = {0};
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -169,9 +199,10 @@ static uPortUartData_t *pUartAdd()
         pTmp->eventQueueHandle = -1;
         pTmp->uartHandle = -1;
         pTmp->windowsUartHandle = INVALID_HANDLE_VALUE;
-        pTmp->waitCommEventThreadHandle = INVALID_HANDLE_VALUE;
-        pTmp->waitCommEventThreadReadyHandle = INVALID_HANDLE_VALUE;
-        pTmp->waitCommEventThreadTerminateHandle = INVALID_HANDLE_VALUE;
+        pTmp->rxThreadHandle = INVALID_HANDLE_VALUE;
+        pTmp->rxThreadReadyHandle = INVALID_HANDLE_VALUE;
+        pTmp->rxThreadTerminateHandle = INVALID_HANDLE_VALUE;
+        pTmp->replayTxEventHandle = INVALID_HANDLE_VALUE;
         pTmp->pNext = NULL;
         // Get the next UART handle
         x = gUartHandleNext;
@@ -228,13 +259,16 @@ static void uartRemove(const uPortUartData_t *pUartData)
 // !!! gMutex should NOT be locked when this is called !!!
 static void uartCloseRequiresMutex(uPortUartData_t *pUartData)
 {
-    // Set the terminate event and wait for the waitCommEvent
+    // Set the terminate event and wait for the receive
     // thread to exit
-    SetEvent(pUartData->waitCommEventThreadTerminateHandle);
-    WaitForSingleObject(pUartData->waitCommEventThreadHandle, INFINITE);
+    SetEvent(pUartData->rxThreadTerminateHandle);
+    WaitForSingleObject(pUartData->rxThreadHandle, INFINITE);
     // Close the ready and terminate events
-    CloseHandle(pUartData->waitCommEventThreadReadyHandle);
-    CloseHandle(pUartData->waitCommEventThreadTerminateHandle);
+    CloseHandle(pUartData->rxThreadReadyHandle);
+    CloseHandle(pUartData->rxThreadTerminateHandle);
+    if (pUartData->replayTxEventHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(pUartData->replayTxEventHandle);
+    }
     // Remove the callback if there is one
     if (pUartData->eventQueueHandle >= 0) {
         uPortEventQueueClose(pUartData->eventQueueHandle);
@@ -259,6 +293,7 @@ static void uartCloseRequiresMutex(uPortUartData_t *pUartData)
 static void eventHandler(void *pParam, size_t paramLength)
 {
     uPortUartEvent_t *pEvent = (uPortUartEvent_t *) pParam;
+    int32_t latencyMs = uPortGetTickTimeMs() - pEvent->timeMs;
 
     (void) paramLength;
 
@@ -269,100 +304,64 @@ static void eventHandler(void *pParam, size_t paramLength)
     // API which will need to lock the mutex.
 
     if (pEvent->pEventCallback != NULL) {
+        if (latencyMs > pEvent->pStats->eventCallbackLatencyMaxMs) {
+            pEvent->pStats->eventCallbackLatencyMaxMs = latencyMs;
+        }
         pEvent->pEventCallback(pEvent->uartHandle,
                                pEvent->eventBitMap,
                                pEvent->pEventCallbackParam);
     }
 }
 
-// Handle a UART event, called by waitCommEventThread().
-// Returns the system error code that the attempt to read the
-// UART results in, usually either:
-// ERROR_SUCCESS (0)
-// ERROR_TIMEOUT (1460)
-static DWORD handleThreadUartEvent(uPortUartData_t *pUartData,
-                                   DWORD uartEvent)
+// Work out how much linear space is free in the receive buffer,
+// i.e. how much can be written at pRxBufferWrite in one go;
+// called from the thread that fills the receive buffer.
+static int32_t rxBufferSpaceAvailable(const uPortUartData_t *pUartData)
 {
-    uPortUartEvent_t event;
-    OVERLAPPED overlap;
-    DWORD bytesRead;
-    DWORD totalSize = 0;
-    DWORD lastErrorCode = -1;
-    const volatile char *pRxBufferRead;
     int32_t spaceAvailable;
-
-    if (uartEvent & EV_RXCHAR) {
-        // There's received data, go get it
-        memset(&overlap, 0, sizeof(overlap));
-        overlap.hEvent = CreateEvent(NULL, true, false, NULL);
-        if (overlap.hEvent != INVALID_HANDLE_VALUE) {
-            do {
-                // Work out how much linear space we have
-                // free in the buffer
-                pRxBufferRead = pUartData->pRxBufferRead;
-                if (pUartData->pRxBufferWrite >= pRxBufferRead) {
-                    //        |              rxBufferSizeBytes          |
-                    //        |---------------|-----------|----- X -----|
-                    //        ^               ^           ^
-                    //        |               |           |
-                    // pRxBufferStart pRxBufferRead pRxBufferWrite
-                    //
-                    // Write pointer is at or ahead of the read pointer,
-                    // bytes available, X, are from the write pointer
-                    // up to the end of the buffer but we also need to
-                    // make sure that wouldn't cause the pointers to
-                    // catch up
-                    spaceAvailable = pUartData->pRxBufferStart +
-                                     (pUartData->rxBufferSizeBytes) -
-                                     pUartData->pRxBufferWrite;
-                    if ((spaceAvailable > 0) &&
-                        (pRxBufferRead == pUartData->pRxBufferStart)) {
-                        spaceAvailable--;
-                    }
-                } else {
-                    //        |              rxBufferSizeBytes          |
-                    //        |---------------|-----X-----|-------------|
-                    //        ^               ^           ^
-                    //        |               |           |
-                    // pRxBufferStart pRxBufferWrite pRxBufferRead
-                    //
-                    // Write pointer is behind read, bytes available, X, is
-                    // simply the difference, -1 so that they don't catch up
-                    spaceAvailable = (pRxBufferRead - pUartData->pRxBufferWrite) - 1;
-                }
-
-                // Now read up to that amount of data or until
-                // we hit the read COMM timeout
-                bytesRead = 0;
-                lastErrorCode = ERROR_SUCCESS;
-                if (!ReadFile(pUartData->windowsUartHandle,
-                              pUartData->pRxBufferWrite,
-                              spaceAvailable, &bytesRead, &overlap)) {
-                    lastErrorCode = GetLastError();
-                    if (lastErrorCode == ERROR_IO_PENDING) {
-                        GetOverlappedResult(pUartData->windowsUartHandle,
-                                            &overlap, &bytesRead, true);
-                        lastErrorCode = GetLastError();
-                    }
-                }
-                // Move the write pointer on
-                pUartData->pRxBufferWrite += bytesRead;
-                totalSize += bytesRead;
-                if (pUartData->pRxBufferWrite >= pUartData->pRxBufferStart +
-                    pUartData->rxBufferSizeBytes) {
-                    pUartData->pRxBufferWrite = pUartData->pRxBufferStart;
-                }
-                // Keep reading while there is stuff to read
-            } while (bytesRead > 0);
-        } else {
-            lastErrorCode = GetLastError() ;
+    const volatile char *pRxBufferRead = pUartData->pRxBufferRead;
+
+    if (pUartData->pRxBufferWrite >= pRxBufferRead) {
+        //        |              rxBufferSizeBytes          |
+        //        |---------------|-----------|----- X -----|
+        //        ^               ^           ^
+        //        |               |           |
+        // pRxBufferStart pRxBufferRead pRxBufferWrite
+        //
+        // Write pointer is at or ahead of the read pointer,
+        // bytes available, X, are from the write pointer
+        // up to the end of the buffer but we also need to
+        // make sure that wouldn't cause the pointers to
+        // catch up
+        spaceAvailable = pUartData->pRxBufferStart +
+                         (pUartData->rxBufferSizeBytes) -
+                         pUartData->pRxBufferWrite;
+        if ((spaceAvailable > 0) &&
+            (pRxBufferRead == pUartData->pRxBufferStart)) {
+            spaceAvailable--;
         }
-
-        CloseHandle(overlap.hEvent);
+    } else {
+        //        |              rxBufferSizeBytes          |
+        //        |---------------|-----X-----|-------------|
+        //        ^               ^           ^
+        //        |               |           |
+        // pRxBufferStart pRxBufferWrite pRxBufferRead
+        //
+        // Write pointer is behind read, bytes available, X, is
+        // simply the difference, -1 so that they don't catch up
+        spaceAvailable = (pRxBufferRead - pUartData->pRxBufferWrite) - 1;
     }
 
-    if ((totalSize > 0) &&
-        (pUartData->userNeedsNotify) &&
+    return spaceAvailable;
+}
+
+// Let the user know that data has been received, if they
+// are waiting for that.
+static void notifyDataReceived(uPortUartData_t *pUartData)
+{
+    uPortUartEvent_t event;
+
+    if ((pUartData->userNeedsNotify) &&
         (pUartData->eventQueueHandle >= 0)) {
         // Call the user callback
         pUartData->userNeedsNotify = false;
@@ -370,124 +369,290 @@ static DWORD handleThreadUartEvent(uPortUartData_t *pUartData,
         event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
         event.pEventCallback = pUartData->pEventCallback;
         event.pEventCallbackParam = pUartData->pEventCallbackParam;
+        event.pStats = &(pUartData->stats);
+        event.timeMs = uPortGetTickTimeMs();
         uPortEventQueueSend(pUartData->eventQueueHandle, &event, sizeof(event));
     }
+}
 
-    return lastErrorCode;
+// Update the statistics from the error state of the COM port and
+// the receive buffer, called by rxThread().
+static void updateStats(uPortUartData_t *pUartData)
+{
+    DWORD errors = 0;
+    COMSTAT comStat = {0};
+    size_t waiting;
+    const volatile char *pRxBufferRead = pUartData->pRxBufferRead;
+
+    if (ClearCommError(pUartData->windowsUartHandle, &errors, &comStat)) {
+        if (errors & CE_OVERRUN) {
+            pUartData->stats.rxOverrunErrors++;
+        }
+        if (errors & (CE_FRAME | CE_RXPARITY)) {
+            pUartData->stats.rxFramingErrors++;
+        }
+        if ((errors & CE_RXOVER) ||
+            ((comStat.cbInQue > 0) && (rxBufferSpaceAvailable(pUartData) == 0))) {
+            // Either the driver's buffer overflowed or data is
+            // waiting in it because our buffer is full
+            pUartData->stats.rxBufferOverflows++;
+        }
+        // Count each time CTS starts holding off transmission
+        if (comStat.fCtsHold && !pUartData->ctsHold) {
+            pUartData->stats.ctsStalls++;
+        }
+        pUartData->ctsHold = comStat.fCtsHold;
+    }
+
+    if (pUartData->pRxBufferWrite >= pRxBufferRead) {
+        waiting = pUartData->pRxBufferWrite - pRxBufferRead;
+    } else {
+        waiting = pUartData->rxBufferSizeBytes -
+                  (pRxBufferRead - pUartData->pRxBufferWrite);
+    }
+    if (waiting > pUartData->stats.rxBufferHighWaterMark) {
+        pUartData->stats.rxBufferHighWaterMark = waiting;
+    }
 }
 
-// Event thread used by all UARTs for COM events.
-static int32_t waitCommEventThread(void *pParam)
+// Receive thread, one per UART: keeps an overlapped read outstanding
+// straight into the linear free space of the receive buffer.  With
+// the COMM timeouts set in uPortUartOpen() the read completes as soon
+// as any data has arrived, or with nothing after
+// U_PORT_UART_READ_TIMEOUT_MS, so there is no need for WaitCommEvent()
+// or for a poll timer, and the data is copied only once.
+static int32_t rxThread(void *pParam)
 {
     uPortUartData_t *pUartData;
     OVERLAPPED overlap;
-    int32_t uartHandle;
-    HANDLE windowsUartHandle = INVALID_HANDLE_VALUE;
-    HANDLE windowsTimerHandle = INVALID_HANDLE_VALUE;
-    HANDLE readyHandle = INVALID_HANDLE_VALUE;
-    LARGE_INTEGER timerDueTime;
-    HANDLE eventHandles[3];
-    DWORD uartEvent;
-    DWORD x;
+    HANDLE windowsUartHandle;
+    HANDLE eventHandles[2];
+    int32_t spaceAvailable;
+    DWORD bytesRead;
     bool keepGoing = true;
 
     if (gMutex != NULL) {
         // The parameter passed to us is actually the UART (non-windows) handle
-        uartHandle = (int32_t) pParam;
-        for (size_t x = 0; x < sizeof(eventHandles) / sizeof(eventHandles[0]); x++) {
-            eventHandles[x] = INVALID_HANDLE_VALUE;
-        }
-
-        pUartData = pUartGetByHandle(uartHandle);
+        pUartData = pUartGetByHandle((int32_t) pParam);
         if (pUartData != NULL) {
-            // First item in the array is the event thread terminate event,
-            // don't want to miss that
-            eventHandles[0] = pUartData->waitCommEventThreadTerminateHandle;
-            // Need the ready handle
-            readyHandle = pUartData->waitCommEventThreadReadyHandle;
-            // Also need the Windows handle of the UART
             windowsUartHandle = pUartData->windowsUartHandle;
-        }
-
-        // Create an event to capture stuff going-on on the serial port
-        // The event is used by WaitCommEvent()
-        eventHandles[1] = CreateEvent(NULL, true, false, NULL);
-        if (eventHandles[1] != INVALID_HANDLE_VALUE) {
-            // Put the event into the overlap structure so that it can
-            // be passed to WaitCommEvent()
+            // First item in the array is the terminate event,
+            // don't want to miss that
+            eventHandles[0] = pUartData->rxThreadTerminateHandle;
             memset(&overlap, 0, sizeof(overlap));
-            overlap.hEvent = eventHandles[1];
-            // Finally, last in the array, add a timer that we can
-            // use to periodically poll the UART for received data
-            // in case we were unable to process any events (e.g.
-            // if our  buffer was full at the time).
-            eventHandles[2] = CreateWaitableTimer(NULL, false, NULL);
-            if (eventHandles[2] != INVALID_HANDLE_VALUE) {
-                // Start the periodic timer, a relative timeout value
-                // that is in units of 100 nanosecond intervals in the future
-                timerDueTime.QuadPart = -U_PORT_UART_TIMER_POLL_TIME_MS * 10;
-                if (SetWaitableTimer(eventHandles[2], &timerDueTime,
-                                     U_PORT_UART_TIMER_POLL_TIME_MS, NULL, NULL, 0)) {
-                    // Now we can wait for events on those handles
-                    SetEvent(readyHandle);
-                    while (keepGoing) {
-                        if (WaitCommEvent(windowsUartHandle, &uartEvent, &overlap)) {
-                            // An event has already occurred, handle it
-                            // However, I have seen this return that there is a character
-                            // in the buffer and then any attempt to read the buffer result
-                            // in timeout, which means the code gets stuck here because
-                            // it never processes any of the events in the section below.
-                            // Hence if handleThreadUartEvent() doesn't return
-                            // ERROR_SUCCESS then we move to waiting on events
-                            x = handleThreadUartEvent(pUartData, uartEvent);
-                        } else {
-                            x = GetLastError();
-                        }
-                        if (x != ERROR_SUCCESS) {
-                            // WaitCommEvent will now signal us with the
-                            // eventHandles[1] flag when something has happened
-                            // while a terminate event might arrive on eventHandles[0]
-                            // and the periodic poll timer on eventHandles[2]
-                            x = WaitForMultipleObjects(sizeof(eventHandles) / sizeof(eventHandles[0]),
-                                                       eventHandles,
-                                                       false, INFINITE);
-                            switch (x) {
-                                case WAIT_OBJECT_0 + 0:
-                                    // Terminate thread was signalled
+            overlap.hEvent = CreateEvent(NULL, true, false, NULL);
+            eventHandles[1] = overlap.hEvent;
+            SetEvent(pUartData->rxThreadReadyHandle);
+            if (overlap.hEvent != INVALID_HANDLE_VALUE) {
+                while (keepGoing) {
+                    spaceAvailable = rxBufferSpaceAvailable(pUartData);
+                    if (spaceAvailable > 0) {
+                        bytesRead = 0;
+                        ResetEvent(overlap.hEvent);
+                        if (!ReadFile(windowsUartHandle,
+                                      (char *) pUartData->pRxBufferWrite,
+                                      spaceAvailable, &bytesRead, &overlap)) {
+                            if (GetLastError() == ERROR_IO_PENDING) {
+                                if (WaitForMultipleObjects(sizeof(eventHandles) /
+                                                           sizeof(eventHandles[0]),
+                                                           eventHandles, false,
+                                                           INFINITE) == WAIT_OBJECT_0 + 1) {
+                                    GetOverlappedResult(windowsUartHandle,
+                                                        &overlap, &bytesRead, false);
+                                } else {
+                                    // Terminated: the read must be finished
+                                    // with before the buffer can go away
+                                    CancelIo(windowsUartHandle);
+                                    GetOverlappedResult(windowsUartHandle,
+                                                        &overlap, &bytesRead, true);
                                     keepGoing = false;
-                                    break;
-                                case WAIT_OBJECT_0 + 1:
-                                    // UART event was signaled, go get it
-                                    // Have to provide x but it is not used
-                                    if (GetOverlappedResult(windowsUartHandle, &overlap, &x, true)) {
-                                        handleThreadUartEvent(pUartData, uartEvent);
-                                    }
-                                    break;
-                                case WAIT_OBJECT_0 + 2:
-                                    // Periodic timer has gone off, do a read
-                                    handleThreadUartEvent(pUartData, EV_RXCHAR);
-                                    break;
-                                default:
-                                    // Ignore and continue
-                                    break;
+                                }
+                            } else {
+                                // Don't spin on a failed port
+                                keepGoing = (WaitForSingleObject(eventHandles[0],
+                                                                 U_PORT_UART_TIMER_POLL_TIME_MS) != WAIT_OBJECT_0);
+                            }
+                        }
+                        if (bytesRead > 0) {
+                            // Move the write pointer on
+                            pUartData->pRxBufferWrite += bytesRead;
+                            if (pUartData->pRxBufferWrite >= pUartData->pRxBufferStart +
+                                pUartData->rxBufferSizeBytes) {
+                                pUartData->pRxBufferWrite = pUartData->pRxBufferStart;
                             }
+                            pUartData->stats.rxBytes += bytesRead;
+                            notifyDataReceived(pUartData);
                         }
+                        updateStats(pUartData);
+                    } else {
+                        // Our buffer is full, give the user time to
+                        // read from it; the driver buffers meanwhile
+                        updateStats(pUartData);
+                        keepGoing = (WaitForSingleObject(eventHandles[0],
+                                                         U_PORT_UART_TIMER_POLL_TIME_MS) != WAIT_OBJECT_0);
                     }
-
-                    // Stop the periodic timer
-                    CancelWaitableTimer(eventHandles[2]);
                 }
             }
+            CloseHandle(overlap.hEvent);
         }
+    }
+
+    ExitThread(0);
+}
+
+// Find a session set with uPortUartReplaySet() by UART number.
+// gMutex should be locked before this is called.
+static uPortUartReplay_t *pReplayGetByUart(int32_t uart)
+{
+    uPortUartReplay_t *pReplay = NULL;
+
+    for (size_t x = 0; (x < sizeof(gReplay) / sizeof(gReplay[0])) &&
+         (pReplay == NULL); x++) {
+        if ((gReplay[x].pSession != NULL) && (gReplay[x].uart == uart)) {
+            pReplay = &(gReplay[x]);
+        }
+    }
+
+    return pReplay;
+}
+
+// Write received data from a session into the receive buffer of
+// a replay UART, waiting for the user to read data if the buffer is
+// full; returns false if the terminate event was signalled.
+static bool replayRxWrite(uPortUartData_t *pUartData,
+                          const char *pData, size_t length)
+{
+    bool keepGoing = true;
+    int32_t spaceAvailable;
+
+    while ((length > 0) && keepGoing) {
+        spaceAvailable = rxBufferSpaceAvailable(pUartData);
+        if (spaceAvailable > (int32_t) length) {
+            spaceAvailable = (int32_t) length;
+        }
+        if (spaceAvailable > 0) {
+            memcpy((char *) pUartData->pRxBufferWrite, pData, spaceAvailable);
+            pData += spaceAvailable;
+            length -= spaceAvailable;
+            // Move the write pointer on
+            pUartData->pRxBufferWrite += spaceAvailable;
+            if (pUartData->pRxBufferWrite >= pUartData->pRxBufferStart +
+                pUartData->rxBufferSizeBytes) {
+                pUartData->pRxBufferWrite = pUartData->pRxBufferStart;
+            }
+            notifyDataReceived(pUartData);
+        } else {
+            // Buffer is full, give the user time to read from it
+            keepGoing = (WaitForSingleObject(pUartData->rxThreadTerminateHandle,
+                                             U_PORT_UART_TIMER_POLL_TIME_MS) != WAIT_OBJECT_0);
+        }
+    }
+
+    return keepGoing;
+}
+
+// Thread that plays a session out through a replay UART, taking the
+// place of rxThread().
+static int32_t replayThread(void *pParam)
+{
+    uPortUartData_t *pUartData;
+    HANDLE eventHandles[2];
+    const char *pSession;
+    size_t sessionLength;
+    int32_t recordLength;
+    bool isTx;
+    int32_t timeMs;
+    int32_t lastTimeMs = 0;
+    int32_t delayMs;
+    const char *pData;
+    size_t length;
+    size_t txCountRequired = 0;
+    bool keepGoing = true;
 
-        // Close the waitable timer handle and the UART event handle
-        CloseHandle(eventHandles[2]);
-        CloseHandle(eventHandles[1]);
+    if (gMutex != NULL) {
+        // The parameter passed to us is actually the UART (non-windows) handle
+        pUartData = pUartGetByHandle((int32_t) pParam);
+        if (pUartData != NULL) {
+            // First item in the array is the terminate event,
+            // don't want to miss that
+            eventHandles[0] = pUartData->rxThreadTerminateHandle;
+            eventHandles[1] = pUartData->replayTxEventHandle;
+            pSession = pUartData->pReplaySession;
+            sessionLength = pUartData->replaySessionLength;
+            SetEvent(pUartData->rxThreadReadyHandle);
+            recordLength = uAtClientRecordGet(pSession, sessionLength, &isTx,
+                                              &timeMs, &pData, &length);
+            while ((recordLength > 0) && keepGoing) {
+                if (isTx) {
+                    // Wait for the user to have written as much as
+                    // was transmitted when the session was recorded
+                    txCountRequired += length;
+                    while ((pUartData->replayTxCount < txCountRequired) && keepGoing) {
+                        keepGoing = (WaitForMultipleObjects(sizeof(eventHandles) /
+                                                            sizeof(eventHandles[0]),
+                                                            eventHandles, false,
+                                                            INFINITE) != WAIT_OBJECT_0);
+                    }
+                } else {
+                    // Leave the recorded gap, scaled, and then
+                    // put the data into the receive buffer
+                    delayMs = (timeMs - lastTimeMs) * pUartData->replayTimeScalePercent / 100;
+                    if (delayMs > 0) {
+                        keepGoing = (WaitForSingleObject(eventHandles[0],
+                                                         delayMs) != WAIT_OBJECT_0);
+                    }
+                    if (keepGoing) {
+                        keepGoing = replayRxWrite(pUartData, pData, length);
+                    }
+                }
+                lastTimeMs = timeMs;
+                pSession += recordLength;
+                sessionLength -= recordLength;
+                recordLength = uAtClientRecordGet(pSession, sessionLength, &isTx,
+                                                  &timeMs, &pData, &length);
+            }
+            pUartData->replayFinished = true;
+            if (keepGoing) {
+                // Nothing more to do, wait to be terminated
+                WaitForSingleObject(eventHandles[0], INFINITE);
+            }
+        }
     }
 
     ExitThread(0);
 }
 
+// Set up the events and start the thread for a replay UART.
+// gMutex should be locked before this is called.
+static bool replayOpen(uPortUartData_t *pUartData,
+                       const uPortUartReplay_t *pReplay)
+{
+    bool success = false;
+
+    pUartData->pReplaySession = pReplay->pSession;
+    pUartData->replaySessionLength = pReplay->length;
+    pUartData->replayTimeScalePercent = pReplay->timeScalePercent;
+    pUartData->replayTxCount = 0;
+    pUartData->replayFinished = false;
+    // Create an event that lets us know the replay thread is ready
+    pUartData->rxThreadReadyHandle = CreateEvent(NULL, true, false, NULL);
+    // Create an event that can terminate the replay thread
+    pUartData->rxThreadTerminateHandle = CreateEvent(NULL, true, false, NULL);
+    // Create an auto-reset event that uPortUartWrite() can signal
+    pUartData->replayTxEventHandle = CreateEvent(NULL, false, false, NULL);
+    if ((pUartData->rxThreadReadyHandle != INVALID_HANDLE_VALUE) &&
+        (pUartData->rxThreadTerminateHandle != INVALID_HANDLE_VALUE) &&
+        (pUartData->replayTxEventHandle != INVALID_HANDLE_VALUE)) {
+        pUartData->rxThreadHandle = CreateThread(NULL, 0,
+                                                            (LPTHREAD_START_ROUTINE) replayThread,
+                                                            (PVOID) pUartData->uartHandle,
+                                                            0, NULL);
+        success = (pUartData->rxThreadHandle != INVALID_HANDLE_VALUE);
+    }
+
+    return success;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -527,8 +692,9 @@ void uPortUartDeinit()
             uartCloseRequiresMutex(gpUartListRoot);
         }
 
-        // Delete the mutex
+        // Forget any replay sessions and delete the mutex
         U_PORT_MUTEX_LOCK(gMutex);
+        memset(gReplay, 0, sizeof(gReplay));
         U_PORT_MUTEX_UNLOCK(gMutex);
         uPortMutexDelete(gMutex);
         gMutex = NULL;
@@ -544,6 +710,7 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
 {
     uErrorCode_t handleOrErrorCode = U_ERROR_COMMON_NOT_INITIALISED;
     uPortUartData_t *pUartData;
+    const uPortUartReplay_t *pReplay;
     char nameStr[U_PORT_UART_MAX_COM_PORT_NAME_BUFFER_LENGTH];
     DCB dcb;
     COMMTIMEOUTS timeouts;
@@ -578,11 +745,20 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
                     // Now do the platform stuff
                     handleOrErrorCode = U_ERROR_COMMON_PLATFORM;
                     strncpy(pUartData->nameStr, nameStr, sizeof(pUartData->nameStr));
-                    pUartData->windowsUartHandle = CreateFile(pUartData->nameStr,
-                                                              GENERIC_READ | GENERIC_WRITE,
-                                                              0, NULL, OPEN_EXISTING,
-                                                              FILE_FLAG_OVERLAPPED, NULL);
-                    if (pUartData->windowsUartHandle != INVALID_HANDLE_VALUE) {
+                    pReplay = pReplayGetByUart(uart);
+                    if (pReplay == NULL) {
+                        pUartData->windowsUartHandle = CreateFile(pUartData->nameStr,
+                                                                  GENERIC_READ | GENERIC_WRITE,
+                                                                  0, NULL, OPEN_EXISTING,
+                                                                  FILE_FLAG_OVERLAPPED, NULL);
+                    }
+                    if (pReplay != NULL) {
+                        // A replay UART has no COM port behind it: instead
+                        // a thread plays the session into the receive buffer
+                        if (replayOpen(pUartData, pReplay)) {
+                            handleOrErrorCode = pUartData->uartHandle;
+                        }
+                    } else if (pUartData->windowsUartHandle != INVALID_HANDLE_VALUE) {
                         // Now configure it
                         memset(&dcb, 0, sizeof(dcb));
                         dcb.DCBlength = sizeof(DCB);
@@ -619,29 +795,25 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
                                 timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
                                 timeouts.ReadTotalTimeoutConstant = U_PORT_UART_READ_TIMEOUT_MS;
                                 if (SetCommTimeouts(pUartData->windowsUartHandle, &timeouts)) {
-                                    // Create an event that lets us know the WaitCom event
+                                    // Create an event that lets us know the receive
                                     // thread is ready
-                                    pUartData->waitCommEventThreadReadyHandle = CreateEvent(NULL, true,
-                                                                                            false, NULL);
-                                    if (pUartData->waitCommEventThreadReadyHandle != INVALID_HANDLE_VALUE) {
-                                        // Create an event that can terminate our WaitCom event thread
-                                        pUartData->waitCommEventThreadTerminateHandle = CreateEvent(NULL,
-                                                                                                    true,
-                                                                                                    false,
-                                                                                                    NULL);
-                                        if (pUartData->waitCommEventThreadTerminateHandle != INVALID_HANDLE_VALUE) {
-                                            // ...then create the WaitCom thread
-                                            pUartData->waitCommEventThreadHandle = CreateThread(NULL, 0,
-                                                                                                (LPTHREAD_START_ROUTINE) waitCommEventThread,
-                                                                                                (PVOID) pUartData->uartHandle,
-                                                                                                0, NULL);
-                                            if (pUartData->waitCommEventThreadHandle != INVALID_HANDLE_VALUE) {
-                                                // Now mask-in the receive event flag as that's the only
-                                                // one we support/care about
-                                                if (SetCommMask(pUartData->windowsUartHandle, EV_RXCHAR)) {
-                                                    // Done!
-                                                    handleOrErrorCode = pUartData->uartHandle;
-                                                }
+                                    pUartData->rxThreadReadyHandle = CreateEvent(NULL, true,
+                                                                                 false, NULL);
+                                    if (pUartData->rxThreadReadyHandle != INVALID_HANDLE_VALUE) {
+                                        // Create an event that can terminate our receive thread
+                                        pUartData->rxThreadTerminateHandle = CreateEvent(NULL,
+                                                                                         true,
+                                                                                         false,
+                                                                                         NULL);
+                                        if (pUartData->rxThreadTerminateHandle != INVALID_HANDLE_VALUE) {
+                                            // ...then create the receive thread
+                                            pUartData->rxThreadHandle = CreateThread(NULL, 0,
+                                                                                     (LPTHREAD_START_ROUTINE) rxThread,
+                                                                                     (PVOID) pUartData->uartHandle,
+                                                                                     0, NULL);
+                                            if (pUartData->rxThreadHandle != INVALID_HANDLE_VALUE) {
+                                                // Done!
+                                                handleOrErrorCode = pUartData->uartHandle;
                                             }
                                         }
                                     }
@@ -653,12 +825,13 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
 
                 if (handleOrErrorCode < 0) {
                     // Clean up
-                    if (pUartData->waitCommEventThreadHandle != INVALID_HANDLE_VALUE) {
-                        SetEvent(pUartData->waitCommEventThreadTerminateHandle);
-                        WaitForSingleObject(pUartData->waitCommEventThreadHandle, INFINITE);
+                    if (pUartData->rxThreadHandle != INVALID_HANDLE_VALUE) {
+                        SetEvent(pUartData->rxThreadTerminateHandle);
+                        WaitForSingleObject(pUartData->rxThreadHandle, INFINITE);
                     }
-                    CloseHandle(pUartData->waitCommEventThreadReadyHandle);
-                    CloseHandle(pUartData->waitCommEventThreadTerminateHandle);
+                    CloseHandle(pUartData->rxThreadReadyHandle);
+                    CloseHandle(pUartData->rxThreadTerminateHandle);
+                    CloseHandle(pUartData->replayTxEventHandle);
                     CloseHandle(pUartData->windowsUartHandle);
                     if (pUartData->rxBufferIsMalloced) {
                         free(pUartData->pRxBufferStart);
@@ -672,8 +845,8 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
     }
 
     if (handleOrErrorCode >= 0) {
-        // Wait for the WaitCom thread to be ready before continuing
-        WaitForSingleObject(pUartData->waitCommEventThreadReadyHandle, INFINITE);
+        // Wait for the receive thread to be ready before continuing
+        WaitForSingleObject(pUartData->rxThreadReadyHandle, INFINITE);
     }
 
     return (int32_t) handleOrErrorCode;
@@ -837,20 +1010,29 @@ int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
         pUartData = pUartGetByHandle(handle);
         if ((pBuffer != NULL) && (sizeBytes > 0) &&
             (pUartData != NULL) && !pUartData->markedForDeletion) {
-            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
-            memset(&overlap, 0, sizeof(overlap));
-            overlap.hEvent = CreateEvent(NULL, true, false, NULL);
-            if (overlap.hEvent != INVALID_HANDLE_VALUE) {
-                if (WriteFile(pUartData->windowsUartHandle, pBuffer,
-                              sizeBytes, &bytesWritten, &overlap) ||
-                    ((GetLastError() == ERROR_IO_PENDING) &&
-                     GetOverlappedResult(pUartData->windowsUartHandle,
-                                         &overlap, &bytesWritten, true))) {
-                    sizeOrErrorCode = (int32_t) bytesWritten;
+            if (pUartData->pReplaySession != NULL) {
+                // The data written to a replay UART goes nowhere,
+                // it just lets the replay move on
+                pUartData->replayTxCount += sizeBytes;
+                SetEvent(pUartData->replayTxEventHandle);
+                sizeOrErrorCode = (int32_t) sizeBytes;
+            } else {
+                sizeOrErrorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+                memset(&overlap, 0, sizeof(overlap));
+                overlap.hEvent = CreateEvent(NULL, true, false, NULL);
+                if (overlap.hEvent != INVALID_HANDLE_VALUE) {
+                    if (WriteFile(pUartData->windowsUartHandle, pBuffer,
+                                  sizeBytes, &bytesWritten, &overlap) ||
+                        ((GetLastError() == ERROR_IO_PENDING) &&
+                         GetOverlappedResult(pUartData->windowsUartHandle,
+                                             &overlap, &bytesWritten, true))) {
+                        sizeOrErrorCode = (int32_t) bytesWritten;
+                        pUartData->stats.txBytes += bytesWritten;
+                    }
                 }
-            }
 
-            CloseHandle(overlap.hEvent);
+                CloseHandle(overlap.hEvent);
+            }
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -859,6 +1041,30 @@ int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
     return sizeOrErrorCode;
 }
 
+// Get the statistics of a UART.
+int32_t uPortUartGetStats(int32_t handle, uPortUartStats_t *pStats)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        pUartData = pUartGetByHandle(handle);
+        if ((pStats != NULL) && (pUartData != NULL) &&
+            !pUartData->markedForDeletion) {
+            *pStats = pUartData->stats;
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return (int32_t) errorCode;
+}
+
 // Set an event callback.
 int32_t uPortUartEventCallbackSet(int32_t handle,
                                   uint32_t filter,
@@ -1005,6 +1211,8 @@ int32_t uPortUartEventSend(int32_t handle, uint32_t eventBitMap)
             event.eventBitMap = eventBitMap;
             event.pEventCallback = pUartData->pEventCallback;
             event.pEventCallbackParam = pUartData->pEventCallbackParam;
+            event.pStats = &(pUartData->stats);
+            event.timeMs = uPortGetTickTimeMs();
             errorCode = uPortEventQueueSend(pUartData->eventQueueHandle,
                                             &event, sizeof(event));
         }
@@ -1203,4 +1411,66 @@ void uPortUartCtsResume(int32_t handle)
     }
 }
 
+// Set the session for a replay UART.
+int32_t uPortUartReplaySet(int32_t uart, const char *pSession,
+                           size_t length, int32_t timeScalePercent)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uPortUartReplay_t *pReplay;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((uart >= 0) && (timeScalePercent >= 0)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            pReplay = pReplayGetByUart(uart);
+            if (pReplay != NULL) {
+                // Free the existing entry
+                pReplay->pSession = NULL;
+            }
+            if (pSession != NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                for (size_t x = 0; (x < sizeof(gReplay) / sizeof(gReplay[0])) &&
+                     (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS); x++) {
+                    if (gReplay[x].pSession == NULL) {
+                        gReplay[x].uart = uart;
+                        gReplay[x].pSession = pSession;
+                        gReplay[x].length = length;
+                        gReplay[x].timeScalePercent = timeScalePercent;
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Determine whether a replay UART has reached the end of its session.
+bool uPortUartReplayIsFinished(int32_t handle)
+{
+    bool isFinished = false;
+    uPortUartData_t *pUartData;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        pUartData = pUartGetByHandle(handle);
+        if ((pUartData != NULL) && !pUartData->markedForDeletion &&
+            (pUartData->pReplaySession != NULL)) {
+            isFinished = pUartData->replayFinished;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return isFinished;
+}
+
 // End of file
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_PORT_UART_REPLAY_H_
+#define _U_PORT_UART_REPLAY_H_
+
+/* No #includes allowed here */
+
+/** @file
+ * @brief Windows only: a replay UART, which plays a session
+ * recorded with uAtClientRecordStart() (see u_at_client_record.h)
+ * into the receive side of a UART, instead of a COM port, so that
+ * the AT client and everything above it can be benchmarked on a PC
+ * without a module.
+ *
+ * Once a session has been set with uPortUartReplaySet() for a
+ * given UART number, a call to uPortUartOpen() for that UART
+ * number opens a replay UART rather than the COM port.  The
+ * received records of the session are written to the receive
+ * buffer, with the recorded gaps between them scaled by
+ * timeScalePercent; when a transmitted record is reached the
+ * replay waits until the same number of bytes have been written
+ * to the UART with uPortUartWrite() before moving on, so that
+ * responses are never played out ahead of the commands that
+ * provoked them.  The content of what is written is not checked
+ * and is otherwise discarded.  Flow control is not supported.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_UART_REPLAY_MAX_NUM
+/** The maximum number of replay sessions that can be set at any
+ * one time.
+ */
+# define U_PORT_UART_REPLAY_MAX_NUM 4
+#endif
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Set the session that uPortUartOpen() will play out for a given
+ * UART number.  uPortUartInit() must have been called.  This has
+ * no effect on a UART that is already open.
+ *
+ * @param uart              the UART number, as would be passed
+ *                          to uPortUartOpen().
+ * @param[in] pSession      the session; this must remain valid
+ *                          until any UART opened with it has been
+ *                          closed.  Use NULL to remove a session
+ *                          that was previously set for uart.
+ * @param length            the length of the session at pSession.
+ * @param timeScalePercent  the percentage to scale the recorded
+ *                          gaps between received records by: 100
+ *                          plays the session out with the timing
+ *                          with which it was recorded, 0 plays
+ *                          each received record immediately.
+ * @return                  zero on success else negative error code.
+ */
+int32_t uPortUartReplaySet(int32_t uart, const char *pSession,
+                           size_t length, int32_t timeScalePercent);
+
+/** Determine whether a replay UART has reached the end of its
+ * session; the last received record may still be sitting in the
+ * receive buffer, see uPortUartGetReceiveSize().
+ *
+ * @param handle the handle of the replay UART.
+ * @return       true if the whole session has been played out,
+ *               false if not or handle is not a replay UART.
+ */
+bool uPortUartReplayIsFinished(int32_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_PORT_UART_REPLAY_H_
+
+// End of file
@@ -37,6 +37,7 @@
 #include "u_port_gpio.h"
 #include "u_port_uart.h"
 #include "u_port_i2c.h"
+#include "u_port_spi.h"
 #include "u_port_event_queue_private.h"
 #include "u_port_private.h"
 
@@ -97,6 +98,7 @@ int32_t uPortInit()
     if (errorCode == 0) {
         errorCode = uPortUartInit();
         errorCode |= uPortI2cInit();
+        errorCode |= uPortSpiInit();
     }
     if (errorCode == 0) {
         errorCode = uPortPrivateInit();
@@ -109,6 +111,7 @@ void uPortDeinit()
 {
     uPortPrivateDeinit();
     uPortUartDeinit();
+    uPortSpiDeinit();
     uPortI2cDeinit();
     uPortEventQueuePrivateDeinit();
     // Workaround for Zephyr thread resource pool bug
@@ -101,10 +101,20 @@ typedef struct {
     struct bt_conn                *pConn;
     subscribeParams_t             *pOngoingSubscribe;
     mtuXchangeRespCallback_t       mtuXchangeCallback;
+    uPortGattTxCompleteCallback_t  txCompleteCallback;
     void                          *discoveryCallback;
     struct bt_gatt_discover_params discoverParams;
 } gattConnection_t;
 
+/** Context for uPortGattWriteBulk().
+ */
+typedef struct {
+    uPortSemaphoreHandle_t txBufferSemaphore; // One count per write we may have in flight
+    atomic_t inFlight;
+    uPortGattTxCompleteCallback_t pCallback;
+    void *pCallbackParam;
+} writeBulkContext_t;
+
 /* ----------------------------------------------------------------
  * Static Prototypes
  * -------------------------------------------------------------- */
@@ -148,6 +158,7 @@ static int32_t startDiscovery(int32_t connHandle, const uPortGattUuid_t *pUuid,
                               void *callback, uint8_t type);
 static void gattXchangeMtuRsp(struct bt_conn *conn, uint8_t err,
                               struct bt_gatt_exchange_params *params);
+static void gattTxComplete(struct bt_conn *conn, void *pUserData);
 
 /* ----------------------------------------------------------------
  * VARIABLES
@@ -656,6 +667,16 @@ static int32_t startDiscovery(int32_t connHandle, const uPortGattUuid_t *pUuid,
     return errorCode;
 }
 
+static void gattTxComplete(struct bt_conn *conn, void *pUserData)
+{
+    int32_t connHandle = findConnHandle(conn);
+    if (connHandle != U_PORT_GATT_GAP_INVALID_CONNHANDLE) {
+        if (gCurrentConnections[connHandle].txCompleteCallback != NULL) {
+            gCurrentConnections[connHandle].txCompleteCallback(connHandle, pUserData);
+        }
+    }
+}
+
 static void gattXchangeMtuRsp(struct bt_conn *conn, uint8_t err,
                               struct bt_gatt_exchange_params *params)
 {
@@ -832,11 +853,126 @@ int32_t uPortGattExchangeMtu(int32_t connHandle, mtuXchangeRespCallback_t respCa
     return errorCode;
 }
 
+int32_t uPortGattUpdateConnParams(int32_t connHandle,
+                                  const uPortGattGapParams_t *pGapParams)
+{
+    int32_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+    struct bt_le_conn_param connParam;
+
+    if (validConnHandle(connHandle) && (pGapParams != NULL)) {
+        connParam.interval_min = pGapParams->connIntervalMin;
+        connParam.interval_max = pGapParams->connIntervalMax;
+        connParam.latency = pGapParams->connLatency;
+        // Zephyr wants the supervision timeout in units of 10 ms
+        connParam.timeout = pGapParams->linkLossTimeout / 10;
+        errorCode = U_ERROR_COMMON_UNKNOWN;
+        if (bt_conn_le_param_update(gCurrentConnections[connHandle].pConn,
+                                    &connParam) == 0) {
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+int32_t uPortGattUpdatePhy(int32_t connHandle, uint8_t phys)
+{
+    int32_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (validConnHandle(connHandle)) {
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+        // The U_PORT_GATT_PHY_xxx values are the same as Zephyr's BT_GAP_LE_PHY_xxx
+        struct bt_conn_le_phy_param phyParam = {
+            .options = BT_CONN_LE_PHY_OPT_NONE,
+            .pref_tx_phy = phys,
+            .pref_rx_phy = phys
+        };
+        errorCode = U_ERROR_COMMON_UNKNOWN;
+        if (bt_conn_le_phy_update(gCurrentConnections[connHandle].pConn,
+                                  &phyParam) == 0) {
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+#else
+        (void)phys;
+        errorCode = U_ERROR_COMMON_NOT_SUPPORTED;
+#endif
+    }
+
+    return errorCode;
+}
+
+int32_t uPortGattUpdateDataLength(int32_t connHandle, uint16_t txOctets,
+                                  uint16_t txTimeUs)
+{
+    int32_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (validConnHandle(connHandle)) {
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+        struct bt_conn_le_data_len_param dataLenParam = {
+            .tx_max_len = txOctets,
+            .tx_max_time = txTimeUs
+        };
+        errorCode = U_ERROR_COMMON_UNKNOWN;
+        if (bt_conn_le_data_len_update(gCurrentConnections[connHandle].pConn,
+                                       &dataLenParam) == 0) {
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+#else
+        (void)txOctets;
+        (void)txTimeUs;
+        errorCode = U_ERROR_COMMON_NOT_SUPPORTED;
+#endif
+    }
+
+    return errorCode;
+}
+
+int32_t uPortGattGetLinkParams(int32_t connHandle,
+                               uPortGattLinkParams_t *pParams)
+{
+    int32_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+    struct bt_conn_info info;
+
+    if (validConnHandle(connHandle) && (pParams != NULL)) {
+        errorCode = U_ERROR_COMMON_UNKNOWN;
+        if (bt_conn_get_info(gCurrentConnections[connHandle].pConn, &info) == 0) {
+            memset(pParams, 0, sizeof(*pParams));
+            pParams->connInterval = info.le.interval;
+            pParams->connLatency = info.le.latency;
+            pParams->linkLossTimeout = ((uint32_t) info.le.timeout) * 10;
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+            if (info.le.data_len != NULL) {
+                pParams->txDataLength = info.le.data_len->tx_max_len;
+                pParams->rxDataLength = info.le.data_len->rx_max_len;
+            }
+#endif
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+            if (info.le.phy != NULL) {
+                pParams->txPhy = info.le.phy->tx_phy;
+                pParams->rxPhy = info.le.phy->rx_phy;
+            }
+#endif
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
 int32_t uPortGattNotify(int32_t connHandle, const uPortGattCharacteristic_t *pChar,
                         const void *data, uint16_t len)
+{
+    return uPortGattNotifyCb(connHandle, pChar, data, len, NULL, NULL);
+}
+
+int32_t uPortGattNotifyCb(int32_t connHandle, const uPortGattCharacteristic_t *pChar,
+                          const void *data, uint16_t len,
+                          uPortGattTxCompleteCallback_t pCallback,
+                          void *pCallbackParam)
 {
     int32_t returnValue = U_ERROR_COMMON_UNKNOWN;
     struct bt_gatt_attr *pAtt = gAttrPool;
+    struct bt_gatt_notify_params params = {0};
 
     if (!validConnHandle(connHandle) || (pChar == NULL) || (data == NULL) || (len == 0)) {
         return U_ERROR_COMMON_INVALID_PARAMETER;
@@ -853,12 +989,31 @@ int32_t uPortGattNotify(int32_t connHandle, const uPortGattCharacteristic_t *pCh
     }
 
     if (pAtt != gpNextFreeAttr) {
-        returnValue = bt_gatt_notify(gCurrentConnections[connHandle].pConn, pAtt, data, len);
+        params.attr = pAtt;
+        params.data = data;
+        params.len = len;
+        if (pCallback != NULL) {
+            gCurrentConnections[connHandle].txCompleteCallback = pCallback;
+            params.func = gattTxComplete;
+            params.user_data = pCallbackParam;
+        }
+        returnValue = bt_gatt_notify_cb(gCurrentConnections[connHandle].pConn, &params);
     }
 
     return returnValue;
 }
 
+int32_t uPortGattGetTxBufferCount(void)
+{
+#if defined(CONFIG_BT_L2CAP_TX_BUF_COUNT)
+    return CONFIG_BT_L2CAP_TX_BUF_COUNT;
+#elif defined(CONFIG_BT_BUF_ACL_TX_COUNT)
+    return CONFIG_BT_BUF_ACL_TX_COUNT;
+#else
+    return 1;
+#endif
+}
+
 static struct bt_conn *connectGapAsPeripheral(const bt_addr_le_t *peer, int32_t *pErrorCode)
 {
     struct bt_conn *pConn;
@@ -995,21 +1150,145 @@ int32_t uPortGattGetRemoteAddress(int32_t connHandle, uint8_t *pAddr,
 
 int32_t uPortGattWriteAttribute(int32_t connHandle, uint16_t handle, const void *pData,
                                 uint16_t len)
+{
+    return uPortGattWriteAttributeCb(connHandle, handle, pData, len, NULL, NULL);
+}
+
+int32_t uPortGattWriteAttributeCb(int32_t connHandle, uint16_t handle,
+                                  const void *pData, uint16_t len,
+                                  uPortGattTxCompleteCallback_t pCallback,
+                                  void *pCallbackParam)
 {
     int32_t errorCode = U_ERROR_COMMON_UNKNOWN;
+    bt_gatt_complete_func_t pFunc = NULL;
 
     if ((handle == 0) || !validConnHandle(connHandle) || (pData == NULL)) {
         return U_ERROR_COMMON_INVALID_PARAMETER;
     }
 
-    if (bt_gatt_write_without_response(gCurrentConnections[connHandle].pConn,
-                                       handle, pData, len, false) == 0) {
+    if (pCallback != NULL) {
+        gCurrentConnections[connHandle].txCompleteCallback = pCallback;
+        pFunc = gattTxComplete;
+    }
+    if (bt_gatt_write_without_response_cb(gCurrentConnections[connHandle].pConn,
+                                          handle, pData, len, false,
+                                          pFunc, pCallbackParam) == 0) {
         errorCode = U_ERROR_COMMON_SUCCESS;
     }
 
     return errorCode;
 }
 
+// Called by the BLE stack when a write queued by uPortGattWriteBulk()
+// has gone to the controller, freeing a place for another.
+static void writeBulkTxComplete(int32_t connHandle, void *pCallbackParam)
+{
+    writeBulkContext_t *pContext = (writeBulkContext_t *) pCallbackParam;
+
+    if (pContext->pCallback != NULL) {
+        pContext->pCallback(connHandle, pContext->pCallbackParam);
+    }
+    atomic_dec(&(pContext->inFlight));
+    uPortSemaphoreGive(pContext->txBufferSemaphore);
+}
+
+int32_t uPortGattWriteBulk(int32_t connHandle, uint16_t handle,
+                           const void *pData, size_t length,
+                           int32_t timeoutMs,
+                           uPortGattTxCompleteCallback_t pCallback,
+                           void *pCallbackParam,
+                           uPortGattWriteBulkStats_t *pStats)
+{
+    int32_t errorCodeOrLength;
+    writeBulkContext_t context = {0};
+    const char *pDataChar = (const char *) pData;
+    int32_t txBufferCount = uPortGattGetTxBufferCount();
+    size_t written = 0;
+    size_t numPdus = 0;
+    size_t inFlightMax = 0;
+    size_t inFlight;
+    size_t thisLength;
+    int32_t pduLengthMax;
+    int32_t startTimeMs;
+    int32_t timeLeftMs;
+
+    if ((handle == 0) || !validConnHandle(connHandle) ||
+        (gCurrentConnections[connHandle].pConn == NULL) ||
+        ((pData == NULL) && (length > 0)) || (timeoutMs < 0)) {
+        return U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+
+    // Three bytes of each ATT PDU are the opcode and handle
+    pduLengthMax = uPortGattGetMtu(connHandle) - 3;
+    if (pduLengthMax <= 0) {
+        return U_ERROR_COMMON_UNKNOWN;
+    }
+
+    errorCodeOrLength = uPortSemaphoreCreate(&(context.txBufferSemaphore),
+                                             (uint32_t) txBufferCount,
+                                             (uint32_t) txBufferCount);
+    if (errorCodeOrLength == 0) {
+        context.pCallback = pCallback;
+        context.pCallbackParam = pCallbackParam;
+        startTimeMs = uPortGetTickTimeMs();
+        while ((written < length) && (errorCodeOrLength == 0)) {
+            timeLeftMs = timeoutMs - (int32_t) (uPortGetTickTimeMs() - startTimeMs);
+            if (timeLeftMs < 0) {
+                timeLeftMs = 0;
+            }
+            // Wait for a transmit buffer to be free
+            if (uPortSemaphoreTryTake(context.txBufferSemaphore, timeLeftMs) != 0) {
+                break;
+            }
+            thisLength = length - written;
+            if (thisLength > (size_t) pduLengthMax) {
+                thisLength = (size_t) pduLengthMax;
+            }
+            atomic_inc(&(context.inFlight));
+            if (uPortGattWriteAttributeCb(connHandle, handle, pDataChar + written,
+                                          (uint16_t) thisLength, writeBulkTxComplete,
+                                          &context) == 0) {
+                written += thisLength;
+                numPdus++;
+                inFlight = (size_t) atomic_get(&(context.inFlight));
+                if (inFlight > inFlightMax) {
+                    inFlightMax = inFlight;
+                }
+            } else {
+                // Not queued, so no callback will come
+                atomic_dec(&(context.inFlight));
+                uPortSemaphoreGive(context.txBufferSemaphore);
+                errorCodeOrLength = U_ERROR_COMMON_DEVICE_ERROR;
+            }
+        }
+        // context is on our stack so the callbacks for everything
+        // that was queued must have been called before we return;
+        // the BLE stack calls them when the connection goes too
+        while ((atomic_get(&(context.inFlight)) > 0) &&
+               (gCurrentConnections[connHandle].pConn != NULL)) {
+            uPortTaskBlock(10);
+        }
+        if (pStats != NULL) {
+            pStats->bytes = written;
+            pStats->numPdus = numPdus;
+            pStats->pdusInFlightMax = inFlightMax;
+            pStats->durationMs = (int32_t) (uPortGetTickTimeMs() - startTimeMs);
+            if (pStats->durationMs > 0) {
+                pStats->bytesPerSecond = (int32_t) (((int64_t) written * 1000) /
+                                                    pStats->durationMs);
+            } else {
+                pStats->bytesPerSecond = (int32_t) written * 1000;
+            }
+        }
+        uPortSemaphoreDelete(context.txBufferSemaphore);
+        if (errorCodeOrLength == 0) {
+            errorCodeOrLength = (int32_t) written;
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
 int32_t uPortGattSubscribe(int32_t connHandle, uPortGattSubscribeParams_t *pParams)
 {
     int32_t errorCode = U_ERROR_COMMON_NO_MEMORY;
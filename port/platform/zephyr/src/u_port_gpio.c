@@ -57,10 +57,27 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Structure to keep track of a GPIO interrupt.
+ */
+typedef struct {
+    int32_t pin;
+    struct gpio_callback callback;
+    void (*pCallback) (int32_t, void *);
+    void *pCallbackParam;
+} uPortGpioInterrupt_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The GPIO interrupts; an entry is free if pCallback is NULL.
+ */
+static uPortGpioInterrupt_t gInterrupt[U_PORT_GPIO_INTERRUPT_MAX_NUM] = {0};
+
+/** Mutex protecting gInterrupt.
+ */
+static K_MUTEX_DEFINE(gInterruptMutex);
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -87,6 +104,41 @@ static const struct device *getGpioDevice(uint32_t pin)
     return pDev;
 }
 
+// The interrupt handler for all GPIO interrupts.
+static void interruptHandler(const struct device *pPort,
+                             struct gpio_callback *pCb,
+                             uint32_t pins)
+{
+    uPortGpioInterrupt_t *pInterrupt = CONTAINER_OF(pCb, uPortGpioInterrupt_t,
+                                                    callback);
+    void (*pCallback) (int32_t, void *) = pInterrupt->pCallback;
+
+    (void) pPort;
+    (void) pins;
+
+    if (pCallback != NULL) {
+        pCallback(pInterrupt->pin, pInterrupt->pCallbackParam);
+    }
+}
+
+// Find the interrupt entry for the given pin or, if pin is
+// negative, a free entry.
+// Note: gInterruptMutex should be locked before this is called.
+static uPortGpioInterrupt_t *pInterruptGet(int32_t pin)
+{
+    uPortGpioInterrupt_t *pInterrupt = NULL;
+
+    for (size_t x = 0; (x < sizeof(gInterrupt) / sizeof(gInterrupt[0])) &&
+         (pInterrupt == NULL); x++) {
+        if (((pin >= 0) && (gInterrupt[x].pCallback != NULL) && (gInterrupt[x].pin == pin)) ||
+            ((pin < 0) && (gInterrupt[x].pCallback == NULL))) {
+            pInterrupt = &(gInterrupt[x]);
+        }
+    }
+
+    return pInterrupt;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -226,4 +278,61 @@ int32_t uPortGpioGet(int32_t pin)
     return (val & (1 << (pin % GPIO_MAX_PINS_PER_PORT))) ? 1 : 0;
 }
 
+// Set or remove an interrupt on a GPIO.
+int32_t uPortGpioInterruptSet(int32_t pin, bool risingEdge,
+                              void (*pCallback) (int32_t pin,
+                                                 void *pCallbackParam),
+                              void *pCallbackParam)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+    const struct device *pPort;
+    uPortGpioInterrupt_t *pInterrupt;
+    gpio_pin_t zPin = (gpio_pin_t) (pin % GPIO_MAX_PINS_PER_PORT);
+
+    pPort = getGpioDevice(pin);
+    if ((pin >= 0) && (pPort != NULL)) {
+        errorCode = U_ERROR_COMMON_SUCCESS;
+
+        k_mutex_lock(&gInterruptMutex, K_FOREVER);
+
+        pInterrupt = pInterruptGet(pin);
+        if (pCallback == NULL) {
+            if (pInterrupt != NULL) {
+                gpio_pin_interrupt_configure(pPort, zPin, GPIO_INT_DISABLE);
+                gpio_remove_callback(pPort, &(pInterrupt->callback));
+                pInterrupt->pCallback = NULL;
+            }
+        } else {
+            if (pInterrupt != NULL) {
+                // Replacing an existing interrupt on this pin
+                gpio_pin_interrupt_configure(pPort, zPin, GPIO_INT_DISABLE);
+                gpio_remove_callback(pPort, &(pInterrupt->callback));
+            } else {
+                pInterrupt = pInterruptGet(-1);
+            }
+            errorCode = U_ERROR_COMMON_NO_MEMORY;
+            if (pInterrupt != NULL) {
+                pInterrupt->pin = pin;
+                pInterrupt->pCallbackParam = pCallbackParam;
+                pInterrupt->pCallback = pCallback;
+                gpio_init_callback(&(pInterrupt->callback), interruptHandler, BIT(zPin));
+                errorCode = U_ERROR_COMMON_PLATFORM;
+                if ((gpio_add_callback(pPort, &(pInterrupt->callback)) == 0) &&
+                    (gpio_pin_interrupt_configure(pPort, zPin,
+                                                  risingEdge ? GPIO_INT_EDGE_RISING :
+                                                  GPIO_INT_EDGE_FALLING) == 0)) {
+                    errorCode = U_ERROR_COMMON_SUCCESS;
+                } else {
+                    gpio_remove_callback(pPort, &(pInterrupt->callback));
+                    pInterrupt->pCallback = NULL;
+                }
+            }
+        }
+
+        k_mutex_unlock(&gInterruptMutex);
+    }
+
+    return (int32_t) errorCode;
+}
+
 // End of file
@@ -99,6 +99,17 @@ typedef struct {
     size_t stackSize;
     bool isAllocated;
 } uPortOsThreadInstance_t;
+
+/** Context for the k_thread_foreach() callback of
+ * uPortTaskGetRuntimeStats().
+ */
+typedef struct {
+    uPortTaskRuntimeStats_t *pStats;
+    size_t maxNumStats;
+    size_t numStats;
+    uint64_t totalTicks;
+    uint64_t idleTicks;
+} uPortOsRuntimeStatsContext_t;
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -176,6 +187,39 @@ static uPortOsThreadInstance_t *getNewThreadInstance(size_t stackSizeBytes)
     return threadPtr;
 }
 
+#if defined(CONFIG_THREAD_MONITOR) && defined(CONFIG_THREAD_RUNTIME_STATS)
+// Callback for k_thread_foreach() from uPortTaskGetRuntimeStats().
+static void runtimeStatsCallback(const struct k_thread *pThread, void *pUserData)
+{
+    uPortOsRuntimeStatsContext_t *pContext = (uPortOsRuntimeStatsContext_t *) pUserData;
+    k_tid_t tid = (k_tid_t) pThread;
+    k_thread_runtime_stats_t threadStats;
+    uPortTaskRuntimeStats_t *pStats;
+    const char *pName = k_thread_name_get(tid);
+    bool isIdle = (k_thread_priority_get(tid) == K_IDLE_PRIO);
+
+    if (k_thread_runtime_stats_get(tid, &threadStats) != 0) {
+        threadStats.execution_cycles = 0;
+    }
+    pContext->totalTicks += threadStats.execution_cycles;
+    if (isIdle) {
+        pContext->idleTicks += threadStats.execution_cycles;
+    }
+    if (pContext->numStats < pContext->maxNumStats) {
+        pStats = &(pContext->pStats[pContext->numStats]);
+        pStats->taskHandle = (uPortTaskHandle_t) tid;
+        pStats->name[0] = 0;
+        if (pName != NULL) {
+            strncpy(pStats->name, pName, sizeof(pStats->name));
+            pStats->name[sizeof(pStats->name) - 1] = 0;
+        }
+        pStats->runtimeTicks = threadStats.execution_cycles;
+        pStats->isIdle = isIdle;
+        pContext->numStats++;
+    }
+}
+#endif
+
 static void freeThreadInstance(struct k_thread *threadPtr)
 {
     int32_t i = 0;
@@ -257,6 +301,7 @@ int32_t uPortTaskCreate(void (*pFunction)(void *),
                 if (pName != NULL) {
                     k_thread_name_set((k_tid_t)*pTaskHandle, pName);
                 }
+                U_PORT_TASK_STACK_REGISTER(*pTaskHandle, pName, stackSizeBytes);
                 errorCode = U_ERROR_COMMON_SUCCESS;
             }
         }
@@ -273,6 +318,7 @@ int32_t uPortTaskDelete(const uPortTaskHandle_t taskHandle)
     if (taskHandle == NULL) {
         thread = k_current_get();
     }
+    U_PORT_TASK_STACK_DEREGISTER(taskHandle);
     freeThreadInstance((struct k_thread *)thread);
     k_thread_abort(thread);
 
@@ -324,6 +370,44 @@ int32_t uPortTaskGetHandle(uPortTaskHandle_t *pTaskHandle)
     return (int32_t) errorCode;
 }
 
+// Get the run-time statistics of all tasks.
+int32_t uPortTaskGetRuntimeStats(uPortTaskRuntimeStats_t *pStats,
+                                 size_t maxNumStats,
+                                 int32_t *pIdlePercent)
+{
+    int32_t errorCodeOrNumStats = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#if defined(CONFIG_THREAD_MONITOR) && defined(CONFIG_THREAD_RUNTIME_STATS)
+    uPortOsRuntimeStatsContext_t context = {0};
+
+    errorCodeOrNumStats = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    if ((pStats != NULL) || (maxNumStats == 0)) {
+        context.pStats = pStats;
+        context.maxNumStats = maxNumStats;
+        k_thread_foreach(runtimeStatsCallback, &context);
+        for (size_t x = 0; x < context.numStats; x++) {
+            pStats[x].percent = 0;
+            if (context.totalTicks > 0) {
+                pStats[x].percent = (int32_t) ((pStats[x].runtimeTicks * 100) /
+                                               context.totalTicks);
+            }
+        }
+        if (pIdlePercent != NULL) {
+            *pIdlePercent = 0;
+            if (context.totalTicks > 0) {
+                *pIdlePercent = (int32_t) ((context.idleTicks * 100) / context.totalTicks);
+            }
+        }
+        errorCodeOrNumStats = (int32_t) context.numStats;
+    }
+#else
+    (void) pStats;
+    (void) maxNumStats;
+    (void) pIdlePercent;
+#endif
+
+    return errorCodeOrNumStats;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: QUEUES
  * -------------------------------------------------------------- */
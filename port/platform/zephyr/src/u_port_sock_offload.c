@@ -0,0 +1,911 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Implementation of a Zephyr socket offload driver on top of
+ * the ubxlib sockets API: each Zephyr socket file descriptor refers
+ * to an entry in gSocket[], which holds the ubxlib socket descriptor
+ * and the level-triggered readiness that zsock_poll() needs, built
+ * up from the edge-triggered events of uSockPollWait().
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include <zephyr/types.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_offload.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/net/socket_offload.h>
+#include <zephyr/sys/fdtable.h>
+#include <fcntl.h>  // F_GETFL, F_SETFL, O_NONBLOCK
+
+#include "sockets_internal.h" // struct socket_op_vtable, from subsys/net/lib/sockets
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdlib.h"    // malloc(), free(), strtol()
+#include "string.h"    // memset(), memcpy()
+#include "errno.h"
+#include "sys/time.h"  // struct timeval
+
+#include "u_cfg_sw.h"
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_device.h"
+#include "u_sock.h"
+#include "u_sock_errno.h"
+
+#include "u_port_sock_offload.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** All of the uSockPollWait() events we keep track of.
+ */
+#define U_PORT_SOCK_OFFLOAD_EVENTS_ALL (U_SOCK_POLL_EVENT_READ |   \
+                                        U_SOCK_POLL_EVENT_WRITE |  \
+                                        U_SOCK_POLL_EVENT_CLOSED | \
+                                        U_SOCK_POLL_EVENT_ERROR)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** An offloaded socket.
+ */
+typedef struct {
+    uSockDescriptor_t descriptor; /**< -1 if the entry is free. */
+    int fd;                       /**< the Zephyr file descriptor. */
+    int family;
+    uint32_t ready;               /**< U_SOCK_POLL_EVENT_xxx bitmap, set by
+                                       uSockPollWait() events, cleared
+                                       when a read or write would block. */
+    bool nonBlocking;             /**< O_NONBLOCK. */
+    bool receiveTimeoutSet;       /**< SO_RCVTIMEO has been set. */
+} uPortSockOffload_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Mutex to protect gSocket[] and gDevHandle.
+ */
+static K_MUTEX_DEFINE(gMutex);
+
+/** The device sockets are offloaded to, NULL if not started.
+ */
+static uDeviceHandle_t gDevHandle = NULL;
+
+/** The offloaded sockets.
+ */
+static uPortSockOffload_t gSocket[U_SOCK_MAX_NUM_SOCKETS];
+
+/** Forward declaration of the vtable, for z_get_fd_obj().
+ */
+static const struct socket_op_vtable gVtable;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: HELPERS
+ * -------------------------------------------------------------- */
+
+// Convert a negative U_SOCK_Exxx error code into a Zephyr errno,
+// set errno to it and return -1; the numbering of u_sock_errno.h
+// is that of Linux, which Zephyr does not share beyond the first
+// few values.
+static int setErrno(int32_t errorCode)
+{
+    int err;
+
+    switch (-errorCode) {
+        case U_SOCK_EAGAIN:
+            err = EAGAIN;
+            break;
+        case U_SOCK_EBADF:
+            err = EBADF;
+            break;
+        case U_SOCK_ENOMEM:
+            err = ENOMEM;
+            break;
+        case U_SOCK_EINVAL:
+            err = EINVAL;
+            break;
+        case U_SOCK_EPIPE:
+            err = EPIPE;
+            break;
+        case U_SOCK_ENOSYS:
+            err = ENOSYS;
+            break;
+        case U_SOCK_EMSGSIZE:
+            err = EMSGSIZE;
+            break;
+        case U_SOCK_ENOPROTOOPT:
+            err = ENOPROTOOPT;
+            break;
+        case U_SOCK_EOPNOTSUPP:
+            err = EOPNOTSUPP;
+            break;
+        case U_SOCK_EAFNOSUPPORT:
+            err = EAFNOSUPPORT;
+            break;
+        case U_SOCK_EADDRINUSE:
+            err = EADDRINUSE;
+            break;
+        case U_SOCK_ENETDOWN:
+            err = ENETDOWN;
+            break;
+        case U_SOCK_ENETUNREACH:
+            err = ENETUNREACH;
+            break;
+        case U_SOCK_ECONNABORTED:
+            err = ECONNABORTED;
+            break;
+        case U_SOCK_ECONNRESET:
+            err = ECONNRESET;
+            break;
+        case U_SOCK_ENOBUFS:
+            err = ENOBUFS;
+            break;
+        case U_SOCK_EISCONN:
+            err = EISCONN;
+            break;
+        case U_SOCK_ENOTCONN:
+            err = ENOTCONN;
+            break;
+        case U_SOCK_ETIMEDOUT:
+            err = ETIMEDOUT;
+            break;
+        case U_SOCK_ECONNREFUSED:
+            err = ECONNREFUSED;
+            break;
+        case U_SOCK_EHOSTUNREACH:
+            err = EHOSTUNREACH;
+            break;
+        case U_SOCK_EALREADY:
+            err = EALREADY;
+            break;
+        case U_SOCK_EINPROGRESS:
+            err = EINPROGRESS;
+            break;
+        default:
+            err = EIO;
+            break;
+    }
+    errno = err;
+
+    return -1;
+}
+
+// Convert a Zephyr socket address into a ubxlib one.
+static int toUSockAddress(const struct sockaddr *pAddr, socklen_t addrLength,
+                          uSockAddress_t *pAddress)
+{
+    int errorCode = -U_SOCK_EAFNOSUPPORT;
+    const struct sockaddr_in *pAddr4;
+    const struct sockaddr_in6 *pAddr6;
+    const uint8_t *pIp6;
+
+    memset(pAddress, 0, sizeof(*pAddress));
+    if ((pAddr->sa_family == AF_INET) && (addrLength >= sizeof(struct sockaddr_in))) {
+        pAddr4 = (const struct sockaddr_in *) pAddr;
+        pAddress->ipAddress.type = U_SOCK_ADDRESS_TYPE_V4;
+        pAddress->ipAddress.address.ipv4 = ntohl(pAddr4->sin_addr.s_addr);
+        pAddress->port = ntohs(pAddr4->sin_port);
+        errorCode = 0;
+    } else if ((pAddr->sa_family == AF_INET6) && (addrLength >= sizeof(struct sockaddr_in6))) {
+        pAddr6 = (const struct sockaddr_in6 *) pAddr;
+        pIp6 = pAddr6->sin6_addr.s6_addr;
+        pAddress->ipAddress.type = U_SOCK_ADDRESS_TYPE_V6;
+        // ubxlib keeps the most significant word last
+        for (size_t x = 0; x < 4; x++) {
+            pAddress->ipAddress.address.ipv6[3 - x] = (((uint32_t) pIp6[x * 4]) << 24) |
+                                                      (((uint32_t) pIp6[(x * 4) + 1]) << 16) |
+                                                      (((uint32_t) pIp6[(x * 4) + 2]) << 8) |
+                                                      pIp6[(x * 4) + 3];
+        }
+        pAddress->port = ntohs(pAddr6->sin6_port);
+        errorCode = 0;
+    }
+
+    return errorCode;
+}
+
+// Convert a ubxlib socket address into a Zephyr one, returning
+// the length written.
+static socklen_t fromUSockAddress(const uSockAddress_t *pAddress,
+                                  struct sockaddr *pAddr, socklen_t addrLength)
+{
+    struct sockaddr_in6 addr6 = {0};
+    struct sockaddr_in *pAddr4 = (struct sockaddr_in *) &addr6;
+    socklen_t length;
+    uint32_t word;
+
+    if (pAddress->ipAddress.type == U_SOCK_ADDRESS_TYPE_V6) {
+        addr6.sin6_family = AF_INET6;
+        addr6.sin6_port = htons(pAddress->port);
+        for (size_t x = 0; x < 4; x++) {
+            word = pAddress->ipAddress.address.ipv6[3 - x];
+            addr6.sin6_addr.s6_addr[x * 4] = (uint8_t) (word >> 24);
+            addr6.sin6_addr.s6_addr[(x * 4) + 1] = (uint8_t) (word >> 16);
+            addr6.sin6_addr.s6_addr[(x * 4) + 2] = (uint8_t) (word >> 8);
+            addr6.sin6_addr.s6_addr[(x * 4) + 3] = (uint8_t) word;
+        }
+        length = sizeof(struct sockaddr_in6);
+    } else {
+        pAddr4->sin_family = AF_INET;
+        pAddr4->sin_port = htons(pAddress->port);
+        pAddr4->sin_addr.s_addr = htonl(pAddress->ipAddress.address.ipv4);
+        length = sizeof(struct sockaddr_in);
+    }
+    if (pAddr != NULL) {
+        memcpy(pAddr, &addr6, (length < addrLength) ? length : addrLength);
+    }
+
+    return length;
+}
+
+// Find the entry for a ubxlib socket descriptor: gMutex must be locked.
+static uPortSockOffload_t *pFindDescriptor(uSockDescriptor_t descriptor)
+{
+    uPortSockOffload_t *pSocket = NULL;
+
+    for (size_t x = 0; (x < sizeof(gSocket) / sizeof(gSocket[0])) &&
+         (pSocket == NULL); x++) {
+        if (gSocket[x].descriptor == descriptor) {
+            pSocket = &(gSocket[x]);
+        }
+    }
+
+    return pSocket;
+}
+
+// Wrap a new ubxlib socket in a Zephyr file descriptor, returning
+// the file descriptor or -1 with errno set.
+static int newFd(uSockDescriptor_t descriptor, int family)
+{
+    int fd;
+    uPortSockOffload_t *pSocket;
+
+    fd = z_reserve_fd();
+    if (fd >= 0) {
+        k_mutex_lock(&gMutex, K_FOREVER);
+        pSocket = pFindDescriptor(-1);
+        if (pSocket != NULL) {
+            memset(pSocket, 0, sizeof(*pSocket));
+            pSocket->descriptor = descriptor;
+            pSocket->fd = fd;
+            pSocket->family = family;
+            // Register for all events: the registration itself
+            // reports readable and writable, which is what we want
+            // since data may already be waiting
+            uSockPollSet(descriptor, U_PORT_SOCK_OFFLOAD_EVENTS_ALL);
+            z_finalize_fd(fd, pSocket, (const struct fd_op_vtable *) &gVtable);
+        } else {
+            z_free_fd(fd);
+            fd = -1;
+            errno = ENFILE;
+        }
+        k_mutex_unlock(&gMutex);
+    }
+    if (fd < 0) {
+        uSockClose(descriptor);
+    }
+
+    return fd;
+}
+
+// Update the readiness of the sockets from any events waiting in
+// uSockPollWait(), waiting up to timeMs for one; returns true if
+// there was at least one event.
+static bool collectEvents(int32_t timeMs)
+{
+    uSockPollEvent_t events[U_PORT_SOCK_OFFLOAD_POLL_MAX_NUM_EVENTS];
+    uPortSockOffload_t *pSocket;
+    int32_t numEvents;
+
+    // Not under gMutex since this may block
+    numEvents = uSockPollWait(events, sizeof(events) / sizeof(events[0]), timeMs);
+    if (numEvents > 0) {
+        k_mutex_lock(&gMutex, K_FOREVER);
+        for (int32_t x = 0; x < numEvents; x++) {
+            pSocket = pFindDescriptor(events[x].descriptor);
+            if (pSocket != NULL) {
+                pSocket->ready |= events[x].events;
+            }
+        }
+        k_mutex_unlock(&gMutex);
+    }
+
+    return (numEvents > 0);
+}
+
+// Work out the revents for a pollfd from the readiness of a socket.
+static short pollRevents(const uPortSockOffload_t *pSocket, short events)
+{
+    short revents = 0;
+
+    if (pSocket->ready & (U_SOCK_POLL_EVENT_READ | U_SOCK_POLL_EVENT_CLOSED)) {
+        revents |= events & ZSOCK_POLLIN;
+    }
+    if (pSocket->ready & U_SOCK_POLL_EVENT_WRITE) {
+        revents |= events & ZSOCK_POLLOUT;
+    }
+    if (pSocket->ready & U_SOCK_POLL_EVENT_CLOSED) {
+        revents |= ZSOCK_POLLHUP;
+    }
+    if (pSocket->ready & U_SOCK_POLL_EVENT_ERROR) {
+        revents |= ZSOCK_POLLERR;
+    }
+
+    return revents;
+}
+
+// Implement zsock_poll() over offloaded sockets.
+static int pollOffload(struct zsock_pollfd *pFds, int numFds, int timeoutMs)
+{
+    int numReady;
+    int64_t startTimeMs = k_uptime_get();
+    int32_t waitMs;
+    uPortSockOffload_t *pSocket;
+
+    for (;;) {
+        // Pick up anything that has already happened
+        while (collectEvents(0)) {}
+        numReady = 0;
+        k_mutex_lock(&gMutex, K_FOREVER);
+        for (int x = 0; x < numFds; x++) {
+            pFds[x].revents = 0;
+            if (pFds[x].fd >= 0) {
+                pSocket = (uPortSockOffload_t *) z_get_fd_obj(pFds[x].fd,
+                                                             (const struct fd_op_vtable *) &gVtable,
+                                                             0);
+                if (pSocket != NULL) {
+                    pFds[x].revents = pollRevents(pSocket, pFds[x].events);
+                } else {
+                    pFds[x].revents = ZSOCK_POLLNVAL;
+                }
+                if (pFds[x].revents != 0) {
+                    numReady++;
+                }
+            }
+        }
+        k_mutex_unlock(&gMutex);
+        if (numReady > 0) {
+            break;
+        }
+        waitMs = -1;
+        if (timeoutMs >= 0) {
+            waitMs = timeoutMs - (int32_t) (k_uptime_get() - startTimeMs);
+            if (waitMs <= 0) {
+                break;
+            }
+        }
+        collectEvents(waitMs);
+    }
+
+    return numReady;
+}
+
+// Clear readiness bits of a socket.
+static void readyClear(uPortSockOffload_t *pSocket, uint32_t events)
+{
+    k_mutex_lock(&gMutex, K_FOREVER);
+    pSocket->ready &= ~events;
+    k_mutex_unlock(&gMutex);
+}
+
+// Receive, with or without an address, implementing Zephyr blocking
+// semantics: a blocking socket without SO_RCVTIMEO waits forever.
+static ssize_t receive(uPortSockOffload_t *pSocket, void *pBuffer, size_t length,
+                       int flags, uSockAddress_t *pAddress)
+{
+    int32_t errorCodeOrLength;
+    bool wait = !pSocket->nonBlocking && ((flags & ZSOCK_MSG_DONTWAIT) == 0);
+
+    uSockBlockingSet(pSocket->descriptor, wait);
+    do {
+        if (pAddress != NULL) {
+            errorCodeOrLength = uSockReceiveFrom(pSocket->descriptor, pAddress,
+                                                 pBuffer, length);
+        } else {
+            errorCodeOrLength = uSockRead(pSocket->descriptor, pBuffer, length);
+        }
+    } while (wait && !pSocket->receiveTimeoutSet &&
+             (errorCodeOrLength == -U_SOCK_EWOULDBLOCK));
+    if ((errorCodeOrLength < 0) ||
+        ((pAddress == NULL) && (errorCodeOrLength < (int32_t) length))) {
+        // Nothing more to read until the next READ event
+        readyClear(pSocket, U_SOCK_POLL_EVENT_READ);
+    }
+    if ((errorCodeOrLength == -U_SOCK_ENOTCONN) &&
+        (pSocket->ready & U_SOCK_POLL_EVENT_CLOSED)) {
+        // The far end has closed: that's end-of-file
+        errorCodeOrLength = 0;
+    }
+
+    return (errorCodeOrLength >= 0) ? errorCodeOrLength : setErrno(errorCodeOrLength);
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: THE VTABLE
+ * -------------------------------------------------------------- */
+
+static ssize_t offloadRead(void *pObj, void *pBuffer, size_t length)
+{
+    return receive((uPortSockOffload_t *) pObj, pBuffer, length, 0, NULL);
+}
+
+static ssize_t offloadWrite(void *pObj, const void *pBuffer, size_t length)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    int32_t errorCodeOrLength;
+
+    uSockBlockingSet(pSocket->descriptor, !pSocket->nonBlocking);
+    errorCodeOrLength = uSockWrite(pSocket->descriptor, pBuffer, length);
+    if (errorCodeOrLength == -U_SOCK_EWOULDBLOCK) {
+        readyClear(pSocket, U_SOCK_POLL_EVENT_WRITE);
+    }
+
+    return (errorCodeOrLength >= 0) ? errorCodeOrLength : setErrno(errorCodeOrLength);
+}
+
+static int offloadClose(void *pObj)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    uSockDescriptor_t descriptor;
+    int32_t errorCode;
+
+    k_mutex_lock(&gMutex, K_FOREVER);
+    descriptor = pSocket->descriptor;
+    pSocket->descriptor = -1;
+    k_mutex_unlock(&gMutex);
+    // uSockClose() also removes the poll interest
+    errorCode = uSockClose(descriptor);
+
+    return (errorCode == 0) ? 0 : setErrno(errorCode);
+}
+
+static int offloadIoctl(void *pObj, unsigned int request, va_list args)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    int returnValue = -1;
+    struct zsock_pollfd *pFds;
+    int numFds;
+    int timeoutMs;
+
+    switch (request) {
+        case ZFD_IOCTL_POLL_PREPARE:
+            // Tell zsock_poll() to hand the whole poll to us
+            returnValue = -EXDEV;
+            break;
+        case ZFD_IOCTL_POLL_UPDATE:
+            errno = EOPNOTSUPP;
+            break;
+        case ZFD_IOCTL_POLL_OFFLOAD:
+            pFds = va_arg(args, struct zsock_pollfd *);
+            numFds = va_arg(args, int);
+            timeoutMs = va_arg(args, int);
+            returnValue = pollOffload(pFds, numFds, timeoutMs);
+            break;
+        case F_GETFL:
+            returnValue = pSocket->nonBlocking ? O_NONBLOCK : 0;
+            break;
+        case F_SETFL:
+            pSocket->nonBlocking = ((va_arg(args, int) & O_NONBLOCK) != 0);
+            returnValue = 0;
+            break;
+        default:
+            errno = EINVAL;
+            break;
+    }
+
+    return returnValue;
+}
+
+static int offloadBind(void *pObj, const struct sockaddr *pAddr, socklen_t addrLength)
+{
+    uSockAddress_t address;
+    int32_t errorCode = toUSockAddress(pAddr, addrLength, &address);
+
+    if (errorCode == 0) {
+        errorCode = uSockBind(((uPortSockOffload_t *) pObj)->descriptor, &address);
+    }
+
+    return (errorCode == 0) ? 0 : setErrno(errorCode);
+}
+
+static int offloadConnect(void *pObj, const struct sockaddr *pAddr, socklen_t addrLength)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    uSockAddress_t address;
+    int32_t errorCode = toUSockAddress(pAddr, addrLength, &address);
+
+    if (errorCode == 0) {
+        errorCode = uSockConnect(pSocket->descriptor, &address);
+    }
+
+    return (errorCode == 0) ? 0 : setErrno(errorCode);
+}
+
+static int offloadListen(void *pObj, int backlog)
+{
+    int32_t errorCode = uSockListen(((uPortSockOffload_t *) pObj)->descriptor,
+                                    backlog);
+
+    return (errorCode == 0) ? 0 : setErrno(errorCode);
+}
+
+static int offloadAccept(void *pObj, struct sockaddr *pAddr, socklen_t *pAddrLength)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    uSockAddress_t address;
+    int32_t descriptorOrError;
+    int fd = -1;
+
+    uSockBlockingSet(pSocket->descriptor, !pSocket->nonBlocking);
+    descriptorOrError = uSockAccept(pSocket->descriptor, &address);
+    if (descriptorOrError >= 0) {
+        fd = newFd(descriptorOrError, pSocket->family);
+        if ((fd >= 0) && (pAddr != NULL) && (pAddrLength != NULL)) {
+            *pAddrLength = fromUSockAddress(&address, pAddr, *pAddrLength);
+        }
+    } else {
+        readyClear(pSocket, U_SOCK_POLL_EVENT_READ);
+        setErrno(descriptorOrError);
+    }
+
+    return fd;
+}
+
+static ssize_t offloadSendTo(void *pObj, const void *pBuffer, size_t length,
+                             int flags, const struct sockaddr *pAddr,
+                             socklen_t addrLength)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    uSockAddress_t address;
+    int32_t errorCodeOrLength = 0;
+
+    if (pAddr == NULL) {
+        return offloadWrite(pObj, pBuffer, length);
+    }
+    errorCodeOrLength = toUSockAddress(pAddr, addrLength, &address);
+    if (errorCodeOrLength == 0) {
+        uSockBlockingSet(pSocket->descriptor, !pSocket->nonBlocking &&
+                         ((flags & ZSOCK_MSG_DONTWAIT) == 0));
+        errorCodeOrLength = uSockSendTo(pSocket->descriptor, &address, pBuffer, length);
+    }
+
+    return (errorCodeOrLength >= 0) ? errorCodeOrLength : setErrno(errorCodeOrLength);
+}
+
+static ssize_t offloadSendMsg(void *pObj, const struct msghdr *pMsg, int flags)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    uSockAddress_t address;
+    uSockAddress_t *pAddress = NULL;
+    int32_t errorCodeOrLength = 0;
+
+    (void) flags;
+
+    if (pMsg->msg_name != NULL) {
+        errorCodeOrLength = toUSockAddress((const struct sockaddr *) pMsg->msg_name,
+                                           pMsg->msg_namelen, &address);
+        pAddress = &address;
+    }
+    if (errorCodeOrLength == 0) {
+        uSockBlockingSet(pSocket->descriptor, !pSocket->nonBlocking);
+        // struct iovec and uSockIoVec_t are both a pointer and a length
+        errorCodeOrLength = uSockSendv(pSocket->descriptor, pAddress,
+                                       (const uSockIoVec_t *) pMsg->msg_iov,
+                                       pMsg->msg_iovlen);
+    }
+
+    return (errorCodeOrLength >= 0) ? errorCodeOrLength : setErrno(errorCodeOrLength);
+}
+
+static ssize_t offloadRecvFrom(void *pObj, void *pBuffer, size_t length, int flags,
+                               struct sockaddr *pAddr, socklen_t *pAddrLength)
+{
+    uSockAddress_t address;
+    ssize_t lengthOrError;
+
+    if ((pAddr == NULL) || (pAddrLength == NULL)) {
+        return receive((uPortSockOffload_t *) pObj, pBuffer, length, flags, NULL);
+    }
+    lengthOrError = receive((uPortSockOffload_t *) pObj, pBuffer, length, flags, &address);
+    if (lengthOrError >= 0) {
+        *pAddrLength = fromUSockAddress(&address, pAddr, *pAddrLength);
+    }
+
+    return lengthOrError;
+}
+
+static int offloadGetSockOpt(void *pObj, int level, int option,
+                             void *pValue, socklen_t *pValueLength)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    struct timeval timeval;
+    size_t length;
+    int32_t errorCode = -U_SOCK_ENOPROTOOPT;
+
+    if ((level == SOL_SOCKET) && (option == SO_ERROR) &&
+        (*pValueLength >= sizeof(int))) {
+        *((int *) pValue) = (pSocket->ready & U_SOCK_POLL_EVENT_ERROR) ? ECONNREFUSED : 0;
+        *pValueLength = sizeof(int);
+        readyClear(pSocket, U_SOCK_POLL_EVENT_ERROR);
+        errorCode = 0;
+    } else if ((level == SOL_SOCKET) &&
+               ((option == SO_RCVTIMEO) || (option == SO_SNDTIMEO)) &&
+               (*pValueLength >= sizeof(struct zsock_timeval))) {
+        length = sizeof(timeval);
+        errorCode = uSockOptionGet(pSocket->descriptor, U_SOCK_OPT_LEVEL_SOCK,
+                                   (option == SO_RCVTIMEO) ? U_SOCK_OPT_RCVTIMEO :
+                                   U_SOCK_OPT_SNDTIMEO, &timeval, &length);
+        if (errorCode == 0) {
+            ((struct zsock_timeval *) pValue)->tv_sec = timeval.tv_sec;
+            ((struct zsock_timeval *) pValue)->tv_usec = timeval.tv_usec;
+            *pValueLength = sizeof(struct zsock_timeval);
+        }
+    } else if (((level == SOL_SOCKET) &&
+                ((option == SO_REUSEADDR) || (option == SO_KEEPALIVE))) ||
+               ((level == IPPROTO_TCP) && (option == TCP_NODELAY))) {
+        // Options whose values are an int in both APIs
+        length = *pValueLength;
+        errorCode = uSockOptionGet(pSocket->descriptor,
+                                   (level == SOL_SOCKET) ? U_SOCK_OPT_LEVEL_SOCK :
+                                   U_SOCK_OPT_LEVEL_TCP,
+                                   (option == SO_REUSEADDR) ? U_SOCK_OPT_REUSEADDR :
+                                   (option == SO_KEEPALIVE) ? U_SOCK_OPT_KEEPALIVE :
+                                   U_SOCK_OPT_TCP_NODELAY, pValue, &length);
+        *pValueLength = length;
+    }
+
+    return (errorCode == 0) ? 0 : setErrno(errorCode);
+}
+
+static int offloadSetSockOpt(void *pObj, int level, int option,
+                             const void *pValue, socklen_t valueLength)
+{
+    uPortSockOffload_t *pSocket = (uPortSockOffload_t *) pObj;
+    struct timeval timeval;
+    int32_t errorCode = -U_SOCK_ENOPROTOOPT;
+
+    if ((level == SOL_SOCKET) &&
+        ((option == SO_RCVTIMEO) || (option == SO_SNDTIMEO)) &&
+        (valueLength >= sizeof(struct zsock_timeval))) {
+        timeval.tv_sec = ((const struct zsock_timeval *) pValue)->tv_sec;
+        timeval.tv_usec = ((const struct zsock_timeval *) pValue)->tv_usec;
+        errorCode = uSockOptionSet(pSocket->descriptor, U_SOCK_OPT_LEVEL_SOCK,
+                                   (option == SO_RCVTIMEO) ? U_SOCK_OPT_RCVTIMEO :
+                                   U_SOCK_OPT_SNDTIMEO, &timeval, sizeof(timeval));
+        if ((errorCode == 0) && (option == SO_RCVTIMEO)) {
+            pSocket->receiveTimeoutSet = (timeval.tv_sec != 0) || (timeval.tv_usec != 0);
+        }
+    } else if (((level == SOL_SOCKET) &&
+                ((option == SO_REUSEADDR) || (option == SO_KEEPALIVE))) ||
+               ((level == IPPROTO_TCP) && (option == TCP_NODELAY))) {
+        errorCode = uSockOptionSet(pSocket->descriptor,
+                                   (level == SOL_SOCKET) ? U_SOCK_OPT_LEVEL_SOCK :
+                                   U_SOCK_OPT_LEVEL_TCP,
+                                   (option == SO_REUSEADDR) ? U_SOCK_OPT_REUSEADDR :
+                                   (option == SO_KEEPALIVE) ? U_SOCK_OPT_KEEPALIVE :
+                                   U_SOCK_OPT_TCP_NODELAY, pValue, valueLength);
+    }
+
+    return (errorCode == 0) ? 0 : setErrno(errorCode);
+}
+
+static int offloadGetPeerName(void *pObj, struct sockaddr *pAddr,
+                              socklen_t *pAddrLength)
+{
+    uSockAddress_t address;
+    int32_t errorCode = uSockGetRemoteAddress(((uPortSockOffload_t *) pObj)->descriptor,
+                                              &address);
+
+    if (errorCode == 0) {
+        *pAddrLength = fromUSockAddress(&address, pAddr, *pAddrLength);
+    }
+
+    return (errorCode == 0) ? 0 : setErrno(errorCode);
+}
+
+static int offloadGetSockName(void *pObj, struct sockaddr *pAddr,
+                              socklen_t *pAddrLength)
+{
+    uSockAddress_t address;
+    int32_t errorCode = uSockGetLocalAddress(((uPortSockOffload_t *) pObj)->descriptor,
+                                             &address);
+
+    if (errorCode == 0) {
+        *pAddrLength = fromUSockAddress(&address, pAddr, *pAddrLength);
+    }
+
+    return (errorCode == 0) ? 0 : setErrno(errorCode);
+}
+
+static const struct socket_op_vtable gVtable = {
+    .fd_vtable = {
+        .read = offloadRead,
+        .write = offloadWrite,
+        .close = offloadClose,
+        .ioctl = offloadIoctl,
+    },
+    .bind = offloadBind,
+    .connect = offloadConnect,
+    .listen = offloadListen,
+    .accept = offloadAccept,
+    .sendto = offloadSendTo,
+    .sendmsg = offloadSendMsg,
+    .recvfrom = offloadRecvFrom,
+    .getsockopt = offloadGetSockOpt,
+    .setsockopt = offloadSetSockOpt,
+    .getpeername = offloadGetPeerName,
+    .getsockname = offloadGetSockName,
+};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: SOCKET CREATION AND DNS
+ * -------------------------------------------------------------- */
+
+// Whether we handle a given socket: anything TCP or UDP, not TLS.
+static bool isSupported(int family, int type, int protocol)
+{
+    return (gDevHandle != NULL) &&
+           ((family == AF_INET) || (family == AF_INET6)) &&
+           (((type == SOCK_STREAM) && ((protocol == 0) || (protocol == IPPROTO_TCP))) ||
+            ((type == SOCK_DGRAM) && ((protocol == 0) || (protocol == IPPROTO_UDP))));
+}
+
+// Create a socket.
+static int socketCreate(int family, int type, int protocol)
+{
+    int32_t descriptorOrError = -U_SOCK_ENETDOWN;
+    uDeviceHandle_t devHandle;
+
+    k_mutex_lock(&gMutex, K_FOREVER);
+    devHandle = gDevHandle;
+    k_mutex_unlock(&gMutex);
+    if (devHandle != NULL) {
+        descriptorOrError = uSockCreate(devHandle,
+                                        (type == SOCK_STREAM) ? U_SOCK_TYPE_STREAM :
+                                        U_SOCK_TYPE_DGRAM,
+                                        (type == SOCK_STREAM) ? U_SOCK_PROTOCOL_TCP :
+                                        U_SOCK_PROTOCOL_UDP);
+    }
+
+    return (descriptorOrError >= 0) ? newFd(descriptorOrError, family) :
+           setErrno(descriptorOrError);
+}
+
+// DNS look-up with uSockGetHostByName(): a single result, of the
+// type the module returns, in one allocation with its address.
+static int getAddrInfo(const char *pNode, const char *pService,
+                       const struct zsock_addrinfo *pHints,
+                       struct zsock_addrinfo **ppResult)
+{
+    int errorCode = DNS_EAI_FAIL;
+    uSockAddress_t address = {0};
+    struct zsock_addrinfo *pResult;
+    uDeviceHandle_t devHandle;
+
+    k_mutex_lock(&gMutex, K_FOREVER);
+    devHandle = gDevHandle;
+    k_mutex_unlock(&gMutex);
+    if ((devHandle != NULL) && (pNode != NULL) &&
+        ((uSockStringToAddress(pNode, &address) == 0) ||
+         (uSockGetHostByName(devHandle, pNode, &(address.ipAddress)) == 0))) {
+        errorCode = DNS_EAI_MEMORY;
+        if (pService != NULL) {
+            address.port = (uint16_t) strtol(pService, NULL, 10);
+        }
+        pResult = (struct zsock_addrinfo *) malloc(sizeof(struct zsock_addrinfo) +
+                                                   sizeof(struct sockaddr_in6));
+        if (pResult != NULL) {
+            memset(pResult, 0, sizeof(*pResult));
+            pResult->ai_addr = (struct sockaddr *) (pResult + 1);
+            pResult->ai_addrlen = fromUSockAddress(&address, pResult->ai_addr,
+                                                   sizeof(struct sockaddr_in6));
+            pResult->ai_family = pResult->ai_addr->sa_family;
+            if (pHints != NULL) {
+                pResult->ai_socktype = pHints->ai_socktype;
+                pResult->ai_protocol = pHints->ai_protocol;
+            }
+            *ppResult = pResult;
+            errorCode = 0;
+        }
+    }
+
+    return errorCode;
+}
+
+static void freeAddrInfo(struct zsock_addrinfo *pResult)
+{
+    free(pResult);
+}
+
+static const struct socket_dns_offload gDnsOffload = {
+    .getaddrinfo = getAddrInfo,
+    .freeaddrinfo = freeAddrInfo,
+};
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: THE NETWORK INTERFACE
+ * -------------------------------------------------------------- */
+
+static void ifaceInit(struct net_if *pIface)
+{
+    pIface->if_dev->offloaded = true;
+    socket_offload_dns_register(&gDnsOffload);
+}
+
+static int offloadInit(const struct device *pDevice)
+{
+    (void) pDevice;
+
+    for (size_t x = 0; x < sizeof(gSocket) / sizeof(gSocket[0]); x++) {
+        gSocket[x].descriptor = -1;
+    }
+
+    return 0;
+}
+
+static struct net_if_api gIfaceApi = {
+    .init = ifaceInit,
+};
+
+NET_DEVICE_OFFLOAD_INIT(ubxlib_sock_offload, "ubxlib_sock_offload",
+                        offloadInit, NULL, NULL, NULL,
+                        CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &gIfaceApi,
+                        U_PORT_SOCK_OFFLOAD_MTU);
+
+NET_SOCKET_OFFLOAD_REGISTER(ubxlib_sock_offload, CONFIG_NET_SOCKETS_OFFLOAD_PRIORITY,
+                            AF_UNSPEC, isSupported, socketCreate);
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start offloading sockets to a device.
+int32_t uPortSockOffloadStart(uDeviceHandle_t devHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (devHandle != NULL) {
+        k_mutex_lock(&gMutex, K_FOREVER);
+        gDevHandle = devHandle;
+        k_mutex_unlock(&gMutex);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Stop offloading sockets.
+void uPortSockOffloadStop()
+{
+    k_mutex_lock(&gMutex, K_FOREVER);
+    gDevHandle = NULL;
+    k_mutex_unlock(&gMutex);
+}
+
+// End of file
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_PORT_SOCK_OFFLOAD_H_
+#define _U_PORT_SOCK_OFFLOAD_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device.h"
+
+/** @file
+ * @brief Zephyr only: a socket offload driver that maps the Zephyr
+ * socket API (zsock_socket(), zsock_recv(), zsock_poll(), etc., and
+ * hence the Zephyr MQTT and HTTP libraries) directly onto the ubxlib
+ * sockets API of u_sock.h, so that a Zephyr application can use the
+ * IP stack of a cellular or Wi-Fi module without any bridging of its
+ * own.  Enable it with CONFIG_UBXLIB_SOCK_OFFLOAD and then, once the
+ * network on the device is up, call uPortSockOffloadStart().
+ *
+ * Limitations:
+ * - TCP and UDP over IPv4 or IPv6 only; TLS is not offloaded (use
+ *   the ubxlib security API with uSockSecurity() directly for that),
+ * - connect() always blocks,
+ * - zsock_poll() is implemented with uSockPollWait(), hence only one
+ *   task should be in zsock_poll() on offloaded sockets at a time,
+ * - getaddrinfo() returns a single address from uSockGetHostByName().
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_SOCK_OFFLOAD_MTU
+/** The MTU to report for the offloaded network interface.
+ */
+# define U_PORT_SOCK_OFFLOAD_MTU 1500
+#endif
+
+#ifndef U_PORT_SOCK_OFFLOAD_POLL_MAX_NUM_EVENTS
+/** The number of events fetched from uSockPollWait() in one go.
+ */
+# define U_PORT_SOCK_OFFLOAD_POLL_MAX_NUM_EVENTS 4
+#endif
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Start offloading Zephyr sockets to the given device: sockets
+ * created through the Zephyr socket API from now on will be created
+ * with uSockCreate() on this device.  The network on the device
+ * should already be up (see uNetworkInterfaceUp()).
+ *
+ * @param devHandle the handle of the device, e.g. as returned by
+ *                  uDeviceOpen().
+ * @return          zero on success else negative error code.
+ */
+int32_t uPortSockOffloadStart(uDeviceHandle_t devHandle);
+
+/** Stop offloading Zephyr sockets: sockets that are already open
+ * remain usable until they are closed but no more may be created.
+ */
+void uPortSockOffloadStop();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_PORT_SOCK_OFFLOAD_H_
+
+// End of file
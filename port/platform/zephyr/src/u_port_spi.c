@@ -0,0 +1,350 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Implementation of the port SPI API for the Zephyr platform.
+ */
+
+#include <zephyr/types.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/spi.h>
+
+#include <zephyr/device.h>
+#include <soc.h>
+
+#include "stddef.h"
+#include "stdint.h"
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_gpio.h"
+#include "u_port_spi.h"
+#include "version.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_PORT_SPI_MAX_NUM
+/** The number of SPI HW blocks that might be available; which ones
+ * actually are depends on the device tree.
+ */
+# define U_PORT_SPI_MAX_NUM 4
+#endif
+
+#ifndef U_PORT_SPI_FILL_BUFFER_LENGTH_BYTES
+/** The size of the buffer of #U_PORT_SPI_FILL_BYTE that is sent
+ * when the caller has nothing to send.
+ */
+# define U_PORT_SPI_FILL_BUFFER_LENGTH_BYTES 64
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Structure of the things we need to keep track of per SPI interface.
+ */
+typedef struct {
+    const struct device *pDevice;
+    struct spi_config config;
+    int32_t pinSelect;
+} uPortSpiData_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Mutex to ensure thread-safety.
+ */
+static uPortMutexHandle_t gMutex = NULL;
+
+/** SPI device data.
+ */
+static uPortSpiData_t gSpiData[U_PORT_SPI_MAX_NUM];
+
+/** Something to send when there is nothing to send.
+ */
+static char gFill[U_PORT_SPI_FILL_BUFFER_LENGTH_BYTES];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Get the device for the given SPI HW block.
+static const struct device *pGetDevice(int32_t spi)
+{
+    const struct device *pDevice = NULL;
+
+    switch (spi) {
+        case 0:
+#if KERNEL_VERSION_MAJOR < 3
+            pDevice = device_get_binding("SPI_0");
+#else
+            pDevice = DEVICE_DT_GET_OR_NULL(DT_NODELABEL(spi0));
+#endif
+            break;
+        case 1:
+#if KERNEL_VERSION_MAJOR < 3
+            pDevice = device_get_binding("SPI_1");
+#else
+            pDevice = DEVICE_DT_GET_OR_NULL(DT_NODELABEL(spi1));
+#endif
+            break;
+        case 2:
+#if KERNEL_VERSION_MAJOR < 3
+            pDevice = device_get_binding("SPI_2");
+#else
+            pDevice = DEVICE_DT_GET_OR_NULL(DT_NODELABEL(spi2));
+#endif
+            break;
+        case 3:
+#if KERNEL_VERSION_MAJOR < 3
+            pDevice = device_get_binding("SPI_3");
+#else
+            pDevice = DEVICE_DT_GET_OR_NULL(DT_NODELABEL(spi3));
+#endif
+            break;
+        default:
+            break;
+    }
+
+    return pDevice;
+}
+
+// Close an SPI instance.
+static void closeSpi(int32_t index)
+{
+    if (gSpiData[index].pDevice != NULL) {
+        spi_release(gSpiData[index].pDevice, &(gSpiData[index].config));
+        uPortGpioSet(gSpiData[index].pinSelect, 1);
+        gSpiData[index].pDevice = NULL;
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Initialise SPI handling.
+int32_t uPortSpiInit()
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (gMutex == NULL) {
+        errorCode = uPortMutexCreate(&gMutex);
+        if (errorCode == 0) {
+            memset(gFill, U_PORT_SPI_FILL_BYTE, sizeof(gFill));
+            for (size_t x = 0; x < sizeof(gSpiData) / sizeof(gSpiData[0]); x++) {
+                gSpiData[x].pDevice = NULL;
+                gSpiData[x].pinSelect = -1;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Shutdown SPI handling.
+void uPortSpiDeinit()
+{
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        for (size_t x = 0; x < sizeof(gSpiData) / sizeof(gSpiData[0]); x++) {
+            closeSpi(x);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+        uPortMutexDelete(gMutex);
+        gMutex = NULL;
+    }
+}
+
+// Open an SPI instance.
+int32_t uPortSpiOpen(int32_t spi, int32_t pinMosi, int32_t pinMiso,
+                     int32_t pinClk, int32_t pinSelect)
+{
+    int32_t handleOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    const struct device *pDevice;
+    uPortGpioConfig_t gpioConfig;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        handleOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        // On Zephyr the data/clock pins are set at compile time so
+        // those passed into here must be non-valid; chip select is
+        // driven as a GPIO by us
+        if ((spi >= 0) && (spi < sizeof(gSpiData) / sizeof(gSpiData[0])) &&
+            (gSpiData[spi].pDevice == NULL) && (pinMosi < 0) &&
+            (pinMiso < 0) && (pinClk < 0) && (pinSelect >= 0)) {
+            handleOrErrorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            pDevice = pGetDevice(spi);
+            if (pDevice != NULL) {
+                // Chip select is active low: set it high before
+                // making it an output
+                uPortGpioSet(pinSelect, 1);
+                U_PORT_GPIO_SET_DEFAULT(&gpioConfig);
+                gpioConfig.pin = pinSelect;
+                gpioConfig.direction = U_PORT_GPIO_DIRECTION_OUTPUT;
+                handleOrErrorCode = uPortGpioConfig(&gpioConfig);
+                if (handleOrErrorCode == 0) {
+                    // Mode 0, MSB first, 8-bit words; no chip select
+                    // control structure since we do chip select
+                    memset(&(gSpiData[spi].config), 0, sizeof(gSpiData[spi].config));
+                    gSpiData[spi].config.frequency = U_PORT_SPI_CLOCK_FREQUENCY_HERTZ;
+                    gSpiData[spi].config.operation = SPI_OP_MODE_MASTER | SPI_TRANSFER_MSB |
+                                                     SPI_WORD_SET(8);
+                    gSpiData[spi].pinSelect = pinSelect;
+                    // Hook the device data structure into the entry
+                    // to flag that it is in use
+                    gSpiData[spi].pDevice = pDevice;
+                    // Return the SPI HW block number as the handle
+                    handleOrErrorCode = spi;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return handleOrErrorCode;
+}
+
+// Close an SPI instance.
+void uPortSpiClose(int32_t handle)
+{
+    if ((gMutex != NULL) && (handle >= 0) &&
+        (handle < sizeof(gSpiData) / sizeof(gSpiData[0]))) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        closeSpi(handle);
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+// Set the SPI clock frequency.
+int32_t uPortSpiControllerSetClock(int32_t handle, int32_t clockHertz)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((handle >= 0) && (handle < sizeof(gSpiData) / sizeof(gSpiData[0])) &&
+            (gSpiData[handle].pDevice != NULL) && (clockHertz > 0)) {
+            // Zephyr applies the configuration on the next transfer
+            gSpiData[handle].config.frequency = clockHertz;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Get the SPI clock frequency.
+int32_t uPortSpiControllerGetClock(int32_t handle)
+{
+    int32_t errorCodeOrClock = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCodeOrClock = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((handle >= 0) && (handle < sizeof(gSpiData) / sizeof(gSpiData[0])) &&
+            (gSpiData[handle].pDevice != NULL)) {
+            errorCodeOrClock = (int32_t) gSpiData[handle].config.frequency;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCodeOrClock;
+}
+
+// Exchange a block of data over SPI.
+int32_t uPortSpiControllerSendReceiveBlock(int32_t handle,
+                                           const char *pSend,
+                                           char *pReceive,
+                                           size_t size)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    struct spi_buf txBuffer;
+    struct spi_buf rxBuffer;
+    struct spi_buf_set txBufferSet = {.buffers = &txBuffer, .count = 1};
+    struct spi_buf_set rxBufferSet = {.buffers = &rxBuffer, .count = 1};
+    size_t thisSize;
+    size_t offset = 0;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((handle >= 0) && (handle < sizeof(gSpiData) / sizeof(gSpiData[0])) &&
+            (gSpiData[handle].pDevice != NULL)) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_SUCCESS;
+            uPortGpioSet(gSpiData[handle].pinSelect, 0);
+            while ((offset < size) && (errorCodeOrLength == 0)) {
+                thisSize = size - offset;
+                txBuffer.buf = gFill;
+                if (pSend != NULL) {
+                    txBuffer.buf = (void *) (pSend + offset);
+                } else if (thisSize > sizeof(gFill)) {
+                    thisSize = sizeof(gFill);
+                }
+                txBuffer.len = thisSize;
+                rxBuffer.buf = NULL;
+                if (pReceive != NULL) {
+                    rxBuffer.buf = pReceive + offset;
+                }
+                // A NULL receive buffer makes Zephyr discard
+                rxBuffer.len = thisSize;
+                if (spi_transceive(gSpiData[handle].pDevice,
+                                   &(gSpiData[handle].config),
+                                   &txBufferSet, &rxBufferSet) == 0) {
+                    offset += thisSize;
+                } else {
+                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_PLATFORM;
+                }
+            }
+            uPortGpioSet(gSpiData[handle].pinSelect, 1);
+            if (errorCodeOrLength == 0) {
+                errorCodeOrLength = (int32_t) size;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCodeOrLength;
+}
+
+// End of file
@@ -50,7 +50,7 @@
 #include "u_port_uart.h"
 #include "version.h"
 
-#include "string.h" // For memcpy()
+#include "string.h" // For memcpy(), memset()
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -91,6 +91,7 @@ typedef struct {
 #else
     struct k_timer pollTimer;
 #endif
+    uPortUartStats_t stats;
 } uPortUartData_t;
 
 /** Structure describing an event.
@@ -98,6 +99,7 @@ typedef struct {
 typedef struct {
     int32_t uartHandle;
     uint32_t eventBitMap;
+    int32_t timeMs; /**< when the event was sent, for the latency statistic. */
 } uPortUartEvent_t;
 
 struct uartData_t {
@@ -122,6 +124,8 @@ static uPortUartData_t gUartData[U_PORT_UART_MAX_NUM];
 static void eventHandler(void *pParam, size_t paramLength)
 {
     uPortUartEvent_t *pEvent = (uPortUartEvent_t *) pParam;
+    uPortUartData_t *pUartData;
+    int32_t latencyMs;
 
     (void) paramLength;
 
@@ -134,6 +138,11 @@ static void eventHandler(void *pParam, size_t paramLength)
     if ((pEvent->uartHandle >= 0) &&
         (pEvent->uartHandle < sizeof(gUartData) / sizeof(gUartData[0]))) {
         if (gUartData[pEvent->uartHandle].pEventCallback != NULL) {
+            pUartData = &gUartData[pEvent->uartHandle];
+            latencyMs = uPortGetTickTimeMs() - pEvent->timeMs;
+            if (latencyMs > pUartData->stats.eventCallbackLatencyMaxMs) {
+                pUartData->stats.eventCallbackLatencyMaxMs = latencyMs;
+            }
             gUartData[pEvent->uartHandle].pEventCallback(pEvent->uartHandle,
                                                          pEvent->eventBitMap,
                                                          gUartData[pEvent->uartHandle].pEventCallbackParam);
@@ -167,6 +176,31 @@ static void uartClose(int32_t handle)
 #endif
 }
 
+// Update the receive statistics after data has been put into the
+// buffer; this code is run in INTERRUPT CONTEXT.
+static void updateRxStats(uPortUartData_t *pUartData)
+{
+    size_t waiting = pUartData->receiveBufferSizeBytes;
+    int errors = uart_err_check(pUartData->pDevice);
+
+    if (!pUartData->bufferFull) {
+        waiting = (pUartData->bufferWrite + pUartData->receiveBufferSizeBytes -
+                   pUartData->bufferRead) % pUartData->receiveBufferSizeBytes;
+    }
+    if (waiting > pUartData->stats.rxBufferHighWaterMark) {
+        pUartData->stats.rxBufferHighWaterMark = waiting;
+    }
+    // uart_err_check() returns negative if not supported
+    if (errors > 0) {
+        if (errors & UART_ERROR_OVERRUN) {
+            pUartData->stats.rxOverrunErrors++;
+        }
+        if (errors & (UART_ERROR_PARITY | UART_ERROR_FRAMING)) {
+            pUartData->stats.rxFramingErrors++;
+        }
+    }
+}
+
 static void rxTimer(struct k_timer *timer_id)
 {
     uint32_t uart = (uint32_t)(timer_id->user_data);
@@ -176,6 +210,7 @@ static void rxTimer(struct k_timer *timer_id)
         uPortUartEvent_t event;
         event.uartHandle = uart;
         event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
+        event.timeMs = uPortGetTickTimeMs();
         uPortEventQueueSendIrq(gUartData[uart].eventQueueHandle,
                                &event, sizeof(event));
     }
@@ -207,10 +242,12 @@ static void uartCb(const struct device *uart, void *user_data)
             while (uart_fifo_read(uart, (gUartData[i].pBuffer + gUartData[i].bufferWrite), 1) != 0) {
                 gUartData[i].bufferWrite++;
                 gUartData[i].bufferWrite %= gUartData[i].receiveBufferSizeBytes;
+                gUartData[i].stats.rxBytes++;
                 read = true;
 
                 if (gUartData[i].bufferWrite == gUartData[i].bufferRead) {
                     gUartData[i].bufferFull = true;
+                    gUartData[i].stats.rxBufferOverflows++;
                     uart_irq_rx_disable(uart);
                     k_timer_stop(&gUartData[i].rxTimer);
                     if ((gUartData[i].eventQueueHandle >= 0) &&
@@ -218,6 +255,7 @@ static void uartCb(const struct device *uart, void *user_data)
                         uPortUartEvent_t event;
                         event.uartHandle = i;
                         event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
+                        event.timeMs = uPortGetTickTimeMs();
                         uPortEventQueueSendIrq(gUartData[i].eventQueueHandle,
                                                &event, sizeof(event));
                     }
@@ -229,6 +267,7 @@ static void uartCb(const struct device *uart, void *user_data)
             }
 
             if (read) {
+                updateRxStats(&gUartData[i]);
                 k_timer_start(&gUartData[i].rxTimer, K_MSEC(1), K_NO_WAIT);
             }
         }
@@ -283,15 +322,18 @@ static void pollTimer(struct k_timer *timer_id)
                          gUartData[uart].pBuffer + gUartData[uart].bufferWrite) == 0)) {
         gUartData[uart].bufferWrite++;
         gUartData[uart].bufferWrite %= gUartData[uart].receiveBufferSizeBytes;
+        gUartData[uart].stats.rxBytes++;
         read = true;
         if (gUartData[uart].bufferWrite == gUartData[uart].bufferRead) {
             gUartData[uart].bufferFull = true;
+            gUartData[uart].stats.rxBufferOverflows++;
             k_timer_stop(&gUartData[uart].rxTimer);
             if ((gUartData[uart].eventQueueHandle >= 0) &&
                 (gUartData[uart].eventFilter & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
                 uPortUartEvent_t event;
                 event.uartHandle = uart;
                 event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
+                event.timeMs = uPortGetTickTimeMs();
                 uPortEventQueueSendIrq(gUartData[uart].eventQueueHandle,
                                        &event, sizeof(event));
             }
@@ -299,6 +341,7 @@ static void pollTimer(struct k_timer *timer_id)
     }
 
     if (read) {
+        updateRxStats(&gUartData[uart]);
         k_timer_start(&gUartData[uart].rxTimer, K_MSEC(1), K_NO_WAIT);
     }
 }
@@ -429,6 +472,7 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
                 gUartData[uart].eventFilter = 0;
                 gUartData[uart].pEventCallback = NULL;
                 gUartData[uart].pEventCallbackParam = NULL;
+                memset(&gUartData[uart].stats, 0, sizeof(gUartData[uart].stats));
                 k_timer_init(&gUartData[uart].rxTimer, rxTimer, NULL);
                 k_timer_user_data_set(&gUartData[uart].rxTimer, (void *)uart);
 
@@ -613,6 +657,7 @@ int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
                 sizeBytes--;
             }
 #endif
+            gUartData[handle].stats.txBytes += errorCode;
             U_PORT_MUTEX_UNLOCK(gMutex);
         }
     }
@@ -620,6 +665,29 @@ int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
     return (int32_t) errorCode;
 }
 
+// Get the statistics of a UART.
+int32_t uPortUartGetStats(int32_t handle, uPortUartStats_t *pStats)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pStats != NULL) && (handle >= 0) &&
+            (handle < sizeof(gUartData) / sizeof(gUartData[0])) &&
+            (gUartData[handle].pBuffer != NULL)) {
+            *pStats = gUartData[handle].stats;
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return (int32_t) errorCode;
+}
+
 int32_t uPortUartEventCallbackSet(int32_t handle,
                                   uint32_t filter,
                                   void (*pFunction)(int32_t,
@@ -765,6 +833,7 @@ int32_t uPortUartEventSend(int32_t handle, uint32_t eventBitMap)
             (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
             event.uartHandle = handle;
             event.eventBitMap = eventBitMap;
+            event.timeMs = uPortGetTickTimeMs();
             errorCode = uPortEventQueueSend(gUartData[handle].eventQueueHandle,
                                             &event, sizeof(event));
         }
@@ -795,6 +864,7 @@ int32_t uPortUartEventTrySend(int32_t handle, uint32_t eventBitMap,
             (eventBitMap == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED)) {
             event.uartHandle = handle;
             event.eventBitMap = eventBitMap;
+            event.timeMs = uPortGetTickTimeMs();
             do {
                 // Push an event to event queue, IRQ version so as not to block
                 errorCode = uPortEventQueueSendIrq(gUartData[handle].eventQueueHandle,
@@ -128,6 +128,11 @@ typedef struct {
     uint8_t flags;
 } spsWriteEvt_t;
 
+typedef struct {
+    int32_t connHandle;
+    void *pCallbackParam;
+} txCompleteEvt_t;
+
 typedef enum {
     GATT_EVT_CONN_STATUS,
     GATT_EVT_SERVICE,
@@ -138,7 +143,8 @@ typedef enum {
     GATT_EVT_SPS_WRITE_FIFO_CCC,
     GATT_EVT_SPS_WRITE_FIFO_CHAR,
     GATT_EVT_SPS_WRITE_CREDIT_CCC,
-    GATT_EVT_SPS_WRITE_CREDIT_CHAR
+    GATT_EVT_SPS_WRITE_CREDIT_CHAR,
+    GATT_EVT_TX_COMPLETE
 } gattEvtId_t;
 
 typedef struct {
@@ -151,6 +157,7 @@ typedef struct {
         notifyEvt_t notify;
         writeCccEvt_t writeCcc;
         spsWriteEvt_t spsWrite;
+        txCompleteEvt_t txComplete;
     };
 } gattEvt_t;
 
@@ -189,6 +196,7 @@ static uPortGattIter_t gattNotifyFunc(int32_t connHandle,
                                       struct uPortGattSubscribeParams_s *pParams,
                                       const void *pData, uint16_t length);
 static void gattCccWriteResp(int32_t connHandle, uint8_t err);
+static void gattTxComplete(int32_t connHandle, void *pCallbackParam);
 static int32_t remoteWritesFifoChar(int32_t gapConnHandle, const void *pBuf, uint16_t len,
                                     uint16_t offset, uint8_t flags);
 static int32_t remoteWritesFifoCcc(int32_t gapConnHandle, const void *pBuf, uint16_t len,
@@ -216,6 +224,11 @@ static const char gRemoteSpsCentralStr[] =
 static uint8_t gRemoteSpsCentral[6];
 static uPortBtLeAddressType_t gRemoteSpsPeripheralType;
 static uPortBtLeAddressType_t gRemoteSpsCentralType;
+
+/** Data for the bulk write test: a few MTUs' worth.
+ */
+static char gBulkData[512];
+
 static volatile uPortGattIter_t gGattIterReturnValue;
 static uPortQueueHandle_t gEvtQueue = NULL;
 
@@ -673,6 +686,20 @@ static void gattCccWriteResp(int32_t connHandle, uint8_t err)
     }
 }
 
+//lint -efunc(785, gattTxComplete) "Too few initializers for aggregate 'evt' of type 'gattEvt_t'"
+static void gattTxComplete(int32_t connHandle, void *pCallbackParam)
+{
+    gattEvt_t evt = { .id = GATT_EVT_TX_COMPLETE };
+    txCompleteEvt_t *txComplete = &evt.txComplete;
+
+    txComplete->connHandle = connHandle;
+    txComplete->pCallbackParam = pCallbackParam;
+
+    if (!enqueueEvt(&evt)) {
+        U_TEST_PRINT_LINE("ERROR: failed to queue GATT TX complete evt.");
+    }
+}
+
 //lint -efunc(785, enqueueSpsWrite) "Too few initializers for aggregate 'evt' of type 'gattEvt_t'"
 static bool enqueueSpsWrite(gattEvtId_t id, int32_t gapConnHandle, const void *pBuf,
                             uint16_t len, uint16_t offset, uint8_t flags)
@@ -789,6 +816,8 @@ U_PORT_TEST_FUNCTION("[portGatt]", "portGattMisc")
     U_PORT_TEST_ASSERT_EQUAL(uPortGattAdd(), 0);
     U_PORT_TEST_ASSERT_EQUAL(uPortGattUp(true), 0);
     U_PORT_TEST_ASSERT(uPortGattIsAdvertising());
+    U_TEST_PRINT_LINE("BLE stack has %d TX buffer(s).", uPortGattGetTxBufferCount());
+    U_PORT_TEST_ASSERT(uPortGattGetTxBufferCount() >= 1);
     uPortGattDown();
     uPortGattDeinit();
     U_PORT_TEST_ASSERT_EQUAL(uPortGattAdd(), 0);
@@ -1296,6 +1325,7 @@ U_PORT_TEST_FUNCTION("[portGatt]", "portGattSubscribeAttrWrite")
     int32_t errorCode;
     int32_t heapUsed;
     int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+    uPortGattWriteBulkStats_t bulkStats;
 
     // Whatever called us likely initialised the
     // port so deinitialise it here to obtain the
@@ -1421,6 +1451,40 @@ U_PORT_TEST_FUNCTION("[portGatt]", "portGattSubscribeAttrWrite")
         // There should be no more notifications
         U_PORT_TEST_ASSERT(!waitForEvt(GATT_EVT_NOTIFY, &evt, WAIT_FOR_CALLBACK_TIMEOUT));
 
+        U_TEST_PRINT_LINE("uPortGattWriteAttributeCb() - invalid connection handle.");
+        errorCode = uPortGattWriteAttributeCb(-1, gNinaW15SpsService.attrHandle + 2,
+                                              "qrst", 4, gattTxComplete, gGattCallbackParamIn);
+        U_PORT_TEST_ASSERT_EQUAL(errorCode, (int32_t)U_ERROR_COMMON_INVALID_PARAMETER);
+
+        U_TEST_PRINT_LINE("uPortGattWriteAttributeCb() - callback when sent.");
+        errorCode = uPortGattWriteAttributeCb(connHandle, gNinaW15SpsService.attrHandle + 2,
+                                              "qrst", 4, gattTxComplete, gGattCallbackParamIn);
+        U_PORT_TEST_ASSERT_EQUAL(errorCode, (int32_t)U_ERROR_COMMON_SUCCESS);
+        U_PORT_TEST_ASSERT(waitForEvt(GATT_EVT_TX_COMPLETE, &evt, WAIT_FOR_CALLBACK_TIMEOUT));
+        U_PORT_TEST_ASSERT_EQUAL(evt.txComplete.connHandle, connHandle);
+        U_PORT_TEST_ASSERT_EQUAL(evt.txComplete.pCallbackParam, gGattCallbackParamIn);
+
+        U_TEST_PRINT_LINE("uPortGattWriteBulk() - invalid connection handle.");
+        errorCode = uPortGattWriteBulk(-1, gNinaW15SpsService.attrHandle + 2,
+                                       gBulkData, sizeof(gBulkData), 5000,
+                                       NULL, NULL, NULL);
+        U_PORT_TEST_ASSERT_EQUAL(errorCode, (int32_t)U_ERROR_COMMON_INVALID_PARAMETER);
+
+        U_TEST_PRINT_LINE("uPortGattWriteBulk() - write %d bytes.", (int32_t) sizeof(gBulkData));
+        memset(gBulkData, 'x', sizeof(gBulkData));
+        errorCode = uPortGattWriteBulk(connHandle, gNinaW15SpsService.attrHandle + 2,
+                                       gBulkData, sizeof(gBulkData), 5000,
+                                       NULL, NULL, &bulkStats);
+        U_PORT_TEST_ASSERT_EQUAL(errorCode, (int32_t) sizeof(gBulkData));
+        U_TEST_PRINT_LINE("%d byte(s) in %d write(s), at most %d in flight,"
+                          " took %d ms, %d byte(s)/second.",
+                          (int32_t) bulkStats.bytes, (int32_t) bulkStats.numPdus,
+                          (int32_t) bulkStats.pdusInFlightMax, bulkStats.durationMs,
+                          bulkStats.bytesPerSecond);
+        U_PORT_TEST_ASSERT_EQUAL(bulkStats.bytes, sizeof(gBulkData));
+        U_PORT_TEST_ASSERT(bulkStats.numPdus > 0);
+        U_PORT_TEST_ASSERT(bulkStats.pdusInFlightMax > 0);
+
         U_TEST_PRINT_LINE("disconnect.");
         U_PORT_TEST_ASSERT_EQUAL(uPortGattDisconnectGap(connHandle), 0);
         U_PORT_TEST_ASSERT(waitForEvt(GATT_EVT_CONN_STATUS, &evt, WAIT_FOR_CALLBACK_TIMEOUT));
@@ -1545,6 +1609,23 @@ U_PORT_TEST_FUNCTION("[portGatt]", "portGattServerConf")
         U_PORT_TEST_ASSERT_EQUAL(notify->length, sizeof(notify->data));
         U_PORT_TEST_ASSERT(memcmp(notify->data, "abcd", sizeof(notify->data)) == 0);
 
+        U_TEST_PRINT_LINE("uPortGattNotifyCb() - invalid connection handle.");
+        errorCode = uPortGattNotifyCb(-1, &gSpsFifoChar, "efgh", 4,
+                                      gattTxComplete, gGattCallbackParamIn);
+        U_PORT_TEST_ASSERT_EQUAL(errorCode, (int32_t)U_ERROR_COMMON_INVALID_PARAMETER);
+
+        U_TEST_PRINT_LINE("uPortGattNotifyCb() - callback when sent.");
+        errorCode = uPortGattNotifyCb(connHandle, &gSpsFifoChar, "efgh", 4,
+                                      gattTxComplete, gGattCallbackParamIn);
+        U_PORT_TEST_ASSERT_EQUAL(errorCode, (int32_t)U_ERROR_COMMON_SUCCESS);
+        U_PORT_TEST_ASSERT(waitForEvt(GATT_EVT_TX_COMPLETE, &evt, WAIT_FOR_CALLBACK_TIMEOUT));
+        U_PORT_TEST_ASSERT_EQUAL(evt.txComplete.connHandle, connHandle);
+        U_PORT_TEST_ASSERT_EQUAL(evt.txComplete.pCallbackParam, gGattCallbackParamIn);
+        U_TEST_PRINT_LINE("wait for data to echo back.");
+        U_PORT_TEST_ASSERT(waitForEvt(GATT_EVT_SPS_WRITE_FIFO_CHAR, &evt, CONNECTION_SETUP_TIMEOUT));
+        U_PORT_TEST_ASSERT_EQUAL(notify->length, sizeof(notify->data));
+        U_PORT_TEST_ASSERT(memcmp(notify->data, "efgh", sizeof(notify->data)) == 0);
+
         U_TEST_PRINT_LINE("disconnect.");
         U_PORT_TEST_ASSERT_EQUAL(uPortGattDisconnectGap(connHandle), 0);
         U_PORT_TEST_ASSERT(waitForEvt(GATT_EVT_CONN_STATUS, &evt, WAIT_FOR_CALLBACK_TIMEOUT));
@@ -60,8 +60,12 @@
 # include "u_port_i2c.h"
 # include "u_ubx_protocol.h"
 #endif
+#if (U_CFG_TEST_SPI >= 0) && (U_CFG_TEST_PIN_SPI_SELECT >= 0)
+# include "u_port_spi.h"
+#endif
 #include "u_port_crypto.h"
 #include "u_port_event_queue.h"
+#include "u_port_heap.h"
 #include "u_error_common.h"
 
 #ifdef CONFIG_IRQ_OFFLOAD
@@ -80,11 +84,11 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
-#ifndef _WIN32
-/** Check time delays on all platforms except _WIN32: on _WIN32
- * the tests are run on the same machine as all of the compilation
- * processes etc. and hence any attempt to check real-timeness
- * is futile.
+#if !defined(_WIN32) && !(defined(__linux__) && !defined(__ZEPHYR__))
+/** Check time delays on all platforms except _WIN32 and Linux: on
+ * those the tests are run on the same machine as all of the
+ * compilation processes etc., and task priorities are not applied,
+ * hence any attempt to check real-timeness is futile.
  */
 # define U_PORT_TEST_CHECK_TIME_TAKEN
 #endif
@@ -146,6 +150,41 @@
 # endif
 #endif
 
+#ifndef U_CFG_TEST_SPI
+/** The SPI HW block to use when testing SPI, which requires MOSI
+ * to be looped back to MISO; -1 means no SPI testing.
+ */
+# define U_CFG_TEST_SPI -1
+#endif
+
+#ifndef U_CFG_TEST_PIN_SPI_MOSI
+/** The MOSI pin to use when testing SPI; -1 if the pin choice is
+ * made at compile time.
+ */
+# define U_CFG_TEST_PIN_SPI_MOSI -1
+#endif
+
+#ifndef U_CFG_TEST_PIN_SPI_MISO
+/** The MISO pin to use when testing SPI, which must be connected
+ * to U_CFG_TEST_PIN_SPI_MOSI; -1 if the pin choice is made at
+ * compile time.
+ */
+# define U_CFG_TEST_PIN_SPI_MISO -1
+#endif
+
+#ifndef U_CFG_TEST_PIN_SPI_CLK
+/** The clock pin to use when testing SPI; -1 if the pin choice is
+ * made at compile time.
+ */
+# define U_CFG_TEST_PIN_SPI_CLK -1
+#endif
+
+#ifndef U_CFG_TEST_PIN_SPI_SELECT
+/** The chip select pin to use when testing SPI, always required.
+ */
+# define U_CFG_TEST_PIN_SPI_SELECT -1
+#endif
+
 #if (U_CFG_APP_GNSS_I2C >= 0)
 # ifndef U_PORT_TEST_I2C_ADDRESS
 /** The I2C address to use when testing, which is the
@@ -231,10 +270,65 @@
 # define U_PORT_TEST_CRITICAL_SECTION_TEST_WAIT_LOOPS 1000000
 #endif
 
+#ifndef U_PORT_TEST_CRYPTO_BENCHMARK_ITERATIONS
+/** The number of times each operation is repeated, for each
+ * block size, by the crypto benchmark.
+ */
+# define U_PORT_TEST_CRYPTO_BENCHMARK_ITERATIONS 100
+#endif
+
+#ifndef U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES
+/** The largest block size used by the crypto benchmark; the
+ * benchmark starts with 16 bytes and quadruples the size up to
+ * this; must be a multiple of 16.
+ */
+# define U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES 1024
+#endif
+
+#ifndef U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS
+/** The number of normal priority events sent when testing high
+ * priority events on an event queue.
+ */
+# define U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS 5
+#endif
+
+#ifndef U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS
+/** The number of blocks sent by reference in the event queue
+ * reference test.
+ */
+# define U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS 4
+#endif
+
+#ifndef U_PORT_TEST_EVENT_QUEUE_REF_BLOCK_LENGTH_BYTES
+/** The length of the blocks sent by reference in the event queue
+ * reference test: larger than an event queue could take by copy.
+ */
+# define U_PORT_TEST_EVENT_QUEUE_REF_BLOCK_LENGTH_BYTES (U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES * 2)
+#endif
+
+#ifndef U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES
+/** The number of event queues used when testing the event queue
+ * pool; more than there are worker tasks in the pool.
+ */
+# define U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES (U_PORT_EVENT_QUEUE_POOL_NUM_TASKS + 2)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+
+/** The parameter sent to the event queues when testing the
+ * event queue pool.
+ */
+typedef struct {
+    size_t queueIndex;
+    int32_t count;
+} uPortTestEventQueuePoolParam_t;
+
+#endif
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
 /** Type to hold the stuff that the UART test task needs to know
@@ -249,6 +343,26 @@ typedef struct {
     int32_t errorCode;
 } uartEventCallbackData_t;
 
+/** Type to hold the outcome of uPortUartWriteAsync() calls.
+ */
+typedef struct {
+    int32_t uartHandle;
+    size_t callCount;
+    size_t bytesSent;
+    int32_t errorCode;
+} uartWriteAsyncCallbackData_t;
+
+#endif
+
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0) && defined(ESP_PLATFORM)
+/** Type to count the events that the UART line-received test gets.
+ */
+typedef struct {
+    int32_t uartHandle;
+    size_t lineCount;
+    size_t dataCount;
+    int32_t errorCode;
+} uartLineCallbackData_t;
 #endif
 
 /** Struct for mktime64() testing.
@@ -262,6 +376,10 @@ typedef struct {
  * VARIABLES
  * -------------------------------------------------------------- */
 
+// Profiling probe for the profile test, only present if
+// U_CFG_PROFILE is defined.
+U_PORT_PROFILE_PROBE(portTest);
+
 // OS test mutex handle.
 static uPortMutexHandle_t gMutexHandle = NULL;
 
@@ -310,6 +428,42 @@ static int32_t gEventQueueMinErrorFlag;
 // Counter for event queue callback min length
 static int32_t gEventQueueMinCounter;
 
+// The number of events handled by the event queue priority test.
+static size_t gEventQueuePriorityCount;
+
+// The order in which the event queue priority test handled events.
+static int32_t gEventQueuePriorityOrder[U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS + 1];
+
+// The blocks sent by the event queue reference test.
+static uint8_t gEventQueueRefBlock[U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS]
+[U_PORT_TEST_EVENT_QUEUE_REF_BLOCK_LENGTH_BYTES];
+
+// The number of blocks handled by the event queue reference test.
+static volatile size_t gEventQueueRefHandledCount;
+
+// The number of blocks given back in the event queue reference test.
+static volatile size_t gEventQueueRefFreeCount;
+
+// Error flag for the event queue reference test.
+static volatile int32_t gEventQueueRefErrorFlag;
+
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+
+// Handles for the event queues testing the pool.
+static int32_t gEventQueuePoolHandle[U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES];
+
+// Counters for the event queues testing the pool.
+static int32_t gEventQueuePoolCounter[U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES];
+
+// Flags that are true while the function of an event queue
+// testing the pool is running.
+static volatile bool gEventQueuePoolRunning[U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES];
+
+// Error flag for the event queues testing the pool.
+static volatile int32_t gEventQueuePoolErrorFlag;
+
+#endif
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
 // The data to send during UART testing.
@@ -348,6 +502,14 @@ static char gUartBuffer[(U_CFG_TEST_UART_BUFFER_LENGTH_BYTES / 2) +
  * I2C buses can easily get stuck, it would seem.
  */
 static int32_t gI2cHandle = -1;
+
+/** The number of times that i2cAsyncCallback() has been called.
+ */
+static volatile int32_t gI2cAsyncCallCount = 0;
+
+/** The outcome passed to i2cAsyncCallback().
+ */
+static volatile int32_t gI2cAsyncErrorCodeOrLength = 0;
 #endif
 
 /** Data for mktime64() testing.
@@ -451,6 +613,18 @@ static uPortTimerHandle_t gTimerHandle[4] = {0};
  */
 static uint32_t gVariable = 0;
 
+/** The number of calls to heapTestAlloc() and heapTestRealloc().
+ */
+static size_t gHeapTestAllocCount = 0;
+
+/** The number of calls to heapTestFree().
+ */
+static size_t gHeapTestFreeCount = 0;
+
+/** The tag of the last call to the heap test allocator.
+ */
+static uPortHeapTag_t gHeapTestLastTag = U_PORT_HEAP_TAG_NONE;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -796,6 +970,109 @@ static void eventQueueMaxFunction(void *pParam,
     gEventQueueMaxCounter++;
 }
 
+// Event queue function for the priority test: records the order of
+// events, taking its time over the first so that the rest queue up.
+//lint -esym(818, pParam) Suppress "could be const"
+// since this has to match the function signature
+// exactly to avoid a compiler warning
+static void eventQueuePriorityFunction(void *pParam,
+                                       size_t paramLength)
+{
+    int32_t value = -1;
+
+    if ((pParam != NULL) && (paramLength == sizeof(value))) {
+        memcpy(&value, pParam, sizeof(value));
+    }
+    if (value == 0) {
+        uPortTaskBlock(500);
+    }
+    if (gEventQueuePriorityCount < sizeof(gEventQueuePriorityOrder) /
+        sizeof(gEventQueuePriorityOrder[0])) {
+        gEventQueuePriorityOrder[gEventQueuePriorityCount] = value;
+    }
+    gEventQueuePriorityCount++;
+}
+
+// Event queue function for the reference test: checks that it is
+// given the block that was sent, not a copy of it.
+static void eventQueueRefFunction(void *pParam,
+                                  size_t paramLength)
+{
+    size_t x = gEventQueueRefHandledCount;
+    uint8_t *pBlock = (uint8_t *) pParam;
+
+    if ((x >= U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS) ||
+        (pBlock != gEventQueueRefBlock[x])) {
+        gEventQueueRefErrorFlag = 1;
+    } else if (paramLength != U_PORT_TEST_EVENT_QUEUE_REF_BLOCK_LENGTH_BYTES) {
+        gEventQueueRefErrorFlag = 2;
+    } else if ((pBlock[0] != (uint8_t) x) || (pBlock[paramLength - 1] != (uint8_t) x)) {
+        gEventQueueRefErrorFlag = 3;
+    } else if (gEventQueueRefFreeCount != x) {
+        // The previous block should have been given back already
+        gEventQueueRefErrorFlag = 4;
+    }
+    gEventQueueRefHandledCount++;
+}
+
+// Free function for the event queue reference test.
+static void eventQueueRefFree(void *pBlock)
+{
+    if (pBlock != gEventQueueRefBlock[gEventQueueRefFreeCount]) {
+        gEventQueueRefErrorFlag = 5;
+    } else if (gEventQueueRefHandledCount != gEventQueueRefFreeCount + 1) {
+        // Should only be given back once it has been handled
+        gEventQueueRefErrorFlag = 6;
+    }
+    gEventQueueRefFreeCount++;
+}
+
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+
+// Event queue function for the pool test, shared by all of the
+// event queues, which checks that the events of each event queue
+// arrive in order and are never handled concurrently.
+//lint -esym(818, pParam) Suppress "could be const"
+// since this has to match the function signature
+// exactly to avoid a compiler warning
+static void eventQueuePoolFunction(void *pParam,
+                                   size_t paramLength)
+{
+    uPortTestEventQueuePoolParam_t *pPoolParam = (uPortTestEventQueuePoolParam_t *) pParam;
+    size_t x;
+
+    if ((pPoolParam == NULL) || (paramLength != sizeof(*pPoolParam)) ||
+        (pPoolParam->queueIndex >= U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES)) {
+        gEventQueuePoolErrorFlag = 1;
+    } else {
+        x = pPoolParam->queueIndex;
+        if (gEventQueuePoolRunning[x]) {
+            // Two workers are running the same event queue
+            gEventQueuePoolErrorFlag = 2;
+        }
+        gEventQueuePoolRunning[x] = true;
+        if (pPoolParam->count != gEventQueuePoolCounter[x]) {
+            // Out of order
+            gEventQueuePoolErrorFlag = 3;
+        }
+        if (!uPortEventQueueIsTask(gEventQueuePoolHandle[x])) {
+            // Not detecting that this is the event task
+            gEventQueuePoolErrorFlag = 4;
+        }
+        if (uPortEventQueueIsTask(gEventQueuePoolHandle[(x + 1) %
+                                                        U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES])) {
+            // Detecting that this is the wrong event task
+            gEventQueuePoolErrorFlag = 5;
+        }
+        // Give another worker the chance to get in
+        uPortTaskBlock(1);
+        gEventQueuePoolCounter[x]++;
+        gEventQueuePoolRunning[x] = false;
+    }
+}
+
+#endif
+
 // Event queue function for minimum length parameter.
 //lint -esym(818, pParam) Suppress "could be const"
 // since this has to match the function signature
@@ -927,6 +1204,43 @@ static void uartReceivedDataCallback(int32_t uartHandle,
     }
 }
 
+// Callback that is called when a uPortUartWriteAsync() completes.
+static void uartWriteAsyncCallback(int32_t uartHandle,
+                                   int32_t sizeOrErrorCode,
+                                   void *pParameters)
+{
+    uartWriteAsyncCallbackData_t *pCallbackData = (uartWriteAsyncCallbackData_t *) pParameters;
+
+    pCallbackData->callCount++;
+    if (uartHandle != pCallbackData->uartHandle) {
+        pCallbackData->errorCode = -1;
+    } else if (sizeOrErrorCode < 0) {
+        pCallbackData->errorCode = sizeOrErrorCode;
+    } else {
+        pCallbackData->bytesSent += sizeOrErrorCode;
+    }
+}
+
+#if defined(ESP_PLATFORM)
+// Callback for the UART line-received test: just counts events,
+// the test itself reads the data.
+static void uartLineCallback(int32_t uartHandle, uint32_t filter,
+                             void *pParameters)
+{
+    uartLineCallbackData_t *pCallbackData = (uartLineCallbackData_t *) pParameters;
+
+    if (uartHandle != pCallbackData->uartHandle) {
+        pCallbackData->errorCode = -1;
+    } else if (filter == U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED) {
+        pCallbackData->lineCount++;
+    } else if (filter == U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) {
+        pCallbackData->dataCount++;
+    } else {
+        pCallbackData->errorCode = -2;
+    }
+}
+#endif
+
 // Run a UART test at the given baud rate and with/without flow control.
 static void runUartTest(int32_t size, int32_t speed, bool flowControlOn)
 {
@@ -938,6 +1252,7 @@ static void runUartTest(int32_t size, int32_t speed, bool flowControlOn)
     int32_t pinRts;
     uPortGpioConfig_t gpioConfig = U_PORT_GPIO_CONFIG_DEFAULT;
     int32_t stackMinFreeBytes;
+    uPortUartStats_t stats;
     int32_t x;
 
     eventCallbackData.callCount = 0;
@@ -1125,12 +1440,46 @@ static void runUartTest(int32_t size, int32_t speed, bool flowControlOn)
         U_PORT_TEST_ASSERT(stackMinFreeBytes > 0);
     }
 
+    // Check the statistics, where supported
+    if (uPortUartGetStats(uartHandle, &stats) == 0) {
+        U_TEST_PRINT_LINE("UART statistics: %u byte(s) received, %u sent,"
+                          " %u overrun(s), %u framing error(s), %u buffer"
+                          " overflow(s), %d byte(s) receive buffer high-water"
+                          " mark, %u CTS stall(s), %d ms max event latency.",
+                          stats.rxBytes, stats.txBytes, stats.rxOverrunErrors,
+                          stats.rxFramingErrors, stats.rxBufferOverflows,
+                          stats.rxBufferHighWaterMark, stats.ctsStalls,
+                          stats.eventCallbackLatencyMaxMs);
+        U_PORT_TEST_ASSERT(stats.rxBytes >= (uint32_t) bytesSent);
+        U_PORT_TEST_ASSERT(stats.txBytes == (uint32_t) bytesSent);
+        U_PORT_TEST_ASSERT(stats.rxOverrunErrors == 0);
+        U_PORT_TEST_ASSERT(stats.rxFramingErrors == 0);
+        U_PORT_TEST_ASSERT(stats.rxBufferHighWaterMark <= U_CFG_TEST_UART_BUFFER_LENGTH_BYTES);
+        U_PORT_TEST_ASSERT(stats.eventCallbackLatencyMaxMs >= 0);
+    }
+    U_PORT_TEST_ASSERT(uPortUartGetStats(uartHandle, NULL) < 0);
+
     U_TEST_PRINT_LINE("tidying up after UART test...");
     uPortUartClose(uartHandle);
 }
 
 #endif // (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
+#if (U_CFG_APP_GNSS_I2C >= 0)
+// Callback that is called when a uPortI2cControllerSendReceiveAsync()
+// completes.
+static void i2cAsyncCallback(int32_t handle, int32_t errorCodeOrLength,
+                             void *pCallbackParam)
+{
+    if ((handle == gI2cHandle) && (pCallbackParam == &gI2cAsyncCallCount)) {
+        gI2cAsyncErrorCodeOrLength = errorCodeOrLength;
+    } else {
+        gI2cAsyncErrorCodeOrLength = -1;
+    }
+    gI2cAsyncCallCount++;
+}
+#endif
+
 // Timer callback
 static void timerCallback(const uPortTimerHandle_t timerHandle, void *pParameter)
 {
@@ -1162,6 +1511,60 @@ static void criticalSectionTestTask(void *pParameter)
     uPortTaskDelete(NULL);
 }
 
+#ifdef U_CFG_TASK_STACK_REGISTRY
+// The test task for the task stack registry: uses a little
+// stack and exits.
+static void taskStackTestTask(void *pParameter)
+{
+    char buffer[64];
+
+    snprintf(buffer, sizeof(buffer), "%s", "taskStackTestTask");
+    (*((volatile int32_t *) pParameter)) += (int32_t) strlen(buffer);
+
+    uPortTaskDelete(NULL);
+}
+
+// Find a task in the task stack registry by name.
+static bool taskStackFind(const char *pName, uPortTaskStack_t *pTaskStack)
+{
+    bool found = false;
+
+    for (size_t x = 0; !found && (uPortTaskStackGet(x, pTaskStack) == 0); x++) {
+        found = (strcmp(pTaskStack->name, pName) == 0);
+    }
+
+    return found;
+}
+#endif
+
+// The allocation function of the heap test allocator.
+static void *heapTestAlloc(size_t sizeBytes, uPortHeapTag_t tag, void *pParam)
+{
+    (*((size_t *) pParam))++;
+    gHeapTestAllocCount++;
+    gHeapTestLastTag = tag;
+    return malloc(sizeBytes);
+}
+
+// The re-allocation function of the heap test allocator.
+static void *heapTestRealloc(void *pMemory, size_t sizeBytes,
+                             uPortHeapTag_t tag, void *pParam)
+{
+    (*((size_t *) pParam))++;
+    gHeapTestAllocCount++;
+    gHeapTestLastTag = tag;
+    return realloc(pMemory, sizeBytes);
+}
+
+// The free function of the heap test allocator.
+static void heapTestFree(void *pMemory, uPortHeapTag_t tag, void *pParam)
+{
+    (*((size_t *) pParam))++;
+    gHeapTestFreeCount++;
+    gHeapTestLastTag = tag;
+    free(pMemory);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -1858,6 +2261,143 @@ U_PORT_TEST_FUNCTION("[port]", "portOsBlock")
 }
 #endif
 
+/** Test getting the run-time statistics of tasks.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portOsRuntimeStats")
+{
+    uPortTaskRuntimeStats_t stats[16];
+    int32_t numStats;
+    int32_t idlePercent = -2;
+    int32_t totalPercent = 0;
+    uint64_t totalTicks = 0;
+    int32_t startTimeMs;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_PORT_TEST_ASSERT(uPortTaskGetRuntimeStats(NULL, 1, NULL) < 0);
+
+    // Use some CPU time so that there is something to see
+    startTimeMs = uPortGetTickTimeMs();
+    while (uPortGetTickTimeMs() - startTimeMs < 200) {}
+
+    numStats = uPortTaskGetRuntimeStats(stats, sizeof(stats) / sizeof(stats[0]),
+                                        &idlePercent);
+    if ((numStats == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) ||
+        (numStats == (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED)) {
+        U_TEST_PRINT_LINE("task run-time statistics are not available (%d).", numStats);
+    } else {
+        U_TEST_PRINT_LINE("%d task(s), idle %d%%.", numStats, idlePercent);
+        U_PORT_TEST_ASSERT(numStats > 0);
+        U_PORT_TEST_ASSERT(numStats <= (int32_t) (sizeof(stats) / sizeof(stats[0])));
+        U_PORT_TEST_ASSERT((idlePercent >= -1) && (idlePercent <= 100));
+        for (int32_t x = 0; x < numStats; x++) {
+            U_TEST_PRINT_LINE("  \"%s\"%s: %d%%.", stats[x].name,
+                              stats[x].isIdle ? " (idle)" : "", stats[x].percent);
+            U_PORT_TEST_ASSERT(strlen(stats[x].name) < sizeof(stats[x].name));
+            U_PORT_TEST_ASSERT((stats[x].percent >= 0) && (stats[x].percent <= 100));
+            totalPercent += stats[x].percent;
+            totalTicks += stats[x].runtimeTicks;
+        }
+        U_PORT_TEST_ASSERT(totalPercent <= 100);
+        U_PORT_TEST_ASSERT(totalTicks > 0);
+        // Asking for just the idle percentage must work also
+        idlePercent = -2;
+        U_PORT_TEST_ASSERT(uPortTaskGetRuntimeStats(NULL, 0, &idlePercent) == 0);
+        U_PORT_TEST_ASSERT((idlePercent >= -1) && (idlePercent <= 100));
+    }
+
+    uPortDeinit();
+}
+
+#ifdef U_CFG_PROFILE
+/** Test the profiling probes.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portProfile")
+{
+    volatile uint32_t y = 0;
+    int32_t startTimeMs;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    for (size_t x = 0; x < 10; x++) {
+        U_PORT_PROFILE_BEGIN(portTest);
+        // Take at least a tick of time so that a platform
+        // whose cycle counter is the tick still sees something
+        startTimeMs = uPortGetTickTimeMs();
+        while (uPortGetTickTimeMs() - startTimeMs < 2) {
+            y++;
+        }
+        U_PORT_PROFILE_END(portTest, 100);
+    }
+    uPortProfilePrint();
+    // The first sample registers the probe and is discarded
+    U_PORT_TEST_ASSERT(gUPortProfileProbe_portTest.count == 9);
+    U_PORT_TEST_ASSERT(gUPortProfileProbe_portTest.minCycles > 0);
+    U_PORT_TEST_ASSERT(gUPortProfileProbe_portTest.minCycles <=
+                       gUPortProfileProbe_portTest.maxCycles);
+    U_PORT_TEST_ASSERT(gUPortProfileProbe_portTest.totalCycles >=
+                       (uint64_t) gUPortProfileProbe_portTest.maxCycles);
+    U_PORT_TEST_ASSERT(gUPortProfileProbe_portTest.totalUnits == 900);
+
+    uPortProfileReset();
+    U_PORT_TEST_ASSERT(gUPortProfileProbe_portTest.count == 0);
+    U_PORT_TEST_ASSERT(gUPortProfileProbe_portTest.totalCycles == 0);
+    U_PORT_TEST_ASSERT(gUPortProfileProbe_portTest.totalUnits == 0);
+
+    uPortDeinit();
+}
+#endif
+
+#ifdef U_CFG_TASK_STACK_REGISTRY
+/** Test the task stack registry.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portTaskStack")
+{
+    volatile int32_t variable = 0;
+    uPortTaskStack_t taskStack;
+    bool found = false;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Run the same task twice: it should get a single entry
+    for (size_t x = 0; x < 2; x++) {
+        U_PORT_TEST_ASSERT(uPortTaskCreate(taskStackTestTask, "taskStackTest",
+                                           U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES,
+                                           (void *) &variable,
+                                           U_CFG_TEST_OS_TASK_PRIORITY,
+                                           &gTaskHandle) == 0);
+        for (size_t y = 0; (variable == 0) && (y < 100); y++) {
+            uPortTaskBlock(10);
+        }
+        U_PORT_TEST_ASSERT(variable > 0);
+        variable = 0;
+        // Give the task time to delete itself
+        found = false;
+        for (size_t y = 0; (!found || taskStack.running) && (y < 100); y++) {
+            uPortTaskBlock(10);
+            found = taskStackFind("taskStackTest", &taskStack);
+        }
+        U_PORT_TEST_ASSERT(found);
+        U_PORT_TEST_ASSERT(!taskStack.running);
+    }
+    gTaskHandle = NULL;
+
+    uPortTaskStackPrint();
+    U_PORT_TEST_ASSERT(taskStack.numCreated == 2);
+    U_PORT_TEST_ASSERT(taskStack.stackSizeBytes == U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES);
+    // Not all platforms can measure stack usage
+    if (taskStack.usedMaxBytes >= 0) {
+        U_PORT_TEST_ASSERT(taskStack.usedMaxBytes <= U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES);
+        U_PORT_TEST_ASSERT(taskStack.recommendedBytes > taskStack.usedMaxBytes);
+    } else {
+        U_PORT_TEST_ASSERT(taskStack.recommendedBytes < 0);
+    }
+    U_PORT_TEST_ASSERT(uPortTaskStackGet(U_PORT_TASK_STACK_MAX_NUM, &taskStack) < 0);
+
+    uPortDeinit();
+}
+#endif
+
 /** Test event queues.
  */
 U_PORT_TEST_FUNCTION("[port]", "portEventQueue")
@@ -2048,63 +2588,327 @@ U_PORT_TEST_FUNCTION("[port]", "portEventQueue")
                        (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
 }
 
-/** Test: strtok_r since we have our own implementation on
- * some platforms.
+/** Test: high priority events on an event queue and the event
+ * queue statistics.
  */
-U_PORT_TEST_FUNCTION("[port]", "portStrtok_r")
+U_PORT_TEST_FUNCTION("[port]", "portEventQueuePriority")
 {
-    char *pSave;
-    char buffer[8];
+    int32_t handle;
+    int32_t value;
+    uPortEventQueueStats_t stats;
+    size_t x;
     int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
 
     // Whatever called us likely initialised the
     // port so deinitialise it here to obtain the
     // correct initial heap size
     uPortDeinit();
     heapUsed = uPortGetHeapFree();
+
+    gEventQueuePriorityCount = 0;
+    memset(gEventQueuePriorityOrder, 0xFF, sizeof(gEventQueuePriorityOrder));
+
     U_PORT_TEST_ASSERT(uPortInit() == 0);
 
-    U_TEST_PRINT_LINE("testing strtok_r()...");
+    handle = uPortEventQueueOpen(eventQueuePriorityFunction, NULL, sizeof(value),
+                                 U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                 U_CFG_TEST_OS_TASK_PRIORITY,
+                                 U_PORT_TEST_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    U_PORT_TEST_ASSERT(uPortEventQueueGetStats(handle, NULL) < 0);
+
+    // Send the normal events, the first of which will keep
+    // the event queue busy, then a high priority one
+    for (value = 0; value < U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS; value++) {
+        U_PORT_TEST_ASSERT(uPortEventQueueSend(handle, &value, sizeof(value)) == 0);
+    }
+    value = U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS;
+    U_PORT_TEST_ASSERT(uPortEventQueueSendHighPriority(handle, &value, sizeof(value)) == 0);
 
-    buffer[sizeof(buffer) - 1] = 'x';
+    for (x = 0; (x < 20) &&
+         (gEventQueuePriorityCount < U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS + 1); x++) {
+        uPortTaskBlock(100);
+    }
+    U_PORT_TEST_ASSERT(gEventQueuePriorityCount == U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS + 1);
 
-    // memcpy() rather than strncpy() as strncpy() would overwrite the 'x' with 0
-    memcpy(buffer, "abcabc", 7);
-    U_PORT_TEST_ASSERT(strcmp(strtok_r(buffer, "b", &pSave), "a") == 0);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
-    //lint -e(668) Suppress possible passing of NULL pointer to strcmp,
-    // it's a test, if it goes bang we've failed
-    U_PORT_TEST_ASSERT(strcmp(strtok_r(NULL, "b", &pSave), "ca") == 0);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
-    //lint -e(668) Suppress possible passing of NULL pointer to strcmp,
-    // it's a test, if it goes bang we've failed
-    U_PORT_TEST_ASSERT(strcmp(strtok_r(NULL, "b", &pSave), "c") == 0);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
-    U_PORT_TEST_ASSERT(strtok_r(NULL, "b", &pSave) == NULL);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    // Find where the high priority event ended up
+    for (x = 0; (x < gEventQueuePriorityCount) &&
+         (gEventQueuePriorityOrder[x] != U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS); x++) {
+    }
+    U_TEST_PRINT_LINE("high priority event was handled at position %d.", x);
+    U_PORT_TEST_ASSERT(gEventQueuePriorityOrder[0] == 0);
+#if U_PORT_EVENT_QUEUE_HIGH_PRIORITY_QUEUE_LENGTH > 0
+    // It should have jumped ahead of all but the batch
+    // that was being handled when it was sent
+    U_PORT_TEST_ASSERT((x >= 1) && (x <= U_PORT_EVENT_QUEUE_BATCH_MAX_NUM));
+#else
+    U_PORT_TEST_ASSERT(x == U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS);
+#endif
 
-    memcpy(buffer, "abcade", 7);
-    U_PORT_TEST_ASSERT(strcmp(strtok_r(buffer, "a", &pSave), "bc") == 0);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
-    memcpy(buffer, "abcade", 7);
-    U_PORT_TEST_ASSERT(strcmp(strtok_r(buffer, "a", &pSave), "bc") == 0);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
-    //lint -e(668) Suppress possible passing of NULL pointer to strcmp,
-    // it's a test, if it goes bang we've failed
-    U_PORT_TEST_ASSERT(strcmp(strtok_r(NULL, "a", &pSave), "de") == 0);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
-    U_PORT_TEST_ASSERT(strtok_r(NULL, "a", &pSave) == NULL);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    U_PORT_TEST_ASSERT(uPortEventQueueGetStats(handle, &stats) == 0);
+    U_TEST_PRINT_LINE("%d event(s) handled (%d high priority), latency average %d ms,"
+                      " max %d ms, largest batch %d.", stats.numEvents,
+                      stats.numHighPriorityEvents, stats.latencyAverageMs,
+                      stats.latencyMaxMs, stats.batchSizeMax);
+    U_PORT_TEST_ASSERT(stats.numEvents == U_PORT_TEST_EVENT_QUEUE_PRIORITY_NUM_EVENTS + 1);
+#if U_PORT_EVENT_QUEUE_HIGH_PRIORITY_QUEUE_LENGTH > 0
+    U_PORT_TEST_ASSERT(stats.numHighPriorityEvents == 1);
+#endif
+    // The events behind the first waited for it
+    U_PORT_TEST_ASSERT(stats.latencyMaxMs >= 250);
+    U_PORT_TEST_ASSERT(stats.latencyAverageMs <= stats.latencyMaxMs);
+    U_PORT_TEST_ASSERT((stats.batchSizeMax >= 1) &&
+                       (stats.batchSizeMax <= U_PORT_EVENT_QUEUE_BATCH_MAX_NUM + 1));
 
-    memcpy(buffer, "abcabc", 7);
-    U_PORT_TEST_ASSERT(strcmp(strtok_r(buffer, "d", &pSave), "abcabc") == 0);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
-    U_PORT_TEST_ASSERT(strtok_r(NULL, "d", &pSave) == NULL);
-    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    U_PORT_TEST_ASSERT(uPortEventQueueClose(handle) == 0);
+    U_PORT_TEST_ASSERT(uPortEventQueueGetStats(handle, &stats) < 0);
 
     uPortDeinit();
 
-    // Check for memory leaks
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(1000);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+/** Test sending to an event queue by reference.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueueRef")
+{
+    int32_t handle;
+    uPortEventQueueStats_t stats;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    gEventQueueRefHandledCount = 0;
+    gEventQueueRefFreeCount = 0;
+    gEventQueueRefErrorFlag = 0;
+    for (size_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS; x++) {
+        memset(gEventQueueRefBlock[x], (int) x, sizeof(gEventQueueRefBlock[x]));
+    }
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Open with a parameter length smaller than a pointer:
+    // references must still fit
+    handle = uPortEventQueueOpen(eventQueueRefFunction, NULL, 1,
+                                 U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                 U_CFG_TEST_OS_TASK_PRIORITY,
+                                 U_PORT_TEST_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(handle >= 0);
+
+    U_PORT_TEST_ASSERT(uPortEventQueueSendRef(handle, NULL, 0, eventQueueRefFree) < 0);
+    U_PORT_TEST_ASSERT(uPortEventQueueSendRef(-1, gEventQueueRefBlock[0],
+                                              sizeof(gEventQueueRefBlock[0]),
+                                              eventQueueRefFree) < 0);
+    for (size_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS; x++) {
+        U_PORT_TEST_ASSERT(uPortEventQueueSendRef(handle, gEventQueueRefBlock[x],
+                                                  sizeof(gEventQueueRefBlock[x]),
+                                                  eventQueueRefFree) == 0);
+    }
+    for (size_t x = 0; (x < 20) &&
+         (gEventQueueRefFreeCount < U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS); x++) {
+        uPortTaskBlock(100);
+    }
+    U_TEST_PRINT_LINE("%d block(s) handled, %d given back, error flag %d.",
+                      gEventQueueRefHandledCount, gEventQueueRefFreeCount,
+                      gEventQueueRefErrorFlag);
+    U_PORT_TEST_ASSERT(gEventQueueRefErrorFlag == 0);
+    U_PORT_TEST_ASSERT(gEventQueueRefHandledCount == U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS);
+    U_PORT_TEST_ASSERT(gEventQueueRefFreeCount == U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS);
+
+    U_PORT_TEST_ASSERT(uPortEventQueueGetStats(handle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numEvents == U_PORT_TEST_EVENT_QUEUE_REF_NUM_BLOCKS);
+
+    U_PORT_TEST_ASSERT(uPortEventQueueClose(handle) == 0);
+
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(1000);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+
+#if U_PORT_EVENT_QUEUE_POOL_NUM_TASKS > 0
+/** Test: event queues served by the pool of worker tasks, more
+ * event queues than workers, checking ordering and exclusion.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueuePool")
+{
+    uPortTestEventQueuePoolParam_t param;
+    int32_t y;
+    int32_t stackMinFreeBytes;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    gEventQueuePoolErrorFlag = 0;
+    for (size_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES; x++) {
+        gEventQueuePoolCounter[x] = 0;
+        gEventQueuePoolRunning[x] = false;
+    }
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("opening %d event queue(s) on a pool of %d worker(s)...",
+                      U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES,
+                      U_PORT_EVENT_QUEUE_POOL_NUM_TASKS);
+    for (size_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES; x++) {
+        gEventQueuePoolHandle[x] = uPortEventQueueOpen(eventQueuePoolFunction, NULL,
+                                                       sizeof(param),
+                                                       U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                                       U_PORT_EVENT_QUEUE_POOL_PRIORITY,
+                                                       U_PORT_TEST_QUEUE_LENGTH);
+        U_PORT_TEST_ASSERT(gEventQueuePoolHandle[x] >= 0);
+    }
+
+    // Send to all of the event queues in turn
+    for (param.count = 0; (param.count < U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS) &&
+         (gEventQueuePoolErrorFlag == 0); param.count++) {
+        for (size_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES; x++) {
+            param.queueIndex = x;
+            U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueuePoolHandle[x], &param,
+                                                   sizeof(param)) == 0);
+        }
+    }
+
+    // Let everything get to its destination
+    for (y = 0; (y < 100) &&
+         (gEventQueuePoolCounter[U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES - 1] <
+          U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS); y++) {
+        uPortTaskBlock(100);
+    }
+
+    U_TEST_PRINT_LINE("error flag is %d.", gEventQueuePoolErrorFlag);
+    U_PORT_TEST_ASSERT(gEventQueuePoolErrorFlag == 0);
+    for (size_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES; x++) {
+        U_TEST_PRINT_LINE("event queue %d received %d message(s).", x,
+                          gEventQueuePoolCounter[x]);
+        U_PORT_TEST_ASSERT(gEventQueuePoolCounter[x] == U_PORT_TEST_OS_EVENT_QUEUE_ITERATIONS);
+        U_PORT_TEST_ASSERT(!uPortEventQueueIsTask(gEventQueuePoolHandle[x]));
+    }
+
+    // Check stack usage of the workers
+    stackMinFreeBytes = uPortEventQueueStackMinFree(gEventQueuePoolHandle[0]);
+    if (stackMinFreeBytes != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("event queue pool workers had %d byte(s) free out of %d.",
+                          stackMinFreeBytes, U_PORT_EVENT_QUEUE_POOL_STACK_SIZE_BYTES);
+        U_PORT_TEST_ASSERT(stackMinFreeBytes > 0);
+    }
+
+    U_TEST_PRINT_LINE("closing the event queues...");
+    for (size_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_POOL_NUM_QUEUES; x++) {
+        U_PORT_TEST_ASSERT(uPortEventQueueClose(gEventQueuePoolHandle[x]) == 0);
+        U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueuePoolHandle[x], &param,
+                                               sizeof(param)) < 0);
+    }
+
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(1000);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+#endif
+
+/** Test: strtok_r since we have our own implementation on
+ * some platforms.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portStrtok_r")
+{
+    char *pSave;
+    char buffer[8];
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("testing strtok_r()...");
+
+    buffer[sizeof(buffer) - 1] = 'x';
+
+    // memcpy() rather than strncpy() as strncpy() would overwrite the 'x' with 0
+    memcpy(buffer, "abcabc", 7);
+    U_PORT_TEST_ASSERT(strcmp(strtok_r(buffer, "b", &pSave), "a") == 0);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    //lint -e(668) Suppress possible passing of NULL pointer to strcmp,
+    // it's a test, if it goes bang we've failed
+    U_PORT_TEST_ASSERT(strcmp(strtok_r(NULL, "b", &pSave), "ca") == 0);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    //lint -e(668) Suppress possible passing of NULL pointer to strcmp,
+    // it's a test, if it goes bang we've failed
+    U_PORT_TEST_ASSERT(strcmp(strtok_r(NULL, "b", &pSave), "c") == 0);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    U_PORT_TEST_ASSERT(strtok_r(NULL, "b", &pSave) == NULL);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+
+    memcpy(buffer, "abcade", 7);
+    U_PORT_TEST_ASSERT(strcmp(strtok_r(buffer, "a", &pSave), "bc") == 0);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    memcpy(buffer, "abcade", 7);
+    U_PORT_TEST_ASSERT(strcmp(strtok_r(buffer, "a", &pSave), "bc") == 0);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    //lint -e(668) Suppress possible passing of NULL pointer to strcmp,
+    // it's a test, if it goes bang we've failed
+    U_PORT_TEST_ASSERT(strcmp(strtok_r(NULL, "a", &pSave), "de") == 0);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    U_PORT_TEST_ASSERT(strtok_r(NULL, "a", &pSave) == NULL);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+
+    memcpy(buffer, "abcabc", 7);
+    U_PORT_TEST_ASSERT(strcmp(strtok_r(buffer, "d", &pSave), "abcabc") == 0);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+    U_PORT_TEST_ASSERT(strtok_r(NULL, "d", &pSave) == NULL);
+    U_PORT_TEST_ASSERT(buffer[sizeof(buffer) - 1] == 'x');
+
+    uPortDeinit();
+
+    // Check for memory leaks
     heapUsed -= uPortGetHeapFree();
     U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
     // heapUsed < 0 for the Zephyr case where the heap can look
@@ -2330,6 +3134,442 @@ U_PORT_TEST_FUNCTION("[port]", "portUartRequiresSpecificWiring")
 }
 #endif
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+/** Test reading from a UART with uPortUartReadSpan(), where supported.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portUartSpanRequiresSpecificWiring")
+{
+    int32_t uartHandle;
+    const char *pData = NULL;
+    int32_t x;
+    size_t sent = 0;
+    size_t received = 0;
+    int32_t startTimeMs;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    uartHandle = uPortUartOpen(U_CFG_TEST_UART_A, 115200, NULL,
+                               U_CFG_TEST_UART_BUFFER_LENGTH_BYTES,
+                               U_CFG_TEST_PIN_UART_A_TXD,
+                               U_CFG_TEST_PIN_UART_A_RXD,
+                               -1, -1);
+    U_PORT_TEST_ASSERT(uartHandle >= 0);
+
+    x = uPortUartReadSpan(uartHandle, &pData);
+    if (x == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("uPortUartReadSpan() is not supported on this platform.");
+        U_PORT_TEST_ASSERT(uPortUartReleaseSpan(uartHandle, 0) ==
+                           (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+    } else {
+        U_PORT_TEST_ASSERT(x == 0);
+        U_PORT_TEST_ASSERT(uPortUartReadSpan(uartHandle, NULL) < 0);
+        // Can't release what isn't there
+        U_PORT_TEST_ASSERT(uPortUartReleaseSpan(uartHandle, 1) < 0);
+        U_TEST_PRINT_LINE("sending %d byte(s) around the loop-back, %d"
+                          " at a time, and reading them with spans...",
+                          sizeof(gUartTestData) - 1, sizeof(gUartBuffer));
+        startTimeMs = uPortGetTickTimeMs();
+        while ((received < sizeof(gUartTestData) - 1) &&
+               (uPortGetTickTimeMs() - startTimeMs < 10000)) {
+            if (sent == received) {
+                // Send in pieces that are not a divisor of the
+                // receive buffer length so that the spans
+                // go "around the corner"
+                x = sizeof(gUartTestData) - 1 - sent;
+                if (x > (int32_t) sizeof(gUartBuffer)) {
+                    x = sizeof(gUartBuffer);
+                }
+                U_PORT_TEST_ASSERT(uPortUartWrite(uartHandle, gUartTestData + sent, x) == x);
+                sent += x;
+            }
+            x = uPortUartReadSpan(uartHandle, &pData);
+            U_PORT_TEST_ASSERT(x >= 0);
+            U_PORT_TEST_ASSERT(x <= (int32_t) (sent - received));
+            if (x > 0) {
+                U_PORT_TEST_ASSERT(memcmp(pData, gUartTestData + received, x) == 0);
+                // Release the first byte on its own to check that
+                // a span may be released in pieces
+                U_PORT_TEST_ASSERT(uPortUartReleaseSpan(uartHandle, 1) == 0);
+                U_PORT_TEST_ASSERT(uPortUartReleaseSpan(uartHandle, x - 1) == 0);
+                received += x;
+            } else {
+                uPortTaskBlock(10);
+            }
+        }
+        U_TEST_PRINT_LINE("%d byte(s) sent, %d received.", sent, received);
+        U_PORT_TEST_ASSERT(received == sizeof(gUartTestData) - 1);
+        U_PORT_TEST_ASSERT(uPortUartGetReceiveSize(uartHandle) == 0);
+    }
+
+    uPortUartClose(uartHandle);
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+#endif
+
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+/** Test writing to a UART with uPortUartWriteAsync().
+ */
+U_PORT_TEST_FUNCTION("[port]", "portUartWriteAsyncRequiresSpecificWiring")
+{
+    int32_t uartHandle;
+    uartWriteAsyncCallbackData_t callbackData = {0};
+    uPortUartIoVec_t ioVec[U_PORT_UART_WRITE_ASYNC_MAX_NUM_IO_VEC + 1];
+    size_t offset = 0;
+    size_t length;
+    size_t numWrites = 0;
+    size_t received = 0;
+    int32_t x;
+    int32_t startTimeMs;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    uartHandle = uPortUartOpen(U_CFG_TEST_UART_A, 115200, NULL,
+                               U_CFG_TEST_UART_BUFFER_LENGTH_BYTES,
+                               U_CFG_TEST_PIN_UART_A_TXD,
+                               U_CFG_TEST_PIN_UART_A_RXD,
+                               -1, -1);
+    U_PORT_TEST_ASSERT(uartHandle >= 0);
+    callbackData.uartHandle = uartHandle;
+
+    ioVec[0].pBase = gUartTestData;
+    ioVec[0].length = 1;
+    // Not yet opened for asynchronous writes
+    U_PORT_TEST_ASSERT(uPortUartWriteAsync(uartHandle, ioVec, 1,
+                                           uartWriteAsyncCallback,
+                                           &callbackData) < 0);
+    U_PORT_TEST_ASSERT(uPortUartWriteAsyncOpen(uartHandle,
+                                               U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                               U_CFG_OS_APP_TASK_PRIORITY + 1) == 0);
+    U_PORT_TEST_ASSERT(uPortUartWriteAsyncOpen(uartHandle,
+                                               U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                               U_CFG_OS_APP_TASK_PRIORITY + 1) < 0);
+    // Too many pieces
+    U_PORT_TEST_ASSERT(uPortUartWriteAsync(uartHandle, ioVec,
+                                           U_PORT_UART_WRITE_ASYNC_MAX_NUM_IO_VEC + 1,
+                                           uartWriteAsyncCallback,
+                                           &callbackData) < 0);
+
+    // The whole of the test data fits into the receive buffer so
+    // queue it all up in writes of varying numbers of pieces,
+    // as fast as possible, and then check what arrives
+    U_TEST_PRINT_LINE("queueing %d byte(s) of asynchronous writes...",
+                      sizeof(gUartTestData) - 1);
+    while (offset < sizeof(gUartTestData) - 1) {
+        x = 0;
+        while ((x < (int32_t) (numWrites % U_PORT_UART_WRITE_ASYNC_MAX_NUM_IO_VEC) + 1) &&
+               (offset < sizeof(gUartTestData) - 1)) {
+            length = sizeof(gUartTestData) - 1 - offset;
+            if (length > 37) {
+                length = 37;
+            }
+            ioVec[x].pBase = gUartTestData + offset;
+            ioVec[x].length = length;
+            offset += length;
+            x++;
+        }
+        U_PORT_TEST_ASSERT(uPortUartWriteAsync(uartHandle, ioVec, x,
+                                               uartWriteAsyncCallback,
+                                               &callbackData) == 0);
+        numWrites++;
+    }
+    U_TEST_PRINT_LINE("%d write(s) queued, %d completed so far.",
+                      numWrites, callbackData.callCount);
+
+    startTimeMs = uPortGetTickTimeMs();
+    while ((received < sizeof(gUartTestData) - 1) &&
+           (uPortGetTickTimeMs() - startTimeMs < 10000)) {
+        x = uPortUartRead(uartHandle, gUartBuffer, sizeof(gUartBuffer));
+        U_PORT_TEST_ASSERT(x >= 0);
+        if (x > 0) {
+            U_PORT_TEST_ASSERT(memcmp(gUartBuffer, gUartTestData + received, x) == 0);
+            received += x;
+        } else {
+            uPortTaskBlock(10);
+        }
+    }
+
+    // Closing lets any writes still outstanding complete
+    uPortUartWriteAsyncClose(uartHandle);
+    U_TEST_PRINT_LINE("%d write(s) completed, %d byte(s) sent, %d received.",
+                      callbackData.callCount, callbackData.bytesSent, received);
+    U_PORT_TEST_ASSERT(callbackData.errorCode == 0);
+    U_PORT_TEST_ASSERT(callbackData.callCount == numWrites);
+    U_PORT_TEST_ASSERT(callbackData.bytesSent == sizeof(gUartTestData) - 1);
+    U_PORT_TEST_ASSERT(received == sizeof(gUartTestData) - 1);
+
+    uPortUartClose(uartHandle);
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+#endif
+
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+/** Test writing to a UART with uPortUartWritev().
+ */
+U_PORT_TEST_FUNCTION("[port]", "portUartWritevRequiresSpecificWiring")
+{
+    int32_t uartHandle;
+    uPortUartIoVec_t ioVec[4];
+    size_t sent = 0;
+    size_t received = 0;
+    int32_t length;
+    int32_t numIoVec = 0;
+    int32_t startTimeMs;
+    int32_t x;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    uartHandle = uPortUartOpen(U_CFG_TEST_UART_A, 115200, NULL,
+                               U_CFG_TEST_UART_BUFFER_LENGTH_BYTES,
+                               U_CFG_TEST_PIN_UART_A_TXD,
+                               U_CFG_TEST_PIN_UART_A_RXD,
+                               -1, -1);
+    U_PORT_TEST_ASSERT(uartHandle >= 0);
+
+    // Check parameter rejection: no array, a NULL piece that claims
+    // to have a length and nothing at all to send
+    U_PORT_TEST_ASSERT(uPortUartWritev(uartHandle, NULL, 1) < 0);
+    ioVec[0].pBase = NULL;
+    ioVec[0].length = 1;
+    U_PORT_TEST_ASSERT(uPortUartWritev(uartHandle, ioVec, 1) < 0);
+    ioVec[0].length = 0;
+    U_PORT_TEST_ASSERT(uPortUartWritev(uartHandle, ioVec, 1) < 0);
+    U_PORT_TEST_ASSERT(uPortUartGetReceiveSize(uartHandle) == 0);
+
+    U_TEST_PRINT_LINE("sending %d byte(s) around the loop-back with"
+                      " uPortUartWritev()...", sizeof(gUartTestData) - 1);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((received < sizeof(gUartTestData) - 1) &&
+           (uPortGetTickTimeMs() - startTimeMs < 10000)) {
+        if (sent == received) {
+            // Alternate between blocks that fit into the stack
+            // buffer of the default implementation and blocks
+            // that don't, splitting each into one to four pieces
+            // with an empty piece in the middle where there's room
+            length = U_PORT_UART_WRITEV_BUFFER_LENGTH_BYTES / 2;
+            if ((numIoVec & 1) != 0) {
+                length = U_PORT_UART_WRITEV_BUFFER_LENGTH_BYTES + 1;
+            }
+            if (length > (int32_t) sizeof(gUartBuffer)) {
+                length = sizeof(gUartBuffer);
+            }
+            if (length > (int32_t) (sizeof(gUartTestData) - 1 - sent)) {
+                length = sizeof(gUartTestData) - 1 - sent;
+            }
+            numIoVec = (numIoVec % 4) + 1;
+            memset(ioVec, 0, sizeof(ioVec));
+            ioVec[0].pBase = gUartTestData + sent;
+            ioVec[0].length = length;
+            if (numIoVec > 1) {
+                ioVec[0].length = length / 2;
+                ioVec[numIoVec - 1].pBase = gUartTestData + sent + ioVec[0].length;
+                ioVec[numIoVec - 1].length = length - ioVec[0].length;
+            }
+            if (numIoVec > 3) {
+                // Give the piece before last some of the data
+                ioVec[2].pBase = ioVec[3].pBase;
+                ioVec[2].length = ioVec[3].length / 2;
+                ioVec[3].pBase = (const char *) ioVec[3].pBase + ioVec[2].length;
+                ioVec[3].length -= ioVec[2].length;
+            }
+            U_PORT_TEST_ASSERT(uPortUartWritev(uartHandle, ioVec, numIoVec) == length);
+            sent += length;
+        }
+        x = uPortUartRead(uartHandle, gUartBuffer, sent - received);
+        U_PORT_TEST_ASSERT(x >= 0);
+        if (x > 0) {
+            U_PORT_TEST_ASSERT(memcmp(gUartBuffer, gUartTestData + received, x) == 0);
+            received += x;
+        } else {
+            uPortTaskBlock(10);
+        }
+    }
+    U_TEST_PRINT_LINE("%d byte(s) sent, %d received.", sent, received);
+    U_PORT_TEST_ASSERT(received == sizeof(gUartTestData) - 1);
+    U_PORT_TEST_ASSERT(uPortUartGetReceiveSize(uartHandle) == 0);
+
+    uPortUartClose(uartHandle);
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+#endif
+
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0) && defined(ESP_PLATFORM)
+/** Test the UART line-received event; only ESP-IDF supports it at
+ * the moment.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portUartLineRequiresSpecificWiring")
+{
+    int32_t uartHandle;
+    uartLineCallbackData_t callbackData = {0};
+    const char *pNoLine = "no line-feed here";
+    const char *pLine = "a line\n";
+    int32_t length;
+    size_t lineCount;
+    int32_t startTimeMs;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    uartHandle = uPortUartOpen(U_CFG_TEST_UART_A, 115200, NULL,
+                               U_CFG_TEST_UART_BUFFER_LENGTH_BYTES,
+                               U_CFG_TEST_PIN_UART_A_TXD,
+                               U_CFG_TEST_PIN_UART_A_RXD,
+                               -1, -1);
+    U_PORT_TEST_ASSERT(uartHandle >= 0);
+    callbackData.uartHandle = uartHandle;
+
+    U_TEST_PRINT_LINE("add a UART event callback for lines only...");
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(uartHandle,
+                                                 (uint32_t) U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED,
+                                                 uartLineCallback,
+                                                 (void *) &callbackData,
+                                                 U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                                 U_CFG_OS_APP_TASK_PRIORITY + 1) == 0);
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackFilterGet(uartHandle) ==
+                       U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED);
+
+    // Data without a line-feed must not produce a line event
+    length = (int32_t) strlen(pNoLine);
+    U_PORT_TEST_ASSERT(uPortUartWrite(uartHandle, pNoLine, length) == length);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((uPortUartGetReceiveSize(uartHandle) < length) &&
+           (uPortGetTickTimeMs() - startTimeMs < 1000)) {
+        uPortTaskBlock(10);
+    }
+    uPortTaskBlock(100);
+    U_PORT_TEST_ASSERT(uPortUartRead(uartHandle, gUartBuffer, sizeof(gUartBuffer)) == length);
+    U_PORT_TEST_ASSERT(memcmp(gUartBuffer, pNoLine, length) == 0);
+    U_PORT_TEST_ASSERT(callbackData.lineCount == 0);
+
+    // Each line-feed should produce one line event, and no
+    // data event since that is not in the filter
+    length = (int32_t) strlen(pLine);
+    for (size_t x = 1; x <= 3; x++) {
+        U_PORT_TEST_ASSERT(uPortUartWrite(uartHandle, pLine, length) == length);
+        startTimeMs = uPortGetTickTimeMs();
+        while ((callbackData.lineCount < x) &&
+               (uPortGetTickTimeMs() - startTimeMs < 1000)) {
+            uPortTaskBlock(10);
+        }
+        U_TEST_PRINT_LINE("line %d: %d line event(s).", x, callbackData.lineCount);
+        U_PORT_TEST_ASSERT(callbackData.lineCount == x);
+        U_PORT_TEST_ASSERT(uPortUartRead(uartHandle, gUartBuffer, sizeof(gUartBuffer)) == length);
+        U_PORT_TEST_ASSERT(memcmp(gUartBuffer, pLine, length) == 0);
+    }
+    U_PORT_TEST_ASSERT(callbackData.dataCount == 0);
+    U_PORT_TEST_ASSERT(callbackData.errorCode == 0);
+
+    // Changing the filter to data only should switch line
+    // detection off again
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackFilterSet(uartHandle,
+                                                       (uint32_t) U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) ==
+                       0);
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackFilterGet(uartHandle) ==
+                       U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED);
+    lineCount = callbackData.lineCount;
+    U_PORT_TEST_ASSERT(uPortUartWrite(uartHandle, pLine, length) == length);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((callbackData.dataCount == 0) &&
+           (uPortGetTickTimeMs() - startTimeMs < 1000)) {
+        uPortTaskBlock(10);
+    }
+    uPortTaskBlock(100);
+    U_TEST_PRINT_LINE("with data filter: %d data event(s), %d line event(s).",
+                      callbackData.dataCount, callbackData.lineCount - lineCount);
+    U_PORT_TEST_ASSERT(callbackData.dataCount > 0);
+    U_PORT_TEST_ASSERT(callbackData.lineCount == lineCount);
+    U_PORT_TEST_ASSERT(uPortUartRead(uartHandle, gUartBuffer, sizeof(gUartBuffer)) == length);
+
+    // And putting it back should switch line detection on again
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackFilterSet(uartHandle,
+                                                       (uint32_t) U_PORT_UART_EVENT_BITMASK_LINE_RECEIVED) ==
+                       0);
+    U_PORT_TEST_ASSERT(uPortUartWrite(uartHandle, pLine, length) == length);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((callbackData.lineCount == lineCount) &&
+           (uPortGetTickTimeMs() - startTimeMs < 1000)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(callbackData.lineCount == lineCount + 1);
+    U_PORT_TEST_ASSERT(uPortUartRead(uartHandle, gUartBuffer, sizeof(gUartBuffer)) == length);
+    U_PORT_TEST_ASSERT(callbackData.errorCode == 0);
+
+    uPortUartEventCallbackRemove(uartHandle);
+    uPortUartClose(uartHandle);
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+#endif
+
 #if (U_CFG_APP_GNSS_I2C >= 0)
 /** Test I2C.
  */
@@ -2486,6 +3726,33 @@ U_PORT_TEST_FUNCTION("[port]", "portI2cRequiresSpecificWiring")
     U_PORT_TEST_ASSERT(buffer2[0] == 0x06);
     U_PORT_TEST_ASSERT(buffer2[1] == 0x00);
 
+    U_TEST_PRINT_LINE("reading the number of bytes waiting asynchronously.");
+    // Not yet opened for asynchronous transfers
+    U_PORT_TEST_ASSERT(uPortI2cControllerSendReceiveAsync(gI2cHandle, U_PORT_TEST_I2C_ADDRESS,
+                                                          buffer1, 1, buffer2, 2,
+                                                          i2cAsyncCallback,
+                                                          (void *) &gI2cAsyncCallCount) < 0);
+    U_PORT_TEST_ASSERT(uPortI2cAsyncOpen(gI2cHandle, U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                         U_CFG_OS_APP_TASK_PRIORITY + 1) == 0);
+    // Can't open twice
+    U_PORT_TEST_ASSERT(uPortI2cAsyncOpen(gI2cHandle, U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                         U_CFG_OS_APP_TASK_PRIORITY + 1) < 0);
+    // This time send the register address and read the length in one
+    // transaction, with a repeated start, as is done for a GNSS device
+    gI2cAsyncCallCount = 0;
+    gI2cAsyncErrorCodeOrLength = 0;
+    buffer1[0] = 0xFD;
+    U_PORT_TEST_ASSERT(uPortI2cControllerSendReceiveAsync(gI2cHandle, U_PORT_TEST_I2C_ADDRESS,
+                                                          buffer1, 1, buffer2, 2,
+                                                          i2cAsyncCallback,
+                                                          (void *) &gI2cAsyncCallCount) == 0);
+    // Closing waits for the transfer to complete
+    uPortI2cAsyncClose(gI2cHandle);
+    U_TEST_PRINT_LINE("asynchronous read of number of bytes waiting returned %d, 0x[%02x][%02x].",
+                      gI2cAsyncErrorCodeOrLength, buffer2[0], buffer2[1]);
+    U_PORT_TEST_ASSERT(gI2cAsyncCallCount == 1);
+    U_PORT_TEST_ASSERT(gI2cAsyncErrorCodeOrLength == 2);
+
     // Deinit I2C without closing the open instance; should tidy itself up
     uPortI2cDeinit();
     U_PORT_TEST_ASSERT(uPortI2cGetClock(gI2cHandle) < 0);
@@ -2512,14 +3779,102 @@ U_PORT_TEST_FUNCTION("[port]", "portI2cRequiresSpecificWiring")
 }
 #endif
 
+#if (U_CFG_TEST_SPI >= 0) && (U_CFG_TEST_PIN_SPI_SELECT >= 0)
+/** Test SPI: requires MOSI to be looped back to MISO.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portSpiRequiresSpecificWiring")
+{
+    int32_t spiHandle;
+    int32_t y;
+    int32_t heapUsed;
+    int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+    char bufferOut[64];
+    char bufferIn[sizeof(bufferOut)];
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uPortSpiInit() == 0);
+
+    U_TEST_PRINT_LINE("testing SPI %d, MOSI pin %d looped back to MISO pin %d,"
+                      " clock pin %d, select pin %d.", U_CFG_TEST_SPI,
+                      U_CFG_TEST_PIN_SPI_MOSI, U_CFG_TEST_PIN_SPI_MISO,
+                      U_CFG_TEST_PIN_SPI_CLK, U_CFG_TEST_PIN_SPI_SELECT);
+    spiHandle = uPortSpiOpen(U_CFG_TEST_SPI, U_CFG_TEST_PIN_SPI_MOSI,
+                             U_CFG_TEST_PIN_SPI_MISO, U_CFG_TEST_PIN_SPI_CLK,
+                             U_CFG_TEST_PIN_SPI_SELECT);
+    U_PORT_TEST_ASSERT(spiHandle >= 0);
+    // Can't open the same HW block twice
+    U_PORT_TEST_ASSERT(uPortSpiOpen(U_CFG_TEST_SPI, U_CFG_TEST_PIN_SPI_MOSI,
+                                    U_CFG_TEST_PIN_SPI_MISO, U_CFG_TEST_PIN_SPI_CLK,
+                                    U_CFG_TEST_PIN_SPI_SELECT) < 0);
+
+    // The clock should start at the default, the HW may round down
+    y = uPortSpiControllerGetClock(spiHandle);
+    U_TEST_PRINT_LINE("SPI clock is %d Hz.", y);
+    U_PORT_TEST_ASSERT((y > 0) && (y <= U_PORT_SPI_CLOCK_FREQUENCY_HERTZ));
+    U_PORT_TEST_ASSERT(uPortSpiControllerSetClock(spiHandle,
+                                                  U_PORT_SPI_CLOCK_FREQUENCY_HERTZ / 2) == 0);
+    y = uPortSpiControllerGetClock(spiHandle);
+    U_TEST_PRINT_LINE("SPI clock is now %d Hz.", y);
+    U_PORT_TEST_ASSERT((y > 0) && (y <= U_PORT_SPI_CLOCK_FREQUENCY_HERTZ / 2));
+
+    // What goes out should come back
+    for (size_t x = 0; x < sizeof(bufferOut); x++) {
+        bufferOut[x] = (char) (x + 1);
+    }
+    memset(bufferIn, 0, sizeof(bufferIn));
+    U_PORT_TEST_ASSERT(uPortSpiControllerSendReceiveBlock(spiHandle, bufferOut, bufferIn,
+                                                          sizeof(bufferOut)) == (int32_t) sizeof(bufferOut));
+    U_PORT_TEST_ASSERT(memcmp(bufferIn, bufferOut, sizeof(bufferIn)) == 0);
+
+    // Receive only: what comes back should be the fill byte
+    memset(bufferIn, 0, sizeof(bufferIn));
+    U_PORT_TEST_ASSERT(uPortSpiControllerSendReceiveBlock(spiHandle, NULL, bufferIn,
+                                                          sizeof(bufferIn)) == (int32_t) sizeof(bufferIn));
+    for (size_t x = 0; x < sizeof(bufferIn); x++) {
+        U_PORT_TEST_ASSERT(bufferIn[x] == (char) U_PORT_SPI_FILL_BYTE);
+    }
+
+    // Send only
+    U_PORT_TEST_ASSERT(uPortSpiControllerSendReceiveBlock(spiHandle, bufferOut, NULL,
+                                                          sizeof(bufferOut)) == (int32_t) sizeof(bufferOut));
+
+    uPortSpiClose(spiHandle);
+    // A closed handle should be refused
+    U_PORT_TEST_ASSERT(uPortSpiControllerSendReceiveBlock(spiHandle, bufferOut, bufferIn,
+                                                          sizeof(bufferOut)) < 0);
+    U_PORT_TEST_ASSERT(uPortSpiControllerGetClock(spiHandle) < 0);
+
+    uPortSpiDeinit();
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("%d byte(s) of heap were lost to the C library"
+                      " during this test and we have leaked %d byte(s).",
+                      gSystemHeapLost - heapClibLossOffset,
+                      heapUsed - (gSystemHeapLost - heapClibLossOffset));
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed < 0) ||
+                       (heapUsed <= ((int32_t) gSystemHeapLost) - heapClibLossOffset));
+}
+#endif
+
 /** Test crypto: not a rigorous test, more a "hello world".
  */
 U_PORT_TEST_FUNCTION("[port]", "portCrypto")
 {
     char buffer[64];
     char iv[U_PORT_CRYPTO_AES128_INITIALISATION_VECTOR_LENGTH_BYTES];
+    void *pContext = NULL;
     int32_t heapUsed;
     int32_t x;
+    size_t z;
 
     // Whatever called us likely initialised the
     // port so deinitialise it here to obtain the
@@ -2543,6 +3898,30 @@ U_PORT_TEST_FUNCTION("[port]", "portCrypto")
         U_TEST_PRINT_LINE("SHA256 not supported.");
     }
 
+    U_TEST_PRINT_LINE("testing SHA256 in pieces...");
+    memset(buffer, 0, sizeof(buffer));
+    x = uPortCryptoSha256Start(&pContext);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_PORT_TEST_ASSERT(x == (int32_t) U_ERROR_COMMON_SUCCESS);
+        // Feed it in uneven pieces, including an empty one
+        for (size_t y = 0; y < sizeof(gSha256Input) - 1; y += z) {
+            z = (y % 7) + 1;
+            if (y + z > sizeof(gSha256Input) - 1) {
+                z = sizeof(gSha256Input) - 1 - y;
+            }
+            U_PORT_TEST_ASSERT(uPortCryptoSha256Update(pContext, gSha256Input + y, z) == 0);
+            U_PORT_TEST_ASSERT(uPortCryptoSha256Update(pContext, NULL, 0) == 0);
+        }
+        U_PORT_TEST_ASSERT(uPortCryptoSha256Finish(pContext, buffer) == 0);
+        U_PORT_TEST_ASSERT(memcmp(buffer, gSha256Output,
+                                  U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES) == 0);
+        // Abandon one
+        U_PORT_TEST_ASSERT(uPortCryptoSha256Start(&pContext) == 0);
+        U_PORT_TEST_ASSERT(uPortCryptoSha256Finish(pContext, NULL) == 0);
+    } else {
+        U_TEST_PRINT_LINE("SHA256 in pieces not supported.");
+    }
+
     U_TEST_PRINT_LINE("testing HMAC SHA256...");
     x = uPortCryptoHmacSha256(gHmacSha256Key,
                               sizeof(gHmacSha256Key) - 1,
@@ -2596,6 +3975,131 @@ U_PORT_TEST_FUNCTION("[port]", "portCrypto")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Measure the throughput and latency of the crypto functions,
+ * e.g. to compare a hardware implementation against mbedTLS (see
+ * U_PORT_CRYPTO_HARDWARE), checking along the way that AES CBC
+ * decryption undoes encryption, that the initialisation vector is
+ * updated for chaining and that a misaligned buffer, which a
+ * hardware implementation may hand to mbedTLS, gives the same answer.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portCryptoBenchmark")
+{
+    char *pBuffer;
+    char *pClear;
+    char *pEncrypted;
+    char *pDecrypted;
+    char output[U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES];
+    char iv[U_PORT_CRYPTO_AES128_INITIALISATION_VECTOR_LENGTH_BYTES];
+    int32_t heapUsed;
+    int32_t startTimeMs;
+    int32_t durationMs[4];
+    int32_t x;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // One word-aligned block of memory for the clear, encrypted and
+    // decrypted data plus one extra word, so that the clear data can
+    // be moved to a misaligned address
+    pBuffer = (char *) malloc((U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES * 3) +
+                              sizeof(int32_t));
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    pClear = pBuffer;
+    pEncrypted = pClear + U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES;
+    pDecrypted = pEncrypted + U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES;
+    for (size_t y = 0; y < U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES; y++) {
+        *(pClear + y) = (char) rand();
+    }
+
+    U_TEST_PRINT_LINE("%d iteration(s) of each, times in milliseconds.",
+                      U_PORT_TEST_CRYPTO_BENCHMARK_ITERATIONS);
+    U_TEST_PRINT_LINE("bytes    SHA256  HMAC SHA256  AES128 CBC enc  AES128 CBC dec");
+    for (size_t length = 16; length <= U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES;
+         length *= 4) {
+        startTimeMs = uPortGetTickTimeMs();
+        for (size_t y = 0; y < U_PORT_TEST_CRYPTO_BENCHMARK_ITERATIONS; y++) {
+            x = uPortCryptoSha256(pClear, length, output);
+            U_PORT_TEST_ASSERT((x == 0) || (x == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED));
+        }
+        durationMs[0] = uPortGetTickTimeMs() - startTimeMs;
+        startTimeMs = uPortGetTickTimeMs();
+        for (size_t y = 0; y < U_PORT_TEST_CRYPTO_BENCHMARK_ITERATIONS; y++) {
+            x = uPortCryptoHmacSha256(gHmacSha256Key, sizeof(gHmacSha256Key) - 1,
+                                      pClear, length, output);
+            U_PORT_TEST_ASSERT((x == 0) || (x == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED));
+        }
+        durationMs[1] = uPortGetTickTimeMs() - startTimeMs;
+        memcpy(iv, gAes128CbcIV, sizeof(iv));
+        startTimeMs = uPortGetTickTimeMs();
+        for (size_t y = 0; y < U_PORT_TEST_CRYPTO_BENCHMARK_ITERATIONS; y++) {
+            x = uPortCryptoAes128CbcEncrypt(gAes128CbcKey, sizeof(gAes128CbcKey) - 1,
+                                            iv, pClear, length, pEncrypted);
+            U_PORT_TEST_ASSERT((x == 0) || (x == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED));
+        }
+        durationMs[2] = uPortGetTickTimeMs() - startTimeMs;
+        if (x == 0) {
+            // Chaining: the initialisation vector must now be the last
+            // block of the most recent output
+            U_PORT_TEST_ASSERT(memcmp(iv, pEncrypted + length - sizeof(iv), sizeof(iv)) == 0);
+        }
+        memcpy(iv, gAes128CbcIV, sizeof(iv));
+        startTimeMs = uPortGetTickTimeMs();
+        for (size_t y = 0; y < U_PORT_TEST_CRYPTO_BENCHMARK_ITERATIONS; y++) {
+            x = uPortCryptoAes128CbcDecrypt(gAes128CbcKey, sizeof(gAes128CbcKey) - 1,
+                                            iv, pEncrypted, length, pDecrypted);
+            U_PORT_TEST_ASSERT((x == 0) || (x == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED));
+        }
+        durationMs[3] = uPortGetTickTimeMs() - startTimeMs;
+        if (x == 0) {
+            // The encrypted data is the output of the last of a chain of
+            // encryptions, so only the first block of the decrypted data
+            // depends on the IV; the rest must match
+            if (length > sizeof(iv)) {
+                U_PORT_TEST_ASSERT(memcmp(pDecrypted + sizeof(iv), pClear + sizeof(iv),
+                                          length - sizeof(iv)) == 0);
+            }
+            U_PORT_TEST_ASSERT(memcmp(iv, pEncrypted + length - sizeof(iv), sizeof(iv)) == 0);
+        }
+        U_TEST_PRINT_LINE("%5d  %8d  %11d  %14d  %14d", (int32_t) length, durationMs[0],
+                          durationMs[1], durationMs[2], durationMs[3]);
+    }
+
+    U_TEST_PRINT_LINE("checking a round trip at an unaligned address...");
+    memcpy(iv, gAes128CbcIV, sizeof(iv));
+    x = uPortCryptoAes128CbcEncrypt(gAes128CbcKey, sizeof(gAes128CbcKey) - 1,
+                                    iv, pClear, U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES,
+                                    pEncrypted);
+    if (x == 0) {
+        // Move the clear data up by one byte (into the spare word at the
+        // end, shifting the encrypted and decrypted areas along with it)
+        memmove(pClear + 1, pClear, U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES * 2);
+        memcpy(iv, gAes128CbcIV, sizeof(iv));
+        x = uPortCryptoAes128CbcDecrypt(gAes128CbcKey, sizeof(gAes128CbcKey) - 1,
+                                        iv, pEncrypted + 1,
+                                        U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES,
+                                        pDecrypted + 1);
+        U_PORT_TEST_ASSERT(x == 0);
+        U_PORT_TEST_ASSERT(memcmp(pDecrypted + 1, pClear + 1,
+                                  U_PORT_TEST_CRYPTO_BENCHMARK_MAX_LENGTH_BYTES) == 0);
+    }
+
+    free(pBuffer);
+
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Test timers.
  */
 U_PORT_TEST_FUNCTION("[port]", "portTimers")
@@ -2838,6 +4342,131 @@ U_PORT_TEST_FUNCTION("[port]", "portCriticalSection")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Test the heap API: a user allocator and arenas.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portHeap")
+{
+    int32_t heapUsed;
+    uPortHeapAllocator_t allocator;
+    uPortHeapStats_t statsBefore;
+    uPortHeapStats_t stats;
+    uPortHeapArena_t arena;
+    size_t calls = 0;
+    uint32_t buffer[32];
+    char *pMemory;
+    char *pMemory2;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+
+    gHeapTestAllocCount = 0;
+    gHeapTestFreeCount = 0;
+    allocator.pAlloc = heapTestAlloc;
+    allocator.pRealloc = heapTestRealloc;
+    allocator.pFree = NULL;
+    allocator.pParam = &calls;
+    U_PORT_TEST_ASSERT(uPortHeapAllocatorSet(&allocator) < 0);
+    allocator.pFree = heapTestFree;
+    // Nothing should be allocated, so this should work
+    U_PORT_TEST_ASSERT(uPortHeapAllocatorSet(&allocator) == 0);
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uPortHeapGetStats(U_PORT_HEAP_TAG_MAX_NUM, &stats) < 0);
+    U_PORT_TEST_ASSERT(uPortHeapGetStats(U_PORT_HEAP_TAG_APPLICATION, &statsBefore) == 0);
+
+    U_TEST_PRINT_LINE("testing user allocator.");
+    pMemory = (char *) pUPortHeapAlloc(10, U_PORT_HEAP_TAG_APPLICATION);
+    U_PORT_TEST_ASSERT(pMemory != NULL);
+    U_PORT_TEST_ASSERT(gHeapTestLastTag == U_PORT_HEAP_TAG_APPLICATION);
+    memset(pMemory, 'a', 10);
+    pMemory = (char *) pUPortHeapRealloc(pMemory, 20, U_PORT_HEAP_TAG_APPLICATION);
+    U_PORT_TEST_ASSERT(pMemory != NULL);
+    U_PORT_TEST_ASSERT(pMemory[9] == 'a');
+    // Can't change the allocator with something allocated
+    U_PORT_TEST_ASSERT(uPortHeapAllocatorSet(NULL) < 0);
+    uPortHeapFree(pMemory, U_PORT_HEAP_TAG_APPLICATION);
+    U_PORT_TEST_ASSERT(gHeapTestAllocCount == 2);
+    U_PORT_TEST_ASSERT(gHeapTestFreeCount == 1);
+    U_PORT_TEST_ASSERT(calls == 3);
+    U_PORT_TEST_ASSERT(uPortHeapGetStats(U_PORT_HEAP_TAG_APPLICATION, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.allocCount == statsBefore.allocCount + 1);
+    U_PORT_TEST_ASSERT(stats.freeCount == statsBefore.freeCount + 1);
+    U_PORT_TEST_ASSERT(stats.outstanding == statsBefore.outstanding);
+
+    U_TEST_PRINT_LINE("testing tracking.");
+    pMemory = (char *) pUPortHeapAlloc(10, U_PORT_HEAP_TAG_APPLICATION);
+    U_PORT_TEST_ASSERT(pMemory != NULL);
+    U_PORT_TEST_ASSERT(uPortHeapPrintOutstanding(U_PORT_HEAP_TAG_APPLICATION) ==
+                       statsBefore.outstanding + 1);
+    U_PORT_TEST_ASSERT(uPortHeapGetStats(U_PORT_HEAP_TAG_APPLICATION, &stats) == 0);
+#ifdef U_CFG_HEAP_TRACKER
+    U_PORT_TEST_ASSERT(stats.liveBytes == statsBefore.liveBytes + 10);
+#else
+    U_PORT_TEST_ASSERT(stats.liveBytes == 0);
+#endif
+    pMemory = (char *) pUPortHeapRealloc(pMemory, 30, U_PORT_HEAP_TAG_APPLICATION);
+    U_PORT_TEST_ASSERT(pMemory != NULL);
+    U_PORT_TEST_ASSERT(uPortHeapGetStats(U_PORT_HEAP_TAG_APPLICATION, &stats) == 0);
+#ifdef U_CFG_HEAP_TRACKER
+    U_PORT_TEST_ASSERT(stats.liveBytes == statsBefore.liveBytes + 30);
+    U_PORT_TEST_ASSERT(stats.liveBytesPeak >= statsBefore.liveBytes + 30);
+#endif
+    uPortHeapPrintStats();
+    uPortHeapFree(pMemory, U_PORT_HEAP_TAG_APPLICATION);
+    U_PORT_TEST_ASSERT(uPortHeapGetStats(U_PORT_HEAP_TAG_APPLICATION, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.outstanding == statsBefore.outstanding);
+    U_PORT_TEST_ASSERT(stats.liveBytes == statsBefore.liveBytes);
+
+    U_TEST_PRINT_LINE("testing arena.");
+    gHeapTestAllocCount = 0;
+    gHeapTestFreeCount = 0;
+    uPortHeapArenaInit(&arena, 64, U_PORT_HEAP_TAG_APPLICATION,
+                       ((char *) buffer) + 1, sizeof(buffer) - 1);
+    // A small allocation should come from the buffer
+    pMemory = (char *) pUPortHeapArenaAlloc(&arena, 3);
+    U_PORT_TEST_ASSERT(pMemory != NULL);
+    U_PORT_TEST_ASSERT((pMemory > (char *) buffer) &&
+                       (pMemory < ((char *) buffer) + sizeof(buffer)));
+    U_PORT_TEST_ASSERT((((uintptr_t) pMemory) % U_PORT_HEAP_ARENA_ALIGNMENT_BYTES) == 0);
+    U_PORT_TEST_ASSERT(gHeapTestAllocCount == 0);
+    memset(pMemory, 'b', 3);
+    // A big allocation should get a chunk to itself
+    pMemory2 = (char *) pUPortHeapArenaAlloc(&arena, 1000);
+    U_PORT_TEST_ASSERT(pMemory2 != NULL);
+    memset(pMemory2, 'c', 1000);
+    U_PORT_TEST_ASSERT(gHeapTestAllocCount == 1);
+    // Lots of smaller allocations should get only a few chunks
+    for (size_t x = 0; x < 16; x++) {
+        U_PORT_TEST_ASSERT(pUPortHeapArenaAlloc(&arena, 16) != NULL);
+    }
+    U_TEST_PRINT_LINE("%d chunk(s) allocated.", (int32_t) gHeapTestAllocCount);
+    U_PORT_TEST_ASSERT(gHeapTestAllocCount <= 1 + 5);
+    U_PORT_TEST_ASSERT(pMemory[2] == 'b');
+    U_PORT_TEST_ASSERT(pMemory2[999] == 'c');
+    // Release the lot in one go
+    uPortHeapArenaRelease(&arena);
+    U_PORT_TEST_ASSERT(gHeapTestFreeCount == gHeapTestAllocCount);
+    // The buffer should be re-used
+    U_PORT_TEST_ASSERT(pUPortHeapArenaAlloc(&arena, 3) == pMemory);
+    uPortHeapArenaRelease(&arena);
+    U_PORT_TEST_ASSERT(uPortHeapGetStats(U_PORT_HEAP_TAG_APPLICATION, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.outstanding == statsBefore.outstanding);
+
+    uPortDeinit();
+
+    // Go back to malloc()
+    U_PORT_TEST_ASSERT(uPortHeapAllocatorSet(NULL) == 0);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -3,9 +3,49 @@
 # that are selected based on UBXLIB_FEATURES. Check README.md for details.
 cmake_minimum_required(VERSION 3.13.1)
 
+# Feature profiles: a profile is a named, declarative selection of
+# features, sub-features to exclude and build options; set
+# UBXLIB_PROFILE to one of the names below to apply it on top of
+# whatever is already in UBXLIB_FEATURES and UBXLIB_FEATURES_EXCLUDE.
+# full: everything
+set(UBXLIB_PROFILE_full_FEATURES short_range cell gnss)
+set(UBXLIB_PROFILE_full_EXCLUDE "")
+set(UBXLIB_PROFILE_full_LTO OFF)
+# minimal: the same module types without any of the optional
+# sub-features, with link-time optimisation
+set(UBXLIB_PROFILE_minimal_FEATURES short_range cell gnss)
+set(UBXLIB_PROFILE_minimal_EXCLUDE cell_loc cell_fota cell_c2c ble_sps)
+set(UBXLIB_PROFILE_minimal_LTO ON)
+
+if (DEFINED UBXLIB_PROFILE)
+  if (NOT DEFINED UBXLIB_PROFILE_${UBXLIB_PROFILE}_FEATURES)
+    message(FATAL_ERROR "Unknown UBXLIB_PROFILE: ${UBXLIB_PROFILE}")
+  endif()
+  list(APPEND UBXLIB_FEATURES ${UBXLIB_PROFILE_${UBXLIB_PROFILE}_FEATURES})
+  list(APPEND UBXLIB_FEATURES_EXCLUDE ${UBXLIB_PROFILE_${UBXLIB_PROFILE}_EXCLUDE})
+  if (NOT DEFINED UBXLIB_LTO)
+    set(UBXLIB_LTO ${UBXLIB_PROFILE_${UBXLIB_PROFILE}_LTO})
+  endif()
+endif()
+
 # Always include base feature
 list(APPEND UBXLIB_FEATURES base)
 
+# Sub-features are enabled along with their parent feature
+# unless they are listed in UBXLIB_FEATURES_EXCLUDE
+set(UBXLIB_SUB_FEATURES_cell cell_loc cell_fota cell_c2c)
+set(UBXLIB_SUB_FEATURES_short_range ble_sps)
+foreach(parent cell short_range)
+  if (${parent} IN_LIST UBXLIB_FEATURES)
+    foreach(sub ${UBXLIB_SUB_FEATURES_${parent}})
+      if (NOT ${sub} IN_LIST UBXLIB_FEATURES_EXCLUDE)
+        list(APPEND UBXLIB_FEATURES ${sub})
+      endif()
+    endforeach()
+  endif()
+endforeach()
+list(REMOVE_DUPLICATES UBXLIB_FEATURES)
+
 # Conditionally add one .c file to UBXLIB_SRC
 function(u_add_source_file feature file)
   if (NOT EXISTS ${file})
@@ -24,6 +64,8 @@ function(u_add_source_dir feature src_dir)
   endif()
   if (${feature} IN_LIST UBXLIB_FEATURES)
     file(GLOB SRCS ${src_dir}/*.c)
+    # Stubs are only added explicitly, for excluded features
+    list(FILTER SRCS EXCLUDE REGEX "_stub\\.c$")
     list(APPEND UBXLIB_SRC ${SRCS})
     set(UBXLIB_SRC ${UBXLIB_SRC} PARENT_SCOPE)
   endif()
@@ -44,6 +86,15 @@ function(u_add_test_source_dir feature src_dir)
   endif()
 endfunction()
 
+# Remove one .c file from UBXLIB_SRC and UBXLIB_TEST_SRC
+function(u_remove_source_file file)
+  get_filename_component(file ${file} ABSOLUTE)
+  list(REMOVE_ITEM UBXLIB_SRC ${file})
+  list(REMOVE_ITEM UBXLIB_TEST_SRC ${file})
+  set(UBXLIB_SRC ${UBXLIB_SRC} PARENT_SCOPE)
+  set(UBXLIB_TEST_SRC ${UBXLIB_TEST_SRC} PARENT_SCOPE)
+endfunction()
+
 # This function will take a module directory and:
 # - Add <module_dir>/src/*.c to UBXLIB_SRC
 # - Add <module_dir>/src to UBXLIB_PRIVATE_INC
@@ -84,6 +135,7 @@ endfunction()
 
 # Add /api, /src and /test sub folders for these:
 u_add_module_dir(base ${UBXLIB_BASE}/common/at_client)
+u_add_module_dir(base ${UBXLIB_BASE}/common/cmux)
 u_add_module_dir(base ${UBXLIB_BASE}/common/error)
 u_add_module_dir(base ${UBXLIB_BASE}/common/assert)
 u_add_module_dir(base ${UBXLIB_BASE}/common/location)
@@ -99,6 +151,11 @@ u_add_module_dir(base ${UBXLIB_BASE}/port/platform/common/debug_utils)
 u_add_source_dir(base ${UBXLIB_BASE}/port/platform/common/event_queue)
 u_add_source_dir(base ${UBXLIB_BASE}/port/platform/common/mutex_debug)
 u_add_source_dir(base ${UBXLIB_BASE}/port/platform/common/log_ram)
+u_add_source_dir(base ${UBXLIB_BASE}/port/platform/common/heap)
+u_add_source_dir(base ${UBXLIB_BASE}/port/platform/common/uart)
+u_add_source_dir(base ${UBXLIB_BASE}/port/platform/common/i2c)
+u_add_source_dir(base ${UBXLIB_BASE}/port/platform/common/profile)
+u_add_source_dir(base ${UBXLIB_BASE}/port/platform/common/task_stack)
 
 # Additional include directories
 list(APPEND UBXLIB_INC
@@ -115,6 +172,7 @@ list(APPEND UBXLIB_PRIVATE_INC
 
 # Device and network require special care since they contains stub & optional files
 list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/common/network/src/u_network.c)
+list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/common/network/src/u_network_bearer.c)
 list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/common/network/src/u_network_shared.c)
 list(APPEND UBXLIB_INC ${UBXLIB_BASE}/common/network/api)
 list(APPEND UBXLIB_PRIVATE_INC ${UBXLIB_BASE}/common/network/src)
@@ -142,6 +200,7 @@ u_add_source_file(cell ${UBXLIB_BASE}/common/device/src/u_device_private_cell.c)
 u_add_module_dir(gnss ${UBXLIB_BASE}/gnss)
 u_add_source_file(gnss ${UBXLIB_BASE}/common/network/src/u_network_private_gnss.c)
 u_add_source_file(gnss ${UBXLIB_BASE}/common/device/src/u_device_private_gnss.c)
+
 # lib_common
 # We have a dependency issue with libfibonacci so lib_common/test needs to manually
 # included by the runner app instead at the moment. For this reason we just add the
@@ -154,6 +213,7 @@ endif()
 # Test related files and directories
 list(APPEND UBXLIB_TEST_INC
   ${UBXLIB_BASE}/common/network/test
+  ${UBXLIB_BASE}/port/platform/common/test
 )
 u_add_test_source_dir(base ${UBXLIB_BASE}/port/platform/common/test)
 u_add_test_source_dir(base ${UBXLIB_BASE}/port/test)
@@ -169,3 +229,40 @@ u_add_test_source_dir(base ${UBXLIB_BASE}/example/cell/lte_cfg)
 u_add_test_source_dir(base ${UBXLIB_BASE}/example/cell/power_saving)
 u_add_test_source_dir(base ${UBXLIB_BASE}/example/gnss)
 u_add_test_source_dir(base ${UBXLIB_BASE}/example/utilities/c030_module_fw_update)
+
+# Excluded sub-features: remove their source and test files,
+# replacing them with a stub or a compile definition where the
+# rest of ubxlib calls into them
+if ((cell IN_LIST UBXLIB_FEATURES) AND (NOT cell_loc IN_LIST UBXLIB_FEATURES))
+  u_remove_source_file(${UBXLIB_BASE}/cell/src/u_cell_loc.c)
+  u_remove_source_file(${UBXLIB_BASE}/cell/test/u_cell_loc_test.c)
+  list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/cell/src/u_cell_loc_stub.c)
+endif()
+if ((cell IN_LIST UBXLIB_FEATURES) AND (NOT cell_fota IN_LIST UBXLIB_FEATURES))
+  u_remove_source_file(${UBXLIB_BASE}/cell/src/u_cell_fota.c)
+  u_remove_source_file(${UBXLIB_BASE}/cell/test/u_cell_fota_test.c)
+endif()
+if ((cell IN_LIST UBXLIB_FEATURES) AND (NOT cell_c2c IN_LIST UBXLIB_FEATURES))
+  u_remove_source_file(${UBXLIB_BASE}/cell/src/u_cell_sec_c2c.c)
+  u_remove_source_file(${UBXLIB_BASE}/cell/test/u_cell_sec_c2c_test.c)
+  u_remove_source_file(${UBXLIB_BASE}/example/security/c2c/c2c_main.c)
+  list(APPEND UBXLIB_COMPILE_DEFINITIONS U_CFG_CELL_DISABLE_C2C)
+endif()
+if ((short_range IN_LIST UBXLIB_FEATURES) AND (NOT ble_sps IN_LIST UBXLIB_FEATURES))
+  u_remove_source_file(${UBXLIB_BASE}/ble/src/u_ble_sps_extmod.c)
+  u_remove_source_file(${UBXLIB_BASE}/ble/src/u_ble_sps_intmod.c)
+  u_remove_source_file(${UBXLIB_BASE}/ble/test/u_ble_sps_test.c)
+  list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/ble/src/u_ble_sps_stub.c)
+endif()
+
+# Build options: each function and data item in its own section so
+# that the linker can discard whatever the application does not use
+# and, if UBXLIB_LTO is set, link-time optimisation
+if (CMAKE_C_COMPILER_ID MATCHES "GNU|Clang")
+  list(APPEND UBXLIB_COMPILE_OPTIONS -ffunction-sections -fdata-sections)
+  list(APPEND UBXLIB_LINK_OPTIONS -Wl,--gc-sections)
+  if (UBXLIB_LTO)
+    list(APPEND UBXLIB_COMPILE_OPTIONS -flto)
+    list(APPEND UBXLIB_LINK_OPTIONS -flto)
+  endif()
+endif()
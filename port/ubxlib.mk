@@ -2,12 +2,46 @@
 # It is used for collecting source code files and include directories
 # that are selected based on UBXLIB_FEATURES. Check README.md for details.
 
+# Feature profiles: a profile is a named, declarative selection of
+# features, sub-features to exclude and build options; set
+# UBXLIB_PROFILE to one of the names below to apply it on top of
+# whatever is already in UBXLIB_FEATURES and UBXLIB_FEATURES_EXCLUDE.
+# full: everything
+UBXLIB_PROFILE_full_FEATURES = short_range cell gnss
+UBXLIB_PROFILE_full_EXCLUDE =
+UBXLIB_PROFILE_full_LTO =
+# minimal: the same module types without any of the optional
+# sub-features, with link-time optimisation
+UBXLIB_PROFILE_minimal_FEATURES = short_range cell gnss
+UBXLIB_PROFILE_minimal_EXCLUDE = cell_loc cell_fota cell_c2c ble_sps
+UBXLIB_PROFILE_minimal_LTO = 1
+
+ifneq ($(strip $(UBXLIB_PROFILE)),)
+ifeq ($(origin UBXLIB_PROFILE_$(UBXLIB_PROFILE)_FEATURES),undefined)
+$(error Unknown UBXLIB_PROFILE: $(UBXLIB_PROFILE))
+endif
+override UBXLIB_FEATURES += $(UBXLIB_PROFILE_$(UBXLIB_PROFILE)_FEATURES)
+override UBXLIB_FEATURES_EXCLUDE += $(UBXLIB_PROFILE_$(UBXLIB_PROFILE)_EXCLUDE)
+UBXLIB_LTO ?= $(UBXLIB_PROFILE_$(UBXLIB_PROFILE)_LTO)
+endif
+
+# Sub-features are enabled along with their parent feature
+# unless they are listed in UBXLIB_FEATURES_EXCLUDE
+UBXLIB_SUB_FEATURES_cell = cell_loc cell_fota cell_c2c
+UBXLIB_SUB_FEATURES_short_range = ble_sps
+UBXLIB_FEATURES_IMPLIED := \
+	$(filter-out $(UBXLIB_FEATURES_EXCLUDE) $(UBXLIB_FEATURES), \
+		$(foreach parent,$(filter cell short_range,$(UBXLIB_FEATURES)), \
+			$(UBXLIB_SUB_FEATURES_$(parent))))
+override UBXLIB_FEATURES += $(UBXLIB_FEATURES_IMPLIED)
+
 # For each entry in UBXLIB_MODULE_DIRS the following will be done:
 # * Append /api and add result to UBXLIB_INC
 # * Append /src and add result to UBXLIB_SRC_DIRS
 # * Append /test and add result to UBXLIB_TEST_DIRS
 UBXLIB_MODULE_DIRS = \
 	${UBXLIB_BASE}/common/at_client \
+	${UBXLIB_BASE}/common/cmux \
 	${UBXLIB_BASE}/common/error \
 	${UBXLIB_BASE}/common/assert \
 	${UBXLIB_BASE}/common/location \
@@ -23,7 +57,12 @@ UBXLIB_MODULE_DIRS = \
 UBXLIB_SRC_DIRS += \
 	${UBXLIB_BASE}/port/platform/common/event_queue \
 	${UBXLIB_BASE}/port/platform/common/mutex_debug \
-	${UBXLIB_BASE}/port/platform/common/log_ram
+	${UBXLIB_BASE}/port/platform/common/log_ram \
+	${UBXLIB_BASE}/port/platform/common/heap \
+	${UBXLIB_BASE}/port/platform/common/uart \
+	${UBXLIB_BASE}/port/platform/common/i2c \
+	${UBXLIB_BASE}/port/platform/common/profile \
+	${UBXLIB_BASE}/port/platform/common/task_stack
 
 
 # Additional include directories
@@ -40,6 +79,7 @@ UBXLIB_PRIVATE_INC += \
 
 # Device and network require special care since they contain stub & optional files
 UBXLIB_SRC += ${UBXLIB_BASE}/common/network/src/u_network.c
+UBXLIB_SRC += ${UBXLIB_BASE}/common/network/src/u_network_bearer.c
 UBXLIB_SRC += ${UBXLIB_BASE}/common/network/src/u_network_shared.c
 UBXLIB_INC += ${UBXLIB_BASE}/common/network/api
 UBXLIB_PRIVATE_INC += ${UBXLIB_BASE}/common/network/src
@@ -85,6 +125,38 @@ UBXLIB_INC += ${UBXLIB_BASE}/common/lib_common/api
 UBXLIB_SRC_DIRS += ${UBXLIB_BASE}/common/lib_common/src
 endif
 
+# Excluded sub-features: their source and test files are removed
+# below, replacing them with a stub or a compile definition where
+# the rest of ubxlib calls into them
+ifneq ($(filter cell,$(UBXLIB_FEATURES)),)
+ifeq ($(filter cell_loc,$(UBXLIB_FEATURES)),)
+UBXLIB_EXCLUDED_SRC += \
+	${UBXLIB_BASE}/cell/src/u_cell_loc.c \
+	${UBXLIB_BASE}/cell/test/u_cell_loc_test.c
+UBXLIB_SRC += ${UBXLIB_BASE}/cell/src/u_cell_loc_stub.c
+endif
+ifeq ($(filter cell_fota,$(UBXLIB_FEATURES)),)
+UBXLIB_EXCLUDED_SRC += \
+	${UBXLIB_BASE}/cell/src/u_cell_fota.c \
+	${UBXLIB_BASE}/cell/test/u_cell_fota_test.c
+endif
+ifeq ($(filter cell_c2c,$(UBXLIB_FEATURES)),)
+UBXLIB_EXCLUDED_SRC += \
+	${UBXLIB_BASE}/cell/src/u_cell_sec_c2c.c \
+	${UBXLIB_BASE}/cell/test/u_cell_sec_c2c_test.c \
+	${UBXLIB_BASE}/example/security/c2c/c2c_main.c
+UBXLIB_CFLAGS += -DU_CFG_CELL_DISABLE_C2C
+endif
+endif
+ifneq ($(filter short_range,$(UBXLIB_FEATURES)),)
+ifeq ($(filter ble_sps,$(UBXLIB_FEATURES)),)
+UBXLIB_EXCLUDED_SRC += \
+	${UBXLIB_BASE}/ble/src/u_ble_sps_extmod.c \
+	${UBXLIB_BASE}/ble/src/u_ble_sps_intmod.c \
+	${UBXLIB_BASE}/ble/test/u_ble_sps_test.c
+UBXLIB_SRC += ${UBXLIB_BASE}/ble/src/u_ble_sps_stub.c
+endif
+endif
 
 # Extra test directories
 UBXLIB_TEST_DIRS += \
@@ -117,15 +189,26 @@ UBXLIB_SRC_DIRS += $(wildcard $(addsuffix /src, $(UBXLIB_MODULE_DIRS)))
 UBXLIB_PRIVATE_INC += $(wildcard $(addsuffix /src, $(UBXLIB_MODULE_DIRS)))
 UBXLIB_TEST_DIRS += $(wildcard $(addsuffix /test/, $(UBXLIB_MODULE_DIRS)))
 
-# Get all .c files in each UBXLIB_SRC_DIRS and add these to UBXLIB_SRC
+# Get all .c files in each UBXLIB_SRC_DIRS and add these to UBXLIB_SRC,
+# leaving out stubs, which are only added explicitly, for excluded features
 UBXLIB_SRC += \
 	$(foreach dir, $(UBXLIB_SRC_DIRS), \
-		$(sort $(wildcard $(dir)/*.c)) \
+		$(filter-out %_stub.c $(UBXLIB_EXCLUDED_SRC), $(sort $(wildcard $(dir)/*.c))) \
 	)
 
 # Get all .c files in each UBXLIB_TEST_DIRS and add these to UBXLIB_TEST_SRC
 UBXLIB_TEST_SRC += \
 	$(foreach dir, $(UBXLIB_TEST_DIRS), \
-		$(sort $(wildcard $(dir)/*.c)) \
+		$(filter-out $(UBXLIB_EXCLUDED_SRC), $(subst //,/,$(sort $(wildcard $(dir)/*.c)))) \
 	)
 UBXLIB_TEST_INC += $(UBXLIB_TEST_DIRS)
+
+# Build options: each function and data item in its own section so
+# that the linker can discard whatever the application does not use
+# and, if UBXLIB_LTO is set, link-time optimisation
+UBXLIB_CFLAGS += -ffunction-sections -fdata-sections
+UBXLIB_LDFLAGS += -Wl,--gc-sections
+ifneq ($(strip $(UBXLIB_LTO)),)
+UBXLIB_CFLAGS += -flto
+UBXLIB_LDFLAGS += -flto
+endif
@@ -76,10 +76,13 @@
 #include <u_base64.h>
 #include <u_hex_bin_convert.h>
 #include <u_mempool.h>
+#include <u_metrics.h>
+#include <u_lzss.h>
 #include <u_ringbuffer.h>
 #include <u_time.h>
 #include <u_debug_utils.h>
 #include <u_at_client.h>
+#include <u_cmux.h>
 #include <u_security.h>
 #include <u_security_credential.h>
 #include <u_security_tls.h>
@@ -89,6 +92,7 @@
 #include <u_mqtt_common.h>
 #include <u_mqtt_client.h>
 #include <u_location.h>
+#include <u_geofence.h>
 #include <u_ubx_protocol.h>
 #include <u_spartn.h>
 #include <u_spartn_crc.h>
@@ -115,6 +119,8 @@
 #include <u_cell_sec_tls.h>
 #include <u_cell_sock.h>
 #include <u_cell_fota.h>
+#include <u_cell_http.h>
+#include <u_cell_mux.h>
 #include <u_gnss_type.h>
 #include <u_gnss.h>
 #include <u_gnss_cfg_val_key.h>
@@ -124,6 +130,11 @@
 #include <u_gnss_pwr.h>
 #include <u_gnss_msg.h>
 #include <u_gnss_util.h>
+#include <u_gnss_correction.h>
+#include <u_gnss_mga.h>
+#include <u_gnss_log.h>
+#include <u_gnss_time_sync.h>
+#include <u_gnss_nmea.h>
 #include <u_wifi.h>
 #include <u_wifi_cfg.h>
 #include <u_wifi_mqtt.h>
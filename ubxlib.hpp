@@ -0,0 +1,780 @@
+/*
+ * Copyright 2019-2022 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \addtogroup ubxlib Headers
+ *  @{
+ */
+
+/** @file
+ * @brief A header-only C++17 layer over the public ubxlib C APIs of
+ * ubxlib.h: RAII, move-only owners of a device, a socket, a GNSS
+ * message reader and an MQTT client, buffer arguments passed as a
+ * Span (pointer plus length, the C++20 std::span in miniature), and
+ * callback adapters that hand a reference to your callable straight
+ * to the C API as its callback parameter, so nothing is ever
+ * allocated.  Every member function is inline and is no more than a
+ * call into the C API, returning the C API's int32_t error code or
+ * length unchanged: no exceptions are thrown and RTTI is not
+ * required.
+ *
+ * A callable passed to one of the onXxx()/start() functions is held
+ * by reference: it must outlive the owning object, or the callback
+ * must be stopped, and it is called in the context of the ubxlib
+ * task that the C API documents for that callback.
+ */
+
+#ifndef _U_UBXLIB_HPP_
+#define _U_UBXLIB_HPP_
+
+#if !defined(__cplusplus) || (__cplusplus < 201703L)
+# error "ubxlib.hpp requires C++17 or later; from C please include ubxlib.h."
+#endif
+
+#include <ubxlib.h>
+
+#include <type_traits> // std::enable_if_t, std::remove_pointer_t, etc.
+#include <utility>     // std::exchange()
+
+namespace ubxlib
+{
+
+/* ----------------------------------------------------------------
+ * SPAN
+ * -------------------------------------------------------------- */
+
+/** A non-owning view of a contiguous run of T: a pointer and a
+ * length, nothing more.  Constructs implicitly from an array or from
+ * anything with data() and size() members (std::array, std::vector,
+ * std::string, a std::span, etc.) so that these can be passed
+ * directly wherever a Span is wanted.
+ */
+template <class T>
+class Span
+{
+public:
+    constexpr Span() noexcept : mpData(nullptr), mSize(0) {}
+
+    constexpr Span(T *pData, size_t size) noexcept : mpData(pData), mSize(size) {}
+
+    template <size_t N>
+    constexpr Span(T (&array)[N]) noexcept : mpData(array), mSize(N) {}
+
+    template < class C,
+               class = std::enable_if_t <
+                   std::is_convertible_v < std::remove_pointer_t<decltype(std::declval<C &>().data())>
+                   (*)[], T(*)[] >>>
+    constexpr Span(C &container) noexcept : mpData(container.data()),
+        mSize(container.size()) {}
+
+    /** A Span of T is a Span of const T.
+     */
+    template < class U,
+               class = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+    constexpr Span(const Span<U> &other) noexcept : mpData(other.data()),
+        mSize(other.size()) {}
+
+    constexpr T *data() const noexcept
+    {
+        return mpData;
+    }
+    constexpr size_t size() const noexcept
+    {
+        return mSize;
+    }
+    constexpr size_t sizeBytes() const noexcept
+    {
+        return mSize * sizeof(T);
+    }
+    constexpr bool empty() const noexcept
+    {
+        return mSize == 0;
+    }
+    constexpr T *begin() const noexcept
+    {
+        return mpData;
+    }
+    constexpr T *end() const noexcept
+    {
+        return mpData + mSize;
+    }
+    constexpr T &operator[](size_t index) const noexcept
+    {
+        return mpData[index];
+    }
+
+    /** The first count elements, or all of them if there are fewer.
+     */
+    constexpr Span first(size_t count) const noexcept
+    {
+        return Span(mpData, (count < mSize) ? count : mSize);
+    }
+
+    /** The elements from offset onwards, at most count of them;
+     * empty if offset is beyond the end.
+     */
+    constexpr Span subspan(size_t offset, size_t count = SIZE_MAX) const noexcept
+    {
+        if (offset > mSize) {
+            offset = mSize;
+        }
+        return Span(mpData + offset, (count < mSize - offset) ? count : mSize - offset);
+    }
+
+private:
+    T *mpData;
+    size_t mSize;
+};
+
+template <class T, size_t N>
+Span(T (&)[N]) -> Span<T>;
+
+template <class C>
+Span(C &) -> Span<std::remove_pointer_t<decltype(std::declval<C &>().data())>>;
+
+/** Make a Span of whatever is passed (an array, a container, a Span),
+ * checking that its elements are bytes (char, uint8_t, std::byte).
+ * A string literal becomes a Span including its terminator: pass a
+ * std::string_view to leave that out.
+ */
+template <class C>
+constexpr auto byteSpan(C &bytes) noexcept
+{
+    Span span(bytes);
+    static_assert(sizeof(*span.data()) == 1, "ubxlib buffers must be of bytes");
+    return span;
+}
+
+/* ----------------------------------------------------------------
+ * DEVICE
+ * -------------------------------------------------------------- */
+
+/** The owner of an open device: uDeviceClose() is called, without
+ * powering the device off, when a Device that is open is destroyed
+ * or assigned to; call close(true) yourself to power it off.
+ * uDeviceInit() must have been called.
+ */
+class Device
+{
+public:
+    Device() noexcept = default;
+
+    /** Take ownership of a handle returned by uDeviceOpen().
+     */
+    explicit Device(uDeviceHandle_t devHandle) noexcept : mDevHandle(devHandle) {}
+
+    Device(const Device &) = delete;
+    Device &operator=(const Device &) = delete;
+
+    Device(Device &&other) noexcept : mDevHandle(other.release()) {}
+
+    Device &operator=(Device &&other) noexcept
+    {
+        if (this != &other) {
+            close();
+            mDevHandle = other.release();
+        }
+        return *this;
+    }
+
+    ~Device()
+    {
+        close();
+    }
+
+    /** Open a device, closing any this object already owns; see
+     * uDeviceOpen().  If that close fails its error code is returned
+     * and nothing is opened.
+     */
+    int32_t open(const uDeviceCfg_t &cfg) noexcept
+    {
+        int32_t errorCode = close();
+        if (errorCode == 0) {
+            errorCode = uDeviceOpen(&cfg, &mDevHandle);
+        }
+        return errorCode;
+    }
+
+    /** Close the device, if open; see uDeviceClose().  If the close
+     * fails the handle is kept, so that it may be tried again.
+     */
+    int32_t close(bool powerOff = false) noexcept
+    {
+        int32_t errorCode = 0;
+        if (mDevHandle != nullptr) {
+            errorCode = uDeviceClose(mDevHandle, powerOff);
+            if (errorCode == 0) {
+                mDevHandle = nullptr;
+            }
+        }
+        return errorCode;
+    }
+
+    /** Bring up a network on the device; see uNetworkInterfaceUp().
+     */
+    int32_t networkUp(uNetworkType_t netType, const void *pCfg) const noexcept
+    {
+        return uNetworkInterfaceUp(mDevHandle, netType, pCfg);
+    }
+
+    /** Take a network on the device down; see uNetworkInterfaceDown().
+     */
+    int32_t networkDown(uNetworkType_t netType) const noexcept
+    {
+        return uNetworkInterfaceDown(mDevHandle, netType);
+    }
+
+    /** Give up ownership of the handle without closing it.
+     */
+    uDeviceHandle_t release() noexcept
+    {
+        return std::exchange(mDevHandle, nullptr);
+    }
+
+    uDeviceHandle_t handle() const noexcept
+    {
+        return mDevHandle;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return mDevHandle != nullptr;
+    }
+
+private:
+    uDeviceHandle_t mDevHandle = nullptr;
+};
+
+/* ----------------------------------------------------------------
+ * SOCKET
+ * -------------------------------------------------------------- */
+
+/** The owner of a socket: uSockClose() is called when a Socket that
+ * is open is destroyed or assigned to.  The data functions take
+ * anything that byteSpan() takes.
+ */
+class Socket
+{
+public:
+    Socket() noexcept = default;
+
+    /** Take ownership of a descriptor returned by uSockCreate().
+     */
+    explicit Socket(uSockDescriptor_t descriptor) noexcept : mDescriptor(descriptor) {}
+
+    Socket(const Socket &) = delete;
+    Socket &operator=(const Socket &) = delete;
+
+    Socket(Socket &&other) noexcept : mDescriptor(other.release()) {}
+
+    Socket &operator=(Socket &&other) noexcept
+    {
+        if (this != &other) {
+            close();
+            mDescriptor = other.release();
+        }
+        return *this;
+    }
+
+    ~Socket()
+    {
+        close();
+    }
+
+    /** Create a socket, closing any this object already owns; see
+     * uSockCreate().  If that close fails its error code is returned
+     * and nothing is created.
+     *
+     * @return zero on success else negative error code.
+     */
+    int32_t create(uDeviceHandle_t devHandle, uSockType_t type,
+                   uSockProtocol_t protocol) noexcept
+    {
+        int32_t errorCode = close();
+        if (errorCode == 0) {
+            errorCode = uSockCreate(devHandle, type, protocol);
+            if (errorCode >= 0) {
+                mDescriptor = errorCode;
+                errorCode = 0;
+            }
+        }
+        return errorCode;
+    }
+
+    int32_t connect(const uSockAddress_t &remoteAddress) const noexcept
+    {
+        return uSockConnect(mDescriptor, &remoteAddress);
+    }
+
+    template <class C>
+    int32_t write(const C &data) const noexcept
+    {
+        auto span = byteSpan(data);
+        return uSockWrite(mDescriptor, span.data(), span.size());
+    }
+
+    template <class C>
+    int32_t read(C &&buffer) const noexcept
+    {
+        auto span = byteSpan(buffer);
+        return uSockRead(mDescriptor, span.data(), span.size());
+    }
+
+    template <class C>
+    int32_t sendTo(const uSockAddress_t *pRemoteAddress, const C &data) const noexcept
+    {
+        auto span = byteSpan(data);
+        return uSockSendTo(mDescriptor, pRemoteAddress, span.data(), span.size());
+    }
+
+    template <class C>
+    int32_t receiveFrom(uSockAddress_t *pRemoteAddress, C &&buffer) const noexcept
+    {
+        auto span = byteSpan(buffer);
+        return uSockReceiveFrom(mDescriptor, pRemoteAddress, span.data(), span.size());
+    }
+
+    int32_t flush() const noexcept
+    {
+        return uSockFlush(mDescriptor);
+    }
+
+    int32_t shutdown(uSockShutdown_t how) const noexcept
+    {
+        return uSockShutdown(mDescriptor, how);
+    }
+
+    void setBlocking(bool isBlocking) const noexcept
+    {
+        uSockBlockingSet(mDescriptor, isBlocking);
+    }
+
+    /** Call callable() when data arrives; see
+     * uSockRegisterCallbackData() for the context it is called in.
+     * callable is held by reference and must outlive the socket.
+     */
+    template <class F>
+    void onData(F &callable) const noexcept
+    {
+        uSockRegisterCallbackData(mDescriptor, thunk<F>, &callable);
+    }
+
+    /** Call callable() when the socket is closed; see
+     * uSockRegisterCallbackClosed().  callable is held by reference
+     * and must outlive the socket.
+     */
+    template <class F>
+    void onClosed(F &callable) const noexcept
+    {
+        uSockRegisterCallbackClosed(mDescriptor, thunk<F>, &callable);
+    }
+
+    /** Close the socket, if open; see uSockClose().  If the close
+     * fails the descriptor is kept, so that it may be tried again.
+     */
+    int32_t close() noexcept
+    {
+        int32_t errorCode = 0;
+        if (mDescriptor >= 0) {
+            errorCode = uSockClose(mDescriptor);
+            if (errorCode == 0) {
+                mDescriptor = -1;
+            }
+        }
+        return errorCode;
+    }
+
+    /** Give up ownership of the descriptor without closing it.
+     */
+    uSockDescriptor_t release() noexcept
+    {
+        return std::exchange(mDescriptor, -1);
+    }
+
+    uSockDescriptor_t descriptor() const noexcept
+    {
+        return mDescriptor;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return mDescriptor >= 0;
+    }
+
+private:
+    template <class F>
+    static void thunk(void *pCallable)
+    {
+        (*static_cast<F *>(pCallable))();
+    }
+
+    uSockDescriptor_t mDescriptor = -1;
+};
+
+/* ----------------------------------------------------------------
+ * GNSS MESSAGE READER
+ * -------------------------------------------------------------- */
+
+/** What the callable given to GnssReader::start() is passed: the
+ * message that has arrived, valid only for the duration of the call.
+ */
+class GnssMessage
+{
+public:
+    GnssMessage(uDeviceHandle_t gnssHandle, const uGnssMessageId_t *pMessageId,
+                int32_t errorCodeOrLength) noexcept :
+        mGnssHandle(gnssHandle), mpMessageId(pMessageId),
+        mErrorCodeOrLength(errorCodeOrLength) {}
+
+    const uGnssMessageId_t &id() const noexcept
+    {
+        return *mpMessageId;
+    }
+
+    /** The length of the message, else negative error code, e.g.
+     * #U_GNSS_ERROR_NACK.
+     */
+    int32_t errorCodeOrLength() const noexcept
+    {
+        return mErrorCodeOrLength;
+    }
+
+    /** Copy the message into buffer, leaving it for other readers;
+     * see uGnssMsgReceiveCallbackRead().
+     */
+    template <class C>
+    int32_t read(C &&buffer) const noexcept
+    {
+        auto span = byteSpan(buffer);
+        return uGnssMsgReceiveCallbackRead(mGnssHandle,
+                                           reinterpret_cast<char *>(span.data()),
+                                           span.size());
+    }
+
+    /** Move the message into buffer, removing it for other readers;
+     * see uGnssMsgReceiveCallbackExtract().
+     */
+    template <class C>
+    int32_t extract(C &&buffer) const noexcept
+    {
+        auto span = byteSpan(buffer);
+        return uGnssMsgReceiveCallbackExtract(mGnssHandle,
+                                              reinterpret_cast<char *>(span.data()),
+                                              span.size());
+    }
+
+    /** The message where it sits in the ring buffer, no copy; see
+     * uGnssMsgReceiveCallbackView(): empty on error and possibly
+     * shorter than the message if it wraps.
+     */
+    Span<const char> view() const noexcept
+    {
+        const char *pBuffer = nullptr;
+        int32_t length = uGnssMsgReceiveCallbackView(mGnssHandle, &pBuffer);
+        return (length > 0) ? Span<const char>(pBuffer, length) : Span<const char>();
+    }
+
+    /** See uGnssMsgReceiveCallbackGetArrivalTime().
+     */
+    int32_t arrivalTimeMs(int32_t &timeMs) const noexcept
+    {
+        return uGnssMsgReceiveCallbackGetArrivalTime(mGnssHandle, &timeMs);
+    }
+
+    uDeviceHandle_t gnssHandle() const noexcept
+    {
+        return mGnssHandle;
+    }
+
+private:
+    uDeviceHandle_t mGnssHandle;
+    const uGnssMessageId_t *mpMessageId;
+    int32_t mErrorCodeOrLength;
+};
+
+/** The owner of an asynchronous GNSS message reader, i.e. of a
+ * uGnssMsgReceiveStart() handle: uGnssMsgReceiveStop() is called
+ * when a GnssReader that is running is destroyed or assigned to.
+ */
+class GnssReader
+{
+public:
+    GnssReader() noexcept = default;
+
+    /** Take ownership of a handle returned by uGnssMsgReceiveStart().
+     */
+    GnssReader(uDeviceHandle_t gnssHandle, int32_t asyncHandle) noexcept :
+        mGnssHandle(gnssHandle), mAsyncHandle(asyncHandle) {}
+
+    GnssReader(const GnssReader &) = delete;
+    GnssReader &operator=(const GnssReader &) = delete;
+
+    GnssReader(GnssReader &&other) noexcept :
+        mGnssHandle(std::exchange(other.mGnssHandle, nullptr)),
+        mAsyncHandle(std::exchange(other.mAsyncHandle, -1)) {}
+
+    GnssReader &operator=(GnssReader &&other) noexcept
+    {
+        if (this != &other) {
+            stop();
+            mGnssHandle = std::exchange(other.mGnssHandle, nullptr);
+            mAsyncHandle = std::exchange(other.mAsyncHandle, -1);
+        }
+        return *this;
+    }
+
+    ~GnssReader()
+    {
+        stop();
+    }
+
+    /** Start calling callable(const GnssMessage &) for each message
+     * matching messageId, stopping any reader this object already
+     * owns; see uGnssMsgReceiveStart().  callable is held by
+     * reference and must outlive the reader.  If stopping the
+     * existing reader fails its error code is returned and nothing
+     * is started.
+     *
+     * @return zero on success else negative error code.
+     */
+    template <class F>
+    int32_t start(uDeviceHandle_t gnssHandle, const uGnssMessageId_t &messageId,
+                  F &callable) noexcept
+    {
+        int32_t errorCode = stop();
+        if (errorCode == 0) {
+            errorCode = uGnssMsgReceiveStart(gnssHandle, &messageId, thunk<F>, &callable);
+            if (errorCode >= 0) {
+                mGnssHandle = gnssHandle;
+                mAsyncHandle = errorCode;
+                errorCode = 0;
+            }
+        }
+        return errorCode;
+    }
+
+    /** Stop the reader, if running; see uGnssMsgReceiveStop().  If
+     * the stop fails the handle is kept, so that it may be tried
+     * again.
+     */
+    int32_t stop() noexcept
+    {
+        int32_t errorCode = 0;
+        if (mAsyncHandle >= 0) {
+            errorCode = uGnssMsgReceiveStop(mGnssHandle, mAsyncHandle);
+            if (errorCode == 0) {
+                mGnssHandle = nullptr;
+                mAsyncHandle = -1;
+            }
+        }
+        return errorCode;
+    }
+
+    /** Give up ownership of the handle without stopping the reader.
+     */
+    int32_t release() noexcept
+    {
+        mGnssHandle = nullptr;
+        return std::exchange(mAsyncHandle, -1);
+    }
+
+    uDeviceHandle_t gnssHandle() const noexcept
+    {
+        return mGnssHandle;
+    }
+
+    int32_t asyncHandle() const noexcept
+    {
+        return mAsyncHandle;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return mAsyncHandle >= 0;
+    }
+
+private:
+    template <class F>
+    static void thunk(uDeviceHandle_t gnssHandle, const uGnssMessageId_t *pMessageId,
+                      int32_t errorCodeOrLength, void *pCallable)
+    {
+        (*static_cast<F *>(pCallable))(GnssMessage(gnssHandle, pMessageId,
+                                                   errorCodeOrLength));
+    }
+
+    uDeviceHandle_t mGnssHandle = nullptr;
+    int32_t mAsyncHandle = -1;
+};
+
+/* ----------------------------------------------------------------
+ * MQTT CLIENT
+ * -------------------------------------------------------------- */
+
+/** The owner of an MQTT client context: uMqttClientClose() is called
+ * when an MqttClient that is open is destroyed or assigned to.
+ */
+class MqttClient
+{
+public:
+    MqttClient() noexcept = default;
+
+    MqttClient(const MqttClient &) = delete;
+    MqttClient &operator=(const MqttClient &) = delete;
+
+    MqttClient(MqttClient &&other) noexcept : mpContext(other.release()) {}
+
+    MqttClient &operator=(MqttClient &&other) noexcept
+    {
+        if (this != &other) {
+            close();
+            mpContext = other.release();
+        }
+        return *this;
+    }
+
+    ~MqttClient()
+    {
+        close();
+    }
+
+    /** Open an MQTT client, closing any this object already owns;
+     * see pUMqttClientOpen().
+     *
+     * @return zero on success else negative error code.
+     */
+    int32_t open(uDeviceHandle_t devHandle,
+                 const uSecurityTlsSettings_t *pSecurityTlsSettings = nullptr) noexcept
+    {
+        close();
+        mpContext = pUMqttClientOpen(devHandle, pSecurityTlsSettings);
+        return (mpContext != nullptr) ? 0 : uMqttClientOpenResetLastError();
+    }
+
+    int32_t connect(const uMqttClientConnection_t &connection) noexcept
+    {
+        return uMqttClientConnect(mpContext, &connection);
+    }
+
+    int32_t disconnect() const noexcept
+    {
+        return uMqttClientDisconnect(mpContext);
+    }
+
+    bool isConnected() const noexcept
+    {
+        return uMqttClientIsConnected(mpContext);
+    }
+
+    template <class C>
+    int32_t publish(const char *pTopicNameStr, const C &message,
+                    uMqttQos_t qos = U_MQTT_QOS_AT_MOST_ONCE,
+                    bool retain = false) noexcept
+    {
+        auto span = byteSpan(message);
+        return uMqttClientPublish(mpContext, pTopicNameStr,
+                                  reinterpret_cast<const char *>(span.data()),
+                                  span.size(), qos, retain);
+    }
+
+    int32_t subscribe(const char *pTopicFilterStr,
+                      uMqttQos_t maxQos = U_MQTT_QOS_AT_MOST_ONCE) const noexcept
+    {
+        return uMqttClientSubscribe(mpContext, pTopicFilterStr, maxQos);
+    }
+
+    int32_t unsubscribe(const char *pTopicFilterStr) const noexcept
+    {
+        return uMqttClientUnsubscribe(mpContext, pTopicFilterStr);
+    }
+
+    int32_t getUnread() const noexcept
+    {
+        return uMqttClientGetUnread(mpContext);
+    }
+
+    /** Read a message; see uMqttClientMessageRead().
+     *
+     * @return the number of bytes written to message, else negative
+     *         error code.
+     */
+    template <class C>
+    int32_t read(Span<char> topicName, C &&message,
+                 uMqttQos_t *pQos = nullptr) noexcept
+    {
+        auto span = byteSpan(message);
+        size_t messageSizeBytes = span.size();
+        int32_t errorCodeOrLength = uMqttClientMessageRead(mpContext, topicName.data(),
+                                                           topicName.size(),
+                                                           reinterpret_cast<char *>(span.data()),
+                                                           &messageSizeBytes, pQos);
+        if (errorCodeOrLength == 0) {
+            errorCodeOrLength = (int32_t) messageSizeBytes;
+        }
+        return errorCodeOrLength;
+    }
+
+    /** Call callable(int32_t numUnread) when messages arrive; see
+     * uMqttClientSetMessageCallback().  callable is held by reference
+     * and must outlive the client.
+     */
+    template <class F>
+    int32_t onMessage(F &callable) noexcept
+    {
+        return uMqttClientSetMessageCallback(mpContext, thunk<F>, &callable);
+    }
+
+    /** Close the client, if open; see uMqttClientClose().
+     */
+    void close() noexcept
+    {
+        if (mpContext != nullptr) {
+            uMqttClientClose(std::exchange(mpContext, nullptr));
+        }
+    }
+
+    /** Give up ownership of the context without closing it.
+     */
+    uMqttClientContext_t *release() noexcept
+    {
+        return std::exchange(mpContext, nullptr);
+    }
+
+    uMqttClientContext_t *context() const noexcept
+    {
+        return mpContext;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return mpContext != nullptr;
+    }
+
+private:
+    template <class F>
+    static void thunk(int32_t numUnread, void *pCallable)
+    {
+        (*static_cast<F *>(pCallable))(numUnread);
+    }
+
+    uMqttClientContext_t *mpContext = nullptr;
+};
+
+} // namespace ubxlib
+
+#endif // _U_UBXLIB_HPP_
+
+/** @}*/
+
+// End of file
@@ -41,6 +41,7 @@ extern "C" {
 
 #define U_WIFI_BSSID_SIZE 6        /**< binary BSSID size. */
 #define U_WIFI_SSID_SIZE (32 + 1)  /**< null-terminated SSID string size. */
+#define U_WIFI_IPV4_STR_SIZE (15 + 1) /**< null-terminated IPv4 address string size. */
 
 /** Wifi connection status codes used by #uWifiConnectionStatusCallback_t */
 #define U_WIFI_CON_STATUS_DISCONNECTED 0
@@ -125,6 +126,55 @@ typedef struct {
 typedef void (*uWifiScanResultCallback_t) (uDeviceHandle_t devHandle,
                                            uWifiScanResult_t *pResult);
 
+/** Filter for an asynchronous scan, see uWifiStationScanStart().
+ */
+typedef struct {
+    const char *pSsid; /**< the SSID to scan for, NULL for any SSID; the
+                            filtering is done by the module. */
+    int32_t channel;   /**< the channel to report results for, 0 for any
+                            channel; results on other channels are skipped
+                            before they are parsed further. */
+} uWifiScanFilter_t;
+
+/** What is remembered of a connection for a fast reconnect, see
+ * uWifiStationGetFastReconnect() and uWifiStationSetFastReconnect().
+ * This may be kept by the application, e.g. in RAM that survives
+ * sleep, and handed back after the module has been re-opened.
+ */
+typedef struct {
+    char ssid[U_WIFI_SSID_SIZE];        /**< null-terminated SSID string,
+                                             empty if nothing is known. */
+    uint8_t bssid[U_WIFI_BSSID_SIZE];   /**< BSSID of the AP in binary format. */
+    int32_t channel;                    /**< WiFi channel number. */
+    char ipV4Address[U_WIFI_IPV4_STR_SIZE];    /**< e.g. "192.168.1.23". */
+    char ipV4SubnetMask[U_WIFI_IPV4_STR_SIZE]; /**< e.g. "255.255.255.0". */
+    char ipV4Gateway[U_WIFI_IPV4_STR_SIZE];    /**< e.g. "192.168.1.1". */
+    char ipV4Dns[U_WIFI_IPV4_STR_SIZE];        /**< the primary DNS server. */
+} uWifiFastReconnect_t;
+
+/** Asynchronous scan result callback type, see uWifiStationScanStart().
+ *
+ * This callback will be called once for each entry found that passes
+ * the filter, as the entries arrive from the module, and then once
+ * more, with pResult set to NULL, when the scan has ended.
+ *
+ * @param devHandle              the handle of the wifi instance.
+ * @param[in] pResult            the scan result, NULL at the end of the
+ *                               scan; only valid for the duration of
+ *                               the callback.
+ * @param errorCode              zero unless pResult is NULL, in which
+ *                               case it is the outcome of the scan.
+ * @param[in] pCallbackParameter parameter pointer set when starting the scan.
+ * @return                       true to continue receiving results, false
+ *                               to stop, e.g. because the wanted access
+ *                               point has been found; ignored at the end
+ *                               of the scan.
+ */
+typedef bool (*uWifiScanAsyncCallback_t) (uDeviceHandle_t devHandle,
+                                          const uWifiScanResult_t *pResult,
+                                          int32_t errorCode,
+                                          void *pCallbackParameter);
+
 
 /** Connection status callback type.
  *
@@ -239,6 +289,96 @@ int32_t uWifiSetNetworkStatusCallback(uDeviceHandle_t devHandle,
 int32_t uWifiStationScan(uDeviceHandle_t devHandle, const char *pSsid,
                          uWifiScanResultCallback_t pCallback);
 
+/** Start a scan for SSIDs without blocking: the scan is run in the
+ * AT client callback task and the results are passed to pCallback
+ * as each one arrives from the module.  pCallback may return false to
+ * stop receiving results early, e.g. once the wanted access point has
+ * been found, or uWifiStationScanStop() may be called; the remaining
+ * lines of the scan are then skipped without being parsed.  Either way
+ * pCallback is called once more, with pResult NULL, at the end of the
+ * scan.  Only one asynchronous scan may be in progress per instance.
+ *
+ * Note that, while the scan is in progress, other asynchronous
+ * callbacks from the same AT client (e.g. those set with
+ * uWifiSetConnectionStatusCallback()) are held back and any other
+ * call into this API will block on the AT lock.
+ *
+ * @param devHandle              the handle of the wifi instance.
+ * @param[in] pFilter            the filter to apply to the results, may be
+ *                               NULL to report everything; need not be
+ *                               kept once this function has returned.
+ * @param[in] pCallback          callback for handling a scan result entry,
+ *                               cannot be NULL.
+ *                               IMPORTANT: except for the end of scan call
+ *                               the callback will be called while the AT
+ *                               lock is held hence you are not allowed to
+ *                               call other u-blox module APIs directly from
+ *                               it.
+ * @param[in] pCallbackParameter parameter included with the callback.
+ * @return                       zero if the scan has been started, else
+ *                               negative error code;
+ *                               #U_WIFI_ERROR_TEMPORARY_FAILURE if an
+ *                               asynchronous scan is already in progress.
+ */
+int32_t uWifiStationScanStart(uDeviceHandle_t devHandle,
+                              const uWifiScanFilter_t *pFilter,
+                              uWifiScanAsyncCallback_t pCallback,
+                              void *pCallbackParameter);
+
+/** Stop an asynchronous scan started with uWifiStationScanStart(): no
+ * more results are passed to the callback, which will be called with
+ * pResult NULL once the module has finished its scan.
+ *
+ * @param devHandle  the handle of the wifi instance.
+ * @return           zero on success, else negative error code;
+ *                   #U_WIFI_ERROR_NOT_FOUND if no asynchronous scan
+ *                   is in progress.
+ */
+int32_t uWifiStationScanStop(uDeviceHandle_t devHandle);
+
+/** Get what would be needed to reconnect quickly to the access point
+ * that the station is connected to.  If the station is connected,
+ * with an IPv4 address, this is read from the module, otherwise the
+ * most recent one read (here or by uWifiStationDisconnect() while fast
+ * reconnect is enabled) or set is returned.  Calling this once the
+ * network is up also confirms that a fast reconnect worked, see
+ * uWifiStationSetFastReconnect().
+ *
+ * @param devHandle            the handle of the wifi instance.
+ * @param[out] pFastReconnect  a place to put the information; cannot
+ *                             be NULL.
+ * @return                     zero on success, else negative error
+ *                             code; #U_WIFI_ERROR_NOT_FOUND if there
+ *                             is nothing to return.
+ */
+int32_t uWifiStationGetFastReconnect(uDeviceHandle_t devHandle,
+                                     uWifiFastReconnect_t *pFastReconnect);
+
+/** Enable or disable fast reconnect.  While fast reconnect is enabled,
+ * uWifiStationDisconnect() remembers the connection and the next
+ * uWifiStationConnect() to the same SSID gives the module the IPv4
+ * configuration of that connection as a static configuration, so that
+ * no DHCP exchange is needed.  If the network does not come up, i.e.
+ * uWifiStationGetFastReconnect() is not called successfully while
+ * connected, before the next uWifiStationConnect() then that call
+ * falls back to DHCP and forgets the remembered connection.
+ *
+ * Independently of this, uWifiStationConnect() always skips writing
+ * station configuration items that already hold the value required.
+ *
+ * @param devHandle              the handle of the wifi instance.
+ * @param[in] pFastReconnect     a connection to start from, e.g. one
+ *                               kept from uWifiStationGetFastReconnect()
+ *                               before the module was last powered down,
+ *                               or one with an empty SSID to start from
+ *                               nothing; use NULL to disable fast
+ *                               reconnect.  Need not be kept once this
+ *                               function has returned.
+ * @return                       zero on success, else negative error code.
+ */
+int32_t uWifiStationSetFastReconnect(uDeviceHandle_t devHandle,
+                                     const uWifiFastReconnect_t *pFastReconnect);
+
 #ifdef __cplusplus
 }
 #endif
@@ -44,6 +44,15 @@ extern "C" {
 #define U_WIFI_MQTT_WRITE_TIMEOUT_MS 500
 #endif
 
+#ifndef U_WIFI_MQTT_WRITE_TIMEOUT_PER_KBYTE_MS
+/** The time added to #U_WIFI_MQTT_WRITE_TIMEOUT_MS for each
+ * whole kilobyte of a message being published, so that a large
+ * message has time to be clocked out to the module at slow UART
+ * rates; the default is about right for 115200 bits/s.
+ */
+#define U_WIFI_MQTT_WRITE_TIMEOUT_PER_KBYTE_MS 100
+#endif
+
 /** The maximum number of connections that can be open at one time.
  */
 #define U_WIFI_MQTT_MAX_NUM_CONNECTIONS 7
@@ -194,6 +203,42 @@ int32_t uWifiMqttMessageRead(const uMqttClientContext_t *pContext,
                              size_t *pMessageSizeBytes,
                              uMqttQos_t *pQos);
 
+/** Read an MQTT message in chunks, so that a message of any
+ * length can be read without a buffer big enough to hold all
+ * of it; the message payload is passed to pCallback exactly as
+ * it was received, i.e. it may be binary.
+ *
+ * @param[in] pContext           client context returned by pUMqttClientOpen().
+ * @param[out] pTopicNameStr     pointer to the topic name string.
+ * @param topicNameSizeBytes     size of the topic name string.
+ * @param[in] pChunkBuffer       storage for one chunk of the message.
+ * @param chunkSizeBytes         the number of bytes of storage at
+ *                               pChunkBuffer.
+ * @param[in] pCallback          called with each chunk: the parameters
+ *                               are a pointer to the chunk, the length
+ *                               of the chunk, the offset of the chunk from
+ *                               the start of the message, the total length
+ *                               of the message and pCallbackParam; return
+ *                               false to discard the rest of the message.
+ *                               The short range lock is not held while
+ *                               this is called, so it does not hold up
+ *                               other sessions.
+ * @param[in] pCallbackParam     parameter passed to pCallback.
+ * @param pQos                   retrieve the QOS of the message.
+ * @return                       the number of bytes of message passed
+ *                               to pCallback or negative error code.
+ */
+int32_t uWifiMqttMessageReadChunked(const uMqttClientContext_t *pContext,
+                                    char *pTopicNameStr,
+                                    size_t topicNameSizeBytes,
+                                    char *pChunkBuffer,
+                                    size_t chunkSizeBytes,
+                                    bool (*pCallback) (const char *, size_t,
+                                                       size_t, size_t,
+                                                       void *),
+                                    void *pCallbackParam,
+                                    uMqttQos_t *pQos);
+
 /** Check if we are connected to the given MQTT session.
  *
  * @param[in] pContext            client context returned by pUMqttClientOpen().
@@ -329,6 +329,26 @@ int32_t uWifiSockSendTo(uDeviceHandle_t devHandle,
                         const void *pData,
                         size_t dataSizeBytes);
 
+/** As uWifiSockSendTo() but with the datagram gathered from
+ * several fragments, which are sent in a single EDM data frame.
+ *
+ * @param devHandle          the handle of the wifi instance.
+ * @param sockHandle         the handle of the socket.
+ * @param[in] pRemoteAddress the address of the server to
+ *                           send the datagram to plus port number.
+ *                           Cannot be NULL.
+ * @param[in] pIoVec         an array of numIoVec fragments; an entry
+ *                           with a length of zero is ignored.
+ * @param numIoVec           the number of entries at pIoVec.
+ * @return                   the number of bytes sent on
+ *                           success else negated value
+ *                           of U_SOCK_Exxx from u_sock_errno.h.
+ */
+int32_t uWifiSockSendTov(uDeviceHandle_t devHandle,
+                         int32_t sockHandle,
+                         const uSockAddress_t *pRemoteAddress,
+                         const uSockIoVec_t *pIoVec, size_t numIoVec);
+
 /** Receive a datagram from IP address.
  *
  *  NOTE: Short range modules have very limited UDP support and can
@@ -360,6 +380,39 @@ int32_t uWifiSockReceiveFrom(uDeviceHandle_t devHandle,
                              uSockAddress_t *pRemoteAddress,
                              void *pData, size_t dataSizeBytes);
 
+/** As uWifiSockReceiveFrom() but, rather than copying the datagram,
+ * lend the application the pbufs (buffers from the receive pool)
+ * that it arrived in, so that it can be read in place.  The data
+ * must be treated as read-only and the pbufs must be given back with
+ * uWifiSockBorrowRelease(), before the socket layer is deinitialised;
+ * until then they count against the receive quota of the socket's
+ * EDM channel, so hold on to them for no longer than necessary.
+ *
+ * @param devHandle           the handle of the wifi instance.
+ * @param sockHandle          the handle of the socket.
+ * @param[out] pRemoteAddress a place to put the address of the remote
+ *                            host from which the datagram was received;
+ *                            may be NULL.
+ * @param[out] pIoVec         an array of numIoVec entries, filled in
+ *                            with the pieces of the datagram in order;
+ *                            entries beyond the end of the datagram
+ *                            are given a length of zero.  If the
+ *                            datagram is in more than numIoVec pbufs
+ *                            the remainder is thrown away.
+ * @param numIoVec            the number of entries at pIoVec.
+ * @param[out] ppBorrowed     a place to put the handle of the borrowed
+ *                            data, to be passed to
+ *                            uWifiSockBorrowRelease(); set to NULL
+ *                            on failure.  Cannot be NULL.
+ * @return                    the number of bytes borrowed else negated
+ *                            value of U_SOCK_Exxx from u_sock_errno.h.
+ */
+int32_t uWifiSockReceiveFromBorrow(uDeviceHandle_t devHandle,
+                                   int32_t sockHandle,
+                                   uSockAddress_t *pRemoteAddress,
+                                   uSockIoVec_t *pIoVec, size_t numIoVec,
+                                   void **ppBorrowed);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: STREAM (TCP)
  * -------------------------------------------------------------- */
@@ -380,6 +433,43 @@ int32_t uWifiSockWrite(uDeviceHandle_t devHandle,
                        int32_t sockHandle,
                        const void *pData, size_t dataSizeBytes);
 
+/** As uWifiSockWrite() but with the data gathered from several
+ * fragments, which are sent in as few EDM data frames as the
+ * frame size, see uWifiSockSetFrameSize(), allows.
+ *
+ * @param devHandle     the handle of the wifi instance.
+ * @param sockHandle    the handle of the socket.
+ * @param[in] pIoVec    an array of numIoVec fragments; an entry
+ *                      with a length of zero is ignored.
+ * @param numIoVec      the number of entries at pIoVec.
+ * @return              the number of bytes sent on
+ *                      success else negated value
+ *                      of U_SOCK_Exxx from u_sock_errno.h.
+ */
+int32_t uWifiSockWritev(uDeviceHandle_t devHandle,
+                        int32_t sockHandle,
+                        const uSockIoVec_t *pIoVec, size_t numIoVec);
+
+/** Set the size of the largest EDM data frame that data written
+ * to a TCP socket is sent to the wifi module in; the module does
+ * the TCP segmentation itself so larger frames mean less overhead
+ * per byte.  The default is the largest EDM frame (4092 bytes):
+ * with module firmware that cannot accept frames that large, set
+ * a smaller size, e.g. the 635 byte IP MTU of the module.  May be
+ * called before or after uWifiSockConnect(); the size is applied
+ * to the connection when it is made.
+ *
+ * @param devHandle  the handle of the wifi instance.
+ * @param sockHandle the handle of the socket.
+ * @param sizeBytes  the frame size, at most 4092 bytes; zero for
+ *                   the default.
+ * @return           zero on success else negated value of
+ *                   U_SOCK_Exxx from u_sock_errno.h.
+ */
+int32_t uWifiSockSetFrameSize(uDeviceHandle_t devHandle,
+                              int32_t sockHandle,
+                              size_t sizeBytes);
+
 /** Receive bytes on a connected socket.
  *
  * @param devHandle     the handle of the wifi instance.
@@ -395,6 +485,44 @@ int32_t uWifiSockRead(uDeviceHandle_t devHandle,
                       int32_t sockHandle,
                       void *pData, size_t dataSizeBytes);
 
+/** As uWifiSockRead() but, rather than copying the received bytes,
+ * lend the application the pbufs (buffers from the receive pool)
+ * that they arrived in, so that they can be read in place, e.g. by
+ * a protocol parser.  The data must be treated as read-only and the
+ * pbufs must be given back with uWifiSockBorrowRelease(), before the
+ * socket layer is deinitialised; until then they count against the
+ * receive quota of the socket's EDM channel, so hold on to them for
+ * no longer than necessary.  Bytes that are borrowed are consumed:
+ * a subsequent uWifiSockRead() or uWifiSockReadBorrow() returns the
+ * bytes that follow them.
+ *
+ * @param devHandle       the handle of the wifi instance.
+ * @param sockHandle      the handle of the socket.
+ * @param[out] pIoVec     an array of numIoVec entries, filled in with
+ *                        the pieces of the received data in order, one
+ *                        per pbuf; entries beyond the end of the data
+ *                        are given a length of zero.
+ * @param numIoVec        the number of entries at pIoVec.
+ * @param[out] ppBorrowed a place to put the handle of the borrowed
+ *                        data, to be passed to uWifiSockBorrowRelease();
+ *                        set to NULL on failure.  Cannot be NULL.
+ * @return                the number of bytes borrowed else negated
+ *                        value of U_SOCK_Exxx from u_sock_errno.h.
+ */
+int32_t uWifiSockReadBorrow(uDeviceHandle_t devHandle,
+                            int32_t sockHandle,
+                            uSockIoVec_t *pIoVec, size_t numIoVec,
+                            void **ppBorrowed);
+
+/** Give back data borrowed with uWifiSockReadBorrow() or
+ * uWifiSockReceiveFromBorrow(), returning its pbufs to the pool;
+ * the pointers that were filled in must not be used afterwards.
+ *
+ * @param[in] pBorrowed the handle of the borrowed data; may be NULL,
+ *                      in which case this function does nothing.
+ */
+void uWifiSockBorrowRelease(void *pBorrowed);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: ASYNC
  * -------------------------------------------------------------- */
@@ -42,6 +42,7 @@
 #include "u_cfg_os_platform_specific.h"
 
 #include "u_at_client.h"
+#include "u_mempool.h"  // uMemPoolMalloc(), uMemPoolFree()
 #include "u_short_range_module_type.h"
 #include "u_short_range.h"
 #include "u_short_range_private.h"
@@ -74,6 +75,20 @@
 //lint -esym(750, LOG_TAG) Suppress LOG_TAG not referenced
 #define LOG_TAG "U_WIFI: "
 
+/** Size of a null-terminated WPA passphrase string.
+ */
+#define U_WIFI_PASSPHRASE_SIZE (63 + 1)
+
+/** AT+UWSC values of the IPv4 mode tag, 100.
+ */
+#define U_WIFI_IPV4_MODE_STATIC 1
+#define U_WIFI_IPV4_MODE_DHCP   2
+
+/** The first of the AT+UWSC/AT+UNSTAT tags for IPv4 address, subnet
+ * mask, gateway and primary DNS server, which are consecutive.
+ */
+#define U_WIFI_IPV4_TAG_FIRST 101
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -92,6 +107,44 @@ typedef struct {
     int32_t interfaceId;
 } uWifiworkEvent_t;
 
+/** The context of an asynchronous scan.
+ */
+typedef struct {
+    uDeviceHandle_t devHandle;
+    char ssid[U_WIFI_SSID_SIZE];
+    bool ssidSet;
+    int32_t channel;
+    uWifiScanAsyncCallback_t pCallback;
+    void *pCallbackParameter;
+    volatile bool stop;
+} uWifiScanContext_t;
+
+/** What was last written with AT+UWSC to station configuration 0:
+ * an integer of -1 or an empty string means not known.
+ */
+typedef struct {
+    int32_t ticksLastRestart; /**< the module restart this is valid for. */
+    int32_t activeOnStartup;
+    int32_t authentication;
+    int32_t ipV4Mode;
+    char ssid[U_WIFI_SSID_SIZE];
+    char passPhrase[U_WIFI_PASSPHRASE_SIZE];
+    char ipV4[4][U_WIFI_IPV4_STR_SIZE]; /**< indexed from U_WIFI_IPV4_TAG_FIRST. */
+} uWifiStaCfgCache_t;
+
+/** The station configuration cache and fast reconnect state of an
+ * instance, hung off pWifiStaCache.
+ */
+typedef struct {
+    uWifiStaCfgCache_t cfg;
+    bool fastReconnectEnabled;
+    bool fastReconnectUnconfirmed; /**< true if a static IPv4 configuration
+                                        from fastReconnect was used by
+                                        the last connect and the network
+                                        has not yet been seen to be up. */
+    uWifiFastReconnect_t fastReconnect;
+} uWifiStaCache_t;
+
 //lint -esym(749, uWifiStaCfgAction_t::STA_ACTION_RESET) Suppress not referenced
 //lint -esym(749, uWifiStaCfgAction_t::STA_ACTION_LOAD) Suppress not referenced
 //lint -esym(749, uWifiStaCfgAction_t::STA_ACTION_STORE) Suppress not referenced
@@ -157,6 +210,74 @@ static int32_t writeWifiStaCfgStr(uAtClientHandle_t atHandle,
     return uAtClientUnlock(atHandle);
 }
 
+/** Helper function to get the station cache of an instance, allocating
+ * it if required; the configuration part is forgotten if the module
+ * has restarted since it was written.  May return NULL. */
+static uWifiStaCache_t *pGetStaCache(uShortRangePrivateInstance_t *pInstance)
+{
+    uWifiStaCache_t *pCache = (uWifiStaCache_t *) pInstance->pWifiStaCache;
+
+    if (pCache == NULL) {
+        pCache = (uWifiStaCache_t *) malloc(sizeof(*pCache));
+        if (pCache != NULL) {
+            memset(pCache, 0, sizeof(*pCache));
+            // Make sure the configuration is reset below
+            pCache->cfg.ticksLastRestart = pInstance->ticksLastRestart - 1;
+            pInstance->pWifiStaCache = pCache;
+        }
+    }
+    if ((pCache != NULL) &&
+        (pCache->cfg.ticksLastRestart != pInstance->ticksLastRestart)) {
+        memset(&(pCache->cfg), 0, sizeof(pCache->cfg));
+        pCache->cfg.ticksLastRestart = pInstance->ticksLastRestart;
+        pCache->cfg.activeOnStartup = -1;
+        pCache->cfg.authentication = -1;
+        pCache->cfg.ipV4Mode = -1;
+    }
+
+    return pCache;
+}
+
+/** Helper function for writing a Wifi station config integer value
+ * only if it differs from *pCached; pCached may be NULL */
+static int32_t writeWifiStaCfgIntCached(uAtClientHandle_t atHandle,
+                                        int32_t tag, int32_t value,
+                                        int32_t *pCached)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if ((pCached == NULL) || (*pCached != value)) {
+        errorCode = writeWifiStaCfgInt(atHandle, 0, tag, value);
+        if (pCached != NULL) {
+            *pCached = (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) ? value : -1;
+        }
+    }
+
+    return errorCode;
+}
+
+/** Helper function for writing a Wifi station config string value
+ * only if it differs from pCached; pCached may be NULL */
+static int32_t writeWifiStaCfgStrCached(uAtClientHandle_t atHandle,
+                                        int32_t tag, const char *pValue,
+                                        char *pCached, size_t cachedSize)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if ((pCached == NULL) || (pCached[0] == 0) || (strcmp(pCached, pValue) != 0)) {
+        errorCode = writeWifiStaCfgStr(atHandle, 0, tag, pValue);
+        if (pCached != NULL) {
+            pCached[0] = 0;
+            if ((errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) &&
+                (strlen(pValue) < cachedSize)) {
+                strncpy(pCached, pValue, cachedSize);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 /** Helper function for reading a Wifi station status string value */
 static int32_t readWifiStaStatusString(uAtClientHandle_t atHandle,
                                        int32_t statusId,
@@ -262,6 +383,150 @@ static int32_t readIfaceStatusString(uAtClientHandle_t atHandle,
     return retValue;
 }
 
+/** Helper function for reading what is needed for a fast reconnect
+ * from the module; succeeds only if the station is connected and has
+ * an IPv4 address */
+static int32_t readFastReconnect(uAtClientHandle_t atHandle,
+                                 uWifiFastReconnect_t *pFastReconnect)
+{
+    int32_t errorCode = (int32_t) U_WIFI_ERROR_NOT_FOUND;
+    char bssid[(U_WIFI_BSSID_SIZE * 2) + 1];
+    // In the order of the AT+UNSTAT tags from U_WIFI_IPV4_TAG_FIRST
+    char *pIpV4[] = {pFastReconnect->ipV4Address, pFastReconnect->ipV4SubnetMask,
+                     pFastReconnect->ipV4Gateway, pFastReconnect->ipV4Dns
+                    };
+    size_t x;
+
+    memset(pFastReconnect, 0, sizeof(*pFastReconnect));
+    if (readWifiStaStatusInt(atHandle, 3) == 2) {
+        errorCode = readWifiStaStatusString(atHandle, 0, pFastReconnect->ssid,
+                                            sizeof(pFastReconnect->ssid));
+        if (errorCode >= 0) {
+            errorCode = readWifiStaStatusString(atHandle, 1, bssid, sizeof(bssid));
+        }
+        if ((errorCode >= 0) &&
+            (uHexToBin(bssid, errorCode, (char *) pFastReconnect->bssid) != U_WIFI_BSSID_SIZE)) {
+            errorCode = (int32_t) U_WIFI_ERROR_AT;
+        }
+        if (errorCode >= 0) {
+            errorCode = readWifiStaStatusInt(atHandle, 2);
+            pFastReconnect->channel = errorCode;
+        }
+        for (x = 0; (x < sizeof(pIpV4) / sizeof(pIpV4[0])) && (errorCode >= 0); x++) {
+            errorCode = readIfaceStatusString(atHandle, 0,
+                                              U_WIFI_IPV4_TAG_FIRST + (int32_t) x,
+                                              pIpV4[x], U_WIFI_IPV4_STR_SIZE);
+        }
+        if (errorCode >= 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if ((pFastReconnect->ipV4Address[0] == 0) ||
+                (strcmp(pFastReconnect->ipV4Address, "0.0.0.0") == 0)) {
+                errorCode = (int32_t) U_WIFI_ERROR_NOT_FOUND;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+/** Helper function for sending a scan command, the caller must
+ * have locked the AT client */
+static void startScan(uAtClientHandle_t atHandle, const char *pSsid)
+{
+    if (pSsid) {
+        uAtClientCommandStart(atHandle, "AT+UWSCAN=");
+        uAtClientWriteString(atHandle, pSsid, false);
+    } else {
+        uAtClientCommandStart(atHandle, "AT+UWSCAN");
+    }
+    uAtClientCommandStop(atHandle);
+
+    uAtClientTimeoutSet(atHandle, 10000);
+}
+
+/** Helper function for reading the rest of a +UWSCAN line; if channel
+ * is non-zero and the line is for a different channel the remainder
+ * of it is skipped, without parsing, and false is returned */
+static bool readScanResult(uAtClientHandle_t atHandle, int32_t channel,
+                           uWifiScanResult_t *pResult)
+{
+    int32_t bssidLength;
+    int32_t result;
+    char bssid[32];
+
+    // The BSSID comes first but is only converted once the
+    // channel is known to be wanted
+    bssidLength = uAtClientReadString(atHandle, bssid, sizeof(bssid), false);
+    pResult->opMode = uAtClientReadInt(atHandle);
+    result = uAtClientReadString(atHandle, pResult->ssid, sizeof(pResult->ssid), false);
+    if (result < 0) {
+        uPortLog(LOG_TAG "Warning: Failed to parse SSID");
+    }
+    pResult->channel = uAtClientReadInt(atHandle);
+    if ((channel > 0) && (pResult->channel != channel)) {
+        // Skip rssi, auth_suites, unicast_ciphers and group_ciphers
+        uAtClientSkipParameters(atHandle, 4);
+        return false;
+    }
+
+    if (bssidLength >= 0) {
+        if (uHexToBin(bssid, bssidLength, (char *)pResult->bssid) != bssidLength / 2) {
+            bssidLength = -1;
+        }
+    }
+    if (bssidLength < 0) {
+        uPortLog(LOG_TAG "Warning: Failed to parse BSSID");
+    }
+    pResult->rssi = uAtClientReadInt(atHandle);
+    pResult->authSuiteBitmask = uAtClientReadInt(atHandle);
+    pResult->uniCipherBitmask = (uint8_t)uAtClientReadInt(atHandle);
+    pResult->grpCipherBitmask = (uint8_t)uAtClientReadInt(atHandle);
+
+    return true;
+}
+
+/** Run an asynchronous scan, called via uAtClientCallback() */
+static void scanAsyncCallback(uAtClientHandle_t atHandle,
+                              void *pParameter)
+{
+    uWifiScanContext_t *pContext = (uWifiScanContext_t *) pParameter;
+    uShortRangePrivateInstance_t *pInstance;
+    uWifiScanResult_t scanResult;
+    int32_t errorCode;
+
+    if (!pContext) {
+        return;
+    }
+
+    uAtClientLock(atHandle);
+    startScan(atHandle, pContext->ssidSet ? pContext->ssid : NULL);
+    // The module always sends the complete list, so once stopped
+    // the remaining lines are skipped rather than parsed
+    while (uAtClientResponseStart(atHandle, "+UWSCAN:") == 0) {
+        if (pContext->stop) {
+            uAtClientSkipParameters(atHandle, 8);
+        } else if (readScanResult(atHandle, pContext->channel, &scanResult) &&
+                   !pContext->pCallback(pContext->devHandle, &scanResult, 0,
+                                        pContext->pCallbackParameter)) {
+            pContext->stop = true;
+        }
+    }
+    errorCode = uAtClientUnlock(atHandle);
+
+    if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
+        pInstance = pUShortRangePrivateGetInstance(pContext->devHandle);
+        if ((pInstance != NULL) && (pInstance->pWifiScanContext == pContext)) {
+            pInstance->pWifiScanContext = NULL;
+        }
+        uShortRangeUnlock();
+    }
+
+    pContext->pCallback(pContext->devHandle, NULL, errorCode,
+                        pContext->pCallbackParameter);
+
+    free(pContext);
+}
+
 static void wifiConnectCallback(uAtClientHandle_t atHandle,
                                 void *pParameter)
 {
@@ -297,7 +562,7 @@ static void wifiConnectCallback(uAtClientHandle_t atHandle,
         }
     }
 
-    free(pStatus);
+    uMemPoolFree(pStatus);
 }
 
 //lint -esym(818, pParameter) Suppress pParameter could be const, need to
@@ -315,7 +580,7 @@ static void UUWLE_urc(uAtClientHandle_t atHandle,
     channel = uAtClientReadInt(atHandle);
 
     //lint -esym(429, pStatus) Suppress pStatus not being free()ed here
-    pStatus = (uWifiConnection_t *) malloc(sizeof(*pStatus));
+    pStatus = (uWifiConnection_t *) uMemPoolMalloc(sizeof(*pStatus));
     if (pStatus != NULL) {
         pStatus->devHandle = devHandle;
         pStatus->connId = connId;
@@ -325,7 +590,7 @@ static void UUWLE_urc(uAtClientHandle_t atHandle,
         pStatus->reason = 0;
         //lint -e(1773) Suppress attempt to cast away volatile
         if (uAtClientCallback(atHandle, wifiConnectCallback, pStatus) < 0) {
-            free(pStatus);
+            uMemPoolFree(pStatus);
         }
     }
 }
@@ -343,7 +608,7 @@ static void UUWLD_urc(uAtClientHandle_t atHandle,
     reason = uAtClientReadInt(atHandle);
 
     //lint -esym(429, pStatus) Suppress pStatus not being free()ed here
-    pStatus = (uWifiConnection_t *) malloc(sizeof(*pStatus));
+    pStatus = (uWifiConnection_t *) uMemPoolMalloc(sizeof(*pStatus));
     if (pStatus != NULL) {
         pStatus->devHandle = devHandle;
         pStatus->connId = connId;
@@ -352,7 +617,7 @@ static void UUWLD_urc(uAtClientHandle_t atHandle,
         pStatus->bssid[0] = '\0';
         pStatus->reason = reason;
         if (uAtClientCallback(atHandle, wifiConnectCallback, pStatus) < 0) {
-            free(pStatus);
+            uMemPoolFree(pStatus);
         }
     }
 }
@@ -573,33 +838,80 @@ int32_t uWifiStationConnect(uDeviceHandle_t devHandle, const char *pSsid,
             }
         }
 
-        // Configure Wifi
+        // Configure Wifi, only writing what has changed
+        uWifiStaCache_t *pCache = pGetStaCache(pInstance);
+        uWifiStaCfgCache_t *pCfg = (pCache != NULL) ? &(pCache->cfg) : NULL;
+        const uWifiFastReconnect_t *pFast = NULL;
+        if ((errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) &&
+            (pCache != NULL) && pCache->fastReconnectEnabled) {
+            if (pCache->fastReconnectUnconfirmed) {
+                // The last fast reconnect never got as far as the
+                // network being up: forget it and use DHCP
+                uPortLog(LOG_TAG "Fast reconnect not confirmed, using DHCP\n");
+                memset(&(pCache->fastReconnect), 0, sizeof(pCache->fastReconnect));
+                pCache->fastReconnectUnconfirmed = false;
+            } else if ((strcmp(pCache->fastReconnect.ssid, pSsid) == 0) &&
+                       (pCache->fastReconnect.ipV4Address[0] != 0)) {
+                pFast = &(pCache->fastReconnect);
+            }
+        }
         if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
             // Set Wifi STA inactive on start up
             uPortLog(LOG_TAG "Activating wifi STA mode\n");
-            errorCode = writeWifiStaCfgInt(atHandle, 0, 0, 0);
+            errorCode = writeWifiStaCfgIntCached(atHandle, 0, 0,
+                                                 (pCfg != NULL) ? &(pCfg->activeOnStartup) : NULL);
         }
         if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
             // Set SSID
-            errorCode = writeWifiStaCfgStr(atHandle, 0, 2, pSsid);
+            errorCode = writeWifiStaCfgStrCached(atHandle, 2, pSsid,
+                                                 (pCfg != NULL) ? pCfg->ssid : NULL,
+                                                 sizeof(pCfg->ssid));
         }
         if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
             // Set authentication
-            errorCode = writeWifiStaCfgInt(atHandle, 0, 5, (int32_t)authentication);
+            errorCode = writeWifiStaCfgIntCached(atHandle, 5, (int32_t)authentication,
+                                                 (pCfg != NULL) ? &(pCfg->authentication) : NULL);
         }
         if ((errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) &&
             (authentication != U_WIFI_AUTH_OPEN)) {
             // Set PSK/passphrase
-            errorCode = writeWifiStaCfgStr(atHandle, 0, 8, pPassPhrase);
+            errorCode = writeWifiStaCfgStrCached(atHandle, 8, pPassPhrase,
+                                                 (pCfg != NULL) ? pCfg->passPhrase : NULL,
+                                                 sizeof(pCfg->passPhrase));
         }
-        if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
-            // Set IP mode to static IP
-            errorCode = writeWifiStaCfgInt(atHandle, 0, 100, 2);
+        if (pFast != NULL) {
+            // Fast reconnect: re-use the IPv4 configuration of the
+            // last connection as a static one, saving the DHCP exchange
+            const char *pIpV4[] = {pFast->ipV4Address, pFast->ipV4SubnetMask,
+                                   pFast->ipV4Gateway, pFast->ipV4Dns
+                                  };
+            uPortLog(LOG_TAG "Fast reconnect with IP address %s\n", pFast->ipV4Address);
+            for (size_t x = 0; (x < sizeof(pIpV4) / sizeof(pIpV4[0])) &&
+                 (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS); x++) {
+                if (pIpV4[x][0] != 0) {
+                    errorCode = writeWifiStaCfgStrCached(atHandle,
+                                                         U_WIFI_IPV4_TAG_FIRST + (int32_t) x,
+                                                         pIpV4[x],
+                                                         (pCfg != NULL) ? pCfg->ipV4[x] : NULL,
+                                                         sizeof(pCfg->ipV4[x]));
+                }
+            }
+            if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+                errorCode = writeWifiStaCfgIntCached(atHandle, 100, U_WIFI_IPV4_MODE_STATIC,
+                                                     (pCfg != NULL) ? &(pCfg->ipV4Mode) : NULL);
+            }
+        } else if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+            // Set IP mode to DHCP
+            errorCode = writeWifiStaCfgIntCached(atHandle, 100, U_WIFI_IPV4_MODE_DHCP,
+                                                 (pCfg != NULL) ? &(pCfg->ipV4Mode) : NULL);
         }
         if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
             // Activate wifi
             errorCode = writeWifiStaCfgAction(atHandle, 0, STA_ACTION_ACTIVATE);
         }
+        if ((errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) && (pFast != NULL)) {
+            pCache->fastReconnectUnconfirmed = true;
+        }
     }
 
     uShortRangeUnlock();
@@ -623,6 +935,14 @@ int32_t uWifiStationDisconnect(uDeviceHandle_t devHandle)
         // Read connection status
         int32_t conStatus = readWifiStaStatusInt(atHandle, 3);
         if (conStatus != 0) {
+            uWifiStaCache_t *pCache = (uWifiStaCache_t *) pInstance->pWifiStaCache;
+            uWifiFastReconnect_t fastReconnect;
+            if ((pCache != NULL) && pCache->fastReconnectEnabled &&
+                (readFastReconnect(atHandle, &fastReconnect) == 0)) {
+                // Remember this connection for next time
+                pCache->fastReconnect = fastReconnect;
+                pCache->fastReconnectUnconfirmed = false;
+            }
             uPortLog(LOG_TAG "De-activating wifi STA mode\n");
             errorCode = writeWifiStaCfgAction(atHandle, 0, STA_ACTION_DEACTIVATE);
         } else {
@@ -637,6 +957,84 @@ int32_t uWifiStationDisconnect(uDeviceHandle_t devHandle)
 }
 
 
+int32_t uWifiStationGetFastReconnect(uDeviceHandle_t devHandle,
+                                     uWifiFastReconnect_t *pFastReconnect)
+{
+    int32_t errorCode;
+    uShortRangePrivateInstance_t *pInstance;
+    uWifiStaCache_t *pCache;
+
+    if (pFastReconnect == NULL) {
+        return (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+
+    errorCode = uShortRangeLock();
+    if (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) {
+        return errorCode;
+    }
+
+    errorCode = getInstance(devHandle, &pInstance);
+    if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+        pCache = pGetStaCache(pInstance);
+        errorCode = readFastReconnect(pInstance->atHandle, pFastReconnect);
+        if (pCache != NULL) {
+            if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+                pCache->fastReconnect = *pFastReconnect;
+                pCache->fastReconnectUnconfirmed = false;
+            } else if (pCache->fastReconnect.ssid[0] != 0) {
+                *pFastReconnect = pCache->fastReconnect;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+        if (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) {
+            errorCode = (int32_t) U_WIFI_ERROR_NOT_FOUND;
+        }
+    }
+
+    uShortRangeUnlock();
+
+    return errorCode;
+}
+
+int32_t uWifiStationSetFastReconnect(uDeviceHandle_t devHandle,
+                                     const uWifiFastReconnect_t *pFastReconnect)
+{
+    int32_t errorCode;
+    uShortRangePrivateInstance_t *pInstance;
+    uWifiStaCache_t *pCache;
+
+    errorCode = uShortRangeLock();
+    if (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) {
+        return errorCode;
+    }
+
+    errorCode = getInstance(devHandle, &pInstance);
+    if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pCache = pGetStaCache(pInstance);
+        if (pCache != NULL) {
+            pCache->fastReconnectEnabled = false;
+            pCache->fastReconnectUnconfirmed = false;
+            memset(&(pCache->fastReconnect), 0, sizeof(pCache->fastReconnect));
+            if (pFastReconnect != NULL) {
+                pCache->fastReconnect = *pFastReconnect;
+                // Make sure the strings are terminated
+                pCache->fastReconnect.ssid[sizeof(pCache->fastReconnect.ssid) - 1] = 0;
+                pCache->fastReconnect.ipV4Address[U_WIFI_IPV4_STR_SIZE - 1] = 0;
+                pCache->fastReconnect.ipV4SubnetMask[U_WIFI_IPV4_STR_SIZE - 1] = 0;
+                pCache->fastReconnect.ipV4Gateway[U_WIFI_IPV4_STR_SIZE - 1] = 0;
+                pCache->fastReconnect.ipV4Dns[U_WIFI_IPV4_STR_SIZE - 1] = 0;
+                pCache->fastReconnectEnabled = true;
+            }
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    uShortRangeUnlock();
+
+    return errorCode;
+}
+
 int32_t uWifiStationScan(uDeviceHandle_t devHandle, const char *pSsid,
                          uWifiScanResultCallback_t pCallback)
 {
@@ -656,43 +1054,13 @@ int32_t uWifiStationScan(uDeviceHandle_t devHandle, const char *pSsid,
         // Since the scanning can take some time we release the short range lock here
         // This should be fine since we currently have the AT client lock instead
         uShortRangeUnlock();
-        if (pSsid) {
-            uAtClientCommandStart(atHandle, "AT+UWSCAN=");
-            uAtClientWriteString(atHandle, pSsid, false);
-        } else {
-            uAtClientCommandStart(atHandle, "AT+UWSCAN");
-        }
-        uAtClientCommandStop(atHandle);
-
-        uAtClientTimeoutSet(atHandle, 10000);
+        startScan(atHandle, pSsid);
 
         // Handle the scan results
         // Loop until we get OK, ERROR or timeout
         while (uAtClientResponseStart(atHandle, "+UWSCAN:") == 0) {
             uWifiScanResult_t scanResult;
-            int32_t result;
-            char bssid[32];
-
-            result = uAtClientReadString(atHandle, bssid, sizeof(bssid), false);
-            if (result >= 0) {
-                if (uHexToBin(bssid, result, (char *)scanResult.bssid) != result / 2) {
-                    result = -1;
-                }
-            }
-            if (result < 0) {
-                uPortLog(LOG_TAG "Warning: Failed to parse BSSID");
-            }
-            scanResult.opMode = uAtClientReadInt(atHandle);
-            result = uAtClientReadString(atHandle, scanResult.ssid, sizeof(scanResult.ssid), false);
-            if (result < 0) {
-                uPortLog(LOG_TAG "Warning: Failed to parse SSID");
-            }
-            scanResult.channel = uAtClientReadInt(atHandle);
-            scanResult.rssi = uAtClientReadInt(atHandle);
-            scanResult.authSuiteBitmask = uAtClientReadInt(atHandle);
-            scanResult.uniCipherBitmask = (uint8_t)uAtClientReadInt(atHandle);
-            scanResult.grpCipherBitmask = (uint8_t)uAtClientReadInt(atHandle);
-
+            (void) readScanResult(atHandle, 0, &scanResult);
             pCallback(devHandle, &scanResult);
         }
 
@@ -705,4 +1073,82 @@ int32_t uWifiStationScan(uDeviceHandle_t devHandle, const char *pSsid,
     return errorCode;
 }
 
+int32_t uWifiStationScanStart(uDeviceHandle_t devHandle,
+                              const uWifiScanFilter_t *pFilter,
+                              uWifiScanAsyncCallback_t pCallback,
+                              void *pCallbackParameter)
+{
+    int32_t errorCode;
+    uShortRangePrivateInstance_t *pInstance;
+    uWifiScanContext_t *pContext;
+
+    if ((pCallback == NULL) ||
+        ((pFilter != NULL) && (pFilter->pSsid != NULL) &&
+         (strlen(pFilter->pSsid) >= U_WIFI_SSID_SIZE))) {
+        return (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    }
+
+    errorCode = uShortRangeLock();
+    if (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) {
+        return errorCode;
+    }
+
+    errorCode = getInstance(devHandle, &pInstance);
+    if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+        errorCode = (int32_t) U_WIFI_ERROR_TEMPORARY_FAILURE;
+        if (pInstance->pWifiScanContext == NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            //lint -esym(593, pContext) Suppress pContext not being free()ed here
+            pContext = (uWifiScanContext_t *) malloc(sizeof(*pContext));
+            if (pContext != NULL) {
+                memset(pContext, 0, sizeof(*pContext));
+                pContext->devHandle = devHandle;
+                if (pFilter != NULL) {
+                    if (pFilter->pSsid != NULL) {
+                        strncpy(pContext->ssid, pFilter->pSsid, sizeof(pContext->ssid));
+                        pContext->ssidSet = true;
+                    }
+                    pContext->channel = pFilter->channel;
+                }
+                pContext->pCallback = pCallback;
+                pContext->pCallbackParameter = pCallbackParameter;
+                pInstance->pWifiScanContext = pContext;
+                errorCode = uAtClientCallback(pInstance->atHandle, scanAsyncCallback, pContext);
+                if (errorCode < 0) {
+                    pInstance->pWifiScanContext = NULL;
+                    free(pContext);
+                }
+            }
+        }
+    }
+
+    uShortRangeUnlock();
+
+    return errorCode;
+}
+
+int32_t uWifiStationScanStop(uDeviceHandle_t devHandle)
+{
+    int32_t errorCode;
+    uShortRangePrivateInstance_t *pInstance;
+
+    errorCode = uShortRangeLock();
+    if (errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) {
+        return errorCode;
+    }
+
+    errorCode = getInstance(devHandle, &pInstance);
+    if (errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+        errorCode = (int32_t) U_WIFI_ERROR_NOT_FOUND;
+        if (pInstance->pWifiScanContext != NULL) {
+            ((uWifiScanContext_t *) pInstance->pWifiScanContext)->stop = true;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    uShortRangeUnlock();
+
+    return errorCode;
+}
+
 // End of file
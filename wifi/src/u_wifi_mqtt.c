@@ -98,6 +98,7 @@ typedef struct uWifiMqttSession_t {
     int32_t localPort;
     int32_t unreadMsgsCount;
     uPortSemaphoreHandle_t semaphore;
+    uPortMutexHandle_t mutex; // Protects this session only, kept across freeMqttSession()
     void *pCbParam;
     void (*pDataCb)(int32_t unreadMsgsCount, void *pCbParam);
     void (*pDisconnectCb)(int32_t status, void *pCbParam);
@@ -112,6 +113,11 @@ typedef struct {
 } uCallbackEvent_t;
 
 static uWifiMqttSession_t gMqttSessions[U_WIFI_MQTT_MAX_NUM_CONNECTIONS];
+/** Created when the first session is opened and deleted when the
+ * last is closed; the sessions themselves are each protected by
+ * their own mutex, so that reading from one session does not hold
+ * up another.
+ */
 static uPortMutexHandle_t gMqttSessionMutex = NULL;
 static int32_t gCallbackQueue = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
 static int32_t gEdmChannel = -1;
@@ -170,6 +176,14 @@ static uWifiMqttTopic_t *pAllocateMqttTopic (uWifiMqttSession_t *pMqttSession, b
         if (pTopic != NULL) {
 
             pTopic->pNext = NULL;
+            pTopic->pTopicStr = NULL;
+            pTopic->peerHandle = -1;
+            pTopic->edmChannel = -1;
+            pTopic->isTopicUnsubscribed = false;
+            pTopic->isPublish = isPublish;
+
+            // The callbacks walk the topic list
+            U_PORT_MUTEX_LOCK(pMqttSession->mutex);
 
             if (pMqttSession->topicList.pHead == NULL) {
 
@@ -182,10 +196,7 @@ static uWifiMqttTopic_t *pAllocateMqttTopic (uWifiMqttSession_t *pMqttSession, b
 
             pMqttSession->topicList.pTail = pTopic;
 
-            pTopic->peerHandle = -1;
-            pTopic->edmChannel = -1;
-            pTopic->isTopicUnsubscribed = false;
-            pTopic->isPublish = isPublish;
+            U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
         }
     }
 
@@ -484,12 +495,11 @@ static void onCallbackEvent(void *pParam, size_t eventSize)
     (void) eventSize;
 
     if (pCbEvent->pDataCb) {
-        U_PORT_MUTEX_LOCK(gMqttSessionMutex);
-
         if (pMqttSession != NULL) {
+            U_PORT_MUTEX_LOCK(pMqttSession->mutex);
             unreadMsgsCount = pMqttSession->unreadMsgsCount;
+            U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
         }
-        U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
 
         pCbEvent->pDataCb(unreadMsgsCount, pCbEvent->pCbParam);
     } else if (pCbEvent->pDisconnectCb) {
@@ -508,12 +518,13 @@ static void edmMqttDataCallback(int32_t edmHandle, int32_t edmChannel,
     (void) edmHandle;
     (void)pCallbackParameter;
 
-    U_PORT_MUTEX_LOCK(gMqttSessionMutex);
-
     for (i = 0; i < U_WIFI_MQTT_MAX_NUM_CONNECTIONS; i++) {
 
         pMqttSession = &gMqttSessions[i];
 
+        // Only the session the data is for is held up
+        U_PORT_MUTEX_LOCK(pMqttSession->mutex);
+
         for (pTopic = pMqttSession->topicList.pHead; pTopic != NULL; pTopic = pTopic->pNext) {
 
             if ((pTopic->edmChannel == edmChannel) && (!pTopic->isTopicUnsubscribed)) {
@@ -540,9 +551,9 @@ static void edmMqttDataCallback(int32_t edmHandle, int32_t edmChannel,
                 }
             }
         }
-    }
 
-    U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+        U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
+    }
 }
 
 
@@ -583,13 +594,14 @@ static void atMqttConnectionCallback(uDeviceHandle_t devHandle,
     (void)pConnectData;
     (void)pCallbackParameter;
 
-    U_PORT_MUTEX_LOCK(gMqttSessionMutex);
-
-    for (i = 0; i < U_WIFI_MQTT_MAX_NUM_CONNECTIONS; i++) {
+    for (i = 0; (i < U_WIFI_MQTT_MAX_NUM_CONNECTIONS) && !topicFound; i++) {
 
         pMqttSession = &gMqttSessions[i];
 
-        for (pTopic = pMqttSession->topicList.pHead; pTopic != NULL; pTopic = pTopic->pNext) {
+        U_PORT_MUTEX_LOCK(pMqttSession->mutex);
+
+        for (pTopic = pMqttSession->topicList.pHead; (pTopic != NULL) && !topicFound;
+             pTopic = pTopic->pNext) {
 
             if (pTopic->peerHandle == connHandle) {
 
@@ -622,18 +634,15 @@ static void atMqttConnectionCallback(uDeviceHandle_t devHandle,
                         break;
                 }
             }
-
-            if (topicFound) {
-                break;
-            }
         }
 
-        if (topicFound) {
-            break;
-        }
+        U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
     }
 
-    U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+    if (topicFound) {
+        // Step back to the session the topic was found in
+        pMqttSession = &gMqttSessions[i - 1];
+    }
     uPortSemaphoreGive(pMqttSession->semaphore);
 }
 
@@ -679,8 +688,31 @@ static int32_t getMqttInstance(const uMqttClientContext_t *pContext,
     return err;
 }
 
+// Get the MQTT session of a context, for the functions that only
+// touch the session and so need not hold the short range lock
+// while they do it: that way reading from one session does not
+// hold up, e.g., publishing on another.
+static int32_t getMqttSession(const uMqttClientContext_t *pContext,
+                              uWifiMqttSession_t **ppMqttSession)
+{
+    int32_t err;
+    uShortRangePrivateInstance_t *pInstance;
+
+    err = uShortRangeLock();
+    if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
+        err = getMqttInstance(pContext, &pInstance, ppMqttSession);
+        uShortRangeUnlock();
+    }
+
+    return err;
+}
+
+// The caller must hold the session mutex, if there is one.
 static void freeMqttSession(uWifiMqttSession_t *pMqttSession)
 {
+    uPortMutexHandle_t mutex;
+    uShortRangePbufList_t *pBufList;
+
     if (pMqttSession != NULL) {
 
         if (pMqttSession->pClientIdStr) {
@@ -701,12 +733,32 @@ static void freeMqttSession(uWifiMqttSession_t *pMqttSession)
             uPortSemaphoreDelete(pMqttSession->semaphore);
 
         }
+        mutex = pMqttSession->mutex;
         if (pMqttSession->topicList.pHead) {
             freeAllMqttTopics(pMqttSession);
         }
+        // Free any messages that were never read
+        while ((pBufList = pUShortRangePktListRemoveHead(&pMqttSession->rxPkt)) != NULL) {
+            uShortRangePbufListFree(pBufList);
+        }
 
         memset(pMqttSession, 0, sizeof(uWifiMqttSession_t));
         pMqttSession->sessionHandle = -1;
+        pMqttSession->mutex = mutex;
+    }
+}
+
+static void deleteMqttSessionMutexes(void)
+{
+    for (int32_t i = 0; i < U_WIFI_MQTT_MAX_NUM_CONNECTIONS; i++) {
+        if (gMqttSessions[i].mutex != NULL) {
+            uPortMutexDelete(gMqttSessions[i].mutex);
+            gMqttSessions[i].mutex = NULL;
+        }
+    }
+    if (gMqttSessionMutex != NULL) {
+        uPortMutexDelete(gMqttSessionMutex);
+        gMqttSessionMutex = NULL;
     }
 }
 
@@ -714,12 +766,16 @@ static int32_t initMqttSessions(void)
 {
     int32_t err;
 
+    memset(gMqttSessions, 0, sizeof(gMqttSessions));
     err = uPortMutexCreate(&gMqttSessionMutex);
 
-    if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
-        for (int32_t i = 0; i < U_WIFI_MQTT_MAX_NUM_CONNECTIONS; i++) {
-            freeMqttSession(&gMqttSessions[i]);
-        }
+    for (int32_t i = 0; (i < U_WIFI_MQTT_MAX_NUM_CONNECTIONS) &&
+         (err == (int32_t)U_ERROR_COMMON_SUCCESS); i++) {
+        err = uPortMutexCreate(&gMqttSessions[i].mutex);
+        freeMqttSession(&gMqttSessions[i]);
+    }
+    if (err != (int32_t)U_ERROR_COMMON_SUCCESS) {
+        deleteMqttSessionMutexes();
     }
     uPortLog("U_WIFI_MQTT: init MQTT session err = %d\n", err);
 
@@ -738,8 +794,6 @@ static void freeMqtt(uMqttClientContext_t *pContext)
     }
 
     if (count == U_WIFI_MQTT_MAX_NUM_CONNECTIONS) {
-        uPortMutexDelete(gMqttSessionMutex);
-        gMqttSessionMutex = NULL;
         if (getInstance(pContext->devHandle, &pInstance) == (int32_t)U_ERROR_COMMON_SUCCESS) {
 
             uShortRangeSetMqttConnectionStatusCallback(pContext->devHandle, NULL, NULL);
@@ -754,6 +808,8 @@ static void freeMqtt(uMqttClientContext_t *pContext)
             gCallbackQueue = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
 
         }
+        // Only now that nothing can call back in
+        deleteMqttSessionMutexes();
     }
 }
 
@@ -896,9 +952,10 @@ int32_t uWifiMqttConnect(const uMqttClientContext_t *pContext,
     int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
     uWifiMqttSession_t *pMqttSession = (uWifiMqttSession_t *)pContext->pPriv;
 
-    if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
+    if ((pMqttSession != NULL) &&
+        (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS)) {
         if (getInstance(pContext->devHandle, &pInstance) == (int32_t)U_ERROR_COMMON_SUCCESS) {
-            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            U_PORT_MUTEX_LOCK(pMqttSession->mutex);
             err = configureMqttSessionConnection(pMqttSession, pConnection);
 
             if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
@@ -914,7 +971,7 @@ int32_t uWifiMqttConnect(const uMqttClientContext_t *pContext,
                 pMqttSession->atHandle = pInstance->atHandle;
                 pMqttSession->isConnected = true;
             }
-            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+            U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
         }
         uShortRangeUnlock();
     } else {
@@ -934,7 +991,7 @@ int32_t uWifiMqttSetMessageCallback(const uMqttClientContext_t *pContext,
     if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
         err = getMqttInstance(pContext, &pInstance, &pMqttSession);
         if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
-            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            U_PORT_MUTEX_LOCK(pMqttSession->mutex);
             pMqttSession->pDataCb = pCallback;
             pMqttSession->pCbParam = pCallbackParam;
 
@@ -948,7 +1005,7 @@ int32_t uWifiMqttSetMessageCallback(const uMqttClientContext_t *pContext,
             }
             err = (gCallbackQueue >= 0) ? (int32_t)U_ERROR_COMMON_SUCCESS : (int32_t)
                   U_ERROR_COMMON_NOT_INITIALISED;
-            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+            U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
         }
         uShortRangeUnlock();
     }
@@ -966,7 +1023,7 @@ int32_t uWifiMqttSetDisconnectCallback(const uMqttClientContext_t *pContext,
     if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
         err = getMqttInstance(pContext, &pInstance, &pMqttSession);
         if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
-            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            U_PORT_MUTEX_LOCK(pMqttSession->mutex);
             pMqttSession->pDisconnectCb = pCallback;
             pMqttSession->pCbParam = pCallbackParam;
 
@@ -980,7 +1037,7 @@ int32_t uWifiMqttSetDisconnectCallback(const uMqttClientContext_t *pContext,
             }
             err = (gCallbackQueue >= 0) ? (int32_t)U_ERROR_COMMON_SUCCESS : (int32_t)
                   U_ERROR_COMMON_NOT_INITIALISED;
-            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+            U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
         }
         uShortRangeUnlock();
     }
@@ -1039,13 +1096,18 @@ int32_t uWifiMqttPublish(const uMqttClientContext_t *pContext,
                                                 pTopic->edmChannel,
                                                 pMessage,
                                                 messageSizeBytes,
-                                                U_WIFI_MQTT_WRITE_TIMEOUT_MS);
+                                                U_WIFI_MQTT_WRITE_TIMEOUT_MS +
+                                                ((messageSizeBytes / 1024) *
+                                                 U_WIFI_MQTT_WRITE_TIMEOUT_PER_KBYTE_MS));
                 uPortLog("EDM write for channel %d message bytes %d written bytes %d\n", pTopic->edmChannel,
                          messageSizeBytes,
                          err);
             }
             if (err == messageSizeBytes) {
                 err = (int32_t)U_ERROR_COMMON_SUCCESS;
+            } else if (err > 0) {
+                // Only part of the message made it out
+                err = (int32_t)U_ERROR_COMMON_TIMEOUT;
             }
         }
         uShortRangeUnlock();
@@ -1120,7 +1182,7 @@ int32_t uWifiMqttUnsubscribe(const uMqttClientContext_t *pContext,
         // Check WiFi SHO handle and MQTT session exists
         if (getMqttInstance(pContext, &pInstance, &pMqttSession) == (int32_t)U_ERROR_COMMON_SUCCESS) {
 
-            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            U_PORT_MUTEX_LOCK(pMqttSession->mutex);
 
             // Fetch the pTopic object that contains this pTopic string
             pTopic = findTopic(pMqttSession, pTopicFilterStr, false);
@@ -1133,7 +1195,7 @@ int32_t uWifiMqttUnsubscribe(const uMqttClientContext_t *pContext,
                 uPortLog("U_WIFI_MQTT: Topic not found in session %p\n", pMqttSession);
             }
 
-            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+            U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
         }
         uShortRangeUnlock();
     }
@@ -1188,7 +1250,9 @@ void uWifiMqttClose(uMqttClientContext_t *pContext)
             }
             // Release the memory for all the topics associated to this session
             // as well as the session itself.
+            U_PORT_MUTEX_LOCK(pMqttSession->mutex);
             freeMqttSession(pMqttSession);
+            U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
             // Deregister the EDM, MQTT, AT callbacks
             freeMqtt(pContext);
         }
@@ -1199,19 +1263,14 @@ void uWifiMqttClose(uMqttClientContext_t *pContext)
 int32_t uWifiMqttGetUnread(const uMqttClientContext_t *pContext)
 {
     uWifiMqttSession_t *pMqttSession;
-    uShortRangePrivateInstance_t *pInstance;
     int32_t unReadMsgsCount = 0;
 
-    if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
+    // Check WiFi SHO handle and MQTT session exists
+    if (getMqttSession(pContext, &pMqttSession) == (int32_t)U_ERROR_COMMON_SUCCESS) {
 
-        // Check WiFi SHO handle and MQTT session exists
-        if (getMqttInstance(pContext, &pInstance, &pMqttSession) == (int32_t)U_ERROR_COMMON_SUCCESS) {
-
-            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
-            unReadMsgsCount = pMqttSession->unreadMsgsCount;
-            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
-        }
-        uShortRangeUnlock();
+        U_PORT_MUTEX_LOCK(pMqttSession->mutex);
+        unReadMsgsCount = pMqttSession->unreadMsgsCount;
+        U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
     }
 
     return unReadMsgsCount;
@@ -1225,74 +1284,140 @@ int32_t uWifiMqttMessageRead(const uMqttClientContext_t *pContext,
                              uMqttQos_t *pQos)
 {
     uWifiMqttSession_t *pMqttSession;
-    uShortRangePrivateInstance_t *pInstance;
     int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
     int32_t edmChannel;
     char *pFoundTopicStr;
     size_t foundTopicLen;
     (void) pQos;
 
-    if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
+    // Check WiFi SHO handle and MQTT session exists
+    if (getMqttSession(pContext, &pMqttSession) == (int32_t)U_ERROR_COMMON_SUCCESS) {
 
-        // Check WiFi SHO handle and MQTT session exists
-        if (getMqttInstance(pContext, &pInstance, &pMqttSession) == (int32_t)U_ERROR_COMMON_SUCCESS) {
+        U_PORT_MUTEX_LOCK(pMqttSession->mutex);
+
+        if ((pTopicNameStr != NULL) &&
+            (pMessage != NULL) &&
+            (pMessageSizeBytes != NULL)) {
 
-            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            memset(pMessage, 0, *pMessageSizeBytes);
+            memset(pTopicNameStr, 0, topicNameSizeBytes);
+            err = uShortRangePktListConsumePacket(&pMqttSession->rxPkt, pMessage, pMessageSizeBytes,
+                                                  &edmChannel);
 
-            if ((pTopicNameStr != NULL) &&
-                (pMessage != NULL) &&
-                (pMessageSizeBytes != NULL)) {
+            pMqttSession->unreadMsgsCount = pMqttSession->rxPkt.pktCount;
+            if (err == 0) {
+                err = (int32_t)U_ERROR_COMMON_NO_MEMORY;
+                pFoundTopicStr = getTopicStrForEdmChannel(pMqttSession, edmChannel);
 
+                if (pFoundTopicStr != NULL) {
+                    foundTopicLen = strlen(pFoundTopicStr);
+                    if ((foundTopicLen + 1) <= topicNameSizeBytes) {
+                        strncpy(pTopicNameStr, pFoundTopicStr, foundTopicLen);
+                        err = (int32_t)U_ERROR_COMMON_SUCCESS;
+                    }
+                }
+
+            }
+            if (err != 0) {
+                // clear the partial message that was copied
                 memset(pMessage, 0, *pMessageSizeBytes);
-                memset(pTopicNameStr, 0, topicNameSizeBytes);
-                err = uShortRangePktListConsumePacket(&pMqttSession->rxPkt, pMessage, pMessageSizeBytes,
-                                                      &edmChannel);
+            }
+        }
+        U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
+    }
 
-                pMqttSession->unreadMsgsCount = pMqttSession->rxPkt.pktCount;
-                if (err == 0) {
-                    err = (int32_t)U_ERROR_COMMON_NO_MEMORY;
-                    pFoundTopicStr = getTopicStrForEdmChannel(pMqttSession, edmChannel);
+    return err;
+}
 
-                    if (pFoundTopicStr != NULL) {
-                        foundTopicLen = strlen(pFoundTopicStr);
-                        if ((foundTopicLen + 1) <= topicNameSizeBytes) {
-                            strncpy(pTopicNameStr, pFoundTopicStr, foundTopicLen);
-                            err = (int32_t)U_ERROR_COMMON_SUCCESS;
-                        }
-                    }
+int32_t uWifiMqttMessageReadChunked(const uMqttClientContext_t *pContext,
+                                    char *pTopicNameStr,
+                                    size_t topicNameSizeBytes,
+                                    char *pChunkBuffer,
+                                    size_t chunkSizeBytes,
+                                    bool (*pCallback) (const char *, size_t,
+                                                       size_t, size_t,
+                                                       void *),
+                                    void *pCallbackParam,
+                                    uMqttQos_t *pQos)
+{
+    uWifiMqttSession_t *pMqttSession;
+    int32_t errOrLength = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+    uShortRangePbufList_t *pBufList = NULL;
+    char *pFoundTopicStr;
+    size_t foundTopicLen;
+    size_t totalLen = 0;
+    size_t offset = 0;
+    size_t chunkLen;
+    bool keepGoing = true;
+    (void) pQos;
 
-                }
-                if (err != 0) {
-                    // clear the partial message that was copied
-                    memset(pMessage, 0, *pMessageSizeBytes);
+    // Check WiFi SHO handle and MQTT session exists
+    if ((pTopicNameStr != NULL) && (topicNameSizeBytes > 0) &&
+        (pChunkBuffer != NULL) && (chunkSizeBytes > 0) && (pCallback != NULL) &&
+        (getMqttSession(pContext, &pMqttSession) == (int32_t)U_ERROR_COMMON_SUCCESS)) {
+
+        U_PORT_MUTEX_LOCK(pMqttSession->mutex);
+
+        // Take the whole packet off the list: its pbufs are
+        // then copied out a chunk at a time, so the message
+        // may be any size the pbuf pool can hold
+        errOrLength = (int32_t)U_ERROR_COMMON_NOT_FOUND;
+        pBufList = pUShortRangePktListRemoveHead(&pMqttSession->rxPkt);
+        pMqttSession->unreadMsgsCount = pMqttSession->rxPkt.pktCount;
+        if (pBufList != NULL) {
+            errOrLength = (int32_t)U_ERROR_COMMON_NO_MEMORY;
+            memset(pTopicNameStr, 0, topicNameSizeBytes);
+            pFoundTopicStr = getTopicStrForEdmChannel(pMqttSession, pBufList->edmChannel);
+            if (pFoundTopicStr != NULL) {
+                foundTopicLen = strlen(pFoundTopicStr);
+                if ((foundTopicLen + 1) <= topicNameSizeBytes) {
+                    strncpy(pTopicNameStr, pFoundTopicStr, foundTopicLen);
+                    totalLen = pBufList->totalLen;
+                    errOrLength = (int32_t)U_ERROR_COMMON_SUCCESS;
                 }
             }
-            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
         }
-        uShortRangeUnlock();
+
+        // The packet is ours now, no need to hold up the
+        // EDM data callback while the application is called
+        U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
+
+        while ((errOrLength == 0) && keepGoing && (offset < totalLen)) {
+            chunkLen = uShortRangePbufListConsumeData(pBufList, pChunkBuffer,
+                                                      chunkSizeBytes);
+            if (chunkLen == 0) {
+                break;
+            }
+            keepGoing = pCallback(pChunkBuffer, chunkLen, offset,
+                                  totalLen, pCallbackParam);
+            offset += chunkLen;
+        }
+
+        if (pBufList != NULL) {
+            // Anything not consumed is discarded with the packet
+            uShortRangePbufListFree(pBufList);
+        }
+        if (errOrLength == 0) {
+            errOrLength = (int32_t) offset;
+        }
     }
 
-    return err;
+    return errOrLength;
 }
 
 bool uWifiMqttIsConnected(const uMqttClientContext_t *pContext)
 {
     uWifiMqttSession_t *pMqttSession;
-    uShortRangePrivateInstance_t *pInstance;
     bool isConnected = false;
 
-    if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
-
-        // Check WiFi SHO handle and MQTT session exists
-        if (getMqttInstance(pContext, &pInstance, &pMqttSession) == (int32_t)U_ERROR_COMMON_SUCCESS) {
+    // Check WiFi SHO handle and MQTT session exists
+    if (getMqttSession(pContext, &pMqttSession) == (int32_t)U_ERROR_COMMON_SUCCESS) {
 
-            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+        U_PORT_MUTEX_LOCK(pMqttSession->mutex);
 
-            isConnected = pMqttSession->isConnected;
+        isConnected = pMqttSession->isConnected;
 
-            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
-        }
-        uShortRangeUnlock();
+        U_PORT_MUTEX_UNLOCK(pMqttSession->mutex);
     }
 
     return isConnected;
@@ -55,6 +55,7 @@
 #include "u_short_range_pbuf.h"
 #include "u_short_range.h"
 #include "u_short_range_private.h"
+#include "u_short_range_edm.h" // U_SHORT_RANGE_EDM_MAX_SIZE
 #include "u_short_range_edm_stream.h"
 
 #include "u_wifi_module_type.h"
@@ -101,6 +102,7 @@ typedef struct {
     uShortRangePbufList_t *pTcpRxBuff;
     uShortRangePktList_t udpPktList;
     int32_t intOpts[WIFI_INT_OPT_MAX];
+    int32_t frameSize; /**< The EDM frame size for a TCP socket, zero for the default. */
     uWifiSockCallback_t pAsyncClosedCallback; /**< Set to NULL if socket is not in use. */
     uWifiSockCallback_t pDataCallback; /**< Set to NULL if socket is not in use. */
     uWifiSockCallback_t pClosedCallback; /**< Set to NULL if socket is not in use. */
@@ -352,6 +354,29 @@ static inline int32_t getInstanceAndSocket(uDeviceHandle_t devHandle, int32_t so
     return errnoLocal;
 }
 
+// Fill in pIoVec with the data of the pbufs of pBufList, which
+// there must be no more of than numIoVec, giving the entries left
+// over a length of zero, and return the total length.
+static int32_t borrowIoVecFill(const uShortRangePbufList_t *pBufList,
+                               uSockIoVec_t *pIoVec, size_t numIoVec)
+{
+    int32_t length = 0;
+    const uShortRangePbuf_t *pBuf = pBufList->pBufHead;
+
+    for (size_t x = 0; x < numIoVec; x++) {
+        (pIoVec + x)->pBase = NULL;
+        (pIoVec + x)->length = 0;
+        if (pBuf != NULL) {
+            (pIoVec + x)->pBase = (void *) &(pBuf->data[pBuf->offset]);
+            (pIoVec + x)->length = pBuf->length;
+            length += pBuf->length;
+            pBuf = pBuf->pNext;
+        }
+    }
+
+    return length;
+}
+
 // Get a socket option that has an integer as a
 // parameter
 static int32_t getOptionInt(uWifiSockSocket_t *pSock,
@@ -856,6 +881,7 @@ int32_t uWifiSockCreate(uDeviceHandle_t devHandle,
             pSock->localPort = pInstance->sockNextLocalPort;
             pInstance->sockNextLocalPort = -1;
             memset(pSock->intOpts, 0, sizeof(pSock->intOpts));
+            pSock->frameSize = 0;
             sockHandle = pSock->sockHandle;
         }
     }
@@ -943,6 +969,11 @@ int32_t uWifiSockConnect(uDeviceHandle_t devHandle,
                         errnoLocal = -U_SOCK_ECONNREFUSED;
                     } else if (pSock->edmChannel < 0) { // Make sure we got the EDM channel
                         errnoLocal = -U_SOCK_EUNATCH;
+                    } else if ((pSock->protocol == U_SOCK_PROTOCOL_TCP) &&
+                               (uShortRangeEdmStreamFrameSizeSet(pInstance->streamHandle,
+                                                                 pSock->edmChannel,
+                                                                 pSock->frameSize) < 0)) {
+                        errnoLocal = -U_SOCK_EIO;
                     }
                 }
                 // On failure make sure that the peer is closed
@@ -1108,12 +1139,28 @@ int32_t uWifiSockSetNextLocalPort(uDeviceHandle_t devHandle, int32_t port)
 int32_t uWifiSockWrite(uDeviceHandle_t devHandle,
                        int32_t sockHandle,
                        const void *pData, size_t dataSizeBytes)
+{
+    uSockIoVec_t ioVec;
+
+    if ((dataSizeBytes == 0) || (pData == NULL)) {
+        return -U_SOCK_EINVAL;
+    }
+
+    ioVec.pBase = (void *) pData;
+    ioVec.length = dataSizeBytes;
+
+    return uWifiSockWritev(devHandle, sockHandle, &ioVec, 1);
+}
+
+int32_t uWifiSockWritev(uDeviceHandle_t devHandle,
+                        int32_t sockHandle,
+                        const uSockIoVec_t *pIoVec, size_t numIoVec)
 {
     int32_t errnoLocal;
     uWifiSockSocket_t *pSock = NULL;
     uShortRangePrivateInstance_t *pInstance = NULL;
 
-    if ((dataSizeBytes == 0) || (pData == NULL)) {
+    if (uSockIoVecLength(pIoVec, numIoVec) <= 0) {
         return -U_SOCK_EINVAL;
     }
 
@@ -1135,10 +1182,10 @@ int32_t uWifiSockWrite(uDeviceHandle_t devHandle,
         }
     }
     if (errnoLocal == U_SOCK_ENONE) {
-        int32_t shortRangeEC = uShortRangeEdmStreamWrite(pInstance->streamHandle,
-                                                         pSock->edmChannel,
-                                                         pData, dataSizeBytes,
-                                                         U_WIFI_SOCK_WRITE_TIMEOUT_MS);
+        int32_t shortRangeEC = uShortRangeEdmStreamWritev(pInstance->streamHandle,
+                                                          pSock->edmChannel,
+                                                          pIoVec, numIoVec,
+                                                          U_WIFI_SOCK_WRITE_TIMEOUT_MS);
         if (shortRangeEC >= 0) {
             errnoLocal = shortRangeEC;
         } else {
@@ -1151,6 +1198,45 @@ int32_t uWifiSockWrite(uDeviceHandle_t devHandle,
     return errnoLocal;
 }
 
+int32_t uWifiSockSetFrameSize(uDeviceHandle_t devHandle,
+                              int32_t sockHandle,
+                              size_t sizeBytes)
+{
+    int32_t errnoLocal;
+    uWifiSockSocket_t *pSock = NULL;
+    uShortRangePrivateInstance_t *pInstance = NULL;
+
+    if (sizeBytes > U_SHORT_RANGE_EDM_MAX_SIZE) {
+        return -U_SOCK_EINVAL;
+    }
+
+    if (uShortRangeLock() != (int32_t) U_ERROR_COMMON_SUCCESS) {
+        return -U_SOCK_EIO;
+    }
+
+    errnoLocal = getInstanceAndSocket(devHandle, sockHandle, &pInstance, &pSock);
+
+    // Only TCP data is split into frames, a UDP datagram
+    // must always go in a single frame
+    if ((errnoLocal == U_SOCK_ENONE) && (pSock->protocol != U_SOCK_PROTOCOL_TCP)) {
+        errnoLocal = -U_SOCK_EOPNOTSUPP;
+    }
+
+    if (errnoLocal == U_SOCK_ENONE) {
+        pSock->frameSize = (int32_t) sizeBytes;
+        if (pSock->connected && (pSock->edmChannel >= 0) &&
+            (uShortRangeEdmStreamFrameSizeSet(pInstance->streamHandle,
+                                              pSock->edmChannel,
+                                              pSock->frameSize) < 0)) {
+            errnoLocal = -U_SOCK_EIO;
+        }
+    }
+
+    uShortRangeUnlock();
+
+    return errnoLocal;
+}
+
 int32_t uWifiSockRead(uDeviceHandle_t devHandle,
                       int32_t sockHandle,
                       void *pData, size_t dataSizeBytes)
@@ -1190,11 +1276,83 @@ int32_t uWifiSockRead(uDeviceHandle_t devHandle,
     return errnoLocal;
 }
 
+int32_t uWifiSockReadBorrow(uDeviceHandle_t devHandle,
+                            int32_t sockHandle,
+                            uSockIoVec_t *pIoVec, size_t numIoVec,
+                            void **ppBorrowed)
+{
+    int32_t errnoLocal;
+    uWifiSockSocket_t *pSock = NULL;
+    uShortRangePrivateInstance_t *pInstance = NULL;
+    uShortRangePbufList_t *pList;
+    uShortRangePbufList_t *pBorrowed;
+
+    if ((pIoVec == NULL) || (numIoVec == 0) || (ppBorrowed == NULL)) {
+        return -U_SOCK_EINVAL;
+    }
+    *ppBorrowed = NULL;
+
+    if (uShortRangeLock() != (int32_t) U_ERROR_COMMON_SUCCESS) {
+        return -U_SOCK_EIO;
+    }
+
+    errnoLocal = getInstanceAndSocket(devHandle, sockHandle, &pInstance, &pSock);
+
+    // We only support Read for TCP sockets
+    if ((errnoLocal == U_SOCK_ENONE) && (pSock->protocol != U_SOCK_PROTOCOL_TCP)) {
+        errnoLocal = -U_SOCK_EOPNOTSUPP;
+    }
+
+    if (errnoLocal == U_SOCK_ENONE) {
+        pList = pSock->pTcpRxBuff;
+        // Take up to one pbuf per I/O vector entry off the front
+        pBorrowed = pUShortRangePbufListSplit(pList, numIoVec);
+        if (pBorrowed != NULL) {
+            errnoLocal = borrowIoVecFill(pBorrowed, pIoVec, numIoVec);
+            *ppBorrowed = (void *) pBorrowed;
+        } else if ((pList != NULL) && (pList->totalLen > 0)) {
+            errnoLocal = -U_SOCK_ENOMEM;
+        } else {
+            // If there are no data available we must return U_SOCK_EWOULDBLOCK
+            errnoLocal = -U_SOCK_EWOULDBLOCK;
+        }
+
+        if ((pList != NULL) && (pList->totalLen == 0)) {
+            uShortRangePbufListFree(pList);
+            pSock->pTcpRxBuff = NULL;
+        }
+    }
+
+    uShortRangeUnlock();
+
+    return errnoLocal;
+}
+
+void uWifiSockBorrowRelease(void *pBorrowed)
+{
+    // The pbuf pool looks after its own locking
+    uShortRangePbufListFree((uShortRangePbufList_t *) pBorrowed);
+}
+
 int32_t uWifiSockSendTo(uDeviceHandle_t devHandle,
                         int32_t sockHandle,
                         const uSockAddress_t *pRemoteAddress,
                         const void *pData,
                         size_t dataSizeBytes)
+{
+    uSockIoVec_t ioVec;
+
+    ioVec.pBase = (void *) pData;
+    ioVec.length = dataSizeBytes;
+
+    return uWifiSockSendTov(devHandle, sockHandle, pRemoteAddress,
+                            &ioVec, 1);
+}
+
+int32_t uWifiSockSendTov(uDeviceHandle_t devHandle,
+                         int32_t sockHandle,
+                         const uSockAddress_t *pRemoteAddress,
+                         const uSockIoVec_t *pIoVec, size_t numIoVec)
 {
     int32_t errnoLocal;
     uShortRangePrivateInstance_t *pInstance = NULL;
@@ -1275,12 +1433,12 @@ int32_t uWifiSockSendTo(uDeviceHandle_t devHandle,
         }
     }
 
-    // Write the data
+    // Write the data, all of the fragments in one EDM frame
     if (errnoLocal == U_SOCK_ENONE) {
-        int32_t shortRangeEC = uShortRangeEdmStreamWrite(pInstance->streamHandle,
-                                                         pSock->edmChannel,
-                                                         pData, dataSizeBytes,
-                                                         U_WIFI_SOCK_WRITE_TIMEOUT_MS);
+        int32_t shortRangeEC = uShortRangeEdmStreamWritev(pInstance->streamHandle,
+                                                          pSock->edmChannel,
+                                                          pIoVec, numIoVec,
+                                                          U_WIFI_SOCK_WRITE_TIMEOUT_MS);
         if (shortRangeEC >= 0) {
             errnoLocal = shortRangeEC;
         } else {
@@ -1346,6 +1504,74 @@ int32_t uWifiSockReceiveFrom(uDeviceHandle_t devHandle,
 }
 
 
+int32_t uWifiSockReceiveFromBorrow(uDeviceHandle_t devHandle,
+                                   int32_t sockHandle,
+                                   uSockAddress_t *pRemoteAddress,
+                                   uSockIoVec_t *pIoVec, size_t numIoVec,
+                                   void **ppBorrowed)
+{
+    int32_t errnoLocal;
+    uShortRangePrivateInstance_t *pInstance = NULL;
+    uWifiSockSocket_t *pSock = NULL;
+    uShortRangePbufList_t *pPacket;
+    uShortRangePbufList_t *pBorrowed = NULL;
+    const uShortRangePbuf_t *pBuf;
+
+    if ((pIoVec == NULL) || (numIoVec == 0) || (ppBorrowed == NULL)) {
+        return -U_SOCK_EINVAL;
+    }
+    *ppBorrowed = NULL;
+
+    if (uShortRangeLock() != (int32_t) U_ERROR_COMMON_SUCCESS) {
+        return -U_SOCK_EIO;
+    }
+
+    errnoLocal = getInstanceAndSocket(devHandle, sockHandle, &pInstance, &pSock);
+
+    if ((errnoLocal == U_SOCK_ENONE) && (pSock->connHandle < 0)) {
+        // uWifiSockSendTo must have been called first in order to setup the peer
+        errnoLocal = -U_SOCK_EUNATCH;
+    }
+
+    // We only support ReceiveFrom for UDP sockets
+    if ((errnoLocal == U_SOCK_ENONE) && (pSock->protocol != U_SOCK_PROTOCOL_UDP)) {
+        errnoLocal = -U_SOCK_EOPNOTSUPP;
+    }
+
+    if (errnoLocal == U_SOCK_ENONE) {
+        errnoLocal = -U_SOCK_EWOULDBLOCK;
+        pPacket = pUShortRangePktListRemoveHead(&pSock->udpPktList);
+        if (pPacket != NULL) {
+            errnoLocal = -U_SOCK_ENOMEM;
+            pBorrowed = pPacket;
+            pBuf = pPacket->pBufHead;
+            for (size_t x = 0; (x < numIoVec) && (pBuf != NULL); x++) {
+                pBuf = pBuf->pNext;
+            }
+            if (pBuf != NULL) {
+                // Too many pbufs: keep what fits and throw the
+                // rest of the datagram away
+                pBorrowed = pUShortRangePbufListSplit(pPacket, numIoVec);
+                uShortRangePbufListFree(pPacket);
+            }
+        }
+        if (pBorrowed != NULL) {
+            errnoLocal = borrowIoVecFill(pBorrowed, pIoVec, numIoVec);
+            *ppBorrowed = (void *) pBorrowed;
+        }
+
+        if (pRemoteAddress) {
+            // At the moment we only receive packets from the address from first
+            // call to uWifiSockSendTo()
+            *pRemoteAddress = pSock->remoteAddress;
+        }
+    }
+
+    uShortRangeUnlock();
+
+    return errnoLocal;
+}
+
 int32_t uWifiSockRegisterCallbackData(uDeviceHandle_t devHandle,
                                       int32_t sockHandle,
                                       uWifiSockCallback_t pCallback)
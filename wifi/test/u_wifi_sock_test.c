@@ -57,6 +57,7 @@
 #include "u_port_uart.h"
 
 #include "u_sock.h"
+#include "u_sock_errno.h"
 
 #include "u_at_client.h"
 
@@ -94,6 +95,30 @@
 #define TEST_CLEAR_ERROR() (gErrorLine = 0)
 #define TEST_GET_ERROR_LINE() gErrorLine
 
+#ifndef U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES
+/** The amount of data to send when measuring TCP throughput.
+ */
+# define U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES (1024 * 32)
+#endif
+
+/** The largest amount of data to pass to uWifiSockWrite() at
+ * one time when measuring TCP throughput.
+ */
+#define U_WIFI_SOCK_TEST_THROUGHPUT_CHUNK_BYTES 4096
+
+#ifndef U_WIFI_SOCK_TEST_THROUGHPUT_TIMEOUT_MS
+/** The time allowed for sending and receiving the echo of
+ * U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES when measuring TCP
+ * throughput.
+ */
+# define U_WIFI_SOCK_TEST_THROUGHPUT_TIMEOUT_MS 60000
+#endif
+
+/** The EDM frame size to compare against the default when
+ * measuring TCP throughput, the IP MTU of the module.
+ */
+#define U_WIFI_SOCK_TEST_THROUGHPUT_SMALL_FRAME_SIZE_BYTES 635
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -381,6 +406,142 @@ static void disconnectWifi()
     TEST_CHECK_TRUE(tmp == 0);
 }
 
+// Borrow whatever has been received on gSockHandleTcp, in up
+// to two pieces, copy it to pBuffer, checking that it fits in
+// bufferSize, and give it back, returning the number of bytes or
+// negative error code.
+static int32_t readBorrowed(char *pBuffer, size_t bufferSize)
+{
+    int32_t returnCode;
+    uSockIoVec_t ioVec[2];
+    void *pBorrowed = NULL;
+    size_t length = 0;
+
+    returnCode = uWifiSockReadBorrow(gHandles.devHandle, gSockHandleTcp,
+                                     ioVec, sizeof(ioVec) / sizeof(ioVec[0]),
+                                     &pBorrowed);
+    if (returnCode >= 0) {
+        for (size_t x = 0; x < sizeof(ioVec) / sizeof(ioVec[0]); x++) {
+            if (length + ioVec[x].length <= bufferSize) {
+                memcpy(pBuffer + length, ioVec[x].pBase, ioVec[x].length);
+            }
+            length += ioVec[x].length;
+        }
+        TEST_CHECK_TRUE(pBorrowed != NULL);
+        TEST_CHECK_TRUE(length == (size_t) returnCode);
+        TEST_CHECK_TRUE(length <= bufferSize);
+        uWifiSockBorrowRelease(pBorrowed);
+    } else {
+        TEST_CHECK_TRUE(pBorrowed == NULL);
+        if (returnCode == -U_SOCK_EWOULDBLOCK) {
+            // Same as uWifiSockRead() with nothing to read
+            returnCode = 0;
+        }
+    }
+
+    return returnCode;
+}
+
+// Fill pBuffer, of U_WIFI_SOCK_TEST_THROUGHPUT_CHUNK_BYTES plus
+// sizeof(gAllChars), with repeats of gAllChars, without its
+// terminator, so that the data at byte offset n of the stream
+// is always at n % (sizeof(gAllChars) - 1) in the buffer.
+static void fillThroughputBuffer(char *pBuffer)
+{
+    size_t period = sizeof(gAllChars) - 1;
+
+    for (size_t x = 0; x < U_WIFI_SOCK_TEST_THROUGHPUT_CHUNK_BYTES + period; x++) {
+        *(pBuffer + x) = gAllChars[x % period];
+    }
+}
+
+// Connect a TCP socket to the echo server with the given EDM frame
+// size, send U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES through it,
+// made by fillThroughputBuffer() in pTxBuffer, reading the echo back
+// into pRxBuffer and checking it as it goes, then close the socket.
+// Returns the sustained send rate in bytes per second or negative
+// error code.
+static int32_t measureTcpThroughput(const uSockAddress_t *pRemoteAddress,
+                                    size_t frameSize, const char *pTxBuffer,
+                                    char *pRxBuffer)
+{
+    int32_t rate = (int32_t) U_ERROR_COMMON_UNKNOWN;
+    size_t period = sizeof(gAllChars) - 1;
+    size_t bytesWritten = 0;
+    size_t bytesRead = 0;
+    size_t thisSize;
+    int32_t returnCode;
+    int32_t startTimeMs;
+    int32_t durationMs = 0;
+    bool success = true;
+
+    gSockHandleTcp = uWifiSockCreate(gHandles.devHandle, U_SOCK_TYPE_STREAM,
+                                     U_SOCK_PROTOCOL_TCP);
+    if (gSockHandleTcp >= 0) {
+        gAsyncClosedCallbackCalledTcp = false;
+        if ((uWifiSockSetFrameSize(gHandles.devHandle, gSockHandleTcp, frameSize) == 0) &&
+            (uWifiSockConnect(gHandles.devHandle, gSockHandleTcp, pRemoteAddress) == 0)) {
+            startTimeMs = uPortGetTickTimeMs();
+            while (success && (bytesRead < U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES) &&
+                   (uPortGetTickTimeMs() - startTimeMs < U_WIFI_SOCK_TEST_THROUGHPUT_TIMEOUT_MS)) {
+                if (bytesWritten < U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES) {
+                    thisSize = U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES - bytesWritten;
+                    if (thisSize > U_WIFI_SOCK_TEST_THROUGHPUT_CHUNK_BYTES) {
+                        thisSize = U_WIFI_SOCK_TEST_THROUGHPUT_CHUNK_BYTES;
+                    }
+                    returnCode = uWifiSockWrite(gHandles.devHandle, gSockHandleTcp,
+                                                pTxBuffer + (bytesWritten % period),
+                                                thisSize);
+                    if (returnCode >= 0) {
+                        bytesWritten += returnCode;
+                        if (bytesWritten >= U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES) {
+                            durationMs = uPortGetTickTimeMs() - startTimeMs;
+                        }
+                    } else {
+                        U_TEST_PRINT_LINE("uWifiSockWrite() returned: %d.", returnCode);
+                        success = false;
+                    }
+                }
+                // Keep reading the echo so that the receive
+                // buffers never fill up
+                returnCode = uWifiSockRead(gHandles.devHandle, gSockHandleTcp,
+                                           pRxBuffer, U_WIFI_SOCK_TEST_THROUGHPUT_CHUNK_BYTES);
+                if (returnCode > 0) {
+                    if (memcmp(pRxBuffer, pTxBuffer + (bytesRead % period), returnCode) != 0) {
+                        U_TEST_PRINT_LINE("echoed data differs at offset %d.", bytesRead);
+                        success = false;
+                    }
+                    bytesRead += returnCode;
+                } else if (returnCode == -U_SOCK_EWOULDBLOCK) {
+                    if (bytesWritten >= U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES) {
+                        uPortTaskBlock(10);
+                    }
+                } else {
+                    U_TEST_PRINT_LINE("uWifiSockRead() returned: %d.", returnCode);
+                    success = false;
+                }
+            }
+            if (success && (bytesRead >= U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES)) {
+                if (durationMs <= 0) {
+                    durationMs = 1;
+                }
+                rate = (int32_t) ((((int64_t) bytesWritten) * 1000) / durationMs);
+            } else {
+                U_TEST_PRINT_LINE("%d byte(s) sent, %d byte(s) echoed.", bytesWritten,
+                                  bytesRead);
+            }
+        }
+        if (uWifiSockClose(gHandles.devHandle, gSockHandleTcp,
+                           &asyncClosedCallbackTcp) == 0) {
+            for (size_t x = 100; (x > 0) && !gAsyncClosedCallbackCalledTcp; x--) {
+                uPortTaskBlock(100);
+            }
+        }
+    }
+
+    return rate;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -524,8 +685,14 @@ U_PORT_TEST_FUNCTION("[wifiSock]", "wifiSockTCPTest")
             }
             chunkCounter++;
 
-            returnCode = uWifiSockRead(gHandles.devHandle, gSockHandleTcp,
-                                       pBuffer + bytesRead, bytesToRead);
+            if ((chunkCounter & 1) == 0) {
+                returnCode = uWifiSockRead(gHandles.devHandle, gSockHandleTcp,
+                                           pBuffer + bytesRead, bytesToRead);
+            } else {
+                // Every other time borrow the data instead
+                returnCode = readBorrowed(pBuffer + bytesRead,
+                                          U_WIFI_SOCK_MAX_SEGMENT_SIZE_BYTES - bytesRead);
+            }
             if (returnCode > 0) {
                 bytesRead += returnCode;
             } else if (returnCode == 0) {
@@ -615,6 +782,111 @@ U_PORT_TEST_FUNCTION("[wifiSock]", "wifiSockTCPTest")
 #endif
 }
 
+/** Benchmark: compare the sustained TCP send rate with EDM data
+ * frames of the module IP MTU against that with the largest EDM
+ * data frames; the rates are printed, not checked.
+ */
+U_PORT_TEST_FUNCTION("[wifiSock]", "wifiSockTcpThroughput")
+{
+    int32_t heapUsed;
+    char *pTxBuffer;
+    char *pRxBuffer;
+    int32_t returnCode;
+    int32_t rateSmall = -1;
+    int32_t rateLarge = -1;
+    uSockAddress_t remoteAddress;
+
+    TEST_CLEAR_ERROR();
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    gWifiStatusMask = 0;
+    gWifiConnected = 0;
+
+    pTxBuffer = (char *) malloc(U_WIFI_SOCK_TEST_THROUGHPUT_CHUNK_BYTES + sizeof(gAllChars));
+    U_PORT_TEST_ASSERT(pTxBuffer != NULL);
+    pRxBuffer = (char *) malloc(U_WIFI_SOCK_TEST_THROUGHPUT_CHUNK_BYTES);
+    U_PORT_TEST_ASSERT(pRxBuffer != NULL);
+    fillThroughputBuffer(pTxBuffer);
+
+    // Do the standard preamble
+    returnCode = uWifiTestPrivatePreamble((uWifiModuleType_t) U_CFG_TEST_SHORT_RANGE_MODULE_TYPE,
+                                          &uart,
+                                          &gHandles);
+    TEST_CHECK_TRUE(returnCode == 0);
+
+    if (!TEST_HAS_ERROR()) {
+        connectWifi();
+    }
+    if (!TEST_HAS_ERROR() && (0 != uWifiSockInit())) {
+        U_TEST_PRINT_LINE("unable to init socket.");
+        TEST_CHECK_TRUE(false);
+    }
+    if (!TEST_HAS_ERROR() && (0 != uWifiSockInitInstance(gHandles.devHandle))) {
+        U_TEST_PRINT_LINE("unable to init socket instance.");
+        TEST_CHECK_TRUE(false);
+    }
+
+    if (!TEST_HAS_ERROR()) {
+        returnCode = uWifiSockGetHostByName(gHandles.devHandle,
+                                            U_SOCK_TEST_ECHO_TCP_SERVER_DOMAIN_NAME,
+                                            &remoteAddress.ipAddress);
+        remoteAddress.port = U_SOCK_TEST_ECHO_TCP_SERVER_PORT;
+        TEST_CHECK_TRUE(returnCode == 0);
+    }
+
+    if (!TEST_HAS_ERROR()) {
+        U_TEST_PRINT_LINE("sending %d byte(s) to %s:%d in EDM frames of %d byte(s)...",
+                          U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES,
+                          U_SOCK_TEST_ECHO_TCP_SERVER_DOMAIN_NAME,
+                          U_SOCK_TEST_ECHO_TCP_SERVER_PORT,
+                          U_WIFI_SOCK_TEST_THROUGHPUT_SMALL_FRAME_SIZE_BYTES);
+        rateSmall = measureTcpThroughput(&remoteAddress,
+                                         U_WIFI_SOCK_TEST_THROUGHPUT_SMALL_FRAME_SIZE_BYTES,
+                                         pTxBuffer, pRxBuffer);
+        TEST_CHECK_TRUE(rateSmall > 0);
+    }
+    if (!TEST_HAS_ERROR()) {
+        U_TEST_PRINT_LINE("sending %d byte(s) again in EDM frames of the default size...",
+                          U_WIFI_SOCK_TEST_THROUGHPUT_LENGTH_BYTES);
+        rateLarge = measureTcpThroughput(&remoteAddress, 0, pTxBuffer, pRxBuffer);
+        TEST_CHECK_TRUE(rateLarge > 0);
+    }
+    U_TEST_PRINT_LINE("sustained TCP send rate: %d byte(s)/s with %d byte EDM frames,"
+                      " %d byte(s)/s with the default.", rateSmall,
+                      U_WIFI_SOCK_TEST_THROUGHPUT_SMALL_FRAME_SIZE_BYTES, rateLarge);
+
+    if (uWifiSockDeinitInstance(gHandles.devHandle) != 0) {
+        U_TEST_PRINT_LINE("unable to deinit socket instance.");
+        TEST_CHECK_TRUE(false);
+    }
+    uWifiSockDeinit();
+
+    // Cleanup
+    disconnectWifi();
+    uWifiTestPrivatePostamble(&gHandles);
+
+    free(pTxBuffer);
+    free(pRxBuffer);
+
+    if (TEST_HAS_ERROR()) {
+        U_TEST_PRINT_LINE(__FILE__ ":%d:FAIL", TEST_GET_ERROR_LINE());
+        U_PORT_TEST_ASSERT(false);
+    }
+
+    U_PORT_TEST_ASSERT_EQUAL(gCallbackErrorNum, 0);
+
+#ifndef __XTENSA__
+    // Check for memory leaks, see wifiSockTCPTest
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+#else
+    (void) heapUsed;
+#endif
+}
+
 U_PORT_TEST_FUNCTION("[wifiSock]", "wifiSockUDPTest")
 {
     int32_t heapUsed;
@@ -98,6 +98,8 @@ static volatile uint32_t gWifiStatusMask = 0;
 static volatile int32_t gLookForDisconnectReasonBitMask = 0;
 static volatile int32_t gDisconnectReasonFound = 0;
 static uWifiScanResult_t gScanResult;
+static volatile int32_t gScanAsyncResults = 0;
+static volatile int32_t gScanAsyncErrorCode = 1;
 static uShortRangeUartConfig_t uart = { .uartPort = U_CFG_APP_SHORT_RANGE_UART,
                                         .baudRate = U_SHORT_RANGE_UART_BAUD_RATE,
                                         .pinTx = U_CFG_APP_PIN_SHORT_RANGE_TXD,
@@ -221,6 +223,18 @@ static uWifiTestError_t runWifiTest(const char *pSsid, const char *pPassPhrase)
         } else {
             connectError = U_WIFI_TEST_ERROR_CONNECT;
         }
+        if (connectError == U_WIFI_TEST_ERROR_NONE) {
+            // What a fast reconnect would use should now be known
+            uWifiFastReconnect_t fastReconnect;
+            if ((uWifiStationGetFastReconnect(gHandles.devHandle, &fastReconnect) != 0) ||
+                (strcmp(fastReconnect.ssid, pSsid) != 0)) {
+                U_TEST_PRINT_LINE("unable to get fast reconnect information.");
+                connectError = U_WIFI_TEST_ERROR_IPRECV;
+            } else {
+                U_TEST_PRINT_LINE("fast reconnect: channel %d, IP address %s.",
+                                  fastReconnect.channel, fastReconnect.ipV4Address);
+            }
+        }
     }
 
     if (testError == U_WIFI_TEST_ERROR_NONE) {
@@ -271,6 +285,28 @@ static void uWifiScanResultCallback(uDeviceHandle_t devHandle, uWifiScanResult_t
     }
 }
 
+static bool uWifiScanAsyncCallback(uDeviceHandle_t devHandle,
+                                   const uWifiScanResult_t *pResult,
+                                   int32_t errorCode,
+                                   void *pCallbackParameter)
+{
+    bool keepGoing = true;
+    (void)devHandle;
+    (void)pCallbackParameter;
+    if (pResult == NULL) {
+        gScanAsyncErrorCode = errorCode;
+    } else {
+        gScanAsyncResults++;
+        if (strcmp(pResult->ssid, U_PORT_STRINGIFY_QUOTED(U_WIFI_TEST_CFG_SSID)) == 0) {
+            gScanResult = *pResult;
+            // Found it: no need to hear about anything else
+            keepGoing = false;
+        }
+    }
+
+    return keepGoing;
+}
+
 static bool validateScanResult(uWifiScanResult_t *pResult)
 {
     if ((pResult->channel <= 0) || (pResult->channel > 185)) {
@@ -543,6 +579,74 @@ U_PORT_TEST_FUNCTION("[wifi]", "wifiScan")
     U_PORT_TEST_ASSERT(testError == U_WIFI_TEST_ERROR_NONE);
 }
 
+/** Test the asynchronous scan, stopping as soon as the wanted
+ * SSID is found and filtering on its channel.
+ */
+U_PORT_TEST_FUNCTION("[wifi]", "wifiScanAsync")
+{
+    int32_t result;
+    int32_t channel;
+    uWifiScanFilter_t filter = {0};
+
+    result = uWifiTestPrivatePreamble((uWifiModuleType_t) U_CFG_TEST_SHORT_RANGE_MODULE_TYPE,
+                                      &uart,
+                                      &gHandles);
+    U_PORT_TEST_ASSERT(result == 0);
+
+    // A callback is required
+    U_PORT_TEST_ASSERT(uWifiStationScanStart(gHandles.devHandle, NULL,
+                                             NULL, NULL) < 0);
+    // Nothing to stop
+    U_PORT_TEST_ASSERT(uWifiStationScanStop(gHandles.devHandle) ==
+                       (int32_t) U_WIFI_ERROR_NOT_FOUND);
+
+    // Scan for anything, the callback stopping the scan when
+    // U_WIFI_TEST_CFG_SSID is found; retry since the AP may be missed
+    memset(&gScanResult, 0, sizeof(gScanResult));
+    for (int32_t i = 0; (i < 3) && (gScanResult.channel == 0); i++) {
+        gScanAsyncErrorCode = 1;
+        result = uWifiStationScanStart(gHandles.devHandle, NULL,
+                                       uWifiScanAsyncCallback, NULL);
+        U_PORT_TEST_ASSERT(result == 0);
+        // Only one at a time
+        U_PORT_TEST_ASSERT(uWifiStationScanStart(gHandles.devHandle, NULL,
+                                                 uWifiScanAsyncCallback, NULL) ==
+                           (int32_t) U_WIFI_ERROR_TEMPORARY_FAILURE);
+        for (int32_t x = 0; (x < 150) && (gScanAsyncErrorCode > 0); x++) {
+            uPortTaskBlock(100);
+        }
+        U_PORT_TEST_ASSERT(gScanAsyncErrorCode == 0);
+    }
+    U_PORT_TEST_ASSERT(gScanResult.channel != 0);
+    U_PORT_TEST_ASSERT(validateScanResult(&gScanResult));
+
+    // Scan again, filtering on the channel the AP was found on
+    // and a channel it can't be on, checking that nothing else
+    // gets through
+    channel = gScanResult.channel;
+    for (int32_t pass = 0; pass < 2; pass++) {
+        memset(&gScanResult, 0, sizeof(gScanResult));
+        filter.pSsid = U_PORT_STRINGIFY_QUOTED(U_WIFI_TEST_CFG_SSID);
+        filter.channel = (pass == 0) ? channel : 200;
+        gScanAsyncResults = 0;
+        gScanAsyncErrorCode = 1;
+        result = uWifiStationScanStart(gHandles.devHandle, &filter,
+                                       uWifiScanAsyncCallback, NULL);
+        U_PORT_TEST_ASSERT(result == 0);
+        for (int32_t x = 0; (x < 150) && (gScanAsyncErrorCode > 0); x++) {
+            uPortTaskBlock(100);
+        }
+        U_PORT_TEST_ASSERT(gScanAsyncErrorCode == 0);
+        if (pass == 0) {
+            U_PORT_TEST_ASSERT((gScanResult.channel == 0) || (gScanResult.channel == channel));
+        } else {
+            U_PORT_TEST_ASSERT(gScanAsyncResults == 0);
+        }
+    }
+
+    uWifiTestPrivatePostamble(&gHandles);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.